@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Bloom and tone mapping post-processing passes, one thread per output
+// pixel and 8x8 pixels per group. Each pass is compiled separately:
+//
+//   BLOOM_EXTRACT: the exposed scene color above the threshold, downsampled
+//                  to the half resolution bloom image with a 2x2 box.
+//   BLOOM_BLUR:    one direction of a separable 9 tap gaussian blur of the
+//                  bloom image, Params.direction is (1, 0) or (0, 1).
+//   TONE_MAP:      the exposed scene color plus the bloom, tone mapped with
+//                  the ACES filmic fit to the LDR output.
+
+struct BloomToneMapParams
+{
+    float2 texelSize; // 1 / Input size
+    float2 direction; // BLOOM_BLUR only
+    float  exposure;
+    float  threshold;
+    float  bloomStrength;
+    float  padding;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<BloomToneMapParams> Params : register(b0);
+
+Texture2D<float4>   Input         : register(t1);
+Texture2D<float4>   Bloom         : register(t2); // TONE_MAP only
+SamplerState        LinearSampler : register(s3);
+RWTexture2D<float4> Output        : register(u4);
+
+float3 ACESFilm(float3 x)
+{
+    return saturate((x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14));
+}
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                : SV_DispatchThreadID) {
+    uint2 outputSize;
+    Output.GetDimensions(outputSize.x, outputSize.y);
+    if (any(tid.xy >= outputSize)) {
+        return;
+    }
+
+    const float2 uv = (tid.xy + 0.5) / float2(outputSize);
+
+#if defined(BLOOM_EXTRACT)
+    // The bilinear fetch at the corner of 4 input texels is their average
+    float3 color = Input.SampleLevel(LinearSampler, uv, 0).rgb * Params.exposure;
+    Output[tid.xy] = float4(max(color - Params.threshold, 0.0), 1.0);
+#elif defined(BLOOM_BLUR)
+    // Binomial weights of 8 choose 4 +- i
+    const float weights[5] = {70.0 / 256.0, 56.0 / 256.0, 28.0 / 256.0, 8.0 / 256.0, 1.0 / 256.0};
+
+    const float2 offset = Params.direction * Params.texelSize;
+    float3       color  = Input.SampleLevel(LinearSampler, uv, 0).rgb * weights[0];
+    for (int i = 1; i < 5; ++i) {
+        color += Input.SampleLevel(LinearSampler, uv + i * offset, 0).rgb * weights[i];
+        color += Input.SampleLevel(LinearSampler, uv - i * offset, 0).rgb * weights[i];
+    }
+    Output[tid.xy] = float4(color, 1.0);
+#elif defined(TONE_MAP)
+    float3 color = Input.SampleLevel(LinearSampler, uv, 0).rgb * Params.exposure;
+    color += Bloom.SampleLevel(LinearSampler, uv, 0).rgb * Params.bloomStrength;
+    Output[tid.xy] = float4(ACESFilm(color), 1.0);
+#endif
+}
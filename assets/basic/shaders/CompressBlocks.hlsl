@@ -0,0 +1,184 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compresses one mip level of every array layer (SV_DispatchThreadID.z)
+// into BC1 or BC3 blocks, one 4x4 block per thread. Color endpoints are the
+// corners of the block's RGB bounding box inset by 1/16 of its size, texels
+// pick the closest palette entry along the axis between them. Blocks are
+// written in the row layout of a buffer to image copy.
+
+#define FORMAT_BC1       0
+#define FORMAT_BC1_ALPHA 1 // BC1 with 1-bit alpha, texels with alpha < 0.5 are transparent
+#define FORMAT_BC3       2
+
+struct CompressBlocksParams
+{
+    uint2 srcSize;
+    uint2 blockCount;
+    uint  rowStride;   // [bytes]
+    uint  layerStride; // [bytes]
+    uint  format;
+    uint  srgb;        // Src decodes sRGB, encode the texels back before compressing
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<CompressBlocksParams> Params : register(b0);
+
+Texture2DArray<float4> Src : register(t1);
+RWByteAddressBuffer    Dst : register(u2);
+
+float3 LinearToSrgb(float3 c)
+{
+    return lerp(1.055 * pow(c, 1.0 / 2.4) - 0.055, c * 12.92, step(c, 0.0031308));
+}
+
+uint ToRgb565(float3 c)
+{
+    const uint3 q = uint3(round(saturate(c) * float3(31, 63, 31)));
+    return (q.r << 11) | (q.g << 5) | q.b;
+}
+
+float3 FromRgb565(uint c)
+{
+    return float3((c >> 11) & 0x1F, (c >> 5) & 0x3F, c & 0x1F) / float3(31, 63, 31);
+}
+
+// Returns the endpoints in x and the 2-bit indices in y
+uint2 CompressColor(float4 texels[16], bool punchThrough)
+{
+    float3 minColor = 1;
+    float3 maxColor = 0;
+    bool   hasAlpha = false;
+    for (uint i = 0; i < 16; ++i) {
+        // Transparent texels don't take part in the endpoints
+        if (punchThrough && (texels[i].a < 0.5)) {
+            hasAlpha = true;
+            continue;
+        }
+        minColor = min(minColor, texels[i].rgb);
+        maxColor = max(maxColor, texels[i].rgb);
+    }
+    if (any(minColor > maxColor)) {
+        // Every texel is transparent
+        return uint2(0, 0xFFFFFFFF);
+    }
+
+    const float3 inset = (maxColor - minColor) / 16.0;
+    uint         c0    = ToRgb565(maxColor - inset);
+    uint         c1    = ToRgb565(minColor + inset);
+
+    // Four color blocks need c0 > c1 and three color blocks c0 <= c1
+    if (hasAlpha == (c0 > c1)) {
+        const uint c = c0;
+        c0           = c1;
+        c1           = c;
+    }
+
+    // t runs from the c1 end of the axis to the c0 end
+    const float3 e0   = FromRgb565(c0);
+    const float3 e1   = FromRgb565(c1);
+    const float3 axis = e0 - e1;
+    const float  scale = (dot(axis, axis) > 0) ? (1.0 / dot(axis, axis)) : 0;
+
+    uint indices = 0;
+    for (uint i = 0; i < 16; ++i) {
+        const float t = saturate(dot(texels[i].rgb - e1, axis) * scale);
+
+        uint index = 0;
+        if (hasAlpha) {
+            // Palette c0, c1, (c0 + c1) / 2, transparent
+            const uint q = uint(round(t * 2));
+            index        = (texels[i].a < 0.5) ? 3 : ((q == 0) ? 1 : ((q == 1) ? 2 : 0));
+        }
+        else {
+            // Palette c0, c1, (2 * c0 + c1) / 3, (c0 + 2 * c1) / 3
+            const uint q = uint(round(t * 3));
+            index        = (q == 0) ? 1 : ((q == 1) ? 3 : ((q == 2) ? 2 : 0));
+        }
+        indices |= index << (2 * i);
+    }
+
+    return uint2(c0 | (c1 << 16), indices);
+}
+
+// Returns the endpoints and 3-bit indices as 8 bytes
+uint2 CompressAlpha(float4 texels[16])
+{
+    float minAlpha = 1;
+    float maxAlpha = 0;
+    for (uint i = 0; i < 16; ++i) {
+        minAlpha = min(minAlpha, texels[i].a);
+        maxAlpha = max(maxAlpha, texels[i].a);
+    }
+
+    // a0 > a1 selects the palette a0, a1 and six values between them
+    const uint  a0    = uint(round(maxAlpha * 255));
+    const uint  a1    = uint(round(minAlpha * 255));
+    const float range = float(a0) - float(a1);
+
+    uint2 block = uint2(a0 | (a1 << 8), 0);
+    if (a0 == a1) {
+        return block;
+    }
+
+    for (uint i = 0; i < 16; ++i) {
+        const uint q     = uint(round(saturate((texels[i].a * 255 - float(a1)) / range) * 7));
+        const uint index = (q == 7) ? 0 : ((q == 0) ? 1 : (8 - q));
+
+        // Indices start at bit 16, the sixth one straddles both words
+        const uint bit = 16 + 3 * i;
+        if (bit < 32) {
+            block.x |= index << bit;
+            if (bit > 29) {
+                block.y |= index >> (32 - bit);
+            }
+        }
+        else {
+            block.y |= index << (bit - 32);
+        }
+    }
+    return block;
+}
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                : SV_DispatchThreadID) {
+    if (any(tid.xy >= Params.blockCount)) {
+        return;
+    }
+
+    const int2 maxCoord = int2(Params.srcSize) - 1;
+
+    float4 texels[16];
+    for (uint i = 0; i < 16; ++i) {
+        // Blocks past the edges of the level repeat its last row and column
+        const int2 coord = min(int2(tid.xy * 4 + uint2(i & 3, i >> 2)), maxCoord);
+        texels[i]        = saturate(Src.Load(int4(coord, tid.z, 0)));
+        if (Params.srgb != 0) {
+            texels[i].rgb = LinearToSrgb(texels[i].rgb);
+        }
+    }
+
+    const uint blockSize = (Params.format == FORMAT_BC3) ? 16 : 8;
+    const uint address   = tid.z * Params.layerStride + tid.y * Params.rowStride + tid.x * blockSize;
+
+    const uint2 color = CompressColor(texels, Params.format == FORMAT_BC1_ALPHA);
+    if (Params.format == FORMAT_BC3) {
+        Dst.Store4(address, uint4(CompressAlpha(texels), color));
+    }
+    else {
+        Dst.Store2(address, color);
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Copies the attributes of each vertex from one vertex buffer layout to
+// another without changing their format. Attribute sizes are in 32-bit
+// words, offsets and strides in bytes. Thread x of row y converts vertex
+// y * rowSize + x.
+
+#define MAX_ATTRIBUTES 4
+
+// Must match grfx::MeshLayoutConverter
+struct ConvertVertexLayoutParams
+{
+    uint  vertexCount;
+    uint  attributeCount;
+    uint  rowSize; // Vertices per dispatch row
+    uint  pad;
+    uint4 sizes;      // Of each attribute
+    uint4 srcBuffers; // Source vertex buffer of each attribute
+    uint4 srcOffsets; // Of each attribute within a source vertex
+    uint4 dstBuffers; // Destination vertex buffer of each attribute
+    uint4 dstOffsets; // Of each attribute within a destination vertex
+    uint2 srcStrides; // Of the source vertex buffers
+    uint2 dstStrides; // Of the destination vertex buffers
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<ConvertVertexLayoutParams> Params : register(b0);
+
+RWByteAddressBuffer Src0 : register(u1);
+RWByteAddressBuffer Src1 : register(u2);
+RWByteAddressBuffer Dst0 : register(u3);
+RWByteAddressBuffer Dst1 : register(u4);
+
+uint Load(uint buffer, uint address)
+{
+    return (buffer == 0) ? Src0.Load(address) : Src1.Load(address);
+}
+
+void Store(uint buffer, uint address, uint value)
+{
+    if (buffer == 0) {
+        Dst0.Store(address, value);
+    }
+    else {
+        Dst1.Store(address, value);
+    }
+}
+
+[numthreads(64, 1, 1)] void csmain(uint3 tid
+                                 : SV_DispatchThreadID) {
+    const uint vertex = tid.y * Params.rowSize + tid.x;
+    if (vertex >= Params.vertexCount) {
+        return;
+    }
+
+    for (uint attribute = 0; attribute < Params.attributeCount; ++attribute) {
+        const uint srcBuffer  = Params.srcBuffers[attribute];
+        const uint dstBuffer  = Params.dstBuffers[attribute];
+        const uint srcAddress = vertex * Params.srcStrides[srcBuffer] + Params.srcOffsets[attribute];
+        const uint dstAddress = vertex * Params.dstStrides[dstBuffer] + Params.dstOffsets[attribute];
+        for (uint i = 0; i < Params.sizes[attribute]; ++i) {
+            Store(dstBuffer, dstAddress + 4 * i, Load(srcBuffer, srcAddress + 4 * i));
+        }
+    }
+}
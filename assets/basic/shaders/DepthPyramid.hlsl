@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Builds every level of the min/max depth pyramid of grfx::DepthPyramid in a
+// single dispatch, in the style of AMD's single pass downsampler.
+//
+// Each group of 256 threads reduces a 64x64 tile of the depth image to
+// levels 0 to 5 of the pyramid (32x32 to 1x1). Threads are laid out in
+// Morton order, so the 4 lanes of a quad hold a 2x2 block of level 1 and
+// the 2x2 reduction to level 2 is a few lane reads. The later levels have
+// fewer texels than a subgroup and go through shared memory.
+//
+// Level 5 is written through a globally coherent view, and the last group
+// to increment the counter reads it back and reduces it the same way to
+// levels 6 to 11. Level sizes are powers of two, so tiles never straddle
+// the edge of a level and reads outside the depth image are clamped.
+//
+// Texels hold the max depth in x and the min depth in y.
+
+#define DEPTH_PYRAMID_MAX_LEVELS 12
+
+struct DepthPyramidParams
+{
+    uint2 depthSize;  // Source depth image size
+    uint2 level0Size; // Powers of two
+    uint  levelCount;
+    uint  groupCount; // Groups in the dispatch
+    uint2 padding;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<DepthPyramidParams> Params : register(b0);
+
+Texture2D<float>                          Depth   : register(t1);
+globallycoherent RWStructuredBuffer<uint> Counter : register(u2);
+globallycoherent RWTexture2D<float2>      Level5  : register(u3);
+RWTexture2D<float2>                       Levels[DEPTH_PYRAMID_MAX_LEVELS] : register(u4);
+
+groupshared float2 sLevel2[64];
+groupshared float2 sLevel3[16];
+groupshared float2 sLevel4[4];
+groupshared uint   sIsLastGroup;
+
+float2 Reduce(float2 a, float2 b)
+{
+    return float2(max(a.x, b.x), min(a.y, b.y));
+}
+
+float2 Reduce4(float2 a, float2 b, float2 c, float2 d)
+{
+    return Reduce(Reduce(a, b), Reduce(c, d));
+}
+
+// Even bits to x, odd bits to y, for the 8 bits of a thread index
+uint2 MortonDecode(uint i)
+{
+    uint2 p = uint2(i, i >> 1) & 0x55;
+    p       = (p | (p >> 1)) & 0x33;
+    p       = (p | (p >> 2)) & 0x0F;
+    return p;
+}
+
+// Reduction of the values of the 4 lanes of this lane's quad. Threads and
+// lanes are numbered the same way in a one dimensional group.
+float2 QuadReduce(float2 v)
+{
+    const uint quad = WaveGetLaneIndex() & ~3u;
+    return Reduce4(
+        WaveReadLaneAt(v, quad),
+        WaveReadLaneAt(v, quad | 1),
+        WaveReadLaneAt(v, quad | 2),
+        WaveReadLaneAt(v, quad | 3));
+}
+
+uint2 LevelSize(uint level)
+{
+    return max(Params.level0Size >> level, (uint2)1);
+}
+
+void Store(uint level, uint2 coord, float2 value)
+{
+    if ((level >= Params.levelCount) || any(coord >= LevelSize(level))) {
+        return;
+    }
+
+    if (level == 5) {
+        Level5[coord] = value;
+    }
+    else {
+        Levels[level][coord] = value;
+    }
+}
+
+float2 LoadSource(bool fromDepth, uint2 coord)
+{
+    if (fromDepth) {
+        float depth = Depth.Load(int3(min(coord, Params.depthSize - 1), 0));
+        return float2(depth, depth);
+    }
+    return Level5[min(coord, LevelSize(5) - 1)];
+}
+
+// Reduces the 64x64 source tile to levels baseLevel to baseLevel + 5. The
+// source is the depth image for base level 0 and level 5 for base level 6.
+void ReduceTile(uint t, uint2 tile, uint baseLevel, bool fromDepth)
+{
+    // This thread's texel of level baseLevel + 1 in the tile
+    const uint2 p = MortonDecode(t);
+
+    float2 v[4];
+    for (uint i = 0; i < 4; ++i) {
+        const uint2 coord = tile * 32 + p * 2 + uint2(i & 1, i >> 1);
+        const uint2 src   = coord * 2;
+
+        v[i] = Reduce4(
+            LoadSource(fromDepth, src + uint2(0, 0)),
+            LoadSource(fromDepth, src + uint2(1, 0)),
+            LoadSource(fromDepth, src + uint2(0, 1)),
+            LoadSource(fromDepth, src + uint2(1, 1)));
+        Store(baseLevel, coord, v[i]);
+    }
+
+    float2 value = Reduce4(v[0], v[1], v[2], v[3]);
+    Store(baseLevel + 1, tile * 16 + p, value);
+
+    value = QuadReduce(value);
+    if ((t & 3) == 0) {
+        Store(baseLevel + 2, tile * 8 + p / 2, value);
+        sLevel2[t >> 2] = value;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (t < 16) {
+        value = Reduce4(sLevel2[t * 4], sLevel2[t * 4 + 1], sLevel2[t * 4 + 2], sLevel2[t * 4 + 3]);
+        Store(baseLevel + 3, tile * 4 + MortonDecode(t), value);
+        sLevel3[t] = value;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (t < 4) {
+        value = Reduce4(sLevel3[t * 4], sLevel3[t * 4 + 1], sLevel3[t * 4 + 2], sLevel3[t * 4 + 3]);
+        Store(baseLevel + 4, tile * 2 + MortonDecode(t), value);
+        sLevel4[t] = value;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (t == 0) {
+        value = Reduce4(sLevel4[0], sLevel4[1], sLevel4[2], sLevel4[3]);
+        Store(baseLevel + 5, tile, value);
+    }
+}
+
+[numthreads(256, 1, 1)] void csmain(uint3 gid
+                                    : SV_GroupID, uint t
+                                    : SV_GroupIndex) {
+    ReduceTile(t, gid.xy, 0, true);
+
+    // A single group covers the whole depth image
+    if (Params.levelCount <= 6) {
+        return;
+    }
+
+    // Level 5 must be visible to the other groups before the increment
+    DeviceMemoryBarrierWithGroupSync();
+    if (t == 0) {
+        uint previous = 0;
+        InterlockedAdd(Counter[0], 1, previous);
+        sIsLastGroup = (previous == Params.groupCount - 1) ? 1 : 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (sIsLastGroup == 0) {
+        return;
+    }
+
+    ReduceTile(t, uint2(0, 0), 6, false);
+}
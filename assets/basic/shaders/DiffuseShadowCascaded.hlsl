@@ -0,0 +1,154 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//
+// Directional light shadows from cascaded shadow maps. The cascades are
+// stored in a 2x2 atlas, cascade i occupies the quadrant (i % 2, i / 2).
+//
+#define CASCADE_COUNT 4
+
+struct SceneData
+{
+    float4x4 ModelMatrix;  // Transforms object space to world space
+    float4x4 NormalMatrix; // Transforms object space to normal space
+    float4   Ambient;      // Object's ambient intensity
+
+    float4x4 CameraViewProjectionMatrix; // Camera's view projection matrix
+    float4   CameraPosition;             // Camera's position
+    float4   CameraForward;              // Camera's view direction
+
+    float4   LightDirection; // Direction towards the light
+
+    float4x4 CascadeViewProjectionMatrices[CASCADE_COUNT]; // Light's view projection matrix for each cascade
+    float4   CascadeSplits;                                // View depth where each cascade ends
+    float4   CascadeTexelSizes;                            // World space size of a texel in each cascade
+
+    uint4    Options; // x = enable/disable PCF, y = tint cascades
+};
+
+ConstantBuffer<SceneData> Scene : register(b0);
+
+Texture2D                 ShadowDepthTexture : register(t1);
+SamplerComparisonState    ShadowDepthSampler : register(s2);
+
+struct VSOutput {
+    float4 PositionWS : POSITION;
+    float4 Position   : SV_POSITION;
+    float3 Color      : COLOR;
+    float3 Normal     : NORMAL;
+};
+
+VSOutput vsmain(
+    float4 Position : POSITION,
+    float3 Color    : COLOR,
+    float3 Normal   : NORMAL)
+{
+    VSOutput result;
+    result.PositionWS = mul(Scene.ModelMatrix, Position);
+    result.Position   = mul(Scene.CameraViewProjectionMatrix, result.PositionWS);
+    result.Color      = Color;
+    result.Normal     = mul(Scene.NormalMatrix, float4(Normal, 0)).xyz;
+    return result;
+}
+
+#define PCF_SIZE 4
+
+//
+// Samples within the cascade's quadrant only, so the filter never reads
+// texels that belong to a neighbouring cascade
+//
+float ShadowPCF(float2 uv, float lightDepth, float2 rectMin, float2 rectMax)
+{
+    float2 dim = (float2)0;
+    ShadowDepthTexture.GetDimensions(dim.x, dim.y);
+    float2 invDim = 1.0 / dim;
+
+    rectMin += 0.5 * invDim;
+    rectMax -= 0.5 * invDim;
+
+    float sum = 0.0;
+    for (uint y = 0; y < PCF_SIZE; ++y) {
+        for (uint x = 0; x < PCF_SIZE; ++x) {
+            float2 offset = (float2(x, y) - (float2(PCF_SIZE, PCF_SIZE) - 1.0) / 2.0f) * invDim;
+            sum += ShadowDepthTexture.SampleCmpLevelZero(ShadowDepthSampler, clamp(uv + offset, rectMin, rectMax), lightDepth).r;
+        }
+    }
+
+    sum = sum / (PCF_SIZE * PCF_SIZE);
+    return sum;
+}
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    // Lower values may introduce artifacts
+    const float bias = 0.0005;
+
+    float3 N = normalize(input.Normal);
+    float3 L = normalize(Scene.LightDirection.xyz);
+
+    // Pick the first cascade that covers the pixel's view depth
+    float viewDepth = dot(input.PositionWS.xyz - Scene.CameraPosition.xyz, Scene.CameraForward.xyz);
+    uint  cascade   = CASCADE_COUNT;
+    for (uint i = 0; i < CASCADE_COUNT; ++i) {
+        if (viewDepth < Scene.CascadeSplits[i]) {
+            cascade = i;
+            break;
+        }
+    }
+
+    // Assume lit, pixels beyond the last cascade don't receive shadows
+    float shadowFactor = 1;
+
+    if (cascade < CASCADE_COUNT) {
+        // Push the position along the normal by a texel to avoid acne at grazing angles
+        float3 positionWS = input.PositionWS.xyz + N * Scene.CascadeTexelSizes[cascade] * 1.5;
+        float4 positionLS = mul(Scene.CascadeViewProjectionMatrices[cascade], float4(positionWS, 1));
+
+        // Orthographic projection, w is always 1
+        float2 uv    = float2(positionLS.x / 2.0 + 0.5, -positionLS.y / 2.0 + 0.5);
+        float  depth = positionLS.z - bias;
+
+        // Move into the cascade's quadrant of the atlas
+        float2 rectMin = float2(cascade % 2, cascade / 2) * 0.5;
+        float2 rectMax = rectMin + 0.5;
+        uv             = rectMin + uv * 0.5;
+
+        if ((depth >= 0) && (depth < 1)) {
+            shadowFactor = ShadowDepthTexture.SampleCmpLevelZero(ShadowDepthSampler, uv, depth);
+            if (Scene.Options.x) {
+                shadowFactor = ShadowPCF(uv, depth, rectMin, rectMax);
+            }
+        }
+    }
+
+    // Calculate diffuse lighting
+    float diffuse = saturate(dot(N, L));
+
+    // Final output color
+    float  ambient = Scene.Ambient.x;
+    float3 Co      = (diffuse * shadowFactor + ambient) * input.Color;
+
+    // Tint each cascade to show where the splits are
+    if (Scene.Options.y && (cascade < CASCADE_COUNT)) {
+        const float3 kCascadeTints[CASCADE_COUNT] = {
+            float3(1.0, 0.4, 0.4),
+            float3(0.4, 1.0, 0.4),
+            float3(0.4, 0.4, 1.0),
+            float3(1.0, 1.0, 0.4),
+        };
+        Co *= kCascadeTints[cascade];
+    }
+
+    return float4(Co, 1);
+}
@@ -0,0 +1,94 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//
+// Same inputs as DiffuseShadow.hlsl but the shadow term is a ray query
+// against the scene's top level acceleration structure instead of a
+// shadow map lookup.
+//
+struct SceneData
+{
+    float4x4 ModelMatrix;  // Transforms object space to world space
+    float4x4 NormalMatrix; // Transforms object space to normal space
+    float4   Ambient;      // Object's ambient intensity
+
+    float4x4 CameraViewProjectionMatrix; // Camera's view projection matrix
+
+    float4   LightPosition;             // Light's position
+    float4x4 LightViewProjectionMatrix; // Light's view projection matrix
+
+    uint4    UsePCF; // Unused, keeps the layout of DiffuseShadow.hlsl
+};
+
+ConstantBuffer<SceneData>       Scene    : register(b0);
+RaytracingAccelerationStructure SceneBVH : register(t3);
+
+struct VSOutput {
+    float4 PositionWS : POSITION;
+    float4 Position   : SV_POSITION;
+    float3 Color      : COLOR;
+    float3 Normal     : NORMAL;
+};
+
+VSOutput vsmain(
+    float4 Position : POSITION,
+    float3 Color    : COLOR,
+    float3 Normal   : NORMAL)
+{
+    VSOutput result;
+
+    // Tranform input position into world space
+    result.PositionWS = mul(Scene.ModelMatrix, Position);
+
+    // Transform world space position into camera's view
+    result.Position = mul(Scene.CameraViewProjectionMatrix, result.PositionWS);
+
+    // Color and normal
+    result.Color  = Color;
+    result.Normal = mul(Scene.NormalMatrix, float4(Normal, 0)).xyz;
+
+    return result;
+}
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    // Offset along the normal to keep the ray off the surface it starts on
+    const float bias = 0.01;
+
+    float3 N       = normalize(input.Normal);
+    float3 toLight = Scene.LightPosition.xyz - input.PositionWS.xyz;
+    float  dist    = length(toLight);
+    float3 L       = toLight / dist;
+
+    RayDesc ray;
+    ray.Origin    = input.PositionWS.xyz + N * bias;
+    ray.Direction = L;
+    ray.TMin      = 0.0;
+    ray.TMax      = dist;
+
+    // Any hit between the surface and the light is enough for a shadow
+    RayQuery<RAY_FLAG_ACCEPT_FIRST_HIT_AND_END_SEARCH | RAY_FLAG_SKIP_PROCEDURAL_PRIMITIVES> query;
+    query.TraceRayInline(SceneBVH, RAY_FLAG_NONE, 0xFF, ray);
+    query.Proceed();
+
+    float shadowFactor = (query.CommittedStatus() == COMMITTED_TRIANGLE_HIT) ? 0.0 : 1.0;
+
+    // Calculate diffuse lighting
+    float diffuse = saturate(dot(N, L));
+
+    // Final output color
+    float  ambient = Scene.Ambient.x;
+    float3 Co      = (diffuse * shadowFactor + ambient) * input.Color;
+    return float4(Co, 1);
+}
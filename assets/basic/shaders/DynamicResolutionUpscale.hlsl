@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Stretches the rendered top left corner of a render target over the
+// output with a full screen triangle, see grfx::DynamicResolution.
+// Coordinates are clamped half a texel inside the corner so bilinear
+// filtering doesn't pick up the stale texels next to it.
+
+struct UpscaleParams
+{
+    float2 uvScale; // Render size / render target size
+    float2 uvMax;   // (Render size - 0.5) / render target size
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<UpscaleParams> Params : register(b2);
+
+Texture2D    Tex0     : register(t0);
+SamplerState Sampler0 : register(s1);
+
+struct VSOutput
+{
+    float4 Position : SV_POSITION;
+    float2 TexCoord : TEXCOORD;
+};
+
+VSOutput vsmain(uint id : SV_VertexID)
+{
+    VSOutput result;
+
+    // Clip space position
+    result.Position.x = (float)(id / 2) * 4.0 - 1.0;
+    result.Position.y = (float)(id % 2) * 4.0 - 1.0;
+    result.Position.z = 0.0;
+    result.Position.w = 1.0;
+
+    // Texture coordinates
+    result.TexCoord.x = (float)(id / 2) * 2.0;
+    result.TexCoord.y = 1.0 - (float)(id % 2) * 2.0;
+
+    return result;
+}
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    float2 uv = min(input.TexCoord * Params.uvScale, Params.uvMax);
+    return Tex0.SampleLevel(Sampler0, uv, 0);
+}
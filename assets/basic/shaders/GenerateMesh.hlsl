@@ -0,0 +1,170 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Generates copies of the vertices and triangles of TriMesh::CreateSphere()
+// or TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y) into index and vertex
+// buffers. Thread x writes vertex x and triangle x of copy
+// SV_DispatchThreadID.y, which is moved by its translation. Offsets are in
+// bytes.
+
+#define SHAPE_SPHERE 0
+#define SHAPE_PLANE  1
+
+#define FORMAT_NONE   0
+#define FORMAT_FLOAT  1 // 32-bit floats
+#define FORMAT_HALF   2 // 16-bit floats
+#define FORMAT_SNORM8 3 // 4 8-bit SNORM values
+
+#define ATTRIBUTE_POSITION 0
+#define ATTRIBUTE_TEXCOORD 1
+#define ATTRIBUTE_NORMAL   2
+#define ATTRIBUTE_TANGENT  3
+
+// Must match grfx::MeshGenerator
+struct GenerateMeshParams
+{
+    uint   shape;
+    uint   usegs;
+    uint   vsegs;
+    uint   vertexCount;   // Per copy
+    float2 size;          // Sphere radius in x, plane size
+    uint   triangleCount; // Per copy
+    uint   pad;
+    uint4  formats;         // Of each attribute
+    uint4  componentCounts; // Of each attribute
+    uint4  buffers;         // Vertex buffer of each attribute
+    uint4  offsets;         // Of each attribute within a vertex
+    uint2  strides;         // Of the vertex buffers
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<GenerateMeshParams> Params : register(b0);
+
+StructuredBuffer<float4> Translations : register(t1);
+RWByteAddressBuffer      Indices      : register(u2);
+RWByteAddressBuffer      Vertices0    : register(u3);
+RWByteAddressBuffer      Vertices1    : register(u4);
+
+struct Vertex
+{
+    float3 position;
+    float2 texCoord;
+    float3 normal;
+    float4 tangent;
+};
+
+// Same as TriMesh::CreateSphere(), vertex (i, j) is at i * vverts + j
+Vertex SphereVertex(uint index)
+{
+    const float kPi    = 3.14159265359;
+    const float kTwoPi = 2.0 * kPi;
+
+    const uint  vverts = Params.vsegs + 1;
+    const float theta  = (index / vverts) * (kTwoPi / Params.usegs);
+    const float phi    = (index % vverts) * (kPi / Params.vsegs);
+
+    Vertex vertex;
+    vertex.position = Params.size.x * float3(cos(theta) * sin(phi), cos(phi), sin(theta) * sin(phi));
+    vertex.texCoord = float2(theta / kTwoPi, phi / kPi);
+    vertex.normal   = normalize(vertex.position);
+    vertex.tangent  = float4(-sin(theta), 0, cos(theta), 1);
+    return vertex;
+}
+
+// Same as TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y), vertex (i, j)
+// is at j * uverts + i
+Vertex PlaneVertex(uint index)
+{
+    const uint  uverts = Params.usegs + 1;
+    const float s      = float(index % uverts) / Params.usegs;
+    const float t      = float(index / uverts) / Params.vsegs;
+
+    Vertex vertex;
+    vertex.position = float3((s - 0.5) * Params.size.x, 0, (t - 0.5) * Params.size.y);
+    vertex.texCoord = float2(s, t);
+    vertex.normal   = float3(0, 1, 0);
+    vertex.tangent  = float4(0, 0, 0, 1);
+    return vertex;
+}
+
+// Same indices as TriMesh for both shapes, two triangles per quad (i, j)
+uint3 GridTriangle(uint index)
+{
+    const uint vverts = Params.vsegs + 1;
+    const uint quad   = index / 2;
+    const uint i      = quad / Params.vsegs + 1;
+    const uint j      = quad % Params.vsegs + 1;
+
+    const uint v0 = i * vverts + j - 1;
+    const uint v1 = i * vverts + j;
+    const uint v2 = (i - 1) * vverts + j;
+    const uint v3 = (i - 1) * vverts + j - 1;
+    return ((index % 2) == 0) ? uint3(v0, v1, v2) : uint3(v0, v2, v3);
+}
+
+void Store(uint buffer, uint address, uint value)
+{
+    if (buffer == 0) {
+        Vertices0.Store(address, value);
+    }
+    else {
+        Vertices1.Store(address, value);
+    }
+}
+
+void WriteAttribute(uint attribute, uint vertex, float4 value)
+{
+    const uint format  = Params.formats[attribute];
+    const uint count   = Params.componentCounts[attribute];
+    const uint buffer  = Params.buffers[attribute];
+    const uint address = vertex * Params.strides[buffer] + Params.offsets[attribute];
+
+    if (format == FORMAT_FLOAT) {
+        for (uint i = 0; i < count; ++i) {
+            Store(buffer, address + 4 * i, asuint(value[i]));
+        }
+    }
+    else if (format == FORMAT_HALF) {
+        for (uint i = 0; i < count; i += 2) {
+            Store(buffer, address + 2 * i, f32tof16(value[i]) | (f32tof16(value[i + 1]) << 16));
+        }
+    }
+    else if (format == FORMAT_SNORM8) {
+        const int4 q = int4(round(clamp(value, -1.0, 1.0) * 127.0));
+        Store(buffer, address, (q.x & 0xFF) | ((q.y & 0xFF) << 8) | ((q.z & 0xFF) << 16) | ((q.w & 0xFF) << 24));
+    }
+}
+
+[numthreads(64, 1, 1)] void csmain(uint3 tid
+                                 : SV_DispatchThreadID) {
+    const uint copy = tid.y;
+
+    if (tid.x < Params.vertexCount) {
+        const Vertex vertex = (Params.shape == SHAPE_SPHERE) ? SphereVertex(tid.x) : PlaneVertex(tid.x);
+        const uint   index  = copy * Params.vertexCount + tid.x;
+
+        // Positions in 4 components have w = 0, normals w = 1
+        WriteAttribute(ATTRIBUTE_POSITION, index, float4(vertex.position + Translations[copy].xyz, 0));
+        WriteAttribute(ATTRIBUTE_TEXCOORD, index, float4(vertex.texCoord, 0, 0));
+        WriteAttribute(ATTRIBUTE_NORMAL, index, float4(vertex.normal, 1));
+        WriteAttribute(ATTRIBUTE_TANGENT, index, vertex.tangent);
+    }
+
+    if (tid.x < Params.triangleCount) {
+        const uint3 triangle = GridTriangle(tid.x) + copy * Params.vertexCount;
+        Indices.Store3(12 * (copy * Params.triangleCount + tid.x), triangle);
+    }
+}
@@ -0,0 +1,129 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Generates up to four mip levels per dispatch, for every array layer at
+// once (SV_DispatchThreadID.z). Each 8x8 group box filters a 16x16 tile of
+// the source level into an 8x8 tile of the first destination level, then
+// keeps halving the tile in group shared memory for the next levels. Reads
+// outside of the source are clamped to its last row and column.
+
+struct GenerateMipsParams
+{
+    uint2 srcSize;
+    uint  levelCount; // Levels written by this dispatch, 1 to 4
+    uint  srgb;       // Color channels are sRGB encoded
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<GenerateMipsParams> Params : register(b0);
+
+Texture2DArray<float4>   Src  : register(t1);
+RWTexture2DArray<float4> Dst0 : register(u2);
+RWTexture2DArray<float4> Dst1 : register(u3);
+RWTexture2DArray<float4> Dst2 : register(u4);
+RWTexture2DArray<float4> Dst3 : register(u5);
+
+groupshared float4 Tile[64];
+
+float3 SrgbToLinear(float3 c)
+{
+    return lerp(pow((c + 0.055) / 1.055, 2.4), c / 12.92, step(c, 0.04045));
+}
+
+float3 LinearToSrgb(float3 c)
+{
+    return lerp(1.055 * pow(c, 1.0 / 2.4) - 0.055, c * 12.92, step(c, 0.0031308));
+}
+
+float4 Load(int2 coord, uint layer, int2 maxCoord)
+{
+    float4 value = Src.Load(int4(min(coord, maxCoord), layer, 0));
+    if (Params.srgb != 0) {
+        value.rgb = SrgbToLinear(value.rgb);
+    }
+    return value;
+}
+
+float4 Encode(float4 value)
+{
+    if (Params.srgb != 0) {
+        value.rgb = LinearToSrgb(saturate(value.rgb));
+    }
+    return value;
+}
+
+// Halves the tile in place: threads whose group coordinates are multiples
+// of 2 * step read the three neighbours step texels away
+float4 Reduce(uint index, uint step, float4 value)
+{
+    value = 0.25 * (value + Tile[index + step] + Tile[index + 8 * step] + Tile[index + 9 * step]);
+    Tile[index] = value;
+    return value;
+}
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                : SV_DispatchThreadID, uint3 gtid
+                                : SV_GroupThreadID, uint3 gid
+                                : SV_GroupID) {
+    const uint  layer    = tid.z;
+    const uint  index    = gtid.y * 8 + gtid.x;
+    const int2  maxCoord = int2(Params.srcSize) - 1;
+    const uint2 dstSize  = max(Params.srcSize >> 1, 1);
+
+    const int2 coord = int2(tid.xy) * 2;
+    float4     value = 0.25 * (Load(coord, layer, maxCoord) + Load(coord + int2(1, 0), layer, maxCoord) + Load(coord + int2(0, 1), layer, maxCoord) + Load(coord + int2(1, 1), layer, maxCoord));
+    if (all(tid.xy < dstSize)) {
+        Dst0[uint3(tid.xy, layer)] = Encode(value);
+    }
+    if (Params.levelCount == 1) {
+        return;
+    }
+
+    Tile[index] = value;
+    GroupMemoryBarrierWithGroupSync();
+
+    if ((index & 0x9) == 0) {
+        const uint2 pixel = gid.xy * 4 + gtid.xy / 2;
+        value             = Reduce(index, 1, value);
+        if (all(pixel < max(dstSize >> 1, 1))) {
+            Dst1[uint3(pixel, layer)] = Encode(value);
+        }
+    }
+    if (Params.levelCount == 2) {
+        return;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if ((index & 0x1B) == 0) {
+        const uint2 pixel = gid.xy * 2 + gtid.xy / 4;
+        value             = Reduce(index, 2, value);
+        if (all(pixel < max(dstSize >> 2, 1))) {
+            Dst2[uint3(pixel, layer)] = Encode(value);
+        }
+    }
+    if (Params.levelCount == 3) {
+        return;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (index == 0) {
+        const uint2 pixel = gid.xy;
+        value             = Reduce(index, 4, value);
+        if (all(pixel < max(dstSize >> 3, 1))) {
+            Dst3[uint3(pixel, layer)] = Encode(value);
+        }
+    }
+}
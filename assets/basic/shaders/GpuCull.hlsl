@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Must match scene::GpuCuller
+#define CULL_FLAG_FRUSTUM   0x1
+#define CULL_FLAG_OCCLUSION 0x2
+
+struct CullParams
+{
+    float4   frustumPlanes[6]; // World space, normals point inside
+    float4x4 prevViewProjectionMatrix;
+    uint     instanceCount;
+    uint     flags;
+};
+
+// Must match scene::GpuCullInstance
+struct Instance
+{
+    float3 boundsMin;
+    uint   indexCount;
+    float3 boundsMax;
+    uint   firstIndex;
+    int    vertexOffset;
+    uint   firstInstance;
+    uint2  padding;
+};
+
+// Must match grfx::DrawIndexedIndirectCommand
+struct DrawArgs
+{
+    uint indexCount;
+    uint instanceCount;
+    uint firstIndex;
+    int  vertexOffset;
+    uint firstInstance;
+};
+
+ConstantBuffer<CullParams>   Params       : register(b0);
+StructuredBuffer<Instance>   Instances    : register(t1);
+Texture2D<float>             HiZ          : register(t2);
+RWStructuredBuffer<DrawArgs> Draws        : register(u3);
+RWStructuredBuffer<uint>     VisibleCount : register(u4);
+
+bool IsInsideFrustum(float3 boundsMin, float3 boundsMax)
+{
+    for (uint i = 0; i < 6; ++i) {
+        const float4 plane = Params.frustumPlanes[i];
+        // Corner furthest along the plane normal
+        const float3 p = float3(
+            plane.x >= 0 ? boundsMax.x : boundsMin.x,
+            plane.y >= 0 ? boundsMax.y : boundsMin.y,
+            plane.z >= 0 ? boundsMax.z : boundsMin.z);
+        if (dot(plane.xyz, p) + plane.w < 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsOccluded(float3 boundsMin, float3 boundsMax)
+{
+    float2 uvMin    = float2(1, 1);
+    float2 uvMax    = float2(0, 0);
+    float  minDepth = 1;
+    for (uint i = 0; i < 8; ++i) {
+        const float3 corner = float3(
+            (i & 1) ? boundsMax.x : boundsMin.x,
+            (i & 2) ? boundsMax.y : boundsMin.y,
+            (i & 4) ? boundsMax.z : boundsMin.z);
+        const float4 clip = mul(Params.prevViewProjectionMatrix, float4(corner, 1));
+        // Crosses the camera plane, can't be tested
+        if (clip.w <= 0) {
+            return false;
+        }
+        const float3 ndc = clip.xyz / clip.w;
+        const float2 uv  = float2(0.5 + 0.5 * ndc.x, 0.5 - 0.5 * ndc.y);
+        uvMin            = min(uvMin, uv);
+        uvMax            = max(uvMax, uv);
+        minDepth         = min(minDepth, ndc.z);
+    }
+    uvMin = saturate(uvMin);
+    uvMax = saturate(uvMax);
+
+    uint width, height, levelCount;
+    HiZ.GetDimensions(0, width, height, levelCount);
+
+    // Smallest level where the rectangle spans at most 2x2 texels
+    const float2 sizeInTexels = (uvMax - uvMin) * float2(width, height);
+    const uint   level        = min(uint(ceil(log2(max(max(sizeInTexels.x, sizeInTexels.y), 1)))), levelCount - 1);
+
+    uint levelWidth, levelHeight;
+    HiZ.GetDimensions(level, levelWidth, levelHeight, levelCount);
+    const int2 maxCoord = int2(levelWidth, levelHeight) - 1;
+    const int2 c0       = min(int2(uvMin * float2(levelWidth, levelHeight)), maxCoord);
+    const int2 c1       = min(int2(uvMax * float2(levelWidth, levelHeight)), maxCoord);
+
+    const float d0 = HiZ.Load(int3(c0.x, c0.y, level));
+    const float d1 = HiZ.Load(int3(c1.x, c0.y, level));
+    const float d2 = HiZ.Load(int3(c0.x, c1.y, level));
+    const float d3 = HiZ.Load(int3(c1.x, c1.y, level));
+
+    return minDepth > max(max(d0, d1), max(d2, d3));
+}
+
+[numthreads(64, 1, 1)] void csmain(uint3 tid
+                                 : SV_DispatchThreadID) {
+    const uint index = tid.x;
+    if (index >= Params.instanceCount) {
+        return;
+    }
+
+    const Instance instance = Instances[index];
+
+    bool visible = true;
+    if (Params.flags & CULL_FLAG_FRUSTUM) {
+        visible = IsInsideFrustum(instance.boundsMin, instance.boundsMax);
+    }
+    if (visible && (Params.flags & CULL_FLAG_OCCLUSION)) {
+        visible = !IsOccluded(instance.boundsMin, instance.boundsMax);
+    }
+
+    DrawArgs draw;
+    draw.indexCount    = instance.indexCount;
+    draw.instanceCount = visible ? 1 : 0;
+    draw.firstIndex    = instance.firstIndex;
+    draw.vertexOffset  = instance.vertexOffset;
+    draw.firstInstance = instance.firstInstance;
+    Draws[index]       = draw;
+
+    if (visible) {
+        InterlockedAdd(VisibleCount[0], 1);
+    }
+}
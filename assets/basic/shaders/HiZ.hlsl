@@ -0,0 +1,48 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Builds one level of a max depth pyramid. The destination is half the
+// size of the source rounded up, reads outside of the source are clamped
+// so the last row and column of odd sized sources are still covered.
+
+struct HiZParams
+{
+    uint2 srcSize;
+    uint2 dstSize;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<HiZParams> Params : register(b0);
+
+Texture2D<float>   Src : register(t1);
+RWTexture2D<float> Dst : register(u2);
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                : SV_DispatchThreadID) {
+    if (any(tid.xy >= Params.dstSize)) {
+        return;
+    }
+
+    const int2 maxCoord = int2(Params.srcSize) - 1;
+    const int2 coord    = int2(tid.xy) * 2;
+
+    float d0 = Src.Load(int3(min(coord + int2(0, 0), maxCoord), 0));
+    float d1 = Src.Load(int3(min(coord + int2(1, 0), maxCoord), 0));
+    float d2 = Src.Load(int3(min(coord + int2(0, 1), maxCoord), 0));
+    float d3 = Src.Load(int3(min(coord + int2(1, 1), maxCoord), 0));
+
+    Dst[tid.xy] = max(max(d0, d1), max(d2, d3));
+}
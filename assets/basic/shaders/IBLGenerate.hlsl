@@ -0,0 +1,273 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compute kernels of grfx::IBLGenerator. Environments are equirectangular
+// textures addressed with DirectionToLatLongUV(), the mapping PBR.hlsli
+// samples IBL textures with.
+//
+//   IBL_PROJECT_SH  Projects the source onto 9 order 2 SH coefficients, one
+//                   group of 256 threads over a Params.dstSize sample grid
+//   IBL_IRRADIANCE  Evaluates the cosine convolved SH coefficients into a
+//                   lat-long irradiance texture, 8x8 pixels per group
+//   IBL_PREFILTER   GGX prefiltered radiance for one level of the specular
+//                   environment, 8x8 pixels per group
+//   IBL_BRDF_LUT    Split sum scale and bias of the specular BRDF, x is
+//                   roughness and y is NoV, 8x8 pixels per group
+
+#include "ppx/Math.hlsli"
+#include "ppx/Sampling.hlsli"
+
+#define SH_COEFFICIENT_COUNT 9
+
+struct IBLParams
+{
+    uint2 srcSize;
+    uint2 dstSize;
+    uint  srcLevelCount;
+    uint  sampleCount;
+    float roughness;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<IBLParams> Params : register(b0);
+
+Texture2D<float4>          Src            : register(t1);
+RWTexture2D<float4>        Dst            : register(u2);
+RWStructuredBuffer<float4> SHCoefficients : register(u3); // IBL_PROJECT_SH output
+SamplerState               SrcSampler     : register(s4);
+StructuredBuffer<float4>   SHInput        : register(t5); // IBL_IRRADIANCE input
+
+// Inverse of DirectionToLatLongUV()
+float3 LatLongUVToDirection(float2 uv)
+{
+    float phi      = (uv.x - 0.75) * 2.0 * PI;
+    float theta    = (0.5 - uv.y) * PI;
+    float cosTheta = cos(theta);
+    return float3(sin(phi) * cosTheta, sin(theta), -cos(phi) * cosTheta);
+}
+
+float3 SampleSource(float3 dir, float lod)
+{
+    float2 uv = DirectionToLatLongUV(dir);
+    return Src.SampleLevel(SrcSampler, uv, clamp(lod, 0.0, float(Params.srcLevelCount - 1))).rgb;
+}
+
+// GGX half vector around N, alpha = roughness^2
+float3 ImportanceSampleGGX(float2 xi, float3 N, float roughness)
+{
+    float alpha    = roughness * roughness;
+    float phi      = 2.0 * PI * xi.x;
+    float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (alpha * alpha - 1.0) * xi.y));
+    float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+    float3 H       = float3(sinTheta * cos(phi), sinTheta * sin(phi), cosTheta);
+
+    float3 up      = (abs(N.z) < 0.999) ? float3(0, 0, 1) : float3(1, 0, 0);
+    float3 tangent = normalize(cross(up, N));
+    float3 bitan   = cross(N, tangent);
+    return normalize(tangent * H.x + bitan * H.y + N * H.z);
+}
+
+float DistributionGGX(float NoH, float roughness)
+{
+    float alpha   = roughness * roughness;
+    float alphaSq = alpha * alpha;
+    float denom   = (NoH * NoH) * (alphaSq - 1.0) + 1.0;
+    return alphaSq / (PI * denom * denom);
+}
+
+#if defined(IBL_PROJECT_SH)
+
+#define GROUP_SIZE 256
+
+groupshared float3 Partial[GROUP_SIZE];
+
+void EvaluateSHBasis(float3 d, out float basis[SH_COEFFICIENT_COUNT])
+{
+    basis[0] = 0.282095;
+    basis[1] = 0.488603 * d.y;
+    basis[2] = 0.488603 * d.z;
+    basis[3] = 0.488603 * d.x;
+    basis[4] = 1.092548 * d.x * d.y;
+    basis[5] = 1.092548 * d.y * d.z;
+    basis[6] = 0.315392 * (3.0 * d.z * d.z - 1.0);
+    basis[7] = 1.092548 * d.x * d.z;
+    basis[8] = 0.546274 * (d.x * d.x - d.y * d.y);
+}
+
+[numthreads(GROUP_SIZE, 1, 1)] void csmain(uint3 gtid
+                                          : SV_GroupThreadID) {
+    const uint  sampleCount = Params.dstSize.x * Params.dstSize.y;
+    const float lod         = log2(float(Params.srcSize.x) / float(Params.dstSize.x));
+
+    float3 acc[SH_COEFFICIENT_COUNT];
+    [unroll] for (uint k = 0; k < SH_COEFFICIENT_COUNT; ++k)
+    {
+        acc[k] = (float3)0;
+    }
+
+    for (uint i = gtid.x; i < sampleCount; i += GROUP_SIZE) {
+        uint2  coord = uint2(i % Params.dstSize.x, i / Params.dstSize.x);
+        float2 uv    = (float2(coord) + 0.5) / float2(Params.dstSize);
+        float3 dir   = LatLongUVToDirection(uv);
+
+        // Solid angle of a lat-long texel shrinks with cos(latitude)
+        float dOmega = cos((0.5 - uv.y) * PI) * (2.0 * PI / Params.dstSize.x) * (PI / Params.dstSize.y);
+
+        float3 radiance = SampleSource(dir, lod) * dOmega;
+
+        float basis[SH_COEFFICIENT_COUNT];
+        EvaluateSHBasis(dir, basis);
+        [unroll] for (uint k = 0; k < SH_COEFFICIENT_COUNT; ++k)
+        {
+            acc[k] += radiance * basis[k];
+        }
+    }
+
+    // Reduce one coefficient at a time to keep group shared memory small
+    [unroll] for (uint k = 0; k < SH_COEFFICIENT_COUNT; ++k)
+    {
+        Partial[gtid.x] = acc[k];
+        GroupMemoryBarrierWithGroupSync();
+
+        for (uint stride = GROUP_SIZE / 2; stride > 0; stride >>= 1) {
+            if (gtid.x < stride) {
+                Partial[gtid.x] += Partial[gtid.x + stride];
+            }
+            GroupMemoryBarrierWithGroupSync();
+        }
+
+        if (gtid.x == 0) {
+            SHCoefficients[k] = float4(Partial[0], 0);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+#elif defined(IBL_IRRADIANCE)
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                  : SV_DispatchThreadID) {
+    if (any(tid.xy >= Params.dstSize)) {
+        return;
+    }
+
+    float2 uv = (float2(tid.xy) + 0.5) / float2(Params.dstSize);
+    float3 d  = LatLongUVToDirection(uv);
+
+    // Cosine lobe convolution: A0 = pi, A1 = 2pi/3, A2 = pi/4
+    const float A0 = PI;
+    const float A1 = 2.0 * PI / 3.0;
+    const float A2 = PI / 4.0;
+
+    // Irradiance, PBR.hlsli applies the Lambert 1/pi
+    float3 E = A0 * 0.282095 * SHInput[0].rgb;
+    E += A1 * 0.488603 * (SHInput[1].rgb * d.y + SHInput[2].rgb * d.z + SHInput[3].rgb * d.x);
+    E += A2 * 1.092548 * (SHInput[4].rgb * d.x * d.y + SHInput[5].rgb * d.y * d.z + SHInput[7].rgb * d.x * d.z);
+    E += A2 * 0.315392 * SHInput[6].rgb * (3.0 * d.z * d.z - 1.0);
+    E += A2 * 0.546274 * SHInput[8].rgb * (d.x * d.x - d.y * d.y);
+
+    Dst[tid.xy] = float4(max(E, (float3)0), 1);
+}
+
+#elif defined(IBL_PREFILTER)
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                  : SV_DispatchThreadID) {
+    if (any(tid.xy >= Params.dstSize)) {
+        return;
+    }
+
+    float2 uv = (float2(tid.xy) + 0.5) / float2(Params.dstSize);
+    float3 N  = LatLongUVToDirection(uv);
+
+    // The mirror level only needs to be resampled to the destination's size
+    const float baseLod = log2(float(Params.srcSize.x) / float(Params.dstSize.x));
+    if (Params.roughness <= 0.0) {
+        Dst[tid.xy] = float4(SampleSource(N, baseLod), 1);
+        return;
+    }
+
+    // Filtered importance sampling: read a source level whose texels cover
+    // the solid angle of each sample, which removes most of the noise a
+    // low sample count would leave. Assumes N = V = R.
+    const float texelSolidAngle = 4.0 * PI / float(Params.srcSize.x * Params.srcSize.y);
+
+    float3 sum         = (float3)0;
+    float  totalWeight = 0;
+    for (uint i = 0; i < Params.sampleCount; ++i) {
+        float2 xi  = Hammersley(i, Params.sampleCount);
+        float3 H   = ImportanceSampleGGX(xi, N, Params.roughness);
+        float3 L   = 2.0 * dot(N, H) * H - N;
+        float  NoL = dot(N, L);
+        if (NoL > 0.0) {
+            float NoH              = saturate(dot(N, H));
+            float pdf              = DistributionGGX(NoH, Params.roughness) * 0.25;
+            float sampleSolidAngle = 1.0 / (float(Params.sampleCount) * pdf + EPSILON);
+            float lod              = 0.5 * log2(sampleSolidAngle / texelSolidAngle) + 1.0;
+
+            sum += SampleSource(L, max(lod, baseLod)) * NoL;
+            totalWeight += NoL;
+        }
+    }
+
+    Dst[tid.xy] = float4(sum / max(totalWeight, EPSILON), 1);
+}
+
+#elif defined(IBL_BRDF_LUT)
+
+// Schlick-GGX with k = alpha / 2, the remapping for IBL
+float GeometrySmithIBL(float NoV, float NoL, float roughness)
+{
+    float k  = (roughness * roughness) * 0.5;
+    float gV = NoV / (NoV * (1.0 - k) + k);
+    float gL = NoL / (NoL * (1.0 - k) + k);
+    return gV * gL;
+}
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                  : SV_DispatchThreadID) {
+    if (any(tid.xy >= Params.dstSize)) {
+        return;
+    }
+
+    const float roughness = (float(tid.x) + 0.5) / float(Params.dstSize.x);
+    const float NoV       = (float(tid.y) + 0.5) / float(Params.dstSize.y);
+
+    const float3 N = float3(0, 0, 1);
+    const float3 V = float3(sqrt(1.0 - NoV * NoV), 0, NoV);
+
+    float scale = 0;
+    float bias  = 0;
+    for (uint i = 0; i < Params.sampleCount; ++i) {
+        float2 xi  = Hammersley(i, Params.sampleCount);
+        float3 H   = ImportanceSampleGGX(xi, N, roughness);
+        float3 L   = 2.0 * dot(V, H) * H - V;
+        float  NoL = saturate(L.z);
+        float  NoH = saturate(H.z);
+        float  VoH = saturate(dot(V, H));
+        if (NoL > 0.0) {
+            float G    = GeometrySmithIBL(NoV, NoL, roughness);
+            float GVis = (G * VoH) / max(NoH * NoV, EPSILON);
+            float Fc   = pow(1.0 - VoH, 5.0);
+            scale += (1.0 - Fc) * GVis;
+            bias += Fc * GVis;
+        }
+    }
+
+    Dst[tid.xy] = float4(scale / float(Params.sampleCount), bias / float(Params.sampleCount), 0, 1);
+}
+
+#endif
@@ -0,0 +1,52 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Renders ImGui draw data for ppx::ImGuiImplGrfx. Textures are indexed out
+// of the bindless heap by a push constant that changes between draws.
+
+struct DrawParams
+{
+    float2 Scale;
+    float2 Translate;
+    uint   TextureIndex;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<DrawParams> Draw : register(b2);
+
+Texture2D    Textures[] : register(t0);
+SamplerState Samplers[] : register(s1);
+
+struct VSOutput {
+    float4 Position : SV_POSITION;
+    float2 TexCoord : TEXCOORD;
+    float4 Color4   : COLOR;
+};
+
+VSOutput vsmain(float2 Position : POSITION, float2 TexCoord : TEXCOORD0, float4 Color4 : COLOR)
+{
+    VSOutput result;
+    result.Position = float4(Position * Draw.Scale + Draw.Translate, 0, 1);
+    result.TexCoord = TexCoord;
+    result.Color4   = Color4;
+    return result;
+}
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    return input.Color4 * Textures[Draw.TextureIndex].Sample(Samplers[0], input.TexCoord);
+}
@@ -0,0 +1,223 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Compute kernels of grfx::ImageFilter. Every group first loads the source
+// texels it needs, including the halo around its pixels, into group shared
+// memory once, so each texel is fetched once per group instead of once per
+// tap. Reads outside of the source are clamped to its edges.
+//
+//   FILTER_SEPARABLE  1D Gaussian or box pass along Params.direction,
+//                     64 pixels per group, radius up to 32
+//   FILTER_2D         Gaussian, box, bilateral or Sobel on 16x16 pixel
+//                     tiles, radius up to 4
+//   FILTER_RESAMPLE   2x downsample with a 4x4 tent or 2x upsample with a
+//                     3x3 tent added onto the destination, 8x8 pixels per
+//                     group
+
+#define IMAGE_FILTER_MODE_GAUSSIAN  0
+#define IMAGE_FILTER_MODE_BOX       1
+#define IMAGE_FILTER_MODE_BILATERAL 2
+#define IMAGE_FILTER_MODE_SOBEL     3
+
+#define IMAGE_FILTER_MODE_DOWNSAMPLE 0
+#define IMAGE_FILTER_MODE_UPSAMPLE   1
+
+struct ImageFilterParams
+{
+    uint2 srcSize;
+    uint2 dstSize;
+    uint  mode;
+    uint  radius;
+    float sigma;
+    float rangeSigma; // Bilateral only
+    uint  direction;  // Separable only, 0 is horizontal
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<ImageFilterParams> Params : register(b0);
+
+Texture2D<float4>   Src : register(t1);
+RWTexture2D<float4> Dst : register(u2);
+
+float4 LoadClamped(int2 coord)
+{
+    return Src.Load(int3(clamp(coord, int2(0, 0), int2(Params.srcSize) - 1), 0));
+}
+
+float SpatialWeight(int dx, int dy)
+{
+    if (Params.mode == IMAGE_FILTER_MODE_BOX) {
+        return 1.0;
+    }
+    return exp(-float(dx * dx + dy * dy) / (2.0 * Params.sigma * Params.sigma));
+}
+
+#if defined(FILTER_SEPARABLE)
+
+#define GROUP_SIZE 64
+#define MAX_RADIUS 32
+
+groupshared float4 Tile[GROUP_SIZE + 2 * MAX_RADIUS];
+
+[numthreads(GROUP_SIZE, 1, 1)] void csmain(uint3 gtid
+                                         : SV_GroupThreadID, uint3 gid
+                                         : SV_GroupID) {
+    const int  radius = int(Params.radius);
+    const int2 axis   = (Params.direction == 0) ? int2(1, 0) : int2(0, 1);
+    const int2 cross  = int2(1, 1) - axis;
+
+    // Groups are laid out along the filter direction, gid.y is the row or
+    // column they filter
+    const int2 base = axis * int(gid.x * GROUP_SIZE) + cross * int(gid.y);
+    for (int i = int(gtid.x); i < GROUP_SIZE + 2 * radius; i += GROUP_SIZE) {
+        Tile[i] = LoadClamped(base + axis * (i - radius));
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    const int2 pixel = base + axis * int(gtid.x);
+    if (any(pixel >= int2(Params.dstSize))) {
+        return;
+    }
+
+    float4 sum       = 0;
+    float  weightSum = 0;
+    for (int k = -radius; k <= radius; ++k) {
+        const float w = SpatialWeight(k, 0);
+        sum += w * Tile[int(gtid.x) + radius + k];
+        weightSum += w;
+    }
+
+    Dst[pixel] = sum / weightSum;
+}
+
+#elif defined(FILTER_2D)
+
+#define GROUP_SIZE 16
+#define MAX_RADIUS 4
+#define TILE_SIZE  (GROUP_SIZE + 2 * MAX_RADIUS)
+
+groupshared float4 Tile[TILE_SIZE * TILE_SIZE];
+
+float Luminance(float3 c)
+{
+    return dot(c, float3(0.3, 0.59, 0.11));
+}
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)] void csmain(uint3 tid
+                                                  : SV_DispatchThreadID, uint3 gtid
+                                                  : SV_GroupThreadID, uint3 gid
+                                                  : SV_GroupID) {
+    const int  radius = (Params.mode == IMAGE_FILTER_MODE_SOBEL) ? 1 : int(Params.radius);
+    const int  span   = GROUP_SIZE + 2 * radius;
+    const int2 origin = int2(gid.xy) * GROUP_SIZE - radius;
+    for (int i = int(gtid.y * GROUP_SIZE + gtid.x); i < span * span; i += GROUP_SIZE * GROUP_SIZE) {
+        const int2 t                = int2(i % span, i / span);
+        Tile[t.y * TILE_SIZE + t.x] = LoadClamped(origin + t);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (any(tid.xy >= Params.dstSize)) {
+        return;
+    }
+
+    const int2   center = int2(gtid.xy) + radius;
+    const float4 c      = Tile[center.y * TILE_SIZE + center.x];
+
+    if (Params.mode == IMAGE_FILTER_MODE_SOBEL) {
+        float gx = 0;
+        float gy = 0;
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                const float lum = Luminance(Tile[(center.y + y) * TILE_SIZE + center.x + x].rgb);
+                const float w   = (x == 0 || y == 0) ? 2.0 : 1.0;
+                gx += -x * w * lum;
+                gy += -y * w * lum;
+            }
+        }
+        const float magnitude = sqrt(gx * gx + gy * gy);
+        Dst[tid.xy]           = float4(magnitude.xxx, c.a);
+        return;
+    }
+
+    float4 sum       = 0;
+    float  weightSum = 0;
+    for (int y = -radius; y <= radius; ++y) {
+        for (int x = -radius; x <= radius; ++x) {
+            const float4 s = Tile[(center.y + y) * TILE_SIZE + center.x + x];
+            float        w = SpatialWeight(x, y);
+            if (Params.mode == IMAGE_FILTER_MODE_BILATERAL) {
+                const float3 d = s.rgb - c.rgb;
+                w *= exp(-dot(d, d) / (2.0 * Params.rangeSigma * Params.rangeSigma));
+            }
+            sum += w * s;
+            weightSum += w;
+        }
+    }
+
+    Dst[tid.xy] = sum / weightSum;
+}
+
+#elif defined(FILTER_RESAMPLE)
+
+#define GROUP_SIZE 8
+#define TILE_SIZE  (2 * GROUP_SIZE + 2)
+
+groupshared float4 Tile[TILE_SIZE * TILE_SIZE];
+
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)] void csmain(uint3 tid
+                                                  : SV_DispatchThreadID, uint3 gtid
+                                                  : SV_GroupThreadID, uint3 gid
+                                                  : SV_GroupID) {
+    const bool upsample = (Params.mode == IMAGE_FILTER_MODE_UPSAMPLE);
+
+    // Downsampling reads 2x the group plus one texel on each side, upsampling
+    // half the group plus one texel on each side
+    const int  span   = upsample ? (GROUP_SIZE / 2 + 2) : TILE_SIZE;
+    const int2 origin = upsample ? (int2(gid.xy) * (GROUP_SIZE / 2) - 1) : (int2(gid.xy) * (2 * GROUP_SIZE) - 1);
+    for (int i = int(gtid.y * GROUP_SIZE + gtid.x); i < span * span; i += GROUP_SIZE * GROUP_SIZE) {
+        const int2 t                = int2(i % span, i / span);
+        Tile[t.y * TILE_SIZE + t.x] = LoadClamped(origin + t);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (any(tid.xy >= Params.dstSize)) {
+        return;
+    }
+
+    float4 sum = 0;
+    if (upsample) {
+        const float weights[3] = {0.25, 0.5, 0.25};
+        const int2  center     = int2(gtid.xy) / 2 + 1;
+        for (int y = -1; y <= 1; ++y) {
+            for (int x = -1; x <= 1; ++x) {
+                sum += weights[x + 1] * weights[y + 1] * Tile[(center.y + y) * TILE_SIZE + center.x + x];
+            }
+        }
+        Dst[tid.xy] = Dst[tid.xy] + sum;
+    }
+    else {
+        const float weights[4] = {0.125, 0.375, 0.375, 0.125};
+        const int2  corner     = int2(gtid.xy) * 2;
+        for (int y = 0; y < 4; ++y) {
+            for (int x = 0; x < 4; ++x) {
+                sum += weights[x] * weights[y] * Tile[(corner.y + y) * TILE_SIZE + corner.x + x];
+            }
+        }
+        Dst[tid.xy] = sum;
+    }
+}
+
+#endif
@@ -0,0 +1,50 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Draws an object's world space bounding box for an occlusion query, see
+// scene::OcclusionPredicates. The box is generated from SV_VertexID, draw
+// 36 vertices without vertex buffers.
+
+// Must match scene_occlusion_predicates.cpp
+struct ProxyParams
+{
+    float4x4 viewProjectionMatrix; // offset = 0
+    float4   boundsMin;            // offset = 64, w unused
+    float4   boundsMax;            // offset = 80, w unused
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<ProxyParams> Params : register(b0);
+
+// Corners of the box's 12 triangles, x in bit 0, y in bit 1 and z in bit 2
+static const uint kCorners[36] = {
+    0, 2, 1, 1, 2, 3, // -z
+    4, 5, 6, 5, 7, 6, // +z
+    0, 1, 4, 1, 5, 4, // -y
+    2, 6, 3, 3, 6, 7, // +y
+    0, 4, 2, 2, 4, 6, // -x
+    1, 3, 5, 3, 7, 5, // +x
+};
+
+float4 vsmain(uint vertexId : SV_VertexID) : SV_POSITION
+{
+    const uint   corner   = kCorners[vertexId];
+    const float3 position = float3(
+        (corner & 1) ? Params.boundsMax.x : Params.boundsMin.x,
+        (corner & 2) ? Params.boundsMax.y : Params.boundsMin.y,
+        (corner & 4) ? Params.boundsMax.z : Params.boundsMin.z);
+    return mul(Params.viewProjectionMatrix, float4(position, 1));
+}
@@ -0,0 +1,404 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Kernels of grfx::ParallelPrimitives, one per define:
+//
+//   SCAN_REDUCE      Sums each tile of 1024 elements into the scratch buffer
+//   SCAN_DOWNSWEEP   Exclusive scan of each tile, offset by the scanned sum
+//                    of the tile if FLAG_ADD_PARTIALS is set
+//   COMPACT_SCATTER  Moves the flagged elements to their scanned offsets
+//   RADIX_HISTOGRAM  Counts the digits of each tile
+//   RADIX_SCATTER    Moves each tile's keys to their scanned digit offsets
+//
+// Groups of 256 threads handle 4 elements each. With USE_SUBGROUP_OPS the
+// group scans are wave prefix sums and the scatter ranks keys with wave
+// ballots. This needs subgroups of at least 16 lanes, so the subgroup
+// totals of a group fit in one subgroup.
+
+#define TILE_SIZE        1024
+#define GROUP_SIZE       256
+#define ITEMS_PER_THREAD (TILE_SIZE / GROUP_SIZE)
+#define RADIX_BITS       8
+#define RADIX_SIZE       (1 << RADIX_BITS)
+#define MIN_WAVE_SIZE    16
+#define MAX_WAVE_COUNT   (GROUP_SIZE / MIN_WAVE_SIZE)
+
+#define FLAG_INPUT_VALUES   0x1  // Scans read InputValues instead of InputKeys
+#define FLAG_INPUT_SCRATCH  0x2  // Scans read Scratch
+#define FLAG_OUTPUT_SCRATCH 0x4  // Scans write Scratch instead of OutputKeys
+#define FLAG_ADD_PARTIALS   0x8  // Scans add the scanned tile sums at scratchOffset
+#define FLAG_VALUES         0x10 // The scatter moves values with the keys
+
+struct ParallelPrimitivesParams
+{
+    uint count;         // Elements
+    uint inputOffset;   // Of the scan input
+    uint outputOffset;  // Of the scan output
+    uint scratchOffset; // Of the tile sums
+    uint tileCount;     // Of the sort
+    uint shift;         // Of the sort digit
+    uint flags;
+    uint padding;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<ParallelPrimitivesParams> Params : register(b0);
+
+RWStructuredBuffer<uint> InputKeys    : register(u1);
+RWStructuredBuffer<uint> OutputKeys   : register(u2);
+RWStructuredBuffer<uint> InputValues  : register(u3); // Flags of the compaction
+RWStructuredBuffer<uint> OutputValues : register(u4);
+RWStructuredBuffer<uint> Scratch      : register(u5); // Scanned flags or digit counts, then tile sums
+RWStructuredBuffer<uint> Count        : register(u6); // Compacted element count
+
+// -------------------------------------------------------------------------------------------------
+// Group scan
+// -------------------------------------------------------------------------------------------------
+
+groupshared uint sScan[GROUP_SIZE];
+groupshared uint sScanTotal;
+
+#if defined(USE_SUBGROUP_OPS)
+
+// Exclusive prefix sum of value over the group's threads
+uint GroupExclusiveSum(uint t, uint value, out uint total)
+{
+    const uint waveSize  = WaveGetLaneCount();
+    const uint waveCount = GROUP_SIZE / waveSize;
+    const uint wave      = t / waveSize;
+
+    const uint wavePrefix = WavePrefixSum(value);
+    if (WaveGetLaneIndex() == waveSize - 1) {
+        sScan[wave] = wavePrefix + value;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // The subgroup totals are scanned by the first subgroup
+    if (t < waveCount) {
+        const uint waveTotal = sScan[t];
+        const uint prefix    = WavePrefixSum(waveTotal);
+        sScan[t]             = prefix;
+        if (t == waveCount - 1) {
+            sScanTotal = prefix + waveTotal;
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint result = sScan[wave] + wavePrefix;
+    total             = sScanTotal;
+    GroupMemoryBarrierWithGroupSync();
+
+    return result;
+}
+
+#else
+
+// Exclusive prefix sum of value over the group's threads
+uint GroupExclusiveSum(uint t, uint value, out uint total)
+{
+    sScan[t] = value;
+    GroupMemoryBarrierWithGroupSync();
+
+    // Inclusive Hillis-Steele scan
+    [unroll]
+    for (uint offset = 1; offset < GROUP_SIZE; offset <<= 1) {
+        const uint other = (t >= offset) ? sScan[t - offset] : 0;
+        GroupMemoryBarrierWithGroupSync();
+        sScan[t] += other;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    const uint inclusive = sScan[t];
+    total                = sScan[GROUP_SIZE - 1];
+    GroupMemoryBarrierWithGroupSync();
+
+    return inclusive - value;
+}
+
+#endif
+
+uint LoadScanInput(uint i)
+{
+    if (Params.flags & FLAG_INPUT_SCRATCH) {
+        return Scratch[Params.inputOffset + i];
+    }
+    if (Params.flags & FLAG_INPUT_VALUES) {
+        return InputValues[Params.inputOffset + i];
+    }
+    return InputKeys[Params.inputOffset + i];
+}
+
+void StoreScanOutput(uint i, uint value)
+{
+    if (Params.flags & FLAG_OUTPUT_SCRATCH) {
+        Scratch[Params.outputOffset + i] = value;
+    }
+    else {
+        OutputKeys[Params.outputOffset + i] = value;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Kernels
+// -------------------------------------------------------------------------------------------------
+
+#if defined(SCAN_REDUCE)
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint3 threadId : SV_GroupThreadID)
+{
+    const uint t     = threadId.x;
+    const uint first = groupId.x * TILE_SIZE + t * ITEMS_PER_THREAD;
+
+    uint sum = 0;
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i) {
+        if ((first + i) < Params.count) {
+            sum += LoadScanInput(first + i);
+        }
+    }
+
+    uint total;
+    GroupExclusiveSum(t, sum, total);
+
+    if (t == 0) {
+        Scratch[Params.scratchOffset + groupId.x] = total;
+    }
+}
+
+#elif defined(SCAN_DOWNSWEEP)
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint3 threadId : SV_GroupThreadID)
+{
+    const uint t     = threadId.x;
+    const uint first = groupId.x * TILE_SIZE + t * ITEMS_PER_THREAD;
+
+    // Every thread reads its elements before any are written, so the
+    // output may be the input
+    uint items[ITEMS_PER_THREAD];
+    uint sum = 0;
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i) {
+        items[i] = ((first + i) < Params.count) ? LoadScanInput(first + i) : 0;
+        sum += items[i];
+    }
+
+    uint total;
+    uint prefix = GroupExclusiveSum(t, sum, total);
+    if (Params.flags & FLAG_ADD_PARTIALS) {
+        prefix += Scratch[Params.scratchOffset + groupId.x];
+    }
+
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i) {
+        if ((first + i) < Params.count) {
+            StoreScanOutput(first + i, prefix);
+        }
+        prefix += items[i];
+    }
+}
+
+#elif defined(COMPACT_SCATTER)
+
+[numthreads(GROUP_SIZE, 1, 1)]
+void csmain(uint3 dtid : SV_DispatchThreadID)
+{
+    const uint i = dtid.x;
+    if (i >= Params.count) {
+        if (i == 0) {
+            Count[0] = 0;
+        }
+        return;
+    }
+
+    // The flags were scanned to the start of the scratch buffer
+    const uint offset = Scratch[i];
+    const bool keep   = (InputValues[i] != 0);
+    if (keep) {
+        OutputKeys[offset] = InputKeys[i];
+    }
+    if (i == (Params.count - 1)) {
+        Count[0] = offset + (keep ? 1 : 0);
+    }
+}
+
+#elif defined(RADIX_HISTOGRAM)
+
+groupshared uint sDigitCounts[RADIX_SIZE];
+
+// Counts are written digit major, count of digit d in tile t at
+// d * tileCount + t, so their exclusive scan is the destination of the
+// first key of each digit of each tile
+[numthreads(GROUP_SIZE, 1, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint3 threadId : SV_GroupThreadID)
+{
+    const uint t = threadId.x;
+
+    sDigitCounts[t] = 0;
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint i = 0; i < ITEMS_PER_THREAD; ++i) {
+        const uint index = groupId.x * TILE_SIZE + i * GROUP_SIZE + t;
+        if (index < Params.count) {
+            const uint digit = (InputKeys[index] >> Params.shift) & (RADIX_SIZE - 1);
+            InterlockedAdd(sDigitCounts[digit], 1);
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    Scratch[t * Params.tileCount + groupId.x] = sDigitCounts[t];
+}
+
+#elif defined(RADIX_SCATTER)
+
+// Destination of the next key of each digit of the tile
+groupshared uint sDigitOffsets[RADIX_SIZE];
+
+#if defined(USE_SUBGROUP_OPS)
+
+// Keys of each digit in each subgroup this round
+groupshared uint sWaveCounts[MAX_WAVE_COUNT * RADIX_SIZE];
+
+uint CountBits(uint4 mask)
+{
+    return countbits(mask.x) + countbits(mask.y) + countbits(mask.z) + countbits(mask.w);
+}
+
+uint4 LanesBelowMask(uint lane)
+{
+    uint4 mask = 0;
+    for (uint i = 0; i < 4; ++i) {
+        const uint first = i * 32;
+        if (lane >= first + 32) {
+            mask[i] = 0xFFFFFFFF;
+        }
+        else if (lane > first) {
+            mask[i] = (1u << (lane - first)) - 1;
+        }
+    }
+    return mask;
+}
+
+void InitRanks(uint t)
+{
+    for (uint i = t; i < MAX_WAVE_COUNT * RADIX_SIZE; i += GROUP_SIZE) {
+        sWaveCounts[i] = 0;
+    }
+}
+
+// Number of valid keys with this digit in lower threads this round. The
+// subgroup's keys with the same digit are found with one ballot per digit
+// bit, the earlier subgroups' counts go through shared memory. leader is
+// set for the subgroup's first key of each digit.
+uint Rank(uint t, uint digit, bool valid, out bool leader)
+{
+    const uint wave = t / WaveGetLaneCount();
+
+    uint4 peers = WaveActiveBallot(valid);
+    [unroll]
+    for (uint bit = 0; bit < RADIX_BITS; ++bit) {
+        const bool  set    = ((digit >> bit) & 1) != 0;
+        const uint4 ballot = WaveActiveBallot(set);
+        peers &= set ? ballot : ~ballot;
+    }
+
+    const uint waveRank = CountBits(peers & LanesBelowMask(WaveGetLaneIndex()));
+    leader              = valid && (waveRank == 0);
+    if (leader) {
+        sWaveCounts[wave * RADIX_SIZE + digit] = CountBits(peers);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    uint rank = waveRank;
+    for (uint w = 0; w < wave; ++w) {
+        rank += sWaveCounts[w * RADIX_SIZE + digit];
+    }
+    return rank;
+}
+
+// Clears the entries the leaders wrote in Rank(), between the barriers
+// that follow it
+void ResetRanks(uint t, uint digit, bool leader)
+{
+    if (leader) {
+        sWaveCounts[(t / WaveGetLaneCount()) * RADIX_SIZE + digit] = 0;
+    }
+}
+
+#else
+
+// Digit of each thread's key this round
+groupshared uint sDigits[GROUP_SIZE];
+
+void InitRanks(uint t)
+{
+}
+
+// Number of valid keys with this digit in lower threads this round
+uint Rank(uint t, uint digit, bool valid, out bool leader)
+{
+    leader     = false;
+    sDigits[t] = valid ? digit : RADIX_SIZE;
+    GroupMemoryBarrierWithGroupSync();
+
+    uint rank = 0;
+    for (uint i = 0; i < t; ++i) {
+        rank += (sDigits[i] == digit) ? 1 : 0;
+    }
+    return rank;
+}
+
+void ResetRanks(uint t, uint digit, bool leader)
+{
+}
+
+#endif
+
+// Keys are moved in rounds of one per thread in index order, so equal
+// digits keep their order and the sort is stable
+[numthreads(GROUP_SIZE, 1, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint3 threadId : SV_GroupThreadID)
+{
+    const uint t = threadId.x;
+
+    sDigitOffsets[t] = Scratch[t * Params.tileCount + groupId.x];
+    InitRanks(t);
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint round = 0; round < ITEMS_PER_THREAD; ++round) {
+        const uint index = groupId.x * TILE_SIZE + round * GROUP_SIZE + t;
+        const bool valid = (index < Params.count);
+        const uint key   = valid ? InputKeys[index] : 0;
+        const uint digit = (key >> Params.shift) & (RADIX_SIZE - 1);
+        bool       leader;
+        const uint rank = Rank(t, digit, valid, leader);
+
+        if (valid) {
+            const uint dst  = sDigitOffsets[digit] + rank;
+            OutputKeys[dst] = key;
+            if (Params.flags & FLAG_VALUES) {
+                OutputValues[dst] = InputValues[index];
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if (valid) {
+            InterlockedAdd(sDigitOffsets[digit], 1);
+        }
+        ResetRanks(t, digit, leader);
+        GroupMemoryBarrierWithGroupSync();
+    }
+}
+
+#endif
@@ -0,0 +1,68 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Luminance variance of the pixels each shading rate texel covers, one 8x8
+// group per texel. Threads accumulate a strided subset of the texel's pixels
+// and the sums are reduced in group shared memory. The source can be of a
+// different size than the framebuffer, pixels are mapped with srcScale.
+
+struct ShadingRateVarianceParams
+{
+    uint2  srcSize;
+    uint2  texelSize;      // Framebuffer pixels per shading rate texel
+    uint2  attachmentSize; // Shading rate texels
+    float2 srcScale;       // Source pixels per framebuffer pixel
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<ShadingRateVarianceParams> Params : register(b0);
+
+Texture2D<float4>         Src      : register(t1);
+RWStructuredBuffer<float> Variance : register(u2);
+
+groupshared float2 Sums[64];
+
+[numthreads(8, 8, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint3 threadId : SV_GroupThreadID, uint threadIndex : SV_GroupIndex)
+{
+    const uint2 origin = groupId.xy * Params.texelSize;
+
+    float2 sum = 0;
+    for (uint y = threadId.y; y < Params.texelSize.y; y += 8) {
+        for (uint x = threadId.x; x < Params.texelSize.x; x += 8) {
+            uint2 coord = uint2(float2(origin + uint2(x, y)) * Params.srcScale);
+            coord       = min(coord, Params.srcSize - 1);
+
+            float luminance = dot(Src.Load(int3(coord, 0)).rgb, float3(0.2126, 0.7152, 0.0722));
+            sum += float2(luminance, luminance * luminance);
+        }
+    }
+    Sums[threadIndex] = sum;
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint stride = 32; stride > 0; stride >>= 1) {
+        if (threadIndex < stride) {
+            Sums[threadIndex] += Sums[threadIndex + stride];
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (threadIndex == 0) {
+        const float count = Params.texelSize.x * Params.texelSize.y;
+        const float mean  = Sums[0].x / count;
+        Variance[groupId.y * Params.attachmentSize.x + groupId.x] = max(Sums[0].y / count - mean * mean, 0.0);
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Skins the vertices of one primitive batch with linear blend skinning.
+// Positions are float3, attributes are copied and their normal and tangent
+// are skinned. Offsets are in bytes.
+
+#define NO_ATTRIBUTE 0xFFFFFFFF
+
+// Must match scene::GpuSkinner
+struct SkinParams
+{
+    uint vertexCount;
+    uint positionOffset;
+    uint attributeOffset;
+    uint attributeStride;
+    uint normalOffset;  // Within an attribute, NO_ATTRIBUTE if there's no normal
+    uint tangentOffset; // Within an attribute, NO_ATTRIBUTE if there's no tangent
+    uint skinOffset;
+    uint firstJoint;
+    uint outPositionOffset;
+    uint outAttributeOffset;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<SkinParams> Params : register(b0);
+
+StructuredBuffer<float4x4> Joints : register(t1);
+RWByteAddressBuffer        Src    : register(u2);
+RWByteAddressBuffer        Dst    : register(u3);
+
+[numthreads(64, 1, 1)] void csmain(uint3 tid
+                                 : SV_DispatchThreadID) {
+    const uint vertex = tid.x;
+    if (vertex >= Params.vertexCount) {
+        return;
+    }
+
+    // 4 UINT16 joints followed by 4 UNORM16 weights
+    const uint4  skin    = Src.Load4(Params.skinOffset + vertex * 16);
+    const uint4  joints  = uint4(skin.x & 0xFFFF, skin.x >> 16, skin.y & 0xFFFF, skin.y >> 16);
+    const float4 weights = float4(skin.z & 0xFFFF, skin.z >> 16, skin.w & 0xFFFF, skin.w >> 16) / 65535.0;
+
+    const float4x4 m = weights.x * Joints[Params.firstJoint + joints.x] +
+                       weights.y * Joints[Params.firstJoint + joints.y] +
+                       weights.z * Joints[Params.firstJoint + joints.z] +
+                       weights.w * Joints[Params.firstJoint + joints.w];
+
+    const float3 position = asfloat(Src.Load3(Params.positionOffset + vertex * 12));
+    Dst.Store3(Params.outPositionOffset + vertex * 12, asuint(mul(m, float4(position, 1)).xyz));
+
+    const uint srcAttribute = Params.attributeOffset + vertex * Params.attributeStride;
+    const uint dstAttribute = Params.outAttributeOffset + vertex * Params.attributeStride;
+    for (uint i = 0; i < Params.attributeStride; i += 4) {
+        Dst.Store(dstAttribute + i, Src.Load(srcAttribute + i));
+    }
+
+    if (Params.normalOffset != NO_ATTRIBUTE) {
+        const float3 normal = asfloat(Src.Load3(srcAttribute + Params.normalOffset));
+        Dst.Store3(dstAttribute + Params.normalOffset, asuint(normalize(mul((float3x3)m, normal))));
+    }
+    if (Params.tangentOffset != NO_ATTRIBUTE) {
+        const float4 tangent = asfloat(Src.Load4(srcAttribute + Params.tangentOffset));
+        Dst.Store3(dstAttribute + Params.tangentOffset, asuint(normalize(mul((float3x3)m, tangent.xyz))));
+    }
+}
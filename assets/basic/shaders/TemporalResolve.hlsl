@@ -0,0 +1,202 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Temporal anti-aliasing and upscaling resolve of grfx::TemporalResolve,
+// one thread per output pixel and 8x8 pixels per group.
+//
+//   1. Reproject: the history is fetched where the pixel was in the
+//      previous frame, from the motion vectors if there are any and from
+//      depth otherwise. The closest depth of the 3x3 neighbourhood is used
+//      so the edges of foreground objects carry their motion with them.
+//   2. Reject: the history is clipped to the color range of the current
+//      frame's 3x3 neighbourhood (variance clipping in YCoCg), which
+//      removes most of the ghosting of disocclusions and changing lighting.
+//   3. Accumulate: the weight of the current sample falls off with its
+//      distance from the output pixel's center, so when upscaling each
+//      output pixel converges to the samples that landed on it.
+//
+// Colors are blended with a reversible tonemap so that a single very
+// bright sample doesn't flicker through the history.
+
+#define TEMPORAL_RESOLVE_FLAG_HISTORY_VALID 0x1
+#define TEMPORAL_RESOLVE_FLAG_HAS_MOTION    0x2
+
+// Variance clipping box size in standard deviations
+#define CLIP_GAMMA 1.25
+
+struct TemporalResolveParams
+{
+    float4x4 reprojection;   // Current unjittered clip space to the previous frame's
+    float2   inputTexelSize; // 1 / input texture size
+    float2   renderSize;     // Rendered top left corner of the inputs, in pixels
+    float2   outputSize;     // History and output size, in pixels
+    float2   jitter;         // Sub-pixel offset of the current samples in render pixels, +y is down
+    float    blendFactor;    // Weight of a current sample that lands on the pixel center
+    uint     flags;          // TEMPORAL_RESOLVE_FLAG_*
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<TemporalResolveParams> Params : register(b0);
+
+Texture2D<float4>   Color         : register(t1);
+Texture2D<float>    Depth         : register(t2);
+Texture2D<float2>   Motion        : register(t3);
+Texture2D<float4>   History       : register(t4);
+RWTexture2D<float4> Output        : register(u5);
+SamplerState        LinearSampler : register(s6);
+
+float Luma(float3 c)
+{
+    return dot(c, float3(0.2126, 0.7152, 0.0722));
+}
+
+float3 Tonemap(float3 c)
+{
+    return c / (1.0 + Luma(c));
+}
+
+float3 InverseTonemap(float3 c)
+{
+    return c / max(1.0 - Luma(c), 0.0001);
+}
+
+float3 RGBToYCoCg(float3 c)
+{
+    return float3(
+        0.25 * c.r + 0.5 * c.g + 0.25 * c.b,
+        0.5 * c.r - 0.5 * c.b,
+        -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);
+}
+
+float3 YCoCgToRGB(float3 c)
+{
+    return float3(
+        c.x + c.y - c.z,
+        c.x + c.z,
+        c.x - c.y - c.z);
+}
+
+// Catmull-Rom filtered history in 5 bilinear taps, the corner taps are
+// dropped and the weights renormalized. Sharper than bilinear, which would
+// blur the history a little more every frame.
+float3 SampleHistory(float2 uv)
+{
+    float2 samplePos = uv * Params.outputSize;
+    float2 texPos1   = floor(samplePos - 0.5) + 0.5;
+    float2 f         = samplePos - texPos1;
+
+    float2 w0  = f * (-0.5 + f * (1.0 - 0.5 * f));
+    float2 w1  = 1.0 + f * f * (-2.5 + 1.5 * f);
+    float2 w2  = f * (0.5 + f * (2.0 - 1.5 * f));
+    float2 w3  = f * f * (-0.5 + 0.5 * f);
+    float2 w12 = w1 + w2;
+
+    float2 texPos0  = (texPos1 - 1.0) / Params.outputSize;
+    float2 texPos3  = (texPos1 + 2.0) / Params.outputSize;
+    float2 texPos12 = (texPos1 + w2 / w12) / Params.outputSize;
+
+    float3 result = (float3)0;
+    result += History.SampleLevel(LinearSampler, float2(texPos12.x, texPos0.y), 0).rgb * (w12.x * w0.y);
+    result += History.SampleLevel(LinearSampler, float2(texPos0.x, texPos12.y), 0).rgb * (w0.x * w12.y);
+    result += History.SampleLevel(LinearSampler, float2(texPos12.x, texPos12.y), 0).rgb * (w12.x * w12.y);
+    result += History.SampleLevel(LinearSampler, float2(texPos3.x, texPos12.y), 0).rgb * (w3.x * w12.y);
+    result += History.SampleLevel(LinearSampler, float2(texPos12.x, texPos3.y), 0).rgb * (w12.x * w3.y);
+
+    float weightSum = (w12.x * w0.y) + (w0.x * w12.y) + (w12.x * w12.y) + (w3.x * w12.y) + (w12.x * w3.y);
+    return max(result / weightSum, (float3)0);
+}
+
+// Moves history towards center until it's inside the box
+float3 ClipToBox(float3 history, float3 center, float3 extents)
+{
+    float3 offset  = history - center;
+    float3 units   = abs(offset / max(extents, (float3)0.0001));
+    float  maxUnit = max(units.x, max(units.y, units.z));
+    return (maxUnit > 1.0) ? (center + offset / maxUnit) : history;
+}
+
+[numthreads(8, 8, 1)] void csmain(uint3 tid
+                                  : SV_DispatchThreadID) {
+    if (any(tid.xy >= uint2(Params.outputSize))) {
+        return;
+    }
+
+    const int2   renderMax = int2(Params.renderSize) - 1;
+    const float2 outputUV  = (float2(tid.xy) + 0.5) / Params.outputSize;
+
+    // Position of the pixel center in render pixels, and the rendered
+    // sample closest to it. A sample stored at texel center c was taken at
+    // c - jitter.
+    const float2 renderPos = outputUV * Params.renderSize;
+    const int2   center    = clamp(int2(floor(renderPos + Params.jitter)), (int2)0, renderMax);
+
+    float3 current      = (float3)0;
+    float3 m1           = (float3)0;
+    float3 m2           = (float3)0;
+    float  closestDepth = 1.0;
+    int2   closestTexel = center;
+    for (int y = -1; y <= 1; ++y) {
+        for (int x = -1; x <= 1; ++x) {
+            int2   texel = clamp(center + int2(x, y), (int2)0, renderMax);
+            float3 c     = RGBToYCoCg(Tonemap(Color.Load(int3(texel, 0)).rgb));
+            m1 += c;
+            m2 += c * c;
+            if ((x == 0) && (y == 0)) {
+                current = c;
+            }
+
+            float depth = Depth.Load(int3(texel, 0));
+            if (depth < closestDepth) {
+                closestDepth = depth;
+                closestTexel = texel;
+            }
+        }
+    }
+
+    const float3 mean  = m1 / 9.0;
+    const float3 sigma = sqrt(max(m2 / 9.0 - mean * mean, (float3)0));
+
+    // Distance of the current sample from the pixel center in output pixels
+    const float2 sampleOffset  = (float2(center) + 0.5 - Params.jitter - renderPos) * (Params.outputSize / Params.renderSize);
+    const float  currentWeight = Params.blendFactor * exp(-2.29 * dot(sampleOffset, sampleOffset));
+
+    // Reproject
+    float2 prevUV = outputUV;
+    if (Params.flags & TEMPORAL_RESOLVE_FLAG_HAS_MOTION) {
+        prevUV = outputUV - Motion.Load(int3(closestTexel, 0));
+    }
+    else {
+        float4 clip     = float4(outputUV.x * 2.0 - 1.0, 1.0 - outputUV.y * 2.0, closestDepth, 1.0);
+        float4 prevClip = mul(Params.reprojection, clip);
+        float2 prevNDC  = prevClip.xy / prevClip.w;
+        prevUV          = float2(prevNDC.x * 0.5 + 0.5, 0.5 - prevNDC.y * 0.5);
+    }
+
+    const bool historyValid = (Params.flags & TEMPORAL_RESOLVE_FLAG_HISTORY_VALID) && all(prevUV >= 0.0) && all(prevUV <= 1.0);
+    if (!historyValid) {
+        Output[tid.xy] = float4(InverseTonemap(YCoCgToRGB(current)), 1);
+        return;
+    }
+
+    // Reject
+    float3 history = RGBToYCoCg(Tonemap(SampleHistory(prevUV)));
+    history        = ClipToBox(history, mean, CLIP_GAMMA * sigma);
+
+    // Accumulate, never fully stop taking new samples so the history
+    // can't get stuck
+    float3 result  = lerp(history, current, clamp(currentWeight, 0.01, 1.0));
+    Output[tid.xy] = float4(InverseTonemap(YCoCgToRGB(result)), 1);
+}
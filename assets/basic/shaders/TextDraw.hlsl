@@ -37,7 +37,15 @@ VSOutput vsmain(float4 Position : POSITION, float2 TexCoord : TEXCOORD0, float4
 
 float4 psmain(VSOutput input) : SV_TARGET
 {
+#if defined(TEXT_DRAW_SDF)
+    // Signed distance field font, the edge is at 0.5. Antialias over one
+    // screen pixel so the edge stays crisp at any scale.
+    float  distance = Tex0.Sample(Sampler0, input.TexCoord).x;
+    float  width    = max(fwidth(distance), 1e-5);
+    float4 value    = smoothstep(0.5 - width, 0.5 + width, distance).xxxx;
+#else
     float4 value  = Tex0.Sample(Sampler0, input.TexCoord).xxxx;    
+#endif
     float4 output = value * input.Color4;
     return output;
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Kernel of benchmarks/compute_occupancy, compiled once per variant with:
+//   - GROUP_SIZE: threads per workgroup
+//   - SHARED_UINTS: groupshared array size, 0 for none
+//   - REGISTERS: uints kept live by every thread
+//   - SUBGROUP_OP: one of the SUBGROUP_OP_* below
+// Every iteration does the same KERNEL_OPS multiply-adds whatever the number
+// of registers they are spread over, plus one shared memory word written and
+// read, or one subgroup op, when the variant has them.
+
+#ifndef GROUP_SIZE
+#define GROUP_SIZE 256
+#endif
+#ifndef SHARED_UINTS
+#define SHARED_UINTS 0
+#endif
+#ifndef REGISTERS
+#define REGISTERS 8
+#endif
+#ifndef SUBGROUP_OP
+#define SUBGROUP_OP 0
+#endif
+
+#define SUBGROUP_OP_NONE       0
+#define SUBGROUP_OP_REDUCE     1
+#define SUBGROUP_OP_PREFIX_SUM 2
+#define SUBGROUP_OP_BALLOT     3
+
+#define KERNEL_OPS 128
+
+// Must match benchmarks/compute_occupancy
+struct ComputeOccupancyParams
+{
+    uint threadCount;
+    uint iterations;
+    uint seed;
+    uint padding;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<ComputeOccupancyParams> Params : register(b0);
+
+RWByteAddressBuffer Output : register(u1);
+
+#if SHARED_UINTS > 0
+groupshared uint Shared[SHARED_UINTS];
+#endif
+
+[numthreads(GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                           : SV_DispatchThreadID, uint3 gtid
+                                           : SV_GroupThreadID) {
+    uint r[REGISTERS];
+    [unroll] for (uint i = 0; i < REGISTERS; ++i)
+    {
+        r[i] = tid.x * (2 * i + 1) + Params.seed;
+    }
+
+    for (uint it = 0; it < Params.iterations; ++it) {
+        [unroll] for (uint k = 0; k < KERNEL_OPS; ++k)
+        {
+            r[k % REGISTERS] = r[k % REGISTERS] * 1664525u + r[(k + 1) % REGISTERS];
+        }
+
+#if SHARED_UINTS > 0
+        // One word written and one read per thread, the words move every
+        // iteration so that the whole array is used
+        const uint base = (it * GROUP_SIZE) % SHARED_UINTS;
+        Shared[(base + gtid.x) % SHARED_UINTS] = r[0];
+        GroupMemoryBarrierWithGroupSync();
+        r[1] ^= Shared[(base + GROUP_SIZE - 1 - gtid.x) % SHARED_UINTS];
+        GroupMemoryBarrierWithGroupSync();
+#endif
+
+#if SUBGROUP_OP == SUBGROUP_OP_REDUCE
+        r[0] += WaveActiveSum(r[1]);
+#elif SUBGROUP_OP == SUBGROUP_OP_PREFIX_SUM
+        r[0] += WavePrefixSum(r[1]);
+#elif SUBGROUP_OP == SUBGROUP_OP_BALLOT
+        r[0] += countbits(WaveActiveBallot((r[1] & 1) != 0).x);
+#endif
+    }
+
+    // Threads past threadCount still run the loop so that every workgroup
+    // reaches the barriers, they just don't write
+    uint result = 0;
+    [unroll] for (uint i = 0; i < REGISTERS; ++i)
+    {
+        result ^= r[i];
+    }
+    if (tid.x < Params.threadCount) {
+        Output.Store(4 * tid.x, result);
+    }
+}
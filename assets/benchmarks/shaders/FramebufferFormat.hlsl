@@ -0,0 +1,64 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Fullscreen layers drawn by benchmarks/framebuffer_format. Noise defeats
+// lossless framebuffer compression, smooth gradients are what it is good at.
+
+struct FramebufferParams
+{
+    uint   layer;
+    uint   smoothContent;
+    float2 invSize; // 1 / render target size
+};
+
+[[vk::push_constant]]
+ConstantBuffer<FramebufferParams> Params : register(b0);
+
+struct VSOutput
+{
+    float4 Position : SV_POSITION;
+};
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Fullscreen triangle
+VSOutput vsmain(uint VertexID : SV_VertexID)
+{
+    float2 uv = float2((VertexID << 1) & 2, VertexID & 2);
+
+    VSOutput result;
+    result.Position = float4(uv * float2(2, -2) + float2(-1, 1), 0, 1);
+    return result;
+}
+
+// Alpha 0.5 so that the blended layers keep changing the render target
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    if (Params.smoothContent != 0) {
+        float2 uv = input.Position.xy * Params.invSize;
+        return float4(uv, frac(Params.layer * 0.125f), 0.5f);
+    }
+
+    uint2 pixel = uint2(input.Position.xy);
+    uint  h     = Hash(Params.layer ^ Hash(pixel.x ^ Hash(pixel.y)));
+    return float4(float3(h & 0x3FF, (h >> 10) & 0x3FF, (h >> 20) & 0x3FF) / 1023.0f, 0.5f);
+}
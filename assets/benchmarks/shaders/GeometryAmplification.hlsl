@@ -0,0 +1,46 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Emits AMPLIFICATION triangles per input triangle, each slightly offset.
+// Used between PassThroughPos.vs and PassThroughPos.ps, see
+// benchmarks/tessellation_geometry.
+
+#ifndef AMPLIFICATION
+#define AMPLIFICATION 1
+#endif
+
+struct GSInput
+{
+    float4 Position : SV_POSITION;
+};
+
+struct GSOutput
+{
+    float4 Position : SV_POSITION;
+};
+
+[maxvertexcount(3 * AMPLIFICATION)]
+void gsmain(triangle GSInput input[3], inout TriangleStream<GSOutput> stream)
+{
+    [unroll]
+    for (uint i = 0; i < AMPLIFICATION; ++i) {
+        const float4 offset = float4(0.001f * i, 0.0f, 0.0f, 0.0f);
+        for (uint j = 0; j < 3; ++j) {
+            GSOutput output;
+            output.Position = input[j].Position + offset;
+            stream.Append(output);
+        }
+        stream.RestartStrip();
+    }
+}
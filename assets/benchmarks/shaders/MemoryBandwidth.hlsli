@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Shared by the MemoryBandwidth*.hlsl shaders of benchmarks/memory_bandwidth.
+// Each thread accesses elementsPerThread 16-byte elements, element i of a
+// thread being linear index i * threadCount + thread. Linear indices wrap
+// around elementCount, so small sizes are accessed several times by a single
+// dispatch. The access pattern maps them to elements with a permutation of
+// [0, elementCount), every element is accessed as often as the others:
+//   - coalesced: the identity, neighbouring threads access neighbouring elements
+//   - strided: multiplied by an odd stride, neighbouring threads are stride elements apart
+//   - random: a hash, no locality at all
+
+#define MEMORY_BANDWIDTH_OP_READ  0
+#define MEMORY_BANDWIDTH_OP_WRITE 1
+#define MEMORY_BANDWIDTH_OP_COPY  2
+
+#define MEMORY_BANDWIDTH_PATTERN_COALESCED 0
+#define MEMORY_BANDWIDTH_PATTERN_STRIDED   1
+#define MEMORY_BANDWIDTH_PATTERN_RANDOM    2
+
+#define MEMORY_BANDWIDTH_GROUP_SIZE   64
+#define MEMORY_BANDWIDTH_IMAGE_WIDTH  4096
+#define MEMORY_BANDWIDTH_UNIFORM_SIZE 4096 // Elements, 64 KiB
+
+// Must match benchmarks/memory_bandwidth
+struct MemoryBandwidthParams
+{
+    uint elementCount; // Power of 2
+    uint elementBits;  // log2(elementCount)
+    uint threadCount;  // Power of 2
+    uint elementsPerThread;
+    uint op;
+    uint pattern;
+    uint stride; // Odd
+    uint seed;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<MemoryBandwidthParams> Params : register(b0);
+
+uint ElementIndex(uint linearIndex)
+{
+    const uint mask = Params.elementCount - 1;
+    linearIndex &= mask;
+    if (Params.pattern == MEMORY_BANDWIDTH_PATTERN_STRIDED) {
+        return (linearIndex * Params.stride) & mask;
+    }
+    if (Params.pattern == MEMORY_BANDWIDTH_PATTERN_RANDOM) {
+        // Odd multiplications and xor-shifts are both invertible modulo 2^elementBits
+        const uint shift = max(Params.elementBits / 2, 1);
+        uint       x     = (linearIndex ^ Params.seed) & mask;
+        x                = (x * 0x9E3779B1u) & mask;
+        x ^= x >> shift;
+        x = (x * 0x85EBCA6Bu) & mask;
+        x ^= x >> shift;
+        return x;
+    }
+    return linearIndex;
+}
+
+// Keeps reads from being optimized out, the condition is practically never true
+void KeepResult(RWByteAddressBuffer dst, uint4 sum)
+{
+    if (all(sum == 0xFFFFFFFFu)) {
+        dst.Store4(0, sum);
+    }
+}
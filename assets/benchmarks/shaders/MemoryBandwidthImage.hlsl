@@ -0,0 +1,45 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "MemoryBandwidth.hlsli"
+
+// Element i is texel (i % width, i / width)
+RWTexture2D<uint4>  Src : register(u1);
+RWTexture2D<uint4>  Dst : register(u2);
+RWByteAddressBuffer Result : register(u3);
+
+[numthreads(MEMORY_BANDWIDTH_GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                                            : SV_DispatchThreadID) {
+    const uint thread = tid.x;
+    if (thread >= Params.threadCount) {
+        return;
+    }
+
+    uint4 sum = 0;
+    for (uint i = 0; i < Params.elementsPerThread; ++i) {
+        const uint  linearIndex = i * Params.threadCount + thread;
+        const uint  index       = ElementIndex(linearIndex);
+        const uint2 texel       = uint2(index % MEMORY_BANDWIDTH_IMAGE_WIDTH, index / MEMORY_BANDWIDTH_IMAGE_WIDTH);
+        if (Params.op == MEMORY_BANDWIDTH_OP_READ) {
+            sum ^= Src[texel];
+        }
+        else if (Params.op == MEMORY_BANDWIDTH_OP_WRITE) {
+            Dst[texel] = uint4(linearIndex, thread, i, Params.seed);
+        }
+        else {
+            Dst[texel] = Src[texel];
+        }
+    }
+    KeepResult(Result, sum);
+}
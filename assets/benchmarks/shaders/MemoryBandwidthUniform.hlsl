@@ -0,0 +1,44 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "MemoryBandwidth.hlsli"
+
+// Uniform buffers are at most 64 KiB, larger sizes aren't measured
+struct UniformData
+{
+    uint4 elements[MEMORY_BANDWIDTH_UNIFORM_SIZE];
+};
+
+ConstantBuffer<UniformData> Src : register(b1);
+RWByteAddressBuffer         Dst : register(u2);
+
+[numthreads(MEMORY_BANDWIDTH_GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                                            : SV_DispatchThreadID) {
+    const uint thread = tid.x;
+    if (thread >= Params.threadCount) {
+        return;
+    }
+
+    uint4 sum = 0;
+    for (uint i = 0; i < Params.elementsPerThread; ++i) {
+        const uint index = ElementIndex(i * Params.threadCount + thread);
+        if (Params.op == MEMORY_BANDWIDTH_OP_COPY) {
+            Dst.Store4(16 * index, Src.elements[index]);
+        }
+        else {
+            sum ^= Src.elements[index];
+        }
+    }
+    KeepResult(Dst, sum);
+}
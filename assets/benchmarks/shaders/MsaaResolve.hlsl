@@ -0,0 +1,47 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Used by benchmarks/msaa_resolve. The color varies per pixel and per
+// triangle so that framebuffer compression can't reduce the samples of the
+// edges to a single value, which would hide the cost of storing them.
+
+struct VSOutput {
+    float4               Position : SV_POSITION;
+    nointerpolation uint Seed     : SEED;
+};
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352Du;
+    x ^= x >> 15;
+    x *= 0x846CA68Bu;
+    x ^= x >> 16;
+    return x;
+}
+
+VSOutput vsmain(float4 Position : POSITION, uint VertexID : SV_VertexID)
+{
+    VSOutput result;
+    result.Position = Position;
+    result.Seed     = Hash(VertexID);
+    return result;
+}
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    uint2 pixel = uint2(input.Position.xy);
+    uint  h     = Hash(input.Seed ^ (pixel.x * 73856093u) ^ (pixel.y * 19349663u));
+    return float4(h & 0xFF, (h >> 8) & 0xFF, (h >> 16) & 0xFF, 255) / 255.0f;
+}
@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Mesh shader counterpart of PassThroughPos.vs, pairs with PassThroughPos.ps.
+// One group per ppx::Meshlet, limits must match MeshletMesh::Create().
+
+#define MAX_VERTICES  64
+#define MAX_TRIANGLES 124
+#define GROUP_SIZE    128
+
+struct Meshlet
+{
+    uint vertexOffset;
+    uint vertexCount;
+    uint triangleOffset;
+    uint triangleCount;
+};
+
+struct DrawParams
+{
+    uint meshletCount;
+    uint groupCountX; // Meshlets are spread over Y once X reaches the group count limit
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<DrawParams> Params : register(b0);
+
+StructuredBuffer<Meshlet> Meshlets      : register(t1);
+StructuredBuffer<float3>  Positions     : register(t2);
+StructuredBuffer<uint>    VertexIndices : register(t3);
+StructuredBuffer<uint>    Triangles     : register(t4); // 8 bit local indices
+
+struct VSOutput {
+    float4 Position : SV_POSITION;
+};
+
+[outputtopology("triangle")]
+[numthreads(GROUP_SIZE, 1, 1)]
+void msmain(
+    uint                  tid : SV_GroupThreadID,
+    uint3                 gid : SV_GroupID,
+    out indices uint3     tris[MAX_TRIANGLES],
+    out vertices VSOutput verts[MAX_VERTICES])
+{
+    uint meshletIndex = gid.y * Params.groupCountX + gid.x;
+    if (meshletIndex >= Params.meshletCount) {
+        SetMeshOutputCounts(0, 0);
+        return;
+    }
+
+    Meshlet meshlet = Meshlets[meshletIndex];
+    SetMeshOutputCounts(meshlet.vertexCount, meshlet.triangleCount);
+
+    if (tid < meshlet.vertexCount) {
+        uint vertexIndex    = VertexIndices[meshlet.vertexOffset + tid];
+        verts[tid].Position = float4(Positions[vertexIndex], 1.0f);
+    }
+
+    if (tid < meshlet.triangleCount) {
+        uint packed = Triangles[meshlet.triangleOffset + tid];
+        tris[tid]   = uint3(packed & 0xFF, (packed >> 8) & 0xFF, (packed >> 16) & 0xFF);
+    }
+}
@@ -0,0 +1,44 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// PassThroughPos with an offset from a uniform buffer and one from push
+// constants, so benchmarks/draw_call's --state-change binds are not dead.
+
+struct StateChangeParams
+{
+    float4 offset;
+};
+
+ConstantBuffer<StateChangeParams> Uniforms : register(b0);
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<StateChangeParams> Constants : register(b1);
+
+struct VSOutput {
+    float4 Position : SV_POSITION;
+};
+
+VSOutput vsmain(float4 Position : POSITION)
+{
+    VSOutput result;
+    result.Position = Position + Uniforms.offset + Constants.offset;
+    return result;
+}
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    return float4(1.0f, 0.0f, 0.0f, 1.0f);
+}
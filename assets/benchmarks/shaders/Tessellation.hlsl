@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tessellates each input triangle with the same integer edge and inner
+// factors, see benchmarks/tessellation_geometry.
+
+struct TessellationParams
+{
+    float tessFactor;
+    uint3 padding;
+};
+
+[[vk::push_constant]]
+ConstantBuffer<TessellationParams> Params : register(b0);
+
+struct ControlPoint
+{
+    float4 Position : POSITION;
+};
+
+struct PatchConstants
+{
+    float Edges[3] : SV_TessFactor;
+    float Inside   : SV_InsideTessFactor;
+};
+
+struct DSOutput
+{
+    float4 Position : SV_POSITION;
+};
+
+ControlPoint vsmain(float4 Position : POSITION)
+{
+    ControlPoint result;
+    result.Position = Position;
+    return result;
+}
+
+PatchConstants PatchConstantsMain(InputPatch<ControlPoint, 3> patch)
+{
+    PatchConstants result;
+    result.Edges[0] = Params.tessFactor;
+    result.Edges[1] = Params.tessFactor;
+    result.Edges[2] = Params.tessFactor;
+    result.Inside   = Params.tessFactor;
+    return result;
+}
+
+[domain("tri")]
+[partitioning("integer")]
+[outputtopology("triangle_ccw")]
+[outputcontrolpoints(3)]
+[patchconstantfunc("PatchConstantsMain")]
+[maxtessfactor(64.0)]
+ControlPoint hsmain(InputPatch<ControlPoint, 3> patch, uint i : SV_OutputControlPointID)
+{
+    return patch[i];
+}
+
+[domain("tri")]
+DSOutput dsmain(PatchConstants constants, float3 uvw : SV_DomainLocation, const OutputPatch<ControlPoint, 3> patch)
+{
+    DSOutput result;
+    result.Position = uvw.x * patch[0].Position + uvw.y * patch[1].Position + uvw.z * patch[2].Position;
+    return result;
+}
+
+float4 psmain(DSOutput input) : SV_TARGET
+{
+    return float4(1.0f, 0.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,37 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef DEVICE_ADDRESS_HLSLI
+#define DEVICE_ADDRESS_HLSLI
+
+// Loads through addresses from grfx::Buffer::GetDeviceAddress(). Push
+// constants are 32-bit values, so an address takes two of them with the
+// low bits first, the same layout as a uint64_t on the CPU.
+//
+// Vulkan only, DXIL has no loads through addresses.
+//
+#if defined(PPX_VULKAN)
+
+uint64_t MakeDeviceAddress(uint2 lowHigh)
+{
+    return (uint64_t(lowHigh.y) << 32) | uint64_t(lowHigh.x);
+}
+
+// Loads the element at index from an array of T starting at address. T's
+// size must match the CPU struct, see -fvk-use-dx-layout.
+#define LOAD_DEVICE_ADDRESS(T, address, index) vk::RawBufferLoad<T>((address) + (index) * sizeof(T))
+
+#endif // defined(PPX_VULKAN)
+
+#endif // DEVICE_ADDRESS_HLSLI
@@ -0,0 +1,86 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SPARSE_FEEDBACK_HLSLI
+#define SPARSE_FEEDBACK_HLSLI
+
+// Matches grfx::SparseImageFeedbackConstants
+struct SparseFeedbackConstants
+{
+    uint2 Size;
+    uint2 TileSize;
+    uint  FirstMipTailLevel;
+    uint  TilesPerLayer;
+    uint2 Padding;
+};
+
+// Index of the tile at uv, in grfx::Image::GetSparseTileIndex() order.
+// Returns 0xFFFFFFFF for mip levels in the mip tail.
+uint SparseFeedbackTileIndex(SparseFeedbackConstants c, float2 uv, uint mipLevel, uint arrayLayer)
+{
+    if (mipLevel >= c.FirstMipTailLevel) {
+        return 0xFFFFFFFF;
+    }
+
+    uint index = arrayLayer * c.TilesPerLayer;
+    for (uint mip = 0; mip < mipLevel; ++mip) {
+        uint2 size   = max(c.Size >> mip, uint2(1, 1));
+        uint2 counts = (size + c.TileSize - 1) / c.TileSize;
+        index += counts.x * counts.y;
+    }
+
+    uint2 size   = max(c.Size >> mipLevel, uint2(1, 1));
+    uint2 counts = (size + c.TileSize - 1) / c.TileSize;
+    uint2 tile   = min(uint2(saturate(uv) * size) / c.TileSize, counts - 1);
+    return index + tile.y * counts.x + tile.x;
+}
+
+// Marks the tile that a sample at uv and lod reads as sampled
+void SparseFeedbackWrite(RWStructuredBuffer<uint> feedback, SparseFeedbackConstants c, float2 uv, float lod, uint arrayLayer)
+{
+    uint index = SparseFeedbackTileIndex(c, uv, (uint)max(lod, 0.0), arrayLayer);
+    if (index != 0xFFFFFFFF) {
+        feedback[index] = 1;
+    }
+}
+
+// Samples a sparse resident texture and records the tile it needs. If that
+// tile isn't resident the closest coarser resident mip level is used, the
+// mip tail always is.
+float4 SparseFeedbackSample(
+    Texture2D                tex,
+    SamplerState             s,
+    RWStructuredBuffer<uint> feedback,
+    SparseFeedbackConstants  c,
+    float2                   uv)
+{
+    float lod = tex.CalculateLevelOfDetail(s, uv);
+    SparseFeedbackWrite(feedback, c, uv, lod, 0);
+
+    uint   status = 0;
+    float4 color  = tex.Sample(s, uv, int2(0, 0), 0.0, status);
+    if (CheckAccessFullyMapped(status)) {
+        return color;
+    }
+
+    for (uint mip = (uint)max(lod, 0.0) + 1; mip < c.FirstMipTailLevel; ++mip) {
+        color = tex.SampleLevel(s, uv, mip, int2(0, 0), status);
+        if (CheckAccessFullyMapped(status)) {
+            return color;
+        }
+    }
+    return tex.SampleLevel(s, uv, c.FirstMipTailLevel);
+}
+
+#endif // SPARSE_FEEDBACK_HLSLI
@@ -42,6 +42,10 @@
 #define RENDER_CURRENT_VELOCITY_TEXTURE_REGISTER   t15 // FLOCKING_SPACE
 #define RENDER_OUTPUT_POSITION_TEXTURE_REGISTER    u16 // FLOCKING_SPACE
 #define RENDER_OUTPUT_VELOCITY_TEXTURE_REGISTER    u17 // FLOCKING_SPACE
+#define RENDER_GRID_CELL_COUNT_REGISTER            u18 // FLOCKING_SPACE
+#define RENDER_GRID_CELL_START_REGISTER            u19 // FLOCKING_SPACE
+#define RENDER_GRID_FISH_CELL_REGISTER             u20 // FLOCKING_SPACE
+#define RENDER_GRID_SORTED_FISH_REGISTER           u21 // FLOCKING_SPACE
 
 // -------------------------------------------------------------------------------------------------
 // VS/PS Input and Output
@@ -121,6 +125,8 @@ struct FlockingData
     float  timeDelta;
     float3 predPos;
     float3 camPos;
+    uint   gridMask;
+    uint   useGrid;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FLOCKING_GRID_HLSLI
+#define FLOCKING_GRID_HLSLI
+
+// Spatial hash grid used to find the neighbors of each fish, built every frame by
+// FlockingGridCount.hlsl, FlockingGridScan.hlsl and FlockingGridScatter.hlsl.
+//
+// Cells are as large as the flocking zone radius so all the neighbors of a fish are in the
+// 3x3x3 cells around its own. Cells are hashed into (Flocking.gridMask + 1) buckets, fish of
+// different cells can end up in the same bucket.
+//
+// Expects the Flocking constant buffer to be declared before inclusion.
+
+int3 GridCell(float3 position)
+{
+    return (int3)floor(position / Flocking.zoneRadius);
+}
+
+uint GridBucket(int3 cell)
+{
+    // Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+    uint3 c = (uint3)cell;
+    return ((c.x * 73856093U) ^ (c.y * 19349663U) ^ (c.z * 83492791U)) & Flocking.gridMask;
+}
+
+uint FishIndex(uint2 xy)
+{
+    return xy.y * (uint)Flocking.resX + xy.x;
+}
+
+uint2 FishCoord(uint index)
+{
+    return uint2(index % (uint)Flocking.resX, index / (uint)Flocking.resX);
+}
+
+#endif // FLOCKING_GRID_HLSLI
@@ -0,0 +1,69 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Config.hlsli"
+
+#define SCAN_THREADS 256
+
+ConstantBuffer<FlockingData> Flocking      : register(RENDER_FLOCKING_DATA_REGISTER, space0);   // Flocking params
+RWStructuredBuffer<uint>     GridCellCount : register(RENDER_GRID_CELL_COUNT_REGISTER, space0); // Fish per bucket
+RWStructuredBuffer<uint>     GridCellStart : register(RENDER_GRID_CELL_START_REGISTER, space0); // First sorted fish per bucket
+
+groupshared uint ScanSums[2][SCAN_THREADS];
+
+// Exclusive prefix sum of the bucket counts, dispatched as a single group. Each thread sums a
+// contiguous chunk of buckets, the chunk sums are scanned in group shared memory and each thread
+// then writes the start of its buckets. GridCellStart has one extra entry holding the fish count
+// so that a bucket ends where the next one starts.
+//
+// The counts are cleared for the next frame once read.
+[numthreads(SCAN_THREADS, 1, 1)]
+void csmain(uint3 tid : SV_DispatchThreadID)
+{
+    const uint bucketCount = Flocking.gridMask + 1;
+    const uint chunkSize   = (bucketCount + SCAN_THREADS - 1) / SCAN_THREADS;
+    const uint first       = min(tid.x * chunkSize, bucketCount);
+    const uint last        = min(first + chunkSize, bucketCount);
+
+    uint sum = 0;
+    for (uint i = first; i < last; ++i) {
+        sum += GridCellCount[i];
+    }
+    ScanSums[0][tid.x] = sum;
+    GroupMemoryBarrierWithGroupSync();
+
+    // Inclusive Hillis-Steele scan of the chunk sums
+    uint src = 0;
+    for (uint offset = 1; offset < SCAN_THREADS; offset <<= 1) {
+        uint value = ScanSums[src][tid.x];
+        if (tid.x >= offset) {
+            value += ScanSums[src][tid.x - offset];
+        }
+        ScanSums[src ^ 1][tid.x] = value;
+        src ^= 1;
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    uint start = ScanSums[src][tid.x] - sum;
+    for (uint i = first; i < last; ++i) {
+        const uint count = GridCellCount[i];
+        GridCellStart[i] = start;
+        GridCellCount[i] = 0;
+        start += count;
+    }
+
+    if (tid.x == 0) {
+        GridCellStart[bucketCount] = ScanSums[src][SCAN_THREADS - 1];
+    }
+}
@@ -0,0 +1,31 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "Config.hlsli"
+
+ConstantBuffer<FlockingData> Flocking       : register(RENDER_FLOCKING_DATA_REGISTER, space0);    // Flocking params
+RWStructuredBuffer<uint>     GridCellStart  : register(RENDER_GRID_CELL_START_REGISTER, space0);  // First sorted fish per bucket
+RWStructuredBuffer<uint2>    GridFishCell   : register(RENDER_GRID_FISH_CELL_REGISTER, space0);   // Bucket and slot of each fish
+RWStructuredBuffer<uint>     GridSortedFish : register(RENDER_GRID_SORTED_FISH_REGISTER, space0); // Fish sorted by bucket
+
+#include "FlockingGrid.hlsli"
+
+[numthreads(8, 8, 1)]
+void csmain(uint3 tid : SV_DispatchThreadID)
+{
+    const uint  fish     = FishIndex(tid.xy);
+    const uint2 fishCell = GridFishCell[fish];
+
+    GridSortedFish[GridCellStart[fishCell.x] + fishCell.y] = fish;
+}
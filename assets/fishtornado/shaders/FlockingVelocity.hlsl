@@ -18,6 +18,45 @@ ConstantBuffer<FlockingData> Flocking           : register(RENDER_FLOCKING_DATA_
 Texture2D<float4>            InPositionTexture  : register(RENDER_PREVIOUS_POSITION_TEXTURE_REGISTER, space0);  // Previous position
 Texture2D<float4>            InVelocityTexture  : register(RENDER_PREVIOUS_VELOCITY_TEXTURE_REGISTER, space0);  // Previous velocity
 RWTexture2D<float4>          OutVelocityTexture : register(RENDER_OUTPUT_VELOCITY_TEXTURE_REGISTER, space0);    // Out position
+RWStructuredBuffer<uint>     GridCellStart      : register(RENDER_GRID_CELL_START_REGISTER, space0);            // First sorted fish per bucket
+RWStructuredBuffer<uint>     GridSortedFish     : register(RENDER_GRID_SORTED_FISH_REGISTER, space0);           // Fish sorted by bucket
+
+#include "FlockingGrid.hlsli"
+
+// Applies the attraction, alignment, and repulsion forces of the fish at xy
+void ApplyNeighbor(int2 xy, int2 myXY, float3 myPos, float accMulti, float zoneRadSqrd, inout float3 acc, inout float crowded)
+{
+    float3 pos      = InPositionTexture[xy].xyz;
+    float3 vel      = InVelocityTexture[xy].xyz;
+    float3 dir      = myPos - pos;
+    float  distSqrd = dot(dir, dir);
+
+    if ((xy.x != myXY.x) && (xy.y != myXY.y) && (distSqrd < zoneRadSqrd)) {
+        float3 dirNorm  = normalize(dir);
+        float  percent  = distSqrd / zoneRadSqrd;
+        float  crowdPer = 1.0 - percent;
+
+        if (percent < Flocking.minThresh) {
+            float F = (Flocking.minThresh / percent - 1.0) * accMulti;
+            acc += dirNorm * F;
+            crowded += crowdPer; //  * 2.0
+        }
+        else if (percent < Flocking.maxThresh) {
+            float threshDelta     = Flocking.maxThresh - Flocking.minThresh;
+            float adjustedPercent = (percent - Flocking.minThresh) / threshDelta;
+            float F               = (1.0 - (cos(adjustedPercent * 6.28318) * -0.5 + 0.5)) * accMulti;
+            acc += normalize(vel) * F;
+            crowded += crowdPer * 0.5;
+        }
+        else {
+            float threshDelta     = 1.0 - Flocking.maxThresh;
+            float adjustedPercent = (percent - Flocking.maxThresh) / threshDelta;
+            float F               = (1.0 - (cos(adjustedPercent * 6.28318) * -0.5 + 0.5)) * accMulti;
+            acc += -dirNorm * F;
+            crowded += crowdPer * 0.25;
+        }
+    }
+}
 
 // -------------------------------------------------------------------------------------------------
 
@@ -48,47 +87,40 @@ void csmain(uint3 tid : SV_DispatchThreadID)
     float threshDelta1 = 1.0 - Flocking.maxThresh;
 
     // Apply the attraction, alignment, and repulsion forces
-    // 
+    //
     // Tempted to use Texture2D::GetDimensions()?
-    //   - Some micro benchmarking shows it's slow: 
+    //   - Some micro benchmarking shows it's slow:
     //       https://www.gamedev.net/forums/topic/605580-performance-comparison-hlsl-texturegetdimension/
-    // 
-    for (int y = 0; y < Flocking.resY; ++y) {
-        for (int x = 0; x < Flocking.resX; ++x) {
-            float  s        = abs(x - myX) + abs(y - myY);
-            uint2  xy       = uint2(x, y);
-            float3 pos      = InPositionTexture[xy].xyz;
-            float3 vel      = InVelocityTexture[xy].xyz;
-            float3 dir      = myPos - pos;
-            float  distSqrd = dot(dir, dir);
-
-            if ((x != myX) && (y != myY) && (distSqrd < zoneRadSqrd)) {
-                float3 dirNorm  = normalize(dir);
-                float  percent  = distSqrd / zoneRadSqrd;
-                float  crowdPer = 1.0 - percent;
-
-                if (percent < Flocking.minThresh) {
-                    float F = (Flocking.minThresh / percent - 1.0) * accMulti;
-                    acc += dirNorm * F;
-                    crowded += crowdPer; //  * 2.0
-                }
-                else if (percent < Flocking.maxThresh) {
-                    float threshDelta     = Flocking.maxThresh - Flocking.minThresh;
-                    float adjustedPercent = (percent - Flocking.minThresh) / threshDelta;
-                    float F               = (1.0 - (cos(adjustedPercent * 6.28318) * -0.5 + 0.5)) * accMulti;
-                    acc += normalize(vel) * F;
-                    crowded += crowdPer * 0.5;
-                }
-                else {
-                    float threshDelta     = 1.0 - Flocking.maxThresh;
-                    float adjustedPercent = (percent - Flocking.maxThresh) / threshDelta;
-                    float F               = (1.0 - (cos(adjustedPercent * 6.28318) * -0.5 + 0.5)) * accMulti;
-                    acc += -dirNorm * F;
-                    crowded += crowdPer * 0.25;
+    //
+    int2 myXY = int2(myX, myY);
+    if (Flocking.useGrid) {
+        // Only the fish in the cells around this one can be within the zone radius
+        int3 myCell = GridCell(myPos);
+        for (int dz = -1; dz <= 1; ++dz) {
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int3 cell   = myCell + int3(dx, dy, dz);
+                    uint bucket = GridBucket(cell);
+                    uint end    = GridCellStart[bucket + 1];
+                    for (uint i = GridCellStart[bucket]; i < end; ++i) {
+                        int2 xy = (int2)FishCoord(GridSortedFish[i]);
+                        // Buckets are shared by colliding cells, skip the fish of other cells so
+                        // that no fish is applied twice
+                        if (all(GridCell(InPositionTexture[xy].xyz) == cell)) {
+                            ApplyNeighbor(xy, myXY, myPos, accMulti, zoneRadSqrd, acc, crowded);
+                        }
+                    }
                 }
             }
         }
     }
+    else {
+        for (int y = 0; y < Flocking.resY; ++y) {
+            for (int x = 0; x < Flocking.resX; ++x) {
+                ApplyNeighbor(int2(x, y), myXY, myPos, accMulti, zoneRadSqrd, acc, crowded);
+            }
+        }
+    }
 
     acc.y *= 0.960;
     acc.y -= 0.005;
@@ -86,6 +86,7 @@ struct CSInput
     float2 normalizationScale;
 
     uint filterOptions;
+    uint iterations;
 };
 
 ConstantBuffer<CSInput> Params : register(b0);
@@ -101,7 +102,7 @@ Texture2D UVelocity : register(t3);
 // Used by vorticity.hlsl.
 Texture2D UCurl : register(t4);
 
-// Used by advection.hlsl.
+// Used by advection.hlsl, pressure_prolongate.hlsl.
 Texture2D USource : register(t5);
 
 // Used by display.hlsl.
@@ -109,10 +110,10 @@ Texture2D UBloom : register(t6);
 Texture2D USunrays : register(t7);
 Texture2D UDithering : register(t8);
 
-// Used by gradient_subtract.hlsl, pressure.hlsl.
+// Used by gradient_subtract.hlsl, pressure*.hlsl.
 Texture2D UPressure : register(t9);
 
-// Used by pressure.hlsl.
+// Used by pressure*.hlsl.
 Texture2D UDivergence : register(t10);
 
 // The output generated by every shader.
@@ -0,0 +1,80 @@
+// Copyright 2017 Pavel Dobryakov
+// Copyright 2022 Google LLC
+//
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#include "config.hlsli"
+
+// Runs up to PRESSURE_FUSED_ITERATIONS Jacobi iterations of pressure.hlsl in a single dispatch.
+//
+// Each group loads its tile plus a halo of PRESSURE_FUSED_ITERATIONS texels into group shared
+// memory. Every iteration leaves the outermost ring of the tile out of date, so after the last
+// iteration only the interior of the tile holds the same values the separate dispatches would
+// have produced. This MUST match the constants in projects/fluid_simulation/sim.h.
+#define PRESSURE_GROUP_SIZE       16
+#define PRESSURE_FUSED_ITERATIONS 4
+#define PRESSURE_TILE_SIZE        (PRESSURE_GROUP_SIZE + 2 * PRESSURE_FUSED_ITERATIONS)
+#define PRESSURE_TILE_TEXELS      (PRESSURE_TILE_SIZE * PRESSURE_TILE_SIZE)
+
+groupshared float TilePressure[2][PRESSURE_TILE_TEXELS];
+groupshared float TileDivergence[PRESSURE_TILE_TEXELS];
+
+uint TileIndex(int2 t)
+{
+    return t.y * PRESSURE_TILE_SIZE + t.x;
+}
+
+[numthreads(PRESSURE_GROUP_SIZE, PRESSURE_GROUP_SIZE, 1)] void csmain(uint2 tid
+                                                                      : SV_DispatchThreadID, uint2 gtid
+                                                                      : SV_GroupThreadID, uint2 gid
+                                                                      : SV_GroupID) {
+    uint2 size;
+    UPressure.GetDimensions(size.x, size.y);
+    const int2 maxCoord = int2(size) - 1;
+    const int2 origin   = int2(gid) * PRESSURE_GROUP_SIZE - PRESSURE_FUSED_ITERATIONS;
+    const uint threadId = gtid.y * PRESSURE_GROUP_SIZE + gtid.x;
+    const int  count    = min(int(Params.iterations), PRESSURE_FUSED_ITERATIONS);
+
+    // Load the tile. Texels outside the grid are clamped like ClampSampler does. The clear pass
+    // is folded into the load through clearValue, zero discards the previous pressure entirely.
+    for (uint i = threadId; i < PRESSURE_TILE_TEXELS; i += PRESSURE_GROUP_SIZE * PRESSURE_GROUP_SIZE) {
+        const int2 coord   = clamp(origin + int2(i % PRESSURE_TILE_SIZE, i / PRESSURE_TILE_SIZE), 0, maxCoord);
+        TilePressure[0][i] = (Params.clearValue == 0.0) ? 0.0 : Params.clearValue * UPressure.Load(int3(coord, 0)).x;
+        TileDivergence[i]  = UDivergence.Load(int3(coord, 0)).x;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    for (int iteration = 0; iteration < count; ++iteration) {
+        const uint src = iteration & 1;
+        const uint dst = src ^ 1;
+        for (uint i = threadId; i < PRESSURE_TILE_TEXELS; i += PRESSURE_GROUP_SIZE * PRESSURE_GROUP_SIZE) {
+            const int2 t        = int2(i % PRESSURE_TILE_SIZE, i / PRESSURE_TILE_SIZE);
+            float      pressure = TilePressure[src][i];
+            if (all(t > iteration) && all(t < PRESSURE_TILE_SIZE - 1 - iteration)) {
+                // Neighbors are clamped to the grid before being looked up in the tile, so texels
+                // on the grid border read themselves exactly like the sampled version does.
+                const int2 coord = origin + t;
+                const int2 lo    = clamp(coord - 1, 0, maxCoord) - origin;
+                const int2 hi    = clamp(coord + 1, 0, maxCoord) - origin;
+
+                float L = TilePressure[src][TileIndex(int2(lo.x, t.y))];
+                float R = TilePressure[src][TileIndex(int2(hi.x, t.y))];
+                float T = TilePressure[src][TileIndex(int2(t.x, hi.y))];
+                float B = TilePressure[src][TileIndex(int2(t.x, lo.y))];
+
+                pressure = (L + R + B + T - TileDivergence[i]) * 0.25;
+            }
+            TilePressure[dst][i] = pressure;
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    if (any(tid >= size)) {
+        return;
+    }
+
+    const int2 t = int2(gtid) + PRESSURE_FUSED_ITERATIONS;
+    Output[tid]  = float4(TilePressure[count & 1][TileIndex(t)], 0.0, 0.0, 1.0);
+}
@@ -0,0 +1,25 @@
+// Copyright 2017 Pavel Dobryakov
+// Copyright 2022 Google LLC
+//
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#include "config.hlsli"
+
+// Adds the error computed on the coarse grid (USource) back to the pressure on the fine grid.
+[numthreads(8, 8, 1)] void csmain(uint2 tid
+                                  : SV_DispatchThreadID) {
+    uint2 size;
+    UPressure.GetDimensions(size.x, size.y);
+    if (any(tid >= size)) {
+        return;
+    }
+
+    Coord coord = BaseVS(tid, Params.normalizationScale, Params.texelSize);
+
+    float pressure = UPressure.Load(int3(tid, 0)).x;
+    float error    = USource.SampleLevel(ClampSampler, coord.vUv, 0).x;
+
+    Output[coord.xy] = float4(pressure + error, 0.0, 0.0, 1.0);
+}
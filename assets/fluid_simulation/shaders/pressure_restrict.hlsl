@@ -0,0 +1,47 @@
+// Copyright 2017 Pavel Dobryakov
+// Copyright 2022 Google LLC
+//
+// Use of this source code is governed by an MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT.
+
+#include "config.hlsli"
+
+float Residual(int2 coord, int2 maxCoord)
+{
+    const int2 lo = clamp(coord - 1, 0, maxCoord);
+    const int2 hi = clamp(coord + 1, 0, maxCoord);
+
+    float L = UPressure.Load(int3(lo.x, coord.y, 0)).x;
+    float R = UPressure.Load(int3(hi.x, coord.y, 0)).x;
+    float T = UPressure.Load(int3(coord.x, hi.y, 0)).x;
+    float B = UPressure.Load(int3(coord.x, lo.y, 0)).x;
+    float C = UPressure.Load(int3(coord, 0)).x;
+
+    return UDivergence.Load(int3(coord, 0)).x - (L + R + B + T - 4.0 * C);
+}
+
+// Computes the residual of the pressure equation solved by pressure.hlsl and restricts it to a
+// grid of half the resolution. The output is the right hand side of the error equation on the
+// coarse grid: the residual is averaged over 2x2 texels and scaled by 4 because coarse texels
+// are twice as large.
+[numthreads(8, 8, 1)] void csmain(uint2 tid
+                                  : SV_DispatchThreadID) {
+    uint2 outputSize;
+    Output.GetDimensions(outputSize.x, outputSize.y);
+    if (any(tid >= outputSize)) {
+        return;
+    }
+
+    uint2 size;
+    UPressure.GetDimensions(size.x, size.y);
+    const int2 maxCoord = int2(size) - 1;
+    const int2 coord    = int2(tid) * 2;
+
+    float residual = Residual(min(coord, maxCoord), maxCoord) +
+                     Residual(min(coord + int2(1, 0), maxCoord), maxCoord) +
+                     Residual(min(coord + int2(0, 1), maxCoord), maxCoord) +
+                     Residual(min(coord + int2(1, 1), maxCoord), maxCoord);
+
+    Output[tid] = float4(residual, 0.0, 0.0, 1.0);
+}
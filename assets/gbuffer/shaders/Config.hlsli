@@ -39,6 +39,26 @@
 #define MATERIAL_HEIGHT_MAP_TEXTURE_REGISTER  t11
 #define MATERIAL_IBL_MAP_TEXTURE_REGISTER     t12
 #define MATERIAL_ENV_MAP_TEXTURE_REGISTER     t13
+#define LIGHT_GRID_REGISTER                   t14
+#define LIGHT_INDEX_LIST_REGISTER             t15
+
+// Light culling compute shaders only
+#define LIGHT_CULL_DEPTH_REGISTER             t22
+#define LIGHT_GRID_UAV_REGISTER               u23
+#define LIGHT_INDEX_LIST_UAV_REGISTER         u24
+
+// Light culling modes
+#define LIGHT_CULLING_NONE              0
+#define LIGHT_CULLING_TILED_DEFERRED    1
+#define LIGHT_CULLING_CLUSTERED_FORWARD 2
+
+// Tiled deferred uses one cell per LIGHT_TILE_SIZE tile, clustered forward
+// splits each LIGHT_CLUSTER_TILE_SIZE tile into LIGHT_CLUSTER_SLICE_COUNT
+// depth slices. Each cell holds at most LIGHT_MAX_LIGHTS_PER_CELL lights.
+#define LIGHT_TILE_SIZE           16
+#define LIGHT_CLUSTER_TILE_SIZE   64
+#define LIGHT_CLUSTER_SLICE_COUNT 16
+#define LIGHT_MAX_LIGHTS_PER_CELL 256
 
 #define PI 3.1415292
 
@@ -52,12 +72,23 @@ struct SceneData
     float    ambient;
     float    iblLevelCount;
     float    envLevelCount;
+    float4x4 viewMatrix;
+    float2   projectionScale;  // (P[0][0], P[1][1])
+    float2   depthUnproject;   // View depth = y / (depth + x)
+    float2   screenSize;       // Pixels
+    uint     lightCullingMode; // LIGHT_CULLING_*
+    uint     lightTileSize;    // Pixels
+    uint     lightTileCountX;
+    uint     lightTileCountY;
+    uint     lightSliceCount;
+    float    lightSliceScale;  // Slice = log(view depth) * scale + bias
+    float    lightSliceBias;
 };
 
 struct Light
 {
-    uint   type;
     float3 position;
+    float  range;
     float3 color;
     float  intensity;
 };
@@ -15,6 +15,8 @@
 //
 // Simple PBR implementation based on https://github.com/Nadrin/PBR (MIT license)
 // 
+// Direct lighting is in Lighting.hlsli, with tiled deferred culling the
+// lights come from the light grid written by LightCullTiled.hlsl.
 //
 
 #define CUSTOM_VS_OUTPUT
@@ -32,6 +34,8 @@ Texture2D    IBLTex         : register(GBUFFER_ENV_REGISTER,     GBUFFER_SPACE);
 Texture2D    EnvMapTex      : register(GBUFFER_IBL_REGISTER,     GBUFFER_SPACE);
 SamplerState ClampedSampler : register(GBUFFER_SAMPLER_REGISTER, GBUFFER_SPACE);
 
+#include "Lighting.hlsli"
+
 cbuffer GBufferData : register(GBUFFER_CONSTANTS_REGISTER, GBUFFER_SPACE)
 {
     uint enableIBL;
@@ -65,44 +69,6 @@ VSOutput vsmain(uint id : SV_VertexID)
 
 // -------------------------------------------------------------------------------------------------
 
-//
-// GGX/Towbridge-Reitz normal distribution function with
-// Disney's reparametrization of alpha = roughness^2
-//
-float DistributionGGX(float cosLh, float roughness)
-{
-    float alpha   = roughness * roughness;
-    float alphaSq = alpha * alpha;
-    float denom   = (cosLh * cosLh) * (alphaSq - 1.0) + 1.0;
-    return alphaSq / (PI * denom * denom);
-}
-
-//
-// Single term for separable Schlick-GGX below
-//
-float GASchlickG1(float cosTheta, float k)
-{
-    return cosTheta / (cosTheta * (1.0 - k) + k);
-}
-
-//
-// Schlick-GGX approximation of geometric attenuation function using Smith's method
-//
-float GASmithSchlickGGX(float cosLi, float cosLo, float roughness)
-{
-    float r = roughness + 1.0;
-    float k = (r * r) / 8.0; // Epic suggests using this roughness remapping for analytic lights
-    return GASchlickG1(cosLi, k) * GASchlickG1(cosLo, k);
-}
-
-//
-// Shlick's approximation of the Fresnel factor
-//
-float3 FresnelSchlick(float3 F0, float cosTheta)
-{
-    return F0 + (1.0 - F0) * (float3)pow(1.0 - cosTheta, 5.0);
-}
-
 float3 Environment(Texture2D tex, float3 coord, float lod)
 {
     float2 uv = CartesianToSphereical(normalize(coord));
@@ -112,7 +78,7 @@ float3 Environment(Texture2D tex, float3 coord, float lod)
     return color;
 }
 
-float3 PBR(GBuffer gbuffer)
+float3 PBR(GBuffer gbuffer, float2 pixelPosition)
 {
     float3 P  = gbuffer.position;
     float3 N  = gbuffer.normal;
@@ -135,40 +101,7 @@ float3 PBR(GBuffer gbuffer)
 
 
     // Calculate direct lighting
-    float3 directLighting = (float3)0;
-    for (uint i = 0; i < Scene.lightCount; ++i) {
-        float3 Li   = normalize(Lights[i].position - P); // Incoming light direction
-        float  Lrad = Lights[i].intensity;               // Light radiance
-        float3 Lh   = normalize(Li + Lo);                // Half-vector between Li and Lo
-        float  cosLi = saturate(dot(N, Li));
-        float  cosLh = saturate(dot(N, Lh));
-
-        // Calculate Fresnel term for direct lighting 
-        float3 F = FresnelSchlick(F0, saturate(dot(Lh, Lo)));
-        // Calculate normal distribution for specular BRDF
-        float  D = DistributionGGX(cosLh, roughness);
-        // Calculate geometric attenuation for specular BRDF
-        float  G = GASmithSchlickGGX(cosLi, cosLo, roughness);
-
-        // Diffuse scattering happens due to light being refracted multiple times by a dielectric medium.
-        // Metals on the other hand either reflect or absorb energy, so diffuse contribution is always zero.
-        // To be energy conserving we must scale diffuse BRDF contribution based on Fresnel factor & metalness.
-        //
-        float3 kD = lerp(float3(1, 1, 1) - F, float3(0, 0, 0), metalness);
-
-        // Lambert diffuse BRDF
-        // 
-        // We don't scale by 1/PI for lighting & material units to be more convenient.
-        //   See: https://seblagarde.wordpress.com/2012/01/08/pi-or-not-to-pi-in-game-lighting-equation/
-        //
-        float3 diffuseBRDF = kD * albedo;
-
-        // Calculate specular BRDF
-        float3 specularBRDF = (F * D * G) / max(0.00001, 4.0 * cosLi * cosLo);
-    
-        // Accumulate light's total contribution
-        directLighting += (diffuseBRDF + specularBRDF) * Lrad * cosLi;
-    }
+    float3 directLighting = DirectLighting(gbuffer, F0, Lo, pixelPosition);
 
     // Calculate indirect lighting
     //
@@ -229,7 +162,7 @@ float4 psmain(float4 Position : SV_POSITION, float2 TexCoord : TEXCOORD) : SV_TA
     
     GBuffer gbuffer = UnpackGBuffer(packed);
     
-    float3 color = PBR(gbuffer);
+    float3 color = PBR(gbuffer, Position.xy);
 
     return float4(color, 1.0);
 }
\ No newline at end of file
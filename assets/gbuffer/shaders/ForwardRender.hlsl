@@ -0,0 +1,40 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//
+// Clustered forward shading, entities are lit directly with the lights of
+// the light grid cluster covering each pixel, see LightCullClustered.hlsl.
+// Indirect lighting isn't evaluated here.
+//
+
+#include "GBuffer.hlsli"
+#include "Config.hlsli"
+
+ConstantBuffer<SceneData>    Scene    : register(SCENE_CONSTANTS_REGISTER,    SCENE_DATA_SPACE);
+StructuredBuffer<Light>      Lights   : register(LIGHT_DATA_REGISTER,         SCENE_DATA_SPACE);
+ConstantBuffer<ModelData>    Model    : register(MODEL_CONSTANTS_REGISTER,    MODEL_DATA_SPACE);
+
+#include "Material.hlsli"
+#include "Lighting.hlsli"
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    GBuffer gbuffer = EvaluateMaterial(input);
+
+    float3 Lo = normalize(Scene.eyePosition.xyz - gbuffer.position);
+    float3 F0 = lerp((float3)gbuffer.F0, gbuffer.albedo, gbuffer.metalness);
+
+    float3 color = DirectLighting(gbuffer, F0, Lo, input.position.xy) + (float3)Scene.ambient;
+    return float4(color, 1.0);
+}
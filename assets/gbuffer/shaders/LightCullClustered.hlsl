@@ -0,0 +1,42 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//
+// Clustered light culling, one thread group per cluster. Clusters split each
+// LIGHT_CLUSTER_TILE_SIZE tile into depth slices that grow exponentially with
+// view depth. The bounds don't depend on the depth buffer, so culling can run
+// before the forward pass draws anything.
+//
+
+#include "LightCulling.hlsli"
+
+#define THREAD_COUNT 64
+
+[numthreads(THREAD_COUNT, 1, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint groupIndex : SV_GroupIndex)
+{
+    BeginCell(groupIndex);
+    GroupMemoryBarrierWithGroupSync();
+
+    // Inverse of the slice mapping in LightCellIndex(), the first and last
+    // slices also hold everything in front of and behind the sliced range.
+    uint  slice    = groupId.z;
+    float minDepth = (slice == 0) ? 0.0 : exp((slice - Scene.lightSliceBias) / Scene.lightSliceScale);
+    float maxDepth = (slice == (Scene.lightSliceCount - 1)) ? 3.402823466e+38 : exp((slice + 1 - Scene.lightSliceBias) / Scene.lightSliceScale);
+
+    TileFrustum frustum = ComputeTileFrustum(groupId.xy);
+    CullLights(groupIndex, THREAD_COUNT, frustum, minDepth, maxDepth);
+
+    EndCell(groupIndex, THREAD_COUNT, (slice * Scene.lightTileCountY + groupId.y) * Scene.lightTileCountX + groupId.x);
+}
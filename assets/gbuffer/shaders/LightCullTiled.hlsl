@@ -0,0 +1,61 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+//
+// Tiled deferred light culling, one thread group per LIGHT_TILE_SIZE tile.
+// The group first reduces the tile's gbuffer depth to a min/max view depth
+// range so the lights are only tested against the depth bounds the tile's
+// pixels actually cover. Tiles without geometry get no lights.
+//
+
+#include "LightCulling.hlsli"
+
+Texture2D<float> DepthTex : register(LIGHT_CULL_DEPTH_REGISTER, SCENE_DATA_SPACE);
+
+#define THREAD_COUNT (LIGHT_TILE_SIZE * LIGHT_TILE_SIZE)
+
+// View depths are positive so their bit patterns sort like the floats
+groupshared uint sMinDepth;
+groupshared uint sMaxDepth;
+
+[numthreads(LIGHT_TILE_SIZE, LIGHT_TILE_SIZE, 1)]
+void csmain(uint3 groupId : SV_GroupID, uint3 dispatchThreadId : SV_DispatchThreadID, uint groupIndex : SV_GroupIndex)
+{
+    BeginCell(groupIndex);
+    if (groupIndex == 0) {
+        sMinDepth = asuint(3.402823466e+38);
+        sMaxDepth = 0;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    if (all((float2)dispatchThreadId.xy < Scene.screenSize)) {
+        float depth = DepthTex.Load(int3(dispatchThreadId.xy, 0));
+        // Skip cleared depth, there's nothing to light
+        if (depth < 1.0) {
+            float viewDepth = Scene.depthUnproject.y / (depth + Scene.depthUnproject.x);
+            InterlockedMin(sMinDepth, asuint(viewDepth));
+            InterlockedMax(sMaxDepth, asuint(viewDepth));
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    float minDepth = asfloat(sMinDepth);
+    float maxDepth = asfloat(sMaxDepth);
+    if (minDepth <= maxDepth) {
+        TileFrustum frustum = ComputeTileFrustum(groupId.xy);
+        CullLights(groupIndex, THREAD_COUNT, frustum, minDepth, maxDepth);
+    }
+
+    EndCell(groupIndex, THREAD_COUNT, groupId.y * Scene.lightTileCountX + groupId.x);
+}
@@ -0,0 +1,115 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIGHT_CULLING_HLSLI
+#define LIGHT_CULLING_HLSLI
+
+//
+// Shared by the light culling compute shaders. Each thread group culls the
+// lights of one light grid cell: the group tests the lights in parallel,
+// appends the ones touching the cell to a group shared list, and then
+// writes the list to the cell's fixed size range of LightIndexList.
+//
+
+#include "Config.hlsli"
+
+ConstantBuffer<SceneData> Scene          : register(SCENE_CONSTANTS_REGISTER,      SCENE_DATA_SPACE);
+StructuredBuffer<Light>   Lights         : register(LIGHT_DATA_REGISTER,           SCENE_DATA_SPACE);
+RWStructuredBuffer<uint>  LightGrid      : register(LIGHT_GRID_UAV_REGISTER,       SCENE_DATA_SPACE);
+RWStructuredBuffer<uint>  LightIndexList : register(LIGHT_INDEX_LIST_UAV_REGISTER, SCENE_DATA_SPACE);
+
+groupshared uint sCellLightCount;
+groupshared uint sCellLights[LIGHT_MAX_LIGHTS_PER_CELL];
+
+//
+// Side planes of a screen tile's frustum in view space. The planes go
+// through the eye and their normals point into the tile.
+//
+struct TileFrustum
+{
+    float3 planes[4];
+};
+
+TileFrustum ComputeTileFrustum(uint2 tile)
+{
+    float2 minPixel = (float2)(tile * Scene.lightTileSize);
+    float2 maxPixel = min((float2)((tile + 1) * Scene.lightTileSize), Scene.screenSize);
+
+    // Pixel rows go down, NDC y goes up
+    float2 minNdc = float2(2.0 * minPixel.x / Scene.screenSize.x - 1.0, 1.0 - 2.0 * maxPixel.y / Scene.screenSize.y);
+    float2 maxNdc = float2(2.0 * maxPixel.x / Scene.screenSize.x - 1.0, 1.0 - 2.0 * minPixel.y / Scene.screenSize.y);
+
+    // The view looks down -Z, a point is inside the left plane when
+    // P[0][0] * x >= ndc.x * depth with depth = -z, and so on.
+    TileFrustum frustum;
+    frustum.planes[0] = normalize(float3(Scene.projectionScale.x, 0, minNdc.x));
+    frustum.planes[1] = normalize(float3(-Scene.projectionScale.x, 0, -maxNdc.x));
+    frustum.planes[2] = normalize(float3(0, Scene.projectionScale.y, minNdc.y));
+    frustum.planes[3] = normalize(float3(0, -Scene.projectionScale.y, -maxNdc.y));
+    return frustum;
+}
+
+bool LightIntersectsCell(Light light, TileFrustum frustum, float minDepth, float maxDepth)
+{
+    float3 center = mul(Scene.viewMatrix, float4(light.position, 1)).xyz;
+    float  depth  = -center.z;
+    if ((depth + light.range < minDepth) || (depth - light.range > maxDepth)) {
+        return false;
+    }
+
+    for (uint i = 0; i < 4; ++i) {
+        if (dot(frustum.planes[i], center) < -light.range) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BeginCell(uint groupIndex)
+{
+    if (groupIndex == 0) {
+        sCellLightCount = 0;
+    }
+}
+
+void CullLights(uint groupIndex, uint threadCount, TileFrustum frustum, float minDepth, float maxDepth)
+{
+    for (uint i = groupIndex; i < Scene.lightCount; i += threadCount) {
+        if (LightIntersectsCell(Lights[i], frustum, minDepth, maxDepth)) {
+            uint slot = 0;
+            InterlockedAdd(sCellLightCount, 1, slot);
+            // Lights past the cell capacity are dropped
+            if (slot < LIGHT_MAX_LIGHTS_PER_CELL) {
+                sCellLights[slot] = i;
+            }
+        }
+    }
+}
+
+void EndCell(uint groupIndex, uint threadCount, uint cell)
+{
+    GroupMemoryBarrierWithGroupSync();
+
+    uint lightCount = min(sCellLightCount, LIGHT_MAX_LIGHTS_PER_CELL);
+    uint firstIndex = cell * LIGHT_MAX_LIGHTS_PER_CELL;
+    for (uint i = groupIndex; i < lightCount; i += threadCount) {
+        LightIndexList[firstIndex + i] = sCellLights[i];
+    }
+
+    if (groupIndex == 0) {
+        LightGrid[cell] = lightCount;
+    }
+}
+
+#endif // LIGHT_CULLING_HLSLI
@@ -0,0 +1,159 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIGHTING_HLSLI
+#define LIGHTING_HLSLI
+
+//
+// Simple PBR implementation based on https://github.com/Nadrin/PBR (MIT license)
+//
+// The including shader declares Scene and Lights. The light grid is written
+// by LightCullTiled.hlsl or LightCullClustered.hlsl depending on
+// Scene.lightCullingMode.
+//
+
+StructuredBuffer<uint> LightGrid      : register(LIGHT_GRID_REGISTER,       SCENE_DATA_SPACE);
+StructuredBuffer<uint> LightIndexList : register(LIGHT_INDEX_LIST_REGISTER, SCENE_DATA_SPACE);
+
+//
+// GGX/Towbridge-Reitz normal distribution function with
+// Disney's reparametrization of alpha = roughness^2
+//
+float DistributionGGX(float cosLh, float roughness)
+{
+    float alpha   = roughness * roughness;
+    float alphaSq = alpha * alpha;
+    float denom   = (cosLh * cosLh) * (alphaSq - 1.0) + 1.0;
+    return alphaSq / (PI * denom * denom);
+}
+
+//
+// Single term for separable Schlick-GGX below
+//
+float GASchlickG1(float cosTheta, float k)
+{
+    return cosTheta / (cosTheta * (1.0 - k) + k);
+}
+
+//
+// Schlick-GGX approximation of geometric attenuation function using Smith's method
+//
+float GASmithSchlickGGX(float cosLi, float cosLo, float roughness)
+{
+    float r = roughness + 1.0;
+    float k = (r * r) / 8.0; // Epic suggests using this roughness remapping for analytic lights
+    return GASchlickG1(cosLi, k) * GASchlickG1(cosLo, k);
+}
+
+//
+// Shlick's approximation of the Fresnel factor
+//
+float3 FresnelSchlick(float3 F0, float cosTheta)
+{
+    return F0 + (1.0 - F0) * (float3)pow(1.0 - cosTheta, 5.0);
+}
+
+//
+// Fades a light out to exactly zero at its range, so the culling passes can
+// drop it from every cell the range doesn't reach.
+//
+float LightAttenuation(float distance, float range)
+{
+    float ratio  = distance / range;
+    float window = saturate(1.0 - (ratio * ratio) * (ratio * ratio));
+    return window * window;
+}
+
+float ViewDepth(float3 positionWS)
+{
+    return -mul(Scene.viewMatrix, float4(positionWS, 1)).z;
+}
+
+//
+// Light grid cell covering a pixel, slices are only used by clustered forward
+//
+uint LightCellIndex(float2 pixelPosition, float viewDepth)
+{
+    uint2 tile  = min((uint2)pixelPosition / Scene.lightTileSize, uint2(Scene.lightTileCountX, Scene.lightTileCountY) - 1);
+    uint  slice = 0;
+    if (Scene.lightSliceCount > 1) {
+        float s = log(max(viewDepth, 0.00001)) * Scene.lightSliceScale + Scene.lightSliceBias;
+        slice   = (uint)clamp(s, 0.0, (float)(Scene.lightSliceCount - 1));
+    }
+    return (slice * Scene.lightTileCountY + tile.y) * Scene.lightTileCountX + tile.x;
+}
+
+float3 DirectLight(Light light, GBuffer gbuffer, float3 F0, float3 Lo, float cosLo)
+{
+    float3 toLight = light.position - gbuffer.position;
+    float  dist    = length(toLight);
+    float3 Li      = toLight / max(dist, 0.00001);                                           // Incoming light direction
+    float3 Lrad    = light.color * light.intensity * LightAttenuation(dist, light.range);   // Light radiance
+    float3 Lh      = normalize(Li + Lo);                                                     // Half-vector between Li and Lo
+    float  cosLi   = saturate(dot(gbuffer.normal, Li));
+    float  cosLh   = saturate(dot(gbuffer.normal, Lh));
+
+    // Calculate Fresnel term for direct lighting
+    float3 F = FresnelSchlick(F0, saturate(dot(Lh, Lo)));
+    // Calculate normal distribution for specular BRDF
+    float  D = DistributionGGX(cosLh, gbuffer.roughness);
+    // Calculate geometric attenuation for specular BRDF
+    float  G = GASmithSchlickGGX(cosLi, cosLo, gbuffer.roughness);
+
+    // Diffuse scattering happens due to light being refracted multiple times by a dielectric medium.
+    // Metals on the other hand either reflect or absorb energy, so diffuse contribution is always zero.
+    // To be energy conserving we must scale diffuse BRDF contribution based on Fresnel factor & metalness.
+    //
+    float3 kD = lerp(float3(1, 1, 1) - F, float3(0, 0, 0), gbuffer.metalness);
+
+    // Lambert diffuse BRDF
+    //
+    // We don't scale by 1/PI for lighting & material units to be more convenient.
+    //   See: https://seblagarde.wordpress.com/2012/01/08/pi-or-not-to-pi-in-game-lighting-equation/
+    //
+    float3 diffuseBRDF = kD * gbuffer.albedo;
+
+    // Calculate specular BRDF
+    float3 specularBRDF = (F * D * G) / max(0.00001, 4.0 * cosLi * cosLo);
+
+    // Light's total contribution
+    return (diffuseBRDF + specularBRDF) * Lrad * cosLi;
+}
+
+//
+// Sums every light without culling, or the lights of the pixel's light grid cell
+//
+float3 DirectLighting(GBuffer gbuffer, float3 F0, float3 Lo, float2 pixelPosition)
+{
+    float  cosLo          = saturate(dot(gbuffer.normal, Lo));
+    float3 directLighting = (float3)0;
+
+    if (Scene.lightCullingMode == LIGHT_CULLING_NONE) {
+        for (uint i = 0; i < Scene.lightCount; ++i) {
+            directLighting += DirectLight(Lights[i], gbuffer, F0, Lo, cosLo);
+        }
+    }
+    else {
+        uint cell       = LightCellIndex(pixelPosition, ViewDepth(gbuffer.position));
+        uint lightCount = LightGrid[cell];
+        uint firstIndex = cell * LIGHT_MAX_LIGHTS_PER_CELL;
+        for (uint i = 0; i < lightCount; ++i) {
+            directLighting += DirectLight(Lights[LightIndexList[firstIndex + i]], gbuffer, F0, Lo, cosLo);
+        }
+    }
+
+    return directLighting;
+}
+
+#endif // LIGHTING_HLSLI
@@ -0,0 +1,47 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Writes the alive particles to the frame's draw buffer, in sorted order if
+// sorting is enabled
+
+#include "ParticlesCompute.hlsli"
+
+[numthreads(PARTICLE_GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                                  : SV_DispatchThreadID) {
+    if (tid.x >= Counters[COUNTER_ALIVE + NextAliveIndex()]) {
+        return;
+    }
+
+    uint index = 0;
+    if (Params.flags & PARTICLE_FLAG_SORT) {
+        index = SortKeys[tid.x].y;
+    }
+    else {
+        index = AliveList[NextAliveIndex() * Params.capacity + tid.x];
+    }
+    const Particle particle = Particles[index];
+
+    // White hot, then orange, then fading grey smoke
+    const float  t     = saturate(particle.age / particle.lifetime);
+    const float3 hot   = lerp(float3(1.0f, 0.9f, 0.6f), float3(1.0f, 0.35f, 0.05f), saturate(t * 4.0f));
+    const float3 color = lerp(hot, float3(0.3f, 0.3f, 0.3f), saturate(t * 2.0f - 0.5f));
+    const float  alpha = Params.opacity * saturate(t * 20.0f) * (1.0f - t);
+
+    DrawParticle draw;
+    draw.position        = particle.position;
+    draw.size            = Params.particleSize * lerp(0.5f, 2.0f, t);
+    draw.color           = float4(color * alpha, alpha);
+    DrawParticles[tid.x] = draw;
+}
@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Shared by the shaders and projects/gpu_particles
+
+#if defined(IS_SHADER)
+#define SHADER_REGISTER(type, num) type##num
+#else
+#define SHADER_REGISTER(type, num) num
+#endif
+
+// Compute
+#define PARTICLE_PARAMS_REGISTER SHADER_REGISTER(b, 0)
+#define SORT_PARAMS_REGISTER     SHADER_REGISTER(b, 1)
+#define PARTICLES_REGISTER       SHADER_REGISTER(u, 2)
+#define DEAD_LIST_REGISTER       SHADER_REGISTER(u, 3)
+#define ALIVE_LIST_REGISTER      SHADER_REGISTER(u, 4)
+#define COUNTERS_REGISTER        SHADER_REGISTER(u, 5)
+#define INDIRECT_ARGS_REGISTER   SHADER_REGISTER(u, 6)
+#define SORT_KEYS_REGISTER       SHADER_REGISTER(u, 7)
+#define DRAW_PARTICLES_REGISTER  SHADER_REGISTER(u, 8)
+#define DRAW_ARGS_REGISTER       SHADER_REGISTER(u, 9)
+
+// Graphics
+#define DRAW_PARAMS_REGISTER         SHADER_REGISTER(b, 0)
+#define DRAW_PARTICLES_SRV_REGISTER  SHADER_REGISTER(t, 1)
+#define COMBINE_SAMPLER_REGISTER     SHADER_REGISTER(s, 2)
+#define COMBINE_COLOR_REGISTER       SHADER_REGISTER(t, 3)
+#define COMBINE_EXTRA_REGISTER       SHADER_REGISTER(t, 4)
+
+#define PARTICLE_GROUP_SIZE 64
+
+// Elements sorted in groupshared memory by one workgroup, two per thread.
+// The sorted count is padded to a power of two no smaller than this.
+#define SORT_BLOCK_SIZE  1024
+#define SORT_GROUP_SIZE  (SORT_BLOCK_SIZE / 2)
+#define SORT_PADDING_KEY 0xFFFFFFFF
+
+// Counters, the alive list and its count are double buffered: simulation
+// reads list aliveIndex and compacts the survivors into the other one
+#define COUNTER_DEAD     0 // Indices in the dead list
+#define COUNTER_ALIVE    1 // Two counters, one per alive list
+#define COUNTER_EMIT     3 // Particles emitted this frame
+#define COUNTER_SIMULATE 4 // Particles simulated this frame, alive before plus emitted
+#define COUNTER_SORT     5 // Alive count after simulation padded for sorting
+#define COUNTER_COUNT    8
+
+// Offsets in uints of the grfx::DispatchIndirectCommand arguments
+#define ARGS_EMIT     0
+#define ARGS_SIMULATE 3
+#define ARGS_SORT     6
+#define ARGS_BUILD    9
+#define ARGS_COUNT    12
+
+#define PARTICLE_FLAG_SORT 0x1
+
+struct Particle
+{
+    float3 position;
+    float  age;
+    float3 velocity;
+    float  lifetime;
+};
+
+// Sorted copy of the alive particles read by the vertex shader
+struct DrawParticle
+{
+    float3 position;
+    float  size;
+    float4 color; // Premultiplied
+};
+
+struct ParticleParams
+{
+    float4x4 viewMatrix;
+    float3   emitterPosition;
+    float    deltaTime;
+    float3   gravity;
+    float    time;
+    uint     emitCount;
+    uint     capacity;
+    uint     aliveIndex;
+    uint     flags;
+    float    minLifetime;
+    float    maxLifetime;
+    float    emitSpeed;
+    float    swirl;
+    float    particleSize;
+    float    opacity;
+    uint     randomSeed;
+    uint     _unused0;
+};
+
+// Pushed for each sort pass
+struct SortParams
+{
+    uint k; // Size of the bitonic sequences being merged
+    uint j; // Distance between the compared elements
+};
+
+struct DrawParams
+{
+    float4x4 viewProjectionMatrix;
+    float3   cameraRight;
+    float    _unused0;
+    float3   cameraUp;
+    float    _unused1;
+};
+
+#if defined(IS_SHADER)
+
+uint Hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    x ^= x >> 16;
+    return x;
+}
+
+// Uniform in [0, 1)
+float Random(inout uint state)
+{
+    state = Hash(state);
+    return float(state >> 8) / 16777216.0f;
+}
+
+#endif
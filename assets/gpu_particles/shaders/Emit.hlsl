@@ -0,0 +1,49 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Takes particles from the dead list and appends them to the current alive
+// list after the particles that were already alive
+
+#include "ParticlesCompute.hlsli"
+
+[numthreads(PARTICLE_GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                                  : SV_DispatchThreadID) {
+    const uint emitCount = Counters[COUNTER_EMIT];
+    if (tid.x >= emitCount) {
+        return;
+    }
+
+    uint deadCount = 0;
+    InterlockedAdd(Counters[COUNTER_DEAD], 0xFFFFFFFF, deadCount);
+    const uint index = DeadList[deadCount - 1];
+
+    uint state = Hash(tid.x ^ Hash(Params.randomSeed));
+
+    // Cone around +Y
+    const float phi      = 6.2831853f * Random(state);
+    const float cosTheta = lerp(0.85f, 1.0f, Random(state));
+    const float sinTheta = sqrt(1.0f - cosTheta * cosTheta);
+    const float3 dir     = float3(sinTheta * cos(phi), cosTheta, sinTheta * sin(phi));
+
+    Particle particle;
+    particle.position = Params.emitterPosition + 0.1f * float3(Random(state) - 0.5f, 0.0f, Random(state) - 0.5f);
+    particle.age      = 0.0f;
+    particle.velocity = dir * Params.emitSpeed * lerp(0.75f, 1.25f, Random(state));
+    particle.lifetime = lerp(Params.minLifetime, Params.maxLifetime, Random(state));
+    Particles[index]  = particle;
+
+    const uint previousAliveCount = Counters[COUNTER_SIMULATE] - emitCount;
+    AliveList[CurrentAliveIndex() * Params.capacity + previousAliveCount + tid.x] = index;
+}
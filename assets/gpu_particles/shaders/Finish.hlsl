@@ -0,0 +1,39 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Pads the alive count for sorting and writes the sort, build and draw
+// arguments
+
+#include "ParticlesCompute.hlsli"
+
+[numthreads(1, 1, 1)] void csmain(uint3 tid
+                                : SV_DispatchThreadID) {
+    const uint aliveCount = Counters[COUNTER_ALIVE + NextAliveIndex()];
+
+    uint sortCount = SORT_BLOCK_SIZE;
+    if (aliveCount > SORT_BLOCK_SIZE) {
+        sortCount = 1u << (firstbithigh(aliveCount - 1) + 1);
+    }
+    Counters[COUNTER_SORT] = sortCount;
+
+    WriteDispatchArgs(ARGS_SORT, sortCount, SORT_BLOCK_SIZE);
+    WriteDispatchArgs(ARGS_BUILD, aliveCount, PARTICLE_GROUP_SIZE);
+
+    // grfx::DrawIndirectCommand, a quad of two triangles per particle
+    DrawArgs[0] = 6 * aliveCount;
+    DrawArgs[1] = 1;
+    DrawArgs[2] = 0;
+    DrawArgs[3] = 0;
+}
@@ -0,0 +1,29 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Puts every particle in the dead list
+
+#include "ParticlesCompute.hlsli"
+
+[numthreads(PARTICLE_GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                                  : SV_DispatchThreadID) {
+    if (tid.x < Params.capacity) {
+        DeadList[tid.x] = Params.capacity - 1 - tid.x;
+    }
+
+    if (tid.x < COUNTER_COUNT) {
+        Counters[tid.x] = (tid.x == COUNTER_DEAD) ? Params.capacity : 0;
+    }
+}
@@ -0,0 +1,32 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Clamps the particles emitted this frame to the dead ones and writes the
+// emit and simulate dispatch arguments
+
+#include "ParticlesCompute.hlsli"
+
+[numthreads(1, 1, 1)] void csmain(uint3 tid
+                                : SV_DispatchThreadID) {
+    const uint aliveCount = Counters[COUNTER_ALIVE + CurrentAliveIndex()];
+    const uint emitCount  = min(Params.emitCount, Counters[COUNTER_DEAD]);
+
+    Counters[COUNTER_EMIT]                     = emitCount;
+    Counters[COUNTER_SIMULATE]                 = aliveCount + emitCount;
+    Counters[COUNTER_ALIVE + NextAliveIndex()] = 0;
+
+    WriteDispatchArgs(ARGS_EMIT, emitCount, PARTICLE_GROUP_SIZE);
+    WriteDispatchArgs(ARGS_SIMULATE, aliveCount + emitCount, PARTICLE_GROUP_SIZE);
+}
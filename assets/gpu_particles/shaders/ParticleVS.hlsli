@@ -0,0 +1,60 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Camera facing quads pulled from the frame's draw buffer, six vertices per
+// particle
+
+#define IS_SHADER
+#include "Common.hlsli"
+
+ConstantBuffer<DrawParams>     Draw          : register(DRAW_PARAMS_REGISTER);
+StructuredBuffer<DrawParticle> DrawParticles : register(DRAW_PARTICLES_SRV_REGISTER);
+
+struct VSOutput
+{
+    float4 position : SV_POSITION;
+    float2 uv       : TEXCOORD;
+    float4 color    : COLOR;
+};
+
+VSOutput vsmain(uint VertexID : SV_VertexID)
+{
+    const float2 corners[] =
+    {
+        float2(-1.0f, -1.0f),
+        float2(+1.0f, -1.0f),
+        float2(+1.0f, +1.0f),
+        float2(-1.0f, -1.0f),
+        float2(+1.0f, +1.0f),
+        float2(-1.0f, +1.0f),
+    };
+
+    const DrawParticle particle = DrawParticles[VertexID / 6];
+    const float2       corner   = corners[VertexID % 6];
+    const float3       position = particle.position + particle.size * (corner.x * Draw.cameraRight + corner.y * Draw.cameraUp);
+
+    VSOutput result;
+    result.position = mul(Draw.viewProjectionMatrix, float4(position, 1.0f));
+    result.uv       = corner;
+    result.color    = particle.color;
+    return result;
+}
+
+// Soft round falloff of the quad
+float GetFalloff(float2 uv)
+{
+    const float f = saturate(1.0f - dot(uv, uv));
+    return f * f;
+}
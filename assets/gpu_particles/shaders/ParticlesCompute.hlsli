@@ -0,0 +1,46 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#define IS_SHADER
+#include "Common.hlsli"
+
+ConstantBuffer<ParticleParams>   Params        : register(PARTICLE_PARAMS_REGISTER);
+RWStructuredBuffer<Particle>     Particles     : register(PARTICLES_REGISTER);
+RWStructuredBuffer<uint>         DeadList      : register(DEAD_LIST_REGISTER);
+RWStructuredBuffer<uint>         AliveList     : register(ALIVE_LIST_REGISTER); // Two lists of capacity indices
+RWStructuredBuffer<uint>         Counters      : register(COUNTERS_REGISTER);
+RWStructuredBuffer<uint>         IndirectArgs  : register(INDIRECT_ARGS_REGISTER);
+RWStructuredBuffer<uint2>        SortKeys      : register(SORT_KEYS_REGISTER); // Key, particle index
+RWStructuredBuffer<DrawParticle> DrawParticles : register(DRAW_PARTICLES_REGISTER);
+RWStructuredBuffer<uint>         DrawArgs      : register(DRAW_ARGS_REGISTER);
+
+// Alive list simulated this frame
+uint CurrentAliveIndex()
+{
+    return Params.aliveIndex;
+}
+
+// Alive list the survivors are compacted into
+uint NextAliveIndex()
+{
+    return 1 - Params.aliveIndex;
+}
+
+void WriteDispatchArgs(uint offset, uint threadCount, uint groupSize)
+{
+    IndirectArgs[offset + 0] = (threadCount + groupSize - 1) / groupSize;
+    IndirectArgs[offset + 1] = 1;
+    IndirectArgs[offset + 2] = 1;
+}
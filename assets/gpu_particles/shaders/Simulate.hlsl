@@ -0,0 +1,93 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Ages and moves the particles of the current alive list, compacts the
+// survivors into the next alive list with their sort keys and returns the
+// others to the dead list.
+//
+// USE_SUBGROUP_OPS aggregates the counter atomics per subgroup: one atomic
+// per subgroup and list instead of one per particle.
+
+#include "ParticlesCompute.hlsli"
+
+[numthreads(PARTICLE_GROUP_SIZE, 1, 1)] void csmain(uint3 tid
+                                                  : SV_DispatchThreadID) {
+    if (tid.x >= Counters[COUNTER_SIMULATE]) {
+        return;
+    }
+
+    const uint index    = AliveList[CurrentAliveIndex() * Params.capacity + tid.x];
+    Particle   particle = Particles[index];
+
+    particle.age += Params.deltaTime;
+    const bool alive = (particle.age < particle.lifetime);
+
+    if (alive) {
+        // Swirl around the Y axis through the emitter
+        const float3 offset = particle.position - Params.emitterPosition;
+        const float3 swirl  = Params.swirl * float3(-offset.z, 0.0f, offset.x);
+
+        particle.velocity += (Params.gravity + swirl - 0.2f * particle.velocity) * Params.deltaTime;
+        particle.position += particle.velocity * Params.deltaTime;
+
+        // Bounce off the ground
+        if (particle.position.y < 0.0f) {
+            particle.position.y = -particle.position.y;
+            particle.velocity.y = -0.5f * particle.velocity.y;
+        }
+    }
+    Particles[index] = particle;
+
+#if defined(USE_SUBGROUP_OPS)
+    const uint aliveLaneCount  = WaveActiveCountBits(alive);
+    const uint aliveLaneOffset = WavePrefixCountBits(alive);
+    const uint deadLaneCount   = WaveActiveCountBits(!alive);
+    const uint deadLaneOffset  = WavePrefixCountBits(!alive);
+
+    uint aliveBase = 0;
+    uint deadBase  = 0;
+    if (WaveIsFirstLane()) {
+        if (aliveLaneCount > 0) {
+            InterlockedAdd(Counters[COUNTER_ALIVE + NextAliveIndex()], aliveLaneCount, aliveBase);
+        }
+        if (deadLaneCount > 0) {
+            InterlockedAdd(Counters[COUNTER_DEAD], deadLaneCount, deadBase);
+        }
+    }
+    const uint slot = alive ? (WaveReadLaneFirst(aliveBase) + aliveLaneOffset) : (WaveReadLaneFirst(deadBase) + deadLaneOffset);
+#else
+    uint slot = 0;
+    if (alive) {
+        InterlockedAdd(Counters[COUNTER_ALIVE + NextAliveIndex()], 1, slot);
+    }
+    else {
+        InterlockedAdd(Counters[COUNTER_DEAD], 1, slot);
+    }
+#endif
+
+    if (!alive) {
+        DeadList[slot] = index;
+        return;
+    }
+
+    AliveList[NextAliveIndex() * Params.capacity + slot] = index;
+
+    if (Params.flags & PARTICLE_FLAG_SORT) {
+        // Ascending keys are back to front, the bits of positive floats
+        // sort like the floats
+        const float distance = length(mul(Params.viewMatrix, float4(particle.position, 1.0f)).xyz);
+        SortKeys[slot]       = uint2(~asuint(distance), index);
+    }
+}
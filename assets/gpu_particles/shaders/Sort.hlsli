@@ -0,0 +1,80 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Bitonic sort of the sort keys of the alive particles, ascending. The
+// count is padded to a power of two, COUNTER_SORT, and sorted in three kinds
+// of passes that each dispatch one workgroup per SORT_BLOCK_SIZE keys:
+//   - SortPresort:    sorts each block in groupshared memory, merging all
+//                     sequences up to SORT_BLOCK_SIZE, and pads the keys
+//                     past the alive count
+//   - SortMergeStep:  one compare and swap step of merging sequences of k
+//                     keys at distance j, for the j >= SORT_BLOCK_SIZE
+//   - SortMergeLocal: the steps of merging sequences of k keys at the
+//                     distances j < SORT_BLOCK_SIZE, in groupshared memory
+//
+// The application records the passes for the largest count and the merge
+// passes of sequences longer than the padded count return right away.
+
+#include "ParticlesCompute.hlsli"
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<SortParams> Sort : register(SORT_PARAMS_REGISTER);
+
+groupshared uint2 SharedKeys[SORT_BLOCK_SIZE];
+
+// Index of the first key compared by thread t, the other one is j after it
+uint GetCompareIndex(uint t, uint j)
+{
+    return ((t & ~(j - 1)) << 1) | (t & (j - 1));
+}
+
+// Sequences are sorted ascending where bit k of the index is clear
+void CompareAndSwap(inout uint2 a, inout uint2 b, uint index, uint k)
+{
+    const bool ascending = ((index & k) == 0);
+    if ((a.x > b.x) == ascending) {
+        const uint2 tmp = a;
+        a               = b;
+        b               = tmp;
+    }
+}
+
+void SortSharedKeys(uint t, uint blockStart, uint k, uint j)
+{
+    const uint i = GetCompareIndex(t, j);
+
+    uint2 a = SharedKeys[i];
+    uint2 b = SharedKeys[i + j];
+    CompareAndSwap(a, b, blockStart + i, k);
+    SharedKeys[i]     = a;
+    SharedKeys[i + j] = b;
+
+    GroupMemoryBarrierWithGroupSync();
+}
+
+void LoadSharedKeys(uint t, uint blockStart)
+{
+    SharedKeys[t]                   = SortKeys[blockStart + t];
+    SharedKeys[t + SORT_GROUP_SIZE] = SortKeys[blockStart + t + SORT_GROUP_SIZE];
+    GroupMemoryBarrierWithGroupSync();
+}
+
+void StoreSharedKeys(uint t, uint blockStart)
+{
+    SortKeys[blockStart + t]                   = SharedKeys[t];
+    SortKeys[blockStart + t + SORT_GROUP_SIZE] = SharedKeys[t + SORT_GROUP_SIZE];
+}
@@ -0,0 +1,34 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "Sort.hlsli"
+
+[numthreads(SORT_GROUP_SIZE, 1, 1)] void csmain(uint3 gid
+                                              : SV_GroupID, uint3 gtid
+                                              : SV_GroupThreadID) {
+    // Same for the whole dispatch, so no thread is left at a barrier
+    if (Sort.k > Counters[COUNTER_SORT]) {
+        return;
+    }
+
+    const uint t          = gtid.x;
+    const uint blockStart = gid.x * SORT_BLOCK_SIZE;
+
+    LoadSharedKeys(t, blockStart);
+    for (uint j = SORT_BLOCK_SIZE >> 1; j > 0; j >>= 1) {
+        SortSharedKeys(t, blockStart, Sort.k, j);
+    }
+    StoreSharedKeys(t, blockStart);
+}
@@ -0,0 +1,38 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "Sort.hlsli"
+
+[numthreads(SORT_GROUP_SIZE, 1, 1)] void csmain(uint3 gid
+                                              : SV_GroupID, uint3 gtid
+                                              : SV_GroupThreadID) {
+    const uint t          = gtid.x;
+    const uint blockStart = gid.x * SORT_BLOCK_SIZE;
+    const uint aliveCount = Counters[COUNTER_ALIVE + NextAliveIndex()];
+
+    for (uint n = t; n < SORT_BLOCK_SIZE; n += SORT_GROUP_SIZE) {
+        const uint index = blockStart + n;
+        SharedKeys[n]    = (index < aliveCount) ? SortKeys[index] : uint2(SORT_PADDING_KEY, 0);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    for (uint k = 2; k <= SORT_BLOCK_SIZE; k <<= 1) {
+        for (uint j = k >> 1; j > 0; j >>= 1) {
+            SortSharedKeys(t, blockStart, k, j);
+        }
+    }
+
+    StoreSharedKeys(t, blockStart);
+}
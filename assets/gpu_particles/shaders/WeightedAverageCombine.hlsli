@@ -0,0 +1,52 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Weighted average combine of oit_demo, outputs the premultiplied average
+// color and coverage to be blended over the background
+
+#define IS_SHADER
+#include "Common.hlsli"
+#include "FullscreenVS.hlsli"
+
+#define EPSILON 0.0001f
+
+SamplerState     NearestSampler  : register(COMBINE_SAMPLER_REGISTER);
+Texture2D        ColorTexture    : register(COMBINE_COLOR_REGISTER);
+#if defined(WEIGHTED_AVERAGE_FRAGMENT_COUNT)
+Texture2D<float> CountTexture    : register(COMBINE_EXTRA_REGISTER);
+#elif defined(WEIGHTED_AVERAGE_EXACT_COVERAGE)
+Texture2D<float> CoverageTexture : register(COMBINE_EXTRA_REGISTER);
+#else
+#error
+#endif
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    const float4 colorInfo    = ColorTexture.Sample(NearestSampler, input.uv);
+    const float3 colorSum     = colorInfo.rgb;
+    const float  alphaSum     = max(colorInfo.a, EPSILON);
+    const float3 averageColor = colorSum / alphaSum;
+
+#if defined(WEIGHTED_AVERAGE_FRAGMENT_COUNT)
+    const uint count     = max(1, (uint)CountTexture.Sample(NearestSampler, input.uv));
+    const float coverage = 1.0f - pow(max(0.0f, 1.0f - (alphaSum / count)), count);
+#elif defined(WEIGHTED_AVERAGE_EXACT_COVERAGE)
+    const float coverage = 1.0f - CoverageTexture.Sample(NearestSampler, input.uv);
+#else
+#error
+#endif
+
+    return float4(averageColor * coverage, coverage);
+}
@@ -0,0 +1,53 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Weighted average gather of oit_demo for particles: sums the premultiplied
+// colors and counts the fragments or multiplies their transmittance
+
+#include "ParticleVS.hlsli"
+
+#define EPSILON 0.0001f
+
+struct PSOutput
+{
+    float4 color    : SV_TARGET0;
+#if defined(WEIGHTED_AVERAGE_FRAGMENT_COUNT)
+    float  count    : SV_TARGET1;
+#elif defined(WEIGHTED_AVERAGE_EXACT_COVERAGE)
+    float  coverage : SV_TARGET1;
+#else
+#error
+#endif
+};
+
+PSOutput psmain(VSOutput input)
+{
+    const float4 color = input.color * GetFalloff(input.uv);
+    // The corners of the quads would count as fragments
+    if (color.a < EPSILON) {
+        discard;
+    }
+
+    PSOutput output = (PSOutput)0;
+    output.color    = color;
+#if defined(WEIGHTED_AVERAGE_FRAGMENT_COUNT)
+    output.count    = 1.0f;
+#elif defined(WEIGHTED_AVERAGE_EXACT_COVERAGE)
+    output.coverage = 1.0f - color.a;
+#else
+#error
+#endif
+    return output;
+}
@@ -45,6 +45,9 @@
 #define BUFFER_LISTS_SORTED_FRAGMENT_MAX_COUNT  64
 #define BUFFER_LISTS_INVALID_INDEX              0xFFFFFFFFU
 
+#define MULTI_LAYER_MAX_LAYERS_COUNT            8
+#define MULTI_LAYER_EMPTY_DEPTH                 0xFFFFFFFFU
+
 struct ShaderGlobals
 {
     float4x4 backgroundMVP;
@@ -61,7 +64,7 @@ struct ShaderGlobals
     int      bufferBucketsFragmentsMaxCount;
     int      bufferListsFragmentBufferScale;
     int      bufferListsSortedFragmentMaxCount;
-    int      _intUnused0;
+    int      multiLayerLayersCount;
     int      _intUnused1;
     int      _intUnused2;
 };
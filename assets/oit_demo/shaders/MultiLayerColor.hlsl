@@ -0,0 +1,62 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define IS_SHADER
+#include "Common.hlsli"
+#include "TransparencyVS.hlsli"
+
+Texture2D         OpaqueDepthTexture : register(CUSTOM_TEXTURE_0_REGISTER);
+RWTexture2D<uint> DepthTexture       : register(CUSTOM_UAV_1_REGISTER);
+RWTexture2D<uint> ColorTexture       : register(CUSTOM_UAV_2_REGISTER);
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    // Test fragment against opaque depth
+    {
+        const float opaqueDepth = OpaqueDepthTexture.Load(int3(input.position.xy, 0)).r;
+        clip(input.position.z < opaqueDepth ? 1.0f : -1.0f);
+    }
+
+    const float4 color = float4(input.color, g_Globals.meshOpacity);
+    const uint   depth = asuint(input.position.z);
+
+    // Store the color in the layer holding the fragment depth
+    // Fragments with the same depth own consecutive layers, the first one still empty is taken
+    const uint2 pixelIndex  = (uint2)input.position.xy;
+    const uint  layersCount = min(g_Globals.multiLayerLayersCount, MULTI_LAYER_MAX_LAYERS_COUNT);
+    for(uint i = 0; i < layersCount; ++i)
+    {
+        uint2 layerIndex = pixelIndex;
+        layerIndex.y *= MULTI_LAYER_MAX_LAYERS_COUNT;
+        layerIndex.y += i;
+
+        const uint layerDepth = DepthTexture[layerIndex];
+        if(layerDepth > depth)
+        {
+            break;
+        }
+        if(layerDepth == depth)
+        {
+            uint previousColor = 0;
+            InterlockedCompareExchange(ColorTexture[layerIndex], 0U, PackColor(color), previousColor);
+            if(previousColor == 0U)
+            {
+                return (float4)0.0f;
+            }
+        }
+    }
+
+    // The fragment is behind all the layers, accumulate it in the tail
+    return float4(color.rgb * color.a, color.a);
+}
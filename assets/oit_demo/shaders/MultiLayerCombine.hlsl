@@ -0,0 +1,69 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define IS_SHADER
+#include "Common.hlsli"
+#include "FullscreenVS.hlsli"
+
+Texture2D         TailTexture  : register(CUSTOM_TEXTURE_0_REGISTER);
+RWTexture2D<uint> CountTexture : register(CUSTOM_UAV_0_REGISTER);
+RWTexture2D<uint> DepthTexture : register(CUSTOM_UAV_1_REGISTER);
+RWTexture2D<uint> ColorTexture : register(CUSTOM_UAV_2_REGISTER);
+
+float4 psmain(VSOutput input) : SV_TARGET
+{
+    const uint2 pixelIndex = (uint2)input.position.xy;
+
+    const uint fragmentCount = CountTexture[pixelIndex];
+    CountTexture[pixelIndex] = 0U; // Reset the count for the next frame
+    if(fragmentCount <= 0)
+    {
+        return (float4)0.0f;
+    }
+
+    const uint layersCount = min(g_Globals.multiLayerLayersCount, MULTI_LAYER_MAX_LAYERS_COUNT);
+    const uint layerCount  = min(fragmentCount, layersCount);
+
+    float4 color = float4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // Merge the tail first, as a weighted average of the fragments behind the layers
+    const uint tailCount = fragmentCount - layerCount;
+    if(tailCount > 0)
+    {
+        const float4 tail = TailTexture.Load(int3(input.position.xy, 0));
+        if(tail.a > EPSILON)
+        {
+            const float averageAlpha = tail.a / float(tailCount);
+            const float tailCoverage = 1.0f - pow(max(1.0f - averageAlpha, 0.0f), float(tailCount));
+            MergeColor(color, float4(tail.rgb / tail.a, tailCoverage));
+        }
+    }
+
+    // Merge the layers back to front
+    for(int i = int(layerCount) - 1; i >= 0; --i)
+    {
+        uint2 layerIndex = pixelIndex;
+        layerIndex.y *= MULTI_LAYER_MAX_LAYERS_COUNT;
+        layerIndex.y += i;
+
+        MergeColor(color, UnpackColor(ColorTexture[layerIndex]));
+
+        // Reset the layer for the next frame
+        DepthTexture[layerIndex] = MULTI_LAYER_EMPTY_DEPTH;
+        ColorTexture[layerIndex] = 0U;
+    }
+
+    color.a = 1.0f - color.a;
+    return color;
+}
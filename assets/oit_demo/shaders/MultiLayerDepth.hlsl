@@ -0,0 +1,53 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#define IS_SHADER
+#include "Common.hlsli"
+#include "TransparencyVS.hlsli"
+
+Texture2D         OpaqueDepthTexture : register(CUSTOM_TEXTURE_0_REGISTER);
+RWTexture2D<uint> CountTexture       : register(CUSTOM_UAV_0_REGISTER);
+RWTexture2D<uint> DepthTexture       : register(CUSTOM_UAV_1_REGISTER);
+
+void psmain(VSOutput input)
+{
+    // Test fragment against opaque depth
+    {
+        const float opaqueDepth = OpaqueDepthTexture.Load(int3(input.position.xy, 0)).r;
+        clip(input.position.z < opaqueDepth ? 1.0f : -1.0f);
+    }
+
+    // Count all the fragments of the pixel, the ones that don't fit in the layers end up in the tail
+    const uint2 pixelIndex = (uint2)input.position.xy;
+    InterlockedAdd(CountTexture[pixelIndex], 1U);
+
+    // Insert the fragment depth in the sorted layers (front to back)
+    // Each atomic min keeps the nearest depth in the layer and carries the farthest one to the next layer
+    uint depth = asuint(input.position.z);
+    const uint layersCount = min(g_Globals.multiLayerLayersCount, MULTI_LAYER_MAX_LAYERS_COUNT);
+    for(uint i = 0; i < layersCount; ++i)
+    {
+        uint2 layerIndex = pixelIndex;
+        layerIndex.y *= MULTI_LAYER_MAX_LAYERS_COUNT;
+        layerIndex.y += i;
+
+        uint previousDepth = 0;
+        InterlockedMin(DepthTexture[layerIndex], depth, previousDepth);
+        if(previousDepth == MULTI_LAYER_EMPTY_DEPTH)
+        {
+            break;
+        }
+        depth = max(depth, previousDepth);
+    }
+}
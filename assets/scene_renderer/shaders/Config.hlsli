@@ -31,6 +31,9 @@
 
 #define MAX_IBL_MAPS              16
 
+// Stereo multiview, see ENABLE_MULTIVIEW in MaterialVertex.hlsl
+#define MAX_VIEWS                 2
+
 // -------------------------------------------------------------------------------------------------
 // Registers
 // -------------------------------------------------------------------------------------------------
@@ -72,11 +75,21 @@ struct CameraParams
     float    farDepth;             // offset = 92
 };
 
-// size = 128
+// size = 160
 struct InstanceParams
 {
-    float4x4 modelMatrix;        // offset = 0  (Object space to world space)
-    float4x4 inverseModelMatrix; // offset = 64 (World space to object space)
+    float4x4 modelMatrix;           // offset = 0  (Object space to world space)
+    float4x4 inverseModelMatrix;    // offset = 64 (World space to object space)
+    float3   positionDequantScale;  // offset = 128
+    float    padding0;              // offset = 140
+    float3   positionDequantOffset; // offset = 144 (Compact positions to object space)
+    float    padding1;              // offset = 156
+};
+
+// size = 192, one CameraParams per multiview view
+struct ViewCameraParams
+{
+    CameraParams views[MAX_VIEWS]; // offset = 0
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -91,6 +104,12 @@ struct InstanceParams
 // they want to enable.
 //
 // -------------------------------------------------------------------------------------------------
+// ENABLE_VTX_QUANTIZATION selects the inputs of meshes loaded with
+// VERTEX_QUANTIZATION_COMPACT: positions are relative to the mesh bounds
+// and normals and tangents are octahedral encoded, see the Decode*
+// functions below.
+//
+// -------------------------------------------------------------------------------------------------
 struct StandardVertexInput
 {
     DECLARE_LOCATION(0) float3 PositionOS : POSITION;
@@ -100,18 +119,52 @@ struct StandardVertexInput
 #endif
 
 #if defined(ENABLE_VTX_ATTR_NORMAL)  
+#if defined(ENABLE_VTX_QUANTIZATION)
+    DECLARE_LOCATION(2) float2 Normal : NORMAL;
+#else
     DECLARE_LOCATION(2) float3 Normal : NORMAL;
 #endif
+#endif
 
 #if defined(ENABLE_VTX_ATTR_TANGENT)
+#if defined(ENABLE_VTX_QUANTIZATION)
+    DECLARE_LOCATION(3) float2 Tangent : TANGENT;
+#else
     DECLARE_LOCATION(3) float4 Tangent : TANGENT;
 #endif
+#endif
 
 #if defined(ENABLE_VTX_ATTR_COLOR)
     DECLARE_LOCATION(4) float3 Color : COLOR;
 #endif
 };
 
+// -------------------------------------------------------------------------------------------------
+// Vertex Dequantization
+//
+// Inverses of the encodings in ppx/vertex_quantization.h
+// -------------------------------------------------------------------------------------------------
+float3 DecodePosition(InstanceParams instance, float3 encoded)
+{
+    return instance.positionDequantOffset + instance.positionDequantScale * encoded;
+}
+
+float3 DecodeOctahedral(float2 e)
+{
+    float3 n = float3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0) {
+        float2 s = float2((e.x < 0) ? -1.0 : 1.0, (e.y < 0) ? -1.0 : 1.0);
+        n.xy     = (1.0 - abs(e.yx)) * s;
+    }
+    return normalize(n);
+}
+
+float4 DecodeOctahedralTangent(float2 e)
+{
+    float3 t = DecodeOctahedral(float2(e.x, 2.0 * abs(e.y) - 1.0));
+    return float4(t, (e.y < 0) ? -1.0 : 1.0);
+}
+
 // -------------------------------------------------------------------------------------------------
 // Vertex Outputs
 //
@@ -144,6 +197,12 @@ struct StandardVertexOutput
 #if defined(ENABLE_VTX_ATTR_COLOR)
     DECLARE_LOCATION(5) float3 Color : COLOR;
 #endif
+
+    // DrawParams::instanceIndex plus the draw's instance
+    DECLARE_LOCATION(6) nointerpolation uint InstanceIndex : INSTANCEINDEX;
+
+    // Index into ViewCameraParams::views, 0 without multiview
+    DECLARE_LOCATION(7) nointerpolation uint ViewIndex : VIEWINDEX;
 };
 
 #endif // CONFIG_HLSLI
@@ -30,10 +30,10 @@ float4 psmain(StandardVertexOutput input) : SV_TARGET
         color = float3(input.TexCoord, 0);
     }
     else if(Draw.dbgVtxAttrIndex == DBG_VTX_ATTR_INDEX_NORMAL) {
-        color = mul(Instances[Draw.instanceIndex].modelMatrix, float4(input.Normal, 0)).xyz;
+        color = mul(Instances[input.InstanceIndex].modelMatrix, float4(input.Normal, 0)).xyz;
     }
     else if(Draw.dbgVtxAttrIndex == DBG_VTX_ATTR_INDEX_TANGENT) {
-        color = mul(Instances[Draw.instanceIndex].modelMatrix, float4(input.Tangent.xyz, 0)).xyz;
+        color = mul(Instances[input.InstanceIndex].modelMatrix, float4(input.Tangent.xyz, 0)).xyz;
     }
 
     return float4(normalize(color), 1);
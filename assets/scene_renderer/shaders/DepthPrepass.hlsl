@@ -0,0 +1,48 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Depth-only vertex shader for the depth prepass. Reads positions only, the
+// position vertex binding of scene meshes, and draws without a pixel
+// shader. Positions are computed exactly like MaterialVertex.hlsl so the
+// shading pass can test depth with COMPARE_OP_EQUAL.
+#include "MaterialInterface.hlsli"
+
+// ENABLE_MULTIVIEW draws every view of a multiview render pass at once
+#if defined(ENABLE_MULTIVIEW)
+float4 vsmain(DECLARE_LOCATION(0) float3 InputPositionOS : POSITION, uint instanceId : SV_InstanceID, uint viewId : SV_ViewID) : SV_POSITION
+#else
+float4 vsmain(DECLARE_LOCATION(0) float3 InputPositionOS : POSITION, uint instanceId : SV_InstanceID) : SV_POSITION
+#endif
+{
+#if defined(ENABLE_MULTIVIEW)
+    uint viewIndex = viewId;
+#else
+    uint viewIndex = 0;
+#endif
+
+    // Instanced draws use consecutive instance params
+    uint           instanceIndex = Draw.instanceIndex + instanceId;
+    InstanceParams instance      = Instances[instanceIndex];
+
+#if defined(ENABLE_VTX_QUANTIZATION)
+    precise float3 PositionOS = DecodePosition(instance, InputPositionOS);
+#else
+    precise float3 PositionOS = InputPositionOS;
+#endif
+
+    precise float4 PositionWS4 = mul(instance.modelMatrix, float4(PositionOS, 1));
+    precise float4 PositionCS  = mul(Cameras.views[viewIndex].viewProjectionMatrix, PositionWS4);
+    return PositionCS;
+}
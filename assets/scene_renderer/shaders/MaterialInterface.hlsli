@@ -20,15 +20,16 @@
 // -------------------------------------------------------------------------------------------------
 // Material Params Structs
 // -------------------------------------------------------------------------------------------------
-// size = 24
+// size = 28
 struct MaterialTextureParams
 {
     uint     textureIndex;      // offset = 0
     uint     samplerIndex;      // offset = 4
     float2x2 texCoordTransform; // offset = 8
+    uint     arrayLayer;        // offset = 24
 };
 
-// size = 164
+// size = 184
 struct MaterialParams
 {
     float4                baseColorFactor;      // offset = 0
@@ -38,10 +39,10 @@ struct MaterialParams
     float3                emissiveFactor;       // offset = 28
     float                 emissiveStrength;     // offset = 40
     MaterialTextureParams baseColorTex;         // offset = 44
-    MaterialTextureParams metallicRoughnessTex; // offset = 68
-    MaterialTextureParams normalTex;            // offset = 92
-    MaterialTextureParams occlusionTex;         // offset = 116
-    MaterialTextureParams emssiveTex;           // offset = 140
+    MaterialTextureParams metallicRoughnessTex; // offset = 72
+    MaterialTextureParams normalTex;            // offset = 100
+    MaterialTextureParams occlusionTex;         // offset = 128
+    MaterialTextureParams emssiveTex;           // offset = 156
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -74,12 +75,12 @@ ConstantBuffer<DrawParams> Draw : register(DRAW_PARAMS_REGISTER);
 // -------------------------------------------------------------------------------------------------
 // ConstantBuffers
 // -------------------------------------------------------------------------------------------------
-ConstantBuffer<FrameParams>  Frame  : register(FRAME_PARAMS_REGISTER);
-ConstantBuffer<CameraParams> Camera : register(CAMERA_PARAMS_REGISTER);
+ConstantBuffer<FrameParams>      Frame   : register(FRAME_PARAMS_REGISTER);
+ConstantBuffer<ViewCameraParams> Cameras : register(CAMERA_PARAMS_REGISTER);
 
 // -------------------------------------------------------------------------------------------------
 // Models and Materials Arrays
-//   - use DrawParams::instanceIndex to index into Instances
+//   - use DrawParams::instanceIndex plus SV_InstanceID to index into Instances
 //   - use DrawParams::materialIndex to index into Materials
 //
 // -------------------------------------------------------------------------------------------------
@@ -104,8 +105,10 @@ Texture2D    IBLEnvironmentMaps[MAX_IBL_MAPS] : register(IBL_ENVIRONMENT_MAP_REG
 // Material Samplers and Textures
 //   - use MaterialTextureParams::samplerIndex to index into MaterialSamplers
 //   - use MaterialTextureParams::textureIndex to index into MaterialTextures
+//   - use MaterialTextureParams::arrayLayer as the texture's layer, small
+//     images can be packed into a shared texture array
 // -------------------------------------------------------------------------------------------------
-SamplerState MaterialSamplers[MAX_MATERIAL_SAMPLERS] : register(MATERIAL_SAMPLERS_REGISTER);
-Texture2D    MaterialTextures[MAX_MATERIAL_TEXTURES] : register(MATERIAL_TEXTURES_REGISTER);
+SamplerState   MaterialSamplers[MAX_MATERIAL_SAMPLERS] : register(MATERIAL_SAMPLERS_REGISTER);
+Texture2DArray MaterialTextures[MAX_MATERIAL_TEXTURES] : register(MATERIAL_TEXTURES_REGISTER);
 
 #endif // MATERIAL_INTERFACE_HLSLI
@@ -17,17 +17,46 @@
 #define ENABLE_VTX_ATTR_TANGENT
 #include "MaterialInterface.hlsli"
 
-StandardVertexOutput vsmain(StandardVertexInput input)
+// ENABLE_MULTIVIEW draws every view of a multiview render pass at once,
+// with the camera of SV_ViewID. It requires multiview support.
+#if defined(ENABLE_MULTIVIEW)
+StandardVertexOutput vsmain(StandardVertexInput input, uint instanceId : SV_InstanceID, uint viewId : SV_ViewID)
+#else
+StandardVertexOutput vsmain(StandardVertexInput input, uint instanceId : SV_InstanceID)
+#endif
 {
-    InstanceParams instance = Instances[Draw.instanceIndex];
+#if defined(ENABLE_MULTIVIEW)
+    uint viewIndex = viewId;
+#else
+    uint viewIndex = 0;
+#endif
 
-    float4 PositionWS4 = mul(instance.modelMatrix, float4(input.PositionOS, 1));
+    // Instanced draws use consecutive instance params
+    uint           instanceIndex = Draw.instanceIndex + instanceId;
+    InstanceParams instance      = Instances[instanceIndex];
+
+    // Positions are precise to match DepthPrepass.hlsl exactly, shading
+    // after a depth prepass tests depth with COMPARE_OP_EQUAL
+#if defined(ENABLE_VTX_QUANTIZATION)
+    precise float3 PositionOS = DecodePosition(instance, input.PositionOS);
+    float3         Normal     = DecodeOctahedral(input.Normal);
+    float4         Tangent    = DecodeOctahedralTangent(input.Tangent);
+#else
+    precise float3 PositionOS = input.PositionOS;
+    float3         Normal     = input.Normal;
+    float4         Tangent    = input.Tangent;
+#endif
+
+    precise float4 PositionWS4 = mul(instance.modelMatrix, float4(PositionOS, 1));
+    precise float4 PositionCS  = mul(Cameras.views[viewIndex].viewProjectionMatrix, PositionWS4);
 
     StandardVertexOutput output = (StandardVertexOutput)0;
     output.PositionWS = PositionWS4;
-    output.PositionCS = mul(Camera.viewProjectionMatrix, PositionWS4);
+    output.PositionCS = PositionCS;
     output.TexCoord   = input.TexCoord;
-    output.Normal     = input.Normal;
-    output.Tangent    = input.Tangent;
+    output.Normal     = Normal;
+    output.Tangent    = Tangent;
+    output.InstanceIndex = instanceIndex;
+    output.ViewIndex     = viewIndex;
     return output;
 }
@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Motion vectors for XR_FB_space_warp: the NDC space motion of each pixel
+// since the previous frame, current minus previous. Drawn by
+// scene::MotionVectorRenderer from unquantized positions.
+
+#include "Config.hlsli"
+
+// Must match scene::MotionVectorRenderer
+struct MotionVectorDraw
+{
+    uint instanceIndex;
+};
+
+struct MotionVectorViews
+{
+    float4x4 viewProjectionMatrix[MAX_VIEWS];
+    float4x4 prevViewProjectionMatrix[MAX_VIEWS];
+};
+
+struct MotionVectorInstance
+{
+    float4x4 modelMatrix;
+    float4x4 prevModelMatrix;
+};
+
+#if defined(__spirv__)
+[[vk::push_constant]]
+#endif
+ConstantBuffer<MotionVectorDraw> Draw : register(b0);
+
+ConstantBuffer<MotionVectorViews>      Views     : register(b1);
+StructuredBuffer<MotionVectorInstance> Instances : register(t2);
+
+struct MotionVectorVertexOutput
+{
+    float4                     PositionCS     : SV_POSITION;
+    DECLARE_LOCATION(0) float4 CurrPositionCS : CURR_POSITION;
+    DECLARE_LOCATION(1) float4 PrevPositionCS : PREV_POSITION;
+};
+
+// ENABLE_MULTIVIEW draws every view of a multiview render pass at once
+#if defined(ENABLE_MULTIVIEW)
+MotionVectorVertexOutput vsmain(DECLARE_LOCATION(0) float3 PositionOS : POSITION, uint viewId : SV_ViewID)
+#else
+MotionVectorVertexOutput vsmain(DECLARE_LOCATION(0) float3 PositionOS : POSITION)
+#endif
+{
+#if defined(ENABLE_MULTIVIEW)
+    uint viewIndex = viewId;
+#else
+    uint viewIndex = 0;
+#endif
+
+    MotionVectorInstance instance = Instances[Draw.instanceIndex];
+
+    MotionVectorVertexOutput output = (MotionVectorVertexOutput)0;
+    output.CurrPositionCS = mul(Views.viewProjectionMatrix[viewIndex], mul(instance.modelMatrix, float4(PositionOS, 1)));
+    output.PrevPositionCS = mul(Views.prevViewProjectionMatrix[viewIndex], mul(instance.prevModelMatrix, float4(PositionOS, 1)));
+    output.PositionCS     = output.CurrPositionCS;
+    return output;
+}
+
+float4 psmain(MotionVectorVertexOutput input) : SV_TARGET
+{
+    // Divided per pixel, interpolated NDC positions aren't perspective correct
+    float3 currNDC = input.CurrPositionCS.xyz / input.CurrPositionCS.w;
+    float3 prevNDC = input.PrevPositionCS.xyz / input.PrevPositionCS.w;
+    return float4(currNDC - prevNDC, 0);
+}
@@ -24,7 +24,7 @@
 // -------------------------------------------------------------------------------------------------
 float4 psmain(StandardVertexOutput input) : SV_TARGET
 {
-    InstanceParams instance = Instances[Draw.instanceIndex];
+    InstanceParams instance = Instances[input.InstanceIndex];
 
     MaterialParams material = Materials[Draw.materialIndex];
 
@@ -40,9 +40,9 @@ float4 psmain(StandardVertexOutput input) : SV_TARGET
     // Base color
     float4 baseColor = material.baseColorFactor;
     if (baseColorTex.textureIndex != INVALID_INDEX) {
-        Texture2D    tex = MaterialTextures[baseColorTex.textureIndex];
-        SamplerState samp = MaterialSamplers[baseColorTex.samplerIndex];
-        float4       color = tex.Sample(samp, uv);
+        Texture2DArray tex = MaterialTextures[baseColorTex.textureIndex];
+        SamplerState   samp = MaterialSamplers[baseColorTex.samplerIndex];
+        float4         color = tex.Sample(samp, float3(uv, baseColorTex.arrayLayer));
 
         baseColor =  baseColor * float4(RemoveGamma(color.rgb, 2.2), color.a);
     }
@@ -51,9 +51,9 @@ float4 psmain(StandardVertexOutput input) : SV_TARGET
     float metallic  = material.metallicFactor;
     float roughness = material.roughnessFactor;
     if (metalRoughTex.textureIndex != INVALID_INDEX) {
-        Texture2D    tex = MaterialTextures[metalRoughTex.textureIndex];
-        SamplerState samp = MaterialSamplers[metalRoughTex.samplerIndex];                
-        float4       value = tex.Sample(samp, uv);
+        Texture2DArray tex = MaterialTextures[metalRoughTex.textureIndex];
+        SamplerState   samp = MaterialSamplers[metalRoughTex.samplerIndex];                
+        float4         value = tex.Sample(samp, float3(uv, metalRoughTex.arrayLayer));
 
         metallic  = metallic * value.b;
         roughness = roughness * value.g;
@@ -62,11 +62,11 @@ float4 psmain(StandardVertexOutput input) : SV_TARGET
     // Normal (N)
     float3 N = normalize(mul(instance.modelMatrix, float4(input.Normal, 0)).xyz);
     if (normalTex.textureIndex != INVALID_INDEX) {
-        Texture2D    tex = MaterialTextures[normalTex.textureIndex];
-        SamplerState samp = MaterialSamplers[normalTex.samplerIndex];
+        Texture2DArray tex = MaterialTextures[normalTex.textureIndex];
+        SamplerState   samp = MaterialSamplers[normalTex.samplerIndex];
     
         // Read normal map value in tangent space
-        float3 vNt = normalize((tex.Sample(samp, uv).rgb * 2.0) - 1.0);
+        float3 vNt = normalize((tex.Sample(samp, float3(uv, normalTex.arrayLayer)).rgb * 2.0) - 1.0);
     
         // Apply TBN transform
         float3 vN = N;
@@ -86,7 +86,7 @@ float4 psmain(StandardVertexOutput input) : SV_TARGET
 
     // Position, View
     float3 P = input.PositionWS.xyz;
-    float3 V = normalize(Camera.eyePosition - P);
+    float3 V = normalize(Cameras.views[input.ViewIndex].eyePosition - P);
 
     // Calculate reflection vector and cosine angle bewteen N and V
     float3 R = reflect(-V, N);
@@ -32,10 +32,10 @@ float4 psmain(StandardVertexOutput input) : SV_TARGET
     // Calculate output color
     float4 color = material.baseColorFactor;
     if (baseColorTex.textureIndex != INVALID_INDEX) {
-        Texture2D    tex = MaterialTextures[baseColorTex.textureIndex];
-        SamplerState sam = MaterialSamplers[baseColorTex.samplerIndex];
+        Texture2DArray tex = MaterialTextures[baseColorTex.textureIndex];
+        SamplerState   sam = MaterialSamplers[baseColorTex.samplerIndex];
 
-        float4 value = tex.Sample(sam, uv);
+        float4 value = tex.Sample(sam, float3(uv, baseColorTex.arrayLayer));
         color = color * value;
     }
 
@@ -0,0 +1,219 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// Replays a capture made with ppx::CommandCapture in a tight loop and
+// reports the GPU and CPU time of each replay:
+//
+//   capture_replay <file> [--iterations <n>] [--gpu <index>] [--reset-contents]
+//
+// The commands are recorded once into a reusable command buffer, so the
+// loop only submits and waits. --reset-contents restores the captured
+// buffer contents before every replay, for work whose cost depends on
+// the data; the copies are outside of the timed region on the GPU.
+
+#include "ppx/command_capture.h"
+#include "ppx/compute_context.h"
+#include "ppx/log.h"
+#include "ppx/timer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+struct Options
+{
+    std::string path;
+    uint32_t    iterations    = 100;
+    uint32_t    gpuIndex      = 0;
+    bool        resetContents = false;
+};
+
+static bool ParseOptions(int argc, char** argv, Options* pOptions)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg     = argv[i];
+        const bool        hasNext = (i + 1) < argc;
+        if ((arg == "--iterations") && hasNext) {
+            pOptions->iterations = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if ((arg == "--gpu") && hasNext) {
+            pOptions->gpuIndex = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--reset-contents") {
+            pOptions->resetContents = true;
+        }
+        else if (pOptions->path.empty() && (arg.rfind("--", 0) != 0)) {
+            pOptions->path = arg;
+        }
+        else {
+            return false;
+        }
+    }
+    return !pOptions->path.empty() && (pOptions->iterations > 0);
+}
+
+static Result Replay(const Options& options)
+{
+    CaptureData data   = {};
+    Result      ppxres = LoadCaptureData(options.path, &data);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ComputeContextCreateInfo contextCreateInfo = {};
+    contextCreateInfo.api                      = kApi;
+    contextCreateInfo.gpuIndex                 = options.gpuIndex;
+    contextCreateInfo.applicationName          = "capture_replay";
+
+    ComputeContext* pContextRaw = nullptr;
+    ppxres                      = ComputeContext::Create(contextCreateInfo, &pContextRaw);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    std::unique_ptr<ComputeContext> context(pContextRaw);
+
+    grfx::DevicePtr device = context->GetDevice();
+    grfx::QueuePtr  queue  = context->GetComputeQueue();
+
+    CaptureReplayer* pReplayerRaw = nullptr;
+    ppxres                        = CaptureReplayer::Create(queue, data, &pReplayerRaw);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    std::unique_ptr<CaptureReplayer> replayer(pReplayerRaw);
+
+    grfx::QueryCreateInfo queryCreateInfo = {};
+    queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+    queryCreateInfo.count                 = 2;
+
+    grfx::FenceCreateInfo fenceCreateInfo = {};
+
+    grfx::QueryPtr         query;
+    grfx::FencePtr         fence;
+    grfx::CommandBufferPtr cmd;
+
+    ppxres = device->CreateQuery(&queryCreateInfo, &query);
+    if (Success(ppxres)) {
+        ppxres = device->CreateFence(&fenceCreateInfo, &fence);
+    }
+    if (Success(ppxres)) {
+        ppxres = queue->CreateReusableCommandBuffer(&cmd);
+    }
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Recorded once, the loop below only submits
+    ppxres = cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    if (options.resetContents) {
+        replayer->RecordResetContents(cmd);
+    }
+    cmd->WriteTimestamp(query, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    replayer->RecordFrames(cmd);
+    cmd->WriteTimestamp(query, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+    cmd->ResolveQueryData(query, 0, 2);
+    ppxres = cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    uint64_t frequency = 0;
+    ppxres             = queue->GetTimestampFrequency(&frequency);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &cmd;
+    submitInfo.pFence             = fence;
+
+    std::vector<double> gpuMs;
+    std::vector<double> cpuMs;
+    for (uint32_t i = 0; i < options.iterations; ++i) {
+        query->Reset(0, 2);
+
+        Timer timer;
+        timer.Start();
+        ppxres = queue->Submit(&submitInfo);
+        if (Success(ppxres)) {
+            ppxres = fence->WaitAndReset();
+        }
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        cpuMs.push_back(timer.MillisSinceStart());
+
+        uint64_t timestamps[2] = {0, 0};
+        ppxres                 = query->GetData(timestamps, sizeof(timestamps));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        gpuMs.push_back(1000.0 * static_cast<double>(timestamps[1] - timestamps[0]) / static_cast<double>(frequency));
+    }
+
+    auto report = [](const char* pName, std::vector<double> values) {
+        std::sort(values.begin(), values.end());
+        double total = 0;
+        for (double value : values) {
+            total += value;
+        }
+        PPX_LOG_INFO(pName << " ms: min " << values.front() << ", median " << values[values.size() / 2] << ", mean " << (total / static_cast<double>(values.size())) << ", max " << values.back());
+    };
+
+    PPX_LOG_INFO("Replayed " << replayer->GetFrameCount() << " captured frames " << options.iterations << " times on " << device->GetGpu()->GetDeviceName());
+    report("GPU", gpuMs);
+    report("CPU submit to completion", cpuMs);
+
+    queue->DestroyCommandBuffer(cmd);
+    device->DestroyFence(fence);
+    device->DestroyQuery(query);
+
+    return ppx::SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    Log::Initialize(LOG_MODE_CONSOLE);
+    Timer::InitializeStaticData();
+
+    Options options = {};
+    if (!ParseOptions(argc, argv, &options)) {
+        std::cerr << "usage: " << argv[0] << " <file> [--iterations <n>] [--gpu <index>] [--reset-contents]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Result ppxres = Replay(options);
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("Replay failed: " << ToString(ppxres));
+    }
+
+    Log::Shutdown();
+
+    return Failed(ppxres) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
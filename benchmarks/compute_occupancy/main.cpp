@@ -0,0 +1,455 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+#include "ppx/grfx/grfx_util.h"
+
+#include <cstring>
+#include <fstream>
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+// Must match ComputeOccupancy.hlsl
+static const uint64_t kKernelOps = 128;
+
+static const uint32_t kThreadCount = 1024 * 1024; // Per dispatch, a multiple of every group size
+static const uint64_t kSampleWork  = 1ull << 28;  // Minimum thread iterations of the dispatches of a sample
+
+enum SubgroupOp
+{
+    SUBGROUP_OP_NONE       = 0,
+    SUBGROUP_OP_REDUCE     = 1,
+    SUBGROUP_OP_PREFIX_SUM = 2,
+    SUBGROUP_OP_BALLOT     = 3,
+    SUBGROUP_OP_COUNT      = 4,
+};
+
+static const char* kSubgroupOpNames[SUBGROUP_OP_COUNT] = {"none", "reduce", "prefix_sum", "ballot"};
+
+// Each sweep varies one parameter of the default group size 256, no shared
+// memory, 8 registers and no subgroup op variant. Must match the variants in
+// assets/benchmarks/shaders/CMakeLists.txt.
+struct Variant
+{
+    const char* sweep;
+    uint32_t    groupSize;
+    uint32_t    sharedKiB;
+    uint32_t    registers;
+    SubgroupOp  subgroupOp;
+};
+
+// clang-format off
+static const Variant kVariants[] = {
+    {"group_size",          32,   0,  8,   SUBGROUP_OP_NONE},
+    {"group_size",          64,   0,  8,   SUBGROUP_OP_NONE},
+    {"group_size",          128,  0,  8,   SUBGROUP_OP_NONE},
+    {"group_size",          256,  0,  8,   SUBGROUP_OP_NONE},
+    {"group_size",          512,  0,  8,   SUBGROUP_OP_NONE},
+    {"group_size",          1024, 0,  8,   SUBGROUP_OP_NONE},
+    {"shared_memory",       256,  1,  8,   SUBGROUP_OP_NONE},
+    {"shared_memory",       256,  4,  8,   SUBGROUP_OP_NONE},
+    {"shared_memory",       256,  8,  8,   SUBGROUP_OP_NONE},
+    {"shared_memory",       256,  16, 8,   SUBGROUP_OP_NONE},
+    {"shared_memory",       256,  32, 8,   SUBGROUP_OP_NONE},
+    {"registers",           256,  0,  16,  SUBGROUP_OP_NONE},
+    {"registers",           256,  0,  32,  SUBGROUP_OP_NONE},
+    {"registers",           256,  0,  64,  SUBGROUP_OP_NONE},
+    {"registers",           256,  0,  128, SUBGROUP_OP_NONE},
+    {"subgroup_reduce",     64,   0,  8,   SUBGROUP_OP_REDUCE},
+    {"subgroup_reduce",     256,  0,  8,   SUBGROUP_OP_REDUCE},
+    {"subgroup_reduce",     1024, 0,  8,   SUBGROUP_OP_REDUCE},
+    {"subgroup_prefix_sum", 64,   0,  8,   SUBGROUP_OP_PREFIX_SUM},
+    {"subgroup_prefix_sum", 256,  0,  8,   SUBGROUP_OP_PREFIX_SUM},
+    {"subgroup_prefix_sum", 1024, 0,  8,   SUBGROUP_OP_PREFIX_SUM},
+    {"subgroup_ballot",     64,   0,  8,   SUBGROUP_OP_BALLOT},
+    {"subgroup_ballot",     256,  0,  8,   SUBGROUP_OP_BALLOT},
+    {"subgroup_ballot",     1024, 0,  8,   SUBGROUP_OP_BALLOT},
+};
+// clang-format on
+
+// Must match ComputeOccupancyParams in ComputeOccupancy.hlsl
+struct ComputeOccupancyParams
+{
+    uint32_t threadCount;
+    uint32_t iterations;
+    uint32_t seed;
+    uint32_t padding;
+};
+
+// Measures the ALU throughput of a compute kernel over variants sweeping the
+// workgroup size, the shared memory allocated per workgroup, the registers
+// kept live per thread and subgroup ops, to find where each GPU's occupancy
+// drops. Each variant is measured for --samples frames after a warmup frame
+// and recorded as a "<sweep>_<value>" gauge in Gops/s (10^9 multiply-adds per
+// second). After every pass over the variants, the best variant of each sweep
+// and the mean of all of them are written to --best-config-path as JSON.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct Case
+    {
+        Variant                  variant     = {};
+        std::string              name        = "";
+        metrics::MetricID        metricId    = metrics::kInvalidMetricID;
+        grfx::ComputePipelinePtr pipeline;
+        double                   totalGops   = 0.0; // Of the samples since the last log
+        uint32_t                 sampleCount = 0;
+        double                   meanGops    = 0.0; // Of all the samples so far
+        uint64_t                 meanCount   = 0;
+    };
+
+    void SetupCases();
+    void RecordCase(const Case& c, uint32_t dispatchCount);
+    void FinishSample(Case& c, uint64_t ticks, uint64_t ops);
+    void WriteBestConfig() const;
+
+    uint64_t GetDispatchOps() const
+    {
+        return static_cast<uint64_t>(kThreadCount) * pIterations->GetValue() * kKernelOps;
+    }
+
+private:
+    std::shared_ptr<KnobFlag<int>>         pIterations;
+    std::shared_ptr<KnobFlag<int>>         pSamples;
+    std::shared_ptr<KnobFlag<int>>         pPasses;
+    std::shared_ptr<KnobFlag<int>>         pMaxGroupSize;
+    std::shared_ptr<KnobFlag<int>>         pMaxSharedKiB;
+    std::shared_ptr<KnobFlag<std::string>> pBestConfigPath;
+
+    grfx::CommandBufferPtr       mCommandBuffer;
+    grfx::FencePtr               mFence;
+    grfx::QueryPtr               mTimestampQuery;
+    grfx::BufferPtr              mOutputBuffer;
+    grfx::DescriptorPoolPtr      mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr mLayout;
+    grfx::DescriptorSetPtr       mSet;
+    grfx::PipelineInterfacePtr   mPipelineInterface;
+
+    std::vector<Case> mCases;
+    uint32_t          mCaseIndex     = 0;
+    uint32_t          mFrameInCase   = 0; // The first frame of a case is a warmup
+    uint32_t          mPass          = 0; // Over all cases
+    uint32_t          mDispatchCount = 0; // Of the submitted frame, 0 if nothing is in flight
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pIterations, "iterations", 64);
+    pIterations->SetFlagDescription("Number of iterations of the kernel loop per thread.");
+    pIterations->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each variant is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all variants are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+
+    GetKnobManager().InitKnob(&pMaxGroupSize, "max-group-size", 1024);
+    pMaxGroupSize->SetFlagDescription("Variants with larger workgroups are skipped, for GPUs supporting fewer than 1024 invocations per workgroup.");
+    pMaxGroupSize->SetValidator([](int value) { return value >= 64; });
+
+    GetKnobManager().InitKnob(&pMaxSharedKiB, "max-shared-kib", 32);
+    pMaxSharedKiB->SetFlagDescription("Variants with more shared memory in KiB are skipped, Vulkan only guarantees 16.");
+    pMaxSharedKiB->SetValidator([](int value) { return value >= 0; });
+
+    GetKnobManager().InitKnob(&pBestConfigPath, "best-config-path", "compute_occupancy_best.json");
+    pBestConfigPath->SetFlagDescription("Path of the JSON summary of the best variant of each sweep, empty to not write it.");
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "compute_occupancy";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    for (const Variant& variant : kVariants) {
+        if ((variant.groupSize > static_cast<uint32_t>(pMaxGroupSize->GetValue())) || (variant.sharedKiB > static_cast<uint32_t>(pMaxSharedKiB->GetValue()))) {
+            continue;
+        }
+
+        Case c    = {};
+        c.variant = variant;
+        c.name    = std::string(variant.sweep) + "_";
+        if (variant.sharedKiB > 0) {
+            c.name += std::to_string(variant.sharedKiB) + "KiB";
+        }
+        else if (variant.registers != kVariants[0].registers) {
+            c.name += std::to_string(variant.registers);
+        }
+        else {
+            c.name += std::to_string(variant.groupSize);
+        }
+        mCases.push_back(c);
+    }
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    // Output buffer, one uint per thread
+    {
+        grfx::BufferCreateInfo createInfo           = {};
+        createInfo.size                             = kThreadCount * sizeof(uint32_t);
+        createInfo.usageFlags.bits.rawStorageBuffer = true;
+        createInfo.memoryUsage                      = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                     = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mOutputBuffer));
+    }
+
+    // Descriptors and pipeline interface shared by all variants
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.rawStorageBuffer               = 1;
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(1, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mLayout));
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mLayout, &mSet));
+
+        grfx::WriteDescriptor write = {};
+        write.binding               = 1;
+        write.type                  = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+        write.bufferOffset          = 0;
+        write.bufferRange           = PPX_WHOLE_SIZE;
+        write.pBuffer               = mOutputBuffer;
+        PPX_CHECKED_CALL(mSet->UpdateDescriptors(1, &write));
+
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mLayout;
+        piCreateInfo.pushConstants.count               = sizeof(ComputeOccupancyParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding             = 0;
+        piCreateInfo.pushConstants.set                 = 0;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+    }
+
+    // One pipeline per variant
+    for (Case& c : mCases) {
+        const Variant&    v    = c.variant;
+        const std::string name = "ComputeOccupancy_g" + std::to_string(v.groupSize) + "_s" + std::to_string(v.sharedKiB) + "_r" + std::to_string(v.registers) + "_o" + std::to_string(v.subgroupOp);
+
+        std::vector<char> bytecode = LoadShader("benchmarks/shaders", name + ".cs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed: " << name);
+        grfx::ShaderModulePtr        shader;
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &shader));
+
+        grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+        cpCreateInfo.CS                              = {shader.Get(), "csmain"};
+        cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+        PPX_CHECKED_CALL(GetDevice()->CreateComputePipeline(&cpCreateInfo, &c.pipeline));
+
+        GetDevice()->DestroyShaderModule(shader);
+    }
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    PPX_LOG_INFO("Measuring " << mCases.size() << " compute occupancy variants");
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name, "Gops/s", metrics::MetricInterpretation::HIGHER_IS_BETTER};
+        c.metricId                       = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.metricId != metrics::kInvalidMetricID, "Failed to add metric " << c.name);
+    }
+}
+
+void ProjApp::RecordCase(const Case& c, uint32_t dispatchCount)
+{
+    ComputeOccupancyParams params = {};
+    params.threadCount            = kThreadCount;
+    params.iterations             = static_cast<uint32_t>(pIterations->GetValue());
+    params.seed                   = static_cast<uint32_t>(GetFrameCount());
+
+    mCommandBuffer->BindComputeDescriptorSets(mPipelineInterface, 1, &mSet);
+    mCommandBuffer->BindComputePipeline(c.pipeline);
+    mCommandBuffer->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+    // The output is never read, dispatches don't need to be ordered
+    for (uint32_t i = 0; i < dispatchCount; ++i) {
+        mCommandBuffer->Dispatch(kThreadCount / c.variant.groupSize, 1, 1);
+    }
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks, uint64_t ops)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double seconds = static_cast<double>(ticks) / static_cast<double>(frequency);
+    const double gops    = static_cast<double>(ops) / seconds / 1e9;
+    c.totalGops += gops;
+    ++c.sampleCount;
+    ++c.meanCount;
+    c.meanGops += (gops - c.meanGops) / static_cast<double>(c.meanCount);
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = gops;
+    RecordMetricData(c.metricId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        PPX_LOG_INFO(c.name << ": " << (c.totalGops / c.sampleCount) << " Gops/s");
+        c.totalGops   = 0.0;
+        c.sampleCount = 0;
+    }
+}
+
+void ProjApp::WriteBestConfig() const
+{
+    const std::string path = pBestConfigPath->GetValue();
+    if (path.empty()) {
+        return;
+    }
+
+    auto exportCase = [](const Case& c) {
+        nlohmann::json json;
+        json["name"]        = c.name;
+        json["group_size"]  = c.variant.groupSize;
+        json["shared_kib"]  = c.variant.sharedKiB;
+        json["registers"]   = c.variant.registers;
+        json["subgroup_op"] = kSubgroupOpNames[c.variant.subgroupOp];
+        json["gops"]        = c.meanGops;
+        return json;
+    };
+
+    // Cases of a sweep are consecutive
+    nlohmann::json best = nlohmann::json::object();
+    nlohmann::json all  = nlohmann::json::array();
+    for (size_t i = 0; i < mCases.size(); ++i) {
+        const Case& c = mCases[i];
+        all.push_back(exportCase(c));
+
+        const bool first = (i == 0) || (std::strcmp(mCases[i - 1].variant.sweep, c.variant.sweep) != 0);
+        if (first || (c.meanGops > best[c.variant.sweep]["gops"].get<double>())) {
+            best[c.variant.sweep] = exportCase(c);
+        }
+    }
+
+    nlohmann::json content;
+    content["api"]    = grfx::ToString(kApi);
+    content["device"] = GetDevice()->GetDeviceName();
+    content["unit"]   = "Gops/s";
+    content["best"]   = best;
+    content["cases"]  = all;
+
+    std::ofstream file(path);
+    if (!file) {
+        PPX_LOG_ERROR("Failed to write the best configs to " << path);
+        return;
+    }
+    file << content.dump(4) << std::endl;
+    PPX_LOG_INFO("Wrote the best configs to " << path);
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mDispatchCount > 0) {
+        uint64_t timestamps[2] = {0};
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        if (mFrameInCase > 0) {
+            FinishSample(mCases[mCaseIndex], timestamps[1] - timestamps[0], mDispatchCount * GetDispatchOps());
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                WriteBestConfig();
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    const Case&    c                = mCases[mCaseIndex];
+    const uint64_t threadIterations = static_cast<uint64_t>(kThreadCount) * pIterations->GetValue();
+    mDispatchCount                  = static_cast<uint32_t>(std::max<uint64_t>(1, kSampleWork / threadIterations));
+
+    mTimestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        RecordCase(c, mDispatchCount);
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+}
+
+SETUP_APPLICATION(ProjApp)
@@ -0,0 +1,289 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpu_benchmark.h"
+
+#include "ppx/command_line_parser.h"
+#include "ppx/knob.h"
+#include "ppx/log.h"
+#include "ppx/metrics.h"
+#include "ppx/timer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// -------------------------------------------------------------------------------------------------
+// Allocation counting
+// -------------------------------------------------------------------------------------------------
+
+namespace {
+
+std::atomic<uint64_t> sAllocationCount{0};
+std::atomic<uint64_t> sAllocationBytes{0};
+
+void* CountedAlloc(size_t size)
+{
+    sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    sAllocationBytes.fetch_add(size, std::memory_order_relaxed);
+    void* p = std::malloc((size > 0) ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+} // namespace
+
+// The aligned overloads keep their default implementation and aren't counted
+void* operator new(size_t size)
+{
+    return CountedAlloc(size);
+}
+
+void* operator new[](size_t size)
+{
+    return CountedAlloc(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace cpu_benchmark {
+
+// -------------------------------------------------------------------------------------------------
+// State
+// -------------------------------------------------------------------------------------------------
+
+State::State(uint64_t iterations)
+    : mIterations(iterations), mRemaining(iterations)
+{
+}
+
+bool State::KeepRunning()
+{
+    if (!mStarted) {
+        Start();
+    }
+    if (mRemaining == 0) {
+        Stop();
+        return false;
+    }
+    --mRemaining;
+    return true;
+}
+
+void State::Start()
+{
+    mStarted         = true;
+    mAllocationCount = sAllocationCount.load(std::memory_order_relaxed);
+    mAllocationBytes = sAllocationBytes.load(std::memory_order_relaxed);
+    ppx::Timer::Timestamp(&mStartTimestamp);
+}
+
+void State::Stop()
+{
+    ppx::Timer::Timestamp(&mStopTimestamp);
+    mAllocationCount = sAllocationCount.load(std::memory_order_relaxed) - mAllocationCount;
+    mAllocationBytes = sAllocationBytes.load(std::memory_order_relaxed) - mAllocationBytes;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Registration
+// -------------------------------------------------------------------------------------------------
+
+namespace {
+
+struct Benchmark
+{
+    const char*       name     = nullptr;
+    BenchmarkFunction function = nullptr;
+};
+
+// Function local so it's constructed before the first registration
+std::vector<Benchmark>& GetBenchmarks()
+{
+    static std::vector<Benchmark> sBenchmarks;
+    return sBenchmarks;
+}
+
+// Per iteration, of one repetition
+struct Sample
+{
+    double nanos       = 0;
+    double allocations = 0;
+    double bytes       = 0;
+};
+
+Sample RunIterations(const Benchmark& benchmark, uint64_t iterations)
+{
+    State state(iterations);
+    benchmark.function(state);
+    PPX_ASSERT_MSG(state.GetIterations() == iterations, "benchmark " << benchmark.name << " must loop while KeepRunning() returns true");
+
+    Sample sample      = {};
+    sample.nanos       = static_cast<double>(state.GetElapsedNanos()) / static_cast<double>(iterations);
+    sample.allocations = static_cast<double>(state.GetAllocationCount()) / static_cast<double>(iterations);
+    sample.bytes       = static_cast<double>(state.GetAllocationBytes()) / static_cast<double>(iterations);
+    return sample;
+}
+
+// Grows the iteration count until a run takes minNanos, the calibration
+// runs double as warmups
+uint64_t CalibrateIterations(const Benchmark& benchmark, double minNanos)
+{
+    uint64_t iterations = 1;
+    while (true) {
+        const double nanos = RunIterations(benchmark, iterations).nanos * static_cast<double>(iterations);
+        if (nanos >= minNanos) {
+            return iterations;
+        }
+        // Aim 20% past the target, growing at most 10x per step
+        const double scale = (nanos > 0) ? std::min(1.2 * minNanos / nanos, 10.0) : 10.0;
+        iterations         = std::max(iterations + 1, static_cast<uint64_t>(static_cast<double>(iterations) * scale));
+    }
+}
+
+} // namespace
+
+bool RegisterBenchmark(const char* name, BenchmarkFunction function)
+{
+    GetBenchmarks().push_back({name, function});
+    return true;
+}
+
+void DoNotOptimize(const void* pValue)
+{
+    // Defined out of line, the compiler can't tell the value isn't read
+    static const void* volatile sSink = nullptr;
+    sSink                             = pValue;
+}
+
+// -------------------------------------------------------------------------------------------------
+// Runner
+// -------------------------------------------------------------------------------------------------
+
+int RunBenchmarks(int argc, char** argv)
+{
+    ppx::Log::Initialize(ppx::LOG_MODE_CONSOLE);
+    PPX_ASSERT_MSG(ppx::Timer::InitializeStaticData() == ppx::TIMER_RESULT_SUCCESS, "timer initialization failed");
+
+    ppx::KnobManager                            knobManager;
+    std::shared_ptr<ppx::KnobFlag<std::string>> pFilter;
+    std::shared_ptr<ppx::KnobFlag<int>>         pMinTimeMs;
+    std::shared_ptr<ppx::KnobFlag<int>>         pRepetitions;
+    std::shared_ptr<ppx::KnobFlag<std::string>> pMetricsFilename;
+    knobManager.InitKnob(&pFilter, "filter", "");
+    pFilter->SetFlagDescription("Only run the benchmarks whose name contains this string.");
+    knobManager.InitKnob(&pMinTimeMs, "min-time-ms", 100);
+    pMinTimeMs->SetFlagDescription("Minimum duration of each repetition, the iteration count is calibrated to reach it.");
+    pMinTimeMs->SetValidator([](int value) { return value >= 1; });
+    knobManager.InitKnob(&pRepetitions, "repetitions", 5);
+    pRepetitions->SetFlagDescription("Number of measured repetitions of each benchmark, after calibration.");
+    pRepetitions->SetValidator([](int value) { return value >= 1; });
+    knobManager.InitKnob(&pMetricsFilename, "metrics-filename", "");
+    pMetricsFilename->SetFlagDescription("Also write a JSON metrics report with <name>_ns_per_op, <name>_allocs_per_op and <name>_bytes_per_op gauges, see tools/metrics_report.py.");
+
+    ppx::CommandLineParser parser;
+    if (ppx::Failed(parser.Parse(argc, const_cast<const char**>(argv)))) {
+        PPX_LOG_ERROR("Unable to parse command line arguments");
+        return EXIT_FAILURE;
+    }
+    if (parser.GetOptions().GetOptionValueOrDefault("help", false)) {
+        PPX_LOG_INFO(knobManager.GetUsageMsg());
+        return EXIT_SUCCESS;
+    }
+    knobManager.UpdateFromFlags(parser.GetOptions());
+
+    ppx::metrics::Manager metrics;
+    const bool            writeMetrics = !pMetricsFilename->GetValue().empty();
+    if (writeMetrics) {
+        metrics.StartRun("cpu_benchmarks");
+    }
+
+    const double minNanos = static_cast<double>(pMinTimeMs->GetValue()) * PPX_TIMER_MILLIS_TO_NANOS;
+    const int    reps     = pRepetitions->GetValue();
+    for (const Benchmark& benchmark : GetBenchmarks()) {
+        if (std::string(benchmark.name).find(pFilter->GetValue()) == std::string::npos) {
+            continue;
+        }
+
+        ppx::metrics::MetricID nanosId       = ppx::metrics::kInvalidMetricID;
+        ppx::metrics::MetricID allocationsId = ppx::metrics::kInvalidMetricID;
+        ppx::metrics::MetricID bytesId       = ppx::metrics::kInvalidMetricID;
+        if (writeMetrics) {
+            const std::string name = benchmark.name;
+            nanosId                = metrics.AddMetric({ppx::metrics::MetricType::GAUGE, name + "_ns_per_op", "ns", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER});
+            allocationsId          = metrics.AddMetric({ppx::metrics::MetricType::GAUGE, name + "_allocs_per_op", "", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER});
+            bytesId                = metrics.AddMetric({ppx::metrics::MetricType::GAUGE, name + "_bytes_per_op", "bytes", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER});
+        }
+
+        const uint64_t      iterations = CalibrateIterations(benchmark, minNanos);
+        std::vector<Sample> samples;
+        for (int i = 0; i < reps; ++i) {
+            samples.push_back(RunIterations(benchmark, iterations));
+            if (writeMetrics) {
+                ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+                data.gauge.seconds            = static_cast<double>(i);
+                data.gauge.value              = samples.back().nanos;
+                metrics.RecordMetricData(nanosId, data);
+                data.gauge.value = samples.back().allocations;
+                metrics.RecordMetricData(allocationsId, data);
+                data.gauge.value = samples.back().bytes;
+                metrics.RecordMetricData(bytesId, data);
+            }
+        }
+
+        // The median repetition is the least disturbed by the rest of the system
+        std::sort(samples.begin(), samples.end(), [](const Sample& a, const Sample& b) { return a.nanos < b.nanos; });
+        const Sample&      median = samples[samples.size() / 2];
+        std::ostringstream ss;
+        ss << std::left << std::setw(40) << benchmark.name << std::right << std::fixed << std::setprecision(1)
+           << std::setw(14) << median.nanos << " ns/op"
+           << std::setw(10) << median.allocations << " allocs/op"
+           << std::setw(14) << median.bytes << " bytes/op"
+           << "  (" << iterations << " iterations x " << reps << ")";
+        PPX_LOG_INFO(ss.str());
+    }
+
+    if (writeMetrics) {
+        metrics.EndRun();
+        metrics.CreateReport(pMetricsFilename->GetValue()).WriteToDisk(/* overwriteExisting= */ true);
+    }
+    return EXIT_SUCCESS;
+}
+
+} // namespace cpu_benchmark
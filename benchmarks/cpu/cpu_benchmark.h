@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARKS_CPU_CPU_BENCHMARK_H
+#define BENCHMARKS_CPU_CPU_BENCHMARK_H
+
+#include <cstdint>
+
+// Minimal microbenchmark harness, with an interface close to Google
+// Benchmark's so benchmarks can move to it if it's ever vendored:
+//
+//   PPX_CPU_BENCHMARK(bitmap_convert)
+//   {
+//       Bitmap src = ...;   // Not measured
+//       Bitmap dst;
+//       while (state.KeepRunning()) {
+//           src.ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, &dst);
+//       }
+//   }
+//
+// Each benchmark reports the time and the heap allocations of one iteration
+// of its loop. Allocations are counted by replacing the global operator new.
+namespace cpu_benchmark {
+
+class State
+{
+public:
+    State(uint64_t iterations);
+
+    // Starts measuring on the first call, returns false once the iterations
+    // are done, which stops measuring
+    bool KeepRunning();
+
+    uint64_t GetIterations() const { return mIterations; }
+    uint64_t GetElapsedNanos() const { return mStopTimestamp - mStartTimestamp; }
+    uint64_t GetAllocationCount() const { return mAllocationCount; }
+    uint64_t GetAllocationBytes() const { return mAllocationBytes; }
+
+private:
+    void Start();
+    void Stop();
+
+private:
+    uint64_t mIterations      = 0;
+    uint64_t mRemaining       = 0;
+    bool     mStarted         = false;
+    uint64_t mStartTimestamp  = 0;
+    uint64_t mStopTimestamp   = 0;
+    uint64_t mAllocationCount = 0; // Made between Start() and Stop()
+    uint64_t mAllocationBytes = 0;
+};
+
+using BenchmarkFunction = void (*)(State& state);
+
+// Called by PPX_CPU_BENCHMARK at static initialization, benchmarks run in
+// the order they're registered
+bool RegisterBenchmark(const char* name, BenchmarkFunction function);
+
+// Keeps the compiler from dropping the computation of an unused result
+void DoNotOptimize(const void* pValue);
+
+// Runs the registered benchmarks, see the --help of cpu_benchmarks
+int RunBenchmarks(int argc, char** argv);
+
+} // namespace cpu_benchmark
+
+#define PPX_CPU_BENCHMARK(NAME)                                                           \
+    static void       NAME(cpu_benchmark::State& state);                                  \
+    static const bool NAME##_registered = cpu_benchmark::RegisterBenchmark(#NAME, &NAME); \
+    static void       NAME(cpu_benchmark::State& state)
+
+#endif // BENCHMARKS_CPU_CPU_BENCHMARK_H
@@ -0,0 +1,238 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "cpu_benchmark.h"
+
+#include "ppx/bitmap.h"
+#include "ppx/command_line_parser.h"
+#include "ppx/geometry.h"
+#include "ppx/knob.h"
+#include "ppx/metrics.h"
+#include "ppx/scene/scene_gltf_loader.h"
+#include "ppx/tri_mesh.h"
+
+#include <climits>
+#include <filesystem>
+
+// CPU hot paths of the framework, measured without a GPU. Run with --help
+// for the options, e.g. `cpu_benchmarks --filter bitmap_`.
+
+using namespace ppx;
+
+static constexpr uint32_t kBitmapSize = 1024;
+
+static std::filesystem::path sAssetsDir;
+
+static Bitmap CreateSourceBitmap(Bitmap::Format format)
+{
+    Bitmap bitmap = Bitmap::Create(kBitmapSize, kBitmapSize, format);
+    PPX_ASSERT_MSG(bitmap.IsOk(), "bitmap creation failed");
+    char* pData = bitmap.GetData();
+    for (uint64_t i = 0; i < bitmap.GetFootprintSize(); ++i) {
+        pData[i] = static_cast<char>(i * 2654435761u >> 24);
+    }
+    return bitmap;
+}
+
+static void ConvertBitmap(cpu_benchmark::State& state, Bitmap::Format srcFormat, Bitmap::Format dstFormat)
+{
+    const Bitmap src = CreateSourceBitmap(srcFormat);
+    Bitmap       dst;
+    while (state.KeepRunning()) {
+        PPX_CHECKED_CALL(src.ConvertTo(dstFormat, &dst));
+        cpu_benchmark::DoNotOptimize(dst.GetData());
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Bitmap
+// -------------------------------------------------------------------------------------------------
+
+PPX_CPU_BENCHMARK(bitmap_convert_rgba8_to_rgba32f)
+{
+    ConvertBitmap(state, Bitmap::FORMAT_RGBA_UINT8, Bitmap::FORMAT_RGBA_FLOAT);
+}
+
+PPX_CPU_BENCHMARK(bitmap_convert_rgba32f_to_rgba8)
+{
+    ConvertBitmap(state, Bitmap::FORMAT_RGBA_FLOAT, Bitmap::FORMAT_RGBA_UINT8);
+}
+
+PPX_CPU_BENCHMARK(bitmap_convert_rgb8_to_rgba8)
+{
+    ConvertBitmap(state, Bitmap::FORMAT_RGB_UINT8, Bitmap::FORMAT_RGBA_UINT8);
+}
+
+// -------------------------------------------------------------------------------------------------
+// TriMesh and Geometry
+// -------------------------------------------------------------------------------------------------
+
+static const TriMeshOptions kMeshOptions = TriMeshOptions().Indices().Normals().TexCoords().Tangents();
+
+PPX_CPU_BENCHMARK(tri_mesh_create_sphere)
+{
+    while (state.KeepRunning()) {
+        TriMesh mesh = TriMesh::CreateSphere(1.0f, 64, 32, kMeshOptions);
+        cpu_benchmark::DoNotOptimize(&mesh);
+    }
+}
+
+PPX_CPU_BENCHMARK(tri_mesh_create_plane)
+{
+    while (state.KeepRunning()) {
+        TriMesh mesh = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1.0f), 128, 128, kMeshOptions);
+        cpu_benchmark::DoNotOptimize(&mesh);
+    }
+}
+
+PPX_CPU_BENCHMARK(geometry_create_interleaved_u32)
+{
+    const TriMesh            mesh       = TriMesh::CreateSphere(1.0f, 64, 32, kMeshOptions);
+    const GeometryCreateInfo createInfo = GeometryCreateInfo::InterleavedU32().AddNormal().AddTexCoord().AddTangent();
+    while (state.KeepRunning()) {
+        Geometry geometry;
+        PPX_CHECKED_CALL(Geometry::Create(createInfo, mesh, &geometry));
+        cpu_benchmark::DoNotOptimize(&geometry);
+    }
+}
+
+PPX_CPU_BENCHMARK(geometry_create_planar_u16)
+{
+    const TriMesh            mesh       = TriMesh::CreateSphere(1.0f, 64, 32, kMeshOptions);
+    const GeometryCreateInfo createInfo = GeometryCreateInfo::PlanarU16().AddNormal().AddTexCoord().AddTangent();
+    while (state.KeepRunning()) {
+        Geometry geometry;
+        PPX_CHECKED_CALL(Geometry::Create(createInfo, mesh, &geometry));
+        cpu_benchmark::DoNotOptimize(&geometry);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Metrics
+// -------------------------------------------------------------------------------------------------
+
+static void RecordMetric(cpu_benchmark::State& state, metrics::MetricType type, metrics::GaugeMode gaugeMode)
+{
+    metrics::Manager manager;
+    manager.SetDefaultGaugeMode(gaugeMode);
+    manager.StartRun("benchmark");
+    const metrics::MetricID id = manager.AddMetric({type, "metric", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER});
+
+    metrics::MetricData data = {type};
+    uint64_t            i    = 0;
+    while (state.KeepRunning()) {
+        if (type == metrics::MetricType::GAUGE) {
+            data.gauge.seconds = static_cast<double>(i) / 60.0;
+            data.gauge.value   = static_cast<double>(i % 17);
+        }
+        else {
+            data.counter.increment = 1;
+        }
+        manager.RecordMetricData(id, data);
+        ++i;
+    }
+    manager.EndRun();
+}
+
+PPX_CPU_BENCHMARK(metrics_record_gauge_time_series)
+{
+    RecordMetric(state, metrics::MetricType::GAUGE, metrics::GaugeMode::TIME_SERIES);
+}
+
+PPX_CPU_BENCHMARK(metrics_record_gauge_sketch)
+{
+    RecordMetric(state, metrics::MetricType::GAUGE, metrics::GaugeMode::SKETCH);
+}
+
+PPX_CPU_BENCHMARK(metrics_record_counter)
+{
+    RecordMetric(state, metrics::MetricType::COUNTER, metrics::GaugeMode::TIME_SERIES);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Command line and knobs
+// -------------------------------------------------------------------------------------------------
+
+// clang-format off
+static const char* const kArgs[] = {
+    "app",
+    "--resolution", "1920x1080",
+    "--frame-count", "100",
+    "--enable-metrics",
+    "--metrics-filename", "report.json",
+    "--extra-assets-path", "a",
+    "--extra-assets-path", "b",
+    "--scale", "0.75",
+    "--mode", "fast",
+    "--no-vsync",
+};
+// clang-format on
+
+PPX_CPU_BENCHMARK(command_line_parse)
+{
+    while (state.KeepRunning()) {
+        CommandLineParser parser;
+        PPX_CHECKED_CALL(parser.Parse(static_cast<int>(std::size(kArgs)), const_cast<const char**>(kArgs)));
+        cpu_benchmark::DoNotOptimize(&parser);
+    }
+}
+
+PPX_CPU_BENCHMARK(knob_update_from_flags)
+{
+    KnobManager                                         knobManager;
+    std::shared_ptr<KnobFlag<std::pair<int, int>>>      pResolution;
+    std::shared_ptr<KnobFlag<int>>                      pFrameCount;
+    std::shared_ptr<KnobFlag<bool>>                     pEnableMetrics;
+    std::shared_ptr<KnobFlag<std::string>>              pMetricsFilename;
+    std::shared_ptr<KnobFlag<std::vector<std::string>>> pAssetsPaths;
+    std::shared_ptr<KnobFlag<float>>                    pScale;
+    std::shared_ptr<KnobDropdown<std::string>>          pMode;
+    std::shared_ptr<KnobFlag<bool>>                     pVsync;
+    const std::vector<std::string>                      modes = {"slow", "fast"};
+    knobManager.InitKnob(&pResolution, "resolution", std::make_pair(0, 0));
+    knobManager.InitKnob(&pFrameCount, "frame-count", 0, 0, INT_MAX);
+    knobManager.InitKnob(&pEnableMetrics, "enable-metrics", false);
+    knobManager.InitKnob(&pMetricsFilename, "metrics-filename", "");
+    knobManager.InitKnob(&pAssetsPaths, "extra-assets-path", std::vector<std::string>{});
+    knobManager.InitKnob(&pScale, "scale", 1.0f, 0.0f, 1.0f);
+    knobManager.InitKnob(&pMode, "mode", 0, modes);
+    knobManager.InitKnob(&pVsync, "vsync", true);
+
+    CommandLineParser parser;
+    PPX_CHECKED_CALL(parser.Parse(static_cast<int>(std::size(kArgs)), const_cast<const char**>(kArgs)));
+    const CliOptions& options = parser.GetOptions();
+    while (state.KeepRunning()) {
+        knobManager.UpdateFromFlags(options);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// glTF
+// -------------------------------------------------------------------------------------------------
+
+PPX_CPU_BENCHMARK(gltf_parse)
+{
+    const std::filesystem::path path = sAssetsDir / "basic/models/altimeter/altimeter.gltf";
+    while (state.KeepRunning()) {
+        scene::GltfLoader* pLoader = nullptr;
+        PPX_CHECKED_CALL(scene::GltfLoader::Create(path, nullptr, &pLoader));
+        delete pLoader;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    sAssetsDir = std::filesystem::absolute(argv[0]).remove_filename() / RELATIVE_PATH_TO_PROJECT_ROOT / "assets";
+    return cpu_benchmark::RunBenchmarks(argc, argv);
+}
@@ -0,0 +1,250 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+struct Resolution
+{
+    const char* name;
+    uint32_t    width;
+    uint32_t    height;
+};
+
+static const Resolution kResolutions[] = {
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"2160p", 3840, 2160},
+};
+
+// Measures the GPU time of grfx::DepthPyramid::Build() for a D32_FLOAT depth
+// image at common resolutions. Each resolution is measured for --samples
+// frames after a warmup frame, each frame building the pyramid --builds times
+// back to back, and recorded as a "build_<resolution>" gauge in microseconds
+// per build. The time includes the depth image and pyramid transitions a
+// renderer pays for around every build.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct Case
+    {
+        Resolution            resolution = {};
+        std::string           name       = "";
+        metrics::MetricID     metricId   = metrics::kInvalidMetricID;
+        grfx::ImagePtr        depthImage;
+        grfx::DepthPyramidPtr pyramid;
+        double                totalUs     = 0.0; // Of the samples since the last log
+        uint32_t              sampleCount = 0;
+    };
+
+    void SetupCases();
+    void FinishSample(Case& c, uint64_t ticks, uint32_t buildCount);
+
+private:
+    std::shared_ptr<KnobFlag<int>> pBuilds;
+    std::shared_ptr<KnobFlag<int>> pSamples;
+    std::shared_ptr<KnobFlag<int>> pPasses;
+
+    grfx::CommandBufferPtr mCommandBuffer;
+    grfx::FencePtr         mFence;
+    grfx::QueryPtr         mTimestampQuery;
+
+    std::vector<Case> mCases;
+    uint32_t          mCaseIndex   = 0;
+    uint32_t          mFrameInCase = 0; // The first frame of a case is a warmup
+    uint32_t          mPass        = 0; // Over all cases
+    uint32_t          mBuildCount  = 0; // Of the submitted frame, 0 if nothing is in flight
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pBuilds, "builds", 16);
+    pBuilds->SetFlagDescription("Number of pyramid builds per frame, averaged into each sample.");
+    pBuilds->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each resolution is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all resolutions are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "depth_pyramid";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    for (const Resolution& resolution : kResolutions) {
+        Case c       = {};
+        c.resolution = resolution;
+        c.name       = std::string("build_") + resolution.name;
+        mCases.push_back(c);
+    }
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    grfx::ShaderModulePtr CS;
+    PPX_CHECKED_CALL(CreateShader("basic/shaders", "DepthPyramid.cs", &CS));
+
+    // The depth content doesn't change the work done, so it's left undefined
+    for (Case& c : mCases) {
+        grfx::ImageCreateInfo imageCreateInfo = grfx::ImageCreateInfo::DepthStencilTarget(c.resolution.width, c.resolution.height, grfx::FORMAT_D32_FLOAT);
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&imageCreateInfo, &c.depthImage));
+
+        grfx::DepthPyramidCreateInfo createInfo = {};
+        createInfo.width                        = c.resolution.width;
+        createInfo.height                       = c.resolution.height;
+        createInfo.maxDepthImages               = 1;
+        createInfo.CS                           = {CS.Get(), "csmain"};
+        PPX_CHECKED_CALL(GetDevice()->CreateDepthPyramid(&createInfo, &c.pyramid));
+    }
+
+    GetDevice()->DestroyShaderModule(CS);
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    PPX_LOG_INFO("Measuring depth pyramid builds at " << mCases.size() << " resolutions");
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name, "us", metrics::MetricInterpretation::LOWER_IS_BETTER};
+        c.metricId                       = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.metricId != metrics::kInvalidMetricID, "Failed to add metric " << c.name);
+    }
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks, uint32_t buildCount)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double us = static_cast<double>(ticks) * 1e6 / static_cast<double>(frequency) / buildCount;
+    c.totalUs += us;
+    ++c.sampleCount;
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = us;
+    RecordMetricData(c.metricId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        PPX_LOG_INFO(c.name << " (" << c.pyramid->GetLevelCount() << " levels): " << (c.totalUs / c.sampleCount) << " us");
+        c.totalUs     = 0.0;
+        c.sampleCount = 0;
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mBuildCount > 0) {
+        uint64_t timestamps[2] = {0};
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        if (mFrameInCase > 0) {
+            FinishSample(mCases[mCaseIndex], timestamps[1] - timestamps[0], mBuildCount);
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    Case& c     = mCases[mCaseIndex];
+    mBuildCount = static_cast<uint32_t>(pBuilds->GetValue());
+
+    mTimestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        for (uint32_t i = 0; i < mBuildCount; ++i) {
+            PPX_CHECKED_CALL(c.pyramid->Build(mCommandBuffer, c.depthImage, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE));
+        }
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+}
+
+SETUP_APPLICATION(ProjApp)
@@ -12,15 +12,21 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <array>
 #include <filesystem>
+#include <iomanip>
+#include <sstream>
+#include <thread>
 
 #include "ppx/config.h"
 #include "ppx/math_config.h"
 #include "ppx/graphics_util.h"
 #include "ppx/grfx/grfx_config.h"
 #include "ppx/grfx/grfx_enums.h"
+#include "ppx/grfx/grfx_util.h"
 #include "ppx/log.h"
 #include "ppx/ppx.h"
+#include "ppx/timer.h"
 #include "ppx/csv_file_log.h"
 
 using namespace ppx;
@@ -31,6 +37,30 @@ const grfx::Api kApi = grfx::API_DX_12_0;
 const grfx::Api kApi = grfx::API_VK_1_1;
 #endif
 
+// State changed between consecutive draws with --state-change, every draw
+// alternates between two objects so that no bind is redundant
+enum StateChange
+{
+    STATE_CHANGE_NONE = 0,
+    STATE_CHANGE_DESCRIPTOR_SETS,
+    STATE_CHANGE_DESCRIPTOR_UPDATES, // Writes a distinct set before every bind
+    STATE_CHANGE_PUSH_CONSTANTS,
+    STATE_CHANGE_PUSH_DESCRIPTORS,
+    STATE_CHANGE_PIPELINES,
+    STATE_CHANGE_VERTEX_BUFFERS,
+    STATE_CHANGE_COUNT,
+};
+
+const char* kStateChangeNames[STATE_CHANGE_COUNT] = {
+    "none",
+    "descriptor-sets",
+    "descriptor-updates",
+    "push-constants",
+    "push-descriptors",
+    "pipelines",
+    "vertex-buffers",
+};
+
 class ProjApp
     : public ppx::Application
 {
@@ -42,6 +72,13 @@ public:
     void SaveResultsToFile();
 
 private:
+    void SetupStateChangeModes(const std::string& stateChange);
+    void SetupStateChange(const grfx::GraphicsPipelineCreateInfo2& baseCreateInfo);
+    void RecordDraws(grfx::CommandBuffer* pCmd, uint32_t firstTriangle, uint32_t triangleCount);
+    void RecordStateChangeDraws(grfx::CommandBuffer* pCmd, uint32_t firstTriangle, uint32_t triangleCount);
+    void SaveStateChangeCosts();
+    void RecordSecondaryCommandBuffers(const grfx::RenderPass* pRenderPass);
+
     struct PerFrame
     {
         ppx::grfx::CommandBufferPtr cmd;
@@ -49,7 +86,9 @@ private:
         ppx::grfx::FencePtr         imageAcquiredFence;
         ppx::grfx::SemaphorePtr     renderCompleteSemaphore;
         ppx::grfx::FencePtr         renderCompleteFence;
-        ppx::grfx::QueryPtr         timestampQuery;
+
+        // One secondary command buffer per recording thread
+        std::vector<ppx::grfx::CommandBufferPtr> secondaryCmds;
     };
 
     std::vector<PerFrame>           mPerFrame;
@@ -63,12 +102,36 @@ private:
     grfx::VertexBinding             mVertexBinding;
     uint2                           mRenderTargetSize;
 
+    // --state-change objects, the second of each pair is only bound by the
+    // mode changing it
+    ppx::grfx::ShaderModulePtr                    mStateChangeVS;
+    ppx::grfx::ShaderModulePtr                    mStateChangePS;
+    ppx::grfx::DescriptorPoolPtr                  mDescriptorPool;
+    ppx::grfx::DescriptorSetLayoutPtr             mSetLayout;
+    ppx::grfx::DescriptorSetLayoutPtr             mPushSetLayout;
+    ppx::grfx::PipelineInterfacePtr               mStateChangeInterface;
+    ppx::grfx::PipelineInterfacePtr               mPushInterface; // Null without push descriptors support
+    std::array<ppx::grfx::GraphicsPipelinePtr, 2> mStateChangePipelines;
+    ppx::grfx::GraphicsPipelinePtr                mPushPipeline;
+    std::array<ppx::grfx::BufferPtr, 2>           mUniformBuffers;
+    std::array<ppx::grfx::DescriptorSetPtr, 2>    mDescriptorSets;
+    std::array<ppx::grfx::BufferPtr, 2>           mVertexBuffers;
+
+    // One set per draw for descriptor-updates, so that no set is written
+    // twice in a frame or by two recording threads
+    std::vector<ppx::grfx::DescriptorPoolPtr> mUpdatePools;
+    std::vector<ppx::grfx::DescriptorSetPtr>  mUpdateSets;
+
     // Options
-    uint32_t mNumTriangles;
-    bool     mUseInstancedDraw;
+    uint32_t                 mNumTriangles;
+    bool                     mUseInstancedDraw;
+    uint32_t                 mRecordThreadCount;
+    std::vector<StateChange> mStateChangeModes; // Empty without --state-change
+    uint32_t                 mFramesPerMode;
+    std::string              mStateChangeFileName;
 
     // Stats
-    uint64_t                 mGpuWorkDuration    = 0;
+    double                   mCpuRecordTime      = 0;
     grfx::PipelineStatistics mPipelineStatistics = {};
     std::string              mCSVFileName;
     struct PerFrameRegister
@@ -76,8 +139,26 @@ private:
         uint64_t frameNumber;
         float    gpuWorkDuration;
         float    cpuFrameTime;
+        float    cpuRecordTime;
+        int32_t  stateChange; // Of cpuRecordTime, -1 without --state-change
     };
     std::deque<PerFrameRegister> mFrameRegisters;
+
+    // The GPU time of a frame is read back during the next one, so the mode
+    // of the previous frame is kept to attribute it. The first frame of each
+    // mode isn't measured when cycling through several.
+    struct StateChangeCost
+    {
+        double   cpuRecordMs = 0;
+        double   gpuMs       = 0;
+        uint64_t cpuFrames   = 0;
+        uint64_t gpuFrames   = 0;
+    };
+    std::array<StateChangeCost, STATE_CHANGE_COUNT> mStateChangeCosts = {};
+    StateChange                                     mStateChange      = STATE_CHANGE_NONE; // Of the frame being recorded
+    bool                                            mMeasured         = false;
+    StateChange                                     mPrevStateChange  = STATE_CHANGE_NONE;
+    bool                                            mPrevMeasured     = false;
 };
 
 void ProjApp::Config(ppx::ApplicationSettings& settings)
@@ -87,6 +168,11 @@ void ProjApp::Config(ppx::ApplicationSettings& settings)
     settings.grfx.api                       = kApi;
     settings.grfx.device.graphicsQueueCount = 1;
     settings.grfx.numFramesInFlight         = 1;
+    settings.grfx.gpuProfiler.enable        = true;
+
+    // Back descriptor sets with a descriptor buffer when supported, to
+    // compare descriptor backends with --state-change
+    settings.grfx.device.descriptorBuffers = GetExtraOptions().GetExtraOptionValueOrDefault<bool>("descriptor-buffers", false);
 }
 
 void ProjApp::SaveResultsToFile()
@@ -95,8 +181,56 @@ void ProjApp::SaveResultsToFile()
     for (const auto& row : mFrameRegisters) {
         fileLogger.LogField(row.frameNumber);
         fileLogger.LogField(row.gpuWorkDuration);
-        fileLogger.LastField(row.cpuFrameTime);
+        fileLogger.LogField(row.cpuFrameTime);
+        if (row.stateChange < 0) {
+            fileLogger.LastField(row.cpuRecordTime);
+            continue;
+        }
+        fileLogger.LogField(row.cpuRecordTime);
+        fileLogger.LastField(kStateChangeNames[row.stateChange]);
     }
+
+    if (!mStateChangeModes.empty()) {
+        SaveStateChangeCosts();
+    }
+}
+
+void ProjApp::SaveStateChangeCosts()
+{
+    // Every draw of a mode changes its state once, so the cost of one change
+    // is the time per draw over the "none" mode's
+    auto nsPerDraw = [this](double ms, uint64_t frames) {
+        return (frames > 0) ? (ms * 1000000.0) / (static_cast<double>(frames) * mNumTriangles) : 0.0;
+    };
+    const StateChangeCost& none      = mStateChangeCosts[STATE_CHANGE_NONE];
+    const double           noneCpuNs = nsPerDraw(none.cpuRecordMs, none.cpuFrames);
+    const double           noneGpuNs = nsPerDraw(none.gpuMs, none.gpuFrames);
+    const char*            pApiName  = grfx::ToString(kApi);
+    const char*            pBackend  = GetDevice()->DescriptorBuffersEnabled() ? "descriptor-buffers" : "descriptor-sets";
+
+    CSVFileLog fileLogger{std::filesystem::path(mStateChangeFileName)};
+    fileLogger.LastField("api,descriptor_backend,state_change,cpu_ns_per_draw,gpu_ns_per_draw,cpu_ns_per_op,gpu_ns_per_op");
+
+    std::stringstream ss;
+    ss << "State change cost per draw (" << pApiName << ", " << pBackend << ", ns):\n";
+    ss << std::left << std::setw(20) << "  state change" << std::right << std::setw(10) << "cpu" << std::setw(10) << "gpu" << std::setw(12) << "cpu/op" << std::setw(12) << "gpu/op" << "\n";
+    for (StateChange mode : mStateChangeModes) {
+        const StateChangeCost& cost  = mStateChangeCosts[mode];
+        const double           cpuNs = nsPerDraw(cost.cpuRecordMs, cost.cpuFrames);
+        const double           gpuNs = nsPerDraw(cost.gpuMs, cost.gpuFrames);
+
+        fileLogger.LogField(pApiName);
+        fileLogger.LogField(pBackend);
+        fileLogger.LogField(kStateChangeNames[mode]);
+        fileLogger.LogField(cpuNs);
+        fileLogger.LogField(gpuNs);
+        fileLogger.LogField(cpuNs - noneCpuNs);
+        fileLogger.LastField(gpuNs - noneGpuNs);
+
+        ss << std::left << std::setw(20) << ("  " + std::string(kStateChangeNames[mode])) << std::right << std::fixed << std::setprecision(1);
+        ss << std::setw(10) << cpuNs << std::setw(10) << gpuNs << std::setw(12) << (cpuNs - noneCpuNs) << std::setw(12) << (gpuNs - noneGpuNs) << "\n";
+    }
+    PPX_LOG_INFO(ss.str());
 }
 
 void ProjApp::Setup()
@@ -113,6 +247,14 @@ void ProjApp::Setup()
     // Whether to make an instanced call for all triangles or use separate draw calls.
     mUseInstancedDraw = cl_options.GetExtraOptionValueOrDefault<bool>("instanced-draw", false);
 
+    // Number of threads recording the draw calls into secondary command buffers.
+    // Zero records all draw calls directly into the primary command buffer.
+    mRecordThreadCount = cl_options.GetExtraOptionValueOrDefault<uint32_t>("record-thread-count", 0);
+    if (mRecordThreadCount > mNumTriangles) {
+        mRecordThreadCount = mNumTriangles;
+        PPX_LOG_WARN("Number of recording threads cannot exceed the number of triangles, defaulting to: " + std::to_string(mRecordThreadCount));
+    }
+
     // Name of the CSV output file
     mCSVFileName = cl_options.GetExtraOptionValueOrDefault<std::string>("stats-file", "stats.csv");
     if (mCSVFileName.empty()) {
@@ -120,12 +262,37 @@ void ProjApp::Setup()
         PPX_LOG_WARN("Invalid name for CSV log file, defaulting to: " + mCSVFileName);
     }
 
+    // State changed between every draw, one of kStateChangeNames alternated
+    // with "none" every frames-per-mode frames, or "all" of them in turn.
+    // The cost per change is written to state-change-file at exit.
+    SetupStateChangeModes(cl_options.GetExtraOptionValueOrDefault<std::string>("state-change", ""));
+    mFramesPerMode = cl_options.GetExtraOptionValueOrDefault<uint32_t>("frames-per-mode", 100);
+    if (mFramesPerMode == 0) {
+        mFramesPerMode = 100;
+        PPX_LOG_WARN("Number of frames per mode must be greater than zero, defaulting to: " + std::to_string(mFramesPerMode));
+    }
+    mStateChangeFileName = cl_options.GetExtraOptionValueOrDefault<std::string>("state-change-file", "state_change.csv");
+    if (mStateChangeFileName.empty()) {
+        mStateChangeFileName = "state_change.csv";
+        PPX_LOG_WARN("Invalid name for state change CSV file, defaulting to: " + mStateChangeFileName);
+    }
+    if (GetDevice()->DescriptorBuffersEnabled()) {
+        PPX_LOG_INFO("Descriptor sets are backed by a descriptor buffer");
+    }
+
     // Per frame data
     {
         PerFrame frame = {};
 
         PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&frame.cmd));
 
+        // Every secondary command buffer gets its own pool so that they
+        // can be recorded concurrently.
+        frame.secondaryCmds.resize(mRecordThreadCount);
+        for (auto& secondaryCmd : frame.secondaryCmds) {
+            PPX_CHECKED_CALL(GetGraphicsQueue()->CreateSecondaryCommandBuffer(&secondaryCmd, 0, 0));
+        }
+
         grfx::SemaphoreCreateInfo semaCreateInfo = {};
         PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.imageAcquiredSemaphore));
 
@@ -137,11 +304,6 @@ void ProjApp::Setup()
         fenceCreateInfo = {true}; // Create signaled
         PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.renderCompleteFence));
 
-        grfx::QueryCreateInfo queryCreateInfo = {};
-        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
-        queryCreateInfo.count                 = 2;
-        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &frame.timestampQuery));
-
         mPerFrame.push_back(frame);
     }
 
@@ -171,12 +333,17 @@ void ProjApp::Setup()
         bufferCreateInfo.usageFlags.bits.vertexBuffer = true;
         bufferCreateInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
 
-        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mVertexBuffer));
+        // --state-change vertex-buffers alternates between two copies
+        const uint32_t bufferCount = mStateChangeModes.empty() ? 1 : 2;
+        for (uint32_t i = 0; i < bufferCount; ++i) {
+            PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mVertexBuffers[i]));
 
-        void* pAddr = nullptr;
-        PPX_CHECKED_CALL(mVertexBuffer->MapMemory(0, &pAddr));
-        memcpy(pAddr, vertexData.data(), dataSize);
-        mVertexBuffer->UnmapMemory();
+            void* pAddr = nullptr;
+            PPX_CHECKED_CALL(mVertexBuffers[i]->MapMemory(0, &pAddr));
+            memcpy(pAddr, vertexData.data(), dataSize);
+            mVertexBuffers[i]->UnmapMemory();
+        }
+        mVertexBuffer = mVertexBuffers[0];
     }
 
     // Pipeline
@@ -216,6 +383,217 @@ void ProjApp::Setup()
         gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
         gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
         PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPipeline));
+
+        if (!mStateChangeModes.empty()) {
+            SetupStateChange(gpCreateInfo);
+        }
+    }
+}
+
+void ProjApp::SetupStateChangeModes(const std::string& stateChange)
+{
+    if (stateChange.empty()) {
+        return;
+    }
+
+    if (stateChange == "all") {
+        for (uint32_t i = 0; i < STATE_CHANGE_COUNT; ++i) {
+            mStateChangeModes.push_back(static_cast<StateChange>(i));
+        }
+    }
+    else {
+        auto it = std::find(std::begin(kStateChangeNames), std::end(kStateChangeNames), stateChange);
+        if (it == std::end(kStateChangeNames)) {
+            PPX_LOG_WARN("Unknown state change: " << stateChange << ", state changes are disabled");
+            return;
+        }
+        // Alternated with the baseline the cost is measured against
+        StateChange mode = static_cast<StateChange>(it - std::begin(kStateChangeNames));
+        mStateChangeModes.push_back(STATE_CHANGE_NONE);
+        if (mode != STATE_CHANGE_NONE) {
+            mStateChangeModes.push_back(mode);
+        }
+    }
+
+    auto pushDescriptors = std::find(mStateChangeModes.begin(), mStateChangeModes.end(), STATE_CHANGE_PUSH_DESCRIPTORS);
+    if ((pushDescriptors != mStateChangeModes.end()) && !GetDevice()->PushDescriptorsSupported()) {
+        PPX_LOG_WARN("Push descriptors are not supported by the device, skipping state change: " << kStateChangeNames[STATE_CHANGE_PUSH_DESCRIPTORS]);
+        mStateChangeModes.erase(pushDescriptors);
+    }
+
+    if (mUseInstancedDraw) {
+        mUseInstancedDraw = false;
+        PPX_LOG_WARN("State changes require separate draw calls, instanced draw is disabled");
+    }
+}
+
+void ProjApp::SetupStateChange(const grfx::GraphicsPipelineCreateInfo2& baseCreateInfo)
+{
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", "PassThroughPosStateChange.vs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mStateChangeVS));
+
+    bytecode = LoadShader("benchmarks/shaders", "PassThroughPosStateChange.ps");
+    PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mStateChangePS));
+
+    // Uniform buffers holding a zero offset
+    for (grfx::BufferPtr& buffer : mUniformBuffers) {
+        grfx::BufferCreateInfo bufferCreateInfo        = {};
+        bufferCreateInfo.size                          = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+        bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+        bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &buffer));
+
+        void* pAddr = nullptr;
+        PPX_CHECKED_CALL(buffer->MapMemory(0, &pAddr));
+        memset(pAddr, 0, PPX_MINIMUM_UNIFORM_BUFFER_SIZE);
+        buffer->UnmapMemory();
+    }
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.uniformBuffer                  = static_cast<uint32_t>(mDescriptorSets.size());
+    PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(0, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER));
+    PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout));
+
+    for (size_t i = 0; i < mDescriptorSets.size(); ++i) {
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &mDescriptorSets[i]));
+        PPX_CHECKED_CALL(mDescriptorSets[i]->UpdateUniformBuffer(0, 0, mUniformBuffers[i]));
+    }
+
+    if (std::find(mStateChangeModes.begin(), mStateChangeModes.end(), STATE_CHANGE_DESCRIPTOR_UPDATES) != mStateChangeModes.end()) {
+        mUpdateSets.resize(mNumTriangles);
+        for (uint32_t i = 0; i < mNumTriangles; ++i) {
+            if ((i % PPX_MAX_SETS_PER_POOL) == 0) {
+                poolCreateInfo.uniformBuffer = std::min<uint32_t>(mNumTriangles - i, PPX_MAX_SETS_PER_POOL);
+                mUpdatePools.emplace_back();
+                PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mUpdatePools.back()));
+            }
+            PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mUpdatePools.back(), mSetLayout, &mUpdateSets[i]));
+        }
+    }
+
+    // The push constants hold a second offset at b1
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = 4;
+    piCreateInfo.pushConstants.binding             = 1;
+    piCreateInfo.pushConstants.set                 = 0;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mStateChangeInterface));
+
+    // Two pipelines that only differ by their blending, which can't be
+    // switched without a new pipeline object
+    grfx::GraphicsPipelineCreateInfo2 gpCreateInfo = baseCreateInfo;
+    gpCreateInfo.VS                                = {mStateChangeVS.Get(), "vsmain"};
+    gpCreateInfo.PS                                = {mStateChangePS.Get(), "psmain"};
+    gpCreateInfo.pPipelineInterface                = mStateChangeInterface;
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mStateChangePipelines[0]));
+    gpCreateInfo.blendModes[0] = grfx::BLEND_MODE_ADDITIVE;
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mStateChangePipelines[1]));
+
+    if (!GetDevice()->PushDescriptorsSupported()) {
+        return;
+    }
+
+    layoutCreateInfo.flags.bits.pushable = true;
+    PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mPushSetLayout));
+
+    piCreateInfo.sets[0].pLayout = mPushSetLayout;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPushInterface));
+
+    gpCreateInfo.blendModes[0]      = grfx::BLEND_MODE_NONE;
+    gpCreateInfo.pPipelineInterface = mPushInterface;
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPushPipeline));
+}
+
+void ProjApp::RecordDraws(grfx::CommandBuffer* pCmd, uint32_t firstTriangle, uint32_t triangleCount)
+{
+    pCmd->SetScissors(1, &mScissorRect);
+    pCmd->SetViewports(1, &mViewport);
+    if (!mStateChangeModes.empty()) {
+        RecordStateChangeDraws(pCmd, firstTriangle, triangleCount);
+        return;
+    }
+    pCmd->BindGraphicsPipeline(mPipeline);
+    pCmd->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
+    if (mUseInstancedDraw) {
+        pCmd->Draw(3, triangleCount, 0, firstTriangle);
+    }
+    else {
+        for (uint32_t i = 0; i < triangleCount; ++i) {
+            pCmd->Draw(3, 1, 0, 0);
+        }
+    }
+}
+
+void ProjApp::RecordStateChangeDraws(grfx::CommandBuffer* pCmd, uint32_t firstTriangle, uint32_t triangleCount)
+{
+    const float kOffset[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+    // Initial state, every draw then switches to the other object of the pair
+    const bool                     push       = (mStateChange == STATE_CHANGE_PUSH_DESCRIPTORS);
+    const grfx::PipelineInterface* pInterface = push ? mPushInterface.Get() : mStateChangeInterface.Get();
+    pCmd->BindGraphicsPipeline(push ? mPushPipeline : mStateChangePipelines[0]);
+    pCmd->BindVertexBuffers(1, &mVertexBuffers[0], &mVertexBinding.GetStride());
+    if (push) {
+        pCmd->PushGraphicsUniformBuffer(pInterface, 0, 0, 0, mUniformBuffers[0]);
+    }
+    else {
+        pCmd->BindGraphicsDescriptorSets(pInterface, 1, &mDescriptorSets[0]);
+    }
+    pCmd->PushGraphicsConstants(pInterface, 4, kOffset);
+
+    for (uint32_t i = 0; i < triangleCount; ++i) {
+        const uint32_t n = (i + 1) % 2;
+        switch (mStateChange) {
+            case STATE_CHANGE_DESCRIPTOR_SETS: pCmd->BindGraphicsDescriptorSets(pInterface, 1, &mDescriptorSets[n]); break;
+            case STATE_CHANGE_DESCRIPTOR_UPDATES: {
+                grfx::DescriptorSet* pSet = mUpdateSets[firstTriangle + i];
+                PPX_CHECKED_CALL(pSet->UpdateUniformBuffer(0, 0, mUniformBuffers[n]));
+                pCmd->BindGraphicsDescriptorSets(pInterface, 1, &pSet);
+            } break;
+            case STATE_CHANGE_PUSH_CONSTANTS: pCmd->PushGraphicsConstants(pInterface, 4, kOffset); break;
+            case STATE_CHANGE_PUSH_DESCRIPTORS: pCmd->PushGraphicsUniformBuffer(pInterface, 0, 0, 0, mUniformBuffers[n]); break;
+            case STATE_CHANGE_PIPELINES: pCmd->BindGraphicsPipeline(mStateChangePipelines[n]); break;
+            case STATE_CHANGE_VERTEX_BUFFERS: pCmd->BindVertexBuffers(1, &mVertexBuffers[n], &mVertexBinding.GetStride()); break;
+            default: break;
+        }
+        pCmd->Draw(3, 1, 0, 0);
+    }
+}
+
+void ProjApp::RecordSecondaryCommandBuffers(const grfx::RenderPass* pRenderPass)
+{
+    PerFrame& frame = mPerFrame[0];
+
+    auto recordRange = [this, &frame, pRenderPass](uint32_t threadIndex) {
+        uint32_t first = (mNumTriangles * threadIndex) / mRecordThreadCount;
+        uint32_t last  = (mNumTriangles * (threadIndex + 1)) / mRecordThreadCount;
+
+        grfx::CommandBufferInheritanceInfo inheritanceInfo = {};
+        inheritanceInfo.pRenderPass                        = pRenderPass;
+
+        grfx::CommandBuffer* pCmd = frame.secondaryCmds[threadIndex];
+        PPX_CHECKED_CALL(pCmd->BeginSecondary(&inheritanceInfo));
+        RecordDraws(pCmd, first, last - first);
+        PPX_CHECKED_CALL(pCmd->End());
+    };
+
+    // The calling thread records the first range
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < mRecordThreadCount; ++i) {
+        threads.emplace_back(recordRange, i);
+    }
+    recordRange(0);
+    for (auto& thread : threads) {
+        thread.join();
     }
 }
 
@@ -234,14 +612,14 @@ void ProjApp::Render()
     // Wait for and reset image acquired fence
     PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
 
-    // Read query results
-    if (GetFrameCount() > 0) {
-        uint64_t data[2] = {0};
-        PPX_CHECKED_CALL(frame.timestampQuery->GetData(data, 2 * sizeof(uint64_t)));
-        mGpuWorkDuration = data[1] - data[0];
+    // Read the previous frame's GPU scopes, the fence wait above made them available
+    GetGpuProfiler()->BeginFrame(0);
+
+    if (!mStateChangeModes.empty()) {
+        const uint64_t frameCount = GetFrameCount();
+        mStateChange              = mStateChangeModes[(frameCount / mFramesPerMode) % mStateChangeModes.size()];
+        mMeasured                 = (mStateChangeModes.size() == 1) || ((frameCount % mFramesPerMode) != 0);
     }
-    // Reset queries
-    frame.timestampQuery->Reset(0, 2);
 
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
@@ -253,25 +631,36 @@ void ProjApp::Render()
         frame.cmd->SetViewports(renderPass->GetViewport());
 
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
-        frame.cmd->BeginRenderPass(renderPass);
-        {
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-            frame.cmd->SetScissors(1, &mScissorRect);
-            frame.cmd->SetViewports(1, &mViewport);
-            frame.cmd->BindGraphicsPipeline(mPipeline);
-            frame.cmd->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
-            if (mUseInstancedDraw) {
-                frame.cmd->Draw(3, mNumTriangles, 0, 0);
-            }
-            else {
-                for (uint32_t i = 0; i < mNumTriangles; ++i) {
-                    frame.cmd->Draw(3, 1, 0, 0);
-                }
+
+        Timer recordTimer;
+        PPX_ASSERT_MSG(recordTimer.Start() == TIMER_RESULT_SUCCESS, "timer start failed");
+        if (mRecordThreadCount > 0) {
+            // Only ExecuteCommands is allowed inside a render pass that uses
+            // secondary command buffers, so the timestamps go outside of it.
+            RecordSecondaryCommandBuffers(renderPass);
+
+            GetGpuProfiler()->BeginScope(frame.cmd, "draw");
+            frame.cmd->BeginRenderPass(renderPass, true);
+            std::vector<const grfx::CommandBuffer*> secondaryCmds(std::begin(frame.secondaryCmds), std::end(frame.secondaryCmds));
+            frame.cmd->ExecuteCommands(CountU32(secondaryCmds), DataPtr(secondaryCmds));
+            frame.cmd->EndRenderPass();
+            GetGpuProfiler()->EndScope(frame.cmd);
+        }
+        else {
+            frame.cmd->BeginRenderPass(renderPass);
+            {
+                GetGpuProfiler()->BeginScope(frame.cmd, "draw");
+                RecordDraws(frame.cmd, 0, mNumTriangles);
+                GetGpuProfiler()->EndScope(frame.cmd);
             }
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+            frame.cmd->EndRenderPass();
         }
-        frame.cmd->EndRenderPass();
-        frame.cmd->ResolveQueryData(frame.timestampQuery, 0, 2);
+        mCpuRecordTime = recordTimer.MillisSinceStart();
+        if (!mStateChangeModes.empty() && mMeasured) {
+            mStateChangeCosts[mStateChange].cpuRecordMs += mCpuRecordTime;
+            mStateChangeCosts[mStateChange].cpuFrames++;
+        }
+        GetGpuProfiler()->EndFrame(frame.cmd);
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
     }
     PPX_CHECKED_CALL(frame.cmd->End());
@@ -288,16 +677,23 @@ void ProjApp::Render()
     PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
 
     PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
-    if (GetFrameCount() > 0) {
-        uint64_t frequency = 0;
-        GetGraphicsQueue()->GetTimestampFrequency(&frequency);
-        const float      gpuWorkDuration = static_cast<float>(mGpuWorkDuration / static_cast<double>(frequency)) * 1000.0f;
+    if (GetGpuProfiler()->GetScopesFrameNumber() > 0) {
+        const float      gpuWorkDuration = static_cast<float>(GetGpuProfiler()->GetScopes()[0].gpuMs);
         PerFrameRegister stats           = {};
         stats.frameNumber                = GetFrameCount();
         stats.gpuWorkDuration            = gpuWorkDuration;
         stats.cpuFrameTime               = GetPrevFrameTime();
+        stats.cpuRecordTime              = static_cast<float>(mCpuRecordTime);
+        stats.stateChange                = mStateChangeModes.empty() ? -1 : static_cast<int32_t>(mStateChange);
         mFrameRegisters.push_back(stats);
+
+        if (!mStateChangeModes.empty() && mPrevMeasured) {
+            mStateChangeCosts[mPrevStateChange].gpuMs += gpuWorkDuration;
+            mStateChangeCosts[mPrevStateChange].gpuFrames++;
+        }
     }
+    mPrevStateChange = mStateChange;
+    mPrevMeasured    = mMeasured;
 }
 
 int main(int argc, char** argv)
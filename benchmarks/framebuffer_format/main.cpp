@@ -0,0 +1,442 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+struct FormatInfo
+{
+    grfx::Format format;
+    const char*  name;
+};
+
+static const FormatInfo kFormats[] = {
+    {grfx::FORMAT_R8G8B8A8_UNORM, "rgba8"},
+    {grfx::FORMAT_R10G10B10A2_UNORM, "rgb10a2"},
+    {grfx::FORMAT_R11G11B10_FLOAT, "rg11b10f"},
+    {grfx::FORMAT_R16G16B16A16_FLOAT, "rgba16f"},
+    {grfx::FORMAT_R32G32B32A32_FLOAT, "rgba32f"},
+};
+
+struct CompressionInfo
+{
+    grfx::ImageCompression compression;
+    const char*            suffix;
+};
+
+static const CompressionInfo kCompressions[] = {
+    {grfx::IMAGE_COMPRESSION_DEFAULT, ""},
+    {grfx::IMAGE_COMPRESSION_DISABLED, "_uncompressed"},
+    {grfx::IMAGE_COMPRESSION_FIXED_RATE, "_fixed_rate"},
+};
+
+// Must match FramebufferParams in FramebufferFormat.hlsl
+struct FramebufferParams
+{
+    uint32_t layer;
+    uint32_t smoothContent;
+    float    invSize[2];
+};
+
+// Measures the fill rate, blend cost and bandwidth of the render target
+// formats considered for HDR rendering, at the window resolution
+// (--resolution). Each case draws --layers fullscreen triangles into a
+// render target of one format, either opaque ("<format>_fill") or alpha
+// blended ("<format>_blend"). With --compression-control, each format is also
+// measured with framebuffer compression disabled ("<format>_uncompressed_*")
+// and with fixed-rate compression ("<format>_fixed_rate_*"), where
+// VK_EXT_image_compression_control supports it.
+//
+// Each case is measured for --samples frames after a warmup frame and
+// recorded as a "<case>" gauge in Gpixels/s and a "<case>_bandwidth" gauge in
+// GB/s. The bandwidth is estimated from the bytes the layers write, and read
+// back when blending, assuming no compression: compression shows up as an
+// estimate above what the memory can do. After every pass over the cases,
+// the blend cost of each format is logged.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    // Per format and compression
+    struct Target
+    {
+        grfx::Format           format      = grfx::FORMAT_UNDEFINED;
+        grfx::ImageCompression compression = grfx::IMAGE_COMPRESSION_DEFAULT;
+        std::string            name        = "";
+        grfx::ImagePtr         image;
+        grfx::RenderPassPtr    renderPass;
+    };
+
+    struct Case
+    {
+        std::string               name         = "";
+        uint32_t                  targetIndex  = 0;
+        bool                      blend        = false;
+        uint64_t                  bytes        = 0; // Estimated memory traffic per frame
+        metrics::MetricID         fillRateId   = metrics::kInvalidMetricID;
+        metrics::MetricID         bandwidthId  = metrics::kInvalidMetricID;
+        grfx::GraphicsPipelinePtr pipeline;
+        double                    totalSeconds = 0.0; // Of the samples since the last log
+        uint32_t                  sampleCount  = 0;
+        double                    meanSeconds  = 0.0; // Of all the samples so far
+        uint64_t                  meanCount    = 0;
+    };
+
+    void SetupCases();
+    void SetupTarget(Target& target);
+    void SetupPipeline(Case& c, grfx::ShaderModule* pVS, grfx::ShaderModule* pPS);
+    void FinishSample(Case& c, uint64_t ticks);
+    void LogBlendCosts() const;
+
+    grfx::ShaderModulePtr LoadShaderModule(const std::string& name);
+
+private:
+    std::shared_ptr<KnobFlag<int>>  pLayers;
+    std::shared_ptr<KnobFlag<bool>> pSmoothContent;
+    std::shared_ptr<KnobFlag<bool>> pCompressionControl;
+    std::shared_ptr<KnobFlag<int>>  pSamples;
+    std::shared_ptr<KnobFlag<int>>  pPasses;
+
+    grfx::CommandBufferPtr     mCommandBuffer;
+    grfx::FencePtr             mFence;
+    grfx::QueryPtr             mTimestampQuery;
+    grfx::PipelineInterfacePtr mPipelineInterface;
+
+    std::vector<Target> mTargets;
+    std::vector<Case>   mCases;
+    uint32_t            mCaseIndex   = 0;
+    uint32_t            mFrameInCase = 0; // The first frame of a case is a warmup
+    uint32_t            mPass        = 0; // Over all cases
+    bool                mInFlight    = false;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pLayers, "layers", 8);
+    pLayers->SetFlagDescription("Number of fullscreen triangles drawn by each case.");
+    pLayers->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pSmoothContent, "smooth-content", false);
+    pSmoothContent->SetFlagDescription("Draw smooth gradients instead of noise, which lossless framebuffer compression reduces much more.");
+
+    GetKnobManager().InitKnob(&pCompressionControl, "compression-control", false);
+    pCompressionControl->SetFlagDescription("Also measure each format with compression disabled and with fixed-rate compression, where VK_EXT_image_compression_control supports them.");
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each case is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all cases are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "framebuffer_format";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    const uint64_t pixels = static_cast<uint64_t>(GetWindowWidth()) * GetWindowHeight() * static_cast<uint64_t>(pLayers->GetValue());
+
+    for (const FormatInfo& format : kFormats) {
+        if (!GetDevice()->RenderTargetSampleCountSupported(format.format, grfx::SAMPLE_COUNT_1)) {
+            PPX_LOG_WARN(format.name << " render targets are not supported, skipping its cases");
+            continue;
+        }
+        const bool     blend         = GetDevice()->RenderTargetBlendSupported(format.format);
+        const uint64_t bytesPerPixel = grfx::GetFormatDescription(format.format)->bytesPerTexel;
+        if (!blend) {
+            PPX_LOG_WARN(format.name << " render targets can't be blended, skipping its blend cases");
+        }
+
+        for (const CompressionInfo& compression : kCompressions) {
+            if (compression.compression != grfx::IMAGE_COMPRESSION_DEFAULT) {
+                if (!pCompressionControl->GetValue()) {
+                    continue;
+                }
+                if (!GetDevice()->ImageCompressionSupported(format.format, compression.compression)) {
+                    PPX_LOG_WARN(format.name << compression.suffix << " is not supported, skipping its cases");
+                    continue;
+                }
+            }
+
+            Target target      = {};
+            target.format      = format.format;
+            target.compression = compression.compression;
+            target.name        = std::string(format.name) + compression.suffix;
+            mTargets.push_back(target);
+
+            Case c        = {};
+            c.name        = target.name + "_fill";
+            c.targetIndex = CountU32(mTargets) - 1;
+            c.bytes       = pixels * bytesPerPixel;
+            mCases.push_back(c);
+
+            if (blend) {
+                c.name  = target.name + "_blend";
+                c.blend = true;
+                c.bytes = 2 * pixels * bytesPerPixel; // Read and write
+                mCases.push_back(c);
+            }
+        }
+    }
+}
+
+grfx::ShaderModulePtr ProjApp::LoadShaderModule(const std::string& name)
+{
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", name);
+    PPX_ASSERT_MSG(!bytecode.empty(), "Shader bytecode load failed: " << name);
+    grfx::ShaderModulePtr        shader;
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &shader));
+    return shader;
+}
+
+void ProjApp::SetupTarget(Target& target)
+{
+    grfx::ImageCreateInfo imageCreateInfo   = grfx::ImageCreateInfo::RenderTarget2D(GetWindowWidth(), GetWindowHeight(), target.format);
+    imageCreateInfo.usageFlags.bits.sampled = false;
+    imageCreateInfo.initialState            = grfx::RESOURCE_STATE_RENDER_TARGET;
+    imageCreateInfo.compression             = target.compression;
+    PPX_CHECKED_CALL(GetDevice()->CreateImage(&imageCreateInfo, &target.image));
+
+    grfx::RenderPassCreateInfo3 createInfo = {};
+    createInfo.width                       = GetWindowWidth();
+    createInfo.height                      = GetWindowHeight();
+    createInfo.renderTargetCount           = 1;
+    createInfo.pRenderTargetImages[0]      = target.image;
+    createInfo.renderTargetLoadOps[0]      = grfx::ATTACHMENT_LOAD_OP_CLEAR;
+    createInfo.renderTargetStoreOps[0]     = grfx::ATTACHMENT_STORE_OP_STORE;
+    PPX_CHECKED_CALL(GetDevice()->CreateRenderPass(&createInfo, &target.renderPass));
+}
+
+void ProjApp::SetupPipeline(Case& c, grfx::ShaderModule* pVS, grfx::ShaderModule* pPS)
+{
+    grfx::GraphicsPipelineCreateInfo gpCreateInfo     = {};
+    gpCreateInfo.VS                                   = {pVS, "vsmain"};
+    gpCreateInfo.PS                                   = {pPS, "psmain"};
+    gpCreateInfo.inputAssemblyState.topology          = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    gpCreateInfo.rasterState.polygonMode              = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.rasterState.cullMode                 = grfx::CULL_MODE_NONE;
+    gpCreateInfo.rasterState.frontFace                = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.depthStencilState.depthTestEnable    = false;
+    gpCreateInfo.depthStencilState.depthWriteEnable   = false;
+    gpCreateInfo.colorBlendState.blendAttachmentCount = 1;
+    gpCreateInfo.outputState.renderTargetCount        = 1;
+    gpCreateInfo.outputState.renderTargetFormats[0]   = mTargets[c.targetIndex].format;
+    gpCreateInfo.pPipelineInterface                   = mPipelineInterface;
+    if (c.blend) {
+        gpCreateInfo.colorBlendState.blendAttachments[0] = grfx::BlendAttachmentState::BlendModeAlpha();
+    }
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &c.pipeline));
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    for (Target& target : mTargets) {
+        SetupTarget(target);
+    }
+
+    // Pipelines
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 0;
+        piCreateInfo.pushConstants.count               = sizeof(FramebufferParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding             = 0;
+        piCreateInfo.pushConstants.set                 = 0;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+        grfx::ShaderModulePtr VS = LoadShaderModule("FramebufferFormat.vs");
+        grfx::ShaderModulePtr PS = LoadShaderModule("FramebufferFormat.ps");
+        for (Case& c : mCases) {
+            SetupPipeline(c, VS, PS);
+        }
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    PPX_LOG_INFO("Measuring " << mCases.size() << " cases at " << GetWindowWidth() << "x" << GetWindowHeight() << " with " << pLayers->GetValue() << " layers");
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name, "Gpixels/s", metrics::MetricInterpretation::HIGHER_IS_BETTER};
+        c.fillRateId                     = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.fillRateId != metrics::kInvalidMetricID, "Failed to add metric " << metadata.name);
+
+        // Derived from the same GPU time as the fill rate, recording it as
+        // NONE keeps --compare from counting a change twice
+        metadata      = {metrics::MetricType::GAUGE, c.name + "_bandwidth", "GB/s", metrics::MetricInterpretation::NONE};
+        c.bandwidthId = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.bandwidthId != metrics::kInvalidMetricID, "Failed to add metric " << metadata.name);
+    }
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double seconds = static_cast<double>(ticks) / static_cast<double>(frequency);
+    const double pixels  = static_cast<double>(GetWindowWidth()) * GetWindowHeight() * pLayers->GetValue();
+    c.totalSeconds += seconds;
+    ++c.sampleCount;
+    ++c.meanCount;
+    c.meanSeconds += (seconds - c.meanSeconds) / static_cast<double>(c.meanCount);
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = pixels / seconds / 1e9;
+    RecordMetricData(c.fillRateId, data);
+
+    data.gauge.value = static_cast<double>(c.bytes) / seconds / 1e9;
+    RecordMetricData(c.bandwidthId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        const double mean = c.totalSeconds / c.sampleCount;
+        PPX_LOG_INFO(c.name << ": " << (pixels / mean / 1e9) << " Gpixels/s, " << (static_cast<double>(c.bytes) / mean / 1e9) << " GB/s estimated");
+        c.totalSeconds = 0.0;
+        c.sampleCount  = 0;
+    }
+}
+
+void ProjApp::LogBlendCosts() const
+{
+    // A blend case directly follows the fill case of its target
+    for (size_t i = 1; i < mCases.size(); ++i) {
+        const Case& fill  = mCases[i - 1];
+        const Case& blend = mCases[i];
+        if (!blend.blend || (fill.targetIndex != blend.targetIndex) || (fill.meanSeconds <= 0.0)) {
+            continue;
+        }
+        PPX_LOG_INFO(mTargets[blend.targetIndex].name << " blend cost: " << (blend.meanSeconds / fill.meanSeconds) << "x the fill time");
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mInFlight) {
+        uint64_t timestamps[2] = {0};
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        if (mFrameInCase > 0) {
+            FinishSample(mCases[mCaseIndex], timestamps[1] - timestamps[0]);
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                LogBlendCosts();
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    const Case&   c      = mCases[mCaseIndex];
+    const Target& target = mTargets[c.targetIndex];
+
+    FramebufferParams params = {};
+    params.smoothContent     = pSmoothContent->GetValue() ? 1 : 0;
+    params.invSize[0]        = 1.0f / static_cast<float>(GetWindowWidth());
+    params.invSize[1]        = 1.0f / static_cast<float>(GetWindowHeight());
+
+    mTimestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        mCommandBuffer->BeginRenderPass(target.renderPass);
+        {
+            mCommandBuffer->SetScissors(target.renderPass->GetScissor());
+            mCommandBuffer->SetViewports(target.renderPass->GetViewport());
+            mCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
+            mCommandBuffer->BindGraphicsPipeline(c.pipeline);
+            for (uint32_t layer = 0; layer < static_cast<uint32_t>(pLayers->GetValue()); ++layer) {
+                params.layer = layer;
+                mCommandBuffer->PushGraphicsConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+                mCommandBuffer->Draw(3);
+            }
+        }
+        mCommandBuffer->EndRenderPass();
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    mInFlight = true;
+}
+
+SETUP_APPLICATION(ProjApp)
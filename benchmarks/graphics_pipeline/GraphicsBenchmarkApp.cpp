@@ -17,6 +17,7 @@
 
 #include "ppx/graphics_util.h"
 #include "ppx/grfx/grfx_format.h"
+#include "ppx/job_system.h"
 #include "ppx/timer.h"
 
 using namespace ppx;
@@ -36,6 +37,11 @@ static constexpr size_t SPHERE_METAL_ROUGHNESS_SAMPLER_REGISTER       = 7;
 
 static constexpr size_t QUADS_SAMPLED_IMAGE_REGISTER = 0;
 
+static uint64_t HashCombine(uint64_t seed, uint64_t value)
+{
+    return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+}
+
 #if defined(USE_DX12)
 const grfx::Api kApi = grfx::API_DX_12_0;
 #elif defined(USE_VK)
@@ -111,6 +117,27 @@ void GraphicsBenchmarkApp::InitKnobs()
     pDepthTestWrite->SetFlagDescription("Enable depth test and depth write for spheres.");
     pDepthTestWrite->SetIndent(1);
 
+    GetKnobManager().InitKnob(&pAsyncPipelineCompile, "async-pipeline-compile", false);
+    pAsyncPipelineCompile->SetFlagDescription(
+        "Compile new sphere pipeline permutations on the device's compile threads "
+        "and keep drawing with the previous pipeline until they are ready.");
+
+    GetKnobManager().InitKnob(&pShaderObjects, "shader-objects", false);
+    pShaderObjects->SetFlagDescription(
+        "Bind shader objects and set all pipeline state dynamically instead of "
+        "binding pipeline objects. Falls back to pipeline objects if the device "
+        "doesn't support shader objects.");
+
+    GetKnobManager().InitKnob(&pGpuSphereGeneration, "gpu-sphere-generation", false);
+    pGpuSphereGeneration->SetFlagDescription(
+        "Generate the sphere meshes with a compute shader straight into their "
+        "vertex and index buffers instead of building and uploading them on the CPU.");
+
+    GetKnobManager().InitKnob(&pSphereLod0Segments, "sphere-lod0-segments", /* defaultValue = */ 0, /* minValue = */ 0, /* maxValue = */ 1024);
+    pSphereLod0Segments->SetFlagDescription(
+        "Override the longitude and latitude segments of LOD_0, 0 keeps the default. "
+        "Meshes of every sphere copy must fit in 4GB buffers with --gpu-sphere-generation.");
+
     GetKnobManager().InitKnob(&pFullscreenQuadsCount, "fullscreen-quads-count", /* defaultValue = */ 0, /* minValue = */ 0, kMaxFullscreenQuadsCount);
     pFullscreenQuadsCount->SetDisplayName("Number of Fullscreen Quads");
     pFullscreenQuadsCount->SetFlagDescription("Select the number of fullscreen quads to render.");
@@ -199,6 +226,14 @@ void GraphicsBenchmarkApp::Setup()
     // SCENE (skybox and spheres)
     // =====================================================================
 
+    // Binding model
+    {
+        mShaderObjects = pShaderObjects->GetValue() && GetDevice()->ShaderObjectsSupported();
+        if (pShaderObjects->GetValue() && !mShaderObjects) {
+            PPX_LOG_WARN("Shader objects are not supported, using pipeline objects");
+        }
+        PPX_LOG_INFO("Binding model: " << (mShaderObjects ? "shader objects" : "pipeline objects"));
+    }
     // Camera
     {
         mCamera.LookAt(mCamera.GetEyePosition(), mCamera.GetTarget());
@@ -235,9 +270,6 @@ void GraphicsBenchmarkApp::Setup()
     SetupSkyBoxPipelines();
 
     CreateColorsForDrawCalls();
-    if (pEnableSpheres->GetValue()) {
-        SetupSpheres();
-    }
 
     // =====================================================================
     // FULLSCREEN QUADS
@@ -294,20 +326,21 @@ void GraphicsBenchmarkApp::Setup()
         PPX_CHECKED_CALL(CreateOffscreenFrame(frame, RenderFormat(), GetSwapchain()->GetDepthFormat(), GetSwapchain()->GetWidth(), GetSwapchain()->GetHeight()));
         mOffscreenFrame.push_back(frame);
     }
+
+    // Builds the spheres if they're enabled
+    SetupDerivedResources();
+    UpdateDerivedResources();
 }
 
-void GraphicsBenchmarkApp::SetupMetrics()
+void GraphicsBenchmarkApp::SetupRunMetrics()
 {
-    Application::SetupMetrics();
-    if (HasActiveMetricsRun()) {
-        ppx::metrics::MetricMetadata metadata                     = {ppx::metrics::MetricType::GAUGE, "CPU Submission Time", "ms", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 10000.f}};
-        mMetricsData.metrics[MetricsData::kTypeCPUSubmissionTime] = AddMetric(metadata);
-        PPX_ASSERT_MSG(mMetricsData.metrics[MetricsData::kTypeCPUSubmissionTime] != ppx::metrics::kInvalidMetricID, "Failed to add CPU Submission Time metric");
+    ppx::metrics::MetricMetadata metadata                     = {ppx::metrics::MetricType::GAUGE, "CPU Submission Time", "ms", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 10000.f}};
+    mMetricsData.metrics[MetricsData::kTypeCPUSubmissionTime] = AddMetric(metadata);
+    PPX_ASSERT_MSG(mMetricsData.metrics[MetricsData::kTypeCPUSubmissionTime] != ppx::metrics::kInvalidMetricID, "Failed to add CPU Submission Time metric");
 
-        metadata                                          = {ppx::metrics::MetricType::GAUGE, "Bandwidth", "GB/s", ppx::metrics::MetricInterpretation::HIGHER_IS_BETTER, {0.f, 10000.f}};
-        mMetricsData.metrics[MetricsData::kTypeBandwidth] = AddMetric(metadata);
-        PPX_ASSERT_MSG(mMetricsData.metrics[MetricsData::kTypeBandwidth] != ppx::metrics::kInvalidMetricID, "Failed to add Bandwidth metric");
-    }
+    metadata                                          = {ppx::metrics::MetricType::GAUGE, "Bandwidth", "GB/s", ppx::metrics::MetricInterpretation::HIGHER_IS_BETTER, {0.f, 10000.f}};
+    mMetricsData.metrics[MetricsData::kTypeBandwidth] = AddMetric(metadata);
+    PPX_ASSERT_MSG(mMetricsData.metrics[MetricsData::kTypeBandwidth] != ppx::metrics::kInvalidMetricID, "Failed to add Bandwidth metric");
 }
 
 void GraphicsBenchmarkApp::UpdateMetrics()
@@ -439,8 +472,6 @@ void GraphicsBenchmarkApp::SetupSphereResources()
         mSphere.descriptorSets.push_back(pDescriptorSet);
     }
 
-    UpdateSphereDescriptors();
-
     // Vertex Shaders
     for (size_t i = 0; i < kAvailableVsShaders.size(); i++) {
         const std::string vsShaderBaseName = ToString(kAvailableVsShaders[i]);
@@ -544,7 +575,8 @@ void GraphicsBenchmarkApp::SetupSkyBoxMeshes()
 void GraphicsBenchmarkApp::SetupSphereMeshes()
 {
     GetDevice()->WaitIdle();
-    // Destroy the meshes if they were created.
+    // Destroy the meshes if they were created, interleaved meshes may share
+    // the index buffer of the position planar mesh after them.
     for (auto& mesh : mSphereMeshes) {
         if (!mesh.IsNull()) {
             GetDevice()->DestroyMesh(mesh);
@@ -557,18 +589,112 @@ void GraphicsBenchmarkApp::SetupSphereMeshes()
 
     // Create the meshes
     OrderedGrid grid(initSphereCount, kSeed);
-    uint32_t    meshIndex = 0;
+    mInitializedSpheres = initSphereCount;
+    if (pGpuSphereGeneration->GetValue()) {
+        GenerateSphereMeshes(grid);
+        return;
+    }
+
+    grfx::ShaderModulePtr shader;
+    SetupShader("basic/shaders", "ConvertVertexLayout.cs", &shader);
+
+    grfx::MeshLayoutConverterCreateInfo converterCreateInfo = {};
+    converterCreateInfo.pShader                             = shader;
+
+    grfx::MeshLayoutConverter* pConverter = nullptr;
+    PPX_CHECKED_CALL(grfx::MeshLayoutConverter::Create(GetDevice(), converterCreateInfo, &pConverter));
+    std::unique_ptr<grfx::MeshLayoutConverter> converter(pConverter);
+
+    // The geometry of the LODs is built on the job system, the uploads stay on this thread
+    std::array<std::unique_ptr<SphereMesh>, kAvailableLODs.size()> sphereMeshes;
+    JobSystem::Get()->ParallelFor(static_cast<uint32_t>(kAvailableLODs.size()), 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            const SphereLOD segments = GetSphereLODSegments(kAvailableLODs[i]);
+            sphereMeshes[i]          = std::make_unique<SphereMesh>(/* radius = */ 1, segments.longitudeSegments, segments.latitudeSegments);
+            sphereMeshes[i]->ApplyGrid(grid);
+        }
+    });
+
+    uint32_t meshIndex = 0;
+    for (size_t lodIndex = 0; lodIndex < kAvailableLODs.size(); ++lodIndex) {
+        PPX_LOG_INFO("LOD: " << kAvailableLODs[lodIndex].name);
+        const SphereMesh& sphereMesh = *sphereMeshes[lodIndex];
+        // Create a giant vertex buffer for each vb type to accommodate all copies of the sphere mesh.
+        // Only the position planar meshes are uploaded, the interleaved ones are copies made on the
+        // GPU that share their index buffer.
+        for (const Geometry* pPlanar : {sphereMesh.GetLowPrecisionPositionPlanar(), sphereMesh.GetHighPrecisionPositionPlanar()}) {
+            grfx::MeshPtr& interleavedMesh = mSphereMeshes[meshIndex++];
+            grfx::MeshPtr& planarMesh      = mSphereMeshes[meshIndex++];
+            PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), pPlanar, &planarMesh, nullptr, false, /* storageBuffers = */ true));
+
+            grfx::MeshLayoutInfo layout = {};
+            layout.vertexBufferCount    = 1;
+            for (uint32_t i = 0; i < planarMesh->GetVertexBufferCount(); ++i) {
+                const grfx::MeshVertexBufferDescription* pDesc = planarMesh->GetVertexBufferDescription(i);
+                for (uint32_t j = 0; j < pDesc->attributeCount; ++j) {
+                    grfx::MeshVertexAttribute& attr = layout.vertexBuffers[0].attributes[layout.vertexBuffers[0].attributeCount++];
+                    attr.format                     = pDesc->attributes[j].format;
+                    attr.vertexSemantic             = pDesc->attributes[j].vertexSemantic;
+                }
+            }
+            PPX_CHECKED_CALL(grfx_util::ConvertMeshLayout(GetGraphicsQueue(), converter.get(), planarMesh, layout, &interleavedMesh));
+        }
+    }
+
+    converter.reset();
+    GetDevice()->DestroyShaderModule(shader);
+}
+
+SphereLOD GraphicsBenchmarkApp::GetSphereLODSegments(const DropdownEntry<SphereLOD>& lod) const
+{
+    const uint32_t segments = static_cast<uint32_t>(pSphereLod0Segments->GetValue());
+    if ((segments == 0) || (&lod != &kAvailableLODs[0])) {
+        return lod.value;
+    }
+    return {segments, segments};
+}
+
+void GraphicsBenchmarkApp::GenerateSphereMeshes(const OrderedGrid& grid)
+{
+    grfx::ShaderModulePtr shader;
+    SetupShader("basic/shaders", "GenerateMesh.cs", &shader);
+
+    grfx::MeshGeneratorCreateInfo generatorCreateInfo = {};
+    generatorCreateInfo.pShader                       = shader;
+
+    grfx::MeshGenerator* pGenerator = nullptr;
+    PPX_CHECKED_CALL(grfx::MeshGenerator::Create(GetDevice(), generatorCreateInfo, &pGenerator));
+    std::unique_ptr<grfx::MeshGenerator> generator(pGenerator);
+
+    grfx::GeneratedMeshInfo info = {};
+    info.shape                   = grfx::MESH_GENERATOR_SHAPE_SPHERE;
+    info.size                    = float2(1);
+    for (uint32_t i = 0; i < grid.GetCount(); ++i) {
+        info.translations.push_back(float3(grid.GetModelMatrix(i)[3]));
+    }
+
+    // Same variants and order as SphereMesh
+    uint32_t meshIndex = 0;
     for (const auto& lod : kAvailableLODs) {
-        PPX_LOG_INFO("LOD: " << lod.name);
-        SphereMesh sphereMesh(/* radius = */ 1, lod.value.longitudeSegments, lod.value.latitudeSegments);
-        sphereMesh.ApplyGrid(grid);
-        // Create a giant vertex buffer for each vb type to accommodate all copies of the sphere mesh
-        PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), sphereMesh.GetLowPrecisionInterleaved(), &mSphereMeshes[meshIndex++]));
-        PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), sphereMesh.GetLowPrecisionPositionPlanar(), &mSphereMeshes[meshIndex++]));
-        PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), sphereMesh.GetHighPrecisionInterleaved(), &mSphereMeshes[meshIndex++]));
-        PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), sphereMesh.GetHighPrecisionPositionPlanar(), &mSphereMeshes[meshIndex++]));
+        PPX_LOG_INFO("LOD: " << lod.name << " (GPU generated)");
+        const SphereLOD segments = GetSphereLODSegments(lod);
+        info.usegs               = segments.longitudeSegments;
+        info.vsegs               = segments.latitudeSegments;
+
+        for (bool highPrecision : {false, true}) {
+            info.positionFormat = highPrecision ? grfx::FORMAT_R32G32B32_FLOAT : grfx::FORMAT_R16G16B16A16_FLOAT;
+            info.texCoordFormat = highPrecision ? grfx::FORMAT_R32G32_FLOAT : grfx::FORMAT_R16G16_FLOAT;
+            info.normalFormat   = highPrecision ? grfx::FORMAT_R32G32B32_FLOAT : grfx::FORMAT_R8G8B8A8_SNORM;
+            info.tangentFormat  = highPrecision ? grfx::FORMAT_R32G32B32A32_FLOAT : grfx::FORMAT_R8G8B8A8_SNORM;
+            for (bool positionPlanar : {false, true}) {
+                info.positionPlanar = positionPlanar;
+                PPX_CHECKED_CALL(grfx_util::GenerateMesh(GetGraphicsQueue(), generator.get(), info, &mSphereMeshes[meshIndex++]));
+            }
+        }
     }
-    mInitializedSpheres = initSphereCount;
+
+    generator.reset();
+    GetDevice()->DestroyShaderModule(shader);
 }
 
 void GraphicsBenchmarkApp::SetupFullscreenQuadsMeshes()
@@ -626,8 +752,8 @@ void GraphicsBenchmarkApp::SetupSpheresPipelines()
     piCreateInfo.pushConstants.set                 = 0;
     PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mSphere.pipelineInterface));
 
-    // Pre-load the current pipeline variant.
-    GetSpherePipeline();
+    mDynamicDepthTestWrite = GetDevice()->ExtendedDynamicStateSupported();
+    mDynamicAlphaBlend     = GetDevice()->DynamicBlendEnableSupported();
 }
 
 Result GraphicsBenchmarkApp::CompilePipeline(const SkyBoxPipelineKey& key)
@@ -652,6 +778,7 @@ Result GraphicsBenchmarkApp::CompilePipeline(const SkyBoxPipelineKey& key)
     gpCreateInfo.outputState.renderTargetFormats[0] = key.renderFormat;
     gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
     gpCreateInfo.pPipelineInterface                 = mSkyBox.pipelineInterface;
+    gpCreateInfo.shaderObjects                      = mShaderObjects;
 
     grfx::GraphicsPipelinePtr pipeline = nullptr;
     Result                    ppxres   = GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &pipeline);
@@ -670,9 +797,22 @@ Result GraphicsBenchmarkApp::CompilePipeline(const SpherePipelineKey& key)
         return SUCCESS;
     }
 
+    auto pending = mPendingPipelines.find(key);
+    if (pending != mPendingPipelines.end()) {
+        if (!pending->second.IsReady()) {
+            return SUCCESS;
+        }
+        Result ppxres = pending->second.GetResult();
+        if (ppxres == SUCCESS) {
+            mPipelines[key] = pending->second.Get();
+        }
+        mPendingPipelines.erase(pending);
+        return ppxres;
+    }
+
     bool            interleaved = (key.vertexAttributeLayout == 0);
     size_t          meshIndex   = kAvailableVertexAttrLayouts.size() * key.vertexFormat + key.vertexAttributeLayout;
-    grfx::BlendMode blendMode   = (key.enableAlphaBlend ? grfx::BLEND_MODE_ALPHA : grfx::BLEND_MODE_NONE);
+    grfx::BlendMode blendMode   = ((key.enableAlphaBlend || mDynamicAlphaBlend) ? grfx::BLEND_MODE_ALPHA : grfx::BLEND_MODE_NONE);
 
     grfx::GraphicsPipelineCreateInfo2 gpCreateInfo = {};
     gpCreateInfo.VS                                = {mVsShaders[key.vs].Get(), "vsmain"};
@@ -699,6 +839,15 @@ Result GraphicsBenchmarkApp::CompilePipeline(const SpherePipelineKey& key)
     gpCreateInfo.outputState.renderTargetFormats[0] = key.renderFormat;
     gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
     gpCreateInfo.pPipelineInterface                 = mSphere.pipelineInterface;
+    gpCreateInfo.shaderObjects                      = mShaderObjects;
+    gpCreateInfo.dynamicState.depthTestEnable       = mDynamicDepthTestWrite;
+    gpCreateInfo.dynamicState.depthWriteEnable      = mDynamicDepthTestWrite;
+    gpCreateInfo.dynamicState.blendEnable           = mDynamicAlphaBlend;
+
+    // Only compile in the background if there's a pipeline to draw with meanwhile
+    if (pAsyncPipelineCompile->GetValue() && mLastSpherePipelineKey.has_value()) {
+        return GetDevice()->CreateGraphicsPipelineAsync(&gpCreateInfo, &mPendingPipelines[key]);
+    }
 
     grfx::GraphicsPipelinePtr pipeline = nullptr;
     Result                    ppxres   = GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &pipeline);
@@ -734,6 +883,7 @@ Result GraphicsBenchmarkApp::CompilePipeline(const QuadPipelineKey& key)
     gpCreateInfo.outputState.renderTargetFormats[0] = key.renderFormat;
     gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
     gpCreateInfo.pPipelineInterface                 = mQuadsPipelineInterfaces[quadTypeIndex];
+    gpCreateInfo.shaderObjects                      = mShaderObjects;
 
     grfx::GraphicsPipelinePtr pipeline = nullptr;
     Result                    ppxres   = GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &pipeline);
@@ -746,20 +896,43 @@ Result GraphicsBenchmarkApp::CompilePipeline(const QuadPipelineKey& key)
     return ppxres;
 }
 
-// Compile or load from cache currently required pipeline.
-grfx::GraphicsPipelinePtr GraphicsBenchmarkApp::GetSpherePipeline()
+SpherePipelineKey GraphicsBenchmarkApp::GetSpherePipelineKey()
 {
     SpherePipelineKey key     = {};
     key.ps                    = static_cast<uint8_t>(pKnobPs->GetIndex());
     key.vs                    = static_cast<uint8_t>(pKnobVs->GetIndex());
     key.vertexFormat          = static_cast<uint8_t>(pKnobVbFormat->GetIndex());
     key.vertexAttributeLayout = static_cast<uint8_t>(pKnobVertexAttrLayout->GetIndex());
-    key.enableDepth           = pDepthTestWrite->GetValue();
-    key.enableAlphaBlend      = pAlphaBlend->GetValue();
+    key.enableDepth           = !mDynamicDepthTestWrite && pDepthTestWrite->GetValue();
+    key.enableAlphaBlend      = !mDynamicAlphaBlend && pAlphaBlend->GetValue();
     key.renderFormat          = RenderFormat();
     key.enablePolygonModeLine = (pDebugViews->GetValue() == DebugView::WIREFRAME_MODE);
+    return key;
+}
+
+// Compile or load from cache currently required pipeline.
+grfx::GraphicsPipelinePtr GraphicsBenchmarkApp::GetSpherePipeline()
+{
+    const SpherePipelineKey key = GetSpherePipelineKey();
     PPX_CHECKED_CALL(CompilePipeline(key));
-    return mPipelines[key];
+
+    auto it = mPipelines.find(key);
+    if (it == mPipelines.end()) {
+        // Still compiling. The previous pipeline can stand in as long as it
+        // matches the vertex buffers and render target that will be bound.
+        const SpherePipelineKey& last = mLastSpherePipelineKey.value();
+        if ((last.vertexFormat == key.vertexFormat) &&
+            (last.vertexAttributeLayout == key.vertexAttributeLayout) &&
+            (last.renderFormat == key.renderFormat)) {
+            return mPipelines[last];
+        }
+        PPX_CHECKED_CALL(mPendingPipelines[key].Wait());
+        PPX_CHECKED_CALL(CompilePipeline(key));
+        it = mPipelines.find(key);
+    }
+
+    mLastSpherePipelineKey = key;
+    return it->second;
 }
 
 grfx::GraphicsPipelinePtr GraphicsBenchmarkApp::GetFullscreenQuadPipeline()
@@ -815,24 +988,151 @@ void GraphicsBenchmarkApp::SetupFullscreenQuadsPipelines()
     GetFullscreenQuadPipeline();
 }
 
-void GraphicsBenchmarkApp::SetupSpheres()
+void GraphicsBenchmarkApp::SetupDerivedResources()
 {
-    SetupSphereResources();
-    SetupSphereMeshes();
-    // Pipelines must be setup after meshes to use in vertex bindings.
-    SetupSpheresPipelines();
-    mSpheresAreSetUp = true;
+    const auto offscreenSize = [this]() {
+        std::pair<int, int> resolution = pResolution->GetValue();
+
+        int fbWidth  = (resolution.first > 0 ? resolution.first : GetSwapchain()->GetWidth());
+        int fbHeight = (resolution.second > 0 ? resolution.second : GetSwapchain()->GetHeight());
+        return std::make_pair(fbWidth, fbHeight);
+    };
+
+    // Setup() created the offscreen frames and the current skybox and quad
+    // pipelines, the spheres are built the first time they're enabled.
+    DerivedResource offscreenFrames = {};
+    offscreenFrames.name            = "offscreen frames";
+    offscreenFrames.isNeeded        = [this]() { return pRenderOffscreen->GetValue(); };
+    offscreenFrames.getInputs       = [this, offscreenSize]() {
+        const std::pair<int, int> size = offscreenSize();
+        return HashCombine(HashCombine(static_cast<uint64_t>(RenderFormat()), size.first), size.second);
+    };
+    offscreenFrames.rebuild = [this, offscreenSize]() {
+        const std::pair<int, int> size = offscreenSize();
+        UpdateOffscreenBuffer(RenderFormat(), size.first, size.second);
+    };
+    offscreenFrames.built = true;
+
+    const size_t offscreenFramesIndex = AddDerivedResource(std::move(offscreenFrames));
+
+    // Textures, uniform buffer, descriptor sets, shaders and pipeline interface
+    DerivedResource sphereResources = {};
+    sphereResources.name            = "sphere resources";
+    sphereResources.isNeeded        = [this]() { return pEnableSpheres->GetValue(); };
+    sphereResources.getInputs       = []() { return uint64_t(0); };
+    sphereResources.rebuild         = [this]() {
+        SetupSphereResources();
+        SetupSpheresPipelines();
+    };
+
+    const size_t sphereResourcesIndex = AddDerivedResource(std::move(sphereResources));
+
+    // Meshes only grow, see SetupSphereMeshes()
+    DerivedResource sphereMeshes = {};
+    sphereMeshes.name            = "sphere meshes";
+    sphereMeshes.isNeeded        = [this]() { return pEnableSpheres->GetValue(); };
+    sphereMeshes.getInputs       = [this]() { return static_cast<uint64_t>(std::max<uint32_t>(pSphereInstanceCount->GetValue(), mInitializedSpheres)); };
+    sphereMeshes.rebuild         = [this]() { SetupSphereMeshes(); };
+
+    const size_t sphereMeshesIndex = AddDerivedResource(std::move(sphereMeshes));
+
+    DerivedResource sphereDescriptors = {};
+    sphereDescriptors.name            = "sphere descriptors";
+    sphereDescriptors.dependencies    = {sphereResourcesIndex};
+    sphereDescriptors.isNeeded        = [this]() { return pEnableSpheres->GetValue(); };
+    sphereDescriptors.getInputs       = [this]() { return static_cast<uint64_t>(pAllTexturesTo1x1->GetValue()); };
+    sphereDescriptors.rebuild         = [this]() { UpdateSphereDescriptors(); };
+
+    AddDerivedResource(std::move(sphereDescriptors));
+
+    // Pipelines are cached per key, so these only start compiling a new
+    // variant as soon as its knobs change, in the background with
+    // --async-pipeline-compile, instead of when it's first drawn
+    DerivedResource spherePipeline = {};
+    spherePipeline.name            = "sphere pipeline";
+    spherePipeline.dependencies    = {offscreenFramesIndex, sphereResourcesIndex, sphereMeshesIndex};
+    spherePipeline.isNeeded        = [this]() { return pEnableSpheres->GetValue(); };
+    spherePipeline.getInputs       = [this]() { return static_cast<uint64_t>(SpherePipelineKey::Hash()(GetSpherePipelineKey())); };
+    spherePipeline.rebuild         = [this]() { GetSpherePipeline(); };
+
+    AddDerivedResource(std::move(spherePipeline));
+
+    DerivedResource skyBoxPipeline = {};
+    skyBoxPipeline.name            = "skybox pipeline";
+    skyBoxPipeline.dependencies    = {offscreenFramesIndex};
+    skyBoxPipeline.isNeeded        = [this]() { return pEnableSkyBox->GetValue(); };
+    skyBoxPipeline.getInputs       = [this]() { return static_cast<uint64_t>(RenderFormat()); };
+    skyBoxPipeline.rebuild         = [this]() { GetSkyBoxPipeline(); };
+    skyBoxPipeline.built           = true;
+
+    AddDerivedResource(std::move(skyBoxPipeline));
+
+    DerivedResource quadsPipeline = {};
+    quadsPipeline.name            = "fullscreen quads pipeline";
+    quadsPipeline.dependencies    = {offscreenFramesIndex};
+    quadsPipeline.isNeeded        = [this]() { return pFullscreenQuadsCount->GetValue() > 0; };
+    quadsPipeline.getInputs       = [this]() { return HashCombine(static_cast<uint64_t>(RenderFormat()), static_cast<uint64_t>(pFullscreenQuadsType->GetValue())); };
+    quadsPipeline.rebuild         = [this]() { GetFullscreenQuadPipeline(); };
+    quadsPipeline.built           = true;
+
+    AddDerivedResource(std::move(quadsPipeline));
 }
 
-void GraphicsBenchmarkApp::UpdateOffscreenBuffer(grfx::Format format, int w, int h)
+size_t GraphicsBenchmarkApp::AddDerivedResource(DerivedResource&& resource)
 {
-    {
-        // Checking if we still have the same buffer format.
-        const auto& frame = mOffscreenFrame.back();
-        if ((frame.colorFormat == format) && (frame.width == w) && (frame.height == h)) {
-            return;
+    for (size_t dependency : resource.dependencies) {
+        PPX_ASSERT_MSG(dependency < mDerivedResources.size(), "derived resources must be added after their dependencies");
+    }
+    if (resource.built) {
+        resource.builtInputs = GetDerivedResourceInputs(resource);
+    }
+    mDerivedResources.push_back(std::move(resource));
+    return mDerivedResources.size() - 1;
+}
+
+uint64_t GraphicsBenchmarkApp::GetDerivedResourceInputs(const DerivedResource& resource) const
+{
+    uint64_t inputs = resource.getInputs();
+    for (size_t dependency : resource.dependencies) {
+        inputs = HashCombine(inputs, mDerivedResources[dependency].version);
+    }
+    return inputs;
+}
+
+uint32_t GraphicsBenchmarkApp::UpdateDerivedResources()
+{
+    uint32_t rebuiltCount = 0;
+    for (DerivedResource& resource : mDerivedResources) {
+        if (resource.isNeeded && !resource.isNeeded()) {
+            continue;
+        }
+
+        // Dependencies that aren't needed may not have been built yet
+        const bool dependenciesBuilt = std::all_of(
+            resource.dependencies.begin(),
+            resource.dependencies.end(),
+            [this](size_t dependency) { return mDerivedResources[dependency].built; });
+        if (!dependenciesBuilt) {
+            continue;
+        }
+
+        if (resource.built && (GetDerivedResourceInputs(resource) == resource.builtInputs)) {
+            continue;
         }
+
+        resource.rebuild();
+        // Read after the rebuild, which may change inputs like the sphere
+        // capacity, so the resource isn't rebuilt again next frame
+        resource.built       = true;
+        resource.builtInputs = GetDerivedResourceInputs(resource);
+        ++resource.version;
+        ++rebuiltCount;
     }
+    return rebuiltCount;
+}
+
+void GraphicsBenchmarkApp::UpdateOffscreenBuffer(grfx::Format format, int w, int h)
+{
     GetDevice()->WaitIdle();
     for (auto& frame : mOffscreenFrame) {
         DestroyOffscreenFrame(frame);
@@ -858,6 +1158,22 @@ void GraphicsBenchmarkApp::MouseMove(int32_t x, int32_t y, int32_t dx, int32_t d
     mCamera.Turn(deltaTheta, -deltaPhi);
 }
 
+// Holding the right button captures the cursor for mouse look, with raw
+// motion where available
+void GraphicsBenchmarkApp::MouseDown(int32_t x, int32_t y, uint32_t buttons)
+{
+    if (mEnableMouseMovement && (buttons & MOUSE_BUTTON_RIGHT)) {
+        SetCursorCaptured(true);
+    }
+}
+
+void GraphicsBenchmarkApp::MouseUp(int32_t x, int32_t y, uint32_t buttons)
+{
+    if (buttons & MOUSE_BUTTON_RIGHT) {
+        SetCursorCaptured(false);
+    }
+}
+
 void GraphicsBenchmarkApp::KeyDown(ppx::KeyCode key)
 {
     mPressedKeys[key] = true;
@@ -901,6 +1217,8 @@ void GraphicsBenchmarkApp::ProcessKnobs()
     const bool quadChanged        = ProcessQuadsKnobs();
     const bool framebufferChanged = ProcessOffscreenRenderKnobs();
 
+    UpdateDerivedResources();
+
     if (sphereChanged || quadChanged || framebufferChanged) {
         mGpuWorkDuration.ClearHistory();
         mCPUSubmissionTime.ClearHistory();
@@ -955,24 +1273,7 @@ bool GraphicsBenchmarkApp::ProcessSphereKnobs()
     pKnobPs->SetVisible(enableSpheres && (pDebugViews->GetIndex() != static_cast<size_t>(DebugView::SHOW_DRAWCALLS)));
     pAllTexturesTo1x1->SetVisible(enableSpheres && (pKnobPs->GetValue() == SpherePS::SPHERE_PS_MEM_BOUND));
 
-    if (enableSpheres) {
-        // Update sphere resources and mesh
-        if (!mSpheresAreSetUp) {
-            // This creates all resources.
-            SetupSpheres();
-        }
-        else {
-            const uint32_t initializedCount   = static_cast<uint32_t>(pSphereInstanceCount->GetValue());
-            const bool     requireMoreSpheres = sphereInstanceCountKnobChanged && (initializedCount > mInitializedSpheres);
-            if (requireMoreSpheres) {
-                SetupSphereMeshes();
-            }
-            // Update descriptors
-            if (allTexturesTo1x1KnobChanged) {
-                UpdateSphereDescriptors();
-            }
-        }
-    }
+    // Sphere resources and meshes are updated by UpdateDerivedResources()
     return anyUpdate;
 }
 
@@ -988,13 +1289,7 @@ bool GraphicsBenchmarkApp::ProcessOffscreenRenderKnobs()
         pResolution->SetVisible(pRenderOffscreen->GetValue());
     }
 
-    if ((offscreenChanged && pRenderOffscreen->GetValue()) || framebufferChanged) {
-        std::pair<int, int> resolution = pResolution->GetValue();
-
-        int fbWidth  = (resolution.first > 0 ? resolution.first : GetSwapchain()->GetWidth());
-        int fbHeight = (resolution.second > 0 ? resolution.second : GetSwapchain()->GetHeight());
-        UpdateOffscreenBuffer(RenderFormat(), fbWidth, fbHeight);
-    }
+    // The offscreen frames are updated by UpdateDerivedResources()
     return anyUpdate;
 }
 
@@ -1111,6 +1406,10 @@ void GraphicsBenchmarkApp::Render()
     // Reset query
     frame.timestampQuery->Reset(/* firstQuery= */ 0, frame.timestampQuery->GetCount());
 
+    // The fence waits and the image acquire may have blocked, turn the
+    // camera with the latest mouse motion before its matrices are recorded
+    PollLateInput();
+
     // Update scene data
 
     const Camera& camera                 = GetCamera();
@@ -1676,6 +1975,14 @@ void GraphicsBenchmarkApp::RecordCommandBufferSpheres(PerFrame& frame)
 {
     // Bind resources
     frame.cmd->BindGraphicsPipeline(GetSpherePipeline());
+    if (mDynamicDepthTestWrite) {
+        frame.cmd->SetDepthTestEnable(pDepthTestWrite->GetValue());
+        frame.cmd->SetDepthWriteEnable(pDepthTestWrite->GetValue());
+    }
+    if (mDynamicAlphaBlend) {
+        const bool blendEnable = pAlphaBlend->GetValue();
+        frame.cmd->SetBlendEnable(1, &blendEnable);
+    }
     const size_t meshIndex = mMeshesIndexer.GetIndex({pKnobLOD->GetIndex(), pKnobVbFormat->GetIndex(), pKnobVertexAttrLayout->GetIndex()});
     frame.cmd->BindIndexBuffer(mSphereMeshes[meshIndex]);
     frame.cmd->BindVertexBuffers(mSphereMeshes[meshIndex]);
@@ -27,9 +27,13 @@
 #include "ppx/random.h"
 
 #include <array>
+#include <functional>
+#include <optional>
 #include <vector>
 #include <unordered_map>
 
+class OrderedGrid;
+
 static constexpr uint32_t kMaxSphereInstanceCount     = 3000;
 static constexpr uint32_t kDefaultSphereInstanceCount = 50;
 static constexpr uint32_t kSeed                       = 89977;
@@ -229,6 +233,8 @@ public:
     virtual void Config(ppx::ApplicationSettings& settings) override;
     virtual void Setup() override;
     virtual void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
+    virtual void MouseDown(int32_t x, int32_t y, uint32_t buttons) override;
+    virtual void MouseUp(int32_t x, int32_t y, uint32_t buttons) override;
     virtual void KeyDown(ppx::KeyCode key) override;
     virtual void KeyUp(ppx::KeyCode key) override;
     virtual void Render() override;
@@ -427,10 +433,25 @@ private:
         grfx::FullscreenQuadPtr      quad;
     };
 
+    // Resource built from knob values and from other derived resources, see
+    // UpdateDerivedResources().
+    struct DerivedResource
+    {
+        const char*               name        = "";
+        std::vector<size_t>       dependencies; // Indices of resources registered before this one
+        std::function<bool()>     isNeeded;     // Null if always needed, others keep their state until they are
+        std::function<uint64_t()> getInputs;    // Hash of the values the resource is built from
+        std::function<void()>     rebuild;
+        bool                      built       = false;
+        uint64_t                  builtInputs = 0; // Inputs and dependency versions read after the last rebuild
+        uint32_t                  version     = 0; // Incremented by every rebuild
+    };
+
 private:
-    using SpherePipelineMap = std::unordered_map<SpherePipelineKey, grfx::GraphicsPipelinePtr, SpherePipelineKey::Hash>;
-    using SkyboxPipelineMap = std::unordered_map<SkyBoxPipelineKey, grfx::GraphicsPipelinePtr, SkyBoxPipelineKey::Hash>;
-    using QuadPipelineMap   = std::unordered_map<QuadPipelineKey, grfx::GraphicsPipelinePtr, QuadPipelineKey::Hash>;
+    using SpherePipelineMap      = std::unordered_map<SpherePipelineKey, grfx::GraphicsPipelinePtr, SpherePipelineKey::Hash>;
+    using AsyncSpherePipelineMap = std::unordered_map<SpherePipelineKey, grfx::AsyncGraphicsPipeline, SpherePipelineKey::Hash>;
+    using SkyboxPipelineMap      = std::unordered_map<SkyBoxPipelineKey, grfx::GraphicsPipelinePtr, SkyBoxPipelineKey::Hash>;
+    using QuadPipelineMap        = std::unordered_map<QuadPipelineKey, grfx::GraphicsPipelinePtr, QuadPipelineKey::Hash>;
 
     std::vector<PerFrame>             mPerFrame;
     FreeCamera                        mCamera;
@@ -459,14 +480,24 @@ private:
     grfx::TexturePtr                                              mMetalRoughnessTexture;
     grfx::TexturePtr                                              mWhitePixelTexture;
     SpherePipelineMap                                             mPipelines;
+    AsyncSpherePipelineMap                                        mPendingPipelines;
+    std::optional<SpherePipelineKey>                              mLastSpherePipelineKey;
     std::array<grfx::MeshPtr, kMeshCount>                         mSphereMeshes;
     std::vector<LOD>                                              mSphereLODs;
     MultiDimensionalIndexer                                       mMeshesIndexer;
     std::vector<float4>                                           mColorsForDrawCalls;
     Random                                                        mRandom;
-    bool                                                          mSpheresAreSetUp    = false;
     uint32_t                                                      mInitializedSpheres = 0;
 
+    // Depth test & write and alpha blend are set on the command buffer
+    // instead of being part of the pipeline key, if the device supports it.
+    bool mDynamicDepthTestWrite = false;
+    bool mDynamicAlphaBlend     = false;
+
+    // Pipelines are bound as shader objects instead of pipeline objects,
+    // see --shader-objects.
+    bool mShaderObjects = false;
+
     // Fullscreen quads resources
     Entity2D                                                             mFullscreenQuads;
     grfx::ShaderModulePtr                                                mVSQuads;
@@ -491,6 +522,8 @@ private:
     MetricsData mMetricsData;
     // This is used to skip first several frames after the knob of quad count being changed
     uint32_t mSkipRecordBandwidthMetricFrameCounter = 0;
+    // In dependency order
+    std::vector<DerivedResource> mDerivedResources;
 
 private:
     std::shared_ptr<KnobCheckbox>              pEnableSkyBox;
@@ -506,6 +539,10 @@ private:
     std::shared_ptr<KnobCheckbox>              pAlphaBlend;
     std::shared_ptr<KnobCheckbox>              pDepthTestWrite;
     std::shared_ptr<KnobCheckbox>              pAllTexturesTo1x1;
+    std::shared_ptr<KnobFlag<bool>>            pAsyncPipelineCompile;
+    std::shared_ptr<KnobFlag<bool>>            pShaderObjects;
+    std::shared_ptr<KnobFlag<bool>>            pGpuSphereGeneration;
+    std::shared_ptr<KnobFlag<int>>             pSphereLod0Segments;
 
     std::shared_ptr<KnobSlider<int>>                   pFullscreenQuadsCount;
     std::shared_ptr<KnobDropdown<FullscreenQuadsType>> pFullscreenQuadsType;
@@ -536,6 +573,9 @@ private:
     // - Geometries (or raw vertices & bindings), meshes
     void SetupSkyBoxMeshes();
     void SetupSphereMeshes();
+    void GenerateSphereMeshes(const OrderedGrid& grid);
+    // Segments of lod after the --sphere-lod0-segments override
+    SphereLOD GetSphereLODSegments(const DropdownEntry<SphereLOD>& lod) const;
     void SetupFullscreenQuadsMeshes();
 
     // Setup pipelines:
@@ -544,12 +584,14 @@ private:
     void SetupSpheresPipelines();
     void SetupFullscreenQuadsPipelines();
 
-    // Setup everything:
-    // - Resources, vertex data and pipelines
-    void SetupSpheres();
+    // Setup the resources rebuilt when knobs change:
+    // - Offscreen frames, sphere resources, meshes and descriptors
+    // - The current pipeline variants, which are cached per key
+    void   SetupDerivedResources();
+    size_t AddDerivedResource(DerivedResource&& resource);
 
     // Metrics related functions
-    virtual void SetupMetrics() override;
+    virtual void SetupRunMetrics() override;
     virtual void UpdateMetrics() override;
 
     Result CompileSpherePipeline(const SpherePipelineKey& key);
@@ -576,6 +618,11 @@ private:
     bool ProcessSphereKnobs();
     bool ProcessQuadsKnobs();
     bool ProcessOffscreenRenderKnobs();
+    // Rebuilds the needed derived resources whose inputs or dependencies
+    // changed since they were built, in dependency order. Returns the
+    // number of rebuilt resources.
+    uint32_t UpdateDerivedResources();
+    uint64_t GetDerivedResourceInputs(const DerivedResource& resource) const;
 
     // Drawing GUI
     void UpdateGUI();
@@ -605,6 +652,7 @@ private:
     void SetupShader(const char* baseDir, const std::filesystem::path& fileName, grfx::ShaderModule** ppShaderModule);
 
     // Compile or load from cache currently required pipeline.
+    SpherePipelineKey         GetSpherePipelineKey();
     grfx::GraphicsPipelinePtr GetSpherePipeline();
     grfx::GraphicsPipelinePtr GetFullscreenQuadPipeline();
     grfx::GraphicsPipelinePtr GetSkyBoxPipeline();
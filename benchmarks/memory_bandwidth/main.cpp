@@ -0,0 +1,492 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+// Must match MemoryBandwidth.hlsli
+static const uint32_t kGroupSize   = 64;
+static const uint32_t kImageWidth  = 4096;
+static const uint64_t kUniformSize = 64 * 1024;
+static const uint64_t kElementSize = 16;
+
+static const uint32_t kStride       = 33;                 // Elements, odd so strided accesses cover the whole size
+static const uint32_t kThreadCount  = 262144;             // Per dispatch, unless fewer elements are accessed
+static const uint64_t kDispatchSize = 64 * 1024 * 1024;   // Minimum bytes accessed by a dispatch
+static const uint64_t kSampleSize   = 1024 * 1024 * 1024; // Bytes accessed by the dispatches of a sample
+
+enum Resource
+{
+    RESOURCE_STORAGE_BUFFER = 0,
+    RESOURCE_UNIFORM_BUFFER = 1,
+    RESOURCE_STORAGE_IMAGE  = 2,
+    RESOURCE_COUNT          = 3,
+};
+
+enum Op
+{
+    OP_READ  = 0,
+    OP_WRITE = 1,
+    OP_COPY  = 2,
+    OP_COUNT = 3,
+};
+
+enum Pattern
+{
+    PATTERN_COALESCED = 0,
+    PATTERN_STRIDED   = 1,
+    PATTERN_RANDOM    = 2,
+    PATTERN_COUNT     = 3,
+};
+
+static const char* kResourceNames[RESOURCE_COUNT] = {"storage_buffer", "uniform_buffer", "storage_image"};
+static const char* kOpNames[OP_COUNT]             = {"read", "write", "copy"};
+static const char* kPatternNames[PATTERN_COUNT]   = {"coalesced", "strided", "random"};
+
+// Must match MemoryBandwidthParams in MemoryBandwidth.hlsli
+struct MemoryBandwidthParams
+{
+    uint32_t elementCount;
+    uint32_t elementBits;
+    uint32_t threadCount;
+    uint32_t elementsPerThread;
+    uint32_t op;
+    uint32_t pattern;
+    uint32_t stride;
+    uint32_t seed;
+};
+
+static bool IsPowerOf2(uint64_t value)
+{
+    return (value != 0) && ((value & (value - 1)) == 0);
+}
+
+static uint32_t Log2(uint64_t value)
+{
+    uint32_t bits = 0;
+    while ((value >> bits) > 1) {
+        ++bits;
+    }
+    return bits;
+}
+
+static std::string SizeString(uint64_t size)
+{
+    if (size >= 1024 * 1024) {
+        return std::to_string(size / (1024 * 1024)) + "MiB";
+    }
+    return std::to_string(size / 1024) + "KiB";
+}
+
+// Measures the GPU bandwidth of compute shaders reading, writing and copying
+// buffers and images of increasing sizes with several access patterns. Each
+// case is measured for --samples frames after a warmup frame and recorded as
+// a "<resource>_<op>_<pattern>_<size>" gauge in GB/s (10^9 bytes per second),
+// so the curve over sizes shows where accesses stop fitting in the caches.
+// Copies count the bytes read and written. Uniform buffers are read-only and
+// at most 64 KiB, their copies write to the storage buffer.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct Case
+    {
+        Resource          resource    = RESOURCE_STORAGE_BUFFER;
+        Op                op          = OP_READ;
+        Pattern           pattern     = PATTERN_COALESCED;
+        uint64_t          size        = 0;
+        std::string       name        = "";
+        metrics::MetricID metricId    = metrics::kInvalidMetricID;
+        double            totalGbps   = 0.0; // Of the samples since the last log
+        uint32_t          sampleCount = 0;
+    };
+
+    struct Shader
+    {
+        grfx::DescriptorSetLayoutPtr layout;
+        grfx::DescriptorSetPtr       set;
+        grfx::PipelineInterfacePtr   pipelineInterface;
+        grfx::ComputePipelinePtr     pipeline;
+    };
+
+    void SetupCases();
+    void SetupShader(const std::string& name, const std::vector<grfx::WriteDescriptor>& writes, Shader* pShader);
+    void RecordCase(const Case& c, uint32_t dispatchCount);
+    void FinishSample(Case& c, uint64_t ticks, uint64_t bytes);
+
+    uint64_t GetPassCount(const Case& c) const
+    {
+        return std::max<uint64_t>(1, kDispatchSize / c.size);
+    }
+
+    uint64_t GetDispatchBytes(const Case& c) const
+    {
+        return c.size * GetPassCount(c) * ((c.op == OP_COPY) ? 2 : 1);
+    }
+
+private:
+    std::shared_ptr<KnobFlag<int>> pMinSizeKiB;
+    std::shared_ptr<KnobFlag<int>> pMaxSizeMiB;
+    std::shared_ptr<KnobFlag<int>> pSamples;
+    std::shared_ptr<KnobFlag<int>> pPasses;
+
+    grfx::CommandBufferPtr    mCommandBuffer;
+    grfx::FencePtr            mFence;
+    grfx::QueryPtr            mTimestampQuery;
+    grfx::DescriptorPoolPtr   mDescriptorPool;
+    grfx::BufferPtr           mSrcBuffer;
+    grfx::BufferPtr           mDstBuffer;
+    grfx::BufferPtr           mUniformBuffer;
+    grfx::ImagePtr            mSrcImage;
+    grfx::ImagePtr            mDstImage;
+    grfx::StorageImageViewPtr mSrcImageView;
+    grfx::StorageImageViewPtr mDstImageView;
+    Shader                    mShaders[RESOURCE_COUNT];
+
+    std::vector<Case> mCases;
+    uint32_t          mCaseIndex     = 0;
+    uint32_t          mFrameInCase   = 0; // The first frame of a case is a warmup
+    uint32_t          mPass          = 0; // Over all cases
+    uint32_t          mDispatchCount = 0; // Of the submitted frame, 0 if nothing is in flight
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pMinSizeKiB, "min-size-kib", 16);
+    pMinSizeKiB->SetFlagDescription("Smallest size measured in KiB, a power of 2.");
+    pMinSizeKiB->SetValidator([](int value) { return (value >= 16) && IsPowerOf2(value); });
+
+    GetKnobManager().InitKnob(&pMaxSizeMiB, "max-size-mib", 256);
+    pMaxSizeMiB->SetFlagDescription("Largest size measured in MiB, a power of 2. Should be well above the GPU's last level cache. Two buffers and two images of this size are allocated.");
+    pMaxSizeMiB->SetValidator([](int value) { return (value >= 1) && (value <= 1024) && IsPowerOf2(value); });
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each case is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all cases are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "memory_bandwidth";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    const uint64_t minSize = static_cast<uint64_t>(pMinSizeKiB->GetValue()) * 1024;
+    const uint64_t maxSize = static_cast<uint64_t>(pMaxSizeMiB->GetValue()) * 1024 * 1024;
+    for (uint32_t resource = 0; resource < RESOURCE_COUNT; ++resource) {
+        for (uint32_t op = 0; op < OP_COUNT; ++op) {
+            if ((resource == RESOURCE_UNIFORM_BUFFER) && (op == OP_WRITE)) {
+                continue;
+            }
+            for (uint32_t pattern = 0; pattern < PATTERN_COUNT; ++pattern) {
+                for (uint64_t size = minSize; size <= maxSize; size *= 2) {
+                    if ((resource == RESOURCE_UNIFORM_BUFFER) && (size > kUniformSize)) {
+                        break;
+                    }
+                    Case c     = {};
+                    c.resource = static_cast<Resource>(resource);
+                    c.op       = static_cast<Op>(op);
+                    c.pattern  = static_cast<Pattern>(pattern);
+                    c.size     = size;
+                    c.name     = std::string(kResourceNames[resource]) + "_" + kOpNames[op] + "_" + kPatternNames[pattern] + "_" + SizeString(size);
+                    mCases.push_back(c);
+                }
+            }
+        }
+    }
+    PPX_ASSERT_MSG(!mCases.empty(), "--min-size-kib must not be larger than --max-size-mib");
+}
+
+void ProjApp::SetupShader(const std::string& name, const std::vector<grfx::WriteDescriptor>& writes, Shader* pShader)
+{
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    for (const grfx::WriteDescriptor& write : writes) {
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(write.binding, write.type));
+    }
+    PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &pShader->layout));
+    PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, pShader->layout, &pShader->set));
+    PPX_CHECKED_CALL(pShader->set->UpdateDescriptors(CountU32(writes), DataPtr(writes)));
+
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", name + ".cs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed: " << name);
+    grfx::ShaderModulePtr        shader;
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &shader));
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = pShader->layout;
+    piCreateInfo.pushConstants.count               = sizeof(MemoryBandwidthParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = 0;
+    piCreateInfo.pushConstants.set                 = 0;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &pShader->pipelineInterface));
+
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {shader.Get(), "csmain"};
+    cpCreateInfo.pPipelineInterface              = pShader->pipelineInterface;
+    PPX_CHECKED_CALL(GetDevice()->CreateComputePipeline(&cpCreateInfo, &pShader->pipeline));
+
+    GetDevice()->DestroyShaderModule(shader);
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    const uint64_t maxSize = static_cast<uint64_t>(pMaxSizeMiB->GetValue()) * 1024 * 1024;
+
+    // Buffers
+    {
+        grfx::BufferCreateInfo createInfo           = {};
+        createInfo.size                             = maxSize;
+        createInfo.usageFlags.bits.rawStorageBuffer = true;
+        createInfo.memoryUsage                      = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                     = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mSrcBuffer));
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mDstBuffer));
+
+        createInfo                               = {};
+        createInfo.size                          = kUniformSize;
+        createInfo.usageFlags.bits.uniformBuffer = true;
+        createInfo.memoryUsage                   = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                  = grfx::RESOURCE_STATE_CONSTANT_BUFFER;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mUniformBuffer));
+    }
+
+    // Images, the element i of a size is texel (i % kImageWidth, i / kImageWidth)
+    {
+        grfx::ImageCreateInfo createInfo   = {};
+        createInfo.type                    = grfx::IMAGE_TYPE_2D;
+        createInfo.width                   = kImageWidth;
+        createInfo.height                  = static_cast<uint32_t>(std::max<uint64_t>(1, maxSize / (kElementSize * kImageWidth)));
+        createInfo.depth                   = 1;
+        createInfo.format                  = grfx::FORMAT_R32G32B32A32_UINT;
+        createInfo.sampleCount             = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount           = 1;
+        createInfo.arrayLayerCount         = 1;
+        createInfo.usageFlags.bits.storage = true;
+        createInfo.memoryUsage             = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState            = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &mSrcImage));
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &mDstImage));
+
+        grfx::StorageImageViewCreateInfo viewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(mSrcImage);
+        PPX_CHECKED_CALL(GetDevice()->CreateStorageImageView(&viewCreateInfo, &mSrcImageView));
+        viewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(mDstImage);
+        PPX_CHECKED_CALL(GetDevice()->CreateStorageImageView(&viewCreateInfo, &mDstImageView));
+    }
+
+    // Shaders
+    {
+        grfx::DescriptorPoolCreateInfo createInfo = {};
+        createInfo.rawStorageBuffer               = 5;
+        createInfo.uniformBuffer                  = 1;
+        createInfo.storageImage                   = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&createInfo, &mDescriptorPool));
+
+        auto bufferWrite = [](uint32_t binding, grfx::DescriptorType type, grfx::Buffer* pBuffer) {
+            grfx::WriteDescriptor write = {};
+            write.binding               = binding;
+            write.type                  = type;
+            write.bufferOffset          = 0;
+            write.bufferRange           = PPX_WHOLE_SIZE;
+            write.pBuffer               = pBuffer;
+            return write;
+        };
+        auto imageWrite = [](uint32_t binding, grfx::StorageImageView* pImageView) {
+            grfx::WriteDescriptor write = {};
+            write.binding               = binding;
+            write.type                  = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            write.pImageView            = pImageView;
+            return write;
+        };
+
+        SetupShader(
+            "MemoryBandwidthBuffer",
+            {bufferWrite(1, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER, mSrcBuffer),
+             bufferWrite(2, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER, mDstBuffer)},
+            &mShaders[RESOURCE_STORAGE_BUFFER]);
+        SetupShader(
+            "MemoryBandwidthUniform",
+            {bufferWrite(1, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, mUniformBuffer),
+             bufferWrite(2, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER, mDstBuffer)},
+            &mShaders[RESOURCE_UNIFORM_BUFFER]);
+        SetupShader(
+            "MemoryBandwidthImage",
+            {imageWrite(1, mSrcImageView),
+             imageWrite(2, mDstImageView),
+             bufferWrite(3, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER, mDstBuffer)},
+            &mShaders[RESOURCE_STORAGE_IMAGE]);
+    }
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    PPX_LOG_INFO("Measuring " << mCases.size() << " memory bandwidth cases from " << SizeString(mCases.front().size) << " to " << SizeString(mCases.back().size));
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name, "GB/s", metrics::MetricInterpretation::HIGHER_IS_BETTER};
+        c.metricId                       = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.metricId != metrics::kInvalidMetricID, "Failed to add metric " << c.name);
+    }
+}
+
+void ProjApp::RecordCase(const Case& c, uint32_t dispatchCount)
+{
+    const uint64_t elementCount = c.size / kElementSize;
+    const uint64_t accessCount  = elementCount * GetPassCount(c);
+
+    MemoryBandwidthParams params = {};
+    params.elementCount          = static_cast<uint32_t>(elementCount);
+    params.elementBits           = Log2(elementCount);
+    params.threadCount           = static_cast<uint32_t>(std::min<uint64_t>(kThreadCount, accessCount));
+    params.elementsPerThread     = static_cast<uint32_t>(accessCount / params.threadCount);
+    params.op                    = c.op;
+    params.pattern               = c.pattern;
+    params.stride                = kStride;
+    params.seed                  = static_cast<uint32_t>(GetFrameCount());
+
+    const Shader& shader = mShaders[c.resource];
+    mCommandBuffer->BindComputeDescriptorSets(shader.pipelineInterface, 1, &shader.set);
+    mCommandBuffer->BindComputePipeline(shader.pipeline);
+    mCommandBuffer->PushComputeConstants(shader.pipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+    // Dispatches of the same case don't need to be ordered, their writes are
+    // only ever read by later frames
+    for (uint32_t i = 0; i < dispatchCount; ++i) {
+        mCommandBuffer->Dispatch(params.threadCount / kGroupSize, 1, 1);
+    }
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks, uint64_t bytes)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double seconds = static_cast<double>(ticks) / static_cast<double>(frequency);
+    const double gbps    = static_cast<double>(bytes) / seconds / 1e9;
+    c.totalGbps += gbps;
+    ++c.sampleCount;
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = gbps;
+    RecordMetricData(c.metricId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        PPX_LOG_INFO(c.name << ": " << (c.totalGbps / c.sampleCount) << " GB/s");
+        c.totalGbps   = 0.0;
+        c.sampleCount = 0;
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mDispatchCount > 0) {
+        uint64_t timestamps[2] = {0};
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        if (mFrameInCase > 0) {
+            Case& c = mCases[mCaseIndex];
+            FinishSample(c, timestamps[1] - timestamps[0], mDispatchCount * GetDispatchBytes(c));
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    const Case& c  = mCases[mCaseIndex];
+    mDispatchCount = static_cast<uint32_t>(std::max<uint64_t>(1, kSampleSize / GetDispatchBytes(c)));
+
+    mTimestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        RecordCase(c, mDispatchCount);
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+}
+
+SETUP_APPLICATION(ProjApp)
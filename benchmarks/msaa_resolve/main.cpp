@@ -0,0 +1,452 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+static const grfx::Format      kFormat         = grfx::FORMAT_R8G8B8A8_UNORM;
+static const uint32_t          kBytesPerPixel  = 4;
+static const grfx::SampleCount kSampleCounts[] = {grfx::SAMPLE_COUNT_2, grfx::SAMPLE_COUNT_4, grfx::SAMPLE_COUNT_8};
+
+enum ResolveMode
+{
+    RESOLVE_MODE_NONE,          // Samples stored, not resolved
+    RESOLVE_MODE_RENDER_PASS,   // Resolve attachment, samples stored
+    RESOLVE_MODE_ON_TILE,       // Resolve attachment, samples discarded and lazily allocated
+    RESOLVE_MODE_RESOLVE_IMAGE, // CommandBuffer::ResolveImage() after the pass
+};
+
+// Measures the cost of MSAA and of resolving it at the window resolution
+// (--resolution), so that the sample count can be chosen per device. A grid
+// of --triangles triangles covers the render target, with a color that varies
+// per pixel and per triangle. The cases are:
+//   - msaa_1x: single sample, the reference
+//   - store_<n>x: n samples stored, not resolved
+//   - render_pass_<n>x: resolved by a resolve attachment of the render pass
+//   - on_tile_<n>x: same, but the samples are discarded at the end of the
+//     pass and their image is lazily allocated, so that tilers never write
+//     them to memory
+//   - resolve_image_<n>x: resolved with CommandBuffer::ResolveImage() after
+//     the render pass
+// for the 2, 4 and 8 sample counts supported by the device. Each case is
+// measured for --samples frames after a warmup frame and recorded as a
+// "<case>_gpu_time" gauge in ms and a "<case>_bandwidth" gauge in GB/s. The
+// bandwidth is estimated from the bytes the case must read and write
+// assuming no framebuffer compression, so it is only comparable between
+// cases and isn't a measure of the memory traffic.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    // Per sample count
+    struct Targets
+    {
+        grfx::SampleCount         sampleCount = grfx::SAMPLE_COUNT_1;
+        grfx::ImagePtr            storedImage;
+        grfx::ImagePtr            transientImage;
+        grfx::GraphicsPipelinePtr pipeline;
+    };
+
+    struct Case
+    {
+        std::string         name         = "";
+        ResolveMode         mode         = RESOLVE_MODE_NONE;
+        uint32_t            targetsIndex = 0;
+        uint64_t            bytes        = 0; // Estimated memory traffic per frame
+        metrics::MetricID   timeMetricId = metrics::kInvalidMetricID;
+        metrics::MetricID   bandwidthId  = metrics::kInvalidMetricID;
+        grfx::RenderPassPtr renderPass;
+        grfx::Image*        pImage      = nullptr; // Render target of the pass
+        double              totalMs     = 0.0;     // Of the samples since the last log
+        uint32_t            sampleCount = 0;
+    };
+
+    void SetupCases();
+    void AddCase(ResolveMode mode, uint32_t targetsIndex);
+    void SetupTargets(Targets& targets);
+    void SetupRenderPass(Case& c);
+    void FinishSample(Case& c, uint64_t ticks);
+
+    grfx::ShaderModulePtr LoadShaderModule(const std::string& name);
+
+private:
+    std::shared_ptr<KnobFlag<int>> pTriangles;
+    std::shared_ptr<KnobFlag<int>> pSamples;
+    std::shared_ptr<KnobFlag<int>> pPasses;
+
+    grfx::CommandBufferPtr     mCommandBuffer;
+    grfx::FencePtr             mFence;
+    grfx::QueryPtr             mTimestampQuery;
+    grfx::ImagePtr             mResolveImage; // Also the render target of msaa_1x
+    grfx::BufferPtr            mVertexBuffer;
+    grfx::BufferPtr            mIndexBuffer;
+    grfx::VertexBinding        mVertexBinding;
+    grfx::PipelineInterfacePtr mPipelineInterface;
+    uint32_t                   mGridTriangles = 0;
+
+    std::vector<Targets> mTargets;
+    std::vector<Case>    mCases;
+    uint32_t             mCaseIndex   = 0;
+    uint32_t             mFrameInCase = 0; // The first frame of a case is a warmup
+    uint32_t             mPass        = 0; // Over all cases
+    bool                 mInFlight    = false;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pTriangles, "triangles", 200000);
+    pTriangles->SetFlagDescription("Approximate number of triangles of the grid covering the render target, more triangles means more edge pixels.");
+    pTriangles->SetValidator([](int value) { return value >= 2; });
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each case is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all cases are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "msaa_resolve";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::AddCase(ResolveMode mode, uint32_t targetsIndex)
+{
+    static const char* kModeNames[] = {"store", "render_pass", "on_tile", "resolve_image"};
+
+    const uint64_t samples     = static_cast<uint64_t>(mTargets[targetsIndex].sampleCount);
+    const uint64_t pixelBytes  = static_cast<uint64_t>(GetWindowWidth()) * GetWindowHeight() * kBytesPerPixel;
+    const bool     storeSample = (mode != RESOLVE_MODE_ON_TILE);
+    const bool     resolve     = (mode != RESOLVE_MODE_NONE);
+
+    Case c         = {};
+    c.name         = (samples == 1) ? "msaa_1x" : (std::string(kModeNames[mode]) + "_" + std::to_string(samples) + "x");
+    c.mode         = mode;
+    c.targetsIndex = targetsIndex;
+    c.bytes        = (storeSample ? (pixelBytes * samples) : 0) + (resolve ? pixelBytes : 0);
+    if (mode == RESOLVE_MODE_RESOLVE_IMAGE) {
+        c.bytes += pixelBytes * samples; // The resolve reads the stored samples back
+    }
+    mCases.push_back(c);
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    mTargets.push_back({grfx::SAMPLE_COUNT_1});
+    AddCase(RESOLVE_MODE_NONE, 0);
+
+    for (grfx::SampleCount sampleCount : kSampleCounts) {
+        if (!GetDevice()->RenderTargetSampleCountSupported(kFormat, sampleCount)) {
+            PPX_LOG_WARN(static_cast<uint32_t>(sampleCount) << "x MSAA is not supported, skipping its cases");
+            continue;
+        }
+
+        const uint32_t targetsIndex = CountU32(mTargets);
+        mTargets.push_back({sampleCount});
+        AddCase(RESOLVE_MODE_NONE, targetsIndex);
+        AddCase(RESOLVE_MODE_RENDER_PASS, targetsIndex);
+        AddCase(RESOLVE_MODE_ON_TILE, targetsIndex);
+        AddCase(RESOLVE_MODE_RESOLVE_IMAGE, targetsIndex);
+    }
+}
+
+grfx::ShaderModulePtr ProjApp::LoadShaderModule(const std::string& name)
+{
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", name);
+    PPX_ASSERT_MSG(!bytecode.empty(), "Shader bytecode load failed: " << name);
+    grfx::ShaderModulePtr        shader;
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &shader));
+    return shader;
+}
+
+void ProjApp::SetupTargets(Targets& targets)
+{
+    if (targets.sampleCount != grfx::SAMPLE_COUNT_1) {
+        // Read by ResolveImage() in the resolve_image cases
+        grfx::ImageCreateInfo createInfo       = grfx::ImageCreateInfo::RenderTarget2D(GetWindowWidth(), GetWindowHeight(), kFormat, targets.sampleCount);
+        createInfo.usageFlags.bits.sampled     = false;
+        createInfo.usageFlags.bits.transferSrc = true;
+        createInfo.initialState                = grfx::RESOURCE_STATE_RENDER_TARGET;
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &targets.storedImage));
+
+        // Transient attachments can only be used as attachments
+        createInfo                                     = grfx::ImageCreateInfo::RenderTarget2D(GetWindowWidth(), GetWindowHeight(), kFormat, targets.sampleCount);
+        createInfo.usageFlags.bits.sampled             = false;
+        createInfo.usageFlags.bits.transientAttachment = true;
+        createInfo.initialState                        = grfx::RESOURCE_STATE_RENDER_TARGET;
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &targets.transientImage));
+    }
+
+    grfx::ShaderModulePtr VS = LoadShaderModule("MsaaResolve.vs");
+    grfx::ShaderModulePtr PS = LoadShaderModule("MsaaResolve.ps");
+
+    grfx::GraphicsPipelineCreateInfo gpCreateInfo     = {};
+    gpCreateInfo.VS                                   = {VS.Get(), "vsmain"};
+    gpCreateInfo.PS                                   = {PS.Get(), "psmain"};
+    gpCreateInfo.vertexInputState.bindingCount        = 1;
+    gpCreateInfo.vertexInputState.bindings[0]         = mVertexBinding;
+    gpCreateInfo.inputAssemblyState.topology          = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    gpCreateInfo.rasterState.polygonMode              = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.rasterState.cullMode                 = grfx::CULL_MODE_NONE;
+    gpCreateInfo.rasterState.frontFace                = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.rasterState.rasterizationSamples     = targets.sampleCount;
+    gpCreateInfo.depthStencilState.depthTestEnable    = false;
+    gpCreateInfo.depthStencilState.depthWriteEnable   = false;
+    gpCreateInfo.colorBlendState.blendAttachmentCount = 1;
+    gpCreateInfo.outputState.renderTargetCount        = 1;
+    gpCreateInfo.outputState.renderTargetFormats[0]   = kFormat;
+    gpCreateInfo.pPipelineInterface                   = mPipelineInterface;
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &targets.pipeline));
+
+    GetDevice()->DestroyShaderModule(VS);
+    GetDevice()->DestroyShaderModule(PS);
+}
+
+void ProjApp::SetupRenderPass(Case& c)
+{
+    const Targets& targets = mTargets[c.targetsIndex];
+
+    c.pImage = mResolveImage;
+    if (targets.sampleCount != grfx::SAMPLE_COUNT_1) {
+        c.pImage = (c.mode == RESOLVE_MODE_ON_TILE) ? targets.transientImage : targets.storedImage;
+    }
+
+    grfx::RenderPassCreateInfo3 createInfo = {};
+    createInfo.width                       = GetWindowWidth();
+    createInfo.height                      = GetWindowHeight();
+    createInfo.renderTargetCount           = 1;
+    createInfo.pRenderTargetImages[0]      = c.pImage;
+    createInfo.renderTargetLoadOps[0]      = grfx::ATTACHMENT_LOAD_OP_CLEAR;
+    createInfo.renderTargetStoreOps[0]     = grfx::ATTACHMENT_STORE_OP_STORE;
+    if ((c.mode == RESOLVE_MODE_RENDER_PASS) || (c.mode == RESOLVE_MODE_ON_TILE)) {
+        createInfo.pResolveImages[0] = mResolveImage;
+    }
+    if (c.mode == RESOLVE_MODE_ON_TILE) {
+        createInfo.renderTargetStoreOps[0] = grfx::ATTACHMENT_STORE_OP_DONT_CARE;
+    }
+    PPX_CHECKED_CALL(GetDevice()->CreateRenderPass(&createInfo, &c.renderPass));
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    // Single sample target of all cases
+    {
+        grfx::ImageCreateInfo createInfo       = grfx::ImageCreateInfo::RenderTarget2D(GetWindowWidth(), GetWindowHeight(), kFormat);
+        createInfo.usageFlags.bits.transferDst = true;
+        createInfo.initialState                = grfx::RESOURCE_STATE_RENDER_TARGET;
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &mResolveImage));
+    }
+
+    // Grid covering the render target
+    {
+        // A segments x segments grid has 2 * segments^2 triangles
+        const uint32_t segments = static_cast<uint32_t>(std::ceil(std::sqrt(pTriangles->GetValue() / 2.0)));
+        TriMesh        mesh     = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Z, float2(2, 2), segments, segments, TriMeshOptions().Indices());
+        mGridTriangles          = mesh.GetCountTriangles();
+
+        grfx::BufferCreateInfo createInfo       = {};
+        createInfo.size                         = mesh.GetDataSizePositions();
+        createInfo.usageFlags.bits.vertexBuffer = true;
+        createInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mVertexBuffer));
+        PPX_CHECKED_CALL(mVertexBuffer->CopyFromSource(static_cast<uint32_t>(mesh.GetDataSizePositions()), mesh.GetDataPositions()));
+
+        createInfo                             = {};
+        createInfo.size                        = mesh.GetDataSizeIndices();
+        createInfo.usageFlags.bits.indexBuffer = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                = grfx::RESOURCE_STATE_INDEX_BUFFER;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mIndexBuffer));
+        PPX_CHECKED_CALL(mIndexBuffer->CopyFromSource(static_cast<uint32_t>(mesh.GetDataSizeIndices()), mesh.GetDataIndicesU32()));
+
+        // TriMesh positions are float3, the missing w component reads as 1
+        mVertexBinding.AppendAttribute({"POSITION", 0, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+    }
+
+    // Images and pipelines per sample count, render passes per case
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 0;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+        for (Targets& targets : mTargets) {
+            SetupTargets(targets);
+        }
+        for (Case& c : mCases) {
+            SetupRenderPass(c);
+        }
+    }
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    PPX_LOG_INFO("Measuring " << mCases.size() << " cases at " << GetWindowWidth() << "x" << GetWindowHeight() << " on a grid of " << mGridTriangles << " triangles");
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name + "_gpu_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER};
+        c.timeMetricId                   = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.timeMetricId != metrics::kInvalidMetricID, "Failed to add metric " << metadata.name);
+
+        // Derived from the GPU time, recording it as NONE keeps --compare
+        // from counting a change twice
+        metadata      = {metrics::MetricType::GAUGE, c.name + "_bandwidth", "GB/s", metrics::MetricInterpretation::NONE};
+        c.bandwidthId = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.bandwidthId != metrics::kInvalidMetricID, "Failed to add metric " << metadata.name);
+    }
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double seconds = static_cast<double>(ticks) / static_cast<double>(frequency);
+    c.totalMs += seconds * 1000.0;
+    ++c.sampleCount;
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = seconds * 1000.0;
+    RecordMetricData(c.timeMetricId, data);
+
+    data.gauge.value = static_cast<double>(c.bytes) / seconds / 1e9;
+    RecordMetricData(c.bandwidthId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        const double ms = c.totalMs / c.sampleCount;
+        PPX_LOG_INFO(c.name << ": " << ms << " ms, " << (static_cast<double>(c.bytes) / (ms / 1000.0) / 1e9) << " GB/s estimated");
+        c.totalMs     = 0.0;
+        c.sampleCount = 0;
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mInFlight) {
+        uint64_t timestamps[2] = {0};
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        if (mFrameInCase > 0) {
+            FinishSample(mCases[mCaseIndex], timestamps[1] - timestamps[0]);
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    const Case&    c       = mCases[mCaseIndex];
+    const Targets& targets = mTargets[c.targetsIndex];
+
+    mTimestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        mCommandBuffer->BeginRenderPass(c.renderPass);
+        {
+            mCommandBuffer->SetScissors(c.renderPass->GetScissor());
+            mCommandBuffer->SetViewports(c.renderPass->GetViewport());
+            mCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
+            mCommandBuffer->BindGraphicsPipeline(targets.pipeline);
+            mCommandBuffer->BindIndexBuffer(mIndexBuffer, grfx::INDEX_TYPE_UINT32);
+            mCommandBuffer->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
+            mCommandBuffer->DrawIndexed(3 * mGridTriangles);
+        }
+        mCommandBuffer->EndRenderPass();
+
+        if (c.mode == RESOLVE_MODE_RESOLVE_IMAGE) {
+            grfx::ImageResolveInfo resolveInfo = {};
+            mCommandBuffer->TransitionImageLayout(c.pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_RESOLVE_SRC);
+            mCommandBuffer->TransitionImageLayout(mResolveImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_RESOLVE_DST);
+            mCommandBuffer->ResolveImage(&resolveInfo, c.pImage, mResolveImage);
+            mCommandBuffer->TransitionImageLayout(c.pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RESOLVE_SRC, grfx::RESOURCE_STATE_RENDER_TARGET);
+            mCommandBuffer->TransitionImageLayout(mResolveImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RESOLVE_DST, grfx::RESOURCE_STATE_RENDER_TARGET);
+        }
+
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    mInFlight = true;
+}
+
+SETUP_APPLICATION(ProjApp)
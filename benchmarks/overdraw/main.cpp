@@ -25,6 +25,7 @@
 #include "ppx/log.h"
 #include "ppx/ppx.h"
 #include "ppx/csv_file_log.h"
+#include "ppx/tri_mesh.h"
 
 using namespace ppx;
 
@@ -55,6 +56,7 @@ public:
 
 private:
     std::vector<float> GetRectSizeScaleFactors();
+    void               SetupMeshGeometry();
 
     struct PerFrame
     {
@@ -63,7 +65,6 @@ private:
         ppx::grfx::FencePtr         imageAcquiredFence;
         ppx::grfx::SemaphorePtr     renderCompleteSemaphore;
         ppx::grfx::FencePtr         renderCompleteFence;
-        ppx::grfx::QueryPtr         timestampQuery;
     };
 
     std::vector<PerFrame>           mPerFrame;
@@ -73,6 +74,8 @@ private:
     ppx::grfx::PipelineInterfacePtr mPipelineInterface;
     ppx::grfx::GraphicsPipelinePtr  mPipeline;
     ppx::grfx::BufferPtr            mVertexBuffer;
+    ppx::grfx::BufferPtr            mIndexBuffer;
+    uint32_t                        mIndexCount = 0;
     grfx::DrawPassPtr               mDrawPass;
     grfx::Viewport                  mViewport;
     grfx::Rect                      mScissorRect;
@@ -95,8 +98,11 @@ private:
     bool        mUseExplicitEarlyZShader = false;
     std::string mBlendMode               = "none";
 
+    // Mesh drawn instead of the layers.
+    std::string mMeshPath;
+    bool        mOptimizeMesh = false;
+
     // Stats
-    uint64_t    mGpuWorkDuration = 0;
     std::string mCSVFileName;
     struct PerFrameRegister
     {
@@ -113,6 +119,7 @@ void ProjApp::Config(ppx::ApplicationSettings& settings)
     settings.enableImGui                = false;
     settings.grfx.api                   = kApi;
     settings.grfx.swapchain.depthFormat = grfx::FORMAT_D32_FLOAT;
+    settings.grfx.gpuProfiler.enable    = true;
 }
 
 void ProjApp::SaveResultsToFile()
@@ -125,6 +132,78 @@ void ProjApp::SaveResultsToFile()
     }
 }
 
+void ProjApp::SetupMeshGeometry()
+{
+    TriMesh mesh = TriMesh::CreateFromOBJ(GetAssetPath(mMeshPath), TriMeshOptions().Indices().TexCoords());
+
+    // OBJ corners are separate vertices, share them so both orders draw the same vertices
+    const uint32_t sourceVertexCount = mesh.GetCountPositions();
+    mesh.WeldVertices();
+    PPX_LOG_INFO("Welded " << sourceVertexCount << " OBJ vertices into " << mesh.GetCountPositions());
+
+    std::vector<uint32_t> indices(mesh.GetDataIndicesU32(), mesh.GetDataIndicesU32() + mesh.GetCountIndices());
+    VertexCacheStats      stats = AnalyzeVertexCache(indices.data(), CountU32(indices), mesh.GetCountPositions());
+    PPX_LOG_INFO("Source order: ACMR " << stats.acmr << ", ATVR " << stats.atvr);
+
+    if (mOptimizeMesh) {
+        MeshOptimizeOptions options = {};
+        options.vertexCache         = true;
+        options.overdraw            = true;
+        options.vertexFetch         = true;
+        mesh.Optimize(options);
+
+        indices.assign(mesh.GetDataIndicesU32(), mesh.GetDataIndicesU32() + mesh.GetCountIndices());
+        stats = AnalyzeVertexCache(indices.data(), CountU32(indices), mesh.GetCountPositions());
+        PPX_LOG_INFO("Optimized order: ACMR " << stats.acmr << ", ATVR " << stats.atvr);
+    }
+
+    // Orthographic view down -Z that fits the mesh on screen, the closest
+    // points get depth 0. Same layout as the layer vertices.
+    const float3 bbMin  = mesh.GetBoundingBoxMin();
+    const float3 bbMax  = mesh.GetBoundingBoxMax();
+    const float3 extent = glm::max(bbMax - bbMin, float3(1e-6f));
+    const float  scale  = 1.8f / std::max(extent.x, extent.y);
+    const float3 center = (bbMin + bbMax) * 0.5f;
+
+    std::vector<float> vertexData;
+    vertexData.reserve(6 * mesh.GetCountPositions());
+    for (uint32_t i = 0; i < mesh.GetCountPositions(); ++i) {
+        const float3& position = *mesh.GetDataPositions(i);
+        const float2  texCoord = mesh.HasTexCoords() ? *mesh.GetDataTexCoords2(i) : float2(0);
+
+        vertexData.push_back((position.x - center.x) * scale);
+        vertexData.push_back((position.y - center.y) * scale);
+        vertexData.push_back((bbMax.z - position.z) / extent.z);
+        vertexData.push_back(1.0f);
+        vertexData.push_back(texCoord.x);
+        vertexData.push_back(texCoord.y);
+    }
+
+    grfx::BufferCreateInfo bufferCreateInfo       = {};
+    bufferCreateInfo.size                         = ppx::SizeInBytesU32(vertexData);
+    bufferCreateInfo.usageFlags.bits.vertexBuffer = true;
+    bufferCreateInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mVertexBuffer));
+
+    void* pAddr = nullptr;
+    PPX_CHECKED_CALL(mVertexBuffer->MapMemory(0, &pAddr));
+    memcpy(pAddr, vertexData.data(), bufferCreateInfo.size);
+    mVertexBuffer->UnmapMemory();
+
+    bufferCreateInfo                             = {};
+    bufferCreateInfo.size                        = mesh.GetDataSizeIndices();
+    bufferCreateInfo.usageFlags.bits.indexBuffer = true;
+    bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mIndexBuffer));
+
+    PPX_CHECKED_CALL(mIndexBuffer->MapMemory(0, &pAddr));
+    memcpy(pAddr, mesh.GetDataIndicesU32(), bufferCreateInfo.size);
+    mIndexBuffer->UnmapMemory();
+
+    mIndexCount = mesh.GetCountIndices();
+    PPX_LOG_INFO("Drawing " << mesh.GetCountTriangles() << " triangles from " << mMeshPath);
+}
+
 void ProjApp::Setup()
 {
     auto cl_options = GetExtraOptions();
@@ -166,6 +245,11 @@ void ProjApp::Setup()
         PPX_LOG_WARN("Invalid blend mode (must be `none`, `additive`, `alpha`, `over`, `under` or `premult_alpha`), defaulting to: " + mBlendMode);
     }
 
+    // OBJ mesh to draw instead of the layers, in its source triangle order
+    // unless optimize-mesh is set.
+    mMeshPath     = cl_options.GetExtraOptionValueOrDefault<std::string>("mesh", "");
+    mOptimizeMesh = cl_options.HasExtraOption("optimize-mesh");
+
     // Per frame data
     {
         PerFrame frame = {};
@@ -183,11 +267,6 @@ void ProjApp::Setup()
         fenceCreateInfo = {true}; // Create signaled
         PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.renderCompleteFence));
 
-        grfx::QueryCreateInfo queryCreateInfo = {};
-        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
-        queryCreateInfo.count                 = 2;
-        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &frame.timestampQuery));
-
         mPerFrame.push_back(frame);
     }
 
@@ -198,7 +277,7 @@ void ProjApp::Setup()
 
     // Vertex buffer for layers rectangles (one full-screen quad for each layer).
     // Each layer's depth is uniformly distributed across [0.0f, 1.0f].
-    {
+    if (mMeshPath.empty()) {
         std::vector<float> vertexData;
 
         // Map rectangle sides length to [-1,+1] space.
@@ -242,6 +321,9 @@ void ProjApp::Setup()
         memcpy(pAddr, vertexData.data(), dataSize);
         mVertexBuffer->UnmapMemory();
     }
+    else {
+        SetupMeshGeometry();
+    }
 
     // Descriptor pool
     {
@@ -363,14 +445,8 @@ void ProjApp::Render()
     // Wait for and reset image acquired fence
     PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
 
-    // Read query results
-    if (GetFrameCount() > 0) {
-        uint64_t data[2] = {0};
-        PPX_CHECKED_CALL(frame.timestampQuery->GetData(data, 2 * sizeof(uint64_t)));
-        mGpuWorkDuration = data[1] - data[0];
-    }
-    // Reset queries
-    frame.timestampQuery->Reset(0, 2);
+    // Read the previous frame's GPU scopes, the fence wait above made them available
+    GetGpuProfiler()->BeginFrame(0);
 
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
@@ -391,23 +467,29 @@ void ProjApp::Render()
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
         frame.cmd->BeginRenderPass(&beginInfo);
         {
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+            GetGpuProfiler()->BeginScope(frame.cmd, "draw");
             frame.cmd->SetScissors(1, &mScissorRect);
             frame.cmd->SetViewports(1, &mViewport);
             frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mDescriptorSet);
             frame.cmd->BindGraphicsPipeline(mPipeline);
             frame.cmd->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
 
-            for (uint32_t d = 0; d < mNumLayers; ++d) {
-                // If we're drawing back-to-front, start from mNumLayers - 1.
-                uint32_t numLayer = mDrawFrontToBack ? d : (mNumLayers - 1 - d);
-                frame.cmd->Draw(6, 1, numLayer * 6, 0);
+            if (mIndexCount > 0) {
+                frame.cmd->BindIndexBuffer(mIndexBuffer, grfx::INDEX_TYPE_UINT32);
+                frame.cmd->DrawIndexed(mIndexCount);
+            }
+            else {
+                for (uint32_t d = 0; d < mNumLayers; ++d) {
+                    // If we're drawing back-to-front, start from mNumLayers - 1.
+                    uint32_t numLayer = mDrawFrontToBack ? d : (mNumLayers - 1 - d);
+                    frame.cmd->Draw(6, 1, numLayer * 6, 0);
+                }
             }
 
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+            GetGpuProfiler()->EndScope(frame.cmd);
         }
         frame.cmd->EndRenderPass();
-        frame.cmd->ResolveQueryData(frame.timestampQuery, 0, 2);
+        GetGpuProfiler()->EndFrame(frame.cmd);
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
     }
     PPX_CHECKED_CALL(frame.cmd->End());
@@ -424,10 +506,8 @@ void ProjApp::Render()
     PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
 
     PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
-    if (GetFrameCount() > 0) {
-        uint64_t frequency = 0;
-        GetGraphicsQueue()->GetTimestampFrequency(&frequency);
-        const float      gpuWorkDurationMs = static_cast<float>(mGpuWorkDuration / static_cast<double>(frequency)) * 1000.0f;
+    if (GetGpuProfiler()->GetScopesFrameNumber() > 0) {
+        const float      gpuWorkDurationMs = static_cast<float>(GetGpuProfiler()->GetScopes()[0].gpuMs);
         PerFrameRegister stats             = {};
         stats.frameNumber                  = GetFrameCount();
         stats.gpuWorkDurationMs            = gpuWorkDurationMs;
@@ -0,0 +1,552 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+enum Operation
+{
+    OPERATION_SCAN    = 0,
+    OPERATION_COMPACT = 1,
+    OPERATION_SORT    = 2,
+};
+
+static const char* kOperationNames[] = {"scan", "compact", "sort"};
+
+struct KeyCount
+{
+    const char* name;
+    uint32_t    count;
+};
+
+static const KeyCount kKeyCounts[] = {
+    {"64K", 1u << 16},
+    {"256K", 1u << 18},
+    {"1M", 1u << 20},
+    {"4M", 1u << 22},
+    {"16M", 1u << 24},
+};
+
+// Measures the GPU throughput of grfx::ParallelPrimitives: exclusive scan,
+// compaction of half the keys and 32 bit key-value radix sort of random
+// keys, at key counts up to --max-keys. Each case is measured for --samples
+// frames after a warmup frame, each frame running the operation --repeats
+// times, and recorded as a "<operation>_<count>" gauge in millions of keys
+// per second. Every repeat is timed on its own, so the copy that restores
+// the unsorted keys before each sort isn't included. --validate checks the
+// results of all three operations against the CPU before measuring.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Shutdown() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct Case
+    {
+        Operation         operation   = OPERATION_SCAN;
+        uint32_t          count       = 0;
+        std::string       name        = "";
+        metrics::MetricID metricId    = metrics::kInvalidMetricID;
+        double            totalMkeys  = 0.0; // Of the samples since the last log
+        uint32_t          sampleCount = 0;
+    };
+
+    void SetupCases();
+    void CreateBuffers();
+    void UploadBuffer(grfx::Buffer* pBuffer, const std::vector<uint32_t>& data);
+    void RecordOperation(grfx::CommandBuffer* pCmd, Operation operation, uint32_t count);
+    void ReadBack(Operation operation, uint32_t count, std::vector<uint32_t>* pResult, std::vector<uint32_t>* pValues, uint32_t* pCount);
+    bool Validate(uint32_t count);
+    void FinishSample(Case& c, uint64_t ticks, uint32_t repeatCount);
+
+private:
+    std::shared_ptr<KnobFlag<int>>  pMaxKeys;
+    std::shared_ptr<KnobFlag<int>>  pRepeats;
+    std::shared_ptr<KnobFlag<int>>  pSamples;
+    std::shared_ptr<KnobFlag<int>>  pPasses;
+    std::shared_ptr<KnobFlag<bool>> pSubgroupOps;
+    std::shared_ptr<KnobFlag<bool>> pValidate;
+
+    std::unique_ptr<grfx::ParallelPrimitives> mPrimitives;
+
+    std::vector<uint32_t> mSourceKeys;  // Random keys
+    std::vector<uint32_t> mSourceFlags; // One in two set
+
+    grfx::BufferPtr mSourceKeysBuffer;
+    grfx::BufferPtr mFlagsBuffer;
+    grfx::BufferPtr mKeysBuffer;
+    grfx::BufferPtr mValuesBuffer;
+    grfx::BufferPtr mTempKeysBuffer;
+    grfx::BufferPtr mTempValuesBuffer;
+    grfx::BufferPtr mCountBuffer;
+    grfx::BufferPtr mReadbackBuffer;
+
+    grfx::CommandBufferPtr mCommandBuffer;
+    grfx::FencePtr         mFence;
+    grfx::QueryPtr         mTimestampQuery;
+
+    std::vector<Case> mCases;
+    uint32_t          mCaseIndex   = 0;
+    uint32_t          mFrameInCase = 0; // The first frame of a case is a warmup
+    uint32_t          mPass        = 0; // Over all cases
+    uint32_t          mRepeatCount = 0; // Of the submitted frame, 0 if nothing is in flight
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pMaxKeys, "max-keys", 1 << 22);
+    pMaxKeys->SetFlagDescription("Largest key count measured, from 64K (65536) to 16M (16777216) keys.");
+    pMaxKeys->SetValidator([](int value) { return (value >= static_cast<int>(kKeyCounts[0].count)) && (value <= static_cast<int>(kKeyCounts[CountU32(kKeyCounts) - 1].count)); });
+
+    GetKnobManager().InitKnob(&pRepeats, "repeats", 4);
+    pRepeats->SetFlagDescription("Number of times each operation runs per frame, averaged into each sample.");
+    pRepeats->SetValidator([](int value) { return (value >= 1) && (value <= 64); });
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each case is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all cases are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+
+    GetKnobManager().InitKnob(&pSubgroupOps, "subgroup-ops", true);
+    pSubgroupOps->SetFlagDescription("Use the subgroup kernels if the GPU supports them.");
+
+    GetKnobManager().InitKnob(&pValidate, "validate", false);
+    pValidate->SetFlagDescription("Check the results of all operations against the CPU at the largest key count before measuring.");
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "parallel_primitives";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    const uint32_t maxKeys = static_cast<uint32_t>(pMaxKeys->GetValue());
+    for (uint32_t operation = 0; operation < CountU32(kOperationNames); ++operation) {
+        for (const KeyCount& keyCount : kKeyCounts) {
+            if (keyCount.count > maxKeys) {
+                break;
+            }
+
+            Case c      = {};
+            c.operation = static_cast<Operation>(operation);
+            c.count     = keyCount.count;
+            c.name      = std::string(kOperationNames[operation]) + "_" + keyCount.name;
+            mCases.push_back(c);
+        }
+    }
+}
+
+void ProjApp::CreateBuffers()
+{
+    const uint32_t maxKeys = static_cast<uint32_t>(pMaxKeys->GetValue());
+
+    grfx::BufferCreateInfo bufferCreateInfo             = {};
+    bufferCreateInfo.size                               = maxKeys * sizeof(uint32_t);
+    bufferCreateInfo.structuredElementStride            = sizeof(uint32_t);
+    bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+    bufferCreateInfo.usageFlags.bits.transferSrc        = true;
+    bufferCreateInfo.usageFlags.bits.transferDst        = true;
+    bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+    bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mSourceKeysBuffer));
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mFlagsBuffer));
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mKeysBuffer));
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mValuesBuffer));
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mTempKeysBuffer));
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mTempValuesBuffer));
+
+    bufferCreateInfo.size = sizeof(uint32_t);
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mCountBuffer));
+
+    // Keys and values of the sort
+    grfx::BufferCreateInfo readbackCreateInfo      = {};
+    readbackCreateInfo.size                        = 2 * maxKeys * sizeof(uint32_t);
+    readbackCreateInfo.usageFlags.bits.transferDst = true;
+    readbackCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+    readbackCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&readbackCreateInfo, &mReadbackBuffer));
+
+    // Keys spread over all 32 bits so every sort pass moves them
+    std::mt19937 random(0x5EED);
+    mSourceKeys.resize(maxKeys);
+    mSourceFlags.resize(maxKeys);
+    for (uint32_t i = 0; i < maxKeys; ++i) {
+        mSourceKeys[i]  = static_cast<uint32_t>(random());
+        mSourceFlags[i] = (random() & 1);
+    }
+
+    std::vector<uint32_t> values(maxKeys);
+    std::iota(values.begin(), values.end(), 0);
+
+    UploadBuffer(mSourceKeysBuffer, mSourceKeys);
+    UploadBuffer(mFlagsBuffer, mSourceFlags);
+    UploadBuffer(mValuesBuffer, values);
+}
+
+void ProjApp::UploadBuffer(grfx::Buffer* pBuffer, const std::vector<uint32_t>& data)
+{
+    const uint32_t size = static_cast<uint32_t>(data.size() * sizeof(uint32_t));
+
+    grfx::BufferCreateInfo stagingCreateInfo      = {};
+    stagingCreateInfo.size                        = size;
+    stagingCreateInfo.usageFlags.bits.transferSrc = true;
+    stagingCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+    grfx::BufferPtr staging;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&stagingCreateInfo, &staging));
+    PPX_CHECKED_CALL(staging->CopyFromSource(size, data.data()));
+
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = size;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->CopyBufferToBuffer(&copyInfo, staging, pBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_UNORDERED_ACCESS));
+
+    GetDevice()->DestroyBuffer(staging);
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    // Kernels
+    {
+        grfx::ShaderModulePtr scanReduce, scanDownsweep, compactScatter, radixHistogram, radixScatter;
+        grfx::ShaderModulePtr scanReduceSubgroup, scanDownsweepSubgroup, radixScatterSubgroup;
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "ScanReduce.cs", &scanReduce));
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "ScanDownsweep.cs", &scanDownsweep));
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "CompactScatter.cs", &compactScatter));
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "RadixHistogram.cs", &radixHistogram));
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "RadixScatter.cs", &radixScatter));
+
+        grfx::ParallelPrimitivesCreateInfo createInfo = {};
+        createInfo.shaders.pScanReduce                = scanReduce;
+        createInfo.shaders.pScanDownsweep             = scanDownsweep;
+        createInfo.shaders.pCompactScatter            = compactScatter;
+        createInfo.shaders.pRadixHistogram            = radixHistogram;
+        createInfo.shaders.pRadixScatter              = radixScatter;
+        createInfo.maxElementCount                    = static_cast<uint32_t>(pMaxKeys->GetValue());
+
+        if (pSubgroupOps->GetValue() && grfx::ParallelPrimitives::SupportsSubgroupOps(GetDevice())) {
+            PPX_CHECKED_CALL(CreateShader("basic/shaders", "ScanReduceSubgroup.cs", &scanReduceSubgroup));
+            PPX_CHECKED_CALL(CreateShader("basic/shaders", "ScanDownsweepSubgroup.cs", &scanDownsweepSubgroup));
+            PPX_CHECKED_CALL(CreateShader("basic/shaders", "RadixScatterSubgroup.cs", &radixScatterSubgroup));
+
+            createInfo.subgroupShaders                = createInfo.shaders;
+            createInfo.subgroupShaders.pScanReduce    = scanReduceSubgroup;
+            createInfo.subgroupShaders.pScanDownsweep = scanDownsweepSubgroup;
+            createInfo.subgroupShaders.pRadixScatter  = radixScatterSubgroup;
+        }
+
+        grfx::ParallelPrimitives* pPrimitives = nullptr;
+        PPX_CHECKED_CALL(grfx::ParallelPrimitives::Create(GetDevice(), createInfo, &pPrimitives));
+        mPrimitives.reset(pPrimitives);
+
+        for (grfx::ShaderModulePtr shader : {scanReduce, scanDownsweep, compactScatter, radixHistogram, radixScatter, scanReduceSubgroup, scanDownsweepSubgroup, radixScatterSubgroup}) {
+            if (!shader.IsNull()) {
+                GetDevice()->DestroyShaderModule(shader);
+            }
+        }
+    }
+
+    CreateBuffers();
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2 * static_cast<uint32_t>(pRepeats->GetValue());
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    if (pValidate->GetValue()) {
+        const uint32_t count = mCases.back().count;
+        if (!Validate(count)) {
+            PPX_LOG_ERROR("Validation failed, quitting");
+            Quit();
+            return;
+        }
+        PPX_LOG_INFO("Validated scan, compact and sort of " << count << " keys");
+    }
+
+    PPX_LOG_INFO("Measuring " << mCases.size() << " parallel primitive cases" << (mPrimitives->UsesSubgroupOps() ? " with subgroup ops" : ""));
+}
+
+void ProjApp::Shutdown()
+{
+    mPrimitives.reset();
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name, "Mkeys/s", metrics::MetricInterpretation::HIGHER_IS_BETTER};
+        c.metricId                       = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.metricId != metrics::kInvalidMetricID, "Failed to add metric " << c.name);
+    }
+}
+
+void ProjApp::RecordOperation(grfx::CommandBuffer* pCmd, Operation operation, uint32_t count)
+{
+    switch (operation) {
+        case OPERATION_SCAN: {
+            PPX_CHECKED_CALL(mPrimitives->RecordScan(pCmd, mSourceKeysBuffer, mTempKeysBuffer, count));
+        } break;
+
+        case OPERATION_COMPACT: {
+            PPX_CHECKED_CALL(mPrimitives->RecordCompact(pCmd, mSourceKeysBuffer, mFlagsBuffer, mTempKeysBuffer, mCountBuffer, count));
+        } break;
+
+        case OPERATION_SORT: {
+            PPX_CHECKED_CALL(mPrimitives->RecordSort(pCmd, mKeysBuffer, mValuesBuffer, mTempKeysBuffer, mTempValuesBuffer, count));
+        } break;
+    }
+}
+
+// Restores the unsorted keys, outside of the timestamps
+static void RecordRestoreKeys(grfx::CommandBuffer* pCmd, grfx::Buffer* pSource, grfx::Buffer* pKeys, uint32_t count)
+{
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = count * sizeof(uint32_t);
+
+    pCmd->BufferResourceBarrier(pSource, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+    pCmd->BufferResourceBarrier(pKeys, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_DST);
+    pCmd->CopyBufferToBuffer(&copyInfo, pSource, pKeys);
+    pCmd->BufferResourceBarrier(pSource, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->BufferResourceBarrier(pKeys, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
+void ProjApp::ReadBack(Operation operation, uint32_t count, std::vector<uint32_t>* pResult, std::vector<uint32_t>* pValues, uint32_t* pCount)
+{
+    // The result is in the keys for the sort and the temp keys otherwise
+    grfx::Buffer* pResultBuffer = (operation == OPERATION_SORT) ? mKeysBuffer.Get() : mTempKeysBuffer.Get();
+
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        if (operation == OPERATION_SORT) {
+            RecordRestoreKeys(mCommandBuffer, mSourceKeysBuffer, mKeysBuffer, count);
+        }
+        RecordOperation(mCommandBuffer, operation, count);
+
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = count * sizeof(uint32_t);
+        mCommandBuffer->BufferResourceBarrier(pResultBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+        mCommandBuffer->CopyBufferToBuffer(&copyInfo, pResultBuffer, mReadbackBuffer);
+        mCommandBuffer->BufferResourceBarrier(pResultBuffer, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+
+        if (!IsNull(pValues)) {
+            copyInfo.dstBuffer.offset = count * sizeof(uint32_t);
+            mCommandBuffer->BufferResourceBarrier(mValuesBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+            mCommandBuffer->CopyBufferToBuffer(&copyInfo, mValuesBuffer, mReadbackBuffer);
+            mCommandBuffer->BufferResourceBarrier(mValuesBuffer, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    PPX_CHECKED_CALL(mFence->Wait());
+
+    // Values follow the result in the readback buffer
+    std::vector<uint32_t> readback(IsNull(pValues) ? count : 2 * count);
+    PPX_CHECKED_CALL(mReadbackBuffer->CopyToDest(static_cast<uint32_t>(readback.size() * sizeof(uint32_t)), readback.data()));
+    pResult->assign(readback.begin(), readback.begin() + count);
+    if (!IsNull(pValues)) {
+        pValues->assign(readback.begin() + count, readback.end());
+    }
+
+    if (!IsNull(pCount)) {
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = sizeof(uint32_t);
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CopyBufferToBuffer(&copyInfo, mCountBuffer, mReadbackBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_COPY_DST));
+        PPX_CHECKED_CALL(mReadbackBuffer->CopyToDest(sizeof(uint32_t), pCount));
+    }
+}
+
+bool ProjApp::Validate(uint32_t count)
+{
+    std::vector<uint32_t> result;
+
+    // Scan, wrapping like the GPU
+    ReadBack(OPERATION_SCAN, count, &result, nullptr, nullptr);
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (result[i] != sum) {
+            PPX_LOG_ERROR("Scan mismatch at " << i << ": " << result[i] << " != " << sum);
+            return false;
+        }
+        sum += mSourceKeys[i];
+    }
+
+    // Compaction
+    uint32_t compactCount = 0;
+    ReadBack(OPERATION_COMPACT, count, &result, nullptr, &compactCount);
+    uint32_t expectedCount = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        if (mSourceFlags[i] == 0) {
+            continue;
+        }
+        if (result[expectedCount] != mSourceKeys[i]) {
+            PPX_LOG_ERROR("Compaction mismatch at " << expectedCount << ": " << result[expectedCount] << " != " << mSourceKeys[i]);
+            return false;
+        }
+        ++expectedCount;
+    }
+    if (compactCount != expectedCount) {
+        PPX_LOG_ERROR("Compaction count mismatch: " << compactCount << " != " << expectedCount);
+        return false;
+    }
+
+    // Sort, the values start as the indices of the keys so a stable sort
+    // of the indices by key gives the expected values
+    std::vector<uint32_t> expected(count);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [this](uint32_t a, uint32_t b) { return mSourceKeys[a] < mSourceKeys[b]; });
+
+    std::vector<uint32_t> values;
+    ReadBack(OPERATION_SORT, count, &result, &values, nullptr);
+    for (uint32_t i = 0; i < count; ++i) {
+        if ((result[i] != mSourceKeys[expected[i]]) || (values[i] != expected[i])) {
+            PPX_LOG_ERROR("Sort mismatch at " << i << ": " << result[i] << " (" << values[i] << ") != " << mSourceKeys[expected[i]] << " (" << expected[i] << ")");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks, uint32_t repeatCount)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double seconds = static_cast<double>(ticks) / static_cast<double>(frequency) / repeatCount;
+    const double mkeys   = static_cast<double>(c.count) / seconds / 1e6;
+    c.totalMkeys += mkeys;
+    ++c.sampleCount;
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = mkeys;
+    RecordMetricData(c.metricId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        PPX_LOG_INFO(c.name << ": " << (c.totalMkeys / c.sampleCount) << " Mkeys/s");
+        c.totalMkeys  = 0.0;
+        c.sampleCount = 0;
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mRepeatCount > 0) {
+        std::vector<uint64_t> timestamps(2 * mRepeatCount, 0);
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps.data(), timestamps.size() * sizeof(uint64_t)));
+        if (mFrameInCase > 0) {
+            uint64_t ticks = 0;
+            for (uint32_t i = 0; i < mRepeatCount; ++i) {
+                ticks += timestamps[2 * i + 1] - timestamps[2 * i];
+            }
+            FinishSample(mCases[mCaseIndex], ticks, mRepeatCount);
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    const Case& c = mCases[mCaseIndex];
+    mRepeatCount  = static_cast<uint32_t>(pRepeats->GetValue());
+
+    mTimestampQuery->Reset(0, 2 * mRepeatCount);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        for (uint32_t i = 0; i < mRepeatCount; ++i) {
+            if (c.operation == OPERATION_SORT) {
+                RecordRestoreKeys(mCommandBuffer, mSourceKeysBuffer, mKeysBuffer, c.count);
+            }
+            mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 2 * i);
+            RecordOperation(mCommandBuffer, c.operation, c.count);
+            mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2 * i + 1);
+        }
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2 * mRepeatCount);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+}
+
+SETUP_APPLICATION(ProjApp)
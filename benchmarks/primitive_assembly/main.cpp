@@ -17,6 +17,7 @@
 
 #include "ppx/ppx.h"
 #include "ppx/csv_file_log.h"
+#include "ppx/meshlet.h"
 
 using namespace ppx;
 
@@ -26,6 +27,20 @@ const grfx::Api kApi = grfx::API_DX_12_0;
 const grfx::Api kApi = grfx::API_VK_1_1;
 #endif
 
+// Per dimension limit of DrawMeshTasks() guaranteed by both APIs
+static const uint32_t kMaxMeshGroupCountX = 65535;
+
+// Must match PassThroughPosMesh.hlsl
+static const uint32_t kMeshletMaxVertices  = 64;
+static const uint32_t kMeshletMaxTriangles = 124;
+
+static void LogVertexCacheStats(const char* pOrder, const TriMesh& mesh)
+{
+    const uint32_t*  pIndices = mesh.GetDataIndicesU32();
+    VertexCacheStats stats    = AnalyzeVertexCache(pIndices, mesh.GetCountIndices(), mesh.GetCountPositions());
+    PPX_LOG_INFO(pOrder << ": " << stats.vertexShaderInvocations << " vertex shader invocations (ACMR " << stats.acmr << ", ATVR " << stats.atvr << ")");
+}
+
 class ProjApp
     : public ppx::Application
 {
@@ -47,24 +62,49 @@ private:
         ppx::grfx::QueryPtr         pipelineStatsQuery;
     };
 
-    std::vector<PerFrame>           mPerFrame;
-    ppx::grfx::ShaderModulePtr      mVS;
-    ppx::grfx::ShaderModulePtr      mPS;
-    ppx::grfx::PipelineInterfacePtr mPipelineInterface;
-    ppx::grfx::GraphicsPipelinePtr  mPipeline;
-    ppx::grfx::BufferPtr            mVertexBuffer;
-    grfx::DrawPassPtr               mDrawPass;
-    grfx::Viewport                  mViewport;
-    grfx::Rect                      mScissorRect;
-    grfx::VertexBinding             mVertexBinding;
-    uint2                           mRenderTargetSize;
-    uint32_t                        mNumTriangles;
-    std::string                     mCSVFileName;
-    uint64_t                        mGpuWorkDuration    = 0;
-    bool                            mUsePipelineQuery   = false;
-    grfx::PipelineStatistics        mPipelineStatistics = {};
-
-    void SetupTestParameters();
+    struct MeshDrawParams
+    {
+        uint32_t meshletCount;
+        uint32_t groupCountX;
+    };
+
+    std::vector<PerFrame>             mPerFrame;
+    ppx::grfx::ShaderModulePtr        mVS;
+    ppx::grfx::ShaderModulePtr        mMS;
+    ppx::grfx::ShaderModulePtr        mPS;
+    ppx::grfx::DescriptorPoolPtr      mDescriptorPool;
+    ppx::grfx::DescriptorSetLayoutPtr mDescriptorSetLayout;
+    ppx::grfx::DescriptorSetPtr       mDescriptorSet;
+    ppx::grfx::PipelineInterfacePtr   mPipelineInterface;
+    ppx::grfx::GraphicsPipelinePtr    mPipeline;
+    ppx::grfx::BufferPtr              mVertexBuffer;
+    ppx::grfx::BufferPtr              mIndexBuffer;
+    ppx::grfx::BufferPtr              mMeshletBuffer;
+    ppx::grfx::BufferPtr              mMeshletVertexBuffer;
+    ppx::grfx::BufferPtr              mMeshletTriangleBuffer;
+    grfx::DrawPassPtr                 mDrawPass;
+    grfx::Viewport                    mViewport;
+    grfx::Rect                        mScissorRect;
+    grfx::VertexBinding               mVertexBinding;
+    uint2                             mRenderTargetSize;
+    uint32_t                          mNumTriangles;
+    uint32_t                          mIndexCount     = 0;
+    MeshDrawParams                    mMeshDrawParams = {};
+    std::string                       mCSVFileName;
+    uint64_t                          mGpuWorkDuration    = 0;
+    bool                              mUsePipelineQuery   = false;
+    bool                              mUseMeshShader      = false;
+    bool                              mOptimizeMesh       = false;
+    std::string                       mMeshPath;
+    grfx::PipelineStatistics          mPipelineStatistics = {};
+
+    void    SetupTestParameters();
+    TriMesh CreateTestMesh();
+    void SetupGeometry(const TriMesh& mesh);
+    void SetupMeshletGeometry(const TriMesh& mesh);
+    void SetupVertexPipeline();
+    void SetupMeshPipeline();
+    void CreateBuffer(const void* pData, uint32_t size, grfx::BufferUsageFlags usageFlags, uint32_t stride, grfx::ResourceState initialState, grfx::BufferPtr* pBuffer);
 
     struct PerFrameRegister
     {
@@ -128,6 +168,194 @@ void ProjApp::SetupTestParameters()
 
     // Whether to use pipeline statistics queries.
     mUsePipelineQuery = cl_options.HasExtraOption("use-pipeline-query");
+
+    // Whether to draw meshlets with a mesh shader instead of the vertex pipeline.
+    mUseMeshShader = cl_options.HasExtraOption("use-mesh-shader");
+
+    // OBJ mesh to draw instead of the grid, and whether to reorder it for
+    // the vertex cache. Run with and without optimize-mesh to compare.
+    mMeshPath     = cl_options.GetExtraOptionValueOrDefault<std::string>("mesh", "");
+    mOptimizeMesh = cl_options.HasExtraOption("optimize-mesh");
+}
+
+TriMesh ProjApp::CreateTestMesh()
+{
+    TriMesh mesh;
+    if (mMeshPath.empty()) {
+        // A segments x segments grid has 2 * segments^2 triangles
+        uint32_t segments = std::max<uint32_t>(1, static_cast<uint32_t>(std::round(std::sqrt(mNumTriangles / 2.0))));
+        mesh              = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Z, float2(1, 1), segments, segments, TriMeshOptions().Indices());
+    }
+    else {
+        // OBJ corners are separate vertices, share them so there's something to reuse
+        mesh = TriMesh::CreateFromOBJ(GetAssetPath(mMeshPath), TriMeshOptions().Indices());
+        mesh.WeldVertices();
+    }
+    LogVertexCacheStats("Source order", mesh);
+
+    if (mOptimizeMesh) {
+        MeshOptimizeOptions options = {};
+        options.vertexCache         = true;
+        options.vertexFetch         = true;
+        mesh.Optimize(options);
+        LogVertexCacheStats("Optimized order", mesh);
+    }
+    return mesh;
+}
+
+void ProjApp::CreateBuffer(const void* pData, uint32_t size, grfx::BufferUsageFlags usageFlags, uint32_t stride, grfx::ResourceState initialState, grfx::BufferPtr* pBuffer)
+{
+    grfx::BufferCreateInfo bufferCreateInfo  = {};
+    bufferCreateInfo.size                    = size;
+    bufferCreateInfo.usageFlags              = usageFlags;
+    bufferCreateInfo.memoryUsage             = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    bufferCreateInfo.initialState            = initialState;
+    bufferCreateInfo.structuredElementStride = stride;
+
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, pBuffer));
+
+    void* pAddr = nullptr;
+    PPX_CHECKED_CALL((*pBuffer)->MapMemory(0, &pAddr));
+    memcpy(pAddr, pData, size);
+    (*pBuffer)->UnmapMemory();
+}
+
+void ProjApp::SetupGeometry(const TriMesh& mesh)
+{
+    grfx::BufferUsageFlags usageFlags = {};
+    usageFlags.bits.vertexBuffer      = true;
+    CreateBuffer(mesh.GetDataPositions(), static_cast<uint32_t>(mesh.GetDataSizePositions()), usageFlags, 0, grfx::RESOURCE_STATE_VERTEX_BUFFER, &mVertexBuffer);
+
+    usageFlags                  = {};
+    usageFlags.bits.indexBuffer = true;
+    CreateBuffer(mesh.GetDataIndicesU32(), static_cast<uint32_t>(mesh.GetDataSizeIndices()), usageFlags, 0, grfx::RESOURCE_STATE_INDEX_BUFFER, &mIndexBuffer);
+
+    mIndexCount = mesh.GetCountIndices();
+}
+
+void ProjApp::SetupMeshletGeometry(const TriMesh& mesh)
+{
+    PPX_ASSERT_MSG(GetDevice()->MeshShaderSupported(), "use-mesh-shader requires mesh shader support");
+
+    MeshletMesh meshlets;
+    PPX_CHECKED_CALL(MeshletMesh::Create(mesh, kMeshletMaxVertices, kMeshletMaxTriangles, &meshlets));
+    PPX_LOG_INFO("Built " << meshlets.GetCountMeshlets() << " meshlets");
+
+    grfx::BufferUsageFlags usageFlags  = {};
+    usageFlags.bits.roStructuredBuffer = true;
+    CreateBuffer(mesh.GetDataPositions(), static_cast<uint32_t>(mesh.GetDataSizePositions()), usageFlags, sizeof(float3), grfx::RESOURCE_STATE_SHADER_RESOURCE, &mVertexBuffer);
+    CreateBuffer(meshlets.GetMeshlets().data(), static_cast<uint32_t>(meshlets.GetCountMeshlets() * sizeof(Meshlet)), usageFlags, sizeof(Meshlet), grfx::RESOURCE_STATE_SHADER_RESOURCE, &mMeshletBuffer);
+    CreateBuffer(meshlets.GetVertexIndices().data(), static_cast<uint32_t>(meshlets.GetCountVertexIndices() * sizeof(uint32_t)), usageFlags, sizeof(uint32_t), grfx::RESOURCE_STATE_SHADER_RESOURCE, &mMeshletVertexBuffer);
+    CreateBuffer(meshlets.GetTriangles().data(), static_cast<uint32_t>(meshlets.GetCountTriangles() * sizeof(uint32_t)), usageFlags, sizeof(uint32_t), grfx::RESOURCE_STATE_SHADER_RESOURCE, &mMeshletTriangleBuffer);
+
+    mMeshDrawParams.meshletCount = meshlets.GetCountMeshlets();
+    mMeshDrawParams.groupCountX  = std::min(mMeshDrawParams.meshletCount, kMaxMeshGroupCountX);
+
+    // Descriptors
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.structuredBuffer               = 4;
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        for (uint32_t binding = 1; binding <= 4; ++binding) {
+            layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(binding, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_MS));
+        }
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mDescriptorSetLayout));
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDescriptorSetLayout, &mDescriptorSet));
+
+        const grfx::Buffer* buffers[4]       = {mMeshletBuffer, mVertexBuffer, mMeshletVertexBuffer, mMeshletTriangleBuffer};
+        const uint32_t      elementCounts[4] = {meshlets.GetCountMeshlets(), mesh.GetCountPositions(), meshlets.GetCountVertexIndices(), meshlets.GetCountTriangles()};
+
+        std::array<grfx::WriteDescriptor, 4> writes = {};
+        for (uint32_t i = 0; i < 4; ++i) {
+            writes[i].binding                = i + 1;
+            writes[i].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+            writes[i].bufferOffset           = 0;
+            writes[i].bufferRange            = PPX_WHOLE_SIZE;
+            writes[i].structuredElementCount = elementCounts[i];
+            writes[i].pBuffer                = buffers[i];
+        }
+        PPX_CHECKED_CALL(mDescriptorSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data()));
+    }
+}
+
+void ProjApp::SetupVertexPipeline()
+{
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", "PassThroughPos.vs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mVS));
+
+    bytecode = LoadShader("benchmarks/shaders", "PassThroughPos.ps");
+    PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mPS));
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 0;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = nullptr;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+    // TriMesh positions are float3, the missing w component reads as 1
+    mVertexBinding.AppendAttribute({"POSITION", 0, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+
+    grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+    gpCreateInfo.VS                                 = {mVS.Get(), "vsmain"};
+    gpCreateInfo.PS                                 = {mPS.Get(), "psmain"};
+    gpCreateInfo.vertexInputState.bindingCount      = 1;
+    gpCreateInfo.vertexInputState.bindings[0]       = mVertexBinding;
+    gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
+    gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.depthReadEnable                    = false;
+    gpCreateInfo.depthWriteEnable                   = false;
+    gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+    gpCreateInfo.outputState.renderTargetCount      = 1;
+    gpCreateInfo.outputState.renderTargetFormats[0] = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
+    gpCreateInfo.outputState.depthStencilFormat     = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
+    gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPipeline));
+}
+
+void ProjApp::SetupMeshPipeline()
+{
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", "PassThroughPosMesh.ms");
+    PPX_ASSERT_MSG(!bytecode.empty(), "MS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mMS));
+
+    bytecode = LoadShader("benchmarks/shaders", "PassThroughPos.ps");
+    PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mPS));
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mDescriptorSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(MeshDrawParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = 0;
+    piCreateInfo.pushConstants.set                 = 0;
+    piCreateInfo.pushConstants.shaderVisiblity     = grfx::SHADER_STAGE_MS;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+    grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+    gpCreateInfo.MS                                 = {mMS.Get(), "msmain"};
+    gpCreateInfo.PS                                 = {mPS.Get(), "psmain"};
+    gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
+    gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.depthReadEnable                    = false;
+    gpCreateInfo.depthWriteEnable                   = false;
+    gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+    gpCreateInfo.outputState.renderTargetCount      = 1;
+    gpCreateInfo.outputState.renderTargetFormats[0] = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
+    gpCreateInfo.outputState.depthStencilFormat     = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
+    gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPipeline));
 }
 
 void ProjApp::Setup()
@@ -157,43 +385,20 @@ void ProjApp::Setup()
 
         PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mDrawPass));
     }
-    // Pipeline
+    // Geometry and pipeline, both modes draw the same mesh
     {
-        std::vector<char> bytecode = LoadShader("benchmarks/shaders", "PassThroughPos.vs");
-        PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
-        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
-        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mVS));
-
-        bytecode = LoadShader("benchmarks/shaders", "PassThroughPos.ps");
-        PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
-        shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
-        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mPS));
-
-        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
-        piCreateInfo.setCount                          = 0;
-        piCreateInfo.sets[0].set                       = 0;
-        piCreateInfo.sets[0].pLayout                   = nullptr;
-        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
-
-        mVertexBinding.AppendAttribute({"POSITION", 0, grfx::FORMAT_R32G32B32A32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
-
-        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
-        gpCreateInfo.VS                                 = {mVS.Get(), "vsmain"};
-        gpCreateInfo.PS                                 = {mPS.Get(), "psmain"};
-        gpCreateInfo.vertexInputState.bindingCount      = 1;
-        gpCreateInfo.vertexInputState.bindings[0]       = mVertexBinding;
-        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
-        gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
-        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
-        gpCreateInfo.depthReadEnable                    = false;
-        gpCreateInfo.depthWriteEnable                   = false;
-        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
-        gpCreateInfo.outputState.renderTargetCount      = 1;
-        gpCreateInfo.outputState.renderTargetFormats[0] = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
-        gpCreateInfo.outputState.depthStencilFormat     = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
-        gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
-        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPipeline));
+        TriMesh mesh  = CreateTestMesh();
+        mNumTriangles = mesh.GetCountTriangles();
+        PPX_LOG_INFO("Drawing " << mNumTriangles << " triangles with the " << (mUseMeshShader ? "mesh shader" : "vertex") << " pipeline");
+
+        if (mUseMeshShader) {
+            SetupMeshletGeometry(mesh);
+            SetupMeshPipeline();
+        }
+        else {
+            SetupGeometry(mesh);
+            SetupVertexPipeline();
+        }
     }
 
     // Per frame data
@@ -229,32 +434,6 @@ void ProjApp::Setup()
         mPerFrame.push_back(frame);
     }
 
-    // Buffer and geometry data
-    {
-        // clang-format off
-        std::vector<float> vertexData = {
-            // position           
-             0.0f,  0.5f, 0.0f, 1.0f,
-            -0.5f, -0.5f, 0.0f, 1.0f,
-             0.5f, -0.5f, 0.0f, 1.0f,
-        };
-        // clang-format on
-        uint32_t dataSize = ppx::SizeInBytesU32(vertexData);
-
-        grfx::BufferCreateInfo bufferCreateInfo       = {};
-        bufferCreateInfo.size                         = dataSize;
-        bufferCreateInfo.usageFlags.bits.vertexBuffer = true;
-        bufferCreateInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
-        bufferCreateInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
-
-        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mVertexBuffer));
-
-        void* pAddr = nullptr;
-        PPX_CHECKED_CALL(mVertexBuffer->MapMemory(0, &pAddr));
-        memcpy(pAddr, vertexData.data(), dataSize);
-        mVertexBuffer->UnmapMemory();
-    }
-
     mViewport    = {0, 0, float(mRenderTargetSize.x), float(mRenderTargetSize.y), 0, 1};
     mScissorRect = {0, 0, mRenderTargetSize.x, mRenderTargetSize.y};
 }
@@ -298,13 +477,26 @@ void ProjApp::Render()
             frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
             frame.cmd->SetScissors(1, &mScissorRect);
             frame.cmd->SetViewports(1, &mViewport);
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
             frame.cmd->BindGraphicsPipeline(mPipeline);
-            frame.cmd->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
+            if (mUseMeshShader) {
+                frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mDescriptorSet);
+                frame.cmd->PushGraphicsConstants(mPipelineInterface, sizeof(MeshDrawParams) / sizeof(uint32_t), &mMeshDrawParams);
+            }
+            else {
+                frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
+                frame.cmd->BindIndexBuffer(mIndexBuffer, grfx::INDEX_TYPE_UINT32);
+                frame.cmd->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
+            }
             if (mUsePipelineQuery) {
                 frame.cmd->BeginQuery(frame.pipelineStatsQuery, 0);
             }
-            frame.cmd->Draw(3, mNumTriangles, 0, 0);
+            if (mUseMeshShader) {
+                uint32_t groupCountY = (mMeshDrawParams.meshletCount + mMeshDrawParams.groupCountX - 1) / mMeshDrawParams.groupCountX;
+                frame.cmd->DrawMeshTasks(mMeshDrawParams.groupCountX, groupCountY);
+            }
+            else {
+                frame.cmd->DrawIndexed(mIndexCount);
+            }
             if (mUsePipelineQuery) {
                 frame.cmd->EndQuery(frame.pipelineStatsQuery, 0);
             }
@@ -0,0 +1,851 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+#include "ppx/graphics_util.h"
+#include "ppx/scene/scene_gltf_loader.h"
+#include "ppx/scene/scene_material.h"
+#include "ppx/scene/scene_mesh.h"
+#include "ppx/scene/scene_occlusion_predicates.h"
+#include "ppx/scene/scene_pipeline_args.h"
+#include "ppx/scene/scene_render_queue.h"
+#include "ppx/scene/scene_scene.h"
+#include "ppx/scene/scene_texture_streamer.h"
+
+#include <thread>
+#include <unordered_map>
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+// Renders a glTF scene loaded with scene::GltfLoader along a deterministic
+// camera path, as an end to end measure of the scene level optimizations.
+// The camera orbits the scene's bounds once every --path-frames frames at
+// --camera-distance times their radius, so frame n always has the same view
+// and runs on the same scene are comparable. Frustum culling (through the
+// scene's bounding volume hierarchy), instancing of mesh nodes sharing a
+// mesh and draw sorting can each be turned off to measure what they save.
+// --occlusion-predicates skips the draws of large mesh nodes occluded in the
+// previous frame on the GPU, see scene::OcclusionPredicates.
+//
+// Every frame after the first records gauges of:
+//   - cpu_record_time: culling, building the render queue and recording the
+//     command buffer, in ms
+//   - gpu_time: the frame's command buffer, in ms
+//   - draws, triangles
+//   - pipeline_binds
+//   - state_changes: pipeline binds, push constant updates and vertex and
+//     index buffer binds
+//   - predicated_draws: draws made conditional on occlusion predicates
+// The scene is rendered headless into a render target at the window
+// resolution (--resolution). Animations aren't applied and skinned meshes are
+// drawn in their bind pose.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Shutdown() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct FrameStats
+    {
+        uint32_t draws         = 0;
+        uint64_t triangles     = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t stateChanges  = 0;
+        uint32_t predicated    = 0;
+    };
+
+    void SetupScene();
+    void UpdateTextureStreaming();
+    void SetupPipelineArgs();
+    void SetupPipelines();
+    void SetupOcclusionPredicates();
+    void UpdateCamera();
+    void BuildRenderQueue();
+    void RecordDepthPrepass(grfx::CommandBuffer* pCmd, FrameStats* pStats);
+    void RecordDraws(grfx::CommandBuffer* pCmd, FrameStats* pStats);
+    void RecordMetric(metrics::MetricID id, double value);
+
+private:
+    std::shared_ptr<KnobFlag<std::string>> pSceneAsset;
+    std::shared_ptr<KnobFlag<std::string>> pSceneCacheDir;
+    std::shared_ptr<KnobFlag<bool>>        pVertexQuantization;
+    std::shared_ptr<KnobFlag<bool>>        pFrustumCulling;
+    std::shared_ptr<KnobFlag<bool>>        pInstancing;
+    std::shared_ptr<KnobFlag<bool>>        pSortDraws;
+    std::shared_ptr<KnobFlag<bool>>        pDepthPrepass;
+    std::shared_ptr<KnobFlag<bool>>        pOcclusionPredicates;
+    std::shared_ptr<KnobFlag<float>>       pOcclusionMinSize;
+    std::shared_ptr<KnobFlag<float>>       pCameraDistance;
+    std::shared_ptr<KnobFlag<int>>         pPathFrames;
+    std::shared_ptr<KnobFlag<int>>         pLaps;
+    std::shared_ptr<KnobFlag<int>>         pTextureStreamingBudget;
+
+    grfx::CommandBufferPtr     mCommandBuffer;
+    grfx::FencePtr             mFence;
+    grfx::QueryPtr             mTimestampQuery;
+    grfx::DrawPassPtr          mDrawPass;
+    grfx::PipelineInterfacePtr mPipelineInterface;
+    grfx::GraphicsPipelinePtr  mStandardMaterialPipeline;
+    grfx::GraphicsPipelinePtr  mUnlitMaterialPipeline;
+    grfx::GraphicsPipelinePtr  mErrorMaterialPipeline;
+    grfx::GraphicsPipelinePtr  mDepthPrepassPipeline;
+    grfx::TexturePtr           mIBLIrrMap;
+    grfx::TexturePtr           mIBLEnvMap;
+
+    scene::Scene*                mScene               = nullptr;
+    scene::MaterialPipelineArgs* mPipelineArgs        = nullptr;
+    scene::OcclusionPredicates*  mOcclusionPredicates = nullptr;
+    scene::TextureStreamer*      mTextureStreamer     = nullptr;
+
+    // Mesh nodes of a group use consecutive instance params, starting at
+    // the group's first instance
+    std::vector<scene::MeshInstanceGroup>                mInstanceGroups;
+    std::vector<uint32_t>                                mInstanceGroupFirstInstances;
+    std::unordered_map<const scene::MeshNode*, uint32_t> mNodeInstances;
+    std::vector<uint8_t>                                 mVisibleInstances; // One per instance
+    std::vector<const scene::MeshNode*>                  mVisibleNodes;     // Of the frustum query
+    std::vector<uint32_t>                                mInstanceObjects;  // Occlusion predicate object per instance, UINT32_MAX if none
+
+    std::unordered_map<const scene::Material*, uint32_t>                mMaterialIndexMap;
+    std::unordered_map<const scene::Material*, grfx::GraphicsPipeline*> mMaterialPipelineMap;
+    std::unordered_map<const grfx::GraphicsPipeline*, uint32_t>         mPipelineSortIndexMap;
+    scene::RenderQueue                                                  mRenderQueue;
+
+    PerspCamera mCamera;
+    float3      mSceneCenter = float3(0);
+    float       mSceneRadius = 1.0f;
+    uint32_t    mFrame       = 0;
+    bool        mInFlight    = false;
+
+    metrics::MetricID mCpuRecordTimeMetric = metrics::kInvalidMetricID;
+    metrics::MetricID mGpuTimeMetric       = metrics::kInvalidMetricID;
+    metrics::MetricID mGpuPrepassMetric    = metrics::kInvalidMetricID;
+    metrics::MetricID mDrawMetric          = metrics::kInvalidMetricID;
+    metrics::MetricID mTriangleMetric      = metrics::kInvalidMetricID;
+    metrics::MetricID mPipelineBindMetric  = metrics::kInvalidMetricID;
+    metrics::MetricID mStateChangeMetric   = metrics::kInvalidMetricID;
+    metrics::MetricID mPredicatedMetric    = metrics::kInvalidMetricID;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pSceneAsset, "gltf-scene-asset", "scene_renderer/scenes/tests/gltf_test_basic_materials.glb");
+    pSceneAsset->SetFlagDescription("GLTF asset to load and render.");
+
+    GetKnobManager().InitKnob(&pSceneCacheDir, "scene-cache-dir", "");
+    pSceneCacheDir->SetFlagDescription("Directory of cooked scene caches, the scene is loaded from its GLTF file only if empty.");
+
+    GetKnobManager().InitKnob(&pVertexQuantization, "vertex-quantization", false);
+    pVertexQuantization->SetFlagDescription("Loads meshes with 16-bit positions, octahedral normals and tangents and half float tex coords.");
+
+    GetKnobManager().InitKnob(&pFrustumCulling, "frustum-culling", true);
+    pFrustumCulling->SetFlagDescription("Only draws the mesh nodes whose bounds overlap the view frustum.");
+
+    GetKnobManager().InitKnob(&pInstancing, "instancing", true);
+    pInstancing->SetFlagDescription("Draws consecutive mesh nodes sharing a mesh with a single instanced draw per batch.");
+
+    GetKnobManager().InitKnob(&pSortDraws, "sort-draws", true);
+    pSortDraws->SetFlagDescription("Sorts draws by pipeline, material, mesh and depth instead of drawing them in scene order.");
+
+    GetKnobManager().InitKnob(&pDepthPrepass, "depth-prepass", false);
+    pDepthPrepass->SetFlagDescription("Draws the scene depth-only from positions first, then shades with an equal depth test so each pixel is shaded once. Compare gpu_time with and without to get the net saving, gpu_prepass_time is the prepass' share.");
+
+    GetKnobManager().InitKnob(&pOcclusionPredicates, "occlusion-predicates", false);
+    pOcclusionPredicates->SetFlagDescription("Skips the draws of large mesh nodes that were occluded in the previous frame with occlusion queries and conditional rendering, without CPU readback.");
+
+    GetKnobManager().InitKnob(&pOcclusionMinSize, "occlusion-min-size", 0.1f, 0.0f, 2.0f);
+    pOcclusionMinSize->SetFlagDescription("Smallest diagonal of a mesh node's bounds, in radii of the scene's bounds, for its draws to be skipped with --occlusion-predicates. Smaller nodes are always drawn.");
+
+    GetKnobManager().InitKnob(&pCameraDistance, "camera-distance", 1.5f, 0.01f, 100.0f);
+    pCameraDistance->SetFlagDescription("Distance of the camera path from the center of the scene, in radii of the scene's bounds. Below 1 the camera flies through the scene.");
+
+    GetKnobManager().InitKnob(&pPathFrames, "path-frames", 600);
+    pPathFrames->SetFlagDescription("Number of frames of one lap of the camera path.");
+    pPathFrames->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pLaps, "laps", 1);
+    pLaps->SetFlagDescription("Number of laps of the camera path before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pLaps->SetValidator([](int value) { return value >= 0; });
+
+    GetKnobManager().InitKnob(&pTextureStreamingBudget, "texture-streaming-budget-mb", 0);
+    pTextureStreamingBudget->SetFlagDescription("Streams the mip levels of the scene's images from their projected size within this many MiB of GPU memory, 0 to load all levels.");
+    pTextureStreamingBudget->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "scene_render";
+    settings.enableImGui                                    = false;
+    settings.allowThirdPartyAssets                          = true;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupScene()
+{
+    scene::GltfLoader* pLoader = nullptr;
+    PPX_CHECKED_CALL(scene::GltfLoader::Create(GetAssetPath(pSceneAsset->GetValue()), /*pMaterialSelector=*/nullptr, &pLoader));
+
+    const scene::VertexQuantization quantization = pVertexQuantization->GetValue() ? scene::VERTEX_QUANTIZATION_COMPACT : scene::VERTEX_QUANTIZATION_NONE;
+
+    scene::LoadOptions loadOptions = scene::LoadOptions().SetCacheDirectory(pSceneCacheDir->GetValue()).SetVertexQuantization(quantization);
+    if (pTextureStreamingBudget->GetValue() > 0) {
+        scene::TextureStreamerCreateInfo streamerCreateInfo = {};
+        streamerCreateInfo.budgetBytes                      = static_cast<uint64_t>(pTextureStreamingBudget->GetValue()) * 1024 * 1024;
+        PPX_CHECKED_CALL(scene::TextureStreamer::Create(GetGraphicsQueue(), streamerCreateInfo, &mTextureStreamer));
+        loadOptions.SetTextureStreamer(mTextureStreamer);
+    }
+    PPX_CHECKED_CALL(pLoader->LoadScene(GetDevice(), 0, &mScene, loadOptions));
+    delete pLoader;
+
+    PPX_ASSERT_MSG((mScene->GetMeshNodeCount() > 0), "scene doesn't have mesh nodes");
+    PPX_ASSERT_MSG((mScene->GetMeshNodeCount() <= scene::MaterialPipelineArgs::MAX_DRAWABLE_INSTANCES), "scene has too many mesh nodes");
+
+    // The scene doesn't move, its transforms and bounds are computed once
+    mScene->UpdateTransforms(std::thread::hardware_concurrency());
+    mScene->UpdateBoundingVolumeHierarchy();
+
+    const ppx::AABB bounds = mScene->GetBoundingVolumeHierarchy().GetBounds();
+    mSceneCenter           = (bounds.GetMin() + bounds.GetMax()) / 2.0f;
+    mSceneRadius           = std::max(glm::length(bounds.GetMax() - bounds.GetMin()) / 2.0f, 0.001f);
+
+    uint32_t firstInstance = 0;
+    mInstanceGroups        = mScene->GetMeshInstanceGroups();
+    for (const auto& group : mInstanceGroups) {
+        mInstanceGroupFirstInstances.push_back(firstInstance);
+        for (auto pNode : group.nodes) {
+            mNodeInstances[pNode] = firstInstance++;
+        }
+    }
+    mVisibleInstances.resize(firstInstance, 1);
+    mInstanceObjects.resize(firstInstance, UINT32_MAX);
+
+    PPX_LOG_INFO("Rendering " << firstInstance << " mesh nodes in " << mInstanceGroups.size() << " instance groups, scene radius " << mSceneRadius);
+}
+
+void ProjApp::SetupPipelineArgs()
+{
+    PPX_CHECKED_CALL(grfx_util::CreateIBLTexturesFromFile(GetDevice()->GetGraphicsQueue(), GetAssetPath("poly_haven/ibl/old_depot_4k.ibl"), &mIBLIrrMap, &mIBLEnvMap));
+
+    PPX_CHECKED_CALL(scene::MaterialPipelineArgs::Create(GetDevice(), &mPipelineArgs));
+
+    auto samplersIndexMap = mScene->GetSamplersArrayIndexMap();
+    for (auto it : samplersIndexMap) {
+        mPipelineArgs->SetMaterialSampler(it.second, it.first);
+    }
+
+    auto imagesIndexMap = mScene->GetImagesArrayIndexMap();
+    for (auto it : imagesIndexMap) {
+        mPipelineArgs->SetMaterialTexture(it.second, it.first);
+    }
+
+    mMaterialIndexMap = mScene->GetMaterialsArrayIndexMap();
+    for (auto it : mMaterialIndexMap) {
+        auto pMaterial       = it.first;
+        auto pMaterialParams = mPipelineArgs->GetMaterialParams(it.second);
+
+        if (pMaterial->GetIdentString() == PPX_MATERIAL_IDENT_STANDARD) {
+            auto pStandardMaterial = static_cast<const scene::StandardMaterial*>(pMaterial);
+
+            pMaterialParams->baseColorFactor   = pStandardMaterial->GetBaseColorFactor();
+            pMaterialParams->metallicFactor    = pStandardMaterial->GetMetallicFactor();
+            pMaterialParams->roughnessFactor   = pStandardMaterial->GetRoughnessFactor();
+            pMaterialParams->occlusionStrength = pStandardMaterial->GetOcclusionStrength();
+            pMaterialParams->emissiveFactor    = pStandardMaterial->GetEmissiveFactor();
+            pMaterialParams->emissiveStrength  = pStandardMaterial->GetEmissiveStrength();
+
+            scene::CopyMaterialTextureParams(samplersIndexMap, imagesIndexMap, pStandardMaterial->GetBaseColorTextureView(), pMaterialParams->baseColorTex);
+            scene::CopyMaterialTextureParams(samplersIndexMap, imagesIndexMap, pStandardMaterial->GetMetallicRoughnessTextureView(), pMaterialParams->metallicRoughnessTex);
+            scene::CopyMaterialTextureParams(samplersIndexMap, imagesIndexMap, pStandardMaterial->GetNormalTextureView(), pMaterialParams->normalTex);
+            scene::CopyMaterialTextureParams(samplersIndexMap, imagesIndexMap, pStandardMaterial->GetOcclusionTextureView(), pMaterialParams->occlusionTex);
+            scene::CopyMaterialTextureParams(samplersIndexMap, imagesIndexMap, pStandardMaterial->GetEmissiveTextureView(), pMaterialParams->emssiveTex);
+        }
+        else if (pMaterial->GetIdentString() == PPX_MATERIAL_IDENT_UNLIT) {
+            auto pUnlitMaterial              = static_cast<const scene::UnlitMaterial*>(pMaterial);
+            pMaterialParams->baseColorFactor = pUnlitMaterial->GetBaseColorFactor();
+            scene::CopyMaterialTextureParams(samplersIndexMap, imagesIndexMap, pUnlitMaterial->GetBaseColorTextureView(), pMaterialParams->baseColorTex);
+        }
+    }
+
+    mPipelineArgs->SetIBLTextures(0, mIBLIrrMap->GetSampledImageView(), mIBLEnvMap->GetSampledImageView());
+
+    // Instance params don't change, the first CopyBuffers() uploads them
+    for (size_t groupIdx = 0; groupIdx < mInstanceGroups.size(); ++groupIdx) {
+        const auto& group          = mInstanceGroups[groupIdx];
+        const auto& dequantization = group.pMesh->GetMeshData()->GetVertexDequantization();
+        for (uint32_t i = 0; i < CountU32(group.nodes); ++i) {
+            const uint32_t instanceIdx                                 = mInstanceGroupFirstInstances[groupIdx] + i;
+            mPipelineArgs->GetInstanceParams(instanceIdx)->modelMatrix = group.nodes[i]->GetEvaluatedMatrix();
+            mPipelineArgs->SetVertexDequantization(instanceIdx, dequantization);
+        }
+    }
+}
+
+void ProjApp::UpdateTextureStreaming()
+{
+    mTextureStreamer->RequestLevels(*mScene, mCamera, GetWindowHeight());
+
+    // The previous frame has completed, its descriptors can be updated
+    uint32_t changedCount = 0;
+    PPX_CHECKED_CALL(mTextureStreamer->Update(&changedCount));
+    if (changedCount > 0) {
+        auto imagesIndexMap = mScene->GetImagesArrayIndexMap();
+        for (auto it : imagesIndexMap) {
+            mPipelineArgs->SetMaterialTexture(it.second, it.first);
+        }
+    }
+}
+
+void ProjApp::SetupPipelines()
+{
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.pushConstants.count               = 32;
+    piCreateInfo.pushConstants.binding             = 0;
+    piCreateInfo.pushConstants.set                 = 0;
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mPipelineArgs->GetDescriptorSetLayout();
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+    // Every mesh in the scene should have the same attributes
+    auto vertexBindings = mScene->GetMeshNode(0)->GetMesh()->GetMeshData()->GetAvailableVertexBindings();
+
+    // Compact vertices are decoded by their own vertex shader
+    const std::string vsName = pVertexQuantization->GetValue() ? "MaterialVertexQuantized.vs" : "MaterialVertex.vs";
+
+    // After a depth prepass, shading only passes where the prepass left
+    // the fragment's own depth and doesn't write depth again
+    const bool prepass = pDepthPrepass->GetValue();
+
+    auto CreatePipeline = [this, &vertexBindings, &vsName, prepass](const std::string& psName, grfx::GraphicsPipeline** ppPipeline) {
+        std::vector<char> bytecode = LoadShader("scene_renderer/shaders", vsName);
+        PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+        grfx::ShaderModulePtr        VS;
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &VS));
+
+        bytecode = LoadShader("scene_renderer/shaders", psName);
+        PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+        grfx::ShaderModulePtr PS;
+        shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &PS));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {VS.Get(), "vsmain"};
+        gpCreateInfo.PS                                 = {PS.Get(), "psmain"};
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_BACK;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = true;
+        gpCreateInfo.depthWriteEnable                   = !prepass;
+        gpCreateInfo.depthCompareOp                     = prepass ? grfx::COMPARE_OP_EQUAL : grfx::COMPARE_OP_LESS;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
+        gpCreateInfo.outputState.depthStencilFormat     = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
+        gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+
+        gpCreateInfo.vertexInputState.bindingCount = CountU32(vertexBindings);
+        for (uint32_t i = 0; i < gpCreateInfo.vertexInputState.bindingCount; ++i) {
+            gpCreateInfo.vertexInputState.bindings[i] = vertexBindings[i];
+        }
+
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, ppPipeline));
+
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    };
+
+    CreatePipeline("StandardMaterial.ps", &mStandardMaterialPipeline);
+    CreatePipeline("UnlitMaterial.ps", &mUnlitMaterialPipeline);
+    CreatePipeline("ErrorMaterial.ps", &mErrorMaterialPipeline);
+
+    // Depth prepass, positions only and no pixel shader
+    if (prepass) {
+        std::vector<char> bytecode = LoadShader("scene_renderer/shaders", pVertexQuantization->GetValue() ? "DepthPrepassQuantized.vs" : "DepthPrepass.vs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+        grfx::ShaderModulePtr        VS;
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &VS));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {VS.Get(), "vsmain"};
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_BACK;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = true;
+        gpCreateInfo.depthWriteEnable                   = true;
+        gpCreateInfo.depthCompareOp                     = grfx::COMPARE_OP_LESS;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
+        gpCreateInfo.outputState.depthStencilFormat     = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
+        gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+
+        // Only the position binding, attributes aren't fetched
+        PPX_ASSERT_MSG(vertexBindings[0].GetBinding() == scene::kVertexPositionBinding, "first vertex binding isn't positions");
+        gpCreateInfo.vertexInputState.bindingCount = 1;
+        gpCreateInfo.vertexInputState.bindings[0]  = vertexBindings[0];
+
+        // The render target stays bound for the pass, but isn't written
+        grfx::GraphicsPipelineCreateInfo fullCreateInfo = {};
+        grfx::internal::FillOutGraphicsPipelineCreateInfo(&gpCreateInfo, &fullCreateInfo);
+        fullCreateInfo.colorBlendState.blendAttachments[0].colorWriteMask = grfx::ColorComponentFlags(0);
+
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&fullCreateInfo, &mDepthPrepassPipeline));
+
+        GetDevice()->DestroyShaderModule(VS);
+    }
+
+    mPipelineSortIndexMap[mStandardMaterialPipeline.Get()] = 0;
+    mPipelineSortIndexMap[mUnlitMaterialPipeline.Get()]    = 1;
+    mPipelineSortIndexMap[mErrorMaterialPipeline.Get()]    = 2;
+
+    for (auto it : mMaterialIndexMap) {
+        auto pMaterial = it.first;
+        auto ident     = pMaterial->GetIdentString();
+        if (ident == PPX_MATERIAL_IDENT_STANDARD) {
+            mMaterialPipelineMap[pMaterial] = mStandardMaterialPipeline;
+        }
+        else if (ident == PPX_MATERIAL_IDENT_UNLIT) {
+            mMaterialPipelineMap[pMaterial] = mUnlitMaterialPipeline;
+        }
+        else {
+            mMaterialPipelineMap[pMaterial] = mErrorMaterialPipeline;
+        }
+    }
+}
+
+void ProjApp::SetupOcclusionPredicates()
+{
+    if (!GetDevice()->ConditionalRenderingSupported()) {
+        PPX_LOG_WARN("Conditional rendering isn't supported, ignoring --occlusion-predicates");
+        return;
+    }
+
+    // Large mesh nodes only, smaller ones cost about as much to draw as
+    // their occlusion query does
+    const float            minSize = pOcclusionMinSize->GetValue() * mSceneRadius;
+    std::vector<ppx::AABB> objectBounds;
+    for (size_t groupIdx = 0; groupIdx < mInstanceGroups.size(); ++groupIdx) {
+        const auto& group = mInstanceGroups[groupIdx];
+        for (uint32_t i = 0; i < CountU32(group.nodes); ++i) {
+            const ppx::AABB bounds = group.pMesh->GetBoundingBox().GetTransformed(group.nodes[i]->GetEvaluatedMatrix());
+            if (glm::length(bounds.GetSize()) < minSize) {
+                continue;
+            }
+            mInstanceObjects[mInstanceGroupFirstInstances[groupIdx] + i] = CountU32(objectBounds);
+            objectBounds.push_back(bounds);
+        }
+    }
+    if (objectBounds.empty()) {
+        PPX_LOG_WARN("No mesh node is larger than --occlusion-min-size, ignoring --occlusion-predicates");
+        return;
+    }
+
+    std::vector<char> bytecode = LoadShader("basic/shaders", "OcclusionProxy.vs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+    grfx::ShaderModulePtr        VS;
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &VS));
+
+    scene::OcclusionPredicatesCreateInfo createInfo = {};
+    createInfo.pProxyShader                         = VS;
+    createInfo.maxObjectCount                       = CountU32(objectBounds);
+    createInfo.colorFormat                          = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
+    createInfo.depthFormat                          = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
+    PPX_CHECKED_CALL(scene::OcclusionPredicates::Create(GetDevice(), createInfo, &mOcclusionPredicates));
+    PPX_CHECKED_CALL(mOcclusionPredicates->SetObjects(CountU32(objectBounds), objectBounds.data()));
+
+    GetDevice()->DestroyShaderModule(VS);
+
+    PPX_LOG_INFO("Drawing " << objectBounds.size() << " mesh nodes with occlusion predicates");
+}
+
+void ProjApp::Setup()
+{
+    SetupScene();
+
+    // Draw pass
+    {
+        grfx::DrawPassCreateInfo createInfo     = {};
+        createInfo.width                        = GetWindowWidth();
+        createInfo.height                       = GetWindowHeight();
+        createInfo.renderTargetCount            = 1;
+        createInfo.renderTargetFormats[0]       = grfx::FORMAT_R8G8B8A8_UNORM;
+        createInfo.depthStencilFormat           = grfx::FORMAT_D32_FLOAT;
+        createInfo.renderTargetInitialStates[0] = grfx::RESOURCE_STATE_RENDER_TARGET;
+        createInfo.depthStencilInitialState     = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE;
+        createInfo.renderTargetClearValues[0]   = {0.2f, 0.2f, 0.3f, 1.0f};
+        createInfo.depthStencilClearValue       = {1.0f, 0xFF};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mDrawPass));
+    }
+
+    SetupPipelineArgs();
+    SetupPipelines();
+
+    if (pOcclusionPredicates->GetValue()) {
+        SetupOcclusionPredicates();
+    }
+
+    // Camera, the far clip contains the scene from anywhere on the path
+    {
+        const float distance = pCameraDistance->GetValue() * mSceneRadius;
+        mCamera              = PerspCamera(60.0f, GetWindowAspect(), std::max(0.001f * mSceneRadius, 0.01f), 2.0f * (distance + mSceneRadius));
+    }
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 3;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+}
+
+void ProjApp::Shutdown()
+{
+    delete mOcclusionPredicates;
+    delete mScene;
+    delete mPipelineArgs;
+    delete mTextureStreamer;
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    struct MetricInfo
+    {
+        metrics::MetricID*            pId;
+        const char*                   name;
+        const char*                   unit;
+        metrics::MetricInterpretation interpretation;
+    };
+
+    const MetricInfo infos[] = {
+        {&mCpuRecordTimeMetric, "cpu_record_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mGpuTimeMetric, "gpu_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mGpuPrepassMetric, "gpu_prepass_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mDrawMetric, "draws", "", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mTriangleMetric, "triangles", "", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mPipelineBindMetric, "pipeline_binds", "", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mStateChangeMetric, "state_changes", "", metrics::MetricInterpretation::LOWER_IS_BETTER},
+        {&mPredicatedMetric, "predicated_draws", "", metrics::MetricInterpretation::NONE},
+    };
+    for (const MetricInfo& info : infos) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, info.name, info.unit, info.interpretation};
+        *info.pId                        = AddMetric(metadata);
+        PPX_ASSERT_MSG(*info.pId != metrics::kInvalidMetricID, "Failed to add metric " << info.name);
+    }
+}
+
+void ProjApp::RecordMetric(metrics::MetricID id, double value)
+{
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = value;
+    RecordMetricData(id, data);
+}
+
+void ProjApp::UpdateCamera()
+{
+    const float  pathFrames = static_cast<float>(pPathFrames->GetValue());
+    const float  angle      = 2.0f * glm::pi<float>() * static_cast<float>(mFrame % pPathFrames->GetValue()) / pathFrames;
+    const float  distance   = pCameraDistance->GetValue() * mSceneRadius;
+    const float3 offset     = float3(std::cos(angle), 0.35f * std::sin(2.0f * angle), std::sin(angle));
+    mCamera.LookAt(mSceneCenter + distance * glm::normalize(offset), mSceneCenter);
+}
+
+void ProjApp::BuildRenderQueue()
+{
+    // Visibility of each instance
+    if (pFrustumCulling->GetValue()) {
+        std::fill(mVisibleInstances.begin(), mVisibleInstances.end(), static_cast<uint8_t>(0));
+        mVisibleNodes.clear();
+        mScene->GetBoundingVolumeHierarchy().QueryFrustum(ppx::Frustum(mCamera.GetViewProjectionMatrix()), &mVisibleNodes);
+        for (const scene::MeshNode* pNode : mVisibleNodes) {
+            auto it = mNodeInstances.find(pNode);
+            if (it != mNodeInstances.end()) {
+                mVisibleInstances[it->second] = 1;
+            }
+        }
+    }
+
+    // Runs of consecutive visible instances of a group share a draw per
+    // batch when instancing. Instances with an occlusion predicate are
+    // drawn on their own.
+    mRenderQueue.Clear();
+    for (size_t groupIdx = 0; groupIdx < mInstanceGroups.size(); ++groupIdx) {
+        const auto&    group         = mInstanceGroups[groupIdx];
+        const uint32_t firstInstance = mInstanceGroupFirstInstances[groupIdx];
+        const uint32_t nodeCount     = CountU32(group.nodes);
+
+        uint32_t firstNode = 0;
+        while (firstNode < nodeCount) {
+            if (mVisibleInstances[firstInstance + firstNode] == 0) {
+                ++firstNode;
+                continue;
+            }
+            uint32_t   endNode   = firstNode + 1;
+            const bool instanced = pInstancing->GetValue() && (mInstanceObjects[firstInstance + firstNode] == UINT32_MAX);
+            while (instanced && (endNode < nodeCount) && (mVisibleInstances[firstInstance + endNode] != 0) && (mInstanceObjects[firstInstance + endNode] == UINT32_MAX)) {
+                ++endNode;
+            }
+
+            const float3 position = float3(group.nodes[firstNode]->GetEvaluatedMatrix()[3]);
+            const float  depth    = glm::distance(position, mCamera.GetEyePosition()) / mCamera.GetFarClip();
+            for (auto& batch : group.pMesh->GetBatches()) {
+                scene::RenderQueue::Draw draw = {};
+                draw.pBatch                   = &batch;
+                draw.pPipeline                = mMaterialPipelineMap[batch.GetMaterial()];
+                draw.materialIndex            = mMaterialIndexMap[batch.GetMaterial()];
+                draw.firstInstance            = firstInstance + firstNode;
+                draw.instanceCount            = endNode - firstNode;
+
+                // Sequential keys keep the scene order
+                draw.sortKey = mRenderQueue.GetDrawCount();
+                if (pSortDraws->GetValue()) {
+                    draw.sortKey = scene::RenderQueue::MakeSortKey(mPipelineSortIndexMap[draw.pPipeline], draw.materialIndex, static_cast<uint32_t>(groupIdx), depth);
+                }
+                mRenderQueue.Add(draw);
+            }
+            firstNode = endNode;
+        }
+    }
+    mRenderQueue.Sort();
+}
+
+void ProjApp::RecordDepthPrepass(grfx::CommandBuffer* pCmd, FrameStats* pStats)
+{
+    pCmd->BindGraphicsPipeline(mDepthPrepassPipeline);
+    ++pStats->pipelineBinds;
+    ++pStats->stateChanges;
+
+    // Same draws as RecordDraws() without materials, and positions only
+    const scene::PrimitiveBatch* pBoundBatch        = nullptr;
+    uint32_t                     boundInstanceIndex = UINT32_MAX;
+    for (uint32_t drawIdx = 0; drawIdx < mRenderQueue.GetDrawCount(); ++drawIdx) {
+        const auto& draw  = mRenderQueue.GetDraw(drawIdx);
+        const auto& batch = *draw.pBatch;
+
+        if (draw.firstInstance != boundInstanceIndex) {
+            pCmd->PushGraphicsConstants(mPipelineInterface, 1, &draw.firstInstance, scene::MaterialPipelineArgs::INSTANCE_INDEX_CONSTANT_OFFSET);
+            boundInstanceIndex = draw.firstInstance;
+            ++pStats->stateChanges;
+        }
+
+        if (draw.pBatch != pBoundBatch) {
+            pCmd->BindIndexBuffer(&batch.GetIndexBufferView());
+            pCmd->BindVertexBuffers(1, &batch.GetPositionBufferView());
+            pBoundBatch = draw.pBatch;
+            pStats->stateChanges += 2;
+        }
+
+        const uint32_t objectIndex = IsNull(mOcclusionPredicates) ? UINT32_MAX : mInstanceObjects[draw.firstInstance];
+        if (objectIndex != UINT32_MAX) {
+            mOcclusionPredicates->BeginObject(pCmd, objectIndex);
+        }
+
+        pCmd->DrawIndexed(batch.GetIndexCount(), draw.instanceCount, 0, 0, 0);
+        ++pStats->draws;
+        pStats->triangles += static_cast<uint64_t>(batch.GetIndexCount() / 3) * draw.instanceCount;
+
+        if (objectIndex != UINT32_MAX) {
+            mOcclusionPredicates->EndObject(pCmd);
+        }
+    }
+}
+
+void ProjApp::RecordDraws(grfx::CommandBuffer* pCmd, FrameStats* pStats)
+{
+    // Only change state that differs from the previous draw
+    const grfx::GraphicsPipeline* pBoundPipeline     = nullptr;
+    const scene::PrimitiveBatch*  pBoundBatch        = nullptr;
+    uint32_t                      boundMaterialIndex = UINT32_MAX;
+    uint32_t                      boundInstanceIndex = UINT32_MAX;
+    for (uint32_t drawIdx = 0; drawIdx < mRenderQueue.GetDrawCount(); ++drawIdx) {
+        const auto& draw  = mRenderQueue.GetDraw(drawIdx);
+        const auto& batch = *draw.pBatch;
+
+        if (draw.pPipeline != pBoundPipeline) {
+            pCmd->BindGraphicsPipeline(draw.pPipeline);
+            pBoundPipeline = draw.pPipeline;
+            ++pStats->pipelineBinds;
+            ++pStats->stateChanges;
+        }
+
+        // DrawParams::materialIndex
+        if (draw.materialIndex != boundMaterialIndex) {
+            pCmd->PushGraphicsConstants(mPipelineInterface, 1, &draw.materialIndex, scene::MaterialPipelineArgs::MATERIAL_INDEX_CONSTANT_OFFSET);
+            boundMaterialIndex = draw.materialIndex;
+            ++pStats->stateChanges;
+        }
+
+        // DrawParams::instanceIndex, the vertex shader adds SV_InstanceID
+        if (draw.firstInstance != boundInstanceIndex) {
+            pCmd->PushGraphicsConstants(mPipelineInterface, 1, &draw.firstInstance, scene::MaterialPipelineArgs::INSTANCE_INDEX_CONSTANT_OFFSET);
+            boundInstanceIndex = draw.firstInstance;
+            ++pStats->stateChanges;
+        }
+
+        if (draw.pBatch != pBoundBatch) {
+            const grfx::VertexBufferView vertexBufferViews[2] = {batch.GetPositionBufferView(), batch.GetAttributeBufferView()};
+            pCmd->BindIndexBuffer(&batch.GetIndexBufferView());
+            pCmd->BindVertexBuffers(2, vertexBufferViews);
+            pBoundBatch = draw.pBatch;
+            pStats->stateChanges += 2;
+        }
+
+        // Draws of a single instance only, see BuildRenderQueue()
+        const uint32_t objectIndex = IsNull(mOcclusionPredicates) ? UINT32_MAX : mInstanceObjects[draw.firstInstance];
+        if (objectIndex != UINT32_MAX) {
+            mOcclusionPredicates->BeginObject(pCmd, objectIndex);
+        }
+
+        pCmd->DrawIndexed(batch.GetIndexCount(), draw.instanceCount, 0, 0, 0);
+        ++pStats->draws;
+        pStats->triangles += static_cast<uint64_t>(batch.GetIndexCount() / 3) * draw.instanceCount;
+
+        if (objectIndex != UINT32_MAX) {
+            mOcclusionPredicates->EndObject(pCmd);
+        }
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's GPU time, the first frame is a warmup
+    if (mInFlight && (mFrame > 1)) {
+        uint64_t timestamps[3] = {0};
+        uint64_t frequency     = 0;
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+        if (frequency > 0) {
+            const double msPerTick = 1000.0 / static_cast<double>(frequency);
+            RecordMetric(mGpuTimeMetric, msPerTick * static_cast<double>(timestamps[2] - timestamps[0]));
+            if (pDepthPrepass->GetValue()) {
+                RecordMetric(mGpuPrepassMetric, msPerTick * static_cast<double>(timestamps[1] - timestamps[0]));
+            }
+        }
+    }
+
+    if ((pLaps->GetValue() > 0) && (mFrame == static_cast<uint32_t>(pLaps->GetValue() * pPathFrames->GetValue()))) {
+        Quit();
+        return;
+    }
+
+    Timer timer;
+    PPX_ASSERT_MSG(timer.Start() == TIMER_RESULT_SUCCESS, "timer start failed");
+
+    UpdateCamera();
+    mPipelineArgs->SetCameraParams(&mCamera);
+    if (!IsNull(mTextureStreamer)) {
+        UpdateTextureStreaming();
+    }
+    BuildRenderQueue();
+
+    FrameStats stats = {};
+
+    mTimestampQuery->Reset(0, 3);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        mPipelineArgs->CopyBuffers(mCommandBuffer);
+        if (!IsNull(mOcclusionPredicates)) {
+            mOcclusionPredicates->BeginFrame(mCommandBuffer, mCamera);
+        }
+
+        mCommandBuffer->BeginRenderPass(mDrawPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_ALL);
+        {
+            mCommandBuffer->SetScissors(mDrawPass->GetScissor());
+            mCommandBuffer->SetViewports(mDrawPass->GetViewport());
+
+            auto pDescriptorSet = mPipelineArgs->GetDescriptorSet();
+            mCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 1, &pDescriptorSet);
+
+            // DrawParams::iblIndex and DrawParams::iblLevelCount
+            const uint32_t iblIndex      = 0;
+            const uint32_t iblLevelCount = mIBLEnvMap->GetMipLevelCount();
+            mCommandBuffer->PushGraphicsConstants(mPipelineInterface, 1, &iblIndex, 2);
+            mCommandBuffer->PushGraphicsConstants(mPipelineInterface, 1, &iblLevelCount, 3);
+
+            // Timestamp 1 ends the depth prepass, if there is one
+            if (pDepthPrepass->GetValue()) {
+                RecordDepthPrepass(mCommandBuffer, &stats);
+            }
+            mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+
+            RecordDraws(mCommandBuffer, &stats);
+
+            // Queries for the next frame's predicates, against this frame's depth
+            if (!IsNull(mOcclusionPredicates)) {
+                mOcclusionPredicates->DrawProxies(mCommandBuffer);
+                stats.predicated = mOcclusionPredicates->GetPredicatedCount();
+            }
+        }
+        mCommandBuffer->EndRenderPass();
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 3);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    const double cpuRecordMs = timer.MillisSinceStart();
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    mInFlight = true;
+
+    if (mFrame > 0) {
+        RecordMetric(mCpuRecordTimeMetric, cpuRecordMs);
+        RecordMetric(mDrawMetric, static_cast<double>(stats.draws));
+        RecordMetric(mTriangleMetric, static_cast<double>(stats.triangles));
+        RecordMetric(mPipelineBindMetric, static_cast<double>(stats.pipelineBinds));
+        RecordMetric(mStateChangeMetric, static_cast<double>(stats.stateChanges));
+        RecordMetric(mPredicatedMetric, static_cast<double>(stats.predicated));
+    }
+    ++mFrame;
+}
+
+SETUP_APPLICATION(ProjApp)
@@ -0,0 +1,269 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/graphics_util.h"
+#include "ppx/knob.h"
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+// Render target formats of the pipeline permutations, besides the swapchain's
+static const grfx::Format kFormats[] = {
+    grfx::FORMAT_R8G8B8A8_UNORM,
+    grfx::FORMAT_R10G10B10A2_UNORM,
+    grfx::FORMAT_R11G11B10_FLOAT,
+    grfx::FORMAT_R16G16B16A16_FLOAT,
+    grfx::FORMAT_R32G32B32A32_FLOAT,
+};
+
+static const grfx::BlendMode kBlendModes[] = {
+    grfx::BLEND_MODE_NONE,
+    grfx::BLEND_MODE_ADDITIVE,
+    grfx::BLEND_MODE_ALPHA,
+};
+
+static const grfx::CullMode kCullModes[] = {
+    grfx::CULL_MODE_NONE,
+    grfx::CULL_MODE_BACK,
+    grfx::CULL_MODE_FRONT,
+};
+
+static const grfx::FrontFace kFrontFaces[] = {
+    grfx::FRONT_FACE_CCW,
+    grfx::FRONT_FACE_CW,
+};
+
+static const uint32_t kPermutationCount = static_cast<uint32_t>((std::size(kFormats) + 1) * std::size(kBlendModes) * std::size(kCullModes) * std::size(kFrontFaces));
+
+static const char* const kTextureFiles[] = {
+    "benchmarks/textures/skybox.jpg",
+    "benchmarks/textures/bricks_1080p.png",
+    "benchmarks/textures/test_image_1280x720.jpg",
+    "benchmarks/textures/resolution.jpg",
+};
+
+// Must match FramebufferParams in FramebufferFormat.hlsl
+struct FramebufferParams
+{
+    uint32_t layer;
+    uint32_t smoothContent;
+    float    invSize[2];
+};
+
+// Stands in for the startup work of a typical app: Setup() loads shaders,
+// creates --pipelines distinct pipeline permutations and loads --textures
+// textures, then a single frame is drawn with the first pipeline and
+// presented (--frame-count defaults to 1).
+//
+// The breakdown is measured by ppx::Application itself and recorded as the
+// startup_* gauges of every metrics run, see ppx::StartupTimes. Launches with
+// and without a --pipeline-cache-path file from an earlier launch compare
+// cold and warm pipeline creation, tools/startup_benchmark.py runs both.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+private:
+    struct PerFrame
+    {
+        grfx::CommandBufferPtr cmd;
+        grfx::SemaphorePtr     imageAcquiredSemaphore;
+        grfx::SemaphorePtr     renderCompleteSemaphore;
+    };
+
+    void SetupPipelines();
+    void SetupTextures();
+
+private:
+    std::shared_ptr<KnobFlag<int>> pPipelines;
+    std::shared_ptr<KnobFlag<int>> pTextures;
+
+    std::vector<PerFrame>                  mPerFrame;
+    grfx::PipelineInterfacePtr             mPipelineInterface;
+    std::vector<grfx::GraphicsPipelinePtr> mPipelines; // The first one draws to the swapchain
+    std::vector<grfx::TexturePtr>          mTextures;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pPipelines, "pipelines", 32);
+    pPipelines->SetFlagDescription("Number of graphics pipeline permutations created at startup, at most " + std::to_string(kPermutationCount) + ".");
+    pPipelines->SetValidator([](int value) { return (value >= 1) && (value <= static_cast<int>(kPermutationCount)); });
+
+    GetKnobManager().InitKnob(&pTextures, "textures", 4);
+    pTextures->SetFlagDescription("Number of textures loaded from files at startup, the benchmark textures are reused past " + std::to_string(std::size(kTextureFiles)) + ".");
+    pTextures->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "startup_time";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.standardKnobsDefaultValue.frameCount           = 1;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::SetupPipelines()
+{
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 0;
+    piCreateInfo.pushConstants.count               = sizeof(FramebufferParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = 0;
+    piCreateInfo.pushConstants.set                 = 0;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+    grfx::ShaderModulePtr VS;
+    grfx::ShaderModulePtr PS;
+    PPX_CHECKED_CALL(CreateShader("benchmarks/shaders", "FramebufferFormat.vs", &VS));
+    PPX_CHECKED_CALL(CreateShader("benchmarks/shaders", "FramebufferFormat.ps", &PS));
+
+    // The swapchain format comes first, so the first pipeline can draw the frame
+    std::vector<grfx::Format> formats = {GetSwapchain()->GetColorFormat()};
+    formats.insert(formats.end(), std::begin(kFormats), std::end(kFormats));
+
+    std::vector<grfx::GraphicsPipelineCreateInfo2> createInfos;
+    for (grfx::Format format : formats) {
+        const bool blend = GetDevice()->RenderTargetBlendSupported(format);
+        for (grfx::BlendMode blendMode : kBlendModes) {
+            for (grfx::CullMode cullMode : kCullModes) {
+                for (grfx::FrontFace frontFace : kFrontFaces) {
+                    grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+                    gpCreateInfo.cullMode                           = cullMode;
+                    gpCreateInfo.frontFace                          = frontFace;
+                    gpCreateInfo.blendModes[0]                      = blend ? blendMode : grfx::BLEND_MODE_NONE;
+                    gpCreateInfo.outputState.renderTargetFormats[0] = format;
+                    createInfos.push_back(gpCreateInfo);
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < static_cast<uint32_t>(pPipelines->GetValue()); ++i) {
+        grfx::GraphicsPipelineCreateInfo2& gpCreateInfo = createInfos[i];
+        gpCreateInfo.VS                                 = {VS.Get(), "vsmain"};
+        gpCreateInfo.PS                                 = {PS.Get(), "psmain"};
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.depthReadEnable                    = false;
+        gpCreateInfo.depthWriteEnable                   = false;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+
+        grfx::GraphicsPipelinePtr pipeline;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &pipeline));
+        mPipelines.push_back(pipeline);
+    }
+
+    GetDevice()->DestroyShaderModule(VS);
+    GetDevice()->DestroyShaderModule(PS);
+}
+
+void ProjApp::SetupTextures()
+{
+    for (uint32_t i = 0; i < static_cast<uint32_t>(pTextures->GetValue()); ++i) {
+        const char* const file = kTextureFiles[i % std::size(kTextureFiles)];
+
+        grfx::TexturePtr texture;
+        PPX_CHECKED_CALL(grfx_util::CreateTextureFromFile(GetGraphicsQueue(), GetAssetPath(file), &texture));
+        mTextures.push_back(texture);
+    }
+}
+
+void ProjApp::Setup()
+{
+    SetupPipelines();
+    SetupTextures();
+
+    for (uint32_t i = 0; i < GetNumFramesInFlight(); ++i) {
+        PerFrame frame = {};
+
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&frame.cmd));
+
+        grfx::SemaphoreCreateInfo semaCreateInfo = {};
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.imageAcquiredSemaphore));
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.renderCompleteSemaphore));
+
+        mPerFrame.push_back(frame);
+    }
+}
+
+void ProjApp::Render()
+{
+    PerFrame& frame = mPerFrame[GetInFlightFrameIndex()];
+
+    grfx::SwapchainPtr swapchain = GetSwapchain();
+
+    uint32_t imageIndex = UINT32_MAX;
+    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, nullptr, &imageIndex));
+
+    PPX_CHECKED_CALL(frame.cmd->Begin());
+    {
+        grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
+        PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
+
+        grfx::RenderPassBeginInfo beginInfo = {};
+        beginInfo.pRenderPass               = renderPass;
+        beginInfo.renderArea                = renderPass->GetRenderArea();
+        beginInfo.RTVClearCount             = 1;
+        beginInfo.RTVClearValues[0]         = {{0, 0, 0, 1}};
+
+        FramebufferParams params = {};
+        params.smoothContent     = 1;
+        params.invSize[0]        = 1.0f / static_cast<float>(GetWindowWidth());
+        params.invSize[1]        = 1.0f / static_cast<float>(GetWindowHeight());
+
+        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+        frame.cmd->BeginRenderPass(&beginInfo);
+        {
+            frame.cmd->SetScissors(GetScissor());
+            frame.cmd->SetViewports(GetViewport());
+            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
+            frame.cmd->BindGraphicsPipeline(mPipelines[0]);
+            frame.cmd->PushGraphicsConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+            frame.cmd->Draw(3, 1, 0, 0);
+        }
+        frame.cmd->EndRenderPass();
+        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+    }
+    PPX_CHECKED_CALL(frame.cmd->End());
+
+    grfx::SubmitInfo submitInfo     = {};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.ppCommandBuffers     = &frame.cmd;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
+
+    PPX_CHECKED_CALL(SubmitFrame(GetGraphicsQueue(), &submitInfo));
+
+    PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
+}
+
+SETUP_APPLICATION(ProjApp)
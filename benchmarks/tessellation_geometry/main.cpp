@@ -0,0 +1,476 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+// Must match maxtessfactor in Tessellation.hlsl
+static const uint32_t kMaxTessFactor = 64;
+
+// Must match the variants in assets/benchmarks/shaders/CMakeLists.txt
+static const uint32_t kAmplifications[] = {1, 2, 4, 8, 16, 32};
+
+// Must match TessellationParams in Tessellation.hlsl
+struct TessellationParams
+{
+    float    tessFactor;
+    uint32_t padding[3];
+};
+
+// Triangles of a tri domain patch with all factors set to an integer n: the
+// outer ring of n segments per edge and the ring of n - 2 segments inside it
+// are joined by 3 * (2n - 2) triangles, down to a point or a single triangle.
+static uint64_t TessellatedTriangleCount(uint32_t n)
+{
+    uint64_t count = 0;
+    for (; n > 1; n -= 2) {
+        count += 3 * (2 * static_cast<uint64_t>(n) - 2);
+    }
+    return count + n; // 1 for odd factors, 0 for even ones
+}
+
+// Measures the primitive throughput of the tessellation and geometry shader
+// stages, to find the factors at which each GPU falls off a cliff. A grid of
+// --primitives triangles is drawn into a 1x1 render target so that
+// rasterization costs nothing, with:
+//   - baseline: the vertex and pixel shaders only
+//   - tessellation_factor_<n>: hull and domain shaders with all tessellation
+//     factors set to n
+//   - geometry_amplification_<n>: a geometry shader emitting n triangles per
+//     input triangle
+// The amplified cases draw fewer input triangles so that they all output close
+// to --primitives. Each case is measured for --samples frames after a warmup
+// frame and recorded as a "<case>" gauge in Mprims/s (10^6 output primitives
+// per second). After every pass over the cases, the largest drop between
+// consecutive steps of each sweep is logged.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct Case
+    {
+        std::string               sweep            = "";
+        uint32_t                  value            = 0; // Tessellation factor or amplification
+        std::string               name             = "";
+        metrics::MetricID         metricId         = metrics::kInvalidMetricID;
+        grfx::GraphicsPipelinePtr pipeline;
+        uint32_t                  inputTriangles   = 0;
+        uint64_t                  outputPrimitives = 0;
+        double                    totalMprims      = 0.0; // Of the samples since the last log
+        uint32_t                  sampleCount      = 0;
+        double                    meanMprims       = 0.0; // Of all the samples so far
+        uint64_t                  meanCount        = 0;
+    };
+
+    void SetupCases();
+    void AddCase(const std::string& sweep, uint32_t value, uint64_t primitivesPerInput);
+    void SetupPipeline(Case& c);
+    void FinishSample(Case& c, uint64_t ticks);
+    void LogCliffs() const;
+
+    grfx::ShaderModulePtr LoadShaderModule(const std::string& name);
+
+private:
+    std::shared_ptr<KnobFlag<int>> pPrimitives;
+    std::shared_ptr<KnobFlag<int>> pMaxTessFactor;
+    std::shared_ptr<KnobFlag<int>> pMaxAmplification;
+    std::shared_ptr<KnobFlag<int>> pSamples;
+    std::shared_ptr<KnobFlag<int>> pPasses;
+
+    grfx::CommandBufferPtr     mCommandBuffer;
+    grfx::FencePtr             mFence;
+    grfx::QueryPtr             mTimestampQuery;
+    grfx::DrawPassPtr          mDrawPass;
+    grfx::BufferPtr            mVertexBuffer;
+    grfx::BufferPtr            mIndexBuffer;
+    grfx::VertexBinding        mVertexBinding;
+    grfx::PipelineInterfacePtr mPipelineInterface;
+    uint32_t                   mGridTriangles = 0;
+
+    std::vector<Case> mCases;
+    uint32_t          mCaseIndex   = 0;
+    uint32_t          mFrameInCase = 0; // The first frame of a case is a warmup
+    uint32_t          mPass        = 0; // Over all cases
+    bool              mInFlight    = false;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pPrimitives, "primitives", 1000000);
+    pPrimitives->SetFlagDescription("Approximate number of primitives output by the draw of each case.");
+    pPrimitives->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pMaxTessFactor, "max-tess-factor", static_cast<int>(kMaxTessFactor));
+    pMaxTessFactor->SetFlagDescription("Tessellation factors above this are skipped, the factors are the powers of 2 up to 64.");
+    pMaxTessFactor->SetValidator([](int value) { return (value >= 1) && (value <= static_cast<int>(kMaxTessFactor)); });
+
+    GetKnobManager().InitKnob(&pMaxAmplification, "max-amplification", 32);
+    pMaxAmplification->SetFlagDescription("Geometry shader amplifications above this are skipped, the amplifications are the powers of 2 up to 32.");
+    pMaxAmplification->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pSamples, "samples", 10);
+    pSamples->SetFlagDescription("Number of frames each case is measured for, after a warmup frame.");
+    pSamples->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pPasses, "passes", 1);
+    pPasses->SetFlagDescription("Number of times all cases are measured before quitting, 0 to run until --frame-count or the end of --benchmark-repetitions.");
+    pPasses->SetValidator([](int value) { return value >= 0; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "tessellation_geometry";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.headless             = true;
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+void ProjApp::AddCase(const std::string& sweep, uint32_t value, uint64_t primitivesPerInput)
+{
+    const uint64_t primitives = static_cast<uint64_t>(pPrimitives->GetValue());
+
+    Case c             = {};
+    c.sweep            = sweep;
+    c.value            = value;
+    c.name             = (value > 0) ? (sweep + "_" + std::to_string(value)) : sweep;
+    c.inputTriangles   = static_cast<uint32_t>(std::max<uint64_t>(1, (primitives + primitivesPerInput / 2) / primitivesPerInput));
+    c.outputPrimitives = c.inputTriangles * primitivesPerInput;
+    mCases.push_back(c);
+}
+
+void ProjApp::SetupCases()
+{
+    if (!mCases.empty()) {
+        return;
+    }
+
+    AddCase("baseline", 0, 1);
+
+    if (GetDevice()->TessellationShaderSupported()) {
+        for (uint32_t factor = 1; factor <= static_cast<uint32_t>(pMaxTessFactor->GetValue()); factor *= 2) {
+            AddCase("tessellation_factor", factor, TessellatedTriangleCount(factor));
+        }
+    }
+    else {
+        PPX_LOG_WARN("Tessellation shaders are not supported, skipping the tessellation_factor cases");
+    }
+
+    if (GetDevice()->GeometryShaderSupported()) {
+        for (uint32_t amplification : kAmplifications) {
+            if (amplification <= static_cast<uint32_t>(pMaxAmplification->GetValue())) {
+                AddCase("geometry_amplification", amplification, amplification);
+            }
+        }
+    }
+    else {
+        PPX_LOG_WARN("Geometry shaders are not supported, skipping the geometry_amplification cases");
+    }
+}
+
+grfx::ShaderModulePtr ProjApp::LoadShaderModule(const std::string& name)
+{
+    std::vector<char> bytecode = LoadShader("benchmarks/shaders", name);
+    PPX_ASSERT_MSG(!bytecode.empty(), "Shader bytecode load failed: " << name);
+    grfx::ShaderModulePtr        shader;
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &shader));
+    return shader;
+}
+
+void ProjApp::SetupPipeline(Case& c)
+{
+    const bool tessellation = (c.sweep == "tessellation_factor");
+    const bool geometry     = (c.sweep == "geometry_amplification");
+
+    grfx::ShaderModulePtr VS = LoadShaderModule(tessellation ? "Tessellation.vs" : "PassThroughPos.vs");
+    grfx::ShaderModulePtr PS = LoadShaderModule(tessellation ? "Tessellation.ps" : "PassThroughPos.ps");
+    grfx::ShaderModulePtr HS;
+    grfx::ShaderModulePtr DS;
+    grfx::ShaderModulePtr GS;
+
+    grfx::GraphicsPipelineCreateInfo gpCreateInfo     = {};
+    gpCreateInfo.VS                                   = {VS.Get(), "vsmain"};
+    gpCreateInfo.PS                                   = {PS.Get(), "psmain"};
+    gpCreateInfo.vertexInputState.bindingCount        = 1;
+    gpCreateInfo.vertexInputState.bindings[0]         = mVertexBinding;
+    gpCreateInfo.inputAssemblyState.topology          = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    gpCreateInfo.rasterState.polygonMode              = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.rasterState.cullMode                 = grfx::CULL_MODE_NONE;
+    gpCreateInfo.rasterState.frontFace                = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.depthStencilState.depthTestEnable    = false;
+    gpCreateInfo.depthStencilState.depthWriteEnable   = false;
+    gpCreateInfo.colorBlendState.blendAttachmentCount = 1;
+    gpCreateInfo.outputState.renderTargetCount        = 1;
+    gpCreateInfo.outputState.renderTargetFormats[0]   = mDrawPass->GetRenderTargetTexture(0)->GetImageFormat();
+    gpCreateInfo.outputState.depthStencilFormat       = mDrawPass->GetDepthStencilTexture()->GetImageFormat();
+    gpCreateInfo.pPipelineInterface                   = mPipelineInterface;
+
+    if (tessellation) {
+        HS                                                = LoadShaderModule("Tessellation.hs");
+        DS                                                = LoadShaderModule("Tessellation.ds");
+        gpCreateInfo.HS                                   = {HS.Get(), "hsmain"};
+        gpCreateInfo.DS                                   = {DS.Get(), "dsmain"};
+        gpCreateInfo.inputAssemblyState.topology          = grfx::PRIMITIVE_TOPOLOGY_PATCH_LIST;
+        gpCreateInfo.tessellationState.patchControlPoints = 3;
+    }
+    else if (geometry) {
+        GS              = LoadShaderModule("GeometryAmplification_" + std::to_string(c.value) + ".gs");
+        gpCreateInfo.GS = {GS.Get(), "gsmain"};
+    }
+
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &c.pipeline));
+
+    for (grfx::ShaderModulePtr shader : {VS, PS, HS, DS, GS}) {
+        if (shader) {
+            GetDevice()->DestroyShaderModule(shader);
+        }
+    }
+}
+
+void ProjApp::Setup()
+{
+    SetupCases();
+
+    // Draw pass, 1x1 so that the cost is in the geometry stages
+    {
+        grfx::DrawPassCreateInfo createInfo     = {};
+        createInfo.width                        = 1;
+        createInfo.height                       = 1;
+        createInfo.renderTargetCount            = 1;
+        createInfo.renderTargetFormats[0]       = grfx::FORMAT_R16G16B16A16_FLOAT;
+        createInfo.depthStencilFormat           = grfx::FORMAT_D32_FLOAT;
+        createInfo.renderTargetInitialStates[0] = grfx::RESOURCE_STATE_RENDER_TARGET;
+        createInfo.depthStencilInitialState     = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE;
+        createInfo.renderTargetClearValues[0]   = {0, 0, 0, 0};
+        createInfo.depthStencilClearValue       = {1.0f, 0xFF};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mDrawPass));
+    }
+
+    // Grid large enough for the case with the most input triangles, each
+    // case draws a prefix of its indices
+    {
+        uint32_t maxInputTriangles = 0;
+        for (const Case& c : mCases) {
+            maxInputTriangles = std::max(maxInputTriangles, c.inputTriangles);
+        }
+
+        // A segments x segments grid has 2 * segments^2 triangles
+        const uint32_t segments = static_cast<uint32_t>(std::ceil(std::sqrt(maxInputTriangles / 2.0)));
+        TriMesh        mesh     = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Z, float2(1, 1), segments, segments, TriMeshOptions().Indices());
+        mGridTriangles          = mesh.GetCountTriangles();
+
+        grfx::BufferCreateInfo createInfo       = {};
+        createInfo.size                         = mesh.GetDataSizePositions();
+        createInfo.usageFlags.bits.vertexBuffer = true;
+        createInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mVertexBuffer));
+        PPX_CHECKED_CALL(mVertexBuffer->CopyFromSource(static_cast<uint32_t>(mesh.GetDataSizePositions()), mesh.GetDataPositions()));
+
+        createInfo                             = {};
+        createInfo.size                        = mesh.GetDataSizeIndices();
+        createInfo.usageFlags.bits.indexBuffer = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                = grfx::RESOURCE_STATE_INDEX_BUFFER;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&createInfo, &mIndexBuffer));
+        PPX_CHECKED_CALL(mIndexBuffer->CopyFromSource(static_cast<uint32_t>(mesh.GetDataSizeIndices()), mesh.GetDataIndicesU32()));
+
+        // TriMesh positions are float3, the missing w component reads as 1
+        mVertexBinding.AppendAttribute({"POSITION", 0, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+    }
+
+    // Pipelines, the push constants are only read by the tessellation cases
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 0;
+        piCreateInfo.pushConstants.count               = sizeof(TessellationParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding             = 0;
+        piCreateInfo.pushConstants.set                 = 0;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+        for (Case& c : mCases) {
+            SetupPipeline(c);
+        }
+    }
+
+    // Submission
+    {
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mCommandBuffer));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFence));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mTimestampQuery));
+    }
+
+    PPX_LOG_INFO("Measuring " << mCases.size() << " cases on a grid of " << mGridTriangles << " triangles");
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    // The first run starts before Setup()
+    SetupCases();
+
+    for (Case& c : mCases) {
+        metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, c.name, "Mprims/s", metrics::MetricInterpretation::HIGHER_IS_BETTER};
+        c.metricId                       = AddMetric(metadata);
+        PPX_ASSERT_MSG(c.metricId != metrics::kInvalidMetricID, "Failed to add metric " << c.name);
+    }
+}
+
+void ProjApp::FinishSample(Case& c, uint64_t ticks)
+{
+    uint64_t frequency = 0;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+    if ((ticks == 0) || (frequency == 0)) {
+        return;
+    }
+
+    const double seconds = static_cast<double>(ticks) / static_cast<double>(frequency);
+    const double mprims  = static_cast<double>(c.outputPrimitives) / seconds / 1e6;
+    c.totalMprims += mprims;
+    ++c.sampleCount;
+    ++c.meanCount;
+    c.meanMprims += (mprims - c.meanMprims) / static_cast<double>(c.meanCount);
+
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = mprims;
+    RecordMetricData(c.metricId, data);
+
+    if (c.sampleCount == static_cast<uint32_t>(pSamples->GetValue())) {
+        PPX_LOG_INFO(c.name << ": " << (c.totalMprims / c.sampleCount) << " Mprims/s");
+        c.totalMprims = 0.0;
+        c.sampleCount = 0;
+    }
+}
+
+void ProjApp::LogCliffs() const
+{
+    // Cases of a sweep are consecutive, the first step of a sweep is
+    // relative to the baseline
+    const Case* pBaseline = &mCases[0];
+    const Case* pPrevious = pBaseline;
+    const Case* pCliff    = nullptr;
+    double      cliffDrop = 0.0;
+    for (size_t i = 1; i <= mCases.size(); ++i) {
+        const Case* pCase = (i < mCases.size()) ? &mCases[i] : nullptr;
+        if ((pCase == nullptr) || (pCase->sweep != pPrevious->sweep)) {
+            if (pCliff != nullptr) {
+                PPX_LOG_INFO(pCliff->sweep << " cliff: " << cliffDrop << "x drop at " << pCliff->name << " (" << pCliff->meanMprims << " Mprims/s)");
+            }
+            pPrevious = pBaseline;
+            pCliff    = nullptr;
+            cliffDrop = 0.0;
+        }
+        if (pCase == nullptr) {
+            break;
+        }
+
+        const double drop = (pCase->meanMprims > 0.0) ? (pPrevious->meanMprims / pCase->meanMprims) : 0.0;
+        if (drop > cliffDrop) {
+            pCliff    = pCase;
+            cliffDrop = drop;
+        }
+        pPrevious = pCase;
+    }
+}
+
+void ProjApp::Render()
+{
+    PPX_CHECKED_CALL(mFence->WaitAndReset());
+
+    // Read back the previous frame's sample
+    if (mInFlight) {
+        uint64_t timestamps[2] = {0};
+        PPX_CHECKED_CALL(mTimestampQuery->GetData(timestamps, sizeof(timestamps)));
+        if (mFrameInCase > 0) {
+            FinishSample(mCases[mCaseIndex], timestamps[1] - timestamps[0]);
+        }
+
+        if (++mFrameInCase > static_cast<uint32_t>(pSamples->GetValue())) {
+            mFrameInCase = 0;
+            if (++mCaseIndex == CountU32(mCases)) {
+                mCaseIndex = 0;
+                LogCliffs();
+                if (++mPass == static_cast<uint32_t>(pPasses->GetValue())) {
+                    Quit();
+                }
+            }
+        }
+    }
+
+    const Case& c = mCases[mCaseIndex];
+
+    TessellationParams params = {};
+    params.tessFactor         = static_cast<float>(std::max<uint32_t>(1, c.value));
+
+    const grfx::Viewport viewport    = {0, 0, 1, 1, 0, 1};
+    const grfx::Rect     scissorRect = {0, 0, 1, 1};
+
+    mTimestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mCommandBuffer->Begin());
+    {
+        mCommandBuffer->BeginRenderPass(mDrawPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS);
+        {
+            mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+            mCommandBuffer->SetScissors(1, &scissorRect);
+            mCommandBuffer->SetViewports(1, &viewport);
+            mCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
+            mCommandBuffer->BindGraphicsPipeline(c.pipeline);
+            mCommandBuffer->PushGraphicsConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+            mCommandBuffer->BindIndexBuffer(mIndexBuffer, grfx::INDEX_TYPE_UINT32);
+            mCommandBuffer->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
+            mCommandBuffer->DrawIndexed(3 * c.inputTriangles);
+        }
+        mCommandBuffer->EndRenderPass();
+        mCommandBuffer->WriteTimestamp(mTimestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mCommandBuffer->ResolveQueryData(mTimestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mCommandBuffer->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &mCommandBuffer;
+    submitInfo.pFence             = mFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    mInFlight = true;
+}
+
+SETUP_APPLICATION(ProjApp)
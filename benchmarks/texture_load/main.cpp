@@ -14,7 +14,9 @@
 
 #include <filesystem>
 
+#include "ppx/bitmap.h"
 #include "ppx/config.h"
+#include "ppx/fs.h"
 #include "ppx/math_config.h"
 #include "ppx/graphics_util.h"
 #include "ppx/grfx/grfx_config.h"
@@ -22,6 +24,7 @@
 #include "ppx/log.h"
 #include "ppx/ppx.h"
 #include "ppx/csv_file_log.h"
+#include "ppx/timer.h"
 
 using namespace ppx;
 
@@ -42,6 +45,9 @@ public:
     void SaveResultsToFile();
 
 private:
+    // Logs the decode rate of every available bitmap decoder for path
+    void BenchmarkDecoders(const std::filesystem::path& path, uint32_t iterations);
+
     struct PerFrame
     {
         ppx::grfx::CommandBufferPtr cmd;
@@ -49,7 +55,6 @@ private:
         ppx::grfx::FencePtr         imageAcquiredFence;
         ppx::grfx::SemaphorePtr     renderCompleteSemaphore;
         ppx::grfx::FencePtr         renderCompleteFence;
-        ppx::grfx::QueryPtr         timestampQuery;
     };
 
     std::vector<PerFrame>           mPerFrame;
@@ -74,7 +79,6 @@ private:
     std::vector<ppx::grfx::SampledImageViewPtr> mSampledImageViews;
 
     // Stats
-    uint64_t    mGpuWorkDuration = 0;
     std::string mCSVFileName;
     struct PerFrameRegister
     {
@@ -91,6 +95,7 @@ void ProjApp::Config(ppx::ApplicationSettings& settings)
     settings.enableImGui                    = false;
     settings.grfx.api                       = kApi;
     settings.grfx.device.graphicsQueueCount = 1;
+    settings.grfx.gpuProfiler.enable        = true;
 }
 
 void ProjApp::SaveResultsToFile()
@@ -103,6 +108,39 @@ void ProjApp::SaveResultsToFile()
     }
 }
 
+void ProjApp::BenchmarkDecoders(const std::filesystem::path& path, uint32_t iterations)
+{
+    std::optional<std::vector<char>> data = fs::load_file(path);
+    if (!data.has_value()) {
+        PPX_LOG_WARN("Failed to read " << path << " for the decode benchmark");
+        return;
+    }
+
+    for (Bitmap::Decoder decoder : {Bitmap::DECODER_STB, Bitmap::DECODER_TURBOJPEG, Bitmap::DECODER_SPNG}) {
+        if (!Bitmap::IsDecoderAvailable(decoder)) {
+            continue;
+        }
+
+        Bitmap bitmap;
+        Timer  timer;
+        timer.Start();
+        for (uint32_t i = 0; i < iterations; ++i) {
+            if (Failed(Bitmap::LoadFromMemory(data->size(), data->data(), 0, nullptr, &bitmap, decoder))) {
+                break;
+            }
+        }
+        const double seconds = timer.SecondsSinceStart();
+        if (!bitmap.IsOk()) {
+            PPX_LOG_INFO("Decoder " << Bitmap::ToString(decoder) << " can't decode " << path);
+            continue;
+        }
+
+        // Rate of decoded pixel data
+        const double megabytes = static_cast<double>(bitmap.GetFootprintSize()) * iterations / (1024.0 * 1024.0);
+        PPX_LOG_INFO("Decoder " << Bitmap::ToString(decoder) << ": " << (megabytes / seconds) << " MB/s");
+    }
+}
+
 void ProjApp::Setup()
 {
     auto cl_options = GetExtraOptions();
@@ -121,6 +159,9 @@ void ProjApp::Setup()
         PPX_LOG_WARN("Invalid name for CSV log file, defaulting to: " + mCSVFileName);
     }
 
+    // Decodes of the texture file per decoder for the decode benchmark, 0 skips it
+    const uint32_t decodeIterations = cl_options.GetExtraOptionValueOrDefault<uint32_t>("decode-iterations", 0);
+
     // Per frame data
     {
         PerFrame frame = {};
@@ -138,11 +179,6 @@ void ProjApp::Setup()
         fenceCreateInfo = {true}; // Create signaled
         PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.renderCompleteFence));
 
-        grfx::QueryCreateInfo queryCreateInfo = {};
-        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
-        queryCreateInfo.count                 = 2;
-        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &frame.timestampQuery));
-
         mPerFrame.push_back(frame);
     }
 
@@ -204,6 +240,10 @@ void ProjApp::Setup()
 
         grfx_util::ImageOptions options = grfx_util::ImageOptions().MipLevelCount(1);
 
+        if (decodeIterations > 0) {
+            BenchmarkDecoders(GetAssetPath("benchmarks/textures/bricks_" + res + ".png"), decodeIterations);
+        }
+
         for (uint32_t i = 0; i < mNumImages; ++i) {
             grfx::ImagePtr image;
             PPX_CHECKED_CALL(grfx_util::CreateImageFromFile(GetDevice()->GetGraphicsQueue(), GetAssetPath("benchmarks/textures/bricks_" + res + ".png"), &image, options, false));
@@ -291,14 +331,8 @@ void ProjApp::Render()
     // Wait for and reset image acquired fence
     PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
 
-    // Read query results
-    if (GetFrameCount() > 0) {
-        uint64_t data[2] = {0};
-        PPX_CHECKED_CALL(frame.timestampQuery->GetData(data, 2 * sizeof(uint64_t)));
-        mGpuWorkDuration = data[1] - data[0];
-    }
-    // Reset queries
-    frame.timestampQuery->Reset(0, 2);
+    // Read the previous frame's GPU scopes, the fence wait above made them available
+    GetGpuProfiler()->BeginFrame(0);
 
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
@@ -312,17 +346,17 @@ void ProjApp::Render()
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
         frame.cmd->BeginRenderPass(renderPass);
         {
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+            GetGpuProfiler()->BeginScope(frame.cmd, "draw");
             frame.cmd->SetScissors(1, &mScissorRect);
             frame.cmd->SetViewports(1, &mViewport);
             frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mDescriptorSet);
             frame.cmd->BindGraphicsPipeline(mPipeline);
             frame.cmd->BindVertexBuffers(1, &mVertexBuffer, &mVertexBinding.GetStride());
             frame.cmd->Draw(6, 1, 0, 0);
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+            GetGpuProfiler()->EndScope(frame.cmd);
         }
         frame.cmd->EndRenderPass();
-        frame.cmd->ResolveQueryData(frame.timestampQuery, 0, 2);
+        GetGpuProfiler()->EndFrame(frame.cmd);
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
     }
     PPX_CHECKED_CALL(frame.cmd->End());
@@ -339,10 +373,8 @@ void ProjApp::Render()
     PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
 
     PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
-    if (GetFrameCount() > 0) {
-        uint64_t frequency = 0;
-        GetGraphicsQueue()->GetTimestampFrequency(&frequency);
-        const float      gpuWorkDuration = static_cast<float>(mGpuWorkDuration / static_cast<double>(frequency)) * 1000.0f;
+    if (GetGpuProfiler()->GetScopesFrameNumber() > 0) {
+        const float      gpuWorkDuration = static_cast<float>(GetGpuProfiler()->GetScopes()[0].gpuMs);
         PerFrameRegister stats           = {};
         stats.frameNumber                = GetFrameCount();
         stats.gpuWorkDuration            = gpuWorkDuration;
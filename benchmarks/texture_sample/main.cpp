@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include <filesystem>
+#include <memory>
 
 #include "ppx/config.h"
 #include "ppx/math_config.h"
@@ -22,6 +23,7 @@
 #include "ppx/grfx/grfx_enums.h"
 #include "ppx/grfx/grfx_image.h"
 #include "ppx/log.h"
+#include "ppx/mipmap.h"
 #include "ppx/ppx.h"
 #include "ppx/csv_file_log.h"
 
@@ -46,6 +48,10 @@ public:
 private:
     std::vector<float> GetRectSizeScaleFactors();
 
+    void SetupSparseTexture();
+    void UpdateSparseResidency(grfx::CommandBuffer* pCmd);
+    void WriteSparseTexels(uint32_t mipLevel, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t rowStride, uint8_t* pDst) const;
+
     struct PerFrame
     {
         ppx::grfx::CommandBufferPtr cmd;
@@ -79,6 +85,21 @@ private:
     ppx::grfx::SamplerPtr                       mSampler;
     std::string                                 mSamplerFilterType;
     std::string                                 mSamplerMipmapFilterType;
+    grfx::Format                                mCompressedFormat = grfx::FORMAT_UNDEFINED; // Block compressed copy of the loaded textures is sampled if set
+
+    // Sparse resident texture (--sparse-size), tiles are bound and filled
+    // as the feedback reports them sampled. The least recently sampled
+    // tiles are unbound once more than mSparseTileBudget are resident.
+    uint32_t                     mSparseSize          = 0;
+    uint32_t                     mSparseTilesPerFrame = 0;
+    uint32_t                     mSparseTileBudget    = 0;
+    grfx::SparseImageFeedbackPtr mSparseFeedback;
+    grfx::BufferPtr              mSparseConstantBuffer;
+    grfx::BufferPtr              mSparseStagingBuffer;
+    grfx::SemaphorePtr           mSparseBindSemaphore;
+    uint64_t                     mSparseBindValue = 0;
+    std::vector<uint64_t>        mSparseTileLastUse; // Frame each tile was last sampled in, by tile index
+    std::vector<uint32_t>        mSparseResidentTiles;
 
     // Drawn rectangle sizes (number of mipmaps of target resolution)
     uint32_t mNumRectSizes = 0;
@@ -148,10 +169,41 @@ void ProjApp::Setup()
         PPX_LOG_WARN("Invalid sampler mipmap filter type (must be `linear` or `nearest`), defaulting to: " + mSamplerMipmapFilterType);
     }
 
+    // Block compression (`bc1` or `bc3`) applied to the loaded texture on
+    // the GPU, to compare sampling it against the uncompressed texture.
+    const std::string compressFormat = cl_options.GetExtraOptionValueOrDefault<std::string>("compress-format", "none");
+    if (compressFormat == "bc1") {
+        mCompressedFormat = grfx::FORMAT_BC1_RGB_UNORM;
+    }
+    else if (compressFormat == "bc3") {
+        mCompressedFormat = grfx::FORMAT_BC3_UNORM;
+    }
+    else if (compressFormat != "none") {
+        PPX_LOG_WARN("Invalid compression format (must be `none`, `bc1` or `bc3`), defaulting to: none");
+    }
+    if ((mCompressedFormat != grfx::FORMAT_UNDEFINED) && !GetDevice()->SampledImageFormatSupported(mCompressedFormat)) {
+        mCompressedFormat = grfx::FORMAT_UNDEFINED;
+        PPX_LOG_WARN("Compression format " << compressFormat << " can't be sampled on this device, using the uncompressed texture");
+    }
+
     // Forced mip level to use for all frames (instead of cycling through all mip levels, one per frame).
     // This value is validated once the image is created and the mip level count is known.
     mForcedMipLevel = cl_options.GetExtraOptionValueOrDefault<int32_t>("force-mip-level", -1);
 
+    // Size of a procedural sparse resident texture that replaces the loaded
+    // one, 0 disables it. Tiles are streamed in as they are sampled.
+    mSparseSize          = cl_options.GetExtraOptionValueOrDefault<uint32_t>("sparse-size", 0);
+    mSparseTilesPerFrame = std::max(cl_options.GetExtraOptionValueOrDefault<uint32_t>("sparse-tiles-per-frame", 16), 1u);
+    mSparseTileBudget    = std::max(cl_options.GetExtraOptionValueOrDefault<uint32_t>("sparse-tile-budget", 1024), mSparseTilesPerFrame);
+    if ((mSparseSize > 0) && !(GetDevice()->SparseResidencySupported() && GetDevice()->FragmentStoresAndAtomicsSupported())) {
+        mSparseSize = 0;
+        PPX_LOG_WARN("Sparse residency is not supported, using the regular texture");
+    }
+    if ((mSparseSize > 0) && (mNumImages != 1)) {
+        mNumImages = 1;
+        PPX_LOG_WARN("Sparse textures only use 1 image");
+    }
+
     // Per frame data
     {
         PerFrame frame = {};
@@ -236,6 +288,8 @@ void ProjApp::Setup()
         grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
         poolCreateInfo.sampledImage                   = mNumImages;
         poolCreateInfo.sampler                        = 1;
+        poolCreateInfo.structuredBuffer               = (mSparseSize > 0) ? 1 : 0;
+        poolCreateInfo.uniformBuffer                  = (mSparseSize > 0) ? 1 : 0;
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
     }
 
@@ -246,6 +300,10 @@ void ProjApp::Setup()
             layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(i, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, grfx::SHADER_STAGE_PS));
         }
         layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(mNumImages, grfx::DESCRIPTOR_TYPE_SAMPLER, 1, grfx::SHADER_STAGE_PS));
+        if (mSparseSize > 0) {
+            layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(2, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_PS));
+            layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(3, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_PS));
+        }
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mDescriptorSetLayout));
     }
 
@@ -258,10 +316,38 @@ void ProjApp::Setup()
 
         grfx_util::ImageOptions options = grfx_util::ImageOptions().MipLevelCount(PPX_REMAINING_MIP_LEVELS);
 
+        std::unique_ptr<grfx::BlockCompressor> compressor;
+        grfx::ShaderModulePtr                  compressShader;
+        if ((mCompressedFormat != grfx::FORMAT_UNDEFINED) && (mSparseSize == 0)) {
+            std::vector<char> bytecode = LoadShader("basic/shaders", "CompressBlocks.cs");
+            PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+            grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+            PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &compressShader));
+
+            grfx::BlockCompressorCreateInfo compressorCreateInfo = {};
+            compressorCreateInfo.pShader                         = compressShader;
+
+            grfx::BlockCompressor* pCompressor = nullptr;
+            PPX_CHECKED_CALL(grfx::BlockCompressor::Create(GetDevice(), compressorCreateInfo, &pCompressor));
+            compressor.reset(pCompressor);
+        }
+
         for (uint32_t i = 0; i < mNumImages; ++i) {
             grfx::ImagePtr image;
-            PPX_CHECKED_CALL(grfx_util::CreateImageFromFile(GetDevice()->GetGraphicsQueue(), GetAssetPath("benchmarks/textures/bricks_" + res + ".png"), &image, options, false));
-            mImages.push_back(image);
+            if (mSparseSize > 0) {
+                SetupSparseTexture();
+                image = mImages.back();
+            }
+            else {
+                PPX_CHECKED_CALL(grfx_util::CreateImageFromFile(GetDevice()->GetGraphicsQueue(), GetAssetPath("benchmarks/textures/bricks_" + res + ".png"), &image, options, false));
+                if (compressor) {
+                    grfx::ImagePtr compressedImage;
+                    PPX_CHECKED_CALL(grfx_util::CompressImage(GetGraphicsQueue(), compressor.get(), image, grfx::RESOURCE_STATE_SHADER_RESOURCE, mCompressedFormat, &compressedImage));
+                    GetDevice()->DestroyImage(image);
+                    image = compressedImage;
+                }
+                mImages.push_back(image);
+            }
 
             grfx::SampledImageViewPtr        imageView;
             grfx::SampledImageViewCreateInfo viewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(image);
@@ -273,6 +359,11 @@ void ProjApp::Setup()
                 PPX_LOG_WARN("Invalid mip level, defaulting to all mip levels");
             }
         }
+        if (compressor) {
+            compressor.reset();
+            GetDevice()->DestroyShaderModule(compressShader);
+        }
+
         grfx::SamplerCreateInfo samplerCreateInfo;
         grfx::Filter            filter       = mSamplerFilterType == "linear" ? grfx::FILTER_LINEAR : grfx::FILTER_NEAREST;
         grfx::SamplerMipmapMode mipmapFilter = mSamplerMipmapFilterType == "linear" ? grfx::SAMPLER_MIPMAP_MODE_LINEAR : grfx::SAMPLER_MIPMAP_MODE_NEAREST;
@@ -285,6 +376,9 @@ void ProjApp::Setup()
     // Pipeline
     {
         std::string shaderName = mNumImages == 1 ? "TextureSample" : "TextureSample4Textures";
+        if (mSparseSize > 0) {
+            shaderName = "TextureSampleSparse";
+        }
 
         std::vector<char> bytecode = LoadShader("benchmarks/shaders", shaderName + ".vs");
         PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
@@ -346,9 +440,243 @@ void ProjApp::Setup()
         sampler.pSampler = mSampler;
 
         PPX_CHECKED_CALL(mDescriptorSet->UpdateDescriptors(1, &sampler));
+
+        if (mSparseSize > 0) {
+            grfx::WriteDescriptor feedback;
+            feedback.binding                = 2;
+            feedback.type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+            feedback.bufferOffset           = 0;
+            feedback.bufferRange            = PPX_WHOLE_SIZE;
+            feedback.structuredElementCount = mImages[0]->GetSparseTileCount();
+            feedback.pBuffer                = mSparseFeedback->GetBuffer();
+            PPX_CHECKED_CALL(mDescriptorSet->UpdateDescriptors(1, &feedback));
+
+            PPX_CHECKED_CALL(mDescriptorSet->UpdateUniformBuffer(3, 0, mSparseConstantBuffer));
+        }
     }
 }
 
+void ProjApp::SetupSparseTexture()
+{
+    grfx::ImageCreateInfo createInfo       = grfx::ImageCreateInfo::SampledImage2D(mSparseSize, mSparseSize, grfx::FORMAT_R8G8B8A8_UNORM);
+    createInfo.mipLevelCount               = Mipmap::CalculateLevelCount(mSparseSize, mSparseSize);
+    createInfo.usageFlags.bits.transferDst = true;
+    createInfo.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+    createInfo.sparseResidency             = true;
+
+    grfx::ImagePtr image;
+    PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &image));
+    mImages.push_back(image);
+
+    const grfx::SparseImageProperties& properties = image->GetSparseProperties();
+    PPX_LOG_INFO("Sparse texture: " << mSparseSize << "x" << mSparseSize << ", " << image->GetSparseTileCount() << " tiles of " << properties.tileWidth << "x" << properties.tileHeight << ", mip tail from level " << properties.firstMipTailLevel);
+
+    grfx::SparseImageFeedbackCreateInfo feedbackCreateInfo = {};
+    feedbackCreateInfo.pImage                              = image;
+    PPX_CHECKED_CALL(GetDevice()->CreateSparseImageFeedback(&feedbackCreateInfo, &mSparseFeedback));
+
+    // Feedback constants
+    {
+        grfx::BufferCreateInfo bufferCreateInfo        = {};
+        bufferCreateInfo.size                          = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+        bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+        bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mSparseConstantBuffer));
+        PPX_CHECKED_CALL(mSparseConstantBuffer->CopyFromSource(sizeof(grfx::SparseImageFeedbackConstants), &mSparseFeedback->GetConstants()));
+    }
+
+    grfx::SemaphoreCreateInfo semaCreateInfo = {};
+    semaCreateInfo.semaphoreType             = grfx::SEMAPHORE_TYPE_TIMELINE;
+    PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &mSparseBindSemaphore));
+
+    mSparseTileLastUse.assign(image->GetSparseTileCount(), 0);
+
+    // Tiles of one frame, tightly packed rows of whole tiles keep the
+    // D3D12 pitch and placement alignments.
+    const uint64_t tileBytes = static_cast<uint64_t>(properties.tileWidth) * properties.tileHeight * 4;
+    {
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = RoundUp<uint64_t>(tileBytes, PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT) * mSparseTilesPerFrame;
+        bufferCreateInfo.usageFlags.bits.transferSrc = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mSparseStagingBuffer));
+    }
+
+    // The mip tail is always resident, fill it once
+    const uint32_t firstMipTailLevel = std::min(properties.firstMipTailLevel, image->GetMipLevelCount());
+    if (firstMipTailLevel < image->GetMipLevelCount()) {
+        std::vector<grfx::BufferToImageCopyInfo> copyInfos;
+        uint64_t                                 size = 0;
+        for (uint32_t mip = firstMipTailLevel; mip < image->GetMipLevelCount(); ++mip) {
+            const uint32_t mipSize = std::max(mSparseSize >> mip, 1u);
+
+            grfx::BufferToImageCopyInfo copyInfo = {};
+            copyInfo.srcBuffer.imageWidth        = mipSize;
+            copyInfo.srcBuffer.imageHeight       = mipSize;
+            copyInfo.srcBuffer.imageRowStride    = RoundUp<uint32_t>(mipSize * 4, PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+            copyInfo.srcBuffer.footprintOffset   = size;
+            copyInfo.srcBuffer.footprintWidth    = mipSize;
+            copyInfo.srcBuffer.footprintHeight   = mipSize;
+            copyInfo.srcBuffer.footprintDepth    = 1;
+            copyInfo.dstImage.mipLevel           = mip;
+            copyInfo.dstImage.arrayLayer         = 0;
+            copyInfo.dstImage.arrayLayerCount    = 1;
+            copyInfo.dstImage.width              = mipSize;
+            copyInfo.dstImage.height             = mipSize;
+            copyInfo.dstImage.depth              = 1;
+            copyInfos.push_back(copyInfo);
+
+            size += RoundUp<uint64_t>(static_cast<uint64_t>(copyInfo.srcBuffer.imageRowStride) * mipSize, PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        }
+
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = size;
+        bufferCreateInfo.usageFlags.bits.transferSrc = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        grfx::BufferPtr stagingBuffer;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &stagingBuffer));
+
+        uint8_t* pMapped = nullptr;
+        PPX_CHECKED_CALL(stagingBuffer->MapMemory(0, reinterpret_cast<void**>(&pMapped)));
+        for (const auto& copyInfo : copyInfos) {
+            WriteSparseTexels(copyInfo.dstImage.mipLevel, 0, 0, copyInfo.dstImage.width, copyInfo.dstImage.height, copyInfo.srcBuffer.imageRowStride, pMapped + copyInfo.srcBuffer.footprintOffset);
+        }
+        stagingBuffer->UnmapMemory();
+
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CopyBufferToImage(copyInfos, stagingBuffer, image, 0, image->GetMipLevelCount(), 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE));
+        GetDevice()->DestroyBuffer(stagingBuffer);
+    }
+}
+
+void ProjApp::WriteSparseTexels(uint32_t mipLevel, uint32_t x, uint32_t y, uint32_t width, uint32_t height, uint32_t rowStride, uint8_t* pDst) const
+{
+    // Checkerboard in texture space tinted by mip level, so streamed in
+    // tiles and the mip levels they replace are easy to tell apart
+    const uint32_t checkerSize = std::max(64u >> std::min(mipLevel, 6u), 1u);
+    const uint8_t  r           = static_cast<uint8_t>(((mipLevel + 1) * 97) & 0xFF);
+    const uint8_t  g           = static_cast<uint8_t>(((mipLevel + 1) * 59) & 0xFF);
+    const uint8_t  b           = static_cast<uint8_t>(((mipLevel + 1) * 31) & 0xFF);
+    for (uint32_t row = 0; row < height; ++row) {
+        uint8_t* pTexel = pDst + row * rowStride;
+        for (uint32_t col = 0; col < width; ++col) {
+            const bool dark = ((((x + col) / checkerSize) + ((y + row) / checkerSize)) & 1) != 0;
+            pTexel[0]       = dark ? (r / 2) : r;
+            pTexel[1]       = dark ? (g / 2) : g;
+            pTexel[2]       = dark ? (b / 2) : b;
+            pTexel[3]       = 0xFF;
+            pTexel += 4;
+        }
+    }
+}
+
+void ProjApp::UpdateSparseResidency(grfx::CommandBuffer* pCmd)
+{
+    grfx::Image*                       pImage      = mImages[0];
+    const grfx::SparseImageProperties& properties  = pImage->GetSparseProperties();
+    const uint64_t                     frameNumber = GetFrameCount() + 1;
+
+    // The previous frame has completed, its feedback is ready
+    std::vector<grfx::SparseImageTile> sampledTiles;
+    PPX_CHECKED_CALL(mSparseFeedback->GetSampledTiles(0, &sampledTiles));
+
+    std::vector<grfx::SparseImageTile> bindTiles;
+    for (const auto& tile : sampledTiles) {
+        mSparseTileLastUse[pImage->GetSparseTileIndex(tile)] = frameNumber;
+        if (!pImage->IsSparseTileResident(tile)) {
+            bindTiles.push_back(tile);
+        }
+    }
+    if (bindTiles.empty()) {
+        return;
+    }
+
+    // Coarse mip levels first, they cover more of the screen per tile
+    std::sort(bindTiles.begin(), bindTiles.end(), [](const grfx::SparseImageTile& a, const grfx::SparseImageTile& b) { return a.mipLevel > b.mipLevel; });
+    if (bindTiles.size() > mSparseTilesPerFrame) {
+        bindTiles.resize(mSparseTilesPerFrame);
+    }
+
+    // Evict the least recently sampled tiles, never ones sampled this frame
+    std::vector<grfx::SparseImageTile> unbindTiles;
+    const size_t                       residentCount = mSparseResidentTiles.size() + bindTiles.size();
+    if (residentCount > mSparseTileBudget) {
+        std::sort(mSparseResidentTiles.begin(), mSparseResidentTiles.end(), [this](uint32_t a, uint32_t b) { return mSparseTileLastUse[a] < mSparseTileLastUse[b]; });
+
+        size_t evictCount = residentCount - mSparseTileBudget;
+        size_t i          = 0;
+        for (; (i < mSparseResidentTiles.size()) && (unbindTiles.size() < evictCount); ++i) {
+            if (mSparseTileLastUse[mSparseResidentTiles[i]] == frameNumber) {
+                break;
+            }
+            unbindTiles.push_back(pImage->GetSparseTile(mSparseResidentTiles[i]));
+        }
+        mSparseResidentTiles.erase(mSparseResidentTiles.begin(), mSparseResidentTiles.begin() + i);
+
+        // Over budget with tiles that are all in use, bind fewer
+        const size_t bindCount = std::min(bindTiles.size(), mSparseTileBudget - mSparseResidentTiles.size());
+        bindTiles.resize(bindCount);
+        if (bindTiles.empty() && unbindTiles.empty()) {
+            return;
+        }
+    }
+
+    grfx::Semaphore*          pSignalSemaphore = mSparseBindSemaphore;
+    grfx::SparseImageBindInfo bindInfo         = {};
+    bindInfo.pImage                            = pImage;
+    bindInfo.bindTileCount                     = CountU32(bindTiles);
+    bindInfo.pBindTiles                        = DataPtr(bindTiles);
+    bindInfo.unbindTileCount                   = CountU32(unbindTiles);
+    bindInfo.pUnbindTiles                      = DataPtr(unbindTiles);
+    bindInfo.signalSemaphoreCount              = 1;
+    bindInfo.ppSignalSemaphores                = &pSignalSemaphore;
+    bindInfo.signalValues                      = {++mSparseBindValue};
+    PPX_CHECKED_CALL(GetGraphicsQueue()->BindSparseImageTiles(&bindInfo));
+
+    if (bindTiles.empty()) {
+        return;
+    }
+
+    // Fill the new tiles before the frame samples them
+    const uint64_t tileStride = RoundUp<uint64_t>(static_cast<uint64_t>(properties.tileWidth) * properties.tileHeight * 4, PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+    std::vector<grfx::BufferToImageCopyInfo> copyInfos;
+    uint8_t*                                 pMapped = nullptr;
+    PPX_CHECKED_CALL(mSparseStagingBuffer->MapMemory(0, reinterpret_cast<void**>(&pMapped)));
+    for (size_t i = 0; i < bindTiles.size(); ++i) {
+        const grfx::SparseImageTile& tile    = bindTiles[i];
+        const uint32_t               mipSize = std::max(mSparseSize >> tile.mipLevel, 1u);
+        const uint32_t               x       = tile.x * properties.tileWidth;
+        const uint32_t               y       = tile.y * properties.tileHeight;
+
+        grfx::BufferToImageCopyInfo copyInfo = {};
+        copyInfo.srcBuffer.imageWidth        = properties.tileWidth;
+        copyInfo.srcBuffer.imageHeight       = properties.tileHeight;
+        copyInfo.srcBuffer.imageRowStride    = properties.tileWidth * 4;
+        copyInfo.srcBuffer.footprintOffset   = i * tileStride;
+        copyInfo.srcBuffer.footprintWidth    = std::min(properties.tileWidth, mipSize - x);
+        copyInfo.srcBuffer.footprintHeight   = std::min(properties.tileHeight, mipSize - y);
+        copyInfo.srcBuffer.footprintDepth    = 1;
+        copyInfo.dstImage.mipLevel           = tile.mipLevel;
+        copyInfo.dstImage.arrayLayer         = 0;
+        copyInfo.dstImage.arrayLayerCount    = 1;
+        copyInfo.dstImage.x                  = x;
+        copyInfo.dstImage.y                  = y;
+        copyInfo.dstImage.width              = copyInfo.srcBuffer.footprintWidth;
+        copyInfo.dstImage.height             = copyInfo.srcBuffer.footprintHeight;
+        copyInfo.dstImage.depth              = 1;
+        copyInfos.push_back(copyInfo);
+
+        WriteSparseTexels(tile.mipLevel, x, y, copyInfo.dstImage.width, copyInfo.dstImage.height, copyInfo.srcBuffer.imageRowStride, pMapped + copyInfo.srcBuffer.footprintOffset);
+        mSparseResidentTiles.push_back(pImage->GetSparseTileIndex(tile));
+    }
+    mSparseStagingBuffer->UnmapMemory();
+
+    pCmd->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_COPY_DST);
+    pCmd->CopyBufferToImage(copyInfos, mSparseStagingBuffer, pImage);
+    pCmd->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+}
+
 void ProjApp::Render()
 {
     PerFrame& frame = mPerFrame[0];
@@ -381,6 +709,10 @@ void ProjApp::Render()
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
     {
+        if (mSparseSize > 0) {
+            UpdateSparseResidency(frame.cmd);
+        }
+
         grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
         PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
 
@@ -401,18 +733,28 @@ void ProjApp::Render()
         }
         frame.cmd->EndRenderPass();
         frame.cmd->ResolveQueryData(frame.timestampQuery, 0, 2);
+        if (mSparseSize > 0) {
+            mSparseFeedback->RecordReadback(0, frame.cmd);
+        }
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
     }
     PPX_CHECKED_CALL(frame.cmd->End());
 
+    // Sampled tiles are bound before the frame runs
+    const grfx::Semaphore* ppWaitSemaphores[2] = {frame.imageAcquiredSemaphore, mSparseBindSemaphore};
+
     grfx::SubmitInfo submitInfo     = {};
     submitInfo.commandBufferCount   = 1;
     submitInfo.ppCommandBuffers     = &frame.cmd;
     submitInfo.waitSemaphoreCount   = 1;
-    submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
+    submitInfo.ppWaitSemaphores     = ppWaitSemaphores;
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
     submitInfo.pFence               = frame.renderCompleteFence;
+    if (mSparseBindValue > 0) {
+        submitInfo.waitSemaphoreCount = 2;
+        submitInfo.waitValues         = {0, mSparseBindValue};
+    }
 
     PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
 
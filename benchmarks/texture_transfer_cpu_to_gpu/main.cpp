@@ -65,6 +65,7 @@ private:
     // Test parameters
     std::vector<std::string> mTextureNames;
     std::string              mCSVFileName;
+    grfx::ImageHostUpload    mUploadMode = grfx::IMAGE_HOST_UPLOAD_NONE;
 
     // Textures
     std::vector<ppx::grfx::SampledImageViewPtr> mSampledImageViews;
@@ -75,9 +76,11 @@ private:
 
     struct PerFrameRegister
     {
-        uint64_t frameNumber;
-        float    cpuTransferTimeMs;
-        uint2    textureSize;
+        uint64_t    frameNumber;
+        float       cpuTransferTimeMs;
+        uint2       textureSize;
+        const char* uploadMode;
+        float       bandwidthMBps;
     };
     std::deque<PerFrameRegister> mFrameRegisters;
 };
@@ -96,7 +99,9 @@ void ProjApp::SaveResultsToFile()
         fileLogger.LogField(row.frameNumber);
         fileLogger.LogField(row.cpuTransferTimeMs);
         fileLogger.LogField(row.textureSize.x);
-        fileLogger.LastField(row.textureSize.y);
+        fileLogger.LogField(row.textureSize.y);
+        fileLogger.LogField(row.uploadMode);
+        fileLogger.LastField(row.bandwidthMBps);
     }
 }
 
@@ -140,6 +145,21 @@ void ProjApp::SetupTestParameters()
         }
     }
 
+    // How textures are uploaded: "staged" copies through a staging buffer,
+    // "linear" and "host-image-copy" write the image from the CPU directly.
+    // Textures whose format doesn't support the direct mode fall back to
+    // staged, the CSV records the mode that was used.
+    std::string uploadMode = cl_options.GetExtraOptionValueOrDefault<std::string>("upload-mode", "staged");
+    if (uploadMode == "linear") {
+        mUploadMode = grfx::IMAGE_HOST_UPLOAD_LINEAR;
+    }
+    else if (uploadMode == "host-image-copy") {
+        mUploadMode = grfx::IMAGE_HOST_UPLOAD_HOST_IMAGE_COPY;
+    }
+    else if (uploadMode != "staged") {
+        PPX_LOG_WARN("Invalid --upload-mode, value must be one of staged, linear or host-image-copy, defaulting to: staged");
+    }
+
     // Name of the CSV output file
     mCSVFileName = cl_options.GetExtraOptionValueOrDefault<std::string>("stats-file", "stats.csv");
     if (mCSVFileName.empty()) {
@@ -223,6 +243,13 @@ void ProjApp::TransferTexture(const std::string fileName)
     Bitmap bitmap;
     // Load bitmap to CPU from file
     PPX_CHECKED_CALL(Bitmap::LoadFile(GetAssetPath(fileName), &bitmap));
+
+    grfx::Format          format     = grfx_util::ToGrfxFormat(bitmap.GetFormat());
+    grfx::ImageHostUpload uploadMode = mUploadMode;
+    if (!GetDevice()->ImageHostUploadSupported(uploadMode, format)) {
+        uploadMode = grfx::IMAGE_HOST_UPLOAD_NONE;
+    }
+
     // Create target image
     grfx::ImagePtr image;
     {
@@ -231,14 +258,19 @@ void ProjApp::TransferTexture(const std::string fileName)
         ci.width                       = bitmap.GetWidth();
         ci.height                      = bitmap.GetHeight();
         ci.depth                       = 1;
-        ci.format                      = grfx_util::ToGrfxFormat(bitmap.GetFormat());
+        ci.format                      = format;
         ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
         ci.mipLevelCount               = 1;
         ci.arrayLayerCount             = 1;
-        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.transferDst = (uploadMode == grfx::IMAGE_HOST_UPLOAD_NONE);
         ci.usageFlags.bits.sampled     = true;
         ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
         ci.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+        ci.hostUpload                  = uploadMode;
+        if (uploadMode != grfx::IMAGE_HOST_UPLOAD_NONE) {
+            // Host writes need the image in the general layout
+            ci.initialState = grfx::RESOURCE_STATE_GENERAL;
+        }
 
         PPX_CHECKED_CALL(GetDevice()->CreateImage(&ci, &image));
     }
@@ -246,7 +278,12 @@ void ProjApp::TransferTexture(const std::string fileName)
     // Since we time in CPU we put a hard barrier to ensure GPU finishes
     GetDevice()->WaitIdle();
     double transferStartTimeMs = timer.MillisSinceStart();
-    PPX_CHECKED_CALL(grfx_util::CopyBitmapToImage(GetDevice()->GetGraphicsQueue(), &bitmap, image, 0, 0, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE));
+    if (uploadMode == grfx::IMAGE_HOST_UPLOAD_NONE) {
+        PPX_CHECKED_CALL(grfx_util::CopyBitmapToImage(GetDevice()->GetGraphicsQueue(), &bitmap, image, 0, 0, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE));
+    }
+    else {
+        PPX_CHECKED_CALL(image->CopyFromHost(0, 0, bitmap.GetData(), bitmap.GetRowStride()));
+    }
     GetDevice()->WaitIdle();
     double transferEndTimeMs = timer.MillisSinceStart();
     float  elapsedTimeMs     = static_cast<float>(transferEndTimeMs - transferStartTimeMs);
@@ -255,6 +292,8 @@ void ProjApp::TransferTexture(const std::string fileName)
     stats.frameNumber       = GetFrameCount();
     stats.cpuTransferTimeMs = elapsedTimeMs;
     stats.textureSize       = uint2(image->GetWidth(), image->GetHeight());
+    stats.uploadMode        = (uploadMode == grfx::IMAGE_HOST_UPLOAD_LINEAR) ? "linear" : ((uploadMode == grfx::IMAGE_HOST_UPLOAD_HOST_IMAGE_COPY) ? "host-image-copy" : "staged");
+    stats.bandwidthMBps     = (elapsedTimeMs > 0) ? static_cast<float>(static_cast<double>(bitmap.GetFootprintSize()) / (elapsedTimeMs * 1000.0)) : 0.0f;
     mFrameRegisters.push_back(stats);
 
     if (mSampledImageViews.size() < mTextureNames.size()) {
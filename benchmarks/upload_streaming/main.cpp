@@ -0,0 +1,589 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/knob.h"
+#include "ppx/timer.h"
+#include "ppx/grfx/grfx_upload_batch.h"
+
+#include <memory>
+
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+// Destinations are reused every kSlotCount frames, uploads still running
+// by then stall the frame
+static const uint32_t kSlotCount               = 3;
+static const double   kThroughputWindowSeconds = 0.5;
+
+enum UploadStrategy
+{
+    UPLOAD_STRATEGY_NONE     = 0, // Render only, the baseline of the frame time
+    UPLOAD_STRATEGY_GRAPHICS = 1, // One staged batch per resource on the graphics queue
+    UPLOAD_STRATEGY_TRANSFER = 2, // One staged batch per resource on the transfer queue
+    UPLOAD_STRATEGY_BATCHED  = 3, // One staged batch per frame, on the transfer queue if there is one
+    UPLOAD_STRATEGY_DIRECT   = 4, // CPU writes to host visible buffers and images
+};
+
+// Streams textures and buffers to the GPU every frame while rendering the
+// most recently uploaded texture --render-draws times over the screen, so
+// the cost of each upload strategy shows up both as upload throughput and
+// as the difference of the frame time to --upload-strategy none. Uploads
+// count as complete once the GPU has finished them, or once the CPU has
+// written them for direct uploads.
+//
+// The transfer queue is only used if it's in a different queue family than
+// the graphics queue, like grfx_util does. Otherwise, e.g. on D3D12, copy
+// queues can't transition resources to the states the render needs and
+// the uploads fall back to the graphics queue. Images fall back to staged
+// uploads if the format doesn't support IMAGE_HOST_UPLOAD_LINEAR.
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupRunMetrics() override;
+
+private:
+    struct Slot
+    {
+        grfx::ImagePtr                                  image;
+        grfx::SampledImageViewPtr                       imageView;
+        grfx::DescriptorSetPtr                          set;
+        std::vector<grfx::BufferPtr>                    buffers;
+        std::vector<std::unique_ptr<grfx::UploadBatch>> batches;
+        bool                                            pending       = false; // Uploaded but not complete yet
+        bool                                            complete      = false; // Holds a completed upload
+        uint64_t                                        uploadFrame   = 0;
+        double                                          submitSeconds = 0.0;
+    };
+
+    struct Frame
+    {
+        grfx::CommandBufferPtr cmd;
+        grfx::SemaphorePtr     imageAcquiredSemaphore;
+        grfx::FencePtr         imageAcquiredFence;
+        grfx::SemaphorePtr     renderCompleteSemaphore;
+        grfx::FencePtr         renderCompleteFence;
+        grfx::QueryPtr         timestampQuery;
+    };
+
+    void SetupSlots();
+    void SetupRender();
+    void RecordGauge(metrics::MetricID id, double value);
+
+    grfx::Queue*       GetUploadQueue() const;
+    grfx::UploadBatch* NextBatch(Slot& slot);
+    void               Upload(Slot& slot);
+    void               UploadStaged(Slot& slot);
+    void               UploadDirect(Slot& slot);
+    void               CompleteUpload(Slot& slot);
+    void               PollUploads();
+    void               WaitForSlot(Slot& slot);
+    uint32_t           GetDisplaySlot(uint32_t uploadSlot) const;
+
+    uint64_t GetTextureUploadSize() const { return mTextureData.GetFootprintSize(); }
+    uint64_t GetBufferUploadSize() const { return mBufferData.size(); }
+    uint64_t GetFrameUploadSize() const;
+
+private:
+    std::shared_ptr<KnobFlag<std::string>> pUploadStrategy;
+    std::shared_ptr<KnobFlag<int>>         pTexturesPerFrame;
+    std::shared_ptr<KnobFlag<int>>         pTextureSize;
+    std::shared_ptr<KnobFlag<int>>         pBuffersPerFrame;
+    std::shared_ptr<KnobFlag<int>>         pBufferSizeKiB;
+    std::shared_ptr<KnobFlag<int>>         pRenderDraws;
+
+    UploadStrategy    mStrategy        = UPLOAD_STRATEGY_BATCHED;
+    bool              mImageHostUpload = false; // Direct uploads of the textures
+    Bitmap            mTextureData;
+    std::vector<char> mBufferData;
+    std::vector<Slot> mSlots;
+
+    Frame                        mFrame;
+    grfx::DescriptorPoolPtr      mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr mLayout;
+    grfx::SamplerPtr             mSampler;
+    grfx::FullscreenQuadPtr      mDraw;
+
+    struct
+    {
+        metrics::MetricID throughputId       = metrics::kInvalidMetricID;
+        metrics::MetricID latencyId          = metrics::kInvalidMetricID;
+        metrics::MetricID cpuTimeId          = metrics::kInvalidMetricID;
+        metrics::MetricID stallTimeId        = metrics::kInvalidMetricID;
+        metrics::MetricID renderTimeId       = metrics::kInvalidMetricID;
+        double            windowStartSeconds = 0.0;
+        uint64_t          windowBytes        = 0; // Completed since windowStartSeconds
+    } mMetrics;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&pUploadStrategy, "upload-strategy", "batched");
+    pUploadStrategy->SetFlagDescription("How uploads are submitted: 'none' only renders, 'graphics' and 'transfer' submit a staged upload per resource on that queue, 'batched' submits one staged upload per frame, 'direct' writes host visible resources from the CPU.");
+    pUploadStrategy->SetFlagParameters("<none|graphics|transfer|batched|direct>");
+    pUploadStrategy->SetValidator([](const std::string& value) {
+        return value == "none" ||
+               value == "graphics" ||
+               value == "transfer" ||
+               value == "batched" ||
+               value == "direct";
+    });
+
+    GetKnobManager().InitKnob(&pTexturesPerFrame, "textures-per-frame", 2);
+    pTexturesPerFrame->SetFlagDescription("Number of RGBA8 textures uploaded every frame.");
+    pTexturesPerFrame->SetValidator([](int value) { return value >= 0; });
+
+    GetKnobManager().InitKnob(&pTextureSize, "texture-size", 1024);
+    pTextureSize->SetFlagDescription("Width and height of the uploaded textures in pixels.");
+    pTextureSize->SetValidator([](int value) { return (value >= 1) && (value <= 16384); });
+
+    GetKnobManager().InitKnob(&pBuffersPerFrame, "buffers-per-frame", 8);
+    pBuffersPerFrame->SetFlagDescription("Number of vertex buffers uploaded every frame.");
+    pBuffersPerFrame->SetValidator([](int value) { return value >= 0; });
+
+    GetKnobManager().InitKnob(&pBufferSizeKiB, "buffer-size-kib", 512);
+    pBufferSizeKiB->SetFlagDescription("Size of the uploaded buffers in KiB.");
+    pBufferSizeKiB->SetValidator([](int value) { return value >= 1; });
+
+    GetKnobManager().InitKnob(&pRenderDraws, "render-draws", 8);
+    pRenderDraws->SetFlagDescription("Number of times the last uploaded texture is drawn over the screen every frame, the concurrent render load.");
+    pRenderDraws->SetValidator([](int value) { return value >= 1; });
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                                        = "upload_streaming";
+    settings.enableImGui                                    = false;
+    settings.grfx.api                                       = kApi;
+    settings.grfx.device.graphicsQueueCount                 = 1;
+    settings.grfx.device.transferQueueCount                 = 1;
+    settings.grfx.numFramesInFlight                         = 1;
+    settings.grfx.pacedFrameRate                            = 0; // Go as fast as possible
+    settings.standardKnobsDefaultValue.enableMetrics        = true;
+    settings.standardKnobsDefaultValue.overwriteMetricsFile = true;
+}
+
+grfx::Queue* ProjApp::GetUploadQueue() const
+{
+    if ((mStrategy == UPLOAD_STRATEGY_GRAPHICS) || (GetDevice()->GetTransferQueueCount() == 0)) {
+        return GetGraphicsQueue().Get();
+    }
+    grfx::Queue* pTransferQueue = GetTransferQueue();
+    return pTransferQueue->RequiresOwnershipTransfer(GetGraphicsQueue()) ? pTransferQueue : GetGraphicsQueue().Get();
+}
+
+uint64_t ProjApp::GetFrameUploadSize() const
+{
+    return pTexturesPerFrame->GetValue() * GetTextureUploadSize() + pBuffersPerFrame->GetValue() * GetBufferUploadSize();
+}
+
+void ProjApp::SetupSlots()
+{
+    const uint32_t textureSize = static_cast<uint32_t>(pTextureSize->GetValue());
+    const uint32_t imageCount  = std::max(1, pTexturesPerFrame->GetValue()); // The render needs one
+    const uint64_t bufferSize  = static_cast<uint64_t>(pBufferSizeKiB->GetValue()) * 1024;
+
+    // Sources, a gradient so the uploads are visible
+    PPX_CHECKED_CALL(Bitmap::Create(textureSize, textureSize, Bitmap::FORMAT_RGBA_UINT8, &mTextureData));
+    for (uint32_t y = 0; y < textureSize; ++y) {
+        for (uint32_t x = 0; x < textureSize; ++x) {
+            uint8_t* pPixel = mTextureData.GetPixel8u(x, y);
+            pPixel[0]       = static_cast<uint8_t>(255 * x / textureSize);
+            pPixel[1]       = static_cast<uint8_t>(255 * y / textureSize);
+            pPixel[2]       = 128;
+            pPixel[3]       = 255;
+        }
+    }
+    mBufferData.resize(bufferSize);
+    for (size_t i = 0; i < mBufferData.size(); ++i) {
+        mBufferData[i] = static_cast<char>(i);
+    }
+
+    const grfx::Format format = grfx::FORMAT_R8G8B8A8_UNORM;
+    mImageHostUpload          = (mStrategy == UPLOAD_STRATEGY_DIRECT) && GetDevice()->ImageHostUploadSupported(grfx::IMAGE_HOST_UPLOAD_LINEAR, format);
+    if ((mStrategy == UPLOAD_STRATEGY_DIRECT) && !mImageHostUpload) {
+        PPX_LOG_WARN("Linear host uploads aren't supported for " << grfx::ToString(format) << ", textures are staged");
+    }
+
+    mSlots.resize(kSlotCount);
+    for (Slot& slot : mSlots) {
+        // Each slot has one image per texture of a frame, only the first one is rendered
+        grfx::ImageCreateInfo createInfo       = {};
+        createInfo.type                        = grfx::IMAGE_TYPE_2D;
+        createInfo.width                       = textureSize;
+        createInfo.height                      = textureSize;
+        createInfo.depth                       = 1;
+        createInfo.format                      = format;
+        createInfo.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount               = 1;
+        createInfo.arrayLayerCount             = imageCount;
+        createInfo.usageFlags.bits.transferDst = !mImageHostUpload;
+        createInfo.usageFlags.bits.sampled     = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+        if (mImageHostUpload) {
+            // Linear host uploads are limited to a single array layer, the
+            // other textures of the frame are written over the same image
+            createInfo.arrayLayerCount = 1;
+            createInfo.hostUpload      = grfx::IMAGE_HOST_UPLOAD_LINEAR;
+            createInfo.initialState    = grfx::RESOURCE_STATE_GENERAL;
+        }
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&createInfo, &slot.image));
+
+        grfx::SampledImageViewCreateInfo viewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(slot.image);
+        viewCreateInfo.arrayLayerCount                  = 1;
+        viewCreateInfo.imageViewType                    = grfx::IMAGE_VIEW_TYPE_2D;
+        PPX_CHECKED_CALL(GetDevice()->CreateSampledImageView(&viewCreateInfo, &slot.imageView));
+
+        for (int i = 0; i < pBuffersPerFrame->GetValue(); ++i) {
+            grfx::BufferCreateInfo bufferCreateInfo       = {};
+            bufferCreateInfo.size                         = bufferSize;
+            bufferCreateInfo.usageFlags.bits.vertexBuffer = true;
+            bufferCreateInfo.usageFlags.bits.transferDst  = true;
+            bufferCreateInfo.memoryUsage                  = grfx::MEMORY_USAGE_GPU_ONLY;
+            bufferCreateInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
+            if (mStrategy == UPLOAD_STRATEGY_DIRECT) {
+                bufferCreateInfo.memoryUsage = grfx::MEMORY_USAGE_CPU_TO_GPU;
+            }
+
+            grfx::BufferPtr buffer;
+            PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &buffer));
+            slot.buffers.push_back(buffer);
+        }
+    }
+}
+
+void ProjApp::SetupRender()
+{
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sampledImage                   = kSlotCount;
+    poolCreateInfo.sampler                        = kSlotCount;
+    PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(0, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(1, grfx::DESCRIPTOR_TYPE_SAMPLER));
+    PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mLayout));
+
+    grfx::SamplerCreateInfo samplerCreateInfo = {};
+    samplerCreateInfo.magFilter               = grfx::FILTER_LINEAR;
+    samplerCreateInfo.minFilter               = grfx::FILTER_LINEAR;
+    PPX_CHECKED_CALL(GetDevice()->CreateSampler(&samplerCreateInfo, &mSampler));
+
+    for (Slot& slot : mSlots) {
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mLayout, &slot.set));
+
+        grfx::WriteDescriptor writes[2] = {};
+        writes[0].binding               = 0;
+        writes[0].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[0].pImageView            = slot.imageView;
+        writes[1].binding               = 1;
+        writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+        writes[1].pSampler              = mSampler;
+        PPX_CHECKED_CALL(slot.set->UpdateDescriptors(2, writes));
+    }
+
+    grfx::ShaderModulePtr VS;
+    std::vector<char>     bytecode = LoadShader("basic/shaders", "FullScreenTriangle.vs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &VS));
+
+    grfx::ShaderModulePtr PS;
+    bytecode = LoadShader("basic/shaders", "FullScreenTriangle.ps");
+    PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &PS));
+
+    grfx::FullscreenQuadCreateInfo createInfo = {};
+    createInfo.VS                             = VS;
+    createInfo.PS                             = PS;
+    createInfo.setCount                       = 1;
+    createInfo.sets[0].set                    = 0;
+    createInfo.sets[0].pLayout                = mLayout;
+    createInfo.renderTargetCount              = 1;
+    createInfo.renderTargetFormats[0]         = GetSwapchain()->GetColorFormat();
+    createInfo.depthStencilFormat             = GetSwapchain()->GetDepthFormat();
+    PPX_CHECKED_CALL(GetDevice()->CreateFullscreenQuad(&createInfo, &mDraw));
+
+    PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&mFrame.cmd));
+
+    grfx::SemaphoreCreateInfo semaphoreCreateInfo = {};
+    PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaphoreCreateInfo, &mFrame.imageAcquiredSemaphore));
+    PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaphoreCreateInfo, &mFrame.renderCompleteSemaphore));
+
+    grfx::FenceCreateInfo fenceCreateInfo = {};
+    PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFrame.imageAcquiredFence));
+    fenceCreateInfo = {true}; // Create signaled
+    PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &mFrame.renderCompleteFence));
+
+    grfx::QueryCreateInfo queryCreateInfo = {};
+    queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+    queryCreateInfo.count                 = 2;
+    PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &mFrame.timestampQuery));
+}
+
+void ProjApp::Setup()
+{
+    const std::string strategy = pUploadStrategy->GetValue();
+    if (strategy == "none") {
+        mStrategy = UPLOAD_STRATEGY_NONE;
+    }
+    else if (strategy == "graphics") {
+        mStrategy = UPLOAD_STRATEGY_GRAPHICS;
+    }
+    else if (strategy == "transfer") {
+        mStrategy = UPLOAD_STRATEGY_TRANSFER;
+    }
+    else if (strategy == "direct") {
+        mStrategy = UPLOAD_STRATEGY_DIRECT;
+    }
+
+    SetupSlots();
+    SetupRender();
+
+    if (((mStrategy == UPLOAD_STRATEGY_TRANSFER) || (mStrategy == UPLOAD_STRATEGY_BATCHED)) && (GetUploadQueue() == GetGraphicsQueue().Get())) {
+        PPX_LOG_WARN("No transfer queue in a separate queue family, uploads are submitted to the graphics queue");
+    }
+    PPX_LOG_INFO("Uploading " << (GetFrameUploadSize() / 1024) << " KiB per frame with --upload-strategy " << strategy);
+}
+
+void ProjApp::SetupRunMetrics()
+{
+    metrics::MetricMetadata metadata = {metrics::MetricType::GAUGE, "upload_throughput", "MB/s", metrics::MetricInterpretation::HIGHER_IS_BETTER};
+    mMetrics.throughputId            = AddMetric(metadata);
+
+    metadata           = {metrics::MetricType::GAUGE, "upload_latency", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER};
+    mMetrics.latencyId = AddMetric(metadata);
+
+    metadata           = {metrics::MetricType::GAUGE, "upload_cpu_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER};
+    mMetrics.cpuTimeId = AddMetric(metadata);
+
+    metadata             = {metrics::MetricType::GAUGE, "upload_stall_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER};
+    mMetrics.stallTimeId = AddMetric(metadata);
+
+    metadata              = {metrics::MetricType::GAUGE, "render_gpu_time", "ms", metrics::MetricInterpretation::LOWER_IS_BETTER};
+    mMetrics.renderTimeId = AddMetric(metadata);
+
+    mMetrics.windowStartSeconds = GetElapsedSeconds();
+    mMetrics.windowBytes        = 0;
+}
+
+void ProjApp::RecordGauge(metrics::MetricID id, double value)
+{
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = GetElapsedSeconds();
+    data.gauge.value         = value;
+    RecordMetricData(id, data);
+}
+
+grfx::UploadBatch* ProjApp::NextBatch(Slot& slot)
+{
+    // Unbatched strategies submit every resource on its own
+    if (!slot.batches.empty() && (mStrategy == UPLOAD_STRATEGY_BATCHED)) {
+        return slot.batches.back().get();
+    }
+    if (!slot.batches.empty()) {
+        PPX_CHECKED_CALL(slot.batches.back()->Submit());
+    }
+    slot.batches.push_back(std::make_unique<grfx::UploadBatch>(GetUploadQueue(), grfx::UploadBatch::kDefaultStagingChunkSize, GetGraphicsQueue()));
+    return slot.batches.back().get();
+}
+
+void ProjApp::UploadStaged(Slot& slot)
+{
+    if (!mImageHostUpload) {
+        for (int i = 0; i < pTexturesPerFrame->GetValue(); ++i) {
+            PPX_CHECKED_CALL(NextBatch(slot)->AddBitmapUpload(&mTextureData, slot.image, 0, i, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE));
+        }
+    }
+    if (mStrategy != UPLOAD_STRATEGY_DIRECT) {
+        for (grfx::BufferPtr& buffer : slot.buffers) {
+            PPX_CHECKED_CALL(NextBatch(slot)->AddBufferUpload(mBufferData.size(), mBufferData.data(), buffer, 0, grfx::RESOURCE_STATE_VERTEX_BUFFER, grfx::RESOURCE_STATE_VERTEX_BUFFER));
+        }
+    }
+    if (!slot.batches.empty()) {
+        PPX_CHECKED_CALL(slot.batches.back()->Submit());
+    }
+}
+
+void ProjApp::UploadDirect(Slot& slot)
+{
+    if (mImageHostUpload) {
+        for (int i = 0; i < pTexturesPerFrame->GetValue(); ++i) {
+            PPX_CHECKED_CALL(slot.image->CopyFromHost(0, 0, mTextureData.GetData(), mTextureData.GetRowStride()));
+        }
+    }
+    for (grfx::BufferPtr& buffer : slot.buffers) {
+        PPX_CHECKED_CALL(buffer->CopyFromSource(static_cast<uint32_t>(mBufferData.size()), mBufferData.data()));
+    }
+}
+
+void ProjApp::Upload(Slot& slot)
+{
+    Timer timer;
+    PPX_ASSERT_MSG(timer.Start() == ppx::TIMER_RESULT_SUCCESS, "timer start failed");
+
+    // Direct uploads stage the textures that can't be written from the CPU
+    UploadStaged(slot);
+    if (mStrategy == UPLOAD_STRATEGY_DIRECT) {
+        UploadDirect(slot);
+    }
+
+    slot.pending       = true;
+    slot.complete      = false;
+    slot.uploadFrame   = GetFrameCount();
+    slot.submitSeconds = GetElapsedSeconds();
+    RecordGauge(mMetrics.cpuTimeId, timer.MillisSinceStart());
+
+    if (slot.batches.empty()) {
+        CompleteUpload(slot);
+    }
+}
+
+void ProjApp::CompleteUpload(Slot& slot)
+{
+    slot.batches.clear();
+    slot.pending  = false;
+    slot.complete = true;
+    mMetrics.windowBytes += GetFrameUploadSize();
+    RecordGauge(mMetrics.latencyId, (GetElapsedSeconds() - slot.submitSeconds) * 1000.0);
+}
+
+void ProjApp::PollUploads()
+{
+    for (Slot& slot : mSlots) {
+        if (!slot.pending) {
+            continue;
+        }
+        bool complete = true;
+        for (const auto& batch : slot.batches) {
+            complete = complete && batch->IsComplete();
+        }
+        if (complete) {
+            CompleteUpload(slot);
+        }
+    }
+}
+
+void ProjApp::WaitForSlot(Slot& slot)
+{
+    Timer timer;
+    PPX_ASSERT_MSG(timer.Start() == ppx::TIMER_RESULT_SUCCESS, "timer start failed");
+
+    if (slot.pending) {
+        for (const auto& batch : slot.batches) {
+            PPX_CHECKED_CALL(batch->Wait());
+        }
+        CompleteUpload(slot);
+    }
+    slot.complete = false;
+    RecordGauge(mMetrics.stallTimeId, timer.MillisSinceStart());
+}
+
+uint32_t ProjApp::GetDisplaySlot(uint32_t uploadSlot) const
+{
+    // The most recent complete upload, any other slot before the first one
+    uint32_t displaySlot = (uploadSlot + 1) % kSlotCount;
+    for (uint32_t i = 0; i < kSlotCount; ++i) {
+        const Slot& slot = mSlots[i];
+        if ((i != uploadSlot) && slot.complete && (!mSlots[displaySlot].complete || (slot.uploadFrame > mSlots[displaySlot].uploadFrame))) {
+            displaySlot = i;
+        }
+    }
+    return displaySlot;
+}
+
+void ProjApp::Render()
+{
+    grfx::SwapchainPtr swapchain = GetSwapchain();
+
+    PPX_CHECKED_CALL(mFrame.renderCompleteFence->WaitAndReset());
+    if (GetFrameCount() > 0) {
+        uint64_t timestamps[2] = {0};
+        uint64_t frequency     = 0;
+        PPX_CHECKED_CALL(mFrame.timestampQuery->GetData(timestamps, sizeof(timestamps)));
+        PPX_CHECKED_CALL(GetGraphicsQueue()->GetTimestampFrequency(&frequency));
+        RecordGauge(mMetrics.renderTimeId, static_cast<double>(timestamps[1] - timestamps[0]) / static_cast<double>(frequency) * 1000.0);
+    }
+
+    // Uploads
+    PollUploads();
+    const uint32_t uploadSlot = static_cast<uint32_t>(GetFrameCount() % kSlotCount);
+    if (mStrategy != UPLOAD_STRATEGY_NONE) {
+        WaitForSlot(mSlots[uploadSlot]);
+        Upload(mSlots[uploadSlot]);
+    }
+
+    const double seconds = GetElapsedSeconds();
+    if (seconds - mMetrics.windowStartSeconds >= kThroughputWindowSeconds) {
+        RecordGauge(mMetrics.throughputId, static_cast<double>(mMetrics.windowBytes) / (seconds - mMetrics.windowStartSeconds) / 1e6);
+        mMetrics.windowStartSeconds = seconds;
+        mMetrics.windowBytes        = 0;
+    }
+
+    // Render
+    uint32_t imageIndex = UINT32_MAX;
+    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, mFrame.imageAcquiredSemaphore, mFrame.imageAcquiredFence, &imageIndex));
+    PPX_CHECKED_CALL(mFrame.imageAcquiredFence->WaitAndReset());
+
+    const Slot& displaySlot = mSlots[GetDisplaySlot(uploadSlot)];
+
+    mFrame.timestampQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(mFrame.cmd->Begin());
+    {
+        grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
+        PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
+
+        mFrame.cmd->WriteTimestamp(mFrame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        mFrame.cmd->SetScissors(renderPass->GetScissor());
+        mFrame.cmd->SetViewports(renderPass->GetViewport());
+        mFrame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+        mFrame.cmd->BeginRenderPass(renderPass);
+        for (int i = 0; i < pRenderDraws->GetValue(); ++i) {
+            mFrame.cmd->Draw(mDraw, 1, &displaySlot.set);
+        }
+        mFrame.cmd->EndRenderPass();
+        mFrame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+        mFrame.cmd->WriteTimestamp(mFrame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        mFrame.cmd->ResolveQueryData(mFrame.timestampQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(mFrame.cmd->End());
+
+    grfx::SubmitInfo submitInfo     = {};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.ppCommandBuffers     = &mFrame.cmd;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.ppWaitSemaphores     = &mFrame.imageAcquiredSemaphore;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.ppSignalSemaphores   = &mFrame.renderCompleteSemaphore;
+    submitInfo.pFence               = mFrame.renderCompleteFence;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+
+    PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &mFrame.renderCompleteSemaphore));
+}
+
+SETUP_APPLICATION(ProjApp)
@@ -66,15 +66,24 @@ function(internal_add_compile_shader_target TARGET_NAME)
 endfunction()
 
 function(internal_generate_rules_for_shader TARGET_NAME)
-    set(oneValueArgs SOURCE SHADER_STAGE)
-    set(multiValueArgs INCLUDE_DIRS INCLUDES)
-    cmake_parse_arguments(PARSE_ARGV 1 "ARG" "" "${oneValueArgs}" "${multiValueArgs}")
+    set(options RAY_QUERY)
+    set(oneValueArgs SOURCE SHADER_STAGE OUTPUT_NAME)
+    set(multiValueArgs INCLUDE_DIRS INCLUDES DEFINES)
+    cmake_parse_arguments(PARSE_ARGV 1 "ARG" "${options}" "${oneValueArgs}" "${multiValueArgs}")
 
     string(REPLACE ".hlsl" "" BASE_NAME "${ARG_SOURCE}")
     get_filename_component(BASE_NAME "${BASE_NAME}" NAME)
+    if (ARG_OUTPUT_NAME)
+        set(BASE_NAME "${ARG_OUTPUT_NAME}")
+    endif ()
     file(RELATIVE_PATH PATH_PREFIX "${PPX_DIR}" "${ARG_SOURCE}")
     get_filename_component(PATH_PREFIX "${PATH_PREFIX}" DIRECTORY)
 
+    set(DEFINE_FLAGS "")
+    foreach (DEFINE ${ARG_DEFINES})
+        list(APPEND DEFINE_FLAGS "-D${DEFINE}")
+    endforeach ()
+
     # D3D12, dxil, sm 6_5.
     if (PPX_D3D12)
         internal_add_compile_shader_target(
@@ -87,12 +96,22 @@ function(internal_generate_rules_for_shader TARGET_NAME)
             SHADER_STAGE "${ARG_SHADER_STAGE}"
             OUTPUT_FORMAT "DXIL_6_5"
             TARGET_FOLDER "${TARGET_NAME}"
-            COMPILER_FLAGS "-T" "${ARG_SHADER_STAGE}_6_5" "-E" "${ARG_SHADER_STAGE}main" "-DPPX_DX12=1")
+            COMPILER_FLAGS "-T" "${ARG_SHADER_STAGE}_6_5" "-E" "${ARG_SHADER_STAGE}main" "-DPPX_DX12=1" ${DEFINE_FLAGS})
         add_dependencies("dx12_${TARGET_NAME}" "dx12_${TARGET_NAME}_${ARG_SHADER_STAGE}")
     endif ()
 
     # Vulkan, spv, sm 6_6.
     if (PPX_VULKAN)
+        # VK_EXT_mesh_shader needs SPIR-V 1.4, DXC otherwise emits the NV extension.
+        set(SPV_TARGET_FLAGS "-fspv-target-env=vulkan1.1")
+        if ("${ARG_SHADER_STAGE}" STREQUAL "ms" OR "${ARG_SHADER_STAGE}" STREQUAL "as")
+            set(SPV_TARGET_FLAGS "-fspv-target-env=vulkan1.1spirv1.4" "-fspv-extension=SPV_EXT_mesh_shader")
+        endif ()
+        # VK_KHR_ray_query needs SPIR-V 1.4 as well.
+        if (ARG_RAY_QUERY)
+            set(SPV_TARGET_FLAGS "-fspv-target-env=vulkan1.1spirv1.4" "-fspv-extension=SPV_KHR_ray_query")
+        endif ()
+
         set(SHADER_OUTPUT_PATH "${CMAKE_BINARY_DIR}/${PATH_PREFIX}/spv/${BASE_NAME}.${ARG_SHADER_STAGE}.spv")
         if (PPX_ANDROID)
             # Place the generated files into build directory. They will be copied into the APK
@@ -110,15 +129,18 @@ function(internal_generate_rules_for_shader TARGET_NAME)
             SHADER_STAGE "${ARG_SHADER_STAGE}"
             OUTPUT_FORMAT "SPV_6_6"
             TARGET_FOLDER "${TARGET_NAME}"
-            COMPILER_FLAGS "-spirv" "-fspv-preserve-interface" "-fspv-target-env=vulkan1.1" "-fvk-use-dx-layout" "-DPPX_VULKAN=1" "-T" "${ARG_SHADER_STAGE}_6_6" "-E" "${ARG_SHADER_STAGE}main")
+            COMPILER_FLAGS "-spirv" "-fspv-preserve-interface" ${SPV_TARGET_FLAGS} "-fvk-use-dx-layout" "-DPPX_VULKAN=1" "-T" "${ARG_SHADER_STAGE}_6_6" "-E" "${ARG_SHADER_STAGE}main" ${DEFINE_FLAGS})
         add_dependencies("vk_${TARGET_NAME}" "vk_${TARGET_NAME}_${ARG_SHADER_STAGE}")
     endif ()
 endfunction()
 
+# OUTPUT_NAME replaces the source's base name in the compiled file names, so
+# that one source can be compiled several times with different DEFINES.
 function(generate_rules_for_shader TARGET_NAME)
-    set(oneValueArgs SOURCE)
-    set(multiValueArgs INCLUDE_DIRS INCLUDES STAGES)
-    cmake_parse_arguments(PARSE_ARGV 1 "ARG" "" "${oneValueArgs}" "${multiValueArgs}")
+    set(options RAY_QUERY)
+    set(oneValueArgs SOURCE OUTPUT_NAME)
+    set(multiValueArgs INCLUDE_DIRS INCLUDES STAGES DEFINES)
+    cmake_parse_arguments(PARSE_ARGV 1 "ARG" "${options}" "${oneValueArgs}" "${multiValueArgs}")
 
     add_custom_target_in_folder("${TARGET_NAME}" SOURCES "${ARG_SOURCE}" ${ARG_INCLUDES} FOLDER "${TARGET_NAME}")
     message(STATUS "creating shader target ${TARGET_NAME}.")
@@ -133,8 +155,13 @@ function(generate_rules_for_shader TARGET_NAME)
         add_dependencies("${TARGET_NAME}" "vk_${TARGET_NAME}")
     endif ()
 
+    set(RAY_QUERY_OPTION "")
+    if (ARG_RAY_QUERY)
+        set(RAY_QUERY_OPTION "RAY_QUERY")
+    endif ()
+
     foreach (STAGE ${ARG_STAGES})
-        internal_generate_rules_for_shader("${TARGET_NAME}" SOURCE "${ARG_SOURCE}" INCLUDE_DIRS ${ARG_INCLUDE_DIRS} INCLUDES ${ARG_INCLUDES} SHADER_STAGE "${STAGE}")
+        internal_generate_rules_for_shader("${TARGET_NAME}" SOURCE "${ARG_SOURCE}" OUTPUT_NAME "${ARG_OUTPUT_NAME}" INCLUDE_DIRS ${ARG_INCLUDE_DIRS} INCLUDES ${ARG_INCLUDES} DEFINES ${ARG_DEFINES} SHADER_STAGE "${STAGE}" ${RAY_QUERY_OPTION})
     endforeach ()
 endfunction()
 
@@ -18,18 +18,31 @@
 #include "ppx/base_application.h"
 #include "ppx/command_line_parser.h"
 #include "ppx/fs.h"
+#include "ppx/image_readback.h"
 #include "ppx/imgui_impl.h"
 #include "ppx/input.h"
 #include "ppx/knob.h"
 #include "ppx/math_config.h"
 #include "ppx/metrics.h"
+#include "ppx/metrics_stream.h"
+#include "ppx/perf_counters.h"
+#include "ppx/performance_hints.h"
+#include "ppx/thread_policy.h"
+#include "ppx/shader_compiler.h"
+#include "ppx/shader_hot_reload.h"
 #include "ppx/timer.h"
 #include "ppx/window.h"
 #include "ppx/xr_component.h"
+#include "ppx/y4m_writer.h"
 
 #include <deque>
 #include <filesystem>
 #include <cinttypes>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 // clang-format off
@@ -69,29 +82,60 @@ struct StandardOptions
 {
     // Flags
     std::shared_ptr<KnobFlag<bool>> pListGpus;
+    std::shared_ptr<KnobFlag<bool>> pCoalesceMouseMoves;
+    std::shared_ptr<KnobFlag<bool>> pLateInputPoll;
+    std::shared_ptr<KnobFlag<bool>> pRawMouseMotion;
+    std::shared_ptr<KnobFlag<bool>> pLogAsync;
     std::shared_ptr<KnobFlag<bool>> pUseSoftwareRenderer;
     std::shared_ptr<KnobFlag<bool>> pHeadless;
+    std::shared_ptr<KnobFlag<bool>> pFreeRunning;
     std::shared_ptr<KnobFlag<bool>> pDeterministic;
     std::shared_ptr<KnobFlag<bool>> pEnableMetrics;
     std::shared_ptr<KnobFlag<bool>> pOverwriteMetricsFile;
+    std::shared_ptr<KnobFlag<bool>> pMetricsStreamingGauges;
+    std::shared_ptr<KnobFlag<bool>> pPerfCounters;
+    std::shared_ptr<KnobFlag<bool>> pPerformanceHints;
+    std::shared_ptr<KnobFlag<bool>> pShaderHotReload;
+    std::shared_ptr<KnobFlag<bool>> pPrecompilePipelines;
 
     // Options
+    std::shared_ptr<KnobFlag<uint32_t>> pBenchmarkRepetitions;
+    std::shared_ptr<KnobFlag<uint32_t>> pBenchmarkRepetitionFrames;
+    std::shared_ptr<KnobFlag<uint32_t>> pBenchmarkWarmupFrames;
     std::shared_ptr<KnobFlag<uint32_t>> pGpuIndex;
+    std::shared_ptr<KnobFlag<uint32_t>> pSecondaryGpuIndex;
     std::shared_ptr<KnobFlag<uint64_t>> pFrameCount;
     std::shared_ptr<KnobFlag<uint32_t>> pRunTimeMs;
+    std::shared_ptr<KnobFlag<uint32_t>> pMetricsStreamPort;
     std::shared_ptr<KnobFlag<int>>      pStatsFrameWindow;
+    std::shared_ptr<KnobFlag<float>>    pFrameBudgetMs;
     std::shared_ptr<KnobFlag<int>>      pScreenshotFrameNumber;
+    std::shared_ptr<KnobFlag<int>>      pScreenshotFrameInterval;
 
     std::shared_ptr<KnobFlag<std::string>> pScreenshotPath;
+    std::shared_ptr<KnobFlag<std::string>> pVideoCapturePath;
     std::shared_ptr<KnobFlag<std::string>> pMetricsFilename;
+    std::shared_ptr<KnobFlag<std::string>> pMetricsFormat;
+    std::shared_ptr<KnobFlag<std::string>> pMetricsResultsStore;
+    std::shared_ptr<KnobFlag<std::string>> pPipelineCachePath;
+    std::shared_ptr<KnobFlag<std::string>> pPipelineManifestPath;
+    std::shared_ptr<KnobFlag<std::string>> pShaderCachePath;
+    std::shared_ptr<KnobFlag<std::string>> pShaderCompilerPath;
+    std::shared_ptr<KnobFlag<std::string>> pTracePath;
+    std::shared_ptr<KnobFlag<std::string>> pSweepPath;
+    std::shared_ptr<KnobFlag<std::string>> pThreadAffinity;
+    std::shared_ptr<KnobFlag<std::string>> pThreadPriority;
 
     std::shared_ptr<KnobFlag<std::pair<int, int>>> pResolution;
 #if defined(PPX_BUILD_XR)
     std::shared_ptr<KnobFlag<std::pair<int, int>>>      pXrUiResolution;
     std::shared_ptr<KnobFlag<std::vector<std::string>>> pXrRequiredExtensions;
     std::shared_ptr<KnobFlag<bool>>                     pXrEnableMultiview;
+    std::shared_ptr<KnobFlag<std::string>>              pXrFoveationLevel;
+    std::shared_ptr<KnobFlag<bool>>                     pXrFoveationDynamic;
 #endif
 
+    std::shared_ptr<KnobFlag<std::vector<std::string>>> pAssetPacks;
     std::shared_ptr<KnobFlag<std::vector<std::string>>> pAssetsPaths;
     std::shared_ptr<KnobFlag<std::vector<std::string>>> pConfigJsonPaths;
 
@@ -112,6 +156,10 @@ struct ApplicationSettings
     bool        enableImGui           = false;
     bool        allowThirdPartyAssets = false;
 
+    // Runs Update() on a game thread one frame ahead of Render(), see
+    // Application::Update().
+    bool pipelinedUpdate = false;
+
 #if defined(PPX_ANDROID)
     bool emulateMouseAndroid = true;
 #endif
@@ -122,9 +170,12 @@ struct ApplicationSettings
 
         // Whether to create depth swapchains in addition to color swapchains,
         // and submit the depth info to the runtime as an additional layer.
-        bool     enableDepthSwapchain = false;
-        uint32_t uiWidth              = 0;
-        uint32_t uiHeight             = 0;
+        bool enableDepthSwapchain = false;
+        // Whether to create XR_FB_space_warp motion vector swapchains, see
+        // GetSpaceWarpSwapchain(). Ignored if the runtime doesn't support it.
+        bool     enableSpaceWarp = false;
+        uint32_t uiWidth         = 0;
+        uint32_t uiHeight        = 0;
     } xr;
 
     struct
@@ -162,8 +213,36 @@ struct ApplicationSettings
             // The application must not use FDM or VRS without setting this to
             // the corresponding shading rate mode.
             grfx::ShadingRateMode supportShadingRateMode = grfx::SHADING_RATE_NONE;
+
+            // Record render passes with dynamic rendering when the device
+            // supports it, see grfx::DeviceCreateInfo::dynamicRenderPasses.
+            bool dynamicRenderPasses = true;
+
+            // Link graphics pipelines from shared libraries when the device
+            // supports it, see grfx::DeviceCreateInfo::graphicsPipelineLibraries.
+            bool graphicsPipelineLibraries = true;
+
+            // Allow grfx::Device::Defragment(), Vulkan only. Adds transfer
+            // usage to GPU only buffers and images.
+            bool defragmentation = false;
+
+            // Back descriptor sets with a descriptor buffer when the device
+            // supports it, Vulkan only. Layouts can't use dynamic buffers.
+            bool descriptorBuffers = false;
         } device;
 
+        // Second device on the GPU selected by `--secondary-gpu`, for work
+        // that runs independently of the rendering device, e.g. compute, see
+        // Application::GetSecondaryDevice(). Resources can't be shared, copy
+        // them with grfx_util::CopyBufferAcrossDevices().
+        struct
+        {
+            bool     enable             = false;
+            uint32_t graphicsQueueCount = 0;
+            uint32_t computeQueueCount  = 1;
+            uint32_t transferQueueCount = 0;
+        } secondaryDevice;
+
         struct
         {
             // NVIDIA only supports B8G8R8A8, ANDROID only supports R8G8B8A8, and
@@ -174,8 +253,11 @@ struct ApplicationSettings
 #else
             grfx::Format colorFormat = grfx::FORMAT_B8G8R8A8_UNORM;
 #endif
-            grfx::Format depthFormat = grfx::FORMAT_UNDEFINED;
-            uint32_t     imageCount  = 2;
+            grfx::Format      depthFormat     = grfx::FORMAT_UNDEFINED;
+            uint32_t          imageCount      = 2;
+            grfx::PresentMode presentMode     = grfx::PRESENT_MODE_IMMEDIATE;
+            uint32_t          maxFrameLatency = 0;     // See grfx::SwapchainCreateInfo::maxFrameLatency
+            bool              transientDepth  = false; // See grfx::SwapchainCreateInfo::transientDepthImages
         } swapchain;
 
         // imGuiDynamicRendering controls whether ImGui window is
@@ -183,35 +265,109 @@ struct ApplicationSettings
         // must have begun with a single color attachment (no depth
         // stencil attachment).
         bool enableImGuiDynamicRendering = false;
+
+        // Renders ImGui with ppx::ImGuiImplGrfx instead of the stock
+        // backend of the API. Loads basic/shaders/ImGui.
+        bool enableGrfxImGui = false;
+
+        // Creates a grfx::GpuProfiler for the first graphics queue with
+        // numFramesInFlight frames, see Application::GetGpuProfiler().
+        struct
+        {
+            bool     enable                   = false;
+            uint32_t maxScopesPerFrame        = 64;
+            bool     enablePipelineStatistics = false;
+        } gpuProfiler;
+
+        // Creates a grfx::DynamicResolution at the size of the first
+        // swapchain, see Application::GetDynamicResolution(). Loads
+        // basic/shaders/DynamicResolutionUpscale.
+        struct
+        {
+            bool         enable             = false;
+            float        targetFrameTimeMs  = 0.0f; // 0 uses 1000 / pacedFrameRate
+            float        minScale           = 0.5f;
+            grfx::Format renderTargetFormat = grfx::FORMAT_UNDEFINED; // Swapchain color format if undefined
+            grfx::Format depthStencilFormat = grfx::FORMAT_UNDEFINED;
+        } dynamicResolution;
     } grfx;
 
     // Default values for standard knobs
     struct StandardKnobsDefaultValue
     {
-        std::vector<std::string> assetsPaths           = {};
-        std::vector<std::string> configJsonPaths       = {};
-        bool                     deterministic         = false;
-        bool                     enableMetrics         = false;
-        uint64_t                 frameCount            = 0;
-        uint32_t                 gpuIndex              = 0;
-        bool                     headless              = false;
-        bool                     listGpus              = false;
-        std::string              metricsFilename       = "report_@.json";
-        bool                     overwriteMetricsFile  = false;
-        std::pair<int, int>      resolution            = std::make_pair(0, 0);
-        uint32_t                 runTimeMs             = 0;
-        int                      screenshotFrameNumber = -1;
-        std::string              screenshotPath        = "screenshot_frame_#.ppm";
-        int                      statsFrameWindow      = -1;
-        bool                     useSoftwareRenderer   = false;
+        std::vector<std::string> assetPacks                = {};
+        std::vector<std::string> assetsPaths               = {};
+        uint32_t                 benchmarkRepetitions      = 0;
+        uint32_t                 benchmarkRepetitionFrames = 300;
+        uint32_t                 benchmarkWarmupFrames     = 60;
+        bool                     coalesceMouseMoves        = false;
+        std::vector<std::string> configJsonPaths           = {};
+        bool                     deterministic             = false;
+        bool                     enableMetrics             = false;
+        float                    frameBudgetMs             = 1000.0f / 60.0f;
+        uint64_t                 frameCount                = 0;
+        bool                     freeRunning               = false;
+        uint32_t                 gpuIndex                  = 0;
+        bool                     headless                  = false;
+        bool                     lateInputPoll             = false;
+        bool                     listGpus                  = false;
+        bool                     logAsync                  = false;
+        std::string              metricsFilename           = "report_@.json";
+        std::string              metricsFormat             = "json";
+        std::string              metricsResultsStore       = "";
+        uint32_t                 metricsStreamPort         = 0;
+        bool                     metricsStreamingGauges    = false;
+        bool                     overwriteMetricsFile      = false;
+        bool                     perfCounters              = false;
+        bool                     performanceHints          = true;
+        std::string              pipelineCachePath         = "";
+        std::string              pipelineManifestPath      = "";
+        bool                     precompilePipelines       = true;
+        bool                     rawMouseMotion            = true;
+        std::pair<int, int>      resolution                = std::make_pair(0, 0);
+        uint32_t                 runTimeMs                 = 0;
+        int                      screenshotFrameNumber     = -1;
+        int                      screenshotFrameInterval   = 0;
+        std::string              screenshotPath            = "screenshot_frame_#.ppm";
+        uint32_t                 secondaryGpuIndex         = 1;
+        std::string              shaderCachePath           = "shader_cache";
+        std::string              shaderCompilerPath        = "";
+        bool                     shaderHotReload           = false;
+        int                      statsFrameWindow          = -1;
+        std::string              sweepPath                 = "";
+        std::string              threadAffinity            = "";
+        std::string              threadPriority            = "";
+        std::string              tracePath                 = "";
+        bool                     useSoftwareRenderer       = false;
+        std::string              videoCapturePath          = "";
 #if defined(PPX_BUILD_XR)
         std::pair<int, int>      xrUiResolution       = std::make_pair(0, 0);
         std::vector<std::string> xrRequiredExtensions = {};
         bool                     xrEnableMultiview    = false;
+        std::string              xrFoveationLevel     = "none";
+        bool                     xrFoveationDynamic   = false;
 #endif
     } standardKnobsDefaultValue;
 };
 
+//! @struct StartupTimes
+//!
+//! CPU time of each phase of Application::Run() up to the end of the first
+//! frame, in milliseconds. Recorded as startup_* gauges in every metrics run.
+//!
+struct StartupTimes
+{
+    double window         = 0; // Window and platform initialization
+    double device         = 0; // Instance and device creation
+    double swapchain      = 0; // Surface, swapchains and dynamic resolution
+    double setup          = 0; // ImGui initialization and Setup()
+    double shaderLoad     = 0; // Shader files and modules, part of setup
+    double pipelineCreate = 0; // Synchronous pipeline creates, part of setup
+    double assetLoad      = 0; // The rest of setup
+    double firstFrame     = 0; // Until the end of the first frame
+    double total          = 0; // Since the start of Run()
+};
+
 //! @class Application
 //!
 //!
@@ -239,6 +395,17 @@ public:
     virtual void MouseUp(int32_t x, int32_t y, uint32_t buttons) {}                           // Mouse up event
     virtual void Scroll(float dx, float dy) {}                                                // Mouse wheel or touchpad scroll event
     virtual void Render() {}
+
+    // Prepares frame packet packetIndex, 0 or 1, for the Render() call that
+    // sees it as GetRenderPacketIndex(). Apps keep the two packets themselves.
+    //
+    // Without ApplicationSettings::pipelinedUpdate it's called right before
+    // Render() on the main thread. With it, it runs on the game thread while
+    // Render() records and submits the other packet, so it must not touch
+    // what Render() uses: ImGui, command buffers or the other packet. Input
+    // events are never dispatched while Update() runs and all of a frame's
+    // events are dispatched before its Update() starts.
+    virtual void Update(uint32_t packetIndex) {}
     // Init knobs (adjustable parameters in the GUI that can be set at startup with commandline flags)
     virtual void InitKnobs() {}
 
@@ -256,6 +423,7 @@ protected:
     virtual void DispatchMouseUp(int32_t x, int32_t y, uint32_t buttons);
     virtual void DispatchScroll(float dx, float dy);
     virtual void DispatchRender();
+    virtual void DispatchUpdate(uint32_t packetIndex);
     virtual void DispatchInitKnobs();
     virtual void DispatchUpdateMetrics();
     virtual void DrawGui(){}; // Draw additional project-related information to ImGui.
@@ -270,13 +438,26 @@ protected:
     // Thus it should always be called once per frame. Virtual for unit testing purposes.
     virtual void UpdateMetrics() {}
 
+    // Called by StartMetricsRun() once the default metrics are added. Override
+    // to add the application's own metrics to every run, including each run
+    // of --benchmark-repetitions.
+    virtual void SetupRunMetrics() {}
+
     virtual metrics::GaugeBasicStatistics GetGaugeBasicStatistics(metrics::MetricID id) const;
 
     void TakeScreenshot();
+    void CaptureVideoFrame();
     void SaveImage(grfx::ImagePtr image, const std::string& filepath, grfx::ResourceState resourceState) const;
 
     void DrawImGui(grfx::CommandBuffer* pCommandBuffer);
     void DrawDebugInfo();
+
+    // XR composites the UI swapchain as a quad layer, which keeps showing
+    // its last image. Returns false if the frame's ImGui draw data is the
+    // same as the previous frame's, so rendering into the UI swapchain can
+    // be skipped. Call it after the frame's ImGui calls, before acquiring
+    // the UI swapchain image. Always true without XR.
+    bool ShouldRenderUI();
     void DrawProfilerGrfxApiFunctions();
 
     KnobManager& GetKnobManager() { return mKnobManager; }
@@ -314,16 +495,45 @@ public:
     //     - loads shader file: some/path/shaders/dxil/Texture.vs.dxil for API_DX_12_0, API_DX_12_1
     //     - loads shader file: some/path/shaders/spv/Texture.vs.spv   for API_VK_1_1, API_VK_1_2
     //
+    // CreateShader() compiles baseDir/<name>.hlsl at runtime if the bytecode
+    // of baseName <name>.<stage> isn't found and --shader-compiler-path is
+    // set. The overload with defines always compiles at runtime, for
+    // variants the build doesn't compile. See ShaderCompiler.
+    //
     std::vector<char> LoadShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName) const;
     Result            CreateShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName, grfx::ShaderModule** ppShaderModule) const;
+    Result            CreateShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName, const std::vector<ShaderDefine>& defines, grfx::ShaderModule** ppShaderModule) const;
+
+    // Returns the compiler CreateShader() uses, null without --shader-compiler-path
+    ShaderCompiler* GetShaderCompiler() const { return mShaderCompiler.IsInitialized() ? &mShaderCompiler : nullptr; }
+
+    // With --shader-hot-reload, rebuilds *ppPipeline when one of the shader
+    // files it was created from with CreateShader() changes, see
+    // ShaderHotReload. *ppPipeline is replaced between frames, so read it
+    // again every frame. Call UnwatchShaders() before destroying the
+    // pipeline during the run. Does nothing without --shader-hot-reload.
+    Result WatchShaders(grfx::GraphicsPipelinePtr* ppPipeline);
+    Result WatchShaders(grfx::ComputePipelinePtr* ppPipeline);
+    void   UnwatchShaders(const void* ppPipeline);
 
     Window*           GetWindow() const { return mWindow.get(); }
     grfx::InstancePtr GetInstance() const { return mInstance; }
     grfx::DevicePtr   GetDevice() const { return mDevice; }
+    grfx::DevicePtr   GetSecondaryDevice() const { return mSecondaryDevice; } // Null unless secondaryDevice.enable and the GPU exists
     grfx::QueuePtr    GetGraphicsQueue(uint32_t index = 0) const { return GetDevice()->GetGraphicsQueue(index); }
     grfx::QueuePtr    GetComputeQueue(uint32_t index = 0) const { return GetDevice()->GetComputeQueue(index); }
     grfx::QueuePtr    GetTransferQueue(uint32_t index = 0) const { return GetDevice()->GetTransferQueue(index); }
 
+    // Null unless ApplicationSettings::grfx.gpuProfiler.enable is set. The
+    // profiler's scopes are recorded as gpu_<path>_time metrics and listed in
+    // the debug info window. Callers own BeginFrame() and EndFrame().
+    grfx::GpuProfiler* GetGpuProfiler() const { return mGpuProfiler; }
+
+    // Null unless ApplicationSettings::grfx.dynamicResolution.enable is set.
+    // It's resized with the swapchain and its scale is listed in the debug
+    // info window. Callers own BeginFrame(), EndFrame() and Upscale().
+    grfx::DynamicResolution* GetDynamicResolution() const { return mDynamicResolution; }
+
     // "index" here is for XR applications to fetch the swapchain of different views.
     // For non-XR applications, "index" should be always 0.
     grfx::SwapchainPtr GetSwapchain(uint32_t index = 0) const;
@@ -342,9 +552,60 @@ public:
     uint32_t GetInFlightFrameIndex() const { return static_cast<uint32_t>(mFrameCount % mSettings.grfx.numFramesInFlight); }
     uint32_t GetPreviousInFlightFrameIndex() const { return static_cast<uint32_t>((mFrameCount - 1) % mSettings.grfx.numFramesInFlight); }
 
+    // Frame packet the current Render() call should draw, see Update()
+    uint32_t GetRenderPacketIndex() const { return mRenderPacketIndex; }
+    // CPU time the last Update() and Render() took in milliseconds
+    float GetPrevUpdateTime() const { return mPreviousUpdateTime; }
+    float GetPrevRenderTime() const { return mPreviousRenderTime; }
+    // Milliseconds from processing the events the last presented frame
+    // was updated with to its Present() returning
+    float GetPrevInputLatency() const { return mPreviousInputLatency; }
+    // Milliseconds the last frame was blocked waiting for the GPU to finish
+    // an earlier frame, and the rest of its frame time
+    float GetPrevGpuWaitTime() const { return mPreviousGpuWaitTime; }
+    float GetPrevCpuBusyTime() const { return std::max(mPreviousFrameTime - mPreviousGpuWaitTime, 0.0f); }
+    // Milliseconds the last frame spent recording ImGui in DrawImGui(),
+    // included in the render time. Subtract it to compare benchmarks
+    // with and without the UI.
+    float GetPrevUITime() const { return mPreviousUITime; }
+
+    // Zero until the first frame has finished
+    const StartupTimes& GetStartupTimes() const { return mStartupTimes; }
+
+    // Frame pacing
+    //
+    // The application owns a timeline semaphore for each device queue. Work
+    // submitted with SubmitFrame() during frame N signals GetFrameTimelineValue(N)
+    // on its queue's timeline. Before Render() is called for frame N the
+    // application waits until frame N - GetNumFramesInFlight() has completed
+    // on every queue, so resources indexed by GetInFlightFrameIndex() are free
+    // to reuse without per frame fences.
+    //
+    // If the device doesn't support timeline semaphores SubmitFrame() waits
+    // for the queue to go idle after submitting and WaitForFrame() is a no-op.
+    //
+    Result           SubmitFrame(grfx::Queue* pQueue, const grfx::SubmitInfo* pSubmitInfo);
+    Result           WaitForFrame(uint64_t frameIndex, uint64_t timeout = UINT64_MAX) const;
+    grfx::Semaphore* GetFrameTimeline(const grfx::Queue* pQueue) const;
+    uint64_t         GetFrameTimelineValue(uint64_t frameIndex) const { return frameIndex + 1; }
+
     const KeyState& GetKeyState(KeyCode code) const;
     float2          GetNormalizedDeviceCoordinates(int32_t x, int32_t y) const;
 
+    // Hides the cursor and keeps it in the window, MouseMove() then reports
+    // unbounded deltas for mouse look. The motion is unaccelerated with
+    // --raw-mouse-motion where the platform supports it.
+    void SetCursorCaptured(bool captured);
+    bool IsCursorCaptured() const { return mCursorCaptured; }
+
+    // With --late-input-poll, processes the window events again so that
+    // MouseMove() sees the latest input, e.g. right before Render() writes
+    // the camera matrices for submission. Only mouse moves are dispatched,
+    // coalesced into one; the other events are deferred to the next frame.
+    // Does nothing with ApplicationSettings::pipelinedUpdate, since Update()
+    // may be running, or with XR.
+    void PollLateInput();
+
     bool IsXrEnabled() const { return mSettings.xr.enable; }
 
     // Starts a new metric run and returns it. Only one run may be active at the same time.
@@ -370,6 +631,11 @@ public:
     // See StartMetricsRun for why this wrapper is necessary.
     virtual bool RecordMetricData(metrics::MetricID id, const metrics::MetricData& data);
 
+    // Same as RecordMetricData() but may be called from any thread, the data is
+    // recorded at the start of the next frame's metrics update.
+    // See StartMetricsRun for why this wrapper is necessary.
+    virtual bool QueueMetricData(metrics::MetricID id, const metrics::MetricData& data);
+
 #if defined(PPX_BUILD_XR)
     // virtual is used for testing
     virtual XrComponent& GetXrComponent()
@@ -386,6 +652,17 @@ public:
     {
         return GetSwapchain(mUISwapchainIndex);
     }
+
+    // Motion vector swapchain of the view being rendered, null unless space
+    // warp is enabled and supported. Its image must be acquired and rendered
+    // with every projection image, RenderFrame() releases both.
+    grfx::SwapchainPtr GetSpaceWarpSwapchain() const
+    {
+        if (!mSpaceWarpSwapchainIndex.has_value()) {
+            return nullptr;
+        }
+        return GetSwapchain(*mSpaceWarpSwapchainIndex + (mXrComponent.IsMultiView() ? 0 : mSwapchainIndex));
+    }
 #else
     // Alias for UI component in non-XR contexts.
     grfx::SwapchainPtr GetUISwapchain() const
@@ -397,10 +674,17 @@ private:
     void   InternalCtor();
     Result InitializeWindow();
     Result InitializePlatform();
+    Result InitializeThreadPolicies();
     Result InitializeGrfxDevice();
     Result InitializeGrfxSurface();
-    Result CreateSwapchains();
+    Result InitializeFrameTimelines();
+    void   DestroyFrameTimelines();
+    Result InitializeGpuProfiler();
+    Result InitializeDynamicResolution();
+    Result CreateSwapchains(grfx::Swapchain* pOldSwapchain = nullptr);
     void   DestroySwapchains();
+    Result RecreateSwapchains();
+    void   DestroyRetiredSwapchains(bool force);
     Result InitializeImGui();
     void   ShutdownImGui();
     void   StopGrfx();
@@ -416,11 +700,31 @@ private:
     // Add the asset directories
     void AddAssetDirs();
 
+    // Reads the bytecode of a shader, nullopt if it doesn't exist.
+    std::optional<std::vector<char>> ReadShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName) const;
+    // Compiles baseDir/<name>.hlsl for a baseName of <name>.<stage>.
+    Result CompileShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName, const std::vector<ShaderDefine>& defines, std::vector<char>* pBytecode) const;
+
     // Updates the shared, app-level metrics.
     void UpdateAppMetrics();
+    // Completes mStartupTimes at the end of the first frame. The startup_*
+    // gauges are recorded then, and by every later StartMetricsRun().
+    void FinishStartup();
+    void RecordStartupMetrics();
+    // Starts and stops the runs of --benchmark-repetitions and --sweep-path,
+    // once per frame. SetupBenchmark() returns false if neither is used.
+    bool SetupBenchmark();
+    void UpdateBenchmarkRepetitions();
+    void StartBenchmarkPoint();
+    void StartBenchmarkRepetition();
     // Saves the metrics data to a file on disk.
     void SaveMetricsReportToDisk();
 
+    // Adds the GPU profiler scopes of each frame of results to the trace.
+    void UpdateTrace();
+    // Saves the profiler trace to the --trace-path file, if set.
+    void SaveTraceToDisk();
+
     // Initializes standard knobs
     void InitStandardKnobs();
 
@@ -435,6 +739,13 @@ private:
 
     void MainLoop();
 
+    // Game thread for ApplicationSettings::pipelinedUpdate
+    void StartGameThread();
+    void StopGameThread();
+    void GameThreadMain();
+    void RequestUpdate(uint32_t packetIndex);
+    void WaitForUpdate();
+
 #if defined(PPX_BUILD_XR)
     void InitializeXRComponentBeforeGrfxDeviceInit();
     void InitializeXRComponentAndUpdateSettingsAfterGrfxDeviceInit();
@@ -459,6 +770,11 @@ private:
     void MouseUpCallback(int32_t x, int32_t y, uint32_t buttons);
     void ScrollCallback(float dx, float dy);
 
+    // Returns true if event was deferred by PollLateInput(). Otherwise
+    // dispatches the coalesced mouse move first, so events stay in order.
+    bool DeferInputEvent(std::function<void()>&& event);
+    void FlushMouseMove();
+
 private:
     CommandLineParser               mCommandLineParser;
     StandardOptions                 mStandardOpts;
@@ -471,12 +787,19 @@ private:
     KeyState                        mKeyStates[TOTAL_KEY_COUNT] = {false, 0.0f};
     int32_t                         mPreviousMouseX             = INT32_MAX;
     int32_t                         mPreviousMouseY             = INT32_MAX;
+    bool                            mCursorCaptured             = false;
     grfx::InstancePtr               mInstance                   = nullptr;
     grfx::DevicePtr                 mDevice                     = nullptr;
+    grfx::DevicePtr                 mSecondaryDevice            = nullptr;
     grfx::SurfacePtr                mSurface                    = nullptr; // Requires enableDisplay
     std::vector<grfx::SwapchainPtr> mSwapchains;                           // Requires enableDisplay
     std::unique_ptr<ImGuiImpl>      mImGui;
     KnobManager                     mKnobManager;
+    ImageReadback                   mScreenshotReadback;
+    ImageReadback                   mVideoReadback; // Ordered, writes to mVideoWriter
+    Y4mWriter                       mVideoWriter;
+    mutable ShaderHotReload         mShaderHotReload; // CreateShader() tracks the modules it creates
+    mutable ShaderCompiler          mShaderCompiler;  // CreateShader() compiles shaders without bytecode
 
     uint64_t          mFrameCount        = 0;
     uint32_t          mSwapchainIndex    = 0;
@@ -488,17 +811,166 @@ private:
     double            mFirstFrameTime    = 0;
     std::deque<float> mFrameTimesMs;
 
+    // Time blocked in RenderFrame() on frames in flight, splits CPU bound
+    // from GPU bound throughput
+    float  mPreviousGpuWaitTime = 0;
+    double mTotalGpuWaitTime    = 0;
+    double mTotalFrameTime      = 0;
+
+    // Android ADPF session of the main thread, see --performance-hints
+    ppx::PerformanceHints mPerformanceHints;
+
+    // Frame packets, see Update()
+    uint32_t mRenderPacketIndex    = 0;
+    float    mPreviousUpdateTime   = 0;
+    float    mPreviousRenderTime   = 0;
+    float    mPreviousUITime       = 0;
+    double   mUITimeAccumulator    = 0; // DrawImGui() calls of the current frame
+    double   mPacketInputTimes[2]  = {}; // When the events each packet was updated with were processed
+    float    mPreviousInputLatency = 0;
+
+    // Mouse moves coalesced by --coalesce-mouse-moves and PollLateInput(),
+    // dispatched as one move with the sum of the deltas
+    struct
+    {
+        bool     pending = false;
+        int32_t  x       = 0;
+        int32_t  y       = 0;
+        int32_t  dx      = 0;
+        int32_t  dy      = 0;
+        uint32_t buttons = 0;
+    } mPendingMouseMove;
+    bool                               mLateInputPolling = false;
+    std::vector<std::function<void()>> mDeferredInputEvents; // Replayed by the next ProcessEvents()
+
+    // Startup breakdown, the timer is started by Run()
+    struct
+    {
+        Timer  timer;
+        double setupEnd = 0;
+        bool   finished = false;
+    } mStartup;
+    StartupTimes   mStartupTimes;
+    mutable double mShaderFileLoadTime = 0; // LoadShader() reads, in milliseconds
+
+    struct
+    {
+        std::thread             thread;
+        std::mutex              mutex;
+        std::condition_variable condition;
+        bool                    updateRequested = false;
+        bool                    updateRunning   = false;
+        bool                    stop            = false;
+        uint32_t                packetIndex     = 0;
+        float                   updateTime      = 0;
+    } mGameThread;
+
+    // Frame pacing
+    struct FrameTimeline
+    {
+        const grfx::Queue* pQueue            = nullptr;
+        grfx::SemaphorePtr semaphore         = nullptr;
+        uint64_t           lastSignaledValue = 0;
+    };
+    std::vector<FrameTimeline> mFrameTimelines;
+
+    // Swapchains replaced on resize, destroyed once the work submitted before
+    // the fence has completed and their images have cycled out of presentation
+    struct RetiredSwapchain
+    {
+        grfx::SwapchainPtr swapchain;
+        grfx::FencePtr     fence;
+        uint64_t           lastFrame = 0; // Destroyed after this frame
+    };
+    std::vector<RetiredSwapchain> mRetiredSwapchains;
+
+    // GPU profiler, requires grfx.gpuProfiler.enable
+    grfx::GpuProfilerPtr mGpuProfiler;
+
+    // Dynamic resolution, requires grfx.dynamicResolution.enable
+    grfx::DynamicResolutionPtr mDynamicResolution;
+
+    // Last GPU profiler results added to the trace
+    uint64_t mTraceGpuScopesFrameNumber = 0;
+
     // Metrics
     struct
     {
-        metrics::Manager  manager;
-        metrics::MetricID cpuFrameTimeId = metrics::kInvalidMetricID;
-        metrics::MetricID framerateId    = metrics::kInvalidMetricID;
-        metrics::MetricID frameCountId   = metrics::kInvalidMetricID;
+        metrics::StreamServer stream; // Requires --metrics-stream-port, outlives the manager
+        metrics::Manager      manager;
+        metrics::MetricID     cpuFrameTimeId  = metrics::kInvalidMetricID;
+        metrics::MetricID     framerateId     = metrics::kInvalidMetricID;
+        metrics::MetricID     frameCountId    = metrics::kInvalidMetricID;
+        metrics::MetricID     cpuUpdateTimeId = metrics::kInvalidMetricID;
+        metrics::MetricID     cpuRenderTimeId = metrics::kInvalidMetricID;
+        metrics::MetricID     inputLatencyId  = metrics::kInvalidMetricID;
+        metrics::MetricID     gpuWaitTimeId   = metrics::kInvalidMetricID;
+        metrics::MetricID     cpuBusyTimeId   = metrics::kInvalidMetricID;
+
+        // ImGui cost, added with enableImGui
+        metrics::MetricID cpuUITimeId   = metrics::kInvalidMetricID;
+        metrics::MetricID uiDrawCountId = metrics::kInvalidMetricID;
+
+        // One gauge per memory heap
+        std::vector<metrics::MetricID> memoryUsageIds;
+        std::vector<metrics::MetricID> memoryBudgetIds;
+
+        // Shader module cache counters, recorded as the increase since the last frame
+        metrics::MetricID shaderModuleCacheHitsId    = metrics::kInvalidMetricID;
+        metrics::MetricID shaderModuleCacheMissesId  = metrics::kInvalidMetricID;
+        uint64_t          shaderModuleCacheHitCount  = 0;
+        uint64_t          shaderModuleCacheMissCount = 0;
+
+        // One gauge per available CPU hardware counter, requires --perf-counters
+        ppx::PerfCounters      perfCounters;
+        metrics::MetricID      perfCounterIds[PERF_COUNTER_COUNT] = {};
+        ppx::PerfCounterValues perfCounterValues;
+
+        // Thermal status and headroom, sampled once per second with --performance-hints
+        metrics::MetricID  thermalStatusId      = metrics::kInvalidMetricID;
+        metrics::MetricID  thermalHeadroomId    = metrics::kInvalidMetricID;
+        double             thermalRecordSeconds = 0.0;
+        ppx::ThermalStatus maxThermalStatus     = THERMAL_STATUS_UNKNOWN;
+
+        // Hitches of cpu_frame_time, over --frame-budget-ms
+        metrics::FrameStutterTracker stutter;
+        metrics::MetricID            framesOverBudgetId     = metrics::kInvalidMetricID;
+        metrics::MetricID            slowFrameStreakId      = metrics::kInvalidMetricID;
+        metrics::MetricID            cpuFrameTimeVarianceId = metrics::kInvalidMetricID;
+
+        // One counter per cpu_frame_time histogram bucket
+        metrics::MetricID cpuFrameTimeHistogramIds[metrics::FrameStutterTracker::kHistogramBucketCount] = {};
+
+        // Added once GPU frame times are available
+        metrics::MetricID gpuFrameTimeId = metrics::kInvalidMetricID;
+
+#if defined(PPX_BUILD_XR)
+        // XR frame pacing, see XrComponent::GetFrameTiming()
+        metrics::MetricID xrFrameWaitTimeId = metrics::kInvalidMetricID;
+        metrics::MetricID xrCpuSlackId      = metrics::kInvalidMetricID;
+        metrics::MetricID xrMissedFramesId  = metrics::kInvalidMetricID;
+#endif
+
+        // One gauge per GPU profiler scope path, added on first use
+        std::unordered_map<std::string, metrics::MetricID> gpuScopeTimeIds;
+        uint64_t                                           gpuScopesFrameNumber = 0;
 
         double   framerateRecordTimer   = 0.0;
         uint64_t framerateFrameCount    = 0;
         bool     resetFramerateTracking = true;
+
+        // --benchmark-repetitions and --sweep-path
+        struct
+        {
+            bool                             active           = false;
+            std::vector<metrics::SweepPoint> points;               // Empty without a sweep
+            uint32_t                         point            = 0; // Index of the current point
+            uint32_t                         repetition       = 0; // Repetitions of the point completed
+            uint32_t                         repetitions      = 0; // Per point
+            uint32_t                         warmupFrames     = 0; // Per point
+            uint32_t                         repetitionFrames = 0;
+            uint64_t                         frameCount       = 0; // Frames of the current repetition, or of the warmup
+        } benchmark;
     } mMetrics;
 
 #if defined(PPX_MSW)
@@ -511,10 +983,15 @@ private:
 #endif
 
 #if defined(PPX_BUILD_XR)
-    XrComponent mXrComponent;
-    uint32_t    mUISwapchainIndex           = 0;
-    uint32_t    mStereoscopicSwapchainIndex = 0;
-    ImVec2      lastImGuiWindowSize         = {};
+    XrComponent             mXrComponent;
+    uint32_t                mUISwapchainIndex           = 0;
+    uint32_t                mStereoscopicSwapchainIndex = 0;
+    std::optional<uint32_t> mSpaceWarpSwapchainIndex;    // After the UI swapchain
+    ImVec2                  lastImGuiWindowSize         = {};
+
+    // Result of this frame's ShouldRenderUI(), the UI swapchain image is
+    // only released if it was rendered
+    std::optional<bool> mRenderUIThisFrame;
 #endif
 };
 
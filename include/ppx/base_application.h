@@ -22,6 +22,9 @@
 #include "ppx/fs.h"
 
 #include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #if defined(PPX_ANDROID)
 #include <android_native_app_glue.h>
@@ -58,8 +61,20 @@ public:
     //      in any of the paths in mAssetDirs on the file system.
     //      Search starts with mAssetsDir[0].
     //
+    // Results are remembered until the next AddAssetDir(), so repeated
+    // lookups don't probe the file system again.
+    //
     std::filesystem::path GetAssetPath(const std::filesystem::path& subPath) const;
 
+    // Adds the asset pack at `path` (see fs::AssetPack) to the packs searched
+    // by LoadAsset(). Returns false if the pack can't be opened.
+    bool AddAssetPack(const std::filesystem::path& path);
+
+    // Returns the content of subPath from the first asset pack that has it,
+    // or else from the first asset directory that has it. Packs are searched
+    // in the order they were added, using subPath with '/' separators.
+    std::optional<std::vector<char>> LoadAsset(const std::filesystem::path& subPath) const;
+
 #if defined(PPX_ANDROID)
     void SetAndroidContext(android_app* androidContext)
     {
@@ -72,11 +87,18 @@ public:
     }
 #endif
 
+protected:
+    // Returns an empty path if subPath isn't in any asset directory
+    std::filesystem::path FindAssetPath(const std::filesystem::path& subPath) const;
+
 private:
 #if defined(PPX_ANDROID)
     android_app* mAndroidContext;
 #endif
-    std::vector<std::filesystem::path> mAssetDirs;
+    std::vector<std::filesystem::path>                             mAssetDirs;
+    std::vector<std::unique_ptr<fs::AssetPack>>                    mAssetPacks;
+    mutable std::mutex                                             mAssetPathCacheMutex;
+    mutable std::unordered_map<std::string, std::filesystem::path> mAssetPathCache;
 };
 
 } // namespace ppx
@@ -0,0 +1,146 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_batch_math_h
+#define ppx_batch_math_h
+
+#include "ppx/bounding_volume.h"
+#include "ppx/transform.h"
+
+#include <vector>
+
+namespace ppx {
+
+//! @class TransformArrays
+//!
+//! @brief Translation, rotation and scale of many objects, one array per
+//!        component (SoA) so the batch functions below can work on several
+//!        objects per SIMD instruction. Rotations are Euler angles in
+//!        radians, like ppx::Transform.
+//!
+class TransformArrays
+{
+public:
+    enum Component
+    {
+        TRANSLATION_X   = 0,
+        TRANSLATION_Y   = 1,
+        TRANSLATION_Z   = 2,
+        ROTATION_X      = 3,
+        ROTATION_Y      = 4,
+        ROTATION_Z      = 5,
+        SCALE_X         = 6,
+        SCALE_Y         = 7,
+        SCALE_Z         = 8,
+        COMPONENT_COUNT = 9,
+    };
+
+    TransformArrays() {}
+    TransformArrays(uint32_t count) { Resize(count); }
+    ~TransformArrays() {}
+
+    //! New objects have no translation and rotation and a scale of 1
+    void     Resize(uint32_t count);
+    uint32_t GetCount() const { return mCount; }
+
+    void Set(uint32_t index, const float3& translation, const float3& rotation, const float3& scale);
+    void Set(uint32_t index, const ppx::Transform& transform);
+
+    float3 GetTranslation(uint32_t index) const;
+    float3 GetRotation(uint32_t index) const;
+    float3 GetScale(uint32_t index) const;
+
+    float*       GetComponent(Component component) { return mComponents[component].data(); }
+    const float* GetComponent(Component component) const { return mComponents[component].data(); }
+
+private:
+    uint32_t           mCount = 0;
+    std::vector<float> mComponents[COMPONENT_COUNT];
+};
+
+//! @class AABBArrays
+//!
+//! @brief Bounds of many objects, one array per component (SoA)
+//!
+class AABBArrays
+{
+public:
+    enum Component
+    {
+        MIN_X           = 0,
+        MIN_Y           = 1,
+        MIN_Z           = 2,
+        MAX_X           = 3,
+        MAX_Y           = 4,
+        MAX_Z           = 5,
+        COMPONENT_COUNT = 6,
+    };
+
+    AABBArrays() {}
+    AABBArrays(uint32_t count) { Resize(count); }
+    ~AABBArrays() {}
+
+    //! New objects have empty bounds at the origin
+    void     Resize(uint32_t count);
+    uint32_t GetCount() const { return mCount; }
+
+    void      Set(uint32_t index, const ppx::AABB& aabb);
+    ppx::AABB Get(uint32_t index) const;
+
+    float*       GetComponent(Component component) { return mComponents[component].data(); }
+    const float* GetComponent(Component component) const { return mComponents[component].data(); }
+
+private:
+    uint32_t           mCount = 0;
+    std::vector<float> mComponents[COMPONENT_COUNT];
+};
+
+// -------------------------------------------------------------------------------------------------
+// Batch functions
+//
+// Work on 4 objects at a time with SSE2 on x64 and NEON on ARM64, other
+// CPUs use a scalar loop. Results match the per-object functions within
+// float rounding: sines and cosines are computed with a polynomial that's
+// accurate to about 1e-6 for angles within a few turns.
+// -------------------------------------------------------------------------------------------------
+
+//! Writes T * R * S of every object to pMatrices, which must hold
+//! transforms.GetCount() matrices. Same as
+//! ppx::Transform::GetConcatenatedMatrix() with rotationOrder.
+void ComputeTransformMatrices(
+    const ppx::TransformArrays&   transforms,
+    ppx::Transform::RotationOrder rotationOrder,
+    float4x4*                     pMatrices);
+
+//! Writes the axis-aligned box around each box of bounds transformed by the
+//! matrix at the same index of pMatrices to pTransformed, which is resized
+//! to bounds.GetCount(). Same as ppx::AABB::GetTransformed() for affine
+//! matrices.
+void TransformAABBs(
+    const ppx::AABBArrays& bounds,
+    const float4x4*        pMatrices,
+    ppx::AABBArrays*       pTransformed);
+
+//! Writes the indices of the boxes of bounds that overlap frustum to
+//! pVisibleIndices in increasing order and returns how many were written.
+//! pVisibleIndices must hold bounds.GetCount() indices. Same as
+//! ppx::Frustum::Overlaps() for each box.
+uint32_t CullAABBs(
+    const ppx::Frustum&    frustum,
+    const ppx::AABBArrays& bounds,
+    uint32_t*              pVisibleIndices);
+
+} // namespace ppx
+
+#endif // ppx_batch_math_h
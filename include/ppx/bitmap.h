@@ -60,6 +60,17 @@ public:
         FORMAT_RGBA_FLOAT,
     };
 
+    // Backends LoadFile() and LoadFromMemory() decode with. stb_image is
+    // always built and decodes everything others don't. The others are
+    // build options, see PPX_ENABLE_TURBOJPEG and PPX_ENABLE_SPNG.
+    enum Decoder
+    {
+        DECODER_DEFAULT = 0, // Fastest available backend for the file
+        DECODER_STB,
+        DECODER_TURBOJPEG,
+        DECODER_SPNG,
+    };
+
     // ---------------------------------------------------------------------------------------------
 
     Bitmap();
@@ -97,6 +108,17 @@ public:
     Result ScaleTo(Bitmap* pTargetBitmap) const;
     Result ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType) const;
 
+    //! Writes the pixels of a bitmap with the same size in format to
+    //! pTargetBitmap, which is recreated with internal storage if its size or
+    //! format differ. Integer channels are normalized, float channels are
+    //! clamped to [0, 1] for integer formats. Missing color channels are 0 and
+    //! missing alpha is opaque. Uses SIMD kernels for 8, 16 bit and float
+    //! conversions when the CPU has them.
+    Result ConvertTo(Bitmap::Format format, Bitmap* pTargetBitmap) const;
+
+    //! Multiplies color channels by alpha, fails for formats without alpha.
+    Result PremultiplyAlpha();
+
     template <typename PixelDataType>
     void Fill(PixelDataType r, PixelDataType g, PixelDataType b, PixelDataType a);
 
@@ -125,10 +147,22 @@ public:
 
     static Result GetFileProperties(const std::filesystem::path& path, uint32_t* pWidth, uint32_t* pHeight, Bitmap::Format* pFormat);
     static Result LoadFile(const std::filesystem::path& path, Bitmap* pBitmap);
+    // Decodes into pExternalStorage, e.g. a mapped staging buffer, which must hold height rows of
+    // rowStride bytes in the format GetFileProperties() reports. A rowStride of 0 means tightly
+    // packed rows. pBitmap references the storage without owning it. Pass a null pExternalStorage
+    // to only pick the decoder.
+    static Result LoadFile(const std::filesystem::path& path, uint32_t rowStride, char* pExternalStorage, Bitmap* pBitmap, Bitmap::Decoder decoder = Bitmap::DECODER_DEFAULT);
+    // 8-bit formats only, see EncodePNG() in image_encoder.h
     static Result SaveFilePNG(const std::filesystem::path& path, const Bitmap* pBitmap);
     static bool   IsBitmapFile(const std::filesystem::path& path);
 
     static Result LoadFromMemory(const size_t dataSize, const void* pData, Bitmap* pBitmap);
+    // Decodes into pExternalStorage, see LoadFile()
+    static Result LoadFromMemory(const size_t dataSize, const void* pData, uint32_t rowStride, char* pExternalStorage, Bitmap* pBitmap, Bitmap::Decoder decoder = Bitmap::DECODER_DEFAULT);
+
+    // Returns true if decoder was built in. DECODER_STB and DECODER_DEFAULT always are.
+    static bool        IsDecoderAvailable(Bitmap::Decoder decoder);
+    static const char* ToString(Bitmap::Decoder decoder);
 
     // ---------------------------------------------------------------------------------------------
 
@@ -198,11 +232,12 @@ private:
     Result InternalInitialize(uint32_t width, uint32_t height, Bitmap::Format format, uint32_t rowStride, char* pExternalStorage);
     Result InternalCopy(const Bitmap& obj);
     void   FreeStbiDataIfNeeded();
+    void   InternalFill(const void* pPixel);
 
     // Stbi-specific functions/wrappers.
     // These arguments generally mirror those for stbi_load, except format which is used to determine whether
     // the call should be made to stbi_load or stbi_loadf (that is, whether the file to be read is in integer or floating point format).
-    static char* StbiLoad(const std::filesystem::path& path, Bitmap::Format format, int* pWidth, int* pHeight, int* pChannels, int desiredChannels);
+    static char* StbiLoad(const void* pData, size_t dataSize, Bitmap::Format format, int* pWidth, int* pHeight, int* pChannels, int desiredChannels);
     // These arugments mirror those for stbi_info.
     static Result StbiInfo(const std::filesystem::path& path, int* pX, int* pY, int* pComp);
 
@@ -224,20 +259,11 @@ void Bitmap::Fill(PixelDataType r, PixelDataType g, PixelDataType b, PixelDataTy
     PPX_ASSERT_MSG(mData != nullptr, "data is null");
     PPX_ASSERT_MSG(mFormat != Bitmap::FORMAT_UNDEFINED, "format is undefined");
 
-    PixelDataType rgba[4] = {r, g, b, a};
-
-    const uint32_t channelCount = Bitmap::ChannelCount(mFormat);
+    PPX_ASSERT_MSG(sizeof(PixelDataType) == Bitmap::ChannelSize(mFormat), "pixel data type doesn't match format");
 
-    char* pData = mData;
-    for (uint32_t y = 0; y < mHeight; ++y) {
-        for (uint32_t x = 0; x < mWidth; ++x) {
-            PixelDataType* pPixelData = reinterpret_cast<PixelDataType*>(pData);
-            for (uint32_t c = 0; c < channelCount; ++c) {
-                pPixelData[c] = rgba[c];
-            }
-            pData += mPixelStride;
-        }
-    }
+    // The first channelCount values are the pixel
+    PixelDataType rgba[4] = {r, g, b, a};
+    InternalFill(rgba);
 }
 
 } // namespace ppx
@@ -21,6 +21,7 @@ namespace ppx {
 
 class AABB;
 class OBB;
+class Frustum;
 
 //! @class AABB
 //!
@@ -66,6 +67,12 @@ public:
         mMax = glm::max(pos, mMax);
     }
 
+    void Expand(const AABB& aabb)
+    {
+        mMin = glm::min(aabb.mMin, mMin);
+        mMax = glm::max(aabb.mMax, mMax);
+    }
+
     const float3& GetMin() const
     {
         return mMin;
@@ -124,8 +131,17 @@ public:
         return W;
     }
 
+    float GetSurfaceArea() const
+    {
+        float3 size = GetSize();
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
     void Transform(const float4x4& matrix, float3 obbVertices[8]) const;
 
+    //! Returns the axis-aligned box around the transformed box
+    AABB GetTransformed(const float4x4& matrix) const;
+
 private:
     float3 mMin = float3(0, 0, 0);
     float3 mMax = float3(0, 0, 0);
@@ -188,6 +204,50 @@ private:
     float3 mW      = float3(0, 0, 1);
 };
 
+//! @class Frustum
+//!
+//! @brief Planes of a view projection matrix with a [0, 1] depth range,
+//!        plane normals point inside
+//!
+class Frustum
+{
+public:
+    enum Plane
+    {
+        PLANE_LEFT   = 0,
+        PLANE_RIGHT  = 1,
+        PLANE_BOTTOM = 2,
+        PLANE_TOP    = 3,
+        PLANE_NEAR   = 4,
+        PLANE_FAR    = 5,
+        PLANE_COUNT  = 6,
+    };
+
+    Frustum() {}
+
+    Frustum(const float4x4& viewProjectionMatrix)
+    {
+        Set(viewProjectionMatrix);
+    }
+
+    ~Frustum() {}
+
+    void Set(const float4x4& viewProjectionMatrix);
+
+    //! Returns plane as float4(normal, distance), normalized
+    const float4& GetPlane(uint32_t index) const
+    {
+        return mPlanes[index];
+    }
+
+    //! Returns false if aabb is entirely outside of one of the planes. Boxes
+    //! near the corners of the frustum can be outside and still overlap.
+    bool Overlaps(const AABB& aabb) const;
+
+private:
+    float4 mPlanes[PLANE_COUNT] = {};
+};
+
 } // namespace ppx
 
 #endif // ppx_bounding_volume_h
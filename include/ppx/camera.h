@@ -66,6 +66,16 @@ public:
 
     void MoveAlongViewDirection(float distance);
 
+    // Offsets the projection by a fraction of a pixel for temporal
+    // anti-aliasing, see grfx::TemporalResolve. pixelOffset is in pixels of
+    // a width x height viewport, +y is down. GetProjectionMatrix() and
+    // GetViewProjectionMatrix() stay unjittered for reprojection.
+    void          SetJitter(const float2& pixelOffset, uint32_t width, uint32_t height);
+    void          ClearJitter() { mJitter = float2(0, 0); }
+    const float2& GetJitter() const { return mJitter; } // Clip space
+    float4x4      GetJitteredProjectionMatrix() const;
+    float4x4      GetJitteredViewProjectionMatrix() const;
+
 protected:
     bool             mPixelAligned         = false;
     float            mNearClip             = PPX_CAMERA_DEFAULT_NEAR_CLIP;
@@ -74,6 +84,7 @@ protected:
     float3           mTarget               = PPX_CAMERA_DEFAULT_LOOK_AT;
     float3           mViewDirection        = PPX_CAMERA_DEFAULT_VIEW_DIRECTION;
     float3           mWorldUp              = PPX_CAMERA_DEFAULT_WORLD_UP;
+    float2           mJitter               = float2(0, 0);
     mutable float4x4 mViewMatrix           = float4x4(1);
     mutable float4x4 mProjectionMatrix     = float4x4(1);
     mutable float4x4 mViewProjectionMatrix = float4x4(1);
@@ -0,0 +1,235 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_command_capture_h
+#define ppx_command_capture_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ppx {
+
+// -------------------------------------------------------------------------------------------------
+// Capture data
+// -------------------------------------------------------------------------------------------------
+
+enum CaptureCommandOp : uint32_t
+{
+    CAPTURE_COMMAND_OP_BIND_COMPUTE_PIPELINE  = 1, // pipeline
+    CAPTURE_COMMAND_OP_PUSH_COMPUTE_CONSTANTS = 2, // interface, dstOffset, count, values[count]
+    CAPTURE_COMMAND_OP_PUSH_COMPUTE_BUFFER    = 3, // interface, descriptorType, binding, set, bufferOffset, buffer
+    CAPTURE_COMMAND_OP_BUFFER_BARRIER         = 4, // buffer, beforeState, afterState
+    CAPTURE_COMMAND_OP_COPY_BUFFER            = 5, // srcBuffer, dstBuffer, srcOffset (lo, hi), dstOffset, size (lo, hi)
+    CAPTURE_COMMAND_OP_DISPATCH               = 6, // groupCountX, groupCountY, groupCountZ
+};
+
+struct CaptureSetLayout
+{
+    uint32_t set = 0;
+
+    struct Binding
+    {
+        uint32_t binding    = 0;
+        uint32_t type       = 0; // grfx::DescriptorType
+        uint32_t arrayCount = 1;
+    };
+    std::vector<Binding> bindings;
+};
+
+struct CaptureInterface
+{
+    std::vector<CaptureSetLayout> sets; // Pushable sets only
+    uint32_t                      pushConstantCount   = 0;
+    uint32_t                      pushConstantBinding = PPX_VALUE_IGNORED;
+    uint32_t                      pushConstantSet     = PPX_VALUE_IGNORED;
+};
+
+struct CapturePipeline
+{
+    uint32_t    shaderIndex    = 0;
+    uint32_t    interfaceIndex = 0;
+    std::string entryPoint;
+};
+
+struct CaptureBuffer
+{
+    uint64_t          size                    = 0;
+    uint32_t          structuredElementStride = 0;
+    uint32_t          usageFlags              = 0; // grfx::BufferUsageFlags::flags
+    uint32_t          state                   = 0; // grfx::ResourceState at the start of every frame
+    std::vector<char> contents;                    // At the start of the first frame
+};
+
+//! @struct CaptureData
+//!
+//! Objects and commands of the frames recorded by ppx::CommandCapture.
+//! Commands reference objects by their index in the vectors, each frame
+//! is a stream of { op, word count, words... } records.
+//!
+struct CaptureData
+{
+    uint32_t                           api = 0; // grfx::Api the capture was made with
+    std::vector<std::vector<char>>     shaders; // Bytecode of that API
+    std::vector<CaptureInterface>      interfaces;
+    std::vector<CapturePipeline>       pipelines;
+    std::vector<CaptureBuffer>         buffers;
+    std::vector<std::vector<uint32_t>> frames;
+};
+
+Result SaveCaptureData(const std::filesystem::path& path, const CaptureData& data);
+Result LoadCaptureData(const std::filesystem::path& path, CaptureData* pData);
+
+// -------------------------------------------------------------------------------------------------
+// CommandCapture
+// -------------------------------------------------------------------------------------------------
+
+struct CommandCaptureCreateInfo
+{
+    uint32_t frameCount = 1; // Frames captured after Start()
+};
+
+//! @class CommandCapture
+//!
+//! Captures the compute work of a few frames with the contents of the
+//! buffers it reads, so it can be replayed by ppx::CaptureReplayer in a
+//! tight loop without the application's CPU work, and on other devices.
+//!
+//! Commands are recorded through the capture instead of the command
+//! buffer, the capture records them into the command buffer and, while
+//! capturing, into the capture. Only what replays identically is
+//! captured: compute pipelines whose sets are all pushable and that have
+//! no specialization constants, push descriptors and push constants,
+//! buffer barriers, buffer copies and dispatches. Objects are registered
+//! beforehand:
+//!
+//!   capture.AddComputePipeline(pipeline, bytecode); // Bytecode of its CS
+//!   capture.AddBuffer(buffer, state);               // State at the start of each frame
+//!   capture.Start();
+//!
+//! Per frame:
+//!   capture.BeginFrame(pCmd); // Outside of a render pass
+//!   capture.BindComputePipeline(pCmd, pipeline);
+//!   capture.PushComputeStorageBuffer(pCmd, ...);
+//!   capture.Dispatch(pCmd, x, y, z);
+//!   capture.EndFrame();
+//!
+//! Buffer contents are copied at the start of the first captured frame,
+//! which requires transferSrc usage. Save() writes the capture once
+//! IsComplete() and the GPU has finished the first captured frame.
+//!
+class CommandCapture
+{
+public:
+    CommandCapture();
+    virtual ~CommandCapture();
+
+    static Result Create(grfx::Device* pDevice, const CommandCaptureCreateInfo& createInfo, CommandCapture** ppCapture);
+
+    Result AddComputePipeline(const grfx::ComputePipeline* pPipeline, const std::vector<char>& bytecode);
+    Result AddBuffer(const grfx::Buffer* pBuffer, grfx::ResourceState state);
+
+    //! Captures the next frameCount frames
+    Result Start();
+    bool   IsCapturing() const { return mCapturing; }
+    bool   IsComplete() const { return !mCapturing && !mData.frames.empty(); }
+
+    void BeginFrame(grfx::CommandBuffer* pCmd);
+    void EndFrame();
+
+    //! Reads the buffer snapshots back and writes the capture
+    Result Save(const std::filesystem::path& path);
+
+    void BindComputePipeline(grfx::CommandBuffer* pCmd, const grfx::ComputePipeline* pPipeline);
+    void PushComputeConstants(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t count, const void* pValues, uint32_t dstOffset = 0);
+    void PushComputeUniformBuffer(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer);
+    void PushComputeStructuredBuffer(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer);
+    void PushComputeStorageBuffer(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer);
+    void BufferResourceBarrier(grfx::CommandBuffer* pCmd, const grfx::Buffer* pBuffer, grfx::ResourceState beforeState, grfx::ResourceState afterState);
+    void CopyBufferToBuffer(grfx::CommandBuffer* pCmd, const grfx::BufferToBufferCopyInfo* pCopyInfo, const grfx::Buffer* pSrcBuffer, const grfx::Buffer* pDstBuffer);
+    void Dispatch(grfx::CommandBuffer* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+
+private:
+    Result   AddInterface(const grfx::PipelineInterface* pInterface, uint32_t* pIndex);
+    uint32_t GetIndex(const std::unordered_map<const void*, uint32_t>& indices, const void* pObject) const;
+    void     PushBuffer(grfx::DescriptorType type, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer);
+    void     Write(CaptureCommandOp op, std::initializer_list<uint32_t> words, uint32_t extraCount = 0, const uint32_t* pExtra = nullptr);
+
+private:
+    grfx::Device*                             mDevice = nullptr;
+    CommandCaptureCreateInfo                  mCreateInfo;
+    bool                                      mCapturing = false;
+    bool                                      mInFrame   = false;
+    CaptureData                               mData;
+    std::unordered_map<const void*, uint32_t> mShaderIndices; // By shader module
+    std::unordered_map<const void*, uint32_t> mInterfaceIndices;
+    std::unordered_map<const void*, uint32_t> mPipelineIndices;
+    std::unordered_map<const void*, uint32_t> mBufferIndices;
+    std::vector<const grfx::Buffer*>          mBuffers;
+    std::vector<grfx::BufferPtr>              mSnapshots; // Read back by Save()
+};
+
+// -------------------------------------------------------------------------------------------------
+// CaptureReplayer
+// -------------------------------------------------------------------------------------------------
+
+//! @class CaptureReplayer
+//!
+//! Recreates the objects of a capture on a device and records its frames.
+//! The capture must have been made with the same API, shaders are stored
+//! as bytecode.
+//!
+class CaptureReplayer
+{
+public:
+    CaptureReplayer();
+    virtual ~CaptureReplayer();
+
+    //! Uploads the buffer contents with pQueue
+    static Result Create(grfx::Queue* pQueue, const CaptureData& data, CaptureReplayer** ppReplayer);
+
+    uint32_t GetFrameCount() const { return CountU32(mFrames); }
+
+    //! Restores the captured buffer contents, so replays start from the
+    //! same data
+    void RecordResetContents(grfx::CommandBuffer* pCmd);
+
+    //! Records every frame of the capture
+    void RecordFrames(grfx::CommandBuffer* pCmd);
+
+private:
+    Result Initialize(grfx::Queue* pQueue, const CaptureData& data);
+
+private:
+    grfx::Device*                             mDevice = nullptr;
+    std::vector<grfx::DescriptorSetLayoutPtr> mSetLayouts;
+    std::vector<grfx::PipelineInterfacePtr>   mInterfaces;
+    std::vector<grfx::ComputePipelinePtr>     mPipelines;
+    std::vector<grfx::BufferPtr>              mBuffers;
+    std::vector<grfx::ResourceState>          mBufferStates;
+    std::vector<grfx::BufferPtr>              mContents; // Copied into mBuffers by RecordResetContents()
+    std::vector<std::vector<uint32_t>>        mFrames;
+};
+
+} // namespace ppx
+
+#endif // ppx_command_capture_h
@@ -0,0 +1,75 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_compute_context_h
+#define ppx_compute_context_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_instance.h"
+
+#include <filesystem>
+
+namespace ppx {
+
+struct ComputeContextCreateInfo
+{
+    grfx::Api   api                 = grfx::API_UNDEFINED;
+    uint32_t    gpuIndex            = 0;
+    uint32_t    computeQueueCount   = 1;
+    bool        enableDebug         = false;
+    bool        useSoftwareRenderer = false; // WARP on DirectX
+    std::string applicationName;
+};
+
+//! @class ComputeContext
+//!
+//! Instance, device and compute queues without a window, swapchain or
+//! frame loop, for tools and servers that only dispatch compute work on
+//! GPUs without displays. Use grfx::ComputeBatchRunner to push a stream
+//! of jobs through the queues; ppx::Application is only needed when
+//! results are presented.
+//!
+//! The device has no graphics queue, so anything that records graphics
+//! work, e.g. grfx_util helpers that blit, isn't available.
+//!
+class ComputeContext
+{
+public:
+    ComputeContext();
+    virtual ~ComputeContext();
+
+    static Result Create(const ComputeContextCreateInfo& createInfo, ComputeContext** ppContext);
+
+    grfx::InstancePtr GetInstance() const { return mInstance; }
+    grfx::DevicePtr   GetDevice() const { return mDevice; }
+    uint32_t          GetComputeQueueCount() const { return mDevice->GetComputeQueueCount(); }
+    grfx::QueuePtr    GetComputeQueue(uint32_t index = 0) const { return mDevice->GetComputeQueue(index); }
+
+    //! Creates a shader module from compiled bytecode, e.g. a .spv or .dxil
+    //! file produced by the shader build rules.
+    Result CreateShader(const std::filesystem::path& path, grfx::ShaderModule** ppShaderModule) const;
+
+private:
+    Result Initialize(const ComputeContextCreateInfo& createInfo);
+
+private:
+    grfx::InstancePtr mInstance;
+    grfx::DevicePtr   mDevice;
+};
+
+} // namespace ppx
+
+#endif // ppx_compute_context_h
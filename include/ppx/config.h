@@ -191,6 +191,9 @@ enum Result
     ERROR_SCENE_INVALID_NODE_HIERARCHY              = -6018,
     ERROR_SCENE_INVALID_STANDALONE_OPERATION        = -6019,
     ERROR_SCENE_NODE_ALREADY_HAS_PARENT             = -6020,
+    ERROR_SCENE_CACHE_MISMATCH                      = -6021,
+    ERROR_SCENE_CACHE_SAVE_FAILED                   = -6022,
+    ERROR_SCENE_UNSUPPORTED_COMPRESSION             = -6023,
 };
 
 inline const char* ToString(ppx::Result value)
@@ -296,6 +299,9 @@ inline const char* ToString(ppx::Result value)
         case Result::ERROR_SCENE_INVALID_NODE_HIERARCHY               : return "ERROR_SCENE_INVALID_NODE_HIERARCHY";
         case Result::ERROR_SCENE_INVALID_STANDALONE_OPERATION         : return "ERROR_SCENE_INVALID_STANDALONE_OPERATION";
         case Result::ERROR_SCENE_NODE_ALREADY_HAS_PARENT              : return "ERROR_SCENE_NODE_ALREADY_HAS_PARENT";
+        case Result::ERROR_SCENE_CACHE_MISMATCH                       : return "ERROR_SCENE_CACHE_MISMATCH";
+        case Result::ERROR_SCENE_CACHE_SAVE_FAILED                    : return "ERROR_SCENE_CACHE_SAVE_FAILED";
+        case Result::ERROR_SCENE_UNSUPPORTED_COMPRESSION              : return "ERROR_SCENE_UNSUPPORTED_COMPRESSION";
     }
     // clang-format on
     return "<unknown ppx::Result value>";
@@ -15,13 +15,20 @@
 #ifndef PPX_CSV_FILE_LOG_H
 #define PPX_CSV_FILE_LOG_H
 
+#include <charconv>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <mutex>
 #include <sstream>
 #include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 
 const std::string PPX_DEFAULT_CSV_FILE{"stats.csv"};
 
@@ -29,19 +36,60 @@ namespace ppx {
 
 //! @class CSVFileLog
 //!
+//! Appends rows to a preallocated buffer. Once the buffer holds bufferSize
+//! bytes it's handed to a writer thread, so the file is written off the
+//! calling thread; the rest is written when the log is destroyed.
+//! Numbers and strings are formatted in place without streams, other
+//! types fall back to operator<< on a std::ostream. Appends must come from
+//! a single thread.
 //!
 class CSVFileLog
 {
 public:
+    static constexpr size_t kDefaultBufferSize = 64 * 1024;
+
     CSVFileLog();
-    CSVFileLog(const std::filesystem::path& filepath);
+    CSVFileLog(const std::filesystem::path& filepath, size_t bufferSize = kDefaultBufferSize);
     ~CSVFileLog();
 
+    CSVFileLog(const CSVFileLog&)            = delete;
+    CSVFileLog& operator=(const CSVFileLog&) = delete;
+
+    CSVFileLog& operator<<(std::string_view value)
+    {
+        mBuffer.append(value);
+        return AfterAppend();
+    }
+    CSVFileLog& operator<<(const char* value) { return (*this) << std::string_view(value); }
+    CSVFileLog& operator<<(const std::string& value) { return (*this) << std::string_view(value); }
+
     template <typename T>
     CSVFileLog& operator<<(const T& value)
     {
-        mBuffer << value;
-        return *this;
+        if constexpr (std::is_same_v<T, bool>) {
+            mBuffer.push_back(value ? '1' : '0');
+        }
+        else if constexpr (std::is_same_v<T, char> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+            // Characters, like streams write them
+            mBuffer.push_back(static_cast<char>(value));
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            char chars[24];
+            auto result = std::to_chars(chars, chars + sizeof(chars), value);
+            mBuffer.append(chars, result.ptr);
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            // Same as the default precision of streams
+            char      chars[32];
+            const int length = std::snprintf(chars, sizeof(chars), "%g", static_cast<double>(value));
+            mBuffer.append(chars, static_cast<size_t>(length));
+        }
+        else {
+            std::ostringstream stream;
+            stream << value;
+            mBuffer.append(stream.str());
+        }
+        return AfterAppend();
     }
 
     template <typename T>
@@ -59,16 +107,30 @@ public:
         (*this) << "\n";
     }
 
-private:
-    void Write(const char* msg);
-    void Lock();
-    void Unlock();
+    //! Hands the buffered rows to the writer thread without waiting
     void Flush();
 
 private:
-    std::ofstream     mFileStream;
-    std::stringstream mBuffer;
-    std::mutex        mWriteMutex;
+    CSVFileLog& AfterAppend()
+    {
+        if (mBuffer.size() >= mBufferSize) {
+            Flush();
+        }
+        return *this;
+    }
+
+    void WriterThreadMain();
+
+private:
+    std::ofstream mFileStream;
+    size_t        mBufferSize = 0;
+    std::string   mBuffer;
+
+    std::thread             mWriterThread;
+    std::mutex              mWriteMutex;
+    std::condition_variable mWriteCondition;
+    std::string             mPending; // Rows handed to the writer thread
+    bool                    mStopWriterThread = false;
 };
 
 } // namespace ppx
@@ -0,0 +1,75 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PPX_DYNAMIC_RESOLUTION_H
+#define PPX_DYNAMIC_RESOLUTION_H
+
+#include "ppx/config.h"
+
+namespace ppx {
+
+struct DynamicResolutionControllerCreateInfo
+{
+    float    targetFrameTimeMs = 16.6f;
+    float    minScale          = 0.5f;
+    float    maxScale          = 1.0f;
+    float    headroom          = 0.1f; // Fraction of the target below it where the scale is kept
+    float    smoothing         = 0.2f; // Weight of each new frame time in the running average
+    uint32_t cooldownFrames    = 8;    // Frames after a change before the next one, covers the readback latency
+    uint32_t alignment         = 8;    // Render sizes are rounded up to multiples of this
+};
+
+//! @class DynamicResolutionController
+//!
+//! Picks the render scale that keeps the GPU frame time just below a
+//! target. GPU time is assumed to scale with the pixel count, so the scale
+//! is corrected by the square root of the ratio of the target to the
+//! average frame time. Scaling down is done in one step, scaling up by at
+//! most 10% per change so a frame time spike doesn't make it oscillate.
+//!
+//! The scale applies to both dimensions.
+//!
+class DynamicResolutionController
+{
+public:
+    DynamicResolutionController() {}
+    ~DynamicResolutionController() {}
+
+    Result Initialize(const DynamicResolutionControllerCreateInfo& createInfo);
+
+    //! Feeds the GPU time of one frame, returns true if the scale changed
+    bool Update(float gpuFrameTimeMs);
+    //! Goes back to maxScale and forgets the frame times seen so far
+    void Reset();
+
+    float GetScale() const { return mScale; }
+    float GetAverageFrameTimeMs() const { return mAverageFrameTimeMs; }
+    float GetTargetFrameTimeMs() const { return mCreateInfo.targetFrameTimeMs; }
+    void  SetTargetFrameTimeMs(float targetFrameTimeMs);
+
+    //! Size to render at for render targets of maxWidth x maxHeight,
+    //! never larger than those or smaller than 1
+    void GetRenderSize(uint32_t maxWidth, uint32_t maxHeight, uint32_t* pWidth, uint32_t* pHeight) const;
+
+private:
+    DynamicResolutionControllerCreateInfo mCreateInfo         = {};
+    float                                 mScale              = 1.0f;
+    float                                 mAverageFrameTimeMs = 0.0f;
+    uint32_t                              mCooldown           = 0;
+    bool                                  mHasAverage         = false;
+};
+
+} // namespace ppx
+
+#endif // PPX_DYNAMIC_RESOLUTION_H
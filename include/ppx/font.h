@@ -75,6 +75,26 @@ public:
         uint32_t       rowStride,
         unsigned char* pOutput) const;
 
+    // Box of the signed distance field rendered by RenderGlyphSDF(), which
+    // is the glyph's bitmap box grown by padding pixels on every side.
+    void GetGlyphSDFBox(
+        float     fontSizeInPixels,
+        uint32_t  codepoint,
+        uint32_t  padding,
+        GlyphBox* pBox) const;
+
+    // Renders a signed distance field where the glyph's edge is 128 and the
+    // value falls to 0 padding pixels outside of it. Safe to call from
+    // several threads at once.
+    void RenderGlyphSDF(
+        float          fontSizeInPixels,
+        uint32_t       codepoint,
+        uint32_t       padding,
+        uint32_t       glyphWidth,
+        uint32_t       glyphHeight,
+        uint32_t       rowStride,
+        unsigned char* pOutput) const;
+
 private:
     void AcquireFontMetrics();
 
@@ -0,0 +1,190 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_frame_arena_h
+#define ppx_frame_arena_h
+
+#include "ppx/config.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace ppx {
+
+//! @class FrameArena
+//!
+//! Linear allocator for temporary CPU memory. Allocations bump a pointer
+//! in the current block and are never freed individually; Reset() or
+//! rewinding a Scope releases them all at once. Blocks are kept across
+//! resets, so after the first frames the arena stops touching the heap.
+//! Destructors of objects placed in the arena aren't called.
+//!
+//! Each thread has its own arena, see GetThreadArena(). Thread arenas
+//! are reset at the first use after NextFrame(), which the Application
+//! calls once per frame, so their memory is valid until the end of the
+//! frame it was allocated in. Code that can run across a frame boundary,
+//! like job workers and command recording, should allocate inside of a
+//! Scope instead:
+//!
+//!   FrameArena::Scope scope(FrameArena::GetThreadArena());
+//!   FrameVector<VkImageMemoryBarrier> barriers(scope.GetAllocator<VkImageMemoryBarrier>());
+//!
+//! Arenas aren't thread safe, only the owning thread may use a thread
+//! arena.
+//!
+class FrameArena
+{
+public:
+    class Scope;
+
+    //! Position in the arena that Rewind() returns to
+    struct Marker
+    {
+        size_t block  = 0;
+        size_t offset = 0;
+    };
+
+    FrameArena(size_t blockSize = 64 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&)            = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    //! Never returns null, size 0 returns a unique pointer
+    void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    template <typename T>
+    T* AllocateArray(size_t count)
+    {
+        return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+    }
+
+    Marker GetMarker() const { return {mCurrentBlock, mOffset}; }
+
+    //! Releases everything allocated after marker was taken
+    void Rewind(const Marker& marker);
+
+    //! Releases every allocation. Blocks are merged into one that holds
+    //! what this frame used, so the next frame fits in a single block.
+    void Reset();
+
+    size_t GetUsedBytes() const;
+    size_t GetCapacity() const;
+    //! Most bytes used at once since the arena was created
+    size_t GetPeakUsedBytes() const { return mPeakUsedBytes; }
+
+    //! Arena of the calling thread
+    static FrameArena& GetThreadArena();
+
+    //! Starts a new frame, thread arenas reset at their next use
+    static void NextFrame();
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        size_t                  size = 0;
+    };
+
+    char* AllocateFromBlock(size_t blockIndex, size_t size, size_t alignment);
+
+private:
+    size_t             mBlockSize     = 0;
+    std::vector<Block> mBlocks;
+    size_t             mCurrentBlock  = 0;
+    size_t             mOffset        = 0;
+    size_t             mPeakUsedBytes = 0;
+    uint32_t           mScopeDepth    = 0;
+    uint64_t           mFrame         = 0;
+
+    static std::atomic<uint64_t> sFrame;
+};
+
+//! @class FrameArenaAllocator
+//!
+//! STL allocator that allocates from a FrameArena. deallocate() is a
+//! no-op, so reserve() containers before filling them: every time a
+//! container grows, the old storage stays used until the arena resets.
+//!
+template <typename T>
+class FrameArenaAllocator
+{
+public:
+    using value_type = T;
+
+    FrameArenaAllocator(FrameArena* pArena) noexcept
+        : mArena(pArena) {}
+
+    template <typename U>
+    FrameArenaAllocator(const FrameArenaAllocator<U>& other) noexcept
+        : mArena(other.GetArena()) {}
+
+    T*   allocate(size_t count) { return mArena->AllocateArray<T>(count); }
+    void deallocate(T*, size_t) noexcept {}
+
+    FrameArena* GetArena() const { return mArena; }
+
+    template <typename U>
+    bool operator==(const FrameArenaAllocator<U>& rhs) const { return mArena == rhs.GetArena(); }
+    template <typename U>
+    bool operator!=(const FrameArenaAllocator<U>& rhs) const { return mArena != rhs.GetArena(); }
+
+private:
+    FrameArena* mArena = nullptr;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameArenaAllocator<T>>;
+
+//! @class FrameArena::Scope
+//!
+//! Rewinds the arena to where it was when the scope was created. Thread
+//! arenas aren't reset by NextFrame() while a scope is open.
+//!
+class FrameArena::Scope
+{
+public:
+    Scope(FrameArena& arena)
+        : mArena(arena), mMarker(arena.GetMarker())
+    {
+        ++mArena.mScopeDepth;
+    }
+
+    ~Scope()
+    {
+        mArena.Rewind(mMarker);
+        --mArena.mScopeDepth;
+    }
+
+    Scope(const Scope&)            = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    FrameArena& GetArena() const { return mArena; }
+
+    template <typename T>
+    FrameArenaAllocator<T> GetAllocator() const
+    {
+        return FrameArenaAllocator<T>(&mArena);
+    }
+
+private:
+    FrameArena&        mArena;
+    FrameArena::Marker mMarker;
+};
+
+} // namespace ppx
+
+#endif // ppx_frame_arena_h
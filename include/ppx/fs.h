@@ -35,6 +35,10 @@
 #include <vector>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 #if defined(PPX_ANDROID)
 #include <android_native_app_glue.h>
@@ -60,6 +64,8 @@ class File
         STREAM_HANDLE = 1,
         // The file is accessible through an Android asset handle.
         ASSET_HANDLE = 2,
+        // The file is mapped by OpenMapped().
+        MAPPED_HANDLE = 3,
     };
 
 public:
@@ -79,6 +85,12 @@ public:
     // - This class supports RAII. File will be closed on destroy.
     bool Open(const std::filesystem::path& path);
 
+    // Opens a file like `File::Open()` and maps regular files in memory on
+    // desktop too, so the content can be used in place through
+    // `File::GetMappedData()`. Pages are read on first access.
+    // Falls back to `File::Open()` if the file can't be mapped, e.g. it's empty.
+    bool OpenMapped(const std::filesystem::path& path);
+
     // Reads `size` bytes from the file into `buffer`.
     // buffer: a pointer to a buffer with at least `count` writable bytes.
     // count: the maximum number of bytes to write to `buffer`.
@@ -127,6 +139,84 @@ private:
 //  - android: relative paths are assumed to be in APK's storage (Asset API). Absolute are loaded from disk.
 std::optional<std::vector<char>> load_file(const std::filesystem::path& path);
 
+// Handle to a load started with load_file_async().
+class AsyncLoad
+{
+public:
+    AsyncLoad() = default;
+
+    // Returns true if the handle refers to a load Wait() hasn't returned yet.
+    bool IsValid() const;
+    // Returns true once the load completed, Wait() won't block.
+    bool IsReady() const;
+    // Blocks until the load completes and returns what load_file() would have.
+    // Invalidates the handle.
+    std::optional<std::vector<char>> Wait();
+
+private:
+    friend AsyncLoad load_file_async(const std::filesystem::path& path);
+
+    std::future<std::optional<std::vector<char>>> mFuture;
+};
+
+// Starts loading a file the way load_file() does and returns right away.
+// Loads run on a few I/O threads shared by the process, so reading several
+// files at once overlaps their disk access with each other and with the
+// caller's work, e.g. decoding files that already arrived with
+// Bitmap::LoadFromMemory().
+AsyncLoad load_file_async(const std::filesystem::path& path);
+
+// Read-only archive of assets written by tools/pack_assets.py, so loading
+// many small files like shaders costs a single open. Entries are named by
+// their path relative to the directory the pack was built from, with '/'
+// separators, and are indexed once in Open().
+//
+// Layout, little endian:
+//  - header: char magic[8] = "PPXPACK", uint32_t version, uint32_t entryCount.
+//  - entries: entryCount x {uint32_t nameOffset, uint32_t nameSize, uint64_t dataOffset, uint64_t dataSize}.
+//  - names: entry names without terminators, nameOffset is relative to the start of the names.
+//  - data: entry contents, dataOffset is relative to the start of the file and 16 byte aligned.
+//
+// The pack is opened with File::OpenMapped(), so entries are used in place
+// unless the pack can't be mapped, then it's read in full by Open().
+class AssetPack
+{
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    AssetPack()                            = default;
+    AssetPack(const AssetPack&)            = delete;
+    AssetPack& operator=(const AssetPack&) = delete;
+
+    // Opens the pack at `path`, handled like File::Open().
+    // Returns false if the file can't be read or isn't a valid pack.
+    bool Open(const std::filesystem::path& path);
+
+    // Returns the number of entries of the opened pack.
+    size_t GetEntryCount() const { return mEntries.size(); }
+
+    // Returns a pointer to the content of entry `name` and writes its size
+    // to `pSize`, or returns nullptr if the pack has no such entry. The
+    // content stays valid for the lifetime of the pack.
+    const void* Find(const std::string& name, size_t* pSize) const;
+
+    // Returns a copy of the content of entry `name` if the pack has it.
+    std::optional<std::vector<char>> Load(const std::string& name) const;
+
+private:
+    struct Entry
+    {
+        uint64_t offset = 0;
+        uint64_t size   = 0;
+    };
+
+    std::unique_ptr<File>                  mFile; // If mapped
+    std::vector<char>                      mStorage;
+    const char*                            mData = nullptr;
+    size_t                                 mSize = 0;
+    std::unordered_map<std::string, Entry> mEntries;
+};
+
 // Returns true if a given path exists (file or directory).
 // `path`: the path to check.
 // The path is handled differently depending on the platform:
@@ -34,7 +34,8 @@ enum GeometryVertexAttributeLayout
 //! @struct GeometryCreateInfo
 //!
 //! primitiveTopology
-//!   - only TRIANGLE_LIST is currently supported
+//!   - only TRIANGLE_LIST is currently supported, Geometry::ConvertToTriangleStrips()
+//!     changes it to TRIANGLE_STRIP afterwards
 //!
 //! indexType
 //!   - use UNDEFINED to indicate there's not index data
@@ -208,6 +209,15 @@ public:
 private:
     Result InternalCtor();
 
+    // Writes count vertices of mesh, gathered through pIndices if it isn't
+    // NULL, one attribute stream at a time. Returns false without writing
+    // anything if an attribute's format doesn't match the mesh data.
+    bool AppendVertexStreams(const TriMesh& mesh, const uint32_t* pIndices, uint32_t count);
+    // Appends UINT32 indices converted to the index type
+    void AppendIndices(uint32_t count, const uint32_t* pIndices);
+    // Returns UINT8, UINT16 or UINT32 indices as UINT32
+    std::vector<uint32_t> GetIndicesU32() const;
+
 public:
     // Create object using parameters from createInfo
     static Result Create(const GeometryCreateInfo& createInfo, Geometry* pGeometry);
@@ -229,10 +239,27 @@ public:
     static Result Create(const WireMesh& mesh, Geometry* pGeometry);
 
     grfx::IndexType         GetIndexType() const { return mCreateInfo.indexType; }
+    grfx::PrimitiveTopology GetPrimitiveTopology() const { return mCreateInfo.primitiveTopology; }
     const Geometry::Buffer* GetIndexBuffer() const { return &mIndexBuffer; }
     void                    SetIndexBuffer(const Geometry::Buffer& newIndexBuffer);
     uint32_t                GetIndexCount() const;
 
+    // Index buffer rewrites, call once the geometry is complete
+    //
+    // CompactIndices() converts UINT32 indices to UINT16 if every index is
+    // below 0xFFFF, which stays free for primitive restart.
+    //
+    // ConvertToTriangleStrips() rewrites UINT16 or UINT32 triangle list
+    // indices as triangle strips separated by the primitive restart index,
+    // 0xFFFF or 0xFFFFFFFF, and changes the topology to TRIANGLE_STRIP.
+    // Pipelines drawing it need primitiveRestartEnable. Nothing changes if
+    // the strips wouldn't have fewer indices.
+    //
+    // Both return true if the index buffer changed.
+    //
+    bool CompactIndices();
+    bool ConvertToTriangleStrips();
+
     GeometryVertexAttributeLayout GetVertexAttributeLayout() const { return mCreateInfo.vertexAttributeLayout; }
     uint32_t                      GetVertexBindingCount() const { return mCreateInfo.vertexBindingCount; }
     const grfx::VertexBinding*    GetVertexBinding(uint32_t index) const;
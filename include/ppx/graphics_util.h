@@ -15,17 +15,26 @@
 #ifndef ppx_graphics_util_h
 #define ppx_graphics_util_h
 
+#include "ppx/grfx/grfx_block_compressor.h"
+#include "ppx/grfx/grfx_ibl_generator.h"
 #include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_image_filter.h"
+#include "ppx/grfx/grfx_mesh_generator.h"
+#include "ppx/grfx/grfx_mesh_layout_converter.h"
+#include "ppx/grfx/grfx_mip_generator.h"
+#include "ppx/grfx/grfx_parallel_primitives.h"
 #include "ppx/grfx/grfx_queue.h"
 #include "ppx/grfx/grfx_texture.h"
 #include "ppx/bitmap.h"
 #include "ppx/geometry.h"
+#include "ppx/ktx2.h"
 #include "ppx/mipmap.h"
 #include "gli/gli.hpp"
 
 #include <array>
 #include <filesystem>
 #include <type_traits>
+#include <vector>
 
 namespace ppx {
 namespace grfx_util {
@@ -51,12 +60,31 @@ private:
         grfx::Image**       ppImage,
         const ImageOptions& options);
 
+    friend Result CreateImageFromMipLevels(
+        grfx::Queue*        pQueue,
+        uint32_t            mipLevelCount,
+        const Bitmap*       pMips,
+        grfx::Image**       ppImage,
+        const ImageOptions& options);
+
+    friend Result CreateImageArrayFromMipmaps(
+        grfx::Queue*                      pQueue,
+        const std::vector<const Mipmap*>& layers,
+        grfx::Image**                     ppImage,
+        const ImageOptions&               options);
+
     friend Result CreateImageFromCompressedImage(
         grfx::Queue*        pQueue,
         const gli::texture& image,
         grfx::Image**       ppImage,
         const ImageOptions& options);
 
+    friend Result CreateImageFromKtx2(
+        grfx::Queue*        pQueue,
+        const Ktx2&         image,
+        grfx::Image**       ppImage,
+        const ImageOptions& options);
+
     friend Result CreateImageFromFile(
         grfx::Queue*                 pQueue,
         const std::filesystem::path& path,
@@ -83,6 +111,26 @@ Result CopyBitmapToImage(
     grfx::ResourceState stateBefore,
     grfx::ResourceState stateAfter);
 
+//! @fn CopyBufferAcrossDevices
+//!
+//! Copies size bytes between buffers of different devices, e.g. from a
+//! compute device on a second GPU to the rendering device. Devices can't
+//! share memory, so the data goes through host visible staging buffers on
+//! both devices and the CPU waits for both copies. pSrcBuffer needs
+//! transferSrc usage and stays in srcState, pDstBuffer needs transferDst
+//! usage and stays in dstState.
+//!
+Result CopyBufferAcrossDevices(
+    grfx::Queue*        pSrcQueue,
+    grfx::Buffer*       pSrcBuffer,
+    uint64_t            srcOffset,
+    grfx::ResourceState srcState,
+    grfx::Queue*        pDstQueue,
+    grfx::Buffer*       pDstBuffer,
+    uint64_t            dstOffset,
+    grfx::ResourceState dstState,
+    uint64_t            size);
+
 //! @fn CreateImageFromBitmap
 //!
 //!
@@ -92,6 +140,60 @@ Result CreateImageFromBitmap(
     grfx::Image**       ppImage,
     const ImageOptions& options = ImageOptions());
 
+//! @fn CreateImageFromMipLevels
+//!
+//! Creates an image with a mip level for each of the mipLevelCount bitmaps
+//! in pMips, pMips[0] is the base level. The smaller levels aren't checked
+//! against the base level. The options' mip level count is ignored.
+//!
+Result CreateImageFromMipLevels(
+    grfx::Queue*        pQueue,
+    uint32_t            mipLevelCount,
+    const Bitmap*       pMips,
+    grfx::Image**       ppImage,
+    const ImageOptions& options = ImageOptions());
+
+//! @fn CreateImageArrayFromMipmaps
+//!
+//! Creates a 2D array image with a layer for each mipmap in layers. The
+//! mipmaps must have the same size, format and level count. The options'
+//! mip level count is ignored.
+//!
+Result CreateImageArrayFromMipmaps(
+    grfx::Queue*                      pQueue,
+    const std::vector<const Mipmap*>& layers,
+    grfx::Image**                     ppImage,
+    const ImageOptions&               options = ImageOptions());
+
+//! @fn CreateImageFromKtx2
+//!
+//! Uploads the levels of a KTX2 texture as they are. Returns
+//! ERROR_REQUIRED_FEATURE_UNAVAILABLE if the device can't sample the
+//! texture's format, see grfx::Device::SampledImageFormatSupported().
+//!
+Result CreateImageFromKtx2(
+    grfx::Queue*        pQueue,
+    const Ktx2&         image,
+    grfx::Image**       ppImage,
+    const ImageOptions& options = ImageOptions());
+
+//! @fn CompressImage
+//!
+//! Creates a block compressed copy of pSrcImage in format, with the same
+//! mip levels and array layers, for images generated at runtime. pSrcImage
+//! must be in srcState and can be destroyed once this returns. Blocks until
+//! the copy completed and resets pCompressor. Returns
+//! ERROR_REQUIRED_FEATURE_UNAVAILABLE if the device can't sample format,
+//! see grfx::BlockCompressor for the supported formats.
+//!
+Result CompressImage(
+    grfx::Queue*           pQueue,
+    grfx::BlockCompressor* pCompressor,
+    grfx::Image*           pSrcImage,
+    grfx::ResourceState    srcState,
+    grfx::Format           format,
+    grfx::Image**          ppImage);
+
 //! @fn CreateImageFromFile
 //!
 //!
@@ -242,6 +344,39 @@ Result CreateIBLTexturesFromFile(
     grfx::Texture**              ppIrradianceTexture,
     grfx::Texture**              ppEnvironmentTexture);
 
+// Sizes and quality of the textures CreateIBLTexturesFromHDR() generates
+struct IBLTextureOptions
+{
+    uint32_t                 irradianceWidth       = 128;  // Height is half the width
+    uint32_t                 environmentWidth      = 1024; // Height is half the width, capped to the source's width
+    uint32_t                 environmentLevelCount = 0;    // 0 stops at the level that is 4 texels high
+    uint32_t                 brdfLUTSize           = 256;
+    grfx::IBLGeneratorParams generatorParams       = {};
+};
+
+// Creates an irradiance and an environment texture from an equirectangular
+// HDR image with pGenerator instead of loading a pre-baked *.ibl file. If
+// cacheDirectory isn't empty the textures are saved there, keyed by a hash
+// of the image file and the options, and later calls load them from there
+// instead of generating them again.
+Result CreateIBLTexturesFromHDR(
+    grfx::Queue*                 pQueue,
+    grfx::IBLGenerator*          pGenerator,
+    const std::filesystem::path& path,
+    const std::filesystem::path& cacheDirectory,
+    grfx::Texture**              ppIrradianceTexture,
+    grfx::Texture**              ppEnvironmentTexture,
+    const IBLTextureOptions&     options = IBLTextureOptions());
+
+// Creates the split sum BRDF LUT PBR.hlsli reads with pGenerator, cached
+// like CreateIBLTexturesFromHDR()
+Result CreateBRDFLUTTexture(
+    grfx::Queue*                 pQueue,
+    grfx::IBLGenerator*          pGenerator,
+    const std::filesystem::path& cacheDirectory,
+    grfx::Texture**              ppLUTTexture,
+    const IBLTextureOptions&     options = IBLTextureOptions());
+
 // -------------------------------------------------------------------------------------------------
 
 // clang-format off
@@ -384,13 +519,14 @@ enum CubeFaceOp
 //!
 struct CubeMapCreateInfo
 {
-    CubeImageLayout layout = CUBE_IMAGE_LAYOUT_UNDEFINED;
-    uint32_t        posX   = PPX_VALUE_IGNORED;
-    uint32_t        negX   = PPX_VALUE_IGNORED;
-    uint32_t        posY   = PPX_VALUE_IGNORED;
-    uint32_t        negY   = PPX_VALUE_IGNORED;
-    uint32_t        posZ   = PPX_VALUE_IGNORED;
-    uint32_t        negZ   = PPX_VALUE_IGNORED;
+    CubeImageLayout     layout = CUBE_IMAGE_LAYOUT_UNDEFINED;
+    uint32_t            posX   = PPX_VALUE_IGNORED;
+    uint32_t            negX   = PPX_VALUE_IGNORED;
+    uint32_t            posY   = PPX_VALUE_IGNORED;
+    uint32_t            negY   = PPX_VALUE_IGNORED;
+    uint32_t            posZ   = PPX_VALUE_IGNORED;
+    uint32_t            negZ   = PPX_VALUE_IGNORED;
+    grfx::MipGenerator* pMipGenerator = nullptr; // Generates a full mip chain in the upload's command buffer if set, and is Reset() once the upload completed
 };
 
 //! @fn CreateCubeMapFromFile
@@ -407,19 +543,73 @@ Result CreateCubeMapFromFile(
 
 //! @fn CreateMeshFromGeometry
 //!
+//! If pBufferPool is set the mesh's buffers are sub-allocated from it,
+//! see grfx::MeshCreateInfo::pBufferPool. accelerationStructureInput
+//! lets the mesh be used for bottom level acceleration structure builds.
+//! storageBuffers lets compute shaders access the mesh's buffers, e.g. to
+//! convert it with grfx::MeshLayoutConverter.
 //!
 Result CreateMeshFromGeometry(
-    grfx::Queue*    pQueue,
-    const Geometry* pGeometry,
-    grfx::Mesh**    ppMesh);
+    grfx::Queue*      pQueue,
+    const Geometry*   pGeometry,
+    grfx::Mesh**      ppMesh,
+    grfx::BufferPool* pBufferPool                = nullptr,
+    bool              accelerationStructureInput = false,
+    bool              storageBuffers             = false);
+
+//! @struct MeshIndexOptions
+//!
+//! How CreateMeshFromTriMesh() writes index data:
+//!   - compact:        UINT16 indices if the vertex count allows, see
+//!                     Geometry::CompactIndices(). Skipped for pooled meshes
+//!                     so the pool's meshes keep one index type.
+//!   - triangleStrips: triangle strips with primitive restart, see
+//!                     Geometry::ConvertToTriangleStrips(). Skipped for
+//!                     meshes with LODs and acceleration structure inputs.
+//!                     Check grfx::Mesh::GetPrimitiveTopology() when
+//!                     creating pipelines for the mesh.
+//!
+struct MeshIndexOptions
+{
+    bool compact        = true;
+    bool triangleStrips = false;
+};
 
 //! @fn CreateMeshFromTriMesh
 //!
 //!
 Result CreateMeshFromTriMesh(
-    grfx::Queue*   pQueue,
-    const TriMesh* pTriMesh,
-    grfx::Mesh**   ppMesh);
+    grfx::Queue*            pQueue,
+    const TriMesh*          pTriMesh,
+    grfx::Mesh**            ppMesh,
+    grfx::BufferPool*       pBufferPool                = nullptr,
+    bool                    accelerationStructureInput = false,
+    const MeshIndexOptions& indexOptions               = MeshIndexOptions());
+
+//! @fn GenerateMesh
+//!
+//! Generates the mesh described by info on the GPU, see
+//! grfx::MeshGenerator. Blocks until the work completed and resets
+//! pGenerator.
+//!
+Result GenerateMesh(
+    grfx::Queue*                   pQueue,
+    grfx::MeshGenerator*           pGenerator,
+    const grfx::GeneratedMeshInfo& info,
+    grfx::Mesh**                   ppMesh);
+
+//! @fn ConvertMeshLayout
+//!
+//! Creates a mesh with pSrcMesh's vertices in the layout of info on the
+//! GPU, see grfx::MeshLayoutConverter. Blocks until the work completed and
+//! resets pConverter.
+//!
+Result ConvertMeshLayout(
+    grfx::Queue*                pQueue,
+    grfx::MeshLayoutConverter*  pConverter,
+    const grfx::Mesh*           pSrcMesh,
+    const grfx::MeshLayoutInfo& info,
+    grfx::Mesh**                ppMesh);
 
 //! @fn CreateMeshFromWireMesh
 //!
@@ -31,8 +31,9 @@ public:
 
     typename D3D12ResourcePtr::InterfaceType* GetDxResource() const { return mResource.Get(); }
 
-    virtual Result MapMemory(uint64_t offset, void** ppMappedAddress) override;
-    virtual void   UnmapMemory() override;
+    virtual Result   MapMemory(uint64_t offset, void** ppMappedAddress) override;
+    virtual void     UnmapMemory() override;
+    virtual uint64_t GetDeviceAddress() const override { return static_cast<uint64_t>(mResource->GetGPUVirtualAddress()); }
 
 protected:
     virtual Result CreateApiObjects(const grfx::BufferCreateInfo* pCreateInfo) override;
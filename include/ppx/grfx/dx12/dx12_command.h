@@ -16,6 +16,7 @@
 #define ppx_grfx_dx12_command_buffer_h
 
 #include "ppx/grfx/dx12/dx12_config.h"
+#include "ppx/grfx/dx12/dx12_descriptor_helper.h"
 #include "ppx/grfx/grfx_command.h"
 
 namespace ppx {
@@ -31,10 +32,28 @@ public:
 
     typename D3D12GraphicsCommandListPtr::InterfaceType* GetDxCommandList() const { return mCommandList.Get(); }
 
+    // Called by dx12::Queue::Submit(), the descriptor ring chunks of this
+    // recording are retired against the last submission.
+    void SetSubmitFence(ID3D12Fence* pFence, UINT64 value) const;
+
     virtual Result Begin() override;
     virtual Result End() override;
 
 private:
+    virtual Result BeginSecondaryImpl(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo) override;
+
+    virtual void ExecuteCommandsImpl(
+        uint32_t                          commandBufferCount,
+        const grfx::CommandBuffer* const* ppCommandBuffers) override;
+
+    virtual void ResourceBarriersImpl(
+        uint32_t             imageBarrierCount,
+        const ImageBarrier*  pImageBarriers,
+        uint32_t             bufferBarrierCount,
+        const BufferBarrier* pBufferBarriers) override;
+
+    virtual void AliasingBarrierImpl(const grfx::Image* pBefore, grfx::Image* pAfter) override;
+
     virtual void BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo) override;
     virtual void EndRenderPassImpl() override;
 
@@ -88,6 +107,14 @@ public:
         uint32_t          scissorCount,
         const grfx::Rect* pScissors) override;
 
+    virtual void SetCullMode(grfx::CullMode cullMode) override;
+    virtual void SetPrimitiveTopology(grfx::PrimitiveTopology topology) override;
+    virtual void SetDepthTestEnable(bool enable) override;
+    virtual void SetDepthWriteEnable(bool enable) override;
+    virtual void SetBlendEnable(
+        uint32_t    renderTargetCount,
+        const bool* pEnables) override;
+
     virtual void BindGraphicsDescriptorSets(
         const grfx::PipelineInterface*    pInterface,
         uint32_t                          setCount,
@@ -138,6 +165,57 @@ public:
         uint32_t groupCountY,
         uint32_t groupCountZ) override;
 
+    virtual void DrawMeshTasks(
+        uint32_t groupCountX,
+        uint32_t groupCountY,
+        uint32_t groupCountZ) override;
+
+    virtual void DrawIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawIndexedIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawIndexedIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawMeshTasksIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawMeshTasksIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride) override;
+
+    virtual void DispatchIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset) override;
+
     virtual void CopyBufferToBuffer(
         const grfx::BufferToBufferCopyInfo* pCopyInfo,
         grfx::Buffer*                       pSrcBuffer,
@@ -168,6 +246,11 @@ public:
         grfx::Image*               pSrcImage,
         grfx::Image*               pDstImage) override;
 
+    virtual void ResolveImage(
+        const grfx::ImageResolveInfo* pResolveInfo,
+        grfx::Image*                  pSrcImage,
+        grfx::Image*                  pDstImage) override;
+
     virtual void BeginQuery(
         const grfx::Query* pQuery,
         uint32_t           queryIndex) override;
@@ -186,6 +269,39 @@ public:
         uint32_t     startIndex,
         uint32_t     numQueries) override;
 
+    virtual void ResolveOcclusionPredicates(
+        const grfx::Query* pQuery,
+        uint32_t           firstQuery,
+        uint32_t           queryCount,
+        grfx::Buffer*      pDstBuffer,
+        uint64_t           dstOffset) override;
+
+    virtual void BeginConditionalRendering(
+        const grfx::Buffer* pBuffer,
+        uint64_t            offset) override;
+
+    virtual void EndConditionalRendering() override;
+
+    virtual void BuildAccelerationStructures(
+        uint32_t                                    count,
+        const grfx::AccelerationStructureBuildInfo* pInfos) override;
+
+    virtual void CopyAccelerationStructure(
+        const grfx::AccelerationStructure* pSrc,
+        grfx::AccelerationStructure*       pDst,
+        bool                               compact) override;
+
+    virtual void WriteAccelerationStructureCompactedSizes(
+        uint32_t                                  count,
+        const grfx::AccelerationStructure* const* ppAccelerationStructures,
+        grfx::Query*                              pQuery,
+        uint32_t                                  firstQuery) override;
+
+    virtual void AccelerationStructureBarrier() override;
+
+    virtual void BeginDebugLabel(const char* pLabel) override;
+    virtual void EndDebugLabel() override;
+
 protected:
     virtual Result CreateApiObjects(const grfx::internal::CommandBufferCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
@@ -201,15 +317,52 @@ private:
         size_t&                           rdtCountCBVSRVUAV,
         size_t&                           rdtCountSampler);
 
+    struct DescriptorStaging
+    {
+        dx12::DescriptorRingAllocator* pRing       = nullptr;
+        UINT                           chunkSize   = 0;
+        UINT                           chunkOffset = 0;
+        UINT                           chunkCount  = 0;
+        UINT                           chunkUsed   = 0;
+        std::vector<UINT>              chunks; // Offsets of this recording's chunks
+    };
+
+    // Reserves count contiguous descriptors in the current chunk, takes a
+    // new chunk from the ring if they don't fit.
+    Result StageDescriptors(DescriptorStaging& staging, UINT count, UINT* pOffset);
+    void   RetireDescriptors(DescriptorStaging& staging);
+
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    // Transitions with ID3D12GraphicsCommandList7::Barrier(), sync scopes
+    // and accesses are limited to what the before and after states need.
+    void EnhancedBarriers(
+        uint32_t             imageBarrierCount,
+        const ImageBarrier*  pImageBarriers,
+        uint32_t             bufferBarrierCount,
+        const BufferBarrier* pBufferBarriers);
+#endif
+
+    // pCountBuffer is optional, maxCommandCount is used as is without it
+    void ExecuteIndirect(
+        D3D12_INDIRECT_ARGUMENT_TYPE type,
+        const grfx::Buffer*          pArgBuffer,
+        uint64_t                     argOffset,
+        const grfx::Buffer*          pCountBuffer,
+        uint64_t                     countOffset,
+        uint32_t                     maxCommandCount,
+        uint32_t                     stride);
+
 private:
     D3D12GraphicsCommandListPtr    mCommandList;
+    D3D12GraphicsCommandList6Ptr   mCommandList6; // Only set if mesh shaders are supported
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    D3D12GraphicsCommandList7Ptr   mCommandList7; // Only set if enhanced barriers are supported
+#endif
     D3D12CommandAllocatorPtr       mCommandAllocator;
-    UINT                           mHeapSizeCBVSRVUAV = 0;
-    UINT                           mHeapSizeSampler   = 0;
-    D3D12DescriptorHeapPtr         mHeapCBVSRVUAV;
-    D3D12DescriptorHeapPtr         mHeapSampler;
-    UINT                           mHeapOffsetCBVSRVUAV      = 0;
-    UINT                           mHeapOffsetSampler        = 0;
+    DescriptorStaging              mStagingCBVSRVUAV;
+    DescriptorStaging              mStagingSampler;
+    mutable CComPtr<ID3D12Fence>   mSubmitFence;
+    mutable UINT64                 mSubmitFenceValue         = 0;
     const grfx::PipelineInterface* mCurrentGraphicsInterface = nullptr;
     const grfx::PipelineInterface* mCurrentComputeInterface  = nullptr;
 
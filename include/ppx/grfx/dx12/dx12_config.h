@@ -43,25 +43,32 @@ namespace ppx {
 namespace grfx {
 namespace dx12 {
 
-using DXGIAdapterPtr              = CComPtr<IDXGIAdapter4>;
-using DXGIFactoryPtr              = CComPtr<IDXGIFactory7>;
-using DXGIDebugPtr                = CComPtr<IDXGIDebug1>;
-using DXGIInfoQueuePtr            = CComPtr<IDXGIInfoQueue>;
-using DXGISwapChainPtr            = CComPtr<IDXGISwapChain4>;
-using D3D12CommandAllocatorPtr    = CComPtr<ID3D12CommandAllocator>;
-using D3D12CommandQueuePtr        = CComPtr<ID3D12CommandQueue>;
-using D3D12DebugPtr               = CComPtr<ID3D12Debug>;
-using D3D12DescriptorHeapPtr      = CComPtr<ID3D12DescriptorHeap>;
-using D3D12DevicePtr              = CComPtr<ID3D12Device5>;
-using D3D12FencePtr               = CComPtr<ID3D12Fence1>;
-using D3D12GraphicsCommandListPtr = CComPtr<ID3D12GraphicsCommandList4>;
-using D3D12PipelineStatePtr       = CComPtr<ID3D12PipelineState>;
-using D3D12QueryHeapPtr           = CComPtr<ID3D12QueryHeap>;
-using D3D12ResourcePtr            = CComPtr<ID3D12Resource1>;
-using D3D12RootSignaturePtr       = CComPtr<ID3D12RootSignature>;
+using DXGIAdapterPtr               = CComPtr<IDXGIAdapter4>;
+using DXGIFactoryPtr               = CComPtr<IDXGIFactory7>;
+using DXGIDebugPtr                 = CComPtr<IDXGIDebug1>;
+using DXGIInfoQueuePtr             = CComPtr<IDXGIInfoQueue>;
+using DXGISwapChainPtr             = CComPtr<IDXGISwapChain4>;
+using D3D12CommandAllocatorPtr     = CComPtr<ID3D12CommandAllocator>;
+using D3D12CommandSignaturePtr     = CComPtr<ID3D12CommandSignature>;
+using D3D12CommandQueuePtr         = CComPtr<ID3D12CommandQueue>;
+using D3D12DebugPtr                = CComPtr<ID3D12Debug>;
+using D3D12DescriptorHeapPtr       = CComPtr<ID3D12DescriptorHeap>;
+using D3D12DevicePtr               = CComPtr<ID3D12Device5>;
+using D3D12FencePtr                = CComPtr<ID3D12Fence1>;
+using D3D12GraphicsCommandListPtr  = CComPtr<ID3D12GraphicsCommandList4>;
+using D3D12GraphicsCommandList6Ptr = CComPtr<ID3D12GraphicsCommandList6>;
+using D3D12PipelineLibraryPtr      = CComPtr<ID3D12PipelineLibrary>;
+using D3D12PipelineStatePtr        = CComPtr<ID3D12PipelineState>;
+using D3D12QueryHeapPtr            = CComPtr<ID3D12QueryHeap>;
+using D3D12ResourcePtr             = CComPtr<ID3D12Resource1>;
+using D3D12RootSignaturePtr        = CComPtr<ID3D12RootSignature>;
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+using D3D12GraphicsCommandList7Ptr = CComPtr<ID3D12GraphicsCommandList7>;
+#endif
 
 // -------------------------------------------------------------------------------------------------
 
+class AccelerationStructure;
 class Buffer;
 class CommandBuffer;
 class CommandPool;
@@ -95,6 +102,13 @@ struct ApiObjectLookUp
 {
 };
 
+template <>
+struct ApiObjectLookUp<grfx::AccelerationStructure>
+{
+    using GrfxType = grfx::AccelerationStructure;
+    using ApiType  = dx12::AccelerationStructure;
+};
+
 template <>
 struct ApiObjectLookUp<grfx::Buffer>
 {
@@ -26,6 +26,9 @@
 
 #include "ppx/grfx/dx12/dx12_config.h"
 
+#include <deque>
+#include <mutex>
+
 namespace ppx {
 namespace grfx {
 namespace dx12 {
@@ -38,6 +41,13 @@ class Device;
 const UINT   MAX_DESCRIPTOR_HANDLE_HEAP_SIZE = 256;
 const SIZE_T INVALID_D3D12_DESCRIPTOR_HANDLE = static_cast<SIZE_T>(~0);
 
+// Shader visible descriptor rings, sampler heaps can't be larger than
+// PPX_MAX_SAMPLER_DESCRIPTORS.
+const UINT DESCRIPTOR_RING_SIZE_CBVSRVUAV       = 131072;
+const UINT DESCRIPTOR_RING_SIZE_SAMPLER         = PPX_MAX_SAMPLER_DESCRIPTORS;
+const UINT DESCRIPTOR_RING_CHUNK_SIZE_CBVSRVUAV = 1024;
+const UINT DESCRIPTOR_RING_CHUNK_SIZE_SAMPLER   = 64;
+
 struct DescriptorHandle
 {
     UINT                        offset = UINT_MAX;
@@ -110,6 +120,59 @@ private:
     std::vector<DescriptorHandleAllocator*> mAllocators;
 };
 
+//! @class DescriptorRingAllocator
+//!
+//! Linear ring over a shader visible heap shared by all command buffers of
+//! a device. Command buffers take chunks of the ring and stage descriptor
+//! tables inside them without locking. A chunk is retired with the fence
+//! value of the last submission that used it and is reused once the GPU
+//! has passed that value. Chunks are reclaimed in allocation order.
+//!
+class DescriptorRingAllocator
+{
+public:
+    DescriptorRingAllocator();
+    ~DescriptorRingAllocator();
+
+    Result Create(dx12::Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT size);
+    void   Destroy();
+
+    typename D3D12DescriptorHeapPtr::InterfaceType* GetDxHeap() const { return mHeap.Get(); }
+    UINT                                            GetSize() const { return mSize; }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(UINT offset) const;
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(UINT offset) const;
+
+    //! Returns ERROR_OUT_OF_MEMORY if the GPU hasn't released enough of
+    //! the ring yet.
+    Result AllocateChunk(UINT count, UINT* pOffset);
+
+    //! pFence is null for chunks that were never submitted.
+    void RetireChunk(UINT offset, ID3D12Fence* pFence, UINT64 fenceValue);
+
+private:
+    void ReclaimChunks();
+
+private:
+    struct Chunk
+    {
+        UINT                 offset     = 0;
+        UINT                 count      = 0;
+        bool                 retired    = false;
+        UINT64               fenceValue = 0;
+        CComPtr<ID3D12Fence> fence;
+    };
+
+    D3D12DescriptorHeapPtr      mHeap;
+    D3D12_CPU_DESCRIPTOR_HANDLE mCPUStart      = {};
+    D3D12_GPU_DESCRIPTOR_HANDLE mGPUStart      = {};
+    UINT                        mIncrementSize = 0;
+    UINT                        mSize          = 0;
+    UINT                        mHead          = 0;
+    std::deque<Chunk>           mChunks; // Oldest first
+    std::mutex                  mMutex;
+};
+
 } // namespace dx12
 } // namespace grfx
 } // namespace ppx
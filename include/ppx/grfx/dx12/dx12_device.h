@@ -19,6 +19,8 @@
 #include "ppx/grfx/dx12/dx12_descriptor_helper.h"
 #include "ppx/grfx/grfx_device.h"
 
+#include <unordered_map>
+
 namespace ppx {
 namespace grfx {
 namespace dx12 {
@@ -42,6 +44,10 @@ public:
     Result AllocateDSVHandle(dx12::DescriptorHandle* pHandle);
     void   FreeDSVHandle(const dx12::DescriptorHandle* pHandle);
 
+    // Shader visible heaps that command buffers stage descriptor tables in
+    dx12::DescriptorRingAllocator* GetDescriptorRingCBVSRVUAV() { return &mDescriptorRingCBVSRVUAV; }
+    dx12::DescriptorRingAllocator* GetDescriptorRingSampler() { return &mDescriptorRingSampler; }
+
     HRESULT CreateRootSignatureDeserializer(
         LPCVOID    pSrcData,
         SIZE_T     SrcDataSizeInBytes,
@@ -59,17 +65,67 @@ public:
         const IID& pRootSignatureDeserializerInterface,
         void**     ppRootSignatureDeserializer);
 
+    // Creates a pipeline state object through the device's pipeline library.
+    // Pipelines are looked up by a hash of their description and stored in
+    // the library on a miss, so a library loaded from disk skips compilation
+    // on later runs. Falls back to ID3D12Device::Create*PipelineState if no
+    // library is available.
+    //
+    HRESULT CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, D3D12PipelineStatePtr& pipelineState);
+    HRESULT CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, D3D12PipelineStatePtr& pipelineState);
+
+    // Pipeline state streams, e.g. mesh shader pipelines. These bypass the
+    // pipeline library.
+    //
+    HRESULT CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, D3D12PipelineStatePtr& pipelineState);
+
+    // Command signatures for ExecuteIndirect() with a single draw or
+    // dispatch argument. Created on first use for each argument type and
+    // stride, and kept for the lifetime of the device.
+    //
+    HRESULT GetCommandSignature(D3D12_INDIRECT_ARGUMENT_TYPE type, UINT stride, ID3D12CommandSignature** ppSignature);
+
+    // ID3D12GraphicsCommandList7::Barrier() is used for transitions if true
+    bool EnhancedBarriersSupported() const { return mEnhancedBarriers; }
+
     virtual Result WaitIdle() override;
 
     virtual bool PipelineStatsAvailable() const override;
     virtual bool DynamicRenderingSupported() const override;
     virtual bool IndependentBlendingSupported() const override;
     virtual bool FragmentStoresAndAtomicsSupported() const override;
+    virtual bool TessellationShaderSupported() const override;
+    virtual bool GeometryShaderSupported() const override;
     virtual bool PartialDescriptorBindingsSupported() const override;
+    virtual bool PushDescriptorsSupported() const override;
     virtual bool MultiViewSupported() const override;
     bool         IndexTypeUint8Supported() const override;
+    virtual bool DrawIndirectCountSupported() const override;
+    virtual bool MeshShaderSupported() const override;
+    virtual bool AmplificationShaderSupported() const override;
+    virtual bool AccelerationStructureSupported() const override;
+    virtual bool BufferDeviceAddressSupported() const override;
+    virtual bool RayQuerySupported() const override;
+    virtual bool TimelineSemaphoreSupported() const override;
+    virtual bool ExtendedDynamicStateSupported() const override;
+    virtual bool DynamicBlendEnableSupported() const override;
+    virtual bool ShaderObjectsSupported() const override;
+    virtual bool DescriptorBuffersEnabled() const override;
+    virtual bool ConditionalRenderingSupported() const override;
+    virtual bool ImageHostUploadSupported(grfx::ImageHostUpload hostUpload, grfx::Format format) const override;
+    virtual bool SampledImageFormatSupported(grfx::Format format) const override;
+    virtual bool RenderTargetSampleCountSupported(grfx::Format format, grfx::SampleCount sampleCount) const override;
+    virtual bool RenderTargetBlendSupported(grfx::Format format) const override;
+    virtual bool ImageCompressionSupported(grfx::Format format, grfx::ImageCompression compression) const override;
+    virtual bool SparseResidencySupported() const override;
+
+    virtual Result GetAccelerationStructureBuildSizes(const grfx::AccelerationStructureBuildInputs* pInputs, grfx::AccelerationStructureBuildSizes* pSizes) const override;
+    virtual Result GetMemoryStatistics(grfx::MemoryStatistics* pStatistics) const override;
+
+    virtual Result SavePipelineCache() override;
 
 protected:
+    virtual Result AllocateObject(grfx::AccelerationStructure** ppObject) override;
     virtual Result AllocateObject(grfx::Buffer** ppObject) override;
     virtual Result AllocateObject(grfx::CommandBuffer** ppObject) override;
     virtual Result AllocateObject(grfx::CommandPool** ppObject) override;
@@ -100,9 +156,13 @@ protected:
     virtual Result CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+    // Not implemented, D3D12 resources would need recreating placed
+    virtual Result DefragmentApiObjects(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats) override;
+
 private:
     void   LoadRootSignatureFunctions();
     Result CreateQueues(const grfx::DeviceCreateInfo* pCreateInfo);
+    Result CreatePipelineLibrary(const grfx::DeviceCreateInfo* pCreateInfo);
 
 private:
     D3D12DevicePtr             mDevice;
@@ -112,6 +172,8 @@ private:
     UINT                          mHandleIncrementSizeSampler   = 0;
     dx12::DescriptorHandleManager mRTVHandleManager;
     dx12::DescriptorHandleManager mDSVHandleManager;
+    dx12::DescriptorRingAllocator mDescriptorRingCBVSRVUAV;
+    dx12::DescriptorRingAllocator mDescriptorRingSampler;
 
     PFN_D3D12_CREATE_ROOT_SIGNATURE_DESERIALIZER           mFnD3D12CreateRootSignatureDeserializer          = nullptr;
     PFN_D3D12_SERIALIZE_VERSIONED_ROOT_SIGNATURE           mFnD3D12SerializeVersionedRootSignature          = nullptr;
@@ -121,7 +183,21 @@ private:
     uint32_t                     mQueryResolveThreadCount = 0;
     std::mutex                   mQueryResolveMutex;
 
-    D3D12_RENDER_PASS_TIER mRenderPassTier;
+    D3D12_RENDER_PASS_TIER     mRenderPassTier;
+    D3D12_MESH_SHADER_TIER     mMeshShaderTier     = D3D12_MESH_SHADER_TIER_NOT_SUPPORTED;
+    D3D12_RAYTRACING_TIER      mRaytracingTier     = D3D12_RAYTRACING_TIER_NOT_SUPPORTED;
+    D3D12_TILED_RESOURCES_TIER mTiledResourcesTier = D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+    bool                       mEnhancedBarriers   = false;
+
+    // The library references the blob it was created from, so the blob
+    // must outlive the library.
+    std::vector<char>       mPipelineLibraryData;
+    D3D12PipelineLibraryPtr mPipelineLibrary;
+    std::mutex              mPipelineLibraryMutex;
+
+    // Keyed by (argument type << 32) | stride
+    std::unordered_map<uint64_t, D3D12CommandSignaturePtr> mCommandSignatures;
+    std::mutex                                             mCommandSignatureMutex;
 };
 
 } // namespace dx12
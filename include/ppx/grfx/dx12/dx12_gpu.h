@@ -41,6 +41,9 @@ protected:
     virtual Result CreateApiObjects(const grfx::internal::GpuCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    void QueryShaderCapabilities();
+
 private:
     DXGIAdapterPtr mGpu;
 };
@@ -32,16 +32,40 @@ public:
 
     typename D3D12ResourcePtr::InterfaceType* GetDxResource() const { return mResource.Get(); }
 
+    // Null for external and aliased images
+    D3D12MA::Allocation* GetAllocation() const { return mAllocation.Get(); }
+
     virtual Result MapMemory(uint64_t offset, void** ppMappedAddress) override;
     virtual void   UnmapMemory() override;
 
+    virtual Result CopyFromHost(
+        uint32_t    mipLevel,
+        uint32_t    arrayLayer,
+        const void* pSrcData,
+        uint32_t    srcRowStride) override;
+
+    // Maps tile memory for the binds of pBindInfo on pQueue and gives the
+    // memory of its unbinds back to the image, used by dx12::Queue
+    Result UpdateSparseTileMappings(
+        ID3D12CommandQueue*              pQueue,
+        const grfx::SparseImageBindInfo* pBindInfo);
+
 protected:
     virtual Result CreateApiObjects(const grfx::ImageCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    // Reads the tile layout and maps the packed mips
+    Result InitializeSparseResidency(const grfx::ImageCreateInfo* pCreateInfo);
+
 private:
     D3D12ResourcePtr            mResource;
     ObjPtr<D3D12MA::Allocation> mAllocation;
+
+    // Sparse residency, tile memory is indexed by GetSparseTileIndex()
+    std::vector<D3D12MA::Allocation*> mSparseTileAllocations;
+    std::vector<D3D12MA::Allocation*> mFreeSparseTileAllocations;
+    std::vector<D3D12MA::Allocation*> mPackedMipAllocations;
 };
 
 // -------------------------------------------------------------------------------------------------
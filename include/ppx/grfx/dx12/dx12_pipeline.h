@@ -81,6 +81,12 @@ private:
         const grfx::GraphicsPipelineCreateInfo* pCreateInfo,
         D3D12_GRAPHICS_PIPELINE_STATE_DESC&     desc);
 
+    // Mesh shader pipelines can only be created from a pipeline state
+    // stream, desc supplies every state except the shaders.
+    HRESULT CreateMeshPipelineState(
+        const grfx::GraphicsPipelineCreateInfo*   pCreateInfo,
+        const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+
 private:
     D3D12PipelineStatePtr  mPipeline;
     D3D_PRIMITIVE_TOPOLOGY mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
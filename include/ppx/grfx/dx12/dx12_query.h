@@ -33,6 +33,10 @@ public:
     D3D12_QUERY_TYPE                           GetQueryType() const { return mQueryType; }
     typename D3D12ResourcePtr::InterfaceType*  GetReadBackBuffer() const;
 
+    // Acceleration structure compacted sizes are postbuild info written to
+    // a UAV buffer instead of a query heap. Null for other query types.
+    grfx::Buffer* GetPostbuildInfoBuffer() const { return mPostbuildInfoBuffer.Get(); }
+
     virtual void   Reset(uint32_t firstQuery, uint32_t queryCount) override;
     virtual Result GetData(void* pDstData, uint64_t dstDataSize) override;
 
@@ -45,6 +49,7 @@ private:
     D3D12QueryHeapPtr mHeap;
     D3D12_QUERY_TYPE  mQueryType;
     grfx::BufferPtr   mBuffer;
+    grfx::BufferPtr   mPostbuildInfoBuffer;
 };
 
 } // namespace dx12
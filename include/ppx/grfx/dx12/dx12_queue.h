@@ -34,20 +34,34 @@ public:
     virtual Result WaitIdle() override;
 
     virtual Result Submit(const grfx::SubmitInfo* pSubmitInfo) override;
+    virtual Result SubmitBatch(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos) override;
 
     virtual Result QueueWait(grfx::Semaphore* pSemaphore, uint64_t value) override;
     virtual Result QueueSignal(grfx::Semaphore* pSemaphore, uint64_t value) override;
 
     virtual Result GetTimestampFrequency(uint64_t* pFrequency) const override;
+    virtual Result GetTimestampOffset(const grfx::Queue* pOtherQueue, double* pSeconds) const override;
 
 protected:
     virtual Result CreateApiObjects(const grfx::internal::QueueCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
 private:
-    D3D12CommandQueuePtr            mCommandQueue;
-    grfx::FencePtr                  mWaitIdleFence;
-    std::vector<ID3D12CommandList*> mListBuffer;
+    virtual Result BindSparseImageTilesImpl(const grfx::SparseImageBindInfo* pBindInfo) override;
+
+    // Executes the command lists gathered by SubmitBatch() in one call
+    Result ExecutePendingLists();
+
+private:
+    D3D12CommandQueuePtr                    mCommandQueue;
+    grfx::FencePtr                          mWaitIdleFence;
+    std::vector<ID3D12CommandList*>         mListBuffer;
+    std::vector<const dx12::CommandBuffer*> mPendingCommandBuffers; // Parallel to mListBuffer
+
+    // Signaled after every submission, command buffers retire their
+    // descriptor ring chunks against it.
+    D3D12FencePtr mSubmitFence;
+    UINT64        mSubmitFenceValue = 0;
 };
 
 } // namespace dx12
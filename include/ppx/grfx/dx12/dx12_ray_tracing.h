@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_dx12_ray_tracing_h
+#define ppx_grfx_dx12_ray_tracing_h
+
+#include "ppx/grfx/dx12/dx12_config.h"
+#include "ppx/grfx/grfx_ray_tracing.h"
+
+namespace ppx {
+namespace grfx {
+namespace dx12 {
+
+//! @class AccelerationStructure
+//!
+//! D3D12 acceleration structures are plain buffer ranges, the structure is
+//! identified by the GPU virtual address of its buffer.
+//!
+class AccelerationStructure
+    : public grfx::AccelerationStructure
+{
+public:
+    AccelerationStructure() {}
+    virtual ~AccelerationStructure() {}
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGpuVirtualAddress() const { return mGpuVirtualAddress; }
+
+    virtual uint64_t GetDeviceAddress() const override { return static_cast<uint64_t>(mGpuVirtualAddress); }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::AccelerationStructureCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    D3D12_GPU_VIRTUAL_ADDRESS mGpuVirtualAddress = 0;
+};
+
+//! @struct AccelerationStructureBuildGeometry
+//!
+//! D3D12 build description of grfx::AccelerationStructureBuildInputs.
+//! Buffer addresses are 0 for buffers that are null, which is enough for
+//! prebuild info queries.
+//!
+struct AccelerationStructureBuildGeometry
+{
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC>          geometries;
+};
+
+Result ToD3D12AccelerationStructureBuildGeometry(const grfx::AccelerationStructureBuildInputs* pInputs, bool update, dx12::AccelerationStructureBuildGeometry* pGeometry);
+
+} // namespace dx12
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_dx12_ray_tracing_h
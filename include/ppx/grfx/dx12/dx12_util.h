@@ -21,10 +21,28 @@
 
 #include <d3d12.h>
 
+// Enhanced barriers need headers from the Agility SDK or Windows SDK 22621+
+#if defined(__ID3D12GraphicsCommandList7_INTERFACE_DEFINED__)
+#define PPX_D3D12_ENHANCED_BARRIERS
+#endif
+
 namespace ppx {
 namespace grfx {
 namespace dx12 {
 
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+//! Sync scope, access and layout of a resource in a grfx::ResourceState,
+//! for enhanced barriers. Buffers ignore the layout.
+struct D3D12BarrierState
+{
+    D3D12_BARRIER_SYNC   sync   = D3D12_BARRIER_SYNC_NONE;
+    D3D12_BARRIER_ACCESS access = D3D12_BARRIER_ACCESS_NO_ACCESS;
+    D3D12_BARRIER_LAYOUT layout = D3D12_BARRIER_LAYOUT_UNDEFINED;
+};
+
+D3D12BarrierState ToD3D12BarrierState(grfx::ResourceState value, grfx::CommandType commandType);
+#endif
+
 D3D12_BLEND                    ToD3D12Blend(grfx::BlendFactor value);
 D3D12_BLEND_OP                 ToD3D12BlendOp(grfx::BlendOp value);
 D3D12_COMPARISON_FUNC          ToD3D12ComparisonFunc(grfx::CompareOp value);
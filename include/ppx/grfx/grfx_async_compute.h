@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_async_compute_h
+#define ppx_grfx_async_compute_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_queue.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct AsyncComputeSchedulerCreateInfo
+//!
+//! \b pComputeQueue can be the same as \b pGraphicsQueue, in which case
+//! the scheduler only adds the semaphores and timestamps.
+//!
+struct AsyncComputeSchedulerCreateInfo
+{
+    grfx::Queue* pGraphicsQueue   = nullptr;
+    grfx::Queue* pComputeQueue    = nullptr;
+    uint32_t     frameCount       = 1;    // Usually the application's frames in flight
+    bool         enableTimestamps = true; // Records timestamps on both queues, see ReadTimings()
+};
+
+//! @struct AsyncComputeTimings
+//!
+//! GPU times of one frame in milliseconds. \b overlapMs is the time the
+//! frame's compute work ran at the same time as graphics work of the same
+//! or the previous frame.
+//!
+struct AsyncComputeTimings
+{
+    double computeMs  = 0;
+    double graphicsMs = 0;
+    double overlapMs  = 0;
+};
+
+//! @class AsyncComputeScheduler
+//!
+//! Schedules a per frame compute workload onto a compute queue next to the
+//! graphics queue that consumes its results:
+//!   - BeginCompute() / EndCompute() are recorded at the start and end of
+//!     the compute command buffer, SubmitCompute() submits it and signals
+//!     the frame's compute semaphore.
+//!   - BeginGraphics() / EndGraphics() are recorded around the graphics
+//!     work that uses the shared resources, SubmitGraphics() submits the
+//!     first graphics command buffer of the frame that reads them and waits
+//!     on the compute semaphore.
+//!
+//! Shared resources are registered per frame with the state they stay in
+//! between the two queues. If the queues are in different queue families
+//! Begin* and End* record the Vulkan queue ownership transfers for them.
+//! Ownership goes back to the compute queue at the end of graphics, so
+//! once a frame has run EndGraphics() the compute workload must run before
+//! graphics uses the frame's shared resources again. Acquires are skipped
+//! if the other queue hasn't released the resources yet, which covers the
+//! first use of each frame.
+//!
+//! Timestamps are written at Begin* and End* on each queue. They can be
+//! read with ReadTimings() once the frame has completed on the GPU. The
+//! overlap assumes both queues' timestamps share a time base, which holds
+//! for graphics and compute queues of the same device on current drivers.
+//!
+class AsyncComputeScheduler
+    : public grfx::DeviceObject<grfx::AsyncComputeSchedulerCreateInfo>
+{
+public:
+    AsyncComputeScheduler() {}
+    virtual ~AsyncComputeScheduler() {}
+
+    grfx::Queue* GetGraphicsQueue() const { return mCreateInfo.pGraphicsQueue; }
+    grfx::Queue* GetComputeQueue() const { return mCreateInfo.pComputeQueue; }
+    bool         IsAsync() const { return mCreateInfo.pComputeQueue != mCreateInfo.pGraphicsQueue; }
+    bool         IsOwnershipTransferred() const { return mTransferOwnership; }
+
+    Result AddSharedImage(uint32_t frameIndex, const grfx::Image* pImage, grfx::ResourceState state);
+    Result AddSharedBuffer(uint32_t frameIndex, const grfx::Buffer* pBuffer, grfx::ResourceState state);
+
+    void   BeginCompute(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer);
+    void   EndCompute(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer);
+    Result SubmitCompute(uint32_t frameIndex, const grfx::SubmitInfo* pSubmitInfo);
+
+    void   BeginGraphics(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer);
+    void   EndGraphics(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer);
+    Result SubmitGraphics(uint32_t frameIndex, const grfx::SubmitInfo* pSubmitInfo);
+
+    //! Semaphore signaled by the frame's SubmitCompute(), for applications
+    //! that submit the graphics work themselves.
+    grfx::Semaphore* GetComputeCompleteSemaphore(uint32_t frameIndex) const;
+
+    //! Reads the timestamps of \b frameIndex. The frame must have completed
+    //! on both queues. Returns ppx::ERROR_ELEMENT_NOT_FOUND if the frame
+    //! hasn't written timestamps on both queues since the last read.
+    Result ReadTimings(uint32_t frameIndex, grfx::AsyncComputeTimings* pTimings);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::AsyncComputeSchedulerCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct SharedResource
+    {
+        const grfx::Image*  pImage  = nullptr;
+        const grfx::Buffer* pBuffer = nullptr;
+        grfx::ResourceState state   = grfx::RESOURCE_STATE_UNDEFINED;
+    };
+
+    struct PerFrame
+    {
+        std::vector<SharedResource> sharedResources;
+        grfx::SemaphorePtr          computeCompleteSemaphore;
+        grfx::QueryPtr              computeTimestamps;
+        grfx::QueryPtr              graphicsTimestamps;
+        bool                        releasedToCompute  = false;
+        bool                        releasedToGraphics = false;
+        bool                        computeSubmitted   = false;
+        bool                        computeTimed       = false;
+        bool                        graphicsTimed      = false;
+    };
+
+    struct Interval
+    {
+        double begin = 0;
+        double end   = 0;
+    };
+
+    void RecordOwnershipTransfers(const PerFrame& frame, grfx::CommandBuffer* pCommandBuffer, const grfx::Queue* pSrcQueue, const grfx::Queue* pDstQueue) const;
+
+private:
+    std::vector<PerFrame> mPerFrame;
+    bool                  mTransferOwnership    = false;
+    uint64_t              mGraphicsFrequency    = 0;
+    uint64_t              mComputeFrequency     = 0;
+    Interval              mPrevGraphicsInterval = {};
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_async_compute_h
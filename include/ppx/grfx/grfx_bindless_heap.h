@@ -0,0 +1,114 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_grfx_bindless_heap_h
+#define ppx_grfx_bindless_heap_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_descriptor.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct BindlessHeapCreateInfo
+//!
+//!
+struct BindlessHeapCreateInfo
+{
+    uint32_t              textureCapacity  = 0;                      // Size of the sampled image array
+    uint32_t              samplerCapacity  = 0;                      // Size of the sampler array
+    uint32_t              textureBinding   = 0;                      // Binding/register of the sampled image array
+    uint32_t              samplerBinding   = 1;                      // Binding/register of the sampler array
+    grfx::ShaderStageBits shaderVisibility = grfx::SHADER_STAGE_ALL; //
+};
+
+//! @class BindlessHeap
+//!
+//! A single descriptor set holding large, partially bound arrays of
+//! sampled images and samplers that shaders index into directly. The
+//! arrays are created with update-after-bind so slots can be filled in
+//! while the set is bound, and bound once per command buffer instead of
+//! once per material.
+//!
+//! Slot writes are queued and sent to the set in one UpdateDescriptors
+//! call by Flush(). Flush() must be called before the set is bound: D3D12
+//! copies the set's descriptors into the command buffer's shader visible
+//! heap at bind time.
+//!
+//! Freed slots are reused by later allocations. The caller must make sure
+//! the GPU is no longer reading a slot before freeing it.
+//!
+class BindlessHeap
+    : public grfx::DeviceObject<grfx::BindlessHeapCreateInfo>
+{
+public:
+    static const uint32_t INVALID_INDEX = UINT32_MAX;
+
+    BindlessHeap() {}
+    virtual ~BindlessHeap() {}
+
+    grfx::DescriptorSetLayoutPtr GetDescriptorSetLayout() const { return mDescriptorSetLayout; }
+    grfx::DescriptorSetPtr       GetDescriptorSet() const { return mDescriptorSet; }
+
+    uint32_t GetTextureCount() const { return mTextureSlots.GetAllocatedCount(); }
+    uint32_t GetSamplerCount() const { return mSamplerSlots.GetAllocatedCount(); }
+
+    // Returns INVALID_INDEX if the heap is full
+    uint32_t AllocateTexture(const grfx::SampledImageView* pImageView);
+    uint32_t AllocateSampler(const grfx::Sampler* pSampler);
+
+    // Replaces the descriptor in an already allocated slot
+    Result UpdateTexture(uint32_t index, const grfx::SampledImageView* pImageView);
+    Result UpdateSampler(uint32_t index, const grfx::Sampler* pSampler);
+
+    void FreeTexture(uint32_t index);
+    void FreeSampler(uint32_t index);
+
+    // Writes all queued slot updates to the descriptor set
+    Result Flush();
+
+protected:
+    virtual Result CreateApiObjects(const grfx::BindlessHeapCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    class SlotAllocator
+    {
+    public:
+        void     Reset(uint32_t capacity);
+        uint32_t Allocate();
+        void     Free(uint32_t index);
+        bool     IsAllocated(uint32_t index) const;
+        uint32_t GetAllocatedCount() const { return mAllocatedCount; }
+
+    private:
+        std::vector<bool>     mAllocated;
+        std::vector<uint32_t> mFreeIndices;
+        uint32_t              mNextIndex      = 0;
+        uint32_t              mAllocatedCount = 0;
+    };
+
+    grfx::DescriptorPoolPtr            mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr       mDescriptorSetLayout;
+    grfx::DescriptorSetPtr             mDescriptorSet;
+    SlotAllocator                      mTextureSlots;
+    SlotAllocator                      mSamplerSlots;
+    std::vector<grfx::WriteDescriptor> mPendingWrites;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_bindless_heap_h
@@ -0,0 +1,100 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_block_compressor_h
+#define ppx_grfx_block_compressor_h
+
+#include "ppx/grfx/grfx_config.h"
+
+namespace ppx {
+namespace grfx {
+
+struct BlockCompressorCreateInfo
+{
+    grfx::ShaderModule* pShader          = nullptr; // basic/shaders/CompressBlocks.cs
+    uint32_t            maxDispatchCount = 32;      // Dispatches Record() can add up between Reset() calls, one per mip level
+};
+
+//! @class BlockCompressor
+//!
+//! Compresses images created at runtime into BC1 or BC3 images with a
+//! compute shader. Images can't change format, so the blocks are written to
+//! a buffer and copied into a separate destination image with the same size
+//! and array layer count, and at most as many mip levels, as the source.
+//!
+//! Sources need sampled usage and an uncompressed color format. sRGB
+//! destinations take the source's color values as sRGB encoded: sources
+//! with an sRGB format are encoded back after sampling.
+//!
+//! Buffers, views and descriptor sets of recorded work are kept until
+//! Reset(), which must only be called once the command buffers Record() was
+//! called with have completed.
+//!
+class BlockCompressor
+{
+public:
+    BlockCompressor();
+    virtual ~BlockCompressor();
+
+    static Result Create(grfx::Device* pDevice, const grfx::BlockCompressorCreateInfo& createInfo, grfx::BlockCompressor** ppCompressor);
+
+    //! Records compression of every mip level and array layer of pDstImage
+    //! from pSrcImage into pCmd. pSrcImage must be in srcState and stays in
+    //! it, the previous contents of pDstImage are discarded and all of its
+    //! subresources end up in dstStateAfter. Must be recorded outside of a
+    //! render pass.
+    Result Record(
+        grfx::CommandBuffer* pCmd,
+        grfx::Image*         pSrcImage,
+        grfx::ResourceState  srcState,
+        grfx::Image*         pDstImage,
+        grfx::ResourceState  dstStateAfter);
+
+    //! Releases the resources of recorded work
+    void Reset();
+
+    //! Returns the number of dispatches recorded since the last Reset()
+    uint32_t GetDispatchCount() const { return mDispatchCount; }
+
+    //! Returns true if format is a destination format Record() writes
+    static bool IsFormatSupported(grfx::Format format);
+    //! Returns true if Record() can compress pSrcImage into pDstImage
+    static bool IsSupported(const grfx::Image* pSrcImage, const grfx::Image* pDstImage);
+
+private:
+    struct Job
+    {
+        grfx::BufferPtr                        buffer;
+        std::vector<grfx::SampledImageViewPtr> srcViews;
+        std::vector<grfx::DescriptorSetPtr>    sets;
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::BlockCompressorCreateInfo& createInfo);
+    void   DestroyJob(Job& job);
+
+private:
+    grfx::Device*                mDevice           = nullptr;
+    uint32_t                     mMaxDispatchCount = 0;
+    uint32_t                     mDispatchCount    = 0;
+    grfx::DescriptorPoolPtr      mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr mSetLayout;
+    grfx::PipelineInterfacePtr   mPipelineInterface;
+    grfx::ComputePipelinePtr     mPipeline;
+    std::vector<Job>             mJobs;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_block_compressor_h
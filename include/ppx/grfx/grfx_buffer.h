@@ -50,12 +50,26 @@ public:
     virtual Result MapMemory(uint64_t offset, void** ppMappedAddress) = 0;
     virtual void   UnmapMemory()                                      = 0;
 
+    //! GPU address of the start of the buffer, for passing buffers to
+    //! shaders without descriptors, e.g. in push constants. The buffer
+    //! needs shaderDeviceAddress usage. Shaders can only load through it on
+    //! Vulkan, see ppx/DeviceAddress.hlsli, on D3D12 the address is only
+    //! meaningful to the API (root descriptors, ray tracing inputs).
+    virtual uint64_t GetDeviceAddress() const = 0;
+
     Result CopyFromSource(uint32_t dataSize, const void* pData);
     Result CopyToDest(uint32_t dataSize, void* pData);
 
+    //! Tracked state used by CommandBuffer::TransitionBufferState. See
+    //! Image::GetTrackedState for the rules that apply.
+    grfx::ResourceState GetTrackedState() const { return mTrackedState; }
+    void                SetTrackedState(grfx::ResourceState state) { mTrackedState = state; }
+
 private:
     virtual Result Create(const grfx::BufferCreateInfo* pCreateInfo) override;
     friend class grfx::Device;
+
+    grfx::ResourceState mTrackedState = grfx::RESOURCE_STATE_UNDEFINED;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -0,0 +1,114 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_buffer_pool_h
+#define ppx_grfx_buffer_pool_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_buffer.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct BufferPoolCreateInfo
+//!
+//! transferDst is always added to usageFlags so that ranges can be
+//! filled with copies.
+//!
+struct BufferPoolCreateInfo
+{
+    uint64_t               blockSize   = 16 * 1024 * 1024; // Size of each pool buffer, larger requests get their own block
+    uint32_t               alignment   = 4;                // Minimum alignment of every range
+    grfx::BufferUsageFlags usageFlags  = {};
+    grfx::MemoryUsage      memoryUsage = grfx::MEMORY_USAGE_GPU_ONLY;
+};
+
+//! @struct BufferRange
+//!
+//! A sub-range of one of the pool's buffers. Stays valid until it's freed
+//! or the pool is destroyed.
+//!
+struct BufferRange
+{
+    grfx::Buffer* pBuffer = nullptr;
+    uint64_t      offset  = 0;
+    uint64_t      size    = 0;
+
+    bool IsValid() const { return !IsNull(pBuffer); }
+
+    grfx::IndexBufferView  GetIndexBufferView(grfx::IndexType indexType) const { return grfx::IndexBufferView(pBuffer, indexType, offset, size); }
+    grfx::VertexBufferView GetVertexBufferView(uint32_t stride) const { return grfx::VertexBufferView(pBuffer, stride, offset, size); }
+};
+
+//! @class BufferPool
+//!
+//! Sub-allocates ranges of a few large buffers so that many small
+//! vertex, index or uniform buffers don't each need their own buffer and
+//! memory allocation. Ranges within a block are placed first fit and
+//! neighbouring free ranges are merged when freed.
+//!
+//! Objects sharing a block can be drawn without rebinding: bind the block
+//! at offset 0 and use offset / elementSize as firstIndex or vertexOffset.
+//! Allocate() with alignment set to the vertex stride keeps those exact.
+//!
+//! Not thread safe.
+//!
+class BufferPool
+    : public grfx::DeviceObject<grfx::BufferPoolCreateInfo>
+{
+public:
+    BufferPool() {}
+    virtual ~BufferPool() {}
+
+    // alignment doesn't have to be a power of two, it's combined with the
+    // pool's alignment. Returns ppx::ERROR_OUT_OF_MEMORY if a new block
+    // can't be created.
+    Result Allocate(uint64_t size, grfx::BufferRange* pRange);
+    Result Allocate(uint64_t size, uint32_t alignment, grfx::BufferRange* pRange);
+    void   Free(const grfx::BufferRange& range);
+
+    uint32_t GetBlockCount() const { return CountU32(mBlocks); }
+    uint32_t GetAllocationCount() const { return mAllocationCount; }
+    uint64_t GetAllocatedSize() const { return mAllocatedSize; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::BufferPoolCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct FreeRange
+    {
+        uint64_t offset = 0;
+        uint64_t size   = 0;
+    };
+
+    struct Block
+    {
+        grfx::BufferPtr        buffer;
+        std::vector<FreeRange> freeRanges; // Sorted by offset
+    };
+
+    Result CreateBlock(uint64_t size);
+    bool   AllocateFromBlock(Block& block, uint64_t size, uint64_t alignment, grfx::BufferRange* pRange);
+
+private:
+    std::vector<Block> mBlocks;
+    uint32_t           mAllocationCount = 0;
+    uint64_t           mAllocatedSize   = 0;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_buffer_pool_h
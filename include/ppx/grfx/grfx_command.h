@@ -184,6 +184,79 @@ struct ImageBlitInfo
     Filter filter = FILTER_LINEAR;
 };
 
+//! @struct ImageResolveInfo
+//!
+//! Resolves the whole extent of the source, which must be multisampled, into
+//! a single sample destination of the same format and size.
+//!
+struct ImageResolveInfo
+{
+    struct
+    {
+        uint32_t arrayLayer      = 0;
+        uint32_t arrayLayerCount = 1;
+    } srcImage;
+
+    struct
+    {
+        uint32_t mipLevel   = 0;
+        uint32_t arrayLayer = 0;
+    } dstImage;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+//! @struct DrawIndirectCommand
+//!
+//! Argument layout read by DrawIndirect*(), matches VkDrawIndirectCommand
+//! and D3D12_DRAW_ARGUMENTS so it can be written directly by shaders.
+//!
+struct DrawIndirectCommand
+{
+    uint32_t vertexCount   = 0;
+    uint32_t instanceCount = 0;
+    uint32_t firstVertex   = 0;
+    uint32_t firstInstance = 0;
+};
+
+//! @struct DrawIndexedIndirectCommand
+//!
+//! Argument layout read by DrawIndexedIndirect*(), matches
+//! VkDrawIndexedIndirectCommand and D3D12_DRAW_INDEXED_ARGUMENTS.
+//!
+struct DrawIndexedIndirectCommand
+{
+    uint32_t indexCount    = 0;
+    uint32_t instanceCount = 0;
+    uint32_t firstIndex    = 0;
+    int32_t  vertexOffset  = 0;
+    uint32_t firstInstance = 0;
+};
+
+//! @struct DispatchIndirectCommand
+//!
+//! Argument layout read by DispatchIndirect(), matches
+//! VkDispatchIndirectCommand and D3D12_DISPATCH_ARGUMENTS.
+//!
+struct DispatchIndirectCommand
+{
+    uint32_t groupCountX = 0;
+    uint32_t groupCountY = 0;
+    uint32_t groupCountZ = 0;
+};
+
+//! @struct DrawMeshTasksIndirectCommand
+//!
+//! Argument layout read by DrawMeshTasksIndirect*(), matches
+//! VkDrawMeshTasksIndirectCommandEXT and D3D12_DISPATCH_MESH_ARGUMENTS.
+//!
+struct DrawMeshTasksIndirectCommand
+{
+    uint32_t groupCountX = 0;
+    uint32_t groupCountY = 0;
+    uint32_t groupCountZ = 0;
+};
+
 // -------------------------------------------------------------------------------------------------
 
 struct RenderPassBeginInfo
@@ -197,6 +270,14 @@ struct RenderPassBeginInfo
     uint32_t                     RTVClearCount                          = 0;
     grfx::RenderTargetClearValue RTVClearValues[PPX_MAX_RENDER_TARGETS] = {0.0f, 0.0f, 0.0f, 0.0f};
     grfx::DepthStencilClearValue DSVClearValue                          = {1.0f, 0xFF};
+
+    //
+    // When true the contents of the render pass are recorded into
+    // secondary command buffers and the only command that may be
+    // recorded between BeginRenderPass and EndRenderPass is
+    // ExecuteCommands.
+    //
+    bool secondaryCommandBuffers = false;
 };
 
 // RenderingInfo is used to start dynamic render passes.
@@ -225,6 +306,11 @@ struct CommandPoolCreateInfo
 
 //! @class CommandPool
 //!
+//! A command pool and the command buffers allocated from it must only be
+//! used by one thread at a time. To record in parallel give each recording
+//! thread its own pool, Queue::CreateCommandBuffer and
+//! Queue::CreateSecondaryCommandBuffer already create a dedicated pool for
+//! every command buffer they return.
 //!
 class CommandPool
     : public grfx::DeviceObject<grfx::CommandPoolCreateInfo>
@@ -233,7 +319,8 @@ public:
     CommandPool() {}
     virtual ~CommandPool() {}
 
-    grfx::CommandType GetCommandType() const;
+    const grfx::Queue* GetQueue() const { return mCreateInfo.pQueue; }
+    grfx::CommandType  GetCommandType() const;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -242,35 +329,62 @@ namespace internal {
 
 //! @struct CommandBufferCreateInfo
 //!
-//! For D3D12 every command buffer will have two GPU visible descriptor heaps:
+//! For D3D12 all command buffers of a device share two GPU visible
+//! descriptor rings:
 //!   - one for CBVSRVUAV descriptors
 //!   - one for Sampler descriptors
 //!
-//! Both of heaps are set when the command buffer begins.
+//! Both rings are set when the command buffer begins.
 //!
 //! Each time that BindGraphicsDescriptorSets or BindComputeDescriptorSets
 //! is called, the contents of each descriptor set's CBVSRVAUV and Sampler heaps
-//! will be copied into the command buffer's respective heap.
+//! will be copied into chunks of the respective ring that the command buffer
+//! holds until it begins again, after the GPU is done with its submission.
 //!
 //! The offsets from used in the copies will be saved and used to set the
 //! root descriptor tables.
 //!
-//! 'resourceDescriptorCount' and 'samplerDescriptorCount' tells the
-//! D3D12 command buffer how large CBVSRVUAV and Sampler heaps should be.
-//!
-//! 'samplerDescriptorCount' cannot exceed PPX_MAX_SAMPLER_DESCRIPTORS.
+//! 'resourceDescriptorCount' and 'samplerDescriptorCount' are no longer used
+//! since heaps aren't per command buffer, they are kept for compatibility.
 //!
 //! Vulkan does not use 'samplerDescriptorCount' or 'samplerDescriptorCount'.
 //!
+//! 'secondary' creates a secondary command buffer (a bundle on D3D12) that
+//! can only be submitted by recording it into a primary command buffer
+//! with ExecuteCommands. D3D12 bundles use the descriptor rings set by
+//! the command list that executes them.
+//!
+//! 'reusable' creates a command buffer that is recorded once and then
+//! submitted (or executed) any number of times, including while earlier
+//! submissions are still pending. On Vulkan it's begun with
+//! VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT. D3D12 command lists and
+//! bundles can always be resubmitted, the descriptor tables copied when
+//! descriptor sets are bound stay alive until the next Begin. Either way
+//! the recorded commands capture the resources and descriptor sets, so
+//! per submission data has to be passed through buffer contents.
+//!
 struct CommandBufferCreateInfo
 {
     const grfx::CommandPool* pPool                   = nullptr;
     uint32_t                 resourceDescriptorCount = PPX_DEFAULT_RESOURCE_DESCRIPTOR_COUNT;
     uint32_t                 samplerDescriptorCount  = PPX_DEFAULT_SAMPLE_DESCRIPTOR_COUNT;
+    bool                     secondary               = false;
+    bool                     reusable                = false;
 };
 
 } // namespace internal
 
+//! @struct CommandBufferInheritanceInfo
+//!
+//! Describes the render pass a secondary command buffer will be executed
+//! in. 'pRenderPass' can be null if the secondary command buffer is
+//! executed outside of a render pass.
+//!
+struct CommandBufferInheritanceInfo
+{
+    const grfx::RenderPass* pRenderPass = nullptr;
+};
+
 //! @class CommandBuffer
 //!
 //!
@@ -282,10 +396,43 @@ public:
     virtual ~CommandBuffer() {}
 
     grfx::CommandType GetCommandType() const { return mCreateInfo.pPool->GetCommandType(); }
+    bool              IsSecondary() const { return mCreateInfo.secondary; }
+    bool              IsReusable() const { return mCreateInfo.reusable; }
+
+    const grfx::CommandPool* GetCommandPool() const { return mCreateInfo.pPool; }
 
     virtual Result Begin() = 0;
     virtual Result End()   = 0;
 
+    //
+    // Begins recording a secondary command buffer. Secondary command
+    // buffers allocated from different pools can be recorded concurrently
+    // on different threads and are then recorded into a primary command
+    // buffer with ExecuteCommands.
+    //
+    // Vulkan secondary command buffers do not inherit any state from the
+    // primary command buffer, so pipelines, vertex buffers, viewports,
+    // scissors and descriptor sets must be set in every secondary command
+    // buffer. D3D12 bundles inherit viewports and scissors from the
+    // primary command list and ignore SetViewports and SetScissors.
+    // D3D12 bundles cannot bind descriptor sets.
+    //
+    Result BeginSecondary(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo);
+
+    //
+    // Records the commands in ppCommandBuffers into this command buffer.
+    // All command buffers in ppCommandBuffers must be secondary command
+    // buffers that have finished recording. If called inside a render pass
+    // the render pass must have been started with secondaryCommandBuffers
+    // set to true.
+    //
+    // The bound pipeline, descriptor sets and dynamic state of this command
+    // buffer are undefined after ExecuteCommands returns.
+    //
+    void ExecuteCommands(
+        uint32_t                          commandBufferCount,
+        const grfx::CommandBuffer* const* ppCommandBuffers);
+
     void BeginRenderPass(const grfx::RenderPassBeginInfo* pBeginInfo);
     void EndRenderPass();
 
@@ -335,6 +482,38 @@ public:
     // See comment at function \b TransitionImageLayout for details
     // on queue ownership transfer.
     //
+    //
+    // Tracked transitions use the state tracked by the image or buffer as
+    // the before state and defer the barrier until the next command that
+    // depends on it: BeginRenderPass, BeginRendering, ExecuteCommands,
+    // Dispatch, copies, blits, explicit barriers and End. All transitions
+    // deferred in between are emitted with a single barrier call, and
+    // transitions to the state a subresource is already in are dropped.
+    //
+    // Tracked transitions cannot be recorded inside a render pass.
+    //
+    void TransitionImageState(
+        grfx::Image*        pImage,
+        grfx::ResourceState afterState,
+        uint32_t            mipLevel        = 0,
+        uint32_t            mipLevelCount   = PPX_REMAINING_MIP_LEVELS,
+        uint32_t            arrayLayer      = 0,
+        uint32_t            arrayLayerCount = PPX_REMAINING_ARRAY_LAYERS);
+
+    void TransitionBufferState(
+        grfx::Buffer*       pBuffer,
+        grfx::ResourceState afterState);
+
+    // Emits all deferred tracked transitions now
+    void FlushBarriers();
+
+    //! Hands the memory shared by aliased images (see ImageCreateInfo::pAliasImage)
+    //! over to pAfter. pBefore is the image that used the memory last, or null
+    //! if it could be any of them. The contents of pAfter are undefined
+    //! afterwards, so render targets and depth stencils should be cleared on
+    //! first use. Must be recorded before pAfter's first tracked transition.
+    void AliasingBarrier(const grfx::Image* pBefore, grfx::Image* pAfter);
+
     virtual void BufferResourceBarrier(
         const grfx::Buffer* pBuffer,
         grfx::ResourceState beforeState,
@@ -350,6 +529,16 @@ public:
         uint32_t          scissorCount,
         const grfx::Rect* pScissors) = 0;
 
+    //! @brief Dynamic pipeline state, the bound pipeline must have been created with the
+    //!        matching grfx::DynamicState member enabled.
+    virtual void SetCullMode(grfx::CullMode cullMode)                   = 0;
+    virtual void SetPrimitiveTopology(grfx::PrimitiveTopology topology) = 0;
+    virtual void SetDepthTestEnable(bool enable)                        = 0;
+    virtual void SetDepthWriteEnable(bool enable)                       = 0;
+    virtual void SetBlendEnable(
+        uint32_t    renderTargetCount,
+        const bool* pEnables) = 0;
+
     virtual void BindGraphicsDescriptorSets(
         const grfx::PipelineInterface*    pInterface,
         uint32_t                          setCount,
@@ -490,6 +679,72 @@ public:
         uint32_t groupCountY,
         uint32_t groupCountZ) = 0;
 
+    // Launches the amplification (task) shader of the bound graphics
+    // pipeline, or its mesh shader if it has none. Requires a pipeline
+    // with a mesh shader and grfx::Device::MeshShaderSupported().
+    //
+    virtual void DrawMeshTasks(
+        uint32_t groupCountX,
+        uint32_t groupCountY = 1,
+        uint32_t groupCountZ = 1) = 0;
+
+    // Indirect draws read drawCount commands from pArgBuffer starting at
+    // argOffset, stride bytes apart. pArgBuffer needs indirectBuffer usage
+    // and must be in RESOURCE_STATE_INDIRECT_ARGUMENT.
+    //
+    virtual void DrawIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride = sizeof(grfx::DrawIndirectCommand)) = 0;
+
+    virtual void DrawIndexedIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride = sizeof(grfx::DrawIndexedIndirectCommand)) = 0;
+
+    // The draw count is read from a uint32_t at countOffset in pCountBuffer
+    // and clamped to maxDrawCount, so a culling pass can decide how many
+    // draws are issued. Requires grfx::Device::DrawIndirectCountSupported().
+    //
+    virtual void DrawIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride = sizeof(grfx::DrawIndirectCommand)) = 0;
+
+    virtual void DrawIndexedIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride = sizeof(grfx::DrawIndexedIndirectCommand)) = 0;
+
+    // Indirect DrawMeshTasks(), the count variant also requires
+    // grfx::Device::DrawIndirectCountSupported().
+    //
+    virtual void DrawMeshTasksIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride = sizeof(grfx::DrawMeshTasksIndirectCommand)) = 0;
+
+    virtual void DrawMeshTasksIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride = sizeof(grfx::DrawMeshTasksIndirectCommand)) = 0;
+
+    virtual void DispatchIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset) = 0;
+
     virtual void CopyBufferToBuffer(
         const grfx::BufferToBufferCopyInfo* pCopyInfo,
         grfx::Buffer*                       pSrcBuffer,
@@ -525,6 +780,14 @@ public:
         grfx::Image*               pSrcImage,
         grfx::Image*               pDstImage) = 0;
 
+    //! @brief Resolves a multisampled image, pSrcImage must be in
+    //!        RESOURCE_STATE_RESOLVE_SRC and pDstImage in RESOURCE_STATE_RESOLVE_DST.
+    //!        Must be recorded outside of a render pass.
+    virtual void ResolveImage(
+        const grfx::ImageResolveInfo* pResolveInfo,
+        grfx::Image*                  pSrcImage,
+        grfx::Image*                  pDstImage) = 0;
+
     virtual void BeginQuery(
         const grfx::Query* pQuery,
         uint32_t           queryIndex) = 0;
@@ -543,10 +806,71 @@ public:
         uint32_t     startIndex,
         uint32_t     numQueries) = 0;
 
+    //! @brief Writes whether each occlusion query from firstQuery on had any samples pass
+    //!        as a predicate for BeginConditionalRendering(), PPX_OCCLUSION_PREDICATE_SIZE
+    //!        bytes per query starting at dstOffset. The results stay on the GPU, nothing
+    //!        waits for them on the CPU. pDstBuffer needs conditionalRendering and transferDst
+    //!        usage and must be in RESOURCE_STATE_PREDICATION, it's returned to it. Must be
+    //!        recorded outside of a render pass. Requires ConditionalRenderingSupported().
+    virtual void ResolveOcclusionPredicates(
+        const grfx::Query* pQuery,
+        uint32_t           firstQuery,
+        uint32_t           queryCount,
+        grfx::Buffer*      pDstBuffer,
+        uint64_t           dstOffset) = 0;
+
+    //! @brief Draws, dispatches and clears recorded until EndConditionalRendering() are
+    //!        skipped if the predicate at offset in pBuffer is zero. offset must be a
+    //!        multiple of PPX_OCCLUSION_PREDICATE_SIZE. Conditional rendering can't be
+    //!        nested and must begin and end in the same render pass if started inside one.
+    //!        Requires ConditionalRenderingSupported().
+    virtual void BeginConditionalRendering(
+        const grfx::Buffer* pBuffer,
+        uint64_t            offset) = 0;
+
+    virtual void EndConditionalRendering() = 0;
+
+    //! @brief Builds or updates acceleration structures, see grfx::AccelerationStructureBuilder
+    //!        for batching and scratch memory management.
+    //! @param count The number of builds in pInfos. The builds must not write overlapping
+    //!              scratch ranges or structures read by other builds of the same call.
+    //! @param pInfos The builds.
+    virtual void BuildAccelerationStructures(
+        uint32_t                                    count,
+        const grfx::AccelerationStructureBuildInfo* pInfos) = 0;
+
+    //! @brief Copies an acceleration structure.
+    //! @param compact If true pDst must be at least the compacted size of pSrc and pSrc
+    //!                must have been built with ALLOW_COMPACTION.
+    virtual void CopyAccelerationStructure(
+        const grfx::AccelerationStructure* pSrc,
+        grfx::AccelerationStructure*       pDst,
+        bool                               compact) = 0;
+
+    //! @brief Writes the compacted size of each structure in ppAccelerationStructures to the
+    //!        queries starting at firstQuery. pQuery must be of type
+    //!        QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE, ResolveQueryData() makes the
+    //!        sizes readable with Query::GetData().
+    virtual void WriteAccelerationStructureCompactedSizes(
+        uint32_t                                  count,
+        const grfx::AccelerationStructure* const* ppAccelerationStructures,
+        grfx::Query*                              pQuery,
+        uint32_t                                  firstQuery) = 0;
+
+    //! @brief Makes acceleration structure builds and copies visible to later builds, copies
+    //!        and shader reads, and orders reuse of their scratch memory.
+    virtual void AccelerationStructureBarrier() = 0;
+
+    //! @brief Opens a named region that shows up in debuggers and GPU captures, must be
+    //!        closed with EndDebugLabel() in the same command buffer. No-op if the API
+    //!        debug utilities aren't available.
+    virtual void BeginDebugLabel(const char* pLabel) = 0;
+    virtual void EndDebugLabel()                     = 0;
+
     // ---------------------------------------------------------------------------------------------
     // Convenience functions
     // ---------------------------------------------------------------------------------------------
-    void BeginRenderPass(const grfx::RenderPass* pRenderPass);
+    void BeginRenderPass(const grfx::RenderPass* pRenderPass, bool secondaryCommandBuffers = false);
 
     void BeginRenderPass(
         const grfx::DrawPass*           pDrawPass,
@@ -577,6 +901,11 @@ public:
         grfx::ResourceState depthStencilTargetBeforeState,
         grfx::ResourceState depthStencilTargetAfterState);
 
+    void TransitionImageState(
+        grfx::DrawPass*     pDrawPass,
+        grfx::ResourceState renderTargetState,
+        grfx::ResourceState depthStencilTargetState);
+
     void SetViewports(const grfx::Viewport& viewport);
 
     void SetScissors(const grfx::Rect& scissor);
@@ -617,6 +946,24 @@ protected:
         grfx::DepthStencilViewPtr              mDepthStencilView  = nullptr;
     };
 
+    struct ImageBarrier
+    {
+        const grfx::Image*  pImage          = nullptr;
+        uint32_t            mipLevel        = 0;
+        uint32_t            mipLevelCount   = 0;
+        uint32_t            arrayLayer      = 0;
+        uint32_t            arrayLayerCount = 0;
+        grfx::ResourceState beforeState     = grfx::RESOURCE_STATE_UNDEFINED;
+        grfx::ResourceState afterState      = grfx::RESOURCE_STATE_UNDEFINED;
+    };
+
+    struct BufferBarrier
+    {
+        const grfx::Buffer* pBuffer     = nullptr;
+        grfx::ResourceState beforeState = grfx::RESOURCE_STATE_UNDEFINED;
+        grfx::ResourceState afterState  = grfx::RESOURCE_STATE_UNDEFINED;
+    };
+
     // Returns true when inside a render pass (dynamic or regular)
     bool HasActiveRenderPass() const;
 
@@ -624,6 +971,21 @@ protected:
     DynamicRenderPassInfo mDynamicRenderPassInfo   = {};
 
 private:
+    virtual Result BeginSecondaryImpl(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo) = 0;
+
+    virtual void ExecuteCommandsImpl(
+        uint32_t                          commandBufferCount,
+        const grfx::CommandBuffer* const* ppCommandBuffers) = 0;
+
+    // Records all barriers with a single API barrier call
+    virtual void ResourceBarriersImpl(
+        uint32_t             imageBarrierCount,
+        const ImageBarrier*  pImageBarriers,
+        uint32_t             bufferBarrierCount,
+        const BufferBarrier* pBufferBarriers) = 0;
+
+    virtual void AliasingBarrierImpl(const grfx::Image* pBefore, grfx::Image* pAfter) = 0;
+
     virtual void BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo) = 0;
     virtual void EndRenderPassImpl()                                              = 0;
 
@@ -643,6 +1005,10 @@ private:
         const grfx::Sampler*           pSampler) = 0;
 
     const grfx::RenderPass* mCurrentRenderPass = nullptr;
+
+    // Deferred tracked transitions, one entry per image subresource
+    std::vector<ImageBarrier>  mPendingImageBarriers;
+    std::vector<BufferBarrier> mPendingBufferBarriers;
 };
 
 } // namespace grfx
@@ -0,0 +1,112 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_compute_batch_h
+#define ppx_grfx_compute_batch_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_queue.h"
+
+#include <functional>
+
+namespace ppx {
+namespace grfx {
+
+//! @struct ComputeBatchRunnerCreateInfo
+//!
+//! \b inFlightCount command buffers are recorded round robin, so up to
+//! that many submits execute on the GPU while the next one is recorded.
+//! \b jobsPerSubmit jobs are recorded into each command buffer, more jobs
+//! per submit trade latency for fewer submits.
+//!
+struct ComputeBatchRunnerCreateInfo
+{
+    grfx::Queue* pQueue        = nullptr;
+    uint32_t     inFlightCount = 3;
+    uint32_t     jobsPerSubmit = 1;
+};
+
+//! @class ComputeBatchRunner
+//!
+//! Pushes a stream of independent jobs through a queue without a frame
+//! loop, for batch processing. \b Add records a job into the current
+//! command buffer and submits it once it holds \b jobsPerSubmit jobs.
+//! When every command buffer is in flight \b Add waits for the oldest one,
+//! so the CPU records at most one submit ahead of the GPU's backlog.
+//!
+//! A job's completion callback runs on the thread that calls \b Add,
+//! \b Poll or \b WaitIdle, after its submit has completed on the GPU,
+//! e.g. to read back results. Jobs of different submits can overlap on
+//! the GPU; jobs recorded into the same command buffer need their own
+//! barriers if they depend on each other.
+//!
+class ComputeBatchRunner
+    : public grfx::DeviceObject<grfx::ComputeBatchRunnerCreateInfo>
+{
+public:
+    using RecordFn   = std::function<void(grfx::CommandBuffer*)>;
+    using CompleteFn = std::function<void()>;
+
+    ComputeBatchRunner() {}
+    virtual ~ComputeBatchRunner() {}
+
+    grfx::Queue* GetQueue() const { return mCreateInfo.pQueue; }
+
+    //! Records a job. \b record must only record into the command buffer
+    //! it's given, \b onComplete can be empty.
+    Result Add(const RecordFn& record, const CompleteFn& onComplete = CompleteFn());
+
+    //! Submits the jobs recorded since the last submit.
+    Result Flush();
+
+    //! Runs the completion callbacks of completed submits, doesn't block.
+    Result Poll();
+
+    //! Flushes and waits for every submit, then runs their callbacks.
+    Result WaitIdle();
+
+    uint64_t GetSubmittedJobCount() const { return mSubmittedJobCount; }
+    uint64_t GetCompletedJobCount() const { return mCompletedJobCount; }
+    uint64_t GetSubmitCount() const { return mSubmitCount; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::ComputeBatchRunnerCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct Slot
+    {
+        grfx::CommandBufferPtr  cmd;
+        grfx::FencePtr          fence;
+        std::vector<CompleteFn> completions;
+        uint32_t                jobCount  = 0;
+        bool                    recording = false;
+        bool                    inFlight  = false;
+    };
+
+    // Waits for the slot if it's in flight and runs its callbacks
+    Result Retire(Slot& slot);
+
+private:
+    std::vector<Slot> mSlots;
+    uint32_t          mCurrentSlot       = 0; // Slots are submitted round robin, so it's also the oldest in flight
+    uint64_t          mSubmittedJobCount = 0;
+    uint64_t          mCompletedJobCount = 0;
+    uint64_t          mSubmitCount       = 0;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_compute_batch_h
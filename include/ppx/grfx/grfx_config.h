@@ -25,39 +25,55 @@
 namespace ppx {
 namespace grfx {
 
+class AccelerationStructure;
+class AccelerationStructureBuilder;
+class AsyncComputeScheduler;
+class BindlessHeap;
 class Buffer;
+class BufferPool;
 class CommandBuffer;
 class CommandPool;
+class ComputeBatchRunner;
 class ComputePipeline;
+class DescriptorAllocator;
 class DescriptorPool;
 class DescriptorSet;
 class DescriptorSet;
 class DescriptorSetLayout;
+class DepthPyramid;
 class Device;
 class DrawPass;
+class DynamicResolution;
 class Fence;
 class ShadingRatePattern;
 class FullscreenQuad;
 class Gpu;
+class GpuProfiler;
 class GraphicsPipeline;
 class Image;
 class ImageView;
 class Instance;
+class LineDraw;
 class Mesh;
 class PipelineInterface;
+class PostProcessChain;
 class Queue;
 class Query;
+class RenderGraph;
 class RenderPass;
 class Sampler;
 class SamplerYcbcrConversion;
 class Semaphore;
 class ShaderModule;
 class ShaderProgram;
+class SparseImageFeedback;
 class Surface;
 class Swapchain;
+class TemporalResolve;
 class TextDraw;
 class Texture;
 class TextureFont;
+class TransientAllocator;
 
 class DepthStencilView;
 class RenderTargetView;
@@ -65,6 +81,7 @@ class SampledImageView;
 class StorageImageView;
 
 struct IndexBufferView;
+struct SparseImageBindInfo;
 struct VertexBufferView;
 
 namespace internal {
@@ -75,37 +92,53 @@ class ImageResourceView;
 
 // -------------------------------------------------------------------------------------------------
 
-using BufferPtr                 = ObjPtr<Buffer>;
-using CommandBufferPtr          = ObjPtr<CommandBuffer>;
-using CommandPoolPtr            = ObjPtr<CommandPool>;
-using ComputePipelinePtr        = ObjPtr<ComputePipeline>;
-using DescriptorPoolPtr         = ObjPtr<DescriptorPool>;
-using DescriptorSetPtr          = ObjPtr<DescriptorSet>;
-using DescriptorSetLayoutPtr    = ObjPtr<DescriptorSetLayout>;
-using DevicePtr                 = ObjPtr<Device>;
-using DrawPassPtr               = ObjPtr<DrawPass>;
-using FencePtr                  = ObjPtr<Fence>;
-using ShadingRatePatternPtr     = ObjPtr<ShadingRatePattern>;
-using FullscreenQuadPtr         = ObjPtr<FullscreenQuad>;
-using GraphicsPipelinePtr       = ObjPtr<GraphicsPipeline>;
-using GpuPtr                    = ObjPtr<Gpu>;
-using ImagePtr                  = ObjPtr<Image>;
-using InstancePtr               = ObjPtr<Instance>;
-using MeshPtr                   = ObjPtr<Mesh>;
-using PipelineInterfacePtr      = ObjPtr<PipelineInterface>;
-using QueuePtr                  = ObjPtr<Queue>;
-using QueryPtr                  = ObjPtr<Query>;
-using RenderPassPtr             = ObjPtr<RenderPass>;
-using SamplerPtr                = ObjPtr<Sampler>;
-using SamplerYcbcrConversionPtr = ObjPtr<SamplerYcbcrConversion>;
-using SemaphorePtr              = ObjPtr<Semaphore>;
-using ShaderModulePtr           = ObjPtr<ShaderModule>;
-using ShaderProgramPtr          = ObjPtr<ShaderProgram>;
-using SurfacePtr                = ObjPtr<Surface>;
-using SwapchainPtr              = ObjPtr<Swapchain>;
-using TextDrawPtr               = ObjPtr<TextDraw>;
-using TexturePtr                = ObjPtr<Texture>;
-using TextureFontPtr            = ObjPtr<TextureFont>;
+using AccelerationStructurePtr        = ObjPtr<AccelerationStructure>;
+using AccelerationStructureBuilderPtr = ObjPtr<AccelerationStructureBuilder>;
+using AsyncComputeSchedulerPtr        = ObjPtr<AsyncComputeScheduler>;
+using BindlessHeapPtr                 = ObjPtr<BindlessHeap>;
+using BufferPtr                       = ObjPtr<Buffer>;
+using BufferPoolPtr                   = ObjPtr<BufferPool>;
+using CommandBufferPtr                = ObjPtr<CommandBuffer>;
+using CommandPoolPtr                  = ObjPtr<CommandPool>;
+using ComputeBatchRunnerPtr           = ObjPtr<ComputeBatchRunner>;
+using ComputePipelinePtr              = ObjPtr<ComputePipeline>;
+using DescriptorAllocatorPtr          = ObjPtr<DescriptorAllocator>;
+using DescriptorPoolPtr               = ObjPtr<DescriptorPool>;
+using DescriptorSetPtr                = ObjPtr<DescriptorSet>;
+using DescriptorSetLayoutPtr          = ObjPtr<DescriptorSetLayout>;
+using DepthPyramidPtr                 = ObjPtr<DepthPyramid>;
+using DevicePtr                       = ObjPtr<Device>;
+using DrawPassPtr                     = ObjPtr<DrawPass>;
+using DynamicResolutionPtr            = ObjPtr<DynamicResolution>;
+using FencePtr                        = ObjPtr<Fence>;
+using ShadingRatePatternPtr           = ObjPtr<ShadingRatePattern>;
+using FullscreenQuadPtr               = ObjPtr<FullscreenQuad>;
+using GraphicsPipelinePtr             = ObjPtr<GraphicsPipeline>;
+using GpuPtr                          = ObjPtr<Gpu>;
+using GpuProfilerPtr                  = ObjPtr<GpuProfiler>;
+using ImagePtr                        = ObjPtr<Image>;
+using InstancePtr                     = ObjPtr<Instance>;
+using LineDrawPtr                     = ObjPtr<LineDraw>;
+using MeshPtr                         = ObjPtr<Mesh>;
+using PipelineInterfacePtr            = ObjPtr<PipelineInterface>;
+using PostProcessChainPtr             = ObjPtr<PostProcessChain>;
+using QueuePtr                        = ObjPtr<Queue>;
+using QueryPtr                        = ObjPtr<Query>;
+using RenderGraphPtr                  = ObjPtr<RenderGraph>;
+using RenderPassPtr                   = ObjPtr<RenderPass>;
+using SamplerPtr                      = ObjPtr<Sampler>;
+using SamplerYcbcrConversionPtr       = ObjPtr<SamplerYcbcrConversion>;
+using SemaphorePtr                    = ObjPtr<Semaphore>;
+using ShaderModulePtr                 = ObjPtr<ShaderModule>;
+using ShaderProgramPtr                = ObjPtr<ShaderProgram>;
+using SparseImageFeedbackPtr          = ObjPtr<SparseImageFeedback>;
+using SurfacePtr                      = ObjPtr<Surface>;
+using SwapchainPtr                    = ObjPtr<Swapchain>;
+using TemporalResolvePtr              = ObjPtr<TemporalResolve>;
+using TextDrawPtr                     = ObjPtr<TextDraw>;
+using TexturePtr                      = ObjPtr<Texture>;
+using TextureFontPtr                  = ObjPtr<TextureFont>;
+using TransientAllocatorPtr           = ObjPtr<TransientAllocator>;
 
 using DepthStencilViewPtr = ObjPtr<DepthStencilView>;
 using RenderTargetViewPtr = ObjPtr<RenderTargetView>;
@@ -299,10 +332,31 @@ private:
 
 // -------------------------------------------------------------------------------------------------
 
+template <typename ObjectT>
+class ObjectTable;
+
+//! @class ObjectTableEntry
+//!
+//! Slot and generation of an object in a grfx::ObjectTable, so the table
+//! can find the object without searching.
+//!
+class ObjectTableEntry
+{
+private:
+    template <typename ObjectT>
+    friend class grfx::ObjectTable;
+
+    uint32_t mTableSlot       = UINT32_MAX;
+    uint32_t mTableGeneration = 0;
+};
+
+// -------------------------------------------------------------------------------------------------
+
 template <typename CreatInfoT>
 class DeviceObject
     : public CreateDestroyTraits<CreatInfoT>,
-      public NamedObjectTrait
+      public NamedObjectTrait,
+      public ObjectTableEntry
 {
 public:
     grfx::Device* GetDevice() const
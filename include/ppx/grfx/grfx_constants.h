@@ -36,9 +36,16 @@
 
 #define PPX_MAX_SETS_PER_POOL                   1024
 #define PPX_MAX_BOUND_DESCRIPTOR_SETS           32
+#define PPX_DESCRIPTOR_BUFFER_SIZE              (16 * 1024 * 1024)
 
 #define PPX_WHOLE_SIZE                          UINT64_MAX
 
+//
+// Occlusion predicates are written as 64-bit values, D3D12 predication
+// reads all 64 bits and Vulkan conditional rendering the low 32.
+//
+#define PPX_OCCLUSION_PREDICATE_SIZE            8
+
 //
 // This value is based on what the majority of the GPUs can
 // support in Vulkan. While D3D12 generally allows about 64
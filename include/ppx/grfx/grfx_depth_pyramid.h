@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_depth_pyramid_h
+#define ppx_grfx_depth_pyramid_h
+
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/math_config.h"
+
+#include <unordered_map>
+
+namespace ppx {
+namespace grfx {
+
+//! @struct DepthPyramidCreateInfo
+//!
+//!
+struct DepthPyramidCreateInfo
+{
+    uint32_t              width          = 0;  // Size of the depth images passed to Build()
+    uint32_t              height         = 0;
+    uint32_t              maxDepthImages = 4;  // Distinct depth images Build() is called with, e.g. swapchain image count
+    grfx::ShaderStageInfo CS             = {}; // Use basic/shaders/DepthPyramid.hlsl (csmain)
+};
+
+//! @class DepthPyramid
+//!
+//! Hierarchical depth (Hi-Z) pyramid of a depth image, for occlusion
+//! culling, screen space ray marching and anything else that needs the
+//! depth range of a screen region in a few fetches. Each texel stores the
+//! max depth of the region it covers in red and the min depth in green, so
+//! a Texture2D<float> reads the max chain.
+//!
+//! Level 0 is half the size of the depth image rounded up to a power of two
+//! in each dimension, so every level halves exactly and texel (x, y) of
+//! level n covers depth texels [x, x + 1) * 2^(n + 1). Depth UVs map to
+//! pyramid UVs through GetUVScale(), the padding repeats the edge of the
+//! depth image.
+//!
+//! Build() writes every level in a single dispatch: each workgroup reduces
+//! a 64x64 depth tile to levels 0 to 5, using subgroup lane reads for the
+//! 2x2 steps and shared memory across subgroups, and the last workgroup to
+//! finish reduces level 5 to the remaining levels. This requires subgroup
+//! shuffles (WaveReadLaneAt with a varying lane) and subgroups of at least
+//! 4 lanes, and limits depth images to kMaxDepthSize in each dimension.
+//!
+//! Descriptor sets are cached per depth image like scene::GpuCuller, so
+//! recreate the pyramid when the depth images are.
+//!
+class DepthPyramid
+    : public grfx::DeviceObject<grfx::DepthPyramidCreateInfo>
+{
+public:
+    static constexpr uint32_t kMaxLevelCount = 12;
+    static constexpr uint32_t kMaxDepthSize  = 1u << kMaxLevelCount;
+
+    DepthPyramid() {}
+    virtual ~DepthPyramid() {}
+
+    //! Builds the pyramid from pDepthImage, which must be in depthState and
+    //! is returned to it. Must be recorded outside of a render pass.
+    Result Build(grfx::CommandBuffer* pCommandBuffer, grfx::Image* pDepthImage, grfx::ResourceState depthState);
+    //! Builds the pyramid from the depth stencil target of pDrawPass
+    Result Build(grfx::CommandBuffer* pCommandBuffer, grfx::DrawPass* pDrawPass, grfx::ResourceState depthState);
+
+    //! In SHADER_RESOURCE outside of Build()
+    grfx::ImagePtr            GetImage() const { return mImage; }
+    grfx::SampledImageViewPtr GetSampledImageView() const { return mSampledView; } // All levels
+    uint32_t                  GetLevelCount() const { return mLevelCount; }
+    uint32_t                  GetWidth() const { return mWidth; } // Of level 0
+    uint32_t                  GetHeight() const { return mHeight; }
+    float2                    GetUVScale() const;
+
+    //! Returns the level 0 size and level count for a depth image size
+    static void GetSize(uint32_t depthWidth, uint32_t depthHeight, uint32_t* pWidth, uint32_t* pHeight, uint32_t* pLevelCount);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::DepthPyramidCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct DepthSource
+    {
+        grfx::SampledImageViewPtr view;
+        grfx::DescriptorSetPtr    set;
+    };
+
+    Result GetDepthSource(grfx::Image* pDepthImage, DepthSource** ppSource);
+
+private:
+    uint32_t                                      mWidth      = 0;
+    uint32_t                                      mHeight     = 0;
+    uint32_t                                      mLevelCount = 0;
+    grfx::ImagePtr                                mImage;
+    grfx::SampledImageViewPtr                     mSampledView;
+    std::vector<grfx::StorageImageViewPtr>        mStorageViews; // One per level
+    grfx::BufferPtr                               mCounterBuffer; // Workgroups done with levels 0 to 5
+    grfx::BufferPtr                               mCounterClearBuffer;
+    grfx::DescriptorPoolPtr                       mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr                  mSetLayout;
+    grfx::PipelineInterfacePtr                    mPipelineInterface;
+    grfx::ComputePipelinePtr                      mPipeline;
+    std::unordered_map<grfx::Image*, DepthSource> mDepthSources;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_depth_pyramid_h
@@ -17,6 +17,8 @@
 
 #include "ppx/grfx/grfx_config.h"
 
+#include <unordered_map>
+
 namespace ppx {
 namespace grfx {
 
@@ -55,15 +57,16 @@ struct DescriptorBinding
 
 struct WriteDescriptor
 {
-    uint32_t               binding                = PPX_VALUE_IGNORED;
-    uint32_t               arrayIndex             = 0;
-    grfx::DescriptorType   type                   = grfx::DESCRIPTOR_TYPE_UNDEFINED;
-    uint64_t               bufferOffset           = 0;
-    uint64_t               bufferRange            = 0;
-    uint32_t               structuredElementCount = 0;
-    const grfx::Buffer*    pBuffer                = nullptr;
-    const grfx::ImageView* pImageView             = nullptr;
-    const grfx::Sampler*   pSampler               = nullptr;
+    uint32_t                           binding                = PPX_VALUE_IGNORED;
+    uint32_t                           arrayIndex             = 0;
+    grfx::DescriptorType               type                   = grfx::DESCRIPTOR_TYPE_UNDEFINED;
+    uint64_t                           bufferOffset           = 0;
+    uint64_t                           bufferRange            = 0;
+    uint32_t                           structuredElementCount = 0;
+    const grfx::Buffer*                pBuffer                = nullptr;
+    const grfx::ImageView*             pImageView             = nullptr;
+    const grfx::Sampler*               pSampler               = nullptr;
+    const grfx::AccelerationStructure* pAccelerationStructure = nullptr; // Top level only
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -73,18 +76,19 @@ struct WriteDescriptor
 //!
 struct DescriptorPoolCreateInfo
 {
-    uint32_t sampler              = 0;
-    uint32_t combinedImageSampler = 0;
-    uint32_t sampledImage         = 0;
-    uint32_t storageImage         = 0;
-    uint32_t uniformTexelBuffer   = 0;
-    uint32_t storageTexelBuffer   = 0;
-    uint32_t uniformBuffer        = 0;
-    uint32_t rawStorageBuffer     = 0;
-    uint32_t structuredBuffer     = 0;
-    uint32_t uniformBufferDynamic = 0;
-    uint32_t storageBufferDynamic = 0;
-    uint32_t inputAttachment      = 0;
+    uint32_t sampler               = 0;
+    uint32_t combinedImageSampler  = 0;
+    uint32_t sampledImage          = 0;
+    uint32_t storageImage          = 0;
+    uint32_t uniformTexelBuffer    = 0;
+    uint32_t storageTexelBuffer    = 0;
+    uint32_t uniformBuffer         = 0;
+    uint32_t rawStorageBuffer      = 0;
+    uint32_t structuredBuffer      = 0;
+    uint32_t uniformBufferDynamic  = 0;
+    uint32_t storageBufferDynamic  = 0;
+    uint32_t inputAttachment       = 0;
+    uint32_t accelerationStructure = 0;
 };
 
 //! @class DescriptorPool
@@ -154,6 +158,22 @@ public:
         const grfx::Buffer* pBuffer,
         uint64_t            offset = 0,
         uint64_t            range  = PPX_WHOLE_SIZE);
+
+    Result UpdateAccelerationStructure(
+        uint32_t                           binding,
+        uint32_t                           arrayIndex,
+        const grfx::AccelerationStructure* pAccelerationStructure);
+
+protected:
+    // Keeps the last write of each binding and array index if the device
+    // allows defragmentation, so Device::Defragment() can rewrite the ones
+    // that reference moved resources. Backends call this once writes
+    // succeed.
+    void RecordWrites(uint32_t writeCount, const grfx::WriteDescriptor* pWrites);
+    friend class grfx::Device;
+
+private:
+    std::unordered_map<uint64_t, grfx::WriteDescriptor> mRecordedWrites; // Keyed by binding and array index
 };
 
 // -------------------------------------------------------------------------------------------------
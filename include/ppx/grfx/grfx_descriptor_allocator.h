@@ -0,0 +1,99 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_grfx_descriptor_allocator_h
+#define ppx_grfx_descriptor_allocator_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_descriptor.h"
+
+#include <unordered_map>
+
+namespace ppx {
+namespace grfx {
+
+//! @struct DescriptorAllocatorCreateInfo
+//!
+//! \b poolSizes is the capacity of each pool in the chain. A new pool of
+//! the same size is added whenever the current one can't hold a set.
+//!
+struct DescriptorAllocatorCreateInfo
+{
+    uint32_t                       frameCount  = 1;                     // Usually the number of frames in flight
+    uint32_t                       setsPerPool = PPX_MAX_SETS_PER_POOL; // Must not exceed PPX_MAX_SETS_PER_POOL
+    grfx::DescriptorPoolCreateInfo poolSizes   = {};                    // Descriptor counts per pool
+};
+
+//! @class DescriptorAllocator
+//!
+//! Frame scoped allocator for short lived descriptor sets, such as per-draw
+//! dynamic sets. Sets are carved out of a chain of descriptor pools that
+//! grows on demand and are handed back in bulk when their frame retires.
+//!
+//! Retired sets are recycled for later allocations that use the same
+//! layout rather than freed, so once the allocator has warmed up an
+//! allocation is a vector pop with no API calls. Recycled sets keep their
+//! old descriptors and must be fully written before use.
+//!
+//! The caller must make sure the GPU has finished with a frame before
+//! calling BeginFrame() for it. Layouts must outlive the allocator.
+//!
+class DescriptorAllocator
+    : public grfx::DeviceObject<grfx::DescriptorAllocatorCreateInfo>
+{
+public:
+    DescriptorAllocator() {}
+    virtual ~DescriptorAllocator() {}
+
+    uint32_t GetFrameIndex() const { return mFrameIndex; }
+    uint32_t GetPoolCount() const { return CountU32(mPools); }
+
+    // Recycles all sets allocated for frameIndex and makes it current
+    void BeginFrame(uint32_t frameIndex);
+
+    // Returns a set for pLayout that is valid until the current frame is recycled
+    Result Allocate(const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::DescriptorAllocatorCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct Pool
+    {
+        grfx::DescriptorPoolPtr        pool;
+        uint32_t                       setCount  = 0;
+        grfx::DescriptorPoolCreateInfo usedSizes = {};
+    };
+
+    using SetMap = std::unordered_map<const grfx::DescriptorSetLayout*, std::vector<grfx::DescriptorSetPtr>>;
+
+    struct Frame
+    {
+        SetMap usedSets;
+        SetMap freeSets;
+    };
+
+    Result AllocateFromPool(const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet);
+
+    std::vector<Pool>  mPools;
+    std::vector<Frame> mFrames;
+    uint32_t           mFrameIndex = 0;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_descriptor_allocator_h
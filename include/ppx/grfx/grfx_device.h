@@ -16,23 +16,47 @@
 #define ppx_grfx_device_h
 
 #include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_async_compute.h"
+#include "ppx/grfx/grfx_bindless_heap.h"
 #include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_buffer_pool.h"
 #include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_compute_batch.h"
 #include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_depth_pyramid.h"
+#include "ppx/grfx/grfx_descriptor_allocator.h"
 #include "ppx/grfx/grfx_draw_pass.h"
+#include "ppx/grfx/grfx_dynamic_resolution.h"
 #include "ppx/grfx/grfx_fullscreen_quad.h"
+#include "ppx/grfx/grfx_gpu_profiler.h"
 #include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_line_draw.h"
 #include "ppx/grfx/grfx_mesh.h"
+#include "ppx/grfx/grfx_object_table.h"
 #include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/grfx/grfx_pipeline_manifest.h"
+#include "ppx/grfx/grfx_post_process_chain.h"
 #include "ppx/grfx/grfx_queue.h"
 #include "ppx/grfx/grfx_query.h"
+#include "ppx/grfx/grfx_ray_tracing.h"
+#include "ppx/grfx/grfx_render_graph.h"
 #include "ppx/grfx/grfx_render_pass.h"
 #include "ppx/grfx/grfx_shader.h"
 #include "ppx/grfx/grfx_shading_rate.h"
+#include "ppx/grfx/grfx_sparse_feedback.h"
 #include "ppx/grfx/grfx_swapchain.h"
 #include "ppx/grfx/grfx_sync.h"
+#include "ppx/grfx/grfx_temporal_resolve.h"
 #include "ppx/grfx/grfx_text_draw.h"
 #include "ppx/grfx/grfx_texture.h"
+#include "ppx/grfx/grfx_transient_allocator.h"
+#include "ppx/timer.h"
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
 namespace ppx {
 namespace grfx {
@@ -42,19 +66,90 @@ namespace grfx {
 //!
 struct DeviceCreateInfo
 {
-    grfx::Gpu*               pGpu                   = nullptr;
-    uint32_t                 graphicsQueueCount     = 0;
-    uint32_t                 computeQueueCount      = 0;
-    uint32_t                 transferQueueCount     = 0;
-    std::vector<std::string> vulkanExtensions       = {};      // [OPTIONAL] Additional device extensions
-    const void*              pVulkanDeviceFeatures  = nullptr; // [OPTIONAL] Pointer to custom VkPhysicalDeviceFeatures
-    bool                     multiView              = false;   // [OPTIONAL] Whether to allow multiView features
-    ShadingRateMode          supportShadingRateMode = SHADING_RATE_NONE;
+    grfx::Gpu*               pGpu                      = nullptr;
+    uint32_t                 graphicsQueueCount        = 0;
+    uint32_t                 computeQueueCount         = 0;
+    uint32_t                 transferQueueCount        = 0;
+    std::vector<std::string> vulkanExtensions          = {};      // [OPTIONAL] Additional device extensions
+    const void*              pVulkanDeviceFeatures     = nullptr; // [OPTIONAL] Pointer to custom VkPhysicalDeviceFeatures
+    bool                     multiView                 = false;   // [OPTIONAL] Whether to allow multiView features
+    ShadingRateMode          supportShadingRateMode    = SHADING_RATE_NONE;
+    std::string              pipelineCachePath         = "";      // [OPTIONAL] File the pipeline cache is loaded from and saved to
+    uint32_t                 pipelineCompileThreads    = 0;       // [OPTIONAL] Threads used for async pipeline creation, 0 picks a default
+    std::string              pipelineManifestPath      = "";      // [OPTIONAL] See Device::PrecompilePipelines()
+    bool                     shaderModuleCache         = true;    // [OPTIONAL] See Device::CreateShaderModule()
+    bool                     samplerCache              = true;    // [OPTIONAL] See Device::CreateSampler()
+    bool                     renderPassCache           = true;    // [OPTIONAL] Share identical API render passes and framebuffers, Vulkan only
+    bool                     dynamicRenderPasses       = true;    // [OPTIONAL] See vk::Device::UsesDynamicRenderPasses(), Vulkan only
+    bool                     graphicsPipelineLibraries = true;    // [OPTIONAL] See vk::Device::UsesGraphicsPipelineLibraries(), Vulkan only
+    bool                     descriptorBuffers         = false;   // [OPTIONAL] See Device::DescriptorBuffersEnabled(), Vulkan only
+    bool                     defragmentation           = false;   // [OPTIONAL] Allows Device::Defragment()
 #if defined(PPX_BUILD_XR)
     XrComponent* pXrComponent = nullptr;
 #endif
 };
 
+//! @struct MemoryHeapStatistics
+//!
+//! usage and budget are for the whole process, including memory the
+//! allocator doesn't know about such as swapchain images. Without
+//! VK_EXT_memory_budget they're estimated by VMA. The block and allocation
+//! values only cover memory allocated through VMA or D3D12MA, the gap
+//! between blockBytes and allocationBytes is free or fragmented space.
+//!
+struct MemoryHeapStatistics
+{
+    bool     deviceLocal     = false;
+    uint64_t size            = 0;
+    uint64_t usage           = 0;
+    uint64_t budget          = 0;
+    uint32_t blockCount      = 0;
+    uint32_t allocationCount = 0;
+    uint64_t blockBytes      = 0;
+    uint64_t allocationBytes = 0;
+};
+
+//! @struct MemoryStatistics
+//!
+//!
+struct MemoryStatistics
+{
+    std::vector<grfx::MemoryHeapStatistics> heaps;
+};
+
+//! @struct DefragmentationInfo
+//!
+//! Limits of a Device::Defragment() call. Each pass moves up to
+//! maxBytesPerPass and maxAllocationsPerPass, 0 means no limit.
+//!
+//! grfx doesn't know the layout of images transitioned with explicit
+//! barriers, so images are only moved if imageState is set. It returns the
+//! state an image is in between frames, the same for all subresources, or
+//! RESOURCE_STATE_UNDEFINED to leave the image where it is.
+//!
+struct DefragmentationInfo
+{
+    uint64_t                                               maxBytesPerPass       = 64 * 1024 * 1024;
+    uint32_t                                               maxAllocationsPerPass = 0;
+    uint32_t                                               maxPasses             = 4;
+    std::function<grfx::ResourceState(const grfx::Image*)> imageState;
+};
+
+//! @struct DefragmentationStats
+//!
+//! Results of a Device::Defragment() call.
+//!
+struct DefragmentationStats
+{
+    uint32_t passCount        = 0;
+    uint32_t bufferMoveCount  = 0;
+    uint32_t imageMoveCount   = 0;
+    uint64_t bytesMoved       = 0;
+    uint64_t bytesFreed       = 0;
+    uint32_t blocksFreedCount = 0;     // Device memory allocations released
+    bool     complete         = false; // False if maxPasses ran out, call again to continue
+};
+
 //! @class Device
 //!
 //!
@@ -92,11 +187,17 @@ public:
     Result CreateDescriptorSetLayout(const grfx::DescriptorSetLayoutCreateInfo* pCreateInfo, grfx::DescriptorSetLayout** ppDescriptorSetLayout);
     void   DestroyDescriptorSetLayout(const grfx::DescriptorSetLayout* pDescriptorSetLayout);
 
+    Result CreateDepthPyramid(const grfx::DepthPyramidCreateInfo* pCreateInfo, grfx::DepthPyramid** ppDepthPyramid);
+    void   DestroyDepthPyramid(const grfx::DepthPyramid* pDepthPyramid);
+
     Result CreateDrawPass(const grfx::DrawPassCreateInfo* pCreateInfo, grfx::DrawPass** ppDrawPass);
     Result CreateDrawPass(const grfx::DrawPassCreateInfo2* pCreateInfo, grfx::DrawPass** ppDrawPass);
     Result CreateDrawPass(const grfx::DrawPassCreateInfo3* pCreateInfo, grfx::DrawPass** ppDrawPass);
     void   DestroyDrawPass(const grfx::DrawPass* pDrawPass);
 
+    Result CreateDynamicResolution(const grfx::DynamicResolutionCreateInfo* pCreateInfo, grfx::DynamicResolution** ppDynamicResolution);
+    void   DestroyDynamicResolution(const grfx::DynamicResolution* pDynamicResolution);
+
     Result CreateFence(const grfx::FenceCreateInfo* pCreateInfo, grfx::Fence** ppFence);
     void   DestroyFence(const grfx::Fence* pFence);
 
@@ -110,9 +211,27 @@ public:
     Result CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo2* pCreateInfo, grfx::GraphicsPipeline** ppGraphicsPipeline);
     void   DestroyGraphicsPipeline(const grfx::GraphicsPipeline* pGraphicsPipeline);
 
+    // Async variants of CreateComputePipeline and CreateGraphicsPipeline.
+    // The create info is copied and the pipeline is built on one of the
+    // device's compile threads; poll or wait on the returned handle to get
+    // it. Objects referenced by the create info (shader modules, pipeline
+    // interface) must stay alive until the handle is ready.
+    //
+    Result CreateComputePipelineAsync(const grfx::ComputePipelineCreateInfo* pCreateInfo, grfx::AsyncComputePipeline* pAsyncPipeline);
+    Result CreateGraphicsPipelineAsync(const grfx::GraphicsPipelineCreateInfo* pCreateInfo, grfx::AsyncGraphicsPipeline* pAsyncPipeline);
+    Result CreateGraphicsPipelineAsync(const grfx::GraphicsPipelineCreateInfo2* pCreateInfo, grfx::AsyncGraphicsPipeline* pAsyncPipeline);
+
+    // Runs task on one of the pipeline compile threads. Backends use this
+    // for pipeline work that can finish after the pipeline is created.
+    // Tasks that are queued when the device is destroyed still run.
+    void EnqueuePipelineCompileTask(std::function<void()>&& task);
+
     Result CreateImage(const grfx::ImageCreateInfo* pCreateInfo, grfx::Image** ppImage);
     void   DestroyImage(const grfx::Image* pImage);
 
+    Result CreateLineDraw(const grfx::LineDrawCreateInfo* pCreateInfo, grfx::LineDraw** ppLineDraw);
+    void   DestroyLineDraw(const grfx::LineDraw* pLineDraw);
+
     Result CreateMesh(const grfx::MeshCreateInfo* pCreateInfo, grfx::Mesh** ppMesh);
     void   DestroyMesh(const grfx::Mesh* pMesh);
 
@@ -133,18 +252,38 @@ public:
     Result CreateSampledImageView(const grfx::SampledImageViewCreateInfo* pCreateInfo, grfx::SampledImageView** ppSampledImageView);
     void   DestroySampledImageView(const grfx::SampledImageView* pSampledImageView);
 
+    //! With DeviceCreateInfo::samplerCache, samplers with OWNERSHIP_REFERENCE
+    //! are cached by their create info: creating an identical sampler returns
+    //! the existing one and DestroySampler() only destroys a sampler once
+    //! every create of it has been matched by a destroy. Some mobile drivers
+    //! limit the number of live samplers to a few thousand.
     Result CreateSampler(const grfx::SamplerCreateInfo* pCreateInfo, grfx::Sampler** ppSampler);
     void   DestroySampler(const grfx::Sampler* pSampler);
 
+    uint64_t GetSamplerCacheHitCount() const { return mSamplerCacheHitCount; }
+    uint64_t GetSamplerCacheMissCount() const { return mSamplerCacheMissCount; }
+
     Result CreateSamplerYcbcrConversion(const grfx::SamplerYcbcrConversionCreateInfo* pCreateInfo, grfx::SamplerYcbcrConversion** ppConversion);
     void   DestroySamplerYcbcrConversion(const grfx::SamplerYcbcrConversion* pConversion);
 
     Result CreateSemaphore(const grfx::SemaphoreCreateInfo* pCreateInfo, grfx::Semaphore** ppSemaphore);
     void   DestroySemaphore(const grfx::Semaphore* pSemaphore);
 
+    //! With DeviceCreateInfo::shaderModuleCache, modules are cached by the
+    //! XXH3 hash of their bytecode: creating the same bytecode again returns
+    //! the existing module and DestroyShaderModule() only destroys a module
+    //! once every create of it has been matched by a destroy.
     Result CreateShaderModule(const grfx::ShaderModuleCreateInfo* pCreateInfo, grfx::ShaderModule** ppShaderModule);
     void   DestroyShaderModule(const grfx::ShaderModule* pShaderModule);
 
+    uint64_t GetShaderModuleCacheHitCount() const { return mShaderModuleCacheHitCount; }
+    uint64_t GetShaderModuleCacheMissCount() const { return mShaderModuleCacheMissCount; }
+
+    //! Total CPU time spent in CreateShaderModule() and in the synchronous
+    //! pipeline creates, pipelines compiled by the async threads aren't counted.
+    double GetShaderModuleCreateTimeMs() const { return Timer::TimestampToMillis(mShaderModuleCreateTime); }
+    double GetPipelineCreateTimeMs() const { return Timer::TimestampToMillis(mPipelineCreateTime); }
+
     Result CreateStorageImageView(const grfx::StorageImageViewCreateInfo* pCreateInfo, grfx::StorageImageView** ppStorageImageView);
     void   DestroyStorageImageView(const grfx::StorageImageView* pStorageImageView);
 
@@ -157,9 +296,42 @@ public:
     Result CreateTexture(const grfx::TextureCreateInfo* pCreateInfo, grfx::Texture** ppTexture);
     void   DestroyTexture(const grfx::Texture* pTexture);
 
+    Result CreateTemporalResolve(const grfx::TemporalResolveCreateInfo* pCreateInfo, grfx::TemporalResolve** ppTemporalResolve);
+    void   DestroyTemporalResolve(const grfx::TemporalResolve* pTemporalResolve);
+
     Result CreateTextureFont(const grfx::TextureFontCreateInfo* pCreateInfo, grfx::TextureFont** ppTextureFont);
     void   DestroyTextureFont(const grfx::TextureFont* pTextureFont);
 
+    Result CreateTransientAllocator(const grfx::TransientAllocatorCreateInfo* pCreateInfo, grfx::TransientAllocator** ppTransientAllocator);
+    void   DestroyTransientAllocator(const grfx::TransientAllocator* pTransientAllocator);
+
+    Result CreateRenderGraph(const grfx::RenderGraphCreateInfo* pCreateInfo, grfx::RenderGraph** ppRenderGraph);
+    void   DestroyRenderGraph(const grfx::RenderGraph* pRenderGraph);
+
+    Result CreatePostProcessChain(const grfx::PostProcessChainCreateInfo* pCreateInfo, grfx::PostProcessChain** ppChain);
+    void   DestroyPostProcessChain(const grfx::PostProcessChain* pChain);
+
+    Result CreateBufferPool(const grfx::BufferPoolCreateInfo* pCreateInfo, grfx::BufferPool** ppBufferPool);
+    void   DestroyBufferPool(const grfx::BufferPool* pBufferPool);
+
+    Result CreateAsyncComputeScheduler(const grfx::AsyncComputeSchedulerCreateInfo* pCreateInfo, grfx::AsyncComputeScheduler** ppScheduler);
+    void   DestroyAsyncComputeScheduler(const grfx::AsyncComputeScheduler* pScheduler);
+
+    Result CreateComputeBatchRunner(const grfx::ComputeBatchRunnerCreateInfo* pCreateInfo, grfx::ComputeBatchRunner** ppRunner);
+    void   DestroyComputeBatchRunner(const grfx::ComputeBatchRunner* pRunner);
+
+    Result CreateGpuProfiler(const grfx::GpuProfilerCreateInfo* pCreateInfo, grfx::GpuProfiler** ppProfiler);
+    void   DestroyGpuProfiler(const grfx::GpuProfiler* pProfiler);
+
+    Result CreateSparseImageFeedback(const grfx::SparseImageFeedbackCreateInfo* pCreateInfo, grfx::SparseImageFeedback** ppFeedback);
+    void   DestroySparseImageFeedback(const grfx::SparseImageFeedback* pFeedback);
+
+    Result CreateBindlessHeap(const grfx::BindlessHeapCreateInfo* pCreateInfo, grfx::BindlessHeap** ppBindlessHeap);
+    void   DestroyBindlessHeap(const grfx::BindlessHeap* pBindlessHeap);
+
+    Result CreateDescriptorAllocator(const grfx::DescriptorAllocatorCreateInfo* pCreateInfo, grfx::DescriptorAllocator** ppDescriptorAllocator);
+    void   DestroyDescriptorAllocator(const grfx::DescriptorAllocator* pDescriptorAllocator);
+
     // See comment section for grfx::internal::CommandBufferCreateInfo for
     // details about 'resourceDescriptorCount' and 'samplerDescriptorCount'.
     //
@@ -167,12 +339,44 @@ public:
         const grfx::CommandPool* pPool,
         grfx::CommandBuffer**    ppCommandBuffer,
         uint32_t                 resourceDescriptorCount = PPX_DEFAULT_RESOURCE_DESCRIPTOR_COUNT,
-        uint32_t                 samplerDescriptorCount  = PPX_DEFAULT_SAMPLE_DESCRIPTOR_COUNT);
+        uint32_t                 samplerDescriptorCount  = PPX_DEFAULT_SAMPLE_DESCRIPTOR_COUNT,
+        bool                     secondary               = false,
+        bool                     reusable                = false);
     void FreeCommandBuffer(const grfx::CommandBuffer* pCommandBuffer);
 
     Result AllocateDescriptorSet(grfx::DescriptorPool* pPool, const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet);
     void   FreeDescriptorSet(const grfx::DescriptorSet* pSet);
 
+    // Deferred variants of the destroy functions above for objects that
+    // work already submitted, or submitted until the next call to
+    // ProcessDeferredDestroys(), may still use. Objects are destroyed once
+    // that work has completed, without waiting for the device to idle.
+    //
+    void DeferDestroyBuffer(const grfx::Buffer* pBuffer);
+    // For command buffers created by a grfx::Queue
+    void DeferDestroyCommandBuffer(const grfx::CommandBuffer* pCommandBuffer);
+    void DeferDestroyComputePipeline(const grfx::ComputePipeline* pComputePipeline);
+    void DeferDestroyDrawPass(const grfx::DrawPass* pDrawPass);
+    void DeferDestroyGraphicsPipeline(const grfx::GraphicsPipeline* pGraphicsPipeline);
+    void DeferDestroyImage(const grfx::Image* pImage);
+    void DeferDestroyTexture(const grfx::Texture* pTexture);
+    void DeferFreeDescriptorSet(const grfx::DescriptorSet* pSet);
+
+    // Fences the work submitted to all queues so far for the objects
+    // deferred since the last call, then destroys the objects whose fences
+    // have signaled. Call once per frame after the frame's submits,
+    // ppx::Application does this at the end of each frame.
+    //
+    Result ProcessDeferredDestroys();
+    // Waits for and destroys all deferred objects
+    void FlushDeferredDestroys();
+
+    uint32_t GetDeferredDestroyCount() const;
+
+    // Fences and binary semaphores recycled across submits, also used for
+    // the deferred destroy fences. Emptied when the device is destroyed.
+    grfx::SyncPool* GetSyncPool() { return &mSyncPool; }
+
     uint32_t       GetGraphicsQueueCount() const;
     Result         GetGraphicsQueue(uint32_t index, grfx::Queue** ppQueue) const;
     grfx::QueuePtr GetGraphicsQueue(uint32_t index = 0) const;
@@ -187,6 +391,12 @@ public:
 
     grfx::QueuePtr GetAnyAvailableQueue() const;
 
+    Result CreateAccelerationStructure(const grfx::AccelerationStructureCreateInfo* pCreateInfo, grfx::AccelerationStructure** ppAccelerationStructure);
+    void   DestroyAccelerationStructure(const grfx::AccelerationStructure* pAccelerationStructure);
+
+    Result CreateAccelerationStructureBuilder(const grfx::AccelerationStructureBuilderCreateInfo* pCreateInfo, grfx::AccelerationStructureBuilder** ppBuilder);
+    void   DestroyAccelerationStructureBuilder(const grfx::AccelerationStructureBuilder* pBuilder);
+
     const grfx::ShadingRateCapabilities& GetShadingRateCapabilities() const { return mShadingRateCapabilities; }
 
     virtual Result WaitIdle()                                 = 0;
@@ -195,14 +405,114 @@ public:
     virtual bool   DynamicRenderingSupported() const          = 0;
     virtual bool   IndependentBlendingSupported() const       = 0;
     virtual bool   FragmentStoresAndAtomicsSupported() const  = 0;
+    virtual bool   TessellationShaderSupported() const        = 0;
+    virtual bool   GeometryShaderSupported() const            = 0;
     virtual bool   PartialDescriptorBindingsSupported() const = 0;
+    // Descriptor set layouts with flags.bits.pushable
+    virtual bool   PushDescriptorsSupported() const           = 0;
     virtual bool   IndexTypeUint8Supported() const            = 0;
+    virtual bool   DrawIndirectCountSupported() const         = 0;
+    virtual bool   MeshShaderSupported() const                = 0;
+    // Task shader on Vulkan, only valid if MeshShaderSupported() is true
+    virtual bool   AmplificationShaderSupported() const       = 0;
+    virtual bool   AccelerationStructureSupported() const     = 0;
+    // Buffers with shaderDeviceAddress usage, see Buffer::GetDeviceAddress()
+    virtual bool   BufferDeviceAddressSupported() const       = 0;
+    // Inline ray tracing from any shader stage, only valid if
+    // AccelerationStructureSupported() is true
+    virtual bool   RayQuerySupported() const                  = 0;
+    virtual bool   TimelineSemaphoreSupported() const         = 0;
+    // Dynamic cull mode, primitive topology and depth test/write enable,
+    // see grfx::DynamicState
+    virtual bool   ExtendedDynamicStateSupported() const      = 0;
+    virtual bool   DynamicBlendEnableSupported() const        = 0;
+    // Pipelines created with shaderObjects bind shader objects and set
+    // their state dynamically, see grfx::GraphicsPipelineCreateInfo
+    virtual bool   ShaderObjectsSupported() const             = 0;
+    // Descriptor sets are written straight into descriptor buffer memory
+    // and bound by offset instead of allocated from API descriptor pools.
+    // Only enabled if requested with DeviceCreateInfo::descriptorBuffers,
+    // layouts with dynamic uniform or storage buffers can't be created then.
+    virtual bool   DescriptorBuffersEnabled() const           = 0;
+    // Draws and dispatches skipped on the GPU by a predicate, see
+    // CommandBuffer::BeginConditionalRendering()
+    virtual bool   ConditionalRenderingSupported() const      = 0;
+
+    // Whether images of format can be created with hostUpload, see
+    // grfx::ImageCreateInfo
+    virtual bool   ImageHostUploadSupported(grfx::ImageHostUpload hostUpload, grfx::Format format) const = 0;
+
+    // Whether optimally tiled images of format can be sampled, block
+    // compressed formats vary between desktop and mobile GPUs
+    virtual bool   SampledImageFormatSupported(grfx::Format format) const = 0;
+
+    // Whether optimally tiled 2D render targets or depth stencil targets of
+    // format can be created with sampleCount
+    virtual bool   RenderTargetSampleCountSupported(grfx::Format format, grfx::SampleCount sampleCount) const = 0;
+
+    // Whether render targets of format support blending, 32-bit float
+    // formats often don't on mobile GPUs
+    virtual bool   RenderTargetBlendSupported(grfx::Format format) const = 0;
+
+    // Whether optimally tiled 2D images of format can be created with
+    // compression, see grfx::ImageCreateInfo
+    virtual bool   ImageCompressionSupported(grfx::Format format, grfx::ImageCompression compression) const = 0;
+
+    // Sparse resident 2D images and Queue::BindSparseImageTiles() on the
+    // graphics queue, see grfx::ImageCreateInfo::sparseResidency
+    virtual bool   SparseResidencySupported() const = 0;
+
+    // Sizes of the acceleration structure and of the scratch memory needed
+    // to build or update it from pInputs. Only the counts, formats and
+    // flags of pInputs are used, buffers can be null.
+    //
+    virtual Result GetAccelerationStructureBuildSizes(const grfx::AccelerationStructureBuildInputs* pInputs, grfx::AccelerationStructureBuildSizes* pSizes) const = 0;
+
+    // Current usage and budget of each memory heap. Cheap enough to call
+    // every frame.
+    //
+    virtual Result GetMemoryStatistics(grfx::MemoryStatistics* pStatistics) const = 0;
+
+    // Compacts the memory heaps by moving GPU only buffers and images into
+    // fewer blocks, for long running sessions that load and unload content.
+    // Requires DeviceCreateInfo::defragmentation. Waits for the device to
+    // idle and flushes deferred destroys, so call it between frames, e.g.
+    // once per idle frame after unloading a scene until pStats->complete.
+    //
+    // Moved resources keep their grfx objects: the views and render passes
+    // of moved images are recreated and the descriptor sets that reference
+    // moved resources are rewritten. Command buffers recorded before the
+    // call must be recorded again and API handles of moved resources that
+    // were obtained before the call are stale. Host visible, aliased,
+    // sparse and external resources and buffers with device addresses
+    // aren't moved.
+    //
+    Result Defragment(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats = nullptr);
+    bool   IsDefragmentationEnabled() const { return mCreateInfo.defragmentation; }
+
+    // Writes the contents of the pipeline cache to
+    // DeviceCreateInfo::pipelineCachePath. This is a no-op if no
+    // path was specified. Backends also call this when the device
+    // is destroyed.
+    //
+    virtual Result SavePipelineCache() = 0;
+
+    // Pipelines created by the device are recorded to a manifest at
+    // DeviceCreateInfo::pipelineManifestPath, which is loaded when the
+    // device is created and saved when it's destroyed. PrecompilePipelines()
+    // creates every pipeline of the manifest on the pipeline compile
+    // threads and waits for them, so the pipeline cache has them before
+    // the first frame. Both are no-ops if no path was specified.
+    //
+    Result SavePipelineManifest();
+    Result PrecompilePipelines(uint32_t* pPipelineCount = nullptr);
 
 protected:
     virtual Result Create(const grfx::DeviceCreateInfo* pCreateInfo) override;
     virtual void   Destroy() override;
     friend class grfx::Instance;
 
+    virtual Result AllocateObject(grfx::AccelerationStructure** ppObject)  = 0;
     virtual Result AllocateObject(grfx::Buffer** ppObject)                 = 0;
     virtual Result AllocateObject(grfx::CommandBuffer** ppObject)          = 0;
     virtual Result AllocateObject(grfx::CommandPool** ppObject)            = 0;
@@ -229,67 +539,181 @@ protected:
     virtual Result AllocateObject(grfx::StorageImageView** ppObject)       = 0;
     virtual Result AllocateObject(grfx::Swapchain** ppObject)              = 0;
 
+    virtual Result AllocateObject(grfx::AccelerationStructureBuilder** ppObject);
+    virtual Result AllocateObject(grfx::BindlessHeap** ppObject);
+    virtual Result AllocateObject(grfx::DepthPyramid** ppObject);
+    virtual Result AllocateObject(grfx::DescriptorAllocator** ppObject);
     virtual Result AllocateObject(grfx::DrawPass** ppObject);
+    virtual Result AllocateObject(grfx::DynamicResolution** ppObject);
     virtual Result AllocateObject(grfx::FullscreenQuad** ppObject);
+    virtual Result AllocateObject(grfx::LineDraw** ppObject);
     virtual Result AllocateObject(grfx::Mesh** ppObject);
+    virtual Result AllocateObject(grfx::TemporalResolve** ppObject);
     virtual Result AllocateObject(grfx::TextDraw** ppObject);
     virtual Result AllocateObject(grfx::Texture** ppObject);
     virtual Result AllocateObject(grfx::TextureFont** ppObject);
-
+    virtual Result AllocateObject(grfx::TransientAllocator** ppObject);
+    virtual Result AllocateObject(grfx::RenderGraph** ppObject);
+    virtual Result AllocateObject(grfx::PostProcessChain** ppObject);
+    virtual Result AllocateObject(grfx::BufferPool** ppObject);
+    virtual Result AllocateObject(grfx::AsyncComputeScheduler** ppObject);
+    virtual Result AllocateObject(grfx::ComputeBatchRunner** ppObject);
+    virtual Result AllocateObject(grfx::GpuProfiler** ppObject);
+    virtual Result AllocateObject(grfx::SparseImageFeedback** ppObject);
+
+    // pContainerMutex is only needed for containers that are also
+    // modified from the pipeline compile threads. Containers are object
+    // tables, except for the queues which are indexed.
+    //
     template <
         typename ObjectT,
         typename CreateInfoT,
-        typename ContainerT = std::vector<ObjPtr<ObjectT>>>
-    Result CreateObject(const CreateInfoT* pCreateInfo, ContainerT& container, ObjectT** ppObject);
+        typename ContainerT = grfx::ObjectTable<ObjectT>>
+    Result CreateObject(const CreateInfoT* pCreateInfo, ContainerT& container, ObjectT** ppObject, std::mutex* pContainerMutex = nullptr);
 
     template <
         typename ObjectT,
-        typename ContainerT = std::vector<ObjPtr<ObjectT>>>
-    void DestroyObject(ContainerT& container, const ObjectT* pObject);
+        typename ContainerT = grfx::ObjectTable<ObjectT>>
+    void DestroyObject(ContainerT& container, const ObjectT* pObject, std::mutex* pContainerMutex = nullptr);
 
+    template <
+        typename ObjectT,
+        typename CreateInfoT>
+    Result CreatePipelineAsync(const CreateInfoT* pCreateInfo, grfx::ObjectTable<ObjectT>& container, grfx::AsyncPipeline<ObjectT>* pAsyncPipeline);
+
+    template <typename ObjectT>
+    void DestroyAllObjects(grfx::ObjectTable<ObjectT>& container);
     template <typename ObjectT>
     void DestroyAllObjects(std::vector<ObjPtr<ObjectT>>& container);
 
+    // Moves allocations for Defragment() with the device idle. Backends
+    // call UpdateMovedResourceReferences() after each pass, once the moved
+    // resources have their new API objects.
+    virtual Result DefragmentApiObjects(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats) = 0;
+
+    // Recreates the views and render passes of images and rewrites the
+    // descriptors that reference buffers or those views
+    Result UpdateMovedResourceReferences(const std::vector<grfx::Buffer*>& buffers, const std::vector<grfx::Image*>& images);
+
     Result CreateGraphicsQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue);
     Result CreateComputeQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue);
     Result CreateTransferQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue);
 
+private:
+    // Creates an uncached shader module and records it to the pipeline manifest
+    Result CreateRecordedShaderModule(const grfx::ShaderModuleCreateInfo* pCreateInfo, grfx::ShaderModule** ppShaderModule);
+
+    void StartPipelineCompileThreads();
+    void StopPipelineCompileThreads();
+    void PipelineCompileThreadMain();
+
 protected:
-    grfx::InstancePtr                            mInstance;
-    std::vector<grfx::BufferPtr>                 mBuffers;
-    std::vector<grfx::CommandBufferPtr>          mCommandBuffers;
-    std::vector<grfx::CommandPoolPtr>            mCommandPools;
-    std::vector<grfx::ComputePipelinePtr>        mComputePipelines;
-    std::vector<grfx::DepthStencilViewPtr>       mDepthStencilViews;
-    std::vector<grfx::DescriptorPoolPtr>         mDescriptorPools;
-    std::vector<grfx::DescriptorSetPtr>          mDescriptorSets;
-    std::vector<grfx::DescriptorSetLayoutPtr>    mDescriptorSetLayouts;
-    std::vector<grfx::DrawPassPtr>               mDrawPasses;
-    std::vector<grfx::FencePtr>                  mFences;
-    std::vector<grfx::ShadingRatePatternPtr>     mShadingRatePatterns;
-    std::vector<grfx::FullscreenQuadPtr>         mFullscreenQuads;
-    std::vector<grfx::GraphicsPipelinePtr>       mGraphicsPipelines;
-    std::vector<grfx::ImagePtr>                  mImages;
-    std::vector<grfx::MeshPtr>                   mMeshes;
-    std::vector<grfx::PipelineInterfacePtr>      mPipelineInterfaces;
-    std::vector<grfx::QueryPtr>                  mQuerys;
-    std::vector<grfx::RenderPassPtr>             mRenderPasses;
-    std::vector<grfx::RenderTargetViewPtr>       mRenderTargetViews;
-    std::vector<grfx::SampledImageViewPtr>       mSampledImageViews;
-    std::vector<grfx::SamplerPtr>                mSamplers;
-    std::vector<grfx::SamplerYcbcrConversionPtr> mSamplerYcbcrConversions;
-    std::vector<grfx::SemaphorePtr>              mSemaphores;
-    std::vector<grfx::ShaderModulePtr>           mShaderModules;
-    std::vector<grfx::ShaderProgramPtr>          mShaderPrograms;
-    std::vector<grfx::StorageImageViewPtr>       mStorageImageViews;
-    std::vector<grfx::SwapchainPtr>              mSwapchains;
-    std::vector<grfx::TextDrawPtr>               mTextDraws;
-    std::vector<grfx::TexturePtr>                mTextures;
-    std::vector<grfx::TextureFontPtr>            mTextureFonts;
-    std::vector<grfx::QueuePtr>                  mGraphicsQueues;
-    std::vector<grfx::QueuePtr>                  mComputeQueues;
-    std::vector<grfx::QueuePtr>                  mTransferQueues;
-    grfx::ShadingRateCapabilities                mShadingRateCapabilities;
+    grfx::InstancePtr                                     mInstance;
+    grfx::ObjectTable<grfx::Buffer>                       mBuffers;
+    grfx::ObjectTable<grfx::CommandBuffer>                mCommandBuffers;
+    grfx::ObjectTable<grfx::CommandPool>                  mCommandPools;
+    grfx::ObjectTable<grfx::ComputePipeline>              mComputePipelines;
+    grfx::ObjectTable<grfx::DepthPyramid>                 mDepthPyramids;
+    grfx::ObjectTable<grfx::DepthStencilView>             mDepthStencilViews;
+    grfx::ObjectTable<grfx::DescriptorPool>               mDescriptorPools;
+    grfx::ObjectTable<grfx::DescriptorSet>                mDescriptorSets;
+    grfx::ObjectTable<grfx::DescriptorSetLayout>          mDescriptorSetLayouts;
+    grfx::ObjectTable<grfx::DrawPass>                     mDrawPasses;
+    grfx::ObjectTable<grfx::DynamicResolution>            mDynamicResolutions;
+    grfx::ObjectTable<grfx::Fence>                        mFences;
+    grfx::ObjectTable<grfx::ShadingRatePattern>           mShadingRatePatterns;
+    grfx::ObjectTable<grfx::FullscreenQuad>               mFullscreenQuads;
+    grfx::ObjectTable<grfx::GraphicsPipeline>             mGraphicsPipelines;
+    grfx::ObjectTable<grfx::Image>                        mImages;
+    grfx::ObjectTable<grfx::LineDraw>                     mLineDraws;
+    grfx::ObjectTable<grfx::Mesh>                         mMeshes;
+    grfx::ObjectTable<grfx::PipelineInterface>            mPipelineInterfaces;
+    grfx::ObjectTable<grfx::Query>                        mQuerys;
+    grfx::ObjectTable<grfx::RenderPass>                   mRenderPasses;
+    grfx::ObjectTable<grfx::RenderTargetView>             mRenderTargetViews;
+    grfx::ObjectTable<grfx::SampledImageView>             mSampledImageViews;
+    grfx::ObjectTable<grfx::Sampler>                      mSamplers;
+    grfx::ObjectTable<grfx::SamplerYcbcrConversion>       mSamplerYcbcrConversions;
+    grfx::ObjectTable<grfx::Semaphore>                    mSemaphores;
+    grfx::ObjectTable<grfx::ShaderModule>                 mShaderModules;
+    grfx::ObjectTable<grfx::ShaderProgram>                mShaderPrograms;
+    grfx::ObjectTable<grfx::StorageImageView>             mStorageImageViews;
+    grfx::ObjectTable<grfx::Swapchain>                    mSwapchains;
+    grfx::ObjectTable<grfx::TemporalResolve>              mTemporalResolves;
+    grfx::ObjectTable<grfx::TextDraw>                     mTextDraws;
+    grfx::ObjectTable<grfx::Texture>                      mTextures;
+    grfx::ObjectTable<grfx::TextureFont>                  mTextureFonts;
+    grfx::ObjectTable<grfx::TransientAllocator>           mTransientAllocators;
+    grfx::ObjectTable<grfx::RenderGraph>                  mRenderGraphs;
+    grfx::ObjectTable<grfx::PostProcessChain>             mPostProcessChains;
+    grfx::ObjectTable<grfx::BufferPool>                   mBufferPools;
+    grfx::ObjectTable<grfx::AsyncComputeScheduler>        mAsyncComputeSchedulers;
+    grfx::ObjectTable<grfx::ComputeBatchRunner>           mComputeBatchRunners;
+    grfx::ObjectTable<grfx::GpuProfiler>                  mGpuProfilers;
+    grfx::ObjectTable<grfx::SparseImageFeedback>          mSparseImageFeedbacks;
+    grfx::ObjectTable<grfx::BindlessHeap>                 mBindlessHeaps;
+    grfx::ObjectTable<grfx::DescriptorAllocator>          mDescriptorAllocators;
+    grfx::ObjectTable<grfx::AccelerationStructure>        mAccelerationStructures;
+    grfx::ObjectTable<grfx::AccelerationStructureBuilder> mAccelerationStructureBuilders;
+    std::vector<grfx::QueuePtr>                           mGraphicsQueues;
+    std::vector<grfx::QueuePtr>                           mComputeQueues;
+    std::vector<grfx::QueuePtr>                           mTransferQueues;
+    grfx::ShadingRateCapabilities                         mShadingRateCapabilities;
+
+    // Shader module cache, keyed by the XXH3 hash of the bytecode
+    struct CachedShaderModule
+    {
+        grfx::ShaderModule* pShaderModule = nullptr;
+        uint32_t            size          = 0;
+        uint32_t            refCount      = 0;
+    };
+    std::unordered_map<uint64_t, CachedShaderModule> mShaderModuleCache;
+    uint64_t                                         mShaderModuleCacheHitCount  = 0;
+    uint64_t                                         mShaderModuleCacheMissCount = 0;
+
+    // Sampler cache, keyed by the XXH3 hash of the create info fields
+    using SamplerKey = std::array<uint64_t, 16>;
+    struct CachedSampler
+    {
+        grfx::Sampler* pSampler = nullptr;
+        SamplerKey     key      = {};
+        uint32_t       refCount = 0;
+    };
+    std::unordered_map<uint64_t, CachedSampler> mSamplerCache;
+    uint64_t                                    mSamplerCacheHitCount  = 0;
+    uint64_t                                    mSamplerCacheMissCount = 0;
+
+    // Timer timestamp ticks spent creating shader modules and pipelines
+    uint64_t mShaderModuleCreateTime = 0;
+    uint64_t mPipelineCreateTime     = 0;
+
+private:
+    void DeferDestroy(std::function<void()>&& destroy);
+
+private:
+    // Deferred destroys, pending ones haven't been fenced yet
+    struct DeferredDestroyBatch
+    {
+        std::vector<grfx::FencePtr>        fences; // One per queue
+        std::vector<std::function<void()>> destroys;
+    };
+    mutable std::mutex                 mDeferredDestroyMutex;
+    std::vector<std::function<void()>> mPendingDestroys;
+    std::deque<DeferredDestroyBatch>   mDeferredDestroyBatches;
+
+    grfx::SyncPool mSyncPool;
+
+    // Guards mComputePipelines and mGraphicsPipelines, which are also
+    // modified by the pipeline compile threads.
+    std::mutex                        mPipelineContainerMutex;
+    std::vector<std::thread>          mPipelineCompileThreads;
+    std::deque<std::function<void()>> mPipelineCompileTasks;
+    std::mutex                        mPipelineCompileMutex;
+    std::condition_variable           mPipelineCompileCondition;
+    bool                              mStopPipelineCompileThreads = false;
+
+    // Null if DeviceCreateInfo::pipelineManifestPath is empty
+    std::unique_ptr<grfx::PipelineManifest> mPipelineManifest;
 };
 
 } // namespace grfx
@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_dynamic_resolution_h
+#define ppx_grfx_dynamic_resolution_h
+
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/dynamic_resolution.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct DynamicResolutionCreateInfo
+//!
+//!
+struct DynamicResolutionCreateInfo
+{
+    grfx::Queue*                               pQueue             = nullptr; // Queue the frames are submitted to
+    uint32_t                                   frameCount         = 1;       // Usually the number of frames in flight
+    uint32_t                                   width              = 0;       // Full resolution, usually the swapchain's
+    uint32_t                                   height             = 0;
+    grfx::Format                               renderTargetFormat = grfx::FORMAT_UNDEFINED;
+    grfx::Format                               depthStencilFormat = grfx::FORMAT_UNDEFINED;
+    grfx::Format                               outputFormat       = grfx::FORMAT_UNDEFINED; // Render target format of the pass Upscale() draws into
+    grfx::ShaderStageInfo                      VS                 = {};                     // Use basic/shaders/DynamicResolutionUpscale.hlsl (vsmain)
+    grfx::ShaderStageInfo                      PS                 = {};                     // Use basic/shaders/DynamicResolutionUpscale.hlsl (psmain)
+    ppx::DynamicResolutionControllerCreateInfo controller         = {};
+};
+
+//! @class DynamicResolution
+//!
+//! Renders at a scale of the full resolution that DynamicResolutionController
+//! picks from the measured GPU frame time. The draw pass is allocated at
+//! full resolution once and each frame only renders to its top left
+//! GetRenderWidth() x GetRenderHeight() corner, so changing the scale
+//! doesn't create any images. Upscale() stretches that corner over the
+//! render pass it's recorded in with a bilinear full screen triangle.
+//!
+//! The GPU frame time is the time between the timestamps BeginFrame() and
+//! EndFrame() write, read back frameCount frames later. BeginFrame() for a
+//! frame index requires the previous work recorded with that index to have
+//! completed.
+//!
+//! Typical frame:
+//!   BeginFrame(cmd, frameIndex)
+//!   render to GetDrawPass() with GetRenderViewport() and GetRenderScissor()
+//!   transition the draw pass render target to SHADER_RESOURCE
+//!   begin the swapchain render pass, Upscale(cmd), end it
+//!   EndFrame(cmd)
+//!
+class DynamicResolution
+    : public grfx::DeviceObject<grfx::DynamicResolutionCreateInfo>
+{
+public:
+    DynamicResolution() {}
+    virtual ~DynamicResolution() {}
+
+    //! Reads back the GPU time of frameIndex's previous use, updates the
+    //! render size and writes the begin timestamp
+    void BeginFrame(grfx::CommandBuffer* pCommandBuffer, uint32_t frameIndex);
+    //! Writes the end timestamp, outside of a render pass
+    void EndFrame(grfx::CommandBuffer* pCommandBuffer);
+
+    //! Draws the rendered corner of the draw pass over the current render
+    //! pass, viewport and scissor must cover the output
+    void Upscale(grfx::CommandBuffer* pCommandBuffer);
+
+    //! Recreates the draw pass at a new full resolution. The old one is
+    //! destroyed with Device::DeferDestroyDrawPass().
+    Result Resize(uint32_t width, uint32_t height);
+
+    grfx::DrawPassPtr GetDrawPass() const { return mDrawPass; }
+    uint32_t          GetWidth() const { return mCreateInfo.width; }
+    uint32_t          GetHeight() const { return mCreateInfo.height; }
+    uint32_t          GetRenderWidth() const { return mRenderWidth; }
+    uint32_t          GetRenderHeight() const { return mRenderHeight; }
+    grfx::Rect        GetRenderScissor() const;
+    grfx::Viewport    GetRenderViewport(float minDepth = 0.0f, float maxDepth = 1.0f) const;
+
+    //! GPU time of the last frame read back, 0 until the first one is
+    float GetGpuFrameTimeMs() const { return mGpuFrameTimeMs; }
+
+    float                             GetScale() const { return mController.GetScale(); }
+    ppx::DynamicResolutionController& GetController() { return mController; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::DynamicResolutionCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct Frame
+    {
+        grfx::QueryPtr timestamps;
+        bool           resolved = false;
+    };
+
+    Result CreateDrawPass(uint32_t width, uint32_t height);
+    void   UpdateRenderSize();
+
+private:
+    ppx::DynamicResolutionController mController;
+    std::vector<Frame>               mFrames;
+    uint32_t                         mFrameIndex          = UINT32_MAX;
+    uint64_t                         mFrequency           = 0;
+    float                            mGpuFrameTimeMs      = 0.0f;
+    uint32_t                         mRenderWidth         = 0;
+    uint32_t                         mRenderHeight        = 0;
+    bool                             mHasDeferredDestroys = false; // Resize() deferred destroys of the old draw pass
+    grfx::DrawPassPtr                mDrawPass;
+    grfx::SamplerPtr                 mSampler;
+    grfx::DescriptorPoolPtr          mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr     mSetLayout;
+    grfx::DescriptorSetPtr           mSet;
+    grfx::PipelineInterfacePtr       mPipelineInterface;
+    grfx::GraphicsPipelinePtr        mPipeline;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_dynamic_resolution_h
@@ -18,6 +18,30 @@
 namespace ppx {
 namespace grfx {
 
+enum AccelerationStructureBuildFlagBits
+{
+    ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE      = 0x1,
+    ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION  = 0x2,
+    ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE = 0x4,
+    ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD = 0x8,
+};
+
+// Same values in Vulkan and D3D12
+enum AccelerationStructureInstanceFlagBits
+{
+    ACCELERATION_STRUCTURE_INSTANCE_FLAG_TRIANGLE_CULL_DISABLE = 0x1,
+    ACCELERATION_STRUCTURE_INSTANCE_FLAG_TRIANGLE_FRONT_CCW    = 0x2,
+    ACCELERATION_STRUCTURE_INSTANCE_FLAG_FORCE_OPAQUE          = 0x4,
+    ACCELERATION_STRUCTURE_INSTANCE_FLAG_FORCE_NON_OPAQUE      = 0x8,
+};
+
+enum AccelerationStructureType
+{
+    ACCELERATION_STRUCTURE_TYPE_UNDEFINED    = 0,
+    ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL = 1, // Triangle geometry
+    ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL    = 2, // Instances of bottom level structures
+};
+
 enum Api
 {
     API_UNDEFINED = 0,
@@ -253,6 +277,7 @@ enum DescriptorType
     DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC = 11, // (Vulkan only)
     DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC = 12, // (Vulkan only)
     DESCRIPTOR_TYPE_INPUT_ATTACHMENT       = 13, // (Vulkan only)
+    DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE = 14, // Top level acceleration structure for ray queries
 };
 
 enum DrawPassClearFlagBits
@@ -282,6 +307,20 @@ enum FrontFace
     FRONT_FACE_CW  = 1, // Clockwise
 };
 
+enum ImageHostUpload
+{
+    IMAGE_HOST_UPLOAD_NONE            = 0, // Uploads go through a staging buffer
+    IMAGE_HOST_UPLOAD_LINEAR          = 1, // Linear tiling in host visible memory, preferably device local
+    IMAGE_HOST_UPLOAD_HOST_IMAGE_COPY = 2, // Optimal tiling in device local memory, VK_EXT_host_image_copy
+};
+
+enum ImageCompression
+{
+    IMAGE_COMPRESSION_DEFAULT    = 0, // Whatever the driver chooses, usually lossless
+    IMAGE_COMPRESSION_DISABLED   = 1, // No framebuffer compression, VK_EXT_image_compression_control
+    IMAGE_COMPRESSION_FIXED_RATE = 2, // Lossy at the driver's default rate, VK_EXT_image_compression_control
+};
+
 enum ImageType
 {
     IMAGE_TYPE_UNDEFINED = 0,
@@ -398,6 +437,8 @@ enum QueryType
     QUERY_TYPE_OCCLUSION           = 1,
     QUERY_TYPE_PIPELINE_STATISTICS = 2,
     QUERY_TYPE_TIMESTAMP           = 3,
+    // Written with CommandBuffer::WriteAccelerationStructureCompactedSizes
+    QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE = 4,
 };
 
 enum ResourceState
@@ -469,6 +510,8 @@ enum ShaderStageBits
     SHADER_STAGE_GS           = 0x00000008,
     SHADER_STAGE_PS           = 0x00000010,
     SHADER_STAGE_CS           = 0x00000020,
+    SHADER_STAGE_AS           = 0x00000040,
+    SHADER_STAGE_MS           = 0x00000080,
     SHADER_STAGE_ALL_GRAPHICS = 0x0000001F,
     SHADER_STAGE_ALL          = 0x7FFFFFFF,
 };
@@ -81,6 +81,10 @@ struct FullscreenQuadCreateInfo
     uint32_t     renderTargetCount                           = 0;
     grfx::Format renderTargetFormats[PPX_MAX_RENDER_TARGETS] = {grfx::FORMAT_UNDEFINED};
     grfx::Format depthStencilFormat                          = grfx::FORMAT_UNDEFINED;
+
+    // Non-NONE blend modes composite onto the render target instead of
+    // sampling it, which lets grfx::PostProcessChain merge the pass
+    grfx::BlendMode blendMode = grfx::BLEND_MODE_NONE;
 };
 
 //! @class FullscreenQuad
@@ -30,6 +30,43 @@ struct GpuCreateInfo
 
 } // namespace internal
 
+//! @struct SubgroupCapabilities
+//!
+//! Subgroups are called waves in HLSL. The operations are the ones
+//! available in compute shaders, all false if compute shaders can't use
+//! subgroup operations.
+//!
+struct SubgroupCapabilities
+{
+    uint32_t size            = 0;     // Lanes per subgroup, the minimum if the size varies by pipeline
+    uint32_t minSize         = 0;     // Range of sizes the driver may pick, equal to size if fixed
+    uint32_t maxSize         = 0;
+    bool     allStages       = false; // Operations are available in graphics stages too
+    bool     basic           = false; // WaveGetLaneIndex, WaveIsFirstLane
+    bool     vote            = false; // WaveActiveAnyTrue, WaveActiveAllTrue, WaveActiveAllEqual
+    bool     arithmetic      = false; // WaveActiveSum, WaveActiveMin, WavePrefixSum, ...
+    bool     ballot          = false; // WaveActiveBallot, WaveReadLaneFirst
+    bool     shuffle         = false; // WaveReadLaneAt with a varying lane
+    bool     shuffleRelative = false; // Shuffles up and down by a constant, Vulkan only
+    bool     clustered       = false; // Reductions over clusters of lanes, Vulkan only
+    bool     quad            = false; // QuadReadAcrossX, QuadReadAcrossY, QuadReadAcrossDiagonal
+};
+
+//! @struct ShaderCapabilities
+//!
+//! Optional shader features of a GPU, so kernels can pick specialized
+//! variants at runtime. Devices created on the GPU enable the features
+//! reported here.
+//!
+struct ShaderCapabilities
+{
+    grfx::SubgroupCapabilities subgroup          = {};
+    bool                       float16           = false; // Native 16 bit float arithmetic
+    bool                       int16             = false; // Native 16 bit integer arithmetic
+    bool                       int8              = false; // 8 bit integer arithmetic, Vulkan only
+    bool                       cooperativeMatrix = false; // VK_KHR_cooperative_matrix, Vulkan only
+};
+
 class Gpu
     : public grfx::InstanceObject<grfx::internal::GpuCreateInfo>
 {
@@ -39,14 +76,21 @@ public:
 
     const char*    GetDeviceName() const { return mDeviceName.c_str(); }
     grfx::VendorId GetDeviceVendorId() const { return mDeviceVendorId; }
+    // Formatted the way the vendor does, e.g. "535.104.5.0" on NVIDIA
+    const char*    GetDriverVersion() const { return mDriverVersion.c_str(); }
 
     virtual uint32_t GetGraphicsQueueCount() const = 0;
     virtual uint32_t GetComputeQueueCount() const  = 0;
     virtual uint32_t GetTransferQueueCount() const = 0;
 
+    const grfx::ShaderCapabilities& GetShaderCapabilities() const { return mShaderCapabilities; }
+
 protected:
     std::string    mDeviceName;
     grfx::VendorId mDeviceVendorId = grfx::VENDOR_ID_UNKNOWN;
+    std::string    mDriverVersion;
+    // Written by the backends when the GPU is created
+    grfx::ShaderCapabilities mShaderCapabilities = {};
 };
 
 } // namespace grfx
@@ -0,0 +1,173 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_gpu_profiler_h
+#define ppx_grfx_gpu_profiler_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_query.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct GpuProfilerCreateInfo
+//!
+//!
+struct GpuProfilerCreateInfo
+{
+    grfx::Queue* pQueue                   = nullptr; // Queue the profiled command buffers are submitted to
+    uint32_t     frameCount               = 1;       // Usually the application's frames in flight
+    uint32_t     maxScopesPerFrame        = 64;
+    bool         enablePipelineStatistics = false; // See GpuProfiler::BeginScope()
+};
+
+//! @struct GpuProfilerScope
+//!
+//! Result of one scope. \b path is the names of the enclosing scopes and
+//! the scope's own name joined with '/', it's unique as long as sibling
+//! scopes have different names.
+//!
+struct GpuProfilerScope
+{
+    std::string              name;
+    std::string              path;
+    uint32_t                 depth                 = 0;
+    double                   startMs               = 0; // From the beginning of the frame's first scope
+    double                   gpuMs                 = 0;
+    bool                     hasPipelineStatistics = false;
+    grfx::PipelineStatistics pipelineStatistics    = {};
+};
+
+//! @class GpuProfiler
+//!
+//! Named, nested GPU timing scopes for a single queue:
+//!   - BeginFrame() is called once the frame's previous use has completed
+//!     on the GPU, usually right after waiting for the frame's fence. It
+//!     reads that use's results and resets the frame's queries.
+//!   - BeginScope() / EndScope() are recorded around the work to measure.
+//!     Each scope also opens a debug label of the same name, so the same
+//!     scopes show up in GPU captures.
+//!   - EndFrame() is recorded after the last scope, outside of a render
+//!     pass, and copies the frame's queries to its readback buffers.
+//!
+//! Each frame index has its own queries, so results come back frameCount
+//! frames after they were recorded and reading them never waits on the GPU.
+//!
+//! Pipeline statistics are only collected for scopes that ask for them,
+//! and only for one scope at a time since the APIs don't allow nested
+//! statistics queries. A scope with statistics must end in the same render
+//! pass it began in, or both outside of render passes.
+//!
+class GpuProfiler
+    : public grfx::DeviceObject<grfx::GpuProfilerCreateInfo>
+{
+public:
+    GpuProfiler() {}
+    virtual ~GpuProfiler() {}
+
+    void BeginFrame(uint32_t frameIndex);
+    void EndFrame(grfx::CommandBuffer* pCommandBuffer);
+
+    void BeginScope(grfx::CommandBuffer* pCommandBuffer, const std::string& name, bool pipelineStatistics = false);
+    void EndScope(grfx::CommandBuffer* pCommandBuffer);
+
+    //! Scopes of the most recently read frame in the order they began.
+    const std::vector<grfx::GpuProfilerScope>& GetScopes() const { return mScopes; }
+
+    //! Number of the BeginFrame() call that recorded GetScopes(), counting
+    //! from 1. Returns 0 until the first results have been read.
+    uint64_t GetScopesFrameNumber() const { return mScopesFrameNumber; }
+
+    //! Timer timestamp taken by the EndFrame() that recorded GetScopes().
+    //! The GPU runs the frame after it, so it approximates where the first
+    //! scope begins on the CPU timeline; GPU clocks aren't calibrated.
+    uint64_t GetScopesCpuTimestamp() const { return mScopesCpuTimestamp; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::GpuProfilerCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct ScopeRecord
+    {
+        std::string name;
+        std::string path;
+        uint32_t    depth           = 0;
+        uint32_t    statisticsIndex = UINT32_MAX;
+    };
+
+    struct PerFrame
+    {
+        grfx::QueryPtr           timestamps;
+        grfx::QueryPtr           statistics;
+        std::vector<ScopeRecord> scopes;
+        uint32_t                 statisticsCount = 0;
+        uint64_t                 frameNumber     = 0;
+        uint64_t                 cpuTimestamp    = 0; // Taken by EndFrame()
+        bool                     resolved        = false;
+    };
+
+    void ReadResults(PerFrame& frame);
+
+private:
+    std::vector<PerFrame>                 mPerFrame;
+    uint64_t                              mFrequency          = 0;
+    uint32_t                              mFrameIndex         = UINT32_MAX; // Frame being recorded
+    uint64_t                              mFrameNumber        = 0;
+    std::vector<uint32_t>                 mScopeStack;                      // Indices into the frame's scopes, UINT32_MAX if dropped
+    uint32_t                              mStatisticsScope    = UINT32_MAX;
+    bool                                  mOverflowWarned     = false;
+    std::vector<uint64_t>                 mTimestampData;
+    std::vector<grfx::PipelineStatistics> mStatisticsData;
+    std::vector<grfx::GpuProfilerScope>   mScopes;
+    uint64_t                              mScopesFrameNumber  = 0;
+    uint64_t                              mScopesCpuTimestamp = 0;
+};
+
+//! @class GpuProfilerScopeGuard
+//!
+//! Begins a scope on construction and ends it on destruction. Does nothing
+//! if \b pProfiler is null, so call sites don't need to check whether
+//! profiling is enabled.
+//!
+class GpuProfilerScopeGuard
+{
+public:
+    GpuProfilerScopeGuard(grfx::GpuProfiler* pProfiler, grfx::CommandBuffer* pCommandBuffer, const std::string& name, bool pipelineStatistics = false)
+        : mProfiler(pProfiler), mCommandBuffer(pCommandBuffer)
+    {
+        if (!IsNull(mProfiler)) {
+            mProfiler->BeginScope(mCommandBuffer, name, pipelineStatistics);
+        }
+    }
+
+    ~GpuProfilerScopeGuard()
+    {
+        if (!IsNull(mProfiler)) {
+            mProfiler->EndScope(mCommandBuffer);
+        }
+    }
+
+    GpuProfilerScopeGuard(const GpuProfilerScopeGuard&)            = delete;
+    GpuProfilerScopeGuard& operator=(const GpuProfilerScopeGuard&) = delete;
+
+private:
+    grfx::GpuProfiler*   mProfiler      = nullptr;
+    grfx::CommandBuffer* mCommandBuffer = nullptr;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_gpu_profiler_h
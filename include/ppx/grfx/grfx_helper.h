@@ -27,6 +27,40 @@
 namespace ppx {
 namespace grfx {
 
+struct AccelerationStructureBuildFlags
+{
+    union
+    {
+        struct
+        {
+            bool allowUpdate     : 1;
+            bool allowCompaction : 1;
+            bool preferFastTrace : 1;
+            bool preferFastBuild : 1;
+        } bits;
+        uint32_t flags;
+    };
+
+    AccelerationStructureBuildFlags()
+        : flags(0) {}
+
+    AccelerationStructureBuildFlags(uint32_t flags_)
+        : flags(flags_) {}
+
+    AccelerationStructureBuildFlags& operator=(uint32_t rhs)
+    {
+        this->flags = rhs;
+        return *this;
+    }
+
+    operator uint32_t() const
+    {
+        return flags;
+    }
+};
+
+// -------------------------------------------------------------------------------------------------
+
 struct BufferUsageFlags
 {
     union
@@ -49,6 +83,8 @@ struct BufferUsageFlags
             bool transformFeedbackBuffer        : 1;
             bool transformFeedbackCounterBuffer : 1;
             bool shaderDeviceAddress            : 1;
+            bool accelerationStructureStorage   : 1; // Backing memory of acceleration structures
+            bool accelerationStructureInput     : 1; // Vertex, index or instance data read by acceleration structure builds
         } bits;
         uint32_t flags;
     };
@@ -251,6 +287,9 @@ struct ImageUsageFlags
             bool storage                       : 1;
             bool colorAttachment               : 1;
             bool depthStencilAttachment        : 1;
+            // Attachment only image whose contents never leave the render
+            // pass. Uses lazily allocated memory on Vulkan when available,
+            // so tile based GPUs may never back it.
             bool transientAttachment           : 1;
             bool inputAttachment               : 1;
             bool fragmentDensityMap            : 1;
@@ -399,6 +438,8 @@ struct ShaderStageFlags
             bool GS : 1;
             bool PS : 1;
             bool CS : 1;
+            bool AS : 1;
+            bool MS : 1;
 
         } bits;
         uint32_t flags;
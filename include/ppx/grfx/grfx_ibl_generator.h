@@ -0,0 +1,127 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_ibl_generator_h
+#define ppx_grfx_ibl_generator_h
+
+#include "ppx/grfx/grfx_config.h"
+
+namespace ppx {
+namespace grfx {
+
+struct IBLGeneratorParams
+{
+    uint32_t shSampleWidth        = 256; // Source samples projected onto SH per row, there are half as many rows
+    uint32_t prefilterSampleCount = 64;  // GGX samples per texel of the rough environment levels
+    uint32_t brdfLUTSampleCount   = 512; // GGX samples per texel of the BRDF LUT
+};
+
+struct IBLGeneratorCreateInfo
+{
+    grfx::ShaderModule* pProjectSHShader  = nullptr; // basic/shaders/IBLProjectSH.cs
+    grfx::ShaderModule* pIrradianceShader = nullptr; // basic/shaders/IBLIrradiance.cs
+    grfx::ShaderModule* pPrefilterShader  = nullptr; // basic/shaders/IBLPrefilter.cs
+    grfx::ShaderModule* pBRDFLUTShader    = nullptr; // basic/shaders/IBLBRDFLUT.cs
+    uint32_t            maxDispatchCount  = 32;      // Dispatches that can be recorded between Reset() calls
+};
+
+//! @class IBLGenerator
+//!
+//! Generates the image based lighting textures PBR.hlsli samples from an
+//! equirectangular HDR environment, so any environment can be used without
+//! baking it offline.
+//!
+//! The diffuse irradiance is projected onto order 2 spherical harmonics and
+//! evaluated into a small lat-long texture. Level i of the specular
+//! environment is the source prefiltered with the GGX lobe of roughness
+//! i / levelCount, which is the level PBR.hlsli reads for that roughness.
+//! Prefiltering picks source mip levels by sample density, so the source
+//! should have a full mip chain.
+//!
+//! Destination images need storage usage and a float color format. Like
+//! grfx::ImageFilter, views and descriptor sets are kept until Reset(),
+//! which must only be called once the recorded work completed.
+//!
+class IBLGenerator
+{
+public:
+    static constexpr uint32_t kSHCoefficientCount = 9;
+
+    IBLGenerator();
+    virtual ~IBLGenerator();
+
+    static Result Create(grfx::Device* pDevice, const grfx::IBLGeneratorCreateInfo& createInfo, grfx::IBLGenerator** ppGenerator);
+
+    //! Writes the irradiance of pSource to the first level of pIrradiance
+    //! and the prefiltered radiance to every level of pEnvironment. pSource
+    //! is returned to srcState, the destinations end up in dstStateAfter.
+    //! Must be recorded outside of a render pass.
+    Result RecordEnvironment(
+        grfx::CommandBuffer*            pCmd,
+        const grfx::IBLGeneratorParams& params,
+        grfx::Image*                    pSource,
+        grfx::ResourceState             srcState,
+        grfx::Image*                    pIrradiance,
+        grfx::Image*                    pEnvironment,
+        grfx::ResourceState             dstStateAfter);
+
+    //! Writes the split sum BRDF LUT to the first level of pLUT, scale in
+    //! red and bias in green
+    Result RecordBRDFLUT(
+        grfx::CommandBuffer*            pCmd,
+        const grfx::IBLGeneratorParams& params,
+        grfx::Image*                    pLUT,
+        grfx::ResourceState             dstStateAfter);
+
+    //! Returns true if pImage can be a destination
+    static bool IsSupported(const grfx::Image* pImage);
+
+    //! Releases the views and descriptor sets of recorded dispatches
+    void Reset();
+
+    uint32_t GetDispatchCount() const { return CountU32(mDispatches); }
+
+private:
+    struct DispatchResources
+    {
+        grfx::SampledImageViewPtr srcView;
+        grfx::StorageImageViewPtr dstView;
+        grfx::DescriptorSetPtr    set;
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::IBLGeneratorCreateInfo& createInfo);
+    Result CreatePipeline(grfx::ShaderModule* pShader, grfx::ComputePipeline** ppPipeline);
+    Result AddDispatch(grfx::Image* pSrc, grfx::Image* pDst, uint32_t dstLevel);
+    void   DestroyDispatch(DispatchResources& dispatch);
+    Result CheckDispatchCount(uint32_t count) const;
+
+private:
+    grfx::Device*                  mDevice           = nullptr;
+    uint32_t                       mMaxDispatchCount = 0;
+    grfx::DescriptorPoolPtr        mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr   mSetLayout;
+    grfx::PipelineInterfacePtr     mPipelineInterface;
+    grfx::ComputePipelinePtr       mProjectSHPipeline;
+    grfx::ComputePipelinePtr       mIrradiancePipeline;
+    grfx::ComputePipelinePtr       mPrefilterPipeline;
+    grfx::ComputePipelinePtr       mBRDFLUTPipeline;
+    grfx::SamplerPtr               mSampler;
+    grfx::BufferPtr                mSHBuffer;
+    std::vector<DispatchResources> mDispatches;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_ibl_generator_h
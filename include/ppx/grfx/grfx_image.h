@@ -20,6 +20,34 @@
 namespace ppx {
 namespace grfx {
 
+//! @struct SparseImageTile
+//!
+//! A tile of a sparse resident image, \b x and \b y count tiles, not
+//! pixels.
+//!
+struct SparseImageTile
+{
+    uint32_t mipLevel   = 0;
+    uint32_t arrayLayer = 0;
+    uint32_t x          = 0;
+    uint32_t y          = 0;
+};
+
+//! @struct SparseImageProperties
+//!
+//! Tile layout of a sparse resident image. Mip levels starting at
+//! \b firstMipTailLevel are too small for whole tiles and packed into the
+//! mip tail, which is bound when the image is created and stays resident.
+//!
+struct SparseImageProperties
+{
+    uint32_t tileWidth         = 0; // [pixels]
+    uint32_t tileHeight        = 0; // [pixels]
+    uint64_t tileSize          = 0; // [bytes]
+    uint32_t firstMipTailLevel = 0;
+    uint64_t mipTailSize       = 0; // [bytes] All array layers
+};
+
 //! @struct ImageCreateInfo
 //!
 //!
@@ -43,6 +71,37 @@ struct ImageCreateInfo
     bool                         concurrentMultiQueueUsage = false;
     grfx::ImageCreateFlags       createFlags               = {};
 
+    // [OPTIONAL] Bind the image to the memory of pAliasImage instead of
+    // allocating its own. pAliasImage must own its memory (i.e. not be an
+    // alias itself) and must outlive this image. Creation fails with
+    // ppx::ERROR_INVALID_CREATE_ARGUMENT if that memory is too small or
+    // incompatible. Contents are undefined whenever the other image was
+    // used last, see CommandBuffer::AliasingBarrier.
+    grfx::Image* pAliasImage = nullptr;
+
+    // [OPTIONAL] Lets the CPU write the image directly with
+    // Image::CopyFromHost() instead of through a staging buffer. Requires
+    // grfx::Device::ImageHostUploadSupported() for the format, a single
+    // sample, initialState RESOURCE_STATE_GENERAL (the image stays in it)
+    // and no pApiObject or pAliasImage. IMAGE_HOST_UPLOAD_LINEAR is also
+    // limited to 2D images with one mip level and array layer.
+    grfx::ImageHostUpload hostUpload = grfx::IMAGE_HOST_UPLOAD_NONE;
+
+    // [OPTIONAL] Creates the image without memory outside of the mip tail,
+    // memory is bound per tile with Queue::BindSparseImageTiles(). Sampling
+    // a tile without memory returns undefined values, shaders can check the
+    // residency with the status of the sample (see ppx/SparseFeedback.hlsli).
+    // Requires grfx::Device::SparseResidencySupported(), a 2D image with a
+    // single sample, MEMORY_USAGE_GPU_ONLY and no pApiObject, pAliasImage or
+    // hostUpload.
+    bool sparseResidency = false;
+
+    // [OPTIONAL] Overrides the framebuffer compression of the image, to
+    // measure its effect on bandwidth. Requires
+    // grfx::Device::ImageCompressionSupported() for the format and no
+    // pApiObject or pAliasImage.
+    grfx::ImageCompression compression = grfx::IMAGE_COMPRESSION_DEFAULT;
+
     // Returns a create info for sampled image
     static ImageCreateInfo SampledImage2D(
         uint32_t          width,
@@ -66,6 +125,29 @@ struct ImageCreateInfo
         grfx::SampleCount sampleCount = grfx::SAMPLE_COUNT_1);
 };
 
+//! @struct ImageViewRange
+//!
+//! Format and subresources of a view cached by grfx::Image. Counts of
+//! PPX_REMAINING_MIP_LEVELS and PPX_REMAINING_ARRAY_LAYERS extend to the end
+//! of the image.
+//!
+struct ImageViewRange
+{
+    grfx::ImageViewType imageViewType   = grfx::IMAGE_VIEW_TYPE_UNDEFINED; // Guessed from the image type and layer count if undefined
+    grfx::Format        format          = grfx::FORMAT_UNDEFINED;          // Format of the image if undefined
+    uint32_t            mipLevel        = 0;
+    uint32_t            mipLevelCount   = PPX_REMAINING_MIP_LEVELS;
+    uint32_t            arrayLayer      = 0;
+    uint32_t            arrayLayerCount = PPX_REMAINING_ARRAY_LAYERS;
+
+    //! A single mip level of a single array layer, e.g. a cubemap face
+    static ImageViewRange Subresource(uint32_t mipLevel, uint32_t arrayLayer = 0);
+    //! A single mip level of all array layers
+    static ImageViewRange MipLevel(uint32_t mipLevel);
+
+    bool operator==(const ImageViewRange& rhs) const;
+};
+
 //! @class Image
 //!
 //!
@@ -91,16 +173,105 @@ public:
     const grfx::DepthStencilClearValue& GetDSVClearValue() const { return mCreateInfo.DSVClearValue; }
     bool                                GetConcurrentMultiQueueUsageEnabled() const { return mCreateInfo.concurrentMultiQueueUsage; }
     grfx::ImageCreateFlags              GetCreateFlags() const { return mCreateInfo.createFlags; }
+    grfx::Image*                        GetAliasImage() const { return mCreateInfo.pAliasImage; }
+    grfx::ImageHostUpload               GetHostUpload() const { return mCreateInfo.hostUpload; }
+    bool                                GetSparseResidency() const { return mCreateInfo.sparseResidency; }
 
     // Convenience functions
     grfx::ImageViewType GuessImageViewType(bool isCube = false) const;
 
+    //! Views owned by the image, created on first use and destroyed with it.
+    //! Requests for the same range return the same view, so render and
+    //! compute loops over mip levels or faces can ask for their views every
+    //! time instead of keeping them. The views can't be destroyed by the
+    //! caller. Render target and depth stencil views use the load and store
+    //! ops of their GuessFromImage() create info, and must cover a single
+    //! mip level.
+    Result GetSampledImageView(const grfx::ImageViewRange& range, grfx::SampledImageView** ppView);
+    Result GetStorageImageView(const grfx::ImageViewRange& range, grfx::StorageImageView** ppView);
+    Result GetRenderTargetView(const grfx::ImageViewRange& range, grfx::RenderTargetView** ppView);
+    Result GetDepthStencilView(const grfx::ImageViewRange& range, grfx::DepthStencilView** ppView);
+
+    uint32_t GetCachedViewCount() const;
+
     virtual Result MapMemory(uint64_t offset, void** ppMappedAddress) = 0;
     virtual void   UnmapMemory()                                      = 0;
 
+    //! Writes a whole subresource from host memory, rows of \b pSrcData are
+    //! \b srcRowStride bytes apart. Only for images created with hostUpload.
+    //! The host writes are visible to work submitted afterwards, the caller
+    //! must make sure the GPU isn't accessing the subresource meanwhile.
+    virtual Result CopyFromHost(
+        uint32_t    mipLevel,
+        uint32_t    arrayLayer,
+        const void* pSrcData,
+        uint32_t    srcRowStride) = 0;
+
+    //! Tracked state of each subresource, starting at the initial state.
+    //! CommandBuffer::TransitionImageState updates these at record time, so
+    //! they are only correct if command buffers are submitted in the order
+    //! they were recorded. Explicit TransitionImageLayout calls do not update
+    //! them: use SetTrackedState to resync after an explicit transition.
+    grfx::ResourceState GetTrackedState(uint32_t mipLevel, uint32_t arrayLayer) const;
+
+    void SetTrackedState(
+        grfx::ResourceState state,
+        uint32_t            mipLevel        = 0,
+        uint32_t            mipLevelCount   = PPX_REMAINING_MIP_LEVELS,
+        uint32_t            arrayLayer      = 0,
+        uint32_t            arrayLayerCount = PPX_REMAINING_ARRAY_LAYERS);
+
+    //! Sparse residency, only valid for images created with sparseResidency.
+    //! Tiles are indexed by array layer, then mip level, then row, the mip
+    //! tail has no tiles. GetSparseTileCount() returns 0 for mip tail levels.
+    const grfx::SparseImageProperties& GetSparseProperties() const { return mSparseProperties; }
+    uint32_t                           GetSparseTileCount() const { return CountU32(mResidentSparseTiles); }
+    uint32_t                           GetResidentSparseTileCount() const { return mResidentSparseTileCount; }
+
+    void                  GetSparseTileCount(uint32_t mipLevel, uint32_t* pCountX, uint32_t* pCountY) const;
+    uint32_t              GetSparseTileIndex(const grfx::SparseImageTile& tile) const;
+    grfx::SparseImageTile GetSparseTile(uint32_t tileIndex) const;
+    bool                  IsSparseTileResident(const grfx::SparseImageTile& tile) const;
+
 protected:
     virtual Result Create(const grfx::ImageCreateInfo* pCreateInfo) override;
+    virtual void   Destroy() override;
     friend class grfx::Device;
+
+    // Residency is tracked at bind time by Queue::BindSparseImageTiles()
+    void SetSparseTileResident(uint32_t tileIndex, bool resident);
+    friend class grfx::Queue;
+
+protected:
+    // Written by the backends when a sparse image is created
+    grfx::SparseImageProperties mSparseProperties = {};
+
+private:
+    template <typename ViewT>
+    struct CachedView
+    {
+        grfx::ImageViewRange range = {}; // Resolved, without undefined or remaining values
+        ObjPtr<ViewT>        view;
+    };
+
+    grfx::ImageViewRange ResolveViewRange(const grfx::ImageViewRange& range) const;
+
+    template <typename ViewT, typename CreateInfoT>
+    Result GetCachedView(std::vector<CachedView<ViewT>>& cache, const grfx::ImageViewRange& range, ViewT** ppView);
+
+private:
+    // Indexed by (arrayLayer * mipLevelCount + mipLevel)
+    std::vector<grfx::ResourceState> mTrackedStates;
+    // Indexed by GetSparseTileIndex()
+    std::vector<bool> mResidentSparseTiles;
+    uint32_t          mResidentSparseTileCount = 0;
+    uint32_t          mSparseTilesPerLayer     = 0;
+
+    // Few views per image, searched linearly
+    std::vector<CachedView<grfx::SampledImageView>> mSampledImageViews;
+    std::vector<CachedView<grfx::StorageImageView>> mStorageImageViews;
+    std::vector<CachedView<grfx::RenderTargetView>> mRenderTargetViews;
+    std::vector<CachedView<grfx::DepthStencilView>> mDepthStencilViews;
 };
 
 // -------------------------------------------------------------------------------------------------
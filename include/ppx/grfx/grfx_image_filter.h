@@ -0,0 +1,151 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_image_filter_h
+#define ppx_grfx_image_filter_h
+
+#include "ppx/grfx/grfx_config.h"
+
+namespace ppx {
+namespace grfx {
+
+enum ImageFilterType
+{
+    IMAGE_FILTER_TYPE_GAUSSIAN  = 0,
+    IMAGE_FILTER_TYPE_BOX       = 1,
+    IMAGE_FILTER_TYPE_BILATERAL = 2,
+    IMAGE_FILTER_TYPE_SOBEL     = 3, // Gradient magnitude of the luminance, radius is ignored
+};
+
+struct ImageFilterParams
+{
+    grfx::ImageFilterType type       = grfx::IMAGE_FILTER_TYPE_GAUSSIAN;
+    uint32_t              radius     = 2;
+    float                 sigma      = 0.0f; // 0 uses radius / 2
+    float                 rangeSigma = 0.1f; // Bilateral only, in color units
+};
+
+struct ImageFilterCreateInfo
+{
+    grfx::ShaderModule* pSeparableShader = nullptr; // basic/shaders/ImageFilterSeparable.cs
+    grfx::ShaderModule* p2DShader        = nullptr; // basic/shaders/ImageFilter2D.cs
+    grfx::ShaderModule* pResampleShader  = nullptr; // basic/shaders/ImageFilterResample.cs
+    uint32_t            maxDispatchCount = 32;      // Dispatches that can be recorded between Reset() calls
+};
+
+//! @class ImageFilter
+//!
+//! Compute image filters whose groups load their source tile, halo
+//! included, into group shared memory once instead of sampling every tap
+//! from the texture.
+//!
+//! Gaussian and box filters run as a horizontal and a vertical pass
+//! through pTemp when that's cheaper than the 2D kernel: from radius
+//! kMinSeparableRadius on, and always above kMax2DRadius. Bilateral and
+//! Sobel only have the 2D kernel.
+//!
+//! The downsample and upsample chains work on the mip levels of one image,
+//! e.g. for bloom: RecordDownsampleChain() tent filters each level into the
+//! next, RecordUpsampleChain() then adds each level, upsampled, onto the one
+//! above it, from the smallest up.
+//!
+//! Images need sampled and storage usage and a UNORM, SNORM or FLOAT color
+//! format. Like grfx::MipGenerator, views and descriptor sets are kept until
+//! Reset(), which must only be called once the recorded work completed.
+//!
+class ImageFilter
+{
+public:
+    static constexpr uint32_t kMax2DRadius        = 4;
+    static constexpr uint32_t kMaxSeparableRadius = 32;
+    static constexpr uint32_t kMinSeparableRadius = 2;
+
+    ImageFilter();
+    virtual ~ImageFilter();
+
+    static Result Create(grfx::Device* pDevice, const grfx::ImageFilterCreateInfo& createInfo, grfx::ImageFilter** ppFilter);
+
+    //! Filters the first level of pSrc into the first level of pDst, which
+    //! must have the same size. pTemp is only needed by separable passes and
+    //! must match pDst. pSrc is returned to srcState, pDst ends up in
+    //! dstStateAfter and its previous contents are discarded. Must be
+    //! recorded outside of a render pass.
+    Result Record(
+        grfx::CommandBuffer*           pCmd,
+        const grfx::ImageFilterParams& params,
+        grfx::Image*                   pSrc,
+        grfx::ResourceState            srcState,
+        grfx::Image*                   pDst,
+        grfx::ResourceState            dstStateAfter,
+        grfx::Image*                   pTemp = nullptr);
+
+    //! Downsamples level 0 of pImage into levels 1 to levelCount - 1, all
+    //! levels end up in stateAfter
+    Result RecordDownsampleChain(
+        grfx::CommandBuffer* pCmd,
+        grfx::Image*         pImage,
+        uint32_t             levelCount,
+        grfx::ResourceState  level0State,
+        grfx::ResourceState  stateAfter);
+
+    //! Adds levels levelCount - 1 to 1 of pImage, upsampled, onto the level
+    //! above them, so level 0 ends up with the sum of the chain
+    Result RecordUpsampleChain(
+        grfx::CommandBuffer* pCmd,
+        grfx::Image*         pImage,
+        uint32_t             levelCount,
+        grfx::ResourceState  stateBefore,
+        grfx::ResourceState  stateAfter);
+
+    //! Returns true if Record() would use the separable kernel
+    static bool UsesSeparablePasses(const grfx::ImageFilterParams& params, bool hasTemp);
+
+    //! Returns true if the filters support pImage
+    static bool IsSupported(const grfx::Image* pImage);
+
+    //! Releases the views and descriptor sets of recorded dispatches
+    void Reset();
+
+    uint32_t GetDispatchCount() const { return CountU32(mDispatches); }
+
+private:
+    struct DispatchResources
+    {
+        grfx::SampledImageViewPtr srcView;
+        grfx::StorageImageViewPtr dstView;
+        grfx::DescriptorSetPtr    set;
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::ImageFilterCreateInfo& createInfo);
+    Result CreatePipeline(grfx::ShaderModule* pShader, grfx::ComputePipeline** ppPipeline);
+    Result AddDispatch(grfx::Image* pSrc, uint32_t srcLevel, grfx::Image* pDst, uint32_t dstLevel);
+    void   DestroyDispatch(DispatchResources& dispatch);
+    Result CheckDispatchCount(uint32_t count) const;
+
+private:
+    grfx::Device*                  mDevice           = nullptr;
+    uint32_t                       mMaxDispatchCount = 0;
+    grfx::DescriptorPoolPtr        mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr   mSetLayout;
+    grfx::PipelineInterfacePtr     mPipelineInterface;
+    grfx::ComputePipelinePtr       mSeparablePipeline;
+    grfx::ComputePipelinePtr       m2DPipeline;
+    grfx::ComputePipelinePtr       mResamplePipeline;
+    std::vector<DispatchResources> mDispatches;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_image_filter_h
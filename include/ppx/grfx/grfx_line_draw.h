@@ -0,0 +1,104 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_line_draw_h
+#define ppx_grfx_line_draw_h
+
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/bounding_volume.h"
+#include "ppx/math_config.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct LineDrawCreateInfo
+//!
+//!
+struct LineDrawCreateInfo
+{
+    uint32_t              maxLineCount       = 65536; // Lines each frame can hold
+    uint32_t              frameCount         = 1;     // Usually the number of frames in flight
+    grfx::ShaderStageInfo VS                 = {};    // Use basic/shaders/VertexColorsPushConstants.hlsl (vsmain)
+    grfx::ShaderStageInfo PS                 = {};    // Use basic/shaders/VertexColorsPushConstants.hlsl (psmain)
+    grfx::Format          renderTargetFormat = grfx::FORMAT_UNDEFINED;
+    grfx::Format          depthStencilFormat = grfx::FORMAT_UNDEFINED;
+    bool                  depthTest          = true; // Lines never write depth
+};
+
+//! @class LineDraw
+//!
+//! Immediate mode debug lines. Lines, boxes and frusta are written straight
+//! into the current frame's mapped CPU_TO_GPU vertex buffer and Draw()
+//! draws all of them with a single draw call, so debug visualization
+//! doesn't add meshes or draw calls that scale with the number of objects.
+//!
+//! BeginFrame() discards the lines of the frame index it makes current, the
+//! caller must have waited on that frame's fence. Lines past maxLineCount
+//! are dropped.
+//!
+class LineDraw
+    : public grfx::DeviceObject<grfx::LineDrawCreateInfo>
+{
+public:
+    LineDraw() {}
+    virtual ~LineDraw() {}
+
+    uint32_t GetLineCount() const { return mLineCount; }
+    uint32_t GetDroppedLineCount() const { return mDroppedLineCount; }
+
+    void BeginFrame(uint32_t frameIndex);
+
+    void AddLine(const float3& p0, const float3& p1, const float3& color);
+    void AddBox(const ppx::AABB& box, const float3& color);
+    void AddBox(const ppx::AABB& box, const float4x4& transform, const float3& color);
+    //! Edges of the [0, 1] depth range frustum of viewProjection
+    void AddFrustum(const float4x4& viewProjection, const float3& color);
+
+    //! Draws the lines added since BeginFrame(), inside a render pass
+    //! compatible with the create info's formats
+    void Draw(grfx::CommandBuffer* pCommandBuffer, const float4x4& viewProjection);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::LineDrawCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct Vertex
+    {
+        float3 position;
+        float3 color;
+    };
+
+    struct Frame
+    {
+        grfx::BufferPtr buffer;
+        Vertex*         pVertices = nullptr;
+    };
+
+    // The 8 corners are ordered by the x, y, z bits of their index
+    void AddBoxEdges(const float3 corners[8], const float3& color);
+
+private:
+    std::vector<Frame>         mFrames;
+    uint32_t                   mFrameIndex       = 0;
+    uint32_t                   mLineCount        = 0;
+    uint32_t                   mDroppedLineCount = 0;
+    grfx::PipelineInterfacePtr mPipelineInterface;
+    grfx::GraphicsPipelinePtr  mPipeline;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_line_draw_h
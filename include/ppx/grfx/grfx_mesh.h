@@ -17,6 +17,8 @@
 
 #include "ppx/grfx/grfx_config.h"
 #include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_buffer_pool.h"
+#include "ppx/grfx/grfx_ray_tracing.h"
 #include "ppx/geometry.h"
 
 namespace ppx {
@@ -57,15 +59,32 @@ struct MeshVertexBufferDescription
 //!   - If \b vertexCount is 0 then no vertex buffers will be created
 //!       - This means vertex buffer information will be ignored
 //!   - Active elements in \b vertexBuffers cannot have an \b attributeCount of 0
+//!   - If \b pBufferPool is set the index and vertex buffers are ranges of the
+//!     pool's buffers instead of dedicated buffers, \b memoryUsage is ignored
+//!   - \b accelerationStructureInput adds the usage needed to build bottom
+//!     level acceleration structures from the mesh, pools need it already
+//!   - \b storageBuffers adds raw storage buffer usage so compute shaders
+//!     can write the index and vertex data, it's ignored for pooled meshes
+//!   - \b primitiveTopology isn't used by the mesh, it tells pipelines how
+//!     to draw it. TRIANGLE_STRIP meshes from ppx::Geometry::ConvertToTriangleStrips()
+//!     need primitive restart.
+//!   - If \b pIndexSource is set the mesh uses that mesh's index buffer
+//!     instead of creating one, \b indexType and \b indexCount must match it
+//!     and it must outlive the mesh
 //!
 struct MeshCreateInfo
 {
     grfx::IndexType                   indexType                              = grfx::INDEX_TYPE_UNDEFINED;
+    grfx::PrimitiveTopology           primitiveTopology                      = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     uint32_t                          indexCount                             = 0;
     uint32_t                          vertexCount                            = 0;
     uint32_t                          vertexBufferCount                      = 0;
     grfx::MeshVertexBufferDescription vertexBuffers[PPX_MAX_VERTEX_BINDINGS] = {};
     grfx::MemoryUsage                 memoryUsage                            = grfx::MEMORY_USAGE_GPU_ONLY;
+    grfx::BufferPool*                 pBufferPool                            = nullptr; // [OPTIONAL] Needs index and vertex buffer usage, must outlive the mesh
+    bool                              accelerationStructureInput             = false;
+    bool                              storageBuffers                         = false;
+    const grfx::Mesh*                 pIndexSource                           = nullptr; // [OPTIONAL]
 
     MeshCreateInfo() {}
     MeshCreateInfo(const ppx::Geometry& geometry);
@@ -93,15 +112,33 @@ public:
     Mesh() {}
     virtual ~Mesh() {}
 
-    grfx::IndexType GetIndexType() const { return mCreateInfo.indexType; }
-    uint32_t        GetIndexCount() const { return mCreateInfo.indexCount; }
-    grfx::BufferPtr GetIndexBuffer() const { return mIndexBuffer; }
+    grfx::IndexType         GetIndexType() const { return mCreateInfo.indexType; }
+    grfx::PrimitiveTopology GetPrimitiveTopology() const { return mCreateInfo.primitiveTopology; }
+    uint32_t                GetIndexCount() const { return mCreateInfo.indexCount; }
+    bool                    IsIndexBufferShared() const { return !IsNull(mCreateInfo.pIndexSource); }
+    grfx::BufferPtr         GetIndexBuffer() const { return mIndexBuffer; }
+    uint64_t                GetIndexBufferOffset() const { return mIndexRange.offset; }
 
     uint32_t                                 GetVertexCount() const { return mCreateInfo.vertexCount; }
     uint32_t                                 GetVertexBufferCount() const { return CountU32(mVertexBuffers); }
     grfx::BufferPtr                          GetVertexBuffer(uint32_t index) const;
+    uint64_t                                 GetVertexBufferOffset(uint32_t index) const;
     const grfx::MeshVertexBufferDescription* GetVertexBufferDescription(uint32_t index) const;
 
+    bool IsPooled() const { return !IsNull(mCreateInfo.pBufferPool); }
+    bool HasStorageBuffers() const { return mCreateInfo.storageBuffers && !IsPooled(); }
+
+    //! firstIndex and vertexOffset for DrawIndexed() when the pool's
+    //! buffers are bound at offset 0 instead of binding the mesh. Only
+    //! meaningful for pooled meshes with a single vertex buffer.
+    uint32_t GetFirstIndex() const;
+    int32_t  GetBaseVertex() const;
+
+    //! Fills the triangle geometry of a bottom level acceleration structure
+    //! from the position attribute. Returns ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION
+    //! if the mesh has no R32G32B32_FLOAT position or isn't a triangle list.
+    Result GetAccelerationStructureTriangles(grfx::AccelerationStructureTriangles* pTriangles) const;
+
     //! Returns derived vertex bindings based on the vertex buffer description
     const std::vector<grfx::VertexBinding>& GetDerivedVertexBindings() const { return mDerivedVertexBindings; }
 
@@ -113,6 +150,8 @@ private:
     grfx::BufferPtr                                                            mIndexBuffer;
     std::vector<std::pair<grfx::BufferPtr, grfx::MeshVertexBufferDescription>> mVertexBuffers;
     std::vector<grfx::VertexBinding>                                           mDerivedVertexBindings;
+    grfx::BufferRange                                                          mIndexRange;
+    std::vector<grfx::BufferRange>                                             mVertexRanges;
 };
 
 } // namespace grfx
@@ -0,0 +1,118 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_mesh_generator_h
+#define ppx_grfx_mesh_generator_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/math_config.h"
+
+namespace ppx {
+namespace grfx {
+
+enum MeshGeneratorShape
+{
+    MESH_GENERATOR_SHAPE_SPHERE = 0, // TriMesh::CreateSphere()
+    MESH_GENERATOR_SHAPE_PLANE  = 1, // TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y)
+};
+
+//! @struct GeneratedMeshInfo
+//!
+//! Vertices have a position, then the attributes that have a format, in the
+//! order texCoord, normal, tangent. Tangents point along -u with the
+//! handedness in w, like TriMesh's.
+//!
+struct GeneratedMeshInfo
+{
+    grfx::MeshGeneratorShape shape          = grfx::MESH_GENERATOR_SHAPE_SPHERE;
+    float2                   size           = float2(1); // Sphere radius in x, plane size
+    uint32_t                 usegs          = 10;
+    uint32_t                 vsegs          = 10;
+    grfx::Format             positionFormat = grfx::FORMAT_R32G32B32_FLOAT;    // Or R16G16B16A16_FLOAT
+    grfx::Format             texCoordFormat = grfx::FORMAT_R32G32_FLOAT;       // Or R16G16_FLOAT, UNDEFINED for none
+    grfx::Format             normalFormat   = grfx::FORMAT_R32G32B32_FLOAT;    // Or R8G8B8A8_SNORM, UNDEFINED for none
+    grfx::Format             tangentFormat  = grfx::FORMAT_R32G32B32A32_FLOAT; // Or R8G8B8A8_SNORM, UNDEFINED for none
+    bool                     positionPlanar = false;                           // Positions in vertex buffer 0, the rest in 1
+
+    // One copy of the shape per translation, with indices into its own
+    // vertices. Empty makes a single copy at the origin.
+    std::vector<float3> translations;
+};
+
+struct MeshGeneratorCreateInfo
+{
+    grfx::ShaderModule* pShader      = nullptr; // basic/shaders/GenerateMesh.cs
+    uint32_t            maxMeshCount = 16;      // Meshes Record() can generate between Reset() calls
+};
+
+//! @class MeshGenerator
+//!
+//! Generates the TriMesh primitives straight into the index and vertex
+//! buffers of a grfx::Mesh with a compute shader, so very finely tessellated
+//! meshes don't cost CPU time or staging memory. Indices are UINT32 and the
+//! buffers are GPU only with raw storage usage.
+//!
+//! The translation buffers and descriptor sets of recorded work are kept
+//! until Reset(), which must only be called once the command buffers
+//! Record() was called with have completed.
+//!
+class MeshGenerator
+{
+public:
+    MeshGenerator();
+    virtual ~MeshGenerator();
+
+    static Result Create(grfx::Device* pDevice, const grfx::MeshGeneratorCreateInfo& createInfo, grfx::MeshGenerator** ppGenerator);
+
+    //! Creates *ppMesh and records the generation of its contents into
+    //! pCmd. The buffers end up in VERTEX_BUFFER and INDEX_BUFFER state.
+    //! Must be recorded outside of a render pass. Returns
+    //! ERROR_LIMIT_EXCEEDED if a copy has more than 4M triangles or the
+    //! buffers would be larger than 4GB.
+    Result Record(grfx::CommandBuffer* pCmd, const grfx::GeneratedMeshInfo& info, grfx::Mesh** ppMesh);
+
+    //! Releases the resources of recorded work
+    void Reset();
+
+    //! Returns the number of meshes recorded since the last Reset()
+    uint32_t GetMeshCount() const { return CountU32(mJobs); }
+
+    //! Returns the vertex and triangle count of one copy of the shape
+    static uint32_t GetVertexCount(const grfx::GeneratedMeshInfo& info);
+    static uint32_t GetTriangleCount(const grfx::GeneratedMeshInfo& info);
+
+private:
+    struct Job
+    {
+        grfx::BufferPtr        translations;
+        grfx::DescriptorSetPtr set;
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::MeshGeneratorCreateInfo& createInfo);
+    void   DestroyJob(Job& job);
+
+private:
+    grfx::Device*                mDevice       = nullptr;
+    uint32_t                     mMaxMeshCount = 0;
+    grfx::DescriptorPoolPtr      mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr mSetLayout;
+    grfx::PipelineInterfacePtr   mPipelineInterface;
+    grfx::ComputePipelinePtr     mPipeline;
+    std::vector<Job>             mJobs;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_mesh_generator_h
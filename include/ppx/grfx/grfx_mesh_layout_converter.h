@@ -0,0 +1,92 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_mesh_layout_converter_h
+#define ppx_grfx_mesh_layout_converter_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_mesh.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct MeshLayoutInfo
+//!
+//! Vertex buffer layout to convert a mesh to. Attributes are matched to
+//! the source mesh's by vertex semantic and must have the same format.
+//! Strides and offsets are calculated like MeshCreateInfo's.
+//!
+struct MeshLayoutInfo
+{
+    uint32_t                          vertexBufferCount = 0;
+    grfx::MeshVertexBufferDescription vertexBuffers[2]  = {};
+};
+
+struct MeshLayoutConverterCreateInfo
+{
+    grfx::ShaderModule* pShader      = nullptr; // basic/shaders/ConvertVertexLayout.cs
+    uint32_t            maxMeshCount = 16;      // Meshes Record() can convert between Reset() calls
+};
+
+//! @class MeshLayoutConverter
+//!
+//! Creates meshes that hold the vertices of an existing mesh in a different
+//! vertex buffer layout, e.g. interleaved from position planar, by copying
+//! them with a compute shader. Nothing is uploaded from the CPU and the
+//! converted mesh shares the source mesh's index buffer, see
+//! MeshCreateInfo::pIndexSource.
+//!
+//! Source meshes need MeshCreateInfo::storageBuffers, at most 2 vertex
+//! buffers and at most 4 attributes whose sizes are multiples of 4 bytes.
+//! The descriptor sets of recorded work are kept until Reset(), which must
+//! only be called once the command buffers Record() was called with have
+//! completed.
+//!
+class MeshLayoutConverter
+{
+public:
+    MeshLayoutConverter();
+    virtual ~MeshLayoutConverter();
+
+    static Result Create(grfx::Device* pDevice, const grfx::MeshLayoutConverterCreateInfo& createInfo, grfx::MeshLayoutConverter** ppConverter);
+
+    //! Creates *ppMesh with the layout of info and records the copy of
+    //! pSrcMesh's vertices into pCmd. The vertex buffers of both meshes
+    //! end up in VERTEX_BUFFER state. Must be recorded outside of a render
+    //! pass and pSrcMesh must outlive *ppMesh.
+    Result Record(grfx::CommandBuffer* pCmd, const grfx::Mesh* pSrcMesh, const grfx::MeshLayoutInfo& info, grfx::Mesh** ppMesh);
+
+    //! Releases the resources of recorded work
+    void Reset();
+
+    //! Returns the number of meshes recorded since the last Reset()
+    uint32_t GetMeshCount() const { return CountU32(mSets); }
+
+private:
+    Result Initialize(grfx::Device* pDevice, const grfx::MeshLayoutConverterCreateInfo& createInfo);
+
+private:
+    grfx::Device*                       mDevice       = nullptr;
+    uint32_t                            mMaxMeshCount = 0;
+    grfx::DescriptorPoolPtr             mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr        mSetLayout;
+    grfx::PipelineInterfacePtr          mPipelineInterface;
+    grfx::ComputePipelinePtr            mPipeline;
+    std::vector<grfx::DescriptorSetPtr> mSets;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_mesh_layout_converter_h
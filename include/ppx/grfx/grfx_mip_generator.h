@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_mip_generator_h
+#define ppx_grfx_mip_generator_h
+
+#include "ppx/grfx/grfx_config.h"
+
+namespace ppx {
+namespace grfx {
+
+struct MipGeneratorCreateInfo
+{
+    grfx::ShaderModule* pShader          = nullptr; // basic/shaders/GenerateMips.cs
+    uint32_t            maxDispatchCount = 32;      // Dispatches Record() can add up between Reset() calls
+};
+
+//! @class MipGenerator
+//!
+//! Generates the mip chain of 2D, 2D array and cube images from their first
+//! level with a compute shader. Each dispatch box filters up to
+//! kLevelsPerDispatch levels of every array layer, so a 4096x4096 image
+//! takes three dispatches.
+//!
+//! Images need storage and sampled usage and a UNORM, SNORM or FLOAT color
+//! format. sRGB formats can't be storage images, images holding sRGB data
+//! should use the matching UNORM format and set srgb so filtering happens
+//! in linear space.
+//!
+//! Descriptor sets of recorded dispatches are kept until Reset(), which must
+//! only be called once the command buffers Record() was called with have
+//! completed. The per level views are cached by the image, so recording the
+//! same image again doesn't create new ones.
+//!
+class MipGenerator
+{
+public:
+    static constexpr uint32_t kLevelsPerDispatch = 4;
+
+    MipGenerator();
+    virtual ~MipGenerator();
+
+    static Result Create(grfx::Device* pDevice, const grfx::MipGeneratorCreateInfo& createInfo, grfx::MipGenerator** ppGenerator);
+
+    //! Records generation of every level after the first into pCmd. The first
+    //! level must be in level0State, the contents of the other levels are
+    //! discarded. All subresources end up in stateAfter. Must be recorded
+    //! outside of a render pass.
+    Result Record(
+        grfx::CommandBuffer* pCmd,
+        grfx::Image*         pImage,
+        grfx::ResourceState  level0State,
+        grfx::ResourceState  stateAfter,
+        bool                 srgb = false);
+
+    //! Releases the descriptor sets of recorded dispatches
+    void Reset();
+
+    //! Returns the number of dispatches recorded since the last Reset()
+    uint32_t GetDispatchCount() const { return CountU32(mDispatches); }
+
+    //! Returns true if Record() supports pImage
+    static bool IsSupported(const grfx::Image* pImage);
+
+private:
+    struct DispatchResources
+    {
+        grfx::DescriptorSetPtr set;
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::MipGeneratorCreateInfo& createInfo);
+    Result AddDispatch(grfx::Image* pImage, uint32_t srcLevel, uint32_t levelCount);
+    void   DestroyDispatch(DispatchResources& dispatch);
+
+private:
+    grfx::Device*                  mDevice           = nullptr;
+    uint32_t                       mMaxDispatchCount = 0;
+    grfx::DescriptorPoolPtr        mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr   mSetLayout;
+    grfx::PipelineInterfacePtr     mPipelineInterface;
+    grfx::ComputePipelinePtr       mPipeline;
+    std::vector<DispatchResources> mDispatches;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_mip_generator_h
@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_object_table_h
+#define ppx_grfx_object_table_h
+
+#include "ppx/grfx/grfx_config.h"
+
+#include <memory>
+#include <vector>
+
+namespace ppx {
+namespace grfx {
+
+//! @class ObjectTable
+//!
+//! Slot map of the objects of one type created by a grfx::Device. Objects
+//! store their slot and its generation in their ObjectTableEntry, so
+//! Insert() and Remove() are O(1) where searching a vector made destroying
+//! thousands of objects quadratic. Remove() ignores objects whose slot or
+//! generation doesn't match, i.e. objects that aren't in this table.
+//!
+//! Slots are allocated in pages that never move and freed slots are reused
+//! first, so a steady state of creates and destroys doesn't allocate.
+//!
+template <typename ObjectT>
+class ObjectTable
+{
+public:
+    static constexpr uint32_t kPageSize = 256;
+
+    ObjectTable() {}
+    ~ObjectTable() {}
+
+    uint32_t GetCount() const { return mCount; }
+    bool     IsEmpty() const { return (mCount == 0); }
+
+    void Insert(ObjectT* pObject)
+    {
+        uint32_t slotIndex = 0;
+        if (!mFreeSlots.empty()) {
+            slotIndex = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else {
+            slotIndex = mSlotCount++;
+            if ((slotIndex / kPageSize) == mPages.size()) {
+                mPages.push_back(std::unique_ptr<Slot[]>(new Slot[kPageSize]));
+            }
+        }
+
+        Slot& slot  = GetSlot(slotIndex);
+        slot.object = pObject;
+
+        ObjectTableEntry* pEntry = pObject;
+        pEntry->mTableSlot       = slotIndex;
+        pEntry->mTableGeneration = slot.generation;
+        ++mCount;
+    }
+
+    //! Returns false if pObject isn't in the table
+    bool Remove(const ObjectT* pObject)
+    {
+        const ObjectTableEntry* pEntry = pObject;
+        if (pEntry->mTableSlot >= mSlotCount) {
+            return false;
+        }
+
+        Slot& slot = GetSlot(pEntry->mTableSlot);
+        if ((slot.object.Get() != pObject) || (slot.generation != pEntry->mTableGeneration)) {
+            return false;
+        }
+
+        slot.object.Reset();
+        ++slot.generation;
+        mFreeSlots.push_back(pEntry->mTableSlot);
+        --mCount;
+        return true;
+    }
+
+    bool Contains(const ObjectT* pObject) const
+    {
+        const ObjectTableEntry* pEntry = pObject;
+        if (pEntry->mTableSlot >= mSlotCount) {
+            return false;
+        }
+        const Slot& slot = GetSlot(pEntry->mTableSlot);
+        return (slot.object.Get() == pObject) && (slot.generation == pEntry->mTableGeneration);
+    }
+
+    //! Calls fn for each object in slot order. fn may remove objects from
+    //! the table, objects inserted during the iteration may be skipped.
+    template <typename FnT>
+    void ForEach(FnT fn) const
+    {
+        for (uint32_t i = 0; i < mSlotCount; ++i) {
+            ObjectT* pObject = GetSlot(i).object.Get();
+            if (!IsNull(pObject)) {
+                fn(pObject);
+            }
+        }
+    }
+
+    //! Forgets every object without destroying them
+    void Clear()
+    {
+        mPages.clear();
+        mFreeSlots.clear();
+        mSlotCount = 0;
+        mCount     = 0;
+    }
+
+private:
+    struct Slot
+    {
+        ObjPtr<ObjectT> object;
+        uint32_t        generation = 0;
+    };
+
+    Slot&       GetSlot(uint32_t index) { return mPages[index / kPageSize][index % kPageSize]; }
+    const Slot& GetSlot(uint32_t index) const { return mPages[index / kPageSize][index % kPageSize]; }
+
+private:
+    std::vector<std::unique_ptr<Slot[]>> mPages;
+    std::vector<uint32_t>                mFreeSlots;
+    uint32_t                             mSlotCount = 0; // Slots ever used
+    uint32_t                             mCount     = 0; // Slots holding an object
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_object_table_h
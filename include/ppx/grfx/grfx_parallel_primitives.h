@@ -0,0 +1,175 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_grfx_parallel_primitives_h
+#define ppx_grfx_parallel_primitives_h
+
+#include "ppx/grfx/grfx_config.h"
+
+#include <array>
+#include <map>
+
+namespace ppx {
+namespace grfx {
+
+struct ParallelPrimitivesParams;
+
+//! @struct ParallelPrimitivesShaders
+//!
+//! Kernels of basic/shaders/ParallelPrimitives.hlsl. The subgroup variants
+//! are the ScanReduceSubgroup.cs, ScanDownsweepSubgroup.cs and
+//! RadixScatterSubgroup.cs outputs of the same file, CompactScatter.cs and
+//! RadixHistogram.cs have none and are used for both.
+//!
+struct ParallelPrimitivesShaders
+{
+    grfx::ShaderModule* pScanReduce     = nullptr; // basic/shaders/ScanReduce.cs
+    grfx::ShaderModule* pScanDownsweep  = nullptr; // basic/shaders/ScanDownsweep.cs
+    grfx::ShaderModule* pCompactScatter = nullptr; // basic/shaders/CompactScatter.cs
+    grfx::ShaderModule* pRadixHistogram = nullptr; // basic/shaders/RadixHistogram.cs
+    grfx::ShaderModule* pRadixScatter   = nullptr; // basic/shaders/RadixScatter.cs
+};
+
+struct ParallelPrimitivesCreateInfo
+{
+    grfx::ParallelPrimitivesShaders shaders         = {};
+    grfx::ParallelPrimitivesShaders subgroupShaders = {};       // Optional, used if all are set and the GPU supports them
+    uint32_t                        maxElementCount = 1u << 20; // Most elements of a single scan, compaction or sort
+    uint32_t                        maxBufferSets   = 16;       // Distinct combinations of buffers the Record*() calls are made with
+};
+
+//! @class ParallelPrimitives
+//!
+//! Exclusive prefix sum, stream compaction and radix sort of 32 bit
+//! unsigned integers in structured buffers, recorded on compute command
+//! buffers.
+//!
+//! Scans are reduce-then-scan: tiles of 1024 elements are summed, the
+//! tile sums are scanned the same way until they fit in a single tile,
+//! and the tiles are then scanned with their tile's offset added. The sort
+//! is a least significant digit radix sort with 8 bit digits, each pass
+//! counts the digits of every tile, scans the counts with the scan above
+//! and scatters the keys stably. Every kernel reads each element once or
+//! twice, so the cost is a few passes over memory per scan and per digit.
+//!
+//! The subgroup kernels scan and rank within a subgroup with wave
+//! intrinsics instead of shared memory loops. They are used when the
+//! subgroup shaders are set and the GPU reports basic, arithmetic and
+//! ballot subgroup operations with subgroups of at least
+//! kMinSubgroupSize lanes, see UsesSubgroupOps().
+//!
+//! Buffers are structured buffers of uint with rwStructuredBuffer usage,
+//! counts are in elements. Buffers are expected in UNORDERED_ACCESS and
+//! stay in it, with a barrier after the last write. Descriptor sets are
+//! cached per combination of buffers until Reset(), which must only be
+//! called once the recorded work completed, like grfx::IBLGenerator.
+//!
+class ParallelPrimitives
+{
+public:
+    static constexpr uint32_t kTileSize        = 1024;
+    static constexpr uint32_t kRadixBits       = 8;
+    static constexpr uint32_t kMinSubgroupSize = 16;
+
+    ParallelPrimitives();
+    virtual ~ParallelPrimitives();
+
+    static Result Create(grfx::Device* pDevice, const grfx::ParallelPrimitivesCreateInfo& createInfo, grfx::ParallelPrimitives** ppPrimitives);
+
+    //! Writes the exclusive prefix sum of the first count elements of
+    //! pInput to pOutput, which may be the same buffer. Sums wrap at 2^32.
+    Result RecordScan(grfx::CommandBuffer* pCmd, grfx::Buffer* pInput, grfx::Buffer* pOutput, uint32_t count);
+
+    //! Writes the elements of pInput whose element in pFlags is non-zero to
+    //! pOutput in their order, and their number to the first element of
+    //! pCount. pOutput must not be pInput.
+    Result RecordCompact(grfx::CommandBuffer* pCmd, grfx::Buffer* pInput, grfx::Buffer* pFlags, grfx::Buffer* pOutput, grfx::Buffer* pCount, uint32_t count);
+
+    //! Sorts the first count elements of pKeys in ascending order, moving
+    //! the elements of pValues with them if it isn't null. Only the low
+    //! keyBits bits of the keys are compared. The temp buffers hold count
+    //! elements and their contents are overwritten. The sort is stable.
+    Result RecordSort(
+        grfx::CommandBuffer* pCmd,
+        grfx::Buffer*        pKeys,
+        grfx::Buffer*        pValues,
+        grfx::Buffer*        pTempKeys,
+        grfx::Buffer*        pTempValues,
+        uint32_t             count,
+        uint32_t             keyBits = 32);
+
+    //! Frees the cached descriptor sets
+    void Reset();
+
+    bool     UsesSubgroupOps() const { return mUsesSubgroupOps; }
+    uint32_t GetMaxElementCount() const { return mMaxElementCount; }
+
+    //! Returns true if pDevice's GPU can run the subgroup kernels
+    static bool SupportsSubgroupOps(const grfx::Device* pDevice);
+
+private:
+    enum Kernel
+    {
+        KERNEL_SCAN_REDUCE     = 0,
+        KERNEL_SCAN_DOWNSWEEP  = 1,
+        KERNEL_COMPACT_SCATTER = 2,
+        KERNEL_RADIX_HISTOGRAM = 3,
+        KERNEL_RADIX_SCATTER   = 4,
+        KERNEL_COUNT           = 5,
+    };
+
+    // Buffers bound to the input keys, output keys, input values, output
+    // values and count registers, null binds the scratch buffer
+    using BufferSetKey = std::array<const grfx::Buffer*, 5>;
+
+    // Source or destination of a scan level
+    enum ScanTarget
+    {
+        SCAN_TARGET_KEYS    = 0, // Input or output keys
+        SCAN_TARGET_VALUES  = 1, // Input values
+        SCAN_TARGET_SCRATCH = 2,
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::ParallelPrimitivesCreateInfo& createInfo);
+    Result GetBufferSet(const BufferSetKey& key, const grfx::DescriptorSet** ppSet);
+    void   RecordScanLevels(
+          grfx::CommandBuffer*       pCmd,
+          const grfx::DescriptorSet* pSet,
+          ScanTarget                 input,
+          uint32_t                   inputOffset,
+          ScanTarget                 output,
+          uint32_t                   outputOffset,
+          uint32_t                   count);
+    void   Dispatch(grfx::CommandBuffer* pCmd, Kernel kernel, const grfx::DescriptorSet* pSet, const grfx::ParallelPrimitivesParams& params, uint32_t groupCount);
+    void   UAVBarrier(grfx::CommandBuffer* pCmd, const grfx::Buffer* pBuffer);
+
+private:
+    grfx::Device*                                      mDevice          = nullptr;
+    uint32_t                                           mMaxElementCount = 0;
+    uint32_t                                           mMaxBufferSets   = 0;
+    uint32_t                                           mPartialsOffset  = 0; // Of the tile sums in the scratch buffer
+    bool                                               mUsesSubgroupOps = false;
+    grfx::BufferPtr                                    mScratchBuffer;
+    grfx::DescriptorPoolPtr                            mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr                       mSetLayout;
+    grfx::PipelineInterfacePtr                         mPipelineInterface;
+    std::array<grfx::ComputePipelinePtr, KERNEL_COUNT> mPipelines;
+    std::map<BufferSetKey, grfx::DescriptorSetPtr>     mBufferSets;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_parallel_primitives_h
@@ -17,13 +17,45 @@
 
 #include "ppx/grfx/grfx_config.h"
 
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
 namespace ppx {
 namespace grfx {
 
+//! @struct SpecializationConstant
+//!
+//! 32-bit specialization constant, \b value is the bit pattern of a bool,
+//! int, uint or float constant. HLSL declares them with
+//! [[vk::constant_id(id)]].
+//!
+struct SpecializationConstant
+{
+    uint32_t id    = 0;
+    uint32_t value = 0;
+
+    static SpecializationConstant Bool(uint32_t id, bool value) { return {id, value ? 1u : 0u}; }
+    static SpecializationConstant Int(uint32_t id, int32_t value) { return {id, static_cast<uint32_t>(value)}; }
+    static SpecializationConstant UInt(uint32_t id, uint32_t value) { return {id, value}; }
+    static SpecializationConstant Float(uint32_t id, float value)
+    {
+        SpecializationConstant constant = {id, 0};
+        std::memcpy(&constant.value, &value, sizeof(value));
+        return constant;
+    }
+};
+
+//! @struct ShaderStageInfo
+//!
+//! D3D12 has no specialization constants, pipelines created from DXIL use
+//! the default values the shader declares.
+//!
 struct ShaderStageInfo
 {
-    const grfx::ShaderModule* pModule    = nullptr;
-    std::string               entryPoint = "";
+    const grfx::ShaderModule*                 pModule    = nullptr;
+    std::string                               entryPoint = "";
+    std::vector<grfx::SpecializationConstant> specializationConstants;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -47,6 +79,10 @@ public:
     ComputePipeline() {}
     virtual ~ComputePipeline() {}
 
+    //! Shader modules and the pipeline interface are only valid while the
+    //! objects the pipeline was created with are alive
+    const grfx::ComputePipelineCreateInfo& GetCreateInfo() const { return mCreateInfo; }
+
 protected:
     virtual Result Create(const grfx::ComputePipelineCreateInfo* pCreateInfo) override;
     friend class grfx::Device;
@@ -153,8 +189,37 @@ struct OutputState
     grfx::Format depthStencilFormat                          = grfx::FORMAT_UNDEFINED;
 };
 
+//! @struct DynamicState
+//!
+//! Pipeline state that's set on the command buffer instead of being baked
+//! into the pipeline, so toggling it doesn't need another pipeline. The
+//! matching grfx::CommandBuffer setter must be recorded after binding the
+//! pipeline and before drawing with it. The values in the rest of the
+//! create info are ignored for dynamic state.
+//!
+//! cullMode, primitiveTopology, depthTestEnable and depthWriteEnable
+//! require grfx::Device::ExtendedDynamicStateSupported(), blendEnable
+//! requires grfx::Device::DynamicBlendEnableSupported(). A dynamic
+//! topology must stay in the same class (points, lines, triangles or
+//! patches) as the pipeline's topology.
+//!
+struct DynamicState
+{
+    bool cullMode          = false; // CommandBuffer::SetCullMode()
+    bool primitiveTopology = false; // CommandBuffer::SetPrimitiveTopology()
+    bool depthTestEnable   = false; // CommandBuffer::SetDepthTestEnable()
+    bool depthWriteEnable  = false; // CommandBuffer::SetDepthWriteEnable()
+    bool blendEnable       = false; // CommandBuffer::SetBlendEnable(), blend factors and ops stay baked
+};
+
 //! @struct GraphicsPipelineCreateInfo
 //!
+//! shaderObjects asks for the pipeline to be bound as shader objects with
+//! all of its state set dynamically instead of as a pipeline object. It
+//! falls back to a pipeline object if grfx::Device::ShaderObjectsSupported()
+//! is false or the pipeline can't use shader objects: mesh shaders,
+//! shading rate and multiview pipelines and pipelines that need a render
+//! pass.
 //!
 struct GraphicsPipelineCreateInfo
 {
@@ -162,6 +227,8 @@ struct GraphicsPipelineCreateInfo
     grfx::ShaderStageInfo          HS                 = {};
     grfx::ShaderStageInfo          DS                 = {};
     grfx::ShaderStageInfo          GS                 = {};
+    grfx::ShaderStageInfo          AS                 = {}; // Amplification (task) shader, requires MS
+    grfx::ShaderStageInfo          MS                 = {}; // Mesh shader, replaces VS/HS/DS/GS and the vertex input
     grfx::ShaderStageInfo          PS                 = {};
     grfx::VertexInputState         vertexInputState   = {};
     grfx::InputAssemblyState       inputAssemblyState = {};
@@ -175,11 +242,21 @@ struct GraphicsPipelineCreateInfo
     grfx::MultiViewState           multiViewState     = {};
     const grfx::PipelineInterface* pPipelineInterface = nullptr;
     bool                           dynamicRenderPass  = false;
+    grfx::DynamicState             dynamicState       = {};
+    bool                           shaderObjects      = false;
 };
 
+//! @struct GraphicsPipelineCreateInfo2
+//!
+//! Setting MS creates a mesh shader pipeline: VS and vertexInputState must
+//! be empty, topology is ignored and draws are issued with DrawMeshTasks().
+//! See grfx::GraphicsPipelineCreateInfo for shaderObjects.
+//!
 struct GraphicsPipelineCreateInfo2
 {
     grfx::ShaderStageInfo          VS                                 = {};
+    grfx::ShaderStageInfo          AS                                 = {};
+    grfx::ShaderStageInfo          MS                                 = {};
     grfx::ShaderStageInfo          PS                                 = {};
     grfx::VertexInputState         vertexInputState                   = {};
     grfx::PrimitiveTopology        topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -195,6 +272,8 @@ struct GraphicsPipelineCreateInfo2
     grfx::MultiViewState           multiViewState                     = {};
     const grfx::PipelineInterface* pPipelineInterface                 = nullptr;
     bool                           dynamicRenderPass                  = false;
+    grfx::DynamicState             dynamicState                       = {};
+    bool                           shaderObjects                      = false;
 };
 
 namespace internal {
@@ -215,6 +294,10 @@ public:
     GraphicsPipeline() {}
     virtual ~GraphicsPipeline() {}
 
+    //! Shader modules and the pipeline interface are only valid while the
+    //! objects the pipeline was created with are alive
+    const grfx::GraphicsPipelineCreateInfo& GetCreateInfo() const { return mCreateInfo; }
+
 protected:
     virtual Result Create(const grfx::GraphicsPipelineCreateInfo* pCreateInfo) override;
     friend class grfx::Device;
@@ -222,6 +305,89 @@ protected:
 
 // -------------------------------------------------------------------------------------------------
 
+//! @class AsyncPipeline
+//!
+//! Handle to a pipeline that is being compiled on one of the device's
+//! pipeline compile threads. See grfx::Device::CreateGraphicsPipelineAsync
+//! and grfx::Device::CreateComputePipelineAsync.
+//!
+//! The handle can be polled with IsReady() every frame; the pipeline
+//! returned by Get() is owned by the device like any other pipeline and
+//! must be destroyed with the matching Device::Destroy* call. Copies of a
+//! handle refer to the same compilation.
+//!
+template <typename PipelineT>
+class AsyncPipeline
+{
+public:
+    AsyncPipeline() {}
+    ~AsyncPipeline() {}
+
+    // Returns true if this handle refers to a compilation
+    bool IsValid() const { return mState != nullptr; }
+
+    // Returns true once the compilation has finished, whether or not it succeeded
+    bool IsReady() const
+    {
+        if (!mState) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        return mState->ready;
+    }
+
+    // Blocks until the compilation finishes and returns its result
+    Result Wait() const
+    {
+        if (!mState) {
+            return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+        }
+        std::unique_lock<std::mutex> lock(mState->mutex);
+        mState->readyCondition.wait(lock, [this] { return mState->ready; });
+        return mState->result;
+    }
+
+    // Result of the compilation, ppx::ERROR_WAIT_TIMED_OUT if it hasn't finished yet
+    Result GetResult() const
+    {
+        if (!mState) {
+            return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+        }
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        return mState->ready ? mState->result : ppx::ERROR_WAIT_TIMED_OUT;
+    }
+
+    // Returns the pipeline if the compilation finished successfully, nullptr otherwise
+    ObjPtr<PipelineT> Get() const
+    {
+        if (!mState) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(mState->mutex);
+        return (mState->ready && (mState->result == ppx::SUCCESS)) ? mState->pPipeline : nullptr;
+    }
+
+    void Reset() { mState.reset(); }
+
+private:
+    struct State
+    {
+        std::mutex              mutex;
+        std::condition_variable readyCondition;
+        bool                    ready     = false;
+        Result                  result    = ppx::ERROR_FAILED;
+        PipelineT*              pPipeline = nullptr;
+    };
+
+    std::shared_ptr<State> mState;
+    friend class grfx::Device;
+};
+
+using AsyncGraphicsPipeline = AsyncPipeline<grfx::GraphicsPipeline>;
+using AsyncComputePipeline  = AsyncPipeline<grfx::ComputePipeline>;
+
+// -------------------------------------------------------------------------------------------------
+
 //! @struct PipelineInterfaceCreateInfo
 //!
 //!
@@ -268,6 +434,10 @@ public:
     bool                         HasConsecutiveSetNumbers() const { return mHasConsecutiveSetNumbers; }
     const std::vector<uint32_t>& GetSetNumbers() const { return mSetNumbers; }
 
+    //! Set layouts are only valid while the layouts the interface was
+    //! created with are alive
+    const grfx::PipelineInterfaceCreateInfo& GetCreateInfo() const { return mCreateInfo; }
+
     const grfx::DescriptorSetLayout* GetSetLayout(uint32_t setNumber) const;
 
 protected:
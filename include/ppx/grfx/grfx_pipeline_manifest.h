@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_pipeline_manifest_h
+#define ppx_grfx_pipeline_manifest_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/grfx/grfx_shader.h"
+
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ppx {
+namespace grfx {
+
+//! @class PipelineManifest
+//!
+//! Records the create info of every pipeline a device creates, so later
+//! runs can build all of them before the first frame with Precompile()
+//! instead of compiling each one the first time it's used. Pipelines
+//! created afterwards with the same create info are found in the driver's
+//! pipeline cache, which DeviceCreateInfo::pipelineCachePath keeps across
+//! runs.
+//!
+//! Shaders are stored as bytecode and pipeline interfaces as their set
+//! layouts, so a manifest is only valid for the API and the build of the
+//! application it was recorded with. Pipelines whose set layouts have
+//! immutable samplers aren't recorded.
+//!
+//! Enabled with DeviceCreateInfo::pipelineManifestPath, see
+//! Device::PrecompilePipelines() and Device::SavePipelineManifest().
+//! Recording is thread safe.
+//!
+class PipelineManifest
+{
+public:
+    PipelineManifest() {}
+    ~PipelineManifest() {}
+
+    void RecordShaderModule(const grfx::ShaderModule* pModule, const grfx::ShaderModuleCreateInfo* pCreateInfo);
+    void RecordPipeline(const grfx::ComputePipelineCreateInfo* pCreateInfo);
+    void RecordPipeline(const grfx::GraphicsPipelineCreateInfo* pCreateInfo);
+
+    uint32_t GetPipelineCount() const;
+
+    //! Adds the pipelines of the manifest at path to this one
+    Result Load(const std::filesystem::path& path);
+    Result Save(const std::filesystem::path& path) const;
+
+    //! Creates every pipeline on the device's pipeline compile threads,
+    //! waits for them and destroys them again. Pipelines that fail to
+    //! compile are skipped with a warning.
+    Result Precompile(grfx::Device* pDevice, uint32_t* pPipelineCount = nullptr) const;
+
+private:
+    bool RecordStage(const grfx::ShaderStageInfo& stage, std::vector<char>& data) const;
+    void AddPipeline(std::vector<char>&& data);
+
+private:
+    mutable std::mutex                                      mMutex;
+    std::unordered_map<const grfx::ShaderModule*, uint64_t> mModuleHashes;
+    std::unordered_map<uint64_t, std::vector<char>>         mShaders;   // Bytecode by XXH3 hash
+    std::unordered_map<uint64_t, std::vector<char>>         mPipelines; // Serialized create info by XXH3 hash
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_pipeline_manifest_h
@@ -0,0 +1,127 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_post_process_chain_h
+#define ppx_grfx_post_process_chain_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_render_graph.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct PostProcessPassInfo
+//!
+//! One fullscreen pass of a grfx::PostProcessChain. graphicsFn draws into
+//! output with a render pass already begun (e.g. a grfx::FullscreenQuad),
+//! computeFn writes output as a storage image and gets a null render pass.
+//! At least one of them must be set.
+//!
+struct PostProcessPassInfo
+{
+    std::string                            name;
+    std::vector<grfx::RenderGraphResource> inputs; // Sampled by the pass
+    grfx::RenderGraphResource              output;
+    grfx::RenderGraphExecuteFn             graphicsFn;
+    grfx::RenderGraphExecuteFn             computeFn;
+};
+
+//! @struct PostProcessChainCreateInfo
+//!
+//!
+struct PostProcessChainCreateInfo
+{
+    bool preferCompute  = false; // Dispatch passes that have a computeFn instead of drawing them
+    bool mergePasses    = true;  // Record compatible graphics passes in one render pass
+    bool enableAliasing = true;  // Forwarded to the grfx::RenderGraph
+};
+
+//! @class PostProcessChain
+//!
+//! Ordered list of fullscreen passes recorded through a grfx::RenderGraph.
+//! Each pass would normally get its own render pass, which on tile based
+//! GPUs means storing the target to memory and loading it back for every
+//! effect.
+//!
+//! With mergePasses, consecutive graphics passes that write the same
+//! output and don't sample it are recorded in a single render pass, so
+//! the target stays on tile between them. That covers the composite style
+//! effects (vignette, grain, overlays, bloom add) which blend onto the
+//! previous result with the fixed function blender instead of reading it;
+//! see grfx::FullscreenQuadCreateInfo::blendMode. A pass that samples the
+//! output of the current group starts a new render pass.
+//!
+//! With preferCompute, passes with a computeFn are dispatched instead,
+//! which avoids render pass setup entirely on desktop GPUs. Those passes
+//! are never merged; passes without a computeFn still draw.
+//!
+class PostProcessChain
+    : public grfx::DeviceObject<grfx::PostProcessChainCreateInfo>
+{
+public:
+    PostProcessChain() {}
+    virtual ~PostProcessChain() {}
+
+    grfx::RenderGraphResource AddImage(const grfx::RenderGraphImageCreateInfo& createInfo);
+    grfx::RenderGraphResource ImportImage(const grfx::RenderGraphImportInfo& importInfo);
+    void                      SetImportedImage(grfx::RenderGraphResource image, grfx::Image* pImage);
+
+    void AddPass(const grfx::PostProcessPassInfo& passInfo);
+
+    // Declarations can't change after the first Compile(), calling it
+    // again only recompiles the render graph
+    Result Compile();
+    void   Execute(grfx::CommandBuffer* pCommandBuffer);
+
+    grfx::ImagePtr       GetImage(grfx::RenderGraphResource image) const;
+    grfx::RenderGraphPtr GetRenderGraph() const { return mRenderGraph; }
+
+    uint32_t GetPassCount() const { return CountU32(mPasses); }
+
+    // Only valid after Compile(), culled passes aren't counted
+    uint32_t GetRenderPassCount() const { return mRenderPassCount; }
+    uint32_t GetComputePassCount() const { return mComputePassCount; }
+    uint32_t GetMergedPassCount() const { return mMergedPassCount; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::PostProcessChainCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    // Graph pass recording one or more chain passes
+    struct GraphPass
+    {
+        grfx::RenderGraphPass* pPass     = nullptr;
+        bool                   compute   = false;
+        uint32_t               passCount = 0;
+    };
+
+    bool UsesCompute(const grfx::PostProcessPassInfo& passInfo) const;
+    void AddGraphPass(const std::vector<uint32_t>& passIndices, bool compute);
+    void BuildGraph();
+
+private:
+    grfx::RenderGraphPtr                   mRenderGraph;
+    std::vector<grfx::PostProcessPassInfo> mPasses;
+    std::vector<GraphPass>                 mGraphPasses;
+    bool                                   mBuilt            = false;
+    uint32_t                               mRenderPassCount  = 0;
+    uint32_t                               mComputePassCount = 0;
+    uint32_t                               mMergedPassCount  = 0;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_post_process_chain_h
@@ -17,6 +17,7 @@
 
 #include "ppx/grfx/grfx_config.h"
 #include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_image.h"
 
 namespace ppx {
 namespace grfx {
@@ -34,6 +35,32 @@ struct SubmitInfo
     grfx::Fence*                      pFence               = nullptr;
 };
 
+//! @struct SparseImageBindInfo
+//!
+//! Tiles of a sparse resident image to bind memory to and to unbind. Binding
+//! takes a tile worth of device memory from the image, unbinding gives it
+//! back to the image for later binds. The memory is only freed when the
+//! image is destroyed. Contents of newly bound tiles are undefined.
+//!
+//! Binds aren't ordered with submissions on the same queue, work that uses
+//! the tiles (or used the unbound tiles) is ordered with the semaphores.
+//!
+struct SparseImageBindInfo
+{
+    grfx::Image*                  pImage               = nullptr;
+    uint32_t                      bindTileCount        = 0;
+    const grfx::SparseImageTile*  pBindTiles           = nullptr;
+    uint32_t                      unbindTileCount      = 0;
+    const grfx::SparseImageTile*  pUnbindTiles         = nullptr;
+    uint32_t                      waitSemaphoreCount   = 0;
+    const grfx::Semaphore* const* ppWaitSemaphores     = nullptr;
+    std::vector<uint64_t>         waitValues           = {}; // Use 0 if index is binary semaphore
+    uint32_t                      signalSemaphoreCount = 0;
+    grfx::Semaphore**             ppSignalSemaphores   = nullptr;
+    std::vector<uint64_t>         signalValues         = {}; // Use 0 if index is binary semaphore
+    grfx::Fence*                  pFence               = nullptr;
+};
+
 namespace internal {
 
 //! @struct QueueCreateInfo
@@ -61,10 +88,22 @@ public:
 
     grfx::CommandType GetCommandType() const { return mCreateInfo.commandType; }
 
+    //! Returns true if resources written on this queue need a queue
+    //! family ownership transfer before they can be used on \b pOtherQueue.
+    //! D3D12 has no queue ownership so this is always false there.
+    virtual bool RequiresOwnershipTransfer(const grfx::Queue* pOtherQueue) const { return false; }
+
     virtual Result WaitIdle() = 0;
 
     virtual Result Submit(const grfx::SubmitInfo* pSubmitInfo) = 0;
 
+    //! Submits pSubmitInfos in order with as few API calls as possible.
+    //! Vulkan makes one vkQueueSubmit per run of submits that ends in a
+    //! submit with a fence, since a fence signals once all the work of its
+    //! call has completed. D3D12 makes one ExecuteCommandLists per run of
+    //! command buffers that isn't split by semaphore waits or signals.
+    virtual Result SubmitBatch(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos) = 0;
+
     // Timeline semaphore functions
     virtual Result QueueWait(grfx::Semaphore* pSemaphore, uint64_t value)   = 0;
     virtual Result QueueSignal(grfx::Semaphore* pSemaphore, uint64_t value) = 0;
@@ -72,12 +111,44 @@ public:
     // GPU timestamp frequency counter in ticks per second
     virtual Result GetTimestampFrequency(uint64_t* pFrequency) const = 0;
 
+    //! Returns the seconds to add to timestamps written on \b pOtherQueue,
+    //! in seconds of its own frequency, to compare them with timestamps
+    //! written on this queue. Vulkan only defines timestamp comparisons
+    //! within a queue but the queues of a device share the device clock, so
+    //! this is 0 there. D3D12 queues are calibrated against the CPU clock.
+    virtual Result GetTimestampOffset(const grfx::Queue* pOtherQueue, double* pSeconds) const;
+
+    //! Binds and unbinds tiles of a sparse resident image, see
+    //! grfx::SparseImageBindInfo. Binding a resident tile or unbinding a
+    //! tile that isn't resident does nothing. Only supported on the graphics
+    //! queue, residency is tracked when this is called.
+    Result BindSparseImageTiles(const grfx::SparseImageBindInfo* pBindInfo);
+
     Result CreateCommandBuffer(
         grfx::CommandBuffer** ppCommandBuffer,
         uint32_t              resourceDescriptorCount = PPX_DEFAULT_RESOURCE_DESCRIPTOR_COUNT,
         uint32_t              samplerDescriptorCount  = PPX_DEFAULT_SAMPLE_DESCRIPTOR_COUNT);
     void DestroyCommandBuffer(const grfx::CommandBuffer* pCommandBuffer);
 
+    //! Creates a secondary command buffer with its own command pool so
+    //! that it can be recorded on a different thread than any other
+    //! command buffer. Destroy with DestroyCommandBuffer.
+    Result CreateSecondaryCommandBuffer(
+        grfx::CommandBuffer** ppCommandBuffer,
+        uint32_t              resourceDescriptorCount = PPX_DEFAULT_RESOURCE_DESCRIPTOR_COUNT,
+        uint32_t              samplerDescriptorCount  = PPX_DEFAULT_SAMPLE_DESCRIPTOR_COUNT);
+
+    //! Creates a command buffer, primary or secondary, that can be recorded
+    //! once and resubmitted across frames, see 'reusable' in
+    //! grfx::internal::CommandBufferCreateInfo. Don't record into it again
+    //! while submissions may be pending, create a new one instead and
+    //! destroy the old one with Device::DeferDestroyCommandBuffer.
+    Result CreateReusableCommandBuffer(
+        grfx::CommandBuffer** ppCommandBuffer,
+        bool                  secondary               = false,
+        uint32_t              resourceDescriptorCount = PPX_DEFAULT_RESOURCE_DESCRIPTOR_COUNT,
+        uint32_t              samplerDescriptorCount  = PPX_DEFAULT_SAMPLE_DESCRIPTOR_COUNT);
+
     // In place copy of buffer to buffer
     Result CopyBufferToBuffer(
         const grfx::BufferToBufferCopyInfo* pCopyInfo,
@@ -99,6 +170,16 @@ public:
         grfx::ResourceState                             stateAfter);
 
 private:
+    // pBindInfo only holds tiles whose residency changes
+    virtual Result BindSparseImageTilesImpl(const grfx::SparseImageBindInfo* pBindInfo) = 0;
+
+    Result CreateCommandBufferImpl(
+        grfx::CommandBuffer** ppCommandBuffer,
+        uint32_t              resourceDescriptorCount,
+        uint32_t              samplerDescriptorCount,
+        bool                  secondary,
+        bool                  reusable);
+
     struct CommandSet
     {
         grfx::CommandPoolPtr   commandPool;
@@ -15,76 +15,250 @@
 #ifndef ppx_grfx_ray_tracing_h
 #define ppx_grfx_ray_tracing_h
 
-#if defined(PPX_ENABLE_RAYTRACING)
-
 #include "ppx/grfx/grfx_config.h"
-#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_buffer_pool.h"
+#include "ppx/grfx/grfx_query.h"
+#include "ppx/math_config.h"
+
+// D3D12 requires acceleration structures and scratch memory to be 256 byte
+// aligned, Vulkan's minAccelerationStructureScratchOffsetAlignment is at
+// most 256.
+#define PPX_ACCELERATION_STRUCTURE_ALIGNMENT 256
+
+// D3D12 requires instance data to be 16 byte aligned
+#define PPX_ACCELERATION_STRUCTURE_INSTANCE_ALIGNMENT 16
 
 namespace ppx {
 namespace grfx {
 
-struct BufferOrHostAddress
+//! @struct AccelerationStructureTriangles
+//!
+//! One triangle geometry of a bottom level acceleration structure. Vertex
+//! and index buffers need accelerationStructureInput usage. Only the
+//! position is read, vertexStride can step over other interleaved
+//! attributes. Without an index buffer every 3 vertices form a triangle.
+//!
+struct AccelerationStructureTriangles
 {
-    grfx::Buffer* pBuffer      = nullptr;
-    void*         pHostAddress = nullptr;
+    const grfx::Buffer* pVertexBuffer = nullptr;
+    uint64_t            vertexOffset  = 0;
+    uint32_t            vertexStride  = 0;
+    uint32_t            vertexCount   = 0;
+    grfx::Format        vertexFormat  = grfx::FORMAT_R32G32B32_FLOAT;
+    const grfx::Buffer* pIndexBuffer  = nullptr; // Optional
+    uint64_t            indexOffset   = 0;
+    grfx::IndexType     indexType     = grfx::INDEX_TYPE_UNDEFINED;
+    uint32_t            indexCount    = 0;
+    bool                opaque        = true; // Skips any hit processing
 };
 
-struct BufferOrHostAddressConst
+//! @struct AccelerationStructureInstance
+//!
+//! size = 64, matches VkAccelerationStructureInstanceKHR and
+//! D3D12_RAYTRACING_INSTANCE_DESC so an array of these can be copied to
+//! the instance buffer of a top level build as is.
+//!
+struct AccelerationStructureInstance
 {
-    const grfx::Buffer* pBuffer      = nullptr;
-    const void*         pHostAddress = nullptr;
+    float    transform[3][4]                        = {}; // Row major object to world, last row is implied
+    uint32_t instanceCustomIndex                    : 24; // CommittedInstanceID() in HLSL
+    uint32_t mask                                   : 8;  // Skipped if (mask & ray mask) is 0
+    uint32_t instanceShaderBindingTableRecordOffset : 24;
+    uint32_t flags                                  : 8;  // grfx::AccelerationStructureInstanceFlagBits
+    uint64_t accelerationStructureReference         = 0; // Bottom level AccelerationStructure::GetDeviceAddress()
+
+    AccelerationStructureInstance()
+        : instanceCustomIndex(0), mask(0xFF), instanceShaderBindingTableRecordOffset(0), flags(0) {}
+
+    void SetTransform(const float4x4& objectToWorld)
+    {
+        for (uint32_t r = 0; r < 3; ++r) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                transform[r][c] = objectToWorld[c][r];
+            }
+        }
+    }
 };
 
-struct AccelerationStructureGeometryTrianglesData
+//! @struct AccelerationStructureBuildInputs
+//!
+//! Bottom level structures are built from geometryCount triangle
+//! geometries, top level structures from instanceCount instances read from
+//! pInstanceBuffer, which needs accelerationStructureInput usage.
+//!
+//! An update must use the same type, flags and counts as the build of the
+//! structure it updates.
+//!
+struct AccelerationStructureBuildInputs
 {
-    grfx::Format                   vertexFormat  = grfx::FORMAT_UNDEFINED;
-    grfx::BufferOrHostAddressConst vertexData    = {};
-    uint32_t                       vertexStride  = 0;
-    uint32_t                       maxVertex     = 0;
-    grfx::IndexType                indexType     = grfx::INDEX_TYPE_UNDEFINED;
-    grfx::BufferOrHostAddressConst indexData     = {};
-    grfx::BufferOrHostAddressConst transformData = {};
+    grfx::AccelerationStructureType             type            = grfx::ACCELERATION_STRUCTURE_TYPE_UNDEFINED;
+    grfx::AccelerationStructureBuildFlags       flags           = grfx::ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+    uint32_t                                    geometryCount   = 0;
+    const grfx::AccelerationStructureTriangles* pGeometries     = nullptr;
+    uint32_t                                    instanceCount   = 0;
+    const grfx::Buffer*                         pInstanceBuffer = nullptr;
+    uint64_t                                    instanceOffset  = 0; // Must be PPX_ACCELERATION_STRUCTURE_INSTANCE_ALIGNMENT aligned
 };
 
-struct AccelerationStructureGeometryAabbsData
+//! @struct AccelerationStructureBuildSizes
+//!
+//!
+struct AccelerationStructureBuildSizes
 {
-    grfx::BufferOrHostAddressConst data   = {};
-    uint32_t                       stride = 0;
+    uint64_t accelerationStructureSize = 0;
+    uint64_t buildScratchSize          = 0;
+    uint64_t updateScratchSize         = 0;
 };
 
-struct AccelerationStructureGeometryInstancesData
+// -------------------------------------------------------------------------------------------------
+
+//! @struct AccelerationStructureCreateInfo
+//!
+//! size comes from Device::GetAccelerationStructureBuildSizes or, for
+//! compacted copies, from the compacted size query.
+//!
+struct AccelerationStructureCreateInfo
 {
-    grfx::BufferOrHostAddressConst data = {};
+    grfx::AccelerationStructureType type = grfx::ACCELERATION_STRUCTURE_TYPE_UNDEFINED;
+    uint64_t                        size = 0;
 };
 
-struct AccelerationStructureGeometryData
+//! @class AccelerationStructure
+//!
+//! Owns the buffer holding the structure. The contents are undefined until
+//! a build or copy into it has completed.
+//!
+class AccelerationStructure
+    : public grfx::DeviceObject<grfx::AccelerationStructureCreateInfo>
 {
-    AccelerationStructureGeometryTrianglesData triangles = {};
-    AccelerationStructureGeometryAabbsData     aabbs     = {};
-    AccelerationStructureGeometryInstancesData instances = {};
+public:
+    AccelerationStructure() {}
+    virtual ~AccelerationStructure() {}
+
+    grfx::AccelerationStructureType GetType() const { return mCreateInfo.type; }
+    uint64_t                        GetSize() const { return mCreateInfo.size; }
+    grfx::Buffer*                   GetBuffer() const { return mBuffer.Get(); }
+
+    // Value for AccelerationStructureInstance::accelerationStructureReference
+    virtual uint64_t GetDeviceAddress() const = 0;
+
+protected:
+    virtual Result Create(const grfx::AccelerationStructureCreateInfo* pCreateInfo) override;
+    virtual void   Destroy() override;
+    friend class grfx::Device;
+
+protected:
+    grfx::BufferPtr mBuffer;
 };
 
-struct AccelerationStructureGeometry
+//! @struct AccelerationStructureBuildInfo
+//!
+//! pSrc is only used by updates and can be the same as pDst for an in
+//! place update. The scratch range needs rawStorageBuffer and
+//! shaderDeviceAddress usage and must be PPX_ACCELERATION_STRUCTURE_ALIGNMENT
+//! aligned.
+//!
+struct AccelerationStructureBuildInfo
 {
-    grfx::RayTracingGeometryType            type  = grfx::RAY_TRACING_GEOMETRY_TYPE_TRIANGLES;
-    grfx::RayTracingGeometryFlags           flags = 0;
-    grfx::AccelerationStructureGeometryData data  = {};
+    const grfx::AccelerationStructureBuildInputs* pInputs       = nullptr;
+    grfx::AccelerationStructure*                  pDst          = nullptr;
+    const grfx::AccelerationStructure*            pSrc          = nullptr; // Non-null for updates
+    const grfx::Buffer*                           pScratch      = nullptr;
+    uint64_t                                      scratchOffset = 0;
 };
 
-struct AccelerationStructureBuildInfo
+// -------------------------------------------------------------------------------------------------
+
+//! @struct AccelerationStructureBuilderCreateInfo
+//!
+//!
+struct AccelerationStructureBuilderCreateInfo
+{
+    uint64_t scratchBudget = 64 * 1024 * 1024; // Scratch memory used by one batch of builds
+};
+
+//! @class AccelerationStructureBuilder
+//!
+//! Queues acceleration structure builds and updates and records them in
+//! as few batches as the scratch budget allows. Bottom level builds are
+//! recorded before top level builds, with a barrier in between, so both
+//! can be queued together as long as the top level instance buffer already
+//! holds the bottom level addresses. Scratch memory comes from a pool owned
+//! by the builder and is reused by later batches.
+//!
+//! Compaction takes two submissions: Record() writes the compacted size
+//! of every structure built with ALLOW_COMPACTION, and once that command
+//! buffer has completed RecordCompaction() creates and copies into
+//! structures of that size. Bottom level structures need to be compacted
+//! before the top level structures referencing them are built.
+//!
+//! Record() and RecordCompaction() reuse the scratch memory and query of
+//! the previous call, so the previous command buffer must have completed.
+//!
+//! Not thread safe.
+//!
+class AccelerationStructureBuilder
+    : public grfx::DeviceObject<grfx::AccelerationStructureBuilderCreateInfo>
 {
-    grfx::BuildAccelerationStructureFlags       flags                     = 0;
-    grfx::BuildAccelerationStructureMode        mode                      = grfx::BUILD_ACCELERATION_STRUCTURE_MODE_BUILD;
-    grfx::AccelerationStructure*                pSrcAccelerationStructure = nullptr;
-    grfx::AccelerationStructure*                pDstAccelerationStructure = nullptr;
-    grfx::BufferOrHostAddress                   scratchData               = {};
-    uint32_t                                    geometryCount             = 0;
-    const AccelerationStructureGeometry*        pGeometries               = nullptr;
-    const AccelerationStructureGeometry* const* ppGeometries              = nullptr;
+public:
+    AccelerationStructureBuilder() {}
+    virtual ~AccelerationStructureBuilder() {}
+
+    // Creates *ppAccelerationStructure sized for inputs and queues its
+    // build. The geometry and instance buffers referenced by inputs must
+    // stay alive until the build was recorded.
+    Result AddBuild(const grfx::AccelerationStructureBuildInputs& inputs, grfx::AccelerationStructure** ppAccelerationStructure);
+
+    // Queues an in place update of pAccelerationStructure, which must have
+    // been built with ALLOW_UPDATE.
+    Result AddUpdate(const grfx::AccelerationStructureBuildInputs& inputs, grfx::AccelerationStructure* pAccelerationStructure);
+
+    uint32_t GetPendingCount() const { return CountU32(mPending); }
+
+    // Records all queued builds and updates. Must be recorded outside of a
+    // render pass. The structures can be used by later commands in pCmd.
+    Result Record(grfx::CommandBuffer* pCmd);
+
+    // Creates a compacted copy of each of the count structures in ppSrc and
+    // records the copies, *ppDst[i] replaces ppSrc[i]. The sources must have
+    // been built with ALLOW_COMPACTION by the last Record() and can be
+    // destroyed once pCmd has completed.
+    Result RecordCompaction(
+        grfx::CommandBuffer*                pCmd,
+        uint32_t                            count,
+        grfx::AccelerationStructure* const* ppSrc,
+        grfx::AccelerationStructure**       ppDst);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::AccelerationStructureBuilderCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct PendingBuild
+    {
+        grfx::AccelerationStructureBuildInputs            inputs;
+        std::vector<grfx::AccelerationStructureTriangles> geometries;
+        grfx::AccelerationStructure*                      pDst        = nullptr;
+        bool                                              update      = false;
+        uint64_t                                          scratchSize = 0;
+    };
+
+    Result QueueBuild(const grfx::AccelerationStructureBuildInputs& inputs, grfx::AccelerationStructure* pDst, bool update, uint64_t scratchSize);
+    Result RecordBatches(grfx::CommandBuffer* pCmd, const std::vector<PendingBuild*>& builds);
+    Result EnsureCompactedSizeQuery(uint32_t count);
+
+private:
+    grfx::BufferPoolPtr                       mScratchPool;
+    std::vector<PendingBuild>                 mPending;
+    grfx::QueryPtr                            mCompactedSizeQuery;
+    std::vector<grfx::AccelerationStructure*> mCompactable; // Query index of the last Record() is the element's index
 };
 
 // -------------------------------------------------------------------------------------------------
 
+#if defined(PPX_ENABLE_RAYTRACING)
+
 struct RayTracingShaderGroup
 {
     RayTracingShaderGroupType type = grfx::RAY_TRACING_SHADER_GROUP_TYPE_UNDEFINED;
@@ -114,9 +288,9 @@ public:
     virtual ~RayTracingPipeline() {}
 };
 
+#endif // defined(PPX_ENABLE_RAYTRACING)
+
 } // namespace grfx
 } // namespace ppx
 
-#endif // defined(PPX_ENABLE_RAYTRACING)
-
 #endif // ppx_grfx_ray_tracing_h
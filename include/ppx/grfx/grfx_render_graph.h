@@ -0,0 +1,265 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_render_graph_h
+#define ppx_grfx_render_graph_h
+
+#include "ppx/grfx/grfx_config.h"
+
+#include <functional>
+
+namespace ppx {
+namespace grfx {
+
+//! @struct RenderGraphResource
+//!
+//! Handle to an image declared on a grfx::RenderGraph. Only valid for the
+//! graph that returned it.
+//!
+struct RenderGraphResource
+{
+    uint32_t index = UINT32_MAX;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+};
+
+//! @struct RenderGraphImageCreateInfo
+//!
+//! Transient image owned by the graph. Usage flags are derived from the
+//! way passes access the image, additionalUsageFlags is for anything done
+//! outside of the graph (e.g. copies).
+//!
+struct RenderGraphImageCreateInfo
+{
+    uint32_t                     width                = 0;
+    uint32_t                     height               = 0;
+    grfx::Format                 format               = grfx::FORMAT_UNDEFINED;
+    grfx::SampleCount            sampleCount          = grfx::SAMPLE_COUNT_1;
+    grfx::ImageUsageFlags        additionalUsageFlags = {};
+    grfx::RenderTargetClearValue RTVClearValue        = {0, 0, 0, 0};
+    grfx::DepthStencilClearValue DSVClearValue        = {1.0f, 0xFF};
+    bool                         clearOnFirstWrite    = false; // Otherwise the first write doesn't load previous contents
+};
+
+//! @struct RenderGraphImportInfo
+//!
+//! Image owned by the caller, e.g. a swapchain image. Imported images are
+//! the outputs of the graph: passes writing them are never culled.
+//!
+struct RenderGraphImportInfo
+{
+    grfx::Image*        pImage            = nullptr;                        // Can be replaced every frame with SetImportedImage()
+    grfx::ResourceState initialState      = grfx::RESOURCE_STATE_UNDEFINED; // State at the start of Execute(), UNDEFINED discards the contents
+    grfx::ResourceState finalState        = grfx::RESOURCE_STATE_UNDEFINED; // State at the end of Execute(), UNDEFINED leaves the last used state
+    bool                clearOnFirstWrite = false;
+};
+
+//! Records the commands of a pass. pRenderPass has already been begun and
+//! is null for passes without attachments (e.g. compute passes).
+using RenderGraphExecuteFn = std::function<void(grfx::CommandBuffer* pCommandBuffer, const grfx::RenderPass* pRenderPass)>;
+
+//! @class RenderGraphPass
+//!
+//! Declares which graph images a pass reads and writes. Each image can only
+//! be accessed once per pass. Render targets are bound in the order they
+//! are added.
+//!
+class RenderGraphPass
+{
+public:
+    RenderGraphPass(const std::string& name)
+        : mName(name) {}
+    ~RenderGraphPass() {}
+
+    const std::string& GetName() const { return mName; }
+
+    void AddRenderTarget(grfx::RenderGraphResource image);
+
+    // RESOURCE_STATE_DEPTH_STENCIL_READ makes this a read of image
+    void SetDepthStencil(grfx::RenderGraphResource image, grfx::ResourceState state = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+
+    // state must be one of the *SHADER_RESOURCE states
+    void AddShaderRead(grfx::RenderGraphResource image, grfx::ResourceState state = grfx::RESOURCE_STATE_SHADER_RESOURCE);
+
+    // Read/write storage image access
+    void AddStorage(grfx::RenderGraphResource image);
+
+    // Keeps the pass even if nothing it writes is used, e.g. for passes with side effects
+    void SetNeverCull(bool neverCull) { mNeverCull = neverCull; }
+
+    void SetExecuteFn(const grfx::RenderGraphExecuteFn& fn) { mExecuteFn = fn; }
+
+    // Only valid after grfx::RenderGraph::Compile()
+    bool IsCulled() const { return mCulled; }
+
+private:
+    friend class grfx::RenderGraph;
+
+    enum AccessType
+    {
+        ACCESS_TYPE_RENDER_TARGET = 0,
+        ACCESS_TYPE_DEPTH_STENCIL = 1,
+        ACCESS_TYPE_SHADER_READ   = 2,
+        ACCESS_TYPE_STORAGE       = 3,
+    };
+
+    struct Access
+    {
+        uint32_t            resource = UINT32_MAX;
+        grfx::ResourceState state    = grfx::RESOURCE_STATE_UNDEFINED;
+        AccessType          type     = ACCESS_TYPE_SHADER_READ;
+
+        bool IsWrite() const { return (type != ACCESS_TYPE_SHADER_READ) && (state != grfx::RESOURCE_STATE_DEPTH_STENCIL_READ); }
+    };
+
+    // Render passes are created on first use for each combination of
+    // attachment images, since imported images can change every frame.
+    struct CachedRenderPass
+    {
+        std::vector<const grfx::Image*> images;
+        grfx::RenderPassPtr             renderPass;
+    };
+
+    bool HasAttachments() const { return !mRenderTargets.empty() || (mDepthStencil != UINT32_MAX); }
+
+private:
+    std::string                   mName;
+    std::vector<Access>           mAccesses;
+    std::vector<uint32_t>         mRenderTargets;
+    grfx::RenderGraphExecuteFn    mExecuteFn;
+    std::vector<CachedRenderPass> mRenderPasses;
+    uint32_t                      mDepthStencil                                 = UINT32_MAX;
+    grfx::ResourceState           mDepthStencilState                            = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE;
+    bool                          mNeverCull                                    = false;
+    bool                          mCulled                                       = false;
+    grfx::AttachmentLoadOp        mRenderTargetLoadOps[PPX_MAX_RENDER_TARGETS]  = {};
+    grfx::AttachmentStoreOp       mRenderTargetStoreOps[PPX_MAX_RENDER_TARGETS] = {};
+    grfx::AttachmentLoadOp        mDepthStencilLoadOp                           = grfx::ATTACHMENT_LOAD_OP_LOAD;
+    grfx::AttachmentStoreOp       mDepthStencilStoreOp                          = grfx::ATTACHMENT_STORE_OP_STORE;
+};
+
+//! @struct RenderGraphCreateInfo
+//!
+//!
+struct RenderGraphCreateInfo
+{
+    bool enableAliasing             = true; // Share memory between transient images whose lifetimes don't overlap
+    bool enableTransientAttachments = true; // Images only used as attachments of one pass get transientAttachment usage
+};
+
+//! @class RenderGraph
+//!
+//! Declarative frame graph on top of grfx::RenderPass. Passes declare the
+//! images they access, Compile() then:
+//!   - culls passes that don't contribute to an imported image
+//!   - creates the transient images, aliasing the memory of images that
+//!     are never alive at the same time
+//!   - derives load and store ops: contents are only loaded and stored
+//!     when an earlier or later pass needs them
+//!   - makes attachments that live within a single pass transient, so
+//!     tile based GPUs don't need to back them with memory
+//!
+//! Execute() records the live passes in declaration order with tracked
+//! state transitions, so barriers are batched and derived from the
+//! declarations. All executions must be submitted to the same queue in
+//! the order they were recorded.
+//!
+//! Aliased images share memory across frames in flight as well; that's
+//! safe as long as the submissions are on one queue since the transitions
+//! out of UNDEFINED wait on all prior work.
+//!
+//! Declarations can't change after Compile(). Calling Compile() again
+//! destroys and recreates the images and render passes, e.g. after the
+//! imported images were recreated.
+//!
+class RenderGraph
+    : public grfx::DeviceObject<grfx::RenderGraphCreateInfo>
+{
+public:
+    RenderGraph() {}
+    virtual ~RenderGraph() {}
+
+    grfx::RenderGraphResource AddImage(const grfx::RenderGraphImageCreateInfo& createInfo);
+    grfx::RenderGraphResource ImportImage(const grfx::RenderGraphImportInfo& importInfo);
+    void                      SetImportedImage(grfx::RenderGraphResource image, grfx::Image* pImage);
+
+    // Pointer is owned by the graph
+    grfx::RenderGraphPass* AddPass(const std::string& name);
+
+    Result Compile();
+    bool   IsCompiled() const { return mCompiled; }
+
+    void Execute(grfx::CommandBuffer* pCommandBuffer);
+
+    // Transient images are only available after Compile()
+    grfx::ImagePtr GetImage(grfx::RenderGraphResource image) const;
+
+    uint32_t GetPassCount() const { return CountU32(mPasses); }
+    uint32_t GetLivePassCount() const { return CountU32(mLivePasses); }
+    uint32_t GetTransientImageCount() const { return mTransientImageCount; }
+
+    // Number of transient images bound to the memory of another one
+    uint32_t GetAliasedImageCount() const { return mAliasedImageCount; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::RenderGraphCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct ImageResource
+    {
+        bool                             imported   = false;
+        grfx::RenderGraphImageCreateInfo createInfo = {};
+        grfx::RenderGraphImportInfo      importInfo = {};
+        grfx::ImagePtr                   image;
+        grfx::ImageUsageFlags            usageFlags = {};
+        uint32_t                         firstPass  = UINT32_MAX; // Live pass indices
+        uint32_t                         lastPass   = UINT32_MAX;
+        uint32_t                         aliasSlot  = UINT32_MAX; // Only set if the slot is shared
+    };
+
+    // Transient images sharing one allocation. The first image owns the
+    // memory, the others alias it.
+    struct AliasSlot
+    {
+        std::vector<uint32_t> resources;
+        const grfx::Image*    pLastImage = nullptr;
+    };
+
+    Result ValidatePasses() const;
+    void   CullPasses();
+    void   ComputeLifetimes();
+    Result CreateImages();
+    void   DeriveAttachmentOps();
+
+    grfx::AttachmentLoadOp  GetLoadOp(uint32_t resourceIndex, uint32_t passIndex) const;
+    grfx::AttachmentStoreOp GetStoreOp(uint32_t resourceIndex, uint32_t passIndex) const;
+
+    Result GetRenderPass(grfx::RenderGraphPass* pPass, grfx::RenderPass** ppRenderPass);
+    void   DestroyCompiledObjects();
+
+private:
+    std::vector<ImageResource>                          mResources;
+    std::vector<std::unique_ptr<grfx::RenderGraphPass>> mPasses;
+    std::vector<uint32_t>                               mLivePasses;
+    std::vector<AliasSlot>                              mAliasSlots;
+    uint32_t                                            mTransientImageCount = 0;
+    uint32_t                                            mAliasedImageCount   = 0;
+    bool                                                mCompiled            = false;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_render_graph_h
@@ -119,6 +119,14 @@ struct RenderPassCreateInfo3
     // (`GraphicsPipelineCreateInfo.shadingRateMode`).
     grfx::ShadingRatePatternPtr pShadingRatePattern = nullptr;
 
+    // [OPTIONAL] If pResolveImages[i] is not null, the multisampled render
+    // target i is resolved into it at the end of the pass. It must be a
+    // single sample image of the same format and size, in
+    // RESOURCE_STATE_RENDER_TARGET like the render target. The render
+    // target's store op can be ATTACHMENT_STORE_OP_DONT_CARE so that tilers
+    // resolve without writing the samples to memory.
+    grfx::Image* pResolveImages[PPX_MAX_RENDER_TARGETS] = {};
+
     void SetAllRenderTargetClearValue(const grfx::RenderTargetClearValue& value);
     void SetAllRenderTargetLoadOp(grfx::AttachmentLoadOp op);
     void SetAllRenderTargetStoreOp(grfx::AttachmentStoreOp op);
@@ -171,6 +179,7 @@ struct RenderPassCreateInfo
     {
         grfx::Image* pRenderTargetImages[PPX_MAX_RENDER_TARGETS] = {};
         grfx::Image* pDepthStencilImage                          = nullptr;
+        grfx::Image* pResolveImages[PPX_MAX_RENDER_TARGETS]      = {};
     } V3;
 
     // Clear values
@@ -237,6 +246,12 @@ public:
     // Returns index of pImage otherwise returns UINT32_MAX
     uint32_t GetRenderTargetImageIndex(const grfx::Image* pImage) const;
 
+    // Single sample view render target index is resolved into at the end of
+    // the pass, empty if it isn't resolved. See RenderPassCreateInfo3.
+    grfx::RenderTargetViewPtr GetResolveView(uint32_t index) const;
+    grfx::ImagePtr            GetResolveImage(uint32_t index) const;
+    bool                      HasResolve() const { return mHasResolve; }
+
     // Returns true if render targets or depth stencil contains ATTACHMENT_LOAD_OP_CLEAR
     bool HasLoadOpClear() const { return mHasLoadOpClear; }
 
@@ -257,7 +272,9 @@ protected:
     grfx::DepthStencilViewPtr              mDepthStencilView;
     std::vector<grfx::ImagePtr>            mRenderTargetImages;
     grfx::ImagePtr                         mDepthStencilImage;
+    std::vector<grfx::RenderTargetViewPtr> mResolveViews; // One per render target, null if not resolved
     bool                                   mHasLoadOpClear = false;
+    bool                                   mHasResolve     = false;
 };
 
 } // namespace grfx
@@ -105,6 +105,12 @@ struct ShadingRatePatternCreateInfo
 
     // The sample count of the render targets using this shading rate pattern.
     SampleCount sampleCount;
+
+    // Optional existing attachment image, e.g. a density map provided by the
+    // XR runtime, used instead of creating one. The pattern doesn't take
+    // ownership of it. texelSize is derived from the image and framebuffer
+    // sizes when left zero.
+    grfx::Image* pAttachmentImage = nullptr;
 };
 
 // ShadingRatePattern
@@ -0,0 +1,127 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_shading_rate_updater_h
+#define ppx_grfx_shading_rate_updater_h
+
+#include "ppx/grfx/grfx_config.h"
+
+#include <optional>
+#include <unordered_map>
+
+namespace ppx {
+namespace grfx {
+
+struct ShadingRateUpdaterCreateInfo
+{
+    grfx::ShadingRatePattern* pPattern        = nullptr;
+    uint32_t                  frameCount      = 1;       // Usually the number of frames in flight
+    grfx::ShaderModule*       pShader         = nullptr; // basic/shaders/ShadingRateVariance.cs, null disables AnalyzeContent()
+    uint32_t                  maxSourceImages = 4;       // Distinct images AnalyzeContent() is called with, e.g. swapchain images
+    float                     foveationScale  = 1.0f;    // Same as FillShadingRateRadial()'s scale
+    float                     lowVariance     = 0.0001f; // Luminance variance under which texels are shaded at 4x4
+    float                     highVariance    = 0.001f;  // Luminance variance under which texels are shaded at 2x2
+};
+
+//! @class ShadingRateUpdater
+//!
+//! Rewrites the attachment image of a shading rate pattern every frame. The
+//! fragment size of each texel is the coarser of two sources:
+//!   - a radial falloff around a focus point, usually the eye gaze from
+//!     XrComponent::GetEyeGazeUV(); no falloff without a focus
+//!   - the luminance variance of the texel's pixels in a previous frame,
+//!     so flat areas are shaded coarsely wherever they are
+//!
+//! The variance is computed on the GPU by AnalyzeContent() and read back
+//! frameCount frames later, when Update() is called with the same frame
+//! index. The fragment sizes are encoded on the CPU with the pattern's
+//! encoder, so rates the device doesn't support are never written.
+//!
+//! Typical frame:
+//!   SetFocus(...) or ClearFocus()
+//!   Update(cmd, frameIndex), before the render pass using the pattern
+//!   render
+//!   AnalyzeContent(cmd, colorImage, colorState), after the render pass
+//!
+class ShadingRateUpdater
+{
+public:
+    ShadingRateUpdater();
+    virtual ~ShadingRateUpdater();
+
+    static Result Create(grfx::Device* pDevice, const grfx::ShadingRateUpdaterCreateInfo& createInfo, grfx::ShadingRateUpdater** ppUpdater);
+
+    //! Focus in [0, 1] of the framebuffer from the top left corner
+    void SetFocus(float x, float y);
+    void ClearFocus();
+
+    //! Reads back the variance frameIndex's previous AnalyzeContent() wrote
+    //! and records the upload of the new fragment sizes. The work previously
+    //! recorded with frameIndex must have completed. Must be recorded outside
+    //! of a render pass.
+    Result Update(grfx::CommandBuffer* pCmd, uint32_t frameIndex);
+
+    //! Records the variance computation of a frame's color image, which is
+    //! in srcState before and after. Uses the frame index of the last
+    //! Update(). Must be recorded outside of a render pass.
+    Result AnalyzeContent(grfx::CommandBuffer* pCmd, grfx::Image* pSrcImage, grfx::ResourceState srcState);
+
+    //! Drops the variance read back so far, e.g. after a scene change
+    void ResetContent();
+
+    //! Fragment size Update() picks for a texel, the larger of the focus and
+    //! content sizes. Variance is ignored if negative.
+    static uint32_t CalculateFragmentSize(float focusDistance2, float variance, float lowVariance, float highVariance);
+
+private:
+    struct Frame
+    {
+        grfx::BufferPtr staging;
+        grfx::BufferPtr readback;
+        uint8_t*        pStagingAddress  = nullptr;
+        const float*    pReadbackAddress = nullptr;
+        bool            hasContent       = false;
+    };
+
+    struct Source
+    {
+        grfx::SampledImageViewPtr view;
+        grfx::DescriptorSetPtr    set;
+    };
+
+    Result Initialize(grfx::Device* pDevice, const grfx::ShadingRateUpdaterCreateInfo& createInfo);
+    Result InitializeContent(grfx::Device* pDevice, const grfx::ShadingRateUpdaterCreateInfo& createInfo);
+    Result GetSource(grfx::Image* pSrcImage, Source** ppSource);
+
+private:
+    grfx::Device*                            mDevice           = nullptr;
+    grfx::ShadingRateUpdaterCreateInfo       mCreateInfo       = {};
+    uint32_t                                 mStagingRowStride = 0;
+    uint32_t                                 mFrameIndex       = UINT32_MAX;
+    bool                                     mDirty            = true; // Inputs changed since the last upload
+    std::optional<float2>                    mFocus;
+    std::vector<float>                       mVariance; // Last read back, empty until the first one
+    std::vector<Frame>                       mFrames;
+    grfx::BufferPtr                          mVarianceBuffer;
+    grfx::DescriptorPoolPtr                  mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr             mSetLayout;
+    grfx::PipelineInterfacePtr               mPipelineInterface;
+    grfx::ComputePipelinePtr                 mPipeline;
+    std::unordered_map<grfx::Image*, Source> mSources;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_shading_rate_updater_h
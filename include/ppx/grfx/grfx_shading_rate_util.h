@@ -29,6 +29,8 @@ void FillShadingRateUniformFragmentSize(ShadingRatePatternPtr pattern, uint32_t
 void FillShadingRateUniformFragmentDensity(ShadingRatePatternPtr pattern, uint32_t xDensity, uint32_t yDensity, Bitmap* bitmap);
 // A map with cells of radial scale size
 void FillShadingRateRadial(ShadingRatePatternPtr pattern, float scale, Bitmap* bitmap);
+// A map with cells of radial scale size around (centerX, centerY), in [0, 1] of the bitmap
+void FillShadingRateRadial(ShadingRatePatternPtr pattern, float scale, float centerX, float centerY, Bitmap* bitmap);
 // A map with cells produced by anisotropic filter of scale size
 void FillShadingRateAnisotropic(ShadingRatePatternPtr pattern, float scale, Bitmap* bitmap);
 
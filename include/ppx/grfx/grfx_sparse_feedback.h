@@ -0,0 +1,97 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_sparse_feedback_h
+#define ppx_grfx_sparse_feedback_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_image.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct SparseImageFeedbackCreateInfo
+//!
+//!
+struct SparseImageFeedbackCreateInfo
+{
+    grfx::Image* pImage     = nullptr; // Sparse resident image
+    uint32_t     frameCount = 1;       // Usually the application's frames in flight
+};
+
+//! @struct SparseImageFeedbackConstants
+//!
+//! Layout of the image that ppx/SparseFeedback.hlsli needs to find the
+//! tile a sample hit, meant to be copied into a constant buffer.
+//!
+struct SparseImageFeedbackConstants
+{
+    uint32_t width             = 0;
+    uint32_t height            = 0;
+    uint32_t tileWidth         = 0;
+    uint32_t tileHeight        = 0;
+    uint32_t firstMipTailLevel = 0;
+    uint32_t tilesPerLayer     = 0;
+    uint32_t padding[2]        = {};
+};
+
+//! @class SparseImageFeedback
+//!
+//! Reports which tiles of a sparse resident image shaders sampled. Shaders
+//! write a flag per tile into GetBuffer(), bound as a RW structured buffer
+//! of uint, with the functions in ppx/SparseFeedback.hlsli. Tiles are in
+//! grfx::Image::GetSparseTileIndex() order.
+//!
+//! RecordReadback() is recorded after the last sample of the frame, outside
+//! of a render pass. It copies the flags to the frame's readback buffer and
+//! clears them for the next frame. GetSampledTiles() reads them back once
+//! the frame has completed on the GPU.
+//!
+//! Samples of mip levels in the mip tail aren't reported, the mip tail is
+//! always resident.
+//!
+class SparseImageFeedback
+    : public grfx::DeviceObject<grfx::SparseImageFeedbackCreateInfo>
+{
+public:
+    SparseImageFeedback() {}
+    virtual ~SparseImageFeedback() {}
+
+    grfx::Image*                              GetImage() const { return mCreateInfo.pImage; }
+    grfx::Buffer*                             GetBuffer() const { return mFeedbackBuffer.Get(); }
+    const grfx::SparseImageFeedbackConstants& GetConstants() const { return mConstants; }
+
+    //! Leaves GetBuffer() in RESOURCE_STATE_UNORDERED_ACCESS.
+    void RecordReadback(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer);
+
+    //! Tiles sampled by the frame's last RecordReadback(). The frame must
+    //! have completed on the GPU.
+    Result GetSampledTiles(uint32_t frameIndex, std::vector<grfx::SparseImageTile>* pTiles);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::SparseImageFeedbackCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    grfx::SparseImageFeedbackConstants mConstants = {};
+    grfx::BufferPtr                    mFeedbackBuffer;
+    grfx::BufferPtr                    mZeroBuffer;
+    std::vector<grfx::BufferPtr>       mReadbackBuffers;
+    std::vector<bool>                  mReadbackRecorded;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_sparse_feedback_h
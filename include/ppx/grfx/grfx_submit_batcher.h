@@ -0,0 +1,77 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_grfx_submit_batcher_h
+#define ppx_grfx_submit_batcher_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_queue.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @class SubmitBatcher
+//!
+//! Collects submits for a queue and hands them to Queue::SubmitBatch in
+//! one go when \b Flush is called, so several command buffers per frame
+//! don't each cost a vkQueueSubmit or ExecuteCommandLists call.
+//!
+//! \b Add copies the submit's arrays, the objects they point to only need
+//! to stay alive until the flush. Semaphore signals of added submits aren't
+//! visible to other queues until the flush, so flush before submitting work
+//! on another queue that waits on them. Binary semaphore waits must
+//! likewise have their signal flushed or submitted first.
+//!
+//! The storage of flushed submits is kept around and reused.
+//!
+class SubmitBatcher
+{
+public:
+    SubmitBatcher(grfx::Queue* pQueue = nullptr);
+    ~SubmitBatcher();
+
+    SubmitBatcher(const SubmitBatcher&)            = delete;
+    SubmitBatcher& operator=(const SubmitBatcher&) = delete;
+
+    void         SetQueue(grfx::Queue* pQueue);
+    grfx::Queue* GetQueue() const { return mQueue; }
+
+    void Add(const grfx::SubmitInfo* pSubmitInfo);
+
+    //! Submits everything added since the last flush, does nothing if
+    //! nothing was added. Submits are dropped even if the queue fails them.
+    Result Flush();
+
+    uint32_t GetPendingCount() const { return mPendingCount; }
+
+private:
+    struct PendingSubmit
+    {
+        std::vector<const grfx::CommandBuffer*> commandBuffers;
+        std::vector<const grfx::Semaphore*>     waitSemaphores;
+        std::vector<grfx::Semaphore*>           signalSemaphores;
+        grfx::SubmitInfo                        submitInfo = {};
+    };
+
+    grfx::Queue*               mQueue        = nullptr;
+    std::vector<PendingSubmit> mPending;
+    uint32_t                   mPendingCount = 0;
+    std::vector<grfx::SubmitInfo> mSubmitInfos;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_submit_batcher_h
@@ -95,20 +95,37 @@ public:
 //!       On Vulkan, the actual number of images created by
 //!       the swapchain may be greater than this value.
 //!
+//! \b pOldSwapchain is a swapchain of the same surface that is being
+//! replaced, e.g. on resize. On Vulkan it's handed to the new swapchain,
+//! which lets presents of the old one finish without waiting for the device
+//! to idle. It must not be acquired from afterwards and may be destroyed once
+//! the work using its images has completed. Only used during creation.
+//!
+//! \b maxFrameLatency is the number of presents that may be queued ahead
+//! of the display. AcquireNextImage() blocks until fewer are queued, which
+//! bounds input latency regardless of the frames in flight. On Vulkan this
+//! needs VK_KHR_present_wait and 0 disables it, on D3D12 it's the waitable
+//! swapchain's maximum frame latency and 0 uses 1.
+//!
 struct SwapchainCreateInfo
 {
-    grfx::Queue*              pQueue              = nullptr;
-    grfx::Surface*            pSurface            = nullptr;
-    grfx::ShadingRatePattern* pShadingRatePattern = nullptr;
-    uint32_t                  width               = 0;
-    uint32_t                  height              = 0;
-    grfx::Format              colorFormat         = grfx::FORMAT_UNDEFINED;
-    grfx::Format              depthFormat         = grfx::FORMAT_UNDEFINED;
-    uint32_t                  imageCount          = 0;
-    uint32_t                  arrayLayerCount     = 1; // Used only for XR swapchains.
-    grfx::PresentMode         presentMode         = grfx::PRESENT_MODE_IMMEDIATE;
+    grfx::Queue*              pQueue               = nullptr;
+    grfx::Surface*            pSurface             = nullptr;
+    grfx::Swapchain*          pOldSwapchain        = nullptr; // See below
+    grfx::ShadingRatePattern* pShadingRatePattern  = nullptr;
+    uint32_t                  width                = 0;
+    uint32_t                  height               = 0;
+    grfx::Format              colorFormat          = grfx::FORMAT_UNDEFINED;
+    grfx::Format              depthFormat          = grfx::FORMAT_UNDEFINED;
+    uint32_t                  imageCount           = 0;
+    uint32_t                  arrayLayerCount      = 1; // Used only for XR swapchains.
+    grfx::PresentMode         presentMode          = grfx::PRESENT_MODE_IMMEDIATE;
+    uint32_t                  maxFrameLatency      = 0;     // See below
+    bool                      transientDepthImages = false; // Depth images can't be sampled, may have no backing memory on tile based GPUs
 #if defined(PPX_BUILD_XR)
     XrComponent* pXrComponent = nullptr;
+    bool         xrSpaceWarp  = false; // Motion vector and depth swapchains of XR_FB_space_warp, Vulkan only
+    bool         xrFoveation  = false; // Render passes use the runtime's density maps when XrComponent::IsFoveationSupported(), Vulkan only
 #endif
 };
 
@@ -126,6 +143,7 @@ public:
     uint32_t     GetWidth() const { return mCreateInfo.width; }
     uint32_t     GetHeight() const { return mCreateInfo.height; }
     uint32_t     GetImageCount() const { return mCreateInfo.imageCount; }
+    uint32_t     GetMaxFrameLatency() const { return mCreateInfo.maxFrameLatency; }
     grfx::Format GetColorFormat() const { return mCreateInfo.colorFormat; }
     grfx::Format GetDepthFormat() const { return mCreateInfo.depthFormat; }
 
@@ -187,6 +205,10 @@ protected:
     Result CreateRenderTargets();
     void   DestroyRenderTargets();
 
+    // The runtime's density map of the image when XR foveation is used,
+    // mCreateInfo.pShadingRatePattern otherwise
+    grfx::ShadingRatePattern* GetShadingRatePattern(size_t imageIndex) const;
+
 private:
     virtual Result AcquireNextImageInternal(
         uint64_t         timeout,    // Nanoseconds
@@ -210,8 +232,6 @@ private:
         uint32_t                      waitSemaphoreCount,
         const grfx::Semaphore* const* ppWaitSemaphores);
 
-    std::vector<grfx::CommandBufferPtr> mHeadlessCommandBuffers;
-
 protected:
     grfx::QueuePtr                         mQueue;
     std::vector<grfx::ImagePtr>            mDepthImages;
@@ -226,6 +246,9 @@ protected:
 #if defined(PPX_BUILD_XR)
     XrSwapchain mXrColorSwapchain = XR_NULL_HANDLE;
     XrSwapchain mXrDepthSwapchain = XR_NULL_HANDLE;
+    // Runtime density maps, one per color image
+    std::vector<grfx::ImagePtr>              mXrFoveationImages;
+    std::vector<grfx::ShadingRatePatternPtr> mXrFoveationPatterns;
 #endif
 
     // Keeps track of the image index returned by the last AcquireNextImage call.
@@ -17,6 +17,9 @@
 
 #include "ppx/grfx/grfx_config.h"
 
+#include <deque>
+#include <mutex>
+
 namespace ppx {
 namespace grfx {
 
@@ -40,6 +43,8 @@ public:
 
     virtual Result Wait(uint64_t timeout = UINT64_MAX) = 0;
     virtual Result Reset()                             = 0;
+    //! Returns true if the fence is signaled, doesn't block
+    virtual bool IsSignaled() const = 0;
 
     Result WaitAndReset(uint64_t timeout = UINT64_MAX);
 
@@ -100,6 +105,65 @@ protected:
 
 // -------------------------------------------------------------------------------------------------
 
+//! @class SyncPool
+//!
+//! Recycles fences and binary semaphores instead of creating and destroying
+//! them for short lived submissions. Acquired fences are unsignaled.
+//!
+//! Objects go back to the pool with \b Release, together with the fence of
+//! the last submit that uses them. They're handed out again once that fence
+//! has signaled, fences are reset when they're recycled. Only release
+//! fences that have been submitted.
+//!
+//! Objects still in the pool are destroyed with the pool, the work they
+//! were released with must have completed by then.
+//!
+class SyncPool
+{
+public:
+    SyncPool(grfx::Device* pDevice = nullptr);
+    ~SyncPool();
+
+    SyncPool(const SyncPool&)            = delete;
+    SyncPool& operator=(const SyncPool&) = delete;
+
+    void          SetDevice(grfx::Device* pDevice) { mDevice = pDevice; }
+    grfx::Device* GetDevice() const { return mDevice; }
+
+    Result AcquireFence(grfx::Fence** ppFence);
+    Result AcquireSemaphore(grfx::Semaphore** ppSemaphore);
+
+    //! Returns \b pFence and \b ppSemaphores to the pool, they're reused
+    //! once \b pFence has signaled.
+    void Release(grfx::Fence* pFence, uint32_t semaphoreCount = 0, grfx::Semaphore* const* ppSemaphores = nullptr);
+
+    //! Waits for and destroys all objects, including released ones.
+    void Destroy();
+
+    uint32_t GetFreeFenceCount() const;
+    uint32_t GetFreeSemaphoreCount() const;
+    uint32_t GetPendingCount() const;
+
+private:
+    // Moves objects whose fences have signaled to the free lists
+    void Recycle();
+
+private:
+    struct Pending
+    {
+        grfx::FencePtr                  fence;
+        std::vector<grfx::SemaphorePtr> semaphores;
+    };
+
+    grfx::Device*                   mDevice = nullptr;
+    mutable std::mutex              mMutex;
+    std::deque<Pending>             mPending;
+    std::vector<grfx::FencePtr>     mFreeFences;
+    std::vector<grfx::SemaphorePtr> mFreeSemaphores;
+};
+
+// -------------------------------------------------------------------------------------------------
+
 } // namespace grfx
 } // namespace ppx
 
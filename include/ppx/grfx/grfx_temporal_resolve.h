@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_temporal_resolve_h
+#define ppx_grfx_temporal_resolve_h
+
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/math_config.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct TemporalResolveCreateInfo
+//!
+//!
+struct TemporalResolveCreateInfo
+{
+    uint32_t              frameCount   = 1; // Usually the number of frames in flight
+    uint32_t              width        = 0; // Output resolution, usually the swapchain's
+    uint32_t              height       = 0;
+    grfx::Format          outputFormat = grfx::FORMAT_R16G16B16A16_FLOAT; // History and output, must support storage
+    grfx::ShaderStageInfo CS           = {};                               // Use basic/shaders/TemporalResolve.hlsl (csmain)
+};
+
+//! @struct TemporalResolveInputs
+//!
+//! The inputs of one frame. Like grfx::DynamicResolution, the frame is
+//! rendered to the top left renderWidth x renderHeight corner of the
+//! input textures, which must all be in SHADER_RESOURCE.
+//!
+//! Motion vectors are the unjittered UV of a pixel minus its UV in the
+//! previous frame. Without them the history is reprojected from depth and
+//! the camera matrices, which only covers camera motion.
+//!
+struct TemporalResolveInputs
+{
+    grfx::Texture* pColor               = nullptr;
+    grfx::Texture* pDepth               = nullptr;
+    grfx::Texture* pMotion              = nullptr; // Optional, two channel float
+    uint32_t       renderWidth          = 0;
+    uint32_t       renderHeight         = 0;
+    float2         jitter               = float2(0, 0);   // Camera::SetJitter() offset of the frame, in render pixels
+    float4x4       viewProjectionMatrix = float4x4(1.0f); // Unjittered, i.e. Camera::GetViewProjectionMatrix()
+};
+
+//! @class TemporalResolve
+//!
+//! Temporal anti-aliasing and upscaling. Every frame is rendered with a
+//! different sub-pixel jitter and accumulated into a history at the full
+//! output resolution, so edges and thin geometry converge to a supersampled
+//! result over a few frames. The render resolution can be lower than the
+//! output, which makes it the reconstruction step for grfx::DynamicResolution.
+//!
+//! The history is fetched where each pixel was in the previous frame and
+//! clipped to the color range of the current frame's neighbourhood around
+//! it, which rejects history that was disoccluded or changed. Call
+//! ResetHistory() on camera cuts.
+//!
+//! Resolve() for a frame index requires the previous work recorded with
+//! that index to have completed.
+//!
+//! Typical frame:
+//!   jitter = GetJitterOffset(frameCount, GetJitterPhaseCount(renderWidth, width))
+//!   camera.SetJitter(jitter, renderWidth, renderHeight)
+//!   render with camera.GetJitteredViewProjectionMatrix()
+//!   transition color and depth to SHADER_RESOURCE
+//!   Resolve(cmd, frameIndex, inputs)
+//!   GetOutputTexture() is in SHADER_RESOURCE, draw it to the swapchain
+//!
+class TemporalResolve
+    : public grfx::DeviceObject<grfx::TemporalResolveCreateInfo>
+{
+public:
+    TemporalResolve() {}
+    virtual ~TemporalResolve() {}
+
+    //! Halton (2, 3) sample index % phaseCount, in [-0.5, 0.5] pixels
+    static float2 GetJitterOffset(uint32_t index, uint32_t phaseCount);
+    //! Enough phases to cover every output pixel of a render pixel: 8 at
+    //! native resolution, more as the render resolution drops
+    static uint32_t GetJitterPhaseCount(uint32_t renderWidth, uint32_t outputWidth);
+
+    //! Records the resolve, outside of a render pass
+    Result Resolve(grfx::CommandBuffer* pCommandBuffer, uint32_t frameIndex, const grfx::TemporalResolveInputs& inputs);
+
+    //! The next Resolve() ignores the history
+    void ResetHistory() { mHistoryValid = false; }
+
+    //! Recreates the history at a new output resolution and resets it. The
+    //! old textures are destroyed with Device::DeferDestroyTexture().
+    Result Resize(uint32_t width, uint32_t height);
+
+    //! Result of the last Resolve()
+    grfx::TexturePtr GetOutputTexture() const { return mHistory[mCurrent]; }
+    uint32_t         GetWidth() const { return mCreateInfo.width; }
+    uint32_t         GetHeight() const { return mCreateInfo.height; }
+
+    //! Weight of a current sample that lands on the pixel center, lower
+    //! values are smoother but reject stale history more slowly
+    float GetBlendFactor() const { return mBlendFactor; }
+    void  SetBlendFactor(float blendFactor) { mBlendFactor = blendFactor; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::TemporalResolveCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    Result CreateHistory(uint32_t width, uint32_t height);
+
+private:
+    std::vector<grfx::DescriptorSetPtr> mSets; // One per frame index
+    grfx::TexturePtr                    mHistory[2];
+    grfx::TexturePtr                    mNullMotion; // Bound when there are no motion vectors
+    grfx::SamplerPtr                    mSampler;
+    grfx::DescriptorPoolPtr             mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr        mSetLayout;
+    grfx::PipelineInterfacePtr          mPipelineInterface;
+    grfx::ComputePipelinePtr            mPipeline;
+    uint32_t                            mCurrent             = 0;
+    bool                                mHistoryValid        = false;
+    bool                                mHasDeferredDestroys = false; // Resize() deferred destroys of the old history
+    float                               mBlendFactor         = 0.1f;
+    float4x4                            mPrevViewProjection  = float4x4(1.0f);
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_temporal_resolve_h
@@ -40,11 +40,19 @@ struct TextureFontGlyphMetrics
     TextureFontUVRect uvRect       = {};
 };
 
+// sdf = true stores a signed distance field of each glyph instead of its
+// coverage. The atlas is rendered once at size and TextDraw scales it to any
+// font size with crisp edges, so a single TextureFont serves all sizes. Draw
+// it with the TextDrawSDF pixel shader. A size of 32 to 64 pixels and a
+// padding of about an eighth of it keep edges sharp when scaled up.
+//
 struct TextureFontCreateInfo
 {
     ppx::Font   font;
     float       size       = 16.0f;
-    std::string characters = ""; // Default characters if empty
+    std::string characters = "";    // Default characters if empty
+    bool        sdf        = false; // See above
+    uint32_t    sdfPadding = 4;     // Distance range in atlas pixels around each glyph
 };
 
 class TextureFont
@@ -60,6 +68,7 @@ public:
     float            GetSize() const { return mCreateInfo.size; }
     std::string      GetCharacters() const { return mCreateInfo.characters; }
     grfx::TexturePtr GetTexture() const { return mTexture; }
+    bool             IsSDF() const { return mCreateInfo.sdf; }
 
     float                                GetAscent() const { return mFontMetrics.ascent; }
     float                                GetDescent() const { return mFontMetrics.descent; }
@@ -78,12 +87,22 @@ private:
 
 // -------------------------------------------------------------------------------------------------
 
+// ringFrameCount > 0 is for text that changes every frame: vertices are
+// written to a persistently mapped ring of ringFrameCount segments that the
+// GPU reads in place, and UploadToGpu() isn't needed. Clear() moves to the
+// next segment, so use at least the number of frames in flight.
+//
+// Strings added after Clear() in the same order and with the same
+// parameters as before are copied from the previous vertices instead of
+// being encoded again.
+//
 struct TextDrawCreateInfo
 {
     grfx::TextureFont*    pFont              = nullptr;
-    uint32_t              maxTextLength      = 4096;
+    uint32_t              maxTextLength      = 4096; // Glyphs
+    uint32_t              ringFrameCount     = 0;    // See above
     grfx::ShaderStageInfo VS                 = {}; // Use basic/shaders/TextDraw.hlsl (vsmain) for now
-    grfx::ShaderStageInfo PS                 = {}; // Use basic/shaders/TextDraw.hlsl (psmain) for now
+    grfx::ShaderStageInfo PS                 = {}; // Use basic/shaders/TextDraw.hlsl (psmain) for now, TextDrawSDF.ps for SDF fonts
     grfx::BlendMode       blendMode          = grfx::BLEND_MODE_PREMULT_ALPHA;
     grfx::Format          renderTargetFormat = grfx::FORMAT_UNDEFINED;
     grfx::Format          depthStencilFormat = grfx::FORMAT_UNDEFINED;
@@ -106,12 +125,29 @@ public:
         const float3&      color,
         float              opacity);
 
+    // Draws the string at fontSize pixels instead of the font's size,
+    // meant for SDF fonts since coverage fonts get blurry when scaled
+    void AddString(
+        const float2&      position,
+        const std::string& string,
+        float              fontSize,
+        float              tabSpacing,
+        float              lineSpacing,
+        const float3&      color,
+        float              opacity);
+
     void AddString(
         const float2&      position,
         const std::string& string,
         const float3&      color   = float3(1, 1, 1),
         float              opacity = 1.0f);
 
+    // Appends the glyphs of another TextDraw with the same font, so text
+    // built by several TextDraws is drawn with a single draw call
+    void AddTextDraw(const grfx::TextDraw* pTextDraw);
+
+    uint32_t GetTextLength() const { return mTextLength; }
+
     // Use this if text is static
     ppx::Result UploadToGpu(grfx::Queue* pQueue);
 
@@ -126,8 +162,26 @@ protected:
     virtual void   DestroyApiObjects() override;
 
 private:
-    uint32_t                     mTextLength = 0;
-    grfx::BufferPtr              mCpuIndexBuffer;
+    // Glyphs of a string added since Clear()
+    struct StringRange
+    {
+        uint64_t hash       = 0;
+        uint32_t firstGlyph = 0;
+        uint32_t glyphCount = 0;
+    };
+
+    bool           IsRing() const { return mCreateInfo.ringFrameCount > 0; }
+    uint8_t*       GetSegmentVertices(uint32_t segment);
+    const uint8_t* GetCurrentVertices() const;
+    // Copies an unchanged string from the previous vertices, returns false if it has to be encoded
+    bool ReuseString(uint64_t hash);
+
+private:
+    uint32_t                     mTextLength    = 0;
+    uint32_t                     mSegment       = 0;
+    uint8_t*                     mMappedAddress = nullptr; // mCpuVertexBuffer, persistently mapped
+    std::vector<StringRange>     mStrings;
+    std::vector<StringRange>     mPrevStrings;
     grfx::BufferPtr              mCpuVertexBuffer;
     grfx::BufferPtr              mGpuIndexBuffer;
     grfx::BufferPtr              mGpuVertexBuffer;
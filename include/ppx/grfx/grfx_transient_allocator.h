@@ -0,0 +1,101 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_transient_allocator_h
+#define ppx_grfx_transient_allocator_h
+
+#include "ppx/grfx/grfx_config.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @struct TransientAllocatorCreateInfo
+//!
+//!
+struct TransientAllocatorCreateInfo
+{
+    uint64_t               frameSize  = 0;                            // Bytes available to each frame
+    uint32_t               frameCount = 0;                            // Usually the number of frames in flight
+    uint32_t               alignment  = PPX_UNIFORM_BUFFER_ALIGNMENT; // Default alignment for Allocate()
+    grfx::BufferUsageFlags usageFlags = grfx::BUFFER_USAGE_UNIFORM_BUFFER;
+};
+
+//! @struct TransientAllocation
+//!
+//! A sub-range of one of the allocator's buffers. Valid until the
+//! allocator is reset for the same frame index.
+//!
+struct TransientAllocation
+{
+    grfx::Buffer* pBuffer        = nullptr;
+    uint64_t      offset         = 0;
+    uint64_t      size           = 0;
+    void*         pMappedAddress = nullptr;
+};
+
+//! @class TransientAllocator
+//!
+//! Linear allocator for per-frame data such as constants. Each frame gets
+//! its own CPU_TO_GPU buffer that is mapped once when the allocator is
+//! created. Allocations are bumped out of the current frame's buffer and
+//! are all released together by BeginFrame() the next time that frame
+//! index comes around.
+//!
+//! The caller is responsible for making sure the GPU has finished with a
+//! frame (i.e. its fence has been waited on) before calling BeginFrame()
+//! for it, which is what the per-frame loop in the samples already does.
+//!
+class TransientAllocator
+    : public grfx::DeviceObject<grfx::TransientAllocatorCreateInfo>
+{
+public:
+    TransientAllocator() {}
+    virtual ~TransientAllocator() {}
+
+    uint32_t GetFrameIndex() const { return mFrameIndex; }
+    uint64_t GetFrameSize() const { return mCreateInfo.frameSize; }
+    uint64_t GetUsedSize() const { return mOffset; }
+
+    grfx::BufferPtr GetBuffer(uint32_t frameIndex) const;
+
+    // Releases all allocations made for frameIndex and makes it current
+    void BeginFrame(uint32_t frameIndex);
+
+    // Returns ppx::ERROR_OUT_OF_MEMORY if the current frame's buffer is full
+    Result Allocate(uint64_t size, grfx::TransientAllocation* pAllocation);
+    Result Allocate(uint64_t size, uint32_t alignment, grfx::TransientAllocation* pAllocation);
+
+    // Allocates and copies size bytes from pData into the allocation
+    Result AllocateAndCopy(uint64_t size, const void* pData, grfx::TransientAllocation* pAllocation);
+
+protected:
+    virtual Result CreateApiObjects(const grfx::TransientAllocatorCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    struct Frame
+    {
+        grfx::BufferPtr buffer;
+        char*           pMappedAddress = nullptr;
+    };
+
+    std::vector<Frame> mFrames;
+    uint32_t           mFrameIndex = 0;
+    uint64_t           mOffset     = 0;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_transient_allocator_h
@@ -0,0 +1,162 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_grfx_upload_batch_h
+#define ppx_grfx_upload_batch_h
+
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/bitmap.h"
+
+namespace ppx {
+namespace grfx {
+
+//! @class UploadBatch
+//!
+//! Accumulates buffer and bitmap uploads into a shared staging arena and
+//! records them into a single command buffer that is submitted once.
+//!
+//! Staging memory is carved out of persistently mapped CPU_TO_GPU chunks
+//! of \b stagingChunkSize bytes. Uploads larger than a chunk get their own
+//! dedicated staging buffer.
+//!
+//! Completion is signaled on a timeline semaphore. Callers can either block
+//! with \b Wait or chain GPU work by waiting on \b GetCompletionSemaphore
+//! with \b GetCompletionValue in their own SubmitInfo. A batch that was
+//! submitted without any uploads has no completion semaphore.
+//!
+//! Uploads can run on a dedicated transfer queue while \b pOwnerQueue keeps
+//! using the resources. If the two queues are in different queue families
+//! the batch releases ownership at the end of the upload and submits a small
+//! acquire command buffer on \b pOwnerQueue that waits on the upload. In
+//! that case the previous contents of each destination are discarded, so
+//! buffer uploads must cover everything the owner still needs.
+//!
+//! The \b stateAfter passed to the Add* functions must be a state that the
+//! batch's queue can transition to. For example, D3D12 copy queues cannot
+//! transition to shader resource states.
+//!
+//! The destructor waits for a submitted batch to finish before releasing
+//! the staging memory.
+//!
+class UploadBatch
+{
+public:
+    static constexpr uint64_t kDefaultStagingChunkSize = 16 * 1024 * 1024;
+
+    UploadBatch(
+        grfx::Queue* pQueue,
+        uint64_t     stagingChunkSize = kDefaultStagingChunkSize,
+        grfx::Queue* pOwnerQueue      = nullptr);
+    ~UploadBatch();
+
+    UploadBatch(const UploadBatch&)            = delete;
+    UploadBatch& operator=(const UploadBatch&) = delete;
+
+    grfx::Queue* GetQueue() const { return mQueue; }
+    grfx::Queue* GetOwnerQueue() const { return mOwnerQueue; }
+    bool         IsOwnershipTransferred() const { return mTransferOwnership; }
+
+    //! Returns the number of staging bytes \b AddBitmapUpload consumes for
+    //! \b pBitmap, including alignment padding. Summing this over all uploads
+    //! gives a chunk size that fits the whole batch in a single staging buffer.
+    static uint64_t CalculateStagingSize(grfx::Api api, const Bitmap* pBitmap);
+
+    //! Copies \b size bytes from \b pSrcData into the staging arena and
+    //! queues a copy into \b pDstBuffer at \b dstOffset.
+    Result AddBufferUpload(
+        uint64_t            size,
+        const void*         pSrcData,
+        grfx::Buffer*       pDstBuffer,
+        uint64_t            dstOffset,
+        grfx::ResourceState stateBefore,
+        grfx::ResourceState stateAfter);
+
+    //! Copies \b pBitmap into the staging arena and queues a copy into
+    //! \b mipLevel / \b arrayLayer of \b pDstImage.
+    Result AddBitmapUpload(
+        const Bitmap*       pBitmap,
+        grfx::Image*        pDstImage,
+        uint32_t            mipLevel,
+        uint32_t            arrayLayer,
+        grfx::ResourceState stateBefore,
+        grfx::ResourceState stateAfter);
+
+    //! Records and submits all queued uploads. Additional uploads cannot
+    //! be added after the batch has been submitted.
+    Result Submit();
+
+    //! Blocks until the submitted uploads have completed on the GPU.
+    //! Returns immediately if nothing was submitted.
+    Result Wait(uint64_t timeout = UINT64_MAX) const;
+
+    bool             IsSubmitted() const { return mSubmitted; }
+    bool             IsComplete() const;
+    uint32_t         GetUploadCount() const { return CountU32(mUploads); }
+    uint64_t         GetStagingSize() const { return mStagingSize; }
+    grfx::Semaphore* GetCompletionSemaphore() const { return mCompletionSemaphore; }
+    uint64_t         GetCompletionValue() const { return mCompletionValue; }
+
+private:
+    static constexpr uint64_t kUploadValue  = 1;
+    static constexpr uint64_t kAcquireValue = 2;
+
+    struct StagingChunk
+    {
+        grfx::BufferPtr buffer;
+        char*           pMappedAddress = nullptr;
+        uint64_t        size           = 0;
+        uint64_t        usedSize       = 0;
+    };
+
+    struct Upload
+    {
+        grfx::Buffer*                pSrcBuffer  = nullptr;
+        grfx::Buffer*                pDstBuffer  = nullptr;
+        grfx::Image*                 pDstImage   = nullptr;
+        grfx::BufferToBufferCopyInfo bufferCopy  = {};
+        grfx::BufferToImageCopyInfo  imageCopy   = {};
+        grfx::ResourceState          stateBefore = grfx::RESOURCE_STATE_UNDEFINED;
+        grfx::ResourceState          stateAfter  = grfx::RESOURCE_STATE_UNDEFINED;
+    };
+
+    static bool IsSameDestination(const Upload& a, const Upload& b);
+
+    bool IsFirstUpload(size_t index) const;
+    bool IsLastUpload(size_t index) const;
+    void RecordFinalBarriers(grfx::CommandBuffer* pCommandBuffer) const;
+
+    Result AllocateStaging(uint64_t size, uint64_t alignment, grfx::Buffer** ppBuffer, uint64_t* pOffset, char** ppMappedAddress);
+    void   ReleaseResources();
+
+private:
+    grfx::Queue*              mQueue             = nullptr;
+    grfx::Queue*              mOwnerQueue        = nullptr;
+    bool                      mTransferOwnership = false;
+    uint64_t                  mStagingChunkSize  = 0;
+    uint64_t                  mStagingSize       = 0;
+    std::vector<StagingChunk> mStagingChunks;
+    std::vector<Upload>       mUploads;
+    grfx::CommandBufferPtr    mCommandBuffer;
+    grfx::CommandBufferPtr    mAcquireCommandBuffer;
+    grfx::SemaphorePtr        mCompletionSemaphore;
+    uint64_t                  mCompletionValue = 0;
+    bool                      mSubmitted       = false;
+};
+
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_upload_batch_h
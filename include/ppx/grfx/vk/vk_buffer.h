@@ -31,17 +31,39 @@ public:
 
     VkBufferPtr GetVkBuffer() const { return mBuffer; }
 
-    virtual Result MapMemory(uint64_t offset, void** ppMappedAddress) override;
-    virtual void   UnmapMemory() override;
+    // Requires shaderDeviceAddress or acceleration structure usage, or
+    // uniform or storage usage on devices that use descriptor buffers
+    VkDeviceAddress GetVkDeviceAddress() const;
+
+    virtual Result   MapMemory(uint64_t offset, void** ppMappedAddress) override;
+    virtual void     UnmapMemory() override;
+    virtual uint64_t GetDeviceAddress() const override;
+
+    // Defragmentation, see vk::Device::DefragmentApiObjects(). Buffers the
+    // device can't move are created without the extra transfer usage.
+    bool             IsMovable() const;
+    VmaAllocationPtr GetVmaAllocation() const { return mAllocation; }
+    // Creates the buffer that's bound to dstAllocation and records the copy
+    // of the contents into it
+    Result BeginMove(VmaAllocation dstAllocation, VkCommandBuffer commandBuffer);
+    // Replaces the buffer once the copy has executed, before VMA frees the
+    // old memory, or destroys the new one if the move is canceled
+    void FinishMove(bool cancel);
+    // Reads the new place of the allocation after the defragmentation pass
+    void UpdateAllocationInfo();
 
 protected:
     virtual Result CreateApiObjects(const grfx::BufferCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    Result CreateVkBuffer(VkBuffer* pBuffer) const;
+
 private:
     VkBufferPtr       mBuffer;
     VmaAllocationPtr  mAllocation;
     VmaAllocationInfo mAllocationInfo = {};
+    VkBufferPtr       mMoveBuffer; // Between BeginMove() and FinishMove()
 };
 
 } // namespace vk
@@ -35,6 +35,20 @@ public:
     virtual Result End() override;
 
 private:
+    virtual Result BeginSecondaryImpl(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo) override;
+
+    virtual void ExecuteCommandsImpl(
+        uint32_t                          commandBufferCount,
+        const grfx::CommandBuffer* const* ppCommandBuffers) override;
+
+    virtual void ResourceBarriersImpl(
+        uint32_t             imageBarrierCount,
+        const ImageBarrier*  pImageBarriers,
+        uint32_t             bufferBarrierCount,
+        const BufferBarrier* pBufferBarriers) override;
+
+    virtual void AliasingBarrierImpl(const grfx::Image* pBefore, grfx::Image* pAfter) override;
+
     virtual void BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo) override;
     virtual void EndRenderPassImpl() override;
 
@@ -88,6 +102,14 @@ public:
         uint32_t          scissorCount,
         const grfx::Rect* pScissors) override;
 
+    virtual void SetCullMode(grfx::CullMode cullMode) override;
+    virtual void SetPrimitiveTopology(grfx::PrimitiveTopology topology) override;
+    virtual void SetDepthTestEnable(bool enable) override;
+    virtual void SetDepthWriteEnable(bool enable) override;
+    virtual void SetBlendEnable(
+        uint32_t    renderTargetCount,
+        const bool* pEnables) override;
+
     virtual void BindGraphicsDescriptorSets(
         const grfx::PipelineInterface*    pInterface,
         uint32_t                          setCount,
@@ -138,6 +160,57 @@ public:
         uint32_t groupCountY,
         uint32_t groupCountZ) override;
 
+    virtual void DrawMeshTasks(
+        uint32_t groupCountX,
+        uint32_t groupCountY,
+        uint32_t groupCountZ) override;
+
+    virtual void DrawIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawIndexedIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawIndexedIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawMeshTasksIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        uint32_t            drawCount,
+        uint32_t            stride) override;
+
+    virtual void DrawMeshTasksIndirectCount(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset,
+        const grfx::Buffer* pCountBuffer,
+        uint64_t            countOffset,
+        uint32_t            maxDrawCount,
+        uint32_t            stride) override;
+
+    virtual void DispatchIndirect(
+        const grfx::Buffer* pArgBuffer,
+        uint64_t            argOffset) override;
+
     virtual void CopyBufferToBuffer(
         const grfx::BufferToBufferCopyInfo* pCopyInfo,
         grfx::Buffer*                       pSrcBuffer,
@@ -168,6 +241,11 @@ public:
         grfx::Image*               pSrcImage,
         grfx::Image*               pDstImage) override;
 
+    virtual void ResolveImage(
+        const grfx::ImageResolveInfo* pResolveInfo,
+        grfx::Image*                  pSrcImage,
+        grfx::Image*                  pDstImage) override;
+
     virtual void BeginQuery(
         const grfx::Query* pQuery,
         uint32_t           queryIndex) override;
@@ -186,25 +264,120 @@ public:
         uint32_t     startIndex,
         uint32_t     numQueries) override;
 
+    virtual void ResolveOcclusionPredicates(
+        const grfx::Query* pQuery,
+        uint32_t           firstQuery,
+        uint32_t           queryCount,
+        grfx::Buffer*      pDstBuffer,
+        uint64_t           dstOffset) override;
+
+    virtual void BeginConditionalRendering(
+        const grfx::Buffer* pBuffer,
+        uint64_t            offset) override;
+
+    virtual void EndConditionalRendering() override;
+
+    virtual void BuildAccelerationStructures(
+        uint32_t                                    count,
+        const grfx::AccelerationStructureBuildInfo* pInfos) override;
+
+    virtual void CopyAccelerationStructure(
+        const grfx::AccelerationStructure* pSrc,
+        grfx::AccelerationStructure*       pDst,
+        bool                               compact) override;
+
+    virtual void WriteAccelerationStructureCompactedSizes(
+        uint32_t                                  count,
+        const grfx::AccelerationStructure* const* ppAccelerationStructures,
+        grfx::Query*                              pQuery,
+        uint32_t                                  firstQuery) override;
+
+    virtual void AccelerationStructureBarrier() override;
+
+    virtual void BeginDebugLabel(const char* pLabel) override;
+    virtual void EndDebugLabel() override;
+
 protected:
     virtual Result CreateApiObjects(const grfx::internal::CommandBufferCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
 private:
+    // Records a render pass that uses dynamic rendering
+    void BeginDynamicRenderPass(const grfx::RenderPassBeginInfo* pBeginInfo);
+
     void BindDescriptorSets(
         VkPipelineBindPoint               bindPoint,
         const grfx::PipelineInterface*    pInterface,
         uint32_t                          setCount,
         const grfx::DescriptorSet* const* ppSets);
 
+    // Sets are bound by their offset into the device's descriptor buffer
+    void BindDescriptorBufferSets(
+        VkPipelineBindPoint               bindPoint,
+        const grfx::PipelineInterface*    pInterface,
+        uint32_t                          setCount,
+        const grfx::DescriptorSet* const* ppSets);
+
     void PushConstants(
         const grfx::PipelineInterface* pInterface,
         uint32_t                       count,
         const void*                    pValues,
         uint32_t                       dstOffset);
 
+    // Adjusts the masks of a queue family ownership transfer barrier for the
+    // release or acquire half, depending on which family this command buffer
+    // is recorded for. The ignored half is reset to a no-op dependency.
+    void ApplyQueueFamilyTransferMasks(
+        uint32_t              srcQueueFamilyIndex,
+        uint32_t              dstQueueFamilyIndex,
+        VkPipelineStageFlags& srcStageMask,
+        VkAccessFlags&        srcAccessMask,
+        VkPipelineStageFlags& dstStageMask,
+        VkAccessFlags&        dstAccessMask) const;
+
+#if defined(VK_KHR_synchronization2)
+    // Synchronization2 counterparts of the above. Used instead of the legacy
+    // barrier path whenever the device has VK_KHR_synchronization2, since
+    // the masks can be specified per barrier instead of per batch.
+    void GetBarrier2Masks(
+        grfx::ResourceState       beforeState,
+        grfx::ResourceState       afterState,
+        VkPipelineStageFlags2KHR& srcStageMask,
+        VkAccessFlags2KHR&        srcAccessMask,
+        VkPipelineStageFlags2KHR& dstStageMask,
+        VkAccessFlags2KHR&        dstAccessMask,
+        VkImageLayout&            oldLayout,
+        VkImageLayout&            newLayout) const;
+
+    void ApplyQueueFamilyTransferMasks2(
+        uint32_t                  srcQueueFamilyIndex,
+        uint32_t                  dstQueueFamilyIndex,
+        VkPipelineStageFlags2KHR& srcStageMask,
+        VkAccessFlags2KHR&        srcAccessMask,
+        VkPipelineStageFlags2KHR& dstStageMask,
+        VkAccessFlags2KHR&        dstAccessMask) const;
+
+    void PipelineBarrier2(
+        uint32_t                         imageBarrierCount,
+        const VkImageMemoryBarrier2KHR*  pImageBarriers,
+        uint32_t                         bufferBarrierCount,
+        const VkBufferMemoryBarrier2KHR* pBufferBarriers);
+#endif
+
 private:
     VkCommandBufferPtr mCommandBuffer;
+
+    // Shader objects need the viewport and scissor counts set dynamically
+    // too, so the last ones set are kept to be set again when shader
+    // objects are bound after them
+    bool       mShaderObjectsBound           = false;
+    uint32_t   mViewportCount                = 0;
+    VkViewport mViewports[PPX_MAX_VIEWPORTS] = {};
+    uint32_t   mScissorCount                 = 0;
+    VkRect2D   mScissors[PPX_MAX_SCISSORS]   = {};
+
+    // The descriptor buffer only has to be bound once per command buffer
+    bool mDescriptorBufferBound = false;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -105,6 +105,7 @@ private:
 
 // -------------------------------------------------------------------------------------------------
 
+using VkAccelerationStructurePtr  = VkHandlePtr<VkAccelerationStructureKHR>;
 using VkBufferPtr                 = VkHandlePtr<VkBuffer>;
 using VkCommandBufferPtr          = VkHandlePtr<VkCommandBuffer>;
 using VkCommandPoolPtr            = VkHandlePtr<VkCommandPool>;
@@ -120,6 +121,7 @@ using VkImageViewPtr              = VkHandlePtr<VkImageView>;
 using VkInstancePtr               = VkHandlePtr<VkInstance>;
 using VkPhysicalDevicePtr         = VkHandlePtr<VkPhysicalDevice>;
 using VkPipelinePtr               = VkHandlePtr<VkPipeline>;
+using VkPipelineCachePtr          = VkHandlePtr<VkPipelineCache>;
 using VkPipelineLayoutPtr         = VkHandlePtr<VkPipelineLayout>;
 using VkQueryPoolPtr              = VkHandlePtr<VkQueryPool>;
 using VkQueuePtr                  = VkHandlePtr<VkQueue>;
@@ -136,6 +138,7 @@ using VmaAllocatorPtr  = VkHandlePtr<VmaAllocator>;
 
 // -------------------------------------------------------------------------------------------------
 
+class AccelerationStructure;
 class Buffer;
 class CommandBuffer;
 class CommandPool;
@@ -179,6 +182,13 @@ struct ApiObjectLookUp
 {
 };
 
+template <>
+struct ApiObjectLookUp<grfx::AccelerationStructure>
+{
+    using GrfxType = grfx::AccelerationStructure;
+    using ApiType  = vk::AccelerationStructure;
+};
+
 template <>
 struct ApiObjectLookUp<grfx::Buffer>
 {
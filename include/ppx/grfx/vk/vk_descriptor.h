@@ -48,7 +48,10 @@ public:
     DescriptorSet() {}
     virtual ~DescriptorSet() {}
 
+    // Null if the device uses descriptor buffers, the set is then bound
+    // by its offset into the device's descriptor buffer instead
     VkDescriptorSetPtr GetVkDescriptorSet() const { return mDescriptorSet; }
+    VkDeviceSize       GetDescriptorBufferOffset() const { return mDescriptorBufferOffset; }
 
     virtual Result UpdateDescriptors(uint32_t writeCount, const grfx::WriteDescriptor* pWrites) override;
 
@@ -56,19 +59,31 @@ protected:
     virtual Result CreateApiObjects(const grfx::internal::DescriptorSetCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+#if defined(VK_EXT_descriptor_buffer)
+    Result CreateDescriptorBufferRange();
+    Result UpdateDescriptorBuffer(uint32_t writeCount, const grfx::WriteDescriptor* pWrites);
+    void   WriteDescriptorBuffer(uint32_t binding, uint32_t arrayIndex, const VkDescriptorGetInfoEXT& getInfo);
+#endif
+
 private:
     VkDescriptorSetPtr  mDescriptorSet;
     VkDescriptorPoolPtr mDescriptorPool;
+    VkDeviceSize        mDescriptorBufferOffset = 0;
+    bool                mUsesDescriptorBuffer   = false;
 
     // Reduce memory allocations during update process
-    std::vector<VkWriteDescriptorSet>   mWriteStore;
-    std::vector<VkDescriptorImageInfo>  mImageInfoStore;
-    std::vector<VkBufferView>           mTexelBufferStore;
-    std::vector<VkDescriptorBufferInfo> mBufferInfoStore;
-    uint32_t                            mWriteCount       = 0;
-    uint32_t                            mImageCount       = 0;
-    uint32_t                            mTexelBufferCount = 0;
-    uint32_t                            mBufferCount      = 0;
+    std::vector<VkWriteDescriptorSet>                         mWriteStore;
+    std::vector<VkDescriptorImageInfo>                        mImageInfoStore;
+    std::vector<VkBufferView>                                 mTexelBufferStore;
+    std::vector<VkDescriptorBufferInfo>                       mBufferInfoStore;
+    std::vector<VkWriteDescriptorSetAccelerationStructureKHR> mAccelerationStructureInfoStore;
+    std::vector<VkAccelerationStructureKHR>                   mAccelerationStructureStore;
+    uint32_t                                                  mWriteCount                 = 0;
+    uint32_t                                                  mImageCount                 = 0;
+    uint32_t                                                  mTexelBufferCount           = 0;
+    uint32_t                                                  mBufferCount                = 0;
+    uint32_t                                                  mAccelerationStructureCount = 0;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -82,14 +97,22 @@ public:
 
     VkDescriptorSetLayoutPtr GetVkDescriptorSetLayout() const { return mDescriptorSetLayout; }
 
+    // Size of a set and offset of a binding in the descriptor buffer if the
+    // device uses descriptor buffers, 0 otherwise
+    VkDeviceSize GetDescriptorBufferSize() const { return mDescriptorBufferSize; }
+    VkDeviceSize GetDescriptorBufferBindingOffset(uint32_t binding) const;
+
 protected:
     virtual Result CreateApiObjects(const grfx::DescriptorSetLayoutCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
 private:
     Result ValidateDescriptorBindingFlags(const grfx::DescriptorBindingFlags& flags) const;
+    Result ValidateDescriptorBufferBindings(const grfx::DescriptorSetLayoutCreateInfo* pCreateInfo) const;
 
-    VkDescriptorSetLayoutPtr mDescriptorSetLayout;
+    VkDescriptorSetLayoutPtr                   mDescriptorSetLayout;
+    VkDeviceSize                               mDescriptorBufferSize = 0;
+    std::unordered_map<uint32_t, VkDeviceSize> mDescriptorBufferBindingOffsets;
 };
 
 } // namespace vk
@@ -18,6 +18,8 @@
 #include "ppx/grfx/vk/vk_config.h"
 #include "ppx/grfx/grfx_device.h"
 
+#include <mutex>
+
 namespace ppx {
 namespace grfx {
 namespace vk {
@@ -32,13 +34,46 @@ public:
     VkDevicePtr     GetVkDevice() const { return mDevice; }
     VmaAllocatorPtr GetVmaAllocator() const { return mVmaAllocator; }
 
+    VkPipelineCachePtr GetVkPipelineCache() const { return mPipelineCache; }
+
     const VkPhysicalDeviceFeatures& GetDeviceFeatures() const { return mDeviceFeatures; }
 
     bool           HasDescriptorIndexingFeatures() const { return mHasDescriptorIndexingFeatures; }
     bool           HasTimelineSemaphore() const { return mHasTimelineSemaphore; }
     bool           HasExtendedDynamicState() const { return mHasExtendedDynamicState; }
+    bool           HasDynamicBlendEnable() const { return mHasDynamicBlendEnable; }
     bool           HasDepthClipEnabled() const { return mHasDepthClipEnabled; }
     bool           HasMultiView() const { return mHasMultiView; }
+    bool           HasSynchronization2() const { return mHasSynchronization2; }
+    bool           HasMemoryBudget() const { return mHasMemoryBudget; }
+    bool           HasPresentWait() const { return mHasPresentWait; }
+    bool           HasDescriptorBufferPushDescriptors() const { return mHasDescriptorBufferPushDescriptors; }
+    bool           HasMultiDrawIndirect() const { return mDeviceFeatures.multiDrawIndirect == VK_TRUE; }
+
+    // Render passes without a shading rate pattern or multiview are recorded
+    // with dynamic rendering instead of VkRenderPass and VkFramebuffer
+    // objects, and pipelines for them are created with their attachment
+    // formats. Requires dynamic rendering and DeviceCreateInfo::dynamicRenderPasses.
+    bool UsesDynamicRenderPasses() const { return mUsesDynamicRenderPasses; }
+
+    // Graphics pipelines that use dynamic rendering are linked from vertex
+    // input, pre-rasterization, fragment shader and fragment output
+    // libraries shared between pipelines, then relinked with link time
+    // optimization on a pipeline compile thread. Requires fast linking
+    // VK_EXT_graphics_pipeline_library and DeviceCreateInfo::graphicsPipelineLibraries.
+    bool UsesGraphicsPipelineLibraries() const { return mUsesGraphicsPipelineLibraries; }
+
+    // Descriptor sets are written into a device wide descriptor buffer with
+    // vkGetDescriptorEXT and bound by their offset into it, pipelines are
+    // created with VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT. Requires
+    // VK_EXT_descriptor_buffer, buffer device address and
+    // DeviceCreateInfo::descriptorBuffers.
+    bool UsesDescriptorBuffers() const { return mUsesDescriptorBuffers; }
+
+    // Stages that descriptor set layouts and push constant ranges can
+    // reference, SHADER_STAGE_ALL is masked with this so it doesn't name
+    // task and mesh stages on devices without mesh shaders.
+    VkShaderStageFlags GetSupportedShaderStageFlags() const;
     virtual Result WaitIdle() override;
 
     virtual bool PipelineStatsAvailable() const override;
@@ -46,8 +81,34 @@ public:
     virtual bool DynamicRenderingSupported() const override;
     virtual bool IndependentBlendingSupported() const override;
     virtual bool FragmentStoresAndAtomicsSupported() const override;
+    virtual bool TessellationShaderSupported() const override;
+    virtual bool GeometryShaderSupported() const override;
     virtual bool PartialDescriptorBindingsSupported() const override;
+    virtual bool PushDescriptorsSupported() const override;
     bool         IndexTypeUint8Supported() const override;
+    virtual bool DrawIndirectCountSupported() const override;
+    virtual bool MeshShaderSupported() const override;
+    virtual bool AmplificationShaderSupported() const override;
+    virtual bool AccelerationStructureSupported() const override;
+    virtual bool BufferDeviceAddressSupported() const override;
+    virtual bool RayQuerySupported() const override;
+    virtual bool TimelineSemaphoreSupported() const override;
+    virtual bool ExtendedDynamicStateSupported() const override;
+    virtual bool DynamicBlendEnableSupported() const override;
+    virtual bool ShaderObjectsSupported() const override;
+    virtual bool DescriptorBuffersEnabled() const override;
+    virtual bool ConditionalRenderingSupported() const override;
+    virtual bool ImageHostUploadSupported(grfx::ImageHostUpload hostUpload, grfx::Format format) const override;
+    virtual bool SampledImageFormatSupported(grfx::Format format) const override;
+    virtual bool RenderTargetSampleCountSupported(grfx::Format format, grfx::SampleCount sampleCount) const override;
+    virtual bool RenderTargetBlendSupported(grfx::Format format) const override;
+    virtual bool ImageCompressionSupported(grfx::Format format, grfx::ImageCompression compression) const override;
+    virtual bool SparseResidencySupported() const override;
+
+    virtual Result GetAccelerationStructureBuildSizes(const grfx::AccelerationStructureBuildInputs* pInputs, grfx::AccelerationStructureBuildSizes* pSizes) const override;
+    virtual Result GetMemoryStatistics(grfx::MemoryStatistics* pStatistics) const override;
+
+    virtual Result SavePipelineCache() override;
 
     void ResetQueryPoolEXT(
         VkQueryPool queryPool,
@@ -65,7 +126,44 @@ public:
 
     uint32_t GetMaxPushDescriptors() const { return mMaxPushDescriptors; }
 
+    // Render passes and framebuffers shared by vk::RenderPass objects with
+    // DeviceCreateInfo::renderPassCache. key must hold everything in the
+    // create info that affects the object, handles are reference counted and
+    // the Release functions destroy them with the last reference. Handles
+    // that aren't cached are destroyed right away by the Release functions.
+    Result AcquireRenderPass(const std::vector<uint64_t>& key, const VkRenderPassCreateInfo* pCreateInfo, VkRenderPass* pRenderPass);
+    void   ReleaseRenderPass(VkRenderPass renderPass);
+    Result AcquireFramebuffer(const std::vector<uint64_t>& key, const VkFramebufferCreateInfo* pCreateInfo, VkFramebuffer* pFramebuffer);
+    void   ReleaseFramebuffer(VkFramebuffer framebuffer);
+
+    // Graphics pipeline libraries shared by vk::GraphicsPipeline objects,
+    // key must hold everything in the create info that affects the library.
+    // Libraries are reference counted like the cached render passes. Safe
+    // to call from the pipeline compile threads.
+    Result AcquirePipelineLibrary(const std::vector<uint64_t>& key, const VkGraphicsPipelineCreateInfo* pCreateInfo, VkPipeline* pLibrary);
+    void   ReleasePipelineLibrary(VkPipeline library);
+
+#if defined(VK_EXT_descriptor_buffer)
+    // Ranges of the descriptor buffer used by descriptor sets if
+    // UsesDescriptorBuffers(). Offsets are aligned to
+    // descriptorBufferOffsetAlignment and the memory stays mapped. Safe to
+    // call from any thread.
+    Result AllocateDescriptorBufferRange(VkDeviceSize size, VkDeviceSize* pOffset);
+    void   FreeDescriptorBufferRange(VkDeviceSize offset);
+
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT& GetDescriptorBufferProperties() const { return mDescriptorBufferProperties; }
+
+    // Size of one descriptor of type in the descriptor buffer
+    size_t GetDescriptorSize(VkDescriptorType type) const;
+
+    VkBuffer           GetDescriptorBuffer() const { return mDescriptorBuffer; }
+    VkDeviceAddress    GetDescriptorBufferAddress() const { return mDescriptorBufferAddress; }
+    VkBufferUsageFlags GetDescriptorBufferUsage() const { return mDescriptorBufferUsage; }
+    char*              GetDescriptorBufferMappedAddress() const { return mDescriptorBufferMappedAddress; }
+#endif
+
 protected:
+    virtual Result AllocateObject(grfx::AccelerationStructure** ppObject) override;
     virtual Result AllocateObject(grfx::Buffer** ppObject) override;
     virtual Result AllocateObject(grfx::CommandBuffer** ppObject) override;
     virtual Result AllocateObject(grfx::CommandPool** ppObject) override;
@@ -96,6 +194,10 @@ protected:
     virtual Result CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+    // Uses VMA's defragmentation passes, each pass copies the moved
+    // resources on the graphics queue and waits for the copies
+    virtual Result DefragmentApiObjects(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats) override;
+
 private:
     Result ConfigureQueueInfo(const grfx::DeviceCreateInfo* pCreateInfo, std::vector<float>& queuePriorities, std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos);
     Result ConfigureExtensions(const grfx::DeviceCreateInfo* pCreateInfo);
@@ -111,6 +213,40 @@ private:
         VkPhysicalDevice               physicalDevice,
         grfx::ShadingRateCapabilities* pShadingRateCapabilities);
     Result CreateQueues(const grfx::DeviceCreateInfo* pCreateInfo);
+    Result CreatePipelineCache(const grfx::DeviceCreateInfo* pCreateInfo);
+    Result CreateDescriptorBuffer(const grfx::DeviceCreateInfo* pCreateInfo);
+
+private:
+    // Keyed by the XXH3 hash of key, a key mismatch is a hash collision
+    // and the colliding object isn't cached
+    template <typename HandleT>
+    struct CachedHandle
+    {
+        HandleT               handle = VK_NULL_HANDLE;
+        std::vector<uint64_t> key;
+        uint32_t              refCount = 0;
+    };
+
+    std::mutex                                                mRenderPassCacheMutex;
+    std::unordered_map<uint64_t, CachedHandle<VkRenderPass>>  mRenderPassCache;
+    std::unordered_map<uint64_t, CachedHandle<VkFramebuffer>> mFramebufferCache;
+
+    std::mutex                                             mPipelineLibraryCacheMutex;
+    std::unordered_map<uint64_t, CachedHandle<VkPipeline>> mPipelineLibraryCache;
+
+#if defined(VK_EXT_descriptor_buffer)
+    // Ranges are placed by a VMA virtual block, keyed by offset so that
+    // descriptor sets only need to keep their offset
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT          mDescriptorBufferProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+    VkBufferPtr                                            mDescriptorBuffer;
+    VmaAllocationPtr                                       mDescriptorBufferAllocation;
+    VkDeviceAddress                                        mDescriptorBufferAddress       = 0;
+    VkBufferUsageFlags                                     mDescriptorBufferUsage         = 0;
+    char*                                                  mDescriptorBufferMappedAddress = nullptr;
+    std::mutex                                             mDescriptorBufferMutex;
+    VmaVirtualBlock                                        mDescriptorBufferBlock = VK_NULL_HANDLE;
+    std::unordered_map<VkDeviceSize, VmaVirtualAllocation> mDescriptorBufferRanges;
+#endif
 
 private:
     std::vector<std::string>                       mFoundExtensions;
@@ -119,13 +255,35 @@ private:
     VkPhysicalDeviceFeatures                       mDeviceFeatures             = {};
     VkPhysicalDeviceDescriptorIndexingFeatures     mDescriptorIndexingFeatures = {};
     VmaAllocatorPtr                                mVmaAllocator;
+    VkPipelineCachePtr                             mPipelineCache;
     bool                                           mHasDescriptorIndexingFeatures              = false;
     bool                                           mHasTimelineSemaphore                       = false;
     bool                                           mHasExtendedDynamicState                    = false;
+    bool                                           mHasDynamicBlendEnable                      = false;
+    bool                                           mHasHostImageCopy                           = false;
+    bool                                           mHasImageCompressionControl                 = false;
+    bool                                           mHasSparseResidency                         = false;
     bool                                           mHasDepthClipEnabled                        = false;
     bool                                           mHasMultiView                               = false;
     bool                                           mHasDynamicRendering                        = false;
+    bool                                           mUsesDynamicRenderPasses                    = false;
+    bool                                           mHasGraphicsPipelineLibrary                 = false;
+    bool                                           mHasShaderObject                            = false;
+    bool                                           mHasDescriptorBuffer                        = false;
+    bool                                           mHasDescriptorBufferPushDescriptors         = false;
+    bool                                           mUsesDescriptorBuffers                      = false;
+    bool                                           mUsesGraphicsPipelineLibraries              = false;
     bool                                           mIndexTypeUint8Supported                    = false;
+    bool                                           mHasSynchronization2                        = false;
+    bool                                           mHasMemoryBudget                            = false;
+    bool                                           mHasDrawIndirectCount                       = false;
+    bool                                           mHasConditionalRendering                    = false;
+    bool                                           mHasMeshShader                              = false;
+    bool                                           mHasTaskShader                              = false;
+    bool                                           mHasBufferDeviceAddress                     = false;
+    bool                                           mHasAccelerationStructure                   = false;
+    bool                                           mHasRayQuery                                = false;
+    bool                                           mHasPresentWait                             = false;
     PFN_vkResetQueryPoolEXT                        mFnResetQueryPoolEXT                        = nullptr;
     PFN_vkWaitSemaphores                           mFnWaitSemaphores                           = nullptr;
     PFN_vkSignalSemaphore                          mFnSignalSemaphore                          = nullptr;
@@ -141,11 +299,106 @@ private:
 
 extern PFN_vkCmdPushDescriptorSetKHR CmdPushDescriptorSetKHR;
 
+// Only set if the instance has debug enabled
+extern PFN_vkCmdBeginDebugUtilsLabelEXT CmdBeginDebugUtilsLabelEXT;
+extern PFN_vkCmdEndDebugUtilsLabelEXT   CmdEndDebugUtilsLabelEXT;
+
 #if defined(VK_KHR_dynamic_rendering)
 extern PFN_vkCmdBeginRenderingKHR CmdBeginRenderingKHR;
 extern PFN_vkCmdEndRenderingKHR   CmdEndRenderingKHR;
 #endif
 
+#if defined(VK_KHR_synchronization2)
+extern PFN_vkCmdPipelineBarrier2KHR CmdPipelineBarrier2KHR;
+extern PFN_vkQueueSubmit2KHR        QueueSubmit2KHR;
+#endif
+
+#if defined(VK_KHR_draw_indirect_count)
+extern PFN_vkCmdDrawIndirectCountKHR        CmdDrawIndirectCountKHR;
+extern PFN_vkCmdDrawIndexedIndirectCountKHR CmdDrawIndexedIndirectCountKHR;
+#endif
+
+#if defined(VK_EXT_conditional_rendering)
+extern PFN_vkCmdBeginConditionalRenderingEXT CmdBeginConditionalRenderingEXT;
+extern PFN_vkCmdEndConditionalRenderingEXT   CmdEndConditionalRenderingEXT;
+#endif
+
+#if defined(VK_EXT_mesh_shader)
+extern PFN_vkCmdDrawMeshTasksEXT              CmdDrawMeshTasksEXT;
+extern PFN_vkCmdDrawMeshTasksIndirectEXT      CmdDrawMeshTasksIndirectEXT;
+extern PFN_vkCmdDrawMeshTasksIndirectCountEXT CmdDrawMeshTasksIndirectCountEXT;
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state)
+extern PFN_vkCmdSetCullModeEXT          CmdSetCullModeEXT;
+extern PFN_vkCmdSetPrimitiveTopologyEXT CmdSetPrimitiveTopologyEXT;
+extern PFN_vkCmdSetDepthTestEnableEXT   CmdSetDepthTestEnableEXT;
+extern PFN_vkCmdSetDepthWriteEnableEXT  CmdSetDepthWriteEnableEXT;
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state3)
+extern PFN_vkCmdSetColorBlendEnableEXT CmdSetColorBlendEnableEXT;
+#endif
+
+// Only set if the device supports shader objects
+#if defined(VK_EXT_shader_object)
+extern PFN_vkCreateShadersEXT                  CreateShadersEXT;
+extern PFN_vkDestroyShaderEXT                  DestroyShaderEXT;
+extern PFN_vkCmdBindShadersEXT                 CmdBindShadersEXT;
+extern PFN_vkCmdSetViewportWithCountEXT        CmdSetViewportWithCountEXT;
+extern PFN_vkCmdSetScissorWithCountEXT         CmdSetScissorWithCountEXT;
+extern PFN_vkCmdSetVertexInputEXT              CmdSetVertexInputEXT;
+extern PFN_vkCmdSetRasterizerDiscardEnableEXT  CmdSetRasterizerDiscardEnableEXT;
+extern PFN_vkCmdSetFrontFaceEXT                CmdSetFrontFaceEXT;
+extern PFN_vkCmdSetDepthCompareOpEXT           CmdSetDepthCompareOpEXT;
+extern PFN_vkCmdSetDepthBoundsTestEnableEXT    CmdSetDepthBoundsTestEnableEXT;
+extern PFN_vkCmdSetDepthBiasEnableEXT          CmdSetDepthBiasEnableEXT;
+extern PFN_vkCmdSetStencilTestEnableEXT        CmdSetStencilTestEnableEXT;
+extern PFN_vkCmdSetStencilOpEXT                CmdSetStencilOpEXT;
+extern PFN_vkCmdSetPrimitiveRestartEnableEXT   CmdSetPrimitiveRestartEnableEXT;
+extern PFN_vkCmdSetPatchControlPointsEXT       CmdSetPatchControlPointsEXT;
+extern PFN_vkCmdSetTessellationDomainOriginEXT CmdSetTessellationDomainOriginEXT;
+extern PFN_vkCmdSetPolygonModeEXT              CmdSetPolygonModeEXT;
+extern PFN_vkCmdSetRasterizationSamplesEXT     CmdSetRasterizationSamplesEXT;
+extern PFN_vkCmdSetSampleMaskEXT               CmdSetSampleMaskEXT;
+extern PFN_vkCmdSetAlphaToCoverageEnableEXT    CmdSetAlphaToCoverageEnableEXT;
+extern PFN_vkCmdSetAlphaToOneEnableEXT         CmdSetAlphaToOneEnableEXT;
+extern PFN_vkCmdSetLogicOpEnableEXT            CmdSetLogicOpEnableEXT;
+extern PFN_vkCmdSetLogicOpEXT                  CmdSetLogicOpEXT;
+extern PFN_vkCmdSetColorBlendEquationEXT       CmdSetColorBlendEquationEXT;
+extern PFN_vkCmdSetColorWriteMaskEXT           CmdSetColorWriteMaskEXT;
+extern PFN_vkCmdSetDepthClampEnableEXT         CmdSetDepthClampEnableEXT;
+extern PFN_vkCmdSetDepthClipEnableEXT          CmdSetDepthClipEnableEXT;
+#endif
+
+// Only set if the device uses descriptor buffers
+#if defined(VK_EXT_descriptor_buffer)
+extern PFN_vkGetDescriptorSetLayoutSizeEXT          GetDescriptorSetLayoutSizeEXT;
+extern PFN_vkGetDescriptorSetLayoutBindingOffsetEXT GetDescriptorSetLayoutBindingOffsetEXT;
+extern PFN_vkGetDescriptorEXT                       GetDescriptorEXT;
+extern PFN_vkCmdBindDescriptorBuffersEXT            CmdBindDescriptorBuffersEXT;
+extern PFN_vkCmdSetDescriptorBufferOffsetsEXT       CmdSetDescriptorBufferOffsetsEXT;
+#endif
+
+#if defined(VK_EXT_host_image_copy)
+extern PFN_vkCopyMemoryToImageEXT CopyMemoryToImageEXT;
+#endif
+
+#if defined(VK_KHR_present_wait)
+extern PFN_vkWaitForPresentKHR WaitForPresentKHR;
+#endif
+
+#if defined(VK_KHR_acceleration_structure)
+extern PFN_vkCreateAccelerationStructureKHR              CreateAccelerationStructureKHR;
+extern PFN_vkDestroyAccelerationStructureKHR             DestroyAccelerationStructureKHR;
+extern PFN_vkGetAccelerationStructureBuildSizesKHR       GetAccelerationStructureBuildSizesKHR;
+extern PFN_vkGetAccelerationStructureDeviceAddressKHR    GetAccelerationStructureDeviceAddressKHR;
+extern PFN_vkCmdBuildAccelerationStructuresKHR           CmdBuildAccelerationStructuresKHR;
+extern PFN_vkCmdCopyAccelerationStructureKHR             CmdCopyAccelerationStructureKHR;
+extern PFN_vkCmdWriteAccelerationStructuresPropertiesKHR CmdWriteAccelerationStructuresPropertiesKHR;
+extern PFN_vkGetBufferDeviceAddressKHR                   GetBufferDeviceAddressKHR;
+#endif
+
 } // namespace vk
 } // namespace grfx
 } // namespace ppx
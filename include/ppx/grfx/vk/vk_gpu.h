@@ -31,7 +31,8 @@ public:
 
     VkPhysicalDevicePtr GetVkGpu() const { return mGpu; }
 
-    const VkPhysicalDeviceLimits& GetLimits() const { return mGpuProperties.limits; }
+    const VkPhysicalDeviceProperties& GetProperties() const { return mGpuProperties; }
+    const VkPhysicalDeviceLimits&     GetLimits() const { return mGpuProperties.limits; }
 
     float GetTimestampPeriod() const;
 
@@ -49,6 +50,9 @@ protected:
     virtual Result CreateApiObjects(const grfx::internal::GpuCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    void QueryShaderCapabilities();
+
 private:
     VkPhysicalDevicePtr                  mGpu;
     VkPhysicalDeviceProperties           mGpuProperties;
@@ -33,19 +33,63 @@ public:
     VkFormat           GetVkFormat() const { return mVkFormat; }
     VkImageAspectFlags GetVkImageAspectFlags() const { return mImageAspect; }
 
+    // Null for external and aliased images
+    VmaAllocationPtr         GetVmaAllocation() const { return mAllocation; }
+    const VmaAllocationInfo& GetVmaAllocationInfo() const { return mAllocationInfo; }
+
     virtual Result MapMemory(uint64_t offset, void** ppMappedAddress) override;
     virtual void   UnmapMemory() override;
 
+    virtual Result CopyFromHost(
+        uint32_t    mipLevel,
+        uint32_t    arrayLayer,
+        const void* pSrcData,
+        uint32_t    srcRowStride) override;
+
+    // Takes tile memory for the binds of pBindInfo and gives the memory of
+    // its unbinds back to the image, used by vk::Queue
+    Result GetSparseImageMemoryBinds(
+        const grfx::SparseImageBindInfo*      pBindInfo,
+        std::vector<VkSparseImageMemoryBind>* pBinds);
+
+    // Defragmentation, see vk::Device::DefragmentApiObjects(). Images the
+    // device can't move are created without the extra transfer usage.
+    // Images that other images alias must not be moved either, which the
+    // device checks.
+    bool IsMovable() const;
+    // Creates the image that's bound to dstAllocation and records the copy
+    // of all subresources into it. All subresources must be in state, the
+    // new image is left in it.
+    Result BeginMove(VmaAllocation dstAllocation, grfx::ResourceState state, VkCommandBuffer commandBuffer);
+    // Replaces the image once the copy has executed, before VMA frees the
+    // old memory, or destroys the new one if the move is canceled
+    void FinishMove(bool cancel);
+    // Reads the new place of the allocation after the defragmentation pass
+    void UpdateAllocationInfo();
+
 protected:
     virtual Result CreateApiObjects(const grfx::ImageCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    Result CreateVkImage(VkImage* pImage) const;
+
+    // Reads the tile layout and binds the mip tail
+    Result InitializeSparseResidency(const grfx::ImageCreateInfo* pCreateInfo);
+
 private:
     VkImagePtr         mImage;
+    VkImagePtr         mMoveImage; // Between BeginMove() and FinishMove()
     VmaAllocationPtr   mAllocation;
     VmaAllocationInfo  mAllocationInfo = {};
     VkFormat           mVkFormat       = VK_FORMAT_UNDEFINED;
     VkImageAspectFlags mImageAspect    = ppx::InvalidValue<VkImageAspectFlags>();
+
+    // Sparse residency, tile memory is indexed by GetSparseTileIndex()
+    VkMemoryRequirements       mSparseMemoryRequirements = {};
+    std::vector<VmaAllocation> mSparseTileAllocations;
+    std::vector<VmaAllocation> mFreeSparseTileAllocations;
+    std::vector<VmaAllocation> mMipTailAllocations;
 };
 
 // -------------------------------------------------------------------------------------------------
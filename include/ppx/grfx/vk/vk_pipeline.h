@@ -18,10 +18,33 @@
 #include "ppx/grfx/vk/vk_config.h"
 #include "ppx/grfx/grfx_pipeline.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
 namespace ppx {
 namespace grfx {
 namespace vk {
 
+//! @struct SpecializationInfo
+//!
+//! VkSpecializationInfo of one shader stage and the data it points to,
+//! must stay in place until the pipeline is created.
+//!
+struct SpecializationInfo
+{
+    std::vector<VkSpecializationMapEntry> mapEntries;
+    std::vector<uint32_t>                 data;
+    VkSpecializationInfo                  info = {};
+};
+
+//! Returns nullptr if \b stage has no specialization constants.
+const VkSpecializationInfo* ToVkSpecializationInfo(const grfx::ShaderStageInfo& stage, vk::SpecializationInfo* pSpecialization);
+
+//! Returns the create flags every pipeline on \b pDevice needs for its descriptor sets.
+VkPipelineCreateFlags ToVkDescriptorBufferPipelineFlags(const vk::Device* pDevice);
+
 //! @class ComputePipeline
 //!
 //!
@@ -54,7 +77,18 @@ public:
     GraphicsPipeline() {}
     virtual ~GraphicsPipeline() {}
 
-    VkPipelinePtr GetVkPipeline() const { return mPipeline; }
+    // Pipelines linked from libraries return the link time optimized
+    // pipeline once the pipeline compile thread has finished it.
+    VkPipelinePtr GetVkPipeline() const;
+
+    // True if the pipeline was created as shader objects, see
+    // grfx::GraphicsPipelineCreateInfo::shaderObjects. GetVkPipeline()
+    // returns VK_NULL_HANDLE for these.
+    bool UsesShaderObjects() const { return mUsesShaderObjects; }
+
+    // Binds the shader objects and sets all of the pipeline's state on
+    // commandBuffer. Viewports and scissors are left to vk::CommandBuffer.
+    void CmdBindShaderObjects(VkCommandBuffer commandBuffer) const;
 
 protected:
     virtual Result CreateApiObjects(const grfx::GraphicsPipelineCreateInfo* pCreateInfo) override;
@@ -63,6 +97,7 @@ protected:
 private:
     Result InitializeShaderStages(
         const grfx::GraphicsPipelineCreateInfo*       pCreateInfo,
+        std::vector<vk::SpecializationInfo>&          specializations,
         std::vector<VkPipelineShaderStageCreateInfo>& shaderStages,
         VkGraphicsPipelineCreateInfo&                 vkCreateInfo);
     Result InitializeVertexInput(
@@ -98,9 +133,61 @@ private:
         const grfx::GraphicsPipelineCreateInfo* pCreateInfo,
         std::vector<VkDynamicState>&            dynamicStates,
         VkPipelineDynamicStateCreateInfo&       stateCreateInfo);
+#if defined(VK_EXT_shader_object)
+    Result CreateShaderObjects(
+        const grfx::GraphicsPipelineCreateInfo* pCreateInfo,
+        const VkGraphicsPipelineCreateInfo&     vkCreateInfo);
+#endif
+#if defined(VK_EXT_graphics_pipeline_library)
+    Result CreateFromLibraries(
+        const grfx::GraphicsPipelineCreateInfo* pCreateInfo,
+        const VkGraphicsPipelineCreateInfo&     vkCreateInfo,
+        const VkPipelineRenderingCreateInfo&    renderingCreateInfo);
+#endif
 
 private:
-    VkPipelinePtr mPipeline;
+    // Shared with the task that relinks the libraries with link time
+    // optimization so the pipeline can be destroyed before it runs
+    struct OptimizedLink
+    {
+        std::mutex              mutex;
+        std::condition_variable doneCondition;
+        bool                    cancelled = false;
+        bool                    running   = false;
+        std::atomic<VkPipeline> pipeline  = {VK_NULL_HANDLE};
+    };
+
+#if defined(VK_EXT_shader_object)
+    // Recorded by CmdBindShaderObjects() in place of binding a pipeline
+    struct ShaderObjectState
+    {
+        std::vector<VkShaderStageFlagBits>                 stages;
+        std::vector<VkShaderEXT>                           shaders;
+        std::vector<VkVertexInputBindingDescription2EXT>   vertexBindings;
+        std::vector<VkVertexInputAttributeDescription2EXT> vertexAttributes;
+        VkPipelineInputAssemblyStateCreateInfo             inputAssembly      = {};
+        uint32_t                                           patchControlPoints = 0;
+        VkTessellationDomainOrigin                         domainOrigin       = VK_TESSELLATION_DOMAIN_ORIGIN_UPPER_LEFT;
+        VkPipelineRasterizationStateCreateInfo             rasterization      = {};
+        VkBool32                                           depthClipEnable    = VK_TRUE;
+        VkPipelineMultisampleStateCreateInfo               multisample        = {};
+        VkPipelineDepthStencilStateCreateInfo              depthStencil       = {};
+        VkBool32                                           logicOpEnable      = VK_FALSE;
+        VkLogicOp                                          logicOp            = VK_LOGIC_OP_CLEAR;
+        float                                              blendConstants[4]  = {};
+        std::vector<VkBool32>                              blendEnables;
+        std::vector<VkColorBlendEquationEXT>               blendEquations;
+        std::vector<VkColorComponentFlags>                 colorWriteMasks;
+    };
+
+    std::vector<VkShaderEXT> mShaders;
+    ShaderObjectState        mShaderObjectState;
+#endif
+
+    VkPipelinePtr                  mPipeline;
+    std::vector<VkPipeline>        mLibraries;
+    std::shared_ptr<OptimizedLink> mOptimizedLink;
+    bool                           mUsesShaderObjects = false;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -119,13 +206,20 @@ public:
 
     VkShaderStageFlags GetPushConstantShaderStageFlags() const { return mPushConstantShaderStageFlags; }
 
+    // What the layout was created from, shader objects take these instead
+    // of a layout
+    const std::vector<VkDescriptorSetLayout>& GetVkDescriptorSetLayouts() const { return mSetLayouts; }
+    const std::vector<VkPushConstantRange>&   GetVkPushConstantRanges() const { return mPushConstantRanges; }
+
 protected:
     virtual Result CreateApiObjects(const grfx::PipelineInterfaceCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
 private:
-    VkPipelineLayoutPtr mPipelineLayout;
-    VkShaderStageFlags  mPushConstantShaderStageFlags = 0;
+    VkPipelineLayoutPtr                mPipelineLayout;
+    VkShaderStageFlags                 mPushConstantShaderStageFlags = 0;
+    std::vector<VkDescriptorSetLayout> mSetLayouts;
+    std::vector<VkPushConstantRange>   mPushConstantRanges;
 };
 
 } // namespace vk
@@ -33,9 +33,12 @@ public:
 
     uint32_t GetQueueFamilyIndex() const { return mCreateInfo.queueFamilyIndex; }
 
+    virtual bool RequiresOwnershipTransfer(const grfx::Queue* pOtherQueue) const override;
+
     virtual Result WaitIdle() override;
 
     virtual Result Submit(const grfx::SubmitInfo* pSubmitInfo) override;
+    virtual Result SubmitBatch(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos) override;
 
     virtual Result QueueWait(grfx::Semaphore* pSemaphore, uint64_t value) override;
     virtual Result QueueSignal(grfx::Semaphore* pSemaphore, uint64_t value) override;
@@ -53,10 +56,22 @@ public:
         VkImageLayout        newLayout,
         VkPipelineStageFlags newPipelineStage);
 
+    // Used for binds that must be done before the object is used, such as
+    // the mip tail of sparse images
+    VkResult BindSparseAndWait(const VkBindSparseInfo* pBindInfo);
+
 protected:
     virtual Result CreateApiObjects(const grfx::internal::QueueCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
+private:
+    virtual Result BindSparseImageTilesImpl(const grfx::SparseImageBindInfo* pBindInfo) override;
+
+#if defined(VK_KHR_synchronization2)
+    // vkQueueSubmit2KHR path, used when the device has VK_KHR_synchronization2
+    Result SubmitBatch2(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos);
+#endif
+
 private:
     VkQueuePtr       mQueue;
     VkCommandPoolPtr mTransientPool;
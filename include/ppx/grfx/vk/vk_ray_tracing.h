@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_grfx_vk_ray_tracing_h
+#define ppx_grfx_vk_ray_tracing_h
+
+#include "ppx/grfx/vk/vk_config.h"
+#include "ppx/grfx/grfx_ray_tracing.h"
+
+namespace ppx {
+namespace grfx {
+namespace vk {
+
+class AccelerationStructure
+    : public grfx::AccelerationStructure
+{
+public:
+    AccelerationStructure() {}
+    virtual ~AccelerationStructure() {}
+
+    VkAccelerationStructurePtr GetVkAccelerationStructure() const { return mAccelerationStructure; }
+
+    virtual uint64_t GetDeviceAddress() const override { return mDeviceAddress; }
+
+protected:
+    virtual Result CreateApiObjects(const grfx::AccelerationStructureCreateInfo* pCreateInfo) override;
+    virtual void   DestroyApiObjects() override;
+
+private:
+    VkAccelerationStructurePtr mAccelerationStructure;
+    uint64_t                   mDeviceAddress = 0;
+};
+
+#if defined(VK_KHR_acceleration_structure)
+//! @struct AccelerationStructureBuildGeometry
+//!
+//! Vulkan build description of grfx::AccelerationStructureBuildInputs.
+//! Buffer addresses are 0 for buffers that are null, which is enough for
+//! size queries.
+//!
+struct AccelerationStructureBuildGeometry
+{
+    VkAccelerationStructureBuildGeometryInfoKHR     buildInfo = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR};
+    std::vector<VkAccelerationStructureGeometryKHR> geometries;
+    std::vector<uint32_t>                           primitiveCounts;
+};
+
+Result ToVkAccelerationStructureBuildGeometry(const grfx::AccelerationStructureBuildInputs* pInputs, bool update, vk::AccelerationStructureBuildGeometry* pGeometry);
+#endif
+
+} // namespace vk
+} // namespace grfx
+} // namespace ppx
+
+#endif // ppx_grfx_vk_ray_tracing_h
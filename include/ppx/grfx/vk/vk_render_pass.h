@@ -29,9 +29,14 @@ public:
     RenderPass() {}
     virtual ~RenderPass() {}
 
+    // Null if the render pass uses dynamic rendering
     VkRenderPassPtr  GetVkRenderPass() const { return mRenderPass; }
     VkFramebufferPtr GetVkFramebuffer() const { return mFramebuffer; }
 
+    // See vk::Device::UsesDynamicRenderPasses()
+    bool          UsesDynamicRendering() const { return mUsesDynamicRendering; }
+    VkImageLayout GetDepthStencilLayout() const { return mDepthStencilLayout; }
+
 protected:
     virtual Result CreateApiObjects(const grfx::internal::RenderPassCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
@@ -41,8 +46,11 @@ private:
     Result CreateFramebuffer(const grfx::internal::RenderPassCreateInfo* pCreateInfo);
 
 private:
-    VkRenderPassPtr  mRenderPass;
-    VkFramebufferPtr mFramebuffer;
+    VkRenderPassPtr       mRenderPass;
+    VkFramebufferPtr      mFramebuffer;
+    std::vector<uint64_t> mCompatibilityKey; // See CreateRenderPass()
+    bool                  mUsesDynamicRendering = false;
+    VkImageLayout         mDepthStencilLayout   = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -34,12 +34,23 @@ public:
 
     VkShaderModulePtr GetVkShaderModule() const { return mShaderModule; }
 
+    // XXH3 hash of the SPIR-V, identifies the code independently of the
+    // handle, which the driver may reuse once the module is destroyed
+    uint64_t GetCodeHash() const { return mCodeHash; }
+
+    // SPIR-V the module was created from, shader objects are created from
+    // code rather than modules. Empty unless the device supports shader
+    // objects.
+    const std::vector<char>& GetCode() const { return mCode; }
+
 protected:
     virtual Result CreateApiObjects(const grfx::ShaderModuleCreateInfo* pCreateInfo) override;
     virtual void   DestroyApiObjects() override;
 
 private:
     VkShaderModulePtr mShaderModule;
+    uint64_t          mCodeHash = 0;
+    std::vector<char> mCode;
 };
 
 } // namespace vk
@@ -208,6 +208,7 @@ protected:
 
     std::unique_ptr<ShadingRateEncoder> mShadingRateEncoder;
     VkImageViewPtr                      mAttachmentView;
+    bool                                mOwnsAttachmentImage = true;
 };
 
 } // namespace vk
@@ -93,6 +93,8 @@ private:
 private:
     VkSwapchainPtr mSwapchain;
     VkQueuePtr     mQueue;
+    bool           mUsePresentWait = false; // maxFrameLatency > 0 and VK_KHR_present_wait
+    uint64_t       mPresentId      = 0;     // Of the last present
 };
 
 } // namespace vk
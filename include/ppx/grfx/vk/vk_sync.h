@@ -36,6 +36,7 @@ public:
 
     virtual Result Wait(uint64_t timeout = UINT64_MAX) override;
     virtual Result Reset() override;
+    virtual bool   IsSignaled() const override;
 
 protected:
     virtual Result CreateApiObjects(const grfx::FenceCreateInfo* pCreateInfo) override;
@@ -80,6 +80,27 @@ Result ToVkBarrierDst(
     VkAccessFlags&                  accessMask,
     VkImageLayout&                  layout);
 
+#if defined(VK_KHR_synchronization2)
+// Synchronization2 variants of ToVkBarrierSrc/Dst. Layouts are identical,
+// stage and access masks use the finer grained *2 bits (e.g. index input
+// vs. vertex attribute input, copy vs. blit vs. resolve).
+//
+Result ToVkBarrierSrc2(
+    ResourceState                   state,
+    grfx::CommandType               commandType,
+    const VkPhysicalDeviceFeatures& features,
+    VkPipelineStageFlags2KHR&       stageMask,
+    VkAccessFlags2KHR&              accessMask,
+    VkImageLayout&                  layout);
+Result ToVkBarrierDst2(
+    ResourceState                   state,
+    grfx::CommandType               commandType,
+    const VkPhysicalDeviceFeatures& features,
+    VkPipelineStageFlags2KHR&       stageMask,
+    VkAccessFlags2KHR&              accessMask,
+    VkImageLayout&                  layout);
+#endif
+
 VkImageAspectFlags DetermineAspectMask(VkFormat format);
 
 VmaMemoryUsage ToVmaMemoryUsage(grfx::MemoryUsage value);
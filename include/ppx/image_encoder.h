@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_image_encoder_h
+#define ppx_image_encoder_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_format.h"
+
+#include <filesystem>
+#include <vector>
+
+// Fast image encoders for screenshots and captured frames
+//
+// EncodePNG() trades some compression for speed the way fpng does: rows are
+// filtered with a fixed filter and deflated with a single probe LZ77 and
+// per block Huffman codes, which is an order of magnitude faster than
+// stb_image_write at the cost of files about 10-20% larger than zlib's.
+// EncodeQOI() writes the QOI format (https://qoiformat.org), which is
+// faster still and usually smaller than PPM by 3-5x.
+//
+namespace ppx {
+
+enum ImageFileFormat
+{
+    IMAGE_FILE_FORMAT_PPM = 0,
+    IMAGE_FILE_FORMAT_PNG = 1,
+    IMAGE_FILE_FORMAT_QOI = 2,
+};
+
+//! Returns PNG for .png, QOI for .qoi and PPM for anything else
+ImageFileFormat GetImageFileFormat(const std::filesystem::path& path);
+
+//! @brief Converts an 8-bit color image to tightly packed RGB8, e.g.
+//!        swizzles BGRA swapchain images and drops alpha.
+//! @param format UNORM, SRGB, UINT, SNORM or SINT format with 1 byte
+//!        components. Signed values are offset by 128 like ExportToPPM().
+//!        Missing components are written as 0.
+//! @param pDst Receives width * height * 3 bytes.
+Result ConvertToRGB8(grfx::Format format, const void* pTexels, uint32_t width, uint32_t height, uint32_t rowPitch, uint8_t* pDst);
+
+//! @brief Encodes 8-bit pixels as a PNG file in memory.
+//! @param channelCount 1 (gray), 2 (gray, alpha), 3 (RGB) or 4 (RGBA).
+Result EncodePNG(const void* pPixels, uint32_t width, uint32_t height, uint32_t rowStride, uint32_t channelCount, std::vector<uint8_t>* pOutput);
+
+//! @brief Encodes 8-bit pixels as a QOI file in memory.
+//! @param channelCount 3 (RGB) or 4 (RGBA).
+Result EncodeQOI(const void* pPixels, uint32_t width, uint32_t height, uint32_t rowStride, uint32_t channelCount, std::vector<uint8_t>* pOutput);
+
+//! @brief Writes an 8-bit color image in the format of the path's
+//!        extension, see GetImageFileFormat(). Alpha is dropped.
+Result WriteImageFile(const std::filesystem::path& path, grfx::Format format, const void* pTexels, uint32_t width, uint32_t height, uint32_t rowPitch);
+
+} // namespace ppx
+
+#endif // ppx_image_encoder_h
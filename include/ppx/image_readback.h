@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_image_readback_h
+#define ppx_image_readback_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/job_system.h"
+
+#include <filesystem>
+#include <functional>
+
+namespace ppx {
+
+struct ImageReadbackCreateInfo
+{
+    grfx::Queue* pQueue    = nullptr;
+    uint32_t     slotCount = 3;     // Captures in flight before Capture() blocks
+    bool         ordered   = false; // Runs the callbacks one at a time in capture order
+};
+
+//! Mapped texels of a finished copy, only valid during the callback
+struct ImageReadbackData
+{
+    grfx::Format format   = grfx::FORMAT_UNDEFINED;
+    uint32_t     width    = 0;
+    uint32_t     height   = 0;
+    uint32_t     rowPitch = 0;
+    const void*  pTexels  = nullptr;
+};
+
+//! @class ImageReadback
+//!
+//! Saves images to disk without stalling the frame. Capture() records a
+//! copy of the image to a GPU_TO_CPU buffer and submits it with a fence,
+//! Poll() maps the buffers of finished copies and writes them out on
+//! JobSystem::Get(), then recycles the slots whose files were written.
+//!
+//! Files are written with WriteImageFile(), as PNG or QOI if their path
+//! ends with .png or .qoi and as PPM otherwise. Alpha is dropped. Only
+//! 8-bit color formats are supported. Captures can also be handed to a callback instead, e.g. to
+//! stream them to a video file with ImageReadbackCreateInfo::ordered.
+//!
+class ImageReadback
+{
+public:
+    using Callback = std::function<Result(const ImageReadbackData&)>;
+
+    ImageReadback();
+    virtual ~ImageReadback();
+
+    Result Initialize(const ImageReadbackCreateInfo& createInfo);
+    //! Writes the pending captures and destroys the slots
+    void Shutdown();
+
+    bool IsInitialized() const { return !IsNull(mQueue); }
+
+    //! Copies pImage, which must be in state, on the queue after the work
+    //! already submitted to it. Waits for the oldest capture if all slots
+    //! are busy.
+    Result Capture(grfx::Image* pImage, grfx::ResourceState state, const std::filesystem::path& path);
+    //! Calls callback on a job system worker once the copy has finished,
+    //! name is used in log messages
+    Result Capture(grfx::Image* pImage, grfx::ResourceState state, const std::string& name, Callback&& callback);
+
+    //! Advances finished captures, call once per frame
+    void Poll();
+    //! Waits until all captures are written
+    void Flush();
+
+    //! Returns the number of captures that haven't been written yet
+    uint32_t GetPendingCount() const;
+
+private:
+    enum SlotState
+    {
+        SLOT_STATE_FREE     = 0,
+        SLOT_STATE_COPYING  = 1,
+        SLOT_STATE_ENCODING = 2,
+    };
+
+    struct Slot
+    {
+        grfx::BufferPtr        buffer;
+        grfx::CommandBufferPtr cmd;
+        grfx::FencePtr         fence;
+        SlotState              state = SLOT_STATE_FREE;
+        ImageReadbackData      data; // pTexels is mapped while encoding
+        std::string            name;
+        Callback               callback;
+        Result                 result = ppx::SUCCESS;
+        JobCounter             counter;
+    };
+
+    // Moves slot to its next state, waits for it if wait is true
+    void Advance(uint32_t slotIndex, bool wait);
+
+private:
+    grfx::Queue*                       mQueue          = nullptr;
+    bool                               mOrdered        = false;
+    uint32_t                           mNextSlot       = 0;
+    uint32_t                           mLastEncodeSlot = UINT32_MAX;
+    std::vector<std::unique_ptr<Slot>> mSlots;
+};
+
+} // namespace ppx
+
+#endif // ppx_image_readback_h
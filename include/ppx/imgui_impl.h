@@ -18,6 +18,8 @@
 #include "imgui.h"
 
 #include "grfx/grfx_config.h"
+#include "grfx/grfx_bindless_heap.h"
+#include "grfx/grfx_transient_allocator.h"
 
 #if defined(PPX_D3D12)
 struct ID3D12DescriptorHeap;
@@ -27,6 +29,17 @@ namespace ppx {
 
 class Application;
 
+// What the last Render() submitted. The stock backends set the scissor and
+// bind the texture for every draw, the grfx backend only when they change.
+struct ImGuiRenderStats
+{
+    uint32_t drawCount        = 0;
+    uint32_t scissorCount     = 0;
+    uint32_t textureBindCount = 0;
+    uint32_t vertexCount      = 0;
+    uint32_t indexCount       = 0;
+};
+
 class ImGuiImpl
 {
 public:
@@ -39,10 +52,29 @@ public:
     virtual void   Render(grfx::CommandBuffer* pCommandBuffer) = 0;
     virtual void   ProcessEvents() {}
 
+    // Ends the ImGui frame and builds its draw data ahead of Render(),
+    // returns true if the draw data differs from the previous frame's
+    bool PrepareDrawData();
+
+    const ImGuiRenderStats& GetRenderStats() const { return mRenderStats; }
+
 protected:
     virtual Result InitApiObjects(ppx::Application* pApp) = 0;
     void           SetColorStyle();
     virtual void   NewFrameApi() = 0;
+
+    // Calls ImGui::Render() unless PrepareDrawData() already did this frame
+    void BuildDrawData();
+
+    // Fills mRenderStats for backends that draw every command with its own state
+    void CountStockBackendDraws();
+
+protected:
+    ImGuiRenderStats mRenderStats = {};
+
+private:
+    bool     mDrawDataBuilt = false;
+    uint64_t mDrawDataHash  = 0;
 };
 
 class ImGuiImplVk
@@ -70,6 +102,51 @@ private:
 #endif
 };
 
+//! @class ImGuiImplGrfx
+//!
+//! API independent renderer selected by grfx.enableGrfxImGui. Vertices
+//! and indices of all draw lists are written to one grfx::TransientAllocator
+//! allocation per frame instead of buffers that are recreated when they
+//! grow. Textures live in a grfx::BindlessHeap that is bound once, so each
+//! command only pushes its texture index and sets its scissor when they
+//! differ from the previous command's.
+//!
+//! Loads basic/shaders/ImGui.
+//!
+class ImGuiImplGrfx
+    : public ImGuiImpl
+{
+public:
+    ImGuiImplGrfx() {}
+    virtual ~ImGuiImplGrfx() {}
+
+    virtual void Shutdown(ppx::Application* pApp) override;
+    virtual void Render(grfx::CommandBuffer* pCommandBuffer) override;
+
+    //! Makes pTexture usable with ImGui::Image(), returns a null ImTextureID
+    //! if the heap is full
+    ImTextureID AddTexture(const grfx::Texture* pTexture);
+    void        RemoveTexture(ImTextureID textureId);
+
+protected:
+    virtual Result InitApiObjects(ppx::Application* pApp) override;
+    virtual void   NewFrameApi() override;
+
+private:
+    // Binds everything but the scissor and texture index of a command
+    void SetupRenderState(grfx::CommandBuffer* pCommandBuffer, const ImDrawData* pDrawData, const grfx::TransientAllocation& vertices, const grfx::TransientAllocation& indices);
+
+private:
+    grfx::BindlessHeapPtr       mHeap;
+    grfx::TransientAllocatorPtr mAllocator;
+    grfx::TexturePtr            mFontTexture;
+    grfx::SamplerPtr            mSampler;
+    grfx::PipelineInterfacePtr  mPipelineInterface;
+    grfx::GraphicsPipelinePtr   mPipeline;
+    uint32_t                    mFontTextureIndex = grfx::BindlessHeap::INVALID_INDEX;
+    uint64_t                    mFrameNumber      = UINT64_MAX; // Application frame mAllocator was last reset for
+};
+
 #if defined(PPX_D3D12)
 class ImGuiImplDx12
     : public ImGuiImpl
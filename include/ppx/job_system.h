@@ -0,0 +1,164 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PPX_JOB_SYSTEM_H
+#define PPX_JOB_SYSTEM_H
+
+#include "ppx/config.h"
+#include "ppx/profiler.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace ppx {
+
+class JobSystem;
+
+enum JobAffinity
+{
+    JOB_AFFINITY_ANY          = 0,
+    JOB_AFFINITY_BIG_CORES    = 1, // Cores with the highest max frequency
+    JOB_AFFINITY_LITTLE_CORES = 2, // Cores with the lowest max frequency
+};
+
+// -------------------------------------------------------------------------------------------------
+
+//! @class JobCounter
+//!
+//! Counts the unfinished jobs a counter was passed to. It reaches zero once
+//! all of them have run, which releases the jobs that depend on it, see
+//! JobSystem::RunAfter(). Counters must outlive their jobs and can only
+//! be reused once they reached zero.
+//!
+class JobCounter
+{
+public:
+    JobCounter() {}
+    ~JobCounter();
+
+    JobCounter(const JobCounter&)            = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool     IsDone() const { return mValue.load(std::memory_order_acquire) == 0; }
+    uint32_t GetValue() const { return mValue.load(std::memory_order_acquire); }
+
+private:
+    friend class JobSystem;
+
+    struct Continuation
+    {
+        std::function<void()> job;
+        JobCounter*           pCounter = nullptr;
+    };
+
+    std::atomic<uint32_t>     mValue{0};
+    std::mutex                mMutex;
+    std::vector<Continuation> mContinuations;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+struct JobSystemCreateInfo
+{
+    uint32_t    workerCount = 0;                // 0 uses one worker less than the hardware threads
+    JobAffinity affinity    = JOB_AFFINITY_ANY; // Hint, ignored where it's not supported
+};
+
+//! @class JobSystem
+//!
+//! Thread pool where each worker owns a deque of jobs. Workers run their
+//! own newest jobs first and steal the oldest jobs of other workers once
+//! they run out, so jobs spawned by jobs stay on the thread that spawned
+//! them while the pool stays busy.
+//!
+//! Fork/join is done with JobCounter: Run() jobs with a counter, then
+//! Wait() on it. Waiting threads run jobs themselves instead of blocking,
+//! so jobs can wait on the jobs they spawn.
+//!
+//! Workers register with Profiler::GetProfilerForThread() when they start
+//! and record each job to the "ppx::JobSystem::Job" event of their thread's
+//! profiler.
+//!
+class JobSystem
+{
+public:
+    using Job = std::function<void()>;
+
+    JobSystem();
+    virtual ~JobSystem();
+
+    //! Shared pool created on first use with the default create info
+    static JobSystem* Get();
+
+    //! Index of the calling thread's worker in the pool running it,
+    //! UINT32_MAX on threads that aren't workers
+    static uint32_t GetCurrentWorkerIndex();
+
+    Result Initialize(const JobSystemCreateInfo& createInfo);
+    //! Runs the queued jobs and stops the workers. Jobs still waiting on
+    //! a dependency are dropped.
+    void Shutdown();
+
+    uint32_t GetWorkerCount() const { return CountU32(mWorkers); }
+
+    //! Queues job, increments pCounter until it has run. Runs job on the
+    //! calling thread if the pool has no workers.
+    void Run(Job&& job, JobCounter* pCounter = nullptr);
+    //! Queues job once pDependency reached zero
+    void RunAfter(JobCounter* pDependency, Job&& job, JobCounter* pCounter = nullptr);
+    //! Runs jobs until pCounter reached zero
+    void Wait(JobCounter* pCounter);
+
+    //! Calls fn(begin, end) for ranges of at most grainSize of [0, count)
+    //! across the pool and returns once all of them have run
+    void ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& fn);
+
+private:
+    struct QueuedJob
+    {
+        Job         job;
+        JobCounter* pCounter = nullptr;
+    };
+
+    struct Worker
+    {
+        std::thread           thread;
+        std::mutex            mutex;
+        std::deque<QueuedJob> jobs; // Owner uses the back, thieves the front
+    };
+
+    // Queues a job whose counter was already incremented
+    void Push(Job&& job, JobCounter* pCounter);
+    bool TryRunJob(uint32_t workerIndex);
+    void Complete(JobCounter* pCounter);
+    void WorkerMain(uint32_t workerIndex);
+
+private:
+    std::vector<std::unique_ptr<Worker>> mWorkers;
+    std::vector<uint32_t>                mAffinityCpus; // Empty if workers can run on any core
+    std::atomic<uint32_t>                mNextWorker{0};
+    std::atomic<uint32_t>                mPendingJobCount{0};
+    std::mutex                           mSleepMutex;
+    std::condition_variable              mSleepCondition;
+    bool                                 mStop          = false;
+    ProfilerEventToken                   mJobEventToken = 0;
+};
+
+} // namespace ppx
+
+#endif // PPX_JOB_SYSTEM_H
@@ -44,6 +44,27 @@ namespace ppx {
 // Knob Classes
 // ---------------------------------------------------------------------------------------------
 
+// KnobValue is a knob value parsed ahead of time, see KnobSnapshot
+class KnobValue
+{
+public:
+    virtual ~KnobValue() = default;
+};
+
+template <typename T>
+class KnobValueT final
+    : public KnobValue
+{
+public:
+    explicit KnobValueT(T value)
+        : mValue(std::move(value)) {}
+
+    const T& Get() const { return mValue; }
+
+private:
+    T mValue;
+};
+
 // Knob is an abstract class which contains common features for all knobs and knob hierarchy
 class Knob
 {
@@ -77,6 +98,13 @@ private:
     // Updates knob value from commandline flag
     virtual void UpdateFromFlags(const CliOptions& opts) = 0;
 
+    // Parses the value of the commandline flag into a value ApplyValue() takes.
+    // Returns nullptr if the flag isn't in opts or its value is invalid.
+    virtual std::unique_ptr<KnobValue> ParseValue(const CliOptions& opts) const = 0;
+
+    // Sets a value returned by ParseValue() and returns true if it changed the knob
+    virtual bool ApplyValue(const KnobValue& value) = 0;
+
 protected:
     std::string mFlagName;
     std::string mDisplayName;
@@ -113,6 +141,9 @@ private:
     // --flag_name <true|false>
     void UpdateFromFlags(const CliOptions& opts) override;
 
+    std::unique_ptr<KnobValue> ParseValue(const CliOptions& opts) const override;
+    bool                       ApplyValue(const KnobValue& value) override;
+
     void SetDefaultAndValue(bool newValue);
 
 private:
@@ -191,7 +222,30 @@ private:
         SetDefaultAndValue(opts.GetOptionValueOrDefault(mFlagName, mValue));
     }
 
-    bool IsValidValue(T val)
+    std::unique_ptr<KnobValue> ParseValue(const CliOptions& opts) const override
+    {
+        if (!opts.HasExtraOption(mFlagName)) {
+            return nullptr;
+        }
+        T value = opts.GetOptionValueOrDefault(mFlagName, mValue);
+        if (!IsValidValue(value)) {
+            PPX_LOG_ERROR(mFlagName << " cannot be set to " << value << " because it's out of range " << mMinValue << "~" << mMaxValue);
+            return nullptr;
+        }
+        return std::make_unique<KnobValueT<T>>(value);
+    }
+
+    bool ApplyValue(const KnobValue& value) override
+    {
+        const T newValue = static_cast<const KnobValueT<T>&>(value).Get();
+        if (newValue == mValue) {
+            return false;
+        }
+        SetValue(newValue);
+        return true;
+    }
+
+    bool IsValidValue(T val) const
     {
         return mMinValue <= val && val <= mMaxValue;
     }
@@ -334,11 +388,48 @@ private:
         SetDefaultAndIndex(opts.GetOptionValueOrDefault(mFlagName, ValueString()));
     }
 
-    bool IsValidIndex(size_t index)
+    // The value is the index of the choice
+    std::unique_ptr<KnobValue> ParseValue(const CliOptions& opts) const override
+    {
+        if (!opts.HasExtraOption(mFlagName)) {
+            return nullptr;
+        }
+        std::string name  = opts.GetOptionValueOrDefault(mFlagName, mChoices[mIndex].name);
+        size_t      index = FindChoice(name);
+        if (!IsValidIndex(index)) {
+            PPX_LOG_ERROR(mFlagName << " does not have this value in allowed choices: " << name);
+            return nullptr;
+        }
+        return std::make_unique<KnobValueT<size_t>>(index);
+    }
+
+    bool ApplyValue(const KnobValue& value) override
+    {
+        const size_t newIndex = static_cast<const KnobValueT<size_t>&>(value).Get();
+        if (newIndex == mIndex) {
+            return false;
+        }
+        SetIndex(newIndex);
+        return true;
+    }
+
+    bool IsValidIndex(size_t index) const
     {
         return index < mChoices.size();
     }
 
+    // Returns mChoices.size() if no choice has this name
+    size_t FindChoice(const std::string& name) const
+    {
+        auto it = std::find_if(
+            mChoices.cbegin(),
+            mChoices.cend(),
+            [&name](const Entry& entry) {
+                return entry.name == name;
+            });
+        return std::distance(mChoices.cbegin(), it);
+    }
+
     void SetDefaultAndIndex(size_t newIndex)
     {
         PPX_ASSERT_MSG(IsValidIndex(newIndex), "invalid default index");
@@ -348,15 +439,10 @@ private:
 
     void SetDefaultAndIndex(std::string newValue)
     {
-        auto temp = std::find_if(
-            mChoices.cbegin(),
-            mChoices.cend(),
-            [&newValue](const Entry& entry) {
-                return entry.name == newValue;
-            });
-        PPX_ASSERT_MSG(temp != mChoices.cend(), "invalid default value");
+        size_t index = FindChoice(newValue);
+        PPX_ASSERT_MSG(IsValidIndex(index), "invalid default value");
 
-        mDefaultIndex = std::distance(mChoices.cbegin(), temp);
+        mDefaultIndex = index;
         ResetToDefault();
     }
 
@@ -421,7 +507,33 @@ private:
         SetValue(opts.GetOptionValueOrDefault(mFlagName, mValue));
     }
 
-    bool IsValidValue(T val)
+    std::unique_ptr<KnobValue> ParseValue(const CliOptions& opts) const override
+    {
+        if (!opts.HasExtraOption(mFlagName)) {
+            return nullptr;
+        }
+        T value = opts.GetOptionValueOrDefault(mFlagName, mValue);
+        if (!IsValidValue(value)) {
+            PPX_LOG_ERROR("invalid value for knob " << mFlagName);
+            return nullptr;
+        }
+        return std::make_unique<KnobValueT<T>>(std::move(value));
+    }
+
+    // Unlike SetValue(), raises the update flag: the application may need to
+    // react to flags changed after startup, e.g. between sweep points
+    bool ApplyValue(const KnobValue& value) override
+    {
+        const T& newValue = static_cast<const KnobValueT<T>&>(value).Get();
+        if (newValue == mValue) {
+            return false;
+        }
+        mValue = newValue;
+        RaiseUpdatedFlag();
+        return true;
+    }
+
+    bool IsValidValue(const T& val) const
     {
         if (!mValidatorFunc) {
             return true;
@@ -440,6 +552,32 @@ private:
     std::function<bool(T)> mValidatorFunc;
 };
 
+class KnobManager;
+
+// KnobSnapshot holds values for some of the knobs of a KnobManager, parsed
+// into the type of each knob by KnobManager::CreateSnapshot(). Applying a
+// snapshot doesn't parse anything, so sweeps can prepare one per sweep point
+// and switch between them quickly.
+class KnobSnapshot
+{
+public:
+    // Returns the number of knobs the snapshot sets
+    size_t GetKnobCount() const { return mEntries.size(); }
+    bool   IsEmpty() const { return mEntries.empty(); }
+
+private:
+    struct Entry
+    {
+        Knob*                      pKnob = nullptr; // Owned by mpManager, knobs are never removed
+        std::unique_ptr<KnobValue> value;
+    };
+
+    const KnobManager* mpManager = nullptr;
+    std::vector<Entry> mEntries;
+
+    friend class KnobManager;
+};
+
 // KnobManager holds the knobs in an application
 class KnobManager
 {
@@ -476,6 +614,15 @@ public:
     std::string GetUsageMsg();
     void        UpdateFromFlags(const CliOptions& opts);
 
+    // Parses the values opts has for the knobs into a snapshot. Knobs opts
+    // doesn't mention or has an invalid value for aren't in the snapshot.
+    KnobSnapshot CreateSnapshot(const CliOptions& opts) const;
+
+    // Sets the knobs in the snapshot to its values. Only the knobs whose
+    // value changed raise their update flag (see Knob::DigestUpdate()), their
+    // count is returned.
+    size_t ApplySnapshot(const KnobSnapshot& snapshot);
+
 private:
     void RegisterKnob(const std::string& flagName, std::shared_ptr<Knob> newKnob);
 };
@@ -0,0 +1,92 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_ktx2_h
+#define ppx_ktx2_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_format.h"
+
+#include <filesystem>
+
+namespace ppx {
+
+//! @class Ktx2
+//!
+//! KTX2 texture container, see https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+//!
+//! Only 2D textures with a single layer and face load. The level data is
+//! kept as is, so textures must be stored in a format grfx has without
+//! supercompression. Basis Universal (BasisLZ/ETC1S and UASTC) and Zstd or
+//! zlib supercompressed textures need a transcoder, IsTranscodingRequired()
+//! tells them apart and loading them returns ERROR_IMAGE_INVALID_FORMAT.
+//!
+class Ktx2
+{
+public:
+    enum Supercompression
+    {
+        SUPERCOMPRESSION_NONE     = 0,
+        SUPERCOMPRESSION_BASIS_LZ = 1,
+        SUPERCOMPRESSION_ZSTD     = 2,
+        SUPERCOMPRESSION_ZLIB     = 3,
+    };
+
+    struct Level
+    {
+        uint32_t width  = 0;
+        uint32_t height = 0;
+        size_t   offset = 0;
+        size_t   size   = 0;
+    };
+
+    Ktx2() {}
+    ~Ktx2() {}
+
+    //! Checks the file extension.
+    static bool IsKtx2File(const std::filesystem::path& path);
+    //! Checks the file identifier.
+    static bool IsKtx2Data(size_t dataSize, const void* pData);
+
+    //! Reads only the header and returns whether the texture needs
+    //! transcoding to load, false if it isn't a valid KTX2 texture.
+    static bool IsTranscodingRequired(size_t dataSize, const void* pData);
+
+    //! Reads only the header and returns the format the texture loads as,
+    //! FORMAT_UNDEFINED if it can't be loaded as is.
+    static grfx::Format ReadFormat(size_t dataSize, const void* pData);
+    static grfx::Format ReadFormat(const std::filesystem::path& path);
+
+    static Result LoadFile(const std::filesystem::path& path, Ktx2* pKtx2);
+    //! Copies the level data out of pData.
+    static Result LoadFromMemory(size_t dataSize, const void* pData, Ktx2* pKtx2);
+
+    grfx::Format GetFormat() const { return mFormat; }
+    uint32_t     GetWidth() const { return mWidth; }
+    uint32_t     GetHeight() const { return mHeight; }
+    uint32_t     GetLevelCount() const { return CountU32(mLevels); }
+    const Level& GetLevel(uint32_t level) const { return mLevels[level]; }
+    const char*  GetLevelData(uint32_t level) const { return mData.data() + mLevels[level].offset; }
+
+private:
+    grfx::Format       mFormat = grfx::FORMAT_UNDEFINED;
+    uint32_t           mWidth  = 0;
+    uint32_t           mHeight = 0;
+    std::vector<Level> mLevels;
+    std::vector<char>  mData;
+};
+
+} // namespace ppx
+
+#endif // ppx_ktx2_h
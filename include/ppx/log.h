@@ -17,12 +17,15 @@
 
 #include "math_config.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <mutex>
 #include <sstream>
+#include <thread>
 
 #define PPX_LOG_DEFAULT_PATH "ppx.log"
 
@@ -39,6 +42,7 @@ enum LogMode
     LOG_MODE_OFF     = 0x0,
     LOG_MODE_CONSOLE = 0x1,
     LOG_MODE_FILE    = 0x2,
+    LOG_MODE_ASYNC   = 0x4, // Write messages on a background thread, see Log::SetAsync()
 };
 
 enum LogLevel
@@ -59,6 +63,13 @@ enum LogLevel
 
 //! @class Log
 //!
+//! The PPX_LOG macros format each message into a per thread stream and pass
+//! it to Submit(). By default Submit() writes and flushes the console and
+//! file streams on the calling thread under a lock. With LOG_MODE_ASYNC it
+//! pushes the message onto a lock-free queue instead, and a background
+//! thread writes and flushes everything queued every few milliseconds, so
+//! logging costs the caller the formatting and an allocation. Fatal
+//! messages and Shutdown() wait until the queue has been written.
 //!
 class Log
 {
@@ -69,12 +80,24 @@ public:
     static bool Initialize(uint32_t modes, const char* filePath = nullptr, std::ostream* consoleStream = &std::cout);
     static void Shutdown();
 
+    //! Starts or stops the background thread of LOG_MODE_ASYNC, for
+    //! applications that choose after the log has been initialized
+    static void SetAsync(bool enable);
+
     static Log*        Get();
     static std::mutex& GetLock();
 
     static bool IsActive();
     static bool IsModeActive(LogMode mode);
 
+    //! Empty stream for the calling thread to format a message into
+    static std::ostringstream& GetThreadStream();
+
+    //! Writes the contents of stream as one message and clears it
+    void Submit(std::ostringstream& stream, LogLevel level);
+
+    //! Writes the contents of the buffer written with operator<<, which
+    //! must be guarded by GetLock(). Queued in async mode.
     void Flush(LogLevel level);
 
     template <typename T>
@@ -95,6 +118,23 @@ private:
     void DestroyObjects();
 
     void Write(const char* msg, LogLevel level);
+    void FlushStreams();
+
+    // LOG_MODE_ASYNC
+    struct QueuedMessage
+    {
+        std::atomic<QueuedMessage*> next{nullptr};
+        std::string                 text     = "";
+        LogLevel                    level    = LOG_LEVEL_DEFAULT;
+        std::atomic<bool>*          pWritten = nullptr; // Set once written if not null
+    };
+
+    void Enqueue(std::string&& text, LogLevel level, bool wait);
+    bool Dequeue(QueuedMessage** ppMessage);
+    void WriteQueuedMessages();
+    void StartFlushThread();
+    void StopFlushThread();
+    void FlushThreadMain();
 
 private:
     uint32_t          mModes = LOG_MODE_OFF;
@@ -103,62 +143,44 @@ private:
     std::ostream*     mConsoleStream = nullptr;
     std::stringstream mBuffer;
     std::mutex        mWriteMutex;
+
+    // Multiple producer single consumer queue of messages, producers
+    // exchange the head and the flush thread pops at the tail, which always
+    // points to an already written message or the stub
+    std::atomic<QueuedMessage*> mQueueHead;
+    QueuedMessage*              mQueueTail = nullptr;
+    QueuedMessage               mQueueStub;
+    std::thread                 mFlushThread;
+    std::mutex                  mFlushMutex;
+    std::condition_variable     mFlushCondition;   // Wakes up the flush thread
+    std::condition_variable     mWrittenCondition; // Signals waiting producers
+    bool                        mFlushRequested  = false;
+    bool                        mStopFlushThread = false;
 };
 
 } // namespace ppx
 
 // clang-format off
-#define PPX_LOG_RAW(MSG)                                \
-    if (ppx::Log::IsActive()) {                         \
-        std::lock_guard lock(ppx::Log::GetLock());      \
-        (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL;      \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_DEFAULT); \
-    }
-
-#define PPX_LOG_INFO(MSG)                            \
-    if (ppx::Log::IsActive()) {                      \
-        std::lock_guard lock(ppx::Log::GetLock());   \
-        (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL;   \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_INFO); \
-    }
-
-#define PPX_LOG_WARN(MSG)                            \
-    if (ppx::Log::IsActive()) {                      \
-        std::lock_guard lock(ppx::Log::GetLock());   \
-        (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL;   \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_WARN); \
-    }
-
-#define PPX_LOG_WARN_ONCE(MSG)                         \
-    if (ppx::Log::IsActive()) {                        \
-        std::lock_guard lock(ppx::Log::GetLock());     \
-        static bool ppxLogWarnOnce = false;            \
-        if(!ppxLogWarnOnce) {                          \
-            (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL; \
-        }                                              \
-        ppxLogWarnOnce = true;                         \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_WARN);   \
-    }
-
-#define PPX_LOG_DEBUG(MSG)                            \
-    if (ppx::Log::IsActive()) {                       \
-        std::lock_guard lock(ppx::Log::GetLock());    \
-        (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL;    \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_DEBUG); \
-    }
-
-#define PPX_LOG_ERROR(MSG)                            \
-    if (ppx::Log::IsActive()) {                       \
-        std::lock_guard lock(ppx::Log::GetLock());    \
-        (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL;    \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_ERROR); \
+#define PPX_LOG_MESSAGE(LEVEL, MSG)                                      \
+    if (ppx::Log::IsActive()) {                                          \
+        std::ostringstream& ppxLogStream = ppx::Log::GetThreadStream(); \
+        ppxLogStream << MSG << PPX_LOG_ENDL;                             \
+        ppx::Log::Get()->Submit(ppxLogStream, LEVEL);                    \
     }
 
-#define PPX_LOG_FATAL(MSG)                            \
-    if (ppx::Log::IsActive()) {                       \
-        std::lock_guard lock(ppx::Log::GetLock());    \
-        (*ppx::Log::Get()) << MSG << PPX_LOG_ENDL;    \
-        ppx::Log::Get()->Flush(ppx::LOG_LEVEL_FATAL); \
+#define PPX_LOG_RAW(MSG)   PPX_LOG_MESSAGE(ppx::LOG_LEVEL_DEFAULT, MSG)
+#define PPX_LOG_INFO(MSG)  PPX_LOG_MESSAGE(ppx::LOG_LEVEL_INFO, MSG)
+#define PPX_LOG_WARN(MSG)  PPX_LOG_MESSAGE(ppx::LOG_LEVEL_WARN, MSG)
+#define PPX_LOG_DEBUG(MSG) PPX_LOG_MESSAGE(ppx::LOG_LEVEL_DEBUG, MSG)
+#define PPX_LOG_ERROR(MSG) PPX_LOG_MESSAGE(ppx::LOG_LEVEL_ERROR, MSG)
+#define PPX_LOG_FATAL(MSG) PPX_LOG_MESSAGE(ppx::LOG_LEVEL_FATAL, MSG)
+
+#define PPX_LOG_WARN_ONCE(MSG)                                  \
+    {                                                           \
+        static std::atomic<bool> ppxLogWarnOnce{false};         \
+        if (!ppxLogWarnOnce.exchange(true)) {                   \
+            PPX_LOG_MESSAGE(ppx::LOG_LEVEL_WARN, MSG)           \
+        }                                                       \
     }
 // clang-format on
 
@@ -0,0 +1,213 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_mesh_optimizer_h
+#define ppx_mesh_optimizer_h
+
+#include "ppx/config.h"
+#include "ppx/math_config.h"
+
+// Size of the FIFO post transform cache the optimizations model
+#define PPX_MESH_OPTIMIZER_CACHE_SIZE 16
+
+// Most levels of detail GenerateMeshLods() makes, including the full detail one
+#define PPX_MESH_MAX_LOD_COUNT 8
+
+namespace ppx {
+
+//! @struct MeshOptimizeOptions
+//!
+//! Reordering steps applied to triangle lists on import, in this order:
+//!   - vertexCache: reorders triangles for post transform cache reuse
+//!                  (Tipsify, Sander et al. 2007)
+//!   - overdraw:    reorders clusters of the cache optimized triangles so
+//!                  outward facing ones are drawn first. The clusters are
+//!                  allowed to raise the vertex cache ACMR by up to
+//!                  overdrawThreshold times. Implies vertexCache.
+//!   - vertexFetch: reorders vertices in the order the triangles first
+//!                  reference them
+//!
+//! None of the steps adds or removes triangles or vertices.
+//!
+struct MeshOptimizeOptions
+{
+    bool  vertexCache       = false;
+    bool  overdraw          = false;
+    bool  vertexFetch       = false;
+    float overdrawThreshold = 1.05f;
+
+    bool IsEnabled() const { return vertexCache || overdraw || vertexFetch; }
+};
+
+//! @struct MeshLodOptions
+//!
+//! Coarser levels of detail generated on import by edge collapse
+//! simplification with quadric error metrics (Garland and Heckbert 1997).
+//! LOD i targets reduction^i of the triangles and is simplified from
+//! LOD i - 1. Generation stops at the first LOD that can't reach its target
+//! within maxError, a fraction of the bounding box diagonal.
+//!
+//! Vertices on open borders and on attribute seams (vertices that share a
+//! position) don't move, so meshes with many seams reduce less.
+//!
+struct MeshLodOptions
+{
+    uint32_t lodCount  = 1; // Including the full detail LOD, 1 generates nothing
+    float    reduction = 0.5f;
+    float    maxError  = 0.02f;
+
+    bool IsEnabled() const { return lodCount > 1; }
+};
+
+//! @struct MeshLod
+//!
+//! Range of a level of detail in a mesh's indices, all LODs share the
+//! vertices. error is how far the LOD's surface may be from the full
+//! detail one, in the units of the positions.
+//!
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float    error      = 0;
+};
+
+//! @struct VertexCacheStats
+//!
+//! acmr: average cache misses (vertex shader invocations) per triangle,
+//!       between 0.5 and 3, lower is better.
+//! atvr: average cache misses per vertex, 1 is optimal.
+//!
+struct VertexCacheStats
+{
+    uint32_t vertexShaderInvocations = 0;
+    float    acmr                    = 0;
+    float    atvr                    = 0;
+};
+
+//! Simulates a FIFO post transform cache of cacheSize entries.
+VertexCacheStats AnalyzeVertexCache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = PPX_MESH_OPTIMIZER_CACHE_SIZE);
+
+//! Reorders the triangles in pIndices in place.
+void OptimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+
+//! Reorders the triangles in pIndices in place, which should already be
+//! vertex cache optimized. Positions are read positionStride bytes apart.
+void OptimizeOverdraw(
+    uint32_t*    pIndices,
+    uint32_t     indexCount,
+    const float* pPositions,
+    uint32_t     positionStride,
+    uint32_t     vertexCount,
+    float        threshold);
+
+//! Builds pRemap so that (*pRemap)[oldIndex] is the new index of each
+//! vertex and rewrites pIndices to use the new indices. Vertices are
+//! numbered in the order the indices first reference them, unreferenced
+//! vertices go at the end. Returns the number of referenced vertices.
+uint32_t OptimizeVertexFetchRemap(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* pRemap);
+
+//! Moves vertex elements of elementSize bytes to their remapped positions.
+void RemapVertexData(void* pVertexData, uint32_t elementSize, uint32_t vertexCount, const std::vector<uint32_t>& remap);
+
+//! Runs the steps enabled in options. pRemap is filled in if vertexFetch
+//! is enabled and cleared otherwise, see OptimizeVertexFetchRemap().
+void OptimizeMesh(
+    const MeshOptimizeOptions& options,
+    uint32_t*                  pIndices,
+    uint32_t                   indexCount,
+    const float*               pPositions,
+    uint32_t                   positionStride,
+    uint32_t                   vertexCount,
+    std::vector<uint32_t>*     pRemap);
+
+//! Rewrites the triangle list in pIndices as triangle strips separated by
+//! restartIndex, for drawing with primitive restart. Strips are grown
+//! greedily in the order of the triangles, so vertex cache optimized lists
+//! give long strips, and keep the winding of every triangle. restartIndex
+//! must not be a vertex index. Returns the number of indices in pStrips,
+//! which can be more than indexCount for meshes with few shared edges.
+uint32_t GenerateTriangleStrips(
+    const uint32_t*        pIndices,
+    uint32_t               indexCount,
+    uint32_t               vertexCount,
+    uint32_t               restartIndex,
+    std::vector<uint32_t>* pStrips);
+
+//! Collapses edges of the triangles in pIndices until at most
+//! targetIndexCount indices are left or until the next collapse would move
+//! the surface more than maxError, in the units of the positions. Writes
+//! the remaining triangles to pResult, which only reference vertices of the
+//! input. Returns the error of the result.
+float SimplifyMesh(
+    const uint32_t*        pIndices,
+    uint32_t               indexCount,
+    const float*           pPositions,
+    uint32_t               positionStride,
+    uint32_t               vertexCount,
+    uint32_t               targetIndexCount,
+    float                  maxError,
+    std::vector<uint32_t>* pResult);
+
+//! Returns the most indices GenerateMeshLods() can make from indexCount
+//! indices: the full detail ones and the target of each LOD.
+uint32_t GetMeshLodIndexCapacity(const MeshLodOptions& options, uint32_t indexCount);
+
+//! Appends the coarser LODs of the triangles in pIndices to pIndices and
+//! fills pLods with the range of each LOD, the full detail one first. The
+//! LODs are vertex cache optimized.
+void GenerateMeshLods(
+    const MeshLodOptions&  options,
+    std::vector<uint32_t>* pIndices,
+    const float*           pPositions,
+    uint32_t               positionStride,
+    uint32_t               vertexCount,
+    std::vector<MeshLod>*  pLods);
+
+//! Writes a smooth normal for every vertex to pNormals, normalStride bytes
+//! apart: the normals of the triangles that use the vertex weighted by
+//! their angle at it. Vertices without a non-degenerate triangle get a zero
+//! normal. Large meshes are processed on several threads.
+void GenerateMeshNormals(
+    const uint32_t* pIndices,
+    uint32_t        indexCount,
+    const float*    pPositions,
+    uint32_t        positionStride,
+    uint32_t        vertexCount,
+    float*          pNormals,
+    uint32_t        normalStride);
+
+//! Writes a tangent for every vertex to pTangents, tangentStride bytes
+//! apart, with the bitangent sign in w: bitangent = w * cross(normal,
+//! tangent). Follows MikkTSpace: each triangle's tangent along increasing u
+//! is projected onto the vertex's tangent plane and weighted by the angle at
+//! the vertex, and w is the sign of the triangles' UV winding. MikkTSpace
+//! splits vertices shared by mirrored triangles, here the winding of most of
+//! the angle wins. Large meshes are processed on several threads.
+void GenerateMeshTangents(
+    const uint32_t* pIndices,
+    uint32_t        indexCount,
+    const float*    pPositions,
+    uint32_t        positionStride,
+    const float*    pNormals,
+    uint32_t        normalStride,
+    const float*    pTexCoords,
+    uint32_t        texCoordStride,
+    uint32_t        vertexCount,
+    float*          pTangents,
+    uint32_t        tangentStride);
+
+} // namespace ppx
+
+#endif // ppx_mesh_optimizer_h
@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_meshlet_h
+#define ppx_meshlet_h
+
+#include "ppx/config.h"
+#include "ppx/tri_mesh.h"
+
+// Meshlet triangles store 8 bit local vertex indices
+#define PPX_MESHLET_MAX_VERTICES  256
+#define PPX_MESHLET_MAX_TRIANGLES 256
+
+namespace ppx {
+
+//! @struct Meshlet
+//!
+//! size = 16, laid out so mesh shaders can read it from a structured buffer.
+//!
+struct Meshlet
+{
+    uint32_t vertexOffset   = 0; // First element in MeshletMesh::GetVertexIndices()
+    uint32_t vertexCount    = 0;
+    uint32_t triangleOffset = 0; // First element in MeshletMesh::GetTriangles()
+    uint32_t triangleCount  = 0;
+};
+
+//! @class MeshletMesh
+//!
+//! Splits the triangles of a TriMesh into meshlets of at most maxVertices
+//! unique vertices and maxTriangles triangles, in the order the triangles
+//! appear in the mesh. Vertex locality therefore depends on the index
+//! order of the source mesh.
+//!
+//! Each meshlet references its vertices through GetVertexIndices(), which
+//! holds indices into the TriMesh vertex data. Triangles are packed into
+//! one uint32_t each: local vertex indices in bits 0-7, 8-15 and 16-23.
+//!
+//! The defaults match the commonly recommended sizes for mesh shaders
+//! (64 vertices, 124 triangles).
+//!
+class MeshletMesh
+{
+public:
+    MeshletMesh() {}
+    ~MeshletMesh() {}
+
+    uint32_t GetMaxVertices() const { return mMaxVertices; }
+    uint32_t GetMaxTriangles() const { return mMaxTriangles; }
+
+    uint32_t GetCountMeshlets() const { return CountU32(mMeshlets); }
+    uint32_t GetCountVertexIndices() const { return CountU32(mVertexIndices); }
+    uint32_t GetCountTriangles() const { return CountU32(mTriangles); }
+
+    const std::vector<Meshlet>&  GetMeshlets() const { return mMeshlets; }
+    const std::vector<uint32_t>& GetVertexIndices() const { return mVertexIndices; }
+    const std::vector<uint32_t>& GetTriangles() const { return mTriangles; }
+
+    static Result Create(const TriMesh& mesh, MeshletMesh* pMeshletMesh);
+    static Result Create(const TriMesh& mesh, uint32_t maxVertices, uint32_t maxTriangles, MeshletMesh* pMeshletMesh);
+
+private:
+    uint32_t              mMaxVertices  = 0;
+    uint32_t              mMaxTriangles = 0;
+    std::vector<Meshlet>  mMeshlets;
+    std::vector<uint32_t> mVertexIndices;
+    std::vector<uint32_t> mTriangles;
+};
+
+} // namespace ppx
+
+#endif // ppx_meshlet_h
@@ -0,0 +1,58 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_meshopt_decoder_h
+#define ppx_meshopt_decoder_h
+
+#include "ppx/config.h"
+
+//
+// Decoders for the meshoptimizer bitstreams used by the glTF
+// EXT_meshopt_compression extension, see:
+//   https://github.com/KhronosGroup/glTF/tree/main/extensions/2.0/Vendor/EXT_meshopt_compression
+//
+// All decoders validate the stream against the output size and return
+// ppx::ERROR_BAD_DATA_SOURCE if it's malformed. Outputs are fully written
+// only on success.
+//
+
+namespace ppx {
+
+enum MeshoptFilter
+{
+    MESHOPT_FILTER_NONE        = 0,
+    MESHOPT_FILTER_OCTAHEDRAL  = 1,
+    MESHOPT_FILTER_QUATERNION  = 2,
+    MESHOPT_FILTER_EXPONENTIAL = 3,
+};
+
+//! Decodes count elements of stride bytes (ATTRIBUTES mode). stride must
+//! be a multiple of 4 and at most 256.
+ppx::Result DecodeMeshoptVertexBuffer(void* pDst, size_t count, size_t stride, const void* pSrc, size_t srcSize);
+
+//! Decodes count indices of indexSize (2 or 4) bytes encoded as triangles
+//! (TRIANGLES mode). count must be a multiple of 3.
+ppx::Result DecodeMeshoptIndexBuffer(void* pDst, size_t count, size_t indexSize, const void* pSrc, size_t srcSize);
+
+//! Decodes count indices of indexSize (2 or 4) bytes encoded as a sequence
+//! (INDICES mode).
+ppx::Result DecodeMeshoptIndexSequence(void* pDst, size_t count, size_t indexSize, const void* pSrc, size_t srcSize);
+
+//! Applies filter in place to count decoded elements of stride bytes.
+//! Returns ppx::ERROR_BAD_DATA_SOURCE if stride isn't valid for filter.
+ppx::Result ApplyMeshoptFilter(MeshoptFilter filter, void* pData, size_t count, size_t stride);
+
+} // namespace ppx
+
+#endif // ppx_meshopt_decoder_h
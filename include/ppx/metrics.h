@@ -17,11 +17,15 @@
 
 #include "nlohmann/json.hpp"
 #include "ppx/config.h"
+#include "ppx/random.h"
 
+#include <atomic>
 #include <filesystem>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -52,6 +56,14 @@ enum class MetricInterpretation
     LOWER_IS_BETTER,
 };
 
+// How a gauge keeps its entries.
+enum class GaugeMode
+{
+    DEFAULT,     // Manager::SetDefaultGaugeMode()
+    TIME_SERIES, // Every entry, exact statistics. Memory grows with the entry count.
+    SKETCH,      // Quantile sketch plus a fixed size reservoir of entries. Bounded memory.
+};
+
 struct Range
 {
     double lowerBound = std::numeric_limits<double>::min();
@@ -66,6 +78,11 @@ struct MetricMetadata
     MetricInterpretation interpretation = MetricInterpretation::NONE;
     Range                expectedRange;
 
+    // Gauges only
+    GaugeMode gaugeMode              = GaugeMode::DEFAULT;
+    double    sketchRelativeAccuracy = 0.01; // Relative error of GaugeMode::SKETCH quantiles
+    uint32_t  reservoirSize          = 1024; // Entries GaugeMode::SKETCH keeps for the time series
+
     nlohmann::json Export() const;
 };
 
@@ -90,6 +107,19 @@ struct MetricData
     };
 };
 
+// Time series of a gauge, kept out of the JSON content of binary reports.
+struct ReportTimeSeries
+{
+    std::vector<double> seconds;
+    std::vector<double> values;
+};
+
+enum class ReportFormat
+{
+    JSON,   // A single JSON document
+    BINARY, // See Report::WriteBinary()
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 // Interface for all metric types.
@@ -134,6 +164,48 @@ struct GaugeComplexStatistics
     double percentile99      = 0.0;
 };
 
+// DDSketch: values are counted in buckets whose bounds grow geometrically,
+// so quantiles have a relative error of at most relativeAccuracy. Adding a
+// value is O(1) and memory is bounded by maxBucketCount per sign; once a
+// sign needs more buckets, its smallest magnitudes are merged.
+class QuantileSketch
+{
+public:
+    QuantileSketch(double relativeAccuracy = 0.01, uint32_t maxBucketCount = 2048);
+
+    // Non-finite values are ignored
+    void Add(double value);
+
+    // q in [0, 1], the value at rank q * count like a sorted array would
+    double GetQuantile(double q) const;
+
+    uint64_t GetCount() const { return mCount; }
+    uint32_t GetBucketCount() const { return static_cast<uint32_t>(mPositive.counts.size() + mNegative.counts.size()); }
+    double   GetRelativeAccuracy() const { return mRelativeAccuracy; }
+
+private:
+    struct Store
+    {
+        int64_t               offset = 0; // Index of counts[0]
+        std::vector<uint64_t> counts;
+
+        void Add(int64_t index, uint32_t maxBucketCount);
+    };
+
+    int64_t GetIndex(double magnitude) const;
+    double  GetValue(int64_t index) const;
+
+private:
+    double   mRelativeAccuracy = 0.0;
+    uint32_t mMaxBucketCount   = 0;
+    double   mGamma            = 0.0;
+    double   mLogGamma         = 0.0;
+    Store    mPositive;
+    Store    mNegative; // Indexed by magnitude
+    uint64_t mZeroCount = 0;
+    uint64_t mCount     = 0;
+};
+
 class MetricGauge final : public Metric
 {
     friend class Run;
@@ -152,6 +224,9 @@ public:
 
     // Exports this metric in JSON format.
     nlohmann::json Export() const override;
+    // Same, but the time series is appended to pTimeSeries and the JSON only
+    // holds its index, as "time_series_index".
+    nlohmann::json Export(std::vector<ReportTimeSeries>* pTimeSeries) const;
 
     MetricType GetType() const override
     {
@@ -160,6 +235,8 @@ public:
 
     const GaugeBasicStatistics GetBasicStatistics() const { return mBasicStats; };
 
+    GaugeMode GetMode() const { return mMetadata.gaugeMode; }
+
 private:
     struct TimeSeriesEntry
     {
@@ -168,20 +245,34 @@ private:
     };
 
 private:
+    // metadata.gaugeMode must not be GaugeMode::DEFAULT
     MetricGauge(const MetricMetadata& metadata)
-        : mMetadata(metadata)
+        : mMetadata(metadata), mSketch(metadata.sketchRelativeAccuracy)
     {
         PPX_ASSERT_MSG(mMetadata.type == MetricType::GAUGE, "Gauge must be instantiated with gauge-type metadata!");
+        PPX_ASSERT_MSG(mMetadata.gaugeMode != GaugeMode::DEFAULT, "Gauge mode must be resolved before instantiation!");
     }
     METRICS_NO_COPY(MetricGauge)
 
     GaugeComplexStatistics ComputeComplexStats() const;
 
+    // Algorithm R, every entry has the same chance to be kept
+    void AddToReservoir(const TimeSeriesEntry& entry);
+
 private:
     MetricMetadata               mMetadata;
-    std::vector<TimeSeriesEntry> mTimeSeries;
+    std::vector<TimeSeriesEntry> mTimeSeries; // Every entry, or the reservoir for GaugeMode::SKETCH
     GaugeBasicStatistics         mBasicStats;
     double                       mAccumulatedValue = 0.0;
+    size_t                       mEntryCount       = 0;
+    double                       mFirstSeconds     = 0.0;
+    double                       mLastSeconds      = 0.0;
+
+    // GaugeMode::SKETCH
+    QuantileSketch mSketch;
+    double         mMean = 0.0; // Welford's running variance
+    double         mM2   = 0.0;
+    ppx::Random    mRandom;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -221,6 +312,152 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Lock-free single producer, single consumer ring of metric entries. The
+// Manager creates one per recording thread: the thread pushes, the Manager
+// pops when draining.
+class MetricQueue final
+{
+public:
+    // The capacity is rounded up to a power of two.
+    MetricQueue(uint32_t capacity);
+
+    // Producer only. Returns false and drops the entry when full.
+    bool Push(MetricID id, const MetricData& data);
+    // Consumer only. Returns false when empty.
+    bool Pop(MetricID* pID, MetricData* pData);
+
+    uint32_t GetCapacity() const { return mMask + 1; }
+
+    // Consumer only. Entries Push() dropped since the last call.
+    uint64_t TakeDroppedCount();
+
+private:
+    METRICS_NO_COPY(MetricQueue)
+
+    struct Entry
+    {
+        MetricID   id;
+        MetricData data;
+    };
+
+private:
+    std::vector<Entry> mEntries;
+    uint32_t           mMask = 0;
+
+    // Each index is written by one side only; kept on separate cache lines so
+    // the producer and consumer don't invalidate each other's.
+    alignas(64) std::atomic<uint64_t> mHead         = 0; // Next entry to pop
+    alignas(64) std::atomic<uint64_t> mTail         = 0; // Next entry to push
+    alignas(64) std::atomic<uint64_t> mDroppedCount = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// What one frame changed in a FrameStutterTracker.
+struct FrameStutterResult
+{
+    bool     overBudget        = false;
+    uint32_t histogramBucket   = 0;
+    uint32_t endedStreakLength = 0;     // Over budget frames in the streak this frame ended, 0 if none
+    bool     windowComplete    = false; // This frame completed a window
+    double   windowVariance    = 0;     // Frame time variance of that window, in ms^2
+};
+
+// Incremental hitch statistics over a sequence of frame times:
+//   - frames over a frame time budget, and streaks of consecutive ones
+//   - the frame time variance of each window of windowFrameCount frames
+//   - a histogram with half octave buckets: [0, 1) ms, then bounds of
+//     2^(i/2) ms up to 256 ms, then [256, inf) ms
+// Every frame is O(1), nothing is kept per frame.
+class FrameStutterTracker final
+{
+public:
+    static constexpr uint32_t kHistogramBucketCount = 18;
+
+    FrameStutterTracker(double budgetMs = 1000.0 / 60.0, uint32_t windowFrameCount = 60);
+
+    FrameStutterResult AddFrame(double frameTimeMs);
+
+    // Ends the current streak, e.g. at the end of a run. Returns its length.
+    uint32_t EndStreak();
+
+    double   GetBudgetMs() const { return mBudgetMs; }
+    uint64_t GetFrameCount() const { return mFrameCount; }
+    uint64_t GetOverBudgetCount() const { return mOverBudgetCount; }
+    uint32_t GetLongestStreak() const { return mLongestStreak; }
+    uint64_t GetHistogramCount(uint32_t bucket) const { return mHistogram[bucket]; }
+
+    static uint32_t GetHistogramBucket(double frameTimeMs);
+    // Bounds of a bucket in ms, the upper bound of the last one is infinite
+    static double GetHistogramLowerBound(uint32_t bucket);
+    static double GetHistogramUpperBound(uint32_t bucket);
+
+private:
+    double   mBudgetMs         = 0;
+    uint32_t mWindowFrameCount = 0;
+    uint64_t mFrameCount       = 0;
+    uint64_t mOverBudgetCount  = 0;
+    uint32_t mStreak           = 0;
+    uint32_t mLongestStreak    = 0;
+
+    uint64_t mHistogram[kHistogramBucketCount] = {};
+
+    // Welford's running mean and sum of squared differences of the window
+    uint32_t mWindowCount = 0;
+    double   mWindowMean  = 0;
+    double   mWindowM2    = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// How the repetitions of a benchmark are summarized, see
+// Manager::AddBenchmarkRepetition().
+struct BenchmarkSettings
+{
+    uint32_t warmupFrames       = 0; // Frames run before the first repetition, only reported
+    uint32_t repetitionFrames   = 0; // Frames of each repetition, only reported
+    uint32_t bootstrapResamples = 1000;
+    double   confidenceLevel    = 0.95;
+    double   outlierThreshold   = 3.5; // Modified z-score over which a repetition is rejected
+};
+
+// Summary of one value per repetition, e.g. the median frame time of each.
+struct BenchmarkSummary
+{
+    std::vector<double>   values;
+    std::vector<uint32_t> outliers;    // Indices of the values rejected as outliers
+    double                mean    = 0; // Of the values kept
+    double                ciLower = 0; // Bootstrap percentile confidence interval of the mean
+    double                ciUpper = 0;
+};
+
+// Rejects the values whose modified z-score, 0.6745 * |x - median| / MAD,
+// is over settings.outlierThreshold, then bootstraps the mean of the rest.
+// Outliers need at least 3 values. The resampling is seeded, so the same
+// values always give the same interval.
+BenchmarkSummary SummarizeRepetitions(const std::vector<double>& values, const BenchmarkSettings& settings);
+
+// One configuration of a parameter sweep: knob flag names and values, as in
+// a --config-json-path file.
+struct SweepPoint
+{
+    std::string    name; // Unique, e.g. "sphere-count=100 vs=1"
+    nlohmann::json knobs;
+};
+
+// Expands a sweep description into its points:
+//   {
+//     "points":    [{"vs": 0}, {"vs": 1, "ps": 2}],        (optional)
+//     "cartesian": {"sphere-count": [10, 100], "LOD": [0, 1]} (optional)
+//   }
+// Every point is combined with every combination of the "cartesian" values,
+// the last knob name varying fastest. Other members are ignored.
+Result ExpandSweep(const nlohmann::json& sweep, std::vector<SweepPoint>* pPoints);
+
+////////////////////////////////////////////////////////////////////////////////
+
+class StreamServer;
+
 // A run gathers metrics relevant to the execution of a benchmark.
 // It is expected that a new run is created each time parameters that affect the
 // metrics measurements are changed.
@@ -233,8 +470,9 @@ public:
     // It is the responsibility of the caller to guard against use-after-free accordingly.
     Metric* AddMetric(const MetricMetadata& metadata);
 
-    // Exports the run in JSON format.
-    nlohmann::json Export() const;
+    // Exports the run in JSON format. Gauge time series are appended to
+    // pTimeSeries instead if not null, see MetricGauge::Export().
+    nlohmann::json Export(std::vector<ReportTimeSeries>* pTimeSeries = nullptr) const;
 
 private:
     Run(const std::string& name)
@@ -243,6 +481,9 @@ private:
 
     bool HasMetric(const std::string& name) const;
 
+    // Metadata and median of each gauge with entries, in the order added.
+    std::vector<std::pair<MetricMetadata, double>> GetGaugeMedians() const;
+
 private:
     std::string                          mName;
     std::unordered_set<std::string>      mMetricNames;
@@ -251,6 +492,25 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// The device a report was measured on. Benchmark results are only comparable
+// between reports with the same fingerprint.
+struct DeviceFingerprint
+{
+    std::string gpu;
+    std::string driver;
+    std::string api;
+    uint32_t    width  = 0; // Resolution of the window
+    uint32_t    height = 0;
+
+    bool IsEmpty() const { return gpu.empty(); }
+
+    // Unique per fingerprint, e.g. "Mali-G78 / 1.3.0 / Vulkan / 1920x1080"
+    std::string    GetKey() const;
+    nlohmann::json Export() const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 // A report contains runs and metrics information meant to be saved to disk.
 class Report final
 {
@@ -259,16 +519,44 @@ public:
     Report(const nlohmann::json& content, const std::string& reportPath);
     // Move constructor for content.
     Report(nlohmann::json&& content, const std::string& reportPath);
+    // Binary report, content refers to timeSeries by index.
+    Report(nlohmann::json&& content, std::vector<ReportTimeSeries>&& timeSeries, const std::string& reportPath);
 
     void WriteToDisk(bool overwriteExisting = false) const;
 
-    std::string GetContentString() const;
+    // Binary layout, little endian, read by tools/metrics_report.py:
+    //   char[4]  "PPXM"
+    //   uint32   version, 1
+    //   uint32   JSON content size, then the compact JSON content
+    //   uint32   time series count, then for each time series:
+    //     uint64   entry count
+    //     uint64   size of the encoded seconds, then the encoded seconds:
+    //              zigzag LEB128 varints, each the difference in microseconds
+    //              from the previous entry (from 0 for the first one)
+    //     float32  values, one per entry
+    void WriteBinary(std::ostream& os) const;
+
+    // Appends GetResultsStoreEntry() as a line to the results store at
+    // storePath, a JSON Lines file shared by every run on the device. Relative
+    // paths are in the default output directory. Only reports with a
+    // "benchmark" or "sweep" summary are stored, see
+    // Manager::AddBenchmarkRepetition(). Read by tools/metrics_report.py.
+    void AppendToResultsStore(const std::string& storePath) const;
+
+    // The compact JSON line stored for this report: "device", "device_key",
+    // "generated_at" and the "benchmark" or "sweep" summaries, without runs.
+    std::string GetResultsStoreEntry() const;
+
+    std::string  GetContentString() const;
+    ReportFormat GetFormat() const { return mFormat; }
 
 private:
     void SetReportPath(const std::string& reportPath);
 
-    nlohmann::json        mContent;
-    std::filesystem::path mFilePath;
+    nlohmann::json                mContent;
+    ReportFormat                  mFormat = ReportFormat::JSON;
+    std::vector<ReportTimeSeries> mTimeSeries; // ReportFormat::BINARY
+    std::filesystem::path         mFilePath;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -278,6 +566,10 @@ class Manager final
 public:
     Manager() = default;
 
+    // Mode of gauges added with GaugeMode::DEFAULT, TIME_SERIES unless set.
+    void      SetDefaultGaugeMode(GaugeMode mode);
+    GaugeMode GetDefaultGaugeMode() const { return mDefaultGaugeMode; }
+
     // Starts a run. There may only be one active run at a time.
     void StartRun(const std::string& name);
     // Concludes the current run.
@@ -292,16 +584,70 @@ public:
     // Records data for the given metric ID. Metrics for completed runs will be discarded.
     bool RecordMetricData(MetricID id, const MetricData& data);
 
+    // Same as RecordMetricData() but may be called from any thread. The data is
+    // pushed to a queue owned by the calling thread and only recorded by the
+    // next DrainQueuedMetricData(); taking a lock only on the thread's first
+    // call. Returns false when the thread's queue is full and the data dropped.
+    // The manager must outlive the threads calling this.
+    bool QueueMetricData(MetricID id, const MetricData& data);
+
+    // Records the data queued by all threads, on the thread owning the manager.
+    // Usually called once per frame; EndRun() also drains first. Gauge entries
+    // of a metric are recorded in order of time, wherever they were queued.
+    void DrainQueuedMetricData();
+
+    // Capacity of the queues of threads calling QueueMetricData() for the first
+    // time. Must be set before other threads start queueing.
+    void     SetQueueCapacity(uint32_t capacity);
+    uint32_t GetQueueCapacity() const { return mQueueCapacity; }
+
+    // Metrics added and data recorded afterwards are also published to the
+    // server, null stops publishing. The server must outlive the manager or be
+    // unset first.
+    void          SetStreamServer(StreamServer* pServer) { mStreamServer = pServer; }
+    StreamServer* GetStreamServer() const { return mStreamServer; }
+
     // Exports all the runs and metrics information into a report. Does NOT close the
     // current run.
-    Report CreateReport(const std::string& reportPath) const;
+    Report CreateReport(const std::string& reportPath, ReportFormat format = ReportFormat::JSON) const;
 
     // Get Gauge Basic Statistics, only works for type GAUGE
     GaugeBasicStatistics GetGaugeBasicStatistics(MetricID id) const;
 
+    // Marks the active run as a repetition of the benchmark. Reports then also
+    // have a "benchmark" object with the SummarizeRepetitions() of the median
+    // of each gauge over the repetitions that have it. Repetitions of a named
+    // point of a sweep are summarized separately, in the "sweep" array, with
+    // the point's parameters.
+    void                     AddBenchmarkRepetition(const std::string& point = "");
+    void                     SetBenchmarkParameters(const std::string& point, const nlohmann::json& parameters);
+    void                     SetBenchmarkSettings(const BenchmarkSettings& settings) { mBenchmarkSettings = settings; }
+    const BenchmarkSettings& GetBenchmarkSettings() const { return mBenchmarkSettings; }
+
+    // Reports have a "device" object with the fingerprint if it isn't empty.
+    void                     SetDeviceFingerprint(const DeviceFingerprint& device) { mDeviceFingerprint = device; }
+    const DeviceFingerprint& GetDeviceFingerprint() const { return mDeviceFingerprint; }
+
 private:
     METRICS_NO_COPY(Manager)
 
+    nlohmann::json ExportBenchmark(const std::string& point) const;
+
+    struct BenchmarkPoint
+    {
+        std::string              name;
+        nlohmann::json           parameters;
+        std::vector<std::string> repetitions; // Run names, in order
+    };
+
+    MetricQueue* GetThreadQueue();
+
+    struct QueuedEntry
+    {
+        MetricID   id;
+        MetricData data;
+    };
+
 private:
     std::unordered_map<std::string, std::unique_ptr<Run>> mRuns;
 
@@ -311,8 +657,30 @@ private:
     // Must be stored with the manager; Runs should not share MetricIDs.
     MetricID mNextMetricID = kInvalidMetricID + 1;
 
+    GaugeMode mDefaultGaugeMode = GaugeMode::TIME_SERIES;
+
+    StreamServer* mStreamServer = nullptr;
+
+    BenchmarkSettings           mBenchmarkSettings;
+    std::vector<BenchmarkPoint> mBenchmarkPoints; // In order of their first repetition
+
+    DeviceFingerprint mDeviceFingerprint;
+
     // Convenient to store with the manager, so the hop of going through the Run isn't necessary.
     std::unordered_map<MetricID, Metric*> mActiveMetrics;
+
+    // Tells apart managers allocated at the same address in the per-thread queue cache.
+    const uint64_t mSerial = sNextSerial++;
+
+    std::mutex                                                        mThreadQueuesMutex; // Guards mThreadQueues
+    std::unordered_map<std::thread::id, std::unique_ptr<MetricQueue>> mThreadQueues;
+    uint32_t                                                          mQueueCapacity = 4096;
+
+    // Reused by DrainQueuedMetricData() to avoid allocating every frame.
+    std::vector<MetricQueue*> mDrainQueues;
+    std::vector<QueuedEntry>  mDrainEntries;
+
+    static std::atomic<uint64_t> sNextSerial;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,125 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_metrics_stream_h
+#define ppx_metrics_stream_h
+
+#include "ppx/metrics.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace ppx {
+namespace metrics {
+
+// Records sent to stream clients, in the host's byte order (little endian on
+// every supported platform). Each record starts with its StreamRecordType.
+enum StreamRecordType : uint32_t
+{
+    // StreamInfoRecord followed by nameLength bytes of name, sent for every
+    // metric when a client connects and for each metric added afterwards.
+    STREAM_RECORD_TYPE_INFO = 1,
+    // StreamDataRecord
+    STREAM_RECORD_TYPE_DATA = 2,
+};
+
+struct StreamInfoRecord
+{
+    uint32_t recordType = STREAM_RECORD_TYPE_INFO;
+    MetricID id         = kInvalidMetricID;
+    uint32_t metricType = 0; // MetricType
+    uint32_t nameLength = 0;
+};
+
+struct StreamDataRecord
+{
+    uint32_t recordType = STREAM_RECORD_TYPE_DATA;
+    MetricID id         = kInvalidMetricID;
+    double   seconds    = 0; // Gauges only
+    double   value      = 0; // Gauge value or counter increment
+};
+
+static_assert(sizeof(StreamInfoRecord) == 16, "StreamInfoRecord must be packed");
+static_assert(sizeof(StreamDataRecord) == 24, "StreamDataRecord must be packed");
+
+// Streams the data recorded by a Manager to TCP clients while it runs, e.g. a
+// desktop dashboard plotting frame times of a headset. Publish() pushes to a
+// lock-free queue, a thread of the server sends it with non-blocking writes.
+// Data is dropped when the queue is full, when no client is connected or when
+// a client doesn't keep up; the report of the run is unaffected.
+//
+// Linux and Android only, Start() fails elsewhere.
+class StreamServer final
+{
+public:
+    StreamServer() = default;
+    ~StreamServer();
+
+    // Listens on all interfaces, port 0 picks a free port, see GetPort().
+    Result Start(uint16_t port, uint32_t queueCapacity = 4096);
+    void   Stop();
+    bool   IsRunning() const { return mThread.joinable(); }
+
+    uint16_t GetPort() const { return mPort; }
+    uint32_t GetClientCount() const { return mClientCount.load(std::memory_order_relaxed); }
+
+    // Owner thread. Sent to connected clients and to clients connecting later.
+    void AddMetricInfo(MetricID id, const MetricMetadata& metadata);
+    // Owner thread. Never blocks or allocates, returns false if dropped.
+    bool Publish(MetricID id, const MetricData& data);
+
+    StreamServer(const StreamServer&)            = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+
+private:
+    struct Client
+    {
+        int                  socket = -1;
+        std::vector<uint8_t> pending; // Not yet sent
+    };
+
+    struct MetricInfo
+    {
+        MetricID    id;
+        MetricType  type;
+        std::string name;
+    };
+
+    void Run();
+    void AcceptClients();
+    void SendNewInfos();
+    void DropClient(size_t index);
+
+private:
+    int                          mListenSocket = -1;
+    uint16_t                     mPort         = 0;
+    std::unique_ptr<MetricQueue> mQueue;
+    std::thread                  mThread;
+    std::atomic<bool>            mStopRequested = false;
+    std::atomic<uint32_t>        mClientCount   = 0;
+
+    std::mutex              mInfosMutex; // Guards mInfos
+    std::vector<MetricInfo> mInfos;
+
+    // Server thread only
+    size_t               mSentInfoCount = 0; // Infos already sent to the connected clients
+    std::vector<Client>  mClients;
+    std::vector<uint8_t> mDataBytes;
+};
+
+} // namespace metrics
+} // namespace ppx
+
+#endif // ppx_metrics_stream_h
@@ -20,6 +20,19 @@
 
 namespace ppx {
 
+enum MipmapFilter
+{
+    MIPMAP_FILTER_BOX = 0,
+    MIPMAP_FILTER_KAISER, // Kaiser windowed sinc, sharper than box
+};
+
+struct MipmapGenerateInfo
+{
+    MipmapFilter filter      = MIPMAP_FILTER_BOX;
+    bool         srgb        = false; // Color channels of 8 bit formats are sRGB encoded, alpha is linear
+    uint32_t     threadCount = 0;     // 0 uses all hardware threads
+};
+
 //! @class MipMap
 //!
 //! Stores a mipmap as a linear chunk of memory with each mip level accessible
@@ -48,6 +61,7 @@ public:
     // This should only be used for temporary mipmaps which will be destroyed prior to the creation of any new mipmap.
     Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool);
     Mipmap(const Bitmap& bitmap, uint32_t levelCount);
+    Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool, const MipmapGenerateInfo& generateInfo);
     ~Mipmap() {}
 
     // Returns true if there's at least one mip level, format is valid, and storage is valid
@@ -61,6 +75,11 @@ public:
     uint32_t GetWidth(uint32_t level) const;
     uint32_t GetHeight(uint32_t level) const;
 
+    //! Regenerates every level after the first from the level before it.
+    //! Levels are split into bands of rows small enough for the cache, and
+    //! bands of large levels are filtered on multiple threads.
+    Result GenerateLevels(const MipmapGenerateInfo& generateInfo = MipmapGenerateInfo());
+
     static uint32_t CalculateLevelCount(uint32_t width, uint32_t height);
     static Result   LoadFile(const std::filesystem::path& path, uint32_t baseWidth, uint32_t baseHeight, Mipmap* pMipmap, uint32_t levelCount = PPX_REMAINING_MIP_LEVELS);
     static Result   SaveFile(const std::filesystem::path& path, const Mipmap* pMipmap, uint32_t levelCount = PPX_REMAINING_MIP_LEVELS);
@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_perf_counters_h
+#define ppx_perf_counters_h
+
+#include "ppx/config.h"
+
+namespace ppx {
+
+enum PerfCounter
+{
+    PERF_COUNTER_CYCLES        = 0,
+    PERF_COUNTER_INSTRUCTIONS  = 1,
+    PERF_COUNTER_CACHE_MISSES  = 2,
+    PERF_COUNTER_BRANCH_MISSES = 3,
+    PERF_COUNTER_COUNT         = 4,
+};
+
+struct PerfCounterValues
+{
+    uint64_t values[PERF_COUNTER_COUNT] = {};
+};
+
+//! @class PerfCounters
+//!
+//! CPU hardware counters of the thread that opens them and of the threads it
+//! creates afterwards, user space only. Uses perf_event_open on Linux and
+//! Android; elsewhere, or where the kernel's perf_event_paranoid setting
+//! doesn't allow it, Open() fails. Counters the CPU doesn't have are
+//! skipped and read as 0, see IsAvailable().
+//!
+//! When more counters are open than the CPU has registers, the kernel
+//! multiplexes them and Read() scales the counts by the time each counter
+//! actually ran.
+//!
+//!   PerfCounterValues begin, end;
+//!   counters.Read(&begin);
+//!   ... work ...
+//!   counters.Read(&end);
+//!   end.values[PERF_COUNTER_CYCLES] - begin.values[PERF_COUNTER_CYCLES]
+//!
+class PerfCounters
+{
+public:
+    PerfCounters() {}
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&)            = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    //! Returns ERROR_REQUIRED_FEATURE_UNAVAILABLE if no counter could be opened
+    Result Open();
+    void   Close();
+
+    bool IsOpen() const;
+    bool IsAvailable(PerfCounter counter) const;
+
+    //! Counts since Open()
+    Result Read(PerfCounterValues* pValues) const;
+
+    static const char* GetName(PerfCounter counter);
+
+private:
+    int mFds[PERF_COUNTER_COUNT] = {-1, -1, -1, -1};
+};
+
+} // namespace ppx
+
+#endif // ppx_perf_counters_h
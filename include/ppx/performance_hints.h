@@ -0,0 +1,89 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_performance_hints_h
+#define ppx_performance_hints_h
+
+#include "ppx/config.h"
+
+namespace ppx {
+
+// Values of Android's AThermalStatus
+enum ThermalStatus
+{
+    THERMAL_STATUS_UNKNOWN   = -1,
+    THERMAL_STATUS_NONE      = 0,
+    THERMAL_STATUS_LIGHT     = 1, // Throttling starts here
+    THERMAL_STATUS_MODERATE  = 2,
+    THERMAL_STATUS_SEVERE    = 3,
+    THERMAL_STATUS_CRITICAL  = 4,
+    THERMAL_STATUS_EMERGENCY = 5,
+    THERMAL_STATUS_SHUTDOWN  = 6,
+};
+
+//! @class PerformanceHints
+//!
+//! Android Dynamic Performance Framework (ADPF): a performance hint session
+//! for the thread that opens it, which reports how long each frame's work
+//! took against a target so the system can pick CPU clocks, and the
+//! device's thermal status and headroom. The NDK functions are looked up at
+//! runtime: the hint session needs Android 13, the thermal status Android
+//! 11 and the headroom Android 12. Elsewhere Open() fails.
+//!
+//!   hints.Open(16666667);
+//!   ... frame work ...
+//!   hints.ReportActualWorkDuration(workNanos);
+//!
+class PerformanceHints
+{
+public:
+    PerformanceHints() {}
+    ~PerformanceHints();
+
+    PerformanceHints(const PerformanceHints&)            = delete;
+    PerformanceHints& operator=(const PerformanceHints&) = delete;
+
+    //! Returns ERROR_REQUIRED_FEATURE_UNAVAILABLE if neither the hint
+    //! session nor the thermal status are available
+    Result Open(uint64_t targetWorkDurationNanos);
+    void   Close();
+
+    bool IsOpen() const { return HasHintSession() || HasThermalStatus(); }
+    bool HasHintSession() const { return mSession != nullptr; }
+    bool HasThermalStatus() const { return mThermalManager != nullptr; }
+
+    Result UpdateTargetWorkDuration(uint64_t nanos);
+    Result ReportActualWorkDuration(uint64_t nanos);
+
+    //! THERMAL_STATUS_UNKNOWN without thermal status
+    ThermalStatus GetThermalStatus() const;
+
+    //! @brief Returns how close the device is to severe throttling: 0 is
+    //!        no throttling, 1 is THERMAL_STATUS_SEVERE. NaN if unavailable.
+    //! @param forecastSeconds Predicts the headroom this far ahead.
+    //!        The system caches the result, calls within a second of the
+    //!        previous one may return NaN.
+    float GetThermalHeadroom(uint32_t forecastSeconds = 0) const;
+
+    static const char* GetThermalStatusName(ThermalStatus status);
+
+private:
+    void* mLibrary        = nullptr;
+    void* mSession        = nullptr; // APerformanceHintSession
+    void* mThermalManager = nullptr; // AThermalManager
+};
+
+} // namespace ppx
+
+#endif // ppx_performance_hints_h
@@ -16,6 +16,7 @@
 #define ppx_h
 
 #include "ppx/application.h"
+#include "ppx/compute_context.h"
 #include "ppx/grfx/grfx_instance.h"
 
 #endif // ppx_h
\ No newline at end of file
@@ -0,0 +1,111 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_prerecorded_commands_h
+#define ppx_prerecorded_commands_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_queue.h"
+
+#include <string>
+#include <vector>
+
+namespace ppx {
+
+class Knob;
+
+struct PrerecordedCommandsCreateInfo
+{
+    grfx::Queue* pQueue    = nullptr;
+    uint32_t     count     = 1;     // Command buffers, e.g. one per swapchain image
+    bool         secondary = false; // Executed with ExecuteCommands instead of submitted
+};
+
+//! @class PrerecordedCommands
+//!
+//! Records static work once and resubmits it every frame, so the CPU only
+//! pays for recording when something it depends on changes. Holds 'count'
+//! reusable command buffers, see grfx::Queue::CreateReusableCommandBuffer(),
+//! indexed by whatever the recorded work varies with, usually the swapchain
+//! image index.
+//!
+//! The recorded commands capture pipelines, descriptor sets and resources,
+//! so per frame data has to go through buffer contents, e.g. uniform
+//! buffers written before the submit. Anything else the recording depends
+//! on must invalidate it: Invalidate() does so explicitly, WatchKnob()
+//! when the value of a knob changes and SetKey() when a caller computed
+//! key changes, e.g. a hash of the render settings.
+//!
+//! Stale command buffers are re-recorded by Get() into new command buffers
+//! and the old ones are destroyed once the GPU is done with them, so
+//! submissions in flight are never re-recorded.
+//!
+class PrerecordedCommands
+{
+public:
+    //! Records the commands of the command buffer at 'index', including
+    //! Begin() or BeginSecondary() and End()
+    using RecordFn = std::function<Result(grfx::CommandBuffer* pCommandBuffer, uint32_t index)>;
+
+    PrerecordedCommands() {}
+    ~PrerecordedCommands() {}
+
+    Result Initialize(const PrerecordedCommandsCreateInfo& createInfo);
+    //! Destroys the command buffers, the GPU must be done with them
+    void Shutdown();
+
+    //! Marks every command buffer for re-recording
+    void Invalidate();
+    //! Invalidates whenever the value of pKnob changes. The knob's own
+    //! update flag is left alone, so the application can still check it.
+    void WatchKnob(Knob* pKnob);
+    //! Invalidates if key differs from the previous key
+    void SetKey(uint64_t key);
+
+    //! Returns the command buffer at index, recording it first with
+    //! recordFn if it's stale
+    Result Get(uint32_t index, const RecordFn& recordFn, grfx::CommandBuffer** ppCommandBuffer);
+
+    uint32_t GetCount() const { return CountU32(mEntries); }
+    //! Returns the number of recordings since initialization
+    uint32_t GetRecordCount() const { return mRecordCount; }
+
+private:
+    struct Entry
+    {
+        grfx::CommandBuffer* pCommandBuffer = nullptr;
+        bool                 stale          = true;
+    };
+
+    struct WatchedKnob
+    {
+        Knob*       pKnob = nullptr;
+        std::string value;
+    };
+
+    void CheckKnobs();
+
+private:
+    grfx::Queue*             mQueue       = nullptr;
+    bool                     mSecondary   = false;
+    uint64_t                 mKey         = 0;
+    uint32_t                 mRecordCount = 0;
+    std::vector<Entry>       mEntries;
+    std::vector<WatchedKnob> mKnobs;
+};
+
+} // namespace ppx
+
+#endif // ppx_prerecorded_commands_h
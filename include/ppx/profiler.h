@@ -18,12 +18,19 @@
 #include "ppx/config.h"
 #include "xxhash.h"
 
+#include <ostream>
+#include <unordered_map>
+
+#define PPX_PROFILER_DEFAULT_TRACE_EVENTS_PER_THREAD (1 << 18)
+
 namespace ppx {
 
 enum ProfilerEventType
 {
     PROFILER_EVENT_TYPE_UNDEFINED   = 0,
     PROFILER_EVENT_TYPE_GRFX_API_FN = 1,
+    PROFILER_EVENT_TYPE_JOB         = 2,
+    PROFILER_EVENT_TYPE_SCOPE       = 3,
 };
 
 enum ProfileEventRecordAction
@@ -32,6 +39,12 @@ enum ProfileEventRecordAction
     PROFILER_EVENT_RECORD_ACTION_AVERAGE = 1,
 };
 
+enum ProfilerTraceEventType
+{
+    PROFILER_TRACE_EVENT_TYPE_SAMPLE       = 0,
+    PROFILER_TRACE_EVENT_TYPE_FRAME_MARKER = 1,
+};
+
 // -------------------------------------------------------------------------------------------------
 
 using ProfilerEventToken = XXH64_hash_t;
@@ -46,6 +59,42 @@ struct ProfilerEventSample
 
 // -------------------------------------------------------------------------------------------------
 
+#define PPX_PROFILE_CONCAT_INTERNAL(A, B) A##B
+#define PPX_PROFILE_CONCAT(A, B)          PPX_PROFILE_CONCAT_INTERNAL(A, B)
+
+// Times the rest of the enclosing scope on the calling thread. Scopes with the
+// same name share one event. The event is registered by the first execution,
+// after that a sample costs two timestamps and a lookup in the thread's
+// profiler. Shown in the debug window and in traces.
+//
+//   void Scene::Load()
+//   {
+//       PPX_PROFILE_SCOPE("Scene::Load");
+//       ...
+//   }
+#define PPX_PROFILE_SCOPE(NAME)                                                                                                             \
+    static const ::ppx::ProfilerEventToken PPX_PROFILE_CONCAT(sPpxProfileScopeToken, __LINE__) = ::ppx::Profiler::RegisterScopeEvent(NAME); \
+    ::ppx::ProfilerScopedEventSample       PPX_PROFILE_CONCAT(ppxProfileScopeSample, __LINE__)(PPX_PROFILE_CONCAT(sPpxProfileScopeToken, __LINE__))
+
+// -------------------------------------------------------------------------------------------------
+
+struct ProfilerTraceEvent
+{
+    ProfilerTraceEventType type;
+    uint64_t               id; // Event token of samples, frame number of frame markers
+    uint64_t               startTimestamp;
+    uint64_t               endTimestamp;
+};
+
+struct ProfilerTraceGpuScope
+{
+    std::string name;
+    uint64_t    startTimestamp; // Timer timestamps
+    uint64_t    endTimestamp;
+};
+
+// -------------------------------------------------------------------------------------------------
+
 class ProfilerScopedEventSample
 {
 public:
@@ -105,6 +154,13 @@ public:
     static Result RegisterEvent(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken* pToken);
     static Result RegisterGrfxApiFnEvent(const std::string& name, ProfilerEventToken* pToken);
 
+    // Registers a PROFILER_EVENT_TYPE_SCOPE event, or returns the token of the
+    // existing one. Safe to call while other threads record samples: each
+    // thread's profiler adds the event with its first sample. Scope events
+    // survive ReinitializeGlobalVariables(), as PPX_PROFILE_SCOPE keeps the
+    // tokens in statics.
+    static ProfilerEventToken RegisterScopeEvent(const std::string& name);
+
     void RecordSample(const ProfilerEventToken& token, const ProfilerEventSample& sample);
 
     // Removed all previously registered events. It is not safe to call this function while
@@ -113,11 +169,38 @@ public:
 
     const std::vector<ProfilerEvent>& GetEvents() const { return mEvents; }
 
+    // While tracing, every sample is also kept with its timestamps, whatever
+    // the event's record action. Each thread writes to its own buffer of
+    // maxEventsPerThread events, allocated by its first traced event; events
+    // past that are dropped. Like RemoveAllEvents(), it is not safe to start,
+    // stop or write a trace while running code recording samples.
+    static void StartTrace(uint32_t maxEventsPerThread = PPX_PROFILER_DEFAULT_TRACE_EVENTS_PER_THREAD);
+    static void StopTrace();
+    static bool IsTracing();
+
+    // Instant event on the calling thread's track.
+    static void RecordTraceFrameMarker(uint64_t frameNumber);
+    // GPU work converted to Timer timestamps, shown on a track of its own.
+    static void RecordTraceGpuScope(const std::string& name, uint64_t startTimestamp, uint64_t endTimestamp);
+
+    // Writes the trace in the Chrome trace event JSON format, which
+    // chrome://tracing and ui.perfetto.dev load.
+    static void WriteTrace(std::ostream& os);
+
+    uint32_t GetTraceEventCount() const { return mTraceEventCount; }
+    uint64_t GetTraceDroppedCount() const { return mTraceDroppedCount; }
+
 private:
     Result RegisterEventInternal(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken token);
+    void   RecordTraceEvent(const ProfilerTraceEvent& event);
+    void   ResetTrace(uint32_t maxEvents);
 
 private:
-    std::vector<ProfilerEvent> mEvents;
+    std::vector<ProfilerEvent>                     mEvents;
+    std::unordered_map<ProfilerEventToken, size_t> mEventIndices; // Into mEvents
+    std::vector<ProfilerTraceEvent>                mTraceEvents;  // Allocated by the first traced event
+    uint32_t                                       mTraceEventCount   = 0;
+    uint64_t                                       mTraceDroppedCount = 0;
 };
 
 } // namespace ppx
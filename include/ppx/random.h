@@ -112,6 +112,34 @@ public:
         return value;
     }
 
+    // Bulk generation
+    //
+    // Each Fill*() call seeds kStreamCount pcg32 streams from this generator
+    // and interleaves them, so the CPU works on several independent state
+    // updates at once instead of waiting on one. Output only depends on the
+    // seed and the sequence of calls, not on the CPU, but it isn't what the
+    // single value functions above would have returned.
+    //
+    void FillUInt32(uint32_t* pValues, size_t count);
+    // Values in [0, 1)
+    void FillFloat(float* pValues, size_t count);
+    // Values between a and b, same mapping as Float(a, b)
+    void FillFloat(float* pValues, size_t count, float a, float b);
+    void FillFloat2(float2* pValues, size_t count, const float2& a, const float2& b);
+    void FillFloat3(float3* pValues, size_t count, const float3& a, const float3& b);
+    void FillFloat4(float4* pValues, size_t count, const float4& a, const float4& b);
+    // Directions uniformly distributed over the unit sphere
+    void FillUnitVector3(float3* pValues, size_t count);
+    // Points uniformly distributed inside of the sphere at center
+    void FillPointInSphere(float3* pValues, size_t count, const float3& center, float radius);
+
+private:
+    static constexpr uint32_t kStreamCount = 4;
+
+    void SeedStreams(pcg32* pStreams);
+    // Fills count floats of consecutive vectors of componentCount components
+    void FillComponents(float* pValues, size_t count, uint32_t componentCount, const float* pA, const float* pB);
+
 private:
     pcg32 mRng;
 };
@@ -0,0 +1,172 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_animation_h
+#define ppx_scene_animation_h
+
+#include "ppx/scene/scene_config.h"
+
+namespace ppx {
+namespace scene {
+
+enum AnimationPath
+{
+    ANIMATION_PATH_TRANSLATION = 0,
+    ANIMATION_PATH_ROTATION    = 1, // Quaternion as float4(x, y, z, w)
+    ANIMATION_PATH_SCALE       = 2,
+    ANIMATION_PATH_WEIGHTS     = 3, // Morph target weights of a scene::MeshNode
+};
+
+enum AnimationInterpolation
+{
+    ANIMATION_INTERPOLATION_STEP         = 0,
+    ANIMATION_INTERPOLATION_LINEAR       = 1,
+    ANIMATION_INTERPOLATION_CUBIC_SPLINE = 2,
+};
+
+// -------------------------------------------------------------------------------------------------
+
+// Animation Sampler
+//
+// Keyframes of one animated property. Key times and values are separate
+// arrays and values are padded to float4s, so finding the keys is a search
+// over packed floats and blending two keys is a few float4 operations.
+// A key has GetVectorCount() float4s, 1 for transforms and one per 4 morph
+// target weights. Cubic spline keys store the in tangent, the value and the
+// out tangent, each GetVectorCount() float4s.
+//
+// Corresponds to GLTF's animation sampler objects.
+//
+class AnimationSampler
+{
+public:
+    AnimationSampler(
+        scene::AnimationInterpolation interpolation,
+        std::vector<float>&&          times,
+        std::vector<float4>&&         values,
+        uint32_t                      valueCount); // Floats per key value, e.g. 3 for translations
+
+    scene::AnimationInterpolation GetInterpolation() const { return mInterpolation; }
+    uint32_t                      GetKeyCount() const { return CountU32(mTimes); }
+    uint32_t                      GetValueCount() const { return mValueCount; }
+    uint32_t                      GetVectorCount() const { return mVectorCount; }
+    float                         GetStartTime() const { return mTimes.empty() ? 0.0f : mTimes.front(); }
+    float                         GetEndTime() const { return mTimes.empty() ? 0.0f : mTimes.back(); }
+
+    // Writes GetVectorCount() float4s of the value at time to pValues, times
+    // outside of the keys are clamped. pCursor holds the key sampled last,
+    // so forward playback finds the next key without searching. Quaternions
+    // are blended linearly along the shorter arc and normalized, which is
+    // close to slerp at animation key rates.
+    void Sample(float time, uint32_t* pCursor, bool quaternion, float4* pValues) const;
+
+private:
+    // Returns the first float4 of the value of key, skipping cubic spline tangents
+    const float4* GetValue(uint32_t key) const;
+
+private:
+    scene::AnimationInterpolation mInterpolation = scene::ANIMATION_INTERPOLATION_LINEAR;
+    std::vector<float>            mTimes;
+    std::vector<float4>           mValues;
+    uint32_t                      mValueCount  = 0;
+    uint32_t                      mVectorCount = 0;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+// Animation
+//
+// Channels that each animate a property of a node with one of the
+// animation's samplers. Apply() sets the properties at a time, nodes in a
+// scene pick the transforms up on the next scene::Scene::UpdateTransforms().
+//
+// Corresponds to GLTF's animation objects.
+//
+class Animation
+    : public grfx::NamedObjectTrait
+{
+public:
+    struct Channel
+    {
+        uint32_t             samplerIndex = 0;
+        scene::Node*         pTargetNode  = nullptr;
+        scene::AnimationPath path         = scene::ANIMATION_PATH_TRANSLATION;
+    };
+
+    Animation() = default;
+    virtual ~Animation() = default;
+
+    // Returns the index of the new sampler
+    uint32_t AddSampler(scene::AnimationSampler&& sampler);
+    // Fails if the channel's sampler doesn't exist or if a weights channel
+    // doesn't target a mesh node
+    ppx::Result AddChannel(const Channel& channel);
+
+    uint32_t                       GetSamplerCount() const { return CountU32(mSamplers); }
+    const scene::AnimationSampler& GetSampler(uint32_t index) const { return mSamplers[index]; }
+    uint32_t                       GetChannelCount() const { return CountU32(mChannels); }
+    const Channel&                 GetChannel(uint32_t index) const { return mChannels[index]; }
+
+    // Returns the end time of the last key in seconds
+    float GetDuration() const { return mDuration; }
+
+    // Sets the animated properties to their value at time seconds
+    void Apply(float time);
+
+private:
+    std::vector<scene::AnimationSampler> mSamplers;
+    std::vector<Channel>                 mChannels;
+    std::vector<uint32_t>                mCursors; // One per channel
+    std::vector<float4>                  mValues;  // Sampled values of a channel
+    std::vector<float>                   mWeights;
+    float                                mDuration = 0;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+// Skin
+//
+// Joint nodes and inverse bind matrices of skinned mesh nodes. Skinned
+// vertices are blended from the joint matrices, which take mesh space
+// positions to the joint's current pose in the mesh node's space.
+//
+// Corresponds to GLTF's skin objects.
+//
+class Skin
+    : public grfx::NamedObjectTrait
+{
+public:
+    // Missing inverse bind matrices are identity matrices
+    Skin(
+        std::vector<const scene::Node*>&& joints,
+        std::vector<float4x4>&&           inverseBindMatrices);
+    virtual ~Skin() = default;
+
+    uint32_t           GetJointCount() const { return CountU32(mJoints); }
+    const scene::Node* GetJoint(uint32_t index) const { return mJoints[index]; }
+
+    // Writes GetJointCount() joint matrices for a mesh node with meshNodeMatrix
+    // as its world matrix:
+    //   inverse(meshNodeMatrix) * jointWorldMatrix * inverseBindMatrix
+    void CalculateJointMatrices(const float4x4& meshNodeMatrix, float4x4* pMatrices) const;
+
+private:
+    std::vector<const scene::Node*> mJoints;
+    std::vector<float4x4>           mInverseBindMatrices;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_animation_h
@@ -0,0 +1,111 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_bounding_volume_hierarchy_h
+#define ppx_scene_bounding_volume_hierarchy_h
+
+#include "ppx/scene/scene_config.h"
+
+namespace ppx {
+namespace scene {
+
+// Bounding Volume Hierarchy
+//
+// Binary tree of world space AABBs of mesh nodes, for culling and picking
+// without visiting every node. Leaves hold up to kMaxLeafItems mesh nodes,
+// each node's box is the union of its children's. Nodes are stored so that
+// children come after their parent, refitting is a reverse pass over the
+// nodes that only recomputes the ones above moved mesh nodes.
+//
+// Update() rebuilds the tree when mesh nodes were added or removed and
+// refits it otherwise: mesh nodes whose world matrix or mesh changed get
+// new boxes. Refitting keeps the tree's topology, so once moving nodes have
+// grown the root box past kRebuildAreaRatio times its size at the last
+// build the tree is rebuilt instead.
+//
+// Boxes come from scene::Mesh::GetBoundingBox(), so ray picks and nearest
+// queries are as precise as the mesh bounds.
+//
+class BoundingVolumeHierarchy
+{
+public:
+    static constexpr uint32_t kMaxLeafItems     = 4;
+    static constexpr float    kRebuildAreaRatio = 2.0f;
+
+    BoundingVolumeHierarchy() = default;
+    ~BoundingVolumeHierarchy() = default;
+
+    // Builds the tree over the mesh nodes that have a mesh, reads their
+    // evaluated matrices so transforms should be up to date
+    void Build(const std::vector<scene::MeshNode*>& meshNodes);
+    // Rebuilds or refits, see above
+    void Update(const std::vector<scene::MeshNode*>& meshNodes);
+
+    // Returns the number of mesh nodes in the tree
+    uint32_t GetItemCount() const { return CountU32(mItems); }
+    // Returns the number of tree nodes
+    uint32_t GetNodeCount() const { return CountU32(mNodes); }
+    // Returns true if the last Update() rebuilt the tree
+    bool WasRebuilt() const { return mRebuilt; }
+
+    // Returns the world space bounds of all mesh nodes in the tree
+    ppx::AABB GetBounds() const { return mNodes.empty() ? ppx::AABB() : mNodes[0].bounds; }
+
+    // Appends the mesh nodes whose bounds overlap frustum to pNodes
+    void QueryFrustum(const ppx::Frustum& frustum, std::vector<const scene::MeshNode*>* pNodes) const;
+
+    // Returns the mesh node whose bounds the ray enters first, or NULL if it
+    // misses every node. pDistance is the distance along direction to the
+    // hit, 0 if origin is inside the bounds.
+    const scene::MeshNode* Raycast(const float3& origin, const float3& direction, float* pDistance = nullptr) const;
+
+    // Returns the mesh node whose bounds are closest to point, or NULL if
+    // the tree is empty. pDistance is 0 if point is inside the bounds.
+    const scene::MeshNode* FindNearest(const float3& point, float* pDistance = nullptr) const;
+
+private:
+    struct Item
+    {
+        const scene::MeshNode* pNode  = nullptr;
+        const scene::Mesh*     pMesh  = nullptr; // Mesh the bounds were computed from
+        float4x4               matrix = float4x4(1);
+        ppx::AABB              bounds = {};
+        uint32_t               leaf   = 0;
+    };
+
+    struct Node
+    {
+        ppx::AABB bounds    = {};
+        uint32_t  parent    = UINT32_MAX;
+        uint32_t  first     = 0; // First child of inner nodes, first mItemOrder index of leaves
+        uint32_t  itemCount = 0; // 0 for inner nodes, their children are first and first + 1
+    };
+
+    void BuildNode(uint32_t index, uint32_t begin, uint32_t end);
+    void Refit();
+
+private:
+    std::vector<const scene::MeshNode*> mMeshNodes = {}; // All mesh nodes the tree was built from
+    std::vector<Item>                   mItems     = {};
+    std::vector<uint32_t>               mItemOrder = {}; // Items of the leaves, leaf by leaf
+    std::vector<Node>                   mNodes     = {};
+    std::vector<uint8_t>                mDirty     = {}; // One per node
+    float                               mBuildArea = 0;
+    bool                                mRebuilt   = false;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_bounding_volume_hierarchy_h
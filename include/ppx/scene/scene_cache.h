@@ -0,0 +1,136 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_cache_h
+#define ppx_scene_cache_h
+
+#include "ppx/scene/scene_config.h"
+#include "ppx/bitmap.h"
+#include "ppx/fs.h"
+#include "ppx/mesh_optimizer.h"
+
+namespace ppx {
+
+class Mipmap;
+
+namespace scene {
+
+// Scene Cache
+//
+// Cooked scene data that GltfLoader writes on the first load of a file and
+// reads on later loads, see LoadOptions::SetCacheDirectory(). Mesh data is
+// stored in the GPU layout GltfLoader builds for a set of vertex attributes
+// and images are stored as full mip chains, so loading either is a copy
+// into a staging buffer.
+//
+// The key identifies the source data and everything else the cooked data
+// depends on. Load() rejects files with a different key or version. The
+// format is raw structs, so files are only meant for the build and the
+// machine that wrote them.
+//
+class SceneCache
+{
+public:
+    struct Batch
+    {
+        uint32_t        indexDataOffset     = 0;
+        uint32_t        indexDataSize       = 0;
+        uint32_t        positionDataOffset  = 0;
+        uint32_t        positionDataSize    = 0;
+        uint32_t        attributeDataOffset = 0;
+        uint32_t        attributeDataSize   = 0;
+        grfx::IndexType indexType           = grfx::INDEX_TYPE_UNDEFINED; // Repacked index type
+        uint32_t        indexCount          = 0;
+        uint32_t        vertexCount         = 0;
+        float3          boundingBoxMin      = float3(0);
+        float3          boundingBoxMax      = float3(0);
+        uint32_t        lodCount            = 0; // 0 if the batch has no LODs
+        ppx::MeshLod    lods[PPX_MESH_MAX_LOD_COUNT];
+    };
+
+    struct MeshData
+    {
+        uint32_t           gltfMeshIndex       = 0;
+        uint32_t           vertexAttributeMask = 0;
+        std::vector<Batch> batches;
+        uint64_t           dataOffset = 0;
+        uint64_t           dataSize   = 0;
+    };
+
+    struct ImageLevel
+    {
+        uint32_t width      = 0;
+        uint32_t height     = 0;
+        uint32_t rowStride  = 0;
+        uint64_t dataOffset = 0;
+        uint64_t dataSize   = 0;
+    };
+
+    struct Image
+    {
+        uint32_t                gltfImageIndex = 0;
+        Bitmap::Format          format         = Bitmap::FORMAT_UNDEFINED;
+        std::vector<ImageLevel> levels;
+    };
+
+    SceneCache() {}
+    ~SceneCache() {}
+
+    uint64_t GetKey() const { return mKey; }
+    void     SetKey(uint64_t key) { mKey = key; }
+
+    // Loads the file at path into an empty cache. Returns
+    // ERROR_SCENE_CACHE_MISMATCH if the file was written for another key
+    // or by another version.
+    ppx::Result Load(const std::filesystem::path& path, uint64_t key);
+
+    ppx::Result Save(const std::filesystem::path& path) const;
+
+    // Return NULL if there's no entry
+    const MeshData* FindMeshData(uint32_t gltfMeshIndex, uint32_t vertexAttributeMask) const;
+    const Image*    FindImage(uint32_t gltfImageIndex) const;
+
+    // Returns the address of an entry's data at dataOffset
+    const char* GetData(uint64_t dataOffset) const;
+
+    // Creates bitmaps that reference the data of each mip level
+    ppx::Result GetImageLevels(const Image& image, std::vector<Bitmap>* pLevels) const;
+
+    void AddMeshData(
+        uint32_t                  gltfMeshIndex,
+        uint32_t                  vertexAttributeMask,
+        const std::vector<Batch>& batches,
+        const void*               pData,
+        uint64_t                  dataSize);
+
+    void AddImage(uint32_t gltfImageIndex, const Mipmap& mipmap);
+
+private:
+    uint64_t AppendData(const void* pData, uint64_t dataSize);
+
+private:
+    uint64_t              mKey = 0;
+    std::vector<MeshData> mMeshData;
+    std::vector<Image>    mImages;
+
+    // Entry data lives in mFile if it's mapped, mData otherwise
+    fs::File          mFile;
+    const char*       mMappedData = nullptr;
+    std::vector<char> mData;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_cache_h
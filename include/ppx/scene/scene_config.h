@@ -30,18 +30,23 @@
 namespace ppx {
 namespace scene {
 
+class Animation;
 class Image;
 class Loader;
 class Material;
 class MaterialFactory;
 class Mesh;
 class MeshData;
+class MeshNode;
 class Node;
 class Renderer;
 class ResourceManager;
 class Sampler;
 class Scene;
+class Skin;
 class Texture;
+class TextureStreamer;
+class TransformHierarchy;
 
 using ImageRef    = std::shared_ptr<scene::Image>;
 using MaterialRef = std::shared_ptr<scene::Material>;
@@ -59,6 +64,16 @@ enum LightType
     LIGHT_TYPE_SPOT        = 3,
 };
 
+// Vertex layout of mesh data
+//   - VERTEX_QUANTIZATION_NONE: 32-bit floats, see kVertex*Format
+//   - VERTEX_QUANTIZATION_COMPACT: 16-bit and smaller, see kVertexQuantized*Format
+//
+enum VertexQuantization
+{
+    VERTEX_QUANTIZATION_NONE    = 0,
+    VERTEX_QUANTIZATION_COMPACT = 1,
+};
+
 const uint32_t kVertexPositionBinding           = 0;
 const uint32_t kVertexPositionLocation          = 0;
 const uint32_t kVertexAttributeBinding          = 1;
@@ -73,6 +88,56 @@ const grfx::Format kVertexAttributeNormalFormat   = grfx::FORMAT_R32G32B32_FLOAT
 const grfx::Format kVertexAttributeTagentFormat   = grfx::FORMAT_R32G32B32A32_FLOAT;
 const grfx::Format kVertexAttributeColorFormat    = grfx::FORMAT_R32G32B32_FLOAT;
 
+// Formats of VERTEX_QUANTIZATION_COMPACT vertices:
+//   - positions are relative to the mesh bounds, see VertexDequantization
+//   - normals are octahedral encoded, see ppx::EncodeOctahedral()
+//   - tangents are octahedral encoded with the sign of w folded into y,
+//     see ppx::EncodeOctahedralTangent()
+const grfx::Format kVertexQuantizedPositionFormat          = grfx::FORMAT_R16G16B16A16_SNORM;
+const grfx::Format kVertexQuantizedAttributeTexCoordFormat = grfx::FORMAT_R16G16_FLOAT;
+const grfx::Format kVertexQuantizedAttributeNormalFormat   = grfx::FORMAT_R16G16_SNORM;
+const grfx::Format kVertexQuantizedAttributeTangentFormat  = grfx::FORMAT_R16G16_SNORM;
+const grfx::Format kVertexQuantizedAttributeColorFormat    = grfx::FORMAT_R8G8B8A8_UNORM;
+
+// Skin data of skinned VERTEX_QUANTIZATION_NONE vertices, in its own plane
+// that the skinning compute shader reads, see scene::GpuSkinner: 4 joint
+// indices as R16G16B16A16_UINT followed by 4 weights as R16G16B16A16_UNORM.
+const uint32_t kVertexSkinDataSize = 16;
+
+struct VertexFormats
+{
+    grfx::Format position = grfx::FORMAT_UNDEFINED;
+    grfx::Format texCoord = grfx::FORMAT_UNDEFINED;
+    grfx::Format normal   = grfx::FORMAT_UNDEFINED;
+    grfx::Format tangent  = grfx::FORMAT_UNDEFINED;
+    grfx::Format color    = grfx::FORMAT_UNDEFINED;
+
+    static VertexFormats Get(scene::VertexQuantization quantization)
+    {
+        if (quantization == scene::VERTEX_QUANTIZATION_COMPACT) {
+            return {kVertexQuantizedPositionFormat, kVertexQuantizedAttributeTexCoordFormat, kVertexQuantizedAttributeNormalFormat, kVertexQuantizedAttributeTangentFormat, kVertexQuantizedAttributeColorFormat};
+        }
+        return {kVertexPositionFormat, kVertexAttributeTexCoordFormat, kVertexAttributeNormalFormat, kVertexAttributeTagentFormat, kVertexAttributeColorFormat};
+    }
+};
+
+// Compact positions are signed normalized relative to the mesh bounds:
+//   positionOS = positionOffset + positionScale * encodedPosition.xyz
+//
+struct VertexDequantization
+{
+    float3 positionScale  = float3(1);
+    float3 positionOffset = float3(0);
+
+    static VertexDequantization FromBounds(const ppx::AABB& bounds)
+    {
+        VertexDequantization dequantization = {};
+        dequantization.positionScale        = 0.5f * (bounds.GetMax() - bounds.GetMin());
+        dequantization.positionOffset       = 0.5f * (bounds.GetMax() + bounds.GetMin());
+        return dequantization;
+    }
+};
+
 template <
     typename ObjectT,
     typename ObjectRefT = std::shared_ptr<ObjectT>>
@@ -157,25 +222,26 @@ struct VertexAttributeFlags
         return *this;
     }
 
-    grfx::VertexBinding GetVertexBinding() const
+    grfx::VertexBinding GetVertexBinding(scene::VertexQuantization quantization = scene::VERTEX_QUANTIZATION_NONE) const
     {
         grfx::VertexBinding binding = grfx::VertexBinding(1, grfx::VERTEX_INPUT_RATE_VERTEX);
+        const VertexFormats formats = VertexFormats::Get(quantization);
 
         uint32_t offset = 0;
         if (this->bits.texCoords) {
-            binding.AppendAttribute(grfx::VertexAttribute{"TEXCOORD", kVertexAttributeTexCoordLocation, grfx::FORMAT_R32G32_FLOAT, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
-            offset += 8;
+            binding.AppendAttribute(grfx::VertexAttribute{"TEXCOORD", kVertexAttributeTexCoordLocation, formats.texCoord, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
+            offset += grfx::GetFormatDescription(formats.texCoord)->bytesPerTexel;
         }
         if (this->bits.normals) {
-            binding.AppendAttribute(grfx::VertexAttribute{"NORMAL", kVertexAttributeNormalLocation, grfx::FORMAT_R32G32B32_FLOAT, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
-            offset += 12;
+            binding.AppendAttribute(grfx::VertexAttribute{"NORMAL", kVertexAttributeNormalLocation, formats.normal, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
+            offset += grfx::GetFormatDescription(formats.normal)->bytesPerTexel;
         }
         if (this->bits.tangents) {
-            binding.AppendAttribute(grfx::VertexAttribute{"TANGENT", kVertexAttributeTangentLocation, grfx::FORMAT_R32G32B32A32_FLOAT, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
-            offset += 16;
+            binding.AppendAttribute(grfx::VertexAttribute{"TANGENT", kVertexAttributeTangentLocation, formats.tangent, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
+            offset += grfx::GetFormatDescription(formats.tangent)->bytesPerTexel;
         }
         if (this->bits.colors) {
-            binding.AppendAttribute(grfx::VertexAttribute{"COLOR", kVertexAttributeColorLocation, grfx::FORMAT_R32G32B32_FLOAT, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
+            binding.AppendAttribute(grfx::VertexAttribute{"COLOR", kVertexAttributeColorLocation, formats.color, kVertexAttributeBinding, offset, grfx::VERTEX_INPUT_RATE_VERTEX});
         }
 
         return binding;
@@ -16,10 +16,15 @@
 #define ppx_scene_gltf_loader_h
 
 #include "ppx/scene/scene_config.h"
+#include "ppx/scene/scene_cache.h"
 #include "ppx/scene/scene_loader.h"
+#include "ppx/bitmap.h"
 #include "cgltf.h"
 
+#include <atomic>
+#include <memory>
 #include <set>
+#include <thread>
 
 #if defined(WIN32) && defined(LoadImage)
 #define _SAVE_MACRO_LoadImage LoadImage
@@ -29,6 +34,8 @@
 namespace ppx {
 namespace scene {
 
+struct GltfSourceFiles;
+
 class GltfMaterialSelector
 {
 public:
@@ -218,6 +225,27 @@ public:
         scene::Scene**            ppTargetScene,
         const scene::LoadOptions& loadOptions = scene::LoadOptions());
 
+    // ---------------------------------------------------------------------------------------------
+    // Loads images that LoadScene() created as placeholders
+    //
+    // See LoadOptions::SetPlaceholderImages(). Images are decoded on
+    // background threads that read the loader's GLTF data, so the loader
+    // must outlive them, its destructor stops them.
+    //
+    // ---------------------------------------------------------------------------------------------
+
+    // Returns the number of images that are still placeholders.
+    uint32_t GetPendingImageCount() const { return CountU32(mPendingImages); }
+
+    // Uploads up to maxImageCount of the images that have finished decoding
+    // and swaps each into its scene::Image. Doesn't wait for decodes in
+    // progress. The GPU must be done with the placeholders that get
+    // replaced, and descriptors that use them need updating. Images that
+    // fail to decode keep their placeholder.
+    ppx::Result LoadPendingImages(
+        uint32_t  maxImageCount = UINT32_MAX,
+        uint32_t* pLoadedCount  = nullptr);
+
 private:
     // Stores a look up of a vertex attribute mask that is comprised of all
     // the required vertex attributes in a meshes materials in a given
@@ -240,6 +268,10 @@ private:
     //
     using MeshMaterialVertexAttributeMasks = std::unordered_map<const cgltf_mesh*, scene::VertexAttributeFlags>;
 
+    // Bitmaps decoded ahead of time, indexed by GLTF image index. Images
+    // without an entry are decoded when they're loaded.
+    using DecodedImages = std::vector<std::unique_ptr<ppx::Bitmap>>;
+
     void CalculateMeshMaterialVertexAttributeMasks(
         const scene::MaterialFactory*                 pMaterialFactory,
         GltfLoader::MeshMaterialVertexAttributeMasks* pOutMasks) const;
@@ -253,6 +285,19 @@ private:
         MeshMaterialVertexAttributeMasks* pMeshMaterialVertexAttributeMasks = nullptr;
         bool                              transformOnly                     = false;
         scene::Scene*                     pTargetScene                      = nullptr;
+        grfx::BufferPool*                 pBufferPool                       = nullptr;
+        bool                              accelerationStructureInput        = false;
+        ppx::MeshOptimizeOptions          meshOptimizeOptions               = {};
+        ppx::MeshLodOptions               meshLodOptions                    = {};
+        scene::VertexQuantization         vertexQuantization                = scene::VERTEX_QUANTIZATION_NONE;
+        DecodedImages*                    pDecodedImages                    = nullptr;
+        bool                              placeholderImages                 = false;
+        scene::TextureStreamer*           pTextureStreamer                  = nullptr;
+        scene::SceneCache*                pSceneCache                       = nullptr;
+        bool                              writeSceneCache                   = false; // Add to pSceneCache instead of reading from it
+        scene::LoadProgressCallback       progressCallback                  = {};
+        scene::LoadProgress*              pProgress                         = nullptr;
+        bool                              contentObjectIds                  = false; // Images and samplers are keyed by content
 
         struct
         {
@@ -261,6 +306,7 @@ private:
             uint64_t texture  = 0;
             uint64_t material = 0;
             uint64_t mesh     = 0;
+            uint64_t meshData = 0;
         } baseObjectIds;
     };
 
@@ -268,6 +314,10 @@ private:
     // same scene we need to apply an offset (base object id) to the object index
     // so that the final object id is unique.
     //
+    // With contentObjectIds images are keyed by a hash of their encoded
+    // bytes and samplers by their parameters instead, so loaders that share
+    // a resource manager share identical images and samplers.
+    //
     // These functions calculate the object id used when caching the resource.
     //
     uint64_t CalculateImageObjectId(const GltfLoader::InternalLoadParams& loadParams, uint32_t objectIndex);
@@ -291,6 +341,43 @@ private:
         const cgltf_image*                    pGltfImage,
         scene::Image**                        ppTargetImage);
 
+    // Key of a scene's cache, covers the source files and the device
+    // features that change the cooked data.
+    uint64_t CalculateSceneCacheKey(
+        grfx::Device*                   pDevice,
+        uint32_t                        sceneIndex,
+        const ppx::MeshOptimizeOptions& meshOptimizeOptions,
+        const ppx::MeshLodOptions&      meshLodOptions,
+        scene::VertexQuantization       vertexQuantization) const;
+
+    // Returns true if the image is a bitmap file or is stored in a buffer view
+    bool IsBitmapImage(const cgltf_image* pGltfImage) const;
+
+    // Decodes a bitmap image, safe to call from any thread
+    ppx::Result DecodeImage(const cgltf_image* pGltfImage, ppx::Bitmap* pBitmap) const;
+
+    // Decodes the images that are bitmaps on threadCount threads. Images
+    // that fail to decode are left out, loading them reports the error.
+    void DecodeImagesInternal(
+        const GltfLoader::InternalLoadParams& loadParams,
+        uint32_t                              threadCount,
+        GltfLoader::DecodedImages&            outDecodedImages);
+
+    // Packs decoded images no larger than maxImageSize into texture arrays
+    // and caches a packed scene::Image for each of them, see
+    // LoadOptions::SetMaxPackedImageSize(). Images that aren't packed are
+    // left in pDecodedImages for LoadImageInternal().
+    ppx::Result PackImagesInternal(
+        const GltfLoader::InternalLoadParams& loadParams,
+        uint32_t                              maxImageSize);
+
+    // Creates a bitmap image through loadParams.pTextureStreamer, see
+    // LoadOptions::SetTextureStreamer()
+    ppx::Result LoadStreamedImageInternal(
+        const GltfLoader::InternalLoadParams& loadParams,
+        const cgltf_image*                    pGltfImage,
+        scene::ImageRef&                      outImage);
+
     ppx::Result FetchImageInternal(
         const GltfLoader::InternalLoadParams& loadParams,
         const cgltf_image*                    pGltfImage,
@@ -357,17 +444,49 @@ private:
         const cgltf_node*                     pGltfNode,
         scene::NodeRef&                       outNode);
 
+    // Adds a mesh node child to pTargetNode for every EXT_mesh_gpu_instancing
+    // instance of pGltfNode, all sharing pGltfNode's mesh.
+    ppx::Result LoadMeshGpuInstancesInternal(
+        const GltfLoader::InternalLoadParams& loadParams,
+        const cgltf_node*                     pGltfNode,
+        scene::Node*                          pTargetNode);
+
     ppx::Result LoadSceneInternal(
         const GltfLoader::InternalLoadParams& externalLoadParams,
         const cgltf_scene*                    pGltfScene,
         scene::Scene*                         pTargetScene);
 
+    // Skins of the scene's mesh nodes, and the channels of animations that
+    // target the scene's nodes. Morph target weights are animated but
+    // morph target geometry isn't loaded.
+    ppx::Result LoadSkinsInternal(
+        const std::unordered_map<cgltf_size, scene::Node*>& indexToNodeMap,
+        scene::Scene*                                       pTargetScene);
+
+    ppx::Result LoadAnimationsInternal(
+        const std::unordered_map<cgltf_size, scene::Node*>& indexToNodeMap,
+        scene::Scene*                                       pTargetScene);
+
 private:
     // Builds a set of node indices that include pGltfNode and all its children.
     void GetUniqueGltfNodeIndices(
         const cgltf_node*     pGltfNode,
         std::set<cgltf_size>& uniqueGltfNodeIndices) const;
 
+    // Placeholder image waiting for its bitmap. Decode threads only write
+    // bitmap and then decoded.
+    struct PendingImage
+    {
+        uint32_t                     gltfImageIndex = 0;
+        std::weak_ptr<scene::Image>  image;
+        std::unique_ptr<ppx::Bitmap> bitmap;
+        std::atomic<bool>            decoded = false;
+    };
+
+    // Starts threadCount threads decoding the pending images that aren't
+    // decoded or being decoded yet.
+    void StartPendingImageDecode(uint32_t threadCount);
+
 private:
     std::filesystem::path        mGltfFilePath           = "";
     std::filesystem::path        mGltfTextureDir         = ""; // This might be different than the parent dir of mGltfFilePath
@@ -376,6 +495,17 @@ private:
     scene::GltfMaterialSelector* mMaterialSelector       = nullptr;
     bool                         mOwnsMaterialSelector   = false;
     scene::MaterialFactory       mDefaultMaterialFactory = {};
+
+    // Content hashes of images, 0 until calculated
+    std::vector<uint64_t> mImageContentHashes;
+
+    std::vector<std::unique_ptr<PendingImage>> mPendingImages;
+    uint32_t                                   mPendingImageDecodeStart = 0;
+    std::vector<std::thread>                   mPendingImageThreads;
+    std::atomic<bool>                          mStopPendingImageDecode = false;
+
+    // Mapped GLTF and buffer files the GLTF data references, released after it
+    std::unique_ptr<scene::GltfSourceFiles> mSourceFiles;
 };
 
 } // namespace scene
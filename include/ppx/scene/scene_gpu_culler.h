@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_gpu_culler_h
+#define ppx_scene_gpu_culler_h
+
+#include "ppx/scene/scene_config.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+
+#include <unordered_map>
+
+namespace ppx {
+namespace scene {
+
+// size = 48, must match GpuCull.hlsl
+struct GpuCullInstance
+{
+    float3   boundsMin;     // offset = 0, world space
+    uint32_t indexCount;    // offset = 12
+    float3   boundsMax;     // offset = 16, world space
+    uint32_t firstIndex;    // offset = 28
+    int32_t  vertexOffset;  // offset = 32
+    uint32_t firstInstance; // offset = 36
+    uint32_t padding[2];    // offset = 40
+};
+
+struct GpuCullerCreateInfo
+{
+    grfx::ShaderModule* pCullShader      = nullptr; // basic/shaders/GpuCull.cs
+    grfx::ShaderModule* pHiZShader       = nullptr; // basic/shaders/HiZ.cs
+    uint32_t            maxInstanceCount = 4096;
+    uint32_t            depthWidth       = 0; // Size of the depth images passed to BuildHiZ()
+    uint32_t            depthHeight      = 0;
+    uint32_t            maxDepthImages   = 4; // Distinct depth images BuildHiZ() is called with, e.g. swapchain image count
+};
+
+// GPU Culler
+//
+// Frustum and occlusion culling of draw instances in a compute shader.
+// Each instance owns one grfx::DrawIndexedIndirectCommand in the draw
+// arguments buffer; Cull() writes the instance's draw to it, with an
+// instance count of 0 if the instance isn't visible. Draws are then
+// issued with DrawIndexedIndirect(GetDrawArgsBuffer(), GetDrawArgsOffset(i), 1).
+//
+// Occlusion culling tests against a hierarchical depth (HiZ) pyramid
+// built by BuildHiZ() from the previous frame's depth buffer, so it uses
+// the previous frame's view projection matrix. Objects that become visible
+// because the camera moved pop in one frame late. Occlusion culling is
+// skipped until BuildHiZ() was called once.
+//
+// Cull() updates CPU visible buffers, so only one Cull() can be in flight
+// on the GPU at a time. The culler must be recreated if the depth images
+// are, e.g. on swapchain resize.
+//
+class GpuCuller
+{
+public:
+    GpuCuller();
+    virtual ~GpuCuller();
+
+    static ppx::Result Create(grfx::Device* pDevice, const scene::GpuCullerCreateInfo& createInfo, scene::GpuCuller** ppCuller);
+
+    // Appends one instance per primitive batch of every mesh node in pScene.
+    // Batch views already point at the batch's geometry, so firstIndex and
+    // vertexOffset are 0.
+    static void AppendInstances(const scene::Scene* pScene, std::vector<scene::GpuCullInstance>* pInstances);
+
+    ppx::Result SetInstances(uint32_t count, const scene::GpuCullInstance* pInstances);
+    uint32_t    GetInstanceCount() const { return mInstanceCount; }
+
+    void SetFrustumCulling(bool enable) { mFrustumCulling = enable; }
+    void SetOcclusionCulling(bool enable) { mOcclusionCulling = enable; }
+    bool GetFrustumCulling() const { return mFrustumCulling; }
+    bool GetOcclusionCulling() const { return mOcclusionCulling; }
+
+    // Records the culling dispatch. Must be recorded outside of a render
+    // pass, leaves the draw arguments in RESOURCE_STATE_INDIRECT_ARGUMENT.
+    void Cull(grfx::CommandBuffer* pCmd, const float4x4& viewProjectionMatrix);
+
+    // Builds the HiZ pyramid from pDepthImage, which must be in depthState
+    // and is returned to depthState. Must be recorded outside of a render pass.
+    void BuildHiZ(grfx::CommandBuffer* pCmd, grfx::Image* pDepthImage, grfx::ResourceState depthState);
+
+    grfx::Buffer* GetDrawArgsBuffer() const { return mDrawArgsBuffer.Get(); }
+    uint64_t      GetDrawArgsOffset(uint32_t instanceIndex) const { return instanceIndex * sizeof(grfx::DrawIndexedIndirectCommand); }
+
+    // Visible instance count of the last completed Cull()
+    uint32_t GetVisibleCount() const;
+
+    grfx::Image* GetHiZImage() const { return mHiZImage.Get(); }
+
+private:
+    struct DepthSource
+    {
+        grfx::SampledImageViewPtr view;
+        grfx::DescriptorSetPtr    set;
+    };
+
+    ppx::Result InitializeResources(grfx::Device* pDevice, const scene::GpuCullerCreateInfo& createInfo);
+    ppx::Result InitializeHiZ(grfx::Device* pDevice, const scene::GpuCullerCreateInfo& createInfo);
+    ppx::Result GetDepthSource(grfx::Image* pDepthImage, DepthSource** ppSource);
+
+private:
+    grfx::Device*                                 mDevice                   = nullptr;
+    uint32_t                                      mMaxInstanceCount         = 0;
+    uint32_t                                      mMaxDepthImages           = 0;
+    uint32_t                                      mInstanceCount            = 0;
+    bool                                          mFrustumCulling           = true;
+    bool                                          mOcclusionCulling         = true;
+    bool                                          mHiZValid                 = false;
+    float4x4                                      mPrevViewProjectionMatrix = float4x4(1);
+    grfx::DescriptorPoolPtr                       mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr                  mCullSetLayout;
+    grfx::DescriptorSetLayoutPtr                  mHiZSetLayout;
+    grfx::DescriptorSetPtr                        mCullSet;
+    grfx::PipelineInterfacePtr                    mCullInterface;
+    grfx::PipelineInterfacePtr                    mHiZInterface;
+    grfx::ComputePipelinePtr                      mCullPipeline;
+    grfx::ComputePipelinePtr                      mHiZPipeline;
+    grfx::BufferPtr                               mParamsBuffer;
+    grfx::BufferPtr                               mInstanceBuffer;
+    grfx::BufferPtr                               mDrawArgsBuffer;
+    grfx::BufferPtr                               mCounterBuffer;
+    grfx::BufferPtr                               mCounterClearBuffer;
+    grfx::BufferPtr                               mCounterReadbackBuffer;
+    void*                                         mParamsMappedAddress      = nullptr;
+    void*                                         mInstanceMappedAddress    = nullptr;
+    const uint32_t*                               mReadbackMappedAddress    = nullptr;
+    grfx::ImagePtr                                mHiZImage;
+    grfx::SampledImageViewPtr                     mHiZView; // All mip levels, read by the cull shader
+    std::vector<grfx::SampledImageViewPtr>        mHiZMipViews;
+    std::vector<grfx::StorageImageViewPtr>        mHiZStorageViews;
+    std::vector<grfx::DescriptorSetPtr>           mHiZSets; // mHiZSets[i] writes mip i + 1
+    std::unordered_map<grfx::Image*, DepthSource> mDepthSources;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_gpu_culler_h
@@ -0,0 +1,122 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_gpu_skinner_h
+#define ppx_scene_gpu_skinner_h
+
+#include "ppx/scene/scene_config.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+
+#include <unordered_map>
+
+namespace ppx {
+namespace scene {
+
+struct GpuSkinnerCreateInfo
+{
+    grfx::ShaderModule* pSkinShader      = nullptr;     // basic/shaders/SkinVertices.cs
+    uint32_t            maxVertexCount   = 1024 * 1024; // Skinned vertices of all instances
+    uint32_t            maxJointCount    = 16 * 1024;   // Joints of all instances
+    uint32_t            maxSourceBuffers = 64;          // Distinct mesh data GPU buffers of the instances
+};
+
+// GPU Skinner
+//
+// Skins the vertices of skinned mesh nodes in a compute shader, before
+// they're drawn. Each instance is a skinned mesh node copy with its own
+// joint matrices and its own skinned positions and attributes, so several
+// copies of a mesh can play different poses. Normals and tangents are
+// skinned with the joint matrices, texture coordinates and colors are
+// copied.
+//
+// Skinned batches are drawn with the regular vertex layout, binding
+// GetPositionBufferView() and GetAttributeBufferView() in place of the
+// batch's views.
+//
+// The mesh data must be loaded with VERTEX_QUANTIZATION_NONE and from a
+// GPU buffer with rawStorageBuffer usage, loaded meshes have it unless
+// they're sub-allocated from a pool without it.
+//
+// Joint matrices are written to CPU visible memory, so only one Skin() can
+// be in flight on the GPU at a time.
+//
+class GpuSkinner
+{
+public:
+    GpuSkinner();
+    virtual ~GpuSkinner();
+
+    static ppx::Result Create(grfx::Device* pDevice, const scene::GpuSkinnerCreateInfo& createInfo, scene::GpuSkinner** ppSkinner);
+
+    // Adds a copy of pNode, which must have a mesh and a skin
+    ppx::Result AddInstance(const scene::MeshNode* pNode, uint32_t* pInstanceIndex);
+    uint32_t    GetInstanceCount() const { return CountU32(mInstances); }
+
+    const scene::MeshNode* GetInstanceNode(uint32_t instanceIndex) const { return mInstances[instanceIndex].pNode; }
+
+    // Returns where the instance's skin joint matrices go, write them with
+    // scene::Skin::CalculateJointMatrices() before Skin().
+    float4x4* GetJointMatrices(uint32_t instanceIndex) const;
+
+    // Records the skinning dispatches of all instances. Must be recorded
+    // outside of a render pass, leaves the skinned vertices in
+    // RESOURCE_STATE_VERTEX_BUFFER.
+    void Skin(grfx::CommandBuffer* pCmd);
+
+    // Skinned views of the batches of the instance's mesh, batches that
+    // aren't skinned return their own views
+    grfx::VertexBufferView GetPositionBufferView(uint32_t instanceIndex, uint32_t batchIndex) const;
+    grfx::VertexBufferView GetAttributeBufferView(uint32_t instanceIndex, uint32_t batchIndex) const;
+
+private:
+    struct Batch
+    {
+        uint32_t positionOffset  = 0; // Output offsets, 0 if the batch isn't skinned
+        uint32_t attributeOffset = 0;
+    };
+
+    struct Instance
+    {
+        const scene::MeshNode* pNode      = nullptr;
+        uint32_t               firstJoint = 0;
+        std::vector<Batch>     batches;
+    };
+
+    ppx::Result InitializeResources(grfx::Device* pDevice, const scene::GpuSkinnerCreateInfo& createInfo);
+    ppx::Result GetSourceSet(const grfx::Buffer* pSourceBuffer, grfx::DescriptorSet** ppSet);
+
+private:
+    grfx::Device*                                                   mDevice             = nullptr;
+    uint32_t                                                        mMaxJointCount      = 0;
+    uint32_t                                                        mMaxSourceBuffers   = 0;
+    uint64_t                                                        mOutputSize         = 0;
+    uint64_t                                                        mOutputUsed         = 0;
+    uint32_t                                                        mJointsUsed         = 0;
+    grfx::DescriptorPoolPtr                                         mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr                                    mSetLayout;
+    grfx::PipelineInterfacePtr                                      mInterface;
+    grfx::ComputePipelinePtr                                        mPipeline;
+    grfx::BufferPtr                                                 mJointBuffer;
+    grfx::BufferPtr                                                 mOutputBuffer;
+    float4x4*                                                       mJointMappedAddress = nullptr;
+    std::vector<Instance>                                           mInstances;
+    std::unordered_map<const grfx::Buffer*, grfx::DescriptorSetPtr> mSourceSets;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_gpu_skinner_h
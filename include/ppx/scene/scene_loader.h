@@ -16,15 +16,32 @@
 #define ppx_scene_loader_h
 
 #include "ppx/scene/scene_config.h"
+#include "ppx/mesh_optimizer.h"
 #include "ppx/scene/scene_material.h"
 #include "ppx/scene/scene_mesh.h"
 #include "ppx/scene/scene_node.h"
 #include "ppx/scene/scene_resource_manager.h"
 #include "ppx/scene/scene_scene.h"
 
+#include <functional>
+
 namespace ppx {
 namespace scene {
 
+// Load Progress
+//
+// Reported to the progress callback set in LoadOptions.
+//
+struct LoadProgress
+{
+    uint32_t imageCount    = 0; // Images decoded ahead of the node walk
+    uint32_t imagesDecoded = 0;
+    uint32_t nodeCount     = 0;
+    uint32_t nodesLoaded   = 0;
+};
+
+using LoadProgressCallback = std::function<void(const scene::LoadProgress&)>;
+
 // Load Options
 //
 // Stores optional paramters that are passed to scene loader implementations.
@@ -61,6 +78,158 @@ public:
     // Clears required attributes (sets required attributs to none)
     void ClearRequiredAttributes() { SetRequiredAttributes(scene::VertexAttributeFlags::None()); }
 
+    // Returns current buffer pool or NULL if one has not been set.
+    grfx::BufferPool* GetBufferPool() const { return mBufferPool; }
+
+    // Sets buffer pool that mesh geometry is sub-allocated from. The pool
+    // needs index and vertex buffer usage and must outlive the loaded meshes.
+    LoadOptions& SetBufferPool(grfx::BufferPool* pBufferPool)
+    {
+        mBufferPool = pBufferPool;
+        return *this;
+    }
+
+    // Returns true if mesh geometry is created for acceleration structure builds.
+    bool GetAccelerationStructureInput() const { return mAccelerationStructureInput; }
+
+    // Adds acceleration structure input usage to mesh geometry buffers so
+    // meshes can be used for ray queries. Buffer pools need the usage already.
+    LoadOptions& SetAccelerationStructureInput(bool value)
+    {
+        mAccelerationStructureInput = value;
+        return *this;
+    }
+
+    // Returns the reordering applied to mesh primitives.
+    const ppx::MeshOptimizeOptions& GetMeshOptimizeOptions() const { return mMeshOptimizeOptions; }
+
+    // Reorders the triangles and vertices of each primitive as it's loaded,
+    // see ppx::MeshOptimizeOptions. Nothing is reordered by default.
+    LoadOptions& SetMeshOptimizeOptions(const ppx::MeshOptimizeOptions& options)
+    {
+        mMeshOptimizeOptions = options;
+        return *this;
+    }
+
+    // Returns the levels of detail generated for mesh primitives.
+    const ppx::MeshLodOptions& GetMeshLodOptions() const { return mMeshLodOptions; }
+
+    // Generates coarser LODs of each primitive as it's loaded, after the
+    // reordering, see ppx::MeshLodOptions and PrimitiveBatch::SelectLod().
+    // The index data of each primitive has room for every LOD's target
+    // count. No LODs are generated by default.
+    LoadOptions& SetMeshLodOptions(const ppx::MeshLodOptions& options)
+    {
+        mMeshLodOptions = options;
+        return *this;
+    }
+
+    // Returns the vertex layout of mesh data.
+    scene::VertexQuantization GetVertexQuantization() const { return mVertexQuantization; }
+
+    // Sets the vertex layout of mesh data, see scene::VertexQuantization.
+    // Compact positions need the mesh data's VertexDequantization in the
+    // vertex shader, see InstanceParams. Meshes stay 32-bit float if they
+    // are acceleration structure input. Default is VERTEX_QUANTIZATION_NONE.
+    LoadOptions& SetVertexQuantization(scene::VertexQuantization quantization)
+    {
+        mVertexQuantization = quantization;
+        return *this;
+    }
+
+    // Returns the number of threads images are decoded on.
+    uint32_t GetDecodeThreadCount() const { return mDecodeThreadCount; }
+
+    // Decodes images on this many threads before any GPU objects are
+    // created, the calling thread is one of them. 0 uses one thread per
+    // hardware thread. With 1, the default, images are decoded as they're
+    // created. Decoded images stay in memory until they're uploaded.
+    LoadOptions& SetDecodeThreadCount(uint32_t count)
+    {
+        mDecodeThreadCount = count;
+        return *this;
+    }
+
+    // Returns true if images are created as placeholders and loaded later.
+    bool GetPlaceholderImages() const { return mPlaceholderImages; }
+
+    // Gives images a 1x1 placeholder and decodes them on background
+    // threads, see GltfLoader::LoadPendingImages(). The scene can be drawn
+    // as soon as the geometry is loaded. Images that aren't bitmaps, such
+    // as DDS files, are loaded as before.
+    LoadOptions& SetPlaceholderImages(bool value)
+    {
+        mPlaceholderImages = value;
+        return *this;
+    }
+
+    // Returns the largest width and height of images that are packed.
+    uint32_t GetMaxPackedImageSize() const { return mMaxPackedImageSize; }
+
+    // Packs bitmap images no larger than size x size into texture arrays,
+    // images with the same dimensions and format share an array and its
+    // descriptor. Material shaders sample layer arrayLayer of
+    // MaterialTextureParams. Images are decoded before any GPU objects
+    // are created, see SetDecodeThreadCount(). Not used with placeholder
+    // images or a scene cache. 0, the default, doesn't pack images.
+    LoadOptions& SetMaxPackedImageSize(uint32_t size)
+    {
+        mMaxPackedImageSize = size;
+        return *this;
+    }
+
+    // Returns the texture streamer or NULL if one has not been set.
+    scene::TextureStreamer* GetTextureStreamer() const { return mTextureStreamer; }
+
+    // Creates bitmap images through the streamer, which starts them with
+    // their smallest mip levels resident, see scene::TextureStreamer. The
+    // streamer must outlive the scene. Not used with placeholder images or
+    // a scene cache, and packed images aren't streamed.
+    LoadOptions& SetTextureStreamer(scene::TextureStreamer* pStreamer)
+    {
+        mTextureStreamer = pStreamer;
+        return *this;
+    }
+
+    // Returns the scene cache directory or an empty path if one has not been set.
+    const std::filesystem::path& GetCacheDirectory() const { return mCacheDirectory; }
+
+    // Sets a directory for cooked scene data, see scene::SceneCache. The
+    // first load of a file writes the cache, later loads read mesh data and
+    // mip chains from it. Placeholder images are turned off while the
+    // cache is written.
+    LoadOptions& SetCacheDirectory(const std::filesystem::path& path)
+    {
+        mCacheDirectory = path;
+        return *this;
+    }
+
+    // Returns the progress callback or an empty function if one has not been set.
+    const scene::LoadProgressCallback& GetProgressCallback() const { return mProgressCallback; }
+
+    // Sets a callback the loader calls on the calling thread as work
+    // completes, applications can use it to draw a loading screen.
+    LoadOptions& SetProgressCallback(const scene::LoadProgressCallback& callback)
+    {
+        mProgressCallback = callback;
+        return *this;
+    }
+
+    // Returns the shared resource manager or NULL if one has not been set.
+    const std::shared_ptr<scene::ResourceManager>& GetResourceManager() const { return mResourceManager; }
+
+    // Loads scenes into a resource manager that other scenes can share.
+    // Images are keyed by the hash of their encoded bytes and samplers by
+    // their parameters, so scenes from different files that use the same
+    // texture files share the GPU objects. Objects stay in the resource
+    // manager after the scenes are destroyed, see
+    // ResourceManager::EvictUnreferenced().
+    LoadOptions& SetResourceManager(const std::shared_ptr<scene::ResourceManager>& resourceManager)
+    {
+        mResourceManager = resourceManager;
+        return *this;
+    }
+
 private:
     // Pointer to custom material factory for loader to use.
     scene::MaterialFactory* mMaterialFactory = nullptr;
@@ -71,6 +240,42 @@ private:
     // default value is used - usually zeroes.
     //
     scene::VertexAttributeFlags mRequiredVertexAttributes = scene::VertexAttributeFlags::None();
+
+    // Pool for mesh geometry, each mesh gets its own buffer if not set.
+    grfx::BufferPool* mBufferPool = nullptr;
+
+    // Geometry buffers get acceleration structure input usage.
+    bool mAccelerationStructureInput = false;
+
+    // Reordering applied to mesh primitives.
+    ppx::MeshOptimizeOptions mMeshOptimizeOptions = {};
+
+    // Levels of detail generated for mesh primitives.
+    ppx::MeshLodOptions mMeshLodOptions = {};
+
+    // Vertex layout of mesh data.
+    scene::VertexQuantization mVertexQuantization = scene::VERTEX_QUANTIZATION_NONE;
+
+    // Threads images are decoded on, see SetDecodeThreadCount().
+    uint32_t mDecodeThreadCount = 1;
+
+    // Images start as placeholders, see SetPlaceholderImages().
+    bool mPlaceholderImages = false;
+
+    // Images no larger than this are packed, see SetMaxPackedImageSize().
+    uint32_t mMaxPackedImageSize = 0;
+
+    // Streams bitmap images if set, see SetTextureStreamer().
+    scene::TextureStreamer* mTextureStreamer = nullptr;
+
+    // Directory of scene caches, not used if empty.
+    std::filesystem::path mCacheDirectory;
+
+    // Called as images are decoded and nodes are loaded.
+    scene::LoadProgressCallback mProgressCallback;
+
+    // Resource manager shared between scenes, each scene gets its own if not set.
+    std::shared_ptr<scene::ResourceManager> mResourceManager;
 };
 
 } // namespace scene
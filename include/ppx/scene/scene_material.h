@@ -35,6 +35,14 @@ namespace scene {
 //
 // scene::Image objects can be shared between different scene::Texture objects.
 //
+// Placeholder images stand in for images that are still loading, see
+// GltfLoader::LoadPendingImages().
+//
+// Packed images are a layer of a texture array that other small images
+// share, see LoadOptions::SetMaxPackedImageSize(). The array image owns the
+// grfx objects and GetImage() and GetImageView() return the array's.
+// Shaders sample layer GetArrayLayer() of the view.
+//
 // Corresponds to GLTF's image object.
 //
 class Image
@@ -43,15 +51,46 @@ class Image
 public:
     Image(
         grfx::Image*            pImage,
-        grfx::SampledImageView* pImageView);
+        grfx::SampledImageView* pImageView,
+        bool                    placeholder = false);
+    Image(
+        const scene::ImageRef& arrayImage,
+        uint32_t               arrayLayer);
     virtual ~Image();
 
-    grfx::Image*            GetImage() const { return mImage.Get(); }
-    grfx::SampledImageView* GetImageView() const { return mImageView.Get(); }
+    grfx::Image*            GetImage() const { return mArrayImage ? mArrayImage->GetImage() : mImage.Get(); }
+    grfx::SampledImageView* GetImageView() const { return mArrayImage ? mArrayImage->GetImageView() : mImageView.Get(); }
+    bool                    IsPlaceholder() const { return mPlaceholder; }
+
+    // Returns the texture array a packed image is a layer of, NULL otherwise
+    const scene::Image* GetArrayImage() const { return mArrayImage.get(); }
+    uint32_t            GetArrayLayer() const { return mArrayLayer; }
+
+    // Destroys the current image and view and takes ownership of the new
+    // ones, the image is no longer a placeholder. The GPU must be done with
+    // the current ones. Descriptors that use GetImageView() need updating.
+    void SetImage(
+        grfx::Image*            pImage,
+        grfx::SampledImageView* pImageView);
+
+    // Takes ownership of the new image and view like SetImage(), but hands
+    // the current ones to the caller to destroy once the GPU is done with
+    // them, see scene::TextureStreamer.
+    void SwapImage(
+        grfx::Image*               pImage,
+        grfx::SampledImageView*    pImageView,
+        grfx::ImagePtr*            pOldImage,
+        grfx::SampledImageViewPtr* pOldImageView);
+
+private:
+    void DestroyImage();
 
 private:
-    grfx::ImagePtr            mImage     = nullptr;
-    grfx::SampledImageViewPtr mImageView = nullptr;
+    grfx::ImagePtr            mImage       = nullptr;
+    grfx::SampledImageViewPtr mImageView   = nullptr;
+    bool                      mPlaceholder = false;
+    scene::ImageRef           mArrayImage  = nullptr;
+    uint32_t                  mArrayLayer  = 0;
 };
 
 // -------------------------------------------------------------------------------------------------
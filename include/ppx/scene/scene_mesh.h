@@ -17,8 +17,12 @@
 
 #include "ppx/scene/scene_config.h"
 #include "ppx/scene/scene_resource_manager.h"
+#include "ppx/mesh_optimizer.h"
 
 namespace ppx {
+
+class Camera;
+
 namespace scene {
 
 // Mesh Data
@@ -36,19 +40,51 @@ class MeshData
     : public grfx::NamedObjectTrait
 {
 public:
+    // Vertices are in the layout of quantization, compact positions are
+    // decoded with dequantization.
+    MeshData(
+        const scene::VertexAttributeFlags& availableVertexAttributes,
+        grfx::Buffer*                      pGpuBuffer,
+        scene::VertexQuantization          quantization   = scene::VERTEX_QUANTIZATION_NONE,
+        const scene::VertexDequantization& dequantization = {});
+
+    // Geometry lives in a range of pBufferPool, the range is freed
+    // back to the pool on destruction.
     MeshData(
         const scene::VertexAttributeFlags& availableVertexAttributes,
-        grfx::Buffer*                      pGpuBuffer);
+        grfx::BufferPool*                  pBufferPool,
+        const grfx::BufferRange&           gpuBufferRange,
+        scene::VertexQuantization          quantization   = scene::VERTEX_QUANTIZATION_NONE,
+        const scene::VertexDequantization& dequantization = {});
+
     virtual ~MeshData();
 
     const scene::VertexAttributeFlags&      GetAvailableVertexAttributes() const { return mAvailableVertexAttributes; }
     const std::vector<grfx::VertexBinding>& GetAvailableVertexBindings() const { return mVertexBindings; }
     grfx::Buffer*                           GetGpuBuffer() const { return mGpuBuffer.Get(); }
+    scene::VertexQuantization               GetVertexQuantization() const { return mVertexQuantization; }
+    const scene::VertexDequantization&      GetVertexDequantization() const { return mVertexDequantization; }
+
+    // Offset of the geometry data in GetGpuBuffer(), non-zero for pooled mesh data
+    uint64_t GetGpuBufferOffset() const { return mGpuBufferRange.offset; }
+    // Bytes of GPU memory used by the geometry data
+    uint64_t GetGpuBufferSize() const;
+
+    // LODs of the batches built from the geometry by batch index, so meshes
+    // that share the mesh data share them. Empty if there are no LODs.
+    const std::vector<std::vector<ppx::MeshLod>>& GetBatchLods() const { return mBatchLods; }
+    void                                          SetBatchLods(std::vector<std::vector<ppx::MeshLod>>&& lods) { mBatchLods = std::move(lods); }
 
 private:
     scene::VertexAttributeFlags      mAvailableVertexAttributes = {};
     std::vector<grfx::VertexBinding> mVertexBindings;
+    scene::VertexQuantization        mVertexQuantization   = scene::VERTEX_QUANTIZATION_NONE;
+    scene::VertexDequantization      mVertexDequantization = {};
     grfx::BufferPtr                  mGpuBuffer;
+    grfx::BufferPool*                mBufferPool     = nullptr;
+    grfx::BufferRange                mGpuBufferRange = {};
+
+    std::vector<std::vector<ppx::MeshLod>> mBatchLods;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -60,6 +96,10 @@ private:
 // counts correspond to the graphics API's draw call. Bounding box
 // can be used by renderer.
 //
+// Batches loaded with LODs have all of them in their index buffer view,
+// GetIndexCount() is LOD 0's count. A LOD is drawn with its index range
+// and the batch's vertex buffers.
+//
 class PrimitiveBatch
 {
 public:
@@ -72,7 +112,8 @@ public:
         const grfx::VertexBufferView& attributeBufferView,
         uint32_t                      indexCount,
         uint32_t                      vertexCount,
-        const ppx::AABB&              boundingBox);
+        const ppx::AABB&              boundingBox,
+        const grfx::VertexBufferView& skinBufferView = {});
 
     ~PrimitiveBatch() = default;
 
@@ -84,16 +125,46 @@ public:
     uint32_t                      GetIndexCount() const { return mIndexCount; }
     uint32_t                      GetVertexCount() const { return mVertexCount; }
 
+    // Joints and weights of skinned vertices, see scene::kVertexSkinDataSize.
+    // Only set for skinned VERTEX_QUANTIZATION_NONE geometry.
+    const grfx::VertexBufferView& GetSkinBufferView() const { return mSkinBufferView; }
+    bool                          IsSkinned() const { return !IsNull(mSkinBufferView.pBuffer); }
+
+    // LOD 0 is the full detail geometry, batches built without LODs only have it
+    uint32_t            GetLodCount() const { return CountU32(mLods); }
+    const ppx::MeshLod& GetLod(uint32_t index) const { return mLods[index]; }
+    void                SetLods(const std::vector<ppx::MeshLod>& lods);
+
+    // Returns the coarsest LOD whose error projects to at most maxPixelError
+    // pixels, see scene::CalculateLodPixelsPerUnit()
+    uint32_t SelectLod(float pixelsPerUnit, float maxPixelError) const;
+
+    // Triangle geometry for bottom level acceleration structure builds, the
+    // mesh data needs to be loaded with acceleration structure input usage.
+    grfx::AccelerationStructureTriangles GetAccelerationStructureTriangles() const;
+
 private:
     scene::MaterialRef     mMaterial            = nullptr;
     grfx::IndexBufferView  mIndexBufferView     = {};
     grfx::VertexBufferView mPositionBufferView  = {};
     grfx::VertexBufferView mAttributeBufferView = {};
+    grfx::VertexBufferView mSkinBufferView      = {};
     uint32_t               mIndexCount          = 0;
     uint32_t               mVertexCount         = 0;
     ppx::AABB              mBoundingBox         = {};
+
+    std::vector<ppx::MeshLod> mLods;
 };
 
+// Projected size in pixels of one mesh space unit at the point of the
+// mesh's world space bounding sphere closest to the camera. Uses the
+// vertical scale of the camera's projection, viewportHeight is in pixels.
+float CalculateLodPixelsPerUnit(
+    const float4x4&    modelMatrix,
+    const ppx::AABB&   boundingBox,
+    const ppx::Camera& camera,
+    float              viewportHeight);
+
 // -------------------------------------------------------------------------------------------------
 
 // Mesh
@@ -137,6 +208,9 @@ public:
 
     std::vector<const scene::Material*> GetMaterials() const;
 
+    // One geometry per batch, see PrimitiveBatch::GetAccelerationStructureTriangles().
+    std::vector<grfx::AccelerationStructureTriangles> GetAccelerationStructureTriangles() const;
+
 private:
     std::unique_ptr<scene::ResourceManager> mResourceManager = nullptr;
     scene::MeshDataRef                      mMeshData        = nullptr;
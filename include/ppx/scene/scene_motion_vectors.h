@@ -0,0 +1,122 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_motion_vectors_h
+#define ppx_scene_motion_vectors_h
+
+#include "ppx/scene/scene_config.h"
+#include "ppx/camera.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <array>
+#include <unordered_map>
+
+namespace ppx {
+namespace scene {
+
+struct MotionVectorRendererCreateInfo
+{
+    grfx::ShaderModule* pVertexShader = nullptr;                         // scene_renderer/shaders/MotionVectors.vs, or MotionVectorsMultiView.vs
+    grfx::ShaderModule* pPixelShader  = nullptr;                         // scene_renderer/shaders/MotionVectors.ps
+    grfx::Format        colorFormat   = grfx::FORMAT_R16G16B16A16_FLOAT; // XrComponent::GetMotionVectorFormat()
+    grfx::Format        depthFormat   = grfx::FORMAT_D32_FLOAT;          // XrComponent::GetDepthFormat()
+    uint32_t            viewMask      = 0;                               // Multiview view mask, with MotionVectorsMultiView.vs
+    uint32_t            maxDraws      = 4096;                            // Draw() calls per frame
+};
+
+// Motion Vector Renderer
+//
+// Draws the motion vectors of mesh nodes from their evaluated matrices of
+// the previous and the current frame, and the cameras of both frames, for
+// XR_FB_space_warp's motion vector swapchains. Nodes drawn for the first
+// time have no motion of their own. Skinned vertices only move with their
+// node.
+//
+// Per frame:
+//   BeginFrame();
+//   SetCamera(viewIndex, camera); // For each view
+//   ...begin a render pass on the motion vector and depth images...
+//   Draw(pCmd, pNode);            // For each node
+//
+// Meshes must be loaded with VERTEX_QUANTIZATION_NONE. Draw parameters are
+// written to CPU visible memory, so only one frame can be in flight on the
+// GPU at a time.
+//
+class MotionVectorRenderer
+{
+public:
+    MotionVectorRenderer();
+    virtual ~MotionVectorRenderer();
+
+    static ppx::Result Create(grfx::Device* pDevice, const scene::MotionVectorRendererCreateInfo& createInfo, scene::MotionVectorRenderer** ppRenderer);
+
+    // The matrices of the current frame become the previous ones
+    void BeginFrame();
+
+    // viewIndex must be less than MAX_VIEWS
+    void SetCamera(uint32_t viewIndex, const ppx::Camera& camera);
+
+    // Records the draws of the node's mesh batches
+    void Draw(grfx::CommandBuffer* pCmd, const scene::MeshNode* pNode);
+
+private:
+    static const uint32_t MAX_VIEWS = 2;
+
+    // Must match MotionVectors.hlsl
+    struct ViewMatrices
+    {
+        float4x4 viewProjectionMatrix[MAX_VIEWS];
+        float4x4 prevViewProjectionMatrix[MAX_VIEWS];
+    };
+
+    struct InstanceMatrices
+    {
+        float4x4 modelMatrix;
+        float4x4 prevModelMatrix;
+    };
+
+    struct NodeMatrices
+    {
+        float4x4 current;
+        float4x4 previous;
+        uint64_t frame = 0; // When current was last updated
+    };
+
+    ppx::Result InitializeResources(grfx::Device* pDevice, const scene::MotionVectorRendererCreateInfo& createInfo);
+
+private:
+    grfx::Device*                                            mDevice   = nullptr;
+    uint32_t                                                 mMaxDraws = 0;
+    grfx::DescriptorPoolPtr                                  mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr                             mSetLayout;
+    grfx::DescriptorSetPtr                                   mSet;
+    grfx::PipelineInterfacePtr                               mInterface;
+    grfx::GraphicsPipelinePtr                                mPipeline;
+    grfx::BufferPtr                                          mViewBuffer;
+    grfx::BufferPtr                                          mInstanceBuffer;
+    ViewMatrices*                                            mViewMappedAddress     = nullptr;
+    InstanceMatrices*                                        mInstanceMappedAddress = nullptr;
+    std::array<bool, MAX_VIEWS>                              mViewsSet              = {};
+    uint64_t                                                 mFrame                 = 0;
+    uint32_t                                                 mDrawCount             = 0;
+    std::unordered_map<const scene::MeshNode*, NodeMatrices> mNodeMatrices;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_motion_vectors_h
@@ -63,6 +63,8 @@ public:
     virtual void SetScale(const float3& scale) override;
     virtual void SetRotationOrder(Transform::RotationOrder rotationOrder) override;
 
+    // Returns the world matrix. Nodes added to a scene read it from the
+    // scene's scene::TransformHierarchy, updating it if it's dirty.
     const float4x4& GetEvaluatedMatrix() const;
 
     scene::Node* GetParent() const { return mParent; }
@@ -80,17 +82,21 @@ public:
     scene::Node* RemoveChild(const scene::Node* pChild);
 
 private:
+    friend class scene::TransformHierarchy;
+
     void SetParent(scene::Node* pNewParent);
     void SetEvaluatedDirty();
 
 private:
-    scene::Scene*             mScene           = nullptr;
-    bool                      mVisible         = true;
-    mutable ppx::Transform    mTransform       = {};
-    mutable float4x4          mEvaluatedMatrix = float4x4(1);
-    mutable bool              mEvaluatedDirty  = false;
-    scene::Node*              mParent          = nullptr;
-    std::vector<scene::Node*> mChildren        = {};
+    scene::Scene*              mScene           = nullptr;
+    bool                       mVisible         = true;
+    mutable ppx::Transform     mTransform       = {};
+    mutable float4x4           mEvaluatedMatrix = float4x4(1);
+    mutable bool               mEvaluatedDirty  = false;
+    scene::Node*               mParent          = nullptr;
+    std::vector<scene::Node*>  mChildren        = {};
+    scene::TransformHierarchy* mHierarchy       = nullptr;
+    uint32_t                   mHierarchyIndex  = UINT32_MAX;
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -117,8 +123,17 @@ public:
 
     void SetMesh(const scene::MeshRef& mesh);
 
+    // Skinned mesh nodes blend their vertices between the skin's joints
+    const scene::Skin* GetSkin() const { return mSkin; }
+    void               SetSkin(const scene::Skin* pSkin) { mSkin = pSkin; }
+
+    const std::vector<float>& GetMorphWeights() const { return mMorphWeights; }
+    void                      SetMorphWeights(const std::vector<float>& weights) { mMorphWeights = weights; }
+
 private:
-    scene::MeshRef mMesh = nullptr;
+    scene::MeshRef     mMesh         = nullptr;
+    const scene::Skin* mSkin         = nullptr;
+    std::vector<float> mMorphWeights = {};
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -0,0 +1,118 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_occlusion_predicates_h
+#define ppx_scene_occlusion_predicates_h
+
+#include "ppx/scene/scene_config.h"
+#include "ppx/bounding_volume.h"
+#include "ppx/camera.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/grfx/grfx_query.h"
+
+#include <array>
+
+namespace ppx {
+namespace scene {
+
+struct OcclusionPredicatesCreateInfo
+{
+    grfx::ShaderModule* pProxyShader   = nullptr;                       // basic/shaders/OcclusionProxy.vs
+    uint32_t            maxObjectCount = 1024;                          // Objects passed to SetObjects()
+    grfx::Format        colorFormat    = grfx::FORMAT_UNDEFINED;        // Render target of the pass DrawProxies() is recorded in, UNDEFINED if it has none
+    grfx::Format        depthFormat    = grfx::FORMAT_D32_FLOAT;        // Depth of the pass DrawProxies() is recorded in
+    grfx::CompareOp     depthCompareOp = grfx::COMPARE_OP_LESS_OR_EQUAL; // GREATER_OR_EQUAL for reversed depth
+};
+
+// Occlusion Predicates
+//
+// Skips the draws of occluded objects on the GPU with conditional rendering
+// (D3D12 predication), without reading occlusion results back on the CPU.
+// Each object's bounding box is drawn with an occlusion query and no color
+// or depth writes after the scene; the next frame resolves the queries into
+// predicates and wraps the object's draws in BeginObject()/EndObject(), so
+// they're skipped if no sample of the box passed the depth test. Visibility
+// is one frame late: objects that become visible pop in a frame after.
+//
+// Per frame:
+//   BeginFrame(pCmd, camera); // Outside of a render pass
+//   ...begin the scene's render pass...
+//   BeginObject(pCmd, i);     // For each object
+//   ...draw object i...
+//   EndObject(pCmd);
+//   DrawProxies(pCmd);
+//
+// Objects are drawn unconditionally in the first frame after SetObjects(),
+// and while the eye is inside their bounds, where the near plane would clip
+// their box. Worth it for large objects only, the proxy draw and the query
+// cost about as much as drawing a small object.
+//
+// Queries are reset on the CPU, so only one frame can be in flight on the
+// GPU at a time. Requires grfx::Device::ConditionalRenderingSupported().
+//
+class OcclusionPredicates
+{
+public:
+    OcclusionPredicates();
+    virtual ~OcclusionPredicates();
+
+    static ppx::Result Create(grfx::Device* pDevice, const scene::OcclusionPredicatesCreateInfo& createInfo, scene::OcclusionPredicates** ppPredicates);
+
+    // World space bounds of each object, objects are indexed in order
+    ppx::Result SetObjects(uint32_t count, const ppx::AABB* pBounds);
+    uint32_t    GetObjectCount() const { return CountU32(mObjectBounds); }
+
+    // Resolves the previous frame's queries into predicates and resets the
+    // queries of this frame, which are drawn from camera. Must be recorded
+    // outside of a render pass.
+    void BeginFrame(grfx::CommandBuffer* pCmd, const ppx::Camera& camera);
+
+    // Draws recorded until EndObject() are skipped if the object was
+    // occluded in the previous frame. Must not be nested.
+    void BeginObject(grfx::CommandBuffer* pCmd, uint32_t objectIndex);
+    void EndObject(grfx::CommandBuffer* pCmd);
+
+    // Draws the bounding box of every object with its occlusion query.
+    // Must be recorded after the occluders in the render pass, binds a
+    // pipeline and push constants of its own.
+    void DrawProxies(grfx::CommandBuffer* pCmd);
+
+    // BeginObject() calls of this frame that made draws conditional
+    uint32_t GetPredicatedCount() const { return mPredicatedCount; }
+
+private:
+    ppx::Result InitializeResources(grfx::Device* pDevice, const scene::OcclusionPredicatesCreateInfo& createInfo);
+
+private:
+    grfx::Device*                 mDevice               = nullptr;
+    uint32_t                      mMaxObjectCount       = 0;
+    uint32_t                      mFrame                = 0; // Frames since SetObjects()
+    uint32_t                      mPredicatedCount      = 0;
+    bool                          mConditional          = false; // Between BeginObject() and EndObject()
+    float3                        mEyePosition          = float3(0);
+    float                         mNearClip             = 0;
+    float4x4                      mViewProjectionMatrix = float4x4(1);
+    std::vector<ppx::AABB>        mObjectBounds;
+    grfx::PipelineInterfacePtr    mInterface;
+    grfx::GraphicsPipelinePtr     mProxyPipeline;
+    std::array<grfx::QueryPtr, 2> mQueries; // Written in alternate frames
+    grfx::BufferPtr               mPredicateBuffer;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_occlusion_predicates_h
@@ -46,22 +46,27 @@ struct CameraParams
     float    farDepth;             // offset = 92
 };
 
-// size = 128
+// size = 160
 struct InstanceParams
 {
-    float4x4 modelMatrix;        // offset = 0
-    float4x4 inverseModelMatrix; // offset = 64
+    float4x4 modelMatrix;           // offset = 0
+    float4x4 inverseModelMatrix;    // offset = 64
+    float3   positionDequantScale;  // offset = 128, see VertexDequantization
+    float    padding0;              // offset = 140
+    float3   positionDequantOffset; // offset = 144
+    float    padding1;              // offset = 156
 };
 
-// size = 24
+// size = 28
 struct MaterialTextureParams
 {
     uint     textureIndex;      // offset = 0
     uint     samplerIndex;      // offset = 4
     float2x2 texCoordTransform; // offset = 8
+    uint     arrayLayer;        // offset = 24
 };
 
-// size = 164
+// size = 184
 struct MaterialParams
 {
     float4                       baseColorFactor;      // offset = 0
@@ -71,10 +76,10 @@ struct MaterialParams
     float3                       emissiveFactor;       // offset = 28
     float                        emissiveStrength;     // offset = 40
     scene::MaterialTextureParams baseColorTex;         // offset = 44
-    scene::MaterialTextureParams metallicRoughnessTex; // offset = 68
-    scene::MaterialTextureParams normalTex;            // offset = 92
-    scene::MaterialTextureParams occlusionTex;         // offset = 116
-    scene::MaterialTextureParams emssiveTex;           // offset = 140
+    scene::MaterialTextureParams metallicRoughnessTex; // offset = 72
+    scene::MaterialTextureParams normalTex;            // offset = 100
+    scene::MaterialTextureParams occlusionTex;         // offset = 128
+    scene::MaterialTextureParams emssiveTex;           // offset = 156
 };
 
 // -------------------------------------------------------------------------------------------------
@@ -100,6 +105,10 @@ public:
 
     static const uint32_t MAX_IBL_MAPS = 16;
 
+    // CameraParams per view, shaders compiled with ENABLE_MULTIVIEW index
+    // them with the view index
+    static const uint32_t MAX_VIEWS = 2;
+
     static const uint32_t FRAME_PARAMS_REGISTER            = 1;
     static const uint32_t CAMERA_PARAMS_REGISTER           = 2;
     static const uint32_t INSTANCE_PARAMS_REGISTER         = 3;
@@ -128,9 +137,9 @@ public:
     // Required size of structs that map to HLSL
     static const uint32_t FRAME_PARAMS_STRUCT_SIZE            = 8;
     static const uint32_t CAMERA_PARAMS_STRUCT_SIZE           = 96;
-    static const uint32_t INSTANCE_PARAMS_STRUCT_SIZE         = 128;
+    static const uint32_t INSTANCE_PARAMS_STRUCT_SIZE         = 160;
     static const uint32_t MATERIAL_TEXTURE_PARAMS_STRUCT_SIZE = 28;
-    static const uint32_t MATERIAL_PARAMS_STRUCT_SIZE         = 164;
+    static const uint32_t MATERIAL_PARAMS_STRUCT_SIZE         = 184;
 
     // ---------------------------------------------------------------------------------------------
 
@@ -143,23 +152,64 @@ public:
     grfx::DescriptorSetLayout* GetDescriptorSetLayout() const { return mDescriptorSetLayout.Get(); }
     grfx::DescriptorSet*       GetDescriptorSet() const { return mDescriptorSet.Get(); }
 
-    scene::FrameParams*  GetFrameParams() { return mFrameParamsAddress; }
-    scene::CameraParams* GetCameraParams() { return mCameraParamsAddress; }
-    void                 SetCameraParams(const ppx::Camera* pCamera);
-
+    // Params returned by the Get*Params() functions or written by the Set*()
+    // functions are marked as changed. CopyBuffers() only copies changed
+    // params, so avoid getting params that didn't change. Shaders without
+    // multiview only use the camera params of view 0.
+    scene::FrameParams*  GetFrameParams();
+    scene::CameraParams* GetCameraParams(uint32_t viewIndex = 0);
+    void                 SetCameraParams(const ppx::Camera* pCamera, uint32_t viewIndex = 0);
+
+    // Instance params start with identity position dequantization, meshes
+    // loaded with VERTEX_QUANTIZATION_COMPACT need theirs set with
+    // SetVertexDequantization().
     scene::InstanceParams* GetInstanceParams(uint32_t index);
+    void                   SetVertexDequantization(uint32_t index, const scene::VertexDequantization& dequantization);
     scene::MaterialParams* GetMaterialParams(uint32_t index);
 
+    // Device addresses of the GPU copies of the params written by
+    // CopyBuffers(), for shaders that take them in push constants instead
+    // of indexing the structured buffers. Returns 0 if the device doesn't
+    // support buffer device addresses.
+    uint64_t GetInstanceParamsDeviceAddress(uint32_t index) const;
+    uint64_t GetMaterialParamsDeviceAddress(uint32_t index) const;
+
     void SetIBLTextures(
         uint32_t                index,
         grfx::SampledImageView* pIrradiance,
         grfx::SampledImageView* pEnvironment);
 
+    // Replaces the default BRDF LUT, e.g. with one from grfx_util::CreateBRDFLUTTexture()
+    void SetBRDFLUTTexture(grfx::SampledImageView* pBRDFLUT);
+
     void SetMaterialSampler(uint32_t index, const scene::Sampler* pSampler);
     void SetMaterialTexture(uint32_t index, const scene::Image* pImage);
 
+    // Copies params changed since the last call from the CPU buffers to the
+    // GPU buffers, adjacent changed params are copied together.
     void CopyBuffers(grfx::CommandBuffer* pCmd);
 
+    // Bytes copied by the last CopyBuffers()
+    uint64_t GetCopiedByteCount() const { return mCopiedByteCount; }
+
+private:
+    // Changed entries of a params buffer
+    struct DirtyEntries
+    {
+        std::vector<uint8_t> flags = {};
+        uint32_t             count = 0;
+
+        void Mark(uint32_t index);
+        void MarkAll();
+    };
+
+    void CopyDirtyEntries(
+        grfx::CommandBuffer* pCmd,
+        uint32_t             entrySize,
+        grfx::Buffer*        pSrcBuffer,
+        grfx::Buffer*        pDstBuffer,
+        DirtyEntries&        dirtyEntries);
+
 private:
     ppx::Result InitializeDefaultObjects(grfx::Device* pDevice);
     ppx::Result InitializeDescriptorSet(grfx::Device* pDevice);
@@ -195,6 +245,11 @@ protected:
     char* mInstanceParamsMappedAddress = nullptr;
     char* mMaterialParamsMappedAddress = nullptr;
 
+    bool         mConstantParamsDirty = true;
+    DirtyEntries mDirtyInstances      = {};
+    DirtyEntries mDirtyMaterials      = {};
+    uint64_t     mCopiedByteCount     = 0;
+
     ppx::grfx::SamplerPtr mDefaultSampler; // Nearest, repeats
     ppx::grfx::TexturePtr mDefaultTexture; // Purple texture
 
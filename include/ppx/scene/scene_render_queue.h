@@ -0,0 +1,85 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_render_queue_h
+#define ppx_scene_render_queue_h
+
+#include "ppx/scene/scene_config.h"
+
+namespace ppx {
+
+namespace grfx {
+class GraphicsPipeline;
+} // namespace grfx
+
+namespace scene {
+
+class PrimitiveBatch;
+
+// Render Queue
+//
+// Draws of primitive batches sorted by a 64-bit key so consecutive draws
+// share as much state as possible. From most to least significant, the key
+// holds the pipeline, the material, the mesh and the quantized depth:
+//
+//   [63:52] pipeline index, 12 bits
+//   [51:36] material index, 16 bits
+//   [35:16] mesh index,     20 bits
+//   [15:0]  depth,          16 bits
+//
+// Indices are wrapped to their bit count, so they only need to be unique
+// among the draws of a frame. Depth is in [0, 1], 0 draws first. Sort() is
+// an LSD radix sort that skips the bytes all keys share, so it's linear in
+// the draw count.
+//
+class RenderQueue
+{
+public:
+    struct Draw
+    {
+        uint64_t                     sortKey       = 0;
+        const scene::PrimitiveBatch* pBatch        = nullptr;
+        grfx::GraphicsPipeline*      pPipeline     = nullptr;
+        uint32_t                     materialIndex = 0;
+        uint32_t                     firstInstance = 0;
+        uint32_t                     instanceCount = 1;
+        uint32_t                     lod           = 0; // Index of the batch LOD to draw
+    };
+
+    RenderQueue() {}
+    ~RenderQueue() {}
+
+    static uint64_t MakeSortKey(uint32_t pipelineIndex, uint32_t materialIndex, uint32_t meshIndex, float depth);
+
+    // Keeps the allocations for the next frame
+    void Clear();
+
+    void Add(const Draw& draw) { mDraws.push_back(draw); }
+
+    void Sort();
+
+    uint32_t GetDrawCount() const { return CountU32(mDraws); }
+    // Returns the draw at index in sorted order, only valid after Sort()
+    const Draw& GetDraw(uint32_t index) const { return mDraws[mOrder[index]]; }
+
+private:
+    std::vector<Draw>     mDraws;
+    std::vector<uint32_t> mOrder;
+    std::vector<uint32_t> mScratch;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_render_queue_h
@@ -40,9 +40,32 @@ namespace scene {
 // If afterwards a shared object has an external reference, the code holding
 // the reference is responsible for the shared objct.
 //
+// Objects are held until DestroyAll() unless EvictUnreferenced() is called,
+// which drops the least recently found or cached objects that nothing else
+// references until the GPU memory of images and mesh data fits the budget.
+//
 class ResourceManager
 {
 public:
+    enum ObjectType
+    {
+        OBJECT_TYPE_SAMPLER   = 0,
+        OBJECT_TYPE_IMAGE     = 1,
+        OBJECT_TYPE_TEXTURE   = 2,
+        OBJECT_TYPE_MATERIAL  = 3,
+        OBJECT_TYPE_MESH_DATA = 4,
+        OBJECT_TYPE_MESH      = 5,
+    };
+
+    struct ResidentObject
+    {
+        ObjectType  type       = OBJECT_TYPE_SAMPLER;
+        uint64_t    objectId   = 0;
+        std::string name       = "";
+        uint64_t    gpuBytes   = 0;
+        bool        referenced = false; // Referenced outside the resource manager
+    };
+
     ResourceManager();
     virtual ~ResourceManager();
 
@@ -70,6 +93,27 @@ public:
 
     void DestroyAll();
 
+    // GPU memory used by cached images and mesh data, other objects count as 0
+    uint64_t GetResidentBytes() const;
+
+    // Default budget is unlimited, 0 makes EvictUnreferenced() evict every
+    // unreferenced object
+    void     SetMemoryBudget(uint64_t bytes) { mMemoryBudget = bytes; }
+    uint64_t GetMemoryBudget() const { return mMemoryBudget; }
+
+    // Evicts unreferenced objects, least recently used first, until the
+    // resident bytes fit the memory budget. Objects that only become
+    // unreferenced by an eviction, like the images of an evicted texture,
+    // are candidates too. The GPU must be done with the evicted objects.
+    // Returns the number of evicted objects.
+    uint32_t EvictUnreferenced();
+
+    // Returns all cached objects, largest first
+    std::vector<ResidentObject> GetResidentObjects() const;
+
+    // Logs per type counts and bytes, and the largest objects
+    void LogResidentReport(uint32_t maxObjectCount = 10) const;
+
     const std::unordered_map<uint64_t, scene::SamplerRef>&  GetSamplers() const;
     const std::unordered_map<uint64_t, scene::ImageRef>&    GetImages() const;
     const std::unordered_map<uint64_t, scene::TextureRef>&  GetTextures() const;
@@ -89,7 +133,8 @@ private:
             return false;
         }
 
-        outObject = (*it).second;
+        outObject                 = (*it).second;
+        mLastUse[outObject.get()] = ++mUseCounter;
         return true;
     }
 
@@ -111,7 +156,8 @@ private:
             return ppx::ERROR_DUPLICATE_ELEMENT;
         }
 
-        container[objectId] = object;
+        container[objectId]    = object;
+        mLastUse[object.get()] = ++mUseCounter;
 
         return ppx::SUCCESS;
     }
@@ -123,6 +169,11 @@ private:
     std::unordered_map<uint64_t, scene::MaterialRef> mMaterials;
     std::unordered_map<uint64_t, scene::MeshDataRef> mMeshData;
     std::unordered_map<uint64_t, scene::MeshRef>     mMeshes;
+
+    // Find() and Cache() stamp objects with an increasing counter
+    mutable std::unordered_map<const void*, uint64_t> mLastUse;
+    mutable uint64_t                                  mUseCounter   = 0;
+    uint64_t                                          mMemoryBudget = UINT64_MAX;
 };
 
 } // namespace scene
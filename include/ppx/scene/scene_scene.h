@@ -15,11 +15,14 @@
 #ifndef ppx_scene_graph_h
 #define ppx_scene_graph_h
 
+#include "ppx/scene/scene_animation.h"
+#include "ppx/scene/scene_bounding_volume_hierarchy.h"
 #include "ppx/scene/scene_config.h"
 #include "ppx/scene/scene_material.h"
 #include "ppx/scene/scene_mesh.h"
 #include "ppx/scene/scene_node.h"
 #include "ppx/scene/scene_resource_manager.h"
+#include "ppx/scene/scene_transform_hierarchy.h"
 
 namespace ppx {
 namespace scene {
@@ -28,6 +31,15 @@ namespace scene {
 template <typename ResObjT>
 using ResourceIndexMap = std::unordered_map<const ResObjT*, uint32_t>;
 
+// Mesh nodes that reference the same mesh. Each of the mesh's batches can
+// draw all of them with a single instanced draw, which also groups them by
+// material since a batch has one material.
+struct MeshInstanceGroup
+{
+    const scene::Mesh*                  pMesh = nullptr;
+    std::vector<const scene::MeshNode*> nodes = {};
+};
+
 // Scene Graph
 //
 // Basic scene graph designed to feed into a renderer. Manages nodes and all
@@ -35,13 +47,14 @@ using ResourceIndexMap = std::unordered_map<const ResObjT*, uint32_t>;
 // images, and samplers.
 //
 // See scene::ResourceManager for details on object sharing among the various
-// elements of the scene.
+// elements of the scene. Scenes can share a resource manager, the object
+// counts and lists then cover all of its scenes.
 //
 class Scene
     : public grfx::NamedObjectTrait
 {
 public:
-    Scene(std::unique_ptr<scene::ResourceManager>&& resourceManager);
+    Scene(std::shared_ptr<scene::ResourceManager> resourceManager);
 
     virtual ~Scene() = default;
 
@@ -95,6 +108,39 @@ public:
 
     ppx::Result AddNode(scene::NodeRef&& node);
 
+    // Updates the world matrices of all nodes that changed since the last
+    // update, call once per frame after animating nodes. threadCount greater
+    // than 1 lets large hierarchies update in parallel.
+    void UpdateTransforms(uint32_t threadCount = 1) { mTransformHierarchy.UpdateWorldMatrices(threadCount); }
+
+    // Returns world matrices of all nodes in update order
+    const scene::TransformHierarchy& GetTransformHierarchy() const { return mTransformHierarchy; }
+
+    // Refits the bounding volume hierarchy of the mesh nodes to their
+    // current world matrices, rebuilding it if mesh nodes were added. Call
+    // after UpdateTransforms().
+    void UpdateBoundingVolumeHierarchy() { mBoundingVolumeHierarchy.Update(mMeshNodes); }
+
+    // Returns the bounding volume hierarchy as of the last update
+    const scene::BoundingVolumeHierarchy& GetBoundingVolumeHierarchy() const { return mBoundingVolumeHierarchy; }
+
+    // Returns the number of animations in the scene
+    uint32_t GetAnimationCount() const { return CountU32(mAnimations); }
+    // Returns the number of skins in the scene
+    uint32_t GetSkinCount() const { return CountU32(mSkins); }
+
+    // Returns the animation at index or NULL if idx is out of range
+    scene::Animation* GetAnimation(uint32_t index) const;
+    // Returns the skin at index or NULL if idx is out of range
+    const scene::Skin* GetSkin(uint32_t index) const;
+
+    ppx::Result AddAnimation(std::unique_ptr<scene::Animation>&& animation);
+    ppx::Result AddSkin(std::unique_ptr<scene::Skin>&& skin);
+
+    // Applies every animation at time seconds, each one looping over its own
+    // duration. Call before UpdateTransforms().
+    void ApplyAnimations(float time);
+
     // ---------------------------------------------------------------------------------------------
     // Get*ArrayIndexMap functions are used when populating resource and parameter
     // arguments for the shader. The return value of these functions are two parts:
@@ -107,11 +153,16 @@ public:
     // ---------------------------------------------------------------------------------------------
     // Returns an array of samplers and their index mappings
     scene::ResourceIndexMap<scene::Sampler> GetSamplersArrayIndexMap() const;
-    // Returns an array of images and their index mappings
+    // Returns an array of images and their index mappings, packed images
+    // map to the index of their texture array
     scene::ResourceIndexMap<scene::Image> GetImagesArrayIndexMap() const;
     // Returns an array of materials and their index mappings
     scene::ResourceIndexMap<scene::Material> GetMaterialsArrayIndexMap() const;
 
+    // Returns mesh nodes grouped by mesh, in order of each mesh's first
+    // mesh node. Mesh nodes without a mesh are skipped.
+    std::vector<scene::MeshInstanceGroup> GetMeshInstanceGroups() const;
+
 private:
     template <typename NodeT>
     NodeT* FindNodeByName(const std::string& name, const std::vector<NodeT*>& container) const
@@ -130,11 +181,18 @@ private:
     }
 
 private:
-    std::unique_ptr<scene::ResourceManager> mResourceManager = nullptr;
-    std::vector<scene::NodeRef>             mNodes           = {};
-    std::vector<scene::MeshNode*>           mMeshNodes       = {};
-    std::vector<scene::CameraNode*>         mCameraNodes     = {};
-    std::vector<scene::LightNode*>          mLightNodes      = {};
+    std::shared_ptr<scene::ResourceManager>        mResourceManager = nullptr;
+    std::vector<scene::NodeRef>                    mNodes           = {};
+    std::vector<scene::MeshNode*>                  mMeshNodes       = {};
+    std::vector<scene::CameraNode*>                mCameraNodes     = {};
+    std::vector<scene::LightNode*>                 mLightNodes      = {};
+    std::vector<std::unique_ptr<scene::Animation>> mAnimations      = {};
+    std::vector<std::unique_ptr<scene::Skin>>      mSkins           = {};
+
+    // Declared after mNodes so it's destroyed first
+    scene::TransformHierarchy mTransformHierarchy;
+
+    scene::BoundingVolumeHierarchy mBoundingVolumeHierarchy;
 };
 
 } // namespace scene
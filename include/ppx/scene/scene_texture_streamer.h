@@ -0,0 +1,146 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_texture_streamer_h
+#define ppx_scene_texture_streamer_h
+
+#include "ppx/scene/scene_config.h"
+#include "ppx/camera.h"
+#include "ppx/mipmap.h"
+#include "ppx/grfx/grfx_queue.h"
+#include "ppx/grfx/grfx_upload_batch.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace ppx {
+namespace scene {
+
+struct TextureStreamerCreateInfo
+{
+    uint64_t budgetBytes      = 512ull * 1024 * 1024; // Resident mip levels of all streamed images
+    uint32_t initialSize      = 128;                  // Images start with the mip levels no larger than this resident
+    uint64_t maxUploadBytes   = 16ull * 1024 * 1024;  // Uploads started per Update(), at least one image
+    uint32_t evictFrameCount  = 60;                   // Update() calls before levels that are no longer requested are dropped
+    uint32_t retireFrameCount = 3;                    // Update() calls before replaced images are destroyed, frames in flight
+};
+
+// Texture Streamer
+//
+// Keeps the full mip chain of each streamed image in CPU memory and only the
+// levels the renderer needs on the GPU. Images start with their smallest
+// levels, the ones no larger than initialSize. Each frame the renderer
+// requests a level for the images it draws, either per image with
+// RequestLevel() or from the projected size of the scene's mesh nodes with
+// RequestLevels(). Update() fits the requested levels into the budget,
+// dropping the finest level of the largest images first, and uploads the
+// images whose resident levels change on the transfer queue if the device
+// has one. Uploads don't block: an image is swapped into its scene::Image
+// by a later Update() once its upload has completed.
+//
+// Per frame:
+//   streamer->RequestLevels(*pScene, camera, height);
+//   streamer->Update(&changedCount); // Update material descriptors if changedCount > 0
+//
+// Streamed images are created by CreateImage(), the GLTF loader does this
+// for bitmap images if LoadOptions::SetTextureStreamer() was called. The
+// streamer must outlive its images' use on the GPU, images that are
+// destroyed are dropped by the next Update().
+//
+class TextureStreamer
+{
+public:
+    TextureStreamer();
+    virtual ~TextureStreamer();
+
+    static ppx::Result Create(grfx::Queue* pQueue, const scene::TextureStreamerCreateInfo& createInfo, scene::TextureStreamer** ppStreamer);
+
+    // Creates an image with the levels of mipmap no larger than initialSize
+    // resident and streams the other levels from mipmap.
+    ppx::Result CreateImage(std::unique_ptr<ppx::Mipmap> mipmap, scene::ImageRef& outImage);
+
+    // Requests level mipLevel of a streamed image for this frame, the
+    // finest level requested for an image wins. Other images are ignored.
+    void RequestLevel(const scene::Image* pImage, float mipLevel);
+
+    // Requests levels for the textures of each mesh node's materials from
+    // the size of the node's bounds on a viewport viewportHeight pixels
+    // high, assuming the texture covers the bounds once.
+    void RequestLevels(const scene::Scene& scene, const ppx::Camera& camera, uint32_t viewportHeight);
+
+    // Swaps in the images whose uploads have completed, then starts the
+    // uploads of the images whose resident levels change. pChangedCount
+    // receives the number of scene::Image objects whose image view changed,
+    // descriptors that use them need updating.
+    ppx::Result Update(uint32_t* pChangedCount = nullptr);
+
+    uint32_t GetImageCount() const { return static_cast<uint32_t>(mEntries.size()); }
+    uint64_t GetResidentBytes() const { return mResidentBytes; }
+    uint64_t GetBudgetBytes() const { return mCreateInfo.budgetBytes; }
+    uint32_t GetPendingUploadCount() const { return static_cast<uint32_t>(mUploads.size()); }
+
+    // Returns the first resident level of a streamed image, 0 for others
+    uint32_t GetResidentLevel(const scene::Image* pImage) const;
+
+private:
+    struct Entry
+    {
+        std::weak_ptr<scene::Image>  image;
+        std::unique_ptr<ppx::Mipmap> mipmap;
+        uint32_t                     coarsestLevel  = 0;          // First level of the initial image
+        uint32_t                     residentLevel  = 0;          // First level of the image on the GPU
+        uint32_t                     requestedLevel = UINT32_MAX; // Finest level requested this frame
+        uint32_t                     wantedLevel    = 0;          // Requested level that's kept until it's evicted
+        uint64_t                     wantedFrame    = 0;          // Frame wantedLevel was last requested in
+        bool                         uploading      = false;
+    };
+
+    struct Upload
+    {
+        const scene::Image*                pSceneImage   = nullptr; // Key of the entry
+        std::weak_ptr<scene::Image>        sceneImage;
+        uint32_t                           residentLevel = 0;
+        grfx::ImagePtr                     image         = nullptr;
+        grfx::SampledImageViewPtr          imageView     = nullptr;
+        std::unique_ptr<grfx::UploadBatch> batch         = nullptr;
+    };
+
+    struct RetiredImage
+    {
+        grfx::ImagePtr            image     = nullptr;
+        grfx::SampledImageViewPtr imageView = nullptr;
+        uint64_t                  frame     = 0; // Frame the image was replaced in
+    };
+
+    ppx::Result CreateResidentImage(const ppx::Mipmap& mipmap, uint32_t firstLevel, std::unique_ptr<grfx::UploadBatch>* pBatch, grfx::Image** ppImage, grfx::SampledImageView** ppImageView);
+    void        CompleteUploads(uint32_t* pChangedCount);
+    void        Retire(const grfx::ImagePtr& image, const grfx::SampledImageViewPtr& imageView);
+    void        DestroyRetired(bool all);
+
+    static uint64_t CalculateLevelsSize(const ppx::Mipmap& mipmap, uint32_t firstLevel);
+
+private:
+    grfx::Queue*                                   mQueue         = nullptr;
+    scene::TextureStreamerCreateInfo               mCreateInfo    = {};
+    uint64_t                                       mFrame         = 0; // Update() calls
+    uint64_t                                       mResidentBytes = 0;
+    std::unordered_map<const scene::Image*, Entry> mEntries;
+    std::vector<Upload>                            mUploads;
+    std::vector<RetiredImage>                      mRetiredImages;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_texture_streamer_h
@@ -0,0 +1,103 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_scene_transform_hierarchy_h
+#define ppx_scene_transform_hierarchy_h
+
+#include "ppx/scene/scene_config.h"
+
+namespace ppx {
+namespace scene {
+
+// Transform Hierarchy
+//
+// Flat store of the world matrices of a scene's nodes. Nodes are kept in
+// depth first order so parents come before their children and every subtree
+// is a contiguous range. Parent indices, local matrices, world matrices and
+// dirty flags are separate arrays, so updating the world matrices is a single
+// linear pass that only touches the nodes of dirty entries to read their
+// local matrix.
+//
+// Setting a node's transform only marks its own entry dirty, the pass
+// propagates it to the descendants. Adding or removing children rebuilds
+// the order on the next update. scene::Node::GetEvaluatedMatrix() updates
+// the hierarchy when something is dirty, calling UpdateWorldMatrices() once
+// per frame after animating nodes avoids doing it on the first read.
+//
+class TransformHierarchy
+{
+public:
+    TransformHierarchy() = default;
+    ~TransformHierarchy();
+
+    TransformHierarchy(const TransformHierarchy&)            = delete;
+    TransformHierarchy& operator=(const TransformHierarchy&) = delete;
+
+    // Returns the number of nodes, only valid after an update
+    uint32_t GetNodeCount() const { return CountU32(mNodes); }
+    // Returns node at index in update order, parents come before children
+    scene::Node* GetNode(uint32_t index) const { return mNodes[index]; }
+    // Returns world matrix of node at index
+    const float4x4& GetWorldMatrix(uint32_t index) const { return mWorldMatrices[index]; }
+
+    // Adds pNode, its parent and children are picked up on the next update
+    void AddNode(scene::Node* pNode);
+
+    // Updates the world matrices of dirty nodes. With threadCount greater
+    // than 1 independent subtrees of large hierarchies update in parallel.
+    void UpdateWorldMatrices(uint32_t threadCount = 1);
+
+private:
+    friend class scene::Node;
+
+    enum DirtyFlags : uint8_t
+    {
+        DIRTY_LOCAL = 0x1,
+        DIRTY_WORLD = 0x2,
+    };
+
+    struct Range
+    {
+        uint32_t begin = 0;
+        uint32_t end   = 0;
+    };
+
+    void SetLocalDirty(uint32_t index);
+    void SetTopologyDirty();
+    void Rebuild();
+    void UpdateRange(const Range& range);
+
+private:
+    std::vector<scene::Node*> mRegisteredNodes = {};
+    bool                      mTopologyDirty   = false;
+    bool                      mDirty           = false;
+
+    // Update order arrays, all indexed the same
+    std::vector<scene::Node*> mNodes         = {};
+    std::vector<uint32_t>     mParents       = {};
+    std::vector<float4x4>     mLocalMatrices = {};
+    std::vector<float4x4>     mWorldMatrices = {};
+    std::vector<uint8_t>      mDirtyFlags    = {};
+
+    // Entries before mSerialEnd update first, then the subtree ranges
+    // can update independently
+    uint32_t           mSerialEnd          = 0;
+    std::vector<Range> mSubtrees           = {};
+    bool               mHasExternalParents = false;
+};
+
+} // namespace scene
+} // namespace ppx
+
+#endif // ppx_scene_transform_hierarchy_h
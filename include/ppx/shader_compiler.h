@@ -0,0 +1,150 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef ppx_shader_compiler_h
+#define ppx_shader_compiler_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_enums.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ppx {
+
+struct ShaderCompilerCreateInfo
+{
+    grfx::Api                          api            = grfx::API_UNDEFINED;
+    std::filesystem::path              compilerPath   = {}; // DXC executable
+    std::filesystem::path              cacheDirectory = {}; // Compiled bytecode is kept here across runs, empty disables the cache
+    std::vector<std::filesystem::path> includeDirectories;
+    uint32_t                           threadCount    = 2;
+};
+
+struct ShaderDefine
+{
+    std::string name;
+    std::string value; // Empty defines name as 1
+};
+
+struct ShaderCompileInfo
+{
+    std::filesystem::path     sourcePath; // HLSL file
+    std::string               stage;      // "vs", "ps", "cs", ... as in the build, the entry point is <stage>main
+    std::vector<ShaderDefine> defines;
+};
+
+struct ShaderCompileResult
+{
+    Result            result = ppx::ERROR_FAILED;
+    std::vector<char> bytecode;
+    std::string       log;            // Compiler diagnostics
+    bool              cached = false; // Loaded from the cache directory
+};
+
+//! @class AsyncShaderCompile
+//!
+//! Handle to a compilation started by ShaderCompiler::CompileAsync().
+//!
+class AsyncShaderCompile
+{
+public:
+    AsyncShaderCompile() = default;
+
+    // Returns true if the handle refers to a compilation Wait() hasn't returned yet.
+    bool IsValid() const;
+    // Returns true once the compilation completed, Wait() won't block.
+    bool IsReady() const;
+    // Blocks until the compilation completes. Invalidates the handle.
+    ShaderCompileResult Wait();
+
+private:
+    friend class ShaderCompiler;
+
+    std::future<ShaderCompileResult> mFuture;
+};
+
+//! @class ShaderCompiler
+//!
+//! Compiles HLSL shaders at runtime, for permutations that weren't compiled
+//! by the build. DXC is run as a separate process with the same arguments
+//! cmake/ShaderCompile.cmake uses for the API, on the compiler's own worker
+//! threads, so several shaders compile at once without blocking the caller.
+//!
+//! Compiled bytecode is saved to the cache directory under a key that
+//! hashes the source, the files it includes with #include "...", the
+//! defines, the stage, the API and the compiler executable's size and
+//! modification time, so a run that asks for the same variant loads it
+//! from disk instead of compiling it again.
+//!
+//! Application::CreateShader() compiles with the application's compiler,
+//! see --shader-compiler-path.
+//!
+class ShaderCompiler
+{
+public:
+    ShaderCompiler();
+    virtual ~ShaderCompiler();
+
+    Result Initialize(const ShaderCompilerCreateInfo& createInfo);
+    //! Waits for the compilations in flight
+    void Shutdown();
+
+    bool IsInitialized() const { return !mThreads.empty(); }
+
+    //! Starts compiling on a worker thread and returns right away
+    AsyncShaderCompile CompileAsync(const ShaderCompileInfo& compileInfo);
+    //! Compiles on the calling thread
+    ShaderCompileResult Compile(const ShaderCompileInfo& compileInfo);
+
+    //! Arguments passed to the compiler, without the output and source files
+    std::vector<std::string> GetCompilerArguments(const ShaderCompileInfo& compileInfo) const;
+    //! Returns the cache key of the bytecode compileInfo compiles to
+    Result CalculateCacheKey(const ShaderCompileInfo& compileInfo, uint64_t* pKey) const;
+
+    //! Compilations run and bytecode loaded from the cache since initialization
+    uint32_t GetCompileCount() const { return mCompileCount; }
+    uint32_t GetCacheHitCount() const { return mCacheHitCount; }
+
+private:
+    std::filesystem::path GetCachePath(uint64_t key) const;
+    Result                RunCompiler(const ShaderCompileInfo& compileInfo, const std::filesystem::path& outputPath, std::string* pLog) const;
+    void                  ThreadMain();
+
+private:
+    ShaderCompilerCreateInfo mCreateInfo    = {};
+    uint64_t                 mCompilerHash  = 0; // Size and modification time of the compiler
+    std::atomic<uint32_t>    mCompileCount  = 0;
+    std::atomic<uint32_t>    mCacheHitCount = 0;
+    std::atomic<uint32_t>    mTempFileCount = 0; // Names the files of concurrent compilations
+
+    std::mutex                        mMutex;
+    std::condition_variable           mCondition;
+    std::deque<std::function<void()>> mTasks;
+    std::vector<std::thread>          mThreads;
+    bool                              mStop = false;
+};
+
+} // namespace ppx
+
+#endif // ppx_shader_compiler_h
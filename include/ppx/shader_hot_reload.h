@@ -0,0 +1,140 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_shader_hot_reload_h
+#define ppx_shader_hot_reload_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ppx {
+
+struct ShaderHotReloadCreateInfo
+{
+    grfx::Device* pDevice        = nullptr;
+    uint32_t      pollIntervalMs = 250; // Between checks of the watched files
+};
+
+//! @class ShaderHotReload
+//!
+//! Rebuilds pipelines when the shader binaries they were created from are
+//! recompiled, so shaders can be tuned without relaunching the application.
+//!
+//! Shader modules are associated with their file by TrackShaderModule(),
+//! which Application::CreateShader() calls. Watch() records the files of
+//! the stages of a pipeline, and a background thread polls their
+//! modification times. A file counts as changed once its time has been
+//! stable for a poll interval, so partially written files are skipped.
+//!
+//! Update() reloads the shaders of the pipelines that use a changed file
+//! and rebuilds them with the device's async pipeline API. Once a rebuild
+//! finishes, a later Update() replaces the watched pipeline pointer and
+//! defers the destruction of the old pipeline until the GPU is done with
+//! it. Call Update() between frames, before anything is recorded with the
+//! watched pipelines. Failed rebuilds are logged and keep the old pipeline.
+//!
+//! The pipeline interface of a watched pipeline must stay alive until it's
+//! unwatched.
+//!
+class ShaderHotReload
+{
+public:
+    ShaderHotReload();
+    virtual ~ShaderHotReload();
+
+    Result Initialize(const ShaderHotReloadCreateInfo& createInfo);
+    //! Stops watching, waits for rebuilds in flight and destroys their pipelines
+    void Shutdown();
+
+    bool IsInitialized() const { return !IsNull(mDevice); }
+
+    //! Associates pModule with the file its bytecode was loaded from
+    void TrackShaderModule(const grfx::ShaderModule* pModule, const std::filesystem::path& filePath);
+
+    //! Rebuilds *ppPipeline when the file of one of its stages changes. The
+    //! shader modules of all of its stages must have been tracked.
+    Result Watch(grfx::GraphicsPipelinePtr* ppPipeline);
+    Result Watch(grfx::ComputePipelinePtr* ppPipeline);
+    //! Stops rebuilding *ppPipeline, e.g. before destroying it
+    void Unwatch(const void* ppPipeline);
+
+    //! Starts rebuilds for changed files and swaps in finished ones
+    void Update();
+
+    //! Returns the number of pipelines swapped in since initialization
+    uint32_t GetReloadCount() const { return mReloadCount; }
+
+private:
+    struct FileState
+    {
+        std::filesystem::file_time_type time;
+        std::filesystem::file_time_type pendingTime; // Seen once, reported once stable
+        bool                            pending  = false;
+        uint32_t                        refCount = 0; // Watches using the file
+    };
+
+    struct WatchEntry
+    {
+        grfx::GraphicsPipelinePtr*         ppGraphicsPipeline = nullptr;
+        grfx::ComputePipelinePtr*          ppComputePipeline  = nullptr;
+        grfx::GraphicsPipelineCreateInfo   graphicsCreateInfo = {};
+        grfx::ComputePipelineCreateInfo    computeCreateInfo  = {};
+        std::vector<std::filesystem::path> stageFiles; // Parallel to GetStages(), empty if unused
+        bool                               dirty = false;
+
+        // Rebuild in flight
+        std::vector<grfx::ShaderModulePtr> modules;
+        grfx::AsyncGraphicsPipeline        graphicsPipeline;
+        grfx::AsyncComputePipeline         computePipeline;
+
+        bool IsRebuilding() const { return graphicsPipeline.IsValid() || computePipeline.IsValid(); }
+    };
+
+    static std::vector<grfx::ShaderStageInfo*> GetStages(WatchEntry& entry);
+
+    Result AddWatch(std::unique_ptr<WatchEntry> entry);
+    void   RemoveWatch(WatchEntry& entry);
+    Result StartRebuild(WatchEntry& entry);
+    // Swaps the rebuilt pipeline in if it's ready, or waits for it and destroys it if discard is true
+    void FinishRebuild(WatchEntry& entry, bool discard);
+
+    void PollThreadMain();
+
+private:
+    grfx::Device* mDevice         = nullptr;
+    uint32_t      mPollIntervalMs = 0;
+    uint32_t      mReloadCount    = 0;
+
+    std::vector<std::unique_ptr<WatchEntry>> mWatches;
+
+    // Shared with the poll thread
+    std::mutex                                                 mMutex;
+    std::unordered_map<const grfx::ShaderModule*, std::string> mModuleFiles;
+    std::unordered_map<std::string, FileState>                 mFiles;
+    std::vector<std::string>                                   mChangedFiles;
+    std::thread                                                mPollThread;
+    std::condition_variable                                    mStopCondition;
+    bool                                                       mStop = false;
+};
+
+} // namespace ppx
+
+#endif // ppx_shader_hot_reload_h
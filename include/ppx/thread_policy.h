@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_thread_policy_h
+#define ppx_thread_policy_h
+
+#include "ppx/config.h"
+
+#include <string>
+#include <vector>
+
+// Thread affinity and priority per thread role
+//
+// Threads look up the policy of their role when they start, see
+// ApplyThreadPolicy(), so policies only apply to threads started after
+// they were set. The Application sets them from --thread-affinity and
+// --thread-priority before Setup() and applies the render policy to the
+// main thread.
+//
+// Core types are told apart by their max frequency, read from cpufreq on
+// Linux and Android: big.LITTLE and hybrid x86 cores differ in it, while
+// CPUID and /proc/cpuinfo only describe the core the reader runs on.
+//
+namespace ppx {
+
+enum CoreType
+{
+    CORE_TYPE_ANY    = 0,
+    CORE_TYPE_BIG    = 1, // Cores with the highest max frequency
+    CORE_TYPE_LITTLE = 2, // Cores with the lowest max frequency
+};
+
+// Values avoid the names of the THREAD_PRIORITY_* macros of Windows.h
+enum ThreadPriority
+{
+    THREAD_PRIORITY_DEFAULT = 0,
+    THREAD_PRIORITY_LOW     = 1,
+    THREAD_PRIORITY_HIGH    = 2, // Usually allowed for unprivileged processes on Android and Windows only
+    THREAD_PRIORITY_URGENT  = 3,
+};
+
+enum ThreadRole
+{
+    THREAD_ROLE_RENDER     = 0, // The main thread, records and submits frames
+    THREAD_ROLE_GAME       = 1, // Update() with ApplicationSettings::pipelinedUpdate
+    THREAD_ROLE_LOADER     = 2, // Blocking reads of fs::load_file_async()
+    THREAD_ROLE_JOB_WORKER = 3, // JobSystem workers
+    THREAD_ROLE_COUNT      = 4,
+};
+
+struct ThreadPolicy
+{
+    std::vector<uint32_t> cpus;                               // Empty runs on any core
+    ThreadPriority        priority = THREAD_PRIORITY_DEFAULT; // DEFAULT leaves the priority alone
+};
+
+//! Returns the cores of a type, empty for CORE_TYPE_ANY, on homogeneous
+//! CPUs and where the frequencies can't be read
+std::vector<uint32_t> GetCoreTypeCpus(CoreType type);
+
+//! @brief Parses "any", "big", "little" or a CPU list like "0-3,6".
+//!        "big" and "little" parse to an empty set on homogeneous CPUs.
+Result ParseCpuSet(const std::string& spec, std::vector<uint32_t>* pCpus);
+
+//! Parses "default", "low", "high" or "urgent"
+Result ParseThreadPriority(const std::string& name, ThreadPriority* pPriority);
+
+//! @brief Parses the --thread-affinity and --thread-priority knobs:
+//!        role=value pairs separated by ';', like "render=big;jobs=0-3,6"
+//!        and "render=high;loader=low". Roles are named like
+//!        GetThreadRoleName(). pPolicies has THREAD_ROLE_COUNT elements,
+//!        roles that aren't listed keep their policy.
+Result ParseThreadPolicies(const std::string& affinity, const std::string& priority, ThreadPolicy* pPolicies);
+
+const char* GetThreadRoleName(ThreadRole role);
+const char* GetThreadPriorityName(ThreadPriority priority);
+
+Result SetCurrentThreadAffinity(const std::vector<uint32_t>& cpus);
+Result SetCurrentThreadPriority(ThreadPriority priority);
+
+void         SetThreadPolicy(ThreadRole role, const ThreadPolicy& policy);
+ThreadPolicy GetThreadPolicy(ThreadRole role);
+
+//! Applies the policy of role to the calling thread, parts that fail are
+//! logged and skipped
+void ApplyThreadPolicy(ThreadRole role);
+
+} // namespace ppx
+
+#endif // ppx_thread_policy_h
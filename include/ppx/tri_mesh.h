@@ -17,9 +17,11 @@
 
 #include "ppx/config.h"
 #include "ppx/math_config.h"
+#include "ppx/mesh_optimizer.h"
 #include "ppx/grfx/grfx_config.h"
 
 #include <filesystem>
+#include <functional>
 
 namespace ppx {
 
@@ -106,6 +108,14 @@ public:
     TriMeshOptions& InvertTexCoordsV() { mInvertTexCoordsV = true; return *this; }
     //! Inverts winding order of ONLY indices
     TriMeshOptions& InvertWinding() { mInvertWinding = true; return *this; }
+    //! Reorder triangles for the post transform cache, needs indices. OBJ meshes have identical vertices merged first.
+    TriMeshOptions& OptimizeVertexCache(bool value = true) { mOptimize.vertexCache = value; return *this; }
+    //! Reorder triangles to reduce overdraw, implies OptimizeVertexCache()
+    TriMeshOptions& OptimizeOverdraw(bool value = true, float threshold = 1.05f) { mOptimize.overdraw = value; mOptimize.overdrawThreshold = threshold; return *this; }
+    //! Reorder vertices in the order triangles use them, needs indices
+    TriMeshOptions& OptimizeVertexFetch(bool value = true) { mOptimize.vertexFetch = value; return *this; }
+    //! Append coarser levels of detail to the indices, needs indices, see MeshLodOptions and TriMesh::GenerateLods()
+    TriMeshOptions& GenerateLods(uint32_t lodCount, float reduction = 0.5f, float maxError = 0.02f) { mLods.lodCount = lodCount; mLods.reduction = reduction; mLods.maxError = maxError; return *this; }
     // clang-format on
 private:
     bool   mEnableIndices      = false;
@@ -120,6 +130,10 @@ private:
     float3 mTranslate          = float3(0, 0, 0);
     float3 mScale              = float3(1, 1, 1);
     float2 mTexCoordScale      = float2(1, 1);
+
+    MeshOptimizeOptions mOptimize = {};
+    MeshLodOptions      mLods     = {};
+
     friend class TriMesh;
 };
 
@@ -129,6 +143,20 @@ private:
 class TriMesh
 {
 public:
+    // Attributes of the vertices [first, first + count) for writing in
+    // place, see AppendVertices(). Attributes that weren't asked for are null.
+    struct VertexSpans
+    {
+        float3*  pPositions  = nullptr;
+        float3*  pColors     = nullptr;
+        float3*  pNormals    = nullptr;
+        float*   pTexCoords  = nullptr; // GetTexCoordDim() floats per vertex
+        float4*  pTangents   = nullptr;
+        float3*  pBitangents = nullptr;
+        uint32_t first       = 0;
+        uint32_t count       = 0;
+    };
+
     TriMesh();
     TriMesh(grfx::IndexType indexType);
     TriMesh(TriMeshAttributeDim texCoordDim);
@@ -188,9 +216,38 @@ public:
     uint32_t AppendTangent(const float4& value);
     uint32_t AppendBitangent(const float3& value);
 
+    // Grows the positions and the enabled attributes by count zeroed vertices
+    // in one allocation each and returns where to write them. The pointers
+    // stay valid until vertices are added again. Call UpdateBoundingBox()
+    // once the positions are written.
+    VertexSpans AppendVertices(uint32_t count, bool enableColors, bool enableNormals, bool enableTexCoords, bool enableTangents);
+    // Grows UINT32 indices by triangleCount zeroed triangles and returns
+    // where to write their 3 * triangleCount indices
+    uint32_t*   AppendTriangles(uint32_t triangleCount);
+    // Recomputes the bounding box from all positions
+    void        UpdateBoundingBox();
+
+    // Returns the indices of every LOD as UINT32 whatever the index type
+    void   GetIndices(std::vector<uint32_t>& indices) const;
     Result GetTriangle(uint32_t triIndex, uint32_t& v0, uint32_t& v1, uint32_t& v2) const;
     Result GetVertexData(uint32_t vtxIndex, TriMeshVertexData* pVertexData) const;
 
+    // Reorders the triangles and vertices of an indexed mesh, see MeshOptimizeOptions
+    void Optimize(const MeshOptimizeOptions& options);
+
+    // Appends coarser levels of detail of an indexed mesh to its indices, so
+    // GetCountIndices() counts all of them and each LOD is drawn with its
+    // range. Call after Optimize(), which would reorder across LODs.
+    void GenerateLods(const MeshLodOptions& options);
+
+    // LOD 0 is the full detail mesh, there's one LOD until GenerateLods()
+    uint32_t GetLodCount() const { return mLods.empty() ? 1 : CountU32(mLods); }
+    MeshLod  GetLod(uint32_t index) const;
+
+    // Merges vertices whose attributes are all identical, for indexed meshes
+    // built one vertex per triangle corner. Returns the new vertex count.
+    uint32_t WeldVertices();
+
     static TriMesh CreatePlane(TriMeshPlane plane, const float2& size, uint32_t usegs, uint32_t vsegs, const TriMeshOptions& options = TriMeshOptions());
     static TriMesh CreateCube(const float3& size, const TriMeshOptions& options = TriMeshOptions());
     static TriMesh CreateSphere(float radius, uint32_t usegs, uint32_t vsegs, const TriMeshOptions& options = TriMeshOptions());
@@ -202,6 +259,9 @@ private:
     void AppendIndexU16(uint16_t value);
     void AppendIndexU32(uint32_t value);
 
+    void SetIndices(const std::vector<uint32_t>& indices);
+    void RemapVertices(const std::vector<uint32_t>& remap, uint32_t newVertexCount);
+
     static void AppendIndexAndVertexData(
         std::vector<uint32_t>&    indexData,
         const std::vector<float>& vertexData,
@@ -209,6 +269,16 @@ private:
         const TriMeshOptions&     options,
         TriMesh&                  mesh);
 
+    // Same as AppendIndexAndVertexData() with vertexFn computing the vertices
+    // instead, which are written straight to mesh on several threads for
+    // large meshes
+    static void AppendGeneratedData(
+        const std::vector<uint32_t>&                             indexData,
+        uint32_t                                                 vertexCount,
+        const std::function<void(uint32_t, TriMeshVertexData*)>& vertexFn,
+        const TriMeshOptions&                                    options,
+        TriMesh&                                                 mesh);
+
 private:
     grfx::IndexType      mIndexType   = grfx::INDEX_TYPE_UNDEFINED;
     TriMeshAttributeDim  mTexCoordDim = TRI_MESH_ATTRIBUTE_DIM_UNDEFINED;
@@ -221,6 +291,7 @@ private:
     std::vector<float3>  mBitangents;     // Vertex bitangents
     float3               mBoundingBoxMin; // Bounding box min
     float3               mBoundingBoxMax; // Bounding box max
+    std::vector<MeshLod> mLods;           // Empty until GenerateLods()
 };
 
 } // namespace ppx
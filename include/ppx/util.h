@@ -54,22 +54,22 @@ T RoundUp(T value, T multiple)
     return (value + multiple - 1) & ~(multiple - 1);
 }
 
-template <typename T>
-uint32_t CountU32(const std::vector<T>& container)
+template <typename T, typename Allocator>
+uint32_t CountU32(const std::vector<T, Allocator>& container)
 {
     uint32_t n = static_cast<uint32_t>(container.size());
     return n;
 }
 
-template <typename T>
-T* DataPtr(std::vector<T>& container)
+template <typename T, typename Allocator>
+T* DataPtr(std::vector<T, Allocator>& container)
 {
     T* ptr = container.empty() ? nullptr : container.data();
     return ptr;
 }
 
-template <typename T>
-const T* DataPtr(const std::vector<T>& container)
+template <typename T, typename Allocator>
+const T* DataPtr(const std::vector<T, Allocator>& container)
 {
     const T* ptr = container.empty() ? nullptr : container.data();
     return ptr;
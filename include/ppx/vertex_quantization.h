@@ -0,0 +1,54 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_vertex_quantization_h
+#define ppx_vertex_quantization_h
+
+#include "ppx/config.h"
+#include "ppx/math_config.h"
+
+namespace ppx {
+
+//! Maps value in [-1, 1] to a 16-bit signed normalized integer, rounding
+//! to nearest. Values outside the range are clamped.
+int16_t QuantizeSnorm16(float value);
+
+//! Maps value in [0, 1] to an 8-bit unsigned normalized integer, rounding
+//! to nearest. Values outside the range are clamped.
+uint8_t QuantizeUnorm8(float value);
+
+//! Converts value to a 16-bit float, rounding to nearest.
+uint16_t QuantizeHalf(float value);
+
+//! Inverse of QuantizeSnorm16(), matches the SNORM format conversion.
+float DequantizeSnorm16(int16_t value);
+
+//! Octahedral encoding of a unit vector (Meyer et al. 2010), the result
+//! is in [-1, 1]^2. Zero vectors encode as (0, 0).
+float2 EncodeOctahedral(const float3& n);
+
+//! Inverse of EncodeOctahedral(), the result is normalized.
+float3 DecodeOctahedral(const float2& e);
+
+//! Octahedral encoding of a tangent with the bitangent sign in w. The
+//! encoded y is remapped to (0, 1] and takes the sign of w, so the
+//! tangent fits in 2 components at 1 bit of precision less in y.
+float2 EncodeOctahedralTangent(const float4& t);
+
+//! Inverse of EncodeOctahedralTangent(), w is either 1 or -1.
+float4 DecodeOctahedralTangent(const float2& e);
+
+} // namespace ppx
+
+#endif // ppx_vertex_quantization_h
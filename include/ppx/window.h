@@ -79,6 +79,10 @@ public:
     virtual void   ProcessEvent() {}
     virtual void*  NativeHandle() { return nullptr; }
 
+    // Hides the cursor and reports unbounded motion, unaccelerated if
+    // rawMotion and the platform supports it.
+    virtual void SetCursorCaptured(bool captured, bool rawMotion) {}
+
     virtual WindowSize Size() const;
 
     WindowState GetState() const { return mState; }
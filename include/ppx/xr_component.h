@@ -43,6 +43,7 @@
 #include <unordered_map>
 
 #include "ppx/camera.h"
+#include "ppx/timer.h"
 #include "ppx/xr_composition_layers.h"
 
 #define CHECK_XR_CALL(CMD__)                                                                       \
@@ -134,12 +135,35 @@ struct XrComponentCreateInfo
     bool                    enableQuadLayer      = false;
     bool                    enableDepthSwapchain = false;
     bool                    enableMultiView      = false;
+    bool                    enableEyeGaze        = false; // Uses XR_EXT_eye_gaze_interaction when the runtime supports it
+    bool                    enableSpaceWarp      = false; // Uses XR_FB_space_warp when the runtime supports it, Vulkan only
+    bool                    enableFoveation      = false; // Uses XR_FB_foveation when the runtime supports it, Vulkan only
     XrComponentResolution   resolution           = {0, 0};
     XrComponentResolution   uiResolution         = {0, 0};
 
     std::vector<std::string> requiredExtensions = {};
 };
 
+// Pacing of the last frame, relative to the runtime's predictions. Times are
+// in milliseconds.
+struct XrFrameTiming
+{
+    double   waitTime          = 0; // Blocked in xrWaitFrame
+    double   displayPeriod     = 0; // Predicted display period
+    double   cpuSlack          = 0; // Display period left between xrWaitFrame and xrEndFrame, negative when over
+    uint32_t missedFrames      = 0; // Display periods skipped since the previous frame
+    uint64_t totalMissedFrames = 0;
+};
+
+// Layout written by XrComponent::LateLatchViews, one entry per view. Matches
+// an HLSL array of three float4x4 per view.
+struct XrViewMatrices
+{
+    float4x4 view;
+    float4x4 projection;
+    float4x4 viewProjection;
+};
+
 // Used to reference OpenXR layers added to XrComponent through XrComponent::AddLayer.
 using LayerRef = uint32_t;
 
@@ -156,6 +180,7 @@ public:
     // Initialize interaction profiles.
     // Currently supported interaction profile:
     //  - khr/simple_controller
+    //  - ext/eye_gaze_interaction, if enableEyeGaze is set and supported
     //
     // The error returned by this function can be safely ignored.
     XrResult InitializeInteractionProfiles();
@@ -164,7 +189,22 @@ public:
     XrResult PollActions();
 
     void BeginFrame();
-    void EndFrame(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t layerProjStartIndex, uint32_t layerQuadStartIndex);
+    // spaceWarpStartIndex is the first of the motion vector swapchains when
+    // space warp is supported, one per projection swapchain.
+    void EndFrame(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t layerProjStartIndex, uint32_t layerQuadStartIndex, std::optional<uint32_t> spaceWarpStartIndex = std::nullopt);
+
+    // Late latching: right before submitting the frame's work, locates the
+    // views again with the newest tracking data and writes GetViewCount()
+    // XrViewMatrices to pMappedData, which is usually a persistently mapped
+    // buffer of the frame in flight. Shaders must read the view matrices from
+    // that buffer for the new poses to take effect.
+    //
+    // Views are only located again on the first call of a frame, so every
+    // view, and the projection layer submitted by EndFrame(), use the same
+    // poses. Cameras returned by GetCamera() are updated as well.
+    void LateLatchViews(void* pMappedData);
+
+    const XrFrameTiming& GetFrameTiming() const { return mFrameTiming; }
 
     grfx::Format GetColorFormat() const { return mCreateInfo.colorFormat; }
     grfx::Format GetDepthFormat() const { return mCreateInfo.depthFormat; }
@@ -231,6 +271,40 @@ public:
     // Note, the current UI swapchain covers a region of [-0.5, +0.5] x [-0.5, +0.5]
     std::optional<XrVector2f> GetUICursor() const;
 
+    // Eye gaze pose in the reference space, empty if eye gaze isn't enabled,
+    // supported or currently tracked.
+    bool                   IsEyeGazeSupported() const { return mEyeGazeSupported; }
+    std::optional<XrPosef> GetEyeGazeState() const { return mEyeGazeState; }
+
+    // Where the eye gaze hits the image of a view, in [0, 1] from the top
+    // left corner. Values outside of [0, 1] are off screen.
+    std::optional<float2> GetEyeGazeUV(uint32_t viewIndex) const;
+
+    // Space warp: the runtime extrapolates frames from the motion vectors
+    // and depth submitted with the projection layer, so the app can render
+    // at half the display rate. Motion vectors are the NDC space motion of
+    // each pixel since the previous frame, current minus previous, in
+    // GetMotionVectorFormat() swapchains of GetSpaceWarpWidth() x
+    // GetSpaceWarpHeight(). See scene::MotionVectorRenderer.
+    bool         IsSpaceWarpSupported() const { return mSpaceWarpSupported; }
+    uint32_t     GetSpaceWarpWidth() const { return mSpaceWarpWidth; }
+    uint32_t     GetSpaceWarpHeight() const { return mSpaceWarpHeight; }
+    grfx::Format GetMotionVectorFormat() const { return grfx::FORMAT_R16G16B16A16_FLOAT; }
+
+    // Motion of the reference space in the tracking space since the previous
+    // frame, e.g. from locomotion. Reset to identity by BeginFrame().
+    void SetSpaceWarpAppSpaceDelta(const XrPosef& deltaPose) { mSpaceWarpAppSpaceDelta = deltaPose; }
+
+    // Runtime foveation: the runtime provides a fragment density map for each
+    // projection swapchain image, which the swapchain's render passes use to
+    // shade the periphery at a lower rate. The foveated region follows the
+    // eyes when the system supports eye tracked foveation. Dynamic levels let
+    // the runtime lower the level while the GPU keeps up with the frame rate.
+    // Changes are applied to the projection swapchains by the next EndFrame().
+    bool IsFoveationSupported() const { return mFoveationSupported; }
+    bool IsFoveationEyeTracked() const { return mFoveationEyeTracked; }
+    void SetFoveation(XrFoveationLevelFB level, bool dynamic, float verticalOffset = 0);
+
     bool IsSessionRunning() const { return mIsSessionRunning; }
     bool ShouldRender() const { return mShouldRender; }
 
@@ -255,12 +329,19 @@ private:
     const XrEventDataBaseHeader* TryReadNextEvent();
     void                         HandleSessionStateChangedEvent(const XrEventDataSessionStateChanged& stateChangedEvent, bool& exitRenderLoop);
 
+    // Locates mViews at the predicted display time of the frame, returns
+    // false if the poses aren't valid
+    bool LocateViews();
+
     // Methods that populate the OpenXR composition layers with information when they are needed for rendering.
     // Used by XrComponent::EndFrame to support the base application composition layers.
-    void ConditionallyPopulateProjectionLayer(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t startIndex, XrLayerBaseQueue& layerQueue, XrProjectionLayer& projectionLayer);
+    void ConditionallyPopulateProjectionLayer(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t startIndex, std::optional<uint32_t> spaceWarpStartIndex, XrLayerBaseQueue& layerQueue, XrProjectionLayer& projectionLayer);
     void ConditionallyPopulateImGuiLayer(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t index, XrLayerBaseQueue& layerQueue, XrQuadLayer& quadLayer);
     void ConditionallyPopulatePassthroughFbLayer(XrLayerBaseQueue& layerQueue, XrPassthroughFbLayer& passthroughFbLayer);
 
+    // Applies mPendingFoveation to the projection swapchains
+    void UpdateFoveation(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t startIndex);
+
     XrInstance mInstance = XR_NULL_HANDLE;
     XrSystemId mSystemId = XR_NULL_SYSTEM_ID;
     XrSession  mSession  = XR_NULL_HANDLE;
@@ -299,12 +380,35 @@ private:
     XrAction    mImguiAimAction   = XR_NULL_HANDLE;
     XrTime      mImguiActionTime  = {};
 
+    // Eye gaze, in the same action set
+    bool                   mEyeGazeSupported = false;
+    XrAction               mEyeGazeAction    = XR_NULL_HANDLE;
+    XrSpace                mEyeGazeSpace     = XR_NULL_HANDLE;
+    std::optional<XrPosef> mEyeGazeState     = {};
+
+    // Space warp
+    bool     mSpaceWarpSupported     = false;
+    uint32_t mSpaceWarpWidth         = 0;
+    uint32_t mSpaceWarpHeight        = 0;
+    XrPosef  mSpaceWarpAppSpaceDelta = {{0, 0, 0, 1}, {0, 0, 0}};
+
+    // Foveation
+    bool                                               mFoveationSupported  = false;
+    bool                                               mFoveationEyeTracked = false;
+    std::optional<XrFoveationLevelProfileCreateInfoFB> mPendingFoveation    = std::nullopt;
+
     std::optional<float> mNearPlaneForFrame     = std::nullopt;
     std::optional<float> mFarPlaneForFrame      = std::nullopt;
     bool                 mShouldSubmitDepthInfo = false;
 
     XrFrameState mFrameState = {XR_TYPE_FRAME_STATE};
 
+    // Frame pacing
+    XrFrameTiming mFrameTiming                  = {};
+    XrTime        mPreviousPredictedDisplayTime = 0;
+    uint64_t      mWaitFrameEndTimestamp        = 0;
+    bool          mViewsLateLatched             = false;
+
     XrEventDataBuffer mEventDataBuffer;
 
     XrComponentCreateInfo mCreateInfo = {};
@@ -88,10 +88,13 @@ public:
     void AddView(XrCompositionLayerProjectionView view);
     // Add a new projection view to this layer that has associated depth info.
     void AddView(XrCompositionLayerProjectionView view, XrCompositionLayerDepthInfoKHR depthInfo);
+    // Chain XR_FB_space_warp motion vectors and depth to the last added view.
+    void AddSpaceWarpInfo(XrCompositionLayerSpaceWarpInfoFB spaceWarpInfo);
 
 private:
-    std::vector<XrCompositionLayerProjectionView>                mViews;
-    std::vector<std::unique_ptr<XrCompositionLayerDepthInfoKHR>> mDepthInfos;
+    std::vector<XrCompositionLayerProjectionView>                   mViews;
+    std::vector<std::unique_ptr<XrCompositionLayerDepthInfoKHR>>    mDepthInfos;
+    std::vector<std::unique_ptr<XrCompositionLayerSpaceWarpInfoFB>> mSpaceWarpInfos;
 };
 
 // XrLayerBase implementation for XrCompositionLayerQuad layers.
@@ -0,0 +1,70 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ppx_y4m_writer_h
+#define ppx_y4m_writer_h
+
+#include "ppx/config.h"
+#include "ppx/grfx/grfx_format.h"
+
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+
+namespace ppx {
+
+//! @class Y4mWriter
+//!
+//! Writes frames as an uncompressed YUV 4:2:0 video in the YUV4MPEG2
+//! format, which ffmpeg and most players read directly. RGB is converted
+//! with BT.601 limited range coefficients, odd sizes round the chroma
+//! planes up.
+//!
+class Y4mWriter
+{
+public:
+    Y4mWriter() {}
+    ~Y4mWriter();
+
+    Result Open(const std::filesystem::path& path, uint32_t width, uint32_t height, uint32_t frameRate);
+    //! pStream must outlive the writer or the next Close()
+    Result Open(std::ostream* pStream, uint32_t width, uint32_t height, uint32_t frameRate);
+    void   Close();
+
+    bool     IsOpen() const { return !IsNull(mStream); }
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    uint32_t GetFrameCount() const { return mFrameCount; }
+
+    //! Appends a frame of the writer's size. Supports the same 8-bit color
+    //! formats as ExportToPPM().
+    Result WriteFrame(grfx::Format format, const void* texels, uint32_t width, uint32_t height, uint32_t rowStride);
+
+    //! Converts texels to Y, U and V planes, stored one after another in
+    //! pDst which must hold GetFrameSize() bytes
+    static Result ConvertToI420(grfx::Format format, const void* texels, uint32_t width, uint32_t height, uint32_t rowStride, uint8_t* pDst);
+    static size_t GetFrameSize(uint32_t width, uint32_t height);
+
+private:
+    std::ofstream        mFile;
+    std::ostream*        mStream     = nullptr;
+    uint32_t             mWidth      = 0;
+    uint32_t             mHeight     = 0;
+    uint32_t             mFrameCount = 0;
+    std::vector<uint8_t> mFrame;
+};
+
+} // namespace ppx
+
+#endif // ppx_y4m_writer_h
@@ -13,8 +13,13 @@
 // limitations under the License.
 
 #include "ppx/ppx.h"
+#include "ppx/random.h"
+#include "ppx/timer.h"
 using namespace ppx;
 
+#include <algorithm>
+#include <numeric>
+
 #if defined(USE_DX12)
 const grfx::Api kApi = grfx::API_DX_12_0;
 #elif defined(USE_VK)
@@ -25,17 +30,63 @@ class ProjApp
     : public ppx::Application
 {
 public:
+    virtual void InitKnobs() override;
     virtual void Config(ppx::ApplicationSettings& settings) override;
     virtual void Setup() override;
     virtual void Render() override;
 
 private:
+    // One step of the stress workload: allocate size bytes and free them
+    // lifetime steps later. A lifetime of 0 keeps the allocation until the
+    // end of the workload.
+    struct StressOp
+    {
+        uint64_t size     = 0;
+        uint32_t lifetime = 0;
+    };
+
+    // Per allocator results, also recorded as metrics when a run is active
+    struct StressResults
+    {
+        std::vector<double> allocMicros;
+        std::vector<double> freeMicros;
+        std::vector<double> fragmentation; // Fraction of reserved bytes not holding live data
+        uint32_t            failedCount = 0;
+    };
+
+    void                            TryAllocateRanges();
     Result                          TryAllocateRange(uint32_t rangeStart, uint32_t rangeEnd, uint32_t usageFlags);
+    void                            GenerateStressOps();
+    template <typename HandleT, typename AllocFn, typename FreeFn, typename ReservedFn>
+    void                            RunStressOps(AllocFn allocFn, FreeFn freeFn, ReservedFn reservedFn, StressResults* pResults);
+    Result                          StressDeviceBuffers(StressResults* pResults);
+    Result                          StressBufferPool(StressResults* pResults);
+    Result                          StressTransientAllocator(StressResults* pResults);
+    uint64_t                        GetDeviceBlockBytes() const;
+    void                            ReportStressResults(const std::string& name, const StressResults& results);
+    std::shared_ptr<KnobFlag<int>>  mStressIterationsKnob;
+    std::shared_ptr<KnobFlag<int>>  mStressSampleIntervalKnob;
+    std::shared_ptr<KnobFlag<bool>> mSkipRangeTestKnob;
+    std::vector<StressOp>           mStressOps;
     ppx::grfx::PipelineInterfacePtr mPipelineInterface;
     ppx::grfx::GraphicsPipelinePtr  mPipeline;
     ppx::grfx::BufferPtr            mVertexBuffer;
 };
 
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&mStressIterationsKnob, "stress-iterations", 4096, 0, 1000000);
+    mStressIterationsKnob->SetFlagDescription(
+        "Number of allocations made by the stress benchmark through each allocator. "
+        "0 skips the benchmark.");
+
+    GetKnobManager().InitKnob(&mStressSampleIntervalKnob, "stress-sample-interval", 64, 1, 1000000);
+    mStressSampleIntervalKnob->SetFlagDescription("Allocations between fragmentation samples of the stress benchmark.");
+
+    GetKnobManager().InitKnob(&mSkipRangeTestKnob, "skip-range-test", false);
+    mSkipRangeTestKnob->SetFlagDescription("Skip the test of which buffer sizes can be allocated.");
+}
+
 void ProjApp::Config(ppx::ApplicationSettings& settings)
 {
     settings.appName  = "alloc";
@@ -101,6 +152,283 @@ Result ProjApp::TryAllocateRange(uint32_t rangeStart, uint32_t rangeEnd, uint32_
     return ppx::SUCCESS;
 }
 
+// Sizes are log-uniform between 256 bytes and 2 MiB so that small
+// allocations dominate, as they do in real scenes. Half of the allocations
+// are short lived, a third live up to a few hundred steps and the rest
+// stay until the end to pin down blocks the way static geometry does.
+void ProjApp::GenerateStressOps()
+{
+    const uint32_t kMinSizeLog2 = 8;
+    const uint32_t kMaxSizeLog2 = 20;
+
+    ppx::Random random;
+    mStressOps.resize(static_cast<size_t>(mStressIterationsKnob->GetValue()));
+    for (auto& op : mStressOps) {
+        uint64_t base = 1ull << (kMinSizeLog2 + random.UInt32() % (kMaxSizeLog2 - kMinSizeLog2 + 1));
+        op.size       = (base + random.UInt32() % base) & ~3ull;
+
+        uint32_t lifetimeClass = random.UInt32() % 100;
+        if (lifetimeClass < 50) {
+            op.lifetime = 1 + random.UInt32() % 8;
+        }
+        else if (lifetimeClass < 85) {
+            op.lifetime = 9 + random.UInt32() % 248;
+        }
+        else {
+            op.lifetime = 0;
+        }
+    }
+}
+
+// Replays mStressOps through one allocator. allocFn returns false if the
+// allocation failed, reservedFn returns the bytes the allocator holds on to
+// for the workload's allocations.
+template <typename HandleT, typename AllocFn, typename FreeFn, typename ReservedFn>
+void ProjApp::RunStressOps(AllocFn allocFn, FreeFn freeFn, ReservedFn reservedFn, StressResults* pResults)
+{
+    struct Live
+    {
+        HandleT  handle   = {};
+        uint64_t size     = 0;
+        uint64_t freeStep = 0; // UINT64_MAX for allocations kept until the end
+    };
+
+    const uint32_t    sampleInterval = static_cast<uint32_t>(mStressSampleIntervalKnob->GetValue());
+    std::vector<Live> live;
+    uint64_t          liveBytes = 0;
+
+    auto timedFree = [&](const Live& allocation) {
+        uint64_t start = 0;
+        uint64_t end   = 0;
+        Timer::Timestamp(&start);
+        freeFn(allocation.handle);
+        Timer::Timestamp(&end);
+        pResults->freeMicros.push_back(Timer::TimestampToMicros(end - start));
+        liveBytes -= allocation.size;
+    };
+
+    for (size_t step = 0; step < mStressOps.size(); ++step) {
+        // Free everything that expires at this step
+        for (size_t i = 0; i < live.size();) {
+            if (live[i].freeStep == step) {
+                timedFree(live[i]);
+                live[i] = live.back();
+                live.pop_back();
+            }
+            else {
+                ++i;
+            }
+        }
+
+        const StressOp& op         = mStressOps[step];
+        Live            allocation = {};
+        allocation.size            = op.size;
+        allocation.freeStep        = (op.lifetime > 0) ? (step + op.lifetime) : UINT64_MAX;
+
+        uint64_t start = 0;
+        uint64_t end   = 0;
+        Timer::Timestamp(&start);
+        bool didSucceed = allocFn(op.size, &allocation.handle);
+        Timer::Timestamp(&end);
+
+        if (didSucceed) {
+            pResults->allocMicros.push_back(Timer::TimestampToMicros(end - start));
+            live.push_back(allocation);
+            liveBytes += op.size;
+        }
+        else {
+            ++pResults->failedCount;
+        }
+
+        if ((step % sampleInterval) == (sampleInterval - 1)) {
+            uint64_t reserved = reservedFn();
+            if (reserved > 0) {
+                double used = static_cast<double>(std::min(liveBytes, reserved));
+                pResults->fragmentation.push_back(1.0 - used / static_cast<double>(reserved));
+            }
+        }
+    }
+
+    for (const auto& allocation : live) {
+        timedFree(allocation);
+    }
+}
+
+uint64_t ProjApp::GetDeviceBlockBytes() const
+{
+    grfx::MemoryStatistics statistics = {};
+    if (Failed(GetDevice()->GetMemoryStatistics(&statistics))) {
+        return 0;
+    }
+
+    uint64_t blockBytes = 0;
+    for (const auto& heap : statistics.heaps) {
+        blockBytes += heap.blockBytes;
+    }
+    return blockBytes;
+}
+
+// Every allocation is its own grfx::Buffer, so this measures the full
+// CreateBuffer() / DestroyBuffer() path including VMA or D3D12MA
+Result ProjApp::StressDeviceBuffers(StressResults* pResults)
+{
+    grfx::BufferCreateInfo createInfo       = {};
+    createInfo.usageFlags.bits.vertexBuffer = true;
+    createInfo.usageFlags.bits.indexBuffer  = true;
+    createInfo.usageFlags.bits.transferDst  = true;
+    createInfo.memoryUsage                  = grfx::MEMORY_USAGE_GPU_ONLY;
+
+    // Blocks that existed before the workload aren't part of it
+    const uint64_t baselineBlockBytes = GetDeviceBlockBytes();
+
+    RunStressOps<grfx::Buffer*>(
+        [&](uint64_t size, grfx::Buffer** ppBuffer) {
+            createInfo.size = size;
+            return Success(GetDevice()->CreateBuffer(&createInfo, ppBuffer));
+        },
+        [&](grfx::Buffer* pBuffer) {
+            GetDevice()->DestroyBuffer(pBuffer);
+        },
+        [&]() {
+            uint64_t blockBytes = GetDeviceBlockBytes();
+            return (blockBytes > baselineBlockBytes) ? (blockBytes - baselineBlockBytes) : 0;
+        },
+        pResults);
+
+    return ppx::SUCCESS;
+}
+
+Result ProjApp::StressBufferPool(StressResults* pResults)
+{
+    grfx::BufferPoolCreateInfo createInfo   = {};
+    createInfo.usageFlags.bits.vertexBuffer = true;
+    createInfo.usageFlags.bits.indexBuffer  = true;
+    createInfo.memoryUsage                  = grfx::MEMORY_USAGE_GPU_ONLY;
+
+    grfx::BufferPoolPtr pool;
+    PPX_CHECKED_CALL(GetDevice()->CreateBufferPool(&createInfo, &pool));
+
+    // Allocations never exceed the block size, so every block is the same size
+    RunStressOps<grfx::BufferRange>(
+        [&](uint64_t size, grfx::BufferRange* pRange) {
+            return Success(pool->Allocate(size, pRange));
+        },
+        [&](const grfx::BufferRange& range) {
+            pool->Free(range);
+        },
+        [&]() {
+            return pool->GetBlockCount() * createInfo.blockSize;
+        },
+        pResults);
+
+    GetDevice()->DestroyBufferPool(pool);
+    return ppx::SUCCESS;
+}
+
+// The transient allocator frees whole frames at once, so lifetimes don't
+// apply: each frame gets kStepsPerFrame allocations and the cost of
+// BeginFrame() is recorded as the free latency. Fragmentation is the
+// alignment padding within each frame.
+Result ProjApp::StressTransientAllocator(StressResults* pResults)
+{
+    const uint32_t kStepsPerFrame = 32;
+
+    grfx::TransientAllocatorCreateInfo createInfo = {};
+    createInfo.frameSize                          = 64 * 1024 * 1024;
+    createInfo.frameCount                         = 2;
+
+    grfx::TransientAllocatorPtr allocator;
+    PPX_CHECKED_CALL(GetDevice()->CreateTransientAllocator(&createInfo, &allocator));
+
+    uint32_t frameIndex     = 0;
+    uint64_t requestedBytes = 0;
+    for (size_t step = 0; step < mStressOps.size(); ++step) {
+        if ((step % kStepsPerFrame) == 0) {
+            if ((step > 0) && (allocator->GetUsedSize() > 0)) {
+                pResults->fragmentation.push_back(1.0 - static_cast<double>(requestedBytes) / static_cast<double>(allocator->GetUsedSize()));
+            }
+
+            uint64_t start = 0;
+            uint64_t end   = 0;
+            Timer::Timestamp(&start);
+            allocator->BeginFrame(frameIndex);
+            Timer::Timestamp(&end);
+            pResults->freeMicros.push_back(Timer::TimestampToMicros(end - start));
+
+            frameIndex     = (frameIndex + 1) % createInfo.frameCount;
+            requestedBytes = 0;
+        }
+
+        grfx::TransientAllocation allocation = {};
+
+        uint64_t start = 0;
+        uint64_t end   = 0;
+        Timer::Timestamp(&start);
+        Result ppxres = allocator->Allocate(mStressOps[step].size, &allocation);
+        Timer::Timestamp(&end);
+
+        if (Success(ppxres)) {
+            pResults->allocMicros.push_back(Timer::TimestampToMicros(end - start));
+            requestedBytes += mStressOps[step].size;
+        }
+        else {
+            ++pResults->failedCount;
+        }
+    }
+
+    GetDevice()->DestroyTransientAllocator(allocator);
+    return ppx::SUCCESS;
+}
+
+static double Percentile(std::vector<double> values, double p)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+static double Average(const std::vector<double>& values)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    return std::accumulate(values.begin(), values.end(), 0.0) / static_cast<double>(values.size());
+}
+
+void ProjApp::ReportStressResults(const std::string& name, const StressResults& results)
+{
+    fprintf(stderr, "%s:\n", name.c_str());
+    fprintf(stderr, "    alloc us: avg %.2f, p50 %.2f, p99 %.2f (%zu allocations, %u failed)\n", Average(results.allocMicros), Percentile(results.allocMicros, 0.5), Percentile(results.allocMicros, 0.99), results.allocMicros.size(), results.failedCount);
+    fprintf(stderr, "    free us:  avg %.2f, p50 %.2f, p99 %.2f\n", Average(results.freeMicros), Percentile(results.freeMicros, 0.5), Percentile(results.freeMicros, 0.99));
+    fprintf(stderr, "    fragmentation: avg %.1f%%, max %.1f%%\n", 100.0 * Average(results.fragmentation), 100.0 * Percentile(results.fragmentation, 1.0));
+
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    // Every sample is recorded so the report has the full distribution
+    auto recordSamples = [&](const std::string& metricName, const std::string& unit, const std::vector<double>& values) {
+        ppx::metrics::MetricMetadata metadata = {ppx::metrics::MetricType::GAUGE, name + " " + metricName, unit, ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 1e10f}};
+        ppx::metrics::MetricID       id       = AddMetric(metadata);
+        PPX_ASSERT_MSG(id != ppx::metrics::kInvalidMetricID, "Failed to add " << metadata.name << " metric");
+
+        ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+        for (size_t i = 0; i < values.size(); ++i) {
+            data.gauge.seconds = static_cast<double>(i);
+            data.gauge.value   = values[i];
+            RecordMetricData(id, data);
+        }
+    };
+
+    recordSamples("Alloc Latency", "us", results.allocMicros);
+    recordSamples("Free Latency", "us", results.freeMicros);
+    recordSamples("Fragmentation", "ratio", results.fragmentation);
+    recordSamples("Failed Allocations", "", {static_cast<double>(results.failedCount)});
+}
+
 struct Range
 {
     uint32_t start;
@@ -108,6 +436,32 @@ struct Range
 };
 
 void ProjApp::Setup()
+{
+    if (!mSkipRangeTestKnob->GetValue()) {
+        TryAllocateRanges();
+    }
+
+    GenerateStressOps();
+    if (!mStressOps.empty()) {
+        fprintf(stderr, "Running %zu stress allocations through each allocator.\n", mStressOps.size());
+
+        StressResults deviceResults;
+        PPX_CHECKED_CALL(StressDeviceBuffers(&deviceResults));
+        ReportStressResults((GetDevice()->GetApi() == grfx::API_DX_12_0) ? "Device Buffers (D3D12MA)" : "Device Buffers (VMA)", deviceResults);
+
+        StressResults poolResults;
+        PPX_CHECKED_CALL(StressBufferPool(&poolResults));
+        ReportStressResults("Buffer Pool", poolResults);
+
+        StressResults transientResults;
+        PPX_CHECKED_CALL(StressTransientAllocator(&transientResults));
+        ReportStressResults("Transient Allocator", transientResults);
+    }
+
+    Quit();
+}
+
+void ProjApp::TryAllocateRanges()
 {
     grfx::BufferUsageFlags usageFlags;
 
@@ -129,8 +483,6 @@ void ProjApp::Setup()
     fprintf(stderr, "Trying uniform texel buffer allocations in [%d, %d] in powers of 2.\n", range.start, range.end);
     usageFlags.bits.uniformTexelBuffer = 1;
     TryAllocateRange(range.start, range.end, usageFlags);
-
-    Quit();
 }
 
 void ProjApp::Render()
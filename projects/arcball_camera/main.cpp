@@ -258,6 +258,9 @@ void ProjApp::Render()
     // Wait for and reset image acquired fence
     PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
 
+    // Rotate with the latest mouse motion, see --late-input-poll
+    PollLateInput();
+
     // Update uniform buffer
     {
         float           t = GetElapsedSeconds();
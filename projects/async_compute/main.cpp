@@ -39,6 +39,7 @@ private:
     void SetupComposition();
     void SetupCompute();
     void SetupDrawToSwapchain();
+    void SetupPostProcess();
     void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
 
     struct PerFrame
@@ -91,6 +92,11 @@ private:
             grfx::DescriptorSetPtr descriptorSet;
         };
         DrawToSwapchainData drawToSwapchainData;
+
+        // Post-processing workload only, the frame presented by this
+        // in-flight frame's draw to swapchain and its timestamps.
+        grfx::QueryPtr blitQuery;
+        uint64_t       blitFrame = UINT64_MAX;
     };
     std::vector<PerFrame> mPerFrame;
     const uint32_t        mNumFramesInFlight = 2;
@@ -102,6 +108,67 @@ private:
     void     Compose(PerFrame& frame, size_t quadIndex);
     void     DrawScene(PerFrame& frame, size_t quadIndex);
 
+    // Post-processing workload (--post-process): the scene of frame N is
+    // rendered to an HDR target on the graphics queue, its bloom and tone
+    // mapping run on the compute queue, and it is presented during frame
+    // N + 1 so the post-processing overlaps frame N + 1's scene. A slot holds
+    // the resources of a frame until it has been presented, which takes one
+    // more frame than the frames in flight.
+    static constexpr uint32_t kPostSlotCount   = 3;
+    static constexpr uint32_t kPostTimingCount = 8;
+
+    struct PostSlot
+    {
+        uint64_t                  frame = UINT64_MAX; // Last frame rendered with this slot
+        grfx::CommandBufferPtr    sceneCmd;
+        grfx::DescriptorSetPtr    sceneDescriptorSet;
+        grfx::BufferPtr           sceneConstants;
+        grfx::DrawPassPtr         sceneDrawPass;
+        grfx::SemaphorePtr        sceneCompleteSemaphore;
+        grfx::QueryPtr            sceneQuery;
+        grfx::CommandBufferPtr    postCmd;
+        grfx::ImagePtr            bloomImages[2]; // Half resolution, blurred back and forth
+        grfx::SampledImageViewPtr bloomSampledViews[2];
+        grfx::StorageImageViewPtr bloomStorageViews[2];
+        grfx::ImagePtr            outputImage; // Tone mapped
+        grfx::SampledImageViewPtr outputSampledView;
+        grfx::StorageImageViewPtr outputStorageView;
+        grfx::DescriptorSetPtr    postDescriptorSets[4]; // Extract, horizontal blur, vertical blur, tone map
+        grfx::SemaphorePtr        postCompleteSemaphore;
+        grfx::QueryPtr            postQuery;
+        grfx::DescriptorSetPtr    drawToSwapchainDescriptorSet;
+    };
+
+    // GPU times in seconds on the graphics queue's clock
+    struct PostTiming
+    {
+        uint64_t frame    = UINT64_MAX;
+        bool     hasScene = false;
+        bool     hasPost  = false;
+        bool     hasBlit  = false;
+        double   scene[2] = {};
+        double   post[2]  = {};
+        double   blit[2]  = {};
+    };
+
+    struct TimelineSpan
+    {
+        uint32_t queue; // 0 for graphics, 1 for post-processing
+        ImU32    color;
+        double   begin; // Seconds from the start of the timeline
+        double   end;
+    };
+
+    void        RenderPostProcess();
+    void        UpdatePostTransform(PostSlot& slot);
+    void        DrawPostScene(PostSlot& slot);
+    void        RunPostProcess(PostSlot& slot);
+    void        BlitAndPresentPost(PerFrame& frame, PostSlot* pSource, uint32_t swapchainImageIndex);
+    void        ReadPostTimestamps(PerFrame& frame, PostSlot& slot);
+    PostTiming& GetPostTiming(uint64_t frameNumber);
+    void        UpdatePostStats(uint64_t frameNumber);
+    void        DrawPostTimeline();
+
     PerspCamera mCamera;
 
     grfx::MeshPtr    mModelMesh;
@@ -140,6 +207,30 @@ private:
 
     bool mAsyncComputeEnabled     = true;
     bool mUseQueueFamilyTransfers = true;
+    bool mPostProcessEnabled      = false;
+
+    std::array<PostSlot, kPostSlotCount>     mPostSlots;
+    std::array<PostTiming, kPostTimingCount> mPostTimings;
+    grfx::GraphicsPipelinePtr                mPostScenePipeline;
+    grfx::DescriptorSetLayoutPtr             mPostLayout;
+    grfx::PipelineInterfacePtr               mPostPipelineInterface;
+    grfx::ComputePipelinePtr                 mBloomExtractPipeline;
+    grfx::ComputePipelinePtr                 mBloomBlurPipeline;
+    grfx::ComputePipelinePtr                 mToneMapPipeline;
+    float                                    mExposure                   = 1.5f;
+    float                                    mBloomThreshold             = 0.9f;
+    float                                    mBloomStrength              = 0.5f;
+    uint64_t                                 mGraphicsTimestampFrequency = 0;
+    uint64_t                                 mComputeTimestampFrequency  = 0;
+    double                                   mComputeTimestampOffset     = 0.0; // Seconds, see grfx::Queue::GetTimestampOffset()
+
+    // Smoothed over frames
+    double                    mSceneMs       = 0.0;
+    double                    mPostMs        = 0.0;
+    double                    mOverlapMs     = 0.0; // Of the post-processing with graphics work
+    uint64_t                  mTimelineFrame = UINT64_MAX;
+    double                    mTimelineMs    = 0.0;
+    std::vector<TimelineSpan> mTimeline;
 };
 
 void ProjApp::Config(ppx::ApplicationSettings& settings)
@@ -164,6 +255,9 @@ void ProjApp::Setup()
     // Whether to use queue family transfers in Vulkan (not required in DX12).
     mUseQueueFamilyTransfers = cl_options.GetExtraOptionValueOrDefault<bool>("use-queue-family-transfers", true);
 
+    // Whether to run the pipelined post-processing workload instead of the image filters.
+    mPostProcessEnabled = cl_options.GetExtraOptionValueOrDefault<bool>("post-process", false);
+
     mCamera = PerspCamera(60.0f, GetWindowAspect());
 
     mGraphicsQueue = GetGraphicsQueue();
@@ -195,6 +289,13 @@ void ProjApp::Setup()
         PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.imageAcquiredSemaphore));
         PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.renderCompleteSemaphore));
 
+        if (mPostProcessEnabled) {
+            grfx::QueryCreateInfo queryCreateInfo = {};
+            queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+            queryCreateInfo.count                 = 2;
+            PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &frame.blitQuery));
+        }
+
         mPerFrame.push_back(frame);
     }
 
@@ -288,10 +389,23 @@ void ProjApp::Setup()
         gpCreateInfo.pPipelineInterface                 = mRenderPipelineInterface;
         PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mRenderPipeline));
 
+        if (mPostProcessEnabled) {
+            gpCreateInfo.outputState.renderTargetFormats[0] = grfx::FORMAT_R16G16B16A16_FLOAT;
+            PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPostScenePipeline));
+        }
+
         GetDevice()->DestroyShaderModule(VS);
         GetDevice()->DestroyShaderModule(PS);
     }
 
+    mCamera.LookAt(float3(0, 2, 7), float3(0, 0, 0));
+
+    if (mPostProcessEnabled) {
+        SetupDrawToSwapchain();
+        SetupPostProcess();
+        return;
+    }
+
     for (auto& frameData : mPerFrame) {
         for (auto& renderData : frameData.renderData) {
             // Descriptor set.
@@ -361,8 +475,6 @@ void ProjApp::Setup()
     SetupCompute();
     SetupComposition();
     SetupDrawToSwapchain();
-
-    mCamera.LookAt(float3(0, 2, 7), float3(0, 0, 0));
 }
 
 void ProjApp::SetupCompute()
@@ -671,6 +783,11 @@ void ProjApp::SetupDrawToSwapchain()
         PPX_CHECKED_CALL(GetDevice()->CreateFullscreenQuad(&createInfo, &mDrawToSwapchainPipeline));
     }
 
+    // The post-processing workload has a descriptor set per output image
+    if (mPostProcessEnabled) {
+        return;
+    }
+
     // Allocate descriptor set
     for (auto& frameData : mPerFrame) {
         PerFrame::DrawToSwapchainData& drawData = frameData.drawToSwapchainData;
@@ -693,6 +810,182 @@ void ProjApp::SetupDrawToSwapchain()
     }
 }
 
+void ProjApp::SetupPostProcess()
+{
+    const uint32_t width       = GetSwapchain()->GetWidth();
+    const uint32_t height      = GetSwapchain()->GetHeight();
+    const uint32_t bloomWidth  = std::max<uint32_t>(width / 2, 1);
+    const uint32_t bloomHeight = std::max<uint32_t>(height / 2, 1);
+
+    PPX_CHECKED_CALL(mGraphicsQueue->GetTimestampFrequency(&mGraphicsTimestampFrequency));
+    PPX_CHECKED_CALL(mComputeQueue->GetTimestampFrequency(&mComputeTimestampFrequency));
+    PPX_CHECKED_CALL(mGraphicsQueue->GetTimestampOffset(mComputeQueue, &mComputeTimestampOffset));
+
+    // Descriptor layout for post-processing pipelines (BloomToneMap.hlsl)
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(1, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(2, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(3, grfx::DESCRIPTOR_TYPE_SAMPLER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(4, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mPostLayout));
+    }
+
+    // Post-processing pipelines
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mPostLayout;
+        piCreateInfo.pushConstants.count               = 8; // BloomToneMapParams
+        piCreateInfo.pushConstants.binding             = 0;
+        piCreateInfo.pushConstants.set                 = 0;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPostPipelineInterface));
+
+        const char*               shaderNames[3] = {"BloomExtract.cs", "BloomBlur.cs", "ToneMap.cs"};
+        grfx::ComputePipelinePtr* pipelines[3]   = {&mBloomExtractPipeline, &mBloomBlurPipeline, &mToneMapPipeline};
+        for (uint32_t i = 0; i < 3; ++i) {
+            grfx::ShaderModulePtr CS;
+
+            std::vector<char> bytecode = LoadShader("basic/shaders", shaderNames[i]);
+            PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+            grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+            PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &CS));
+
+            grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+            cpCreateInfo.CS                              = {CS.Get(), "csmain"};
+            cpCreateInfo.pPipelineInterface              = mPostPipelineInterface;
+            PPX_CHECKED_CALL(GetDevice()->CreateComputePipeline(&cpCreateInfo, pipelines[i]));
+
+            GetDevice()->DestroyShaderModule(CS);
+        }
+    }
+
+    // Compute queue images are left in NON_PIXEL_SHADER_RESOURCE between
+    // passes, D3D12 compute queues can't transition to pixel shader states.
+    auto createImage = [this](uint32_t imageWidth, uint32_t imageHeight, grfx::Format format, grfx::Image** ppImage, grfx::SampledImageView** ppSampledView, grfx::StorageImageView** ppStorageView) {
+        grfx::ImageCreateInfo ci   = {};
+        ci.type                    = grfx::IMAGE_TYPE_2D;
+        ci.width                   = imageWidth;
+        ci.height                  = imageHeight;
+        ci.depth                   = 1;
+        ci.format                  = format;
+        ci.usageFlags.bits.sampled = true;
+        ci.usageFlags.bits.storage = true;
+        ci.memoryUsage             = grfx::MEMORY_USAGE_GPU_ONLY;
+        ci.initialState            = grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&ci, ppImage));
+
+        grfx::SampledImageViewCreateInfo sampledViewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(*ppImage);
+        PPX_CHECKED_CALL(GetDevice()->CreateSampledImageView(&sampledViewCreateInfo, ppSampledView));
+
+        grfx::StorageImageViewCreateInfo storageViewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(*ppImage);
+        PPX_CHECKED_CALL(GetDevice()->CreateStorageImageView(&storageViewCreateInfo, ppStorageView));
+    };
+
+    auto writePostDescriptors = [this](grfx::DescriptorSet* pSet, const grfx::ImageView* pInput, const grfx::ImageView* pBloom, const grfx::ImageView* pOutput) {
+        grfx::WriteDescriptor writes[4] = {};
+        writes[0].binding               = 1;
+        writes[0].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[0].pImageView            = pInput;
+        writes[1].binding               = 2;
+        writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[1].pImageView            = pBloom;
+        writes[2].binding               = 3;
+        writes[2].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+        writes[2].pSampler              = mLinearSampler;
+        writes[3].binding               = 4;
+        writes[3].type                  = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[3].pImageView            = pOutput;
+        PPX_CHECKED_CALL(pSet->UpdateDescriptors(4, writes));
+    };
+
+    for (PostSlot& slot : mPostSlots) {
+        grfx::SemaphoreCreateInfo semaCreateInfo = {};
+        PPX_CHECKED_CALL(mGraphicsQueue->CreateCommandBuffer(&slot.sceneCmd));
+        PPX_CHECKED_CALL(mComputeQueue->CreateCommandBuffer(&slot.postCmd));
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &slot.sceneCompleteSemaphore));
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &slot.postCompleteSemaphore));
+
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2;
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &slot.sceneQuery));
+        PPX_CHECKED_CALL(GetDevice()->CreateQuery(&queryCreateInfo, &slot.postQuery));
+
+        // Scene, same descriptors as the image filters workload
+        {
+            grfx::BufferCreateInfo bufferCreateInfo        = {};
+            bufferCreateInfo.size                          = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+            bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+            bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+            PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &slot.sceneConstants));
+
+            PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mRenderLayout, &slot.sceneDescriptorSet));
+
+            grfx::WriteDescriptor writes[3] = {};
+            writes[0].binding               = 0;
+            writes[0].type                  = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[0].bufferOffset          = 0;
+            writes[0].bufferRange           = PPX_WHOLE_SIZE;
+            writes[0].pBuffer               = slot.sceneConstants;
+            writes[1].binding               = 1;
+            writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            writes[1].pImageView            = mModelTexture->GetSampledImageView();
+            writes[2].binding               = 2;
+            writes[2].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+            writes[2].pSampler              = mLinearSampler;
+            PPX_CHECKED_CALL(slot.sceneDescriptorSet->UpdateDescriptors(3, writes));
+
+            grfx::DrawPassCreateInfo dpCreateInfo     = {};
+            dpCreateInfo.width                        = width;
+            dpCreateInfo.height                       = height;
+            dpCreateInfo.depthStencilFormat           = grfx::FORMAT_D32_FLOAT;
+            dpCreateInfo.depthStencilClearValue       = {1.0f, 0};
+            dpCreateInfo.depthStencilInitialState     = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE;
+            dpCreateInfo.renderTargetCount            = 1;
+            dpCreateInfo.renderTargetFormats[0]       = grfx::FORMAT_R16G16B16A16_FLOAT;
+            dpCreateInfo.renderTargetClearValues[0]   = {0.05f, 0.07f, 0.12f, 1.0f};
+            dpCreateInfo.renderTargetInitialStates[0] = grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+            dpCreateInfo.renderTargetUsageFlags[0]    = grfx::IMAGE_USAGE_SAMPLED;
+            PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&dpCreateInfo, &slot.sceneDrawPass));
+        }
+
+        // Post-processing
+        {
+            for (uint32_t i = 0; i < 2; ++i) {
+                createImage(bloomWidth, bloomHeight, grfx::FORMAT_R16G16B16A16_FLOAT, &slot.bloomImages[i], &slot.bloomSampledViews[i], &slot.bloomStorageViews[i]);
+            }
+            createImage(width, height, grfx::FORMAT_R8G8B8A8_UNORM, &slot.outputImage, &slot.outputSampledView, &slot.outputStorageView);
+
+            for (grfx::DescriptorSetPtr& set : slot.postDescriptorSets) {
+                PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mPostLayout, &set));
+            }
+
+            // Every binding is written, the unused bloom input with the scene
+            const grfx::ImageView* pScene = slot.sceneDrawPass->GetRenderTargetTexture(0)->GetSampledImageView();
+            writePostDescriptors(slot.postDescriptorSets[0], pScene, pScene, slot.bloomStorageViews[0]);
+            writePostDescriptors(slot.postDescriptorSets[1], slot.bloomSampledViews[0], pScene, slot.bloomStorageViews[1]);
+            writePostDescriptors(slot.postDescriptorSets[2], slot.bloomSampledViews[1], pScene, slot.bloomStorageViews[0]);
+            writePostDescriptors(slot.postDescriptorSets[3], pScene, slot.bloomSampledViews[0], slot.outputStorageView);
+        }
+
+        // Draw to swapchain
+        {
+            PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDrawToSwapchainLayout, &slot.drawToSwapchainDescriptorSet));
+
+            grfx::WriteDescriptor writes[2] = {};
+            writes[0].binding               = 0;
+            writes[0].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            writes[0].pImageView            = slot.outputSampledView;
+            writes[1].binding               = 1;
+            writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+            writes[1].pSampler              = mLinearSampler;
+            PPX_CHECKED_CALL(slot.drawToSwapchainDescriptorSet->UpdateDescriptors(2, writes));
+        }
+    }
+}
+
 void ProjApp::MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons)
 {
     if (buttons & ppx::MOUSE_BUTTON_LEFT) {
@@ -721,6 +1014,11 @@ void ProjApp::UpdateTransforms(PerFrame& frame)
 
 void ProjApp::Render()
 {
+    if (mPostProcessEnabled) {
+        RenderPostProcess();
+        return;
+    }
+
     PerFrame& frame = mPerFrame[GetInFlightFrameIndex()];
 
     grfx::SwapchainPtr swapchain = GetSwapchain();
@@ -942,12 +1240,388 @@ void ProjApp::BlitAndPresent(PerFrame& frame, uint32_t swapchainImageIndex)
     PPX_CHECKED_CALL(GetSwapchain()->Present(swapchainImageIndex, 1, &frame.renderCompleteSemaphore));
 }
 
+void ProjApp::RenderPostProcess()
+{
+    PerFrame& frame      = mPerFrame[GetInFlightFrameIndex()];
+    uint32_t  imageIndex = AcquireFrame(frame);
+
+    // The render complete fence waited for was signaled after the frame
+    // rendered with this slot was presented, so the slot is free.
+    const uint64_t frameNumber = GetFrameCount();
+    PostSlot&      slot        = mPostSlots[frameNumber % kPostSlotCount];
+    ReadPostTimestamps(frame, slot);
+
+    UpdatePostTransform(slot);
+    DrawPostScene(slot);
+    RunPostProcess(slot);
+    slot.frame = frameNumber;
+
+    // Present the previous frame, its post-processing had this frame's
+    // scene to overlap with. There is nothing to present yet on the first
+    // frame.
+    PostSlot* pSource = (frameNumber > 0) ? &mPostSlots[(frameNumber - 1) % kPostSlotCount] : nullptr;
+    BlitAndPresentPost(frame, pSource, imageIndex);
+}
+
+void ProjApp::UpdatePostTransform(PostSlot& slot)
+{
+    mModelRotation += (mModelTargetRotation - mModelRotation) * 0.1f;
+
+    void* pMappedAddress = nullptr;
+    PPX_CHECKED_CALL(slot.sceneConstants->MapMemory(0, &pMappedAddress));
+
+    const float4x4& PV  = mCamera.GetViewProjectionMatrix();
+    float4x4        M   = glm::rotate(glm::radians(mModelRotation + 180.0f), float3(0, 1, 0));
+    float4x4        mat = PV * M;
+    memcpy(pMappedAddress, &mat, sizeof(mat));
+
+    slot.sceneConstants->UnmapMemory();
+}
+
+void ProjApp::DrawPostScene(PostSlot& slot)
+{
+    grfx::CommandBufferPtr cmd          = slot.sceneCmd;
+    grfx::Texture*         renderTarget = slot.sceneDrawPass->GetRenderTargetTexture(0);
+
+    slot.sceneQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(cmd->Begin());
+    {
+        cmd->WriteTimestamp(slot.sceneQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+
+        cmd->SetScissors(slot.sceneDrawPass->GetScissor());
+        cmd->SetViewports(slot.sceneDrawPass->GetViewport());
+
+        cmd->TransitionImageLayout(renderTarget, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_RENDER_TARGET);
+        cmd->BeginRenderPass(slot.sceneDrawPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS | grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_DEPTH);
+        {
+            cmd->BindGraphicsDescriptorSets(mRenderPipelineInterface, 1, &slot.sceneDescriptorSet);
+            cmd->BindGraphicsPipeline(mPostScenePipeline);
+            cmd->BindIndexBuffer(mModelMesh);
+            cmd->BindVertexBuffers(mModelMesh);
+            cmd->DrawIndexed(mModelMesh->GetIndexCount(), mGraphicsLoad);
+        }
+        cmd->EndRenderPass();
+        cmd->TransitionImageLayout(renderTarget, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+        // Release from graphics queue to compute queue.
+        if (mUseQueueFamilyTransfers) {
+            cmd->TransitionImageLayout(renderTarget, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mGraphicsQueue, mComputeQueue);
+        }
+
+        cmd->WriteTimestamp(slot.sceneQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        cmd->ResolveQueryData(slot.sceneQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(cmd->End());
+
+    grfx::SubmitInfo submitInfo     = {};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.ppCommandBuffers     = &cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.ppSignalSemaphores   = &slot.sceneCompleteSemaphore;
+
+    PPX_CHECKED_CALL(mGraphicsQueue->Submit(&submitInfo));
+}
+
+void ProjApp::RunPostProcess(PostSlot& slot)
+{
+    // Must match BloomToneMapParams in BloomToneMap.hlsl
+    struct BloomToneMapParams
+    {
+        float2 texelSize;
+        float2 direction;
+        float  exposure;
+        float  threshold;
+        float  bloomStrength;
+        float  padding;
+    };
+
+    grfx::CommandBufferPtr cmd          = slot.postCmd;
+    grfx::Texture*         renderTarget = slot.sceneDrawPass->GetRenderTargetTexture(0);
+
+    auto dispatch = [&](grfx::ComputePipeline* pPipeline, grfx::DescriptorSet* pSet, grfx::Image* pOutput, const float2& direction) {
+        BloomToneMapParams params = {};
+        params.texelSize          = float2(1.0f / pOutput->GetWidth(), 1.0f / pOutput->GetHeight());
+        params.direction          = direction;
+        params.exposure           = mExposure;
+        params.threshold          = mBloomThreshold;
+        params.bloomStrength      = mBloomStrength;
+
+        cmd->TransitionImageLayout(pOutput, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+        cmd->BindComputeDescriptorSets(mPostPipelineInterface, 1, &pSet);
+        cmd->BindComputePipeline(pPipeline);
+        cmd->PushComputeConstants(mPostPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+        cmd->Dispatch((pOutput->GetWidth() + 7) / 8, (pOutput->GetHeight() + 7) / 8, 1);
+        cmd->TransitionImageLayout(pOutput, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    };
+
+    slot.postQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(cmd->Begin());
+    {
+        cmd->WriteTimestamp(slot.postQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+
+        // Acquire from graphics queue to compute queue.
+        if (mUseQueueFamilyTransfers) {
+            cmd->TransitionImageLayout(renderTarget, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mGraphicsQueue, mComputeQueue);
+        }
+
+        dispatch(mBloomExtractPipeline, slot.postDescriptorSets[0], slot.bloomImages[0], float2(0, 0));
+        // The compute load widens the bloom with more blur passes
+        for (int i = 0; i < mComputeLoad; ++i) {
+            dispatch(mBloomBlurPipeline, slot.postDescriptorSets[1], slot.bloomImages[1], float2(1, 0));
+            dispatch(mBloomBlurPipeline, slot.postDescriptorSets[2], slot.bloomImages[0], float2(0, 1));
+        }
+        dispatch(mToneMapPipeline, slot.postDescriptorSets[3], slot.outputImage, float2(0, 0));
+
+        // Release from compute queue to graphics queue.
+        if (mUseQueueFamilyTransfers) {
+            cmd->TransitionImageLayout(slot.outputImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mComputeQueue, mGraphicsQueue);
+        }
+
+        cmd->WriteTimestamp(slot.postQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        cmd->ResolveQueryData(slot.postQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(cmd->End());
+
+    grfx::SubmitInfo submitInfo     = {};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.ppCommandBuffers     = &cmd;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.ppWaitSemaphores     = &slot.sceneCompleteSemaphore;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.ppSignalSemaphores   = &slot.postCompleteSemaphore;
+
+    // The graphics queue if async compute is disabled
+    PPX_CHECKED_CALL(mComputeQueue->Submit(&submitInfo));
+}
+
+void ProjApp::BlitAndPresentPost(PerFrame& frame, PostSlot* pSource, uint32_t swapchainImageIndex)
+{
+    grfx::RenderPassPtr renderPass = GetSwapchain()->GetRenderPass(swapchainImageIndex);
+    PPX_ASSERT_MSG(!renderPass.IsNull(), "swapchain render pass object is null");
+
+    grfx::CommandBufferPtr cmd = frame.drawToSwapchainData.cmd;
+
+    frame.blitQuery->Reset(0, 2);
+    PPX_CHECKED_CALL(cmd->Begin());
+    {
+        cmd->WriteTimestamp(frame.blitQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+
+        cmd->SetScissors(renderPass->GetScissor());
+        cmd->SetViewports(renderPass->GetViewport());
+        cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+        if (!IsNull(pSource)) {
+            // Acquire from compute queue to graphics queue.
+            if (mUseQueueFamilyTransfers) {
+                cmd->TransitionImageLayout(pSource->outputImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, mComputeQueue, mGraphicsQueue);
+            }
+            cmd->TransitionImageLayout(pSource->outputImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        }
+        cmd->BeginRenderPass(renderPass);
+        {
+            // Draw post-processed image to swapchain.
+            if (!IsNull(pSource)) {
+                cmd->Draw(mDrawToSwapchainPipeline, 1, &pSource->drawToSwapchainDescriptorSet);
+            }
+
+            // Draw ImGui.
+            DrawDebugInfo();
+            DrawImGui(cmd);
+        }
+        cmd->EndRenderPass();
+        if (!IsNull(pSource)) {
+            cmd->TransitionImageLayout(pSource->outputImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        }
+        cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+
+        cmd->WriteTimestamp(frame.blitQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        cmd->ResolveQueryData(frame.blitQuery, 0, 2);
+    }
+    PPX_CHECKED_CALL(cmd->End());
+
+    frame.blitFrame = IsNull(pSource) ? UINT64_MAX : pSource->frame;
+
+    std::vector<const grfx::Semaphore*> waitSemaphores = {frame.imageAcquiredSemaphore};
+    if (!IsNull(pSource)) {
+        waitSemaphores.push_back(pSource->postCompleteSemaphore);
+    }
+
+    grfx::SubmitInfo submitInfo     = {};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.ppCommandBuffers     = &cmd;
+    submitInfo.waitSemaphoreCount   = CountU32(waitSemaphores);
+    submitInfo.ppWaitSemaphores     = DataPtr(waitSemaphores);
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
+    submitInfo.pFence               = frame.renderCompleteFence;
+
+    PPX_CHECKED_CALL(mGraphicsQueue->Submit(&submitInfo));
+
+    PPX_CHECKED_CALL(GetSwapchain()->Present(swapchainImageIndex, 1, &frame.renderCompleteSemaphore));
+}
+
+ProjApp::PostTiming& ProjApp::GetPostTiming(uint64_t frameNumber)
+{
+    PostTiming& timing = mPostTimings[frameNumber % kPostTimingCount];
+    if (timing.frame != frameNumber) {
+        timing       = {};
+        timing.frame = frameNumber;
+    }
+    return timing;
+}
+
+void ProjApp::ReadPostTimestamps(PerFrame& frame, PostSlot& slot)
+{
+    const double graphicsPeriod = 1.0 / static_cast<double>(mGraphicsTimestampFrequency);
+    const double computePeriod  = 1.0 / static_cast<double>(mComputeTimestampFrequency);
+
+    uint64_t timestamps[2] = {0};
+    if (slot.frame != UINT64_MAX) {
+        PostTiming& timing = GetPostTiming(slot.frame);
+
+        PPX_CHECKED_CALL(slot.sceneQuery->GetData(timestamps, sizeof(timestamps)));
+        timing.scene[0] = timestamps[0] * graphicsPeriod;
+        timing.scene[1] = timestamps[1] * graphicsPeriod;
+        timing.hasScene = true;
+
+        PPX_CHECKED_CALL(slot.postQuery->GetData(timestamps, sizeof(timestamps)));
+        timing.post[0] = timestamps[0] * computePeriod + mComputeTimestampOffset;
+        timing.post[1] = timestamps[1] * computePeriod + mComputeTimestampOffset;
+        timing.hasPost = true;
+    }
+
+    if (frame.blitFrame != UINT64_MAX) {
+        PostTiming& timing = GetPostTiming(frame.blitFrame);
+
+        PPX_CHECKED_CALL(frame.blitQuery->GetData(timestamps, sizeof(timestamps)));
+        timing.blit[0] = timestamps[0] * graphicsPeriod;
+        timing.blit[1] = timestamps[1] * graphicsPeriod;
+        timing.hasBlit = true;
+
+        // The frame before now has the timestamps of the frames on both
+        // sides of it.
+        UpdatePostStats(frame.blitFrame - 1);
+    }
+}
+
+void ProjApp::UpdatePostStats(uint64_t frameNumber)
+{
+    // Needs the graphics work of the frames before and after
+    if ((frameNumber == 0) || (frameNumber == UINT64_MAX)) {
+        return;
+    }
+
+    const PostTiming* timings[3] = {};
+    for (uint32_t i = 0; i < 3; ++i) {
+        const PostTiming& timing = mPostTimings[(frameNumber - 1 + i) % kPostTimingCount];
+        if ((timing.frame != frameNumber - 1 + i) || !timing.hasScene || !timing.hasPost || !timing.hasBlit) {
+            return;
+        }
+        timings[i] = &timing;
+    }
+
+    // Post-processing time that the graphics queue was busy for
+    const PostTiming& current = *timings[1];
+    double            overlap = 0.0;
+    for (const PostTiming* pTiming : timings) {
+        for (const double* span : {pTiming->scene, pTiming->blit}) {
+            overlap += std::max(0.0, std::min(current.post[1], span[1]) - std::max(current.post[0], span[0]));
+        }
+    }
+
+    const double kSmoothing = 0.05;
+
+    mSceneMs += ((current.scene[1] - current.scene[0]) * 1000.0 - mSceneMs) * kSmoothing;
+    mPostMs += ((current.post[1] - current.post[0]) * 1000.0 - mPostMs) * kSmoothing;
+    mOverlapMs += (overlap * 1000.0 - mOverlapMs) * kSmoothing;
+
+    // Timeline from this frame's scene to the end of the next frame's work
+    const ImU32 kSceneColor = IM_COL32(100, 149, 237, 255);
+    const ImU32 kPostColor  = IM_COL32(255, 165, 0, 255);
+    const ImU32 kBlitColor  = IM_COL32(160, 160, 160, 255);
+    const ImU32 kAlphaMask  = IM_COL32(255, 255, 255, 96); // Other frames
+
+    const double start = current.scene[0];
+    double       end   = start;
+    mTimeline.clear();
+    for (uint32_t i = 0; i < 3; ++i) {
+        const PostTiming& timing = *timings[i];
+        const ImU32       mask   = (i == 1) ? IM_COL32_WHITE : kAlphaMask;
+        mTimeline.push_back({0, kSceneColor & mask, timing.scene[0] - start, timing.scene[1] - start});
+        mTimeline.push_back({1, kPostColor & mask, timing.post[0] - start, timing.post[1] - start});
+        mTimeline.push_back({0, kBlitColor & mask, timing.blit[0] - start, timing.blit[1] - start});
+        if (i > 0) {
+            end = std::max({end, timing.scene[1], timing.post[1], timing.blit[1]});
+        }
+    }
+    mTimelineFrame = frameNumber;
+    mTimelineMs    = (end - start) * 1000.0;
+}
+
+void ProjApp::DrawPostTimeline()
+{
+    if (mTimelineFrame == UINT64_MAX) {
+        ImGui::Text("Waiting for timestamps...");
+        return;
+    }
+
+    ImGui::Text("Scene: %.3f ms", mSceneMs);
+    ImGui::Text("Post-processing: %.3f ms", mPostMs);
+    ImGui::Text("Overlapped with graphics: %.3f ms (%.0f%%)", mOverlapMs, (mPostMs > 0.0) ? 100.0 * mOverlapMs / mPostMs : 0.0);
+
+    ImGui::Separator();
+    ImGui::Text("Frame %llu and the next, %.3f ms", static_cast<unsigned long long>(mTimelineFrame), mTimelineMs);
+    ImGui::TextColored(ImVec4(0.39f, 0.58f, 0.93f, 1.0f), "Scene");
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(1.0f, 0.65f, 0.0f, 1.0f), "Post-processing");
+    ImGui::SameLine();
+    ImGui::TextColored(ImVec4(0.63f, 0.63f, 0.63f, 1.0f), "Draw to swapchain");
+
+    const char*  queueNames[2] = {"Graphics", mAsyncComputeEnabled ? "Compute" : "Graphics (post)"};
+    const float  kLabelWidth   = 120.0f;
+    const float  kRowHeight    = 20.0f;
+    const float  width         = std::max(ImGui::GetContentRegionAvail().x, kLabelWidth + 200.0f);
+    const float  barsWidth     = width - kLabelWidth;
+    const ImVec2 origin        = ImGui::GetCursorScreenPos();
+
+    ImDrawList* pDrawList = ImGui::GetWindowDrawList();
+    for (uint32_t queue = 0; queue < 2; ++queue) {
+        const float y = origin.y + queue * (kRowHeight + 4.0f);
+        pDrawList->AddText(ImVec2(origin.x, y + 2.0f), IM_COL32_WHITE, queueNames[queue]);
+        pDrawList->AddRect(ImVec2(origin.x + kLabelWidth, y), ImVec2(origin.x + width, y + kRowHeight), IM_COL32(80, 80, 80, 255));
+    }
+
+    const double scale = (mTimelineMs > 0.0) ? barsWidth / (mTimelineMs / 1000.0) : 0.0;
+    for (const TimelineSpan& span : mTimeline) {
+        const double begin = std::max(span.begin, 0.0);
+        const double end   = std::min(span.end, mTimelineMs / 1000.0);
+        if (end <= begin) {
+            continue;
+        }
+        const float y = origin.y + span.queue * (kRowHeight + 4.0f);
+        pDrawList->AddRectFilled(
+            ImVec2(origin.x + kLabelWidth + static_cast<float>(begin * scale), y + 1.0f),
+            ImVec2(origin.x + kLabelWidth + static_cast<float>(end * scale), y + kRowHeight - 1.0f),
+            span.color);
+    }
+
+    ImGui::Dummy(ImVec2(width, 2.0f * (kRowHeight + 4.0f)));
+}
+
 void ProjApp::DrawGui()
 {
     ImGui::Separator();
 
     ImGui::SliderInt("Graphics Load", &mGraphicsLoad, 1, 500);
     ImGui::SliderInt("Compute Load", &mComputeLoad, 1, 20);
+
+    if (mPostProcessEnabled) {
+        ImGui::SliderFloat("Exposure", &mExposure, 0.1f, 4.0f);
+        ImGui::SliderFloat("Bloom Threshold", &mBloomThreshold, 0.0f, 2.0f);
+        ImGui::SliderFloat("Bloom Strength", &mBloomStrength, 0.0f, 2.0f);
+
+        ImGui::Separator();
+        DrawPostTimeline();
+    }
 }
 
 SETUP_APPLICATION(ProjApp)
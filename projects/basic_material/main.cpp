@@ -74,6 +74,7 @@ class ProjApp
     : public ppx::Application
 {
 public:
+    virtual void InitKnobs() override;
     virtual void Config(ppx::ApplicationSettings& settings) override;
     virtual void Setup() override;
     virtual void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
@@ -284,6 +285,9 @@ private:
         "Noon Grass",
     };
 
+    std::shared_ptr<KnobFlag<std::string>> mIBLHDRKnob;
+    std::shared_ptr<KnobFlag<std::string>> mIBLCacheDirKnob;
+
 private:
     void SetupSamplers();
     void SetupMaterialResources(
@@ -524,11 +528,41 @@ void ProjApp::SetupMaterials()
 
 void ProjApp::SetupIBL()
 {
-    // BRDF LUT
-    PPX_CHECKED_CALL(grfx_util::CreateTextureFromFile(
-        GetDevice()->GetGraphicsQueue(),
-        GetAssetPath("common/textures/ppx/brdf_lut.hdr"),
-        &mBRDFLUTTexture));
+    // Textures of an HDR passed with --ibl-hdr are generated on the GPU instead of baked offline
+    const bool                          useHDR = !mIBLHDRKnob->GetValue().empty();
+    grfx::ShaderModulePtr               iblShaders[4];
+    std::unique_ptr<grfx::IBLGenerator> iblGenerator;
+    if (useHDR) {
+        const char* shaderNames[4] = {"IBLProjectSH.cs", "IBLIrradiance.cs", "IBLPrefilter.cs", "IBLBRDFLUT.cs"};
+        for (uint32_t i = 0; i < 4; ++i) {
+            PPX_CHECKED_CALL(CreateShader("basic/shaders", shaderNames[i], &iblShaders[i]));
+        }
+
+        grfx::IBLGeneratorCreateInfo createInfo = {};
+        createInfo.pProjectSHShader             = iblShaders[0];
+        createInfo.pIrradianceShader            = iblShaders[1];
+        createInfo.pPrefilterShader             = iblShaders[2];
+        createInfo.pBRDFLUTShader               = iblShaders[3];
+
+        grfx::IBLGenerator* pGenerator = nullptr;
+        PPX_CHECKED_CALL(grfx::IBLGenerator::Create(GetDevice(), createInfo, &pGenerator));
+        iblGenerator.reset(pGenerator);
+    }
+
+    // BRDF LUT, the generated one matches the GGX conventions of the generated environment
+    if (useHDR) {
+        PPX_CHECKED_CALL(grfx_util::CreateBRDFLUTTexture(
+            GetDevice()->GetGraphicsQueue(),
+            iblGenerator.get(),
+            mIBLCacheDirKnob->GetValue(),
+            &mBRDFLUTTexture));
+    }
+    else {
+        PPX_CHECKED_CALL(grfx_util::CreateTextureFromFile(
+            GetDevice()->GetGraphicsQueue(),
+            GetAssetPath("common/textures/ppx/brdf_lut.hdr"),
+            &mBRDFLUTTexture));
+    }
 
     // Old Depot - good mix of diffused over head and bright exterior lighting from windows
     {
@@ -606,6 +640,37 @@ void ProjApp::SetupIBL()
             &reses.environmentTexture));
         mIBLResources.push_back(reses);
     }
+
+    // HDR from the command line, selected at startup
+    if (useHDR) {
+        IBLResources reses = {};
+        PPX_CHECKED_CALL(grfx_util::CreateIBLTexturesFromHDR(
+            GetDevice()->GetGraphicsQueue(),
+            iblGenerator.get(),
+            GetAssetPath(mIBLHDRKnob->GetValue()),
+            mIBLCacheDirKnob->GetValue(),
+            &reses.irradianceTexture,
+            &reses.environmentTexture));
+        mIBLResources.push_back(reses);
+        mIBLNames.push_back("Command Line HDR");
+
+        mIBLIndex        = CountU32(mIBLResources) - 1;
+        mCurrentIBLIndex = mIBLIndex;
+
+        iblGenerator.reset();
+        for (auto& shader : iblShaders) {
+            GetDevice()->DestroyShaderModule(shader);
+        }
+    }
+}
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&mIBLHDRKnob, "ibl-hdr", "");
+    mIBLHDRKnob->SetFlagDescription("Equirectangular HDR environment to light with, its IBL textures are generated on the GPU");
+
+    GetKnobManager().InitKnob(&mIBLCacheDirKnob, "ibl-cache-dir", "");
+    mIBLCacheDirKnob->SetFlagDescription("Directory the textures generated for --ibl-hdr are cached in, they are generated on every run if empty");
 }
 
 void ProjApp::Setup()
@@ -1475,7 +1540,7 @@ void ProjApp::DrawGui()
 
     ImGui::Separator();
 
-    static const char* currentIBLName = mIBLNames[0];
+    static const char* currentIBLName = mIBLNames[mIBLIndex];
     if (ImGui::BeginCombo("IBL Selection", currentIBLName)) {
         for (size_t i = 0; i < mIBLNames.size(); ++i) {
             bool isSelected = (currentIBLName == mIBLNames[i]);
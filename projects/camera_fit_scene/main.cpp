@@ -59,14 +59,15 @@ private:
     grfx::DescriptorSetLayoutPtr mDescriptorSetLayout;
     grfx::GraphicsPipelinePtr    mTrianglePipeline;
     Entity                       mCube;
-    grfx::GraphicsPipelinePtr    mWirePipeline;
-    Entity                       mWirePlane;
+    grfx::ShaderModulePtr        mLineVS;
+    grfx::ShaderModulePtr        mLinePS;
+    grfx::LineDrawPtr            mLineDraw;
 
     ArcballCamera mCamera;
 
 private:
     void SetupEntity(const TriMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity);
-    void SetupEntity(const WireMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity);
+    void AddSceneLines();
 };
 
 void ProjApp::Config(ppx::ApplicationSettings& settings)
@@ -98,27 +99,6 @@ void ProjApp::SetupEntity(const TriMesh& mesh, const GeometryCreateInfo& createI
     PPX_CHECKED_CALL(pEntity->descriptorSet->UpdateDescriptors(1, &write));
 }
 
-void ProjApp::SetupEntity(const WireMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity)
-{
-    PPX_CHECKED_CALL(grfx_util::CreateMeshFromWireMesh(GetGraphicsQueue(), &mesh, &pEntity->mesh));
-
-    grfx::BufferCreateInfo bufferCreateInfo        = {};
-    bufferCreateInfo.size                          = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
-    bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
-    bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
-    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &pEntity->uniformBuffer));
-
-    PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDescriptorSetLayout, &pEntity->descriptorSet));
-
-    grfx::WriteDescriptor write = {};
-    write.binding               = 0;
-    write.type                  = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    write.bufferOffset          = 0;
-    write.bufferRange           = PPX_WHOLE_SIZE;
-    write.pBuffer               = pEntity->uniformBuffer;
-    PPX_CHECKED_CALL(pEntity->descriptorSet->UpdateDescriptors(1, &write));
-}
-
 void ProjApp::Setup()
 {
     // Descriptor stuff
@@ -136,13 +116,9 @@ void ProjApp::Setup()
     {
         GeometryCreateInfo geometryCreateInfo = GeometryCreateInfo::Planar().AddColor();
         TriMeshOptions     triMeshOptions     = TriMeshOptions().Indices().VertexColors();
-        WireMeshOptions    wireMeshOptions    = WireMeshOptions().Indices().VertexColors();
 
         TriMesh triMesh = TriMesh::CreateCube(float3(2, 2, 2), triMeshOptions);
         SetupEntity(triMesh, geometryCreateInfo, &mCube);
-
-        WireMesh wireMesh = WireMesh::CreatePlane(WIRE_MESH_PLANE_POSITIVE_Y, float2(10, 10), 10, 10, wireMeshOptions);
-        SetupEntity(wireMesh, geometryCreateInfo, &mWirePlane);
     }
 
     // Pipelines
@@ -183,10 +159,27 @@ void ProjApp::Setup()
 
         // Triange pipeline
         PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mTrianglePipeline));
+    }
 
-        // Wire pipeline
-        gpCreateInfo.topology = grfx::PRIMITIVE_TOPOLOGY_LINE_LIST;
-        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mWirePipeline));
+    // Debug lines
+    {
+        std::vector<char> bytecode = LoadShader("basic/shaders", "VertexColorsPushConstants.vs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mLineVS));
+
+        bytecode = LoadShader("basic/shaders", "VertexColorsPushConstants.ps");
+        PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+        shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mLinePS));
+
+        grfx::LineDrawCreateInfo createInfo = {};
+        createInfo.maxLineCount             = 256;
+        createInfo.VS                       = {mLineVS.Get(), "vsmain"};
+        createInfo.PS                       = {mLinePS.Get(), "psmain"};
+        createInfo.renderTargetFormat       = GetSwapchain()->GetColorFormat();
+        createInfo.depthStencilFormat       = GetSwapchain()->GetDepthFormat();
+        PPX_CHECKED_CALL(GetDevice()->CreateLineDraw(&createInfo, &mLineDraw));
     }
 
     // Per frame data
@@ -216,6 +209,21 @@ void ProjApp::Setup()
     }
 }
 
+void ProjApp::AddSceneLines()
+{
+    // Plane grid
+    const uint32_t kCellCount = 10;
+    const float    kHalfSize  = 5.0f;
+    for (uint32_t i = 0; i <= kCellCount; ++i) {
+        float t = -kHalfSize + (2.0f * kHalfSize * i) / kCellCount;
+        mLineDraw->AddLine(float3(t, 0, -kHalfSize), float3(t, 0, kHalfSize), float3(0.7f));
+        mLineDraw->AddLine(float3(-kHalfSize, 0, t), float3(kHalfSize, 0, t), float3(0.7f));
+    }
+
+    // Bounds the F key fits the camera to
+    mLineDraw->AddBox(AABB(float3(-5, -0.01f, -5), float3(5, 0.01f, 5)), float3(1, 1, 0));
+}
+
 void ProjApp::MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons)
 {
     if (buttons & ppx::MOUSE_BUTTON_LEFT) {
@@ -277,12 +285,12 @@ void ProjApp::Render()
         float4x4 T   = glm::translate(float3(0, 1, 0));
         float4x4 mat = P * V * T;
         mCube.uniformBuffer->CopyFromSource(sizeof(mat), &mat);
-
-        T   = glm::translate(float3(0, 0, 0));
-        mat = P * V * T;
-        mWirePlane.uniformBuffer->CopyFromSource(sizeof(mat), &mat);
     }
 
+    // Frame 0's fence was waited on above
+    mLineDraw->BeginFrame(0);
+    AddSceneLines();
+
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
     {
@@ -311,16 +319,8 @@ void ProjApp::Render()
             frame.cmd->BindVertexBuffers(mCube.mesh);
             frame.cmd->DrawIndexed(mCube.mesh->GetIndexCount());
 
-            // -------------------------------------------------------------------------------------
-            //
-            // Wire pipeline
-            frame.cmd->BindGraphicsPipeline(mWirePipeline);
-
-            // Wire plane
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mWirePlane.descriptorSet);
-            frame.cmd->BindIndexBuffer(mWirePlane.mesh);
-            frame.cmd->BindVertexBuffers(mWirePlane.mesh);
-            frame.cmd->DrawIndexed(mWirePlane.mesh->GetIndexCount());
+            // Debug lines
+            mLineDraw->Draw(frame.cmd, mCamera.GetViewProjectionMatrix());
 
             // Draw ImGui
             DrawDebugInfo();
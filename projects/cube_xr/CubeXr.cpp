@@ -218,8 +218,12 @@ void CubeXrApp::Render()
         currentViewIndex = xrComponent.GetCurrentViewIndex();
     }
 
-    // Render UI into a different composition layer.
-    if (IsXrEnabled() && (currentViewIndex == 0) && GetSettings()->enableImGui) {
+    // Render UI into a different composition layer, only when it changed.
+    const bool drawUI = IsXrEnabled() && (currentViewIndex == 0) && GetSettings()->enableImGui;
+    if (drawUI) {
+        DrawDebugInfo();
+    }
+    if (drawUI && ShouldRenderUI()) {
         grfx::SwapchainPtr uiSwapchain = GetUISwapchain();
         PPX_CHECKED_CALL(uiSwapchain->AcquireNextImage(UINT64_MAX, nullptr, nullptr, &imageIndex));
         PPX_CHECKED_CALL(frame.uiRenderCompleteFence->WaitAndReset());
@@ -238,7 +242,6 @@ void CubeXrApp::Render()
 
             frame.uiCmd->BeginRenderPass(&beginInfo);
             // Draw ImGui
-            DrawDebugInfo();
             DrawImGui(frame.uiCmd);
             frame.uiCmd->EndRenderPass();
         }
@@ -37,5 +37,9 @@
 // u#
 #define RENDER_OUTPUT_POSITION_TEXTURE_REGISTER 16
 #define RENDER_OUTPUT_VELOCITY_TEXTURE_REGISTER 17
+#define RENDER_GRID_CELL_COUNT_REGISTER         18
+#define RENDER_GRID_CELL_START_REGISTER         19
+#define RENDER_GRID_FISH_CELL_REGISTER          20
+#define RENDER_GRID_SORTED_FISH_REGISTER        21
 
 #endif // CONFIG_H
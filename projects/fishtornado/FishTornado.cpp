@@ -413,6 +413,9 @@ void FishTornadoApp::Setup()
     PPX_ASSERT_MSG(mSettings.fishThreadsX < 65536, "Fish X threads out-of-range.");
     mSettings.fishThreadsY = clOptions.GetExtraOptionValueOrDefault<uint32_t>("ft-fish-threads-y", kDefaultFishThreadsY);
     PPX_ASSERT_MSG(mSettings.fishThreadsY < 65536, "Fish Y threads out of range.");
+    mSettings.fishCountScale = clOptions.GetExtraOptionValueOrDefault<uint32_t>("ft-fish-count-scale", kDefaultFishCountScale);
+    PPX_ASSERT_MSG((mSettings.fishCountScale >= 1) && (mSettings.fishCountScale <= kMaxFishCountScale), "Fish count scale out-of-range.");
+    mSettings.useSpatialGrid = !(clOptions.HasExtraOption("ft-disable-spatial-grid") && clOptions.GetExtraOptionValueOrDefault<bool>("ft-disable-spatial-grid", true));
 
     SetupDescriptorPool();
     SetupSetLayouts();
@@ -424,6 +427,24 @@ void FishTornadoApp::Setup()
     SetupDebug();
 
     const uint32_t numFramesInFlight = GetNumFramesInFlight();
+
+    // Schedules flocking on the compute queue, flocking registers its
+    // textures with it so it must exist before the scene is setup.
+    {
+        grfx::AsyncComputeSchedulerCreateInfo createInfo = {};
+        createInfo.pGraphicsQueue                        = GetGraphicsQueue();
+        createInfo.pComputeQueue                         = GetComputeQueue();
+        createInfo.frameCount                            = numFramesInFlight;
+        PPX_CHECKED_CALL(GetDevice()->CreateAsyncComputeScheduler(&createInfo, &mAsyncComputeScheduler));
+        mSubmitBatcher.SetQueue(GetGraphicsQueue());
+
+        if (HasActiveMetricsRun()) {
+            ppx::metrics::MetricMetadata metadata = {ppx::metrics::MetricType::GAUGE, "Async Compute Overlap", "ms", ppx::metrics::MetricInterpretation::HIGHER_IS_BETTER, {0.f, 60000.f}};
+            mAsyncComputeOverlapMetric            = AddMetric(metadata);
+            PPX_ASSERT_MSG(mAsyncComputeOverlapMetric != ppx::metrics::kInvalidMetricID, "Failed to add Async Compute Overlap metric");
+        }
+    }
+
     // Always setup all elements of the scene, even if they're not in use.
     mFlocking.Setup(numFramesInFlight, mSettings);
     mOcean.Setup(numFramesInFlight);
@@ -654,6 +675,9 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
     grfx::SwapchainPtr& swapchain,
     uint32_t            imageIndex)
 {
+    // The GUI can toggle async compute while the frame is recorded
+    const bool asyncCompute = mSettings.useAsyncCompute;
+
 #if defined(ENABLE_GPU_QUERIES)
     frame.startTimestampQuery->Reset(0, 1);
     frame.endTimestampQuery->Reset(0, 1);
@@ -674,7 +698,7 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.ppSignalSemaphores   = &frame.gpuStartTimestampSemaphore;
 
-        PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+        mSubmitBatcher.Add(&submitInfo);
     }
 #endif
 
@@ -722,41 +746,46 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.ppSignalSemaphores   = &frame.copyConstantsSemaphore;
 
-        PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+        mSubmitBatcher.Add(&submitInfo);
     }
 
     // ---------------------------------------------------------------------------------------------
 
     if (mSettings.renderFish) {
         grfx::CommandBuffer* pFlockingCmd = frame.grfxFlockingCmd;
-        if (mSettings.useAsyncCompute) {
+        if (asyncCompute) {
             pFlockingCmd = frame.asyncFlockingCmd;
         }
 
         // Compute flocking
         PPX_CHECKED_CALL(pFlockingCmd->Begin());
         {
-            mFlocking.BeginCompute(frameIndex, pFlockingCmd, mSettings.useAsyncCompute);
+            mFlocking.BeginCompute(frameIndex, pFlockingCmd, asyncCompute);
             mFlocking.Compute(frameIndex, pFlockingCmd);
-            mFlocking.EndCompute(frameIndex, pFlockingCmd, mSettings.useAsyncCompute);
+            mFlocking.EndCompute(frameIndex, pFlockingCmd, asyncCompute);
         }
         PPX_CHECKED_CALL(pFlockingCmd->End());
 
         // Submit flocking
         {
-            grfx::SubmitInfo submitInfo     = {};
-            submitInfo.commandBufferCount   = 1;
-            submitInfo.ppCommandBuffers     = &pFlockingCmd;
-            submitInfo.waitSemaphoreCount   = 1;
-            submitInfo.ppWaitSemaphores     = &frame.copyConstantsSemaphore;
-            submitInfo.signalSemaphoreCount = 1;
-            submitInfo.ppSignalSemaphores   = &frame.flockingCompleteSemaphore;
-
-            if (mSettings.useAsyncCompute) {
-                PPX_CHECKED_CALL(GetComputeQueue()->Submit(&submitInfo));
+            grfx::SubmitInfo submitInfo   = {};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.ppCommandBuffers   = &pFlockingCmd;
+            submitInfo.waitSemaphoreCount = 1;
+            submitInfo.ppWaitSemaphores   = &frame.copyConstantsSemaphore;
+
+            if (asyncCompute) {
+                // The compute queue waits on the constant copy's semaphore
+                PPX_CHECKED_CALL(mSubmitBatcher.Flush());
+
+                // Signals the scheduler's compute semaphore that the shadow submit waits on
+                PPX_CHECKED_CALL(mAsyncComputeScheduler->SubmitCompute(frameIndex, &submitInfo));
             }
             else {
-                PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+                submitInfo.signalSemaphoreCount = 1;
+                submitInfo.ppSignalSemaphores   = &frame.flockingCompleteSemaphore;
+
+                mSubmitBatcher.Add(&submitInfo);
             }
         }
     }
@@ -767,7 +796,7 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
     PPX_CHECKED_CALL(frame.shadowCmd->Begin());
     {
         if (mSettings.renderFish) {
-            mFlocking.BeginGraphics(frameIndex, frame.shadowCmd, mSettings.useAsyncCompute);
+            mFlocking.BeginGraphics(frameIndex, frame.shadowCmd, asyncCompute);
         }
         frame.shadowCmd->TransitionImageLayout(frame.shadowDrawPass, grfx::RESOURCE_STATE_UNDEFINED, grfx::RESOURCE_STATE_UNDEFINED, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
         frame.shadowCmd->BeginRenderPass(frame.shadowDrawPass);
@@ -800,7 +829,18 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         if (!mSettings.renderFish) {
             submitInfo.ppWaitSemaphores = &frame.copyConstantsSemaphore;
         }
-        PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+
+        if (mSettings.renderFish && asyncCompute) {
+            // Waits on the scheduler's compute semaphore instead
+            submitInfo.waitSemaphoreCount = 0;
+            submitInfo.ppWaitSemaphores   = nullptr;
+
+            PPX_CHECKED_CALL(mSubmitBatcher.Flush());
+            PPX_CHECKED_CALL(mAsyncComputeScheduler->SubmitGraphics(frameIndex, &submitInfo));
+        }
+        else {
+            mSubmitBatcher.Add(&submitInfo);
+        }
     }
 
     // ---------------------------------------------------------------------------------------------
@@ -855,7 +895,7 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
 
         if (mSettings.renderFish) {
-            mFlocking.EndGraphics(frameIndex, frame.cmd, mSettings.useAsyncCompute);
+            mFlocking.EndGraphics(frameIndex, frame.cmd, asyncCompute);
         }
     }
     PPX_CHECKED_CALL(frame.cmd->End());
@@ -873,7 +913,7 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
 
-        PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+        mSubmitBatcher.Add(&submitInfo);
     }
 
     // ---------------------------------------------------------------------------------------------
@@ -903,7 +943,7 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         submitInfo.ppSignalSemaphores   = &frame.frameCompleteSemaphore;
         submitInfo.pFence               = frame.frameCompleteFence;
 
-        PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+        mSubmitBatcher.Add(&submitInfo);
     }
 #else
     // Submit a wait for render complete and a signal for frame complete
@@ -915,9 +955,12 @@ void FishTornadoApp::RenderSceneUsingMultipleCommandBuffers(
         submitInfo.ppSignalSemaphores   = &frame.frameCompleteSemaphore;
         submitInfo.pFence               = frame.frameCompleteFence;
 
-        PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+        mSubmitBatcher.Add(&submitInfo);
     }
 #endif
+
+    // One queue submission for everything that wasn't flushed above
+    PPX_CHECKED_CALL(mSubmitBatcher.Flush());
 }
 
 void FishTornadoApp::Render()
@@ -950,6 +993,16 @@ void FishTornadoApp::Render()
     // Wait for and reset image acquired fence
     PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
 
+    // Async compute timings of the last frame that used this frame's resources
+    if (mAsyncComputeScheduler->ReadTimings(frameIndex, &mAsyncComputeTimings) == ppx::SUCCESS) {
+        if (HasActiveMetricsRun()) {
+            ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+            data.gauge.seconds            = GetElapsedSeconds();
+            data.gauge.value              = mAsyncComputeTimings.overlapMs;
+            RecordMetricData(mAsyncComputeOverlapMetric, data);
+        }
+    }
+
     // Read query results
     if (GetFrameCount() > 0) {
 #if defined(ENABLE_GPU_QUERIES)
@@ -992,6 +1045,16 @@ void FishTornadoApp::DrawGui()
         ImGui::Text("%f ms ", static_cast<float>(mTotalGpuFrameTime / static_cast<double>(frequency)) * 1000.0f);
         ImGui::NextColumn();
 
+        ImGui::Text("Async Compute Flocking Time");
+        ImGui::NextColumn();
+        ImGui::Text("%f ms ", static_cast<float>(mAsyncComputeTimings.computeMs));
+        ImGui::NextColumn();
+
+        ImGui::Text("Async Compute Overlap");
+        ImGui::NextColumn();
+        ImGui::Text("%f ms ", static_cast<float>(mAsyncComputeTimings.overlapMs));
+        ImGui::NextColumn();
+
         ImGui::Separator();
 
         ImGui::Text("Fish IAVertices");
@@ -24,6 +24,7 @@
 
 #include "ppx/ppx.h"
 #include "ppx/camera.h"
+#include "ppx/grfx/grfx_submit_batcher.h"
 
 #include <filesystem>
 
@@ -45,6 +46,8 @@ struct FishTornadoSettings
     uint32_t fishResY                 = kDefaultFishResY;
     uint32_t fishThreadsX             = kDefaultFishThreadsX;
     uint32_t fishThreadsY             = kDefaultFishThreadsY;
+    uint32_t fishCountScale           = kDefaultFishCountScale;
+    bool     useSpatialGrid           = true;
 };
 
 class FishTornadoApp
@@ -69,6 +72,7 @@ public:
     grfx::SamplerPtr             GetRepeatSampler() const { return mRepeatSampler; }
     grfx::PipelineInterfacePtr   GetForwardPipelineInterface() const { return mForwardPipelineInterface; }
     grfx::GraphicsPipelinePtr    GetDebugDrawPipeline() const { return mDebugDrawPipeline; }
+    grfx::AsyncComputeScheduler* GetAsyncComputeScheduler() const { return mAsyncComputeScheduler; }
 
     grfx::GraphicsPipelinePtr CreateForwardPipeline(
         const std::filesystem::path& baseDir,
@@ -141,6 +145,14 @@ private:
     bool                         mLastFrameWasAsyncCompute = false;
     FishTornadoSettings          mSettings;
 
+    // Async compute
+    grfx::AsyncComputeSchedulerPtr mAsyncComputeScheduler;
+    grfx::AsyncComputeTimings      mAsyncComputeTimings       = {};
+    ppx::metrics::MetricID         mAsyncComputeOverlapMetric = ppx::metrics::kInvalidMetricID;
+
+    // Graphics queue submits of the multiple command buffer path
+    grfx::SubmitBatcher mSubmitBatcher;
+
 private:
     void SetupDescriptorPool();
     void SetupSetLayouts();
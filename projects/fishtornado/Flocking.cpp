@@ -19,12 +19,47 @@
 #include "ppx/graphics_util.h"
 #include "ppx/random.h"
 
+#include <algorithm>
+#include <cstring>
+
 static uint32_t PreviousFrameIndex(uint32_t frameIndex, uint32_t numFrameInFlights)
 {
     uint32_t previousFrameIndex = (frameIndex == 0) ? (numFrameInFlights - 1) : (frameIndex)-1;
     return previousFrameIndex;
 }
 
+static grfx::BufferCreateInfo GridBufferCreateInfo(uint32_t elementCount, uint32_t elementSize)
+{
+    grfx::BufferCreateInfo createInfo             = {};
+    createInfo.size                               = std::max<uint64_t>(static_cast<uint64_t>(elementCount) * elementSize, PPX_MINIMUM_STRUCTURED_BUFFER_SIZE);
+    createInfo.structuredElementStride            = elementSize;
+    createInfo.usageFlags.bits.rwStructuredBuffer = true;
+    createInfo.usageFlags.bits.transferDst        = true;
+    createInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+    createInfo.initialState                       = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+    return createInfo;
+}
+
+static grfx::WriteDescriptor GridBufferWrite(uint32_t binding, grfx::Buffer* pBuffer)
+{
+    grfx::WriteDescriptor write  = {};
+    write.binding                = binding;
+    write.type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+    write.bufferOffset           = 0;
+    write.bufferRange            = PPX_WHOLE_SIZE;
+    write.structuredElementCount = static_cast<uint32_t>(pBuffer->GetSize() / pBuffer->GetStructuredElementStride());
+    write.pBuffer                = pBuffer;
+    return write;
+}
+
+// grfx has no UAV barrier: going through the shader resource state makes the writes of one
+// dispatch visible to the next one.
+static void GridBufferBarrier(grfx::CommandBuffer* pCmd, const grfx::Buffer* pBuffer)
+{
+    pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
 // -------------------------------------------------------------------------------------------------
 // Flocking
 // -------------------------------------------------------------------------------------------------
@@ -105,8 +140,21 @@ void Flocking::SetupSetLayouts()
     createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_PREVIOUS_POSITION_TEXTURE_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE}); // t1
     createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_PREVIOUS_VELOCITY_TEXTURE_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE}); // t2
     createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_OUTPUT_VELOCITY_TEXTURE_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE});   // u3
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_GRID_CELL_START_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER});    // u19
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_GRID_SORTED_FISH_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER});   // u21
     PPX_CHECKED_CALL(device->CreateDescriptorSetLayout(&createInfo, &mFlockingVelocitySetLayout));
 
+    // See FlockingGridCount.hlsl, FlockingGridScan.hlsl and FlockingGridScatter.hlsl
+    //
+    createInfo = {};
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_FLOCKING_DATA_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER});            // b0
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_PREVIOUS_POSITION_TEXTURE_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE}); // t1
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_GRID_CELL_COUNT_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER});    // u18
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_GRID_CELL_START_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER});    // u19
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_GRID_FISH_CELL_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER});     // u20
+    createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_GRID_SORTED_FISH_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER});   // u21
+    PPX_CHECKED_CALL(device->CreateDescriptorSetLayout(&createInfo, &mFlockingGridSetLayout));
+
     // See FlockingRender.hlsl
     createInfo = {};
     createInfo.bindings.push_back(grfx::DescriptorBinding{RENDER_FLOCKING_DATA_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER});            // b0
@@ -143,6 +191,24 @@ void Flocking::SetupSets()
         PPX_CHECKED_CALL(frame.velocitySet->UpdateSampledImage(RENDER_PREVIOUS_POSITION_TEXTURE_REGISTER, 0, prevFrame.positionTexture));
         PPX_CHECKED_CALL(frame.velocitySet->UpdateSampledImage(RENDER_PREVIOUS_VELOCITY_TEXTURE_REGISTER, 0, prevFrame.velocityTexture));
         PPX_CHECKED_CALL(frame.velocitySet->UpdateStorageImage(RENDER_OUTPUT_VELOCITY_TEXTURE_REGISTER, 0, frame.velocityTexture));
+        {
+            grfx::WriteDescriptor writes[2] = {
+                GridBufferWrite(RENDER_GRID_CELL_START_REGISTER, mGridCellStart),
+                GridBufferWrite(RENDER_GRID_SORTED_FISH_REGISTER, mGridSortedFish)};
+            PPX_CHECKED_CALL(frame.velocitySet->UpdateDescriptors(2, writes));
+        }
+
+        PPX_CHECKED_CALL(device->AllocateDescriptorSet(pool, mFlockingGridSetLayout, &frame.gridSet));
+        PPX_CHECKED_CALL(frame.gridSet->UpdateUniformBuffer(RENDER_FLOCKING_DATA_REGISTER, 0, frame.flockingConstants.GetGpuBuffer()));
+        PPX_CHECKED_CALL(frame.gridSet->UpdateSampledImage(RENDER_PREVIOUS_POSITION_TEXTURE_REGISTER, 0, prevFrame.positionTexture));
+        {
+            grfx::WriteDescriptor writes[4] = {
+                GridBufferWrite(RENDER_GRID_CELL_COUNT_REGISTER, mGridCellCount),
+                GridBufferWrite(RENDER_GRID_CELL_START_REGISTER, mGridCellStart),
+                GridBufferWrite(RENDER_GRID_FISH_CELL_REGISTER, mGridFishCell),
+                GridBufferWrite(RENDER_GRID_SORTED_FISH_REGISTER, mGridSortedFish)};
+            PPX_CHECKED_CALL(frame.gridSet->UpdateDescriptors(4, writes));
+        }
 
         PPX_CHECKED_CALL(device->AllocateDescriptorSet(pool, mRenderSetLayout, &frame.renderSet));
         PPX_CHECKED_CALL(frame.renderSet->UpdateUniformBuffer(RENDER_FLOCKING_DATA_REGISTER, 0, frame.flockingConstants.GetGpuBuffer()));
@@ -200,6 +266,14 @@ void Flocking::SetupPipelineInterfaces()
     createInfo.sets[0].set     = 0;
     createInfo.sets[0].pLayout = mFlockingVelocitySetLayout;
     PPX_CHECKED_CALL(device->CreatePipelineInterface(&createInfo, &mFlockingVelocityPipelineInterface));
+
+    // [set0] : resources for the spatial grid
+    //
+    createInfo                 = {};
+    createInfo.setCount        = 1;
+    createInfo.sets[0].set     = 0;
+    createInfo.sets[0].pLayout = mFlockingGridSetLayout;
+    PPX_CHECKED_CALL(device->CreatePipelineInterface(&createInfo, &mFlockingGridPipelineInterface));
 }
 
 void Flocking::SetupPipelines()
@@ -233,6 +307,45 @@ void Flocking::SetupPipelines()
         device->DestroyShaderModule(CS);
     }
 
+    // Flocking grid count
+    {
+        grfx::ShaderModulePtr CS;
+
+        PPX_CHECKED_CALL(pApp->CreateShader("fishtornado/shaders", "FlockingGridCount.cs", &CS));
+        grfx::ComputePipelineCreateInfo createInfo = {};
+        createInfo.CS                              = {CS, "csmain"};
+        createInfo.pPipelineInterface              = mFlockingGridPipelineInterface;
+        PPX_CHECKED_CALL(device->CreateComputePipeline(&createInfo, &mFlockingGridCountPipeline));
+
+        device->DestroyShaderModule(CS);
+    }
+
+    // Flocking grid scan
+    {
+        grfx::ShaderModulePtr CS;
+
+        PPX_CHECKED_CALL(pApp->CreateShader("fishtornado/shaders", "FlockingGridScan.cs", &CS));
+        grfx::ComputePipelineCreateInfo createInfo = {};
+        createInfo.CS                              = {CS, "csmain"};
+        createInfo.pPipelineInterface              = mFlockingGridPipelineInterface;
+        PPX_CHECKED_CALL(device->CreateComputePipeline(&createInfo, &mFlockingGridScanPipeline));
+
+        device->DestroyShaderModule(CS);
+    }
+
+    // Flocking grid scatter
+    {
+        grfx::ShaderModulePtr CS;
+
+        PPX_CHECKED_CALL(pApp->CreateShader("fishtornado/shaders", "FlockingGridScatter.cs", &CS));
+        grfx::ComputePipelineCreateInfo createInfo = {};
+        createInfo.CS                              = {CS, "csmain"};
+        createInfo.pPipelineInterface              = mFlockingGridPipelineInterface;
+        PPX_CHECKED_CALL(device->CreateComputePipeline(&createInfo, &mFlockingGridScatterPipeline));
+
+        device->DestroyShaderModule(CS);
+    }
+
     // Foward
     mForwardPipeline = pApp->CreateForwardPipeline("fishtornado/shaders", "FlockingRender.vs", "FlockingRender.ps", mForwardPipelineInterface);
 
@@ -240,6 +353,54 @@ void Flocking::SetupPipelines()
     mShadowPipeline = pApp->CreateShadowPipeline("fishtornado/shaders", "FlockingShadow.vs", mForwardPipelineInterface);
 }
 
+void Flocking::SetupGridBuffers(grfx::Queue* pQueue)
+{
+    grfx::DevicePtr device = FishTornadoApp::GetThisApp()->GetDevice();
+
+    // At least one bucket per fish, as a power of two so that hashes can be masked
+    const uint32_t fishCount = mResX * mResY;
+    mGridBucketCount         = 1;
+    while (mGridBucketCount < fishCount) {
+        mGridBucketCount <<= 1;
+    }
+
+    grfx::BufferCreateInfo createInfo = GridBufferCreateInfo(mGridBucketCount, sizeof(uint32_t));
+    PPX_CHECKED_CALL(device->CreateBuffer(&createInfo, &mGridCellCount));
+
+    createInfo = GridBufferCreateInfo(mGridBucketCount + 1, sizeof(uint32_t));
+    PPX_CHECKED_CALL(device->CreateBuffer(&createInfo, &mGridCellStart));
+
+    createInfo = GridBufferCreateInfo(fishCount, sizeof(uint2));
+    PPX_CHECKED_CALL(device->CreateBuffer(&createInfo, &mGridFishCell));
+
+    createInfo = GridBufferCreateInfo(fishCount, sizeof(uint32_t));
+    PPX_CHECKED_CALL(device->CreateBuffer(&createInfo, &mGridSortedFish));
+
+    // FlockingGridScan.hlsl clears the counts once it's done with them, they only need to be
+    // cleared once here.
+    {
+        grfx::BufferCreateInfo zeroCreateInfo      = {};
+        zeroCreateInfo.size                        = mGridCellCount->GetSize();
+        zeroCreateInfo.usageFlags.bits.transferSrc = true;
+        zeroCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        zeroCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+
+        grfx::BufferPtr zeroBuffer;
+        PPX_CHECKED_CALL(device->CreateBuffer(&zeroCreateInfo, &zeroBuffer));
+
+        void* pMappedAddress = nullptr;
+        PPX_CHECKED_CALL(zeroBuffer->MapMemory(0, &pMappedAddress));
+        memset(pMappedAddress, 0, static_cast<size_t>(zeroCreateInfo.size));
+        zeroBuffer->UnmapMemory();
+
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = zeroCreateInfo.size;
+        PPX_CHECKED_CALL(pQueue->CopyBufferToBuffer(&copyInfo, zeroBuffer, mGridCellCount, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_UNORDERED_ACCESS));
+
+        device->DestroyBuffer(zeroBuffer);
+    }
+}
+
 void Flocking::Setup(uint32_t numFramesInFlight, const FishTornadoSettings& settings)
 {
     FishTornadoApp*         pApp   = FishTornadoApp::GetThisApp();
@@ -247,12 +408,13 @@ void Flocking::Setup(uint32_t numFramesInFlight, const FishTornadoSettings& sett
     grfx::QueuePtr          queue  = pApp->GetGraphicsQueue();
     grfx::DescriptorPoolPtr pool   = pApp->GetDescriptorPool();
 
-    mThreadsX = settings.fishThreadsX;
-    mThreadsY = settings.fishThreadsY;
+    mThreadsX       = settings.fishThreadsX;
+    mThreadsY       = settings.fishThreadsY;
+    mUseSpatialGrid = settings.useSpatialGrid;
 
     // Round up resolution to nearest mThreadsX and mThreadsY.
     mResX = RoundUp<uint32_t>(settings.fishResX, mThreadsX);
-    mResY = RoundUp<uint32_t>(settings.fishResY, mThreadsY);
+    mResY = RoundUp<uint32_t>(settings.fishResY * settings.fishCountScale, mThreadsY);
 
     // Fill initial data for velocity texture
     Bitmap velocityData = Bitmap::Create(mResX, mResY, ppx::Bitmap::FORMAT_RGBA_FLOAT);
@@ -267,6 +429,9 @@ void Flocking::Setup(uint32_t numFramesInFlight, const FishTornadoSettings& sett
     SetupPipelineInterfaces();
     SetupPipelines();
 
+    // The grid is only ever accessed by the queue running the flocking compute
+    SetupGridBuffers(settings.useAsyncCompute ? pApp->GetComputeQueue() : queue);
+
     // Per frame
     mPerFrame.resize(numFramesInFlight);
     for (uint32_t i = 0; i < numFramesInFlight; ++i) {
@@ -278,6 +443,11 @@ void Flocking::Setup(uint32_t numFramesInFlight, const FishTornadoSettings& sett
         PPX_CHECKED_CALL(grfx_util::CreateTextureFromBitmap(queue, &positionData, &frame.positionTexture, textureOptions));
         PPX_CHECKED_CALL(grfx_util::CreateTextureFromBitmap(queue, &velocityData, &frame.velocityTexture, textureOptions));
 
+        // Written on the compute queue and read on the graphics queue when using async compute
+        grfx::AsyncComputeScheduler* pScheduler = pApp->GetAsyncComputeScheduler();
+        PPX_CHECKED_CALL(pScheduler->AddSharedImage(i, frame.velocityTexture->GetImage(), grfx::RESOURCE_STATE_SHADER_RESOURCE));
+        PPX_CHECKED_CALL(pScheduler->AddSharedImage(i, frame.positionTexture->GetImage(), grfx::RESOURCE_STATE_SHADER_RESOURCE));
+
         PPX_CHECKED_CALL(device->AllocateDescriptorSet(pool, mFlockingPositionSetLayout, &frame.positionSet));
         PPX_CHECKED_CALL(device->AllocateDescriptorSet(pool, mFlockingVelocitySetLayout, &frame.velocitySet));
     }
@@ -312,6 +482,11 @@ void Flocking::Shutdown()
         device->DestroyTexture(frame.velocityTexture);
     }
 
+    device->DestroyBuffer(mGridCellCount);
+    device->DestroyBuffer(mGridCellStart);
+    device->DestroyBuffer(mGridFishCell);
+    device->DestroyBuffer(mGridSortedFish);
+
     mMaterialConstants.Destroy();
 }
 
@@ -342,6 +517,8 @@ void Flocking::Update(uint32_t frameIndex)
         pFlockingData->timeDelta          = dt;
         pFlockingData->predPos            = pApp->GetShark()->GetPosition();
         pFlockingData->camPos             = pApp->GetCamera()->GetEyePosition();
+        pFlockingData->gridMask           = mGridBucketCount - 1;
+        pFlockingData->useGrid            = mUseSpatialGrid ? 1 : 0;
     }
 }
 
@@ -382,14 +559,9 @@ void Flocking::CopyConstantsToGpu(uint32_t frameIndex, grfx::CommandBuffer* pCmd
 
 void Flocking::BeginCompute(uint32_t frameIndex, grfx::CommandBuffer* pCmd, bool asyncCompute)
 {
-    PerFrame& frame = mPerFrame[frameIndex];
-
     // Acquire from graphics queue to compute queue.
-    if (asyncCompute && frame.renderedWithAsyncCompute) {
-        FishTornadoApp* pApp = FishTornadoApp::GetThisApp();
-
-        pCmd->TransitionImageLayout(frame.velocityTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetGraphicsQueue(), pApp->GetComputeQueue());
-        pCmd->TransitionImageLayout(frame.positionTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetGraphicsQueue(), pApp->GetComputeQueue());
+    if (asyncCompute) {
+        FishTornadoApp::GetThisApp()->GetAsyncComputeScheduler()->BeginCompute(frameIndex, pCmd);
     }
 }
 
@@ -401,6 +573,26 @@ void Flocking::Compute(uint32_t frameIndex, grfx::CommandBuffer* pCmd)
 
     PerFrame& frame = mPerFrame[frameIndex];
 
+    // Spatial grid: count the fish in each bucket, turn the counts into the start of each bucket
+    // and sort the fish by bucket.
+    if (mUseSpatialGrid) {
+        pCmd->BindComputeDescriptorSets(mFlockingGridPipelineInterface, 1, &frame.gridSet);
+
+        pCmd->BindComputePipeline(mFlockingGridCountPipeline);
+        pCmd->Dispatch(groupCountX, groupCountY, groupCountZ);
+        GridBufferBarrier(pCmd, mGridCellCount);
+        GridBufferBarrier(pCmd, mGridFishCell);
+
+        pCmd->BindComputePipeline(mFlockingGridScanPipeline);
+        pCmd->Dispatch(1, 1, 1);
+        GridBufferBarrier(pCmd, mGridCellCount);
+        GridBufferBarrier(pCmd, mGridCellStart);
+
+        pCmd->BindComputePipeline(mFlockingGridScatterPipeline);
+        pCmd->Dispatch(groupCountX, groupCountY, groupCountZ);
+        GridBufferBarrier(pCmd, mGridSortedFish);
+    }
+
     // Velocity
     {
         pCmd->TransitionImageLayout(frame.velocityTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
@@ -428,10 +620,7 @@ void Flocking::EndCompute(uint32_t frameIndex, grfx::CommandBuffer* pCmd, bool a
 {
     // Release from compute queue to graphics queue.
     if (asyncCompute) {
-        FishTornadoApp* pApp  = FishTornadoApp::GetThisApp();
-        PerFrame&       frame = mPerFrame[frameIndex];
-        pCmd->TransitionImageLayout(frame.velocityTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetComputeQueue(), pApp->GetGraphicsQueue());
-        pCmd->TransitionImageLayout(frame.positionTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetComputeQueue(), pApp->GetGraphicsQueue());
+        FishTornadoApp::GetThisApp()->GetAsyncComputeScheduler()->EndCompute(frameIndex, pCmd);
     }
 }
 
@@ -439,10 +628,7 @@ void Flocking::BeginGraphics(uint32_t frameIndex, grfx::CommandBuffer* pCmd, boo
 {
     // Acquire from compute queue to graphics queue.
     if (asyncCompute) {
-        FishTornadoApp* pApp  = FishTornadoApp::GetThisApp();
-        PerFrame&       frame = mPerFrame[frameIndex];
-        pCmd->TransitionImageLayout(frame.velocityTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetComputeQueue(), pApp->GetGraphicsQueue());
-        pCmd->TransitionImageLayout(frame.positionTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetComputeQueue(), pApp->GetGraphicsQueue());
+        FishTornadoApp::GetThisApp()->GetAsyncComputeScheduler()->BeginGraphics(frameIndex, pCmd);
     }
 }
 
@@ -492,17 +678,8 @@ void Flocking::DrawForward(uint32_t frameIndex, grfx::CommandBuffer* pCmd)
 
 void Flocking::EndGraphics(uint32_t frameIndex, grfx::CommandBuffer* pCmd, bool asyncCompute)
 {
-    PerFrame& frame = mPerFrame[frameIndex];
-
     // Release from graphics queue to compute queue.
     if (asyncCompute) {
-        FishTornadoApp* pApp = FishTornadoApp::GetThisApp();
-
-        pCmd->TransitionImageLayout(frame.velocityTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetGraphicsQueue(), pApp->GetComputeQueue());
-        pCmd->TransitionImageLayout(frame.positionTexture, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE, pApp->GetGraphicsQueue(), pApp->GetComputeQueue());
-        frame.renderedWithAsyncCompute = true;
-    }
-    else {
-        frame.renderedWithAsyncCompute = false;
+        FishTornadoApp::GetThisApp()->GetAsyncComputeScheduler()->EndGraphics(frameIndex, pCmd);
     }
 }
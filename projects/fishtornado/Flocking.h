@@ -25,6 +25,10 @@ constexpr uint32_t kDefaultFishResY     = 128;
 constexpr uint32_t kDefaultFishThreadsX = 8;
 constexpr uint32_t kDefaultFishThreadsY = 8;
 
+// Multiplies the number of fish rows, fish count scales linearly with it.
+constexpr uint32_t kDefaultFishCountScale = 1;
+constexpr uint32_t kMaxFishCountScale     = 16;
+
 class FishTornadoApp;
 struct FishTornadoSettings;
 
@@ -54,6 +58,7 @@ private:
     void SetupSets();
     void SetupPipelineInterfaces();
     void SetupPipelines();
+    void SetupGridBuffers(grfx::Queue* pQueue);
 
 private:
     struct PerFrame
@@ -66,8 +71,7 @@ private:
         grfx::DescriptorSetPtr positionSet;
         grfx::DescriptorSetPtr velocitySet;
         grfx::DescriptorSetPtr renderSet;
-
-        bool renderedWithAsyncCompute = false;
+        grfx::DescriptorSetPtr gridSet;
     };
 
     uint32_t mResX     = kDefaultFishResX;
@@ -80,12 +84,26 @@ private:
     float    mMaxSpeed;
     float    mZoneRadius;
 
+    // Spatial hash grid rebuilt every frame so that each fish only visits the fish in the
+    // neighboring cells, see FlockingGrid.hlsli. Falls back to visiting every fish when disabled.
+    bool            mUseSpatialGrid  = true;
+    uint32_t        mGridBucketCount = 0;
+    grfx::BufferPtr mGridCellCount   = nullptr;
+    grfx::BufferPtr mGridCellStart   = nullptr;
+    grfx::BufferPtr mGridFishCell    = nullptr;
+    grfx::BufferPtr mGridSortedFish  = nullptr;
+
     grfx::DescriptorSetLayoutPtr mFlockingPositionSetLayout;
     grfx::DescriptorSetLayoutPtr mFlockingVelocitySetLayout;
     grfx::PipelineInterfacePtr   mFlockingPositionPipelineInterface;
     grfx::PipelineInterfacePtr   mFlockingVelocityPipelineInterface;
     grfx::ComputePipelinePtr     mFlockingPositionPipeline;
     grfx::ComputePipelinePtr     mFlockingVelocityPipeline;
+    grfx::DescriptorSetLayoutPtr mFlockingGridSetLayout;
+    grfx::PipelineInterfacePtr   mFlockingGridPipelineInterface;
+    grfx::ComputePipelinePtr     mFlockingGridCountPipeline;
+    grfx::ComputePipelinePtr     mFlockingGridScanPipeline;
+    grfx::ComputePipelinePtr     mFlockingGridScatterPipeline;
     grfx::DescriptorSetLayoutPtr mRenderSetLayout;
     grfx::PipelineInterfacePtr   mForwardPipelineInterface;
     grfx::GraphicsPipelinePtr    mForwardPipeline;
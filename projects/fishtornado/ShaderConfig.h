@@ -89,6 +89,8 @@ struct FlockingData
     hlsl_float<4>   timeDelta;
     hlsl_float3<12> predPos;
     hlsl_float3<12> camPos;
+    hlsl_uint<4>    gridMask;
+    hlsl_uint<4>    useGrid;
 };
 PPX_HLSL_PACK_END();
 
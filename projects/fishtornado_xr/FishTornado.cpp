@@ -1024,8 +1024,12 @@ void FishTornadoApp::Render()
         currentViewIndex = GetXrComponent().GetCurrentViewIndex();
     }
 
-    // Render UI into a different composition layer.
-    if (IsXrEnabled() && (currentViewIndex == 0) && GetSettings()->enableImGui) {
+    // Render UI into a different composition layer, only when it changed.
+    const bool drawUI = IsXrEnabled() && (currentViewIndex == 0) && GetSettings()->enableImGui;
+    if (drawUI) {
+        DrawDebugInfo();
+    }
+    if (drawUI && ShouldRenderUI()) {
         grfx::SwapchainPtr uiSwapchain = GetUISwapchain();
         PPX_CHECKED_CALL(uiSwapchain->AcquireNextImage(UINT64_MAX, nullptr, nullptr, &imageIndex));
         PPX_CHECKED_CALL(frame.uiRenderCompleteFence->WaitAndReset());
@@ -1044,7 +1048,6 @@ void FishTornadoApp::Render()
 
             frame.uiCmd->BeginRenderPass(&beginInfo);
             // Draw ImGui
-            DrawDebugInfo();
             DrawImGui(frame.uiCmd);
             frame.uiCmd->EndRenderPass();
         }
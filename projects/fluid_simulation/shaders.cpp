@@ -44,6 +44,8 @@ std::ostream& operator<<(std::ostream& os, const FluidSim::ScalarInput& i)
     os << "weight:             [" << offsetof(FluidSim::ScalarInput, weight) << "]: " << i.weight << "\n";
     os << "curl:               [" << offsetof(FluidSim::ScalarInput, curl) << "]: " << i.curl << "\n";
     os << "normalizationScale: [" << offsetof(FluidSim::ScalarInput, normalizationScale) << "]: " << i.normalizationScale << "\n";
+    os << "filterOptions:      [" << offsetof(FluidSim::ScalarInput, filterOptions) << "]: " << i.filterOptions << "\n";
+    os << "iterations:         [" << offsetof(FluidSim::ScalarInput, iterations) << "]: " << i.iterations << "\n";
     return os;
 }
 
@@ -142,8 +144,8 @@ void SimulationGrid::Draw(const PerFrame& frame, ppx::float2 coord)
     frame.cmd->Draw(6, 1, 0, 0);
 }
 
-ComputeShader::ComputeShader(const std::string& shaderFile, const std::vector<uint32_t>& gridBindingSlots)
-    : mShaderFile(shaderFile), mGridBindingSlots(gridBindingSlots)
+ComputeShader::ComputeShader(const std::string& shaderFile, const std::vector<uint32_t>& gridBindingSlots, ppx::uint2 groupSize)
+    : mShaderFile(shaderFile), mGridBindingSlots(gridBindingSlots), mGroupSize(groupSize)
 {
     FluidSimulationApp* pApp = FluidSimulationApp::GetThisApp();
 
@@ -218,7 +220,7 @@ void ComputeShader::Dispatch(PerFrame* pFrame, const std::vector<SimulationGrid*
     pDispatchData->mUniformBuffer->UnmapMemory();
 
     // Queue the dispatch operation.
-    ppx::uint3 dispatchSize = ppx::uint3(pOutput->GetWidth(), pOutput->GetHeight(), 1);
+    ppx::uint3 dispatchSize = ppx::uint3((pOutput->GetWidth() + mGroupSize.x - 1) / mGroupSize.x, (pOutput->GetHeight() + mGroupSize.y - 1) / mGroupSize.y, 1);
     pFrame->cmd->TransitionImageLayout(pOutput->GetImage(), PPX_ALL_SUBRESOURCES, ppx::grfx::RESOURCE_STATE_SHADER_RESOURCE, ppx::grfx::RESOURCE_STATE_UNORDERED_ACCESS);
     pFrame->cmd->BindComputeDescriptorSets(pApp->GetComputePipelineInterface(), 1, &pDispatchData->mDescriptorSet);
     pFrame->cmd->BindComputePipeline(mPipeline);
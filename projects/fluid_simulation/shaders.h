@@ -132,12 +132,17 @@ struct alignas(16) ScalarInput
     float       curl               = .0f;
     ppx::float2 normalizationScale = ppx::float2();
     uint32_t    filterOptions      = 0;
+    uint32_t    iterations         = 0;
 };
 
 class ComputeShader
 {
 public:
-    ComputeShader(const std::string& shaderFile, const std::vector<uint32_t>& gridBindingSlots);
+    // shaderFile        Name of the compiled shader in assets/fluid_simulation/shaders.
+    // gridBindingSlots  Binding slots of the grids given to Dispatch().
+    // groupSize         Thread group size declared by the shader's numthreads attribute. The
+    //                       dispatch covers the output grid with as many groups as needed.
+    ComputeShader(const std::string& shaderFile, const std::vector<uint32_t>& gridBindingSlots, ppx::uint2 groupSize = ppx::uint2(1, 1));
 
     const std::string& GetName() const { return mShaderFile; }
 
@@ -154,6 +159,7 @@ private:
     ppx::grfx::ComputePipelinePtr mPipeline;
     std::string                   mShaderFile;
     std::vector<uint32_t>         mGridBindingSlots;
+    ppx::uint2                    mGroupSize;
 };
 
 } // namespace FluidSim
@@ -24,6 +24,7 @@
 #include "ppx/knob.h"
 #include "ppx/math_config.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <float.h>
@@ -44,6 +45,9 @@ const ppx::Bitmap::Format kR    = ppx::Bitmap::FORMAT_R_FLOAT;
 const ppx::Bitmap::Format kRG   = ppx::Bitmap::FORMAT_RG_FLOAT;
 const ppx::Bitmap::Format kRGBA = ppx::Bitmap::FORMAT_RGBA_FLOAT;
 
+// Choices of the --pressure-solver knob, indexed by PressureSolver.
+const std::vector<std::string> kPressureSolverChoices = {"jacobi", "fused-jacobi", "multigrid"};
+
 void FluidSimulationApp::InitKnobs()
 {
     size_t indent = 2;
@@ -65,9 +69,20 @@ void FluidSimulationApp::InitKnobs()
     mConfig.pPressure->SetDisplayName("Pressure");
     mConfig.pPressure->SetFlagDescription("Indicates the force exerted by the fluid on its surrounding boundaries. Higher values cause a greater force exerted on the boundaries. This can lead to denser regions in the fluid.");
 
+    GetKnobManager().InitKnob(&mConfig.pPressureSolver, "pressure-solver", kPressureSolverFusedJacobi, kPressureSolverChoices);
+    mConfig.pPressureSolver->SetDisplayName("Pressure Solver");
+    mConfig.pPressureSolver->SetFlagDescription("Selects how the pressure field is solved. 'jacobi' runs one dispatch per iteration. 'fused-jacobi' produces the same result but runs several iterations per dispatch out of group shared memory. 'multigrid' runs V-cycles over a hierarchy of coarser grids, which converges in far fewer passes on large grids.");
+
     GetKnobManager().InitKnob(&mConfig.pPressureIterations, "pressure-iterations", 20, 1, 100);
     mConfig.pPressureIterations->SetDisplayName("Pressure Iterations");
     mConfig.pPressureIterations->SetFlagDescription("This is the number of iterations performed when solving the pressure field. Higher values produce a more accurate and detailed pressure computation.");
+    mConfig.pPressureIterations->SetIndent(indent);
+
+    GetKnobManager().InitKnob(&mConfig.pMultigridCycles, "multigrid-cycles", 2, 1, 4);
+    mConfig.pMultigridCycles->SetDisplayName("Multigrid Cycles");
+    mConfig.pMultigridCycles->SetFlagDescription("This is the number of V-cycles performed by the multigrid pressure solver. Higher values produce a more accurate pressure computation.");
+    mConfig.pMultigridCycles->SetIndent(indent);
+    mConfig.pMultigridCycles->SetVisible(false);
 
     GetKnobManager().InitKnob(&mConfig.pVelocityDissipation, "velocity-dissipation", 0.2f, 0.0f, 1.0f);
     mConfig.pVelocityDissipation->SetDisplayName("Velocity Dissipations");
@@ -194,10 +209,10 @@ void FluidSimulationApp::Setup()
 {
     // Create descriptor pool shared by all pipelines.
     ppx::grfx::DescriptorPoolCreateInfo dpci = {};
-    dpci.sampler                             = 1024;
-    dpci.sampledImage                        = 1024;
-    dpci.uniformBuffer                       = 1024;
-    dpci.storageImage                        = 1024;
+    dpci.sampler                             = 2048;
+    dpci.sampledImage                        = 2048;
+    dpci.uniformBuffer                       = 2048;
+    dpci.storageImage                        = 2048;
     PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&dpci, &mDescriptorPool));
 
     // Frame synchronization data.
@@ -285,6 +300,9 @@ void FluidSimulationApp::SetupComputeShaders()
     mDivergence        = std::make_unique<ComputeShader>("divergence", std::vector<uint32_t>({kUVelocityBindingSlot, kOutputBindingSlot}));
     mGradientSubtract  = std::make_unique<ComputeShader>("gradient_subtract", std::vector<uint32_t>({kUPressureBindingSlot, kUVelocityBindingSlot, kOutputBindingSlot}));
     mPressure          = std::make_unique<ComputeShader>("pressure", std::vector<uint32_t>({kUPressureBindingSlot, kUDivergenceBindingSlot, kOutputBindingSlot}));
+    mPressureFused     = std::make_unique<ComputeShader>("pressure_fused", std::vector<uint32_t>({kUPressureBindingSlot, kUDivergenceBindingSlot, kOutputBindingSlot}), ppx::uint2(kPressureGroupSize, kPressureGroupSize));
+    mPressureProlong   = std::make_unique<ComputeShader>("pressure_prolongate", std::vector<uint32_t>({kUPressureBindingSlot, kUSourceBindingSlot, kOutputBindingSlot}), ppx::uint2(kMultigridGroupSize, kMultigridGroupSize));
+    mPressureRestrict  = std::make_unique<ComputeShader>("pressure_restrict", std::vector<uint32_t>({kUPressureBindingSlot, kUDivergenceBindingSlot, kOutputBindingSlot}), ppx::uint2(kMultigridGroupSize, kMultigridGroupSize));
     mSplat             = std::make_unique<ComputeShader>("splat", std::vector<uint32_t>({kUTextureBindingSlot, kOutputBindingSlot}));
     mSunrays           = std::make_unique<ComputeShader>("sunrays", std::vector<uint32_t>({kUTextureBindingSlot, kOutputBindingSlot}));
     mSunraysMask       = std::make_unique<ComputeShader>("sunrays_mask", std::vector<uint32_t>({kUTextureBindingSlot, kOutputBindingSlot}));
@@ -362,9 +380,25 @@ void FluidSimulationApp::SetupGrids()
     mVelocityGrid[1] = std::make_unique<SimulationGrid>("velocity[1]", simRes.x, simRes.y, kRG);
 
     SetupBloomGrids();
+    SetupMultigridGrids();
     SetupSunraysGrids();
 }
 
+void FluidSimulationApp::SetupMultigridGrids()
+{
+    mMultigridLevels.clear();
+
+    ppx::uint2 res = GetResolution(GetConfig().pSimResolution->GetValue());
+    for (res = (res + 1u) / 2u; std::min(res.x, res.y) >= kMultigridMinSize; res = (res + 1u) / 2u) {
+        std::string    prefix = "multigrid[" + std::to_string(mMultigridLevels.size()) + "] ";
+        MultigridLevel level;
+        level.pressure[0] = std::make_unique<SimulationGrid>(prefix + "pressure[0]", res.x, res.y, kR);
+        level.pressure[1] = std::make_unique<SimulationGrid>(prefix + "pressure[1]", res.x, res.y, kR);
+        level.divergence  = std::make_unique<SimulationGrid>(prefix + "divergence", res.x, res.y, kR);
+        mMultigridLevels.push_back(std::move(level));
+    }
+}
+
 void FluidSimulationApp::SetupBloomGrids()
 {
     ppx::int2 res = GetResolution(GetConfig().pBloomResolution->GetValue());
@@ -486,6 +520,11 @@ void FluidSimulationApp::UpdateKnobVisibility()
         mConfig.pColorUpdateFrequency->SetVisible(marbleEnabled);
         mConfig.pMarbleDropFrequency->SetVisible(marbleEnabled);
     }
+    if (mConfig.pPressureSolver->DigestUpdate()) {
+        bool multigrid = (mConfig.pPressureSolver->GetIndex() == kPressureSolverMultigrid);
+        mConfig.pPressureIterations->SetVisible(!multigrid);
+        mConfig.pMultigridCycles->SetVisible(multigrid);
+    }
     if (mConfig.pEnableSunrays->DigestUpdate()) {
         bool sunraysEnabled = mConfig.pEnableSunrays->GetValue();
         mConfig.pSunraysResolution->SetVisible(sunraysEnabled);
@@ -761,17 +800,7 @@ void FluidSimulationApp::Step(PerFrame* pFrame, float delta)
     si.texelSize = texelSize;
     mDivergence->Dispatch(pFrame, {mVelocityGrid[0].get(), mDivergenceGrid.get()}, &si);
 
-    si            = ScalarInput();
-    si.clearValue = GetConfig().pPressure->GetValue();
-    mClear->Dispatch(pFrame, {mPressureGrid[0].get(), mPressureGrid[1].get()}, &si);
-    std::swap(mPressureGrid[0], mPressureGrid[1]);
-
-    si           = ScalarInput();
-    si.texelSize = texelSize;
-    for (int i = 0; i < GetConfig().pPressureIterations->GetValue(); ++i) {
-        mPressure->Dispatch(pFrame, {mPressureGrid[0].get(), mDivergenceGrid.get(), mPressureGrid[1].get()}, &si);
-        std::swap(mPressureGrid[0], mPressureGrid[1]);
-    }
+    SolvePressure(pFrame);
 
     si           = ScalarInput();
     si.texelSize = texelSize;
@@ -796,4 +825,77 @@ void FluidSimulationApp::Step(PerFrame* pFrame, float delta)
     std::swap(mDyeGrid[0], mDyeGrid[1]);
 }
 
+void FluidSimulationApp::SolvePressure(PerFrame* pFrame)
+{
+    float    clearValue = GetConfig().pPressure->GetValue();
+    uint32_t iterations = static_cast<uint32_t>(GetConfig().pPressureIterations->GetValue());
+
+    switch (GetConfig().pPressureSolver->GetIndex()) {
+        case kPressureSolverJacobi: {
+            ScalarInput si;
+            si.clearValue = clearValue;
+            mClear->Dispatch(pFrame, {mPressureGrid[0].get(), mPressureGrid[1].get()}, &si);
+            std::swap(mPressureGrid[0], mPressureGrid[1]);
+
+            si           = ScalarInput();
+            si.texelSize = mPressureGrid[0]->GetTexelSize();
+            for (uint32_t i = 0; i < iterations; ++i) {
+                mPressure->Dispatch(pFrame, {mPressureGrid[0].get(), mDivergenceGrid.get(), mPressureGrid[1].get()}, &si);
+                std::swap(mPressureGrid[0], mPressureGrid[1]);
+            }
+        } break;
+
+        case kPressureSolverFusedJacobi: {
+            RelaxPressure(pFrame, mPressureGrid, mDivergenceGrid.get(), iterations, clearValue);
+        } break;
+
+        case kPressureSolverMultigrid: {
+            for (int i = 0; i < GetConfig().pMultigridCycles->GetValue(); ++i) {
+                PressureVCycle(pFrame, mPressureGrid, mDivergenceGrid.get(), 0, (i == 0) ? clearValue : 1.0f);
+            }
+        } break;
+
+        default: {
+            PPX_ASSERT_MSG(false, "unknown pressure solver " << GetConfig().pPressureSolver->GetIndex());
+        } break;
+    }
+}
+
+void FluidSimulationApp::RelaxPressure(PerFrame* pFrame, std::unique_ptr<SimulationGrid> (&pressure)[kGridPair], SimulationGrid* pDivergence, uint32_t iterations, float clearValue)
+{
+    // Each dispatch runs up to kPressureFusedIterations Jacobi iterations. The clear value only
+    // applies to the pressure loaded by the first one.
+    for (uint32_t i = 0; i < iterations; i += kPressureFusedIterations) {
+        ScalarInput si;
+        si.clearValue = (i == 0) ? clearValue : 1.0f;
+        si.iterations = std::min(iterations - i, kPressureFusedIterations);
+        mPressureFused->Dispatch(pFrame, {pressure[0].get(), pDivergence, pressure[1].get()}, &si);
+        std::swap(pressure[0], pressure[1]);
+    }
+}
+
+void FluidSimulationApp::PressureVCycle(PerFrame* pFrame, std::unique_ptr<SimulationGrid> (&pressure)[kGridPair], SimulationGrid* pDivergence, size_t level, float clearValue)
+{
+    // The coarsest grid is small enough to be solved with plain relaxation.
+    if (level >= mMultigridLevels.size()) {
+        RelaxPressure(pFrame, pressure, pDivergence, kMultigridCoarseIterations, clearValue);
+        return;
+    }
+
+    // Smooth the high frequency error on this grid.
+    RelaxPressure(pFrame, pressure, pDivergence, kPressureFusedIterations, clearValue);
+
+    // Solve for the remaining low frequency error on the coarser grid, starting from zero.
+    MultigridLevel& coarse = mMultigridLevels[level];
+    ScalarInput     si;
+    mPressureRestrict->Dispatch(pFrame, {pressure[0].get(), pDivergence, coarse.divergence.get()}, &si);
+    PressureVCycle(pFrame, coarse.pressure, coarse.divergence.get(), level + 1, 0.0f);
+
+    // Correct this grid with the coarse error and smooth the interpolation artifacts.
+    si = ScalarInput();
+    mPressureProlong->Dispatch(pFrame, {pressure[0].get(), coarse.pressure[0].get(), pressure[1].get()}, &si);
+    std::swap(pressure[0], pressure[1]);
+    RelaxPressure(pFrame, pressure, pDivergence, kPressureFusedIterations, 1.0f);
+}
+
 } // namespace FluidSim
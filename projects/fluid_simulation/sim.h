@@ -19,6 +19,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace FluidSim {
@@ -46,14 +47,38 @@ const uint32_t kGraphicsRepeatSamplerBindingSlot = 1;
 // that switch between input and output in successive iterations.
 const uint32_t kGridPair = 2;
 
+// Thread group size and number of Jacobi iterations run per dispatch by the fused pressure solver.
+//
+// These MUST match the constants in assets/fluid_simulation/shaders/pressure_fused.hlsl.
+const uint32_t kPressureGroupSize       = 16;
+const uint32_t kPressureFusedIterations = 4;
+
+// Thread group size of the multigrid restriction and prolongation shaders.
+const uint32_t kMultigridGroupSize = 8;
+
+// The multigrid hierarchy stops before either dimension gets below this size. The coarsest level
+// is solved with kMultigridCoarseIterations Jacobi iterations.
+const uint32_t kMultigridMinSize          = 8;
+const uint32_t kMultigridCoarseIterations = 16;
+
+// Pressure solvers, in the order of the choices of the --pressure-solver knob.
+enum PressureSolver : size_t
+{
+    kPressureSolverJacobi = 0,
+    kPressureSolverFusedJacobi,
+    kPressureSolverMultigrid,
+};
+
 struct SimulationConfig
 {
     // Fluid knobs.
     std::shared_ptr<ppx::KnobSlider<float>> pCurl;
     std::shared_ptr<ppx::KnobSlider<float>> pDensityDissipation;
     std::shared_ptr<ppx::KnobSlider<int>>   pDyeResolution;
-    std::shared_ptr<ppx::KnobSlider<float>> pPressure;
-    std::shared_ptr<ppx::KnobSlider<int>>   pPressureIterations;
+    std::shared_ptr<ppx::KnobSlider<float>>         pPressure;
+    std::shared_ptr<ppx::KnobDropdown<std::string>> pPressureSolver;
+    std::shared_ptr<ppx::KnobSlider<int>>           pPressureIterations;
+    std::shared_ptr<ppx::KnobSlider<int>>           pMultigridCycles;
     std::shared_ptr<ppx::KnobSlider<float>> pVelocityDissipation;
 
     // Bloom knobs.
@@ -89,6 +114,14 @@ struct SimulationConfig
     std::shared_ptr<ppx::KnobCheckbox> pEnableGridDisplay;
 };
 
+// Coarse grids of the multigrid pressure solver. Each level has half the resolution of the
+// previous one, the first level has half the simulation resolution.
+struct MultigridLevel
+{
+    std::unique_ptr<SimulationGrid> pressure[kGridPair];
+    std::unique_ptr<SimulationGrid> divergence = nullptr;
+};
+
 // Represents a virtual object bouncing around the field.
 struct Bouncer
 {
@@ -165,6 +198,7 @@ private:
     std::unique_ptr<SimulationGrid>              mSunraysTempGrid = nullptr;
     std::unique_ptr<SimulationGrid>              mSunraysGrid     = nullptr;
     std::unique_ptr<SimulationGrid>              mVelocityGrid[kGridPair];
+    std::vector<MultigridLevel>                  mMultigridLevels;
 
     // Compute shader filters.
     std::unique_ptr<ComputeShader> mAdvection         = nullptr;
@@ -179,6 +213,9 @@ private:
     std::unique_ptr<ComputeShader> mDivergence        = nullptr;
     std::unique_ptr<ComputeShader> mGradientSubtract  = nullptr;
     std::unique_ptr<ComputeShader> mPressure          = nullptr;
+    std::unique_ptr<ComputeShader> mPressureFused     = nullptr;
+    std::unique_ptr<ComputeShader> mPressureProlong   = nullptr;
+    std::unique_ptr<ComputeShader> mPressureRestrict  = nullptr;
     std::unique_ptr<ComputeShader> mSplat             = nullptr;
     std::unique_ptr<ComputeShader> mSunrays           = nullptr;
     std::unique_ptr<ComputeShader> mSunraysMask       = nullptr;
@@ -208,12 +245,16 @@ private:
     void         MoveMarble();
     void         MultipleSplats(PerFrame* pFrame, uint32_t amount);
     ppx::float4  NormalizeColor(ppx::float4 input);
+    void         PressureVCycle(PerFrame* pFrame, std::unique_ptr<SimulationGrid> (&pressure)[kGridPair], SimulationGrid* pDivergence, size_t level, float clearValue);
+    void         RelaxPressure(PerFrame* pFrame, std::unique_ptr<SimulationGrid> (&pressure)[kGridPair], SimulationGrid* pDivergence, uint32_t iterations, float clearValue);
     ppx::Random& Random() { return mRandom; }
     void         SetupBloomGrids();
     void         SetupComputeShaders();
     void         SetupGrids();
+    void         SetupMultigridGrids();
     void         SetupRenderingPipeline();
     void         SetupSunraysGrids();
+    void         SolvePressure(PerFrame* pFrame);
     void         Splat(PerFrame* pFrame, ppx::float2 coordinate, ppx::float2 delta, ppx::float3 color);
     void         Step(PerFrame* pFrame, float deltaTime);
     void         UpdateKnobVisibility();
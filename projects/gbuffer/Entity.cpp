@@ -25,6 +25,7 @@ ppx::grfx::DescriptorSetLayoutPtr Entity::sModelDataLayout;
 ppx::grfx::VertexDescription      Entity::sVertexDescription;
 ppx::grfx::PipelineInterfacePtr   Entity::sPipelineInterface;
 ppx::grfx::GraphicsPipelinePtr    Entity::sPipeline;
+ppx::grfx::GraphicsPipelinePtr    Entity::sForwardPipeline;
 
 ppx::Result Entity::Create(ppx::grfx::Queue* pQueue, ppx::grfx::DescriptorPool* pPool, const EntityCreateInfo* pCreateInfo)
 {
@@ -75,7 +76,69 @@ void Entity::Destroy()
 {
 }
 
-ppx::Result Entity::CreatePipelines(ppx::grfx::DescriptorSetLayout* pSceneDataLayout, ppx::grfx::DrawPass* pDrawPass)
+ppx::Result Entity::CreatePipeline(ppx::grfx::Device* pDevice, const char* psName, ppx::grfx::DrawPass* pDrawPass, ppx::grfx::GraphicsPipeline** ppPipeline)
+{
+    PPX_ASSERT_NULL_ARG(pDevice);
+    PPX_ASSERT_NULL_ARG(pDrawPass);
+
+    Application* pApp = Application::Get();
+
+    grfx::ShaderModulePtr VS;
+
+    std::vector<char> bytecode = pApp->LoadShader("gbuffer/shaders", "VertexShader.vs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(pDevice->CreateShaderModule(&shaderCreateInfo, &VS));
+
+    grfx::ShaderModulePtr PS;
+
+    bytecode = pApp->LoadShader("gbuffer/shaders", psName);
+    PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(pDevice->CreateShaderModule(&shaderCreateInfo, &PS));
+
+    const grfx::VertexInputRate inputRate = grfx::VERTEX_INPUT_RATE_VERTEX;
+    grfx::VertexDescription     vertexDescription;
+    // clang-format off
+    vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_POSITION , 0, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, inputRate});
+    vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_COLOR    , 1, grfx::FORMAT_R32G32B32_FLOAT, 1, PPX_APPEND_OFFSET_ALIGNED, inputRate});
+    vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_NORMAL   , 2, grfx::FORMAT_R32G32B32_FLOAT, 2, PPX_APPEND_OFFSET_ALIGNED, inputRate});
+    vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_TEXCOORD , 3, grfx::FORMAT_R32G32_FLOAT,    3, PPX_APPEND_OFFSET_ALIGNED, inputRate});
+    vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_TANGENT  , 4, grfx::FORMAT_R32G32B32_FLOAT, 4, PPX_APPEND_OFFSET_ALIGNED, inputRate});
+    vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_BITANGENT, 5, grfx::FORMAT_R32G32B32_FLOAT, 5, PPX_APPEND_OFFSET_ALIGNED, inputRate});
+    // clang-format on
+
+    grfx::GraphicsPipelineCreateInfo2 gpCreateInfo = {};
+    gpCreateInfo.VS                                = {VS.Get(), "vsmain"};
+    gpCreateInfo.PS                                = {PS.Get(), "psmain"};
+    gpCreateInfo.topology                          = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    gpCreateInfo.polygonMode                       = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.cullMode                          = grfx::CULL_MODE_BACK;
+    gpCreateInfo.frontFace                         = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.depthReadEnable                   = true;
+    gpCreateInfo.depthWriteEnable                  = true;
+    gpCreateInfo.pPipelineInterface                = sPipelineInterface;
+    gpCreateInfo.outputState.depthStencilFormat    = pDrawPass->GetDepthStencilTexture()->GetImage()->GetFormat();
+    // Render target
+    gpCreateInfo.outputState.renderTargetCount = pDrawPass->GetRenderTargetCount();
+    for (uint32_t i = 0; i < gpCreateInfo.outputState.renderTargetCount; ++i) {
+        gpCreateInfo.blendModes[i]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetFormats[i] = pDrawPass->GetRenderTargetTexture(i)->GetImage()->GetFormat();
+    }
+    // Vertex description
+    gpCreateInfo.vertexInputState.bindingCount = vertexDescription.GetBindingCount();
+    for (uint32_t i = 0; i < vertexDescription.GetBindingCount(); ++i) {
+        gpCreateInfo.vertexInputState.bindings[i] = *vertexDescription.GetBinding(i);
+    }
+
+    PPX_CHECKED_CALL(pDevice->CreateGraphicsPipeline(&gpCreateInfo, ppPipeline));
+    pDevice->DestroyShaderModule(VS);
+    pDevice->DestroyShaderModule(PS);
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result Entity::CreatePipelines(ppx::grfx::DescriptorSetLayout* pSceneDataLayout, ppx::grfx::DrawPass* pGBufferPass, ppx::grfx::DrawPass* pForwardPass)
 {
     PPX_ASSERT_NULL_ARG(pSceneDataLayout);
 
@@ -104,62 +167,9 @@ ppx::Result Entity::CreatePipelines(ppx::grfx::DescriptorSetLayout* pSceneDataLa
         PPX_CHECKED_CALL(pDevice->CreatePipelineInterface(&createInfo, &sPipelineInterface));
     }
 
-    // Pipeline
-    {
-        Application* pApp = Application::Get();
-
-        grfx::ShaderModulePtr VS;
-
-        std::vector<char> bytecode = pApp->LoadShader("gbuffer/shaders", "VertexShader.vs");
-        PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
-        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
-        PPX_CHECKED_CALL(pDevice->CreateShaderModule(&shaderCreateInfo, &VS));
-
-        grfx::ShaderModulePtr PS;
-
-        bytecode = pApp->LoadShader("gbuffer/shaders", "DeferredRender.ps");
-        PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
-        shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
-        PPX_CHECKED_CALL(pDevice->CreateShaderModule(&shaderCreateInfo, &PS));
-
-        const grfx::VertexInputRate inputRate = grfx::VERTEX_INPUT_RATE_VERTEX;
-        grfx::VertexDescription     vertexDescription;
-        // clang-format off
-        vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_POSITION , 0, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, inputRate});
-        vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_COLOR    , 1, grfx::FORMAT_R32G32B32_FLOAT, 1, PPX_APPEND_OFFSET_ALIGNED, inputRate});
-        vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_NORMAL   , 2, grfx::FORMAT_R32G32B32_FLOAT, 2, PPX_APPEND_OFFSET_ALIGNED, inputRate});
-        vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_TEXCOORD , 3, grfx::FORMAT_R32G32_FLOAT,    3, PPX_APPEND_OFFSET_ALIGNED, inputRate});
-        vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_TANGENT  , 4, grfx::FORMAT_R32G32B32_FLOAT, 4, PPX_APPEND_OFFSET_ALIGNED, inputRate});
-        vertexDescription.AppendBinding(grfx::VertexAttribute{PPX_SEMANTIC_NAME_BITANGENT, 5, grfx::FORMAT_R32G32B32_FLOAT, 5, PPX_APPEND_OFFSET_ALIGNED, inputRate});
-        // clang-format on
-
-        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo = {};
-        gpCreateInfo.VS                                = {VS.Get(), "vsmain"};
-        gpCreateInfo.PS                                = {PS.Get(), "psmain"};
-        gpCreateInfo.topology                          = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        gpCreateInfo.polygonMode                       = grfx::POLYGON_MODE_FILL;
-        gpCreateInfo.cullMode                          = grfx::CULL_MODE_BACK;
-        gpCreateInfo.frontFace                         = grfx::FRONT_FACE_CCW;
-        gpCreateInfo.depthReadEnable                   = true;
-        gpCreateInfo.depthWriteEnable                  = true;
-        gpCreateInfo.pPipelineInterface                = sPipelineInterface;
-        gpCreateInfo.outputState.depthStencilFormat    = pDrawPass->GetDepthStencilTexture()->GetImage()->GetFormat();
-        // Render target
-        gpCreateInfo.outputState.renderTargetCount = pDrawPass->GetRenderTargetCount();
-        for (uint32_t i = 0; i < gpCreateInfo.outputState.renderTargetCount; ++i) {
-            gpCreateInfo.blendModes[i]                      = grfx::BLEND_MODE_NONE;
-            gpCreateInfo.outputState.renderTargetFormats[i] = pDrawPass->GetRenderTargetTexture(i)->GetImage()->GetFormat();
-        }
-        // Vertex description
-        gpCreateInfo.vertexInputState.bindingCount = vertexDescription.GetBindingCount();
-        for (uint32_t i = 0; i < vertexDescription.GetBindingCount(); ++i) {
-            gpCreateInfo.vertexInputState.bindings[i] = *vertexDescription.GetBinding(i);
-        }
-
-        PPX_CHECKED_CALL(pDevice->CreateGraphicsPipeline(&gpCreateInfo, &sPipeline));
-        pDevice->DestroyShaderModule(VS);
-        pDevice->DestroyShaderModule(PS);
-    }
+    // Pipelines
+    PPX_CHECKED_CALL(CreatePipeline(pDevice, "DeferredRender.ps", pGBufferPass, &sPipeline));
+    PPX_CHECKED_CALL(CreatePipeline(pDevice, "ForwardRender.ps", pForwardPass, &sForwardPipeline));
 
     return ppx::SUCCESS;
 }
@@ -194,7 +204,7 @@ void Entity::UpdateConstants(ppx::grfx::Queue* pQueue)
     PPX_CHECKED_CALL(pQueue->CopyBufferToBuffer(&copyInfo, mCpuModelConstants, mGpuModelConstants, grfx::RESOURCE_STATE_CONSTANT_BUFFER, grfx::RESOURCE_STATE_CONSTANT_BUFFER));
 }
 
-void Entity::Draw(ppx::grfx::DescriptorSet* pSceneDataSet, ppx::grfx::CommandBuffer* pCmd)
+void Entity::Draw(ppx::grfx::DescriptorSet* pSceneDataSet, ppx::grfx::CommandBuffer* pCmd, bool forward)
 {
     grfx::DescriptorSet* sets[4] = {nullptr};
     sets[0]                      = pSceneDataSet;
@@ -203,7 +213,7 @@ void Entity::Draw(ppx::grfx::DescriptorSet* pSceneDataSet, ppx::grfx::CommandBuf
     sets[3]                      = mModelDataSet;
     pCmd->BindGraphicsDescriptorSets(sPipelineInterface, 4, sets);
 
-    pCmd->BindGraphicsPipeline(sPipeline);
+    pCmd->BindGraphicsPipeline(forward ? sForwardPipeline : sPipeline);
 
     pCmd->BindIndexBuffer(mMesh);
     pCmd->BindVertexBuffers(mMesh);
@@ -36,14 +36,18 @@ public:
     ppx::Result Create(ppx::grfx::Queue* pQueue, ppx::grfx::DescriptorPool* pPool, const EntityCreateInfo* pCreateInfo);
     void        Destroy();
 
-    static ppx::Result CreatePipelines(ppx::grfx::DescriptorSetLayout* pSceneDataLayout, ppx::grfx::DrawPass* pDrawPass);
+    // pGBufferPass is drawn to with DeferredRender, pForwardPass with ForwardRender
+    static ppx::Result CreatePipelines(ppx::grfx::DescriptorSetLayout* pSceneDataLayout, ppx::grfx::DrawPass* pGBufferPass, ppx::grfx::DrawPass* pForwardPass);
     static void        DestroyPipelines();
 
     ppx::Transform&       GetTransform() { return mTransform; }
     const ppx::Transform& GetTransform() const { return mTransform; }
 
     void UpdateConstants(ppx::grfx::Queue* pQueue);
-    void Draw(ppx::grfx::DescriptorSet* pSceneDataSet, ppx::grfx::CommandBuffer* pCmd);
+    void Draw(ppx::grfx::DescriptorSet* pSceneDataSet, ppx::grfx::CommandBuffer* pCmd, bool forward = false);
+
+private:
+    static ppx::Result CreatePipeline(ppx::grfx::Device* pDevice, const char* psName, ppx::grfx::DrawPass* pDrawPass, ppx::grfx::GraphicsPipeline** ppPipeline);
 
 private:
     ppx::Transform              mTransform;
@@ -57,6 +61,7 @@ private:
     static ppx::grfx::VertexDescription      sVertexDescription;
     static ppx::grfx::PipelineInterfacePtr   sPipelineInterface;
     static ppx::grfx::GraphicsPipelinePtr    sPipeline;
+    static ppx::grfx::GraphicsPipelinePtr    sForwardPipeline;
 };
 
 #endif // ENTITY_H
@@ -34,6 +34,8 @@
 #define MATERIAL_HEIGHT_MAP_TEXTURE_REGISTER 11 // DeferredRender only
 #define MATERIAL_IBL_MAP_TEXTURE_REGISTER    12
 #define MATERIAL_ENV_MAP_TEXTURE_REGISTER    13
+#define LIGHT_GRID_REGISTER                  14
+#define LIGHT_INDEX_LIST_REGISTER            15
 
 // t#
 #define GBUFFER_RT0_REGISTER 16 // DeferredLight only
@@ -46,6 +48,22 @@
 // s#
 #define GBUFFER_SAMPLER_REGISTER 6 // DeferredLight only
 
+// t#, u#
+#define LIGHT_CULL_DEPTH_REGISTER     22 // LightCullTiled only
+#define LIGHT_GRID_UAV_REGISTER       23 // LightCull* only
+#define LIGHT_INDEX_LIST_UAV_REGISTER 24 // LightCull* only
+
+// Light culling modes
+#define LIGHT_CULLING_NONE              0
+#define LIGHT_CULLING_TILED_DEFERRED    1
+#define LIGHT_CULLING_CLUSTERED_FORWARD 2
+
+// Light grid
+#define LIGHT_TILE_SIZE           16
+#define LIGHT_CLUSTER_TILE_SIZE   64
+#define LIGHT_CLUSTER_SLICE_COUNT 16
+#define LIGHT_MAX_LIGHTS_PER_CELL 256
+
 // GBuffer Attributes
 #define GBUFFER_POSITION     0
 #define GBUFFER_NORMAL       1
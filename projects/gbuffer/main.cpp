@@ -15,6 +15,7 @@
 #include "ppx/ppx.h"
 #include "ppx/camera.h"
 #include "ppx/graphics_util.h"
+#include "ppx/random.h"
 using namespace ppx;
 
 #include "Entity.h"
@@ -31,11 +32,31 @@ const grfx::Api kApi = grfx::API_VK_1_1;
 
 bool gUpdateOnce = false;
 
+// The key lights light the whole scene, the point lights are small and
+// numerous enough that they need to be culled.
+const uint32_t kKeyLightCount      = 5;
+const uint32_t kMaxPointLightCount = 4096;
+const uint32_t kMaxLightCount      = kKeyLightCount + kMaxPointLightCount;
+const uint32_t kLightStride        = 32;
+
+// Depth range split into clustered forward slices, anything past the far
+// end lands in the last slice.
+const float kClusterFarDepth = 32.0f;
+
+static uint32_t LightTileCount(uint32_t pixelCount, uint32_t tileSize)
+{
+    return (pixelCount + tileSize - 1) / tileSize;
+}
+
+// Order matches LIGHT_CULLING_*
+const std::vector<std::string> kLightCullingChoices = {"none", "tiled-deferred", "clustered-forward"};
+
 class ProjApp
     : public ppx::Application
 {
 public:
     virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void InitKnobs() override;
     virtual void Setup() override;
     virtual void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
     virtual void Shutdown() override;
@@ -67,12 +88,39 @@ private:
     grfx::BufferPtr              mGpuSceneConstants;
     grfx::BufferPtr              mCpuLightConstants;
     grfx::BufferPtr              mGpuLightConstants;
+    uint32_t                     mLightCount = 0;
+
+    struct PointLight
+    {
+        float  orbitRadius;
+        float  orbitSpeed;
+        float  phase;
+        float  height;
+        float  range;
+        float  intensity;
+        float3 color;
+    };
+    std::vector<PointLight> mPointLights;
+
+    std::shared_ptr<KnobDropdown<std::string>> mLightCullingKnob;
+    std::shared_ptr<KnobSlider<int>>           mPointLightCountKnob;
+    uint32_t                                   mLightCulling = LIGHT_CULLING_NONE;
+
+    grfx::BufferPtr              mLightGrid;
+    grfx::BufferPtr              mLightIndexList;
+    uint32_t                     mLightCellCount = 0;
+    grfx::DescriptorSetLayoutPtr mLightCullLayout;
+    grfx::DescriptorSetPtr       mLightCullSet;
+    grfx::PipelineInterfacePtr   mLightCullInterface;
+    grfx::ComputePipelinePtr     mLightCullTiledPipeline;
+    grfx::ComputePipelinePtr     mLightCullClusteredPipeline;
 
     grfx::SamplerPtr mSampler;
 
     grfx::DrawPassPtr            mGBufferRenderPass;
     grfx::TexturePtr             mGBufferLightRenderTarget;
     grfx::DrawPassPtr            mGBufferLightPass;
+    grfx::DrawPassPtr            mForwardPass;
     grfx::DescriptorSetLayoutPtr mGBufferReadLayout;
     grfx::DescriptorSetPtr       mGBufferReadSet;
     grfx::BufferPtr              mGBufferDrawAttrConstants;
@@ -115,7 +163,12 @@ private:
     void SetupGBufferLightQuad();
     void SetupDebugDraw();
     void SetupDrawToSwapchain();
+    void SetupPointLights();
+    void SetupLightGrid();
+    void SetupLightCulling();
     void UpdateConstants();
+    void DrawEntities(grfx::CommandBuffer* pCmd, bool forward);
+    void CullLights(grfx::CommandBuffer* pCmd);
 
 protected:
     virtual void DrawGui() override;
@@ -126,6 +179,20 @@ void ProjApp::Config(ppx::ApplicationSettings& settings)
     settings.appName     = "gbuffer";
     settings.enableImGui = true;
     settings.grfx.api    = kApi;
+
+    // Reports the light culling and shading passes as GPU scope metrics
+    settings.grfx.gpuProfiler.enable = true;
+}
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&mLightCullingKnob, "light-culling", LIGHT_CULLING_TILED_DEFERRED, kLightCullingChoices);
+    mLightCullingKnob->SetDisplayName("Light Culling");
+    mLightCullingKnob->SetFlagDescription("Selects how lights are assigned to pixels. 'none' shades every pixel of the gbuffer with every light. 'tiled-deferred' culls the lights against the depth bounds of each screen tile of the gbuffer in a compute pass. 'clustered-forward' culls the lights into depth sliced screen tiles in a compute pass and shades the entities directly without a gbuffer.");
+
+    GetKnobManager().InitKnob(&mPointLightCountKnob, "point-light-count", 1024, 0, static_cast<int>(kMaxPointLightCount));
+    mPointLightCountKnob->SetDisplayName("Point Lights");
+    mPointLightCountKnob->SetFlagDescription("Number of small point lights orbiting the scene, in addition to the key lights.");
 }
 
 void ProjApp::SetupPerFrame()
@@ -286,6 +353,20 @@ void ProjApp::SetupGBufferPasses()
 
         PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mGBufferLightPass));
     }
+
+    // Forward draw pass, shades into the light render target and
+    // reuses the gbuffer's depth buffer
+    {
+        grfx::DrawPassCreateInfo3 createInfo = {};
+        createInfo.width                     = mGBufferRenderPass->GetWidth();
+        createInfo.height                    = mGBufferRenderPass->GetHeight();
+        createInfo.renderTargetCount         = 1;
+        createInfo.pRenderTargetTextures[0]  = mGBufferLightRenderTarget;
+        createInfo.pDepthStencilTexture      = mGBufferRenderPass->GetDepthStencilTexture();
+        createInfo.depthStencilState         = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE;
+
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mForwardPass));
+    }
 }
 
 void ProjApp::SetupGBufferLightQuad()
@@ -409,6 +490,129 @@ void ProjApp::SetupDrawToSwapchain()
     }
 }
 
+void ProjApp::SetupPointLights()
+{
+    Random random;
+
+    mPointLights.resize(kMaxPointLightCount);
+    for (size_t i = 0; i < mPointLights.size(); ++i) {
+        PointLight& light = mPointLights[i];
+        light.orbitRadius = random.Float(0.5f, 6.0f);
+        light.orbitSpeed  = random.Float(0.1f, 0.5f) * ((i % 2) ? 1.0f : -1.0f);
+        light.phase       = random.Float(0.0f, 2.0f * 3.141592f);
+        light.height      = random.Float(0.1f, 3.0f);
+        light.range       = random.Float(0.75f, 1.5f);
+        light.intensity   = random.Float(0.5f, 1.0f);
+        light.color       = random.Float3(float3(0.2f), float3(1.0f));
+    }
+}
+
+void ProjApp::SetupLightGrid()
+{
+    // Sized for whichever of the tile or cluster grids has more cells
+    const uint32_t width        = mGBufferRenderPass->GetWidth();
+    const uint32_t height       = mGBufferRenderPass->GetHeight();
+    const uint32_t tileCount    = LightTileCount(width, LIGHT_TILE_SIZE) * LightTileCount(height, LIGHT_TILE_SIZE);
+    const uint32_t clusterCount = LightTileCount(width, LIGHT_CLUSTER_TILE_SIZE) * LightTileCount(height, LIGHT_CLUSTER_TILE_SIZE) * LIGHT_CLUSTER_SLICE_COUNT;
+    mLightCellCount             = std::max(tileCount, clusterCount);
+
+    // Light count per cell
+    grfx::BufferCreateInfo bufferCreateInfo             = {};
+    bufferCreateInfo.size                               = mLightCellCount * sizeof(uint32_t);
+    bufferCreateInfo.structuredElementStride            = sizeof(uint32_t);
+    bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+    bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+    bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+    bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mLightGrid));
+
+    // Light indices, each cell owns LIGHT_MAX_LIGHTS_PER_CELL of them
+    bufferCreateInfo.size = mLightCellCount * LIGHT_MAX_LIGHTS_PER_CELL * sizeof(uint32_t);
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mLightIndexList));
+}
+
+void ProjApp::SetupLightCulling()
+{
+    // Descriptor set layout
+    {
+        // clang-format off
+        grfx::DescriptorSetLayoutCreateInfo createInfo = {};
+        createInfo.bindings.push_back({grfx::DescriptorBinding{SCENE_CONSTANTS_REGISTER,      grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER,       1, grfx::SHADER_STAGE_CS}});
+        createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_DATA_REGISTER,           grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_CS}});
+        createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_CULL_DEPTH_REGISTER,     grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE,        1, grfx::SHADER_STAGE_CS}});
+        createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_GRID_UAV_REGISTER,       grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_CS}});
+        createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_INDEX_LIST_UAV_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_CS}});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&createInfo, &mLightCullLayout));
+        // clang-format on
+    }
+
+    // Descriptor set
+    {
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mLightCullLayout, &mLightCullSet));
+        mLightCullSet->SetName("Light Cull");
+
+        grfx::WriteDescriptor writes[5]  = {};
+        writes[0].binding                = SCENE_CONSTANTS_REGISTER;
+        writes[0].type                   = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset           = 0;
+        writes[0].bufferRange            = PPX_WHOLE_SIZE;
+        writes[0].pBuffer                = mGpuSceneConstants;
+        writes[1].binding                = LIGHT_DATA_REGISTER;
+        writes[1].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+        writes[1].bufferOffset           = 0;
+        writes[1].bufferRange            = PPX_WHOLE_SIZE;
+        writes[1].structuredElementCount = kMaxLightCount;
+        writes[1].pBuffer                = mGpuLightConstants;
+        writes[2].binding                = LIGHT_CULL_DEPTH_REGISTER;
+        writes[2].type                   = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[2].pImageView             = mGBufferRenderPass->GetDepthStencilTexture()->GetSampledImageView();
+        writes[3].binding                = LIGHT_GRID_UAV_REGISTER;
+        writes[3].type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+        writes[3].bufferOffset           = 0;
+        writes[3].bufferRange            = PPX_WHOLE_SIZE;
+        writes[3].structuredElementCount = mLightCellCount;
+        writes[3].pBuffer                = mLightGrid;
+        writes[4].binding                = LIGHT_INDEX_LIST_UAV_REGISTER;
+        writes[4].type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+        writes[4].bufferOffset           = 0;
+        writes[4].bufferRange            = PPX_WHOLE_SIZE;
+        writes[4].structuredElementCount = mLightCellCount * LIGHT_MAX_LIGHTS_PER_CELL;
+        writes[4].pBuffer                = mLightIndexList;
+        PPX_CHECKED_CALL(mLightCullSet->UpdateDescriptors(5, writes));
+    }
+
+    // Pipelines
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mLightCullLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mLightCullInterface));
+
+        grfx::ShaderModulePtr CS;
+
+        std::vector<char> bytecode = LoadShader("gbuffer/shaders", "LightCullTiled.cs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &CS));
+
+        grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+        cpCreateInfo.CS                              = {CS.Get(), "csmain"};
+        cpCreateInfo.pPipelineInterface              = mLightCullInterface;
+        PPX_CHECKED_CALL(GetDevice()->CreateComputePipeline(&cpCreateInfo, &mLightCullTiledPipeline));
+        GetDevice()->DestroyShaderModule(CS);
+
+        bytecode = LoadShader("gbuffer/shaders", "LightCullClustered.cs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+        shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &CS));
+
+        cpCreateInfo.CS = {CS.Get(), "csmain"};
+        PPX_CHECKED_CALL(GetDevice()->CreateComputePipeline(&cpCreateInfo, &mLightCullClusteredPipeline));
+        GetDevice()->DestroyShaderModule(CS);
+    }
+}
+
 void ProjApp::Setup()
 {
     // Cameras
@@ -441,6 +645,9 @@ void ProjApp::Setup()
     // GBuffer passes
     SetupGBufferPasses();
 
+    // Light grid buffers, read through the scene data set
+    SetupLightGrid();
+
     // GBuffer attribute selection buffer
     {
         grfx::BufferCreateInfo bufferCreateInfo        = {};
@@ -530,13 +737,13 @@ void ProjApp::Setup()
 
         // Light constants
         bufferCreateInfo                             = {};
-        bufferCreateInfo.size                        = PPX_MINIMUM_STRUCTURED_BUFFER_SIZE;
+        bufferCreateInfo.size                        = kMaxLightCount * kLightStride;
         bufferCreateInfo.usageFlags.bits.transferSrc = true;
         bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
-        bufferCreateInfo.structuredElementStride     = 32;
+        bufferCreateInfo.structuredElementStride     = kLightStride;
         PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mCpuLightConstants));
 
-        bufferCreateInfo.structuredElementStride            = 32;
+        bufferCreateInfo.structuredElementStride            = kLightStride;
         bufferCreateInfo.usageFlags.bits.transferDst        = true;
         bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
         bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
@@ -546,6 +753,8 @@ void ProjApp::Setup()
         grfx::DescriptorSetLayoutCreateInfo createInfo = {};
         createInfo.bindings.push_back({grfx::DescriptorBinding{SCENE_CONSTANTS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS}});
         createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_DATA_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS}});
+        createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_GRID_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS}});
+        createInfo.bindings.push_back({grfx::DescriptorBinding{LIGHT_INDEX_LIST_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS}});
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&createInfo, &mSceneDataLayout));
 
         // Allocate descriptor set
@@ -553,7 +762,7 @@ void ProjApp::Setup()
         mSceneDataSet->SetName("Scene Data");
 
         // Update descriptor
-        grfx::WriteDescriptor writes[2] = {};
+        grfx::WriteDescriptor writes[4] = {};
         writes[0].binding               = SCENE_CONSTANTS_REGISTER;
         writes[0].type                  = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         writes[0].bufferOffset          = 0;
@@ -565,16 +774,36 @@ void ProjApp::Setup()
         writes[1].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
         writes[1].bufferOffset           = 0;
         writes[1].bufferRange            = PPX_WHOLE_SIZE;
-        writes[1].structuredElementCount = 1;
+        writes[1].structuredElementCount = kMaxLightCount;
         writes[1].pBuffer                = mGpuLightConstants;
-        PPX_CHECKED_CALL(mSceneDataSet->UpdateDescriptors(2, writes));
+
+        writes[2].binding                = LIGHT_GRID_REGISTER;
+        writes[2].arrayIndex             = 0;
+        writes[2].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+        writes[2].bufferOffset           = 0;
+        writes[2].bufferRange            = PPX_WHOLE_SIZE;
+        writes[2].structuredElementCount = mLightCellCount;
+        writes[2].pBuffer                = mLightGrid;
+
+        writes[3].binding                = LIGHT_INDEX_LIST_REGISTER;
+        writes[3].arrayIndex             = 0;
+        writes[3].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+        writes[3].bufferOffset           = 0;
+        writes[3].bufferRange            = PPX_WHOLE_SIZE;
+        writes[3].structuredElementCount = mLightCellCount * LIGHT_MAX_LIGHTS_PER_CELL;
+        writes[3].pBuffer                = mLightIndexList;
+        PPX_CHECKED_CALL(mSceneDataSet->UpdateDescriptors(4, writes));
     }
 
+    // Light culling
+    SetupPointLights();
+    SetupLightCulling();
+
     // Create materials
     PPX_CHECKED_CALL(Material::CreateMaterials(GetGraphicsQueue(), mDescriptorPool));
 
     // Create pipelines
-    PPX_CHECKED_CALL(Entity::CreatePipelines(mSceneDataLayout, mGBufferRenderPass));
+    PPX_CHECKED_CALL(Entity::CreatePipelines(mSceneDataLayout, mGBufferRenderPass, mForwardPass));
 
     // Entities
     SetupEntities();
@@ -604,6 +833,9 @@ void ProjApp::UpdateConstants()
 {
     const float kPi = 3.1451592f;
 
+    mLightCulling = static_cast<uint32_t>(mLightCullingKnob->GetIndex());
+    mLightCount   = kKeyLightCount + static_cast<uint32_t>(mPointLightCountKnob->GetValue());
+
     // Scene constants
     {
         mCamSwing += (mTargetCamSwing - mCamSwing) * 0.1f;
@@ -623,7 +855,18 @@ void ProjApp::UpdateConstants()
             hlsl_uint<4>      lightCount;
             hlsl_float<4>     ambient;
             hlsl_float<4>     iblLevelCount;
-            hlsl_float<4>     envLevelCount;
+            hlsl_float<8>     envLevelCount;
+            hlsl_float4x4<64> viewMatrix;
+            hlsl_float2<8>    projectionScale;
+            hlsl_float2<8>    depthUnproject;
+            hlsl_float2<8>    screenSize;
+            hlsl_uint<4>      lightCullingMode;
+            hlsl_uint<4>      lightTileSize;
+            hlsl_uint<4>      lightTileCountX;
+            hlsl_uint<4>      lightTileCountY;
+            hlsl_uint<4>      lightSliceCount;
+            hlsl_float<4>     lightSliceScale;
+            hlsl_float<4>     lightSliceBias;
         };
         PPX_HLSL_PACK_END();
 
@@ -633,11 +876,37 @@ void ProjApp::UpdateConstants()
         HlslSceneData* pSceneData        = static_cast<HlslSceneData*>(pMappedAddress);
         pSceneData->viewProjectionMatrix = mCamera.GetViewProjectionMatrix();
         pSceneData->eyePosition          = mCamera.GetEyePosition();
-        pSceneData->lightCount           = 5;
+        pSceneData->lightCount           = mLightCount;
         pSceneData->ambient              = 0.0f;
         pSceneData->iblLevelCount        = 0;
         pSceneData->envLevelCount        = 0;
 
+        // Light culling works in view space with positive depths, see LightCulling.hlsli
+        const float4x4& P            = mCamera.GetProjectionMatrix();
+        const float     width        = static_cast<float>(mGBufferRenderPass->GetWidth());
+        const float     height       = static_cast<float>(mGBufferRenderPass->GetHeight());
+        pSceneData->viewMatrix       = mCamera.GetViewMatrix();
+        pSceneData->projectionScale  = float2(P[0][0], P[1][1]);
+        pSceneData->depthUnproject   = float2(P[2][2], P[3][2]);
+        pSceneData->screenSize       = float2(width, height);
+        pSceneData->lightCullingMode = mLightCulling;
+
+        const uint32_t tileSize     = (mLightCulling == LIGHT_CULLING_CLUSTERED_FORWARD) ? LIGHT_CLUSTER_TILE_SIZE : LIGHT_TILE_SIZE;
+        pSceneData->lightTileSize   = tileSize;
+        pSceneData->lightTileCountX = LightTileCount(mGBufferRenderPass->GetWidth(), tileSize);
+        pSceneData->lightTileCountY = LightTileCount(mGBufferRenderPass->GetHeight(), tileSize);
+        pSceneData->lightSliceCount = 1;
+        pSceneData->lightSliceScale = 0.0f;
+        pSceneData->lightSliceBias  = 0.0f;
+        if (mLightCulling == LIGHT_CULLING_CLUSTERED_FORWARD) {
+            // Slices are spaced exponentially from the near plane to kClusterFarDepth
+            const float nearDepth       = mCamera.GetNearClip();
+            const float logDepthRange   = std::log(kClusterFarDepth / nearDepth);
+            pSceneData->lightSliceCount = LIGHT_CLUSTER_SLICE_COUNT;
+            pSceneData->lightSliceScale = LIGHT_CLUSTER_SLICE_COUNT / logDepthRange;
+            pSceneData->lightSliceBias  = -LIGHT_CLUSTER_SLICE_COUNT * std::log(nearDepth) / logDepthRange;
+        }
+
         mCpuSceneConstants->UnmapMemory();
 
         grfx::BufferToBufferCopyInfo copyInfo = {mCpuSceneConstants->GetSize()};
@@ -649,12 +918,13 @@ void ProjApp::UpdateConstants()
         PPX_HLSL_PACK_BEGIN();
         struct HlslLight
         {
-            hlsl_uint<4>    type;
             hlsl_float3<12> position;
+            hlsl_float<4>   range;
             hlsl_float3<12> color;
             hlsl_float<4>   intensity;
         };
         PPX_HLSL_PACK_END();
+        static_assert(sizeof(HlslLight) == kLightStride, "HlslLight doesn't match the light buffer stride");
 
         void* pMappedAddress = nullptr;
         PPX_CHECKED_CALL(mCpuLightConstants->MapMemory(0, &pMappedAddress));
@@ -667,18 +937,32 @@ void ProjApp::UpdateConstants()
         pLight[2].position = float3(1, 10, 3) * float3(sin(t / 2), 1, cos(t / 2));
         pLight[3].position = float3(-1, 0, 15) * float3(sin(t / 3), 1, cos(t / 3));
         pLight[4].position = float3(-1, 2, -5) * float3(sin(t / 4), 1, cos(t / 4));
-        pLight[5].position = float3(-6, 3, -4) * float3(sin(t / 5), 1, cos(t / 5));
 
         pLight[0].intensity = 0.5f;
         pLight[1].intensity = 0.25f;
         pLight[2].intensity = 0.5f;
         pLight[3].intensity = 0.25f;
         pLight[4].intensity = 0.5f;
-        pLight[5].intensity = 0.25f;
+
+        // Key lights reach the whole scene, so they end up in every cell
+        for (uint32_t i = 0; i < kKeyLightCount; ++i) {
+            pLight[i].range = 100.0f;
+            pLight[i].color = float3(1);
+        }
+
+        for (uint32_t i = kKeyLightCount; i < mLightCount; ++i) {
+            const PointLight& pointLight = mPointLights[i - kKeyLightCount];
+
+            float angle         = pointLight.phase + pointLight.orbitSpeed * t;
+            pLight[i].position  = float3(pointLight.orbitRadius * cos(angle), pointLight.height, pointLight.orbitRadius * sin(angle));
+            pLight[i].range     = pointLight.range;
+            pLight[i].color     = pointLight.color;
+            pLight[i].intensity = pointLight.intensity;
+        }
 
         mCpuLightConstants->UnmapMemory();
 
-        grfx::BufferToBufferCopyInfo copyInfo = {mCpuLightConstants->GetSize()};
+        grfx::BufferToBufferCopyInfo copyInfo = {mLightCount * kLightStride};
         GetGraphicsQueue()->CopyBufferToBuffer(&copyInfo, mCpuLightConstants, mGpuLightConstants, grfx::RESOURCE_STATE_CONSTANT_BUFFER, grfx::RESOURCE_STATE_CONSTANT_BUFFER);
     }
 
@@ -711,6 +995,54 @@ void ProjApp::UpdateConstants()
     }
 }
 
+void ProjApp::DrawEntities(grfx::CommandBuffer* pCmd, bool forward)
+{
+#ifdef ENABLE_GPU_QUERIES
+    PerFrame& frame = mPerFrame[0];
+    if (GetDevice()->PipelineStatsAvailable()) {
+        pCmd->BeginQuery(frame.pipelineStatsQuery, 0);
+    }
+#endif
+    for (size_t i = 0; i < mEntities.size(); ++i) {
+        mEntities[i].Draw(mSceneDataSet, pCmd, forward);
+    }
+#ifdef ENABLE_GPU_QUERIES
+    if (GetDevice()->PipelineStatsAvailable()) {
+        pCmd->EndQuery(frame.pipelineStatsQuery, 0);
+    }
+#endif
+}
+
+void ProjApp::CullLights(grfx::CommandBuffer* pCmd)
+{
+    grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), pCmd, "LightCulling");
+
+    pCmd->TransitionBufferState(mLightGrid, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->TransitionBufferState(mLightIndexList, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+
+    grfx::DescriptorSet* set = mLightCullSet;
+    pCmd->BindComputeDescriptorSets(mLightCullInterface, 1, &set);
+    if (mLightCulling == LIGHT_CULLING_CLUSTERED_FORWARD) {
+        // One group per cluster
+        pCmd->BindComputePipeline(mLightCullClusteredPipeline);
+        pCmd->Dispatch(
+            LightTileCount(mGBufferRenderPass->GetWidth(), LIGHT_CLUSTER_TILE_SIZE),
+            LightTileCount(mGBufferRenderPass->GetHeight(), LIGHT_CLUSTER_TILE_SIZE),
+            LIGHT_CLUSTER_SLICE_COUNT);
+    }
+    else {
+        // One group per tile
+        pCmd->BindComputePipeline(mLightCullTiledPipeline);
+        pCmd->Dispatch(
+            LightTileCount(mGBufferRenderPass->GetWidth(), LIGHT_TILE_SIZE),
+            LightTileCount(mGBufferRenderPass->GetHeight(), LIGHT_TILE_SIZE),
+            1);
+    }
+
+    pCmd->TransitionBufferState(mLightGrid, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    pCmd->TransitionBufferState(mLightIndexList, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+}
+
 void ProjApp::Render()
 {
     PerFrame& frame = mPerFrame[0];
@@ -719,6 +1051,7 @@ void ProjApp::Render()
 
     // Wait for and reset render complete fence
     PPX_CHECKED_CALL(frame.renderCompleteFence->WaitAndReset());
+    GetGpuProfiler()->BeginFrame(0);
 
     uint32_t imageIndex = UINT32_MAX;
     PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, frame.imageAcquiredFence, &imageIndex));
@@ -753,77 +1086,77 @@ void ProjApp::Render()
         frame.cmd->SetScissors(mGBufferRenderPass->GetScissor());
         frame.cmd->SetViewports(mGBufferRenderPass->GetViewport());
 
-        // =====================================================================
-        //  GBuffer render
-        // =====================================================================
-        frame.cmd->TransitionImageLayout(
-            mGBufferRenderPass,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE,
-            grfx::RESOURCE_STATE_RENDER_TARGET,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE,
-            grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
-        frame.cmd->BeginRenderPass(mGBufferRenderPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS | grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_DEPTH);
-        {
 #ifdef ENABLE_GPU_QUERIES
-            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+        frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
 #endif
 
-#ifdef ENABLE_GPU_QUERIES
-            if (GetDevice()->PipelineStatsAvailable()) {
-                frame.cmd->BeginQuery(frame.pipelineStatsQuery, 0);
+        if (mLightCulling == LIGHT_CULLING_CLUSTERED_FORWARD) {
+            // =================================================================
+            //  Clustered forward, the clusters don't depend on depth so the
+            //  lights are culled before anything is drawn
+            // =================================================================
+            CullLights(frame.cmd);
+
+            grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), frame.cmd, "LightShading");
+            frame.cmd->TransitionImageState(mForwardPass, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+            frame.cmd->BeginRenderPass(mForwardPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS | grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_DEPTH);
+            {
+                DrawEntities(frame.cmd, true);
             }
-#endif
-            for (size_t i = 0; i < mEntities.size(); ++i) {
-                mEntities[i].Draw(mSceneDataSet, frame.cmd);
+            frame.cmd->EndRenderPass();
+        }
+        else {
+            // =================================================================
+            //  GBuffer render
+            // =================================================================
+            // The gbuffer passes use tracked transitions, the depth buffer's
+            // transition to shader resource and back into depth read is folded
+            // into a single barrier when the light pass begins.
+            {
+                grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), frame.cmd, "GBuffer");
+                frame.cmd->TransitionImageState(mGBufferRenderPass, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+                frame.cmd->BeginRenderPass(mGBufferRenderPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS | grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_DEPTH);
+                {
+                    DrawEntities(frame.cmd, false);
+                }
+                frame.cmd->EndRenderPass();
+                frame.cmd->TransitionImageState(mGBufferRenderPass, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE);
             }
-#ifdef ENABLE_GPU_QUERIES
-            if (GetDevice()->PipelineStatsAvailable()) {
-                frame.cmd->EndQuery(frame.pipelineStatsQuery, 0);
+
+            // =================================================================
+            //  Tiled deferred light culling, reads the gbuffer depth
+            // =================================================================
+            if (mLightCulling == LIGHT_CULLING_TILED_DEFERRED) {
+                CullLights(frame.cmd);
             }
-#endif
-        }
-        frame.cmd->EndRenderPass();
-        frame.cmd->TransitionImageLayout(
-            mGBufferRenderPass,
-            grfx::RESOURCE_STATE_RENDER_TARGET,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE,
-            grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE);
 
-        // =====================================================================
-        //  GBuffer light
-        // =====================================================================
-        frame.cmd->TransitionImageLayout(
-            mGBufferLightPass,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE,
-            grfx::RESOURCE_STATE_RENDER_TARGET,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE,
-            grfx::RESOURCE_STATE_DEPTH_STENCIL_READ);
-        frame.cmd->BeginRenderPass(mGBufferLightPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS);
-        {
-            // Light scene using gbuffer data
-            //
-            grfx::DescriptorSet* sets[2] = {nullptr};
-            sets[0]                      = mSceneDataSet;
-            sets[1]                      = mGBufferReadSet;
-
-            grfx::FullscreenQuad* pDrawQuad = mGBufferLightQuad;
-            if (mDrawGBufferAttr) {
-                pDrawQuad = mDebugDrawQuad;
+            // =================================================================
+            //  GBuffer light
+            // =================================================================
+            grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), frame.cmd, "LightShading");
+            frame.cmd->TransitionImageState(mGBufferLightPass, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_DEPTH_STENCIL_READ);
+            frame.cmd->BeginRenderPass(mGBufferLightPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS);
+            {
+                // Light scene using gbuffer data
+                //
+                grfx::DescriptorSet* sets[2] = {nullptr};
+                sets[0]                      = mSceneDataSet;
+                sets[1]                      = mGBufferReadSet;
+
+                grfx::FullscreenQuad* pDrawQuad = mGBufferLightQuad;
+                if (mDrawGBufferAttr) {
+                    pDrawQuad = mDebugDrawQuad;
+                }
+                frame.cmd->Draw(pDrawQuad, 2, sets);
             }
-            frame.cmd->Draw(pDrawQuad, 2, sets);
+            frame.cmd->EndRenderPass();
         }
-        frame.cmd->EndRenderPass();
 #ifdef ENABLE_GPU_QUERIES
         frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
 #endif
 
-        frame.cmd->TransitionImageLayout(
-            mGBufferLightPass,
-            grfx::RESOURCE_STATE_RENDER_TARGET,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE,
-            grfx::RESOURCE_STATE_DEPTH_STENCIL_READ,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        frame.cmd->TransitionImageState(mGBufferLightPass, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        GetGpuProfiler()->EndFrame(frame.cmd);
 
         // =====================================================================
         //  Blit to swapchain
@@ -893,6 +1226,13 @@ void ProjApp::DrawGui()
 
     ImGui::Separator();
 
+    ImGui::Text("Lights: %u", mLightCount);
+    for (const auto& scope : GetGpuProfiler()->GetScopes()) {
+        ImGui::Text("GPU %s: %.3f ms", scope.name.c_str(), scope.gpuMs);
+    }
+
+    ImGui::Separator();
+
     ImGui::Columns(2);
 
     uint64_t frequency = 0;
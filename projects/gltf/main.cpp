@@ -22,6 +22,7 @@
 #include "ppx/camera.h"
 #include "ppx/graphics_util.h"
 #include "ppx/grfx/grfx_scope.h"
+#include "ppx/scene/scene_gpu_culler.h"
 #include "cgltf.h"
 #include "glm/gtc/type_ptr.hpp"
 
@@ -37,9 +38,13 @@ class ProjApp
     : public ppx::Application
 {
 public:
+    virtual void InitKnobs() override;
     virtual void Config(ppx::ApplicationSettings& settings) override;
     virtual void Setup() override;
+    virtual void Shutdown() override;
     virtual void Render() override;
+    virtual void SetupMetrics() override;
+    virtual void UpdateMetrics() override;
 
 private:
     struct PerFrame
@@ -69,6 +74,7 @@ private:
     struct Primitive
     {
         grfx::Mesh* mesh;
+        ppx::AABB   bounds; // Object space
     };
 
     struct Renderable
@@ -106,6 +112,15 @@ private:
     std::vector<Object>    mObjects;
     TextureCache           mTextureCache;
 
+    std::shared_ptr<KnobCheckbox>  mGpuCullingKnob;
+    std::shared_ptr<KnobCheckbox>  mOcclusionCullingKnob;
+    std::shared_ptr<KnobFlag<int>> mGridSizeKnob;
+
+    scene::GpuCuller* mCuller        = nullptr;
+    uint32_t          mDrawCount     = 0;
+    metrics::MetricID mVisibleMetric = metrics::kInvalidMetricID;
+    metrics::MetricID mCulledMetric  = metrics::kInvalidMetricID;
+
 private:
     void LoadScene(
         const std::filesystem::path& filename,
@@ -155,8 +170,27 @@ private:
         const std::unordered_map<const cgltf_primitive*, size_t>& primitiveToIndex,
         std::vector<Primitive>*                                   pPrimitives,
         std::vector<Material>*                                    pMaterials) const;
+
+    // Adds copies of the loaded objects on a gridSize^3 grid
+    void ReplicateObjects(uint32_t gridSize, grfx::Queue* pQueue, grfx::DescriptorPool* pDescriptorPool, std::vector<Object>* pObjects) const;
+
+    void SetupCulling();
 };
 
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&mGpuCullingKnob, "gpu-culling", false);
+    mGpuCullingKnob->SetDisplayName("GPU Culling");
+    mGpuCullingKnob->SetFlagDescription("Frustum cull draws in a compute shader and issue them as indirect draws.");
+
+    GetKnobManager().InitKnob(&mOcclusionCullingKnob, "occlusion-culling", true);
+    mOcclusionCullingKnob->SetDisplayName("Occlusion Culling");
+    mOcclusionCullingKnob->SetFlagDescription("With GPU culling, also cull draws hidden behind the previous frame's depth.");
+
+    GetKnobManager().InitKnob(&mGridSizeKnob, "grid-size", 1, 1, 6);
+    mGridSizeKnob->SetFlagDescription("Number of copies of the scene along each axis, to give culling something to work with.");
+}
+
 void ProjApp::Config(ppx::ApplicationSettings& settings)
 {
     settings.appName                    = "gltf";
@@ -431,6 +465,11 @@ void ProjApp::LoadPrimitive(const cgltf_primitive& primitive, grfx::BufferPtr pS
         }
     }
 
+    // POSITION accessors are required to have min and max.
+    const cgltf_accessor& positions = *accessors[POSITION_INDEX];
+    PPX_ASSERT_MSG(positions.has_min && positions.has_max, "POSITION accessor is missing min/max.");
+    pOutput->bounds = ppx::AABB(glm::make_vec3(positions.min), glm::make_vec3(positions.max));
+
     targetMesh->SetOwnership(grfx::OWNERSHIP_REFERENCE);
     pOutput->mesh = targetMesh;
 }
@@ -595,6 +634,120 @@ void ProjApp::LoadNodes(
     }
 }
 
+static ppx::AABB ComputeWorldBounds(const float4x4& modelMatrix, const ppx::AABB& bounds)
+{
+    float3 corners[8];
+    bounds.Transform(modelMatrix, corners);
+
+    ppx::AABB worldBounds(corners[0]);
+    for (uint32_t i = 1; i < 8; ++i) {
+        worldBounds.Expand(corners[i]);
+    }
+    return worldBounds;
+}
+
+void ProjApp::ReplicateObjects(uint32_t gridSize, grfx::Queue* pQueue, grfx::DescriptorPool* pDescriptorPool, std::vector<Object>* pObjects) const
+{
+    if (pObjects->empty()) {
+        return;
+    }
+
+    ppx::AABB sceneBounds;
+    bool      first = true;
+    for (const auto& object : *pObjects) {
+        for (const auto& renderable : object.renderables) {
+            const ppx::AABB bounds = ComputeWorldBounds(object.modelMatrix, renderable.pPrimitive->bounds);
+            if (first) {
+                sceneBounds = bounds;
+                first       = false;
+                continue;
+            }
+            sceneBounds.Expand(bounds.GetMin());
+            sceneBounds.Expand(bounds.GetMax());
+        }
+    }
+    const float3 spacing = 1.25f * (sceneBounds.GetMax() - sceneBounds.GetMin());
+
+    // Copies extend away from the camera so most of them are occluded.
+    const size_t originalCount = pObjects->size();
+    pObjects->reserve(originalCount * gridSize * gridSize * gridSize);
+    for (uint32_t z = 0; z < gridSize; ++z) {
+        for (uint32_t y = 0; y < gridSize; ++y) {
+            for (uint32_t x = 0; x < gridSize; ++x) {
+                if ((x == 0) && (y == 0) && (z == 0)) {
+                    continue;
+                }
+
+                const float4x4 offset = glm::translate(-spacing * float3(x, y, z));
+                for (size_t i = 0; i < originalCount; ++i) {
+                    const Object& original = (*pObjects)[i];
+
+                    Object item;
+                    item.modelMatrix   = offset * original.modelMatrix;
+                    item.ITModelMatrix = glm::inverse(glm::transpose(item.modelMatrix));
+
+                    for (const auto& renderable : original.renderables) {
+                        grfx::DescriptorSet* pDescriptorSet = nullptr;
+                        PPX_CHECKED_CALL(pQueue->GetDevice()->AllocateDescriptorSet(pDescriptorPool, mSetLayout, &pDescriptorSet));
+                        item.renderables.emplace_back(renderable.pMaterial, renderable.pPrimitive, pDescriptorSet);
+                    }
+
+                    grfx::BufferCreateInfo bufferCreateInfo        = {};
+                    bufferCreateInfo.size                          = RoundUp(512, PPX_CONSTANT_BUFFER_ALIGNMENT);
+                    bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+                    bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+                    PPX_CHECKED_CALL(pQueue->GetDevice()->CreateBuffer(&bufferCreateInfo, &item.pUniformBuffer));
+
+                    pObjects->emplace_back(std::move(item));
+                }
+            }
+        }
+    }
+}
+
+void ProjApp::SetupCulling()
+{
+    std::vector<char> bytecode = LoadShader("basic/shaders", "GpuCull.cs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    grfx::ShaderModulePtr        cullShader;
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &cullShader));
+
+    bytecode = LoadShader("basic/shaders", "HiZ.cs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    grfx::ShaderModulePtr hizShader;
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &hizShader));
+
+    // One instance per renderable, in draw order
+    std::vector<scene::GpuCullInstance> instances;
+    for (const auto& object : mObjects) {
+        for (const auto& renderable : object.renderables) {
+            const ppx::AABB bounds = ComputeWorldBounds(object.modelMatrix, renderable.pPrimitive->bounds);
+
+            scene::GpuCullInstance instance = {};
+            instance.boundsMin              = bounds.GetMin();
+            instance.boundsMax              = bounds.GetMax();
+            instance.indexCount             = renderable.pPrimitive->mesh->GetIndexCount();
+            instances.push_back(instance);
+        }
+    }
+    mDrawCount = CountU32(instances);
+
+    scene::GpuCullerCreateInfo createInfo = {};
+    createInfo.pCullShader                = cullShader;
+    createInfo.pHiZShader                 = hizShader;
+    createInfo.maxInstanceCount           = std::max<uint32_t>(mDrawCount, 1);
+    createInfo.depthWidth                 = GetSwapchain()->GetWidth();
+    createInfo.depthHeight                = GetSwapchain()->GetHeight();
+    createInfo.maxDepthImages             = GetSwapchain()->GetImageCount();
+    PPX_CHECKED_CALL(scene::GpuCuller::Create(GetDevice(), createInfo, &mCuller));
+    PPX_CHECKED_CALL(mCuller->SetInstances(mDrawCount, DataPtr(instances)));
+
+    GetDevice()->DestroyShaderModule(cullShader);
+    GetDevice()->DestroyShaderModule(hizShader);
+}
+
 void ProjApp::Setup()
 {
     // Cameras
@@ -602,12 +755,15 @@ void ProjApp::Setup()
         mCamera = PerspCamera(60.0f, GetWindowAspect());
     }
 
+    const uint32_t gridSize  = static_cast<uint32_t>(mGridSizeKnob->GetValue());
+    const uint32_t gridCount = gridSize * gridSize * gridSize;
+
     // Create descriptor pool large enough for this project
     {
         grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
-        poolCreateInfo.uniformBuffer                  = 1024;
-        poolCreateInfo.sampledImage                   = 1024;
-        poolCreateInfo.sampler                        = 1024;
+        poolCreateInfo.uniformBuffer                  = 1024 * gridCount;
+        poolCreateInfo.sampledImage                   = 1024 * gridCount;
+        poolCreateInfo.sampler                        = 1024 * gridCount;
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
     }
 
@@ -684,6 +840,12 @@ void ProjApp::Setup()
         &mPrimitives,
         &mMaterials);
 
+    if (gridSize > 1) {
+        ReplicateObjects(gridSize, GetGraphicsQueue(), mDescriptorPool, &mObjects);
+    }
+
+    SetupCulling();
+
     // Per frame data
     {
         PerFrame frame = {};
@@ -709,6 +871,46 @@ void ProjApp::Setup()
     GetDevice()->DestroyShaderModule(mUnlitPixelShader);
 }
 
+void ProjApp::Shutdown()
+{
+    delete mCuller;
+    mCuller = nullptr;
+}
+
+void ProjApp::SetupMetrics()
+{
+    Application::SetupMetrics();
+
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricMetadata metadata = {ppx::metrics::MetricType::GAUGE, "Visible Draws", "", ppx::metrics::MetricInterpretation::NONE, {0.f, 1000000.f}};
+    mVisibleMetric                        = AddMetric(metadata);
+    PPX_ASSERT_MSG(mVisibleMetric != ppx::metrics::kInvalidMetricID, "Failed to add Visible Draws metric");
+
+    metadata      = {ppx::metrics::MetricType::GAUGE, "Culled Draws", "", ppx::metrics::MetricInterpretation::NONE, {0.f, 1000000.f}};
+    mCulledMetric = AddMetric(metadata);
+    PPX_ASSERT_MSG(mCulledMetric != ppx::metrics::kInvalidMetricID, "Failed to add Culled Draws metric");
+}
+
+void ProjApp::UpdateMetrics()
+{
+    if (!HasActiveMetricsRun() || IsNull(mCuller)) {
+        return;
+    }
+
+    const uint32_t visibleCount = mGpuCullingKnob->GetValue() ? std::min(mCuller->GetVisibleCount(), mDrawCount) : mDrawCount;
+
+    ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+    data.gauge.seconds            = GetElapsedSeconds();
+
+    data.gauge.value = static_cast<double>(visibleCount);
+    RecordMetricData(mVisibleMetric, data);
+    data.gauge.value = static_cast<double>(mDrawCount - visibleCount);
+    RecordMetricData(mCulledMetric, data);
+}
+
 void ProjApp::Render()
 {
     PerFrame&          frame     = mPerFrame[0];
@@ -776,12 +978,19 @@ void ProjApp::Render()
         }
     }
 
+    const bool gpuCulling = mGpuCullingKnob->GetValue();
+    mCuller->SetOcclusionCulling(mOcclusionCullingKnob->GetValue());
+
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
     {
         grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
         PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
 
+        if (gpuCulling) {
+            mCuller->Cull(frame.cmd, mCamera.GetViewProjectionMatrix());
+        }
+
         // =====================================================================
         //  Render scene
         // =====================================================================
@@ -791,7 +1000,9 @@ void ProjApp::Render()
             frame.cmd->SetScissors(GetScissor());
             frame.cmd->SetViewports(GetViewport());
 
-            // Draw entities
+            // Draw entities, with GPU culling each renderable has its own
+            // indirect draw in the order the culling instances were added.
+            uint32_t drawIndex = 0;
             for (auto& object : mObjects) {
                 for (auto& renderable : object.renderables) {
                     frame.cmd->BindGraphicsPipeline(renderable.pMaterial->pPipeline);
@@ -799,7 +1010,13 @@ void ProjApp::Render()
 
                     frame.cmd->BindIndexBuffer(renderable.pPrimitive->mesh);
                     frame.cmd->BindVertexBuffers(renderable.pPrimitive->mesh);
-                    frame.cmd->DrawIndexed(renderable.pPrimitive->mesh->GetIndexCount());
+                    if (gpuCulling) {
+                        frame.cmd->DrawIndexedIndirect(mCuller->GetDrawArgsBuffer(), mCuller->GetDrawArgsOffset(drawIndex), 1);
+                    }
+                    else {
+                        frame.cmd->DrawIndexed(renderable.pPrimitive->mesh->GetIndexCount());
+                    }
+                    drawIndex++;
                 }
             }
 
@@ -807,6 +1024,11 @@ void ProjApp::Render()
         }
         frame.cmd->EndRenderPass();
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+
+        // Depth pyramid for next frame's occlusion culling
+        if (gpuCulling && mOcclusionCullingKnob->GetValue()) {
+            mCuller->BuildHiZ(frame.cmd, swapchain->GetDepthImage(imageIndex), grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+        }
     }
     PPX_CHECKED_CALL(frame.cmd->End());
 
@@ -16,6 +16,10 @@
 #include "ppx/scene/scene_gltf_loader.h"
 #include "ppx/graphics_util.h"
 
+#include <algorithm>
+#include <limits>
+#include <thread>
+
 namespace {
 
 using namespace ppx;
@@ -26,6 +30,9 @@ const grfx::Api kApi = grfx::API_DX_12_0;
 const grfx::Api kApi = grfx::API_VK_1_1;
 #endif
 
+// Animation time between consecutive character copies, so they don't move in lockstep
+constexpr float kCharacterTimeOffset = 0.37f;
+
 // Calculates a world space bounding box for the mesh. May be bigger than the actual bounding box (especially if rotation is applied) since the node's bounding box is the starting point for transformation (not the individual vertices).
 ppx::AABB GetMeshNodeBoundingBox(const scene::MeshNode& meshNode)
 {
@@ -94,7 +101,13 @@ void GltfBasicMaterialsApp::Setup()
         //
         PPX_CHECKED_CALL(scene::GltfLoader::Create(GetAssetPath(mSceneAssetKnob->GetValue()), /*pMaterialSelector=*/nullptr, &pLoader));
 
-        PPX_CHECKED_CALL(pLoader->LoadScene(GetDevice(), 0, &mScene));
+        const scene::VertexQuantization quantization = mVertexQuantizationKnob->GetValue() ? scene::VERTEX_QUANTIZATION_COMPACT : scene::VERTEX_QUANTIZATION_NONE;
+
+        ppx::MeshLodOptions lodOptions = {};
+        lodOptions.lodCount            = static_cast<uint32_t>(mLodCountKnob->GetValue());
+
+        scene::LoadOptions loadOptions = scene::LoadOptions().SetCacheDirectory(mSceneCacheDirKnob->GetValue()).SetVertexQuantization(quantization).SetMeshLodOptions(lodOptions);
+        PPX_CHECKED_CALL(pLoader->LoadScene(GetDevice(), 0, &mScene, loadOptions));
         if (mScene->GetCameraNodeCount() == 0) {
             PPX_LOG_WARN("Scene doesn't have a camera node. Using a default camera");
             mDefaultCamera = ArcballCamera();
@@ -106,14 +119,112 @@ void GltfBasicMaterialsApp::Setup()
             mDefaultCamera->FitToBoundingBox(boundingBox.GetMin(), boundingBox.GetMax());
         }
         PPX_ASSERT_MSG((mScene->GetMeshNodeCount() > 0), "scene doesn't have mesh nodes");
+        PPX_ASSERT_MSG((mScene->GetMeshNodeCount() <= scene::MaterialPipelineArgs::MAX_DRAWABLE_INSTANCES), "scene has too many mesh nodes");
 
         delete pLoader;
+
+        // Draw mesh nodes that share a mesh with instanced draws, skinned
+        // mesh nodes each need their own vertices
+        for (auto& group : mScene->GetMeshInstanceGroups()) {
+            const auto& batches = group.pMesh->GetBatches();
+            const bool  skinned = std::any_of(batches.begin(), batches.end(), [](const scene::PrimitiveBatch& batch) { return batch.IsSkinned(); });
+
+            scene::MeshInstanceGroup rigidGroup = {group.pMesh};
+            for (auto pNode : group.nodes) {
+                if (skinned && !IsNull(pNode->GetSkin())) {
+                    mSkinnedNodes.push_back(pNode);
+                }
+                else {
+                    rigidGroup.nodes.push_back(pNode);
+                }
+            }
+            if (!rigidGroup.nodes.empty()) {
+                mInstanceGroups.push_back(std::move(rigidGroup));
+            }
+        }
+
+        uint32_t firstInstance = 0;
+        for (const auto& group : mInstanceGroups) {
+            mInstanceGroupFirstInstances.push_back(firstInstance);
+            firstInstance += CountU32(group.nodes);
+        }
+        PPX_LOG_INFO("Drawing " << firstInstance << " mesh nodes with " << mInstanceGroups.size() << " instance groups");
+
+        // Character copies fill the instances the rigid mesh nodes leave
+        mSkinnedFirstInstance = firstInstance;
+        if (!mSkinnedNodes.empty()) {
+            const uint32_t maxCharacterCount = (scene::MaterialPipelineArgs::MAX_DRAWABLE_INSTANCES - firstInstance) / CountU32(mSkinnedNodes);
+            mCharacterCount                  = std::min(static_cast<uint32_t>(mAnimatedCharacterCountKnob->GetValue()), maxCharacterCount);
+            if (mCharacterCount < static_cast<uint32_t>(mAnimatedCharacterCountKnob->GetValue())) {
+                PPX_LOG_WARN("Only " << mCharacterCount << " animated characters fit in the drawable instances");
+            }
+
+            const ppx::AABB boundingBox = GetSceneBoundingBox(*mScene);
+            mCharacterSpacing           = float3(1.25f * (boundingBox.GetMax().x - boundingBox.GetMin().x), 0, 0);
+        }
     }
 
-    // IBL Textures
-    {
+    // Skinning
+    if (!mSkinnedNodes.empty()) {
+        std::vector<char> bytecode = LoadShader("basic/shaders", "SkinVertices.cs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mSkinShader));
+
+        uint32_t vertexCount = 0;
+        uint32_t jointCount  = 0;
+        for (auto pNode : mSkinnedNodes) {
+            for (const auto& batch : pNode->GetMesh()->GetBatches()) {
+                vertexCount += batch.IsSkinned() ? batch.GetVertexCount() : 0;
+            }
+            jointCount += pNode->GetSkin()->GetJointCount();
+        }
+
+        scene::GpuSkinnerCreateInfo createInfo = {};
+        createInfo.pSkinShader                 = mSkinShader;
+        createInfo.maxVertexCount              = std::max<uint32_t>(mCharacterCount * vertexCount, 1);
+        createInfo.maxJointCount               = std::max<uint32_t>(mCharacterCount * jointCount, 1);
+        PPX_CHECKED_CALL(scene::GpuSkinner::Create(GetDevice(), createInfo, &mSkinner));
+
+        for (uint32_t copy = 0; copy < mCharacterCount; ++copy) {
+            for (auto pNode : mSkinnedNodes) {
+                uint32_t instanceIndex = 0;
+                PPX_CHECKED_CALL(mSkinner->AddInstance(pNode, &instanceIndex));
+            }
+        }
+        PPX_LOG_INFO("Skinning " << mCharacterCount << " copies of " << mSkinnedNodes.size() << " mesh nodes, " << (mCharacterCount * vertexCount) << " vertices");
+    }
+
+    // IBL Textures, generated on the GPU from --ibl-hdr if it's set
+    if (mIBLHDRKnob->GetValue().empty()) {
         PPX_CHECKED_CALL(grfx_util::CreateIBLTexturesFromFile(GetDevice()->GetGraphicsQueue(), GetAssetPath("poly_haven/ibl/old_depot_4k.ibl"), &mIBLIrrMap, &mIBLEnvMap));
     }
+    else {
+        const char*           shaderNames[4] = {"IBLProjectSH.cs", "IBLIrradiance.cs", "IBLPrefilter.cs", "IBLBRDFLUT.cs"};
+        grfx::ShaderModulePtr shaders[4];
+        for (uint32_t i = 0; i < 4; ++i) {
+            PPX_CHECKED_CALL(CreateShader("basic/shaders", shaderNames[i], &shaders[i]));
+        }
+
+        grfx::IBLGeneratorCreateInfo createInfo = {};
+        createInfo.pProjectSHShader             = shaders[0];
+        createInfo.pIrradianceShader            = shaders[1];
+        createInfo.pPrefilterShader             = shaders[2];
+        createInfo.pBRDFLUTShader               = shaders[3];
+
+        grfx::IBLGenerator* pGenerator = nullptr;
+        PPX_CHECKED_CALL(grfx::IBLGenerator::Create(GetDevice(), createInfo, &pGenerator));
+        std::unique_ptr<grfx::IBLGenerator> generator(pGenerator);
+
+        const std::filesystem::path cacheDir = mIBLCacheDirKnob->GetValue();
+        PPX_CHECKED_CALL(grfx_util::CreateIBLTexturesFromHDR(GetDevice()->GetGraphicsQueue(), generator.get(), GetAssetPath(mIBLHDRKnob->GetValue()), cacheDir, &mIBLIrrMap, &mIBLEnvMap));
+        PPX_CHECKED_CALL(grfx_util::CreateBRDFLUTTexture(GetDevice()->GetGraphicsQueue(), generator.get(), cacheDir, &mBRDFLUT));
+
+        generator.reset();
+        for (auto& shader : shaders) {
+            GetDevice()->DestroyShaderModule(shader);
+        }
+    }
 
     // Pipeline args
     {
@@ -164,6 +275,22 @@ void GltfBasicMaterialsApp::Setup()
 
         // Populate IBL textures
         mPipelineArgs->SetIBLTextures(0, mIBLIrrMap->GetSampledImageView(), mIBLEnvMap->GetSampledImageView());
+        if (mBRDFLUT) {
+            mPipelineArgs->SetBRDFLUTTexture(mBRDFLUT->GetSampledImageView());
+        }
+
+        // Populate instance dequantization, it only depends on the mesh
+        for (size_t groupIdx = 0; groupIdx < mInstanceGroups.size(); ++groupIdx) {
+            const auto& group          = mInstanceGroups[groupIdx];
+            const auto& dequantization = group.pMesh->GetMeshData()->GetVertexDequantization();
+            for (uint32_t i = 0; i < CountU32(group.nodes); ++i) {
+                mPipelineArgs->SetVertexDequantization(mInstanceGroupFirstInstances[groupIdx] + i, dequantization);
+            }
+        }
+
+        // NaN never compares equal, so every model matrix is written once
+        const uint32_t instanceCount = mSkinnedFirstInstance + (IsNull(mSkinner) ? 0 : mSkinner->GetInstanceCount());
+        mInstanceModelMatrices.resize(instanceCount, float4x4(std::numeric_limits<float>::quiet_NaN()));
     }
 
     // Pipelines
@@ -180,6 +307,13 @@ void GltfBasicMaterialsApp::Setup()
         // Get vertex bindings - every mesh in the test scene should have the same attributes
         auto vertexBindings = mScene->GetMeshNode(0)->GetMesh()->GetMeshData()->GetAvailableVertexBindings();
 
+#if defined(PPX_BUILD_XR)
+        mMultiView = IsXrEnabled() && GetXrComponent().IsMultiView();
+#endif
+
+        // Compact vertices are decoded by their own vertex shader
+        const std::string materialVsName = std::string(mVertexQuantizationKnob->GetValue() ? "MaterialVertexQuantized" : "MaterialVertex") + (mMultiView ? "MultiView.vs" : ".vs");
+
         auto CreatePipeline = [this, &vertexBindings](const std::string& vsName, const std::string& psName, grfx::GraphicsPipeline** ppPipeline) {
             std::vector<char> bytecode = LoadShader("scene_renderer/shaders", vsName);
             PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
@@ -205,6 +339,12 @@ void GltfBasicMaterialsApp::Setup()
             gpCreateInfo.outputState.renderTargetFormats[0] = GetSwapchain()->GetColorFormat();
             gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
             gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+#if defined(PPX_BUILD_XR)
+            if (mMultiView) {
+                gpCreateInfo.multiViewState.viewMask        = GetXrComponent().GetDefaultViewMask();
+                gpCreateInfo.multiViewState.correlationMask = GetXrComponent().GetDefaultViewMask();
+            }
+#endif
 
             gpCreateInfo.vertexInputState.bindingCount = CountU32(vertexBindings);
             for (uint32_t i = 0; i < gpCreateInfo.vertexInputState.bindingCount; ++i) {
@@ -215,9 +355,14 @@ void GltfBasicMaterialsApp::Setup()
         };
 
         // Pipelines
-        CreatePipeline("MaterialVertex.vs", "StandardMaterial.ps", &mStandardMaterialPipeline);
-        CreatePipeline("MaterialVertex.vs", "UnlitMaterial.ps", &mUnlitMaterialPipeline);
-        CreatePipeline("MaterialVertex.vs", "ErrorMaterial.ps", &mErrorMaterialPipeline);
+        CreatePipeline(materialVsName, "StandardMaterial.ps", &mStandardMaterialPipeline);
+        CreatePipeline(materialVsName, "UnlitMaterial.ps", &mUnlitMaterialPipeline);
+        CreatePipeline(materialVsName, "ErrorMaterial.ps", &mErrorMaterialPipeline);
+
+        // Pipeline part of the render queue sort keys
+        mPipelineSortIndexMap[mStandardMaterialPipeline.Get()] = 0;
+        mPipelineSortIndexMap[mUnlitMaterialPipeline.Get()]    = 1;
+        mPipelineSortIndexMap[mErrorMaterialPipeline.Get()]    = 2;
 
         // Compile pipelines for mmaterials
         for (auto it : mMaterialIndexMap) {
@@ -239,6 +384,7 @@ void GltfBasicMaterialsApp::Setup()
 
 void GltfBasicMaterialsApp::Shutdown()
 {
+    delete mSkinner;
     delete mScene;
     delete mPipelineArgs;
 }
@@ -247,40 +393,161 @@ void GltfBasicMaterialsApp::Render()
 {
     PerFrame& frame = mPerFrame[0];
 
-    grfx::SwapchainPtr swapchain = GetSwapchain();
+    // XR renders each view into its own swapchain, unless it's multiview
+    uint32_t currentViewIndex = 0;
+#if defined(PPX_BUILD_XR)
+    if (IsXrEnabled()) {
+        currentViewIndex = GetXrComponent().GetCurrentViewIndex();
+    }
+#endif
+    grfx::SwapchainPtr swapchain = GetSwapchain(currentViewIndex);
 
     // Wait for and reset render complete fence
     PPX_CHECKED_CALL(frame.renderCompleteFence->WaitAndReset());
 
     uint32_t imageIndex = UINT32_MAX;
-    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, frame.imageAcquiredFence, &imageIndex));
+    if (swapchain->ShouldSkipExternalSynchronization()) {
+        // XR swapchains wait for their images in AcquireNextImage
+        PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, nullptr, nullptr, &imageIndex));
+    }
+    else {
+        PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, frame.imageAcquiredFence, &imageIndex));
+
+        // Wait for and reset image acquired fence
+        PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
+    }
 
-    // Wait for and reset image acquired fence
-    PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
+    // Update camera params, with multiview every view has its own
+    const ppx::Camera* pCamera = mDefaultCamera.has_value() ? &*mDefaultCamera : mScene->GetCameraNode(0)->GetCamera();
+#if defined(PPX_BUILD_XR)
+    if (IsXrEnabled()) {
+        const XrComponent& xrComponent = GetXrComponent();
+        const uint32_t     viewCount   = mMultiView ? static_cast<uint32_t>(xrComponent.GetViewCount()) : 1;
+        for (uint32_t viewIndex = 0; viewIndex < viewCount; ++viewIndex) {
+            mPipelineArgs->SetCameraParams(mMultiView ? &xrComponent.GetCamera(viewIndex) : &xrComponent.GetCamera(), viewIndex);
+        }
+        pCamera = &xrComponent.GetCamera();
+    }
+    else
+#endif
+    {
+        mPipelineArgs->SetCameraParams(pCamera);
+    }
+    const ppx::Camera& camera = *pCamera;
 
-    // Update camera params
-    const ppx::Camera& camera = mDefaultCamera.has_value() ? *mDefaultCamera : *mScene->GetCameraNode(0)->GetCamera();
-    mPipelineArgs->SetCameraParams(&camera);
+    // Animate, each character copy is posed in turn and the last pose is
+    // copy 0's, which the rigid mesh nodes use
+    {
+        const float    time             = static_cast<float>(GetElapsedSeconds());
+        const uint32_t skinnedNodeCount = CountU32(mSkinnedNodes);
+        const bool     hasAnimations    = (mScene->GetAnimationCount() > 0);
+
+        for (uint32_t copy = mCharacterCount; copy > 0; --copy) {
+            if (hasAnimations) {
+                mScene->ApplyAnimations(time + (copy - 1) * kCharacterTimeOffset);
+            }
+            mScene->UpdateTransforms(std::thread::hardware_concurrency());
+
+            for (uint32_t nodeIdx = 0; nodeIdx < skinnedNodeCount; ++nodeIdx) {
+                const scene::MeshNode* pNode       = mSkinnedNodes[nodeIdx];
+                const uint32_t         skinnerIdx  = (copy - 1) * skinnedNodeCount + nodeIdx;
+                const uint32_t         instanceIdx = mSkinnedFirstInstance + skinnerIdx;
+                const float4x4&        nodeMatrix  = pNode->GetEvaluatedMatrix();
+                const float4x4         modelMatrix = glm::translate(static_cast<float>(copy - 1) * mCharacterSpacing) * nodeMatrix;
+
+                pNode->GetSkin()->CalculateJointMatrices(nodeMatrix, mSkinner->GetJointMatrices(skinnerIdx));
+                if (modelMatrix != mInstanceModelMatrices[instanceIdx]) {
+                    mPipelineArgs->GetInstanceParams(instanceIdx)->modelMatrix = modelMatrix;
+                    mInstanceModelMatrices[instanceIdx]                        = modelMatrix;
+                }
+            }
+        }
+    }
 
     // Update instance params
     {
-        const uint32_t numMeshNodes = mScene->GetMeshNodeCount();
-        for (uint32_t instanceIdx = 0; instanceIdx < numMeshNodes; ++instanceIdx) {
-            auto pNode                   = mScene->GetMeshNode(instanceIdx);
-            auto pInstanceParmas         = mPipelineArgs->GetInstanceParams(instanceIdx);
-            pInstanceParmas->modelMatrix = pNode->GetEvaluatedMatrix();
+        // Only write instances that moved, CopyBuffers() copies what's written
+        for (size_t groupIdx = 0; groupIdx < mInstanceGroups.size(); ++groupIdx) {
+            uint32_t instanceIdx = mInstanceGroupFirstInstances[groupIdx];
+            for (auto pNode : mInstanceGroups[groupIdx].nodes) {
+                const float4x4& modelMatrix = pNode->GetEvaluatedMatrix();
+                if (modelMatrix != mInstanceModelMatrices[instanceIdx]) {
+                    mPipelineArgs->GetInstanceParams(instanceIdx)->modelMatrix = modelMatrix;
+                    mInstanceModelMatrices[instanceIdx]                        = modelMatrix;
+                }
+                ++instanceIdx;
+            }
         }
     }
 
+    // Sort batch draws so consecutive draws share pipelines and materials,
+    // groups sort front to back by their first node
+    {
+        mRenderQueue.Clear();
+
+        const float viewportHeight = static_cast<float>(GetWindowHeight());
+        const float maxPixelError  = mLodPixelErrorKnob->GetValue();
+
+        for (size_t groupIdx = 0; groupIdx < mInstanceGroups.size(); ++groupIdx) {
+            const auto&    group     = mInstanceGroups[groupIdx];
+            const uint32_t nodeCount = CountU32(group.nodes);
+            const float3   position  = float3(group.nodes[0]->GetEvaluatedMatrix()[3]);
+            const float    depth     = glm::distance(position, camera.GetEyePosition()) / camera.GetFarClip();
+
+            // Each node picks its own LOD, consecutive instances that pick
+            // the same one share a draw
+            mLodPixelsPerUnit.resize(nodeCount);
+            for (uint32_t nodeIdx = 0; nodeIdx < nodeCount; ++nodeIdx) {
+                mLodPixelsPerUnit[nodeIdx] = scene::CalculateLodPixelsPerUnit(group.nodes[nodeIdx]->GetEvaluatedMatrix(), group.pMesh->GetBoundingBox(), camera, viewportHeight);
+            }
+
+            for (auto& batch : group.pMesh->GetBatches()) {
+                scene::RenderQueue::Draw draw = {};
+                draw.pBatch                   = &batch;
+                draw.pPipeline                = mMaterialPipelineMap[batch.GetMaterial()];
+                draw.materialIndex            = mMaterialIndexMap[batch.GetMaterial()];
+                draw.sortKey                  = scene::RenderQueue::MakeSortKey(mPipelineSortIndexMap[draw.pPipeline], draw.materialIndex, static_cast<uint32_t>(groupIdx), depth);
+
+                uint32_t firstNode = 0;
+                while (firstNode < nodeCount) {
+                    const uint32_t lod     = batch.SelectLod(mLodPixelsPerUnit[firstNode], maxPixelError);
+                    uint32_t       endNode = firstNode + 1;
+                    while ((endNode < nodeCount) && (batch.SelectLod(mLodPixelsPerUnit[endNode], maxPixelError) == lod)) {
+                        ++endNode;
+                    }
+
+                    draw.firstInstance = mInstanceGroupFirstInstances[groupIdx] + firstNode;
+                    draw.instanceCount = endNode - firstNode;
+                    draw.lod           = lod;
+                    mRenderQueue.Add(draw);
+
+                    firstNode = endNode;
+                }
+            }
+        }
+
+        mRenderQueue.Sort();
+    }
+
+    mPipelineBindCount      = 0;
+    mDescriptorSetBindCount = 0;
+    mTriangleCount          = 0;
+
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
     {
         // Copy pipeline args buffers
         mPipelineArgs->CopyBuffers(frame.cmd);
 
+        // Skin vertices of this frame's poses
+        if (!IsNull(mSkinner)) {
+            mSkinner->Skin(frame.cmd);
+        }
+
         // Set descriptor set from pipeline args
         auto pDescriptorSets = mPipelineArgs->GetDescriptorSet();
         frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &pDescriptorSets);
+        ++mDescriptorSetBindCount;
 
         grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
         PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
@@ -291,12 +558,15 @@ void GltfBasicMaterialsApp::Render()
         beginInfo.RTVClearCount             = 1;
         beginInfo.RTVClearValues[0]         = {{0.2f, 0.2f, 0.3f, 1}};
 
-        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+        if (!IsXrEnabled()) {
+            frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+        }
         frame.cmd->BeginRenderPass(&beginInfo);
         {
             frame.cmd->SetScissors(GetScissor());
             frame.cmd->SetViewports(GetViewport());
             frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 0, nullptr);
+            ++mDescriptorSetBindCount;
 
             // Set DrawParams::iblIndex and DrawParams::iblLevelCount
             const uint32_t iblIndex      = 0;
@@ -304,74 +574,188 @@ void GltfBasicMaterialsApp::Render()
             frame.cmd->PushGraphicsConstants(mPipelineInterface, 1, &iblIndex, 2);
             frame.cmd->PushGraphicsConstants(mPipelineInterface, 1, &iblLevelCount, 3);
 
-            // Draw scene
-            const uint32_t numMeshNodes = mScene->GetMeshNodeCount();
-            for (uint32_t instanceIdx = 0; instanceIdx < numMeshNodes; ++instanceIdx) {
-                auto pNode = mScene->GetMeshNode(instanceIdx);
-                auto pMesh = pNode->GetMesh();
-
-                // Set DrawParams::instanceIndex
-                frame.cmd->PushGraphicsConstants(
-                    mPipelineInterface,
-                    1,
-                    &instanceIdx,
-                    scene::MaterialPipelineArgs::INSTANCE_INDEX_CONSTANT_OFFSET);
-
-                // Draw batches
-                auto& batches = pMesh->GetBatches();
-                for (auto& batch : batches) {
-                    // Set pipeline
-                    auto pipeline = mMaterialPipelineMap[batch.GetMaterial()];
-                    frame.cmd->BindGraphicsPipeline(pipeline);
-
-                    // Set DrawParams::materialIndex
-                    uint32_t materialIndex = mMaterialIndexMap[batch.GetMaterial()];
+            // Draw scene, only changing state that differs from the previous draw
+            const grfx::GraphicsPipeline* pBoundPipeline     = nullptr;
+            uint32_t                      boundMaterialIndex = UINT32_MAX;
+            uint32_t                      boundInstanceIndex = UINT32_MAX;
+            for (uint32_t drawIdx = 0; drawIdx < mRenderQueue.GetDrawCount(); ++drawIdx) {
+                const auto& draw  = mRenderQueue.GetDraw(drawIdx);
+                const auto& batch = *draw.pBatch;
+
+                // Set pipeline
+                if (draw.pPipeline != pBoundPipeline) {
+                    frame.cmd->BindGraphicsPipeline(draw.pPipeline);
+                    pBoundPipeline = draw.pPipeline;
+                    ++mPipelineBindCount;
+                }
+
+                // Set DrawParams::materialIndex
+                if (draw.materialIndex != boundMaterialIndex) {
                     frame.cmd->PushGraphicsConstants(
                         mPipelineInterface,
                         1,
-                        &materialIndex,
+                        &draw.materialIndex,
                         scene::MaterialPipelineArgs::MATERIAL_INDEX_CONSTANT_OFFSET);
+                    boundMaterialIndex = draw.materialIndex;
+                }
+
+                // Set DrawParams::instanceIndex to the group's first instance,
+                // the vertex shader adds SV_InstanceID
+                if (draw.firstInstance != boundInstanceIndex) {
+                    frame.cmd->PushGraphicsConstants(
+                        mPipelineInterface,
+                        1,
+                        &draw.firstInstance,
+                        scene::MaterialPipelineArgs::INSTANCE_INDEX_CONSTANT_OFFSET);
+                    boundInstanceIndex = draw.firstInstance;
+                }
+
+                // Index buffer
+                frame.cmd->BindIndexBuffer(&batch.GetIndexBufferView());
+
+                // Vertex buffers
+                std::vector<grfx::VertexBufferView> vertexBufferViews = {
+                    batch.GetPositionBufferView(),
+                    batch.GetAttributeBufferView()};
+                frame.cmd->BindVertexBuffers(CountU32(vertexBufferViews), DataPtr(vertexBufferViews));
+
+                const ppx::MeshLod& lod = batch.GetLod(draw.lod);
+                frame.cmd->DrawIndexed(lod.indexCount, draw.instanceCount, lod.firstIndex, 0, 0);
+                mTriangleCount += static_cast<uint64_t>(lod.indexCount / 3) * draw.instanceCount;
+            }
+
+            // Draw skinned instances from their skinned vertices
+            const uint32_t skinnedInstanceCount = IsNull(mSkinner) ? 0 : mSkinner->GetInstanceCount();
+            for (uint32_t skinnerIdx = 0; skinnerIdx < skinnedInstanceCount; ++skinnerIdx) {
+                const auto&    batches     = mSkinner->GetInstanceNode(skinnerIdx)->GetMesh()->GetBatches();
+                const uint32_t instanceIdx = mSkinnedFirstInstance + skinnerIdx;
+                frame.cmd->PushGraphicsConstants(mPipelineInterface, 1, &instanceIdx, scene::MaterialPipelineArgs::INSTANCE_INDEX_CONSTANT_OFFSET);
+
+                for (uint32_t batchIdx = 0; batchIdx < CountU32(batches); ++batchIdx) {
+                    const auto&                   batch     = batches[batchIdx];
+                    const grfx::GraphicsPipeline* pPipeline = mMaterialPipelineMap[batch.GetMaterial()];
+                    if (pPipeline != pBoundPipeline) {
+                        frame.cmd->BindGraphicsPipeline(pPipeline);
+                        pBoundPipeline = pPipeline;
+                        ++mPipelineBindCount;
+                    }
+
+                    const uint32_t materialIndex = mMaterialIndexMap[batch.GetMaterial()];
+                    frame.cmd->PushGraphicsConstants(mPipelineInterface, 1, &materialIndex, scene::MaterialPipelineArgs::MATERIAL_INDEX_CONSTANT_OFFSET);
 
-                    // Index buffer
                     frame.cmd->BindIndexBuffer(&batch.GetIndexBufferView());
 
-                    // Vertex buffers
                     std::vector<grfx::VertexBufferView> vertexBufferViews = {
-                        batch.GetPositionBufferView(),
-                        batch.GetAttributeBufferView()};
+                        mSkinner->GetPositionBufferView(skinnerIdx, batchIdx),
+                        mSkinner->GetAttributeBufferView(skinnerIdx, batchIdx)};
                     frame.cmd->BindVertexBuffers(CountU32(vertexBufferViews), DataPtr(vertexBufferViews));
 
                     frame.cmd->DrawIndexed(batch.GetIndexCount(), 1, 0, 0, 0);
+                    mTriangleCount += batch.GetIndexCount() / 3;
                 }
             }
 
-            // Draw ImGui
-            DrawDebugInfo();
-            DrawImGui(frame.cmd);
+            // Draw ImGui, XR draws it into its own layer
+            if (!IsXrEnabled()) {
+                DrawDebugInfo();
+                DrawImGui(frame.cmd);
+            }
         }
         frame.cmd->EndRenderPass();
-        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+        if (!IsXrEnabled()) {
+            frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+        }
     }
     PPX_CHECKED_CALL(frame.cmd->End());
 
-    grfx::SubmitInfo submitInfo     = {};
-    submitInfo.commandBufferCount   = 1;
-    submitInfo.ppCommandBuffers     = &frame.cmd;
-    submitInfo.waitSemaphoreCount   = 1;
-    submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
-    submitInfo.pFence               = frame.renderCompleteFence;
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &frame.cmd;
+    // XR swapchains don't use semaphores and aren't presented
+    if (!IsXrEnabled()) {
+        submitInfo.waitSemaphoreCount   = 1;
+        submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
+    }
+    submitInfo.pFence = frame.renderCompleteFence;
 
     PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
 
-    PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
+    if (!IsXrEnabled()) {
+        PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
+    }
 }
 
 void GltfBasicMaterialsApp::InitKnobs()
 {
     GetKnobManager().InitKnob(&mSceneAssetKnob, "gltf-scene-asset", "scene_renderer/scenes/tests/gltf_test_basic_materials.glb");
     mSceneAssetKnob->SetFlagDescription("GLTF asset to load and render");
+
+    GetKnobManager().InitKnob(&mSceneCacheDirKnob, "scene-cache-dir", "");
+    mSceneCacheDirKnob->SetFlagDescription("Directory of cooked scene caches, the scene is loaded from its GLTF file only if empty");
+
+    GetKnobManager().InitKnob(&mIBLHDRKnob, "ibl-hdr", "");
+    mIBLHDRKnob->SetFlagDescription("Equirectangular HDR environment to light the scene with, its IBL textures are generated on the GPU");
+
+    GetKnobManager().InitKnob(&mIBLCacheDirKnob, "ibl-cache-dir", "");
+    mIBLCacheDirKnob->SetFlagDescription("Directory the textures generated for --ibl-hdr are cached in, they are generated on every run if empty");
+
+    GetKnobManager().InitKnob(&mVertexQuantizationKnob, "vertex-quantization", false);
+    mVertexQuantizationKnob->SetFlagDescription("Loads meshes with 16-bit positions, octahedral normals and tangents and half float tex coords");
+
+    GetKnobManager().InitKnob(&mAnimatedCharacterCountKnob, "animated-character-count", 1, 1, 1024);
+    GetKnobManager().InitKnob(&mLodCountKnob, "lod-count", 1, 1, PPX_MESH_MAX_LOD_COUNT);
+    mLodCountKnob->SetFlagDescription("Levels of detail generated for each mesh primitive on load, 1 only loads the full detail meshes");
+
+    GetKnobManager().InitKnob(&mLodPixelErrorKnob, "lod-pixel-error", 1.0f, 0.0f, 16.0f);
+    mLodPixelErrorKnob->SetFlagDescription("Screen space error in pixels a mesh node's LOD may have");
+
+    mAnimatedCharacterCountKnob->SetFlagDescription("Number of copies of the scene's skinned characters, each skinned with its own pose in a compute pre-pass");
+}
+
+void GltfBasicMaterialsApp::SetupMetrics()
+{
+    Application::SetupMetrics();
+
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricMetadata metadata = {ppx::metrics::MetricType::GAUGE, "Pipeline Binds", "", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 1000000.f}};
+    mPipelineBindMetric                   = AddMetric(metadata);
+    PPX_ASSERT_MSG(mPipelineBindMetric != ppx::metrics::kInvalidMetricID, "Failed to add Pipeline Binds metric");
+
+    metadata                 = {ppx::metrics::MetricType::GAUGE, "Descriptor Set Binds", "", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 1000000.f}};
+    mDescriptorSetBindMetric = AddMetric(metadata);
+    PPX_ASSERT_MSG(mDescriptorSetBindMetric != ppx::metrics::kInvalidMetricID, "Failed to add Descriptor Set Binds metric");
+
+    metadata             = {ppx::metrics::MetricType::GAUGE, "Params Bytes Uploaded", "bytes", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 1e9f}};
+    mUploadedBytesMetric = AddMetric(metadata);
+    PPX_ASSERT_MSG(mUploadedBytesMetric != ppx::metrics::kInvalidMetricID, "Failed to add Params Bytes Uploaded metric");
+
+    metadata        = {ppx::metrics::MetricType::GAUGE, "Triangles Drawn", "", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 1e10f}};
+    mTriangleMetric = AddMetric(metadata);
+    PPX_ASSERT_MSG(mTriangleMetric != ppx::metrics::kInvalidMetricID, "Failed to add Triangles Drawn metric");
+}
+
+void GltfBasicMaterialsApp::UpdateMetrics()
+{
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+    data.gauge.seconds            = GetElapsedSeconds();
+
+    data.gauge.value = static_cast<double>(mPipelineBindCount);
+    RecordMetricData(mPipelineBindMetric, data);
+    data.gauge.value = static_cast<double>(mDescriptorSetBindCount);
+    RecordMetricData(mDescriptorSetBindMetric, data);
+    data.gauge.value = static_cast<double>(mPipelineArgs->GetCopiedByteCount());
+    RecordMetricData(mUploadedBytesMetric, data);
+    data.gauge.value = static_cast<double>(mTriangleCount);
+    RecordMetricData(mTriangleMetric, data);
 }
 
 void GltfBasicMaterialsApp::MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons)
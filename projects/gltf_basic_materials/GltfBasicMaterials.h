@@ -16,9 +16,12 @@
 #define GLTF_BASIC_MATERIALS_H
 
 #include "ppx/ppx.h"
+#include "ppx/scene/scene_gpu_skinner.h"
 #include "ppx/scene/scene_material.h"
 #include "ppx/scene/scene_mesh.h"
 #include "ppx/scene/scene_pipeline_args.h"
+#include "ppx/scene/scene_render_queue.h"
+#include "ppx/scene/scene_scene.h"
 
 #include <unordered_map>
 
@@ -33,6 +36,8 @@ public:
     void InitKnobs() override;
     void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
     void Scroll(float dx, float dy) override;
+    void SetupMetrics() override;
+    void UpdateMetrics() override;
 
 private:
     struct PerFrame
@@ -55,13 +60,53 @@ private:
     ppx::scene::Scene*                mScene        = nullptr;
     ppx::scene::MaterialPipelineArgs* mPipelineArgs = nullptr;
 
+    // Mesh nodes of a group use consecutive instance params, starting at
+    // the group's first instance
+    std::vector<ppx::scene::MeshInstanceGroup> mInstanceGroups;
+    std::vector<uint32_t>                      mInstanceGroupFirstInstances;
+    std::vector<ppx::float4x4>                 mInstanceModelMatrices; // Last written to the pipeline args
+
+    // Skinned mesh nodes are drawn once per character copy from their own
+    // skinned vertices. Copy c of skinned node n is skinner instance
+    // i = c * mSkinnedNodes.size() + n and uses instance mSkinnedFirstInstance + i.
+    ppx::scene::GpuSkinner*                  mSkinner              = nullptr;
+    ppx::grfx::ShaderModulePtr               mSkinShader;
+    std::vector<const ppx::scene::MeshNode*> mSkinnedNodes;
+    uint32_t                                 mSkinnedFirstInstance = 0;
+    uint32_t                                 mCharacterCount       = 1;
+    ppx::float3                              mCharacterSpacing     = ppx::float3(0); // Offset between character copies
+
+    ppx::scene::RenderQueue                                          mRenderQueue;
+    std::unordered_map<const ppx::grfx::GraphicsPipeline*, uint32_t> mPipelineSortIndexMap;
+    std::vector<float>                                               mLodPixelsPerUnit; // Of the nodes of the group being queued
+
+    // State binds and triangles of the last frame
+    uint32_t               mPipelineBindCount       = 0;
+    uint32_t               mDescriptorSetBindCount  = 0;
+    uint64_t               mTriangleCount           = 0;
+    ppx::metrics::MetricID mPipelineBindMetric      = ppx::metrics::kInvalidMetricID;
+    ppx::metrics::MetricID mDescriptorSetBindMetric = ppx::metrics::kInvalidMetricID;
+    ppx::metrics::MetricID mUploadedBytesMetric     = ppx::metrics::kInvalidMetricID;
+    ppx::metrics::MetricID mTriangleMetric          = ppx::metrics::kInvalidMetricID;
+
     std::unordered_map<const ppx::scene::Material*, uint32_t>                     mMaterialIndexMap;
     std::unordered_map<const ppx::scene::Material*, ppx::grfx::GraphicsPipeline*> mMaterialPipelineMap;
 
     ppx::grfx::TexturePtr mIBLIrrMap;
     ppx::grfx::TexturePtr mIBLEnvMap;
+    ppx::grfx::TexturePtr mBRDFLUT; // Only set with --ibl-hdr, the pipeline args' default is used otherwise
 
     std::shared_ptr<ppx::KnobFlag<std::string>> mSceneAssetKnob;
+    std::shared_ptr<ppx::KnobFlag<std::string>> mSceneCacheDirKnob;
+    std::shared_ptr<ppx::KnobFlag<std::string>> mIBLHDRKnob;
+    std::shared_ptr<ppx::KnobFlag<std::string>> mIBLCacheDirKnob;
+    std::shared_ptr<ppx::KnobFlag<bool>>        mVertexQuantizationKnob;
+    std::shared_ptr<ppx::KnobFlag<int>>         mAnimatedCharacterCountKnob;
+    std::shared_ptr<ppx::KnobFlag<int>>         mLodCountKnob;
+    std::shared_ptr<ppx::KnobSlider<float>>     mLodPixelErrorKnob;
+
+    // XR multiview, Render() draws every view in one pass
+    bool mMultiView = false;
 
     // Contains a value only if the GLTF scene doesn't have a camera.
     std::optional<ppx::ArcballCamera> mDefaultCamera;
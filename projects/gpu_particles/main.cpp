@@ -0,0 +1,1047 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/ppx.h"
+#include "ppx/camera.h"
+
+using namespace ppx;
+
+#include "shaders/Common.hlsli"
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+static_assert(sizeof(Particle) == 32, "Particle must match Common.hlsli");
+static_assert(sizeof(DrawParticle) == 32, "DrawParticle must match Common.hlsli");
+static_assert(sizeof(grfx::DispatchIndirectCommand) == 3 * sizeof(uint32_t), "ARGS_* offsets assume 3 uint dispatch arguments");
+
+enum RenderMode
+{
+    RENDER_MODE_UNSORTED_OVER                   = 0,
+    RENDER_MODE_SORTED_OVER                     = 1,
+    RENDER_MODE_WEIGHTED_AVERAGE_FRAGMENT_COUNT = 2,
+    RENDER_MODE_WEIGHTED_AVERAGE_EXACT_COVERAGE = 3,
+};
+
+// Order matches RENDER_MODE_*
+const std::vector<std::string> kRenderModeChoices = {"unsorted-over", "sorted-over", "weighted-average-fragment-count", "weighted-average-exact-coverage"};
+
+const uint32_t kFramesInFlight   = 2;
+const int      kMaxParticleCount = 1 << 22;
+
+// UAV to UAV transitions are no-ops, go through another state so writes
+// are visible to the next dispatch
+static void UAVBarrier(grfx::CommandBuffer* pCmd, const grfx::Buffer* pBuffer)
+{
+    pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
+    virtual void Scroll(float dx, float dy) override;
+    virtual void Render() override;
+
+protected:
+    virtual void SetupMetrics() override;
+    virtual void UpdateMetrics() override;
+    virtual void DrawGui() override;
+
+private:
+    struct PerFrame
+    {
+        grfx::CommandBufferPtr computeCmd;
+        grfx::CommandBufferPtr cmd;
+        grfx::SemaphorePtr     imageAcquiredSemaphore;
+        grfx::FencePtr         imageAcquiredFence;
+        grfx::SemaphorePtr     renderCompleteSemaphore;
+        grfx::FencePtr         renderCompleteFence;
+
+        // Compute
+        grfx::BufferPtr        particleParams;
+        grfx::BufferPtr        counterReadback;
+        grfx::DescriptorSetPtr computeSet;
+        uint32_t               readbackAliveIndex = UINT32_MAX; // Counter the readback holds the alive count in
+
+        // Written by compute and drawn by graphics, shared between the queues
+        grfx::BufferPtr drawParticles;
+        grfx::BufferPtr drawArgs;
+
+        // Graphics
+        grfx::BufferPtr        drawParams;
+        grfx::DescriptorSetPtr drawSet;
+    };
+
+    struct WeightedAverage
+    {
+        grfx::GraphicsPipelinePtr gatherPipeline;
+        grfx::GraphicsPipelinePtr combinePipeline;
+        grfx::DrawPassPtr         gatherPass;
+    };
+
+    void SetupCompute();
+    void SetupGraphics();
+    void SetupWeightedAverage();
+    void ReadCounters(PerFrame& frame);
+    void UpdateParams(PerFrame& frame, bool sort);
+    void RecordCompute(PerFrame& frame, uint32_t frameIndex, bool sort);
+    void RecordSort(grfx::CommandBuffer* pCmd);
+    void RecordGraphics(PerFrame& frame, uint32_t frameIndex, uint32_t imageIndex, uint32_t renderMode);
+
+private:
+    std::shared_ptr<KnobFlag<int>>             mMaxParticlesKnob;
+    std::shared_ptr<KnobFlag<bool>>            mAsyncComputeKnob;
+    std::shared_ptr<KnobSlider<int>>           mEmitRateKnob;
+    std::shared_ptr<KnobSlider<float>>         mParticleSizeKnob;
+    std::shared_ptr<KnobDropdown<std::string>> mRenderModeKnob;
+    std::shared_ptr<KnobCheckbox>              mSubgroupOpsKnob;
+    std::vector<PerFrame>                      mPerFrame;
+    ArcballCamera                              mArcballCamera;
+    grfx::AsyncComputeSchedulerPtr             mAsyncComputeScheduler;
+    grfx::AsyncComputeTimings                  mAsyncComputeTimings = {};
+    grfx::DescriptorPoolPtr                    mDescriptorPool;
+
+    // Particle state, only used by the compute queue
+    uint32_t                     mCapacity      = 0;
+    uint32_t                     mSortCapacity  = 0; // Capacity padded for sorting
+    uint32_t                     mAliveIndex    = 0; // Alive list simulated next
+    bool                         mInitPending   = true;
+    float                        mEmitRemainder = 0; // Fraction of a particle carried to the next frame
+    grfx::BufferPtr              mParticlesBuffer;
+    grfx::BufferPtr              mDeadListBuffer;
+    grfx::BufferPtr              mAliveListBuffer;
+    grfx::BufferPtr              mCountersBuffer;
+    grfx::BufferPtr              mIndirectArgsBuffer;
+    grfx::BufferPtr              mSortKeysBuffer;
+    grfx::DescriptorSetLayoutPtr mComputeLayout;
+    grfx::PipelineInterfacePtr   mComputeInterface;
+    grfx::ComputePipelinePtr     mInitPipeline;
+    grfx::ComputePipelinePtr     mKickoffPipeline;
+    grfx::ComputePipelinePtr     mEmitPipeline;
+    grfx::ComputePipelinePtr     mSimulatePipeline;
+    grfx::ComputePipelinePtr     mSimulateSubgroupPipeline; // Null if the GPU lacks subgroup ballots
+    grfx::ComputePipelinePtr     mFinishPipeline;
+    grfx::ComputePipelinePtr     mSortPresortPipeline;
+    grfx::ComputePipelinePtr     mSortMergeStepPipeline;
+    grfx::ComputePipelinePtr     mSortMergeLocalPipeline;
+    grfx::ComputePipelinePtr     mBuildPipeline;
+
+    // Rendering
+    grfx::DescriptorSetLayoutPtr mDrawLayout;
+    grfx::PipelineInterfacePtr   mDrawInterface;
+    grfx::GraphicsPipelinePtr    mOverPipeline;
+    grfx::SamplerPtr             mNearestSampler;
+    grfx::TexturePtr             mWeightedAverageColorTexture;
+    grfx::TexturePtr             mWeightedAverageExtraTexture; // Count or coverage
+    grfx::DescriptorSetLayoutPtr mCombineLayout;
+    grfx::PipelineInterfacePtr   mCombineInterface;
+    grfx::DescriptorSetPtr       mCombineSet;
+    WeightedAverage              mWeightedAverageCount;
+    WeightedAverage              mWeightedAverageCoverage;
+
+    uint32_t          mAliveCount    = 0; // Read back from a previous frame
+    metrics::MetricID mAliveMetric   = metrics::kInvalidMetricID;
+    metrics::MetricID mOverlapMetric = metrics::kInvalidMetricID;
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&mMaxParticlesKnob, "max-particles", 1 << 21, 1024, kMaxParticleCount);
+    mMaxParticlesKnob->SetFlagDescription("Most particles alive at once. Emission stops while they are all alive.");
+
+    GetKnobManager().InitKnob(&mAsyncComputeKnob, "async-compute", true);
+    mAsyncComputeKnob->SetFlagDescription("Simulate on the compute queue while the graphics queue draws the previous frame. Off runs both on the graphics queue.");
+
+    GetKnobManager().InitKnob(&mEmitRateKnob, "emit-rate", 500000, 0, 4000000);
+    mEmitRateKnob->SetDisplayName("Emit Rate");
+    mEmitRateKnob->SetFlagDescription("Particles emitted per second, they live for 2 to 6 seconds.");
+
+    GetKnobManager().InitKnob(&mParticleSizeKnob, "particle-size", 0.02f, 0.005f, 0.2f);
+    mParticleSizeKnob->SetDisplayName("Particle Size");
+    mParticleSizeKnob->SetFlagDescription("Half the width of a newly emitted particle, particles grow to four times this as they age.");
+
+    GetKnobManager().InitKnob(&mRenderModeKnob, "render-mode", RENDER_MODE_SORTED_OVER, kRenderModeChoices);
+    mRenderModeKnob->SetDisplayName("Render Mode");
+    mRenderModeKnob->SetFlagDescription("Selects how the particles are blended. 'unsorted-over' blends them in simulation order, 'sorted-over' sorts them back to front on the GPU first. The 'weighted-average-*' modes are the order independent approximations of oit_demo and don't sort.");
+
+    GetKnobManager().InitKnob(&mSubgroupOpsKnob, "subgroup-ops", true);
+    mSubgroupOpsKnob->SetDisplayName("Subgroup Ops");
+    mSubgroupOpsKnob->SetFlagDescription("Compact the particles with one atomic per subgroup instead of one per particle. Ignored if the GPU doesn't support subgroup ballots.");
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                       = "gpu_particles";
+    settings.enableImGui                   = true;
+    settings.grfx.api                      = kApi;
+    settings.grfx.swapchain.imageCount     = kFramesInFlight;
+    settings.grfx.device.computeQueueCount = 1;
+    settings.grfx.numFramesInFlight        = kFramesInFlight;
+}
+
+void ProjApp::SetupCompute()
+{
+    mCapacity     = static_cast<uint32_t>(mMaxParticlesKnob->GetValue());
+    mSortCapacity = SORT_BLOCK_SIZE;
+    while (mSortCapacity < mCapacity) {
+        mSortCapacity <<= 1;
+    }
+
+    // Buffers
+    {
+        grfx::BufferCreateInfo bufferCreateInfo             = {};
+        bufferCreateInfo.size                               = mCapacity * sizeof(Particle);
+        bufferCreateInfo.structuredElementStride            = sizeof(Particle);
+        bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mParticlesBuffer));
+
+        bufferCreateInfo.size                    = mCapacity * sizeof(uint32_t);
+        bufferCreateInfo.structuredElementStride = sizeof(uint32_t);
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mDeadListBuffer));
+
+        bufferCreateInfo.size = 2 * mCapacity * sizeof(uint32_t);
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mAliveListBuffer));
+
+        bufferCreateInfo.size                    = mSortCapacity * 2 * sizeof(uint32_t);
+        bufferCreateInfo.structuredElementStride = 2 * sizeof(uint32_t);
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mSortKeysBuffer));
+
+        bufferCreateInfo.size                        = COUNTER_COUNT * sizeof(uint32_t);
+        bufferCreateInfo.structuredElementStride     = sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.transferSrc = true;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mCountersBuffer));
+
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = ARGS_COUNT * sizeof(uint32_t);
+        bufferCreateInfo.structuredElementStride            = sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+        bufferCreateInfo.usageFlags.bits.indirectBuffer     = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_INDIRECT_ARGUMENT;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mIndirectArgsBuffer));
+    }
+
+    // Descriptor layout and pipeline interface, shared by all the kernels
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PARTICLE_PARAMS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PARTICLES_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DEAD_LIST_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(ALIVE_LIST_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(COUNTERS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(INDIRECT_ARGS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(SORT_KEYS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DRAW_PARTICLES_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DRAW_ARGS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mComputeLayout));
+
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mComputeLayout;
+        piCreateInfo.pushConstants.count               = sizeof(SortParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding             = SORT_PARAMS_REGISTER;
+        piCreateInfo.pushConstants.set                 = 0;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mComputeInterface));
+    }
+
+    // Pipelines
+    {
+        const grfx::SubgroupCapabilities& subgroup = GetDevice()->GetGpu()->GetShaderCapabilities().subgroup;
+
+        struct Kernel
+        {
+            const char*               name;
+            grfx::ComputePipelinePtr* pPipeline;
+            bool                      enabled;
+        };
+
+        const Kernel kernels[] = {
+            {"Init", &mInitPipeline, true},
+            {"Kickoff", &mKickoffPipeline, true},
+            {"Emit", &mEmitPipeline, true},
+            {"Simulate", &mSimulatePipeline, true},
+            {"SimulateSubgroup", &mSimulateSubgroupPipeline, subgroup.basic && subgroup.ballot},
+            {"Finish", &mFinishPipeline, true},
+            {"SortPresort", &mSortPresortPipeline, true},
+            {"SortMergeStep", &mSortMergeStepPipeline, true},
+            {"SortMergeLocal", &mSortMergeLocalPipeline, true},
+            {"Build", &mBuildPipeline, true},
+        };
+
+        for (const Kernel& kernel : kernels) {
+            if (!kernel.enabled) {
+                continue;
+            }
+
+            grfx::ShaderModulePtr CS;
+            PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", std::string(kernel.name) + ".cs", &CS));
+
+            grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+            cpCreateInfo.CS                              = {CS.Get(), "csmain"};
+            cpCreateInfo.pPipelineInterface              = mComputeInterface;
+            PPX_CHECKED_CALL(GetDevice()->CreateComputePipeline(&cpCreateInfo, kernel.pPipeline));
+
+            GetDevice()->DestroyShaderModule(CS);
+        }
+    }
+
+    // Per frame buffers and descriptors
+    for (uint32_t i = 0; i < kFramesInFlight; ++i) {
+        PerFrame& frame = mPerFrame[i];
+
+        grfx::BufferCreateInfo bufferCreateInfo        = {};
+        bufferCreateInfo.size                          = RoundUp<uint64_t>(sizeof(ParticleParams), PPX_CONSTANT_BUFFER_ALIGNMENT);
+        bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+        bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &frame.particleParams));
+
+        bufferCreateInfo                             = {};
+        bufferCreateInfo.size                        = COUNTER_COUNT * sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.transferDst = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &frame.counterReadback));
+
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = mCapacity * sizeof(DrawParticle);
+        bufferCreateInfo.structuredElementStride            = sizeof(DrawParticle);
+        bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+        bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &frame.drawParticles));
+
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = sizeof(grfx::DrawIndirectCommand);
+        bufferCreateInfo.structuredElementStride            = sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+        bufferCreateInfo.usageFlags.bits.indirectBuffer     = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_INDIRECT_ARGUMENT;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &frame.drawArgs));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mComputeLayout, &frame.computeSet));
+
+        struct StructuredBinding
+        {
+            uint32_t      binding;
+            grfx::Buffer* pBuffer;
+            uint32_t      elementCount;
+        };
+
+        const StructuredBinding structuredBindings[] = {
+            {PARTICLES_REGISTER, mParticlesBuffer, mCapacity},
+            {DEAD_LIST_REGISTER, mDeadListBuffer, mCapacity},
+            {ALIVE_LIST_REGISTER, mAliveListBuffer, 2 * mCapacity},
+            {COUNTERS_REGISTER, mCountersBuffer, COUNTER_COUNT},
+            {INDIRECT_ARGS_REGISTER, mIndirectArgsBuffer, ARGS_COUNT},
+            {SORT_KEYS_REGISTER, mSortKeysBuffer, mSortCapacity},
+            {DRAW_PARTICLES_REGISTER, frame.drawParticles, mCapacity},
+            {DRAW_ARGS_REGISTER, frame.drawArgs, 4},
+        };
+
+        std::vector<grfx::WriteDescriptor> writes;
+
+        grfx::WriteDescriptor write = {};
+        write.binding               = PARTICLE_PARAMS_REGISTER;
+        write.type                  = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.bufferOffset          = 0;
+        write.bufferRange           = PPX_WHOLE_SIZE;
+        write.pBuffer               = frame.particleParams;
+        writes.push_back(write);
+
+        for (const StructuredBinding& structured : structuredBindings) {
+            write                        = {};
+            write.binding                = structured.binding;
+            write.type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+            write.bufferOffset           = 0;
+            write.bufferRange            = PPX_WHOLE_SIZE;
+            write.structuredElementCount = structured.elementCount;
+            write.pBuffer                = structured.pBuffer;
+            writes.push_back(write);
+        }
+
+        PPX_CHECKED_CALL(frame.computeSet->UpdateDescriptors(CountU32(writes), DataPtr(writes)));
+
+        // Graphics only sees the draw buffers between BeginGraphics() and EndGraphics()
+        PPX_CHECKED_CALL(mAsyncComputeScheduler->AddSharedBuffer(i, frame.drawParticles, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+        PPX_CHECKED_CALL(mAsyncComputeScheduler->AddSharedBuffer(i, frame.drawArgs, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT));
+    }
+}
+
+void ProjApp::SetupGraphics()
+{
+    // Particle draw descriptors
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{DRAW_PARAMS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{DRAW_PARTICLES_SRV_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mDrawLayout));
+
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mDrawLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mDrawInterface));
+    }
+
+    for (PerFrame& frame : mPerFrame) {
+        grfx::BufferCreateInfo bufferCreateInfo        = {};
+        bufferCreateInfo.size                          = RoundUp<uint64_t>(sizeof(DrawParams), PPX_CONSTANT_BUFFER_ALIGNMENT);
+        bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+        bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &frame.drawParams));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDrawLayout, &frame.drawSet));
+
+        std::array<grfx::WriteDescriptor, 2> writes = {};
+
+        writes[0].binding      = DRAW_PARAMS_REGISTER;
+        writes[0].type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset = 0;
+        writes[0].bufferRange  = PPX_WHOLE_SIZE;
+        writes[0].pBuffer      = frame.drawParams;
+
+        writes[1].binding                = DRAW_PARTICLES_SRV_REGISTER;
+        writes[1].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+        writes[1].bufferOffset           = 0;
+        writes[1].bufferRange            = PPX_WHOLE_SIZE;
+        writes[1].structuredElementCount = mCapacity;
+        writes[1].pBuffer                = frame.drawParticles;
+
+        PPX_CHECKED_CALL(frame.drawSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data()));
+    }
+
+    // Over, premultiplied
+    {
+        grfx::ShaderModulePtr VS, PS;
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "Over.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "Over.ps", &PS));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {VS.Get(), "vsmain"};
+        gpCreateInfo.PS                                 = {PS.Get(), "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount      = 0;
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = false;
+        gpCreateInfo.depthWriteEnable                   = false;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_PREMULT_ALPHA;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = GetSwapchain()->GetColorFormat();
+        gpCreateInfo.pPipelineInterface                 = mDrawInterface;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mOverPipeline));
+
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+
+    SetupWeightedAverage();
+}
+
+void ProjApp::SetupWeightedAverage()
+{
+    // Textures
+    {
+        grfx::TextureCreateInfo createInfo         = {};
+        createInfo.imageType                       = grfx::IMAGE_TYPE_2D;
+        createInfo.width                           = GetSwapchain()->GetWidth();
+        createInfo.height                          = GetSwapchain()->GetHeight();
+        createInfo.depth                           = 1;
+        createInfo.sampleCount                     = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount                   = 1;
+        createInfo.arrayLayerCount                 = 1;
+        createInfo.usageFlags.bits.colorAttachment = true;
+        createInfo.usageFlags.bits.sampled         = true;
+        createInfo.memoryUsage                     = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                    = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        createInfo.imageFormat = grfx::FORMAT_R16G16B16A16_FLOAT;
+        PPX_CHECKED_CALL(GetDevice()->CreateTexture(&createInfo, &mWeightedAverageColorTexture));
+
+        createInfo.imageFormat = grfx::FORMAT_R16_FLOAT;
+        PPX_CHECKED_CALL(GetDevice()->CreateTexture(&createInfo, &mWeightedAverageExtraTexture));
+    }
+
+    // Gather passes, the count starts at 0 and the transmittance at 1
+    {
+        grfx::DrawPassCreateInfo2 createInfo  = {};
+        createInfo.width                      = mWeightedAverageColorTexture->GetWidth();
+        createInfo.height                     = mWeightedAverageColorTexture->GetHeight();
+        createInfo.renderTargetCount          = 2;
+        createInfo.pRenderTargetImages[0]     = mWeightedAverageColorTexture->GetImage();
+        createInfo.pRenderTargetImages[1]     = mWeightedAverageExtraTexture->GetImage();
+        createInfo.renderTargetClearValues[0] = {0, 0, 0, 0};
+
+        createInfo.renderTargetClearValues[1] = {0, 0, 0, 0};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mWeightedAverageCount.gatherPass));
+
+        createInfo.renderTargetClearValues[1] = {1, 1, 1, 1};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mWeightedAverageCoverage.gatherPass));
+    }
+
+    // Gather pipelines, additive color and added count or multiplied transmittance
+    {
+        grfx::GraphicsPipelineCreateInfo gpCreateInfo   = {};
+        gpCreateInfo.vertexInputState.bindingCount      = 0;
+        gpCreateInfo.inputAssemblyState.topology        = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.rasterState.polygonMode            = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.rasterState.cullMode               = grfx::CULL_MODE_NONE;
+        gpCreateInfo.rasterState.frontFace              = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.rasterState.rasterizationSamples   = grfx::SAMPLE_COUNT_1;
+        gpCreateInfo.depthStencilState.depthTestEnable  = false;
+        gpCreateInfo.depthStencilState.depthWriteEnable = false;
+
+        gpCreateInfo.colorBlendState.blendAttachmentCount = 2;
+
+        gpCreateInfo.colorBlendState.blendAttachments[0].blendEnable         = true;
+        gpCreateInfo.colorBlendState.blendAttachments[0].srcColorBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].dstColorBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].colorBlendOp        = grfx::BLEND_OP_ADD;
+        gpCreateInfo.colorBlendState.blendAttachments[0].srcAlphaBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].dstAlphaBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].alphaBlendOp        = grfx::BLEND_OP_ADD;
+        gpCreateInfo.colorBlendState.blendAttachments[0].colorWriteMask      = grfx::ColorComponentFlags::RGBA();
+
+        gpCreateInfo.colorBlendState.blendAttachments[1].blendEnable         = true;
+        gpCreateInfo.colorBlendState.blendAttachments[1].colorBlendOp        = grfx::BLEND_OP_ADD;
+        gpCreateInfo.colorBlendState.blendAttachments[1].srcAlphaBlendFactor = grfx::BLEND_FACTOR_ZERO;
+        gpCreateInfo.colorBlendState.blendAttachments[1].dstAlphaBlendFactor = grfx::BLEND_FACTOR_ZERO;
+        gpCreateInfo.colorBlendState.blendAttachments[1].alphaBlendOp        = grfx::BLEND_OP_ADD;
+        gpCreateInfo.colorBlendState.blendAttachments[1].colorWriteMask      = grfx::ColorComponentFlags::RGBA();
+
+        gpCreateInfo.outputState.renderTargetCount      = 2;
+        gpCreateInfo.outputState.renderTargetFormats[0] = mWeightedAverageColorTexture->GetImageFormat();
+        gpCreateInfo.outputState.renderTargetFormats[1] = mWeightedAverageExtraTexture->GetImageFormat();
+        gpCreateInfo.pPipelineInterface                 = mDrawInterface;
+
+        grfx::ShaderModulePtr VS, PS;
+
+        // Count type
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageFragmentCountGather.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageFragmentCountGather.ps", &PS));
+        gpCreateInfo.VS                                                      = {VS, "vsmain"};
+        gpCreateInfo.PS                                                      = {PS, "psmain"};
+        gpCreateInfo.colorBlendState.blendAttachments[1].srcColorBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[1].dstColorBlendFactor = grfx::BLEND_FACTOR_ONE;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mWeightedAverageCount.gatherPipeline));
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+
+        // Coverage type
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageExactCoverageGather.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageExactCoverageGather.ps", &PS));
+        gpCreateInfo.VS                                                      = {VS, "vsmain"};
+        gpCreateInfo.PS                                                      = {PS, "psmain"};
+        gpCreateInfo.colorBlendState.blendAttachments[1].srcColorBlendFactor = grfx::BLEND_FACTOR_ZERO;
+        gpCreateInfo.colorBlendState.blendAttachments[1].dstColorBlendFactor = grfx::BLEND_FACTOR_SRC_COLOR;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mWeightedAverageCoverage.gatherPipeline));
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+
+    // Combine descriptors
+    {
+        grfx::SamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.magFilter               = grfx::FILTER_NEAREST;
+        samplerCreateInfo.minFilter               = grfx::FILTER_NEAREST;
+        samplerCreateInfo.mipmapMode              = grfx::SAMPLER_MIPMAP_MODE_NEAREST;
+        PPX_CHECKED_CALL(GetDevice()->CreateSampler(&samplerCreateInfo, &mNearestSampler));
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{COMBINE_SAMPLER_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{COMBINE_COLOR_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{COMBINE_EXTRA_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mCombineLayout));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mCombineLayout, &mCombineSet));
+
+        std::array<grfx::WriteDescriptor, 3> writes = {};
+
+        writes[0].binding  = COMBINE_SAMPLER_REGISTER;
+        writes[0].type     = grfx::DESCRIPTOR_TYPE_SAMPLER;
+        writes[0].pSampler = mNearestSampler;
+
+        writes[1].binding    = COMBINE_COLOR_REGISTER;
+        writes[1].type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[1].pImageView = mWeightedAverageColorTexture->GetSampledImageView();
+
+        writes[2].binding    = COMBINE_EXTRA_REGISTER;
+        writes[2].type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[2].pImageView = mWeightedAverageExtraTexture->GetSampledImageView();
+
+        PPX_CHECKED_CALL(mCombineSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data()));
+
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mCombineLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mCombineInterface));
+    }
+
+    // Combine pipelines, blended over the background
+    {
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.vertexInputState.bindingCount      = 0;
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_BACK;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = false;
+        gpCreateInfo.depthWriteEnable                   = false;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_PREMULT_ALPHA;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = GetSwapchain()->GetColorFormat();
+        gpCreateInfo.pPipelineInterface                 = mCombineInterface;
+
+        grfx::ShaderModulePtr VS, PS;
+
+        // Count type
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageFragmentCountCombine.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageFragmentCountCombine.ps", &PS));
+        gpCreateInfo.VS = {VS, "vsmain"};
+        gpCreateInfo.PS = {PS, "psmain"};
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mWeightedAverageCount.combinePipeline));
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+
+        // Coverage type
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageExactCoverageCombine.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("gpu_particles/shaders", "WeightedAverageExactCoverageCombine.ps", &PS));
+        gpCreateInfo.VS = {VS, "vsmain"};
+        gpCreateInfo.PS = {PS, "psmain"};
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mWeightedAverageCoverage.combinePipeline));
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+}
+
+void ProjApp::Setup()
+{
+    const bool     asyncCompute = mAsyncComputeKnob->GetValue();
+    grfx::QueuePtr computeQueue = asyncCompute ? GetComputeQueue() : GetGraphicsQueue();
+
+    // Per frame data
+    for (uint32_t i = 0; i < kFramesInFlight; ++i) {
+        PerFrame frame = {};
+
+        PPX_CHECKED_CALL(computeQueue->CreateCommandBuffer(&frame.computeCmd));
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&frame.cmd));
+
+        grfx::SemaphoreCreateInfo semaCreateInfo = {};
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.imageAcquiredSemaphore));
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.renderCompleteSemaphore));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {};
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.imageAcquiredFence));
+        fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.renderCompleteFence));
+
+        mPerFrame.push_back(frame);
+    }
+
+    // Without async compute the scheduler only adds the semaphores and timestamps
+    {
+        grfx::AsyncComputeSchedulerCreateInfo createInfo = {};
+        createInfo.pGraphicsQueue                        = GetGraphicsQueue();
+        createInfo.pComputeQueue                         = computeQueue;
+        createInfo.frameCount                            = kFramesInFlight;
+        PPX_CHECKED_CALL(GetDevice()->CreateAsyncComputeScheduler(&createInfo, &mAsyncComputeScheduler));
+    }
+
+    // Descriptor pool: per frame a compute and a draw set, and the combine set
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.uniformBuffer                  = 2 * kFramesInFlight;
+        poolCreateInfo.structuredBuffer               = 9 * kFramesInFlight;
+        poolCreateInfo.sampledImage                   = 2;
+        poolCreateInfo.sampler                        = 1;
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
+    }
+
+    SetupCompute();
+    SetupGraphics();
+
+    // Arcball camera
+    {
+        mArcballCamera.LookAt(float3(0, 4, 12), float3(0, 3, 0), float3(0, 1, 0));
+        mArcballCamera.SetPerspective(60.0f, GetWindowAspect());
+    }
+}
+
+void ProjApp::SetupMetrics()
+{
+    Application::SetupMetrics();
+
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricMetadata metadata = {ppx::metrics::MetricType::GAUGE, "Alive Particles", "", ppx::metrics::MetricInterpretation::NONE, {0.f, static_cast<double>(kMaxParticleCount)}};
+    mAliveMetric                          = AddMetric(metadata);
+    PPX_ASSERT_MSG(mAliveMetric != ppx::metrics::kInvalidMetricID, "Failed to add Alive Particles metric");
+
+    metadata       = {ppx::metrics::MetricType::GAUGE, "Async Compute Overlap", "ms", ppx::metrics::MetricInterpretation::HIGHER_IS_BETTER, {0.f, 60000.f}};
+    mOverlapMetric = AddMetric(metadata);
+    PPX_ASSERT_MSG(mOverlapMetric != ppx::metrics::kInvalidMetricID, "Failed to add Async Compute Overlap metric");
+}
+
+void ProjApp::UpdateMetrics()
+{
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+    data.gauge.seconds            = GetElapsedSeconds();
+
+    data.gauge.value = static_cast<double>(mAliveCount);
+    RecordMetricData(mAliveMetric, data);
+    data.gauge.value = mAsyncComputeTimings.overlapMs;
+    RecordMetricData(mOverlapMetric, data);
+}
+
+void ProjApp::MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons)
+{
+    if (buttons & ppx::MOUSE_BUTTON_LEFT) {
+        int32_t prevX = x - dx;
+        int32_t prevY = y - dy;
+
+        float2 prevPos = GetNormalizedDeviceCoordinates(prevX, prevY);
+        float2 curPos  = GetNormalizedDeviceCoordinates(x, y);
+
+        mArcballCamera.Rotate(prevPos, curPos);
+    }
+    else if (buttons & ppx::MOUSE_BUTTON_RIGHT) {
+        int32_t prevX = x - dx;
+        int32_t prevY = y - dy;
+
+        float2 prevPos = GetNormalizedDeviceCoordinates(prevX, prevY);
+        float2 curPos  = GetNormalizedDeviceCoordinates(x, y);
+        float2 delta   = curPos - prevPos;
+
+        mArcballCamera.Pan(delta);
+    }
+}
+
+void ProjApp::Scroll(float dx, float dy)
+{
+    mArcballCamera.Zoom(dy / 2.0f);
+}
+
+void ProjApp::ReadCounters(PerFrame& frame)
+{
+    if (frame.readbackAliveIndex == UINT32_MAX) {
+        return;
+    }
+
+    uint32_t counters[COUNTER_COUNT] = {};
+    PPX_CHECKED_CALL(frame.counterReadback->CopyToDest(sizeof(counters), counters));
+    mAliveCount = counters[COUNTER_ALIVE + frame.readbackAliveIndex];
+}
+
+void ProjApp::UpdateParams(PerFrame& frame, bool sort)
+{
+    // Long frames would emit and move everything at once
+    const float deltaTime = std::min(GetPrevFrameTime() / 1000.0f, 1.0f / 30.0f);
+
+    const float emitCount = mEmitRateKnob->GetValue() * deltaTime + mEmitRemainder;
+    mEmitRemainder        = emitCount - std::floor(emitCount);
+
+    ParticleParams params  = {};
+    params.viewMatrix      = mArcballCamera.GetViewMatrix();
+    params.emitterPosition = float3(0, 0, 0);
+    params.deltaTime       = deltaTime;
+    params.gravity         = float3(0, -2.0f, 0);
+    params.time            = GetElapsedSeconds();
+    params.emitCount       = static_cast<uint32_t>(emitCount);
+    params.capacity        = mCapacity;
+    params.aliveIndex      = mAliveIndex;
+    params.flags           = sort ? PARTICLE_FLAG_SORT : 0;
+    params.minLifetime     = 2.0f;
+    params.maxLifetime     = 6.0f;
+    params.emitSpeed       = 6.0f;
+    params.swirl           = 1.5f;
+    params.particleSize    = mParticleSizeKnob->GetValue();
+    params.opacity         = 0.5f;
+    params.randomSeed      = static_cast<uint32_t>(GetFrameCount());
+    PPX_CHECKED_CALL(frame.particleParams->CopyFromSource(sizeof(params), &params));
+
+    // Camera facing quads
+    const float4x4& view = mArcballCamera.GetViewMatrix();
+
+    DrawParams drawParams           = {};
+    drawParams.viewProjectionMatrix = mArcballCamera.GetViewProjectionMatrix();
+    drawParams.cameraRight          = float3(view[0][0], view[1][0], view[2][0]);
+    drawParams.cameraUp             = float3(view[0][1], view[1][1], view[2][1]);
+    PPX_CHECKED_CALL(frame.drawParams->CopyFromSource(sizeof(drawParams), &drawParams));
+}
+
+void ProjApp::RecordCompute(PerFrame& frame, uint32_t frameIndex, bool sort)
+{
+    grfx::CommandBuffer* pCmd = frame.computeCmd;
+
+    const uint32_t argStride   = sizeof(uint32_t);
+    const bool     subgroupOps = mSubgroupOpsKnob->GetValue() && !mSimulateSubgroupPipeline.IsNull();
+
+    mAsyncComputeScheduler->BeginCompute(frameIndex, pCmd);
+
+    pCmd->BindComputeDescriptorSets(mComputeInterface, 1, &frame.computeSet);
+
+    if (mInitPending) {
+        pCmd->BindComputePipeline(mInitPipeline);
+        pCmd->Dispatch((std::max<uint32_t>(mCapacity, COUNTER_COUNT) + PARTICLE_GROUP_SIZE - 1) / PARTICLE_GROUP_SIZE, 1, 1);
+        UAVBarrier(pCmd, mDeadListBuffer);
+        UAVBarrier(pCmd, mCountersBuffer);
+        mInitPending = false;
+    }
+
+    // Kickoff
+    pCmd->BufferResourceBarrier(mIndirectArgsBuffer, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->BindComputePipeline(mKickoffPipeline);
+    pCmd->Dispatch(1, 1, 1);
+    UAVBarrier(pCmd, mCountersBuffer);
+    pCmd->BufferResourceBarrier(mIndirectArgsBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+    // Emit
+    pCmd->BindComputePipeline(mEmitPipeline);
+    pCmd->DispatchIndirect(mIndirectArgsBuffer, ARGS_EMIT * argStride);
+    UAVBarrier(pCmd, mParticlesBuffer);
+    UAVBarrier(pCmd, mDeadListBuffer);
+    UAVBarrier(pCmd, mAliveListBuffer);
+    UAVBarrier(pCmd, mCountersBuffer);
+
+    // Simulate and compact
+    pCmd->BindComputePipeline(subgroupOps ? mSimulateSubgroupPipeline : mSimulatePipeline);
+    pCmd->DispatchIndirect(mIndirectArgsBuffer, ARGS_SIMULATE * argStride);
+    UAVBarrier(pCmd, mParticlesBuffer);
+    UAVBarrier(pCmd, mDeadListBuffer);
+    UAVBarrier(pCmd, mAliveListBuffer);
+    UAVBarrier(pCmd, mCountersBuffer);
+    UAVBarrier(pCmd, mSortKeysBuffer);
+
+    // Sort, build and draw arguments
+    pCmd->BufferResourceBarrier(mIndirectArgsBuffer, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->BufferResourceBarrier(frame.drawArgs, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->BindComputePipeline(mFinishPipeline);
+    pCmd->Dispatch(1, 1, 1);
+    UAVBarrier(pCmd, mCountersBuffer);
+    pCmd->BufferResourceBarrier(frame.drawArgs, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT);
+    pCmd->BufferResourceBarrier(mIndirectArgsBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT);
+
+    if (sort) {
+        RecordSort(pCmd);
+    }
+
+    // Draw buffer
+    pCmd->BufferResourceBarrier(frame.drawParticles, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->BindComputePipeline(mBuildPipeline);
+    pCmd->DispatchIndirect(mIndirectArgsBuffer, ARGS_BUILD * argStride);
+    pCmd->BufferResourceBarrier(frame.drawParticles, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    // Alive count for the GUI and metrics, read once the frame's fence is signaled
+    {
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = COUNTER_COUNT * sizeof(uint32_t);
+
+        pCmd->BufferResourceBarrier(mCountersBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+        pCmd->CopyBufferToBuffer(&copyInfo, mCountersBuffer, frame.counterReadback);
+        pCmd->BufferResourceBarrier(mCountersBuffer, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+        frame.readbackAliveIndex = 1 - mAliveIndex;
+    }
+
+    mAsyncComputeScheduler->EndCompute(frameIndex, pCmd);
+
+    // The survivors are simulated next frame
+    mAliveIndex = 1 - mAliveIndex;
+}
+
+void ProjApp::RecordSort(grfx::CommandBuffer* pCmd)
+{
+    const uint64_t argOffset = ARGS_SORT * sizeof(uint32_t);
+
+    pCmd->BindComputePipeline(mSortPresortPipeline);
+    pCmd->DispatchIndirect(mIndirectArgsBuffer, argOffset);
+    UAVBarrier(pCmd, mSortKeysBuffer);
+
+    // Passes for the largest count, the ones merging sequences longer than
+    // this frame's padded count return right away
+    for (uint32_t k = 2 * SORT_BLOCK_SIZE; k <= mSortCapacity; k <<= 1) {
+        SortParams params = {};
+        params.k          = k;
+
+        pCmd->BindComputePipeline(mSortMergeStepPipeline);
+        for (uint32_t j = k >> 1; j >= SORT_BLOCK_SIZE; j >>= 1) {
+            params.j = j;
+            pCmd->PushComputeConstants(mComputeInterface, sizeof(params) / sizeof(uint32_t), &params);
+            pCmd->DispatchIndirect(mIndirectArgsBuffer, argOffset);
+            UAVBarrier(pCmd, mSortKeysBuffer);
+        }
+
+        params.j = SORT_BLOCK_SIZE >> 1;
+        pCmd->BindComputePipeline(mSortMergeLocalPipeline);
+        pCmd->PushComputeConstants(mComputeInterface, sizeof(params) / sizeof(uint32_t), &params);
+        pCmd->DispatchIndirect(mIndirectArgsBuffer, argOffset);
+        UAVBarrier(pCmd, mSortKeysBuffer);
+    }
+}
+
+void ProjApp::RecordGraphics(PerFrame& frame, uint32_t frameIndex, uint32_t imageIndex, uint32_t renderMode)
+{
+    grfx::CommandBuffer* pCmd = frame.cmd;
+
+    mAsyncComputeScheduler->BeginGraphics(frameIndex, pCmd);
+
+    const WeightedAverage* pWeightedAverage = nullptr;
+    if (renderMode == RENDER_MODE_WEIGHTED_AVERAGE_FRAGMENT_COUNT) {
+        pWeightedAverage = &mWeightedAverageCount;
+    }
+    else if (renderMode == RENDER_MODE_WEIGHTED_AVERAGE_EXACT_COVERAGE) {
+        pWeightedAverage = &mWeightedAverageCoverage;
+    }
+
+    if (!IsNull(pWeightedAverage)) {
+        pCmd->TransitionImageLayout(pWeightedAverage->gatherPass, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_UNDEFINED, grfx::RESOURCE_STATE_UNDEFINED);
+        pCmd->BeginRenderPass(pWeightedAverage->gatherPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS);
+        {
+            pCmd->SetScissors(pWeightedAverage->gatherPass->GetScissor());
+            pCmd->SetViewports(pWeightedAverage->gatherPass->GetViewport());
+
+            pCmd->BindGraphicsDescriptorSets(mDrawInterface, 1, &frame.drawSet);
+            pCmd->BindGraphicsPipeline(pWeightedAverage->gatherPipeline);
+            pCmd->DrawIndirect(frame.drawArgs, 0, 1);
+        }
+        pCmd->EndRenderPass();
+        pCmd->TransitionImageLayout(pWeightedAverage->gatherPass, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNDEFINED, grfx::RESOURCE_STATE_UNDEFINED);
+    }
+
+    grfx::RenderPassPtr renderPass = GetSwapchain()->GetRenderPass(imageIndex);
+    PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
+
+    grfx::RenderPassBeginInfo beginInfo = {};
+    beginInfo.pRenderPass               = renderPass;
+    beginInfo.renderArea                = renderPass->GetRenderArea();
+    beginInfo.RTVClearCount             = 1;
+    beginInfo.RTVClearValues[0]         = {{0.02f, 0.02f, 0.04f, 1.0f}};
+
+    pCmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+    pCmd->BeginRenderPass(&beginInfo);
+    {
+        pCmd->SetScissors(GetScissor());
+        pCmd->SetViewports(GetViewport());
+
+        if (IsNull(pWeightedAverage)) {
+            pCmd->BindGraphicsDescriptorSets(mDrawInterface, 1, &frame.drawSet);
+            pCmd->BindGraphicsPipeline(mOverPipeline);
+            pCmd->DrawIndirect(frame.drawArgs, 0, 1);
+        }
+        else {
+            pCmd->BindGraphicsDescriptorSets(mCombineInterface, 1, &mCombineSet);
+            pCmd->BindGraphicsPipeline(pWeightedAverage->combinePipeline);
+            pCmd->Draw(3);
+        }
+
+        // Draw ImGui
+        DrawDebugInfo();
+        DrawImGui(pCmd);
+    }
+    pCmd->EndRenderPass();
+    pCmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+
+    mAsyncComputeScheduler->EndGraphics(frameIndex, pCmd);
+}
+
+void ProjApp::Render()
+{
+    const uint32_t frameIndex = static_cast<uint32_t>(GetFrameCount() % kFramesInFlight);
+    PerFrame&      frame      = mPerFrame[frameIndex];
+
+    grfx::SwapchainPtr swapchain = GetSwapchain();
+
+    // Graphics waited for the frame's compute, so both have completed
+    PPX_CHECKED_CALL(frame.renderCompleteFence->WaitAndReset());
+    ReadCounters(frame);
+    mAsyncComputeScheduler->ReadTimings(frameIndex, &mAsyncComputeTimings);
+
+    uint32_t imageIndex = UINT32_MAX;
+    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, frame.imageAcquiredFence, &imageIndex));
+
+    // Wait for and reset image acquired fence
+    PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
+
+    const uint32_t renderMode = static_cast<uint32_t>(mRenderModeKnob->GetIndex());
+    const bool     sort       = (renderMode == RENDER_MODE_SORTED_OVER);
+
+    UpdateParams(frame, sort);
+
+    // Compute
+    {
+        PPX_CHECKED_CALL(frame.computeCmd->Begin());
+        RecordCompute(frame, frameIndex, sort);
+        PPX_CHECKED_CALL(frame.computeCmd->End());
+
+        grfx::SubmitInfo submitInfo   = {};
+        submitInfo.commandBufferCount = 1;
+        submitInfo.ppCommandBuffers   = &frame.computeCmd;
+        PPX_CHECKED_CALL(mAsyncComputeScheduler->SubmitCompute(frameIndex, &submitInfo));
+    }
+
+    // Graphics, waits on the compute semaphore
+    {
+        PPX_CHECKED_CALL(frame.cmd->Begin());
+        RecordGraphics(frame, frameIndex, imageIndex, renderMode);
+        PPX_CHECKED_CALL(frame.cmd->End());
+
+        grfx::SubmitInfo submitInfo     = {};
+        submitInfo.commandBufferCount   = 1;
+        submitInfo.ppCommandBuffers     = &frame.cmd;
+        submitInfo.waitSemaphoreCount   = 1;
+        submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
+        submitInfo.pFence               = frame.renderCompleteFence;
+        PPX_CHECKED_CALL(mAsyncComputeScheduler->SubmitGraphics(frameIndex, &submitInfo));
+    }
+
+    PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
+}
+
+void ProjApp::DrawGui()
+{
+    ImGui::Separator();
+
+    ImGui::Text("Alive Particles: %u / %u", mAliveCount, mCapacity);
+    ImGui::Text("Async Compute: %s", mAsyncComputeScheduler->IsAsync() ? "on" : "off");
+    ImGui::Text("Subgroup Ballot: %s", mSimulateSubgroupPipeline.IsNull() ? "unsupported" : "supported");
+    ImGui::Text("Compute: %.3f ms", mAsyncComputeTimings.computeMs);
+    ImGui::Text("Graphics: %.3f ms", mAsyncComputeTimings.graphicsMs);
+    ImGui::Text("Overlap: %.3f ms", mAsyncComputeTimings.overlapMs);
+}
+
+SETUP_APPLICATION(ProjApp)
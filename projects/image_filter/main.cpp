@@ -69,6 +69,13 @@ private:
     grfx::SamplerPtr             mComputeSampler;
     grfx::BufferPtr              mComputeUniformBuffer;
 
+    // Tiled shared memory filters, run instead of ImageFilter.hlsl when enabled
+    std::unique_ptr<grfx::ImageFilter> mImageFilter;
+    grfx::ShaderModulePtr              mImageFilterShaders[3];
+    std::vector<grfx::ImagePtr>        mTempImages;
+    bool                               mUseTiledFilters = false;
+    int                                mFilterRadius    = 1;
+
     // Options
     uint32_t mFilterOption = 0;
     uint32_t mImageOption  = 0;
@@ -92,6 +99,8 @@ private:
 
     void SetupDrawToSwapchain();
     void SetupComputeShaderPass();
+    void SetupImageFilter();
+    bool UsesImageFilter() const;
 
     float4x4 calculateTransform(float2 imgSize);
     void     changeImages();
@@ -121,6 +130,7 @@ void ProjApp::Setup()
 
     // To filter the image
     SetupComputeShaderPass();
+    SetupImageFilter();
     // To present the image on screen
     SetupDrawToSwapchain();
 
@@ -165,7 +175,7 @@ void ProjApp::SetupComputeShaderPass()
 
     // Texture images, views, and sampler
     {
-        std::vector<std::string> imageFiles = {"basic/textures/hanging_lights.jpg", "basic/textures/chinatown.jpg", "basic/textures/box_panel.jpg", "benchmarks/textures/test_image_1280x720.jpg"};
+        std::vector<std::string> imageFiles = {"basic/textures/hanging_lights.jpg", "basic/textures/chinatown.jpg", "basic/textures/box_panel.jpg", "benchmarks/textures/test_image_1280x720.jpg", "benchmarks/textures/bricks_4k.png"};
 
         for (size_t i = 0; i < imageFiles.size(); ++i) {
             grfx_util::ImageOptions options = grfx_util::ImageOptions().AdditionalUsage(grfx::IMAGE_USAGE_STORAGE).MipLevelCount(1);
@@ -193,6 +203,11 @@ void ProjApp::SetupComputeShaderPass()
 
                 PPX_CHECKED_CALL(GetDevice()->CreateImage(&ci, &filteredImage));
                 mFilteredImages.push_back(filteredImage);
+
+                // Intermediate of separable filters
+                grfx::ImagePtr tempImage;
+                PPX_CHECKED_CALL(GetDevice()->CreateImage(&ci, &tempImage));
+                mTempImages.push_back(tempImage);
             }
             grfx::SampledImageViewPtr        sampledImageView;
             grfx::SampledImageViewCreateInfo sampledViewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(mOriginalImages[i]);
@@ -276,6 +291,39 @@ void ProjApp::SetupComputeShaderPass()
     }
 }
 
+void ProjApp::SetupImageFilter()
+{
+    const char* shaderNames[3] = {"ImageFilterSeparable.cs", "ImageFilter2D.cs", "ImageFilterResample.cs"};
+    for (uint32_t i = 0; i < 3; ++i) {
+        std::vector<char> bytecode = LoadShader("basic/shaders", shaderNames[i]);
+        PPX_ASSERT_MSG(!bytecode.empty(), "CS shader bytecode load failed");
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &mImageFilterShaders[i]));
+    }
+
+    grfx::ImageFilterCreateInfo createInfo = {};
+    createInfo.pSeparableShader            = mImageFilterShaders[0];
+    createInfo.p2DShader                   = mImageFilterShaders[1];
+    createInfo.pResampleShader             = mImageFilterShaders[2];
+
+    grfx::ImageFilter* pFilter = nullptr;
+    PPX_CHECKED_CALL(grfx::ImageFilter::Create(GetDevice(), createInfo, &pFilter));
+    mImageFilter.reset(pFilter);
+}
+
+bool ProjApp::UsesImageFilter() const
+{
+    // Box and bilateral only exist in the tiled library, sharpen and
+    // desaturate only in ImageFilter.hlsl
+    switch (mFilterOption) {
+        case 1:
+        case 4: return mUseTiledFilters;
+        case 5:
+        case 6: return true;
+        default: return false;
+    }
+}
+
 void ProjApp::SetupDrawToSwapchain()
 {
     // Image and sampler
@@ -478,15 +526,30 @@ void ProjApp::Render()
         beginInfo.RTVClearValues[0]         = {{0, 0, 0, 0}};
 
         // Filter image with CS
-        frame.cmd->TransitionImageLayout(mFilteredImages[mImageOption], PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
-        frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
-        frame.cmd->BindComputeDescriptorSets(mComputePipelineInterface, 1, &mComputeDescriptorSet);
-        frame.cmd->BindComputePipeline(mComputePipeline);
-        uint32_t dispatchX = static_cast<uint32_t>(std::ceil(mFilteredImages[mImageOption]->GetWidth() / 32.0));
-        uint32_t dispatchY = static_cast<uint32_t>(std::ceil(mFilteredImages[mImageOption]->GetHeight() / 32.0));
-        frame.cmd->Dispatch(dispatchX, dispatchY, 1);
-        frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
-        frame.cmd->TransitionImageLayout(mFilteredImages[mImageOption], PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        if (UsesImageFilter()) {
+            const grfx::ImageFilterType types[] = {grfx::IMAGE_FILTER_TYPE_GAUSSIAN, grfx::IMAGE_FILTER_TYPE_GAUSSIAN, grfx::IMAGE_FILTER_TYPE_GAUSSIAN, grfx::IMAGE_FILTER_TYPE_GAUSSIAN, grfx::IMAGE_FILTER_TYPE_SOBEL, grfx::IMAGE_FILTER_TYPE_BOX, grfx::IMAGE_FILTER_TYPE_BILATERAL};
+
+            grfx::ImageFilterParams params = {};
+            params.type                    = types[mFilterOption];
+            params.radius                  = static_cast<uint32_t>(mFilterRadius);
+
+            // Single frame in flight, the previous frame's dispatches completed
+            mImageFilter->Reset();
+            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+            PPX_CHECKED_CALL(mImageFilter->Record(frame.cmd, params, mOriginalImages[mImageOption], grfx::RESOURCE_STATE_SHADER_RESOURCE, mFilteredImages[mImageOption], grfx::RESOURCE_STATE_SHADER_RESOURCE, mTempImages[mImageOption]));
+            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+        }
+        else {
+            frame.cmd->TransitionImageLayout(mFilteredImages[mImageOption], PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+            frame.cmd->BindComputeDescriptorSets(mComputePipelineInterface, 1, &mComputeDescriptorSet);
+            frame.cmd->BindComputePipeline(mComputePipeline);
+            uint32_t dispatchX = static_cast<uint32_t>(std::ceil(mFilteredImages[mImageOption]->GetWidth() / 32.0));
+            uint32_t dispatchY = static_cast<uint32_t>(std::ceil(mFilteredImages[mImageOption]->GetHeight() / 32.0));
+            frame.cmd->Dispatch(dispatchX, dispatchY, 1);
+            frame.cmd->WriteTimestamp(frame.timestampQuery, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+            frame.cmd->TransitionImageLayout(mFilteredImages[mImageOption], PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        }
 
         frame.cmd->SetScissors(renderPass->GetScissor());
         frame.cmd->SetViewports(renderPass->GetViewport());
@@ -598,7 +661,7 @@ void ProjApp::DrawGui()
     ImGui::Separator();
     ImGui::Text("Filter time: %fms", mCSDurationMs);
     ImGui::Separator();
-    const std::vector<const char*> filterNames = {"No filter", "Blur", "Sharpen", "Desaturate", "Sobel"};
+    const std::vector<const char*> filterNames = {"No filter", "Blur", "Sharpen", "Desaturate", "Sobel", "Box", "Bilateral"};
 
     if (ImGui::BeginCombo("Filter", filterNames[mFilterOption])) {
         for (size_t i = 0; i < filterNames.size(); ++i) {
@@ -613,7 +676,24 @@ void ProjApp::DrawGui()
         ImGui::EndCombo();
     }
 
-    const std::vector<const char*> imageNames = {"Lights", "Chinatown", "Box", "San Francisco"};
+    ImGui::Checkbox("Tiled compute filters", &mUseTiledFilters);
+    if (UsesImageFilter()) {
+        grfx::ImageFilterParams params = {};
+        params.type                    = (mFilterOption == 5) ? grfx::IMAGE_FILTER_TYPE_BOX : grfx::IMAGE_FILTER_TYPE_GAUSSIAN;
+        params.radius                  = static_cast<uint32_t>(mFilterRadius);
+
+        // Bilateral and Sobel only have the 2D kernel
+        const bool separableType = (mFilterOption == 1) || (mFilterOption == 5);
+        const bool separable     = separableType && grfx::ImageFilter::UsesSeparablePasses(params, true);
+        const int  maxRadius     = static_cast<int>(separableType ? grfx::ImageFilter::kMaxSeparableRadius : grfx::ImageFilter::kMax2DRadius);
+        mFilterRadius            = std::min(mFilterRadius, maxRadius);
+        if (mFilterOption != 4) {
+            ImGui::SliderInt("Radius", &mFilterRadius, 1, maxRadius);
+        }
+        ImGui::Text("Kernel: %s", separable ? "separable (2 passes)" : "2D (1 pass)");
+    }
+
+    const std::vector<const char*> imageNames = {"Lights", "Chinatown", "Box", "San Francisco", "Bricks 4K"};
     if (ImGui::BeginCombo("Image", imageNames[mImageOption])) {
         for (size_t i = 0; i < imageNames.size(); ++i) {
             bool isSelected = (i == mImageOption);
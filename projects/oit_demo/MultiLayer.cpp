@@ -0,0 +1,469 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "OITDemoApplication.h"
+
+void OITDemoApp::SetupMultiLayer()
+{
+    mMultiLayer.texturesNeedClear = true;
+
+    // Count texture
+    {
+        grfx::TextureCreateInfo createInfo         = {};
+        createInfo.imageType                       = grfx::IMAGE_TYPE_2D;
+        createInfo.width                           = mTransparencyTexture->GetWidth();
+        createInfo.height                          = mTransparencyTexture->GetHeight();
+        createInfo.depth                           = 1;
+        createInfo.imageFormat                     = grfx::FORMAT_R32_UINT;
+        createInfo.sampleCount                     = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount                   = 1;
+        createInfo.arrayLayerCount                 = 1;
+        createInfo.usageFlags.bits.colorAttachment = true;
+        createInfo.usageFlags.bits.storage         = true;
+        createInfo.memoryUsage                     = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                    = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        PPX_CHECKED_CALL(GetDevice()->CreateTexture(&createInfo, &mMultiLayer.countTexture));
+    }
+
+    // Layer textures
+    {
+        grfx::TextureCreateInfo createInfo         = {};
+        createInfo.imageType                       = grfx::IMAGE_TYPE_2D;
+        createInfo.width                           = mMultiLayer.countTexture->GetWidth();
+        createInfo.height                          = mMultiLayer.countTexture->GetHeight() * MULTI_LAYER_MAX_LAYERS_COUNT;
+        createInfo.depth                           = 1;
+        createInfo.imageFormat                     = grfx::FORMAT_R32_UINT;
+        createInfo.sampleCount                     = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount                   = 1;
+        createInfo.arrayLayerCount                 = 1;
+        createInfo.usageFlags.bits.colorAttachment = true;
+        createInfo.usageFlags.bits.storage         = true;
+        createInfo.memoryUsage                     = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                    = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        PPX_CHECKED_CALL(GetDevice()->CreateTexture(&createInfo, &mMultiLayer.depthTexture));
+        PPX_CHECKED_CALL(GetDevice()->CreateTexture(&createInfo, &mMultiLayer.colorTexture));
+    }
+
+    // Tail texture
+    {
+        grfx::TextureCreateInfo createInfo         = {};
+        createInfo.imageType                       = grfx::IMAGE_TYPE_2D;
+        createInfo.width                           = mTransparencyTexture->GetWidth();
+        createInfo.height                          = mTransparencyTexture->GetHeight();
+        createInfo.depth                           = 1;
+        createInfo.imageFormat                     = grfx::FORMAT_R16G16B16A16_FLOAT;
+        createInfo.sampleCount                     = grfx::SAMPLE_COUNT_1;
+        createInfo.mipLevelCount                   = 1;
+        createInfo.arrayLayerCount                 = 1;
+        createInfo.usageFlags.bits.colorAttachment = true;
+        createInfo.usageFlags.bits.sampled         = true;
+        createInfo.memoryUsage                     = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                    = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        PPX_CHECKED_CALL(GetDevice()->CreateTexture(&createInfo, &mMultiLayer.tailTexture));
+    }
+
+    // Clear passes
+    {
+        grfx::DrawPassCreateInfo2 createInfo  = {};
+        createInfo.width                      = mMultiLayer.countTexture->GetWidth();
+        createInfo.height                     = mMultiLayer.countTexture->GetHeight();
+        createInfo.renderTargetCount          = 1;
+        createInfo.pRenderTargetImages[0]     = mMultiLayer.countTexture->GetImage();
+        createInfo.pDepthStencilImage         = nullptr;
+        createInfo.renderTargetClearValues[0] = {0, 0, 0, 0};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mMultiLayer.countClearPass));
+    }
+    {
+        constexpr uint            emptyDepthUint  = MULTI_LAYER_EMPTY_DEPTH;
+        const float               emptyDepthFloat = *reinterpret_cast<const float*>(&emptyDepthUint);
+        grfx::DrawPassCreateInfo2 createInfo      = {};
+        createInfo.width                          = mMultiLayer.depthTexture->GetWidth();
+        createInfo.height                         = mMultiLayer.depthTexture->GetHeight();
+        createInfo.renderTargetCount              = 2;
+        createInfo.pRenderTargetImages[0]         = mMultiLayer.depthTexture->GetImage();
+        createInfo.pRenderTargetImages[1]         = mMultiLayer.colorTexture->GetImage();
+        createInfo.pDepthStencilImage             = nullptr;
+        createInfo.renderTargetClearValues[0]     = {emptyDepthFloat, 0, 0, 0};
+        createInfo.renderTargetClearValues[1]     = {0, 0, 0, 0};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mMultiLayer.layerClearPass));
+    }
+
+    // Depth pass
+    {
+        grfx::DrawPassCreateInfo2 createInfo = {};
+        createInfo.width                     = mMultiLayer.countTexture->GetWidth();
+        createInfo.height                    = mMultiLayer.countTexture->GetHeight();
+        createInfo.renderTargetCount         = 0;
+        createInfo.pDepthStencilImage        = nullptr;
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mMultiLayer.depthPass));
+    }
+
+    // Color pass
+    {
+        grfx::DrawPassCreateInfo2 createInfo  = {};
+        createInfo.width                      = mMultiLayer.tailTexture->GetWidth();
+        createInfo.height                     = mMultiLayer.tailTexture->GetHeight();
+        createInfo.renderTargetCount          = 1;
+        createInfo.pRenderTargetImages[0]     = mMultiLayer.tailTexture->GetImage();
+        createInfo.pDepthStencilImage         = nullptr;
+        createInfo.renderTargetClearValues[0] = {0, 0, 0, 0};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mMultiLayer.colorPass));
+    }
+
+    ////////////////////////////////////////
+    // Depth
+    ////////////////////////////////////////
+
+    // Descriptor
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{SHADER_GLOBALS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_TEXTURE_0_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_0_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_1_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mMultiLayer.depthDescriptorSetLayout));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mMultiLayer.depthDescriptorSetLayout, &mMultiLayer.depthDescriptorSet));
+
+        std::array<grfx::WriteDescriptor, 4> writes = {};
+
+        writes[0].binding      = SHADER_GLOBALS_REGISTER;
+        writes[0].type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset = 0;
+        writes[0].bufferRange  = PPX_WHOLE_SIZE;
+        writes[0].pBuffer      = mShaderGlobalsBuffer;
+
+        writes[1].binding    = CUSTOM_TEXTURE_0_REGISTER;
+        writes[1].arrayIndex = 0;
+        writes[1].type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[1].pImageView = mOpaquePass->GetDepthStencilTexture()->GetSampledImageView();
+
+        writes[2].binding    = CUSTOM_UAV_0_REGISTER;
+        writes[2].arrayIndex = 0;
+        writes[2].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[2].pImageView = mMultiLayer.countTexture->GetStorageImageView();
+
+        writes[3].binding    = CUSTOM_UAV_1_REGISTER;
+        writes[3].arrayIndex = 0;
+        writes[3].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[3].pImageView = mMultiLayer.depthTexture->GetStorageImageView();
+
+        PPX_CHECKED_CALL(mMultiLayer.depthDescriptorSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data()));
+    }
+
+    // Pipeline
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mMultiLayer.depthDescriptorSetLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mMultiLayer.depthPipelineInterface));
+
+        grfx::ShaderModulePtr VS, PS;
+        PPX_CHECKED_CALL(CreateShader("oit_demo/shaders", "MultiLayerDepth.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("oit_demo/shaders", "MultiLayerDepth.ps", &PS));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo = {};
+        gpCreateInfo.VS                                = {VS, "vsmain"};
+        gpCreateInfo.PS                                = {PS, "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount     = 1;
+        gpCreateInfo.vertexInputState.bindings[0]      = GetTransparentMesh()->GetDerivedVertexBindings()[0];
+        gpCreateInfo.topology                          = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                       = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                          = grfx::CULL_MODE_NONE;
+        gpCreateInfo.frontFace                         = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                   = false;
+        gpCreateInfo.depthWriteEnable                  = false;
+        gpCreateInfo.blendModes[0]                     = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount     = 0;
+        gpCreateInfo.pPipelineInterface                = mMultiLayer.depthPipelineInterface;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mMultiLayer.depthPipeline));
+
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+
+    ////////////////////////////////////////
+    // Color
+    ////////////////////////////////////////
+
+    // Descriptor
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{SHADER_GLOBALS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_TEXTURE_0_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_1_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_2_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mMultiLayer.colorDescriptorSetLayout));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mMultiLayer.colorDescriptorSetLayout, &mMultiLayer.colorDescriptorSet));
+
+        std::array<grfx::WriteDescriptor, 4> writes = {};
+
+        writes[0].binding      = SHADER_GLOBALS_REGISTER;
+        writes[0].type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset = 0;
+        writes[0].bufferRange  = PPX_WHOLE_SIZE;
+        writes[0].pBuffer      = mShaderGlobalsBuffer;
+
+        writes[1].binding    = CUSTOM_TEXTURE_0_REGISTER;
+        writes[1].arrayIndex = 0;
+        writes[1].type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[1].pImageView = mOpaquePass->GetDepthStencilTexture()->GetSampledImageView();
+
+        writes[2].binding    = CUSTOM_UAV_1_REGISTER;
+        writes[2].arrayIndex = 0;
+        writes[2].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[2].pImageView = mMultiLayer.depthTexture->GetStorageImageView();
+
+        writes[3].binding    = CUSTOM_UAV_2_REGISTER;
+        writes[3].arrayIndex = 0;
+        writes[3].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[3].pImageView = mMultiLayer.colorTexture->GetStorageImageView();
+
+        PPX_CHECKED_CALL(mMultiLayer.colorDescriptorSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data()));
+    }
+
+    // Pipeline
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mMultiLayer.colorDescriptorSetLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mMultiLayer.colorPipelineInterface));
+
+        grfx::ShaderModulePtr VS, PS;
+        PPX_CHECKED_CALL(CreateShader("oit_demo/shaders", "MultiLayerColor.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("oit_demo/shaders", "MultiLayerColor.ps", &PS));
+
+        grfx::GraphicsPipelineCreateInfo gpCreateInfo   = {};
+        gpCreateInfo.VS                                 = {VS, "vsmain"};
+        gpCreateInfo.PS                                 = {PS, "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount      = 1;
+        gpCreateInfo.vertexInputState.bindings[0]       = GetTransparentMesh()->GetDerivedVertexBindings()[0];
+        gpCreateInfo.inputAssemblyState.topology        = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.rasterState.polygonMode            = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.rasterState.cullMode               = grfx::CULL_MODE_NONE;
+        gpCreateInfo.rasterState.frontFace              = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.rasterState.rasterizationSamples   = grfx::SAMPLE_COUNT_1;
+        gpCreateInfo.depthStencilState.depthTestEnable  = false;
+        gpCreateInfo.depthStencilState.depthWriteEnable = false;
+
+        // The tail accumulates the premultiplied color and the alpha of the fragments behind the layers
+        gpCreateInfo.colorBlendState.blendAttachmentCount                    = 1;
+        gpCreateInfo.colorBlendState.blendAttachments[0].blendEnable         = true;
+        gpCreateInfo.colorBlendState.blendAttachments[0].srcColorBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].dstColorBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].colorBlendOp        = grfx::BLEND_OP_ADD;
+        gpCreateInfo.colorBlendState.blendAttachments[0].srcAlphaBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].dstAlphaBlendFactor = grfx::BLEND_FACTOR_ONE;
+        gpCreateInfo.colorBlendState.blendAttachments[0].alphaBlendOp        = grfx::BLEND_OP_ADD;
+        gpCreateInfo.colorBlendState.blendAttachments[0].colorWriteMask      = grfx::ColorComponentFlags::RGBA();
+
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = mMultiLayer.tailTexture->GetImageFormat();
+        gpCreateInfo.pPipelineInterface                 = mMultiLayer.colorPipelineInterface;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mMultiLayer.colorPipeline));
+
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+
+    ////////////////////////////////////////
+    // Combine
+    ////////////////////////////////////////
+
+    // Descriptor
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{SHADER_GLOBALS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_TEXTURE_0_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_0_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_1_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{CUSTOM_UAV_2_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mMultiLayer.combineDescriptorSetLayout));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mMultiLayer.combineDescriptorSetLayout, &mMultiLayer.combineDescriptorSet));
+
+        std::array<grfx::WriteDescriptor, 5> writes = {};
+
+        writes[0].binding      = SHADER_GLOBALS_REGISTER;
+        writes[0].type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset = 0;
+        writes[0].bufferRange  = PPX_WHOLE_SIZE;
+        writes[0].pBuffer      = mShaderGlobalsBuffer;
+
+        writes[1].binding    = CUSTOM_TEXTURE_0_REGISTER;
+        writes[1].arrayIndex = 0;
+        writes[1].type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[1].pImageView = mMultiLayer.tailTexture->GetSampledImageView();
+
+        writes[2].binding    = CUSTOM_UAV_0_REGISTER;
+        writes[2].arrayIndex = 0;
+        writes[2].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[2].pImageView = mMultiLayer.countTexture->GetStorageImageView();
+
+        writes[3].binding    = CUSTOM_UAV_1_REGISTER;
+        writes[3].arrayIndex = 0;
+        writes[3].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[3].pImageView = mMultiLayer.depthTexture->GetStorageImageView();
+
+        writes[4].binding    = CUSTOM_UAV_2_REGISTER;
+        writes[4].arrayIndex = 0;
+        writes[4].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[4].pImageView = mMultiLayer.colorTexture->GetStorageImageView();
+
+        PPX_CHECKED_CALL(mMultiLayer.combineDescriptorSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data()));
+    }
+
+    // Pipeline
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mMultiLayer.combineDescriptorSetLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mMultiLayer.combinePipelineInterface));
+
+        grfx::ShaderModulePtr VS, PS;
+        PPX_CHECKED_CALL(CreateShader("oit_demo/shaders", "MultiLayerCombine.vs", &VS));
+        PPX_CHECKED_CALL(CreateShader("oit_demo/shaders", "MultiLayerCombine.ps", &PS));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {VS, "vsmain"};
+        gpCreateInfo.PS                                 = {PS, "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount      = 0;
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_BACK;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = false;
+        gpCreateInfo.depthWriteEnable                   = false;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = mTransparencyPass->GetRenderTargetTexture(0)->GetImageFormat();
+        gpCreateInfo.outputState.depthStencilFormat     = mTransparencyPass->GetDepthStencilTexture()->GetImageFormat();
+        gpCreateInfo.pPipelineInterface                 = mMultiLayer.combinePipelineInterface;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mMultiLayer.combinePipeline));
+
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+}
+
+void OITDemoApp::RecordMultiLayer()
+{
+    // The combine pass resets the textures for the next frame, they only need to be cleared once
+    if (mMultiLayer.texturesNeedClear) {
+        grfx::DrawPassPtr clearPasses[] = {mMultiLayer.countClearPass, mMultiLayer.layerClearPass};
+        for (grfx::DrawPassPtr clearPass : clearPasses) {
+            mCommandBuffer->TransitionImageLayout(
+                clearPass,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE,
+                grfx::RESOURCE_STATE_RENDER_TARGET,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE);
+            mCommandBuffer->BeginRenderPass(clearPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_ALL);
+
+            mCommandBuffer->SetScissors(clearPass->GetScissor());
+            mCommandBuffer->SetViewports(clearPass->GetViewport());
+
+            mCommandBuffer->EndRenderPass();
+            mCommandBuffer->TransitionImageLayout(
+                clearPass,
+                grfx::RESOURCE_STATE_RENDER_TARGET,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        }
+
+        mMultiLayer.texturesNeedClear = false;
+    }
+
+    // Depth pass: keep the nearest fragment depths of each pixel, sorted
+    {
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.countTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.depthTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->BeginRenderPass(mMultiLayer.depthPass, 0);
+
+        mCommandBuffer->SetScissors(mMultiLayer.depthPass->GetScissor());
+        mCommandBuffer->SetViewports(mMultiLayer.depthPass->GetViewport());
+
+        mCommandBuffer->BindGraphicsDescriptorSets(mMultiLayer.depthPipelineInterface, 1, &mMultiLayer.depthDescriptorSet);
+        mCommandBuffer->BindGraphicsPipeline(mMultiLayer.depthPipeline);
+        mCommandBuffer->BindIndexBuffer(GetTransparentMesh());
+        mCommandBuffer->BindVertexBuffers(GetTransparentMesh());
+        mCommandBuffer->DrawIndexed(GetTransparentMesh()->GetIndexCount());
+
+        mCommandBuffer->EndRenderPass();
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.countTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.depthTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    }
+
+    // Color pass: store the colors of the layers, accumulate the others in the tail
+    {
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.depthTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.colorTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.tailTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_RENDER_TARGET);
+        mCommandBuffer->BeginRenderPass(mMultiLayer.colorPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS);
+
+        mCommandBuffer->SetScissors(mMultiLayer.colorPass->GetScissor());
+        mCommandBuffer->SetViewports(mMultiLayer.colorPass->GetViewport());
+
+        mCommandBuffer->BindGraphicsDescriptorSets(mMultiLayer.colorPipelineInterface, 1, &mMultiLayer.colorDescriptorSet);
+        mCommandBuffer->BindGraphicsPipeline(mMultiLayer.colorPipeline);
+        mCommandBuffer->BindIndexBuffer(GetTransparentMesh());
+        mCommandBuffer->BindVertexBuffers(GetTransparentMesh());
+        mCommandBuffer->DrawIndexed(GetTransparentMesh()->GetIndexCount());
+
+        mCommandBuffer->EndRenderPass();
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.tailTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.depthTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.colorTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    }
+
+    // Transparency pass: merge the tail then the layers, back to front
+    {
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.countTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.depthTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.colorTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_GENERAL);
+        mCommandBuffer->TransitionImageLayout(
+            mTransparencyPass,
+            grfx::RESOURCE_STATE_SHADER_RESOURCE,
+            grfx::RESOURCE_STATE_RENDER_TARGET,
+            grfx::RESOURCE_STATE_SHADER_RESOURCE,
+            grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+        mCommandBuffer->BeginRenderPass(mTransparencyPass, grfx::DRAW_PASS_CLEAR_FLAG_CLEAR_RENDER_TARGETS);
+
+        mCommandBuffer->SetScissors(mTransparencyPass->GetScissor());
+        mCommandBuffer->SetViewports(mTransparencyPass->GetViewport());
+
+        mCommandBuffer->BindGraphicsDescriptorSets(mMultiLayer.combinePipelineInterface, 1, &mMultiLayer.combineDescriptorSet);
+        mCommandBuffer->BindGraphicsPipeline(mMultiLayer.combinePipeline);
+        mCommandBuffer->Draw(3);
+
+        mCommandBuffer->EndRenderPass();
+        mCommandBuffer->TransitionImageLayout(
+            mTransparencyPass,
+            grfx::RESOURCE_STATE_RENDER_TARGET,
+            grfx::RESOURCE_STATE_SHADER_RESOURCE,
+            grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE,
+            grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.countTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.depthTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        mCommandBuffer->TransitionImageLayout(mMultiLayer.colorTexture, 0, 1, 0, 1, grfx::RESOURCE_STATE_GENERAL, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    }
+}
@@ -35,6 +35,7 @@ void OITDemoApp::Config(ppx::ApplicationSettings& settings)
     settings.enableImGui           = true;
 
     settings.grfx.swapchain.colorFormat = grfx::FORMAT_B8G8R8A8_UNORM;
+    settings.grfx.gpuProfiler.enable    = true;
 
 #if defined(USE_DX12)
     settings.grfx.api = grfx::API_DX_12_0;
@@ -78,7 +79,8 @@ void OITDemoApp::SetupCommon()
         grfx::DescriptorPoolCreateInfo createInfo = {};
         createInfo.sampler                        = 16;
         createInfo.sampledImage                   = 16;
-        createInfo.uniformBuffer                  = 16;
+        createInfo.storageImage                   = 16;
+        createInfo.uniformBuffer                  = 32;
         createInfo.structuredBuffer               = 16;
         createInfo.storageTexelBuffer             = 16;
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&createInfo, &mDescriptorPool));
@@ -299,6 +301,57 @@ grfx::MeshPtr OITDemoApp::GetTransparentMesh() const
     return mTransparentMeshes[mGuiParameters.mesh.type];
 }
 
+static uint64_t GetTextureMemorySize(const grfx::TexturePtr& texture)
+{
+    const uint64_t texelCount = static_cast<uint64_t>(texture->GetWidth()) * texture->GetHeight() * texture->GetDepth() * texture->GetArrayLayerCount();
+    return texelCount * grfx::GetFormatDescription(texture->GetImageFormat())->bytesPerTexel;
+}
+
+uint64_t OITDemoApp::GetTransparencyMemorySize() const
+{
+    // Memory used by the selected algorithm on top of the transparency pass
+    uint64_t size = 0;
+    switch (GetSelectedAlgorithm()) {
+        case ALGORITHM_WEIGHTED_AVERAGE: {
+            size += GetTextureMemorySize(mWeightedAverage.colorTexture);
+            size += GetTextureMemorySize(mWeightedAverage.extraTexture);
+            break;
+        }
+        case ALGORITHM_DEPTH_PEELING: {
+            for (const grfx::TexturePtr& texture : mDepthPeeling.layerTextures) {
+                size += GetTextureMemorySize(texture);
+            }
+            for (const grfx::TexturePtr& texture : mDepthPeeling.depthTextures) {
+                size += GetTextureMemorySize(texture);
+            }
+            break;
+        }
+        case ALGORITHM_BUFFER: {
+            if (mGuiParameters.buffer.type == BUFFER_ALGORITHM_BUCKETS) {
+                size += GetTextureMemorySize(mBuffer.buckets.countTexture);
+                size += GetTextureMemorySize(mBuffer.buckets.fragmentTexture);
+            }
+            else {
+                size += GetTextureMemorySize(mBuffer.lists.linkedListHeadTexture);
+                size += mBuffer.lists.fragmentBuffer->GetSize();
+                size += mBuffer.lists.atomicCounter->GetSize();
+            }
+            break;
+        }
+        case ALGORITHM_MULTI_LAYER: {
+            size += GetTextureMemorySize(mMultiLayer.countTexture);
+            size += GetTextureMemorySize(mMultiLayer.depthTexture);
+            size += GetTextureMemorySize(mMultiLayer.colorTexture);
+            size += GetTextureMemorySize(mMultiLayer.tailTexture);
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+    return size;
+}
+
 void OITDemoApp::FillSupportedAlgorithmData()
 {
     const auto addSupportedAlgorithm = [this](const char* name, Algorithm algorithm) {
@@ -315,6 +368,7 @@ void OITDemoApp::FillSupportedAlgorithmData()
     addSupportedAlgorithm("Depth peeling", ALGORITHM_DEPTH_PEELING);
     if (GetDevice()->FragmentStoresAndAtomicsSupported()) {
         addSupportedAlgorithm("Buffer", ALGORITHM_BUFFER);
+        addSupportedAlgorithm("Multi-layer", ALGORITHM_MULTI_LAYER);
     }
 }
 
@@ -351,6 +405,8 @@ void OITDemoApp::ParseCommandLineOptions()
     mGuiParameters.buffer.bucketsFragmentsMaxCount    = std::clamp(cliOptions.GetExtraOptionValueOrDefault("bu_buckets_fragments_max_count", BUFFER_BUCKETS_SIZE_PER_PIXEL), 1, BUFFER_BUCKETS_SIZE_PER_PIXEL);
     mGuiParameters.buffer.listsFragmentBufferScale    = std::clamp(cliOptions.GetExtraOptionValueOrDefault("bu_lists_fragment_buffer_scale", BUFFER_LISTS_FRAGMENT_BUFFER_MAX_SCALE), 1, BUFFER_LISTS_FRAGMENT_BUFFER_MAX_SCALE);
     mGuiParameters.buffer.listsSortedFragmentMaxCount = std::clamp(cliOptions.GetExtraOptionValueOrDefault("bu_lists_sorted_fragment_max_count", BUFFER_LISTS_SORTED_FRAGMENT_MAX_COUNT), 1, BUFFER_LISTS_SORTED_FRAGMENT_MAX_COUNT);
+
+    mGuiParameters.multiLayer.layersCount = std::clamp(cliOptions.GetExtraOptionValueOrDefault("ml_layers_count", MULTI_LAYER_MAX_LAYERS_COUNT), 1, MULTI_LAYER_MAX_LAYERS_COUNT);
 }
 
 void OITDemoApp::Setup()
@@ -366,6 +422,7 @@ void OITDemoApp::Setup()
             &OITDemoApp::SetupWeightedAverage,
             &OITDemoApp::SetupDepthPeeling,
             &OITDemoApp::SetupBuffer,
+            &OITDemoApp::SetupMultiLayer,
         };
     static_assert(sizeof(setupFuncs) / sizeof(setupFuncs[0]) == ALGORITHMS_COUNT, "Algorithm setup func count mismatch");
 
@@ -417,6 +474,8 @@ void OITDemoApp::Update()
         shaderGlobals.bufferListsFragmentBufferScale    = std::min(BUFFER_LISTS_FRAGMENT_BUFFER_MAX_SCALE, mGuiParameters.buffer.listsFragmentBufferScale);
         shaderGlobals.bufferListsSortedFragmentMaxCount = std::min(BUFFER_LISTS_SORTED_FRAGMENT_MAX_COUNT, mGuiParameters.buffer.listsSortedFragmentMaxCount);
 
+        shaderGlobals.multiLayerLayersCount = std::min(MULTI_LAYER_MAX_LAYERS_COUNT, mGuiParameters.multiLayer.layersCount);
+
         mShaderGlobalsBuffer->CopyFromSource(sizeof(shaderGlobals), &shaderGlobals);
     }
 
@@ -432,6 +491,10 @@ void OITDemoApp::UpdateGUI()
     // GUI
     if (ImGui::Begin("Parameters")) {
         ImGui::Combo("Algorithm", &mGuiParameters.algorithmDataIndex, mSupportedAlgorithmNames.data(), static_cast<int>(mSupportedAlgorithmNames.size()));
+        ImGui::Text("OIT memory: %.2f MiB", static_cast<float>(GetTransparencyMemorySize()) / (1024.0f * 1024.0f));
+        for (const auto& scope : GetGpuProfiler()->GetScopes()) {
+            ImGui::Text("GPU %s: %.3f ms", scope.name.c_str(), scope.gpuMs);
+        }
 
         ImGui::Separator();
         ImGui::Text("Model");
@@ -514,6 +577,11 @@ void OITDemoApp::UpdateGUI()
                 }
                 break;
             }
+            case ALGORITHM_MULTI_LAYER: {
+                ImGui::Text("%s", mSupportedAlgorithmNames[mGuiParameters.algorithmDataIndex]);
+                ImGui::SliderInt("ML layers count", &mGuiParameters.multiLayer.layersCount, 1, MULTI_LAYER_MAX_LAYERS_COUNT);
+                break;
+            }
             default: {
                 break;
             }
@@ -524,6 +592,8 @@ void OITDemoApp::UpdateGUI()
 
 void OITDemoApp::RecordOpaque()
 {
+    grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), mCommandBuffer, "Opaque");
+
     mCommandBuffer->TransitionImageLayout(
         mOpaquePass,
         grfx::RESOURCE_STATE_SHADER_RESOURCE,
@@ -561,11 +631,15 @@ void OITDemoApp::RecordTransparency()
             &OITDemoApp::RecordWeightedAverage,
             &OITDemoApp::RecordDepthPeeling,
             &OITDemoApp::RecordBuffer,
+            &OITDemoApp::RecordMultiLayer,
         };
     static_assert(sizeof(recordFuncs) / sizeof(recordFuncs[0]) == ALGORITHMS_COUNT, "Algorithm record func count mismatch");
 
     const Algorithm algorithm = GetSelectedAlgorithm();
     PPX_ASSERT_MSG(algorithm >= 0 && algorithm < ALGORITHMS_COUNT, "unknown algorithm");
+
+    // Each algorithm gets its own scope, so the GPU time of each one is reported as a separate metric
+    grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), mCommandBuffer, mSupportedAlgorithmNames[mGuiParameters.algorithmDataIndex]);
     (this->*recordFuncs[algorithm])();
 }
 
@@ -601,6 +675,7 @@ void OITDemoApp::RecordComposite(grfx::RenderPassPtr renderPass)
 void OITDemoApp::Render()
 {
     PPX_CHECKED_CALL(mRenderCompleteFence->WaitAndReset());
+    GetGpuProfiler()->BeginFrame(0);
     uint32_t imageIndex = UINT32_MAX;
     PPX_CHECKED_CALL(GetSwapchain()->AcquireNextImage(UINT64_MAX, mImageAcquiredSemaphore, mImageAcquiredFence, &imageIndex));
     PPX_CHECKED_CALL(mImageAcquiredFence->WaitAndReset());
@@ -612,6 +687,7 @@ void OITDemoApp::Render()
     PPX_CHECKED_CALL(mCommandBuffer->Begin());
     RecordOpaque();
     RecordTransparency();
+    GetGpuProfiler()->EndFrame(mCommandBuffer);
     RecordComposite(GetSwapchain()->GetRenderPass(imageIndex));
     PPX_CHECKED_CALL(mCommandBuffer->End());
 
@@ -627,3 +703,28 @@ void OITDemoApp::Render()
     PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
     PPX_CHECKED_CALL(GetSwapchain()->Present(imageIndex, 1, &mRenderCompleteSemaphore));
 }
+
+void OITDemoApp::SetupMetrics()
+{
+    Application::SetupMetrics();
+
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricMetadata metadata = {ppx::metrics::MetricType::GAUGE, "OIT Memory", "bytes", ppx::metrics::MetricInterpretation::LOWER_IS_BETTER, {0.f, 1e10f}};
+    mTransparencyMemoryMetric             = AddMetric(metadata);
+    PPX_ASSERT_MSG(mTransparencyMemoryMetric != ppx::metrics::kInvalidMetricID, "Failed to add OIT Memory metric");
+}
+
+void OITDemoApp::UpdateMetrics()
+{
+    if (!HasActiveMetricsRun()) {
+        return;
+    }
+
+    ppx::metrics::MetricData data = {ppx::metrics::MetricType::GAUGE};
+    data.gauge.seconds            = GetElapsedSeconds();
+    data.gauge.value              = static_cast<double>(GetTransparencyMemorySize());
+    RecordMetricData(mTransparencyMemoryMetric, data);
+}
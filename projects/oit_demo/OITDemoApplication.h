@@ -26,6 +26,10 @@ public:
     virtual void Setup() override;
     virtual void Render() override;
 
+protected:
+    virtual void SetupMetrics() override;
+    virtual void UpdateMetrics() override;
+
 private:
     enum Algorithm : int32_t
     {
@@ -34,6 +38,7 @@ private:
         ALGORITHM_WEIGHTED_AVERAGE,
         ALGORITHM_DEPTH_PEELING,
         ALGORITHM_BUFFER,
+        ALGORITHM_MULTI_LAYER,
         ALGORITHMS_COUNT,
     };
 
@@ -110,6 +115,11 @@ private:
             int32_t             listsFragmentBufferScale;
             int32_t             listsSortedFragmentMaxCount;
         } buffer;
+
+        struct
+        {
+            int32_t layersCount;
+        } multiLayer;
     };
 
     std::vector<const char*> mSupportedAlgorithmNames;
@@ -124,12 +134,14 @@ private:
     void SetupBuffer();
     void SetupBufferBuckets();
     void SetupBufferLinkedLists();
+    void SetupMultiLayer();
 
     void FillSupportedAlgorithmData();
     void ParseCommandLineOptions();
 
     Algorithm     GetSelectedAlgorithm() const;
     grfx::MeshPtr GetTransparentMesh() const;
+    uint64_t      GetTransparencyMemorySize() const;
 
     void Update();
     void UpdateGUI();
@@ -145,6 +157,7 @@ private:
     void RecordBuffer();
     void RecordBufferBuckets();
     void RecordBufferLinkedLists();
+    void RecordMultiLayer();
 
 private:
     GuiParameters mGuiParameters = {};
@@ -181,6 +194,8 @@ private:
     grfx::PipelineInterfacePtr   mCompositePipelineInterface;
     grfx::GraphicsPipelinePtr    mCompositePipeline;
 
+    metrics::MetricID mTransparencyMemoryMetric = metrics::kInvalidMetricID;
+
     struct
     {
         grfx::DescriptorSetLayoutPtr descriptorSetLayout;
@@ -292,4 +307,33 @@ private:
             bool linkedListHeadTextureNeedClear;
         } lists;
     } mBuffer;
+
+    struct
+    {
+        grfx::TexturePtr  countTexture;
+        grfx::TexturePtr  depthTexture;
+        grfx::TexturePtr  colorTexture;
+        grfx::TexturePtr  tailTexture;
+        grfx::DrawPassPtr countClearPass;
+        grfx::DrawPassPtr layerClearPass;
+        grfx::DrawPassPtr depthPass;
+        grfx::DrawPassPtr colorPass;
+
+        grfx::DescriptorSetLayoutPtr depthDescriptorSetLayout;
+        grfx::DescriptorSetPtr       depthDescriptorSet;
+        grfx::PipelineInterfacePtr   depthPipelineInterface;
+        grfx::GraphicsPipelinePtr    depthPipeline;
+
+        grfx::DescriptorSetLayoutPtr colorDescriptorSetLayout;
+        grfx::DescriptorSetPtr       colorDescriptorSet;
+        grfx::PipelineInterfacePtr   colorPipelineInterface;
+        grfx::GraphicsPipelinePtr    colorPipeline;
+
+        grfx::DescriptorSetLayoutPtr combineDescriptorSetLayout;
+        grfx::DescriptorSetPtr       combineDescriptorSet;
+        grfx::PipelineInterfacePtr   combinePipelineInterface;
+        grfx::GraphicsPipelinePtr    combinePipeline;
+
+        bool texturesNeedClear;
+    } mMultiLayer;
 };
@@ -38,6 +38,33 @@ int main(int argc, char** argv)
     ppx::Log::Initialize(LOG_MODE_CONSOLE);
     PPX_LOG_INFO("Graphics instance and devices created successfully.");
 
+    for (uint32_t i = 0; i < instance->GetGpuCount(); ++i) {
+        grfx::GpuPtr gpu;
+        ppxres = instance->GetGpu(i, &gpu);
+        if (ppxres != ppx::SUCCESS) {
+            continue;
+        }
+
+        const grfx::ShaderCapabilities&   caps     = gpu->GetShaderCapabilities();
+        const grfx::SubgroupCapabilities& subgroup = caps.subgroup;
+        PPX_LOG_INFO("GPU " << i << ": " << gpu->GetDeviceName());
+        PPX_LOG_INFO("   subgroup size      : " << subgroup.size << " (" << subgroup.minSize << " to " << subgroup.maxSize << ")");
+        PPX_LOG_INFO("   subgroup all stages: " << subgroup.allStages);
+        PPX_LOG_INFO("   subgroup operations:"
+                     << (subgroup.basic ? " basic" : "")
+                     << (subgroup.vote ? " vote" : "")
+                     << (subgroup.arithmetic ? " arithmetic" : "")
+                     << (subgroup.ballot ? " ballot" : "")
+                     << (subgroup.shuffle ? " shuffle" : "")
+                     << (subgroup.shuffleRelative ? " shuffle_relative" : "")
+                     << (subgroup.clustered ? " clustered" : "")
+                     << (subgroup.quad ? " quad" : ""));
+        PPX_LOG_INFO("   float16            : " << caps.float16);
+        PPX_LOG_INFO("   int16              : " << caps.int16);
+        PPX_LOG_INFO("   int8               : " << caps.int8);
+        PPX_LOG_INFO("   cooperative matrix : " << caps.cooperativeMatrix);
+    }
+
     grfx::DestroyInstance(instance);
 
     return 0;
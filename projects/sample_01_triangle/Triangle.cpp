@@ -24,10 +24,11 @@ const grfx::Api kApi = grfx::API_VK_1_1;
 
 void TriangleApp::Config(ApplicationSettings& settings)
 {
-    settings.appName          = "sample_01_triangle";
-    settings.enableImGui      = true;
-    settings.grfx.api         = kApi;
-    settings.window.resizable = true;
+    settings.appName                = "sample_01_triangle";
+    settings.enableImGui            = true;
+    settings.grfx.api               = kApi;
+    settings.grfx.numFramesInFlight = 2;
+    settings.window.resizable       = true;
 }
 
 void TriangleApp::Setup()
@@ -68,23 +69,17 @@ void TriangleApp::Setup()
         PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mPipeline));
     }
 
-    // Per frame data
-    {
+    // Per frame data, the application's frame timeline keeps these from
+    // being reused before the GPU is done with them
+    for (uint32_t i = 0; i < GetNumFramesInFlight(); ++i) {
         PerFrame frame = {};
 
         PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&frame.cmd));
 
         grfx::SemaphoreCreateInfo semaCreateInfo = {};
         PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.imageAcquiredSemaphore));
-
-        grfx::FenceCreateInfo fenceCreateInfo = {};
-        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.imageAcquiredFence));
-
         PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.renderCompleteSemaphore));
 
-        fenceCreateInfo = {true}; // Create signaled
-        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.renderCompleteFence));
-
         mPerFrame.push_back(frame);
     }
 
@@ -117,18 +112,13 @@ void TriangleApp::Setup()
 
 void TriangleApp::Render()
 {
-    PerFrame& frame = mPerFrame[0];
+    PerFrame& frame = mPerFrame[GetInFlightFrameIndex()];
 
     grfx::SwapchainPtr swapchain = GetSwapchain();
 
-    // Wait for and reset render complete fence
-    PPX_CHECKED_CALL(frame.renderCompleteFence->WaitAndReset());
-
+    // The submission waits on the acquire semaphore, no fence needed
     uint32_t imageIndex = UINT32_MAX;
-    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, frame.imageAcquiredFence, &imageIndex));
-
-    // Wait for and reset image acquired fence
-    PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
+    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, nullptr, &imageIndex));
 
     // Build command buffer
     PPX_CHECKED_CALL(frame.cmd->Begin());
@@ -171,9 +161,9 @@ void TriangleApp::Render()
     submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
-    submitInfo.pFence               = frame.renderCompleteFence;
 
-    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    // Also signals this frame's value on the graphics queue's frame timeline
+    PPX_CHECKED_CALL(SubmitFrame(GetGraphicsQueue(), &submitInfo));
 
     PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
 }
@@ -14,6 +14,7 @@
 
 #include "ppx/ppx.h"
 #include "ppx/graphics_util.h"
+#include "ppx/prerecorded_commands.h"
 using namespace ppx;
 
 #if defined(USE_DX12)
@@ -28,6 +29,8 @@ class ProjApp
 public:
     virtual void Config(ppx::ApplicationSettings& settings) override;
     virtual void Setup() override;
+    virtual void Shutdown() override;
+    virtual void Resize(uint32_t width, uint32_t height) override;
     virtual void Render() override;
 
 private:
@@ -48,6 +51,7 @@ private:
     };
 
     std::vector<PerFrame>        mPerFrame;
+    PrerecordedCommands          mSceneCommands; // One per swapchain image
     grfx::ShaderModulePtr        mVS;
     grfx::ShaderModulePtr        mPS;
     grfx::PipelineInterfacePtr   mPipelineInterface;
@@ -67,7 +71,8 @@ private:
     Entity                       mPositionPlanar;
 
 private:
-    void SetupEntity(const TriMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity);
+    void   SetupEntity(const TriMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity);
+    Result RecordScene(grfx::CommandBuffer* pCmd, uint32_t imageIndex);
 };
 
 void ProjApp::Config(ppx::ApplicationSettings& settings)
@@ -216,6 +221,118 @@ void ProjApp::Setup()
 
         mPerFrame.push_back(frame);
     }
+
+    // The scene is static apart from the uniform buffers, so it's recorded
+    // once per swapchain image and resubmitted every frame.
+    {
+        PrerecordedCommandsCreateInfo createInfo = {};
+        createInfo.pQueue                        = GetGraphicsQueue();
+        createInfo.count                         = GetSwapchain()->GetImageCount();
+        PPX_CHECKED_CALL(mSceneCommands.Initialize(createInfo));
+    }
+}
+
+void ProjApp::Shutdown()
+{
+    mSceneCommands.Shutdown();
+}
+
+void ProjApp::Resize(uint32_t width, uint32_t height)
+{
+    // The swapchain render passes, viewport and scissor have changed
+    mSceneCommands.Invalidate();
+}
+
+Result ProjApp::RecordScene(grfx::CommandBuffer* pCmd, uint32_t imageIndex)
+{
+    Result ppxres = pCmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::RenderPassPtr renderPass = GetSwapchain()->GetRenderPass(imageIndex);
+    PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
+
+    grfx::RenderPassBeginInfo beginInfo = {};
+    beginInfo.pRenderPass               = renderPass;
+    beginInfo.renderArea                = renderPass->GetRenderArea();
+    beginInfo.RTVClearCount             = 1;
+    beginInfo.RTVClearValues[0]         = {{0, 0, 0, 0}};
+    beginInfo.DSVClearValue             = {1.0f, 0xFF};
+
+    pCmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+    pCmd->BeginRenderPass(&beginInfo);
+    {
+        pCmd->SetScissors(GetScissor());
+        pCmd->SetViewports(GetViewport());
+
+        // Interleaved pipeline
+        pCmd->BindGraphicsPipeline(mInterleavedPipeline);
+
+        // Interleaved U16
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mInterleavedU16.descriptorSet);
+        pCmd->BindIndexBuffer(mInterleavedU16.mesh);
+        pCmd->BindVertexBuffers(mInterleavedU16.mesh);
+        pCmd->DrawIndexed(mInterleavedU16.mesh->GetIndexCount());
+
+        // Interleaved U32
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mInterleavedU32.descriptorSet);
+        pCmd->BindIndexBuffer(mInterleavedU32.mesh);
+        pCmd->BindVertexBuffers(mInterleavedU32.mesh);
+        pCmd->DrawIndexed(mInterleavedU32.mesh->GetIndexCount());
+
+        // Interleaved
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mInterleaved.descriptorSet);
+        pCmd->BindVertexBuffers(mInterleaved.mesh);
+        pCmd->Draw(mInterleaved.mesh->GetVertexCount());
+
+        // -------------------------------------------------------------------------------------
+
+        // Planar pipeline
+        pCmd->BindGraphicsPipeline(mPlanarPipeline);
+
+        // Planar U16
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPlanarU16.descriptorSet);
+        pCmd->BindIndexBuffer(mPlanarU16.mesh);
+        pCmd->BindVertexBuffers(mPlanarU16.mesh);
+        pCmd->DrawIndexed(mPlanarU16.mesh->GetIndexCount());
+
+        // Planar U32
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPlanarU32.descriptorSet);
+        pCmd->BindIndexBuffer(mPlanarU32.mesh);
+        pCmd->BindVertexBuffers(mPlanarU32.mesh);
+        pCmd->DrawIndexed(mPlanarU32.mesh->GetIndexCount());
+
+        // Planar
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPlanar.descriptorSet);
+        pCmd->BindVertexBuffers(mPlanar.mesh);
+        pCmd->Draw(mPlanar.mesh->GetVertexCount());
+
+        // -------------------------------------------------------------------------------------
+
+        // Position Planar pipeline
+        pCmd->BindGraphicsPipeline(mPositionPlanarPipeline);
+
+        // Position Planar U16
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPositionPlanarU16.descriptorSet);
+        pCmd->BindIndexBuffer(mPositionPlanarU16.mesh);
+        pCmd->BindVertexBuffers(mPositionPlanarU16.mesh);
+        pCmd->DrawIndexed(mPositionPlanarU16.mesh->GetIndexCount());
+
+        // Position Planar U32
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPositionPlanarU32.descriptorSet);
+        pCmd->BindIndexBuffer(mPositionPlanarU32.mesh);
+        pCmd->BindVertexBuffers(mPositionPlanarU32.mesh);
+        pCmd->DrawIndexed(mPositionPlanarU32.mesh->GetIndexCount());
+
+        // Position Planar
+        pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPositionPlanar.descriptorSet);
+        pCmd->BindVertexBuffers(mPositionPlanar.mesh);
+        pCmd->Draw(mPositionPlanar.mesh->GetVertexCount());
+    }
+    pCmd->EndRenderPass();
+
+    return pCmd->End();
 }
 
 void ProjApp::Render()
@@ -280,89 +397,24 @@ void ProjApp::Render()
         mPositionPlanar.uniformBuffer->CopyFromSource(sizeof(mat), &mat);
     }
 
-    // Build command buffer
+    grfx::CommandBuffer* pSceneCmd = nullptr;
+    PPX_CHECKED_CALL(mSceneCommands.Get(
+        imageIndex,
+        [this](grfx::CommandBuffer* pCmd, uint32_t index) { return RecordScene(pCmd, index); },
+        &pSceneCmd));
+
+    // Build command buffer for the UI, drawn over the scene
     PPX_CHECKED_CALL(frame.cmd->Begin());
     {
-        grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
+        grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex, grfx::ATTACHMENT_LOAD_OP_LOAD);
         PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
 
         grfx::RenderPassBeginInfo beginInfo = {};
         beginInfo.pRenderPass               = renderPass;
         beginInfo.renderArea                = renderPass->GetRenderArea();
-        beginInfo.RTVClearCount             = 1;
-        beginInfo.RTVClearValues[0]         = {{0, 0, 0, 0}};
-        beginInfo.DSVClearValue             = {1.0f, 0xFF};
 
-        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
         frame.cmd->BeginRenderPass(&beginInfo);
         {
-            frame.cmd->SetScissors(GetScissor());
-            frame.cmd->SetViewports(GetViewport());
-
-            // Interleaved pipeline
-            frame.cmd->BindGraphicsPipeline(mInterleavedPipeline);
-
-            // Interleaved U16
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mInterleavedU16.descriptorSet);
-            frame.cmd->BindIndexBuffer(mInterleavedU16.mesh);
-            frame.cmd->BindVertexBuffers(mInterleavedU16.mesh);
-            frame.cmd->DrawIndexed(mInterleavedU16.mesh->GetIndexCount());
-
-            // Interleaved U32
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mInterleavedU32.descriptorSet);
-            frame.cmd->BindIndexBuffer(mInterleavedU32.mesh);
-            frame.cmd->BindVertexBuffers(mInterleavedU32.mesh);
-            frame.cmd->DrawIndexed(mInterleavedU32.mesh->GetIndexCount());
-
-            // Interleaved
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mInterleaved.descriptorSet);
-            frame.cmd->BindVertexBuffers(mInterleaved.mesh);
-            frame.cmd->Draw(mInterleaved.mesh->GetVertexCount());
-
-            // -------------------------------------------------------------------------------------
-
-            // Planar pipeline
-            frame.cmd->BindGraphicsPipeline(mPlanarPipeline);
-
-            // Planar U16
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPlanarU16.descriptorSet);
-            frame.cmd->BindIndexBuffer(mPlanarU16.mesh);
-            frame.cmd->BindVertexBuffers(mPlanarU16.mesh);
-            frame.cmd->DrawIndexed(mPlanarU16.mesh->GetIndexCount());
-
-            // Planar U32
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPlanarU32.descriptorSet);
-            frame.cmd->BindIndexBuffer(mPlanarU32.mesh);
-            frame.cmd->BindVertexBuffers(mPlanarU32.mesh);
-            frame.cmd->DrawIndexed(mPlanarU32.mesh->GetIndexCount());
-
-            // Planar
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPlanar.descriptorSet);
-            frame.cmd->BindVertexBuffers(mPlanar.mesh);
-            frame.cmd->Draw(mPlanar.mesh->GetVertexCount());
-
-            // -------------------------------------------------------------------------------------
-
-            // Position Planar pipeline
-            frame.cmd->BindGraphicsPipeline(mPositionPlanarPipeline);
-
-            // Position Planar U16
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPositionPlanarU16.descriptorSet);
-            frame.cmd->BindIndexBuffer(mPositionPlanarU16.mesh);
-            frame.cmd->BindVertexBuffers(mPositionPlanarU16.mesh);
-            frame.cmd->DrawIndexed(mPositionPlanarU16.mesh->GetIndexCount());
-
-            // Position Planar U32
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPositionPlanarU32.descriptorSet);
-            frame.cmd->BindIndexBuffer(mPositionPlanarU32.mesh);
-            frame.cmd->BindVertexBuffers(mPositionPlanarU32.mesh);
-            frame.cmd->DrawIndexed(mPositionPlanarU32.mesh->GetIndexCount());
-
-            // Position Planar
-            frame.cmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mPositionPlanar.descriptorSet);
-            frame.cmd->BindVertexBuffers(mPositionPlanar.mesh);
-            frame.cmd->Draw(mPositionPlanar.mesh->GetVertexCount());
-
             // Draw ImGui
             DrawDebugInfo();
             DrawImGui(frame.cmd);
@@ -372,9 +424,11 @@ void ProjApp::Render()
     }
     PPX_CHECKED_CALL(frame.cmd->End());
 
+    const grfx::CommandBuffer* commandBuffers[2] = {pSceneCmd, frame.cmd};
+
     grfx::SubmitInfo submitInfo     = {};
-    submitInfo.commandBufferCount   = 1;
-    submitInfo.ppCommandBuffers     = &frame.cmd;
+    submitInfo.commandBufferCount   = 2;
+    submitInfo.ppCommandBuffers     = commandBuffers;
     submitInfo.waitSemaphoreCount   = 1;
     submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
     submitInfo.signalSemaphoreCount = 1;
@@ -23,7 +23,14 @@ const grfx::Api kApi = grfx::API_DX_12_0;
 const grfx::Api kApi = grfx::API_VK_1_1;
 #endif
 
-#define kShadowMapSize 1024
+#define kShadowMapSize    1024
+#define kCascadeCount     4
+#define kCascadeSize      1024
+#define kCascadeAtlasSize (2 * kCascadeSize)
+
+static const float kShadowDistance       = 40.0f; // View depth covered by the cascades
+static const float kCascadeSplitLambda   = 0.75f; // Blend between uniform (0) and logarithmic (1) splits
+static const float kCascadeCasterPadding = 20.0f; // Pulls each cascade's near plane towards the light to keep off-screen casters
 
 class ProjApp
     : public ppx::Application
@@ -46,16 +53,30 @@ private:
         grfx::FencePtr         renderCompleteFence;
     };
 
+    enum ShadowMode
+    {
+        SHADOW_MODE_SINGLE          = 0,
+        SHADOW_MODE_CASCADED        = 1,
+        SHADOW_MODE_CASCADED_CACHED = 2,
+    };
+
     struct Entity
     {
-        float3                 translate = float3(0, 0, 0);
-        float3                 rotate    = float3(0, 0, 0);
-        float3                 scale     = float3(1, 1, 1);
-        grfx::MeshPtr          mesh;
-        grfx::DescriptorSetPtr drawDescriptorSet;
-        grfx::BufferPtr        drawUniformBuffer;
-        grfx::DescriptorSetPtr shadowDescriptorSet;
-        grfx::BufferPtr        shadowUniformBuffer;
+        float3                         translate = float3(0, 0, 0);
+        float3                         rotate    = float3(0, 0, 0);
+        float3                         scale     = float3(1, 1, 1);
+        bool                           isStatic  = true; // Static entities are drawn into the cached cascades
+        grfx::MeshPtr                  mesh;
+        grfx::DescriptorSetPtr         drawDescriptorSet;
+        grfx::BufferPtr                drawUniformBuffer;
+        grfx::DescriptorSetPtr         shadowDescriptorSet;
+        grfx::BufferPtr                shadowUniformBuffer;
+        grfx::DescriptorSetPtr         cascadeDrawDescriptorSet;
+        grfx::BufferPtr                cascadeDrawUniformBuffer;
+        grfx::DescriptorSetPtr         cascadeShadowDescriptorSets[kCascadeCount];
+        grfx::BufferPtr                cascadeShadowUniformBuffer; // One MVP per cascade
+        grfx::DescriptorSetPtr         rayQueryDescriptorSet;
+        grfx::AccelerationStructurePtr blas;
     };
 
     std::vector<PerFrame>        mPerFrame;
@@ -82,7 +103,37 @@ private:
     Entity                       mLight;
     float3                       mLightPosition = float3(0, 5, 5);
     PerspCamera                  mLightCamera;
-    bool                         mUsePCF = false;
+    float                        mLightTime     = 0;
+    bool                         mAnimateLight  = true;
+    bool                         mUsePCF        = false;
+
+    // Cascaded shadow maps for a directional light pointing from the light
+    // cube towards the origin. The cascades share one atlas, the cached mode
+    // keeps the static entities' depth in a second atlas and only draws it
+    // again when a cascade moves.
+    ShadowMode                mShadowMode   = SHADOW_MODE_CASCADED_CACHED;
+    bool                      mShowCascades = false;
+    grfx::GraphicsPipelinePtr mCascadeDrawPipeline;
+    grfx::RenderPassPtr       mCascadeRenderPass;        // Clears the atlas
+    grfx::RenderPassPtr       mCascadeDynamicRenderPass; // Loads the atlas copied from the static one
+    grfx::RenderPassPtr       mCascadeStaticRenderPass;
+    grfx::SampledImageViewPtr mCascadeImageView;
+    float4x4                  mCascadeViewProjectionMatrices[kCascadeCount]       = {};
+    float4x4                  mCachedCascadeViewProjectionMatrices[kCascadeCount] = {};
+    float4                    mCascadeSplits                                      = float4(0);
+    float4                    mCascadeTexelSizes                                  = float4(0);
+    bool                      mStaticCascadesValid                                = false;
+    uint64_t                  mStaticCascadeDrawCount                             = 0;
+
+    // Ray queried shadows, only set up if the device supports ray queries
+    bool                                  mRayQuerySupported = false;
+    bool                                  mUseRayQuery       = false;
+    grfx::DescriptorSetLayoutPtr          mRayQuerySetLayout;
+    grfx::PipelineInterfacePtr            mRayQueryPipelineInterface;
+    grfx::GraphicsPipelinePtr             mRayQueryPipeline;
+    grfx::AccelerationStructureBuilderPtr mAccelerationStructureBuilder;
+    grfx::BufferPtr                       mInstanceBuffer;
+    grfx::AccelerationStructurePtr        mTLAS;
 
 private:
     void SetupEntity(
@@ -91,14 +142,30 @@ private:
         const grfx::DescriptorSetLayout* pDrawSetLayout,
         const grfx::DescriptorSetLayout* pShadowSetLayout,
         Entity*                          pEntity);
+    void SetupRayQuery();
+    void SetupCascades();
+    void UpdateCascades();
+    void DrawCascadeEntities(grfx::CommandBuffer* pCmd, bool drawStatic, bool drawDynamic);
+    void RecordCascades(grfx::CommandBuffer* pCmd);
 };
 
+static float4x4 GetModelMatrix(const float3& translate, const float3& rotate, const float3& scale)
+{
+    float4x4 T = glm::translate(translate);
+    float4x4 R = glm::rotate(rotate.z, float3(0, 0, 1)) *
+                 glm::rotate(rotate.y, float3(0, 1, 0)) *
+                 glm::rotate(rotate.x, float3(1, 0, 0));
+    float4x4 S = glm::scale(scale);
+    return T * R * S;
+}
+
 void ProjApp::Config(ppx::ApplicationSettings& settings)
 {
     settings.appName                    = "sample_12_shadows";
     settings.enableImGui                = true;
     settings.grfx.api                   = kApi;
     settings.grfx.swapchain.depthFormat = grfx::FORMAT_D32_FLOAT;
+    settings.grfx.gpuProfiler.enable    = true;
 }
 
 void ProjApp::SetupEntity(
@@ -110,7 +177,7 @@ void ProjApp::SetupEntity(
 {
     Geometry geo;
     PPX_CHECKED_CALL(Geometry::Create(mesh, &geo));
-    PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), &geo, &pEntity->mesh));
+    PPX_CHECKED_CALL(grfx_util::CreateMeshFromGeometry(GetGraphicsQueue(), &geo, &pEntity->mesh, nullptr, mRayQuerySupported));
 
     // Draw uniform buffer
     grfx::BufferCreateInfo bufferCreateInfo        = {};
@@ -149,6 +216,407 @@ void ProjApp::SetupEntity(
     write.bufferRange  = PPX_WHOLE_SIZE;
     write.pBuffer      = pEntity->shadowUniformBuffer;
     PPX_CHECKED_CALL(pEntity->shadowDescriptorSet->UpdateDescriptors(1, &write));
+
+    // Cascade draw uniform buffer and descriptor set, the atlas is written by SetupCascades()
+    bufferCreateInfo                               = {};
+    bufferCreateInfo.size                          = RoundUp(1024, PPX_CONSTANT_BUFFER_ALIGNMENT);
+    bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+    bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &pEntity->cascadeDrawUniformBuffer));
+
+    PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(pDescriptorPool, pDrawSetLayout, &pEntity->cascadeDrawDescriptorSet));
+
+    write              = {};
+    write.binding      = 0;
+    write.type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.bufferOffset = 0;
+    write.bufferRange  = PPX_WHOLE_SIZE;
+    write.pBuffer      = pEntity->cascadeDrawUniformBuffer;
+    PPX_CHECKED_CALL(pEntity->cascadeDrawDescriptorSet->UpdateDescriptors(1, &write));
+
+    // Cascade shadow uniform buffer, each cascade's descriptor set points at its own slice
+    bufferCreateInfo                               = {};
+    bufferCreateInfo.size                          = kCascadeCount * PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+    bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+    bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &pEntity->cascadeShadowUniformBuffer));
+
+    for (uint32_t i = 0; i < kCascadeCount; ++i) {
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(pDescriptorPool, pShadowSetLayout, &pEntity->cascadeShadowDescriptorSets[i]));
+
+        write              = {};
+        write.binding      = 0;
+        write.type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.bufferOffset = i * PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+        write.bufferRange  = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+        write.pBuffer      = pEntity->cascadeShadowUniformBuffer;
+        PPX_CHECKED_CALL(pEntity->cascadeShadowDescriptorSets[i]->UpdateDescriptors(1, &write));
+    }
+
+    // Ray query descriptor set, the acceleration structure is written once the TLAS exists
+    if (mRayQuerySupported) {
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(pDescriptorPool, mRayQuerySetLayout, &pEntity->rayQueryDescriptorSet));
+
+        write              = {};
+        write.binding      = 0;
+        write.type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        write.bufferOffset = 0;
+        write.bufferRange  = PPX_WHOLE_SIZE;
+        write.pBuffer      = pEntity->drawUniformBuffer;
+        PPX_CHECKED_CALL(pEntity->rayQueryDescriptorSet->UpdateDescriptors(1, &write));
+    }
+}
+
+void ProjApp::SetupRayQuery()
+{
+    grfx::AccelerationStructureBuilderCreateInfo builderCreateInfo = {};
+    PPX_CHECKED_CALL(GetDevice()->CreateAccelerationStructureBuilder(&builderCreateInfo, &mAccelerationStructureBuilder));
+
+    // One BLAS per entity, the scene is static so the TLAS is built once
+    std::vector<grfx::AccelerationStructureInstance> instances;
+    for (size_t i = 0; i < mEntities.size(); ++i) {
+        Entity* pEntity = mEntities[i];
+
+        grfx::AccelerationStructureTriangles triangles = {};
+        PPX_CHECKED_CALL(pEntity->mesh->GetAccelerationStructureTriangles(&triangles));
+
+        grfx::AccelerationStructureBuildInputs inputs = {};
+        inputs.type                                   = grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        inputs.geometryCount                          = 1;
+        inputs.pGeometries                            = &triangles;
+        PPX_CHECKED_CALL(mAccelerationStructureBuilder->AddBuild(inputs, &pEntity->blas));
+
+        grfx::AccelerationStructureInstance instance = {};
+        instance.SetTransform(GetModelMatrix(pEntity->translate, pEntity->rotate, pEntity->scale));
+        instance.instanceCustomIndex            = static_cast<uint32_t>(i);
+        instance.accelerationStructureReference = pEntity->blas->GetDeviceAddress();
+        instances.push_back(instance);
+    }
+
+    // Instance buffer
+    {
+        grfx::BufferCreateInfo bufferCreateInfo                     = {};
+        bufferCreateInfo.size                                       = instances.size() * sizeof(grfx::AccelerationStructureInstance);
+        bufferCreateInfo.usageFlags.bits.accelerationStructureInput = true;
+        bufferCreateInfo.memoryUsage                                = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &mInstanceBuffer));
+        PPX_CHECKED_CALL(mInstanceBuffer->CopyFromSource(static_cast<uint32_t>(bufferCreateInfo.size), instances.data()));
+    }
+
+    // TLAS, recorded after the BLAS builds by the builder
+    {
+        grfx::AccelerationStructureBuildInputs inputs = {};
+        inputs.type                                   = grfx::ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+        inputs.instanceCount                          = CountU32(instances);
+        inputs.pInstanceBuffer                        = mInstanceBuffer;
+        PPX_CHECKED_CALL(mAccelerationStructureBuilder->AddBuild(inputs, &mTLAS));
+    }
+
+    grfx::CommandBufferPtr cmd;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&cmd));
+    PPX_CHECKED_CALL(cmd->Begin());
+    PPX_CHECKED_CALL(mAccelerationStructureBuilder->Record(cmd));
+    PPX_CHECKED_CALL(cmd->End());
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &cmd;
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+    PPX_CHECKED_CALL(GetGraphicsQueue()->WaitIdle());
+    GetGraphicsQueue()->DestroyCommandBuffer(cmd);
+
+    // Point the ray query descriptor sets at the TLAS
+    grfx::WriteDescriptor write  = {};
+    write.binding                = 3;
+    write.type                   = grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE;
+    write.pAccelerationStructure = mTLAS;
+    for (size_t i = 0; i < mEntities.size(); ++i) {
+        PPX_CHECKED_CALL(mEntities[i]->rayQueryDescriptorSet->UpdateDescriptors(1, &write));
+    }
+
+    // Pipeline interface
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mRayQuerySetLayout;
+    PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mRayQueryPipelineInterface));
+
+    // Pipeline
+    grfx::ShaderModulePtr VS;
+
+    std::vector<char> bytecode = LoadShader("basic/shaders", "DiffuseShadowRayQuery.vs");
+    PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &VS));
+
+    grfx::ShaderModulePtr PS;
+
+    bytecode = LoadShader("basic/shaders", "DiffuseShadowRayQuery.ps");
+    PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+    shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &PS));
+
+    grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+    gpCreateInfo.VS                                 = {VS.Get(), "vsmain"};
+    gpCreateInfo.PS                                 = {PS.Get(), "psmain"};
+    gpCreateInfo.vertexInputState.bindingCount      = 3;
+    gpCreateInfo.vertexInputState.bindings[0]       = mGroundPlane.mesh->GetDerivedVertexBindings()[0];
+    gpCreateInfo.vertexInputState.bindings[1]       = mGroundPlane.mesh->GetDerivedVertexBindings()[1];
+    gpCreateInfo.vertexInputState.bindings[2]       = mGroundPlane.mesh->GetDerivedVertexBindings()[2];
+    gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+    gpCreateInfo.cullMode                           = grfx::CULL_MODE_BACK;
+    gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+    gpCreateInfo.depthReadEnable                    = true;
+    gpCreateInfo.depthWriteEnable                   = true;
+    gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+    gpCreateInfo.outputState.renderTargetCount      = 1;
+    gpCreateInfo.outputState.renderTargetFormats[0] = GetSwapchain()->GetColorFormat();
+    gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
+    gpCreateInfo.pPipelineInterface                 = mRayQueryPipelineInterface;
+
+    PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mRayQueryPipeline));
+    GetDevice()->DestroyShaderModule(VS);
+    GetDevice()->DestroyShaderModule(PS);
+}
+
+void ProjApp::SetupCascades()
+{
+    // Cascade atlas, the cached mode copies the static atlas into it
+    {
+        grfx::RenderPassCreateInfo2 createInfo                        = {};
+        createInfo.width                                              = kCascadeAtlasSize;
+        createInfo.height                                             = kCascadeAtlasSize;
+        createInfo.depthStencilFormat                                 = grfx::FORMAT_D32_FLOAT;
+        createInfo.depthStencilUsageFlags.bits.depthStencilAttachment = true;
+        createInfo.depthStencilUsageFlags.bits.sampled                = true;
+        createInfo.depthStencilUsageFlags.bits.transferDst            = true;
+        createInfo.depthStencilClearValue                             = {1.0f, 0xFF};
+        createInfo.depthLoadOp                                        = grfx::ATTACHMENT_LOAD_OP_CLEAR;
+        createInfo.depthStoreOp                                       = grfx::ATTACHMENT_STORE_OP_STORE;
+        createInfo.depthStencilInitialState                           = grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        PPX_CHECKED_CALL(GetDevice()->CreateRenderPass(&createInfo, &mCascadeRenderPass));
+    }
+
+    // Same atlas, loaded so the dynamic entities are drawn on top of the static ones
+    {
+        grfx::RenderPassCreateInfo3 createInfo = {};
+        createInfo.width                       = kCascadeAtlasSize;
+        createInfo.height                      = kCascadeAtlasSize;
+        createInfo.pDepthStencilImage          = mCascadeRenderPass->GetDepthStencilImage();
+        createInfo.depthLoadOp                 = grfx::ATTACHMENT_LOAD_OP_LOAD;
+        createInfo.depthStoreOp                = grfx::ATTACHMENT_STORE_OP_STORE;
+        PPX_CHECKED_CALL(GetDevice()->CreateRenderPass(&createInfo, &mCascadeDynamicRenderPass));
+    }
+
+    // Static atlas
+    {
+        grfx::RenderPassCreateInfo2 createInfo                        = {};
+        createInfo.width                                              = kCascadeAtlasSize;
+        createInfo.height                                             = kCascadeAtlasSize;
+        createInfo.depthStencilFormat                                 = grfx::FORMAT_D32_FLOAT;
+        createInfo.depthStencilUsageFlags.bits.depthStencilAttachment = true;
+        createInfo.depthStencilUsageFlags.bits.transferSrc            = true;
+        createInfo.depthStencilClearValue                             = {1.0f, 0xFF};
+        createInfo.depthLoadOp                                        = grfx::ATTACHMENT_LOAD_OP_CLEAR;
+        createInfo.depthStoreOp                                       = grfx::ATTACHMENT_STORE_OP_STORE;
+        createInfo.depthStencilInitialState                           = grfx::RESOURCE_STATE_COPY_SRC;
+        PPX_CHECKED_CALL(GetDevice()->CreateRenderPass(&createInfo, &mCascadeStaticRenderPass));
+    }
+
+    // Point the cascade draw descriptor sets at the atlas
+    {
+        grfx::SampledImageViewCreateInfo ivCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(mCascadeRenderPass->GetDepthStencilImage());
+        PPX_CHECKED_CALL(GetDevice()->CreateSampledImageView(&ivCreateInfo, &mCascadeImageView));
+
+        grfx::WriteDescriptor writes[2] = {};
+        writes[0].binding               = 1; // Cascade atlas
+        writes[0].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[0].pImageView            = mCascadeImageView;
+        writes[1].binding               = 2; // Shadow sampler
+        writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+        writes[1].pSampler              = mShadowSampler;
+
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            Entity* pEntity = mEntities[i];
+            PPX_CHECKED_CALL(pEntity->cascadeDrawDescriptorSet->UpdateDescriptors(2, writes));
+        }
+    }
+
+    // Pipeline, same interface as the single shadow map draw
+    {
+        grfx::ShaderModulePtr VS;
+
+        std::vector<char> bytecode = LoadShader("basic/shaders", "DiffuseShadowCascaded.vs");
+        PPX_ASSERT_MSG(!bytecode.empty(), "VS shader bytecode load failed");
+        grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &VS));
+
+        grfx::ShaderModulePtr PS;
+
+        bytecode = LoadShader("basic/shaders", "DiffuseShadowCascaded.ps");
+        PPX_ASSERT_MSG(!bytecode.empty(), "PS shader bytecode load failed");
+        shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+        PPX_CHECKED_CALL(GetDevice()->CreateShaderModule(&shaderCreateInfo, &PS));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {VS.Get(), "vsmain"};
+        gpCreateInfo.PS                                 = {PS.Get(), "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount      = 3;
+        gpCreateInfo.vertexInputState.bindings[0]       = mGroundPlane.mesh->GetDerivedVertexBindings()[0];
+        gpCreateInfo.vertexInputState.bindings[1]       = mGroundPlane.mesh->GetDerivedVertexBindings()[1];
+        gpCreateInfo.vertexInputState.bindings[2]       = mGroundPlane.mesh->GetDerivedVertexBindings()[2];
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_BACK;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = true;
+        gpCreateInfo.depthWriteEnable                   = true;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = GetSwapchain()->GetColorFormat();
+        gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
+        gpCreateInfo.pPipelineInterface                 = mDrawObjectPipelineInterface;
+
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mCascadeDrawPipeline));
+        GetDevice()->DestroyShaderModule(VS);
+        GetDevice()->DestroyShaderModule(PS);
+    }
+}
+
+void ProjApp::UpdateCascades()
+{
+    const float nearClip = mCamera.GetNearClip();
+    const float farClip  = std::min(mCamera.GetFarClip(), kShadowDistance);
+
+    // View space corners of the near plane. The corners of a slice at view
+    // depth d are the same corners scaled by d / nearClip.
+    const float4x4 invProjection = glm::inverse(mCamera.GetProjectionMatrix());
+    const float4x4 invView       = glm::inverse(mCamera.GetViewMatrix());
+    const float2   ndcCorners[4] = {float2(-1, -1), float2(1, -1), float2(-1, 1), float2(1, 1)};
+    float3         nearCorners[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+        float4 corner  = invProjection * float4(ndcCorners[i], 0, 1);
+        nearCorners[i] = float3(corner) / corner.w;
+    }
+
+    const float3 lightDirection = glm::normalize(mLightPosition);
+    const float3 up             = (std::abs(lightDirection.y) > 0.99f) ? float3(0, 0, 1) : float3(0, 1, 0);
+
+    float splitNear = nearClip;
+    for (uint32_t i = 0; i < kCascadeCount; ++i) {
+        // Practical split scheme
+        float p        = static_cast<float>(i + 1) / static_cast<float>(kCascadeCount);
+        float logSplit = nearClip * std::pow(farClip / nearClip, p);
+        float uniSplit = nearClip + (farClip - nearClip) * p;
+        float splitFar = glm::mix(uniSplit, logSplit, kCascadeSplitLambda);
+
+        // Bound the slice with a sphere rather than a box, its size doesn't
+        // change as the camera rotates so the texel size stays constant
+        float3 corners[8];
+        float3 center = float3(0);
+        for (uint32_t j = 0; j < 4; ++j) {
+            corners[j]     = float3(invView * float4(nearCorners[j] * (splitNear / nearClip), 1));
+            corners[j + 4] = float3(invView * float4(nearCorners[j] * (splitFar / nearClip), 1));
+            center += corners[j] + corners[j + 4];
+        }
+        center /= 8.0f;
+
+        float radius = 0;
+        for (uint32_t j = 0; j < 8; ++j) {
+            radius = std::max(radius, glm::length(corners[j] - center));
+        }
+        radius = std::ceil(radius * 16.0f) / 16.0f;
+
+        float4x4 V = glm::lookAt(center + lightDirection * (radius + kCascadeCasterPadding), center, up);
+        float4x4 P = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + kCascadeCasterPadding);
+
+        // Snap to whole texels: shift the projection so the world origin
+        // lands on a texel corner, which keeps shadow edges from shimmering
+        // as the cascade follows the camera
+        float4 origin       = P * V * float4(0, 0, 0, 1);
+        float2 originTexels = float2(origin) * (kCascadeSize / 2.0f);
+        float2 offset       = (glm::round(originTexels) - originTexels) * (2.0f / kCascadeSize);
+        P[3][0] += offset.x;
+        P[3][1] += offset.y;
+
+        mCascadeViewProjectionMatrices[i] = P * V;
+        mCascadeSplits[i]                 = splitFar;
+        mCascadeTexelSizes[i]             = 2.0f * radius / kCascadeSize;
+
+        splitNear = splitFar;
+    }
+}
+
+void ProjApp::DrawCascadeEntities(grfx::CommandBuffer* pCmd, bool drawStatic, bool drawDynamic)
+{
+    pCmd->BindGraphicsPipeline(mShadowPipeline);
+    for (uint32_t cascade = 0; cascade < kCascadeCount; ++cascade) {
+        int32_t x = static_cast<int32_t>((cascade % 2) * kCascadeSize);
+        int32_t y = static_cast<int32_t>((cascade / 2) * kCascadeSize);
+        pCmd->SetScissors(grfx::Rect(x, y, kCascadeSize, kCascadeSize));
+        pCmd->SetViewports(grfx::Viewport(static_cast<float>(x), static_cast<float>(y), kCascadeSize, kCascadeSize));
+
+        for (size_t i = 0; i < mEntities.size(); ++i) {
+            Entity* pEntity = mEntities[i];
+            if (pEntity->isStatic ? !drawStatic : !drawDynamic) {
+                continue;
+            }
+
+            pCmd->BindGraphicsDescriptorSets(mShadowPipelineInterface, 1, &pEntity->cascadeShadowDescriptorSets[cascade]);
+            pCmd->BindIndexBuffer(pEntity->mesh);
+            pCmd->BindVertexBuffers(pEntity->mesh);
+            pCmd->DrawIndexed(pEntity->mesh->GetIndexCount());
+        }
+    }
+}
+
+void ProjApp::RecordCascades(grfx::CommandBuffer* pCmd)
+{
+    grfx::ImagePtr cascadeImage = mCascadeRenderPass->GetDepthStencilImage();
+
+    if (mShadowMode == SHADOW_MODE_CASCADED_CACHED) {
+        grfx::ImagePtr staticImage = mCascadeStaticRenderPass->GetDepthStencilImage();
+
+        // Static entities only need to be drawn again when a cascade moved,
+        // texel snapping keeps the matrices identical while it doesn't
+        bool staticCascadesDirty = !mStaticCascadesValid ||
+                                   (memcmp(mCachedCascadeViewProjectionMatrices, mCascadeViewProjectionMatrices, sizeof(mCascadeViewProjectionMatrices)) != 0);
+        if (staticCascadesDirty) {
+            pCmd->TransitionImageState(staticImage, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+            pCmd->BeginRenderPass(mCascadeStaticRenderPass);
+            DrawCascadeEntities(pCmd, true, false);
+            pCmd->EndRenderPass();
+
+            memcpy(mCachedCascadeViewProjectionMatrices, mCascadeViewProjectionMatrices, sizeof(mCascadeViewProjectionMatrices));
+            mStaticCascadesValid = true;
+            ++mStaticCascadeDrawCount;
+        }
+
+        // Start from the static depth and draw the dynamic entities on top.
+        // D3D12 can only copy whole depth subresources, so the whole atlas is copied.
+        pCmd->TransitionImageState(staticImage, grfx::RESOURCE_STATE_COPY_SRC);
+        pCmd->TransitionImageState(cascadeImage, grfx::RESOURCE_STATE_COPY_DST);
+
+        grfx::ImageToImageCopyInfo copyInfo = {};
+        copyInfo.extent.x                   = kCascadeAtlasSize;
+        copyInfo.extent.y                   = kCascadeAtlasSize;
+        copyInfo.extent.z                   = 1;
+        pCmd->CopyImageToImage(&copyInfo, staticImage, cascadeImage);
+
+        pCmd->TransitionImageState(cascadeImage, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+        pCmd->BeginRenderPass(mCascadeDynamicRenderPass);
+        DrawCascadeEntities(pCmd, false, true);
+        pCmd->EndRenderPass();
+    }
+    else {
+        pCmd->TransitionImageState(cascadeImage, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+        pCmd->BeginRenderPass(mCascadeRenderPass);
+        DrawCascadeEntities(pCmd, true, true);
+        pCmd->EndRenderPass();
+    }
+
+    pCmd->TransitionImageState(cascadeImage, grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
 }
 
 void ProjApp::Setup()
@@ -159,12 +627,15 @@ void ProjApp::Setup()
         mLightCamera = PerspCamera(60.0f, 1.0f, 1.0f, 100.0f);
     }
 
+    mRayQuerySupported = GetDevice()->RayQuerySupported();
+
     // Create descriptor pool large enough for this project
     {
         grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
         poolCreateInfo.uniformBuffer                  = 512;
         poolCreateInfo.sampledImage                   = 512;
         poolCreateInfo.sampler                        = 512;
+        poolCreateInfo.accelerationStructure          = mRayQuerySupported ? 512 : 0;
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
     }
 
@@ -181,6 +652,14 @@ void ProjApp::Setup()
         layoutCreateInfo = {};
         layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{0, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
         PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mShadowSetLayout));
+
+        // Ray query
+        if (mRayQuerySupported) {
+            layoutCreateInfo = {};
+            layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{0, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+            layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{3, grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE, 1, grfx::SHADER_STAGE_PS});
+            PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mRayQuerySetLayout));
+        }
     }
 
     // Setup entities
@@ -200,9 +679,15 @@ void ProjApp::Setup()
         mKnob.translate = float3(2, 1, 0);
         mKnob.rotate    = float3(0, glm::radians(180.0f), 0);
         mKnob.scale     = float3(2, 2, 2);
+        mKnob.isStatic  = false;
         mEntities.push_back(&mKnob);
     }
 
+    // Acceleration structures and ray query pipeline
+    if (mRayQuerySupported) {
+        SetupRayQuery();
+    }
+
     // Draw object pipeline interface and pipeline
     {
         // Pipeline interface
@@ -331,6 +816,9 @@ void ProjApp::Setup()
         }
     }
 
+    // Cascaded shadow maps
+    SetupCascades();
+
     // Light
     {
         // Descriptor set layt
@@ -445,25 +933,37 @@ void ProjApp::Render()
     // Wait for and reset image acquired fence
     PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
 
+    // Read the previous frame's GPU timings
+    GetGpuProfiler()->BeginFrame(0);
+
+    // Ray queries don't need a shadow map, cascades replace the single one otherwise
+    const bool useRayQuery = mRayQuerySupported && mUseRayQuery;
+    const bool useCascades = !useRayQuery && (mShadowMode != SHADOW_MODE_SINGLE);
+
     // Update light position
-    float t        = GetElapsedSeconds() / 2.0f;
+    if (mAnimateLight) {
+        mLightTime += GetPrevFrameTime() / 2000.0f;
+    }
+    float t        = mLightTime;
     float r        = 7.0f;
     mLightPosition = float3(r * cos(t), 5.0f, r * sin(t));
 
+    // The sphere bobs up and down with cascades to exercise the dynamic entity
+    // path, it stays put otherwise since the ray query TLAS is only built once
+    mKnob.translate.y = useCascades ? 1.5f + 0.5f * std::sin(GetElapsedSeconds() * 2.0f) : 1.0f;
+
     // Update camera(s)
     mCamera.LookAt(float3(5, 7, 7), float3(0, 1, 0));
     mLightCamera.LookAt(mLightPosition, float3(0, 0, 0));
+    if (useCascades) {
+        UpdateCascades();
+    }
 
     // Update uniform buffers
     for (size_t i = 0; i < mEntities.size(); ++i) {
         Entity* pEntity = mEntities[i];
 
-        float4x4 T = glm::translate(pEntity->translate);
-        float4x4 R = glm::rotate(pEntity->rotate.z, float3(0, 0, 1)) *
-                     glm::rotate(pEntity->rotate.y, float3(0, 1, 0)) *
-                     glm::rotate(pEntity->rotate.x, float3(1, 0, 0));
-        float4x4 S = glm::scale(pEntity->scale);
-        float4x4 M = T * R * S;
+        float4x4 M = GetModelMatrix(pEntity->translate, pEntity->rotate, pEntity->scale);
 
         // Draw uniform buffers
         struct Scene
@@ -493,6 +993,47 @@ void ProjApp::Render()
         float4x4 MVP = PV * M; // Yes - the other is reversed
 
         pEntity->shadowUniformBuffer->CopyFromSource(sizeof(MVP), &MVP);
+
+        if (useCascades) {
+            struct CascadedScene
+            {
+                float4x4 ModelMatrix;                                  // Transforms object space to world space
+                float4x4 NormalMatrix;                                 // Transforms object space to normal space
+                float4   Ambient;                                      // Object's ambient intensity
+                float4x4 CameraViewProjectionMatrix;                   // Camera's view projection matrix
+                float4   CameraPosition;                               // Camera's position
+                float4   CameraForward;                                // Camera's view direction
+                float4   LightDirection;                               // Direction towards the light
+                float4x4 CascadeViewProjectionMatrices[kCascadeCount]; // Light's view projection matrix for each cascade
+                float4   CascadeSplits;                                // View depth where each cascade ends
+                float4   CascadeTexelSizes;                            // World space size of a texel in each cascade
+                uint4    Options;                                      // Enable/disable PCF, tint cascades
+            };
+
+            CascadedScene cascadedScene              = {};
+            cascadedScene.ModelMatrix                = M;
+            cascadedScene.NormalMatrix               = glm::inverseTranspose(M);
+            cascadedScene.Ambient                    = float4(0.3f);
+            cascadedScene.CameraViewProjectionMatrix = mCamera.GetViewProjectionMatrix();
+            cascadedScene.CameraPosition             = float4(mCamera.GetEyePosition(), 1);
+            cascadedScene.CameraForward              = float4(mCamera.GetViewDirection(), 0);
+            cascadedScene.LightDirection             = float4(glm::normalize(mLightPosition), 0);
+            cascadedScene.CascadeSplits              = mCascadeSplits;
+            cascadedScene.CascadeTexelSizes          = mCascadeTexelSizes;
+            cascadedScene.Options                    = uint4(mUsePCF, mShowCascades, 0, 0);
+
+            void* pMappedAddress = nullptr;
+            PPX_CHECKED_CALL(pEntity->cascadeShadowUniformBuffer->MapMemory(0, &pMappedAddress));
+            for (uint32_t cascade = 0; cascade < kCascadeCount; ++cascade) {
+                cascadedScene.CascadeViewProjectionMatrices[cascade] = mCascadeViewProjectionMatrices[cascade];
+
+                float4x4 cascadeMVP = mCascadeViewProjectionMatrices[cascade] * M;
+                memcpy(static_cast<char*>(pMappedAddress) + cascade * PPX_MINIMUM_UNIFORM_BUFFER_SIZE, &cascadeMVP, sizeof(cascadeMVP));
+            }
+            pEntity->cascadeShadowUniformBuffer->UnmapMemory();
+
+            pEntity->cascadeDrawUniformBuffer->CopyFromSource(sizeof(cascadedScene), &cascadedScene);
+        }
     }
 
     // Update light uniform buffer
@@ -511,11 +1052,18 @@ void ProjApp::Render()
         PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
 
         // =====================================================================
-        //  Render shadow pass
+        //  Render shadow pass, ray queries don't need the shadow map
         // =====================================================================
+        if (useCascades) {
+            grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), frame.cmd, "Shadow");
+            RecordCascades(frame.cmd);
+        }
+
         frame.cmd->TransitionImageLayout(mShadowRenderPass->GetDepthStencilImage(), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
         frame.cmd->BeginRenderPass(mShadowRenderPass);
-        {
+        if (!useRayQuery && !useCascades) {
+            grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), frame.cmd, "Shadow");
+
             frame.cmd->SetScissors(mShadowRenderPass->GetScissor());
             frame.cmd->SetViewports(mShadowRenderPass->GetViewport());
 
@@ -543,14 +1091,26 @@ void ProjApp::Render()
             frame.cmd->SetViewports(GetViewport());
 
             // Draw entities
-            frame.cmd->BindGraphicsPipeline(mDrawObjectPipeline);
-            for (size_t i = 0; i < mEntities.size(); ++i) {
-                Entity* pEntity = mEntities[i];
-
-                frame.cmd->BindGraphicsDescriptorSets(mDrawObjectPipelineInterface, 1, &pEntity->drawDescriptorSet);
-                frame.cmd->BindIndexBuffer(pEntity->mesh);
-                frame.cmd->BindVertexBuffers(pEntity->mesh);
-                frame.cmd->DrawIndexed(pEntity->mesh->GetIndexCount());
+            {
+                grfx::GpuProfilerScopeGuard scope(GetGpuProfiler(), frame.cmd, "Scene");
+
+                frame.cmd->BindGraphicsPipeline(useRayQuery ? mRayQueryPipeline : (useCascades ? mCascadeDrawPipeline : mDrawObjectPipeline));
+                for (size_t i = 0; i < mEntities.size(); ++i) {
+                    Entity* pEntity = mEntities[i];
+
+                    if (useRayQuery) {
+                        frame.cmd->BindGraphicsDescriptorSets(mRayQueryPipelineInterface, 1, &pEntity->rayQueryDescriptorSet);
+                    }
+                    else if (useCascades) {
+                        frame.cmd->BindGraphicsDescriptorSets(mDrawObjectPipelineInterface, 1, &pEntity->cascadeDrawDescriptorSet);
+                    }
+                    else {
+                        frame.cmd->BindGraphicsDescriptorSets(mDrawObjectPipelineInterface, 1, &pEntity->drawDescriptorSet);
+                    }
+                    frame.cmd->BindIndexBuffer(pEntity->mesh);
+                    frame.cmd->BindVertexBuffers(pEntity->mesh);
+                    frame.cmd->DrawIndexed(pEntity->mesh->GetIndexCount());
+                }
             }
 
             // Draw light
@@ -566,6 +1126,8 @@ void ProjApp::Render()
         }
         frame.cmd->EndRenderPass();
         frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+
+        GetGpuProfiler()->EndFrame(frame.cmd);
     }
     PPX_CHECKED_CALL(frame.cmd->End());
 
@@ -587,7 +1149,30 @@ void ProjApp::DrawGui()
 {
     ImGui::Separator();
 
+    const char* shadowModeChoices[] = {"Single", "Cascaded", "Cascaded + Cached"};
+    ImGui::Combo("Shadow Mode", reinterpret_cast<int32_t*>(&mShadowMode), shadowModeChoices, IM_ARRAYSIZE(shadowModeChoices));
+    if (mShadowMode != SHADOW_MODE_SINGLE) {
+        ImGui::Checkbox("Show Cascades", &mShowCascades);
+    }
+    if (mShadowMode == SHADOW_MODE_CASCADED_CACHED) {
+        ImGui::Text("Static cascade draws: %" PRIu64, mStaticCascadeDrawCount);
+    }
+
+    ImGui::Checkbox("Animate Light", &mAnimateLight);
     ImGui::Checkbox("Use PCF Shadows", &mUsePCF);
+
+    if (mRayQuerySupported) {
+        ImGui::Checkbox("Use Ray Query Shadows", &mUseRayQuery);
+    }
+    else {
+        ImGui::Text("Ray query shadows not supported");
+    }
+
+    ImGui::Separator();
+
+    for (const auto& scope : GetGpuProfiler()->GetScopes()) {
+        ImGui::Text("GPU %s: %.3f ms", scope.name.c_str(), scope.gpuMs);
+    }
 }
 
 SETUP_APPLICATION(ProjApp)
@@ -0,0 +1,507 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ppx.h"
+#include "ppx/camera.h"
+#include "ppx/graphics_util.h"
+using namespace ppx;
+
+#if defined(USE_DX12)
+const grfx::Api kApi = grfx::API_DX_12_0;
+#elif defined(USE_VK)
+const grfx::Api kApi = grfx::API_VK_1_1;
+#endif
+
+class ProjApp
+    : public ppx::Application
+{
+public:
+    virtual void InitKnobs() override;
+    virtual void Config(ppx::ApplicationSettings& settings) override;
+    virtual void Setup() override;
+    virtual void MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons) override;
+    virtual void Scroll(float dx, float dy) override;
+    virtual void Render() override;
+
+private:
+    struct PerFrame
+    {
+        grfx::CommandBufferPtr cmd;
+        grfx::SemaphorePtr     imageAcquiredSemaphore;
+        grfx::FencePtr         imageAcquiredFence;
+        grfx::SemaphorePtr     renderCompleteSemaphore;
+        grfx::FencePtr         renderCompleteFence;
+    };
+
+    struct Entity
+    {
+        grfx::MeshPtr          mesh;
+        grfx::DescriptorSetPtr descriptorSet;
+        grfx::BufferPtr        uniformBuffer;
+    };
+
+    std::vector<PerFrame>        mPerFrame;
+    grfx::ShaderModulePtr        mVS;
+    grfx::ShaderModulePtr        mPS;
+    grfx::PipelineInterfacePtr   mPipelineInterface;
+    grfx::DescriptorPoolPtr      mDescriptorPool;
+    grfx::DescriptorSetLayoutPtr mDescriptorSetLayout;
+    grfx::GraphicsPipelinePtr    mTrianglePipeline;
+    Entity                       mCube;
+    grfx::GraphicsPipelinePtr    mWirePipeline;
+    Entity                       mWirePlane;
+
+    // The scene is rendered to the top left corner of a full resolution
+    // draw pass, like grfx::DynamicResolution does
+    grfx::DrawPassPtr            mSceneDrawPass;
+    grfx::TemporalResolvePtr     mTemporalResolve;
+    grfx::SamplerPtr             mLinearSampler;
+    grfx::DescriptorSetLayoutPtr mDrawToSwapchainLayout;
+    grfx::DescriptorSetPtr       mDrawToSwapchainSet;
+    grfx::FullscreenQuadPtr      mDrawToSwapchain;
+
+    ArcballCamera mArcballCamera;
+    bool          mWasTemporalAA = false;
+
+    std::shared_ptr<KnobCheckbox>      mTemporalAAKnob;
+    std::shared_ptr<KnobSlider<float>> mRenderScaleKnob;
+    std::shared_ptr<KnobSlider<float>> mBlendFactorKnob;
+
+private:
+    void SetupEntity(const TriMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity);
+    void SetupEntity(const WireMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity);
+    void SetupTemporalResolve();
+    void DrawScene(grfx::CommandBuffer* pCmd);
+};
+
+void ProjApp::InitKnobs()
+{
+    GetKnobManager().InitKnob(&mTemporalAAKnob, "temporal-aa", true);
+    mTemporalAAKnob->SetDisplayName("Temporal AA");
+    mTemporalAAKnob->SetFlagDescription("Render with a jittered camera and resolve through grfx::TemporalResolve. Off renders straight to the swapchain at native resolution.");
+
+    GetKnobManager().InitKnob(&mRenderScaleKnob, "render-scale", 0.5f, 0.25f, 1.0f);
+    mRenderScaleKnob->SetDisplayName("Render Scale");
+    mRenderScaleKnob->SetFlagDescription("Internal resolution of the temporal AA path as a fraction of the swapchain's, upscaled by the resolve.");
+
+    GetKnobManager().InitKnob(&mBlendFactorKnob, "taa-blend-factor", 0.1f, 0.01f, 1.0f);
+    mBlendFactorKnob->SetDisplayName("Blend Factor");
+    mBlendFactorKnob->SetFlagDescription("Weight of the current frame in the history, see grfx::TemporalResolve::SetBlendFactor().");
+}
+
+void ProjApp::Config(ppx::ApplicationSettings& settings)
+{
+    settings.appName                    = "temporal_aa";
+    settings.enableImGui                = true;
+    settings.grfx.api                   = kApi;
+    settings.grfx.swapchain.depthFormat = grfx::FORMAT_D32_FLOAT;
+}
+
+void ProjApp::SetupEntity(const TriMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity)
+{
+    PPX_CHECKED_CALL(grfx_util::CreateMeshFromTriMesh(GetGraphicsQueue(), &mesh, &pEntity->mesh));
+
+    grfx::BufferCreateInfo bufferCreateInfo        = {};
+    bufferCreateInfo.size                          = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+    bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+    bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &pEntity->uniformBuffer));
+
+    PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDescriptorSetLayout, &pEntity->descriptorSet));
+
+    grfx::WriteDescriptor write = {};
+    write.binding               = 0;
+    write.type                  = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.bufferOffset          = 0;
+    write.bufferRange           = PPX_WHOLE_SIZE;
+    write.pBuffer               = pEntity->uniformBuffer;
+    PPX_CHECKED_CALL(pEntity->descriptorSet->UpdateDescriptors(1, &write));
+}
+
+void ProjApp::SetupEntity(const WireMesh& mesh, const GeometryCreateInfo& createInfo, Entity* pEntity)
+{
+    PPX_CHECKED_CALL(grfx_util::CreateMeshFromWireMesh(GetGraphicsQueue(), &mesh, &pEntity->mesh));
+
+    grfx::BufferCreateInfo bufferCreateInfo        = {};
+    bufferCreateInfo.size                          = PPX_MINIMUM_UNIFORM_BUFFER_SIZE;
+    bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+    bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    PPX_CHECKED_CALL(GetDevice()->CreateBuffer(&bufferCreateInfo, &pEntity->uniformBuffer));
+
+    PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDescriptorSetLayout, &pEntity->descriptorSet));
+
+    grfx::WriteDescriptor write = {};
+    write.binding               = 0;
+    write.type                  = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.bufferOffset          = 0;
+    write.bufferRange           = PPX_WHOLE_SIZE;
+    write.pBuffer               = pEntity->uniformBuffer;
+    PPX_CHECKED_CALL(pEntity->descriptorSet->UpdateDescriptors(1, &write));
+}
+
+void ProjApp::SetupTemporalResolve()
+{
+    const uint32_t width  = GetSwapchain()->GetWidth();
+    const uint32_t height = GetSwapchain()->GetHeight();
+
+    // Scene draw pass, same formats as the swapchain so the scene pipelines
+    // work for both paths. Depth is sampled by the resolve.
+    {
+        grfx::DrawPassCreateInfo createInfo     = {};
+        createInfo.width                        = width;
+        createInfo.height                       = height;
+        createInfo.renderTargetCount            = 1;
+        createInfo.renderTargetFormats[0]       = GetSwapchain()->GetColorFormat();
+        createInfo.depthStencilFormat           = GetSwapchain()->GetDepthFormat();
+        createInfo.renderTargetUsageFlags[0]    = grfx::IMAGE_USAGE_SAMPLED;
+        createInfo.depthStencilUsageFlags       = grfx::IMAGE_USAGE_SAMPLED;
+        createInfo.renderTargetInitialStates[0] = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+        createInfo.depthStencilInitialState     = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+        createInfo.renderTargetClearValues[0]   = {0, 0, 0, 0};
+        createInfo.depthStencilClearValue       = {1.0f, 0xFF};
+        PPX_CHECKED_CALL(GetDevice()->CreateDrawPass(&createInfo, &mSceneDrawPass));
+    }
+
+    // Resolve
+    {
+        grfx::ShaderModulePtr CS;
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "TemporalResolve.cs", &CS));
+
+        grfx::TemporalResolveCreateInfo createInfo = {};
+        createInfo.frameCount                      = CountU32(mPerFrame);
+        createInfo.width                           = width;
+        createInfo.height                          = height;
+        createInfo.CS                              = {CS.Get(), "csmain"};
+        PPX_CHECKED_CALL(GetDevice()->CreateTemporalResolve(&createInfo, &mTemporalResolve));
+    }
+
+    // Draw to swapchain
+    {
+        grfx::SamplerCreateInfo samplerCreateInfo = {};
+        samplerCreateInfo.magFilter               = grfx::FILTER_LINEAR;
+        samplerCreateInfo.minFilter               = grfx::FILTER_LINEAR;
+        samplerCreateInfo.addressModeU            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerCreateInfo.addressModeV            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        PPX_CHECKED_CALL(GetDevice()->CreateSampler(&samplerCreateInfo, &mLinearSampler));
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(0, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(1, grfx::DESCRIPTOR_TYPE_SAMPLER));
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mDrawToSwapchainLayout));
+
+        grfx::ShaderModulePtr VS;
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "FullScreenTriangle.vs", &VS));
+        grfx::ShaderModulePtr PS;
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "FullScreenTriangle.ps", &PS));
+
+        grfx::FullscreenQuadCreateInfo createInfo = {};
+        createInfo.VS                             = VS;
+        createInfo.PS                             = PS;
+        createInfo.setCount                       = 1;
+        createInfo.sets[0].set                    = 0;
+        createInfo.sets[0].pLayout                = mDrawToSwapchainLayout;
+        createInfo.renderTargetCount              = 1;
+        createInfo.renderTargetFormats[0]         = GetSwapchain()->GetColorFormat();
+        createInfo.depthStencilFormat             = GetSwapchain()->GetDepthFormat();
+        PPX_CHECKED_CALL(GetDevice()->CreateFullscreenQuad(&createInfo, &mDrawToSwapchain));
+
+        PPX_CHECKED_CALL(GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDrawToSwapchainLayout, &mDrawToSwapchainSet));
+    }
+}
+
+void ProjApp::Setup()
+{
+    // Descriptor stuff
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.uniformBuffer                  = 6;
+        poolCreateInfo.sampledImage                   = 1;
+        poolCreateInfo.sampler                        = 1;
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool));
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding{0, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, grfx::SHADER_STAGE_ALL_GRAPHICS});
+        PPX_CHECKED_CALL(GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mDescriptorSetLayout));
+    }
+
+    // Entities
+    {
+        GeometryCreateInfo geometryCreateInfo = GeometryCreateInfo::Planar().AddColor();
+        TriMeshOptions     triMeshOptions     = TriMeshOptions().Indices().VertexColors();
+        WireMeshOptions    wireMeshOptions    = WireMeshOptions().Indices().VertexColors();
+
+        TriMesh triMesh = TriMesh::CreateCube(float3(2, 2, 2), triMeshOptions);
+        SetupEntity(triMesh, geometryCreateInfo, &mCube);
+
+        // Dense wires alias badly without anti-aliasing
+        WireMesh wireMesh = WireMesh::CreatePlane(WIRE_MESH_PLANE_POSITIVE_Y, float2(20, 20), 80, 80, wireMeshOptions);
+        SetupEntity(wireMesh, geometryCreateInfo, &mWirePlane);
+    }
+
+    // Pipelines
+    {
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "VertexColors.vs", &mVS));
+        PPX_CHECKED_CALL(CreateShader("basic/shaders", "VertexColors.ps", &mPS));
+
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mDescriptorSetLayout;
+        PPX_CHECKED_CALL(GetDevice()->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface));
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {mVS.Get(), "vsmain"};
+        gpCreateInfo.PS                                 = {mPS.Get(), "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount      = 2;
+        gpCreateInfo.vertexInputState.bindings[0]       = mCube.mesh->GetDerivedVertexBindings()[0];
+        gpCreateInfo.vertexInputState.bindings[1]       = mCube.mesh->GetDerivedVertexBindings()[1];
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = true;
+        gpCreateInfo.depthWriteEnable                   = true;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = GetSwapchain()->GetColorFormat();
+        gpCreateInfo.outputState.depthStencilFormat     = GetSwapchain()->GetDepthFormat();
+        gpCreateInfo.pPipelineInterface                 = mPipelineInterface;
+
+        // Triange pipeline
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mTrianglePipeline));
+
+        // Wire pipeline
+        gpCreateInfo.topology = grfx::PRIMITIVE_TOPOLOGY_LINE_LIST;
+        PPX_CHECKED_CALL(GetDevice()->CreateGraphicsPipeline(&gpCreateInfo, &mWirePipeline));
+    }
+
+    // Per frame data
+    {
+        PerFrame frame = {};
+
+        PPX_CHECKED_CALL(GetGraphicsQueue()->CreateCommandBuffer(&frame.cmd));
+
+        grfx::SemaphoreCreateInfo semaCreateInfo = {};
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.imageAcquiredSemaphore));
+
+        grfx::FenceCreateInfo fenceCreateInfo = {};
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.imageAcquiredFence));
+
+        PPX_CHECKED_CALL(GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.renderCompleteSemaphore));
+
+        fenceCreateInfo = {true}; // Create signaled
+        PPX_CHECKED_CALL(GetDevice()->CreateFence(&fenceCreateInfo, &frame.renderCompleteFence));
+
+        mPerFrame.push_back(frame);
+    }
+
+    SetupTemporalResolve();
+
+    // Arcball camera
+    {
+        mArcballCamera.LookAt(float3(4, 5, 8), float3(0, 0, 0), float3(0, 1, 0));
+        mArcballCamera.SetPerspective(60.0f, GetWindowAspect());
+    }
+}
+
+void ProjApp::MouseMove(int32_t x, int32_t y, int32_t dx, int32_t dy, uint32_t buttons)
+{
+    if (buttons & ppx::MOUSE_BUTTON_LEFT) {
+        int32_t prevX = x - dx;
+        int32_t prevY = y - dy;
+
+        float2 prevPos = GetNormalizedDeviceCoordinates(prevX, prevY);
+        float2 curPos  = GetNormalizedDeviceCoordinates(x, y);
+
+        mArcballCamera.Rotate(prevPos, curPos);
+    }
+    else if (buttons & ppx::MOUSE_BUTTON_RIGHT) {
+        int32_t prevX = x - dx;
+        int32_t prevY = y - dy;
+
+        float2 prevPos = GetNormalizedDeviceCoordinates(prevX, prevY);
+        float2 curPos  = GetNormalizedDeviceCoordinates(x, y);
+        float2 delta   = curPos - prevPos;
+
+        mArcballCamera.Pan(delta);
+    }
+}
+
+void ProjApp::Scroll(float dx, float dy)
+{
+    mArcballCamera.Zoom(dy / 2.0f);
+}
+
+void ProjApp::DrawScene(grfx::CommandBuffer* pCmd)
+{
+    // Triangle pipeline
+    pCmd->BindGraphicsPipeline(mTrianglePipeline);
+
+    // Cube
+    pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mCube.descriptorSet);
+    pCmd->BindIndexBuffer(mCube.mesh);
+    pCmd->BindVertexBuffers(mCube.mesh);
+    pCmd->DrawIndexed(mCube.mesh->GetIndexCount());
+
+    // Wire pipeline
+    pCmd->BindGraphicsPipeline(mWirePipeline);
+
+    // Wire plane
+    pCmd->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mWirePlane.descriptorSet);
+    pCmd->BindIndexBuffer(mWirePlane.mesh);
+    pCmd->BindVertexBuffers(mWirePlane.mesh);
+    pCmd->DrawIndexed(mWirePlane.mesh->GetIndexCount());
+}
+
+void ProjApp::Render()
+{
+    PerFrame& frame = mPerFrame[0];
+
+    grfx::SwapchainPtr swapchain = GetSwapchain();
+
+    // Wait for and reset render complete fence
+    PPX_CHECKED_CALL(frame.renderCompleteFence->WaitAndReset());
+
+    uint32_t imageIndex = UINT32_MAX;
+    PPX_CHECKED_CALL(swapchain->AcquireNextImage(UINT64_MAX, frame.imageAcquiredSemaphore, frame.imageAcquiredFence, &imageIndex));
+
+    // Wait for and reset image acquired fence
+    PPX_CHECKED_CALL(frame.imageAcquiredFence->WaitAndReset());
+
+    const bool     temporalAA   = mTemporalAAKnob->GetValue();
+    const uint32_t outputWidth  = mTemporalResolve->GetWidth();
+    const uint32_t outputHeight = mTemporalResolve->GetHeight();
+    uint32_t       renderWidth  = outputWidth;
+    uint32_t       renderHeight = outputHeight;
+    float2         jitter       = float2(0, 0);
+    if (temporalAA) {
+        renderWidth  = std::max(1u, static_cast<uint32_t>(mRenderScaleKnob->GetValue() * static_cast<float>(outputWidth)));
+        renderHeight = std::max(1u, static_cast<uint32_t>(mRenderScaleKnob->GetValue() * static_cast<float>(outputHeight)));
+
+        // The history is stale after rendering without it
+        if (!mWasTemporalAA) {
+            mTemporalResolve->ResetHistory();
+        }
+        mTemporalResolve->SetBlendFactor(mBlendFactorKnob->GetValue());
+
+        const uint32_t phaseCount = grfx::TemporalResolve::GetJitterPhaseCount(renderWidth, outputWidth);
+        jitter                    = grfx::TemporalResolve::GetJitterOffset(static_cast<uint32_t>(GetFrameCount()), phaseCount);
+        mArcballCamera.SetJitter(jitter, renderWidth, renderHeight);
+    }
+    else {
+        mArcballCamera.ClearJitter();
+    }
+    mWasTemporalAA = temporalAA;
+
+    // Update uniform buffer
+    {
+        const float4x4 PV = mArcballCamera.GetJitteredViewProjectionMatrix();
+
+        // Move cube up so it sits on top of the plane
+        float4x4 T   = glm::translate(float3(0, 1, 0));
+        float4x4 mat = PV * T;
+        mCube.uniformBuffer->CopyFromSource(sizeof(mat), &mat);
+
+        T   = glm::translate(float3(0, 0, 0));
+        mat = PV * T;
+        mWirePlane.uniformBuffer->CopyFromSource(sizeof(mat), &mat);
+    }
+
+    // Build command buffer
+    PPX_CHECKED_CALL(frame.cmd->Begin());
+    {
+        if (temporalAA) {
+            grfx::Viewport viewport = {};
+            viewport.width          = static_cast<float>(renderWidth);
+            viewport.height         = static_cast<float>(renderHeight);
+            viewport.minDepth       = 0.0f;
+            viewport.maxDepth       = 1.0f;
+
+            frame.cmd->TransitionImageLayout(mSceneDrawPass, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE);
+            frame.cmd->BeginRenderPass(mSceneDrawPass);
+            {
+                frame.cmd->SetScissors(grfx::Rect(0, 0, renderWidth, renderHeight));
+                frame.cmd->SetViewports(viewport);
+                DrawScene(frame.cmd);
+            }
+            frame.cmd->EndRenderPass();
+            frame.cmd->TransitionImageLayout(mSceneDrawPass, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+
+            grfx::TemporalResolveInputs inputs = {};
+            inputs.pColor                      = mSceneDrawPass->GetRenderTargetTexture(0);
+            inputs.pDepth                      = mSceneDrawPass->GetDepthStencilTexture();
+            inputs.renderWidth                 = renderWidth;
+            inputs.renderHeight                = renderHeight;
+            inputs.jitter                      = jitter;
+            inputs.viewProjectionMatrix        = mArcballCamera.GetViewProjectionMatrix();
+            PPX_CHECKED_CALL(mTemporalResolve->Resolve(frame.cmd, 0, inputs));
+
+            // The output alternates between the two history textures
+            grfx::WriteDescriptor writes[2] = {};
+            writes[0].binding               = 0;
+            writes[0].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            writes[0].pImageView            = mTemporalResolve->GetOutputTexture()->GetSampledImageView();
+            writes[1].binding               = 1;
+            writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+            writes[1].pSampler              = mLinearSampler;
+            PPX_CHECKED_CALL(mDrawToSwapchainSet->UpdateDescriptors(2, writes));
+        }
+
+        grfx::RenderPassPtr renderPass = swapchain->GetRenderPass(imageIndex);
+        PPX_ASSERT_MSG(!renderPass.IsNull(), "render pass object is null");
+
+        grfx::RenderPassBeginInfo beginInfo = {};
+        beginInfo.pRenderPass               = renderPass;
+        beginInfo.renderArea                = renderPass->GetRenderArea();
+        beginInfo.RTVClearCount             = 1;
+        beginInfo.RTVClearValues[0]         = {{0, 0, 0, 0}};
+        beginInfo.DSVClearValue             = {1.0f, 0xFF};
+
+        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_PRESENT, grfx::RESOURCE_STATE_RENDER_TARGET);
+        frame.cmd->BeginRenderPass(&beginInfo);
+        {
+            frame.cmd->SetScissors(GetScissor());
+            frame.cmd->SetViewports(GetViewport());
+
+            if (temporalAA) {
+                frame.cmd->Draw(mDrawToSwapchain, 1, &mDrawToSwapchainSet);
+            }
+            else {
+                DrawScene(frame.cmd);
+            }
+
+            // Draw ImGui
+            DrawDebugInfo();
+            DrawImGui(frame.cmd);
+        }
+        frame.cmd->EndRenderPass();
+        frame.cmd->TransitionImageLayout(renderPass->GetRenderTargetImage(0), PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_PRESENT);
+    }
+    PPX_CHECKED_CALL(frame.cmd->End());
+
+    grfx::SubmitInfo submitInfo     = {};
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.ppCommandBuffers     = &frame.cmd;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.ppWaitSemaphores     = &frame.imageAcquiredSemaphore;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.ppSignalSemaphores   = &frame.renderCompleteSemaphore;
+    submitInfo.pFence               = frame.renderCompleteFence;
+
+    PPX_CHECKED_CALL(GetGraphicsQueue()->Submit(&submitInfo));
+
+    PPX_CHECKED_CALL(swapchain->Present(imageIndex, 1, &frame.renderCompleteSemaphore));
+}
+
+SETUP_APPLICATION(ProjApp)
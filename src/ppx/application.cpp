@@ -13,11 +13,15 @@
 // limitations under the License.
 
 #include "ppx/application.h"
+#include "ppx/frame_arena.h"
 #include "ppx/fs.h"
-#include "ppx/ppm_export.h"
+#include "ppx/image_encoder.h"
 #include "ppx/profiler.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <limits>
@@ -111,6 +115,29 @@ Result Application::InitializePlatform()
     return ppx::SUCCESS;
 }
 
+Result Application::InitializeThreadPolicies()
+{
+    ThreadPolicy policies[THREAD_ROLE_COUNT] = {};
+    Result       ppxres                      = ParseThreadPolicies(mStandardOpts.pThreadAffinity->GetValue(), mStandardOpts.pThreadPriority->GetValue(), policies);
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("invalid --thread-affinity or --thread-priority: \"" << mStandardOpts.pThreadAffinity->GetValue() << "\", \"" << mStandardOpts.pThreadPriority->GetValue() << "\"");
+        return ppxres;
+    }
+
+    for (uint32_t i = 0; i < THREAD_ROLE_COUNT; ++i) {
+        const ThreadRole role = static_cast<ThreadRole>(i);
+        SetThreadPolicy(role, policies[i]);
+        if (!policies[i].cpus.empty() || (policies[i].priority != THREAD_PRIORITY_DEFAULT)) {
+            PPX_LOG_INFO("Thread policy of " << GetThreadRoleName(role) << " threads: " << policies[i].cpus.size() << " cores, " << GetThreadPriorityName(policies[i].priority) << " priority");
+        }
+    }
+
+    // This is the render thread
+    ApplyThreadPolicy(THREAD_ROLE_RENDER);
+
+    return ppx::SUCCESS;
+}
+
 Result Application::InitializeGrfxDevice()
 {
     // Instance
@@ -153,14 +180,24 @@ Result Application::InitializeGrfxDevice()
             return ppxres;
         }
 
-        grfx::DeviceCreateInfo ci = {};
-        ci.pGpu                   = gpu;
-        ci.graphicsQueueCount     = mSettings.grfx.device.graphicsQueueCount;
-        ci.computeQueueCount      = mSettings.grfx.device.computeQueueCount;
-        ci.transferQueueCount     = mSettings.grfx.device.transferQueueCount;
-        ci.vulkanExtensions       = {};
-        ci.pVulkanDeviceFeatures  = nullptr;
-        ci.supportShadingRateMode = mSettings.grfx.device.supportShadingRateMode;
+        grfx::DeviceCreateInfo ci    = {};
+        ci.pGpu                      = gpu;
+        ci.graphicsQueueCount        = mSettings.grfx.device.graphicsQueueCount;
+        ci.computeQueueCount         = mSettings.grfx.device.computeQueueCount;
+        ci.transferQueueCount        = mSettings.grfx.device.transferQueueCount;
+        ci.vulkanExtensions          = {};
+        ci.pVulkanDeviceFeatures     = nullptr;
+        ci.supportShadingRateMode    = mSettings.grfx.device.supportShadingRateMode;
+        ci.dynamicRenderPasses       = mSettings.grfx.device.dynamicRenderPasses;
+        ci.graphicsPipelineLibraries = mSettings.grfx.device.graphicsPipelineLibraries;
+        ci.defragmentation           = mSettings.grfx.device.defragmentation;
+        ci.descriptorBuffers         = mSettings.grfx.device.descriptorBuffers;
+        if (!mStandardOpts.pPipelineCachePath->GetValue().empty()) {
+            ci.pipelineCachePath = ppx::fs::GetFullPath(mStandardOpts.pPipelineCachePath->GetValue(), ppx::fs::GetDefaultOutputDirectory()).string();
+        }
+        if (!mStandardOpts.pPipelineManifestPath->GetValue().empty()) {
+            ci.pipelineManifestPath = ppx::fs::GetFullPath(mStandardOpts.pPipelineManifestPath->GetValue(), ppx::fs::GetDefaultOutputDirectory()).string();
+        }
 #if defined(PPX_BUILD_XR)
         ci.multiView    = IsXrEnabled() && mStandardOpts.pXrEnableMultiview->GetValue();
         ci.pXrComponent = IsXrEnabled() ? &mXrComponent : nullptr;
@@ -178,9 +215,253 @@ Result Application::InitializeGrfxDevice()
         }
     }
 
+    // Secondary device, skipped with a warning on single GPU systems so
+    // applications can fall back to the primary device
+    if (mSettings.grfx.secondaryDevice.enable) {
+        const uint32_t gpuIndex = mStandardOpts.pSecondaryGpuIndex->GetValue();
+        if ((gpuIndex >= mInstance->GetGpuCount()) || (gpuIndex == mStandardOpts.pGpuIndex->GetValue())) {
+            PPX_LOG_WARN("No secondary GPU at index " << gpuIndex << ", the secondary device isn't created");
+        }
+        else {
+            grfx::GpuPtr gpu;
+            Result       ppxres = mInstance->GetGpu(gpuIndex, &gpu);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "grfx::Instance::GetGpu failed");
+                return ppxres;
+            }
+
+            grfx::DeviceCreateInfo ci = {};
+            ci.pGpu                   = gpu;
+            ci.graphicsQueueCount     = mSettings.grfx.secondaryDevice.graphicsQueueCount;
+            ci.computeQueueCount      = mSettings.grfx.secondaryDevice.computeQueueCount;
+            ci.transferQueueCount     = mSettings.grfx.secondaryDevice.transferQueueCount;
+
+            PPX_LOG_INFO("Creating secondary graphics device using " << gpu->GetDeviceName());
+
+            ppxres = mInstance->CreateDevice(&ci, &mSecondaryDevice);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "grfx::Instance::CreateDevice failed for the secondary device");
+                return ppxres;
+            }
+        }
+    }
+
+    // Frame pacing
+    {
+        Result ppxres = InitializeFrameTimelines();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // GPU profiler
+    {
+        Result ppxres = InitializeGpuProfiler();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Application::InitializeFrameTimelines()
+{
+    if (mSettings.grfx.numFramesInFlight == 0) {
+        PPX_ASSERT_MSG(false, "numFramesInFlight must be at least 1");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    if (!mDevice->TimelineSemaphoreSupported()) {
+        PPX_LOG_WARN("Timeline semaphores are not supported, frame pacing falls back to waiting for queue idle");
+        return ppx::SUCCESS;
+    }
+
+    std::vector<grfx::QueuePtr> queues;
+    for (uint32_t i = 0; i < mDevice->GetGraphicsQueueCount(); ++i) {
+        queues.push_back(mDevice->GetGraphicsQueue(i));
+    }
+    for (uint32_t i = 0; i < mDevice->GetComputeQueueCount(); ++i) {
+        queues.push_back(mDevice->GetComputeQueue(i));
+    }
+    for (uint32_t i = 0; i < mDevice->GetTransferQueueCount(); ++i) {
+        queues.push_back(mDevice->GetTransferQueue(i));
+    }
+
+    for (auto& queue : queues) {
+        grfx::SemaphoreCreateInfo createInfo = {};
+        createInfo.semaphoreType             = grfx::SEMAPHORE_TYPE_TIMELINE;
+        createInfo.initialValue              = 0;
+
+        FrameTimeline timeline = {};
+        timeline.pQueue        = queue.Get();
+
+        Result ppxres = mDevice->CreateSemaphore(&createInfo, &timeline.semaphore);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "frame timeline semaphore create failed");
+            return ppxres;
+        }
+
+        mFrameTimelines.push_back(timeline);
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Application::InitializeGpuProfiler()
+{
+    if (!mSettings.grfx.gpuProfiler.enable) {
+        return ppx::SUCCESS;
+    }
+
+    grfx::GpuProfilerCreateInfo createInfo = {};
+    createInfo.pQueue                      = mDevice->GetGraphicsQueue();
+    createInfo.frameCount                  = mSettings.grfx.numFramesInFlight;
+    createInfo.maxScopesPerFrame           = mSettings.grfx.gpuProfiler.maxScopesPerFrame;
+    createInfo.enablePipelineStatistics    = mSettings.grfx.gpuProfiler.enablePipelineStatistics;
+
+    Result ppxres = mDevice->CreateGpuProfiler(&createInfo, &mGpuProfiler);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "grfx::Device::CreateGpuProfiler failed");
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Application::InitializeDynamicResolution()
+{
+    if (!mSettings.grfx.dynamicResolution.enable) {
+        return ppx::SUCCESS;
+    }
+
+    grfx::ShaderModulePtr VS;
+    Result                ppxres = CreateShader("basic/shaders", "DynamicResolutionUpscale.vs", &VS);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    grfx::ShaderModulePtr PS;
+    ppxres = CreateShader("basic/shaders", "DynamicResolutionUpscale.ps", &PS);
+    if (Failed(ppxres)) {
+        mDevice->DestroyShaderModule(VS);
+        return ppxres;
+    }
+
+    const auto&        settings  = mSettings.grfx.dynamicResolution;
+    grfx::SwapchainPtr swapchain = GetSwapchain();
+
+    grfx::DynamicResolutionCreateInfo createInfo = {};
+    createInfo.pQueue                            = mDevice->GetGraphicsQueue();
+    createInfo.frameCount                        = mSettings.grfx.numFramesInFlight;
+    createInfo.width                             = swapchain->GetWidth();
+    createInfo.height                            = swapchain->GetHeight();
+    createInfo.renderTargetFormat                = (settings.renderTargetFormat != grfx::FORMAT_UNDEFINED) ? settings.renderTargetFormat : swapchain->GetColorFormat();
+    createInfo.depthStencilFormat                = settings.depthStencilFormat;
+    createInfo.outputFormat                      = swapchain->GetColorFormat();
+    createInfo.VS                                = {VS, "vsmain"};
+    createInfo.PS                                = {PS, "psmain"};
+    createInfo.controller.targetFrameTimeMs      = (settings.targetFrameTimeMs > 0.0f) ? settings.targetFrameTimeMs : (1000.0f / static_cast<float>(std::max<uint32_t>(mSettings.grfx.pacedFrameRate, 1)));
+    createInfo.controller.minScale               = settings.minScale;
+    createInfo.controller.cooldownFrames         = std::max<uint32_t>(createInfo.controller.cooldownFrames, mSettings.grfx.numFramesInFlight);
+
+    ppxres = mDevice->CreateDynamicResolution(&createInfo, &mDynamicResolution);
+
+    // The pipeline doesn't need the modules once it's created
+    mDevice->DestroyShaderModule(PS);
+    mDevice->DestroyShaderModule(VS);
+
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "grfx::Device::CreateDynamicResolution failed");
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void Application::DestroyFrameTimelines()
+{
+    for (auto& timeline : mFrameTimelines) {
+        mDevice->DestroySemaphore(timeline.semaphore);
+    }
+    mFrameTimelines.clear();
+}
+
+Result Application::SubmitFrame(grfx::Queue* pQueue, const grfx::SubmitInfo* pSubmitInfo)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pSubmitInfo);
+
+    auto it = std::find_if(
+        mFrameTimelines.begin(),
+        mFrameTimelines.end(),
+        [pQueue](const FrameTimeline& elem) -> bool { return elem.pQueue == pQueue; });
+    if (it == mFrameTimelines.end()) {
+        Result ppxres = pQueue->Submit(pSubmitInfo);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        return pQueue->WaitIdle();
+    }
+
+    const uint64_t value = GetFrameTimelineValue(mFrameCount);
+
+    // Append the queue's timeline to the caller's signal semaphores. Value
+    // arrays carry one entry per semaphore when any semaphore is a timeline,
+    // 0 is ignored for binary semaphores.
+    std::vector<grfx::Semaphore*> signalSemaphores(pSubmitInfo->ppSignalSemaphores, pSubmitInfo->ppSignalSemaphores + pSubmitInfo->signalSemaphoreCount);
+    signalSemaphores.push_back(it->semaphore.Get());
+
+    grfx::SubmitInfo submitInfo     = *pSubmitInfo;
+    submitInfo.signalSemaphoreCount = CountU32(signalSemaphores);
+    submitInfo.ppSignalSemaphores   = DataPtr(signalSemaphores);
+    submitInfo.signalValues.resize(pSubmitInfo->signalSemaphoreCount, 0);
+    submitInfo.signalValues.push_back(value);
+    if (submitInfo.waitSemaphoreCount > 0) {
+        submitInfo.waitValues.resize(submitInfo.waitSemaphoreCount, 0);
+    }
+
+    Result ppxres = pQueue->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    it->lastSignaledValue = value;
+
+    return ppx::SUCCESS;
+}
+
+Result Application::WaitForFrame(uint64_t frameIndex, uint64_t timeout) const
+{
+    // Queues that didn't receive work for frameIndex are waited on for the
+    // last value they were signaled with, which completes no later.
+    const uint64_t value = GetFrameTimelineValue(frameIndex);
+    for (const auto& timeline : mFrameTimelines) {
+        const uint64_t waitValue = std::min(value, timeline.lastSignaledValue);
+        if (waitValue == 0) {
+            continue;
+        }
+
+        Result ppxres = timeline.semaphore->Wait(waitValue, timeout);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
     return ppx::SUCCESS;
 }
 
+grfx::Semaphore* Application::GetFrameTimeline(const grfx::Queue* pQueue) const
+{
+    auto it = std::find_if(
+        mFrameTimelines.begin(),
+        mFrameTimelines.end(),
+        [pQueue](const FrameTimeline& elem) -> bool { return elem.pQueue == pQueue; });
+    if (it == mFrameTimelines.end()) {
+        return nullptr;
+    }
+    return it->semaphore.Get();
+}
+
 Result Application::InitializeGrfxSurface()
 {
     if (mSettings.headless) {
@@ -209,7 +490,7 @@ Result Application::InitializeGrfxSurface()
     return ppx::SUCCESS;
 }
 
-Result Application::CreateSwapchains()
+Result Application::CreateSwapchains(grfx::Swapchain* pOldSwapchain)
 {
 #if defined(PPX_BUILD_XR)
     if (IsXrEnabled()) {
@@ -232,6 +513,7 @@ Result Application::CreateSwapchains()
         const int numSwapChains = (mXrComponent.IsMultiView() ? 1 : viewCount) + 1;
         mSwapchains.resize(numSwapChains);
         mStereoscopicSwapchainIndex = 0;
+        ci.xrFoveation              = true;
         for (size_t k = 0; k < numSwapChains - 1; ++k) {
             Result ppxres = mDevice->CreateSwapchain(&ci, &mSwapchains[k]);
             if (Failed(ppxres)) {
@@ -245,12 +527,33 @@ Result Application::CreateSwapchains()
         ci.height          = GetUIHeight();
         ci.arrayLayerCount = 1;                      // UI has its own separate swapchain
         ci.depthFormat     = grfx::FORMAT_UNDEFINED; // UI does not use depth.
+        ci.xrFoveation     = false;
         Result ppxres      = mDevice->CreateSwapchain(&ci, &mSwapchains[mUISwapchainIndex]);
         if (Failed(ppxres)) {
             PPX_ASSERT_MSG(false, "grfx::Device::CreateSwapchain failed");
             return ppxres;
         }
 
+        // Motion vectors and depth for space warp, one per projection swapchain
+        mSpaceWarpSwapchainIndex.reset();
+        if (mXrComponent.IsSpaceWarpSupported()) {
+            mSpaceWarpSwapchainIndex = static_cast<uint32_t>(numSwapChains);
+            ci.width                 = mXrComponent.GetSpaceWarpWidth();
+            ci.height                = mXrComponent.GetSpaceWarpHeight();
+            ci.colorFormat           = mXrComponent.GetMotionVectorFormat();
+            ci.depthFormat           = mXrComponent.GetDepthFormat();
+            ci.arrayLayerCount       = (mXrComponent.IsMultiView() ? viewCount : 1);
+            ci.xrSpaceWarp           = true;
+            mSwapchains.resize(numSwapChains + (numSwapChains - 1));
+            for (size_t k = *mSpaceWarpSwapchainIndex; k < mSwapchains.size(); ++k) {
+                ppxres = mDevice->CreateSwapchain(&ci, &mSwapchains[k]);
+                if (Failed(ppxres)) {
+                    PPX_ASSERT_MSG(false, "grfx::Device::CreateSwapchain failed");
+                    return ppxres;
+                }
+            }
+        }
+
         // Image count is from xrEnumerateSwapchainImages
         mSettings.grfx.swapchain.imageCount = mSwapchains[0]->GetImageCount();
     }
@@ -300,12 +603,15 @@ Result Application::CreateSwapchains()
         grfx::SwapchainCreateInfo ci = {};
         ci.pQueue                    = mDevice->GetGraphicsQueue();
         ci.pSurface                  = mSurface;
+        ci.pOldSwapchain             = pOldSwapchain;
         ci.width                     = mSettings.window.width;
         ci.height                    = mSettings.window.height;
         ci.colorFormat               = mSettings.grfx.swapchain.colorFormat;
         ci.depthFormat               = mSettings.grfx.swapchain.depthFormat;
         ci.imageCount                = mSettings.grfx.swapchain.imageCount;
-        ci.presentMode               = grfx::PRESENT_MODE_IMMEDIATE;
+        ci.presentMode               = mSettings.grfx.swapchain.presentMode;
+        ci.maxFrameLatency           = mSettings.grfx.swapchain.maxFrameLatency;
+        ci.transientDepthImages      = mSettings.grfx.swapchain.transientDepth;
 
         grfx::SwapchainPtr swapchain;
         Result             ppxres = mDevice->CreateSwapchain(&ci, &swapchain);
@@ -330,29 +636,96 @@ void Application::DestroySwapchains()
         sc.Reset();
     }
     mSwapchains.clear();
+
+    DestroyRetiredSwapchains(true);
+}
+
+Result Application::RecreateSwapchains()
+{
+    // XR swapchains aren't tied to the window surface
+    if (mSwapchains.size() != 1) {
+        DestroySwapchains();
+        return CreateSwapchains();
+    }
+    grfx::SwapchainPtr oldSwapchain = mSwapchains[0];
+
+    // Hands the old swapchain over instead of waiting for the device to idle
+    mSwapchains.clear();
+    Result ppxres = CreateSwapchains(oldSwapchain);
+    if (Failed(ppxres)) {
+        mSwapchains.push_back(oldSwapchain);
+        return ppxres;
+    }
+
+    // A submit without command buffers signals once all previous work on the queue has completed
+    RetiredSwapchain retired = {};
+    retired.swapchain        = oldSwapchain;
+    retired.lastFrame        = mFrameCount + oldSwapchain->GetImageCount();
+
+    grfx::FenceCreateInfo fenceCreateInfo = {};
+    ppxres                                = mDevice->CreateFence(&fenceCreateInfo, &retired.fence);
+    if (Failed(ppxres)) {
+        mDevice->WaitIdle();
+        mDevice->DestroySwapchain(oldSwapchain);
+        return ppx::SUCCESS;
+    }
+
+    grfx::SubmitInfo submitInfo = {};
+    submitInfo.pFence           = retired.fence;
+    ppxres                      = mDevice->GetGraphicsQueue()->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        mDevice->WaitIdle();
+        mDevice->DestroyFence(retired.fence);
+        mDevice->DestroySwapchain(oldSwapchain);
+        return ppx::SUCCESS;
+    }
+
+    mRetiredSwapchains.push_back(retired);
+    return ppx::SUCCESS;
+}
+
+void Application::DestroyRetiredSwapchains(bool force)
+{
+    for (auto it = mRetiredSwapchains.begin(); it != mRetiredSwapchains.end();) {
+        if (!force && ((mFrameCount <= it->lastFrame) || !it->fence->IsSignaled())) {
+            ++it;
+            continue;
+        }
+        if (force) {
+            it->fence->Wait();
+        }
+        mDevice->DestroySwapchain(it->swapchain);
+        mDevice->DestroyFence(it->fence);
+        it = mRetiredSwapchains.erase(it);
+    }
 }
 
 Result Application::InitializeImGui()
 {
-    switch (mSettings.grfx.api) {
-        default: {
-            PPX_ASSERT_MSG(false, "[imgui] unknown graphics API");
-            return ppx::ERROR_UNSUPPORTED_API;
-        } break;
+    if (mSettings.grfx.enableGrfxImGui) {
+        mImGui = std::unique_ptr<ImGuiImpl>(new ImGuiImplGrfx());
+    }
+    else {
+        switch (mSettings.grfx.api) {
+            default: {
+                PPX_ASSERT_MSG(false, "[imgui] unknown graphics API");
+                return ppx::ERROR_UNSUPPORTED_API;
+            } break;
 
 #if defined(PPX_D3D12)
-        case grfx::API_DX_12_0:
-        case grfx::API_DX_12_1: {
-            mImGui = std::unique_ptr<ImGuiImpl>(new ImGuiImplDx12());
-        } break;
+            case grfx::API_DX_12_0:
+            case grfx::API_DX_12_1: {
+                mImGui = std::unique_ptr<ImGuiImpl>(new ImGuiImplDx12());
+            } break;
 #endif // defined(PPX_D3D12)
 
 #if defined(PPX_VULKAN)
-        case grfx::API_VK_1_1:
-        case grfx::API_VK_1_2: {
-            mImGui = std::unique_ptr<ImGuiImpl>(new ImGuiImplVk());
-        } break;
+            case grfx::API_VK_1_1:
+            case grfx::API_VK_1_2: {
+                mImGui = std::unique_ptr<ImGuiImpl>(new ImGuiImplVk());
+            } break;
 #endif // defined(PPX_VULKAN)
+        }
     }
 
     if (mImGui) {
@@ -385,7 +758,23 @@ void Application::ShutdownGrfx()
     if (mInstance) {
         DestroySwapchains();
 
+        if (mSecondaryDevice) {
+            mInstance->DestroyDevice(mSecondaryDevice);
+            mSecondaryDevice.Reset();
+        }
+
         if (mDevice) {
+            if (mGpuProfiler) {
+                mDevice->DestroyGpuProfiler(mGpuProfiler);
+                mGpuProfiler.Reset();
+            }
+            if (mDynamicResolution) {
+                mDevice->DestroyDynamicResolution(mDynamicResolution);
+                mDynamicResolution.Reset();
+            }
+            DestroyFrameTimelines();
+            mShaderHotReload.Shutdown();
+            mShaderCompiler.Shutdown();
             mInstance->DestroyDevice(mDevice);
             mDevice.Reset();
         }
@@ -435,6 +824,15 @@ void Application::DispatchInitKnobs()
 
 void Application::DispatchSetup()
 {
+    // Opened before the metrics runs start, which record the thermal status.
+    // The hint session is for the thread that renders, this one.
+    if (mStandardOpts.pPerformanceHints->GetValue()) {
+        const uint32_t frameRate = (mSettings.grfx.pacedFrameRate > 0) ? mSettings.grfx.pacedFrameRate : 60;
+        if (Success(mPerformanceHints.Open(1000000000ull / frameRate))) {
+            PPX_LOG_INFO("Performance hints: hint session " << (mPerformanceHints.HasHintSession() ? "on" : "off") << ", thermal status " << (mPerformanceHints.HasThermalStatus() ? "on" : "off"));
+        }
+    }
+
     SetupMetrics();
     Setup();
 }
@@ -445,10 +843,21 @@ void Application::DispatchShutdown()
 
     ShutdownMetrics();
     SaveMetricsReportToDisk();
+    SaveTraceToDisk();
 
     PPX_LOG_INFO("Number of frames drawn: " << GetFrameCount());
     PPX_LOG_INFO("Average frame time:     " << GetAverageFrameTime() << " ms");
     PPX_LOG_INFO("Average FPS:            " << GetAverageFPS());
+
+    // Without GPU waits the CPU is the bottleneck and the GPU could go
+    // faster, with them the measured FPS is the GPU bound throughput
+    if (mStandardOpts.pFreeRunning->GetValue() && (mFrameCount > 0)) {
+        const double cpuBusyTime = std::max(mTotalFrameTime - mTotalGpuWaitTime, 0.0);
+        const double gpuWaitTime = mTotalGpuWaitTime / mFrameCount;
+        PPX_LOG_INFO("Average GPU wait time:  " << gpuWaitTime << " ms");
+        PPX_LOG_INFO("CPU bound FPS:          " << ((cpuBusyTime > 0) ? (1000.0 * mFrameCount / cpuBusyTime) : 0.0));
+        PPX_LOG_INFO("Bottleneck:             " << ((mTotalGpuWaitTime > 0.01 * mTotalFrameTime) ? "GPU" : "CPU"));
+    }
 }
 
 void Application::DispatchMove(int32_t x, int32_t y)
@@ -503,9 +912,16 @@ void Application::DispatchScroll(float dx, float dy)
 
 void Application::DispatchRender()
 {
+    PPX_PROFILE_SCOPE("Application::Render");
     Render();
 }
 
+void Application::DispatchUpdate(uint32_t packetIndex)
+{
+    PPX_PROFILE_SCOPE("Application::Update");
+    Update(packetIndex);
+}
+
 void Application::DispatchUpdateMetrics()
 {
     // NOTE: This function is dispatched once per frame for both recorded AND displayed
@@ -526,6 +942,17 @@ void Application::SetupMetrics()
         return;
     }
 
+    const uint32_t streamPort = mStandardOpts.pMetricsStreamPort->GetValue();
+    if ((streamPort > 0) && Success(mMetrics.stream.Start(static_cast<uint16_t>(streamPort)))) {
+        mMetrics.manager.SetStreamServer(&mMetrics.stream);
+    }
+
+    // With --benchmark-repetitions or --sweep-path the runs are started and
+    // stopped by UpdateBenchmarkRepetitions(), after each warmup
+    if (SetupBenchmark()) {
+        return;
+    }
+
     // Default behavior for this function is to start a single run at setup, and stop it at shutdown.
     // This enables all applications to get a minimum of functionality from enabling metrics.
     StartMetricsRun("Default Run");
@@ -537,7 +964,13 @@ void Application::ShutdownMetrics()
         return;
     }
 
-    StopMetricsRun();
+    // Benchmark repetitions may all be complete
+    if (mMetrics.manager.HasActiveRun()) {
+        StopMetricsRun();
+    }
+
+    mMetrics.manager.SetStreamServer(nullptr);
+    mMetrics.stream.Stop();
 }
 
 metrics::GaugeBasicStatistics Application::GetGaugeBasicStatistics(metrics::MetricID id) const
@@ -560,10 +993,61 @@ void Application::SaveMetricsReportToDisk()
     // Ensure the needed knobs were initialized by the KnobManager.
     PPX_ASSERT_MSG(mStandardOpts.pMetricsFilename != nullptr, "The --metrics-filename knob was not initialized.");
     PPX_ASSERT_MSG(mStandardOpts.pOverwriteMetricsFile != nullptr, "The --overwrite-metrics-file knob was not initialized.");
+    PPX_ASSERT_MSG(mStandardOpts.pMetricsFormat != nullptr, "The --metrics-format knob was not initialized.");
+    PPX_ASSERT_MSG(mStandardOpts.pMetricsResultsStore != nullptr, "The --metrics-results-store knob was not initialized.");
+
+    if (mDevice) {
+        metrics::DeviceFingerprint device = {};
+        device.gpu                        = mDevice->GetDeviceName();
+        device.driver                     = mDevice->GetGpu()->GetDriverVersion();
+        device.api                        = ToString(mSettings.grfx.api);
+        device.width                      = GetWindowWidth();
+        device.height                     = GetWindowHeight();
+        mMetrics.manager.SetDeviceFingerprint(device);
+    }
 
     // Export the report from the metrics manager to the disk.
-    auto report = mMetrics.manager.CreateReport(mStandardOpts.pMetricsFilename->GetValue());
+    const metrics::ReportFormat format = (mStandardOpts.pMetricsFormat->GetValue() == "binary") ? metrics::ReportFormat::BINARY : metrics::ReportFormat::JSON;
+    auto                        report = mMetrics.manager.CreateReport(mStandardOpts.pMetricsFilename->GetValue(), format);
     report.WriteToDisk(mStandardOpts.pOverwriteMetricsFile->GetValue());
+
+    if (!mStandardOpts.pMetricsResultsStore->GetValue().empty()) {
+        report.AppendToResultsStore(mStandardOpts.pMetricsResultsStore->GetValue());
+    }
+}
+
+void Application::UpdateTrace()
+{
+    if (!Profiler::IsTracing() || !mGpuProfiler || (mGpuProfiler->GetScopesFrameNumber() == mTraceGpuScopesFrameNumber)) {
+        return;
+    }
+
+    const uint64_t frameTimestamp = mGpuProfiler->GetScopesCpuTimestamp();
+    for (const auto& scope : mGpuProfiler->GetScopes()) {
+        const uint64_t start = frameTimestamp + static_cast<uint64_t>(scope.startMs * PPX_TIMER_MILLIS_TO_NANOS);
+        const uint64_t end   = start + static_cast<uint64_t>(scope.gpuMs * PPX_TIMER_MILLIS_TO_NANOS);
+        Profiler::RecordTraceGpuScope(scope.path, start, end);
+    }
+    mTraceGpuScopesFrameNumber = mGpuProfiler->GetScopesFrameNumber();
+}
+
+void Application::SaveTraceToDisk()
+{
+    PPX_ASSERT_MSG(mStandardOpts.pTracePath != nullptr, "The --trace-path knob was not initialized.");
+    if (!Profiler::IsTracing()) {
+        return;
+    }
+    Profiler::StopTrace();
+
+    std::filesystem::path tracePath = ppx::fs::GetFullPath(mStandardOpts.pTracePath->GetValue(), ppx::fs::GetDefaultOutputDirectory());
+    std::filesystem::create_directories(tracePath.parent_path());
+    std::ofstream outputFile(tracePath, std::ofstream::out);
+    if (!outputFile.is_open()) {
+        PPX_LOG_ERROR("Failed to open trace file at path [" << tracePath << "] for writing!");
+        return;
+    }
+    Profiler::WriteTrace(outputFile);
+    PPX_LOG_INFO("Profiler trace written to path [" << tracePath << "]");
 }
 
 void Application::InitStandardKnobs()
@@ -574,6 +1058,11 @@ void Application::InitStandardKnobs()
         "Add a path before the default assets folder in the search list.");
     mStandardOpts.pAssetsPaths->SetFlagParameters("<path>");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pAssetPacks, "asset-pack", mSettings.standardKnobsDefaultValue.assetPacks);
+    mStandardOpts.pAssetPacks->SetFlagDescription(
+        "Load assets from a pack written by tools/pack_assets.py before searching the assets folders.");
+    mStandardOpts.pAssetPacks->SetFlagParameters("<path>");
+
     GetKnobManager().InitKnob(&mStandardOpts.pConfigJsonPaths, mCommandLineParser.GetJsonConfigFlagName(), mSettings.standardKnobsDefaultValue.configJsonPaths);
     mStandardOpts.pConfigJsonPaths->SetFlagDescription(
         "Additional commandline flags specified in a JSON file. Values specified in JSON files are "
@@ -581,6 +1070,30 @@ void Application::InitStandardKnobs()
         "later ones take priority.");
     mStandardOpts.pConfigJsonPaths->SetFlagParameters("<path>");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pBenchmarkRepetitions, "benchmark-repetitions", mSettings.standardKnobsDefaultValue.benchmarkRepetitions, 0, UINT32_MAX);
+    mStandardOpts.pBenchmarkRepetitions->SetFlagDescription(
+        "If metrics are enabled, run the benchmark N times as separate metrics runs "
+        "after `--benchmark-warmup-frames`, then shutdown. The report summarizes "
+        "the median of each gauge over the repetitions, with outliers rejected "
+        "and a bootstrap confidence interval of the mean. If 0, this is disabled "
+        "and the whole application is a single run. "
+        "See also `--enable-metrics` and `--benchmark-repetition-frames`.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pBenchmarkRepetitionFrames, "benchmark-repetition-frames", mSettings.standardKnobsDefaultValue.benchmarkRepetitionFrames, 1, UINT32_MAX);
+    mStandardOpts.pBenchmarkRepetitionFrames->SetFlagDescription(
+        "Number of frames of each run of `--benchmark-repetitions`.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pBenchmarkWarmupFrames, "benchmark-warmup-frames", mSettings.standardKnobsDefaultValue.benchmarkWarmupFrames, 0, UINT32_MAX);
+    mStandardOpts.pBenchmarkWarmupFrames->SetFlagDescription(
+        "Number of frames rendered without recording metrics before the first "
+        "run of `--benchmark-repetitions`, so caches and clocks settle.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pCoalesceMouseMoves, "coalesce-mouse-moves", mSettings.standardKnobsDefaultValue.coalesceMouseMoves);
+    mStandardOpts.pCoalesceMouseMoves->SetFlagDescription(
+        "Dispatch the mouse moves of each frame as one MouseMove() event with "
+        "the sum of their deltas, instead of one per window event. Moves are "
+        "still dispatched before the button and key events that follow them.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pDeterministic, "deterministic", mSettings.standardKnobsDefaultValue.deterministic);
     mStandardOpts.pDeterministic->SetFlagDescription(
         "Disable non-deterministic behaviors, like clocks and ImGui.");
@@ -589,20 +1102,49 @@ void Application::InitStandardKnobs()
     mStandardOpts.pEnableMetrics->SetFlagDescription(
         "Enable metrics report output. See also: `--metrics-filename` and `--overwrite-metrics-file`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pFrameBudgetMs, "frame-budget-ms", mSettings.standardKnobsDefaultValue.frameBudgetMs, 0.1f, 10000.0f);
+    mStandardOpts.pFrameBudgetMs->SetFlagDescription(
+        "If metrics are enabled, frames with a CPU frame time over this budget are "
+        "counted as hitches in `frames_over_budget` and `slow_frame_streak`. "
+        "See also `--enable-metrics`.");
+    mStandardOpts.pFrameBudgetMs->SetFlagParameters("<ms>");
+
     GetKnobManager().InitKnob(&mStandardOpts.pFrameCount, "frame-count", mSettings.standardKnobsDefaultValue.frameCount, 0, UINT64_MAX);
     mStandardOpts.pFrameCount->SetFlagDescription(
         "Shutdown the application after successfully rendering N frames. "
         "If 0, this is disabled.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pFreeRunning, "free-running", mSettings.standardKnobsDefaultValue.freeRunning);
+    mStandardOpts.pFreeRunning->SetFlagDescription(
+        "Render offscreen as fast as possible for throughput benchmarks. Implies "
+        "`--headless`, disables frame pacing and reports CPU and GPU bound "
+        "throughput on exit.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pGpuIndex, "gpu", mSettings.standardKnobsDefaultValue.gpuIndex, 0, UINT_MAX);
     mStandardOpts.pGpuIndex->SetFlagDescription(
         "Select the gpu with the given index. To determine the set of valid "
         "indices use `--list-gpus`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pSecondaryGpuIndex, "secondary-gpu", mSettings.standardKnobsDefaultValue.secondaryGpuIndex, 0, UINT_MAX);
+    mStandardOpts.pSecondaryGpuIndex->SetFlagDescription(
+        "Select the gpu of the secondary device by index, for applications "
+        "that enable one. Must differ from `--gpu`.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pHeadless, "headless", mSettings.standardKnobsDefaultValue.headless);
     mStandardOpts.pHeadless->SetFlagDescription(
         "Run the sample without creating windows.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pLateInputPoll, "late-input-poll", mSettings.standardKnobsDefaultValue.lateInputPoll);
+    mStandardOpts.pLateInputPoll->SetFlagDescription(
+        "Let apps sample mouse input again with PollLateInput() right before "
+        "they write the camera matrices for submission, which lowers the "
+        "latency of camera control. Not available with pipelined updates or XR.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pLogAsync, "log-async", mSettings.standardKnobsDefaultValue.logAsync);
+    mStandardOpts.pLogAsync->SetFlagDescription(
+        "Write log messages on a background thread instead of the thread that "
+        "logs them. Messages can show up a few milliseconds late.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pListGpus, "list-gpus", mSettings.standardKnobsDefaultValue.listGpus);
     mStandardOpts.pListGpus->SetFlagDescription(
         "Prints a list of the available GPUs on the current system with their "
@@ -616,12 +1158,109 @@ void Application::InitStandardKnobs()
         "If not a full path, will be defined relative to the default "
         "output directory. See also `--enable-metrics` and `--overwrite-metrics-file`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsFormat, "metrics-format", mSettings.standardKnobsDefaultValue.metricsFormat);
+    mStandardOpts.pMetricsFormat->SetFlagDescription(
+        "If metrics are enabled, the format of the metrics report. `binary` stores "
+        "gauge time series as delta encoded columns, which is much smaller and "
+        "faster to write on long runs. Use tools/metrics_report.py to read or "
+        "convert binary reports. See also `--enable-metrics`.");
+    mStandardOpts.pMetricsFormat->SetFlagParameters("<json|binary>");
+    mStandardOpts.pMetricsFormat->SetValidator([](const std::string& res) {
+        return res == "json" || res == "binary";
+    });
+
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsResultsStore, "metrics-results-store", mSettings.standardKnobsDefaultValue.metricsResultsStore);
+    mStandardOpts.pMetricsResultsStore->SetFlagDescription(
+        "If metrics are enabled, also append the benchmark summaries of the report "
+        "and the device fingerprint (GPU, driver, API, resolution) as a line to "
+        "this JSON Lines results store. If not a full path, will be defined "
+        "relative to the default output directory. Compare a report against the "
+        "rolling baseline of its device with `tools/metrics_report.py --store`. "
+        "See also `--enable-metrics` and `--benchmark-repetitions`.");
+    mStandardOpts.pMetricsResultsStore->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsStreamPort, "metrics-stream-port", mSettings.standardKnobsDefaultValue.metricsStreamPort, 0, UINT16_MAX);
+    mStandardOpts.pMetricsStreamPort->SetFlagDescription(
+        "If metrics are enabled, stream every recorded metric entry live to TCP "
+        "clients connecting to this port, as the binary records described in "
+        "ppx/metrics_stream.h. Linux and Android only. If 0, this is disabled. "
+        "See also `--enable-metrics`.");
+    mStandardOpts.pMetricsStreamPort->SetFlagParameters("<port>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pMetricsStreamingGauges, "metrics-streaming-gauges", mSettings.standardKnobsDefaultValue.metricsStreamingGauges);
+    mStandardOpts.pMetricsStreamingGauges->SetFlagDescription(
+        "If metrics are enabled, gauges keep a quantile sketch and a fixed size "
+        "sample of their entries instead of every entry, so memory stays bounded "
+        "on long runs. Percentiles are then approximate. See also `--enable-metrics`.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pOverwriteMetricsFile, "overwrite-metrics-file", mSettings.standardKnobsDefaultValue.overwriteMetricsFile);
     mStandardOpts.pOverwriteMetricsFile->SetFlagDescription(
         "Only applies if metrics are enabled with `--enable-metrics`. "
         "If an existing file at the path set with `--metrics-filename` is found, it will be overwritten. "
         "See also: `--enable-metrics` and `--metrics-filename`.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pPerfCounters, "perf-counters", mSettings.standardKnobsDefaultValue.perfCounters);
+    mStandardOpts.pPerfCounters->SetFlagDescription(
+        "If metrics are enabled, record the CPU cycles, instructions, cache misses "
+        "and branch misses of each frame as gauges. Linux and Android only, the "
+        "kernel's perf_event_paranoid setting must allow user space counters. "
+        "See also `--enable-metrics`.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pPerformanceHints, "performance-hints", mSettings.standardKnobsDefaultValue.performanceHints);
+    mStandardOpts.pPerformanceHints->SetFlagDescription(
+        "Android only. Report the main thread's work duration of each frame to the "
+        "Android Dynamic Performance Framework, and if metrics are enabled record "
+        "the device's thermal status and headroom as gauges. Runs that were "
+        "thermally throttled are flagged with a warning. "
+        "See also `--enable-metrics`.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pShaderHotReload, "shader-hot-reload", mSettings.standardKnobsDefaultValue.shaderHotReload);
+    mStandardOpts.pShaderHotReload->SetFlagDescription(
+        "Watch the shader files loaded from the asset directories and rebuild "
+        "the pipelines registered with WatchShaders() when they're recompiled.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pShaderCompilerPath, "shader-compiler-path", mSettings.standardKnobsDefaultValue.shaderCompilerPath);
+    mStandardOpts.pShaderCompilerPath->SetFlagDescription(
+        "Path to a DXC executable used to compile shaders at runtime: shaders "
+        "whose precompiled bytecode isn't found are compiled from their HLSL "
+        "source, and so are the variants created with defines. If empty, only "
+        "precompiled shaders can be created. See also `--shader-cache-path`.");
+    mStandardOpts.pShaderCompilerPath->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pShaderCachePath, "shader-cache-path", mSettings.standardKnobsDefaultValue.shaderCachePath);
+    mStandardOpts.pShaderCachePath->SetFlagDescription(
+        "Directory the shaders compiled at runtime are saved to and loaded "
+        "from on later runs, keyed by their source and defines. If not a full "
+        "path, will be defined relative to the default output directory. If "
+        "empty, compiled shaders are not cached across runs.");
+    mStandardOpts.pShaderCachePath->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pPipelineCachePath, "pipeline-cache-path", mSettings.standardKnobsDefaultValue.pipelineCachePath);
+    mStandardOpts.pPipelineCachePath->SetFlagDescription(
+        "Load the pipeline cache from this file at startup and save it back on "
+        "exit. Data written by a different GPU or driver is ignored. If not a "
+        "full path, will be defined relative to the default output directory. "
+        "If empty, pipelines are not cached across runs.");
+    mStandardOpts.pPipelineCachePath->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pPipelineManifestPath, "pipeline-manifest-path", mSettings.standardKnobsDefaultValue.pipelineManifestPath);
+    mStandardOpts.pPipelineManifestPath->SetFlagDescription(
+        "Record the pipelines the application creates to this file and save it "
+        "on exit. A manifest of an earlier run is loaded at startup, see "
+        "`--precompile-pipelines`. If not a full path, will be defined relative "
+        "to the default output directory. Use with `--pipeline-cache-path`.");
+    mStandardOpts.pPipelineManifestPath->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pPrecompilePipelines, "precompile-pipelines", mSettings.standardKnobsDefaultValue.precompilePipelines);
+    mStandardOpts.pPrecompilePipelines->SetFlagDescription(
+        "Compile every pipeline of the manifest loaded from `--pipeline-manifest-path` "
+        "before Setup(), so they're in the pipeline cache before the first frame.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pRawMouseMotion, "raw-mouse-motion", mSettings.standardKnobsDefaultValue.rawMouseMotion);
+    mStandardOpts.pRawMouseMotion->SetFlagDescription(
+        "Report unaccelerated mouse motion while an app captures the cursor, "
+        "e.g. for mouse look, on platforms that support it.");
+
     GetKnobManager().InitKnob(&mStandardOpts.pResolution, "resolution", mSettings.standardKnobsDefaultValue.resolution);
     mStandardOpts.pResolution->SetFlagDescription(
         "Specify the main window resolution in pixels. Width and Height must be "
@@ -642,8 +1281,14 @@ void Application::InitStandardKnobs()
 
     GetKnobManager().InitKnob(&mStandardOpts.pScreenshotFrameNumber, "screenshot-frame-number", mSettings.standardKnobsDefaultValue.screenshotFrameNumber, -1, INT_MAX);
     mStandardOpts.pScreenshotFrameNumber->SetFlagDescription(
-        "Take a screenshot of frame number N and save it in PPM format. See also "
-        "`--screenshot-path`.");
+        "Take a screenshot of frame number N and save it in PPM format, or PNG or QOI "
+        "if the path ends with `.png` or `.qoi`. See also `--screenshot-path`.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pScreenshotFrameInterval, "screenshot-frame-interval", mSettings.standardKnobsDefaultValue.screenshotFrameInterval, 0, INT_MAX);
+    mStandardOpts.pScreenshotFrameInterval->SetFlagDescription(
+        "Take a screenshot every N frames, starting at `--screenshot-frame-number` or "
+        "frame 0 if it isn't set. Screenshots are read back and written without "
+        "stalling the frame. If 0, this is disabled.");
 
     GetKnobManager().InitKnob(&mStandardOpts.pScreenshotPath, "screenshot-path", mSettings.standardKnobsDefaultValue.screenshotPath);
     mStandardOpts.pScreenshotPath->SetFlagDescription(
@@ -658,6 +1303,40 @@ void Application::InitStandardKnobs()
         "Calculate frame statistics over the last N frames only. If 0, "
         "all frames since the beginning of the application will be used.");
 
+    GetKnobManager().InitKnob(&mStandardOpts.pSweepPath, "sweep-path", mSettings.standardKnobsDefaultValue.sweepPath);
+    mStandardOpts.pSweepPath->SetFlagDescription(
+        "If metrics are enabled, benchmark each point of the knob sweep described "
+        "by this JSON file in turn, without restarting, then shutdown. The file has "
+        "\"points\", a list of knob value objects, and/or \"cartesian\", an object "
+        "of knob value lists to combine. \"warmup_frames\", \"repetition_frames\" "
+        "and \"repetitions\" override the `--benchmark-*` knobs, with at least one "
+        "repetition per point. The report has a \"sweep\" summary of each point. "
+        "See also `--enable-metrics` and `--benchmark-repetitions`.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pThreadAffinity, "thread-affinity", mSettings.standardKnobsDefaultValue.threadAffinity);
+    mStandardOpts.pThreadAffinity->SetFlagDescription(
+        "Cores each thread role runs on, as role=cores pairs separated by ';'. "
+        "Roles are render, game, loader and jobs. Cores are any, big, little "
+        "or a CPU list, e.g. \"render=big;jobs=0-3,6\". big and little are the "
+        "cores with the highest and lowest max frequency, and mean any core "
+        "on CPUs whose cores are all alike.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pThreadPriority, "thread-priority", mSettings.standardKnobsDefaultValue.threadPriority);
+    mStandardOpts.pThreadPriority->SetFlagDescription(
+        "Scheduling priority of each thread role, as role=priority pairs "
+        "separated by ';', e.g. \"render=urgent;loader=low\". Priorities are "
+        "default, low, high and urgent. Raising priorities needs CAP_SYS_NICE "
+        "on desktop Linux. See also `--thread-affinity`.");
+    mStandardOpts.pSweepPath->SetFlagParameters("<path>");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pTracePath, "trace-path", mSettings.standardKnobsDefaultValue.tracePath);
+    mStandardOpts.pTracePath->SetFlagDescription(
+        "Record the profiler samples, GPU profiler scopes and frame markers of the "
+        "whole run and save them to this path on exit, as Chrome trace JSON that "
+        "chrome://tracing and ui.perfetto.dev open. If not a full path, will be "
+        "defined relative to the default output directory. If empty, this is disabled.");
+    mStandardOpts.pTracePath->SetFlagParameters("<path>");
+
     GetKnobManager().InitKnob(&mStandardOpts.pUseSoftwareRenderer, "use-software-renderer", mSettings.standardKnobsDefaultValue.useSoftwareRenderer);
     mStandardOpts.pUseSoftwareRenderer->SetFlagDescription(
         "Use a software renderer instead of a hardware device, if available.");
@@ -666,6 +1345,14 @@ void Application::InitStandardKnobs()
         return useSoftwareRenderer ? gpuIndex == 0 : true;
     });
 
+    GetKnobManager().InitKnob(&mStandardOpts.pVideoCapturePath, "video-capture-path", mSettings.standardKnobsDefaultValue.videoCapturePath);
+    mStandardOpts.pVideoCapturePath->SetFlagDescription(
+        "Record every frame to this path as uncompressed YUV4MPEG2 (.y4m) video. "
+        "Frames are read back and written without stalling the frame. "
+        "If not a full path, will be defined relative to the default output directory. "
+        "If empty, this is disabled.");
+    mStandardOpts.pVideoCapturePath->SetFlagParameters("<path>");
+
 #if defined(PPX_BUILD_XR)
     GetKnobManager().InitKnob(&mStandardOpts.pXrUiResolution, "xr-ui-resolution", mSettings.standardKnobsDefaultValue.xrUiResolution);
     mStandardOpts.pXrUiResolution->SetFlagDescription(
@@ -686,6 +1373,19 @@ void Application::InitStandardKnobs()
     GetKnobManager().InitKnob(&mStandardOpts.pXrEnableMultiview, "xr-enable-multiview", mSettings.standardKnobsDefaultValue.xrEnableMultiview);
     mStandardOpts.pXrEnableMultiview->SetFlagDescription(
         "Specify whether or not multiview should be enabled for the application.");
+
+    GetKnobManager().InitKnob(&mStandardOpts.pXrFoveationLevel, "xr-foveation-level", mSettings.standardKnobsDefaultValue.xrFoveationLevel);
+    mStandardOpts.pXrFoveationLevel->SetFlagDescription(
+        "Specify the level of the runtime's foveated rendering of the projection swapchains. "
+        "Uses XR_FB_foveation when supported, and enables fragment density map support on the device.");
+    mStandardOpts.pXrFoveationLevel->SetFlagParameters("<none|low|medium|high>");
+    mStandardOpts.pXrFoveationLevel->SetValidator([](const std::string& res) {
+        return res == "none" || res == "low" || res == "medium" || res == "high";
+    });
+
+    GetKnobManager().InitKnob(&mStandardOpts.pXrFoveationDynamic, "xr-foveation-dynamic", mSettings.standardKnobsDefaultValue.xrFoveationDynamic);
+    mStandardOpts.pXrFoveationDynamic->SetFlagDescription(
+        "Specify whether the runtime may lower the foveation level while the GPU keeps up with the display rate.");
 #endif
 
     GetKnobManager().InitKnob(&mStandardOpts.pShadingRateMode, "shading-rate-mode", "");
@@ -748,11 +1448,11 @@ void Application::SaveImage(grfx::ImagePtr image, const std::string& filepath, g
     // Wait for the copy to be finished.
     queue->WaitIdle();
 
-    // Export to PPM.
+    // Export in the format of the file extension.
     unsigned char* texels = nullptr;
     screenshotBuf->MapMemory(0, (void**)&texels);
 
-    PPX_CHECKED_CALL(ExportToPPM(filepath, image->GetFormat(), texels, width, height, outPitch.rowPitch));
+    PPX_CHECKED_CALL(WriteImageFile(filepath, image->GetFormat(), texels, width, height, outPitch.rowPitch));
 
     screenshotBuf->UnmapMemory();
 
@@ -768,18 +1468,59 @@ void Application::TakeScreenshot()
 
     auto swapchainImg = GetSwapchain()->GetColorImage(GetSwapchain()->GetCurrentImageIndex());
 
-    SaveImage(swapchainImg, screenshotPath.string(), grfx::RESOURCE_STATE_PRESENT);
+    // The copy is queued behind the frame and written out a few frames later
+    if (!mScreenshotReadback.IsInitialized()) {
+        ImageReadbackCreateInfo createInfo = {};
+        createInfo.pQueue                  = mDevice->GetGraphicsQueue();
+        PPX_CHECKED_CALL(mScreenshotReadback.Initialize(createInfo));
+    }
+    PPX_CHECKED_CALL(mScreenshotReadback.Capture(swapchainImg, grfx::RESOURCE_STATE_PRESENT, screenshotPath));
+
+    PPX_LOG_INFO("Screenshot of frame " << mFrameCount << " queued for: " << screenshotPath.string());
+}
+
+void Application::CaptureVideoFrame()
+{
+    auto swapchainImg = GetSwapchain()->GetColorImage(GetSwapchain()->GetCurrentImageIndex());
+
+    if (!mVideoReadback.IsInitialized()) {
+        std::filesystem::path videoPath = ppx::fs::GetFullPath(mStandardOpts.pVideoCapturePath->GetValue(), ppx::fs::GetDefaultOutputDirectory());
+
+        // The recorded rate is nominal, frames are written as they are rendered
+        const uint32_t frameRate = (mSettings.grfx.pacedFrameRate > 0) ? mSettings.grfx.pacedFrameRate : 60;
+        PPX_CHECKED_CALL(mVideoWriter.Open(videoPath, swapchainImg->GetWidth(), swapchainImg->GetHeight(), frameRate));
+
+        // Deeper than the screenshot ring so writing can fall behind for a few frames
+        ImageReadbackCreateInfo createInfo = {};
+        createInfo.pQueue                  = mDevice->GetGraphicsQueue();
+        createInfo.slotCount               = 6;
+        createInfo.ordered                 = true;
+        PPX_CHECKED_CALL(mVideoReadback.Initialize(createInfo));
 
-    PPX_LOG_INFO("Screenshot of frame " << mFrameCount << " saved to: " << screenshotPath.string());
+        PPX_LOG_INFO("Recording video to: " << videoPath.string());
+    }
+
+    PPX_CHECKED_CALL(mVideoReadback.Capture(swapchainImg, grfx::RESOURCE_STATE_PRESENT, "video frame " + std::to_string(mFrameCount), [this](const ImageReadbackData& data) {
+        // Ordered callbacks run one at a time, so the writer needs no lock
+        return mVideoWriter.WriteFrame(data.format, data.pTexels, data.width, data.height, data.rowPitch);
+    }));
 }
 
 void Application::MoveCallback(int32_t x, int32_t y)
 {
+    if (DeferInputEvent([=]() { MoveCallback(x, y); })) {
+        return;
+    }
+
     Move(x, y);
 }
 
 void Application::ResizeCallback(uint32_t width, uint32_t height)
 {
+    if (DeferInputEvent([=]() { ResizeCallback(width, height); })) {
+        return;
+    }
+
     bool widthChanged  = (width != mSettings.window.width);
     bool heightChanged = (height != mSettings.window.height);
     if (widthChanged || heightChanged) {
@@ -814,16 +1555,21 @@ void Application::ResizeCallback(uint32_t width, uint32_t height)
             }
             // Vulkan swapchain needs recreation
             else {
-                // This function will wait for device to idle
-                DestroySwapchains();
-
-                auto ppxres = CreateSwapchains();
+                auto ppxres = RecreateSwapchains();
                 if (Failed(ppxres)) {
                     PPX_ASSERT_MSG(false, "Vulkan swapchain recreate failed");
                     // Signal the app to quit if swapchain recreation fails
                     mWindow->Quit();
                 }
             }
+
+            if (mDynamicResolution) {
+                auto ppxres = mDynamicResolution->Resize(GetSwapchain()->GetWidth(), GetSwapchain()->GetHeight());
+                if (Failed(ppxres)) {
+                    PPX_ASSERT_MSG(false, "dynamic resolution resize failed");
+                    mWindow->Quit();
+                }
+            }
         }
 
         // Dispatch resize event
@@ -833,18 +1579,30 @@ void Application::ResizeCallback(uint32_t width, uint32_t height)
 
 void Application::WindowIconifyCallback(bool iconified)
 {
-    mWindow->SetState(iconified ? WINDOW_STATE_ICONIFIED : WINDOW_STATE_RESTORED);
-    DispatchWindowIconify(iconified);
+    if (DeferInputEvent([=]() { WindowIconifyCallback(iconified); })) {
+        return;
+    }
+
+    mWindow->SetState(iconified ? WINDOW_STATE_ICONIFIED : WINDOW_STATE_RESTORED);
+    DispatchWindowIconify(iconified);
 }
 
 void Application::WindowMaximizeCallback(bool maximized)
 {
+    if (DeferInputEvent([=]() { WindowMaximizeCallback(maximized); })) {
+        return;
+    }
+
     mWindow->SetState(maximized ? WINDOW_STATE_MAXIMIZED : WINDOW_STATE_RESTORED);
     DispatchWindowMaximize(maximized);
 }
 
 void Application::KeyDownCallback(KeyCode key)
 {
+    if (DeferInputEvent([=]() { KeyDownCallback(key); })) {
+        return;
+    }
+
     if (mSettings.enableImGui && ImGui::GetIO().WantCaptureKeyboard) {
         return;
     }
@@ -856,6 +1614,10 @@ void Application::KeyDownCallback(KeyCode key)
 
 void Application::KeyUpCallback(KeyCode key)
 {
+    if (DeferInputEvent([=]() { KeyUpCallback(key); })) {
+        return;
+    }
+
     if (mSettings.enableImGui && ImGui::GetIO().WantCaptureKeyboard) {
         return;
     }
@@ -871,15 +1633,74 @@ void Application::MouseMoveCallback(int32_t x, int32_t y, uint32_t buttons)
         return;
     }
 
-    int32_t dx = (mPreviousMouseX != INT32_MAX) ? (x - mPreviousMouseX) : 0;
-    int32_t dy = (mPreviousMouseY != INT32_MAX) ? (y - mPreviousMouseY) : 0;
-    DispatchMouseMove(x, y, dx, dy, buttons);
+    int32_t dx      = (mPreviousMouseX != INT32_MAX) ? (x - mPreviousMouseX) : 0;
+    int32_t dy      = (mPreviousMouseY != INT32_MAX) ? (y - mPreviousMouseY) : 0;
     mPreviousMouseX = x;
     mPreviousMouseY = y;
+
+    if (!mStandardOpts.pCoalesceMouseMoves->GetValue() && !mLateInputPolling) {
+        DispatchMouseMove(x, y, dx, dy, buttons);
+        return;
+    }
+
+    // Dispatched by FlushMouseMove()
+    mPendingMouseMove.pending = true;
+    mPendingMouseMove.x       = x;
+    mPendingMouseMove.y       = y;
+    mPendingMouseMove.buttons = buttons;
+
+    mPendingMouseMove.dx += dx;
+    mPendingMouseMove.dy += dy;
+}
+
+bool Application::DeferInputEvent(std::function<void()>&& event)
+{
+    if (mLateInputPolling) {
+        mDeferredInputEvents.push_back(std::move(event));
+        return true;
+    }
+    FlushMouseMove();
+    return false;
+}
+
+void Application::FlushMouseMove()
+{
+    if (!mPendingMouseMove.pending) {
+        return;
+    }
+    mPendingMouseMove.pending = false;
+    DispatchMouseMove(mPendingMouseMove.x, mPendingMouseMove.y, mPendingMouseMove.dx, mPendingMouseMove.dy, mPendingMouseMove.buttons);
+    mPendingMouseMove.dx = 0;
+    mPendingMouseMove.dy = 0;
+}
+
+void Application::SetCursorCaptured(bool captured)
+{
+    if (!mWindow || (captured == mCursorCaptured)) {
+        return;
+    }
+    mWindow->SetCursorCaptured(captured, mStandardOpts.pRawMouseMotion->GetValue());
+    mCursorCaptured = captured;
+}
+
+void Application::PollLateInput()
+{
+    if (!mStandardOpts.pLateInputPoll->GetValue() || mSettings.pipelinedUpdate || IsXrEnabled() || !mWindow) {
+        return;
+    }
+
+    mLateInputPolling = true;
+    mWindow->ProcessEvent();
+    mLateInputPolling = false;
+    FlushMouseMove();
 }
 
 void Application::MouseDownCallback(int32_t x, int32_t y, uint32_t buttons)
 {
+    if (DeferInputEvent([=]() { MouseDownCallback(x, y, buttons); })) {
+        return;
+    }
+
     if (mSettings.enableImGui && ImGui::GetIO().WantCaptureMouse) {
         return;
     }
@@ -889,6 +1710,10 @@ void Application::MouseDownCallback(int32_t x, int32_t y, uint32_t buttons)
 
 void Application::MouseUpCallback(int32_t x, int32_t y, uint32_t buttons)
 {
+    if (DeferInputEvent([=]() { MouseUpCallback(x, y, buttons); })) {
+        return;
+    }
+
     if (mSettings.enableImGui && ImGui::GetIO().WantCaptureMouse) {
         return;
     }
@@ -898,6 +1723,10 @@ void Application::MouseUpCallback(int32_t x, int32_t y, uint32_t buttons)
 
 void Application::ScrollCallback(float dx, float dy)
 {
+    if (DeferInputEvent([=]() { ScrollCallback(dx, dy); })) {
+        return;
+    }
+
     if (mSettings.enableImGui && ImGui::GetIO().WantCaptureMouse) {
         return;
     }
@@ -911,7 +1740,22 @@ void Application::DrawImGui(grfx::CommandBuffer* pCommandBuffer)
         return;
     }
 
+    const double startMs = mTimer.MillisSinceStart();
     mImGui->Render(pCommandBuffer);
+    mUITimeAccumulator += mTimer.MillisSinceStart() - startMs;
+}
+
+bool Application::ShouldRenderUI()
+{
+#if defined(PPX_BUILD_XR)
+    if (IsXrEnabled() && mImGui) {
+        if (!mRenderUIThisFrame.has_value()) {
+            mRenderUIThisFrame = mImGui->PrepareDrawData();
+        }
+        return *mRenderUIThisFrame;
+    }
+#endif
+    return true;
 }
 
 bool Application::IsRunning() const
@@ -923,6 +1767,15 @@ void Application::UpdateStandardSettings()
 {
     mSettings.headless = mStandardOpts.pHeadless->GetValue();
 
+    Log::SetAsync(mStandardOpts.pLogAsync->GetValue());
+
+    // Offscreen images are still cycled through the headless swapchain, but
+    // its acquire and present don't record or submit any work
+    if (mStandardOpts.pFreeRunning->GetValue()) {
+        mSettings.headless            = true;
+        mSettings.grfx.pacedFrameRate = 0;
+    }
+
     // If command line argument provided width and height
     auto       resolution        = mStandardOpts.pResolution->GetValue();
     const bool hasResolutionFlag = (resolution.first > 0 && resolution.second > 0);
@@ -978,6 +1831,8 @@ void Application::InitializeXRComponentBeforeGrfxDeviceInit()
         createInfo.enableQuadLayer      = mSettings.enableImGui;
         createInfo.enableDepthSwapchain = mSettings.xr.enableDepthSwapchain;
         createInfo.enableMultiView      = mStandardOpts.pXrEnableMultiview->GetValue();
+        createInfo.enableSpaceWarp      = mSettings.xr.enableSpaceWarp;
+        createInfo.enableFoveation      = (mStandardOpts.pXrFoveationLevel->GetValue() != "none");
         const auto resolution           = mStandardOpts.pResolution->GetValue();
         const bool hasResolutionFlag    = (resolution.first > 0 && resolution.second > 0);
         if (hasResolutionFlag) {
@@ -989,6 +1844,24 @@ void Application::InitializeXRComponentBeforeGrfxDeviceInit()
         createInfo.requiredExtensions  = mStandardOpts.pXrRequiredExtensions->GetValue();
 
         mXrComponent.InitializeBeforeGrfxDeviceInit(createInfo);
+
+        // The runtime's density maps are bound to the projection render passes
+        if (mXrComponent.IsFoveationSupported()) {
+            if (mSettings.grfx.device.supportShadingRateMode == grfx::SHADING_RATE_VRS) {
+                PPX_LOG_WARN("XR foveation replaces the requested VRS shading rate mode with FDM");
+            }
+            mSettings.grfx.device.supportShadingRateMode = grfx::SHADING_RATE_FDM;
+
+            const std::string  levelString = mStandardOpts.pXrFoveationLevel->GetValue();
+            XrFoveationLevelFB level       = XR_FOVEATION_LEVEL_HIGH_FB;
+            if (levelString == "low") {
+                level = XR_FOVEATION_LEVEL_LOW_FB;
+            }
+            else if (levelString == "medium") {
+                level = XR_FOVEATION_LEVEL_MEDIUM_FB;
+            }
+            mXrComponent.SetFoveation(level, mStandardOpts.pXrFoveationDynamic->GetValue());
+        }
     }
 }
 
@@ -1056,7 +1929,15 @@ void Application::ProcessEvents()
     else
 #endif
     {
+        // Events PollLateInput() deferred happened before the ones polled now
+        std::vector<std::function<void()>> deferredEvents;
+        deferredEvents.swap(mDeferredInputEvents);
+        for (auto& event : deferredEvents) {
+            event();
+        }
+
         mWindow->ProcessEvent();
+        FlushMouseMove();
         if (!IsRunning()) {
             return;
         }
@@ -1068,10 +1949,26 @@ void Application::ProcessEvents()
 
 void Application::RenderFrame()
 {
+    // Wait for the GPU to finish the frame that last used this frame's
+    // in flight resources
+    mPreviousGpuWaitTime = 0;
+    if (mFrameCount >= mSettings.grfx.numFramesInFlight) {
+        const double waitStartMs = mTimer.MillisSinceStart();
+        Result       ppxres      = WaitForFrame(mFrameCount - mSettings.grfx.numFramesInFlight);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "frame pacing wait failed: " << ToString(ppxres));
+        }
+        mPreviousGpuWaitTime = static_cast<float>(mTimer.MillisSinceStart() - waitStartMs);
+    }
+
+    // Swap in rebuilt pipelines before anything is recorded with them
+    mShaderHotReload.Update();
+
 #if defined(PPX_BUILD_XR)
     if (IsXrEnabled()) {
         if (mXrComponent.IsSessionRunning()) {
             mXrComponent.BeginFrame();
+            mRenderUIThisFrame.reset();
             if (mXrComponent.ShouldRender()) {
                 XrSwapchainImageReleaseInfo releaseInfo = {XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
                 uint32_t                    viewCount   = static_cast<uint32_t>(mXrComponent.GetViewCount());
@@ -1089,9 +1986,15 @@ void Application::RenderFrame()
                     if (swapchain->GetXrDepthSwapchain() != XR_NULL_HANDLE) {
                         CHECK_XR_CALL(xrReleaseSwapchainImage(swapchain->GetXrDepthSwapchain(), &releaseInfo));
                     }
+                    if (mSpaceWarpSwapchainIndex.has_value()) {
+                        grfx::SwapchainPtr spaceWarpSwapchain = GetSwapchain(k + *mSpaceWarpSwapchainIndex);
+                        CHECK_XR_CALL(xrReleaseSwapchainImage(spaceWarpSwapchain->GetXrColorSwapchain(), &releaseInfo));
+                        CHECK_XR_CALL(xrReleaseSwapchainImage(spaceWarpSwapchain->GetXrDepthSwapchain(), &releaseInfo));
+                    }
                 }
 
-                if (GetSettings()->enableImGui) {
+                // Without a new image the compositor keeps using the last one
+                if (GetSettings()->enableImGui && mRenderUIThisFrame.value_or(true)) {
                     grfx::SwapchainPtr swapchain = GetSwapchain(mUISwapchainIndex);
                     CHECK_XR_CALL(xrReleaseSwapchainImage(swapchain->GetXrColorSwapchain(), &releaseInfo));
                     if (swapchain->GetXrDepthSwapchain() != XR_NULL_HANDLE) {
@@ -1099,7 +2002,7 @@ void Application::RenderFrame()
                     }
                 }
             }
-            mXrComponent.EndFrame(mSwapchains, 0, mUISwapchainIndex);
+            mXrComponent.EndFrame(mSwapchains, 0, mUISwapchainIndex, mSpaceWarpSwapchainIndex);
         }
     }
     else
@@ -1148,28 +2051,164 @@ void Application::RenderFrame()
     }
 }
 
+void Application::StartGameThread()
+{
+    mGameThread.stop            = false;
+    mGameThread.updateRequested = false;
+    mGameThread.updateRunning   = false;
+    mGameThread.thread          = std::thread(&Application::GameThreadMain, this);
+}
+
+void Application::StopGameThread()
+{
+    if (!mGameThread.thread.joinable()) {
+        return;
+    }
+
+    WaitForUpdate();
+    {
+        std::lock_guard<std::mutex> lock(mGameThread.mutex);
+        mGameThread.stop = true;
+    }
+    mGameThread.condition.notify_all();
+    mGameThread.thread.join();
+}
+
+void Application::GameThreadMain()
+{
+    ApplyThreadPolicy(THREAD_ROLE_GAME);
+
+    std::unique_lock<std::mutex> lock(mGameThread.mutex);
+    while (true) {
+        mGameThread.condition.wait(lock, [this]() { return mGameThread.updateRequested || mGameThread.stop; });
+        if (mGameThread.stop) {
+            return;
+        }
+        mGameThread.updateRequested = false;
+        const uint32_t packetIndex  = mGameThread.packetIndex;
+        lock.unlock();
+
+        const double startMs = mTimer.MillisSinceStart();
+        DispatchUpdate(packetIndex);
+        const float updateTime = static_cast<float>(mTimer.MillisSinceStart() - startMs);
+
+        lock.lock();
+        mGameThread.updateTime    = updateTime;
+        mGameThread.updateRunning = false;
+        mGameThread.condition.notify_all();
+    }
+}
+
+void Application::RequestUpdate(uint32_t packetIndex)
+{
+    {
+        std::lock_guard<std::mutex> lock(mGameThread.mutex);
+        PPX_ASSERT_MSG(!mGameThread.updateRunning, "previous update hasn't been waited for");
+        mGameThread.packetIndex     = packetIndex;
+        mGameThread.updateRequested = true;
+        mGameThread.updateRunning   = true;
+    }
+    mGameThread.condition.notify_all();
+}
+
+void Application::WaitForUpdate()
+{
+    std::unique_lock<std::mutex> lock(mGameThread.mutex);
+    mGameThread.condition.wait(lock, [this]() { return !mGameThread.updateRunning; });
+    mPreviousUpdateTime = mGameThread.updateTime;
+}
+
 void Application::MainLoop()
 {
+    // The game thread prepares packet 0 while the first events are pumped
+    const bool pipelined = mSettings.pipelinedUpdate;
+    mPacketInputTimes[0] = mTimer.MillisSinceStart();
+    if (pipelined) {
+        StartGameThread();
+        RequestUpdate(0);
+    }
+
+    if (!mStandardOpts.pTracePath->GetValue().empty()) {
+        Profiler::StartTrace();
+    }
+
     while (IsRunning()) {
         // Frame start
         mFrameStartTime = static_cast<float>(mTimer.MillisSinceStart());
+        Profiler::RecordTraceFrameMarker(mFrameCount);
+
+        // Events are only dispatched while no update runs
+        if (pipelined) {
+            WaitForUpdate();
+        }
 
+        const double inputTimeMs = mTimer.MillisSinceStart();
         ProcessEvents();
         if (!IsRunning()) {
-            return;
+            break;
+        }
+
+        if (pipelined) {
+            // Render the packet that was just finished while the next one is updated
+            mPacketInputTimes[mRenderPacketIndex ^ 1] = inputTimeMs;
+            RequestUpdate(mRenderPacketIndex ^ 1);
         }
+        else {
+            mPacketInputTimes[mRenderPacketIndex] = inputTimeMs;
+            const double updateStartMs            = mTimer.MillisSinceStart();
+            DispatchUpdate(mRenderPacketIndex);
+            mPreviousUpdateTime = static_cast<float>(mTimer.MillisSinceStart() - updateStartMs);
+        }
+
+        const double renderStartMs = mTimer.MillisSinceStart();
         RenderFrame();
+        mPreviousRenderTime = static_cast<float>(mTimer.MillisSinceStart() - renderStartMs);
+        mPreviousUITime     = static_cast<float>(mUITimeAccumulator);
+        mUITimeAccumulator  = 0;
 
-        // Take screenshot if this is the requested frame.
-        if (mFrameCount == static_cast<uint64_t>(mStandardOpts.pScreenshotFrameNumber->GetValue())) {
+        if (!mStartup.finished) {
+            FinishStartup();
+        }
+
+        // Take screenshot if this is a requested frame.
+        const int      screenshotFrameNumber   = mStandardOpts.pScreenshotFrameNumber->GetValue();
+        const uint64_t screenshotFrameInterval = static_cast<uint64_t>(mStandardOpts.pScreenshotFrameInterval->GetValue());
+        const uint64_t firstScreenshotFrame    = static_cast<uint64_t>(std::max(screenshotFrameNumber, 0));
+        if (mFrameCount == static_cast<uint64_t>(screenshotFrameNumber)) {
+            TakeScreenshot();
+        }
+        else if ((screenshotFrameInterval > 0) && (mFrameCount >= firstScreenshotFrame) && (((mFrameCount - firstScreenshotFrame) % screenshotFrameInterval) == 0)) {
             TakeScreenshot();
         }
+        mScreenshotReadback.Poll();
+
+        if (!mStandardOpts.pVideoCapturePath->GetValue().empty()) {
+            CaptureVideoFrame();
+        }
+        mVideoReadback.Poll();
+
+        DestroyRetiredSwapchains(false);
+        PPX_CHECKED_CALL(mDevice->ProcessDeferredDestroys());
+        UpdateTrace();
+
+        // Temporary allocations of this frame are released
+        FrameArena::NextFrame();
 
         // Frame end general metrics data, used for recorded metrics, display, screenshots, and pacing.
         double nowMs       = mTimer.MillisSinceStart();
         mFrameCount        = mFrameCount + 1;
         mPreviousFrameTime = static_cast<float>(nowMs) - mFrameStartTime;
 
+        // Totals for the throughput summary of --free-running
+        mTotalFrameTime += mPreviousFrameTime;
+        mTotalGpuWaitTime += mPreviousGpuWaitTime;
+
+        // The frame's work, without waiting for the GPU
+        if (mPerformanceHints.HasHintSession()) {
+            const double workMs = std::max(static_cast<double>(GetPrevCpuBusyTime()), 0.001);
+            mPerformanceHints.ReportActualWorkDuration(static_cast<uint64_t>(workMs * 1000000.0));
+        }
+
         // Keep a rolling window of frame times to calculate stats, if requested.
         if (mStandardOpts.pStatsFrameWindow->GetValue() > 0) {
             mFrameTimesMs.push_back(mPreviousFrameTime);
@@ -1188,6 +2227,7 @@ void Application::MainLoop()
         // Update the metrics. This can be used for both recorded AND displayed metrics,
         // and therefore should always be called.
         DispatchUpdateMetrics();
+        UpdateBenchmarkRepetitions();
 
         // Pace frames - if needed
         if (mSettings.grfx.pacedFrameRate > 0) {
@@ -1209,7 +2249,14 @@ void Application::MainLoop()
             (nowMs / 1000.f) > mRunTimeSeconds) {
             Quit();
         }
+
+        // Without a game thread Update() and Render() share one packet
+        if (pipelined) {
+            mRenderPacketIndex ^= 1;
+        }
     }
+
+    StopGameThread();
 }
 
 int Application::Run(int argc, char** argv)
@@ -1221,6 +2268,11 @@ int Application::Run(int argc, char** argv)
         return false;
     }
 
+    if (mStartup.timer.Start() != ppx::TIMER_RESULT_SUCCESS) {
+        PPX_ASSERT_MSG(false, "failed to start startup timer");
+        return EXIT_FAILURE;
+    }
+
     // Parse args.
     if (Failed(mCommandLineParser.Parse(argc, const_cast<const char**>(argv)))) {
         PPX_ASSERT_MSG(false, "Unable to parse command line arguments");
@@ -1259,8 +2311,21 @@ int Application::Run(int argc, char** argv)
 
     UpdateStandardSettings();
 
+    // Before any threads that have a role are started
+    if (Failed(InitializeThreadPolicies())) {
+        return EXIT_FAILURE;
+    }
+
     mDecoratedApiName = ToString(mSettings.grfx.api);
 
+    // Adds the time since the previous phase ended to a startup phase
+    double phaseStart = mStartup.timer.MillisSinceStart();
+    auto   endPhase   = [this, &phaseStart](double* pPhaseTime) {
+        const double now = mStartup.timer.MillisSinceStart();
+        *pPhaseTime += now - phaseStart;
+        phaseStart = now;
+    };
+
     // Initialize the window
     Result ppxres = InitializeWindow();
     if (Failed(ppxres)) {
@@ -1277,6 +2342,7 @@ int Application::Run(int argc, char** argv)
     if (Failed(ppxres)) {
         return EXIT_FAILURE;
     }
+    endPhase(&mStartupTimes.window);
 
 #if defined(PPX_BUILD_XR)
     InitializeXRComponentBeforeGrfxDeviceInit();
@@ -1291,6 +2357,7 @@ int Application::Run(int argc, char** argv)
 #if defined(PPX_BUILD_XR)
     InitializeXRComponentAndUpdateSettingsAfterGrfxDeviceInit();
 #endif
+    endPhase(&mStartupTimes.device);
 
     // List gpus
     if (mStandardOpts.pListGpus->GetValue()) {
@@ -1302,6 +2369,7 @@ int Application::Run(int argc, char** argv)
     if (Failed(ppxres)) {
         return EXIT_FAILURE;
     }
+    endPhase(&mStartupTimes.window);
 
     // Create surface
     ppxres = InitializeGrfxSurface();
@@ -1318,9 +2386,16 @@ int Application::Run(int argc, char** argv)
         return EXIT_FAILURE;
     }
 
+    // Needs the swapchain size and format
+    ppxres = InitializeDynamicResolution();
+    if (Failed(ppxres)) {
+        return EXIT_FAILURE;
+    }
+
     if (!IsXrEnabled()) {
         mWindow->Resize({mSettings.window.width, mSettings.window.height});
     }
+    endPhase(&mStartupTimes.swapchain);
 
     // Setup ImGui
     if (mSettings.enableImGui) {
@@ -1330,11 +2405,48 @@ int Application::Run(int argc, char** argv)
         }
     }
 
+    if (mStandardOpts.pShaderHotReload->GetValue()) {
+        ShaderHotReloadCreateInfo createInfo = {};
+        createInfo.pDevice                   = mDevice;
+        ppxres                               = mShaderHotReload.Initialize(createInfo);
+        if (Failed(ppxres)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Optional, shaders with bytecode can still be created without it
+    if (!mStandardOpts.pShaderCompilerPath->GetValue().empty()) {
+        ShaderCompilerCreateInfo createInfo = {};
+        createInfo.api                      = mSettings.grfx.api;
+        createInfo.compilerPath             = mStandardOpts.pShaderCompilerPath->GetValue();
+        if (!mStandardOpts.pShaderCachePath->GetValue().empty()) {
+            createInfo.cacheDirectory = ppx::fs::GetFullPath(mStandardOpts.pShaderCachePath->GetValue(), ppx::fs::GetDefaultOutputDirectory());
+        }
+        ppxres = mShaderCompiler.Initialize(createInfo);
+        if (Failed(ppxres)) {
+            PPX_LOG_WARN("Shader compiler " << createInfo.compilerPath << " is unavailable: " << ToString(ppxres));
+        }
+    }
+
+    if (mStandardOpts.pPrecompilePipelines->GetValue()) {
+        ppxres = mDevice->PrecompilePipelines();
+        if (Failed(ppxres)) {
+            PPX_LOG_WARN("Precompiling the pipeline manifest failed: " << ToString(ppxres));
+        }
+    }
+
     // Call setup
     {
         ScopedTimer timer("Setup() finished");
         DispatchSetup();
     }
+    endPhase(&mStartupTimes.setup);
+    mStartup.setupEnd = phaseStart;
+
+    // Setup() time that wasn't spent on shaders or pipelines is mostly assets
+    mStartupTimes.shaderLoad     = mShaderFileLoadTime + mDevice->GetShaderModuleCreateTimeMs();
+    mStartupTimes.pipelineCreate = mDevice->GetPipelineCreateTimeMs();
+    mStartupTimes.assetLoad      = std::max(mStartupTimes.setup - mStartupTimes.shaderLoad - mStartupTimes.pipelineCreate, 0.0);
 
     // ---------------------------------------------------------------------------------------------
     // Main loop [BEGIN]
@@ -1358,6 +2470,14 @@ int Application::Run(int argc, char** argv)
     //
     StopGrfx();
 
+    // Write the screenshots and video frames that are still being read back
+    mScreenshotReadback.Shutdown();
+    mVideoReadback.Shutdown();
+    if (mVideoWriter.IsOpen()) {
+        PPX_LOG_INFO("Recorded " << mVideoWriter.GetFrameCount() << " video frames");
+        mVideoWriter.Close();
+    }
+
     // Call shutdown
     DispatchShutdown();
 
@@ -1456,30 +2576,100 @@ std::optional<std::filesystem::path> GetShaderPathSuffix(const ppx::ApplicationS
 
 } // namespace
 
-std::vector<char> Application::LoadShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName) const
+std::optional<std::vector<char>> Application::ReadShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName) const
 {
     PPX_ASSERT_MSG(baseDir.is_relative(), "baseDir must be relative. Do not call GetAssetPath() on the directory.");
     PPX_ASSERT_MSG(baseName.is_relative(), "baseName must be relative. Do not call GetAssetPath() on the directory.");
     auto suffix = GetShaderPathSuffix(mSettings, baseName);
     if (!suffix.has_value()) {
         PPX_ASSERT_MSG(false, "unsupported API");
-        return {};
+        return std::nullopt;
     }
 
-    const auto filePath = GetAssetPath(baseDir / suffix.value());
-    auto       bytecode = fs::load_file(filePath);
+    Timer timer;
+    PPX_ASSERT_MSG(timer.Start() == TIMER_RESULT_SUCCESS, "timer start failed");
+
+    const auto filePath = baseDir / suffix.value();
+    auto       bytecode = LoadAsset(filePath);
+    mShaderFileLoadTime += timer.MillisSinceStart();
+    if (bytecode.has_value()) {
+        PPX_LOG_INFO("Loaded shader " << filePath);
+    }
+    return bytecode;
+}
+
+std::vector<char> Application::LoadShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName) const
+{
+    auto bytecode = ReadShader(baseDir, baseName);
     if (!bytecode.has_value()) {
-        PPX_ASSERT_MSG(false, "could not load file: " << filePath);
+        PPX_ASSERT_MSG(false, "could not load shader: " << (baseDir / baseName));
         return {};
     }
-
-    PPX_LOG_INFO("Loaded shader from " << filePath);
     return bytecode.value();
 }
 
+Result Application::CompileShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName, const std::vector<ShaderDefine>& defines, std::vector<char>* pBytecode) const
+{
+    if (!mShaderCompiler.IsInitialized()) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    // "Texture.vs" is the vs stage of Texture.hlsl
+    const std::string extension = baseName.extension().string();
+    if (extension.size() < 2) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    ShaderCompileInfo compileInfo = {};
+    compileInfo.sourcePath        = FindAssetPath(baseDir / std::filesystem::path(baseName).replace_extension(".hlsl"));
+    compileInfo.stage             = extension.substr(1);
+    compileInfo.defines           = defines;
+    if (compileInfo.sourcePath.empty()) {
+        PPX_LOG_ERROR("Could not find the HLSL source of shader " << (baseDir / baseName));
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+
+    Timer timer;
+    PPX_ASSERT_MSG(timer.Start() == TIMER_RESULT_SUCCESS, "timer start failed");
+
+    ShaderCompileResult result = mShaderCompiler.Compile(compileInfo);
+    mShaderFileLoadTime += timer.MillisSinceStart();
+    if (Failed(result.result)) {
+        PPX_LOG_ERROR("Compiling shader " << compileInfo.sourcePath << " (" << compileInfo.stage << ") failed: " << result.log);
+        return result.result;
+    }
+
+    PPX_LOG_INFO((result.cached ? "Loaded cached shader " : "Compiled shader ") << compileInfo.sourcePath << " (" << compileInfo.stage << ")");
+    *pBytecode = std::move(result.bytecode);
+    return ppx::SUCCESS;
+}
+
+Result Application::CreateShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName, const std::vector<ShaderDefine>& defines, grfx::ShaderModule** ppShaderModule) const
+{
+    std::vector<char> bytecode;
+    Result            ppxres = CompileShader(baseDir, baseName, defines, &bytecode);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode.size()), bytecode.data()};
+    return GetDevice()->CreateShaderModule(&shaderCreateInfo, ppShaderModule);
+}
+
 Result Application::CreateShader(const std::filesystem::path& baseDir, const std::filesystem::path& baseName, grfx::ShaderModule** ppShaderModule) const
 {
-    std::vector<char> bytecode = LoadShader(baseDir, baseName);
+    std::vector<char> bytecode;
+    if (mShaderCompiler.IsInitialized()) {
+        // Without precompiled bytecode, fall back to the runtime compiler
+        auto loaded = ReadShader(baseDir, baseName);
+        if (!loaded.has_value()) {
+            return CreateShader(baseDir, baseName, {}, ppShaderModule);
+        }
+        bytecode = std::move(loaded.value());
+    }
+    else {
+        bytecode = LoadShader(baseDir, baseName);
+    }
     if (bytecode.empty()) {
         return ppx::ERROR_GRFX_INVALID_SHADER_BYTE_CODE;
     }
@@ -1490,9 +2680,38 @@ Result Application::CreateShader(const std::filesystem::path& baseDir, const std
         return ppxres;
     }
 
+    // Shaders that only exist in asset packs can't change
+    if (mShaderHotReload.IsInitialized()) {
+        auto filePath = FindAssetPath(baseDir / GetShaderPathSuffix(mSettings, baseName).value());
+        if (!filePath.empty()) {
+            mShaderHotReload.TrackShaderModule(*ppShaderModule, filePath);
+        }
+    }
+
     return ppx::SUCCESS;
 }
 
+Result Application::WatchShaders(grfx::GraphicsPipelinePtr* ppPipeline)
+{
+    if (!mShaderHotReload.IsInitialized()) {
+        return ppx::SUCCESS;
+    }
+    return mShaderHotReload.Watch(ppPipeline);
+}
+
+Result Application::WatchShaders(grfx::ComputePipelinePtr* ppPipeline)
+{
+    if (!mShaderHotReload.IsInitialized()) {
+        return ppx::SUCCESS;
+    }
+    return mShaderHotReload.Watch(ppPipeline);
+}
+
+void Application::UnwatchShaders(const void* ppPipeline)
+{
+    mShaderHotReload.Unwatch(ppPipeline);
+}
+
 grfx::SwapchainPtr Application::GetSwapchain(uint32_t index) const
 {
     PPX_ASSERT_MSG(index < mSwapchains.size(), "Invalid Swapchain Index!");
@@ -1510,6 +2729,8 @@ Result Application::Present(
         return ppxres;
     }
 
+    mPreviousInputLatency = static_cast<float>(mTimer.MillisSinceStart() - mPacketInputTimes[mRenderPacketIndex]);
+
     return ppx::SUCCESS;
 }
 
@@ -1542,6 +2763,7 @@ void Application::StartMetricsRun(const std::string& name)
     // Callers should check mSettings.enableMetrics before making this call.
     PPX_ASSERT_MSG(mStandardOpts.pEnableMetrics->GetValue(), "Metrics must be enabled to use metrics capabilities");
     PPX_ASSERT_MSG(!mMetrics.manager.HasActiveRun(), "A run is already active; stop it before starting another one");
+    mMetrics.manager.SetDefaultGaugeMode(mStandardOpts.pMetricsStreamingGauges->GetValue() ? metrics::GaugeMode::SKETCH : metrics::GaugeMode::TIME_SERIES);
     mMetrics.manager.StartRun(name.c_str());
 
     // Add default metrics to every single run
@@ -1563,6 +2785,60 @@ void Application::StartMetricsRun(const std::string& name)
         mMetrics.framerateId             = mMetrics.manager.AddMetric(metadata);
         PPX_ASSERT_MSG(mMetrics.framerateId != metrics::kInvalidMetricID, "Failed to create framerate metric");
     }
+    {
+        // Update() and Render() run in parallel with ApplicationSettings::pipelinedUpdate
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = "cpu_update_time";
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.cpuUpdateTimeId         = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.cpuUpdateTimeId != metrics::kInvalidMetricID, "Failed to create update time metric");
+
+        metadata.name            = "cpu_render_time";
+        mMetrics.cpuRenderTimeId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.cpuRenderTimeId != metrics::kInvalidMetricID, "Failed to create render time metric");
+    }
+    {
+        // Lower with grfx.swapchain.maxFrameLatency, higher with pipelinedUpdate
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = "input_to_present_latency";
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.inputLatencyId          = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.inputLatencyId != metrics::kInvalidMetricID, "Failed to create input latency metric");
+    }
+    {
+        // Frames with GPU waits are GPU bound, cpu_busy_time is the frame time without them
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = "gpu_wait_time";
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::NONE;
+        mMetrics.gpuWaitTimeId           = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.gpuWaitTimeId != metrics::kInvalidMetricID, "Failed to create GPU wait time metric");
+
+        metadata.name           = "cpu_busy_time";
+        metadata.interpretation = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.cpuBusyTimeId  = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.cpuBusyTimeId != metrics::kInvalidMetricID, "Failed to create CPU busy time metric");
+    }
+    if (mSettings.enableImGui) {
+        // Part of cpu_render_time, subtract it to compare runs with and without the UI
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = "cpu_ui_time";
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.cpuUITimeId             = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.cpuUITimeId != metrics::kInvalidMetricID, "Failed to create UI time metric");
+
+        metadata.name          = "ui_draw_count";
+        metadata.unit          = "";
+        mMetrics.uiDrawCountId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.uiDrawCountId != metrics::kInvalidMetricID, "Failed to create UI draw count metric");
+    }
     {
         metrics::MetricMetadata metadata = {};
         metadata.type                    = metrics::MetricType::COUNTER;
@@ -1572,8 +2848,208 @@ void Application::StartMetricsRun(const std::string& name)
         mMetrics.frameCountId            = mMetrics.manager.AddMetric(metadata);
         PPX_ASSERT_MSG(mMetrics.frameCountId != metrics::kInvalidMetricID, "Failed to create frame count metric");
     }
+    {
+        mMetrics.stutter = metrics::FrameStutterTracker(mStandardOpts.pFrameBudgetMs->GetValue());
+
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::COUNTER;
+        metadata.name                    = "frames_over_budget";
+        metadata.unit                    = "";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.framesOverBudgetId      = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.framesOverBudgetId != metrics::kInvalidMetricID, "Failed to create frames over budget metric");
+
+        // One entry per streak of consecutive frames over budget, its length
+        metadata.type              = metrics::MetricType::GAUGE;
+        metadata.name              = "slow_frame_streak";
+        metadata.unit              = "frames";
+        mMetrics.slowFrameStreakId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.slowFrameStreakId != metrics::kInvalidMetricID, "Failed to create slow frame streak metric");
+
+        // One entry per window of frames
+        metadata.name                   = "cpu_frame_time_variance";
+        metadata.unit                   = "ms^2";
+        mMetrics.cpuFrameTimeVarianceId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.cpuFrameTimeVarianceId != metrics::kInvalidMetricID, "Failed to create frame time variance metric");
+
+        metadata.type           = metrics::MetricType::COUNTER;
+        metadata.unit           = "";
+        metadata.interpretation = metrics::MetricInterpretation::NONE;
+        for (uint32_t i = 0; i < metrics::FrameStutterTracker::kHistogramBucketCount; ++i) {
+            // e.g. cpu_frame_time_histogram_11.3_16.0ms, the last one is 256.0_inf_ms
+            const double lowerBound = metrics::FrameStutterTracker::GetHistogramLowerBound(i);
+            const double upperBound = metrics::FrameStutterTracker::GetHistogramUpperBound(i);
+            char         bounds[32] = {};
+            if (std::isinf(upperBound)) {
+                std::snprintf(bounds, sizeof(bounds), "%.1f_inf_ms", lowerBound);
+            }
+            else {
+                std::snprintf(bounds, sizeof(bounds), "%.1f_%.1fms", lowerBound, upperBound);
+            }
+            metadata.name                        = std::string("cpu_frame_time_histogram_") + bounds;
+            mMetrics.cpuFrameTimeHistogramIds[i] = mMetrics.manager.AddMetric(metadata);
+            PPX_ASSERT_MSG(mMetrics.cpuFrameTimeHistogramIds[i] != metrics::kInvalidMetricID, "Failed to create frame time histogram metric");
+        }
+    }
+    {
+        grfx::MemoryStatistics memoryStatistics = {};
+        GetDevice()->GetMemoryStatistics(&memoryStatistics);
+        for (size_t i = 0; i < memoryStatistics.heaps.size(); ++i) {
+            metrics::MetricMetadata metadata = {};
+            metadata.type                    = metrics::MetricType::GAUGE;
+            metadata.name                    = "memory_heap" + std::to_string(i) + "_usage";
+            metadata.unit                    = "MB";
+            metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+            mMetrics.memoryUsageIds.push_back(mMetrics.manager.AddMetric(metadata));
+            PPX_ASSERT_MSG(mMetrics.memoryUsageIds.back() != metrics::kInvalidMetricID, "Failed to create memory usage metric");
+
+            metadata.name           = "memory_heap" + std::to_string(i) + "_budget";
+            metadata.interpretation = metrics::MetricInterpretation::NONE;
+            mMetrics.memoryBudgetIds.push_back(mMetrics.manager.AddMetric(metadata));
+            PPX_ASSERT_MSG(mMetrics.memoryBudgetIds.back() != metrics::kInvalidMetricID, "Failed to create memory budget metric");
+        }
+    }
+    {
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::COUNTER;
+        metadata.name                    = "shader_module_cache_hits";
+        metadata.unit                    = "";
+        metadata.interpretation          = metrics::MetricInterpretation::NONE;
+        mMetrics.shaderModuleCacheHitsId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.shaderModuleCacheHitsId != metrics::kInvalidMetricID, "Failed to create shader module cache hits metric");
+
+        metadata.name                      = "shader_module_cache_misses";
+        mMetrics.shaderModuleCacheMissesId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.shaderModuleCacheMissesId != metrics::kInvalidMetricID, "Failed to create shader module cache misses metric");
+
+        mMetrics.shaderModuleCacheHitCount  = GetDevice()->GetShaderModuleCacheHitCount();
+        mMetrics.shaderModuleCacheMissCount = GetDevice()->GetShaderModuleCacheMissCount();
+    }
+#if defined(PPX_BUILD_XR)
+    if (IsXrEnabled()) {
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = "xr_frame_wait_time";
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::NONE;
+        mMetrics.xrFrameWaitTimeId       = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.xrFrameWaitTimeId != metrics::kInvalidMetricID, "Failed to create XR frame wait time metric");
+
+        metadata.name           = "xr_cpu_slack";
+        metadata.interpretation = metrics::MetricInterpretation::HIGHER_IS_BETTER;
+        mMetrics.xrCpuSlackId   = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.xrCpuSlackId != metrics::kInvalidMetricID, "Failed to create XR CPU slack metric");
+
+        metadata.type             = metrics::MetricType::COUNTER;
+        metadata.name             = "xr_missed_frames";
+        metadata.unit             = "";
+        metadata.interpretation   = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.xrMissedFramesId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.xrMissedFramesId != metrics::kInvalidMetricID, "Failed to create XR missed frames metric");
+    }
+#endif
+    if (mStandardOpts.pPerfCounters->GetValue()) {
+        // Opened once, by the first run, which is usually started before the
+        // game and job threads so they're counted as well
+        if (!mMetrics.perfCounters.IsOpen() && Failed(mMetrics.perfCounters.Open())) {
+            PPX_LOG_WARN("CPU hardware counters are unavailable, check /proc/sys/kernel/perf_event_paranoid");
+        }
+
+        for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+            const PerfCounter counter  = static_cast<PerfCounter>(i);
+            mMetrics.perfCounterIds[i] = metrics::kInvalidMetricID;
+            if (!mMetrics.perfCounters.IsAvailable(counter)) {
+                continue;
+            }
+
+            metrics::MetricMetadata metadata = {};
+            metadata.type                    = metrics::MetricType::GAUGE;
+            metadata.name                    = std::string("cpu_frame_") + PerfCounters::GetName(counter);
+            metadata.unit                    = "";
+            metadata.interpretation          = (counter == PERF_COUNTER_INSTRUCTIONS) ? metrics::MetricInterpretation::NONE : metrics::MetricInterpretation::LOWER_IS_BETTER;
+            mMetrics.perfCounterIds[i]       = mMetrics.manager.AddMetric(metadata);
+            PPX_ASSERT_MSG(mMetrics.perfCounterIds[i] != metrics::kInvalidMetricID, "Failed to create CPU hardware counter metric");
+        }
+        mMetrics.perfCounters.Read(&mMetrics.perfCounterValues);
+    }
+    if (mPerformanceHints.HasThermalStatus()) {
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = "thermal_status";
+        metadata.unit                    = "";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        mMetrics.thermalStatusId         = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.thermalStatusId != metrics::kInvalidMetricID, "Failed to create thermal status metric");
+
+        metadata.name              = "thermal_headroom";
+        mMetrics.thermalHeadroomId = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(mMetrics.thermalHeadroomId != metrics::kInvalidMetricID, "Failed to create thermal headroom metric");
+
+        // Sampled on the run's first frame
+        mMetrics.thermalRecordSeconds = -1.0;
+        mMetrics.maxThermalStatus     = THERMAL_STATUS_UNKNOWN;
+    }
 
     mMetrics.resetFramerateTracking = true;
+
+    // Runs started by benchmark repetitions or by the app after the first frame
+    if (mStartup.finished) {
+        RecordStartupMetrics();
+    }
+
+    SetupRunMetrics();
+}
+
+void Application::FinishStartup()
+{
+    const double now         = mStartup.timer.MillisSinceStart();
+    mStartupTimes.firstFrame = now - mStartup.setupEnd;
+    mStartupTimes.total      = now;
+    mStartup.finished        = true;
+
+    PPX_LOG_INFO("Startup time: " << mStartupTimes.total << " ms");
+    PPX_LOG_INFO("   window          : " << mStartupTimes.window << " ms");
+    PPX_LOG_INFO("   device          : " << mStartupTimes.device << " ms");
+    PPX_LOG_INFO("   swapchain       : " << mStartupTimes.swapchain << " ms");
+    PPX_LOG_INFO("   setup           : " << mStartupTimes.setup << " ms");
+    PPX_LOG_INFO("     shader load   : " << mStartupTimes.shaderLoad << " ms");
+    PPX_LOG_INFO("     pipelines     : " << mStartupTimes.pipelineCreate << " ms");
+    PPX_LOG_INFO("     assets        : " << mStartupTimes.assetLoad << " ms");
+    PPX_LOG_INFO("   first frame     : " << mStartupTimes.firstFrame << " ms");
+
+    if (HasActiveMetricsRun()) {
+        RecordStartupMetrics();
+    }
+}
+
+void Application::RecordStartupMetrics()
+{
+    const std::pair<const char*, double> phases[] = {
+        {"startup_window_time", mStartupTimes.window},
+        {"startup_device_time", mStartupTimes.device},
+        {"startup_swapchain_time", mStartupTimes.swapchain},
+        {"startup_setup_time", mStartupTimes.setup},
+        {"startup_shader_load_time", mStartupTimes.shaderLoad},
+        {"startup_pipeline_create_time", mStartupTimes.pipelineCreate},
+        {"startup_asset_load_time", mStartupTimes.assetLoad},
+        {"startup_first_frame_time", mStartupTimes.firstFrame},
+        {"startup_total_time", mStartupTimes.total},
+    };
+
+    for (const auto& [name, time] : phases) {
+        metrics::MetricMetadata metadata = {};
+        metadata.type                    = metrics::MetricType::GAUGE;
+        metadata.name                    = name;
+        metadata.unit                    = "ms";
+        metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+        const metrics::MetricID id       = mMetrics.manager.AddMetric(metadata);
+        PPX_ASSERT_MSG(id != metrics::kInvalidMetricID, "Failed to create startup metric " << name);
+
+        metrics::MetricData data = {metrics::MetricType::GAUGE};
+        data.gauge.seconds       = GetElapsedSeconds();
+        data.gauge.value         = time;
+        mMetrics.manager.RecordMetricData(id, data);
+    }
 }
 
 void Application::StopMetricsRun()
@@ -1586,10 +3062,155 @@ void Application::StopMetricsRun()
         PPX_LOG_WARN("Attempt to stop metrics without a run in progress!");
     }
 
+    // The streak the run ended in
+    const uint32_t streak = mMetrics.stutter.EndStreak();
+    if ((streak > 0) && mMetrics.manager.HasActiveRun()) {
+        metrics::MetricData streakData = {metrics::MetricType::GAUGE};
+        streakData.gauge.seconds       = GetElapsedSeconds();
+        streakData.gauge.value         = streak;
+        mMetrics.manager.RecordMetricData(mMetrics.slowFrameStreakId, streakData);
+    }
+
+    // Throttled runs don't measure the device at its normal clocks
+    if (mMetrics.maxThermalStatus >= THERMAL_STATUS_LIGHT) {
+        PPX_LOG_WARN("Metrics run was thermally throttled, thermal status reached " << PerformanceHints::GetThermalStatusName(mMetrics.maxThermalStatus));
+    }
+
     mMetrics.manager.EndRun();
-    mMetrics.cpuFrameTimeId = metrics::kInvalidMetricID;
-    mMetrics.framerateId    = metrics::kInvalidMetricID;
-    mMetrics.frameCountId   = metrics::kInvalidMetricID;
+    mMetrics.cpuFrameTimeId  = metrics::kInvalidMetricID;
+    mMetrics.framerateId     = metrics::kInvalidMetricID;
+    mMetrics.frameCountId    = metrics::kInvalidMetricID;
+    mMetrics.cpuUpdateTimeId = metrics::kInvalidMetricID;
+    mMetrics.cpuRenderTimeId = metrics::kInvalidMetricID;
+    mMetrics.inputLatencyId  = metrics::kInvalidMetricID;
+    mMetrics.gpuWaitTimeId   = metrics::kInvalidMetricID;
+    mMetrics.cpuBusyTimeId   = metrics::kInvalidMetricID;
+    mMetrics.cpuUITimeId     = metrics::kInvalidMetricID;
+    mMetrics.uiDrawCountId   = metrics::kInvalidMetricID;
+    mMetrics.memoryUsageIds.clear();
+    mMetrics.memoryBudgetIds.clear();
+    mMetrics.shaderModuleCacheHitsId   = metrics::kInvalidMetricID;
+    mMetrics.shaderModuleCacheMissesId = metrics::kInvalidMetricID;
+    mMetrics.framesOverBudgetId        = metrics::kInvalidMetricID;
+    mMetrics.slowFrameStreakId         = metrics::kInvalidMetricID;
+    mMetrics.cpuFrameTimeVarianceId    = metrics::kInvalidMetricID;
+    std::fill(std::begin(mMetrics.cpuFrameTimeHistogramIds), std::end(mMetrics.cpuFrameTimeHistogramIds), metrics::kInvalidMetricID);
+    mMetrics.gpuFrameTimeId = metrics::kInvalidMetricID;
+    mMetrics.gpuScopeTimeIds.clear();
+    mMetrics.thermalStatusId   = metrics::kInvalidMetricID;
+    mMetrics.thermalHeadroomId = metrics::kInvalidMetricID;
+    mMetrics.maxThermalStatus  = THERMAL_STATUS_UNKNOWN;
+#if defined(PPX_BUILD_XR)
+    mMetrics.xrFrameWaitTimeId = metrics::kInvalidMetricID;
+    mMetrics.xrCpuSlackId      = metrics::kInvalidMetricID;
+    mMetrics.xrMissedFramesId  = metrics::kInvalidMetricID;
+#endif
+}
+
+bool Application::SetupBenchmark()
+{
+    auto& benchmark            = mMetrics.benchmark;
+    benchmark.repetitions      = mStandardOpts.pBenchmarkRepetitions->GetValue();
+    benchmark.warmupFrames     = mStandardOpts.pBenchmarkWarmupFrames->GetValue();
+    benchmark.repetitionFrames = mStandardOpts.pBenchmarkRepetitionFrames->GetValue();
+
+    const std::string sweepPath = mStandardOpts.pSweepPath->GetValue();
+    if (!sweepPath.empty()) {
+        std::ifstream  file(sweepPath);
+        nlohmann::json sweep = nlohmann::json::parse(file, nullptr, /* allow_exceptions= */ false);
+        if (sweep.is_discarded() || Failed(metrics::ExpandSweep(sweep, &benchmark.points))) {
+            PPX_LOG_ERROR("Failed to load --sweep-path " << sweepPath << ", running without it");
+            benchmark.points.clear();
+        }
+        else {
+            benchmark.repetitions      = sweep.value("repetitions", std::max(benchmark.repetitions, 1u));
+            benchmark.warmupFrames     = sweep.value("warmup_frames", benchmark.warmupFrames);
+            benchmark.repetitionFrames = std::max(sweep.value("repetition_frames", benchmark.repetitionFrames), 1u);
+            PPX_LOG_INFO("Sweeping " << benchmark.points.size() << " points from " << sweepPath);
+        }
+    }
+    if (benchmark.repetitions == 0) {
+        return false;
+    }
+
+    metrics::BenchmarkSettings settings = {};
+    settings.warmupFrames               = benchmark.warmupFrames;
+    settings.repetitionFrames           = benchmark.repetitionFrames;
+    mMetrics.manager.SetBenchmarkSettings(settings);
+
+    benchmark.active = true;
+    StartBenchmarkPoint();
+    return true;
+}
+
+void Application::UpdateBenchmarkRepetitions()
+{
+    auto& benchmark = mMetrics.benchmark;
+    if (!benchmark.active) {
+        return;
+    }
+
+    ++benchmark.frameCount;
+    if (!mMetrics.manager.HasActiveRun()) {
+        if (benchmark.frameCount >= benchmark.warmupFrames) {
+            StartBenchmarkRepetition();
+        }
+        return;
+    }
+    if (benchmark.frameCount < benchmark.repetitionFrames) {
+        return;
+    }
+
+    StopMetricsRun();
+    if (++benchmark.repetition < benchmark.repetitions) {
+        StartBenchmarkRepetition();
+        return;
+    }
+    benchmark.repetition = 0;
+    if (++benchmark.point < benchmark.points.size()) {
+        StartBenchmarkPoint();
+        return;
+    }
+
+    benchmark.active = false;
+    PPX_LOG_INFO("Benchmark complete");
+    Quit();
+}
+
+void Application::StartBenchmarkPoint()
+{
+    auto& benchmark      = mMetrics.benchmark;
+    benchmark.frameCount = 0;
+
+    // Knobs the point doesn't set keep their values
+    if (!benchmark.points.empty()) {
+        const metrics::SweepPoint& point   = benchmark.points[benchmark.point];
+        CliOptions                 options = {};
+        mCommandLineParser.ParseJson(options, point.knobs);
+        mKnobManager.UpdateFromFlags(options);
+        mMetrics.manager.SetBenchmarkParameters(point.name, point.knobs);
+        PPX_LOG_INFO("Sweep point " << (benchmark.point + 1) << "/" << benchmark.points.size() << ": " << point.name);
+    }
+
+    if (benchmark.warmupFrames == 0) {
+        StartBenchmarkRepetition();
+    }
+}
+
+void Application::StartBenchmarkRepetition()
+{
+    auto&             benchmark  = mMetrics.benchmark;
+    const std::string repetition = "Repetition " + std::to_string(benchmark.repetition + 1);
+    if (benchmark.points.empty()) {
+        StartMetricsRun(repetition);
+        mMetrics.manager.AddBenchmarkRepetition();
+    }
+    else {
+        const std::string& point = benchmark.points[benchmark.point].name;
+        StartMetricsRun((benchmark.repetitions > 1) ? (point + " / " + repetition) : point);
+        mMetrics.manager.AddBenchmarkRepetition(point);
+    }
+    benchmark.frameCount = 0;
 }
 
 bool Application::HasActiveMetricsRun() const
@@ -1619,6 +3240,14 @@ bool Application::RecordMetricData(metrics::MetricID id, const metrics::MetricDa
     return mMetrics.manager.RecordMetricData(id, data);
 }
 
+bool Application::QueueMetricData(metrics::MetricID id, const metrics::MetricData& data)
+{
+    if (!mStandardOpts.pEnableMetrics->GetValue()) {
+        return false;
+    }
+    return mMetrics.manager.QueueMetricData(id, data);
+}
+
 void Application::AddAssetDirs()
 {
     std::filesystem::path projectRootPath = GetApplicationPath().remove_filename() / RELATIVE_PATH_TO_PROJECT_ROOT;
@@ -1642,11 +3271,25 @@ void Application::AddAssetDirs()
             AddAssetDir(*it, /* insert_at_front= */ true);
         }
     }
+
+    // Relative paths are looked up in the asset directories
+    for (const auto& pack : mStandardOpts.pAssetPacks->GetValue()) {
+        std::filesystem::path packPath = pack;
+        if (packPath.is_relative()) {
+            for (const auto& assetDir : GetAssetDirs()) {
+                if (fs::path_exists(assetDir / packPath)) {
+                    packPath = assetDir / packPath;
+                    break;
+                }
+            }
+        }
+        AddAssetPack(packPath);
+    }
 }
 
 void Application::UpdateAppMetrics()
 {
-    // This data is the same for every call to increase the frame count.
+    // This data is the same for every call to increase the frame count, or any other counter by one.
     static const metrics::MetricData frameCountData = []() {
         metrics::MetricData data = {};
         data.type                = metrics::MetricType::COUNTER;
@@ -1654,6 +3297,9 @@ void Application::UpdateAppMetrics()
         return data;
     }();
 
+    // Entries queued from other threads since the last frame.
+    mMetrics.manager.DrainQueuedMetricData();
+
     if (!HasActiveMetricsRun()) {
         return;
     }
@@ -1667,6 +3313,186 @@ void Application::UpdateAppMetrics()
     mMetrics.manager.RecordMetricData(mMetrics.cpuFrameTimeId, frameTimeData);
     mMetrics.manager.RecordMetricData(mMetrics.frameCountId, frameCountData);
 
+    frameTimeData.gauge.value = mPreviousUpdateTime;
+    mMetrics.manager.RecordMetricData(mMetrics.cpuUpdateTimeId, frameTimeData);
+    frameTimeData.gauge.value = mPreviousRenderTime;
+    mMetrics.manager.RecordMetricData(mMetrics.cpuRenderTimeId, frameTimeData);
+    frameTimeData.gauge.value = mPreviousInputLatency;
+    mMetrics.manager.RecordMetricData(mMetrics.inputLatencyId, frameTimeData);
+    frameTimeData.gauge.value = mPreviousGpuWaitTime;
+    mMetrics.manager.RecordMetricData(mMetrics.gpuWaitTimeId, frameTimeData);
+    frameTimeData.gauge.value = GetPrevCpuBusyTime();
+    mMetrics.manager.RecordMetricData(mMetrics.cpuBusyTimeId, frameTimeData);
+    if (mImGui) {
+        frameTimeData.gauge.value = mPreviousUITime;
+        mMetrics.manager.RecordMetricData(mMetrics.cpuUITimeId, frameTimeData);
+        frameTimeData.gauge.value = mImGui->GetRenderStats().drawCount;
+        mMetrics.manager.RecordMetricData(mMetrics.uiDrawCountId, frameTimeData);
+    }
+
+    // Record hitches
+    {
+        const metrics::FrameStutterResult stutter = mMetrics.stutter.AddFrame(mPreviousFrameTime);
+        if (stutter.overBudget) {
+            mMetrics.manager.RecordMetricData(mMetrics.framesOverBudgetId, frameCountData);
+        }
+        mMetrics.manager.RecordMetricData(mMetrics.cpuFrameTimeHistogramIds[stutter.histogramBucket], frameCountData);
+
+        metrics::MetricData stutterData = {metrics::MetricType::GAUGE};
+        stutterData.gauge.seconds       = seconds;
+        if (stutter.endedStreakLength > 0) {
+            stutterData.gauge.value = stutter.endedStreakLength;
+            mMetrics.manager.RecordMetricData(mMetrics.slowFrameStreakId, stutterData);
+        }
+        if (stutter.windowComplete) {
+            stutterData.gauge.value = stutter.windowVariance;
+            mMetrics.manager.RecordMetricData(mMetrics.cpuFrameTimeVarianceId, stutterData);
+        }
+    }
+
+    // Record memory usage and budget per heap
+    {
+        grfx::MemoryStatistics memoryStatistics = {};
+        GetDevice()->GetMemoryStatistics(&memoryStatistics);
+
+        const size_t heapCount = std::min(memoryStatistics.heaps.size(), mMetrics.memoryUsageIds.size());
+        for (size_t i = 0; i < heapCount; ++i) {
+            metrics::MetricData memoryData = {metrics::MetricType::GAUGE};
+            memoryData.gauge.seconds       = seconds;
+            memoryData.gauge.value         = static_cast<double>(memoryStatistics.heaps[i].usage) / (1024.0 * 1024.0);
+            mMetrics.manager.RecordMetricData(mMetrics.memoryUsageIds[i], memoryData);
+
+            memoryData.gauge.value = static_cast<double>(memoryStatistics.heaps[i].budget) / (1024.0 * 1024.0);
+            mMetrics.manager.RecordMetricData(mMetrics.memoryBudgetIds[i], memoryData);
+        }
+    }
+
+    // Record shader module cache hits and misses since the last frame
+    {
+        const uint64_t hitCount  = GetDevice()->GetShaderModuleCacheHitCount();
+        const uint64_t missCount = GetDevice()->GetShaderModuleCacheMissCount();
+        if (hitCount != mMetrics.shaderModuleCacheHitCount) {
+            metrics::MetricData hitData = {metrics::MetricType::COUNTER};
+            hitData.counter.increment   = hitCount - mMetrics.shaderModuleCacheHitCount;
+            mMetrics.manager.RecordMetricData(mMetrics.shaderModuleCacheHitsId, hitData);
+            mMetrics.shaderModuleCacheHitCount = hitCount;
+        }
+        if (missCount != mMetrics.shaderModuleCacheMissCount) {
+            metrics::MetricData missData = {metrics::MetricType::COUNTER};
+            missData.counter.increment   = missCount - mMetrics.shaderModuleCacheMissCount;
+            mMetrics.manager.RecordMetricData(mMetrics.shaderModuleCacheMissesId, missData);
+            mMetrics.shaderModuleCacheMissCount = missCount;
+        }
+    }
+
+#if defined(PPX_BUILD_XR)
+    // Record the pacing of the last XR frame
+    if (mMetrics.xrFrameWaitTimeId != metrics::kInvalidMetricID) {
+        const XrFrameTiming& timing = mXrComponent.GetFrameTiming();
+        metrics::MetricData  xrData = {metrics::MetricType::GAUGE};
+        xrData.gauge.seconds        = seconds;
+        xrData.gauge.value          = timing.waitTime;
+        mMetrics.manager.RecordMetricData(mMetrics.xrFrameWaitTimeId, xrData);
+        xrData.gauge.value = timing.cpuSlack;
+        mMetrics.manager.RecordMetricData(mMetrics.xrCpuSlackId, xrData);
+        if (timing.missedFrames > 0) {
+            metrics::MetricData missedData = {metrics::MetricType::COUNTER};
+            missedData.counter.increment   = timing.missedFrames;
+            mMetrics.manager.RecordMetricData(mMetrics.xrMissedFramesId, missedData);
+        }
+    }
+#endif
+
+    // Record CPU hardware counters as the increase since the last frame
+    if (mMetrics.perfCounters.IsOpen()) {
+        PerfCounterValues values = {};
+        if (Success(mMetrics.perfCounters.Read(&values))) {
+            for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+                if (mMetrics.perfCounterIds[i] == metrics::kInvalidMetricID) {
+                    continue;
+                }
+                // Scaled counts of multiplexed counters aren't always increasing
+                const uint64_t previous         = mMetrics.perfCounterValues.values[i];
+                metrics::MetricData counterData = {metrics::MetricType::GAUGE};
+                counterData.gauge.seconds       = seconds;
+                counterData.gauge.value         = (values.values[i] > previous) ? static_cast<double>(values.values[i] - previous) : 0.0;
+                mMetrics.manager.RecordMetricData(mMetrics.perfCounterIds[i], counterData);
+            }
+            mMetrics.perfCounterValues = values;
+        }
+    }
+
+    // Thermal state changes over seconds, and the headroom is only updated
+    // once per second
+    if ((mMetrics.thermalStatusId != metrics::kInvalidMetricID) && ((seconds - mMetrics.thermalRecordSeconds) >= 1.0)) {
+        mMetrics.thermalRecordSeconds = seconds;
+
+        const ThermalStatus status = mPerformanceHints.GetThermalStatus();
+        if (status != THERMAL_STATUS_UNKNOWN) {
+            metrics::MetricData thermalData = {metrics::MetricType::GAUGE};
+            thermalData.gauge.seconds       = seconds;
+            thermalData.gauge.value         = static_cast<double>(status);
+            mMetrics.manager.RecordMetricData(mMetrics.thermalStatusId, thermalData);
+            mMetrics.maxThermalStatus = std::max(mMetrics.maxThermalStatus, status);
+        }
+
+        const float headroom = mPerformanceHints.GetThermalHeadroom();
+        if (!std::isnan(headroom)) {
+            metrics::MetricData thermalData = {metrics::MetricType::GAUGE};
+            thermalData.gauge.seconds       = seconds;
+            thermalData.gauge.value         = static_cast<double>(headroom);
+            mMetrics.manager.RecordMetricData(mMetrics.thermalHeadroomId, thermalData);
+        }
+    }
+
+    // Record the GPU frame time: dynamic resolution's timestamps enclose the
+    // whole frame, otherwise it's the span of the GPU profiler scopes
+    auto recordGpuFrameTime = [&](double gpuFrameTimeMs) {
+        if (mMetrics.gpuFrameTimeId == metrics::kInvalidMetricID) {
+            metrics::MetricMetadata metadata = {};
+            metadata.type                    = metrics::MetricType::GAUGE;
+            metadata.name                    = "gpu_frame_time";
+            metadata.unit                    = "ms";
+            metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+            mMetrics.gpuFrameTimeId          = mMetrics.manager.AddMetric(metadata);
+        }
+
+        metrics::MetricData gpuFrameTimeData = {metrics::MetricType::GAUGE};
+        gpuFrameTimeData.gauge.seconds       = seconds;
+        gpuFrameTimeData.gauge.value         = gpuFrameTimeMs;
+        mMetrics.manager.RecordMetricData(mMetrics.gpuFrameTimeId, gpuFrameTimeData);
+    };
+    if (mDynamicResolution && (mDynamicResolution->GetGpuFrameTimeMs() > 0.0f)) {
+        recordGpuFrameTime(mDynamicResolution->GetGpuFrameTimeMs());
+    }
+
+    // Record GPU profiler scopes once per frame of results
+    if (mGpuProfiler && (mGpuProfiler->GetScopesFrameNumber() != mMetrics.gpuScopesFrameNumber)) {
+        double scopesEndMs = 0.0;
+        for (const auto& scope : mGpuProfiler->GetScopes()) {
+            scopesEndMs = std::max(scopesEndMs, scope.startMs + scope.gpuMs);
+
+            auto it = mMetrics.gpuScopeTimeIds.find(scope.path);
+            if (it == mMetrics.gpuScopeTimeIds.end()) {
+                metrics::MetricMetadata metadata = {};
+                metadata.type                    = metrics::MetricType::GAUGE;
+                metadata.name                    = "gpu_" + scope.path + "_time";
+                metadata.unit                    = "ms";
+                metadata.interpretation          = metrics::MetricInterpretation::LOWER_IS_BETTER;
+                it                               = mMetrics.gpuScopeTimeIds.emplace(scope.path, mMetrics.manager.AddMetric(metadata)).first;
+            }
+
+            metrics::MetricData scopeData = {metrics::MetricType::GAUGE};
+            scopeData.gauge.seconds       = seconds;
+            scopeData.gauge.value         = scope.gpuMs;
+            mMetrics.manager.RecordMetricData(it->second, scopeData);
+        }
+        if (!mDynamicResolution && !mGpuProfiler->GetScopes().empty()) {
+            recordGpuFrameTime(scopesEndMs);
+        }
+        mMetrics.gpuScopesFrameNumber = mGpuProfiler->GetScopesFrameNumber();
+    }
+
     // Record the average framerate over a given period of time
     if (mMetrics.resetFramerateTracking) {
         // Start tracking time
@@ -1786,6 +3612,40 @@ void Application::DrawDebugInfo()
             ImGui::NextColumn();
         }
 
+        // Previous update and render time, they overlap with pipelinedUpdate
+        {
+            ImGui::Text("Previous CPU Update Time");
+            ImGui::NextColumn();
+            ImGui::Text("%f ms", mPreviousUpdateTime);
+            ImGui::NextColumn();
+
+            ImGui::Text("Previous CPU Render Time");
+            ImGui::NextColumn();
+            ImGui::Text("%f ms", mPreviousRenderTime);
+            ImGui::NextColumn();
+
+            ImGui::Text("Previous CPU UI Time");
+            ImGui::NextColumn();
+            ImGui::Text("%f ms (%u draws)", mPreviousUITime, mImGui->GetRenderStats().drawCount);
+            ImGui::NextColumn();
+        }
+
+        // Input to present latency
+        {
+            ImGui::Text("Input To Present Latency");
+            ImGui::NextColumn();
+            ImGui::Text("%f ms", mPreviousInputLatency);
+            ImGui::NextColumn();
+        }
+
+        // GPU wait time
+        {
+            ImGui::Text("Previous GPU Wait Time");
+            ImGui::NextColumn();
+            ImGui::Text("%f ms", mPreviousGpuWaitTime);
+            ImGui::NextColumn();
+        }
+
         // Average frame time
         {
             ImGui::Text("Average Frame Time");
@@ -1819,6 +3679,82 @@ void Application::DrawDebugInfo()
             ImGui::NextColumn();
         }
 
+        ImGui::Separator();
+
+        // Memory heaps
+        {
+            grfx::MemoryStatistics memoryStatistics = {};
+            GetDevice()->GetMemoryStatistics(&memoryStatistics);
+
+            for (size_t i = 0; i < memoryStatistics.heaps.size(); ++i) {
+                const grfx::MemoryHeapStatistics& heap = memoryStatistics.heaps[i];
+                ImGui::Text("Memory Heap %zu%s", i, heap.deviceLocal ? " (device local)" : "");
+                ImGui::NextColumn();
+                ImGui::Text("%.1f / %.1f MB", heap.usage / (1024.0 * 1024.0), heap.budget / (1024.0 * 1024.0));
+                ImGui::NextColumn();
+
+                ImGui::Text("  Blocks / Allocations");
+                ImGui::NextColumn();
+                ImGui::Text("%u / %u (%.1f / %.1f MB)", heap.blockCount, heap.allocationCount, heap.blockBytes / (1024.0 * 1024.0), heap.allocationBytes / (1024.0 * 1024.0));
+                ImGui::NextColumn();
+            }
+        }
+
+        // Dynamic resolution
+        if (mDynamicResolution) {
+            ImGui::Separator();
+
+            ImGui::Text("Render Scale");
+            ImGui::NextColumn();
+            ImGui::Text("%.2f (%ux%u)", mDynamicResolution->GetScale(), mDynamicResolution->GetRenderWidth(), mDynamicResolution->GetRenderHeight());
+            ImGui::NextColumn();
+
+            ImGui::Text("GPU Frame Time");
+            ImGui::NextColumn();
+            ImGui::Text("%.3f ms (target %.3f ms)", mDynamicResolution->GetGpuFrameTimeMs(), mDynamicResolution->GetController().GetTargetFrameTimeMs());
+            ImGui::NextColumn();
+        }
+
+        // GPU profiler scopes
+        if (mGpuProfiler && !mGpuProfiler->GetScopes().empty()) {
+            ImGui::Separator();
+
+            for (const auto& scope : mGpuProfiler->GetScopes()) {
+                ImGui::Text("%*sGPU %s", static_cast<int>(2 * scope.depth), "", scope.name.c_str());
+                ImGui::NextColumn();
+                ImGui::Text("%.3f ms", scope.gpuMs);
+                ImGui::NextColumn();
+
+                if (scope.hasPipelineStatistics) {
+                    ImGui::Text("%*s  VS / PS Invocations", static_cast<int>(2 * scope.depth), "");
+                    ImGui::NextColumn();
+                    ImGui::Text("%" PRIu64 " / %" PRIu64, scope.pipelineStatistics.VSInvocations, scope.pipelineStatistics.PSInvocations);
+                    ImGui::NextColumn();
+                }
+            }
+        }
+
+        // CPU scopes of this thread, see PPX_PROFILE_SCOPE
+        Profiler* pProfiler = Profiler::GetProfilerForThread();
+        if (!IsNull(pProfiler)) {
+            bool hasScopes = false;
+            for (const auto& event : pProfiler->GetEvents()) {
+                if ((event.GetType() != PROFILER_EVENT_TYPE_SCOPE) || (event.GetSampleCount() == 0)) {
+                    continue;
+                }
+                if (!hasScopes) {
+                    ImGui::Separator();
+                    hasScopes = true;
+                }
+
+                const double average = Timer::TimestampToMillis(event.GetSampleTotal()) / static_cast<double>(event.GetSampleCount());
+                ImGui::Text("CPU %s", event.GetName().c_str());
+                ImGui::NextColumn();
+                ImGui::Text("%.3f ms (max %.3f ms)", average, Timer::TimestampToMillis(event.GetSampleMax()));
+                ImGui::NextColumn();
+            }
+        }
+
         ImGui::Columns(1);
 
         // Draw additional elements
@@ -1862,6 +3798,10 @@ void Application::DrawProfilerGrfxApiFunctions()
 
             uint32_t i = 0;
             for (auto& event : events) {
+                if (event.GetType() != PROFILER_EVENT_TYPE_GRFX_API_FN) {
+                    continue;
+                }
+
                 uint64_t count    = event.GetSampleCount();
                 float    average  = 0;
                 float    minValue = 0;
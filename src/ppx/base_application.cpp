@@ -79,6 +79,10 @@ void BaseApplication::AddAssetDir(const std::filesystem::path& path, bool insert
 #endif
 
     mAssetDirs.push_back(path);
+    {
+        std::lock_guard<std::mutex> lock(mAssetPathCacheMutex);
+        mAssetPathCache.clear();
+    }
 
     if (insertAtFront) {
         // Rotate to front
@@ -89,8 +93,17 @@ void BaseApplication::AddAssetDir(const std::filesystem::path& path, bool insert
     }
 }
 
-std::filesystem::path BaseApplication::GetAssetPath(const std::filesystem::path& subPath) const
+std::filesystem::path BaseApplication::FindAssetPath(const std::filesystem::path& subPath) const
 {
+    const std::string key = subPath.generic_string();
+    {
+        std::lock_guard<std::mutex> lock(mAssetPathCacheMutex);
+        auto                        it = mAssetPathCache.find(key);
+        if (it != mAssetPathCache.end()) {
+            return it->second;
+        }
+    }
+
     std::filesystem::path assetPath;
     for (const auto& assetDir : mAssetDirs) {
         std::filesystem::path path = assetDir / subPath;
@@ -99,8 +112,50 @@ std::filesystem::path BaseApplication::GetAssetPath(const std::filesystem::path&
             break;
         }
     }
+
+    // Missing assets aren't remembered, they may be written later
+    if (!assetPath.empty()) {
+        std::lock_guard<std::mutex> lock(mAssetPathCacheMutex);
+        mAssetPathCache[key] = assetPath;
+    }
+    return assetPath;
+}
+
+std::filesystem::path BaseApplication::GetAssetPath(const std::filesystem::path& subPath) const
+{
+    std::filesystem::path assetPath = FindAssetPath(subPath);
     PPX_ASSERT_MSG(!assetPath.empty(), "Could not determine asset path for " << subPath);
     return assetPath;
 }
 
+bool BaseApplication::AddAssetPack(const std::filesystem::path& path)
+{
+    auto pack = std::make_unique<fs::AssetPack>();
+    if (!pack->Open(path)) {
+        PPX_LOG_ERROR("Could not open asset pack " << path);
+        return false;
+    }
+
+    PPX_LOG_INFO("Added asset pack " << path << " with " << pack->GetEntryCount() << " entries");
+    mAssetPacks.push_back(std::move(pack));
+    return true;
+}
+
+std::optional<std::vector<char>> BaseApplication::LoadAsset(const std::filesystem::path& subPath) const
+{
+    const std::string name = subPath.generic_string();
+    for (const auto& pack : mAssetPacks) {
+        auto content = pack->Load(name);
+        if (content.has_value()) {
+            return content;
+        }
+    }
+
+    std::filesystem::path assetPath = FindAssetPath(subPath);
+    if (assetPath.empty()) {
+        return std::nullopt;
+    }
+    return fs::load_file(assetPath);
+}
+
 } // namespace ppx
@@ -0,0 +1,473 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/batch_math.h"
+#include "ppx/config.h"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PPX_BATCH_MATH_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PPX_BATCH_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ppx {
+
+// -------------------------------------------------------------------------------------------------
+// TransformArrays
+// -------------------------------------------------------------------------------------------------
+void TransformArrays::Resize(uint32_t count)
+{
+    for (uint32_t i = 0; i < COMPONENT_COUNT; ++i) {
+        const float defaultValue = (i >= SCALE_X) ? 1.0f : 0.0f;
+        mComponents[i].resize(count, defaultValue);
+    }
+    mCount = count;
+}
+
+void TransformArrays::Set(uint32_t index, const float3& translation, const float3& rotation, const float3& scale)
+{
+    PPX_ASSERT_MSG(index < mCount, "index out of range");
+    mComponents[TRANSLATION_X][index] = translation.x;
+    mComponents[TRANSLATION_Y][index] = translation.y;
+    mComponents[TRANSLATION_Z][index] = translation.z;
+    mComponents[ROTATION_X][index]    = rotation.x;
+    mComponents[ROTATION_Y][index]    = rotation.y;
+    mComponents[ROTATION_Z][index]    = rotation.z;
+    mComponents[SCALE_X][index]       = scale.x;
+    mComponents[SCALE_Y][index]       = scale.y;
+    mComponents[SCALE_Z][index]       = scale.z;
+}
+
+void TransformArrays::Set(uint32_t index, const ppx::Transform& transform)
+{
+    Set(index, transform.GetTranslation(), transform.GetRotation(), transform.GetScale());
+}
+
+float3 TransformArrays::GetTranslation(uint32_t index) const
+{
+    return float3(mComponents[TRANSLATION_X][index], mComponents[TRANSLATION_Y][index], mComponents[TRANSLATION_Z][index]);
+}
+
+float3 TransformArrays::GetRotation(uint32_t index) const
+{
+    return float3(mComponents[ROTATION_X][index], mComponents[ROTATION_Y][index], mComponents[ROTATION_Z][index]);
+}
+
+float3 TransformArrays::GetScale(uint32_t index) const
+{
+    return float3(mComponents[SCALE_X][index], mComponents[SCALE_Y][index], mComponents[SCALE_Z][index]);
+}
+
+// -------------------------------------------------------------------------------------------------
+// AABBArrays
+// -------------------------------------------------------------------------------------------------
+void AABBArrays::Resize(uint32_t count)
+{
+    for (auto& component : mComponents) {
+        component.resize(count, 0.0f);
+    }
+    mCount = count;
+}
+
+void AABBArrays::Set(uint32_t index, const ppx::AABB& aabb)
+{
+    PPX_ASSERT_MSG(index < mCount, "index out of range");
+    mComponents[MIN_X][index] = aabb.GetMin().x;
+    mComponents[MIN_Y][index] = aabb.GetMin().y;
+    mComponents[MIN_Z][index] = aabb.GetMin().z;
+    mComponents[MAX_X][index] = aabb.GetMax().x;
+    mComponents[MAX_Y][index] = aabb.GetMax().y;
+    mComponents[MAX_Z][index] = aabb.GetMax().z;
+}
+
+ppx::AABB AABBArrays::Get(uint32_t index) const
+{
+    return ppx::AABB(
+        float3(mComponents[MIN_X][index], mComponents[MIN_Y][index], mComponents[MIN_Z][index]),
+        float3(mComponents[MAX_X][index], mComponents[MAX_Y][index], mComponents[MAX_Z][index]));
+}
+
+// -------------------------------------------------------------------------------------------------
+// Lanes
+//
+// The kernels are written once against a lane type holding one float per
+// object. SimdLanes holds 4 objects, ScalarLanes holds 1 and handles the
+// objects left over at the end of the arrays and CPUs without SIMD.
+// -------------------------------------------------------------------------------------------------
+namespace {
+
+struct ScalarLanes
+{
+    static constexpr uint32_t kWidth = 1;
+
+    using Mask = bool;
+
+    float v;
+
+    static ScalarLanes Load(const float* pSrc) { return {*pSrc}; }
+    static ScalarLanes Set(float value) { return {value}; }
+    void               Store(float* pDst) const { *pDst = v; }
+
+    friend ScalarLanes operator+(ScalarLanes a, ScalarLanes b) { return {a.v + b.v}; }
+    friend ScalarLanes operator-(ScalarLanes a, ScalarLanes b) { return {a.v - b.v}; }
+    friend ScalarLanes operator*(ScalarLanes a, ScalarLanes b) { return {a.v * b.v}; }
+    friend ScalarLanes Abs(ScalarLanes a) { return {std::fabs(a.v)}; }
+    friend ScalarLanes Round(ScalarLanes a) { return {std::nearbyint(a.v)}; }
+    friend Mask        Greater(ScalarLanes a, ScalarLanes b) { return a.v > b.v; }
+    friend Mask        Less(ScalarLanes a, ScalarLanes b) { return a.v < b.v; }
+    friend Mask        GreaterEqual(ScalarLanes a, ScalarLanes b) { return a.v >= b.v; }
+    friend Mask        And(Mask a, Mask b) { return a && b; }
+    friend ScalarLanes Select(Mask mask, ScalarLanes a, ScalarLanes b) { return mask ? a : b; }
+    friend uint32_t    MoveMask(Mask mask) { return mask ? 1 : 0; }
+};
+
+#if defined(PPX_BATCH_MATH_SSE2)
+struct SimdLanes
+{
+    static constexpr uint32_t kWidth = 4;
+
+    struct Mask
+    {
+        __m128 v;
+    };
+
+    __m128 v;
+
+    static SimdLanes Load(const float* pSrc) { return {_mm_loadu_ps(pSrc)}; }
+    static SimdLanes Set(float value) { return {_mm_set1_ps(value)}; }
+    void             Store(float* pDst) const { _mm_storeu_ps(pDst, v); }
+
+    friend SimdLanes operator+(SimdLanes a, SimdLanes b) { return {_mm_add_ps(a.v, b.v)}; }
+    friend SimdLanes operator-(SimdLanes a, SimdLanes b) { return {_mm_sub_ps(a.v, b.v)}; }
+    friend SimdLanes operator*(SimdLanes a, SimdLanes b) { return {_mm_mul_ps(a.v, b.v)}; }
+    friend SimdLanes Abs(SimdLanes a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+    // Only used on values well within the int32 range
+    friend SimdLanes Round(SimdLanes a) { return {_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))}; }
+    friend Mask      Greater(SimdLanes a, SimdLanes b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+    friend Mask      Less(SimdLanes a, SimdLanes b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+    friend Mask      GreaterEqual(SimdLanes a, SimdLanes b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+    friend Mask      And(Mask a, Mask b) { return {_mm_and_ps(a.v, b.v)}; }
+    friend SimdLanes Select(Mask mask, SimdLanes a, SimdLanes b) { return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))}; }
+    friend uint32_t  MoveMask(Mask mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask.v)); }
+};
+#elif defined(PPX_BATCH_MATH_NEON)
+struct SimdLanes
+{
+    static constexpr uint32_t kWidth = 4;
+
+    struct Mask
+    {
+        uint32x4_t v;
+    };
+
+    float32x4_t v;
+
+    static SimdLanes Load(const float* pSrc) { return {vld1q_f32(pSrc)}; }
+    static SimdLanes Set(float value) { return {vdupq_n_f32(value)}; }
+    void             Store(float* pDst) const { vst1q_f32(pDst, v); }
+
+    friend SimdLanes operator+(SimdLanes a, SimdLanes b) { return {vaddq_f32(a.v, b.v)}; }
+    friend SimdLanes operator-(SimdLanes a, SimdLanes b) { return {vsubq_f32(a.v, b.v)}; }
+    friend SimdLanes operator*(SimdLanes a, SimdLanes b) { return {vmulq_f32(a.v, b.v)}; }
+    friend SimdLanes Abs(SimdLanes a) { return {vabsq_f32(a.v)}; }
+    friend SimdLanes Round(SimdLanes a) { return {vrndnq_f32(a.v)}; }
+    friend Mask      Greater(SimdLanes a, SimdLanes b) { return {vcgtq_f32(a.v, b.v)}; }
+    friend Mask      Less(SimdLanes a, SimdLanes b) { return {vcltq_f32(a.v, b.v)}; }
+    friend Mask      GreaterEqual(SimdLanes a, SimdLanes b) { return {vcgeq_f32(a.v, b.v)}; }
+    friend Mask      And(Mask a, Mask b) { return {vandq_u32(a.v, b.v)}; }
+    friend SimdLanes Select(Mask mask, SimdLanes a, SimdLanes b) { return {vbslq_f32(mask.v, a.v, b.v)}; }
+    friend uint32_t  MoveMask(Mask mask)
+    {
+        static const uint32_t kBits[4] = {1, 2, 4, 8};
+        return vaddvq_u32(vandq_u32(mask.v, vld1q_u32(kBits)));
+    }
+};
+#else
+using SimdLanes = ScalarLanes;
+#endif
+
+constexpr float kPi       = 3.14159265358979f;
+constexpr float kHalfPi   = 1.57079632679490f;
+constexpr float kInvTwoPi = 0.15915494309190f;
+// 2 pi split in two, so k * kTwoPiHi is exact for the k of a few turns
+constexpr float kTwoPiHi = 6.28125f;
+constexpr float kTwoPiLo = 0.00193530717958647f;
+
+template <typename L>
+L Sin(L x)
+{
+    // Reduce to [-pi, pi], then to [-pi/2, pi/2] with sin(x) = sin(pi - x)
+    const L k = Round(x * L::Set(kInvTwoPi));
+    x         = x - k * L::Set(kTwoPiHi) - k * L::Set(kTwoPiLo);
+    x         = Select(Greater(x, L::Set(kHalfPi)), L::Set(kPi) - x, x);
+    x         = Select(Less(x, L::Set(-kHalfPi)), L::Set(-kPi) - x, x);
+
+    // Taylor series up to x^11, error is below 1e-7 on [-pi/2, pi/2]
+    const L x2 = x * x;
+    L       p  = L::Set(-2.5052108e-8f);
+    p          = p * x2 + L::Set(2.7557319e-6f);
+    p          = p * x2 + L::Set(-1.9841270e-4f);
+    p          = p * x2 + L::Set(8.3333333e-3f);
+    p          = p * x2 + L::Set(-1.6666667e-1f);
+    p          = p * x2 + L::Set(1.0f);
+    return p * x;
+}
+
+template <typename L>
+L Cos(L x)
+{
+    return Sin(x + L::Set(kHalfPi));
+}
+
+// Column major like GLM, m[column][row]
+template <typename L>
+struct Matrix3
+{
+    L m[3][3];
+};
+
+template <typename L>
+Matrix3<L> Multiply(const Matrix3<L>& a, const Matrix3<L>& b)
+{
+    Matrix3<L> result;
+    for (uint32_t c = 0; c < 3; ++c) {
+        for (uint32_t r = 0; r < 3; ++r) {
+            result.m[c][r] = a.m[0][r] * b.m[c][0] + a.m[1][r] * b.m[c][1] + a.m[2][r] * b.m[c][2];
+        }
+    }
+    return result;
+}
+
+// Same matrices as glm::rotate() around the X, Y and Z axes
+template <typename L>
+Matrix3<L> RotationX(L s, L c)
+{
+    const L zero = L::Set(0.0f);
+    const L one  = L::Set(1.0f);
+    return {{{one, zero, zero}, {zero, c, s}, {zero, zero - s, c}}};
+}
+
+template <typename L>
+Matrix3<L> RotationY(L s, L c)
+{
+    const L zero = L::Set(0.0f);
+    const L one  = L::Set(1.0f);
+    return {{{c, zero, zero - s}, {zero, one, zero}, {s, zero, c}}};
+}
+
+template <typename L>
+Matrix3<L> RotationZ(L s, L c)
+{
+    const L zero = L::Set(0.0f);
+    const L one  = L::Set(1.0f);
+    return {{{c, s, zero}, {zero - s, c, zero}, {zero, zero, one}}};
+}
+
+template <typename L>
+Matrix3<L> Rotation(const L angles[3], ppx::Transform::RotationOrder rotationOrder)
+{
+    const Matrix3<L> xm = RotationX(Sin(angles[0]), Cos(angles[0]));
+    const Matrix3<L> ym = RotationY(Sin(angles[1]), Cos(angles[1]));
+    const Matrix3<L> zm = RotationZ(Sin(angles[2]), Cos(angles[2]));
+    switch (rotationOrder) {
+        default:
+        case ppx::Transform::RotationOrder::XYZ: return Multiply(Multiply(xm, ym), zm);
+        case ppx::Transform::RotationOrder::XZY: return Multiply(Multiply(xm, zm), ym);
+        case ppx::Transform::RotationOrder::YZX: return Multiply(Multiply(ym, zm), xm);
+        case ppx::Transform::RotationOrder::YXZ: return Multiply(Multiply(ym, xm), zm);
+        case ppx::Transform::RotationOrder::ZXY: return Multiply(Multiply(zm, xm), ym);
+        case ppx::Transform::RotationOrder::ZYX: return Multiply(Multiply(zm, ym), xm);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Kernels
+//
+// Each kernel processes objects from index begin in groups of L::kWidth
+// and returns the index of the first object it didn't process.
+// -------------------------------------------------------------------------------------------------
+template <typename L>
+uint32_t ComputeTransformMatricesKernel(const ppx::TransformArrays& transforms, ppx::Transform::RotationOrder rotationOrder, float4x4* pMatrices, uint32_t begin)
+{
+    using Component = ppx::TransformArrays::Component;
+
+    const uint32_t count = transforms.GetCount();
+
+    uint32_t i = begin;
+    for (; (i + L::kWidth) <= count; i += L::kWidth) {
+        L values[ppx::TransformArrays::COMPONENT_COUNT];
+        for (uint32_t j = 0; j < ppx::TransformArrays::COMPONENT_COUNT; ++j) {
+            values[j] = L::Load(transforms.GetComponent(static_cast<Component>(j)) + i);
+        }
+
+        const Matrix3<L> rotation = Rotation(values + ppx::TransformArrays::ROTATION_X, rotationOrder);
+
+        // T * R * S scales the columns of R
+        float columns[4][3][L::kWidth];
+        for (uint32_t c = 0; c < 3; ++c) {
+            const L scale = values[ppx::TransformArrays::SCALE_X + c];
+            for (uint32_t r = 0; r < 3; ++r) {
+                (rotation.m[c][r] * scale).Store(columns[c][r]);
+            }
+        }
+        for (uint32_t r = 0; r < 3; ++r) {
+            values[ppx::TransformArrays::TRANSLATION_X + r].Store(columns[3][r]);
+        }
+
+        for (uint32_t j = 0; j < L::kWidth; ++j) {
+            pMatrices[i + j] = float4x4(
+                float4(columns[0][0][j], columns[0][1][j], columns[0][2][j], 0.0f),
+                float4(columns[1][0][j], columns[1][1][j], columns[1][2][j], 0.0f),
+                float4(columns[2][0][j], columns[2][1][j], columns[2][2][j], 0.0f),
+                float4(columns[3][0][j], columns[3][1][j], columns[3][2][j], 1.0f));
+        }
+    }
+    return i;
+}
+
+template <typename L>
+uint32_t TransformAABBsKernel(const ppx::AABBArrays& bounds, const float4x4* pMatrices, ppx::AABBArrays* pTransformed, uint32_t begin)
+{
+    const uint32_t count = bounds.GetCount();
+
+    uint32_t i = begin;
+    for (; (i + L::kWidth) <= count; i += L::kWidth) {
+        // Matrices are stored per object, gather the upper 4x3
+        float elements[4][3][L::kWidth];
+        for (uint32_t j = 0; j < L::kWidth; ++j) {
+            const float4x4& matrix = pMatrices[i + j];
+            for (uint32_t c = 0; c < 4; ++c) {
+                for (uint32_t r = 0; r < 3; ++r) {
+                    elements[c][r][j] = matrix[c][r];
+                }
+            }
+        }
+
+        L center[3];
+        L extent[3];
+        for (uint32_t r = 0; r < 3; ++r) {
+            const L minValue = L::Load(bounds.GetComponent(static_cast<ppx::AABBArrays::Component>(ppx::AABBArrays::MIN_X + r)) + i);
+            const L maxValue = L::Load(bounds.GetComponent(static_cast<ppx::AABBArrays::Component>(ppx::AABBArrays::MAX_X + r)) + i);
+            center[r]        = (minValue + maxValue) * L::Set(0.5f);
+            extent[r]        = (maxValue - minValue) * L::Set(0.5f);
+        }
+
+        // The extent of the transformed box along an axis is the sum of the
+        // absolute projections of the box's half axes
+        for (uint32_t r = 0; r < 3; ++r) {
+            L transformedCenter = L::Load(elements[3][r]);
+            L transformedExtent = L::Set(0.0f);
+            for (uint32_t c = 0; c < 3; ++c) {
+                const L element   = L::Load(elements[c][r]);
+                transformedCenter = transformedCenter + element * center[c];
+                transformedExtent = transformedExtent + Abs(element) * extent[c];
+            }
+            (transformedCenter - transformedExtent).Store(pTransformed->GetComponent(static_cast<ppx::AABBArrays::Component>(ppx::AABBArrays::MIN_X + r)) + i);
+            (transformedCenter + transformedExtent).Store(pTransformed->GetComponent(static_cast<ppx::AABBArrays::Component>(ppx::AABBArrays::MAX_X + r)) + i);
+        }
+    }
+    return i;
+}
+
+template <typename L>
+uint32_t CullAABBsKernel(const ppx::Frustum& frustum, const ppx::AABBArrays& bounds, uint32_t* pVisibleIndices, uint32_t begin, uint32_t* pVisibleCount)
+{
+    const uint32_t count        = bounds.GetCount();
+    uint32_t       visibleCount = *pVisibleCount;
+
+    L planes[ppx::Frustum::PLANE_COUNT][4];
+    L absNormals[ppx::Frustum::PLANE_COUNT][3];
+    for (uint32_t p = 0; p < ppx::Frustum::PLANE_COUNT; ++p) {
+        const float4& plane = frustum.GetPlane(p);
+        for (uint32_t k = 0; k < 4; ++k) {
+            planes[p][k] = L::Set(plane[k]);
+        }
+        for (uint32_t k = 0; k < 3; ++k) {
+            absNormals[p][k] = L::Set(std::fabs(plane[k]));
+        }
+    }
+
+    uint32_t i = begin;
+    for (; (i + L::kWidth) <= count; i += L::kWidth) {
+        L center[3];
+        L extent[3];
+        for (uint32_t k = 0; k < 3; ++k) {
+            const L minValue = L::Load(bounds.GetComponent(static_cast<ppx::AABBArrays::Component>(ppx::AABBArrays::MIN_X + k)) + i);
+            const L maxValue = L::Load(bounds.GetComponent(static_cast<ppx::AABBArrays::Component>(ppx::AABBArrays::MAX_X + k)) + i);
+            center[k]        = (minValue + maxValue) * L::Set(0.5f);
+            extent[k]        = (maxValue - minValue) * L::Set(0.5f);
+        }
+
+        // Same test as Frustum::Overlaps(), without the early out
+        typename L::Mask visible = {};
+        for (uint32_t p = 0; p < ppx::Frustum::PLANE_COUNT; ++p) {
+            const L    distance = center[0] * planes[p][0] + center[1] * planes[p][1] + center[2] * planes[p][2] + planes[p][3];
+            const L    radius   = extent[0] * absNormals[p][0] + extent[1] * absNormals[p][1] + extent[2] * absNormals[p][2];
+            const auto inside   = GreaterEqual(distance, L::Set(0.0f) - radius);
+            visible             = (p == 0) ? inside : And(visible, inside);
+        }
+
+        // Writes an index for every object and only advances past the
+        // visible ones, visibleCount never passes i
+        const uint32_t bits = MoveMask(visible);
+        for (uint32_t j = 0; j < L::kWidth; ++j) {
+            pVisibleIndices[visibleCount] = i + j;
+            visibleCount += (bits >> j) & 1;
+        }
+    }
+
+    *pVisibleCount = visibleCount;
+    return i;
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// Batch functions
+// -------------------------------------------------------------------------------------------------
+void ComputeTransformMatrices(const ppx::TransformArrays& transforms, ppx::Transform::RotationOrder rotationOrder, float4x4* pMatrices)
+{
+    PPX_ASSERT_MSG((transforms.GetCount() == 0) || !IsNull(pMatrices), "pMatrices is null");
+
+    uint32_t i = ComputeTransformMatricesKernel<SimdLanes>(transforms, rotationOrder, pMatrices, 0);
+    ComputeTransformMatricesKernel<ScalarLanes>(transforms, rotationOrder, pMatrices, i);
+}
+
+void TransformAABBs(const ppx::AABBArrays& bounds, const float4x4* pMatrices, ppx::AABBArrays* pTransformed)
+{
+    PPX_ASSERT_NULL_ARG(pTransformed);
+    PPX_ASSERT_MSG((bounds.GetCount() == 0) || !IsNull(pMatrices), "pMatrices is null");
+    PPX_ASSERT_MSG(pTransformed != &bounds, "bounds can't be transformed in place");
+
+    pTransformed->Resize(bounds.GetCount());
+
+    uint32_t i = TransformAABBsKernel<SimdLanes>(bounds, pMatrices, pTransformed, 0);
+    TransformAABBsKernel<ScalarLanes>(bounds, pMatrices, pTransformed, i);
+}
+
+uint32_t CullAABBs(const ppx::Frustum& frustum, const ppx::AABBArrays& bounds, uint32_t* pVisibleIndices)
+{
+    PPX_ASSERT_MSG((bounds.GetCount() == 0) || !IsNull(pVisibleIndices), "pVisibleIndices is null");
+
+    uint32_t visibleCount = 0;
+    uint32_t i            = CullAABBsKernel<SimdLanes>(frustum, bounds, pVisibleIndices, 0, &visibleCount);
+    CullAABBsKernel<ScalarLanes>(frustum, bounds, pVisibleIndices, i, &visibleCount);
+    return visibleCount;
+}
+
+} // namespace ppx
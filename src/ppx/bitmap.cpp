@@ -17,19 +17,630 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
-
 #define STB_IMAGE_RESIZE_IMPLEMENTATION
 #include "stb_image_resize.h"
 
 #include "ppx/fs.h"
+#include "ppx/image_encoder.h"
+#include "ppx/platform.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+
+#if defined(PPX_ENABLE_TURBOJPEG)
+#include <turbojpeg.h>
+#endif
+
+#if defined(PPX_ENABLE_SPNG)
+#include <spng.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PPX_BITMAP_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PPX_BITMAP_NEON
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit SIMD instructions the target allows, MSVC emits
+// any intrinsic
+#if defined(PPX_BITMAP_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PPX_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define PPX_TARGET_AVX2  __attribute__((target("avx2")))
+#else
+#define PPX_TARGET_SSE41
+#define PPX_TARGET_AVX2
+#endif
 
 namespace ppx {
 
 static const char*  kRadianceSig     = "#?RADIANCE";
 static const size_t kRadianceSigSize = 10;
 
+// -------------------------------------------------------------------------------------------------
+// Conversion kernels
+//
+// Scalar kernels work for every CPU, SIMD kernels are picked at runtime
+// from the CPU features. Every kernel rounds like its scalar version, so
+// results don't depend on the CPU.
+// -------------------------------------------------------------------------------------------------
+namespace {
+
+constexpr float kInv255   = 1.0f / 255.0f;
+constexpr float kInv65535 = 1.0f / 65535.0f;
+
+template <typename T>
+T ClampToUnorm(float value, float maxValue)
+{
+    // NaN becomes 0, same as the SIMD kernels
+    value = std::max(0.0f, std::min(value, 1.0f));
+    return static_cast<T>(value * maxValue + 0.5f);
+}
+
+void Convert8uTo16uScalar(const uint8_t* pSrc, uint16_t* pDst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        pDst[i] = static_cast<uint16_t>(pSrc[i] * 257);
+    }
+}
+
+void Convert16uTo8uScalar(const uint16_t* pSrc, uint8_t* pDst, uint32_t count)
+{
+    // round(x / 257)
+    for (uint32_t i = 0; i < count; ++i) {
+        pDst[i] = static_cast<uint8_t>((pSrc[i] * 255u + 32895u) >> 16);
+    }
+}
+
+void Convert8uTo32fScalar(const uint8_t* pSrc, float* pDst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        pDst[i] = static_cast<float>(pSrc[i]) * kInv255;
+    }
+}
+
+void Convert32fTo8uScalar(const float* pSrc, uint8_t* pDst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        pDst[i] = ClampToUnorm<uint8_t>(pSrc[i], 255.0f);
+    }
+}
+
+void Convert16uTo32fScalar(const uint16_t* pSrc, float* pDst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        pDst[i] = static_cast<float>(pSrc[i]) * kInv65535;
+    }
+}
+
+void Convert32fTo16uScalar(const float* pSrc, uint16_t* pDst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        pDst[i] = ClampToUnorm<uint16_t>(pSrc[i], 65535.0f);
+    }
+}
+
+void ExpandRgb8ToRgba8Scalar(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
+{
+    for (uint32_t i = 0; i < pixelCount; ++i, pSrc += 3, pDst += 4) {
+        pDst[0] = pSrc[0];
+        pDst[1] = pSrc[1];
+        pDst[2] = pSrc[2];
+        pDst[3] = 0xFF;
+    }
+}
+
+// round(c * a / 255)
+uint8_t MultiplyUnorm8(uint32_t c, uint32_t a)
+{
+    const uint32_t t = c * a + 128;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+void PremultiplyRgba8Scalar(uint8_t* pPixels, uint32_t pixelCount)
+{
+    for (uint32_t i = 0; i < pixelCount; ++i, pPixels += 4) {
+        const uint32_t a = pPixels[3];
+        pPixels[0]       = MultiplyUnorm8(pPixels[0], a);
+        pPixels[1]       = MultiplyUnorm8(pPixels[1], a);
+        pPixels[2]       = MultiplyUnorm8(pPixels[2], a);
+    }
+}
+
+#if defined(PPX_BITMAP_X86)
+PPX_TARGET_SSE41 void Convert8uTo16uSse41(const uint8_t* pSrc, uint16_t* pDst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; (i + 16) <= count; i += 16) {
+        // x * 257 is x in both bytes
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), _mm_unpacklo_epi8(v, v));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i + 8), _mm_unpackhi_epi8(v, v));
+    }
+    Convert8uTo16uScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_SSE41 void Convert16uTo8uSse41(const uint16_t* pSrc, uint8_t* pDst, uint32_t count)
+{
+    const __m128i k255   = _mm_set1_epi32(255);
+    const __m128i kRound = _mm_set1_epi32(32895);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        __m128i       lo = _mm_cvtepu16_epi32(v);
+        __m128i       hi = _mm_cvtepu16_epi32(_mm_srli_si128(v, 8));
+        lo               = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(lo, k255), kRound), 16);
+        hi               = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi32(hi, k255), kRound), 16);
+        const __m128i p  = _mm_packus_epi16(_mm_packus_epi32(lo, hi), _mm_setzero_si128());
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + i), p);
+    }
+    Convert16uTo8uScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_SSE41 void Convert8uTo32fSse41(const uint8_t* pSrc, float* pDst, uint32_t count)
+{
+    const __m128 kScale = _mm_set1_ps(kInv255);
+
+    uint32_t i = 0;
+    for (; (i + 4) <= count; i += 4) {
+        int32_t bytes = 0;
+        memcpy(&bytes, pSrc + i, sizeof(bytes));
+        const __m128i v = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(bytes));
+        _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(v), kScale));
+    }
+    Convert8uTo32fScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_SSE41 void Convert32fTo8uSse41(const float* pSrc, uint8_t* pDst, uint32_t count)
+{
+    const __m128 kZero  = _mm_setzero_ps();
+    const __m128 kOne   = _mm_set1_ps(1.0f);
+    const __m128 kMax   = _mm_set1_ps(255.0f);
+    const __m128 kRound = _mm_set1_ps(0.5f);
+
+    uint32_t i = 0;
+    for (; (i + 4) <= count; i += 4) {
+        // minps/maxps return the second operand for NaN, so NaN becomes 0
+        __m128 v = _mm_loadu_ps(pSrc + i);
+        v        = _mm_max_ps(kZero, _mm_min_ps(kOne, v));
+        v        = _mm_add_ps(_mm_mul_ps(v, kMax), kRound);
+
+        const __m128i n  = _mm_cvttps_epi32(v);
+        const __m128i p  = _mm_packus_epi16(_mm_packus_epi32(n, n), _mm_setzero_si128());
+        const int32_t px = _mm_cvtsi128_si32(p);
+        memcpy(pDst + i, &px, sizeof(px));
+    }
+    Convert32fTo8uScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_SSE41 void Convert16uTo32fSse41(const uint16_t* pSrc, float* pDst, uint32_t count)
+{
+    const __m128 kScale = _mm_set1_ps(kInv65535);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const __m128i v  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i));
+        const __m128i lo = _mm_cvtepu16_epi32(v);
+        const __m128i hi = _mm_cvtepu16_epi32(_mm_srli_si128(v, 8));
+        _mm_storeu_ps(pDst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), kScale));
+        _mm_storeu_ps(pDst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), kScale));
+    }
+    Convert16uTo32fScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_SSE41 void Convert32fTo16uSse41(const float* pSrc, uint16_t* pDst, uint32_t count)
+{
+    const __m128 kZero  = _mm_setzero_ps();
+    const __m128 kOne   = _mm_set1_ps(1.0f);
+    const __m128 kMax   = _mm_set1_ps(65535.0f);
+    const __m128 kRound = _mm_set1_ps(0.5f);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        __m128 lo = _mm_loadu_ps(pSrc + i);
+        __m128 hi = _mm_loadu_ps(pSrc + i + 4);
+        lo        = _mm_add_ps(_mm_mul_ps(_mm_max_ps(kZero, _mm_min_ps(kOne, lo)), kMax), kRound);
+        hi        = _mm_add_ps(_mm_mul_ps(_mm_max_ps(kZero, _mm_min_ps(kOne, hi)), kMax), kRound);
+
+        const __m128i p = _mm_packus_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), p);
+    }
+    Convert32fTo16uScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_SSE41 void ExpandRgb8ToRgba8Sse41(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
+{
+    const __m128i kShuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i kAlpha   = _mm_set1_epi32(static_cast<int32_t>(0xFF000000));
+
+    // Each 16 byte load holds 4 pixels and 4 bytes of the next ones,
+    // stop while the load stays inside the source
+    uint32_t i = 0;
+    for (; ((i + 4) * 3 + 4) <= (pixelCount * 3); i += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i * 3));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, kShuffle), kAlpha));
+    }
+    ExpandRgb8ToRgba8Scalar(pSrc + i * 3, pDst + i * 4, pixelCount - i);
+}
+
+PPX_TARGET_SSE41 void PremultiplyRgba8Sse41(uint8_t* pPixels, uint32_t pixelCount)
+{
+    const __m128i kRound     = _mm_set1_epi16(128);
+    const __m128i kAlphaMask = _mm_set1_epi32(static_cast<int32_t>(0xFF000000));
+
+    // 8 bit channels widened to 16 bits, 2 pixels per half
+    auto multiply = [&](__m128i c) {
+        const __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        const __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), kRound);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    };
+
+    uint32_t i = 0;
+    for (; (i + 4) <= pixelCount; i += 4) {
+        __m128i*      pVector = reinterpret_cast<__m128i*>(pPixels + i * 4);
+        const __m128i v       = _mm_loadu_si128(pVector);
+        const __m128i lo      = multiply(_mm_cvtepu8_epi16(v));
+        const __m128i hi      = multiply(_mm_unpackhi_epi8(v, _mm_setzero_si128()));
+        const __m128i color   = _mm_packus_epi16(lo, hi);
+        _mm_storeu_si128(pVector, _mm_blendv_epi8(color, v, kAlphaMask));
+    }
+    PremultiplyRgba8Scalar(pPixels + i * 4, pixelCount - i);
+}
+
+PPX_TARGET_AVX2 void Convert8uTo32fAvx2(const uint8_t* pSrc, float* pDst, uint32_t count)
+{
+    const __m256 kScale = _mm256_set1_ps(kInv255);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const __m256i v = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), kScale));
+    }
+    Convert8uTo32fScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_AVX2 void Convert32fTo8uAvx2(const float* pSrc, uint8_t* pDst, uint32_t count)
+{
+    const __m256 kZero  = _mm256_setzero_ps();
+    const __m256 kOne   = _mm256_set1_ps(1.0f);
+    const __m256 kMax   = _mm256_set1_ps(255.0f);
+    const __m256 kRound = _mm256_set1_ps(0.5f);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(pSrc + i);
+        v        = _mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(kZero, _mm256_min_ps(kOne, v)), kMax), kRound);
+
+        // Packing works within 128 bit lanes, so pack the two halves
+        const __m256i n = _mm256_cvttps_epi32(v);
+        const __m128i w = _mm_packus_epi32(_mm256_castsi256_si128(n), _mm256_extracti128_si256(n, 1));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(pDst + i), _mm_packus_epi16(w, w));
+    }
+    Convert32fTo8uScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_AVX2 void Convert16uTo32fAvx2(const uint16_t* pSrc, float* pDst, uint32_t count)
+{
+    const __m256 kScale = _mm256_set1_ps(kInv65535);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const __m256i v = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + i)));
+        _mm256_storeu_ps(pDst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), kScale));
+    }
+    Convert16uTo32fScalar(pSrc + i, pDst + i, count - i);
+}
+
+PPX_TARGET_AVX2 void Convert32fTo16uAvx2(const float* pSrc, uint16_t* pDst, uint32_t count)
+{
+    const __m256 kZero  = _mm256_setzero_ps();
+    const __m256 kOne   = _mm256_set1_ps(1.0f);
+    const __m256 kMax   = _mm256_set1_ps(65535.0f);
+    const __m256 kRound = _mm256_set1_ps(0.5f);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        __m256 v = _mm256_loadu_ps(pSrc + i);
+        v        = _mm256_add_ps(_mm256_mul_ps(_mm256_max_ps(kZero, _mm256_min_ps(kOne, v)), kMax), kRound);
+
+        const __m256i n = _mm256_cvttps_epi32(v);
+        const __m128i p = _mm_packus_epi32(_mm256_castsi256_si128(n), _mm256_extracti128_si256(n, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + i), p);
+    }
+    Convert32fTo16uScalar(pSrc + i, pDst + i, count - i);
+}
+#endif // defined(PPX_BITMAP_X86)
+
+#if defined(PPX_BITMAP_NEON)
+void Convert8uTo16uNeon(const uint8_t* pSrc, uint16_t* pDst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; (i + 16) <= count; i += 16) {
+        const uint8x16_t v = vld1q_u8(pSrc + i);
+        vst1q_u16(pDst + i, vreinterpretq_u16_u8(vzip1q_u8(v, v)));
+        vst1q_u16(pDst + i + 8, vreinterpretq_u16_u8(vzip2q_u8(v, v)));
+    }
+    Convert8uTo16uScalar(pSrc + i, pDst + i, count - i);
+}
+
+void Convert16uTo8uNeon(const uint16_t* pSrc, uint8_t* pDst, uint32_t count)
+{
+    const uint32x4_t kRound = vdupq_n_u32(32895);
+
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const uint16x8_t v  = vld1q_u16(pSrc + i);
+        const uint32x4_t lo = vshrq_n_u32(vmlal_n_u16(kRound, vget_low_u16(v), 255), 16);
+        const uint32x4_t hi = vshrq_n_u32(vmlal_n_u16(kRound, vget_high_u16(v), 255), 16);
+        vst1_u8(pDst + i, vmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi))));
+    }
+    Convert16uTo8uScalar(pSrc + i, pDst + i, count - i);
+}
+
+void Convert8uTo32fNeon(const uint8_t* pSrc, float* pDst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const uint16x8_t v = vmovl_u8(vld1_u8(pSrc + i));
+        vst1q_f32(pDst + i, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), kInv255));
+        vst1q_f32(pDst + i + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), kInv255));
+    }
+    Convert8uTo32fScalar(pSrc + i, pDst + i, count - i);
+}
+
+uint32x4_t ClampToUnormNeon(float32x4_t v, float maxValue)
+{
+    // vmaxq/vminq return NaN for NaN, which converts to 0
+    v = vmaxq_f32(vdupq_n_f32(0.0f), vminq_f32(v, vdupq_n_f32(1.0f)));
+    return vcvtq_u32_f32(vaddq_f32(vmulq_n_f32(v, maxValue), vdupq_n_f32(0.5f)));
+}
+
+void Convert32fTo8uNeon(const float* pSrc, uint8_t* pDst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const uint32x4_t lo = ClampToUnormNeon(vld1q_f32(pSrc + i), 255.0f);
+        const uint32x4_t hi = ClampToUnormNeon(vld1q_f32(pSrc + i + 4), 255.0f);
+        vst1_u8(pDst + i, vmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi))));
+    }
+    Convert32fTo8uScalar(pSrc + i, pDst + i, count - i);
+}
+
+void Convert16uTo32fNeon(const uint16_t* pSrc, float* pDst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const uint16x8_t v = vld1q_u16(pSrc + i);
+        vst1q_f32(pDst + i, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(v))), kInv65535));
+        vst1q_f32(pDst + i + 4, vmulq_n_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(v))), kInv65535));
+    }
+    Convert16uTo32fScalar(pSrc + i, pDst + i, count - i);
+}
+
+void Convert32fTo16uNeon(const float* pSrc, uint16_t* pDst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; (i + 8) <= count; i += 8) {
+        const uint32x4_t lo = ClampToUnormNeon(vld1q_f32(pSrc + i), 65535.0f);
+        const uint32x4_t hi = ClampToUnormNeon(vld1q_f32(pSrc + i + 4), 65535.0f);
+        vst1q_u16(pDst + i, vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+    }
+    Convert32fTo16uScalar(pSrc + i, pDst + i, count - i);
+}
+
+void ExpandRgb8ToRgba8Neon(const uint8_t* pSrc, uint8_t* pDst, uint32_t pixelCount)
+{
+    uint32_t i = 0;
+    for (; (i + 16) <= pixelCount; i += 16) {
+        const uint8x16x3_t rgb  = vld3q_u8(pSrc + i * 3);
+        uint8x16x4_t       rgba = {{rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(0xFF)}};
+        vst4q_u8(pDst + i * 4, rgba);
+    }
+    ExpandRgb8ToRgba8Scalar(pSrc + i * 3, pDst + i * 4, pixelCount - i);
+}
+
+uint8x8_t MultiplyUnorm8Neon(uint8x8_t c, uint8x8_t a)
+{
+    const uint16x8_t t = vaddq_u16(vmull_u8(c, a), vdupq_n_u16(128));
+    return vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+}
+
+void PremultiplyRgba8Neon(uint8_t* pPixels, uint32_t pixelCount)
+{
+    uint32_t i = 0;
+    for (; (i + 8) <= pixelCount; i += 8) {
+        uint8x8x4_t v = vld4_u8(pPixels + i * 4);
+        v.val[0]      = MultiplyUnorm8Neon(v.val[0], v.val[3]);
+        v.val[1]      = MultiplyUnorm8Neon(v.val[1], v.val[3]);
+        v.val[2]      = MultiplyUnorm8Neon(v.val[2], v.val[3]);
+        vst4_u8(pPixels + i * 4, v);
+    }
+    PremultiplyRgba8Scalar(pPixels + i * 4, pixelCount - i);
+}
+#endif // defined(PPX_BITMAP_NEON)
+
+struct BitmapKernels
+{
+    void (*pConvert8uTo16u)(const uint8_t*, uint16_t*, uint32_t)   = Convert8uTo16uScalar;
+    void (*pConvert16uTo8u)(const uint16_t*, uint8_t*, uint32_t)   = Convert16uTo8uScalar;
+    void (*pConvert8uTo32f)(const uint8_t*, float*, uint32_t)      = Convert8uTo32fScalar;
+    void (*pConvert32fTo8u)(const float*, uint8_t*, uint32_t)      = Convert32fTo8uScalar;
+    void (*pConvert16uTo32f)(const uint16_t*, float*, uint32_t)    = Convert16uTo32fScalar;
+    void (*pConvert32fTo16u)(const float*, uint16_t*, uint32_t)    = Convert32fTo16uScalar;
+    void (*pExpandRgb8ToRgba8)(const uint8_t*, uint8_t*, uint32_t) = ExpandRgb8ToRgba8Scalar;
+    void (*pPremultiplyRgba8)(uint8_t*, uint32_t)                  = PremultiplyRgba8Scalar;
+};
+
+BitmapKernels SelectKernels()
+{
+    BitmapKernels kernels = {};
+#if defined(PPX_BITMAP_X86)
+    const CpuInfo::Features& features = Platform::GetCpuInfo().GetFeatures();
+    if (features.ssse3 && features.sse4_1) {
+        kernels.pConvert8uTo16u    = Convert8uTo16uSse41;
+        kernels.pConvert16uTo8u    = Convert16uTo8uSse41;
+        kernels.pConvert8uTo32f    = Convert8uTo32fSse41;
+        kernels.pConvert32fTo8u    = Convert32fTo8uSse41;
+        kernels.pConvert16uTo32f   = Convert16uTo32fSse41;
+        kernels.pConvert32fTo16u   = Convert32fTo16uSse41;
+        kernels.pExpandRgb8ToRgba8 = ExpandRgb8ToRgba8Sse41;
+        kernels.pPremultiplyRgba8  = PremultiplyRgba8Sse41;
+    }
+    if (features.avx2) {
+        kernels.pConvert8uTo32f  = Convert8uTo32fAvx2;
+        kernels.pConvert32fTo8u  = Convert32fTo8uAvx2;
+        kernels.pConvert16uTo32f = Convert16uTo32fAvx2;
+        kernels.pConvert32fTo16u = Convert32fTo16uAvx2;
+    }
+#elif defined(PPX_BITMAP_NEON)
+    kernels.pConvert8uTo16u    = Convert8uTo16uNeon;
+    kernels.pConvert16uTo8u    = Convert16uTo8uNeon;
+    kernels.pConvert8uTo32f    = Convert8uTo32fNeon;
+    kernels.pConvert32fTo8u    = Convert32fTo8uNeon;
+    kernels.pConvert16uTo32f   = Convert16uTo32fNeon;
+    kernels.pConvert32fTo16u   = Convert32fTo16uNeon;
+    kernels.pExpandRgb8ToRgba8 = ExpandRgb8ToRgba8Neon;
+    kernels.pPremultiplyRgba8  = PremultiplyRgba8Neon;
+#endif
+    return kernels;
+}
+
+const BitmapKernels& GetKernels()
+{
+    static const BitmapKernels sKernels = SelectKernels();
+    return sKernels;
+}
+
+// Largest value of a normalized channel
+template <typename T>
+double GetUnormMax()
+{
+    return std::is_floating_point<T>::value ? 1.0 : static_cast<double>(std::numeric_limits<T>::max());
+}
+
+// Conversions without a kernel, all the ones with 32 bit integers
+template <typename SrcT, typename DstT>
+void ConvertScalars(const SrcT* pSrc, DstT* pDst, uint32_t count)
+{
+    const double scale = GetUnormMax<DstT>() / GetUnormMax<SrcT>();
+    for (uint32_t i = 0; i < count; ++i) {
+        const double value = static_cast<double>(pSrc[i]) * scale;
+        if constexpr (std::is_floating_point<DstT>::value) {
+            pDst[i] = static_cast<DstT>(value);
+        }
+        else {
+            pDst[i] = static_cast<DstT>(std::max(0.0, std::min(value, GetUnormMax<DstT>())) + 0.5);
+        }
+    }
+}
+
+template <typename SrcT>
+void ConvertScalars(const SrcT* pSrc, Bitmap::DataType dstType, void* pDst, uint32_t count)
+{
+    // clang-format off
+    switch (dstType) {
+        default: break;
+        case Bitmap::DATA_TYPE_UINT8  : ConvertScalars(pSrc, static_cast<uint8_t*>(pDst), count); break;
+        case Bitmap::DATA_TYPE_UINT16 : ConvertScalars(pSrc, static_cast<uint16_t*>(pDst), count); break;
+        case Bitmap::DATA_TYPE_UINT32 : ConvertScalars(pSrc, static_cast<uint32_t*>(pDst), count); break;
+        case Bitmap::DATA_TYPE_FLOAT  : ConvertScalars(pSrc, static_cast<float*>(pDst), count); break;
+    }
+    // clang-format on
+}
+
+void ConvertScalars(const void* pSrc, Bitmap::DataType srcType, void* pDst, Bitmap::DataType dstType, uint32_t count)
+{
+    const BitmapKernels& kernels = GetKernels();
+
+    const uint8_t*  pSrc8u  = static_cast<const uint8_t*>(pSrc);
+    const uint16_t* pSrc16u = static_cast<const uint16_t*>(pSrc);
+    const float*    pSrc32f = static_cast<const float*>(pSrc);
+    if ((srcType == Bitmap::DATA_TYPE_UINT8) && (dstType == Bitmap::DATA_TYPE_UINT16)) {
+        kernels.pConvert8uTo16u(pSrc8u, static_cast<uint16_t*>(pDst), count);
+    }
+    else if ((srcType == Bitmap::DATA_TYPE_UINT16) && (dstType == Bitmap::DATA_TYPE_UINT8)) {
+        kernels.pConvert16uTo8u(pSrc16u, static_cast<uint8_t*>(pDst), count);
+    }
+    else if ((srcType == Bitmap::DATA_TYPE_UINT8) && (dstType == Bitmap::DATA_TYPE_FLOAT)) {
+        kernels.pConvert8uTo32f(pSrc8u, static_cast<float*>(pDst), count);
+    }
+    else if ((srcType == Bitmap::DATA_TYPE_FLOAT) && (dstType == Bitmap::DATA_TYPE_UINT8)) {
+        kernels.pConvert32fTo8u(pSrc32f, static_cast<uint8_t*>(pDst), count);
+    }
+    else if ((srcType == Bitmap::DATA_TYPE_UINT16) && (dstType == Bitmap::DATA_TYPE_FLOAT)) {
+        kernels.pConvert16uTo32f(pSrc16u, static_cast<float*>(pDst), count);
+    }
+    else if ((srcType == Bitmap::DATA_TYPE_FLOAT) && (dstType == Bitmap::DATA_TYPE_UINT16)) {
+        kernels.pConvert32fTo16u(pSrc32f, static_cast<uint16_t*>(pDst), count);
+    }
+    else {
+        // clang-format off
+        switch (srcType) {
+            default: break;
+            case Bitmap::DATA_TYPE_UINT8  : ConvertScalars(pSrc8u, dstType, pDst, count); break;
+            case Bitmap::DATA_TYPE_UINT16 : ConvertScalars(pSrc16u, dstType, pDst, count); break;
+            case Bitmap::DATA_TYPE_UINT32 : ConvertScalars(static_cast<const uint32_t*>(pSrc), dstType, pDst, count); break;
+            case Bitmap::DATA_TYPE_FLOAT  : ConvertScalars(pSrc32f, dstType, pDst, count); break;
+        }
+        // clang-format on
+    }
+}
+
+// Missing color channels are 0 and missing alpha is opaque
+template <typename T>
+void RemapChannels(const T* pSrc, uint32_t srcChannelCount, T* pDst, uint32_t dstChannelCount, uint32_t pixelCount)
+{
+    if ((sizeof(T) == 1) && (srcChannelCount == 3) && (dstChannelCount == 4)) {
+        GetKernels().pExpandRgb8ToRgba8(reinterpret_cast<const uint8_t*>(pSrc), reinterpret_cast<uint8_t*>(pDst), pixelCount);
+        return;
+    }
+
+    const T opaque = static_cast<T>(GetUnormMax<T>());
+    for (uint32_t i = 0; i < pixelCount; ++i, pSrc += srcChannelCount, pDst += dstChannelCount) {
+        for (uint32_t c = 0; c < dstChannelCount; ++c) {
+            pDst[c] = (c < srcChannelCount) ? pSrc[c] : ((c == 3) ? opaque : T(0));
+        }
+    }
+}
+
+void RemapChannels(const void* pSrc, Bitmap::DataType type, uint32_t srcChannelCount, void* pDst, uint32_t dstChannelCount, uint32_t pixelCount)
+{
+    // clang-format off
+    switch (type) {
+        default: break;
+        case Bitmap::DATA_TYPE_UINT8  : RemapChannels(static_cast<const uint8_t*>(pSrc), srcChannelCount, static_cast<uint8_t*>(pDst), dstChannelCount, pixelCount); break;
+        case Bitmap::DATA_TYPE_UINT16 : RemapChannels(static_cast<const uint16_t*>(pSrc), srcChannelCount, static_cast<uint16_t*>(pDst), dstChannelCount, pixelCount); break;
+        case Bitmap::DATA_TYPE_UINT32 : RemapChannels(static_cast<const uint32_t*>(pSrc), srcChannelCount, static_cast<uint32_t*>(pDst), dstChannelCount, pixelCount); break;
+        case Bitmap::DATA_TYPE_FLOAT  : RemapChannels(static_cast<const float*>(pSrc), srcChannelCount, static_cast<float*>(pDst), dstChannelCount, pixelCount); break;
+    }
+    // clang-format on
+}
+
+template <typename T>
+void PremultiplyRgba(T* pPixels, uint32_t pixelCount)
+{
+    for (uint32_t i = 0; i < pixelCount; ++i, pPixels += 4) {
+        if constexpr (std::is_floating_point<T>::value) {
+            pPixels[0] *= pPixels[3];
+            pPixels[1] *= pPixels[3];
+            pPixels[2] *= pPixels[3];
+        }
+        else {
+            const double a = static_cast<double>(pPixels[3]) / GetUnormMax<T>();
+            pPixels[0]     = static_cast<T>(pPixels[0] * a + 0.5);
+            pPixels[1]     = static_cast<T>(pPixels[1] * a + 0.5);
+            pPixels[2]     = static_cast<T>(pPixels[2] * a + 0.5);
+        }
+    }
+}
+
+} // namespace
+
 // -------------------------------------------------------------------------------------------------
 // Bitmap
 // -------------------------------------------------------------------------------------------------
@@ -311,6 +922,111 @@ Result Bitmap::ScaleTo(Bitmap* pTargetBitmap, stbir_filter filterType) const
     return ppx::SUCCESS;
 }
 
+Result Bitmap::ConvertTo(Bitmap::Format format, Bitmap* pTargetBitmap) const
+{
+    if (IsNull(pTargetBitmap)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (pTargetBitmap == this) {
+        return ppx::ERROR_RANGE_ALIASING_NOT_ALLOWED;
+    }
+    if (!IsOk()) {
+        return ppx::ERROR_BITMAP_BAD_COPY_SOURCE;
+    }
+    if (format == Bitmap::FORMAT_UNDEFINED) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    bool matches = pTargetBitmap->IsOk() && (pTargetBitmap->GetFormat() == format);
+    matches      = matches && (pTargetBitmap->GetWidth() == mWidth) && (pTargetBitmap->GetHeight() == mHeight);
+    if (!matches) {
+        Result ppxres = Bitmap::Create(mWidth, mHeight, format, pTargetBitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    const Bitmap::DataType srcType         = ChannelDataType(mFormat);
+    const Bitmap::DataType dstType         = ChannelDataType(format);
+    const uint32_t         dstChannelCount = ChannelCount(format);
+    const bool             remap           = (mChannelCount != dstChannelCount);
+
+    // Channels are remapped in the source type first, in place if the
+    // types match
+    std::vector<char> remapped;
+    if (remap && (srcType != dstType)) {
+        remapped.resize(static_cast<size_t>(mWidth) * dstChannelCount * ChannelSize(mFormat));
+    }
+
+    for (uint32_t y = 0; y < mHeight; ++y) {
+        const char* pSrcRow = mData + static_cast<size_t>(y) * mRowStride;
+        char*       pDstRow = pTargetBitmap->GetData() + static_cast<size_t>(y) * pTargetBitmap->GetRowStride();
+        if (remap) {
+            char* pRemappedRow = remapped.empty() ? pDstRow : remapped.data();
+            RemapChannels(pSrcRow, srcType, mChannelCount, pRemappedRow, dstChannelCount, mWidth);
+            pSrcRow = pRemappedRow;
+        }
+
+        if (pSrcRow == pDstRow) {
+            continue;
+        }
+        if (srcType == dstType) {
+            memcpy(pDstRow, pSrcRow, static_cast<size_t>(mWidth) * mPixelStride);
+            continue;
+        }
+        ConvertScalars(pSrcRow, srcType, pDstRow, dstType, mWidth * dstChannelCount);
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Bitmap::PremultiplyAlpha()
+{
+    if (!IsOk()) {
+        return ppx::ERROR_FAILED;
+    }
+    if (mChannelCount != 4) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const Bitmap::DataType type = ChannelDataType(mFormat);
+    for (uint32_t y = 0; y < mHeight; ++y) {
+        char* pRow = mData + static_cast<size_t>(y) * mRowStride;
+
+        // clang-format off
+        switch (type) {
+            default: break;
+            case Bitmap::DATA_TYPE_UINT8  : GetKernels().pPremultiplyRgba8(reinterpret_cast<uint8_t*>(pRow), mWidth); break;
+            case Bitmap::DATA_TYPE_UINT16 : PremultiplyRgba(reinterpret_cast<uint16_t*>(pRow), mWidth); break;
+            case Bitmap::DATA_TYPE_UINT32 : PremultiplyRgba(reinterpret_cast<uint32_t*>(pRow), mWidth); break;
+            case Bitmap::DATA_TYPE_FLOAT  : PremultiplyRgba(reinterpret_cast<float*>(pRow), mWidth); break;
+        }
+        // clang-format on
+    }
+
+    return ppx::SUCCESS;
+}
+
+void Bitmap::InternalFill(const void* pPixel)
+{
+    if ((mWidth == 0) || (mHeight == 0)) {
+        return;
+    }
+
+    // The first row doubles its filled part with each copy, the other rows
+    // are copies of it
+    const size_t rowSize = static_cast<size_t>(mWidth) * mPixelStride;
+    memcpy(mData, pPixel, mPixelStride);
+    for (size_t filled = mPixelStride; filled < rowSize;) {
+        const size_t size = std::min(filled, rowSize - filled);
+        memcpy(mData + filled, mData, size);
+        filled += size;
+    }
+    for (uint32_t y = 1; y < mHeight; ++y) {
+        memcpy(mData + static_cast<size_t>(y) * mRowStride, mData, rowSize);
+    }
+}
+
 char* Bitmap::GetPixelAddress(uint32_t x, uint32_t y)
 {
     char* pPixel = nullptr;
@@ -607,32 +1323,175 @@ Result Bitmap::GetFileProperties(const std::filesystem::path& path, uint32_t* pW
     return ppx::SUCCESS;
 }
 
-char* Bitmap::StbiLoad(const std::filesystem::path& path, Bitmap::Format format, int* pWidth, int* pHeight, int* pChannels, int desiredChannels)
+// -------------------------------------------------------------------------------------------------
+// Decoders
+//
+// Optional backends decode 8-bit RGBA straight into the bitmap's storage. Each
+// one only takes data with its signature, stb_image handles what's left and
+// Radiance files.
+// -------------------------------------------------------------------------------------------------
+struct BitmapDecoder
 {
-    ppx::fs::File file;
-    if (!file.Open(path)) {
-        return nullptr;
+    Bitmap::Decoder decoder;
+    // Returns true if pData has the backend's file signature
+    bool (*pfnAccepts)(size_t dataSize, const uint8_t* pData);
+    // Returns false if the backend can't decode pData
+    bool (*pfnGetSize)(size_t dataSize, const uint8_t* pData, uint32_t* pWidth, uint32_t* pHeight);
+    bool (*pfnDecode)(size_t dataSize, const uint8_t* pData, uint32_t width, uint32_t height, uint32_t rowStride, char* pDst);
+};
+
+#if defined(PPX_ENABLE_TURBOJPEG)
+static bool TurboJpegAccepts(size_t dataSize, const uint8_t* pData)
+{
+    return (dataSize >= 3) && (pData[0] == 0xFF) && (pData[1] == 0xD8) && (pData[2] == 0xFF);
+}
+
+static bool TurboJpegGetSize(size_t dataSize, const uint8_t* pData, uint32_t* pWidth, uint32_t* pHeight)
+{
+    tjhandle handle = tjInitDecompress();
+    if (IsNull(handle)) {
+        return false;
     }
+    int  width      = 0;
+    int  height     = 0;
+    int  subsamp    = 0;
+    int  colorspace = 0;
+    bool ok         = (tjDecompressHeader3(handle, pData, static_cast<unsigned long>(dataSize), &width, &height, &subsamp, &colorspace) == 0);
+    tjDestroy(handle);
+
+    *pWidth  = static_cast<uint32_t>(width);
+    *pHeight = static_cast<uint32_t>(height);
+    return ok;
+}
 
-    std::vector<stbi_uc> buffer(0);
-    if (!file.IsMapped()) {
-        buffer.resize(file.GetLength());
-        file.Read(buffer.data(), buffer.size());
+static bool TurboJpegDecode(size_t dataSize, const uint8_t* pData, uint32_t width, uint32_t height, uint32_t rowStride, char* pDst)
+{
+    tjhandle handle = tjInitDecompress();
+    if (IsNull(handle)) {
+        return false;
+    }
+    const int res = tjDecompress2(
+        handle,
+        pData,
+        static_cast<unsigned long>(dataSize),
+        reinterpret_cast<unsigned char*>(pDst),
+        static_cast<int>(width),
+        static_cast<int>(rowStride),
+        static_cast<int>(height),
+        TJPF_RGBA,
+        0);
+    tjDestroy(handle);
+    return (res == 0);
+}
+#endif // defined(PPX_ENABLE_TURBOJPEG)
+
+#if defined(PPX_ENABLE_SPNG)
+static bool SpngAccepts(size_t dataSize, const uint8_t* pData)
+{
+    static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    return (dataSize >= sizeof(kSignature)) && (memcmp(pData, kSignature, sizeof(kSignature)) == 0);
+}
+
+static bool SpngGetSize(size_t dataSize, const uint8_t* pData, uint32_t* pWidth, uint32_t* pHeight)
+{
+    spng_ctx* pCtx = spng_ctx_new(0);
+    if (IsNull(pCtx)) {
+        return false;
+    }
+    struct spng_ihdr ihdr = {};
+    bool             ok   = (spng_set_png_buffer(pCtx, pData, dataSize) == 0) && (spng_get_ihdr(pCtx, &ihdr) == 0);
+    spng_ctx_free(pCtx);
+
+    // Interlaced rows come in several passes, leave those to stb
+    ok       = ok && (ihdr.interlace_method == SPNG_INTERLACE_NONE);
+    *pWidth  = ihdr.width;
+    *pHeight = ihdr.height;
+    return ok;
+}
+
+static bool SpngDecode(size_t dataSize, const uint8_t* pData, uint32_t width, uint32_t height, uint32_t rowStride, char* pDst)
+{
+    spng_ctx* pCtx = spng_ctx_new(0);
+    if (IsNull(pCtx)) {
+        return false;
+    }
+
+    // Row by row to write rows of rowStride bytes
+    int res = spng_set_png_buffer(pCtx, pData, dataSize);
+    if (res == 0) {
+        res = spng_decode_image(pCtx, nullptr, 0, SPNG_FMT_RGBA8, SPNG_DECODE_TRNS | SPNG_DECODE_PROGRESSIVE);
+    }
+    while (res == 0) {
+        struct spng_row_info rowInfo = {};
+        res                          = spng_get_row_info(pCtx, &rowInfo);
+        if ((res != 0) || (rowInfo.row_num >= height)) {
+            break;
+        }
+        res = spng_decode_row(pCtx, pDst + static_cast<size_t>(rowInfo.row_num) * rowStride, 4 * static_cast<size_t>(width));
+    }
+    spng_ctx_free(pCtx);
+    return (res == SPNG_EOI);
+}
+#endif // defined(PPX_ENABLE_SPNG)
+
+static const BitmapDecoder kDecoders[] = {
+#if defined(PPX_ENABLE_TURBOJPEG)
+    {Bitmap::DECODER_TURBOJPEG, TurboJpegAccepts, TurboJpegGetSize, TurboJpegDecode},
+#endif
+#if defined(PPX_ENABLE_SPNG)
+    {Bitmap::DECODER_SPNG, SpngAccepts, SpngGetSize, SpngDecode},
+#endif
+    // Keeps the array non-empty, stb isn't called through the table
+    {Bitmap::DECODER_STB, nullptr, nullptr, nullptr},
+};
+
+// Returns nullptr for stb
+static const BitmapDecoder* FindDecoder(Bitmap::Decoder decoder, size_t dataSize, const uint8_t* pData)
+{
+    for (const BitmapDecoder& entry : kDecoders) {
+        if ((entry.decoder == Bitmap::DECODER_STB) || ((decoder != Bitmap::DECODER_DEFAULT) && (entry.decoder != decoder))) {
+            continue;
+        }
+        if (entry.pfnAccepts(dataSize, pData)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool Bitmap::IsDecoderAvailable(Bitmap::Decoder decoder)
+{
+    return std::any_of(std::begin(kDecoders), std::end(kDecoders), [decoder](const BitmapDecoder& entry) { return entry.decoder == decoder; }) || (decoder == Bitmap::DECODER_DEFAULT);
+}
+
+const char* Bitmap::ToString(Bitmap::Decoder decoder)
+{
+    // clang-format off
+    switch (decoder) {
+        default                        : break;
+        case Bitmap::DECODER_DEFAULT   : return "default";
+        case Bitmap::DECODER_STB       : return "stb";
+        case Bitmap::DECODER_TURBOJPEG : return "turbojpeg";
+        case Bitmap::DECODER_SPNG      : return "spng";
     }
+    // clang-format on
+    return "<unknown decoder>";
+}
 
-    const stbi_uc* readPtr = file.IsMapped() ? reinterpret_cast<const stbi_uc*>(file.GetMappedData()) : buffer.data();
+char* Bitmap::StbiLoad(const void* pData, size_t dataSize, Bitmap::Format format, int* pWidth, int* pHeight, int* pChannels, int desiredChannels)
+{
     if (format == Bitmap::FORMAT_RGBA_FLOAT) {
         return reinterpret_cast<char*>(stbi_loadf_from_memory(
-            readPtr,
-            static_cast<int>(file.GetLength()),
+            static_cast<const stbi_uc*>(pData),
+            static_cast<int>(dataSize),
             pWidth,
             pHeight,
             pChannels,
             desiredChannels));
     }
     return reinterpret_cast<char*>(stbi_load_from_memory(
-        readPtr,
-        static_cast<int>(file.GetLength()),
+        static_cast<const stbi_uc*>(pData),
+        static_cast<int>(dataSize),
         pWidth,
         pHeight,
         pChannels,
@@ -640,36 +1499,39 @@ char* Bitmap::StbiLoad(const std::filesystem::path& path, Bitmap::Format format,
 }
 
 Result Bitmap::LoadFile(const std::filesystem::path& path, Bitmap* pBitmap)
+{
+    return LoadFile(path, 0, nullptr, pBitmap);
+}
+
+Result Bitmap::LoadFile(const std::filesystem::path& path, uint32_t rowStride, char* pExternalStorage, Bitmap* pBitmap, Bitmap::Decoder decoder)
 {
     if (!ppx::fs::path_exists(path)) {
         return ppx::ERROR_PATH_DOES_NOT_EXIST;
     }
 
-    bool   isRadiance = false;
-    Result ppxres     = IsRadianceFile(path, isRadiance);
-    if (Failed(ppxres)) {
-        return ppxres;
-    }
-
-    int            width            = 0;
-    int            height           = 0;
-    int            channels         = 0;
-    int            requiredChannels = 4; // Force to 4 channels to make things easier for the graphics APIs.
-    Bitmap::Format format           = (isRadiance) ? Bitmap::FORMAT_RGBA_FLOAT : Bitmap::FORMAT_RGBA_UINT8;
-    char*          dataPtr          = StbiLoad(path, format, &width, &height, &channels, requiredChannels);
-
-    if (IsNull(dataPtr)) {
+    // Decode straight from the mapping if the file is mapped, otherwise
+    // read it whole once
+    ppx::fs::File file;
+    if (!file.Open(path)) {
         PPX_LOG_ERROR("Failed to open file '" + path.string() + "'");
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
-    ppxres = Bitmap::Create(width, height, format, dataPtr, pBitmap);
-    if (!pBitmap->IsOk()) {
-        // Something has gone really wrong if this happens
-        stbi_image_free(dataPtr);
-        return ppx::ERROR_FAILED;
+
+    std::vector<char> buffer(0);
+    if (!file.IsMapped()) {
+        buffer.resize(file.GetLength());
+        if (file.Read(buffer.data(), buffer.size()) != buffer.size()) {
+            PPX_LOG_ERROR("Failed to read file '" + path.string() + "'");
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+    }
+    const void* pData = file.IsMapped() ? file.GetMappedData() : buffer.data();
+
+    Result ppxres = LoadFromMemory(file.GetLength(), pData, rowStride, pExternalStorage, pBitmap, decoder);
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("Failed to load image file '" + path.string() + "'");
+        return ppxres;
     }
-    // Critical! This marks the memory as needing to be freed later!
-    pBitmap->mDataIsFromStbi = true;
 
     return ppx::SUCCESS;
 }
@@ -680,8 +1542,22 @@ Result Bitmap::SaveFilePNG(const std::filesystem::path& path, const Bitmap* pBit
     PPX_ASSERT_MSG(false, "SaveFilePNG not supported on Android");
     return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
 #else
-    int res = stbi_write_png(path.string().c_str(), pBitmap->GetWidth(), pBitmap->GetHeight(), pBitmap->GetChannelCount(), pBitmap->GetData(), pBitmap->GetRowStride());
-    if (res == 0) {
+    if (Bitmap::ChannelDataType(pBitmap->GetFormat()) != Bitmap::DATA_TYPE_UINT8) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    std::vector<uint8_t> encoded;
+    Result               ppxres = EncodePNG(pBitmap->GetData(), pBitmap->GetWidth(), pBitmap->GetHeight(), pBitmap->GetRowStride(), pBitmap->GetChannelCount(), &encoded);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+    file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    if (!file) {
         return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
     }
     return ppx::SUCCESS;
@@ -689,10 +1565,18 @@ Result Bitmap::SaveFilePNG(const std::filesystem::path& path, const Bitmap* pBit
 }
 
 Result Bitmap::LoadFromMemory(const size_t dataSize, const void* pData, Bitmap* pBitmap)
+{
+    return LoadFromMemory(dataSize, pData, 0, nullptr, pBitmap);
+}
+
+Result Bitmap::LoadFromMemory(const size_t dataSize, const void* pData, uint32_t rowStride, char* pExternalStorage, Bitmap* pBitmap, Bitmap::Decoder decoder)
 {
     if ((dataSize == 0) || IsNull(pData) || IsNull(pBitmap)) {
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
     }
+    if (!IsDecoderAvailable(decoder)) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
 
     bool   isRadiance = false;
     Result ppxres     = IsRadianceImage(dataSize, pData, isRadiance);
@@ -700,44 +1584,70 @@ Result Bitmap::LoadFromMemory(const size_t dataSize, const void* pData, Bitmap*
         return ppxres;
     }
 
+    const uint8_t*       pBytes   = static_cast<const uint8_t*>(pData);
+    const BitmapDecoder* pDecoder = (isRadiance || (decoder == Bitmap::DECODER_STB)) ? nullptr : FindDecoder(decoder, dataSize, pBytes);
+    if (IsNull(pDecoder) && (decoder != Bitmap::DECODER_DEFAULT) && (decoder != Bitmap::DECODER_STB)) {
+        // The requested backend doesn't take this kind of file
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    uint32_t decoderWidth  = 0;
+    uint32_t decoderHeight = 0;
+    if (!IsNull(pDecoder) && pDecoder->pfnGetSize(dataSize, pBytes, &decoderWidth, &decoderHeight)) {
+        ppxres = Bitmap::Create(decoderWidth, decoderHeight, Bitmap::FORMAT_RGBA_UINT8, IsNull(pExternalStorage) ? 0 : rowStride, pExternalStorage, pBitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        if (!pDecoder->pfnDecode(dataSize, pBytes, decoderWidth, decoderHeight, pBitmap->GetRowStride(), pBitmap->GetData())) {
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+        return ppx::SUCCESS;
+    }
+    if (!IsNull(pDecoder) && (decoder != Bitmap::DECODER_DEFAULT)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
     int            width            = 0;
     int            height           = 0;
     int            channels         = 0;
     int            requiredChannels = 4; // Force to 4 channels to make things easier for the graphics APIs.
     Bitmap::Format format           = (isRadiance) ? Bitmap::FORMAT_RGBA_FLOAT : Bitmap::FORMAT_RGBA_UINT8;
-
-    void* pStbData = nullptr;
-    if (isRadiance) {
-        pStbData = stbi_loadf_from_memory(
-            static_cast<const stbi_uc*>(pData),
-            static_cast<int>(dataSize),
-            &width,
-            &height,
-            &channels,
-            requiredChannels);
-    }
-    else {
-        pStbData = stbi_load_from_memory(
-            static_cast<const stbi_uc*>(pData),
-            static_cast<int>(dataSize),
-            &width,
-            &height,
-            &channels,
-            requiredChannels);
-    }
-
+    char*          pStbData         = StbiLoad(pData, dataSize, format, &width, &height, &channels, requiredChannels);
     if (IsNull(pStbData)) {
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
 
-    ppxres = Bitmap::Create(width, height, format, static_cast<char*>(pStbData), pBitmap);
-    if (!pBitmap->IsOk()) {
-        // Something has gone really wrong if this happens
+    if (IsNull(pExternalStorage)) {
+        ppxres = Bitmap::Create(width, height, format, pStbData, pBitmap);
+        if (!pBitmap->IsOk()) {
+            // Something has gone really wrong if this happens
+            stbi_image_free(pStbData);
+            return ppx::ERROR_FAILED;
+        }
+        // Critical! This marks the memory as needing to be freed later!
+        pBitmap->mDataIsFromStbi = true;
+
+        return ppx::SUCCESS;
+    }
+
+    // stb always decodes into its own allocation, copy the rows over once
+    ppxres = Bitmap::Create(width, height, format, rowStride, pExternalStorage, pBitmap);
+    if (Failed(ppxres)) {
         stbi_image_free(pStbData);
-        return ppx::ERROR_FAILED;
+        return ppxres;
+    }
+
+    const uint32_t srcRowStride = static_cast<uint32_t>(width) * Bitmap::FormatSize(format);
+    const uint32_t dstRowStride = pBitmap->GetRowStride();
+    if (srcRowStride == dstRowStride) {
+        memcpy(pExternalStorage, pStbData, static_cast<size_t>(srcRowStride) * height);
+    }
+    else {
+        for (int y = 0; y < height; ++y) {
+            memcpy(pExternalStorage + static_cast<size_t>(y) * dstRowStride, pStbData + static_cast<size_t>(y) * srcRowStride, srcRowStride);
+        }
     }
-    // Critical! This marks the memory as needing to be freed later!
-    pBitmap->mDataIsFromStbi = true;
+    stbi_image_free(pStbData);
 
     return ppx::SUCCESS;
 }
@@ -53,6 +53,18 @@ void AABB::Transform(const float4x4& matrix, float3 obbVertices[8]) const
     obbVertices[7] = matrix * float4(mMax.x, mMax.y, mMax.z, 1.0f);
 }
 
+AABB AABB::GetTransformed(const float4x4& matrix) const
+{
+    float3 obbVertices[8];
+    Transform(matrix, obbVertices);
+
+    AABB aabb(obbVertices[0]);
+    for (size_t i = 1; i < 8; ++i) {
+        aabb.Expand(obbVertices[i]);
+    }
+    return aabb;
+}
+
 // -------------------------------------------------------------------------------------------------
 // OBB
 // -------------------------------------------------------------------------------------------------
@@ -86,4 +98,40 @@ void OBB::GetPoints(float3 obbVertices[8]) const
     obbVertices[7] = mCenter + w + v + w;
 }
 
+// -------------------------------------------------------------------------------------------------
+// Frustum
+// -------------------------------------------------------------------------------------------------
+void Frustum::Set(const float4x4& viewProjectionMatrix)
+{
+    const float4 row0 = glm::row(viewProjectionMatrix, 0);
+    const float4 row1 = glm::row(viewProjectionMatrix, 1);
+    const float4 row2 = glm::row(viewProjectionMatrix, 2);
+    const float4 row3 = glm::row(viewProjectionMatrix, 3);
+
+    mPlanes[PLANE_LEFT]   = row3 + row0;
+    mPlanes[PLANE_RIGHT]  = row3 - row0;
+    mPlanes[PLANE_BOTTOM] = row3 + row1;
+    mPlanes[PLANE_TOP]    = row3 - row1;
+    mPlanes[PLANE_NEAR]   = row2;
+    mPlanes[PLANE_FAR]    = row3 - row2;
+
+    for (uint32_t i = 0; i < PLANE_COUNT; ++i) {
+        mPlanes[i] /= glm::length(float3(mPlanes[i]));
+    }
+}
+
+bool Frustum::Overlaps(const AABB& aabb) const
+{
+    const float3 center = aabb.GetCenter();
+    const float3 extent = aabb.GetSize() / 2.0f;
+    for (uint32_t i = 0; i < PLANE_COUNT; ++i) {
+        const float3 normal = float3(mPlanes[i]);
+        const float  radius = glm::dot(extent, glm::abs(normal));
+        if ((glm::dot(center, normal) + mPlanes[i].w) < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace ppx
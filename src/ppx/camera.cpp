@@ -62,6 +62,31 @@ void Camera::MoveAlongViewDirection(float distance)
     LookAt(eyePosition, mTarget, mWorldUp);
 }
 
+void Camera::SetJitter(const float2& pixelOffset, uint32_t width, uint32_t height)
+{
+    if ((width == 0) || (height == 0)) {
+        ClearJitter();
+        return;
+    }
+
+    // Clip space y is up
+    mJitter = float2(
+        2.0f * pixelOffset.x / static_cast<float>(width),
+        -2.0f * pixelOffset.y / static_cast<float>(height));
+}
+
+float4x4 Camera::GetJitteredProjectionMatrix() const
+{
+    // Translating after the projection scales the offset by w, which
+    // shifts every depth by the same amount in clip space
+    return glm::translate(float3(mJitter, 0.0f)) * mProjectionMatrix;
+}
+
+float4x4 Camera::GetJitteredViewProjectionMatrix() const
+{
+    return GetJitteredProjectionMatrix() * mViewMatrix;
+}
+
 // -------------------------------------------------------------------------------------------------
 // PerspCamera
 // -------------------------------------------------------------------------------------------------
@@ -0,0 +1,990 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/command_capture.h"
+#include "ppx/fs.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_queue.h"
+#include "ppx/grfx/grfx_util.h"
+#include "ppx/log.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <optional>
+
+namespace ppx {
+
+// 'PPXC'
+static const uint32_t kCaptureMagic   = 0x43585050;
+static const uint32_t kCaptureVersion = 1;
+
+// -------------------------------------------------------------------------------------------------
+// Capture data
+// -------------------------------------------------------------------------------------------------
+namespace {
+
+class CaptureWriter
+{
+public:
+    void U32(uint32_t value) { Bytes(&value, sizeof(value)); }
+    void U64(uint64_t value) { Bytes(&value, sizeof(value)); }
+
+    void Bytes(const void* pData, size_t size)
+    {
+        const char* pBytes = static_cast<const char*>(pData);
+        mBytes.insert(mBytes.end(), pBytes, pBytes + size);
+    }
+
+    void Blob(const std::vector<char>& data)
+    {
+        U64(data.size());
+        Bytes(data.data(), data.size());
+    }
+
+    void String(const std::string& value)
+    {
+        U32(static_cast<uint32_t>(value.size()));
+        Bytes(value.data(), value.size());
+    }
+
+    const std::vector<char>& GetBytes() const { return mBytes; }
+
+private:
+    std::vector<char> mBytes;
+};
+
+// Reads stop at the end of the data, Failed() tells if one did
+class CaptureReader
+{
+public:
+    CaptureReader(const std::vector<char>& bytes)
+        : mBytes(bytes) {}
+
+    bool   Failed() const { return mFailed; }
+    size_t GetRemaining() const { return mBytes.size() - mOffset; }
+
+    uint32_t U32()
+    {
+        uint32_t value = 0;
+        Bytes(&value, sizeof(value));
+        return value;
+    }
+
+    uint64_t U64()
+    {
+        uint64_t value = 0;
+        Bytes(&value, sizeof(value));
+        return value;
+    }
+
+    // Counts of elements of at least elementSize bytes, checked against the
+    // remaining data so corrupt files don't allocate huge vectors
+    size_t Count(size_t elementSize)
+    {
+        const uint64_t count = U64();
+        if (count > (GetRemaining() / elementSize)) {
+            mFailed = true;
+            return 0;
+        }
+        return static_cast<size_t>(count);
+    }
+
+    void Bytes(void* pData, size_t size)
+    {
+        if (mFailed || (size > GetRemaining())) {
+            mFailed = true;
+            return;
+        }
+        std::memcpy(pData, mBytes.data() + mOffset, size);
+        mOffset += size;
+    }
+
+    std::vector<char> Blob()
+    {
+        std::vector<char> data(Count(1));
+        Bytes(data.data(), data.size());
+        return data;
+    }
+
+    std::string String()
+    {
+        const uint32_t size = U32();
+        if (size > GetRemaining()) {
+            mFailed = true;
+            return std::string();
+        }
+        std::string value(size, '\0');
+        Bytes(value.data(), size);
+        return value;
+    }
+
+private:
+    const std::vector<char>& mBytes;
+    size_t                   mOffset = 0;
+    bool                     mFailed = false;
+};
+
+} // namespace
+
+Result SaveCaptureData(const std::filesystem::path& path, const CaptureData& data)
+{
+    CaptureWriter writer;
+    writer.U32(kCaptureMagic);
+    writer.U32(kCaptureVersion);
+    writer.U32(data.api);
+
+    writer.U64(data.shaders.size());
+    for (const auto& shader : data.shaders) {
+        writer.Blob(shader);
+    }
+
+    writer.U64(data.interfaces.size());
+    for (const auto& interfaceData : data.interfaces) {
+        writer.U64(interfaceData.sets.size());
+        for (const auto& set : interfaceData.sets) {
+            writer.U32(set.set);
+            writer.U64(set.bindings.size());
+            for (const auto& binding : set.bindings) {
+                writer.U32(binding.binding);
+                writer.U32(binding.type);
+                writer.U32(binding.arrayCount);
+            }
+        }
+        writer.U32(interfaceData.pushConstantCount);
+        writer.U32(interfaceData.pushConstantBinding);
+        writer.U32(interfaceData.pushConstantSet);
+    }
+
+    writer.U64(data.pipelines.size());
+    for (const auto& pipeline : data.pipelines) {
+        writer.U32(pipeline.shaderIndex);
+        writer.U32(pipeline.interfaceIndex);
+        writer.String(pipeline.entryPoint);
+    }
+
+    writer.U64(data.buffers.size());
+    for (const auto& buffer : data.buffers) {
+        writer.U64(buffer.size);
+        writer.U32(buffer.structuredElementStride);
+        writer.U32(buffer.usageFlags);
+        writer.U32(buffer.state);
+        writer.Blob(buffer.contents);
+    }
+
+    writer.U64(data.frames.size());
+    for (const auto& frame : data.frames) {
+        writer.U64(frame.size());
+        writer.Bytes(frame.data(), frame.size() * sizeof(uint32_t));
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        PPX_LOG_ERROR("Couldn't open capture file for writing: " << path);
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+    const auto& bytes = writer.GetBytes();
+    file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!file.good()) {
+        PPX_LOG_ERROR("Couldn't write capture file: " << path);
+        return ppx::ERROR_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result LoadCaptureData(const std::filesystem::path& path, CaptureData* pData)
+{
+    if (IsNull(pData)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    std::optional<std::vector<char>> bytes = fs::load_file(path);
+    if (!bytes.has_value()) {
+        PPX_LOG_ERROR("Couldn't load capture file: " << path);
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+
+    CaptureReader reader(bytes.value());
+    if ((reader.U32() != kCaptureMagic) || (reader.U32() != kCaptureVersion)) {
+        PPX_LOG_ERROR("Not a capture file, or one of another version: " << path);
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    CaptureData data = {};
+    data.api         = reader.U32();
+
+    data.shaders.resize(reader.Count(sizeof(uint64_t)));
+    for (auto& shader : data.shaders) {
+        shader = reader.Blob();
+    }
+
+    data.interfaces.resize(reader.Count(sizeof(uint64_t) + 3 * sizeof(uint32_t)));
+    for (auto& interfaceData : data.interfaces) {
+        interfaceData.sets.resize(reader.Count(sizeof(uint32_t) + sizeof(uint64_t)));
+        for (auto& set : interfaceData.sets) {
+            set.set = reader.U32();
+            set.bindings.resize(reader.Count(3 * sizeof(uint32_t)));
+            for (auto& binding : set.bindings) {
+                binding.binding    = reader.U32();
+                binding.type       = reader.U32();
+                binding.arrayCount = reader.U32();
+            }
+        }
+        interfaceData.pushConstantCount   = reader.U32();
+        interfaceData.pushConstantBinding = reader.U32();
+        interfaceData.pushConstantSet     = reader.U32();
+    }
+
+    data.pipelines.resize(reader.Count(3 * sizeof(uint32_t)));
+    for (auto& pipeline : data.pipelines) {
+        pipeline.shaderIndex    = reader.U32();
+        pipeline.interfaceIndex = reader.U32();
+        pipeline.entryPoint     = reader.String();
+    }
+
+    data.buffers.resize(reader.Count(sizeof(uint64_t) + 3 * sizeof(uint32_t) + sizeof(uint64_t)));
+    for (auto& buffer : data.buffers) {
+        buffer.size                    = reader.U64();
+        buffer.structuredElementStride = reader.U32();
+        buffer.usageFlags              = reader.U32();
+        buffer.state                   = reader.U32();
+        buffer.contents                = reader.Blob();
+    }
+
+    data.frames.resize(reader.Count(sizeof(uint64_t)));
+    for (auto& frame : data.frames) {
+        frame.resize(reader.Count(sizeof(uint32_t)));
+        reader.Bytes(frame.data(), frame.size() * sizeof(uint32_t));
+    }
+
+    if (reader.Failed()) {
+        PPX_LOG_ERROR("Truncated or corrupt capture file: " << path);
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    *pData = std::move(data);
+
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+// CommandCapture
+// -------------------------------------------------------------------------------------------------
+CommandCapture::CommandCapture()
+{
+}
+
+CommandCapture::~CommandCapture()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    for (auto& snapshot : mSnapshots) {
+        mDevice->DestroyBuffer(snapshot);
+    }
+    mSnapshots.clear();
+}
+
+Result CommandCapture::Create(grfx::Device* pDevice, const CommandCaptureCreateInfo& createInfo, CommandCapture** ppCapture)
+{
+    if (IsNull(pDevice) || IsNull(ppCapture)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.frameCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    CommandCapture* pCapture = new CommandCapture();
+    if (IsNull(pCapture)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    pCapture->mDevice     = pDevice;
+    pCapture->mCreateInfo = createInfo;
+    pCapture->mData.api   = static_cast<uint32_t>(pDevice->GetApi());
+
+    *ppCapture = pCapture;
+
+    return ppx::SUCCESS;
+}
+
+Result CommandCapture::AddInterface(const grfx::PipelineInterface* pInterface, uint32_t* pIndex)
+{
+    auto it = mInterfaceIndices.find(pInterface);
+    if (it != mInterfaceIndices.end()) {
+        *pIndex = it->second;
+        return ppx::SUCCESS;
+    }
+
+    const grfx::PipelineInterfaceCreateInfo& createInfo = pInterface->GetCreateInfo();
+
+    CaptureInterface interfaceData    = {};
+    interfaceData.pushConstantCount   = createInfo.pushConstants.count;
+    interfaceData.pushConstantBinding = createInfo.pushConstants.binding;
+    interfaceData.pushConstantSet     = createInfo.pushConstants.set;
+
+    for (uint32_t i = 0; i < createInfo.setCount; ++i) {
+        const grfx::DescriptorSetLayout* pLayout = createInfo.sets[i].pLayout;
+        // Contents of descriptor sets aren't captured
+        if (!pLayout->IsPushable()) {
+            PPX_LOG_ERROR("Only pipelines with pushable set layouts can be captured");
+            return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+        }
+
+        CaptureSetLayout set = {};
+        set.set              = createInfo.sets[i].set;
+        for (const auto& binding : pLayout->GetBindings()) {
+            set.bindings.push_back({binding.binding, static_cast<uint32_t>(binding.type), binding.arrayCount});
+        }
+        interfaceData.sets.push_back(std::move(set));
+    }
+
+    *pIndex = CountU32(mData.interfaces);
+    mData.interfaces.push_back(std::move(interfaceData));
+    mInterfaceIndices[pInterface] = *pIndex;
+
+    return ppx::SUCCESS;
+}
+
+Result CommandCapture::AddComputePipeline(const grfx::ComputePipeline* pPipeline, const std::vector<char>& bytecode)
+{
+    if (IsNull(pPipeline)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (mCapturing) {
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+    if (mPipelineIndices.find(pPipeline) != mPipelineIndices.end()) {
+        return ppx::ERROR_DUPLICATE_ELEMENT;
+    }
+
+    const grfx::ComputePipelineCreateInfo& createInfo = pPipeline->GetCreateInfo();
+    if (!createInfo.CS.specializationConstants.empty()) {
+        PPX_LOG_ERROR("Pipelines with specialization constants can't be captured");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    CapturePipeline pipeline = {};
+    pipeline.entryPoint      = createInfo.CS.entryPoint;
+
+    Result ppxres = AddInterface(createInfo.pPipelineInterface, &pipeline.interfaceIndex);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Pipelines created from the same module share its bytecode
+    auto it = mShaderIndices.find(createInfo.CS.pModule);
+    if (it != mShaderIndices.end()) {
+        pipeline.shaderIndex = it->second;
+    }
+    else {
+        if (bytecode.empty()) {
+            return ppx::ERROR_GRFX_INVALID_SHADER_BYTE_CODE;
+        }
+        pipeline.shaderIndex = CountU32(mData.shaders);
+        mData.shaders.push_back(bytecode);
+        mShaderIndices[createInfo.CS.pModule] = pipeline.shaderIndex;
+    }
+
+    mPipelineIndices[pPipeline] = CountU32(mData.pipelines);
+    mData.pipelines.push_back(std::move(pipeline));
+
+    return ppx::SUCCESS;
+}
+
+Result CommandCapture::AddBuffer(const grfx::Buffer* pBuffer, grfx::ResourceState state)
+{
+    if (IsNull(pBuffer)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (mCapturing) {
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+    if (mBufferIndices.find(pBuffer) != mBufferIndices.end()) {
+        return ppx::ERROR_DUPLICATE_ELEMENT;
+    }
+    // Contents are copied out at the start of the capture
+    if (!pBuffer->GetUsageFlags().bits.transferSrc) {
+        PPX_LOG_ERROR("Captured buffers need transferSrc usage");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    CaptureBuffer buffer           = {};
+    buffer.size                    = pBuffer->GetSize();
+    buffer.structuredElementStride = pBuffer->GetStructuredElementStride();
+    buffer.usageFlags              = pBuffer->GetUsageFlags().flags;
+    buffer.state                   = static_cast<uint32_t>(state);
+
+    mBufferIndices[pBuffer] = CountU32(mData.buffers);
+    mData.buffers.push_back(std::move(buffer));
+    mBuffers.push_back(pBuffer);
+
+    return ppx::SUCCESS;
+}
+
+Result CommandCapture::Start()
+{
+    if (mCapturing) {
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    for (auto& snapshot : mSnapshots) {
+        mDevice->DestroyBuffer(snapshot);
+    }
+    mSnapshots.clear();
+    mData.frames.clear();
+
+    for (const auto* pBuffer : mBuffers) {
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = pBuffer->GetSize();
+        bufferCreateInfo.usageFlags.bits.transferDst = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+
+        grfx::BufferPtr snapshot;
+        Result          ppxres = mDevice->CreateBuffer(&bufferCreateInfo, &snapshot);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mSnapshots.push_back(snapshot);
+    }
+
+    mCapturing = true;
+
+    return ppx::SUCCESS;
+}
+
+void CommandCapture::BeginFrame(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_MSG(!mInFrame, "EndFrame() wasn't called");
+
+    if (!mCapturing) {
+        return;
+    }
+
+    // Snapshot of the contents the first frame starts from
+    if (mData.frames.empty()) {
+        for (size_t i = 0; i < mBuffers.size(); ++i) {
+            const grfx::Buffer*       pBuffer = mBuffers[i];
+            const grfx::ResourceState state   = static_cast<grfx::ResourceState>(mData.buffers[i].state);
+
+            grfx::BufferToBufferCopyInfo copyInfo = {};
+            copyInfo.size                         = pBuffer->GetSize();
+
+            if (state != grfx::RESOURCE_STATE_COPY_SRC) {
+                pCmd->BufferResourceBarrier(pBuffer, state, grfx::RESOURCE_STATE_COPY_SRC);
+            }
+            pCmd->CopyBufferToBuffer(&copyInfo, pBuffer, mSnapshots[i]);
+            if (state != grfx::RESOURCE_STATE_COPY_SRC) {
+                pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_COPY_SRC, state);
+            }
+        }
+    }
+
+    mData.frames.emplace_back();
+    mInFrame = true;
+}
+
+void CommandCapture::EndFrame()
+{
+    if (!mInFrame) {
+        return;
+    }
+
+    mInFrame = false;
+    if (CountU32(mData.frames) == mCreateInfo.frameCount) {
+        mCapturing = false;
+    }
+}
+
+Result CommandCapture::Save(const std::filesystem::path& path)
+{
+    if (!IsComplete()) {
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    for (size_t i = 0; i < mSnapshots.size(); ++i) {
+        std::vector<char>& contents = mData.buffers[i].contents;
+        contents.resize(static_cast<size_t>(mData.buffers[i].size));
+
+        void*  pMapped = nullptr;
+        Result ppxres  = mSnapshots[i]->MapMemory(0, &pMapped);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        std::memcpy(contents.data(), pMapped, contents.size());
+        mSnapshots[i]->UnmapMemory();
+    }
+
+    Result ppxres = SaveCaptureData(path, mData);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    PPX_LOG_INFO("Saved a capture of " << mData.frames.size() << " frames to " << path);
+
+    return ppx::SUCCESS;
+}
+
+uint32_t CommandCapture::GetIndex(const std::unordered_map<const void*, uint32_t>& indices, const void* pObject) const
+{
+    auto it = indices.find(pObject);
+    PPX_ASSERT_MSG(it != indices.end(), "object wasn't added to the capture");
+    return it->second;
+}
+
+void CommandCapture::Write(CaptureCommandOp op, std::initializer_list<uint32_t> words, uint32_t extraCount, const uint32_t* pExtra)
+{
+    std::vector<uint32_t>& frame = mData.frames.back();
+    frame.push_back(static_cast<uint32_t>(op));
+    frame.push_back(static_cast<uint32_t>(words.size()) + extraCount);
+    frame.insert(frame.end(), words.begin(), words.end());
+    if (extraCount > 0) {
+        frame.insert(frame.end(), pExtra, pExtra + extraCount);
+    }
+}
+
+void CommandCapture::BindComputePipeline(grfx::CommandBuffer* pCmd, const grfx::ComputePipeline* pPipeline)
+{
+    pCmd->BindComputePipeline(pPipeline);
+    if (mInFrame) {
+        Write(CAPTURE_COMMAND_OP_BIND_COMPUTE_PIPELINE, {GetIndex(mPipelineIndices, pPipeline)});
+    }
+}
+
+void CommandCapture::PushComputeConstants(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t count, const void* pValues, uint32_t dstOffset)
+{
+    pCmd->PushComputeConstants(pInterface, count, pValues, dstOffset);
+    if (mInFrame) {
+        Write(CAPTURE_COMMAND_OP_PUSH_COMPUTE_CONSTANTS, {GetIndex(mInterfaceIndices, pInterface), dstOffset, count}, count, static_cast<const uint32_t*>(pValues));
+    }
+}
+
+void CommandCapture::PushBuffer(grfx::DescriptorType type, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer)
+{
+    if (mInFrame) {
+        Write(CAPTURE_COMMAND_OP_PUSH_COMPUTE_BUFFER, {GetIndex(mInterfaceIndices, pInterface), static_cast<uint32_t>(type), binding, set, bufferOffset, GetIndex(mBufferIndices, pBuffer)});
+    }
+}
+
+void CommandCapture::PushComputeUniformBuffer(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer)
+{
+    pCmd->PushComputeUniformBuffer(pInterface, binding, set, bufferOffset, pBuffer);
+    PushBuffer(grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER, pInterface, binding, set, bufferOffset, pBuffer);
+}
+
+void CommandCapture::PushComputeStructuredBuffer(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer)
+{
+    pCmd->PushComputeStructuredBuffer(pInterface, binding, set, bufferOffset, pBuffer);
+    PushBuffer(grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER, pInterface, binding, set, bufferOffset, pBuffer);
+}
+
+void CommandCapture::PushComputeStorageBuffer(grfx::CommandBuffer* pCmd, const grfx::PipelineInterface* pInterface, uint32_t binding, uint32_t set, uint32_t bufferOffset, const grfx::Buffer* pBuffer)
+{
+    pCmd->PushComputeStorageBuffer(pInterface, binding, set, bufferOffset, pBuffer);
+    PushBuffer(grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER, pInterface, binding, set, bufferOffset, pBuffer);
+}
+
+void CommandCapture::BufferResourceBarrier(grfx::CommandBuffer* pCmd, const grfx::Buffer* pBuffer, grfx::ResourceState beforeState, grfx::ResourceState afterState)
+{
+    pCmd->BufferResourceBarrier(pBuffer, beforeState, afterState);
+    if (mInFrame) {
+        Write(CAPTURE_COMMAND_OP_BUFFER_BARRIER, {GetIndex(mBufferIndices, pBuffer), static_cast<uint32_t>(beforeState), static_cast<uint32_t>(afterState)});
+    }
+}
+
+void CommandCapture::CopyBufferToBuffer(grfx::CommandBuffer* pCmd, const grfx::BufferToBufferCopyInfo* pCopyInfo, const grfx::Buffer* pSrcBuffer, const grfx::Buffer* pDstBuffer)
+{
+    pCmd->CopyBufferToBuffer(pCopyInfo, pSrcBuffer, pDstBuffer);
+    if (mInFrame) {
+        const uint64_t srcOffset = pCopyInfo->srcBuffer.offset;
+        const uint64_t size      = pCopyInfo->size;
+        Write(
+            CAPTURE_COMMAND_OP_COPY_BUFFER,
+            {GetIndex(mBufferIndices, pSrcBuffer),
+             GetIndex(mBufferIndices, pDstBuffer),
+             static_cast<uint32_t>(srcOffset),
+             static_cast<uint32_t>(srcOffset >> 32),
+             pCopyInfo->dstBuffer.offset,
+             static_cast<uint32_t>(size),
+             static_cast<uint32_t>(size >> 32)});
+    }
+}
+
+void CommandCapture::Dispatch(grfx::CommandBuffer* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    pCmd->Dispatch(groupCountX, groupCountY, groupCountZ);
+    if (mInFrame) {
+        Write(CAPTURE_COMMAND_OP_DISPATCH, {groupCountX, groupCountY, groupCountZ});
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// CaptureReplayer
+// -------------------------------------------------------------------------------------------------
+
+// Checks the records of a frame against the objects of the capture, so
+// RecordFrames() can trust the stream
+static bool ValidateFrame(const CaptureData& data, const std::vector<uint32_t>& frame)
+{
+    const uint32_t pipelineCount  = CountU32(data.pipelines);
+    const uint32_t interfaceCount = CountU32(data.interfaces);
+    const uint32_t bufferCount    = CountU32(data.buffers);
+
+    size_t offset = 0;
+    while (offset < frame.size()) {
+        if ((frame.size() - offset) < 2) {
+            return false;
+        }
+        const uint32_t  op        = frame[offset];
+        const uint32_t  wordCount = frame[offset + 1];
+        const uint32_t* pWords    = frame.data() + offset + 2;
+        if (wordCount > (frame.size() - offset - 2)) {
+            return false;
+        }
+
+        bool valid = false;
+        switch (op) {
+            case CAPTURE_COMMAND_OP_BIND_COMPUTE_PIPELINE: {
+                valid = (wordCount == 1) && (pWords[0] < pipelineCount);
+            } break;
+            case CAPTURE_COMMAND_OP_PUSH_COMPUTE_CONSTANTS: {
+                valid = (wordCount >= 3) && (pWords[0] < interfaceCount) && (pWords[2] <= PPX_MAX_PUSH_CONSTANTS) && (wordCount == (3 + pWords[2]));
+            } break;
+            case CAPTURE_COMMAND_OP_PUSH_COMPUTE_BUFFER: {
+                if (wordCount != 6) {
+                    break;
+                }
+                const uint32_t type     = pWords[1];
+                const bool     isBuffer = (type == grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER) || (type == grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER) || (type == grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER);
+                valid                   = isBuffer && (pWords[0] < interfaceCount) && (pWords[5] < bufferCount);
+            } break;
+            case CAPTURE_COMMAND_OP_BUFFER_BARRIER: {
+                valid = (wordCount == 3) && (pWords[0] < bufferCount);
+            } break;
+            case CAPTURE_COMMAND_OP_COPY_BUFFER: {
+                valid = (wordCount == 7) && (pWords[0] < bufferCount) && (pWords[1] < bufferCount);
+            } break;
+            case CAPTURE_COMMAND_OP_DISPATCH: {
+                valid = (wordCount == 3);
+            } break;
+            default: break;
+        }
+        if (!valid) {
+            return false;
+        }
+
+        offset += 2 + wordCount;
+    }
+
+    return true;
+}
+
+CaptureReplayer::CaptureReplayer()
+{
+}
+
+CaptureReplayer::~CaptureReplayer()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    for (auto& buffer : mContents) {
+        mDevice->DestroyBuffer(buffer);
+    }
+    for (auto& buffer : mBuffers) {
+        mDevice->DestroyBuffer(buffer);
+    }
+    for (auto& pipeline : mPipelines) {
+        mDevice->DestroyComputePipeline(pipeline);
+    }
+    for (auto& pipelineInterface : mInterfaces) {
+        mDevice->DestroyPipelineInterface(pipelineInterface);
+    }
+    for (auto& layout : mSetLayouts) {
+        mDevice->DestroyDescriptorSetLayout(layout);
+    }
+}
+
+Result CaptureReplayer::Create(grfx::Queue* pQueue, const CaptureData& data, CaptureReplayer** ppReplayer)
+{
+    if (IsNull(pQueue) || IsNull(ppReplayer)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    CaptureReplayer* pReplayer = new CaptureReplayer();
+    if (IsNull(pReplayer)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pReplayer->Initialize(pQueue, data);
+    if (Failed(ppxres)) {
+        delete pReplayer;
+        return ppxres;
+    }
+
+    *ppReplayer = pReplayer;
+
+    return ppx::SUCCESS;
+}
+
+Result CaptureReplayer::Initialize(grfx::Queue* pQueue, const CaptureData& data)
+{
+    mDevice = pQueue->GetDevice();
+
+    // Shaders are API specific bytecode
+    const grfx::Api captureApi = static_cast<grfx::Api>(data.api);
+    if (grfx::IsVk(captureApi) != grfx::IsVk(mDevice->GetApi())) {
+        PPX_LOG_ERROR("The capture was made with " << ToString(captureApi) << ", it can't be replayed with " << ToString(mDevice->GetApi()));
+        return ppx::ERROR_UNSUPPORTED_API;
+    }
+
+    for (const auto& frame : data.frames) {
+        if (!ValidateFrame(data, frame)) {
+            PPX_LOG_ERROR("Capture has invalid commands");
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+    }
+
+    // Pipeline interfaces
+    for (const auto& interfaceData : data.interfaces) {
+        if (interfaceData.sets.size() > PPX_MAX_BOUND_DESCRIPTOR_SETS) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = CountU32(interfaceData.sets);
+        piCreateInfo.pushConstants.count               = interfaceData.pushConstantCount;
+        piCreateInfo.pushConstants.binding             = interfaceData.pushConstantBinding;
+        piCreateInfo.pushConstants.set                 = interfaceData.pushConstantSet;
+
+        for (uint32_t i = 0; i < piCreateInfo.setCount; ++i) {
+            const CaptureSetLayout& set = interfaceData.sets[i];
+
+            grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+            layoutCreateInfo.flags.bits.pushable                 = true;
+            for (const auto& binding : set.bindings) {
+                layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(binding.binding, static_cast<grfx::DescriptorType>(binding.type), binding.arrayCount));
+            }
+
+            grfx::DescriptorSetLayoutPtr layout;
+            Result                       ppxres = mDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &layout);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            mSetLayouts.push_back(layout);
+
+            piCreateInfo.sets[i].set     = set.set;
+            piCreateInfo.sets[i].pLayout = layout;
+        }
+
+        grfx::PipelineInterfacePtr pipelineInterface;
+        Result                     ppxres = mDevice->CreatePipelineInterface(&piCreateInfo, &pipelineInterface);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mInterfaces.push_back(pipelineInterface);
+    }
+
+    // Pipelines, the modules are only needed to create them
+    {
+        std::vector<grfx::ShaderModulePtr> modules;
+        Result                             ppxres = ppx::SUCCESS;
+        for (const auto& shader : data.shaders) {
+            grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(shader.size()), shader.data()};
+
+            grfx::ShaderModulePtr module;
+            ppxres = mDevice->CreateShaderModule(&shaderCreateInfo, &module);
+            if (Failed(ppxres)) {
+                break;
+            }
+            modules.push_back(module);
+        }
+
+        for (size_t i = 0; Success(ppxres) && (i < data.pipelines.size()); ++i) {
+            const CapturePipeline& pipeline = data.pipelines[i];
+            if ((pipeline.shaderIndex >= modules.size()) || (pipeline.interfaceIndex >= mInterfaces.size())) {
+                ppxres = ppx::ERROR_BAD_DATA_SOURCE;
+                break;
+            }
+
+            grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+            cpCreateInfo.CS                              = {modules[pipeline.shaderIndex], pipeline.entryPoint};
+            cpCreateInfo.pPipelineInterface              = mInterfaces[pipeline.interfaceIndex];
+
+            grfx::ComputePipelinePtr computePipeline;
+            ppxres = mDevice->CreateComputePipeline(&cpCreateInfo, &computePipeline);
+            if (Success(ppxres)) {
+                mPipelines.push_back(computePipeline);
+            }
+        }
+
+        for (auto& module : modules) {
+            mDevice->DestroyShaderModule(module);
+        }
+
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Buffers, each with a copy of its contents for RecordResetContents()
+    for (const auto& buffer : data.buffers) {
+        if ((buffer.contents.size() != buffer.size) || (buffer.size > std::numeric_limits<uint32_t>::max())) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = buffer.size;
+        bufferCreateInfo.structuredElementStride     = buffer.structuredElementStride;
+        bufferCreateInfo.usageFlags.flags            = buffer.usageFlags;
+        bufferCreateInfo.usageFlags.bits.transferDst = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                = static_cast<grfx::ResourceState>(buffer.state);
+
+        grfx::BufferPtr gpuBuffer;
+        Result          ppxres = mDevice->CreateBuffer(&bufferCreateInfo, &gpuBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mBuffers.push_back(gpuBuffer);
+        mBufferStates.push_back(bufferCreateInfo.initialState);
+
+        grfx::BufferCreateInfo contentsCreateInfo      = {};
+        contentsCreateInfo.size                        = buffer.size;
+        contentsCreateInfo.usageFlags.bits.transferSrc = true;
+        contentsCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        contentsCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+
+        grfx::BufferPtr contents;
+        ppxres = mDevice->CreateBuffer(&contentsCreateInfo, &contents);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mContents.push_back(contents);
+
+        ppxres = contents->CopyFromSource(static_cast<uint32_t>(buffer.contents.size()), buffer.contents.data());
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    mFrames = data.frames;
+
+    // Initial contents
+    {
+        grfx::CommandBufferPtr cmd;
+        Result                 ppxres = pQueue->CreateCommandBuffer(&cmd);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = cmd->Begin();
+        if (Success(ppxres)) {
+            RecordResetContents(cmd);
+            ppxres = cmd->End();
+        }
+        if (Success(ppxres)) {
+            grfx::SubmitInfo submitInfo   = {};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.ppCommandBuffers   = &cmd;
+
+            ppxres = pQueue->Submit(&submitInfo);
+        }
+        if (Success(ppxres)) {
+            ppxres = pQueue->WaitIdle();
+        }
+
+        pQueue->DestroyCommandBuffer(cmd);
+
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void CaptureReplayer::RecordResetContents(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    for (size_t i = 0; i < mBuffers.size(); ++i) {
+        const grfx::ResourceState state = mBufferStates[i];
+
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = mBuffers[i]->GetSize();
+
+        if (state != grfx::RESOURCE_STATE_COPY_DST) {
+            pCmd->BufferResourceBarrier(mBuffers[i], state, grfx::RESOURCE_STATE_COPY_DST);
+        }
+        pCmd->CopyBufferToBuffer(&copyInfo, mContents[i], mBuffers[i]);
+        if (state != grfx::RESOURCE_STATE_COPY_DST) {
+            pCmd->BufferResourceBarrier(mBuffers[i], grfx::RESOURCE_STATE_COPY_DST, state);
+        }
+    }
+}
+
+void CaptureReplayer::RecordFrames(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    for (const auto& frame : mFrames) {
+        size_t offset = 0;
+        while (offset < frame.size()) {
+            const uint32_t  op     = frame[offset];
+            const uint32_t* pWords = frame.data() + offset + 2;
+            offset += 2 + frame[offset + 1];
+
+            switch (op) {
+                case CAPTURE_COMMAND_OP_BIND_COMPUTE_PIPELINE: {
+                    pCmd->BindComputePipeline(mPipelines[pWords[0]]);
+                } break;
+                case CAPTURE_COMMAND_OP_PUSH_COMPUTE_CONSTANTS: {
+                    pCmd->PushComputeConstants(mInterfaces[pWords[0]], pWords[2], pWords + 3, pWords[1]);
+                } break;
+                case CAPTURE_COMMAND_OP_PUSH_COMPUTE_BUFFER: {
+                    const grfx::PipelineInterface* pInterface = mInterfaces[pWords[0]];
+                    const grfx::Buffer*            pBuffer    = mBuffers[pWords[5]];
+                    switch (pWords[1]) {
+                        case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER: pCmd->PushComputeUniformBuffer(pInterface, pWords[2], pWords[3], pWords[4], pBuffer); break;
+                        case grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER: pCmd->PushComputeStructuredBuffer(pInterface, pWords[2], pWords[3], pWords[4], pBuffer); break;
+                        default: pCmd->PushComputeStorageBuffer(pInterface, pWords[2], pWords[3], pWords[4], pBuffer); break;
+                    }
+                } break;
+                case CAPTURE_COMMAND_OP_BUFFER_BARRIER: {
+                    pCmd->BufferResourceBarrier(mBuffers[pWords[0]], static_cast<grfx::ResourceState>(pWords[1]), static_cast<grfx::ResourceState>(pWords[2]));
+                } break;
+                case CAPTURE_COMMAND_OP_COPY_BUFFER: {
+                    grfx::BufferToBufferCopyInfo copyInfo = {};
+                    copyInfo.srcBuffer.offset             = static_cast<uint64_t>(pWords[2]) | (static_cast<uint64_t>(pWords[3]) << 32);
+                    copyInfo.dstBuffer.offset             = pWords[4];
+                    copyInfo.size                         = static_cast<uint64_t>(pWords[5]) | (static_cast<uint64_t>(pWords[6]) << 32);
+                    pCmd->CopyBufferToBuffer(&copyInfo, mBuffers[pWords[0]], mBuffers[pWords[1]]);
+                } break;
+                case CAPTURE_COMMAND_OP_DISPATCH: {
+                    pCmd->Dispatch(pWords[0], pWords[1], pWords[2]);
+                } break;
+                default: break;
+            }
+        }
+    }
+}
+
+} // namespace ppx
@@ -0,0 +1,124 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/compute_context.h"
+#include "ppx/fs.h"
+#include "ppx/log.h"
+
+namespace ppx {
+
+ComputeContext::ComputeContext()
+{
+}
+
+ComputeContext::~ComputeContext()
+{
+    if (mDevice) {
+        mDevice->WaitIdle();
+        mInstance->DestroyDevice(mDevice);
+        mDevice.Reset();
+    }
+
+    if (mInstance) {
+        grfx::DestroyInstance(mInstance);
+        mInstance.Reset();
+    }
+}
+
+Result ComputeContext::Create(const ComputeContextCreateInfo& createInfo, ComputeContext** ppContext)
+{
+    if (IsNull(ppContext)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.computeQueueCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    ComputeContext* pContext = new ComputeContext();
+    if (IsNull(pContext)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pContext->Initialize(createInfo);
+    if (Failed(ppxres)) {
+        delete pContext;
+        return ppxres;
+    }
+
+    *ppContext = pContext;
+
+    return ppx::SUCCESS;
+}
+
+Result ComputeContext::Initialize(const ComputeContextCreateInfo& createInfo)
+{
+    // Instance, no surface or swapchain extensions
+    {
+        grfx::InstanceCreateInfo ci = {};
+        ci.api                      = createInfo.api;
+        ci.createDevices            = false;
+        ci.enableDebug              = createInfo.enableDebug;
+        ci.enableSwapchain          = false;
+        ci.useSoftwareRenderer      = createInfo.useSoftwareRenderer;
+        ci.applicationName          = createInfo.applicationName;
+        ci.engineName               = createInfo.applicationName;
+
+        Result ppxres = grfx::CreateInstance(&ci, &mInstance);
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("grfx::CreateInstance failed: " << ToString(ppxres));
+            return ppxres;
+        }
+    }
+
+    // Device, compute queues only
+    {
+        grfx::GpuPtr gpu;
+        Result       ppxres = mInstance->GetGpu(createInfo.gpuIndex, &gpu);
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("No GPU at index " << createInfo.gpuIndex);
+            return ppxres;
+        }
+
+        grfx::DeviceCreateInfo ci = {};
+        ci.pGpu                   = gpu;
+        ci.graphicsQueueCount     = 0;
+        ci.computeQueueCount      = createInfo.computeQueueCount;
+        ci.transferQueueCount     = 0;
+
+        PPX_LOG_INFO("Creating compute device using " << gpu->GetDeviceName());
+
+        ppxres = mInstance->CreateDevice(&ci, &mDevice);
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("grfx::Instance::CreateDevice failed: " << ToString(ppxres));
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ComputeContext::CreateShader(const std::filesystem::path& path, grfx::ShaderModule** ppShaderModule) const
+{
+    std::optional<std::vector<char>> bytecode = fs::load_file(path);
+    if (!bytecode.has_value() || bytecode->empty()) {
+        PPX_LOG_ERROR("Couldn't load shader bytecode from " << path);
+        return ppx::ERROR_GRFX_INVALID_SHADER_BYTE_CODE;
+    }
+
+    grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(bytecode->size()), bytecode->data()};
+    return mDevice->CreateShaderModule(&shaderCreateInfo, ppShaderModule);
+}
+
+} // namespace ppx
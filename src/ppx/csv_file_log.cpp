@@ -14,6 +14,8 @@
 
 #include "ppx/csv_file_log.h"
 
+#include <algorithm>
+
 namespace ppx {
 
 CSVFileLog::CSVFileLog()
@@ -21,59 +23,88 @@ CSVFileLog::CSVFileLog()
 {
 }
 
-CSVFileLog::CSVFileLog(const std::filesystem::path& filepath)
+CSVFileLog::CSVFileLog(const std::filesystem::path& filepath, size_t bufferSize)
+    : mBufferSize(std::max<size_t>(bufferSize, 1))
 {
+    mBuffer.reserve(mBufferSize);
+
     if (!filepath.empty()) {
         mFileStream.open(filepath.c_str());
     }
-    Lock();
+    if (mFileStream.is_open()) {
+        mWriterThread = std::thread(&CSVFileLog::WriterThreadMain, this);
+    }
 }
 
 CSVFileLog::~CSVFileLog()
 {
     Flush();
-    Unlock();
+
+    if (mWriterThread.joinable()) {
+        {
+            std::lock_guard lock(mWriteMutex);
+            mStopWriterThread = true;
+            mWriteCondition.notify_one();
+        }
+        mWriterThread.join();
+    }
+
     if (mFileStream.is_open()) {
         mFileStream.close();
     }
 }
 
-#if defined(__clang__)
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wthread-safety-analysis"
-#endif
-void CSVFileLog::Lock()
+void CSVFileLog::Flush()
 {
-    mWriteMutex.lock();
-}
+    if (mBuffer.empty()) {
+        return;
+    }
 
-void CSVFileLog::Unlock()
-{
-    mWriteMutex.unlock();
-}
-#if defined(__clang__)
-#pragma clang diagnostic pop
-#endif
+    if (!mWriterThread.joinable()) {
+        mBuffer.clear();
+        return;
+    }
 
-void CSVFileLog::Write(const char* msg)
-{
-    if (mFileStream.is_open()) {
-        mFileStream << msg;
+    {
+        std::lock_guard lock(mWriteMutex);
+        // Swapping hands over the rows without a copy, and gets back the
+        // storage of rows the writer thread already wrote
+        if (mPending.empty()) {
+            std::swap(mPending, mBuffer);
+        }
+        else {
+            mPending.append(mBuffer);
+        }
+        mWriteCondition.notify_one();
+    }
+
+    mBuffer.clear();
+    if (mBuffer.capacity() < mBufferSize) {
+        mBuffer.reserve(mBufferSize);
     }
 }
-void CSVFileLog::Flush()
+
+void CSVFileLog::WriterThreadMain()
 {
-    // Write anything that's in the buffer
-    Write(mBuffer.str().c_str());
+    std::string rows;
 
-    // Signal flush for file
-    if (mFileStream.is_open()) {
-        mFileStream.flush();
+    std::unique_lock<std::mutex> lock(mWriteMutex);
+    while (true) {
+        mWriteCondition.wait(lock, [this]() { return !mPending.empty() || mStopWriterThread; });
+        const bool stop = mStopWriterThread;
+        std::swap(rows, mPending);
+
+        lock.unlock();
+        mFileStream.write(rows.data(), static_cast<std::streamsize>(rows.size()));
+        rows.clear();
+        lock.lock();
+
+        if (stop && mPending.empty()) {
+            break;
+        }
     }
 
-    // Clear buffer
-    mBuffer.str(std::string());
-    mBuffer.clear();
+    mFileStream.flush();
 }
 
 } // namespace ppx
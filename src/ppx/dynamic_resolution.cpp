@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/dynamic_resolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ppx {
+
+// Largest increase of the scale per change
+static const float kMaxScaleUpStep = 1.1f;
+
+// Changes smaller than this are dropped, they only happen at the bounds
+static const float kMinScaleChange = 0.01f;
+
+// Scales must be in (0, 1] with min <= max, headroom in [0, 1) and smoothing
+// in (0, 1]
+Result DynamicResolutionController::Initialize(const DynamicResolutionControllerCreateInfo& createInfo)
+{
+    if ((createInfo.targetFrameTimeMs <= 0.0f) || (createInfo.minScale <= 0.0f) || (createInfo.minScale > createInfo.maxScale) || (createInfo.maxScale > 1.0f)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((createInfo.headroom < 0.0f) || (createInfo.headroom >= 1.0f) || (createInfo.smoothing <= 0.0f) || (createInfo.smoothing > 1.0f) || (createInfo.alignment == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mCreateInfo = createInfo;
+    Reset();
+
+    return ppx::SUCCESS;
+}
+
+void DynamicResolutionController::Reset()
+{
+    mScale              = mCreateInfo.maxScale;
+    mAverageFrameTimeMs = 0.0f;
+    mCooldown           = 0;
+    mHasAverage         = false;
+}
+
+void DynamicResolutionController::SetTargetFrameTimeMs(float targetFrameTimeMs)
+{
+    PPX_ASSERT_MSG(targetFrameTimeMs > 0.0f, "dynamic resolution target frame time must be positive");
+    mCreateInfo.targetFrameTimeMs = targetFrameTimeMs;
+}
+
+bool DynamicResolutionController::Update(float gpuFrameTimeMs)
+{
+    // Frames without results, e.g. the first ones in flight
+    if (!(gpuFrameTimeMs > 0.0f)) {
+        return false;
+    }
+
+    if (!mHasAverage) {
+        mAverageFrameTimeMs = gpuFrameTimeMs;
+        mHasAverage         = true;
+    }
+    else {
+        mAverageFrameTimeMs += mCreateInfo.smoothing * (gpuFrameTimeMs - mAverageFrameTimeMs);
+    }
+
+    if (mCooldown > 0) {
+        --mCooldown;
+        return false;
+    }
+
+    const float target = mCreateInfo.targetFrameTimeMs;
+    if ((mAverageFrameTimeMs <= target) && (mAverageFrameTimeMs >= target * (1.0f - mCreateInfo.headroom))) {
+        return false;
+    }
+
+    // Aim for the middle of the headroom
+    const float goal  = target * (1.0f - 0.5f * mCreateInfo.headroom);
+    float       scale = mScale * std::sqrt(goal / mAverageFrameTimeMs);
+    scale             = std::min(scale, mScale * kMaxScaleUpStep);
+    scale             = std::clamp(scale, mCreateInfo.minScale, mCreateInfo.maxScale);
+    if (std::fabs(scale - mScale) < kMinScaleChange) {
+        return false;
+    }
+
+    // The average was measured at the old scale
+    mAverageFrameTimeMs *= (scale * scale) / (mScale * mScale);
+    mScale    = scale;
+    mCooldown = mCreateInfo.cooldownFrames;
+
+    return true;
+}
+
+void DynamicResolutionController::GetRenderSize(uint32_t maxWidth, uint32_t maxHeight, uint32_t* pWidth, uint32_t* pHeight) const
+{
+    PPX_ASSERT_NULL_ARG(pWidth);
+    PPX_ASSERT_NULL_ARG(pHeight);
+
+    const uint32_t alignment = std::max<uint32_t>(mCreateInfo.alignment, 1);
+    auto           scaled    = [this, alignment](uint32_t size) {
+        uint32_t value = static_cast<uint32_t>(std::ceil(static_cast<float>(size) * mScale));
+        value          = ((value + alignment - 1) / alignment) * alignment;
+        return std::clamp<uint32_t>(value, 1, std::max<uint32_t>(size, 1));
+    };
+
+    *pWidth  = scaled(maxWidth);
+    *pHeight = scaled(maxHeight);
+}
+
+} // namespace ppx
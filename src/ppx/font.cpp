@@ -190,6 +190,89 @@ void Font::RenderGlyphBitmap(
         static_cast<int>(codepoint));
 }
 
+void Font::GetGlyphSDFBox(
+    float     fontSizeInPixels,
+    uint32_t  codepoint,
+    uint32_t  padding,
+    GlyphBox* pBox) const
+{
+    if (IsNull(pBox)) {
+        return;
+    }
+
+    float scale = stbtt_ScaleForPixelHeight(&mObject->fontInfo, fontSizeInPixels);
+
+    // Matches the box stbtt_GetCodepointSDF() computes
+    stbtt_GetCodepointBitmapBoxSubpixel(
+        &mObject->fontInfo,
+        static_cast<int>(codepoint),
+        scale,
+        scale,
+        0.0f,
+        0.0f,
+        &pBox->x0,
+        &pBox->y0,
+        &pBox->x1,
+        &pBox->y1);
+
+    // Glyphs without contours, such as space, have no field
+    if ((pBox->x0 == pBox->x1) || (pBox->y0 == pBox->y1)) {
+        return;
+    }
+
+    const int32_t pad = static_cast<int32_t>(padding);
+    pBox->x0 -= pad;
+    pBox->y0 -= pad;
+    pBox->x1 += pad;
+    pBox->y1 += pad;
+}
+
+void Font::RenderGlyphSDF(
+    float          fontSizeInPixels,
+    uint32_t       codepoint,
+    uint32_t       padding,
+    uint32_t       glyphWidth,
+    uint32_t       glyphHeight,
+    uint32_t       rowStride,
+    unsigned char* pOutput) const
+{
+    if (IsNull(pOutput) || (padding == 0)) {
+        return;
+    }
+
+    float scale = stbtt_ScaleForPixelHeight(&mObject->fontInfo, fontSizeInPixels);
+
+    const unsigned char kOnEdgeValue   = 128;
+    const float         pixelDistScale = static_cast<float>(kOnEdgeValue) / static_cast<float>(padding);
+
+    int            width  = 0;
+    int            height = 0;
+    int            xoff   = 0;
+    int            yoff   = 0;
+    unsigned char* pSdf   = stbtt_GetCodepointSDF(
+        &mObject->fontInfo,
+        scale,
+        static_cast<int>(codepoint),
+        static_cast<int>(padding),
+        kOnEdgeValue,
+        pixelDistScale,
+        &width,
+        &height,
+        &xoff,
+        &yoff);
+    if (IsNull(pSdf)) {
+        return;
+    }
+
+    const uint32_t copyWidth  = std::min<uint32_t>(glyphWidth, static_cast<uint32_t>(width));
+    const uint32_t copyHeight = std::min<uint32_t>(glyphHeight, static_cast<uint32_t>(height));
+    for (uint32_t y = 0; y < copyHeight; ++y) {
+        std::memcpy(pOutput + y * rowStride, pSdf + y * width, copyWidth);
+    }
+
+    stbtt_FreeSDF(pSdf, nullptr);
+}
+
 // void  Font::GetGlyphBitmap(float fontSizeInPixels)
 //{
 //     stbtt_MakeCodepointBitmapSubpixel(
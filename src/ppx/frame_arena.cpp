@@ -0,0 +1,141 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/frame_arena.h"
+
+#include <algorithm>
+
+namespace ppx {
+
+std::atomic<uint64_t> FrameArena::sFrame{0};
+
+FrameArena::FrameArena(size_t blockSize)
+    : mBlockSize(std::max<size_t>(blockSize, 256))
+{
+}
+
+FrameArena::~FrameArena()
+{
+    PPX_ASSERT_MSG(mScopeDepth == 0, "arena destroyed with an open scope");
+}
+
+char* FrameArena::AllocateFromBlock(size_t blockIndex, size_t size, size_t alignment)
+{
+    const Block&    block   = mBlocks[blockIndex];
+    const uintptr_t base    = reinterpret_cast<uintptr_t>(block.data.get());
+    const size_t    offset  = (blockIndex == mCurrentBlock) ? mOffset : 0;
+    const uintptr_t aligned = (base + offset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+    const size_t    end     = static_cast<size_t>(aligned - base) + size;
+    if (end > block.size) {
+        return nullptr;
+    }
+
+    mCurrentBlock  = blockIndex;
+    mOffset        = end;
+    mPeakUsedBytes = std::max(mPeakUsedBytes, GetUsedBytes());
+
+    return reinterpret_cast<char*>(aligned);
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+    PPX_ASSERT_MSG((alignment > 0) && ((alignment & (alignment - 1)) == 0), "alignment must be a power of 2");
+
+    // Zero sized allocations still get a unique address
+    size = std::max<size_t>(size, 1);
+
+    // Blocks after the current one are free, skipped space at the end of
+    // a block stays unused until the arena is rewound
+    for (size_t i = mCurrentBlock; i < mBlocks.size(); ++i) {
+        char* pData = AllocateFromBlock(i, size, alignment);
+        if (!IsNull(pData)) {
+            return pData;
+        }
+    }
+
+    Block block = {};
+    block.size  = std::max(mBlockSize, size + alignment);
+    block.data.reset(new char[block.size]);
+    mBlocks.push_back(std::move(block));
+
+    char* pData = AllocateFromBlock(mBlocks.size() - 1, size, alignment);
+    PPX_ASSERT_MSG(!IsNull(pData), "new block too small");
+    return pData;
+}
+
+void FrameArena::Rewind(const Marker& marker)
+{
+    PPX_ASSERT_MSG((marker.block < mCurrentBlock) || ((marker.block == mCurrentBlock) && (marker.offset <= mOffset)), "marker is past the current position");
+    mCurrentBlock = marker.block;
+    mOffset       = marker.offset;
+}
+
+void FrameArena::Reset()
+{
+    PPX_ASSERT_MSG(mScopeDepth == 0, "arena reset with an open scope");
+
+    // Replace the blocks with one that holds all of them
+    if (mBlocks.size() > 1) {
+        Block block = {};
+        for (const Block& oldBlock : mBlocks) {
+            block.size += oldBlock.size;
+        }
+        block.data.reset(new char[block.size]);
+        mBlocks.clear();
+        mBlocks.push_back(std::move(block));
+    }
+
+    mCurrentBlock = 0;
+    mOffset       = 0;
+}
+
+size_t FrameArena::GetUsedBytes() const
+{
+    size_t usedBytes = 0;
+    for (size_t i = 0; (i < mCurrentBlock) && (i < mBlocks.size()); ++i) {
+        usedBytes += mBlocks[i].size;
+    }
+    return usedBytes + mOffset;
+}
+
+size_t FrameArena::GetCapacity() const
+{
+    size_t capacity = 0;
+    for (const Block& block : mBlocks) {
+        capacity += block.size;
+    }
+    return capacity;
+}
+
+FrameArena& FrameArena::GetThreadArena()
+{
+    thread_local FrameArena sArena;
+
+    // Scopes can be open across a frame boundary, the arena resets once
+    // they're closed
+    const uint64_t frame = sFrame.load(std::memory_order_relaxed);
+    if ((sArena.mFrame != frame) && (sArena.mScopeDepth == 0)) {
+        sArena.Reset();
+        sArena.mFrame = frame;
+    }
+
+    return sArena;
+}
+
+void FrameArena::NextFrame()
+{
+    sFrame.fetch_add(1, std::memory_order_relaxed);
+}
+
+} // namespace ppx
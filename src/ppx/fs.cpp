@@ -14,10 +14,19 @@
 
 #include "ppx/fs.h"
 #include "ppx/config.h"
+#include "ppx/thread_policy.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <optional>
+#include <thread>
 #include <vector>
 
 #if defined(PPX_ANDROID)
@@ -25,6 +34,23 @@
 android_app* gAndroidContext;
 #endif
 
+// clang-format off
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#elif defined(PPX_MSW)
+#   if ! defined(VC_EXTRALEAN)
+#       define VC_EXTRALEAN
+#   endif
+#   if ! defined(WIN32_LEAN_AND_MEAN)
+#   define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <Windows.h>
+#endif
+// clang-format on
+
 namespace ppx::fs {
 
 #if defined(PPX_ANDROID)
@@ -52,6 +78,13 @@ File::~File()
         case STREAM_HANDLE:
             mStream.close();
             break;
+        case MAPPED_HANDLE:
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+            munmap(const_cast<void*>(mBuffer), mFileSize);
+#elif defined(PPX_MSW)
+            UnmapViewOfFile(mBuffer);
+#endif
+            break;
         default:
             break;
     }
@@ -83,11 +116,67 @@ bool File::Open(const std::filesystem::path& path)
     return true;
 }
 
+bool File::OpenMapped(const std::filesystem::path& path)
+{
+#if defined(PPX_ANDROID)
+    // APK assets are mapped by Open()
+    if (!path.is_absolute()) {
+        return Open(path);
+    }
+#endif
+
+    const void* pBuffer = nullptr;
+    size_t      size    = 0;
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info = {};
+    if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && (info.st_size > 0)) {
+        size        = static_cast<size_t>(info.st_size);
+        void* pData = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        pBuffer     = (pData != MAP_FAILED) ? pData : nullptr;
+    }
+    // The mapping keeps the file open
+    close(fd);
+#elif defined(PPX_MSW)
+    HANDLE hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize = {};
+    if (GetFileSizeEx(hFile, &fileSize) && (fileSize.QuadPart > 0)) {
+        HANDLE hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (hMapping != nullptr) {
+            size    = static_cast<size_t>(fileSize.QuadPart);
+            pBuffer = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            // The view keeps the mapping and the file open
+            CloseHandle(hMapping);
+        }
+    }
+    CloseHandle(hFile);
+#endif
+
+    if (IsNull(pBuffer)) {
+        return Open(path);
+    }
+
+    mBuffer     = pBuffer;
+    mFileSize   = size;
+    mFileOffset = 0;
+    mHandleType = MAPPED_HANDLE;
+    return true;
+}
+
 bool File::IsValid() const
 {
     if (mHandleType == STREAM_HANDLE) {
         return mStream.good();
     }
+    if (mHandleType == MAPPED_HANDLE) {
+        return mBuffer != nullptr;
+    }
     return mHandleType == ASSET_HANDLE && mAsset != nullptr;
 }
 
@@ -156,6 +245,191 @@ std::optional<std::vector<char>> load_file(const std::filesystem::path& path)
     return buffer;
 }
 
+// Threads doing the blocking reads of load_file_async(). They mostly wait on
+// the disk, a few keep its queue busy without competing with decoding.
+class IoThreadPool
+{
+public:
+    IoThreadPool()
+    {
+        const uint32_t threadCount = std::clamp<uint32_t>(std::thread::hardware_concurrency(), 1, kMaxThreadCount);
+        for (uint32_t i = 0; i < threadCount; ++i) {
+            mThreads.emplace_back([this]() { Run(); });
+        }
+    }
+
+    ~IoThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mCondition.notify_all();
+        for (std::thread& thread : mThreads) {
+            thread.join();
+        }
+    }
+
+    void Push(std::function<void()>&& task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+        mCondition.notify_one();
+    }
+
+private:
+    static constexpr uint32_t kMaxThreadCount = 4;
+
+    void Run()
+    {
+        ApplyThreadPolicy(THREAD_ROLE_LOADER);
+
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+                // Pending loads still complete on shutdown
+                if (mTasks.empty()) {
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex                        mMutex;
+    std::condition_variable           mCondition;
+    std::deque<std::function<void()>> mTasks;
+    std::vector<std::thread>          mThreads;
+    bool                              mStop = false;
+};
+
+bool AsyncLoad::IsValid() const
+{
+    return mFuture.valid();
+}
+
+bool AsyncLoad::IsReady() const
+{
+    return IsValid() && (mFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+}
+
+std::optional<std::vector<char>> AsyncLoad::Wait()
+{
+    PPX_ASSERT_MSG(IsValid(), "Calling AsyncLoad::Wait() on an invalid handle.");
+    return mFuture.get();
+}
+
+AsyncLoad load_file_async(const std::filesystem::path& path)
+{
+    static IoThreadPool sThreadPool;
+
+    // std::function needs copyable tasks
+    auto task = std::make_shared<std::packaged_task<std::optional<std::vector<char>>()>>([path]() { return load_file(path); });
+
+    AsyncLoad load;
+    load.mFuture = task->get_future();
+    sThreadPool.Push([task]() { (*task)(); });
+    return load;
+}
+
+namespace {
+
+constexpr char   kAssetPackMagic[8]   = "PPXPACK";
+constexpr size_t kAssetPackHeaderSize = 16;
+constexpr size_t kAssetPackEntrySize  = 24;
+
+template <typename T>
+T ReadPacked(const char* pData)
+{
+    T value;
+    memcpy(&value, pData, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+bool AssetPack::Open(const std::filesystem::path& path)
+{
+    mFile.reset();
+    mStorage.clear();
+    mData = nullptr;
+    mSize = 0;
+    mEntries.clear();
+
+    auto file = std::make_unique<File>();
+    if (!file->OpenMapped(path)) {
+        return false;
+    }
+
+    if (file->IsMapped()) {
+        mData = static_cast<const char*>(file->GetMappedData());
+        mSize = file->GetLength();
+        mFile = std::move(file);
+    }
+    else {
+        mStorage.resize(file->GetLength());
+        if (file->Read(mStorage.data(), mStorage.size()) != mStorage.size()) {
+            mStorage.clear();
+            return false;
+        }
+        mData = mStorage.data();
+        mSize = mStorage.size();
+    }
+
+    if ((mSize < kAssetPackHeaderSize) || (memcmp(mData, kAssetPackMagic, sizeof(kAssetPackMagic)) != 0)) {
+        return false;
+    }
+    const uint32_t version    = ReadPacked<uint32_t>(mData + 8);
+    const uint32_t entryCount = ReadPacked<uint32_t>(mData + 12);
+    const size_t   namesStart = kAssetPackHeaderSize + static_cast<size_t>(entryCount) * kAssetPackEntrySize;
+    if ((version != kVersion) || (namesStart > mSize)) {
+        return false;
+    }
+
+    mEntries.reserve(entryCount);
+    for (uint32_t i = 0; i < entryCount; ++i) {
+        const char*    pEntry     = mData + kAssetPackHeaderSize + i * kAssetPackEntrySize;
+        const uint32_t nameOffset = ReadPacked<uint32_t>(pEntry);
+        const uint32_t nameSize   = ReadPacked<uint32_t>(pEntry + 4);
+        Entry          entry      = {ReadPacked<uint64_t>(pEntry + 8), ReadPacked<uint64_t>(pEntry + 16)};
+
+        const bool nameInBounds = (namesStart + nameOffset + nameSize) <= mSize;
+        const bool dataInBounds = (entry.offset <= mSize) && (entry.size <= mSize - entry.offset);
+        if (!nameInBounds || !dataInBounds) {
+            mEntries.clear();
+            return false;
+        }
+        mEntries.emplace(std::string(mData + namesStart + nameOffset, nameSize), entry);
+    }
+    return true;
+}
+
+const void* AssetPack::Find(const std::string& name, size_t* pSize) const
+{
+    auto it = mEntries.find(name);
+    if (it == mEntries.end()) {
+        return nullptr;
+    }
+    *pSize = static_cast<size_t>(it->second.size);
+    return mData + it->second.offset;
+}
+
+std::optional<std::vector<char>> AssetPack::Load(const std::string& name) const
+{
+    size_t      size  = 0;
+    const char* pData = static_cast<const char*>(Find(name, &size));
+    if (pData == nullptr) {
+        return std::nullopt;
+    }
+    return std::vector<char>(pData, pData + size);
+}
+
 bool path_exists(const std::filesystem::path& path)
 {
 #if defined(PPX_ANDROID)
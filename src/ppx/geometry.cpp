@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include "ppx/geometry.h"
+#include <algorithm>
 #include <cmath>
+#include <numeric>
 
 #define NOT_INTERLEAVED_MSG "cannot append interleaved data if attribute layout is not interleaved"
 #define NOT_PLANAR_MSG      "cannot append planar data if attribute layout is not planar"
@@ -663,6 +665,81 @@ uint32_t Geometry::Buffer::GetElementCount() const
     return count;
 }
 
+// -------------------------------------------------------------------------------------------------
+// Vertex streams
+//     Geometry::Create() from a TriMesh copies one attribute of all vertices at a time instead
+//     of going through the VertexDataProcessor for every vertex. Planar bindings become plain
+//     memcpys, interleaved ones fixed size copies the compiler turns into vector moves.
+// -------------------------------------------------------------------------------------------------
+
+// Attribute data of a TriMesh, vertices past count read as zeros the way
+// TriMesh::GetVertexData() leaves missing attributes
+struct VertexStream
+{
+    const char* pData       = nullptr;
+    uint32_t    count       = 0;
+    uint32_t    elementSize = 0;
+};
+
+template <typename T>
+static VertexStream MakeVertexStream(const T* pData, uint32_t count)
+{
+    VertexStream stream = {};
+    stream.pData        = reinterpret_cast<const char*>(pData);
+    stream.count        = IsNull(pData) ? 0 : count;
+    stream.elementSize  = static_cast<uint32_t>(sizeof(T));
+    return stream;
+}
+
+// Returns false for semantics TriMeshVertexData doesn't have
+static bool GetVertexStream(const TriMesh& mesh, grfx::VertexSemantic semantic, VertexStream* pStream)
+{
+    // clang-format off
+    switch (semantic) {
+        default                              : return false;
+        case grfx::VERTEX_SEMANTIC_POSITION  : *pStream = MakeVertexStream(mesh.GetDataPositions(), mesh.GetCountPositions()); break;
+        case grfx::VERTEX_SEMANTIC_NORMAL    : *pStream = MakeVertexStream(mesh.GetDataNormalls(), mesh.GetCountNormals()); break;
+        case grfx::VERTEX_SEMANTIC_COLOR     : *pStream = MakeVertexStream(mesh.GetDataColors(), mesh.GetCountColors()); break;
+        case grfx::VERTEX_SEMANTIC_TANGENT   : *pStream = MakeVertexStream(mesh.GetDataTangents(), mesh.GetCountTangents()); break;
+        case grfx::VERTEX_SEMANTIC_BITANGENT : *pStream = MakeVertexStream(mesh.GetDataBitangents(), mesh.GetCountBitangents()); break;
+        case grfx::VERTEX_SEMANTIC_TEXCOORD  : *pStream = MakeVertexStream(mesh.GetDataTexCoords2(), mesh.GetCountTexCoords()); break;
+    }
+    // clang-format on
+    return true;
+}
+
+template <size_t kSize>
+static void CopyVertexStream(const VertexStream& src, const uint32_t* pIndices, uint32_t count, char* pDst, uint32_t dstStride)
+{
+    if (IsNull(pIndices) && (dstStride == kSize)) {
+        const uint32_t copyCount = std::min(count, src.count);
+        if (copyCount > 0) {
+            memcpy(pDst, src.pData, copyCount * kSize);
+        }
+        memset(pDst + copyCount * kSize, 0, (count - copyCount) * kSize);
+        return;
+    }
+
+    static const char kZeros[kSize] = {};
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t index = IsNull(pIndices) ? i : pIndices[i];
+        const char*    pSrc  = (index < src.count) ? (src.pData + static_cast<size_t>(index) * kSize) : kZeros;
+        memcpy(pDst + static_cast<size_t>(i) * dstStride, pSrc, kSize);
+    }
+}
+
+static void CopyVertexStream(const VertexStream& src, const uint32_t* pIndices, uint32_t count, char* pDst, uint32_t dstStride)
+{
+    // clang-format off
+    switch (src.elementSize) {
+        default : PPX_ASSERT_MSG(false, "unsupported vertex stream element size: " << src.elementSize); break;
+        case 8  : CopyVertexStream<8>(src, pIndices, count, pDst, dstStride); break;
+        case 12 : CopyVertexStream<12>(src, pIndices, count, pDst, dstStride); break;
+        case 16 : CopyVertexStream<16>(src, pIndices, count, pDst, dstStride); break;
+    }
+    // clang-format on
+}
+
 // -------------------------------------------------------------------------------------------------
 // Geometry
 // -------------------------------------------------------------------------------------------------
@@ -743,6 +820,36 @@ Result Geometry::Create(
         return ppxres;
     }
 
+    // Whole attribute streams at a time if the formats match the mesh data,
+    // the vertex at a time paths below handle the rest
+    {
+        const bool            meshIndexed     = (mesh.GetIndexType() != grfx::INDEX_TYPE_UNDEFINED);
+        const bool            geometryIndexed = (createInfo.indexType != grfx::INDEX_TYPE_UNDEFINED);
+        const uint32_t        positionCount   = mesh.GetCountPositions();
+        std::vector<uint32_t> indices;
+        if (meshIndexed) {
+            mesh.GetIndices(indices);
+            indices.resize(3 * mesh.GetCountTriangles());
+        }
+        else if (geometryIndexed) {
+            // Every 3 vertices are a triangle
+            indices.resize(3 * (positionCount / 3));
+            std::iota(indices.begin(), indices.end(), 0);
+        }
+
+        // Unindexed geometry from an indexed mesh gets a vertex per index
+        const bool     gather      = meshIndexed && !geometryIndexed;
+        const uint32_t vertexCount = (meshIndexed == geometryIndexed) ? positionCount : CountU32(indices);
+        const bool     inRange     = !gather || std::all_of(indices.begin(), indices.end(), [positionCount](uint32_t index) { return index < positionCount; });
+
+        if (inRange && pGeometry->AppendVertexStreams(mesh, gather ? indices.data() : nullptr, vertexCount)) {
+            if (geometryIndexed) {
+                pGeometry->AppendIndices(CountU32(indices), indices.data());
+            }
+            return ppx::SUCCESS;
+        }
+    }
+
     //
     // Target geometry WITHOUT index data
     //
@@ -1155,6 +1262,57 @@ void Geometry::AppendIndicesEdge(uint32_t idx0, uint32_t idx1)
     }
 }
 
+bool Geometry::AppendVertexStreams(const TriMesh& mesh, const uint32_t* pIndices, uint32_t count)
+{
+    // Vertex buffers match the bindings one to one in every layout
+    for (uint32_t bindingIndex = 0; bindingIndex < mCreateInfo.vertexBindingCount; ++bindingIndex) {
+        const grfx::VertexBinding& binding = mCreateInfo.vertexBindings[bindingIndex];
+        for (uint32_t attrIndex = 0; attrIndex < binding.GetAttributeCount(); ++attrIndex) {
+            const grfx::VertexAttribute* pAttribute = nullptr;
+            VertexStream                 stream     = {};
+            if (Failed(binding.GetAttribute(attrIndex, &pAttribute)) || !GetVertexStream(mesh, pAttribute->semantic, &stream)) {
+                return false;
+            }
+            if (grfx::GetFormatDescription(pAttribute->format)->bytesPerTexel != stream.elementSize) {
+                return false;
+            }
+        }
+    }
+
+    for (uint32_t bindingIndex = 0; bindingIndex < mCreateInfo.vertexBindingCount; ++bindingIndex) {
+        const grfx::VertexBinding& binding   = mCreateInfo.vertexBindings[bindingIndex];
+        Geometry::Buffer&          buffer    = mVertexBuffers[bindingIndex];
+        const uint32_t             startSize = buffer.GetSize();
+        buffer.SetSize(startSize + count * binding.GetStride());
+
+        char* pDst = buffer.GetData() + startSize;
+        for (uint32_t attrIndex = 0; attrIndex < binding.GetAttributeCount(); ++attrIndex) {
+            const grfx::VertexAttribute* pAttribute = nullptr;
+            VertexStream                 stream     = {};
+            binding.GetAttribute(attrIndex, &pAttribute);
+            GetVertexStream(mesh, pAttribute->semantic, &stream);
+            CopyVertexStream(stream, pIndices, count, pDst + pAttribute->offset, binding.GetStride());
+        }
+    }
+
+    return true;
+}
+
+void Geometry::AppendIndices(uint32_t count, const uint32_t* pIndices)
+{
+    if (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT32) {
+        mIndexBuffer.Append(count, pIndices);
+    }
+    else if (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT16) {
+        std::vector<uint16_t> indices(pIndices, pIndices + count);
+        mIndexBuffer.Append(count, indices.data());
+    }
+    else if (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT8) {
+        std::vector<uint8_t> indices(pIndices, pIndices + count);
+        mIndexBuffer.Append(count, indices.data());
+    }
+}
+
 void Geometry::AppendIndicesU32(uint32_t count, const uint32_t* pIndices)
 {
     if (mCreateInfo.indexType != grfx::INDEX_TYPE_UINT32) {
@@ -1164,6 +1322,69 @@ void Geometry::AppendIndicesU32(uint32_t count, const uint32_t* pIndices)
     mIndexBuffer.Append(count, pIndices);
 }
 
+std::vector<uint32_t> Geometry::GetIndicesU32() const
+{
+    std::vector<uint32_t> indices(GetIndexCount());
+    if (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT32) {
+        const uint32_t* pIndices = reinterpret_cast<const uint32_t*>(mIndexBuffer.GetData());
+        std::copy(pIndices, pIndices + indices.size(), indices.begin());
+    }
+    else if (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT16) {
+        const uint16_t* pIndices = reinterpret_cast<const uint16_t*>(mIndexBuffer.GetData());
+        std::copy(pIndices, pIndices + indices.size(), indices.begin());
+    }
+    else if (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT8) {
+        const uint8_t* pIndices = reinterpret_cast<const uint8_t*>(mIndexBuffer.GetData());
+        std::copy(pIndices, pIndices + indices.size(), indices.begin());
+    }
+    return indices;
+}
+
+bool Geometry::CompactIndices()
+{
+    if (mCreateInfo.indexType != grfx::INDEX_TYPE_UINT32) {
+        return false;
+    }
+
+    const std::vector<uint32_t> indices = GetIndicesU32();
+    if (std::any_of(indices.begin(), indices.end(), [](uint32_t index) { return index >= UINT16_MAX; })) {
+        return false;
+    }
+
+    mCreateInfo.indexType = grfx::INDEX_TYPE_UINT16;
+    mIndexBuffer          = Buffer(BUFFER_TYPE_INDEX, grfx::IndexTypeSize(mCreateInfo.indexType));
+    AppendIndices(CountU32(indices), indices.data());
+    return true;
+}
+
+bool Geometry::ConvertToTriangleStrips()
+{
+    if (mCreateInfo.primitiveTopology != grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {
+        return false;
+    }
+    if ((mCreateInfo.indexType != grfx::INDEX_TYPE_UINT16) && (mCreateInfo.indexType != grfx::INDEX_TYPE_UINT32)) {
+        return false;
+    }
+
+    const uint32_t restartIndex = (mCreateInfo.indexType == grfx::INDEX_TYPE_UINT16) ? UINT16_MAX : UINT32_MAX;
+    const uint32_t vertexCount  = GetVertexCount();
+    if (vertexCount > restartIndex) {
+        return false;
+    }
+
+    const std::vector<uint32_t> indices = GetIndicesU32();
+    std::vector<uint32_t>       strips;
+    const uint32_t              stripIndexCount = GenerateTriangleStrips(indices.data(), CountU32(indices), vertexCount, restartIndex, &strips);
+    if ((stripIndexCount == 0) || (stripIndexCount >= CountU32(indices))) {
+        return false;
+    }
+
+    mCreateInfo.primitiveTopology = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    mIndexBuffer                  = Buffer(BUFFER_TYPE_INDEX, mIndexBuffer.GetElementSize());
+    AppendIndices(stripIndexCount, strips.data());
+    return true;
+}
+
 uint32_t Geometry::AppendVertexData(const TriMeshVertexData& vtx)
 {
     return mVDProcessor->AppendVertexData(this, vtx);
@@ -17,6 +17,7 @@
 #include "ppx/graphics_util.h"
 #include "ppx/bitmap.h"
 #include "ppx/fs.h"
+#include "ppx/job_system.h"
 #include "ppx/mipmap.h"
 #include "ppx/timer.h"
 #include "ppx/grfx/grfx_buffer.h"
@@ -24,9 +25,15 @@
 #include "ppx/grfx/grfx_device.h"
 #include "ppx/grfx/grfx_image.h"
 #include "ppx/grfx/grfx_queue.h"
+#include "ppx/grfx/grfx_upload_batch.h"
 #include "ppx/grfx/grfx_util.h"
 #include "ppx/grfx/grfx_scope.h"
 #include "gli/gli.hpp"
+#include "xxhash.h"
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 
 namespace ppx {
 namespace grfx_util {
@@ -85,6 +92,20 @@ grfx::Format ToGrfxFormat(gli::format value)
 
 // -------------------------------------------------------------------------------------------------
 
+// Uploads go to the device's transfer queue when it's in a different queue
+// family than pQueue so they don't compete with rendering. The batch hands
+// ownership back to pQueue, resources are usable there once it completes.
+static grfx::Queue* GetUploadQueue(grfx::Queue* pQueue)
+{
+    grfx::Device* pDevice = pQueue->GetDevice();
+    if (pDevice->GetTransferQueueCount() == 0) {
+        return pQueue;
+    }
+
+    grfx::Queue* pTransferQueue = pDevice->GetTransferQueue();
+    return pTransferQueue->RequiresOwnershipTransfer(pQueue) ? pTransferQueue : pQueue;
+}
+
 Result CopyBitmapToImage(
     grfx::Queue*        pQueue,
     const Bitmap*       pBitmap,
@@ -98,97 +119,155 @@ Result CopyBitmapToImage(
     PPX_ASSERT_NULL_ARG(pBitmap);
     PPX_ASSERT_NULL_ARG(pImage);
 
-    Result ppxres = ppx::ERROR_FAILED;
+    uint64_t          stagingSize = grfx::UploadBatch::CalculateStagingSize(pQueue->GetDevice()->GetApi(), pBitmap);
+    grfx::UploadBatch batch(GetUploadQueue(pQueue), stagingSize, pQueue);
 
-    // Scoped destroy
-    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+    Result ppxres = batch.AddBitmapUpload(pBitmap, pImage, mipLevel, arrayLayer, stateBefore, stateAfter);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
 
-    // This is the number of bytes we're going to copy per row.
-    uint32_t rowCopySize = pBitmap->GetWidth() * pBitmap->GetPixelStride();
+    ppxres = batch.Submit();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
 
-    // When copying from a buffer to a image/texture, D3D12 requires that the rows
-    // stored in the source buffer (aka staging buffer) are aligned to 256 bytes.
-    // Vulkan does not have this requirement. So for the staging buffer, we want
-    // to enforce the alignment for D3D12 but not for Vulkan.
-    //
-    uint32_t apiRowStrideAligement = grfx::IsDx12(pQueue->GetDevice()->GetApi()) ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
-    // The staging buffer's row stride alignemnt needs to be based off the bitmap's
-    // width (i.e. the number of bytes we're going to copy) and not the bitmap's row
-    // stride. The bitmap's may be padded beyond width * pixel stride.
-    //
-    uint32_t stagingBufferRowStride = RoundUp<uint32_t>(rowCopySize, apiRowStrideAligement);
+    ppxres = batch.Wait();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
 
-    // Create staging buffer
-    grfx::BufferPtr stagingBuffer;
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+Result CopyBufferAcrossDevices(
+    grfx::Queue*        pSrcQueue,
+    grfx::Buffer*       pSrcBuffer,
+    uint64_t            srcOffset,
+    grfx::ResourceState srcState,
+    grfx::Queue*        pDstQueue,
+    grfx::Buffer*       pDstBuffer,
+    uint64_t            dstOffset,
+    grfx::ResourceState dstState,
+    uint64_t            size)
+{
+    PPX_ASSERT_NULL_ARG(pSrcQueue);
+    PPX_ASSERT_NULL_ARG(pSrcBuffer);
+    PPX_ASSERT_NULL_ARG(pDstQueue);
+    PPX_ASSERT_NULL_ARG(pDstBuffer);
+
+    if ((srcOffset + size > pSrcBuffer->GetSize()) || (dstOffset + size > pDstBuffer->GetSize())) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    if (size == 0) {
+        return ppx::SUCCESS;
+    }
+
+    grfx::ScopeDestroyer srcDestroyer(pSrcQueue->GetDevice());
+    grfx::ScopeDestroyer dstDestroyer(pDstQueue->GetDevice());
+
+    // Readback on the source device
+    grfx::BufferPtr readbackBuffer;
+    {
+        grfx::BufferCreateInfo ci      = {};
+        ci.size                        = size;
+        ci.usageFlags.bits.transferDst = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        ci.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+
+        Result ppxres = pSrcQueue->GetDevice()->CreateBuffer(&ci, &readbackBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        srcDestroyer.AddObject(readbackBuffer);
+    }
+
+    // Copy to the readback buffer and wait for it
     {
-        uint64_t bufferSize = stagingBufferRowStride * pBitmap->GetHeight();
+        grfx::CommandBufferPtr cmd;
+        Result                 ppxres = pSrcQueue->CreateCommandBuffer(&cmd, 0, 0);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        srcDestroyer.AddObject(pSrcQueue, cmd);
+
+        ppxres = cmd->Begin();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = size;
+        copyInfo.srcBuffer.offset             = srcOffset;
+        copyInfo.dstBuffer.offset             = 0;
+
+        cmd->BufferResourceBarrier(pSrcBuffer, srcState, grfx::RESOURCE_STATE_COPY_SRC);
+        cmd->CopyBufferToBuffer(&copyInfo, pSrcBuffer, readbackBuffer);
+        cmd->BufferResourceBarrier(pSrcBuffer, grfx::RESOURCE_STATE_COPY_SRC, srcState);
+
+        ppxres = cmd->End();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        grfx::SubmitInfo submitInfo   = {};
+        submitInfo.commandBufferCount = 1;
+        submitInfo.ppCommandBuffers   = &cmd;
+
+        ppxres = pSrcQueue->Submit(&submitInfo);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = pSrcQueue->WaitIdle();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
 
+    // Upload on the destination device
+    grfx::BufferPtr uploadBuffer;
+    {
         grfx::BufferCreateInfo ci      = {};
-        ci.size                        = bufferSize;
+        ci.size                        = size;
         ci.usageFlags.bits.transferSrc = true;
         ci.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        ci.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
 
-        ppxres = pQueue->GetDevice()->CreateBuffer(&ci, &stagingBuffer);
+        Result ppxres = pDstQueue->GetDevice()->CreateBuffer(&ci, &uploadBuffer);
         if (Failed(ppxres)) {
             return ppxres;
         }
-        SCOPED_DESTROYER.AddObject(stagingBuffer);
+        dstDestroyer.AddObject(uploadBuffer);
 
-        // Map and copy to staging buffer
-        void* pBufferAddress = nullptr;
-        ppxres               = stagingBuffer->MapMemory(0, &pBufferAddress);
+        void* pSrcAddress = nullptr;
+        ppxres            = readbackBuffer->MapMemory(0, &pSrcAddress);
         if (Failed(ppxres)) {
             return ppxres;
         }
 
-        const char*    pSrc         = pBitmap->GetData();
-        char*          pDst         = static_cast<char*>(pBufferAddress);
-        const uint32_t srcRowStride = pBitmap->GetRowStride();
-        const uint32_t dstRowStride = stagingBufferRowStride;
-        for (uint32_t y = 0; y < pBitmap->GetHeight(); ++y) {
-            memcpy(pDst, pSrc, rowCopySize);
-            pSrc += srcRowStride;
-            pDst += dstRowStride;
+        void* pDstAddress = nullptr;
+        ppxres            = uploadBuffer->MapMemory(0, &pDstAddress);
+        if (Failed(ppxres)) {
+            readbackBuffer->UnmapMemory();
+            return ppxres;
         }
 
-        stagingBuffer->UnmapMemory();
-    }
-
-    // Copy info
-    grfx::BufferToImageCopyInfo copyInfo = {};
-    copyInfo.srcBuffer.imageWidth        = pBitmap->GetWidth();
-    copyInfo.srcBuffer.imageHeight       = pBitmap->GetHeight();
-    copyInfo.srcBuffer.imageRowStride    = stagingBufferRowStride;
-    copyInfo.srcBuffer.footprintOffset   = 0;
-    copyInfo.srcBuffer.footprintWidth    = pBitmap->GetWidth();
-    copyInfo.srcBuffer.footprintHeight   = pBitmap->GetHeight();
-    copyInfo.srcBuffer.footprintDepth    = 1;
-    copyInfo.dstImage.mipLevel           = mipLevel;
-    copyInfo.dstImage.arrayLayer         = arrayLayer;
-    copyInfo.dstImage.arrayLayerCount    = 1;
-    copyInfo.dstImage.x                  = 0;
-    copyInfo.dstImage.y                  = 0;
-    copyInfo.dstImage.z                  = 0;
-    copyInfo.dstImage.width              = pBitmap->GetWidth();
-    copyInfo.dstImage.height             = pBitmap->GetHeight();
-    copyInfo.dstImage.depth              = 1;
+        std::memcpy(pDstAddress, pSrcAddress, static_cast<size_t>(size));
 
-    // Copy to GPU image
-    ppxres = pQueue->CopyBufferToImage(
-        std::vector<grfx::BufferToImageCopyInfo>{copyInfo},
-        stagingBuffer,
-        pImage,
-        mipLevel,
-        1,
-        arrayLayer,
-        1,
-        stateBefore,
-        stateAfter);
-    if (Failed(ppxres)) {
-        return ppxres;
+        uploadBuffer->UnmapMemory();
+        readbackBuffer->UnmapMemory();
     }
 
-    return ppx::SUCCESS;
+    // Copy to the destination, waits for it
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = size;
+    copyInfo.srcBuffer.offset             = 0;
+    copyInfo.dstBuffer.offset             = dstOffset;
+
+    return pDstQueue->CopyBufferToBuffer(&copyInfo, uploadBuffer, pDstBuffer, dstState, dstState);
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -203,24 +282,45 @@ Result CreateImageFromBitmap(
     PPX_ASSERT_NULL_ARG(pBitmap);
     PPX_ASSERT_NULL_ARG(ppImage);
 
+    // Cap mip level count
+    uint32_t maxMipLevelCount = Mipmap::CalculateLevelCount(pBitmap->GetWidth(), pBitmap->GetHeight());
+    uint32_t mipLevelCount    = std::min<uint32_t>(options.mMipLevelCount, maxMipLevelCount);
+
+    // Since this mipmap is temporary, it's safe to use the static pool.
+    Mipmap mipmap = Mipmap(*pBitmap, mipLevelCount, /* useStaticPool= */ true);
+    if (!mipmap.IsOk()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    return CreateImageFromMipLevels(pQueue, mipLevelCount, mipmap.GetMip(0), ppImage, options);
+}
+
+Result CreateImageFromMipLevels(
+    grfx::Queue*        pQueue,
+    uint32_t            mipLevelCount,
+    const Bitmap*       pMips,
+    grfx::Image**       ppImage,
+    const ImageOptions& options)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pMips);
+    PPX_ASSERT_NULL_ARG(ppImage);
+    PPX_ASSERT_MSG(mipLevelCount > 0, "mip level count must be non-zero");
+
     Result ppxres = ppx::ERROR_FAILED;
 
     // Scoped destroy
     grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
 
-    // Cap mip level count
-    uint32_t maxMipLevelCount = Mipmap::CalculateLevelCount(pBitmap->GetWidth(), pBitmap->GetHeight());
-    uint32_t mipLevelCount    = std::min<uint32_t>(options.mMipLevelCount, maxMipLevelCount);
-
     // Create target image
     grfx::ImagePtr targetImage;
     {
         grfx::ImageCreateInfo ci       = {};
         ci.type                        = grfx::IMAGE_TYPE_2D;
-        ci.width                       = pBitmap->GetWidth();
-        ci.height                      = pBitmap->GetHeight();
+        ci.width                       = pMips[0].GetWidth();
+        ci.height                      = pMips[0].GetHeight();
         ci.depth                       = 1;
-        ci.format                      = ToGrfxFormat(pBitmap->GetFormat());
+        ci.format                      = ToGrfxFormat(pMips[0].GetFormat());
         ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
         ci.mipLevelCount               = mipLevelCount;
         ci.arrayLayerCount             = 1;
@@ -238,18 +338,17 @@ Result CreateImageFromBitmap(
         SCOPED_DESTROYER.AddObject(targetImage);
     }
 
-    // Since this mipmap is temporary, it's safe to use the static pool.
-    Mipmap mipmap = Mipmap(*pBitmap, mipLevelCount, /* useStaticPool= */ true);
-    if (!mipmap.IsOk()) {
-        return ppx::ERROR_FAILED;
+    // Copy mips to image in a single submission
+    uint64_t stagingSize = 0;
+    for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel) {
+        stagingSize += grfx::UploadBatch::CalculateStagingSize(pQueue->GetDevice()->GetApi(), &pMips[mipLevel]);
     }
 
-    // Copy mips to image
+    grfx::UploadBatch batch(GetUploadQueue(pQueue), stagingSize, pQueue);
     for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel) {
-        const Bitmap* pMip = mipmap.GetMip(mipLevel);
+        const Bitmap* pMip = &pMips[mipLevel];
 
-        ppxres = CopyBitmapToImage(
-            pQueue,
+        ppxres = batch.AddBitmapUpload(
             pMip,
             targetImage,
             mipLevel,
@@ -261,6 +360,114 @@ Result CreateImageFromBitmap(
         }
     }
 
+    ppxres = batch.Submit();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = batch.Wait();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetImage->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppImage = targetImage;
+
+    return ppx::SUCCESS;
+}
+
+Result CreateImageArrayFromMipmaps(
+    grfx::Queue*                      pQueue,
+    const std::vector<const Mipmap*>& layers,
+    grfx::Image**                     ppImage,
+    const ImageOptions&               options)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(ppImage);
+
+    if (layers.empty()) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    for (const Mipmap* pLayer : layers) {
+        PPX_ASSERT_NULL_ARG(pLayer);
+        if (!pLayer->IsOk()) {
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if ((pLayer->GetWidth(0) != layers[0]->GetWidth(0)) || (pLayer->GetHeight(0) != layers[0]->GetHeight(0)) || (pLayer->GetFormat() != layers[0]->GetFormat()) || (pLayer->GetLevelCount() != layers[0]->GetLevelCount())) {
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+    }
+
+    const uint32_t mipLevelCount = layers[0]->GetLevelCount();
+
+    Result ppxres = ppx::ERROR_FAILED;
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    // Create target image
+    grfx::ImagePtr targetImage;
+    {
+        grfx::ImageCreateInfo ci       = {};
+        ci.type                        = grfx::IMAGE_TYPE_2D;
+        ci.width                       = layers[0]->GetWidth(0);
+        ci.height                      = layers[0]->GetHeight(0);
+        ci.depth                       = 1;
+        ci.format                      = ToGrfxFormat(layers[0]->GetFormat());
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = mipLevelCount;
+        ci.arrayLayerCount             = CountU32(layers);
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        ci.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        ci.usageFlags.flags |= options.mAdditionalUsage;
+
+        ppxres = pQueue->GetDevice()->CreateImage(&ci, &targetImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(targetImage);
+    }
+
+    // Copy every layer's mips to image in a single submission
+    uint64_t stagingSize = 0;
+    for (const Mipmap* pLayer : layers) {
+        for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel) {
+            stagingSize += grfx::UploadBatch::CalculateStagingSize(pQueue->GetDevice()->GetApi(), pLayer->GetMip(mipLevel));
+        }
+    }
+
+    grfx::UploadBatch batch(GetUploadQueue(pQueue), stagingSize, pQueue);
+    for (uint32_t arrayLayer = 0; arrayLayer < CountU32(layers); ++arrayLayer) {
+        for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel) {
+            ppxres = batch.AddBitmapUpload(
+                layers[arrayLayer]->GetMip(mipLevel),
+                targetImage,
+                mipLevel,
+                arrayLayer,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+        }
+    }
+
+    ppxres = batch.Submit();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = batch.Wait();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
     // Change ownership to reference so object doesn't get destroyed
     targetImage->SetOwnership(grfx::OWNERSHIP_REFERENCE);
 
@@ -580,6 +787,14 @@ bool IsDDSFile(const std::filesystem::path& path)
     return (std::strstr(path.string().c_str(), ".dds") != nullptr || std::strstr(path.string().c_str(), ".ktx") != nullptr);
 }
 
+struct CompressedLevel
+{
+    uint32_t    width;
+    uint32_t    height;
+    const void* pData;
+    size_t      size;
+};
+
 struct MipLevel
 {
     uint32_t width;
@@ -591,50 +806,24 @@ struct MipLevel
     size_t   offset;
 };
 
-Result CreateImageFromCompressedImage(
-    grfx::Queue*        pQueue,
-    const gli::texture& image,
-    grfx::Image**       ppImage,
-    const ImageOptions& options)
+// Creates an image from the levels of a block compressed (or uncompressed)
+// image, levels[0] is the base level
+static Result CreateImageFromCompressedLevels(
+    grfx::Queue*                        pQueue,
+    grfx::Format                        format,
+    const std::vector<CompressedLevel>& levels,
+    grfx::ImageUsageFlags               additionalUsage,
+    grfx::Image**                       ppImage)
 {
-    Result ppxres;
-
-    PPX_LOG_INFO("Target type: " << grfx::ToString(image.target()) << "\n");
-    PPX_LOG_INFO("Format: " << grfx::ToString(image.format()) << "\n");
-    PPX_LOG_INFO("Swizzles: " << image.swizzles()[0] << ", " << image.swizzles()[1] << ", " << image.swizzles()[2] << ", " << image.swizzles()[3] << "\n");
-    PPX_LOG_INFO("Layer information:\n"
-                 << "\tBase layer: " << image.base_layer() << "\n"
-                 << "\tMax layer: " << image.max_layer() << "\n"
-                 << "\t# of layers: " << image.layers() << "\n");
-    PPX_LOG_INFO("Face information:\n"
-                 << "\tBase face: " << image.base_face() << "\n"
-                 << "\tMax face: " << image.max_face() << "\n"
-                 << "\t# of faces: " << image.faces() << "\n");
-    PPX_LOG_INFO("Level information:\n"
-                 << "\tBase level: " << image.base_level() << "\n"
-                 << "\tMax level: " << image.max_level() << "\n"
-                 << "\t# of levels: " << image.levels() << "\n");
-    PPX_LOG_INFO("Image extents by level:\n");
-    for (gli::texture::size_type level = 0; level < image.levels(); level++) {
-        PPX_LOG_INFO("\textent(level == " << level << "): [" << image.extent(level)[0] << ", " << image.extent(level)[1] << ", " << image.extent(level)[2] << "]\n");
-    }
-    PPX_LOG_INFO("Total image size (bytes): " << image.size() << "\n");
-    PPX_LOG_INFO("Image size by level:\n");
-    for (gli::texture::size_type i = 0; i < image.levels(); i++) {
-        PPX_LOG_INFO("\tsize(level == " << i << "): " << image.size(i) << "\n");
-    }
-    PPX_LOG_INFO("Image data pointer: " << image.data() << "\n");
+    PPX_ASSERT_MSG(!levels.empty(), "No image levels");
 
-    PPX_ASSERT_MSG((image.target() == gli::TARGET_2D), "Expecting a 2D DDS image.");
+    Result ppxres;
 
     // Scoped destroy
     grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
 
-    // Cap mip level count
-    const grfx::Format format           = ToGrfxFormat(image.format());
-    const uint32_t     maxMipLevelCount = std::min<uint32_t>(options.mMipLevelCount, static_cast<uint32_t>(image.levels()));
-    const uint32_t     imageWidth       = static_cast<uint32_t>(image.extent(0)[0]);
-    const uint32_t     imageHeight      = static_cast<uint32_t>(image.extent(0)[1]);
+    const uint32_t imageWidth  = levels[0].width;
+    const uint32_t imageHeight = levels[0].height;
 
     // Row stride and texture offset alignment to handle DX's requirements
     const uint32_t rowStrideAlignment = grfx::IsDx12(pQueue->GetDevice()->GetApi()) ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
@@ -644,8 +833,6 @@ Result CreateImageFromCompressedImage(
 
     // Create staging buffer
     grfx::BufferPtr stagingBuffer;
-    PPX_LOG_INFO("Storage size for image: " << image.size() << " bytes\n");
-    PPX_LOG_INFO("Is image compressed: " << (gli::is_compressed(image.format()) ? "YES" : "NO"));
 
     grfx::BufferCreateInfo ci      = {};
     ci.size                        = 0;
@@ -655,10 +842,10 @@ Result CreateImageFromCompressedImage(
     // Compute each mipmap level size and alignments.
     // This step filters out levels too small to match minimal alignment.
     std::vector<MipLevel> levelSizes;
-    for (gli::texture::size_type level = 0; level < maxMipLevelCount; level++) {
+    for (size_t level = 0; level < levels.size(); level++) {
         MipLevel ls;
-        ls.width  = static_cast<uint32_t>(image.extent(level)[0]);
-        ls.height = static_cast<uint32_t>(image.extent(level)[1]);
+        ls.width  = levels[level].width;
+        ls.height = levels[level].height;
         // Stop when mipmaps are becoming too small to respect the format alignment.
         // The DXT* format documentation says texture sizes must be a multiple of 4.
         // For some reason, tools like imagemagick can generate mipmaps with a size < 4.
@@ -686,7 +873,7 @@ Result CreateImageFromCompressedImage(
         ls.dstRowStride = RoundUp<uint32_t>(ls.srcRowStride, rowStrideAlignment);
 
         ls.offset = ci.size;
-        ci.size += (image.size(level) / ls.srcRowStride) * ls.dstRowStride;
+        ci.size += (levels[level].size / ls.srcRowStride) * ls.dstRowStride;
         ci.size = RoundUp<uint64_t>(ci.size, offsetAlignment);
         levelSizes.emplace_back(std::move(ls));
     }
@@ -709,9 +896,9 @@ Result CreateImageFromCompressedImage(
     for (size_t level = 0; level < mipmapLevelCount; level++) {
         auto& ls = levelSizes[level];
 
-        const char* pSrc = static_cast<const char*>(image.data(0, 0, level));
+        const char* pSrc = static_cast<const char*>(levels[level].pData);
         char*       pDst = static_cast<char*>(pBufferAddress) + ls.offset;
-        for (uint32_t row = 0; row * ls.srcRowStride < image.size(level); row++) {
+        for (uint32_t row = 0; row * ls.srcRowStride < levels[level].size; row++) {
             const char* pSrcRow = pSrc + row * ls.srcRowStride;
             char*       pDstRow = pDst + row * ls.dstRowStride;
             memcpy(pDstRow, pSrcRow, ls.srcRowStride);
@@ -736,7 +923,7 @@ Result CreateImageFromCompressedImage(
         ci.usageFlags.bits.sampled     = true;
         ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
 
-        ci.usageFlags.flags |= options.mAdditionalUsage;
+        ci.usageFlags.flags |= additionalUsage;
 
         ppxres = pQueue->GetDevice()->CreateImage(&ci, &targetImage);
         if (Failed(ppxres)) {
@@ -746,7 +933,7 @@ Result CreateImageFromCompressedImage(
     }
 
     std::vector<grfx::BufferToImageCopyInfo> copyInfos(mipmapLevelCount);
-    for (gli::texture::size_type level = 0; level < mipmapLevelCount; level++) {
+    for (uint32_t level = 0; level < mipmapLevelCount; level++) {
         auto& ls       = levelSizes[level];
         auto& copyInfo = copyInfos[level];
 
@@ -790,28 +977,198 @@ Result CreateImageFromCompressedImage(
     return ppx::SUCCESS;
 }
 
-// -------------------------------------------------------------------------------------------------
 
-Result CreateImageFromFile(
-    grfx::Queue*                 pQueue,
-    const std::filesystem::path& path,
-    grfx::Image**                ppImage,
-    const ImageOptions&          options,
-    bool                         useGpu)
+Result CreateImageFromCompressedImage(
+    grfx::Queue*        pQueue,
+    const gli::texture& image,
+    grfx::Image**       ppImage,
+    const ImageOptions& options)
 {
-    PPX_ASSERT_NULL_ARG(pQueue);
-    PPX_ASSERT_NULL_ARG(ppImage);
-
-    ScopedTimer timer("Image creation from file '" + path.string() + "'");
-
-    Result ppxres;
-    if (Bitmap::IsBitmapFile(path)) {
-        // Load bitmap
-        Bitmap bitmap;
-        ppxres = Bitmap::LoadFile(path, &bitmap);
-        if (Failed(ppxres)) {
-            return ppxres;
-        }
+    PPX_LOG_INFO("Target type: " << grfx::ToString(image.target()) << "\n");
+    PPX_LOG_INFO("Format: " << grfx::ToString(image.format()) << "\n");
+    PPX_LOG_INFO("Swizzles: " << image.swizzles()[0] << ", " << image.swizzles()[1] << ", " << image.swizzles()[2] << ", " << image.swizzles()[3] << "\n");
+    PPX_LOG_INFO("Layer information:\n"
+                 << "\tBase layer: " << image.base_layer() << "\n"
+                 << "\tMax layer: " << image.max_layer() << "\n"
+                 << "\t# of layers: " << image.layers() << "\n");
+    PPX_LOG_INFO("Face information:\n"
+                 << "\tBase face: " << image.base_face() << "\n"
+                 << "\tMax face: " << image.max_face() << "\n"
+                 << "\t# of faces: " << image.faces() << "\n");
+    PPX_LOG_INFO("Level information:\n"
+                 << "\tBase level: " << image.base_level() << "\n"
+                 << "\tMax level: " << image.max_level() << "\n"
+                 << "\t# of levels: " << image.levels() << "\n");
+    PPX_LOG_INFO("Image extents by level:\n");
+    for (gli::texture::size_type level = 0; level < image.levels(); level++) {
+        PPX_LOG_INFO("\textent(level == " << level << "): [" << image.extent(level)[0] << ", " << image.extent(level)[1] << ", " << image.extent(level)[2] << "]\n");
+    }
+    PPX_LOG_INFO("Total image size (bytes): " << image.size() << "\n");
+    PPX_LOG_INFO("Image size by level:\n");
+    for (gli::texture::size_type i = 0; i < image.levels(); i++) {
+        PPX_LOG_INFO("\tsize(level == " << i << "): " << image.size(i) << "\n");
+    }
+    PPX_LOG_INFO("Image data pointer: " << image.data() << "\n");
+
+    PPX_ASSERT_MSG((image.target() == gli::TARGET_2D), "Expecting a 2D DDS image.");
+
+    // Cap mip level count
+    const uint32_t maxMipLevelCount = std::min<uint32_t>(options.mMipLevelCount, static_cast<uint32_t>(image.levels()));
+
+    PPX_LOG_INFO("Storage size for image: " << image.size() << " bytes\n");
+    PPX_LOG_INFO("Is image compressed: " << (gli::is_compressed(image.format()) ? "YES" : "NO"));
+
+    std::vector<CompressedLevel> levels(maxMipLevelCount);
+    for (uint32_t level = 0; level < maxMipLevelCount; level++) {
+        levels[level].width  = static_cast<uint32_t>(image.extent(level)[0]);
+        levels[level].height = static_cast<uint32_t>(image.extent(level)[1]);
+        levels[level].pData  = image.data(0, 0, level);
+        levels[level].size   = image.size(level);
+    }
+
+    return CreateImageFromCompressedLevels(pQueue, ToGrfxFormat(image.format()), levels, options.mAdditionalUsage, ppImage);
+}
+
+Result CreateImageFromKtx2(
+    grfx::Queue*        pQueue,
+    const Ktx2&         image,
+    grfx::Image**       ppImage,
+    const ImageOptions& options)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(ppImage);
+
+    if (!pQueue->GetDevice()->SampledImageFormatSupported(image.GetFormat())) {
+        PPX_LOG_ERROR("KTX2 image format " << grfx::ToString(image.GetFormat()) << " can't be sampled on this device");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    const uint32_t               levelCount = std::min<uint32_t>(options.mMipLevelCount, image.GetLevelCount());
+    std::vector<CompressedLevel> levels(levelCount);
+    for (uint32_t level = 0; level < levelCount; level++) {
+        levels[level].width  = image.GetLevel(level).width;
+        levels[level].height = image.GetLevel(level).height;
+        levels[level].pData  = image.GetLevelData(level);
+        levels[level].size   = image.GetLevel(level).size;
+    }
+
+    return CreateImageFromCompressedLevels(pQueue, image.GetFormat(), levels, options.mAdditionalUsage, ppImage);
+}
+
+Result CompressImage(
+    grfx::Queue*           pQueue,
+    grfx::BlockCompressor* pCompressor,
+    grfx::Image*           pSrcImage,
+    grfx::ResourceState    srcState,
+    grfx::Format           format,
+    grfx::Image**          ppImage)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pCompressor);
+    PPX_ASSERT_NULL_ARG(pSrcImage);
+    PPX_ASSERT_NULL_ARG(ppImage);
+
+    if (!grfx::BlockCompressor::IsFormatSupported(format)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if (!pQueue->GetDevice()->SampledImageFormatSupported(format)) {
+        PPX_LOG_ERROR("Compressed format " << grfx::ToString(format) << " can't be sampled on this device");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::ImagePtr targetImage;
+    {
+        grfx::ImageCreateInfo ci       = {};
+        ci.type                        = pSrcImage->GetType();
+        ci.width                       = pSrcImage->GetWidth();
+        ci.height                      = pSrcImage->GetHeight();
+        ci.depth                       = 1;
+        ci.format                      = format;
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = pSrcImage->GetMipLevelCount();
+        ci.arrayLayerCount             = pSrcImage->GetArrayLayerCount();
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+
+        Result ppxres = pQueue->GetDevice()->CreateImage(&ci, &targetImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(targetImage);
+    }
+
+    grfx::CommandBufferPtr cmd;
+    Result                 ppxres = pQueue->CreateCommandBuffer(&cmd, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(pQueue, cmd);
+
+    ppxres = cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = pCompressor->Record(cmd, pSrcImage, srcState, targetImage, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submit   = {};
+    submit.commandBufferCount = 1;
+    submit.ppCommandBuffers   = &cmd;
+
+    ppxres = pQueue->Submit(&submit);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = pQueue->WaitIdle();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    pCompressor->Reset();
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetImage->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppImage = targetImage;
+
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+Result CreateImageFromFile(
+    grfx::Queue*                 pQueue,
+    const std::filesystem::path& path,
+    grfx::Image**                ppImage,
+    const ImageOptions&          options,
+    bool                         useGpu)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(ppImage);
+
+    ScopedTimer timer("Image creation from file '" + path.string() + "'");
+
+    Result ppxres;
+    if (Bitmap::IsBitmapFile(path)) {
+        // Load bitmap
+        Bitmap bitmap;
+        ppxres = Bitmap::LoadFile(path, &bitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
 
         if (useGpu) {
             ppxres = CreateImageFromBitmapGpu(pQueue, &bitmap, ppImage, options);
@@ -824,6 +1181,14 @@ Result CreateImageFromFile(
             return ppxres;
         }
     }
+    else if (Ktx2::IsKtx2File(path)) {
+        Ktx2 image;
+        ppxres = Ktx2::LoadFile(path, &image);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        ppxres = CreateImageFromKtx2(pQueue, image, ppImage, options);
+    }
     else if (IsDDSFile(path)) {
         // Generate a bitmap out of a DDS
         gli::texture image = gli::load(path.string().c_str());
@@ -840,7 +1205,7 @@ Result CreateImageFromFile(
     if (ppxres != Result::SUCCESS) {
         PPX_LOG_INFO("Failed to create image from image file: " << path);
     }
-    return ppx::SUCCESS;
+    return ppxres;
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -936,14 +1301,19 @@ Result CreateTextureFromBitmap(
         return ppx::ERROR_FAILED;
     }
 
-    // Copy mips to texture
+    // Copy mips to texture in a single submission
+    uint64_t stagingSize = 0;
+    for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel) {
+        stagingSize += grfx::UploadBatch::CalculateStagingSize(pQueue->GetDevice()->GetApi(), mipmap.GetMip(mipLevel));
+    }
+
+    grfx::UploadBatch batch(GetUploadQueue(pQueue), stagingSize, pQueue);
     for (uint32_t mipLevel = 0; mipLevel < mipLevelCount; ++mipLevel) {
         const Bitmap* pMip = mipmap.GetMip(mipLevel);
 
-        ppxres = CopyBitmapToTexture(
-            pQueue,
+        ppxres = batch.AddBitmapUpload(
             pMip,
-            targetTexture,
+            targetTexture->GetImage(),
             mipLevel,
             0,
             options.mInitialState,
@@ -953,6 +1323,16 @@ Result CreateTextureFromBitmap(
         }
     }
 
+    ppxres = batch.Submit();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = batch.Wait();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
     // Change ownership to reference so object doesn't get destroyed
     targetTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
 
@@ -1016,14 +1396,19 @@ Result CreateTextureFromMipmap(
         SCOPED_DESTROYER.AddObject(targetTexture);
     }
 
-    // Copy mips to texture
+    // Copy mips to texture in a single submission
+    uint64_t stagingSize = 0;
+    for (uint32_t mipLevel = 0; mipLevel < pMipmap->GetLevelCount(); ++mipLevel) {
+        stagingSize += grfx::UploadBatch::CalculateStagingSize(pQueue->GetDevice()->GetApi(), pMipmap->GetMip(mipLevel));
+    }
+
+    grfx::UploadBatch batch(GetUploadQueue(pQueue), stagingSize, pQueue);
     for (uint32_t mipLevel = 0; mipLevel < pMipmap->GetLevelCount(); ++mipLevel) {
         const Bitmap* pMip = pMipmap->GetMip(mipLevel);
 
-        ppxres = CopyBitmapToTexture(
-            pQueue,
+        ppxres = batch.AddBitmapUpload(
             pMip,
-            targetTexture,
+            targetTexture->GetImage(),
             mipLevel,
             0,
             options.mInitialState,
@@ -1033,6 +1418,16 @@ Result CreateTextureFromMipmap(
         }
     }
 
+    ppxres = batch.Submit();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = batch.Wait();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
     // Change ownership to reference so object doesn't get destroyed
     targetTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
 
@@ -1169,6 +1564,20 @@ Result CreateIBLTexturesFromFile(
         return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
     }
 
+    // Load IBL environment map - this is stored as a bitmap on disk. It's
+    // much larger than the irradiance map, decode it on a worker while the
+    // irradiance texture is created.
+    std::filesystem::path envFilePath = path.parent_path() / envFile;
+    Mipmap                mipmap      = {};
+    Result                envResult   = ppx::ERROR_FAILED;
+    JobCounter            envCounter;
+
+    JobSystem::Job loadEnvironment = [&]() {
+        ScopedTimer timer("Mipmap load from file '" + envFilePath.string() + "'");
+        envResult = Mipmap::LoadFile(envFilePath, baseWidth, baseHeight, &mipmap, levelCount);
+    };
+    JobSystem::Get()->Run(std::move(loadEnvironment), &envCounter);
+
     // Create irradiance texture - does not require mip maps
     std::filesystem::path irrFilePath = path.parent_path() / irrFile;
     Result                ppxres;
@@ -1176,130 +1585,688 @@ Result CreateIBLTexturesFromFile(
         ScopedTimer timer("Texture creation from file '" + irrFilePath.string() + "'");
         ppxres = CreateTextureFromFile(pQueue, irrFilePath, ppIrradianceTexture);
     }
+    JobSystem::Get()->Wait(&envCounter);
     if (Failed(ppxres)) {
         return ppxres;
     }
-
-    // Load IBL environment map - this is stored as a bitmap on disk
-    std::filesystem::path envFilePath = path.parent_path() / envFile;
-    ScopedTimer           timer("Texture creation from mipmap file '" + envFilePath.string() + "'");
-    Mipmap                mipmap = {};
-    ppxres                       = Mipmap::LoadFile(envFilePath, baseWidth, baseHeight, &mipmap, levelCount);
-    if (Failed(ppxres)) {
-        return ppxres;
+    if (Failed(envResult)) {
+        return envResult;
     }
 
     // Create environment texture
+    ScopedTimer timer("Texture creation from mipmap '" + envFilePath.string() + "'");
     return CreateTextureFromMipmap(pQueue, &mipmap, ppEnvironmentTexture);
 }
 
 // -------------------------------------------------------------------------------------------------
 
-Result CreateCubeMapFromFile(
-    grfx::Queue*                 pQueue,
-    const std::filesystem::path& path,
-    const CubeMapCreateInfo*     pCreateInfo,
-    grfx::Image**                ppImage,
-    const grfx::ImageUsageFlags& additionalImageUsage)
+namespace {
+
+// Bump when the layout of the file or the generated data changes
+constexpr uint32_t     kIBLCacheMagic   = 0x49585050; // 'PPXI'
+constexpr uint32_t     kIBLCacheVersion = 1;
+constexpr XXH64_hash_t kIBLCacheSeed    = 0x2f6a41c8d3e5b907;
+
+struct IBLCacheHeader
 {
-    PPX_ASSERT_NULL_ARG(pQueue);
-    PPX_ASSERT_NULL_ARG(ppImage);
-    ScopedTimer timer("Cubemap creation from file '" + path.string() + "'");
+    uint32_t magic      = kIBLCacheMagic;
+    uint32_t version    = kIBLCacheVersion;
+    uint64_t key        = 0;
+    uint32_t imageCount = 0;
+    uint32_t reserved   = 0;
+};
 
-    // Load bitmap
-    Bitmap bitmap;
-    Result ppxres = Bitmap::LoadFile(path, &bitmap);
-    if (Failed(ppxres)) {
-        return ppxres;
+struct IBLCacheImage
+{
+    uint32_t width      = 0;
+    uint32_t height     = 0;
+    uint32_t levelCount = 0;
+    uint32_t reserved   = 0;
+};
+
+// Everything the generated texels depend on besides the source image
+struct IBLCacheKeyData
+{
+    uint64_t sourceHash           = 0;
+    uint32_t width                = 0;
+    uint32_t levelCount           = 0;
+    uint32_t irradianceWidth      = 0;
+    uint32_t shSampleWidth        = 0;
+    uint32_t prefilterSampleCount = 0;
+    uint32_t brdfLUTSampleCount   = 0;
+};
+
+std::filesystem::path IBLCachePath(const std::filesystem::path& cacheDirectory, const char* prefix, uint64_t key)
+{
+    std::stringstream ss;
+    ss << prefix << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return cacheDirectory / ss.str();
+}
+
+// Reads RGBA float images, levels are stored tightly packed
+Result LoadIBLCache(const std::filesystem::path& path, uint64_t key, std::vector<Mipmap>* pImages)
+{
+    if (!fs::path_exists(path)) {
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
     }
 
-    // Scoped destroy
-    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+    fs::File file;
+    if (!file.Open(path)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
 
-    // Create staging buffer
-    grfx::BufferPtr stagingBuffer;
-    {
-        uint64_t bitmapFootprintSize = bitmap.GetFootprintSize();
+    IBLCacheHeader header = {};
+    if (file.Read(&header, sizeof(header)) != sizeof(header)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+    if ((header.magic != kIBLCacheMagic) || (header.version != kIBLCacheVersion) || (header.key != key)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
 
-        grfx::BufferCreateInfo ci      = {};
-        ci.size                        = bitmapFootprintSize;
-        ci.usageFlags.bits.transferSrc = true;
-        ci.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+    std::vector<IBLCacheImage> images(header.imageCount);
+    if (file.Read(images.data(), images.size() * sizeof(IBLCacheImage)) != (images.size() * sizeof(IBLCacheImage))) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
 
-        ppxres = pQueue->GetDevice()->CreateBuffer(&ci, &stagingBuffer);
-        if (Failed(ppxres)) {
-            return ppxres;
+    pImages->clear();
+    pImages->reserve(images.size());
+    for (const IBLCacheImage& image : images) {
+        if ((image.width == 0) || (image.height == 0) || (image.levelCount == 0) || (image.levelCount > Mipmap::CalculateLevelCount(image.width, image.height))) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
         }
-        SCOPED_DESTROYER.AddObject(stagingBuffer);
 
-        // Map and copy to staging buffer
-        void* pBufferAddress = nullptr;
-        ppxres               = stagingBuffer->MapMemory(0, &pBufferAddress);
-        if (Failed(ppxres)) {
-            return ppxres;
+        Mipmap& mipmap = pImages->emplace_back(image.width, image.height, Bitmap::FORMAT_RGBA_FLOAT, image.levelCount);
+        if (!mipmap.IsOk()) {
+            return ppx::ERROR_ALLOCATION_FAILED;
+        }
+
+        for (uint32_t level = 0; level < image.levelCount; ++level) {
+            Bitmap*      pMip    = mipmap.GetMip(level);
+            const size_t rowSize = pMip->GetWidth() * pMip->GetPixelStride();
+            for (uint32_t y = 0; y < pMip->GetHeight(); ++y) {
+                if (file.Read(pMip->GetPixelAddress(0, y), rowSize) != rowSize) {
+                    return ppx::ERROR_BAD_DATA_SOURCE;
+                }
+            }
         }
-        std::memcpy(pBufferAddress, bitmap.GetData(), bitmapFootprintSize);
-        stagingBuffer->UnmapMemory();
     }
 
-    // Target format
-    grfx::Format targetFormat = grfx::FORMAT_R8G8B8A8_UNORM;
+    return ppx::SUCCESS;
+}
 
-    PPX_ASSERT_MSG(bitmap.GetWidth() * 3 == bitmap.GetHeight() * 4, "cubemap texture dimension must be a multiple of 4x3");
-    // Calculate subImage to use for target image dimensions
-    SubImage tmpSubImage = CalcSubimageCrossHorizontalLeft(0, bitmap.GetWidth(), bitmap.GetHeight(), targetFormat);
+Result SaveIBLCache(const std::filesystem::path& path, uint64_t key, const std::vector<const Mipmap*>& images)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
 
-    PPX_ASSERT_MSG(tmpSubImage.width == tmpSubImage.height, "cubemap face width != height");
-    // Create target image
-    grfx::ImagePtr targetImage;
-    {
-        grfx::ImageCreateInfo ci       = {};
-        ci.type                        = grfx::IMAGE_TYPE_CUBE;
-        ci.width                       = tmpSubImage.width;
-        ci.height                      = tmpSubImage.height;
-        ci.depth                       = 1;
-        ci.format                      = targetFormat;
-        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
-        ci.mipLevelCount               = 1;
-        ci.arrayLayerCount             = 6;
-        ci.usageFlags.bits.transferDst = true;
-        ci.usageFlags.bits.sampled     = true;
-        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+    // Written next to the final path and renamed, so a crash never leaves a truncated cache behind
+    std::filesystem::path tempPath = path;
+    tempPath += ".tmp";
 
-        ci.usageFlags.flags |= additionalImageUsage.flags;
+    std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
 
-        ppxres = pQueue->GetDevice()->CreateImage(&ci, &targetImage);
-        if (Failed(ppxres)) {
-            return ppxres;
+    IBLCacheHeader header = {};
+    header.key            = key;
+    header.imageCount     = CountU32(images);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const Mipmap* pMipmap : images) {
+        IBLCacheImage image = {};
+        image.width         = pMipmap->GetWidth(0);
+        image.height        = pMipmap->GetHeight(0);
+        image.levelCount    = pMipmap->GetLevelCount();
+        stream.write(reinterpret_cast<const char*>(&image), sizeof(image));
+    }
+
+    for (const Mipmap* pMipmap : images) {
+        for (uint32_t level = 0; level < pMipmap->GetLevelCount(); ++level) {
+            const Bitmap* pMip    = pMipmap->GetMip(level);
+            const size_t  rowSize = pMip->GetWidth() * pMip->GetPixelStride();
+            for (uint32_t y = 0; y < pMip->GetHeight(); ++y) {
+                stream.write(pMip->GetPixelAddress(0, y), rowSize);
+            }
         }
-        SCOPED_DESTROYER.AddObject(targetImage);
     }
 
-    // Copy to GPU image
-    //
-    {
-        uint32_t faces[6] = {
-            pCreateInfo->posX,
-            pCreateInfo->negX,
-            pCreateInfo->posY,
-            pCreateInfo->negY,
-            pCreateInfo->posZ,
-            pCreateInfo->negZ,
-        };
+    stream.close();
+    if (!stream) {
+        std::filesystem::remove(tempPath, ec);
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
 
-        std::vector<grfx::BufferToImageCopyInfo> copyInfos(6);
-        for (uint32_t arrayLayer = 0; arrayLayer < 6; ++arrayLayer) {
-            uint32_t subImageIndex = faces[arrayLayer];
-            SubImage subImage      = CalcSubimageCrossHorizontalLeft(subImageIndex, bitmap.GetWidth(), bitmap.GetHeight(), targetFormat);
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
 
+    return ppx::SUCCESS;
+}
+
+// Sampled RGBA float texture the generator can write and the cache can read back
+Result CreateIBLTargetTexture(grfx::Queue* pQueue, uint32_t width, uint32_t height, uint32_t levelCount, grfx::Texture** ppTexture)
+{
+    grfx::TextureCreateInfo ci     = {};
+    ci.imageType                   = grfx::IMAGE_TYPE_2D;
+    ci.width                       = width;
+    ci.height                      = height;
+    ci.depth                       = 1;
+    ci.imageFormat                 = grfx::FORMAT_R32G32B32A32_FLOAT;
+    ci.mipLevelCount               = levelCount;
+    ci.usageFlags.bits.sampled     = true;
+    ci.usageFlags.bits.storage     = true;
+    ci.usageFlags.bits.transferSrc = true;
+    ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+    ci.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+    return pQueue->GetDevice()->CreateTexture(&ci, ppTexture);
+}
+
+// Records with recordFn, submits and waits for the work to complete
+template <typename RecordFn>
+Result SubmitAndWait(grfx::Queue* pQueue, RecordFn recordFn)
+{
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::CommandBufferPtr cmd;
+    Result                 ppxres = pQueue->CreateCommandBuffer(&cmd, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(pQueue, cmd);
+
+    ppxres = cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = recordFn(cmd.Get());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submit   = {};
+    submit.commandBufferCount = 1;
+    submit.ppCommandBuffers   = &cmd;
+
+    ppxres = pQueue->Submit(&submit);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return pQueue->WaitIdle();
+}
+
+// Copies every level of a texture written by CreateIBLTargetTexture() to
+// pMipmap, which must have the texture's size and level count
+Result ReadbackIBLTexture(grfx::Queue* pQueue, grfx::Texture* pTexture, Mipmap* pMipmap)
+{
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::Image*   pImage     = pTexture->GetImage();
+    const uint32_t levelCount = pImage->GetMipLevelCount();
+    if (!pMipmap->IsOk() || (pMipmap->GetLevelCount() != levelCount) || (pMipmap->GetWidth(0) != pImage->GetWidth()) || (pMipmap->GetHeight(0) != pImage->GetHeight())) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    // One buffer per level, copies can't target an offset into a buffer.
+    // Rows are padded to the 256 byte pitch D3D12 requires.
+    std::vector<grfx::BufferPtr> buffers(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const uint32_t width  = std::max<uint32_t>(pImage->GetWidth() >> level, 1);
+        const uint32_t height = std::max<uint32_t>(pImage->GetHeight() >> level, 1);
+
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = static_cast<uint64_t>(((width * 16) + 255) & ~255u) * height;
+        bufferCreateInfo.usageFlags.bits.transferDst = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+
+        Result ppxres = pQueue->GetDevice()->CreateBuffer(&bufferCreateInfo, &buffers[level]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(buffers[level]);
+    }
+
+    std::vector<uint32_t> rowPitches(levelCount);
+
+    Result ppxres = SubmitAndWait(pQueue, [&](grfx::CommandBuffer* pCmd) {
+        pCmd->TransitionImageLayout(pImage, 0, levelCount, 0, 1, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_COPY_SRC);
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            grfx::ImageToBufferCopyInfo copyInfo = {};
+            copyInfo.srcImage.mipLevel           = level;
+            copyInfo.extent                      = {std::max<uint32_t>(pImage->GetWidth() >> level, 1), std::max<uint32_t>(pImage->GetHeight() >> level, 1), 0};
+            rowPitches[level]                    = pCmd->CopyImageToBuffer(&copyInfo, pImage, buffers[level]).rowPitch;
+        }
+        pCmd->TransitionImageLayout(pImage, 0, levelCount, 0, 1, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        return ppx::SUCCESS;
+    });
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        Bitmap* pMip = pMipmap->GetMip(level);
+
+        const char* pTexels = nullptr;
+        ppxres              = buffers[level]->MapMemory(0, (void**)&pTexels);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        for (uint32_t y = 0; y < pMip->GetHeight(); ++y) {
+            std::memcpy(pMip->GetPixelAddress(0, y), pTexels + static_cast<size_t>(y) * rowPitches[level], pMip->GetWidth() * pMip->GetPixelStride());
+        }
+        buffers[level]->UnmapMemory();
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace
+
+Result CreateIBLTexturesFromHDR(
+    grfx::Queue*                 pQueue,
+    grfx::IBLGenerator*          pGenerator,
+    const std::filesystem::path& path,
+    const std::filesystem::path& cacheDirectory,
+    grfx::Texture**              ppIrradianceTexture,
+    grfx::Texture**              ppEnvironmentTexture,
+    const IBLTextureOptions&     options)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pGenerator);
+    PPX_ASSERT_NULL_ARG(ppIrradianceTexture);
+    PPX_ASSERT_NULL_ARG(ppEnvironmentTexture);
+
+    if ((options.irradianceWidth < 2) || (options.environmentWidth < 2)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    auto fileBytes = ppx::fs::load_file(path);
+    if (!fileBytes.has_value()) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    Bitmap source;
+    Result ppxres = Bitmap::LoadFromMemory(fileBytes.value().size(), fileBytes.value().data(), &source);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    if (source.GetFormat() != Bitmap::FORMAT_RGBA_FLOAT) {
+        Bitmap converted;
+        ppxres = source.ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, &converted);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        source = converted;
+    }
+
+    // Levels below 4 texels high carry no directional information
+    const uint32_t envWidth      = std::min(options.environmentWidth, source.GetWidth());
+    const uint32_t envHeight     = std::max<uint32_t>(envWidth / 2, 1);
+    const uint32_t maxLevelCount = Mipmap::CalculateLevelCount(envWidth, envHeight);
+    uint32_t       levelCount    = (maxLevelCount > 2) ? (maxLevelCount - 2) : 1;
+    if (options.environmentLevelCount > 0) {
+        levelCount = std::min(options.environmentLevelCount, maxLevelCount);
+    }
+
+    IBLCacheKeyData keyData      = {};
+    keyData.sourceHash           = XXH64(fileBytes.value().data(), fileBytes.value().size(), kIBLCacheSeed);
+    keyData.width                = envWidth;
+    keyData.levelCount           = levelCount;
+    keyData.irradianceWidth      = options.irradianceWidth;
+    keyData.shSampleWidth        = options.generatorParams.shSampleWidth;
+    keyData.prefilterSampleCount = options.generatorParams.prefilterSampleCount;
+    const uint64_t key           = XXH64(&keyData, sizeof(keyData), kIBLCacheSeed);
+
+    const std::filesystem::path cachePath = cacheDirectory.empty() ? std::filesystem::path() : IBLCachePath(cacheDirectory, "ibl_", key);
+    if (!cachePath.empty()) {
+        std::vector<Mipmap> images;
+        ppxres = LoadIBLCache(cachePath, key, &images);
+        if (Success(ppxres) && (images.size() == 2)) {
+            ScopedTimer timer("IBL texture creation from cache '" + cachePath.string() + "'");
+            ppxres = CreateTextureFromMipmap(pQueue, &images[0], ppIrradianceTexture);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            return CreateTextureFromMipmap(pQueue, &images[1], ppEnvironmentTexture);
+        }
+        if (ppxres != ppx::ERROR_PATH_DOES_NOT_EXIST) {
+            PPX_LOG_WARN("IBL cache '" << cachePath << "' is invalid, regenerating it");
+        }
+    }
+
+    ScopedTimer timer("IBL texture generation from '" + path.string() + "'");
+
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    // The prefilter reads the source's mips
+    grfx::TexturePtr sourceTexture;
+    ppxres = CreateTextureFromBitmap(pQueue, &source, &sourceTexture, TextureOptions().MipLevelCount(PPX_REMAINING_MIP_LEVELS));
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(sourceTexture);
+
+    grfx::TexturePtr irradianceTexture;
+    ppxres = CreateIBLTargetTexture(pQueue, options.irradianceWidth, options.irradianceWidth / 2, 1, &irradianceTexture);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(irradianceTexture);
+
+    grfx::TexturePtr environmentTexture;
+    ppxres = CreateIBLTargetTexture(pQueue, envWidth, envHeight, levelCount, &environmentTexture);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(environmentTexture);
+
+    ppxres = SubmitAndWait(pQueue, [&](grfx::CommandBuffer* pCmd) {
+        return pGenerator->RecordEnvironment(
+            pCmd,
+            options.generatorParams,
+            sourceTexture->GetImage(),
+            grfx::RESOURCE_STATE_SHADER_RESOURCE,
+            irradianceTexture->GetImage(),
+            environmentTexture->GetImage(),
+            grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    });
+    pGenerator->Reset();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // A failed save only costs the next run another generation
+    if (!cachePath.empty()) {
+        Mipmap irradiance(options.irradianceWidth, options.irradianceWidth / 2, Bitmap::FORMAT_RGBA_FLOAT, 1);
+        Mipmap environment(envWidth, envHeight, Bitmap::FORMAT_RGBA_FLOAT, levelCount);
+        ppxres = ReadbackIBLTexture(pQueue, irradianceTexture, &irradiance);
+        if (Success(ppxres)) {
+            ppxres = ReadbackIBLTexture(pQueue, environmentTexture, &environment);
+        }
+        if (Success(ppxres)) {
+            ppxres = SaveIBLCache(cachePath, key, {&irradiance, &environment});
+        }
+        if (Failed(ppxres)) {
+            PPX_LOG_WARN("Failed to write IBL cache '" << cachePath << "': " << ToString(ppxres));
+        }
+    }
+
+    // Change ownership to reference so the textures don't get destroyed
+    irradianceTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+    environmentTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    *ppIrradianceTexture  = irradianceTexture;
+    *ppEnvironmentTexture = environmentTexture;
+
+    return ppx::SUCCESS;
+}
+
+Result CreateBRDFLUTTexture(
+    grfx::Queue*                 pQueue,
+    grfx::IBLGenerator*          pGenerator,
+    const std::filesystem::path& cacheDirectory,
+    grfx::Texture**              ppLUTTexture,
+    const IBLTextureOptions&     options)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pGenerator);
+    PPX_ASSERT_NULL_ARG(ppLUTTexture);
+
+    if (options.brdfLUTSize == 0) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    IBLCacheKeyData keyData    = {};
+    keyData.width              = options.brdfLUTSize;
+    keyData.brdfLUTSampleCount = options.generatorParams.brdfLUTSampleCount;
+    const uint64_t key         = XXH64(&keyData, sizeof(keyData), kIBLCacheSeed);
+
+    const std::filesystem::path cachePath = cacheDirectory.empty() ? std::filesystem::path() : IBLCachePath(cacheDirectory, "brdf_lut_", key);
+    if (!cachePath.empty()) {
+        std::vector<Mipmap> images;
+        Result              ppxres = LoadIBLCache(cachePath, key, &images);
+        if (Success(ppxres) && (images.size() == 1)) {
+            return CreateTextureFromMipmap(pQueue, &images[0], ppLUTTexture);
+        }
+        if (ppxres != ppx::ERROR_PATH_DOES_NOT_EXIST) {
+            PPX_LOG_WARN("BRDF LUT cache '" << cachePath << "' is invalid, regenerating it");
+        }
+    }
+
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::TexturePtr lutTexture;
+    Result           ppxres = CreateIBLTargetTexture(pQueue, options.brdfLUTSize, options.brdfLUTSize, 1, &lutTexture);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(lutTexture);
+
+    ppxres = SubmitAndWait(pQueue, [&](grfx::CommandBuffer* pCmd) {
+        return pGenerator->RecordBRDFLUT(pCmd, options.generatorParams, lutTexture->GetImage(), grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    });
+    pGenerator->Reset();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    if (!cachePath.empty()) {
+        Mipmap lut(options.brdfLUTSize, options.brdfLUTSize, Bitmap::FORMAT_RGBA_FLOAT, 1);
+        ppxres = ReadbackIBLTexture(pQueue, lutTexture, &lut);
+        if (Success(ppxres)) {
+            ppxres = SaveIBLCache(cachePath, key, {&lut});
+        }
+        if (Failed(ppxres)) {
+            PPX_LOG_WARN("Failed to write BRDF LUT cache '" << cachePath << "': " << ToString(ppxres));
+        }
+    }
+
+    lutTexture->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+    *ppLUTTexture = lutTexture;
+
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+// Uploads the first level of every layer of pImage and generates the other
+// levels in the same command buffer
+static Result CopyAndGenerateMips(
+    grfx::Queue*                                    pQueue,
+    grfx::MipGenerator*                             pMipGenerator,
+    const std::vector<grfx::BufferToImageCopyInfo>& copyInfos,
+    grfx::Buffer*                                   pSrcBuffer,
+    grfx::Image*                                    pImage)
+{
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::CommandBufferPtr cmd;
+    Result                 ppxres = pQueue->CreateCommandBuffer(&cmd, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(pQueue, cmd);
+
+    ppxres = cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    cmd->TransitionImageLayout(pImage, 0, 1, 0, pImage->GetArrayLayerCount(), grfx::RESOURCE_STATE_UNDEFINED, grfx::RESOURCE_STATE_COPY_DST);
+    cmd->CopyBufferToImage(copyInfos, pSrcBuffer, pImage);
+
+    ppxres = pMipGenerator->Record(cmd, pImage, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submit   = {};
+    submit.commandBufferCount = 1;
+    submit.ppCommandBuffers   = &cmd;
+
+    ppxres = pQueue->Submit(&submit);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = pQueue->WaitIdle();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    pMipGenerator->Reset();
+
+    return ppx::SUCCESS;
+}
+
+Result CreateCubeMapFromFile(
+    grfx::Queue*                 pQueue,
+    const std::filesystem::path& path,
+    const CubeMapCreateInfo*     pCreateInfo,
+    grfx::Image**                ppImage,
+    const grfx::ImageUsageFlags& additionalImageUsage)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(ppImage);
+    ScopedTimer timer("Cubemap creation from file '" + path.string() + "'");
+
+    // Load bitmap
+    Bitmap bitmap;
+    Result ppxres = Bitmap::LoadFile(path, &bitmap);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    // Target format
+    grfx::Format   targetFormat  = grfx::FORMAT_R8G8B8A8_UNORM;
+    const uint32_t bytesPerTexel = grfx::GetFormatDescription(targetFormat)->bytesPerTexel;
+
+    PPX_ASSERT_MSG(bitmap.GetWidth() * 3 == bitmap.GetHeight() * 4, "cubemap texture dimension must be a multiple of 4x3");
+    PPX_ASSERT_MSG(bitmap.GetPixelStride() == bytesPerTexel, "cubemap bitmap format doesn't match the target format");
+    PPX_ASSERT_MSG(bitmap.GetRowStride() == bitmap.GetWidth() * bytesPerTexel, "cubemap bitmap rows must be tightly packed");
+    // Calculate subImage to use for target image dimensions
+    SubImage tmpSubImage = CalcSubimageCrossHorizontalLeft(0, bitmap.GetWidth(), bitmap.GetHeight(), targetFormat);
+
+    PPX_ASSERT_MSG(tmpSubImage.width == tmpSubImage.height, "cubemap face width != height");
+    const uint32_t faceSize = tmpSubImage.width;
+
+    uint32_t faces[6] = {
+        pCreateInfo->posX,
+        pCreateInfo->negX,
+        pCreateInfo->posY,
+        pCreateInfo->negY,
+        pCreateInfo->posZ,
+        pCreateInfo->negZ,
+    };
+
+    // The staging buffer only holds the six faces, half of the cross, each
+    // aligned for DX's requirements
+    const bool     isDx12         = grfx::IsDx12(pQueue->GetDevice()->GetApi());
+    const uint32_t faceRowBytes   = faceSize * bytesPerTexel;
+    const uint32_t faceRowStride  = RoundUp<uint32_t>(faceRowBytes, isDx12 ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1);
+    const uint64_t faceByteStride = RoundUp<uint64_t>(static_cast<uint64_t>(faceRowStride) * faceSize, isDx12 ? PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT : 1);
+
+    // Create staging buffer
+    grfx::BufferPtr stagingBuffer;
+    {
+        grfx::BufferCreateInfo ci      = {};
+        ci.size                        = 6 * faceByteStride;
+        ci.usageFlags.bits.transferSrc = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        ppxres = pQueue->GetDevice()->CreateBuffer(&ci, &stagingBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(stagingBuffer);
+
+        // Map and extract the faces to the staging buffer, the rows of all
+        // faces are copied in parallel
+        void* pBufferAddress = nullptr;
+        ppxres               = stagingBuffer->MapMemory(0, &pBufferAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        const char* pFaceSrc[6] = {};
+        for (uint32_t arrayLayer = 0; arrayLayer < 6; ++arrayLayer) {
+            SubImage subImage    = CalcSubimageCrossHorizontalLeft(faces[arrayLayer], bitmap.GetWidth(), bitmap.GetHeight(), targetFormat);
+            pFaceSrc[arrayLayer] = bitmap.GetData() + subImage.bufferOffset;
+        }
+
+        const uint32_t grainSize = std::max<uint32_t>(1, (256 * 1024) / faceRowBytes);
+        JobSystem::Get()->ParallelFor(6 * faceSize, grainSize, [&](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                const uint32_t arrayLayer = i / faceSize;
+                const uint32_t row        = i % faceSize;
+
+                const char* pSrc = pFaceSrc[arrayLayer] + static_cast<uint64_t>(row) * bitmap.GetRowStride();
+                char*       pDst = static_cast<char*>(pBufferAddress) + arrayLayer * faceByteStride + static_cast<uint64_t>(row) * faceRowStride;
+                std::memcpy(pDst, pSrc, faceRowBytes);
+            }
+        });
+        stagingBuffer->UnmapMemory();
+    }
+
+    grfx::MipGenerator* pMipGenerator = pCreateInfo->pMipGenerator;
+    const uint32_t      mipLevelCount = IsNull(pMipGenerator) ? 1 : Mipmap::CalculateLevelCount(faceSize, faceSize);
+
+    // Create target image
+    grfx::ImagePtr targetImage;
+    {
+        grfx::ImageCreateInfo ci       = {};
+        ci.type                        = grfx::IMAGE_TYPE_CUBE;
+        ci.width                       = faceSize;
+        ci.height                      = faceSize;
+        ci.depth                       = 1;
+        ci.format                      = targetFormat;
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = mipLevelCount;
+        ci.arrayLayerCount             = 6;
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.usageFlags.bits.storage     = !IsNull(pMipGenerator);
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+
+        ci.usageFlags.flags |= additionalImageUsage.flags;
+
+        ppxres = pQueue->GetDevice()->CreateImage(&ci, &targetImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(targetImage);
+    }
+
+    // Copy to GPU image
+    //
+    {
+        std::vector<grfx::BufferToImageCopyInfo> copyInfos(6);
+        for (uint32_t arrayLayer = 0; arrayLayer < 6; ++arrayLayer) {
             // Copy info
             grfx::BufferToImageCopyInfo& copyInfo = copyInfos[arrayLayer];
-            copyInfo.srcBuffer.imageWidth         = bitmap.GetWidth();
-            copyInfo.srcBuffer.imageHeight        = bitmap.GetHeight();
-            copyInfo.srcBuffer.imageRowStride     = bitmap.GetRowStride();
-            copyInfo.srcBuffer.footprintOffset    = subImage.bufferOffset;
-            copyInfo.srcBuffer.footprintWidth     = subImage.width;
-            copyInfo.srcBuffer.footprintHeight    = subImage.height;
+            copyInfo.srcBuffer.imageWidth         = faceSize;
+            copyInfo.srcBuffer.imageHeight        = faceSize;
+            copyInfo.srcBuffer.imageRowStride     = faceRowStride;
+            copyInfo.srcBuffer.footprintOffset    = arrayLayer * faceByteStride;
+            copyInfo.srcBuffer.footprintWidth     = faceSize;
+            copyInfo.srcBuffer.footprintHeight    = faceSize;
             copyInfo.srcBuffer.footprintDepth     = 1;
             copyInfo.dstImage.mipLevel            = 0;
             copyInfo.dstImage.arrayLayer          = arrayLayer;
@@ -1307,20 +2274,29 @@ Result CreateCubeMapFromFile(
             copyInfo.dstImage.x                   = 0;
             copyInfo.dstImage.y                   = 0;
             copyInfo.dstImage.z                   = 0;
-            copyInfo.dstImage.width               = subImage.width;
-            copyInfo.dstImage.height              = subImage.height;
+            copyInfo.dstImage.width               = faceSize;
+            copyInfo.dstImage.height              = faceSize;
             copyInfo.dstImage.depth               = 1;
         }
 
-        ppxres = pQueue->CopyBufferToImage(
-            copyInfos,
-            stagingBuffer,
-            targetImage,
-            PPX_ALL_SUBRESOURCES,
-            grfx::RESOURCE_STATE_UNDEFINED,
-            grfx::RESOURCE_STATE_SHADER_RESOURCE);
-        if (Failed(ppxres)) {
-            return ppxres;
+        // All faces, and the mips if generated, are recorded in one submission
+        if (IsNull(pMipGenerator)) {
+            ppxres = pQueue->CopyBufferToImage(
+                copyInfos,
+                stagingBuffer,
+                targetImage,
+                PPX_ALL_SUBRESOURCES,
+                grfx::RESOURCE_STATE_UNDEFINED,
+                grfx::RESOURCE_STATE_SHADER_RESOURCE);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+        }
+        else {
+            ppxres = CopyAndGenerateMips(pQueue, pMipGenerator, copyInfos, stagingBuffer, targetImage);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
         }
     }
 
@@ -1336,9 +2312,12 @@ Result CreateCubeMapFromFile(
 // -------------------------------------------------------------------------------------------------
 
 Result CreateMeshFromGeometry(
-    grfx::Queue*    pQueue,
-    const Geometry* pGeometry,
-    grfx::Mesh**    ppMesh)
+    grfx::Queue*      pQueue,
+    const Geometry*   pGeometry,
+    grfx::Mesh**      ppMesh,
+    grfx::BufferPool* pBufferPool,
+    bool              accelerationStructureInput,
+    bool              storageBuffers)
 {
     PPX_ASSERT_NULL_ARG(pQueue);
     PPX_ASSERT_NULL_ARG(pGeometry);
@@ -1366,7 +2345,10 @@ Result CreateMeshFromGeometry(
     // Create target mesh
     grfx::MeshPtr targetMesh;
     {
-        grfx::MeshCreateInfo ci = grfx::MeshCreateInfo(*pGeometry);
+        grfx::MeshCreateInfo ci       = grfx::MeshCreateInfo(*pGeometry);
+        ci.pBufferPool                = pBufferPool;
+        ci.accelerationStructureInput = accelerationStructureInput;
+        ci.storageBuffers             = storageBuffers;
 
         Result ppxres = pQueue->GetDevice()->CreateMesh(&ci, &targetMesh);
         if (Failed(ppxres)) {
@@ -1392,7 +2374,8 @@ Result CreateMeshFromGeometry(
                 return ppxres;
             }
 
-            copyInfo.size = geoBufferSize;
+            copyInfo.size             = geoBufferSize;
+            copyInfo.dstBuffer.offset = static_cast<uint32_t>(targetMesh->GetIndexBufferOffset());
 
             // Copy to GPU buffer
             ppxres = pQueue->CopyBufferToBuffer(&copyInfo, stagingBuffer, targetMesh->GetIndexBuffer(), grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_INDEX_BUFFER);
@@ -1414,7 +2397,8 @@ Result CreateMeshFromGeometry(
                 return ppxres;
             }
 
-            copyInfo.size = geoBufferSize;
+            copyInfo.size             = geoBufferSize;
+            copyInfo.dstBuffer.offset = static_cast<uint32_t>(targetMesh->GetVertexBufferOffset(i));
 
             grfx::BufferPtr targetBuffer = targetMesh->GetVertexBuffer(i);
 
@@ -1438,9 +2422,12 @@ Result CreateMeshFromGeometry(
 // -------------------------------------------------------------------------------------------------
 
 Result CreateMeshFromTriMesh(
-    grfx::Queue*   pQueue,
-    const TriMesh* pTriMesh,
-    grfx::Mesh**   ppMesh)
+    grfx::Queue*            pQueue,
+    const TriMesh*          pTriMesh,
+    grfx::Mesh**            ppMesh,
+    grfx::BufferPool*       pBufferPool,
+    bool                    accelerationStructureInput,
+    const MeshIndexOptions& indexOptions)
 {
     PPX_ASSERT_NULL_ARG(pQueue);
     PPX_ASSERT_NULL_ARG(pTriMesh);
@@ -1454,11 +2441,148 @@ Result CreateMeshFromTriMesh(
         return ppxres;
     }
 
-    ppxres = CreateMeshFromGeometry(pQueue, &geo, ppMesh);
+    // Halves the index bandwidth of meshes with fewer than 64k vertices
+    if (indexOptions.compact && IsNull(pBufferPool)) {
+        geo.CompactIndices();
+    }
+    // LOD ranges index the triangle list
+    if (indexOptions.triangleStrips && !accelerationStructureInput && (pTriMesh->GetLodCount() == 1)) {
+        geo.ConvertToTriangleStrips();
+    }
+
+    ppxres = CreateMeshFromGeometry(pQueue, &geo, ppMesh, pBufferPool, accelerationStructureInput);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+Result GenerateMesh(
+    grfx::Queue*                   pQueue,
+    grfx::MeshGenerator*           pGenerator,
+    const grfx::GeneratedMeshInfo& info,
+    grfx::Mesh**                   ppMesh)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pGenerator);
+    PPX_ASSERT_NULL_ARG(ppMesh);
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::CommandBufferPtr cmd;
+    Result                 ppxres = pQueue->CreateCommandBuffer(&cmd, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(pQueue, cmd);
+
+    ppxres = cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::MeshPtr targetMesh;
+    ppxres = pGenerator->Record(cmd, info, &targetMesh);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(targetMesh);
+
+    ppxres = cmd->End();
     if (Failed(ppxres)) {
         return ppxres;
     }
 
+    grfx::SubmitInfo submit   = {};
+    submit.commandBufferCount = 1;
+    submit.ppCommandBuffers   = &cmd;
+
+    ppxres = pQueue->Submit(&submit);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = pQueue->WaitIdle();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    pGenerator->Reset();
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetMesh->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppMesh = targetMesh;
+
+    return ppx::SUCCESS;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+Result ConvertMeshLayout(
+    grfx::Queue*                pQueue,
+    grfx::MeshLayoutConverter*  pConverter,
+    const grfx::Mesh*           pSrcMesh,
+    const grfx::MeshLayoutInfo& info,
+    grfx::Mesh**                ppMesh)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pConverter);
+    PPX_ASSERT_NULL_ARG(pSrcMesh);
+    PPX_ASSERT_NULL_ARG(ppMesh);
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pQueue->GetDevice());
+
+    grfx::CommandBufferPtr cmd;
+    Result                 ppxres = pQueue->CreateCommandBuffer(&cmd, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(pQueue, cmd);
+
+    ppxres = cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::MeshPtr targetMesh;
+    ppxres = pConverter->Record(cmd, pSrcMesh, info, &targetMesh);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    SCOPED_DESTROYER.AddObject(targetMesh);
+
+    ppxres = cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submit   = {};
+    submit.commandBufferCount = 1;
+    submit.ppCommandBuffers   = &cmd;
+
+    ppxres = pQueue->Submit(&submit);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = pQueue->WaitIdle();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    pConverter->Reset();
+
+    // Change ownership to reference so object doesn't get destroyed
+    targetMesh->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    // Assign output
+    *ppMesh = targetMesh;
+
     return ppx::SUCCESS;
 }
 
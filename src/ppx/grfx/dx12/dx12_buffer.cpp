@@ -24,7 +24,8 @@ Result Buffer::CreateApiObjects(const grfx::BufferCreateInfo* pCreateInfo)
     D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE;
 
     if (pCreateInfo->usageFlags.bits.rawStorageBuffer ||
-        pCreateInfo->usageFlags.bits.rwStructuredBuffer) {
+        pCreateInfo->usageFlags.bits.rwStructuredBuffer ||
+        pCreateInfo->usageFlags.bits.accelerationStructureStorage) {
         flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
     }
 
@@ -19,8 +19,10 @@
 #include "ppx/grfx/dx12/dx12_image.h"
 #include "ppx/grfx/dx12/dx12_pipeline.h"
 #include "ppx/grfx/dx12/dx12_query.h"
+#include "ppx/grfx/dx12/dx12_ray_tracing.h"
 #include "ppx/grfx/dx12/dx12_render_pass.h"
 #include "ppx/grfx/dx12/dx12_util.h"
+#include "ppx/frame_arena.h"
 
 namespace ppx {
 namespace grfx {
@@ -37,6 +39,13 @@ Result CommandBuffer::CreateApiObjects(const grfx::internal::CommandBufferCreate
     D3D12_COMMAND_LIST_TYPE  type     = ToApi(pCreateInfo->pPool)->GetDxCommandType();
     D3D12_COMMAND_LIST_FLAGS flags    = D3D12_COMMAND_LIST_FLAG_NONE;
 
+    // Secondary command buffers are bundles. Bundles need a bundle
+    // allocator and cannot have descriptor heaps of their own.
+    //
+    if (pCreateInfo->secondary) {
+        type = D3D12_COMMAND_LIST_TYPE_BUNDLE;
+    }
+
     // NOTE: CreateCommandList1 creates a command list in closed state. No need to
     //       call Close() it after creation unlike command lists created with
     //       CreateCommandList.
@@ -48,6 +57,27 @@ Result CommandBuffer::CreateApiObjects(const grfx::internal::CommandBufferCreate
     }
     PPX_LOG_OBJECT_CREATION(D3D12GraphicsCommandList, mCommandList.Get());
 
+    // DispatchMesh is only on ID3D12GraphicsCommandList6
+    if (GetDevice()->MeshShaderSupported()) {
+        hr = mCommandList->QueryInterface(IID_PPV_ARGS(&mCommandList6));
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12GraphicsCommandList::QueryInterface(ID3D12GraphicsCommandList6) failed");
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    // Barrier() is only on ID3D12GraphicsCommandList7, bundles can't record
+    // barriers
+    if (ToApi(GetDevice())->EnhancedBarriersSupported() && !pCreateInfo->secondary) {
+        hr = mCommandList->QueryInterface(IID_PPV_ARGS(&mCommandList7));
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12GraphicsCommandList::QueryInterface(ID3D12GraphicsCommandList7) failed");
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+#endif
+
     //// Store command allocator for reset
     // mCommandAllocator = ToApi(pCreateInfo->pPool)->GetDxCommandAllocator();
     hr = ToApi(GetDevice())->GetDxDevice()->CreateCommandAllocator(type, IID_PPV_ARGS(&mCommandAllocator));
@@ -57,38 +87,15 @@ Result CommandBuffer::CreateApiObjects(const grfx::internal::CommandBufferCreate
     }
     PPX_LOG_OBJECT_CREATION(D3D12CommandAllocator, mCommandAllocator.Get());
 
-    // Heap sizes
-    mHeapSizeCBVSRVUAV = static_cast<UINT>(pCreateInfo->resourceDescriptorCount);
-    mHeapSizeSampler   = static_cast<UINT>(pCreateInfo->samplerDescriptorCount);
-
-    // Allocate CBVSRVUAV heap
-    if (mHeapSizeCBVSRVUAV > 0) {
-        D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-        desc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-        desc.NumDescriptors             = mHeapSizeCBVSRVUAV;
-        desc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        desc.NodeMask                   = 0;
-
-        HRESULT hr = device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&mHeapCBVSRVUAV));
-        if (FAILED(hr)) {
-            PPX_ASSERT_MSG(false, "ID3D12Device::CreateDescriptorHeap(CBVSRVUAV) failed");
-            return ppx::ERROR_API_FAILURE;
-        }
-    }
-
-    // Allocate Sampler heap
-    if (mHeapSizeSampler > 0) {
-        D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-        desc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
-        desc.NumDescriptors             = mHeapSizeSampler;
-        desc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-        desc.NodeMask                   = 0;
-
-        HRESULT hr = device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&mHeapSampler));
-        if (FAILED(hr)) {
-            PPX_ASSERT_MSG(false, "ID3D12Device::CreateDescriptorHeap(Sampler) failed");
-            return ppx::ERROR_API_FAILURE;
-        }
+    // Descriptor tables are staged in chunks of the device's shader
+    // visible rings, bundles use the heaps of the command list that
+    // executes them.
+    //
+    if (!pCreateInfo->secondary) {
+        mStagingCBVSRVUAV.pRing     = ToApi(GetDevice())->GetDescriptorRingCBVSRVUAV();
+        mStagingCBVSRVUAV.chunkSize = dx12::DESCRIPTOR_RING_CHUNK_SIZE_CBVSRVUAV;
+        mStagingSampler.pRing       = ToApi(GetDevice())->GetDescriptorRingSampler();
+        mStagingSampler.chunkSize   = dx12::DESCRIPTOR_RING_CHUNK_SIZE_SAMPLER;
     }
 
     return ppx::SUCCESS;
@@ -96,6 +103,20 @@ Result CommandBuffer::CreateApiObjects(const grfx::internal::CommandBufferCreate
 
 void CommandBuffer::DestroyApiObjects()
 {
+    RetireDescriptors(mStagingCBVSRVUAV);
+    RetireDescriptors(mStagingSampler);
+    mSubmitFence.Reset();
+
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    if (mCommandList7) {
+        mCommandList7.Reset();
+    }
+#endif
+
+    if (mCommandList6) {
+        mCommandList6.Reset();
+    }
+
     if (mCommandList) {
         mCommandList.Reset();
     }
@@ -103,14 +124,48 @@ void CommandBuffer::DestroyApiObjects()
     if (mCommandAllocator) {
         mCommandAllocator.Reset();
     }
+}
+
+void CommandBuffer::SetSubmitFence(ID3D12Fence* pFence, UINT64 value) const
+{
+    mSubmitFence      = pFence;
+    mSubmitFenceValue = value;
+}
 
-    if (mHeapCBVSRVUAV) {
-        mHeapCBVSRVUAV.Reset();
+Result CommandBuffer::StageDescriptors(DescriptorStaging& staging, UINT count, UINT* pOffset)
+{
+    PPX_ASSERT_MSG(!IsNull(staging.pRing), "command buffer has no descriptor ring");
+
+    if ((staging.chunkUsed + count) > staging.chunkCount) {
+        UINT   chunkCount  = std::max(staging.chunkSize, count);
+        UINT   chunkOffset = 0;
+        Result ppxres      = staging.pRing->AllocateChunk(chunkCount, &chunkOffset);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "descriptor ring is exhausted, too many descriptors in flight");
+            return ppxres;
+        }
+
+        staging.chunkOffset = chunkOffset;
+        staging.chunkCount  = chunkCount;
+        staging.chunkUsed   = 0;
+        staging.chunks.push_back(chunkOffset);
     }
 
-    if (mHeapSampler) {
-        mHeapSampler.Reset();
+    *pOffset = staging.chunkOffset + staging.chunkUsed;
+    staging.chunkUsed += count;
+
+    return ppx::SUCCESS;
+}
+
+void CommandBuffer::RetireDescriptors(DescriptorStaging& staging)
+{
+    for (UINT offset : staging.chunks) {
+        staging.pRing->RetireChunk(offset, mSubmitFence, mSubmitFenceValue);
     }
+    staging.chunks.clear();
+    staging.chunkOffset = 0;
+    staging.chunkCount  = 0;
+    staging.chunkUsed   = 0;
 }
 
 Result CommandBuffer::Begin()
@@ -141,30 +196,37 @@ Result CommandBuffer::Begin()
     mCurrentGraphicsInterface = nullptr;
     mCurrentComputeInterface  = nullptr;
 
+    // The previous recording's chunks go back to the rings, they're reused
+    // once the GPU is past its last submission.
+    RetireDescriptors(mStagingCBVSRVUAV);
+    RetireDescriptors(mStagingSampler);
+    mSubmitFence.Reset();
+    mSubmitFenceValue = 0;
+
     // Set descriptor heaps
-    ID3D12DescriptorHeap* heaps[2]  = {nullptr};
-    uint32_t              heapCount = 0;
-    if (mHeapCBVSRVUAV) {
-        heaps[heapCount] = mHeapCBVSRVUAV.Get();
-        ++heapCount;
-    }
-    if (mHeapSampler) {
-        heaps[heapCount] = mHeapSampler.Get();
-        ++heapCount;
-    }
-    if (heapCount > 0) {
-        mCommandList->SetDescriptorHeaps(heapCount, heaps);
+    if (!IsSecondary()) {
+        ID3D12DescriptorHeap* heaps[2] = {
+            mStagingCBVSRVUAV.pRing->GetDxHeap(),
+            mStagingSampler.pRing->GetDxHeap()};
+        mCommandList->SetDescriptorHeaps(2, heaps);
     }
 
-    // Reset heap offsets
-    mHeapOffsetCBVSRVUAV = 0;
-    mHeapOffsetSampler   = 0;
-
     return ppx::SUCCESS;
 }
 
+Result CommandBuffer::BeginSecondaryImpl(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo)
+{
+    // Bundles inherit render targets, viewports and scissors from the
+    // command list that executes them so there is nothing to set up
+    // from the inheritance info.
+    //
+    return Begin();
+}
+
 Result CommandBuffer::End()
 {
+    FlushBarriers();
+
     HRESULT hr = mCommandList->Close();
     if (FAILED(hr)) {
         PPX_ASSERT_MSG(false, "ID3D12CommandList::Close failed");
@@ -174,6 +236,19 @@ Result CommandBuffer::End()
     return ppx::SUCCESS;
 }
 
+void CommandBuffer::ExecuteCommandsImpl(
+    uint32_t                          commandBufferCount,
+    const grfx::CommandBuffer* const* ppCommandBuffers)
+{
+    for (uint32_t i = 0; i < commandBufferCount; ++i) {
+        mCommandList->ExecuteBundle(ToApi(ppCommandBuffers[i])->GetDxCommandList());
+    }
+
+    // Root signatures set by the bundles leak into this command list
+    mCurrentGraphicsInterface = nullptr;
+    mCurrentComputeInterface  = nullptr;
+}
+
 void CommandBuffer::BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo)
 {
     PPX_ASSERT_NULL_ARG(pBeginInfo->pRenderPass);
@@ -241,7 +316,31 @@ void CommandBuffer::BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginI
 
 void CommandBuffer::EndRenderPassImpl()
 {
-    // Nothing to do here for now
+    // Render pass resolves are done with ResolveSubresource(), the render
+    // targets and resolve images stay in RESOURCE_STATE_RENDER_TARGET like
+    // the Vulkan resolve attachments
+    const grfx::RenderPass* pRenderPass = GetCurrentRenderPass();
+    if (IsNull(pRenderPass) || !pRenderPass->HasResolve()) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < pRenderPass->GetRenderTargetCount(); ++i) {
+        grfx::ImagePtr dstImage = pRenderPass->GetResolveImage(i);
+        if (!dstImage) {
+            continue;
+        }
+        grfx::ImagePtr srcImage = pRenderPass->GetRenderTargetImage(i);
+
+        TransitionImageLayout(srcImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_RESOLVE_SRC);
+        TransitionImageLayout(dstImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RENDER_TARGET, grfx::RESOURCE_STATE_RESOLVE_DST);
+
+        grfx::ImageResolveInfo resolveInfo   = {};
+        resolveInfo.srcImage.arrayLayerCount = srcImage->GetArrayLayerCount();
+        ResolveImage(&resolveInfo, srcImage, dstImage);
+
+        TransitionImageLayout(srcImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RESOLVE_SRC, grfx::RESOURCE_STATE_RENDER_TARGET);
+        TransitionImageLayout(dstImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_RESOLVE_DST, grfx::RESOURCE_STATE_RENDER_TARGET);
+    }
 }
 
 D3D12_RENDER_PASS_BEGINNING_ACCESS_TYPE ToBeginningAccessType(grfx::AttachmentLoadOp loadOp)
@@ -510,6 +609,8 @@ void CommandBuffer::TransitionImageLayout(
     const grfx::Queue*  pSrcQueue,
     const grfx::Queue*  pDstQueue)
 {
+    FlushBarriers();
+
     PPX_ASSERT_NULL_ARG(pImage);
 
     (void)pSrcQueue;
@@ -531,9 +632,26 @@ void CommandBuffer::TransitionImageLayout(
         arrayLayerCount = pImage->GetArrayLayerCount();
     }
 
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    if (mCommandList7) {
+        ImageBarrier barrier    = {};
+        barrier.pImage          = pImage;
+        barrier.mipLevel        = mipLevel;
+        barrier.mipLevelCount   = mipLevelCount;
+        barrier.arrayLayer      = arrayLayer;
+        barrier.arrayLayerCount = arrayLayerCount;
+        barrier.beforeState     = beforeState;
+        barrier.afterState      = afterState;
+        EnhancedBarriers(1, &barrier, 0, nullptr);
+        return;
+    }
+#endif
+
     grfx::CommandType commandType = GetCommandType();
 
-    std::vector<D3D12_RESOURCE_BARRIER> barriers;
+    FrameArena::Scope                   scope(FrameArena::GetThreadArena());
+    FrameVector<D3D12_RESOURCE_BARRIER> barriers(scope.GetAllocator<D3D12_RESOURCE_BARRIER>());
+    barriers.reserve(allSubresources ? 1 : (arrayLayerCount * mipLevelCount));
     if (allSubresources) {
         D3D12_RESOURCE_BARRIER barrier = {};
         barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
@@ -580,6 +698,172 @@ void CommandBuffer::TransitionImageLayout(
         DataPtr(barriers));
 }
 
+void CommandBuffer::ResourceBarriersImpl(
+    uint32_t             imageBarrierCount,
+    const ImageBarrier*  pImageBarriers,
+    uint32_t             bufferBarrierCount,
+    const BufferBarrier* pBufferBarriers)
+{
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    if (mCommandList7) {
+        EnhancedBarriers(imageBarrierCount, pImageBarriers, bufferBarrierCount, pBufferBarriers);
+        return;
+    }
+#endif
+
+    grfx::CommandType commandType = GetCommandType();
+
+    FrameArena::Scope                   scope(FrameArena::GetThreadArena());
+    FrameVector<D3D12_RESOURCE_BARRIER> barriers(scope.GetAllocator<D3D12_RESOURCE_BARRIER>());
+    barriers.reserve(imageBarrierCount + bufferBarrierCount);
+    for (uint32_t i = 0; i < imageBarrierCount; ++i) {
+        const ImageBarrier& src    = pImageBarriers[i];
+        const grfx::Image*  pImage = src.pImage;
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.pResource   = ToApi(pImage)->GetDxResource();
+        barrier.Transition.StateBefore = ToD3D12ResourceStates(src.beforeState, commandType);
+        barrier.Transition.StateAfter  = ToD3D12ResourceStates(src.afterState, commandType);
+
+        bool allSubresources = (src.mipLevelCount == pImage->GetMipLevelCount()) && (src.arrayLayerCount == pImage->GetArrayLayerCount());
+        if (allSubresources) {
+            barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+            barriers.push_back(barrier);
+            continue;
+        }
+
+        uint32_t mipSpan = pImage->GetMipLevelCount();
+        for (uint32_t layer = src.arrayLayer; layer < (src.arrayLayer + src.arrayLayerCount); ++layer) {
+            for (uint32_t mip = src.mipLevel; mip < (src.mipLevel + src.mipLevelCount); ++mip) {
+                barrier.Transition.Subresource = static_cast<UINT>(layer * mipSpan + mip);
+                barriers.push_back(barrier);
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i) {
+        const BufferBarrier& src = pBufferBarriers[i];
+
+        D3D12_RESOURCE_BARRIER barrier = {};
+        barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+        barrier.Transition.pResource   = ToApi(src.pBuffer)->GetDxResource();
+        barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+        barrier.Transition.StateBefore = ToD3D12ResourceStates(src.beforeState, commandType);
+        barrier.Transition.StateAfter  = ToD3D12ResourceStates(src.afterState, commandType);
+        barriers.push_back(barrier);
+    }
+
+    if (barriers.empty()) {
+        return;
+    }
+
+    mCommandList->ResourceBarrier(
+        static_cast<UINT>(barriers.size()),
+        DataPtr(barriers));
+}
+
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+void CommandBuffer::EnhancedBarriers(
+    uint32_t             imageBarrierCount,
+    const ImageBarrier*  pImageBarriers,
+    uint32_t             bufferBarrierCount,
+    const BufferBarrier* pBufferBarriers)
+{
+    grfx::CommandType commandType = GetCommandType();
+
+    // A subresource range replaces the per subresource legacy barriers
+    std::vector<D3D12_TEXTURE_BARRIER> textureBarriers;
+    textureBarriers.reserve(imageBarrierCount);
+    for (uint32_t i = 0; i < imageBarrierCount; ++i) {
+        const ImageBarrier&     src    = pImageBarriers[i];
+        const grfx::Image*      pImage = src.pImage;
+        const D3D12BarrierState before = ToD3D12BarrierState(src.beforeState, commandType);
+        const D3D12BarrierState after  = ToD3D12BarrierState(src.afterState, commandType);
+
+        D3D12_TEXTURE_BARRIER barrier = {};
+        barrier.SyncBefore            = before.sync;
+        barrier.SyncAfter             = after.sync;
+        barrier.AccessBefore          = before.access;
+        barrier.AccessAfter           = after.access;
+        barrier.LayoutBefore          = before.layout;
+        barrier.LayoutAfter           = after.layout;
+        barrier.pResource             = ToApi(pImage)->GetDxResource();
+        barrier.Flags                 = D3D12_TEXTURE_BARRIER_FLAG_NONE;
+
+        bool allSubresources = (src.mipLevel == 0) && (src.mipLevelCount == pImage->GetMipLevelCount()) && (src.arrayLayer == 0) && (src.arrayLayerCount == pImage->GetArrayLayerCount());
+        if (allSubresources) {
+            // NumMipLevels = 0 selects all subresources
+            barrier.Subresources.IndexOrFirstMipLevel = 0xFFFFFFFF;
+            barrier.Subresources.NumMipLevels         = 0;
+        }
+        else {
+            const grfx::FormatDesc* pFormatDesc = grfx::GetFormatDescription(pImage->GetFormat());
+
+            barrier.Subresources.IndexOrFirstMipLevel = src.mipLevel;
+            barrier.Subresources.NumMipLevels         = src.mipLevelCount;
+            barrier.Subresources.FirstArraySlice      = src.arrayLayer;
+            barrier.Subresources.NumArraySlices       = src.arrayLayerCount;
+            barrier.Subresources.FirstPlane           = 0;
+            barrier.Subresources.NumPlanes            = (pFormatDesc->aspect == grfx::FORMAT_ASPECT_DEPTH_STENCIL) ? 2 : 1;
+        }
+        textureBarriers.push_back(barrier);
+    }
+
+    std::vector<D3D12_BUFFER_BARRIER> bufferBarriers;
+    bufferBarriers.reserve(bufferBarrierCount);
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i) {
+        const BufferBarrier&    src    = pBufferBarriers[i];
+        const D3D12BarrierState before = ToD3D12BarrierState(src.beforeState, commandType);
+        const D3D12BarrierState after  = ToD3D12BarrierState(src.afterState, commandType);
+
+        D3D12_BUFFER_BARRIER barrier = {};
+        barrier.SyncBefore           = before.sync;
+        barrier.SyncAfter            = after.sync;
+        barrier.AccessBefore         = before.access;
+        barrier.AccessAfter          = after.access;
+        barrier.pResource            = ToApi(src.pBuffer)->GetDxResource();
+        barrier.Offset               = 0;
+        barrier.Size                 = UINT64_MAX;
+        bufferBarriers.push_back(barrier);
+    }
+
+    D3D12_BARRIER_GROUP groups[2]  = {};
+    UINT32              groupCount = 0;
+    if (!textureBarriers.empty()) {
+        groups[groupCount].Type             = D3D12_BARRIER_TYPE_TEXTURE;
+        groups[groupCount].NumBarriers      = CountU32(textureBarriers);
+        groups[groupCount].pTextureBarriers = DataPtr(textureBarriers);
+        ++groupCount;
+    }
+    if (!bufferBarriers.empty()) {
+        groups[groupCount].Type            = D3D12_BARRIER_TYPE_BUFFER;
+        groups[groupCount].NumBarriers     = CountU32(bufferBarriers);
+        groups[groupCount].pBufferBarriers = DataPtr(bufferBarriers);
+        ++groupCount;
+    }
+
+    if (groupCount > 0) {
+        mCommandList7->Barrier(groupCount, groups);
+    }
+}
+#endif
+
+void CommandBuffer::AliasingBarrierImpl(const grfx::Image* pBefore, grfx::Image* pAfter)
+{
+    // D3D12 keeps per-resource states across aliasing, so the tracked
+    // state of pAfter stays valid.
+    D3D12_RESOURCE_BARRIER barrier   = {};
+    barrier.Type                     = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+    barrier.Flags                    = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.Aliasing.pResourceBefore = IsNull(pBefore) ? nullptr : ToApi(pBefore)->GetDxResource();
+    barrier.Aliasing.pResourceAfter  = ToApi(pAfter)->GetDxResource();
+
+    mCommandList->ResourceBarrier(1, &barrier);
+}
+
 void CommandBuffer::BufferResourceBarrier(
     const grfx::Buffer* pBuffer,
     grfx::ResourceState beforeState,
@@ -587,6 +871,8 @@ void CommandBuffer::BufferResourceBarrier(
     const grfx::Queue*  pSrcQueue,
     const grfx::Queue*  pDstQueue)
 {
+    FlushBarriers();
+
     PPX_ASSERT_NULL_ARG(pBuffer);
 
     (void)pSrcQueue;
@@ -596,6 +882,17 @@ void CommandBuffer::BufferResourceBarrier(
         return;
     }
 
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    if (mCommandList7) {
+        BufferBarrier barrier = {};
+        barrier.pBuffer       = pBuffer;
+        barrier.beforeState   = beforeState;
+        barrier.afterState    = afterState;
+        EnhancedBarriers(0, nullptr, 1, &barrier);
+        return;
+    }
+#endif
+
     grfx::CommandType commandType = GetCommandType();
 
     D3D12_RESOURCE_BARRIER barrier = {};
@@ -612,6 +909,11 @@ void CommandBuffer::SetViewports(
     uint32_t              viewportCount,
     const grfx::Viewport* pViewports)
 {
+    // Bundles inherit viewports from the executing command list
+    if (IsSecondary()) {
+        return;
+    }
+
     D3D12_VIEWPORT viewports[PPX_MAX_VIEWPORTS] = {};
     for (uint32_t i = 0; i < viewportCount; ++i) {
         viewports[i].TopLeftX = pViewports[i].x;
@@ -629,6 +931,11 @@ void CommandBuffer::SetScissors(
     uint32_t          scissorCount,
     const grfx::Rect* pScissors)
 {
+    // Bundles inherit scissors from the executing command list
+    if (IsSecondary()) {
+        return;
+    }
+
     D3D12_RECT rects[PPX_MAX_SCISSORS] = {};
     for (uint32_t i = 0; i < scissorCount; ++i) {
         rects[i].left   = pScissors[i].x;
@@ -640,6 +947,35 @@ void CommandBuffer::SetScissors(
     mCommandList->RSSetScissorRects(static_cast<UINT>(scissorCount), rects);
 }
 
+// D3D12 pipeline state objects bake these states, Device reports them as
+// unsupported so pipelines can't ask for them.
+void CommandBuffer::SetCullMode(grfx::CullMode cullMode)
+{
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported on D3D12");
+}
+
+void CommandBuffer::SetPrimitiveTopology(grfx::PrimitiveTopology topology)
+{
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported on D3D12");
+}
+
+void CommandBuffer::SetDepthTestEnable(bool enable)
+{
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported on D3D12");
+}
+
+void CommandBuffer::SetDepthWriteEnable(bool enable)
+{
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported on D3D12");
+}
+
+void CommandBuffer::SetBlendEnable(
+    uint32_t    renderTargetCount,
+    const bool* pEnables)
+{
+    PPX_ASSERT_MSG(false, "dynamic blend enable is not supported on D3D12");
+}
+
 void CommandBuffer::SetGraphicsPipelineInterface(const grfx::PipelineInterface* pInterface)
 {
     // Only set root signature if we have to
@@ -665,12 +1001,14 @@ void CommandBuffer::BindDescriptorSets(
     size_t&                           rdtCountCBVSRVUAV,
     size_t&                           rdtCountSampler)
 {
-    dx12::Device*                  pApiDevice             = ToApi(GetDevice());
-    D3D12DevicePtr                 device                 = pApiDevice->GetDxDevice();
-    const dx12::PipelineInterface* pApiPipelineInterface  = ToApi(pInterface);
-    const std::vector<uint32_t>&   setNumbers             = pApiPipelineInterface->GetSetNumbers();
-    UINT                           incrementSizeCBVSRVUAV = pApiDevice->GetHandleIncrementSizeCBVSRVUAV();
-    UINT                           incrementSizeSampler   = pApiDevice->GetHandleIncrementSizeSampler();
+    PPX_ASSERT_MSG(!IsSecondary(), "descriptor sets cannot be bound in D3D12 bundles");
+
+    dx12::Device*                  pApiDevice            = ToApi(GetDevice());
+    D3D12DevicePtr                 device                = pApiDevice->GetDxDevice();
+    const dx12::PipelineInterface* pApiPipelineInterface = ToApi(pInterface);
+    const std::vector<uint32_t>&   setNumbers            = pApiPipelineInterface->GetSetNumbers();
+    dx12::DescriptorRingAllocator* pRingCBVSRVUAV        = mStagingCBVSRVUAV.pRing;
+    dx12::DescriptorRingAllocator* pRingSampler          = mStagingSampler.pRing;
 
     uint32_t parameterIndexCount = pApiPipelineInterface->GetParameterIndexCount();
     if (parameterIndexCount > mRootDescriptorTablesCBVSRVUAV.size()) {
@@ -688,13 +1026,17 @@ void CommandBuffer::BindDescriptorSets(
         auto&                      bindings = pApiSet->GetLayout()->GetBindings();
 
         // Copy the descriptors
+        UINT offsetCBVSRVUAV = 0;
+        UINT offsetSampler   = 0;
         {
             UINT numDescriptors = pApiSet->GetNumDescriptorsCBVSRVUAV();
             if (numDescriptors > 0) {
-                D3D12_CPU_DESCRIPTOR_HANDLE dstRangeStart = mHeapCBVSRVUAV->GetCPUDescriptorHandleForHeapStart();
-                D3D12_CPU_DESCRIPTOR_HANDLE srcRangeStart = pApiSet->GetHeapCBVSRVUAV()->GetCPUDescriptorHandleForHeapStart();
+                if (Failed(StageDescriptors(mStagingCBVSRVUAV, numDescriptors, &offsetCBVSRVUAV))) {
+                    return;
+                }
 
-                dstRangeStart.ptr += (mHeapOffsetCBVSRVUAV * incrementSizeCBVSRVUAV);
+                D3D12_CPU_DESCRIPTOR_HANDLE dstRangeStart = pRingCBVSRVUAV->GetCPUHandle(offsetCBVSRVUAV);
+                D3D12_CPU_DESCRIPTOR_HANDLE srcRangeStart = pApiSet->GetHeapCBVSRVUAV()->GetCPUDescriptorHandleForHeapStart();
 
                 device->CopyDescriptorsSimple(
                     numDescriptors,
@@ -705,10 +1047,12 @@ void CommandBuffer::BindDescriptorSets(
 
             numDescriptors = pApiSet->GetNumDescriptorsSampler();
             if (numDescriptors > 0) {
-                D3D12_CPU_DESCRIPTOR_HANDLE dstRangeStart = mHeapSampler->GetCPUDescriptorHandleForHeapStart();
-                D3D12_CPU_DESCRIPTOR_HANDLE srcRangeStart = pApiSet->GetHeapSampler()->GetCPUDescriptorHandleForHeapStart();
+                if (Failed(StageDescriptors(mStagingSampler, numDescriptors, &offsetSampler))) {
+                    return;
+                }
 
-                dstRangeStart.ptr += (mHeapOffsetSampler * incrementSizeSampler);
+                D3D12_CPU_DESCRIPTOR_HANDLE dstRangeStart = pRingSampler->GetCPUHandle(offsetSampler);
+                D3D12_CPU_DESCRIPTOR_HANDLE srcRangeStart = pApiSet->GetHeapSampler()->GetCPUDescriptorHandleForHeapStart();
 
                 device->CopyDescriptorsSimple(
                     numDescriptors,
@@ -727,19 +1071,17 @@ void CommandBuffer::BindDescriptorSets(
             if (binding.type == grfx::DESCRIPTOR_TYPE_SAMPLER) {
                 RootDescriptorTable& rdt = mRootDescriptorTablesSampler[rdtCountSampler];
                 rdt.parameterIndex       = parameterIndex;
-                rdt.baseDescriptor       = mHeapSampler->GetGPUDescriptorHandleForHeapStart();
-                rdt.baseDescriptor.ptr += (mHeapOffsetSampler * incrementSizeSampler);
+                rdt.baseDescriptor       = pRingSampler->GetGPUHandle(offsetSampler);
 
-                mHeapOffsetSampler += static_cast<UINT>(binding.arrayCount);
+                offsetSampler += static_cast<UINT>(binding.arrayCount);
                 rdtCountSampler += 1;
             }
             else {
                 RootDescriptorTable& rdt = mRootDescriptorTablesCBVSRVUAV[rdtCountCBVSRVUAV];
                 rdt.parameterIndex       = parameterIndex;
-                rdt.baseDescriptor       = mHeapCBVSRVUAV->GetGPUDescriptorHandleForHeapStart();
-                rdt.baseDescriptor.ptr += (mHeapOffsetCBVSRVUAV * incrementSizeCBVSRVUAV);
+                rdt.baseDescriptor       = pRingCBVSRVUAV->GetGPUHandle(offsetCBVSRVUAV);
 
-                mHeapOffsetCBVSRVUAV += static_cast<UINT>(binding.arrayCount);
+                offsetCBVSRVUAV += static_cast<UINT>(binding.arrayCount);
                 rdtCountCBVSRVUAV += 1;
             }
         }
@@ -914,17 +1256,135 @@ void CommandBuffer::Dispatch(
     uint32_t groupCountY,
     uint32_t groupCountZ)
 {
+    FlushBarriers();
+
     mCommandList->Dispatch(
         static_cast<UINT>(groupCountX),
         static_cast<UINT>(groupCountY),
         static_cast<UINT>(groupCountZ));
 }
 
+void CommandBuffer::DrawMeshTasks(
+    uint32_t groupCountX,
+    uint32_t groupCountY,
+    uint32_t groupCountZ)
+{
+    PPX_ASSERT_MSG(mCommandList6, "mesh shaders are not supported");
+
+    mCommandList6->DispatchMesh(
+        static_cast<UINT>(groupCountX),
+        static_cast<UINT>(groupCountY),
+        static_cast<UINT>(groupCountZ));
+}
+
+void CommandBuffer::ExecuteIndirect(
+    D3D12_INDIRECT_ARGUMENT_TYPE type,
+    const grfx::Buffer*          pArgBuffer,
+    uint64_t                     argOffset,
+    const grfx::Buffer*          pCountBuffer,
+    uint64_t                     countOffset,
+    uint32_t                     maxCommandCount,
+    uint32_t                     stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+
+    ID3D12CommandSignature* pSignature = nullptr;
+    HRESULT                 hr         = ToApi(GetDevice())->GetCommandSignature(type, static_cast<UINT>(stride), &pSignature);
+    if (FAILED(hr)) {
+        PPX_ASSERT_MSG(false, "ID3D12Device::CreateCommandSignature failed");
+        return;
+    }
+
+    mCommandList->ExecuteIndirect(
+        pSignature,
+        static_cast<UINT>(maxCommandCount),
+        ToApi(pArgBuffer)->GetDxResource(),
+        static_cast<UINT64>(argOffset),
+        IsNull(pCountBuffer) ? nullptr : ToApi(pCountBuffer)->GetDxResource(),
+        static_cast<UINT64>(countOffset));
+}
+
+void CommandBuffer::DrawIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    uint32_t            drawCount,
+    uint32_t            stride)
+{
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DRAW, pArgBuffer, argOffset, nullptr, 0, drawCount, stride);
+}
+
+void CommandBuffer::DrawIndexedIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    uint32_t            drawCount,
+    uint32_t            stride)
+{
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED, pArgBuffer, argOffset, nullptr, 0, drawCount, stride);
+}
+
+void CommandBuffer::DrawIndirectCount(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    const grfx::Buffer* pCountBuffer,
+    uint64_t            countOffset,
+    uint32_t            maxDrawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pCountBuffer);
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DRAW, pArgBuffer, argOffset, pCountBuffer, countOffset, maxDrawCount, stride);
+}
+
+void CommandBuffer::DrawIndexedIndirectCount(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    const grfx::Buffer* pCountBuffer,
+    uint64_t            countOffset,
+    uint32_t            maxDrawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pCountBuffer);
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED, pArgBuffer, argOffset, pCountBuffer, countOffset, maxDrawCount, stride);
+}
+
+void CommandBuffer::DrawMeshTasksIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    uint32_t            drawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_MSG(mCommandList6, "mesh shaders are not supported");
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH, pArgBuffer, argOffset, nullptr, 0, drawCount, stride);
+}
+
+void CommandBuffer::DrawMeshTasksIndirectCount(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    const grfx::Buffer* pCountBuffer,
+    uint64_t            countOffset,
+    uint32_t            maxDrawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_MSG(mCommandList6, "mesh shaders are not supported");
+    PPX_ASSERT_NULL_ARG(pCountBuffer);
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH_MESH, pArgBuffer, argOffset, pCountBuffer, countOffset, maxDrawCount, stride);
+}
+
+void CommandBuffer::DispatchIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset)
+{
+    FlushBarriers();
+
+    ExecuteIndirect(D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH, pArgBuffer, argOffset, nullptr, 0, 1, sizeof(grfx::DispatchIndirectCommand));
+}
+
 void CommandBuffer::CopyBufferToBuffer(
     const grfx::BufferToBufferCopyInfo* pCopyInfo,
     grfx::Buffer*                       pSrcBuffer,
     grfx::Buffer*                       pDstBuffer)
 {
+    FlushBarriers();
+
     mCommandList->CopyBufferRegion(
         ToApi(pDstBuffer)->GetDxResource(),
         static_cast<UINT64>(pCopyInfo->dstBuffer.offset),
@@ -948,6 +1408,8 @@ void CommandBuffer::CopyBufferToImage(
     grfx::Buffer*                      pSrcBuffer,
     grfx::Image*                       pDstImage)
 {
+    FlushBarriers();
+
     D3D12DevicePtr      device        = ToApi(GetDevice())->GetDxDevice();
     D3D12_RESOURCE_DESC resouceDesc   = ToApi(pDstImage)->GetDxResource()->GetDesc();
     const uint32_t      mipLevelCount = pDstImage->GetMipLevelCount();
@@ -1009,6 +1471,8 @@ grfx::ImageToBufferOutputPitch CommandBuffer::CopyImageToBuffer(
     grfx::Image*                       pSrcImage,
     grfx::Buffer*                      pDstBuffer)
 {
+    FlushBarriers();
+
     D3D12DevicePtr      device      = ToApi(GetDevice())->GetDxDevice();
     D3D12_RESOURCE_DESC resouceDesc = ToApi(pSrcImage)->GetDxResource()->GetDesc();
 
@@ -1087,6 +1551,8 @@ void CommandBuffer::CopyImageToImage(
     grfx::Image*                      pSrcImage,
     grfx::Image*                      pDstImage)
 {
+    FlushBarriers();
+
     bool isSourceDepthStencil = grfx::GetFormatDescription(pSrcImage->GetFormat())->aspect == grfx::FORMAT_ASPECT_DEPTH_STENCIL;
     bool isDestDepthStencil   = grfx::GetFormatDescription(pDstImage->GetFormat())->aspect == grfx::FORMAT_ASPECT_DEPTH_STENCIL;
     PPX_ASSERT_MSG(isSourceDepthStencil == isDestDepthStencil, "both images in an image copy must be depth-stencil if one is depth-stencil");
@@ -1134,9 +1600,34 @@ void CommandBuffer::BlitImage(
     grfx::Image*               pSrcImage,
     grfx::Image*               pDstImage)
 {
+    FlushBarriers();
+
     PPX_ASSERT_MSG(false, "BlitImage is not implemented in DX12 backend");
 }
 
+void CommandBuffer::ResolveImage(
+    const grfx::ImageResolveInfo* pResolveInfo,
+    grfx::Image*                  pSrcImage,
+    grfx::Image*                  pDstImage)
+{
+    PPX_ASSERT_MSG(pSrcImage->GetSampleCount() != grfx::SAMPLE_COUNT_1, "resolve source must be multisampled");
+    PPX_ASSERT_MSG(pDstImage->GetSampleCount() == grfx::SAMPLE_COUNT_1, "resolve destination must have a single sample");
+    PPX_ASSERT_MSG(pSrcImage->GetFormat() == pDstImage->GetFormat(), "both images in a resolve must have the same format");
+
+    FlushBarriers();
+
+    for (uint32_t l = 0; l < pResolveInfo->srcImage.arrayLayerCount; ++l) {
+        UINT srcSubresource = ToSubresourceIndex(0, pResolveInfo->srcImage.arrayLayer + l, 0, pSrcImage->GetMipLevelCount(), pSrcImage->GetArrayLayerCount());
+        UINT dstSubresource = ToSubresourceIndex(pResolveInfo->dstImage.mipLevel, pResolveInfo->dstImage.arrayLayer + l, 0, pDstImage->GetMipLevelCount(), pDstImage->GetArrayLayerCount());
+        mCommandList->ResolveSubresource(
+            ToApi(pDstImage)->GetDxResource(),
+            dstSubresource,
+            ToApi(pSrcImage)->GetDxResource(),
+            srcSubresource,
+            dx::ToDxgiFormat(pSrcImage->GetFormat()));
+    }
+}
+
 void CommandBuffer::BeginQuery(
     const grfx::Query* pQuery,
     uint32_t           queryIndex)
@@ -1191,9 +1682,167 @@ void CommandBuffer::ResolveQueryData(
     uint32_t     numQueries)
 {
     PPX_ASSERT_MSG((startIndex + numQueries) <= pQuery->GetCount(), "invalid query index/number");
+
+    // Compacted sizes live in a UAV buffer, copy them to the readback buffer
+    if (pQuery->GetType() == grfx::QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE) {
+        const grfx::Buffer* pPostbuildInfoBuffer = ToApi(pQuery)->GetPostbuildInfoBuffer();
+        const uint64_t      elementSize          = sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+        BufferResourceBarrier(pPostbuildInfoBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+        mCommandList->CopyBufferRegion(
+            ToApi(pQuery)->GetReadBackBuffer(),
+            startIndex * elementSize,
+            ToApi(pPostbuildInfoBuffer)->GetDxResource(),
+            startIndex * elementSize,
+            numQueries * elementSize);
+        BufferResourceBarrier(pPostbuildInfoBuffer, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+        return;
+    }
+
     mCommandList->ResolveQueryData(ToApi(pQuery)->GetDxQueryHeap(), ToApi(pQuery)->GetQueryType(), startIndex, numQueries, ToApi(pQuery)->GetReadBackBuffer(), 0);
 }
 
+void CommandBuffer::ResolveOcclusionPredicates(
+    const grfx::Query* pQuery,
+    uint32_t           firstQuery,
+    uint32_t           queryCount,
+    grfx::Buffer*      pDstBuffer,
+    uint64_t           dstOffset)
+{
+    PPX_ASSERT_NULL_ARG(pQuery);
+    PPX_ASSERT_NULL_ARG(pDstBuffer);
+    PPX_ASSERT_MSG(pQuery->GetType() == grfx::QUERY_TYPE_OCCLUSION, "query must be an occlusion query");
+    PPX_ASSERT_MSG((firstQuery + queryCount) <= pQuery->GetCount(), "invalid query index/number");
+    PPX_ASSERT_MSG((dstOffset + queryCount * PPX_OCCLUSION_PREDICATE_SIZE) <= pDstBuffer->GetSize(), "predicates exceed destination buffer");
+
+    // Resolved sample counts are 64-bit, which is what predication reads
+    BufferResourceBarrier(pDstBuffer, grfx::RESOURCE_STATE_PREDICATION, grfx::RESOURCE_STATE_COPY_DST);
+    mCommandList->ResolveQueryData(
+        ToApi(pQuery)->GetDxQueryHeap(),
+        ToApi(pQuery)->GetQueryType(),
+        static_cast<UINT>(firstQuery),
+        static_cast<UINT>(queryCount),
+        ToApi(pDstBuffer)->GetDxResource(),
+        static_cast<UINT64>(dstOffset));
+    BufferResourceBarrier(pDstBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_PREDICATION);
+}
+
+void CommandBuffer::BeginConditionalRendering(
+    const grfx::Buffer* pBuffer,
+    uint64_t            offset)
+{
+    PPX_ASSERT_NULL_ARG(pBuffer);
+    PPX_ASSERT_MSG((offset % PPX_OCCLUSION_PREDICATE_SIZE) == 0, "predicate offset must be a multiple of PPX_OCCLUSION_PREDICATE_SIZE");
+
+    // Commands are dropped while the predicate is zero
+    mCommandList->SetPredication(
+        ToApi(pBuffer)->GetDxResource(),
+        static_cast<UINT64>(offset),
+        D3D12_PREDICATION_OP_EQUAL_ZERO);
+}
+
+void CommandBuffer::EndConditionalRendering()
+{
+    mCommandList->SetPredication(nullptr, 0, D3D12_PREDICATION_OP_EQUAL_ZERO);
+}
+
+void CommandBuffer::BuildAccelerationStructures(
+    uint32_t                                    count,
+    const grfx::AccelerationStructureBuildInfo* pInfos)
+{
+    PPX_ASSERT_MSG(ToApi(GetDevice())->AccelerationStructureSupported(), "acceleration structures are not supported");
+
+    FlushBarriers();
+
+    // D3D12 builds one structure per call, the geometry is reused between builds
+    dx12::AccelerationStructureBuildGeometry geometry;
+    for (uint32_t i = 0; i < count; ++i) {
+        const grfx::AccelerationStructureBuildInfo& info   = pInfos[i];
+        const bool                                  update = !IsNull(info.pSrc);
+
+        Result ppxres = ToD3D12AccelerationStructureBuildGeometry(info.pInputs, update, &geometry);
+        PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "invalid acceleration structure build inputs");
+
+        D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+        desc.DestAccelerationStructureData                      = ToApi(info.pDst)->GetGpuVirtualAddress();
+        desc.Inputs                                             = geometry.inputs;
+        desc.SourceAccelerationStructureData                    = update ? ToApi(info.pSrc)->GetGpuVirtualAddress() : 0;
+        desc.ScratchAccelerationStructureData                   = ToApi(info.pScratch)->GetDxResource()->GetGPUVirtualAddress() + info.scratchOffset;
+
+        mCommandList->BuildRaytracingAccelerationStructure(&desc, 0, nullptr);
+    }
+}
+
+void CommandBuffer::CopyAccelerationStructure(
+    const grfx::AccelerationStructure* pSrc,
+    grfx::AccelerationStructure*       pDst,
+    bool                               compact)
+{
+    PPX_ASSERT_NULL_ARG(pSrc);
+    PPX_ASSERT_NULL_ARG(pDst);
+
+    FlushBarriers();
+
+    mCommandList->CopyRaytracingAccelerationStructure(
+        ToApi(pDst)->GetGpuVirtualAddress(),
+        ToApi(pSrc)->GetGpuVirtualAddress(),
+        compact ? D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_COMPACT : D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE_CLONE);
+}
+
+void CommandBuffer::WriteAccelerationStructureCompactedSizes(
+    uint32_t                                  count,
+    const grfx::AccelerationStructure* const* ppAccelerationStructures,
+    grfx::Query*                              pQuery,
+    uint32_t                                  firstQuery)
+{
+    PPX_ASSERT_NULL_ARG(pQuery);
+    PPX_ASSERT_MSG(pQuery->GetType() == grfx::QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE, "invalid query type");
+    PPX_ASSERT_MSG((firstQuery + count) <= pQuery->GetCount(), "invalid query index/number");
+
+    FlushBarriers();
+
+    std::vector<D3D12_GPU_VIRTUAL_ADDRESS> addresses(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        addresses[i] = ToApi(ppAccelerationStructures[i])->GetGpuVirtualAddress();
+    }
+
+    const uint64_t elementSize = sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC desc = {};
+    desc.DestBuffer                                                  = ToApi(ToApi(pQuery)->GetPostbuildInfoBuffer())->GetDxResource()->GetGPUVirtualAddress() + firstQuery * elementSize;
+    desc.InfoType                                                    = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE;
+
+    mCommandList->EmitRaytracingAccelerationStructurePostbuildInfo(&desc, count, DataPtr(addresses));
+}
+
+void CommandBuffer::AccelerationStructureBarrier()
+{
+    FlushBarriers();
+
+    // Builds and copies are UAV accesses of the structure buffers
+    D3D12_RESOURCE_BARRIER barrier = {};
+    barrier.Type                   = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+    barrier.Flags                  = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+    barrier.UAV.pResource          = nullptr;
+
+    mCommandList->ResourceBarrier(1, &barrier);
+}
+
+void CommandBuffer::BeginDebugLabel(const char* pLabel)
+{
+    PPX_ASSERT_NULL_ARG(pLabel);
+
+    // Metadata 1 is an ANSI string in the PIX event encoding, which is
+    // what PIX and RenderDoc expect without the PIX event runtime.
+    const UINT size = static_cast<UINT>(strlen(pLabel) + 1);
+    mCommandList->BeginEvent(1, pLabel, size);
+}
+
+void CommandBuffer::EndDebugLabel()
+{
+    mCommandList->EndEvent();
+}
+
 // -------------------------------------------------------------------------------------------------
 // CommandPool
 // -------------------------------------------------------------------------------------------------
@@ -16,6 +16,7 @@
 #include "ppx/grfx/dx12/dx12_buffer.h"
 #include "ppx/grfx/dx12/dx12_device.h"
 #include "ppx/grfx/dx12/dx12_image.h"
+#include "ppx/grfx/dx12/dx12_ray_tracing.h"
 
 // *** Graphics API Note ***
 //
@@ -371,6 +372,20 @@ Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDe
 
                 device->CreateConstantBufferView(&desc, handle);
             } break;
+
+            case grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE: {
+                // The structure is addressed by location, the resource must be null
+                D3D12_SHADER_RESOURCE_VIEW_DESC desc          = {};
+                desc.Format                                   = DXGI_FORMAT_UNKNOWN;
+                desc.ViewDimension                            = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
+                desc.Shader4ComponentMapping                  = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+                desc.RaytracingAccelerationStructure.Location = ToApi(srcWrite.pAccelerationStructure)->GetGpuVirtualAddress();
+
+                SIZE_T                      ptr    = heapOffset.descriptorHandle.ptr + static_cast<SIZE_T>(handleIncSizeCBVSRVUAV * srcWrite.arrayIndex);
+                D3D12_CPU_DESCRIPTOR_HANDLE handle = D3D12_CPU_DESCRIPTOR_HANDLE{ptr};
+
+                device->CreateShaderResourceView(nullptr, &desc, handle);
+            } break;
         }
     }
 
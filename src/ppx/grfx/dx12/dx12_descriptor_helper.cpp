@@ -223,6 +223,159 @@ bool DescriptorHandleManager::HasHandle(const DescriptorHandle& handle) const
     return found;
 }
 
+// -------------------------------------------------------------------------------------------------
+// DescriptorRingAllocator
+// -------------------------------------------------------------------------------------------------
+DescriptorRingAllocator::DescriptorRingAllocator()
+{
+}
+
+DescriptorRingAllocator::~DescriptorRingAllocator()
+{
+}
+
+Result DescriptorRingAllocator::Create(dx12::Device* pDevice, D3D12_DESCRIPTOR_HEAP_TYPE type, UINT size)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC d3d12Desc = {};
+    d3d12Desc.Type                       = type;
+    d3d12Desc.NumDescriptors             = size;
+    d3d12Desc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    d3d12Desc.NodeMask                   = 0;
+
+    HRESULT hr = pDevice->GetDxDevice()->CreateDescriptorHeap(&d3d12Desc, IID_PPV_ARGS(&mHeap));
+    if (FAILED(hr)) {
+        PPX_ASSERT_MSG(false, "ID3D12Device::CreateDescriptorHeap(shader visible) failed");
+        return ppx::ERROR_API_FAILURE;
+    }
+    PPX_LOG_OBJECT_CREATION(D3D12DescriptorHeap(Ring), mHeap.Get());
+
+    mCPUStart      = mHeap->GetCPUDescriptorHandleForHeapStart();
+    mGPUStart      = mHeap->GetGPUDescriptorHandleForHeapStart();
+    mIncrementSize = pDevice->GetDxDevice()->GetDescriptorHandleIncrementSize(type);
+    mSize          = size;
+    mHead          = 0;
+
+    return ppx::SUCCESS;
+}
+
+void DescriptorRingAllocator::Destroy()
+{
+    mChunks.clear();
+    mHead = 0;
+    mSize = 0;
+
+    if (mHeap) {
+        mHeap.Reset();
+    }
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorRingAllocator::GetCPUHandle(UINT offset) const
+{
+    D3D12_CPU_DESCRIPTOR_HANDLE handle = mCPUStart;
+    handle.ptr += (SIZE_T(offset) * SIZE_T(mIncrementSize));
+    return handle;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE DescriptorRingAllocator::GetGPUHandle(UINT offset) const
+{
+    D3D12_GPU_DESCRIPTOR_HANDLE handle = mGPUStart;
+    handle.ptr += (UINT64(offset) * UINT64(mIncrementSize));
+    return handle;
+}
+
+void DescriptorRingAllocator::ReclaimChunks()
+{
+    while (!mChunks.empty()) {
+        const Chunk& chunk = mChunks.front();
+        if (!chunk.retired) {
+            break;
+        }
+        if (chunk.fence && (chunk.fence->GetCompletedValue() < chunk.fenceValue)) {
+            break;
+        }
+        mChunks.pop_front();
+    }
+
+    if (mChunks.empty()) {
+        mHead = 0;
+    }
+}
+
+Result DescriptorRingAllocator::AllocateChunk(UINT count, UINT* pOffset)
+{
+    PPX_ASSERT_NULL_ARG(pOffset);
+
+    if ((count == 0) || (count > mSize)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    ReclaimChunks();
+
+    // The used part of the ring runs from the oldest chunk to mHead,
+    // possibly wrapping around the end of the heap.
+    UINT offset = UINT_MAX;
+    if (mChunks.empty()) {
+        offset = 0;
+    }
+    else {
+        const UINT tail = mChunks.front().offset;
+        if (mHead > tail) {
+            if ((mSize - mHead) >= count) {
+                offset = mHead;
+            }
+            else if (tail >= count) {
+                // Skip the end of the heap, it's free once everything
+                // before it is.
+                if (mHead < mSize) {
+                    Chunk padding   = {};
+                    padding.offset  = mHead;
+                    padding.count   = mSize - mHead;
+                    padding.retired = true;
+                    mChunks.push_back(padding);
+                }
+                offset = 0;
+            }
+        }
+        else if ((mHead < tail) && ((tail - mHead) >= count)) {
+            offset = mHead;
+        }
+    }
+
+    if (offset == UINT_MAX) {
+        return ppx::ERROR_OUT_OF_MEMORY;
+    }
+
+    Chunk chunk  = {};
+    chunk.offset = offset;
+    chunk.count  = count;
+    mChunks.push_back(chunk);
+
+    mHead    = offset + count;
+    *pOffset = offset;
+
+    return ppx::SUCCESS;
+}
+
+void DescriptorRingAllocator::RetireChunk(UINT offset, ID3D12Fence* pFence, UINT64 fenceValue)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    auto it = std::find_if(
+        std::begin(mChunks),
+        std::end(mChunks),
+        [offset](const Chunk& elem) -> bool { return !elem.retired && (elem.offset == offset); });
+    if (it == std::end(mChunks)) {
+        PPX_ASSERT_MSG(false, "descriptor ring chunk at offset " << offset << " is not in use");
+        return;
+    }
+
+    it->retired    = true;
+    it->fence      = pFence;
+    it->fenceValue = fenceValue;
+}
+
 } // namespace dx12
 } // namespace grfx
 } // namespace ppx
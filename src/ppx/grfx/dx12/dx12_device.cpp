@@ -22,17 +22,96 @@
 #include "ppx/grfx/dx12/dx12_pipeline.h"
 #include "ppx/grfx/dx12/dx12_queue.h"
 #include "ppx/grfx/dx12/dx12_query.h"
+#include "ppx/grfx/dx12/dx12_ray_tracing.h"
 #include "ppx/grfx/dx12/dx12_render_pass.h"
 #include "ppx/grfx/dx12/dx12_shader.h"
 #include "ppx/grfx/dx12/dx12_swapchain.h"
 #include "ppx/grfx/dx12/dx12_sync.h"
 
 #include "ppx/grfx/grfx_scope.h"
+#include "ppx/fs.h"
+
+#include "xxhash.h"
+
+#include <fstream>
 
 namespace ppx {
 namespace grfx {
 namespace dx12 {
 
+// -------------------------------------------------------------------------------------------------
+// Pipeline library names
+//
+// ID3D12PipelineLibrary stores PSOs by name, so each description is reduced to
+// a hash of everything that affects compilation. Pointers inside the desc are
+// replaced by the data they point to. The root signature is not part of the
+// name: if the stored PSO was built with a different root signature, the load
+// fails and the PSO is compiled normally.
+// -------------------------------------------------------------------------------------------------
+static uint64_t HashBytes(const void* pData, size_t size, uint64_t seed)
+{
+    if (IsNull(pData) || (size == 0)) {
+        return seed;
+    }
+    return XXH64(pData, size, seed);
+}
+
+static uint64_t HashShaderBytecode(const D3D12_SHADER_BYTECODE& bytecode, uint64_t seed)
+{
+    seed = HashBytes(&bytecode.BytecodeLength, sizeof(bytecode.BytecodeLength), seed);
+    return HashBytes(bytecode.pShaderBytecode, bytecode.BytecodeLength, seed);
+}
+
+static std::wstring ToPipelineName(const char* pPrefix, uint64_t hash)
+{
+    std::wstringstream ss;
+    ss << pPrefix << L"_" << std::hex << hash;
+    return ss.str();
+}
+
+static std::wstring GetPipelineName(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    uint64_t hash = 0;
+    hash          = HashShaderBytecode(desc.VS, hash);
+    hash          = HashShaderBytecode(desc.PS, hash);
+    hash          = HashShaderBytecode(desc.DS, hash);
+    hash          = HashShaderBytecode(desc.HS, hash);
+    hash          = HashShaderBytecode(desc.GS, hash);
+    hash          = HashBytes(&desc.BlendState, sizeof(desc.BlendState), hash);
+    hash          = HashBytes(&desc.SampleMask, sizeof(desc.SampleMask), hash);
+    hash          = HashBytes(&desc.RasterizerState, sizeof(desc.RasterizerState), hash);
+    hash          = HashBytes(&desc.DepthStencilState, sizeof(desc.DepthStencilState), hash);
+    for (UINT i = 0; i < desc.InputLayout.NumElements; ++i) {
+        D3D12_INPUT_ELEMENT_DESC element = desc.InputLayout.pInputElementDescs[i];
+        if (!IsNull(element.SemanticName)) {
+            hash = HashBytes(element.SemanticName, strlen(element.SemanticName), hash);
+        }
+        element.SemanticName = nullptr;
+        hash                 = HashBytes(&element, sizeof(element), hash);
+    }
+    hash = HashBytes(&desc.IBStripCutValue, sizeof(desc.IBStripCutValue), hash);
+    hash = HashBytes(&desc.PrimitiveTopologyType, sizeof(desc.PrimitiveTopologyType), hash);
+    hash = HashBytes(&desc.NumRenderTargets, sizeof(desc.NumRenderTargets), hash);
+    hash = HashBytes(desc.RTVFormats, sizeof(desc.RTVFormats), hash);
+    hash = HashBytes(&desc.DSVFormat, sizeof(desc.DSVFormat), hash);
+    hash = HashBytes(&desc.SampleDesc, sizeof(desc.SampleDesc), hash);
+    hash = HashBytes(&desc.NodeMask, sizeof(desc.NodeMask), hash);
+    hash = HashBytes(&desc.Flags, sizeof(desc.Flags), hash);
+    return ToPipelineName("gfx", hash);
+}
+
+static std::wstring GetPipelineName(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc)
+{
+    uint64_t hash = 0;
+    hash          = HashShaderBytecode(desc.CS, hash);
+    hash          = HashBytes(&desc.NodeMask, sizeof(desc.NodeMask), hash);
+    hash          = HashBytes(&desc.Flags, sizeof(desc.Flags), hash);
+    return ToPipelineName("cs", hash);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Device
+// -------------------------------------------------------------------------------------------------
 void Device::LoadRootSignatureFunctions()
 {
     HMODULE module = ::GetModuleHandle(TEXT("d3d12.dll"));
@@ -136,6 +215,179 @@ Result Device::CreateQueues(const grfx::DeviceCreateInfo* pCreateInfo)
     return ppx::SUCCESS;
 }
 
+Result Device::CreatePipelineLibrary(const grfx::DeviceCreateInfo* pCreateInfo)
+{
+    if (!pCreateInfo->pipelineCachePath.empty() && fs::path_exists(pCreateInfo->pipelineCachePath)) {
+        auto data = fs::load_file(pCreateInfo->pipelineCachePath);
+        if (data.has_value()) {
+            mPipelineLibraryData = std::move(data.value());
+        }
+    }
+
+    HRESULT hr = E_FAIL;
+    if (!mPipelineLibraryData.empty()) {
+        // The runtime validates the blob against the adapter and driver and
+        // returns D3D12_ERROR_ADAPTER_NOT_FOUND or D3D12_ERROR_DRIVER_VERSION_MISMATCH
+        // if it was serialized somewhere else.
+        hr = mDevice->CreatePipelineLibrary(mPipelineLibraryData.data(), mPipelineLibraryData.size(), IID_PPV_ARGS(&mPipelineLibrary));
+        if (FAILED(hr)) {
+            PPX_LOG_WARN("Ignoring pipeline library created by a different GPU or driver: " << pCreateInfo->pipelineCachePath);
+            mPipelineLibraryData.clear();
+        }
+    }
+
+    if (FAILED(hr)) {
+        hr = mDevice->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&mPipelineLibrary));
+        if (FAILED(hr)) {
+            // Pipeline libraries are optional in older runtimes and some tools
+            // (e.g. capture layers) don't support them. Carry on without one.
+            PPX_LOG_WARN("ID3D12Device1::CreatePipelineLibrary failed, pipelines will not be cached");
+            mPipelineLibrary.Reset();
+            return ppx::SUCCESS;
+        }
+    }
+    PPX_LOG_OBJECT_CREATION(D3D12PipelineLibrary, mPipelineLibrary.Get());
+
+    PPX_LOG_INFO("D3D12 pipeline library loaded " << mPipelineLibraryData.size() << " bytes");
+
+    return ppx::SUCCESS;
+}
+
+Result Device::SavePipelineCache()
+{
+    std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+
+    if (!mPipelineLibrary || mCreateInfo.pipelineCachePath.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    const SIZE_T      size = mPipelineLibrary->GetSerializedSize();
+    std::vector<char> data(size);
+    HRESULT           hr = mPipelineLibrary->Serialize(data.data(), size);
+    if (FAILED(hr)) {
+        PPX_LOG_ERROR("ID3D12PipelineLibrary::Serialize failed");
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    std::ofstream os(mCreateInfo.pipelineCachePath, std::ios::binary | std::ios::trunc);
+    if (!os.is_open()) {
+        PPX_LOG_ERROR("Unable to open pipeline cache file for writing: " << mCreateInfo.pipelineCachePath);
+        return ppx::ERROR_FAILED;
+    }
+    os.write(data.data(), static_cast<std::streamsize>(size));
+    os.close();
+
+    PPX_LOG_INFO("D3D12 pipeline library saved " << size << " bytes to " << mCreateInfo.pipelineCachePath);
+
+    return ppx::SUCCESS;
+}
+
+HRESULT Device::CreateGraphicsPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc, D3D12PipelineStatePtr& pipelineState)
+{
+    if (!mPipelineLibrary) {
+        return mDevice->CreateGraphicsPipelineState(pDesc, IID_PPV_ARGS(&pipelineState));
+    }
+
+    const std::wstring name = GetPipelineName(*pDesc);
+
+    HRESULT hr = E_FAIL;
+    {
+        std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+        hr = mPipelineLibrary->LoadGraphicsPipeline(name.c_str(), pDesc, IID_PPV_ARGS(&pipelineState));
+    }
+    if (SUCCEEDED(hr)) {
+        return hr;
+    }
+
+    // Compile outside the lock so async pipeline creation isn't serialized
+    hr = mDevice->CreateGraphicsPipelineState(pDesc, IID_PPV_ARGS(&pipelineState));
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+
+    // StorePipeline fails with E_INVALIDARG if the name is already taken by a
+    // PSO with a different root signature. That only costs a cache miss.
+    if (FAILED(mPipelineLibrary->StorePipeline(name.c_str(), pipelineState.Get()))) {
+        PPX_LOG_WARN("ID3D12PipelineLibrary::StorePipeline failed for graphics pipeline");
+    }
+
+    return hr;
+}
+
+HRESULT Device::CreatePipelineState(const D3D12_PIPELINE_STATE_STREAM_DESC* pDesc, D3D12PipelineStatePtr& pipelineState)
+{
+    // Stream descriptions would need ID3D12PipelineLibrary1 and a hash
+    // of every subobject, these aren't cached.
+    return mDevice->CreatePipelineState(pDesc, IID_PPV_ARGS(&pipelineState));
+}
+
+HRESULT Device::CreateComputePipelineState(const D3D12_COMPUTE_PIPELINE_STATE_DESC* pDesc, D3D12PipelineStatePtr& pipelineState)
+{
+    if (!mPipelineLibrary) {
+        return mDevice->CreateComputePipelineState(pDesc, IID_PPV_ARGS(&pipelineState));
+    }
+
+    const std::wstring name = GetPipelineName(*pDesc);
+
+    HRESULT hr = E_FAIL;
+    {
+        std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+        hr = mPipelineLibrary->LoadComputePipeline(name.c_str(), pDesc, IID_PPV_ARGS(&pipelineState));
+    }
+    if (SUCCEEDED(hr)) {
+        return hr;
+    }
+
+    // Compile outside the lock so async pipeline creation isn't serialized
+    hr = mDevice->CreateComputePipelineState(pDesc, IID_PPV_ARGS(&pipelineState));
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    std::lock_guard<std::mutex> lock(mPipelineLibraryMutex);
+
+    if (FAILED(mPipelineLibrary->StorePipeline(name.c_str(), pipelineState.Get()))) {
+        PPX_LOG_WARN("ID3D12PipelineLibrary::StorePipeline failed for compute pipeline");
+    }
+
+    return hr;
+}
+
+HRESULT Device::GetCommandSignature(D3D12_INDIRECT_ARGUMENT_TYPE type, UINT stride, ID3D12CommandSignature** ppSignature)
+{
+    const uint64_t key = (static_cast<uint64_t>(type) << 32) | static_cast<uint64_t>(stride);
+
+    std::lock_guard<std::mutex> lock(mCommandSignatureMutex);
+
+    auto it = mCommandSignatures.find(key);
+    if (it == mCommandSignatures.end()) {
+        D3D12_INDIRECT_ARGUMENT_DESC argument = {};
+        argument.Type                         = type;
+
+        // Root signature isn't needed since the arguments don't change any
+        // root parameters
+        D3D12_COMMAND_SIGNATURE_DESC desc = {};
+        desc.ByteStride                   = stride;
+        desc.NumArgumentDescs             = 1;
+        desc.pArgumentDescs               = &argument;
+        desc.NodeMask                     = 0;
+
+        D3D12CommandSignaturePtr signature;
+        HRESULT                  hr = mDevice->CreateCommandSignature(&desc, nullptr, IID_PPV_ARGS(&signature));
+        if (FAILED(hr)) {
+            return hr;
+        }
+        PPX_LOG_OBJECT_CREATION(D3D12CommandSignature, signature.Get());
+
+        it = mCommandSignatures.emplace(key, signature).first;
+    }
+
+    *ppSignature = it->second.Get();
+    return S_OK;
+}
+
 Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
 {
     // Feature level
@@ -169,6 +421,19 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         }
     }
 
+    // Check for tiled resources, used for sparse residency
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS featureSupport{};
+
+        hr = mDevice->CheckFeatureSupport(
+            D3D12_FEATURE_D3D12_OPTIONS,
+            &featureSupport,
+            sizeof(featureSupport));
+
+        mTiledResourcesTier = SUCCEEDED(hr) ? featureSupport.TiledResourcesTier : D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED;
+        PPX_LOG_INFO("D3D12 tiled resources tier: " << static_cast<uint32_t>(mTiledResourcesTier));
+    }
+
     // Check for Dynamic Rendering capabilities: render passes in DX12 lingo
     {
         D3D12_FEATURE_DATA_D3D12_OPTIONS5 featureSupport{};
@@ -184,7 +449,39 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         }
 
         mRenderPassTier = featureSupport.RenderPassesTier;
+        mRaytracingTier = featureSupport.RaytracingTier;
+        PPX_LOG_INFO("D3D12 raytracing tier: " << static_cast<uint32_t>(mRaytracingTier));
     }
+
+    // Check for mesh shaders, OPTIONS7 is unknown to older runtimes
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS7 featureSupport{};
+
+        hr = mDevice->CheckFeatureSupport(
+            D3D12_FEATURE_D3D12_OPTIONS7,
+            &featureSupport,
+            sizeof(featureSupport));
+
+        mMeshShaderTier = SUCCEEDED(hr) ? featureSupport.MeshShaderTier : D3D12_MESH_SHADER_TIER_NOT_SUPPORTED;
+        PPX_LOG_INFO("D3D12 mesh shader is present: " << (mMeshShaderTier != D3D12_MESH_SHADER_TIER_NOT_SUPPORTED));
+    }
+
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+    // Check for enhanced barriers, OPTIONS12 is unknown to runtimes older
+    // than the Agility SDK that added it
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS12 featureSupport{};
+
+        hr = mDevice->CheckFeatureSupport(
+            D3D12_FEATURE_D3D12_OPTIONS12,
+            &featureSupport,
+            sizeof(featureSupport));
+
+        mEnhancedBarriers = SUCCEEDED(hr) && featureSupport.EnhancedBarriersSupported;
+    }
+#endif
+    PPX_LOG_INFO("D3D12 enhanced barriers is present: " << mEnhancedBarriers);
+
     // Create D3D12MA allocator
     {
         D3D12MA::ALLOCATOR_FLAGS flags = D3D12MA::ALLOCATOR_FLAG_NONE;
@@ -218,11 +515,32 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         }
     }
 
+    // Shader visible descriptor rings
+    {
+        // CBVSRVUAV
+        Result ppxres = mDescriptorRingCBVSRVUAV.Create(this, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, dx12::DESCRIPTOR_RING_SIZE_CBVSRVUAV);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Sampler
+        ppxres = mDescriptorRingSampler.Create(this, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, dx12::DESCRIPTOR_RING_SIZE_SAMPLER);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
     // Load root signature functions
     LoadRootSignatureFunctions();
 
+    // Pipeline library
+    Result ppxres = CreatePipelineLibrary(pCreateInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
     // Create queues
-    Result ppxres = CreateQueues(pCreateInfo);
+    ppxres = CreateQueues(pCreateInfo);
     if (Failed(ppxres)) {
         return ppxres;
     }
@@ -259,12 +577,22 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
 
 void Device::DestroyApiObjects()
 {
+    if (mPipelineLibrary) {
+        SavePipelineCache();
+        mPipelineLibrary.Reset();
+    }
+    mPipelineLibraryData.clear();
+
+    mCommandSignatures.clear();
+
     mFnD3D12CreateRootSignatureDeserializer          = nullptr;
     mFnD3D12SerializeVersionedRootSignature          = nullptr;
     mFnD3D12CreateVersionedRootSignatureDeserializer = nullptr;
 
     mRTVHandleManager.Destroy();
     mDSVHandleManager.Destroy();
+    mDescriptorRingCBVSRVUAV.Destroy();
+    mDescriptorRingSampler.Destroy();
 
     if (mAllocator) {
         mAllocator->Release();
@@ -362,6 +690,16 @@ HRESULT Device::CreateVersionedRootSignatureDeserializer(
     return hr;
 }
 
+Result Device::AllocateObject(grfx::AccelerationStructure** ppObject)
+{
+    dx12::AccelerationStructure* pObject = new dx12::AccelerationStructure();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::AllocateObject(grfx::Buffer** ppObject)
 {
     dx12::Buffer* pObject = new dx12::Buffer();
@@ -649,6 +987,16 @@ bool Device::FragmentStoresAndAtomicsSupported() const
     return true;
 }
 
+bool Device::TessellationShaderSupported() const
+{
+    return true;
+}
+
+bool Device::GeometryShaderSupported() const
+{
+    return true;
+}
+
 bool Device::PartialDescriptorBindingsSupported() const
 {
     PPX_LOG_WARN(
@@ -657,6 +1005,12 @@ bool Device::PartialDescriptorBindingsSupported() const
     return true;
 }
 
+bool Device::PushDescriptorsSupported() const
+{
+    // Root descriptors
+    return true;
+}
+
 bool Device::IndexTypeUint8Supported() const
 {
     // R8_UINT is not supported for "Input Assembler Index Buffer", only R16_UINT and R32_UINT
@@ -664,6 +1018,210 @@ bool Device::IndexTypeUint8Supported() const
     return false;
 }
 
+bool Device::DrawIndirectCountSupported() const
+{
+    // ExecuteIndirect always takes an optional count buffer
+    return true;
+}
+
+bool Device::MeshShaderSupported() const
+{
+    return mMeshShaderTier != D3D12_MESH_SHADER_TIER_NOT_SUPPORTED;
+}
+
+bool Device::AmplificationShaderSupported() const
+{
+    // Amplification shaders are part of mesh shader tier 1
+    return MeshShaderSupported();
+}
+
+bool Device::AccelerationStructureSupported() const
+{
+    return mRaytracingTier >= D3D12_RAYTRACING_TIER_1_0;
+}
+
+bool Device::BufferDeviceAddressSupported() const
+{
+    // Every D3D12 buffer has a GPU virtual address
+    return true;
+}
+
+bool Device::RayQuerySupported() const
+{
+    // Inline ray tracing was added in tier 1.1
+    return mRaytracingTier >= D3D12_RAYTRACING_TIER_1_1;
+}
+
+bool Device::TimelineSemaphoreSupported() const
+{
+    // Fences are timelines
+    return true;
+}
+
+bool Device::ExtendedDynamicStateSupported() const
+{
+    // Cull mode and depth state are part of the pipeline state object
+    return false;
+}
+
+bool Device::DynamicBlendEnableSupported() const
+{
+    return false;
+}
+
+bool Device::ShaderObjectsSupported() const
+{
+    // D3D12 only has pipeline state objects
+    return false;
+}
+
+bool Device::DescriptorBuffersEnabled() const
+{
+    // Descriptor heaps are already written directly and bound by offset
+    return false;
+}
+
+bool Device::ConditionalRenderingSupported() const
+{
+    // SetPredication is core
+    return true;
+}
+
+bool Device::ImageHostUploadSupported(grfx::ImageHostUpload hostUpload, grfx::Format format) const
+{
+    // Images are only created in default heaps
+    return (hostUpload == grfx::IMAGE_HOST_UPLOAD_NONE);
+}
+
+bool Device::SampledImageFormatSupported(grfx::Format format) const
+{
+    D3D12_FEATURE_DATA_FORMAT_SUPPORT featureData = {dx::ToDxgiFormat(format)};
+
+    HRESULT hr = mDevice->CheckFeatureSupport(
+        D3D12_FEATURE_FORMAT_SUPPORT,
+        &featureData,
+        sizeof(featureData));
+    if (FAILED(hr)) {
+        return false;
+    }
+
+    const D3D12_FORMAT_SUPPORT1 required = D3D12_FORMAT_SUPPORT1_TEXTURE2D | D3D12_FORMAT_SUPPORT1_SHADER_SAMPLE;
+    return (featureData.Support1 & required) == required;
+}
+
+bool Device::RenderTargetSampleCountSupported(grfx::Format format, grfx::SampleCount sampleCount) const
+{
+    D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS featureData = {};
+    featureData.Format                                        = dx::ToDxgiFormat(format);
+    featureData.SampleCount                                   = static_cast<UINT>(sampleCount);
+    featureData.Flags                                         = D3D12_MULTISAMPLE_QUALITY_LEVELS_FLAG_NONE;
+
+    HRESULT hr = mDevice->CheckFeatureSupport(
+        D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS,
+        &featureData,
+        sizeof(featureData));
+    if (FAILED(hr)) {
+        return false;
+    }
+    return featureData.NumQualityLevels > 0;
+}
+
+bool Device::RenderTargetBlendSupported(grfx::Format format) const
+{
+    D3D12_FEATURE_DATA_FORMAT_SUPPORT featureData = {dx::ToDxgiFormat(format)};
+
+    HRESULT hr = mDevice->CheckFeatureSupport(
+        D3D12_FEATURE_FORMAT_SUPPORT,
+        &featureData,
+        sizeof(featureData));
+    if (FAILED(hr)) {
+        return false;
+    }
+
+    const D3D12_FORMAT_SUPPORT1 required = D3D12_FORMAT_SUPPORT1_RENDER_TARGET | D3D12_FORMAT_SUPPORT1_BLENDABLE;
+    return (featureData.Support1 & required) == required;
+}
+
+bool Device::ImageCompressionSupported(grfx::Format format, grfx::ImageCompression compression) const
+{
+    // D3D12 has no control over framebuffer compression
+    return (compression == grfx::IMAGE_COMPRESSION_DEFAULT);
+}
+
+bool Device::SparseResidencySupported() const
+{
+    // Tier 2 adds the residency status of samples and returns zero for
+    // unmapped tiles
+    return mTiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_2;
+}
+
+Result Device::GetAccelerationStructureBuildSizes(const grfx::AccelerationStructureBuildInputs* pInputs, grfx::AccelerationStructureBuildSizes* pSizes) const
+{
+    PPX_ASSERT_NULL_ARG(pInputs);
+    PPX_ASSERT_NULL_ARG(pSizes);
+
+    if (!AccelerationStructureSupported()) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    dx12::AccelerationStructureBuildGeometry geometry = {};
+    Result                                   ppxres   = ToD3D12AccelerationStructureBuildGeometry(pInputs, false, &geometry);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO prebuildInfo = {};
+    mDevice->GetRaytracingAccelerationStructurePrebuildInfo(&geometry.inputs, &prebuildInfo);
+
+    pSizes->accelerationStructureSize = static_cast<uint64_t>(prebuildInfo.ResultDataMaxSizeInBytes);
+    pSizes->buildScratchSize          = static_cast<uint64_t>(prebuildInfo.ScratchDataSizeInBytes);
+    pSizes->updateScratchSize         = static_cast<uint64_t>(prebuildInfo.UpdateScratchDataSizeInBytes);
+
+    return ppx::SUCCESS;
+}
+
+Result Device::GetMemoryStatistics(grfx::MemoryStatistics* pStatistics) const
+{
+    PPX_ASSERT_NULL_ARG(pStatistics);
+
+    typename DXGIAdapterPtr::InterfaceType* pAdapter = ToApi(GetGpu())->GetDxAdapter();
+
+    DXGI_ADAPTER_DESC1 adapterDesc = {};
+    HRESULT            hr          = pAdapter->GetDesc1(&adapterDesc);
+    if (FAILED(hr)) {
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    // D3D12MA gets usage and budget from IDXGIAdapter3::QueryVideoMemoryInfo
+    // for the local and non-local segment groups.
+    D3D12MA::Budget localBudget    = {};
+    D3D12MA::Budget nonLocalBudget = {};
+    mAllocator->GetBudget(&localBudget, &nonLocalBudget);
+
+    const D3D12MA::Budget* pBudgets[2] = {&localBudget, &nonLocalBudget};
+    const uint64_t         sizes[2]    = {adapterDesc.DedicatedVideoMemory, adapterDesc.SharedSystemMemory};
+
+    pStatistics->heaps.resize(2);
+    for (uint32_t i = 0; i < 2; ++i) {
+        grfx::MemoryHeapStatistics& heap = pStatistics->heaps[i];
+        heap.deviceLocal                 = (i == 0);
+        heap.size                        = sizes[i];
+        heap.usage                       = pBudgets[i]->UsageBytes;
+        heap.budget                      = pBudgets[i]->BudgetBytes;
+        heap.blockCount                  = pBudgets[i]->Stats.BlockCount;
+        heap.allocationCount             = pBudgets[i]->Stats.AllocationCount;
+        heap.blockBytes                  = pBudgets[i]->Stats.BlockBytes;
+        heap.allocationBytes             = pBudgets[i]->Stats.AllocationBytes;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Device::DefragmentApiObjects(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats)
+{
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+}
+
 } // namespace dx12
 } // namespace grfx
 } // namespace ppx
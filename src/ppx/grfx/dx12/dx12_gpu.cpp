@@ -48,9 +48,57 @@ Result Gpu::CreateApiObjects(const grfx::internal::GpuCreateInfo* pCreateInfo)
     // Vendor
     mDeviceVendorId = static_cast<grfx::VendorId>(adapterDesc.VendorId);
 
+    // User mode driver version, four 16 bit parts
+    LARGE_INTEGER umdVersion = {};
+    if (SUCCEEDED(mGpu->CheckInterfaceSupport(__uuidof(IDXGIDevice), &umdVersion))) {
+        for (int shift = 48; shift >= 0; shift -= 16) {
+            mDriverVersion += std::to_string((umdVersion.QuadPart >> shift) & 0xFFFF);
+            if (shift > 0) {
+                mDriverVersion += ".";
+            }
+        }
+    }
+
+    QueryShaderCapabilities();
+
     return ppx::SUCCESS;
 }
 
+void Gpu::QueryShaderCapabilities()
+{
+    // Feature support is queried on a device, create a temporary one
+    D3D12DevicePtr device;
+    HRESULT        hr = D3D12CreateDevice(mGpu.Get(), GetFeatureLevel(), IID_PPV_ARGS(&device));
+    if (FAILED(hr)) {
+        return;
+    }
+
+    // Wave intrinsics are all or nothing in shader model 6.0
+    D3D12_FEATURE_DATA_D3D12_OPTIONS1 options1 = {};
+    hr                                         = device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS1, &options1, sizeof(options1));
+    if (SUCCEEDED(hr) && options1.WaveOps) {
+        grfx::SubgroupCapabilities& subgroup = mShaderCapabilities.subgroup;
+        subgroup.size                        = options1.WaveLaneCountMin;
+        subgroup.minSize                     = options1.WaveLaneCountMin;
+        subgroup.maxSize                     = options1.WaveLaneCountMax;
+        subgroup.allStages                   = true;
+        subgroup.basic                       = true;
+        subgroup.vote                        = true;
+        subgroup.arithmetic                  = true;
+        subgroup.ballot                      = true;
+        subgroup.shuffle                     = true;
+        subgroup.quad                        = true;
+    }
+
+    // 16 bit types cover both floats and integers
+    D3D12_FEATURE_DATA_D3D12_OPTIONS4 options4 = {};
+    hr                                         = device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS4, &options4, sizeof(options4));
+    if (SUCCEEDED(hr)) {
+        mShaderCapabilities.float16 = (options4.Native16BitShaderOpsSupported == TRUE);
+        mShaderCapabilities.int16   = (options4.Native16BitShaderOpsSupported == TRUE);
+    }
+}
+
 void Gpu::DestroyApiObjects()
 {
     if (mGpu) {
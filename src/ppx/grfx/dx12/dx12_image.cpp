@@ -14,6 +14,7 @@
 
 #include "ppx/grfx/dx12/dx12_image.h"
 #include "ppx/grfx/dx12/dx12_device.h"
+#include "ppx/grfx/dx12/dx12_queue.h"
 
 namespace ppx {
 namespace grfx {
@@ -22,6 +23,23 @@ namespace dx12 {
 // -------------------------------------------------------------------------------------------------
 // Image
 // -------------------------------------------------------------------------------------------------
+static Result AllocateTileMemory(D3D12MA::Allocator* pAllocator, UINT tileCount, D3D12MA::Allocation** ppAllocation)
+{
+    D3D12MA::ALLOCATION_DESC allocationDesc = {};
+    allocationDesc.HeapType                 = D3D12_HEAP_TYPE_DEFAULT;
+    allocationDesc.ExtraHeapFlags           = D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+    D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = {};
+    allocationInfo.SizeInBytes                    = static_cast<UINT64>(tileCount) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    allocationInfo.Alignment                      = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+
+    HRESULT hr = pAllocator->AllocateMemory(&allocationDesc, &allocationInfo, ppAllocation);
+    if (FAILED(hr)) {
+        return ppx::ERROR_OUT_OF_MEMORY;
+    }
+    return ppx::SUCCESS;
+}
+
 Image::~Image()
 {
 }
@@ -87,17 +105,66 @@ Result Image::CreateApiObjects(const grfx::ImageCreateInfo* pCreateInfo)
         }
 
         dx12::Device* pDevice = ToApi(GetDevice());
-        HRESULT       hr      = pDevice->GetAllocator()->CreateResource(
-            &allocationDesc,
-            &resourceDesc,
-            initialResourceState,
-            useClearValue ? &clearValue : nullptr,
-            &mAllocation,
-            IID_PPV_ARGS(&mResource));
-        if (FAILED(hr)) {
-            return ppx::ERROR_API_FAILURE;
+
+        if (pCreateInfo->sparseResidency) {
+            // Reserved resources have no memory until tiles are mapped
+            resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+
+            HRESULT hr = pDevice->GetDxDevice()->CreateReservedResource(
+                &resourceDesc,
+                initialResourceState,
+                useClearValue ? &clearValue : nullptr,
+                IID_PPV_ARGS(&mResource));
+            if (FAILED(hr)) {
+                return ppx::ERROR_API_FAILURE;
+            }
+            PPX_LOG_OBJECT_CREATION(D3D12Resource(Image | Reserved), mResource.Get());
+
+            Result ppxres = InitializeSparseResidency(pCreateInfo);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+        }
+        else if (!IsNull(pCreateInfo->pAliasImage)) {
+            // Placed resources can only alias allocations that live in a
+            // heap, committed allocations have none. Not asserting here:
+            // callers like grfx::RenderGraph fall back to a regular
+            // allocation if the memory doesn't fit.
+            D3D12MA::Allocation* pAliasAllocation = ToApi(pCreateInfo->pAliasImage)->GetAllocation();
+            if (IsNull(pAliasAllocation) || IsNull(pAliasAllocation->GetHeap())) {
+                return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+            }
+
+            D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = pDevice->GetDxDevice()->GetResourceAllocationInfo(0, 1, &resourceDesc);
+            if (allocationInfo.SizeInBytes > pAliasAllocation->GetSize()) {
+                return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+            }
+
+            HRESULT hr = pDevice->GetAllocator()->CreateAliasingResource(
+                pAliasAllocation,
+                0,
+                &resourceDesc,
+                initialResourceState,
+                useClearValue ? &clearValue : nullptr,
+                IID_PPV_ARGS(&mResource));
+            if (FAILED(hr)) {
+                return ppx::ERROR_API_FAILURE;
+            }
+            PPX_LOG_OBJECT_CREATION(D3D12Resource(Image | Aliased), mResource.Get());
+        }
+        else {
+            HRESULT hr = pDevice->GetAllocator()->CreateResource(
+                &allocationDesc,
+                &resourceDesc,
+                initialResourceState,
+                useClearValue ? &clearValue : nullptr,
+                &mAllocation,
+                IID_PPV_ARGS(&mResource));
+            if (FAILED(hr)) {
+                return ppx::ERROR_API_FAILURE;
+            }
+            PPX_LOG_OBJECT_CREATION(D3D12Resource(Image), mResource.Get());
         }
-        PPX_LOG_OBJECT_CREATION(D3D12Resource(Image), mResource.Get());
     }
     else {
         CComPtr<ID3D12Resource> resource = static_cast<ID3D12Resource*>(pCreateInfo->pApiObject);
@@ -132,6 +199,152 @@ void Image::DestroyApiObjects()
         mAllocation->Release();
         mAllocation.Reset();
     }
+
+    for (D3D12MA::Allocation* pAllocation : mSparseTileAllocations) {
+        if (!IsNull(pAllocation)) {
+            pAllocation->Release();
+        }
+    }
+    for (D3D12MA::Allocation* pAllocation : mFreeSparseTileAllocations) {
+        pAllocation->Release();
+    }
+    for (D3D12MA::Allocation* pAllocation : mPackedMipAllocations) {
+        pAllocation->Release();
+    }
+    mSparseTileAllocations.clear();
+    mFreeSparseTileAllocations.clear();
+    mPackedMipAllocations.clear();
+}
+
+Result Image::InitializeSparseResidency(const grfx::ImageCreateInfo* pCreateInfo)
+{
+    dx12::Device* pDevice = ToApi(GetDevice());
+
+    UINT                  tileCount     = 0;
+    D3D12_PACKED_MIP_INFO packedMipInfo = {};
+    D3D12_TILE_SHAPE      tileShape     = {};
+    pDevice->GetDxDevice()->GetResourceTiling(mResource.Get(), &tileCount, &packedMipInfo, &tileShape, nullptr, 0, nullptr);
+
+    mSparseProperties.tileWidth         = tileShape.WidthInTexels;
+    mSparseProperties.tileHeight        = tileShape.HeightInTexels;
+    mSparseProperties.tileSize          = D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    mSparseProperties.firstMipTailLevel = std::min(static_cast<uint32_t>(packedMipInfo.NumStandardMips), pCreateInfo->mipLevelCount);
+    mSparseProperties.mipTailSize       = 0;
+
+    if (packedMipInfo.NumPackedMips == 0) {
+        return ppx::SUCCESS;
+    }
+
+    // Each array layer has its own packed mips, mapped once and resident
+    // until the image is destroyed
+    ID3D12CommandQueue* pQueue = ToApi(GetDevice()->GetGraphicsQueue().Get())->GetDxQueue();
+    for (uint32_t layer = 0; layer < pCreateInfo->arrayLayerCount; ++layer) {
+        D3D12MA::Allocation* pAllocation = nullptr;
+
+        Result ppxres = AllocateTileMemory(pDevice->GetAllocator(), packedMipInfo.NumTilesForPackedMips, &pAllocation);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "packed mip allocation failed");
+            return ppxres;
+        }
+        mPackedMipAllocations.push_back(pAllocation);
+
+        D3D12_TILED_RESOURCE_COORDINATE coordinate = {};
+        coordinate.Subresource                     = D3D12CalcSubresource(packedMipInfo.NumStandardMips, layer, 0, pCreateInfo->mipLevelCount, pCreateInfo->arrayLayerCount);
+
+        D3D12_TILE_REGION_SIZE regionSize = {};
+        regionSize.NumTiles               = packedMipInfo.NumTilesForPackedMips;
+        regionSize.UseBox                 = FALSE;
+
+        D3D12_TILE_RANGE_FLAGS rangeFlags      = D3D12_TILE_RANGE_FLAG_NONE;
+        UINT                   heapRangeOffset = static_cast<UINT>(pAllocation->GetOffset() / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+        UINT                   rangeTileCount  = packedMipInfo.NumTilesForPackedMips;
+
+        pQueue->UpdateTileMappings(mResource.Get(), 1, &coordinate, &regionSize, pAllocation->GetHeap(), 1, &rangeFlags, &heapRangeOffset, &rangeTileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+
+        mSparseProperties.mipTailSize += static_cast<uint64_t>(packedMipInfo.NumTilesForPackedMips) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES;
+    }
+
+    // Matches Vulkan, where the mip tail is bound before the image is used
+    return GetDevice()->GetGraphicsQueue()->WaitIdle();
+}
+
+Result Image::UpdateSparseTileMappings(
+    ID3D12CommandQueue*              pQueue,
+    const grfx::SparseImageBindInfo* pBindInfo)
+{
+    PPX_ASSERT_NULL_ARG(pQueue);
+    PPX_ASSERT_NULL_ARG(pBindInfo);
+
+    // Indexed by GetSparseTileIndex(), which is only valid once the image
+    // has been created
+    if (mSparseTileAllocations.empty()) {
+        mSparseTileAllocations.assign(GetSparseTileCount(), nullptr);
+    }
+
+    // Allocate what unbinds and earlier unbinds don't give back before
+    // changing anything, so that a failed allocation leaves the image as is
+    size_t reusableCount = mFreeSparseTileAllocations.size() + pBindInfo->unbindTileCount;
+    size_t newCount      = (pBindInfo->bindTileCount > reusableCount) ? (pBindInfo->bindTileCount - reusableCount) : 0;
+    for (size_t i = 0; i < newCount; ++i) {
+        D3D12MA::Allocation* pAllocation = nullptr;
+
+        Result ppxres = AllocateTileMemory(ToApi(GetDevice())->GetAllocator(), 1, &pAllocation);
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("sparse tile allocation failed after " << i << " of " << newCount << " tiles");
+            return ppxres;
+        }
+        mFreeSparseTileAllocations.push_back(pAllocation);
+    }
+
+    auto UpdateTileMapping = [this, pQueue](const grfx::SparseImageTile& tile, D3D12MA::Allocation* pAllocation) {
+        D3D12_TILED_RESOURCE_COORDINATE coordinate = {};
+        coordinate.X                               = tile.x;
+        coordinate.Y                               = tile.y;
+        coordinate.Z                               = 0;
+        coordinate.Subresource                     = D3D12CalcSubresource(tile.mipLevel, tile.arrayLayer, 0, GetMipLevelCount(), GetArrayLayerCount());
+
+        D3D12_TILE_REGION_SIZE regionSize = {};
+        regionSize.NumTiles               = 1;
+        regionSize.UseBox                 = FALSE;
+
+        D3D12_TILE_RANGE_FLAGS rangeFlags      = IsNull(pAllocation) ? D3D12_TILE_RANGE_FLAG_NULL : D3D12_TILE_RANGE_FLAG_NONE;
+        UINT                   heapRangeOffset = IsNull(pAllocation) ? 0 : static_cast<UINT>(pAllocation->GetOffset() / D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES);
+        UINT                   rangeTileCount  = 1;
+
+        pQueue->UpdateTileMappings(
+            mResource.Get(),
+            1,
+            &coordinate,
+            &regionSize,
+            IsNull(pAllocation) ? nullptr : pAllocation->GetHeap(),
+            1,
+            &rangeFlags,
+            &heapRangeOffset,
+            &rangeTileCount,
+            D3D12_TILE_MAPPING_FLAG_NONE);
+    };
+
+    for (uint32_t i = 0; i < pBindInfo->unbindTileCount; ++i) {
+        const grfx::SparseImageTile& tile  = pBindInfo->pUnbindTiles[i];
+        const uint32_t               index = GetSparseTileIndex(tile);
+        PPX_ASSERT_MSG(!IsNull(mSparseTileAllocations[index]), "unbinding a sparse tile without memory");
+
+        mFreeSparseTileAllocations.push_back(mSparseTileAllocations[index]);
+        mSparseTileAllocations[index] = nullptr;
+        UpdateTileMapping(tile, nullptr);
+    }
+
+    for (uint32_t i = 0; i < pBindInfo->bindTileCount; ++i) {
+        const grfx::SparseImageTile& tile  = pBindInfo->pBindTiles[i];
+        const uint32_t               index = GetSparseTileIndex(tile);
+        PPX_ASSERT_MSG(IsNull(mSparseTileAllocations[index]), "binding a sparse tile that has memory");
+
+        mSparseTileAllocations[index] = mFreeSparseTileAllocations.back();
+        mFreeSparseTileAllocations.pop_back();
+        UpdateTileMapping(tile, mSparseTileAllocations[index]);
+    }
+
+    return ppx::SUCCESS;
 }
 
 Result Image::MapMemory(uint64_t offset, void** ppMappedAddress)
@@ -145,6 +358,17 @@ void Image::UnmapMemory()
     PPX_ASSERT_MSG(false, "memory mapping of textures is not availalble in D3D12");
 }
 
+Result Image::CopyFromHost(
+    uint32_t    mipLevel,
+    uint32_t    arrayLayer,
+    const void* pSrcData,
+    uint32_t    srcRowStride)
+{
+    // Device::ImageHostUploadSupported() doesn't allow creating these images
+    PPX_ASSERT_MSG(false, "host upload of images is not available in D3D12");
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+}
+
 // -------------------------------------------------------------------------------------------------
 // Sampler
 // -------------------------------------------------------------------------------------------------
@@ -22,11 +22,44 @@ namespace ppx {
 namespace grfx {
 namespace dx12 {
 
+// Pipeline state stream subobjects must be pointer aligned
+template <D3D12_PIPELINE_STATE_SUBOBJECT_TYPE Type, typename T>
+struct alignas(void*) PipelineStateSubobject
+{
+    D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type  = Type;
+    T                                   value = {};
+};
+
+struct MeshPipelineStateStream
+{
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, ID3D12RootSignature*>         rootSignature;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS, D3D12_SHADER_BYTECODE>                    AS;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS, D3D12_SHADER_BYTECODE>                    MS;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, D3D12_SHADER_BYTECODE>                    PS;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND, D3D12_BLEND_DESC>                      blendState;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, UINT>                            sampleMask;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER, D3D12_RASTERIZER_DESC>            rasterizerState;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL, D3D12_DEPTH_STENCIL_DESC>      depthStencilState;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS, D3D12_RT_FORMAT_ARRAY> renderTargetFormats;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, DXGI_FORMAT>            depthStencilFormat;
+    PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC, DXGI_SAMPLE_DESC>                sampleDesc;
+};
+
+static void WarnSpecializationConstants(const grfx::ShaderStageInfo& stage)
+{
+    // DXIL has no specialization constants, the shader's defaults apply
+    if (!stage.specializationConstants.empty()) {
+        PPX_LOG_WARN("specialization constants are ignored on D3D12 (entry point: " << stage.entryPoint << ")");
+    }
+}
+
 // -------------------------------------------------------------------------------------------------
 // ComputePipeline
 // -------------------------------------------------------------------------------------------------
 Result ComputePipeline::CreateApiObjects(const grfx::ComputePipelineCreateInfo* pCreateInfo)
 {
+    WarnSpecializationConstants(pCreateInfo->CS);
+
     D3D12_COMPUTE_PIPELINE_STATE_DESC desc = {};
     desc.pRootSignature                    = ToApi(pCreateInfo->pPipelineInterface)->GetDxRootSignature().Get();
     desc.CS.pShaderBytecode                = ToApi(pCreateInfo->CS.pModule)->GetCode();
@@ -35,7 +68,7 @@ Result ComputePipeline::CreateApiObjects(const grfx::ComputePipelineCreateInfo*
     desc.CachedPSO                         = {};
     desc.Flags                             = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-    HRESULT hr = ToApi(GetDevice())->GetDxDevice()->CreateComputePipelineState(&desc, IID_PPV_ARGS(&mPipeline));
+    HRESULT hr = ToApi(GetDevice())->CreateComputePipelineState(&desc, mPipeline);
     if (FAILED(hr)) {
         PPX_ASSERT_MSG(false, "ID3D12Device::CreateComputePipelineState failed");
         return ppx::ERROR_API_FAILURE;
@@ -195,11 +228,48 @@ void GraphicsPipeline::InitializeOutput(
     desc.DSVFormat = dx::ToDxgiFormat(pCreateInfo->outputState.depthStencilFormat);
 }
 
+HRESULT GraphicsPipeline::CreateMeshPipelineState(
+    const grfx::GraphicsPipelineCreateInfo*   pCreateInfo,
+    const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc)
+{
+    MeshPipelineStateStream stream  = {};
+    stream.rootSignature.value      = desc.pRootSignature;
+    stream.PS.value                 = desc.PS;
+    stream.blendState.value         = desc.BlendState;
+    stream.sampleMask.value         = desc.SampleMask;
+    stream.rasterizerState.value    = desc.RasterizerState;
+    stream.depthStencilState.value  = desc.DepthStencilState;
+    stream.depthStencilFormat.value = desc.DSVFormat;
+    stream.sampleDesc.value         = desc.SampleDesc;
+
+    // An empty amplification shader is the same as none
+    if (!IsNull(pCreateInfo->AS.pModule)) {
+        stream.AS.value.pShaderBytecode = ToApi(pCreateInfo->AS.pModule)->GetCode();
+        stream.AS.value.BytecodeLength  = ToApi(pCreateInfo->AS.pModule)->GetSize();
+    }
+    stream.MS.value.pShaderBytecode = ToApi(pCreateInfo->MS.pModule)->GetCode();
+    stream.MS.value.BytecodeLength  = ToApi(pCreateInfo->MS.pModule)->GetSize();
+
+    stream.renderTargetFormats.value.NumRenderTargets = desc.NumRenderTargets;
+    for (UINT i = 0; i < desc.NumRenderTargets; ++i) {
+        stream.renderTargetFormats.value.RTFormats[i] = desc.RTVFormats[i];
+    }
+
+    D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = {};
+    streamDesc.SizeInBytes                      = sizeof(stream);
+    streamDesc.pPipelineStateSubobjectStream    = &stream;
+
+    return ToApi(GetDevice())->CreatePipelineState(&streamDesc, mPipeline);
+}
+
 Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo* pCreateInfo)
 {
     D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
     desc.pRootSignature                     = ToApi(pCreateInfo->pPipelineInterface)->GetDxRootSignature().Get();
 
+    for (const grfx::ShaderStageInfo* pStage : {&pCreateInfo->VS, &pCreateInfo->HS, &pCreateInfo->DS, &pCreateInfo->GS, &pCreateInfo->PS}) {
+        WarnSpecializationConstants(*pStage);
+    }
     InitializeShaderStages(pCreateInfo, desc);
 
     desc.StreamOutput = {};
@@ -231,12 +301,22 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
     desc.CachedPSO = {};
     desc.Flags     = D3D12_PIPELINE_STATE_FLAG_NONE;
 
-    HRESULT hr = ToApi(GetDevice())->GetDxDevice()->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&mPipeline));
-    if (FAILED(hr)) {
-        PPX_ASSERT_MSG(false, "ID3D12Device::CreateGraphicsPipelineState failed");
-        return ppx::ERROR_API_FAILURE;
+    if (!IsNull(pCreateInfo->MS.pModule)) {
+        HRESULT hr = CreateMeshPipelineState(pCreateInfo, desc);
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12Device2::CreatePipelineState failed (mesh shader)");
+            return ppx::ERROR_API_FAILURE;
+        }
+        PPX_LOG_OBJECT_CREATION(D3D12PipelineState(Mesh), mPipeline.Get());
+    }
+    else {
+        HRESULT hr = ToApi(GetDevice())->CreateGraphicsPipelineState(&desc, mPipeline);
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12Device::CreateGraphicsPipelineState failed");
+            return ppx::ERROR_API_FAILURE;
+        }
+        PPX_LOG_OBJECT_CREATION(D3D12PipelineState(Graphics), mPipeline.Get());
     }
-    PPX_LOG_OBJECT_CREATION(D3D12PipelineState(Graphics), mPipeline.Get());
 
     // clang-format off
     switch (pCreateInfo->inputAssemblyState.topology) {
@@ -251,7 +331,7 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
         case grfx::PRIMITIVE_TOPOLOGY_POINT_LIST     : mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_POINTLIST; break;
         case grfx::PRIMITIVE_TOPOLOGY_LINE_LIST      : mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_LINELIST; break;
         case grfx::PRIMITIVE_TOPOLOGY_LINE_STRIP     : mPrimitiveTopology = D3D_PRIMITIVE_TOPOLOGY_LINESTRIP; break;
-        case grfx::PRIMITIVE_TOPOLOGY_PATCH_LIST     : break;
+        case grfx::PRIMITIVE_TOPOLOGY_PATCH_LIST     : mPrimitiveTopology = static_cast<D3D_PRIMITIVE_TOPOLOGY>(D3D_PRIMITIVE_TOPOLOGY_1_CONTROL_POINT_PATCHLIST + pCreateInfo->tessellationState.patchControlPoints - 1); break;
     }
     // clang-format on
 
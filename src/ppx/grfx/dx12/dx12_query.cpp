@@ -52,6 +52,37 @@ uint32_t Query::GetQueryTypeSize(D3D12_QUERY_HEAP_TYPE type) const
 
 Result Query::CreateApiObjects(const grfx::QueryCreateInfo* pCreateInfo)
 {
+    if (pCreateInfo->type == grfx::QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE) {
+        const uint64_t size = static_cast<uint64_t>(GetCount()) * sizeof(D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_COMPACTED_SIZE_DESC);
+
+        grfx::BufferCreateInfo createInfo           = {};
+        createInfo.size                             = size;
+        createInfo.usageFlags.bits.rawStorageBuffer = true;
+        createInfo.usageFlags.bits.transferSrc      = true;
+        createInfo.memoryUsage                      = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                     = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+        createInfo.ownership                        = grfx::OWNERSHIP_REFERENCE;
+
+        Result ppxres = GetDevice()->CreateBuffer(&createInfo, &mPostbuildInfoBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        createInfo              = {};
+        createInfo.size         = size;
+        createInfo.usageFlags   = grfx::BUFFER_USAGE_TRANSFER_DST;
+        createInfo.memoryUsage  = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        createInfo.initialState = grfx::RESOURCE_STATE_COPY_DST;
+        createInfo.ownership    = grfx::OWNERSHIP_REFERENCE;
+
+        ppxres = GetDevice()->CreateBuffer(&createInfo, &mBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        return ppx::SUCCESS;
+    }
+
     D3D12_QUERY_HEAP_DESC desc = {};
     desc.Type                  = ToD3D12QueryHeapType(pCreateInfo->type);
     desc.Count                 = static_cast<UINT>(pCreateInfo->count);
@@ -92,6 +123,10 @@ void Query::DestroyApiObjects()
     if (mBuffer) {
         mBuffer.Reset();
     }
+
+    if (mPostbuildInfoBuffer) {
+        mPostbuildInfoBuffer.Reset();
+    }
 }
 
 void Query::Reset(uint32_t firstQuery, uint32_t queryCount)
@@ -15,6 +15,7 @@
 #include "ppx/grfx/dx12/dx12_queue.h"
 #include "ppx/grfx/dx12/dx12_command.h"
 #include "ppx/grfx/dx12/dx12_device.h"
+#include "ppx/grfx/dx12/dx12_image.h"
 #include "ppx/grfx/dx12/dx12_sync.h"
 
 namespace ppx {
@@ -44,6 +45,12 @@ Result Queue::CreateApiObjects(const grfx::internal::QueueCreateInfo* pCreateInf
         return ppxres;
     }
 
+    hr = ToApi(GetDevice())->GetDxDevice()->CreateFence(mSubmitFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mSubmitFence));
+    if (FAILED(hr)) {
+        PPX_ASSERT_MSG(false, "ID3D12Device::CreateFence(submit) failed");
+        return ppx::ERROR_API_FAILURE;
+    }
+
     return ppx::SUCCESS;
 }
 
@@ -55,6 +62,10 @@ void Queue::DestroyApiObjects()
         mWaitIdleFence.Reset();
     }
 
+    if (mSubmitFence) {
+        mSubmitFence.Reset();
+    }
+
     if (mCommandQueue) {
         mCommandQueue.Reset();
     }
@@ -74,55 +85,105 @@ Result Queue::WaitIdle()
 
 Result Queue::Submit(const grfx::SubmitInfo* pSubmitInfo)
 {
-    if (mListBuffer.size() < pSubmitInfo->commandBufferCount) {
-        mListBuffer.resize(pSubmitInfo->commandBufferCount);
+    return SubmitBatch(1, pSubmitInfo);
+}
+
+Result Queue::ExecutePendingLists()
+{
+    if (mListBuffer.empty()) {
+        return ppx::SUCCESS;
     }
 
-    for (uint32_t i = 0; i < pSubmitInfo->commandBufferCount; ++i) {
-        mListBuffer[i] = ToApi(pSubmitInfo->ppCommandBuffers[i])->GetDxCommandList();
+    mCommandQueue->ExecuteCommandLists(CountU32(mListBuffer), mListBuffer.data());
+
+    // Keep the command buffers' descriptors alive until the GPU is done
+    HRESULT hr = mCommandQueue->Signal(mSubmitFence.Get(), ++mSubmitFenceValue);
+    if (FAILED(hr)) {
+        PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal(submit) failed");
+        return ppx::ERROR_API_FAILURE;
     }
 
-    // Wait semaphores
-    for (uint32_t i = 0; i < pSubmitInfo->waitSemaphoreCount; ++i) {
-        auto         pSemaphore = ToApi(pSubmitInfo->ppWaitSemaphores[i]);
-        ID3D12Fence* pDxFence   = pSemaphore->GetDxFence();
-        UINT64       value      = pSemaphore->IsTimeline() ? pSubmitInfo->waitValues[i] : pSemaphore->GetWaitForValue();
+    for (const dx12::CommandBuffer* pCommandBuffer : mPendingCommandBuffers) {
+        pCommandBuffer->SetSubmitFence(mSubmitFence.Get(), mSubmitFenceValue);
+    }
 
-        HRESULT hr = mCommandQueue->Wait(pDxFence, value);
-        if (FAILED(hr)) {
-            PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Wait failed");
-            return ppx::ERROR_API_FAILURE;
+    mListBuffer.clear();
+    mPendingCommandBuffers.clear();
+
+    return ppx::SUCCESS;
+}
+
+Result Queue::SubmitBatch(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos)
+{
+    // Command lists of consecutive submits are executed together, waits
+    // and signals split the batch since they're queue operations of
+    // their own.
+    mListBuffer.clear();
+    mPendingCommandBuffers.clear();
+
+    for (uint32_t n = 0; n < submitCount; ++n) {
+        const grfx::SubmitInfo* pSubmitInfo = &pSubmitInfos[n];
+
+        // Wait semaphores
+        if (pSubmitInfo->waitSemaphoreCount > 0) {
+            Result ppxres = ExecutePendingLists();
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
         }
-    }
+        for (uint32_t i = 0; i < pSubmitInfo->waitSemaphoreCount; ++i) {
+            auto         pSemaphore = ToApi(pSubmitInfo->ppWaitSemaphores[i]);
+            ID3D12Fence* pDxFence   = pSemaphore->GetDxFence();
+            UINT64       value      = pSemaphore->IsTimeline() ? pSubmitInfo->waitValues[i] : pSemaphore->GetWaitForValue();
 
-    mCommandQueue->ExecuteCommandLists(
-        static_cast<UINT>(pSubmitInfo->commandBufferCount),
-        mListBuffer.data());
+            HRESULT hr = mCommandQueue->Wait(pDxFence, value);
+            if (FAILED(hr)) {
+                PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Wait failed");
+                return ppx::ERROR_API_FAILURE;
+            }
+        }
 
-    // Signal semaphores
-    for (uint32_t i = 0; i < pSubmitInfo->signalSemaphoreCount; ++i) {
-        auto         pSemaphore = ToApi(pSubmitInfo->ppSignalSemaphores[i]);
-        ID3D12Fence* pDxFence   = pSemaphore->GetDxFence();
-        UINT64       value      = pSemaphore->IsTimeline() ? pSubmitInfo->signalValues[i] : pSemaphore->GetNextSignalValue();
+        // Submits with only semaphores and fences are allowed
+        for (uint32_t i = 0; i < pSubmitInfo->commandBufferCount; ++i) {
+            const dx12::CommandBuffer* pCommandBuffer = ToApi(pSubmitInfo->ppCommandBuffers[i]);
+            mListBuffer.push_back(pCommandBuffer->GetDxCommandList());
+            mPendingCommandBuffers.push_back(pCommandBuffer);
+        }
 
-        HRESULT hr = mCommandQueue->Signal(pDxFence, value);
-        if (FAILED(hr)) {
-            PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal failed");
-            return ppx::ERROR_API_FAILURE;
+        if ((pSubmitInfo->signalSemaphoreCount == 0) && IsNull(pSubmitInfo->pFence)) {
+            continue;
         }
-    }
 
-    if (!IsNull(pSubmitInfo->pFence)) {
-        dx12::Fence* pFence = ToApi(pSubmitInfo->pFence);
-        UINT64       value  = pFence->GetNextSignalValue();
-        HRESULT      hr     = mCommandQueue->Signal(pFence->GetDxFence(), value);
-        if (FAILED(hr)) {
-            PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal failed");
-            return ppx::ERROR_API_FAILURE;
+        Result ppxres = ExecutePendingLists();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Signal semaphores
+        for (uint32_t i = 0; i < pSubmitInfo->signalSemaphoreCount; ++i) {
+            auto         pSemaphore = ToApi(pSubmitInfo->ppSignalSemaphores[i]);
+            ID3D12Fence* pDxFence   = pSemaphore->GetDxFence();
+            UINT64       value      = pSemaphore->IsTimeline() ? pSubmitInfo->signalValues[i] : pSemaphore->GetNextSignalValue();
+
+            HRESULT hr = mCommandQueue->Signal(pDxFence, value);
+            if (FAILED(hr)) {
+                PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal failed");
+                return ppx::ERROR_API_FAILURE;
+            }
+        }
+
+        if (!IsNull(pSubmitInfo->pFence)) {
+            dx12::Fence* pFence = ToApi(pSubmitInfo->pFence);
+            UINT64       value  = pFence->GetNextSignalValue();
+            HRESULT      hr     = mCommandQueue->Signal(pFence->GetDxFence(), value);
+            if (FAILED(hr)) {
+                PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal failed");
+                return ppx::ERROR_API_FAILURE;
+            }
         }
     }
 
-    return ppx::SUCCESS;
+    return ExecutePendingLists();
 }
 
 Result Queue::QueueWait(grfx::Semaphore* pSemaphore, uint64_t value)
@@ -165,6 +226,53 @@ Result Queue::QueueSignal(grfx::Semaphore* pSemaphore, uint64_t value)
     return ppx::SUCCESS;
 }
 
+Result Queue::BindSparseImageTilesImpl(const grfx::SparseImageBindInfo* pBindInfo)
+{
+    // Wait semaphores
+    for (uint32_t i = 0; i < pBindInfo->waitSemaphoreCount; ++i) {
+        auto         pSemaphore = ToApi(pBindInfo->ppWaitSemaphores[i]);
+        ID3D12Fence* pDxFence   = pSemaphore->GetDxFence();
+        UINT64       value      = pSemaphore->IsTimeline() ? pBindInfo->waitValues[i] : pSemaphore->GetWaitForValue();
+
+        HRESULT hr = mCommandQueue->Wait(pDxFence, value);
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Wait failed");
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    // Tile mappings are ordered with the queue's other work
+    Result ppxres = ToApi(pBindInfo->pImage)->UpdateSparseTileMappings(mCommandQueue.Get(), pBindInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Signal semaphores
+    for (uint32_t i = 0; i < pBindInfo->signalSemaphoreCount; ++i) {
+        auto         pSemaphore = ToApi(pBindInfo->ppSignalSemaphores[i]);
+        ID3D12Fence* pDxFence   = pSemaphore->GetDxFence();
+        UINT64       value      = pSemaphore->IsTimeline() ? pBindInfo->signalValues[i] : pSemaphore->GetNextSignalValue();
+
+        HRESULT hr = mCommandQueue->Signal(pDxFence, value);
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal failed");
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    if (!IsNull(pBindInfo->pFence)) {
+        dx12::Fence* pFence = ToApi(pBindInfo->pFence);
+        UINT64       value  = pFence->GetNextSignalValue();
+        HRESULT      hr     = mCommandQueue->Signal(pFence->GetDxFence(), value);
+        if (FAILED(hr)) {
+            PPX_ASSERT_MSG(false, "ID3D12CommandQueue::Signal failed");
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
 Result Queue::GetTimestampFrequency(uint64_t* pFrequency) const
 {
     if (IsNull(pFrequency)) {
@@ -178,6 +286,39 @@ Result Queue::GetTimestampFrequency(uint64_t* pFrequency) const
     return ppx::SUCCESS;
 }
 
+Result Queue::GetTimestampOffset(const grfx::Queue* pOtherQueue, double* pSeconds) const
+{
+    if (IsNull(pOtherQueue) || IsNull(pSeconds)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    ID3D12CommandQueue* queues[2]      = {mCommandQueue.Get(), ToApi(pOtherQueue)->GetDxQueue()};
+    UINT64              frequencies[2] = {0};
+    UINT64              gpuTicks[2]    = {0};
+    UINT64              cpuTicks[2]    = {0};
+    for (uint32_t i = 0; i < 2; ++i) {
+        HRESULT hr = queues[i]->GetTimestampFrequency(&frequencies[i]);
+        if (FAILED(hr) || (frequencies[i] == 0)) {
+            return ppx::ERROR_API_FAILURE;
+        }
+        hr = queues[i]->GetClockCalibration(&gpuTicks[i], &cpuTicks[i]);
+        if (FAILED(hr)) {
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    LARGE_INTEGER cpuFrequency = {};
+    QueryPerformanceFrequency(&cpuFrequency);
+
+    // GPU time of both queues at the CPU time of this queue's calibration
+    const double cpuDelta  = static_cast<double>(static_cast<int64_t>(cpuTicks[0] - cpuTicks[1])) / static_cast<double>(cpuFrequency.QuadPart);
+    const double thisTime  = static_cast<double>(gpuTicks[0]) / static_cast<double>(frequencies[0]);
+    const double otherTime = static_cast<double>(gpuTicks[1]) / static_cast<double>(frequencies[1]) + cpuDelta;
+
+    *pSeconds = thisTime - otherTime;
+    return ppx::SUCCESS;
+}
+
 } // namespace dx12
 } // namespace grfx
 } // namespace ppx
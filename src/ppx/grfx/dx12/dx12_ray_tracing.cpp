@@ -0,0 +1,110 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/dx12/dx12_ray_tracing.h"
+#include "ppx/grfx/dx12/dx12_buffer.h"
+#include "ppx/grfx/dx12/dx12_device.h"
+
+namespace ppx {
+namespace grfx {
+namespace dx12 {
+
+static D3D12_GPU_VIRTUAL_ADDRESS GetBufferAddress(const grfx::Buffer* pBuffer, uint64_t offset)
+{
+    if (IsNull(pBuffer)) {
+        return 0;
+    }
+    return ToApi(pBuffer)->GetDxResource()->GetGPUVirtualAddress() + offset;
+}
+
+static D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS ToD3D12AccelerationStructureBuildFlags(const grfx::AccelerationStructureBuildFlags& value, bool update)
+{
+    D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
+    // clang-format off
+    if (value.bits.allowUpdate    ) flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+    if (value.bits.allowCompaction) flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_COMPACTION;
+    if (value.bits.preferFastTrace) flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+    if (value.bits.preferFastBuild) flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD;
+    if (update                    ) flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+    // clang-format on
+    return flags;
+}
+
+Result ToD3D12AccelerationStructureBuildGeometry(const grfx::AccelerationStructureBuildInputs* pInputs, bool update, dx12::AccelerationStructureBuildGeometry* pGeometry)
+{
+    PPX_ASSERT_NULL_ARG(pInputs);
+    PPX_ASSERT_NULL_ARG(pGeometry);
+
+    pGeometry->geometries.clear();
+
+    D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& inputs = pGeometry->inputs;
+    inputs                                                       = {};
+    inputs.Flags                                                 = ToD3D12AccelerationStructureBuildFlags(pInputs->flags, update);
+    inputs.DescsLayout                                           = D3D12_ELEMENTS_LAYOUT_ARRAY;
+
+    if (pInputs->type == grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) {
+        if ((pInputs->geometryCount > 0) && IsNull(pInputs->pGeometries)) {
+            return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+        }
+
+        for (uint32_t i = 0; i < pInputs->geometryCount; ++i) {
+            const grfx::AccelerationStructureTriangles& src     = pInputs->pGeometries[i];
+            const bool                                  indexed = (src.indexType != grfx::INDEX_TYPE_UNDEFINED);
+
+            D3D12_RAYTRACING_GEOMETRY_DESC geometry       = {};
+            geometry.Type                                 = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+            geometry.Flags                                = src.opaque ? D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE : D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
+            geometry.Triangles.Transform3x4               = 0;
+            geometry.Triangles.IndexFormat                = indexed ? ToD3D12IndexFormat(src.indexType) : DXGI_FORMAT_UNKNOWN;
+            geometry.Triangles.VertexFormat               = dx::ToDxgiFormat(src.vertexFormat);
+            geometry.Triangles.IndexCount                 = indexed ? src.indexCount : 0;
+            geometry.Triangles.VertexCount                = src.vertexCount;
+            geometry.Triangles.IndexBuffer                = indexed ? GetBufferAddress(src.pIndexBuffer, src.indexOffset) : 0;
+            geometry.Triangles.VertexBuffer.StartAddress  = GetBufferAddress(src.pVertexBuffer, src.vertexOffset);
+            geometry.Triangles.VertexBuffer.StrideInBytes = src.vertexStride;
+
+            pGeometry->geometries.push_back(geometry);
+        }
+
+        inputs.Type           = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+        inputs.NumDescs       = CountU32(pGeometry->geometries);
+        inputs.pGeometryDescs = DataPtr(pGeometry->geometries);
+    }
+    else if (pInputs->type == grfx::ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL) {
+        inputs.Type          = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+        inputs.NumDescs      = pInputs->instanceCount;
+        inputs.InstanceDescs = GetBufferAddress(pInputs->pInstanceBuffer, pInputs->instanceOffset);
+    }
+    else {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result AccelerationStructure::CreateApiObjects(const grfx::AccelerationStructureCreateInfo* pCreateInfo)
+{
+    // The buffer created by grfx::AccelerationStructure is the structure
+    mGpuVirtualAddress = ToApi(mBuffer)->GetDxResource()->GetGPUVirtualAddress();
+    return ppx::SUCCESS;
+}
+
+void AccelerationStructure::DestroyApiObjects()
+{
+    mGpuVirtualAddress = 0;
+}
+
+} // namespace dx12
+} // namespace grfx
+} // namespace ppx
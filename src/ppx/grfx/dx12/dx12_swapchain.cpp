@@ -61,6 +61,11 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
     if (isXREnabled) {
         const XrComponent& xrComponent = *mCreateInfo.pXrComponent;
 
+        if (pCreateInfo->xrSpaceWarp) {
+            PPX_ASSERT_MSG(false, "XR_FB_space_warp swapchains are Vulkan only");
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+
         PPX_ASSERT_MSG(xrComponent.GetColorFormat() == pCreateInfo->colorFormat, "XR color format differs from requested swapchain format");
 
         XrSwapchainCreateInfo info = {XR_TYPE_SWAPCHAIN_CREATE_INFO};
@@ -216,7 +221,8 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
             return ppx::ERROR_API_FAILURE;
         }
 
-        hr = mSwapchain->SetMaximumFrameLatency(1);
+        // AcquireNextImage() waits on this, 0 keeps the previous default of 1
+        hr = mSwapchain->SetMaximumFrameLatency(std::max<UINT>(pCreateInfo->maxFrameLatency, 1));
         if (FAILED(hr)) {
             PPX_ASSERT_MSG(false, "IDXGISwapChain2::SetMaximumFrameLatency failed");
             return ppx::ERROR_API_FAILURE;
@@ -278,7 +284,10 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
 
 void Swapchain::DestroyApiObjects()
 {
-    mFrameLatencyWaitableObject = nullptr;
+    if (!IsNull(mFrameLatencyWaitableObject)) {
+        CloseHandle(mFrameLatencyWaitableObject);
+        mFrameLatencyWaitableObject = nullptr;
+    }
 
     if (mSwapchain) {
         mSwapchain.Reset();
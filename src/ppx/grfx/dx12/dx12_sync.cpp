@@ -80,6 +80,11 @@ Result Fence::Reset()
     return ppx::SUCCESS;
 }
 
+bool Fence::IsSignaled() const
+{
+    return (mFence->GetCompletedValue() >= GetWaitForValue());
+}
+
 // -------------------------------------------------------------------------------------------------
 // Semaphore
 // -------------------------------------------------------------------------------------------------
@@ -249,7 +249,8 @@ D3D12_DESCRIPTOR_RANGE_TYPE ToD3D12RangeType(grfx::DescriptorType value)
 
         case grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE:
         case grfx::DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-        case grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER: {
+        case grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER:
+        case grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE: {
             return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
         } break;
 
@@ -295,11 +296,52 @@ D3D12_RESOURCE_STATES ToD3D12ResourceStates(grfx::ResourceState value, grfx::Com
         case grfx::RESOURCE_STATE_RESOLVE_DST               : return D3D12_RESOURCE_STATE_RESOLVE_DEST; break;
         case grfx::RESOURCE_STATE_PRESENT                   : return D3D12_RESOURCE_STATE_PRESENT; break;
         case grfx::RESOURCE_STATE_UNORDERED_ACCESS          : return D3D12_RESOURCE_STATE_UNORDERED_ACCESS; break;
+        case grfx::RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE : return D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE; break;
+        case grfx::RESOURCE_STATE_PREDICATION               : return D3D12_RESOURCE_STATE_PREDICATION; break;
     }
     // clang-format on
     return ppx::InvalidValue<D3D12_RESOURCE_STATES>();
 }
 
+#if defined(PPX_D3D12_ENHANCED_BARRIERS)
+D3D12BarrierState ToD3D12BarrierState(grfx::ResourceState value, grfx::CommandType commandType)
+{
+    // Compute queues can't sync graphics stages
+    const D3D12_BARRIER_SYNC shading = (commandType == grfx::COMMAND_TYPE_GRAPHICS) ? D3D12_BARRIER_SYNC_ALL_SHADING : D3D12_BARRIER_SYNC_COMPUTE_SHADING;
+
+    // clang-format off
+    switch (value) {
+        default: break;
+        case grfx::RESOURCE_STATE_UNDEFINED                 : return {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+        case grfx::RESOURCE_STATE_GENERAL                   : return {D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_COMMON, D3D12_BARRIER_LAYOUT_COMMON}; break;
+        case grfx::RESOURCE_STATE_CONSTANT_BUFFER           : return {shading, D3D12_BARRIER_ACCESS_CONSTANT_BUFFER, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+        case grfx::RESOURCE_STATE_VERTEX_BUFFER             : return {D3D12_BARRIER_SYNC_VERTEX_SHADING, D3D12_BARRIER_ACCESS_VERTEX_BUFFER, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+        case grfx::RESOURCE_STATE_INDEX_BUFFER              : return {D3D12_BARRIER_SYNC_INDEX_INPUT, D3D12_BARRIER_ACCESS_INDEX_BUFFER, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+        case grfx::RESOURCE_STATE_INDIRECT_ARGUMENT         : return {D3D12_BARRIER_SYNC_EXECUTE_INDIRECT, D3D12_BARRIER_ACCESS_INDIRECT_ARGUMENT, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+        case grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE : return {D3D12_BARRIER_SYNC_NON_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE}; break;
+        case grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE     : return {D3D12_BARRIER_SYNC_PIXEL_SHADING, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE}; break;
+        case grfx::RESOURCE_STATE_SHADER_RESOURCE           : return {shading, D3D12_BARRIER_ACCESS_SHADER_RESOURCE, D3D12_BARRIER_LAYOUT_SHADER_RESOURCE}; break;
+        case grfx::RESOURCE_STATE_DEPTH_STENCIL_READ        : return {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_READ, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_READ}; break;
+        case grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE       : return {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE}; break;
+        case grfx::RESOURCE_STATE_DEPTH_WRITE_STENCIL_READ  : return {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE}; break;
+        case grfx::RESOURCE_STATE_DEPTH_READ_STENCIL_WRITE  : return {D3D12_BARRIER_SYNC_DEPTH_STENCIL, D3D12_BARRIER_ACCESS_DEPTH_STENCIL_WRITE, D3D12_BARRIER_LAYOUT_DEPTH_STENCIL_WRITE}; break;
+        case grfx::RESOURCE_STATE_RENDER_TARGET             : return {D3D12_BARRIER_SYNC_RENDER_TARGET, D3D12_BARRIER_ACCESS_RENDER_TARGET, D3D12_BARRIER_LAYOUT_RENDER_TARGET}; break;
+        case grfx::RESOURCE_STATE_COPY_SRC                  : return {D3D12_BARRIER_SYNC_COPY, D3D12_BARRIER_ACCESS_COPY_SOURCE, D3D12_BARRIER_LAYOUT_COPY_SOURCE}; break;
+        case grfx::RESOURCE_STATE_COPY_DST                  : return {D3D12_BARRIER_SYNC_COPY, D3D12_BARRIER_ACCESS_COPY_DEST, D3D12_BARRIER_LAYOUT_COPY_DEST}; break;
+        case grfx::RESOURCE_STATE_RESOLVE_SRC               : return {D3D12_BARRIER_SYNC_RESOLVE, D3D12_BARRIER_ACCESS_RESOLVE_SOURCE, D3D12_BARRIER_LAYOUT_RESOLVE_SOURCE}; break;
+        case grfx::RESOURCE_STATE_RESOLVE_DST               : return {D3D12_BARRIER_SYNC_RESOLVE, D3D12_BARRIER_ACCESS_RESOLVE_DEST, D3D12_BARRIER_LAYOUT_RESOLVE_DEST}; break;
+        case grfx::RESOURCE_STATE_PRESENT                   : return {D3D12_BARRIER_SYNC_NONE, D3D12_BARRIER_ACCESS_NO_ACCESS, D3D12_BARRIER_LAYOUT_PRESENT}; break;
+        case grfx::RESOURCE_STATE_UNORDERED_ACCESS          : return {shading, D3D12_BARRIER_ACCESS_UNORDERED_ACCESS, D3D12_BARRIER_LAYOUT_UNORDERED_ACCESS}; break;
+        case grfx::RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE : return {shading | D3D12_BARRIER_SYNC_BUILD_RAYTRACING_ACCELERATION_STRUCTURE, D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_READ | D3D12_BARRIER_ACCESS_RAYTRACING_ACCELERATION_STRUCTURE_WRITE, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+        case grfx::RESOURCE_STATE_PREDICATION               : return {D3D12_BARRIER_SYNC_PREDICATION, D3D12_BARRIER_ACCESS_PREDICATION, D3D12_BARRIER_LAYOUT_UNDEFINED}; break;
+    }
+    // clang-format on
+
+    // Anything else is treated as RESOURCE_STATE_GENERAL
+    return {D3D12_BARRIER_SYNC_ALL, D3D12_BARRIER_ACCESS_COMMON, D3D12_BARRIER_LAYOUT_COMMON};
+}
+#endif
+
 D3D12_RTV_DIMENSION ToD3D12RTVDimension(grfx::ImageViewType value)
 {
     // clang-format off
@@ -344,6 +386,8 @@ D3D12_SHADER_VISIBILITY ToD3D12ShaderVisibliity(grfx::ShaderStageBits value)
         case grfx:: SHADER_STAGE_GS           : return D3D12_SHADER_VISIBILITY_GEOMETRY; break;
         case grfx:: SHADER_STAGE_PS           : return D3D12_SHADER_VISIBILITY_PIXEL; break;
         case grfx:: SHADER_STAGE_CS           : return D3D12_SHADER_VISIBILITY_ALL; break;
+        case grfx:: SHADER_STAGE_AS           : return D3D12_SHADER_VISIBILITY_AMPLIFICATION; break;
+        case grfx:: SHADER_STAGE_MS           : return D3D12_SHADER_VISIBILITY_MESH; break;
         case grfx:: SHADER_STAGE_ALL_GRAPHICS : return D3D12_SHADER_VISIBILITY_ALL; break;
         case grfx:: SHADER_STAGE_ALL          : return D3D12_SHADER_VISIBILITY_ALL; break;       
     }
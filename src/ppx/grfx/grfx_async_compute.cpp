@@ -0,0 +1,341 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_async_compute.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_query.h"
+#include "ppx/grfx/grfx_sync.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace grfx {
+
+static constexpr uint32_t kBeginTimestamp = 0;
+static constexpr uint32_t kEndTimestamp   = 1;
+
+static double TicksToMs(uint64_t ticks, uint64_t frequency)
+{
+    return (frequency > 0) ? (static_cast<double>(ticks) * 1000.0 / static_cast<double>(frequency)) : 0.0;
+}
+
+Result AsyncComputeScheduler::CreateApiObjects(const grfx::AsyncComputeSchedulerCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->pGraphicsQueue) || IsNull(pCreateInfo->pComputeQueue)) {
+        PPX_ASSERT_MSG(false, "async compute scheduler needs a graphics and a compute queue");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (pCreateInfo->frameCount == 0) {
+        PPX_ASSERT_MSG(false, "async compute scheduler frame count must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mTransferOwnership = pCreateInfo->pComputeQueue->RequiresOwnershipTransfer(pCreateInfo->pGraphicsQueue);
+
+    if (pCreateInfo->enableTimestamps) {
+        Result ppxres = pCreateInfo->pGraphicsQueue->GetTimestampFrequency(&mGraphicsFrequency);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        ppxres = pCreateInfo->pComputeQueue->GetTimestampFrequency(&mComputeFrequency);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    mPerFrame.resize(pCreateInfo->frameCount);
+    for (auto& frame : mPerFrame) {
+        grfx::SemaphoreCreateInfo semaCreateInfo = {};
+
+        Result ppxres = GetDevice()->CreateSemaphore(&semaCreateInfo, &frame.computeCompleteSemaphore);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        if (pCreateInfo->enableTimestamps) {
+            grfx::QueryCreateInfo queryCreateInfo = {};
+            queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+            queryCreateInfo.count                 = 2;
+
+            ppxres = GetDevice()->CreateQuery(&queryCreateInfo, &frame.computeTimestamps);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            ppxres = GetDevice()->CreateQuery(&queryCreateInfo, &frame.graphicsTimestamps);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void AsyncComputeScheduler::DestroyApiObjects()
+{
+    for (auto& frame : mPerFrame) {
+        if (frame.computeCompleteSemaphore) {
+            GetDevice()->DestroySemaphore(frame.computeCompleteSemaphore);
+        }
+        if (frame.computeTimestamps) {
+            GetDevice()->DestroyQuery(frame.computeTimestamps);
+        }
+        if (frame.graphicsTimestamps) {
+            GetDevice()->DestroyQuery(frame.graphicsTimestamps);
+        }
+    }
+    mPerFrame.clear();
+}
+
+Result AsyncComputeScheduler::AddSharedImage(uint32_t frameIndex, const grfx::Image* pImage, grfx::ResourceState state)
+{
+    PPX_ASSERT_NULL_ARG(pImage);
+    if (frameIndex >= CountU32(mPerFrame)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    SharedResource resource = {};
+    resource.pImage         = pImage;
+    resource.state          = state;
+    mPerFrame[frameIndex].sharedResources.push_back(resource);
+
+    return ppx::SUCCESS;
+}
+
+Result AsyncComputeScheduler::AddSharedBuffer(uint32_t frameIndex, const grfx::Buffer* pBuffer, grfx::ResourceState state)
+{
+    PPX_ASSERT_NULL_ARG(pBuffer);
+    if (frameIndex >= CountU32(mPerFrame)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    SharedResource resource = {};
+    resource.pBuffer        = pBuffer;
+    resource.state          = state;
+    mPerFrame[frameIndex].sharedResources.push_back(resource);
+
+    return ppx::SUCCESS;
+}
+
+void AsyncComputeScheduler::RecordOwnershipTransfers(const PerFrame& frame, grfx::CommandBuffer* pCommandBuffer, const grfx::Queue* pSrcQueue, const grfx::Queue* pDstQueue) const
+{
+    // The same barrier is recorded as the release on the source queue
+    // and as the acquire on the destination queue.
+    for (const auto& resource : frame.sharedResources) {
+        if (!IsNull(resource.pImage)) {
+            pCommandBuffer->TransitionImageLayout(resource.pImage, PPX_ALL_SUBRESOURCES, resource.state, resource.state, pSrcQueue, pDstQueue);
+        }
+        else {
+            pCommandBuffer->BufferResourceBarrier(resource.pBuffer, resource.state, resource.state, pSrcQueue, pDstQueue);
+        }
+    }
+}
+
+void AsyncComputeScheduler::BeginCompute(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mPerFrame), "frame index out of range");
+
+    PerFrame& frame = mPerFrame[frameIndex];
+
+    if (mTransferOwnership && frame.releasedToCompute) {
+        RecordOwnershipTransfers(frame, pCommandBuffer, GetGraphicsQueue(), GetComputeQueue());
+    }
+    frame.releasedToCompute = false;
+
+    if (frame.computeTimestamps) {
+        frame.computeTimestamps->Reset(0, 2);
+        pCommandBuffer->WriteTimestamp(frame.computeTimestamps, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, kBeginTimestamp);
+    }
+}
+
+void AsyncComputeScheduler::EndCompute(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mPerFrame), "frame index out of range");
+
+    PerFrame& frame = mPerFrame[frameIndex];
+
+    if (mTransferOwnership) {
+        RecordOwnershipTransfers(frame, pCommandBuffer, GetComputeQueue(), GetGraphicsQueue());
+        frame.releasedToGraphics = true;
+    }
+
+    if (frame.computeTimestamps) {
+        pCommandBuffer->WriteTimestamp(frame.computeTimestamps, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, kEndTimestamp);
+        pCommandBuffer->ResolveQueryData(frame.computeTimestamps, 0, 2);
+        frame.computeTimed = true;
+    }
+}
+
+Result AsyncComputeScheduler::SubmitCompute(uint32_t frameIndex, const grfx::SubmitInfo* pSubmitInfo)
+{
+    PPX_ASSERT_NULL_ARG(pSubmitInfo);
+    if (frameIndex >= CountU32(mPerFrame)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    PerFrame& frame = mPerFrame[frameIndex];
+
+    std::vector<grfx::Semaphore*> signalSemaphores(pSubmitInfo->ppSignalSemaphores, pSubmitInfo->ppSignalSemaphores + pSubmitInfo->signalSemaphoreCount);
+    signalSemaphores.push_back(frame.computeCompleteSemaphore.Get());
+
+    grfx::SubmitInfo submitInfo     = *pSubmitInfo;
+    submitInfo.signalSemaphoreCount = CountU32(signalSemaphores);
+    submitInfo.ppSignalSemaphores   = DataPtr(signalSemaphores);
+    // Values are only needed if the caller signals timelines
+    if (!submitInfo.signalValues.empty()) {
+        submitInfo.signalValues.resize(pSubmitInfo->signalSemaphoreCount, 0);
+        submitInfo.signalValues.push_back(0);
+    }
+
+    Result ppxres = GetComputeQueue()->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    frame.computeSubmitted = true;
+
+    return ppx::SUCCESS;
+}
+
+void AsyncComputeScheduler::BeginGraphics(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mPerFrame), "frame index out of range");
+
+    PerFrame& frame = mPerFrame[frameIndex];
+
+    if (mTransferOwnership && frame.releasedToGraphics) {
+        RecordOwnershipTransfers(frame, pCommandBuffer, GetComputeQueue(), GetGraphicsQueue());
+    }
+    frame.releasedToGraphics = false;
+
+    if (frame.graphicsTimestamps) {
+        frame.graphicsTimestamps->Reset(0, 2);
+        pCommandBuffer->WriteTimestamp(frame.graphicsTimestamps, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, kBeginTimestamp);
+    }
+}
+
+void AsyncComputeScheduler::EndGraphics(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mPerFrame), "frame index out of range");
+
+    PerFrame& frame = mPerFrame[frameIndex];
+
+    if (mTransferOwnership) {
+        RecordOwnershipTransfers(frame, pCommandBuffer, GetGraphicsQueue(), GetComputeQueue());
+        frame.releasedToCompute = true;
+    }
+
+    if (frame.graphicsTimestamps) {
+        pCommandBuffer->WriteTimestamp(frame.graphicsTimestamps, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, kEndTimestamp);
+        pCommandBuffer->ResolveQueryData(frame.graphicsTimestamps, 0, 2);
+        frame.graphicsTimed = true;
+    }
+}
+
+Result AsyncComputeScheduler::SubmitGraphics(uint32_t frameIndex, const grfx::SubmitInfo* pSubmitInfo)
+{
+    PPX_ASSERT_NULL_ARG(pSubmitInfo);
+    if (frameIndex >= CountU32(mPerFrame)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    PerFrame& frame = mPerFrame[frameIndex];
+
+    // Nothing to wait for if the frame's compute workload was skipped
+    if (!frame.computeSubmitted) {
+        return GetGraphicsQueue()->Submit(pSubmitInfo);
+    }
+
+    std::vector<const grfx::Semaphore*> waitSemaphores(pSubmitInfo->ppWaitSemaphores, pSubmitInfo->ppWaitSemaphores + pSubmitInfo->waitSemaphoreCount);
+    waitSemaphores.push_back(frame.computeCompleteSemaphore.Get());
+
+    grfx::SubmitInfo submitInfo   = *pSubmitInfo;
+    submitInfo.waitSemaphoreCount = CountU32(waitSemaphores);
+    submitInfo.ppWaitSemaphores   = DataPtr(waitSemaphores);
+    if (!submitInfo.waitValues.empty()) {
+        submitInfo.waitValues.resize(pSubmitInfo->waitSemaphoreCount, 0);
+        submitInfo.waitValues.push_back(0);
+    }
+
+    Result ppxres = GetGraphicsQueue()->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    frame.computeSubmitted = false;
+
+    return ppx::SUCCESS;
+}
+
+grfx::Semaphore* AsyncComputeScheduler::GetComputeCompleteSemaphore(uint32_t frameIndex) const
+{
+    if (frameIndex >= CountU32(mPerFrame)) {
+        return nullptr;
+    }
+    return mPerFrame[frameIndex].computeCompleteSemaphore.Get();
+}
+
+Result AsyncComputeScheduler::ReadTimings(uint32_t frameIndex, grfx::AsyncComputeTimings* pTimings)
+{
+    PPX_ASSERT_NULL_ARG(pTimings);
+    if (frameIndex >= CountU32(mPerFrame)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    PerFrame& frame = mPerFrame[frameIndex];
+    if (!frame.computeTimed || !frame.graphicsTimed) {
+        return ppx::ERROR_ELEMENT_NOT_FOUND;
+    }
+
+    uint64_t computeData[2]  = {0, 0};
+    uint64_t graphicsData[2] = {0, 0};
+
+    Result ppxres = frame.computeTimestamps->GetData(computeData, sizeof(computeData));
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    ppxres = frame.graphicsTimestamps->GetData(graphicsData, sizeof(graphicsData));
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    frame.computeTimed  = false;
+    frame.graphicsTimed = false;
+
+    Interval compute  = {TicksToMs(computeData[kBeginTimestamp], mComputeFrequency), TicksToMs(computeData[kEndTimestamp], mComputeFrequency)};
+    Interval graphics = {TicksToMs(graphicsData[kBeginTimestamp], mGraphicsFrequency), TicksToMs(graphicsData[kEndTimestamp], mGraphicsFrequency)};
+
+    // Graphics of the same frame usually waits for the compute results, most
+    // of the overlap is with the end of the previous frame's graphics work.
+    auto overlap = [](const Interval& a, const Interval& b) -> double {
+        return std::max(0.0, std::min(a.end, b.end) - std::max(a.begin, b.begin));
+    };
+
+    pTimings->computeMs  = compute.end - compute.begin;
+    pTimings->graphicsMs = graphics.end - graphics.begin;
+    pTimings->overlapMs  = overlap(compute, graphics) + overlap(compute, mPrevGraphicsInterval);
+
+    mPrevGraphicsInterval = graphics;
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -0,0 +1,243 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/grfx/grfx_bindless_heap.h"
+#include "ppx/grfx/grfx_device.h"
+
+namespace ppx {
+namespace grfx {
+
+// -------------------------------------------------------------------------------------------------
+// BindlessHeap::SlotAllocator
+// -------------------------------------------------------------------------------------------------
+void BindlessHeap::SlotAllocator::Reset(uint32_t capacity)
+{
+    mAllocated.assign(capacity, false);
+    mFreeIndices.clear();
+    mNextIndex      = 0;
+    mAllocatedCount = 0;
+}
+
+uint32_t BindlessHeap::SlotAllocator::Allocate()
+{
+    uint32_t index = INVALID_INDEX;
+    if (!mFreeIndices.empty()) {
+        index = mFreeIndices.back();
+        mFreeIndices.pop_back();
+    }
+    else if (mNextIndex < CountU32(mAllocated)) {
+        index = mNextIndex;
+        ++mNextIndex;
+    }
+    else {
+        return INVALID_INDEX;
+    }
+
+    mAllocated[index] = true;
+    ++mAllocatedCount;
+    return index;
+}
+
+void BindlessHeap::SlotAllocator::Free(uint32_t index)
+{
+    if (!IsAllocated(index)) {
+        PPX_ASSERT_MSG(false, "bindless heap slot " << index << " is not allocated");
+        return;
+    }
+
+    mAllocated[index] = false;
+    mFreeIndices.push_back(index);
+    --mAllocatedCount;
+}
+
+bool BindlessHeap::SlotAllocator::IsAllocated(uint32_t index) const
+{
+    return (index < CountU32(mAllocated)) && mAllocated[index];
+}
+
+// -------------------------------------------------------------------------------------------------
+// BindlessHeap
+// -------------------------------------------------------------------------------------------------
+Result BindlessHeap::CreateApiObjects(const grfx::BindlessHeapCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if ((pCreateInfo->textureCapacity == 0) && (pCreateInfo->samplerCapacity == 0)) {
+        PPX_ASSERT_MSG(false, "bindless heap needs a non-zero texture or sampler capacity");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((pCreateInfo->textureCapacity > 0) && (pCreateInfo->samplerCapacity > 0) && (pCreateInfo->textureBinding == pCreateInfo->samplerBinding)) {
+        PPX_ASSERT_MSG(false, "bindless heap texture and sampler bindings must be different");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Slots are only written when allocated so the arrays are partially
+    // bound, and update-after-bind lets slots change while the set is bound.
+    grfx::DescriptorBindingFlags bindingFlags = {};
+    bindingFlags.bits.updatable               = true;
+    bindingFlags.bits.partiallyBound          = true;
+
+    grfx::DescriptorPoolCreateInfo      poolCreateInfo   = {};
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    if (pCreateInfo->textureCapacity > 0) {
+        poolCreateInfo.sampledImage = pCreateInfo->textureCapacity;
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(
+            pCreateInfo->textureBinding,
+            grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            pCreateInfo->textureCapacity,
+            pCreateInfo->shaderVisibility,
+            bindingFlags));
+    }
+    if (pCreateInfo->samplerCapacity > 0) {
+        poolCreateInfo.sampler = pCreateInfo->samplerCapacity;
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(
+            pCreateInfo->samplerBinding,
+            grfx::DESCRIPTOR_TYPE_SAMPLER,
+            pCreateInfo->samplerCapacity,
+            pCreateInfo->shaderVisibility,
+            bindingFlags));
+    }
+
+    Result ppxres = GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed creating bindless heap descriptor pool");
+        return ppxres;
+    }
+
+    ppxres = GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mDescriptorSetLayout);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed creating bindless heap descriptor set layout");
+        return ppxres;
+    }
+
+    ppxres = GetDevice()->AllocateDescriptorSet(mDescriptorPool, mDescriptorSetLayout, &mDescriptorSet);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed allocating bindless heap descriptor set");
+        return ppxres;
+    }
+
+    mTextureSlots.Reset(pCreateInfo->textureCapacity);
+    mSamplerSlots.Reset(pCreateInfo->samplerCapacity);
+
+    return ppx::SUCCESS;
+}
+
+void BindlessHeap::DestroyApiObjects()
+{
+    mPendingWrites.clear();
+
+    if (mDescriptorSet) {
+        GetDevice()->FreeDescriptorSet(mDescriptorSet);
+        mDescriptorSet.Reset();
+    }
+
+    if (mDescriptorSetLayout) {
+        GetDevice()->DestroyDescriptorSetLayout(mDescriptorSetLayout);
+        mDescriptorSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        GetDevice()->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+}
+
+uint32_t BindlessHeap::AllocateTexture(const grfx::SampledImageView* pImageView)
+{
+    PPX_ASSERT_NULL_ARG(pImageView);
+
+    uint32_t index = mTextureSlots.Allocate();
+    if (index != INVALID_INDEX) {
+        UpdateTexture(index, pImageView);
+    }
+    return index;
+}
+
+uint32_t BindlessHeap::AllocateSampler(const grfx::Sampler* pSampler)
+{
+    PPX_ASSERT_NULL_ARG(pSampler);
+
+    uint32_t index = mSamplerSlots.Allocate();
+    if (index != INVALID_INDEX) {
+        UpdateSampler(index, pSampler);
+    }
+    return index;
+}
+
+Result BindlessHeap::UpdateTexture(uint32_t index, const grfx::SampledImageView* pImageView)
+{
+    PPX_ASSERT_NULL_ARG(pImageView);
+
+    if (!mTextureSlots.IsAllocated(index)) {
+        PPX_ASSERT_MSG(false, "bindless heap texture slot " << index << " is not allocated");
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    grfx::WriteDescriptor write = {};
+    write.binding               = mCreateInfo.textureBinding;
+    write.arrayIndex            = index;
+    write.type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    write.pImageView            = pImageView;
+    mPendingWrites.push_back(write);
+
+    return ppx::SUCCESS;
+}
+
+Result BindlessHeap::UpdateSampler(uint32_t index, const grfx::Sampler* pSampler)
+{
+    PPX_ASSERT_NULL_ARG(pSampler);
+
+    if (!mSamplerSlots.IsAllocated(index)) {
+        PPX_ASSERT_MSG(false, "bindless heap sampler slot " << index << " is not allocated");
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    grfx::WriteDescriptor write = {};
+    write.binding               = mCreateInfo.samplerBinding;
+    write.arrayIndex            = index;
+    write.type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+    write.pSampler              = pSampler;
+    mPendingWrites.push_back(write);
+
+    return ppx::SUCCESS;
+}
+
+void BindlessHeap::FreeTexture(uint32_t index)
+{
+    mTextureSlots.Free(index);
+}
+
+void BindlessHeap::FreeSampler(uint32_t index)
+{
+    mSamplerSlots.Free(index);
+}
+
+Result BindlessHeap::Flush()
+{
+    if (mPendingWrites.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = mDescriptorSet->UpdateDescriptors(CountU32(mPendingWrites), DataPtr(mPendingWrites));
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    mPendingWrites.clear();
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -0,0 +1,417 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_block_compressor.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_format.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in CompressBlocks.hlsl
+enum
+{
+    COMPRESS_BLOCKS_PARAMS_REGISTER = 0,
+    COMPRESS_BLOCKS_SRC_REGISTER    = 1,
+    COMPRESS_BLOCKS_DST_REGISTER    = 2,
+};
+
+// Formats in CompressBlocks.hlsl
+enum
+{
+    COMPRESS_BLOCKS_FORMAT_BC1       = 0,
+    COMPRESS_BLOCKS_FORMAT_BC1_ALPHA = 1,
+    COMPRESS_BLOCKS_FORMAT_BC3       = 2,
+};
+
+static const uint32_t kCompressBlocksGroupSize = 8;
+
+// Must match CompressBlocks.hlsl
+struct CompressBlocksParams
+{
+    uint32_t srcSize[2];
+    uint32_t blockCount[2];
+    uint32_t rowStride;
+    uint32_t layerStride;
+    uint32_t format;
+    uint32_t srgb;
+};
+
+// Buffer to image copies need D3D12's alignments, Vulkan's are looser
+struct LevelLayout
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t blockCountX;
+    uint32_t blockCountY;
+    uint32_t rowStride;
+    uint32_t layerStride;
+    uint64_t offset;
+};
+
+static uint32_t GetShaderFormat(grfx::Format format)
+{
+    switch (format) {
+        default: break;
+        case grfx::FORMAT_BC1_RGB_SRGB:
+        case grfx::FORMAT_BC1_RGB_UNORM: return COMPRESS_BLOCKS_FORMAT_BC1;
+        case grfx::FORMAT_BC1_RGBA_SRGB:
+        case grfx::FORMAT_BC1_RGBA_UNORM: return COMPRESS_BLOCKS_FORMAT_BC1_ALPHA;
+        case grfx::FORMAT_BC3_SRGB:
+        case grfx::FORMAT_BC3_UNORM: return COMPRESS_BLOCKS_FORMAT_BC3;
+    }
+    return UINT32_MAX;
+}
+
+BlockCompressor::BlockCompressor()
+{
+}
+
+BlockCompressor::~BlockCompressor()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    if (mPipeline) {
+        mDevice->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+}
+
+Result BlockCompressor::Create(grfx::Device* pDevice, const grfx::BlockCompressorCreateInfo& createInfo, grfx::BlockCompressor** ppCompressor)
+{
+    if (IsNull(pDevice) || IsNull(ppCompressor) || IsNull(createInfo.pShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxDispatchCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::BlockCompressor* pCompressor = new grfx::BlockCompressor();
+    if (IsNull(pCompressor)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pCompressor->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pCompressor;
+        return ppxres;
+    }
+
+    *ppCompressor = pCompressor;
+
+    return ppx::SUCCESS;
+}
+
+Result BlockCompressor::Initialize(grfx::Device* pDevice, const grfx::BlockCompressorCreateInfo& createInfo)
+{
+    mDevice           = pDevice;
+    mMaxDispatchCount = createInfo.maxDispatchCount;
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sampledImage                   = mMaxDispatchCount;
+    poolCreateInfo.rawStorageBuffer               = mMaxDispatchCount;
+
+    Result ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(COMPRESS_BLOCKS_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(COMPRESS_BLOCKS_DST_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(CompressBlocksParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = COMPRESS_BLOCKS_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {createInfo.pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+bool BlockCompressor::IsFormatSupported(grfx::Format format)
+{
+    return GetShaderFormat(format) != UINT32_MAX;
+}
+
+bool BlockCompressor::IsSupported(const grfx::Image* pSrcImage, const grfx::Image* pDstImage)
+{
+    if (IsNull(pSrcImage) || IsNull(pDstImage)) {
+        return false;
+    }
+    if (!pSrcImage->GetUsageFlags().bits.sampled || !pDstImage->GetUsageFlags().bits.transferDst) {
+        return false;
+    }
+    if (!IsFormatSupported(pDstImage->GetFormat())) {
+        return false;
+    }
+    if ((pSrcImage->GetType() != grfx::IMAGE_TYPE_2D) && (pSrcImage->GetType() != grfx::IMAGE_TYPE_CUBE)) {
+        return false;
+    }
+    if ((pSrcImage->GetSampleCount() != grfx::SAMPLE_COUNT_1) || (pDstImage->GetType() != pSrcImage->GetType())) {
+        return false;
+    }
+    if ((pDstImage->GetWidth() != pSrcImage->GetWidth()) || (pDstImage->GetHeight() != pSrcImage->GetHeight())) {
+        return false;
+    }
+    if ((pDstImage->GetArrayLayerCount() != pSrcImage->GetArrayLayerCount()) || (pDstImage->GetMipLevelCount() > pSrcImage->GetMipLevelCount())) {
+        return false;
+    }
+
+    // Shaders read float4, which excludes integer formats
+    const grfx::FormatDesc* pDesc = grfx::GetFormatDescription(pSrcImage->GetFormat());
+    if (IsNull(pDesc) || (pDesc->aspect != grfx::FORMAT_ASPECT_COLOR) || (pDesc->layout == grfx::FORMAT_LAYOUT_COMPRESSED)) {
+        return false;
+    }
+    return (pDesc->dataType != grfx::FORMAT_DATA_TYPE_UINT) && (pDesc->dataType != grfx::FORMAT_DATA_TYPE_SINT);
+}
+
+void BlockCompressor::DestroyJob(Job& job)
+{
+    for (auto& set : job.sets) {
+        mDevice->FreeDescriptorSet(set);
+    }
+    job.sets.clear();
+    for (auto& view : job.srcViews) {
+        mDevice->DestroySampledImageView(view);
+    }
+    job.srcViews.clear();
+    if (job.buffer) {
+        mDevice->DestroyBuffer(job.buffer);
+        job.buffer.Reset();
+    }
+}
+
+Result BlockCompressor::Record(
+    grfx::CommandBuffer* pCmd,
+    grfx::Image*         pSrcImage,
+    grfx::ResourceState  srcState,
+    grfx::Image*         pDstImage,
+    grfx::ResourceState  dstStateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pSrcImage);
+    PPX_ASSERT_NULL_ARG(pDstImage);
+
+    if (!IsSupported(pSrcImage, pDstImage)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const uint32_t levelCount = pDstImage->GetMipLevelCount();
+    const uint32_t layerCount = pDstImage->GetArrayLayerCount();
+    if ((mDispatchCount + levelCount) > mMaxDispatchCount) {
+        PPX_ASSERT_MSG(false, "BlockCompressor: more dispatches than BlockCompressorCreateInfo::maxDispatchCount, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    const grfx::FormatDesc* pSrcDesc  = grfx::GetFormatDescription(pSrcImage->GetFormat());
+    const grfx::FormatDesc* pDstDesc  = grfx::GetFormatDescription(pDstImage->GetFormat());
+    const uint32_t          blockSize = pDstDesc->bytesPerTexel;
+    const bool              srgb      = (pSrcDesc->dataType == grfx::FORMAT_DATA_TYPE_SRGB) && (pDstDesc->dataType == grfx::FORMAT_DATA_TYPE_SRGB);
+
+    std::vector<LevelLayout> levels(levelCount);
+    uint64_t                 bufferSize = 0;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        LevelLayout& layout = levels[level];
+        layout.width        = std::max<uint32_t>(pDstImage->GetWidth() >> level, 1);
+        layout.height       = std::max<uint32_t>(pDstImage->GetHeight() >> level, 1);
+        layout.blockCountX  = (layout.width + 3) / 4;
+        layout.blockCountY  = (layout.height + 3) / 4;
+        layout.rowStride    = RoundUp<uint32_t>(layout.blockCountX * blockSize, PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT);
+        layout.layerStride  = RoundUp<uint32_t>(layout.rowStride * layout.blockCountY, PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+        layout.offset       = bufferSize;
+        bufferSize += static_cast<uint64_t>(layout.layerStride) * layerCount;
+    }
+
+    Job job = {};
+
+    grfx::BufferCreateInfo bufferCreateInfo           = {};
+    bufferCreateInfo.size                             = bufferSize;
+    bufferCreateInfo.usageFlags.bits.rawStorageBuffer = true;
+    bufferCreateInfo.usageFlags.bits.transferSrc      = true;
+    bufferCreateInfo.memoryUsage                      = grfx::MEMORY_USAGE_GPU_ONLY;
+    bufferCreateInfo.initialState                     = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+
+    Result ppxres = mDevice->CreateBuffer(&bufferCreateInfo, &job.buffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        grfx::SampledImageViewCreateInfo viewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(pSrcImage);
+        viewCreateInfo.imageViewType                    = grfx::IMAGE_VIEW_TYPE_2D_ARRAY;
+        viewCreateInfo.mipLevel                         = level;
+        viewCreateInfo.mipLevelCount                    = 1;
+        viewCreateInfo.arrayLayer                       = 0;
+        viewCreateInfo.arrayLayerCount                  = layerCount;
+
+        grfx::SampledImageViewPtr view;
+        ppxres = mDevice->CreateSampledImageView(&viewCreateInfo, &view);
+        if (Failed(ppxres)) {
+            DestroyJob(job);
+            return ppxres;
+        }
+        job.srcViews.push_back(view);
+
+        grfx::DescriptorSetPtr set;
+        ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+        if (Failed(ppxres)) {
+            DestroyJob(job);
+            return ppxres;
+        }
+        job.sets.push_back(set);
+
+        std::array<grfx::WriteDescriptor, 2> writes = {};
+        writes[0].binding                           = COMPRESS_BLOCKS_SRC_REGISTER;
+        writes[0].type                              = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[0].pImageView                        = view;
+
+        writes[1].binding      = COMPRESS_BLOCKS_DST_REGISTER;
+        writes[1].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+        writes[1].bufferOffset = levels[level].offset;
+        writes[1].bufferRange  = static_cast<uint64_t>(levels[level].layerStride) * layerCount;
+        writes[1].pBuffer      = job.buffer;
+
+        ppxres = set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+        if (Failed(ppxres)) {
+            DestroyJob(job);
+            return ppxres;
+        }
+    }
+
+    // Tracked transitions from the states the caller gave, the destination's
+    // contents are discarded
+    pCmd->FlushBarriers();
+    pSrcImage->SetTrackedState(srcState, 0, levelCount);
+    pDstImage->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED);
+
+    pCmd->TransitionImageState(pSrcImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0, levelCount);
+    pCmd->BindComputePipeline(mPipeline);
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const LevelLayout& layout = levels[level];
+
+        const grfx::DescriptorSet* pSet = job.sets[level].Get();
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+
+        CompressBlocksParams params = {};
+        params.srcSize[0]           = layout.width;
+        params.srcSize[1]           = layout.height;
+        params.blockCount[0]        = layout.blockCountX;
+        params.blockCount[1]        = layout.blockCountY;
+        params.rowStride            = layout.rowStride;
+        params.layerStride          = layout.layerStride;
+        params.format               = GetShaderFormat(pDstImage->GetFormat());
+        params.srgb                 = srgb ? 1 : 0;
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+        pCmd->Dispatch((layout.blockCountX + kCompressBlocksGroupSize - 1) / kCompressBlocksGroupSize, (layout.blockCountY + kCompressBlocksGroupSize - 1) / kCompressBlocksGroupSize, layerCount);
+    }
+
+    // One copy per layer, D3D12 copies every layer from the same offset
+    std::vector<grfx::BufferToImageCopyInfo> copyInfos;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const LevelLayout& layout = levels[level];
+        for (uint32_t layer = 0; layer < layerCount; ++layer) {
+            grfx::BufferToImageCopyInfo copyInfo = {};
+            copyInfo.srcBuffer.imageWidth        = (layout.rowStride / blockSize) * 4;
+            copyInfo.srcBuffer.imageHeight       = layout.blockCountY * 4;
+            copyInfo.srcBuffer.imageRowStride    = layout.rowStride;
+            copyInfo.srcBuffer.footprintOffset   = layout.offset + static_cast<uint64_t>(layout.layerStride) * layer;
+            copyInfo.srcBuffer.footprintWidth    = layout.blockCountX * 4;
+            copyInfo.srcBuffer.footprintHeight   = layout.blockCountY * 4;
+            copyInfo.srcBuffer.footprintDepth    = 1;
+            copyInfo.dstImage.mipLevel           = level;
+            copyInfo.dstImage.arrayLayer         = layer;
+            copyInfo.dstImage.arrayLayerCount    = 1;
+            copyInfo.dstImage.width              = layout.width;
+            copyInfo.dstImage.height             = layout.height;
+            copyInfo.dstImage.depth              = 1;
+            copyInfos.push_back(copyInfo);
+        }
+    }
+
+    pCmd->TransitionBufferState(job.buffer, grfx::RESOURCE_STATE_COPY_SRC);
+    pCmd->TransitionImageState(pDstImage, grfx::RESOURCE_STATE_COPY_DST);
+    pCmd->FlushBarriers();
+    pCmd->CopyBufferToImage(copyInfos, job.buffer, pDstImage);
+
+    pCmd->TransitionImageState(pSrcImage, srcState, 0, levelCount);
+    pCmd->TransitionImageState(pDstImage, dstStateAfter);
+    pCmd->FlushBarriers();
+
+    mJobs.push_back(job);
+    mDispatchCount += levelCount;
+
+    return ppx::SUCCESS;
+}
+
+void BlockCompressor::Reset()
+{
+    for (auto& job : mJobs) {
+        DestroyJob(job);
+    }
+    mJobs.clear();
+    mDispatchCount = 0;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_device.h"
 
 namespace ppx {
 namespace grfx {
@@ -32,11 +33,18 @@ Result Buffer::Create(const grfx::BufferCreateInfo* pCreateInfo)
         return ppx::ERROR_GRFX_MINIMUM_BUFFER_SIZE_NOT_MET;
     }
 #endif
+    if (pCreateInfo->usageFlags.bits.shaderDeviceAddress && !GetDevice()->BufferDeviceAddressSupported()) {
+        PPX_ASSERT_MSG(false, "shaderDeviceAddress usage requires buffer device address support");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
     Result ppxres = grfx::DeviceObject<grfx::BufferCreateInfo>::Create(pCreateInfo);
     if (Failed(ppxres)) {
         return ppxres;
     }
 
+    mTrackedState = pCreateInfo->initialState;
+
     return ppx::SUCCESS;
 }
 
@@ -0,0 +1,183 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_buffer_pool.h"
+#include "ppx/grfx/grfx_device.h"
+
+#include <numeric>
+
+namespace ppx {
+namespace grfx {
+
+Result BufferPool::CreateApiObjects(const grfx::BufferPoolCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if ((pCreateInfo->blockSize == 0) || (pCreateInfo->alignment == 0)) {
+        PPX_ASSERT_MSG(false, "buffer pool block size and alignment must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (pCreateInfo->usageFlags.flags == 0) {
+        PPX_ASSERT_MSG(false, "buffer pool usage flags must not be empty");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Blocks are created on demand
+    return ppx::SUCCESS;
+}
+
+void BufferPool::DestroyApiObjects()
+{
+    if (mAllocationCount > 0) {
+        PPX_LOG_WARN("buffer pool destroyed with " << mAllocationCount << " ranges still allocated");
+    }
+
+    for (auto& block : mBlocks) {
+        if (block.buffer) {
+            GetDevice()->DestroyBuffer(block.buffer);
+            block.buffer.Reset();
+        }
+    }
+    mBlocks.clear();
+    mAllocationCount = 0;
+    mAllocatedSize   = 0;
+}
+
+Result BufferPool::CreateBlock(uint64_t size)
+{
+    grfx::BufferCreateInfo createInfo      = {};
+    createInfo.size                        = size;
+    createInfo.usageFlags                  = mCreateInfo.usageFlags;
+    createInfo.usageFlags.bits.transferDst = true;
+    createInfo.memoryUsage                 = mCreateInfo.memoryUsage;
+    createInfo.initialState                = grfx::RESOURCE_STATE_GENERAL;
+    createInfo.ownership                   = grfx::OWNERSHIP_REFERENCE;
+
+    Block  block  = {};
+    Result ppxres = GetDevice()->CreateBuffer(&createInfo, &block.buffer);
+    if (Failed(ppxres)) {
+        return ppx::ERROR_OUT_OF_MEMORY;
+    }
+
+    block.freeRanges.push_back({0, size});
+    mBlocks.push_back(block);
+
+    return ppx::SUCCESS;
+}
+
+bool BufferPool::AllocateFromBlock(Block& block, uint64_t size, uint64_t alignment, grfx::BufferRange* pRange)
+{
+    for (size_t i = 0; i < block.freeRanges.size(); ++i) {
+        const FreeRange freeRange = block.freeRanges[i];
+
+        const uint64_t offset  = ((freeRange.offset + alignment - 1) / alignment) * alignment;
+        const uint64_t padding = offset - freeRange.offset;
+        if ((padding + size) > freeRange.size) {
+            continue;
+        }
+
+        // Keep the padding in front and whatever is left behind the range free
+        std::vector<FreeRange> remainder;
+        if (padding > 0) {
+            remainder.push_back({freeRange.offset, padding});
+        }
+        if ((padding + size) < freeRange.size) {
+            remainder.push_back({offset + size, freeRange.size - padding - size});
+        }
+        block.freeRanges.erase(block.freeRanges.begin() + i);
+        block.freeRanges.insert(block.freeRanges.begin() + i, remainder.begin(), remainder.end());
+
+        pRange->pBuffer = block.buffer;
+        pRange->offset  = offset;
+        pRange->size    = size;
+        return true;
+    }
+    return false;
+}
+
+Result BufferPool::Allocate(uint64_t size, grfx::BufferRange* pRange)
+{
+    return Allocate(size, mCreateInfo.alignment, pRange);
+}
+
+Result BufferPool::Allocate(uint64_t size, uint32_t alignment, grfx::BufferRange* pRange)
+{
+    PPX_ASSERT_NULL_ARG(pRange);
+    PPX_ASSERT_MSG(size > 0, "buffer pool allocation size must be non-zero");
+
+    // Least common multiple so that both the pool's and the caller's
+    // alignment hold, e.g. for vertex strides that aren't a power of two.
+    const uint64_t poolAlignment  = mCreateInfo.alignment;
+    const uint64_t rangeAlignment = (alignment > 0) ? std::lcm<uint64_t>(poolAlignment, alignment) : poolAlignment;
+
+    bool allocated = false;
+    for (auto& block : mBlocks) {
+        allocated = AllocateFromBlock(block, size, rangeAlignment, pRange);
+        if (allocated) {
+            break;
+        }
+    }
+
+    if (!allocated) {
+        Result ppxres = CreateBlock(std::max<uint64_t>(size, mCreateInfo.blockSize));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        // Offset 0 satisfies any alignment
+        allocated = AllocateFromBlock(mBlocks.back(), size, rangeAlignment, pRange);
+        PPX_ASSERT_MSG(allocated, "buffer pool allocation from new block failed");
+    }
+
+    ++mAllocationCount;
+    mAllocatedSize += size;
+
+    return ppx::SUCCESS;
+}
+
+void BufferPool::Free(const grfx::BufferRange& range)
+{
+    if (!range.IsValid()) {
+        return;
+    }
+
+    auto it = std::find_if(mBlocks.begin(), mBlocks.end(), [&range](const Block& block) { return block.buffer.Get() == range.pBuffer; });
+    if (it == mBlocks.end()) {
+        PPX_ASSERT_MSG(false, "buffer range was not allocated from this pool");
+        return;
+    }
+
+    // Insert sorted and merge with the neighbours
+    std::vector<FreeRange>& freeRanges = it->freeRanges;
+    auto                    next       = std::lower_bound(freeRanges.begin(), freeRanges.end(), range.offset, [](const FreeRange& freeRange, uint64_t offset) { return freeRange.offset < offset; });
+    auto                    current    = freeRanges.insert(next, {range.offset, range.size});
+
+    auto following = current + 1;
+    if ((following != freeRanges.end()) && ((current->offset + current->size) == following->offset)) {
+        current->size += following->size;
+        freeRanges.erase(following);
+    }
+    if (current != freeRanges.begin()) {
+        auto previous = current - 1;
+        if ((previous->offset + previous->size) == current->offset) {
+            previous->size += current->size;
+            freeRanges.erase(current);
+        }
+    }
+
+    --mAllocationCount;
+    mAllocatedSize -= range.size;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -21,6 +21,7 @@
 #include "ppx/grfx/grfx_mesh.h"
 #include "ppx/grfx/grfx_render_pass.h"
 #include "ppx/grfx/grfx_texture.h"
+#include "ppx/frame_arena.h"
 
 namespace ppx {
 namespace grfx {
@@ -35,6 +36,36 @@ bool CommandBuffer::HasActiveRenderPass() const
     return !IsNull(mCurrentRenderPass) || mDynamicRenderPassActive;
 }
 
+Result CommandBuffer::BeginSecondary(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo)
+{
+    PPX_ASSERT_NULL_ARG(pInheritanceInfo);
+    if (!IsSecondary()) {
+        PPX_ASSERT_MSG(false, "BeginSecondary requires a secondary command buffer");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    return BeginSecondaryImpl(pInheritanceInfo);
+}
+
+void CommandBuffer::ExecuteCommands(
+    uint32_t                          commandBufferCount,
+    const grfx::CommandBuffer* const* ppCommandBuffers)
+{
+    PPX_ASSERT_MSG(!IsSecondary(), "secondary command buffers cannot execute other command buffers");
+    if (commandBufferCount == 0) {
+        return;
+    }
+    PPX_ASSERT_NULL_ARG(ppCommandBuffers);
+
+    for (uint32_t i = 0; i < commandBufferCount; ++i) {
+        PPX_ASSERT_MSG(!IsNull(ppCommandBuffers[i]), "ppCommandBuffers[" << i << "] is null");
+        PPX_ASSERT_MSG(ppCommandBuffers[i]->IsSecondary(), "ppCommandBuffers[" << i << "] is not a secondary command buffer");
+    }
+
+    FlushBarriers();
+    ExecuteCommandsImpl(commandBufferCount, ppCommandBuffers);
+}
+
 void CommandBuffer::BeginRenderPass(const grfx::RenderPassBeginInfo* pBeginInfo)
 {
     if (HasActiveRenderPass()) {
@@ -49,6 +80,7 @@ void CommandBuffer::BeginRenderPass(const grfx::RenderPassBeginInfo* pBeginInfo)
         }
     }
 
+    FlushBarriers();
     BeginRenderPassImpl(pBeginInfo);
     mCurrentRenderPass = pBeginInfo->pRenderPass;
 }
@@ -69,6 +101,7 @@ void CommandBuffer::BeginRendering(const grfx::RenderingInfo* pRenderingInfo)
     PPX_ASSERT_NULL_ARG(pRenderingInfo);
     PPX_ASSERT_MSG(!HasActiveRenderPass(), "cannot nest render passes");
 
+    FlushBarriers();
     BeginRenderingImpl(pRenderingInfo);
     mDynamicRenderPassActive           = true;
     mDynamicRenderPassInfo.mRenderArea = pRenderingInfo->renderArea;
@@ -90,13 +123,14 @@ void CommandBuffer::EndRendering()
     mDynamicRenderPassInfo   = {};
 }
 
-void CommandBuffer::BeginRenderPass(const grfx::RenderPass* pRenderPass)
+void CommandBuffer::BeginRenderPass(const grfx::RenderPass* pRenderPass, bool secondaryCommandBuffers)
 {
     PPX_ASSERT_NULL_ARG(pRenderPass);
 
     grfx::RenderPassBeginInfo beginInfo = {};
     beginInfo.pRenderPass               = pRenderPass;
     beginInfo.renderArea                = pRenderPass->GetRenderArea();
+    beginInfo.secondaryCommandBuffers   = secondaryCommandBuffers;
 
     beginInfo.RTVClearCount = pRenderPass->GetRenderTargetCount();
     for (uint32_t i = 0; i < beginInfo.RTVClearCount; ++i) {
@@ -217,6 +251,195 @@ void CommandBuffer::TransitionImageLayout(
     }
 }
 
+void CommandBuffer::TransitionImageState(
+    grfx::DrawPass*     pDrawPass,
+    grfx::ResourceState renderTargetState,
+    grfx::ResourceState depthStencilTargetState)
+{
+    PPX_ASSERT_NULL_ARG(pDrawPass);
+
+    const uint32_t n = pDrawPass->GetRenderTargetCount();
+    for (uint32_t i = 0; i < n; ++i) {
+        grfx::Texture* pRenderTarget = pDrawPass->GetRenderTargetTexture(i);
+        PPX_ASSERT_MSG(!IsNull(pRenderTarget), "failed getting draw pass render target");
+
+        TransitionImageState(pRenderTarget->GetImage(), renderTargetState);
+    }
+
+    if (pDrawPass->HasDepthStencil()) {
+        TransitionImageState(pDrawPass->GetDepthStencilTexture()->GetImage(), depthStencilTargetState);
+    }
+}
+
+void CommandBuffer::TransitionImageState(
+    grfx::Image*        pImage,
+    grfx::ResourceState afterState,
+    uint32_t            mipLevel,
+    uint32_t            mipLevelCount,
+    uint32_t            arrayLayer,
+    uint32_t            arrayLayerCount)
+{
+    PPX_ASSERT_NULL_ARG(pImage);
+    PPX_ASSERT_MSG(!HasActiveRenderPass(), "tracked transitions cannot be recorded inside a render pass");
+
+    if (mipLevelCount == PPX_REMAINING_MIP_LEVELS) {
+        mipLevelCount = pImage->GetMipLevelCount() - mipLevel;
+    }
+    if (arrayLayerCount == PPX_REMAINING_ARRAY_LAYERS) {
+        arrayLayerCount = pImage->GetArrayLayerCount() - arrayLayer;
+    }
+
+    for (uint32_t layer = arrayLayer; layer < (arrayLayer + arrayLayerCount); ++layer) {
+        for (uint32_t mip = mipLevel; mip < (mipLevel + mipLevelCount); ++mip) {
+            grfx::ResourceState beforeState = pImage->GetTrackedState(mip, layer);
+            if (beforeState == afterState) {
+                continue;
+            }
+            pImage->SetTrackedState(afterState, mip, 1, layer, 1);
+
+            // A subresource can only appear once in a barrier call, so fold
+            // this transition into a pending one for the same subresource.
+            auto it = std::find_if(
+                mPendingImageBarriers.begin(),
+                mPendingImageBarriers.end(),
+                [pImage, mip, layer](const ImageBarrier& elem) -> bool {
+                    return (elem.pImage == pImage) && (elem.mipLevel == mip) && (elem.arrayLayer == layer); });
+            if (it != mPendingImageBarriers.end()) {
+                it->afterState = afterState;
+                if (it->beforeState == it->afterState) {
+                    mPendingImageBarriers.erase(it);
+                }
+                continue;
+            }
+
+            ImageBarrier barrier    = {};
+            barrier.pImage          = pImage;
+            barrier.mipLevel        = mip;
+            barrier.mipLevelCount   = 1;
+            barrier.arrayLayer      = layer;
+            barrier.arrayLayerCount = 1;
+            barrier.beforeState     = beforeState;
+            barrier.afterState      = afterState;
+            mPendingImageBarriers.push_back(barrier);
+        }
+    }
+}
+
+void CommandBuffer::TransitionBufferState(
+    grfx::Buffer*       pBuffer,
+    grfx::ResourceState afterState)
+{
+    PPX_ASSERT_NULL_ARG(pBuffer);
+    PPX_ASSERT_MSG(!HasActiveRenderPass(), "tracked transitions cannot be recorded inside a render pass");
+
+    grfx::ResourceState beforeState = pBuffer->GetTrackedState();
+    if (beforeState == afterState) {
+        return;
+    }
+    pBuffer->SetTrackedState(afterState);
+
+    auto it = std::find_if(
+        mPendingBufferBarriers.begin(),
+        mPendingBufferBarriers.end(),
+        [pBuffer](const BufferBarrier& elem) -> bool { return elem.pBuffer == pBuffer; });
+    if (it != mPendingBufferBarriers.end()) {
+        it->afterState = afterState;
+        if (it->beforeState == it->afterState) {
+            mPendingBufferBarriers.erase(it);
+        }
+        return;
+    }
+
+    BufferBarrier barrier = {};
+    barrier.pBuffer       = pBuffer;
+    barrier.beforeState   = beforeState;
+    barrier.afterState    = afterState;
+    mPendingBufferBarriers.push_back(barrier);
+}
+
+void CommandBuffer::AliasingBarrier(const grfx::Image* pBefore, grfx::Image* pAfter)
+{
+    PPX_ASSERT_NULL_ARG(pAfter);
+    PPX_ASSERT_MSG(!HasActiveRenderPass(), "aliasing barriers cannot be recorded inside a render pass");
+    PPX_ASSERT_MSG(IsNull(pBefore) || (pBefore != pAfter), "pBefore and pAfter must be different images");
+
+    // Pending transitions of pBefore must land before the memory changes hands
+    FlushBarriers();
+    AliasingBarrierImpl(pBefore, pAfter);
+}
+
+void CommandBuffer::FlushBarriers()
+{
+    if (mPendingImageBarriers.empty() && mPendingBufferBarriers.empty()) {
+        return;
+    }
+
+    // Sort so that subresources that share an image and a transition are
+    // adjacent, ordered by mip level then array layer.
+    std::sort(
+        mPendingImageBarriers.begin(),
+        mPendingImageBarriers.end(),
+        [](const ImageBarrier& a, const ImageBarrier& b) -> bool {
+            if (a.pImage != b.pImage) {
+                return std::less<const grfx::Image*>()(a.pImage, b.pImage);
+            }
+            if (a.beforeState != b.beforeState) {
+                return a.beforeState < b.beforeState;
+            }
+            if (a.afterState != b.afterState) {
+                return a.afterState < b.afterState;
+            }
+            if (a.mipLevel != b.mipLevel) {
+                return a.mipLevel < b.mipLevel;
+            }
+            return a.arrayLayer < b.arrayLayer;
+        });
+
+    auto isSameTransition = [](const ImageBarrier& a, const ImageBarrier& b) -> bool {
+        return (a.pImage == b.pImage) && (a.beforeState == b.beforeState) && (a.afterState == b.afterState);
+    };
+
+    // Merged barriers are temporary, command buffers can be recorded on any thread
+    FrameArena::Scope scope(FrameArena::GetThreadArena());
+
+    // Merge contiguous array layers of the same mip level
+    FrameVector<ImageBarrier> layerRanges(scope.GetAllocator<ImageBarrier>());
+    layerRanges.reserve(mPendingImageBarriers.size());
+    for (const ImageBarrier& barrier : mPendingImageBarriers) {
+        if (!layerRanges.empty()) {
+            ImageBarrier& last = layerRanges.back();
+            if (isSameTransition(last, barrier) && (last.mipLevel == barrier.mipLevel) && ((last.arrayLayer + last.arrayLayerCount) == barrier.arrayLayer)) {
+                last.arrayLayerCount += 1;
+                continue;
+            }
+        }
+        layerRanges.push_back(barrier);
+    }
+
+    // Merge contiguous mip levels that cover the same array layers
+    FrameVector<ImageBarrier> imageBarriers(scope.GetAllocator<ImageBarrier>());
+    imageBarriers.reserve(layerRanges.size());
+    for (const ImageBarrier& barrier : layerRanges) {
+        if (!imageBarriers.empty()) {
+            ImageBarrier& last = imageBarriers.back();
+            if (isSameTransition(last, barrier) && (last.arrayLayer == barrier.arrayLayer) && (last.arrayLayerCount == barrier.arrayLayerCount) && ((last.mipLevel + last.mipLevelCount) == barrier.mipLevel)) {
+                last.mipLevelCount += 1;
+                continue;
+            }
+        }
+        imageBarriers.push_back(barrier);
+    }
+
+    ResourceBarriersImpl(
+        CountU32(imageBarriers),
+        DataPtr(imageBarriers),
+        CountU32(mPendingBufferBarriers),
+        DataPtr(mPendingBufferBarriers));
+
+    mPendingImageBarriers.clear();
+    mPendingBufferBarriers.clear();
+}
+
 void CommandBuffer::SetViewports(const grfx::Viewport& viewport)
 {
     SetViewports(1, &viewport);
@@ -243,7 +466,8 @@ void CommandBuffer::BindIndexBuffer(const grfx::Mesh* pMesh, uint64_t offset)
 {
     PPX_ASSERT_NULL_ARG(pMesh);
 
-    BindIndexBuffer(pMesh->GetIndexBuffer(), pMesh->GetIndexType(), offset);
+    // Pooled meshes start at an offset into the pool's buffer
+    BindIndexBuffer(pMesh->GetIndexBuffer(), pMesh->GetIndexType(), pMesh->GetIndexBufferOffset() + offset);
 }
 
 void CommandBuffer::BindVertexBuffers(
@@ -274,14 +498,16 @@ void CommandBuffer::BindVertexBuffers(const grfx::Mesh* pMesh, const uint64_t* p
 
     const grfx::Buffer* buffers[PPX_MAX_VERTEX_BINDINGS] = {nullptr};
     uint32_t            strides[PPX_MAX_VERTEX_BINDINGS] = {0};
+    uint64_t            offsets[PPX_MAX_VERTEX_BINDINGS] = {0};
 
     uint32_t bufferCount = pMesh->GetVertexBufferCount();
     for (uint32_t i = 0; i < bufferCount; ++i) {
         buffers[i] = pMesh->GetVertexBuffer(i);
         strides[i] = pMesh->GetVertexBufferDescription(i)->stride;
+        offsets[i] = pMesh->GetVertexBufferOffset(i) + (IsNull(pOffsets) ? 0 : pOffsets[i]);
     }
 
-    BindVertexBuffers(bufferCount, buffers, strides, pOffsets);
+    BindVertexBuffers(bufferCount, buffers, strides, offsets);
 }
 
 void CommandBuffer::Draw(const grfx::FullscreenQuad* pQuad, uint32_t setCount, const grfx::DescriptorSet* const* ppSets)
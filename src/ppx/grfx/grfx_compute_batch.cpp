@@ -0,0 +1,216 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_compute_batch.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_sync.h"
+
+namespace ppx {
+namespace grfx {
+
+Result ComputeBatchRunner::CreateApiObjects(const grfx::ComputeBatchRunnerCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->pQueue)) {
+        PPX_ASSERT_MSG(false, "compute batch runner needs a queue");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((pCreateInfo->inFlightCount == 0) || (pCreateInfo->jobsPerSubmit == 0)) {
+        PPX_ASSERT_MSG(false, "compute batch runner in flight count and jobs per submit must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mSlots.resize(pCreateInfo->inFlightCount);
+    for (auto& slot : mSlots) {
+        Result ppxres = pCreateInfo->pQueue->CreateCommandBuffer(&slot.cmd);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        grfx::FenceCreateInfo fenceCreateInfo = {};
+        ppxres                                = GetDevice()->CreateFence(&fenceCreateInfo, &slot.fence);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void ComputeBatchRunner::DestroyApiObjects()
+{
+    // Pending callbacks are dropped, the objects they reference may
+    // already be gone
+    for (auto& slot : mSlots) {
+        if (slot.inFlight) {
+            slot.fence->Wait();
+        }
+        if (slot.cmd) {
+            mCreateInfo.pQueue->DestroyCommandBuffer(slot.cmd);
+        }
+        if (slot.fence) {
+            GetDevice()->DestroyFence(slot.fence);
+        }
+    }
+    mSlots.clear();
+}
+
+Result ComputeBatchRunner::Retire(Slot& slot)
+{
+    if (!slot.inFlight) {
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = slot.fence->WaitAndReset();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    mCompletedJobCount += slot.jobCount;
+    slot.jobCount = 0;
+    slot.inFlight = false;
+
+    // Callbacks may add jobs, which can reuse the slot
+    std::vector<CompleteFn> completions;
+    completions.swap(slot.completions);
+    for (auto& fn : completions) {
+        fn();
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ComputeBatchRunner::Add(const RecordFn& record, const CompleteFn& onComplete)
+{
+    PPX_ASSERT_MSG(static_cast<bool>(record), "compute batch job needs a record function");
+
+    Slot& slot = mSlots[mCurrentSlot];
+    if (!slot.recording) {
+        Result ppxres = Retire(slot);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = slot.cmd->Begin();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        slot.recording = true;
+    }
+
+    record(slot.cmd);
+    if (onComplete) {
+        slot.completions.push_back(onComplete);
+    }
+    slot.jobCount += 1;
+
+    if (slot.jobCount >= mCreateInfo.jobsPerSubmit) {
+        return Flush();
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ComputeBatchRunner::Flush()
+{
+    Slot& slot = mSlots[mCurrentSlot];
+    if (!slot.recording) {
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = slot.cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    slot.recording = false;
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &slot.cmd;
+    submitInfo.pFence             = slot.fence;
+
+    ppxres = mCreateInfo.pQueue->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    slot.inFlight = true;
+
+    mSubmittedJobCount += slot.jobCount;
+    mSubmitCount += 1;
+    mCurrentSlot = (mCurrentSlot + 1) % CountU32(mSlots);
+
+    return ppx::SUCCESS;
+}
+
+Result ComputeBatchRunner::Poll()
+{
+    // Submits complete in order, stop at the first one that hasn't
+    const uint32_t slotCount = CountU32(mSlots);
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        Slot& slot = mSlots[(mCurrentSlot + i) % slotCount];
+        if (!slot.inFlight) {
+            continue;
+        }
+        if (!slot.fence->IsSignaled()) {
+            break;
+        }
+
+        Result ppxres = Retire(slot);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ComputeBatchRunner::WaitIdle()
+{
+    Result ppxres = Flush();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Callbacks can add and flush jobs, keep going until nothing is left
+    bool retired = true;
+    while (retired) {
+        retired = false;
+
+        const uint32_t slotCount = CountU32(mSlots);
+        for (uint32_t i = 0; i < slotCount; ++i) {
+            Slot& slot = mSlots[(mCurrentSlot + i) % slotCount];
+            if (!slot.inFlight) {
+                continue;
+            }
+
+            ppxres = Retire(slot);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            retired = true;
+        }
+
+        ppxres = Flush();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
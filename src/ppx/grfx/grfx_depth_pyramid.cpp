@@ -0,0 +1,416 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_depth_pyramid.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_draw_pass.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_texture.h"
+
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in DepthPyramid.hlsl
+enum
+{
+    DEPTH_PYRAMID_PARAMS_REGISTER  = 0,
+    DEPTH_PYRAMID_DEPTH_REGISTER   = 1,
+    DEPTH_PYRAMID_COUNTER_REGISTER = 2,
+    DEPTH_PYRAMID_LEVEL5_REGISTER  = 3,
+    DEPTH_PYRAMID_LEVELS_REGISTER  = 4,
+};
+
+// Must match DepthPyramid.hlsl
+struct DepthPyramidParams
+{
+    uint32_t depthSize[2];
+    uint32_t level0Size[2];
+    uint32_t levelCount;
+    uint32_t groupCount;
+    uint32_t padding[2];
+};
+
+// Level 0 texels per group in each dimension, the group reduces them to
+// 1 texel of level 5
+static const uint32_t kTileSize = 32;
+
+static uint32_t NextPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+void DepthPyramid::GetSize(uint32_t depthWidth, uint32_t depthHeight, uint32_t* pWidth, uint32_t* pHeight, uint32_t* pLevelCount)
+{
+    *pWidth      = NextPowerOfTwo((depthWidth + 1) / 2);
+    *pHeight     = NextPowerOfTwo((depthHeight + 1) / 2);
+    *pLevelCount = 1;
+    for (uint32_t size = std::max(*pWidth, *pHeight); size > 1; size /= 2) {
+        *pLevelCount += 1;
+    }
+}
+
+float2 DepthPyramid::GetUVScale() const
+{
+    return float2(
+        static_cast<float>(mCreateInfo.width) / static_cast<float>(2 * mWidth),
+        static_cast<float>(mCreateInfo.height) / static_cast<float>(2 * mHeight));
+}
+
+Result DepthPyramid::CreateApiObjects(const grfx::DepthPyramidCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->CS.pModule)) {
+        PPX_ASSERT_MSG(false, "depth pyramid shader must not be null");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((pCreateInfo->width == 0) || (pCreateInfo->height == 0) || (pCreateInfo->maxDepthImages == 0)) {
+        PPX_ASSERT_MSG(false, "depth pyramid size and max depth images must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((pCreateInfo->width > kMaxDepthSize) || (pCreateInfo->height > kMaxDepthSize)) {
+        PPX_ASSERT_MSG(false, "depth pyramid source exceeds " << kMaxDepthSize << " texels");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    GetSize(pCreateInfo->width, pCreateInfo->height, &mWidth, &mHeight, &mLevelCount);
+
+    // Pyramid
+    Result ppxres = ppx::SUCCESS;
+    {
+        grfx::ImageCreateInfo createInfo   = {};
+        createInfo.type                    = grfx::IMAGE_TYPE_2D;
+        createInfo.width                   = mWidth;
+        createInfo.height                  = mHeight;
+        createInfo.depth                   = 1;
+        createInfo.format                  = grfx::FORMAT_R32G32_FLOAT;
+        createInfo.mipLevelCount           = mLevelCount;
+        createInfo.usageFlags.bits.sampled = true;
+        createInfo.usageFlags.bits.storage = true;
+        createInfo.initialState            = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        ppxres = GetDevice()->CreateImage(&createInfo, &mImage);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating depth pyramid image");
+            return ppxres;
+        }
+
+        grfx::SampledImageViewCreateInfo sampledViewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(mImage);
+        ppxres                                                 = GetDevice()->CreateSampledImageView(&sampledViewCreateInfo, &mSampledView);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating depth pyramid sampled view");
+            return ppxres;
+        }
+
+        for (uint32_t level = 0; level < mLevelCount; ++level) {
+            grfx::StorageImageViewCreateInfo storageViewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(mImage);
+            storageViewCreateInfo.mipLevel                         = level;
+            storageViewCreateInfo.mipLevelCount                    = 1;
+
+            grfx::StorageImageViewPtr storageView;
+            ppxres = GetDevice()->CreateStorageImageView(&storageViewCreateInfo, &storageView);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "failed creating depth pyramid storage view");
+                return ppxres;
+            }
+            mStorageViews.push_back(storageView);
+        }
+    }
+
+    // Counter of the groups that finished levels 0 to 5
+    {
+        grfx::BufferCreateInfo createInfo             = {};
+        createInfo.size                               = sizeof(uint32_t);
+        createInfo.structuredElementStride            = sizeof(uint32_t);
+        createInfo.usageFlags.bits.rwStructuredBuffer = true;
+        createInfo.usageFlags.bits.transferDst        = true;
+        createInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                       = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+
+        ppxres = GetDevice()->CreateBuffer(&createInfo, &mCounterBuffer);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating depth pyramid counter buffer");
+            return ppxres;
+        }
+
+        createInfo                             = {};
+        createInfo.size                        = sizeof(uint32_t);
+        createInfo.usageFlags.bits.transferSrc = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        ppxres = GetDevice()->CreateBuffer(&createInfo, &mCounterClearBuffer);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating depth pyramid counter clear buffer");
+            return ppxres;
+        }
+
+        const uint32_t zero = 0;
+        ppxres              = mCounterClearBuffer->CopyFromSource(sizeof(zero), &zero);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Descriptors
+    {
+        const uint32_t setCount = pCreateInfo->maxDepthImages;
+
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sampledImage                   = setCount;
+        poolCreateInfo.structuredBuffer               = setCount;
+        poolCreateInfo.storageImage                   = (1 + kMaxLevelCount) * setCount;
+
+        ppxres = GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating depth pyramid descriptor pool");
+            return ppxres;
+        }
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DEPTH_PYRAMID_DEPTH_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DEPTH_PYRAMID_COUNTER_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DEPTH_PYRAMID_LEVEL5_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DEPTH_PYRAMID_LEVELS_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE, kMaxLevelCount));
+
+        ppxres = GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating depth pyramid descriptor set layout");
+            return ppxres;
+        }
+    }
+
+    // Pipeline interface
+    {
+        grfx::PipelineInterfaceCreateInfo createInfo = {};
+        createInfo.setCount                          = 1;
+        createInfo.sets[0].set                       = 0;
+        createInfo.sets[0].pLayout                   = mSetLayout;
+        createInfo.pushConstants.count               = sizeof(DepthPyramidParams) / sizeof(uint32_t);
+        createInfo.pushConstants.binding             = DEPTH_PYRAMID_PARAMS_REGISTER;
+        createInfo.pushConstants.set                 = 0;
+
+        ppxres = GetDevice()->CreatePipelineInterface(&createInfo, &mPipelineInterface);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline interface");
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::ComputePipelineCreateInfo createInfo = {};
+        createInfo.CS                              = {pCreateInfo->CS.pModule, pCreateInfo->CS.entryPoint};
+        createInfo.pPipelineInterface              = mPipelineInterface;
+
+        ppxres = GetDevice()->CreateComputePipeline(&createInfo, &mPipeline);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline");
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void DepthPyramid::DestroyApiObjects()
+{
+    for (auto& it : mDepthSources) {
+        GetDevice()->FreeDescriptorSet(it.second.set);
+        GetDevice()->DestroySampledImageView(it.second.view);
+    }
+    mDepthSources.clear();
+
+    if (mPipeline) {
+        GetDevice()->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        GetDevice()->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        GetDevice()->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        GetDevice()->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mCounterClearBuffer) {
+        GetDevice()->DestroyBuffer(mCounterClearBuffer);
+        mCounterClearBuffer.Reset();
+    }
+
+    if (mCounterBuffer) {
+        GetDevice()->DestroyBuffer(mCounterBuffer);
+        mCounterBuffer.Reset();
+    }
+
+    for (auto& view : mStorageViews) {
+        GetDevice()->DestroyStorageImageView(view);
+    }
+    mStorageViews.clear();
+
+    if (mSampledView) {
+        GetDevice()->DestroySampledImageView(mSampledView);
+        mSampledView.Reset();
+    }
+
+    if (mImage) {
+        GetDevice()->DestroyImage(mImage);
+        mImage.Reset();
+    }
+}
+
+Result DepthPyramid::GetDepthSource(grfx::Image* pDepthImage, DepthSource** ppSource)
+{
+    auto it = mDepthSources.find(pDepthImage);
+    if (it != mDepthSources.end()) {
+        *ppSource = &it->second;
+        return ppx::SUCCESS;
+    }
+
+    if (CountU32(mDepthSources) >= mCreateInfo.maxDepthImages) {
+        PPX_ASSERT_MSG(false, "DepthPyramid: more distinct depth images than DepthPyramidCreateInfo::maxDepthImages");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    DepthSource source = {};
+
+    grfx::SampledImageViewCreateInfo viewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(pDepthImage);
+    viewCreateInfo.mipLevelCount                    = 1;
+
+    Result ppxres = GetDevice()->CreateSampledImageView(&viewCreateInfo, &source.view);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = GetDevice()->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &source.set);
+    if (Failed(ppxres)) {
+        GetDevice()->DestroySampledImageView(source.view);
+        return ppxres;
+    }
+
+    // Levels past the last one are never written but must be valid
+    std::array<grfx::WriteDescriptor, 3 + kMaxLevelCount> writes = {};
+    writes[0].binding                                            = DEPTH_PYRAMID_DEPTH_REGISTER;
+    writes[0].type                                               = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageView                                         = source.view;
+    writes[1].binding                                            = DEPTH_PYRAMID_COUNTER_REGISTER;
+    writes[1].type                                               = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+    writes[1].bufferOffset                                       = 0;
+    writes[1].bufferRange                                        = PPX_WHOLE_SIZE;
+    writes[1].structuredElementCount                             = 1;
+    writes[1].pBuffer                                            = mCounterBuffer;
+    writes[2].binding                                            = DEPTH_PYRAMID_LEVEL5_REGISTER;
+    writes[2].type                                               = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[2].pImageView                                         = mStorageViews[std::min<uint32_t>(5, mLevelCount - 1)];
+    for (uint32_t level = 0; level < kMaxLevelCount; ++level) {
+        grfx::WriteDescriptor& write = writes[3 + level];
+        write.binding                = DEPTH_PYRAMID_LEVELS_REGISTER;
+        write.arrayIndex             = level;
+        write.type                   = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        write.pImageView             = mStorageViews[std::min(level, mLevelCount - 1)];
+    }
+
+    ppxres = source.set->UpdateDescriptors(CountU32(writes), writes.data());
+    if (Failed(ppxres)) {
+        GetDevice()->FreeDescriptorSet(source.set);
+        GetDevice()->DestroySampledImageView(source.view);
+        return ppxres;
+    }
+
+    *ppSource = &mDepthSources.emplace(pDepthImage, source).first->second;
+
+    return ppx::SUCCESS;
+}
+
+Result DepthPyramid::Build(grfx::CommandBuffer* pCommandBuffer, grfx::Image* pDepthImage, grfx::ResourceState depthState)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+
+    if (IsNull(pDepthImage)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((pDepthImage->GetWidth() != mCreateInfo.width) || (pDepthImage->GetHeight() != mCreateInfo.height)) {
+        PPX_ASSERT_MSG(false, "depth pyramid source size doesn't match DepthPyramidCreateInfo");
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    DepthSource* pSource = nullptr;
+    Result       ppxres  = GetDepthSource(pDepthImage, &pSource);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Clearing the counter every build also orders it after the previous
+    // build's dispatch
+    {
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = sizeof(uint32_t);
+
+        pCommandBuffer->BufferResourceBarrier(mCounterBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_DST);
+        pCommandBuffer->CopyBufferToBuffer(&copyInfo, mCounterClearBuffer, mCounterBuffer);
+        pCommandBuffer->BufferResourceBarrier(mCounterBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    }
+
+    const uint32_t groupCountX = std::max<uint32_t>(mWidth / kTileSize, 1);
+    const uint32_t groupCountY = std::max<uint32_t>(mHeight / kTileSize, 1);
+
+    DepthPyramidParams params = {};
+    params.depthSize[0]       = mCreateInfo.width;
+    params.depthSize[1]       = mCreateInfo.height;
+    params.level0Size[0]      = mWidth;
+    params.level0Size[1]      = mHeight;
+    params.levelCount         = mLevelCount;
+    params.groupCount         = groupCountX * groupCountY;
+
+    pCommandBuffer->TransitionImageLayout(pDepthImage, PPX_ALL_SUBRESOURCES, depthState, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCommandBuffer->TransitionImageLayout(mImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+
+    const grfx::DescriptorSet* pSet = pSource->set;
+    pCommandBuffer->BindComputePipeline(mPipeline);
+    pCommandBuffer->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCommandBuffer->PushComputeConstants(mPipelineInterface, sizeof(DepthPyramidParams) / sizeof(uint32_t), &params);
+    pCommandBuffer->Dispatch(groupCountX, groupCountY, 1);
+
+    pCommandBuffer->TransitionImageLayout(mImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+    pCommandBuffer->TransitionImageLayout(pDepthImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, depthState);
+
+    return ppx::SUCCESS;
+}
+
+Result DepthPyramid::Build(grfx::CommandBuffer* pCommandBuffer, grfx::DrawPass* pDrawPass, grfx::ResourceState depthState)
+{
+    if (IsNull(pDrawPass) || IsNull(pDrawPass->GetDepthStencilTexture())) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    return Build(pCommandBuffer, pDrawPass->GetDepthStencilTexture()->GetImage(), depthState);
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
 #include "ppx/grfx/grfx_image.h"
 #include "ppx/grfx/grfx_texture.h"
 
@@ -111,6 +112,37 @@ Result DescriptorSet::UpdateUniformBuffer(
     return ppx::SUCCESS;
 }
 
+Result DescriptorSet::UpdateAccelerationStructure(
+    uint32_t                           binding,
+    uint32_t                           arrayIndex,
+    const grfx::AccelerationStructure* pAccelerationStructure)
+{
+    grfx::WriteDescriptor write  = {};
+    write.binding                = binding;
+    write.arrayIndex             = arrayIndex;
+    write.type                   = grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE;
+    write.pAccelerationStructure = pAccelerationStructure;
+
+    Result ppxres = UpdateDescriptors(1, &write);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void DescriptorSet::RecordWrites(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
+{
+    if (!GetDevice()->IsDefragmentationEnabled()) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        uint64_t key         = (static_cast<uint64_t>(pWrites[i].binding) << 32) | pWrites[i].arrayIndex;
+        mRecordedWrites[key] = pWrites[i];
+    }
+}
+
 // -------------------------------------------------------------------------------------------------
 // DescriptorSetLayout
 // -------------------------------------------------------------------------------------------------
@@ -0,0 +1,204 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/grfx/grfx_descriptor_allocator.h"
+#include "ppx/grfx/grfx_device.h"
+
+namespace ppx {
+namespace grfx {
+
+// Every per-type count in DescriptorPoolCreateInfo
+static uint32_t grfx::DescriptorPoolCreateInfo::*const kDescriptorPoolCounts[] = {
+    &grfx::DescriptorPoolCreateInfo::sampler,
+    &grfx::DescriptorPoolCreateInfo::combinedImageSampler,
+    &grfx::DescriptorPoolCreateInfo::sampledImage,
+    &grfx::DescriptorPoolCreateInfo::storageImage,
+    &grfx::DescriptorPoolCreateInfo::uniformTexelBuffer,
+    &grfx::DescriptorPoolCreateInfo::storageTexelBuffer,
+    &grfx::DescriptorPoolCreateInfo::uniformBuffer,
+    &grfx::DescriptorPoolCreateInfo::rawStorageBuffer,
+    &grfx::DescriptorPoolCreateInfo::structuredBuffer,
+    &grfx::DescriptorPoolCreateInfo::uniformBufferDynamic,
+    &grfx::DescriptorPoolCreateInfo::storageBufferDynamic,
+    &grfx::DescriptorPoolCreateInfo::inputAttachment,
+    &grfx::DescriptorPoolCreateInfo::accelerationStructure,
+};
+
+static grfx::DescriptorPoolCreateInfo GetLayoutDescriptorCounts(const grfx::DescriptorSetLayout* pLayout)
+{
+    grfx::DescriptorPoolCreateInfo counts = {};
+    for (const auto& binding : pLayout->GetBindings()) {
+        // clang-format off
+        switch (binding.type) {
+            default: break;
+            case grfx::DESCRIPTOR_TYPE_SAMPLER                : counts.sampler += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : counts.combinedImageSampler += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE          : counts.sampledImage += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE          : counts.storageImage += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER   : counts.uniformTexelBuffer += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER   : counts.storageTexelBuffer += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER         : counts.uniformBuffer += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER     : counts.rawStorageBuffer += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER   : counts.structuredBuffer += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER   : counts.structuredBuffer += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : counts.uniformBufferDynamic += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : counts.storageBufferDynamic += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_INPUT_ATTACHMENT       : counts.inputAttachment += binding.arrayCount; break;
+            case grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE : counts.accelerationStructure += binding.arrayCount; break;
+        }
+        // clang-format on
+    }
+    return counts;
+}
+
+static bool FitsInPool(
+    const grfx::DescriptorPoolCreateInfo& capacity,
+    const grfx::DescriptorPoolCreateInfo& used,
+    const grfx::DescriptorPoolCreateInfo& request)
+{
+    for (auto count : kDescriptorPoolCounts) {
+        if ((used.*count + request.*count) > capacity.*count) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// -------------------------------------------------------------------------------------------------
+// DescriptorAllocator
+// -------------------------------------------------------------------------------------------------
+Result DescriptorAllocator::CreateApiObjects(const grfx::DescriptorAllocatorCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (pCreateInfo->frameCount == 0) {
+        PPX_ASSERT_MSG(false, "descriptor allocator frame count must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((pCreateInfo->setsPerPool == 0) || (pCreateInfo->setsPerPool > PPX_MAX_SETS_PER_POOL)) {
+        PPX_ASSERT_MSG(false, "descriptor allocator sets per pool must be between 1 and PPX_MAX_SETS_PER_POOL");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mFrames.resize(pCreateInfo->frameCount);
+    mFrameIndex = 0;
+
+    return ppx::SUCCESS;
+}
+
+void DescriptorAllocator::DestroyApiObjects()
+{
+    for (auto& frame : mFrames) {
+        for (auto* pSetMap : {&frame.usedSets, &frame.freeSets}) {
+            for (auto& it : *pSetMap) {
+                for (auto& set : it.second) {
+                    GetDevice()->FreeDescriptorSet(set);
+                }
+            }
+            pSetMap->clear();
+        }
+    }
+    mFrames.clear();
+
+    for (auto& pool : mPools) {
+        GetDevice()->DestroyDescriptorPool(pool.pool);
+    }
+    mPools.clear();
+}
+
+void DescriptorAllocator::BeginFrame(uint32_t frameIndex)
+{
+    PPX_ASSERT_MSG(frameIndex < CountU32(mFrames), "frame index out of range");
+
+    mFrameIndex = frameIndex;
+
+    // Everything handed out for this frame becomes available again
+    Frame& frame = mFrames[mFrameIndex];
+    for (auto& it : frame.usedSets) {
+        auto& freeSets = frame.freeSets[it.first];
+        freeSets.insert(freeSets.end(), it.second.begin(), it.second.end());
+        it.second.clear();
+    }
+}
+
+Result DescriptorAllocator::Allocate(const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet)
+{
+    PPX_ASSERT_NULL_ARG(pLayout);
+    PPX_ASSERT_NULL_ARG(ppSet);
+
+    Frame& frame = mFrames[mFrameIndex];
+
+    // Recycle a retired set with the same layout
+    auto it = frame.freeSets.find(pLayout);
+    if ((it != frame.freeSets.end()) && !it->second.empty()) {
+        grfx::DescriptorSetPtr set = it->second.back();
+        it->second.pop_back();
+        frame.usedSets[pLayout].push_back(set);
+        *ppSet = set;
+        return ppx::SUCCESS;
+    }
+
+    grfx::DescriptorSetPtr set;
+    Result                 ppxres = AllocateFromPool(pLayout, &set);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    frame.usedSets[pLayout].push_back(set);
+    *ppSet = set;
+
+    return ppx::SUCCESS;
+}
+
+Result DescriptorAllocator::AllocateFromPool(const grfx::DescriptorSetLayout* pLayout, grfx::DescriptorSet** ppSet)
+{
+    const grfx::DescriptorPoolCreateInfo request = GetLayoutDescriptorCounts(pLayout);
+    const grfx::DescriptorPoolCreateInfo empty   = {};
+    if (!FitsInPool(mCreateInfo.poolSizes, empty, request)) {
+        PPX_ASSERT_MSG(false, "descriptor set layout doesn't fit in a descriptor allocator pool");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    // Only the last pool in the chain can have room left
+    bool needsPool = mPools.empty();
+    if (!needsPool) {
+        const Pool& pool = mPools.back();
+        needsPool        = (pool.setCount >= mCreateInfo.setsPerPool) || !FitsInPool(mCreateInfo.poolSizes, pool.usedSizes, request);
+    }
+
+    if (needsPool) {
+        Pool   pool   = {};
+        Result ppxres = GetDevice()->CreateDescriptorPool(&mCreateInfo.poolSizes, &pool.pool);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mPools.push_back(pool);
+    }
+
+    Pool&  pool   = mPools.back();
+    Result ppxres = GetDevice()->AllocateDescriptorSet(pool.pool, pLayout, ppSet);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    pool.setCount += 1;
+    for (auto count : kDescriptorPoolCounts) {
+        pool.usedSizes.*count += request.*count;
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -16,9 +16,105 @@
 #include "ppx/grfx/grfx_gpu.h"
 #include "ppx/grfx/grfx_instance.h"
 
+#include "xxhash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <unordered_set>
+
 namespace ppx {
 namespace grfx {
 
+namespace {
+
+// Adds the time until the end of the scope to a timestamp total
+class ScopedTimeAccumulator
+{
+public:
+    ScopedTimeAccumulator(uint64_t* pTotal)
+        : mTotal(pTotal)
+    {
+        Timer::Timestamp(&mStart);
+    }
+
+    ~ScopedTimeAccumulator()
+    {
+        uint64_t end = 0;
+        Timer::Timestamp(&end);
+        *mTotal += (end > mStart) ? (end - mStart) : 0;
+    }
+
+private:
+    uint64_t* mTotal = nullptr;
+    uint64_t  mStart = 0;
+};
+
+// Every field that affects the API sampler, the struct itself has padding
+std::array<uint64_t, 16> GetSamplerKey(const grfx::SamplerCreateInfo& createInfo)
+{
+    auto floatBits = [](float value) {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return static_cast<uint64_t>(bits);
+    };
+
+    return {
+        static_cast<uint64_t>(createInfo.magFilter),
+        static_cast<uint64_t>(createInfo.minFilter),
+        static_cast<uint64_t>(createInfo.mipmapMode),
+        static_cast<uint64_t>(createInfo.addressModeU),
+        static_cast<uint64_t>(createInfo.addressModeV),
+        static_cast<uint64_t>(createInfo.addressModeW),
+        floatBits(createInfo.mipLodBias),
+        static_cast<uint64_t>(createInfo.anisotropyEnable),
+        floatBits(createInfo.maxAnisotropy),
+        static_cast<uint64_t>(createInfo.compareEnable),
+        static_cast<uint64_t>(createInfo.compareOp),
+        floatBits(createInfo.minLod),
+        floatBits(createInfo.maxLod),
+        static_cast<uint64_t>(createInfo.borderColor),
+        static_cast<uint64_t>(reinterpret_cast<uintptr_t>(createInfo.pYcbcrConversion)),
+        static_cast<uint64_t>(createInfo.createFlags.flags),
+    };
+}
+
+// Object container operations for Device::CreateObject() and
+// Device::DestroyObject(), removal returns false for unknown objects
+template <typename ObjectT>
+void InsertObject(grfx::ObjectTable<ObjectT>& container, ObjectT* pObject)
+{
+    container.Insert(pObject);
+}
+
+template <typename ObjectT>
+bool RemoveObject(grfx::ObjectTable<ObjectT>& container, const ObjectT* pObject)
+{
+    return container.Remove(pObject);
+}
+
+template <typename ObjectT>
+void InsertObject(std::vector<ObjPtr<ObjectT>>& container, ObjectT* pObject)
+{
+    container.push_back(ObjPtr<ObjectT>(pObject));
+}
+
+template <typename ObjectT>
+bool RemoveObject(std::vector<ObjPtr<ObjectT>>& container, const ObjectT* pObject)
+{
+    auto it = std::find_if(
+        std::begin(container),
+        std::end(container),
+        [pObject](const ObjPtr<ObjectT>& elem) -> bool { return (elem == pObject); });
+    if (it == std::end(container)) {
+        return false;
+    }
+    container.erase(it);
+    return true;
+}
+
+} // namespace
+
 Result Device::Create(const grfx::DeviceCreateInfo* pCreateInfo)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo->pGpu);
@@ -26,27 +122,72 @@ Result Device::Create(const grfx::DeviceCreateInfo* pCreateInfo)
     if (Failed(ppxres)) {
         return ppxres;
     }
+    mSyncPool.SetDevice(this);
+
+    if (!pCreateInfo->pipelineManifestPath.empty()) {
+        mPipelineManifest = std::make_unique<grfx::PipelineManifest>();
+        if (std::filesystem::exists(pCreateInfo->pipelineManifestPath)) {
+            // A manifest that can't be loaded is replaced when the device is destroyed
+            if (Success(mPipelineManifest->Load(pCreateInfo->pipelineManifestPath))) {
+                PPX_LOG_INFO("Loaded pipeline manifest with " << mPipelineManifest->GetPipelineCount() << " pipelines: " << pCreateInfo->pipelineManifestPath);
+            }
+        }
+    }
+
     PPX_LOG_INFO("Created device: " << pCreateInfo->pGpu->GetDeviceName());
     return ppx::SUCCESS;
 }
 
 void Device::Destroy()
 {
+    // Finish any pipelines that are still compiling
+    StopPipelineCompileThreads();
+
+    SavePipelineManifest();
+
+    // Deferred destroys need the queues to wait on their fences
+    FlushDeferredDestroys();
+    mSyncPool.Destroy();
+
     // Destroy queues first to clear any pending work
     DestroyAllObjects(mGraphicsQueues);
     DestroyAllObjects(mComputeQueues);
     DestroyAllObjects(mTransferQueues);
 
-    // Destroy helper objects first
+    // Destroy helper objects first, render graphs own images and render passes
+    DestroyAllObjects(mPostProcessChains);
+    DestroyAllObjects(mRenderGraphs);
+    DestroyAllObjects(mDynamicResolutions);
+    DestroyAllObjects(mTemporalResolves);
+    DestroyAllObjects(mDepthPyramids);
     DestroyAllObjects(mDrawPasses);
     DestroyAllObjects(mFullscreenQuads);
+    DestroyAllObjects(mLineDraws);
     DestroyAllObjects(mTextDraws);
     DestroyAllObjects(mTextures);
     DestroyAllObjects(mTextureFonts);
+    DestroyAllObjects(mTransientAllocators);
+    DestroyAllObjects(mBindlessHeaps);
+    DestroyAllObjects(mDescriptorAllocators);
+    DestroyAllObjects(mAccelerationStructureBuilders);
+    DestroyAllObjects(mAsyncComputeSchedulers);
+    DestroyAllObjects(mComputeBatchRunners);
+    DestroyAllObjects(mGpuProfilers);
+    DestroyAllObjects(mSparseImageFeedbacks);
+
+    // Meshes return their ranges to buffer pools
+    DestroyAllObjects(mMeshes);
+    DestroyAllObjects(mBufferPools);
+
+    // Acceleration structures own their buffers
+    DestroyAllObjects(mAccelerationStructures);
 
     // Destroy render passes before images and views
     DestroyAllObjects(mRenderPasses);
 
+    // Images destroy their cached views, see Image::GetSampledImageView()
+    DestroyAllObjects(mImages);
+
     DestroyAllObjects(mBuffers);
     DestroyAllObjects(mCommandBuffers);
     DestroyAllObjects(mCommandPools);
@@ -56,16 +197,17 @@ void Device::Destroy()
     DestroyAllObjects(mDescriptorPools);
     DestroyAllObjects(mDescriptorSetLayouts);
     DestroyAllObjects(mFences);
-    DestroyAllObjects(mImages);
     DestroyAllObjects(mGraphicsPipelines);
     DestroyAllObjects(mPipelineInterfaces);
     DestroyAllObjects(mQuerys);
     DestroyAllObjects(mRenderTargetViews);
     DestroyAllObjects(mSampledImageViews);
     DestroyAllObjects(mSamplers);
+    mSamplerCache.clear();
     DestroyAllObjects(mSemaphores);
     DestroyAllObjects(mStorageImageViews);
     DestroyAllObjects(mShaderModules);
+    mShaderModuleCache.clear();
     DestroyAllObjects(mSwapchains);
 
     // Destroy Ycbcr Conversions after images and views
@@ -99,7 +241,7 @@ template <
     typename ObjectT,
     typename CreateInfoT,
     typename ContainerT>
-Result Device::CreateObject(const CreateInfoT* pCreateInfo, ContainerT& container, ObjectT** ppObject)
+Result Device::CreateObject(const CreateInfoT* pCreateInfo, ContainerT& container, ObjectT** ppObject, std::mutex* pContainerMutex)
 {
     // Allocate object
     ObjectT* pObject = nullptr;
@@ -118,7 +260,13 @@ Result Device::CreateObject(const CreateInfoT* pCreateInfo, ContainerT& containe
         return ppxres;
     }
     // Store
-    container.push_back(ObjPtr<ObjectT>(pObject));
+    if (!IsNull(pContainerMutex)) {
+        std::lock_guard<std::mutex> lock(*pContainerMutex);
+        InsertObject(container, pObject);
+    }
+    else {
+        InsertObject(container, pObject);
+    }
     // Assign
     *ppObject = pObject;
     // Success
@@ -128,29 +276,42 @@ Result Device::CreateObject(const CreateInfoT* pCreateInfo, ContainerT& containe
 template <
     typename ObjectT,
     typename ContainerT>
-void Device::DestroyObject(ContainerT& container, const ObjectT* pObject)
+void Device::DestroyObject(ContainerT& container, const ObjectT* pObject, std::mutex* pContainerMutex)
 {
-    // Make sure object is in container
-    auto it = std::find_if(
-        std::begin(container),
-        std::end(container),
-        [pObject](const ObjPtr<ObjectT>& elem) -> bool {
-            bool res = (elem == pObject);
-            return res; });
-    if (it == std::end(container)) {
+    std::unique_lock<std::mutex> lock;
+    if (!IsNull(pContainerMutex)) {
+        lock = std::unique_lock<std::mutex>(*pContainerMutex);
+    }
+    // Remove object pointer from container, if it's there
+    if (!RemoveObject(container, pObject)) {
         return;
     }
-    // Copy pointer
-    ObjPtr<ObjectT> object = *it;
-    // Remove object pointer from container
-    RemoveElement(object, container);
+    if (lock.owns_lock()) {
+        lock.unlock();
+    }
     // Destroy internal objects
-    object->Destroy();
+    ObjectT* ptr = const_cast<ObjectT*>(pObject);
+    ptr->Destroy();
     // Delete allocation
-    ObjectT* ptr = object.Get();
     delete ptr;
 }
 
+template <typename ObjectT>
+void Device::DestroyAllObjects(grfx::ObjectTable<ObjectT>& container)
+{
+    // Objects are removed before they're destroyed in case destroying one
+    // destroys others in the same table
+    container.ForEach([&container](ObjectT* pObject) {
+        container.Remove(pObject);
+        // Destroy internal objects
+        pObject->Destroy();
+        // Delete allocation
+        delete pObject;
+    });
+    // Clear container
+    container.Clear();
+}
+
 template <typename ObjectT>
 void Device::DestroyAllObjects(std::vector<ObjPtr<ObjectT>>& container)
 {
@@ -168,6 +329,138 @@ void Device::DestroyAllObjects(std::vector<ObjPtr<ObjectT>>& container)
     container.clear();
 }
 
+template <
+    typename ObjectT,
+    typename CreateInfoT>
+Result Device::CreatePipelineAsync(const CreateInfoT* pCreateInfo, grfx::ObjectTable<ObjectT>& container, grfx::AsyncPipeline<ObjectT>* pAsyncPipeline)
+{
+    auto state = std::make_shared<typename grfx::AsyncPipeline<ObjectT>::State>();
+
+    // Copy the create info since the caller's copy may go out of scope
+    // before the task runs
+    CreateInfoT createInfo = *pCreateInfo;
+    if (mPipelineManifest) {
+        mPipelineManifest->RecordPipeline(&createInfo);
+    }
+    EnqueuePipelineCompileTask([this, createInfo, state, &container]() {
+        ObjectT* pObject = nullptr;
+        Result   ppxres  = CreateObject(&createInfo, container, &pObject, &mPipelineContainerMutex);
+        {
+            std::lock_guard<std::mutex> stateLock(state->mutex);
+            state->result    = ppxres;
+            state->pPipeline = pObject;
+            state->ready     = true;
+        }
+        state->readyCondition.notify_all();
+    });
+
+    pAsyncPipeline->mState = state;
+
+    return ppx::SUCCESS;
+}
+
+void Device::EnqueuePipelineCompileTask(std::function<void()>&& task)
+{
+    StartPipelineCompileThreads();
+    {
+        std::lock_guard<std::mutex> lock(mPipelineCompileMutex);
+        mPipelineCompileTasks.push_back(std::move(task));
+    }
+    mPipelineCompileCondition.notify_one();
+}
+
+void Device::StartPipelineCompileThreads()
+{
+    std::lock_guard<std::mutex> lock(mPipelineCompileMutex);
+    if (!mPipelineCompileThreads.empty()) {
+        return;
+    }
+
+    uint32_t threadCount = mCreateInfo.pipelineCompileThreads;
+    if (threadCount == 0) {
+        // Leave the rest of the cores to the render thread and the driver
+        threadCount = std::max<uint32_t>(1, std::min<uint32_t>(4, std::thread::hardware_concurrency() / 2));
+    }
+
+    mStopPipelineCompileThreads = false;
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        mPipelineCompileThreads.emplace_back(&Device::PipelineCompileThreadMain, this);
+    }
+    PPX_LOG_INFO("Started " << threadCount << " pipeline compile threads");
+}
+
+void Device::StopPipelineCompileThreads()
+{
+    {
+        std::lock_guard<std::mutex> lock(mPipelineCompileMutex);
+        mStopPipelineCompileThreads = true;
+    }
+    mPipelineCompileCondition.notify_all();
+
+    // Threads drain the task queue before exiting
+    for (auto& thread : mPipelineCompileThreads) {
+        thread.join();
+    }
+    mPipelineCompileThreads.clear();
+}
+
+void Device::PipelineCompileThreadMain()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mPipelineCompileMutex);
+            mPipelineCompileCondition.wait(lock, [this] { return mStopPipelineCompileThreads || !mPipelineCompileTasks.empty(); });
+            if (mPipelineCompileTasks.empty()) {
+                return;
+            }
+            task = std::move(mPipelineCompileTasks.front());
+            mPipelineCompileTasks.pop_front();
+        }
+        task();
+    }
+}
+
+Result Device::AllocateObject(grfx::AccelerationStructureBuilder** ppObject)
+{
+    grfx::AccelerationStructureBuilder* pObject = new grfx::AccelerationStructureBuilder();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::BindlessHeap** ppObject)
+{
+    grfx::BindlessHeap* pObject = new grfx::BindlessHeap();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::DescriptorAllocator** ppObject)
+{
+    grfx::DescriptorAllocator* pObject = new grfx::DescriptorAllocator();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::DepthPyramid** ppObject)
+{
+    grfx::DepthPyramid* pObject = new grfx::DepthPyramid();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::AllocateObject(grfx::DrawPass** ppObject)
 {
     grfx::DrawPass* pObject = new grfx::DrawPass();
@@ -178,6 +471,16 @@ Result Device::AllocateObject(grfx::DrawPass** ppObject)
     return ppx::SUCCESS;
 }
 
+Result Device::AllocateObject(grfx::DynamicResolution** ppObject)
+{
+    grfx::DynamicResolution* pObject = new grfx::DynamicResolution();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::AllocateObject(grfx::FullscreenQuad** ppObject)
 {
     grfx::FullscreenQuad* pObject = new grfx::FullscreenQuad();
@@ -188,6 +491,16 @@ Result Device::AllocateObject(grfx::FullscreenQuad** ppObject)
     return ppx::SUCCESS;
 }
 
+Result Device::AllocateObject(grfx::LineDraw** ppObject)
+{
+    grfx::LineDraw* pObject = new grfx::LineDraw();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::AllocateObject(grfx::Mesh** ppObject)
 {
     grfx::Mesh* pObject = new grfx::Mesh();
@@ -218,6 +531,16 @@ Result Device::AllocateObject(grfx::Texture** ppObject)
     return ppx::SUCCESS;
 }
 
+Result Device::AllocateObject(grfx::TemporalResolve** ppObject)
+{
+    grfx::TemporalResolve* pObject = new grfx::TemporalResolve();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::AllocateObject(grfx::TextureFont** ppObject)
 {
     grfx::TextureFont* pObject = new grfx::TextureFont();
@@ -228,6 +551,86 @@ Result Device::AllocateObject(grfx::TextureFont** ppObject)
     return ppx::SUCCESS;
 }
 
+Result Device::AllocateObject(grfx::TransientAllocator** ppObject)
+{
+    grfx::TransientAllocator* pObject = new grfx::TransientAllocator();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::RenderGraph** ppObject)
+{
+    grfx::RenderGraph* pObject = new grfx::RenderGraph();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::PostProcessChain** ppObject)
+{
+    grfx::PostProcessChain* pObject = new grfx::PostProcessChain();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::BufferPool** ppObject)
+{
+    grfx::BufferPool* pObject = new grfx::BufferPool();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::AsyncComputeScheduler** ppObject)
+{
+    grfx::AsyncComputeScheduler* pObject = new grfx::AsyncComputeScheduler();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::ComputeBatchRunner** ppObject)
+{
+    grfx::ComputeBatchRunner* pObject = new grfx::ComputeBatchRunner();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::GpuProfiler** ppObject)
+{
+    grfx::GpuProfiler* pObject = new grfx::GpuProfiler();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
+Result Device::AllocateObject(grfx::SparseImageFeedback** ppObject)
+{
+    grfx::SparseImageFeedback* pObject = new grfx::SparseImageFeedback();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::CreateBuffer(const grfx::BufferCreateInfo* pCreateInfo, grfx::Buffer** ppBuffer)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
@@ -258,13 +661,25 @@ Result Device::CreateComputePipeline(const grfx::ComputePipelineCreateInfo* pCre
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
     PPX_ASSERT_NULL_ARG(ppComputePipeline);
-    return CreateObject(pCreateInfo, mComputePipelines, ppComputePipeline);
+    ScopedTimeAccumulator timer(&mPipelineCreateTime);
+    Result                ppxres = CreateObject(pCreateInfo, mComputePipelines, ppComputePipeline, &mPipelineContainerMutex);
+    if (Success(ppxres) && mPipelineManifest) {
+        mPipelineManifest->RecordPipeline(pCreateInfo);
+    }
+    return ppxres;
+}
+
+Result Device::CreateComputePipelineAsync(const grfx::ComputePipelineCreateInfo* pCreateInfo, grfx::AsyncComputePipeline* pAsyncPipeline)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(pAsyncPipeline);
+    return CreatePipelineAsync(pCreateInfo, mComputePipelines, pAsyncPipeline);
 }
 
 void Device::DestroyComputePipeline(const grfx::ComputePipeline* pComputePipeline)
 {
     PPX_ASSERT_NULL_ARG(pComputePipeline);
-    DestroyObject(mComputePipelines, pComputePipeline);
+    DestroyObject(mComputePipelines, pComputePipeline, &mPipelineContainerMutex);
 }
 
 Result Device::CreateDepthStencilView(const grfx::DepthStencilViewCreateInfo* pCreateInfo, grfx::DepthStencilView** ppDepthStencilView)
@@ -306,6 +721,19 @@ void Device::DestroyDescriptorSetLayout(const grfx::DescriptorSetLayout* pDescri
     DestroyObject(mDescriptorSetLayouts, pDescriptorSetLayout);
 }
 
+Result Device::CreateDepthPyramid(const grfx::DepthPyramidCreateInfo* pCreateInfo, grfx::DepthPyramid** ppDepthPyramid)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppDepthPyramid);
+    return CreateObject(pCreateInfo, mDepthPyramids, ppDepthPyramid);
+}
+
+void Device::DestroyDepthPyramid(const grfx::DepthPyramid* pDepthPyramid)
+{
+    PPX_ASSERT_NULL_ARG(pDepthPyramid);
+    DestroyObject(mDepthPyramids, pDepthPyramid);
+}
+
 Result Device::CreateDrawPass(const grfx::DrawPassCreateInfo* pCreateInfo, grfx::DrawPass** ppDrawPass)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
@@ -342,6 +770,19 @@ void Device::DestroyDrawPass(const grfx::DrawPass* pDrawPass)
     DestroyObject(mDrawPasses, pDrawPass);
 }
 
+Result Device::CreateDynamicResolution(const grfx::DynamicResolutionCreateInfo* pCreateInfo, grfx::DynamicResolution** ppDynamicResolution)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppDynamicResolution);
+    return CreateObject(pCreateInfo, mDynamicResolutions, ppDynamicResolution);
+}
+
+void Device::DestroyDynamicResolution(const grfx::DynamicResolution* pDynamicResolution)
+{
+    PPX_ASSERT_NULL_ARG(pDynamicResolution);
+    DestroyObject(mDynamicResolutions, pDynamicResolution);
+}
+
 Result Device::CreateFence(const grfx::FenceCreateInfo* pCreateInfo, grfx::Fence** ppFence)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
@@ -385,7 +826,12 @@ Result Device::CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo* pC
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
     PPX_ASSERT_NULL_ARG(ppGraphicsPipeline);
-    return CreateObject(pCreateInfo, mGraphicsPipelines, ppGraphicsPipeline);
+    ScopedTimeAccumulator timer(&mPipelineCreateTime);
+    Result                ppxres = CreateObject(pCreateInfo, mGraphicsPipelines, ppGraphicsPipeline, &mPipelineContainerMutex);
+    if (Success(ppxres) && mPipelineManifest) {
+        mPipelineManifest->RecordPipeline(pCreateInfo);
+    }
+    return ppxres;
 }
 
 Result Device::CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo2* pCreateInfo, grfx::GraphicsPipeline** ppGraphicsPipeline)
@@ -396,13 +842,57 @@ Result Device::CreateGraphicsPipeline(const grfx::GraphicsPipelineCreateInfo2* p
     grfx::GraphicsPipelineCreateInfo createInfo = {};
     grfx::internal::FillOutGraphicsPipelineCreateInfo(pCreateInfo, &createInfo);
 
-    return CreateObject(&createInfo, mGraphicsPipelines, ppGraphicsPipeline);
+    return CreateGraphicsPipeline(&createInfo, ppGraphicsPipeline);
+}
+
+Result Device::CreateGraphicsPipelineAsync(const grfx::GraphicsPipelineCreateInfo* pCreateInfo, grfx::AsyncGraphicsPipeline* pAsyncPipeline)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(pAsyncPipeline);
+    return CreatePipelineAsync(pCreateInfo, mGraphicsPipelines, pAsyncPipeline);
+}
+
+Result Device::CreateGraphicsPipelineAsync(const grfx::GraphicsPipelineCreateInfo2* pCreateInfo, grfx::AsyncGraphicsPipeline* pAsyncPipeline)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(pAsyncPipeline);
+
+    grfx::GraphicsPipelineCreateInfo createInfo = {};
+    grfx::internal::FillOutGraphicsPipelineCreateInfo(pCreateInfo, &createInfo);
+
+    return CreatePipelineAsync(&createInfo, mGraphicsPipelines, pAsyncPipeline);
+}
+
+Result Device::SavePipelineManifest()
+{
+    if (!mPipelineManifest) {
+        return ppx::SUCCESS;
+    }
+    return mPipelineManifest->Save(mCreateInfo.pipelineManifestPath);
+}
+
+Result Device::PrecompilePipelines(uint32_t* pPipelineCount)
+{
+    if (!IsNull(pPipelineCount)) {
+        *pPipelineCount = 0;
+    }
+    if (!mPipelineManifest) {
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = mPipelineManifest->Precompile(this, pPipelineCount);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Keep the compiled pipelines if the application doesn't exit cleanly
+    return SavePipelineCache();
 }
 
 void Device::DestroyGraphicsPipeline(const grfx::GraphicsPipeline* pGraphicsPipeline)
 {
     PPX_ASSERT_NULL_ARG(pGraphicsPipeline);
-    DestroyObject(mGraphicsPipelines, pGraphicsPipeline);
+    DestroyObject(mGraphicsPipelines, pGraphicsPipeline, &mPipelineContainerMutex);
 }
 
 Result Device::CreateImage(const grfx::ImageCreateInfo* pCreateInfo, grfx::Image** ppImage)
@@ -418,6 +908,19 @@ void Device::DestroyImage(const grfx::Image* pImage)
     DestroyObject(mImages, pImage);
 }
 
+Result Device::CreateLineDraw(const grfx::LineDrawCreateInfo* pCreateInfo, grfx::LineDraw** ppLineDraw)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppLineDraw);
+    return CreateObject(pCreateInfo, mLineDraws, ppLineDraw);
+}
+
+void Device::DestroyLineDraw(const grfx::LineDraw* pLineDraw)
+{
+    PPX_ASSERT_NULL_ARG(pLineDraw);
+    DestroyObject(mLineDraws, pLineDraw);
+}
+
 Result Device::CreateMesh(const grfx::MeshCreateInfo* pCreateInfo, grfx::Mesh** ppMesh)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
@@ -523,12 +1026,55 @@ Result Device::CreateSampler(const grfx::SamplerCreateInfo* pCreateInfo, grfx::S
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
     PPX_ASSERT_NULL_ARG(ppSampler);
-    return CreateObject(pCreateInfo, mSamplers, ppSampler);
+
+    // Samplers owned by another object are destroyed with it, don't share them
+    if (!mCreateInfo.samplerCache || (pCreateInfo->ownership != grfx::OWNERSHIP_REFERENCE)) {
+        return CreateObject(pCreateInfo, mSamplers, ppSampler);
+    }
+
+    const SamplerKey key  = GetSamplerKey(*pCreateInfo);
+    const uint64_t   hash = XXH3_64bits(key.data(), sizeof(key));
+
+    auto it = mSamplerCache.find(hash);
+    if (it != mSamplerCache.end()) {
+        // A key mismatch is a hash collision, those samplers aren't cached
+        if (it->second.key != key) {
+            return CreateObject(pCreateInfo, mSamplers, ppSampler);
+        }
+        it->second.refCount += 1;
+        *ppSampler = it->second.pSampler;
+        ++mSamplerCacheHitCount;
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = CreateObject(pCreateInfo, mSamplers, ppSampler);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    CachedSampler cached = {};
+    cached.pSampler      = *ppSampler;
+    cached.key           = key;
+    cached.refCount      = 1;
+    mSamplerCache[hash]  = cached;
+    ++mSamplerCacheMissCount;
+
+    return ppx::SUCCESS;
 }
 
 void Device::DestroySampler(const grfx::Sampler* pSampler)
 {
     PPX_ASSERT_NULL_ARG(pSampler);
+
+    auto it = std::find_if(mSamplerCache.begin(), mSamplerCache.end(), [pSampler](const auto& elem) { return elem.second.pSampler == pSampler; });
+    if (it != mSamplerCache.end()) {
+        it->second.refCount -= 1;
+        if (it->second.refCount > 0) {
+            return;
+        }
+        mSamplerCache.erase(it);
+    }
+
     DestroyObject(mSamplers, pSampler);
 }
 
@@ -562,12 +1108,63 @@ Result Device::CreateShaderModule(const grfx::ShaderModuleCreateInfo* pCreateInf
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
     PPX_ASSERT_NULL_ARG(ppShaderModule);
-    return CreateObject(pCreateInfo, mShaderModules, ppShaderModule);
+    ScopedTimeAccumulator timer(&mShaderModuleCreateTime);
+
+    if (!mCreateInfo.shaderModuleCache || IsNull(pCreateInfo->pCode) || (pCreateInfo->size == 0)) {
+        return CreateRecordedShaderModule(pCreateInfo, ppShaderModule);
+    }
+
+    const uint64_t hash = XXH3_64bits(pCreateInfo->pCode, pCreateInfo->size);
+
+    auto it = mShaderModuleCache.find(hash);
+    if (it != mShaderModuleCache.end()) {
+        // A size mismatch is a hash collision, those modules aren't cached
+        if (it->second.size != pCreateInfo->size) {
+            return CreateRecordedShaderModule(pCreateInfo, ppShaderModule);
+        }
+        it->second.refCount += 1;
+        *ppShaderModule = it->second.pShaderModule;
+        ++mShaderModuleCacheHitCount;
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = CreateRecordedShaderModule(pCreateInfo, ppShaderModule);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    CachedShaderModule cached = {};
+    cached.pShaderModule      = *ppShaderModule;
+    cached.size               = pCreateInfo->size;
+    cached.refCount           = 1;
+    mShaderModuleCache[hash]  = cached;
+    ++mShaderModuleCacheMissCount;
+
+    return ppx::SUCCESS;
+}
+
+Result Device::CreateRecordedShaderModule(const grfx::ShaderModuleCreateInfo* pCreateInfo, grfx::ShaderModule** ppShaderModule)
+{
+    Result ppxres = CreateObject(pCreateInfo, mShaderModules, ppShaderModule);
+    if (Success(ppxres) && mPipelineManifest) {
+        mPipelineManifest->RecordShaderModule(*ppShaderModule, pCreateInfo);
+    }
+    return ppxres;
 }
 
 void Device::DestroyShaderModule(const grfx::ShaderModule* pShaderModule)
 {
     PPX_ASSERT_NULL_ARG(pShaderModule);
+
+    auto it = std::find_if(mShaderModuleCache.begin(), mShaderModuleCache.end(), [pShaderModule](const auto& elem) { return elem.second.pShaderModule == pShaderModule; });
+    if (it != mShaderModuleCache.end()) {
+        it->second.refCount -= 1;
+        if (it->second.refCount > 0) {
+            return;
+        }
+        mShaderModuleCache.erase(it);
+    }
+
     DestroyObject(mShaderModules, pShaderModule);
 }
 
@@ -623,6 +1220,19 @@ void Device::DestroyTexture(const grfx::Texture* pTexture)
     DestroyObject(mTextures, pTexture);
 }
 
+Result Device::CreateTemporalResolve(const grfx::TemporalResolveCreateInfo* pCreateInfo, grfx::TemporalResolve** ppTemporalResolve)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppTemporalResolve);
+    return CreateObject(pCreateInfo, mTemporalResolves, ppTemporalResolve);
+}
+
+void Device::DestroyTemporalResolve(const grfx::TemporalResolve* pTemporalResolve)
+{
+    PPX_ASSERT_NULL_ARG(pTemporalResolve);
+    DestroyObject(mTemporalResolves, pTemporalResolve);
+}
+
 Result Device::CreateTextureFont(const grfx::TextureFontCreateInfo* pCreateInfo, grfx::TextureFont** ppTextureFont)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
@@ -636,11 +1246,173 @@ void Device::DestroyTextureFont(const grfx::TextureFont* pTextureFont)
     DestroyObject(mTextureFonts, pTextureFont);
 }
 
+Result Device::CreateTransientAllocator(const grfx::TransientAllocatorCreateInfo* pCreateInfo, grfx::TransientAllocator** ppTransientAllocator)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppTransientAllocator);
+    return CreateObject(pCreateInfo, mTransientAllocators, ppTransientAllocator);
+}
+
+void Device::DestroyTransientAllocator(const grfx::TransientAllocator* pTransientAllocator)
+{
+    PPX_ASSERT_NULL_ARG(pTransientAllocator);
+    DestroyObject(mTransientAllocators, pTransientAllocator);
+}
+
+Result Device::CreateRenderGraph(const grfx::RenderGraphCreateInfo* pCreateInfo, grfx::RenderGraph** ppRenderGraph)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppRenderGraph);
+    return CreateObject(pCreateInfo, mRenderGraphs, ppRenderGraph);
+}
+
+void Device::DestroyRenderGraph(const grfx::RenderGraph* pRenderGraph)
+{
+    PPX_ASSERT_NULL_ARG(pRenderGraph);
+    DestroyObject(mRenderGraphs, pRenderGraph);
+}
+
+Result Device::CreatePostProcessChain(const grfx::PostProcessChainCreateInfo* pCreateInfo, grfx::PostProcessChain** ppChain)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppChain);
+    return CreateObject(pCreateInfo, mPostProcessChains, ppChain);
+}
+
+void Device::DestroyPostProcessChain(const grfx::PostProcessChain* pChain)
+{
+    PPX_ASSERT_NULL_ARG(pChain);
+    DestroyObject(mPostProcessChains, pChain);
+}
+
+Result Device::CreateBufferPool(const grfx::BufferPoolCreateInfo* pCreateInfo, grfx::BufferPool** ppBufferPool)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppBufferPool);
+    return CreateObject(pCreateInfo, mBufferPools, ppBufferPool);
+}
+
+void Device::DestroyBufferPool(const grfx::BufferPool* pBufferPool)
+{
+    PPX_ASSERT_NULL_ARG(pBufferPool);
+    DestroyObject(mBufferPools, pBufferPool);
+}
+
+Result Device::CreateAsyncComputeScheduler(const grfx::AsyncComputeSchedulerCreateInfo* pCreateInfo, grfx::AsyncComputeScheduler** ppScheduler)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppScheduler);
+    return CreateObject(pCreateInfo, mAsyncComputeSchedulers, ppScheduler);
+}
+
+void Device::DestroyAsyncComputeScheduler(const grfx::AsyncComputeScheduler* pScheduler)
+{
+    PPX_ASSERT_NULL_ARG(pScheduler);
+    DestroyObject(mAsyncComputeSchedulers, pScheduler);
+}
+
+Result Device::CreateComputeBatchRunner(const grfx::ComputeBatchRunnerCreateInfo* pCreateInfo, grfx::ComputeBatchRunner** ppRunner)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppRunner);
+    return CreateObject(pCreateInfo, mComputeBatchRunners, ppRunner);
+}
+
+void Device::DestroyComputeBatchRunner(const grfx::ComputeBatchRunner* pRunner)
+{
+    PPX_ASSERT_NULL_ARG(pRunner);
+    DestroyObject(mComputeBatchRunners, pRunner);
+}
+
+Result Device::CreateGpuProfiler(const grfx::GpuProfilerCreateInfo* pCreateInfo, grfx::GpuProfiler** ppProfiler)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppProfiler);
+    return CreateObject(pCreateInfo, mGpuProfilers, ppProfiler);
+}
+
+void Device::DestroyGpuProfiler(const grfx::GpuProfiler* pProfiler)
+{
+    PPX_ASSERT_NULL_ARG(pProfiler);
+    DestroyObject(mGpuProfilers, pProfiler);
+}
+
+Result Device::CreateSparseImageFeedback(const grfx::SparseImageFeedbackCreateInfo* pCreateInfo, grfx::SparseImageFeedback** ppFeedback)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppFeedback);
+    return CreateObject(pCreateInfo, mSparseImageFeedbacks, ppFeedback);
+}
+
+void Device::DestroySparseImageFeedback(const grfx::SparseImageFeedback* pFeedback)
+{
+    PPX_ASSERT_NULL_ARG(pFeedback);
+    DestroyObject(mSparseImageFeedbacks, pFeedback);
+}
+
+Result Device::CreateBindlessHeap(const grfx::BindlessHeapCreateInfo* pCreateInfo, grfx::BindlessHeap** ppBindlessHeap)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppBindlessHeap);
+    return CreateObject(pCreateInfo, mBindlessHeaps, ppBindlessHeap);
+}
+
+void Device::DestroyBindlessHeap(const grfx::BindlessHeap* pBindlessHeap)
+{
+    PPX_ASSERT_NULL_ARG(pBindlessHeap);
+    DestroyObject(mBindlessHeaps, pBindlessHeap);
+}
+
+Result Device::CreateDescriptorAllocator(const grfx::DescriptorAllocatorCreateInfo* pCreateInfo, grfx::DescriptorAllocator** ppDescriptorAllocator)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppDescriptorAllocator);
+    return CreateObject(pCreateInfo, mDescriptorAllocators, ppDescriptorAllocator);
+}
+
+void Device::DestroyDescriptorAllocator(const grfx::DescriptorAllocator* pDescriptorAllocator)
+{
+    PPX_ASSERT_NULL_ARG(pDescriptorAllocator);
+    DestroyObject(mDescriptorAllocators, pDescriptorAllocator);
+}
+
+Result Device::CreateAccelerationStructure(const grfx::AccelerationStructureCreateInfo* pCreateInfo, grfx::AccelerationStructure** ppAccelerationStructure)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppAccelerationStructure);
+    if (!AccelerationStructureSupported()) {
+        PPX_ASSERT_MSG(false, "acceleration structures are not supported by this device");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+    return CreateObject(pCreateInfo, mAccelerationStructures, ppAccelerationStructure);
+}
+
+void Device::DestroyAccelerationStructure(const grfx::AccelerationStructure* pAccelerationStructure)
+{
+    PPX_ASSERT_NULL_ARG(pAccelerationStructure);
+    DestroyObject(mAccelerationStructures, pAccelerationStructure);
+}
+
+Result Device::CreateAccelerationStructureBuilder(const grfx::AccelerationStructureBuilderCreateInfo* pCreateInfo, grfx::AccelerationStructureBuilder** ppBuilder)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(ppBuilder);
+    return CreateObject(pCreateInfo, mAccelerationStructureBuilders, ppBuilder);
+}
+
+void Device::DestroyAccelerationStructureBuilder(const grfx::AccelerationStructureBuilder* pBuilder)
+{
+    PPX_ASSERT_NULL_ARG(pBuilder);
+    DestroyObject(mAccelerationStructureBuilders, pBuilder);
+}
+
 Result Device::AllocateCommandBuffer(
     const grfx::CommandPool* pPool,
     grfx::CommandBuffer**    ppCommandBuffer,
     uint32_t                 resourceDescriptorCount,
-    uint32_t                 samplerDescriptorCount)
+    uint32_t                 samplerDescriptorCount,
+    bool                     secondary,
+    bool                     reusable)
 {
     PPX_ASSERT_NULL_ARG(ppCommandBuffer);
 
@@ -648,6 +1420,8 @@ Result Device::AllocateCommandBuffer(
     createInfo.pPool                                   = pPool;
     createInfo.resourceDescriptorCount                 = resourceDescriptorCount;
     createInfo.samplerDescriptorCount                  = samplerDescriptorCount;
+    createInfo.secondary                               = secondary;
+    createInfo.reusable                                = reusable;
 
     return CreateObject(&createInfo, mCommandBuffers, ppCommandBuffer);
 }
@@ -682,6 +1456,262 @@ void Device::FreeDescriptorSet(const grfx::DescriptorSet* pSet)
     DestroyObject(mDescriptorSets, pSet);
 }
 
+void Device::DeferDestroyBuffer(const grfx::Buffer* pBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pBuffer);
+    DeferDestroy([this, pBuffer]() { DestroyBuffer(pBuffer); });
+}
+
+void Device::DeferDestroyCommandBuffer(const grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    grfx::Queue* pQueue = const_cast<grfx::Queue*>(pCommandBuffer->GetCommandPool()->GetQueue());
+    DeferDestroy([pQueue, pCommandBuffer]() { pQueue->DestroyCommandBuffer(pCommandBuffer); });
+}
+
+void Device::DeferDestroyComputePipeline(const grfx::ComputePipeline* pComputePipeline)
+{
+    PPX_ASSERT_NULL_ARG(pComputePipeline);
+    DeferDestroy([this, pComputePipeline]() { DestroyComputePipeline(pComputePipeline); });
+}
+
+void Device::DeferDestroyDrawPass(const grfx::DrawPass* pDrawPass)
+{
+    PPX_ASSERT_NULL_ARG(pDrawPass);
+    DeferDestroy([this, pDrawPass]() { DestroyDrawPass(pDrawPass); });
+}
+
+void Device::DeferDestroyGraphicsPipeline(const grfx::GraphicsPipeline* pGraphicsPipeline)
+{
+    PPX_ASSERT_NULL_ARG(pGraphicsPipeline);
+    DeferDestroy([this, pGraphicsPipeline]() { DestroyGraphicsPipeline(pGraphicsPipeline); });
+}
+
+void Device::DeferDestroyImage(const grfx::Image* pImage)
+{
+    PPX_ASSERT_NULL_ARG(pImage);
+    DeferDestroy([this, pImage]() { DestroyImage(pImage); });
+}
+
+void Device::DeferDestroyTexture(const grfx::Texture* pTexture)
+{
+    PPX_ASSERT_NULL_ARG(pTexture);
+    DeferDestroy([this, pTexture]() { DestroyTexture(pTexture); });
+}
+
+void Device::DeferFreeDescriptorSet(const grfx::DescriptorSet* pSet)
+{
+    PPX_ASSERT_NULL_ARG(pSet);
+    DeferDestroy([this, pSet]() { FreeDescriptorSet(pSet); });
+}
+
+void Device::DeferDestroy(std::function<void()>&& destroy)
+{
+    std::lock_guard<std::mutex> lock(mDeferredDestroyMutex);
+    mPendingDestroys.push_back(std::move(destroy));
+}
+
+Result Device::ProcessDeferredDestroys()
+{
+    std::vector<std::function<void()>> destroys;
+    {
+        std::lock_guard<std::mutex> lock(mDeferredDestroyMutex);
+
+        // Batches are fenced in order, so the first unsignaled one ends the search
+        while (!mDeferredDestroyBatches.empty()) {
+            DeferredDestroyBatch& batch    = mDeferredDestroyBatches.front();
+            const bool            signaled = std::all_of(batch.fences.begin(), batch.fences.end(), [](const grfx::FencePtr& fence) { return fence->IsSignaled(); });
+            if (!signaled) {
+                break;
+            }
+            destroys.insert(destroys.end(), std::make_move_iterator(batch.destroys.begin()), std::make_move_iterator(batch.destroys.end()));
+            for (auto& fence : batch.fences) {
+                mSyncPool.Release(fence);
+            }
+            mDeferredDestroyBatches.pop_front();
+        }
+    }
+    // Destroying takes the object container locks
+    for (auto& destroy : destroys) {
+        destroy();
+    }
+
+    std::lock_guard<std::mutex> lock(mDeferredDestroyMutex);
+    if (mPendingDestroys.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    // A submit without command buffers signals once all previous work on the queue has completed
+    DeferredDestroyBatch batch = {};
+    for (auto* pQueues : {&mGraphicsQueues, &mComputeQueues, &mTransferQueues}) {
+        for (auto& queue : *pQueues) {
+            grfx::FencePtr fence;
+            Result         ppxres = mSyncPool.AcquireFence(&fence);
+            if (Failed(ppxres)) {
+                // Keeps the destroys pending and retries next time
+                for (auto& submittedFence : batch.fences) {
+                    mSyncPool.Release(submittedFence);
+                }
+                return ppxres;
+            }
+
+            grfx::SubmitInfo submitInfo = {};
+            submitInfo.pFence           = fence;
+            ppxres                      = queue->Submit(&submitInfo);
+            if (Failed(ppxres)) {
+                DestroyFence(fence);
+                for (auto& submittedFence : batch.fences) {
+                    mSyncPool.Release(submittedFence);
+                }
+                return ppxres;
+            }
+            batch.fences.push_back(fence);
+        }
+    }
+    batch.destroys.swap(mPendingDestroys);
+    mDeferredDestroyBatches.push_back(std::move(batch));
+
+    return ppx::SUCCESS;
+}
+
+void Device::FlushDeferredDestroys()
+{
+    std::vector<std::function<void()>> destroys;
+    {
+        std::lock_guard<std::mutex> lock(mDeferredDestroyMutex);
+        for (auto& batch : mDeferredDestroyBatches) {
+            for (auto& fence : batch.fences) {
+                fence->Wait();
+                mSyncPool.Release(fence);
+            }
+            destroys.insert(destroys.end(), std::make_move_iterator(batch.destroys.begin()), std::make_move_iterator(batch.destroys.end()));
+        }
+        mDeferredDestroyBatches.clear();
+
+        // Pending objects may be used by work that hasn't been fenced
+        if (!mPendingDestroys.empty()) {
+            WaitIdle();
+            destroys.insert(destroys.end(), std::make_move_iterator(mPendingDestroys.begin()), std::make_move_iterator(mPendingDestroys.end()));
+            mPendingDestroys.clear();
+        }
+    }
+
+    for (auto& destroy : destroys) {
+        destroy();
+    }
+}
+
+uint32_t Device::GetDeferredDestroyCount() const
+{
+    std::lock_guard<std::mutex> lock(mDeferredDestroyMutex);
+
+    size_t count = mPendingDestroys.size();
+    for (auto& batch : mDeferredDestroyBatches) {
+        count += batch.destroys.size();
+    }
+    return static_cast<uint32_t>(count);
+}
+
+Result Device::Defragment(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats)
+{
+    if (!IsDefragmentationEnabled()) {
+        PPX_ASSERT_MSG(false, "defragmentation requires DeviceCreateInfo::defragmentation");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    // Resources can only move once the GPU is done with them, and memory
+    // of deferred destroys is better freed before compacting
+    Result ppxres = WaitIdle();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    FlushDeferredDestroys();
+
+    grfx::DefragmentationStats stats = {};
+    ppxres                           = DefragmentApiObjects(info, &stats);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    PPX_LOG_INFO("Defragmentation moved " << stats.bufferMoveCount << " buffers and " << stats.imageMoveCount << " images (" << stats.bytesMoved << " bytes), freed " << stats.blocksFreedCount << " blocks (" << stats.bytesFreed << " bytes)");
+
+    if (!IsNull(pStats)) {
+        *pStats = stats;
+    }
+    return ppx::SUCCESS;
+}
+
+Result Device::UpdateMovedResourceReferences(const std::vector<grfx::Buffer*>& buffers, const std::vector<grfx::Image*>& images)
+{
+    std::unordered_set<const grfx::Buffer*>    movedBuffers(buffers.begin(), buffers.end());
+    std::unordered_set<const grfx::Image*>     movedImages(images.begin(), images.end());
+    std::unordered_set<const grfx::ImageView*> recreatedViews;
+
+    // Release the framebuffers of render passes first, shared framebuffers
+    // are keyed by view handles that recreated views may reuse
+    std::vector<grfx::RenderPass*> renderPasses;
+    mRenderPasses.ForEach([&](grfx::RenderPass* pRenderPass) {
+        bool moved = pRenderPass->HasDepthStencil() && (movedImages.count(pRenderPass->GetDepthStencilImage().Get()) > 0);
+        for (uint32_t i = 0; i < pRenderPass->GetRenderTargetCount(); ++i) {
+            moved = moved || (movedImages.count(pRenderPass->GetRenderTargetImage(i).Get()) > 0);
+            moved = moved || (movedImages.count(pRenderPass->GetResolveImage(i).Get()) > 0);
+        }
+        if (moved) {
+            pRenderPass->DestroyApiObjects();
+            renderPasses.push_back(pRenderPass);
+        }
+    });
+
+    Result ppxres       = ppx::SUCCESS;
+    auto   recreateView = [&](auto* pView) {
+        if (Failed(ppxres) || (movedImages.count(pView->GetImage().Get()) == 0)) {
+            return;
+        }
+        pView->DestroyApiObjects();
+        ppxres = pView->CreateApiObjects(&pView->mCreateInfo);
+        recreatedViews.insert(pView);
+    };
+    mSampledImageViews.ForEach(recreateView);
+    mStorageImageViews.ForEach(recreateView);
+    mRenderTargetViews.ForEach(recreateView);
+    mDepthStencilViews.ForEach(recreateView);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed to recreate views of moved images");
+        return ppxres;
+    }
+
+    for (grfx::RenderPass* pRenderPass : renderPasses) {
+        ppxres = pRenderPass->CreateApiObjects(&pRenderPass->mCreateInfo);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed to recreate render pass of moved images");
+            return ppxres;
+        }
+    }
+
+    mDescriptorSets.ForEach([&](grfx::DescriptorSet* pSet) {
+        if (Failed(ppxres)) {
+            return;
+        }
+
+        std::vector<grfx::WriteDescriptor> writes;
+        for (auto& it : pSet->mRecordedWrites) {
+            const grfx::WriteDescriptor& write = it.second;
+            if ((movedBuffers.count(write.pBuffer) > 0) || (recreatedViews.count(write.pImageView) > 0)) {
+                writes.push_back(write);
+            }
+        }
+        if (!writes.empty()) {
+            ppxres = pSet->UpdateDescriptors(CountU32(writes), writes.data());
+        }
+    });
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed to rewrite descriptors of moved resources");
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
 Result Device::CreateGraphicsQueue(const grfx::internal::QueueCreateInfo* pCreateInfo, grfx::Queue** ppQueue)
 {
     PPX_ASSERT_NULL_ARG(pCreateInfo);
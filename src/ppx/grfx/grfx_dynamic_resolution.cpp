@@ -0,0 +1,380 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_dynamic_resolution.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_draw_pass.h"
+#include "ppx/grfx/grfx_query.h"
+#include "ppx/grfx/grfx_queue.h"
+
+namespace ppx {
+namespace grfx {
+
+// Registers in DynamicResolutionUpscale.hlsl
+enum
+{
+    DYNAMIC_RESOLUTION_TEXTURE_REGISTER = 0,
+    DYNAMIC_RESOLUTION_SAMPLER_REGISTER = 1,
+    DYNAMIC_RESOLUTION_PARAMS_REGISTER  = 2,
+};
+
+// Must match DynamicResolutionUpscale.hlsl
+struct UpscaleParams
+{
+    float uvScale[2];
+    float uvMax[2];
+};
+
+// A set for the current draw pass and the ones Resize() left to deferred
+// frees, more are only needed if the window is resized every frame
+static const uint32_t kMaxDescriptorSets = 4;
+
+Result DynamicResolution::CreateApiObjects(const grfx::DynamicResolutionCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->pQueue) || IsNull(pCreateInfo->VS.pModule) || IsNull(pCreateInfo->PS.pModule)) {
+        PPX_ASSERT_MSG(false, "dynamic resolution queue and shaders must not be null");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((pCreateInfo->frameCount == 0) || (pCreateInfo->width == 0) || (pCreateInfo->height == 0)) {
+        PPX_ASSERT_MSG(false, "dynamic resolution frame count and size must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((pCreateInfo->renderTargetFormat == grfx::FORMAT_UNDEFINED) || (pCreateInfo->outputFormat == grfx::FORMAT_UNDEFINED)) {
+        PPX_ASSERT_MSG(false, "dynamic resolution render target and output formats must be defined");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    Result ppxres = mController.Initialize(pCreateInfo->controller);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "invalid dynamic resolution controller create info");
+        return ppxres;
+    }
+
+    ppxres = pCreateInfo->pQueue->GetTimestampFrequency(&mFrequency);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Timestamps
+    mFrames.resize(pCreateInfo->frameCount);
+    for (auto& frame : mFrames) {
+        grfx::QueryCreateInfo createInfo = {};
+        createInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        createInfo.count                 = 2;
+
+        ppxres = GetDevice()->CreateQuery(&createInfo, &frame.timestamps);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating dynamic resolution timestamp query");
+            return ppxres;
+        }
+        frame.timestamps->Reset(0, createInfo.count);
+    }
+
+    // Sampler
+    {
+        grfx::SamplerCreateInfo createInfo = {};
+        createInfo.magFilter               = grfx::FILTER_LINEAR;
+        createInfo.minFilter               = grfx::FILTER_LINEAR;
+        createInfo.mipmapMode              = grfx::SAMPLER_MIPMAP_MODE_NEAREST;
+        createInfo.addressModeU            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.addressModeV            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.addressModeW            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+        ppxres = GetDevice()->CreateSampler(&createInfo, &mSampler);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating dynamic resolution sampler");
+            return ppxres;
+        }
+    }
+
+    // Descriptors
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sampledImage                   = kMaxDescriptorSets;
+        poolCreateInfo.sampler                        = kMaxDescriptorSets;
+
+        ppxres = GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating dynamic resolution descriptor pool");
+            return ppxres;
+        }
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DYNAMIC_RESOLUTION_TEXTURE_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(DYNAMIC_RESOLUTION_SAMPLER_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLER));
+
+        ppxres = GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating dynamic resolution descriptor set layout");
+            return ppxres;
+        }
+    }
+
+    // Pipeline interface
+    {
+        grfx::PipelineInterfaceCreateInfo createInfo = {};
+        createInfo.setCount                          = 1;
+        createInfo.sets[0].set                       = 0;
+        createInfo.sets[0].pLayout                   = mSetLayout;
+        createInfo.pushConstants.count               = sizeof(UpscaleParams) / sizeof(uint32_t);
+        createInfo.pushConstants.binding             = DYNAMIC_RESOLUTION_PARAMS_REGISTER;
+        createInfo.pushConstants.set                 = 0;
+
+        ppxres = GetDevice()->CreatePipelineInterface(&createInfo, &mPipelineInterface);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline interface");
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::GraphicsPipelineCreateInfo2 createInfo  = {};
+        createInfo.VS                                 = {pCreateInfo->VS.pModule, pCreateInfo->VS.entryPoint};
+        createInfo.PS                                 = {pCreateInfo->PS.pModule, pCreateInfo->PS.entryPoint};
+        createInfo.depthReadEnable                    = false;
+        createInfo.depthWriteEnable                   = false;
+        createInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        createInfo.outputState.renderTargetCount      = 1;
+        createInfo.outputState.renderTargetFormats[0] = pCreateInfo->outputFormat;
+        createInfo.pPipelineInterface                 = mPipelineInterface;
+
+        ppxres = GetDevice()->CreateGraphicsPipeline(&createInfo, &mPipeline);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline");
+            return ppxres;
+        }
+    }
+
+    ppxres = CreateDrawPass(pCreateInfo->width, pCreateInfo->height);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    mFrameIndex     = UINT32_MAX;
+    mGpuFrameTimeMs = 0.0f;
+    UpdateRenderSize();
+
+    return ppx::SUCCESS;
+}
+
+void DynamicResolution::DestroyApiObjects()
+{
+    // Sets freed by Resize() must go before their pool
+    if (mHasDeferredDestroys) {
+        GetDevice()->FlushDeferredDestroys();
+        mHasDeferredDestroys = false;
+    }
+
+    if (mSet) {
+        GetDevice()->FreeDescriptorSet(mSet);
+        mSet.Reset();
+    }
+
+    if (mDrawPass) {
+        GetDevice()->DestroyDrawPass(mDrawPass);
+        mDrawPass.Reset();
+    }
+
+    if (mPipeline) {
+        GetDevice()->DestroyGraphicsPipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        GetDevice()->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        GetDevice()->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        GetDevice()->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mSampler) {
+        GetDevice()->DestroySampler(mSampler);
+        mSampler.Reset();
+    }
+
+    for (auto& frame : mFrames) {
+        if (frame.timestamps) {
+            GetDevice()->DestroyQuery(frame.timestamps);
+            frame.timestamps.Reset();
+        }
+    }
+    mFrames.clear();
+}
+
+Result DynamicResolution::CreateDrawPass(uint32_t width, uint32_t height)
+{
+    grfx::DrawPassCreateInfo createInfo     = {};
+    createInfo.width                        = width;
+    createInfo.height                       = height;
+    createInfo.renderTargetCount            = 1;
+    createInfo.renderTargetFormats[0]       = mCreateInfo.renderTargetFormat;
+    createInfo.depthStencilFormat           = mCreateInfo.depthStencilFormat;
+    createInfo.renderTargetUsageFlags[0]    = grfx::IMAGE_USAGE_SAMPLED;
+    createInfo.depthStencilUsageFlags       = grfx::IMAGE_USAGE_SAMPLED; // For grfx::TemporalResolve
+    createInfo.renderTargetInitialStates[0] = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+    createInfo.depthStencilInitialState     = grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE;
+    createInfo.renderTargetClearValues[0]   = {0, 0, 0, 0};
+    createInfo.depthStencilClearValue       = {1.0f, 0xFF};
+
+    grfx::DrawPassPtr drawPass;
+    Result            ppxres = GetDevice()->CreateDrawPass(&createInfo, &drawPass);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed creating dynamic resolution draw pass");
+        return ppxres;
+    }
+
+    grfx::DescriptorSetPtr set;
+    ppxres = GetDevice()->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+    if (Failed(ppxres)) {
+        // The pool is full of sets waiting on deferred frees
+        GetDevice()->FlushDeferredDestroys();
+        ppxres = GetDevice()->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+    }
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed allocating dynamic resolution descriptor set");
+        GetDevice()->DestroyDrawPass(drawPass);
+        return ppxres;
+    }
+
+    set->UpdateSampledImage(DYNAMIC_RESOLUTION_TEXTURE_REGISTER, 0, drawPass->GetRenderTargetTexture(0));
+    set->UpdateSampler(DYNAMIC_RESOLUTION_SAMPLER_REGISTER, 0, mSampler);
+
+    // Frames in flight may still render to or sample the old ones
+    if (mSet) {
+        GetDevice()->DeferFreeDescriptorSet(mSet);
+    }
+    if (mDrawPass) {
+        GetDevice()->DeferDestroyDrawPass(mDrawPass);
+        mHasDeferredDestroys = true;
+    }
+
+    mDrawPass          = drawPass;
+    mSet               = set;
+    mCreateInfo.width  = width;
+    mCreateInfo.height = height;
+
+    return ppx::SUCCESS;
+}
+
+Result DynamicResolution::Resize(uint32_t width, uint32_t height)
+{
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((width == mCreateInfo.width) && (height == mCreateInfo.height)) {
+        return ppx::SUCCESS;
+    }
+
+    Result ppxres = CreateDrawPass(width, height);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    UpdateRenderSize();
+
+    return ppx::SUCCESS;
+}
+
+void DynamicResolution::UpdateRenderSize()
+{
+    mController.GetRenderSize(mCreateInfo.width, mCreateInfo.height, &mRenderWidth, &mRenderHeight);
+}
+
+grfx::Rect DynamicResolution::GetRenderScissor() const
+{
+    return grfx::Rect(0, 0, mRenderWidth, mRenderHeight);
+}
+
+grfx::Viewport DynamicResolution::GetRenderViewport(float minDepth, float maxDepth) const
+{
+    grfx::Viewport viewport = {};
+    viewport.x              = 0.0f;
+    viewport.y              = 0.0f;
+    viewport.width          = static_cast<float>(mRenderWidth);
+    viewport.height         = static_cast<float>(mRenderHeight);
+    viewport.minDepth       = minDepth;
+    viewport.maxDepth       = maxDepth;
+    return viewport;
+}
+
+void DynamicResolution::BeginFrame(grfx::CommandBuffer* pCommandBuffer, uint32_t frameIndex)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mFrames), "dynamic resolution frame index out of range");
+    PPX_ASSERT_MSG(mFrameIndex == UINT32_MAX, "dynamic resolution EndFrame() of the previous frame wasn't called");
+
+    Frame& frame = mFrames[frameIndex];
+    if (frame.resolved) {
+        uint64_t timestamps[2] = {};
+        Result   ppxres        = frame.timestamps->GetData(timestamps, sizeof(timestamps));
+        if (!Failed(ppxres) && (timestamps[1] > timestamps[0]) && (mFrequency > 0)) {
+            mGpuFrameTimeMs = static_cast<float>(static_cast<double>(timestamps[1] - timestamps[0]) * 1000.0 / static_cast<double>(mFrequency));
+            if (mController.Update(mGpuFrameTimeMs)) {
+                UpdateRenderSize();
+            }
+        }
+        frame.timestamps->Reset(0, 2);
+        frame.resolved = false;
+    }
+
+    pCommandBuffer->WriteTimestamp(frame.timestamps, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0);
+    mFrameIndex = frameIndex;
+}
+
+void DynamicResolution::EndFrame(grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(mFrameIndex != UINT32_MAX, "dynamic resolution EndFrame() without BeginFrame()");
+
+    Frame& frame = mFrames[mFrameIndex];
+    pCommandBuffer->WriteTimestamp(frame.timestamps, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 1);
+    pCommandBuffer->ResolveQueryData(frame.timestamps, 0, 2);
+    frame.resolved = true;
+
+    mFrameIndex = UINT32_MAX;
+}
+
+void DynamicResolution::Upscale(grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+
+    const float width  = static_cast<float>(mCreateInfo.width);
+    const float height = static_cast<float>(mCreateInfo.height);
+
+    UpscaleParams params = {};
+    params.uvScale[0]    = static_cast<float>(mRenderWidth) / width;
+    params.uvScale[1]    = static_cast<float>(mRenderHeight) / height;
+    params.uvMax[0]      = (static_cast<float>(mRenderWidth) - 0.5f) / width;
+    params.uvMax[1]      = (static_cast<float>(mRenderHeight) - 0.5f) / height;
+
+    pCommandBuffer->BindGraphicsPipeline(mPipeline);
+    pCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mSet);
+    pCommandBuffer->PushGraphicsConstants(mPipelineInterface, sizeof(UpscaleParams) / sizeof(uint32_t), &params);
+    pCommandBuffer->Draw(3);
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -53,7 +53,7 @@ Result FullscreenQuad::CreateApiObjects(const grfx::FullscreenQuadCreateInfo* pC
         // Render target formats
         createInfo.outputState.renderTargetCount = pCreateInfo->renderTargetCount;
         for (uint32_t i = 0; i < createInfo.outputState.renderTargetCount; ++i) {
-            createInfo.blendModes[i]                      = grfx::BLEND_MODE_NONE;
+            createInfo.blendModes[i]                      = pCreateInfo->blendMode;
             createInfo.outputState.renderTargetFormats[i] = pCreateInfo->renderTargetFormats[i];
         }
 
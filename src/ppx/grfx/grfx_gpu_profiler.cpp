@@ -0,0 +1,245 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_gpu_profiler.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_queue.h"
+#include "ppx/timer.h"
+
+namespace ppx {
+namespace grfx {
+
+Result GpuProfiler::CreateApiObjects(const grfx::GpuProfilerCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->pQueue)) {
+        PPX_ASSERT_MSG(false, "GPU profiler needs the queue it profiles");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((pCreateInfo->frameCount == 0) || (pCreateInfo->maxScopesPerFrame == 0)) {
+        PPX_ASSERT_MSG(false, "GPU profiler frame count and max scopes per frame must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    Result ppxres = pCreateInfo->pQueue->GetTimestampFrequency(&mFrequency);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    mPerFrame.resize(pCreateInfo->frameCount);
+    for (auto& frame : mPerFrame) {
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_TIMESTAMP;
+        queryCreateInfo.count                 = 2 * pCreateInfo->maxScopesPerFrame;
+
+        ppxres = GetDevice()->CreateQuery(&queryCreateInfo, &frame.timestamps);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        frame.timestamps->Reset(0, queryCreateInfo.count);
+
+        if (pCreateInfo->enablePipelineStatistics) {
+            queryCreateInfo.type  = grfx::QUERY_TYPE_PIPELINE_STATISTICS;
+            queryCreateInfo.count = pCreateInfo->maxScopesPerFrame;
+
+            ppxres = GetDevice()->CreateQuery(&queryCreateInfo, &frame.statistics);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            frame.statistics->Reset(0, queryCreateInfo.count);
+        }
+
+        frame.scopes.reserve(pCreateInfo->maxScopesPerFrame);
+    }
+
+    mTimestampData.resize(2 * pCreateInfo->maxScopesPerFrame);
+    if (pCreateInfo->enablePipelineStatistics) {
+        mStatisticsData.resize(pCreateInfo->maxScopesPerFrame);
+    }
+
+    return ppx::SUCCESS;
+}
+
+void GpuProfiler::DestroyApiObjects()
+{
+    for (auto& frame : mPerFrame) {
+        if (frame.timestamps) {
+            GetDevice()->DestroyQuery(frame.timestamps);
+        }
+        if (frame.statistics) {
+            GetDevice()->DestroyQuery(frame.statistics);
+        }
+    }
+    mPerFrame.clear();
+    mScopes.clear();
+}
+
+void GpuProfiler::ReadResults(PerFrame& frame)
+{
+    const uint32_t timestampCount = 2 * CountU32(frame.scopes);
+
+    Result ppxres = frame.timestamps->GetData(DataPtr(mTimestampData), timestampCount * sizeof(uint64_t));
+    if (Failed(ppxres)) {
+        return;
+    }
+
+    if (frame.statisticsCount > 0) {
+        ppxres = frame.statistics->GetData(DataPtr(mStatisticsData), frame.statisticsCount * sizeof(grfx::PipelineStatistics));
+        if (Failed(ppxres)) {
+            return;
+        }
+    }
+
+    // Scopes are in the order they began, the first begins the frame
+    const uint64_t frameBegin = mTimestampData[0];
+    auto           toMs       = [this](uint64_t ticks) {
+        return (mFrequency > 0) ? (static_cast<double>(ticks) * 1000.0 / static_cast<double>(mFrequency)) : 0.0;
+    };
+
+    mScopes.resize(frame.scopes.size());
+    for (size_t i = 0; i < frame.scopes.size(); ++i) {
+        const ScopeRecord& record = frame.scopes[i];
+        const uint64_t     begin  = mTimestampData[2 * i + 0];
+        const uint64_t     end    = mTimestampData[2 * i + 1];
+
+        grfx::GpuProfilerScope& scope = mScopes[i];
+        scope.name                    = record.name;
+        scope.path                    = record.path;
+        scope.depth                   = record.depth;
+        scope.startMs                 = (begin > frameBegin) ? toMs(begin - frameBegin) : 0.0;
+        scope.gpuMs                   = (end > begin) ? toMs(end - begin) : 0.0;
+        scope.hasPipelineStatistics   = (record.statisticsIndex != UINT32_MAX);
+        scope.pipelineStatistics      = scope.hasPipelineStatistics ? mStatisticsData[record.statisticsIndex] : grfx::PipelineStatistics{};
+    }
+    mScopesFrameNumber  = frame.frameNumber;
+    mScopesCpuTimestamp = frame.cpuTimestamp;
+}
+
+void GpuProfiler::BeginFrame(uint32_t frameIndex)
+{
+    PPX_ASSERT_MSG(frameIndex < CountU32(mPerFrame), "GPU profiler frame index out of range");
+    PPX_ASSERT_MSG(mScopeStack.empty(), "GPU profiler scopes of the previous frame were not ended");
+
+    PerFrame& frame = mPerFrame[frameIndex];
+    if (frame.resolved && !frame.scopes.empty()) {
+        ReadResults(frame);
+    }
+
+    // Reset only what the previous use wrote, the rest is still unused
+    if (!frame.scopes.empty()) {
+        frame.timestamps->Reset(0, 2 * CountU32(frame.scopes));
+    }
+    if (frame.statisticsCount > 0) {
+        frame.statistics->Reset(0, frame.statisticsCount);
+    }
+
+    frame.scopes.clear();
+    frame.statisticsCount = 0;
+    frame.frameNumber     = ++mFrameNumber;
+    frame.resolved        = false;
+
+    mFrameIndex      = frameIndex;
+    mStatisticsScope = UINT32_MAX;
+}
+
+void GpuProfiler::EndFrame(grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(mFrameIndex != UINT32_MAX, "GPU profiler EndFrame() without BeginFrame()");
+    PPX_ASSERT_MSG(mScopeStack.empty(), "GPU profiler scopes were not ended before EndFrame()");
+
+    PerFrame& frame = mPerFrame[mFrameIndex];
+    if (!frame.scopes.empty()) {
+        pCommandBuffer->ResolveQueryData(frame.timestamps, 0, 2 * CountU32(frame.scopes));
+    }
+    if (frame.statisticsCount > 0) {
+        pCommandBuffer->ResolveQueryData(frame.statistics, 0, frame.statisticsCount);
+    }
+    Timer::Timestamp(&frame.cpuTimestamp);
+    frame.resolved = true;
+
+    mFrameIndex = UINT32_MAX;
+}
+
+void GpuProfiler::BeginScope(grfx::CommandBuffer* pCommandBuffer, const std::string& name, bool pipelineStatistics)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(mFrameIndex != UINT32_MAX, "GPU profiler BeginScope() outside of BeginFrame() and EndFrame()");
+
+    pCommandBuffer->BeginDebugLabel(name.c_str());
+
+    PerFrame& frame = mPerFrame[mFrameIndex];
+    if (frame.scopes.size() >= mCreateInfo.maxScopesPerFrame) {
+        if (!mOverflowWarned) {
+            PPX_LOG_WARN("GPU profiler ran out of scopes, increase maxScopesPerFrame (" << mCreateInfo.maxScopesPerFrame << ")");
+            mOverflowWarned = true;
+        }
+        mScopeStack.push_back(UINT32_MAX);
+        return;
+    }
+
+    const uint32_t scopeIndex = CountU32(frame.scopes);
+
+    // Dropped parents are left out of the path
+    ScopeRecord record = {};
+    record.name        = name;
+    record.path        = name;
+    record.depth       = 0;
+    for (auto it = mScopeStack.rbegin(); it != mScopeStack.rend(); ++it) {
+        if (*it != UINT32_MAX) {
+            record.path  = frame.scopes[*it].path + "/" + name;
+            record.depth = frame.scopes[*it].depth + 1;
+            break;
+        }
+    }
+
+    pCommandBuffer->WriteTimestamp(frame.timestamps, grfx::PIPELINE_STAGE_TOP_OF_PIPE_BIT, 2 * scopeIndex + 0);
+
+    if (pipelineStatistics && frame.statistics && (mStatisticsScope == UINT32_MAX)) {
+        record.statisticsIndex = frame.statisticsCount++;
+        mStatisticsScope       = scopeIndex;
+        pCommandBuffer->BeginQuery(frame.statistics, record.statisticsIndex);
+    }
+
+    frame.scopes.push_back(record);
+    mScopeStack.push_back(scopeIndex);
+}
+
+void GpuProfiler::EndScope(grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(!mScopeStack.empty(), "GPU profiler EndScope() without BeginScope()");
+
+    const uint32_t scopeIndex = mScopeStack.back();
+    mScopeStack.pop_back();
+
+    if (scopeIndex != UINT32_MAX) {
+        PerFrame&          frame  = mPerFrame[mFrameIndex];
+        const ScopeRecord& record = frame.scopes[scopeIndex];
+
+        if (scopeIndex == mStatisticsScope) {
+            pCommandBuffer->EndQuery(frame.statistics, record.statisticsIndex);
+            mStatisticsScope = UINT32_MAX;
+        }
+
+        pCommandBuffer->WriteTimestamp(frame.timestamps, grfx::PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 2 * scopeIndex + 1);
+    }
+
+    pCommandBuffer->EndDebugLabel();
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -0,0 +1,520 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_ibl_generator.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_format.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in IBLGenerate.hlsl
+enum
+{
+    IBL_PARAMS_REGISTER          = 0,
+    IBL_SRC_REGISTER             = 1,
+    IBL_DST_REGISTER             = 2,
+    IBL_SH_COEFFICIENTS_REGISTER = 3,
+    IBL_SAMPLER_REGISTER         = 4,
+    IBL_SH_INPUT_REGISTER        = 5,
+};
+
+// Pixels per group of the irradiance, prefilter and BRDF LUT kernels
+static const uint32_t kGroupSize = 8;
+
+// Must match IBLGenerate.hlsl
+struct IBLConstants
+{
+    uint32_t srcSize[2];
+    uint32_t dstSize[2];
+    uint32_t srcLevelCount;
+    uint32_t sampleCount;
+    float    roughness;
+};
+
+static uint32_t DivideRoundUp(uint32_t value, uint32_t divisor)
+{
+    return (value + divisor - 1) / divisor;
+}
+
+IBLGenerator::IBLGenerator()
+{
+}
+
+IBLGenerator::~IBLGenerator()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    for (grfx::ComputePipelinePtr* pPipeline : {&mProjectSHPipeline, &mIrradiancePipeline, &mPrefilterPipeline, &mBRDFLUTPipeline}) {
+        if (*pPipeline) {
+            mDevice->DestroyComputePipeline(*pPipeline);
+            pPipeline->Reset();
+        }
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mSampler) {
+        mDevice->DestroySampler(mSampler);
+        mSampler.Reset();
+    }
+
+    if (mSHBuffer) {
+        mDevice->DestroyBuffer(mSHBuffer);
+        mSHBuffer.Reset();
+    }
+}
+
+Result IBLGenerator::Create(grfx::Device* pDevice, const grfx::IBLGeneratorCreateInfo& createInfo, grfx::IBLGenerator** ppGenerator)
+{
+    if (IsNull(pDevice) || IsNull(ppGenerator) || IsNull(createInfo.pProjectSHShader) || IsNull(createInfo.pIrradianceShader) || IsNull(createInfo.pPrefilterShader) || IsNull(createInfo.pBRDFLUTShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxDispatchCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::IBLGenerator* pGenerator = new grfx::IBLGenerator();
+    if (IsNull(pGenerator)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pGenerator->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pGenerator;
+        return ppxres;
+    }
+
+    *ppGenerator = pGenerator;
+
+    return ppx::SUCCESS;
+}
+
+Result IBLGenerator::Initialize(grfx::Device* pDevice, const grfx::IBLGeneratorCreateInfo& createInfo)
+{
+    mDevice           = pDevice;
+    mMaxDispatchCount = createInfo.maxDispatchCount;
+
+    // The SH coefficients stay on the GPU between the projection and the irradiance pass
+    grfx::BufferCreateInfo bufferCreateInfo             = {};
+    bufferCreateInfo.size                               = kSHCoefficientCount * 4 * sizeof(float);
+    bufferCreateInfo.structuredElementStride            = 4 * sizeof(float);
+    bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+    bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+    bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+    bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+
+    Result ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mSHBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Lat-long environments wrap horizontally and clamp at the poles
+    grfx::SamplerCreateInfo samplerCreateInfo = {};
+    samplerCreateInfo.magFilter               = grfx::FILTER_LINEAR;
+    samplerCreateInfo.minFilter               = grfx::FILTER_LINEAR;
+    samplerCreateInfo.mipmapMode              = grfx::SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerCreateInfo.addressModeU            = grfx::SAMPLER_ADDRESS_MODE_REPEAT;
+    samplerCreateInfo.addressModeV            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.addressModeW            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerCreateInfo.minLod                  = 0.0f;
+    samplerCreateInfo.maxLod                  = 1000.0f;
+
+    ppxres = pDevice->CreateSampler(&samplerCreateInfo, &mSampler);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sampledImage                   = mMaxDispatchCount;
+    poolCreateInfo.storageImage                   = mMaxDispatchCount;
+    poolCreateInfo.structuredBuffer               = 2 * mMaxDispatchCount;
+    poolCreateInfo.sampler                        = mMaxDispatchCount;
+
+    ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IBL_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IBL_DST_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IBL_SH_COEFFICIENTS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IBL_SAMPLER_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IBL_SH_INPUT_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(IBLConstants) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = IBL_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.pProjectSHShader, &mProjectSHPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.pIrradianceShader, &mIrradiancePipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.pPrefilterShader, &mPrefilterPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.pBRDFLUTShader, &mBRDFLUTPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result IBLGenerator::CreatePipeline(grfx::ShaderModule* pShader, grfx::ComputePipeline** ppPipeline)
+{
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    return mDevice->CreateComputePipeline(&cpCreateInfo, ppPipeline);
+}
+
+bool IBLGenerator::IsSupported(const grfx::Image* pImage)
+{
+    if (IsNull(pImage)) {
+        return false;
+    }
+
+    if (!pImage->GetUsageFlags().bits.storage) {
+        return false;
+    }
+    if ((pImage->GetType() != grfx::IMAGE_TYPE_2D) || (pImage->GetSampleCount() != grfx::SAMPLE_COUNT_1)) {
+        return false;
+    }
+
+    // Radiance is unbounded, so only float formats hold it
+    const grfx::FormatDesc* pDesc = grfx::GetFormatDescription(pImage->GetFormat());
+    return !IsNull(pDesc) && (pDesc->aspect == grfx::FORMAT_ASPECT_COLOR) && (pDesc->dataType == grfx::FORMAT_DATA_TYPE_FLOAT);
+}
+
+Result IBLGenerator::CheckDispatchCount(uint32_t count) const
+{
+    if ((GetDispatchCount() + count) > mMaxDispatchCount) {
+        PPX_ASSERT_MSG(false, "IBLGenerator: more dispatches than IBLGeneratorCreateInfo::maxDispatchCount, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    return ppx::SUCCESS;
+}
+
+Result IBLGenerator::AddDispatch(grfx::Image* pSrc, grfx::Image* pDst, uint32_t dstLevel)
+{
+    DispatchResources dispatch = {};
+
+    // The source is read with every level, the prefilter picks them by sample density
+    Result ppxres = ppx::SUCCESS;
+    if (!IsNull(pSrc)) {
+        grfx::SampledImageViewCreateInfo sampledViewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(pSrc);
+
+        ppxres = mDevice->CreateSampledImageView(&sampledViewCreateInfo, &dispatch.srcView);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    if (!IsNull(pDst)) {
+        grfx::StorageImageViewCreateInfo storageViewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(pDst);
+        storageViewCreateInfo.mipLevel                         = dstLevel;
+        storageViewCreateInfo.mipLevelCount                    = 1;
+
+        ppxres = mDevice->CreateStorageImageView(&storageViewCreateInfo, &dispatch.dstView);
+        if (Failed(ppxres)) {
+            DestroyDispatch(dispatch);
+            return ppxres;
+        }
+    }
+
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &dispatch.set);
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    std::vector<grfx::WriteDescriptor> writes;
+
+    grfx::WriteDescriptor write  = {};
+    write.binding                = IBL_SH_COEFFICIENTS_REGISTER;
+    write.type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+    write.bufferOffset           = 0;
+    write.bufferRange            = PPX_WHOLE_SIZE;
+    write.structuredElementCount = kSHCoefficientCount;
+    write.pBuffer                = mSHBuffer;
+    writes.push_back(write);
+
+    write.binding = IBL_SH_INPUT_REGISTER;
+    write.type    = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+    writes.push_back(write);
+
+    write          = {};
+    write.binding  = IBL_SAMPLER_REGISTER;
+    write.type     = grfx::DESCRIPTOR_TYPE_SAMPLER;
+    write.pSampler = mSampler;
+    writes.push_back(write);
+
+    if (dispatch.srcView) {
+        write            = {};
+        write.binding    = IBL_SRC_REGISTER;
+        write.type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        write.pImageView = dispatch.srcView;
+        writes.push_back(write);
+    }
+
+    if (dispatch.dstView) {
+        write            = {};
+        write.binding    = IBL_DST_REGISTER;
+        write.type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        write.pImageView = dispatch.dstView;
+        writes.push_back(write);
+    }
+
+    ppxres = dispatch.set->UpdateDescriptors(CountU32(writes), writes.data());
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    mDispatches.push_back(dispatch);
+
+    return ppx::SUCCESS;
+}
+
+void IBLGenerator::DestroyDispatch(DispatchResources& dispatch)
+{
+    if (dispatch.set) {
+        mDevice->FreeDescriptorSet(dispatch.set);
+        dispatch.set.Reset();
+    }
+    if (dispatch.dstView) {
+        mDevice->DestroyStorageImageView(dispatch.dstView);
+        dispatch.dstView.Reset();
+    }
+    if (dispatch.srcView) {
+        mDevice->DestroySampledImageView(dispatch.srcView);
+        dispatch.srcView.Reset();
+    }
+}
+
+Result IBLGenerator::RecordEnvironment(
+    grfx::CommandBuffer*            pCmd,
+    const grfx::IBLGeneratorParams& params,
+    grfx::Image*                    pSource,
+    grfx::ResourceState             srcState,
+    grfx::Image*                    pIrradiance,
+    grfx::Image*                    pEnvironment,
+    grfx::ResourceState             dstStateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pSource);
+    PPX_ASSERT_NULL_ARG(pIrradiance);
+    PPX_ASSERT_NULL_ARG(pEnvironment);
+
+    if (!pSource->GetUsageFlags().bits.sampled || !IsSupported(pIrradiance) || !IsSupported(pEnvironment)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if ((params.shSampleWidth < 2) || (params.prefilterSampleCount == 0)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    const uint32_t levelCount = pEnvironment->GetMipLevelCount();
+
+    // Projection, irradiance and one prefilter per environment level
+    Result ppxres = CheckDispatchCount(2 + levelCount);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t firstDispatch = GetDispatchCount();
+    ppxres                       = AddDispatch(pSource, nullptr, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    ppxres = AddDispatch(nullptr, pIrradiance, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        ppxres = AddDispatch(pSource, pEnvironment, level);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    const uint32_t srcLevelCount = pSource->GetMipLevelCount();
+
+    IBLConstants constants  = {};
+    constants.srcSize[0]    = pSource->GetWidth();
+    constants.srcSize[1]    = pSource->GetHeight();
+    constants.srcLevelCount = srcLevelCount;
+
+    // The destinations' contents are discarded
+    pCmd->FlushBarriers();
+    pSource->SetTrackedState(srcState, 0, srcLevelCount);
+    pIrradiance->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 0, 1);
+    pEnvironment->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 0, levelCount);
+    pCmd->TransitionImageState(pSource, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0, srcLevelCount);
+    pCmd->TransitionImageState(pIrradiance, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 0, 1);
+    pCmd->TransitionImageState(pEnvironment, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 0, levelCount);
+    pCmd->TransitionBufferState(mSHBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->FlushBarriers();
+
+    // SH projection, a single group
+    const grfx::DescriptorSet* pSet = mDispatches[firstDispatch].set.Get();
+    constants.dstSize[0]            = params.shSampleWidth;
+    constants.dstSize[1]            = params.shSampleWidth / 2;
+    pCmd->BindComputePipeline(mProjectSHPipeline);
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+    pCmd->Dispatch(1, 1, 1);
+
+    // Irradiance
+    pCmd->TransitionBufferState(mSHBuffer, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCmd->FlushBarriers();
+
+    pSet                 = mDispatches[firstDispatch + 1].set.Get();
+    constants.dstSize[0] = pIrradiance->GetWidth();
+    constants.dstSize[1] = pIrradiance->GetHeight();
+    pCmd->BindComputePipeline(mIrradiancePipeline);
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+    pCmd->Dispatch(DivideRoundUp(constants.dstSize[0], kGroupSize), DivideRoundUp(constants.dstSize[1], kGroupSize), 1);
+
+    // Prefiltered environment, level 0 is the mirror reflection
+    pCmd->BindComputePipeline(mPrefilterPipeline);
+    constants.sampleCount = params.prefilterSampleCount;
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        pSet = mDispatches[firstDispatch + 2 + level].set.Get();
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+
+        constants.dstSize[0] = std::max<uint32_t>(pEnvironment->GetWidth() >> level, 1);
+        constants.dstSize[1] = std::max<uint32_t>(pEnvironment->GetHeight() >> level, 1);
+        constants.roughness  = static_cast<float>(level) / static_cast<float>(levelCount);
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+
+        pCmd->Dispatch(DivideRoundUp(constants.dstSize[0], kGroupSize), DivideRoundUp(constants.dstSize[1], kGroupSize), 1);
+    }
+
+    pCmd->TransitionBufferState(mSHBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->TransitionImageState(pSource, srcState, 0, srcLevelCount);
+    pCmd->TransitionImageState(pIrradiance, dstStateAfter, 0, 1);
+    pCmd->TransitionImageState(pEnvironment, dstStateAfter, 0, levelCount);
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+Result IBLGenerator::RecordBRDFLUT(
+    grfx::CommandBuffer*            pCmd,
+    const grfx::IBLGeneratorParams& params,
+    grfx::Image*                    pLUT,
+    grfx::ResourceState             dstStateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pLUT);
+
+    if (!IsSupported(pLUT)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if (params.brdfLUTSampleCount == 0) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    Result ppxres = CheckDispatchCount(1);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = AddDispatch(nullptr, pLUT, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    IBLConstants constants = {};
+    constants.dstSize[0]   = pLUT->GetWidth();
+    constants.dstSize[1]   = pLUT->GetHeight();
+    constants.sampleCount  = params.brdfLUTSampleCount;
+
+    pCmd->FlushBarriers();
+    pLUT->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 0, 1);
+    pCmd->TransitionImageState(pLUT, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 0, 1);
+    pCmd->FlushBarriers();
+
+    const grfx::DescriptorSet* pSet = mDispatches.back().set.Get();
+    pCmd->BindComputePipeline(mBRDFLUTPipeline);
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+    pCmd->Dispatch(DivideRoundUp(constants.dstSize[0], kGroupSize), DivideRoundUp(constants.dstSize[1], kGroupSize), 1);
+
+    pCmd->TransitionImageState(pLUT, dstStateAfter, 0, 1);
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+void IBLGenerator::Reset()
+{
+    for (auto& dispatch : mDispatches) {
+        DestroyDispatch(dispatch);
+    }
+    mDispatches.clear();
+}
+
+} // namespace grfx
+} // namespace ppx
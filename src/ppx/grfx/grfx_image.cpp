@@ -13,10 +13,95 @@
 // limitations under the License.
 
 #include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_device.h"
 
 namespace ppx {
 namespace grfx {
 
+namespace {
+
+Result CreateView(grfx::Device* pDevice, const grfx::SampledImageViewCreateInfo* pCreateInfo, grfx::SampledImageView** ppView)
+{
+    return pDevice->CreateSampledImageView(pCreateInfo, ppView);
+}
+
+Result CreateView(grfx::Device* pDevice, const grfx::StorageImageViewCreateInfo* pCreateInfo, grfx::StorageImageView** ppView)
+{
+    return pDevice->CreateStorageImageView(pCreateInfo, ppView);
+}
+
+Result CreateView(grfx::Device* pDevice, const grfx::RenderTargetViewCreateInfo* pCreateInfo, grfx::RenderTargetView** ppView)
+{
+    return pDevice->CreateRenderTargetView(pCreateInfo, ppView);
+}
+
+Result CreateView(grfx::Device* pDevice, const grfx::DepthStencilViewCreateInfo* pCreateInfo, grfx::DepthStencilView** ppView)
+{
+    return pDevice->CreateDepthStencilView(pCreateInfo, ppView);
+}
+
+void DestroyView(grfx::Device* pDevice, const grfx::SampledImageView* pView)
+{
+    pDevice->DestroySampledImageView(pView);
+}
+
+void DestroyView(grfx::Device* pDevice, const grfx::StorageImageView* pView)
+{
+    pDevice->DestroyStorageImageView(pView);
+}
+
+void DestroyView(grfx::Device* pDevice, const grfx::RenderTargetView* pView)
+{
+    pDevice->DestroyRenderTargetView(pView);
+}
+
+void DestroyView(grfx::Device* pDevice, const grfx::DepthStencilView* pView)
+{
+    pDevice->DestroyDepthStencilView(pView);
+}
+
+template <typename ViewT>
+void DestroyCachedViews(grfx::Device* pDevice, std::vector<ViewT>& cache)
+{
+    for (auto& cached : cache) {
+        DestroyView(pDevice, cached.view.Get());
+    }
+    cache.clear();
+}
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// ImageViewRange
+// -------------------------------------------------------------------------------------------------
+ImageViewRange ImageViewRange::Subresource(uint32_t mipLevel, uint32_t arrayLayer)
+{
+    ImageViewRange range  = {};
+    range.mipLevel        = mipLevel;
+    range.mipLevelCount   = 1;
+    range.arrayLayer      = arrayLayer;
+    range.arrayLayerCount = 1;
+    return range;
+}
+
+ImageViewRange ImageViewRange::MipLevel(uint32_t mipLevel)
+{
+    ImageViewRange range = {};
+    range.mipLevel       = mipLevel;
+    range.mipLevelCount  = 1;
+    return range;
+}
+
+bool ImageViewRange::operator==(const ImageViewRange& rhs) const
+{
+    return (imageViewType == rhs.imageViewType) &&
+           (format == rhs.format) &&
+           (mipLevel == rhs.mipLevel) &&
+           (mipLevelCount == rhs.mipLevelCount) &&
+           (arrayLayer == rhs.arrayLayer) &&
+           (arrayLayerCount == rhs.arrayLayerCount);
+}
+
 // -------------------------------------------------------------------------------------------------
 // ImageCreateInfo
 // -------------------------------------------------------------------------------------------------
@@ -98,14 +183,217 @@ Result Image::Create(const grfx::ImageCreateInfo* pCreateInfo)
         return ppx::ERROR_INVALID_CREATE_ARGUMENT;
     }
 
+    if (pCreateInfo->usageFlags.bits.transientAttachment) {
+        const grfx::ImageUsageFlags& usage = pCreateInfo->usageFlags;
+        if (!(usage.bits.colorAttachment || usage.bits.depthStencilAttachment) ||
+            usage.bits.transferSrc || usage.bits.transferDst || usage.bits.sampled || usage.bits.storage) {
+            PPX_ASSERT_MSG(false, "transient attachments can only be used as render target, depth stencil or input attachment");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if (!IsNull(pCreateInfo->pAliasImage) || (pCreateInfo->memoryUsage != grfx::MEMORY_USAGE_GPU_ONLY)) {
+            PPX_ASSERT_MSG(false, "transient attachments must be GPU only and can't alias memory");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+    }
+
+    if (!IsNull(pCreateInfo->pAliasImage)) {
+        if (!IsNull(pCreateInfo->pApiObject) || (pCreateInfo->memoryUsage != grfx::MEMORY_USAGE_GPU_ONLY)) {
+            PPX_ASSERT_MSG(false, "pAliasImage requires a GPU only image without pApiObject");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if (!IsNull(pCreateInfo->pAliasImage->GetAliasImage()) || pCreateInfo->pAliasImage->GetUsageFlags().bits.transientAttachment) {
+            PPX_ASSERT_MSG(false, "pAliasImage must own its memory and can't be a transient attachment");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+    }
+
+    if (pCreateInfo->hostUpload != grfx::IMAGE_HOST_UPLOAD_NONE) {
+        if (!IsNull(pCreateInfo->pApiObject) || !IsNull(pCreateInfo->pAliasImage) || (pCreateInfo->sampleCount != grfx::SAMPLE_COUNT_1)) {
+            PPX_ASSERT_MSG(false, "host upload images must own their memory and have a single sample");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if (pCreateInfo->initialState != grfx::RESOURCE_STATE_GENERAL) {
+            PPX_ASSERT_MSG(false, "host upload images must be created in RESOURCE_STATE_GENERAL");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if ((pCreateInfo->hostUpload == grfx::IMAGE_HOST_UPLOAD_LINEAR) &&
+            ((pCreateInfo->type != grfx::IMAGE_TYPE_2D) || (pCreateInfo->mipLevelCount != 1) || (pCreateInfo->arrayLayerCount != 1))) {
+            PPX_ASSERT_MSG(false, "linear host upload images must be 2D with one mip level and array layer");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if (!GetDevice()->ImageHostUploadSupported(pCreateInfo->hostUpload, pCreateInfo->format)) {
+            PPX_ASSERT_MSG(false, "host upload mode is not supported for format " << ToString(pCreateInfo->format));
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+    }
+
+    if (pCreateInfo->sparseResidency) {
+        if (!IsNull(pCreateInfo->pApiObject) || !IsNull(pCreateInfo->pAliasImage) || (pCreateInfo->hostUpload != grfx::IMAGE_HOST_UPLOAD_NONE)) {
+            PPX_ASSERT_MSG(false, "sparse resident images can't have pApiObject, pAliasImage or hostUpload");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if ((pCreateInfo->type != grfx::IMAGE_TYPE_2D) || (pCreateInfo->sampleCount != grfx::SAMPLE_COUNT_1) || (pCreateInfo->memoryUsage != grfx::MEMORY_USAGE_GPU_ONLY)) {
+            PPX_ASSERT_MSG(false, "sparse resident images must be 2D, single sampled and GPU only");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if (!GetDevice()->SparseResidencySupported()) {
+            PPX_ASSERT_MSG(false, "sparse residency is not supported");
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+    }
+
+    if (pCreateInfo->compression != grfx::IMAGE_COMPRESSION_DEFAULT) {
+        if (!IsNull(pCreateInfo->pApiObject) || !IsNull(pCreateInfo->pAliasImage)) {
+            PPX_ASSERT_MSG(false, "images with a compression override can't have pApiObject or pAliasImage");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+        if (!GetDevice()->ImageCompressionSupported(pCreateInfo->format, pCreateInfo->compression)) {
+            PPX_ASSERT_MSG(false, "compression override is not supported for format " << ToString(pCreateInfo->format));
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+    }
+
     Result ppxres = grfx::DeviceObject<grfx::ImageCreateInfo>::Create(pCreateInfo);
     if (Failed(ppxres)) {
         return ppxres;
     }
 
+    mTrackedStates.assign(GetMipLevelCount() * GetArrayLayerCount(), GetInitialState());
+
+    if (GetSparseResidency()) {
+        PPX_ASSERT_MSG((mSparseProperties.tileWidth > 0) && (mSparseProperties.tileHeight > 0), "backend didn't write the sparse properties");
+
+        mSparseTilesPerLayer = 0;
+        for (uint32_t mip = 0; mip < GetMipLevelCount(); ++mip) {
+            uint32_t countX = 0;
+            uint32_t countY = 0;
+            GetSparseTileCount(mip, &countX, &countY);
+            mSparseTilesPerLayer += countX * countY;
+        }
+        mResidentSparseTiles.assign(mSparseTilesPerLayer * GetArrayLayerCount(), false);
+        mResidentSparseTileCount = 0;
+    }
+
     return ppx::SUCCESS;
 }
 
+void Image::Destroy()
+{
+    // Device::Destroy() destroys images before views, so these are still alive
+    DestroyCachedViews(GetDevice(), mSampledImageViews);
+    DestroyCachedViews(GetDevice(), mStorageImageViews);
+    DestroyCachedViews(GetDevice(), mRenderTargetViews);
+    DestroyCachedViews(GetDevice(), mDepthStencilViews);
+
+    grfx::DeviceObject<grfx::ImageCreateInfo>::Destroy();
+}
+
+grfx::ResourceState Image::GetTrackedState(uint32_t mipLevel, uint32_t arrayLayer) const
+{
+    PPX_ASSERT_MSG(mipLevel < GetMipLevelCount(), "mip level out of range");
+    PPX_ASSERT_MSG(arrayLayer < GetArrayLayerCount(), "array layer out of range");
+    return mTrackedStates[arrayLayer * GetMipLevelCount() + mipLevel];
+}
+
+void Image::SetTrackedState(
+    grfx::ResourceState state,
+    uint32_t            mipLevel,
+    uint32_t            mipLevelCount,
+    uint32_t            arrayLayer,
+    uint32_t            arrayLayerCount)
+{
+    if (mipLevelCount == PPX_REMAINING_MIP_LEVELS) {
+        mipLevelCount = GetMipLevelCount() - mipLevel;
+    }
+    if (arrayLayerCount == PPX_REMAINING_ARRAY_LAYERS) {
+        arrayLayerCount = GetArrayLayerCount() - arrayLayer;
+    }
+    PPX_ASSERT_MSG((mipLevel + mipLevelCount) <= GetMipLevelCount(), "mip level range out of range");
+    PPX_ASSERT_MSG((arrayLayer + arrayLayerCount) <= GetArrayLayerCount(), "array layer range out of range");
+
+    for (uint32_t layer = arrayLayer; layer < (arrayLayer + arrayLayerCount); ++layer) {
+        for (uint32_t mip = mipLevel; mip < (mipLevel + mipLevelCount); ++mip) {
+            mTrackedStates[layer * GetMipLevelCount() + mip] = state;
+        }
+    }
+}
+
+void Image::GetSparseTileCount(uint32_t mipLevel, uint32_t* pCountX, uint32_t* pCountY) const
+{
+    PPX_ASSERT_NULL_ARG(pCountX);
+    PPX_ASSERT_NULL_ARG(pCountY);
+
+    *pCountX = 0;
+    *pCountY = 0;
+    if (!GetSparseResidency() || (mipLevel >= std::min(mSparseProperties.firstMipTailLevel, GetMipLevelCount()))) {
+        return;
+    }
+
+    const uint32_t width  = std::max(GetWidth() >> mipLevel, 1u);
+    const uint32_t height = std::max(GetHeight() >> mipLevel, 1u);
+    *pCountX              = (width + mSparseProperties.tileWidth - 1) / mSparseProperties.tileWidth;
+    *pCountY              = (height + mSparseProperties.tileHeight - 1) / mSparseProperties.tileHeight;
+}
+
+uint32_t Image::GetSparseTileIndex(const grfx::SparseImageTile& tile) const
+{
+    PPX_ASSERT_MSG(tile.arrayLayer < GetArrayLayerCount(), "array layer out of range");
+
+    uint32_t index = tile.arrayLayer * mSparseTilesPerLayer;
+    for (uint32_t mip = 0; mip < tile.mipLevel; ++mip) {
+        uint32_t countX = 0;
+        uint32_t countY = 0;
+        GetSparseTileCount(mip, &countX, &countY);
+        index += countX * countY;
+    }
+
+    uint32_t countX = 0;
+    uint32_t countY = 0;
+    GetSparseTileCount(tile.mipLevel, &countX, &countY);
+    PPX_ASSERT_MSG((tile.x < countX) && (tile.y < countY), "sparse tile out of range");
+
+    return index + tile.y * countX + tile.x;
+}
+
+grfx::SparseImageTile Image::GetSparseTile(uint32_t tileIndex) const
+{
+    PPX_ASSERT_MSG(tileIndex < GetSparseTileCount(), "sparse tile index out of range");
+
+    grfx::SparseImageTile tile = {};
+    tile.arrayLayer            = tileIndex / mSparseTilesPerLayer;
+
+    tileIndex -= tile.arrayLayer * mSparseTilesPerLayer;
+
+    for (uint32_t mip = 0; mip < GetMipLevelCount(); ++mip) {
+        uint32_t countX = 0;
+        uint32_t countY = 0;
+        GetSparseTileCount(mip, &countX, &countY);
+        if (tileIndex < (countX * countY)) {
+            tile.mipLevel = mip;
+            tile.x        = tileIndex % countX;
+            tile.y        = tileIndex / countX;
+            break;
+        }
+        tileIndex -= countX * countY;
+    }
+    return tile;
+}
+
+bool Image::IsSparseTileResident(const grfx::SparseImageTile& tile) const
+{
+    return mResidentSparseTiles[GetSparseTileIndex(tile)];
+}
+
+void Image::SetSparseTileResident(uint32_t tileIndex, bool resident)
+{
+    PPX_ASSERT_MSG(tileIndex < GetSparseTileCount(), "sparse tile index out of range");
+    if (mResidentSparseTiles[tileIndex] == resident) {
+        return;
+    }
+    mResidentSparseTiles[tileIndex] = resident;
+    mResidentSparseTileCount        = resident ? (mResidentSparseTileCount + 1) : (mResidentSparseTileCount - 1);
+}
+
 grfx::ImageViewType Image::GuessImageViewType(bool isCube) const
 {
     const uint32_t arrayLayerCount = GetArrayLayerCount();
@@ -127,6 +415,113 @@ grfx::ImageViewType Image::GuessImageViewType(bool isCube) const
     return grfx::IMAGE_VIEW_TYPE_UNDEFINED;
 }
 
+grfx::ImageViewRange Image::ResolveViewRange(const grfx::ImageViewRange& range) const
+{
+    grfx::ImageViewRange resolved = range;
+    if (resolved.format == grfx::FORMAT_UNDEFINED) {
+        resolved.format = GetFormat();
+    }
+    if (resolved.mipLevelCount == PPX_REMAINING_MIP_LEVELS) {
+        resolved.mipLevelCount = GetMipLevelCount() - std::min(resolved.mipLevel, GetMipLevelCount());
+    }
+    if (resolved.arrayLayerCount == PPX_REMAINING_ARRAY_LAYERS) {
+        resolved.arrayLayerCount = GetArrayLayerCount() - std::min(resolved.arrayLayer, GetArrayLayerCount());
+    }
+
+    // A subset of the layers of a cube or array image isn't viewed as a cube or array
+    if (resolved.imageViewType == grfx::IMAGE_VIEW_TYPE_UNDEFINED) {
+        const bool isArray = (resolved.arrayLayerCount > 1);
+        switch (GetType()) {
+            default: break;
+            case grfx::IMAGE_TYPE_1D: resolved.imageViewType = isArray ? grfx::IMAGE_VIEW_TYPE_1D_ARRAY : grfx::IMAGE_VIEW_TYPE_1D; break;
+            case grfx::IMAGE_TYPE_2D: resolved.imageViewType = isArray ? grfx::IMAGE_VIEW_TYPE_2D_ARRAY : grfx::IMAGE_VIEW_TYPE_2D; break;
+            case grfx::IMAGE_TYPE_3D: resolved.imageViewType = grfx::IMAGE_VIEW_TYPE_3D; break;
+            case grfx::IMAGE_TYPE_CUBE: {
+                if (resolved.arrayLayerCount == 6) {
+                    resolved.imageViewType = grfx::IMAGE_VIEW_TYPE_CUBE;
+                }
+                else if ((resolved.arrayLayerCount % 6) == 0) {
+                    resolved.imageViewType = grfx::IMAGE_VIEW_TYPE_CUBE_ARRAY;
+                }
+                else {
+                    resolved.imageViewType = isArray ? grfx::IMAGE_VIEW_TYPE_2D_ARRAY : grfx::IMAGE_VIEW_TYPE_2D;
+                }
+            } break;
+        }
+    }
+    return resolved;
+}
+
+template <typename ViewT, typename CreateInfoT>
+Result Image::GetCachedView(std::vector<CachedView<ViewT>>& cache, const grfx::ImageViewRange& range, ViewT** ppView)
+{
+    PPX_ASSERT_NULL_ARG(ppView);
+
+    const grfx::ImageViewRange resolved = ResolveViewRange(range);
+    if ((resolved.mipLevelCount == 0) || ((resolved.mipLevel + resolved.mipLevelCount) > GetMipLevelCount())) {
+        PPX_ASSERT_MSG(false, "view mip level range out of range");
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    if ((resolved.arrayLayerCount == 0) || ((resolved.arrayLayer + resolved.arrayLayerCount) > GetArrayLayerCount())) {
+        PPX_ASSERT_MSG(false, "view array layer range out of range");
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    for (const auto& cached : cache) {
+        if (cached.range == resolved) {
+            *ppView = cached.view;
+            return ppx::SUCCESS;
+        }
+    }
+
+    CreateInfoT createInfo     = CreateInfoT::GuessFromImage(this);
+    createInfo.imageViewType   = resolved.imageViewType;
+    createInfo.format          = resolved.format;
+    createInfo.mipLevel        = resolved.mipLevel;
+    createInfo.mipLevelCount   = resolved.mipLevelCount;
+    createInfo.arrayLayer      = resolved.arrayLayer;
+    createInfo.arrayLayerCount = resolved.arrayLayerCount;
+    createInfo.ownership       = grfx::OWNERSHIP_RESTRICTED;
+
+    CachedView<ViewT> cached = {};
+    cached.range             = resolved;
+    Result ppxres            = CreateView(GetDevice(), &createInfo, &cached.view);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    cache.push_back(cached);
+
+    *ppView = cached.view;
+    return ppx::SUCCESS;
+}
+
+Result Image::GetSampledImageView(const grfx::ImageViewRange& range, grfx::SampledImageView** ppView)
+{
+    return GetCachedView<grfx::SampledImageView, grfx::SampledImageViewCreateInfo>(mSampledImageViews, range, ppView);
+}
+
+Result Image::GetStorageImageView(const grfx::ImageViewRange& range, grfx::StorageImageView** ppView)
+{
+    return GetCachedView<grfx::StorageImageView, grfx::StorageImageViewCreateInfo>(mStorageImageViews, range, ppView);
+}
+
+Result Image::GetRenderTargetView(const grfx::ImageViewRange& range, grfx::RenderTargetView** ppView)
+{
+    PPX_ASSERT_MSG((range.mipLevelCount == 1) || ((range.mipLevelCount == PPX_REMAINING_MIP_LEVELS) && (range.mipLevel + 1 == GetMipLevelCount())), "render target views must cover a single mip level");
+    return GetCachedView<grfx::RenderTargetView, grfx::RenderTargetViewCreateInfo>(mRenderTargetViews, range, ppView);
+}
+
+Result Image::GetDepthStencilView(const grfx::ImageViewRange& range, grfx::DepthStencilView** ppView)
+{
+    PPX_ASSERT_MSG((range.mipLevelCount == 1) || ((range.mipLevelCount == PPX_REMAINING_MIP_LEVELS) && (range.mipLevel + 1 == GetMipLevelCount())), "depth stencil views must cover a single mip level");
+    return GetCachedView<grfx::DepthStencilView, grfx::DepthStencilViewCreateInfo>(mDepthStencilViews, range, ppView);
+}
+
+uint32_t Image::GetCachedViewCount() const
+{
+    return CountU32(mSampledImageViews) + CountU32(mStorageImageViews) + CountU32(mRenderTargetViews) + CountU32(mDepthStencilViews);
+}
+
 // -------------------------------------------------------------------------------------------------
 // DepthStencilView
 // -------------------------------------------------------------------------------------------------
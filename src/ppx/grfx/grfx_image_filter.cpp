@@ -0,0 +1,524 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_image_filter.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_format.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <algorithm>
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in ImageFilterTiled.hlsl
+enum
+{
+    IMAGE_FILTER_PARAMS_REGISTER = 0,
+    IMAGE_FILTER_SRC_REGISTER    = 1,
+    IMAGE_FILTER_DST_REGISTER    = 2,
+};
+
+// Modes of the resample kernel
+enum
+{
+    IMAGE_FILTER_MODE_DOWNSAMPLE = 0,
+    IMAGE_FILTER_MODE_UPSAMPLE   = 1,
+};
+
+// Pixels per group of each kernel
+static const uint32_t kSeparableGroupSize = 64;
+static const uint32_t k2DGroupSize        = 16;
+static const uint32_t kResampleGroupSize  = 8;
+
+// Must match ImageFilterTiled.hlsl
+struct ImageFilterConstants
+{
+    uint32_t srcSize[2];
+    uint32_t dstSize[2];
+    uint32_t mode;
+    uint32_t radius;
+    float    sigma;
+    float    rangeSigma;
+    uint32_t direction;
+};
+
+static uint32_t DivideRoundUp(uint32_t value, uint32_t divisor)
+{
+    return (value + divisor - 1) / divisor;
+}
+
+ImageFilter::ImageFilter()
+{
+}
+
+ImageFilter::~ImageFilter()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    for (grfx::ComputePipelinePtr* pPipeline : {&mSeparablePipeline, &m2DPipeline, &mResamplePipeline}) {
+        if (*pPipeline) {
+            mDevice->DestroyComputePipeline(*pPipeline);
+            pPipeline->Reset();
+        }
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+}
+
+Result ImageFilter::Create(grfx::Device* pDevice, const grfx::ImageFilterCreateInfo& createInfo, grfx::ImageFilter** ppFilter)
+{
+    if (IsNull(pDevice) || IsNull(ppFilter) || IsNull(createInfo.pSeparableShader) || IsNull(createInfo.p2DShader) || IsNull(createInfo.pResampleShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxDispatchCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::ImageFilter* pFilter = new grfx::ImageFilter();
+    if (IsNull(pFilter)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pFilter->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pFilter;
+        return ppxres;
+    }
+
+    *ppFilter = pFilter;
+
+    return ppx::SUCCESS;
+}
+
+Result ImageFilter::Initialize(grfx::Device* pDevice, const grfx::ImageFilterCreateInfo& createInfo)
+{
+    mDevice           = pDevice;
+    mMaxDispatchCount = createInfo.maxDispatchCount;
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sampledImage                   = mMaxDispatchCount;
+    poolCreateInfo.storageImage                   = mMaxDispatchCount;
+
+    Result ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IMAGE_FILTER_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(IMAGE_FILTER_DST_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(ImageFilterConstants) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = IMAGE_FILTER_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.pSeparableShader, &mSeparablePipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.p2DShader, &m2DPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = CreatePipeline(createInfo.pResampleShader, &mResamplePipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ImageFilter::CreatePipeline(grfx::ShaderModule* pShader, grfx::ComputePipeline** ppPipeline)
+{
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    return mDevice->CreateComputePipeline(&cpCreateInfo, ppPipeline);
+}
+
+bool ImageFilter::IsSupported(const grfx::Image* pImage)
+{
+    if (IsNull(pImage)) {
+        return false;
+    }
+
+    const grfx::ImageUsageFlags& usage = pImage->GetUsageFlags();
+    if (!usage.bits.storage || !usage.bits.sampled) {
+        return false;
+    }
+    if ((pImage->GetType() != grfx::IMAGE_TYPE_2D) || (pImage->GetSampleCount() != grfx::SAMPLE_COUNT_1)) {
+        return false;
+    }
+
+    const grfx::FormatDesc* pDesc = grfx::GetFormatDescription(pImage->GetFormat());
+    if (IsNull(pDesc) || (pDesc->aspect != grfx::FORMAT_ASPECT_COLOR) || (pDesc->layout == grfx::FORMAT_LAYOUT_COMPRESSED)) {
+        return false;
+    }
+    // Shaders write float4, which excludes integer and sRGB formats
+    return (pDesc->dataType == grfx::FORMAT_DATA_TYPE_UNORM) || (pDesc->dataType == grfx::FORMAT_DATA_TYPE_SNORM) || (pDesc->dataType == grfx::FORMAT_DATA_TYPE_FLOAT);
+}
+
+bool ImageFilter::UsesSeparablePasses(const grfx::ImageFilterParams& params, bool hasTemp)
+{
+    if ((params.type != grfx::IMAGE_FILTER_TYPE_GAUSSIAN) && (params.type != grfx::IMAGE_FILTER_TYPE_BOX)) {
+        return false;
+    }
+    // Two passes read 2 * (2r + 1) texels per pixel instead of (2r + 1)^2,
+    // which pays for the extra round trip through memory from r = 2 on
+    return hasTemp && (params.radius >= kMinSeparableRadius);
+}
+
+Result ImageFilter::CheckDispatchCount(uint32_t count) const
+{
+    if ((GetDispatchCount() + count) > mMaxDispatchCount) {
+        PPX_ASSERT_MSG(false, "ImageFilter: more dispatches than ImageFilterCreateInfo::maxDispatchCount, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    return ppx::SUCCESS;
+}
+
+Result ImageFilter::AddDispatch(grfx::Image* pSrc, uint32_t srcLevel, grfx::Image* pDst, uint32_t dstLevel)
+{
+    DispatchResources dispatch = {};
+
+    grfx::SampledImageViewCreateInfo sampledViewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(pSrc);
+    sampledViewCreateInfo.mipLevel                         = srcLevel;
+    sampledViewCreateInfo.mipLevelCount                    = 1;
+
+    Result ppxres = mDevice->CreateSampledImageView(&sampledViewCreateInfo, &dispatch.srcView);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::StorageImageViewCreateInfo storageViewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(pDst);
+    storageViewCreateInfo.mipLevel                         = dstLevel;
+    storageViewCreateInfo.mipLevelCount                    = 1;
+
+    ppxres = mDevice->CreateStorageImageView(&storageViewCreateInfo, &dispatch.dstView);
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &dispatch.set);
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    std::array<grfx::WriteDescriptor, 2> writes = {};
+    writes[0].binding                           = IMAGE_FILTER_SRC_REGISTER;
+    writes[0].type                              = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageView                        = dispatch.srcView;
+    writes[1].binding                           = IMAGE_FILTER_DST_REGISTER;
+    writes[1].type                              = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageView                        = dispatch.dstView;
+
+    ppxres = dispatch.set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    mDispatches.push_back(dispatch);
+
+    return ppx::SUCCESS;
+}
+
+void ImageFilter::DestroyDispatch(DispatchResources& dispatch)
+{
+    if (dispatch.set) {
+        mDevice->FreeDescriptorSet(dispatch.set);
+        dispatch.set.Reset();
+    }
+    if (dispatch.dstView) {
+        mDevice->DestroyStorageImageView(dispatch.dstView);
+        dispatch.dstView.Reset();
+    }
+    if (dispatch.srcView) {
+        mDevice->DestroySampledImageView(dispatch.srcView);
+        dispatch.srcView.Reset();
+    }
+}
+
+Result ImageFilter::Record(
+    grfx::CommandBuffer*           pCmd,
+    const grfx::ImageFilterParams& params,
+    grfx::Image*                   pSrc,
+    grfx::ResourceState            srcState,
+    grfx::Image*                   pDst,
+    grfx::ResourceState            dstStateAfter,
+    grfx::Image*                   pTemp)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pSrc);
+    PPX_ASSERT_NULL_ARG(pDst);
+    PPX_ASSERT_MSG(pSrc != pDst, "ImageFilter: source and destination must be different images");
+
+    if (!IsSupported(pSrc) || !IsSupported(pDst)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if ((pSrc->GetWidth() != pDst->GetWidth()) || (pSrc->GetHeight() != pDst->GetHeight())) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    const bool hasTemp   = IsSupported(pTemp) && (pTemp->GetWidth() == pDst->GetWidth()) && (pTemp->GetHeight() == pDst->GetHeight());
+    const bool separable = UsesSeparablePasses(params, hasTemp);
+    const bool sobel     = (params.type == grfx::IMAGE_FILTER_TYPE_SOBEL);
+    if (!sobel && (params.radius > (separable ? kMaxSeparableRadius : kMax2DRadius))) {
+        PPX_ASSERT_MSG(false, "ImageFilter: radius " << params.radius << " is too large" << (hasTemp ? "" : ", separable filters need a temp image"));
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    Result ppxres = CheckDispatchCount(separable ? 2 : 1);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t firstDispatch = GetDispatchCount();
+    ppxres                       = AddDispatch(pSrc, 0, separable ? pTemp : pDst, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    if (separable) {
+        ppxres = AddDispatch(pTemp, 0, pDst, 0);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    const uint32_t width  = pDst->GetWidth();
+    const uint32_t height = pDst->GetHeight();
+
+    ImageFilterConstants constants = {};
+    constants.srcSize[0]           = width;
+    constants.srcSize[1]           = height;
+    constants.dstSize[0]           = width;
+    constants.dstSize[1]           = height;
+    constants.mode                 = static_cast<uint32_t>(params.type);
+    constants.radius               = sobel ? 1 : params.radius;
+    constants.sigma                = (params.sigma > 0.0f) ? params.sigma : std::max(0.5f * static_cast<float>(params.radius), 0.5f);
+    constants.rangeSigma           = std::max(params.rangeSigma, 1e-4f);
+
+    // The destination's contents are discarded
+    pCmd->FlushBarriers();
+    pSrc->SetTrackedState(srcState, 0, 1);
+    pDst->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 0, 1);
+    pCmd->TransitionImageState(pSrc, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0, 1);
+
+    const grfx::DescriptorSet* pSet = mDispatches[firstDispatch].set.Get();
+    if (separable) {
+        pTemp->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 0, 1);
+        pCmd->TransitionImageState(pTemp, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 0, 1);
+        pCmd->BindComputePipeline(mSeparablePipeline);
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+        constants.direction = 0;
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+        pCmd->Dispatch(DivideRoundUp(width, kSeparableGroupSize), height, 1);
+
+        pCmd->TransitionImageState(pTemp, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0, 1);
+        pCmd->TransitionImageState(pDst, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 0, 1);
+        pSet = mDispatches[firstDispatch + 1].set.Get();
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+        constants.direction = 1;
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+        pCmd->Dispatch(DivideRoundUp(height, kSeparableGroupSize), width, 1);
+    }
+    else {
+        pCmd->TransitionImageState(pDst, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 0, 1);
+        pCmd->BindComputePipeline(m2DPipeline);
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+        pCmd->Dispatch(DivideRoundUp(width, k2DGroupSize), DivideRoundUp(height, k2DGroupSize), 1);
+    }
+
+    pCmd->TransitionImageState(pSrc, srcState, 0, 1);
+    pCmd->TransitionImageState(pDst, dstStateAfter, 0, 1);
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+Result ImageFilter::RecordDownsampleChain(
+    grfx::CommandBuffer* pCmd,
+    grfx::Image*         pImage,
+    uint32_t             levelCount,
+    grfx::ResourceState  level0State,
+    grfx::ResourceState  stateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pImage);
+
+    if (!IsSupported(pImage)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if ((levelCount < 2) || (levelCount > pImage->GetMipLevelCount())) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    Result ppxres = CheckDispatchCount(levelCount - 1);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t firstDispatch = GetDispatchCount();
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        ppxres = AddDispatch(pImage, level - 1, pImage, level);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    pCmd->FlushBarriers();
+    pImage->SetTrackedState(level0State, 0, 1);
+    pImage->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 1, levelCount - 1);
+    pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 1, levelCount - 1);
+    pCmd->BindComputePipeline(mResamplePipeline);
+
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        // The previous level was the last dispatch's destination
+        pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, level - 1, 1);
+
+        const grfx::DescriptorSet* pSet = mDispatches[firstDispatch + level - 1].set.Get();
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+
+        ImageFilterConstants constants = {};
+        constants.srcSize[0]           = std::max<uint32_t>(pImage->GetWidth() >> (level - 1), 1);
+        constants.srcSize[1]           = std::max<uint32_t>(pImage->GetHeight() >> (level - 1), 1);
+        constants.dstSize[0]           = std::max<uint32_t>(pImage->GetWidth() >> level, 1);
+        constants.dstSize[1]           = std::max<uint32_t>(pImage->GetHeight() >> level, 1);
+        constants.mode                 = IMAGE_FILTER_MODE_DOWNSAMPLE;
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+
+        pCmd->Dispatch(DivideRoundUp(constants.dstSize[0], kResampleGroupSize), DivideRoundUp(constants.dstSize[1], kResampleGroupSize), 1);
+    }
+
+    pCmd->TransitionImageState(pImage, stateAfter, 0, levelCount);
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+Result ImageFilter::RecordUpsampleChain(
+    grfx::CommandBuffer* pCmd,
+    grfx::Image*         pImage,
+    uint32_t             levelCount,
+    grfx::ResourceState  stateBefore,
+    grfx::ResourceState  stateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pImage);
+
+    if (!IsSupported(pImage)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    if ((levelCount < 2) || (levelCount > pImage->GetMipLevelCount())) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    Result ppxres = CheckDispatchCount(levelCount - 1);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Smallest level first
+    const uint32_t firstDispatch = GetDispatchCount();
+    for (uint32_t level = levelCount - 1; level > 0; --level) {
+        ppxres = AddDispatch(pImage, level, pImage, level - 1);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    pCmd->FlushBarriers();
+    pImage->SetTrackedState(stateBefore, 0, levelCount);
+    pCmd->BindComputePipeline(mResamplePipeline);
+
+    for (uint32_t i = 0; i < levelCount - 1; ++i) {
+        const uint32_t srcLevel = levelCount - 1 - i;
+        const uint32_t dstLevel = srcLevel - 1;
+
+        // The source level was the last dispatch's destination
+        pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, srcLevel, 1);
+        pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_UNORDERED_ACCESS, dstLevel, 1);
+
+        const grfx::DescriptorSet* pSet = mDispatches[firstDispatch + i].set.Get();
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+
+        ImageFilterConstants constants = {};
+        constants.srcSize[0]           = std::max<uint32_t>(pImage->GetWidth() >> srcLevel, 1);
+        constants.srcSize[1]           = std::max<uint32_t>(pImage->GetHeight() >> srcLevel, 1);
+        constants.dstSize[0]           = std::max<uint32_t>(pImage->GetWidth() >> dstLevel, 1);
+        constants.dstSize[1]           = std::max<uint32_t>(pImage->GetHeight() >> dstLevel, 1);
+        constants.mode                 = IMAGE_FILTER_MODE_UPSAMPLE;
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(constants) / sizeof(uint32_t), &constants);
+
+        pCmd->Dispatch(DivideRoundUp(constants.dstSize[0], kResampleGroupSize), DivideRoundUp(constants.dstSize[1], kResampleGroupSize), 1);
+    }
+
+    pCmd->TransitionImageState(pImage, stateAfter, 0, levelCount);
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+void ImageFilter::Reset()
+{
+    for (auto& dispatch : mDispatches) {
+        DestroyDispatch(dispatch);
+    }
+    mDispatches.clear();
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -0,0 +1,228 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_line_draw.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
+
+namespace ppx {
+namespace grfx {
+
+// Corner pairs of the 12 box edges, corner bits are x, y, z
+static const uint32_t kBoxEdges[12][2] = {
+    {0, 1}, {2, 3}, {4, 5}, {6, 7}, // Along x
+    {0, 2}, {1, 3}, {4, 6}, {5, 7}, // Along y
+    {0, 4}, {1, 5}, {2, 6}, {3, 7}, // Along z
+};
+
+Result LineDraw::CreateApiObjects(const grfx::LineDrawCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if ((pCreateInfo->maxLineCount == 0) || (pCreateInfo->frameCount == 0)) {
+        PPX_ASSERT_MSG(false, "line draw max line count and frame count must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Vertex buffers
+    mFrames.resize(pCreateInfo->frameCount);
+    for (auto& frame : mFrames) {
+        grfx::BufferCreateInfo createInfo       = {};
+        createInfo.size                         = 2 * static_cast<uint64_t>(pCreateInfo->maxLineCount) * sizeof(Vertex);
+        createInfo.usageFlags.bits.vertexBuffer = true;
+        createInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
+
+        Result ppxres = GetDevice()->CreateBuffer(&createInfo, &frame.buffer);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating line draw vertex buffer");
+            return ppxres;
+        }
+
+        // Buffers stay mapped for the lifetime of the object
+        void* pMappedAddress = nullptr;
+        ppxres               = frame.buffer->MapMemory(0, &pMappedAddress);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed mapping line draw vertex buffer");
+            return ppxres;
+        }
+        frame.pVertices = static_cast<Vertex*>(pMappedAddress);
+    }
+
+    // Pipeline interface
+    {
+        grfx::PipelineInterfaceCreateInfo createInfo = {};
+        createInfo.setCount                          = 0;
+        createInfo.pushConstants.count               = sizeof(float4x4) / sizeof(uint32_t);
+        createInfo.pushConstants.binding             = 0;
+        createInfo.pushConstants.set                 = 0;
+
+        Result ppxres = GetDevice()->CreatePipelineInterface(&createInfo, &mPipelineInterface);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline interface");
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::VertexBinding vertexBinding;
+        vertexBinding.AppendAttribute({"POSITION", 0, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+        vertexBinding.AppendAttribute({"COLOR", 1, grfx::FORMAT_R32G32B32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+
+        const bool depthTest = pCreateInfo->depthTest && (pCreateInfo->depthStencilFormat != grfx::FORMAT_UNDEFINED);
+
+        grfx::GraphicsPipelineCreateInfo2 createInfo  = {};
+        createInfo.VS                                 = {pCreateInfo->VS.pModule, pCreateInfo->VS.entryPoint};
+        createInfo.PS                                 = {pCreateInfo->PS.pModule, pCreateInfo->PS.entryPoint};
+        createInfo.vertexInputState.bindingCount      = 1;
+        createInfo.vertexInputState.bindings[0]       = vertexBinding;
+        createInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_LINE_LIST;
+        createInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        createInfo.cullMode                           = grfx::CULL_MODE_NONE;
+        createInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        createInfo.depthReadEnable                    = depthTest;
+        createInfo.depthWriteEnable                   = false;
+        createInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        createInfo.outputState.renderTargetCount      = 1;
+        createInfo.outputState.renderTargetFormats[0] = pCreateInfo->renderTargetFormat;
+        createInfo.outputState.depthStencilFormat     = pCreateInfo->depthStencilFormat;
+        createInfo.pPipelineInterface                 = mPipelineInterface;
+
+        Result ppxres = GetDevice()->CreateGraphicsPipeline(&createInfo, &mPipeline);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline");
+            return ppxres;
+        }
+    }
+
+    mFrameIndex       = 0;
+    mLineCount        = 0;
+    mDroppedLineCount = 0;
+
+    return ppx::SUCCESS;
+}
+
+void LineDraw::DestroyApiObjects()
+{
+    if (mPipeline) {
+        GetDevice()->DestroyGraphicsPipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        GetDevice()->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    for (auto& frame : mFrames) {
+        if (frame.buffer) {
+            if (!IsNull(frame.pVertices)) {
+                frame.buffer->UnmapMemory();
+                frame.pVertices = nullptr;
+            }
+            GetDevice()->DestroyBuffer(frame.buffer);
+            frame.buffer.Reset();
+        }
+    }
+    mFrames.clear();
+}
+
+void LineDraw::BeginFrame(uint32_t frameIndex)
+{
+    PPX_ASSERT_MSG(frameIndex < CountU32(mFrames), "line draw frame index out of range");
+    mFrameIndex       = frameIndex;
+    mLineCount        = 0;
+    mDroppedLineCount = 0;
+}
+
+void LineDraw::AddLine(const float3& p0, const float3& p1, const float3& color)
+{
+    if (mLineCount >= mCreateInfo.maxLineCount) {
+        ++mDroppedLineCount;
+        return;
+    }
+
+    Vertex* pVertices = mFrames[mFrameIndex].pVertices + 2 * mLineCount;
+    pVertices[0]      = {p0, color};
+    pVertices[1]      = {p1, color};
+    ++mLineCount;
+}
+
+void LineDraw::AddBoxEdges(const float3 corners[8], const float3& color)
+{
+    for (const auto& edge : kBoxEdges) {
+        AddLine(corners[edge[0]], corners[edge[1]], color);
+    }
+}
+
+void LineDraw::AddBox(const ppx::AABB& box, const float3& color)
+{
+    const float3 minPos = box.GetMin();
+    const float3 maxPos = box.GetMax();
+
+    float3 corners[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        corners[i] = float3((i & 1) ? maxPos.x : minPos.x, (i & 2) ? maxPos.y : minPos.y, (i & 4) ? maxPos.z : minPos.z);
+    }
+    AddBoxEdges(corners, color);
+}
+
+void LineDraw::AddBox(const ppx::AABB& box, const float4x4& transform, const float3& color)
+{
+    const float3 minPos = box.GetMin();
+    const float3 maxPos = box.GetMax();
+
+    float3 corners[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        const float4 corner = float4((i & 1) ? maxPos.x : minPos.x, (i & 2) ? maxPos.y : minPos.y, (i & 4) ? maxPos.z : minPos.z, 1.0f);
+        corners[i]          = float3(transform * corner);
+    }
+    AddBoxEdges(corners, color);
+}
+
+void LineDraw::AddFrustum(const float4x4& viewProjection, const float3& color)
+{
+    const float4x4 inverseViewProjection = glm::inverse(viewProjection);
+
+    float3 corners[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        const float4 corner = inverseViewProjection * float4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f, 1.0f);
+        corners[i]          = float3(corner) / corner.w;
+    }
+    AddBoxEdges(corners, color);
+}
+
+void LineDraw::Draw(grfx::CommandBuffer* pCommandBuffer, const float4x4& viewProjection)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+
+    if (mLineCount == 0) {
+        return;
+    }
+
+    grfx::VertexBufferView view = {};
+    view.pBuffer                = mFrames[mFrameIndex].buffer;
+    view.stride                 = sizeof(Vertex);
+    view.offset                 = 0;
+
+    pCommandBuffer->BindGraphicsPipeline(mPipeline);
+    pCommandBuffer->PushGraphicsConstants(mPipelineInterface, sizeof(viewProjection) / sizeof(uint32_t), &viewProjection);
+    pCommandBuffer->BindVertexBuffers(1, &view);
+    pCommandBuffer->Draw(2 * mLineCount);
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -24,6 +24,7 @@ namespace grfx {
 MeshCreateInfo::MeshCreateInfo(const ppx::Geometry& geometry)
 {
     this->indexType         = geometry.GetIndexType();
+    this->primitiveTopology = geometry.GetPrimitiveTopology();
     this->indexCount        = geometry.GetIndexCount();
     this->vertexCount       = geometry.GetVertexCount();
     this->vertexBufferCount = geometry.GetVertexBufferCount();
@@ -62,31 +63,54 @@ Result Mesh::CreateApiObjects(const grfx::MeshCreateInfo* pCreateInfo)
         return Result::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
     }
 
-    // Index buffer
-    if (pCreateInfo->indexCount > 0) {
+    // Index buffer, pIndexSource keeps ownership of a shared one
+    if (!IsNull(pCreateInfo->pIndexSource)) {
+        const grfx::Mesh* pSource = pCreateInfo->pIndexSource;
+        if ((pCreateInfo->indexType != pSource->GetIndexType()) || (pCreateInfo->indexCount != pSource->GetIndexCount())) {
+            return Result::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
+        }
+        mIndexBuffer = pSource->mIndexBuffer;
+        mIndexRange  = pSource->mIndexRange;
+    }
+    else if (pCreateInfo->indexCount > 0) {
         // Bail if index type doesn't make sense
         if ((pCreateInfo->indexType != grfx::INDEX_TYPE_UINT16) && (pCreateInfo->indexType != grfx::INDEX_TYPE_UINT32)) {
             return Result::ERROR_GRFX_INVALID_INDEX_TYPE;
         }
 
-        grfx::BufferCreateInfo createInfo      = {};
-        createInfo.size                        = pCreateInfo->indexCount * grfx::IndexTypeSize(pCreateInfo->indexType);
-        createInfo.usageFlags.bits.indexBuffer = true;
-        createInfo.usageFlags.bits.transferDst = true;
-        createInfo.memoryUsage                 = pCreateInfo->memoryUsage;
-        createInfo.initialState                = grfx::RESOURCE_STATE_GENERAL;
-        createInfo.ownership                   = grfx::OWNERSHIP_REFERENCE;
-
-        auto ppxres = GetDevice()->CreateBuffer(&createInfo, &mIndexBuffer);
-        if (Failed(ppxres)) {
-            PPX_ASSERT_MSG(false, "create mesh index buffer failed");
-            return ppxres;
+        const uint32_t indexSize = grfx::IndexTypeSize(pCreateInfo->indexType);
+
+        if (!IsNull(pCreateInfo->pBufferPool)) {
+            auto ppxres = pCreateInfo->pBufferPool->Allocate(pCreateInfo->indexCount * indexSize, indexSize, &mIndexRange);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "allocate mesh index buffer range failed");
+                return ppxres;
+            }
+            mIndexBuffer = mIndexRange.pBuffer;
+        }
+        else {
+            grfx::BufferCreateInfo createInfo                     = {};
+            createInfo.size                                       = pCreateInfo->indexCount * indexSize;
+            createInfo.usageFlags.bits.indexBuffer                = true;
+            createInfo.usageFlags.bits.transferDst                = true;
+            createInfo.usageFlags.bits.accelerationStructureInput = pCreateInfo->accelerationStructureInput;
+            createInfo.usageFlags.bits.rawStorageBuffer           = pCreateInfo->storageBuffers;
+            createInfo.memoryUsage                                = pCreateInfo->memoryUsage;
+            createInfo.initialState                               = grfx::RESOURCE_STATE_GENERAL;
+            createInfo.ownership                                  = grfx::OWNERSHIP_REFERENCE;
+
+            auto ppxres = GetDevice()->CreateBuffer(&createInfo, &mIndexBuffer);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "create mesh index buffer failed");
+                return ppxres;
+            }
         }
     }
 
     // Vertex buffers
     if (pCreateInfo->vertexCount > 0) {
         mVertexBuffers.resize(pCreateInfo->vertexBufferCount);
+        mVertexRanges.resize(pCreateInfo->vertexBufferCount);
 
         // Iterate through all the vertex buffer descriptions and create appropriately sized buffers
         for (uint32_t vbIdx = 0; vbIdx < pCreateInfo->vertexBufferCount; ++vbIdx) {
@@ -132,18 +156,32 @@ Result Mesh::CreateApiObjects(const grfx::MeshCreateInfo* pCreateInfo)
                 }
             }
 
-            grfx::BufferCreateInfo createInfo       = {};
-            createInfo.size                         = pCreateInfo->vertexCount * mVertexBuffers[vbIdx].second.stride;
-            createInfo.usageFlags.bits.vertexBuffer = true;
-            createInfo.usageFlags.bits.transferDst  = true;
-            createInfo.memoryUsage                  = pCreateInfo->memoryUsage;
-            createInfo.initialState                 = grfx::RESOURCE_STATE_GENERAL;
-            createInfo.ownership                    = grfx::OWNERSHIP_REFERENCE;
-
-            auto ppxres = GetDevice()->CreateBuffer(&createInfo, &mVertexBuffers[vbIdx].first);
-            if (Failed(ppxres)) {
-                PPX_ASSERT_MSG(false, "create mesh vertex buffer failed");
-                return ppxres;
+            if (!IsNull(pCreateInfo->pBufferPool)) {
+                // Aligning to the stride keeps GetBaseVertex() exact
+                const uint32_t stride = mVertexBuffers[vbIdx].second.stride;
+                auto           ppxres = pCreateInfo->pBufferPool->Allocate(pCreateInfo->vertexCount * stride, stride, &mVertexRanges[vbIdx]);
+                if (Failed(ppxres)) {
+                    PPX_ASSERT_MSG(false, "allocate mesh vertex buffer range failed");
+                    return ppxres;
+                }
+                mVertexBuffers[vbIdx].first = mVertexRanges[vbIdx].pBuffer;
+            }
+            else {
+                grfx::BufferCreateInfo createInfo                     = {};
+                createInfo.size                                       = pCreateInfo->vertexCount * mVertexBuffers[vbIdx].second.stride;
+                createInfo.usageFlags.bits.vertexBuffer               = true;
+                createInfo.usageFlags.bits.transferDst                = true;
+                createInfo.usageFlags.bits.accelerationStructureInput = pCreateInfo->accelerationStructureInput;
+                createInfo.usageFlags.bits.rawStorageBuffer           = pCreateInfo->storageBuffers;
+                createInfo.memoryUsage                                = pCreateInfo->memoryUsage;
+                createInfo.initialState                               = grfx::RESOURCE_STATE_GENERAL;
+                createInfo.ownership                                  = grfx::OWNERSHIP_REFERENCE;
+
+                auto ppxres = GetDevice()->CreateBuffer(&createInfo, &mVertexBuffers[vbIdx].first);
+                if (Failed(ppxres)) {
+                    PPX_ASSERT_MSG(false, "create mesh vertex buffer failed");
+                    return ppxres;
+                }
             }
         }
     }
@@ -198,14 +236,33 @@ Result Mesh::CreateApiObjects(const grfx::MeshCreateInfo* pCreateInfo)
 
 void Mesh::DestroyApiObjects()
 {
-    if (mIndexBuffer) {
-        GetDevice()->DestroyBuffer(mIndexBuffer);
-    }
+    // Pooled buffers belong to the pool, only the ranges are returned
+    grfx::BufferPool* pBufferPool = mCreateInfo.pBufferPool;
+
+    const bool ownsIndexBuffer = IsNull(mCreateInfo.pIndexSource);
 
-    for (auto& elem : mVertexBuffers) {
-        GetDevice()->DestroyBuffer(elem.first);
+    if (!IsNull(pBufferPool)) {
+        if (ownsIndexBuffer) {
+            pBufferPool->Free(mIndexRange);
+        }
+        for (auto& range : mVertexRanges) {
+            pBufferPool->Free(range);
+        }
+    }
+    else {
+        if (mIndexBuffer && ownsIndexBuffer) {
+            GetDevice()->DestroyBuffer(mIndexBuffer);
+        }
+        for (auto& elem : mVertexBuffers) {
+            if (elem.first) {
+                GetDevice()->DestroyBuffer(elem.first);
+            }
+        }
     }
+    mIndexBuffer.Reset();
+    mIndexRange = {};
     mVertexBuffers.clear();
+    mVertexRanges.clear();
 }
 
 grfx::BufferPtr Mesh::GetVertexBuffer(uint32_t index) const
@@ -217,6 +274,31 @@ grfx::BufferPtr Mesh::GetVertexBuffer(uint32_t index) const
     return mVertexBuffers[index].first;
 }
 
+uint64_t Mesh::GetVertexBufferOffset(uint32_t index) const
+{
+    if (index >= CountU32(mVertexRanges)) {
+        return 0;
+    }
+    return mVertexRanges[index].offset;
+}
+
+uint32_t Mesh::GetFirstIndex() const
+{
+    if (mCreateInfo.indexType == grfx::INDEX_TYPE_UNDEFINED) {
+        return 0;
+    }
+    return static_cast<uint32_t>(mIndexRange.offset / grfx::IndexTypeSize(mCreateInfo.indexType));
+}
+
+int32_t Mesh::GetBaseVertex() const
+{
+    PPX_ASSERT_MSG(mVertexBuffers.size() <= 1, "base vertex is ambiguous for meshes with multiple vertex buffers");
+    if (mVertexRanges.empty()) {
+        return 0;
+    }
+    return static_cast<int32_t>(mVertexRanges[0].offset / mVertexBuffers[0].second.stride);
+}
+
 const grfx::MeshVertexBufferDescription* Mesh::GetVertexBufferDescription(uint32_t index) const
 {
     const uint32_t vertexBufferCount = CountU32(mVertexBuffers);
@@ -226,5 +308,48 @@ const grfx::MeshVertexBufferDescription* Mesh::GetVertexBufferDescription(uint32
     return &mVertexBuffers[index].second;
 }
 
+Result Mesh::GetAccelerationStructureTriangles(grfx::AccelerationStructureTriangles* pTriangles) const
+{
+    PPX_ASSERT_NULL_ARG(pTriangles);
+
+    // Acceleration structures are built from triangle lists only
+    if (mCreateInfo.primitiveTopology != grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST) {
+        return ppx::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
+    }
+
+    // Find the position attribute, geometries without semantics keep it first
+    for (uint32_t vbIdx = 0; vbIdx < GetVertexBufferCount(); ++vbIdx) {
+        const grfx::MeshVertexBufferDescription& desc = mVertexBuffers[vbIdx].second;
+        for (uint32_t attrIdx = 0; attrIdx < desc.attributeCount; ++attrIdx) {
+            const grfx::MeshVertexAttribute& attr        = desc.attributes[attrIdx];
+            const bool                       isFirst     = (vbIdx == 0) && (attrIdx == 0);
+            const bool                       isPosition  = (attr.vertexSemantic == grfx::VERTEX_SEMANTIC_POSITION);
+            const bool                       isUndefined = (attr.vertexSemantic == grfx::VERTEX_SEMANTIC_UNDEFINED);
+            if (!isPosition && !(isUndefined && isFirst)) {
+                continue;
+            }
+            if (attr.format != grfx::FORMAT_R32G32B32_FLOAT) {
+                return ppx::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
+            }
+
+            *pTriangles               = {};
+            pTriangles->pVertexBuffer = mVertexBuffers[vbIdx].first.Get();
+            pTriangles->vertexOffset  = GetVertexBufferOffset(vbIdx) + attr.offset;
+            pTriangles->vertexStride  = desc.stride;
+            pTriangles->vertexCount   = mCreateInfo.vertexCount;
+            pTriangles->vertexFormat  = attr.format;
+            if (mIndexBuffer) {
+                pTriangles->pIndexBuffer = mIndexBuffer.Get();
+                pTriangles->indexOffset  = mIndexRange.offset;
+                pTriangles->indexType    = mCreateInfo.indexType;
+                pTriangles->indexCount   = mCreateInfo.indexCount;
+            }
+            return ppx::SUCCESS;
+        }
+    }
+
+    return ppx::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
+}
+
 } // namespace grfx
 } // namespace ppx
@@ -0,0 +1,437 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_mesh_generator.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_mesh.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in GenerateMesh.hlsl
+enum
+{
+    GENERATE_MESH_PARAMS_REGISTER       = 0,
+    GENERATE_MESH_TRANSLATIONS_REGISTER = 1,
+    GENERATE_MESH_INDICES_REGISTER      = 2,
+    GENERATE_MESH_VERTICES0_REGISTER    = 3,
+    GENERATE_MESH_VERTICES1_REGISTER    = 4,
+};
+
+// Attribute formats in GenerateMesh.hlsl
+enum
+{
+    GENERATE_MESH_FORMAT_NONE   = 0,
+    GENERATE_MESH_FORMAT_FLOAT  = 1,
+    GENERATE_MESH_FORMAT_HALF   = 2,
+    GENERATE_MESH_FORMAT_SNORM8 = 3,
+};
+
+// Attributes in GenerateMesh.hlsl, in vertex order
+enum
+{
+    GENERATE_MESH_ATTRIBUTE_POSITION = 0,
+    GENERATE_MESH_ATTRIBUTE_TEXCOORD = 1,
+    GENERATE_MESH_ATTRIBUTE_NORMAL   = 2,
+    GENERATE_MESH_ATTRIBUTE_TANGENT  = 3,
+    GENERATE_MESH_ATTRIBUTE_COUNT    = 4,
+};
+
+static const uint32_t kGenerateMeshGroupSize = 64;
+
+// Dispatches are limited to 65535 groups per dimension
+static const uint32_t kMaxGeneratedTriangleCount = 65535 * kGenerateMeshGroupSize;
+static const uint32_t kMaxGeneratedCopyCount     = 65535;
+
+// Must match GenerateMesh.hlsl
+struct GenerateMeshParams
+{
+    uint32_t shape;
+    uint32_t usegs;
+    uint32_t vsegs;
+    uint32_t vertexCount;
+    float    size[2];
+    uint32_t triangleCount;
+    uint32_t pad;
+    uint32_t formats[GENERATE_MESH_ATTRIBUTE_COUNT];
+    uint32_t componentCounts[GENERATE_MESH_ATTRIBUTE_COUNT];
+    uint32_t buffers[GENERATE_MESH_ATTRIBUTE_COUNT];
+    uint32_t offsets[GENERATE_MESH_ATTRIBUTE_COUNT];
+    uint32_t strides[2];
+};
+
+// Returns false for formats the shader doesn't write
+static bool GetShaderFormat(grfx::Format format, uint32_t* pShaderFormat, uint32_t* pComponentCount)
+{
+    // clang-format off
+    switch (format) {
+        default: return false;
+        case grfx::FORMAT_UNDEFINED          : *pShaderFormat = GENERATE_MESH_FORMAT_NONE;   *pComponentCount = 0; break;
+        case grfx::FORMAT_R32G32_FLOAT       : *pShaderFormat = GENERATE_MESH_FORMAT_FLOAT;  *pComponentCount = 2; break;
+        case grfx::FORMAT_R32G32B32_FLOAT    : *pShaderFormat = GENERATE_MESH_FORMAT_FLOAT;  *pComponentCount = 3; break;
+        case grfx::FORMAT_R32G32B32A32_FLOAT : *pShaderFormat = GENERATE_MESH_FORMAT_FLOAT;  *pComponentCount = 4; break;
+        case grfx::FORMAT_R16G16_FLOAT       : *pShaderFormat = GENERATE_MESH_FORMAT_HALF;   *pComponentCount = 2; break;
+        case grfx::FORMAT_R16G16B16A16_FLOAT : *pShaderFormat = GENERATE_MESH_FORMAT_HALF;   *pComponentCount = 4; break;
+        case grfx::FORMAT_R8G8B8A8_SNORM     : *pShaderFormat = GENERATE_MESH_FORMAT_SNORM8; *pComponentCount = 4; break;
+    }
+    // clang-format on
+    return true;
+}
+
+MeshGenerator::MeshGenerator()
+{
+}
+
+MeshGenerator::~MeshGenerator()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    if (mPipeline) {
+        mDevice->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+}
+
+Result MeshGenerator::Create(grfx::Device* pDevice, const grfx::MeshGeneratorCreateInfo& createInfo, grfx::MeshGenerator** ppGenerator)
+{
+    if (IsNull(pDevice) || IsNull(ppGenerator) || IsNull(createInfo.pShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxMeshCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::MeshGenerator* pGenerator = new grfx::MeshGenerator();
+    if (IsNull(pGenerator)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pGenerator->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pGenerator;
+        return ppxres;
+    }
+
+    *ppGenerator = pGenerator;
+
+    return ppx::SUCCESS;
+}
+
+Result MeshGenerator::Initialize(grfx::Device* pDevice, const grfx::MeshGeneratorCreateInfo& createInfo)
+{
+    mDevice       = pDevice;
+    mMaxMeshCount = createInfo.maxMeshCount;
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.structuredBuffer               = mMaxMeshCount;
+    poolCreateInfo.rawStorageBuffer               = 3 * mMaxMeshCount;
+
+    Result ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(GENERATE_MESH_TRANSLATIONS_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(GENERATE_MESH_INDICES_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(GENERATE_MESH_VERTICES0_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(GENERATE_MESH_VERTICES1_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(GenerateMeshParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = GENERATE_MESH_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {createInfo.pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+uint32_t MeshGenerator::GetVertexCount(const grfx::GeneratedMeshInfo& info)
+{
+    return (info.usegs + 1) * (info.vsegs + 1);
+}
+
+uint32_t MeshGenerator::GetTriangleCount(const grfx::GeneratedMeshInfo& info)
+{
+    return 2 * info.usegs * info.vsegs;
+}
+
+void MeshGenerator::DestroyJob(Job& job)
+{
+    if (job.set) {
+        mDevice->FreeDescriptorSet(job.set);
+        job.set.Reset();
+    }
+    if (job.translations) {
+        mDevice->DestroyBuffer(job.translations);
+        job.translations.Reset();
+    }
+}
+
+Result MeshGenerator::Record(grfx::CommandBuffer* pCmd, const grfx::GeneratedMeshInfo& info, grfx::Mesh** ppMesh)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(ppMesh);
+
+    if (CountU32(mJobs) >= mMaxMeshCount) {
+        PPX_ASSERT_MSG(false, "MeshGenerator: more meshes than MeshGeneratorCreateInfo::maxMeshCount, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    if ((info.usegs == 0) || (info.vsegs == 0) || (info.positionFormat == grfx::FORMAT_UNDEFINED)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    GenerateMeshParams params = {};
+
+    // Shader formats and the mesh's vertex layout
+    const grfx::Format formats[GENERATE_MESH_ATTRIBUTE_COUNT] = {info.positionFormat, info.texCoordFormat, info.normalFormat, info.tangentFormat};
+    // clang-format off
+    const grfx::VertexSemantic semantics[GENERATE_MESH_ATTRIBUTE_COUNT] = {
+        grfx::VERTEX_SEMANTIC_POSITION,
+        grfx::VERTEX_SEMANTIC_TEXCOORD,
+        grfx::VERTEX_SEMANTIC_NORMAL,
+        grfx::VERTEX_SEMANTIC_TANGENT,
+    };
+    // clang-format on
+
+    const uint32_t copyCount     = std::max<uint32_t>(CountU32(info.translations), 1);
+    const uint32_t vertexCount   = GetVertexCount(info);
+    const uint32_t triangleCount = GetTriangleCount(info);
+    if ((triangleCount > kMaxGeneratedTriangleCount) || (copyCount > kMaxGeneratedCopyCount)) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    grfx::MeshCreateInfo meshCreateInfo = {};
+    meshCreateInfo.indexType            = grfx::INDEX_TYPE_UINT32;
+    meshCreateInfo.indexCount           = 3 * triangleCount * copyCount;
+    meshCreateInfo.vertexCount          = vertexCount * copyCount;
+    meshCreateInfo.vertexBufferCount    = info.positionPlanar ? 2 : 1;
+    meshCreateInfo.memoryUsage          = grfx::MEMORY_USAGE_GPU_ONLY;
+    meshCreateInfo.storageBuffers       = true;
+
+    uint32_t attributeIndices[GENERATE_MESH_ATTRIBUTE_COUNT] = {};
+    uint64_t vertexSizes[2]                                  = {};
+    for (uint32_t attribute = 0; attribute < GENERATE_MESH_ATTRIBUTE_COUNT; ++attribute) {
+        if (!GetShaderFormat(formats[attribute], &params.formats[attribute], &params.componentCounts[attribute])) {
+            return ppx::ERROR_IMAGE_INVALID_FORMAT;
+        }
+        if (formats[attribute] == grfx::FORMAT_UNDEFINED) {
+            continue;
+        }
+
+        const uint32_t buffer     = (info.positionPlanar && (attribute != GENERATE_MESH_ATTRIBUTE_POSITION)) ? 1 : 0;
+        params.buffers[attribute] = buffer;
+        vertexSizes[buffer] += grfx::GetFormatDescription(formats[attribute])->bytesPerTexel;
+
+        grfx::MeshVertexBufferDescription& desc = meshCreateInfo.vertexBuffers[buffer];
+        grfx::MeshVertexAttribute&         attr = desc.attributes[desc.attributeCount];
+        attr.format                             = formats[attribute];
+        attr.vertexSemantic                     = semantics[attribute];
+        attributeIndices[attribute]             = desc.attributeCount++;
+    }
+    if (info.positionPlanar && (meshCreateInfo.vertexBuffers[1].attributeCount == 0)) {
+        return ppx::ERROR_GRFX_INVALID_VERTEX_ATTRIBUTE_COUNT;
+    }
+
+    // The shader addresses bytes with 32-bit integers
+    const uint64_t kMaxBufferSize = static_cast<uint64_t>(UINT32_MAX) + 1;
+    for (uint64_t vertexSize : vertexSizes) {
+        if ((vertexSize * meshCreateInfo.vertexCount) > kMaxBufferSize) {
+            return ppx::ERROR_LIMIT_EXCEEDED;
+        }
+    }
+    if ((sizeof(uint32_t) * static_cast<uint64_t>(meshCreateInfo.indexCount)) > kMaxBufferSize) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    grfx::MeshPtr mesh;
+    Result        ppxres = mDevice->CreateMesh(&meshCreateInfo, &mesh);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Offsets and strides are known once the mesh is created
+    for (uint32_t attribute = 0; attribute < GENERATE_MESH_ATTRIBUTE_COUNT; ++attribute) {
+        if (formats[attribute] != grfx::FORMAT_UNDEFINED) {
+            const grfx::MeshVertexBufferDescription* pDesc = mesh->GetVertexBufferDescription(params.buffers[attribute]);
+            params.offsets[attribute]                      = pDesc->attributes[attributeIndices[attribute]].offset;
+        }
+    }
+    for (uint32_t buffer = 0; buffer < mesh->GetVertexBufferCount(); ++buffer) {
+        params.strides[buffer] = mesh->GetVertexBufferDescription(buffer)->stride;
+    }
+
+    Job job = {};
+
+    // One float4 per copy
+    grfx::BufferCreateInfo bufferCreateInfo             = {};
+    bufferCreateInfo.size                               = copyCount * sizeof(float4);
+    bufferCreateInfo.structuredElementStride            = sizeof(float4);
+    bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+    bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+    ppxres = mDevice->CreateBuffer(&bufferCreateInfo, &job.translations);
+    if (Failed(ppxres)) {
+        mDevice->DestroyMesh(mesh);
+        return ppxres;
+    }
+
+    void* pAddress = nullptr;
+    ppxres         = job.translations->MapMemory(0, &pAddress);
+    if (Failed(ppxres)) {
+        DestroyJob(job);
+        mDevice->DestroyMesh(mesh);
+        return ppxres;
+    }
+    float4* pTranslations = static_cast<float4*>(pAddress);
+    for (uint32_t copy = 0; copy < copyCount; ++copy) {
+        pTranslations[copy] = info.translations.empty() ? float4(0) : float4(info.translations[copy], 0);
+    }
+    job.translations->UnmapMemory();
+
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &job.set);
+    if (Failed(ppxres)) {
+        DestroyJob(job);
+        mDevice->DestroyMesh(mesh);
+        return ppxres;
+    }
+
+    // Interleaved meshes bind their only vertex buffer twice
+    grfx::Buffer* pVertices0 = mesh->GetVertexBuffer(0);
+    grfx::Buffer* pVertices1 = info.positionPlanar ? mesh->GetVertexBuffer(1).Get() : pVertices0;
+
+    std::array<grfx::WriteDescriptor, 4> writes = {};
+    writes[0].binding                           = GENERATE_MESH_TRANSLATIONS_REGISTER;
+    writes[0].type                              = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+    writes[0].bufferOffset                      = 0;
+    writes[0].bufferRange                       = PPX_WHOLE_SIZE;
+    writes[0].structuredElementCount            = copyCount;
+    writes[0].pBuffer                           = job.translations;
+
+    writes[1].binding      = GENERATE_MESH_INDICES_REGISTER;
+    writes[1].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+    writes[1].bufferOffset = 0;
+    writes[1].bufferRange  = PPX_WHOLE_SIZE;
+    writes[1].pBuffer      = mesh->GetIndexBuffer();
+
+    writes[2].binding      = GENERATE_MESH_VERTICES0_REGISTER;
+    writes[2].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+    writes[2].bufferOffset = 0;
+    writes[2].bufferRange  = PPX_WHOLE_SIZE;
+    writes[2].pBuffer      = pVertices0;
+
+    writes[3].binding      = GENERATE_MESH_VERTICES1_REGISTER;
+    writes[3].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+    writes[3].bufferOffset = 0;
+    writes[3].bufferRange  = PPX_WHOLE_SIZE;
+    writes[3].pBuffer      = pVertices1;
+
+    ppxres = job.set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        DestroyJob(job);
+        mDevice->DestroyMesh(mesh);
+        return ppxres;
+    }
+
+    params.shape         = static_cast<uint32_t>(info.shape);
+    params.usegs         = info.usegs;
+    params.vsegs         = info.vsegs;
+    params.vertexCount   = vertexCount;
+    params.size[0]       = info.size.x;
+    params.size[1]       = info.size.y;
+    params.triangleCount = triangleCount;
+
+    pCmd->TransitionBufferState(mesh->GetIndexBuffer(), grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    for (uint32_t buffer = 0; buffer < mesh->GetVertexBufferCount(); ++buffer) {
+        pCmd->TransitionBufferState(mesh->GetVertexBuffer(buffer), grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    }
+    pCmd->FlushBarriers();
+
+    const grfx::DescriptorSet* pSet = job.set.Get();
+    pCmd->BindComputePipeline(mPipeline);
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+    // Threads past a copy's vertex or triangle count only write the other
+    const uint32_t threadCount = std::max(vertexCount, triangleCount);
+    pCmd->Dispatch((threadCount + kGenerateMeshGroupSize - 1) / kGenerateMeshGroupSize, copyCount, 1);
+
+    pCmd->TransitionBufferState(mesh->GetIndexBuffer(), grfx::RESOURCE_STATE_INDEX_BUFFER);
+    for (uint32_t buffer = 0; buffer < mesh->GetVertexBufferCount(); ++buffer) {
+        pCmd->TransitionBufferState(mesh->GetVertexBuffer(buffer), grfx::RESOURCE_STATE_VERTEX_BUFFER);
+    }
+    pCmd->FlushBarriers();
+
+    mJobs.push_back(job);
+    *ppMesh = mesh;
+
+    return ppx::SUCCESS;
+}
+
+void MeshGenerator::Reset()
+{
+    for (auto& job : mJobs) {
+        DestroyJob(job);
+    }
+    mJobs.clear();
+}
+
+} // namespace grfx
+} // namespace ppx
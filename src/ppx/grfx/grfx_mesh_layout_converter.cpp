@@ -0,0 +1,334 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_mesh_layout_converter.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in ConvertVertexLayout.hlsl
+enum
+{
+    CONVERT_VERTEX_LAYOUT_PARAMS_REGISTER = 0,
+    CONVERT_VERTEX_LAYOUT_SRC0_REGISTER   = 1,
+    CONVERT_VERTEX_LAYOUT_SRC1_REGISTER   = 2,
+    CONVERT_VERTEX_LAYOUT_DST0_REGISTER   = 3,
+    CONVERT_VERTEX_LAYOUT_DST1_REGISTER   = 4,
+};
+
+static const uint32_t kConvertVertexLayoutGroupSize     = 64;
+static const uint32_t kConvertVertexLayoutMaxAttributes = 4;
+static const uint32_t kConvertVertexLayoutMaxBuffers    = 2;
+
+// Dispatches are limited to 65535 groups per dimension
+static const uint32_t kConvertVertexLayoutRowSize = 65535 * kConvertVertexLayoutGroupSize;
+
+// Must match ConvertVertexLayout.hlsl
+struct ConvertVertexLayoutParams
+{
+    uint32_t vertexCount;
+    uint32_t attributeCount;
+    uint32_t rowSize;
+    uint32_t pad;
+    uint32_t sizes[kConvertVertexLayoutMaxAttributes];
+    uint32_t srcBuffers[kConvertVertexLayoutMaxAttributes];
+    uint32_t srcOffsets[kConvertVertexLayoutMaxAttributes];
+    uint32_t dstBuffers[kConvertVertexLayoutMaxAttributes];
+    uint32_t dstOffsets[kConvertVertexLayoutMaxAttributes];
+    uint32_t srcStrides[kConvertVertexLayoutMaxBuffers];
+    uint32_t dstStrides[kConvertVertexLayoutMaxBuffers];
+};
+
+MeshLayoutConverter::MeshLayoutConverter()
+{
+}
+
+MeshLayoutConverter::~MeshLayoutConverter()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    if (mPipeline) {
+        mDevice->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+}
+
+Result MeshLayoutConverter::Create(grfx::Device* pDevice, const grfx::MeshLayoutConverterCreateInfo& createInfo, grfx::MeshLayoutConverter** ppConverter)
+{
+    if (IsNull(pDevice) || IsNull(ppConverter) || IsNull(createInfo.pShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxMeshCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::MeshLayoutConverter* pConverter = new grfx::MeshLayoutConverter();
+    if (IsNull(pConverter)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pConverter->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pConverter;
+        return ppxres;
+    }
+
+    *ppConverter = pConverter;
+
+    return ppx::SUCCESS;
+}
+
+Result MeshLayoutConverter::Initialize(grfx::Device* pDevice, const grfx::MeshLayoutConverterCreateInfo& createInfo)
+{
+    mDevice       = pDevice;
+    mMaxMeshCount = createInfo.maxMeshCount;
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.rawStorageBuffer               = 4 * mMaxMeshCount;
+
+    Result ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CONVERT_VERTEX_LAYOUT_SRC0_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CONVERT_VERTEX_LAYOUT_SRC1_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CONVERT_VERTEX_LAYOUT_DST0_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CONVERT_VERTEX_LAYOUT_DST1_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(ConvertVertexLayoutParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = CONVERT_VERTEX_LAYOUT_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {createInfo.pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result MeshLayoutConverter::Record(grfx::CommandBuffer* pCmd, const grfx::Mesh* pSrcMesh, const grfx::MeshLayoutInfo& info, grfx::Mesh** ppMesh)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pSrcMesh);
+    PPX_ASSERT_NULL_ARG(ppMesh);
+
+    if (CountU32(mSets) >= mMaxMeshCount) {
+        PPX_ASSERT_MSG(false, "MeshLayoutConverter: more meshes than MeshLayoutConverterCreateInfo::maxMeshCount, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    const uint32_t srcBufferCount = pSrcMesh->GetVertexBufferCount();
+    if ((srcBufferCount == 0) || (info.vertexBufferCount == 0)) {
+        return ppx::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
+    }
+    if ((srcBufferCount > kConvertVertexLayoutMaxBuffers) || (info.vertexBufferCount > kConvertVertexLayoutMaxBuffers)) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    if (!pSrcMesh->HasStorageBuffers()) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::MeshCreateInfo meshCreateInfo = {};
+    meshCreateInfo.indexType            = pSrcMesh->GetIndexType();
+    meshCreateInfo.indexCount           = pSrcMesh->GetIndexCount();
+    meshCreateInfo.vertexCount          = pSrcMesh->GetVertexCount();
+    meshCreateInfo.vertexBufferCount    = info.vertexBufferCount;
+    meshCreateInfo.memoryUsage          = grfx::MEMORY_USAGE_GPU_ONLY;
+    meshCreateInfo.storageBuffers       = true;
+    meshCreateInfo.pIndexSource         = pSrcMesh;
+    for (uint32_t buffer = 0; buffer < info.vertexBufferCount; ++buffer) {
+        meshCreateInfo.vertexBuffers[buffer] = info.vertexBuffers[buffer];
+    }
+
+    // The shader addresses bytes with 32-bit integers
+    const uint64_t kMaxBufferSize = static_cast<uint64_t>(UINT32_MAX) + 1;
+    for (uint32_t buffer = 0; buffer < srcBufferCount; ++buffer) {
+        if ((static_cast<uint64_t>(pSrcMesh->GetVertexBufferDescription(buffer)->stride) * meshCreateInfo.vertexCount) > kMaxBufferSize) {
+            return ppx::ERROR_LIMIT_EXCEEDED;
+        }
+    }
+
+    grfx::MeshPtr mesh;
+    Result        ppxres = mDevice->CreateMesh(&meshCreateInfo, &mesh);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Match every destination attribute with the source attribute of the
+    // same semantic, offsets and strides are known once the mesh is created
+    ConvertVertexLayoutParams params = {};
+    for (uint32_t dstBuffer = 0; dstBuffer < mesh->GetVertexBufferCount(); ++dstBuffer) {
+        const grfx::MeshVertexBufferDescription* pDstDesc = mesh->GetVertexBufferDescription(dstBuffer);
+        params.dstStrides[dstBuffer]                      = pDstDesc->stride;
+        if ((static_cast<uint64_t>(pDstDesc->stride) * meshCreateInfo.vertexCount) > kMaxBufferSize) {
+            mDevice->DestroyMesh(mesh);
+            return ppx::ERROR_LIMIT_EXCEEDED;
+        }
+
+        for (uint32_t dstAttr = 0; dstAttr < pDstDesc->attributeCount; ++dstAttr) {
+            const grfx::MeshVertexAttribute& dst = pDstDesc->attributes[dstAttr];
+
+            if (params.attributeCount >= kConvertVertexLayoutMaxAttributes) {
+                mDevice->DestroyMesh(mesh);
+                return ppx::ERROR_LIMIT_EXCEEDED;
+            }
+
+            bool found = false;
+            for (uint32_t srcBuffer = 0; (srcBuffer < srcBufferCount) && !found; ++srcBuffer) {
+                const grfx::MeshVertexBufferDescription* pSrcDesc = pSrcMesh->GetVertexBufferDescription(srcBuffer);
+                for (uint32_t srcAttr = 0; (srcAttr < pSrcDesc->attributeCount) && !found; ++srcAttr) {
+                    const grfx::MeshVertexAttribute& src = pSrcDesc->attributes[srcAttr];
+                    if ((src.vertexSemantic != dst.vertexSemantic) || (src.format != dst.format)) {
+                        continue;
+                    }
+
+                    const uint32_t size = grfx::GetFormatDescription(src.format)->bytesPerTexel;
+                    if ((size % sizeof(uint32_t)) != 0) {
+                        mDevice->DestroyMesh(mesh);
+                        return ppx::ERROR_GRFX_INVALID_VERTEX_ATTRIBUTE_STRIDE;
+                    }
+
+                    const uint32_t index         = params.attributeCount++;
+                    params.sizes[index]          = size / sizeof(uint32_t);
+                    params.srcBuffers[index]     = srcBuffer;
+                    params.srcOffsets[index]     = src.offset;
+                    params.dstBuffers[index]     = dstBuffer;
+                    params.dstOffsets[index]     = dst.offset;
+                    params.srcStrides[srcBuffer] = pSrcDesc->stride;
+                    found                        = true;
+                }
+            }
+            if (!found) {
+                mDevice->DestroyMesh(mesh);
+                return ppx::ERROR_GRFX_INVALID_GEOMETRY_CONFIGURATION;
+            }
+        }
+    }
+
+    grfx::DescriptorSetPtr set;
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+    if (Failed(ppxres)) {
+        mDevice->DestroyMesh(mesh);
+        return ppxres;
+    }
+
+    // Single vertex buffers are bound twice
+    grfx::Buffer* buffers[4] = {
+        pSrcMesh->GetVertexBuffer(0).Get(),
+        pSrcMesh->GetVertexBuffer(srcBufferCount - 1).Get(),
+        mesh->GetVertexBuffer(0).Get(),
+        mesh->GetVertexBuffer(mesh->GetVertexBufferCount() - 1).Get(),
+    };
+
+    std::array<grfx::WriteDescriptor, 4> writes = {};
+    for (uint32_t i = 0; i < CountU32(writes); ++i) {
+        writes[i].binding      = CONVERT_VERTEX_LAYOUT_SRC0_REGISTER + i;
+        writes[i].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+        writes[i].bufferOffset = 0;
+        writes[i].bufferRange  = PPX_WHOLE_SIZE;
+        writes[i].pBuffer      = buffers[i];
+    }
+
+    ppxres = set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        mDevice->FreeDescriptorSet(set);
+        mDevice->DestroyMesh(mesh);
+        return ppxres;
+    }
+
+    params.vertexCount = meshCreateInfo.vertexCount;
+    params.rowSize     = kConvertVertexLayoutRowSize;
+
+    for (grfx::Buffer* pBuffer : buffers) {
+        pCmd->TransitionBufferState(pBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    }
+    pCmd->FlushBarriers();
+
+    const grfx::DescriptorSet* pSet = set.Get();
+    pCmd->BindComputePipeline(mPipeline);
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+    const uint32_t groupCount = (params.vertexCount + kConvertVertexLayoutGroupSize - 1) / kConvertVertexLayoutGroupSize;
+    const uint32_t rowCount   = (params.vertexCount + kConvertVertexLayoutRowSize - 1) / kConvertVertexLayoutRowSize;
+    pCmd->Dispatch(std::min<uint32_t>(groupCount, 65535), rowCount, 1);
+
+    for (grfx::Buffer* pBuffer : buffers) {
+        pCmd->TransitionBufferState(pBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER);
+    }
+    pCmd->FlushBarriers();
+
+    mSets.push_back(set);
+    *ppMesh = mesh;
+
+    return ppx::SUCCESS;
+}
+
+void MeshLayoutConverter::Reset()
+{
+    for (auto& set : mSets) {
+        mDevice->FreeDescriptorSet(set);
+    }
+    mSets.clear();
+}
+
+} // namespace grfx
+} // namespace ppx
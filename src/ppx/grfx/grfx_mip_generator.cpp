@@ -0,0 +1,320 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_mip_generator.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_format.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in GenerateMips.hlsl
+enum
+{
+    GENERATE_MIPS_PARAMS_REGISTER = 0,
+    GENERATE_MIPS_SRC_REGISTER    = 1,
+    GENERATE_MIPS_DST_REGISTER    = 2, // First of kLevelsPerDispatch
+};
+
+static const uint32_t kGenerateMipsGroupSize = 8;
+
+// Must match GenerateMips.hlsl
+struct GenerateMipsParams
+{
+    uint32_t srcSize[2];
+    uint32_t levelCount;
+    uint32_t srgb;
+};
+
+MipGenerator::MipGenerator()
+{
+}
+
+MipGenerator::~MipGenerator()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    if (mPipeline) {
+        mDevice->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+}
+
+Result MipGenerator::Create(grfx::Device* pDevice, const grfx::MipGeneratorCreateInfo& createInfo, grfx::MipGenerator** ppGenerator)
+{
+    if (IsNull(pDevice) || IsNull(ppGenerator) || IsNull(createInfo.pShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxDispatchCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::MipGenerator* pGenerator = new grfx::MipGenerator();
+    if (IsNull(pGenerator)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pGenerator->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pGenerator;
+        return ppxres;
+    }
+
+    *ppGenerator = pGenerator;
+
+    return ppx::SUCCESS;
+}
+
+Result MipGenerator::Initialize(grfx::Device* pDevice, const grfx::MipGeneratorCreateInfo& createInfo)
+{
+    mDevice           = pDevice;
+    mMaxDispatchCount = createInfo.maxDispatchCount;
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sampledImage                   = mMaxDispatchCount;
+    poolCreateInfo.storageImage                   = mMaxDispatchCount * kLevelsPerDispatch;
+
+    Result ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(GENERATE_MIPS_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+    for (uint32_t i = 0; i < kLevelsPerDispatch; ++i) {
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(GENERATE_MIPS_DST_REGISTER + i, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+    }
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(GenerateMipsParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = GENERATE_MIPS_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {createInfo.pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+bool MipGenerator::IsSupported(const grfx::Image* pImage)
+{
+    if (IsNull(pImage)) {
+        return false;
+    }
+
+    const grfx::ImageUsageFlags& usage = pImage->GetUsageFlags();
+    if (!usage.bits.storage || !usage.bits.sampled) {
+        return false;
+    }
+    if ((pImage->GetType() != grfx::IMAGE_TYPE_2D) && (pImage->GetType() != grfx::IMAGE_TYPE_CUBE)) {
+        return false;
+    }
+    if (pImage->GetSampleCount() != grfx::SAMPLE_COUNT_1) {
+        return false;
+    }
+
+    const grfx::FormatDesc* pDesc = grfx::GetFormatDescription(pImage->GetFormat());
+    if (IsNull(pDesc) || (pDesc->aspect != grfx::FORMAT_ASPECT_COLOR) || (pDesc->layout == grfx::FORMAT_LAYOUT_COMPRESSED)) {
+        return false;
+    }
+    // Shaders write float4, which excludes integer and sRGB formats
+    return (pDesc->dataType == grfx::FORMAT_DATA_TYPE_UNORM) || (pDesc->dataType == grfx::FORMAT_DATA_TYPE_SNORM) || (pDesc->dataType == grfx::FORMAT_DATA_TYPE_FLOAT);
+}
+
+Result MipGenerator::AddDispatch(grfx::Image* pImage, uint32_t srcLevel, uint32_t levelCount)
+{
+    DispatchResources dispatch = {};
+
+    // The shader treats every image as a 2D array
+    grfx::ImageViewRange range = grfx::ImageViewRange::MipLevel(srcLevel);
+    range.imageViewType        = grfx::IMAGE_VIEW_TYPE_2D_ARRAY;
+
+    grfx::SampledImageViewPtr srcView;
+    Result                    ppxres = pImage->GetSampledImageView(range, &srcView);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    std::array<grfx::StorageImageViewPtr, kLevelsPerDispatch> dstViews = {};
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        range.mipLevel = srcLevel + 1 + i;
+        ppxres         = pImage->GetStorageImageView(range, &dstViews[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &dispatch.set);
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    // Unused destinations of the last dispatch alias its last level, the
+    // shader returns before writing them
+    std::array<grfx::WriteDescriptor, 1 + kLevelsPerDispatch> writes = {};
+    writes[0].binding                                                = GENERATE_MIPS_SRC_REGISTER;
+    writes[0].type                                                   = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageView                                             = srcView;
+    for (uint32_t i = 0; i < kLevelsPerDispatch; ++i) {
+        writes[1 + i].binding    = GENERATE_MIPS_DST_REGISTER + i;
+        writes[1 + i].type       = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1 + i].pImageView = dstViews[std::min(i, levelCount - 1)];
+    }
+
+    ppxres = dispatch.set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        DestroyDispatch(dispatch);
+        return ppxres;
+    }
+
+    mDispatches.push_back(dispatch);
+
+    return ppx::SUCCESS;
+}
+
+void MipGenerator::DestroyDispatch(DispatchResources& dispatch)
+{
+    if (dispatch.set) {
+        mDevice->FreeDescriptorSet(dispatch.set);
+        dispatch.set.Reset();
+    }
+}
+
+Result MipGenerator::Record(
+    grfx::CommandBuffer* pCmd,
+    grfx::Image*         pImage,
+    grfx::ResourceState  level0State,
+    grfx::ResourceState  stateAfter,
+    bool                 srgb)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pImage);
+
+    if (!IsSupported(pImage)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const uint32_t levelCount    = pImage->GetMipLevelCount();
+    const uint32_t layerCount    = pImage->GetArrayLayerCount();
+    const uint32_t dispatchCount = (levelCount + kLevelsPerDispatch - 2) / kLevelsPerDispatch;
+    if ((GetDispatchCount() + dispatchCount) > mMaxDispatchCount) {
+        PPX_ASSERT_MSG(false, "MipGenerator: more dispatches than MipGeneratorCreateInfo::maxDispatchCount, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    const uint32_t firstDispatch = GetDispatchCount();
+    for (uint32_t i = 0; i < dispatchCount; ++i) {
+        const uint32_t srcLevel = i * kLevelsPerDispatch;
+        Result         ppxres   = AddDispatch(pImage, srcLevel, std::min(kLevelsPerDispatch, levelCount - 1 - srcLevel));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Tracked transitions handle the mix of states the levels end up in;
+    // the levels being generated don't need their contents
+    pCmd->FlushBarriers();
+    pImage->SetTrackedState(level0State, 0, 1);
+    pImage->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED, 1);
+
+    pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0, 1);
+    if (levelCount > 1) {
+        pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_UNORDERED_ACCESS, 1);
+        pCmd->BindComputePipeline(mPipeline);
+    }
+
+    for (uint32_t i = 0; i < dispatchCount; ++i) {
+        const uint32_t srcLevel  = i * kLevelsPerDispatch;
+        const uint32_t srcWidth  = std::max<uint32_t>(pImage->GetWidth() >> srcLevel, 1);
+        const uint32_t srcHeight = std::max<uint32_t>(pImage->GetHeight() >> srcLevel, 1);
+        const uint32_t dstWidth  = std::max<uint32_t>(srcWidth / 2, 1);
+        const uint32_t dstHeight = std::max<uint32_t>(srcHeight / 2, 1);
+
+        // The last level of the previous dispatch is this one's source
+        pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, srcLevel, 1);
+
+        const grfx::DescriptorSet* pSet = mDispatches[firstDispatch + i].set.Get();
+        pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+
+        GenerateMipsParams params = {};
+        params.srcSize[0]         = srcWidth;
+        params.srcSize[1]         = srcHeight;
+        params.levelCount         = std::min(kLevelsPerDispatch, levelCount - 1 - srcLevel);
+        params.srgb               = srgb ? 1 : 0;
+        pCmd->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+        pCmd->Dispatch((dstWidth + kGenerateMipsGroupSize - 1) / kGenerateMipsGroupSize, (dstHeight + kGenerateMipsGroupSize - 1) / kGenerateMipsGroupSize, layerCount);
+    }
+
+    pCmd->TransitionImageState(pImage, stateAfter);
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+void MipGenerator::Reset()
+{
+    for (auto& dispatch : mDispatches) {
+        DestroyDispatch(dispatch);
+    }
+    mDispatches.clear();
+}
+
+} // namespace grfx
+} // namespace ppx
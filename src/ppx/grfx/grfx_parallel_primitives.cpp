@@ -0,0 +1,546 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/grfx/grfx_parallel_primitives.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_gpu.h"
+#include "ppx/grfx/grfx_pipeline.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in ParallelPrimitives.hlsl
+enum
+{
+    PRIMITIVES_PARAMS_REGISTER        = 0,
+    PRIMITIVES_INPUT_KEYS_REGISTER    = 1,
+    PRIMITIVES_OUTPUT_KEYS_REGISTER   = 2,
+    PRIMITIVES_INPUT_VALUES_REGISTER  = 3,
+    PRIMITIVES_OUTPUT_VALUES_REGISTER = 4,
+    PRIMITIVES_SCRATCH_REGISTER       = 5,
+    PRIMITIVES_COUNT_REGISTER         = 6,
+};
+
+// Must match ParallelPrimitives.hlsl
+enum
+{
+    PRIMITIVES_FLAG_INPUT_VALUES   = 0x1,
+    PRIMITIVES_FLAG_INPUT_SCRATCH  = 0x2,
+    PRIMITIVES_FLAG_OUTPUT_SCRATCH = 0x4,
+    PRIMITIVES_FLAG_ADD_PARTIALS   = 0x8,
+    PRIMITIVES_FLAG_VALUES         = 0x10,
+};
+
+// Must match ParallelPrimitives.hlsl
+struct ParallelPrimitivesParams
+{
+    uint32_t count;
+    uint32_t inputOffset;
+    uint32_t outputOffset;
+    uint32_t scratchOffset;
+    uint32_t tileCount;
+    uint32_t shift;
+    uint32_t flags;
+    uint32_t padding;
+};
+
+// Threads per group of every kernel, the compaction scatters one element
+// per thread and the others a tile
+static const uint32_t kGroupSize  = 256;
+static const uint32_t kRadixSize  = 1u << ParallelPrimitives::kRadixBits;
+static const uint32_t kMaxGroups  = 65535;
+static const uint32_t kUintStride = sizeof(uint32_t);
+
+static uint32_t DivideRoundUp(uint32_t value, uint32_t divisor)
+{
+    return (value + divisor - 1) / divisor;
+}
+
+ParallelPrimitives::ParallelPrimitives()
+{
+}
+
+ParallelPrimitives::~ParallelPrimitives()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    Reset();
+
+    for (grfx::ComputePipelinePtr& pipeline : mPipelines) {
+        if (pipeline) {
+            mDevice->DestroyComputePipeline(pipeline);
+            pipeline.Reset();
+        }
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mScratchBuffer) {
+        mDevice->DestroyBuffer(mScratchBuffer);
+        mScratchBuffer.Reset();
+    }
+}
+
+static bool HasAllShaders(const grfx::ParallelPrimitivesShaders& shaders)
+{
+    return !IsNull(shaders.pScanReduce) && !IsNull(shaders.pScanDownsweep) && !IsNull(shaders.pCompactScatter) && !IsNull(shaders.pRadixHistogram) && !IsNull(shaders.pRadixScatter);
+}
+
+Result ParallelPrimitives::Create(grfx::Device* pDevice, const grfx::ParallelPrimitivesCreateInfo& createInfo, grfx::ParallelPrimitives** ppPrimitives)
+{
+    if (IsNull(pDevice) || IsNull(ppPrimitives) || !HasAllShaders(createInfo.shaders)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.maxElementCount == 0) || (createInfo.maxBufferSets == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (DivideRoundUp(createInfo.maxElementCount, kTileSize) > kMaxGroups) {
+        PPX_ASSERT_MSG(false, "ParallelPrimitives: maxElementCount exceeds " << (kMaxGroups * kTileSize));
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    grfx::ParallelPrimitives* pPrimitives = new grfx::ParallelPrimitives();
+    if (IsNull(pPrimitives)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pPrimitives->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pPrimitives;
+        return ppxres;
+    }
+
+    *ppPrimitives = pPrimitives;
+
+    return ppx::SUCCESS;
+}
+
+bool ParallelPrimitives::SupportsSubgroupOps(const grfx::Device* pDevice)
+{
+    if (IsNull(pDevice) || IsNull(pDevice->GetGpu())) {
+        return false;
+    }
+
+    // The group's subgroup totals are scanned by its first subgroup, and
+    // ranks are counted with 128 lane ballots
+    const grfx::SubgroupCapabilities& subgroup = pDevice->GetGpu()->GetShaderCapabilities().subgroup;
+    return subgroup.basic && subgroup.arithmetic && subgroup.ballot && (subgroup.size >= kMinSubgroupSize) && (std::max(subgroup.size, subgroup.maxSize) <= 128);
+}
+
+Result ParallelPrimitives::Initialize(grfx::Device* pDevice, const grfx::ParallelPrimitivesCreateInfo& createInfo)
+{
+    mDevice          = pDevice;
+    mMaxElementCount = createInfo.maxElementCount;
+    mMaxBufferSets   = createInfo.maxBufferSets;
+    mUsesSubgroupOps = HasAllShaders(createInfo.subgroupShaders) && SupportsSubgroupOps(pDevice);
+
+    // Scanned flags and digit counts go first, then the tile sums of every
+    // level of the largest scan, which is the larger of the two
+    const uint32_t scanCount = std::max(mMaxElementCount, kRadixSize * DivideRoundUp(mMaxElementCount, kTileSize));
+    uint32_t       partials  = 0;
+    for (uint32_t levelCount = scanCount; levelCount > kTileSize;) {
+        levelCount = DivideRoundUp(levelCount, kTileSize);
+        partials += levelCount;
+    }
+    mPartialsOffset = scanCount;
+
+    grfx::BufferCreateInfo bufferCreateInfo             = {};
+    bufferCreateInfo.size                               = static_cast<uint64_t>(scanCount + std::max<uint32_t>(partials, 1)) * kUintStride;
+    bufferCreateInfo.structuredElementStride            = kUintStride;
+    bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+    bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+    bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_UNORDERED_ACCESS;
+
+    Result ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mScratchBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.structuredBuffer               = 6 * mMaxBufferSets;
+
+    ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PRIMITIVES_INPUT_KEYS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PRIMITIVES_OUTPUT_KEYS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PRIMITIVES_INPUT_VALUES_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PRIMITIVES_OUTPUT_VALUES_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PRIMITIVES_SCRATCH_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(PRIMITIVES_COUNT_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(ParallelPrimitivesParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = PRIMITIVES_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Only the scans and the scatter have subgroup variants, the histogram
+    // and compaction shaders of both sets are the same
+    const grfx::ParallelPrimitivesShaders& shaders = mUsesSubgroupOps ? createInfo.subgroupShaders : createInfo.shaders;
+
+    grfx::ShaderModule* kernelShaders[KERNEL_COUNT] = {};
+    kernelShaders[KERNEL_SCAN_REDUCE]               = shaders.pScanReduce;
+    kernelShaders[KERNEL_SCAN_DOWNSWEEP]            = shaders.pScanDownsweep;
+    kernelShaders[KERNEL_COMPACT_SCATTER]           = shaders.pCompactScatter;
+    kernelShaders[KERNEL_RADIX_HISTOGRAM]           = shaders.pRadixHistogram;
+    kernelShaders[KERNEL_RADIX_SCATTER]             = shaders.pRadixScatter;
+
+    for (uint32_t kernel = 0; kernel < KERNEL_COUNT; ++kernel) {
+        grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+        cpCreateInfo.CS                              = {kernelShaders[kernel], "csmain"};
+        cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+        ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipelines[kernel]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void ParallelPrimitives::Reset()
+{
+    for (auto& it : mBufferSets) {
+        mDevice->FreeDescriptorSet(it.second);
+    }
+    mBufferSets.clear();
+}
+
+Result ParallelPrimitives::GetBufferSet(const BufferSetKey& key, const grfx::DescriptorSet** ppSet)
+{
+    auto it = mBufferSets.find(key);
+    if (it != mBufferSets.end()) {
+        *ppSet = it->second;
+        return ppx::SUCCESS;
+    }
+
+    if (CountU32(mBufferSets) >= mMaxBufferSets) {
+        PPX_ASSERT_MSG(false, "ParallelPrimitives: more buffer combinations than ParallelPrimitivesCreateInfo::maxBufferSets, call Reset() after the work completed");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    grfx::DescriptorSetPtr set;
+    Result                 ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t bindings[] = {
+        PRIMITIVES_INPUT_KEYS_REGISTER,
+        PRIMITIVES_OUTPUT_KEYS_REGISTER,
+        PRIMITIVES_INPUT_VALUES_REGISTER,
+        PRIMITIVES_OUTPUT_VALUES_REGISTER,
+        PRIMITIVES_COUNT_REGISTER,
+    };
+    static_assert(std::size(bindings) == std::tuple_size<BufferSetKey>::value, "one binding per key buffer");
+
+    std::array<grfx::WriteDescriptor, std::size(bindings) + 1> writes = {};
+    for (size_t i = 0; i < writes.size(); ++i) {
+        const grfx::Buffer* pBuffer = (i < key.size()) ? key[i] : nullptr;
+        if (IsNull(pBuffer)) {
+            pBuffer = mScratchBuffer;
+        }
+
+        writes[i].binding                = (i < key.size()) ? bindings[i] : PRIMITIVES_SCRATCH_REGISTER;
+        writes[i].type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+        writes[i].bufferOffset           = 0;
+        writes[i].bufferRange            = PPX_WHOLE_SIZE;
+        writes[i].structuredElementCount = static_cast<uint32_t>(pBuffer->GetSize() / kUintStride);
+        writes[i].pBuffer                = pBuffer;
+    }
+
+    ppxres = set->UpdateDescriptors(CountU32(writes), writes.data());
+    if (Failed(ppxres)) {
+        mDevice->FreeDescriptorSet(set);
+        return ppxres;
+    }
+
+    mBufferSets.emplace(key, set);
+    *ppSet = set;
+
+    return ppx::SUCCESS;
+}
+
+void ParallelPrimitives::UAVBarrier(grfx::CommandBuffer* pCmd, const grfx::Buffer* pBuffer)
+{
+    // Transitions to the same state are dropped, so go through another one
+    pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCmd->BufferResourceBarrier(pBuffer, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
+void ParallelPrimitives::Dispatch(grfx::CommandBuffer* pCmd, Kernel kernel, const grfx::DescriptorSet* pSet, const ParallelPrimitivesParams& params, uint32_t groupCount)
+{
+    pCmd->BindComputePipeline(mPipelines[kernel]);
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+    pCmd->Dispatch(groupCount, 1, 1);
+}
+
+void ParallelPrimitives::RecordScanLevels(
+    grfx::CommandBuffer*       pCmd,
+    const grfx::DescriptorSet* pSet,
+    ScanTarget                 input,
+    uint32_t                   inputOffset,
+    ScanTarget                 output,
+    uint32_t                   outputOffset,
+    uint32_t                   count)
+{
+    // Level 0 is the input, level n + 1 holds the tile sums of level n
+    std::vector<uint32_t> levelCounts  = {count};
+    std::vector<uint32_t> levelOffsets = {0};
+    for (uint32_t offset = mPartialsOffset; levelCounts.back() > kTileSize;) {
+        levelCounts.push_back(DivideRoundUp(levelCounts.back(), kTileSize));
+        levelOffsets.push_back(offset);
+        offset += levelCounts.back();
+    }
+    const uint32_t topLevel = CountU32(levelCounts) - 1;
+
+    uint32_t inputFlags = 0;
+    if (input == SCAN_TARGET_VALUES) {
+        inputFlags = PRIMITIVES_FLAG_INPUT_VALUES;
+    }
+    else if (input == SCAN_TARGET_SCRATCH) {
+        inputFlags = PRIMITIVES_FLAG_INPUT_SCRATCH;
+    }
+    const uint32_t outputFlags = (output == SCAN_TARGET_SCRATCH) ? PRIMITIVES_FLAG_OUTPUT_SCRATCH : 0;
+
+    // Tile sums, up to the level that fits in a single tile
+    for (uint32_t level = 0; level < topLevel; ++level) {
+        ParallelPrimitivesParams params = {};
+        params.count                    = levelCounts[level];
+        params.inputOffset              = (level == 0) ? inputOffset : levelOffsets[level];
+        params.scratchOffset            = levelOffsets[level + 1];
+        params.flags                    = (level == 0) ? inputFlags : PRIMITIVES_FLAG_INPUT_SCRATCH;
+
+        Dispatch(pCmd, KERNEL_SCAN_REDUCE, pSet, params, levelCounts[level + 1]);
+        UAVBarrier(pCmd, mScratchBuffer);
+    }
+
+    // Scans of each level from the top, offset by the scanned level above.
+    // Levels above 0 are scanned in place.
+    for (uint32_t level = topLevel + 1; level-- > 0;) {
+        ParallelPrimitivesParams params = {};
+        params.count                    = levelCounts[level];
+        if (level == 0) {
+            params.inputOffset  = inputOffset;
+            params.outputOffset = outputOffset;
+            params.flags        = inputFlags | outputFlags;
+        }
+        else {
+            params.inputOffset  = levelOffsets[level];
+            params.outputOffset = levelOffsets[level];
+            params.flags        = PRIMITIVES_FLAG_INPUT_SCRATCH | PRIMITIVES_FLAG_OUTPUT_SCRATCH;
+        }
+        if (level < topLevel) {
+            params.scratchOffset = levelOffsets[level + 1];
+            params.flags |= PRIMITIVES_FLAG_ADD_PARTIALS;
+        }
+
+        Dispatch(pCmd, KERNEL_SCAN_DOWNSWEEP, pSet, params, DivideRoundUp(levelCounts[level], kTileSize));
+        UAVBarrier(pCmd, mScratchBuffer);
+    }
+}
+
+Result ParallelPrimitives::RecordScan(grfx::CommandBuffer* pCmd, grfx::Buffer* pInput, grfx::Buffer* pOutput, uint32_t count)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    if (IsNull(pInput) || IsNull(pOutput)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (count > mMaxElementCount) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    if (count == 0) {
+        return ppx::SUCCESS;
+    }
+
+    const grfx::DescriptorSet* pSet   = nullptr;
+    Result                     ppxres = GetBufferSet({pInput, pOutput, nullptr, nullptr, nullptr}, &pSet);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    RecordScanLevels(pCmd, pSet, SCAN_TARGET_KEYS, 0, SCAN_TARGET_KEYS, 0, count);
+    UAVBarrier(pCmd, pOutput);
+
+    return ppx::SUCCESS;
+}
+
+Result ParallelPrimitives::RecordCompact(grfx::CommandBuffer* pCmd, grfx::Buffer* pInput, grfx::Buffer* pFlags, grfx::Buffer* pOutput, grfx::Buffer* pCount, uint32_t count)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    if (IsNull(pInput) || IsNull(pFlags) || IsNull(pOutput) || IsNull(pCount)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (pInput == pOutput) {
+        return ppx::ERROR_RANGE_ALIASING_NOT_ALLOWED;
+    }
+    if (count > mMaxElementCount) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    const grfx::DescriptorSet* pSet   = nullptr;
+    Result                     ppxres = GetBufferSet({pInput, pOutput, pFlags, nullptr, pCount}, &pSet);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Destination of each element, at the start of the scratch buffer
+    if (count > 0) {
+        RecordScanLevels(pCmd, pSet, SCAN_TARGET_VALUES, 0, SCAN_TARGET_SCRATCH, 0, count);
+    }
+
+    // Still dispatched for no elements, to write the count
+    ParallelPrimitivesParams params = {};
+    params.count                    = count;
+
+    Dispatch(pCmd, KERNEL_COMPACT_SCATTER, pSet, params, std::max<uint32_t>(DivideRoundUp(count, kGroupSize), 1));
+    UAVBarrier(pCmd, pOutput);
+    UAVBarrier(pCmd, pCount);
+
+    return ppx::SUCCESS;
+}
+
+Result ParallelPrimitives::RecordSort(
+    grfx::CommandBuffer* pCmd,
+    grfx::Buffer*        pKeys,
+    grfx::Buffer*        pValues,
+    grfx::Buffer*        pTempKeys,
+    grfx::Buffer*        pTempValues,
+    uint32_t             count,
+    uint32_t             keyBits)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    if (IsNull(pKeys) || IsNull(pTempKeys) || (!IsNull(pValues) && IsNull(pTempValues))) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((keyBits == 0) || (keyBits > 32)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    if (count > mMaxElementCount) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    if (count == 0) {
+        return ppx::SUCCESS;
+    }
+
+    const bool     hasValues = !IsNull(pValues);
+    const uint32_t passCount = DivideRoundUp(keyBits, kRadixBits);
+    const uint32_t tileCount = DivideRoundUp(count, kTileSize);
+
+    // Passes alternate between the buffers and their temp buffers
+    const grfx::DescriptorSet* pSets[2] = {};
+    Result                     ppxres   = GetBufferSet({pKeys, pTempKeys, pValues, pTempValues, nullptr}, &pSets[0]);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    if (passCount > 1) {
+        ppxres = GetBufferSet({pTempKeys, pKeys, pTempValues, pValues, nullptr}, &pSets[1]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    for (uint32_t pass = 0; pass < passCount; ++pass) {
+        const grfx::DescriptorSet* pSet = pSets[pass % 2];
+
+        ParallelPrimitivesParams params = {};
+        params.count                    = count;
+        params.tileCount                = tileCount;
+        params.shift                    = pass * kRadixBits;
+        params.flags                    = hasValues ? PRIMITIVES_FLAG_VALUES : 0;
+
+        // Digit counts of each tile, digit major so their exclusive scan
+        // is where each tile's keys of each digit go
+        Dispatch(pCmd, KERNEL_RADIX_HISTOGRAM, pSet, params, tileCount);
+        UAVBarrier(pCmd, mScratchBuffer);
+
+        RecordScanLevels(pCmd, pSet, SCAN_TARGET_SCRATCH, 0, SCAN_TARGET_SCRATCH, 0, kRadixSize * tileCount);
+
+        Dispatch(pCmd, KERNEL_RADIX_SCATTER, pSet, params, tileCount);
+
+        grfx::Buffer* pDstKeys   = (pass % 2 == 0) ? pTempKeys : pKeys;
+        grfx::Buffer* pDstValues = (pass % 2 == 0) ? pTempValues : pValues;
+        UAVBarrier(pCmd, pDstKeys);
+        if (hasValues) {
+            UAVBarrier(pCmd, pDstValues);
+        }
+    }
+
+    // An odd number of passes ends in the temp buffers
+    if (passCount % 2 == 1) {
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = static_cast<uint64_t>(count) * kUintStride;
+
+        std::vector<std::pair<grfx::Buffer*, grfx::Buffer*>> copies = {{pTempKeys, pKeys}};
+        if (hasValues) {
+            copies.push_back({pTempValues, pValues});
+        }
+
+        for (auto& copy : copies) {
+            pCmd->BufferResourceBarrier(copy.first, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+            pCmd->BufferResourceBarrier(copy.second, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_DST);
+            pCmd->CopyBufferToBuffer(&copyInfo, copy.first, copy.second);
+            pCmd->BufferResourceBarrier(copy.first, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+            pCmd->BufferResourceBarrier(copy.second, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
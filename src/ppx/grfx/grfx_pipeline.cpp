@@ -110,9 +110,13 @@ void FillOutGraphicsPipelineCreateInfo(
     *pDstCreateInfo = {};
 
     pDstCreateInfo->dynamicRenderPass = pSrcCreateInfo->dynamicRenderPass;
+    pDstCreateInfo->dynamicState      = pSrcCreateInfo->dynamicState;
+    pDstCreateInfo->shaderObjects     = pSrcCreateInfo->shaderObjects;
 
     // Shaders
     pDstCreateInfo->VS = pSrcCreateInfo->VS;
+    pDstCreateInfo->AS = pSrcCreateInfo->AS;
+    pDstCreateInfo->MS = pSrcCreateInfo->MS;
     pDstCreateInfo->PS = pSrcCreateInfo->PS;
 
     // Vertex input
@@ -290,6 +294,49 @@ Result GraphicsPipeline::Create(const grfx::GraphicsPipelineCreateInfo* pCreateI
         return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
     }
 
+    if (!IsNull(pCreateInfo->AS.pModule) && IsNull(pCreateInfo->MS.pModule)) {
+        PPX_ASSERT_MSG(false, "amplification shader requires a mesh shader");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    if (!IsNull(pCreateInfo->MS.pModule)) {
+        if (!GetDevice()->MeshShaderSupported()) {
+            PPX_ASSERT_MSG(false, "Cannot create a mesh shader pipeline, mesh shaders are not supported.");
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+        if (!IsNull(pCreateInfo->AS.pModule) && !GetDevice()->AmplificationShaderSupported()) {
+            PPX_ASSERT_MSG(false, "Cannot create a pipeline with an amplification shader, amplification shaders are not supported.");
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+
+        bool hasVertexStages = !IsNull(pCreateInfo->VS.pModule) ||
+                               !IsNull(pCreateInfo->HS.pModule) ||
+                               !IsNull(pCreateInfo->DS.pModule) ||
+                               !IsNull(pCreateInfo->GS.pModule);
+        if (hasVertexStages || (pCreateInfo->vertexInputState.bindingCount > 0)) {
+            PPX_ASSERT_MSG(false, "mesh shader pipelines cannot have vertex, tessellation or geometry shaders or vertex input");
+            return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+        }
+    }
+
+    const grfx::DynamicState& dynamicState         = pCreateInfo->dynamicState;
+    bool                      extendedDynamicState = dynamicState.cullMode ||
+                                                     dynamicState.primitiveTopology ||
+                                                     dynamicState.depthTestEnable ||
+                                                     dynamicState.depthWriteEnable;
+    if (extendedDynamicState && !GetDevice()->ExtendedDynamicStateSupported()) {
+        PPX_ASSERT_MSG(false, "Cannot create a pipeline with dynamic cull mode, topology or depth state, extended dynamic state is not supported.");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+    if (dynamicState.blendEnable && !GetDevice()->DynamicBlendEnableSupported()) {
+        PPX_ASSERT_MSG(false, "Cannot create a pipeline with dynamic blend enable, dynamic blend enable is not supported.");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+    if (dynamicState.primitiveTopology && !IsNull(pCreateInfo->MS.pModule)) {
+        PPX_ASSERT_MSG(false, "mesh shader pipelines have no primitive topology");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
     Result ppxres = grfx::DeviceObject<grfx::GraphicsPipelineCreateInfo>::Create(pCreateInfo);
     if (Failed(ppxres)) {
         return ppxres;
@@ -0,0 +1,744 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_pipeline_manifest.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/fs.h"
+#include "ppx/timer.h"
+
+#include "xxhash.h"
+
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace ppx {
+namespace grfx {
+
+// 'PPXM'
+static const uint32_t kManifestMagic   = 0x4D585050;
+static const uint32_t kManifestVersion = 1;
+
+// Layout changes of the create info invalidate manifests of older builds
+static const uint32_t kManifestLayout = static_cast<uint32_t>(sizeof(grfx::GraphicsPipelineCreateInfo));
+
+enum ManifestPipelineKind : uint32_t
+{
+    MANIFEST_PIPELINE_KIND_COMPUTE  = 0,
+    MANIFEST_PIPELINE_KIND_GRAPHICS = 1,
+};
+
+namespace {
+
+// Writer and reader share the Serialize* functions below, so the two sides
+// of the format can't drift apart
+class ManifestWriter
+{
+public:
+    ManifestWriter(std::vector<char>& data)
+        : mData(data) {}
+
+    template <typename T>
+    void Value(const T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "values must be scalars");
+        const char* pBytes = reinterpret_cast<const char*>(&value);
+        mData.insert(mData.end(), pBytes, pBytes + sizeof(T));
+    }
+
+    void String(const std::string& value)
+    {
+        Value(static_cast<uint32_t>(value.size()));
+        mData.insert(mData.end(), value.begin(), value.end());
+    }
+
+    void Blob(const std::vector<char>& value)
+    {
+        Value(static_cast<uint64_t>(value.size()));
+        mData.insert(mData.end(), value.begin(), value.end());
+    }
+
+private:
+    std::vector<char>& mData;
+};
+
+// Reads stop at the end of the data, Failed() tells if one did
+class ManifestReader
+{
+public:
+    ManifestReader(const char* pData, size_t size)
+        : mData(pData), mSize(size) {}
+
+    bool Failed() const { return mFailed; }
+    bool AtEnd() const { return mOffset == mSize; }
+
+    template <typename T>
+    void Value(T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "values must be scalars");
+        Bytes(&value, sizeof(T));
+    }
+
+    void String(std::string& value)
+    {
+        uint32_t size = 0;
+        Value(size);
+        value.assign(Take(size), mFailed ? 0 : size);
+    }
+
+    void Blob(std::vector<char>& value)
+    {
+        uint64_t size = 0;
+        Value(size);
+        const char* pBytes = Take(size);
+        value.assign(pBytes, pBytes + (mFailed ? 0 : size));
+    }
+
+private:
+    const char* Take(uint64_t size)
+    {
+        if (mFailed || (size > (mSize - mOffset))) {
+            mFailed = true;
+            return mData;
+        }
+        const char* pBytes = mData + mOffset;
+        mOffset += static_cast<size_t>(size);
+        return pBytes;
+    }
+
+    void Bytes(void* pDst, size_t size)
+    {
+        const char* pBytes = Take(size);
+        if (!mFailed) {
+            std::memcpy(pDst, pBytes, size);
+        }
+    }
+
+private:
+    const char* mData   = nullptr;
+    size_t      mSize   = 0;
+    size_t      mOffset = 0;
+    bool        mFailed = false;
+};
+
+uint64_t Hash(const std::vector<char>& data)
+{
+    return XXH3_64bits(data.data(), data.size());
+}
+
+template <typename Archive>
+void SerializeStencilOpState(Archive& ar, grfx::StencilOpState& state)
+{
+    ar.Value(state.failOp);
+    ar.Value(state.passOp);
+    ar.Value(state.depthFailOp);
+    ar.Value(state.compareOp);
+    ar.Value(state.compareMask);
+    ar.Value(state.writeMask);
+    ar.Value(state.reference);
+}
+
+// Fixed function state of a graphics pipeline, shaders, vertex input and
+// the pipeline interface are handled separately
+template <typename Archive>
+void SerializeGraphicsState(Archive& ar, grfx::GraphicsPipelineCreateInfo& ci)
+{
+    ar.Value(ci.inputAssemblyState.topology);
+    ar.Value(ci.inputAssemblyState.primitiveRestartEnable);
+
+    ar.Value(ci.tessellationState.patchControlPoints);
+    ar.Value(ci.tessellationState.domainOrigin);
+
+    ar.Value(ci.rasterState.depthClampEnable);
+    ar.Value(ci.rasterState.rasterizeDiscardEnable);
+    ar.Value(ci.rasterState.polygonMode);
+    ar.Value(ci.rasterState.cullMode);
+    ar.Value(ci.rasterState.frontFace);
+    ar.Value(ci.rasterState.depthBiasEnable);
+    ar.Value(ci.rasterState.depthBiasConstantFactor);
+    ar.Value(ci.rasterState.depthBiasClamp);
+    ar.Value(ci.rasterState.depthBiasSlopeFactor);
+    ar.Value(ci.rasterState.depthClipEnable);
+    ar.Value(ci.rasterState.rasterizationSamples);
+
+    ar.Value(ci.multisampleState.alphaToCoverageEnable);
+
+    ar.Value(ci.depthStencilState.depthTestEnable);
+    ar.Value(ci.depthStencilState.depthWriteEnable);
+    ar.Value(ci.depthStencilState.depthCompareOp);
+    ar.Value(ci.depthStencilState.depthBoundsTestEnable);
+    ar.Value(ci.depthStencilState.minDepthBounds);
+    ar.Value(ci.depthStencilState.maxDepthBounds);
+    ar.Value(ci.depthStencilState.stencilTestEnable);
+    SerializeStencilOpState(ar, ci.depthStencilState.front);
+    SerializeStencilOpState(ar, ci.depthStencilState.back);
+
+    ar.Value(ci.colorBlendState.logicOpEnable);
+    ar.Value(ci.colorBlendState.logicOp);
+    ar.Value(ci.colorBlendState.blendAttachmentCount);
+    for (auto& attachment : ci.colorBlendState.blendAttachments) {
+        ar.Value(attachment.blendEnable);
+        ar.Value(attachment.srcColorBlendFactor);
+        ar.Value(attachment.dstColorBlendFactor);
+        ar.Value(attachment.colorBlendOp);
+        ar.Value(attachment.srcAlphaBlendFactor);
+        ar.Value(attachment.dstAlphaBlendFactor);
+        ar.Value(attachment.alphaBlendOp);
+        ar.Value(attachment.colorWriteMask.flags);
+    }
+    for (auto& constant : ci.colorBlendState.blendConstants) {
+        ar.Value(constant);
+    }
+
+    ar.Value(ci.outputState.renderTargetCount);
+    for (auto& format : ci.outputState.renderTargetFormats) {
+        ar.Value(format);
+    }
+    ar.Value(ci.outputState.depthStencilFormat);
+
+    ar.Value(ci.shadingRateMode);
+    ar.Value(ci.multiViewState.viewMask);
+    ar.Value(ci.multiViewState.correlationMask);
+    ar.Value(ci.dynamicRenderPass);
+    ar.Value(ci.dynamicState.cullMode);
+    ar.Value(ci.dynamicState.primitiveTopology);
+    ar.Value(ci.dynamicState.depthTestEnable);
+    ar.Value(ci.dynamicState.depthWriteEnable);
+    ar.Value(ci.dynamicState.blendEnable);
+    ar.Value(ci.shaderObjects);
+}
+
+void WriteVertexInput(ManifestWriter& writer, const grfx::VertexInputState& state)
+{
+    writer.Value(state.bindingCount);
+    for (uint32_t i = 0; i < state.bindingCount; ++i) {
+        const grfx::VertexBinding& binding = state.bindings[i];
+        writer.Value(binding.GetBinding());
+        writer.Value(binding.GetStride());
+        writer.Value(binding.GetInputRate());
+        writer.Value(binding.GetAttributeCount());
+        for (uint32_t j = 0; j < binding.GetAttributeCount(); ++j) {
+            const grfx::VertexAttribute* pAttribute = nullptr;
+            binding.GetAttribute(j, &pAttribute);
+            writer.String(pAttribute->semanticName);
+            writer.Value(pAttribute->location);
+            writer.Value(pAttribute->format);
+            writer.Value(pAttribute->binding);
+            writer.Value(pAttribute->offset);
+            writer.Value(pAttribute->inputRate);
+            writer.Value(pAttribute->semantic);
+        }
+    }
+}
+
+void ReadVertexInput(ManifestReader& reader, grfx::VertexInputState& state)
+{
+    reader.Value(state.bindingCount);
+    if (state.bindingCount > PPX_MAX_VERTEX_BINDINGS) {
+        state.bindingCount = 0;
+        return;
+    }
+
+    for (uint32_t i = 0; (i < state.bindingCount) && !reader.Failed(); ++i) {
+        uint32_t              bindingNumber  = 0;
+        uint32_t              stride         = 0;
+        uint32_t              attributeCount = 0;
+        grfx::VertexInputRate inputRate      = grfx::VERTEX_INPUT_RATE_VERTEX;
+        reader.Value(bindingNumber);
+        reader.Value(stride);
+        reader.Value(inputRate);
+        reader.Value(attributeCount);
+
+        grfx::VertexBinding binding(bindingNumber, inputRate);
+        for (uint32_t j = 0; (j < attributeCount) && !reader.Failed(); ++j) {
+            grfx::VertexAttribute attribute = {};
+            reader.String(attribute.semanticName);
+            reader.Value(attribute.location);
+            reader.Value(attribute.format);
+            reader.Value(attribute.binding);
+            reader.Value(attribute.offset);
+            reader.Value(attribute.inputRate);
+            reader.Value(attribute.semantic);
+            binding.AppendAttribute(attribute);
+        }
+        // Appending recomputes the stride, restore the one it was created with
+        binding.SetStride(stride);
+
+        state.bindings[i] = binding;
+    }
+}
+
+// Returns false for interfaces that can't be recreated from the manifest
+bool WriteInterface(ManifestWriter& writer, const grfx::PipelineInterface* pInterface)
+{
+    const grfx::PipelineInterfaceCreateInfo& ci = pInterface->GetCreateInfo();
+
+    writer.Value(ci.setCount);
+    for (uint32_t i = 0; i < ci.setCount; ++i) {
+        const grfx::DescriptorSetLayout* pLayout = ci.sets[i].pLayout;
+        const auto&                      layout  = pLayout->GetBindings();
+
+        writer.Value(ci.sets[i].set);
+        writer.Value(pLayout->IsPushable());
+        writer.Value(static_cast<uint32_t>(layout.size()));
+        for (const auto& binding : layout) {
+            if (!binding.immutableSamplers.empty()) {
+                return false;
+            }
+            writer.Value(binding.binding);
+            writer.Value(binding.type);
+            writer.Value(binding.arrayCount);
+            writer.Value(binding.shaderVisiblity);
+            writer.Value(binding.flags.flags);
+        }
+    }
+
+    writer.Value(ci.pushConstants.count);
+    writer.Value(ci.pushConstants.binding);
+    writer.Value(ci.pushConstants.set);
+    writer.Value(ci.pushConstants.shaderVisiblity);
+
+    return true;
+}
+
+// Objects created by Precompile(), shared by the pipelines that use them
+class PrecompileObjects
+{
+public:
+    PrecompileObjects(grfx::Device* pDevice, const std::unordered_map<uint64_t, std::vector<char>>& shaders)
+        : mDevice(pDevice), mShaders(shaders) {}
+
+    ~PrecompileObjects()
+    {
+        for (auto& it : mInterfaces) {
+            mDevice->DestroyPipelineInterface(it.second);
+        }
+        for (auto& layout : mSetLayouts) {
+            mDevice->DestroyDescriptorSetLayout(layout);
+        }
+        for (auto& it : mModules) {
+            mDevice->DestroyShaderModule(it.second);
+        }
+    }
+
+    bool ReadStage(ManifestReader& reader, grfx::ShaderStageInfo& stage)
+    {
+        uint64_t hash = 0;
+        reader.Value(hash);
+        reader.String(stage.entryPoint);
+
+        uint32_t constantCount = 0;
+        reader.Value(constantCount);
+        for (uint32_t i = 0; (i < constantCount) && !reader.Failed(); ++i) {
+            grfx::SpecializationConstant constant = {};
+            reader.Value(constant.id);
+            reader.Value(constant.value);
+            stage.specializationConstants.push_back(constant);
+        }
+
+        if (reader.Failed() || (hash == 0)) {
+            return !reader.Failed();
+        }
+
+        auto it = mModules.find(hash);
+        if (it == mModules.end()) {
+            auto shader = mShaders.find(hash);
+            if (shader == mShaders.end()) {
+                return false;
+            }
+
+            grfx::ShaderModuleCreateInfo shaderCreateInfo = {static_cast<uint32_t>(shader->second.size()), shader->second.data()};
+            grfx::ShaderModulePtr        module;
+            if (Failed(mDevice->CreateShaderModule(&shaderCreateInfo, &module))) {
+                return false;
+            }
+            it = mModules.emplace(hash, module).first;
+        }
+        stage.pModule = it->second;
+
+        return true;
+    }
+
+    const grfx::PipelineInterface* ReadInterface(ManifestReader& reader)
+    {
+        std::vector<char> data;
+        reader.Blob(data);
+        if (reader.Failed()) {
+            return nullptr;
+        }
+
+        const uint64_t hash = Hash(data);
+        auto           it   = mInterfaces.find(hash);
+        if (it != mInterfaces.end()) {
+            return it->second;
+        }
+
+        ManifestReader                    interfaceReader(data.data(), data.size());
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        interfaceReader.Value(piCreateInfo.setCount);
+        if (piCreateInfo.setCount > PPX_MAX_BOUND_DESCRIPTOR_SETS) {
+            return nullptr;
+        }
+
+        for (uint32_t i = 0; i < piCreateInfo.setCount; ++i) {
+            grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+            bool                                pushable         = false;
+            uint32_t                            bindingCount     = 0;
+            interfaceReader.Value(piCreateInfo.sets[i].set);
+            interfaceReader.Value(pushable);
+            interfaceReader.Value(bindingCount);
+            layoutCreateInfo.flags.bits.pushable = pushable;
+
+            for (uint32_t j = 0; (j < bindingCount) && !interfaceReader.Failed(); ++j) {
+                grfx::DescriptorBinding binding;
+                interfaceReader.Value(binding.binding);
+                interfaceReader.Value(binding.type);
+                interfaceReader.Value(binding.arrayCount);
+                interfaceReader.Value(binding.shaderVisiblity);
+                interfaceReader.Value(binding.flags.flags);
+                layoutCreateInfo.bindings.push_back(binding);
+            }
+            if (interfaceReader.Failed()) {
+                return nullptr;
+            }
+
+            grfx::DescriptorSetLayoutPtr layout;
+            if (Failed(mDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &layout))) {
+                return nullptr;
+            }
+            mSetLayouts.push_back(layout);
+            piCreateInfo.sets[i].pLayout = layout;
+        }
+
+        interfaceReader.Value(piCreateInfo.pushConstants.count);
+        interfaceReader.Value(piCreateInfo.pushConstants.binding);
+        interfaceReader.Value(piCreateInfo.pushConstants.set);
+        interfaceReader.Value(piCreateInfo.pushConstants.shaderVisiblity);
+        if (interfaceReader.Failed()) {
+            return nullptr;
+        }
+
+        grfx::PipelineInterfacePtr pipelineInterface;
+        if (Failed(mDevice->CreatePipelineInterface(&piCreateInfo, &pipelineInterface))) {
+            return nullptr;
+        }
+        mInterfaces[hash] = pipelineInterface;
+
+        return pipelineInterface;
+    }
+
+private:
+    grfx::Device*                                          mDevice = nullptr;
+    const std::unordered_map<uint64_t, std::vector<char>>& mShaders;
+    std::unordered_map<uint64_t, grfx::ShaderModulePtr>      mModules;
+    std::unordered_map<uint64_t, grfx::PipelineInterfacePtr> mInterfaces;
+    std::vector<grfx::DescriptorSetLayoutPtr>                mSetLayouts;
+};
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// PipelineManifest
+// -------------------------------------------------------------------------------------------------
+void PipelineManifest::RecordShaderModule(const grfx::ShaderModule* pModule, const grfx::ShaderModuleCreateInfo* pCreateInfo)
+{
+    if (IsNull(pModule) || IsNull(pCreateInfo->pCode) || (pCreateInfo->size == 0)) {
+        return;
+    }
+
+    const uint64_t hash = XXH3_64bits(pCreateInfo->pCode, pCreateInfo->size);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Modules can be created at the address of destroyed ones
+    mModuleHashes[pModule] = hash;
+    if (mShaders.find(hash) == mShaders.end()) {
+        mShaders[hash] = std::vector<char>(pCreateInfo->pCode, pCreateInfo->pCode + pCreateInfo->size);
+    }
+}
+
+bool PipelineManifest::RecordStage(const grfx::ShaderStageInfo& stage, std::vector<char>& data) const
+{
+    uint64_t hash = 0;
+    if (!IsNull(stage.pModule)) {
+        auto it = mModuleHashes.find(stage.pModule);
+        if (it == mModuleHashes.end()) {
+            return false;
+        }
+        hash = it->second;
+    }
+
+    ManifestWriter writer(data);
+    writer.Value(hash);
+    writer.String(stage.entryPoint);
+    writer.Value(static_cast<uint32_t>(stage.specializationConstants.size()));
+    for (const auto& constant : stage.specializationConstants) {
+        writer.Value(constant.id);
+        writer.Value(constant.value);
+    }
+
+    return true;
+}
+
+void PipelineManifest::AddPipeline(std::vector<char>&& data)
+{
+    const uint64_t hash = Hash(data);
+    if (mPipelines.find(hash) == mPipelines.end()) {
+        mPipelines[hash] = std::move(data);
+    }
+}
+
+void PipelineManifest::RecordPipeline(const grfx::ComputePipelineCreateInfo* pCreateInfo)
+{
+    std::vector<char> data;
+    ManifestWriter    writer(data);
+    writer.Value(MANIFEST_PIPELINE_KIND_COMPUTE);
+
+    std::vector<char> interfaceData;
+    ManifestWriter    interfaceWriter(interfaceData);
+    if (!WriteInterface(interfaceWriter, pCreateInfo->pPipelineInterface)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!RecordStage(pCreateInfo->CS, data)) {
+        return;
+    }
+    writer.Blob(interfaceData);
+
+    AddPipeline(std::move(data));
+}
+
+void PipelineManifest::RecordPipeline(const grfx::GraphicsPipelineCreateInfo* pCreateInfo)
+{
+    std::vector<char> data;
+    ManifestWriter    writer(data);
+    writer.Value(MANIFEST_PIPELINE_KIND_GRAPHICS);
+
+    std::vector<char> interfaceData;
+    ManifestWriter    interfaceWriter(interfaceData);
+    if (!WriteInterface(interfaceWriter, pCreateInfo->pPipelineInterface)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const grfx::ShaderStageInfo* pStage : {&pCreateInfo->VS, &pCreateInfo->HS, &pCreateInfo->DS, &pCreateInfo->GS, &pCreateInfo->AS, &pCreateInfo->MS, &pCreateInfo->PS}) {
+        if (!RecordStage(*pStage, data)) {
+            return;
+        }
+    }
+    WriteVertexInput(writer, pCreateInfo->vertexInputState);
+
+    grfx::GraphicsPipelineCreateInfo createInfo = *pCreateInfo;
+    SerializeGraphicsState(writer, createInfo);
+    writer.Blob(interfaceData);
+
+    AddPipeline(std::move(data));
+}
+
+uint32_t PipelineManifest::GetPipelineCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<uint32_t>(mPipelines.size());
+}
+
+Result PipelineManifest::Load(const std::filesystem::path& path)
+{
+    std::optional<std::vector<char>> file = fs::load_file(path);
+    if (!file.has_value()) {
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+
+    ManifestReader reader(file->data(), file->size());
+
+    uint32_t magic   = 0;
+    uint32_t version = 0;
+    uint32_t layout  = 0;
+    reader.Value(magic);
+    reader.Value(version);
+    reader.Value(layout);
+    if ((magic != kManifestMagic) || (version != kManifestVersion) || (layout != kManifestLayout)) {
+        PPX_LOG_WARN("Ignoring pipeline manifest of another version or build: " << path);
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    std::unordered_map<uint64_t, std::vector<char>> shaders;
+    std::vector<std::vector<char>>                  pipelines;
+
+    uint64_t shaderCount = 0;
+    reader.Value(shaderCount);
+    for (uint64_t i = 0; (i < shaderCount) && !reader.Failed(); ++i) {
+        std::vector<char> bytecode;
+        reader.Blob(bytecode);
+        const uint64_t hash = XXH3_64bits(bytecode.data(), bytecode.size());
+        shaders[hash]       = std::move(bytecode);
+    }
+
+    uint64_t pipelineCount = 0;
+    reader.Value(pipelineCount);
+    for (uint64_t i = 0; (i < pipelineCount) && !reader.Failed(); ++i) {
+        std::vector<char> data;
+        reader.Blob(data);
+        pipelines.push_back(std::move(data));
+    }
+
+    if (reader.Failed() || !reader.AtEnd()) {
+        PPX_LOG_WARN("Ignoring truncated or corrupt pipeline manifest: " << path);
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& it : shaders) {
+        mShaders.emplace(it.first, std::move(it.second));
+    }
+    for (auto& data : pipelines) {
+        AddPipeline(std::move(data));
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result PipelineManifest::Save(const std::filesystem::path& path) const
+{
+    std::vector<char> data;
+    ManifestWriter    writer(data);
+    writer.Value(kManifestMagic);
+    writer.Value(kManifestVersion);
+    writer.Value(kManifestLayout);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        writer.Value(static_cast<uint64_t>(mShaders.size()));
+        for (const auto& it : mShaders) {
+            writer.Blob(it.second);
+        }
+        writer.Value(static_cast<uint64_t>(mPipelines.size()));
+        for (const auto& it : mPipelines) {
+            writer.Blob(it.second);
+        }
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        PPX_LOG_ERROR("Unable to open pipeline manifest for writing: " << path);
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file.good()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result PipelineManifest::Precompile(grfx::Device* pDevice, uint32_t* pPipelineCount) const
+{
+    if (IsNull(pDevice)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    // Copies, creating the pipelines records them again
+    std::unordered_map<uint64_t, std::vector<char>> shaders;
+    std::vector<std::vector<char>>                  pipelines;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        shaders = mShaders;
+        for (const auto& it : mPipelines) {
+            pipelines.push_back(it.second);
+        }
+    }
+
+    Timer timer;
+    timer.Start();
+
+    PrecompileObjects                        objects(pDevice, shaders);
+    std::vector<grfx::AsyncComputePipeline>  computePipelines;
+    std::vector<grfx::AsyncGraphicsPipeline> graphicsPipelines;
+
+    for (const auto& data : pipelines) {
+        ManifestReader reader(data.data(), data.size());
+
+        ManifestPipelineKind kind = MANIFEST_PIPELINE_KIND_COMPUTE;
+        reader.Value(kind);
+
+        // Pipelines that can't be recreated are counted as failed below
+        if (reader.Failed()) {
+            continue;
+        }
+
+        if (kind == MANIFEST_PIPELINE_KIND_COMPUTE) {
+            grfx::ComputePipelineCreateInfo createInfo = {};
+            if (!objects.ReadStage(reader, createInfo.CS)) {
+                continue;
+            }
+            createInfo.pPipelineInterface = objects.ReadInterface(reader);
+            if (IsNull(createInfo.pPipelineInterface) || !reader.AtEnd()) {
+                continue;
+            }
+
+            grfx::AsyncComputePipeline pipeline;
+            pDevice->CreateComputePipelineAsync(&createInfo, &pipeline);
+            computePipelines.push_back(pipeline);
+        }
+        else if (kind == MANIFEST_PIPELINE_KIND_GRAPHICS) {
+            grfx::GraphicsPipelineCreateInfo createInfo = {};
+
+            bool valid = true;
+            for (grfx::ShaderStageInfo* pStage : {&createInfo.VS, &createInfo.HS, &createInfo.DS, &createInfo.GS, &createInfo.AS, &createInfo.MS, &createInfo.PS}) {
+                valid = valid && objects.ReadStage(reader, *pStage);
+            }
+            ReadVertexInput(reader, createInfo.vertexInputState);
+            SerializeGraphicsState(reader, createInfo);
+            if (!valid || reader.Failed()) {
+                continue;
+            }
+            createInfo.pPipelineInterface = objects.ReadInterface(reader);
+            if (IsNull(createInfo.pPipelineInterface) || !reader.AtEnd()) {
+                continue;
+            }
+
+            grfx::AsyncGraphicsPipeline pipeline;
+            pDevice->CreateGraphicsPipelineAsync(&createInfo, &pipeline);
+            graphicsPipelines.push_back(pipeline);
+        }
+    }
+
+    // Shader modules and interfaces must outlive the compilations
+    uint32_t compiledCount = 0;
+    for (auto& pipeline : computePipelines) {
+        if (Success(pipeline.Wait())) {
+            pDevice->DestroyComputePipeline(pipeline.Get());
+            ++compiledCount;
+        }
+    }
+    for (auto& pipeline : graphicsPipelines) {
+        if (Success(pipeline.Wait())) {
+            pDevice->DestroyGraphicsPipeline(pipeline.Get());
+            ++compiledCount;
+        }
+    }
+
+    const uint32_t failedCount = static_cast<uint32_t>(pipelines.size()) - compiledCount;
+    if (failedCount > 0) {
+        PPX_LOG_WARN("Skipped " << failedCount << " pipelines of the manifest that couldn't be recreated or compiled");
+    }
+    PPX_LOG_INFO("Precompiled " << compiledCount << " pipelines in " << timer.MillisSinceStart() << " ms");
+
+    if (!IsNull(pPipelineCount)) {
+        *pPipelineCount = compiledCount;
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
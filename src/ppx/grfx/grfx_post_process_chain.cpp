@@ -0,0 +1,202 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_post_process_chain.h"
+#include "ppx/grfx/grfx_device.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace grfx {
+
+Result PostProcessChain::CreateApiObjects(const grfx::PostProcessChainCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    grfx::RenderGraphCreateInfo createInfo = {};
+    createInfo.enableAliasing              = pCreateInfo->enableAliasing;
+
+    Result ppxres = GetDevice()->CreateRenderGraph(&createInfo, &mRenderGraph);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "failed creating post process render graph");
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void PostProcessChain::DestroyApiObjects()
+{
+    if (mRenderGraph) {
+        GetDevice()->DestroyRenderGraph(mRenderGraph);
+        mRenderGraph.Reset();
+    }
+    mGraphPasses.clear();
+    mPasses.clear();
+    mBuilt = false;
+}
+
+grfx::RenderGraphResource PostProcessChain::AddImage(const grfx::RenderGraphImageCreateInfo& createInfo)
+{
+    return mRenderGraph->AddImage(createInfo);
+}
+
+grfx::RenderGraphResource PostProcessChain::ImportImage(const grfx::RenderGraphImportInfo& importInfo)
+{
+    return mRenderGraph->ImportImage(importInfo);
+}
+
+void PostProcessChain::SetImportedImage(grfx::RenderGraphResource image, grfx::Image* pImage)
+{
+    mRenderGraph->SetImportedImage(image, pImage);
+}
+
+grfx::ImagePtr PostProcessChain::GetImage(grfx::RenderGraphResource image) const
+{
+    return mRenderGraph->GetImage(image);
+}
+
+void PostProcessChain::AddPass(const grfx::PostProcessPassInfo& passInfo)
+{
+    PPX_ASSERT_MSG(!mBuilt, "post process chain declarations can't change after Compile()");
+    PPX_ASSERT_MSG(passInfo.output.IsValid(), "post process pass " << passInfo.name << " has invalid output");
+    PPX_ASSERT_MSG(passInfo.graphicsFn || passInfo.computeFn, "post process pass " << passInfo.name << " has nothing to record");
+
+    mPasses.push_back(passInfo);
+}
+
+bool PostProcessChain::UsesCompute(const grfx::PostProcessPassInfo& passInfo) const
+{
+    return passInfo.computeFn && (mCreateInfo.preferCompute || !passInfo.graphicsFn);
+}
+
+void PostProcessChain::AddGraphPass(const std::vector<uint32_t>& passIndices, bool compute)
+{
+    const grfx::RenderGraphResource output = mPasses[passIndices.front()].output;
+
+    std::string                             name;
+    std::vector<uint32_t>                   reads;
+    std::vector<grfx::RenderGraphExecuteFn> fns;
+    for (uint32_t passIndex : passIndices) {
+        const grfx::PostProcessPassInfo& passInfo = mPasses[passIndex];
+
+        name += (name.empty() ? "" : "+") + passInfo.name;
+        fns.push_back(compute ? passInfo.computeFn : passInfo.graphicsFn);
+
+        for (const auto& input : passInfo.inputs) {
+            PPX_ASSERT_MSG(input.IsValid(), "post process pass " << passInfo.name << " has invalid input");
+            // Compute passes read and write their output through the storage access,
+            // sampling the render target that's being written is a feedback loop
+            PPX_ASSERT_MSG(compute || (input.index != output.index), "post process pass " << passInfo.name << " samples its own render target");
+            if ((input.index != output.index) && (std::find(reads.begin(), reads.end(), input.index) == reads.end())) {
+                reads.push_back(input.index);
+            }
+        }
+    }
+
+    grfx::RenderGraphPass* pPass = mRenderGraph->AddPass(name);
+    if (compute) {
+        pPass->AddStorage(output);
+    }
+    else {
+        pPass->AddRenderTarget(output);
+    }
+    for (uint32_t index : reads) {
+        grfx::RenderGraphResource input = {};
+        input.index                     = index;
+        pPass->AddShaderRead(input, compute ? grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE : grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+    pPass->SetExecuteFn([fns](grfx::CommandBuffer* pCommandBuffer, const grfx::RenderPass* pRenderPass) {
+        for (const auto& fn : fns) {
+            fn(pCommandBuffer, pRenderPass);
+        }
+    });
+
+    mGraphPasses.push_back({pPass, compute, CountU32(passIndices)});
+}
+
+void PostProcessChain::BuildGraph()
+{
+    std::vector<uint32_t> group;
+    bool                  groupCompute = false;
+
+    for (uint32_t passIndex = 0; passIndex < CountU32(mPasses); ++passIndex) {
+        const grfx::PostProcessPassInfo& passInfo = mPasses[passIndex];
+        const bool                       compute  = UsesCompute(passInfo);
+
+        // Graphics passes join the open group if they render to the same
+        // target without sampling it, i.e. the target can stay on tile
+        bool merge = mCreateInfo.mergePasses && !compute && !group.empty() && !groupCompute;
+        if (merge) {
+            const grfx::RenderGraphResource groupOutput = mPasses[group.front()].output;
+
+            merge = (passInfo.output.index == groupOutput.index);
+            for (const auto& input : passInfo.inputs) {
+                merge = merge && (input.index != groupOutput.index);
+            }
+        }
+
+        if (!merge && !group.empty()) {
+            AddGraphPass(group, groupCompute);
+            group.clear();
+        }
+
+        group.push_back(passIndex);
+        groupCompute = compute;
+    }
+
+    if (!group.empty()) {
+        AddGraphPass(group, groupCompute);
+    }
+
+    mBuilt = true;
+}
+
+Result PostProcessChain::Compile()
+{
+    if (!mBuilt) {
+        BuildGraph();
+    }
+
+    Result ppxres = mRenderGraph->Compile();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    mRenderPassCount  = 0;
+    mComputePassCount = 0;
+    mMergedPassCount  = 0;
+    for (const auto& graphPass : mGraphPasses) {
+        if (graphPass.pPass->IsCulled()) {
+            continue;
+        }
+        if (graphPass.compute) {
+            ++mComputePassCount;
+        }
+        else {
+            ++mRenderPassCount;
+            mMergedPassCount += graphPass.passCount - 1;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void PostProcessChain::Execute(grfx::CommandBuffer* pCommandBuffer)
+{
+    mRenderGraph->Execute(pCommandBuffer);
+}
+
+} // namespace grfx
+} // namespace ppx
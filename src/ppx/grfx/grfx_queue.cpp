@@ -23,6 +23,33 @@ Result Queue::CreateCommandBuffer(
     grfx::CommandBuffer** ppCommandBuffer,
     uint32_t              resourceDescriptorCount,
     uint32_t              samplerDescriptorCount)
+{
+    return CreateCommandBufferImpl(ppCommandBuffer, resourceDescriptorCount, samplerDescriptorCount, false, false);
+}
+
+Result Queue::CreateSecondaryCommandBuffer(
+    grfx::CommandBuffer** ppCommandBuffer,
+    uint32_t              resourceDescriptorCount,
+    uint32_t              samplerDescriptorCount)
+{
+    return CreateCommandBufferImpl(ppCommandBuffer, resourceDescriptorCount, samplerDescriptorCount, true, false);
+}
+
+Result Queue::CreateReusableCommandBuffer(
+    grfx::CommandBuffer** ppCommandBuffer,
+    bool                  secondary,
+    uint32_t              resourceDescriptorCount,
+    uint32_t              samplerDescriptorCount)
+{
+    return CreateCommandBufferImpl(ppCommandBuffer, resourceDescriptorCount, samplerDescriptorCount, secondary, true);
+}
+
+Result Queue::CreateCommandBufferImpl(
+    grfx::CommandBuffer** ppCommandBuffer,
+    uint32_t              resourceDescriptorCount,
+    uint32_t              samplerDescriptorCount,
+    bool                  secondary,
+    bool                  reusable)
 {
     std::lock_guard<std::mutex> lock(mCommandSetMutex);
 
@@ -36,7 +63,7 @@ Result Queue::CreateCommandBuffer(
         return ppxres;
     }
 
-    ppxres = GetDevice()->AllocateCommandBuffer(set.commandPool, &set.commandBuffer, resourceDescriptorCount, samplerDescriptorCount);
+    ppxres = GetDevice()->AllocateCommandBuffer(set.commandPool, &set.commandBuffer, resourceDescriptorCount, samplerDescriptorCount, secondary, reusable);
     if (Failed(ppxres)) {
         GetDevice()->DestroyCommandPool(set.commandPool);
         return ppxres;
@@ -187,5 +214,71 @@ Result Queue::CopyBufferToImage(
     return ppx::SUCCESS;
 }
 
+Result Queue::BindSparseImageTiles(const grfx::SparseImageBindInfo* pBindInfo)
+{
+    PPX_ASSERT_NULL_ARG(pBindInfo);
+    PPX_ASSERT_NULL_ARG(pBindInfo->pImage);
+
+    if (!pBindInfo->pImage->GetSparseResidency()) {
+        PPX_ASSERT_MSG(false, "image wasn't created with sparseResidency");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+    if (GetCommandType() != grfx::COMMAND_TYPE_GRAPHICS) {
+        PPX_ASSERT_MSG(false, "sparse binds are only supported on the graphics queue");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    grfx::Image* pImage = pBindInfo->pImage;
+
+    // Unbinds go first so that a tile in both lists stays resident. Tiles
+    // are marked as they're added, which also drops duplicates.
+    std::vector<grfx::SparseImageTile> unbindTiles;
+    for (uint32_t i = 0; i < pBindInfo->unbindTileCount; ++i) {
+        const grfx::SparseImageTile& tile = pBindInfo->pUnbindTiles[i];
+        if (pImage->IsSparseTileResident(tile)) {
+            pImage->SetSparseTileResident(pImage->GetSparseTileIndex(tile), false);
+            unbindTiles.push_back(tile);
+        }
+    }
+
+    std::vector<grfx::SparseImageTile> bindTiles;
+    for (uint32_t i = 0; i < pBindInfo->bindTileCount; ++i) {
+        const grfx::SparseImageTile& tile = pBindInfo->pBindTiles[i];
+        if (!pImage->IsSparseTileResident(tile)) {
+            pImage->SetSparseTileResident(pImage->GetSparseTileIndex(tile), true);
+            bindTiles.push_back(tile);
+        }
+    }
+
+    // Semaphores and fence are still signaled if no residency changed
+    grfx::SparseImageBindInfo bindInfo = *pBindInfo;
+    bindInfo.bindTileCount             = CountU32(bindTiles);
+    bindInfo.pBindTiles                = DataPtr(bindTiles);
+    bindInfo.unbindTileCount           = CountU32(unbindTiles);
+    bindInfo.pUnbindTiles              = DataPtr(unbindTiles);
+
+    Result ppxres = BindSparseImageTilesImpl(&bindInfo);
+    if (Failed(ppxres)) {
+        for (const auto& tile : bindTiles) {
+            pImage->SetSparseTileResident(pImage->GetSparseTileIndex(tile), false);
+        }
+        for (const auto& tile : unbindTiles) {
+            pImage->SetSparseTileResident(pImage->GetSparseTileIndex(tile), true);
+        }
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Queue::GetTimestampOffset(const grfx::Queue* pOtherQueue, double* pSeconds) const
+{
+    if (IsNull(pOtherQueue) || IsNull(pSeconds)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    *pSeconds = 0.0;
+    return ppx::SUCCESS;
+}
+
 } // namespace grfx
 } // namespace ppx
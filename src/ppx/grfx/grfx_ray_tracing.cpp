@@ -12,14 +12,386 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
-#if defined(PPX_ENABLE_RAYTRACING)
-
 #include "ppx/grfx/grfx_ray_tracing.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
 
 namespace ppx {
 namespace grfx {
 
+// -------------------------------------------------------------------------------------------------
+// AccelerationStructure
+// -------------------------------------------------------------------------------------------------
+Result AccelerationStructure::Create(const grfx::AccelerationStructureCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if ((pCreateInfo->type != grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) && (pCreateInfo->type != grfx::ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL)) {
+        PPX_ASSERT_MSG(false, "acceleration structure type must be bottom or top level");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (pCreateInfo->size == 0) {
+        PPX_ASSERT_MSG(false, "acceleration structure size must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::BufferCreateInfo createInfo                       = {};
+    createInfo.size                                         = RoundUp<uint64_t>(pCreateInfo->size, PPX_ACCELERATION_STRUCTURE_ALIGNMENT);
+    createInfo.usageFlags.bits.accelerationStructureStorage = true;
+    createInfo.memoryUsage                                  = grfx::MEMORY_USAGE_GPU_ONLY;
+    createInfo.initialState                                 = grfx::RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE;
+    createInfo.ownership                                    = grfx::OWNERSHIP_REFERENCE;
+
+    Result ppxres = GetDevice()->CreateBuffer(&createInfo, &mBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = grfx::DeviceObject<grfx::AccelerationStructureCreateInfo>::Create(pCreateInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void AccelerationStructure::Destroy()
+{
+    grfx::DeviceObject<grfx::AccelerationStructureCreateInfo>::Destroy();
+
+    if (mBuffer) {
+        GetDevice()->DestroyBuffer(mBuffer);
+        mBuffer.Reset();
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// AccelerationStructureBuilder
+// -------------------------------------------------------------------------------------------------
+Result AccelerationStructureBuilder::CreateApiObjects(const grfx::AccelerationStructureBuilderCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (!GetDevice()->AccelerationStructureSupported()) {
+        PPX_ASSERT_MSG(false, "acceleration structures are not supported by this device");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+    if (pCreateInfo->scratchBudget < PPX_ACCELERATION_STRUCTURE_ALIGNMENT) {
+        PPX_ASSERT_MSG(false, "scratch budget must be at least " << PPX_ACCELERATION_STRUCTURE_ALIGNMENT << " bytes");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Builds larger than the budget get a block of their own
+    grfx::BufferPoolCreateInfo createInfo          = {};
+    createInfo.blockSize                           = pCreateInfo->scratchBudget;
+    createInfo.alignment                           = PPX_ACCELERATION_STRUCTURE_ALIGNMENT;
+    createInfo.usageFlags.bits.rawStorageBuffer    = true;
+    createInfo.usageFlags.bits.shaderDeviceAddress = true;
+    createInfo.memoryUsage                         = grfx::MEMORY_USAGE_GPU_ONLY;
+
+    Result ppxres = GetDevice()->CreateBufferPool(&createInfo, &mScratchPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void AccelerationStructureBuilder::DestroyApiObjects()
+{
+    if (!mPending.empty()) {
+        PPX_LOG_WARN("acceleration structure builder destroyed with " << mPending.size() << " builds still queued");
+    }
+    mPending.clear();
+    mCompactable.clear();
+
+    if (mCompactedSizeQuery) {
+        GetDevice()->DestroyQuery(mCompactedSizeQuery);
+        mCompactedSizeQuery.Reset();
+    }
+
+    if (mScratchPool) {
+        GetDevice()->DestroyBufferPool(mScratchPool);
+        mScratchPool.Reset();
+    }
+}
+
+Result AccelerationStructureBuilder::AddBuild(const grfx::AccelerationStructureBuildInputs& inputs, grfx::AccelerationStructure** ppAccelerationStructure)
+{
+    PPX_ASSERT_NULL_ARG(ppAccelerationStructure);
+
+    grfx::AccelerationStructureBuildSizes sizes  = {};
+    Result                                ppxres = GetDevice()->GetAccelerationStructureBuildSizes(&inputs, &sizes);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::AccelerationStructureCreateInfo createInfo = {};
+    createInfo.type                                  = inputs.type;
+    createInfo.size                                  = sizes.accelerationStructureSize;
+
+    grfx::AccelerationStructurePtr accelerationStructure;
+    ppxres = GetDevice()->CreateAccelerationStructure(&createInfo, &accelerationStructure);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = QueueBuild(inputs, accelerationStructure, false, sizes.buildScratchSize);
+    if (Failed(ppxres)) {
+        GetDevice()->DestroyAccelerationStructure(accelerationStructure);
+        return ppxres;
+    }
+
+    *ppAccelerationStructure = accelerationStructure;
+
+    return ppx::SUCCESS;
+}
+
+Result AccelerationStructureBuilder::AddUpdate(const grfx::AccelerationStructureBuildInputs& inputs, grfx::AccelerationStructure* pAccelerationStructure)
+{
+    PPX_ASSERT_NULL_ARG(pAccelerationStructure);
+
+    if (!inputs.flags.bits.allowUpdate) {
+        PPX_ASSERT_MSG(false, "acceleration structure updates require ALLOW_UPDATE");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+    if (inputs.type != pAccelerationStructure->GetType()) {
+        PPX_ASSERT_MSG(false, "update inputs don't match the acceleration structure type");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::AccelerationStructureBuildSizes sizes  = {};
+    Result                                ppxres = GetDevice()->GetAccelerationStructureBuildSizes(&inputs, &sizes);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return QueueBuild(inputs, pAccelerationStructure, true, sizes.updateScratchSize);
+}
+
+Result AccelerationStructureBuilder::QueueBuild(const grfx::AccelerationStructureBuildInputs& inputs, grfx::AccelerationStructure* pDst, bool update, uint64_t scratchSize)
+{
+    if (inputs.type == grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) {
+        if ((inputs.geometryCount == 0) || IsNull(inputs.pGeometries)) {
+            PPX_ASSERT_MSG(false, "bottom level acceleration structures need at least one geometry");
+            return ppx::ERROR_UNEXPECTED_COUNT_VALUE;
+        }
+        for (uint32_t i = 0; i < inputs.geometryCount; ++i) {
+            if (IsNull(inputs.pGeometries[i].pVertexBuffer)) {
+                PPX_ASSERT_MSG(false, "geometry " << i << " has no vertex buffer");
+                return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+            }
+        }
+    }
+    else if (inputs.type == grfx::ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL) {
+        if (IsNull(inputs.pInstanceBuffer)) {
+            PPX_ASSERT_MSG(false, "top level acceleration structures need an instance buffer");
+            return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+        }
+        if ((inputs.instanceOffset % PPX_ACCELERATION_STRUCTURE_INSTANCE_ALIGNMENT) != 0) {
+            PPX_ASSERT_MSG(false, "instance offset must be " << PPX_ACCELERATION_STRUCTURE_INSTANCE_ALIGNMENT << " byte aligned");
+            return ppx::ERROR_OUT_OF_RANGE;
+        }
+    }
+    else {
+        PPX_ASSERT_MSG(false, "acceleration structure type must be bottom or top level");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Keep a copy of the geometries, the caller's array can go away
+    PendingBuild build = {};
+    build.inputs       = inputs;
+    build.pDst         = pDst;
+    build.update       = update;
+    build.scratchSize  = std::max<uint64_t>(scratchSize, PPX_ACCELERATION_STRUCTURE_ALIGNMENT);
+    if (inputs.type == grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) {
+        build.geometries.assign(inputs.pGeometries, inputs.pGeometries + inputs.geometryCount);
+    }
+    build.inputs.pGeometries = nullptr;
+
+    mPending.push_back(std::move(build));
+
+    return ppx::SUCCESS;
+}
+
+Result AccelerationStructureBuilder::RecordBatches(grfx::CommandBuffer* pCmd, const std::vector<PendingBuild*>& builds)
+{
+    std::vector<grfx::AccelerationStructureBuildInfo> batch;
+    std::vector<grfx::BufferRange>                    scratchRanges;
+    uint64_t                                          batchScratchSize = 0;
+
+    auto flush = [&]() {
+        if (batch.empty()) {
+            return;
+        }
+        pCmd->BuildAccelerationStructures(CountU32(batch), DataPtr(batch));
+        // The next batch reuses the scratch memory of this one
+        pCmd->AccelerationStructureBarrier();
+        for (const auto& range : scratchRanges) {
+            mScratchPool->Free(range);
+        }
+        batch.clear();
+        scratchRanges.clear();
+        batchScratchSize = 0;
+    };
+
+    for (PendingBuild* pBuild : builds) {
+        if (!batch.empty() && ((batchScratchSize + pBuild->scratchSize) > mCreateInfo.scratchBudget)) {
+            flush();
+        }
+
+        grfx::BufferRange range  = {};
+        Result            ppxres = mScratchPool->Allocate(pBuild->scratchSize, PPX_ACCELERATION_STRUCTURE_ALIGNMENT, &range);
+        if (Failed(ppxres)) {
+            flush();
+            return ppxres;
+        }
+        scratchRanges.push_back(range);
+        batchScratchSize += pBuild->scratchSize;
+
+        pBuild->inputs.pGeometries = DataPtr(pBuild->geometries);
+
+        grfx::AccelerationStructureBuildInfo info = {};
+        info.pInputs                              = &pBuild->inputs;
+        info.pDst                                 = pBuild->pDst;
+        info.pSrc                                 = pBuild->update ? pBuild->pDst : nullptr;
+        info.pScratch                             = range.pBuffer;
+        info.scratchOffset                        = range.offset;
+        batch.push_back(info);
+    }
+    flush();
+
+    return ppx::SUCCESS;
+}
+
+Result AccelerationStructureBuilder::EnsureCompactedSizeQuery(uint32_t count)
+{
+    if (mCompactedSizeQuery && (mCompactedSizeQuery->GetCount() >= count)) {
+        return ppx::SUCCESS;
+    }
+
+    if (mCompactedSizeQuery) {
+        GetDevice()->DestroyQuery(mCompactedSizeQuery);
+        mCompactedSizeQuery.Reset();
+    }
+
+    grfx::QueryCreateInfo createInfo = {};
+    createInfo.type                  = grfx::QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE;
+    createInfo.count                 = count;
+
+    Result ppxres = GetDevice()->CreateQuery(&createInfo, &mCompactedSizeQuery);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result AccelerationStructureBuilder::Record(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    mCompactable.clear();
+    if (mPending.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    std::vector<PendingBuild*> bottomLevel;
+    std::vector<PendingBuild*> topLevel;
+    for (auto& build : mPending) {
+        if (build.inputs.type == grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) {
+            bottomLevel.push_back(&build);
+        }
+        else {
+            topLevel.push_back(&build);
+        }
+        if (!build.update && build.inputs.flags.bits.allowCompaction) {
+            mCompactable.push_back(build.pDst);
+        }
+    }
+
+    // Each batch ends with a barrier, so the top level builds see the
+    // finished bottom level structures.
+    Result ppxres = RecordBatches(pCmd, bottomLevel);
+    if (Failed(ppxres)) {
+        mPending.clear();
+        return ppxres;
+    }
+    ppxres = RecordBatches(pCmd, topLevel);
+    mPending.clear();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    if (!mCompactable.empty()) {
+        const uint32_t count = CountU32(mCompactable);
+
+        ppxres = EnsureCompactedSizeQuery(count);
+        if (Failed(ppxres)) {
+            mCompactable.clear();
+            return ppxres;
+        }
+
+        mCompactedSizeQuery->Reset(0, count);
+        pCmd->WriteAccelerationStructureCompactedSizes(count, DataPtr(mCompactable), mCompactedSizeQuery, 0);
+        pCmd->ResolveQueryData(mCompactedSizeQuery, 0, count);
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result AccelerationStructureBuilder::RecordCompaction(
+    grfx::CommandBuffer*                pCmd,
+    uint32_t                            count,
+    grfx::AccelerationStructure* const* ppSrc,
+    grfx::AccelerationStructure**       ppDst)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(ppSrc);
+    PPX_ASSERT_NULL_ARG(ppDst);
+
+    if (count == 0) {
+        return ppx::SUCCESS;
+    }
+    if (mCompactable.empty()) {
+        PPX_ASSERT_MSG(false, "no compactable acceleration structures were built by the last Record()");
+        return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+    }
+
+    std::vector<uint64_t> compactedSizes(mCompactable.size());
+    Result                ppxres = mCompactedSizeQuery->GetData(DataPtr(compactedSizes), SizeInBytesU32(compactedSizes));
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        auto it = std::find(mCompactable.begin(), mCompactable.end(), ppSrc[i]);
+        if (it == mCompactable.end()) {
+            PPX_ASSERT_MSG(false, "acceleration structure " << i << " wasn't built with ALLOW_COMPACTION by the last Record()");
+            return ppx::ERROR_ELEMENT_NOT_FOUND;
+        }
+
+        const uint64_t compactedSize = compactedSizes[static_cast<size_t>(it - mCompactable.begin())];
+        if (compactedSize == 0) {
+            PPX_ASSERT_MSG(false, "compacted size of acceleration structure " << i << " is not available");
+            return ppx::ERROR_FAILED;
+        }
+
+        grfx::AccelerationStructureCreateInfo createInfo = {};
+        createInfo.type                                  = ppSrc[i]->GetType();
+        createInfo.size                                  = compactedSize;
+
+        ppxres = GetDevice()->CreateAccelerationStructure(&createInfo, &ppDst[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        pCmd->CopyAccelerationStructure(ppSrc[i], ppDst[i], true);
+    }
+    pCmd->AccelerationStructureBarrier();
+
+    return ppx::SUCCESS;
+}
+
 } // namespace grfx
 } // namespace ppx
-
-#endif // defined(PPX_ENABLE_RAYTRACING)
\ No newline at end of file
@@ -0,0 +1,563 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_render_graph.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_format.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_render_pass.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace grfx {
+
+// -------------------------------------------------------------------------------------------------
+// RenderGraphPass
+// -------------------------------------------------------------------------------------------------
+void RenderGraphPass::AddRenderTarget(grfx::RenderGraphResource image)
+{
+    PPX_ASSERT_MSG(image.IsValid(), "render graph pass " << mName << " has invalid render target");
+    PPX_ASSERT_MSG(mRenderTargets.size() < PPX_MAX_RENDER_TARGETS, "render graph pass " << mName << " has too many render targets");
+
+    mRenderTargets.push_back(image.index);
+    mAccesses.push_back({image.index, grfx::RESOURCE_STATE_RENDER_TARGET, ACCESS_TYPE_RENDER_TARGET});
+}
+
+void RenderGraphPass::SetDepthStencil(grfx::RenderGraphResource image, grfx::ResourceState state)
+{
+    PPX_ASSERT_MSG(image.IsValid(), "render graph pass " << mName << " has invalid depth stencil");
+    PPX_ASSERT_MSG(mDepthStencil == UINT32_MAX, "render graph pass " << mName << " already has a depth stencil");
+    PPX_ASSERT_MSG((state == grfx::RESOURCE_STATE_DEPTH_STENCIL_READ) || (state == grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE), "invalid depth stencil state");
+
+    mDepthStencil      = image.index;
+    mDepthStencilState = state;
+    mAccesses.push_back({image.index, state, ACCESS_TYPE_DEPTH_STENCIL});
+}
+
+void RenderGraphPass::AddShaderRead(grfx::RenderGraphResource image, grfx::ResourceState state)
+{
+    PPX_ASSERT_MSG(image.IsValid(), "render graph pass " << mName << " has invalid shader read");
+    PPX_ASSERT_MSG(
+        (state == grfx::RESOURCE_STATE_SHADER_RESOURCE) ||
+            (state == grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE) ||
+            (state == grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+        "invalid shader read state");
+
+    mAccesses.push_back({image.index, state, ACCESS_TYPE_SHADER_READ});
+}
+
+void RenderGraphPass::AddStorage(grfx::RenderGraphResource image)
+{
+    PPX_ASSERT_MSG(image.IsValid(), "render graph pass " << mName << " has invalid storage image");
+
+    mAccesses.push_back({image.index, grfx::RESOURCE_STATE_UNORDERED_ACCESS, ACCESS_TYPE_STORAGE});
+}
+
+// -------------------------------------------------------------------------------------------------
+// RenderGraph
+// -------------------------------------------------------------------------------------------------
+static uint64_t EstimateImageSize(const grfx::RenderGraphImageCreateInfo& createInfo)
+{
+    const grfx::FormatDesc* pDesc         = grfx::GetFormatDescription(createInfo.format);
+    uint64_t                bytesPerTexel = IsNull(pDesc) ? 4 : pDesc->bytesPerTexel;
+    return static_cast<uint64_t>(createInfo.width) * createInfo.height * bytesPerTexel * static_cast<uint64_t>(createInfo.sampleCount);
+}
+
+Result RenderGraph::CreateApiObjects(const grfx::RenderGraphCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    return ppx::SUCCESS;
+}
+
+void RenderGraph::DestroyApiObjects()
+{
+    DestroyCompiledObjects();
+    mPasses.clear();
+    mResources.clear();
+}
+
+grfx::RenderGraphResource RenderGraph::AddImage(const grfx::RenderGraphImageCreateInfo& createInfo)
+{
+    PPX_ASSERT_MSG(!mCompiled, "render graph declarations can't change after Compile()");
+    PPX_ASSERT_MSG((createInfo.width > 0) && (createInfo.height > 0), "render graph image size must be non-zero");
+    PPX_ASSERT_MSG(createInfo.format != grfx::FORMAT_UNDEFINED, "render graph image format is undefined");
+
+    ImageResource resource = {};
+    resource.imported      = false;
+    resource.createInfo    = createInfo;
+    mResources.push_back(resource);
+
+    grfx::RenderGraphResource handle = {};
+    handle.index                     = CountU32(mResources) - 1;
+    return handle;
+}
+
+grfx::RenderGraphResource RenderGraph::ImportImage(const grfx::RenderGraphImportInfo& importInfo)
+{
+    PPX_ASSERT_MSG(!mCompiled, "render graph declarations can't change after Compile()");
+
+    ImageResource resource = {};
+    resource.imported      = true;
+    resource.importInfo    = importInfo;
+    resource.image         = importInfo.pImage;
+    mResources.push_back(resource);
+
+    grfx::RenderGraphResource handle = {};
+    handle.index                     = CountU32(mResources) - 1;
+    return handle;
+}
+
+void RenderGraph::SetImportedImage(grfx::RenderGraphResource image, grfx::Image* pImage)
+{
+    PPX_ASSERT_MSG(image.index < CountU32(mResources), "invalid render graph image");
+    PPX_ASSERT_MSG(mResources[image.index].imported, "render graph image isn't imported");
+
+    mResources[image.index].image = pImage;
+}
+
+grfx::RenderGraphPass* RenderGraph::AddPass(const std::string& name)
+{
+    PPX_ASSERT_MSG(!mCompiled, "render graph declarations can't change after Compile()");
+
+    mPasses.push_back(std::make_unique<grfx::RenderGraphPass>(name));
+    return mPasses.back().get();
+}
+
+grfx::ImagePtr RenderGraph::GetImage(grfx::RenderGraphResource image) const
+{
+    PPX_ASSERT_MSG(image.index < CountU32(mResources), "invalid render graph image");
+    return mResources[image.index].image;
+}
+
+Result RenderGraph::Compile()
+{
+    DestroyCompiledObjects();
+
+    Result ppxres = ValidatePasses();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    CullPasses();
+    ComputeLifetimes();
+
+    ppxres = CreateImages();
+    if (Failed(ppxres)) {
+        DestroyCompiledObjects();
+        return ppxres;
+    }
+
+    DeriveAttachmentOps();
+
+    mCompiled = true;
+
+    return ppx::SUCCESS;
+}
+
+Result RenderGraph::ValidatePasses() const
+{
+    const uint32_t resourceCount = CountU32(mResources);
+    for (const auto& pass : mPasses) {
+        std::vector<bool> accessed(resourceCount, false);
+        for (const auto& access : pass->mAccesses) {
+            if (access.resource >= resourceCount) {
+                PPX_ASSERT_MSG(false, "render graph pass " << pass->GetName() << " accesses an unknown image");
+                return ppx::ERROR_OUT_OF_RANGE;
+            }
+            if (accessed[access.resource]) {
+                PPX_ASSERT_MSG(false, "render graph pass " << pass->GetName() << " accesses an image more than once");
+                return ppx::ERROR_DUPLICATE_ELEMENT;
+            }
+            accessed[access.resource] = true;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+void RenderGraph::CullPasses()
+{
+    // Walk backwards from the imported images: a pass is live if it writes
+    // an image that's needed afterwards. Every image a live pass accesses is
+    // then needed from earlier passes, since writes that aren't first in the
+    // frame load the previous contents.
+    std::vector<bool> needed(mResources.size(), false);
+    for (size_t i = 0; i < mResources.size(); ++i) {
+        needed[i] = mResources[i].imported;
+    }
+
+    std::vector<uint32_t> livePasses;
+    for (uint32_t passIndex = CountU32(mPasses); passIndex > 0; --passIndex) {
+        grfx::RenderGraphPass* pPass = mPasses[passIndex - 1].get();
+
+        bool live = pPass->mNeverCull;
+        for (const auto& access : pPass->mAccesses) {
+            live = live || (access.IsWrite() && needed[access.resource]);
+        }
+
+        pPass->mCulled = !live;
+        if (!live) {
+            continue;
+        }
+
+        for (const auto& access : pPass->mAccesses) {
+            needed[access.resource] = true;
+        }
+        livePasses.push_back(passIndex - 1);
+    }
+
+    mLivePasses.assign(livePasses.rbegin(), livePasses.rend());
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+    for (uint32_t passIndex : mLivePasses) {
+        const grfx::RenderGraphPass* pPass = mPasses[passIndex].get();
+        for (const auto& access : pPass->mAccesses) {
+            ImageResource& resource = mResources[access.resource];
+            if (resource.firstPass == UINT32_MAX) {
+                resource.firstPass = passIndex;
+            }
+            resource.lastPass = passIndex;
+
+            // clang-format off
+            switch (access.type) {
+                case grfx::RenderGraphPass::ACCESS_TYPE_RENDER_TARGET : resource.usageFlags.bits.colorAttachment        = true; break;
+                case grfx::RenderGraphPass::ACCESS_TYPE_DEPTH_STENCIL : resource.usageFlags.bits.depthStencilAttachment = true; break;
+                case grfx::RenderGraphPass::ACCESS_TYPE_SHADER_READ   : resource.usageFlags.bits.sampled                = true; break;
+                case grfx::RenderGraphPass::ACCESS_TYPE_STORAGE       : resource.usageFlags.bits.storage                = true; break;
+            }
+            // clang-format on
+        }
+    }
+
+    grfx::ImageUsageFlags attachmentUsage;
+    attachmentUsage.bits.colorAttachment        = true;
+    attachmentUsage.bits.depthStencilAttachment = true;
+
+    for (auto& resource : mResources) {
+        if (resource.imported) {
+            continue;
+        }
+
+        // Contents of an attachment only used by one pass never leave it
+        bool singlePass     = (resource.firstPass != UINT32_MAX) && (resource.firstPass == resource.lastPass);
+        bool attachmentOnly = (resource.usageFlags.flags & ~attachmentUsage.flags) == 0;
+        if (mCreateInfo.enableTransientAttachments && singlePass && attachmentOnly && (resource.createInfo.additionalUsageFlags.flags == 0)) {
+            resource.usageFlags.bits.transientAttachment = true;
+        }
+
+        resource.usageFlags |= resource.createInfo.additionalUsageFlags;
+    }
+}
+
+Result RenderGraph::CreateImages()
+{
+    // Transient images that no live pass accesses aren't created
+    std::vector<uint32_t> order;
+    for (uint32_t i = 0; i < CountU32(mResources); ++i) {
+        if (!mResources[i].imported && (mResources[i].firstPass != UINT32_MAX)) {
+            order.push_back(i);
+        }
+    }
+
+    // Largest first so that the first image in a slot is the one with the
+    // most memory, first fit for the rest.
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        return EstimateImageSize(mResources[a].createInfo) > EstimateImageSize(mResources[b].createInfo);
+    });
+
+    std::vector<std::vector<uint32_t>> slots;
+    for (uint32_t index : order) {
+        const ImageResource& resource  = mResources[index];
+        uint32_t             slotIndex = UINT32_MAX;
+        // Transient attachments have lazily allocated memory which can't be shared
+        if (mCreateInfo.enableAliasing && !resource.usageFlags.bits.transientAttachment) {
+            for (uint32_t i = 0; (i < CountU32(slots)) && (slotIndex == UINT32_MAX); ++i) {
+                const ImageResource& owner      = mResources[slots[i][0]];
+                bool                 compatible = (owner.usageFlags.flags == resource.usageFlags.flags) &&
+                                  (owner.createInfo.sampleCount == resource.createInfo.sampleCount);
+                for (uint32_t other : slots[i]) {
+                    const ImageResource& otherResource = mResources[other];
+                    compatible                         = compatible && ((resource.lastPass < otherResource.firstPass) || (otherResource.lastPass < resource.firstPass));
+                }
+                if (compatible) {
+                    slotIndex = i;
+                }
+            }
+        }
+
+        if (slotIndex == UINT32_MAX) {
+            slots.emplace_back();
+            slotIndex = CountU32(slots) - 1;
+        }
+        slots[slotIndex].push_back(index);
+    }
+
+    for (const auto& slot : slots) {
+        AliasSlot aliasSlot = {};
+        for (size_t i = 0; i < slot.size(); ++i) {
+            ImageResource& resource = mResources[slot[i]];
+
+            grfx::ImageCreateInfo createInfo = {};
+            createInfo.type                  = grfx::IMAGE_TYPE_2D;
+            createInfo.width                 = resource.createInfo.width;
+            createInfo.height                = resource.createInfo.height;
+            createInfo.depth                 = 1;
+            createInfo.format                = resource.createInfo.format;
+            createInfo.sampleCount           = resource.createInfo.sampleCount;
+            createInfo.mipLevelCount         = 1;
+            createInfo.arrayLayerCount       = 1;
+            createInfo.usageFlags            = resource.usageFlags;
+            createInfo.memoryUsage           = grfx::MEMORY_USAGE_GPU_ONLY;
+            createInfo.initialState          = grfx::RESOURCE_STATE_UNDEFINED;
+            createInfo.RTVClearValue         = resource.createInfo.RTVClearValue;
+            createInfo.DSVClearValue         = resource.createInfo.DSVClearValue;
+            createInfo.pAliasImage           = (i > 0) ? mResources[slot[0]].image.Get() : nullptr;
+
+            Result ppxres = GetDevice()->CreateImage(&createInfo, &resource.image);
+            if (Failed(ppxres) && !IsNull(createInfo.pAliasImage)) {
+                // The owner's memory didn't fit, e.g. different alignment or
+                // memory type requirements for this format.
+                PPX_LOG_WARN("render graph image can't alias memory, allocating separately");
+                createInfo.pAliasImage = nullptr;
+                ppxres                 = GetDevice()->CreateImage(&createInfo, &resource.image);
+            }
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "render graph failed creating transient image");
+                return ppxres;
+            }
+
+            ++mTransientImageCount;
+            if ((i == 0) || !IsNull(createInfo.pAliasImage)) {
+                aliasSlot.resources.push_back(slot[i]);
+            }
+        }
+
+        if (aliasSlot.resources.size() > 1) {
+            const uint32_t slotIndex = CountU32(mAliasSlots);
+            for (uint32_t index : aliasSlot.resources) {
+                mResources[index].aliasSlot = slotIndex;
+            }
+            mAliasedImageCount += CountU32(aliasSlot.resources) - 1;
+            mAliasSlots.push_back(aliasSlot);
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+grfx::AttachmentLoadOp RenderGraph::GetLoadOp(uint32_t resourceIndex, uint32_t passIndex) const
+{
+    const ImageResource& resource = mResources[resourceIndex];
+    if (resource.firstPass != passIndex) {
+        return grfx::ATTACHMENT_LOAD_OP_LOAD;
+    }
+
+    if (resource.imported) {
+        if (resource.importInfo.clearOnFirstWrite) {
+            return grfx::ATTACHMENT_LOAD_OP_CLEAR;
+        }
+        return (resource.importInfo.initialState == grfx::RESOURCE_STATE_UNDEFINED) ? grfx::ATTACHMENT_LOAD_OP_DONT_CARE : grfx::ATTACHMENT_LOAD_OP_LOAD;
+    }
+
+    // Aliased memory holds whatever the previous image left behind, which
+    // must be cleared (not just discarded) to be a valid attachment on D3D12.
+    if (resource.createInfo.clearOnFirstWrite || (resource.aliasSlot != UINT32_MAX)) {
+        return grfx::ATTACHMENT_LOAD_OP_CLEAR;
+    }
+    return grfx::ATTACHMENT_LOAD_OP_DONT_CARE;
+}
+
+grfx::AttachmentStoreOp RenderGraph::GetStoreOp(uint32_t resourceIndex, uint32_t passIndex) const
+{
+    // Transient contents don't outlive their last pass
+    const ImageResource& resource = mResources[resourceIndex];
+    if (resource.imported || (resource.lastPass != passIndex)) {
+        return grfx::ATTACHMENT_STORE_OP_STORE;
+    }
+    return grfx::ATTACHMENT_STORE_OP_DONT_CARE;
+}
+
+void RenderGraph::DeriveAttachmentOps()
+{
+    for (uint32_t passIndex : mLivePasses) {
+        grfx::RenderGraphPass* pPass = mPasses[passIndex].get();
+        for (uint32_t i = 0; i < CountU32(pPass->mRenderTargets); ++i) {
+            pPass->mRenderTargetLoadOps[i]  = GetLoadOp(pPass->mRenderTargets[i], passIndex);
+            pPass->mRenderTargetStoreOps[i] = GetStoreOp(pPass->mRenderTargets[i], passIndex);
+        }
+
+        if (pPass->mDepthStencil != UINT32_MAX) {
+            // Read only depth has to come from somewhere
+            bool readOnly               = (pPass->mDepthStencilState == grfx::RESOURCE_STATE_DEPTH_STENCIL_READ);
+            pPass->mDepthStencilLoadOp  = readOnly ? grfx::ATTACHMENT_LOAD_OP_LOAD : GetLoadOp(pPass->mDepthStencil, passIndex);
+            pPass->mDepthStencilStoreOp = GetStoreOp(pPass->mDepthStencil, passIndex);
+        }
+    }
+}
+
+Result RenderGraph::GetRenderPass(grfx::RenderGraphPass* pPass, grfx::RenderPass** ppRenderPass)
+{
+    std::vector<const grfx::Image*> images;
+    for (uint32_t index : pPass->mRenderTargets) {
+        images.push_back(mResources[index].image.Get());
+    }
+    if (pPass->mDepthStencil != UINT32_MAX) {
+        images.push_back(mResources[pPass->mDepthStencil].image.Get());
+    }
+
+    for (const auto& cached : pPass->mRenderPasses) {
+        if (cached.images == images) {
+            *ppRenderPass = cached.renderPass;
+            return ppx::SUCCESS;
+        }
+    }
+
+    grfx::RenderPassCreateInfo3 createInfo = {};
+    createInfo.width                       = images[0]->GetWidth();
+    createInfo.height                      = images[0]->GetHeight();
+    createInfo.renderTargetCount           = CountU32(pPass->mRenderTargets);
+    createInfo.ownership                   = grfx::OWNERSHIP_EXCLUSIVE;
+
+    for (uint32_t i = 0; i < createInfo.renderTargetCount; ++i) {
+        grfx::Image* pImage                   = mResources[pPass->mRenderTargets[i]].image;
+        createInfo.pRenderTargetImages[i]     = pImage;
+        createInfo.renderTargetClearValues[i] = pImage->GetRTVClearValue();
+        createInfo.renderTargetLoadOps[i]     = pPass->mRenderTargetLoadOps[i];
+        createInfo.renderTargetStoreOps[i]    = pPass->mRenderTargetStoreOps[i];
+    }
+
+    if (pPass->mDepthStencil != UINT32_MAX) {
+        grfx::Image* pImage               = mResources[pPass->mDepthStencil].image;
+        createInfo.pDepthStencilImage     = pImage;
+        createInfo.depthStencilState      = pPass->mDepthStencilState;
+        createInfo.depthStencilClearValue = pImage->GetDSVClearValue();
+        createInfo.depthLoadOp            = pPass->mDepthStencilLoadOp;
+        createInfo.depthStoreOp           = pPass->mDepthStencilStoreOp;
+        createInfo.stencilLoadOp          = pPass->mDepthStencilLoadOp;
+        createInfo.stencilStoreOp         = pPass->mDepthStencilStoreOp;
+    }
+
+    grfx::RenderPassPtr renderPass;
+    Result              ppxres = GetDevice()->CreateRenderPass(&createInfo, &renderPass);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    pPass->mRenderPasses.push_back({images, renderPass});
+    *ppRenderPass = renderPass;
+
+    return ppx::SUCCESS;
+}
+
+void RenderGraph::Execute(grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(mCompiled, "render graph must be compiled before it's executed");
+
+    for (auto& resource : mResources) {
+        if (resource.imported && (resource.firstPass != UINT32_MAX)) {
+            PPX_ASSERT_MSG(resource.image, "imported render graph image is null");
+            resource.image->SetTrackedState(resource.importInfo.initialState);
+        }
+    }
+
+    for (uint32_t passIndex : mLivePasses) {
+        grfx::RenderGraphPass* pPass = mPasses[passIndex].get();
+
+        // Hand aliased memory over before the transitions so they still batch
+        for (const auto& access : pPass->mAccesses) {
+            ImageResource& resource = mResources[access.resource];
+            if ((resource.firstPass != passIndex) || (resource.aliasSlot == UINT32_MAX)) {
+                continue;
+            }
+            AliasSlot& slot = mAliasSlots[resource.aliasSlot];
+            if (slot.pLastImage != resource.image.Get()) {
+                pCommandBuffer->AliasingBarrier(slot.pLastImage, resource.image);
+                slot.pLastImage = resource.image;
+            }
+        }
+
+        for (const auto& access : pPass->mAccesses) {
+            pCommandBuffer->TransitionImageState(mResources[access.resource].image, access.state);
+        }
+
+        grfx::RenderPass* pRenderPass = nullptr;
+        if (pPass->HasAttachments()) {
+            Result ppxres = GetRenderPass(pPass, &pRenderPass);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "render graph failed creating render pass for " << pPass->GetName());
+                return;
+            }
+            pCommandBuffer->BeginRenderPass(pRenderPass);
+        }
+
+        if (pPass->mExecuteFn) {
+            pPass->mExecuteFn(pCommandBuffer, pRenderPass);
+        }
+
+        if (!IsNull(pRenderPass)) {
+            pCommandBuffer->EndRenderPass();
+        }
+    }
+
+    for (auto& resource : mResources) {
+        if (resource.imported && (resource.firstPass != UINT32_MAX) && (resource.importInfo.finalState != grfx::RESOURCE_STATE_UNDEFINED)) {
+            pCommandBuffer->TransitionImageState(resource.image, resource.importInfo.finalState);
+        }
+    }
+    pCommandBuffer->FlushBarriers();
+}
+
+void RenderGraph::DestroyCompiledObjects()
+{
+    // Render passes own views of the images, so they go first
+    for (auto& pass : mPasses) {
+        for (auto& cached : pass->mRenderPasses) {
+            GetDevice()->DestroyRenderPass(cached.renderPass);
+        }
+        pass->mRenderPasses.clear();
+        pass->mCulled = false;
+    }
+
+    // Aliasing images before the images owning their memory
+    for (auto& resource : mResources) {
+        if (!resource.imported && resource.image && !IsNull(resource.image->GetAliasImage())) {
+            GetDevice()->DestroyImage(resource.image);
+            resource.image.Reset();
+        }
+    }
+
+    for (auto& resource : mResources) {
+        if (!resource.imported && resource.image) {
+            GetDevice()->DestroyImage(resource.image);
+            resource.image.Reset();
+        }
+        resource.usageFlags = {};
+        resource.firstPass  = UINT32_MAX;
+        resource.lastPass   = UINT32_MAX;
+        resource.aliasSlot  = UINT32_MAX;
+    }
+
+    mLivePasses.clear();
+    mAliasSlots.clear();
+    mTransientImageCount = 0;
+    mAliasedImageCount   = 0;
+    mCompiled            = false;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -186,6 +186,9 @@ RenderPassCreateInfo::RenderPassCreateInfo(const grfx::RenderPassCreateInfo3& ob
         this->V3.pRenderTargetImages[i] = obj.pRenderTargetImages[i];
     }
     this->V3.pDepthStencilImage = obj.pDepthStencilImage;
+    for (uint32_t i = 0; i < this->renderTargetCount; ++i) {
+        this->V3.pResolveImages[i] = obj.pResolveImages[i];
+    }
 
     // Clear values
     for (uint32_t i = 0; i < this->renderTargetCount; ++i) {
@@ -463,6 +466,48 @@ Result RenderPass::CreateImagesAndViewsV3(const grfx::internal::RenderPassCreate
             mHasLoadOpClear |= (dsvCreateInfo.depthLoadOp == grfx::ATTACHMENT_LOAD_OP_CLEAR);
             mHasLoadOpClear |= (dsvCreateInfo.stencilLoadOp == grfx::ATTACHMENT_LOAD_OP_CLEAR);
         }
+
+        // Resolve RTVs
+        mResolveViews.resize(pCreateInfo->renderTargetCount);
+        for (uint32_t i = 0; i < pCreateInfo->renderTargetCount; ++i) {
+            grfx::ImagePtr image = pCreateInfo->V3.pResolveImages[i];
+            if (!image) {
+                continue;
+            }
+
+            const grfx::ImagePtr& renderTarget = mRenderTargetImages[i];
+            if ((renderTarget->GetSampleCount() == grfx::SAMPLE_COUNT_1) || (image->GetSampleCount() != grfx::SAMPLE_COUNT_1)) {
+                PPX_ASSERT_MSG(false, "render target " << i << " must be multisampled and its resolve image single sampled");
+                return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+            }
+            if ((image->GetFormat() != renderTarget->GetFormat()) || (image->GetWidth() != renderTarget->GetWidth()) || (image->GetHeight() != renderTarget->GetHeight())) {
+                PPX_ASSERT_MSG(false, "resolve image " << i << " must have the format and size of its render target");
+                return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+            }
+
+            grfx::RenderTargetViewCreateInfo rtvCreateInfo = {};
+            rtvCreateInfo.pImage                           = image;
+            rtvCreateInfo.imageViewType                    = image->GuessImageViewType();
+            rtvCreateInfo.format                           = image->GetFormat();
+            rtvCreateInfo.mipLevel                         = 0;
+            rtvCreateInfo.mipLevelCount                    = 1;
+            rtvCreateInfo.arrayLayer                       = 0;
+            rtvCreateInfo.arrayLayerCount                  = image->GetArrayLayerCount();
+            rtvCreateInfo.components                       = {};
+            rtvCreateInfo.loadOp                           = grfx::ATTACHMENT_LOAD_OP_DONT_CARE;
+            rtvCreateInfo.storeOp                          = grfx::ATTACHMENT_STORE_OP_STORE;
+            rtvCreateInfo.ownership                        = pCreateInfo->ownership;
+
+            grfx::RenderTargetViewPtr rtv;
+            Result                    ppxres = GetDevice()->CreateRenderTargetView(&rtvCreateInfo, &rtv);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "resolve RTV create failed");
+                return ppxres;
+            }
+
+            mResolveViews[i] = rtv;
+            mHasResolve      = true;
+        }
     }
 
     return ppx::SUCCESS;
@@ -524,6 +569,14 @@ void RenderPass::Destroy()
     mRenderTargetViews.clear();
     mRenderTargetImages.clear();
 
+    // Only the views of resolve images are owned, never the images
+    for (grfx::RenderTargetViewPtr& rtv : mResolveViews) {
+        if (rtv && (rtv->GetOwnership() != grfx::OWNERSHIP_REFERENCE)) {
+            GetDevice()->DestroyRenderTargetView(rtv);
+        }
+    }
+    mResolveViews.clear();
+
     if (mDepthStencilView && (mDepthStencilView->GetOwnership() != grfx::OWNERSHIP_REFERENCE)) {
         GetDevice()->DestroyDepthStencilView(mDepthStencilView);
         mDepthStencilView.Reset();
@@ -613,6 +666,25 @@ uint32_t RenderPass::GetRenderTargetImageIndex(const grfx::Image* pImage) const
     return index;
 }
 
+grfx::RenderTargetViewPtr RenderPass::GetResolveView(uint32_t index) const
+{
+    grfx::RenderTargetViewPtr object;
+    if (IsIndexInRange(index, mResolveViews)) {
+        object = mResolveViews[index];
+    }
+    return object;
+}
+
+grfx::ImagePtr RenderPass::GetResolveImage(uint32_t index) const
+{
+    grfx::ImagePtr            object;
+    grfx::RenderTargetViewPtr rtv = GetResolveView(index);
+    if (rtv) {
+        object = rtv->GetImage();
+    }
+    return object;
+}
+
 Result RenderPass::DisownRenderTargetView(uint32_t index, grfx::RenderTargetView** ppView)
 {
     if (IsIndexInRange(index, mRenderTargetViews)) {
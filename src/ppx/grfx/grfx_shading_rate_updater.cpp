@@ -0,0 +1,498 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_shading_rate_updater.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_pipeline.h"
+#include "ppx/grfx/grfx_shading_rate.h"
+
+#include <array>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in ShadingRateVariance.hlsl
+enum
+{
+    SHADING_RATE_VARIANCE_PARAMS_REGISTER = 0,
+    SHADING_RATE_VARIANCE_SRC_REGISTER    = 1,
+    SHADING_RATE_VARIANCE_DST_REGISTER    = 2,
+};
+
+// Must match ShadingRateVariance.hlsl
+struct ShadingRateVarianceParams
+{
+    uint32_t srcSize[2];
+    uint32_t texelSize[2];
+    uint32_t attachmentSize[2];
+    float    srcScale[2];
+};
+
+ShadingRateUpdater::ShadingRateUpdater()
+{
+}
+
+ShadingRateUpdater::~ShadingRateUpdater()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    for (auto& it : mSources) {
+        mDevice->FreeDescriptorSet(it.second.set);
+        mDevice->DestroySampledImageView(it.second.view);
+    }
+    mSources.clear();
+
+    for (auto& frame : mFrames) {
+        if (frame.staging) {
+            if (!IsNull(frame.pStagingAddress)) {
+                frame.staging->UnmapMemory();
+            }
+            mDevice->DestroyBuffer(frame.staging);
+        }
+        if (frame.readback) {
+            if (!IsNull(frame.pReadbackAddress)) {
+                frame.readback->UnmapMemory();
+            }
+            mDevice->DestroyBuffer(frame.readback);
+        }
+    }
+    mFrames.clear();
+
+    if (mPipeline) {
+        mDevice->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        mDevice->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mVarianceBuffer) {
+        mDevice->DestroyBuffer(mVarianceBuffer);
+        mVarianceBuffer.Reset();
+    }
+}
+
+Result ShadingRateUpdater::Create(grfx::Device* pDevice, const grfx::ShadingRateUpdaterCreateInfo& createInfo, grfx::ShadingRateUpdater** ppUpdater)
+{
+    if (IsNull(pDevice) || IsNull(ppUpdater) || IsNull(createInfo.pPattern)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.frameCount == 0) || (createInfo.lowVariance > createInfo.highVariance)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (!IsNull(createInfo.pShader) && (createInfo.maxSourceImages == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    grfx::ShadingRateUpdater* pUpdater = new grfx::ShadingRateUpdater();
+    if (IsNull(pUpdater)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    Result ppxres = pUpdater->Initialize(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pUpdater;
+        return ppxres;
+    }
+
+    *ppUpdater = pUpdater;
+
+    return ppx::SUCCESS;
+}
+
+Result ShadingRateUpdater::Initialize(grfx::Device* pDevice, const grfx::ShadingRateUpdaterCreateInfo& createInfo)
+{
+    mDevice     = pDevice;
+    mCreateInfo = createInfo;
+
+    const grfx::ShadingRatePattern* pPattern = createInfo.pPattern;
+    const uint32_t                  width    = pPattern->GetAttachmentWidth();
+    const uint32_t                  height   = pPattern->GetAttachmentHeight();
+
+    // D3D12 requires buffer rows of image copies to be 256 byte aligned
+    const uint32_t pixelStride  = Bitmap::ChannelCount(pPattern->GetBitmapFormat()) * Bitmap::ChannelSize(pPattern->GetBitmapFormat());
+    const uint32_t rowAlignment = grfx::IsDx12(pDevice->GetApi()) ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
+    mStagingRowStride           = RoundUp<uint32_t>(width * pixelStride, rowAlignment);
+
+    mFrames.resize(createInfo.frameCount);
+    for (auto& frame : mFrames) {
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = static_cast<uint64_t>(mStagingRowStride) * height;
+        bufferCreateInfo.usageFlags.bits.transferSrc = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+
+        Result ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &frame.staging);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pStagingAddress = nullptr;
+        ppxres                = frame.staging->MapMemory(0, &pStagingAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        frame.pStagingAddress = static_cast<uint8_t*>(pStagingAddress);
+    }
+
+    if (!IsNull(createInfo.pShader)) {
+        Result ppxres = InitializeContent(pDevice, createInfo);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ShadingRateUpdater::InitializeContent(grfx::Device* pDevice, const grfx::ShadingRateUpdaterCreateInfo& createInfo)
+{
+    const uint64_t varianceSize = static_cast<uint64_t>(createInfo.pPattern->GetAttachmentWidth()) * createInfo.pPattern->GetAttachmentHeight() * sizeof(float);
+
+    grfx::BufferCreateInfo bufferCreateInfo             = {};
+    bufferCreateInfo.size                               = varianceSize;
+    bufferCreateInfo.structuredElementStride            = sizeof(float);
+    bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+    bufferCreateInfo.usageFlags.bits.transferSrc        = true;
+    bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+    bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_COPY_SRC;
+
+    Result ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mVarianceBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (auto& frame : mFrames) {
+        bufferCreateInfo                             = {};
+        bufferCreateInfo.size                        = varianceSize;
+        bufferCreateInfo.usageFlags.bits.transferDst = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &frame.readback);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pReadbackAddress = nullptr;
+        ppxres                 = frame.readback->MapMemory(0, &pReadbackAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        frame.pReadbackAddress = static_cast<const float*>(pReadbackAddress);
+    }
+
+    grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+    poolCreateInfo.sampledImage                   = createInfo.maxSourceImages;
+    poolCreateInfo.structuredBuffer               = createInfo.maxSourceImages;
+
+    ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(SHADING_RATE_VARIANCE_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+    layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(SHADING_RATE_VARIANCE_DST_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+
+    ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+    piCreateInfo.setCount                          = 1;
+    piCreateInfo.sets[0].set                       = 0;
+    piCreateInfo.sets[0].pLayout                   = mSetLayout;
+    piCreateInfo.pushConstants.count               = sizeof(ShadingRateVarianceParams) / sizeof(uint32_t);
+    piCreateInfo.pushConstants.binding             = SHADING_RATE_VARIANCE_PARAMS_REGISTER;
+    piCreateInfo.pushConstants.set                 = 0;
+
+    ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mPipelineInterface);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+    cpCreateInfo.CS                              = {createInfo.pShader, "csmain"};
+    cpCreateInfo.pPipelineInterface              = mPipelineInterface;
+
+    ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipeline);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+uint32_t ShadingRateUpdater::CalculateFragmentSize(float focusDistance2, float variance, float lowVariance, float highVariance)
+{
+    // Same falloff as FillShadingRateRadial(), snapped to 1, 2 or 4
+    uint32_t focusSize = 1;
+    if (focusDistance2 >= 3.0f) {
+        focusSize = 4;
+    }
+    else if (focusDistance2 >= 1.0f) {
+        focusSize = 2;
+    }
+
+    uint32_t contentSize = 1;
+    if (variance >= 0.0f) {
+        if (variance < lowVariance) {
+            contentSize = 4;
+        }
+        else if (variance < highVariance) {
+            contentSize = 2;
+        }
+    }
+
+    return std::max(focusSize, contentSize);
+}
+
+void ShadingRateUpdater::SetFocus(float x, float y)
+{
+    const float2 focus = float2(x, y);
+    if (!mFocus.has_value() || (mFocus.value() != focus)) {
+        mFocus = focus;
+        mDirty = true;
+    }
+}
+
+void ShadingRateUpdater::ClearFocus()
+{
+    if (mFocus.has_value()) {
+        mFocus.reset();
+        mDirty = true;
+    }
+}
+
+void ShadingRateUpdater::ResetContent()
+{
+    for (auto& frame : mFrames) {
+        frame.hasContent = false;
+    }
+    if (!mVariance.empty()) {
+        mVariance.clear();
+        mDirty = true;
+    }
+}
+
+Result ShadingRateUpdater::Update(grfx::CommandBuffer* pCmd, uint32_t frameIndex)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    if (frameIndex >= CountU32(mFrames)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    mFrameIndex = frameIndex;
+
+    grfx::ShadingRatePattern* pPattern = mCreateInfo.pPattern;
+    const uint32_t            width    = pPattern->GetAttachmentWidth();
+    const uint32_t            height   = pPattern->GetAttachmentHeight();
+
+    Frame& frame = mFrames[frameIndex];
+    if (frame.hasContent) {
+        mVariance.assign(frame.pReadbackAddress, frame.pReadbackAddress + (width * height));
+        frame.hasContent = false;
+        mDirty           = true;
+    }
+
+    // The attachment image still holds the last upload
+    if (!mDirty) {
+        return ppx::SUCCESS;
+    }
+    mDirty = false;
+
+    const grfx::ShadingRateEncoder* pEncoder    = pPattern->GetShadingRateEncoder();
+    const uint32_t                  pixelStride = Bitmap::ChannelCount(pPattern->GetBitmapFormat()) * Bitmap::ChannelSize(pPattern->GetBitmapFormat());
+    const float                     scale       = mCreateInfo.foveationScale / std::min<uint32_t>(width, height);
+
+    // Encodings of the 1x1, 2x2 and 4x4 fragment sizes
+    std::array<uint32_t, 5> encoded = {};
+    for (uint32_t size = 1; size <= 4; size *= 2) {
+        encoded[size] = pEncoder->EncodeFragmentSize(size, size);
+    }
+
+    for (uint32_t j = 0; j < height; ++j) {
+        uint8_t* pDst = frame.pStagingAddress + (j * mStagingRowStride);
+        for (uint32_t i = 0; i < width; ++i, pDst += pixelStride) {
+            float focusDistance2 = 0.0f;
+            if (mFocus.has_value()) {
+                const float x  = scale * (2.0f * i - 2.0f * mFocus->x * width);
+                const float y  = scale * (2.0f * j - 2.0f * mFocus->y * height);
+                focusDistance2 = x * x + y * y;
+            }
+            const float    variance = mVariance.empty() ? -1.0f : mVariance[j * width + i];
+            const uint32_t size     = CalculateFragmentSize(focusDistance2, variance, mCreateInfo.lowVariance, mCreateInfo.highVariance);
+            memcpy(pDst, &encoded[size], pixelStride);
+        }
+    }
+
+    grfx::Image* pImage = pPattern->GetAttachmentImage();
+
+    grfx::BufferToImageCopyInfo copyInfo = {};
+    copyInfo.srcBuffer.imageWidth        = width;
+    copyInfo.srcBuffer.imageHeight       = height;
+    copyInfo.srcBuffer.imageRowStride    = mStagingRowStride;
+    copyInfo.srcBuffer.footprintOffset   = 0;
+    copyInfo.srcBuffer.footprintWidth    = width;
+    copyInfo.srcBuffer.footprintHeight   = height;
+    copyInfo.srcBuffer.footprintDepth    = 1;
+    copyInfo.dstImage.mipLevel           = 0;
+    copyInfo.dstImage.arrayLayer         = 0;
+    copyInfo.dstImage.arrayLayerCount    = 1;
+    copyInfo.dstImage.width              = width;
+    copyInfo.dstImage.height             = height;
+    copyInfo.dstImage.depth              = 1;
+
+    pCmd->TransitionImageState(pImage, grfx::RESOURCE_STATE_COPY_DST);
+    pCmd->CopyBufferToImage(&copyInfo, frame.staging, pImage);
+    pCmd->TransitionImageState(pImage, pImage->GetInitialState());
+    pCmd->FlushBarriers();
+
+    return ppx::SUCCESS;
+}
+
+Result ShadingRateUpdater::GetSource(grfx::Image* pSrcImage, Source** ppSource)
+{
+    auto it = mSources.find(pSrcImage);
+    if (it != mSources.end()) {
+        *ppSource = &it->second;
+        return ppx::SUCCESS;
+    }
+
+    if (CountU32(mSources) >= mCreateInfo.maxSourceImages) {
+        PPX_ASSERT_MSG(false, "ShadingRateUpdater: more distinct source images than ShadingRateUpdaterCreateInfo::maxSourceImages");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    Source source = {};
+
+    grfx::SampledImageViewCreateInfo viewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(pSrcImage);
+    viewCreateInfo.mipLevelCount                    = 1;
+
+    Result ppxres = mDevice->CreateSampledImageView(&viewCreateInfo, &source.view);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &source.set);
+    if (Failed(ppxres)) {
+        mDevice->DestroySampledImageView(source.view);
+        return ppxres;
+    }
+
+    std::array<grfx::WriteDescriptor, 2> writes = {};
+    writes[0].binding                           = SHADING_RATE_VARIANCE_SRC_REGISTER;
+    writes[0].type                              = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageView                        = source.view;
+    writes[1].binding                           = SHADING_RATE_VARIANCE_DST_REGISTER;
+    writes[1].type                              = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+    writes[1].bufferOffset                      = 0;
+    writes[1].bufferRange                       = PPX_WHOLE_SIZE;
+    writes[1].structuredElementCount            = mCreateInfo.pPattern->GetAttachmentWidth() * mCreateInfo.pPattern->GetAttachmentHeight();
+    writes[1].pBuffer                           = mVarianceBuffer;
+
+    ppxres = source.set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        mDevice->FreeDescriptorSet(source.set);
+        mDevice->DestroySampledImageView(source.view);
+        return ppxres;
+    }
+
+    *ppSource = &mSources.emplace(pSrcImage, source).first->second;
+
+    return ppx::SUCCESS;
+}
+
+Result ShadingRateUpdater::AnalyzeContent(grfx::CommandBuffer* pCmd, grfx::Image* pSrcImage, grfx::ResourceState srcState)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pSrcImage);
+
+    if (!mPipeline) {
+        PPX_ASSERT_MSG(false, "ShadingRateUpdater: content analysis needs ShadingRateUpdaterCreateInfo::pShader");
+        return ppx::ERROR_FAILED;
+    }
+    if (mFrameIndex >= CountU32(mFrames)) {
+        PPX_ASSERT_MSG(false, "ShadingRateUpdater: AnalyzeContent() called before Update()");
+        return ppx::ERROR_FAILED;
+    }
+
+    Source* pSource = nullptr;
+    Result  ppxres  = GetSource(pSrcImage, &pSource);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const grfx::ShadingRatePattern* pPattern = mCreateInfo.pPattern;
+    const uint32_t                  width    = pPattern->GetAttachmentWidth();
+    const uint32_t                  height   = pPattern->GetAttachmentHeight();
+
+    ShadingRateVarianceParams params = {};
+    params.srcSize[0]                = pSrcImage->GetWidth();
+    params.srcSize[1]                = pSrcImage->GetHeight();
+    params.texelSize[0]              = pPattern->GetTexelWidth();
+    params.texelSize[1]              = pPattern->GetTexelHeight();
+    params.attachmentSize[0]         = width;
+    params.attachmentSize[1]         = height;
+    params.srcScale[0]               = static_cast<float>(pSrcImage->GetWidth()) / (width * pPattern->GetTexelWidth());
+    params.srcScale[1]               = static_cast<float>(pSrcImage->GetHeight()) / (height * pPattern->GetTexelHeight());
+
+    pCmd->FlushBarriers();
+    pCmd->TransitionImageLayout(pSrcImage, PPX_ALL_SUBRESOURCES, srcState, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCmd->TransitionBufferState(mVarianceBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->FlushBarriers();
+
+    const grfx::DescriptorSet* pSet = pSource->set.Get();
+    pCmd->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCmd->BindComputePipeline(mPipeline);
+    pCmd->PushComputeConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+    pCmd->Dispatch(width, height, 1);
+
+    Frame& frame = mFrames[mFrameIndex];
+
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = static_cast<uint64_t>(width) * height * sizeof(float);
+
+    pCmd->TransitionBufferState(mVarianceBuffer, grfx::RESOURCE_STATE_COPY_SRC);
+    pCmd->CopyBufferToBuffer(&copyInfo, mVarianceBuffer, frame.readback);
+    pCmd->FlushBarriers();
+    pCmd->TransitionImageLayout(pSrcImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, srcState);
+
+    frame.hasContent = true;
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -32,16 +32,21 @@ void FillShadingRateUniformFragmentDensity(ShadingRatePatternPtr pattern, uint32
 }
 
 void FillShadingRateRadial(ShadingRatePatternPtr pattern, float scale, Bitmap* bitmap)
+{
+    FillShadingRateRadial(pattern, scale, 0.5f, 0.5f, bitmap);
+}
+
+void FillShadingRateRadial(ShadingRatePatternPtr pattern, float scale, float centerX, float centerY, Bitmap* bitmap)
 {
     auto encoder = pattern->GetShadingRateEncoder();
     scale /= std::min<uint32_t>(bitmap->GetWidth(), bitmap->GetHeight());
     for (uint32_t j = 0; j < bitmap->GetHeight(); ++j) {
-        float    y    = scale * (2.0 * j - bitmap->GetHeight());
+        float    y    = scale * (2.0 * j - 2.0 * centerY * bitmap->GetHeight());
         uint8_t* addr = bitmap->GetPixel8u(0, j);
         for (uint32_t i = 0; i < bitmap->GetWidth(); ++i, addr += bitmap->GetPixelStride()) {
-            float          x            = scale * (2.0 * i - bitmap->GetWidth());
-            float          r2           = x * x + y * y;
-            uint32_t       encoded      = encoder->EncodeFragmentSize(r2 + 1, r2 + 1);
+            float          x            = scale * (2.0 * i - 2.0 * centerX * bitmap->GetWidth());
+            float          size         = std::min(x * x + y * y + 1.0f, 255.0f); // Off center foci reach further
+            uint32_t       encoded      = encoder->EncodeFragmentSize(size, size);
             const uint8_t* encodedBytes = reinterpret_cast<const uint8_t*>(&encoded);
             for (uint32_t k = 0; k < bitmap->GetChannelCount(); ++k) {
                 addr[k] = encodedBytes[k];
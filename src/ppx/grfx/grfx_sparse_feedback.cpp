@@ -0,0 +1,187 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_sparse_feedback.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_queue.h"
+
+namespace ppx {
+namespace grfx {
+
+Result SparseImageFeedback::CreateApiObjects(const grfx::SparseImageFeedbackCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->pImage)) {
+        PPX_ASSERT_MSG(false, "sparse feedback needs the image it reports on");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (!pCreateInfo->pImage->GetSparseResidency() || (pCreateInfo->pImage->GetSparseTileCount() == 0)) {
+        PPX_ASSERT_MSG(false, "sparse feedback image must be sparse resident and have tiles outside of the mip tail");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (pCreateInfo->frameCount == 0) {
+        PPX_ASSERT_MSG(false, "sparse feedback frame count must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    const grfx::Image*                 pImage     = pCreateInfo->pImage;
+    const grfx::SparseImageProperties& properties = pImage->GetSparseProperties();
+    const uint32_t                     tileCount  = pImage->GetSparseTileCount();
+    const uint64_t                     bufferSize = tileCount * sizeof(uint32_t);
+
+    mConstants.width             = pImage->GetWidth();
+    mConstants.height            = pImage->GetHeight();
+    mConstants.tileWidth         = properties.tileWidth;
+    mConstants.tileHeight        = properties.tileHeight;
+    mConstants.firstMipTailLevel = std::min(properties.firstMipTailLevel, pImage->GetMipLevelCount());
+    mConstants.tilesPerLayer     = tileCount / pImage->GetArrayLayerCount();
+
+    // Flags written by shaders
+    {
+        grfx::BufferCreateInfo createInfo             = {};
+        createInfo.size                               = bufferSize;
+        createInfo.structuredElementStride            = sizeof(uint32_t);
+        createInfo.usageFlags.bits.rwStructuredBuffer = true;
+        createInfo.usageFlags.bits.transferSrc        = true;
+        createInfo.usageFlags.bits.transferDst        = true;
+        createInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.initialState                       = grfx::RESOURCE_STATE_COPY_DST;
+
+        Result ppxres = GetDevice()->CreateBuffer(&createInfo, &mFeedbackBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Source of the clears, there's no fill command in grfx
+    {
+        grfx::BufferCreateInfo createInfo      = {};
+        createInfo.size                        = bufferSize;
+        createInfo.usageFlags.bits.transferSrc = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+
+        Result ppxres = GetDevice()->CreateBuffer(&createInfo, &mZeroBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pMappedAddress = nullptr;
+        ppxres               = mZeroBuffer->MapMemory(0, &pMappedAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        memset(pMappedAddress, 0, static_cast<size_t>(bufferSize));
+        mZeroBuffer->UnmapMemory();
+    }
+
+    mReadbackBuffers.resize(pCreateInfo->frameCount);
+    mReadbackRecorded.assign(pCreateInfo->frameCount, false);
+    for (auto& readbackBuffer : mReadbackBuffers) {
+        grfx::BufferCreateInfo createInfo      = {};
+        createInfo.size                        = bufferSize;
+        createInfo.usageFlags.bits.transferDst = true;
+        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        createInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+
+        Result ppxres = GetDevice()->CreateBuffer(&createInfo, &readbackBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Start with no tiles sampled
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = bufferSize;
+
+    Result ppxres = GetDevice()->GetGraphicsQueue()->CopyBufferToBuffer(&copyInfo, mZeroBuffer, mFeedbackBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void SparseImageFeedback::DestroyApiObjects()
+{
+    for (auto& readbackBuffer : mReadbackBuffers) {
+        if (readbackBuffer) {
+            GetDevice()->DestroyBuffer(readbackBuffer);
+        }
+    }
+    mReadbackBuffers.clear();
+    mReadbackRecorded.clear();
+
+    if (mZeroBuffer) {
+        GetDevice()->DestroyBuffer(mZeroBuffer);
+        mZeroBuffer.Reset();
+    }
+    if (mFeedbackBuffer) {
+        GetDevice()->DestroyBuffer(mFeedbackBuffer);
+        mFeedbackBuffer.Reset();
+    }
+}
+
+void SparseImageFeedback::RecordReadback(uint32_t frameIndex, grfx::CommandBuffer* pCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mReadbackBuffers), "sparse feedback frame index out of range");
+
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = mFeedbackBuffer->GetSize();
+
+    pCommandBuffer->BufferResourceBarrier(mFeedbackBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_COPY_SRC);
+    pCommandBuffer->CopyBufferToBuffer(&copyInfo, mFeedbackBuffer, mReadbackBuffers[frameIndex]);
+    pCommandBuffer->BufferResourceBarrier(mFeedbackBuffer, grfx::RESOURCE_STATE_COPY_SRC, grfx::RESOURCE_STATE_COPY_DST);
+    pCommandBuffer->CopyBufferToBuffer(&copyInfo, mZeroBuffer, mFeedbackBuffer);
+    pCommandBuffer->BufferResourceBarrier(mFeedbackBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+
+    mReadbackRecorded[frameIndex] = true;
+}
+
+Result SparseImageFeedback::GetSampledTiles(uint32_t frameIndex, std::vector<grfx::SparseImageTile>* pTiles)
+{
+    PPX_ASSERT_NULL_ARG(pTiles);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mReadbackBuffers), "sparse feedback frame index out of range");
+
+    pTiles->clear();
+    if (!mReadbackRecorded[frameIndex]) {
+        return ppx::SUCCESS;
+    }
+
+    grfx::Buffer* pReadbackBuffer = mReadbackBuffers[frameIndex];
+    void*         pMappedAddress  = nullptr;
+
+    Result ppxres = pReadbackBuffer->MapMemory(0, &pMappedAddress);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const uint32_t* pFlags    = static_cast<const uint32_t*>(pMappedAddress);
+    const uint32_t  tileCount = GetImage()->GetSparseTileCount();
+    for (uint32_t i = 0; i < tileCount; ++i) {
+        if (pFlags[i] != 0) {
+            pTiles->push_back(GetImage()->GetSparseTile(i));
+        }
+    }
+
+    pReadbackBuffer->UnmapMemory();
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -0,0 +1,75 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/grfx/grfx_submit_batcher.h"
+
+namespace ppx {
+namespace grfx {
+
+SubmitBatcher::SubmitBatcher(grfx::Queue* pQueue)
+    : mQueue(pQueue)
+{
+}
+
+SubmitBatcher::~SubmitBatcher()
+{
+    PPX_ASSERT_MSG(mPendingCount == 0, "submit batcher destroyed with pending submits");
+}
+
+void SubmitBatcher::SetQueue(grfx::Queue* pQueue)
+{
+    PPX_ASSERT_MSG(mPendingCount == 0, "can't change the queue of a submit batcher with pending submits");
+    mQueue = pQueue;
+}
+
+void SubmitBatcher::Add(const grfx::SubmitInfo* pSubmitInfo)
+{
+    PPX_ASSERT_NULL_ARG(pSubmitInfo);
+
+    if (mPendingCount == CountU32(mPending)) {
+        mPending.emplace_back();
+    }
+    PendingSubmit& pending = mPending[mPendingCount];
+    ++mPendingCount;
+
+    pending.commandBuffers.assign(pSubmitInfo->ppCommandBuffers, pSubmitInfo->ppCommandBuffers + pSubmitInfo->commandBufferCount);
+    pending.waitSemaphores.assign(pSubmitInfo->ppWaitSemaphores, pSubmitInfo->ppWaitSemaphores + pSubmitInfo->waitSemaphoreCount);
+    pending.signalSemaphores.assign(pSubmitInfo->ppSignalSemaphores, pSubmitInfo->ppSignalSemaphores + pSubmitInfo->signalSemaphoreCount);
+
+    // Points at the copies, values are copied along with the info
+    pending.submitInfo                    = *pSubmitInfo;
+    pending.submitInfo.ppCommandBuffers   = DataPtr(pending.commandBuffers);
+    pending.submitInfo.ppWaitSemaphores   = DataPtr(pending.waitSemaphores);
+    pending.submitInfo.ppSignalSemaphores = DataPtr(pending.signalSemaphores);
+}
+
+Result SubmitBatcher::Flush()
+{
+    if (mPendingCount == 0) {
+        return ppx::SUCCESS;
+    }
+    PPX_ASSERT_NULL_ARG(mQueue);
+
+    mSubmitInfos.clear();
+    for (uint32_t i = 0; i < mPendingCount; ++i) {
+        mSubmitInfos.push_back(mPending[i].submitInfo);
+    }
+    mPendingCount = 0;
+
+    return mQueue->SubmitBatch(CountU32(mSubmitInfos), DataPtr(mSubmitInfos));
+}
+
+} // namespace grfx
+} // namespace ppx
@@ -96,14 +96,6 @@ Result Swapchain::Create(const grfx::SwapchainCreateInfo* pCreateInfo)
         // Set mCurrentImageIndex to (imageCount - 1) so that the first
         // AcquireNextImage call acquires the first image at index 0.
         mCurrentImageIndex = mCreateInfo.imageCount - 1;
-
-        // Create command buffers to signal and wait semaphores at
-        // AcquireNextImage and Present calls.
-        for (uint32_t i = 0; i < mCreateInfo.imageCount; ++i) {
-            grfx::CommandBufferPtr commandBuffer = nullptr;
-            mCreateInfo.pQueue->CreateCommandBuffer(&commandBuffer, 0, 0);
-            mHeadlessCommandBuffers.push_back(commandBuffer);
-        }
     }
 
     PPX_LOG_INFO("Swapchain created");
@@ -119,6 +111,17 @@ void Swapchain::Destroy()
 {
     DestroyRenderPasses();
 
+#if defined(PPX_BUILD_XR)
+    for (auto& elem : mXrFoveationPatterns) {
+        GetDevice()->DestroyShadingRatePattern(elem);
+    }
+    mXrFoveationPatterns.clear();
+    for (auto& elem : mXrFoveationImages) {
+        GetDevice()->DestroyImage(elem);
+    }
+    mXrFoveationImages.clear();
+#endif
+
     DestroyRenderTargets();
 
     DestroyDepthImages();
@@ -134,13 +137,6 @@ void Swapchain::Destroy()
     }
 #endif
 
-    for (auto& elem : mHeadlessCommandBuffers) {
-        if (elem) {
-            mCreateInfo.pQueue->DestroyCommandBuffer(elem);
-        }
-    }
-    mHeadlessCommandBuffers.clear();
-
     grfx::DeviceObject<grfx::SwapchainCreateInfo>::Destroy();
 }
 
@@ -163,6 +159,11 @@ Result Swapchain::CreateDepthImages()
             dpCreateInfo.arrayLayerCount       = mCreateInfo.arrayLayerCount;
             dpCreateInfo.DSVClearValue         = {1.0f, 0xFF};
 
+            if (mCreateInfo.transientDepthImages) {
+                dpCreateInfo.usageFlags.bits.sampled             = false;
+                dpCreateInfo.usageFlags.bits.transientAttachment = true;
+            }
+
             grfx::ImagePtr depthStencilTarget;
             auto           ppxres = GetDevice()->CreateImage(&dpCreateInfo, &depthStencilTarget);
             if (Failed(ppxres)) {
@@ -246,6 +247,16 @@ Result Swapchain::CreateRenderTargets()
     return ppx::SUCCESS;
 }
 
+grfx::ShadingRatePattern* Swapchain::GetShadingRatePattern(size_t imageIndex) const
+{
+#if defined(PPX_BUILD_XR)
+    if (!mXrFoveationPatterns.empty()) {
+        return mXrFoveationPatterns[imageIndex];
+    }
+#endif
+    return mCreateInfo.pShadingRatePattern;
+}
+
 Result Swapchain::CreateRenderPasses()
 {
     uint32_t imageCount = CountU32(mColorImages);
@@ -262,7 +273,7 @@ Result Swapchain::CreateRenderPasses()
         rpCreateInfo.renderTargetClearValues[0] = {{0.0f, 0.0f, 0.0f, 0.0f}};
         rpCreateInfo.depthStencilClearValue     = {1.0f, 0xFF};
         rpCreateInfo.ownership                  = grfx::OWNERSHIP_RESTRICTED;
-        rpCreateInfo.pShadingRatePattern        = mCreateInfo.pShadingRatePattern;
+        rpCreateInfo.pShadingRatePattern        = GetShadingRatePattern(i);
         rpCreateInfo.arrayLayerCount            = mCreateInfo.arrayLayerCount;
 #if defined(PPX_BUILD_XR)
         if (mCreateInfo.pXrComponent && mCreateInfo.arrayLayerCount > 1) {
@@ -292,7 +303,7 @@ Result Swapchain::CreateRenderPasses()
         rpCreateInfo.renderTargetClearValues[0] = {{0.0f, 0.0f, 0.0f, 0.0f}};
         rpCreateInfo.depthStencilClearValue     = {1.0f, 0xFF};
         rpCreateInfo.ownership                  = grfx::OWNERSHIP_RESTRICTED;
-        rpCreateInfo.pShadingRatePattern        = mCreateInfo.pShadingRatePattern;
+        rpCreateInfo.pShadingRatePattern        = GetShadingRatePattern(i);
 #if defined(PPX_BUILD_XR)
         if (mCreateInfo.pXrComponent && mCreateInfo.arrayLayerCount > 1) {
             rpCreateInfo.multiViewState.viewMask = mCreateInfo.pXrComponent->GetDefaultViewMask();
@@ -511,37 +522,32 @@ Result Swapchain::AcquireNextImageHeadless(uint64_t timeout, grfx::Semaphore* pS
     *pImageIndex       = (mCurrentImageIndex + 1u) % CountU32(mColorImages);
     mCurrentImageIndex = *pImageIndex;
 
-    grfx::CommandBufferPtr commandBuffer = mHeadlessCommandBuffers[mCurrentImageIndex];
-
-    commandBuffer->Begin();
-    commandBuffer->End();
+    // Images are available right away, an empty submit signals the caller's
+    // semaphore and fence without recording anything
+    if (IsNull(pSemaphore) && IsNull(pFence)) {
+        return ppx::SUCCESS;
+    }
 
     grfx::SubmitInfo sInfo     = {};
-    sInfo.ppCommandBuffers     = &commandBuffer;
-    sInfo.commandBufferCount   = 1;
+    sInfo.commandBufferCount   = 0;
     sInfo.pFence               = pFence;
     sInfo.ppSignalSemaphores   = &pSemaphore;
-    sInfo.signalSemaphoreCount = 1;
-    mCreateInfo.pQueue->Submit(&sInfo);
-
-    return ppx::SUCCESS;
+    sInfo.signalSemaphoreCount = IsNull(pSemaphore) ? 0 : 1;
+    return mCreateInfo.pQueue->Submit(&sInfo);
 }
 
 Result Swapchain::PresentHeadless(uint32_t imageIndex, uint32_t waitSemaphoreCount, const grfx::Semaphore* const* ppWaitSemaphores)
 {
-    grfx::CommandBufferPtr commandBuffer = mHeadlessCommandBuffers[mCurrentImageIndex];
-
-    commandBuffer->Begin();
-    commandBuffer->End();
+    // Nothing is presented, the wait only unsignals the caller's semaphores
+    if (waitSemaphoreCount == 0) {
+        return ppx::SUCCESS;
+    }
 
     grfx::SubmitInfo sInfo   = {};
-    sInfo.ppCommandBuffers   = &commandBuffer;
-    sInfo.commandBufferCount = 1;
+    sInfo.commandBufferCount = 0;
     sInfo.ppWaitSemaphores   = ppWaitSemaphores;
     sInfo.waitSemaphoreCount = waitSemaphoreCount;
-    mCreateInfo.pQueue->Submit(&sInfo);
-
-    return ppx::SUCCESS;
+    return mCreateInfo.pQueue->Submit(&sInfo);
 }
 
 } // namespace grfx
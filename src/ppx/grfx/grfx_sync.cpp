@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "ppx/grfx/grfx_sync.h"
+#include "ppx/grfx/grfx_device.h"
 
 #define REQUIRES_TIMELINE_MSG "invalid semaphore type: operation requires timeline semaphore"
 
@@ -81,5 +82,141 @@ uint64_t Semaphore::GetCounterValue() const
     return value;
 }
 
+// -------------------------------------------------------------------------------------------------
+// SyncPool
+// -------------------------------------------------------------------------------------------------
+SyncPool::SyncPool(grfx::Device* pDevice)
+    : mDevice(pDevice)
+{
+}
+
+SyncPool::~SyncPool()
+{
+    Destroy();
+}
+
+void SyncPool::Recycle()
+{
+    // Fences are released in submission order per queue but the pool may be
+    // shared across queues, so every pending entry is checked.
+    for (auto it = mPending.begin(); it != mPending.end();) {
+        if (!it->fence->IsSignaled()) {
+            ++it;
+            continue;
+        }
+        mFreeFences.push_back(it->fence);
+        mFreeSemaphores.insert(mFreeSemaphores.end(), it->semaphores.begin(), it->semaphores.end());
+        it = mPending.erase(it);
+    }
+}
+
+Result SyncPool::AcquireFence(grfx::Fence** ppFence)
+{
+    PPX_ASSERT_NULL_ARG(ppFence);
+    PPX_ASSERT_NULL_ARG(mDevice);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mFreeFences.empty()) {
+            Recycle();
+        }
+        if (!mFreeFences.empty()) {
+            grfx::FencePtr fence = mFreeFences.back();
+            mFreeFences.pop_back();
+
+            Result ppxres = fence->Reset();
+            if (Failed(ppxres)) {
+                mFreeFences.push_back(fence);
+                return ppxres;
+            }
+
+            *ppFence = fence;
+            return ppx::SUCCESS;
+        }
+    }
+
+    grfx::FenceCreateInfo createInfo = {};
+    return mDevice->CreateFence(&createInfo, ppFence);
+}
+
+Result SyncPool::AcquireSemaphore(grfx::Semaphore** ppSemaphore)
+{
+    PPX_ASSERT_NULL_ARG(ppSemaphore);
+    PPX_ASSERT_NULL_ARG(mDevice);
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mFreeSemaphores.empty()) {
+            Recycle();
+        }
+        if (!mFreeSemaphores.empty()) {
+            *ppSemaphore = mFreeSemaphores.back();
+            mFreeSemaphores.pop_back();
+            return ppx::SUCCESS;
+        }
+    }
+
+    grfx::SemaphoreCreateInfo createInfo = {};
+    return mDevice->CreateSemaphore(&createInfo, ppSemaphore);
+}
+
+void SyncPool::Release(grfx::Fence* pFence, uint32_t semaphoreCount, grfx::Semaphore* const* ppSemaphores)
+{
+    PPX_ASSERT_NULL_ARG(pFence);
+
+    Pending pending = {};
+    pending.fence   = pFence;
+    for (uint32_t i = 0; i < semaphoreCount; ++i) {
+        PPX_ASSERT_MSG(ppSemaphores[i]->IsBinary(), "only binary semaphores are pooled");
+        pending.semaphores.push_back(ppSemaphores[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPending.push_back(std::move(pending));
+}
+
+void SyncPool::Destroy()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    for (auto& pending : mPending) {
+        pending.fence->Wait();
+        mFreeFences.push_back(pending.fence);
+        mFreeSemaphores.insert(mFreeSemaphores.end(), pending.semaphores.begin(), pending.semaphores.end());
+    }
+    mPending.clear();
+
+    for (auto& fence : mFreeFences) {
+        mDevice->DestroyFence(fence);
+    }
+    mFreeFences.clear();
+
+    for (auto& semaphore : mFreeSemaphores) {
+        mDevice->DestroySemaphore(semaphore);
+    }
+    mFreeSemaphores.clear();
+}
+
+uint32_t SyncPool::GetFreeFenceCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return CountU32(mFreeFences);
+}
+
+uint32_t SyncPool::GetFreeSemaphoreCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return CountU32(mFreeSemaphores);
+}
+
+uint32_t SyncPool::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<uint32_t>(mPending.size());
+}
+
 } // namespace grfx
 } // namespace ppx
@@ -0,0 +1,401 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_temporal_resolve.h"
+#include "ppx/grfx/grfx_command.h"
+#include "ppx/grfx/grfx_descriptor.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_texture.h"
+
+#include <cmath>
+
+namespace ppx {
+namespace grfx {
+
+// Registers in TemporalResolve.hlsl
+enum
+{
+    TEMPORAL_RESOLVE_PARAMS_REGISTER  = 0,
+    TEMPORAL_RESOLVE_COLOR_REGISTER   = 1,
+    TEMPORAL_RESOLVE_DEPTH_REGISTER   = 2,
+    TEMPORAL_RESOLVE_MOTION_REGISTER  = 3,
+    TEMPORAL_RESOLVE_HISTORY_REGISTER = 4,
+    TEMPORAL_RESOLVE_OUTPUT_REGISTER  = 5,
+    TEMPORAL_RESOLVE_SAMPLER_REGISTER = 6,
+};
+
+enum
+{
+    TEMPORAL_RESOLVE_FLAG_HISTORY_VALID = 0x1,
+    TEMPORAL_RESOLVE_FLAG_HAS_MOTION    = 0x2,
+};
+
+// Must match TemporalResolve.hlsl
+struct TemporalResolveParams
+{
+    float4x4 reprojection;
+    float    inputTexelSize[2];
+    float    renderSize[2];
+    float    outputSize[2];
+    float    jitter[2];
+    float    blendFactor;
+    uint32_t flags;
+};
+
+// Pixels per group in each dimension
+static const uint32_t kGroupSize = 8;
+
+static float Halton(uint32_t index, uint32_t base)
+{
+    float result = 0.0f;
+    float f      = 1.0f;
+    while (index > 0) {
+        f /= static_cast<float>(base);
+        result += f * static_cast<float>(index % base);
+        index /= base;
+    }
+    return result;
+}
+
+float2 TemporalResolve::GetJitterOffset(uint32_t index, uint32_t phaseCount)
+{
+    // Halton index 0 is (0, 0), start at 1 so every phase is off center
+    uint32_t i = (index % std::max<uint32_t>(phaseCount, 1)) + 1;
+    return float2(Halton(i, 2) - 0.5f, Halton(i, 3) - 0.5f);
+}
+
+uint32_t TemporalResolve::GetJitterPhaseCount(uint32_t renderWidth, uint32_t outputWidth)
+{
+    if ((renderWidth == 0) || (renderWidth >= outputWidth)) {
+        return 8;
+    }
+    float ratio = static_cast<float>(outputWidth) / static_cast<float>(renderWidth);
+    return std::min<uint32_t>(static_cast<uint32_t>(std::ceil(8.0f * ratio * ratio)), 64);
+}
+
+Result TemporalResolve::CreateApiObjects(const grfx::TemporalResolveCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if (IsNull(pCreateInfo->CS.pModule)) {
+        PPX_ASSERT_MSG(false, "temporal resolve shader must not be null");
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((pCreateInfo->frameCount == 0) || (pCreateInfo->width == 0) || (pCreateInfo->height == 0)) {
+        PPX_ASSERT_MSG(false, "temporal resolve frame count and size must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (pCreateInfo->outputFormat == grfx::FORMAT_UNDEFINED) {
+        PPX_ASSERT_MSG(false, "temporal resolve output format must be defined");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // History sampler
+    Result ppxres = ppx::SUCCESS;
+    {
+        grfx::SamplerCreateInfo createInfo = {};
+        createInfo.magFilter               = grfx::FILTER_LINEAR;
+        createInfo.minFilter               = grfx::FILTER_LINEAR;
+        createInfo.mipmapMode              = grfx::SAMPLER_MIPMAP_MODE_NEAREST;
+        createInfo.addressModeU            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.addressModeV            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.addressModeW            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+        ppxres = GetDevice()->CreateSampler(&createInfo, &mSampler);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating temporal resolve sampler");
+            return ppxres;
+        }
+    }
+
+    // Stands in for the motion vectors, never read
+    {
+        grfx::TextureCreateInfo createInfo = {};
+        createInfo.imageType               = grfx::IMAGE_TYPE_2D;
+        createInfo.width                   = 1;
+        createInfo.height                  = 1;
+        createInfo.depth                   = 1;
+        createInfo.imageFormat             = grfx::FORMAT_R16G16_FLOAT;
+        createInfo.usageFlags              = grfx::ImageUsageFlags::SampledImage();
+        createInfo.initialState            = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        ppxres = GetDevice()->CreateTexture(&createInfo, &mNullMotion);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating temporal resolve null motion texture");
+            return ppxres;
+        }
+    }
+
+    // Descriptors
+    {
+        const uint32_t setCount = pCreateInfo->frameCount;
+
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.sampledImage                   = 4 * setCount;
+        poolCreateInfo.storageImage                   = setCount;
+        poolCreateInfo.sampler                        = setCount;
+
+        ppxres = GetDevice()->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating temporal resolve descriptor pool");
+            return ppxres;
+        }
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(TEMPORAL_RESOLVE_COLOR_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(TEMPORAL_RESOLVE_DEPTH_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(TEMPORAL_RESOLVE_MOTION_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(TEMPORAL_RESOLVE_HISTORY_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(TEMPORAL_RESOLVE_OUTPUT_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(TEMPORAL_RESOLVE_SAMPLER_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLER));
+
+        ppxres = GetDevice()->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating temporal resolve descriptor set layout");
+            return ppxres;
+        }
+
+        mSets.resize(setCount);
+        for (auto& set : mSets) {
+            ppxres = GetDevice()->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "failed allocating temporal resolve descriptor set");
+                return ppxres;
+            }
+        }
+    }
+
+    // Pipeline interface
+    {
+        grfx::PipelineInterfaceCreateInfo createInfo = {};
+        createInfo.setCount                          = 1;
+        createInfo.sets[0].set                       = 0;
+        createInfo.sets[0].pLayout                   = mSetLayout;
+        createInfo.pushConstants.count               = sizeof(TemporalResolveParams) / sizeof(uint32_t);
+        createInfo.pushConstants.binding             = TEMPORAL_RESOLVE_PARAMS_REGISTER;
+        createInfo.pushConstants.set                 = 0;
+
+        ppxres = GetDevice()->CreatePipelineInterface(&createInfo, &mPipelineInterface);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline interface");
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::ComputePipelineCreateInfo createInfo = {};
+        createInfo.CS                              = {pCreateInfo->CS.pModule, pCreateInfo->CS.entryPoint};
+        createInfo.pPipelineInterface              = mPipelineInterface;
+
+        ppxres = GetDevice()->CreateComputePipeline(&createInfo, &mPipeline);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating pipeline");
+            return ppxres;
+        }
+    }
+
+    ppxres = CreateHistory(pCreateInfo->width, pCreateInfo->height);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ppx::SUCCESS;
+}
+
+void TemporalResolve::DestroyApiObjects()
+{
+    // History textures freed by Resize()
+    if (mHasDeferredDestroys) {
+        GetDevice()->FlushDeferredDestroys();
+        mHasDeferredDestroys = false;
+    }
+
+    for (auto& history : mHistory) {
+        if (history) {
+            GetDevice()->DestroyTexture(history);
+            history.Reset();
+        }
+    }
+
+    for (auto& set : mSets) {
+        if (set) {
+            GetDevice()->FreeDescriptorSet(set);
+            set.Reset();
+        }
+    }
+    mSets.clear();
+
+    if (mPipeline) {
+        GetDevice()->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mPipelineInterface) {
+        GetDevice()->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        GetDevice()->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        GetDevice()->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mNullMotion) {
+        GetDevice()->DestroyTexture(mNullMotion);
+        mNullMotion.Reset();
+    }
+
+    if (mSampler) {
+        GetDevice()->DestroySampler(mSampler);
+        mSampler.Reset();
+    }
+}
+
+Result TemporalResolve::CreateHistory(uint32_t width, uint32_t height)
+{
+    grfx::TexturePtr history[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        grfx::TextureCreateInfo createInfo = {};
+        createInfo.imageType               = grfx::IMAGE_TYPE_2D;
+        createInfo.width                   = width;
+        createInfo.height                  = height;
+        createInfo.depth                   = 1;
+        createInfo.imageFormat             = mCreateInfo.outputFormat;
+        createInfo.usageFlags.bits.sampled = true;
+        createInfo.usageFlags.bits.storage = true;
+        createInfo.initialState            = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        Result ppxres = GetDevice()->CreateTexture(&createInfo, &history[i]);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating temporal resolve history");
+            if (history[0]) {
+                GetDevice()->DestroyTexture(history[0]);
+            }
+            return ppxres;
+        }
+    }
+
+    // Frames in flight may still read or write the old ones
+    for (uint32_t i = 0; i < 2; ++i) {
+        if (mHistory[i]) {
+            GetDevice()->DeferDestroyTexture(mHistory[i]);
+            mHasDeferredDestroys = true;
+        }
+        mHistory[i] = history[i];
+    }
+
+    mCreateInfo.width  = width;
+    mCreateInfo.height = height;
+    mCurrent           = 0;
+    mHistoryValid      = false;
+
+    return ppx::SUCCESS;
+}
+
+Result TemporalResolve::Resize(uint32_t width, uint32_t height)
+{
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((width == mCreateInfo.width) && (height == mCreateInfo.height)) {
+        return ppx::SUCCESS;
+    }
+
+    return CreateHistory(width, height);
+}
+
+Result TemporalResolve::Resolve(grfx::CommandBuffer* pCommandBuffer, uint32_t frameIndex, const grfx::TemporalResolveInputs& inputs)
+{
+    PPX_ASSERT_NULL_ARG(pCommandBuffer);
+    PPX_ASSERT_MSG(frameIndex < CountU32(mSets), "temporal resolve frame index out of range");
+
+    if (IsNull(inputs.pColor) || IsNull(inputs.pDepth)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((inputs.renderWidth == 0) || (inputs.renderHeight == 0) || (inputs.renderWidth > inputs.pColor->GetWidth()) || (inputs.renderHeight > inputs.pColor->GetHeight())) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    const uint32_t       previous = mCurrent;
+    const uint32_t       current  = 1 - mCurrent;
+    grfx::Texture*       pMotion  = IsNull(inputs.pMotion) ? mNullMotion.Get() : inputs.pMotion;
+    grfx::DescriptorSet* pSet     = mSets[frameIndex];
+
+    // The set of this frame index was last used by work that has completed
+    grfx::WriteDescriptor writes[6] = {};
+    writes[0].binding               = TEMPORAL_RESOLVE_COLOR_REGISTER;
+    writes[0].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageView            = inputs.pColor->GetSampledImageView();
+    writes[1].binding               = TEMPORAL_RESOLVE_DEPTH_REGISTER;
+    writes[1].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[1].pImageView            = inputs.pDepth->GetSampledImageView();
+    writes[2].binding               = TEMPORAL_RESOLVE_MOTION_REGISTER;
+    writes[2].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[2].pImageView            = pMotion->GetSampledImageView();
+    writes[3].binding               = TEMPORAL_RESOLVE_HISTORY_REGISTER;
+    writes[3].type                  = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[3].pImageView            = mHistory[previous]->GetSampledImageView();
+    writes[4].binding               = TEMPORAL_RESOLVE_OUTPUT_REGISTER;
+    writes[4].type                  = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[4].pImageView            = mHistory[current]->GetStorageImageView();
+    writes[5].binding               = TEMPORAL_RESOLVE_SAMPLER_REGISTER;
+    writes[5].type                  = grfx::DESCRIPTOR_TYPE_SAMPLER;
+    writes[5].pSampler              = mSampler;
+
+    Result ppxres = pSet->UpdateDescriptors(6, writes);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    TemporalResolveParams params = {};
+    params.reprojection          = mPrevViewProjection * glm::inverse(inputs.viewProjectionMatrix);
+    params.inputTexelSize[0]     = 1.0f / static_cast<float>(inputs.pColor->GetWidth());
+    params.inputTexelSize[1]     = 1.0f / static_cast<float>(inputs.pColor->GetHeight());
+    params.renderSize[0]         = static_cast<float>(inputs.renderWidth);
+    params.renderSize[1]         = static_cast<float>(inputs.renderHeight);
+    params.outputSize[0]         = static_cast<float>(mCreateInfo.width);
+    params.outputSize[1]         = static_cast<float>(mCreateInfo.height);
+    params.jitter[0]             = inputs.jitter.x;
+    params.jitter[1]             = inputs.jitter.y;
+    params.blendFactor           = mBlendFactor;
+    params.flags                 = (mHistoryValid ? TEMPORAL_RESOLVE_FLAG_HISTORY_VALID : 0) | (IsNull(inputs.pMotion) ? 0 : TEMPORAL_RESOLVE_FLAG_HAS_MOTION);
+
+    grfx::Image* pOutputImage = mHistory[current]->GetImage();
+    pCommandBuffer->TransitionImageLayout(pOutputImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_SHADER_RESOURCE, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+
+    pCommandBuffer->BindComputePipeline(mPipeline);
+    pCommandBuffer->BindComputeDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCommandBuffer->PushComputeConstants(mPipelineInterface, sizeof(TemporalResolveParams) / sizeof(uint32_t), &params);
+    pCommandBuffer->Dispatch(
+        (mCreateInfo.width + kGroupSize - 1) / kGroupSize,
+        (mCreateInfo.height + kGroupSize - 1) / kGroupSize,
+        1);
+
+    pCommandBuffer->TransitionImageLayout(pOutputImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_UNORDERED_ACCESS, grfx::RESOURCE_STATE_SHADER_RESOURCE);
+
+    mCurrent            = current;
+    mHistoryValid       = true;
+    mPrevViewProjection = inputs.viewProjectionMatrix;
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
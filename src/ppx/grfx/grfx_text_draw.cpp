@@ -16,6 +16,7 @@
 #include "ppx/grfx/grfx_device.h"
 #include "ppx/bitmap.h"
 #include "ppx/graphics_util.h"
+#include "ppx/job_system.h"
 
 #define STB_TRUETYPE_IMPLEMENTATION
 #include "stb_truetype.h"
@@ -57,32 +58,39 @@ Result TextureFont::CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateI
     float subpixelShiftY = 0.5f;
 
     // Get glyph metrics and max bounds
+    auto addGlyph = [this, pCreateInfo, subpixelShiftX, subpixelShiftY](uint32_t codepoint) {
+        GlyphMetrics metrics = {};
+        pCreateInfo->font.GetGlyphMetrics(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, &metrics);
+        if (pCreateInfo->sdf) {
+            // Distance fields aren't rendered with a subpixel shift and extend past the glyph
+            pCreateInfo->font.GetGlyphSDFBox(pCreateInfo->size, codepoint, pCreateInfo->sdfPadding, &metrics.box);
+        }
+        mGlyphMetrics.emplace_back(grfx::TextureFontGlyphMetrics{codepoint, metrics});
+    };
+
     utf8::iterator<std::string::iterator> it(characters.begin(), characters.begin(), characters.end());
     utf8::iterator<std::string::iterator> it_end(characters.end(), characters.begin(), characters.end());
     bool                                  hasSpace = false;
     while (it != it_end) {
         const uint32_t codepoint = utf8::next(it, it_end);
-        GlyphMetrics   metrics   = {};
-        pCreateInfo->font.GetGlyphMetrics(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, &metrics);
-        mGlyphMetrics.emplace_back(grfx::TextureFontGlyphMetrics{codepoint, metrics});
+        addGlyph(codepoint);
 
         if (!hasSpace) {
             hasSpace = (codepoint == 32);
         }
     }
     if (!hasSpace) {
-        const uint32_t codepoint = 32;
-        GlyphMetrics   metrics   = {};
-        pCreateInfo->font.GetGlyphMetrics(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, &metrics);
-        mGlyphMetrics.emplace_back(grfx::TextureFontGlyphMetrics{codepoint, metrics});
+        addGlyph(32);
     }
 
-    // Figure out a squarish somewhat texture size
-    const size_t  nc           = characters.size();
-    const int32_t sqrtnc       = static_cast<int32_t>(sqrtf(static_cast<float>(nc)) + 0.5f) + 1;
-    int32_t       bitmapWidth  = 0;
-    int32_t       bitmapHeight = 0;
-    size_t        glyphIndex   = 0;
+    // Figure out a squarish somewhat texture size and where each glyph goes
+    const size_t          nc           = characters.size();
+    const int32_t         sqrtnc       = static_cast<int32_t>(sqrtf(static_cast<float>(nc)) + 0.5f) + 1;
+    int32_t               bitmapWidth  = 0;
+    int32_t               bitmapHeight = 0;
+    size_t                glyphIndex   = 0;
+    std::vector<uint32_t> glyphX;
+    std::vector<uint32_t> glyphY;
     for (int32_t i = 0; (i < sqrtnc) && (glyphIndex < nc); ++i) {
         int32_t height = 0;
         int32_t width  = 0;
@@ -90,8 +98,10 @@ Result TextureFont::CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateI
             const GlyphMetrics& metrics = mGlyphMetrics[glyphIndex].glyphMetrics;
             int32_t             w       = (metrics.box.x1 - metrics.box.x0) + 1;
             int32_t             h       = (metrics.box.y1 - metrics.box.y0) + 1;
-            width                       = width + w;
-            height                      = std::max<int32_t>(height, h);
+            glyphX.push_back(static_cast<uint32_t>(width));
+            glyphY.push_back(static_cast<uint32_t>(bitmapHeight));
+            width  = width + w;
+            height = std::max<int32_t>(height, h);
         }
         bitmapWidth  = std::max<int32_t>(bitmapWidth, width);
         bitmapHeight = bitmapHeight + height;
@@ -100,39 +110,39 @@ Result TextureFont::CreateApiObjects(const grfx::TextureFontCreateInfo* pCreateI
     // Storage bitmap
     Bitmap bitmap = Bitmap::Create(bitmapWidth, bitmapHeight, Bitmap::Format::FORMAT_R_UINT8);
 
-    // Render glyph bitmaps
+    // Render glyph bitmaps, glyphs don't overlap so they're rendered on the job system
     const float    invBitmapWidth  = 1.0f / static_cast<float>(bitmapWidth);
     const float    invBitmapHeight = 1.0f / static_cast<float>(bitmapHeight);
     const uint32_t rowStride       = bitmap.GetRowStride();
     const uint32_t pixelStride     = bitmap.GetPixelStride();
-    uint32_t       y               = 0;
-    glyphIndex                     = 0;
-    for (int32_t i = 0; (i < sqrtnc) && (glyphIndex < nc); ++i) {
-        uint32_t x      = 0;
-        uint32_t height = 0;
-        for (int32_t j = 0; (j < sqrtnc) && (glyphIndex < nc); ++j, ++glyphIndex) {
-            uint32_t            codepoint = mGlyphMetrics[glyphIndex].codepoint;
-            const GlyphMetrics& metrics   = mGlyphMetrics[glyphIndex].glyphMetrics;
+    const uint32_t glyphCount      = CountU32(glyphX);
+    JobSystem::Get()->ParallelFor(glyphCount, 8, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            uint32_t            codepoint = mGlyphMetrics[i].codepoint;
+            const GlyphMetrics& metrics   = mGlyphMetrics[i].glyphMetrics;
+            uint32_t            x         = glyphX[i];
+            uint32_t            y         = glyphY[i];
             uint32_t            w         = static_cast<uint32_t>(metrics.box.x1 - metrics.box.x0) + 1;
             uint32_t            h         = static_cast<uint32_t>(metrics.box.y1 - metrics.box.y0) + 1;
 
             uint32_t offset  = (y * rowStride) + (x * pixelStride);
             char*    pOutput = bitmap.GetData() + offset;
-            pCreateInfo->font.RenderGlyphBitmap(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, w, h, rowStride, reinterpret_cast<unsigned char*>(pOutput));
-
-            mGlyphMetrics[glyphIndex].size.x = static_cast<float>(w);
-            mGlyphMetrics[glyphIndex].size.y = static_cast<float>(h);
-
-            mGlyphMetrics[glyphIndex].uvRect.u0 = x * invBitmapWidth;
-            mGlyphMetrics[glyphIndex].uvRect.v0 = y * invBitmapHeight;
-            mGlyphMetrics[glyphIndex].uvRect.u1 = (x + w - 1) * invBitmapWidth;
-            mGlyphMetrics[glyphIndex].uvRect.v1 = (y + h - 1) * invBitmapHeight;
-
-            x      = x + w;
-            height = std::max<int32_t>(height, h);
+            if (pCreateInfo->sdf) {
+                pCreateInfo->font.RenderGlyphSDF(pCreateInfo->size, codepoint, pCreateInfo->sdfPadding, w, h, rowStride, reinterpret_cast<unsigned char*>(pOutput));
+            }
+            else {
+                pCreateInfo->font.RenderGlyphBitmap(pCreateInfo->size, codepoint, subpixelShiftX, subpixelShiftY, w, h, rowStride, reinterpret_cast<unsigned char*>(pOutput));
+            }
+
+            mGlyphMetrics[i].size.x = static_cast<float>(w);
+            mGlyphMetrics[i].size.y = static_cast<float>(h);
+
+            mGlyphMetrics[i].uvRect.u0 = x * invBitmapWidth;
+            mGlyphMetrics[i].uvRect.v0 = y * invBitmapHeight;
+            mGlyphMetrics[i].uvRect.u1 = (x + w - 1) * invBitmapWidth;
+            mGlyphMetrics[i].uvRect.v1 = (y + h - 1) * invBitmapHeight;
         }
-        y += height;
-    }
+    });
 
     ppx::Result ppxres = grfx_util::CreateTextureFromBitmap(GetDevice()->GetGraphicsQueue(), &bitmap, &mTexture);
     if (Failed(ppxres)) {
@@ -189,7 +199,7 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
     }
 
-    // Index buffer
+    // Index buffer, the same quads for every string so it's uploaded once
     {
         uint64_t size = pCreateInfo->maxTextLength * kGlyphIndicesSize;
 
@@ -199,12 +209,31 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
         createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
         createInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
 
-        ppx::Result ppxres = GetDevice()->CreateBuffer(&createInfo, &mCpuIndexBuffer);
+        grfx::BufferPtr cpuIndexBuffer;
+        ppx::Result     ppxres = GetDevice()->CreateBuffer(&createInfo, &cpuIndexBuffer);
         if (Failed(ppxres)) {
             PPX_ASSERT_MSG(false, "failed creating CPU index buffer");
             return ppxres;
         }
 
+        void* mappedAddress = nullptr;
+        ppxres              = cpuIndexBuffer->MapMemory(0, &mappedAddress);
+        if (Failed(ppxres)) {
+            GetDevice()->DestroyBuffer(cpuIndexBuffer);
+            return ppxres;
+        }
+        uint32_t* pIndices = static_cast<uint32_t*>(mappedAddress);
+        for (uint32_t i = 0; i < pCreateInfo->maxTextLength; ++i, pIndices += 6) {
+            uint32_t vertexCount = i * 4;
+            pIndices[0]          = vertexCount + 0;
+            pIndices[1]          = vertexCount + 1;
+            pIndices[2]          = vertexCount + 2;
+            pIndices[3]          = vertexCount + 0;
+            pIndices[4]          = vertexCount + 2;
+            pIndices[5]          = vertexCount + 3;
+        }
+        cpuIndexBuffer->UnmapMemory();
+
         createInfo.usageFlags.bits.transferSrc = false;
         createInfo.usageFlags.bits.transferDst = true;
         createInfo.usageFlags.bits.indexBuffer = true;
@@ -213,24 +242,35 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
 
         ppxres = GetDevice()->CreateBuffer(&createInfo, &mGpuIndexBuffer);
         if (Failed(ppxres)) {
+            GetDevice()->DestroyBuffer(cpuIndexBuffer);
             PPX_ASSERT_MSG(false, "failed creating GPU index buffer");
             return ppxres;
         }
 
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.size                         = size;
+        ppxres                                = GetDevice()->GetGraphicsQueue()->CopyBufferToBuffer(&copyInfo, cpuIndexBuffer, mGpuIndexBuffer, grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_INDEX_BUFFER);
+        GetDevice()->DestroyBuffer(cpuIndexBuffer);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed uploading index buffer");
+            return ppxres;
+        }
+
         mIndexBufferView.pBuffer   = mGpuIndexBuffer;
         mIndexBufferView.indexType = grfx::INDEX_TYPE_UINT32;
         mIndexBufferView.offset    = 0;
     }
 
-    // Vertex buffer
+    // Vertex buffer, read in place by the GPU in ring mode
     {
-        uint64_t size = pCreateInfo->maxTextLength * kGlyphVerticesSize;
+        uint64_t size = pCreateInfo->maxTextLength * kGlyphVerticesSize * std::max<uint32_t>(pCreateInfo->ringFrameCount, 1);
 
-        grfx::BufferCreateInfo createInfo      = {};
-        createInfo.size                        = size;
-        createInfo.usageFlags.bits.transferSrc = true;
-        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
-        createInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+        grfx::BufferCreateInfo createInfo       = {};
+        createInfo.size                         = size;
+        createInfo.usageFlags.bits.transferSrc  = true;
+        createInfo.usageFlags.bits.vertexBuffer = (pCreateInfo->ringFrameCount > 0);
+        createInfo.memoryUsage                  = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState                 = grfx::RESOURCE_STATE_COPY_SRC;
 
         ppx::Result ppxres = GetDevice()->CreateBuffer(&createInfo, &mCpuVertexBuffer);
         if (Failed(ppxres)) {
@@ -238,21 +278,33 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
             return ppxres;
         }
 
-        createInfo.usageFlags.bits.transferSrc  = false;
-        createInfo.usageFlags.bits.transferDst  = true;
-        createInfo.usageFlags.bits.vertexBuffer = true;
-        createInfo.memoryUsage                  = grfx::MEMORY_USAGE_GPU_ONLY;
-        createInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
-
-        ppxres = GetDevice()->CreateBuffer(&createInfo, &mGpuVertexBuffer);
+        void* mappedAddress = nullptr;
+        ppxres              = mCpuVertexBuffer->MapMemory(0, &mappedAddress);
         if (Failed(ppxres)) {
-            PPX_ASSERT_MSG(false, "failed creating GPU vertex buffer");
+            PPX_ASSERT_MSG(false, "failed mapping CPU vertex buffer");
             return ppxres;
         }
+        mMappedAddress = static_cast<uint8_t*>(mappedAddress);
 
-        mVertexBufferView.pBuffer = mGpuVertexBuffer;
+        mVertexBufferView.pBuffer = mCpuVertexBuffer;
         mVertexBufferView.stride  = sizeof(Vertex);
         mVertexBufferView.offset  = 0;
+
+        if (pCreateInfo->ringFrameCount == 0) {
+            createInfo.usageFlags.bits.transferSrc  = false;
+            createInfo.usageFlags.bits.transferDst  = true;
+            createInfo.usageFlags.bits.vertexBuffer = true;
+            createInfo.memoryUsage                  = grfx::MEMORY_USAGE_GPU_ONLY;
+            createInfo.initialState                 = grfx::RESOURCE_STATE_VERTEX_BUFFER;
+
+            ppxres = GetDevice()->CreateBuffer(&createInfo, &mGpuVertexBuffer);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "failed creating GPU vertex buffer");
+                return ppxres;
+            }
+
+            mVertexBufferView.pBuffer = mGpuVertexBuffer;
+        }
     }
 
     if (!sSampler) {
@@ -403,17 +455,16 @@ Result TextDraw::CreateApiObjects(const grfx::TextDrawCreateInfo* pCreateInfo)
 
 void TextDraw::DestroyApiObjects()
 {
-    if (mCpuIndexBuffer) {
-        GetDevice()->DestroyBuffer(mCpuIndexBuffer);
-        mCpuIndexBuffer.Reset();
-    }
-
     if (mGpuIndexBuffer) {
         GetDevice()->DestroyBuffer(mGpuIndexBuffer);
         mGpuIndexBuffer.Reset();
     }
 
     if (mCpuVertexBuffer) {
+        if (!IsNull(mMappedAddress)) {
+            mCpuVertexBuffer->UnmapMemory();
+            mMappedAddress = nullptr;
+        }
         GetDevice()->DestroyBuffer(mCpuVertexBuffer);
         mCpuVertexBuffer.Reset();
     }
@@ -459,14 +510,73 @@ void TextDraw::DestroyApiObjects()
     }
 }
 
+uint8_t* TextDraw::GetSegmentVertices(uint32_t segment)
+{
+    return mMappedAddress + segment * mCreateInfo.maxTextLength * kGlyphVerticesSize;
+}
+
+const uint8_t* TextDraw::GetCurrentVertices() const
+{
+    return mMappedAddress + mSegment * mCreateInfo.maxTextLength * kGlyphVerticesSize;
+}
+
 void TextDraw::Clear()
 {
+    mPrevStrings.swap(mStrings);
+    mStrings.clear();
     mTextLength = 0;
+
+    if (IsRing()) {
+        mSegment                 = (mSegment + 1) % mCreateInfo.ringFrameCount;
+        mVertexBufferView.offset = mSegment * mCreateInfo.maxTextLength * kGlyphVerticesSize;
+    }
+}
+
+bool TextDraw::ReuseString(uint64_t hash)
+{
+    const size_t stringIndex = mStrings.size();
+    if ((stringIndex >= mPrevStrings.size()) || (mPrevStrings[stringIndex].hash != hash)) {
+        return false;
+    }
+
+    const StringRange& prev = mPrevStrings[stringIndex];
+    if (mCreateInfo.ringFrameCount > 1) {
+        // Vertices are in screen space, so the string can move within the segment
+        const uint32_t prevSegment = (mSegment + mCreateInfo.ringFrameCount - 1) % mCreateInfo.ringFrameCount;
+        const uint32_t glyphCount  = std::min(prev.glyphCount, mCreateInfo.maxTextLength - mTextLength);
+        std::memcpy(
+            GetSegmentVertices(mSegment) + mTextLength * kGlyphVerticesSize,
+            GetSegmentVertices(prevSegment) + prev.firstGlyph * kGlyphVerticesSize,
+            glyphCount * kGlyphVerticesSize);
+        mStrings.push_back({hash, mTextLength, glyphCount});
+        mTextLength += glyphCount;
+        return true;
+    }
+
+    // Without a separate previous segment the vertices are still in place if nothing before them changed
+    if (prev.firstGlyph != mTextLength) {
+        return false;
+    }
+    mStrings.push_back(prev);
+    mTextLength += prev.glyphCount;
+    return true;
+}
+
+void TextDraw::AddString(
+    const float2&      position,
+    const std::string& string,
+    float              tabSpacing,
+    float              lineSpacing,
+    const float3&      color,
+    float              opacity)
+{
+    AddString(position, string, mCreateInfo.pFont->GetSize(), tabSpacing, lineSpacing, color, opacity);
 }
 
 void TextDraw::AddString(
     const float2&      position,
     const std::string& string,
+    float              fontSize,
     float              tabSpacing,
     float              lineSpacing,
     const float3&      color,
@@ -476,20 +586,15 @@ void TextDraw::AddString(
         return;
     }
 
-    // Map index buffer
-    void*       mappedAddress = nullptr;
-    ppx::Result ppxres        = mCpuIndexBuffer->MapMemory(0, &mappedAddress);
-    if (Failed(ppxres)) {
+    const XXH64_hash_t kSeed      = 0x1b873593cc9e2d51;
+    const float        params[9]  = {position.x, position.y, fontSize, tabSpacing, lineSpacing, color.r, color.g, color.b, opacity};
+    const uint64_t     hash       = XXH64(string.data(), string.size(), XXH64(params, sizeof(params), kSeed));
+    const uint32_t     firstGlyph = mTextLength;
+    if (ReuseString(hash)) {
         return;
     }
-    uint8_t* pIndicesBaseAddr = static_cast<uint8_t*>(mappedAddress);
 
-    // Map vertex buffer
-    ppxres = mCpuVertexBuffer->MapMemory(0, &mappedAddress);
-    if (Failed(ppxres)) {
-        return;
-    }
-    uint8_t* pVerticesBaseAddr = static_cast<uint8_t*>(mappedAddress);
+    uint8_t* pVerticesBaseAddr = GetSegmentVertices(mSegment);
 
     // Convert to 8 bit color
     uint32_t r    = std::min<uint32_t>(static_cast<uint32_t>(color.r * 255.0f), 255);
@@ -501,9 +606,10 @@ void TextDraw::AddString(
     utf8::iterator<std::string::const_iterator> it(string.begin(), string.begin(), string.end());
     utf8::iterator<std::string::const_iterator> it_end(string.end(), string.begin(), string.end());
     float2                                      baseline = position;
-    float                                       ascent   = mCreateInfo.pFont->GetAscent();
-    float                                       descent  = mCreateInfo.pFont->GetDescent();
-    float                                       lineGap  = mCreateInfo.pFont->GetLineGap();
+    float                                       scale    = fontSize / mCreateInfo.pFont->GetSize();
+    float                                       ascent   = scale * mCreateInfo.pFont->GetAscent();
+    float                                       descent  = scale * mCreateInfo.pFont->GetDescent();
+    float                                       lineGap  = scale * mCreateInfo.pFont->GetLineGap();
     lineSpacing                                          = lineSpacing * (ascent - descent + lineGap);
 
     while (it != it_end) {
@@ -515,7 +621,7 @@ void TextDraw::AddString(
         }
         else if (codepoint == '\t') {
             const grfx::TextureFontGlyphMetrics* pMetrics = mCreateInfo.pFont->GetGlyphMetrics(32);
-            baseline.x += tabSpacing * pMetrics->glyphMetrics.advance;
+            baseline.x += tabSpacing * scale * pMetrics->glyphMetrics.advance;
             continue;
         }
 
@@ -524,22 +630,18 @@ void TextDraw::AddString(
             pMetrics = mCreateInfo.pFont->GetGlyphMetrics(32);
         }
 
-        size_t indexBufferOffset    = mTextLength * kGlyphIndicesSize;
-        size_t vertexBufferOffset   = mTextLength * kGlyphVerticesSize;
-        bool   exceededIndexBuffer  = (indexBufferOffset >= mCpuIndexBuffer->GetSize());
-        bool   exceededVertexBuffer = (vertexBufferOffset >= mCpuVertexBuffer->GetSize());
-        if (exceededIndexBuffer || exceededVertexBuffer) {
+        if (mTextLength >= mCreateInfo.maxTextLength) {
             break;
         }
 
-        uint32_t* pIndices  = reinterpret_cast<uint32_t*>(pIndicesBaseAddr + indexBufferOffset);
-        Vertex*   pVertices = reinterpret_cast<Vertex*>(pVerticesBaseAddr + vertexBufferOffset);
+        Vertex* pVertices = reinterpret_cast<Vertex*>(pVerticesBaseAddr + mTextLength * kGlyphVerticesSize);
 
-        float2 P   = baseline + float2(pMetrics->glyphMetrics.box.x0, pMetrics->glyphMetrics.box.y0);
+        float2 P   = baseline + scale * float2(pMetrics->glyphMetrics.box.x0, pMetrics->glyphMetrics.box.y0);
+        float2 S   = scale * pMetrics->size;
         float2 P0  = P;
-        float2 P1  = P + float2(0, pMetrics->size.y);
-        float2 P2  = P + pMetrics->size;
-        float2 P3  = P + float2(pMetrics->size.x, 0);
+        float2 P1  = P + float2(0, S.y);
+        float2 P2  = P + S;
+        float2 P3  = P + float2(S.x, 0);
         float2 uv0 = float2(pMetrics->uvRect.u0, pMetrics->uvRect.v0);
         float2 uv1 = float2(pMetrics->uvRect.u0, pMetrics->uvRect.v1);
         float2 uv2 = float2(pMetrics->uvRect.u1, pMetrics->uvRect.v1);
@@ -550,20 +652,11 @@ void TextDraw::AddString(
         pVertices[2] = Vertex{P2, uv2, rgba};
         pVertices[3] = Vertex{P3, uv3, rgba};
 
-        uint32_t vertexCount = mTextLength * 4;
-        pIndices[0]          = vertexCount + 0;
-        pIndices[1]          = vertexCount + 1;
-        pIndices[2]          = vertexCount + 2;
-        pIndices[3]          = vertexCount + 0;
-        pIndices[4]          = vertexCount + 2;
-        pIndices[5]          = vertexCount + 3;
-
         mTextLength += 1;
-        baseline.x += pMetrics->glyphMetrics.advance;
+        baseline.x += scale * pMetrics->glyphMetrics.advance;
     }
 
-    mCpuIndexBuffer->UnmapMemory();
-    mCpuVertexBuffer->UnmapMemory();
+    mStrings.push_back({hash, firstGlyph, mTextLength - firstGlyph});
 }
 
 void TextDraw::AddString(
@@ -575,20 +668,40 @@ void TextDraw::AddString(
     AddString(position, string, 3.0f, 1.0f, color, opacity);
 }
 
+void TextDraw::AddTextDraw(const grfx::TextDraw* pTextDraw)
+{
+    if (IsNull(pTextDraw) || (pTextDraw == this)) {
+        return;
+    }
+    PPX_ASSERT_MSG(pTextDraw->mCreateInfo.pFont == mCreateInfo.pFont, "text draws must use the same texture font");
+
+    const uint8_t* pSrcVertices = pTextDraw->GetCurrentVertices();
+    const uint32_t glyphCount   = std::min(pTextDraw->mTextLength, mCreateInfo.maxTextLength - mTextLength);
+    const uint64_t hash         = XXH64(pSrcVertices, glyphCount * kGlyphVerticesSize, 0);
+    if (ReuseString(hash)) {
+        return;
+    }
+
+    std::memcpy(
+        GetSegmentVertices(mSegment) + mTextLength * kGlyphVerticesSize,
+        pSrcVertices,
+        glyphCount * kGlyphVerticesSize);
+    mStrings.push_back({hash, mTextLength, glyphCount});
+    mTextLength += glyphCount;
+}
+
 ppx::Result TextDraw::UploadToGpu(grfx::Queue* pQueue)
 {
+    if (IsRing()) {
+        return ppx::SUCCESS;
+    }
+
     grfx::BufferToBufferCopyInfo copyInfo = {};
-    copyInfo.size                         = mCpuIndexBuffer->GetSize();
+    copyInfo.size                         = mCpuVertexBuffer->GetSize();
     copyInfo.srcBuffer.offset             = 0;
     copyInfo.dstBuffer.offset             = 0;
 
-    ppx::Result ppxres = pQueue->CopyBufferToBuffer(&copyInfo, mCpuIndexBuffer, mGpuIndexBuffer, grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_INDEX_BUFFER);
-    if (Failed(ppxres)) {
-        return ppxres;
-    }
-
-    copyInfo.size = mCpuVertexBuffer->GetSize();
-    ppxres        = pQueue->CopyBufferToBuffer(&copyInfo, mCpuVertexBuffer, mGpuVertexBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER, grfx::RESOURCE_STATE_VERTEX_BUFFER);
+    ppx::Result ppxres = pQueue->CopyBufferToBuffer(&copyInfo, mCpuVertexBuffer, mGpuVertexBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER, grfx::RESOURCE_STATE_VERTEX_BUFFER);
     if (Failed(ppxres)) {
         return ppxres;
     }
@@ -598,16 +711,15 @@ ppx::Result TextDraw::UploadToGpu(grfx::Queue* pQueue)
 
 void TextDraw::UploadToGpu(grfx::CommandBuffer* pCommandBuffer)
 {
+    if (IsRing() || (mTextLength == 0)) {
+        return;
+    }
+
     grfx::BufferToBufferCopyInfo copyInfo = {};
-    copyInfo.size                         = mTextLength * kGlyphIndicesSize;
+    copyInfo.size                         = mTextLength * kGlyphVerticesSize;
     copyInfo.srcBuffer.offset             = 0;
     copyInfo.dstBuffer.offset             = 0;
 
-    pCommandBuffer->BufferResourceBarrier(mGpuIndexBuffer, grfx::RESOURCE_STATE_INDEX_BUFFER, grfx::RESOURCE_STATE_COPY_DST);
-    pCommandBuffer->CopyBufferToBuffer(&copyInfo, mCpuIndexBuffer, mGpuIndexBuffer);
-    pCommandBuffer->BufferResourceBarrier(mGpuIndexBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_INDEX_BUFFER);
-
-    copyInfo.size = mTextLength * kGlyphVerticesSize;
     pCommandBuffer->BufferResourceBarrier(mGpuVertexBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER, grfx::RESOURCE_STATE_COPY_DST);
     pCommandBuffer->CopyBufferToBuffer(&copyInfo, mCpuVertexBuffer, mGpuVertexBuffer);
     pCommandBuffer->BufferResourceBarrier(mGpuVertexBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_VERTEX_BUFFER);
@@ -637,6 +749,10 @@ void TextDraw::PrepareDraw(const float4x4& MVP, grfx::CommandBuffer* pCommandBuf
 
 void TextDraw::Draw(grfx::CommandBuffer* pCommandBuffer)
 {
+    if (mTextLength == 0) {
+        return;
+    }
+
     pCommandBuffer->BindIndexBuffer(&mIndexBufferView);
     pCommandBuffer->BindVertexBuffers(1, &mVertexBufferView);
     pCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 1, &mDescriptorSet);
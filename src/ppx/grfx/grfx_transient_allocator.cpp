@@ -0,0 +1,139 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/grfx_transient_allocator.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_device.h"
+
+namespace ppx {
+namespace grfx {
+
+Result TransientAllocator::CreateApiObjects(const grfx::TransientAllocatorCreateInfo* pCreateInfo)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+
+    if ((pCreateInfo->frameSize == 0) || (pCreateInfo->frameCount == 0)) {
+        PPX_ASSERT_MSG(false, "transient allocator frame size and frame count must be non-zero");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((pCreateInfo->alignment == 0) || ((pCreateInfo->alignment & (pCreateInfo->alignment - 1)) != 0)) {
+        PPX_ASSERT_MSG(false, "transient allocator alignment must be a power of 2");
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mFrames.resize(pCreateInfo->frameCount);
+    for (auto& frame : mFrames) {
+        grfx::BufferCreateInfo createInfo = {};
+        createInfo.size                   = RoundUp<uint64_t>(pCreateInfo->frameSize, PPX_CONSTANT_BUFFER_ALIGNMENT);
+        createInfo.usageFlags             = pCreateInfo->usageFlags;
+        createInfo.memoryUsage            = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        createInfo.initialState           = grfx::RESOURCE_STATE_GENERAL;
+
+        Result ppxres = GetDevice()->CreateBuffer(&createInfo, &frame.buffer);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed creating transient allocator buffer");
+            return ppxres;
+        }
+
+        // Buffers stay mapped for the lifetime of the allocator
+        void* pMappedAddress = nullptr;
+        ppxres               = frame.buffer->MapMemory(0, &pMappedAddress);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed mapping transient allocator buffer");
+            return ppxres;
+        }
+        frame.pMappedAddress = static_cast<char*>(pMappedAddress);
+    }
+
+    mFrameIndex = 0;
+    mOffset     = 0;
+
+    return ppx::SUCCESS;
+}
+
+void TransientAllocator::DestroyApiObjects()
+{
+    for (auto& frame : mFrames) {
+        if (frame.buffer) {
+            if (!IsNull(frame.pMappedAddress)) {
+                frame.buffer->UnmapMemory();
+                frame.pMappedAddress = nullptr;
+            }
+            GetDevice()->DestroyBuffer(frame.buffer);
+            frame.buffer.Reset();
+        }
+    }
+    mFrames.clear();
+}
+
+grfx::BufferPtr TransientAllocator::GetBuffer(uint32_t frameIndex) const
+{
+    if (frameIndex >= CountU32(mFrames)) {
+        return nullptr;
+    }
+    return mFrames[frameIndex].buffer;
+}
+
+void TransientAllocator::BeginFrame(uint32_t frameIndex)
+{
+    PPX_ASSERT_MSG(frameIndex < CountU32(mFrames), "transient allocator frame index out of range");
+    mFrameIndex = frameIndex;
+    mOffset     = 0;
+}
+
+Result TransientAllocator::Allocate(uint64_t size, grfx::TransientAllocation* pAllocation)
+{
+    return Allocate(size, mCreateInfo.alignment, pAllocation);
+}
+
+Result TransientAllocator::Allocate(uint64_t size, uint32_t alignment, grfx::TransientAllocation* pAllocation)
+{
+    PPX_ASSERT_NULL_ARG(pAllocation);
+
+    if ((alignment == 0) || ((alignment & (alignment - 1)) != 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    const Frame&   frame    = mFrames[mFrameIndex];
+    const uint64_t offset   = RoundUp<uint64_t>(mOffset, alignment);
+    const uint64_t capacity = frame.buffer->GetSize();
+    if ((offset > capacity) || (size > (capacity - offset))) {
+        return ppx::ERROR_OUT_OF_MEMORY;
+    }
+
+    pAllocation->pBuffer        = frame.buffer;
+    pAllocation->offset         = offset;
+    pAllocation->size           = size;
+    pAllocation->pMappedAddress = frame.pMappedAddress + offset;
+
+    mOffset = offset + size;
+
+    return ppx::SUCCESS;
+}
+
+Result TransientAllocator::AllocateAndCopy(uint64_t size, const void* pData, grfx::TransientAllocation* pAllocation)
+{
+    PPX_ASSERT_NULL_ARG(pData);
+
+    Result ppxres = Allocate(size, pAllocation);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    std::memcpy(pAllocation->pMappedAddress, pData, static_cast<size_t>(size));
+
+    return ppx::SUCCESS;
+}
+
+} // namespace grfx
+} // namespace ppx
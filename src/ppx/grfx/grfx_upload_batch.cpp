@@ -0,0 +1,459 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/grfx/grfx_upload_batch.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_image.h"
+#include "ppx/grfx/grfx_queue.h"
+#include "ppx/grfx/grfx_sync.h"
+
+namespace ppx {
+namespace grfx {
+
+// Offsets of buffer-to-image copies must satisfy D3D12's placement
+// alignment. Vulkan only requires a multiple of the texel size and 4,
+// which 512 satisfies for every uncompressed format.
+static constexpr uint64_t kImageStagingAlignment  = PPX_D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+static constexpr uint64_t kBufferStagingAlignment = 16;
+
+static uint32_t CalculateRowStride(grfx::Api api, uint32_t rowCopySize)
+{
+    // D3D12 requires rows in the staging buffer to be aligned to 256 bytes,
+    // Vulkan does not. The alignment is based off the number of bytes being
+    // copied rather than the bitmap's row stride, which may be padded.
+    uint32_t apiRowStrideAligement = grfx::IsDx12(api) ? PPX_D3D12_TEXTURE_DATA_PITCH_ALIGNMENT : 1;
+    return RoundUp<uint32_t>(rowCopySize, apiRowStrideAligement);
+}
+
+uint64_t UploadBatch::CalculateStagingSize(grfx::Api api, const Bitmap* pBitmap)
+{
+    PPX_ASSERT_NULL_ARG(pBitmap);
+    uint32_t rowStride = CalculateRowStride(api, pBitmap->GetWidth() * pBitmap->GetPixelStride());
+    return RoundUp<uint64_t>(static_cast<uint64_t>(rowStride) * pBitmap->GetHeight(), kImageStagingAlignment);
+}
+
+UploadBatch::UploadBatch(grfx::Queue* pQueue, uint64_t stagingChunkSize, grfx::Queue* pOwnerQueue)
+    : mQueue(pQueue),
+      mOwnerQueue(pOwnerQueue),
+      mStagingChunkSize(stagingChunkSize)
+{
+    PPX_ASSERT_NULL_ARG(mQueue);
+    PPX_ASSERT_MSG(mStagingChunkSize > 0, "staging chunk size must be greater than zero");
+
+    mTransferOwnership = !IsNull(mOwnerQueue) && mQueue->RequiresOwnershipTransfer(mOwnerQueue);
+}
+
+UploadBatch::~UploadBatch()
+{
+    ReleaseResources();
+}
+
+void UploadBatch::ReleaseResources()
+{
+    // Staging memory must outlive the GPU copies that read from it.
+    if (mSubmitted) {
+        Result ppxres = Wait();
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("UploadBatch: wait for completion failed, staging memory released while potentially in use");
+        }
+    }
+
+    grfx::Device* pDevice = mQueue->GetDevice();
+
+    for (auto& chunk : mStagingChunks) {
+        chunk.buffer->UnmapMemory();
+        pDevice->DestroyBuffer(chunk.buffer);
+    }
+    mStagingChunks.clear();
+    mUploads.clear();
+
+    if (mCommandBuffer) {
+        mQueue->DestroyCommandBuffer(mCommandBuffer);
+        mCommandBuffer.Reset();
+    }
+
+    if (mAcquireCommandBuffer) {
+        mOwnerQueue->DestroyCommandBuffer(mAcquireCommandBuffer);
+        mAcquireCommandBuffer.Reset();
+    }
+
+    if (mCompletionSemaphore) {
+        pDevice->DestroySemaphore(mCompletionSemaphore);
+        mCompletionSemaphore.Reset();
+    }
+}
+
+Result UploadBatch::AllocateStaging(uint64_t size, uint64_t alignment, grfx::Buffer** ppBuffer, uint64_t* pOffset, char** ppMappedAddress)
+{
+    // Sub-allocate from the most recent chunk if it has room
+    if (!mStagingChunks.empty()) {
+        StagingChunk& chunk  = mStagingChunks.back();
+        uint64_t      offset = RoundUp<uint64_t>(chunk.usedSize, alignment);
+        if ((offset + size) <= chunk.size) {
+            chunk.usedSize   = offset + size;
+            *ppBuffer        = chunk.buffer;
+            *pOffset         = offset;
+            *ppMappedAddress = chunk.pMappedAddress + offset;
+            return ppx::SUCCESS;
+        }
+    }
+
+    // Otherwise start a new chunk, oversized uploads get a dedicated one
+    StagingChunk chunk = {};
+    chunk.size         = std::max<uint64_t>(size, mStagingChunkSize);
+
+    grfx::BufferCreateInfo ci      = {};
+    ci.size                        = chunk.size;
+    ci.usageFlags.bits.transferSrc = true;
+    ci.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+    Result ppxres = mQueue->GetDevice()->CreateBuffer(&ci, &chunk.buffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    void* pMappedAddress = nullptr;
+    ppxres               = chunk.buffer->MapMemory(0, &pMappedAddress);
+    if (Failed(ppxres)) {
+        mQueue->GetDevice()->DestroyBuffer(chunk.buffer);
+        return ppxres;
+    }
+    chunk.pMappedAddress = static_cast<char*>(pMappedAddress);
+    chunk.usedSize       = size;
+
+    mStagingChunks.push_back(chunk);
+    mStagingSize += chunk.size;
+
+    *ppBuffer        = chunk.buffer;
+    *pOffset         = 0;
+    *ppMappedAddress = chunk.pMappedAddress;
+
+    return ppx::SUCCESS;
+}
+
+Result UploadBatch::AddBufferUpload(
+    uint64_t            size,
+    const void*         pSrcData,
+    grfx::Buffer*       pDstBuffer,
+    uint64_t            dstOffset,
+    grfx::ResourceState stateBefore,
+    grfx::ResourceState stateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pSrcData);
+    PPX_ASSERT_NULL_ARG(pDstBuffer);
+    PPX_ASSERT_MSG(!mSubmitted, "cannot add uploads to a submitted batch");
+    PPX_ASSERT_MSG(dstOffset <= UINT32_MAX, "destination offset exceeds copy limit");
+
+    if (mSubmitted) {
+        return ppx::ERROR_FAILED;
+    }
+    if ((dstOffset + size) > pDstBuffer->GetSize()) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    Upload   upload    = {};
+    uint64_t srcOffset = 0;
+    char*    pStaging  = nullptr;
+
+    Result ppxres = AllocateStaging(size, kBufferStagingAlignment, &upload.pSrcBuffer, &srcOffset, &pStaging);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    memcpy(pStaging, pSrcData, static_cast<size_t>(size));
+
+    upload.pDstBuffer                  = pDstBuffer;
+    upload.bufferCopy.size             = size;
+    upload.bufferCopy.srcBuffer.offset = srcOffset;
+    upload.bufferCopy.dstBuffer.offset = static_cast<uint32_t>(dstOffset);
+    upload.stateBefore                 = stateBefore;
+    upload.stateAfter                  = stateAfter;
+    mUploads.push_back(upload);
+
+    return ppx::SUCCESS;
+}
+
+Result UploadBatch::AddBitmapUpload(
+    const Bitmap*       pBitmap,
+    grfx::Image*        pDstImage,
+    uint32_t            mipLevel,
+    uint32_t            arrayLayer,
+    grfx::ResourceState stateBefore,
+    grfx::ResourceState stateAfter)
+{
+    PPX_ASSERT_NULL_ARG(pBitmap);
+    PPX_ASSERT_NULL_ARG(pDstImage);
+    PPX_ASSERT_MSG(!mSubmitted, "cannot add uploads to a submitted batch");
+
+    if (mSubmitted) {
+        return ppx::ERROR_FAILED;
+    }
+
+    // This is the number of bytes we're going to copy per row.
+    uint32_t rowCopySize            = pBitmap->GetWidth() * pBitmap->GetPixelStride();
+    uint32_t stagingBufferRowStride = CalculateRowStride(mQueue->GetDevice()->GetApi(), rowCopySize);
+    uint64_t stagingSize            = static_cast<uint64_t>(stagingBufferRowStride) * pBitmap->GetHeight();
+
+    Upload   upload    = {};
+    uint64_t srcOffset = 0;
+    char*    pStaging  = nullptr;
+
+    Result ppxres = AllocateStaging(stagingSize, kImageStagingAlignment, &upload.pSrcBuffer, &srcOffset, &pStaging);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    const char*    pSrc         = pBitmap->GetData();
+    const uint32_t srcRowStride = pBitmap->GetRowStride();
+    for (uint32_t y = 0; y < pBitmap->GetHeight(); ++y) {
+        memcpy(pStaging, pSrc, rowCopySize);
+        pSrc += srcRowStride;
+        pStaging += stagingBufferRowStride;
+    }
+
+    upload.pDstImage                           = pDstImage;
+    upload.imageCopy.srcBuffer.imageWidth      = pBitmap->GetWidth();
+    upload.imageCopy.srcBuffer.imageHeight     = pBitmap->GetHeight();
+    upload.imageCopy.srcBuffer.imageRowStride  = stagingBufferRowStride;
+    upload.imageCopy.srcBuffer.footprintOffset = srcOffset;
+    upload.imageCopy.srcBuffer.footprintWidth  = pBitmap->GetWidth();
+    upload.imageCopy.srcBuffer.footprintHeight = pBitmap->GetHeight();
+    upload.imageCopy.srcBuffer.footprintDepth  = 1;
+    upload.imageCopy.dstImage.mipLevel         = mipLevel;
+    upload.imageCopy.dstImage.arrayLayer       = arrayLayer;
+    upload.imageCopy.dstImage.arrayLayerCount  = 1;
+    upload.imageCopy.dstImage.x                = 0;
+    upload.imageCopy.dstImage.y                = 0;
+    upload.imageCopy.dstImage.z                = 0;
+    upload.imageCopy.dstImage.width            = pBitmap->GetWidth();
+    upload.imageCopy.dstImage.height           = pBitmap->GetHeight();
+    upload.imageCopy.dstImage.depth            = 1;
+    upload.stateBefore                         = stateBefore;
+    upload.stateAfter                          = stateAfter;
+    mUploads.push_back(upload);
+
+    return ppx::SUCCESS;
+}
+
+bool UploadBatch::IsSameDestination(const Upload& a, const Upload& b)
+{
+    if (!IsNull(a.pDstBuffer)) {
+        return a.pDstBuffer == b.pDstBuffer;
+    }
+    return (a.pDstImage == b.pDstImage) &&
+           (a.imageCopy.dstImage.mipLevel == b.imageCopy.dstImage.mipLevel) &&
+           (a.imageCopy.dstImage.arrayLayer == b.imageCopy.dstImage.arrayLayer);
+}
+
+bool UploadBatch::IsFirstUpload(size_t index) const
+{
+    for (size_t i = 0; i < index; ++i) {
+        if (IsSameDestination(mUploads[i], mUploads[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UploadBatch::IsLastUpload(size_t index) const
+{
+    for (size_t i = index + 1; i < mUploads.size(); ++i) {
+        if (IsSameDestination(mUploads[i], mUploads[index])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void UploadBatch::RecordFinalBarriers(grfx::CommandBuffer* pCommandBuffer) const
+{
+    // With an ownership transfer this records the release half on the
+    // upload queue and the matching acquire half on the owner queue.
+    const grfx::Queue* pSrcQueue = mTransferOwnership ? mQueue : nullptr;
+    const grfx::Queue* pDstQueue = mTransferOwnership ? mOwnerQueue : nullptr;
+
+    for (size_t i = 0; i < mUploads.size(); ++i) {
+        if (!IsLastUpload(i)) {
+            continue;
+        }
+
+        const Upload& upload = mUploads[i];
+        if (!IsNull(upload.pDstBuffer)) {
+            pCommandBuffer->BufferResourceBarrier(upload.pDstBuffer, grfx::RESOURCE_STATE_COPY_DST, upload.stateAfter, pSrcQueue, pDstQueue);
+        }
+        else {
+            pCommandBuffer->TransitionImageLayout(upload.pDstImage, upload.imageCopy.dstImage.mipLevel, 1, upload.imageCopy.dstImage.arrayLayer, 1, grfx::RESOURCE_STATE_COPY_DST, upload.stateAfter, pSrcQueue, pDstQueue);
+        }
+    }
+}
+
+Result UploadBatch::Submit()
+{
+    PPX_ASSERT_MSG(!mSubmitted, "upload batch has already been submitted");
+    if (mSubmitted) {
+        return ppx::ERROR_FAILED;
+    }
+
+    // Nothing to do, Wait() and IsComplete() treat this as done.
+    if (mUploads.empty()) {
+        mSubmitted = true;
+        return ppx::SUCCESS;
+    }
+
+    grfx::Device* pDevice = mQueue->GetDevice();
+
+    Result ppxres = mQueue->CreateCommandBuffer(&mCommandBuffer, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    if (mTransferOwnership) {
+        ppxres = mOwnerQueue->CreateCommandBuffer(&mAcquireCommandBuffer, 0, 0);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    grfx::SemaphoreCreateInfo semaphoreCreateInfo = {};
+    semaphoreCreateInfo.semaphoreType             = grfx::SEMAPHORE_TYPE_TIMELINE;
+    semaphoreCreateInfo.initialValue              = 0;
+
+    ppxres = pDevice->CreateSemaphore(&semaphoreCreateInfo, &mCompletionSemaphore);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Build upload command buffer
+    {
+        ppxres = mCommandBuffer->Begin();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Transition each destination into the copy state once, ahead
+        // of all copies, so the barriers can be batched by the driver.
+        //
+        // The upload queue doesn't own the destination when ownership is
+        // transferred, so its previous contents are discarded. Each upload
+        // overwrites its whole subresource so nothing of value is lost.
+        for (size_t i = 0; i < mUploads.size(); ++i) {
+            if (!IsFirstUpload(i)) {
+                continue;
+            }
+
+            const Upload&       upload      = mUploads[i];
+            grfx::ResourceState stateBefore = mTransferOwnership ? grfx::RESOURCE_STATE_UNDEFINED : upload.stateBefore;
+            if (!IsNull(upload.pDstBuffer)) {
+                mCommandBuffer->BufferResourceBarrier(upload.pDstBuffer, stateBefore, grfx::RESOURCE_STATE_COPY_DST);
+            }
+            else {
+                mCommandBuffer->TransitionImageLayout(upload.pDstImage, upload.imageCopy.dstImage.mipLevel, 1, upload.imageCopy.dstImage.arrayLayer, 1, stateBefore, grfx::RESOURCE_STATE_COPY_DST);
+            }
+        }
+
+        for (auto& upload : mUploads) {
+            if (!IsNull(upload.pDstBuffer)) {
+                mCommandBuffer->CopyBufferToBuffer(&upload.bufferCopy, upload.pSrcBuffer, upload.pDstBuffer);
+            }
+            else {
+                mCommandBuffer->CopyBufferToImage(&upload.imageCopy, upload.pSrcBuffer, upload.pDstImage);
+            }
+        }
+
+        // Transition each destination into its final state after the
+        // last copy that targets it.
+        RecordFinalBarriers(mCommandBuffer);
+
+        ppxres = mCommandBuffer->End();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Build acquire command buffer
+    if (mTransferOwnership) {
+        ppxres = mAcquireCommandBuffer->Begin();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        RecordFinalBarriers(mAcquireCommandBuffer);
+
+        ppxres = mAcquireCommandBuffer->End();
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Submit upload command buffer
+    grfx::Semaphore* pSemaphore = mCompletionSemaphore;
+
+    grfx::SubmitInfo submit     = {};
+    submit.commandBufferCount   = 1;
+    submit.ppCommandBuffers     = &mCommandBuffer;
+    submit.signalSemaphoreCount = 1;
+    submit.ppSignalSemaphores   = &pSemaphore;
+    submit.signalValues         = {kUploadValue};
+
+    ppxres = mQueue->Submit(&submit);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    mSubmitted       = true;
+    mCompletionValue = kUploadValue;
+
+    // Submit acquire command buffer, ordered after the upload
+    if (mTransferOwnership) {
+        grfx::SubmitInfo acquire     = {};
+        acquire.commandBufferCount   = 1;
+        acquire.ppCommandBuffers     = &mAcquireCommandBuffer;
+        acquire.waitSemaphoreCount   = 1;
+        acquire.ppWaitSemaphores     = &pSemaphore;
+        acquire.waitValues           = {kUploadValue};
+        acquire.signalSemaphoreCount = 1;
+        acquire.ppSignalSemaphores   = &pSemaphore;
+        acquire.signalValues         = {kAcquireValue};
+
+        ppxres = mOwnerQueue->Submit(&acquire);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mCompletionValue = kAcquireValue;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result UploadBatch::Wait(uint64_t timeout) const
+{
+    if (!mSubmitted || !mCompletionSemaphore) {
+        return ppx::SUCCESS;
+    }
+    return mCompletionSemaphore->Wait(mCompletionValue, timeout);
+}
+
+bool UploadBatch::IsComplete() const
+{
+    if (!mSubmitted) {
+        return false;
+    }
+    if (!mCompletionSemaphore) {
+        return true;
+    }
+    return mCompletionSemaphore->GetCounterValue() >= mCompletionValue;
+}
+
+} // namespace grfx
+} // namespace ppx
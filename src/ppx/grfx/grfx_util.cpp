@@ -46,6 +46,7 @@ const char* ToString(grfx::DescriptorType value)
         case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : return "grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC"; break;
         case grfx::DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : return "grfx::DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC"; break;
         case grfx::DESCRIPTOR_TYPE_INPUT_ATTACHMENT       : return "grfx::DESCRIPTOR_TYPE_INPUT_ATTACHMENT"; break;
+        case grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE : return "grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE"; break;
     }
     // clang-format on
     return "<unknown descriptor type>";
@@ -21,31 +21,52 @@ namespace ppx {
 namespace grfx {
 namespace vk {
 
-Result Buffer::CreateApiObjects(const grfx::BufferCreateInfo* pCreateInfo)
+Result Buffer::CreateVkBuffer(VkBuffer* pBuffer) const
 {
-    vk::Device* pDevice = ToApi(GetDevice());
+    VkDeviceSize alignedSize = static_cast<VkDeviceSize>(mCreateInfo.size);
+    if (mCreateInfo.usageFlags.bits.uniformBuffer) {
+        alignedSize = RoundUp<VkDeviceSize>(mCreateInfo.size, PPX_UNIFORM_BUFFER_ALIGNMENT);
+    }
 
-    VkDeviceSize alignedSize = static_cast<VkDeviceSize>(pCreateInfo->size);
-    if (pCreateInfo->usageFlags.bits.uniformBuffer) {
-        alignedSize = RoundUp<VkDeviceSize>(pCreateInfo->size, PPX_UNIFORM_BUFFER_ALIGNMENT);
+    VkBufferUsageFlags usage = ToVkBufferUsageFlags(mCreateInfo.usageFlags);
+    if (IsMovable()) {
+        usage |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    }
+
+    // Descriptor buffers reference uniform and storage buffers by address
+    const VkBufferUsageFlags descriptorUsage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    if (ToApi(GetDevice())->UsesDescriptorBuffers() && ((usage & descriptorUsage) != 0)) {
+        usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
     }
 
     VkBufferCreateInfo createInfo    = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
     createInfo.flags                 = 0;
     createInfo.size                  = alignedSize;
-    createInfo.usage                 = ToVkBufferUsageFlags(pCreateInfo->usageFlags);
+    createInfo.usage                 = usage;
     createInfo.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
     createInfo.queueFamilyIndexCount = 0;
     createInfo.pQueueFamilyIndices   = nullptr;
 
     VkAllocationCallbacks* pAllocator = nullptr;
 
-    VkResult vkres = vk::CreateBuffer(ToApi(GetDevice())->GetVkDevice(), &createInfo, pAllocator, &mBuffer);
+    VkResult vkres = vk::CreateBuffer(ToApi(GetDevice())->GetVkDevice(), &createInfo, pAllocator, pBuffer);
     if (vkres != VK_SUCCESS) {
         PPX_ASSERT_MSG(false, "vkCreateBuffer failed: " << ToString(vkres));
         return ppx::ERROR_API_FAILURE;
     }
 
+    return ppx::SUCCESS;
+}
+
+Result Buffer::CreateApiObjects(const grfx::BufferCreateInfo* pCreateInfo)
+{
+    vk::Device* pDevice = ToApi(GetDevice());
+
+    Result ppxres = CreateVkBuffer(&mBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
     // Allocate memory
     {
         VmaMemoryUsage memoryUsage = ToVmaMemoryUsage(pCreateInfo->memoryUsage);
@@ -97,6 +118,11 @@ Result Buffer::CreateApiObjects(const grfx::BufferCreateInfo* pCreateInfo)
 
 void Buffer::DestroyApiObjects()
 {
+    if (mMoveBuffer) {
+        vkDestroyBuffer(ToApi(GetDevice())->GetVkDevice(), mMoveBuffer, nullptr);
+        mMoveBuffer.Reset();
+    }
+
     if (mAllocation) {
         vmaFreeMemory(ToApi(GetDevice())->GetVmaAllocator(), mAllocation);
         mAllocation.Reset();
@@ -135,6 +161,81 @@ void Buffer::UnmapMemory()
         mAllocation);
 }
 
+VkDeviceAddress Buffer::GetVkDeviceAddress() const
+{
+#if defined(VK_KHR_buffer_device_address)
+    if (IsNull(GetBufferDeviceAddressKHR)) {
+        PPX_ASSERT_MSG(false, "buffer device address is not available");
+        return 0;
+    }
+
+    VkBufferDeviceAddressInfoKHR addressInfo = {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR};
+    addressInfo.buffer                       = mBuffer;
+    return GetBufferDeviceAddressKHR(ToApi(GetDevice())->GetVkDevice(), &addressInfo);
+#else
+    return 0;
+#endif
+}
+
+uint64_t Buffer::GetDeviceAddress() const
+{
+    PPX_ASSERT_MSG(GetUsageFlags().bits.shaderDeviceAddress, "buffer was not created with shaderDeviceAddress usage");
+    return static_cast<uint64_t>(GetVkDeviceAddress());
+}
+
+bool Buffer::IsMovable() const
+{
+    // Device addresses are baked into shader data and acceleration structures
+    const grfx::BufferUsageFlags& usage = mCreateInfo.usageFlags;
+    if (usage.bits.shaderDeviceAddress || usage.bits.accelerationStructureStorage || usage.bits.accelerationStructureInput || usage.bits.rayTracing) {
+        return false;
+    }
+    return GetDevice()->IsDefragmentationEnabled() && (mCreateInfo.memoryUsage == grfx::MEMORY_USAGE_GPU_ONLY);
+}
+
+Result Buffer::BeginMove(VmaAllocation dstAllocation, VkCommandBuffer commandBuffer)
+{
+    PPX_ASSERT_MSG(!mMoveBuffer, "buffer move already in progress");
+
+    Result ppxres = CreateVkBuffer(&mMoveBuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    VkResult vkres = vmaBindBufferMemory(ToApi(GetDevice())->GetVmaAllocator(), dstAllocation, mMoveBuffer);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vmaBindBufferMemory failed: " << ToString(vkres));
+        vkDestroyBuffer(ToApi(GetDevice())->GetVkDevice(), mMoveBuffer, nullptr);
+        mMoveBuffer.Reset();
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    VkBufferCopy region = {};
+    region.size         = static_cast<VkDeviceSize>(mCreateInfo.size);
+    vkCmdCopyBuffer(commandBuffer, mBuffer, mMoveBuffer, 1, &region);
+
+    return ppx::SUCCESS;
+}
+
+void Buffer::FinishMove(bool cancel)
+{
+    PPX_ASSERT_MSG(mMoveBuffer, "no buffer move in progress");
+
+    if (cancel) {
+        vkDestroyBuffer(ToApi(GetDevice())->GetVkDevice(), mMoveBuffer, nullptr);
+    }
+    else {
+        vkDestroyBuffer(ToApi(GetDevice())->GetVkDevice(), mBuffer, nullptr);
+        mBuffer = mMoveBuffer;
+    }
+    mMoveBuffer.Reset();
+}
+
+void Buffer::UpdateAllocationInfo()
+{
+    vmaGetAllocationInfo(ToApi(GetDevice())->GetVmaAllocator(), mAllocation, &mAllocationInfo);
+}
+
 } // namespace vk
 } // namespace grfx
 } // namespace ppx
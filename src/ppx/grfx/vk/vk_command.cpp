@@ -19,8 +19,10 @@
 #include "ppx/grfx/vk/vk_image.h"
 #include "ppx/grfx/vk/vk_query.h"
 #include "ppx/grfx/vk/vk_queue.h"
+#include "ppx/grfx/vk/vk_ray_tracing.h"
 #include "ppx/grfx/vk/vk_pipeline.h"
 #include "ppx/grfx/vk/vk_render_pass.h"
+#include "ppx/frame_arena.h"
 
 #include "ppx/grfx/vk/vk_profiler_fn_wrapper.h"
 
@@ -35,7 +37,7 @@ Result CommandBuffer::CreateApiObjects(const grfx::internal::CommandBufferCreate
 {
     VkCommandBufferAllocateInfo vkai = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
     vkai.commandPool                 = ToApi(pCreateInfo->pPool)->GetVkCommandPool();
-    vkai.level                       = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    vkai.level                       = pCreateInfo->secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     vkai.commandBufferCount          = 1;
 
     VkResult vkres = vk::AllocateCommandBuffers(
@@ -65,7 +67,79 @@ void CommandBuffer::DestroyApiObjects()
 
 Result CommandBuffer::Begin()
 {
+    mShaderObjectsBound    = false;
+    mViewportCount         = 0;
+    mScissorCount          = 0;
+    mDescriptorBufferBound = false;
+
     VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    if (IsReusable()) {
+        vkbi.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    }
+
+    VkResult vkres = vk::BeginCommandBuffer(mCommandBuffer, &vkbi);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkBeginCommandBuffer failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result CommandBuffer::BeginSecondaryImpl(const grfx::CommandBufferInheritanceInfo* pInheritanceInfo)
+{
+    mShaderObjectsBound    = false;
+    mViewportCount         = 0;
+    mScissorCount          = 0;
+    mDescriptorBufferBound = false;
+
+    VkCommandBufferInheritanceInfo vkii = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+
+    VkCommandBufferBeginInfo vkbi = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    vkbi.pInheritanceInfo         = &vkii;
+    if (IsReusable()) {
+        vkbi.flags |= VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+    }
+
+#if defined(VK_KHR_dynamic_rendering)
+    std::vector<VkFormat>                   colorFormats;
+    VkCommandBufferInheritanceRenderingInfo renderingInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO};
+#endif
+
+    const vk::RenderPass* pRenderPass = IsNull(pInheritanceInfo->pRenderPass) ? nullptr : ToApi(pInheritanceInfo->pRenderPass);
+    if (!IsNull(pRenderPass) && pRenderPass->UsesDynamicRendering()) {
+#if defined(VK_KHR_dynamic_rendering)
+        renderingInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+        for (uint32_t i = 0; i < pRenderPass->GetRenderTargetCount(); ++i) {
+            grfx::RenderTargetViewPtr rtv = pRenderPass->GetRenderTargetView(i);
+            colorFormats.push_back(ToVkFormat(rtv->GetFormat()));
+            renderingInfo.rasterizationSamples = ToVkSampleCount(rtv->GetSampleCount());
+        }
+        renderingInfo.colorAttachmentCount    = CountU32(colorFormats);
+        renderingInfo.pColorAttachmentFormats = DataPtr(colorFormats);
+
+        grfx::DepthStencilViewPtr dsv = pRenderPass->GetDepthStencilView();
+        if (dsv) {
+            const grfx::FormatDesc* pFormatDesc = GetFormatDescription(dsv->GetFormat());
+            if (pFormatDesc->aspect & grfx::FORMAT_ASPECT_DEPTH) {
+                renderingInfo.depthAttachmentFormat = ToVkFormat(dsv->GetFormat());
+            }
+            if (pFormatDesc->aspect & grfx::FORMAT_ASPECT_STENCIL) {
+                renderingInfo.stencilAttachmentFormat = ToVkFormat(dsv->GetFormat());
+            }
+            renderingInfo.rasterizationSamples = ToVkSampleCount(dsv->GetSampleCount());
+        }
+
+        vkii.pNext = &renderingInfo;
+        vkbi.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+#endif
+    }
+    else if (!IsNull(pRenderPass)) {
+        vkii.renderPass  = pRenderPass->GetVkRenderPass();
+        vkii.subpass     = 0;
+        vkii.framebuffer = pRenderPass->GetVkFramebuffer();
+        vkbi.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    }
 
     VkResult vkres = vk::BeginCommandBuffer(mCommandBuffer, &vkbi);
     if (vkres != VK_SUCCESS) {
@@ -78,6 +152,8 @@ Result CommandBuffer::Begin()
 
 Result CommandBuffer::End()
 {
+    FlushBarriers();
+
     VkResult vkres = vk::EndCommandBuffer(mCommandBuffer);
     if (vkres != VK_SUCCESS) {
         PPX_ASSERT_MSG(false, "vkEndCommandBuffer failed: " << ToString(vkres));
@@ -87,10 +163,27 @@ Result CommandBuffer::End()
     return ppx::SUCCESS;
 }
 
+void CommandBuffer::ExecuteCommandsImpl(
+    uint32_t                          commandBufferCount,
+    const grfx::CommandBuffer* const* ppCommandBuffers)
+{
+    std::vector<VkCommandBuffer> commandBuffers(commandBufferCount);
+    for (uint32_t i = 0; i < commandBufferCount; ++i) {
+        commandBuffers[i] = ToApi(ppCommandBuffers[i])->GetVkCommandBuffer();
+    }
+
+    vkCmdExecuteCommands(mCommandBuffer, commandBufferCount, DataPtr(commandBuffers));
+}
+
 void CommandBuffer::BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginInfo)
 {
+    if (ToApi(pBeginInfo->pRenderPass)->UsesDynamicRendering()) {
+        BeginDynamicRenderPass(pBeginInfo);
+        return;
+    }
+
     VkRect2D rect = {};
-    rect.offset   = {pBeginInfo->renderArea.x, pBeginInfo->renderArea.x};
+    rect.offset   = {pBeginInfo->renderArea.x, pBeginInfo->renderArea.y};
     rect.extent   = {pBeginInfo->renderArea.width, pBeginInfo->renderArea.height};
 
     uint32_t     clearValueCount                         = 0;
@@ -114,14 +207,97 @@ void CommandBuffer::BeginRenderPassImpl(const grfx::RenderPassBeginInfo* pBeginI
     vkbi.clearValueCount       = clearValueCount;
     vkbi.pClearValues          = clearValues;
 
-    vk::CmdBeginRenderPass(mCommandBuffer, &vkbi, VK_SUBPASS_CONTENTS_INLINE);
+    VkSubpassContents contents = pBeginInfo->secondaryCommandBuffers ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+
+    vk::CmdBeginRenderPass(mCommandBuffer, &vkbi, contents);
 }
 
 void CommandBuffer::EndRenderPassImpl()
 {
+#if defined(VK_KHR_dynamic_rendering)
+    if (ToApi(GetCurrentRenderPass())->UsesDynamicRendering()) {
+        vk::CmdEndRenderingKHR(mCommandBuffer);
+        return;
+    }
+#endif
+
     vk::CmdEndRenderPass(mCommandBuffer);
 }
 
+void CommandBuffer::BeginDynamicRenderPass(const grfx::RenderPassBeginInfo* pBeginInfo)
+{
+#if defined(VK_KHR_dynamic_rendering)
+    const vk::RenderPass* pRenderPass = ToApi(pBeginInfo->pRenderPass);
+
+    VkRect2D rect = {};
+    rect.offset   = {pBeginInfo->renderArea.x, pBeginInfo->renderArea.y};
+    rect.extent   = {pBeginInfo->renderArea.width, pBeginInfo->renderArea.height};
+
+    // Same attachments, ops and layouts as the VkRenderPass the pass would
+    // otherwise be created with, see vk::RenderPass::CreateRenderPass()
+    VkRenderingAttachmentInfo colorAttachments[PPX_MAX_RENDER_TARGETS] = {};
+    for (uint32_t i = 0; i < pRenderPass->GetRenderTargetCount(); ++i) {
+        grfx::RenderTargetViewPtr  rtv             = pRenderPass->GetRenderTargetView(i);
+        VkRenderingAttachmentInfo& colorAttachment = colorAttachments[i];
+        colorAttachment.sType                      = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        colorAttachment.imageView                  = ToApi(rtv.Get())->GetVkImageView();
+        colorAttachment.imageLayout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.resolveMode                = VK_RESOLVE_MODE_NONE;
+        colorAttachment.loadOp                     = ToVkAttachmentLoadOp(rtv->GetLoadOp());
+        colorAttachment.storeOp                    = ToVkAttachmentStoreOp(rtv->GetStoreOp());
+        if (i < pBeginInfo->RTVClearCount) {
+            colorAttachment.clearValue.color = ToVkClearColorValue(pBeginInfo->RTVClearValues[i]);
+        }
+
+        grfx::RenderTargetViewPtr resolveView = pRenderPass->GetResolveView(i);
+        if (resolveView) {
+            // Integer formats can't be averaged
+            const grfx::FormatDataType dataType = GetFormatDescription(rtv->GetFormat())->dataType;
+            const bool                 integer  = (dataType == grfx::FORMAT_DATA_TYPE_UINT) || (dataType == grfx::FORMAT_DATA_TYPE_SINT);
+            colorAttachment.resolveMode         = integer ? VK_RESOLVE_MODE_SAMPLE_ZERO_BIT : VK_RESOLVE_MODE_AVERAGE_BIT;
+            colorAttachment.resolveImageView    = ToApi(resolveView.Get())->GetVkImageView();
+            colorAttachment.resolveImageLayout  = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        }
+    }
+
+    VkRenderingInfo vkri      = {VK_STRUCTURE_TYPE_RENDERING_INFO};
+    vkri.flags                = pBeginInfo->secondaryCommandBuffers ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0;
+    vkri.renderArea           = rect;
+    vkri.layerCount           = 1;
+    vkri.viewMask             = 0;
+    vkri.colorAttachmentCount = pRenderPass->GetRenderTargetCount();
+    vkri.pColorAttachments    = colorAttachments;
+
+    VkRenderingAttachmentInfo depthAttachment   = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    VkRenderingAttachmentInfo stencilAttachment = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+
+    grfx::DepthStencilViewPtr dsv = pRenderPass->GetDepthStencilView();
+    if (dsv) {
+        const grfx::FormatDesc* pFormatDesc = GetFormatDescription(dsv->GetFormat());
+
+        depthAttachment.imageView               = ToApi(dsv.Get())->GetVkImageView();
+        depthAttachment.imageLayout             = pRenderPass->GetDepthStencilLayout();
+        depthAttachment.resolveMode             = VK_RESOLVE_MODE_NONE;
+        depthAttachment.loadOp                  = ToVkAttachmentLoadOp(dsv->GetDepthLoadOp());
+        depthAttachment.storeOp                 = ToVkAttachmentStoreOp(dsv->GetDepthStoreOp());
+        depthAttachment.clearValue.depthStencil = ToVkClearDepthStencilValue(pBeginInfo->DSVClearValue);
+
+        stencilAttachment         = depthAttachment;
+        stencilAttachment.loadOp  = ToVkAttachmentLoadOp(dsv->GetStencilLoadOp());
+        stencilAttachment.storeOp = ToVkAttachmentStoreOp(dsv->GetStencilStoreOp());
+
+        if (pFormatDesc->aspect & grfx::FORMAT_ASPECT_DEPTH) {
+            vkri.pDepthAttachment = &depthAttachment;
+        }
+        if (pFormatDesc->aspect & grfx::FORMAT_ASPECT_STENCIL) {
+            vkri.pStencilAttachment = &stencilAttachment;
+        }
+    }
+
+    vk::CmdBeginRenderingKHR(mCommandBuffer, &vkri);
+#endif
+}
+
 void CommandBuffer::BeginRenderingImpl(const grfx::RenderingInfo* pRenderingInfo)
 {
     vk::Device* pDevice = ToApi(GetDevice());
@@ -131,7 +307,7 @@ void CommandBuffer::BeginRenderingImpl(const grfx::RenderingInfo* pRenderingInfo
     }
 #if defined(VK_KHR_dynamic_rendering)
     VkRect2D rect = {};
-    rect.offset   = {pRenderingInfo->renderArea.x, pRenderingInfo->renderArea.x};
+    rect.offset   = {pRenderingInfo->renderArea.x, pRenderingInfo->renderArea.y};
     rect.extent   = {pRenderingInfo->renderArea.width, pRenderingInfo->renderArea.height};
 
     std::vector<VkRenderingAttachmentInfo> colorAttachmentDescs;
@@ -416,6 +592,103 @@ void CommandBuffer::ClearDepthStencil(
         &clearRect);
 }
 
+void CommandBuffer::ApplyQueueFamilyTransferMasks(
+    uint32_t              srcQueueFamilyIndex,
+    uint32_t              dstQueueFamilyIndex,
+    VkPipelineStageFlags& srcStageMask,
+    VkAccessFlags&        srcAccessMask,
+    VkPipelineStageFlags& dstStageMask,
+    VkAccessFlags&        dstAccessMask) const
+{
+    if (srcQueueFamilyIndex == dstQueueFamilyIndex) {
+        return;
+    }
+
+    // Release and acquire barriers must specify identical layouts and
+    // queue family indices, but each queue only executes its own half:
+    //   - Release: dst access is ignored and must not wait on stages the
+    //     source queue may not support.
+    //   - Acquire: src access is ignored, the semaphore wait between the
+    //     two submissions provides the execution dependency.
+    //
+    uint32_t queueFamilyIndex = ToApi(mCreateInfo.pPool->GetQueue())->GetQueueFamilyIndex();
+    if (queueFamilyIndex == srcQueueFamilyIndex) {
+        dstStageMask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        dstAccessMask = 0;
+    }
+    else if (queueFamilyIndex == dstQueueFamilyIndex) {
+        srcStageMask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        srcAccessMask = 0;
+    }
+}
+
+#if defined(VK_KHR_synchronization2)
+void CommandBuffer::GetBarrier2Masks(
+    grfx::ResourceState       beforeState,
+    grfx::ResourceState       afterState,
+    VkPipelineStageFlags2KHR& srcStageMask,
+    VkAccessFlags2KHR&        srcAccessMask,
+    VkPipelineStageFlags2KHR& dstStageMask,
+    VkAccessFlags2KHR&        dstAccessMask,
+    VkImageLayout&            oldLayout,
+    VkImageLayout&            newLayout) const
+{
+    vk::Device* pDevice = ToApi(GetDevice());
+
+    grfx::CommandType commandType = GetCommandType();
+
+    Result ppxres = ToVkBarrierSrc2(beforeState, commandType, pDevice->GetDeviceFeatures(), srcStageMask, srcAccessMask, oldLayout);
+    PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get src barrier data");
+
+    ppxres = ToVkBarrierDst2(afterState, commandType, pDevice->GetDeviceFeatures(), dstStageMask, dstAccessMask, newLayout);
+    PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get dst barrier data");
+}
+
+void CommandBuffer::ApplyQueueFamilyTransferMasks2(
+    uint32_t                  srcQueueFamilyIndex,
+    uint32_t                  dstQueueFamilyIndex,
+    VkPipelineStageFlags2KHR& srcStageMask,
+    VkAccessFlags2KHR&        srcAccessMask,
+    VkPipelineStageFlags2KHR& dstStageMask,
+    VkAccessFlags2KHR&        dstAccessMask) const
+{
+    if (srcQueueFamilyIndex == dstQueueFamilyIndex) {
+        return;
+    }
+
+    // Same split as ApplyQueueFamilyTransferMasks, but synchronization2
+    // allows NONE for the half that isn't executed on this queue.
+    uint32_t queueFamilyIndex = ToApi(mCreateInfo.pPool->GetQueue())->GetQueueFamilyIndex();
+    if (queueFamilyIndex == srcQueueFamilyIndex) {
+        dstStageMask  = VK_PIPELINE_STAGE_2_NONE_KHR;
+        dstAccessMask = VK_ACCESS_2_NONE_KHR;
+    }
+    else if (queueFamilyIndex == dstQueueFamilyIndex) {
+        srcStageMask  = VK_PIPELINE_STAGE_2_NONE_KHR;
+        srcAccessMask = VK_ACCESS_2_NONE_KHR;
+    }
+}
+
+void CommandBuffer::PipelineBarrier2(
+    uint32_t                         imageBarrierCount,
+    const VkImageMemoryBarrier2KHR*  pImageBarriers,
+    uint32_t                         bufferBarrierCount,
+    const VkBufferMemoryBarrier2KHR* pBufferBarriers)
+{
+    VkDependencyInfoKHR dependencyInfo      = {VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR};
+    dependencyInfo.dependencyFlags          = 0;
+    dependencyInfo.memoryBarrierCount       = 0;
+    dependencyInfo.pMemoryBarriers          = nullptr;
+    dependencyInfo.bufferMemoryBarrierCount = bufferBarrierCount;
+    dependencyInfo.pBufferMemoryBarriers    = pBufferBarriers;
+    dependencyInfo.imageMemoryBarrierCount  = imageBarrierCount;
+    dependencyInfo.pImageMemoryBarriers     = pImageBarriers;
+
+    PPX_ASSERT_MSG(vk::CmdPipelineBarrier2KHR != nullptr, "Function not found");
+    vk::CmdPipelineBarrier2KHR(mCommandBuffer, &dependencyInfo);
+}
+#endif // defined(VK_KHR_synchronization2)
+
 void CommandBuffer::TransitionImageLayout(
     const grfx::Image*  pImage,
     uint32_t            mipLevel,
@@ -427,6 +700,8 @@ void CommandBuffer::TransitionImageLayout(
     const grfx::Queue*  pSrcQueue,
     const grfx::Queue*  pDstQueue)
 {
+    FlushBarriers();
+
     PPX_ASSERT_NULL_ARG(pImage);
 
     if ((!IsNull(pSrcQueue) && IsNull(pDstQueue)) || (IsNull(pSrcQueue) && !IsNull(pDstQueue))) {
@@ -462,6 +737,25 @@ void CommandBuffer::TransitionImageLayout(
 
     const vk::Image* pApiImage = ToApi(pImage);
 
+#if defined(VK_KHR_synchronization2)
+    if (ToApi(GetDevice())->HasSynchronization2()) {
+        VkImageMemoryBarrier2KHR barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR};
+        GetBarrier2Masks(beforeState, afterState, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask, barrier.oldLayout, barrier.newLayout);
+        ApplyQueueFamilyTransferMasks2(srcQueueFamilyIndex, dstQueueFamilyIndex, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask);
+        barrier.srcQueueFamilyIndex             = srcQueueFamilyIndex;
+        barrier.dstQueueFamilyIndex             = dstQueueFamilyIndex;
+        barrier.image                           = pApiImage->GetVkImage();
+        barrier.subresourceRange.aspectMask     = pApiImage->GetVkImageAspectFlags();
+        barrier.subresourceRange.baseMipLevel   = mipLevel;
+        barrier.subresourceRange.levelCount     = mipLevelCount;
+        barrier.subresourceRange.baseArrayLayer = arrayLayer;
+        barrier.subresourceRange.layerCount     = arrayLayerCount;
+
+        PipelineBarrier2(1, &barrier, 0, nullptr);
+        return;
+    }
+#endif
+
     VkPipelineStageFlags srcStageMask    = InvalidValue<VkPipelineStageFlags>();
     VkPipelineStageFlags dstStageMask    = InvalidValue<VkPipelineStageFlags>();
     VkAccessFlags        srcAccessMask   = InvalidValue<VkAccessFlags>();
@@ -492,6 +786,8 @@ void CommandBuffer::TransitionImageLayout(
         newLayout);
     PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get dst barrier data");
 
+    ApplyQueueFamilyTransferMasks(srcQueueFamilyIndex, dstQueueFamilyIndex, srcStageMask, srcAccessMask, dstStageMask, dstAccessMask);
+
     VkImageMemoryBarrier barrier            = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
     barrier.srcAccessMask                   = srcAccessMask;
     barrier.dstAccessMask                   = dstAccessMask;
@@ -519,6 +815,150 @@ void CommandBuffer::TransitionImageLayout(
         &barrier);       // pImageMemoryBarriers);
 }
 
+void CommandBuffer::ResourceBarriersImpl(
+    uint32_t             imageBarrierCount,
+    const ImageBarrier*  pImageBarriers,
+    uint32_t             bufferBarrierCount,
+    const BufferBarrier* pBufferBarriers)
+{
+    vk::Device*       pDevice     = ToApi(GetDevice());
+    grfx::CommandType commandType = GetCommandType();
+
+    FrameArena::Scope scope(FrameArena::GetThreadArena());
+
+#if defined(VK_KHR_synchronization2)
+    // Each barrier carries its own masks, so batching doesn't widen the
+    // dependency of any individual transition.
+    if (pDevice->HasSynchronization2()) {
+        FrameVector<VkImageMemoryBarrier2KHR> imageBarriers(imageBarrierCount, {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR}, scope.GetAllocator<VkImageMemoryBarrier2KHR>());
+        for (uint32_t i = 0; i < imageBarrierCount; ++i) {
+            const ImageBarrier&       src       = pImageBarriers[i];
+            const vk::Image*          pApiImage = ToApi(src.pImage);
+            VkImageMemoryBarrier2KHR& barrier   = imageBarriers[i];
+
+            GetBarrier2Masks(src.beforeState, src.afterState, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask, barrier.oldLayout, barrier.newLayout);
+            barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image                           = pApiImage->GetVkImage();
+            barrier.subresourceRange.aspectMask     = pApiImage->GetVkImageAspectFlags();
+            barrier.subresourceRange.baseMipLevel   = src.mipLevel;
+            barrier.subresourceRange.levelCount     = src.mipLevelCount;
+            barrier.subresourceRange.baseArrayLayer = src.arrayLayer;
+            barrier.subresourceRange.layerCount     = src.arrayLayerCount;
+        }
+
+        FrameVector<VkBufferMemoryBarrier2KHR> bufferBarriers(bufferBarrierCount, {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR}, scope.GetAllocator<VkBufferMemoryBarrier2KHR>());
+        for (uint32_t i = 0; i < bufferBarrierCount; ++i) {
+            const BufferBarrier&       src       = pBufferBarriers[i];
+            VkBufferMemoryBarrier2KHR& barrier   = bufferBarriers[i];
+            VkImageLayout              oldLayout = InvalidValue<VkImageLayout>();
+            VkImageLayout              newLayout = InvalidValue<VkImageLayout>();
+
+            GetBarrier2Masks(src.beforeState, src.afterState, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask, oldLayout, newLayout);
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer              = ToApi(src.pBuffer)->GetVkBuffer();
+            barrier.offset              = static_cast<VkDeviceSize>(0);
+            barrier.size                = static_cast<VkDeviceSize>(src.pBuffer->GetSize());
+        }
+
+        PipelineBarrier2(CountU32(imageBarriers), DataPtr(imageBarriers), CountU32(bufferBarriers), DataPtr(bufferBarriers));
+        return;
+    }
+#endif
+
+    VkPipelineStageFlags srcStageMask = 0;
+    VkPipelineStageFlags dstStageMask = 0;
+
+    FrameVector<VkImageMemoryBarrier> imageBarriers(imageBarrierCount, VkImageMemoryBarrier{}, scope.GetAllocator<VkImageMemoryBarrier>());
+    for (uint32_t i = 0; i < imageBarrierCount; ++i) {
+        const ImageBarrier& src       = pImageBarriers[i];
+        const vk::Image*    pApiImage = ToApi(src.pImage);
+
+        VkPipelineStageFlags srcStage  = InvalidValue<VkPipelineStageFlags>();
+        VkPipelineStageFlags dstStage  = InvalidValue<VkPipelineStageFlags>();
+        VkAccessFlags        srcAccess = InvalidValue<VkAccessFlags>();
+        VkAccessFlags        dstAccess = InvalidValue<VkAccessFlags>();
+        VkImageLayout        oldLayout = InvalidValue<VkImageLayout>();
+        VkImageLayout        newLayout = InvalidValue<VkImageLayout>();
+
+        Result ppxres = ToVkBarrierSrc(src.beforeState, commandType, pDevice->GetDeviceFeatures(), srcStage, srcAccess, oldLayout);
+        PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get src barrier data");
+        ppxres = ToVkBarrierDst(src.afterState, commandType, pDevice->GetDeviceFeatures(), dstStage, dstAccess, newLayout);
+        PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get dst barrier data");
+
+        srcStageMask |= srcStage;
+        dstStageMask |= dstStage;
+
+        VkImageMemoryBarrier& barrier           = imageBarriers[i];
+        barrier.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask                   = srcAccess;
+        barrier.dstAccessMask                   = dstAccess;
+        barrier.oldLayout                       = oldLayout;
+        barrier.newLayout                       = newLayout;
+        barrier.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image                           = pApiImage->GetVkImage();
+        barrier.subresourceRange.aspectMask     = pApiImage->GetVkImageAspectFlags();
+        barrier.subresourceRange.baseMipLevel   = src.mipLevel;
+        barrier.subresourceRange.levelCount     = src.mipLevelCount;
+        barrier.subresourceRange.baseArrayLayer = src.arrayLayer;
+        barrier.subresourceRange.layerCount     = src.arrayLayerCount;
+    }
+
+    FrameVector<VkBufferMemoryBarrier> bufferBarriers(bufferBarrierCount, VkBufferMemoryBarrier{}, scope.GetAllocator<VkBufferMemoryBarrier>());
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i) {
+        const BufferBarrier& src = pBufferBarriers[i];
+
+        VkPipelineStageFlags srcStage  = InvalidValue<VkPipelineStageFlags>();
+        VkPipelineStageFlags dstStage  = InvalidValue<VkPipelineStageFlags>();
+        VkAccessFlags        srcAccess = InvalidValue<VkAccessFlags>();
+        VkAccessFlags        dstAccess = InvalidValue<VkAccessFlags>();
+        VkImageLayout        oldLayout = InvalidValue<VkImageLayout>();
+        VkImageLayout        newLayout = InvalidValue<VkImageLayout>();
+
+        Result ppxres = ToVkBarrierSrc(src.beforeState, commandType, pDevice->GetDeviceFeatures(), srcStage, srcAccess, oldLayout);
+        PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get src barrier data");
+        ppxres = ToVkBarrierDst(src.afterState, commandType, pDevice->GetDeviceFeatures(), dstStage, dstAccess, newLayout);
+        PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get dst barrier data");
+
+        srcStageMask |= srcStage;
+        dstStageMask |= dstStage;
+
+        VkBufferMemoryBarrier& barrier = bufferBarriers[i];
+        barrier.sType                  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask          = srcAccess;
+        barrier.dstAccessMask          = dstAccess;
+        barrier.srcQueueFamilyIndex    = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex    = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer                 = ToApi(src.pBuffer)->GetVkBuffer();
+        barrier.offset                 = static_cast<VkDeviceSize>(0);
+        barrier.size                   = static_cast<VkDeviceSize>(src.pBuffer->GetSize());
+    }
+
+    vk::CmdPipelineBarrier(
+        mCommandBuffer,           // commandBuffer
+        srcStageMask,             // srcStageMask
+        dstStageMask,             // dstStageMask
+        0,                        // dependencyFlags
+        0,                        // memoryBarrierCount
+        nullptr,                  // pMemoryBarriers
+        CountU32(bufferBarriers), // bufferMemoryBarrierCount
+        DataPtr(bufferBarriers),  // pBufferMemoryBarriers
+        CountU32(imageBarriers),  // imageMemoryBarrierCount
+        DataPtr(imageBarriers));  // pImageMemoryBarriers
+}
+
+void CommandBuffer::AliasingBarrierImpl(const grfx::Image* pBefore, grfx::Image* pAfter)
+{
+    (void)pBefore;
+
+    // Nothing to record: discarding the contents makes the next tracked
+    // transition of pAfter come from UNDEFINED, whose source scope covers
+    // all prior commands and their writes to the shared memory.
+    pAfter->SetTrackedState(grfx::RESOURCE_STATE_UNDEFINED);
+}
+
 void CommandBuffer::BufferResourceBarrier(
     const grfx::Buffer* pBuffer,
     grfx::ResourceState beforeState,
@@ -526,6 +966,8 @@ void CommandBuffer::BufferResourceBarrier(
     const grfx::Queue*  pSrcQueue,
     const grfx::Queue*  pDstQueue)
 {
+    FlushBarriers();
+
     PPX_ASSERT_NULL_ARG(pBuffer);
 
     if ((!IsNull(pSrcQueue) && IsNull(pDstQueue)) || (IsNull(pSrcQueue) && !IsNull(pDstQueue))) {
@@ -561,6 +1003,22 @@ void CommandBuffer::BufferResourceBarrier(
 
     vk::Device* pDevice = ToApi(GetDevice());
 
+#if defined(VK_KHR_synchronization2)
+    if (pDevice->HasSynchronization2()) {
+        VkBufferMemoryBarrier2KHR barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR};
+        GetBarrier2Masks(beforeState, afterState, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask, oldLayout, newLayout);
+        ApplyQueueFamilyTransferMasks2(srcQueueFamilyIndex, dstQueueFamilyIndex, barrier.srcStageMask, barrier.srcAccessMask, barrier.dstStageMask, barrier.dstAccessMask);
+        barrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+        barrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+        barrier.buffer              = ToApi(pBuffer)->GetVkBuffer();
+        barrier.offset              = static_cast<VkDeviceSize>(0);
+        barrier.size                = static_cast<VkDeviceSize>(pBuffer->GetSize());
+
+        PipelineBarrier2(0, nullptr, 1, &barrier);
+        return;
+    }
+#endif
+
     grfx::CommandType commandType = GetCommandType();
 
     Result ppxres = ToVkBarrierSrc(
@@ -581,6 +1039,8 @@ void CommandBuffer::BufferResourceBarrier(
         newLayout);
     PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "couldn't get dst barrier data");
 
+    ApplyQueueFamilyTransferMasks(srcQueueFamilyIndex, dstQueueFamilyIndex, srcStageMask, srcAccessMask, dstStageMask, dstAccessMask);
+
     VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
     barrier.srcAccessMask         = srcAccessMask;
     barrier.dstAccessMask         = dstAccessMask;
@@ -605,32 +1065,116 @@ void CommandBuffer::BufferResourceBarrier(
 
 void CommandBuffer::SetViewports(uint32_t viewportCount, const grfx::Viewport* pViewports)
 {
-    VkViewport viewports[PPX_MAX_VIEWPORTS] = {};
+    PPX_ASSERT_MSG(viewportCount <= PPX_MAX_VIEWPORTS, "viewport count exceeds PPX_MAX_VIEWPORTS");
+
     for (uint32_t i = 0; i < viewportCount; ++i) {
         // clang-format off
-        viewports[i].x        =  pViewports[i].x;
-        viewports[i].y        =  pViewports[i].height;
-        viewports[i].width    =  pViewports[i].width;
-        viewports[i].height   = -pViewports[i].height;
-        viewports[i].minDepth =  pViewports[i].minDepth;
-        viewports[i].maxDepth =  pViewports[i].maxDepth;
+        mViewports[i].x        =  pViewports[i].x;
+        mViewports[i].y        =  pViewports[i].height;
+        mViewports[i].width    =  pViewports[i].width;
+        mViewports[i].height   = -pViewports[i].height;
+        mViewports[i].minDepth =  pViewports[i].minDepth;
+        mViewports[i].maxDepth =  pViewports[i].maxDepth;
         // clang-format on
     }
+    mViewportCount = viewportCount;
+
+#if defined(VK_EXT_shader_object)
+    if (mShaderObjectsBound) {
+        CmdSetViewportWithCountEXT(mCommandBuffer, mViewportCount, mViewports);
+        return;
+    }
+#endif
 
     vkCmdSetViewport(
         mCommandBuffer,
         0,
         viewportCount,
-        viewports);
+        mViewports);
 }
 
 void CommandBuffer::SetScissors(uint32_t scissorCount, const grfx::Rect* pScissors)
 {
+    PPX_ASSERT_MSG(scissorCount <= PPX_MAX_SCISSORS, "scissor count exceeds PPX_MAX_SCISSORS");
+
+    for (uint32_t i = 0; i < scissorCount; ++i) {
+        mScissors[i].offset = {pScissors[i].x, pScissors[i].y};
+        mScissors[i].extent = {pScissors[i].width, pScissors[i].height};
+    }
+    mScissorCount = scissorCount;
+
+#if defined(VK_EXT_shader_object)
+    if (mShaderObjectsBound) {
+        CmdSetScissorWithCountEXT(mCommandBuffer, mScissorCount, mScissors);
+        return;
+    }
+#endif
+
     vkCmdSetScissor(
         mCommandBuffer,
         0,
         scissorCount,
-        reinterpret_cast<const VkRect2D*>(pScissors));
+        mScissors);
+}
+
+void CommandBuffer::SetCullMode(grfx::CullMode cullMode)
+{
+#if defined(VK_EXT_extended_dynamic_state)
+    PPX_ASSERT_MSG(!IsNull(CmdSetCullModeEXT), "extended dynamic state is not supported");
+    CmdSetCullModeEXT(mCommandBuffer, ToVkCullMode(cullMode));
+#else
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported");
+#endif
+}
+
+void CommandBuffer::SetPrimitiveTopology(grfx::PrimitiveTopology topology)
+{
+#if defined(VK_EXT_extended_dynamic_state)
+    PPX_ASSERT_MSG(!IsNull(CmdSetPrimitiveTopologyEXT), "extended dynamic state is not supported");
+    CmdSetPrimitiveTopologyEXT(mCommandBuffer, ToVkPrimitiveTopology(topology));
+#else
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported");
+#endif
+}
+
+void CommandBuffer::SetDepthTestEnable(bool enable)
+{
+#if defined(VK_EXT_extended_dynamic_state)
+    PPX_ASSERT_MSG(!IsNull(CmdSetDepthTestEnableEXT), "extended dynamic state is not supported");
+    CmdSetDepthTestEnableEXT(mCommandBuffer, enable ? VK_TRUE : VK_FALSE);
+#else
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported");
+#endif
+}
+
+void CommandBuffer::SetDepthWriteEnable(bool enable)
+{
+#if defined(VK_EXT_extended_dynamic_state)
+    PPX_ASSERT_MSG(!IsNull(CmdSetDepthWriteEnableEXT), "extended dynamic state is not supported");
+    CmdSetDepthWriteEnableEXT(mCommandBuffer, enable ? VK_TRUE : VK_FALSE);
+#else
+    PPX_ASSERT_MSG(false, "extended dynamic state is not supported");
+#endif
+}
+
+void CommandBuffer::SetBlendEnable(
+    uint32_t    renderTargetCount,
+    const bool* pEnables)
+{
+    PPX_ASSERT_MSG(renderTargetCount <= PPX_MAX_RENDER_TARGETS, "render target count exceeds PPX_MAX_RENDER_TARGETS");
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    PPX_ASSERT_MSG(!IsNull(CmdSetColorBlendEnableEXT), "dynamic blend enable is not supported");
+
+    VkBool32 enables[PPX_MAX_RENDER_TARGETS] = {};
+    for (uint32_t i = 0; i < renderTargetCount; ++i) {
+        enables[i] = pEnables[i] ? VK_TRUE : VK_FALSE;
+    }
+
+    CmdSetColorBlendEnableEXT(mCommandBuffer, 0, renderTargetCount, enables);
+#else
+    PPX_ASSERT_MSG(false, "dynamic blend enable is not supported");
+#endif
 }
 
 void CommandBuffer::BindDescriptorSets(
@@ -658,6 +1202,13 @@ void CommandBuffer::BindDescriptorSets(
         PPX_ASSERT_MSG(false, "setCount exceeds the number of sets in pipeline interface");
     }
 
+#if defined(VK_EXT_descriptor_buffer)
+    if (ToApi(GetDevice())->UsesDescriptorBuffers()) {
+        BindDescriptorBufferSets(bindPoint, pInterface, setCount, ppSets);
+        return;
+    }
+#endif
+
     if (setCount > 0) {
         // Get Vulkan handles
         VkDescriptorSet vkSets[PPX_MAX_BOUND_DESCRIPTOR_SETS] = {VK_NULL_HANDLE};
@@ -709,6 +1260,46 @@ void CommandBuffer::BindDescriptorSets(
     }
 }
 
+void CommandBuffer::BindDescriptorBufferSets(
+    VkPipelineBindPoint               bindPoint,
+    const grfx::PipelineInterface*    pInterface,
+    uint32_t                          setCount,
+    const grfx::DescriptorSet* const* ppSets)
+{
+#if defined(VK_EXT_descriptor_buffer)
+    vk::Device* pDevice = ToApi(GetDevice());
+
+    if (!mDescriptorBufferBound) {
+        VkDescriptorBufferBindingInfoEXT bindingInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT};
+        bindingInfo.address                          = pDevice->GetDescriptorBufferAddress();
+        bindingInfo.usage                            = pDevice->GetDescriptorBufferUsage();
+
+        vk::CmdBindDescriptorBuffersEXT(mCommandBuffer, 1, &bindingInfo);
+        mDescriptorBufferBound = true;
+    }
+
+    // Every set lives in buffer 0, only the offsets differ
+    const std::vector<uint32_t>& setNumbers                                   = pInterface->GetSetNumbers();
+    VkPipelineLayout             layout                                       = ToApi(pInterface)->GetVkPipelineLayout();
+    const uint32_t               bufferIndices[PPX_MAX_BOUND_DESCRIPTOR_SETS] = {0};
+    VkDeviceSize                 offsets[PPX_MAX_BOUND_DESCRIPTOR_SETS]       = {0};
+    for (uint32_t i = 0; i < setCount; ++i) {
+        offsets[i] = ToApi(ppSets[i])->GetDescriptorBufferOffset();
+    }
+
+    if (pInterface->HasConsecutiveSetNumbers()) {
+        vk::CmdSetDescriptorBufferOffsetsEXT(mCommandBuffer, bindPoint, layout, setNumbers[0], setCount, bufferIndices, offsets);
+    }
+    else {
+        for (uint32_t i = 0; i < setCount; ++i) {
+            vk::CmdSetDescriptorBufferOffsetsEXT(mCommandBuffer, bindPoint, layout, setNumbers[i], 1, bufferIndices, &offsets[i]);
+        }
+    }
+#else
+    PPX_ASSERT_MSG(false, "descriptor buffers are not supported");
+#endif
+}
+
 void CommandBuffer::BindGraphicsDescriptorSets(
     const grfx::PipelineInterface*    pInterface,
     uint32_t                          setCount,
@@ -749,7 +1340,7 @@ void CommandBuffer::PushGraphicsConstants(
     PPX_ASSERT_MSG(((dstOffset + count) <= PPX_MAX_PUSH_CONSTANTS), "dstOffset + count (" << (dstOffset + count) << ") exceeds PPX_MAX_PUSH_CONSTANTS (" << PPX_MAX_PUSH_CONSTANTS << ")");
 
     const VkShaderStageFlags shaderStageFlags = ToApi(pInterface)->GetPushConstantShaderStageFlags();
-    if ((shaderStageFlags & VK_SHADER_STAGE_ALL_GRAPHICS) == 0) {
+    if ((shaderStageFlags & ~VK_SHADER_STAGE_COMPUTE_BIT) == 0) {
         PPX_ASSERT_MSG(false, "push constants shader visibility flags in pInterface does not have any graphics stages");
     }
 
@@ -760,6 +1351,23 @@ void CommandBuffer::BindGraphicsPipeline(const grfx::GraphicsPipeline* pPipeline
 {
     PPX_ASSERT_NULL_ARG(pPipeline);
 
+#if defined(VK_EXT_shader_object)
+    if (ToApi(pPipeline)->UsesShaderObjects()) {
+        ToApi(pPipeline)->CmdBindShaderObjects(mCommandBuffer);
+        if (mViewportCount > 0) {
+            CmdSetViewportWithCountEXT(mCommandBuffer, mViewportCount, mViewports);
+        }
+        if (mScissorCount > 0) {
+            CmdSetScissorWithCountEXT(mCommandBuffer, mScissorCount, mScissors);
+        }
+        mShaderObjectsBound = true;
+        return;
+    }
+#endif
+
+    // Binding a pipeline unbinds any shader objects
+    mShaderObjectsBound = false;
+
     vk::CmdBindPipeline(
         mCommandBuffer,
         VK_PIPELINE_BIND_POINT_GRAPHICS,
@@ -857,14 +1465,175 @@ void CommandBuffer::Dispatch(
     uint32_t groupCountY,
     uint32_t groupCountZ)
 {
+    FlushBarriers();
+
     vk::CmdDispatch(mCommandBuffer, groupCountX, groupCountY, groupCountZ);
 }
 
+void CommandBuffer::DrawMeshTasks(
+    uint32_t groupCountX,
+    uint32_t groupCountY,
+    uint32_t groupCountZ)
+{
+    PPX_ASSERT_MSG(ToApi(GetDevice())->MeshShaderSupported(), "mesh shaders are not supported");
+
+#if defined(VK_EXT_mesh_shader)
+    CmdDrawMeshTasksEXT(mCommandBuffer, groupCountX, groupCountY, groupCountZ);
+#endif
+}
+
+void CommandBuffer::DrawIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    uint32_t            drawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+
+    VkBuffer buffer = ToApi(pArgBuffer)->GetVkBuffer();
+
+    // Without multiDrawIndirect drawCount must be 0 or 1
+    if (ToApi(GetDevice())->HasMultiDrawIndirect() || (drawCount <= 1)) {
+        vkCmdDrawIndirect(mCommandBuffer, buffer, static_cast<VkDeviceSize>(argOffset), drawCount, stride);
+        return;
+    }
+    for (uint32_t i = 0; i < drawCount; ++i) {
+        vkCmdDrawIndirect(mCommandBuffer, buffer, static_cast<VkDeviceSize>(argOffset + i * stride), 1, stride);
+    }
+}
+
+void CommandBuffer::DrawIndexedIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    uint32_t            drawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+
+    VkBuffer buffer = ToApi(pArgBuffer)->GetVkBuffer();
+
+    if (ToApi(GetDevice())->HasMultiDrawIndirect() || (drawCount <= 1)) {
+        vkCmdDrawIndexedIndirect(mCommandBuffer, buffer, static_cast<VkDeviceSize>(argOffset), drawCount, stride);
+        return;
+    }
+    for (uint32_t i = 0; i < drawCount; ++i) {
+        vkCmdDrawIndexedIndirect(mCommandBuffer, buffer, static_cast<VkDeviceSize>(argOffset + i * stride), 1, stride);
+    }
+}
+
+void CommandBuffer::DrawIndirectCount(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    const grfx::Buffer* pCountBuffer,
+    uint64_t            countOffset,
+    uint32_t            maxDrawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+    PPX_ASSERT_NULL_ARG(pCountBuffer);
+    PPX_ASSERT_MSG(ToApi(GetDevice())->DrawIndirectCountSupported(), "draw indirect count is not supported");
+
+#if defined(VK_KHR_draw_indirect_count)
+    CmdDrawIndirectCountKHR(
+        mCommandBuffer,
+        ToApi(pArgBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(argOffset),
+        ToApi(pCountBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(countOffset),
+        maxDrawCount,
+        stride);
+#endif
+}
+
+void CommandBuffer::DrawIndexedIndirectCount(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    const grfx::Buffer* pCountBuffer,
+    uint64_t            countOffset,
+    uint32_t            maxDrawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+    PPX_ASSERT_NULL_ARG(pCountBuffer);
+    PPX_ASSERT_MSG(ToApi(GetDevice())->DrawIndirectCountSupported(), "draw indirect count is not supported");
+
+#if defined(VK_KHR_draw_indirect_count)
+    CmdDrawIndexedIndirectCountKHR(
+        mCommandBuffer,
+        ToApi(pArgBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(argOffset),
+        ToApi(pCountBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(countOffset),
+        maxDrawCount,
+        stride);
+#endif
+}
+
+void CommandBuffer::DrawMeshTasksIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    uint32_t            drawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+    PPX_ASSERT_MSG(ToApi(GetDevice())->MeshShaderSupported(), "mesh shaders are not supported");
+
+#if defined(VK_EXT_mesh_shader)
+    VkBuffer buffer = ToApi(pArgBuffer)->GetVkBuffer();
+
+    if (ToApi(GetDevice())->HasMultiDrawIndirect() || (drawCount <= 1)) {
+        CmdDrawMeshTasksIndirectEXT(mCommandBuffer, buffer, static_cast<VkDeviceSize>(argOffset), drawCount, stride);
+        return;
+    }
+    for (uint32_t i = 0; i < drawCount; ++i) {
+        CmdDrawMeshTasksIndirectEXT(mCommandBuffer, buffer, static_cast<VkDeviceSize>(argOffset + i * stride), 1, stride);
+    }
+#endif
+}
+
+void CommandBuffer::DrawMeshTasksIndirectCount(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset,
+    const grfx::Buffer* pCountBuffer,
+    uint64_t            countOffset,
+    uint32_t            maxDrawCount,
+    uint32_t            stride)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+    PPX_ASSERT_NULL_ARG(pCountBuffer);
+    PPX_ASSERT_MSG(ToApi(GetDevice())->MeshShaderSupported(), "mesh shaders are not supported");
+
+#if defined(VK_EXT_mesh_shader)
+    PPX_ASSERT_MSG(!IsNull(CmdDrawMeshTasksIndirectCountEXT), "draw indirect count is not supported");
+    CmdDrawMeshTasksIndirectCountEXT(
+        mCommandBuffer,
+        ToApi(pArgBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(argOffset),
+        ToApi(pCountBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(countOffset),
+        maxDrawCount,
+        stride);
+#endif
+}
+
+void CommandBuffer::DispatchIndirect(
+    const grfx::Buffer* pArgBuffer,
+    uint64_t            argOffset)
+{
+    PPX_ASSERT_NULL_ARG(pArgBuffer);
+
+    FlushBarriers();
+
+    vkCmdDispatchIndirect(mCommandBuffer, ToApi(pArgBuffer)->GetVkBuffer(), static_cast<VkDeviceSize>(argOffset));
+}
+
 void CommandBuffer::CopyBufferToBuffer(
     const grfx::BufferToBufferCopyInfo* pCopyInfo,
     grfx::Buffer*                       pSrcBuffer,
     grfx::Buffer*                       pDstBuffer)
 {
+    FlushBarriers();
+
     VkBufferCopy region = {};
     region.srcOffset    = static_cast<VkDeviceSize>(pCopyInfo->srcBuffer.offset);
     region.dstOffset    = static_cast<VkDeviceSize>(pCopyInfo->dstBuffer.offset);
@@ -883,6 +1652,8 @@ void CommandBuffer::CopyBufferToImage(
     grfx::Buffer*                                   pSrcBuffer,
     grfx::Image*                                    pDstImage)
 {
+    FlushBarriers();
+
     PPX_ASSERT_NULL_ARG(pSrcBuffer);
     PPX_ASSERT_NULL_ARG(pDstImage);
 
@@ -926,6 +1697,8 @@ grfx::ImageToBufferOutputPitch CommandBuffer::CopyImageToBuffer(
     grfx::Image*                       pSrcImage,
     grfx::Buffer*                      pDstBuffer)
 {
+    FlushBarriers();
+
     std::vector<VkBufferImageCopy> regions;
 
     VkBufferImageCopy region               = {};
@@ -989,6 +1762,8 @@ void CommandBuffer::CopyImageToImage(
     grfx::Image*                      pSrcImage,
     grfx::Image*                      pDstImage)
 {
+    FlushBarriers();
+
     bool isSourceDepthStencil = grfx::GetFormatDescription(pSrcImage->GetFormat())->aspect == grfx::FORMAT_ASPECT_DEPTH_STENCIL;
     bool isDestDepthStencil   = grfx::GetFormatDescription(pDstImage->GetFormat())->aspect == grfx::FORMAT_ASPECT_DEPTH_STENCIL;
     PPX_ASSERT_MSG(isSourceDepthStencil == isDestDepthStencil, "both images in an image copy must be depth-stencil if one is depth-stencil");
@@ -1040,6 +1815,8 @@ void CommandBuffer::BlitImage(
     grfx::Image*               pSrcImage,
     grfx::Image*               pDstImage)
 {
+    FlushBarriers();
+
     bool isSourceDepthOrStencil = grfx::GetFormatDescription(pSrcImage->GetFormat())->aspect & grfx::FORMAT_ASPECT_DEPTH_STENCIL;
     bool isDestDepthOrStencil   = grfx::GetFormatDescription(pDstImage->GetFormat())->aspect & grfx::FORMAT_ASPECT_DEPTH_STENCIL;
     if (isSourceDepthOrStencil || isDestDepthOrStencil) {
@@ -1096,6 +1873,40 @@ void CommandBuffer::BlitImage(
         filter);
 }
 
+void CommandBuffer::ResolveImage(
+    const grfx::ImageResolveInfo* pResolveInfo,
+    grfx::Image*                  pSrcImage,
+    grfx::Image*                  pDstImage)
+{
+    PPX_ASSERT_MSG(pSrcImage->GetSampleCount() != grfx::SAMPLE_COUNT_1, "resolve source must be multisampled");
+    PPX_ASSERT_MSG(pDstImage->GetSampleCount() == grfx::SAMPLE_COUNT_1, "resolve destination must have a single sample");
+    PPX_ASSERT_MSG(pSrcImage->GetFormat() == pDstImage->GetFormat(), "both images in a resolve must have the same format");
+
+    FlushBarriers();
+
+    VkImageResolve region                = {};
+    region.srcSubresource.aspectMask     = DetermineAspectMask(ToApi(pSrcImage)->GetVkFormat());
+    region.srcSubresource.mipLevel       = 0;
+    region.srcSubresource.baseArrayLayer = pResolveInfo->srcImage.arrayLayer;
+    region.srcSubresource.layerCount     = pResolveInfo->srcImage.arrayLayerCount;
+    region.srcOffset                     = {0, 0, 0};
+    region.dstSubresource.aspectMask     = DetermineAspectMask(ToApi(pDstImage)->GetVkFormat());
+    region.dstSubresource.mipLevel       = pResolveInfo->dstImage.mipLevel;
+    region.dstSubresource.baseArrayLayer = pResolveInfo->dstImage.arrayLayer;
+    region.dstSubresource.layerCount     = pResolveInfo->srcImage.arrayLayerCount;
+    region.dstOffset                     = {0, 0, 0};
+    region.extent                        = {pSrcImage->GetWidth(), pSrcImage->GetHeight(), 1};
+
+    vkCmdResolveImage(
+        mCommandBuffer,
+        ToApi(pSrcImage)->GetVkImage(),
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        ToApi(pDstImage)->GetVkImage(),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &region);
+}
+
 void CommandBuffer::BeginQuery(
     const grfx::Query* pQuery,
     uint32_t           queryIndex)
@@ -1151,6 +1962,205 @@ void CommandBuffer::ResolveQueryData(
     vkCmdCopyQueryPoolResults(mCommandBuffer, ToApi(pQuery)->GetVkQueryPool(), startIndex, numQueries, ToApi(pQuery)->GetReadBackBuffer(), 0, ToApi(pQuery)->GetQueryTypeSize(), flags);
 }
 
+void CommandBuffer::ResolveOcclusionPredicates(
+    const grfx::Query* pQuery,
+    uint32_t           firstQuery,
+    uint32_t           queryCount,
+    grfx::Buffer*      pDstBuffer,
+    uint64_t           dstOffset)
+{
+    PPX_ASSERT_NULL_ARG(pQuery);
+    PPX_ASSERT_NULL_ARG(pDstBuffer);
+    PPX_ASSERT_MSG(pQuery->GetType() == grfx::QUERY_TYPE_OCCLUSION, "query must be an occlusion query");
+    PPX_ASSERT_MSG((firstQuery + queryCount) <= pQuery->GetCount(), "invalid query index/number");
+    PPX_ASSERT_MSG((dstOffset + queryCount * PPX_OCCLUSION_PREDICATE_SIZE) <= pDstBuffer->GetSize(), "predicates exceed destination buffer");
+
+    // Conditional rendering reads the low 32 bits of each sample count, the
+    // wait is on the GPU and doesn't stall the CPU
+    BufferResourceBarrier(pDstBuffer, grfx::RESOURCE_STATE_PREDICATION, grfx::RESOURCE_STATE_COPY_DST);
+    vkCmdCopyQueryPoolResults(
+        mCommandBuffer,
+        ToApi(pQuery)->GetVkQueryPool(),
+        firstQuery,
+        queryCount,
+        ToApi(pDstBuffer)->GetVkBuffer(),
+        static_cast<VkDeviceSize>(dstOffset),
+        PPX_OCCLUSION_PREDICATE_SIZE,
+        VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_64_BIT);
+    BufferResourceBarrier(pDstBuffer, grfx::RESOURCE_STATE_COPY_DST, grfx::RESOURCE_STATE_PREDICATION);
+}
+
+void CommandBuffer::BeginConditionalRendering(
+    const grfx::Buffer* pBuffer,
+    uint64_t            offset)
+{
+#if defined(VK_EXT_conditional_rendering)
+    PPX_ASSERT_NULL_ARG(pBuffer);
+    PPX_ASSERT_MSG(ToApi(GetDevice())->ConditionalRenderingSupported(), "conditional rendering is not supported");
+    PPX_ASSERT_MSG((offset % PPX_OCCLUSION_PREDICATE_SIZE) == 0, "predicate offset must be a multiple of PPX_OCCLUSION_PREDICATE_SIZE");
+
+    VkConditionalRenderingBeginInfoEXT beginInfo = {VK_STRUCTURE_TYPE_CONDITIONAL_RENDERING_BEGIN_INFO_EXT};
+    beginInfo.buffer                             = ToApi(pBuffer)->GetVkBuffer();
+    beginInfo.offset                             = static_cast<VkDeviceSize>(offset);
+    beginInfo.flags                              = 0;
+
+    vk::CmdBeginConditionalRenderingEXT(mCommandBuffer, &beginInfo);
+#else
+    PPX_ASSERT_MSG(false, "conditional rendering is not supported");
+#endif
+}
+
+void CommandBuffer::EndConditionalRendering()
+{
+#if defined(VK_EXT_conditional_rendering)
+    vk::CmdEndConditionalRenderingEXT(mCommandBuffer);
+#else
+    PPX_ASSERT_MSG(false, "conditional rendering is not supported");
+#endif
+}
+
+void CommandBuffer::BuildAccelerationStructures(
+    uint32_t                                    count,
+    const grfx::AccelerationStructureBuildInfo* pInfos)
+{
+#if defined(VK_KHR_acceleration_structure)
+    PPX_ASSERT_MSG(ToApi(GetDevice())->AccelerationStructureSupported(), "acceleration structures are not supported");
+    if (count == 0) {
+        return;
+    }
+
+    // Sized up front, the build infos point into the geometry vectors
+    std::vector<vk::AccelerationStructureBuildGeometry>          geometries(count);
+    std::vector<VkAccelerationStructureBuildGeometryInfoKHR>     buildInfos(count);
+    std::vector<VkAccelerationStructureBuildRangeInfoKHR>        ranges;
+    std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> rangePointers(count);
+
+    uint32_t rangeCount = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        rangeCount += (pInfos[i].pInputs->type == grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) ? pInfos[i].pInputs->geometryCount : 1;
+    }
+    ranges.reserve(rangeCount);
+
+    for (uint32_t i = 0; i < count; ++i) {
+        const grfx::AccelerationStructureBuildInfo& info   = pInfos[i];
+        const bool                                  update = !IsNull(info.pSrc);
+
+        Result ppxres = ToVkAccelerationStructureBuildGeometry(info.pInputs, update, &geometries[i]);
+        PPX_ASSERT_MSG(ppxres == ppx::SUCCESS, "invalid acceleration structure build inputs");
+
+        VkAccelerationStructureBuildGeometryInfoKHR& buildInfo = geometries[i].buildInfo;
+        buildInfo.srcAccelerationStructure                     = update ? ToApi(info.pSrc)->GetVkAccelerationStructure() : VK_NULL_HANDLE;
+        buildInfo.dstAccelerationStructure                     = ToApi(info.pDst)->GetVkAccelerationStructure();
+        buildInfo.scratchData.deviceAddress                    = ToApi(info.pScratch)->GetVkDeviceAddress() + info.scratchOffset;
+        buildInfos[i]                                          = buildInfo;
+
+        rangePointers[i] = DataPtr(ranges) + ranges.size();
+        for (uint32_t primitiveCount : geometries[i].primitiveCounts) {
+            VkAccelerationStructureBuildRangeInfoKHR range = {};
+            range.primitiveCount                           = primitiveCount;
+            ranges.push_back(range);
+        }
+    }
+
+    CmdBuildAccelerationStructuresKHR(mCommandBuffer, count, DataPtr(buildInfos), DataPtr(rangePointers));
+#else
+    PPX_ASSERT_MSG(false, "acceleration structures are not supported");
+#endif
+}
+
+void CommandBuffer::CopyAccelerationStructure(
+    const grfx::AccelerationStructure* pSrc,
+    grfx::AccelerationStructure*       pDst,
+    bool                               compact)
+{
+#if defined(VK_KHR_acceleration_structure)
+    PPX_ASSERT_NULL_ARG(pSrc);
+    PPX_ASSERT_NULL_ARG(pDst);
+
+    VkCopyAccelerationStructureInfoKHR copyInfo = {VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR};
+    copyInfo.src                                = ToApi(pSrc)->GetVkAccelerationStructure();
+    copyInfo.dst                                = ToApi(pDst)->GetVkAccelerationStructure();
+    copyInfo.mode                               = compact ? VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR : VK_COPY_ACCELERATION_STRUCTURE_MODE_CLONE_KHR;
+
+    CmdCopyAccelerationStructureKHR(mCommandBuffer, &copyInfo);
+#else
+    PPX_ASSERT_MSG(false, "acceleration structures are not supported");
+#endif
+}
+
+void CommandBuffer::WriteAccelerationStructureCompactedSizes(
+    uint32_t                                  count,
+    const grfx::AccelerationStructure* const* ppAccelerationStructures,
+    grfx::Query*                              pQuery,
+    uint32_t                                  firstQuery)
+{
+#if defined(VK_KHR_acceleration_structure)
+    PPX_ASSERT_NULL_ARG(pQuery);
+    PPX_ASSERT_MSG(pQuery->GetType() == grfx::QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE, "invalid query type");
+    PPX_ASSERT_MSG((firstQuery + count) <= pQuery->GetCount(), "invalid query index/number");
+
+    std::vector<VkAccelerationStructureKHR> accelerationStructures(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        accelerationStructures[i] = ToApi(ppAccelerationStructures[i])->GetVkAccelerationStructure();
+    }
+
+    CmdWriteAccelerationStructuresPropertiesKHR(
+        mCommandBuffer,
+        count,
+        DataPtr(accelerationStructures),
+        VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR,
+        ToApi(pQuery)->GetVkQueryPool(),
+        firstQuery);
+#else
+    PPX_ASSERT_MSG(false, "acceleration structures are not supported");
+#endif
+}
+
+void CommandBuffer::AccelerationStructureBarrier()
+{
+#if defined(VK_KHR_acceleration_structure)
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask   = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+    barrier.dstAccessMask   = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(
+        mCommandBuffer,                                         // commandBuffer
+        VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, // srcStageMask
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,                     // dstStageMask
+        0,                                                      // dependencyFlags
+        1,                                                      // memoryBarrierCount
+        &barrier,                                               // pMemoryBarriers
+        0,                                                      // bufferMemoryBarrierCount
+        nullptr,                                                // pBufferMemoryBarriers
+        0,                                                      // imageMemoryBarrierCount
+        nullptr);                                               // pImageMemoryBarriers
+#else
+    PPX_ASSERT_MSG(false, "acceleration structures are not supported");
+#endif
+}
+
+void CommandBuffer::BeginDebugLabel(const char* pLabel)
+{
+    PPX_ASSERT_NULL_ARG(pLabel);
+    if (CmdBeginDebugUtilsLabelEXT == nullptr) {
+        return;
+    }
+
+    VkDebugUtilsLabelEXT label = {VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+    label.pLabelName           = pLabel;
+
+    CmdBeginDebugUtilsLabelEXT(mCommandBuffer, &label);
+}
+
+void CommandBuffer::EndDebugLabel()
+{
+    if (CmdEndDebugUtilsLabelEXT == nullptr) {
+        return;
+    }
+
+    CmdEndDebugUtilsLabelEXT(mCommandBuffer);
+}
+
 // -------------------------------------------------------------------------------------------------
 // CommandPool
 // -------------------------------------------------------------------------------------------------
@@ -16,6 +16,7 @@
 #include "ppx/grfx/vk/vk_buffer.h"
 #include "ppx/grfx/vk/vk_device.h"
 #include "ppx/grfx/vk/vk_image.h"
+#include "ppx/grfx/vk/vk_ray_tracing.h"
 
 #include "ppx/grfx/vk/vk_profiler_fn_wrapper.h"
 
@@ -42,6 +43,11 @@ Result DescriptorPool::CreateApiObjects(const grfx::DescriptorPoolCreateInfo* pC
     if (pCreateInfo->storageBufferDynamic > 0) poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, pCreateInfo->storageBufferDynamic});
     if (pCreateInfo->inputAttachment      > 0) poolSizes.push_back({VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT      , pCreateInfo->inputAttachment     });
     // clang-format on
+#if defined(VK_KHR_acceleration_structure)
+    if (pCreateInfo->accelerationStructure > 0) {
+        poolSizes.push_back({VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, pCreateInfo->accelerationStructure});
+    }
+#endif
     if (pCreateInfo->structuredBuffer > 0) {
         auto it = FindIf(
             poolSizes,
@@ -91,6 +97,12 @@ void DescriptorPool::DestroyApiObjects()
 // -------------------------------------------------------------------------------------------------
 Result DescriptorSet::CreateApiObjects(const grfx::internal::DescriptorSetCreateInfo* pCreateInfo)
 {
+#if defined(VK_EXT_descriptor_buffer)
+    if (ToApi(GetDevice())->UsesDescriptorBuffers()) {
+        return CreateDescriptorBufferRange();
+    }
+#endif
+
     mDescriptorPool = ToApi(pCreateInfo->pPool)->GetVkDescriptorPool();
 
     VkDescriptorSetLayout layout = ToApi(pCreateInfo->pLayout)->GetVkDescriptorSetLayout();
@@ -115,12 +127,22 @@ Result DescriptorSet::CreateApiObjects(const grfx::internal::DescriptorSetCreate
     mImageInfoStore.resize(count);
     mBufferInfoStore.resize(count);
     mTexelBufferStore.resize(count);
+    mAccelerationStructureInfoStore.resize(count);
+    mAccelerationStructureStore.resize(count);
 
     return ppx::SUCCESS;
 }
 
 void DescriptorSet::DestroyApiObjects()
 {
+#if defined(VK_EXT_descriptor_buffer)
+    if (mUsesDescriptorBuffer) {
+        ToApi(GetDevice())->FreeDescriptorBufferRange(mDescriptorBufferOffset);
+        mDescriptorBufferOffset = 0;
+        mUsesDescriptorBuffer   = false;
+    }
+#endif
+
     if (mDescriptorSet) {
         vk::FreeDescriptorSets(
             ToApi(GetDevice())->GetVkDevice(),
@@ -142,22 +164,32 @@ Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDe
         return ppx::ERROR_UNEXPECTED_COUNT_VALUE;
     }
 
+#if defined(VK_EXT_descriptor_buffer)
+    if (mUsesDescriptorBuffer) {
+        return UpdateDescriptorBuffer(writeCount, pWrites);
+    }
+#endif
+
     if (CountU32(mWriteStore) < writeCount) {
         mWriteStore.resize(writeCount);
         mImageInfoStore.resize(writeCount);
         mBufferInfoStore.resize(writeCount);
         mTexelBufferStore.resize(writeCount);
+        mAccelerationStructureInfoStore.resize(writeCount);
+        mAccelerationStructureStore.resize(writeCount);
     }
 
-    mImageCount       = 0;
-    mBufferCount      = 0;
-    mTexelBufferCount = 0;
+    mImageCount                 = 0;
+    mBufferCount                = 0;
+    mTexelBufferCount           = 0;
+    mAccelerationStructureCount = 0;
     for (mWriteCount = 0; mWriteCount < writeCount; ++mWriteCount) {
         const grfx::WriteDescriptor& srcWrite = pWrites[mWriteCount];
 
         VkDescriptorImageInfo*  pImageInfo       = nullptr;
         VkBufferView*           pTexelBufferView = nullptr;
         VkDescriptorBufferInfo* pBufferInfo      = nullptr;
+        const void*             pNext            = nullptr;
 
         VkDescriptorType descriptorType = ToVkDescriptorType(srcWrite.type);
         switch (descriptorType) {
@@ -223,10 +255,27 @@ Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDe
                 // Increment count
                 mBufferCount += 1;
             } break;
+
+#if defined(VK_KHR_acceleration_structure)
+            case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
+                PPX_ASSERT_MSG(mAccelerationStructureCount < mAccelerationStructureStore.size(), "acceleration structure count exceeds acceleration structure store capacity");
+                VkAccelerationStructureKHR&                   accelerationStructure = mAccelerationStructureStore[mAccelerationStructureCount];
+                VkWriteDescriptorSetAccelerationStructureKHR& info                  = mAccelerationStructureInfoStore[mAccelerationStructureCount];
+                // Fill out info, the handle is chained to the write
+                accelerationStructure           = ToApi(srcWrite.pAccelerationStructure)->GetVkAccelerationStructure();
+                info                            = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR};
+                info.accelerationStructureCount = 1;
+                info.pAccelerationStructures    = &accelerationStructure;
+                pNext                           = &info;
+                // Increment count
+                mAccelerationStructureCount += 1;
+            } break;
+#endif
         }
 
         VkWriteDescriptorSet& vkWrite = mWriteStore[mWriteCount];
         vkWrite                       = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        vkWrite.pNext                 = pNext;
         vkWrite.dstSet                = mDescriptorSet;
         vkWrite.dstBinding            = srcWrite.binding;
         vkWrite.dstArrayElement       = srcWrite.arrayIndex;
@@ -244,9 +293,117 @@ Result DescriptorSet::UpdateDescriptors(uint32_t writeCount, const grfx::WriteDe
         0,
         nullptr);
 
+    RecordWrites(writeCount, pWrites);
+
     return ppx::SUCCESS;
 }
 
+#if defined(VK_EXT_descriptor_buffer)
+Result DescriptorSet::CreateDescriptorBufferRange()
+{
+    const vk::DescriptorSetLayout* pLayout = ToApi(GetLayout());
+
+    Result ppxres = ToApi(GetDevice())->AllocateDescriptorBufferRange(pLayout->GetDescriptorBufferSize(), &mDescriptorBufferOffset);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    mUsesDescriptorBuffer = true;
+
+    // Immutable samplers are read from the buffer like any other sampler
+    for (const grfx::DescriptorBinding& binding : pLayout->GetBindings()) {
+        if (binding.type != grfx::DESCRIPTOR_TYPE_SAMPLER) {
+            continue;
+        }
+        for (uint32_t i = 0; i < CountU32(binding.immutableSamplers); ++i) {
+            VkSampler sampler = ToApi(binding.immutableSamplers[i])->GetVkSampler();
+
+            VkDescriptorGetInfoEXT getInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT};
+            getInfo.type                   = VK_DESCRIPTOR_TYPE_SAMPLER;
+            getInfo.data.pSampler          = &sampler;
+            WriteDescriptorBuffer(binding.binding, i, getInfo);
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result DescriptorSet::UpdateDescriptorBuffer(uint32_t writeCount, const grfx::WriteDescriptor* pWrites)
+{
+    for (uint32_t i = 0; i < writeCount; ++i) {
+        const grfx::WriteDescriptor& srcWrite = pWrites[i];
+
+        VkSampler                  sampler     = VK_NULL_HANDLE;
+        VkDescriptorImageInfo      imageInfo   = {};
+        VkDescriptorAddressInfoEXT addressInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
+
+        VkDescriptorGetInfoEXT getInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT};
+        getInfo.type                   = ToVkDescriptorType(srcWrite.type);
+        switch (getInfo.type) {
+            default: {
+                PPX_ASSERT_MSG(false, "descriptor type not supported with descriptor buffers: " << ToString(getInfo.type) << "(" << getInfo.type << ")");
+                return ppx::ERROR_GRFX_UNKNOWN_DESCRIPTOR_TYPE;
+            } break;
+
+            case VK_DESCRIPTOR_TYPE_SAMPLER: {
+                sampler               = ToApi(srcWrite.pSampler)->GetVkSampler();
+                getInfo.data.pSampler = &sampler;
+            } break;
+
+            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: {
+                imageInfo.sampler                  = ToApi(srcWrite.pSampler)->GetVkSampler();
+                imageInfo.imageView                = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageView();
+                imageInfo.imageLayout              = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageLayout();
+                getInfo.data.pCombinedImageSampler = &imageInfo;
+            } break;
+
+            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT: {
+                imageInfo.imageView   = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageView();
+                imageInfo.imageLayout = ToApi(srcWrite.pImageView->GetResourceView())->GetVkImageLayout();
+                // All image members of the union are the same pointer type
+                getInfo.data.pSampledImage = &imageInfo;
+            } break;
+
+            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+                const vk::Buffer* pBuffer = ToApi(srcWrite.pBuffer);
+                addressInfo.address       = pBuffer->GetVkDeviceAddress() + srcWrite.bufferOffset;
+                addressInfo.range         = (srcWrite.bufferRange == PPX_WHOLE_SIZE) ? (pBuffer->GetSize() - srcWrite.bufferOffset) : srcWrite.bufferRange;
+                addressInfo.format        = VK_FORMAT_UNDEFINED;
+                // Both buffer members of the union are the same pointer type
+                getInfo.data.pUniformBuffer = &addressInfo;
+            } break;
+
+#if defined(VK_KHR_acceleration_structure)
+            case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
+                getInfo.data.accelerationStructure = static_cast<VkDeviceAddress>(srcWrite.pAccelerationStructure->GetDeviceAddress());
+            } break;
+#endif
+        }
+
+        WriteDescriptorBuffer(srcWrite.binding, srcWrite.arrayIndex, getInfo);
+    }
+
+    RecordWrites(writeCount, pWrites);
+
+    return ppx::SUCCESS;
+}
+
+void DescriptorSet::WriteDescriptorBuffer(uint32_t binding, uint32_t arrayIndex, const VkDescriptorGetInfoEXT& getInfo)
+{
+    vk::Device*        pDevice        = ToApi(GetDevice());
+    const size_t       descriptorSize = pDevice->GetDescriptorSize(getInfo.type);
+    const VkDeviceSize offset         = mDescriptorBufferOffset + ToApi(GetLayout())->GetDescriptorBufferBindingOffset(binding) + arrayIndex * descriptorSize;
+
+    vk::GetDescriptorEXT(
+        pDevice->GetVkDevice(),
+        &getInfo,
+        descriptorSize,
+        pDevice->GetDescriptorBufferMappedAddress() + offset);
+}
+#endif
+
 // -------------------------------------------------------------------------------------------------
 // DescriptorSetLayout
 // -------------------------------------------------------------------------------------------------
@@ -258,6 +415,14 @@ Result DescriptorSetLayout::CreateApiObjects(const grfx::DescriptorSetLayoutCrea
         return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
     }
 
+    const bool descriptorBuffer = ToApi(GetDevice())->UsesDescriptorBuffers();
+    if (descriptorBuffer) {
+        Result ppxres = ValidateDescriptorBufferBindings(pCreateInfo);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
     std::vector<std::vector<VkSampler>>       immutableSamplers;
     std::vector<VkDescriptorSetLayoutBinding> vkBindings;
     std::vector<VkDescriptorBindingFlags>     vkBindingFlags;
@@ -269,7 +434,7 @@ Result DescriptorSetLayout::CreateApiObjects(const grfx::DescriptorSetLayoutCrea
         vkBinding.binding                      = baseBinding.binding;
         vkBinding.descriptorType               = ToVkDescriptorType(baseBinding.type);
         vkBinding.descriptorCount              = baseBinding.arrayCount;
-        vkBinding.stageFlags                   = ToVkShaderStageFlags(baseBinding.shaderVisiblity);
+        vkBinding.stageFlags                   = ToVkShaderStageFlags(baseBinding.shaderVisiblity) & ToApi(GetDevice())->GetSupportedShaderStageFlags();
         if (baseBinding.immutableSamplers.size() == 0) {
             vkBinding.pImmutableSamplers = nullptr;
         }
@@ -285,6 +450,10 @@ Result DescriptorSetLayout::CreateApiObjects(const grfx::DescriptorSetLayoutCrea
 
         PPX_CHECKED_CALL(ValidateDescriptorBindingFlags(baseBinding.flags));
         VkDescriptorBindingFlags vkBindingFlag = ToVkDescriptorBindingFlags(baseBinding.flags);
+        if (descriptorBuffer) {
+            // Descriptor buffer memory can always be written while it's bound
+            vkBindingFlag &= ~VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+        }
         vkBindingFlags.push_back(vkBindingFlag);
         if (baseBinding.flags != 0) {
             hasBindingFlags = true;
@@ -305,9 +474,15 @@ Result DescriptorSetLayout::CreateApiObjects(const grfx::DescriptorSetLayoutCrea
     if (pCreateInfo->flags.bits.pushable) {
         vkci.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
     }
-    else {
+    else if (!descriptorBuffer) {
         vkci.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
     }
+#if defined(VK_EXT_descriptor_buffer)
+    // Every layout of a pipeline layout has to use descriptor buffers if one does
+    if (descriptorBuffer) {
+        vkci.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+    }
+#endif
 
     VkResult vkres = vkCreateDescriptorSetLayout(
         ToApi(GetDevice())->GetVkDevice(),
@@ -319,17 +494,62 @@ Result DescriptorSetLayout::CreateApiObjects(const grfx::DescriptorSetLayoutCrea
         return ppx::ERROR_API_FAILURE;
     }
 
+#if defined(VK_EXT_descriptor_buffer)
+    if (descriptorBuffer && !pCreateInfo->flags.bits.pushable) {
+        VkDevice device = ToApi(GetDevice())->GetVkDevice();
+        vk::GetDescriptorSetLayoutSizeEXT(device, mDescriptorSetLayout, &mDescriptorBufferSize);
+        for (const grfx::DescriptorBinding& binding : pCreateInfo->bindings) {
+            VkDeviceSize offset = 0;
+            vk::GetDescriptorSetLayoutBindingOffsetEXT(device, mDescriptorSetLayout, binding.binding, &offset);
+            mDescriptorBufferBindingOffsets[binding.binding] = offset;
+        }
+    }
+#endif
+
     return ppx::SUCCESS;
 }
 
 void DescriptorSetLayout::DestroyApiObjects()
 {
+    mDescriptorBufferSize = 0;
+    mDescriptorBufferBindingOffsets.clear();
+
     if (mDescriptorSetLayout) {
         vkDestroyDescriptorSetLayout(ToApi(GetDevice())->GetVkDevice(), mDescriptorSetLayout, nullptr);
         mDescriptorSetLayout.Reset();
     }
 }
 
+VkDeviceSize DescriptorSetLayout::GetDescriptorBufferBindingOffset(uint32_t binding) const
+{
+    auto it = mDescriptorBufferBindingOffsets.find(binding);
+    if (it == mDescriptorBufferBindingOffsets.end()) {
+        PPX_ASSERT_MSG(false, "binding " << binding << " is not in the descriptor buffer layout");
+        return 0;
+    }
+    return it->second;
+}
+
+Result DescriptorSetLayout::ValidateDescriptorBufferBindings(const grfx::DescriptorSetLayoutCreateInfo* pCreateInfo) const
+{
+    if (pCreateInfo->flags.bits.pushable && !ToApi(GetDevice())->HasDescriptorBufferPushDescriptors()) {
+        PPX_ASSERT_MSG(false, "Descriptor set layout has pushable flag but the device can't push descriptors with descriptor buffers");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    // Dynamic offsets only exist for descriptor sets, descriptor buffers
+    // bind the whole set by its offset instead
+    for (const grfx::DescriptorBinding& binding : pCreateInfo->bindings) {
+        VkDescriptorType type = ToVkDescriptorType(binding.type);
+        if ((type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) || (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)) {
+            PPX_ASSERT_MSG(false, "Dynamic buffer descriptors can't be used with descriptor buffers, binding=" << binding.binding);
+            return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
 Result DescriptorSetLayout::ValidateDescriptorBindingFlags(const grfx::DescriptorBindingFlags& flags) const
 {
     if (flags == 0) {
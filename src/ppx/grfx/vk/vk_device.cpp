@@ -22,16 +22,22 @@
 #include "ppx/grfx/vk/vk_pipeline.h"
 #include "ppx/grfx/vk/vk_queue.h"
 #include "ppx/grfx/vk/vk_query.h"
+#include "ppx/grfx/vk/vk_ray_tracing.h"
 #include "ppx/grfx/vk/vk_render_pass.h"
 #include "ppx/grfx/vk/vk_shader.h"
 #include "ppx/grfx/vk/vk_shading_rate.h"
 #include "ppx/grfx/vk/vk_swapchain.h"
 #include "ppx/grfx/vk/vk_sync.h"
 #include "ppx/grfx/vk/vk_profiler_fn_wrapper.h"
+#include "ppx/fs.h"
 
 #define VMA_IMPLEMENTATION
 #define VMA_VULKAN_VERSION 1002000 // Vulkan 1.2
 #include "vk_mem_alloc.h"
+#include "xxhash.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
 #include <unordered_set>
 
 namespace ppx {
@@ -40,11 +46,103 @@ namespace vk {
 
 PFN_vkCmdPushDescriptorSetKHR CmdPushDescriptorSetKHR = nullptr;
 
+PFN_vkCmdBeginDebugUtilsLabelEXT CmdBeginDebugUtilsLabelEXT = nullptr;
+PFN_vkCmdEndDebugUtilsLabelEXT   CmdEndDebugUtilsLabelEXT   = nullptr;
+
 #if defined(VK_KHR_dynamic_rendering)
 PFN_vkCmdBeginRenderingKHR CmdBeginRenderingKHR = nullptr;
 PFN_vkCmdEndRenderingKHR   CmdEndRenderingKHR   = nullptr;
 #endif
 
+#if defined(VK_KHR_synchronization2)
+PFN_vkCmdPipelineBarrier2KHR CmdPipelineBarrier2KHR = nullptr;
+PFN_vkQueueSubmit2KHR        QueueSubmit2KHR        = nullptr;
+#endif
+
+#if defined(VK_KHR_present_wait)
+PFN_vkWaitForPresentKHR WaitForPresentKHR = nullptr;
+#endif
+
+#if defined(VK_KHR_draw_indirect_count)
+PFN_vkCmdDrawIndirectCountKHR        CmdDrawIndirectCountKHR        = nullptr;
+PFN_vkCmdDrawIndexedIndirectCountKHR CmdDrawIndexedIndirectCountKHR = nullptr;
+#endif
+
+#if defined(VK_EXT_conditional_rendering)
+PFN_vkCmdBeginConditionalRenderingEXT CmdBeginConditionalRenderingEXT = nullptr;
+PFN_vkCmdEndConditionalRenderingEXT   CmdEndConditionalRenderingEXT   = nullptr;
+#endif
+
+#if defined(VK_EXT_mesh_shader)
+PFN_vkCmdDrawMeshTasksEXT              CmdDrawMeshTasksEXT              = nullptr;
+PFN_vkCmdDrawMeshTasksIndirectEXT      CmdDrawMeshTasksIndirectEXT      = nullptr;
+PFN_vkCmdDrawMeshTasksIndirectCountEXT CmdDrawMeshTasksIndirectCountEXT = nullptr;
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state)
+PFN_vkCmdSetCullModeEXT          CmdSetCullModeEXT          = nullptr;
+PFN_vkCmdSetPrimitiveTopologyEXT CmdSetPrimitiveTopologyEXT = nullptr;
+PFN_vkCmdSetDepthTestEnableEXT   CmdSetDepthTestEnableEXT   = nullptr;
+PFN_vkCmdSetDepthWriteEnableEXT  CmdSetDepthWriteEnableEXT  = nullptr;
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state3)
+PFN_vkCmdSetColorBlendEnableEXT CmdSetColorBlendEnableEXT = nullptr;
+#endif
+
+#if defined(VK_EXT_shader_object)
+PFN_vkCreateShadersEXT                  CreateShadersEXT                  = nullptr;
+PFN_vkDestroyShaderEXT                  DestroyShaderEXT                  = nullptr;
+PFN_vkCmdBindShadersEXT                 CmdBindShadersEXT                 = nullptr;
+PFN_vkCmdSetViewportWithCountEXT        CmdSetViewportWithCountEXT        = nullptr;
+PFN_vkCmdSetScissorWithCountEXT         CmdSetScissorWithCountEXT         = nullptr;
+PFN_vkCmdSetVertexInputEXT              CmdSetVertexInputEXT              = nullptr;
+PFN_vkCmdSetRasterizerDiscardEnableEXT  CmdSetRasterizerDiscardEnableEXT  = nullptr;
+PFN_vkCmdSetFrontFaceEXT                CmdSetFrontFaceEXT                = nullptr;
+PFN_vkCmdSetDepthCompareOpEXT           CmdSetDepthCompareOpEXT           = nullptr;
+PFN_vkCmdSetDepthBoundsTestEnableEXT    CmdSetDepthBoundsTestEnableEXT    = nullptr;
+PFN_vkCmdSetDepthBiasEnableEXT          CmdSetDepthBiasEnableEXT          = nullptr;
+PFN_vkCmdSetStencilTestEnableEXT        CmdSetStencilTestEnableEXT        = nullptr;
+PFN_vkCmdSetStencilOpEXT                CmdSetStencilOpEXT                = nullptr;
+PFN_vkCmdSetPrimitiveRestartEnableEXT   CmdSetPrimitiveRestartEnableEXT   = nullptr;
+PFN_vkCmdSetPatchControlPointsEXT       CmdSetPatchControlPointsEXT       = nullptr;
+PFN_vkCmdSetTessellationDomainOriginEXT CmdSetTessellationDomainOriginEXT = nullptr;
+PFN_vkCmdSetPolygonModeEXT              CmdSetPolygonModeEXT              = nullptr;
+PFN_vkCmdSetRasterizationSamplesEXT     CmdSetRasterizationSamplesEXT     = nullptr;
+PFN_vkCmdSetSampleMaskEXT               CmdSetSampleMaskEXT               = nullptr;
+PFN_vkCmdSetAlphaToCoverageEnableEXT    CmdSetAlphaToCoverageEnableEXT    = nullptr;
+PFN_vkCmdSetAlphaToOneEnableEXT         CmdSetAlphaToOneEnableEXT         = nullptr;
+PFN_vkCmdSetLogicOpEnableEXT            CmdSetLogicOpEnableEXT            = nullptr;
+PFN_vkCmdSetLogicOpEXT                  CmdSetLogicOpEXT                  = nullptr;
+PFN_vkCmdSetColorBlendEquationEXT       CmdSetColorBlendEquationEXT       = nullptr;
+PFN_vkCmdSetColorWriteMaskEXT           CmdSetColorWriteMaskEXT           = nullptr;
+PFN_vkCmdSetDepthClampEnableEXT         CmdSetDepthClampEnableEXT         = nullptr;
+PFN_vkCmdSetDepthClipEnableEXT          CmdSetDepthClipEnableEXT          = nullptr;
+#endif
+
+#if defined(VK_EXT_descriptor_buffer)
+PFN_vkGetDescriptorSetLayoutSizeEXT          GetDescriptorSetLayoutSizeEXT          = nullptr;
+PFN_vkGetDescriptorSetLayoutBindingOffsetEXT GetDescriptorSetLayoutBindingOffsetEXT = nullptr;
+PFN_vkGetDescriptorEXT                       GetDescriptorEXT                       = nullptr;
+PFN_vkCmdBindDescriptorBuffersEXT            CmdBindDescriptorBuffersEXT            = nullptr;
+PFN_vkCmdSetDescriptorBufferOffsetsEXT       CmdSetDescriptorBufferOffsetsEXT       = nullptr;
+#endif
+
+#if defined(VK_EXT_host_image_copy)
+PFN_vkCopyMemoryToImageEXT CopyMemoryToImageEXT = nullptr;
+#endif
+
+#if defined(VK_KHR_acceleration_structure)
+PFN_vkCreateAccelerationStructureKHR              CreateAccelerationStructureKHR              = nullptr;
+PFN_vkDestroyAccelerationStructureKHR             DestroyAccelerationStructureKHR             = nullptr;
+PFN_vkGetAccelerationStructureBuildSizesKHR       GetAccelerationStructureBuildSizesKHR       = nullptr;
+PFN_vkGetAccelerationStructureDeviceAddressKHR    GetAccelerationStructureDeviceAddressKHR    = nullptr;
+PFN_vkCmdBuildAccelerationStructuresKHR           CmdBuildAccelerationStructuresKHR           = nullptr;
+PFN_vkCmdCopyAccelerationStructureKHR             CmdCopyAccelerationStructureKHR             = nullptr;
+PFN_vkCmdWriteAccelerationStructuresPropertiesKHR CmdWriteAccelerationStructuresPropertiesKHR = nullptr;
+PFN_vkGetBufferDeviceAddressKHR                   GetBufferDeviceAddressKHR                   = nullptr;
+#endif
+
 Result Device::ConfigureQueueInfo(const grfx::DeviceCreateInfo* pCreateInfo, std::vector<float>& queuePriorities, std::vector<VkDeviceQueueCreateInfo>& queueCreateInfos)
 {
     VkPhysicalDevicePtr gpu = ToApi(pCreateInfo->pGpu)->GetVkGpu();
@@ -196,11 +294,57 @@ Result Device::ConfigureExtensions(const grfx::DeviceCreateInfo* pCreateInfo)
         mExtensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
     }
 
-#if defined(PPX_VK_EXTENDED_DYNAMIC_STATE)
+    // Extended dynamic state - if present
+#if defined(VK_EXT_extended_dynamic_state)
     if (ElementExists(std::string(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME), mFoundExtensions)) {
         mExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
     }
-#endif // defined(PPX_VK_EXTENDED_DYNAMIC_STATE)
+#endif
+#if defined(VK_EXT_extended_dynamic_state3)
+    if (ElementExists(std::string(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME);
+    }
+#endif
+
+    // Graphics pipeline libraries - if present and not opted out of. It
+    // also requires VK_KHR_pipeline_library.
+#if defined(VK_EXT_graphics_pipeline_library)
+    if (pCreateInfo->graphicsPipelineLibraries &&
+        ElementExists(std::string(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+        mExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+    }
+#endif
+
+    // Shader objects - if present. Shading rate images would need their
+    // state set on every bind as well, so devices created with a shading
+    // rate mode keep using pipelines.
+#if defined(VK_EXT_shader_object)
+    if ((pCreateInfo->supportShadingRateMode == SHADING_RATE_NONE) &&
+        ElementExists(std::string(VK_EXT_SHADER_OBJECT_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_SHADER_OBJECT_EXTENSION_NAME);
+    }
+#endif
+
+    // Host image copy - if present. It also requires VK_KHR_copy_commands2
+    // and VK_KHR_format_feature_flags2.
+#if defined(VK_EXT_host_image_copy)
+    if (ElementExists(std::string(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+        mExtensions.push_back(VK_KHR_COPY_COMMANDS_2_EXTENSION_NAME);
+        mExtensions.push_back(VK_KHR_FORMAT_FEATURE_FLAGS_2_EXTENSION_NAME);
+    }
+#endif
+
+    // Image compression control - if present
+#if defined(VK_EXT_image_compression_control)
+    if (ElementExists(std::string(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME);
+    }
+#endif
 
     // Depth clip
     if (ElementExists(std::string(VK_EXT_DEPTH_CLIP_ENABLE_EXTENSION_NAME), mFoundExtensions)) {
@@ -244,6 +388,113 @@ Result Device::ConfigureExtensions(const grfx::DeviceCreateInfo* pCreateInfo)
         mExtensions.push_back(VK_EXT_INDEX_TYPE_UINT8_EXTENSION_NAME);
     }
 
+    // 16 bit float and 8 bit integer arithmetic - if present (promoted to core in 1.2)
+#if defined(VK_KHR_shader_float16_int8)
+    if (ElementExists(std::string(VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME);
+    }
+#endif
+
+    // Cooperative matrix - if present
+#if defined(VK_KHR_cooperative_matrix)
+    if (ElementExists(std::string(VK_KHR_COOPERATIVE_MATRIX_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_COOPERATIVE_MATRIX_EXTENSION_NAME);
+    }
+#endif
+
+    // Synchronization2 - if present. Barriers and submits fall back to
+    // the legacy paths without it.
+#if defined(VK_KHR_synchronization2)
+    if (ElementExists(std::string(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    }
+#endif
+
+    // Draw indirect count - if present (promoted to core in 1.2)
+#if defined(VK_KHR_draw_indirect_count)
+    if (ElementExists(std::string(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+#endif
+
+    // Conditional rendering - if present
+#if defined(VK_EXT_conditional_rendering)
+    if (ElementExists(std::string(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME);
+    }
+#endif
+
+    // Mesh shader - if present. It also requires VK_KHR_spirv_1_4 and
+    // VK_KHR_shader_float_controls.
+#if defined(VK_EXT_mesh_shader)
+    if (ElementExists(std::string(VK_EXT_MESH_SHADER_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_SPIRV_1_4_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+        mExtensions.push_back(VK_KHR_SPIRV_1_4_EXTENSION_NAME);
+        mExtensions.push_back(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME);
+    }
+#endif
+
+    // Buffer device address - if present (promoted to core in 1.2)
+#if defined(VK_KHR_buffer_device_address)
+    if (ElementExists(std::string(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+    }
+#endif
+
+    // Descriptor buffers - if present and requested. They also require
+    // buffer device address, synchronization2 and descriptor indexing.
+#if defined(VK_EXT_descriptor_buffer)
+    if (pCreateInfo->descriptorBuffers &&
+        ElementExists(std::string(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME), mExtensions) &&
+        ElementExists(std::string(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME), mExtensions) &&
+        ((GetInstance()->GetApi() >= grfx::API_VK_1_2) || ElementExists(std::string(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME), mExtensions))) {
+        mExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+    }
+#endif
+
+    // Acceleration structures - if present. They also require
+    // VK_KHR_deferred_host_operations and VK_KHR_buffer_device_address.
+    // Ray query additionally requires VK_KHR_spirv_1_4 and
+    // VK_KHR_shader_float_controls.
+#if defined(VK_KHR_acceleration_structure)
+    if (ElementExists(std::string(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+        mExtensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+
+#if defined(VK_KHR_ray_query)
+        if (ElementExists(std::string(VK_KHR_RAY_QUERY_EXTENSION_NAME), mFoundExtensions) &&
+            ElementExists(std::string(VK_KHR_SPIRV_1_4_EXTENSION_NAME), mFoundExtensions) &&
+            ElementExists(std::string(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME), mFoundExtensions)) {
+            mExtensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+            mExtensions.push_back(VK_KHR_SPIRV_1_4_EXTENSION_NAME);
+            mExtensions.push_back(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME);
+        }
+#endif
+    }
+#endif
+
+    // Memory budget - if present. VMA estimates usage and budget without it.
+#if defined(VK_EXT_memory_budget)
+    if (ElementExists(std::string(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+#endif
+
+    // Present id and present wait - if present. Swapchains with a max frame
+    // latency pace presents with them.
+#if defined(VK_KHR_present_id) && defined(VK_KHR_present_wait)
+    if (ElementExists(std::string(VK_KHR_PRESENT_ID_EXTENSION_NAME), mFoundExtensions) &&
+        ElementExists(std::string(VK_KHR_PRESENT_WAIT_EXTENSION_NAME), mFoundExtensions)) {
+        mExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        mExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+#endif
+
     // Add additional extensions and uniquify
     AppendElements(pCreateInfo->vulkanExtensions, mExtensions);
     Unique(mExtensions);
@@ -278,6 +529,12 @@ Result Device::ConfigureFeatures(const grfx::DeviceCreateInfo* pCreateInfo, VkPh
     features.shaderStorageImageWriteWithoutFormat = foundFeatures.shaderStorageImageWriteWithoutFormat;
     features.shaderStorageImageMultisample        = foundFeatures.shaderStorageImageMultisample;
     features.samplerAnisotropy                    = foundFeatures.samplerAnisotropy;
+    features.multiDrawIndirect                    = foundFeatures.multiDrawIndirect;
+    features.drawIndirectFirstInstance            = foundFeatures.drawIndirectFirstInstance;
+    features.sparseBinding                        = foundFeatures.sparseBinding;
+    features.sparseResidencyImage2D               = foundFeatures.sparseResidencyImage2D;
+    features.shaderResourceResidency              = foundFeatures.shaderResourceResidency;
+    features.shaderInt16                          = foundFeatures.shaderInt16;
 
     if (ElementExists(std::string(VK_KHR_MULTIVIEW_EXTENSION_NAME), mExtensions)) {
         mHasMultiView = pCreateInfo->multiView;
@@ -562,6 +819,385 @@ Result Device::CreateQueues(const grfx::DeviceCreateInfo* pCreateInfo)
     return ppx::SUCCESS;
 }
 
+Result Device::CreatePipelineCache(const grfx::DeviceCreateInfo* pCreateInfo)
+{
+    // Previously saved cache data is only usable if it was written by the
+    // same driver on the same GPU. The driver is supposed to reject mismatched
+    // data on its own, but not all of them do, so check the header here.
+    std::vector<char> initialData;
+    if (!pCreateInfo->pipelineCachePath.empty() && fs::path_exists(pCreateInfo->pipelineCachePath)) {
+        auto data = fs::load_file(pCreateInfo->pipelineCachePath);
+        if (data.has_value() && (data->size() >= sizeof(VkPipelineCacheHeaderVersionOne))) {
+            const VkPhysicalDeviceProperties& gpuProperties = ToApi(pCreateInfo->pGpu)->GetProperties();
+
+            VkPipelineCacheHeaderVersionOne header = {};
+            std::memcpy(&header, data->data(), sizeof(header));
+
+            bool valid = (header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne)) &&
+                         (header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE) &&
+                         (header.vendorID == gpuProperties.vendorID) &&
+                         (header.deviceID == gpuProperties.deviceID) &&
+                         (std::memcmp(header.pipelineCacheUUID, gpuProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0);
+            if (valid) {
+                initialData = std::move(data.value());
+            }
+            else {
+                PPX_LOG_WARN("Ignoring pipeline cache created by a different GPU or driver: " << pCreateInfo->pipelineCachePath);
+            }
+        }
+    }
+
+    VkPipelineCacheCreateInfo vkci = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    vkci.flags                     = 0;
+    vkci.initialDataSize           = initialData.size();
+    vkci.pInitialData              = DataPtr(initialData);
+
+    VkResult vkres = vkCreatePipelineCache(mDevice, &vkci, nullptr, &mPipelineCache);
+    if ((vkres != VK_SUCCESS) && !initialData.empty()) {
+        // Retry with an empty cache if the driver rejected the data
+        PPX_LOG_WARN("vkCreatePipelineCache rejected cache data, starting with an empty cache: " << ToString(vkres));
+        vkci.initialDataSize = 0;
+        vkci.pInitialData    = nullptr;
+        initialData.clear();
+
+        vkres = vkCreatePipelineCache(mDevice, &vkci, nullptr, &mPipelineCache);
+    }
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreatePipelineCache failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    PPX_LOG_INFO("Vulkan pipeline cache loaded " << initialData.size() << " bytes");
+
+    return ppx::SUCCESS;
+}
+
+Result Device::SavePipelineCache()
+{
+    if (!mPipelineCache || mCreateInfo.pipelineCachePath.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    size_t   size  = 0;
+    VkResult vkres = vkGetPipelineCacheData(mDevice, mPipelineCache, &size, nullptr);
+    if (vkres != VK_SUCCESS) {
+        PPX_LOG_ERROR("vkGetPipelineCacheData(0) failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    std::vector<char> data(size);
+    vkres = vkGetPipelineCacheData(mDevice, mPipelineCache, &size, DataPtr(data));
+    if (vkres != VK_SUCCESS) {
+        PPX_LOG_ERROR("vkGetPipelineCacheData(1) failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    std::ofstream os(mCreateInfo.pipelineCachePath, std::ios::binary | std::ios::trunc);
+    if (!os.is_open()) {
+        PPX_LOG_ERROR("Unable to open pipeline cache file for writing: " << mCreateInfo.pipelineCachePath);
+        return ppx::ERROR_FAILED;
+    }
+    os.write(data.data(), static_cast<std::streamsize>(size));
+    os.close();
+
+    PPX_LOG_INFO("Vulkan pipeline cache saved " << size << " bytes to " << mCreateInfo.pipelineCachePath);
+
+    return ppx::SUCCESS;
+}
+
+Result Device::AcquireRenderPass(const std::vector<uint64_t>& key, const VkRenderPassCreateInfo* pCreateInfo, VkRenderPass* pRenderPass)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(pRenderPass);
+
+    std::lock_guard<std::mutex> lock(mRenderPassCacheMutex);
+
+    const uint64_t hash = XXH3_64bits(DataPtr(key), key.size() * sizeof(uint64_t));
+
+    auto it = mRenderPassCache.find(hash);
+    if (mCreateInfo.renderPassCache && (it != mRenderPassCache.end()) && (it->second.key == key)) {
+        it->second.refCount += 1;
+        *pRenderPass = it->second.handle;
+        return ppx::SUCCESS;
+    }
+
+    VkResult vkres = vk::CreateRenderPass(mDevice, pCreateInfo, nullptr, pRenderPass);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateRenderPass failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    if (mCreateInfo.renderPassCache && (it == mRenderPassCache.end())) {
+        CachedHandle<VkRenderPass> cached = {};
+        cached.handle                     = *pRenderPass;
+        cached.key                        = key;
+        cached.refCount                   = 1;
+        mRenderPassCache[hash]            = std::move(cached);
+    }
+
+    return ppx::SUCCESS;
+}
+
+void Device::ReleaseRenderPass(VkRenderPass renderPass)
+{
+    std::lock_guard<std::mutex> lock(mRenderPassCacheMutex);
+
+    auto it = std::find_if(mRenderPassCache.begin(), mRenderPassCache.end(), [renderPass](const auto& elem) { return elem.second.handle == renderPass; });
+    if (it != mRenderPassCache.end()) {
+        it->second.refCount -= 1;
+        if (it->second.refCount > 0) {
+            return;
+        }
+        mRenderPassCache.erase(it);
+    }
+
+    vkDestroyRenderPass(mDevice, renderPass, nullptr);
+}
+
+Result Device::AcquireFramebuffer(const std::vector<uint64_t>& key, const VkFramebufferCreateInfo* pCreateInfo, VkFramebuffer* pFramebuffer)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(pFramebuffer);
+
+    std::lock_guard<std::mutex> lock(mRenderPassCacheMutex);
+
+    const uint64_t hash = XXH3_64bits(DataPtr(key), key.size() * sizeof(uint64_t));
+
+    auto it = mFramebufferCache.find(hash);
+    if (mCreateInfo.renderPassCache && (it != mFramebufferCache.end()) && (it->second.key == key)) {
+        it->second.refCount += 1;
+        *pFramebuffer = it->second.handle;
+        return ppx::SUCCESS;
+    }
+
+    VkResult vkres = vkCreateFramebuffer(mDevice, pCreateInfo, nullptr, pFramebuffer);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateFramebuffer failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    if (mCreateInfo.renderPassCache && (it == mFramebufferCache.end())) {
+        CachedHandle<VkFramebuffer> cached = {};
+        cached.handle                      = *pFramebuffer;
+        cached.key                         = key;
+        cached.refCount                    = 1;
+        mFramebufferCache[hash]            = std::move(cached);
+    }
+
+    return ppx::SUCCESS;
+}
+
+void Device::ReleaseFramebuffer(VkFramebuffer framebuffer)
+{
+    std::lock_guard<std::mutex> lock(mRenderPassCacheMutex);
+
+    auto it = std::find_if(mFramebufferCache.begin(), mFramebufferCache.end(), [framebuffer](const auto& elem) { return elem.second.handle == framebuffer; });
+    if (it != mFramebufferCache.end()) {
+        it->second.refCount -= 1;
+        if (it->second.refCount > 0) {
+            return;
+        }
+        mFramebufferCache.erase(it);
+    }
+
+    vkDestroyFramebuffer(mDevice, framebuffer, nullptr);
+}
+
+Result Device::AcquirePipelineLibrary(const std::vector<uint64_t>& key, const VkGraphicsPipelineCreateInfo* pCreateInfo, VkPipeline* pLibrary)
+{
+    PPX_ASSERT_NULL_ARG(pCreateInfo);
+    PPX_ASSERT_NULL_ARG(pLibrary);
+
+    const uint64_t hash = XXH3_64bits(DataPtr(key), key.size() * sizeof(uint64_t));
+    {
+        std::lock_guard<std::mutex> lock(mPipelineLibraryCacheMutex);
+
+        auto it = mPipelineLibraryCache.find(hash);
+        if ((it != mPipelineLibraryCache.end()) && (it->second.key == key)) {
+            it->second.refCount += 1;
+            *pLibrary = it->second.handle;
+            return ppx::SUCCESS;
+        }
+    }
+
+    // Compiled without holding the lock so that compile threads building
+    // different libraries don't wait on each other
+    VkPipeline library = VK_NULL_HANDLE;
+    VkResult   vkres   = vkCreateGraphicsPipelines(mDevice, mPipelineCache, 1, pCreateInfo, nullptr, &library);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateGraphicsPipelines(library) failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    std::lock_guard<std::mutex> lock(mPipelineLibraryCacheMutex);
+
+    auto it = mPipelineLibraryCache.find(hash);
+    if (it == mPipelineLibraryCache.end()) {
+        CachedHandle<VkPipeline> cached = {};
+        cached.handle                   = library;
+        cached.key                      = key;
+        cached.refCount                 = 1;
+        mPipelineLibraryCache[hash]     = std::move(cached);
+    }
+    else if (it->second.key == key) {
+        // Another thread created the same library in the meantime
+        vkDestroyPipeline(mDevice, library, nullptr);
+        it->second.refCount += 1;
+        library = it->second.handle;
+    }
+
+    *pLibrary = library;
+    return ppx::SUCCESS;
+}
+
+void Device::ReleasePipelineLibrary(VkPipeline library)
+{
+    std::lock_guard<std::mutex> lock(mPipelineLibraryCacheMutex);
+
+    auto it = std::find_if(mPipelineLibraryCache.begin(), mPipelineLibraryCache.end(), [library](const auto& elem) { return elem.second.handle == library; });
+    if (it != mPipelineLibraryCache.end()) {
+        it->second.refCount -= 1;
+        if (it->second.refCount > 0) {
+            return;
+        }
+        mPipelineLibraryCache.erase(it);
+    }
+
+    vkDestroyPipeline(mDevice, library, nullptr);
+}
+
+Result Device::CreateDescriptorBuffer(const grfx::DeviceCreateInfo* pCreateInfo)
+{
+#if defined(VK_EXT_descriptor_buffer)
+    VkPhysicalDeviceProperties2 properties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+    properties.pNext                       = &mDescriptorBufferProperties;
+    vkGetPhysicalDeviceProperties2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &properties);
+    mDescriptorBufferProperties.pNext = nullptr;
+
+    // Sets with samplers are bound from buffers with sampler usage and all
+    // other sets from buffers with resource usage. A single buffer with
+    // both covers every layout, so it's limited by the smaller range.
+    VkDeviceSize size = PPX_DESCRIPTOR_BUFFER_SIZE;
+    size              = std::min<VkDeviceSize>(size, mDescriptorBufferProperties.maxSamplerDescriptorBufferRange);
+    size              = std::min<VkDeviceSize>(size, mDescriptorBufferProperties.maxResourceDescriptorBufferRange);
+    size              = std::min<VkDeviceSize>(size, mDescriptorBufferProperties.samplerDescriptorBufferAddressSpaceSize);
+    size              = std::min<VkDeviceSize>(size, mDescriptorBufferProperties.resourceDescriptorBufferAddressSpaceSize);
+
+    // Devices that write push descriptors into a bound buffer of their own
+    // would need a second buffer, pushable layouts aren't supported there
+    if (!mDescriptorBufferProperties.bufferlessPushDescriptors) {
+        mHasDescriptorBufferPushDescriptors = false;
+    }
+
+    mDescriptorBufferUsage = VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+                             VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+                             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+
+    VkBufferCreateInfo bufferCreateInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCreateInfo.size               = size;
+    bufferCreateInfo.usage              = mDescriptorBufferUsage;
+    bufferCreateInfo.sharingMode        = VK_SHARING_MODE_EXCLUSIVE;
+
+    // Descriptors are written by the CPU without flushes and read by the GPU
+    VmaAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.flags                   = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocCreateInfo.usage                   = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocCreateInfo.requiredFlags           = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    VkBuffer          buffer     = VK_NULL_HANDLE;
+    VmaAllocation     allocation = VK_NULL_HANDLE;
+    VmaAllocationInfo allocInfo  = {};
+    VkResult          vkres      = vmaCreateBufferWithAlignment(
+        mVmaAllocator,
+        &bufferCreateInfo,
+        &allocCreateInfo,
+        mDescriptorBufferProperties.descriptorBufferOffsetAlignment,
+        &buffer,
+        &allocation,
+        &allocInfo);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vmaCreateBufferWithAlignment(descriptor buffer) failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+    mDescriptorBuffer              = buffer;
+    mDescriptorBufferAllocation    = allocation;
+    mDescriptorBufferMappedAddress = static_cast<char*>(allocInfo.pMappedData);
+
+    VkBufferDeviceAddressInfoKHR addressInfo = {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR};
+    addressInfo.buffer                       = mDescriptorBuffer;
+    mDescriptorBufferAddress                 = GetBufferDeviceAddressKHR(mDevice, &addressInfo);
+
+    VmaVirtualBlockCreateInfo blockCreateInfo = {};
+    blockCreateInfo.size                      = size;
+
+    vkres = vmaCreateVirtualBlock(&blockCreateInfo, &mDescriptorBufferBlock);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vmaCreateVirtualBlock failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    PPX_LOG_INFO("Vulkan descriptor buffer size: " << size << " bytes");
+#endif
+    return ppx::SUCCESS;
+}
+
+#if defined(VK_EXT_descriptor_buffer)
+Result Device::AllocateDescriptorBufferRange(VkDeviceSize size, VkDeviceSize* pOffset)
+{
+    std::lock_guard<std::mutex> lock(mDescriptorBufferMutex);
+
+    VmaVirtualAllocationCreateInfo allocCreateInfo = {};
+    allocCreateInfo.size                           = std::max<VkDeviceSize>(size, 1);
+    allocCreateInfo.alignment                      = mDescriptorBufferProperties.descriptorBufferOffsetAlignment;
+
+    VmaVirtualAllocation allocation = VK_NULL_HANDLE;
+    VkResult             vkres      = vmaVirtualAllocate(mDescriptorBufferBlock, &allocCreateInfo, &allocation, pOffset);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "descriptor buffer is full, " << size << " bytes requested");
+        return ppx::ERROR_OUT_OF_MEMORY;
+    }
+    mDescriptorBufferRanges[*pOffset] = allocation;
+
+    return ppx::SUCCESS;
+}
+
+void Device::FreeDescriptorBufferRange(VkDeviceSize offset)
+{
+    std::lock_guard<std::mutex> lock(mDescriptorBufferMutex);
+
+    auto it = mDescriptorBufferRanges.find(offset);
+    if (it == mDescriptorBufferRanges.end()) {
+        PPX_ASSERT_MSG(false, "descriptor buffer range at offset " << offset << " was not allocated");
+        return;
+    }
+    vmaVirtualFree(mDescriptorBufferBlock, it->second);
+    mDescriptorBufferRanges.erase(it);
+}
+
+size_t Device::GetDescriptorSize(VkDescriptorType type) const
+{
+    const VkPhysicalDeviceDescriptorBufferPropertiesEXT& props = mDescriptorBufferProperties;
+    // clang-format off
+    switch (type) {
+        default: break;
+        case VK_DESCRIPTOR_TYPE_SAMPLER                : return props.samplerDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : return props.combinedImageSamplerDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE          : return props.sampledImageDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE          : return props.storageImageDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER   : return props.uniformTexelBufferDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER   : return props.storageTexelBufferDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER         : return props.uniformBufferDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER         : return props.storageBufferDescriptorSize;
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT       : return props.inputAttachmentDescriptorSize;
+#if defined(VK_KHR_acceleration_structure)
+        case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR : return props.accelerationStructureDescriptorSize;
+#endif
+    }
+    // clang-format on
+    return 0;
+}
+#endif
+
 Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
 {
     std::vector<float>                   queuePriorities;
@@ -579,6 +1215,22 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
     if (Failed(ppxres)) {
         return ppxres;
     }
+
+    // Sparse binds are only submitted to the graphics queue
+    {
+        VkPhysicalDevice gpu   = ToApi(pCreateInfo->pGpu)->GetVkGpu();
+        uint32_t         count = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &count, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(count);
+        vkGetPhysicalDeviceQueueFamilyProperties(gpu, &count, DataPtr(queueFamilies));
+
+        bool sparseQueue    = (mGraphicsQueueFamilyIndex < count) && ((queueFamilies[mGraphicsQueueFamilyIndex].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) != 0);
+        mHasSparseResidency = sparseQueue &&
+                              (mDeviceFeatures.sparseBinding == VK_TRUE) &&
+                              (mDeviceFeatures.sparseResidencyImage2D == VK_TRUE) &&
+                              (mDeviceFeatures.shaderResourceResidency == VK_TRUE);
+        PPX_LOG_INFO("Vulkan sparse residency is present: " << mHasSparseResidency);
+    }
     ConfigureShadingRateCapabilities(pCreateInfo, &mShadingRateCapabilities);
 
     // We can't include structs whose extesnions aren't enabled, so do the tracking.
@@ -662,41 +1314,282 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         }
     }
 
-    // Chain pNexts
-    for (size_t i = 1; i < extensionStructs.size(); ++i) {
-        extensionStructs[i - 1]->pNext = extensionStructs[i];
+#if defined(VK_EXT_conditional_rendering)
+    // VK_EXT_conditional_rendering
+    VkPhysicalDeviceConditionalRenderingFeaturesEXT conditionalRenderingFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_CONDITIONAL_RENDERING_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_CONDITIONAL_RENDERING_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &conditionalRenderingFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (conditionalRenderingFeatures.conditionalRendering == VK_TRUE) {
+            mHasConditionalRendering = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&conditionalRenderingFeatures));
+        }
     }
+#endif
 
-    // Get C strings
-    std::vector<const char*> extensions = GetCStrings(mExtensions);
+#if defined(VK_KHR_synchronization2)
+    // VK_KHR_synchronization2
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &synchronization2Features};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (synchronization2Features.synchronization2 == VK_TRUE) {
+            mHasSynchronization2 = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&synchronization2Features));
+        }
+    }
+#endif
 
-    VkDeviceCreateInfo vkci      = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
-    vkci.pNext                   = extensionStructs.empty() ? nullptr : extensionStructs[0];
-    vkci.flags                   = 0;
-    vkci.queueCreateInfoCount    = CountU32(queueCreateInfos);
-    vkci.pQueueCreateInfos       = DataPtr(queueCreateInfos);
-    vkci.enabledLayerCount       = 0;
-    vkci.ppEnabledLayerNames     = nullptr;
-    vkci.enabledExtensionCount   = CountU32(extensions);
-    vkci.ppEnabledExtensionNames = DataPtr(extensions);
-    vkci.pEnabledFeatures        = &mDeviceFeatures;
+#if defined(VK_KHR_present_id) && defined(VK_KHR_present_wait)
+    // VK_KHR_present_id and VK_KHR_present_wait
+    VkPhysicalDevicePresentIdFeaturesKHR   presentIdFeatures   = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR};
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_PRESENT_WAIT_EXTENSION_NAME), mExtensions)) {
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &presentIdFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        presentIdFeatures.pNext = nullptr;
+        if ((presentIdFeatures.presentId == VK_TRUE) && (presentWaitFeatures.presentWait == VK_TRUE)) {
+            mHasPresentWait = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&presentIdFeatures));
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&presentWaitFeatures));
+        }
+    }
+#endif
 
-    // Log layers and extensions
-    {
-        PPX_LOG_INFO("Loading " << vkci.enabledExtensionCount << " Vulkan device extensions");
-        for (uint32_t i = 0; i < vkci.enabledExtensionCount; ++i) {
-            PPX_LOG_INFO("   " << i << " : " << vkci.ppEnabledExtensionNames[i]);
+#if defined(VK_EXT_mesh_shader)
+    // VK_EXT_mesh_shader - the task shader is optional, pipelines with an
+    // amplification shader fail validation without it.
+    VkPhysicalDeviceMeshShaderFeaturesEXT meshShaderFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_MESH_SHADER_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &meshShaderFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (meshShaderFeatures.meshShader == VK_TRUE) {
+            mHasMeshShader = true;
+            mHasTaskShader = (meshShaderFeatures.taskShader == VK_TRUE);
+            // Only the shader stages are used, leave the query and
+            // multiview features disabled.
+            meshShaderFeatures.multiviewMeshShader                    = VK_FALSE;
+            meshShaderFeatures.primitiveFragmentShadingRateMeshShader = VK_FALSE;
+            meshShaderFeatures.meshShaderQueries                      = VK_FALSE;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&meshShaderFeatures));
         }
     }
+#endif
 
-    VkResult vkres;
-#if defined(PPX_BUILD_XR)
-    if (pCreateInfo->pXrComponent != nullptr) {
-#if !defined(PPX_ANDROID)
-        // TODO: is this still needed for Air Link?
-        // This fixes a validation error with Oculus Quest 2 Runtime
-        mDeviceFeatures.samplerAnisotropy             = VK_TRUE;
-        mDeviceFeatures.shaderStorageImageMultisample = VK_TRUE;
+#if defined(VK_EXT_extended_dynamic_state)
+    // VK_EXT_extended_dynamic_state
+    VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extendedDynamicStateFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &extendedDynamicStateFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (extendedDynamicStateFeatures.extendedDynamicState == VK_TRUE) {
+            mHasExtendedDynamicState = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&extendedDynamicStateFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    // VK_EXT_extended_dynamic_state3 - only blend enable is used, leave the
+    // other states disabled.
+    VkPhysicalDeviceExtendedDynamicState3FeaturesEXT extendedDynamicState3Features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_EXTENDED_DYNAMIC_STATE_3_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceExtendedDynamicState3FeaturesEXT foundState3Features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_3_FEATURES_EXT};
+        VkPhysicalDeviceFeatures2                        foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &foundState3Features};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (foundState3Features.extendedDynamicState3ColorBlendEnable == VK_TRUE) {
+            mHasDynamicBlendEnable                                              = true;
+            extendedDynamicState3Features.extendedDynamicState3ColorBlendEnable = VK_TRUE;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&extendedDynamicState3Features));
+        }
+    }
+#endif
+
+#if defined(VK_EXT_graphics_pipeline_library)
+    // VK_EXT_graphics_pipeline_library - only used if linking libraries
+    // without link time optimization is fast, otherwise they don't save
+    // anything over creating whole pipelines.
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT graphicsPipelineLibraryFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT graphicsPipelineLibraryProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT};
+        VkPhysicalDeviceProperties2                          foundProperties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &graphicsPipelineLibraryProperties};
+        vkGetPhysicalDeviceProperties2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundProperties);
+
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &graphicsPipelineLibraryFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        graphicsPipelineLibraryFeatures.pNext = nullptr;
+        if ((graphicsPipelineLibraryFeatures.graphicsPipelineLibrary == VK_TRUE) &&
+            (graphicsPipelineLibraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE)) {
+            mHasGraphicsPipelineLibrary = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&graphicsPipelineLibraryFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_EXT_shader_object)
+    // VK_EXT_shader_object
+    VkPhysicalDeviceShaderObjectFeaturesEXT shaderObjectFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_OBJECT_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_SHADER_OBJECT_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &shaderObjectFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        shaderObjectFeatures.pNext = nullptr;
+        if (shaderObjectFeatures.shaderObject == VK_TRUE) {
+            mHasShaderObject = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&shaderObjectFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_EXT_host_image_copy)
+    // VK_EXT_host_image_copy
+    VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &hostImageCopyFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (hostImageCopyFeatures.hostImageCopy == VK_TRUE) {
+            mHasHostImageCopy = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&hostImageCopyFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_EXT_image_compression_control)
+    // VK_EXT_image_compression_control
+    VkPhysicalDeviceImageCompressionControlFeaturesEXT imageCompressionControlFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_COMPRESSION_CONTROL_FEATURES_EXT};
+    if (ElementExists(std::string(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &imageCompressionControlFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (imageCompressionControlFeatures.imageCompressionControl == VK_TRUE) {
+            mHasImageCompressionControl = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&imageCompressionControlFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_KHR_buffer_device_address)
+    // VK_KHR_buffer_device_address - shaders load through addresses passed
+    // in push constants, acceleration structure builds take them for their
+    // inputs. Capture replay and multi device are not used.
+    VkPhysicalDeviceBufferDeviceAddressFeaturesKHR bufferDeviceAddressFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &bufferDeviceAddressFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        bufferDeviceAddressFeatures.pNext = nullptr;
+        if (bufferDeviceAddressFeatures.bufferDeviceAddress == VK_TRUE) {
+            mHasBufferDeviceAddress                                      = true;
+            bufferDeviceAddressFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+            bufferDeviceAddressFeatures.bufferDeviceAddressMultiDevice   = VK_FALSE;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&bufferDeviceAddressFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_EXT_descriptor_buffer)
+    // VK_EXT_descriptor_buffer - descriptors reference buffers by device
+    // address. Capture replay and ignored image layouts are not used,
+    // descriptorBufferPushDescriptors is kept for pushable set layouts.
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT};
+    if (mHasBufferDeviceAddress && mHasSynchronization2 && ElementExists(std::string(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &descriptorBufferFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        descriptorBufferFeatures.pNext = nullptr;
+        if (descriptorBufferFeatures.descriptorBuffer == VK_TRUE) {
+            mHasDescriptorBuffer                                        = true;
+            mHasDescriptorBufferPushDescriptors                         = (descriptorBufferFeatures.descriptorBufferPushDescriptors == VK_TRUE);
+            descriptorBufferFeatures.descriptorBufferCaptureReplay      = VK_FALSE;
+            descriptorBufferFeatures.descriptorBufferImageLayoutIgnored = VK_FALSE;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&descriptorBufferFeatures));
+        }
+    }
+#endif
+
+#if defined(VK_KHR_acceleration_structure)
+    // VK_KHR_acceleration_structure - builds need buffer device addresses
+    // for geometry, instance and scratch memory. Host builds and capture
+    // replay are not used.
+    VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR};
+    if (mHasBufferDeviceAddress && ElementExists(std::string(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &accelerationStructureFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        accelerationStructureFeatures.pNext = nullptr;
+        if (accelerationStructureFeatures.accelerationStructure == VK_TRUE) {
+            mHasAccelerationStructure                                        = true;
+            accelerationStructureFeatures.accelerationStructureCaptureReplay = VK_FALSE;
+            accelerationStructureFeatures.accelerationStructureHostCommands  = VK_FALSE;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&accelerationStructureFeatures));
+        }
+    }
+
+#if defined(VK_KHR_ray_query)
+    // VK_KHR_ray_query
+    VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR};
+    if (mHasAccelerationStructure && ElementExists(std::string(VK_KHR_RAY_QUERY_EXTENSION_NAME), mExtensions)) {
+        VkPhysicalDeviceFeatures2 foundFeatures{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &rayQueryFeatures};
+        vkGetPhysicalDeviceFeatures2(ToApi(pCreateInfo->pGpu)->GetVkGpu(), &foundFeatures);
+        if (rayQueryFeatures.rayQuery == VK_TRUE) {
+            mHasRayQuery = true;
+            extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&rayQueryFeatures));
+        }
+    }
+#endif
+#endif
+
+#if defined(VK_KHR_shader_float16_int8)
+    // VK_KHR_shader_float16_int8 - enabled as reported by Gpu::GetShaderCapabilities()
+    VkPhysicalDeviceShaderFloat16Int8FeaturesKHR float16Int8Features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME), mExtensions)) {
+        const grfx::ShaderCapabilities& capabilities = pCreateInfo->pGpu->GetShaderCapabilities();
+        float16Int8Features.shaderFloat16            = capabilities.float16 ? VK_TRUE : VK_FALSE;
+        float16Int8Features.shaderInt8               = capabilities.int8 ? VK_TRUE : VK_FALSE;
+        extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&float16Int8Features));
+    }
+#endif
+
+#if defined(VK_KHR_cooperative_matrix)
+    // VK_KHR_cooperative_matrix - robust buffer access is not used
+    VkPhysicalDeviceCooperativeMatrixFeaturesKHR cooperativeMatrixFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_COOPERATIVE_MATRIX_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_COOPERATIVE_MATRIX_EXTENSION_NAME), mExtensions) && pCreateInfo->pGpu->GetShaderCapabilities().cooperativeMatrix) {
+        cooperativeMatrixFeatures.cooperativeMatrix = VK_TRUE;
+        extensionStructs.push_back(reinterpret_cast<VkBaseOutStructure*>(&cooperativeMatrixFeatures));
+    }
+#endif
+
+    // Chain pNexts
+    for (size_t i = 1; i < extensionStructs.size(); ++i) {
+        extensionStructs[i - 1]->pNext = extensionStructs[i];
+    }
+
+    // Get C strings
+    std::vector<const char*> extensions = GetCStrings(mExtensions);
+
+    VkDeviceCreateInfo vkci      = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    vkci.pNext                   = extensionStructs.empty() ? nullptr : extensionStructs[0];
+    vkci.flags                   = 0;
+    vkci.queueCreateInfoCount    = CountU32(queueCreateInfos);
+    vkci.pQueueCreateInfos       = DataPtr(queueCreateInfos);
+    vkci.enabledLayerCount       = 0;
+    vkci.ppEnabledLayerNames     = nullptr;
+    vkci.enabledExtensionCount   = CountU32(extensions);
+    vkci.ppEnabledExtensionNames = DataPtr(extensions);
+    vkci.pEnabledFeatures        = &mDeviceFeatures;
+
+    // Log layers and extensions
+    {
+        PPX_LOG_INFO("Loading " << vkci.enabledExtensionCount << " Vulkan device extensions");
+        for (uint32_t i = 0; i < vkci.enabledExtensionCount; ++i) {
+            PPX_LOG_INFO("   " << i << " : " << vkci.ppEnabledExtensionNames[i]);
+        }
+    }
+
+    VkResult vkres;
+#if defined(PPX_BUILD_XR)
+    if (pCreateInfo->pXrComponent != nullptr) {
+#if !defined(PPX_ANDROID)
+        // TODO: is this still needed for Air Link?
+        // This fixes a validation error with Oculus Quest 2 Runtime
+        mDeviceFeatures.samplerAnisotropy             = VK_TRUE;
+        mDeviceFeatures.shaderStorageImageMultisample = VK_TRUE;
 #endif // !defined(PPX_ANDROID)
 
         const XrComponent&          xrComponent = *pCreateInfo->pXrComponent;
@@ -769,10 +1662,6 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
 #endif
     PPX_LOG_INFO("Vulkan dynamic rendering is present: " << mHasDynamicRendering);
 
-#if defined(PPX_VK_EXTENDED_DYNAMIC_STATE)
-    mExtendedDynamicStateAvailable = ElementExists(std::string(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME), mFoundExtensions));
-#endif // defined(PPX_VK_EXTENDED_DYNAMIC_STATE)
-
     // Depth clip enabled
     mHasDepthClipEnabled = ElementExists(std::string(VK_EXT_DEPTH_CLIP_ENABLE_EXTENSION_NAME), mExtensions);
 
@@ -791,19 +1680,225 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         CmdPushDescriptorSetKHR = (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(mDevice, "vkCmdPushDescriptorSetKHR");
     }
 
+    // VK_EXT_debug_utils is an instance extension, enabled with debug
+    if (GetInstance()->IsDebugEnabled()) {
+        CmdBeginDebugUtilsLabelEXT = (PFN_vkCmdBeginDebugUtilsLabelEXT)vkGetInstanceProcAddr(ToApi(GetInstance())->GetVkInstance(), "vkCmdBeginDebugUtilsLabelEXT");
+        CmdEndDebugUtilsLabelEXT   = (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(ToApi(GetInstance())->GetVkInstance(), "vkCmdEndDebugUtilsLabelEXT");
+    }
+
 #if defined(VK_KHR_dynamic_rendering)
     if (mHasDynamicRendering) {
         CmdBeginRenderingKHR = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(mDevice, "vkCmdBeginRenderingKHR");
         CmdEndRenderingKHR   = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(mDevice, "vkCmdEndRenderingKHR");
     }
+    mUsesDynamicRenderPasses = mHasDynamicRendering && pCreateInfo->dynamicRenderPasses && (CmdBeginRenderingKHR != nullptr) && (CmdEndRenderingKHR != nullptr);
+#endif
+    PPX_LOG_INFO("Vulkan render passes use dynamic rendering: " << mUsesDynamicRenderPasses);
+
+    // Libraries are only created for pipelines that use dynamic rendering
+    mUsesGraphicsPipelineLibraries = mHasGraphicsPipelineLibrary && mUsesDynamicRenderPasses;
+    PPX_LOG_INFO("Vulkan graphics pipelines are linked from libraries: " << mUsesGraphicsPipelineLibraries);
+
+#if defined(VK_KHR_synchronization2)
+    if (mHasSynchronization2) {
+        CmdPipelineBarrier2KHR = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(mDevice, "vkCmdPipelineBarrier2KHR");
+        QueueSubmit2KHR        = (PFN_vkQueueSubmit2KHR)vkGetDeviceProcAddr(mDevice, "vkQueueSubmit2KHR");
+        mHasSynchronization2   = (CmdPipelineBarrier2KHR != nullptr) && (QueueSubmit2KHR != nullptr);
+    }
 #endif
+    PPX_LOG_INFO("Vulkan synchronization2 is present: " << mHasSynchronization2);
+
+#if defined(VK_KHR_present_wait)
+    if (mHasPresentWait) {
+        WaitForPresentKHR = (PFN_vkWaitForPresentKHR)vkGetDeviceProcAddr(mDevice, "vkWaitForPresentKHR");
+        mHasPresentWait   = (WaitForPresentKHR != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan present wait is present: " << mHasPresentWait);
+
+#if defined(VK_KHR_draw_indirect_count)
+    if (ElementExists(std::string(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME), mExtensions)) {
+        CmdDrawIndirectCountKHR        = (PFN_vkCmdDrawIndirectCountKHR)vkGetDeviceProcAddr(mDevice, "vkCmdDrawIndirectCountKHR");
+        CmdDrawIndexedIndirectCountKHR = (PFN_vkCmdDrawIndexedIndirectCountKHR)vkGetDeviceProcAddr(mDevice, "vkCmdDrawIndexedIndirectCountKHR");
+        mHasDrawIndirectCount          = (CmdDrawIndirectCountKHR != nullptr) && (CmdDrawIndexedIndirectCountKHR != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan draw indirect count is present: " << mHasDrawIndirectCount);
+
+#if defined(VK_EXT_conditional_rendering)
+    if (mHasConditionalRendering) {
+        CmdBeginConditionalRenderingEXT = (PFN_vkCmdBeginConditionalRenderingEXT)vkGetDeviceProcAddr(mDevice, "vkCmdBeginConditionalRenderingEXT");
+        CmdEndConditionalRenderingEXT   = (PFN_vkCmdEndConditionalRenderingEXT)vkGetDeviceProcAddr(mDevice, "vkCmdEndConditionalRenderingEXT");
+        mHasConditionalRendering        = (CmdBeginConditionalRenderingEXT != nullptr) && (CmdEndConditionalRenderingEXT != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan conditional rendering is present: " << mHasConditionalRendering);
+
+#if defined(VK_EXT_mesh_shader)
+    if (mHasMeshShader) {
+        CmdDrawMeshTasksEXT         = (PFN_vkCmdDrawMeshTasksEXT)vkGetDeviceProcAddr(mDevice, "vkCmdDrawMeshTasksEXT");
+        CmdDrawMeshTasksIndirectEXT = (PFN_vkCmdDrawMeshTasksIndirectEXT)vkGetDeviceProcAddr(mDevice, "vkCmdDrawMeshTasksIndirectEXT");
+        mHasMeshShader              = (CmdDrawMeshTasksEXT != nullptr) && (CmdDrawMeshTasksIndirectEXT != nullptr);
+        mHasTaskShader              = mHasTaskShader && mHasMeshShader;
+
+        // The count variant also needs drawIndirectCount
+        if (mHasMeshShader && mHasDrawIndirectCount) {
+            CmdDrawMeshTasksIndirectCountEXT = (PFN_vkCmdDrawMeshTasksIndirectCountEXT)vkGetDeviceProcAddr(mDevice, "vkCmdDrawMeshTasksIndirectCountEXT");
+        }
+    }
+#endif
+    PPX_LOG_INFO("Vulkan mesh shader is present: " << mHasMeshShader);
+
+#if defined(VK_EXT_extended_dynamic_state)
+    if (mHasExtendedDynamicState) {
+        CmdSetCullModeEXT          = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetCullModeEXT");
+        CmdSetPrimitiveTopologyEXT = (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetPrimitiveTopologyEXT");
+        CmdSetDepthTestEnableEXT   = (PFN_vkCmdSetDepthTestEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthTestEnableEXT");
+        CmdSetDepthWriteEnableEXT  = (PFN_vkCmdSetDepthWriteEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthWriteEnableEXT");
+        mHasExtendedDynamicState   = (CmdSetCullModeEXT != nullptr) &&
+                                     (CmdSetPrimitiveTopologyEXT != nullptr) &&
+                                     (CmdSetDepthTestEnableEXT != nullptr) &&
+                                     (CmdSetDepthWriteEnableEXT != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan extended dynamic state is present: " << mHasExtendedDynamicState);
+
+#if defined(VK_EXT_extended_dynamic_state3)
+    if (mHasDynamicBlendEnable) {
+        CmdSetColorBlendEnableEXT = (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetColorBlendEnableEXT");
+        mHasDynamicBlendEnable    = (CmdSetColorBlendEnableEXT != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan dynamic blend enable is present: " << mHasDynamicBlendEnable);
+
+#if defined(VK_EXT_shader_object)
+    if (mHasShaderObject) {
+        CreateShadersEXT                  = (PFN_vkCreateShadersEXT)vkGetDeviceProcAddr(mDevice, "vkCreateShadersEXT");
+        DestroyShaderEXT                  = (PFN_vkDestroyShaderEXT)vkGetDeviceProcAddr(mDevice, "vkDestroyShaderEXT");
+        CmdBindShadersEXT                 = (PFN_vkCmdBindShadersEXT)vkGetDeviceProcAddr(mDevice, "vkCmdBindShadersEXT");
+        CmdSetViewportWithCountEXT        = (PFN_vkCmdSetViewportWithCountEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetViewportWithCountEXT");
+        CmdSetScissorWithCountEXT         = (PFN_vkCmdSetScissorWithCountEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetScissorWithCountEXT");
+        CmdSetVertexInputEXT              = (PFN_vkCmdSetVertexInputEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetVertexInputEXT");
+        CmdSetRasterizerDiscardEnableEXT  = (PFN_vkCmdSetRasterizerDiscardEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetRasterizerDiscardEnableEXT");
+        CmdSetFrontFaceEXT                = (PFN_vkCmdSetFrontFaceEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetFrontFaceEXT");
+        CmdSetDepthCompareOpEXT           = (PFN_vkCmdSetDepthCompareOpEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthCompareOpEXT");
+        CmdSetDepthBoundsTestEnableEXT    = (PFN_vkCmdSetDepthBoundsTestEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthBoundsTestEnableEXT");
+        CmdSetDepthBiasEnableEXT          = (PFN_vkCmdSetDepthBiasEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthBiasEnableEXT");
+        CmdSetStencilTestEnableEXT        = (PFN_vkCmdSetStencilTestEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetStencilTestEnableEXT");
+        CmdSetStencilOpEXT                = (PFN_vkCmdSetStencilOpEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetStencilOpEXT");
+        CmdSetPrimitiveRestartEnableEXT   = (PFN_vkCmdSetPrimitiveRestartEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetPrimitiveRestartEnableEXT");
+        CmdSetPatchControlPointsEXT       = (PFN_vkCmdSetPatchControlPointsEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetPatchControlPointsEXT");
+        CmdSetTessellationDomainOriginEXT = (PFN_vkCmdSetTessellationDomainOriginEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetTessellationDomainOriginEXT");
+        CmdSetPolygonModeEXT              = (PFN_vkCmdSetPolygonModeEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetPolygonModeEXT");
+        CmdSetRasterizationSamplesEXT     = (PFN_vkCmdSetRasterizationSamplesEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetRasterizationSamplesEXT");
+        CmdSetSampleMaskEXT               = (PFN_vkCmdSetSampleMaskEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetSampleMaskEXT");
+        CmdSetAlphaToCoverageEnableEXT    = (PFN_vkCmdSetAlphaToCoverageEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetAlphaToCoverageEnableEXT");
+        CmdSetAlphaToOneEnableEXT         = (PFN_vkCmdSetAlphaToOneEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetAlphaToOneEnableEXT");
+        CmdSetLogicOpEnableEXT            = (PFN_vkCmdSetLogicOpEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetLogicOpEnableEXT");
+        CmdSetLogicOpEXT                  = (PFN_vkCmdSetLogicOpEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetLogicOpEXT");
+        CmdSetColorBlendEquationEXT       = (PFN_vkCmdSetColorBlendEquationEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetColorBlendEquationEXT");
+        CmdSetColorWriteMaskEXT           = (PFN_vkCmdSetColorWriteMaskEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetColorWriteMaskEXT");
+        CmdSetDepthClampEnableEXT         = (PFN_vkCmdSetDepthClampEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthClampEnableEXT");
+        CmdSetDepthClipEnableEXT          = (PFN_vkCmdSetDepthClipEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthClipEnableEXT");
+        mHasShaderObject = (CreateShadersEXT != nullptr) &&
+                           (DestroyShaderEXT != nullptr) &&
+                           (CmdBindShadersEXT != nullptr);
+
+        // The extension also provides the extended dynamic state commands
+        // the grfx::CommandBuffer setters use
+        if (IsNull(CmdSetCullModeEXT)) {
+            CmdSetCullModeEXT          = (PFN_vkCmdSetCullModeEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetCullModeEXT");
+            CmdSetPrimitiveTopologyEXT = (PFN_vkCmdSetPrimitiveTopologyEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetPrimitiveTopologyEXT");
+            CmdSetDepthTestEnableEXT   = (PFN_vkCmdSetDepthTestEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthTestEnableEXT");
+            CmdSetDepthWriteEnableEXT  = (PFN_vkCmdSetDepthWriteEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDepthWriteEnableEXT");
+        }
+        if (IsNull(CmdSetColorBlendEnableEXT)) {
+            CmdSetColorBlendEnableEXT = (PFN_vkCmdSetColorBlendEnableEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetColorBlendEnableEXT");
+        }
+    }
+#endif
+    // Shader objects are only created for pipelines that use dynamic rendering
+    mHasShaderObject = mHasShaderObject && mUsesDynamicRenderPasses;
+    PPX_LOG_INFO("Vulkan shader objects are present: " << mHasShaderObject);
+
+#if defined(VK_EXT_host_image_copy)
+    if (mHasHostImageCopy) {
+        CopyMemoryToImageEXT = (PFN_vkCopyMemoryToImageEXT)vkGetDeviceProcAddr(mDevice, "vkCopyMemoryToImageEXT");
+        mHasHostImageCopy    = (CopyMemoryToImageEXT != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan host image copy is present: " << mHasHostImageCopy);
+    PPX_LOG_INFO("Vulkan image compression control is present: " << mHasImageCompressionControl);
+
+#if defined(VK_KHR_buffer_device_address)
+    if (mHasBufferDeviceAddress) {
+        GetBufferDeviceAddressKHR = (PFN_vkGetBufferDeviceAddressKHR)vkGetDeviceProcAddr(mDevice, "vkGetBufferDeviceAddressKHR");
+        mHasBufferDeviceAddress   = (GetBufferDeviceAddressKHR != nullptr);
+    }
+#endif
+    PPX_LOG_INFO("Vulkan buffer device address is present: " << mHasBufferDeviceAddress);
+
+#if defined(VK_EXT_descriptor_buffer)
+    if (mHasDescriptorBuffer && mHasBufferDeviceAddress) {
+        GetDescriptorSetLayoutSizeEXT          = (PFN_vkGetDescriptorSetLayoutSizeEXT)vkGetDeviceProcAddr(mDevice, "vkGetDescriptorSetLayoutSizeEXT");
+        GetDescriptorSetLayoutBindingOffsetEXT = (PFN_vkGetDescriptorSetLayoutBindingOffsetEXT)vkGetDeviceProcAddr(mDevice, "vkGetDescriptorSetLayoutBindingOffsetEXT");
+        GetDescriptorEXT                       = (PFN_vkGetDescriptorEXT)vkGetDeviceProcAddr(mDevice, "vkGetDescriptorEXT");
+        CmdBindDescriptorBuffersEXT            = (PFN_vkCmdBindDescriptorBuffersEXT)vkGetDeviceProcAddr(mDevice, "vkCmdBindDescriptorBuffersEXT");
+        CmdSetDescriptorBufferOffsetsEXT       = (PFN_vkCmdSetDescriptorBufferOffsetsEXT)vkGetDeviceProcAddr(mDevice, "vkCmdSetDescriptorBufferOffsetsEXT");
+        mUsesDescriptorBuffers                 = (GetDescriptorSetLayoutSizeEXT != nullptr) &&
+                                                 (GetDescriptorSetLayoutBindingOffsetEXT != nullptr) &&
+                                                 (GetDescriptorEXT != nullptr) &&
+                                                 (CmdBindDescriptorBuffersEXT != nullptr) &&
+                                                 (CmdSetDescriptorBufferOffsetsEXT != nullptr);
+    }
+#endif
+    mHasDescriptorBufferPushDescriptors = mHasDescriptorBufferPushDescriptors && mUsesDescriptorBuffers;
+    PPX_LOG_INFO("Vulkan descriptor sets use descriptor buffers: " << mUsesDescriptorBuffers);
+
+#if defined(VK_KHR_acceleration_structure)
+    if (mHasAccelerationStructure) {
+        CreateAccelerationStructureKHR              = (PFN_vkCreateAccelerationStructureKHR)vkGetDeviceProcAddr(mDevice, "vkCreateAccelerationStructureKHR");
+        DestroyAccelerationStructureKHR             = (PFN_vkDestroyAccelerationStructureKHR)vkGetDeviceProcAddr(mDevice, "vkDestroyAccelerationStructureKHR");
+        GetAccelerationStructureBuildSizesKHR       = (PFN_vkGetAccelerationStructureBuildSizesKHR)vkGetDeviceProcAddr(mDevice, "vkGetAccelerationStructureBuildSizesKHR");
+        GetAccelerationStructureDeviceAddressKHR    = (PFN_vkGetAccelerationStructureDeviceAddressKHR)vkGetDeviceProcAddr(mDevice, "vkGetAccelerationStructureDeviceAddressKHR");
+        CmdBuildAccelerationStructuresKHR           = (PFN_vkCmdBuildAccelerationStructuresKHR)vkGetDeviceProcAddr(mDevice, "vkCmdBuildAccelerationStructuresKHR");
+        CmdCopyAccelerationStructureKHR             = (PFN_vkCmdCopyAccelerationStructureKHR)vkGetDeviceProcAddr(mDevice, "vkCmdCopyAccelerationStructureKHR");
+        CmdWriteAccelerationStructuresPropertiesKHR = (PFN_vkCmdWriteAccelerationStructuresPropertiesKHR)vkGetDeviceProcAddr(mDevice, "vkCmdWriteAccelerationStructuresPropertiesKHR");
+
+        mHasAccelerationStructure = (CreateAccelerationStructureKHR != nullptr) &&
+                                    (DestroyAccelerationStructureKHR != nullptr) &&
+                                    (GetAccelerationStructureBuildSizesKHR != nullptr) &&
+                                    (GetAccelerationStructureDeviceAddressKHR != nullptr) &&
+                                    (CmdBuildAccelerationStructuresKHR != nullptr) &&
+                                    (CmdCopyAccelerationStructureKHR != nullptr) &&
+                                    (CmdWriteAccelerationStructuresPropertiesKHR != nullptr) &&
+                                    mHasBufferDeviceAddress;
+        mHasRayQuery = mHasRayQuery && mHasAccelerationStructure;
+    }
+#endif
+    PPX_LOG_INFO("Vulkan acceleration structure is present: " << mHasAccelerationStructure);
+    PPX_LOG_INFO("Vulkan ray query is present: " << mHasRayQuery);
 
     // VMA
     {
+#if defined(VK_EXT_memory_budget)
+        mHasMemoryBudget = ElementExists(std::string(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME), mExtensions);
+#endif
+        PPX_LOG_INFO("Vulkan memory budget is present: " << mHasMemoryBudget);
+
+        // The instance is at least Vulkan 1.1, VMA needs to know that to use
+        // vkGetPhysicalDeviceMemoryProperties2 for the memory budget.
         VmaAllocatorCreateInfo vmaCreateInfo = {};
+        vmaCreateInfo.flags                  = mHasMemoryBudget ? VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT : 0;
         vmaCreateInfo.physicalDevice         = ToApi(pCreateInfo->pGpu)->GetVkGpu();
         vmaCreateInfo.device                 = mDevice;
         vmaCreateInfo.instance               = ToApi(GetInstance())->GetVkInstance();
+        vmaCreateInfo.vulkanApiVersion       = VK_API_VERSION_1_1;
+        if (mHasBufferDeviceAddress) {
+            // Buffers with shaderDeviceAddress usage, including acceleration
+            // structure, geometry and scratch buffers.
+            vmaCreateInfo.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+        }
 
         vkres = vmaCreateAllocator(&vmaCreateInfo, &mVmaAllocator);
         if (vkres != VK_SUCCESS) {
@@ -812,6 +1907,20 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
         }
     }
 
+    // Pipeline cache
+    ppxres = CreatePipelineCache(pCreateInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Descriptor buffer, needs VMA
+    if (mUsesDescriptorBuffers) {
+        ppxres = CreateDescriptorBuffer(pCreateInfo);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
     // Create queues
     ppxres = CreateQueues(pCreateInfo);
     if (Failed(ppxres)) {
@@ -823,6 +1932,44 @@ Result Device::CreateApiObjects(const grfx::DeviceCreateInfo* pCreateInfo)
 
 void Device::DestroyApiObjects()
 {
+    // Render passes are destroyed before the device, anything left was leaked
+    for (auto& elem : mFramebufferCache) {
+        vkDestroyFramebuffer(mDevice, elem.second.handle, nullptr);
+    }
+    mFramebufferCache.clear();
+    for (auto& elem : mRenderPassCache) {
+        vkDestroyRenderPass(mDevice, elem.second.handle, nullptr);
+    }
+    mRenderPassCache.clear();
+    for (auto& elem : mPipelineLibraryCache) {
+        vkDestroyPipeline(mDevice, elem.second.handle, nullptr);
+    }
+    mPipelineLibraryCache.clear();
+
+    if (mPipelineCache) {
+        SavePipelineCache();
+        vkDestroyPipelineCache(mDevice, mPipelineCache, nullptr);
+        mPipelineCache.Reset();
+    }
+
+#if defined(VK_EXT_descriptor_buffer)
+    // Descriptor sets are destroyed before the device, anything left was leaked
+    if (mDescriptorBufferBlock != VK_NULL_HANDLE) {
+        vmaClearVirtualBlock(mDescriptorBufferBlock);
+        vmaDestroyVirtualBlock(mDescriptorBufferBlock);
+        mDescriptorBufferBlock = VK_NULL_HANDLE;
+    }
+    mDescriptorBufferRanges.clear();
+
+    if (mDescriptorBuffer) {
+        vmaDestroyBuffer(mVmaAllocator, mDescriptorBuffer, mDescriptorBufferAllocation);
+        mDescriptorBuffer.Reset();
+        mDescriptorBufferAllocation.Reset();
+        mDescriptorBufferAddress       = 0;
+        mDescriptorBufferMappedAddress = nullptr;
+    }
+#endif
+
     if (mVmaAllocator) {
         vmaDestroyAllocator(mVmaAllocator);
         mVmaAllocator.Reset();
@@ -834,6 +1981,16 @@ void Device::DestroyApiObjects()
     }
 }
 
+Result Device::AllocateObject(grfx::AccelerationStructure** ppObject)
+{
+    vk::AccelerationStructure* pObject = new vk::AccelerationStructure();
+    if (IsNull(pObject)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+    *ppObject = pObject;
+    return ppx::SUCCESS;
+}
+
 Result Device::AllocateObject(grfx::Buffer** ppObject)
 {
     vk::Buffer* pObject = new vk::Buffer();
@@ -1113,16 +2270,481 @@ bool Device::FragmentStoresAndAtomicsSupported() const
     return mDeviceFeatures.fragmentStoresAndAtomics == VK_TRUE;
 }
 
+bool Device::TessellationShaderSupported() const
+{
+    return mDeviceFeatures.tessellationShader == VK_TRUE;
+}
+
+bool Device::GeometryShaderSupported() const
+{
+    return mDeviceFeatures.geometryShader == VK_TRUE;
+}
+
 bool Device::PartialDescriptorBindingsSupported() const
 {
     return mDescriptorIndexingFeatures.descriptorBindingPartiallyBound;
 }
 
+bool Device::PushDescriptorsSupported() const
+{
+    return (mMaxPushDescriptors > 0) && (!mUsesDescriptorBuffers || mHasDescriptorBufferPushDescriptors);
+}
+
 bool Device::IndexTypeUint8Supported() const
 {
     return mIndexTypeUint8Supported;
 }
 
+bool Device::DrawIndirectCountSupported() const
+{
+    return mHasDrawIndirectCount;
+}
+
+VkShaderStageFlags Device::GetSupportedShaderStageFlags() const
+{
+    VkShaderStageFlags flags = VK_SHADER_STAGE_ALL_GRAPHICS | VK_SHADER_STAGE_COMPUTE_BIT;
+#if defined(VK_EXT_mesh_shader)
+    if (mHasMeshShader) {
+        flags |= VK_SHADER_STAGE_MESH_BIT_EXT;
+    }
+    if (mHasTaskShader) {
+        flags |= VK_SHADER_STAGE_TASK_BIT_EXT;
+    }
+#endif
+    return flags;
+}
+
+bool Device::MeshShaderSupported() const
+{
+    return mHasMeshShader;
+}
+
+bool Device::AmplificationShaderSupported() const
+{
+    return mHasTaskShader;
+}
+
+bool Device::AccelerationStructureSupported() const
+{
+    return mHasAccelerationStructure;
+}
+
+bool Device::BufferDeviceAddressSupported() const
+{
+    return mHasBufferDeviceAddress;
+}
+
+bool Device::RayQuerySupported() const
+{
+    return mHasRayQuery;
+}
+
+bool Device::TimelineSemaphoreSupported() const
+{
+    return mHasTimelineSemaphore;
+}
+
+bool Device::ExtendedDynamicStateSupported() const
+{
+    return mHasExtendedDynamicState;
+}
+
+bool Device::ShaderObjectsSupported() const
+{
+    return mHasShaderObject;
+}
+
+bool Device::DescriptorBuffersEnabled() const
+{
+    return mUsesDescriptorBuffers;
+}
+
+bool Device::ConditionalRenderingSupported() const
+{
+    return mHasConditionalRendering;
+}
+
+bool Device::DynamicBlendEnableSupported() const
+{
+    return mHasDynamicBlendEnable;
+}
+
+bool Device::ImageHostUploadSupported(grfx::ImageHostUpload hostUpload, grfx::Format format) const
+{
+    VkPhysicalDevice gpu = ToApi(GetGpu())->GetVkGpu();
+
+    switch (hostUpload) {
+        default: break;
+
+        case grfx::IMAGE_HOST_UPLOAD_NONE: {
+            return true;
+        } break;
+
+        case grfx::IMAGE_HOST_UPLOAD_LINEAR: {
+            VkFormatProperties properties = {};
+            vkGetPhysicalDeviceFormatProperties(gpu, ToVkFormat(format), &properties);
+            return (properties.linearTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+        } break;
+
+#if defined(VK_EXT_host_image_copy)
+        case grfx::IMAGE_HOST_UPLOAD_HOST_IMAGE_COPY: {
+            if (!mHasHostImageCopy) {
+                return false;
+            }
+            VkFormatProperties3KHR properties3 = {VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_3_KHR};
+            VkFormatProperties2    properties2 = {VK_STRUCTURE_TYPE_FORMAT_PROPERTIES_2, &properties3};
+            vkGetPhysicalDeviceFormatProperties2(gpu, ToVkFormat(format), &properties2);
+            return (properties3.optimalTilingFeatures & VK_FORMAT_FEATURE_2_HOST_IMAGE_TRANSFER_BIT_EXT) != 0;
+        } break;
+#endif
+    }
+    return false;
+}
+
+bool Device::SampledImageFormatSupported(grfx::Format format) const
+{
+    VkFormatProperties properties = {};
+    vkGetPhysicalDeviceFormatProperties(ToApi(GetGpu())->GetVkGpu(), ToVkFormat(format), &properties);
+    return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+bool Device::RenderTargetSampleCountSupported(grfx::Format format, grfx::SampleCount sampleCount) const
+{
+    const bool        isDepthStencil = (grfx::GetFormatDescription(format)->aspect & grfx::FORMAT_ASPECT_DEPTH_STENCIL) != 0;
+    VkImageUsageFlags usage          = isDepthStencil ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+    VkImageFormatProperties properties = {};
+    VkResult                vkres      = vkGetPhysicalDeviceImageFormatProperties(
+        ToApi(GetGpu())->GetVkGpu(),
+        ToVkFormat(format),
+        VK_IMAGE_TYPE_2D,
+        VK_IMAGE_TILING_OPTIMAL,
+        usage,
+        0,
+        &properties);
+    if (vkres != VK_SUCCESS) {
+        return false;
+    }
+    return (properties.sampleCounts & ToVkSampleCount(sampleCount)) != 0;
+}
+
+bool Device::RenderTargetBlendSupported(grfx::Format format) const
+{
+    VkFormatProperties properties = {};
+    vkGetPhysicalDeviceFormatProperties(ToApi(GetGpu())->GetVkGpu(), ToVkFormat(format), &properties);
+    return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BLEND_BIT) != 0;
+}
+
+bool Device::ImageCompressionSupported(grfx::Format format, grfx::ImageCompression compression) const
+{
+    switch (compression) {
+        default: break;
+
+        case grfx::IMAGE_COMPRESSION_DEFAULT: {
+            return true;
+        } break;
+
+#if defined(VK_EXT_image_compression_control)
+        case grfx::IMAGE_COMPRESSION_DISABLED: {
+            return mHasImageCompressionControl;
+        } break;
+
+        // Drivers report the fixed-rate they would apply, none if the
+        // format can't be fixed-rate compressed
+        case grfx::IMAGE_COMPRESSION_FIXED_RATE: {
+            if (!mHasImageCompressionControl) {
+                return false;
+            }
+            VkImageCompressionControlEXT compressionControl = {VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT};
+            compressionControl.flags                        = VK_IMAGE_COMPRESSION_FIXED_RATE_DEFAULT_EXT;
+
+            VkPhysicalDeviceImageFormatInfo2 formatInfo = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2, &compressionControl};
+            formatInfo.format                           = ToVkFormat(format);
+            formatInfo.type                             = VK_IMAGE_TYPE_2D;
+            formatInfo.tiling                           = VK_IMAGE_TILING_OPTIMAL;
+            formatInfo.usage                            = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+            VkImageCompressionPropertiesEXT compressionProperties = {VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_PROPERTIES_EXT};
+            VkImageFormatProperties2        properties            = {VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2, &compressionProperties};
+
+            VkResult vkres = vkGetPhysicalDeviceImageFormatProperties2(ToApi(GetGpu())->GetVkGpu(), &formatInfo, &properties);
+            if (vkres != VK_SUCCESS) {
+                return false;
+            }
+            return compressionProperties.imageCompressionFixedRateFlags != VK_IMAGE_COMPRESSION_FIXED_RATE_NONE_EXT;
+        } break;
+#endif
+    }
+    return false;
+}
+
+bool Device::SparseResidencySupported() const
+{
+    return mHasSparseResidency;
+}
+
+Result Device::GetAccelerationStructureBuildSizes(const grfx::AccelerationStructureBuildInputs* pInputs, grfx::AccelerationStructureBuildSizes* pSizes) const
+{
+    PPX_ASSERT_NULL_ARG(pInputs);
+    PPX_ASSERT_NULL_ARG(pSizes);
+
+    if (!mHasAccelerationStructure) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+#if defined(VK_KHR_acceleration_structure)
+    vk::AccelerationStructureBuildGeometry geometry = {};
+    Result                                 ppxres   = ToVkAccelerationStructureBuildGeometry(pInputs, false, &geometry);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    VkAccelerationStructureBuildSizesInfoKHR sizesInfo = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR};
+    GetAccelerationStructureBuildSizesKHR(
+        mDevice,
+        VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+        &geometry.buildInfo,
+        DataPtr(geometry.primitiveCounts),
+        &sizesInfo);
+
+    pSizes->accelerationStructureSize = static_cast<uint64_t>(sizesInfo.accelerationStructureSize);
+    pSizes->buildScratchSize          = static_cast<uint64_t>(sizesInfo.buildScratchSize);
+    pSizes->updateScratchSize         = static_cast<uint64_t>(sizesInfo.updateScratchSize);
+
+    return ppx::SUCCESS;
+#else
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#endif
+}
+
+Result Device::GetMemoryStatistics(grfx::MemoryStatistics* pStatistics) const
+{
+    PPX_ASSERT_NULL_ARG(pStatistics);
+
+    const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+    vmaGetMemoryProperties(mVmaAllocator, &pMemoryProperties);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS] = {};
+    vmaGetHeapBudgets(mVmaAllocator, budgets);
+
+    pStatistics->heaps.resize(pMemoryProperties->memoryHeapCount);
+    for (uint32_t i = 0; i < pMemoryProperties->memoryHeapCount; ++i) {
+        grfx::MemoryHeapStatistics& heap = pStatistics->heaps[i];
+        heap.deviceLocal                 = (pMemoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+        heap.size                        = pMemoryProperties->memoryHeaps[i].size;
+        heap.usage                       = budgets[i].usage;
+        heap.budget                      = budgets[i].budget;
+        heap.blockCount                  = budgets[i].statistics.blockCount;
+        heap.allocationCount             = budgets[i].statistics.allocationCount;
+        heap.blockBytes                  = budgets[i].statistics.blockBytes;
+        heap.allocationBytes             = budgets[i].statistics.allocationBytes;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Device::DefragmentApiObjects(const grfx::DefragmentationInfo& info, grfx::DefragmentationStats* pStats)
+{
+    grfx::QueuePtr queue = GetGraphicsQueue();
+    if (!queue) {
+        PPX_ASSERT_MSG(false, "defragmentation requires a graphics queue");
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    // Map allocations to the resources that can move, VMA can pick any
+    // allocation including internal ones that must stay where they are
+    std::unordered_set<const grfx::Image*> aliasedImages;
+    mImages.ForEach([&](grfx::Image* pImage) {
+        if (!IsNull(pImage->GetAliasImage())) {
+            aliasedImages.insert(pImage->GetAliasImage());
+        }
+    });
+
+    std::unordered_map<VmaAllocation, vk::Buffer*> buffers;
+    mBuffers.ForEach([&](grfx::Buffer* pBuffer) {
+        vk::Buffer* pApiBuffer = ToApi(pBuffer);
+        if (pApiBuffer->IsMovable()) {
+            buffers[pApiBuffer->GetVmaAllocation()] = pApiBuffer;
+        }
+    });
+
+    std::unordered_map<VmaAllocation, vk::Image*> images;
+    if (info.imageState) {
+        mImages.ForEach([&](grfx::Image* pImage) {
+            vk::Image* pApiImage = ToApi(pImage);
+            if (pApiImage->IsMovable() && (aliasedImages.count(pImage) == 0)) {
+                images[pApiImage->GetVmaAllocation()] = pApiImage;
+            }
+        });
+    }
+
+    grfx::CommandBufferPtr commandBuffer;
+    Result                 ppxres = queue->CreateCommandBuffer(&commandBuffer, 0, 0);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::FencePtr        fence;
+    grfx::FenceCreateInfo fenceCreateInfo = {};
+    ppxres                                = CreateFence(&fenceCreateInfo, &fence);
+    if (Failed(ppxres)) {
+        queue->DestroyCommandBuffer(commandBuffer);
+        return ppxres;
+    }
+
+    VmaDefragmentationInfo defragInfo = {};
+    defragInfo.flags                  = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+    defragInfo.maxBytesPerPass        = static_cast<VkDeviceSize>(info.maxBytesPerPass);
+    defragInfo.maxAllocationsPerPass  = info.maxAllocationsPerPass;
+
+    VmaDefragmentationContext context = VK_NULL_HANDLE;
+    VkResult                  vkres   = vmaBeginDefragmentation(mVmaAllocator, &defragInfo, &context);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vmaBeginDefragmentation failed: " << ToString(vkres));
+        DestroyFence(fence);
+        queue->DestroyCommandBuffer(commandBuffer);
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    for (uint32_t pass = 0; (pass < info.maxPasses) && !pStats->complete; ++pass) {
+        VmaDefragmentationPassMoveInfo passInfo = {};
+        vkres                                   = vmaBeginDefragmentationPass(mVmaAllocator, context, &passInfo);
+        if (vkres == VK_SUCCESS) {
+            pStats->complete = true;
+            break;
+        }
+        if (vkres != VK_INCOMPLETE) {
+            PPX_ASSERT_MSG(false, "vmaBeginDefragmentationPass failed: " << ToString(vkres));
+            ppxres = ppx::ERROR_API_FAILURE;
+            break;
+        }
+
+        // Moves that fail to start are skipped along with the rest of the
+        // pass, the ones already recorded still need to finish
+        std::vector<vk::Buffer*> movedBuffers;
+        std::vector<vk::Image*>  movedImages;
+        VkCommandBuffer          cmd = ToApi(commandBuffer.Get())->GetVkCommandBuffer();
+
+        ppxres         = commandBuffer->Begin();
+        bool recording = Success(ppxres);
+        for (uint32_t i = 0; i < passInfo.moveCount; ++i) {
+            VmaDefragmentationMove& move = passInfo.pMoves[i];
+
+            auto bufferIt = buffers.find(move.srcAllocation);
+            auto imageIt  = images.find(move.srcAllocation);
+            if (Failed(ppxres)) {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            }
+            else if (bufferIt != buffers.end()) {
+                ppxres = bufferIt->second->BeginMove(move.dstTmpAllocation, cmd);
+                if (Failed(ppxres)) {
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                movedBuffers.push_back(bufferIt->second);
+            }
+            else if (imageIt != images.end()) {
+                grfx::ResourceState state = info.imageState(imageIt->second);
+                if (state == grfx::RESOURCE_STATE_UNDEFINED) {
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                ppxres = imageIt->second->BeginMove(move.dstTmpAllocation, state, cmd);
+                if (Failed(ppxres)) {
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                movedImages.push_back(imageIt->second);
+            }
+            else {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            }
+        }
+
+        if (!movedBuffers.empty() || !movedImages.empty()) {
+            // Copied buffers are read by later submissions
+            VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+            barrier.srcAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+        if (recording) {
+            commandBuffer->End();
+        }
+
+        bool copied = true;
+        if (!movedBuffers.empty() || !movedImages.empty()) {
+            grfx::SubmitInfo submitInfo   = {};
+            submitInfo.commandBufferCount = 1;
+            submitInfo.ppCommandBuffers   = &commandBuffer;
+            submitInfo.pFence             = fence;
+
+            Result submitres = queue->Submit(&submitInfo);
+            if (Success(submitres)) {
+                submitres = fence->WaitAndReset();
+            }
+            if (Failed(submitres)) {
+                // The copies may not have executed, everything stays where it is
+                PPX_ASSERT_MSG(false, "defragmentation copies failed");
+                WaitIdle();
+                for (uint32_t i = 0; i < passInfo.moveCount; ++i) {
+                    passInfo.pMoves[i].operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                }
+                copied = false;
+                ppxres = submitres;
+            }
+        }
+
+        // Old resources are destroyed before VMA frees their memory
+        for (vk::Buffer* pBuffer : movedBuffers) {
+            pBuffer->FinishMove(!copied);
+        }
+        for (vk::Image* pImage : movedImages) {
+            pImage->FinishMove(!copied);
+        }
+        if (!copied) {
+            movedBuffers.clear();
+            movedImages.clear();
+        }
+
+        vkres = vmaEndDefragmentationPass(mVmaAllocator, context, &passInfo);
+        pStats->passCount += 1;
+        pStats->complete = (vkres == VK_SUCCESS);
+
+        std::vector<grfx::Buffer*> grfxBuffers;
+        std::vector<grfx::Image*>  grfxImages;
+        for (vk::Buffer* pBuffer : movedBuffers) {
+            pBuffer->UpdateAllocationInfo();
+            grfxBuffers.push_back(pBuffer);
+        }
+        for (vk::Image* pImage : movedImages) {
+            pImage->UpdateAllocationInfo();
+            grfxImages.push_back(pImage);
+        }
+        pStats->bufferMoveCount += CountU32(grfxBuffers);
+        pStats->imageMoveCount += CountU32(grfxImages);
+
+        Result updateres = UpdateMovedResourceReferences(grfxBuffers, grfxImages);
+        if (Failed(updateres)) {
+            ppxres = updateres;
+        }
+        if (Failed(ppxres)) {
+            break;
+        }
+    }
+
+    VmaDefragmentationStats vmaStats = {};
+    vmaEndDefragmentation(mVmaAllocator, context, &vmaStats);
+    pStats->bytesMoved       = static_cast<uint64_t>(vmaStats.bytesMoved);
+    pStats->bytesFreed       = static_cast<uint64_t>(vmaStats.bytesFreed);
+    pStats->blocksFreedCount = vmaStats.deviceMemoryBlocksFreed;
+
+    DestroyFence(fence);
+    queue->DestroyCommandBuffer(commandBuffer);
+
+    return ppxres;
+}
+
 void Device::ResetQueryPoolEXT(
     VkQueryPool queryPool,
     uint32_t    firstQuery,
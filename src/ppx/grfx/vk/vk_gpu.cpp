@@ -41,6 +41,57 @@ uint32_t GetQueueFamilyIndexByPreferences(const std::vector<VkQueueFamilyPropert
     }
     return PPX_VALUE_IGNORED;
 }
+
+std::vector<std::string> GetDeviceExtensions(VkPhysicalDevice gpu)
+{
+    uint32_t count = 0;
+    if ((vkEnumerateDeviceExtensionProperties(gpu, nullptr, &count, nullptr) != VK_SUCCESS) || (count == 0)) {
+        return {};
+    }
+
+    std::vector<VkExtensionProperties> properties(count);
+    if (vkEnumerateDeviceExtensionProperties(gpu, nullptr, &count, properties.data()) != VK_SUCCESS) {
+        return {};
+    }
+
+    std::vector<std::string> extensions;
+    for (const auto& elem : properties) {
+        extensions.push_back(elem.extensionName);
+    }
+    return extensions;
+}
+
+// Vulkan leaves the encoding of driverVersion to the vendor
+std::string FormatDriverVersion(uint32_t vendorId, uint32_t version)
+{
+    uint32_t parts[4] = {};
+    uint32_t count    = 3;
+    if (vendorId == grfx::VENDOR_ID_NVIDIA) {
+        parts[0] = (version >> 22) & 0x3FF;
+        parts[1] = (version >> 14) & 0xFF;
+        parts[2] = (version >> 6) & 0xFF;
+        parts[3] = version & 0x3F;
+        count    = 4;
+    }
+#if defined(PPX_MSW)
+    else if (vendorId == grfx::VENDOR_ID_INTEL) {
+        parts[0] = version >> 14;
+        parts[1] = version & 0x3FFF;
+        count    = 2;
+    }
+#endif
+    else {
+        parts[0] = VK_VERSION_MAJOR(version);
+        parts[1] = VK_VERSION_MINOR(version);
+        parts[2] = VK_VERSION_PATCH(version);
+    }
+
+    std::string result = std::to_string(parts[0]);
+    for (uint32_t i = 1; i < count; ++i) {
+        result += "." + std::to_string(parts[i]);
+    }
+    return result;
+}
 } // namespace
 
 Result Gpu::CreateApiObjects(const grfx::internal::GpuCreateInfo* pCreateInfo)
@@ -64,10 +115,83 @@ Result Gpu::CreateApiObjects(const grfx::internal::GpuCreateInfo* pCreateInfo)
 
     mDeviceName     = mGpuProperties.deviceName;
     mDeviceVendorId = static_cast<grfx::VendorId>(mGpuProperties.deviceID);
+    mDriverVersion  = FormatDriverVersion(mGpuProperties.vendorID, mGpuProperties.driverVersion);
+
+    QueryShaderCapabilities();
 
     return ppx::SUCCESS;
 }
 
+void Gpu::QueryShaderCapabilities()
+{
+    const std::vector<std::string> extensions = GetDeviceExtensions(mGpu);
+
+    // Subgroups are core in Vulkan 1.1
+    VkPhysicalDeviceSubgroupProperties subgroupProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+    VkPhysicalDeviceProperties2        properties         = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+    properties.pNext                                      = &subgroupProperties;
+#if defined(VK_EXT_subgroup_size_control)
+    VkPhysicalDeviceSubgroupSizeControlPropertiesEXT sizeControlProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES_EXT};
+    if (ElementExists(std::string(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME), extensions)) {
+        subgroupProperties.pNext = &sizeControlProperties;
+    }
+#endif
+    vkGetPhysicalDeviceProperties2(mGpu, &properties);
+
+    grfx::SubgroupCapabilities& subgroup = mShaderCapabilities.subgroup;
+    subgroup.size                        = subgroupProperties.subgroupSize;
+    subgroup.minSize                     = subgroupProperties.subgroupSize;
+    subgroup.maxSize                     = subgroupProperties.subgroupSize;
+#if defined(VK_EXT_subgroup_size_control)
+    if (sizeControlProperties.minSubgroupSize > 0) {
+        subgroup.minSize = sizeControlProperties.minSubgroupSize;
+        subgroup.maxSize = sizeControlProperties.maxSubgroupSize;
+    }
+#endif
+
+    const VkShaderStageFlags graphicsStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    if ((subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) != 0) {
+        const VkSubgroupFeatureFlags ops = subgroupProperties.supportedOperations;
+        subgroup.allStages               = ((subgroupProperties.supportedStages & graphicsStages) == graphicsStages);
+        subgroup.basic                   = ((ops & VK_SUBGROUP_FEATURE_BASIC_BIT) != 0);
+        subgroup.vote                    = ((ops & VK_SUBGROUP_FEATURE_VOTE_BIT) != 0);
+        subgroup.arithmetic              = ((ops & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT) != 0);
+        subgroup.ballot                  = ((ops & VK_SUBGROUP_FEATURE_BALLOT_BIT) != 0);
+        subgroup.shuffle                 = ((ops & VK_SUBGROUP_FEATURE_SHUFFLE_BIT) != 0);
+        subgroup.shuffleRelative         = ((ops & VK_SUBGROUP_FEATURE_SHUFFLE_RELATIVE_BIT) != 0);
+        subgroup.clustered               = ((ops & VK_SUBGROUP_FEATURE_CLUSTERED_BIT) != 0);
+        subgroup.quad                    = ((ops & VK_SUBGROUP_FEATURE_QUAD_BIT) != 0);
+    }
+
+    mShaderCapabilities.int16 = (mGpuFeatures.shaderInt16 == VK_TRUE);
+
+    // Feature structs can only be chained if the extension is present
+    VkPhysicalDeviceFeatures2 features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+#if defined(VK_KHR_shader_float16_int8)
+    VkPhysicalDeviceShaderFloat16Int8FeaturesKHR float16Int8Features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_SHADER_FLOAT16_INT8_EXTENSION_NAME), extensions)) {
+        float16Int8Features.pNext = features.pNext;
+        features.pNext            = &float16Int8Features;
+    }
+#endif
+#if defined(VK_KHR_cooperative_matrix)
+    VkPhysicalDeviceCooperativeMatrixFeaturesKHR cooperativeMatrixFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_COOPERATIVE_MATRIX_FEATURES_KHR};
+    if (ElementExists(std::string(VK_KHR_COOPERATIVE_MATRIX_EXTENSION_NAME), extensions)) {
+        cooperativeMatrixFeatures.pNext = features.pNext;
+        features.pNext                  = &cooperativeMatrixFeatures;
+    }
+#endif
+    vkGetPhysicalDeviceFeatures2(mGpu, &features);
+
+#if defined(VK_KHR_shader_float16_int8)
+    mShaderCapabilities.float16 = (float16Int8Features.shaderFloat16 == VK_TRUE);
+    mShaderCapabilities.int8    = (float16Int8Features.shaderInt8 == VK_TRUE);
+#endif
+#if defined(VK_KHR_cooperative_matrix)
+    mShaderCapabilities.cooperativeMatrix = (cooperativeMatrixFeatures.cooperativeMatrix == VK_TRUE);
+#endif
+}
+
 void Gpu::DestroyApiObjects()
 {
     if (mGpu) {
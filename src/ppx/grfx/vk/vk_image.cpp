@@ -15,6 +15,7 @@
 #include "ppx/grfx/vk/vk_image.h"
 #include "ppx/grfx/vk/vk_device.h"
 #include "ppx/grfx/vk/vk_queue.h"
+#include "ppx/grfx/grfx_format.h"
 
 #include "ppx/grfx/vk/vk_profiler_fn_wrapper.h"
 
@@ -25,65 +26,145 @@ namespace vk {
 // -------------------------------------------------------------------------------------------------
 // Image
 // -------------------------------------------------------------------------------------------------
+Result Image::CreateVkImage(VkImage* pImage) const
+{
+    VkExtent3D extent = {};
+    extent.width      = mCreateInfo.width;
+    extent.height     = mCreateInfo.height;
+    extent.depth      = mCreateInfo.depth;
+
+    VkImageCreateFlags createFlags = 0;
+    if (mCreateInfo.type == grfx::IMAGE_TYPE_CUBE) {
+        createFlags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
+    }
+
+    if (mCreateInfo.createFlags.bits.subsampledFormat) {
+        createFlags |= VK_IMAGE_CREATE_SUBSAMPLED_BIT_EXT;
+    }
+    if (mCreateInfo.sparseResidency) {
+        createFlags |= VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+    }
+    auto queueIndices = ToApi(GetDevice())->GetAllQueueFamilyIndices();
+
+    bool linearTiling = (mCreateInfo.memoryUsage == grfx::MEMORY_USAGE_GPU_TO_CPU) ||
+                        (mCreateInfo.hostUpload == grfx::IMAGE_HOST_UPLOAD_LINEAR);
+
+    VkImageUsageFlags usage = ToVkImageUsageFlags(mCreateInfo.usageFlags);
+    if (IsMovable()) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    }
+#if defined(VK_EXT_host_image_copy)
+    if (mCreateInfo.hostUpload == grfx::IMAGE_HOST_UPLOAD_HOST_IMAGE_COPY) {
+        usage |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+    }
+#endif
+
+    VkImageCreateInfo vkci = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    vkci.flags             = createFlags;
+    vkci.imageType         = ToVkImageType(mCreateInfo.type);
+    vkci.format            = ToVkFormat(mCreateInfo.format);
+    vkci.extent            = extent;
+    vkci.mipLevels         = mCreateInfo.mipLevelCount;
+    vkci.arrayLayers       = mCreateInfo.arrayLayerCount;
+    vkci.samples           = ToVkSampleCount(mCreateInfo.sampleCount);
+    vkci.tiling            = linearTiling ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
+    vkci.usage             = usage;
+    vkci.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (mCreateInfo.concurrentMultiQueueUsage) {
+        vkci.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+        vkci.queueFamilyIndexCount = 3;
+        vkci.pQueueFamilyIndices   = queueIndices.data();
+    }
+    else {
+        vkci.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
+        vkci.queueFamilyIndexCount = 0;
+        vkci.pQueueFamilyIndices   = nullptr;
+    }
+
+#if defined(VK_EXT_image_compression_control)
+    VkImageCompressionControlEXT compressionControl = {VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_CONTROL_EXT};
+    if (mCreateInfo.compression != grfx::IMAGE_COMPRESSION_DEFAULT) {
+        compressionControl.flags = (mCreateInfo.compression == grfx::IMAGE_COMPRESSION_DISABLED) ? VK_IMAGE_COMPRESSION_DISABLED_EXT : VK_IMAGE_COMPRESSION_FIXED_RATE_DEFAULT_EXT;
+        vkci.pNext               = &compressionControl;
+    }
+#endif
+
+    VkAllocationCallbacks* pAllocator = nullptr;
+
+    VkResult vkres = vk::CreateImage(ToApi(GetDevice())->GetVkDevice(), &vkci, pAllocator, pImage);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateImage failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    return ppx::SUCCESS;
+}
+
 Result Image::CreateApiObjects(const grfx::ImageCreateInfo* pCreateInfo)
 {
     if (IsNull(pCreateInfo->pApiObject)) {
-        // Create image
-        {
-            VkExtent3D extent = {};
-            extent.width      = pCreateInfo->width;
-            extent.height     = pCreateInfo->height;
-            extent.depth      = pCreateInfo->depth;
-
-            VkImageCreateFlags createFlags = 0;
-            if (pCreateInfo->type == grfx::IMAGE_TYPE_CUBE) {
-                createFlags |= VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
-            }
+        Result ppxres = CreateVkImage(&mImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
 
-            if (pCreateInfo->createFlags.bits.subsampledFormat) {
-                createFlags |= VK_IMAGE_CREATE_SUBSAMPLED_BIT_EXT;
-            }
-            auto queueIndices = ToApi(GetDevice())->GetAllQueueFamilyIndices();
-
-            VkImageCreateInfo vkci = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
-            vkci.flags             = createFlags;
-            vkci.imageType         = ToVkImageType(pCreateInfo->type);
-            vkci.format            = ToVkFormat(pCreateInfo->format);
-            vkci.extent            = extent;
-            vkci.mipLevels         = pCreateInfo->mipLevelCount;
-            vkci.arrayLayers       = pCreateInfo->arrayLayerCount;
-            vkci.samples           = ToVkSampleCount(pCreateInfo->sampleCount);
-            vkci.tiling            = pCreateInfo->memoryUsage == grfx::MEMORY_USAGE_GPU_TO_CPU ? VK_IMAGE_TILING_LINEAR : VK_IMAGE_TILING_OPTIMAL;
-            vkci.usage             = ToVkImageUsageFlags(pCreateInfo->usageFlags);
-            vkci.initialLayout     = VK_IMAGE_LAYOUT_UNDEFINED;
-            if (pCreateInfo->concurrentMultiQueueUsage) {
-                vkci.sharingMode           = VK_SHARING_MODE_CONCURRENT;
-                vkci.queueFamilyIndexCount = 3;
-                vkci.pQueueFamilyIndices   = queueIndices.data();
+        // Sparse images get their memory per tile
+        if (pCreateInfo->sparseResidency) {
+            ppxres = InitializeSparseResidency(pCreateInfo);
+            if (Failed(ppxres)) {
+                return ppxres;
             }
-            else {
-                vkci.sharingMode           = VK_SHARING_MODE_EXCLUSIVE;
-                vkci.queueFamilyIndexCount = 0;
-                vkci.pQueueFamilyIndices   = nullptr;
+        }
+        // Alias memory of another image
+        else if (!IsNull(pCreateInfo->pAliasImage)) {
+            const vk::Image* pAliasImage = ToApi(pCreateInfo->pAliasImage);
+
+            VkMemoryRequirements memoryRequirements = {};
+            vkGetImageMemoryRequirements(ToApi(GetDevice())->GetVkDevice(), mImage, &memoryRequirements);
+
+            // Not asserting here: callers like grfx::RenderGraph fall back to
+            // a regular allocation if the memory doesn't fit.
+            const VmaAllocationInfo& aliasInfo  = pAliasImage->GetVmaAllocationInfo();
+            bool                     compatible = pAliasImage->GetVmaAllocation() &&
+                                                  (memoryRequirements.size <= aliasInfo.size) &&
+                                                  ((memoryRequirements.memoryTypeBits & (1u << aliasInfo.memoryType)) != 0) &&
+                                                  ((aliasInfo.offset % memoryRequirements.alignment) == 0);
+            if (!compatible) {
+                return ppx::ERROR_INVALID_CREATE_ARGUMENT;
             }
 
-            VkAllocationCallbacks* pAllocator = nullptr;
-
-            VkResult vkres = vk::CreateImage(ToApi(GetDevice())->GetVkDevice(), &vkci, pAllocator, &mImage);
+            VkResult vkres = vmaBindImageMemory(
+                ToApi(GetDevice())->GetVmaAllocator(),
+                pAliasImage->GetVmaAllocation(),
+                mImage);
             if (vkres != VK_SUCCESS) {
-                PPX_ASSERT_MSG(false, "vkCreateImage failed: " << ToString(vkres));
+                PPX_ASSERT_MSG(false, "vmaBindImageMemory failed: " << ToString(vkres));
                 return ppx::ERROR_API_FAILURE;
             }
         }
-
-        // Allocate memory
-        {
+        else {
+            // Allocate memory
             VmaMemoryUsage memoryUsage = ToVmaMemoryUsage(pCreateInfo->memoryUsage);
             if (memoryUsage == VMA_MEMORY_USAGE_UNKNOWN) {
                 PPX_ASSERT_MSG(false, "unknown memory usage");
                 return ppx::ERROR_API_FAILURE;
             }
 
+            // Desktop GPUs usually don't have a lazily allocated memory
+            // type, the allocation below falls back to GPU only memory.
+            if (pCreateInfo->usageFlags.bits.transientAttachment) {
+                memoryUsage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+            }
+
+            // Linear host upload images are written through a mapping,
+            // device local host visible memory skips a PCIe read on every
+            // texture fetch on ReBAR and integrated GPUs.
+            VkMemoryPropertyFlags preferredFlags = 0;
+            if (pCreateInfo->hostUpload == grfx::IMAGE_HOST_UPLOAD_LINEAR) {
+                memoryUsage    = VMA_MEMORY_USAGE_CPU_TO_GPU;
+                preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            }
+
             VmaAllocationCreateFlags createFlags = 0;
 
             if ((memoryUsage == VMA_MEMORY_USAGE_CPU_ONLY) || (memoryUsage == VMA_MEMORY_USAGE_CPU_TO_GPU)) {
@@ -94,7 +175,7 @@ Result Image::CreateApiObjects(const grfx::ImageCreateInfo* pCreateInfo)
             vma_alloc_ci.flags                   = createFlags;
             vma_alloc_ci.usage                   = memoryUsage;
             vma_alloc_ci.requiredFlags           = 0;
-            vma_alloc_ci.preferredFlags          = 0;
+            vma_alloc_ci.preferredFlags          = preferredFlags;
             vma_alloc_ci.memoryTypeBits          = 0;
             vma_alloc_ci.pool                    = VK_NULL_HANDLE;
             vma_alloc_ci.pUserData               = nullptr;
@@ -105,15 +186,23 @@ Result Image::CreateApiObjects(const grfx::ImageCreateInfo* pCreateInfo)
                 &vma_alloc_ci,
                 &mAllocation,
                 &mAllocationInfo);
+            if ((vkres == VK_ERROR_FEATURE_NOT_PRESENT) && (memoryUsage == VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED)) {
+                vma_alloc_ci.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+                vkres = vmaAllocateMemoryForImage(
+                    ToApi(GetDevice())->GetVmaAllocator(),
+                    mImage,
+                    &vma_alloc_ci,
+                    &mAllocation,
+                    &mAllocationInfo);
+            }
             if (vkres != VK_SUCCESS) {
                 PPX_ASSERT_MSG(false, "vmaAllocateMemoryForImage failed: " << ToString(vkres));
                 return ppx::ERROR_API_FAILURE;
             }
-        }
 
-        // Bind memory
-        {
-            VkResult vkres = vmaBindImageMemory(
+            // Bind memory
+            vkres = vmaBindImageMemory(
                 ToApi(GetDevice())->GetVmaAllocator(),
                 mAllocation,
                 mImage);
@@ -189,12 +278,207 @@ void Image::DestroyApiObjects()
         mAllocationInfo = {};
     }
 
+    for (VmaAllocation allocation : mSparseTileAllocations) {
+        if (allocation != VK_NULL_HANDLE) {
+            vmaFreeMemory(ToApi(GetDevice())->GetVmaAllocator(), allocation);
+        }
+    }
+    for (VmaAllocation allocation : mFreeSparseTileAllocations) {
+        vmaFreeMemory(ToApi(GetDevice())->GetVmaAllocator(), allocation);
+    }
+    for (VmaAllocation allocation : mMipTailAllocations) {
+        vmaFreeMemory(ToApi(GetDevice())->GetVmaAllocator(), allocation);
+    }
+    mSparseTileAllocations.clear();
+    mFreeSparseTileAllocations.clear();
+    mMipTailAllocations.clear();
+
+    if (mMoveImage) {
+        vkDestroyImage(ToApi(GetDevice())->GetVkDevice(), mMoveImage, nullptr);
+        mMoveImage.Reset();
+    }
+
     if (mImage) {
         vkDestroyImage(ToApi(GetDevice())->GetVkDevice(), mImage, nullptr);
         mImage.Reset();
     }
 }
 
+Result Image::InitializeSparseResidency(const grfx::ImageCreateInfo* pCreateInfo)
+{
+    vk::Device*  pDevice      = ToApi(GetDevice());
+    VmaAllocator vmaAllocator = pDevice->GetVmaAllocator();
+
+    vkGetImageMemoryRequirements(pDevice->GetVkDevice(), mImage, &mSparseMemoryRequirements);
+
+    uint32_t count = 0;
+    vkGetImageSparseMemoryRequirements(pDevice->GetVkDevice(), mImage, &count, nullptr);
+    std::vector<VkSparseImageMemoryRequirements> sparseRequirements(count);
+    vkGetImageSparseMemoryRequirements(pDevice->GetVkDevice(), mImage, &count, DataPtr(sparseRequirements));
+
+    auto colorRequirements = std::find_if(
+        sparseRequirements.begin(),
+        sparseRequirements.end(),
+        [](const VkSparseImageMemoryRequirements& elem) -> bool { return (elem.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT) != 0; });
+    if (colorRequirements == sparseRequirements.end()) {
+        PPX_ASSERT_MSG(false, "format has no sparse color aspect: " << ToString(pCreateInfo->format));
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    // The size of a sparse block is the image's memory alignment
+    mSparseProperties.tileWidth         = colorRequirements->formatProperties.imageGranularity.width;
+    mSparseProperties.tileHeight        = colorRequirements->formatProperties.imageGranularity.height;
+    mSparseProperties.tileSize          = mSparseMemoryRequirements.alignment;
+    mSparseProperties.firstMipTailLevel = std::min(colorRequirements->imageMipTailFirstLod, pCreateInfo->mipLevelCount);
+    mSparseProperties.mipTailSize       = 0;
+
+    // Mip tails of the color and metadata aspects are bound once and stay
+    // resident. Metadata only exists as a mip tail.
+    std::vector<VkSparseMemoryBind> mipTailBinds;
+    for (const auto& requirements : sparseRequirements) {
+        const bool isMetadata = (requirements.formatProperties.aspectMask & VK_IMAGE_ASPECT_METADATA_BIT) != 0;
+        if (!isMetadata && (requirements.imageMipTailFirstLod >= pCreateInfo->mipLevelCount)) {
+            continue;
+        }
+
+        const bool     singleMipTail = (requirements.formatProperties.flags & VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT) != 0;
+        const uint32_t mipTailCount  = singleMipTail ? 1 : pCreateInfo->arrayLayerCount;
+        for (uint32_t layer = 0; layer < mipTailCount; ++layer) {
+            VkMemoryRequirements memoryRequirements = mSparseMemoryRequirements;
+            memoryRequirements.size                 = requirements.imageMipTailSize;
+
+            VmaAllocationCreateInfo vma_alloc_ci = {};
+            vma_alloc_ci.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+
+            VmaAllocation     allocation     = VK_NULL_HANDLE;
+            VmaAllocationInfo allocationInfo = {};
+
+            VkResult vkres = vmaAllocateMemory(vmaAllocator, &memoryRequirements, &vma_alloc_ci, &allocation, &allocationInfo);
+            if (vkres != VK_SUCCESS) {
+                PPX_ASSERT_MSG(false, "vmaAllocateMemory failed: " << ToString(vkres));
+                return ppx::ERROR_API_FAILURE;
+            }
+            mMipTailAllocations.push_back(allocation);
+
+            VkSparseMemoryBind bind = {};
+            bind.resourceOffset     = requirements.imageMipTailOffset + layer * requirements.imageMipTailStride;
+            bind.size               = requirements.imageMipTailSize;
+            bind.memory             = allocationInfo.deviceMemory;
+            bind.memoryOffset       = allocationInfo.offset;
+            bind.flags              = isMetadata ? VK_SPARSE_MEMORY_BIND_METADATA_BIT : 0;
+            mipTailBinds.push_back(bind);
+
+            if (!isMetadata) {
+                mSparseProperties.mipTailSize += requirements.imageMipTailSize;
+            }
+        }
+    }
+
+    if (!mipTailBinds.empty()) {
+        VkSparseImageOpaqueMemoryBindInfo opaqueBind = {};
+        opaqueBind.image                             = mImage;
+        opaqueBind.bindCount                         = CountU32(mipTailBinds);
+        opaqueBind.pBinds                            = DataPtr(mipTailBinds);
+
+        VkBindSparseInfo bindInfo     = {VK_STRUCTURE_TYPE_BIND_SPARSE_INFO};
+        bindInfo.imageOpaqueBindCount = 1;
+        bindInfo.pImageOpaqueBinds    = &opaqueBind;
+
+        VkResult vkres = ToApi(GetDevice()->GetGraphicsQueue().Get())->BindSparseAndWait(&bindInfo);
+        if (vkres != VK_SUCCESS) {
+            PPX_ASSERT_MSG(false, "vk::Queue::BindSparseAndWait failed: " << ToString(vkres));
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result Image::GetSparseImageMemoryBinds(
+    const grfx::SparseImageBindInfo*      pBindInfo,
+    std::vector<VkSparseImageMemoryBind>* pBinds)
+{
+    PPX_ASSERT_NULL_ARG(pBindInfo);
+    PPX_ASSERT_NULL_ARG(pBinds);
+
+    VmaAllocator vmaAllocator = ToApi(GetDevice())->GetVmaAllocator();
+
+    // Indexed by GetSparseTileIndex(), which is only valid once the image
+    // has been created
+    if (mSparseTileAllocations.empty()) {
+        mSparseTileAllocations.assign(GetSparseTileCount(), VK_NULL_HANDLE);
+    }
+
+    // Allocate what unbinds and earlier unbinds don't give back before
+    // changing anything, so that a failed allocation leaves the image as is
+    size_t                     reusableCount = mFreeSparseTileAllocations.size() + pBindInfo->unbindTileCount;
+    size_t                     newCount      = (pBindInfo->bindTileCount > reusableCount) ? (pBindInfo->bindTileCount - reusableCount) : 0;
+    std::vector<VmaAllocation> newAllocations(newCount, VK_NULL_HANDLE);
+    if (newCount > 0) {
+        VkMemoryRequirements memoryRequirements = mSparseMemoryRequirements;
+        memoryRequirements.size                 = mSparseMemoryRequirements.alignment;
+
+        VmaAllocationCreateInfo vma_alloc_ci = {};
+        vma_alloc_ci.usage                   = VMA_MEMORY_USAGE_GPU_ONLY;
+
+        VkResult vkres = vmaAllocateMemoryPages(vmaAllocator, &memoryRequirements, &vma_alloc_ci, newCount, newAllocations.data(), nullptr);
+        if (vkres != VK_SUCCESS) {
+            PPX_LOG_ERROR("vmaAllocateMemoryPages failed for " << newCount << " sparse tiles: " << ToString(vkres));
+            return ppx::ERROR_OUT_OF_MEMORY;
+        }
+    }
+    mFreeSparseTileAllocations.insert(mFreeSparseTileAllocations.end(), newAllocations.begin(), newAllocations.end());
+
+    auto ToVkBind = [this, vmaAllocator](const grfx::SparseImageTile& tile, VmaAllocation allocation) -> VkSparseImageMemoryBind {
+        const int32_t  x      = static_cast<int32_t>(tile.x * mSparseProperties.tileWidth);
+        const int32_t  y      = static_cast<int32_t>(tile.y * mSparseProperties.tileHeight);
+        const uint32_t width  = std::max(GetWidth() >> tile.mipLevel, 1u);
+        const uint32_t height = std::max(GetHeight() >> tile.mipLevel, 1u);
+
+        VkSparseImageMemoryBind bind = {};
+        bind.subresource.aspectMask  = VK_IMAGE_ASPECT_COLOR_BIT;
+        bind.subresource.mipLevel    = tile.mipLevel;
+        bind.subresource.arrayLayer  = tile.arrayLayer;
+        bind.offset                  = {x, y, 0};
+        bind.extent.width            = std::min(mSparseProperties.tileWidth, width - static_cast<uint32_t>(x));
+        bind.extent.height           = std::min(mSparseProperties.tileHeight, height - static_cast<uint32_t>(y));
+        bind.extent.depth            = 1;
+        bind.memory                  = VK_NULL_HANDLE;
+        bind.memoryOffset            = 0;
+        bind.flags                   = 0;
+
+        if (allocation != VK_NULL_HANDLE) {
+            VmaAllocationInfo allocationInfo = {};
+            vmaGetAllocationInfo(vmaAllocator, allocation, &allocationInfo);
+            bind.memory       = allocationInfo.deviceMemory;
+            bind.memoryOffset = allocationInfo.offset;
+        }
+        return bind;
+    };
+
+    for (uint32_t i = 0; i < pBindInfo->unbindTileCount; ++i) {
+        const grfx::SparseImageTile& tile  = pBindInfo->pUnbindTiles[i];
+        const uint32_t               index = GetSparseTileIndex(tile);
+        PPX_ASSERT_MSG(mSparseTileAllocations[index] != VK_NULL_HANDLE, "unbinding a sparse tile without memory");
+
+        mFreeSparseTileAllocations.push_back(mSparseTileAllocations[index]);
+        mSparseTileAllocations[index] = VK_NULL_HANDLE;
+        pBinds->push_back(ToVkBind(tile, VK_NULL_HANDLE));
+    }
+
+    for (uint32_t i = 0; i < pBindInfo->bindTileCount; ++i) {
+        const grfx::SparseImageTile& tile  = pBindInfo->pBindTiles[i];
+        const uint32_t               index = GetSparseTileIndex(tile);
+        PPX_ASSERT_MSG(mSparseTileAllocations[index] == VK_NULL_HANDLE, "binding a sparse tile that has memory");
+
+        mSparseTileAllocations[index] = mFreeSparseTileAllocations.back();
+        mFreeSparseTileAllocations.pop_back();
+        pBinds->push_back(ToVkBind(tile, mSparseTileAllocations[index]));
+    }
+
+    return ppx::SUCCESS;
+}
+
 Result Image::MapMemory(uint64_t offset, void** ppMappedAddress)
 {
     if (IsNull(ppMappedAddress)) {
@@ -220,6 +504,193 @@ void Image::UnmapMemory()
         mAllocation);
 }
 
+Result Image::CopyFromHost(
+    uint32_t    mipLevel,
+    uint32_t    arrayLayer,
+    const void* pSrcData,
+    uint32_t    srcRowStride)
+{
+    PPX_ASSERT_NULL_ARG(pSrcData);
+
+    if ((mipLevel >= GetMipLevelCount()) || (arrayLayer >= GetArrayLayerCount())) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    const grfx::FormatDesc* pFormatDesc = grfx::GetFormatDescription(GetFormat());
+    const uint32_t          width       = std::max<uint32_t>(GetWidth() >> mipLevel, 1);
+    const uint32_t          height      = std::max<uint32_t>(GetHeight() >> mipLevel, 1);
+    const uint32_t          depth       = std::max<uint32_t>(GetDepth() >> mipLevel, 1);
+    const uint32_t          rowSize     = width * pFormatDesc->bytesPerTexel;
+    if (srcRowStride < rowSize) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    switch (GetHostUpload()) {
+        default: {
+            PPX_ASSERT_MSG(false, "image wasn't created with hostUpload");
+            return ppx::ERROR_GRFX_OPERATION_NOT_PERMITTED;
+        } break;
+
+        case grfx::IMAGE_HOST_UPLOAD_LINEAR: {
+            VkImageSubresource subresource = {};
+            subresource.aspectMask         = mImageAspect;
+            subresource.mipLevel           = mipLevel;
+            subresource.arrayLayer         = arrayLayer;
+
+            VkSubresourceLayout layout = {};
+            vkGetImageSubresourceLayout(ToApi(GetDevice())->GetVkDevice(), mImage, &subresource, &layout);
+
+            // Mapped at creation, see CreateApiObjects()
+            char*       pDst = static_cast<char*>(mAllocationInfo.pMappedData) + layout.offset;
+            const char* pSrc = static_cast<const char*>(pSrcData);
+            for (uint32_t z = 0; z < depth; ++z) {
+                for (uint32_t y = 0; y < height; ++y) {
+                    std::memcpy(pDst + z * layout.depthPitch + y * layout.rowPitch, pSrc + (z * height + y) * srcRowStride, rowSize);
+                }
+            }
+
+            VkResult vkres = vmaFlushAllocation(ToApi(GetDevice())->GetVmaAllocator(), mAllocation, layout.offset, layout.size);
+            if (vkres != VK_SUCCESS) {
+                PPX_ASSERT_MSG(false, "vmaFlushAllocation failed: " << ToString(vkres));
+                return ppx::ERROR_API_FAILURE;
+            }
+        } break;
+
+#if defined(VK_EXT_host_image_copy)
+        case grfx::IMAGE_HOST_UPLOAD_HOST_IMAGE_COPY: {
+            VkMemoryToImageCopyEXT region = {VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT};
+            region.pHostPointer           = pSrcData;
+            region.memoryRowLength        = srcRowStride / pFormatDesc->bytesPerTexel;
+            region.memoryImageHeight      = 0;
+            region.imageSubresource       = {mImageAspect, mipLevel, arrayLayer, 1};
+            region.imageOffset            = {0, 0, 0};
+            region.imageExtent            = {width, height, depth};
+
+            // Host upload images stay in RESOURCE_STATE_GENERAL, which every
+            // implementation supports as a host copy destination.
+            VkCopyMemoryToImageInfoEXT copyInfo = {VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT};
+            copyInfo.flags                      = 0;
+            copyInfo.dstImage                   = mImage;
+            copyInfo.dstImageLayout             = VK_IMAGE_LAYOUT_GENERAL;
+            copyInfo.regionCount                = 1;
+            copyInfo.pRegions                   = &region;
+
+            VkResult vkres = vk::CopyMemoryToImageEXT(ToApi(GetDevice())->GetVkDevice(), &copyInfo);
+            if (vkres != VK_SUCCESS) {
+                PPX_ASSERT_MSG(false, "vkCopyMemoryToImageEXT failed: " << ToString(vkres));
+                return ppx::ERROR_API_FAILURE;
+            }
+        } break;
+#endif
+    }
+
+    return ppx::SUCCESS;
+}
+
+bool Image::IsMovable() const
+{
+    // Linear host upload images are mapped and lazily allocated memory
+    // can't be copied
+    if (!IsNull(mCreateInfo.pApiObject) || !IsNull(mCreateInfo.pAliasImage) || mCreateInfo.sparseResidency) {
+        return false;
+    }
+    if ((mCreateInfo.hostUpload == grfx::IMAGE_HOST_UPLOAD_LINEAR) || mCreateInfo.usageFlags.bits.transientAttachment) {
+        return false;
+    }
+    return GetDevice()->IsDefragmentationEnabled() && (mCreateInfo.memoryUsage == grfx::MEMORY_USAGE_GPU_ONLY);
+}
+
+Result Image::BeginMove(VmaAllocation dstAllocation, grfx::ResourceState state, VkCommandBuffer commandBuffer)
+{
+    PPX_ASSERT_MSG(!mMoveImage, "image move already in progress");
+
+    vk::Device* pDevice = ToApi(GetDevice());
+
+    VkPipelineStageFlags stageMask  = 0;
+    VkAccessFlags        accessMask = 0;
+    VkImageLayout        layout     = VK_IMAGE_LAYOUT_UNDEFINED;
+    Result               ppxres     = ToVkBarrierDst(state, grfx::COMMAND_TYPE_GRAPHICS, pDevice->GetDeviceFeatures(), stageMask, accessMask, layout);
+    if (Failed(ppxres)) {
+        PPX_ASSERT_MSG(false, "couldn't determine layout of image state");
+        return ppxres;
+    }
+
+    ppxres = CreateVkImage(&mMoveImage);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    VkResult vkres = vmaBindImageMemory(pDevice->GetVmaAllocator(), dstAllocation, mMoveImage);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vmaBindImageMemory failed: " << ToString(vkres));
+        vkDestroyImage(pDevice->GetVkDevice(), mMoveImage, nullptr);
+        mMoveImage.Reset();
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    VkImageSubresourceRange range = {mImageAspect, 0, mCreateInfo.mipLevelCount, 0, mCreateInfo.arrayLayerCount};
+
+    // Previous work is finished, the device is idle during defragmentation
+    VkImageMemoryBarrier barriers[2] = {};
+    barriers[0]                      = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barriers[0].srcAccessMask        = VK_ACCESS_MEMORY_WRITE_BIT;
+    barriers[0].dstAccessMask        = VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[0].oldLayout            = layout;
+    barriers[0].newLayout            = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[0].srcQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].dstQueueFamilyIndex  = VK_QUEUE_FAMILY_IGNORED;
+    barriers[0].image                = mImage;
+    barriers[0].subresourceRange     = range;
+    barriers[1]                      = barriers[0];
+    barriers[1].srcAccessMask        = 0;
+    barriers[1].dstAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[1].oldLayout            = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[1].image                = mMoveImage;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 2, barriers);
+
+    std::vector<VkImageCopy> regions(mCreateInfo.mipLevelCount);
+    for (uint32_t mip = 0; mip < mCreateInfo.mipLevelCount; ++mip) {
+        VkImageCopy& region   = regions[mip];
+        region.srcSubresource = {mImageAspect, mip, 0, mCreateInfo.arrayLayerCount};
+        region.srcOffset      = {0, 0, 0};
+        region.dstSubresource = region.srcSubresource;
+        region.dstOffset      = {0, 0, 0};
+        region.extent.width   = std::max<uint32_t>(mCreateInfo.width >> mip, 1);
+        region.extent.height  = std::max<uint32_t>(mCreateInfo.height >> mip, 1);
+        region.extent.depth   = std::max<uint32_t>(mCreateInfo.depth >> mip, 1);
+    }
+    vkCmdCopyImage(commandBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mMoveImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, CountU32(regions), regions.data());
+
+    VkImageMemoryBarrier barrier = barriers[1];
+    barrier.srcAccessMask        = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask        = accessMask;
+    barrier.oldLayout            = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout            = layout;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, stageMask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    return ppx::SUCCESS;
+}
+
+void Image::FinishMove(bool cancel)
+{
+    PPX_ASSERT_MSG(mMoveImage, "no image move in progress");
+
+    if (cancel) {
+        vkDestroyImage(ToApi(GetDevice())->GetVkDevice(), mMoveImage, nullptr);
+    }
+    else {
+        vkDestroyImage(ToApi(GetDevice())->GetVkDevice(), mImage, nullptr);
+        mImage = mMoveImage;
+    }
+    mMoveImage.Reset();
+}
+
+void Image::UpdateAllocationInfo()
+{
+    vmaGetAllocationInfo(ToApi(GetDevice())->GetVmaAllocator(), mAllocation, &mAllocationInfo);
+}
+
 // -------------------------------------------------------------------------------------------------
 // Sampler
 // -------------------------------------------------------------------------------------------------
@@ -19,24 +19,67 @@
 #include "ppx/grfx/vk/vk_render_pass.h"
 #include "ppx/grfx/vk/vk_shader.h"
 
+#include "xxhash.h"
+
+#include <algorithm>
+#include <cstring>
+
 namespace ppx {
 namespace grfx {
 namespace vk {
 
+VkPipelineCreateFlags ToVkDescriptorBufferPipelineFlags(const vk::Device* pDevice)
+{
+#if defined(VK_EXT_descriptor_buffer)
+    if (pDevice->UsesDescriptorBuffers()) {
+        return VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT;
+    }
+#endif
+    return 0;
+}
+
+const VkSpecializationInfo* ToVkSpecializationInfo(const grfx::ShaderStageInfo& stage, vk::SpecializationInfo* pSpecialization)
+{
+    if (stage.specializationConstants.empty()) {
+        return nullptr;
+    }
+
+    pSpecialization->mapEntries.clear();
+    pSpecialization->data.clear();
+    for (const auto& constant : stage.specializationConstants) {
+        VkSpecializationMapEntry entry = {};
+        entry.constantID               = constant.id;
+        entry.offset                   = static_cast<uint32_t>(pSpecialization->data.size() * sizeof(uint32_t));
+        entry.size                     = sizeof(uint32_t);
+        pSpecialization->mapEntries.push_back(entry);
+        pSpecialization->data.push_back(constant.value);
+    }
+
+    pSpecialization->info               = {};
+    pSpecialization->info.mapEntryCount = CountU32(pSpecialization->mapEntries);
+    pSpecialization->info.pMapEntries   = DataPtr(pSpecialization->mapEntries);
+    pSpecialization->info.dataSize      = pSpecialization->data.size() * sizeof(uint32_t);
+    pSpecialization->info.pData         = DataPtr(pSpecialization->data);
+
+    return &pSpecialization->info;
+}
+
 // -------------------------------------------------------------------------------------------------
 // ComputePipeline
 // -------------------------------------------------------------------------------------------------
 Result ComputePipeline::CreateApiObjects(const grfx::ComputePipelineCreateInfo* pCreateInfo)
 {
+    vk::SpecializationInfo specialization = {};
+
     VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
     ssci.flags                           = 0;
-    ssci.pSpecializationInfo             = nullptr;
+    ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->CS, &specialization);
     ssci.pName                           = pCreateInfo->CS.entryPoint.c_str();
     ssci.stage                           = VK_SHADER_STAGE_COMPUTE_BIT;
     ssci.module                          = ToApi(pCreateInfo->CS.pModule)->GetVkShaderModule();
 
     VkComputePipelineCreateInfo vkci = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
-    vkci.flags                       = 0;
+    vkci.flags                       = ToVkDescriptorBufferPipelineFlags(ToApi(GetDevice()));
     vkci.stage                       = ssci;
     vkci.layout                      = ToApi(pCreateInfo->pPipelineInterface)->GetVkPipelineLayout();
     vkci.basePipelineHandle          = VK_NULL_HANDLE;
@@ -44,7 +87,7 @@ Result ComputePipeline::CreateApiObjects(const grfx::ComputePipelineCreateInfo*
 
     VkResult vkres = vkCreateComputePipelines(
         ToApi(GetDevice())->GetVkDevice(),
-        VK_NULL_HANDLE,
+        ToApi(GetDevice())->GetVkPipelineCache(),
         1,
         &vkci,
         nullptr,
@@ -68,18 +111,78 @@ void ComputePipeline::DestroyApiObjects()
 // -------------------------------------------------------------------------------------------------
 // GraphicsPipeline
 // -------------------------------------------------------------------------------------------------
+#if defined(VK_EXT_graphics_pipeline_library)
+namespace {
+
+uint64_t FloatKey(float value)
+{
+    uint32_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+void AppendShaderStageKey(const grfx::ShaderStageInfo& stage, VkShaderStageFlagBits vkStage, std::vector<uint64_t>& key)
+{
+    if (IsNull(stage.pModule)) {
+        return;
+    }
+
+    key.push_back(vkStage);
+    key.push_back(ToApi(stage.pModule)->GetCodeHash());
+    key.push_back(XXH3_64bits(stage.entryPoint.data(), stage.entryPoint.size()));
+    key.push_back(stage.specializationConstants.size());
+    for (const auto& constant : stage.specializationConstants) {
+        key.push_back((static_cast<uint64_t>(constant.id) << 32) | constant.value);
+    }
+}
+
+void AppendDynamicStateKey(const VkPipelineDynamicStateCreateInfo& dynamicState, std::vector<uint64_t>& key)
+{
+    key.push_back(dynamicState.dynamicStateCount);
+    for (uint32_t i = 0; i < dynamicState.dynamicStateCount; ++i) {
+        key.push_back(dynamicState.pDynamicStates[i]);
+    }
+}
+
+void AppendMultisampleKey(const VkPipelineMultisampleStateCreateInfo& multisampleState, std::vector<uint64_t>& key)
+{
+    key.push_back(multisampleState.rasterizationSamples);
+    key.push_back(multisampleState.sampleShadingEnable);
+    key.push_back(FloatKey(multisampleState.minSampleShading));
+    key.push_back(multisampleState.alphaToCoverageEnable);
+    key.push_back(multisampleState.alphaToOneEnable);
+}
+
+void AppendStencilOpKey(const VkStencilOpState& op, std::vector<uint64_t>& key)
+{
+    key.push_back(op.failOp);
+    key.push_back(op.passOp);
+    key.push_back(op.depthFailOp);
+    key.push_back(op.compareOp);
+    key.push_back(op.compareMask);
+    key.push_back(op.writeMask);
+    key.push_back(op.reference);
+}
+
+} // namespace
+#endif
+
 Result GraphicsPipeline::InitializeShaderStages(
     const grfx::GraphicsPipelineCreateInfo*       pCreateInfo,
+    std::vector<vk::SpecializationInfo>&          specializations,
     std::vector<VkPipelineShaderStageCreateInfo>& shaderStages,
     VkGraphicsPipelineCreateInfo&                 vkCreateInfo)
 {
+    // One entry per stage so the pointers into it stay valid
+    specializations.resize(7);
+
     // VS
     if (!IsNull(pCreateInfo->VS.pModule)) {
         const vk::ShaderModule* pModule = ToApi(pCreateInfo->VS.pModule);
 
         VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
         ssci.flags                           = 0;
-        ssci.pSpecializationInfo             = nullptr;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->VS, &specializations[0]);
         ssci.pName                           = pCreateInfo->VS.entryPoint.c_str();
         ssci.stage                           = VK_SHADER_STAGE_VERTEX_BIT;
         ssci.module                          = pModule->GetVkShaderModule();
@@ -92,7 +195,7 @@ Result GraphicsPipeline::InitializeShaderStages(
 
         VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
         ssci.flags                           = 0;
-        ssci.pSpecializationInfo             = nullptr;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->HS, &specializations[1]);
         ssci.pName                           = pCreateInfo->HS.entryPoint.c_str();
         ssci.stage                           = VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
         ssci.module                          = pModule->GetVkShaderModule();
@@ -105,7 +208,7 @@ Result GraphicsPipeline::InitializeShaderStages(
 
         VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
         ssci.flags                           = 0;
-        ssci.pSpecializationInfo             = nullptr;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->DS, &specializations[2]);
         ssci.pName                           = pCreateInfo->DS.entryPoint.c_str();
         ssci.stage                           = VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
         ssci.module                          = pModule->GetVkShaderModule();
@@ -118,20 +221,48 @@ Result GraphicsPipeline::InitializeShaderStages(
 
         VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
         ssci.flags                           = 0;
-        ssci.pSpecializationInfo             = nullptr;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->GS, &specializations[3]);
         ssci.pName                           = pCreateInfo->GS.entryPoint.c_str();
         ssci.stage                           = VK_SHADER_STAGE_GEOMETRY_BIT;
         ssci.module                          = pModule->GetVkShaderModule();
         shaderStages.push_back(ssci);
     }
 
+#if defined(VK_EXT_mesh_shader)
+    // AS
+    if (!IsNull(pCreateInfo->AS.pModule)) {
+        const vk::ShaderModule* pModule = ToApi(pCreateInfo->AS.pModule);
+
+        VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        ssci.flags                           = 0;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->AS, &specializations[4]);
+        ssci.pName                           = pCreateInfo->AS.entryPoint.c_str();
+        ssci.stage                           = VK_SHADER_STAGE_TASK_BIT_EXT;
+        ssci.module                          = pModule->GetVkShaderModule();
+        shaderStages.push_back(ssci);
+    }
+
+    // MS
+    if (!IsNull(pCreateInfo->MS.pModule)) {
+        const vk::ShaderModule* pModule = ToApi(pCreateInfo->MS.pModule);
+
+        VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        ssci.flags                           = 0;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->MS, &specializations[5]);
+        ssci.pName                           = pCreateInfo->MS.entryPoint.c_str();
+        ssci.stage                           = VK_SHADER_STAGE_MESH_BIT_EXT;
+        ssci.module                          = pModule->GetVkShaderModule();
+        shaderStages.push_back(ssci);
+    }
+#endif
+
     // PS
     if (!IsNull(pCreateInfo->PS.pModule)) {
         const vk::ShaderModule* pModule = ToApi(pCreateInfo->PS.pModule);
 
         VkPipelineShaderStageCreateInfo ssci = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
         ssci.flags                           = 0;
-        ssci.pSpecializationInfo             = nullptr;
+        ssci.pSpecializationInfo             = ToVkSpecializationInfo(pCreateInfo->PS, &specializations[6]);
         ssci.pName                           = pCreateInfo->PS.entryPoint.c_str();
         ssci.stage                           = VK_SHADER_STAGE_FRAGMENT_BIT;
         ssci.module                          = pModule->GetVkShaderModule();
@@ -359,23 +490,28 @@ Result GraphicsPipeline::InitializeDynamicState(
     dynamicStates.push_back(VK_DYNAMIC_STATE_STENCIL_WRITE_MASK);
     dynamicStates.push_back(VK_DYNAMIC_STATE_STENCIL_REFERENCE);
 
-#if defined(PPX_VK_EXTENDED_DYNAMIC_STATE)
-    if (ToApi(GetDevice())->IsExtendedDynamicStateAvailable()) {
-        // Provided by VK_EXT_extended_dynamic_state
+    // Opt-in states from grfx::DynamicState, grfx::GraphicsPipeline::Create()
+    // has checked that the device supports them.
+    const grfx::DynamicState& dynamicState = pCreateInfo->dynamicState;
+#if defined(VK_EXT_extended_dynamic_state)
+    if (dynamicState.cullMode) {
         dynamicStates.push_back(VK_DYNAMIC_STATE_CULL_MODE_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_FRONT_FACE_EXT);
+    }
+    if (dynamicState.primitiveTopology) {
         dynamicStates.push_back(VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT_WITH_COUNT_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR_WITH_COUNT_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE_EXT);
+    }
+    if (dynamicState.depthTestEnable) {
         dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT);
+    }
+    if (dynamicState.depthWriteEnable) {
         dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT);
-        dynamicStates.push_back(VK_DYNAMIC_STATE_STENCIL_OP_EXT);
     }
-#endif // defined(PPX_VK_EXTENDED_DYNAMIC_STATE)
+#endif
+#if defined(VK_EXT_extended_dynamic_state3)
+    if (dynamicState.blendEnable) {
+        dynamicStates.push_back(VK_DYNAMIC_STATE_COLOR_BLEND_ENABLE_EXT);
+    }
+#endif
 
     stateCreateInfo.flags             = 0;
     stateCreateInfo.dynamicStateCount = CountU32(dynamicStates);
@@ -388,8 +524,9 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
 {
     VkGraphicsPipelineCreateInfo vkci = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
 
+    std::vector<vk::SpecializationInfo>          specializations;
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-    Result                                       ppxres = InitializeShaderStages(pCreateInfo, shaderStages, vkci);
+    Result                                       ppxres = InitializeShaderStages(pCreateInfo, specializations, shaderStages, vkci);
 
     std::vector<VkVertexInputAttributeDescription> vertexAttributes;
     std::vector<VkVertexInputBindingDescription>   vertexBindings;
@@ -461,6 +598,26 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
         return ppxres;
     }
 
+    // Fill in pointers nad remaining values
+    //
+    vkci.flags               = ToVkDescriptorBufferPipelineFlags(ToApi(GetDevice()));
+    vkci.stageCount          = CountU32(shaderStages);
+    vkci.pStages             = DataPtr(shaderStages);
+    vkci.pVertexInputState   = IsNull(pCreateInfo->MS.pModule) ? &vertexInputState : nullptr; // Ignored by mesh pipelines
+    vkci.pInputAssemblyState = IsNull(pCreateInfo->MS.pModule) ? &inputAssemblyState : nullptr;
+    vkci.pTessellationState  = &tessellationState;
+    vkci.pViewportState      = &viewportState;
+    vkci.pRasterizationState = &rasterizationState;
+    vkci.pMultisampleState   = &multisampleState;
+    vkci.pDepthStencilState  = &depthStencilState;
+    vkci.pColorBlendState    = &colorBlendState;
+    vkci.pDynamicState       = &dynamicState;
+    vkci.layout              = ToApi(pCreateInfo->pPipelineInterface)->GetVkPipelineLayout();
+    vkci.renderPass          = VK_NULL_HANDLE;
+    vkci.subpass             = 0; // One subpass to rule them all
+    vkci.basePipelineHandle  = VK_NULL_HANDLE;
+    vkci.basePipelineIndex   = -1;
+
     VkRenderPassPtr       renderPass = VK_NULL_HANDLE;
     std::vector<VkFormat> renderTargetFormats;
     for (uint32_t i = 0; i < pCreateInfo->outputState.renderTargetCount; ++i) {
@@ -471,7 +628,13 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
 #if defined(VK_KHR_dynamic_rendering)
     VkPipelineRenderingCreateInfo renderingCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
 
-    if (pCreateInfo->dynamicRenderPass) {
+    // Must match vk::RenderPass::CreateApiObjects() for render passes to
+    // be able to use the pipeline
+    const bool dynamicRendering = pCreateInfo->dynamicRenderPass ||
+                                  (ToApi(GetDevice())->UsesDynamicRenderPasses() &&
+                                   (pCreateInfo->shadingRateMode == grfx::SHADING_RATE_NONE) &&
+                                   (pCreateInfo->multiViewState.viewMask == 0));
+    if (dynamicRendering) {
         renderingCreateInfo.viewMask                = 0;
         renderingCreateInfo.colorAttachmentCount    = CountU32(renderTargetFormats);
         renderingCreateInfo.pColorAttachmentFormats = DataPtr(renderTargetFormats);
@@ -481,6 +644,26 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
         }
 
         vkci.pNext = &renderingCreateInfo;
+
+#if defined(VK_EXT_shader_object)
+        // Shader objects get their render target formats from the render
+        // pass they're drawn in, so they only need the state
+        if (pCreateInfo->shaderObjects &&
+            ToApi(GetDevice())->ShaderObjectsSupported() &&
+            IsNull(pCreateInfo->MS.pModule) &&
+            (pCreateInfo->shadingRateMode == grfx::SHADING_RATE_NONE)) {
+            return CreateShaderObjects(pCreateInfo, vkci);
+        }
+#endif
+
+#if defined(VK_EXT_graphics_pipeline_library)
+        // Mesh and shading rate pipelines are always created whole
+        if (ToApi(GetDevice())->UsesGraphicsPipelineLibraries() &&
+            IsNull(pCreateInfo->MS.pModule) &&
+            (pCreateInfo->shadingRateMode == grfx::SHADING_RATE_NONE)) {
+            return CreateFromLibraries(pCreateInfo, vkci, renderingCreateInfo);
+        }
+#endif
     }
     else
 #endif
@@ -504,25 +687,8 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
         }
     }
 
-    // Fill in pointers nad remaining values
-    //
-    vkci.flags               = 0;
-    vkci.stageCount          = CountU32(shaderStages);
-    vkci.pStages             = DataPtr(shaderStages);
-    vkci.pVertexInputState   = &vertexInputState;
-    vkci.pInputAssemblyState = &inputAssemblyState;
-    vkci.pTessellationState  = &tessellationState;
-    vkci.pViewportState      = &viewportState;
-    vkci.pRasterizationState = &rasterizationState;
-    vkci.pMultisampleState   = &multisampleState;
-    vkci.pDepthStencilState  = &depthStencilState;
-    vkci.pColorBlendState    = &colorBlendState;
-    vkci.pDynamicState       = &dynamicState;
-    vkci.layout              = ToApi(pCreateInfo->pPipelineInterface)->GetVkPipelineLayout();
-    vkci.renderPass          = renderPass;
-    vkci.subpass             = 0; // One subpass to rule them all
-    vkci.basePipelineHandle  = VK_NULL_HANDLE;
-    vkci.basePipelineIndex   = -1;
+    // Transient render pass if the pipeline doesn't use dynamic rendering
+    vkci.renderPass = renderPass;
 
     // [VRS] set pipeline shading rate
     VkPipelineFragmentShadingRateStateCreateInfoKHR shadingRate = {VK_STRUCTURE_TYPE_PIPELINE_FRAGMENT_SHADING_RATE_STATE_CREATE_INFO_KHR};
@@ -535,7 +701,7 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
 
     VkResult vkres = vkCreateGraphicsPipelines(
         ToApi(GetDevice())->GetVkDevice(),
-        VK_NULL_HANDLE,
+        ToApi(GetDevice())->GetVkPipelineCache(),
         1,
         &vkci,
         nullptr,
@@ -556,12 +722,555 @@ Result GraphicsPipeline::CreateApiObjects(const grfx::GraphicsPipelineCreateInfo
     return ppx::SUCCESS;
 }
 
+#if defined(VK_EXT_graphics_pipeline_library)
+Result GraphicsPipeline::CreateFromLibraries(
+    const grfx::GraphicsPipelineCreateInfo* pCreateInfo,
+    const VkGraphicsPipelineCreateInfo&     vkCreateInfo,
+    const VkPipelineRenderingCreateInfo&    renderingCreateInfo)
+{
+    vk::Device* pDevice = ToApi(GetDevice());
+
+    // Split the shader stages between the pre-rasterization and fragment
+    // shader libraries
+    std::vector<VkPipelineShaderStageCreateInfo> preRasterizationStages;
+    std::vector<VkPipelineShaderStageCreateInfo> fragmentStages;
+    for (uint32_t i = 0; i < vkCreateInfo.stageCount; ++i) {
+        if (vkCreateInfo.pStages[i].stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
+            fragmentStages.push_back(vkCreateInfo.pStages[i]);
+        }
+        else {
+            preRasterizationStages.push_back(vkCreateInfo.pStages[i]);
+        }
+    }
+
+    const uint64_t layoutKey = reinterpret_cast<uint64_t>(vkCreateInfo.layout);
+
+    // Libraries keep the link time optimization info so that the final
+    // pipeline can be relinked with it later
+    VkGraphicsPipelineCreateInfo libraryCreateInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    libraryCreateInfo.flags                        = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT | ToVkDescriptorBufferPipelineFlags(pDevice);
+    libraryCreateInfo.pDynamicState                = vkCreateInfo.pDynamicState;
+    libraryCreateInfo.basePipelineHandle           = VK_NULL_HANDLE;
+    libraryCreateInfo.basePipelineIndex            = -1;
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT};
+    libraryInfo.pNext                                  = &renderingCreateInfo;
+
+    // Vertex input
+    {
+        VkGraphicsPipelineCreateInfo vkci = libraryCreateInfo;
+        vkci.pNext                        = &libraryInfo;
+        vkci.pVertexInputState            = vkCreateInfo.pVertexInputState;
+        vkci.pInputAssemblyState          = vkCreateInfo.pInputAssemblyState;
+        libraryInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT;
+
+        const VkPipelineVertexInputStateCreateInfo& vertexInput = *vkCreateInfo.pVertexInputState;
+
+        std::vector<uint64_t> key = {libraryInfo.flags};
+        key.push_back(vertexInput.vertexBindingDescriptionCount);
+        for (uint32_t i = 0; i < vertexInput.vertexBindingDescriptionCount; ++i) {
+            const VkVertexInputBindingDescription& binding = vertexInput.pVertexBindingDescriptions[i];
+            key.push_back(binding.binding);
+            key.push_back(binding.stride);
+            key.push_back(binding.inputRate);
+        }
+        key.push_back(vertexInput.vertexAttributeDescriptionCount);
+        for (uint32_t i = 0; i < vertexInput.vertexAttributeDescriptionCount; ++i) {
+            const VkVertexInputAttributeDescription& attribute = vertexInput.pVertexAttributeDescriptions[i];
+            key.push_back(attribute.location);
+            key.push_back(attribute.binding);
+            key.push_back(attribute.format);
+            key.push_back(attribute.offset);
+        }
+        key.push_back(vkCreateInfo.pInputAssemblyState->topology);
+        key.push_back(vkCreateInfo.pInputAssemblyState->primitiveRestartEnable);
+        AppendDynamicStateKey(*vkCreateInfo.pDynamicState, key);
+
+        VkPipeline library = VK_NULL_HANDLE;
+        Result     ppxres  = pDevice->AcquirePipelineLibrary(key, &vkci, &library);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mLibraries.push_back(library);
+    }
+
+    // Pre-rasterization shaders
+    {
+        VkGraphicsPipelineCreateInfo vkci = libraryCreateInfo;
+        vkci.pNext                        = &libraryInfo;
+        vkci.stageCount                   = CountU32(preRasterizationStages);
+        vkci.pStages                      = DataPtr(preRasterizationStages);
+        vkci.pTessellationState           = vkCreateInfo.pTessellationState;
+        vkci.pViewportState               = vkCreateInfo.pViewportState;
+        vkci.pRasterizationState          = vkCreateInfo.pRasterizationState;
+        vkci.layout                       = vkCreateInfo.layout;
+        libraryInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+
+        const VkPipelineRasterizationStateCreateInfo& raster = *vkCreateInfo.pRasterizationState;
+
+        std::vector<uint64_t> key = {libraryInfo.flags, layoutKey, renderingCreateInfo.viewMask};
+        AppendShaderStageKey(pCreateInfo->VS, VK_SHADER_STAGE_VERTEX_BIT, key);
+        AppendShaderStageKey(pCreateInfo->HS, VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT, key);
+        AppendShaderStageKey(pCreateInfo->DS, VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT, key);
+        AppendShaderStageKey(pCreateInfo->GS, VK_SHADER_STAGE_GEOMETRY_BIT, key);
+        key.push_back(pCreateInfo->tessellationState.patchControlPoints);
+        key.push_back(pCreateInfo->tessellationState.domainOrigin);
+        key.push_back(raster.depthClampEnable);
+        key.push_back(raster.rasterizerDiscardEnable);
+        key.push_back(raster.polygonMode);
+        key.push_back(raster.cullMode);
+        key.push_back(raster.frontFace);
+        key.push_back(raster.depthBiasEnable);
+        key.push_back(FloatKey(raster.depthBiasConstantFactor));
+        key.push_back(FloatKey(raster.depthBiasClamp));
+        key.push_back(FloatKey(raster.depthBiasSlopeFactor));
+        key.push_back(pDevice->HasDepthClipEnabled() ? pCreateInfo->rasterState.depthClipEnable : 2);
+        AppendDynamicStateKey(*vkCreateInfo.pDynamicState, key);
+
+        VkPipeline library = VK_NULL_HANDLE;
+        Result     ppxres  = pDevice->AcquirePipelineLibrary(key, &vkci, &library);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mLibraries.push_back(library);
+    }
+
+    // Fragment shader
+    {
+        VkGraphicsPipelineCreateInfo vkci = libraryCreateInfo;
+        vkci.pNext                        = &libraryInfo;
+        vkci.stageCount                   = CountU32(fragmentStages);
+        vkci.pStages                      = DataPtr(fragmentStages);
+        vkci.pMultisampleState            = vkCreateInfo.pMultisampleState;
+        vkci.pDepthStencilState           = vkCreateInfo.pDepthStencilState;
+        vkci.layout                       = vkCreateInfo.layout;
+        libraryInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT;
+
+        const VkPipelineDepthStencilStateCreateInfo& depthStencil = *vkCreateInfo.pDepthStencilState;
+
+        std::vector<uint64_t> key = {libraryInfo.flags, layoutKey, renderingCreateInfo.viewMask};
+        AppendShaderStageKey(pCreateInfo->PS, VK_SHADER_STAGE_FRAGMENT_BIT, key);
+        AppendMultisampleKey(*vkCreateInfo.pMultisampleState, key);
+        key.push_back(depthStencil.depthTestEnable);
+        key.push_back(depthStencil.depthWriteEnable);
+        key.push_back(depthStencil.depthCompareOp);
+        key.push_back(depthStencil.depthBoundsTestEnable);
+        key.push_back(depthStencil.stencilTestEnable);
+        AppendStencilOpKey(depthStencil.front, key);
+        AppendStencilOpKey(depthStencil.back, key);
+        key.push_back(FloatKey(depthStencil.minDepthBounds));
+        key.push_back(FloatKey(depthStencil.maxDepthBounds));
+        AppendDynamicStateKey(*vkCreateInfo.pDynamicState, key);
+
+        VkPipeline library = VK_NULL_HANDLE;
+        Result     ppxres  = pDevice->AcquirePipelineLibrary(key, &vkci, &library);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mLibraries.push_back(library);
+    }
+
+    // Fragment output
+    {
+        VkGraphicsPipelineCreateInfo vkci = libraryCreateInfo;
+        vkci.pNext                        = &libraryInfo;
+        vkci.pMultisampleState            = vkCreateInfo.pMultisampleState;
+        vkci.pColorBlendState             = vkCreateInfo.pColorBlendState;
+        libraryInfo.flags                 = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT;
+
+        const VkPipelineColorBlendStateCreateInfo& colorBlend = *vkCreateInfo.pColorBlendState;
+
+        std::vector<uint64_t> key = {libraryInfo.flags};
+        key.push_back(renderingCreateInfo.colorAttachmentCount);
+        for (uint32_t i = 0; i < renderingCreateInfo.colorAttachmentCount; ++i) {
+            key.push_back(renderingCreateInfo.pColorAttachmentFormats[i]);
+        }
+        key.push_back(renderingCreateInfo.depthAttachmentFormat);
+        key.push_back(renderingCreateInfo.stencilAttachmentFormat);
+        AppendMultisampleKey(*vkCreateInfo.pMultisampleState, key);
+        key.push_back(colorBlend.logicOpEnable);
+        key.push_back(colorBlend.logicOp);
+        key.push_back(colorBlend.attachmentCount);
+        for (uint32_t i = 0; i < colorBlend.attachmentCount; ++i) {
+            const VkPipelineColorBlendAttachmentState& attachment = colorBlend.pAttachments[i];
+            key.push_back(attachment.blendEnable);
+            key.push_back(attachment.srcColorBlendFactor);
+            key.push_back(attachment.dstColorBlendFactor);
+            key.push_back(attachment.colorBlendOp);
+            key.push_back(attachment.srcAlphaBlendFactor);
+            key.push_back(attachment.dstAlphaBlendFactor);
+            key.push_back(attachment.alphaBlendOp);
+            key.push_back(attachment.colorWriteMask);
+        }
+        for (uint32_t i = 0; i < 4; ++i) {
+            key.push_back(FloatKey(colorBlend.blendConstants[i]));
+        }
+        AppendDynamicStateKey(*vkCreateInfo.pDynamicState, key);
+
+        VkPipeline library = VK_NULL_HANDLE;
+        Result     ppxres  = pDevice->AcquirePipelineLibrary(key, &vkci, &library);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mLibraries.push_back(library);
+    }
+
+    // Fast link without optimization so the pipeline is usable right away
+    VkPipelineLibraryCreateInfoKHR linkInfo = {VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR};
+    linkInfo.libraryCount                   = CountU32(mLibraries);
+    linkInfo.pLibraries                     = DataPtr(mLibraries);
+
+    VkGraphicsPipelineCreateInfo linkCreateInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    linkCreateInfo.pNext                        = &linkInfo;
+    linkCreateInfo.flags                        = ToVkDescriptorBufferPipelineFlags(pDevice);
+    linkCreateInfo.layout                       = vkCreateInfo.layout;
+    linkCreateInfo.basePipelineHandle           = VK_NULL_HANDLE;
+    linkCreateInfo.basePipelineIndex            = -1;
+
+    VkResult vkres = vkCreateGraphicsPipelines(
+        pDevice->GetVkDevice(),
+        pDevice->GetVkPipelineCache(),
+        1,
+        &linkCreateInfo,
+        nullptr,
+        &mPipeline);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateGraphicsPipelines(link) failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    // Relink with link time optimization in the background, the task only
+    // holds on to handles that outlive it since DestroyApiObjects() waits
+    // for it
+    auto link      = std::make_shared<OptimizedLink>();
+    mOptimizedLink = link;
+
+    VkDevice                device    = pDevice->GetVkDevice();
+    VkPipelineCache         cache     = pDevice->GetVkPipelineCache();
+    VkPipelineLayout        layout    = vkCreateInfo.layout;
+    VkPipelineCreateFlags   flags     = ToVkDescriptorBufferPipelineFlags(pDevice);
+    std::vector<VkPipeline> libraries = mLibraries;
+    GetDevice()->EnqueuePipelineCompileTask([link, device, cache, layout, flags, libraries]() {
+        {
+            std::lock_guard<std::mutex> lock(link->mutex);
+            if (link->cancelled) {
+                return;
+            }
+            link->running = true;
+        }
+
+        VkPipelineLibraryCreateInfoKHR linkInfo = {VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR};
+        linkInfo.libraryCount                   = CountU32(libraries);
+        linkInfo.pLibraries                     = DataPtr(libraries);
+
+        VkGraphicsPipelineCreateInfo linkCreateInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+        linkCreateInfo.pNext                        = &linkInfo;
+        linkCreateInfo.flags                        = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT | flags;
+        linkCreateInfo.layout                       = layout;
+        linkCreateInfo.basePipelineHandle           = VK_NULL_HANDLE;
+        linkCreateInfo.basePipelineIndex            = -1;
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult   vkres    = vkCreateGraphicsPipelines(device, cache, 1, &linkCreateInfo, nullptr, &pipeline);
+        if (vkres != VK_SUCCESS) {
+            // Not fatal, the fast linked pipeline keeps being used
+            PPX_LOG_WARN("vkCreateGraphicsPipelines(link time optimization) failed: " << ToString(vkres));
+            pipeline = VK_NULL_HANDLE;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(link->mutex);
+            link->pipeline.store(pipeline);
+            link->running = false;
+        }
+        link->doneCondition.notify_all();
+    });
+
+    return ppx::SUCCESS;
+}
+#endif
+
+#if defined(VK_EXT_shader_object)
+Result GraphicsPipeline::CreateShaderObjects(
+    const grfx::GraphicsPipelineCreateInfo* pCreateInfo,
+    const VkGraphicsPipelineCreateInfo&     vkCreateInfo)
+{
+    vk::Device*                  pDevice    = ToApi(GetDevice());
+    const vk::PipelineInterface* pInterface = ToApi(pCreateInfo->pPipelineInterface);
+
+    // Stages are in pipeline order, so each stage's next stage is the one
+    // after it and all of them are linked together
+    std::vector<VkShaderCreateInfoEXT> shaderCreateInfos;
+    for (uint32_t i = 0; i < vkCreateInfo.stageCount; ++i) {
+        const VkPipelineShaderStageCreateInfo& stage = vkCreateInfo.pStages[i];
+
+        const grfx::ShaderModule* pModule = nullptr;
+        switch (stage.stage) {
+            default: break;
+            case VK_SHADER_STAGE_VERTEX_BIT: pModule = pCreateInfo->VS.pModule; break;
+            case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT: pModule = pCreateInfo->HS.pModule; break;
+            case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT: pModule = pCreateInfo->DS.pModule; break;
+            case VK_SHADER_STAGE_GEOMETRY_BIT: pModule = pCreateInfo->GS.pModule; break;
+            case VK_SHADER_STAGE_FRAGMENT_BIT: pModule = pCreateInfo->PS.pModule; break;
+        }
+        PPX_ASSERT_MSG(!IsNull(pModule), "unexpected shader stage for shader objects");
+
+        const std::vector<char>& code = ToApi(pModule)->GetCode();
+        PPX_ASSERT_MSG(!code.empty(), "shader module has no code for shader objects");
+
+        VkShaderCreateInfoEXT shaderCreateInfo  = {VK_STRUCTURE_TYPE_SHADER_CREATE_INFO_EXT};
+        shaderCreateInfo.flags                  = (vkCreateInfo.stageCount > 1) ? VK_SHADER_CREATE_LINK_STAGE_BIT_EXT : 0;
+        shaderCreateInfo.stage                  = stage.stage;
+        shaderCreateInfo.nextStage              = ((i + 1) < vkCreateInfo.stageCount) ? vkCreateInfo.pStages[i + 1].stage : 0;
+        shaderCreateInfo.codeType               = VK_SHADER_CODE_TYPE_SPIRV_EXT;
+        shaderCreateInfo.codeSize               = code.size();
+        shaderCreateInfo.pCode                  = DataPtr(code);
+        shaderCreateInfo.pName                  = stage.pName;
+        shaderCreateInfo.setLayoutCount         = CountU32(pInterface->GetVkDescriptorSetLayouts());
+        shaderCreateInfo.pSetLayouts            = DataPtr(pInterface->GetVkDescriptorSetLayouts());
+        shaderCreateInfo.pushConstantRangeCount = CountU32(pInterface->GetVkPushConstantRanges());
+        shaderCreateInfo.pPushConstantRanges    = DataPtr(pInterface->GetVkPushConstantRanges());
+        shaderCreateInfo.pSpecializationInfo    = stage.pSpecializationInfo;
+        shaderCreateInfos.push_back(shaderCreateInfo);
+    }
+
+    std::vector<VkShaderEXT> shaders(shaderCreateInfos.size(), VK_NULL_HANDLE);
+    if (!shaderCreateInfos.empty()) {
+        VkResult vkres = CreateShadersEXT(
+            pDevice->GetVkDevice(),
+            CountU32(shaderCreateInfos),
+            DataPtr(shaderCreateInfos),
+            nullptr,
+            DataPtr(shaders));
+        if (vkres != VK_SUCCESS) {
+            PPX_ASSERT_MSG(false, "vkCreateShadersEXT failed: " << ToString(vkres));
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    // Every graphics stage the device has features for must be bound, the
+    // ones the pipeline doesn't use are bound to VK_NULL_HANDLE
+    ShaderObjectState& state = mShaderObjectState;
+
+    state.stages.push_back(VK_SHADER_STAGE_VERTEX_BIT);
+    if (pDevice->TessellationShaderSupported()) {
+        state.stages.push_back(VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT);
+        state.stages.push_back(VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT);
+    }
+    if (pDevice->GeometryShaderSupported()) {
+        state.stages.push_back(VK_SHADER_STAGE_GEOMETRY_BIT);
+    }
+    state.stages.push_back(VK_SHADER_STAGE_FRAGMENT_BIT);
+#if defined(VK_EXT_mesh_shader)
+    if (pDevice->AmplificationShaderSupported()) {
+        state.stages.push_back(VK_SHADER_STAGE_TASK_BIT_EXT);
+    }
+    if (pDevice->MeshShaderSupported()) {
+        state.stages.push_back(VK_SHADER_STAGE_MESH_BIT_EXT);
+    }
+#endif
+    state.shaders.resize(state.stages.size(), VK_NULL_HANDLE);
+    for (size_t i = 0; i < shaderCreateInfos.size(); ++i) {
+        auto it = std::find(state.stages.begin(), state.stages.end(), shaderCreateInfos[i].stage);
+        PPX_ASSERT_MSG(it != state.stages.end(), "shader stage is not supported by the device");
+        state.shaders[std::distance(state.stages.begin(), it)] = shaders[i];
+        mShaders.push_back(shaders[i]);
+    }
+
+    // Vertex input
+    const VkPipelineVertexInputStateCreateInfo& vertexInput = *vkCreateInfo.pVertexInputState;
+    for (uint32_t i = 0; i < vertexInput.vertexBindingDescriptionCount; ++i) {
+        const VkVertexInputBindingDescription& binding = vertexInput.pVertexBindingDescriptions[i];
+
+        VkVertexInputBindingDescription2EXT binding2 = {VK_STRUCTURE_TYPE_VERTEX_INPUT_BINDING_DESCRIPTION_2_EXT};
+        binding2.binding                             = binding.binding;
+        binding2.stride                              = binding.stride;
+        binding2.inputRate                           = binding.inputRate;
+        binding2.divisor                             = 1;
+        state.vertexBindings.push_back(binding2);
+    }
+    for (uint32_t i = 0; i < vertexInput.vertexAttributeDescriptionCount; ++i) {
+        const VkVertexInputAttributeDescription& attribute = vertexInput.pVertexAttributeDescriptions[i];
+
+        VkVertexInputAttributeDescription2EXT attribute2 = {VK_STRUCTURE_TYPE_VERTEX_INPUT_ATTRIBUTE_DESCRIPTION_2_EXT};
+        attribute2.location                              = attribute.location;
+        attribute2.binding                               = attribute.binding;
+        attribute2.format                                = attribute.format;
+        attribute2.offset                                = attribute.offset;
+        state.vertexAttributes.push_back(attribute2);
+    }
+
+    // Fixed function state, only the values are used
+    state.inputAssembly           = *vkCreateInfo.pInputAssemblyState;
+    state.patchControlPoints      = pCreateInfo->tessellationState.patchControlPoints;
+    state.domainOrigin            = ToVkTessellationDomainOrigin(pCreateInfo->tessellationState.domainOrigin);
+    state.rasterization           = *vkCreateInfo.pRasterizationState;
+    state.depthClipEnable         = pCreateInfo->rasterState.depthClipEnable ? VK_TRUE : VK_FALSE;
+    state.multisample             = *vkCreateInfo.pMultisampleState;
+    state.depthStencil            = *vkCreateInfo.pDepthStencilState;
+    state.logicOpEnable           = vkCreateInfo.pColorBlendState->logicOpEnable;
+    state.logicOp                 = vkCreateInfo.pColorBlendState->logicOp;
+    state.blendConstants[0]       = vkCreateInfo.pColorBlendState->blendConstants[0];
+    state.blendConstants[1]       = vkCreateInfo.pColorBlendState->blendConstants[1];
+    state.blendConstants[2]       = vkCreateInfo.pColorBlendState->blendConstants[2];
+    state.blendConstants[3]       = vkCreateInfo.pColorBlendState->blendConstants[3];
+    state.inputAssembly.pNext     = nullptr;
+    state.rasterization.pNext     = nullptr;
+    state.multisample.pNext       = nullptr;
+    state.multisample.pSampleMask = nullptr;
+    state.depthStencil.pNext      = nullptr;
+
+    for (uint32_t i = 0; i < vkCreateInfo.pColorBlendState->attachmentCount; ++i) {
+        const VkPipelineColorBlendAttachmentState& attachment = vkCreateInfo.pColorBlendState->pAttachments[i];
+
+        VkColorBlendEquationEXT equation = {};
+        equation.srcColorBlendFactor     = attachment.srcColorBlendFactor;
+        equation.dstColorBlendFactor     = attachment.dstColorBlendFactor;
+        equation.colorBlendOp            = attachment.colorBlendOp;
+        equation.srcAlphaBlendFactor     = attachment.srcAlphaBlendFactor;
+        equation.dstAlphaBlendFactor     = attachment.dstAlphaBlendFactor;
+        equation.alphaBlendOp            = attachment.alphaBlendOp;
+
+        state.blendEnables.push_back(attachment.blendEnable);
+        state.blendEquations.push_back(equation);
+        state.colorWriteMasks.push_back(attachment.colorWriteMask);
+    }
+
+    mUsesShaderObjects = true;
+
+    return ppx::SUCCESS;
+}
+#endif
+
+void GraphicsPipeline::CmdBindShaderObjects(VkCommandBuffer commandBuffer) const
+{
+#if defined(VK_EXT_shader_object)
+    PPX_ASSERT_MSG(mUsesShaderObjects, "pipeline was not created with shader objects");
+
+    const ShaderObjectState&        state    = mShaderObjectState;
+    const VkPhysicalDeviceFeatures& features = ToApi(GetDevice())->GetDeviceFeatures();
+
+    CmdBindShadersEXT(commandBuffer, CountU32(state.stages), DataPtr(state.stages), DataPtr(state.shaders));
+
+    // Vertex input and input assembly
+    CmdSetVertexInputEXT(
+        commandBuffer,
+        CountU32(state.vertexBindings),
+        DataPtr(state.vertexBindings),
+        CountU32(state.vertexAttributes),
+        DataPtr(state.vertexAttributes));
+    CmdSetPrimitiveTopologyEXT(commandBuffer, state.inputAssembly.topology);
+    CmdSetPrimitiveRestartEnableEXT(commandBuffer, state.inputAssembly.primitiveRestartEnable);
+    if (state.patchControlPoints > 0) {
+        CmdSetPatchControlPointsEXT(commandBuffer, state.patchControlPoints);
+        CmdSetTessellationDomainOriginEXT(commandBuffer, state.domainOrigin);
+    }
+
+    // Rasterization
+    const VkPipelineRasterizationStateCreateInfo& raster = state.rasterization;
+    CmdSetRasterizerDiscardEnableEXT(commandBuffer, raster.rasterizerDiscardEnable);
+    CmdSetPolygonModeEXT(commandBuffer, raster.polygonMode);
+    CmdSetCullModeEXT(commandBuffer, raster.cullMode);
+    CmdSetFrontFaceEXT(commandBuffer, raster.frontFace);
+    CmdSetDepthBiasEnableEXT(commandBuffer, raster.depthBiasEnable);
+    vkCmdSetDepthBias(commandBuffer, raster.depthBiasConstantFactor, raster.depthBiasClamp, raster.depthBiasSlopeFactor);
+    vkCmdSetLineWidth(commandBuffer, raster.lineWidth);
+    if (features.depthClamp == VK_TRUE) {
+        CmdSetDepthClampEnableEXT(commandBuffer, raster.depthClampEnable);
+    }
+    if (ToApi(GetDevice())->HasDepthClipEnabled()) {
+        CmdSetDepthClipEnableEXT(commandBuffer, state.depthClipEnable);
+    }
+
+    // Multisample
+    const VkSampleMask sampleMask = ~0u;
+    CmdSetRasterizationSamplesEXT(commandBuffer, state.multisample.rasterizationSamples);
+    CmdSetSampleMaskEXT(commandBuffer, state.multisample.rasterizationSamples, &sampleMask);
+    CmdSetAlphaToCoverageEnableEXT(commandBuffer, state.multisample.alphaToCoverageEnable);
+    if (features.alphaToOne == VK_TRUE) {
+        CmdSetAlphaToOneEnableEXT(commandBuffer, state.multisample.alphaToOneEnable);
+    }
+
+    // Depth stencil
+    const VkPipelineDepthStencilStateCreateInfo& depthStencil = state.depthStencil;
+    CmdSetDepthTestEnableEXT(commandBuffer, depthStencil.depthTestEnable);
+    CmdSetDepthWriteEnableEXT(commandBuffer, depthStencil.depthWriteEnable);
+    CmdSetDepthCompareOpEXT(commandBuffer, depthStencil.depthCompareOp);
+    if (features.depthBounds == VK_TRUE) {
+        CmdSetDepthBoundsTestEnableEXT(commandBuffer, depthStencil.depthBoundsTestEnable);
+        vkCmdSetDepthBounds(commandBuffer, depthStencil.minDepthBounds, depthStencil.maxDepthBounds);
+    }
+    CmdSetStencilTestEnableEXT(commandBuffer, depthStencil.stencilTestEnable);
+    CmdSetStencilOpEXT(commandBuffer, VK_STENCIL_FACE_FRONT_BIT, depthStencil.front.failOp, depthStencil.front.passOp, depthStencil.front.depthFailOp, depthStencil.front.compareOp);
+    CmdSetStencilOpEXT(commandBuffer, VK_STENCIL_FACE_BACK_BIT, depthStencil.back.failOp, depthStencil.back.passOp, depthStencil.back.depthFailOp, depthStencil.back.compareOp);
+    vkCmdSetStencilCompareMask(commandBuffer, VK_STENCIL_FACE_FRONT_BIT, depthStencil.front.compareMask);
+    vkCmdSetStencilCompareMask(commandBuffer, VK_STENCIL_FACE_BACK_BIT, depthStencil.back.compareMask);
+    vkCmdSetStencilWriteMask(commandBuffer, VK_STENCIL_FACE_FRONT_BIT, depthStencil.front.writeMask);
+    vkCmdSetStencilWriteMask(commandBuffer, VK_STENCIL_FACE_BACK_BIT, depthStencil.back.writeMask);
+    vkCmdSetStencilReference(commandBuffer, VK_STENCIL_FACE_FRONT_BIT, depthStencil.front.reference);
+    vkCmdSetStencilReference(commandBuffer, VK_STENCIL_FACE_BACK_BIT, depthStencil.back.reference);
+
+    // Color blend
+    if (features.logicOp == VK_TRUE) {
+        CmdSetLogicOpEnableEXT(commandBuffer, state.logicOpEnable);
+        CmdSetLogicOpEXT(commandBuffer, state.logicOp);
+    }
+    if (!state.blendEnables.empty()) {
+        CmdSetColorBlendEnableEXT(commandBuffer, 0, CountU32(state.blendEnables), DataPtr(state.blendEnables));
+        CmdSetColorBlendEquationEXT(commandBuffer, 0, CountU32(state.blendEquations), DataPtr(state.blendEquations));
+        CmdSetColorWriteMaskEXT(commandBuffer, 0, CountU32(state.colorWriteMasks), DataPtr(state.colorWriteMasks));
+    }
+    vkCmdSetBlendConstants(commandBuffer, state.blendConstants);
+#else
+    PPX_ASSERT_MSG(false, "shader objects are not supported");
+#endif
+}
+
+VkPipelinePtr GraphicsPipeline::GetVkPipeline() const
+{
+    if (mOptimizedLink) {
+        VkPipeline optimized = mOptimizedLink->pipeline.load();
+        if (optimized != VK_NULL_HANDLE) {
+            return optimized;
+        }
+    }
+    return mPipeline;
+}
+
 void GraphicsPipeline::DestroyApiObjects()
 {
+    vk::Device* pDevice = ToApi(GetDevice());
+
+    if (mOptimizedLink) {
+        std::unique_lock<std::mutex> lock(mOptimizedLink->mutex);
+        mOptimizedLink->cancelled = true;
+        mOptimizedLink->doneCondition.wait(lock, [this] { return !mOptimizedLink->running; });
+
+        VkPipeline optimized = mOptimizedLink->pipeline.exchange(VK_NULL_HANDLE);
+        if (optimized != VK_NULL_HANDLE) {
+            vkDestroyPipeline(pDevice->GetVkDevice(), optimized, nullptr);
+        }
+    }
+    mOptimizedLink.reset();
+
     if (mPipeline) {
-        vkDestroyPipeline(ToApi(GetDevice())->GetVkDevice(), mPipeline, nullptr);
+        vkDestroyPipeline(pDevice->GetVkDevice(), mPipeline, nullptr);
         mPipeline.Reset();
     }
+
+    for (VkPipeline library : mLibraries) {
+        pDevice->ReleasePipelineLibrary(library);
+    }
+    mLibraries.clear();
+
+#if defined(VK_EXT_shader_object)
+    for (VkShaderEXT shader : mShaders) {
+        DestroyShaderEXT(pDevice->GetVkDevice(), shader, nullptr);
+    }
+    mShaders.clear();
+    mShaderObjectState = {};
+#endif
+    mUsesShaderObjects = false;
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -587,7 +1296,7 @@ Result PipelineInterface::CreateApiObjects(const grfx::PipelineInterfaceCreateIn
         }
 
         // Save stage flags for use in command buffer
-        mPushConstantShaderStageFlags = ToVkShaderStageFlags(pCreateInfo->pushConstants.shaderVisiblity);
+        mPushConstantShaderStageFlags = ToVkShaderStageFlags(pCreateInfo->pushConstants.shaderVisiblity) & ToApi(GetDevice())->GetSupportedShaderStageFlags();
 
         // Fill out range
         pushConstantsRange.stageFlags = mPushConstantShaderStageFlags;
@@ -595,12 +1304,17 @@ Result PipelineInterface::CreateApiObjects(const grfx::PipelineInterfaceCreateIn
         pushConstantsRange.size       = sizeInBytes;
     }
 
+    mSetLayouts.assign(setLayouts, setLayouts + pCreateInfo->setCount);
+    if (hasPushConstants) {
+        mPushConstantRanges.push_back(pushConstantsRange);
+    }
+
     VkPipelineLayoutCreateInfo vkci = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
     vkci.flags                      = 0;
-    vkci.setLayoutCount             = pCreateInfo->setCount;
-    vkci.pSetLayouts                = setLayouts;
-    vkci.pushConstantRangeCount     = hasPushConstants ? 1 : 0;
-    vkci.pPushConstantRanges        = hasPushConstants ? &pushConstantsRange : nullptr;
+    vkci.setLayoutCount             = CountU32(mSetLayouts);
+    vkci.pSetLayouts                = DataPtr(mSetLayouts);
+    vkci.pushConstantRangeCount     = CountU32(mPushConstantRanges);
+    vkci.pPushConstantRanges        = DataPtr(mPushConstantRanges);
 
     VkResult vkres = vkCreatePipelineLayout(
         ToApi(GetDevice())->GetVkDevice(),
@@ -621,6 +1335,8 @@ void PipelineInterface::DestroyApiObjects()
         vkDestroyPipelineLayout(ToApi(GetDevice())->GetVkDevice(), mPipelineLayout, nullptr);
         mPipelineLayout.Reset();
     }
+    mSetLayouts.clear();
+    mPushConstantRanges.clear();
 }
 
 } // namespace vk
@@ -33,6 +33,9 @@ uint32_t Query::GetQueryTypeSize(VkQueryType type, uint32_t multiplier) const
     switch (type) {
         case VK_QUERY_TYPE_OCCLUSION:
         case VK_QUERY_TYPE_TIMESTAMP:
+#if defined(VK_KHR_acceleration_structure)
+        case VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR:
+#endif
             // this need VK_QUERY_RESULT_64_BIT to be set
             result = (uint32_t)sizeof(uint64_t);
             break;
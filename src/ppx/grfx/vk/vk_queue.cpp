@@ -16,6 +16,7 @@
 #include "ppx/grfx/vk/vk_command.h"
 #include "ppx/grfx/vk/vk_device.h"
 #include "ppx/grfx/vk/vk_gpu.h"
+#include "ppx/grfx/vk/vk_image.h"
 #include "ppx/grfx/vk/vk_swapchain.h"
 #include "ppx/grfx/vk/vk_sync.h"
 
@@ -80,67 +81,174 @@ Result Queue::WaitIdle()
     return ppx::SUCCESS;
 }
 
-Result Queue::Submit(const grfx::SubmitInfo* pSubmitInfo)
+// Calls submitFn(first, count, fence) for each run of submits that ends in
+// a submit with a fence or in the last submit. A fence passed to
+// vkQueueSubmit signals once all of that call's submits have completed, so
+// a run can't extend past the submit the fence belongs to.
+template <typename SubmitFn>
+static Result SubmitRuns(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos, SubmitFn submitFn)
 {
-    // Command buffers
-    std::vector<VkCommandBuffer> commandBuffers;
-    for (uint32_t i = 0; i < pSubmitInfo->commandBufferCount; ++i) {
-        commandBuffers.push_back(ToApi(pSubmitInfo->ppCommandBuffers[i])->GetVkCommandBuffer());
+    uint32_t first = 0;
+    for (uint32_t i = 0; i < submitCount; ++i) {
+        const bool last = ((i + 1) == submitCount);
+        if (IsNull(pSubmitInfos[i].pFence) && !last) {
+            continue;
+        }
+
+        VkFence fence = VK_NULL_HANDLE;
+        if (!IsNull(pSubmitInfos[i].pFence)) {
+            fence = ToApi(pSubmitInfos[i].pFence)->GetVkFence();
+        }
+
+        VkResult vkres = submitFn(first, i - first + 1, fence);
+        if (vkres != VK_SUCCESS) {
+            return ppx::ERROR_API_FAILURE;
+        }
+        first = i + 1;
     }
+    return ppx::SUCCESS;
+}
 
-    // Wait semaphores
-    std::vector<VkSemaphore>          waitSemaphores;
-    std::vector<VkPipelineStageFlags> waitDstStageMasks;
-    for (uint32_t i = 0; i < pSubmitInfo->waitSemaphoreCount; ++i) {
-        waitSemaphores.push_back(ToApi(pSubmitInfo->ppWaitSemaphores[i])->GetVkSemaphore());
-        waitDstStageMasks.push_back(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+Result Queue::Submit(const grfx::SubmitInfo* pSubmitInfo)
+{
+    return SubmitBatch(1, pSubmitInfo);
+}
+
+Result Queue::SubmitBatch(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos)
+{
+    if (submitCount == 0) {
+        return ppx::SUCCESS;
     }
 
-    // Signal semaphores
-    std::vector<VkSemaphore> signalSemaphores;
-    for (uint32_t i = 0; i < pSubmitInfo->signalSemaphoreCount; ++i) {
-        signalSemaphores.push_back(ToApi(pSubmitInfo->ppSignalSemaphores[i])->GetVkSemaphore());
+#if defined(VK_KHR_synchronization2)
+    if (ToApi(GetDevice())->HasSynchronization2()) {
+        return SubmitBatch2(submitCount, pSubmitInfos);
     }
+#endif
+
+    // Sized up front so the pointers in the submit infos stay valid
+    std::vector<std::vector<VkCommandBuffer>>      commandBuffers(submitCount);
+    std::vector<std::vector<VkSemaphore>>          waitSemaphores(submitCount);
+    std::vector<std::vector<VkPipelineStageFlags>> waitDstStageMasks(submitCount);
+    std::vector<std::vector<VkSemaphore>>          signalSemaphores(submitCount);
+    std::vector<VkTimelineSemaphoreSubmitInfo>     timelineSubmitInfos(submitCount);
+    std::vector<VkSubmitInfo>                      vksis(submitCount);
+
+    for (uint32_t n = 0; n < submitCount; ++n) {
+        const grfx::SubmitInfo* pSubmitInfo = &pSubmitInfos[n];
+
+        // Command buffers
+        for (uint32_t i = 0; i < pSubmitInfo->commandBufferCount; ++i) {
+            commandBuffers[n].push_back(ToApi(pSubmitInfo->ppCommandBuffers[i])->GetVkCommandBuffer());
+        }
 
-    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
-    timelineSubmitInfo.pNext                         = nullptr;
-    timelineSubmitInfo.waitSemaphoreValueCount       = CountU32(pSubmitInfo->waitValues);
-    timelineSubmitInfo.pWaitSemaphoreValues          = DataPtr(pSubmitInfo->waitValues);
-    timelineSubmitInfo.signalSemaphoreValueCount     = CountU32(pSubmitInfo->signalValues);
-    timelineSubmitInfo.pSignalSemaphoreValues        = DataPtr(pSubmitInfo->signalValues);
+        // Wait semaphores
+        for (uint32_t i = 0; i < pSubmitInfo->waitSemaphoreCount; ++i) {
+            waitSemaphores[n].push_back(ToApi(pSubmitInfo->ppWaitSemaphores[i])->GetVkSemaphore());
+            waitDstStageMasks[n].push_back(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT);
+        }
 
-    VkSubmitInfo vksi         = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
-    vksi.pNext                = &timelineSubmitInfo;
-    vksi.waitSemaphoreCount   = CountU32(waitSemaphores);
-    vksi.pWaitSemaphores      = DataPtr(waitSemaphores);
-    vksi.pWaitDstStageMask    = DataPtr(waitDstStageMasks);
-    vksi.commandBufferCount   = CountU32(commandBuffers);
-    vksi.pCommandBuffers      = DataPtr(commandBuffers);
-    vksi.signalSemaphoreCount = CountU32(signalSemaphores);
-    vksi.pSignalSemaphores    = DataPtr(signalSemaphores);
+        // Signal semaphores
+        for (uint32_t i = 0; i < pSubmitInfo->signalSemaphoreCount; ++i) {
+            signalSemaphores[n].push_back(ToApi(pSubmitInfo->ppSignalSemaphores[i])->GetVkSemaphore());
+        }
 
-    // Fence
-    VkFence fence = VK_NULL_HANDLE;
-    if (!IsNull(pSubmitInfo->pFence)) {
-        fence = ToApi(pSubmitInfo->pFence)->GetVkFence();
+        VkTimelineSemaphoreSubmitInfo& timelineSubmitInfo = timelineSubmitInfos[n];
+        timelineSubmitInfo                                = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+        timelineSubmitInfo.pNext                          = nullptr;
+        timelineSubmitInfo.waitSemaphoreValueCount        = CountU32(pSubmitInfo->waitValues);
+        timelineSubmitInfo.pWaitSemaphoreValues           = DataPtr(pSubmitInfo->waitValues);
+        timelineSubmitInfo.signalSemaphoreValueCount      = CountU32(pSubmitInfo->signalValues);
+        timelineSubmitInfo.pSignalSemaphoreValues         = DataPtr(pSubmitInfo->signalValues);
+
+        VkSubmitInfo& vksi        = vksis[n];
+        vksi                      = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        vksi.pNext                = &timelineSubmitInfo;
+        vksi.waitSemaphoreCount   = CountU32(waitSemaphores[n]);
+        vksi.pWaitSemaphores      = DataPtr(waitSemaphores[n]);
+        vksi.pWaitDstStageMask    = DataPtr(waitDstStageMasks[n]);
+        vksi.commandBufferCount   = CountU32(commandBuffers[n]);
+        vksi.pCommandBuffers      = DataPtr(commandBuffers[n]);
+        vksi.signalSemaphoreCount = CountU32(signalSemaphores[n]);
+        vksi.pSignalSemaphores    = DataPtr(signalSemaphores[n]);
     }
 
     // Synchronized queue access
-    {
-        std::lock_guard<std::mutex> lock(mQueueMutex);
+    std::lock_guard<std::mutex> lock(mQueueMutex);
 
-        VkResult vkres = vk::QueueSubmit(
-            mQueue,
-            1,
-            &vksi,
-            fence);
-        if (vkres != VK_SUCCESS) {
-            return ppx::ERROR_API_FAILURE;
+    return SubmitRuns(
+        submitCount,
+        pSubmitInfos,
+        [this, &vksis](uint32_t first, uint32_t count, VkFence fence) {
+            return vk::QueueSubmit(mQueue, count, &vksis[first], fence);
+        });
+}
+
+#if defined(VK_KHR_synchronization2)
+Result Queue::SubmitBatch2(uint32_t submitCount, const grfx::SubmitInfo* pSubmitInfos)
+{
+    // Sized up front so the pointers in the submit infos stay valid
+    std::vector<std::vector<VkCommandBufferSubmitInfoKHR>> commandBuffers(submitCount);
+    std::vector<std::vector<VkSemaphoreSubmitInfoKHR>>     waitSemaphores(submitCount);
+    std::vector<std::vector<VkSemaphoreSubmitInfoKHR>>     signalSemaphores(submitCount);
+    std::vector<VkSubmitInfo2KHR>                          vksis(submitCount);
+
+    for (uint32_t n = 0; n < submitCount; ++n) {
+        const grfx::SubmitInfo* pSubmitInfo = &pSubmitInfos[n];
+
+        // Command buffers
+        for (uint32_t i = 0; i < pSubmitInfo->commandBufferCount; ++i) {
+            VkCommandBufferSubmitInfoKHR info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR};
+            info.commandBuffer                = ToApi(pSubmitInfo->ppCommandBuffers[i])->GetVkCommandBuffer();
+            info.deviceMask                   = 0;
+            commandBuffers[n].push_back(info);
+        }
+
+        // Wait semaphores - values are ignored for binary semaphores. Waiting
+        // at ALL_COMMANDS makes sure barriers recorded in the command buffers
+        // (e.g. the swapchain image transition out of PRESENT) chain off of
+        // the wait.
+        for (uint32_t i = 0; i < pSubmitInfo->waitSemaphoreCount; ++i) {
+            VkSemaphoreSubmitInfoKHR info = {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR};
+            info.semaphore                = ToApi(pSubmitInfo->ppWaitSemaphores[i])->GetVkSemaphore();
+            info.value                    = (i < pSubmitInfo->waitValues.size()) ? pSubmitInfo->waitValues[i] : 0;
+            info.stageMask                = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+            info.deviceIndex              = 0;
+            waitSemaphores[n].push_back(info);
         }
+
+        // Signal semaphores
+        for (uint32_t i = 0; i < pSubmitInfo->signalSemaphoreCount; ++i) {
+            VkSemaphoreSubmitInfoKHR info = {VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR};
+            info.semaphore                = ToApi(pSubmitInfo->ppSignalSemaphores[i])->GetVkSemaphore();
+            info.value                    = (i < pSubmitInfo->signalValues.size()) ? pSubmitInfo->signalValues[i] : 0;
+            info.stageMask                = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+            info.deviceIndex              = 0;
+            signalSemaphores[n].push_back(info);
+        }
+
+        VkSubmitInfo2KHR& vksi        = vksis[n];
+        vksi                          = {VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR};
+        vksi.waitSemaphoreInfoCount   = CountU32(waitSemaphores[n]);
+        vksi.pWaitSemaphoreInfos      = DataPtr(waitSemaphores[n]);
+        vksi.commandBufferInfoCount   = CountU32(commandBuffers[n]);
+        vksi.pCommandBufferInfos      = DataPtr(commandBuffers[n]);
+        vksi.signalSemaphoreInfoCount = CountU32(signalSemaphores[n]);
+        vksi.pSignalSemaphoreInfos    = DataPtr(signalSemaphores[n]);
     }
 
-    return ppx::SUCCESS;
+    // Synchronized queue access
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+
+    PPX_ASSERT_MSG(vk::QueueSubmit2KHR != nullptr, "Function not found");
+    return SubmitRuns(
+        submitCount,
+        pSubmitInfos,
+        [this, &vksis](uint32_t first, uint32_t count, VkFence fence) {
+            return vk::QueueSubmit2KHR(mQueue, count, &vksis[first], fence);
+        });
 }
+#endif // defined(VK_KHR_synchronization2)
 
 Result Queue::QueueWait(grfx::Semaphore* pSemaphore, uint64_t value)
 {
@@ -220,6 +328,12 @@ Result Queue::QueueSignal(grfx::Semaphore* pSemaphore, uint64_t value)
     return ppx::SUCCESS;
 }
 
+bool Queue::RequiresOwnershipTransfer(const grfx::Queue* pOtherQueue) const
+{
+    PPX_ASSERT_NULL_ARG(pOtherQueue);
+    return GetQueueFamilyIndex() != ToApi(pOtherQueue)->GetQueueFamilyIndex();
+}
+
 Result Queue::GetTimestampFrequency(uint64_t* pFrequency) const
 {
     if (IsNull(pFrequency)) {
@@ -233,6 +347,81 @@ Result Queue::GetTimestampFrequency(uint64_t* pFrequency) const
     return ppx::SUCCESS;
 }
 
+Result Queue::BindSparseImageTilesImpl(const grfx::SparseImageBindInfo* pBindInfo)
+{
+    vk::Image* pImage = ToApi(pBindInfo->pImage);
+
+    std::vector<VkSparseImageMemoryBind> binds;
+    Result                               ppxres = pImage->GetSparseImageMemoryBinds(pBindInfo, &binds);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    VkSparseImageMemoryBindInfo imageBind = {};
+    imageBind.image                       = pImage->GetVkImage();
+    imageBind.bindCount                   = CountU32(binds);
+    imageBind.pBinds                      = DataPtr(binds);
+
+    // Wait semaphores
+    std::vector<VkSemaphore> waitSemaphores;
+    for (uint32_t i = 0; i < pBindInfo->waitSemaphoreCount; ++i) {
+        waitSemaphores.push_back(ToApi(pBindInfo->ppWaitSemaphores[i])->GetVkSemaphore());
+    }
+
+    // Signal semaphores
+    std::vector<VkSemaphore> signalSemaphores;
+    for (uint32_t i = 0; i < pBindInfo->signalSemaphoreCount; ++i) {
+        signalSemaphores.push_back(ToApi(pBindInfo->ppSignalSemaphores[i])->GetVkSemaphore());
+    }
+
+    VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timelineSubmitInfo.pNext                         = nullptr;
+    timelineSubmitInfo.waitSemaphoreValueCount       = CountU32(pBindInfo->waitValues);
+    timelineSubmitInfo.pWaitSemaphoreValues          = DataPtr(pBindInfo->waitValues);
+    timelineSubmitInfo.signalSemaphoreValueCount     = CountU32(pBindInfo->signalValues);
+    timelineSubmitInfo.pSignalSemaphoreValues        = DataPtr(pBindInfo->signalValues);
+
+    VkBindSparseInfo vkbi     = {VK_STRUCTURE_TYPE_BIND_SPARSE_INFO};
+    vkbi.pNext                = &timelineSubmitInfo;
+    vkbi.waitSemaphoreCount   = CountU32(waitSemaphores);
+    vkbi.pWaitSemaphores      = DataPtr(waitSemaphores);
+    vkbi.imageBindCount       = binds.empty() ? 0 : 1;
+    vkbi.pImageBinds          = &imageBind;
+    vkbi.signalSemaphoreCount = CountU32(signalSemaphores);
+    vkbi.pSignalSemaphores    = DataPtr(signalSemaphores);
+
+    // Fence
+    VkFence fence = VK_NULL_HANDLE;
+    if (!IsNull(pBindInfo->pFence)) {
+        fence = ToApi(pBindInfo->pFence)->GetVkFence();
+    }
+
+    // Synchronized queue access
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+
+        VkResult vkres = vkQueueBindSparse(mQueue, 1, &vkbi, fence);
+        if (vkres != VK_SUCCESS) {
+            PPX_ASSERT_MSG(false, "vkQueueBindSparse failed: " << ToString(vkres));
+            return ppx::ERROR_API_FAILURE;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+VkResult Queue::BindSparseAndWait(const VkBindSparseInfo* pBindInfo)
+{
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+
+    VkResult vkres = vkQueueBindSparse(mQueue, 1, pBindInfo, VK_NULL_HANDLE);
+    if (vkres != VK_SUCCESS) {
+        return vkres;
+    }
+
+    return vkQueueWaitIdle(mQueue);
+}
+
 static VkResult CmdTransitionImageLayout(
     VkCommandBuffer      commandBuffer,
     VkImage              image,
@@ -0,0 +1,159 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/grfx/vk/vk_ray_tracing.h"
+#include "ppx/grfx/vk/vk_buffer.h"
+#include "ppx/grfx/vk/vk_device.h"
+
+namespace ppx {
+namespace grfx {
+namespace vk {
+
+#if defined(VK_KHR_acceleration_structure)
+static VkDeviceAddress GetBufferAddress(const grfx::Buffer* pBuffer, uint64_t offset)
+{
+    if (IsNull(pBuffer)) {
+        return 0;
+    }
+    return ToApi(pBuffer)->GetVkDeviceAddress() + offset;
+}
+
+static VkAccelerationStructureTypeKHR ToVkAccelerationStructureType(grfx::AccelerationStructureType value)
+{
+    switch (value) {
+        default: break;
+        case grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL: return VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+        case grfx::ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL: return VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
+    }
+    return VK_ACCELERATION_STRUCTURE_TYPE_MAX_ENUM_KHR;
+}
+
+static VkBuildAccelerationStructureFlagsKHR ToVkBuildAccelerationStructureFlags(const grfx::AccelerationStructureBuildFlags& value)
+{
+    VkBuildAccelerationStructureFlagsKHR flags = 0;
+    // clang-format off
+    if (value.bits.allowUpdate    ) flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    if (value.bits.allowCompaction) flags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    if (value.bits.preferFastTrace) flags |= VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+    if (value.bits.preferFastBuild) flags |= VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+    // clang-format on
+    return flags;
+}
+
+Result ToVkAccelerationStructureBuildGeometry(const grfx::AccelerationStructureBuildInputs* pInputs, bool update, vk::AccelerationStructureBuildGeometry* pGeometry)
+{
+    PPX_ASSERT_NULL_ARG(pInputs);
+    PPX_ASSERT_NULL_ARG(pGeometry);
+
+    pGeometry->geometries.clear();
+    pGeometry->primitiveCounts.clear();
+
+    if (pInputs->type == grfx::ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL) {
+        if ((pInputs->geometryCount > 0) && IsNull(pInputs->pGeometries)) {
+            return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+        }
+
+        for (uint32_t i = 0; i < pInputs->geometryCount; ++i) {
+            const grfx::AccelerationStructureTriangles& src     = pInputs->pGeometries[i];
+            const bool                                  indexed = (src.indexType != grfx::INDEX_TYPE_UNDEFINED);
+
+            VkAccelerationStructureGeometryKHR geometry             = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR};
+            geometry.geometryType                                   = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+            geometry.flags                                          = src.opaque ? VK_GEOMETRY_OPAQUE_BIT_KHR : 0;
+            geometry.geometry.triangles.sType                       = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+            geometry.geometry.triangles.vertexFormat                = ToVkFormat(src.vertexFormat);
+            geometry.geometry.triangles.vertexData.deviceAddress    = GetBufferAddress(src.pVertexBuffer, src.vertexOffset);
+            geometry.geometry.triangles.vertexStride                = src.vertexStride;
+            geometry.geometry.triangles.maxVertex                   = (src.vertexCount > 0) ? (src.vertexCount - 1) : 0;
+            geometry.geometry.triangles.indexType                   = indexed ? ToVkIndexType(src.indexType) : VK_INDEX_TYPE_NONE_KHR;
+            geometry.geometry.triangles.indexData.deviceAddress     = indexed ? GetBufferAddress(src.pIndexBuffer, src.indexOffset) : 0;
+            geometry.geometry.triangles.transformData.deviceAddress = 0;
+
+            pGeometry->geometries.push_back(geometry);
+            pGeometry->primitiveCounts.push_back((indexed ? src.indexCount : src.vertexCount) / 3);
+        }
+    }
+    else if (pInputs->type == grfx::ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL) {
+        VkAccelerationStructureGeometryKHR geometry    = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR};
+        geometry.geometryType                          = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+        geometry.geometry.instances.sType              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
+        geometry.geometry.instances.arrayOfPointers    = VK_FALSE;
+        geometry.geometry.instances.data.deviceAddress = GetBufferAddress(pInputs->pInstanceBuffer, pInputs->instanceOffset);
+
+        pGeometry->geometries.push_back(geometry);
+        pGeometry->primitiveCounts.push_back(pInputs->instanceCount);
+    }
+    else {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    VkAccelerationStructureBuildGeometryInfoKHR& buildInfo = pGeometry->buildInfo;
+    buildInfo                                              = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR};
+    buildInfo.type                                         = ToVkAccelerationStructureType(pInputs->type);
+    buildInfo.flags                                        = ToVkBuildAccelerationStructureFlags(pInputs->flags);
+    buildInfo.mode                                         = update ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+    buildInfo.geometryCount                                = CountU32(pGeometry->geometries);
+    buildInfo.pGeometries                                  = DataPtr(pGeometry->geometries);
+
+    return ppx::SUCCESS;
+}
+#endif // defined(VK_KHR_acceleration_structure)
+
+Result AccelerationStructure::CreateApiObjects(const grfx::AccelerationStructureCreateInfo* pCreateInfo)
+{
+#if defined(VK_KHR_acceleration_structure)
+    VkAccelerationStructureCreateInfoKHR vkci = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
+    vkci.buffer                               = ToApi(mBuffer)->GetVkBuffer();
+    vkci.offset                               = 0;
+    vkci.size                                 = pCreateInfo->size;
+    vkci.type                                 = ToVkAccelerationStructureType(pCreateInfo->type);
+
+    VkResult vkres = CreateAccelerationStructureKHR(
+        ToApi(GetDevice())->GetVkDevice(),
+        &vkci,
+        nullptr,
+        &mAccelerationStructure);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateAccelerationStructureKHR failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
+    }
+
+    VkAccelerationStructureDeviceAddressInfoKHR addressInfo = {VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR};
+    addressInfo.accelerationStructure                       = mAccelerationStructure;
+    mDeviceAddress                                          = GetAccelerationStructureDeviceAddressKHR(ToApi(GetDevice())->GetVkDevice(), &addressInfo);
+
+    return ppx::SUCCESS;
+#else
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#endif
+}
+
+void AccelerationStructure::DestroyApiObjects()
+{
+#if defined(VK_KHR_acceleration_structure)
+    if (mAccelerationStructure) {
+        DestroyAccelerationStructureKHR(
+            ToApi(GetDevice())->GetVkDevice(),
+            mAccelerationStructure,
+            nullptr);
+
+        mAccelerationStructure.Reset();
+    }
+#endif
+    mDeviceAddress = 0;
+}
+
+} // namespace vk
+} // namespace grfx
+} // namespace ppx
@@ -30,23 +30,7 @@ Result RenderPass::CreateRenderPass(const grfx::internal::RenderPassCreateInfo*
 
     uint32_t      depthStencilAttachment = -1;
     size_t        rtvCount               = CountU32(mRenderTargetViews);
-    VkImageLayout depthStencillayout     = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Determine layout for depth/stencil
-    {
-        // These variables are not used for anything meaningful
-        // in ToVkBarrierDst so they can be all zeroes.
-        //
-        VkPhysicalDeviceFeatures features   = {};
-        VkPipelineStageFlags     stageMask  = 0;
-        VkAccessFlags            accessMask = 0;
-
-        Result ppxres = ToVkBarrierDst(pCreateInfo->depthStencilState, grfx::CommandType::COMMAND_TYPE_GRAPHICS, features, stageMask, accessMask, depthStencillayout);
-        if (Failed(ppxres)) {
-            PPX_ASSERT_MSG(false, "failed to determine layout for depth stencil state");
-            return ppxres;
-        }
-    }
+    VkImageLayout depthStencillayout     = mDepthStencilLayout;
 
     // Attachment descriptions
     std::vector<VkAttachmentDescription> attachmentDescs;
@@ -74,7 +58,7 @@ Result RenderPass::CreateRenderPass(const grfx::internal::RenderPassCreateInfo*
             VkAttachmentDescription desc = {};
             desc.flags                   = 0;
             desc.format                  = ToVkFormat(dsv->GetFormat());
-            desc.samples                 = VK_SAMPLE_COUNT_1_BIT;
+            desc.samples                 = ToVkSampleCount(dsv->GetSampleCount());
             desc.loadOp                  = ToVkAttachmentLoadOp(dsv->GetDepthLoadOp());
             desc.storeOp                 = ToVkAttachmentStoreOp(dsv->GetDepthStoreOp());
             desc.stencilLoadOp           = ToVkAttachmentLoadOp(dsv->GetStencilLoadOp());
@@ -85,15 +69,42 @@ Result RenderPass::CreateRenderPass(const grfx::internal::RenderPassCreateInfo*
             depthStencilAttachment = attachmentDescs.size();
             attachmentDescs.push_back(desc);
         }
+
+        // Resolve attachments follow the depth stencil, in the order of
+        // the render targets they resolve
+        for (uint32_t i = 0; i < rtvCount; ++i) {
+            grfx::RenderTargetViewPtr rtv = GetResolveView(i);
+            if (!rtv) {
+                continue;
+            }
+
+            VkAttachmentDescription desc = {};
+            desc.flags                   = 0;
+            desc.format                  = ToVkFormat(rtv->GetFormat());
+            desc.samples                 = VK_SAMPLE_COUNT_1_BIT;
+            desc.loadOp                  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            desc.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+            desc.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            desc.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            desc.initialLayout           = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            desc.finalLayout             = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            attachmentDescs.push_back(desc);
+        }
     }
 
     std::vector<VkAttachmentReference> colorRefs;
+    std::vector<VkAttachmentReference> resolveRefs;
     {
+        uint32_t resolveAttachment = hasDepthSencil ? (depthStencilAttachment + 1) : static_cast<uint32_t>(rtvCount);
         for (uint32_t i = 0; i < rtvCount; ++i) {
             VkAttachmentReference ref = {};
             ref.attachment            = i;
             ref.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
             colorRefs.push_back(ref);
+
+            ref.attachment = GetResolveView(i) ? resolveAttachment++ : VK_ATTACHMENT_UNUSED;
+            resolveRefs.push_back(ref);
         }
     }
 
@@ -110,7 +121,7 @@ Result RenderPass::CreateRenderPass(const grfx::internal::RenderPassCreateInfo*
     subpassDescription.pInputAttachments       = nullptr;
     subpassDescription.colorAttachmentCount    = CountU32(colorRefs);
     subpassDescription.pColorAttachments       = DataPtr(colorRefs);
-    subpassDescription.pResolveAttachments     = nullptr;
+    subpassDescription.pResolveAttachments     = HasResolve() ? DataPtr(resolveRefs) : nullptr;
     subpassDescription.pDepthStencilAttachment = hasDepthSencil ? &depthStencilRef : nullptr;
     subpassDescription.preserveAttachmentCount = 0;
     subpassDescription.pPreserveAttachments    = nullptr;
@@ -146,39 +157,65 @@ Result RenderPass::CreateRenderPass(const grfx::internal::RenderPassCreateInfo*
         vkci.pNext = &multiviewInfo;
     }
 
-    if (!IsNull(pCreateInfo->pShadingRatePattern)) {
-        SampleCount shadingRateSampleCount = pCreateInfo->pShadingRatePattern->GetSampleCount();
-        for (uint32_t i = 0; i < rtvCount; ++i) {
-            PPX_ASSERT_MSG(
-                mRenderTargetViews[i]->GetSampleCount() == shadingRateSampleCount,
-                "The sample count for each render target must match the sample count of the shading rate pattern.");
-        }
-        if (hasDepthSencil) {
-            PPX_ASSERT_MSG(
-                mDepthStencilView->GetSampleCount() == shadingRateSampleCount,
-                "The sample count of the depth attachment must match the sample count of the shading rate pattern.");
+    // Render pass compatibility only depends on the attachment formats and
+    // sample counts and on the subpass, so framebuffers are shared between
+    // render passes that differ in load ops or layouts, e.g. the swapchain's
+    // clear and load render passes.
+    mCompatibilityKey.clear();
+    mCompatibilityKey.push_back(rtvCount);
+    mCompatibilityKey.push_back(hasDepthSencil ? 1 : 0);
+    for (const VkAttachmentDescription& desc : attachmentDescs) {
+        mCompatibilityKey.push_back(static_cast<uint64_t>(desc.format));
+        mCompatibilityKey.push_back(static_cast<uint64_t>(desc.samples));
+    }
+    for (const VkAttachmentReference& ref : resolveRefs) {
+        mCompatibilityKey.push_back(HasResolve() ? ref.attachment : VK_ATTACHMENT_UNUSED);
+    }
+    mCompatibilityKey.push_back(pCreateInfo->multiViewState.viewMask);
+    mCompatibilityKey.push_back((pCreateInfo->multiViewState.viewMask > 0) ? pCreateInfo->multiViewState.correlationMask : 0);
+
+    // Shading rate patterns add attachments of their own, those render
+    // passes aren't shared
+    if (IsNull(pCreateInfo->pShadingRatePattern)) {
+        std::vector<uint64_t> key = mCompatibilityKey;
+        for (const VkAttachmentDescription& desc : attachmentDescs) {
+            key.push_back(static_cast<uint64_t>(desc.loadOp));
+            key.push_back(static_cast<uint64_t>(desc.storeOp));
+            key.push_back(static_cast<uint64_t>(desc.stencilLoadOp));
+            key.push_back(static_cast<uint64_t>(desc.stencilStoreOp));
+            key.push_back(static_cast<uint64_t>(desc.initialLayout));
+            key.push_back(static_cast<uint64_t>(desc.finalLayout));
         }
-        auto     modifiedCreateInfo = ToApi(pCreateInfo->pShadingRatePattern)->GetModifiedRenderPassCreateInfo(vkci);
-        VkResult vkres              = vk::CreateRenderPass(
-            ToApi(GetDevice())->GetVkDevice(),
-            modifiedCreateInfo.get(),
-            nullptr,
-            &mRenderPass);
-        if (vkres != VK_SUCCESS) {
-            PPX_ASSERT_MSG(false, "vkCreateRenderPass failed: " << ToString(vkres));
-            return ppx::ERROR_API_FAILURE;
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        Result       ppxres     = ToApi(GetDevice())->AcquireRenderPass(key, &vkci, &renderPass);
+        if (Failed(ppxres)) {
+            return ppxres;
         }
+        mRenderPass = renderPass;
+        return ppx::SUCCESS;
     }
-    else {
-        VkResult vkres = vk::CreateRenderPass(
-            ToApi(GetDevice())->GetVkDevice(),
-            &vkci,
-            nullptr,
-            &mRenderPass);
-        if (vkres != VK_SUCCESS) {
-            PPX_ASSERT_MSG(false, "vkCreateRenderPass failed: " << ToString(vkres));
-            return ppx::ERROR_API_FAILURE;
-        }
+
+    SampleCount shadingRateSampleCount = pCreateInfo->pShadingRatePattern->GetSampleCount();
+    for (uint32_t i = 0; i < rtvCount; ++i) {
+        PPX_ASSERT_MSG(
+            mRenderTargetViews[i]->GetSampleCount() == shadingRateSampleCount,
+            "The sample count for each render target must match the sample count of the shading rate pattern.");
+    }
+    if (hasDepthSencil) {
+        PPX_ASSERT_MSG(
+            mDepthStencilView->GetSampleCount() == shadingRateSampleCount,
+            "The sample count of the depth attachment must match the sample count of the shading rate pattern.");
+    }
+    auto     modifiedCreateInfo = ToApi(pCreateInfo->pShadingRatePattern)->GetModifiedRenderPassCreateInfo(vkci);
+    VkResult vkres              = vk::CreateRenderPass(
+        ToApi(GetDevice())->GetVkDevice(),
+        modifiedCreateInfo.get(),
+        nullptr,
+        &mRenderPass);
+    if (vkres != VK_SUCCESS) {
+        PPX_ASSERT_MSG(false, "vkCreateRenderPass failed: " << ToString(vkres));
+        return ppx::ERROR_API_FAILURE;
     }
 
     return ppx::SUCCESS;
@@ -201,6 +238,13 @@ Result RenderPass::CreateFramebuffer(const grfx::internal::RenderPassCreateInfo*
         attachments.push_back(ToApi(dsv.Get())->GetVkImageView());
     }
 
+    for (uint32_t i = 0; i < rtvCount; ++i) {
+        grfx::RenderTargetViewPtr rtv = GetResolveView(i);
+        if (rtv) {
+            attachments.push_back(ToApi(rtv.Get())->GetVkImageView());
+        }
+    }
+
     if (!IsNull(pCreateInfo->pShadingRatePattern)) {
         if (pCreateInfo->pShadingRatePattern->GetShadingRateMode() == grfx::SHADING_RATE_FDM) {
             if (rtvCount > 0) {
@@ -246,21 +290,65 @@ Result RenderPass::CreateFramebuffer(const grfx::internal::RenderPassCreateInfo*
     vkci.height                  = pCreateInfo->height;
     vkci.layers                  = 1;
 
-    VkResult vkres = vkCreateFramebuffer(
-        ToApi(GetDevice())->GetVkDevice(),
-        &vkci,
-        nullptr,
-        &mFramebuffer);
-    if (vkres != VK_SUCCESS) {
-        PPX_ASSERT_MSG(false, "vkCreateFramebuffer failed: " << ToString(vkres));
-        return ppx::ERROR_API_FAILURE;
+    if (!IsNull(pCreateInfo->pShadingRatePattern)) {
+        VkResult vkres = vkCreateFramebuffer(
+            ToApi(GetDevice())->GetVkDevice(),
+            &vkci,
+            nullptr,
+            &mFramebuffer);
+        if (vkres != VK_SUCCESS) {
+            PPX_ASSERT_MSG(false, "vkCreateFramebuffer failed: " << ToString(vkres));
+            return ppx::ERROR_API_FAILURE;
+        }
+        return ppx::SUCCESS;
     }
 
+    // Any render pass compatible with this one can use the framebuffer
+    std::vector<uint64_t> key = mCompatibilityKey;
+    for (VkImageView attachment : attachments) {
+        key.push_back(reinterpret_cast<uint64_t>(attachment));
+    }
+    key.push_back(vkci.width);
+    key.push_back(vkci.height);
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    Result        ppxres      = ToApi(GetDevice())->AcquireFramebuffer(key, &vkci, &framebuffer);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    mFramebuffer = framebuffer;
+
     return ppx::SUCCESS;
 }
 
 Result RenderPass::CreateApiObjects(const grfx::internal::RenderPassCreateInfo* pCreateInfo)
 {
+    // Determine layout for depth/stencil
+    {
+        // These variables are not used for anything meaningful
+        // in ToVkBarrierDst so they can be all zeroes.
+        //
+        VkPhysicalDeviceFeatures features   = {};
+        VkPipelineStageFlags     stageMask  = 0;
+        VkAccessFlags            accessMask = 0;
+
+        Result ppxres = ToVkBarrierDst(pCreateInfo->depthStencilState, grfx::CommandType::COMMAND_TYPE_GRAPHICS, features, stageMask, accessMask, mDepthStencilLayout);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "failed to determine layout for depth stencil state");
+            return ppxres;
+        }
+    }
+
+    // Dynamic rendering takes the views when the pass begins, so there's
+    // nothing to create for a load op or on resize. Shading rate patterns
+    // and multiview still need a VkRenderPass, as do the pipelines for them.
+    mUsesDynamicRendering = ToApi(GetDevice())->UsesDynamicRenderPasses() &&
+                            IsNull(pCreateInfo->pShadingRatePattern) &&
+                            (pCreateInfo->multiViewState.viewMask == 0);
+    if (mUsesDynamicRendering) {
+        return ppx::SUCCESS;
+    }
+
     Result ppxres = CreateRenderPass(pCreateInfo);
     if (Failed(ppxres)) {
         return ppxres;
@@ -276,19 +364,14 @@ Result RenderPass::CreateApiObjects(const grfx::internal::RenderPassCreateInfo*
 
 void RenderPass::DestroyApiObjects()
 {
+    // Shared objects are only destroyed with their last reference
     if (mFramebuffer) {
-        vkDestroyFramebuffer(
-            ToApi(GetDevice())->GetVkDevice(),
-            mFramebuffer,
-            nullptr);
+        ToApi(GetDevice())->ReleaseFramebuffer(mFramebuffer);
         mFramebuffer.Reset();
     }
 
     if (mRenderPass) {
-        vkDestroyRenderPass(
-            ToApi(GetDevice())->GetVkDevice(),
-            mRenderPass,
-            nullptr);
+        ToApi(GetDevice())->ReleaseRenderPass(mRenderPass);
         mRenderPass.Reset();
     }
 }
@@ -326,7 +409,7 @@ VkResult CreateTransientRenderPass(
             VkAttachmentDescription desc = {};
             desc.flags                   = 0;
             desc.format                  = depthStencilFormat;
-            desc.samples                 = VK_SAMPLE_COUNT_1_BIT;
+            desc.samples                 = sampleCount;
             desc.loadOp                  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             desc.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
             desc.finalLayout             = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
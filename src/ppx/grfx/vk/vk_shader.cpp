@@ -15,6 +15,8 @@
 #include "ppx/grfx/vk/vk_shader.h"
 #include "ppx/grfx/vk/vk_device.h"
 
+#include "xxhash.h"
+
 namespace ppx {
 namespace grfx {
 namespace vk {
@@ -39,6 +41,13 @@ Result ShaderModule::CreateApiObjects(const grfx::ShaderModuleCreateInfo* pCreat
         return ppx::ERROR_API_FAILURE;
     }
 
+    // The size is mixed in since it's part of what identifies the code
+    mCodeHash = XXH3_64bits_withSeed(pCreateInfo->pCode, pCreateInfo->size, pCreateInfo->size);
+
+    if (GetDevice()->ShaderObjectsSupported()) {
+        mCode.assign(pCreateInfo->pCode, pCreateInfo->pCode + pCreateInfo->size);
+    }
+
     return ppx::SUCCESS;
 }
 
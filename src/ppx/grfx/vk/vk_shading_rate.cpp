@@ -174,8 +174,13 @@ Result ShadingRatePattern::CreateApiObjects(const ShadingRatePatternCreateInfo*
             return ppx::ERROR_FAILED;
     }
 
+    const grfx::Image* pExistingImage = pCreateInfo->pAttachmentImage;
     if (pCreateInfo->texelSize.width == 0 && pCreateInfo->texelSize.height == 0) {
         mTexelSize = minTexelSize;
+        if (!IsNull(pExistingImage)) {
+            mTexelSize.width  = (pCreateInfo->framebufferSize.width + pExistingImage->GetWidth() - 1) / pExistingImage->GetWidth();
+            mTexelSize.height = (pCreateInfo->framebufferSize.height + pExistingImage->GetHeight() - 1) / pExistingImage->GetHeight();
+        }
     }
     else {
         mTexelSize = pCreateInfo->texelSize;
@@ -194,22 +199,31 @@ Result ShadingRatePattern::CreateApiObjects(const ShadingRatePatternCreateInfo*
         mTexelSize.height <= maxTexelSize.height,
         "Texel height (" << mTexelSize.height << ") must be <= the maximum texel height from capabilities (" << maxTexelSize.height << ")");
 
-    imageCreateInfo.width  = (pCreateInfo->framebufferSize.width + mTexelSize.width - 1) / mTexelSize.width;
-    imageCreateInfo.height = (pCreateInfo->framebufferSize.height + mTexelSize.height - 1) / mTexelSize.height;
-    imageCreateInfo.depth  = 1;
+    if (!IsNull(pExistingImage)) {
+        PPX_ASSERT_MSG(pExistingImage->GetFormat() == imageCreateInfo.format, "Existing shading rate attachment image has the wrong format");
+        mAttachmentImage     = const_cast<grfx::Image*>(pExistingImage);
+        mOwnsAttachmentImage = false;
+    }
+    else {
+        imageCreateInfo.width  = (pCreateInfo->framebufferSize.width + mTexelSize.width - 1) / mTexelSize.width;
+        imageCreateInfo.height = (pCreateInfo->framebufferSize.height + mTexelSize.height - 1) / mTexelSize.height;
+        imageCreateInfo.depth  = 1;
 
-    PPX_CHECKED_CALL(GetDevice()->CreateImage(&imageCreateInfo, &mAttachmentImage));
+        PPX_CHECKED_CALL(GetDevice()->CreateImage(&imageCreateInfo, &mAttachmentImage));
+    }
 
+    // Multiview density maps have a layer per view
+    const uint32_t        layerCount     = mAttachmentImage->GetArrayLayerCount();
     VkImageViewCreateInfo vkci           = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
     vkci.flags                           = 0;
     vkci.image                           = ToApi(mAttachmentImage)->GetVkImage();
-    vkci.viewType                        = VK_IMAGE_VIEW_TYPE_2D;
+    vkci.viewType                        = (layerCount > 1) ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     vkci.format                          = ToVkFormat(imageCreateInfo.format);
     vkci.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
     vkci.subresourceRange.baseMipLevel   = 0;
     vkci.subresourceRange.levelCount     = 1;
     vkci.subresourceRange.baseArrayLayer = 0;
-    vkci.subresourceRange.layerCount     = 1;
+    vkci.subresourceRange.layerCount     = layerCount;
 
     VkResult vkres = vk::CreateImageView(
         ToApi(GetDevice())->GetVkDevice(),
@@ -234,7 +248,9 @@ void ShadingRatePattern::DestroyApiObjects()
         mAttachmentView.Reset();
     }
     if (mAttachmentImage) {
-        GetDevice()->DestroyImage(mAttachmentImage);
+        if (mOwnsAttachmentImage) {
+            GetDevice()->DestroyImage(mAttachmentImage);
+        }
         mAttachmentImage.Reset();
     }
 }
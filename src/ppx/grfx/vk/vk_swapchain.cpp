@@ -259,7 +259,8 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
     if (isXREnabled) {
         const XrComponent& xrComponent = *mCreateInfo.pXrComponent;
 
-        PPX_ASSERT_MSG(pCreateInfo->colorFormat == xrComponent.GetColorFormat(), "XR color format differs from requested swapchain format");
+        // Motion vectors have their own format and aren't multisampled
+        PPX_ASSERT_MSG(pCreateInfo->xrSpaceWarp || (pCreateInfo->colorFormat == xrComponent.GetColorFormat()), "XR color format differs from requested swapchain format");
 
         XrSwapchainCreateInfo info = {XR_TYPE_SWAPCHAIN_CREATE_INFO};
         info.arraySize             = pCreateInfo->arrayLayerCount;
@@ -268,21 +269,78 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
         info.format                = ToVkFormat(pCreateInfo->colorFormat);
         info.width                 = pCreateInfo->width;
         info.height                = pCreateInfo->height;
-        info.sampleCount           = xrComponent.GetSampleCount();
+        info.sampleCount           = pCreateInfo->xrSpaceWarp ? 1 : xrComponent.GetSampleCount();
         info.usageFlags            = XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT;
+
+        // The runtime provides a density map with each image
+        const bool usesFoveation = pCreateInfo->xrFoveation && xrComponent.IsFoveationSupported() && (GetDevice()->GetShadingRateCapabilities().supportedShadingRateMode == grfx::SHADING_RATE_FDM);
+        if (pCreateInfo->xrFoveation && xrComponent.IsFoveationSupported() && !usesFoveation) {
+            PPX_LOG_WARN("XR foveation needs a device created with SHADING_RATE_FDM, swapchain isn't foveated");
+        }
+        XrSwapchainCreateInfoFoveationFB foveationInfo = {XR_TYPE_SWAPCHAIN_CREATE_INFO_FOVEATION_FB};
+        foveationInfo.flags                            = XR_SWAPCHAIN_CREATE_FOVEATION_FRAGMENT_DENSITY_MAP_BIT_FB;
+        if (usesFoveation) {
+            info.next = &foveationInfo;
+        }
         CHECK_XR_CALL(xrCreateSwapchain(xrComponent.GetSession(), &info, &mXrColorSwapchain));
 
         // Find out how many textures were generated for the swapchain
         uint32_t imageCount = 0;
         CHECK_XR_CALL(xrEnumerateSwapchainImages(mXrColorSwapchain, 0, &imageCount, nullptr));
-        std::vector<XrSwapchainImageVulkanKHR> surfaceImages;
+        std::vector<XrSwapchainImageVulkanKHR>         surfaceImages;
+        std::vector<XrSwapchainImageFoveationVulkanFB> foveationImages;
         surfaceImages.resize(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_VULKAN_KHR});
+        if (usesFoveation) {
+            foveationImages.resize(imageCount, {XR_TYPE_SWAPCHAIN_IMAGE_FOVEATION_VULKAN_FB});
+            for (uint32_t i = 0; i < imageCount; i++) {
+                surfaceImages[i].next = &foveationImages[i];
+            }
+        }
         CHECK_XR_CALL(xrEnumerateSwapchainImages(mXrColorSwapchain, imageCount, &imageCount, (XrSwapchainImageBaseHeader*)surfaceImages.data()));
         for (uint32_t i = 0; i < imageCount; i++) {
             colorImages.push_back(surfaceImages[i].image);
         }
 
-        if (pCreateInfo->depthFormat != grfx::FORMAT_UNDEFINED && xrComponent.GetDepthFormat() != grfx::FORMAT_UNDEFINED && xrComponent.UsesDepthSwapchains()) {
+        for (const XrSwapchainImageFoveationVulkanFB& foveationImage : foveationImages) {
+            grfx::ImageCreateInfo imageCreateInfo              = {};
+            imageCreateInfo.type                               = grfx::IMAGE_TYPE_2D;
+            imageCreateInfo.width                              = foveationImage.width;
+            imageCreateInfo.height                             = foveationImage.height;
+            imageCreateInfo.depth                              = 1;
+            imageCreateInfo.format                             = grfx::FORMAT_R8G8_UNORM;
+            imageCreateInfo.sampleCount                        = grfx::SAMPLE_COUNT_1;
+            imageCreateInfo.mipLevelCount                      = 1;
+            imageCreateInfo.arrayLayerCount                    = pCreateInfo->arrayLayerCount;
+            imageCreateInfo.usageFlags.bits.fragmentDensityMap = true;
+            imageCreateInfo.initialState                       = grfx::RESOURCE_STATE_FRAGMENT_DENSITY_MAP_ATTACHMENT;
+            imageCreateInfo.pApiObject                         = (void*)(foveationImage.image);
+
+            grfx::ImagePtr image;
+            Result         ppxres = GetDevice()->CreateImage(&imageCreateInfo, &image);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "foveation image create failed");
+                return ppxres;
+            }
+            mXrFoveationImages.push_back(image);
+
+            grfx::ShadingRatePatternCreateInfo patternCreateInfo = {};
+            patternCreateInfo.framebufferSize                    = {pCreateInfo->width, pCreateInfo->height};
+            patternCreateInfo.shadingRateMode                    = grfx::SHADING_RATE_FDM;
+            patternCreateInfo.sampleCount                        = static_cast<grfx::SampleCount>(xrComponent.GetSampleCount());
+            patternCreateInfo.pAttachmentImage                   = image;
+
+            grfx::ShadingRatePatternPtr pattern;
+            ppxres = GetDevice()->CreateShadingRatePattern(&patternCreateInfo, &pattern);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "foveation shading rate pattern create failed");
+                return ppxres;
+            }
+            mXrFoveationPatterns.push_back(pattern);
+        }
+
+        // Space warp always needs depth
+        const bool usesDepthSwapchain = xrComponent.UsesDepthSwapchains() || pCreateInfo->xrSpaceWarp;
+        if (pCreateInfo->depthFormat != grfx::FORMAT_UNDEFINED && xrComponent.GetDepthFormat() != grfx::FORMAT_UNDEFINED && usesDepthSwapchain) {
             PPX_ASSERT_MSG(pCreateInfo->depthFormat == xrComponent.GetDepthFormat(), "XR depth format differs from requested swapchain format");
 
             XrSwapchainCreateInfo info = {XR_TYPE_SWAPCHAIN_CREATE_INFO};
@@ -438,7 +496,7 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
         vkci.compositeAlpha           = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
         vkci.presentMode              = presentMode;
         vkci.clipped                  = VK_FALSE;
-        vkci.oldSwapchain             = VK_NULL_HANDLE;
+        vkci.oldSwapchain             = IsNull(pCreateInfo->pOldSwapchain) ? VK_NULL_HANDLE : ToApi(pCreateInfo->pOldSwapchain)->GetVkSwapchain();
 
         VkResult vkres = vkCreateSwapchainKHR(
             ToApi(GetDevice())->GetVkDevice(),
@@ -543,6 +601,12 @@ Result Swapchain::CreateApiObjects(const grfx::SwapchainCreateInfo* pCreateInfo)
     // Save queue for presentation.
     mQueue = ToApi(pCreateInfo->pQueue)->GetVkQueue();
 
+    mUsePresentWait = (pCreateInfo->maxFrameLatency > 0) && ToApi(GetDevice())->HasPresentWait();
+    mPresentId      = 0;
+    if ((pCreateInfo->maxFrameLatency > 0) && !mUsePresentWait) {
+        PPX_LOG_WARN("Vulkan swapchain max frame latency ignored, VK_KHR_present_wait is not supported");
+    }
+
     return ppx::SUCCESS;
 }
 
@@ -573,6 +637,21 @@ Result Swapchain::AcquireNextImageInternal(
         fence = ToApi(pFence)->GetVkFence();
     }
 
+#if defined(VK_KHR_present_wait)
+    // Wait until at most maxFrameLatency presents are queued ahead of the display
+    if (mUsePresentWait && (mPresentId >= mCreateInfo.maxFrameLatency)) {
+        const uint64_t presentId = mPresentId + 1 - mCreateInfo.maxFrameLatency;
+        VkResult       vkres     = vk::WaitForPresentKHR(ToApi(GetDevice())->GetVkDevice(), mSwapchain, presentId, timeout);
+        if (vkres == VK_TIMEOUT) {
+            return ppx::ERROR_WAIT_TIMED_OUT;
+        }
+        // Out of date or lost surfaces are reported by the acquire below
+        if (vkres < VK_SUCCESS) {
+            PPX_LOG_WARN_ONCE("vkWaitForPresentKHR returned: " << ToString(vkres));
+        }
+    }
+#endif
+
     VkResult vkres = vkAcquireNextImageKHR(
         ToApi(GetDevice())->GetVkDevice(),
         mSwapchain,
@@ -620,6 +699,17 @@ Result Swapchain::PresentInternal(
     vkpi.pImageIndices      = &imageIndex;
     vkpi.pResults           = nullptr;
 
+#if defined(VK_KHR_present_id)
+    // Ids are what AcquireNextImageInternal() waits on
+    VkPresentIdKHR presentIdInfo = {VK_STRUCTURE_TYPE_PRESENT_ID_KHR};
+    uint64_t       presentId     = mPresentId + 1;
+    if (mUsePresentWait) {
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds    = &presentId;
+        vkpi.pNext                   = &presentIdInfo;
+    }
+#endif
+
     VkResult vkres = vk::QueuePresent(
         mQueue,
         &vkpi);
@@ -628,6 +718,7 @@ Result Swapchain::PresentInternal(
         PPX_ASSERT_MSG(false, "vkQueuePresentKHR failed: " << ToString(vkres));
         return ppx::ERROR_API_FAILURE;
     }
+    mPresentId = mPresentId + 1;
     // Handle warning cases
     if (vkres > VK_SUCCESS) {
 #if !defined(PPX_ANDROID)
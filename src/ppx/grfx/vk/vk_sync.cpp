@@ -81,6 +81,14 @@ Result Fence::Reset()
     return ppx::SUCCESS;
 }
 
+bool Fence::IsSignaled() const
+{
+    VkResult vkres = vkGetFenceStatus(
+        ToApi(GetDevice())->GetVkDevice(),
+        mFence);
+    return (vkres == VK_SUCCESS);
+}
+
 // -------------------------------------------------------------------------------------------------
 // Semaphore
 // -------------------------------------------------------------------------------------------------
@@ -85,6 +85,9 @@ const char* ToString(VkDescriptorType value)
         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : return "VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC"; break;
         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : return "VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC"; break;
         case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT       : return "VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT"; break;
+#if defined(VK_KHR_acceleration_structure)
+        case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR : return "VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR"; break;
+#endif
     }
     // clang-format on
     return "<unknown VkDescriptorType value>";
@@ -258,6 +261,10 @@ VkBufferUsageFlags ToVkBufferUsageFlags(const grfx::BufferUsageFlags& value)
     if (value.bits.transformFeedbackBuffer       ) flags |= VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_BUFFER_BIT_EXT;
     if (value.bits.transformFeedbackCounterBuffer) flags |= VK_BUFFER_USAGE_TRANSFORM_FEEDBACK_COUNTER_BUFFER_BIT_EXT;
     if (value.bits.shaderDeviceAddress           ) flags |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+#if defined(VK_KHR_acceleration_structure)
+    if (value.bits.accelerationStructureStorage  ) flags |= VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+    if (value.bits.accelerationStructureInput    ) flags |= VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
+#endif
     // clang-format on
     return flags;
 }
@@ -392,6 +399,9 @@ VkDescriptorType ToVkDescriptorType(grfx::DescriptorType value)
         case grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; break;
         case grfx::DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC; break;
         case grfx::DESCRIPTOR_TYPE_INPUT_ATTACHMENT       : return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT      ; break;
+#if defined(VK_KHR_acceleration_structure)
+        case grfx::DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE : return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR; break;
+#endif
     }
     // clang-format on
     return ppx::InvalidValue<VkDescriptorType>();
@@ -708,6 +718,9 @@ VkQueryType ToVkQueryType(grfx::QueryType value)
         case grfx::QUERY_TYPE_OCCLUSION           : return VK_QUERY_TYPE_OCCLUSION; break;
         case grfx::QUERY_TYPE_TIMESTAMP           : return VK_QUERY_TYPE_TIMESTAMP; break;
         case grfx::QUERY_TYPE_PIPELINE_STATISTICS : return VK_QUERY_TYPE_PIPELINE_STATISTICS; break;
+#if defined(VK_KHR_acceleration_structure)
+        case grfx::QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE : return VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR; break;
+#endif
     }
     // clang-format on
     return ppx::InvalidValue<VkQueryType>();
@@ -766,6 +779,10 @@ VkShaderStageFlags ToVkShaderStageFlags(const grfx::ShaderStageFlags& value)
     if (value.bits.GS) flags |= VK_SHADER_STAGE_GEOMETRY_BIT;
     if (value.bits.PS) flags |= VK_SHADER_STAGE_FRAGMENT_BIT;
     if (value.bits.CS) flags |= VK_SHADER_STAGE_COMPUTE_BIT;
+#if defined(VK_EXT_mesh_shader)
+    if (value.bits.AS) flags |= VK_SHADER_STAGE_TASK_BIT_EXT;
+    if (value.bits.MS) flags |= VK_SHADER_STAGE_MESH_BIT_EXT;
+#endif
     // clang-format on
     return flags;
 }
@@ -992,8 +1009,13 @@ static Result ToVkBarrier(
         } break;
 
         case grfx::RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE: {
+#if defined(VK_KHR_acceleration_structure)
+            stageMask  = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | PIPELINE_STAGE_ALL_SHADER_STAGES;
+            accessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+#else
             stageMask  = InvalidValue<VkPipelineStageFlags>();
             accessMask = InvalidValue<VkAccessFlags>();
+#endif
             layout     = InvalidValue<VkImageLayout>();
         } break;
 
@@ -1036,6 +1058,223 @@ Result ToVkBarrierDst(
     return ToVkBarrier(state, commandType, features, false, stageMask, accessMask, layout);
 }
 
+#if defined(VK_KHR_synchronization2)
+static Result ToVkBarrier2(
+    ResourceState                   state,
+    grfx::CommandType               commandType,
+    const VkPhysicalDeviceFeatures& features,
+    bool                            isSource,
+    VkPipelineStageFlags2KHR&       stageMask,
+    VkAccessFlags2KHR&              accessMask,
+    VkImageLayout&                  layout)
+{
+    // Layouts don't change with synchronization2, so let the legacy
+    // mapping validate the state and supply the layout.
+    VkPipelineStageFlags legacyStageMask  = 0;
+    VkAccessFlags        legacyAccessMask = 0;
+    Result               ppxres           = ToVkBarrier(state, commandType, features, isSource, legacyStageMask, legacyAccessMask, layout);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    VkPipelineStageFlags2KHR PIPELINE_STAGE_ALL_SHADER_STAGES = {};
+    if (commandType == grfx::CommandType::COMMAND_TYPE_COMPUTE) {
+        PIPELINE_STAGE_ALL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+    }
+    else if (commandType == grfx::CommandType::COMMAND_TYPE_GRAPHICS) {
+        PIPELINE_STAGE_ALL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR |
+                                            VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR;
+    }
+    else {
+        PIPELINE_STAGE_ALL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT_KHR;
+    }
+
+    VkPipelineStageFlags2KHR PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES = {};
+    if (commandType == grfx::CommandType::COMMAND_TYPE_COMPUTE) {
+        PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR;
+    }
+    else if (commandType == grfx::CommandType::COMMAND_TYPE_GRAPHICS) {
+        PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT_KHR;
+    }
+    else {
+        PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT_KHR;
+    }
+
+    if (commandType == grfx::CommandType::COMMAND_TYPE_GRAPHICS && features.geometryShader) {
+        PIPELINE_STAGE_ALL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT_KHR;
+        PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES |= VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT_KHR;
+    }
+    if (commandType == grfx::CommandType::COMMAND_TYPE_GRAPHICS && features.tessellationShader) {
+        PIPELINE_STAGE_ALL_SHADER_STAGES |=
+            VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT_KHR |
+            VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT_KHR;
+        PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES |=
+            VK_PIPELINE_STAGE_2_TESSELLATION_CONTROL_SHADER_BIT_KHR |
+            VK_PIPELINE_STAGE_2_TESSELLATION_EVALUATION_SHADER_BIT_KHR;
+    }
+
+    // Shader resources can be sampled images or read-only storage buffers
+    const VkAccessFlags2KHR ACCESS_SHADER_RESOURCE_READ = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR;
+
+    switch (state) {
+        default: return ppx::ERROR_FAILED; break;
+
+        // Contents are discarded but the memory may be aliased with another
+        // image (see CommandBuffer::AliasingBarrier), so prior writes still
+        // need to be ordered before the transition.
+        case grfx::RESOURCE_STATE_UNDEFINED: {
+            stageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+            accessMask = isSource ? VK_ACCESS_2_MEMORY_WRITE_BIT_KHR : (VK_ACCESS_2_MEMORY_READ_BIT_KHR | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR);
+        } break;
+
+        case grfx::RESOURCE_STATE_GENERAL: {
+            stageMask  = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+            accessMask = VK_ACCESS_2_MEMORY_READ_BIT_KHR | VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_CONSTANT_BUFFER: {
+            stageMask  = PIPELINE_STAGE_ALL_SHADER_STAGES;
+            accessMask = VK_ACCESS_2_UNIFORM_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_VERTEX_BUFFER: {
+            stageMask  = VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT_KHR;
+            accessMask = VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_INDEX_BUFFER: {
+            stageMask  = VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT_KHR;
+            accessMask = VK_ACCESS_2_INDEX_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_RENDER_TARGET: {
+            stageMask  = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR;
+            accessMask = VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_UNORDERED_ACCESS: {
+            stageMask  = PIPELINE_STAGE_ALL_SHADER_STAGES;
+            accessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT_KHR | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_DEPTH_STENCIL_READ: {
+            stageMask  = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+            accessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_DEPTH_STENCIL_WRITE:
+        case grfx::RESOURCE_STATE_DEPTH_WRITE_STENCIL_READ:
+        case grfx::RESOURCE_STATE_DEPTH_READ_STENCIL_WRITE: {
+            stageMask  = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR;
+            accessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE: {
+            stageMask  = PIPELINE_STAGE_NON_PIXEL_SHADER_STAGES;
+            accessMask = ACCESS_SHADER_RESOURCE_READ;
+        } break;
+
+        case grfx::RESOURCE_STATE_SHADER_RESOURCE: {
+            stageMask  = PIPELINE_STAGE_ALL_SHADER_STAGES;
+            accessMask = ACCESS_SHADER_RESOURCE_READ;
+        } break;
+
+        case grfx::RESOURCE_STATE_PIXEL_SHADER_RESOURCE: {
+            stageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR;
+            accessMask = ACCESS_SHADER_RESOURCE_READ;
+        } break;
+
+        case grfx::RESOURCE_STATE_STREAM_OUT: {
+            stageMask  = VK_PIPELINE_STAGE_2_TRANSFORM_FEEDBACK_BIT_EXT;
+            accessMask = VK_ACCESS_2_TRANSFORM_FEEDBACK_WRITE_BIT_EXT;
+        } break;
+
+        case grfx::RESOURCE_STATE_INDIRECT_ARGUMENT: {
+            stageMask  = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT_KHR;
+            accessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_COPY_SRC: {
+            stageMask  = VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR;
+            accessMask = VK_ACCESS_2_TRANSFER_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_COPY_DST: {
+            stageMask  = VK_PIPELINE_STAGE_2_COPY_BIT_KHR | VK_PIPELINE_STAGE_2_BLIT_BIT_KHR | VK_PIPELINE_STAGE_2_CLEAR_BIT_KHR;
+            accessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_RESOLVE_SRC: {
+            stageMask  = VK_PIPELINE_STAGE_2_RESOLVE_BIT_KHR;
+            accessMask = VK_ACCESS_2_TRANSFER_READ_BIT_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_RESOLVE_DST: {
+            stageMask  = VK_PIPELINE_STAGE_2_RESOLVE_BIT_KHR;
+            accessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR;
+        } break;
+
+        // Visibility with the presentation engine comes from the semaphores,
+        // which wait and signal at ALL_COMMANDS in the synchronization2 submit
+        // path. So the source stage only needs to chain with the wait and the
+        // destination can be NONE.
+        case grfx::RESOURCE_STATE_PRESENT: {
+            stageMask  = isSource ? VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR : VK_PIPELINE_STAGE_2_NONE_KHR;
+            accessMask = VK_ACCESS_2_NONE_KHR;
+        } break;
+
+        case grfx::RESOURCE_STATE_PREDICATION: {
+            stageMask  = VK_PIPELINE_STAGE_2_CONDITIONAL_RENDERING_BIT_EXT;
+            accessMask = VK_ACCESS_2_CONDITIONAL_RENDERING_READ_BIT_EXT;
+        } break;
+
+        case grfx::RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE: {
+#if defined(VK_KHR_acceleration_structure)
+            stageMask  = VK_PIPELINE_STAGE_2_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | PIPELINE_STAGE_ALL_SHADER_STAGES;
+            accessMask = VK_ACCESS_2_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_2_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+#else
+            stageMask  = InvalidValue<VkPipelineStageFlags2KHR>();
+            accessMask = InvalidValue<VkAccessFlags2KHR>();
+#endif
+        } break;
+
+        case grfx::RESOURCE_STATE_FRAGMENT_DENSITY_MAP_ATTACHMENT: {
+            stageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_DENSITY_PROCESS_BIT_EXT;
+            accessMask = VK_ACCESS_2_FRAGMENT_DENSITY_MAP_READ_BIT_EXT;
+        } break;
+
+        case grfx::RESOURCE_STATE_FRAGMENT_SHADING_RATE_ATTACHMENT: {
+            stageMask  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+            accessMask = VK_ACCESS_2_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR;
+        } break;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result ToVkBarrierSrc2(
+    ResourceState                   state,
+    grfx::CommandType               commandType,
+    const VkPhysicalDeviceFeatures& features,
+    VkPipelineStageFlags2KHR&       stageMask,
+    VkAccessFlags2KHR&              accessMask,
+    VkImageLayout&                  layout)
+{
+    return ToVkBarrier2(state, commandType, features, true, stageMask, accessMask, layout);
+}
+
+Result ToVkBarrierDst2(
+    ResourceState                   state,
+    grfx::CommandType               commandType,
+    const VkPhysicalDeviceFeatures& features,
+    VkPipelineStageFlags2KHR&       stageMask,
+    VkAccessFlags2KHR&              accessMask,
+    VkImageLayout&                  layout)
+{
+    return ToVkBarrier2(state, commandType, features, false, stageMask, accessMask, layout);
+}
+#endif // defined(VK_KHR_synchronization2)
+
 VkImageAspectFlags DetermineAspectMask(VkFormat format)
 {
     // clang-format off
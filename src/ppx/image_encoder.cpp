@@ -0,0 +1,879 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/image_encoder.h"
+#include "ppx/platform.h"
+#include "ppx/ppm_export.h"
+#include "ppx/string_util.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <queue>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PPX_IMAGE_ENCODER_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PPX_IMAGE_ENCODER_NEON
+#include <arm_neon.h>
+#endif
+
+// GCC and Clang only emit SIMD instructions the target allows, MSVC emits
+// any intrinsic
+#if defined(PPX_IMAGE_ENCODER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PPX_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+#define PPX_TARGET_SSSE3
+#endif
+
+namespace ppx {
+
+namespace {
+
+// -------------------------------------------------------------------------------------------------
+// Format conversion
+// -------------------------------------------------------------------------------------------------
+
+// Byte offsets of R, G and B in a texel, -1 if the format doesn't have them
+struct RowLayout
+{
+    uint32_t bytesPerTexel = 0;
+    int32_t  offsets[3]    = {-1, -1, -1};
+    uint8_t  signFlip      = 0; // XORed into present components of signed formats
+};
+
+using ConvertRowFn = void (*)(const uint8_t*, const RowLayout&, uint8_t*, uint32_t);
+
+void ConvertRowScalar(const uint8_t* pSrc, const RowLayout& layout, uint8_t* pDst, uint32_t width)
+{
+    for (uint32_t x = 0; x < width; ++x) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            pDst[c] = (layout.offsets[c] >= 0) ? (pSrc[layout.offsets[c]] ^ layout.signFlip) : 0;
+        }
+        pSrc += layout.bytesPerTexel;
+        pDst += 3;
+    }
+}
+
+#if defined(PPX_IMAGE_ENCODER_X86)
+// 4 byte texels only
+PPX_TARGET_SSSE3 void ConvertRow4Ssse3(const uint8_t* pSrc, const RowLayout& layout, uint8_t* pDst, uint32_t width)
+{
+    alignas(16) int8_t shuffle[16];
+    alignas(16) int8_t flip[16];
+    for (uint32_t i = 0; i < 16; ++i) {
+        const uint32_t pixel = i / 3;
+        const uint32_t c     = i % 3;
+        const bool     valid = (i < 12) && (layout.offsets[c] >= 0);
+        shuffle[i]           = valid ? static_cast<int8_t>(pixel * 4 + layout.offsets[c]) : -1;
+        flip[i]              = valid ? static_cast<int8_t>(layout.signFlip) : 0;
+    }
+    const __m128i kShuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffle));
+    const __m128i kFlip    = _mm_load_si128(reinterpret_cast<const __m128i*>(flip));
+
+    // Each 16 byte store holds 4 pixels and 4 bytes that the next store
+    // overwrites, stop while the store stays inside the row
+    uint32_t x = 0;
+    for (; ((x + 4) * 3 + 4) <= (width * 3); x += 4) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc + x * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pDst + x * 3), _mm_xor_si128(_mm_shuffle_epi8(v, kShuffle), kFlip));
+    }
+    ConvertRowScalar(pSrc + x * 4, layout, pDst + x * 3, width - x);
+}
+#endif // defined(PPX_IMAGE_ENCODER_X86)
+
+#if defined(PPX_IMAGE_ENCODER_NEON)
+// 4 byte texels only
+void ConvertRow4Neon(const uint8_t* pSrc, const RowLayout& layout, uint8_t* pDst, uint32_t width)
+{
+    const uint8x16_t kZero = vdupq_n_u8(0);
+    const uint8x16_t kFlip = vdupq_n_u8(layout.signFlip);
+
+    uint32_t x = 0;
+    for (; (x + 16) <= width; x += 16) {
+        const uint8x16x4_t v   = vld4q_u8(pSrc + x * 4);
+        uint8x16x3_t       rgb = {};
+        for (uint32_t c = 0; c < 3; ++c) {
+            rgb.val[c] = (layout.offsets[c] >= 0) ? veorq_u8(v.val[layout.offsets[c]], kFlip) : kZero;
+        }
+        vst3q_u8(pDst + x * 3, rgb);
+    }
+    ConvertRowScalar(pSrc + x * 4, layout, pDst + x * 3, width - x);
+}
+#endif // defined(PPX_IMAGE_ENCODER_NEON)
+
+ConvertRowFn SelectConvertRow4()
+{
+#if defined(PPX_IMAGE_ENCODER_X86)
+    if (Platform::GetCpuInfo().GetFeatures().ssse3) {
+        return ConvertRow4Ssse3;
+    }
+#elif defined(PPX_IMAGE_ENCODER_NEON)
+    return ConvertRow4Neon;
+#endif
+    return ConvertRowScalar;
+}
+
+bool IsSupportedFormat(const grfx::FormatDesc* pDesc)
+{
+    return (pDesc->layout == grfx::FORMAT_LAYOUT_LINEAR) &&
+           (pDesc->dataType != grfx::FORMAT_DATA_TYPE_FLOAT) &&
+           (pDesc->bytesPerComponent == 1) &&
+           ((pDesc->componentBits & grfx::FORMAT_COMPONENT_RED_GREEN_BLUE) != 0);
+}
+
+// -------------------------------------------------------------------------------------------------
+// Checksums
+// -------------------------------------------------------------------------------------------------
+
+uint32_t Crc32(uint32_t crc, const uint8_t* pData, size_t size)
+{
+    static const std::array<uint32_t, 256> sTable = [] {
+        std::array<uint32_t, 256> table = {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (uint32_t k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = sTable[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t Adler32(const uint8_t* pData, size_t size)
+{
+    // Largest run of bytes whose sums can't overflow 32 bits before the modulo
+    const size_t kMaxRun = 5552;
+
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (size > 0) {
+        const size_t run = std::min(size, kMaxRun);
+        for (size_t i = 0; i < run; ++i) {
+            a += pData[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        pData += run;
+        size -= run;
+    }
+    return (b << 16) | a;
+}
+
+void AppendU32BE(std::vector<uint8_t>& output, uint32_t value)
+{
+    output.push_back(static_cast<uint8_t>(value >> 24));
+    output.push_back(static_cast<uint8_t>(value >> 16));
+    output.push_back(static_cast<uint8_t>(value >> 8));
+    output.push_back(static_cast<uint8_t>(value));
+}
+
+// -------------------------------------------------------------------------------------------------
+// Deflate
+// -------------------------------------------------------------------------------------------------
+
+const uint32_t kMaxMatchLength      = 258;
+const uint32_t kMaxMatchDistance    = 32768;
+const uint32_t kMinMatchLength      = 4;
+const uint32_t kHashBits            = 15;
+const uint32_t kBlockSymbolCount    = 1 << 16;
+const uint32_t kLiteralCodeCount    = 286;
+const uint32_t kDistanceCodeCount   = 30;
+const uint32_t kCodeLengthCodeCount = 19;
+const uint32_t kEndOfBlock          = 256;
+const uint32_t kMatchFlag           = 0x80000000;
+
+const uint8_t kCodeLengthOrder[kCodeLengthCodeCount] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+uint32_t FloorLog2(uint32_t value)
+{
+    uint32_t n = 0;
+    while (value >>= 1) {
+        ++n;
+    }
+    return n;
+}
+
+// Length symbol, extra bits and their value of a match length in [3, 258]
+void GetLengthCode(uint32_t length, uint32_t* pSymbol, uint32_t* pExtraBits, uint32_t* pExtra)
+{
+    if (length == kMaxMatchLength) {
+        *pSymbol    = 285;
+        *pExtraBits = 0;
+        *pExtra     = 0;
+        return;
+    }
+    const uint32_t v = length - 3;
+    if (v < 8) {
+        *pSymbol    = 257 + v;
+        *pExtraBits = 0;
+        *pExtra     = 0;
+        return;
+    }
+    const uint32_t n = FloorLog2(v);
+    *pSymbol         = 257 + 4 * (n - 1) + ((v >> (n - 2)) & 3);
+    *pExtraBits      = n - 2;
+    *pExtra          = v & ((1u << (n - 2)) - 1);
+}
+
+// Distance symbol, extra bits and their value of a distance in [1, 32768]
+void GetDistanceCode(uint32_t distance, uint32_t* pSymbol, uint32_t* pExtraBits, uint32_t* pExtra)
+{
+    const uint32_t v = distance - 1;
+    if (v < 4) {
+        *pSymbol    = v;
+        *pExtraBits = 0;
+        *pExtra     = 0;
+        return;
+    }
+    const uint32_t n = FloorLog2(v);
+    *pSymbol         = 2 * n + ((v >> (n - 1)) & 1);
+    *pExtraBits      = n - 1;
+    *pExtra          = v & ((1u << (n - 1)) - 1);
+}
+
+// Code lengths of at most maxLength bits for the symbols with a non zero
+// frequency. Lengths over the limit are shortened the way miniz does it,
+// by moving leaves down the tree until the Kraft sum is 1 again.
+void BuildCodeLengths(const uint32_t* pFrequencies, uint32_t symbolCount, uint32_t maxLength, uint8_t* pLengths)
+{
+    std::fill(pLengths, pLengths + symbolCount, static_cast<uint8_t>(0));
+
+    std::vector<uint32_t> symbols;
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+        if (pFrequencies[i] > 0) {
+            symbols.push_back(i);
+        }
+    }
+
+    // A single code still needs a sibling to form a complete tree
+    if (symbols.size() < 2) {
+        const uint32_t symbol = symbols.empty() ? 0 : symbols[0];
+        pLengths[symbol]                = 1;
+        pLengths[(symbol == 0) ? 1 : 0] = 1;
+        return;
+    }
+
+    // Huffman tree, leaves are [0, n) and parents [n, 2n - 1)
+    const uint32_t        leafCount = CountU32(symbols);
+    std::vector<uint32_t> parents(2 * leafCount - 1, 0);
+    using Node = std::pair<uint64_t, uint32_t>;
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+    for (uint32_t i = 0; i < leafCount; ++i) {
+        queue.push({pFrequencies[symbols[i]], i});
+    }
+    uint32_t nextNode = leafCount;
+    while (queue.size() > 1) {
+        const Node a = queue.top();
+        queue.pop();
+        const Node b = queue.top();
+        queue.pop();
+        parents[a.second] = nextNode;
+        parents[b.second] = nextNode;
+        queue.push({a.first + b.first, nextNode++});
+    }
+
+    // Parents are created after their children, so depths resolve root first
+    const uint32_t        root = nextNode - 1;
+    std::vector<uint32_t> depths(nextNode, 0);
+    for (uint32_t node = root; node-- > 0;) {
+        depths[node] = depths[parents[node]] + 1;
+    }
+
+    std::vector<uint32_t> lengthCounts(maxLength + 1, 0);
+    for (uint32_t i = 0; i < leafCount; ++i) {
+        ++lengthCounts[std::min(depths[i], maxLength)];
+    }
+
+    uint32_t kraft = 0;
+    for (uint32_t length = 1; length <= maxLength; ++length) {
+        kraft += lengthCounts[length] << (maxLength - length);
+    }
+    while (kraft != (1u << maxLength)) {
+        --lengthCounts[maxLength];
+        for (uint32_t length = maxLength - 1; length > 0; --length) {
+            if (lengthCounts[length] > 0) {
+                --lengthCounts[length];
+                lengthCounts[length + 1] += 2;
+                break;
+            }
+        }
+        --kraft;
+    }
+
+    // Most frequent symbols get the shortest codes
+    std::stable_sort(symbols.begin(), symbols.end(), [pFrequencies](uint32_t a, uint32_t b) { return pFrequencies[a] > pFrequencies[b]; });
+    uint32_t next = 0;
+    for (uint32_t length = 1; length <= maxLength; ++length) {
+        for (uint32_t i = 0; i < lengthCounts[length]; ++i) {
+            pLengths[symbols[next++]] = static_cast<uint8_t>(length);
+        }
+    }
+}
+
+// Canonical codes, bit reversed since deflate writes codes from their
+// most significant bit but packs bits from the least significant one
+void BuildCodes(const uint8_t* pLengths, uint32_t symbolCount, uint16_t* pCodes)
+{
+    uint32_t lengthCounts[16] = {};
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+        ++lengthCounts[pLengths[i]];
+    }
+    lengthCounts[0] = 0;
+
+    uint32_t nextCodes[16] = {};
+    uint32_t code          = 0;
+    for (uint32_t length = 1; length < 16; ++length) {
+        code              = (code + lengthCounts[length - 1]) << 1;
+        nextCodes[length] = code;
+    }
+
+    for (uint32_t i = 0; i < symbolCount; ++i) {
+        const uint32_t length = pLengths[i];
+        if (length == 0) {
+            pCodes[i] = 0;
+            continue;
+        }
+        const uint32_t value    = nextCodes[length]++;
+        uint32_t       reversed = 0;
+        for (uint32_t bit = 0; bit < length; ++bit) {
+            reversed |= ((value >> bit) & 1) << (length - 1 - bit);
+        }
+        pCodes[i] = static_cast<uint16_t>(reversed);
+    }
+}
+
+class BitWriter
+{
+public:
+    // Appends to pOutput, which holds spare bytes until Flush()
+    BitWriter(std::vector<uint8_t>* pOutput)
+        : mOutput(pOutput), mSize(pOutput->size()) {}
+
+    // count is at most 16
+    void Put(uint32_t value, uint32_t count)
+    {
+        mBits |= static_cast<uint64_t>(value) << mCount;
+        mCount += count;
+        if (mCount >= 32) {
+            if ((mSize + 4) > mOutput->size()) {
+                mOutput->resize(std::max<size_t>(2 * mOutput->size(), 4096));
+            }
+            uint8_t* pDst = mOutput->data() + mSize;
+            for (uint32_t i = 0; i < 4; ++i) {
+                pDst[i] = static_cast<uint8_t>(mBits >> (8 * i));
+            }
+            mSize += 4;
+            mBits >>= 32;
+            mCount -= 32;
+        }
+    }
+
+    void Flush()
+    {
+        mOutput->resize(mSize);
+        while (mCount > 0) {
+            mOutput->push_back(static_cast<uint8_t>(mBits));
+            mBits >>= 8;
+            mCount = (mCount > 8) ? (mCount - 8) : 0;
+        }
+        mSize = mOutput->size();
+        mBits = 0;
+    }
+
+private:
+    std::vector<uint8_t>* mOutput = nullptr;
+    size_t                mSize   = 0; // Bytes written to mOutput
+    uint64_t              mBits   = 0;
+    uint32_t              mCount  = 0;
+};
+
+// Writes one dynamic Huffman block. Symbols are literals, or kMatchFlag
+// with the length in bits 16-24 and the distance in bits 0-15 minus 1.
+void WriteBlock(BitWriter& writer, const std::vector<uint32_t>& symbols, bool last)
+{
+    uint32_t literalFrequencies[kLiteralCodeCount]   = {};
+    uint32_t distanceFrequencies[kDistanceCodeCount] = {};
+    for (uint32_t symbol : symbols) {
+        uint32_t code = 0, extraBits = 0, extra = 0;
+        if (symbol & kMatchFlag) {
+            GetLengthCode((symbol >> 16) & 0x1FF, &code, &extraBits, &extra);
+            ++literalFrequencies[code];
+            GetDistanceCode((symbol & 0xFFFF) + 1, &code, &extraBits, &extra);
+            ++distanceFrequencies[code];
+        }
+        else {
+            ++literalFrequencies[symbol];
+        }
+    }
+    literalFrequencies[kEndOfBlock] = 1;
+
+    uint8_t  literalLengths[kLiteralCodeCount];
+    uint8_t  distanceLengths[kDistanceCodeCount];
+    uint16_t literalCodes[kLiteralCodeCount];
+    uint16_t distanceCodes[kDistanceCodeCount];
+    BuildCodeLengths(literalFrequencies, kLiteralCodeCount, 15, literalLengths);
+    BuildCodeLengths(distanceFrequencies, kDistanceCodeCount, 15, distanceLengths);
+    BuildCodes(literalLengths, kLiteralCodeCount, literalCodes);
+    BuildCodes(distanceLengths, kDistanceCodeCount, distanceCodes);
+
+    uint32_t literalCount = kLiteralCodeCount;
+    while ((literalCount > 257) && (literalLengths[literalCount - 1] == 0)) {
+        --literalCount;
+    }
+    uint32_t distanceCount = kDistanceCodeCount;
+    while ((distanceCount > 1) && (distanceLengths[distanceCount - 1] == 0)) {
+        --distanceCount;
+    }
+
+    // Run length encode both length arrays as one sequence, entries are
+    // the code length symbol in the low byte and its extra value above
+    std::vector<uint8_t> lengths(literalLengths, literalLengths + literalCount);
+    lengths.insert(lengths.end(), distanceLengths, distanceLengths + distanceCount);
+
+    std::vector<uint32_t> lengthSymbols;
+    uint32_t              lengthFrequencies[kCodeLengthCodeCount] = {};
+    for (size_t i = 0; i < lengths.size();) {
+        const uint8_t length = lengths[i];
+        uint32_t      run    = 1;
+        while (((i + run) < lengths.size()) && (lengths[i + run] == length)) {
+            ++run;
+        }
+        i += run;
+
+        if (length == 0) {
+            while (run >= 11) {
+                const uint32_t count = std::min<uint32_t>(run, 138);
+                lengthSymbols.push_back(18 | ((count - 11) << 8));
+                run -= count;
+            }
+            if (run >= 3) {
+                lengthSymbols.push_back(17 | ((run - 3) << 8));
+                run = 0;
+            }
+        }
+        else {
+            lengthSymbols.push_back(length);
+            --run;
+            while (run >= 3) {
+                const uint32_t count = std::min<uint32_t>(run, 6);
+                lengthSymbols.push_back(16 | ((count - 3) << 8));
+                run -= count;
+            }
+        }
+        for (; run > 0; --run) {
+            lengthSymbols.push_back(length);
+        }
+    }
+    for (uint32_t symbol : lengthSymbols) {
+        ++lengthFrequencies[symbol & 0xFF];
+    }
+
+    uint8_t  codeLengthLengths[kCodeLengthCodeCount];
+    uint16_t codeLengthCodes[kCodeLengthCodeCount];
+    BuildCodeLengths(lengthFrequencies, kCodeLengthCodeCount, 7, codeLengthLengths);
+    BuildCodes(codeLengthLengths, kCodeLengthCodeCount, codeLengthCodes);
+
+    uint32_t codeLengthCount = kCodeLengthCodeCount;
+    while ((codeLengthCount > 4) && (codeLengthLengths[kCodeLengthOrder[codeLengthCount - 1]] == 0)) {
+        --codeLengthCount;
+    }
+
+    // Block header
+    writer.Put(last ? 1 : 0, 1);
+    writer.Put(2, 2);
+    writer.Put(literalCount - 257, 5);
+    writer.Put(distanceCount - 1, 5);
+    writer.Put(codeLengthCount - 4, 4);
+    for (uint32_t i = 0; i < codeLengthCount; ++i) {
+        writer.Put(codeLengthLengths[kCodeLengthOrder[i]], 3);
+    }
+    for (uint32_t symbol : lengthSymbols) {
+        const uint32_t code = symbol & 0xFF;
+        writer.Put(codeLengthCodes[code], codeLengthLengths[code]);
+        // clang-format off
+        switch (code) {
+            default: break;
+            case 16 : writer.Put(symbol >> 8, 2); break;
+            case 17 : writer.Put(symbol >> 8, 3); break;
+            case 18 : writer.Put(symbol >> 8, 7); break;
+        }
+        // clang-format on
+    }
+
+    // Data
+    for (uint32_t symbol : symbols) {
+        if (symbol & kMatchFlag) {
+            uint32_t code = 0, extraBits = 0, extra = 0;
+            GetLengthCode((symbol >> 16) & 0x1FF, &code, &extraBits, &extra);
+            writer.Put(literalCodes[code], literalLengths[code]);
+            writer.Put(extra, extraBits);
+            GetDistanceCode((symbol & 0xFFFF) + 1, &code, &extraBits, &extra);
+            writer.Put(distanceCodes[code], distanceLengths[code]);
+            writer.Put(extra, extraBits);
+        }
+        else {
+            writer.Put(literalCodes[symbol], literalLengths[symbol]);
+        }
+    }
+    writer.Put(literalCodes[kEndOfBlock], literalLengths[kEndOfBlock]);
+}
+
+uint32_t Load32(const uint8_t* pData)
+{
+    uint32_t value = 0;
+    std::memcpy(&value, pData, sizeof(value));
+    return value;
+}
+
+// Greedy LZ77 with a single candidate per hash, like LZ4. Matches are only
+// looked up at literals, so long runs cost one probe.
+void Deflate(const uint8_t* pData, size_t size, std::vector<uint8_t>* pOutput)
+{
+    BitWriter             writer(pOutput);
+    std::vector<uint32_t> table(1u << kHashBits, 0); // Position + 1, 0 if empty
+    std::vector<uint32_t> symbols;
+    symbols.reserve(kBlockSymbolCount);
+
+    size_t pos = 0;
+    while (pos < size) {
+        uint32_t length = 0;
+        uint32_t match  = 0;
+        if ((pos + kMinMatchLength) <= size) {
+            const uint32_t value     = Load32(pData + pos);
+            const uint32_t hash      = (value * 2654435761u) >> (32 - kHashBits);
+            const uint32_t candidate = table[hash];
+            table[hash]              = static_cast<uint32_t>(pos + 1);
+            if ((candidate > 0) && ((pos - (candidate - 1)) <= kMaxMatchDistance) && (Load32(pData + candidate - 1) == value)) {
+                match                    = candidate - 1;
+                const uint32_t maxLength = static_cast<uint32_t>(std::min<size_t>(kMaxMatchLength, size - pos));
+                length                   = kMinMatchLength;
+                while ((length < maxLength) && (pData[match + length] == pData[pos + length])) {
+                    ++length;
+                }
+            }
+        }
+
+        if (length > 0) {
+            symbols.push_back(kMatchFlag | (length << 16) | static_cast<uint32_t>(pos - match - 1));
+            pos += length;
+        }
+        else {
+            symbols.push_back(pData[pos]);
+            ++pos;
+        }
+
+        if (symbols.size() == kBlockSymbolCount) {
+            WriteBlock(writer, symbols, pos == size);
+            symbols.clear();
+        }
+    }
+    if (!symbols.empty() || (size == 0)) {
+        WriteBlock(writer, symbols, true);
+    }
+    writer.Flush();
+}
+
+void AppendChunk(std::vector<uint8_t>& output, const char* type, const uint8_t* pData, uint32_t size)
+{
+    AppendU32BE(output, size);
+    const size_t typeOffset = output.size();
+    output.insert(output.end(), type, type + 4);
+    output.insert(output.end(), pData, pData + size);
+    AppendU32BE(output, Crc32(0, output.data() + typeOffset, size + 4));
+}
+
+} // namespace
+
+ImageFileFormat GetImageFileFormat(const std::filesystem::path& path)
+{
+    const std::string extension = string_util::ToLowerCopy(path.extension().string());
+    if (extension == ".png") {
+        return IMAGE_FILE_FORMAT_PNG;
+    }
+    if (extension == ".qoi") {
+        return IMAGE_FILE_FORMAT_QOI;
+    }
+    return IMAGE_FILE_FORMAT_PPM;
+}
+
+Result ConvertToRGB8(grfx::Format format, const void* pTexels, uint32_t width, uint32_t height, uint32_t rowPitch, uint8_t* pDst)
+{
+    PPX_ASSERT_NULL_ARG(pTexels);
+    PPX_ASSERT_NULL_ARG(pDst);
+
+    const grfx::FormatDesc* pDesc = grfx::GetFormatDescription(format);
+    if (!IsSupportedFormat(pDesc)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+    PPX_ASSERT_MSG(rowPitch >= (pDesc->bytesPerTexel * width), "row pitch must be at least equal to texel size * width");
+
+    RowLayout layout     = {};
+    layout.bytesPerTexel = pDesc->bytesPerTexel;
+    layout.offsets[0]    = (pDesc->componentBits & grfx::FORMAT_COMPONENT_RED) ? pDesc->componentOffset.red : -1;
+    layout.offsets[1]    = (pDesc->componentBits & grfx::FORMAT_COMPONENT_GREEN) ? pDesc->componentOffset.green : -1;
+    layout.offsets[2]    = (pDesc->componentBits & grfx::FORMAT_COMPONENT_BLUE) ? pDesc->componentOffset.blue : -1;
+    layout.signFlip      = ((pDesc->dataType == grfx::FORMAT_DATA_TYPE_SNORM) || (pDesc->dataType == grfx::FORMAT_DATA_TYPE_SINT)) ? 0x80 : 0;
+
+    const bool isRGB8 = (layout.bytesPerTexel == 3) && (layout.offsets[0] == 0) && (layout.offsets[1] == 1) && (layout.offsets[2] == 2) && (layout.signFlip == 0);
+
+    static const ConvertRowFn sConvertRow4 = SelectConvertRow4();
+    const ConvertRowFn        convertRow   = (layout.bytesPerTexel == 4) ? sConvertRow4 : ConvertRowScalar;
+
+    const uint8_t* pSrc = static_cast<const uint8_t*>(pTexels);
+    for (uint32_t y = 0; y < height; ++y) {
+        if (isRGB8) {
+            std::memcpy(pDst, pSrc, width * 3);
+        }
+        else {
+            convertRow(pSrc, layout, pDst, width);
+        }
+        pSrc += rowPitch;
+        pDst += width * 3;
+    }
+
+    return ppx::SUCCESS;
+}
+
+Result EncodePNG(const void* pPixels, uint32_t width, uint32_t height, uint32_t rowStride, uint32_t channelCount, std::vector<uint8_t>* pOutput)
+{
+    PPX_ASSERT_NULL_ARG(pPixels);
+    PPX_ASSERT_NULL_ARG(pOutput);
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((channelCount == 0) || (channelCount > 4)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    // Rows are prefixed with their filter type. The first row subtracts the
+    // pixel to the left, the others the pixel above. A fixed filter loses
+    // a little compression against a per row choice but costs one pass.
+    const size_t         rowSize = static_cast<size_t>(width) * channelCount;
+    std::vector<uint8_t> filtered((rowSize + 1) * height);
+    const uint8_t*       pSrc    = static_cast<const uint8_t*>(pPixels);
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t*       pDst = filtered.data() + y * (rowSize + 1) + 1;
+        const uint8_t* pRow = pSrc + static_cast<size_t>(y) * rowStride;
+        if (y == 0) {
+            pDst[-1] = 1;
+            std::memcpy(pDst, pRow, channelCount);
+            for (size_t i = channelCount; i < rowSize; ++i) {
+                pDst[i] = static_cast<uint8_t>(pRow[i] - pRow[i - channelCount]);
+            }
+        }
+        else {
+            const uint8_t* pAbove = pRow - rowStride;
+            pDst[-1]              = 2;
+            for (size_t i = 0; i < rowSize; ++i) {
+                pDst[i] = static_cast<uint8_t>(pRow[i] - pAbove[i]);
+            }
+        }
+    }
+
+    // zlib stream: header without a preset dictionary, deflate, Adler-32
+    std::vector<uint8_t> zlib;
+    zlib.reserve(filtered.size() / 2);
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+    Deflate(filtered.data(), filtered.size(), &zlib);
+    AppendU32BE(zlib, Adler32(filtered.data(), filtered.size()));
+
+    if (zlib.size() > static_cast<size_t>(INT32_MAX)) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    // Gray, gray and alpha, RGB, RGBA
+    const uint8_t kColorTypes[4] = {0, 4, 2, 6};
+
+    uint8_t header[13] = {};
+    for (uint32_t i = 0; i < 4; ++i) {
+        header[i]     = static_cast<uint8_t>(width >> (24 - 8 * i));
+        header[4 + i] = static_cast<uint8_t>(height >> (24 - 8 * i));
+    }
+    header[8] = 8; // Bit depth
+    header[9] = kColorTypes[channelCount - 1];
+
+    static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::vector<uint8_t>& output = *pOutput;
+    output.clear();
+    output.reserve(zlib.size() + 64);
+    output.insert(output.end(), kSignature, kSignature + 8);
+    AppendChunk(output, "IHDR", header, sizeof(header));
+    AppendChunk(output, "IDAT", zlib.data(), static_cast<uint32_t>(zlib.size()));
+    AppendChunk(output, "IEND", nullptr, 0);
+
+    return ppx::SUCCESS;
+}
+
+Result EncodeQOI(const void* pPixels, uint32_t width, uint32_t height, uint32_t rowStride, uint32_t channelCount, std::vector<uint8_t>* pOutput)
+{
+    PPX_ASSERT_NULL_ARG(pPixels);
+    PPX_ASSERT_NULL_ARG(pOutput);
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if ((channelCount != 3) && (channelCount != 4)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const uint8_t kOpIndex = 0x00;
+    const uint8_t kOpDiff  = 0x40;
+    const uint8_t kOpLuma  = 0x80;
+    const uint8_t kOpRun   = 0xC0;
+    const uint8_t kOpRGB   = 0xFE;
+    const uint8_t kOpRGBA  = 0xFF;
+
+    std::vector<uint8_t>& output = *pOutput;
+    output.clear();
+    // Worst case is a full RGBA op per pixel
+    output.resize(14 + static_cast<size_t>(width) * height * (channelCount + 1) + 8);
+
+    uint8_t* pOut = output.data();
+    std::memcpy(pOut, "qoif", 4);
+    for (uint32_t i = 0; i < 4; ++i) {
+        pOut[4 + i] = static_cast<uint8_t>(width >> (24 - 8 * i));
+        pOut[8 + i] = static_cast<uint8_t>(height >> (24 - 8 * i));
+    }
+    pOut[12] = static_cast<uint8_t>(channelCount);
+    pOut[13] = 0; // sRGB with linear alpha, informative only
+    pOut += 14;
+
+    uint32_t index[64] = {};
+    uint8_t  prev[4]   = {0, 0, 0, 255};
+    uint8_t  px[4]     = {0, 0, 0, 255};
+    uint32_t run       = 0;
+
+    const uint8_t* pSrc = static_cast<const uint8_t*>(pPixels);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* pRow = pSrc + static_cast<size_t>(y) * rowStride;
+        for (uint32_t x = 0; x < width; ++x, pRow += channelCount) {
+            std::memcpy(px, pRow, channelCount);
+
+            if (std::memcmp(px, prev, 4) == 0) {
+                ++run;
+                if (run == 62) {
+                    *pOut++ = kOpRun | static_cast<uint8_t>(run - 1);
+                    run     = 0;
+                }
+                continue;
+            }
+
+            if (run > 0) {
+                *pOut++ = kOpRun | static_cast<uint8_t>(run - 1);
+                run     = 0;
+            }
+
+            uint32_t value = 0;
+            std::memcpy(&value, px, 4);
+            const uint32_t hash = (px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64;
+            if (index[hash] == value) {
+                *pOut++ = kOpIndex | static_cast<uint8_t>(hash);
+            }
+            else {
+                index[hash] = value;
+                if (px[3] == prev[3]) {
+                    const int8_t dr   = static_cast<int8_t>(px[0] - prev[0]);
+                    const int8_t dg   = static_cast<int8_t>(px[1] - prev[1]);
+                    const int8_t db   = static_cast<int8_t>(px[2] - prev[2]);
+                    const int8_t drDg = static_cast<int8_t>(dr - dg);
+                    const int8_t dbDg = static_cast<int8_t>(db - dg);
+                    if ((dr >= -2) && (dr <= 1) && (dg >= -2) && (dg <= 1) && (db >= -2) && (db <= 1)) {
+                        *pOut++ = kOpDiff | static_cast<uint8_t>(((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                    }
+                    else if ((dg >= -32) && (dg <= 31) && (drDg >= -8) && (drDg <= 7) && (dbDg >= -8) && (dbDg <= 7)) {
+                        *pOut++ = kOpLuma | static_cast<uint8_t>(dg + 32);
+                        *pOut++ = static_cast<uint8_t>(((drDg + 8) << 4) | (dbDg + 8));
+                    }
+                    else {
+                        *pOut++ = kOpRGB;
+                        *pOut++ = px[0];
+                        *pOut++ = px[1];
+                        *pOut++ = px[2];
+                    }
+                }
+                else {
+                    *pOut++ = kOpRGBA;
+                    std::memcpy(pOut, px, 4);
+                    pOut += 4;
+                }
+            }
+            std::memcpy(prev, px, 4);
+        }
+    }
+    if (run > 0) {
+        *pOut++ = kOpRun | static_cast<uint8_t>(run - 1);
+    }
+
+    static const uint8_t kEndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+    std::memcpy(pOut, kEndMarker, 8);
+    pOut += 8;
+
+    output.resize(static_cast<size_t>(pOut - output.data()));
+
+    return ppx::SUCCESS;
+}
+
+Result WriteImageFile(const std::filesystem::path& path, grfx::Format format, const void* pTexels, uint32_t width, uint32_t height, uint32_t rowPitch)
+{
+    const ImageFileFormat fileFormat = GetImageFileFormat(path);
+    if (fileFormat == IMAGE_FILE_FORMAT_PPM) {
+        return ExportToPPM(path.string(), format, pTexels, width, height, rowPitch);
+    }
+
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+    Result               ppxres = ConvertToRGB8(format, pTexels, width, height, rowPitch, pixels.data());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    std::vector<uint8_t> encoded;
+    if (fileFormat == IMAGE_FILE_FORMAT_PNG) {
+        ppxres = EncodePNG(pixels.data(), width, height, width * 3, 3, &encoded);
+    }
+    else {
+        ppxres = EncodeQOI(pixels.data(), width, height, width * 3, 3, &encoded);
+    }
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+    file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+    if (!file) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
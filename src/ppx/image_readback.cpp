@@ -0,0 +1,266 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/image_readback.h"
+#include "ppx/image_encoder.h"
+#include "ppx/grfx/grfx_device.h"
+
+namespace ppx {
+
+ImageReadback::ImageReadback()
+{
+}
+
+ImageReadback::~ImageReadback()
+{
+    Shutdown();
+}
+
+Result ImageReadback::Initialize(const ImageReadbackCreateInfo& createInfo)
+{
+    PPX_ASSERT_NULL_ARG(createInfo.pQueue);
+    if (IsInitialized()) {
+        PPX_ASSERT_MSG(false, "image readback is already initialized");
+        return ppx::ERROR_FAILED;
+    }
+
+    mQueue   = createInfo.pQueue;
+    mOrdered = createInfo.ordered;
+
+    const uint32_t slotCount = std::max<uint32_t>(createInfo.slotCount, 1);
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        auto slot = std::make_unique<Slot>();
+
+        Result ppxres = mQueue->CreateCommandBuffer(&slot->cmd, 0, 0);
+        if (Failed(ppxres)) {
+            Shutdown();
+            return ppxres;
+        }
+
+        grfx::FenceCreateInfo fenceCreateInfo = {};
+        ppxres                                = mQueue->GetDevice()->CreateFence(&fenceCreateInfo, &slot->fence);
+        if (Failed(ppxres)) {
+            mQueue->DestroyCommandBuffer(slot->cmd);
+            Shutdown();
+            return ppxres;
+        }
+
+        mSlots.push_back(std::move(slot));
+    }
+
+    return ppx::SUCCESS;
+}
+
+void ImageReadback::Shutdown()
+{
+    if (!IsInitialized()) {
+        return;
+    }
+
+    Flush();
+
+    grfx::Device* pDevice = mQueue->GetDevice();
+    for (auto& slot : mSlots) {
+        if (slot->buffer) {
+            pDevice->DestroyBuffer(slot->buffer);
+        }
+        pDevice->DestroyFence(slot->fence);
+        mQueue->DestroyCommandBuffer(slot->cmd);
+    }
+    mSlots.clear();
+    mNextSlot       = 0;
+    mLastEncodeSlot = UINT32_MAX;
+    mQueue          = nullptr;
+}
+
+Result ImageReadback::Capture(grfx::Image* pImage, grfx::ResourceState state, const std::filesystem::path& path)
+{
+    return Capture(pImage, state, path.string(), [path](const ImageReadbackData& data) {
+        Result ppxres = WriteImageFile(path, data.format, data.pTexels, data.width, data.height, data.rowPitch);
+        if (Success(ppxres)) {
+            PPX_LOG_INFO("Image saved to: " << path);
+        }
+        return ppxres;
+    });
+}
+
+Result ImageReadback::Capture(grfx::Image* pImage, grfx::ResourceState state, const std::string& name, Callback&& callback)
+{
+    PPX_ASSERT_NULL_ARG(pImage);
+    if (!IsInitialized()) {
+        PPX_ASSERT_MSG(false, "image readback is not initialized");
+        return ppx::ERROR_FAILED;
+    }
+
+    // Slots are used in order, so the next one holds the oldest capture
+    Slot& slot = *mSlots[mNextSlot];
+    while (slot.state != SLOT_STATE_FREE) {
+        Advance(mNextSlot, true);
+    }
+
+    const grfx::FormatDesc* formatDesc = grfx::GetFormatDescription(pImage->GetFormat());
+    const uint32_t          width      = pImage->GetWidth();
+    const uint32_t          height     = pImage->GetHeight();
+
+    // Twice the tight size so a larger row pitch doesn't overflow the buffer
+    const uint64_t bufferSize = 2ull * formatDesc->bytesPerTexel * width * height;
+    if (!slot.buffer || (slot.buffer->GetSize() < bufferSize)) {
+        if (slot.buffer) {
+            mQueue->GetDevice()->DestroyBuffer(slot.buffer);
+            slot.buffer.Reset();
+        }
+
+        grfx::BufferCreateInfo bufferCreateInfo      = {};
+        bufferCreateInfo.size                        = bufferSize;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+        bufferCreateInfo.usageFlags.bits.transferDst = 1;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        Result ppxres                                = mQueue->GetDevice()->CreateBuffer(&bufferCreateInfo, &slot.buffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    grfx::ImageToBufferOutputPitch outPitch;
+
+    Result ppxres = slot.cmd->Begin();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+    {
+        slot.cmd->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, state, grfx::RESOURCE_STATE_COPY_SRC);
+
+        grfx::ImageToBufferCopyInfo copyInfo = {};
+        copyInfo.extent                      = {width, height, 0};
+        outPitch                             = slot.cmd->CopyImageToBuffer(&copyInfo, pImage, slot.buffer);
+
+        slot.cmd->TransitionImageLayout(pImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_COPY_SRC, state);
+    }
+    ppxres = slot.cmd->End();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = slot.fence->Reset();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SubmitInfo submitInfo   = {};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.ppCommandBuffers   = &slot.cmd;
+    submitInfo.pFence             = slot.fence;
+    ppxres                        = mQueue->Submit(&submitInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    slot.state         = SLOT_STATE_COPYING;
+    slot.data.format   = pImage->GetFormat();
+    slot.data.width    = width;
+    slot.data.height   = height;
+    slot.data.rowPitch = outPitch.rowPitch;
+    slot.name          = name;
+    slot.callback      = std::move(callback);
+    mNextSlot          = (mNextSlot + 1) % CountU32(mSlots);
+
+    return ppx::SUCCESS;
+}
+
+void ImageReadback::Poll()
+{
+    // Oldest capture first, so ordered callbacks are queued in order
+    const uint32_t slotCount = CountU32(mSlots);
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        const uint32_t slotIndex = (mNextSlot + i) % slotCount;
+        // Encoding starts right after a copy finished
+        Advance(slotIndex, false);
+        if (mOrdered && (mSlots[slotIndex]->state == SLOT_STATE_COPYING)) {
+            break;
+        }
+        Advance(slotIndex, false);
+    }
+}
+
+void ImageReadback::Flush()
+{
+    const uint32_t slotCount = CountU32(mSlots);
+    for (uint32_t i = 0; i < slotCount; ++i) {
+        const uint32_t slotIndex = (mNextSlot + i) % slotCount;
+        while (mSlots[slotIndex]->state != SLOT_STATE_FREE) {
+            Advance(slotIndex, true);
+        }
+    }
+}
+
+uint32_t ImageReadback::GetPendingCount() const
+{
+    uint32_t count = 0;
+    for (auto& slot : mSlots) {
+        count += (slot->state != SLOT_STATE_FREE) ? 1 : 0;
+    }
+    return count;
+}
+
+void ImageReadback::Advance(uint32_t slotIndex, bool wait)
+{
+    Slot& slot = *mSlots[slotIndex];
+    switch (slot.state) {
+        default: break;
+
+        case SLOT_STATE_COPYING: {
+            if (!wait && !slot.fence->IsSignaled()) {
+                return;
+            }
+            PPX_CHECKED_CALL(slot.fence->Wait());
+
+            void*  pTexels = nullptr;
+            Result ppxres  = slot.buffer->MapMemory(0, &pTexels);
+            if (Failed(ppxres)) {
+                PPX_LOG_ERROR("failed mapping readback of " << slot.name);
+                slot.callback = nullptr;
+                slot.state    = SLOT_STATE_FREE;
+                return;
+            }
+
+            slot.data.pTexels = pTexels;
+            slot.state        = SLOT_STATE_ENCODING;
+
+            // Encoding starts in capture order, so the previous capture's
+            // slot is either free or still encoding
+            JobSystem::Job job       = [pSlot = &slot]() { pSlot->result = pSlot->callback(pSlot->data); };
+            JobCounter*    pPrevious = (mOrdered && (mLastEncodeSlot < CountU32(mSlots))) ? &mSlots[mLastEncodeSlot]->counter : nullptr;
+            JobSystem::Get()->RunAfter(pPrevious, std::move(job), &slot.counter);
+            mLastEncodeSlot = slotIndex;
+        } break;
+
+        case SLOT_STATE_ENCODING: {
+            if (!wait && !slot.counter.IsDone()) {
+                return;
+            }
+            JobSystem::Get()->Wait(&slot.counter);
+
+            slot.buffer->UnmapMemory();
+            slot.data.pTexels = nullptr;
+            slot.callback     = nullptr;
+            slot.state        = SLOT_STATE_FREE;
+
+            if (Failed(slot.result)) {
+                PPX_LOG_ERROR("failed writing " << slot.name << ": " << ToString(slot.result));
+            }
+        } break;
+    }
+}
+
+} // namespace ppx
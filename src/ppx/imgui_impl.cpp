@@ -16,6 +16,7 @@
 #include "ppx/imgui/font_inconsolata.h"
 #include "ppx/application.h"
 #include "ppx/grfx/grfx_device.h"
+#include "ppx/graphics_util.h"
 
 #if !defined(PPX_ANDROID)
 #include "backends/imgui_impl_glfw.h"
@@ -148,6 +149,469 @@ void ImGuiImpl::NewFrame()
     io.DisplaySize.x = static_cast<float>(pApp->GetUIWidth());
     io.DisplaySize.y = static_cast<float>(pApp->GetUIHeight());
     NewFrameApi();
+    mDrawDataBuilt = false;
+}
+
+void ImGuiImpl::BuildDrawData()
+{
+    if (!mDrawDataBuilt) {
+        ImGui::Render();
+        mDrawDataBuilt = true;
+    }
+}
+
+bool ImGuiImpl::PrepareDrawData()
+{
+    BuildDrawData();
+
+    // FNV-1a of everything the backends read from the draw data
+    uint64_t hash    = 14695981039346656037ull;
+    auto     hashRaw = [&hash](const void* pData, size_t size) {
+        const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ pBytes[i]) * 1099511628211ull;
+        }
+    };
+
+    const ImDrawData* pDrawData = ImGui::GetDrawData();
+    hashRaw(&pDrawData->DisplayPos, sizeof(pDrawData->DisplayPos));
+    hashRaw(&pDrawData->DisplaySize, sizeof(pDrawData->DisplaySize));
+    for (int i = 0; i < pDrawData->CmdListsCount; ++i) {
+        const ImDrawList* pList = pDrawData->CmdLists[i];
+        for (const ImDrawCmd& cmd : pList->CmdBuffer) {
+            hashRaw(&cmd.ClipRect, sizeof(cmd.ClipRect));
+            hashRaw(&cmd.TextureId, sizeof(cmd.TextureId));
+            hashRaw(&cmd.VtxOffset, sizeof(cmd.VtxOffset));
+            hashRaw(&cmd.IdxOffset, sizeof(cmd.IdxOffset));
+            hashRaw(&cmd.ElemCount, sizeof(cmd.ElemCount));
+            hashRaw(&cmd.UserCallback, sizeof(cmd.UserCallback));
+        }
+        hashRaw(pList->VtxBuffer.Data, pList->VtxBuffer.size_in_bytes());
+        hashRaw(pList->IdxBuffer.Data, pList->IdxBuffer.size_in_bytes());
+    }
+
+    const bool changed = (hash != mDrawDataHash);
+    mDrawDataHash      = hash;
+    return changed;
+}
+
+void ImGuiImpl::CountStockBackendDraws()
+{
+    mRenderStats = {};
+
+    const ImDrawData* pDrawData = ImGui::GetDrawData();
+    if (IsNull(pDrawData)) {
+        return;
+    }
+
+    mRenderStats.vertexCount = static_cast<uint32_t>(pDrawData->TotalVtxCount);
+    mRenderStats.indexCount  = static_cast<uint32_t>(pDrawData->TotalIdxCount);
+    for (int i = 0; i < pDrawData->CmdListsCount; ++i) {
+        for (const ImDrawCmd& cmd : pDrawData->CmdLists[i]->CmdBuffer) {
+            if (IsNull(cmd.UserCallback) && (cmd.ElemCount > 0)) {
+                mRenderStats.drawCount += 1;
+            }
+        }
+    }
+    mRenderStats.scissorCount     = mRenderStats.drawCount;
+    mRenderStats.textureBindCount = mRenderStats.drawCount;
+}
+
+// -------------------------------------------------------------------------------------------------
+// ImGuiImplGrfx
+// -------------------------------------------------------------------------------------------------
+
+// Transient vertex and index memory of each frame in flight
+constexpr uint64_t kImGuiFrameBufferSize = 4 * 1024 * 1024;
+constexpr uint32_t kImGuiMaxTextures     = 64;
+
+// ImTextureID is a pointer or a 64-bit integer depending on the ImGui
+// version, a C-style cast converts a heap index to and from either.
+static ImTextureID ToImTextureID(uint32_t index)
+{
+    return (ImTextureID)(static_cast<uintptr_t>(index) + 1);
+}
+
+static uint32_t ToHeapIndex(ImTextureID textureId)
+{
+    return static_cast<uint32_t>((uintptr_t)textureId) - 1;
+}
+
+struct ImGuiDrawParams
+{
+    float2   scale;
+    float2   translate;
+    uint32_t textureIndex;
+};
+
+Result ImGuiImplGrfx::InitApiObjects(ppx::Application* pApp)
+{
+#if defined(PPX_ANDROID)
+    ImGui_ImplAndroid_Init(pApp->GetAndroidContext()->window);
+#else
+    GLFWwindow* pWindow = static_cast<GLFWwindow*>(pApp->GetWindow()->NativeHandle());
+    ImGui_ImplGlfw_InitForOther(pWindow, false);
+#endif
+
+    // Setup style
+    SetColorStyle();
+
+    ImGuiIO& io            = ImGui::GetIO();
+    io.BackendRendererName = "ppx_grfx";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+
+    grfx::DevicePtr device = pApp->GetDevice();
+
+    // Bindless heap, texture slots for the font and AddTexture() plus one sampler
+    {
+        grfx::BindlessHeapCreateInfo createInfo = {};
+        createInfo.textureCapacity              = kImGuiMaxTextures;
+        createInfo.samplerCapacity              = 1;
+        createInfo.textureBinding               = 0;
+        createInfo.samplerBinding               = 1;
+        createInfo.shaderVisibility             = grfx::SHADER_STAGE_PS;
+
+        Result ppxres = device->CreateBindlessHeap(&createInfo, &mHeap);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "[imgui:grfx] failed creating bindless heap");
+            return ppxres;
+        }
+    }
+
+    // Sampler
+    {
+        grfx::SamplerCreateInfo createInfo = {};
+        createInfo.magFilter               = grfx::FILTER_LINEAR;
+        createInfo.minFilter               = grfx::FILTER_LINEAR;
+        createInfo.mipmapMode              = grfx::SAMPLER_MIPMAP_MODE_LINEAR;
+        createInfo.addressModeU            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.addressModeV            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.addressModeW            = grfx::SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        createInfo.maxLod                  = 1.0f;
+
+        Result ppxres = device->CreateSampler(&createInfo, &mSampler);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "[imgui:grfx] failed creating sampler");
+            return ppxres;
+        }
+
+        if (mHeap->AllocateSampler(mSampler) == grfx::BindlessHeap::INVALID_INDEX) {
+            return ppx::ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    // Font texture
+    {
+        unsigned char* pPixels = nullptr;
+        int            width   = 0;
+        int            height  = 0;
+        io.Fonts->GetTexDataAsRGBA32(&pPixels, &width, &height);
+
+        Bitmap bitmap = Bitmap::Create(
+            static_cast<uint32_t>(width),
+            static_cast<uint32_t>(height),
+            Bitmap::FORMAT_RGBA_UINT8,
+            reinterpret_cast<char*>(pPixels));
+
+        Result ppxres = grfx_util::CreateTextureFromBitmap(pApp->GetGraphicsQueue(), &bitmap, &mFontTexture);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "[imgui:grfx] failed creating font texture");
+            return ppxres;
+        }
+
+        mFontTextureIndex = mHeap->AllocateTexture(mFontTexture->GetSampledImageView());
+        if (mFontTextureIndex == grfx::BindlessHeap::INVALID_INDEX) {
+            return ppx::ERROR_OUT_OF_MEMORY;
+        }
+        io.Fonts->SetTexID(ToImTextureID(mFontTextureIndex));
+    }
+
+    // Vertex and index ring
+    {
+        grfx::TransientAllocatorCreateInfo createInfo = {};
+        createInfo.frameSize                          = kImGuiFrameBufferSize;
+        createInfo.frameCount                         = pApp->GetNumFramesInFlight();
+        createInfo.alignment                          = sizeof(uint32_t);
+        createInfo.usageFlags                         = grfx::BufferUsageFlags();
+        createInfo.usageFlags.bits.vertexBuffer       = true;
+        createInfo.usageFlags.bits.indexBuffer        = true;
+
+        Result ppxres = device->CreateTransientAllocator(&createInfo, &mAllocator);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "[imgui:grfx] failed creating transient allocator");
+            return ppxres;
+        }
+    }
+
+    // Pipeline interface
+    {
+        grfx::PipelineInterfaceCreateInfo createInfo = {};
+        createInfo.setCount                          = 1;
+        createInfo.sets[0].set                       = 0;
+        createInfo.sets[0].pLayout                   = mHeap->GetDescriptorSetLayout();
+        createInfo.pushConstants.count               = sizeof(ImGuiDrawParams) / sizeof(uint32_t);
+        createInfo.pushConstants.binding             = 2;
+        createInfo.pushConstants.set                 = 0;
+
+        Result ppxres = device->CreatePipelineInterface(&createInfo, &mPipelineInterface);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "[imgui:grfx] failed creating pipeline interface");
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::ShaderModulePtr VS;
+        Result                ppxres = pApp->CreateShader("basic/shaders", "ImGui.vs", &VS);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        grfx::ShaderModulePtr PS;
+        ppxres = pApp->CreateShader("basic/shaders", "ImGui.ps", &PS);
+        if (Failed(ppxres)) {
+            device->DestroyShaderModule(VS);
+            return ppxres;
+        }
+
+        grfx::VertexBinding vertexBinding;
+        vertexBinding.AppendAttribute({"POSITION", 0, grfx::FORMAT_R32G32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+        vertexBinding.AppendAttribute({"TEXCOORD", 1, grfx::FORMAT_R32G32_FLOAT, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+        vertexBinding.AppendAttribute({"COLOR", 2, grfx::FORMAT_R8G8B8A8_UNORM, 0, PPX_APPEND_OFFSET_ALIGNED, grfx::VERTEX_INPUT_RATE_VERTEX});
+
+        // Dynamic render passes for ImGui have a single color attachment
+        const bool dynamicRendering = pApp->GetSettings()->grfx.enableImGuiDynamicRendering;
+
+        grfx::GraphicsPipelineCreateInfo2 createInfo  = {};
+        createInfo.VS                                 = {VS.Get(), "vsmain"};
+        createInfo.PS                                 = {PS.Get(), "psmain"};
+        createInfo.vertexInputState.bindingCount      = 1;
+        createInfo.vertexInputState.bindings[0]       = vertexBinding;
+        createInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        createInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        createInfo.cullMode                           = grfx::CULL_MODE_NONE;
+        createInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        createInfo.depthReadEnable                    = false;
+        createInfo.depthWriteEnable                   = false;
+        createInfo.blendModes[0]                      = grfx::BLEND_MODE_ALPHA;
+        createInfo.outputState.renderTargetCount      = 1;
+        createInfo.outputState.renderTargetFormats[0] = pApp->GetUISwapchain()->GetColorFormat();
+        createInfo.outputState.depthStencilFormat     = dynamicRendering ? grfx::FORMAT_UNDEFINED : pApp->GetUISwapchain()->GetDepthFormat();
+        createInfo.pPipelineInterface                 = mPipelineInterface;
+        createInfo.dynamicRenderPass                  = dynamicRendering;
+
+        ppxres = device->CreateGraphicsPipeline(&createInfo, &mPipeline);
+        device->DestroyShaderModule(VS);
+        device->DestroyShaderModule(PS);
+        if (Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "[imgui:grfx] failed creating pipeline");
+            return ppxres;
+        }
+    }
+
+    return mHeap->Flush();
+}
+
+void ImGuiImplGrfx::Shutdown(ppx::Application* pApp)
+{
+#if defined(PPX_ANDROID)
+    ImGui_ImplAndroid_Shutdown();
+#else
+    ImGui_ImplGlfw_Shutdown();
+#endif
+    ImGui::DestroyContext();
+
+    grfx::DevicePtr device = pApp->GetDevice();
+    if (mPipeline) {
+        device->DestroyGraphicsPipeline(mPipeline);
+        mPipeline.Reset();
+    }
+    if (mPipelineInterface) {
+        device->DestroyPipelineInterface(mPipelineInterface);
+        mPipelineInterface.Reset();
+    }
+    if (mAllocator) {
+        device->DestroyTransientAllocator(mAllocator);
+        mAllocator.Reset();
+    }
+    if (mFontTexture) {
+        device->DestroyTexture(mFontTexture);
+        mFontTexture.Reset();
+    }
+    if (mSampler) {
+        device->DestroySampler(mSampler);
+        mSampler.Reset();
+    }
+    if (mHeap) {
+        device->DestroyBindlessHeap(mHeap);
+        mHeap.Reset();
+    }
+}
+
+void ImGuiImplGrfx::NewFrameApi()
+{
+#if defined(PPX_ANDROID)
+    ImGui_ImplAndroid_NewFrame();
+#else
+    ImGui_ImplGlfw_NewFrame();
+#endif
+    ImGui::NewFrame();
+}
+
+ImTextureID ImGuiImplGrfx::AddTexture(const grfx::Texture* pTexture)
+{
+    PPX_ASSERT_NULL_ARG(pTexture);
+
+    const uint32_t index = mHeap->AllocateTexture(pTexture->GetSampledImageView());
+    if (index == grfx::BindlessHeap::INVALID_INDEX) {
+        return ImTextureID();
+    }
+    return ToImTextureID(index);
+}
+
+void ImGuiImplGrfx::RemoveTexture(ImTextureID textureId)
+{
+    const uint32_t index = ToHeapIndex(textureId);
+    if (index == mFontTextureIndex) {
+        return;
+    }
+    mHeap->FreeTexture(index);
+}
+
+void ImGuiImplGrfx::SetupRenderState(grfx::CommandBuffer* pCommandBuffer, const ImDrawData* pDrawData, const grfx::TransientAllocation& vertices, const grfx::TransientAllocation& indices)
+{
+    const grfx::DescriptorSet* pSet = mHeap->GetDescriptorSet();
+
+    grfx::VertexBufferView vertexBufferView = {};
+    vertexBufferView.pBuffer                = vertices.pBuffer;
+    vertexBufferView.stride                 = sizeof(ImDrawVert);
+    vertexBufferView.offset                 = vertices.offset;
+
+    grfx::IndexBufferView indexBufferView = {};
+    indexBufferView.pBuffer               = indices.pBuffer;
+    indexBufferView.indexType             = (sizeof(ImDrawIdx) == 2) ? grfx::INDEX_TYPE_UINT16 : grfx::INDEX_TYPE_UINT32;
+    indexBufferView.offset                = indices.offset;
+
+    const float width  = pDrawData->DisplaySize.x * pDrawData->FramebufferScale.x;
+    const float height = pDrawData->DisplaySize.y * pDrawData->FramebufferScale.y;
+
+    // Maps the display rectangle to clip space, grfx clip space is y up on every API
+    ImGuiDrawParams params = {};
+    params.scale           = float2(2.0f / pDrawData->DisplaySize.x, -2.0f / pDrawData->DisplaySize.y);
+    params.translate       = float2(-1.0f - pDrawData->DisplayPos.x * params.scale.x, 1.0f - pDrawData->DisplayPos.y * params.scale.y);
+    params.textureIndex    = mFontTextureIndex;
+
+    pCommandBuffer->BindGraphicsPipeline(mPipeline);
+    pCommandBuffer->BindGraphicsDescriptorSets(mPipelineInterface, 1, &pSet);
+    pCommandBuffer->BindVertexBuffers(1, &vertexBufferView);
+    pCommandBuffer->BindIndexBuffer(&indexBufferView);
+    pCommandBuffer->SetViewports(grfx::Viewport(0, 0, width, height));
+    pCommandBuffer->PushGraphicsConstants(mPipelineInterface, sizeof(params) / sizeof(uint32_t), &params);
+}
+
+void ImGuiImplGrfx::Render(grfx::CommandBuffer* pCommandBuffer)
+{
+    mRenderStats = {};
+
+    BuildDrawData();
+    const ImDrawData* pDrawData = ImGui::GetDrawData();
+    if (IsNull(pDrawData) || (pDrawData->TotalIdxCount == 0)) {
+        return;
+    }
+    const float fbWidth  = pDrawData->DisplaySize.x * pDrawData->FramebufferScale.x;
+    const float fbHeight = pDrawData->DisplaySize.y * pDrawData->FramebufferScale.y;
+    if ((fbWidth <= 0.0f) || (fbHeight <= 0.0f)) {
+        return;
+    }
+
+    // Draws of the same frame share the allocator's frame
+    Application*   pApp        = Application::Get();
+    const uint64_t frameNumber = pApp->GetFrameCount();
+    if (frameNumber != mFrameNumber) {
+        mAllocator->BeginFrame(pApp->GetInFlightFrameIndex());
+        mFrameNumber = frameNumber;
+    }
+
+    grfx::TransientAllocation vertices = {};
+    grfx::TransientAllocation indices  = {};
+    Result                    ppxres   = mAllocator->Allocate(pDrawData->TotalVtxCount * sizeof(ImDrawVert), &vertices);
+    if (Success(ppxres)) {
+        ppxres = mAllocator->Allocate(pDrawData->TotalIdxCount * sizeof(ImDrawIdx), &indices);
+    }
+    if (Failed(ppxres)) {
+        PPX_LOG_WARN_ONCE("[imgui:grfx] draw data doesn't fit in " << kImGuiFrameBufferSize << " bytes, skipping frames");
+        return;
+    }
+
+    ImDrawVert* pVertices = static_cast<ImDrawVert*>(vertices.pMappedAddress);
+    ImDrawIdx*  pIndices  = static_cast<ImDrawIdx*>(indices.pMappedAddress);
+    for (int i = 0; i < pDrawData->CmdListsCount; ++i) {
+        const ImDrawList* pList = pDrawData->CmdLists[i];
+        std::memcpy(pVertices, pList->VtxBuffer.Data, pList->VtxBuffer.size_in_bytes());
+        std::memcpy(pIndices, pList->IdxBuffer.Data, pList->IdxBuffer.size_in_bytes());
+        pVertices += pList->VtxBuffer.Size;
+        pIndices += pList->IdxBuffer.Size;
+    }
+
+    PPX_CHECKED_CALL(mHeap->Flush());
+    SetupRenderState(pCommandBuffer, pDrawData, vertices, indices);
+
+    // Scissor and texture index are only set when they change
+    const ImVec2 clipOff      = pDrawData->DisplayPos;
+    const ImVec2 clipScale    = pDrawData->FramebufferScale;
+    grfx::Rect   scissor      = {};
+    bool         scissorSet   = false;
+    uint32_t     textureIndex = mFontTextureIndex;
+    uint32_t     vertexOffset = 0;
+    uint32_t     indexOffset  = 0;
+    for (int i = 0; i < pDrawData->CmdListsCount; ++i) {
+        const ImDrawList* pList = pDrawData->CmdLists[i];
+        for (const ImDrawCmd& cmd : pList->CmdBuffer) {
+            if (!IsNull(cmd.UserCallback)) {
+                if (cmd.UserCallback == ImDrawCallback_ResetRenderState) {
+                    SetupRenderState(pCommandBuffer, pDrawData, vertices, indices);
+                    scissorSet   = false;
+                    textureIndex = mFontTextureIndex;
+                }
+                else {
+                    cmd.UserCallback(pList, &cmd);
+                }
+                continue;
+            }
+
+            const float x0 = std::max((cmd.ClipRect.x - clipOff.x) * clipScale.x, 0.0f);
+            const float y0 = std::max((cmd.ClipRect.y - clipOff.y) * clipScale.y, 0.0f);
+            const float x1 = std::min((cmd.ClipRect.z - clipOff.x) * clipScale.x, fbWidth);
+            const float y1 = std::min((cmd.ClipRect.w - clipOff.y) * clipScale.y, fbHeight);
+            if ((x1 <= x0) || (y1 <= y0) || (cmd.ElemCount == 0)) {
+                continue;
+            }
+
+            const grfx::Rect cmdScissor(static_cast<int32_t>(x0), static_cast<int32_t>(y0), static_cast<uint32_t>(x1 - x0), static_cast<uint32_t>(y1 - y0));
+            const bool       scissorChanged = !scissorSet || (cmdScissor.x != scissor.x) || (cmdScissor.y != scissor.y) || (cmdScissor.width != scissor.width) || (cmdScissor.height != scissor.height);
+            if (scissorChanged) {
+                pCommandBuffer->SetScissors(cmdScissor);
+                scissor    = cmdScissor;
+                scissorSet = true;
+                mRenderStats.scissorCount += 1;
+            }
+
+            const uint32_t cmdTextureIndex = ToHeapIndex(cmd.GetTexID());
+            if (cmdTextureIndex != textureIndex) {
+                pCommandBuffer->PushGraphicsConstants(mPipelineInterface, 1, &cmdTextureIndex, offsetof(ImGuiDrawParams, textureIndex) / sizeof(uint32_t));
+                textureIndex = cmdTextureIndex;
+                mRenderStats.textureBindCount += 1;
+            }
+
+            pCommandBuffer->DrawIndexed(cmd.ElemCount, 1, indexOffset + cmd.IdxOffset, static_cast<int32_t>(vertexOffset + cmd.VtxOffset));
+            mRenderStats.drawCount += 1;
+        }
+        vertexOffset += static_cast<uint32_t>(pList->VtxBuffer.Size);
+        indexOffset += static_cast<uint32_t>(pList->IdxBuffer.Size);
+    }
+
+    mRenderStats.vertexCount = static_cast<uint32_t>(pDrawData->TotalVtxCount);
+    mRenderStats.indexCount  = static_cast<uint32_t>(pDrawData->TotalIdxCount);
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -222,8 +686,9 @@ void ImGuiImplDx12::Render(grfx::CommandBuffer* pCommandBuffer)
     grfx::dx12::D3D12GraphicsCommandListPtr commandList = grfx::dx12::ToApi(pCommandBuffer)->GetDxCommandList();
     commandList->SetDescriptorHeaps(1, &mHeapCBVSRVUAV);
 
-    ImGui::Render();
+    BuildDrawData();
     ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), grfx::dx12::ToApi(pCommandBuffer)->GetDxCommandList());
+    CountStockBackendDraws();
 }
 
 #endif // defined(PPX_D3D12)
@@ -271,19 +736,36 @@ Result ImGuiImplVk::InitApiObjects(ppx::Application* pApp)
         init_info.ImageCount                = pApp->GetUISwapchain()->GetImageCount();
         init_info.Allocator                 = VK_NULL_HANDLE;
         init_info.CheckVkResultFn           = nullptr;
+
+        grfx::RenderPassPtr renderPass = pApp->GetUISwapchain()->GetRenderPass(0, grfx::ATTACHMENT_LOAD_OP_LOAD);
+        PPX_ASSERT_MSG(!renderPass.IsNull(), "[imgui:vk] failed to get swapchain renderpass");
+
+        // ImGui is drawn either in a dynamic render pass with a single color
+        // attachment, or in the swapchain render pass which uses dynamic
+        // rendering too if the device records render passes with it.
+        const bool imGuiDynamicRendering = pApp->GetSettings()->grfx.enableImGuiDynamicRendering;
+        const bool swapchainDynamic      = grfx::vk::ToApi(renderPass)->UsesDynamicRendering();
 #if (IMGUI_VERSION_NUM > 18970) && defined(IMGUI_IMPL_VULKAN_HAS_DYNAMIC_RENDERING)
-        init_info.UseDynamicRendering                                 = pApp->GetSettings()->grfx.enableImGuiDynamicRendering;
+        init_info.UseDynamicRendering                                 = imGuiDynamicRendering || swapchainDynamic;
         init_info.PipelineRenderingCreateInfo                         = {VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
         VkFormat colorFormat                                          = grfx::vk::ToVkFormat(pApp->GetUISwapchain()->GetColorFormat());
         init_info.PipelineRenderingCreateInfo.colorAttachmentCount    = 1;
         init_info.PipelineRenderingCreateInfo.pColorAttachmentFormats = &colorFormat;
+        if (!imGuiDynamicRendering && renderPass->HasDepthStencil()) {
+            grfx::Format            depthFormat = pApp->GetUISwapchain()->GetDepthFormat();
+            const grfx::FormatDesc* pFormatDesc = grfx::GetFormatDescription(depthFormat);
+            if (pFormatDesc->aspect & grfx::FORMAT_ASPECT_DEPTH) {
+                init_info.PipelineRenderingCreateInfo.depthAttachmentFormat = grfx::vk::ToVkFormat(depthFormat);
+            }
+            if (pFormatDesc->aspect & grfx::FORMAT_ASPECT_STENCIL) {
+                init_info.PipelineRenderingCreateInfo.stencilAttachmentFormat = grfx::vk::ToVkFormat(depthFormat);
+            }
+        }
 #else
-        PPX_ASSERT_MSG(!pApp->GetSettings()->grfx.enableImGuiDynamicRendering, "This version of ImGui does not have dynamic rendering support");
+        PPX_ASSERT_MSG(!imGuiDynamicRendering, "This version of ImGui does not have dynamic rendering support");
+        PPX_ASSERT_MSG(!swapchainDynamic, "This version of ImGui does not have dynamic rendering support, set ApplicationSettings::grfx.device.dynamicRenderPasses to false");
 #endif
 
-        grfx::RenderPassPtr renderPass = pApp->GetUISwapchain()->GetRenderPass(0, grfx::ATTACHMENT_LOAD_OP_LOAD);
-        PPX_ASSERT_MSG(!renderPass.IsNull(), "[imgui:vk] failed to get swapchain renderpass");
-
         init_info.RenderPass = grfx::vk::ToApi(renderPass)->GetVkRenderPass();
         bool result          = ImGui_ImplVulkan_Init(&init_info);
         if (!result) {
@@ -369,8 +851,9 @@ void ImGuiImplVk::NewFrameApi()
 
 void ImGuiImplVk::Render(grfx::CommandBuffer* pCommandBuffer)
 {
-    ImGui::Render();
+    BuildDrawData();
     ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), grfx::vk::ToApi(pCommandBuffer)->GetVkCommandBuffer());
+    CountStockBackendDraws();
 }
 
 #if defined(PPX_BUILD_XR)
@@ -0,0 +1,310 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/job_system.h"
+#include "ppx/thread_policy.h"
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#include <pthread.h>
+#endif
+
+namespace ppx {
+
+static thread_local JobSystem* sCurrentJobSystem   = nullptr;
+static thread_local uint32_t   sCurrentWorkerIndex = UINT32_MAX;
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+static void SetCurrentThreadName(uint32_t workerIndex)
+{
+    // Names are limited to 15 characters
+    const std::string name = "ppx_job_" + std::to_string(workerIndex);
+    pthread_setname_np(pthread_self(), name.c_str());
+}
+#else
+static void SetCurrentThreadName(uint32_t workerIndex)
+{
+}
+#endif
+
+// -------------------------------------------------------------------------------------------------
+// JobCounter
+// -------------------------------------------------------------------------------------------------
+JobCounter::~JobCounter()
+{
+    // Waits for JobSystem::Complete() to release the counter that woke a waiter
+    std::lock_guard<std::mutex> lock(mMutex);
+    PPX_ASSERT_MSG(IsDone(), "job counter destroyed before its jobs have run");
+}
+
+// -------------------------------------------------------------------------------------------------
+// JobSystem
+// -------------------------------------------------------------------------------------------------
+JobSystem::JobSystem()
+{
+}
+
+JobSystem::~JobSystem()
+{
+    Shutdown();
+}
+
+JobSystem* JobSystem::Get()
+{
+    static JobSystem      sJobSystem;
+    static std::once_flag sInitialized;
+    std::call_once(sInitialized, []() { sJobSystem.Initialize(JobSystemCreateInfo{}); });
+    return &sJobSystem;
+}
+
+uint32_t JobSystem::GetCurrentWorkerIndex()
+{
+    return sCurrentWorkerIndex;
+}
+
+Result JobSystem::Initialize(const JobSystemCreateInfo& createInfo)
+{
+    if (!mWorkers.empty()) {
+        PPX_ASSERT_MSG(false, "job system is already initialized");
+        return ppx::ERROR_FAILED;
+    }
+
+    // All pools share the event
+    Result ppxres = Profiler::RegisterEvent(PROFILER_EVENT_TYPE_JOB, "ppx::JobSystem::Job", PROFILER_EVENT_RECORD_ACTION_AVERAGE, &mJobEventToken);
+    if (Failed(ppxres) && (ppxres != ppx::ERROR_DUPLICATE_ELEMENT)) {
+        PPX_ASSERT_MSG(false, "failed registering job profiler event");
+        return ppxres;
+    }
+
+    switch (createInfo.affinity) {
+        case JOB_AFFINITY_BIG_CORES: mAffinityCpus = GetCoreTypeCpus(CORE_TYPE_BIG); break;
+        case JOB_AFFINITY_LITTLE_CORES: mAffinityCpus = GetCoreTypeCpus(CORE_TYPE_LITTLE); break;
+        default: mAffinityCpus.clear(); break;
+    }
+
+    uint32_t workerCount = createInfo.workerCount;
+    if (workerCount == 0) {
+        const uint32_t threadCount = mAffinityCpus.empty() ? std::thread::hardware_concurrency() : CountU32(mAffinityCpus) + 1;
+        workerCount                = (threadCount > 1) ? (threadCount - 1) : 0;
+    }
+
+    mStop = false;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        mWorkers.push_back(std::make_unique<Worker>());
+    }
+    // Workers steal from each other, so all of them must exist before any starts
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        mWorkers[i]->thread = std::thread([this, i]() { WorkerMain(i); });
+    }
+
+    return ppx::SUCCESS;
+}
+
+void JobSystem::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+        mStop = true;
+    }
+    mSleepCondition.notify_all();
+
+    for (auto& worker : mWorkers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    mWorkers.clear();
+    mAffinityCpus.clear();
+}
+
+void JobSystem::Run(Job&& job, JobCounter* pCounter)
+{
+    if (!IsNull(pCounter)) {
+        pCounter->mValue.fetch_add(1, std::memory_order_relaxed);
+    }
+    Push(std::move(job), pCounter);
+}
+
+void JobSystem::RunAfter(JobCounter* pDependency, Job&& job, JobCounter* pCounter)
+{
+    if (!IsNull(pCounter)) {
+        pCounter->mValue.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (!IsNull(pDependency)) {
+        std::lock_guard<std::mutex> lock(pDependency->mMutex);
+        if (!pDependency->IsDone()) {
+            pDependency->mContinuations.push_back({std::move(job), pCounter});
+            return;
+        }
+    }
+    // Pushed outside the lock, the job may run right away and use pDependency
+    Push(std::move(job), pCounter);
+}
+
+void JobSystem::Wait(JobCounter* pCounter)
+{
+    PPX_ASSERT_NULL_ARG(pCounter);
+
+    const uint32_t workerIndex = (sCurrentJobSystem == this) ? sCurrentWorkerIndex : UINT32_MAX;
+    while (!pCounter->IsDone()) {
+        if (!TryRunJob(workerIndex)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& fn)
+{
+    grainSize = std::max<uint32_t>(grainSize, 1);
+
+    JobCounter counter;
+    for (uint32_t begin = 0; begin < count; begin += grainSize) {
+        const uint32_t end = std::min(begin + grainSize, count);
+        Run([&fn, begin, end]() { fn(begin, end); }, &counter);
+    }
+    Wait(&counter);
+}
+
+void JobSystem::Push(Job&& job, JobCounter* pCounter)
+{
+    if (mWorkers.empty()) {
+        job();
+        Complete(pCounter);
+        return;
+    }
+
+    // Jobs spawned by a worker go to its own deque, others are spread out
+    uint32_t workerIndex = (sCurrentJobSystem == this) ? sCurrentWorkerIndex : UINT32_MAX;
+    if (workerIndex == UINT32_MAX) {
+        workerIndex = mNextWorker.fetch_add(1, std::memory_order_relaxed) % GetWorkerCount();
+    }
+
+    {
+        Worker&                     worker = *mWorkers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back({std::move(job), pCounter});
+    }
+    mPendingJobCount.fetch_add(1, std::memory_order_release);
+
+    // Taking the lock makes sure a worker isn't between checking for jobs and sleeping
+    {
+        std::lock_guard<std::mutex> lock(mSleepMutex);
+    }
+    mSleepCondition.notify_one();
+}
+
+bool JobSystem::TryRunJob(uint32_t workerIndex)
+{
+    const uint32_t workerCount = GetWorkerCount();
+    if (workerCount == 0) {
+        return false;
+    }
+
+    QueuedJob queuedJob;
+    bool      found = false;
+
+    // Newest job of our own deque
+    if (workerIndex < workerCount) {
+        Worker&                     worker = *mWorkers[workerIndex];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            queuedJob = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // Oldest job of another deque
+    const uint32_t firstVictim = (workerIndex < workerCount) ? (workerIndex + 1) : mNextWorker.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; !found && (i < workerCount); ++i) {
+        const uint32_t victimIndex = (firstVictim + i) % workerCount;
+        if (victimIndex == workerIndex) {
+            continue;
+        }
+        Worker&                     victim = *mWorkers[victimIndex];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            queuedJob = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+    mPendingJobCount.fetch_sub(1, std::memory_order_acq_rel);
+
+    {
+        ProfilerScopedEventSample sample(mJobEventToken);
+        queuedJob.job();
+    }
+    Complete(queuedJob.pCounter);
+
+    return true;
+}
+
+void JobSystem::Complete(JobCounter* pCounter)
+{
+    if (IsNull(pCounter)) {
+        return;
+    }
+
+    // Decrementing under the lock keeps RunAfter() from adding continuations
+    // that are never run
+    std::vector<JobCounter::Continuation> continuations;
+    {
+        std::lock_guard<std::mutex> lock(pCounter->mMutex);
+        if (pCounter->mValue.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return;
+        }
+        continuations.swap(pCounter->mContinuations);
+    }
+    // pCounter may be destroyed by a waiter from here on
+    for (auto& continuation : continuations) {
+        Push(std::move(continuation.job), continuation.pCounter);
+    }
+}
+
+void JobSystem::WorkerMain(uint32_t workerIndex)
+{
+    sCurrentJobSystem   = this;
+    sCurrentWorkerIndex = workerIndex;
+
+    // Reserves this thread's profiler so its job events show up
+    if (IsNull(Profiler::GetProfilerForThread())) {
+        PPX_LOG_WARN("job system worker " << workerIndex << " has no profiler");
+    }
+    SetCurrentThreadName(workerIndex);
+    if (Failed(SetCurrentThreadAffinity(mAffinityCpus))) {
+        PPX_LOG_WARN("failed setting job system worker affinity");
+    }
+    // The job worker role's affinity, if set, overrides the create info's
+    ApplyThreadPolicy(THREAD_ROLE_JOB_WORKER);
+
+    for (;;) {
+        if (TryRunJob(workerIndex)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mSleepMutex);
+        mSleepCondition.wait(lock, [this]() { return mStop || (mPendingJobCount.load(std::memory_order_acquire) > 0); });
+        // Queued jobs still run on shutdown
+        if (mStop && (mPendingJobCount.load(std::memory_order_acquire) == 0)) {
+            return;
+        }
+    }
+}
+
+} // namespace ppx
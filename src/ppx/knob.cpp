@@ -15,6 +15,7 @@
 #include "ppx/knob.h"
 #include "ppx/string_util.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace ppx {
@@ -70,6 +71,24 @@ void KnobCheckbox::UpdateFromFlags(const CliOptions& opts)
     SetDefaultAndValue(opts.GetOptionValueOrDefault(mFlagName, mValue));
 }
 
+std::unique_ptr<KnobValue> KnobCheckbox::ParseValue(const CliOptions& opts) const
+{
+    if (!opts.HasExtraOption(mFlagName)) {
+        return nullptr;
+    }
+    return std::make_unique<KnobValueT<bool>>(opts.GetOptionValueOrDefault(mFlagName, mValue));
+}
+
+bool KnobCheckbox::ApplyValue(const KnobValue& value)
+{
+    const bool newValue = static_cast<const KnobValueT<bool>&>(value).Get();
+    if (newValue == mValue) {
+        return false;
+    }
+    SetValue(newValue);
+    return true;
+}
+
 void KnobCheckbox::SetValue(bool newValue)
 {
     if (newValue == mValue) {
@@ -151,6 +170,33 @@ void KnobManager::UpdateFromFlags(const CliOptions& opts)
     }
 }
 
+KnobSnapshot KnobManager::CreateSnapshot(const CliOptions& opts) const
+{
+    KnobSnapshot snapshot;
+    snapshot.mpManager = this;
+    snapshot.mEntries.reserve(std::min(mKnobs.size(), opts.GetNumUniqueOptions()));
+    for (const auto& knobPtr : mKnobs) {
+        std::unique_ptr<KnobValue> value = knobPtr->ParseValue(opts);
+        if (value) {
+            snapshot.mEntries.push_back({knobPtr.get(), std::move(value)});
+        }
+    }
+    return snapshot;
+}
+
+size_t KnobManager::ApplySnapshot(const KnobSnapshot& snapshot)
+{
+    PPX_ASSERT_MSG(snapshot.IsEmpty() || (snapshot.mpManager == this), "snapshot was created by another knob manager");
+
+    size_t changedCount = 0;
+    for (const auto& entry : snapshot.mEntries) {
+        if (entry.pKnob->ApplyValue(*entry.value)) {
+            ++changedCount;
+        }
+    }
+    return changedCount;
+}
+
 void KnobManager::RegisterKnob(const std::string& flagName, std::shared_ptr<Knob> newKnob)
 {
     mFlagNames.insert(flagName);
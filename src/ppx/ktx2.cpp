@@ -0,0 +1,223 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/ktx2.h"
+#include "ppx/fs.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace ppx {
+
+namespace {
+
+const uint8_t kIdentifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+// Identifier, header and index, the level index follows
+constexpr size_t kHeaderSize     = 80;
+constexpr size_t kLevelEntrySize = 24;
+
+struct Header
+{
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+};
+
+// KTX2 is little endian like every platform we run on
+template <typename T>
+T Read(const uint8_t* pData, size_t offset)
+{
+    T value;
+    memcpy(&value, pData + offset, sizeof(T));
+    return value;
+}
+
+bool ReadHeader(size_t dataSize, const void* pData, Header* pHeader)
+{
+    if (IsNull(pData) || (dataSize < kHeaderSize) || (memcmp(pData, kIdentifier, sizeof(kIdentifier)) != 0)) {
+        return false;
+    }
+
+    const uint8_t* pBytes           = static_cast<const uint8_t*>(pData);
+    pHeader->vkFormat               = Read<uint32_t>(pBytes, 12);
+    pHeader->typeSize               = Read<uint32_t>(pBytes, 16);
+    pHeader->pixelWidth             = Read<uint32_t>(pBytes, 20);
+    pHeader->pixelHeight            = Read<uint32_t>(pBytes, 24);
+    pHeader->pixelDepth             = Read<uint32_t>(pBytes, 28);
+    pHeader->layerCount             = Read<uint32_t>(pBytes, 32);
+    pHeader->faceCount              = Read<uint32_t>(pBytes, 36);
+    pHeader->levelCount             = Read<uint32_t>(pBytes, 40);
+    pHeader->supercompressionScheme = Read<uint32_t>(pBytes, 44);
+    return true;
+}
+
+// VkFormat values of the formats grfx can create images with
+grfx::Format ToGrfxFormat(uint32_t vkFormat)
+{
+    // clang-format off
+    switch (vkFormat) {
+        default: break;
+        case 37  : return grfx::FORMAT_R8G8B8A8_UNORM;
+        case 43  : return grfx::FORMAT_R8G8B8A8_SRGB;
+        case 131 : return grfx::FORMAT_BC1_RGB_UNORM;
+        case 132 : return grfx::FORMAT_BC1_RGB_SRGB;
+        case 133 : return grfx::FORMAT_BC1_RGBA_UNORM;
+        case 134 : return grfx::FORMAT_BC1_RGBA_SRGB;
+        case 135 : return grfx::FORMAT_BC2_UNORM;
+        case 136 : return grfx::FORMAT_BC2_SRGB;
+        case 137 : return grfx::FORMAT_BC3_UNORM;
+        case 138 : return grfx::FORMAT_BC3_SRGB;
+        case 139 : return grfx::FORMAT_BC4_UNORM;
+        case 140 : return grfx::FORMAT_BC4_SNORM;
+        case 141 : return grfx::FORMAT_BC5_UNORM;
+        case 142 : return grfx::FORMAT_BC5_SNORM;
+        case 143 : return grfx::FORMAT_BC6H_UFLOAT;
+        case 144 : return grfx::FORMAT_BC6H_SFLOAT;
+        case 145 : return grfx::FORMAT_BC7_UNORM;
+        case 146 : return grfx::FORMAT_BC7_SRGB;
+    }
+    // clang-format on
+    return grfx::FORMAT_UNDEFINED;
+}
+
+bool NeedsTranscoding(const Header& header)
+{
+    // VK_FORMAT_UNDEFINED is Basis Universal, either BasisLZ or UASTC
+    return (header.vkFormat == 0) || (header.supercompressionScheme != Ktx2::SUPERCOMPRESSION_NONE);
+}
+
+} // namespace
+
+bool Ktx2::IsKtx2File(const std::filesystem::path& path)
+{
+    return path.extension() == ".ktx2";
+}
+
+bool Ktx2::IsKtx2Data(size_t dataSize, const void* pData)
+{
+    return !IsNull(pData) && (dataSize >= sizeof(kIdentifier)) && (memcmp(pData, kIdentifier, sizeof(kIdentifier)) == 0);
+}
+
+bool Ktx2::IsTranscodingRequired(size_t dataSize, const void* pData)
+{
+    Header header = {};
+    return ReadHeader(dataSize, pData, &header) && NeedsTranscoding(header);
+}
+
+grfx::Format Ktx2::ReadFormat(size_t dataSize, const void* pData)
+{
+    Header header = {};
+    if (!ReadHeader(dataSize, pData, &header) || NeedsTranscoding(header)) {
+        return grfx::FORMAT_UNDEFINED;
+    }
+    return ToGrfxFormat(header.vkFormat);
+}
+
+grfx::Format Ktx2::ReadFormat(const std::filesystem::path& path)
+{
+    char          header[kHeaderSize] = {};
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(header, sizeof(header))) {
+        return grfx::FORMAT_UNDEFINED;
+    }
+    return ReadFormat(sizeof(header), header);
+}
+
+Result Ktx2::LoadFile(const std::filesystem::path& path, Ktx2* pKtx2)
+{
+    auto data = fs::load_file(path);
+    if (!data.has_value()) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+    return LoadFromMemory(data->size(), data->data(), pKtx2);
+}
+
+Result Ktx2::LoadFromMemory(size_t dataSize, const void* pData, Ktx2* pKtx2)
+{
+    PPX_ASSERT_NULL_ARG(pKtx2);
+
+    Header header = {};
+    if (!ReadHeader(dataSize, pData, &header)) {
+        PPX_LOG_ERROR("KTX2: invalid header");
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    if (NeedsTranscoding(header)) {
+        PPX_LOG_ERROR("KTX2: Basis Universal and supercompressed textures need transcoding, which isn't available (vkFormat=" << header.vkFormat << ", supercompression=" << header.supercompressionScheme << ")");
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const grfx::Format format = ToGrfxFormat(header.vkFormat);
+    if (format == grfx::FORMAT_UNDEFINED) {
+        PPX_LOG_ERROR("KTX2: unsupported vkFormat " << header.vkFormat);
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    if ((header.pixelWidth == 0) || (header.pixelHeight == 0) || (header.pixelDepth > 1) || (header.layerCount > 1) || (header.faceCount != 1)) {
+        PPX_LOG_ERROR("KTX2: only 2D textures with a single layer and face are supported");
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    // Zero levels asks for the mip chain to be generated, only the base
+    // level is stored
+    const uint32_t levelCount = std::max<uint32_t>(header.levelCount, 1);
+    if ((levelCount > 32) || (dataSize < kHeaderSize + levelCount * kLevelEntrySize)) {
+        return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+    }
+
+    const grfx::FormatDesc* pFormatDesc = grfx::GetFormatDescription(format);
+    const uint32_t          blockWidth  = std::max<uint32_t>(pFormatDesc->blockWidth, 1);
+    const uint8_t*          pBytes      = static_cast<const uint8_t*>(pData);
+
+    std::vector<Level> levels(levelCount);
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        const uint64_t offset = Read<uint64_t>(pBytes, kHeaderSize + i * kLevelEntrySize);
+        const uint64_t size   = Read<uint64_t>(pBytes, kHeaderSize + i * kLevelEntrySize + 8);
+        if ((offset > dataSize) || (size > (dataSize - offset))) {
+            PPX_LOG_ERROR("KTX2: level " << i << " exceeds the data");
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+
+        Level& level = levels[i];
+        level.width  = std::max<uint32_t>(header.pixelWidth >> i, 1);
+        level.height = std::max<uint32_t>(header.pixelHeight >> i, 1);
+        level.offset = static_cast<size_t>(offset);
+        level.size   = static_cast<size_t>(size);
+
+        // bytesPerTexel is the size of a block for compressed formats
+        const uint64_t blockCount = static_cast<uint64_t>((level.width + blockWidth - 1) / blockWidth) * ((level.height + blockWidth - 1) / blockWidth);
+        if (size < blockCount * pFormatDesc->bytesPerTexel) {
+            PPX_LOG_ERROR("KTX2: level " << i << " is too small for its extent");
+            return ppx::ERROR_IMAGE_FILE_LOAD_FAILED;
+        }
+    }
+
+    pKtx2->mFormat = format;
+    pKtx2->mWidth  = header.pixelWidth;
+    pKtx2->mHeight = header.pixelHeight;
+    pKtx2->mLevels = std::move(levels);
+    pKtx2->mData.assign(static_cast<const char*>(pData), static_cast<const char*>(pData) + dataSize);
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
@@ -14,7 +14,9 @@
 
 #include "ppx/log.h"
 
+#include <chrono>
 #include <mutex>
+#include <vector>
 
 // Use current platform if one isn't defined
 // clang-format off
@@ -45,15 +47,25 @@
 
 namespace ppx {
 
+// How long the flush thread sleeps between writes of LOG_MODE_ASYNC
+// messages, which bounds how late they show up
+static constexpr auto kAsyncFlushInterval = std::chrono::milliseconds(10);
+
 static Log sLogInstance;
 
 Log::Log()
+    : mQueueHead(&mQueueStub), mQueueTail(&mQueueStub)
 {
 }
 
 Log::~Log()
 {
     Shutdown();
+
+    // The last message written in async mode stays at the tail of the queue
+    if (mQueueTail != &mQueueStub) {
+        delete mQueueTail;
+    }
 }
 
 bool Log::Initialize(uint32_t mode, const char* filePath, std::ostream* consoleStream)
@@ -69,6 +81,10 @@ bool Log::Initialize(uint32_t mode, const char* filePath, std::ostream* consoleS
         return false;
     }
 
+    if ((mode & LOG_MODE_ASYNC) != 0) {
+        sLogInstance.StartFlushThread();
+    }
+
     {
         std::lock_guard lock(sLogInstance.mWriteMutex);
         sLogInstance << "Logging started" << std::endl;
@@ -91,12 +107,33 @@ void Log::Shutdown()
         std::lock_guard lock(sLogInstance.mWriteMutex);
         sLogInstance << "Logging stopped" << std::endl;
         sLogInstance.Flush(LOG_LEVEL_DEFAULT);
+    }
 
-        // Destroy internal objects
+    // Writes anything still queued
+    sLogInstance.StopFlushThread();
+
+    // Destroy internal objects
+    {
+        std::lock_guard lock(sLogInstance.mWriteMutex);
         sLogInstance.DestroyObjects();
     }
 }
 
+void Log::SetAsync(bool enable)
+{
+    Log* pLog = Get();
+    if ((pLog == nullptr) || (enable == IsModeActive(LOG_MODE_ASYNC))) {
+        return;
+    }
+
+    if (enable) {
+        pLog->StartFlushThread();
+    }
+    else {
+        pLog->StopFlushThread();
+    }
+}
+
 Log* Log::Get()
 {
     Log* ptr = nullptr;
@@ -224,13 +261,53 @@ std::mutex& Log::GetLock()
     return Get()->mWriteMutex;
 }
 
+std::ostringstream& Log::GetThreadStream()
+{
+    thread_local std::ostringstream stream;
+    return stream;
+}
+
+void Log::Submit(std::ostringstream& stream, LogLevel level)
+{
+    std::string text = stream.str();
+    stream.str(std::string());
+    stream.clear();
+
+    if (IsModeActive(LOG_MODE_ASYNC)) {
+        // Fatal errors are usually followed by an abort
+        Enqueue(std::move(text), level, (level == LOG_LEVEL_FATAL));
+        return;
+    }
+
+    std::lock_guard lock(mWriteMutex);
+    Write(text.c_str(), level);
+    FlushStreams();
+}
+
 void Log::Flush(LogLevel level)
 {
-    // Write anything that's in the buffer
+    // Write anything that's in the buffer. Only the flush thread writes in
+    // async mode, the caller holds mWriteMutex so this can't wait for it.
     if (mBuffer.str().size() > 0) {
-        Write(mBuffer.str().c_str(), level);
+        if (IsModeActive(LOG_MODE_ASYNC)) {
+            Enqueue(mBuffer.str(), level, false);
+        }
+        else {
+            Write(mBuffer.str().c_str(), level);
+        }
     }
 
+    if (!IsModeActive(LOG_MODE_ASYNC)) {
+        FlushStreams();
+    }
+
+    // Clear buffer
+    mBuffer.str(std::string());
+    mBuffer.clear();
+}
+
+void Log::FlushStreams()
+{
     // Signal flush for console
     if ((mModes & LOG_MODE_CONSOLE) != 0) {
 #if defined(PPX_MSW)
@@ -245,10 +322,119 @@ void Log::Flush(LogLevel level)
     if (((mModes & LOG_MODE_FILE) != 0) && (mFileStream.is_open())) {
         mFileStream.flush();
     }
+}
 
-    // Clear buffer
-    mBuffer.str(std::string());
-    mBuffer.clear();
+void Log::Enqueue(std::string&& text, LogLevel level, bool wait)
+{
+    std::atomic<bool> written{false};
+
+    QueuedMessage* pMessage = new QueuedMessage();
+    pMessage->text          = std::move(text);
+    pMessage->level         = level;
+    pMessage->pWritten      = wait ? &written : nullptr;
+
+    // Lock-free push, the message is visible to the flush thread once the
+    // previous head links to it
+    QueuedMessage* pPrevious = mQueueHead.exchange(pMessage, std::memory_order_acq_rel);
+    pPrevious->next.store(pMessage, std::memory_order_release);
+
+    if (wait) {
+        std::unique_lock<std::mutex> lock(mFlushMutex);
+        mFlushRequested = true;
+        mFlushCondition.notify_one();
+        mWrittenCondition.wait(lock, [&written]() { return written.load(); });
+    }
+}
+
+bool Log::Dequeue(QueuedMessage** ppMessage)
+{
+    QueuedMessage* pTail = mQueueTail;
+    QueuedMessage* pNext = pTail->next.load(std::memory_order_acquire);
+    if (pNext == nullptr) {
+        return false;
+    }
+
+    // pNext becomes the tail, its contents are moved out before it's
+    // written so the tail never holds an unwritten message
+    mQueueTail = pNext;
+    if (pTail != &mQueueStub) {
+        delete pTail;
+    }
+
+    *ppMessage = pNext;
+    return true;
+}
+
+void Log::WriteQueuedMessages()
+{
+    std::vector<std::atomic<bool>*> written;
+    {
+        std::lock_guard lock(mWriteMutex);
+
+        QueuedMessage* pMessage = nullptr;
+        while (Dequeue(&pMessage)) {
+            Write(pMessage->text.c_str(), pMessage->level);
+            pMessage->text.clear();
+            pMessage->text.shrink_to_fit();
+            if (pMessage->pWritten != nullptr) {
+                written.push_back(pMessage->pWritten);
+                pMessage->pWritten = nullptr;
+            }
+        }
+        FlushStreams();
+    }
+
+    if (!written.empty()) {
+        std::lock_guard lock(mFlushMutex);
+        for (std::atomic<bool>* pWritten : written) {
+            pWritten->store(true);
+        }
+        mWrittenCondition.notify_all();
+    }
+}
+
+void Log::StartFlushThread()
+{
+    mModes |= LOG_MODE_ASYNC;
+    mStopFlushThread = false;
+    mFlushThread     = std::thread(&Log::FlushThreadMain, this);
+}
+
+void Log::StopFlushThread()
+{
+    if (!mFlushThread.joinable()) {
+        return;
+    }
+
+    mModes &= ~LOG_MODE_ASYNC;
+    {
+        std::lock_guard lock(mFlushMutex);
+        mStopFlushThread = true;
+        mFlushCondition.notify_one();
+    }
+    mFlushThread.join();
+
+    // Messages enqueued by threads that saw LOG_MODE_ASYNC just before it
+    // was cleared
+    WriteQueuedMessages();
+}
+
+void Log::FlushThreadMain()
+{
+    std::unique_lock<std::mutex> lock(mFlushMutex);
+    while (true) {
+        mFlushCondition.wait_for(lock, kAsyncFlushInterval, [this]() { return mFlushRequested || mStopFlushThread; });
+        const bool stop = mStopFlushThread;
+        mFlushRequested = false;
+
+        lock.unlock();
+        WriteQueuedMessages();
+        lock.lock();
+
+        if (stop) {
+            break;
+        }
+    }
 }
 
 } // namespace ppx
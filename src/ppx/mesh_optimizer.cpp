@@ -0,0 +1,1035 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/mesh_optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+namespace ppx {
+
+namespace {
+
+// Triangles that use each vertex
+struct TriangleAdjacency
+{
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+};
+
+void BuildTriangleAdjacency(const uint32_t* pIndices, uint32_t triangleCount, uint32_t vertexCount, TriangleAdjacency& adjacency)
+{
+    adjacency.counts.assign(vertexCount, 0);
+    for (uint32_t i = 0; i < 3 * triangleCount; ++i) {
+        ++adjacency.counts[pIndices[i]];
+    }
+
+    adjacency.offsets.resize(vertexCount);
+    uint32_t offset = 0;
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        adjacency.offsets[v] = offset;
+        offset += adjacency.counts[v];
+    }
+
+    std::vector<uint32_t> fill = adjacency.offsets;
+    adjacency.triangles.resize(3 * triangleCount);
+    for (uint32_t i = 0; i < 3 * triangleCount; ++i) {
+        adjacency.triangles[fill[pIndices[i]]++] = i / 3;
+    }
+}
+
+// FIFO cache: a vertex is in the cache until cacheSize newer vertices have
+// been added, hits don't move it. Bumping the time stamp by more than the
+// cache size empties it.
+class FifoCache
+{
+public:
+    FifoCache(uint32_t vertexCount, uint32_t cacheSize)
+        : mTimeStamps(vertexCount, 0), mTimeStamp(cacheSize + 1), mCacheSize(cacheSize) {}
+
+    bool Contains(uint32_t v) const { return (mTimeStamp - mTimeStamps[v]) <= mCacheSize; }
+    void Clear() { mTimeStamp += mCacheSize + 1; }
+
+    // Returns 1 for a miss
+    uint32_t Access(uint32_t v)
+    {
+        if (Contains(v)) {
+            return 0;
+        }
+        mTimeStamps[v] = mTimeStamp++;
+        return 1;
+    }
+
+    uint32_t Age(uint32_t v) const { return mTimeStamp - mTimeStamps[v]; }
+
+private:
+    std::vector<uint32_t> mTimeStamps;
+    uint32_t              mTimeStamp = 0;
+    uint32_t              mCacheSize = 0;
+};
+
+bool IndicesInRange(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+{
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        if (pIndices[i] >= vertexCount) {
+            PPX_ASSERT_MSG(false, "index " << i << " references a vertex out of range");
+            return false;
+        }
+    }
+    return true;
+}
+
+float3 GetPosition(const float* pPositions, uint32_t positionStride, uint32_t v)
+{
+    const float* pPosition = reinterpret_cast<const float*>(reinterpret_cast<const char*>(pPositions) + v * positionStride);
+    return float3(pPosition[0], pPosition[1], pPosition[2]);
+}
+
+float* GetElement(float* pData, uint32_t stride, uint32_t v)
+{
+    return reinterpret_cast<float*>(reinterpret_cast<char*>(pData) + static_cast<size_t>(v) * stride);
+}
+
+// Normals and tangents are generated on a thread per this many vertices
+// or triangles
+constexpr uint32_t kMinItemsPerTask = 16384;
+
+// Splits [0, count) into one range per thread, including the calling one,
+// and runs fn(begin, end) on each. The ranges don't overlap, so fn can
+// write the results of its range without synchronization.
+template <typename Fn>
+void ForEachRange(uint32_t count, Fn fn)
+{
+    const uint32_t maxTasks  = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    const uint32_t taskCount = std::clamp<uint32_t>(count / kMinItemsPerTask, 1, maxTasks);
+    auto           begin     = [count, taskCount](uint32_t task) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(count) * task) / taskCount);
+    };
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < taskCount; ++i) {
+        workers.emplace_back(fn, begin(i), begin(i + 1));
+    }
+    fn(0, begin(1));
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Returns the angle at corner v of triangle t, with the edges projected
+// onto the plane of normal unless it's zero
+float GetCornerAngle(const uint32_t* pIndices, const float* pPositions, uint32_t positionStride, uint32_t t, uint32_t v, const float3& normal)
+{
+    uint32_t k = 0;
+    while ((k < 2) && (pIndices[3 * t + k] != v)) {
+        ++k;
+    }
+
+    const float3 position = GetPosition(pPositions, positionStride, v);
+    float3       e1       = GetPosition(pPositions, positionStride, pIndices[3 * t + (k + 1) % 3]) - position;
+    float3       e2       = GetPosition(pPositions, positionStride, pIndices[3 * t + (k + 2) % 3]) - position;
+    e1 -= normal * glm::dot(normal, e1);
+    e2 -= normal * glm::dot(normal, e2);
+
+    const float length = glm::length(e1) * glm::length(e2);
+    if (length <= 0.0f) {
+        return 0.0f;
+    }
+    return std::acos(std::clamp(glm::dot(e1, e2) / length, -1.0f, 1.0f));
+}
+
+// Area weighted sum of the squared distances to triangle planes, the upper
+// triangle of the symmetric 4x4 matrix row by row
+struct Quadric
+{
+    double m[10] = {};
+    double weight = 0;
+
+    void AddPlane(const float3& normal, float d, double area)
+    {
+        const double plane[4] = {normal.x, normal.y, normal.z, d};
+        uint32_t     k        = 0;
+        for (uint32_t i = 0; i < 4; ++i) {
+            for (uint32_t j = i; j < 4; ++j) {
+                m[k++] += area * plane[i] * plane[j];
+            }
+        }
+        weight += area;
+    }
+
+    void Add(const Quadric& other)
+    {
+        for (uint32_t k = 0; k < 10; ++k) {
+            m[k] += other.m[k];
+        }
+        weight += other.weight;
+    }
+
+    // Mean squared distance of position to the planes
+    double Evaluate(const float3& position) const
+    {
+        if (weight <= 0) {
+            return 0;
+        }
+
+        const double v[4] = {position.x, position.y, position.z, 1};
+        double       sum  = 0;
+        uint32_t     k    = 0;
+        for (uint32_t i = 0; i < 4; ++i) {
+            for (uint32_t j = i; j < 4; ++j) {
+                sum += ((i == j) ? 1 : 2) * m[k++] * v[i] * v[j];
+            }
+        }
+        return std::max(sum, 0.0) / weight;
+    }
+};
+
+struct EdgeCollapse
+{
+    double   cost = 0;
+    uint32_t from = 0;
+    uint32_t to   = 0;
+
+    bool operator>(const EdgeCollapse& other) const { return cost > other.cost; }
+};
+
+uint32_t GetLodTargetIndexCount(const MeshLodOptions& options, uint32_t indexCount, uint32_t lod)
+{
+    const double reduction = std::clamp(options.reduction, 0.0f, 1.0f);
+    return 3 * static_cast<uint32_t>((indexCount / 3) * std::pow(reduction, static_cast<double>(lod)));
+}
+
+} // namespace
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+{
+    VertexCacheStats stats         = {};
+    const uint32_t   triangleCount = indexCount / 3;
+    if ((triangleCount == 0) || !IndicesInRange(pIndices, 3 * triangleCount, vertexCount)) {
+        return stats;
+    }
+
+    FifoCache         cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    uint32_t          referencedCount = 0;
+    for (uint32_t i = 0; i < 3 * triangleCount; ++i) {
+        const uint32_t v = pIndices[i];
+        stats.vertexShaderInvocations += cache.Access(v);
+        if (!referenced[v]) {
+            referenced[v] = true;
+            ++referencedCount;
+        }
+    }
+
+    stats.acmr = static_cast<float>(stats.vertexShaderInvocations) / static_cast<float>(triangleCount);
+    stats.atvr = static_cast<float>(stats.vertexShaderInvocations) / static_cast<float>(referencedCount);
+    return stats;
+}
+
+void OptimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+{
+    const uint32_t triangleCount = indexCount / 3;
+    if ((triangleCount < 2) || !IndicesInRange(pIndices, 3 * triangleCount, vertexCount)) {
+        return;
+    }
+
+    const uint32_t cacheSize = PPX_MESH_OPTIMIZER_CACHE_SIZE;
+
+    TriangleAdjacency adjacency;
+    BuildTriangleAdjacency(pIndices, triangleCount, vertexCount, adjacency);
+
+    std::vector<uint32_t> liveTriangles = adjacency.counts;
+    std::vector<bool>     emitted(triangleCount, false);
+    std::vector<uint32_t> deadEndStack;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    FifoCache             cache(vertexCount, cacheSize);
+    uint32_t              cursor = 0;
+
+    output.reserve(3 * triangleCount);
+
+    // Fan out from a vertex, then continue from the neighbour that's
+    // expected to stay in the cache the longest.
+    uint32_t fanningVertex = pIndices[0];
+    while (fanningVertex != UINT32_MAX) {
+        candidates.clear();
+
+        const uint32_t begin = adjacency.offsets[fanningVertex];
+        const uint32_t end   = begin + adjacency.counts[fanningVertex];
+        for (uint32_t k = begin; k < end; ++k) {
+            const uint32_t t = adjacency.triangles[k];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+
+            for (uint32_t j = 0; j < 3; ++j) {
+                const uint32_t v = pIndices[3 * t + j];
+                output.push_back(v);
+                deadEndStack.push_back(v);
+                candidates.push_back(v);
+                --liveTriangles[v];
+                cache.Access(v);
+            }
+        }
+
+        // Candidates that are still in the cache after their remaining
+        // triangles are emitted, preferring the oldest
+        fanningVertex        = UINT32_MAX;
+        int64_t bestPriority = -1;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+
+            int64_t priority = 0;
+            if ((cache.Age(v) + 2 * liveTriangles[v]) <= cacheSize) {
+                priority = cache.Age(v);
+            }
+            if (priority > bestPriority) {
+                bestPriority  = priority;
+                fanningVertex = v;
+            }
+        }
+
+        // Dead end: recently used vertices, then the first vertex that's left
+        while ((fanningVertex == UINT32_MAX) && !deadEndStack.empty()) {
+            const uint32_t v = deadEndStack.back();
+            deadEndStack.pop_back();
+            if (liveTriangles[v] > 0) {
+                fanningVertex = v;
+            }
+        }
+        while ((fanningVertex == UINT32_MAX) && (cursor < vertexCount)) {
+            if (liveTriangles[cursor] > 0) {
+                fanningVertex = cursor;
+            }
+            ++cursor;
+        }
+    }
+
+    PPX_ASSERT_MSG(output.size() == (3 * triangleCount), "vertex cache optimization lost triangles");
+    std::copy(output.begin(), output.end(), pIndices);
+}
+
+void OptimizeOverdraw(
+    uint32_t*    pIndices,
+    uint32_t     indexCount,
+    const float* pPositions,
+    uint32_t     positionStride,
+    uint32_t     vertexCount,
+    float        threshold)
+{
+    const uint32_t triangleCount = indexCount / 3;
+    if ((triangleCount < 2) || IsNull(pPositions) || !IndicesInRange(pIndices, 3 * triangleCount, vertexCount)) {
+        return;
+    }
+
+    const uint32_t cacheSize = PPX_MESH_OPTIMIZER_CACHE_SIZE;
+    const float    meshAcmr  = AnalyzeVertexCache(pIndices, indexCount, vertexCount, cacheSize).acmr;
+
+    // Clusters start where the cache optimized order restarts, a triangle
+    // that misses all of its vertices. They're split further as long as
+    // each piece stays within threshold of the mesh ACMR on its own.
+    std::vector<uint32_t> clusterStarts;
+    {
+        FifoCache cache(vertexCount, cacheSize);
+        uint32_t  clusterStart  = 0;
+        uint32_t  clusterMisses = 0;
+        for (uint32_t t = 0; t < triangleCount; ++t) {
+            uint32_t misses = 0;
+            for (uint32_t j = 0; j < 3; ++j) {
+                misses += cache.Access(pIndices[3 * t + j]);
+            }
+
+            if ((t == 0) || (misses == 3)) {
+                clusterStarts.push_back(t);
+                clusterStart  = t;
+                clusterMisses = 0;
+            }
+            clusterMisses += misses;
+
+            const float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(t + 1 - clusterStart);
+            if (((t + 1) < triangleCount) && (clusterAcmr <= (meshAcmr * threshold))) {
+                clusterStarts.push_back(t + 1);
+                clusterStart  = t + 1;
+                clusterMisses = 0;
+                cache.Clear();
+            }
+        }
+    }
+
+    // Drop the duplicate a soft split followed by a hard one makes
+    clusterStarts.erase(std::unique(clusterStarts.begin(), clusterStarts.end()), clusterStarts.end());
+
+    const uint32_t clusterCount = CountU32(clusterStarts);
+    if (clusterCount < 2) {
+        return;
+    }
+
+    // Area weighted centroid and normal of each cluster
+    std::vector<float3> clusterCentroids(clusterCount, float3(0));
+    std::vector<float3> clusterNormals(clusterCount, float3(0));
+    float3              meshCentroid = float3(0);
+    float               meshArea     = 0;
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+        const uint32_t begin = clusterStarts[c];
+        const uint32_t end   = ((c + 1) < clusterCount) ? clusterStarts[c + 1] : triangleCount;
+
+        float area = 0;
+        for (uint32_t t = begin; t < end; ++t) {
+            const float3 p0 = GetPosition(pPositions, positionStride, pIndices[3 * t + 0]);
+            const float3 p1 = GetPosition(pPositions, positionStride, pIndices[3 * t + 1]);
+            const float3 p2 = GetPosition(pPositions, positionStride, pIndices[3 * t + 2]);
+
+            const float3 normal       = glm::cross(p1 - p0, p2 - p0);
+            const float  triangleArea = glm::length(normal);
+            clusterCentroids[c] += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            clusterNormals[c] += normal;
+            area += triangleArea;
+        }
+
+        meshCentroid += clusterCentroids[c];
+        meshArea += area;
+        if (area > 0) {
+            clusterCentroids[c] /= area;
+        }
+    }
+    if (meshArea > 0) {
+        meshCentroid /= meshArea;
+    }
+
+    // Clusters facing away from the center occlude the others, draw them first
+    std::vector<float> sortKeys(clusterCount, 0);
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+        const float length = glm::length(clusterNormals[c]);
+        if (length > 0) {
+            sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / length);
+        }
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    for (uint32_t c = 0; c < clusterCount; ++c) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(3 * triangleCount);
+    for (uint32_t c : order) {
+        const uint32_t begin = clusterStarts[c];
+        const uint32_t end   = ((c + 1) < clusterCount) ? clusterStarts[c + 1] : triangleCount;
+        output.insert(output.end(), pIndices + 3 * begin, pIndices + 3 * end);
+    }
+    std::copy(output.begin(), output.end(), pIndices);
+}
+
+uint32_t OptimizeVertexFetchRemap(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, std::vector<uint32_t>* pRemap)
+{
+    PPX_ASSERT_NULL_ARG(pRemap);
+
+    pRemap->assign(vertexCount, UINT32_MAX);
+    if (!IndicesInRange(pIndices, indexCount, vertexCount)) {
+        pRemap->clear();
+        return 0;
+    }
+
+    uint32_t nextIndex = 0;
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        uint32_t& newIndex = (*pRemap)[pIndices[i]];
+        if (newIndex == UINT32_MAX) {
+            newIndex = nextIndex++;
+        }
+        pIndices[i] = newIndex;
+    }
+
+    const uint32_t referencedCount = nextIndex;
+    for (auto& newIndex : *pRemap) {
+        if (newIndex == UINT32_MAX) {
+            newIndex = nextIndex++;
+        }
+    }
+    return referencedCount;
+}
+
+void RemapVertexData(void* pVertexData, uint32_t elementSize, uint32_t vertexCount, const std::vector<uint32_t>& remap)
+{
+    if (IsNull(pVertexData) || (elementSize == 0) || remap.empty()) {
+        return;
+    }
+    PPX_ASSERT_MSG(remap.size() == vertexCount, "vertex remap size doesn't match vertex count");
+
+    char*                   pData = static_cast<char*>(pVertexData);
+    const std::vector<char> source(pData, pData + static_cast<size_t>(vertexCount) * elementSize);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        memcpy(pData + static_cast<size_t>(remap[v]) * elementSize, source.data() + static_cast<size_t>(v) * elementSize, elementSize);
+    }
+}
+
+void OptimizeMesh(
+    const MeshOptimizeOptions& options,
+    uint32_t*                  pIndices,
+    uint32_t                   indexCount,
+    const float*               pPositions,
+    uint32_t                   positionStride,
+    uint32_t                   vertexCount,
+    std::vector<uint32_t>*     pRemap)
+{
+    if (!IsNull(pRemap)) {
+        pRemap->clear();
+    }
+    if (IsNull(pIndices) || (indexCount == 0)) {
+        return;
+    }
+
+    if (options.vertexCache || options.overdraw) {
+        OptimizeVertexCache(pIndices, indexCount, vertexCount);
+    }
+    if (options.overdraw) {
+        OptimizeOverdraw(pIndices, indexCount, pPositions, positionStride, vertexCount, options.overdrawThreshold);
+    }
+    if (options.vertexFetch && !IsNull(pRemap)) {
+        OptimizeVertexFetchRemap(pIndices, indexCount, vertexCount, pRemap);
+    }
+}
+
+uint32_t GenerateTriangleStrips(
+    const uint32_t*        pIndices,
+    uint32_t               indexCount,
+    uint32_t               vertexCount,
+    uint32_t               restartIndex,
+    std::vector<uint32_t>* pStrips)
+{
+    PPX_ASSERT_NULL_ARG(pStrips);
+    PPX_ASSERT_MSG(vertexCount <= restartIndex, "restart index is a vertex index");
+
+    pStrips->clear();
+    const uint32_t triangleCount = indexCount / 3;
+    if (IsNull(pIndices) || (triangleCount == 0) || !IndicesInRange(pIndices, 3 * triangleCount, vertexCount)) {
+        return 0;
+    }
+
+    TriangleAdjacency adjacency;
+    BuildTriangleAdjacency(pIndices, triangleCount, vertexCount, adjacency);
+
+    std::vector<bool> emitted(triangleCount, false);
+
+    // Finds a triangle not in a strip yet with the edge a -> b and its third vertex
+    auto findTriangle = [&](uint32_t a, uint32_t b, uint32_t* pThird) -> uint32_t {
+        const uint32_t* pTriangles = adjacency.triangles.data() + adjacency.offsets[a];
+        for (uint32_t i = 0; i < adjacency.counts[a]; ++i) {
+            const uint32_t t = pTriangles[i];
+            if (emitted[t]) {
+                continue;
+            }
+            const uint32_t* pTri = pIndices + 3 * t;
+            for (uint32_t k = 0; k < 3; ++k) {
+                if ((pTri[k] == a) && (pTri[(k + 1) % 3] == b)) {
+                    *pThird = pTri[(k + 2) % 3];
+                    return t;
+                }
+            }
+        }
+        return UINT32_MAX;
+    };
+
+    pStrips->reserve(indexCount);
+    for (uint32_t start = 0; start < triangleCount; ++start) {
+        if (emitted[start]) {
+            continue;
+        }
+        emitted[start] = true;
+
+        // Rotate the first triangle so the strip can continue across its last edge
+        const uint32_t* pTri     = pIndices + 3 * start;
+        uint32_t        rotation = 0;
+        for (uint32_t r = 0; r < 3; ++r) {
+            uint32_t third = 0;
+            if (findTriangle(pTri[(r + 2) % 3], pTri[(r + 1) % 3], &third) != UINT32_MAX) {
+                rotation = r;
+                break;
+            }
+        }
+
+        if (!pStrips->empty()) {
+            pStrips->push_back(restartIndex);
+        }
+        pStrips->push_back(pTri[rotation]);
+        pStrips->push_back(pTri[(rotation + 1) % 3]);
+        pStrips->push_back(pTri[(rotation + 2) % 3]);
+
+        // Strip triangle i is (i, i + 1, i + 2) for even i and (i + 1, i, i + 2)
+        // for odd i, so the edge to continue across alternates direction
+        for (uint32_t i = 1;; ++i) {
+            const uint32_t p     = (*pStrips)[pStrips->size() - 2];
+            const uint32_t q     = (*pStrips)[pStrips->size() - 1];
+            uint32_t       third = 0;
+            const uint32_t t     = ((i % 2) == 0) ? findTriangle(p, q, &third) : findTriangle(q, p, &third);
+            if (t == UINT32_MAX) {
+                break;
+            }
+            emitted[t] = true;
+            pStrips->push_back(third);
+        }
+    }
+
+    return CountU32(*pStrips);
+}
+
+float SimplifyMesh(
+    const uint32_t*        pIndices,
+    uint32_t               indexCount,
+    const float*           pPositions,
+    uint32_t               positionStride,
+    uint32_t               vertexCount,
+    uint32_t               targetIndexCount,
+    float                  maxError,
+    std::vector<uint32_t>* pResult)
+{
+    PPX_ASSERT_NULL_ARG(pResult);
+
+    pResult->clear();
+    const uint32_t triangleCount = indexCount / 3;
+    if ((triangleCount == 0) || IsNull(pPositions) || !IndicesInRange(pIndices, 3 * triangleCount, vertexCount)) {
+        return 0;
+    }
+
+    // Vertices that share a position are one vertex of the surface, such as
+    // the copies along a UV seam
+    std::vector<uint32_t> positionIds(vertexCount);
+    std::vector<uint32_t> positionCopies(vertexCount, 0);
+    {
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            const float3 pa = GetPosition(pPositions, positionStride, a);
+            const float3 pb = GetPosition(pPositions, positionStride, b);
+            return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+        });
+
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const bool sameAsPrevious = (i > 0) && (GetPosition(pPositions, positionStride, order[i]) == GetPosition(pPositions, positionStride, order[i - 1]));
+            positionIds[order[i]]     = sameAsPrevious ? positionIds[order[i - 1]] : order[i];
+            ++positionCopies[positionIds[order[i]]];
+        }
+    }
+
+    // Seams, open borders and non-manifold edges are locked
+    std::vector<bool> locked(vertexCount, false);
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        locked[v] = (positionCopies[positionIds[v]] > 1);
+    }
+    {
+        std::unordered_map<uint64_t, uint32_t> edgeTriangleCounts;
+        for (uint32_t i = 0; i < 3 * triangleCount; ++i) {
+            const uint32_t a = positionIds[pIndices[i]];
+            const uint32_t b = positionIds[pIndices[(i % 3 == 2) ? (i - 2) : (i + 1)]];
+            ++edgeTriangleCounts[(static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b)];
+        }
+        for (uint32_t i = 0; i < 3 * triangleCount; ++i) {
+            const uint32_t a  = pIndices[i];
+            const uint32_t b  = pIndices[(i % 3 == 2) ? (i - 2) : (i + 1)];
+            const uint32_t pa = positionIds[a];
+            const uint32_t pb = positionIds[b];
+            if (edgeTriangleCounts[(static_cast<uint64_t>(std::min(pa, pb)) << 32) | std::max(pa, pb)] != 2) {
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+    }
+
+    // Working copy of the triangles, degenerate ones are dropped
+    std::vector<uint32_t>              indices(pIndices, pIndices + 3 * triangleCount);
+    std::vector<bool>                  removed(triangleCount, false);
+    std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+    std::vector<Quadric>               quadrics(vertexCount);
+    uint32_t                           liveIndexCount = 0;
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* pTriangle = &indices[3 * t];
+        if ((pTriangle[0] == pTriangle[1]) || (pTriangle[1] == pTriangle[2]) || (pTriangle[0] == pTriangle[2])) {
+            removed[t] = true;
+            continue;
+        }
+        liveIndexCount += 3;
+
+        const float3 p0     = GetPosition(pPositions, positionStride, pTriangle[0]);
+        const float3 p1     = GetPosition(pPositions, positionStride, pTriangle[1]);
+        const float3 p2     = GetPosition(pPositions, positionStride, pTriangle[2]);
+        const float3 normal = glm::cross(p1 - p0, p2 - p0);
+        const float  length = glm::length(normal);
+        for (uint32_t j = 0; j < 3; ++j) {
+            vertexTriangles[pTriangle[j]].push_back(t);
+            if (length > 0) {
+                quadrics[positionIds[pTriangle[j]]].AddPlane(normal / length, -glm::dot(normal / length, p0), 0.5 * length);
+            }
+        }
+    }
+
+    auto collapseCost = [&](uint32_t from, uint32_t to) {
+        Quadric quadric = quadrics[positionIds[from]];
+        quadric.Add(quadrics[positionIds[to]]);
+        return quadric.Evaluate(GetPosition(pPositions, positionStride, to));
+    };
+
+    // Cheapest collapses first. Costs only grow as quadrics are merged, so
+    // stale entries are re-queued with their current cost when they come up.
+    std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>, std::greater<EdgeCollapse>> queue;
+
+    auto pushEdge = [&](uint32_t from, uint32_t to) {
+        if (!locked[from] && (positionIds[from] != positionIds[to])) {
+            queue.push({collapseCost(from, to), from, to});
+        }
+    };
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        if (removed[t]) {
+            continue;
+        }
+        for (uint32_t j = 0; j < 3; ++j) {
+            const uint32_t a = indices[3 * t + j];
+            const uint32_t b = indices[3 * t + (j + 1) % 3];
+            pushEdge(a, b);
+            pushEdge(b, a);
+        }
+    }
+
+    std::vector<bool>     collapsed(vertexCount, false);
+    std::vector<uint32_t> marks(vertexCount, 0);
+    uint32_t              mark     = 0;
+    const double          maxCost  = static_cast<double>(maxError) * static_cast<double>(maxError);
+    double                maxFound = 0;
+    while ((liveIndexCount > targetIndexCount) && !queue.empty()) {
+        const EdgeCollapse collapse = queue.top();
+        queue.pop();
+
+        const uint32_t from = collapse.from;
+        const uint32_t to   = collapse.to;
+        if (collapsed[from] || collapsed[to]) {
+            continue;
+        }
+
+        const double cost = collapseCost(from, to);
+        if (cost > collapse.cost) {
+            queue.push({cost, from, to});
+            continue;
+        }
+        if (cost > maxCost) {
+            break;
+        }
+
+        // The edge has to still exist, the vertices can only share the
+        // opposite corners of its triangles or the surface would fold onto
+        // itself, and no triangle that moves can flip
+        mark += 2;
+        uint32_t edgeTriangles = 0;
+        bool     valid         = true;
+        for (uint32_t t : vertexTriangles[from]) {
+            if (removed[t]) {
+                continue;
+            }
+
+            const uint32_t* pTriangle = &indices[3 * t];
+            if ((pTriangle[0] == to) || (pTriangle[1] == to) || (pTriangle[2] == to)) {
+                ++edgeTriangles;
+            }
+            else {
+                const float3 p0     = GetPosition(pPositions, positionStride, pTriangle[0]);
+                const float3 p1     = GetPosition(pPositions, positionStride, pTriangle[1]);
+                const float3 p2     = GetPosition(pPositions, positionStride, pTriangle[2]);
+                const float3 moved0 = GetPosition(pPositions, positionStride, (pTriangle[0] == from) ? to : pTriangle[0]);
+                const float3 moved1 = GetPosition(pPositions, positionStride, (pTriangle[1] == from) ? to : pTriangle[1]);
+                const float3 moved2 = GetPosition(pPositions, positionStride, (pTriangle[2] == from) ? to : pTriangle[2]);
+                if (glm::dot(glm::cross(p1 - p0, p2 - p0), glm::cross(moved1 - moved0, moved2 - moved0)) <= 0) {
+                    valid = false;
+                    break;
+                }
+            }
+
+            for (uint32_t j = 0; j < 3; ++j) {
+                if (pTriangle[j] != from) {
+                    marks[pTriangle[j]] = mark;
+                }
+            }
+        }
+        if (!valid || (edgeTriangles == 0)) {
+            continue;
+        }
+
+        uint32_t sharedVertices = 0;
+        for (uint32_t t : vertexTriangles[to]) {
+            if (removed[t]) {
+                continue;
+            }
+            for (uint32_t j = 0; j < 3; ++j) {
+                const uint32_t v = indices[3 * t + j];
+                if ((v != to) && (marks[v] == mark)) {
+                    marks[v] = mark + 1;
+                    ++sharedVertices;
+                }
+            }
+        }
+        if (sharedVertices != edgeTriangles) {
+            continue;
+        }
+
+        // Collapse from into to
+        collapsed[from] = true;
+        for (uint32_t t : vertexTriangles[from]) {
+            if (removed[t]) {
+                continue;
+            }
+
+            uint32_t* pTriangle = &indices[3 * t];
+            if ((pTriangle[0] == to) || (pTriangle[1] == to) || (pTriangle[2] == to)) {
+                removed[t] = true;
+                liveIndexCount -= 3;
+                continue;
+            }
+            for (uint32_t j = 0; j < 3; ++j) {
+                pTriangle[j] = (pTriangle[j] == from) ? to : pTriangle[j];
+            }
+            vertexTriangles[to].push_back(t);
+        }
+        quadrics[positionIds[to]].Add(quadrics[positionIds[from]]);
+        maxFound = std::max(maxFound, cost);
+
+        for (uint32_t t : vertexTriangles[to]) {
+            if (removed[t]) {
+                continue;
+            }
+            for (uint32_t j = 0; j < 3; ++j) {
+                const uint32_t v = indices[3 * t + j];
+                if (v != to) {
+                    pushEdge(v, to);
+                    pushEdge(to, v);
+                }
+            }
+        }
+    }
+
+    pResult->reserve(liveIndexCount);
+    for (uint32_t t = 0; t < triangleCount; ++t) {
+        if (!removed[t]) {
+            pResult->insert(pResult->end(), indices.begin() + 3 * t, indices.begin() + 3 * (t + 1));
+        }
+    }
+
+    return static_cast<float>(std::sqrt(maxFound));
+}
+
+uint32_t GetMeshLodIndexCapacity(const MeshLodOptions& options, uint32_t indexCount)
+{
+    uint32_t       capacity = indexCount;
+    const uint32_t lodCount = std::min<uint32_t>(options.lodCount, PPX_MESH_MAX_LOD_COUNT);
+    for (uint32_t lod = 1; lod < lodCount; ++lod) {
+        const uint32_t targetIndexCount = GetLodTargetIndexCount(options, indexCount, lod);
+        if (targetIndexCount == 0) {
+            break;
+        }
+        capacity += targetIndexCount;
+    }
+    return capacity;
+}
+
+void GenerateMeshLods(
+    const MeshLodOptions&  options,
+    std::vector<uint32_t>* pIndices,
+    const float*           pPositions,
+    uint32_t               positionStride,
+    uint32_t               vertexCount,
+    std::vector<MeshLod>*  pLods)
+{
+    PPX_ASSERT_NULL_ARG(pIndices);
+    PPX_ASSERT_NULL_ARG(pLods);
+
+    const uint32_t indexCount = CountU32(*pIndices);
+    pLods->assign(1, MeshLod{0, indexCount, 0});
+    if (!options.IsEnabled() || (indexCount < 3) || IsNull(pPositions) || (vertexCount == 0)) {
+        return;
+    }
+
+    // The error limit is relative to the size of the mesh
+    float3 boundsMin = GetPosition(pPositions, positionStride, 0);
+    float3 boundsMax = boundsMin;
+    for (uint32_t v = 1; v < vertexCount; ++v) {
+        boundsMin = glm::min(boundsMin, GetPosition(pPositions, positionStride, v));
+        boundsMax = glm::max(boundsMax, GetPosition(pPositions, positionStride, v));
+    }
+    const float maxError = options.maxError * glm::length(boundsMax - boundsMin);
+
+    // Each LOD is simplified from the previous one, so their errors add up
+    std::vector<uint32_t> source(pIndices->begin(), pIndices->end());
+    std::vector<uint32_t> simplified;
+    float                 error    = 0;
+    const uint32_t        lodCount = std::min<uint32_t>(options.lodCount, PPX_MESH_MAX_LOD_COUNT);
+    for (uint32_t lod = 1; lod < lodCount; ++lod) {
+        const uint32_t targetIndexCount = GetLodTargetIndexCount(options, indexCount, lod);
+        if (targetIndexCount == 0) {
+            break;
+        }
+
+        const float lodError = SimplifyMesh(source.data(), CountU32(source), pPositions, positionStride, vertexCount, targetIndexCount, maxError - error, &simplified);
+        if (simplified.empty() || (simplified.size() > targetIndexCount)) {
+            break;
+        }
+        OptimizeVertexCache(simplified.data(), CountU32(simplified), vertexCount);
+
+        error += lodError;
+        pLods->push_back(MeshLod{CountU32(*pIndices), CountU32(simplified), error});
+        pIndices->insert(pIndices->end(), simplified.begin(), simplified.end());
+        source.swap(simplified);
+    }
+}
+
+
+void GenerateMeshNormals(
+    const uint32_t* pIndices,
+    uint32_t        indexCount,
+    const float*    pPositions,
+    uint32_t        positionStride,
+    uint32_t        vertexCount,
+    float*          pNormals,
+    uint32_t        normalStride)
+{
+    if (!IndicesInRange(pIndices, indexCount, vertexCount)) {
+        return;
+    }
+
+    // Unit normals of the triangles, zero for degenerate ones
+    const uint32_t      triangleCount = indexCount / 3;
+    std::vector<float3> faceNormals(triangleCount);
+    ForEachRange(triangleCount, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t t = begin; t < end; ++t) {
+            const float3 p0     = GetPosition(pPositions, positionStride, pIndices[3 * t + 0]);
+            const float3 p1     = GetPosition(pPositions, positionStride, pIndices[3 * t + 1]);
+            const float3 p2     = GetPosition(pPositions, positionStride, pIndices[3 * t + 2]);
+            const float3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float  length = glm::length(normal);
+            faceNormals[t]      = (length > 0.0f) ? (normal / length) : float3(0);
+        }
+    });
+
+    // Each vertex gathers from its own triangles
+    TriangleAdjacency adjacency;
+    BuildTriangleAdjacency(pIndices, triangleCount, vertexCount, adjacency);
+    ForEachRange(vertexCount, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t v = begin; v < end; ++v) {
+            float3 sum = float3(0);
+            for (uint32_t i = 0; i < adjacency.counts[v]; ++i) {
+                const uint32_t t = adjacency.triangles[adjacency.offsets[v] + i];
+                sum += faceNormals[t] * GetCornerAngle(pIndices, pPositions, positionStride, t, v, float3(0));
+            }
+
+            const float  length  = glm::length(sum);
+            const float3 normal  = (length > 0.0f) ? (sum / length) : float3(0);
+            float*       pNormal = GetElement(pNormals, normalStride, v);
+            pNormal[0]           = normal.x;
+            pNormal[1]           = normal.y;
+            pNormal[2]           = normal.z;
+        }
+    });
+}
+
+void GenerateMeshTangents(
+    const uint32_t* pIndices,
+    uint32_t        indexCount,
+    const float*    pPositions,
+    uint32_t        positionStride,
+    const float*    pNormals,
+    uint32_t        normalStride,
+    const float*    pTexCoords,
+    uint32_t        texCoordStride,
+    uint32_t        vertexCount,
+    float*          pTangents,
+    uint32_t        tangentStride)
+{
+    if (!IndicesInRange(pIndices, indexCount, vertexCount)) {
+        return;
+    }
+
+    auto getTexCoord = [pTexCoords, texCoordStride](uint32_t v) {
+        const float* pTexCoord = reinterpret_cast<const float*>(reinterpret_cast<const char*>(pTexCoords) + static_cast<size_t>(v) * texCoordStride);
+        return float2(pTexCoord[0], pTexCoord[1]);
+    };
+
+    // Unit tangents of the triangles and the sign of their UV area, a zero
+    // sign for triangles without a UV mapping
+    const uint32_t      triangleCount = indexCount / 3;
+    std::vector<float3> faceTangents(triangleCount);
+    std::vector<float>  faceSigns(triangleCount);
+    ForEachRange(triangleCount, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t t = begin; t < end; ++t) {
+            const uint32_t v0   = pIndices[3 * t + 0];
+            const float3   p0   = GetPosition(pPositions, positionStride, v0);
+            const float2   uv0  = getTexCoord(v0);
+            const float3   d1   = GetPosition(pPositions, positionStride, pIndices[3 * t + 1]) - p0;
+            const float3   d2   = GetPosition(pPositions, positionStride, pIndices[3 * t + 2]) - p0;
+            const float2   st1  = getTexCoord(pIndices[3 * t + 1]) - uv0;
+            const float2   st2  = getTexCoord(pIndices[3 * t + 2]) - uv0;
+            const float    area = (st1.x * st2.y) - (st1.y * st2.x);
+
+            // Scaled by the signed UV area, so the sign restores the direction
+            const float3 tangent = (d1 * st2.y) - (d2 * st1.y);
+            const float  length  = glm::length(tangent);
+            faceSigns[t]         = ((area == 0.0f) || (length <= 0.0f)) ? 0.0f : ((area > 0.0f) ? 1.0f : -1.0f);
+            faceTangents[t]      = (faceSigns[t] != 0.0f) ? (tangent * (faceSigns[t] / length)) : float3(0);
+        }
+    });
+
+    TriangleAdjacency adjacency;
+    BuildTriangleAdjacency(pIndices, triangleCount, vertexCount, adjacency);
+    ForEachRange(vertexCount, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t v = begin; v < end; ++v) {
+            const float3 normal      = GetPosition(pNormals, normalStride, v);
+            float3       sum         = float3(0);
+            float        orientation = 0;
+            for (uint32_t i = 0; i < adjacency.counts[v]; ++i) {
+                const uint32_t t = adjacency.triangles[adjacency.offsets[v] + i];
+                if (faceSigns[t] == 0.0f) {
+                    continue;
+                }
+
+                const float3 tangent = faceTangents[t] - normal * glm::dot(normal, faceTangents[t]);
+                const float  length  = glm::length(tangent);
+                if (length <= 0.0f) {
+                    continue;
+                }
+                const float angle = GetCornerAngle(pIndices, pPositions, positionStride, t, v, normal);
+                sum += tangent * (angle / length);
+                orientation += faceSigns[t] * angle;
+            }
+
+            // Vertices without a UV mapping get any tangent perpendicular to the normal
+            float3 tangent = sum;
+            if (glm::dot(tangent, tangent) <= 0.0f) {
+                const float3 axis = (std::abs(normal.x) < 0.9f) ? float3(1, 0, 0) : float3(0, 1, 0);
+                tangent           = axis - normal * glm::dot(normal, axis);
+            }
+            tangent = glm::normalize(tangent);
+
+            float* pTangent = GetElement(pTangents, tangentStride, v);
+            pTangent[0]     = tangent.x;
+            pTangent[1]     = tangent.y;
+            pTangent[2]     = tangent.z;
+            pTangent[3]     = (orientation < 0.0f) ? -1.0f : 1.0f;
+        }
+    });
+}
+
+} // namespace ppx
@@ -0,0 +1,114 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/meshlet.h"
+
+namespace ppx {
+
+Result MeshletMesh::Create(const TriMesh& mesh, MeshletMesh* pMeshletMesh)
+{
+    return Create(mesh, 64, 124, pMeshletMesh);
+}
+
+Result MeshletMesh::Create(const TriMesh& mesh, uint32_t maxVertices, uint32_t maxTriangles, MeshletMesh* pMeshletMesh)
+{
+    PPX_ASSERT_NULL_ARG(pMeshletMesh);
+
+    // A triangle needs up to 3 new vertices
+    if ((maxVertices < 3) || (maxVertices > PPX_MESHLET_MAX_VERTICES)) {
+        PPX_ASSERT_MSG(false, "maxVertices must be between 3 and " << PPX_MESHLET_MAX_VERTICES);
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    if ((maxTriangles < 1) || (maxTriangles > PPX_MESHLET_MAX_TRIANGLES)) {
+        PPX_ASSERT_MSG(false, "maxTriangles must be between 1 and " << PPX_MESHLET_MAX_TRIANGLES);
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    *pMeshletMesh               = MeshletMesh();
+    pMeshletMesh->mMaxVertices  = maxVertices;
+    pMeshletMesh->mMaxTriangles = maxTriangles;
+
+    const bool     indexed       = (mesh.GetIndexType() != grfx::INDEX_TYPE_UNDEFINED);
+    const uint32_t triangleCount = mesh.GetCountTriangles();
+    const uint32_t vertexCount   = mesh.GetCountPositions();
+    if (triangleCount == 0) {
+        return ppx::SUCCESS;
+    }
+
+    // Local index of each mesh vertex in the current meshlet, if it's in it
+    std::vector<uint32_t> vertexMeshlet(vertexCount, UINT32_MAX);
+    std::vector<uint8_t>  vertexLocalIndex(vertexCount, 0);
+
+    std::vector<Meshlet>&  meshlets      = pMeshletMesh->mMeshlets;
+    std::vector<uint32_t>& vertexIndices = pMeshletMesh->mVertexIndices;
+    std::vector<uint32_t>& triangles     = pMeshletMesh->mTriangles;
+
+    meshlets.reserve((triangleCount + maxTriangles - 1) / maxTriangles);
+    triangles.reserve(triangleCount);
+    meshlets.emplace_back();
+
+    for (uint32_t triIndex = 0; triIndex < triangleCount; ++triIndex) {
+        uint32_t v[3] = {3 * triIndex + 0, 3 * triIndex + 1, 3 * triIndex + 2};
+        if (indexed) {
+            Result ppxres = mesh.GetTriangle(triIndex, v[0], v[1], v[2]);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+        }
+        if ((v[0] >= vertexCount) || (v[1] >= vertexCount) || (v[2] >= vertexCount)) {
+            PPX_ASSERT_MSG(false, "triangle " << triIndex << " references a vertex out of range");
+            return ppx::ERROR_OUT_OF_RANGE;
+        }
+
+        uint32_t meshletIndex = CountU32(meshlets) - 1;
+
+        // Vertices not yet in the current meshlet, degenerate triangles
+        // reference the same vertex more than once.
+        uint32_t newVertexCount = 0;
+        for (uint32_t i = 0; i < 3; ++i) {
+            bool isDuplicate = (i > 0 && v[i] == v[0]) || (i > 1 && v[i] == v[1]);
+            if ((vertexMeshlet[v[i]] != meshletIndex) && !isDuplicate) {
+                ++newVertexCount;
+            }
+        }
+
+        // Start a new meshlet if this triangle doesn't fit
+        const Meshlet& current = meshlets.back();
+        if (((current.vertexCount + newVertexCount) > maxVertices) || (current.triangleCount == maxTriangles)) {
+            Meshlet next        = {};
+            next.vertexOffset   = CountU32(vertexIndices);
+            next.triangleOffset = CountU32(triangles);
+            meshlets.push_back(next);
+            ++meshletIndex;
+        }
+
+        Meshlet& meshlet = meshlets.back();
+        uint32_t packed  = 0;
+        for (uint32_t i = 0; i < 3; ++i) {
+            if (vertexMeshlet[v[i]] != meshletIndex) {
+                vertexMeshlet[v[i]]    = meshletIndex;
+                vertexLocalIndex[v[i]] = static_cast<uint8_t>(meshlet.vertexCount);
+                vertexIndices.push_back(v[i]);
+                ++meshlet.vertexCount;
+            }
+            packed |= static_cast<uint32_t>(vertexLocalIndex[v[i]]) << (8 * i);
+        }
+        triangles.push_back(packed);
+        ++meshlet.triangleCount;
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
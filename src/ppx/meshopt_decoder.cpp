@@ -0,0 +1,499 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/meshopt_decoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ppx {
+
+namespace {
+
+constexpr uint8_t kVertexHeader         = 0xA0;
+constexpr uint8_t kIndexHeader          = 0xE0;
+constexpr uint8_t kSequenceHeader       = 0xD0;
+constexpr size_t  kVertexBlockSizeBytes = 8192;
+constexpr size_t  kVertexBlockMaxSize   = 256;
+constexpr size_t  kByteGroupSize        = 16;
+constexpr size_t  kVertexTailMinSize    = 32;
+constexpr size_t  kIndexCodeAuxSize     = 16;
+constexpr size_t  kSequenceTailSize     = 4;
+
+// Reads bytes from [pData, pEnd), the read position is only advanced by
+// successful reads.
+struct ByteReader
+{
+    const uint8_t* pData = nullptr;
+    const uint8_t* pEnd  = nullptr;
+
+    size_t Remaining() const { return static_cast<size_t>(pEnd - pData); }
+
+    bool Read(uint8_t& value)
+    {
+        if (pData >= pEnd) {
+            return false;
+        }
+        value = *pData++;
+        return true;
+    }
+
+    // Little endian base 128, at most 5 bytes
+    bool ReadVByte(uint32_t& value)
+    {
+        uint8_t group = 0;
+        if (!Read(group)) {
+            return false;
+        }
+        value          = group & 0x7F;
+        uint32_t shift = 7;
+        for (uint32_t i = 0; (i < 4) && (group >= 0x80); ++i, shift += 7) {
+            if (!Read(group)) {
+                return false;
+            }
+            value |= static_cast<uint32_t>(group & 0x7F) << shift;
+        }
+        return true;
+    }
+};
+
+uint8_t Unzigzag8(uint8_t value)
+{
+    return static_cast<uint8_t>(-(value & 1) ^ (value >> 1));
+}
+
+uint32_t Unzigzag32(uint32_t value)
+{
+    return (value >> 1) ^ (0u - (value & 1));
+}
+
+// Vertex blocks hold up to 256 vertices in multiples of the byte group size
+size_t GetVertexBlockSize(size_t stride)
+{
+    size_t size = (kVertexBlockSizeBytes / stride) & ~(kByteGroupSize - 1);
+    return (size < kVertexBlockMaxSize) ? size : kVertexBlockMaxSize;
+}
+
+// Group of 16 deltas at 0, 2, 4 or 8 bits each. Values that don't fit in
+// 2 or 4 bits are stored as all ones followed by a full byte, after the
+// packed values.
+bool DecodeBytesGroup(ByteReader& reader, uint32_t bitsLog2, uint8_t* pDst)
+{
+    if (bitsLog2 == 0) {
+        memset(pDst, 0, kByteGroupSize);
+        return true;
+    }
+    if (bitsLog2 == 3) {
+        if (reader.Remaining() < kByteGroupSize) {
+            return false;
+        }
+        memcpy(pDst, reader.pData, kByteGroupSize);
+        reader.pData += kByteGroupSize;
+        return true;
+    }
+
+    const uint32_t bits      = 1u << bitsLog2;
+    const uint32_t escape    = (1u << bits) - 1;
+    const size_t   codeBytes = (kByteGroupSize * bits) / 8;
+    if (reader.Remaining() < codeBytes) {
+        return false;
+    }
+
+    const uint8_t* pCodes = reader.pData;
+    ByteReader     extra  = {reader.pData + codeBytes, reader.pEnd};
+    for (size_t i = 0; i < kByteGroupSize; ++i) {
+        // Values are packed starting at the high bits
+        const size_t   bit   = i * bits;
+        const uint32_t value = (pCodes[bit / 8] >> (8 - bits - (bit % 8))) & escape;
+        if (value == escape) {
+            if (!extra.Read(pDst[i])) {
+                return false;
+            }
+        }
+        else {
+            pDst[i] = static_cast<uint8_t>(value);
+        }
+    }
+    reader.pData = extra.pData;
+    return true;
+}
+
+// count is a multiple of the byte group size. A 2-bit per group header
+// holds each group's bit width.
+bool DecodeBytes(ByteReader& reader, size_t count, uint8_t* pDst)
+{
+    const size_t groupCount = count / kByteGroupSize;
+    const size_t headerSize = (groupCount + 3) / 4;
+    if (reader.Remaining() < headerSize) {
+        return false;
+    }
+
+    const uint8_t* pHeader = reader.pData;
+    reader.pData += headerSize;
+    for (size_t i = 0; i < groupCount; ++i) {
+        const uint32_t bitsLog2 = (pHeader[i / 4] >> ((i % 4) * 2)) & 3;
+        if (!DecodeBytesGroup(reader, bitsLog2, pDst + i * kByteGroupSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Each byte of the vertex is a separate stream of deltas from the same
+// byte of the previous vertex
+bool DecodeVertexBlock(ByteReader& reader, size_t count, size_t stride, uint8_t* pLastVertex, uint8_t* pDst)
+{
+    uint8_t      deltas[kVertexBlockMaxSize];
+    const size_t alignedCount = (count + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+    for (size_t k = 0; k < stride; ++k) {
+        if (!DecodeBytes(reader, alignedCount, deltas)) {
+            return false;
+        }
+
+        uint8_t previous = pLastVertex[k];
+        for (size_t i = 0; i < count; ++i) {
+            previous             = static_cast<uint8_t>(Unzigzag8(deltas[i]) + previous);
+            pDst[i * stride + k] = previous;
+        }
+    }
+    memcpy(pLastVertex, pDst + (count - 1) * stride, stride);
+    return true;
+}
+
+void WriteIndex(void* pDst, size_t index, size_t indexSize, uint32_t value)
+{
+    if (indexSize == 2) {
+        static_cast<uint16_t*>(pDst)[index] = static_cast<uint16_t>(value);
+    }
+    else {
+        static_cast<uint32_t*>(pDst)[index] = value;
+    }
+}
+
+struct IndexFifos
+{
+    uint32_t vertices[16];
+    uint32_t edges[16][2];
+    uint32_t vertexOffset = 0;
+    uint32_t edgeOffset   = 0;
+
+    IndexFifos()
+    {
+        memset(vertices, 0xFF, sizeof(vertices));
+        memset(edges, 0xFF, sizeof(edges));
+    }
+
+    uint32_t Vertex(uint32_t age) const { return vertices[(vertexOffset - age) & 15]; }
+
+    void PushVertex(uint32_t v, bool cond = true)
+    {
+        vertices[vertexOffset] = v;
+        vertexOffset           = (vertexOffset + (cond ? 1 : 0)) & 15;
+    }
+
+    void PushEdge(uint32_t a, uint32_t b)
+    {
+        edges[edgeOffset][0] = a;
+        edges[edgeOffset][1] = b;
+        edgeOffset           = (edgeOffset + 1) & 15;
+    }
+};
+
+template <typename T>
+void DecodeFilterOctahedral(T* pData, size_t count, size_t stride)
+{
+    const float maxValue = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t i = 0; i < count; ++i) {
+        T* pElement = reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(pData) + i * stride);
+
+        // z holds the value that 1 encodes as, at the same bit count
+        float x = static_cast<float>(pElement[0]);
+        float y = static_cast<float>(pElement[1]);
+        float z = static_cast<float>(pElement[2]) - std::fabs(x) - std::fabs(y);
+
+        // Unfold the lower hemisphere
+        const float t = (z >= 0.0f) ? 0.0f : z;
+        x += (x >= 0.0f) ? t : -t;
+        y += (y >= 0.0f) ? t : -t;
+
+        const float s = maxValue / std::sqrt(x * x + y * y + z * z);
+        pElement[0]   = static_cast<T>(std::lround(x * s));
+        pElement[1]   = static_cast<T>(std::lround(y * s));
+        pElement[2]   = static_cast<T>(std::lround(z * s));
+    }
+}
+
+void DecodeFilterQuaternion(int16_t* pData, size_t count)
+{
+    const float scale = 1.0f / std::sqrt(2.0f);
+    for (size_t i = 0; i < count; ++i) {
+        int16_t* pElement = pData + i * 4;
+
+        // The low 2 bits of w are the index of the dropped component, the
+        // rest is the range the other 3 were quantized to
+        const int   range = pElement[3] | 3;
+        const float s     = scale / static_cast<float>(range);
+        const float x     = static_cast<float>(pElement[0]) * s;
+        const float y     = static_cast<float>(pElement[1]) * s;
+        const float z     = static_cast<float>(pElement[2]) * s;
+        const float ww    = 1.0f - x * x - y * y - z * z;
+        const float w     = std::sqrt((ww >= 0.0f) ? ww : 0.0f);
+
+        const int index           = pElement[3] & 3;
+        pElement[(index + 1) & 3] = static_cast<int16_t>(std::lround(x * 32767.0f));
+        pElement[(index + 2) & 3] = static_cast<int16_t>(std::lround(y * 32767.0f));
+        pElement[(index + 3) & 3] = static_cast<int16_t>(std::lround(z * 32767.0f));
+        pElement[(index + 0) & 3] = static_cast<int16_t>(std::lround(w * 32767.0f));
+    }
+}
+
+// 24-bit signed mantissa and 8-bit signed exponent to 32-bit float
+void DecodeFilterExponential(uint32_t* pData, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const int32_t mantissa = static_cast<int32_t>(pData[i] << 8) >> 8;
+        const int32_t exponent = static_cast<int32_t>(pData[i]) >> 24;
+        const float   value    = std::ldexp(static_cast<float>(mantissa), exponent);
+        memcpy(&pData[i], &value, sizeof(value));
+    }
+}
+
+} // namespace
+
+ppx::Result DecodeMeshoptVertexBuffer(void* pDst, size_t count, size_t stride, const void* pSrc, size_t srcSize)
+{
+    if (IsNull(pDst) || IsNull(pSrc)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((stride == 0) || (stride > kVertexBlockMaxSize) || ((stride % 4) != 0)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    // The first vertex is the delta base, it's stored at the end of a tail
+    // of at least 32 bytes
+    const size_t   tailSize = (stride < kVertexTailMinSize) ? kVertexTailMinSize : stride;
+    const uint8_t* pBytes   = static_cast<const uint8_t*>(pSrc);
+    if ((srcSize < 1 + tailSize) || ((pBytes[0] & 0xF0) != kVertexHeader) || ((pBytes[0] & 0x0F) > 0)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    uint8_t lastVertex[kVertexBlockMaxSize];
+    memcpy(lastVertex, pBytes + srcSize - stride, stride);
+
+    ByteReader   reader    = {pBytes + 1, pBytes + srcSize - tailSize};
+    const size_t blockSize = GetVertexBlockSize(stride);
+    for (size_t offset = 0; offset < count; offset += blockSize) {
+        const size_t blockCount = std::min(blockSize, count - offset);
+        if (!DecodeVertexBlock(reader, blockCount, stride, lastVertex, static_cast<uint8_t*>(pDst) + offset * stride)) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+    }
+
+    return (reader.Remaining() == 0) ? ppx::SUCCESS : ppx::ERROR_BAD_DATA_SOURCE;
+}
+
+ppx::Result DecodeMeshoptIndexBuffer(void* pDst, size_t count, size_t indexSize, const void* pSrc, size_t srcSize)
+{
+    if (IsNull(pDst) || IsNull(pSrc)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (((indexSize != 2) && (indexSize != 4)) || ((count % 3) != 0)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    // Header, one code per triangle, triangle data, then 16 bytes of
+    // auxiliary codes
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pSrc);
+    if ((srcSize < 1 + count / 3 + kIndexCodeAuxSize) || ((pBytes[0] & 0xF0) != kIndexHeader)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+    const uint32_t version = pBytes[0] & 0x0F;
+    if (version > 1) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    const uint8_t* pCodes   = pBytes + 1;
+    const uint8_t* pCodeAux = pBytes + srcSize - kIndexCodeAuxSize;
+    ByteReader     reader   = {pCodes + count / 3, pCodeAux};
+
+    // Version 1 uses edge codes 13 and 14 for +/-1 deltas from the last
+    // free index
+    const uint32_t fecMax = (version >= 1) ? 13 : 15;
+
+    IndexFifos fifos;
+    uint32_t   next     = 0;
+    uint32_t   last     = 0;
+    auto       readFree = [&](uint32_t& value) -> bool {
+        uint32_t delta = 0;
+        if (!reader.ReadVByte(delta)) {
+            return false;
+        }
+        value = last = last + Unzigzag32(delta);
+        return true;
+    };
+
+    for (size_t i = 0; i < count; i += 3) {
+        const uint8_t codeTri = *pCodes++;
+        uint32_t      a = 0, b = 0, c = 0;
+
+        if (codeTri < 0xF0) {
+            // Edge from the FIFO plus a third vertex
+            const uint32_t fe  = codeTri >> 4;
+            const uint32_t fec = codeTri & 15;
+            a                  = fifos.edges[(fifos.edgeOffset - 1 - fe) & 15][0];
+            b                  = fifos.edges[(fifos.edgeOffset - 1 - fe) & 15][1];
+
+            if (fec < fecMax) {
+                c = (fec == 0) ? next++ : fifos.Vertex(1 + fec);
+                fifos.PushVertex(c, fec == 0);
+            }
+            else {
+                if (fec != 15) {
+                    // 13 and 14 decode as -1 and 1
+                    c = last = (fec == 13) ? (last - 1) : (last + 1);
+                }
+                else if (!readFree(c)) {
+                    return ppx::ERROR_BAD_DATA_SOURCE;
+                }
+                fifos.PushVertex(c);
+            }
+            fifos.PushEdge(c, b);
+            fifos.PushEdge(a, c);
+        }
+        else if (codeTri < 0xFE) {
+            // New vertex plus two vertices from the FIFO or new ones,
+            // described by the auxiliary table
+            const uint8_t  codeAux = pCodeAux[codeTri & 15];
+            const uint32_t feb     = codeAux >> 4;
+            const uint32_t fec     = codeAux & 15;
+
+            a = next++;
+            b = (feb == 0) ? next++ : fifos.Vertex(feb);
+            c = (fec == 0) ? next++ : fifos.Vertex(fec);
+
+            fifos.PushVertex(a);
+            fifos.PushVertex(b, feb == 0);
+            fifos.PushVertex(c, fec == 0);
+            fifos.PushEdge(b, a);
+            fifos.PushEdge(c, b);
+            fifos.PushEdge(a, c);
+        }
+        else {
+            // Same as above with the auxiliary code inline, where 15 is a
+            // free index
+            uint8_t codeAux = 0;
+            if (!reader.Read(codeAux)) {
+                return ppx::ERROR_BAD_DATA_SOURCE;
+            }
+            const uint32_t fea = (codeTri == 0xFE) ? 0 : 15;
+            const uint32_t feb = codeAux >> 4;
+            const uint32_t fec = codeAux & 15;
+
+            // Zero restarts the numbering of new vertices
+            if (codeAux == 0) {
+                next = 0;
+            }
+
+            a = (fea == 0) ? next++ : 0;
+            b = (feb == 0) ? next++ : fifos.Vertex(feb);
+            c = (fec == 0) ? next++ : fifos.Vertex(fec);
+            if (((fea == 15) && !readFree(a)) || ((feb == 15) && !readFree(b)) || ((fec == 15) && !readFree(c))) {
+                return ppx::ERROR_BAD_DATA_SOURCE;
+            }
+
+            fifos.PushVertex(a);
+            fifos.PushVertex(b, (feb == 0) || (feb == 15));
+            fifos.PushVertex(c, (fec == 0) || (fec == 15));
+            fifos.PushEdge(b, a);
+            fifos.PushEdge(c, b);
+            fifos.PushEdge(a, c);
+        }
+
+        WriteIndex(pDst, i + 0, indexSize, a);
+        WriteIndex(pDst, i + 1, indexSize, b);
+        WriteIndex(pDst, i + 2, indexSize, c);
+    }
+
+    // The triangle data should end right at the auxiliary codes
+    return (reader.Remaining() == 0) ? ppx::SUCCESS : ppx::ERROR_BAD_DATA_SOURCE;
+}
+
+ppx::Result DecodeMeshoptIndexSequence(void* pDst, size_t count, size_t indexSize, const void* pSrc, size_t srcSize)
+{
+    if (IsNull(pDst) || IsNull(pSrc)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((indexSize != 2) && (indexSize != 4)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pSrc);
+    if ((srcSize < 1 + count + kSequenceTailSize) || ((pBytes[0] & 0xF0) != kSequenceHeader) || ((pBytes[0] & 0x0F) > 1)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+
+    // Each index is a delta from one of two baselines, the low bit picks it
+    ByteReader reader  = {pBytes + 1, pBytes + srcSize - kSequenceTailSize};
+    uint32_t   last[2] = {};
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t value = 0;
+        if (!reader.ReadVByte(value)) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+        const uint32_t baseline = value & 1;
+        last[baseline] += Unzigzag32(value >> 1);
+        WriteIndex(pDst, i, indexSize, last[baseline]);
+    }
+
+    return (reader.Remaining() == 0) ? ppx::SUCCESS : ppx::ERROR_BAD_DATA_SOURCE;
+}
+
+ppx::Result ApplyMeshoptFilter(MeshoptFilter filter, void* pData, size_t count, size_t stride)
+{
+    if (IsNull(pData)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    switch (filter) {
+        case MESHOPT_FILTER_NONE: {
+            return ppx::SUCCESS;
+        }
+        case MESHOPT_FILTER_OCTAHEDRAL: {
+            if (stride == 4) {
+                DecodeFilterOctahedral(static_cast<int8_t*>(pData), count, stride);
+                return ppx::SUCCESS;
+            }
+            if (stride == 8) {
+                DecodeFilterOctahedral(static_cast<int16_t*>(pData), count, stride);
+                return ppx::SUCCESS;
+            }
+        } break;
+        case MESHOPT_FILTER_QUATERNION: {
+            if (stride == 8) {
+                DecodeFilterQuaternion(static_cast<int16_t*>(pData), count);
+                return ppx::SUCCESS;
+            }
+        } break;
+        case MESHOPT_FILTER_EXPONENTIAL: {
+            if ((stride % 4) == 0) {
+                DecodeFilterExponential(static_cast<uint32_t*>(pData), count * stride / 4);
+                return ppx::SUCCESS;
+            }
+        } break;
+    }
+    return ppx::ERROR_BAD_DATA_SOURCE;
+}
+
+} // namespace ppx
@@ -14,10 +14,14 @@
 
 #include "ppx/metrics.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <regex>
 #include <sstream>
 
 #include "ppx/fs.h"
+#include "ppx/metrics_stream.h"
 
 namespace ppx {
 namespace metrics {
@@ -37,6 +41,119 @@ nlohmann::json MetricMetadata::Export() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// Magnitudes below this are counted as zero
+static constexpr double kSketchMinMagnitude = 1e-9;
+
+QuantileSketch::QuantileSketch(double relativeAccuracy, uint32_t maxBucketCount)
+    : mRelativeAccuracy(std::clamp(relativeAccuracy, 1e-6, 0.5)),
+      mMaxBucketCount(std::max<uint32_t>(maxBucketCount, 1))
+{
+    mGamma    = (1.0 + mRelativeAccuracy) / (1.0 - mRelativeAccuracy);
+    mLogGamma = std::log(mGamma);
+}
+
+// Bucket index covers (gamma^(index - 1), gamma^index]
+int64_t QuantileSketch::GetIndex(double magnitude) const
+{
+    return static_cast<int64_t>(std::ceil(std::log(magnitude) / mLogGamma));
+}
+
+// The value within mRelativeAccuracy of the whole bucket
+double QuantileSketch::GetValue(int64_t index) const
+{
+    return 2.0 * std::pow(mGamma, static_cast<double>(index)) / (mGamma + 1.0);
+}
+
+void QuantileSketch::Store::Add(int64_t index, uint32_t maxBucketCount)
+{
+    if (counts.empty()) {
+        offset = index;
+        counts.push_back(1);
+        return;
+    }
+
+    const int64_t size = static_cast<int64_t>(counts.size());
+    if (index < offset) {
+        // Grow as far as allowed, smaller magnitudes go to the lowest bucket
+        const int64_t grow = std::min<int64_t>(offset - index, static_cast<int64_t>(maxBucketCount) - size);
+        if (grow > 0) {
+            counts.insert(counts.begin(), static_cast<size_t>(grow), 0);
+            offset -= grow;
+        }
+        index = offset;
+    }
+    else if (index >= offset + size) {
+        // Merge the lowest buckets to make room
+        const int64_t shift = (index - offset + 1) - static_cast<int64_t>(maxBucketCount);
+        if (shift > 0) {
+            const int64_t merged = std::min(shift, size - 1);
+            uint64_t      total  = 0;
+            for (int64_t i = 0; i <= merged; ++i) {
+                total += counts[static_cast<size_t>(i)];
+            }
+            counts.erase(counts.begin(), counts.begin() + static_cast<ptrdiff_t>(merged));
+            counts[0] = total;
+            offset += shift;
+        }
+        counts.resize(static_cast<size_t>(index - offset + 1), 0);
+    }
+
+    ++counts[static_cast<size_t>(index - offset)];
+}
+
+void QuantileSketch::Add(double value)
+{
+    if (!std::isfinite(value)) {
+        return;
+    }
+
+    const double magnitude = std::fabs(value);
+    if (magnitude < kSketchMinMagnitude) {
+        ++mZeroCount;
+    }
+    else if (value > 0.0) {
+        mPositive.Add(GetIndex(magnitude), mMaxBucketCount);
+    }
+    else {
+        mNegative.Add(GetIndex(magnitude), mMaxBucketCount);
+    }
+    ++mCount;
+}
+
+double QuantileSketch::GetQuantile(double q) const
+{
+    if (mCount == 0) {
+        return 0.0;
+    }
+
+    const uint64_t rank       = std::min(static_cast<uint64_t>(std::clamp(q, 0.0, 1.0) * mCount), mCount - 1);
+    uint64_t       cumulative = 0;
+
+    // Most negative first
+    for (size_t i = mNegative.counts.size(); i-- > 0;) {
+        cumulative += mNegative.counts[i];
+        if (cumulative > rank) {
+            return -GetValue(mNegative.offset + static_cast<int64_t>(i));
+        }
+    }
+
+    cumulative += mZeroCount;
+    if (cumulative > rank) {
+        return 0.0;
+    }
+
+    for (size_t i = 0; i < mPositive.counts.size(); ++i) {
+        cumulative += mPositive.counts[i];
+        if (cumulative > rank) {
+            return GetValue(mPositive.offset + static_cast<int64_t>(i));
+        }
+    }
+
+    return mPositive.counts.empty() ? 0.0 : GetValue(mPositive.offset + static_cast<int64_t>(mPositive.counts.size()) - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 bool MetricGauge::RecordEntry(const MetricData& data)
 {
     if (data.type != MetricType::GAUGE) {
@@ -49,8 +166,8 @@ bool MetricGauge::RecordEntry(const MetricData& data)
         return false;
     }
 
-    auto entryCount = mTimeSeries.size();
-    if (entryCount > 0 && data.gauge.seconds <= mTimeSeries.back().seconds) {
+    auto entryCount = mEntryCount;
+    if (entryCount > 0 && data.gauge.seconds <= mLastSeconds) {
         PPX_LOG_ERROR("Provided gauge metric had old seconds value; ignoring.");
         return false;
     }
@@ -60,6 +177,9 @@ bool MetricGauge::RecordEntry(const MetricData& data)
     entry.value   = data.gauge.value;
     // This entry will be added at the end; update the count now for calculations.
     ++entryCount;
+    if (entryCount == 1) {
+        mFirstSeconds = entry.seconds;
+    }
 
     // Update the basic stats.
     mAccumulatedValue += entry.value;
@@ -68,18 +188,61 @@ bool MetricGauge::RecordEntry(const MetricData& data)
     mBasicStats.average = mAccumulatedValue / entryCount;
     // Above checks guarantee the 'seconds' field monotonically increases with each entry.
     mBasicStats.timeRatio = (entryCount > 1)
-                                ? mAccumulatedValue / (entry.seconds - mTimeSeries.front().seconds)
+                                ? mAccumulatedValue / (entry.seconds - mFirstSeconds)
                                 : entry.value;
 
+    mEntryCount  = entryCount;
+    mLastSeconds = entry.seconds;
+
+    if (mMetadata.gaugeMode == GaugeMode::SKETCH) {
+        const double delta = entry.value - mMean;
+        mMean += delta / entryCount;
+        mM2 += delta * (entry.value - mMean);
+
+        mSketch.Add(entry.value);
+        AddToReservoir(entry);
+        return true;
+    }
+
     mTimeSeries.emplace_back(std::move(entry));
     return true;
 }
 
+void MetricGauge::AddToReservoir(const TimeSeriesEntry& entry)
+{
+    if (mMetadata.reservoirSize == 0) {
+        return;
+    }
+    if (mTimeSeries.size() < mMetadata.reservoirSize) {
+        mTimeSeries.push_back(entry);
+        return;
+    }
+
+    // mEntryCount already includes this entry
+    const uint64_t random = (static_cast<uint64_t>(mRandom.UInt32()) << 32) | mRandom.UInt32();
+    const uint64_t slot   = random % mEntryCount;
+    if (slot < mTimeSeries.size()) {
+        mTimeSeries[static_cast<size_t>(slot)] = entry;
+    }
+}
+
 ppx::metrics::GaugeComplexStatistics MetricGauge::ComputeComplexStats() const
 {
     GaugeComplexStatistics complex;
     size_t                 entryCount = mTimeSeries.size();
-    if (entryCount == 0) {
+    if (mEntryCount == 0) {
+        return complex;
+    }
+
+    if (mMetadata.gaugeMode == GaugeMode::SKETCH) {
+        complex.median            = mSketch.GetQuantile(0.50);
+        complex.standardDeviation = sqrt(mM2 / mEntryCount);
+        complex.percentile01      = mSketch.GetQuantile(0.01);
+        complex.percentile05      = mSketch.GetQuantile(0.05);
+        complex.percentile10      = mSketch.GetQuantile(0.10);
+        complex.percentile90      = mSketch.GetQuantile(0.90);
+        complex.percentile95      = mSketch.GetQuantile(0.95);
+        complex.percentile99      = mSketch.GetQuantile(0.99);
         return complex;
     }
 
@@ -114,6 +277,11 @@ ppx::metrics::GaugeComplexStatistics MetricGauge::ComputeComplexStats() const
 }
 
 nlohmann::json MetricGauge::Export() const
+{
+    return Export(nullptr);
+}
+
+nlohmann::json MetricGauge::Export(std::vector<ReportTimeSeries>* pTimeSeries) const
 {
     nlohmann::json metricObject;
     nlohmann::json statsObject;
@@ -136,8 +304,44 @@ nlohmann::json MetricGauge::Export() const
 
     metricObject["statistics"] = statsObject;
 
+    // Sketch gauges export their reservoir, in time order
+    std::vector<TimeSeriesEntry> reservoir;
+    if (mMetadata.gaugeMode == GaugeMode::SKETCH) {
+        metricObject["mode"] = "sketch";
+
+        nlohmann::json sketchObject;
+        sketchObject["relative_accuracy"] = mSketch.GetRelativeAccuracy();
+        sketchObject["bucket_count"]      = mSketch.GetBucketCount();
+        sketchObject["entry_count"]       = mEntryCount;
+        sketchObject["reservoir_size"]    = mMetadata.reservoirSize;
+        metricObject["sketch"]            = sketchObject;
+
+        reservoir = mTimeSeries;
+        std::sort(
+            reservoir.begin(), reservoir.end(), [](const TimeSeriesEntry& lhs, const TimeSeriesEntry& rhs) {
+                return lhs.seconds < rhs.seconds;
+            });
+    }
+    else {
+        metricObject["mode"] = "time_series";
+    }
+
+    const std::vector<TimeSeriesEntry>& timeSeries = (mMetadata.gaugeMode == GaugeMode::SKETCH) ? reservoir : mTimeSeries;
+    if (pTimeSeries != nullptr) {
+        ReportTimeSeries columns;
+        columns.seconds.reserve(timeSeries.size());
+        columns.values.reserve(timeSeries.size());
+        for (const auto& entry : timeSeries) {
+            columns.seconds.push_back(entry.seconds);
+            columns.values.push_back(entry.value);
+        }
+        metricObject["time_series_index"] = pTimeSeries->size();
+        pTimeSeries->push_back(std::move(columns));
+        return metricObject;
+    }
+
     metricObject["time_series"] = nlohmann::json::array();
-    for (const auto& entry : mTimeSeries) {
+    for (const auto& entry : timeSeries) {
         metricObject["time_series"] += nlohmann::json::array({entry.seconds, entry.value});
     }
 
@@ -169,6 +373,49 @@ nlohmann::json MetricCounter::Export() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+MetricQueue::MetricQueue(uint32_t capacity)
+{
+    PPX_ASSERT_MSG(capacity > 0 && capacity <= (1u << 31), "Metric queue capacity out of range: " << capacity);
+    uint32_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    mEntries.resize(size);
+    mMask = size - 1;
+}
+
+bool MetricQueue::Push(MetricID id, const MetricData& data)
+{
+    const uint64_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mHead.load(std::memory_order_acquire) > mMask) {
+        mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    mEntries[tail & mMask] = {id, data};
+    mTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool MetricQueue::Pop(MetricID* pID, MetricData* pData)
+{
+    const uint64_t head = mHead.load(std::memory_order_relaxed);
+    if (head == mTail.load(std::memory_order_acquire)) {
+        return false;
+    }
+    const Entry& entry = mEntries[head & mMask];
+    *pID               = entry.id;
+    *pData             = entry.data;
+    mHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+uint64_t MetricQueue::TakeDroppedCount()
+{
+    return mDroppedCount.exchange(0, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Metric* Run::AddMetric(const MetricMetadata& metadata)
 {
     if (metadata.name.empty()) {
@@ -183,9 +430,14 @@ Metric* Run::AddMetric(const MetricMetadata& metadata)
 
     Metric* pMetric = nullptr;
     switch (metadata.type) {
-        case MetricType::GAUGE:
-            pMetric = new MetricGauge(metadata);
+        case MetricType::GAUGE: {
+            MetricMetadata gaugeMetadata = metadata;
+            if (gaugeMetadata.gaugeMode == GaugeMode::DEFAULT) {
+                gaugeMetadata.gaugeMode = GaugeMode::TIME_SERIES;
+            }
+            pMetric = new MetricGauge(gaugeMetadata);
             break;
+        }
         case MetricType::COUNTER:
             pMetric = new MetricCounter(metadata);
             break;
@@ -203,7 +455,22 @@ bool Run::HasMetric(const std::string& name) const
     return (mMetricNames.count(name) != 0);
 }
 
-nlohmann::json Run::Export() const
+std::vector<std::pair<MetricMetadata, double>> Run::GetGaugeMedians() const
+{
+    std::vector<std::pair<MetricMetadata, double>> medians;
+    for (const auto& metric : mMetrics) {
+        if (metric->GetType() != MetricType::GAUGE) {
+            continue;
+        }
+        const MetricGauge* pGauge = static_cast<const MetricGauge*>(metric.get());
+        if (pGauge->mEntryCount > 0) {
+            medians.emplace_back(pGauge->mMetadata, pGauge->ComputeComplexStats().median);
+        }
+    }
+    return medians;
+}
+
+nlohmann::json Run::Export(std::vector<ReportTimeSeries>* pTimeSeries) const
 {
     nlohmann::json object;
     object["name"]     = mName;
@@ -222,6 +489,10 @@ nlohmann::json Run::Export() const
                 PPX_LOG_ERROR("Unrecognized metric type at export: " << static_cast<uint32_t>(metric->GetType()));
                 continue;
         }
+        if ((pTimeSeries != nullptr) && (metric->GetType() == MetricType::GAUGE)) {
+            object[typeString] += static_cast<const MetricGauge*>(metric.get())->Export(pTimeSeries);
+            continue;
+        }
         object[typeString] += metric->Export();
     }
     return object;
@@ -229,6 +500,213 @@ nlohmann::json Run::Export() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+FrameStutterTracker::FrameStutterTracker(double budgetMs, uint32_t windowFrameCount)
+    : mBudgetMs(budgetMs), mWindowFrameCount(windowFrameCount)
+{
+    PPX_ASSERT_MSG(budgetMs > 0.0, "Frame time budget must be positive");
+    PPX_ASSERT_MSG(windowFrameCount > 1, "Frame time variance windows need at least 2 frames");
+}
+
+FrameStutterResult FrameStutterTracker::AddFrame(double frameTimeMs)
+{
+    FrameStutterResult result = {};
+    result.overBudget         = (frameTimeMs > mBudgetMs);
+    result.histogramBucket    = GetHistogramBucket(frameTimeMs);
+
+    ++mFrameCount;
+    ++mHistogram[result.histogramBucket];
+    if (result.overBudget) {
+        ++mOverBudgetCount;
+        ++mStreak;
+    }
+    else {
+        result.endedStreakLength = EndStreak();
+    }
+
+    ++mWindowCount;
+    const double delta = frameTimeMs - mWindowMean;
+    mWindowMean += delta / mWindowCount;
+    mWindowM2 += delta * (frameTimeMs - mWindowMean);
+    if (mWindowCount == mWindowFrameCount) {
+        result.windowComplete = true;
+        result.windowVariance = mWindowM2 / mWindowCount;
+        mWindowCount          = 0;
+        mWindowMean           = 0;
+        mWindowM2             = 0;
+    }
+    return result;
+}
+
+uint32_t FrameStutterTracker::EndStreak()
+{
+    const uint32_t streak = mStreak;
+    mLongestStreak        = std::max(mLongestStreak, streak);
+    mStreak               = 0;
+    return streak;
+}
+
+uint32_t FrameStutterTracker::GetHistogramBucket(double frameTimeMs)
+{
+    if (!(frameTimeMs >= 1.0)) {
+        return 0;
+    }
+    const double bucket = 1.0 + std::floor(2.0 * std::log2(frameTimeMs));
+    return static_cast<uint32_t>(std::min(bucket, static_cast<double>(kHistogramBucketCount - 1)));
+}
+
+double FrameStutterTracker::GetHistogramLowerBound(uint32_t bucket)
+{
+    return (bucket == 0) ? 0.0 : std::exp2((bucket - 1) / 2.0);
+}
+
+double FrameStutterTracker::GetHistogramUpperBound(uint32_t bucket)
+{
+    return (bucket + 1 >= kHistogramBucketCount) ? std::numeric_limits<double>::infinity() : GetHistogramLowerBound(bucket + 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+double Median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+    return (values.size() % 2 == 0) ? 0.5 * (values[middle - 1] + values[middle]) : values[middle];
+}
+
+} // namespace
+
+BenchmarkSummary SummarizeRepetitions(const std::vector<double>& values, const BenchmarkSettings& settings)
+{
+    BenchmarkSummary summary = {};
+    summary.values           = values;
+    if (values.empty()) {
+        return summary;
+    }
+
+    std::vector<double> kept = values;
+    if (values.size() >= 3) {
+        const double        median = Median(values);
+        std::vector<double> deviations;
+        for (double value : values) {
+            deviations.push_back(std::abs(value - median));
+        }
+        // All values are outliers of a zero MAD but the median ones, reject none instead
+        const double mad = Median(deviations);
+        if (mad > 0.0) {
+            kept.clear();
+            for (uint32_t i = 0; i < values.size(); ++i) {
+                if (0.6745 * deviations[i] / mad > settings.outlierThreshold) {
+                    summary.outliers.push_back(i);
+                }
+                else {
+                    kept.push_back(values[i]);
+                }
+            }
+        }
+    }
+
+    double sum = 0.0;
+    for (double value : kept) {
+        sum += value;
+    }
+    summary.mean    = sum / kept.size();
+    summary.ciLower = summary.mean;
+    summary.ciUpper = summary.mean;
+    if ((kept.size() < 2) || (settings.bootstrapResamples == 0)) {
+        return summary;
+    }
+
+    ppx::Random         random;
+    std::vector<double> means(settings.bootstrapResamples);
+    for (double& mean : means) {
+        double resampleSum = 0.0;
+        for (size_t i = 0; i < kept.size(); ++i) {
+            resampleSum += kept[random.UInt32() % kept.size()];
+        }
+        mean = resampleSum / kept.size();
+    }
+    std::sort(means.begin(), means.end());
+
+    const double alpha     = 0.5 * (1.0 - settings.confidenceLevel);
+    const size_t lastIndex = means.size() - 1;
+    summary.ciLower        = means[static_cast<size_t>(std::floor(alpha * lastIndex))];
+    summary.ciUpper        = means[static_cast<size_t>(std::ceil((1.0 - alpha) * lastIndex))];
+    return summary;
+}
+
+Result ExpandSweep(const nlohmann::json& sweep, std::vector<SweepPoint>* pPoints)
+{
+    PPX_ASSERT_NULL_ARG(pPoints);
+    if (!sweep.is_object()) {
+        PPX_LOG_ERROR("A sweep must be a JSON object");
+        return ERROR_FAILED;
+    }
+
+    std::vector<nlohmann::json> points = {nlohmann::json::object()};
+    if (sweep.contains("points")) {
+        if (!sweep["points"].is_array() || sweep["points"].empty()) {
+            PPX_LOG_ERROR("Sweep \"points\" must be a non empty array");
+            return ERROR_FAILED;
+        }
+        points.clear();
+        for (const auto& point : sweep["points"]) {
+            if (!point.is_object()) {
+                PPX_LOG_ERROR("Sweep points must be JSON objects of knob values");
+                return ERROR_FAILED;
+            }
+            points.push_back(point);
+        }
+    }
+
+    if (sweep.contains("cartesian")) {
+        const auto& cartesian = sweep["cartesian"];
+        if (!cartesian.is_object()) {
+            PPX_LOG_ERROR("Sweep \"cartesian\" must be a JSON object of knob value arrays");
+            return ERROR_FAILED;
+        }
+        for (auto it = cartesian.begin(); it != cartesian.end(); ++it) {
+            if (!it.value().is_array() || it.value().empty()) {
+                PPX_LOG_ERROR("Sweep \"cartesian\" values of " << it.key() << " must be a non empty array");
+                return ERROR_FAILED;
+            }
+            std::vector<nlohmann::json> combined;
+            for (const auto& point : points) {
+                for (const auto& value : it.value()) {
+                    combined.push_back(point);
+                    combined.back()[it.key()] = value;
+                }
+            }
+            points = std::move(combined);
+        }
+    }
+
+    std::unordered_set<std::string> names;
+    pPoints->clear();
+    for (auto& knobs : points) {
+        std::string name;
+        for (auto it = knobs.begin(); it != knobs.end(); ++it) {
+            name += (name.empty() ? "" : " ") + it.key() + "=" + (it.value().is_string() ? it.value().get<std::string>() : it.value().dump());
+        }
+        if (name.empty()) {
+            name = "default";
+        }
+        // Points may repeat, e.g. to check for drift over the sweep
+        const std::string baseName = name;
+        for (uint32_t i = 2; names.count(name) > 0; ++i) {
+            name = baseName + " (" + std::to_string(i) + ")";
+        }
+        names.insert(name);
+        pPoints->push_back({name, std::move(knobs)});
+    }
+    return SUCCESS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+std::atomic<uint64_t> Manager::sNextSerial = 1;
+
 void Manager::StartRun(const std::string& name)
 {
     PPX_ASSERT_MSG(!name.empty(), "A run name must not be empty");
@@ -246,6 +724,9 @@ void Manager::EndRun()
         PPX_LOG_ERROR("Requested to end run with no active run!");
     }
 
+    // The data queued so far belongs to this run.
+    DrainQueuedMetricData();
+
     mActiveRun = nullptr;
     mActiveMetrics.clear();
 }
@@ -255,18 +736,32 @@ bool Manager::HasActiveRun() const
     return (mActiveRun != nullptr);
 }
 
+void Manager::SetDefaultGaugeMode(GaugeMode mode)
+{
+    PPX_ASSERT_MSG(mode != GaugeMode::DEFAULT, "The default gauge mode must be a concrete mode");
+    mDefaultGaugeMode = mode;
+}
+
 MetricID Manager::AddMetric(const MetricMetadata& metadata)
 {
     if (mActiveRun == nullptr) {
         return kInvalidMetricID;
     }
 
-    auto* metric = mActiveRun->AddMetric(metadata);
+    MetricMetadata resolvedMetadata = metadata;
+    if (resolvedMetadata.gaugeMode == GaugeMode::DEFAULT) {
+        resolvedMetadata.gaugeMode = mDefaultGaugeMode;
+    }
+
+    auto* metric = mActiveRun->AddMetric(resolvedMetadata);
     if (metric == nullptr) {
         return kInvalidMetricID;
     }
     auto metricID = mNextMetricID++;
     mActiveMetrics.emplace(metricID, metric);
+    if (mStreamServer != nullptr) {
+        mStreamServer->AddMetricInfo(metricID, resolvedMetadata);
+    }
     return metricID;
 }
 
@@ -281,13 +776,121 @@ bool Manager::RecordMetricData(MetricID id, const MetricData& data)
         PPX_LOG_ERROR("Attempted to record a metric entry against an invalid ID.");
         return false;
     }
-    return findResult->second->RecordEntry(data);
+    if (!findResult->second->RecordEntry(data)) {
+        return false;
+    }
+    if (mStreamServer != nullptr) {
+        mStreamServer->Publish(id, data);
+    }
+    return true;
 }
 
-Report Manager::CreateReport(const std::string& reportPath) const
+bool Manager::QueueMetricData(MetricID id, const MetricData& data)
+{
+    return GetThreadQueue()->Push(id, data);
+}
+
+MetricQueue* Manager::GetThreadQueue()
+{
+    // Threads usually record to a single manager, remember the last one's queue.
+    struct CachedQueue
+    {
+        uint64_t     managerSerial = 0;
+        MetricQueue* pQueue        = nullptr;
+    };
+    thread_local CachedQueue sCachedQueue;
+
+    if (sCachedQueue.managerSerial != mSerial) {
+        std::lock_guard<std::mutex> lock(mThreadQueuesMutex);
+
+        auto& pQueue = mThreadQueues[std::this_thread::get_id()];
+        if (!pQueue) {
+            pQueue = std::make_unique<MetricQueue>(mQueueCapacity);
+        }
+        sCachedQueue.managerSerial = mSerial;
+        sCachedQueue.pQueue        = pQueue.get();
+    }
+    return sCachedQueue.pQueue;
+}
+
+void Manager::DrainQueuedMetricData()
+{
+    mDrainQueues.clear();
+    {
+        std::lock_guard<std::mutex> lock(mThreadQueuesMutex);
+        for (const auto& [threadID, pQueue] : mThreadQueues) {
+            mDrainQueues.push_back(pQueue.get());
+        }
+    }
+
+    mDrainEntries.clear();
+    uint64_t droppedCount = 0;
+    for (MetricQueue* pQueue : mDrainQueues) {
+        QueuedEntry entry = {};
+        while (pQueue->Pop(&entry.id, &entry.data)) {
+            mDrainEntries.push_back(entry);
+        }
+        droppedCount += pQueue->TakeDroppedCount();
+    }
+    if (droppedCount > 0) {
+        PPX_LOG_WARN("Dropped " << droppedCount << " metric entries queued while the thread's queue was full.");
+    }
+
+    // Queues are drained one thread at a time, but gauges only accept entries
+    // in order of time.
+    auto seconds = [](const QueuedEntry& entry) {
+        return (entry.data.type == MetricType::GAUGE) ? entry.data.gauge.seconds : 0.0;
+    };
+    std::stable_sort(mDrainEntries.begin(), mDrainEntries.end(), [&seconds](const QueuedEntry& a, const QueuedEntry& b) {
+        if (a.id != b.id) {
+            return a.id < b.id;
+        }
+        return seconds(a) < seconds(b);
+    });
+
+    // Entries for the metrics of completed runs are discarded.
+    for (const QueuedEntry& entry : mDrainEntries) {
+        auto findResult = mActiveMetrics.find(entry.id);
+        if ((findResult != mActiveMetrics.end()) && findResult->second->RecordEntry(entry.data) && (mStreamServer != nullptr)) {
+            mStreamServer->Publish(entry.id, entry.data);
+        }
+    }
+}
+
+void Manager::SetQueueCapacity(uint32_t capacity)
+{
+    PPX_ASSERT_MSG(capacity > 0, "Metric queue capacity must not be zero");
+    mQueueCapacity = capacity;
+}
+
+Report Manager::CreateReport(const std::string& reportPath, ReportFormat format) const
 {
     nlohmann::json content;
     content["runs"] = nlohmann::json::array();
+    for (const auto& point : mBenchmarkPoints) {
+        if (point.repetitions.empty()) {
+            continue;
+        }
+        if (point.name.empty()) {
+            content["benchmark"] = ExportBenchmark(point.name);
+        }
+        else {
+            content["sweep"] += ExportBenchmark(point.name);
+        }
+    }
+
+    if (!mDeviceFingerprint.IsEmpty()) {
+        content["device"] = mDeviceFingerprint.Export();
+    }
+
+    if (format == ReportFormat::BINARY) {
+        std::vector<ReportTimeSeries> timeSeries;
+        for (const auto& [name, pRun] : mRuns) {
+            content["runs"] += pRun->Export(&timeSeries);
+        }
+        return Report(std::move(content), std::move(timeSeries), reportPath);
+    }
+
     for (const auto& [name, pRun] : mRuns) {
         content["runs"] += pRun->Export();
     }
@@ -295,6 +898,80 @@ Report Manager::CreateReport(const std::string& reportPath) const
     return Report(std::move(content), reportPath);
 }
 
+void Manager::AddBenchmarkRepetition(const std::string& point)
+{
+    PPX_ASSERT_MSG(mActiveRun != nullptr, "A run must be active to be a benchmark repetition");
+    SetBenchmarkParameters(point, nullptr);
+    for (auto& benchmarkPoint : mBenchmarkPoints) {
+        if (benchmarkPoint.name == point) {
+            benchmarkPoint.repetitions.push_back(mActiveRun->mName);
+        }
+    }
+}
+
+void Manager::SetBenchmarkParameters(const std::string& point, const nlohmann::json& parameters)
+{
+    for (auto& benchmarkPoint : mBenchmarkPoints) {
+        if (benchmarkPoint.name == point) {
+            if (!parameters.is_null()) {
+                benchmarkPoint.parameters = parameters;
+            }
+            return;
+        }
+    }
+    mBenchmarkPoints.push_back({point, parameters, {}});
+}
+
+nlohmann::json Manager::ExportBenchmark(const std::string& point) const
+{
+    const auto& benchmarkPoint = *std::find_if(mBenchmarkPoints.begin(), mBenchmarkPoints.end(), [&point](const BenchmarkPoint& p) {
+        return p.name == point;
+    });
+
+    nlohmann::json object;
+    if (!point.empty()) {
+        object["name"]       = point;
+        object["parameters"] = benchmarkPoint.parameters;
+    }
+    object["repetitions"]         = benchmarkPoint.repetitions;
+    object["warmup_frames"]       = mBenchmarkSettings.warmupFrames;
+    object["repetition_frames"]   = mBenchmarkSettings.repetitionFrames;
+    object["statistic"]           = "median";
+    object["confidence_level"]    = mBenchmarkSettings.confidenceLevel;
+    object["bootstrap_resamples"] = mBenchmarkSettings.bootstrapResamples;
+    object["outlier_threshold"]   = mBenchmarkSettings.outlierThreshold;
+    object["gauges"]              = nlohmann::json::array();
+
+    // Gauges in the order they were first added, with the median of each
+    // repetition that has entries
+    std::vector<std::pair<MetricMetadata, std::vector<double>>> gauges;
+    std::unordered_map<std::string, size_t>                     indices;
+    for (const auto& runName : benchmarkPoint.repetitions) {
+        for (const auto& [metadata, median] : mRuns.at(runName)->GetGaugeMedians()) {
+            auto it = indices.find(metadata.name);
+            if (it == indices.end()) {
+                it = indices.emplace(metadata.name, gauges.size()).first;
+                gauges.emplace_back(metadata, std::vector<double>());
+            }
+            gauges[it->second].second.push_back(median);
+        }
+    }
+
+    for (const auto& [metadata, medians] : gauges) {
+        const BenchmarkSummary summary = SummarizeRepetitions(medians, mBenchmarkSettings);
+
+        nlohmann::json gaugeObject;
+        gaugeObject["metadata"] = metadata.Export();
+        gaugeObject["values"]   = summary.values;
+        gaugeObject["outliers"] = summary.outliers;
+        gaugeObject["mean"]     = summary.mean;
+        gaugeObject["ci_lower"] = summary.ciLower;
+        gaugeObject["ci_upper"] = summary.ciUpper;
+        object["gauges"] += gaugeObject;
+    }
+    return object;
+}
+
 GaugeBasicStatistics Manager::GetGaugeBasicStatistics(MetricID id) const
 {
     if (mActiveRun == nullptr) {
@@ -317,6 +994,27 @@ GaugeBasicStatistics Manager::GetGaugeBasicStatistics(MetricID id) const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+std::string DeviceFingerprint::GetKey() const
+{
+    std::stringstream ss;
+    ss << gpu << " / " << driver << " / " << api << " / " << width << "x" << height;
+    return ss.str();
+}
+
+nlohmann::json DeviceFingerprint::Export() const
+{
+    nlohmann::json object;
+    object["gpu"]    = gpu;
+    object["driver"] = driver;
+    object["api"]    = api;
+    object["width"]  = width;
+    object["height"] = height;
+    object["key"]    = GetKey();
+    return object;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 Report::Report(const nlohmann::json& content, const std::string& reportPath)
     : mContent(content)
 {
@@ -324,7 +1022,13 @@ Report::Report(const nlohmann::json& content, const std::string& reportPath)
 }
 
 Report::Report(nlohmann::json&& content, const std::string& reportPath)
-    : mContent(content)
+    : mContent(std::move(content))
+{
+    SetReportPath(reportPath);
+}
+
+Report::Report(nlohmann::json&& content, std::vector<ReportTimeSeries>&& timeSeries, const std::string& reportPath)
+    : mContent(std::move(content)), mFormat(ReportFormat::BINARY), mTimeSeries(std::move(timeSeries))
 {
     SetReportPath(reportPath);
 }
@@ -339,17 +1043,122 @@ void Report::WriteToDisk(bool overwriteExisting) const
     }
 
     std::filesystem::create_directories(mFilePath.parent_path());
-    std::ofstream outputFile(mFilePath, std::ofstream::out);
+    const bool    binary = (mFormat == ReportFormat::BINARY);
+    std::ofstream outputFile(mFilePath, binary ? (std::ofstream::out | std::ofstream::binary) : std::ofstream::out);
     if (!outputFile.is_open()) {
         PPX_LOG_ERROR("Failed to open metrics file at path [" << mFilePath << "] for writing!");
         return;
     }
-    outputFile << GetContentString() << std::endl;
+    if (binary) {
+        WriteBinary(outputFile);
+    }
+    else {
+        outputFile << GetContentString() << std::endl;
+    }
     outputFile.close();
 
     PPX_LOG_INFO("Metrics report written to path [" << mFilePath << "]");
 }
 
+namespace {
+
+template <typename T>
+void WriteLittleEndian(std::string& buffer, T value)
+{
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        buffer.push_back(static_cast<char>(static_cast<uint8_t>(value >> (8 * i))));
+    }
+}
+
+void WriteVarint(std::string& buffer, uint64_t value)
+{
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>(static_cast<uint8_t>(value) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+} // namespace
+
+void Report::WriteBinary(std::ostream& os) const
+{
+    const std::string json = mContent.dump();
+
+    std::string header = "PPXM";
+    WriteLittleEndian<uint32_t>(header, 1);
+    WriteLittleEndian<uint32_t>(header, static_cast<uint32_t>(json.size()));
+    os.write(header.data(), header.size());
+    os.write(json.data(), json.size());
+
+    std::string buffer;
+    WriteLittleEndian<uint32_t>(buffer, static_cast<uint32_t>(mTimeSeries.size()));
+    for (const auto& series : mTimeSeries) {
+        // Gauges are mostly recorded at a steady rate, so the deltas of
+        // consecutive timestamps usually fit in one or two bytes
+        std::string timestamps;
+        int64_t     previous = 0;
+        for (double seconds : series.seconds) {
+            const int64_t micros = static_cast<int64_t>(std::llround(seconds * 1000000.0));
+            const int64_t delta  = micros - previous;
+            WriteVarint(timestamps, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+            previous = micros;
+        }
+
+        WriteLittleEndian<uint64_t>(buffer, series.values.size());
+        WriteLittleEndian<uint64_t>(buffer, timestamps.size());
+        buffer += timestamps;
+        for (double value : series.values) {
+            const float floatValue = static_cast<float>(value);
+            uint32_t    bits       = 0;
+            std::memcpy(&bits, &floatValue, sizeof(bits));
+            WriteLittleEndian<uint32_t>(buffer, bits);
+        }
+
+        os.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+}
+
+void Report::AppendToResultsStore(const std::string& storePath) const
+{
+    if (!mContent.contains("benchmark") && !mContent.contains("sweep")) {
+        PPX_LOG_WARN("Metrics report not added to the results store, it has no benchmark repetitions.");
+        return;
+    }
+    if (!mContent.contains("device")) {
+        PPX_LOG_WARN("Metrics report not added to the results store, it has no device fingerprint.");
+        return;
+    }
+
+    const std::filesystem::path path = ppx::fs::GetFullPath(std::filesystem::path(storePath), ppx::fs::GetDefaultOutputDirectory());
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream outputFile(path, std::ofstream::out | std::ofstream::app);
+    if (!outputFile.is_open()) {
+        PPX_LOG_ERROR("Failed to open results store at path [" << path << "] for appending!");
+        return;
+    }
+    // One entry per line, so the store only ever grows at the end
+    outputFile << GetResultsStoreEntry() << std::endl;
+    outputFile.close();
+
+    PPX_LOG_INFO("Metrics report added to results store [" << path << "]");
+}
+
+std::string Report::GetResultsStoreEntry() const
+{
+    nlohmann::json entry;
+    for (const char* key : {"device", "generated_at", "benchmark", "sweep"}) {
+        if (mContent.contains(key)) {
+            entry[key] = mContent[key];
+        }
+    }
+    if (mContent.contains("device")) {
+        entry["device_key"] = mContent["device"]["key"];
+    }
+    return entry.dump();
+}
+
 std::string Report::GetContentString() const
 {
     return mContent.dump(4);
@@ -0,0 +1,245 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/metrics_stream.h"
+
+#include <cerrno>
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define PPX_HAS_POSIX_SOCKETS
+#endif
+
+namespace ppx {
+namespace metrics {
+
+// Clients this far behind stop receiving data until they catch up
+static constexpr size_t kMaxPendingBytes = 1 << 20;
+static constexpr size_t kMaxClients      = 4;
+// How long the server thread sleeps when there's nothing to do
+static constexpr int kPollTimeoutMs = 10;
+
+static void AppendBytes(std::vector<uint8_t>& bytes, const void* pData, size_t size)
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    bytes.insert(bytes.end(), pBytes, pBytes + size);
+}
+
+static void AppendInfo(std::vector<uint8_t>& bytes, MetricID id, MetricType type, const std::string& name)
+{
+    StreamInfoRecord record = {};
+    record.id               = id;
+    record.metricType       = static_cast<uint32_t>(type);
+    record.nameLength       = static_cast<uint32_t>(name.size());
+    AppendBytes(bytes, &record, sizeof(record));
+    AppendBytes(bytes, name.data(), name.size());
+}
+
+StreamServer::~StreamServer()
+{
+    Stop();
+}
+
+Result StreamServer::Start(uint16_t port, uint32_t queueCapacity)
+{
+    PPX_ASSERT_MSG(!IsRunning(), "Metrics stream server already started");
+
+#if defined(PPX_HAS_POSIX_SOCKETS)
+    mListenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (mListenSocket < 0) {
+        PPX_LOG_ERROR("Metrics stream server failed to create a socket");
+        return ppx::ERROR_FAILED;
+    }
+
+    int reuse = 1;
+    setsockopt(mListenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address     = {};
+    address.sin_family      = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port        = htons(port);
+    if ((bind(mListenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) || (listen(mListenSocket, static_cast<int>(kMaxClients)) != 0)) {
+        PPX_LOG_ERROR("Metrics stream server failed to listen on port " << port);
+        close(mListenSocket);
+        mListenSocket = -1;
+        return ppx::ERROR_FAILED;
+    }
+    fcntl(mListenSocket, F_SETFL, fcntl(mListenSocket, F_GETFL, 0) | O_NONBLOCK);
+
+    socklen_t addressSize = sizeof(address);
+    getsockname(mListenSocket, reinterpret_cast<sockaddr*>(&address), &addressSize);
+    mPort = ntohs(address.sin_port);
+
+    mQueue = std::make_unique<MetricQueue>(queueCapacity);
+    mStopRequested.store(false);
+    mThread = std::thread(&StreamServer::Run, this);
+
+    PPX_LOG_INFO("Metrics stream server listening on port " << mPort);
+    return ppx::SUCCESS;
+#else
+    (void)port;
+    (void)queueCapacity;
+    PPX_LOG_ERROR("Metrics streaming is only supported on Linux and Android");
+    return ppx::ERROR_UNSUPPORTED_API;
+#endif
+}
+
+void StreamServer::Stop()
+{
+    if (!IsRunning()) {
+        return;
+    }
+
+    mStopRequested.store(true);
+    mThread.join();
+
+#if defined(PPX_HAS_POSIX_SOCKETS)
+    while (!mClients.empty()) {
+        DropClient(mClients.size() - 1);
+    }
+    close(mListenSocket);
+#endif
+    mListenSocket  = -1;
+    mPort          = 0;
+    mSentInfoCount = 0;
+    mQueue.reset();
+}
+
+void StreamServer::AddMetricInfo(MetricID id, const MetricMetadata& metadata)
+{
+    std::lock_guard<std::mutex> lock(mInfosMutex);
+    mInfos.push_back({id, metadata.type, metadata.name});
+}
+
+bool StreamServer::Publish(MetricID id, const MetricData& data)
+{
+    if (!mQueue || (GetClientCount() == 0)) {
+        return false;
+    }
+    return mQueue->Push(id, data);
+}
+
+void StreamServer::Run()
+{
+#if defined(PPX_HAS_POSIX_SOCKETS)
+    std::vector<pollfd> pollFds;
+    while (!mStopRequested.load()) {
+        AcceptClients();
+
+        // Pop before sending infos: data is published after its metric's info
+        // was added, so every popped entry's info is sent first
+        mDataBytes.clear();
+        MetricID   id   = kInvalidMetricID;
+        MetricData data = {};
+        while (mQueue->Pop(&id, &data)) {
+            StreamDataRecord record = {};
+            record.id               = id;
+            record.seconds          = (data.type == MetricType::GAUGE) ? data.gauge.seconds : 0.0;
+            record.value            = (data.type == MetricType::GAUGE) ? data.gauge.value : static_cast<double>(data.counter.increment);
+            AppendBytes(mDataBytes, &record, sizeof(record));
+        }
+        SendNewInfos();
+
+        pollFds.clear();
+        pollFds.push_back({mListenSocket, POLLIN, 0});
+        for (size_t i = mClients.size(); i > 0; --i) {
+            Client& client = mClients[i - 1];
+            if (!mDataBytes.empty() && (client.pending.size() < kMaxPendingBytes)) {
+                AppendBytes(client.pending, mDataBytes.data(), mDataBytes.size());
+            }
+
+            while (!client.pending.empty()) {
+                const ssize_t sent = send(client.socket, client.pending.data(), client.pending.size(), MSG_NOSIGNAL);
+                if (sent <= 0) {
+                    break;
+                }
+                client.pending.erase(client.pending.begin(), client.pending.begin() + sent);
+            }
+
+            // Closed by the client, or a send error other than a full socket buffer
+            char    probe    = 0;
+            ssize_t received = recv(client.socket, &probe, sizeof(probe), MSG_DONTWAIT);
+            if ((received == 0) || ((received < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))) {
+                DropClient(i - 1);
+                continue;
+            }
+            pollFds.push_back({client.socket, static_cast<short>(client.pending.empty() ? 0 : POLLOUT), 0});
+        }
+
+        poll(pollFds.data(), static_cast<nfds_t>(pollFds.size()), kPollTimeoutMs);
+    }
+#endif
+}
+
+void StreamServer::AcceptClients()
+{
+#if defined(PPX_HAS_POSIX_SOCKETS)
+    for (;;) {
+        int clientSocket = accept(mListenSocket, nullptr, nullptr);
+        if (clientSocket < 0) {
+            return;
+        }
+        if (mClients.size() >= kMaxClients) {
+            PPX_LOG_WARN("Metrics stream server refused a client, " << kMaxClients << " are connected");
+            close(clientSocket);
+            continue;
+        }
+
+        fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL, 0) | O_NONBLOCK);
+        int noDelay = 1;
+        setsockopt(clientSocket, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        Client client = {};
+        client.socket = clientSocket;
+        {
+            // Infos not sent yet are sent by the next SendNewInfos()
+            std::lock_guard<std::mutex> lock(mInfosMutex);
+            for (size_t i = 0; i < mSentInfoCount; ++i) {
+                AppendInfo(client.pending, mInfos[i].id, mInfos[i].type, mInfos[i].name);
+            }
+        }
+        mClients.push_back(std::move(client));
+        mClientCount.store(static_cast<uint32_t>(mClients.size()));
+    }
+#endif
+}
+
+void StreamServer::SendNewInfos()
+{
+    std::lock_guard<std::mutex> lock(mInfosMutex);
+    for (; mSentInfoCount < mInfos.size(); ++mSentInfoCount) {
+        const MetricInfo& info = mInfos[mSentInfoCount];
+        for (Client& client : mClients) {
+            AppendInfo(client.pending, info.id, info.type, info.name);
+        }
+    }
+}
+
+void StreamServer::DropClient(size_t index)
+{
+#if defined(PPX_HAS_POSIX_SOCKETS)
+    close(mClients[index].socket);
+#endif
+    mClients.erase(mClients.begin() + index);
+    mClientCount.store(static_cast<uint32_t>(mClients.size()));
+}
+
+} // namespace metrics
+} // namespace ppx
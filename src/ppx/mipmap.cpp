@@ -17,12 +17,271 @@
 #include "ppx/timer.h"
 
 #include "stb_image.h"
-#include "stb_image_resize.h"
 
+#include <atomic>
+#include <cmath>
 #include <filesystem>
+#include <limits>
+#include <thread>
+#include <type_traits>
 
 namespace ppx {
 
+namespace {
+
+// Bands are sized so their horizontally filtered rows stay in cache
+constexpr size_t kBandScratchSize = 256 * 1024;
+// Levels with fewer pixels are filtered on the calling thread
+constexpr uint64_t kMinParallelPixelCount = 256 * 256;
+// Kaiser filter radius in destination pixels and window shape
+constexpr float kKaiserRadius = 3.0f;
+constexpr float kKaiserAlpha  = 4.0f;
+constexpr float kPi           = 3.14159265358979f;
+
+// Source pixels and weights for one destination pixel along an axis
+struct FilterTaps
+{
+    uint32_t first        = 0;
+    uint32_t count        = 0;
+    uint32_t weightOffset = 0;
+};
+
+struct FilterWeights
+{
+    std::vector<FilterTaps> taps;
+    std::vector<float>      weights;
+};
+
+float BesselI0(float x)
+{
+    float sum  = 1.0f;
+    float term = 1.0f;
+    for (uint32_t k = 1; k < 32; ++k) {
+        const float t = x / (2.0f * k);
+        term *= t * t;
+        sum += term;
+        if (term < (sum * 1e-7f)) {
+            break;
+        }
+    }
+    return sum;
+}
+
+float Kaiser(float x)
+{
+    if (std::abs(x) >= kKaiserRadius) {
+        return 0.0f;
+    }
+    const float sinc = (x == 0.0f) ? 1.0f : std::sin(kPi * x) / (kPi * x);
+    const float t    = x / kKaiserRadius;
+    return sinc * BesselI0(kKaiserAlpha * std::sqrt(1.0f - t * t)) / BesselI0(kKaiserAlpha);
+}
+
+// Source pixels outside the image are clamped to the edge
+FilterWeights CalculateFilterWeights(uint32_t srcSize, uint32_t dstSize, MipmapFilter filter)
+{
+    const float scale  = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+    const float radius = (filter == MIPMAP_FILTER_KAISER) ? (kKaiserRadius * scale) : (0.5f * scale);
+
+    FilterWeights result = {};
+    result.taps.resize(dstSize);
+    for (uint32_t i = 0; i < dstSize; ++i) {
+        const float   center = (static_cast<float>(i) + 0.5f) * scale;
+        const int32_t begin  = static_cast<int32_t>(std::floor(center - radius));
+        const int32_t end    = static_cast<int32_t>(std::ceil(center + radius));
+        const int32_t first  = std::max<int32_t>(begin, 0);
+        const int32_t last   = std::min<int32_t>(end - 1, static_cast<int32_t>(srcSize) - 1);
+
+        FilterTaps& taps  = result.taps[i];
+        taps.first        = static_cast<uint32_t>(first);
+        taps.count        = static_cast<uint32_t>(last - first + 1);
+        taps.weightOffset = CountU32(result.weights);
+        result.weights.resize(result.weights.size() + taps.count, 0.0f);
+
+        float* pWeights = result.weights.data() + taps.weightOffset;
+        float  sum      = 0.0f;
+        for (int32_t j = begin; j < end; ++j) {
+            float weight = 0.0f;
+            if (filter == MIPMAP_FILTER_KAISER) {
+                weight = Kaiser((static_cast<float>(j) + 0.5f - center) / scale);
+            }
+            else {
+                const float overlapBegin = std::max(center - radius, static_cast<float>(j));
+                const float overlapEnd   = std::min(center + radius, static_cast<float>(j + 1));
+                weight                   = std::max(overlapEnd - overlapBegin, 0.0f);
+            }
+            pWeights[std::min(std::max(j, first), last) - first] += weight;
+            sum += weight;
+        }
+        for (uint32_t j = 0; j < taps.count; ++j) {
+            pWeights[j] /= sum;
+        }
+    }
+    return result;
+}
+
+float SrgbToLinear(float value)
+{
+    return (value <= 0.04045f) ? (value / 12.92f) : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float LinearToSrgb(float value)
+{
+    return (value <= 0.0031308f) ? (value * 12.92f) : (1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f);
+}
+
+// Linear values of 8 bit sRGB in [0, 255]
+const float* GetSrgbToLinearTable()
+{
+    static const std::vector<float> sTable = []() {
+        std::vector<float> table(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            table[i] = 255.0f * SrgbToLinear(static_cast<float>(i) / 255.0f);
+        }
+        return table;
+    }();
+    return sTable.data();
+}
+
+template <typename T>
+T FromFilteredValue(float value)
+{
+    if constexpr (std::is_floating_point<T>::value) {
+        return static_cast<T>(value);
+    }
+    else {
+        const float maxValue = static_cast<float>(std::numeric_limits<T>::max());
+        return static_cast<T>(std::min(std::max(value, 0.0f), maxValue) + 0.5f);
+    }
+}
+
+// Filters the source rows a band of destination rows needs horizontally into
+// scratch, then filters those vertically into the destination rows
+template <typename T>
+class LevelDownsampler
+{
+public:
+    LevelDownsampler(const Bitmap& src, Bitmap* pDst, MipmapFilter filter, bool srgb)
+        : mSrc(src),
+          mDst(*pDst),
+          mChannelCount(src.GetChannelCount()),
+          mColorChannelCount((mChannelCount == 4) ? 3 : mChannelCount),
+          mHorizontal(CalculateFilterWeights(src.GetWidth(), pDst->GetWidth(), filter)),
+          mVertical(CalculateFilterWeights(src.GetHeight(), pDst->GetHeight(), filter)),
+          mpSrgbToLinear((srgb && (sizeof(T) == 1)) ? GetSrgbToLinearTable() : nullptr)
+    {
+    }
+
+    uint32_t GetBandRowCount() const
+    {
+        const size_t rowSize = static_cast<size_t>(mDst.GetWidth()) * mChannelCount * sizeof(float);
+        // Bands read about twice as many source rows as they write
+        const size_t rowCount = kBandScratchSize / (2 * rowSize);
+        return static_cast<uint32_t>(std::min<size_t>(std::max<size_t>(rowCount, 1), mDst.GetHeight()));
+    }
+
+    void FilterBand(uint32_t dstRowBegin, uint32_t dstRowEnd, std::vector<float>* pScratch) const
+    {
+        const uint32_t dstWidth   = mDst.GetWidth();
+        const size_t   rowFloats  = static_cast<size_t>(dstWidth) * mChannelCount;
+        const uint32_t srcRowBase = mVertical.taps[dstRowBegin].first;
+        const uint32_t srcRowEnd  = mVertical.taps[dstRowEnd - 1].first + mVertical.taps[dstRowEnd - 1].count;
+        pScratch->resize(rowFloats * (srcRowEnd - srcRowBase));
+
+        for (uint32_t y = srcRowBase; y < srcRowEnd; ++y) {
+            const T* pSrcRow     = reinterpret_cast<const T*>(mSrc.GetPixelAddress(0, y));
+            float*   pScratchRow = pScratch->data() + rowFloats * (y - srcRowBase);
+            for (uint32_t x = 0; x < dstWidth; ++x) {
+                const FilterTaps& taps     = mHorizontal.taps[x];
+                const float*      pWeights = mHorizontal.weights.data() + taps.weightOffset;
+                const T*          pSrc     = pSrcRow + static_cast<size_t>(taps.first) * mChannelCount;
+                float*            pDst     = pScratchRow + static_cast<size_t>(x) * mChannelCount;
+                for (uint32_t c = 0; c < mChannelCount; ++c) {
+                    float sum = 0.0f;
+                    for (uint32_t i = 0; i < taps.count; ++i) {
+                        sum += pWeights[i] * ToLinear(pSrc[i * mChannelCount + c], c);
+                    }
+                    pDst[c] = sum;
+                }
+            }
+        }
+
+        for (uint32_t y = dstRowBegin; y < dstRowEnd; ++y) {
+            const FilterTaps& taps     = mVertical.taps[y];
+            const float*      pWeights = mVertical.weights.data() + taps.weightOffset;
+            const float*      pSrc     = pScratch->data() + rowFloats * (taps.first - srcRowBase);
+            T*                pDstRow  = reinterpret_cast<T*>(mDst.GetPixelAddress(0, y));
+            for (size_t i = 0; i < rowFloats; ++i) {
+                float sum = 0.0f;
+                for (uint32_t j = 0; j < taps.count; ++j) {
+                    sum += pWeights[j] * pSrc[j * rowFloats + i];
+                }
+                pDstRow[i] = FromLinear(sum, static_cast<uint32_t>(i % mChannelCount));
+            }
+        }
+    }
+
+private:
+    float ToLinear(T value, uint32_t channel) const
+    {
+        if constexpr (sizeof(T) == 1) {
+            if (!IsNull(mpSrgbToLinear) && (channel < mColorChannelCount)) {
+                return mpSrgbToLinear[value];
+            }
+        }
+        return static_cast<float>(value);
+    }
+
+    T FromLinear(float value, uint32_t channel) const
+    {
+        if (!IsNull(mpSrgbToLinear) && (channel < mColorChannelCount)) {
+            value = 255.0f * LinearToSrgb(std::min(std::max(value / 255.0f, 0.0f), 1.0f));
+        }
+        return FromFilteredValue<T>(value);
+    }
+
+private:
+    const Bitmap& mSrc;
+    Bitmap&       mDst;
+    uint32_t      mChannelCount      = 0;
+    uint32_t      mColorChannelCount = 0;
+    FilterWeights mHorizontal;
+    FilterWeights mVertical;
+    const float*  mpSrgbToLinear = nullptr;
+};
+
+template <typename T>
+void DownsampleLevel(const Bitmap& src, Bitmap* pDst, const MipmapGenerateInfo& generateInfo, uint32_t threadCount)
+{
+    const LevelDownsampler<T> downsampler(src, pDst, generateInfo.filter, generateInfo.srgb);
+    const uint32_t            bandRowCount = downsampler.GetBandRowCount();
+    const uint32_t            bandCount    = (pDst->GetHeight() + bandRowCount - 1) / bandRowCount;
+
+    std::atomic<uint32_t> nextBand = 0;
+
+    auto filter = [&]() {
+        std::vector<float> scratch;
+        for (uint32_t i = nextBand++; i < bandCount; i = nextBand++) {
+            const uint32_t rowBegin = i * bandRowCount;
+            downsampler.FilterBand(rowBegin, std::min(rowBegin + bandRowCount, pDst->GetHeight()), &scratch);
+        }
+    };
+
+    const uint64_t pixelCount  = static_cast<uint64_t>(pDst->GetWidth()) * pDst->GetHeight();
+    const uint32_t workerCount = (pixelCount < kMinParallelPixelCount) ? 0 : (std::min(threadCount, bandCount) - 1);
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(filter);
+    }
+    filter();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+} // namespace
+
 static uint32_t CalculatActualLevelCount(uint32_t width, uint32_t height, uint32_t levelCount)
 {
     uint32_t actualLevelCount = 0;
@@ -121,6 +380,11 @@ Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount)
 }
 
 Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool)
+    : Mipmap(bitmap, levelCount, useStaticPool, MipmapGenerateInfo())
+{
+}
+
+Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool, const MipmapGenerateInfo& generateInfo)
     : Mipmap(bitmap.GetWidth(), bitmap.GetHeight(), bitmap.GetFormat(), levelCount, useStaticPool)
 {
     Bitmap* pMip0 = GetMip(0);
@@ -132,18 +396,11 @@ Mipmap::Mipmap(const Bitmap& bitmap, uint32_t levelCount, bool useStaticPool)
         if ((srcSize > 0) && (srcSize == dstSize) && !IsNull(pSrcData) && !IsNull(pDstData)) {
             memcpy(pDstData, pSrcData, srcSize);
 
-            // Generate mip
-            for (uint32_t level = 1; level < levelCount; ++level) {
-                uint32_t prevLevel = level - 1;
-                Bitmap*  pPrevMip  = GetMip(prevLevel);
-                Bitmap*  pMip      = GetMip(level);
-
-                Result ppxres = pPrevMip->ScaleTo(pMip, STBIR_FILTER_BOX);
-                if (Failed(ppxres)) {
-                    mData.clear();
-                    mMips.clear();
-                    return;
-                }
+            Result ppxres = GenerateLevels(generateInfo);
+            if (Failed(ppxres)) {
+                mData.clear();
+                mMips.clear();
+                return;
             }
         }
     }
@@ -213,6 +470,36 @@ uint32_t Mipmap::GetHeight(uint32_t level) const
     return IsNull(pMip) ? 0 : pMip->GetHeight();
 }
 
+Result Mipmap::GenerateLevels(const MipmapGenerateInfo& generateInfo)
+{
+    if (!IsOk()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    uint32_t threadCount = generateInfo.threadCount;
+    if (threadCount == 0) {
+        threadCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    const Bitmap::DataType dataType = Bitmap::ChannelDataType(GetFormat());
+    for (uint32_t level = 1; level < GetLevelCount(); ++level) {
+        const Bitmap& prevMip = mMips[level - 1];
+        Bitmap*       pMip    = &mMips[level];
+
+        // clang-format off
+        switch (dataType) {
+            default: return ppx::ERROR_IMAGE_INVALID_FORMAT;
+            case Bitmap::DATA_TYPE_UINT8  : DownsampleLevel<uint8_t>(prevMip, pMip, generateInfo, threadCount); break;
+            case Bitmap::DATA_TYPE_UINT16 : DownsampleLevel<uint16_t>(prevMip, pMip, generateInfo, threadCount); break;
+            case Bitmap::DATA_TYPE_UINT32 : DownsampleLevel<uint32_t>(prevMip, pMip, generateInfo, threadCount); break;
+            case Bitmap::DATA_TYPE_FLOAT  : DownsampleLevel<float>(prevMip, pMip, generateInfo, threadCount); break;
+        }
+        // clang-format on
+    }
+
+    return ppx::SUCCESS;
+}
+
 uint32_t Mipmap::CalculateLevelCount(uint32_t width, uint32_t height)
 {
     uint32_t levelCount = CalculatActualLevelCount(width, height, UINT32_MAX);
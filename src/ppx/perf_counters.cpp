@@ -0,0 +1,149 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/perf_counters.h"
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#define PPX_HAS_PERF_EVENT
+#endif
+
+namespace ppx {
+
+#if defined(PPX_HAS_PERF_EVENT)
+static int OpenPerfEvent(PerfCounter counter)
+{
+    static const uint64_t kConfigs[PERF_COUNTER_COUNT] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_BRANCH_MISSES,
+    };
+
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = kConfigs[counter];
+    attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.inherit        = 1; // Threads created later are counted too
+    attr.exclude_kernel = 1; // Allowed with perf_event_paranoid up to 2
+    attr.exclude_hv     = 1;
+
+    // Calling thread, any CPU
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+#endif
+
+PerfCounters::~PerfCounters()
+{
+    Close();
+}
+
+Result PerfCounters::Open()
+{
+    Close();
+
+#if defined(PPX_HAS_PERF_EVENT)
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        mFds[i] = OpenPerfEvent(static_cast<PerfCounter>(i));
+    }
+#endif
+
+    return IsOpen() ? ppx::SUCCESS : ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+}
+
+void PerfCounters::Close()
+{
+    for (int& fd : mFds) {
+#if defined(PPX_HAS_PERF_EVENT)
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+        fd = -1;
+    }
+}
+
+bool PerfCounters::IsOpen() const
+{
+    for (int fd : mFds) {
+        if (fd >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PerfCounters::IsAvailable(PerfCounter counter) const
+{
+    return (counter < PERF_COUNTER_COUNT) && (mFds[counter] >= 0);
+}
+
+Result PerfCounters::Read(PerfCounterValues* pValues) const
+{
+    PPX_ASSERT_NULL_ARG(pValues);
+    if (IsNull(pValues)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    *pValues = {};
+    if (!IsOpen()) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+#if defined(PPX_HAS_PERF_EVENT)
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (mFds[i] < 0) {
+            continue;
+        }
+
+        // value, time enabled, time running
+        uint64_t data[3] = {};
+        if (read(mFds[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data))) {
+            return ppx::ERROR_FAILED;
+        }
+
+        const uint64_t value   = data[0];
+        const uint64_t enabled = data[1];
+        const uint64_t running = data[2];
+        if ((running > 0) && (running < enabled)) {
+            pValues->values[i] = static_cast<uint64_t>(static_cast<double>(value) * static_cast<double>(enabled) / static_cast<double>(running));
+        }
+        else {
+            pValues->values[i] = value;
+        }
+    }
+#endif
+
+    return ppx::SUCCESS;
+}
+
+const char* PerfCounters::GetName(PerfCounter counter)
+{
+    switch (counter) {
+        case PERF_COUNTER_CYCLES: return "cycles";
+        case PERF_COUNTER_INSTRUCTIONS: return "instructions";
+        case PERF_COUNTER_CACHE_MISSES: return "cache_misses";
+        case PERF_COUNTER_BRANCH_MISSES: return "branch_misses";
+        default: break;
+    }
+    return "<unknown>";
+}
+
+} // namespace ppx
@@ -0,0 +1,189 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/performance_hints.h"
+
+#include <cmath>
+#include <limits>
+
+#if defined(PPX_ANDROID)
+#include <dlfcn.h>
+#include <unistd.h>
+#endif
+
+namespace ppx {
+
+#if defined(PPX_ANDROID)
+// libandroid functions, looked up at runtime so older API levels load
+struct AdpfFunctions
+{
+    void* (*APerformanceHint_getManager)()                                                     = nullptr;
+    void* (*APerformanceHint_createSession)(void*, const int32_t*, size_t, int64_t)            = nullptr;
+    int (*APerformanceHint_updateTargetWorkDuration)(void*, int64_t)                           = nullptr;
+    int (*APerformanceHint_reportActualWorkDuration)(void*, int64_t)                           = nullptr;
+    void (*APerformanceHint_closeSession)(void*)                                               = nullptr;
+    void* (*AThermal_acquireManager)()                                                         = nullptr;
+    void (*AThermal_releaseManager)(void*)                                                     = nullptr;
+    int (*AThermal_getCurrentThermalStatus)(void*)                                             = nullptr;
+    float (*AThermal_getThermalHeadroom)(void*, int)                                           = nullptr;
+};
+
+static AdpfFunctions sAdpf;
+
+template <typename T>
+static void LoadFunction(void* pLibrary, const char* name, T* pFunction)
+{
+    *pFunction = reinterpret_cast<T>(dlsym(pLibrary, name));
+}
+#endif
+
+PerformanceHints::~PerformanceHints()
+{
+    Close();
+}
+
+Result PerformanceHints::Open(uint64_t targetWorkDurationNanos)
+{
+    Close();
+
+#if defined(PPX_ANDROID)
+    mLibrary = dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL);
+    if (IsNull(mLibrary)) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    LoadFunction(mLibrary, "APerformanceHint_getManager", &sAdpf.APerformanceHint_getManager);
+    LoadFunction(mLibrary, "APerformanceHint_createSession", &sAdpf.APerformanceHint_createSession);
+    LoadFunction(mLibrary, "APerformanceHint_updateTargetWorkDuration", &sAdpf.APerformanceHint_updateTargetWorkDuration);
+    LoadFunction(mLibrary, "APerformanceHint_reportActualWorkDuration", &sAdpf.APerformanceHint_reportActualWorkDuration);
+    LoadFunction(mLibrary, "APerformanceHint_closeSession", &sAdpf.APerformanceHint_closeSession);
+    LoadFunction(mLibrary, "AThermal_acquireManager", &sAdpf.AThermal_acquireManager);
+    LoadFunction(mLibrary, "AThermal_releaseManager", &sAdpf.AThermal_releaseManager);
+    LoadFunction(mLibrary, "AThermal_getCurrentThermalStatus", &sAdpf.AThermal_getCurrentThermalStatus);
+    LoadFunction(mLibrary, "AThermal_getThermalHeadroom", &sAdpf.AThermal_getThermalHeadroom);
+
+    // Session for the calling thread, Android 13
+    if ((sAdpf.APerformanceHint_getManager != nullptr) && (sAdpf.APerformanceHint_createSession != nullptr) && (sAdpf.APerformanceHint_closeSession != nullptr)) {
+        void* pManager = sAdpf.APerformanceHint_getManager();
+        if (!IsNull(pManager)) {
+            const int32_t tid = static_cast<int32_t>(gettid());
+            mSession          = sAdpf.APerformanceHint_createSession(pManager, &tid, 1, static_cast<int64_t>(targetWorkDurationNanos));
+        }
+    }
+
+    // Thermal status, Android 11
+    if ((sAdpf.AThermal_acquireManager != nullptr) && (sAdpf.AThermal_releaseManager != nullptr) && (sAdpf.AThermal_getCurrentThermalStatus != nullptr)) {
+        mThermalManager = sAdpf.AThermal_acquireManager();
+    }
+
+    if (!IsOpen()) {
+        Close();
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+    return ppx::SUCCESS;
+#else
+    (void)targetWorkDurationNanos;
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#endif
+}
+
+void PerformanceHints::Close()
+{
+#if defined(PPX_ANDROID)
+    if (!IsNull(mSession)) {
+        sAdpf.APerformanceHint_closeSession(mSession);
+    }
+    if (!IsNull(mThermalManager)) {
+        sAdpf.AThermal_releaseManager(mThermalManager);
+    }
+    if (!IsNull(mLibrary)) {
+        dlclose(mLibrary);
+    }
+#endif
+    mSession        = nullptr;
+    mThermalManager = nullptr;
+    mLibrary        = nullptr;
+}
+
+Result PerformanceHints::UpdateTargetWorkDuration(uint64_t nanos)
+{
+    if (!HasHintSession()) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+#if defined(PPX_ANDROID)
+    if ((sAdpf.APerformanceHint_updateTargetWorkDuration == nullptr) || (sAdpf.APerformanceHint_updateTargetWorkDuration(mSession, static_cast<int64_t>(nanos)) != 0)) {
+        return ppx::ERROR_FAILED;
+    }
+#endif
+    return ppx::SUCCESS;
+}
+
+Result PerformanceHints::ReportActualWorkDuration(uint64_t nanos)
+{
+    if (!HasHintSession()) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+    // Durations must be positive
+    if (nanos == 0) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+#if defined(PPX_ANDROID)
+    if ((sAdpf.APerformanceHint_reportActualWorkDuration == nullptr) || (sAdpf.APerformanceHint_reportActualWorkDuration(mSession, static_cast<int64_t>(nanos)) != 0)) {
+        return ppx::ERROR_FAILED;
+    }
+#endif
+    return ppx::SUCCESS;
+}
+
+ThermalStatus PerformanceHints::GetThermalStatus() const
+{
+#if defined(PPX_ANDROID)
+    if (HasThermalStatus()) {
+        const int status = sAdpf.AThermal_getCurrentThermalStatus(mThermalManager);
+        if ((status >= THERMAL_STATUS_NONE) && (status <= THERMAL_STATUS_SHUTDOWN)) {
+            return static_cast<ThermalStatus>(status);
+        }
+    }
+#endif
+    return THERMAL_STATUS_UNKNOWN;
+}
+
+float PerformanceHints::GetThermalHeadroom(uint32_t forecastSeconds) const
+{
+#if defined(PPX_ANDROID)
+    if (HasThermalStatus() && (sAdpf.AThermal_getThermalHeadroom != nullptr)) {
+        return sAdpf.AThermal_getThermalHeadroom(mThermalManager, static_cast<int>(forecastSeconds));
+    }
+#else
+    (void)forecastSeconds;
+#endif
+    return std::numeric_limits<float>::quiet_NaN();
+}
+
+const char* PerformanceHints::GetThermalStatusName(ThermalStatus status)
+{
+    switch (status) {
+        case THERMAL_STATUS_NONE: return "none";
+        case THERMAL_STATUS_LIGHT: return "light";
+        case THERMAL_STATUS_MODERATE: return "moderate";
+        case THERMAL_STATUS_SEVERE: return "severe";
+        case THERMAL_STATUS_CRITICAL: return "critical";
+        case THERMAL_STATUS_EMERGENCY: return "emergency";
+        case THERMAL_STATUS_SHUTDOWN: return "shutdown";
+        default: break;
+    }
+    return "unknown";
+}
+
+} // namespace ppx
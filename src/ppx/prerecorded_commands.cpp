@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/prerecorded_commands.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/knob.h"
+
+namespace ppx {
+
+Result PrerecordedCommands::Initialize(const PrerecordedCommandsCreateInfo& createInfo)
+{
+    if (IsNull(createInfo.pQueue) || (createInfo.count == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    mQueue       = createInfo.pQueue;
+    mSecondary   = createInfo.secondary;
+    mKey         = 0;
+    mRecordCount = 0;
+    mEntries.assign(createInfo.count, Entry{});
+    mKnobs.clear();
+
+    return ppx::SUCCESS;
+}
+
+void PrerecordedCommands::Shutdown()
+{
+    for (Entry& entry : mEntries) {
+        if (!IsNull(entry.pCommandBuffer)) {
+            mQueue->DestroyCommandBuffer(entry.pCommandBuffer);
+        }
+    }
+    mEntries.clear();
+    mKnobs.clear();
+    mQueue = nullptr;
+}
+
+void PrerecordedCommands::Invalidate()
+{
+    for (Entry& entry : mEntries) {
+        entry.stale = true;
+    }
+}
+
+void PrerecordedCommands::WatchKnob(Knob* pKnob)
+{
+    PPX_ASSERT_NULL_ARG(pKnob);
+    mKnobs.push_back({pKnob, pKnob->ValueString()});
+}
+
+void PrerecordedCommands::SetKey(uint64_t key)
+{
+    if (key != mKey) {
+        mKey = key;
+        Invalidate();
+    }
+}
+
+void PrerecordedCommands::CheckKnobs()
+{
+    for (WatchedKnob& knob : mKnobs) {
+        std::string value = knob.pKnob->ValueString();
+        if (value != knob.value) {
+            knob.value = value;
+            Invalidate();
+        }
+    }
+}
+
+Result PrerecordedCommands::Get(uint32_t index, const RecordFn& recordFn, grfx::CommandBuffer** ppCommandBuffer)
+{
+    PPX_ASSERT_NULL_ARG(ppCommandBuffer);
+    if (index >= CountU32(mEntries)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    CheckKnobs();
+
+    Entry& entry = mEntries[index];
+    if (entry.stale) {
+        // Earlier submissions of the old command buffer may still be
+        // pending, so record into a new one instead of resetting it.
+        grfx::CommandBuffer* pCommandBuffer = nullptr;
+        Result               ppxres         = mQueue->CreateReusableCommandBuffer(&pCommandBuffer, mSecondary);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = recordFn(pCommandBuffer, index);
+        if (Failed(ppxres)) {
+            mQueue->DestroyCommandBuffer(pCommandBuffer);
+            return ppxres;
+        }
+
+        if (!IsNull(entry.pCommandBuffer)) {
+            mQueue->GetDevice()->DeferDestroyCommandBuffer(entry.pCommandBuffer);
+        }
+        entry.pCommandBuffer = pCommandBuffer;
+        entry.stale          = false;
+        ++mRecordCount;
+    }
+
+    *ppCommandBuffer = entry.pCommandBuffer;
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
@@ -15,6 +15,10 @@
 #include "ppx/profiler.h"
 #include "ppx/timer.h"
 
+#include <atomic>
+#include <iomanip>
+#include <unordered_map>
+
 #define PPX_MAX_THREAD_PROFILERS 64
 
 namespace ppx {
@@ -24,6 +28,15 @@ static std::mutex         sThreadIndexMutex;
 static unsigned int       sThreadCount = 0;
 thread_local unsigned int sThreadIndex = UINT32_MAX;
 
+// Added to a thread's profiler by its first sample, guarded by sThreadIndexMutex
+static std::unordered_map<ProfilerEventToken, std::string> sScopeEvents;
+
+static std::atomic<bool>                  sTracing             = false;
+static uint32_t                           sTraceCapacity       = 0;
+static uint64_t                           sTraceStartTimestamp = 0;
+static std::mutex                         sTraceGpuScopesMutex;
+static std::vector<ProfilerTraceGpuScope> sTraceGpuScopes;
+
 static unsigned int GetThreadIndex()
 {
     if (sThreadIndex == UINT32_MAX) {
@@ -117,6 +130,7 @@ void Profiler::RemoveAllEvents()
 {
     std::lock_guard<std::mutex> lock(sThreadIndexMutex);
     mEvents.clear();
+    mEventIndices.clear();
 }
 
 Result Profiler::RegisterEvent(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken* pToken)
@@ -130,6 +144,9 @@ Result Profiler::RegisterEvent(ProfilerEventType type, const std::string& name,
 
     ProfilerEventToken token = XXH64(name.c_str(), name.length(), 0xDEADBEEF);
 
+    // Set even on ERROR_DUPLICATE_ELEMENT so the existing event can be used
+    *pToken = token;
+
     for (size_t i = 0; i < PPX_MAX_THREAD_PROFILERS; ++i) {
         Result ppxres = sPerThreadProfilers[i].RegisterEventInternal(type, name, recordAction, token);
         if (Failed(ppxres)) {
@@ -137,8 +154,6 @@ Result Profiler::RegisterEvent(ProfilerEventType type, const std::string& name,
         }
     }
 
-    *pToken = token;
-
     return ppx::SUCCESS;
 }
 
@@ -148,17 +163,24 @@ Result Profiler::RegisterGrfxApiFnEvent(const std::string& name, ProfilerEventTo
     return ppxres;
 }
 
+ProfilerEventToken Profiler::RegisterScopeEvent(const std::string& name)
+{
+    ProfilerEventToken token = XXH64(name.c_str(), name.length(), 0xDEADBEEF);
+
+    // Scopes are first executed while other threads record samples, so unlike
+    // RegisterEvent() this doesn't touch the per-thread profilers
+    std::lock_guard<std::mutex> lock(sThreadIndexMutex);
+    sScopeEvents.emplace(token, name);
+    return token;
+}
+
 Result Profiler::RegisterEventInternal(ProfilerEventType type, const std::string& name, ProfileEventRecordAction recordAction, ProfilerEventToken token)
 {
-    auto it = FindIf(
-        mEvents,
-        [token](const ProfilerEvent& elem) -> bool {
-            bool isSame = (elem.mToken == token);
-            return isSame; });
-    if (it != std::end(mEvents)) {
+    if (mEventIndices.find(token) != mEventIndices.end()) {
         return ppx::ERROR_DUPLICATE_ELEMENT;
     }
 
+    mEventIndices.emplace(token, mEvents.size());
     mEvents.emplace_back(type, name, recordAction, token);
 
     return ppx::SUCCESS;
@@ -166,14 +188,208 @@ Result Profiler::RegisterEventInternal(ProfilerEventType type, const std::string
 
 void Profiler::RecordSample(const ProfilerEventToken& token, const ProfilerEventSample& sample)
 {
-    auto it = FindIf(
-        mEvents,
-        [token](const ProfilerEvent& elem) -> bool {
-            bool isSame = (elem.mToken == token);
-            return isSame; });
-    if (it != std::end(mEvents)) {
-        ProfilerEvent& event = *it;
+    auto it = mEventIndices.find(token);
+    if (it == mEventIndices.end()) {
+        // First sample of a scope event on this thread
+        std::lock_guard<std::mutex> lock(sThreadIndexMutex);
+        auto                        scopeIt = sScopeEvents.find(token);
+        if (scopeIt != sScopeEvents.end()) {
+            RegisterEventInternal(PROFILER_EVENT_TYPE_SCOPE, scopeIt->second, PROFILER_EVENT_RECORD_ACTION_AVERAGE, token);
+            it = mEventIndices.find(token);
+        }
+    }
+    if (it != mEventIndices.end()) {
+        ProfilerEvent& event = mEvents[it->second];
         event.RecordSample(sample);
+
+        if (sTracing.load(std::memory_order_relaxed)) {
+            RecordTraceEvent({PROFILER_TRACE_EVENT_TYPE_SAMPLE, token, sample.startTimestamp, sample.endTimestamp});
+        }
+    }
+}
+
+void Profiler::RecordTraceEvent(const ProfilerTraceEvent& event)
+{
+    if (mTraceEvents.empty()) {
+        mTraceEvents.resize(sTraceCapacity);
+    }
+    if (mTraceEventCount >= mTraceEvents.size()) {
+        mTraceDroppedCount += 1;
+        return;
+    }
+    mTraceEvents[mTraceEventCount] = event;
+    mTraceEventCount += 1;
+}
+
+void Profiler::ResetTrace(uint32_t maxEvents)
+{
+    // Keep the buffer if the next trace uses the same size
+    if (mTraceEvents.size() != maxEvents) {
+        std::vector<ProfilerTraceEvent>().swap(mTraceEvents);
+    }
+    mTraceEventCount   = 0;
+    mTraceDroppedCount = 0;
+}
+
+void Profiler::StartTrace(uint32_t maxEventsPerThread)
+{
+    PPX_ASSERT_MSG(maxEventsPerThread > 0, "trace needs room for at least one event per thread");
+
+    for (auto& profiler : sPerThreadProfilers) {
+        profiler.ResetTrace(maxEventsPerThread);
+    }
+    {
+        std::lock_guard<std::mutex> lock(sTraceGpuScopesMutex);
+        sTraceGpuScopes.clear();
+    }
+    sTraceCapacity = maxEventsPerThread;
+    Timer::Timestamp(&sTraceStartTimestamp);
+    sTracing.store(true);
+}
+
+void Profiler::StopTrace()
+{
+    sTracing.store(false);
+}
+
+bool Profiler::IsTracing()
+{
+    return sTracing.load(std::memory_order_relaxed);
+}
+
+void Profiler::RecordTraceFrameMarker(uint64_t frameNumber)
+{
+    if (!IsTracing()) {
+        return;
+    }
+
+    Profiler* pProfiler = GetProfilerForThread();
+    if (IsNull(pProfiler)) {
+        return;
+    }
+
+    uint64_t timestamp = 0;
+    Timer::Timestamp(&timestamp);
+    pProfiler->RecordTraceEvent({PROFILER_TRACE_EVENT_TYPE_FRAME_MARKER, frameNumber, timestamp, timestamp});
+}
+
+void Profiler::RecordTraceGpuScope(const std::string& name, uint64_t startTimestamp, uint64_t endTimestamp)
+{
+    if (!IsTracing()) {
+        return;
+    }
+
+    // Same bound as a thread's buffer, GPU scopes are only added once per frame
+    std::lock_guard<std::mutex> lock(sTraceGpuScopesMutex);
+    if (sTraceGpuScopes.size() < sTraceCapacity) {
+        sTraceGpuScopes.push_back({name, startTimestamp, endTimestamp});
+    }
+}
+
+static void WriteTraceString(std::ostream& os, const std::string& s)
+{
+    os << '"';
+    for (char c : s) {
+        if ((c == '"') || (c == '\\')) {
+            os << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+        }
+        else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+// Microseconds since the start of the trace, events may have started before it
+static double TraceMicros(uint64_t timestamp)
+{
+    return (timestamp > sTraceStartTimestamp) ? Timer::TimestampToMicros(timestamp - sTraceStartTimestamp) : 0.0;
+}
+
+static const char* TraceCategory(ProfilerEventType type)
+{
+    switch (type) {
+        case PROFILER_EVENT_TYPE_GRFX_API_FN: return "grfx_api_fn";
+        case PROFILER_EVENT_TYPE_JOB: return "job";
+        case PROFILER_EVENT_TYPE_SCOPE: return "scope";
+        default: break;
+    }
+    return "undefined";
+}
+
+void Profiler::WriteTrace(std::ostream& os)
+{
+    // The GPU track goes after the thread tracks
+    const uint32_t gpuTid = PPX_MAX_THREAD_PROFILERS;
+
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool first     = true;
+    auto nextEvent = [&os, &first]() {
+        os << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    uint64_t droppedCount = 0;
+    for (uint32_t tid = 0; tid < PPX_MAX_THREAD_PROFILERS; ++tid) {
+        const Profiler& profiler = sPerThreadProfilers[tid];
+        if (profiler.mTraceEventCount == 0) {
+            continue;
+        }
+        droppedCount += profiler.mTraceDroppedCount;
+
+        nextEvent();
+        os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"args\":{\"name\":\"Thread " << tid << "\"}}";
+
+        std::unordered_map<ProfilerEventToken, const ProfilerEvent*> events;
+        for (const auto& event : profiler.mEvents) {
+            events.emplace(event.GetToken(), &event);
+        }
+
+        for (uint32_t i = 0; i < profiler.mTraceEventCount; ++i) {
+            const ProfilerTraceEvent& traceEvent = profiler.mTraceEvents[i];
+            nextEvent();
+            if (traceEvent.type == PROFILER_TRACE_EVENT_TYPE_FRAME_MARKER) {
+                os << "{\"name\":\"Frame " << traceEvent.id << "\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"p\",\"pid\":0,\"tid\":" << tid
+                   << ",\"ts\":" << TraceMicros(traceEvent.startTimestamp) << "}";
+                continue;
+            }
+
+            auto              it       = events.find(traceEvent.id);
+            const std::string name     = (it != events.end()) ? it->second->GetName() : std::string("unknown");
+            const char*       category = (it != events.end()) ? TraceCategory(it->second->GetType()) : TraceCategory(PROFILER_EVENT_TYPE_UNDEFINED);
+            const uint64_t    duration = (traceEvent.endTimestamp > traceEvent.startTimestamp) ? (traceEvent.endTimestamp - traceEvent.startTimestamp) : 0;
+            os << "{\"name\":";
+            WriteTraceString(os, name);
+            os << ",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid
+               << ",\"ts\":" << TraceMicros(traceEvent.startTimestamp) << ",\"dur\":" << Timer::TimestampToMicros(duration) << "}";
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sTraceGpuScopesMutex);
+        if (!sTraceGpuScopes.empty()) {
+            nextEvent();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << gpuTid << ",\"args\":{\"name\":\"GPU\"}}";
+        }
+        for (const auto& scope : sTraceGpuScopes) {
+            const uint64_t duration = (scope.endTimestamp > scope.startTimestamp) ? (scope.endTimestamp - scope.startTimestamp) : 0;
+            nextEvent();
+            os << "{\"name\":";
+            WriteTraceString(os, scope.name);
+            os << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << gpuTid
+               << ",\"ts\":" << TraceMicros(scope.startTimestamp) << ",\"dur\":" << Timer::TimestampToMicros(duration) << "}";
+        }
+    }
+
+    os << "\n]}\n";
+
+    if (droppedCount > 0) {
+        PPX_LOG_WARN("Profiler trace dropped " << droppedCount << " events, increase the events per thread");
     }
 }
 
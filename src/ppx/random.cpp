@@ -0,0 +1,168 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/random.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ppx {
+
+namespace {
+
+// Values generated per chunk, so vectors can be built from a buffer of
+// floats on the stack
+constexpr size_t kChunkSize = 256;
+
+// Same mapping as pcg32::nextFloat()
+float ToFloat(uint32_t value)
+{
+    const uint32_t bits = (value >> 9) | 0x3F800000u;
+    float          result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result - 1.0f;
+}
+
+// Same mapping as glm::lerp()
+float Lerp(float a, float b, float t)
+{
+    return a * (1.0f - t) + b * t;
+}
+
+// Calls fn(index, value) for count values, consecutive values come from
+// consecutive streams. The streams' state updates are independent, so the
+// loop over them runs in parallel on the CPU's execution units.
+template <uint32_t StreamCount, typename Fn>
+void GenerateInterleaved(pcg32* pStreams, size_t count, Fn fn)
+{
+    size_t i = 0;
+    for (; (i + StreamCount) <= count; i += StreamCount) {
+        uint32_t values[StreamCount];
+        for (uint32_t k = 0; k < StreamCount; ++k) {
+            values[k] = pStreams[k].nextUInt();
+        }
+        for (uint32_t k = 0; k < StreamCount; ++k) {
+            fn(i + k, values[k]);
+        }
+    }
+    for (uint32_t k = 0; i < count; ++i, ++k) {
+        fn(i, pStreams[k].nextUInt());
+    }
+}
+
+} // namespace
+
+void Random::SeedStreams(pcg32* pStreams)
+{
+    // Every stream gets its own sequence, so they never overlap
+    for (uint32_t k = 0; k < kStreamCount; ++k) {
+        const uint64_t hi    = mRng.nextUInt();
+        const uint64_t lo    = mRng.nextUInt();
+        const uint64_t state = (hi << 32) | lo;
+        pStreams[k].seed(state, k);
+    }
+}
+
+void Random::FillUInt32(uint32_t* pValues, size_t count)
+{
+    pcg32 streams[kStreamCount];
+    SeedStreams(streams);
+    GenerateInterleaved<kStreamCount>(streams, count, [pValues](size_t i, uint32_t value) { pValues[i] = value; });
+}
+
+void Random::FillFloat(float* pValues, size_t count)
+{
+    pcg32 streams[kStreamCount];
+    SeedStreams(streams);
+    GenerateInterleaved<kStreamCount>(streams, count, [pValues](size_t i, uint32_t value) { pValues[i] = ToFloat(value); });
+}
+
+void Random::FillFloat(float* pValues, size_t count, float a, float b)
+{
+    FillComponents(pValues, count, 1, &a, &b);
+}
+
+void Random::FillComponents(float* pValues, size_t count, uint32_t componentCount, const float* pA, const float* pB)
+{
+    pcg32 streams[kStreamCount];
+    SeedStreams(streams);
+    GenerateInterleaved<kStreamCount>(streams, count, [=](size_t i, uint32_t value) {
+        const uint32_t component = static_cast<uint32_t>(i % componentCount);
+        pValues[i]               = Lerp(pA[component], pB[component], ToFloat(value));
+    });
+}
+
+void Random::FillFloat2(float2* pValues, size_t count, const float2& a, const float2& b)
+{
+    static_assert(sizeof(float2) == 2 * sizeof(float), "float2 must be tightly packed");
+    FillComponents(&pValues->x, 2 * count, 2, &a.x, &b.x);
+}
+
+void Random::FillFloat3(float3* pValues, size_t count, const float3& a, const float3& b)
+{
+    static_assert(sizeof(float3) == 3 * sizeof(float), "float3 must be tightly packed");
+    FillComponents(&pValues->x, 3 * count, 3, &a.x, &b.x);
+}
+
+void Random::FillFloat4(float4* pValues, size_t count, const float4& a, const float4& b)
+{
+    static_assert(sizeof(float4) == 4 * sizeof(float), "float4 must be tightly packed");
+    FillComponents(&pValues->x, 4 * count, 4, &a.x, &b.x);
+}
+
+void Random::FillUnitVector3(float3* pValues, size_t count)
+{
+    pcg32 streams[kStreamCount];
+    SeedStreams(streams);
+
+    // z uniform in [-1, 1] and a uniform angle around z give a uniform
+    // distribution over the sphere
+    float uv[2 * kChunkSize];
+    for (size_t begin = 0; begin < count; begin += kChunkSize) {
+        const size_t chunkCount = std::min(kChunkSize, count - begin);
+        GenerateInterleaved<kStreamCount>(streams, 2 * chunkCount, [&uv](size_t i, uint32_t value) { uv[i] = ToFloat(value); });
+
+        for (size_t i = 0; i < chunkCount; ++i) {
+            const float z      = 2.0f * uv[2 * i] - 1.0f;
+            const float phi    = 2.0f * glm::pi<float>() * uv[2 * i + 1];
+            const float r      = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            pValues[begin + i] = float3(r * std::cos(phi), r * std::sin(phi), z);
+        }
+    }
+}
+
+void Random::FillPointInSphere(float3* pValues, size_t count, const float3& center, float radius)
+{
+    pcg32 streams[kStreamCount];
+    SeedStreams(streams);
+
+    // A uniform direction scaled by the cube root of a uniform value, the
+    // volume of a shell grows with the square of its radius
+    float uvw[3 * kChunkSize];
+    for (size_t begin = 0; begin < count; begin += kChunkSize) {
+        const size_t chunkCount = std::min(kChunkSize, count - begin);
+        GenerateInterleaved<kStreamCount>(streams, 3 * chunkCount, [&uvw](size_t i, uint32_t value) { uvw[i] = ToFloat(value); });
+
+        for (size_t i = 0; i < chunkCount; ++i) {
+            const float z      = 2.0f * uvw[3 * i] - 1.0f;
+            const float phi    = 2.0f * glm::pi<float>() * uvw[3 * i + 1];
+            const float r      = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            const float scale  = radius * std::cbrt(uvw[3 * i + 2]);
+            pValues[begin + i] = center + scale * float3(r * std::cos(phi), r * std::sin(phi), z);
+        }
+    }
+}
+
+} // namespace ppx
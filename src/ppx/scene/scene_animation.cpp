@@ -0,0 +1,213 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_animation.h"
+#include "ppx/scene/scene_node.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace scene {
+
+// -------------------------------------------------------------------------------------------------
+// AnimationSampler
+// -------------------------------------------------------------------------------------------------
+AnimationSampler::AnimationSampler(
+    scene::AnimationInterpolation interpolation,
+    std::vector<float>&&          times,
+    std::vector<float4>&&         values,
+    uint32_t                      valueCount)
+    : mInterpolation(interpolation),
+      mTimes(std::move(times)),
+      mValues(std::move(values)),
+      mValueCount(valueCount),
+      mVectorCount((valueCount + 3) / 4)
+{
+    const size_t vectorsPerKey = (mInterpolation == scene::ANIMATION_INTERPOLATION_CUBIC_SPLINE) ? (3 * mVectorCount) : mVectorCount;
+    PPX_ASSERT_MSG(mValues.size() == (mTimes.size() * vectorsPerKey), "animation sampler value count doesn't match its key count");
+}
+
+const float4* AnimationSampler::GetValue(uint32_t key) const
+{
+    if (mInterpolation == scene::ANIMATION_INTERPOLATION_CUBIC_SPLINE) {
+        return &mValues[(3 * key + 1) * mVectorCount];
+    }
+    return &mValues[key * mVectorCount];
+}
+
+void AnimationSampler::Sample(float time, uint32_t* pCursor, bool quaternion, float4* pValues) const
+{
+    const uint32_t keyCount = GetKeyCount();
+    if (keyCount == 0) {
+        return;
+    }
+
+    if ((keyCount == 1) || (time <= mTimes.front())) {
+        std::copy_n(GetValue(0), mVectorCount, pValues);
+        *pCursor = 0;
+        return;
+    }
+    if (time >= mTimes.back()) {
+        std::copy_n(GetValue(keyCount - 1), mVectorCount, pValues);
+        *pCursor = keyCount - 1;
+        return;
+    }
+
+    // Find key so mTimes[key] <= time < mTimes[key + 1], playback usually
+    // stays on the same key or moves to the next one
+    uint32_t key = std::min(*pCursor, keyCount - 2);
+    if ((time < mTimes[key]) || (time >= mTimes[key + 1])) {
+        if ((key + 2 < keyCount) && (time >= mTimes[key + 1]) && (time < mTimes[key + 2])) {
+            key += 1;
+        }
+        else {
+            auto it = std::upper_bound(mTimes.begin(), mTimes.end(), time);
+            key     = static_cast<uint32_t>(std::distance(mTimes.begin(), it)) - 1;
+        }
+    }
+    *pCursor = key;
+
+    const float4* pValue0 = GetValue(key);
+    const float4* pValue1 = GetValue(key + 1);
+
+    if (mInterpolation == scene::ANIMATION_INTERPOLATION_STEP) {
+        std::copy_n(pValue0, mVectorCount, pValues);
+        return;
+    }
+
+    const float dt = mTimes[key + 1] - mTimes[key];
+    const float t  = (time - mTimes[key]) / dt;
+
+    if (mInterpolation == scene::ANIMATION_INTERPOLATION_LINEAR) {
+        if (quaternion) {
+            const float sign = (glm::dot(pValue0[0], pValue1[0]) < 0) ? -1.0f : 1.0f;
+            pValues[0]       = glm::normalize(glm::mix(pValue0[0], sign * pValue1[0], t));
+            return;
+        }
+        for (uint32_t i = 0; i < mVectorCount; ++i) {
+            pValues[i] = glm::mix(pValue0[i], pValue1[i], t);
+        }
+        return;
+    }
+
+    // Cubic hermite spline, tangents are scaled by the key interval
+    const float t2  = t * t;
+    const float t3  = t2 * t;
+    const float h00 = 2 * t3 - 3 * t2 + 1;
+    const float h10 = t3 - 2 * t2 + t;
+    const float h01 = -2 * t3 + 3 * t2;
+    const float h11 = t3 - t2;
+
+    const float4* pOutTangent0 = pValue0 + mVectorCount;
+    const float4* pInTangent1  = pValue1 - mVectorCount;
+    for (uint32_t i = 0; i < mVectorCount; ++i) {
+        pValues[i] = h00 * pValue0[i] + h10 * dt * pOutTangent0[i] + h01 * pValue1[i] + h11 * dt * pInTangent1[i];
+    }
+    if (quaternion) {
+        pValues[0] = glm::normalize(pValues[0]);
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Animation
+// -------------------------------------------------------------------------------------------------
+uint32_t Animation::AddSampler(scene::AnimationSampler&& sampler)
+{
+    mDuration = std::max(mDuration, sampler.GetEndTime());
+    mSamplers.push_back(std::move(sampler));
+    return CountU32(mSamplers) - 1;
+}
+
+ppx::Result Animation::AddChannel(const Channel& channel)
+{
+    if (IsNull(channel.pTargetNode)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (channel.samplerIndex >= CountU32(mSamplers)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    if ((channel.path == scene::ANIMATION_PATH_WEIGHTS) && (channel.pTargetNode->GetNodeType() != scene::NODE_TYPE_MESH)) {
+        return ppx::ERROR_SCENE_UNSUPPORTED_NODE_TYPE;
+    }
+
+    const scene::AnimationSampler& sampler = mSamplers[channel.samplerIndex];
+    if ((channel.path != scene::ANIMATION_PATH_WEIGHTS) && (sampler.GetVectorCount() != 1)) {
+        return ppx::ERROR_UNEXPECTED_COUNT_VALUE;
+    }
+
+    mChannels.push_back(channel);
+    mCursors.push_back(0);
+    return ppx::SUCCESS;
+}
+
+void Animation::Apply(float time)
+{
+    const uint32_t channelCount = GetChannelCount();
+    for (uint32_t i = 0; i < channelCount; ++i) {
+        const Channel&                 channel = mChannels[i];
+        const scene::AnimationSampler& sampler = mSamplers[channel.samplerIndex];
+
+        mValues.resize(std::max<size_t>(mValues.size(), sampler.GetVectorCount()));
+        sampler.Sample(time, &mCursors[i], (channel.path == scene::ANIMATION_PATH_ROTATION), mValues.data());
+
+        const float4& value = mValues[0];
+        switch (channel.path) {
+            case scene::ANIMATION_PATH_TRANSLATION: {
+                channel.pTargetNode->SetTranslation(float3(value));
+            } break;
+
+            case scene::ANIMATION_PATH_ROTATION: {
+                float3 euler = float3(0);
+                glm::extractEulerAngleXYZ(glm::toMat4(glm::quat(value.w, value.x, value.y, value.z)), euler.x, euler.y, euler.z);
+                channel.pTargetNode->SetRotation(euler);
+                channel.pTargetNode->SetRotationOrder(ppx::Transform::RotationOrder::XYZ);
+            } break;
+
+            case scene::ANIMATION_PATH_SCALE: {
+                channel.pTargetNode->SetScale(float3(value));
+            } break;
+
+            case scene::ANIMATION_PATH_WEIGHTS: {
+                const float* pWeights = reinterpret_cast<const float*>(mValues.data());
+                mWeights.assign(pWeights, pWeights + sampler.GetValueCount());
+                static_cast<scene::MeshNode*>(channel.pTargetNode)->SetMorphWeights(mWeights);
+            } break;
+        }
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// Skin
+// -------------------------------------------------------------------------------------------------
+Skin::Skin(
+    std::vector<const scene::Node*>&& joints,
+    std::vector<float4x4>&&           inverseBindMatrices)
+    : mJoints(std::move(joints)),
+      mInverseBindMatrices(std::move(inverseBindMatrices))
+{
+    mInverseBindMatrices.resize(mJoints.size(), float4x4(1));
+}
+
+void Skin::CalculateJointMatrices(const float4x4& meshNodeMatrix, float4x4* pMatrices) const
+{
+    const float4x4 inverseMeshNodeMatrix = glm::inverse(meshNodeMatrix);
+
+    const uint32_t jointCount = GetJointCount();
+    for (uint32_t i = 0; i < jointCount; ++i) {
+        pMatrices[i] = inverseMeshNodeMatrix * mJoints[i]->GetEvaluatedMatrix() * mInverseBindMatrices[i];
+    }
+}
+
+} // namespace scene
+} // namespace ppx
@@ -0,0 +1,327 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_bounding_volume_hierarchy.h"
+#include "ppx/scene/scene_mesh.h"
+#include "ppx/scene/scene_node.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace ppx {
+namespace scene {
+
+// Median splits halve the items at every level, so trees stay far shallower
+static constexpr uint32_t kMaxStackDepth = 64;
+
+// Returns the distance along the ray where it enters aabb, 0 if origin is
+// inside, or false if it misses aabb or enters it past maxDistance
+static bool IntersectRay(const ppx::AABB& aabb, const float3& origin, const float3& invDirection, float maxDistance, float* pDistance)
+{
+    const float3 t0    = (aabb.GetMin() - origin) * invDirection;
+    const float3 t1    = (aabb.GetMax() - origin) * invDirection;
+    const float3 tMin  = glm::min(t0, t1);
+    const float3 tMax  = glm::max(t0, t1);
+    const float  enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+    const float  exit  = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+    if (enter > exit) {
+        return false;
+    }
+    *pDistance = enter;
+    return true;
+}
+
+static float GetDistance(const ppx::AABB& aabb, const float3& point)
+{
+    const float3 d = glm::max(glm::max(aabb.GetMin() - point, point - aabb.GetMax()), float3(0));
+    return glm::length(d);
+}
+
+void BoundingVolumeHierarchy::Build(const std::vector<scene::MeshNode*>& meshNodes)
+{
+    mMeshNodes.assign(meshNodes.begin(), meshNodes.end());
+    mItems.clear();
+    mNodes.clear();
+
+    for (const scene::MeshNode* pNode : meshNodes) {
+        const scene::Mesh* pMesh = pNode->GetMesh();
+        if (IsNull(pMesh)) {
+            continue;
+        }
+
+        Item item   = {};
+        item.pNode  = pNode;
+        item.pMesh  = pMesh;
+        item.matrix = pNode->GetEvaluatedMatrix();
+        item.bounds = pMesh->GetBoundingBox().GetTransformed(item.matrix);
+        mItems.push_back(item);
+    }
+
+    const uint32_t itemCount = GetItemCount();
+    mItemOrder.resize(itemCount);
+    std::iota(mItemOrder.begin(), mItemOrder.end(), 0);
+
+    if (itemCount > 0) {
+        // A binary tree with at least one item per leaf has fewer than
+        // 2 * itemCount nodes, so node references stay valid while building
+        mNodes.reserve(2 * itemCount);
+        mNodes.emplace_back();
+        BuildNode(0, 0, itemCount);
+    }
+
+    mDirty.assign(mNodes.size(), 0);
+    mBuildArea = GetBounds().GetSurfaceArea();
+    mRebuilt   = true;
+}
+
+void BoundingVolumeHierarchy::BuildNode(uint32_t index, uint32_t begin, uint32_t end)
+{
+    Node& node = mNodes[index];
+
+    ppx::AABB centers(mItems[mItemOrder[begin]].bounds.GetCenter());
+    node.bounds = mItems[mItemOrder[begin]].bounds;
+    for (uint32_t i = begin + 1; i < end; ++i) {
+        node.bounds.Expand(mItems[mItemOrder[i]].bounds);
+        centers.Expand(mItems[mItemOrder[i]].bounds.GetCenter());
+    }
+
+    if ((end - begin) <= kMaxLeafItems) {
+        node.first     = begin;
+        node.itemCount = end - begin;
+        for (uint32_t i = begin; i < end; ++i) {
+            mItems[mItemOrder[i]].leaf = index;
+        }
+        return;
+    }
+
+    // Split at the median center along the longest axis of the centers
+    const float3   size  = centers.GetSize();
+    const int      axis  = (size.x >= size.y) ? ((size.x >= size.z) ? 0 : 2) : ((size.y >= size.z) ? 1 : 2);
+    const uint32_t split = (begin + end) / 2;
+    std::nth_element(
+        mItemOrder.begin() + begin,
+        mItemOrder.begin() + split,
+        mItemOrder.begin() + end,
+        [this, axis](uint32_t a, uint32_t b) {
+            return mItems[a].bounds.GetCenter()[axis] < mItems[b].bounds.GetCenter()[axis];
+        });
+
+    const uint32_t first = CountU32(mNodes);
+    node.first           = first;
+    node.itemCount       = 0;
+
+    mNodes.emplace_back();
+    mNodes.emplace_back();
+    mNodes[first].parent     = index;
+    mNodes[first + 1].parent = index;
+
+    BuildNode(first, begin, split);
+    BuildNode(first + 1, split, end);
+}
+
+void BoundingVolumeHierarchy::Update(const std::vector<scene::MeshNode*>& meshNodes)
+{
+    mRebuilt = false;
+
+    if (!std::equal(meshNodes.begin(), meshNodes.end(), mMeshNodes.begin(), mMeshNodes.end())) {
+        Build(meshNodes);
+        return;
+    }
+
+    // Mesh nodes that got a mesh since the build aren't in the tree
+    const size_t meshCount = std::count_if(meshNodes.begin(), meshNodes.end(), [](const scene::MeshNode* pNode) { return !IsNull(pNode->GetMesh()); });
+    if (meshCount != mItems.size()) {
+        Build(meshNodes);
+        return;
+    }
+
+    bool refit = false;
+    for (Item& item : mItems) {
+        const scene::Mesh* pMesh  = item.pNode->GetMesh();
+        const float4x4&    matrix = item.pNode->GetEvaluatedMatrix();
+        if (IsNull(pMesh)) {
+            Build(meshNodes);
+            return;
+        }
+        if ((pMesh == item.pMesh) && (matrix == item.matrix)) {
+            continue;
+        }
+
+        item.pMesh  = pMesh;
+        item.matrix = matrix;
+        item.bounds = pMesh->GetBoundingBox().GetTransformed(matrix);
+
+        for (uint32_t i = item.leaf; (i != UINT32_MAX) && !mDirty[i]; i = mNodes[i].parent) {
+            mDirty[i] = 1;
+        }
+        refit = true;
+    }
+
+    if (!refit) {
+        return;
+    }
+
+    Refit();
+    if (GetBounds().GetSurfaceArea() > (kRebuildAreaRatio * mBuildArea)) {
+        Build(meshNodes);
+    }
+}
+
+void BoundingVolumeHierarchy::Refit()
+{
+    // Children come after their parent
+    for (uint32_t i = GetNodeCount(); i-- > 0;) {
+        if (!mDirty[i]) {
+            continue;
+        }
+        mDirty[i] = 0;
+
+        Node& node = mNodes[i];
+        if (node.itemCount > 0) {
+            node.bounds = mItems[mItemOrder[node.first]].bounds;
+            for (uint32_t j = 1; j < node.itemCount; ++j) {
+                node.bounds.Expand(mItems[mItemOrder[node.first + j]].bounds);
+            }
+        }
+        else {
+            node.bounds = mNodes[node.first].bounds;
+            node.bounds.Expand(mNodes[node.first + 1].bounds);
+        }
+    }
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const ppx::Frustum& frustum, std::vector<const scene::MeshNode*>* pNodes) const
+{
+    if (mNodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[kMaxStackDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = mNodes[stack[--stackSize]];
+        if (!frustum.Overlaps(node.bounds)) {
+            continue;
+        }
+
+        if (node.itemCount == 0) {
+            stack[stackSize++] = node.first;
+            stack[stackSize++] = node.first + 1;
+            continue;
+        }
+        for (uint32_t i = 0; i < node.itemCount; ++i) {
+            const Item& item = mItems[mItemOrder[node.first + i]];
+            if (frustum.Overlaps(item.bounds)) {
+                pNodes->push_back(item.pNode);
+            }
+        }
+    }
+}
+
+const scene::MeshNode* BoundingVolumeHierarchy::Raycast(const float3& origin, const float3& direction, float* pDistance) const
+{
+    const scene::MeshNode* pHit = nullptr;
+    if (mNodes.empty()) {
+        return pHit;
+    }
+
+    const float3 invDirection = 1.0f / direction;
+    float        hitDistance  = std::numeric_limits<float>::max();
+    float        distance     = 0;
+
+    uint32_t stack[kMaxStackDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = mNodes[stack[--stackSize]];
+        if (!IntersectRay(node.bounds, origin, invDirection, hitDistance, &distance)) {
+            continue;
+        }
+
+        if (node.itemCount == 0) {
+            // Visit the child the ray enters sooner first
+            float      distance0 = std::numeric_limits<float>::max();
+            float      distance1 = std::numeric_limits<float>::max();
+            const bool hit0      = IntersectRay(mNodes[node.first].bounds, origin, invDirection, hitDistance, &distance0);
+            const bool hit1      = IntersectRay(mNodes[node.first + 1].bounds, origin, invDirection, hitDistance, &distance1);
+            if (hit0 && hit1) {
+                const bool swap    = (distance1 < distance0);
+                stack[stackSize++] = swap ? node.first : node.first + 1;
+                stack[stackSize++] = swap ? node.first + 1 : node.first;
+            }
+            else if (hit0 || hit1) {
+                stack[stackSize++] = hit0 ? node.first : node.first + 1;
+            }
+            continue;
+        }
+        for (uint32_t i = 0; i < node.itemCount; ++i) {
+            const Item& item = mItems[mItemOrder[node.first + i]];
+            if (IntersectRay(item.bounds, origin, invDirection, hitDistance, &distance) && (distance < hitDistance)) {
+                hitDistance = distance;
+                pHit        = item.pNode;
+            }
+        }
+    }
+
+    if (!IsNull(pHit) && !IsNull(pDistance)) {
+        *pDistance = hitDistance;
+    }
+    return pHit;
+}
+
+const scene::MeshNode* BoundingVolumeHierarchy::FindNearest(const float3& point, float* pDistance) const
+{
+    const scene::MeshNode* pNearest = nullptr;
+    if (mNodes.empty()) {
+        return pNearest;
+    }
+
+    float nearestDistance = std::numeric_limits<float>::max();
+
+    uint32_t stack[kMaxStackDepth];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = 0;
+    while (stackSize > 0) {
+        const Node& node = mNodes[stack[--stackSize]];
+        if (GetDistance(node.bounds, point) >= nearestDistance) {
+            continue;
+        }
+
+        if (node.itemCount == 0) {
+            // Visit the closer child first
+            const bool swap    = GetDistance(mNodes[node.first + 1].bounds, point) < GetDistance(mNodes[node.first].bounds, point);
+            stack[stackSize++] = swap ? node.first : node.first + 1;
+            stack[stackSize++] = swap ? node.first + 1 : node.first;
+            continue;
+        }
+        for (uint32_t i = 0; i < node.itemCount; ++i) {
+            const Item& item     = mItems[mItemOrder[node.first + i]];
+            const float distance = GetDistance(item.bounds, point);
+            if (distance < nearestDistance) {
+                nearestDistance = distance;
+                pNearest        = item.pNode;
+            }
+        }
+    }
+
+    if (!IsNull(pNearest) && !IsNull(pDistance)) {
+        *pDistance = nearestDistance;
+    }
+    return pNearest;
+}
+
+} // namespace scene
+} // namespace ppx
@@ -0,0 +1,291 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_cache.h"
+#include "ppx/mipmap.h"
+
+#include <fstream>
+
+namespace ppx {
+namespace scene {
+
+namespace {
+
+// Bump when the layout of the file or of the cooked data changes
+constexpr uint32_t kSceneCacheMagic   = 0x43585050; // 'PPXC'
+constexpr uint32_t kSceneCacheVersion = 3;
+
+struct FileHeader
+{
+    uint32_t magic         = kSceneCacheMagic;
+    uint32_t version       = kSceneCacheVersion;
+    uint64_t key           = 0;
+    uint32_t meshDataCount = 0;
+    uint32_t imageCount    = 0;
+    uint64_t dataSize      = 0;
+};
+
+struct FileMeshData
+{
+    uint32_t gltfMeshIndex       = 0;
+    uint32_t vertexAttributeMask = 0;
+    uint32_t batchCount          = 0;
+    uint32_t reserved            = 0;
+    uint64_t dataOffset          = 0;
+    uint64_t dataSize            = 0;
+};
+
+struct FileImage
+{
+    uint32_t gltfImageIndex = 0;
+    uint32_t format         = 0;
+    uint32_t levelCount     = 0;
+    uint32_t reserved       = 0;
+};
+
+template <typename T>
+bool Read(fs::File& file, T* pValues, size_t count = 1)
+{
+    const size_t size = count * sizeof(T);
+    return (size == 0) || (file.Read(pValues, size) == size);
+}
+
+template <typename T>
+void Write(std::ofstream& stream, const T* pValues, size_t count = 1)
+{
+    stream.write(reinterpret_cast<const char*>(pValues), count * sizeof(T));
+}
+
+} // namespace
+
+ppx::Result SceneCache::Load(const std::filesystem::path& path, uint64_t key)
+{
+    PPX_ASSERT_MSG(mMeshData.empty() && mImages.empty() && !mFile.IsValid(), "scene cache must be empty to load");
+
+    if (!fs::path_exists(path)) {
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+    if (!mFile.Open(path)) {
+        return ppx::ERROR_SCENE_SOURCE_FILE_LOAD_FAILED;
+    }
+
+    FileHeader header = {};
+    if (!Read(mFile, &header)) {
+        return ppx::ERROR_BAD_DATA_SOURCE;
+    }
+    if ((header.magic != kSceneCacheMagic) || (header.version != kSceneCacheVersion) || (header.key != key)) {
+        return ppx::ERROR_SCENE_CACHE_MISMATCH;
+    }
+
+    std::vector<MeshData> meshData(header.meshDataCount);
+    for (auto& entry : meshData) {
+        FileMeshData fileMeshData = {};
+        if (!Read(mFile, &fileMeshData)) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+
+        entry.gltfMeshIndex       = fileMeshData.gltfMeshIndex;
+        entry.vertexAttributeMask = fileMeshData.vertexAttributeMask;
+        entry.dataOffset          = fileMeshData.dataOffset;
+        entry.dataSize            = fileMeshData.dataSize;
+        entry.batches.resize(fileMeshData.batchCount);
+        if (!Read(mFile, entry.batches.data(), entry.batches.size())) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+        if ((entry.dataOffset + entry.dataSize) > header.dataSize) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+    }
+
+    std::vector<Image> images(header.imageCount);
+    for (auto& entry : images) {
+        FileImage fileImage = {};
+        if (!Read(mFile, &fileImage)) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+
+        entry.gltfImageIndex = fileImage.gltfImageIndex;
+        entry.format         = static_cast<Bitmap::Format>(fileImage.format);
+        entry.levels.resize(fileImage.levelCount);
+        if (!Read(mFile, entry.levels.data(), entry.levels.size())) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+        for (const auto& level : entry.levels) {
+            if ((level.dataOffset + level.dataSize) > header.dataSize) {
+                return ppx::ERROR_BAD_DATA_SOURCE;
+            }
+        }
+    }
+
+    // Use the data in place if the file is mapped
+    const size_t tableSize = mFile.GetLength() - static_cast<size_t>(header.dataSize);
+    if (mFile.IsMapped()) {
+        mMappedData = static_cast<const char*>(mFile.GetMappedData()) + tableSize;
+    }
+    else {
+        mData.resize(static_cast<size_t>(header.dataSize));
+        if (!Read(mFile, mData.data(), mData.size())) {
+            return ppx::ERROR_BAD_DATA_SOURCE;
+        }
+    }
+
+    mKey      = key;
+    mMeshData = std::move(meshData);
+    mImages   = std::move(images);
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result SceneCache::Save(const std::filesystem::path& path) const
+{
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.good()) {
+        return ppx::ERROR_SCENE_CACHE_SAVE_FAILED;
+    }
+
+    FileHeader header    = {};
+    header.key           = mKey;
+    header.meshDataCount = CountU32(mMeshData);
+    header.imageCount    = CountU32(mImages);
+    header.dataSize      = static_cast<uint64_t>(mData.size());
+    Write(stream, &header);
+
+    for (const auto& entry : mMeshData) {
+        FileMeshData fileMeshData        = {};
+        fileMeshData.gltfMeshIndex       = entry.gltfMeshIndex;
+        fileMeshData.vertexAttributeMask = entry.vertexAttributeMask;
+        fileMeshData.batchCount          = CountU32(entry.batches);
+        fileMeshData.dataOffset          = entry.dataOffset;
+        fileMeshData.dataSize            = entry.dataSize;
+        Write(stream, &fileMeshData);
+        Write(stream, entry.batches.data(), entry.batches.size());
+    }
+
+    for (const auto& entry : mImages) {
+        FileImage fileImage      = {};
+        fileImage.gltfImageIndex = entry.gltfImageIndex;
+        fileImage.format         = static_cast<uint32_t>(entry.format);
+        fileImage.levelCount     = CountU32(entry.levels);
+        Write(stream, &fileImage);
+        Write(stream, entry.levels.data(), entry.levels.size());
+    }
+
+    Write(stream, mData.data(), mData.size());
+
+    stream.close();
+    if (stream.fail()) {
+        return ppx::ERROR_SCENE_CACHE_SAVE_FAILED;
+    }
+
+    return ppx::SUCCESS;
+}
+
+const SceneCache::MeshData* SceneCache::FindMeshData(uint32_t gltfMeshIndex, uint32_t vertexAttributeMask) const
+{
+    for (const auto& entry : mMeshData) {
+        if ((entry.gltfMeshIndex == gltfMeshIndex) && (entry.vertexAttributeMask == vertexAttributeMask)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const SceneCache::Image* SceneCache::FindImage(uint32_t gltfImageIndex) const
+{
+    for (const auto& entry : mImages) {
+        if (entry.gltfImageIndex == gltfImageIndex) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+const char* SceneCache::GetData(uint64_t dataOffset) const
+{
+    const char* pBase = IsNull(mMappedData) ? mData.data() : mMappedData;
+    return pBase + dataOffset;
+}
+
+ppx::Result SceneCache::GetImageLevels(const Image& image, std::vector<Bitmap>* pLevels) const
+{
+    PPX_ASSERT_NULL_ARG(pLevels);
+
+    // Created in place, copying a bitmap copies its data
+    pLevels->clear();
+    pLevels->resize(image.levels.size());
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        const ImageLevel& level = image.levels[i];
+
+        // Bitmaps only read from external storage here
+        char* pStorage = const_cast<char*>(GetData(level.dataOffset));
+
+        auto ppxres = Bitmap::Create(level.width, level.height, image.format, level.rowStride, pStorage, &(*pLevels)[i]);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+uint64_t SceneCache::AppendData(const void* pData, uint64_t dataSize)
+{
+    PPX_ASSERT_MSG(IsNull(mMappedData), "can't add to a mapped scene cache");
+
+    // Keep entries 16 byte aligned
+    const uint64_t offset = RoundUp<uint64_t>(static_cast<uint64_t>(mData.size()), 16);
+    mData.resize(static_cast<size_t>(offset + dataSize));
+    memcpy(mData.data() + offset, pData, static_cast<size_t>(dataSize));
+    return offset;
+}
+
+void SceneCache::AddMeshData(
+    uint32_t                  gltfMeshIndex,
+    uint32_t                  vertexAttributeMask,
+    const std::vector<Batch>& batches,
+    const void*               pData,
+    uint64_t                  dataSize)
+{
+    MeshData entry            = {};
+    entry.gltfMeshIndex       = gltfMeshIndex;
+    entry.vertexAttributeMask = vertexAttributeMask;
+    entry.batches             = batches;
+    entry.dataOffset          = AppendData(pData, dataSize);
+    entry.dataSize            = dataSize;
+    mMeshData.push_back(entry);
+}
+
+void SceneCache::AddImage(uint32_t gltfImageIndex, const Mipmap& mipmap)
+{
+    Image entry          = {};
+    entry.gltfImageIndex = gltfImageIndex;
+    entry.format         = mipmap.GetFormat();
+
+    for (uint32_t i = 0; i < mipmap.GetLevelCount(); ++i) {
+        const Bitmap* pMip = mipmap.GetMip(i);
+
+        ImageLevel level = {};
+        level.width      = pMip->GetWidth();
+        level.height     = pMip->GetHeight();
+        level.rowStride  = pMip->GetRowStride();
+        level.dataSize   = pMip->GetFootprintSize();
+        level.dataOffset = AppendData(pMip->GetData(), level.dataSize);
+        entry.levels.push_back(level);
+    }
+
+    mImages.push_back(entry);
+}
+
+} // namespace scene
+} // namespace ppx
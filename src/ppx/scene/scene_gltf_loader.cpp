@@ -13,12 +13,28 @@
 // limitations under the License.
 
 #include "ppx/scene/scene_gltf_loader.h"
+#include "ppx/scene/scene_texture_streamer.h"
 #include "ppx/grfx/grfx_device.h"
 #include "ppx/grfx/grfx_scope.h"
 #include "ppx/graphics_util.h"
+#include "ppx/fs.h"
+#include "ppx/ktx2.h"
+#include "ppx/mesh_optimizer.h"
+#include "ppx/meshopt_decoder.h"
+#include "ppx/mipmap.h"
+#include "ppx/profiler.h"
+#include "ppx/vertex_quantization.h"
 #include "cgltf.h"
 #include "xxhash.h"
 
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+
 #if defined(WIN32) && defined(LoadImage)
 #undef LoadImage
 #endif
@@ -26,6 +42,15 @@
 namespace ppx {
 namespace scene {
 
+// Files cgltf read for a GltfLoader, see ReadSourceFile()
+struct GltfSourceFiles
+{
+    std::unordered_map<std::string, fs::AsyncLoad>             loads;       // Buffer files that couldn't be mapped
+    std::unordered_map<std::string, std::unique_ptr<fs::File>> openFiles;   // Mapped buffer files cgltf hasn't read yet
+    std::unordered_map<const void*, std::unique_ptr<fs::File>> mappedFiles; // Mapped files cgltf references, by data
+    uint64_t                                                   mappedSize = 0;
+};
+
 namespace {
 
 #define GLTF_LOD_CLAMP_NONE 1000.0f
@@ -43,6 +68,10 @@ enum GltfTextureWrap
     GLTF_TEXTURE_WRAP_MIRRORED_REPEAT = 33648,
 };
 
+// Layers of a texture array of packed images, the least that Vulkan
+// guarantees for maxImageArrayLayers
+const uint32_t kMaxPackedImageLayers = 256;
+
 struct VertexAccessors
 {
     const cgltf_accessor* pPositions;
@@ -50,6 +79,8 @@ struct VertexAccessors
     const cgltf_accessor* pTangents;
     const cgltf_accessor* pColors;
     const cgltf_accessor* pTexCoords;
+    const cgltf_accessor* pJoints;
+    const cgltf_accessor* pWeights;
 };
 
 static std::string ToStringSafe(const char* cStr)
@@ -64,69 +95,6 @@ static std::string GetName(const GltfObjectT* pGltfObject)
     return IsNull(pGltfObject->name) ? "" : std::string(pGltfObject->name);
 }
 
-static grfx::Format GetFormat(const cgltf_accessor* pGltfAccessor)
-{
-    if (IsNull(pGltfAccessor)) {
-        return grfx::FORMAT_UNDEFINED;
-    }
-
-    // clang-format off
-    switch (pGltfAccessor->type) {
-        default: break;
-
-        case cgltf_type_scalar: {
-            switch (pGltfAccessor->component_type) {
-                default: return grfx::FORMAT_UNDEFINED;
-                case cgltf_component_type_r_8   : return grfx::FORMAT_R8_SINT;
-                case cgltf_component_type_r_8u  : return grfx::FORMAT_R8_UINT;
-                case cgltf_component_type_r_16  : return grfx::FORMAT_R16_SINT;
-                case cgltf_component_type_r_16u : return grfx::FORMAT_R16_UINT;
-                case cgltf_component_type_r_32u : return grfx::FORMAT_R32_UINT;
-                case cgltf_component_type_r_32f : return grfx::FORMAT_R32_FLOAT;
-            }
-        } break;
-
-        case cgltf_type_vec2: {
-            switch (pGltfAccessor->component_type) {
-                default: return grfx::FORMAT_UNDEFINED;
-                case cgltf_component_type_r_8   : return grfx::FORMAT_R8G8_SINT;
-                case cgltf_component_type_r_8u  : return grfx::FORMAT_R8G8_UINT;
-                case cgltf_component_type_r_16  : return grfx::FORMAT_R16G16_SINT;
-                case cgltf_component_type_r_16u : return grfx::FORMAT_R16G16_UINT;
-                case cgltf_component_type_r_32u : return grfx::FORMAT_R32G32_UINT;
-                case cgltf_component_type_r_32f : return grfx::FORMAT_R32G32_FLOAT;
-            }
-        } break;
-
-        case cgltf_type_vec3: {
-            switch (pGltfAccessor->component_type) {
-                default: return grfx::FORMAT_UNDEFINED;
-                case cgltf_component_type_r_8   : return grfx::FORMAT_R8G8B8_SINT;
-                case cgltf_component_type_r_8u  : return grfx::FORMAT_R8G8B8_UINT;
-                case cgltf_component_type_r_16  : return grfx::FORMAT_R16G16B16_SINT;
-                case cgltf_component_type_r_16u : return grfx::FORMAT_R16G16B16_UINT;
-                case cgltf_component_type_r_32u : return grfx::FORMAT_R32G32B32_UINT;
-                case cgltf_component_type_r_32f : return grfx::FORMAT_R32G32B32_FLOAT;
-            }
-        } break;
-
-        case cgltf_type_vec4: {
-            switch (pGltfAccessor->component_type) {
-                default: return grfx::FORMAT_UNDEFINED;
-                case cgltf_component_type_r_8   : return grfx::FORMAT_R8G8B8A8_SINT;
-                case cgltf_component_type_r_8u  : return grfx::FORMAT_R8G8B8A8_UINT;
-                case cgltf_component_type_r_16  : return grfx::FORMAT_R16G16B16A16_SINT;
-                case cgltf_component_type_r_16u : return grfx::FORMAT_R16G16B16A16_UINT;
-                case cgltf_component_type_r_32u : return grfx::FORMAT_R32G32B32A32_UINT;
-                case cgltf_component_type_r_32f : return grfx::FORMAT_R32G32B32A32_FLOAT;
-            }
-        } break;
-    }
-    // clang-format on
-
-    return grfx::FORMAT_UNDEFINED;
-}
-
 static scene::NodeType GetNodeType(const cgltf_node* pGltfNode)
 {
     if (IsNull(pGltfNode)) {
@@ -186,7 +154,9 @@ static uint64_t GetMeshAccessorsHash(
                 case cgltf_attribute_type_normal:
                 case cgltf_attribute_type_tangent:
                 case cgltf_attribute_type_color:
-                case cgltf_attribute_type_texcoord: {
+                case cgltf_attribute_type_texcoord:
+                case cgltf_attribute_type_joints:
+                case cgltf_attribute_type_weights: {
                     uniqueAccessorIndices.insert(accessorIndex);
                 } break;
             }
@@ -214,7 +184,7 @@ static uint64_t GetMeshAccessorsHash(
 
 static VertexAccessors GetVertexAccessors(const cgltf_primitive* pGltfPrimitive)
 {
-    VertexAccessors accessors{nullptr, nullptr, nullptr, nullptr, nullptr};
+    VertexAccessors accessors{nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
     if (IsNull(pGltfPrimitive)) {
         return accessors;
     }
@@ -233,6 +203,16 @@ static VertexAccessors GetVertexAccessors(const cgltf_primitive* pGltfPrimitive)
             case cgltf_attribute_type_texcoord : accessors.pTexCoords = pGltfAccessor; break;
         };
         // clang-format on
+
+        // Only the first set of 4 joint influences is skinned
+        if (pGltfAttr->index == 0) {
+            if (pGltfAttr->type == cgltf_attribute_type_joints) {
+                accessors.pJoints = pGltfAccessor;
+            }
+            else if (pGltfAttr->type == cgltf_attribute_type_weights) {
+                accessors.pWeights = pGltfAccessor;
+            }
+        }
     }
     return accessors;
 }
@@ -245,40 +225,24 @@ static const void* GetStartAddress(
     // NOTE: Don't assert in this function since any of the fields can be NULL for different reasons.
     //
 
-    if (IsNull(pGltfBufferView) || IsNull(pGltfBufferView->buffer) || IsNull(pGltfBufferView->buffer->data)) {
+    if (IsNull(pGltfBufferView)) {
         return nullptr;
     }
 
-    const size_t bufferViewOffset = static_cast<size_t>(pGltfBufferView->offset);
-    const char*  pBufferAddress   = static_cast<const char*>(pGltfBufferView->buffer->data);
-    const char*  pDataStart       = pBufferAddress + bufferViewOffset;
-
-    return static_cast<const void*>(pDataStart);
-}
-
-// Get an accessor's starting address
-static const void* GetStartAddress(
-    const cgltf_accessor* pGltfAccessor)
-{
-    //
-    // NOTE: Don't assert in this function since any of the fields can be NULL for different reasons.
-    //
-
-    if (IsNull(pGltfAccessor)) {
-        return nullptr;
+    // Decoded data of compressed buffer views
+    if (!IsNull(pGltfBufferView->data)) {
+        return pGltfBufferView->data;
     }
 
-    // Get buffer view's start address
-    const char* pBufferViewDataStart = static_cast<const char*>(GetStartAddress(pGltfAccessor->buffer_view));
-    if (IsNull(pBufferViewDataStart)) {
+    if (IsNull(pGltfBufferView->buffer) || IsNull(pGltfBufferView->buffer->data)) {
         return nullptr;
     }
 
-    // Calculate accesor's start address
-    const size_t accessorOffset     = static_cast<size_t>(pGltfAccessor->offset);
-    const char*  pAccessorDataStart = pBufferViewDataStart + accessorOffset;
+    const size_t bufferViewOffset = static_cast<size_t>(pGltfBufferView->offset);
+    const char*  pBufferAddress   = static_cast<const char*>(pGltfBufferView->buffer->data);
+    const char*  pDataStart       = pBufferAddress + bufferViewOffset;
 
-    return static_cast<const void*>(pAccessorDataStart);
+    return static_cast<const void*>(pDataStart);
 }
 
 const char* ToString(cgltf_component_type componentType)
@@ -359,6 +323,443 @@ ppx::Result ValidateAccessorIndexType(const cgltf_accessor* pGltfAccessor, grfx:
     return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_INDEX_TYPE;
 }
 
+// Creates a view of all of an image's mip levels and array layers. Material
+// shaders sample every image as a texture array so that packed images and
+// single images share the descriptor type.
+static ppx::Result CreateImageView(
+    grfx::Device*            pDevice,
+    grfx::Image*             pImage,
+    grfx::SampledImageView** ppImageView)
+{
+    grfx::SampledImageViewCreateInfo createInfo = {};
+    createInfo.pImage                           = pImage;
+    createInfo.imageViewType                    = grfx::IMAGE_VIEW_TYPE_2D_ARRAY;
+    createInfo.format                           = pImage->GetFormat();
+    createInfo.sampleCount                      = grfx::SAMPLE_COUNT_1;
+    createInfo.mipLevel                         = 0;
+    createInfo.mipLevelCount                    = pImage->GetMipLevelCount();
+    createInfo.arrayLayer                       = 0;
+    createInfo.arrayLayerCount                  = pImage->GetArrayLayerCount();
+    createInfo.components                       = {};
+
+    return pDevice->CreateSampledImageView(&createInfo, ppImageView);
+}
+
+static bool IsKtx2Image(const cgltf_image* pGltfImage)
+{
+    if (!IsNull(pGltfImage->mime_type) && (strcmp(pGltfImage->mime_type, "image/ktx2") == 0)) {
+        return true;
+    }
+    return !IsNull(pGltfImage->uri) && ppx::Ktx2::IsKtx2File(ToStringSafe(pGltfImage->uri));
+}
+
+// KHR_texture_basisu textures use their KTX2 image if the device can sample
+// it as stored, the texture's regular image is the fallback otherwise.
+static const cgltf_image* GetTextureImage(
+    const grfx::Device*          pDevice,
+    const std::filesystem::path& textureDirPath,
+    const cgltf_texture*         pGltfTexture)
+{
+    const cgltf_image* pKtx2Image = pGltfTexture->has_basisu ? pGltfTexture->basisu_image : nullptr;
+    if (IsNull(pKtx2Image)) {
+        return pGltfTexture->image;
+    }
+
+    grfx::Format format = grfx::FORMAT_UNDEFINED;
+    if (!IsNull(pKtx2Image->uri)) {
+        format = ppx::Ktx2::ReadFormat(textureDirPath / ToStringSafe(pKtx2Image->uri));
+    }
+    else if (!IsNull(pKtx2Image->buffer_view)) {
+        format = ppx::Ktx2::ReadFormat(static_cast<size_t>(pKtx2Image->buffer_view->size), GetStartAddress(pKtx2Image->buffer_view));
+    }
+
+    if (((format != grfx::FORMAT_UNDEFINED) && pDevice->SampledImageFormatSupported(format)) || IsNull(pGltfTexture->image)) {
+        return pKtx2Image;
+    }
+
+    PPX_LOG_INFO("GLTF: KTX2 image " << GetName(pKtx2Image) << " can't be used as stored, using fallback image " << GetName(pGltfTexture->image));
+    return pGltfTexture->image;
+}
+
+// Returns true if a material uses the image as its normal map
+static bool IsNormalMapImage(const cgltf_data* pGltfData, const cgltf_image* pGltfImage)
+{
+    for (cgltf_size i = 0; i < pGltfData->materials_count; ++i) {
+        const cgltf_texture* pGltfTexture = pGltfData->materials[i].normal_texture.texture;
+        if (!IsNull(pGltfTexture) && ((pGltfTexture->image == pGltfImage) || (pGltfTexture->basisu_image == pGltfImage))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Acceleration structures are built from float positions
+static scene::VertexQuantization GetVertexQuantization(const scene::LoadOptions& loadOptions)
+{
+    if (loadOptions.GetAccelerationStructureInput() && (loadOptions.GetVertexQuantization() != scene::VERTEX_QUANTIZATION_NONE)) {
+        PPX_LOG_WARN("Vertex quantization isn't supported for acceleration structure input, loading float vertices");
+        return scene::VERTEX_QUANTIZATION_NONE;
+    }
+    return loadOptions.GetVertexQuantization();
+}
+
+// Reads element index of a vertex attribute accessor. Integer components
+// from KHR_mesh_quantization are converted the way the accessor says,
+// normalized or not. Components the accessor doesn't have are left as is.
+static bool ReadVertexElement(const cgltf_accessor* pGltfAccessor, cgltf_size index, float* pValues, cgltf_size valueCount)
+{
+    float            values[4]      = {};
+    const cgltf_size componentCount = cgltf_num_components(pGltfAccessor->type);
+    if ((componentCount > 4) || !cgltf_accessor_read_float(pGltfAccessor, index, values, componentCount)) {
+        return false;
+    }
+    for (cgltf_size i = 0; i < std::min(componentCount, valueCount); ++i) {
+        pValues[i] = values[i];
+    }
+    return true;
+}
+
+// Writes the kVertexSkinDataSize bytes of a skinned vertex: 4 joint indices
+// followed by 4 UNORM16 weights that are normalized to sum to 1.
+static bool ReadVertexSkinData(const cgltf_accessor* pGltfJoints, const cgltf_accessor* pGltfWeights, cgltf_size index, uint16_t* pSkinData)
+{
+    cgltf_uint joints[4]  = {};
+    float      weights[4] = {};
+    if (!cgltf_accessor_read_uint(pGltfJoints, index, joints, 4) || !cgltf_accessor_read_float(pGltfWeights, index, weights, 4)) {
+        return false;
+    }
+
+    const float weightSum = weights[0] + weights[1] + weights[2] + weights[3];
+    const float scale     = (weightSum > 0) ? (1.0f / weightSum) : 0.0f;
+    for (uint32_t i = 0; i < 4; ++i) {
+        pSkinData[i]     = static_cast<uint16_t>(std::min<cgltf_uint>(joints[i], UINT16_MAX));
+        pSkinData[4 + i] = static_cast<uint16_t>(std::clamp(weights[i] * scale, 0.0f, 1.0f) * 65535.0f + 0.5f);
+    }
+    return true;
+}
+
+// Min and max are in the units cgltf_accessor_read_float() returns unless
+// the accessor is normalized, in which case the bounds are computed.
+static ppx::Result GetPositionBounds(const cgltf_accessor* pGltfPositions, ppx::AABB* pBounds)
+{
+    if (pGltfPositions->has_min && pGltfPositions->has_max && !pGltfPositions->normalized) {
+        *pBounds = ppx::AABB(
+            float3(pGltfPositions->min[0], pGltfPositions->min[1], pGltfPositions->min[2]),
+            float3(pGltfPositions->max[0], pGltfPositions->max[1], pGltfPositions->max[2]));
+        return ppx::SUCCESS;
+    }
+
+    for (cgltf_size i = 0; i < pGltfPositions->count; ++i) {
+        float3 position = float3(0);
+        if (!ReadVertexElement(pGltfPositions, i, &position.x, 3)) {
+            return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
+        }
+        if (i > 0) {
+            pBounds->Expand(position);
+        }
+        else {
+            *pBounds = ppx::AABB(position, position);
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+// Writes vertices in the VERTEX_QUANTIZATION_COMPACT layout, see
+// scene::VertexFormats. Positions are encoded with dequantization.
+static void PackCompactVertices(
+    const std::vector<TriMeshVertexData>& vertices,
+    const scene::VertexAttributeFlags&    attributes,
+    const scene::VertexDequantization&    dequantization,
+    char*                                 pPositions,
+    char*                                 pAttributes)
+{
+    // Flat meshes have a zero scale on some axis
+    const float3 scale    = dequantization.positionScale;
+    const float3 invScale = float3(
+        (scale.x > 0) ? (1.0f / scale.x) : 0.0f,
+        (scale.y > 0) ? (1.0f / scale.y) : 0.0f,
+        (scale.z > 0) ? (1.0f / scale.z) : 0.0f);
+
+    auto write = [](char*& pDst, const void* pSrc, size_t size) {
+        memcpy(pDst, pSrc, size);
+        pDst += size;
+    };
+
+    for (const auto& vertex : vertices) {
+        const float3  p           = (vertex.position - dequantization.positionOffset) * invScale;
+        const int16_t position[4] = {QuantizeSnorm16(p.x), QuantizeSnorm16(p.y), QuantizeSnorm16(p.z), 0};
+        write(pPositions, position, sizeof(position));
+
+        if (attributes.bits.texCoords) {
+            const uint16_t texCoord[2] = {QuantizeHalf(vertex.texCoord.x), QuantizeHalf(vertex.texCoord.y)};
+            write(pAttributes, texCoord, sizeof(texCoord));
+        }
+        if (attributes.bits.normals) {
+            const float2  e         = EncodeOctahedral(vertex.normal);
+            const int16_t normal[2] = {QuantizeSnorm16(e.x), QuantizeSnorm16(e.y)};
+            write(pAttributes, normal, sizeof(normal));
+        }
+        if (attributes.bits.tangents) {
+            const float2  e          = EncodeOctahedralTangent(vertex.tangent);
+            const int16_t tangent[2] = {QuantizeSnorm16(e.x), QuantizeSnorm16(e.y)};
+            write(pAttributes, tangent, sizeof(tangent));
+        }
+        if (attributes.bits.colors) {
+            const uint8_t color[4] = {QuantizeUnorm8(vertex.color.r), QuantizeUnorm8(vertex.color.g), QuantizeUnorm8(vertex.color.b), 255};
+            write(pAttributes, color, sizeof(color));
+        }
+    }
+}
+
+// Decodes an EXT_meshopt_compression buffer view into pGltfBufferView->data,
+// which cgltf reads in place of the fallback buffer and frees with the rest
+// of the GLTF data.
+// Extract euler angles using a matrix
+//
+// The values returned by glm::eulerAngles(quat) expects a
+// certain rotation order. It wasn't clear at the time of
+// this writing what that should be exactly. So, for the time
+// being, we'll use the matrix route and stick with XYZ.
+//
+static float3 QuaternionToEulerXYZ(float x, float y, float z, float w)
+{
+    auto q = glm::quat(w, x, y, z);
+    auto R = glm::toMat4(q);
+
+    float3 euler = float3(0);
+    glm::extractEulerAngleXYZ(R, euler.x, euler.y, euler.z);
+    return euler;
+}
+
+static ppx::Result DecodeMeshoptBufferView(cgltf_buffer_view* pGltfBufferView)
+{
+    const cgltf_meshopt_compression& compression = pGltfBufferView->meshopt_compression;
+    if (IsNull(compression.buffer) || IsNull(compression.buffer->data) || ((compression.offset + compression.size) > compression.buffer->size)) {
+        return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
+    }
+    const size_t decodedSize = static_cast<size_t>(compression.count * compression.stride);
+    if (decodedSize > static_cast<size_t>(pGltfBufferView->size)) {
+        return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
+    }
+
+    void* pDecoded = malloc(static_cast<size_t>(pGltfBufferView->size));
+    if (IsNull(pDecoded)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    const uint8_t* pSrc   = static_cast<const uint8_t*>(compression.buffer->data) + compression.offset;
+    const size_t   count  = static_cast<size_t>(compression.count);
+    const size_t   stride = static_cast<size_t>(compression.stride);
+    ppx::Result    ppxres = ppx::ERROR_SCENE_UNSUPPORTED_COMPRESSION;
+    switch (compression.mode) {
+        default: break;
+        case cgltf_meshopt_compression_mode_attributes: ppxres = DecodeMeshoptVertexBuffer(pDecoded, count, stride, pSrc, compression.size); break;
+        case cgltf_meshopt_compression_mode_triangles: ppxres = DecodeMeshoptIndexBuffer(pDecoded, count, stride, pSrc, compression.size); break;
+        case cgltf_meshopt_compression_mode_indices: ppxres = DecodeMeshoptIndexSequence(pDecoded, count, stride, pSrc, compression.size); break;
+    }
+
+    if (Success(ppxres)) {
+        switch (compression.filter) {
+            default: break;
+            case cgltf_meshopt_compression_filter_octahedral: ppxres = ApplyMeshoptFilter(MESHOPT_FILTER_OCTAHEDRAL, pDecoded, count, stride); break;
+            case cgltf_meshopt_compression_filter_quaternion: ppxres = ApplyMeshoptFilter(MESHOPT_FILTER_QUATERNION, pDecoded, count, stride); break;
+            case cgltf_meshopt_compression_filter_exponential: ppxres = ApplyMeshoptFilter(MESHOPT_FILTER_EXPONENTIAL, pDecoded, count, stride); break;
+        }
+    }
+
+    if (Failed(ppxres)) {
+        free(pDecoded);
+        return ppxres;
+    }
+
+    pGltfBufferView->data = pDecoded;
+    return ppx::SUCCESS;
+}
+
+// Decodes all meshopt compressed buffer views up front, on up to threadCount
+// threads. Views are independent so each thread pulls the next one until
+// there are none left.
+static ppx::Result DecodeCompressedBufferViews(cgltf_data* pGltfData, uint32_t threadCount)
+{
+    std::vector<cgltf_buffer_view*> bufferViews;
+    cgltf_size                      compressedSize = 0;
+    for (cgltf_size i = 0; i < pGltfData->buffer_views_count; ++i) {
+        cgltf_buffer_view* pGltfBufferView = &pGltfData->buffer_views[i];
+        if (pGltfBufferView->has_meshopt_compression && IsNull(pGltfBufferView->data)) {
+            bufferViews.push_back(pGltfBufferView);
+            compressedSize += pGltfBufferView->meshopt_compression.size;
+        }
+    }
+
+    if (bufferViews.empty()) {
+        return ppx::SUCCESS;
+    }
+
+    const uint32_t           viewCount = CountU32(bufferViews);
+    std::vector<ppx::Result> results(bufferViews.size(), ppx::SUCCESS);
+    std::atomic<uint32_t>    nextView  = 0;
+
+    auto decode = [&]() {
+        for (uint32_t i = nextView++; i < viewCount; i = nextView++) {
+            results[i] = DecodeMeshoptBufferView(bufferViews[i]);
+        }
+    };
+
+    const uint32_t           workerCount = std::min(std::max<uint32_t>(threadCount, 1), viewCount) - 1;
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(decode);
+    }
+    decode();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (uint32_t i = 0; i < viewCount; ++i) {
+        if (Failed(results[i])) {
+            PPX_LOG_ERROR("GLTF: failed to decode meshopt compressed buffer view " << cgltf_buffer_view_index(pGltfData, bufferViews[i]) << " (" << ppx::ToString(results[i]) << ")");
+            return results[i];
+        }
+    }
+
+    PPX_LOG_INFO("Decoded " << viewCount << " meshopt compressed GLTF buffer views (" << compressedSize << " bytes) on " << (workerCount + 1) << " threads");
+
+    return ppx::SUCCESS;
+}
+
+// KHR_draco_mesh_compression primitives can only be read through the
+// uncompressed fallback data that some files carry alongside.
+static bool HasUncompressedFallback(const cgltf_primitive* pGltfPrimitive)
+{
+    if (!IsNull(pGltfPrimitive->indices) && IsNull(pGltfPrimitive->indices->buffer_view)) {
+        return false;
+    }
+    for (cgltf_size i = 0; i < pGltfPrimitive->attributes_count; ++i) {
+        if (IsNull(pGltfPrimitive->attributes[i].data->buffer_view)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// GLTF path of a buffer's uri the way cgltf_load_buffers() builds it: the
+// GLTF file's directory followed by the decoded uri.
+static std::string GetBufferFilePath(const std::string& directory, const char* uri)
+{
+    std::string path = directory + uri;
+    path.resize(directory.size() + cgltf_decode_uri(path.data() + directory.size()));
+    return path;
+}
+
+// Maps the buffer files of a GLTF file so cgltf_load_buffers() references
+// them in place. Files that can't be mapped load concurrently instead while
+// cgltf_load_buffers() asks for them one after the other.
+static void OpenBufferFiles(const cgltf_data* pGltfData, const std::filesystem::path& filePath, GltfSourceFiles* pFiles)
+{
+    const std::string gltfPath  = filePath.string();
+    const size_t      separator = gltfPath.find_last_of("/\\");
+    const std::string directory = (separator == std::string::npos) ? std::string() : gltfPath.substr(0, separator + 1);
+
+    for (cgltf_size i = 0; i < pGltfData->buffers_count; ++i) {
+        const cgltf_buffer* pGltfBuffer = &pGltfData->buffers[i];
+        // GLB and data uri buffers aren't files
+        if (IsNull(pGltfBuffer->uri) || !IsNull(pGltfBuffer->data) || (strncmp(pGltfBuffer->uri, "data:", 5) == 0)) {
+            continue;
+        }
+
+        const std::string path = GetBufferFilePath(directory, pGltfBuffer->uri);
+        if ((pFiles->openFiles.find(path) != pFiles->openFiles.end()) || (pFiles->loads.find(path) != pFiles->loads.end())) {
+            continue;
+        }
+
+        auto file = std::make_unique<fs::File>();
+        if (file->OpenMapped(path) && file->IsMapped()) {
+            pFiles->openFiles.emplace(path, std::move(file));
+        }
+        else {
+            pFiles->loads.emplace(path, fs::load_file_async(path));
+        }
+    }
+}
+
+// cgltf file read callback, returns the mapped data of files that can be
+// mapped and a copy of the others
+static cgltf_result ReadSourceFile(
+    const cgltf_memory_options* pMemoryOptions,
+    const cgltf_file_options*   pFileOptions,
+    const char*                 path,
+    cgltf_size*                 pSize,
+    void**                      ppData)
+{
+    GltfSourceFiles* pFiles = static_cast<GltfSourceFiles*>(pFileOptions->user_data);
+
+    // Mapped by OpenBufferFiles() or mapped now, e.g. the GLTF file itself
+    std::unique_ptr<fs::File> file;
+    if (auto it = pFiles->openFiles.find(path); it != pFiles->openFiles.end()) {
+        file = std::move(it->second);
+        pFiles->openFiles.erase(it);
+    }
+    else if (pFiles->loads.find(path) == pFiles->loads.end()) {
+        file = std::make_unique<fs::File>();
+        if (!(file->OpenMapped(path) && file->IsMapped())) {
+            file.reset();
+        }
+    }
+    if (file) {
+        if ((*pSize > 0) && (file->GetLength() < *pSize)) {
+            return cgltf_result_data_too_short;
+        }
+
+        // cgltf only reads the data, ReleaseSourceFile() unmaps it
+        void* pData = const_cast<void*>(file->GetMappedData());
+        *pSize      = static_cast<cgltf_size>(file->GetLength());
+        *ppData     = pData;
+        pFiles->mappedSize += file->GetLength();
+        pFiles->mappedFiles.emplace(pData, std::move(file));
+        return cgltf_result_success;
+    }
+
+    auto                             it   = pFiles->loads.find(path);
+    std::optional<std::vector<char>> data = ((it != pFiles->loads.end()) && it->second.IsValid()) ? it->second.Wait() : fs::load_file(path);
+    if (!data.has_value()) {
+        return cgltf_result_file_not_found;
+    }
+    if ((*pSize > 0) && (data->size() < *pSize)) {
+        return cgltf_result_data_too_short;
+    }
+
+    // ReleaseSourceFile() releases the data with the memory options' free function
+    void* pData = IsNull(pMemoryOptions->alloc_func) ? malloc(data->size()) : pMemoryOptions->alloc_func(pMemoryOptions->user_data, data->size());
+    if (IsNull(pData)) {
+        return cgltf_result_out_of_memory;
+    }
+    memcpy(pData, data->data(), data->size());
+
+    *pSize  = static_cast<cgltf_size>(data->size());
+    *ppData = pData;
+    return cgltf_result_success;
+}
+
+// cgltf file release callback, called by cgltf_free() for the data
+// ReadSourceFile() returned
+static void ReleaseSourceFile(
+    const cgltf_memory_options* pMemoryOptions,
+    const cgltf_file_options*   pFileOptions,
+    void*                       pData)
+{
+    GltfSourceFiles* pFiles = static_cast<GltfSourceFiles*>(pFileOptions->user_data);
+    if (pFiles->mappedFiles.erase(pData) > 0) {
+        return;
+    }
+
+    if (IsNull(pMemoryOptions->free_func)) {
+        free(pData);
+    }
+    else {
+        pMemoryOptions->free_func(pMemoryOptions->user_data, pData);
+    }
+}
+
 } // namespace
 
 // -------------------------------------------------------------------------------------------------
@@ -408,6 +809,13 @@ GltfLoader::GltfLoader(
 
 GltfLoader::~GltfLoader()
 {
+    // Decode threads read the GLTF data
+    mStopPendingImageDecode = true;
+    for (auto& thread : mPendingImageThreads) {
+        thread.join();
+    }
+    mPendingImageThreads.clear();
+
     if (HasGltfData() && mOwnsGltfData) {
         cgltf_free(mGltfData);
         mGltfData = nullptr;
@@ -435,9 +843,17 @@ ppx::Result GltfLoader::Create(
         return ppx::ERROR_PATH_DOES_NOT_EXIST;
     }
 
+    // Files are mapped and released through sourceFiles, so the GLB chunk and
+    // buffer files are used in place instead of being read into memory. It
+    // must outlive the GLTF data, the loader takes it over.
+    auto sourceFiles = std::make_unique<GltfSourceFiles>();
+
     // Parse gltf data
-    cgltf_options cgltfOptions = {};
-    cgltf_data*   pGltfData    = nullptr;
+    cgltf_options cgltfOptions  = {};
+    cgltfOptions.file.read      = ReadSourceFile;
+    cgltfOptions.file.release   = ReleaseSourceFile;
+    cgltfOptions.file.user_data = sourceFiles.get();
+    cgltf_data* pGltfData       = nullptr;
 
     cgltf_result cgres = cgltf_parse_file(
         &cgltfOptions,
@@ -447,8 +863,10 @@ ppx::Result GltfLoader::Create(
         return ppx::ERROR_SCENE_SOURCE_FILE_LOAD_FAILED;
     }
 
-    // Load GLTF buffers
+    // Load GLTF buffers, buffer files are mapped or load concurrently
     {
+        OpenBufferFiles(pGltfData, filePath, sourceFiles.get());
+
         cgltf_result res = cgltf_load_buffers(
             &cgltfOptions,
             pGltfData,
@@ -460,6 +878,15 @@ ppx::Result GltfLoader::Create(
         }
     }
 
+    // Decode compressed buffer views, accessors read the decoded data
+    {
+        const uint32_t threadCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+        if (ppx::Result ppxres = DecodeCompressedBufferViews(pGltfData, threadCount); Failed(ppxres)) {
+            cgltf_free(pGltfData);
+            return ppxres;
+        }
+    }
+
     // Loading from file means we own the GLTF data
     const bool ownsGltfData = true;
 
@@ -485,10 +912,11 @@ ppx::Result GltfLoader::Create(
         cgltf_free(pGltfData);
         return ppx::ERROR_ALLOCATION_FAILED;
     }
+    pLoader->mSourceFiles = std::move(sourceFiles);
 
     *ppLoader = pLoader;
 
-    PPX_LOG_INFO("Successfully opened GLTF file: " << filePath);
+    PPX_LOG_INFO("Successfully opened GLTF file: " << filePath << " (" << (pLoader->mSourceFiles->mappedSize >> 20) << " MB mapped)");
 
     return ppx::SUCCESS;
 }
@@ -541,16 +969,129 @@ void GltfLoader::CalculateMeshMaterialVertexAttributeMasks(
     }
 }
 
+uint64_t GltfLoader::CalculateSceneCacheKey(
+    grfx::Device*                   pDevice,
+    uint32_t                        sceneIndex,
+    const ppx::MeshOptimizeOptions& meshOptimizeOptions,
+    const ppx::MeshLodOptions&      meshLodOptions,
+    scene::VertexQuantization       vertexQuantization) const
+{
+    // The GLTF file is hashed in place, a GLB holds all of its buffers
+    fs::File          file;
+    std::vector<char> fileData;
+    const void*       pFileData = nullptr;
+    size_t            fileSize  = 0;
+    if (file.OpenMapped(mGltfFilePath) && file.IsMapped()) {
+        pFileData = file.GetMappedData();
+        fileSize  = file.GetLength();
+    }
+    else {
+        fileData  = fs::load_file(mGltfFilePath).value_or(std::vector<char>());
+        pFileData = fileData.data();
+        fileSize  = fileData.size();
+    }
+
+    std::vector<char> data;
+    auto append = [&data](const void* pValue, size_t size) {
+        const char* pBytes = static_cast<const char*>(pValue);
+        data.insert(data.end(), pBytes, pBytes + size);
+    };
+
+    // External files are covered by their size and write time, hashing
+    // their contents would cost about as much as loading them.
+    auto appendFile = [&append](const std::filesystem::path& dir, const char* uri) {
+        const std::string uriString = ToStringSafe(uri);
+        if (uriString.empty() || (uriString.rfind("data:", 0) == 0)) {
+            return;
+        }
+
+        std::error_code ec;
+        const auto      path      = dir / uriString;
+        const uint64_t  size      = static_cast<uint64_t>(std::filesystem::file_size(path, ec));
+        const int64_t   writeTime = static_cast<int64_t>(std::filesystem::last_write_time(path, ec).time_since_epoch().count());
+        append(&size, sizeof(size));
+        append(&writeTime, sizeof(writeTime));
+    };
+
+    for (cgltf_size i = 0; i < mGltfData->buffers_count; ++i) {
+        appendFile(mGltfFilePath.parent_path(), mGltfData->buffers[i].uri);
+    }
+    for (cgltf_size i = 0; i < mGltfData->images_count; ++i) {
+        appendFile(mGltfTextureDir, mGltfData->images[i].uri);
+    }
+
+    // UINT8 indices are repacked if the device doesn't support them
+    const uint32_t indexTypeUint8 = pDevice->IndexTypeUint8Supported() ? 1 : 0;
+    append(&indexTypeUint8, sizeof(indexTypeUint8));
+    append(&sceneIndex, sizeof(sceneIndex));
+
+    // Mesh data is cooked after reordering
+    const uint32_t optimizeFlags = (meshOptimizeOptions.vertexCache ? 1 : 0) | (meshOptimizeOptions.overdraw ? 2 : 0) | (meshOptimizeOptions.vertexFetch ? 4 : 0);
+    append(&optimizeFlags, sizeof(optimizeFlags));
+    append(&meshOptimizeOptions.overdrawThreshold, sizeof(meshOptimizeOptions.overdrawThreshold));
+    append(&vertexQuantization, sizeof(vertexQuantization));
+
+    // LODs are cooked into the index data
+    append(&meshLodOptions.lodCount, sizeof(meshLodOptions.lodCount));
+    append(&meshLodOptions.reduction, sizeof(meshLodOptions.reduction));
+    append(&meshLodOptions.maxError, sizeof(meshLodOptions.maxError));
+
+    const XXH64_hash_t kSeed = 0x5874bc9de50a7627;
+    return XXH64(data.data(), data.size(), XXH64(pFileData, fileSize, kSeed));
+}
+
 uint64_t GltfLoader::CalculateImageObjectId(const GltfLoader::InternalLoadParams& loadParams, uint32_t objectIndex)
 {
-    uint64_t objectId = objectIndex + loadParams.baseObjectIds.image;
-    return objectId;
+    if (!loadParams.contentObjectIds) {
+        uint64_t objectId = objectIndex + loadParams.baseObjectIds.image;
+        return objectId;
+    }
+
+    // Hashing reads the image once more, keep it for later fetches
+    if (mImageContentHashes.size() != mGltfData->images_count) {
+        mImageContentHashes.assign(mGltfData->images_count, 0);
+    }
+
+    uint64_t& hash = mImageContentHashes[objectIndex];
+    if (hash == 0) {
+        const XXH64_hash_t kSeed      = 0x2d358dccaa6c78a5;
+        const cgltf_image* pGltfImage = &mGltfData->images[objectIndex];
+        if (!IsNull(pGltfImage->uri)) {
+            auto data = fs::load_file(mGltfTextureDir / ToStringSafe(pGltfImage->uri));
+            if (data.has_value()) {
+                hash = XXH64(data->data(), data->size(), kSeed);
+            }
+        }
+        else if (!IsNull(pGltfImage->buffer_view) && !IsNull(GetStartAddress(pGltfImage->buffer_view))) {
+            hash = XXH64(GetStartAddress(pGltfImage->buffer_view), static_cast<size_t>(pGltfImage->buffer_view->size), kSeed);
+        }
+
+        // Images that can't be read aren't shared
+        if (hash == 0) {
+            hash = XXH64(&objectIndex, sizeof(objectIndex), loadParams.baseObjectIds.texture + kSeed);
+        }
+    }
+
+    return hash;
 }
 
 uint64_t GltfLoader::CalculateSamplerObjectId(const GltfLoader::InternalLoadParams& loadParams, uint32_t objectIndex)
 {
-    uint64_t objectId = objectIndex + loadParams.baseObjectIds.sampler;
-    return objectId;
+    if (!loadParams.contentObjectIds) {
+        uint64_t objectId = objectIndex + loadParams.baseObjectIds.sampler;
+        return objectId;
+    }
+
+    // Only the parameters LoadSamplerInternal() uses
+    const cgltf_sampler* pGltfSampler = &mGltfData->samplers[objectIndex];
+    const int32_t        params[3]    = {
+        static_cast<int32_t>(pGltfSampler->mag_filter),
+        static_cast<int32_t>(pGltfSampler->wrap_s),
+        static_cast<int32_t>(pGltfSampler->wrap_t),
+    };
+
+    const XXH64_hash_t kSeed = 0x6c1b3e8f0a4d9527;
+    return XXH64(params, sizeof(params), kSeed);
 }
 
 uint64_t GltfLoader::CalculateTextureObjectId(const GltfLoader::InternalLoadParams& loadParams, uint32_t objectIndex)
@@ -676,11 +1217,33 @@ ppx::Result GltfLoader::FetchSamplerInternal(
     return ppx::SUCCESS;
 }
 
+bool GltfLoader::IsBitmapImage(const cgltf_image* pGltfImage) const
+{
+    if (!IsNull(pGltfImage->uri)) {
+        std::filesystem::path filePath = mGltfTextureDir / ToStringSafe(pGltfImage->uri);
+        return std::filesystem::exists(filePath) && ppx::Bitmap::IsBitmapFile(filePath);
+    }
+    return !IsNull(pGltfImage->buffer_view) && !IsNull(GetStartAddress(pGltfImage->buffer_view)) && !IsKtx2Image(pGltfImage);
+}
+
+ppx::Result GltfLoader::DecodeImage(const cgltf_image* pGltfImage, ppx::Bitmap* pBitmap) const
+{
+    if (!IsNull(pGltfImage->uri)) {
+        return ppx::Bitmap::LoadFile(mGltfTextureDir / ToStringSafe(pGltfImage->uri), pBitmap);
+    }
+    return ppx::Bitmap::LoadFromMemory(
+        static_cast<size_t>(pGltfImage->buffer_view->size),
+        GetStartAddress(pGltfImage->buffer_view),
+        pBitmap);
+}
+
 ppx::Result GltfLoader::LoadImageInternal(
     const GltfLoader::InternalLoadParams& loadParams,
     const cgltf_image*                    pGltfImage,
     scene::Image**                        ppTargetImage)
 {
+    PPX_PROFILE_SCOPE("GltfLoader::LoadImage");
+
     if (IsNull(loadParams.pDevice) || IsNull(pGltfImage) || IsNull(ppTargetImage)) {
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
     }
@@ -692,10 +1255,107 @@ ppx::Result GltfLoader::LoadImageInternal(
     const uint32_t gltfObjectIndex = static_cast<uint32_t>(cgltf_image_index(mGltfData, pGltfImage));
     PPX_LOG_INFO("Loading GLTF image[" << gltfObjectIndex << "]: " << gltfObjectName);
 
+    // Use the bitmap if it was decoded ahead of time
+    ppx::Bitmap* pDecodedBitmap = nullptr;
+    if (!IsNull(loadParams.pDecodedImages) && (gltfObjectIndex < loadParams.pDecodedImages->size())) {
+        pDecodedBitmap = (*loadParams.pDecodedImages)[gltfObjectIndex].get();
+    }
+
+    // Placeholders are only used for cached images that the decode threads
+    // can load, FetchImageInternal() queues them.
+    const bool placeholder = loadParams.placeholderImages && !IsNull(loadParams.pResourceManager) && IsBitmapImage(pGltfImage);
+
+    // Cooked mip chain
+    const scene::SceneCache::Image* pCachedImage = nullptr;
+    if (!IsNull(loadParams.pSceneCache) && !loadParams.writeSceneCache) {
+        pCachedImage = loadParams.pSceneCache->FindImage(gltfObjectIndex);
+    }
+
     // Load image
     grfx::Image* pGrfxImage = nullptr;
     //
-    if (!IsNull(pGltfImage->uri)) {
+    if (!IsNull(pCachedImage)) {
+        std::vector<ppx::Bitmap> mips;
+        auto                     ppxres = loadParams.pSceneCache->GetImageLevels(*pCachedImage, &mips);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = grfx_util::CreateImageFromMipLevels(
+            loadParams.pDevice->GetGraphicsQueue(),
+            CountU32(mips),
+            mips.data(),
+            &pGrfxImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    else if (loadParams.writeSceneCache && IsBitmapImage(pGltfImage)) {
+        ppx::Bitmap bitmap;
+        if (IsNull(pDecodedBitmap)) {
+            auto ppxres = DecodeImage(pGltfImage, &bitmap);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+            pDecodedBitmap = &bitmap;
+        }
+
+        // Cook the full mip chain, it's what CreateImageFromBitmap() builds
+        Mipmap mipmap = Mipmap(*pDecodedBitmap, Mipmap::CalculateLevelCount(pDecodedBitmap->GetWidth(), pDecodedBitmap->GetHeight()));
+        if (!mipmap.IsOk()) {
+            return ppx::ERROR_FAILED;
+        }
+        loadParams.pSceneCache->AddImage(gltfObjectIndex, mipmap);
+
+        auto ppxres = grfx_util::CreateImageFromMipLevels(
+            loadParams.pDevice->GetGraphicsQueue(),
+            mipmap.GetLevelCount(),
+            mipmap.GetMip(0),
+            &pGrfxImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        if (!IsNull(loadParams.pDecodedImages) && (gltfObjectIndex < loadParams.pDecodedImages->size())) {
+            (*loadParams.pDecodedImages)[gltfObjectIndex].reset();
+        }
+    }
+    else if (placeholder) {
+        ppx::Bitmap bitmap;
+        auto        ppxres = ppx::Bitmap::Create(1, 1, ppx::Bitmap::FORMAT_RGBA_UINT8, &bitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Flat normal for normal maps, white for everything else
+        if (IsNormalMapImage(mGltfData, pGltfImage)) {
+            bitmap.Fill<uint8_t>(128, 128, 255, 255);
+        }
+        else {
+            bitmap.Fill<uint8_t>(255, 255, 255, 255);
+        }
+
+        ppxres = grfx_util::CreateImageFromBitmap(
+            loadParams.pDevice->GetGraphicsQueue(),
+            &bitmap,
+            &pGrfxImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    else if (!IsNull(pDecodedBitmap)) {
+        auto ppxres = grfx_util::CreateImageFromBitmap(
+            loadParams.pDevice->GetGraphicsQueue(),
+            pDecodedBitmap,
+            &pGrfxImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Uploaded, the bitmap isn't needed anymore
+        (*loadParams.pDecodedImages)[gltfObjectIndex].reset();
+    }
+    else if (!IsNull(pGltfImage->uri)) {
         std::filesystem::path filePath = mGltfTextureDir / ToStringSafe(pGltfImage->uri);
         if (!std::filesystem::exists(filePath)) {
             PPX_LOG_ERROR("GLTF file references an image file that doesn't exist (image=" << ToStringSafe(pGltfImage->name) << ", uri=" << ToStringSafe(pGltfImage->uri) << ", file=" << filePath);
@@ -717,18 +1377,35 @@ ppx::Result GltfLoader::LoadImageInternal(
             return ppx::ERROR_BAD_DATA_SOURCE;
         }
 
-        ppx::Bitmap bitmap;
-        auto        ppxres = ppx::Bitmap::LoadFromMemory(dataSize, pData, &bitmap);
-        if (Failed(ppxres)) {
-            return ppxres;
+        if (IsKtx2Image(pGltfImage)) {
+            ppx::Ktx2 ktx2;
+            auto      ppxres = ppx::Ktx2::LoadFromMemory(dataSize, pData, &ktx2);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+
+            ppxres = grfx_util::CreateImageFromKtx2(
+                loadParams.pDevice->GetGraphicsQueue(),
+                ktx2,
+                &pGrfxImage);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
         }
+        else {
+            ppx::Bitmap bitmap;
+            auto        ppxres = ppx::Bitmap::LoadFromMemory(dataSize, pData, &bitmap);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
 
-        ppxres = grfx_util::CreateImageFromBitmap(
-            loadParams.pDevice->GetGraphicsQueue(),
-            &bitmap,
-            &pGrfxImage);
-        if (Failed(ppxres)) {
-            return ppxres;
+            ppxres = grfx_util::CreateImageFromBitmap(
+                loadParams.pDevice->GetGraphicsQueue(),
+                &bitmap,
+                &pGrfxImage);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
         }
     }
     else {
@@ -739,20 +1416,7 @@ ppx::Result GltfLoader::LoadImageInternal(
     grfx::SampledImageView* pGrfxImageView = nullptr;
     //
     {
-        grfx::SampledImageViewCreateInfo createInfo = {};
-        createInfo.pImage                           = pGrfxImage;
-        createInfo.imageViewType                    = grfx::IMAGE_VIEW_TYPE_2D;
-        createInfo.format                           = pGrfxImage->GetFormat();
-        createInfo.sampleCount                      = grfx::SAMPLE_COUNT_1;
-        createInfo.mipLevel                         = 0;
-        createInfo.mipLevelCount                    = pGrfxImage->GetMipLevelCount();
-        createInfo.arrayLayer                       = 0;
-        createInfo.arrayLayerCount                  = pGrfxImage->GetArrayLayerCount();
-        createInfo.components                       = {};
-
-        auto ppxres = loadParams.pDevice->CreateSampledImageView(
-            &createInfo,
-            &pGrfxImageView);
+        auto ppxres = CreateImageView(loadParams.pDevice, pGrfxImage, &pGrfxImageView);
         if (ppxres) {
             loadParams.pDevice->DestroyImage(pGrfxImage);
             return ppxres;
@@ -760,7 +1424,7 @@ ppx::Result GltfLoader::LoadImageInternal(
     }
 
     // Creat target object
-    auto pImage = new scene::Image(pGrfxImage, pGrfxImageView);
+    auto pImage = new scene::Image(pGrfxImage, pGrfxImageView, placeholder);
     if (IsNull(pImage)) {
         loadParams.pDevice->DestroySampledImageView(pGrfxImageView);
         loadParams.pDevice->DestroyImage(pGrfxImage);
@@ -776,6 +1440,235 @@ ppx::Result GltfLoader::LoadImageInternal(
     return ppx::SUCCESS;
 }
 
+void GltfLoader::DecodeImagesInternal(
+    const GltfLoader::InternalLoadParams& loadParams,
+    uint32_t                              threadCount,
+    GltfLoader::DecodedImages&            outDecodedImages)
+{
+    outDecodedImages.clear();
+    outDecodedImages.resize(static_cast<size_t>(mGltfData->images_count));
+
+    // DDS files and anything else that isn't a bitmap is loaded as before
+    std::vector<uint32_t> imageIndices;
+    for (cgltf_size i = 0; i < mGltfData->images_count; ++i) {
+        if (IsBitmapImage(&mGltfData->images[i])) {
+            imageIndices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    if (imageIndices.empty()) {
+        return;
+    }
+
+    const uint32_t imageCount = CountU32(imageIndices);
+    if (!IsNull(loadParams.pProgress)) {
+        loadParams.pProgress->imageCount = imageCount;
+    }
+
+    std::atomic<uint32_t> nextImage    = 0;
+    std::atomic<uint32_t> decodedCount = 0;
+
+    // Each thread pulls the next image until there are none left. Threads
+    // write to different elements of outDecodedImages.
+    auto decode = [&](bool reportProgress) {
+        for (uint32_t i = nextImage++; i < imageCount; i = nextImage++) {
+            const uint32_t gltfImageIndex = imageIndices[i];
+
+            auto bitmap = std::make_unique<ppx::Bitmap>();
+            if (DecodeImage(&mGltfData->images[gltfImageIndex], bitmap.get()) == ppx::SUCCESS) {
+                outDecodedImages[gltfImageIndex] = std::move(bitmap);
+            }
+
+            uint32_t count = ++decodedCount;
+            if (reportProgress && !IsNull(loadParams.pProgress) && loadParams.progressCallback) {
+                loadParams.pProgress->imagesDecoded = count;
+                loadParams.progressCallback(*loadParams.pProgress);
+            }
+        }
+    };
+
+    // The calling thread decodes too, it's the only one that reports progress
+    const uint32_t           workerCount = std::min(threadCount, imageCount) - 1;
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(decode, false);
+    }
+    decode(true);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (!IsNull(loadParams.pProgress)) {
+        loadParams.pProgress->imagesDecoded = imageCount;
+        if (loadParams.progressCallback) {
+            loadParams.progressCallback(*loadParams.pProgress);
+        }
+    }
+
+    PPX_LOG_INFO("Decoded " << imageCount << " GLTF images on " << (workerCount + 1) << " threads");
+}
+
+ppx::Result GltfLoader::PackImagesInternal(
+    const GltfLoader::InternalLoadParams& loadParams,
+    uint32_t                              maxImageSize)
+{
+    PPX_PROFILE_SCOPE("GltfLoader::PackImages");
+
+    if (IsNull(loadParams.pDevice) || IsNull(loadParams.pResourceManager) || IsNull(loadParams.pDecodedImages)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    GltfLoader::DecodedImages& decodedImages = *loadParams.pDecodedImages;
+
+    // Group small images by size and format. Images that are already
+    // cached, or that have the same content as an earlier image, are
+    // fetched as before.
+    using PackKey = std::tuple<uint32_t, uint32_t, ppx::Bitmap::Format>;
+
+    std::map<PackKey, std::vector<uint32_t>> groups;
+    std::unordered_set<uint64_t>             objectIds;
+    std::vector<uint64_t>                    imageObjectIds(decodedImages.size());
+    for (uint32_t gltfImageIndex = 0; gltfImageIndex < CountU32(decodedImages); ++gltfImageIndex) {
+        const ppx::Bitmap* pBitmap = decodedImages[gltfImageIndex].get();
+        if (IsNull(pBitmap) || (pBitmap->GetWidth() > maxImageSize) || (pBitmap->GetHeight() > maxImageSize)) {
+            continue;
+        }
+
+        const uint64_t objectId        = CalculateImageObjectId(loadParams, gltfImageIndex);
+        imageObjectIds[gltfImageIndex] = objectId;
+
+        scene::ImageRef cachedImage;
+        if (loadParams.pResourceManager->Find(objectId, cachedImage) || !objectIds.insert(objectId).second) {
+            continue;
+        }
+
+        groups[PackKey(pBitmap->GetWidth(), pBitmap->GetHeight(), pBitmap->GetFormat())].push_back(gltfImageIndex);
+    }
+
+    uint32_t packedCount = 0;
+    uint32_t arrayCount  = 0;
+    for (const auto& it : groups) {
+        const std::vector<uint32_t>& imageIndices = it.second;
+
+        for (size_t first = 0; first < imageIndices.size(); first += kMaxPackedImageLayers) {
+            const uint32_t layerCount = static_cast<uint32_t>(std::min<size_t>(kMaxPackedImageLayers, imageIndices.size() - first));
+
+            // An array of one image doesn't save a descriptor
+            if (layerCount < 2) {
+                continue;
+            }
+
+            // Full mip chain, it's what CreateImageFromBitmap() builds
+            std::vector<std::unique_ptr<ppx::Mipmap>> mipmaps;
+            std::vector<const ppx::Mipmap*>           layers;
+            for (uint32_t layer = 0; layer < layerCount; ++layer) {
+                const ppx::Bitmap& bitmap = *decodedImages[imageIndices[first + layer]];
+
+                auto mipmap = std::make_unique<ppx::Mipmap>(bitmap, Mipmap::CalculateLevelCount(bitmap.GetWidth(), bitmap.GetHeight()));
+                if (!mipmap->IsOk()) {
+                    return ppx::ERROR_FAILED;
+                }
+                layers.push_back(mipmap.get());
+                mipmaps.push_back(std::move(mipmap));
+            }
+
+            grfx::Image* pGrfxImage = nullptr;
+            //
+            auto ppxres = grfx_util::CreateImageArrayFromMipmaps(
+                loadParams.pDevice->GetGraphicsQueue(),
+                layers,
+                &pGrfxImage);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+
+            grfx::SampledImageView* pGrfxImageView = nullptr;
+            ppxres                                 = CreateImageView(loadParams.pDevice, pGrfxImage, &pGrfxImageView);
+            if (Failed(ppxres)) {
+                loadParams.pDevice->DestroyImage(pGrfxImage);
+                return ppxres;
+            }
+
+            // The array isn't cached, the packed images keep it alive
+            scene::ImageRef arrayImage = scene::MakeRef(new scene::Image(pGrfxImage, pGrfxImageView));
+            if (!arrayImage) {
+                loadParams.pDevice->DestroySampledImageView(pGrfxImageView);
+                loadParams.pDevice->DestroyImage(pGrfxImage);
+                return ppx::ERROR_ALLOCATION_FAILED;
+            }
+            arrayImage->SetName("packed images " + std::to_string(arrayCount));
+
+            for (uint32_t layer = 0; layer < layerCount; ++layer) {
+                const uint32_t     gltfImageIndex = imageIndices[first + layer];
+                const cgltf_image* pGltfImage     = &mGltfData->images[gltfImageIndex];
+
+                scene::ImageRef image = scene::MakeRef(new scene::Image(arrayImage, layer));
+                if (!image) {
+                    return ppx::ERROR_ALLOCATION_FAILED;
+                }
+                image->SetName(GetName(pGltfImage));
+
+                loadParams.pResourceManager->Cache(imageObjectIds[gltfImageIndex], image);
+
+                // Uploaded, the bitmap isn't needed anymore
+                decodedImages[gltfImageIndex].reset();
+            }
+
+            packedCount += layerCount;
+            ++arrayCount;
+        }
+    }
+
+    PPX_LOG_INFO("Packed " << packedCount << " GLTF images into " << arrayCount << " texture arrays");
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GltfLoader::LoadStreamedImageInternal(
+    const GltfLoader::InternalLoadParams& loadParams,
+    const cgltf_image*                    pGltfImage,
+    scene::ImageRef&                      outImage)
+{
+    PPX_PROFILE_SCOPE("GltfLoader::LoadStreamedImage");
+
+    const uint32_t gltfObjectIndex = static_cast<uint32_t>(cgltf_image_index(mGltfData, pGltfImage));
+    PPX_LOG_INFO("Loading streamed GLTF image[" << gltfObjectIndex << "]: " << GetName(pGltfImage));
+
+    // Use the bitmap if it was decoded ahead of time
+    ppx::Bitmap* pBitmap = nullptr;
+    if (!IsNull(loadParams.pDecodedImages) && (gltfObjectIndex < loadParams.pDecodedImages->size())) {
+        pBitmap = (*loadParams.pDecodedImages)[gltfObjectIndex].get();
+    }
+
+    ppx::Bitmap bitmap;
+    if (IsNull(pBitmap)) {
+        auto ppxres = DecodeImage(pGltfImage, &bitmap);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        pBitmap = &bitmap;
+    }
+
+    // The streamer keeps the full mip chain
+    auto mipmap = std::make_unique<ppx::Mipmap>(*pBitmap, Mipmap::CalculateLevelCount(pBitmap->GetWidth(), pBitmap->GetHeight()));
+    if (!mipmap->IsOk()) {
+        return ppx::ERROR_FAILED;
+    }
+
+    if (!IsNull(loadParams.pDecodedImages) && (gltfObjectIndex < loadParams.pDecodedImages->size())) {
+        (*loadParams.pDecodedImages)[gltfObjectIndex].reset();
+    }
+
+    auto ppxres = loadParams.pTextureStreamer->CreateImage(std::move(mipmap), outImage);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    outImage->SetName(GetName(pGltfImage));
+
+    return ppx::SUCCESS;
+}
+
 ppx::Result GltfLoader::FetchImageInternal(
     const GltfLoader::InternalLoadParams& loadParams,
     const cgltf_image*                    pGltfImage,
@@ -799,19 +1692,27 @@ ppx::Result GltfLoader::FetchImageInternal(
     }
 
     // Cached failed, so load object
-    scene::Image* pImage = nullptr;
-    //
-    auto ppxres = LoadImageInternal(loadParams, pGltfImage, &pImage);
-    if (Failed(ppxres)) {
-        return ppxres;
+    if (!IsNull(loadParams.pTextureStreamer) && IsBitmapImage(pGltfImage)) {
+        auto ppxres = LoadStreamedImageInternal(loadParams, pGltfImage, outImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
     }
-    PPX_ASSERT_NULL_ARG(pImage);
+    else {
+        scene::Image* pImage = nullptr;
+        //
+        auto ppxres = LoadImageInternal(loadParams, pGltfImage, &pImage);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        PPX_ASSERT_NULL_ARG(pImage);
 
-    // Create object ref
-    outImage = scene::MakeRef(pImage);
-    if (!outImage) {
-        delete pImage;
-        return ppx::ERROR_ALLOCATION_FAILED;
+        // Create object ref
+        outImage = scene::MakeRef(pImage);
+        if (!outImage) {
+            delete pImage;
+            return ppx::ERROR_ALLOCATION_FAILED;
+        }
     }
 
     // Cache object
@@ -820,6 +1721,14 @@ ppx::Result GltfLoader::FetchImageInternal(
         PPX_LOG_INFO("   ...cached image[" << gltfObjectIndex << "]: " << gltfObjectName << " (objectId=" << objectId << ")");
     }
 
+    // Decoded later
+    if (outImage->IsPlaceholder()) {
+        auto pendingImage            = std::make_unique<PendingImage>();
+        pendingImage->gltfImageIndex = gltfObjectIndex;
+        pendingImage->image          = outImage;
+        mPendingImages.push_back(std::move(pendingImage));
+    }
+
     return ppx::SUCCESS;
 }
 
@@ -832,9 +1741,12 @@ ppx::Result GltfLoader::LoadTextureInternal(
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
     }
 
+    // KTX2 or fallback image
+    const cgltf_image* pGltfImage = GetTextureImage(loadParams.pDevice, mGltfTextureDir, pGltfTexture);
+
     // Get GLTF object name
     const std::string gltfTextureObjectName = GetName(pGltfTexture);
-    const std::string gltfImageObjectName   = IsNull(pGltfTexture->image) ? "<NULL>" : GetName(pGltfTexture->image);
+    const std::string gltfImageObjectName   = IsNull(pGltfImage) ? "<NULL>" : GetName(pGltfImage);
 
     // Get GLTF object index to use as object id
     const uint32_t gltfObjectIndex = static_cast<uint32_t>(cgltf_texture_index(mGltfData, pGltfTexture));
@@ -852,7 +1764,7 @@ ppx::Result GltfLoader::LoadTextureInternal(
             return ppxres;
         }
 
-        ppxres = FetchImageInternal(loadParams, pGltfTexture->image, targetImage);
+        ppxres = FetchImageInternal(loadParams, pGltfImage, targetImage);
         if (Failed(ppxres)) {
             return ppxres;
         }
@@ -875,7 +1787,7 @@ ppx::Result GltfLoader::LoadTextureInternal(
 
         // Load image
         scene::Image* pTargetImage = nullptr;
-        ppxres                     = LoadImageInternal(loadParams, pGltfTexture->image, &pTargetImage);
+        ppxres                     = LoadImageInternal(loadParams, pGltfImage, &pTargetImage);
         if (Failed(ppxres)) {
             return ppxres;
         }
@@ -1221,6 +2133,8 @@ ppx::Result GltfLoader::LoadMeshData(
     scene::MeshDataRef&                   outMeshData,
     std::vector<scene::PrimitiveBatch>&   outBatches)
 {
+    PPX_PROFILE_SCOPE("GltfLoader::LoadMeshData");
+
     if (IsNull(loadParams.pDevice) || IsNull(pGltfMesh)) {
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
     }
@@ -1232,7 +2146,7 @@ ppx::Result GltfLoader::LoadMeshData(
     const uint64_t gltfMeshIndex = static_cast<uint64_t>(cgltf_mesh_index(mGltfData, pGltfMesh));
 
     // Calculate id using geometry related accessor hash
-    const uint64_t objectId = GetMeshAccessorsHash(mGltfData, pGltfMesh);
+    const uint64_t objectId = GetMeshAccessorsHash(mGltfData, pGltfMesh) + loadParams.baseObjectIds.meshData;
     PPX_LOG_INFO("Loading mesh data (id=" << objectId << ") for GLTF mesh[" << gltfMeshIndex << "]: " << gltfObjectName);
 
     // Use cached object if possible
@@ -1252,11 +2166,13 @@ ppx::Result GltfLoader::LoadMeshData(
     // ---------------------------------------------------------------------------------------------
 
     // Target vertex formats
-    auto targetPositionFormat = scene::kVertexPositionFormat;
-    auto targetTexCoordFormat = loadParams.requiredVertexAttributes.bits.texCoords ? scene::kVertexAttributeTexCoordFormat : grfx::FORMAT_UNDEFINED;
-    auto targetNormalFormat   = loadParams.requiredVertexAttributes.bits.normals ? scene::kVertexAttributeNormalFormat : grfx::FORMAT_UNDEFINED;
-    auto targetTangentFormat  = loadParams.requiredVertexAttributes.bits.tangents ? scene::kVertexAttributeTagentFormat : grfx::FORMAT_UNDEFINED;
-    auto targetColorFormat    = loadParams.requiredVertexAttributes.bits.colors ? scene::kVertexAttributeColorFormat : grfx::FORMAT_UNDEFINED;
+    const bool                 quantized            = (loadParams.vertexQuantization == scene::VERTEX_QUANTIZATION_COMPACT);
+    const scene::VertexFormats targetFormats        = scene::VertexFormats::Get(loadParams.vertexQuantization);
+    auto                       targetPositionFormat = targetFormats.position;
+    auto                       targetTexCoordFormat = loadParams.requiredVertexAttributes.bits.texCoords ? targetFormats.texCoord : grfx::FORMAT_UNDEFINED;
+    auto                       targetNormalFormat   = loadParams.requiredVertexAttributes.bits.normals ? targetFormats.normal : grfx::FORMAT_UNDEFINED;
+    auto                       targetTangentFormat  = loadParams.requiredVertexAttributes.bits.tangents ? targetFormats.tangent : grfx::FORMAT_UNDEFINED;
+    auto                       targetColorFormat    = loadParams.requiredVertexAttributes.bits.colors ? targetFormats.color : grfx::FORMAT_UNDEFINED;
 
     const uint32_t targetTexCoordElementSize = (targetTexCoordFormat != grfx::FORMAT_UNDEFINED) ? grfx::GetFormatDescription(targetTexCoordFormat)->bytesPerTexel : 0;
     const uint32_t targetNormalElementSize   = (targetNormalFormat != grfx::FORMAT_UNDEFINED) ? grfx::GetFormatDescription(targetNormalFormat)->bytesPerTexel : 0;
@@ -1277,6 +2193,8 @@ ppx::Result GltfLoader::LoadMeshData(
         uint32_t positionDataSize    = 0;
         uint32_t attributeDataOffset = 0; // Must have 4 byte alignment
         uint32_t attributeDataSize   = 0;
+        uint32_t skinDataOffset      = 0; // Must have 4 byte alignment
+        uint32_t skinDataSize        = 0; // 0 if the batch isn't skinned
         // Format of the input index buffer.
         grfx::IndexType indexType = grfx::INDEX_TYPE_UNDEFINED;
         // Format of the index plane in the final repacked GPU buffer.
@@ -1285,10 +2203,15 @@ ppx::Result GltfLoader::LoadMeshData(
         uint32_t  indexCount  = 0;
         uint32_t  vertexCount = 0;
         ppx::AABB boundingBox = {};
+        // LOD index ranges, empty if the batch has no LODs. The index plane
+        // has room for every LOD's target index count.
+        std::vector<ppx::MeshLod> lods;
     };
 
     // Build out batch infos
     std::vector<BatchInfo> batchInfos;
+    // Compact positions are relative to the bounds of all batches
+    ppx::AABB meshBounds = {};
     // Size of the final GPU buffer to allocate. Must account for growth during repacking.
     uint32_t totalDataSize = 0;
     //
@@ -1301,6 +2224,13 @@ ppx::Result GltfLoader::LoadMeshData(
             return ppx::ERROR_SCENE_UNSUPPORTED_TOPOLOGY_TYPE;
         }
 
+        // There's no Draco decoder, cgltf would read zeros for accessors
+        // without data
+        if (pGltfPrimitive->has_draco_mesh_compression && !HasUncompressedFallback(pGltfPrimitive)) {
+            PPX_LOG_ERROR("GLTF: KHR_draco_mesh_compression is not supported, primitive " << primIdx << " of mesh " << gltfObjectName << " has no uncompressed fallback");
+            return ppx::ERROR_SCENE_UNSUPPORTED_COMPRESSION;
+        }
+
         // Get index format
         grfx::IndexType indexType = grfx::INDEX_TYPE_UNDEFINED;
         if (ppx::Result ppxres = ValidateAccessorIndexType(pGltfPrimitive->indices, indexType); Failed(ppxres)) {
@@ -1326,7 +2256,8 @@ ppx::Result GltfLoader::LoadMeshData(
         const uint32_t indexElementSize = grfx::IndexTypeSize(indexType);
         // If we repack indices into a buffer of a different format then we need to account for disparity between input and output sizes.
         const uint32_t repackedSizeRatio = grfx::IndexTypeSize(repackedIndexType) / indexElementSize;
-        const uint32_t indexDataSize     = indexCount * indexElementSize * repackedSizeRatio;
+        const uint32_t indexCapacity     = GetMeshLodIndexCapacity(loadParams.meshLodOptions, indexCount);
+        const uint32_t indexDataSize     = indexCapacity * indexElementSize * repackedSizeRatio;
 
         // Get position accessor
         const VertexAccessors gltflAccessors = GetVertexAccessors(pGltfPrimitive);
@@ -1340,6 +2271,10 @@ ppx::Result GltfLoader::LoadMeshData(
         const uint32_t positionDataSize  = vertexCount * targetPositionElementSize;
         const uint32_t attributeDataSize = vertexCount * targetAttributesElementSize;
 
+        // Skinning reads float positions, compact vertices are left unskinned
+        const bool     skinned      = !quantized && !IsNull(gltflAccessors.pJoints) && !IsNull(gltflAccessors.pWeights);
+        const uint32_t skinDataSize = skinned ? (vertexCount * scene::kVertexSkinDataSize) : 0;
+
         // Index data offset
         const uint32_t indexDataOffset = totalDataSize;
         totalDataSize += RoundUp<uint32_t>(indexDataSize, 4);
@@ -1349,6 +2284,9 @@ ppx::Result GltfLoader::LoadMeshData(
         // Attribute data offset;
         const uint32_t attributeDataOffset = totalDataSize;
         totalDataSize += RoundUp<uint32_t>(attributeDataSize, 4);
+        // Skin data offset
+        const uint32_t skinDataOffset = totalDataSize;
+        totalDataSize += skinDataSize;
 
         // Build out batch info with data we'll need later
         BatchInfo batchInfo           = {};
@@ -1358,9 +2296,25 @@ ppx::Result GltfLoader::LoadMeshData(
         batchInfo.positionDataSize    = positionDataSize;
         batchInfo.attributeDataOffset = attributeDataOffset;
         batchInfo.attributeDataSize   = attributeDataSize;
+        batchInfo.skinDataOffset      = skinDataOffset;
+        batchInfo.skinDataSize        = skinDataSize;
         batchInfo.indexType           = indexType;
         batchInfo.repackedIndexType   = repackedIndexType;
         batchInfo.indexCount          = indexCount;
+        batchInfo.vertexCount         = vertexCount;
+
+        // Bounding box
+        if (ppx::Result ppxres = GetPositionBounds(gltflAccessors.pPositions, &batchInfo.boundingBox); Failed(ppxres)) {
+            PPX_ASSERT_MSG(false, "GLTF mesh primitive position data could not be read");
+            return ppxres;
+        }
+        if (primIdx > 0) {
+            meshBounds.Expand(batchInfo.boundingBox.GetMin());
+            meshBounds.Expand(batchInfo.boundingBox.GetMax());
+        }
+        else {
+            meshBounds = batchInfo.boundingBox;
+        }
 
         // Material
         {
@@ -1370,7 +2324,7 @@ ppx::Result GltfLoader::LoadMeshData(
             // NULL. Use error material if GLTF material is NULL.
             //
             if (!IsNull(pGltfPrimitive->material)) {
-                const uint64_t materialId = cgltf_material_index(mGltfData, pGltfPrimitive->material);
+                const uint64_t materialId = CalculateMaterialObjectId(loadParams, static_cast<uint32_t>(cgltf_material_index(mGltfData, pGltfPrimitive->material)));
                 loadParams.pResourceManager->Find(materialId, batchInfo.material);
             }
             else {
@@ -1393,8 +2347,38 @@ ppx::Result GltfLoader::LoadMeshData(
         batchInfos.push_back(batchInfo);
     }
 
+    const scene::VertexDequantization dequantization = quantized ? scene::VertexDequantization::FromBounds(meshBounds) : scene::VertexDequantization{};
+
+    // Cooked geometry is only used if it's laid out like the batches above
+    const scene::SceneCache::MeshData* pCachedMeshData = nullptr;
+    if (!IsNull(loadParams.pSceneCache) && !loadParams.writeSceneCache && !hasCachedGeometry) {
+        pCachedMeshData = loadParams.pSceneCache->FindMeshData(static_cast<uint32_t>(gltfMeshIndex), loadParams.requiredVertexAttributes.mask);
+        if (!IsNull(pCachedMeshData)) {
+            bool matches = (pCachedMeshData->dataSize == totalDataSize) && (pCachedMeshData->batches.size() == batchInfos.size());
+            for (size_t i = 0; matches && (i < batchInfos.size()); ++i) {
+                const auto& cachedBatch = pCachedMeshData->batches[i];
+                const auto& batch       = batchInfos[i];
+
+                matches = (cachedBatch.indexDataOffset == batch.indexDataOffset) &&
+                          (cachedBatch.indexDataSize == batch.indexDataSize) &&
+                          (cachedBatch.positionDataOffset == batch.positionDataOffset) &&
+                          (cachedBatch.positionDataSize == batch.positionDataSize) &&
+                          (cachedBatch.attributeDataOffset == batch.attributeDataOffset) &&
+                          (cachedBatch.attributeDataSize == batch.attributeDataSize) &&
+                          (cachedBatch.indexType == batch.repackedIndexType) &&
+                          (cachedBatch.indexCount == batch.indexCount);
+            }
+            if (!matches) {
+                PPX_LOG_WARN("Scene cache mesh data doesn't match GLTF mesh[" << gltfMeshIndex << "]: " << gltfObjectName << ", repacking");
+                pCachedMeshData = nullptr;
+            }
+        }
+    }
+
     // Create GPU buffer and copy geometry data to it
-    grfx::BufferPtr targetGpuBuffer = outMeshData ? outMeshData->GetGpuBuffer() : nullptr;
+    grfx::BufferPtr   targetGpuBuffer = outMeshData ? outMeshData->GetGpuBuffer() : nullptr;
+    uint64_t          targetGpuOffset = outMeshData ? outMeshData->GetGpuBufferOffset() : 0;
+    grfx::BufferRange targetGpuRange  = {};
     //
     if (!targetGpuBuffer) {
         grfx::BufferCreateInfo bufferCreateInfo      = {};
@@ -1416,19 +2400,37 @@ ppx::Result GltfLoader::LoadMeshData(
         grfx::ScopeDestroyer SCOPED_DESTROYER = grfx::ScopeDestroyer(loadParams.pDevice);
         SCOPED_DESTROYER.AddObject(stagingBuffer);
 
-        // Create GPU buffer
-        bufferCreateInfo.usageFlags.bits.indexBuffer  = true;
-        bufferCreateInfo.usageFlags.bits.vertexBuffer = true;
-        bufferCreateInfo.usageFlags.bits.transferDst  = true;
-        bufferCreateInfo.memoryUsage                  = grfx::MEMORY_USAGE_GPU_ONLY;
-        bufferCreateInfo.initialState                 = grfx::RESOURCE_STATE_GENERAL;
-        //
-        ppxres = loadParams.pDevice->CreateBuffer(&bufferCreateInfo, &targetGpuBuffer);
-        if (Failed(ppxres)) {
-            PPX_ASSERT_MSG(false, "GPU buffer creation failed");
-            return ppxres;
+        // Create GPU buffer, or sub-allocate it from the pool
+        if (!IsNull(loadParams.pBufferPool)) {
+            ppxres = loadParams.pBufferPool->Allocate(totalDataSize, &targetGpuRange);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "GPU buffer range allocation failed");
+                return ppxres;
+            }
+            targetGpuBuffer = targetGpuRange.pBuffer;
+            targetGpuOffset = targetGpuRange.offset;
+        }
+        else {
+            bufferCreateInfo.usageFlags.bits.indexBuffer                = true;
+            bufferCreateInfo.usageFlags.bits.vertexBuffer               = true;
+            bufferCreateInfo.usageFlags.bits.transferDst                = true;
+            bufferCreateInfo.usageFlags.bits.accelerationStructureInput = loadParams.accelerationStructureInput;
+            bufferCreateInfo.memoryUsage                                = grfx::MEMORY_USAGE_GPU_ONLY;
+
+            // Skinned geometry is read by scene::GpuSkinner, pooled meshes
+            // need a pool created with the same usage
+            for (const auto& batch : batchInfos) {
+                bufferCreateInfo.usageFlags.bits.rawStorageBuffer |= (batch.skinDataSize != 0);
+            }
+            bufferCreateInfo.initialState                               = grfx::RESOURCE_STATE_GENERAL;
+            //
+            ppxres = loadParams.pDevice->CreateBuffer(&bufferCreateInfo, &targetGpuBuffer);
+            if (Failed(ppxres)) {
+                PPX_ASSERT_MSG(false, "GPU buffer creation failed");
+                return ppxres;
+            }
+            SCOPED_DESTROYER.AddObject(targetGpuBuffer);
         }
-        SCOPED_DESTROYER.AddObject(targetGpuBuffer);
 
         // Map staging buffer
         char* pStagingBaseAddr = nullptr;
@@ -1438,23 +2440,39 @@ ppx::Result GltfLoader::LoadMeshData(
             return ppxres;
         }
 
-        // Stage data for copy
-        for (cgltf_size primIdx = 0; primIdx < pGltfMesh->primitives_count; ++primIdx) {
+        // Cooked data is already in the GPU layout
+        if (!IsNull(pCachedMeshData)) {
+            memcpy(pStagingBaseAddr, loadParams.pSceneCache->GetData(pCachedMeshData->dataOffset), totalDataSize);
+
+            for (size_t i = 0; i < batchInfos.size(); ++i) {
+                const auto& cachedBatch   = pCachedMeshData->batches[i];
+                batchInfos[i].vertexCount = cachedBatch.vertexCount;
+                batchInfos[i].boundingBox = ppx::AABB(cachedBatch.boundingBoxMin, cachedBatch.boundingBoxMax);
+                batchInfos[i].lods.assign(cachedBatch.lods, cachedBatch.lods + std::min<uint32_t>(cachedBatch.lodCount, PPX_MESH_MAX_LOD_COUNT));
+            }
+        }
+
+        // Stage data for copy, nothing needs repacking if it was cooked
+        const cgltf_size repackCount = IsNull(pCachedMeshData) ? pGltfMesh->primitives_count : 0;
+        for (cgltf_size primIdx = 0; primIdx < repackCount; ++primIdx) {
             const cgltf_primitive* pGltfPrimitive = &pGltfMesh->primitives[primIdx];
             BatchInfo&             batch          = batchInfos[primIdx];
 
             // Create targetGeometry so we can repack gemetry data into position planar + packed vertex attributes.
+            // Compact vertices are packed by PackCompactVertices(), the geometry only holds the indices.
             Geometry   targetGeometry = {};
             const bool hasAttributes  = (loadParams.requiredVertexAttributes.mask != 0);
             //
             {
-                GeometryCreateInfo createInfo = (hasAttributes ? GeometryCreateInfo::PositionPlanar() : GeometryCreateInfo::Planar()).IndexType(batch.repackedIndexType);
+                GeometryCreateInfo createInfo = ((hasAttributes && !quantized) ? GeometryCreateInfo::PositionPlanar() : GeometryCreateInfo::Planar()).IndexType(batch.repackedIndexType);
 
                 // clang-format off
-                if (loadParams.requiredVertexAttributes.bits.texCoords) createInfo.AddTexCoord(targetTexCoordFormat);
-                if (loadParams.requiredVertexAttributes.bits.normals) createInfo.AddNormal(targetNormalFormat);
-                if (loadParams.requiredVertexAttributes.bits.tangents) createInfo.AddTangent(targetTangentFormat);
-                if (loadParams.requiredVertexAttributes.bits.colors) createInfo.AddColor(targetColorFormat);
+                if (!quantized) {
+                    if (loadParams.requiredVertexAttributes.bits.texCoords) createInfo.AddTexCoord(targetTexCoordFormat);
+                    if (loadParams.requiredVertexAttributes.bits.normals) createInfo.AddNormal(targetNormalFormat);
+                    if (loadParams.requiredVertexAttributes.bits.tangents) createInfo.AddTangent(targetTangentFormat);
+                    if (loadParams.requiredVertexAttributes.bits.colors) createInfo.AddColor(targetColorFormat);
+                }
                 // clang-format on
 
                 auto ppxres = ppx::Geometry::Create(createInfo, &targetGeometry);
@@ -1463,6 +2481,11 @@ ppx::Result GltfLoader::LoadMeshData(
                 }
             }
 
+            // Indices and vertices are collected first so they can be reordered
+            std::vector<uint32_t>          indices;
+            std::vector<TriMeshVertexData> vertices;
+            std::vector<uint16_t>          skinData; // 8 values per vertex, see ReadVertexSkinData()
+
             // Repack geometry data for batch
             {
                 // Process indices
@@ -1482,7 +2505,7 @@ ppx::Result GltfLoader::LoadMeshData(
                                 PPX_ASSERT_MSG(false, "cgltf_accessor_read_uint failed. Index " << i);
                                 return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_INDEX_DATA;
                             }
-                            targetGeometry.AppendIndex(value);
+                            indices.push_back(value);
                         }
                         break;
                 }
@@ -1499,100 +2522,127 @@ ppx::Result GltfLoader::LoadMeshData(
                     return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
                 }
 
-                // Bounding box
-                bool hasBoundingBox = (gltflAccessors.pPositions->has_min && gltflAccessors.pPositions->has_max);
-                if (hasBoundingBox) {
-                    batch.boundingBox = ppx::AABB(
-                        *reinterpret_cast<const float3*>(gltflAccessors.pPositions->min),
-                        *reinterpret_cast<const float3*>(gltflAccessors.pPositions->max));
-                }
-
-                // Determine if we need to process vertices
-                //
-                // Assume we have to procss the vertices
-                bool processVertices = true;
-                if (hasCachedGeometry) {
-                    // If we have cached geometry, we only process the vertices if
-                    // we need the bounding box.
-                    //
-                    processVertices = !hasBoundingBox;
-                }
-
-                // Check vertex data formats
-                auto positionFormat = GetFormat(gltflAccessors.pPositions);
-                auto texCoordFormat = GetFormat(gltflAccessors.pTexCoords);
-                auto normalFormat   = GetFormat(gltflAccessors.pNormals);
-                auto tangentFormat  = GetFormat(gltflAccessors.pTangents);
-                auto colorFormat    = GetFormat(gltflAccessors.pColors);
-                //
-                PPX_ASSERT_MSG((positionFormat == targetPositionFormat), "GLTF: vertex positions format is not supported");
-                //
-                if (loadParams.requiredVertexAttributes.bits.texCoords && !IsNull(gltflAccessors.pTexCoords)) {
-                    PPX_ASSERT_MSG((texCoordFormat == targetTexCoordFormat), "GLTF: vertex tex coords sourceIndexTypeFormat is not supported");
-                }
-                if (loadParams.requiredVertexAttributes.bits.normals && !IsNull(gltflAccessors.pNormals)) {
-                    PPX_ASSERT_MSG((normalFormat == targetNormalFormat), "GLTF: vertex normals format is not supported");
-                }
-                if (loadParams.requiredVertexAttributes.bits.tangents && !IsNull(gltflAccessors.pTangents)) {
-                    PPX_ASSERT_MSG((tangentFormat == targetTangentFormat), "GLTF: vertex tangents format is not supported");
-                }
-                if (loadParams.requiredVertexAttributes.bits.colors && !IsNull(gltflAccessors.pColors)) {
-                    PPX_ASSERT_MSG((colorFormat == targetColorFormat), "GLTF: vertex colors format is not supported");
-                }
-
-                // Data starts
-                const float3* pGltflPositions = static_cast<const float3*>(GetStartAddress(gltflAccessors.pPositions));
-                const float3* pGltflNormals   = static_cast<const float3*>(GetStartAddress(gltflAccessors.pNormals));
-                const float4* pGltflTangents  = static_cast<const float4*>(GetStartAddress(gltflAccessors.pTangents));
-                const float3* pGltflColors    = static_cast<const float3*>(GetStartAddress(gltflAccessors.pColors));
-                const float2* pGltflTexCoords = static_cast<const float2*>(GetStartAddress(gltflAccessors.pTexCoords));
+                // Float and KHR_mesh_quantization integer data are both read as
+                // floats here and only encoded to the target formats once.
+                // Missing normals are generated smooth and missing
+                // tangents from the normals and texture coordinates, as
+                // glTF asks for MikkTSpace tangents.
+                const VertexAttributeFlags& required         = loadParams.requiredVertexAttributes;
+                const bool                  generateTangents = required.bits.tangents && IsNull(gltflAccessors.pTangents) && !IsNull(gltflAccessors.pTexCoords);
+                const bool                  needNormals      = required.bits.normals || generateTangents;
+                const bool                  generateNormals  = needNormals && IsNull(gltflAccessors.pNormals);
+                const cgltf_accessor*       pGltfTexCoords   = (required.bits.texCoords || generateTangents) ? gltflAccessors.pTexCoords : nullptr;
+                const cgltf_accessor*       pGltfNormals     = needNormals ? gltflAccessors.pNormals : nullptr;
+                const cgltf_accessor*       pGltfTangents    = required.bits.tangents ? gltflAccessors.pTangents : nullptr;
+                const cgltf_accessor*       pGltfColors      = required.bits.colors ? gltflAccessors.pColors : nullptr;
 
                 // Process vertex data
+                vertices.reserve(gltflAccessors.pPositions->count);
                 for (cgltf_size i = 0; i < gltflAccessors.pPositions->count; ++i) {
                     TriMeshVertexData vertexData = {};
 
-                    // Position
-                    vertexData.position = *pGltflPositions;
-                    ++pGltflPositions;
-                    // Normals
-                    if (loadParams.requiredVertexAttributes.bits.normals && !IsNull(pGltflNormals)) {
-                        vertexData.normal = *pGltflNormals;
-                        ++pGltflNormals;
+                    bool read = ReadVertexElement(gltflAccessors.pPositions, i, &vertexData.position.x, 3);
+                    if (!IsNull(pGltfNormals)) {
+                        read = read && ReadVertexElement(pGltfNormals, i, &vertexData.normal.x, 3);
+                    }
+                    if (!IsNull(pGltfTangents)) {
+                        read = read && ReadVertexElement(pGltfTangents, i, &vertexData.tangent.x, 4);
                     }
-                    // Tangents
-                    if (loadParams.requiredVertexAttributes.bits.tangents && !IsNull(pGltflTangents)) {
-                        vertexData.tangent = *pGltflTangents;
-                        ++pGltflTangents;
+                    if (!IsNull(pGltfColors)) {
+                        read = read && ReadVertexElement(pGltfColors, i, &vertexData.color.x, 3);
                     }
-                    // Colors
-                    if (loadParams.requiredVertexAttributes.bits.colors && !IsNull(pGltflColors)) {
-                        vertexData.color = *pGltflColors;
-                        ++pGltflColors;
+                    if (!IsNull(pGltfTexCoords)) {
+                        read = read && ReadVertexElement(pGltfTexCoords, i, &vertexData.texCoord.x, 2);
                     }
-                    // Tex cooord
-                    if (loadParams.requiredVertexAttributes.bits.texCoords && !IsNull(pGltflTexCoords)) {
-                        vertexData.texCoord = *pGltflTexCoords;
-                        ++pGltflTexCoords;
+                    if (!read) {
+                        PPX_ASSERT_MSG(false, "GLTF: vertex data could not be read. Vertex " << i);
+                        return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
                     }
 
                     // Append vertex data
-                    targetGeometry.AppendVertexData(vertexData);
+                    vertices.push_back(vertexData);
+                }
 
-                    if (!hasBoundingBox) {
-                        if (i > 0) {
-                            batch.boundingBox.Expand(vertexData.position);
-                        }
-                        else {
-                            batch.boundingBox = ppx::AABB(vertexData.position, vertexData.position);
+                if (generateNormals && !vertices.empty()) {
+                    GenerateMeshNormals(
+                        indices.data(),
+                        CountU32(indices),
+                        &vertices[0].position.x,
+                        static_cast<uint32_t>(sizeof(TriMeshVertexData)),
+                        CountU32(vertices),
+                        &vertices[0].normal.x,
+                        static_cast<uint32_t>(sizeof(TriMeshVertexData)));
+                }
+                if (generateTangents && !vertices.empty()) {
+                    GenerateMeshTangents(
+                        indices.data(),
+                        CountU32(indices),
+                        &vertices[0].position.x,
+                        static_cast<uint32_t>(sizeof(TriMeshVertexData)),
+                        &vertices[0].normal.x,
+                        static_cast<uint32_t>(sizeof(TriMeshVertexData)),
+                        &vertices[0].texCoord.x,
+                        static_cast<uint32_t>(sizeof(TriMeshVertexData)),
+                        CountU32(vertices),
+                        &vertices[0].tangent.x,
+                        static_cast<uint32_t>(sizeof(TriMeshVertexData)));
+                }
+
+                if (batch.skinDataSize != 0) {
+                    skinData.resize(8 * vertices.size());
+                    for (cgltf_size i = 0; i < vertices.size(); ++i) {
+                        if (!ReadVertexSkinData(gltflAccessors.pJoints, gltflAccessors.pWeights, i, &skinData[8 * i])) {
+                            PPX_ASSERT_MSG(false, "GLTF: vertex skin data could not be read. Vertex " << i);
+                            return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
                         }
                     }
                 }
             }
 
+            // Reorder triangles and vertices, the sizes don't change
+            if (loadParams.meshOptimizeOptions.IsEnabled() && !vertices.empty()) {
+                std::vector<uint32_t> remap;
+                OptimizeMesh(
+                    loadParams.meshOptimizeOptions,
+                    indices.data(),
+                    CountU32(indices),
+                    &vertices[0].position.x,
+                    static_cast<uint32_t>(sizeof(TriMeshVertexData)),
+                    CountU32(vertices),
+                    &remap);
+                RemapVertexData(vertices.data(), static_cast<uint32_t>(sizeof(TriMeshVertexData)), CountU32(vertices), remap);
+                if (!skinData.empty()) {
+                    RemapVertexData(skinData.data(), scene::kVertexSkinDataSize, CountU32(vertices), remap);
+                }
+            }
+
+            // Append LODs to the indices, the rest of the index plane is
+            // filled with zeros that no LOD draws
+            if (loadParams.meshLodOptions.IsEnabled() && !vertices.empty()) {
+                GenerateMeshLods(
+                    loadParams.meshLodOptions,
+                    &indices,
+                    &vertices[0].position.x,
+                    static_cast<uint32_t>(sizeof(TriMeshVertexData)),
+                    CountU32(vertices),
+                    &batch.lods);
+                indices.resize(GetMeshLodIndexCapacity(loadParams.meshLodOptions, batch.indexCount), 0);
+            }
+
+            for (uint32_t index : indices) {
+                targetGeometry.AppendIndex(index);
+            }
+            if (!quantized) {
+                for (const auto& vertexData : vertices) {
+                    targetGeometry.AppendVertexData(vertexData);
+                }
+            }
+
             // Geometry data must match what's in the batch
+            const uint32_t vertexCount                 = CountU32(vertices);
             const uint32_t repackedIndexBufferSize     = targetGeometry.GetIndexBuffer()->GetSize();
-            const uint32_t repackedPositionBufferSize  = targetGeometry.GetVertexBuffer(0)->GetSize();
-            const uint32_t repackedAttributeBufferSize = hasAttributes ? targetGeometry.GetVertexBuffer(1)->GetSize() : 0;
+            const uint32_t repackedPositionBufferSize  = quantized ? (vertexCount * targetPositionElementSize) : targetGeometry.GetVertexBuffer(0)->GetSize();
+            const uint32_t repackedAttributeBufferSize = quantized ? (vertexCount * targetAttributesElementSize) : (hasAttributes ? targetGeometry.GetVertexBuffer(1)->GetSize() : 0);
             if (repackedIndexBufferSize != batch.indexDataSize) {
                 PPX_ASSERT_MSG(false, "repacked index buffer size (" << repackedIndexBufferSize << ") does not match batch's index data size (" << batch.indexDataSize << ")");
                 return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_INDEX_DATA;
@@ -1614,26 +2664,75 @@ ppx::Result GltfLoader::LoadMeshData(
                 PPX_ASSERT_MSG((static_cast<uint32_t>((pDstData + repackedIndexBufferSize) - pStagingBaseAddr) <= stagingBuffer->GetSize()), "index data exceeds buffer range");
                 memcpy(pDstData, pSrcData, repackedIndexBufferSize);
 
-                // Positions
-                pSrcData = targetGeometry.GetVertexBuffer(0)->GetData();
-                pDstData = pStagingBaseAddr + batch.positionDataOffset;
-                PPX_ASSERT_MSG((static_cast<uint32_t>((pDstData + repackedPositionBufferSize) - pStagingBaseAddr) <= stagingBuffer->GetSize()), "position data exceeds buffer range");
-                memcpy(pDstData, pSrcData, repackedPositionBufferSize);
+                // Compact vertices are encoded in place
+                if (quantized) {
+                    PPX_ASSERT_MSG((batch.attributeDataOffset + repackedAttributeBufferSize) <= stagingBuffer->GetSize(), "vertex data exceeds buffer range");
+                    PackCompactVertices(
+                        vertices,
+                        loadParams.requiredVertexAttributes,
+                        dequantization,
+                        pStagingBaseAddr + batch.positionDataOffset,
+                        pStagingBaseAddr + batch.attributeDataOffset);
+                }
+                else {
+                    // Positions
+                    pSrcData = targetGeometry.GetVertexBuffer(0)->GetData();
+                    pDstData = pStagingBaseAddr + batch.positionDataOffset;
+                    PPX_ASSERT_MSG((static_cast<uint32_t>((pDstData + repackedPositionBufferSize) - pStagingBaseAddr) <= stagingBuffer->GetSize()), "position data exceeds buffer range");
+                    memcpy(pDstData, pSrcData, repackedPositionBufferSize);
+                }
 
                 // Attributes
-                if (hasAttributes) {
+                if (hasAttributes && !quantized) {
                     pSrcData = targetGeometry.GetVertexBuffer(1)->GetData();
                     pDstData = pStagingBaseAddr + batch.attributeDataOffset;
                     PPX_ASSERT_MSG((static_cast<uint32_t>((pDstData + repackedAttributeBufferSize) - pStagingBaseAddr) <= stagingBuffer->GetSize()), "attribute data exceeds buffer range");
                     memcpy(pDstData, pSrcData, repackedAttributeBufferSize);
                 }
+
+                // Skin data
+                if (batch.skinDataSize != 0) {
+                    PPX_ASSERT_MSG(SizeInBytesU32(skinData) == batch.skinDataSize, "skin data size does not match batch's skin data size");
+                    PPX_ASSERT_MSG((batch.skinDataOffset + batch.skinDataSize) <= stagingBuffer->GetSize(), "skin data exceeds buffer range");
+                    memcpy(pStagingBaseAddr + batch.skinDataOffset, DataPtr(skinData), batch.skinDataSize);
+                }
             }
         }
 
+        // Cook the staged data. Reading back the staging buffer is slow but
+        // only happens when the cache is written.
+        if (loadParams.writeSceneCache) {
+            std::vector<scene::SceneCache::Batch> cachedBatches;
+            for (const auto& batch : batchInfos) {
+                scene::SceneCache::Batch cachedBatch = {};
+                cachedBatch.indexDataOffset          = batch.indexDataOffset;
+                cachedBatch.indexDataSize            = batch.indexDataSize;
+                cachedBatch.positionDataOffset       = batch.positionDataOffset;
+                cachedBatch.positionDataSize         = batch.positionDataSize;
+                cachedBatch.attributeDataOffset      = batch.attributeDataOffset;
+                cachedBatch.attributeDataSize        = batch.attributeDataSize;
+                cachedBatch.indexType                = batch.repackedIndexType;
+                cachedBatch.indexCount               = batch.indexCount;
+                cachedBatch.vertexCount              = batch.vertexCount;
+                cachedBatch.boundingBoxMin           = batch.boundingBox.GetMin();
+                cachedBatch.boundingBoxMax           = batch.boundingBox.GetMax();
+                cachedBatch.lodCount                 = std::min<uint32_t>(CountU32(batch.lods), PPX_MESH_MAX_LOD_COUNT);
+                std::copy_n(batch.lods.begin(), cachedBatch.lodCount, cachedBatch.lods);
+                cachedBatches.push_back(cachedBatch);
+            }
+
+            loadParams.pSceneCache->AddMeshData(
+                static_cast<uint32_t>(gltfMeshIndex),
+                loadParams.requiredVertexAttributes.mask,
+                cachedBatches,
+                pStagingBaseAddr,
+                totalDataSize);
+        }
+
         // Copy staging buffer to GPU buffer
         grfx::BufferToBufferCopyInfo copyInfo = {};
         copyInfo.srcBuffer.offset             = 0;
-        copyInfo.dstBuffer.offset             = 0;
+        copyInfo.dstBuffer.offset             = static_cast<uint32_t>(targetGpuOffset);
         copyInfo.size                         = stagingBuffer->GetSize();
         //
         ppxres = loadParams.pDevice->GetGraphicsQueue()->CopyBufferToBuffer(
@@ -1643,6 +2742,9 @@ ppx::Result GltfLoader::LoadMeshData(
             grfx::RESOURCE_STATE_GENERAL,
             grfx::RESOURCE_STATE_GENERAL);
         if (Failed(ppxres)) {
+            if (!IsNull(loadParams.pBufferPool)) {
+                loadParams.pBufferPool->Free(targetGpuRange);
+            }
             PPX_ASSERT_MSG(false, "staging buffer to GPU buffer copy failed");
             return ppxres;
         }
@@ -1654,14 +2756,22 @@ ppx::Result GltfLoader::LoadMeshData(
         loadParams.pDevice->DestroyBuffer(stagingBuffer);
     }
 
+    // Geometry from the resource manager has the LODs its batches were built with
+    if (hasCachedGeometry && (outMeshData->GetBatchLods().size() == batchInfos.size())) {
+        for (size_t i = 0; i < batchInfos.size(); ++i) {
+            batchInfos[i].lods = outMeshData->GetBatchLods()[i];
+        }
+    }
+
     // Build batches
     for (uint32_t batchIdx = 0; batchIdx < CountU32(batchInfos); ++batchIdx) {
         const auto& batch = batchInfos[batchIdx];
 
-        grfx::IndexBufferView indexBufferView = grfx::IndexBufferView(targetGpuBuffer, batch.repackedIndexType, batch.indexDataOffset, batch.indexDataSize);
+        grfx::IndexBufferView indexBufferView = grfx::IndexBufferView(targetGpuBuffer, batch.repackedIndexType, targetGpuOffset + batch.indexDataOffset, batch.indexDataSize);
 
-        grfx::VertexBufferView positionBufferView  = grfx::VertexBufferView(targetGpuBuffer, targetPositionElementSize, batch.positionDataOffset, batch.positionDataSize);
-        grfx::VertexBufferView attributeBufferView = grfx::VertexBufferView((batch.attributeDataSize != 0) ? targetGpuBuffer : nullptr, targetAttributesElementSize, batch.attributeDataOffset, batch.attributeDataSize);
+        grfx::VertexBufferView positionBufferView  = grfx::VertexBufferView(targetGpuBuffer, targetPositionElementSize, targetGpuOffset + batch.positionDataOffset, batch.positionDataSize);
+        grfx::VertexBufferView attributeBufferView = grfx::VertexBufferView((batch.attributeDataSize != 0) ? targetGpuBuffer : nullptr, targetAttributesElementSize, targetGpuOffset + batch.attributeDataOffset, batch.attributeDataSize);
+        grfx::VertexBufferView skinBufferView      = grfx::VertexBufferView((batch.skinDataSize != 0) ? targetGpuBuffer : nullptr, scene::kVertexSkinDataSize, targetGpuOffset + batch.skinDataOffset, batch.skinDataSize);
 
         scene::PrimitiveBatch targetBatch = scene::PrimitiveBatch(
             batch.material,
@@ -1670,7 +2780,11 @@ ppx::Result GltfLoader::LoadMeshData(
             attributeBufferView,
             batch.indexCount,
             batch.vertexCount,
-            batch.boundingBox);
+            batch.boundingBox,
+            skinBufferView);
+        if (!batch.lods.empty()) {
+            targetBatch.SetLods(batch.lods);
+        }
 
         outBatches.push_back(targetBatch);
     }
@@ -1680,12 +2794,30 @@ ppx::Result GltfLoader::LoadMeshData(
     // Create GPU mesh from geometry if we don't have cached geometry
     if (!hasCachedGeometry) {
         // Allocate mesh data
-        auto pTargetMeshData = new scene::MeshData(loadParams.requiredVertexAttributes, targetGpuBuffer);
+        scene::MeshData* pTargetMeshData = nullptr;
+        if (!IsNull(loadParams.pBufferPool)) {
+            pTargetMeshData = new scene::MeshData(loadParams.requiredVertexAttributes, loadParams.pBufferPool, targetGpuRange, loadParams.vertexQuantization, dequantization);
+        }
+        else {
+            pTargetMeshData = new scene::MeshData(loadParams.requiredVertexAttributes, targetGpuBuffer, loadParams.vertexQuantization, dequantization);
+        }
         if (IsNull(pTargetMeshData)) {
-            loadParams.pDevice->DestroyBuffer(targetGpuBuffer);
+            if (!IsNull(loadParams.pBufferPool)) {
+                loadParams.pBufferPool->Free(targetGpuRange);
+            }
+            else {
+                loadParams.pDevice->DestroyBuffer(targetGpuBuffer);
+            }
             return ppx::ERROR_ALLOCATION_FAILED;
         }
 
+        // Batches built from this geometry later reuse its LODs
+        std::vector<std::vector<ppx::MeshLod>> batchLods;
+        for (const auto& batch : batchInfos) {
+            batchLods.push_back(batch.lods);
+        }
+        pTargetMeshData->SetBatchLods(std::move(batchLods));
+
         // Create ref
         outMeshData = scene::MakeRef(pTargetMeshData);
 
@@ -1929,6 +3061,13 @@ ppx::Result GltfLoader::LoadNodeInternal(
                 return ppx::ERROR_SCENE_INVALID_SOURCE_MESH;
             }
 
+            // The mesh is only drawn at the instance transforms, which
+            // LoadSceneInternal adds as children
+            if (pGltfNode->has_mesh_gpu_instancing && !IsNull(loadParams.pTargetScene)) {
+                pTargetNode = new scene::Node(loadParams.pTargetScene);
+                break;
+            }
+
             // Required object
             scene::MeshRef targetMesh = nullptr;
 
@@ -1955,7 +3094,17 @@ ppx::Result GltfLoader::LoadNodeInternal(
             }
 
             // Allocate node
-            pTargetNode = new scene::MeshNode(targetMesh, loadParams.pTargetScene);
+            auto pMeshNode = new scene::MeshNode(targetMesh, loadParams.pTargetScene);
+
+            // Default morph target weights, animations overwrite them
+            if (pGltfNode->weights_count > 0) {
+                pMeshNode->SetMorphWeights(std::vector<float>(pGltfNode->weights, pGltfNode->weights + pGltfNode->weights_count));
+            }
+            else if (pGltfMesh->weights_count > 0) {
+                pMeshNode->SetMorphWeights(std::vector<float>(pGltfMesh->weights, pGltfMesh->weights + pGltfMesh->weights_count));
+            }
+
+            pTargetNode = pMeshNode;
         } break;
 
         // Camera node
@@ -2058,20 +3207,7 @@ ppx::Result GltfLoader::LoadNodeInternal(
             float z = pGltfNode->rotation[2];
             float w = pGltfNode->rotation[3];
 
-            // Extract euler angles using a matrix
-            //
-            // The values returned by glm::eulerAngles(quat) expects a
-            // certain rotation order. It wasn't clear at the time of
-            // this writing what that should be exactly. So, for the time
-            // being, we'll use the matrix route and stick with XYZ.
-            //
-            auto q = glm::quat(w, x, y, z);
-            auto R = glm::toMat4(q);
-
-            float3 euler = float3(0);
-            glm::extractEulerAngleXYZ(R, euler.x, euler.y, euler.z);
-
-            pTargetNode->SetRotation(euler);
+            pTargetNode->SetRotation(QuaternionToEulerXYZ(x, y, z, w));
             pTargetNode->SetRotationOrder(ppx::Transform::RotationOrder::XYZ);
         }
 
@@ -2120,6 +3256,91 @@ ppx::Result GltfLoader::FetchNodeInternal(
     return ppx::SUCCESS;
 }
 
+ppx::Result GltfLoader::LoadMeshGpuInstancesInternal(
+    const GltfLoader::InternalLoadParams& loadParams,
+    const cgltf_node*                     pGltfNode,
+    scene::Node*                          pTargetNode)
+{
+    if (IsNull(loadParams.pResourceManager) || IsNull(loadParams.pTargetScene) || IsNull(pGltfNode) || IsNull(pTargetNode)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    const cgltf_accessor* pTranslations = nullptr;
+    const cgltf_accessor* pRotations    = nullptr;
+    const cgltf_accessor* pScales       = nullptr;
+    cgltf_size            instanceCount = 0;
+    //
+    const cgltf_mesh_gpu_instancing& gpuInstancing = pGltfNode->mesh_gpu_instancing;
+    for (cgltf_size i = 0; i < gpuInstancing.attributes_count; ++i) {
+        const cgltf_attribute& attribute = gpuInstancing.attributes[i];
+        if (IsNull(attribute.data) || IsNull(attribute.name)) {
+            continue;
+        }
+
+        const std::string name = attribute.name;
+        if (name == "TRANSLATION") {
+            pTranslations = attribute.data;
+        }
+        else if (name == "ROTATION") {
+            pRotations = attribute.data;
+        }
+        else if (name == "SCALE") {
+            pScales = attribute.data;
+        }
+        else {
+            // Custom attributes aren't used
+            continue;
+        }
+
+        if ((instanceCount != 0) && (attribute.data->count != instanceCount)) {
+            PPX_LOG_ERROR("GLTF: EXT_mesh_gpu_instancing attributes of node " << GetName(pGltfNode) << " have different counts");
+            return ppx::ERROR_SCENE_INVALID_SOURCE_MESH;
+        }
+        instanceCount = attribute.data->count;
+    }
+
+    scene::MeshRef targetMesh = nullptr;
+    auto           ppxres     = FetchMeshInternal(loadParams, pGltfNode->mesh, targetMesh);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (cgltf_size i = 0; i < instanceCount; ++i) {
+        auto instanceNode = scene::MakeRef(new scene::MeshNode(targetMesh, loadParams.pTargetScene));
+        if (!instanceNode) {
+            return ppx::ERROR_ALLOCATION_FAILED;
+        }
+
+        float values[4] = {0, 0, 0, 1};
+        if (!IsNull(pTranslations) && cgltf_accessor_read_float(pTranslations, i, values, 3)) {
+            instanceNode->SetTranslation(float3(values[0], values[1], values[2]));
+        }
+        if (!IsNull(pRotations) && cgltf_accessor_read_float(pRotations, i, values, 4)) {
+            instanceNode->SetRotation(QuaternionToEulerXYZ(values[0], values[1], values[2], values[3]));
+            instanceNode->SetRotationOrder(ppx::Transform::RotationOrder::XYZ);
+        }
+        if (!IsNull(pScales) && cgltf_accessor_read_float(pScales, i, values, 3)) {
+            instanceNode->SetScale(float3(values[0], values[1], values[2]));
+        }
+        instanceNode->SetName(pTargetNode->GetName() + "_instance_" + std::to_string(i));
+
+        scene::Node* pInstanceNode = instanceNode.get();
+        ppxres                     = loadParams.pTargetScene->AddNode(std::move(instanceNode));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = pTargetNode->AddChild(pInstanceNode);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    PPX_LOG_INFO("Loaded " << instanceCount << " EXT_mesh_gpu_instancing instances of GLTF node " << GetName(pGltfNode));
+
+    return ppx::SUCCESS;
+}
+
 void GltfLoader::GetUniqueGltfNodeIndices(
     const cgltf_node*     pGltfNode,
     std::set<cgltf_size>& uniqueGltfNodeIndices) const
@@ -2145,6 +3366,8 @@ ppx::Result GltfLoader::LoadSceneInternal(
     const cgltf_scene*                    pGltfScene,
     scene::Scene*                         pTargetScene)
 {
+    PPX_PROFILE_SCOPE("GltfLoader::LoadScene");
+
     if (IsNull(loadParams.pDevice) || IsNull(pGltfScene)) {
         return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
     }
@@ -2167,6 +3390,10 @@ ppx::Result GltfLoader::LoadSceneInternal(
         }
     }
 
+    if (!IsNull(loadParams.pProgress)) {
+        loadParams.pProgress->nodeCount = static_cast<uint32_t>(uniqueGltfNodeIndices.size());
+    }
+
     // Load scene
     //
     // Keeps some maps so we can process the children
@@ -2198,6 +3425,20 @@ ppx::Result GltfLoader::LoadSceneInternal(
 
             // Update map
             indexToNodeMap[gltfNodeIndex] = pNode;
+
+            if (!loadParams.transformOnly && pGltfNode->has_mesh_gpu_instancing && !IsNull(pGltfNode->mesh)) {
+                ppxres = LoadMeshGpuInstancesInternal(loadParams, pGltfNode, pNode);
+                if (Failed(ppxres)) {
+                    return ppxres;
+                }
+            }
+
+            if (!IsNull(loadParams.pProgress)) {
+                loadParams.pProgress->nodesLoaded += 1;
+                if (loadParams.progressCallback) {
+                    loadParams.progressCallback(*loadParams.pProgress);
+                }
+            }
         }
     }
 
@@ -2232,12 +3473,186 @@ ppx::Result GltfLoader::LoadSceneInternal(
         }
     }
 
+    // Skins and animations reference the scene's nodes
+    if (!loadParams.transformOnly) {
+        auto ppxres = LoadSkinsInternal(indexToNodeMap, pTargetScene);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = LoadAnimationsInternal(indexToNodeMap, pTargetScene);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
     // Set name
     pTargetScene->SetName(gltfObjectName);
 
     return ppx::SUCCESS;
 }
 
+ppx::Result GltfLoader::LoadSkinsInternal(
+    const std::unordered_map<cgltf_size, scene::Node*>& indexToNodeMap,
+    scene::Scene*                                       pTargetScene)
+{
+    for (cgltf_size skinIdx = 0; skinIdx < mGltfData->skins_count; ++skinIdx) {
+        const cgltf_skin* pGltfSkin = &mGltfData->skins[skinIdx];
+
+        // Skins used by a mesh node of the scene
+        std::vector<scene::MeshNode*> meshNodes;
+        for (const auto& it : indexToNodeMap) {
+            const cgltf_node* pGltfNode = &mGltfData->nodes[it.first];
+            if ((pGltfNode->skin == pGltfSkin) && (it.second->GetNodeType() == scene::NODE_TYPE_MESH)) {
+                meshNodes.push_back(static_cast<scene::MeshNode*>(it.second));
+            }
+        }
+        if (meshNodes.empty()) {
+            continue;
+        }
+
+        std::vector<const scene::Node*> joints;
+        for (cgltf_size i = 0; i < pGltfSkin->joints_count; ++i) {
+            auto it = indexToNodeMap.find(cgltf_node_index(mGltfData, pGltfSkin->joints[i]));
+            if (it == indexToNodeMap.end()) {
+                PPX_LOG_WARN("GLTF skin[" << skinIdx << "] has joints outside of the scene, skipping it");
+                joints.clear();
+                break;
+            }
+            joints.push_back(it->second);
+        }
+        if (joints.empty()) {
+            continue;
+        }
+
+        std::vector<float4x4> inverseBindMatrices;
+        if (!IsNull(pGltfSkin->inverse_bind_matrices)) {
+            inverseBindMatrices.resize(joints.size(), float4x4(1));
+            for (size_t i = 0; i < joints.size(); ++i) {
+                if (!cgltf_accessor_read_float(pGltfSkin->inverse_bind_matrices, i, &inverseBindMatrices[i][0][0], 16)) {
+                    return ppx::ERROR_SCENE_INVALID_SOURCE_NODE;
+                }
+            }
+        }
+
+        auto skin = std::make_unique<scene::Skin>(std::move(joints), std::move(inverseBindMatrices));
+        skin->SetName(GetName(pGltfSkin));
+        for (auto pMeshNode : meshNodes) {
+            pMeshNode->SetSkin(skin.get());
+        }
+
+        auto ppxres = pTargetScene->AddSkin(std::move(skin));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GltfLoader::LoadAnimationsInternal(
+    const std::unordered_map<cgltf_size, scene::Node*>& indexToNodeMap,
+    scene::Scene*                                       pTargetScene)
+{
+    for (cgltf_size animIdx = 0; animIdx < mGltfData->animations_count; ++animIdx) {
+        const cgltf_animation* pGltfAnimation = &mGltfData->animations[animIdx];
+
+        auto animation = std::make_unique<scene::Animation>();
+        animation->SetName(GetName(pGltfAnimation));
+
+        // GLTF sampler index to animation sampler index
+        std::unordered_map<cgltf_size, uint32_t> samplerIndexMap;
+
+        for (cgltf_size i = 0; i < pGltfAnimation->channels_count; ++i) {
+            const cgltf_animation_channel* pGltfChannel = &pGltfAnimation->channels[i];
+
+            // Channels of nodes outside of the scene are skipped
+            auto itNode = IsNull(pGltfChannel->target_node) ? indexToNodeMap.end() : indexToNodeMap.find(cgltf_node_index(mGltfData, pGltfChannel->target_node));
+            if (itNode == indexToNodeMap.end()) {
+                continue;
+            }
+
+            scene::Animation::Channel channel = {};
+            channel.pTargetNode               = itNode->second;
+            switch (pGltfChannel->target_path) {
+                default: continue;
+                case cgltf_animation_path_type_translation: channel.path = scene::ANIMATION_PATH_TRANSLATION; break;
+                case cgltf_animation_path_type_rotation: channel.path = scene::ANIMATION_PATH_ROTATION; break;
+                case cgltf_animation_path_type_scale: channel.path = scene::ANIMATION_PATH_SCALE; break;
+                case cgltf_animation_path_type_weights: channel.path = scene::ANIMATION_PATH_WEIGHTS; break;
+            }
+
+            const cgltf_animation_sampler* pGltfSampler = pGltfChannel->sampler;
+            const cgltf_size               samplerIndex = static_cast<cgltf_size>(pGltfSampler - pGltfAnimation->samplers);
+
+            auto itSampler = samplerIndexMap.find(samplerIndex);
+            if (itSampler == samplerIndexMap.end()) {
+                const cgltf_accessor* pInput  = pGltfSampler->input;
+                const cgltf_accessor* pOutput = pGltfSampler->output;
+                if (IsNull(pInput) || IsNull(pOutput) || (pInput->count == 0)) {
+                    return ppx::ERROR_SCENE_INVALID_SOURCE_SCENE;
+                }
+
+                scene::AnimationInterpolation interpolation = scene::ANIMATION_INTERPOLATION_LINEAR;
+                switch (pGltfSampler->interpolation) {
+                    default: break;
+                    case cgltf_interpolation_type_step: interpolation = scene::ANIMATION_INTERPOLATION_STEP; break;
+                    case cgltf_interpolation_type_cubic_spline: interpolation = scene::ANIMATION_INTERPOLATION_CUBIC_SPLINE; break;
+                }
+
+                // Weights have one output element per morph target and key
+                const cgltf_size elementsPerKey = pOutput->count / pInput->count;
+                const cgltf_size componentCount = cgltf_num_components(pOutput->type);
+                const cgltf_size valuesPerKey   = (interpolation == scene::ANIMATION_INTERPOLATION_CUBIC_SPLINE) ? 3 : 1;
+                const uint32_t   valueCount     = static_cast<uint32_t>((channel.path == scene::ANIMATION_PATH_WEIGHTS) ? (elementsPerKey / valuesPerKey) : componentCount);
+                const uint32_t   vectorCount    = (valueCount + 3) / 4;
+                if ((valueCount == 0) || (pOutput->count != (pInput->count * valuesPerKey * ((channel.path == scene::ANIMATION_PATH_WEIGHTS) ? valueCount : 1)))) {
+                    return ppx::ERROR_SCENE_INVALID_SOURCE_SCENE;
+                }
+
+                std::vector<float> times(pInput->count);
+                if (cgltf_accessor_unpack_floats(pInput, DataPtr(times), times.size()) != times.size()) {
+                    return ppx::ERROR_SCENE_INVALID_SOURCE_SCENE;
+                }
+
+                std::vector<float> outputs(pOutput->count * componentCount);
+                if (cgltf_accessor_unpack_floats(pOutput, DataPtr(outputs), outputs.size()) != outputs.size()) {
+                    return ppx::ERROR_SCENE_INVALID_SOURCE_SCENE;
+                }
+
+                // Pad each value to whole float4s
+                std::vector<float4> values(pInput->count * valuesPerKey * vectorCount, float4(0));
+                for (size_t j = 0; j < (pInput->count * valuesPerKey); ++j) {
+                    float* pValue = &values[j * vectorCount].x;
+                    std::copy_n(&outputs[j * valueCount], valueCount, pValue);
+                }
+
+                const uint32_t index = animation->AddSampler(scene::AnimationSampler(interpolation, std::move(times), std::move(values), valueCount));
+                itSampler            = samplerIndexMap.emplace(samplerIndex, index).first;
+            }
+            channel.samplerIndex = itSampler->second;
+
+            auto ppxres = animation->AddChannel(channel);
+            if (Failed(ppxres)) {
+                PPX_LOG_WARN("GLTF animation[" << animIdx << "] channel[" << i << "] could not be added: " << ToString(ppxres));
+            }
+        }
+
+        if (animation->GetChannelCount() == 0) {
+            continue;
+        }
+
+        PPX_LOG_INFO("Loaded GLTF animation[" << animIdx << "] with " << animation->GetChannelCount() << " channels: " << animation->GetName());
+
+        auto ppxres = pTargetScene->AddAnimation(std::move(animation));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
 uint32_t GltfLoader::GetSamplerCount() const
 {
     return IsNull(mGltfData) ? 0 : static_cast<uint32_t>(mGltfData->samplers_count);
@@ -2646,6 +4061,11 @@ ppx::Result GltfLoader::LoadMesh(
     loadParams.pDevice                        = pDevice;
     loadParams.pMaterialFactory               = loadOptions.GetMaterialFactory();
     loadParams.requiredVertexAttributes       = loadOptions.GetRequiredAttributes();
+    loadParams.pBufferPool                    = loadOptions.GetBufferPool();
+    loadParams.accelerationStructureInput     = loadOptions.GetAccelerationStructureInput();
+    loadParams.meshOptimizeOptions            = loadOptions.GetMeshOptimizeOptions();
+    loadParams.meshLodOptions                 = loadOptions.GetMeshLodOptions();
+    loadParams.vertexQuantization             = GetVertexQuantization(loadOptions);
 
     // Use default material factory if one wasn't supplied
     if (IsNull(loadParams.pMaterialFactory)) {
@@ -2712,6 +4132,11 @@ ppx::Result GltfLoader::LoadNode(
     loadParams.pDevice                        = pDevice;
     loadParams.pMaterialFactory               = loadOptions.GetMaterialFactory();
     loadParams.requiredVertexAttributes       = loadOptions.GetRequiredAttributes();
+    loadParams.pBufferPool                    = loadOptions.GetBufferPool();
+    loadParams.accelerationStructureInput     = loadOptions.GetAccelerationStructureInput();
+    loadParams.meshOptimizeOptions            = loadOptions.GetMeshOptimizeOptions();
+    loadParams.meshLodOptions                 = loadOptions.GetMeshLodOptions();
+    loadParams.vertexQuantization             = GetVertexQuantization(loadOptions);
 
     // Use default material factory if one wasn't supplied
     if (IsNull(loadParams.pMaterialFactory)) {
@@ -2823,6 +4248,14 @@ ppx::Result GltfLoader::LoadScene(
     loadParams.pDevice                        = pDevice;
     loadParams.pMaterialFactory               = loadOptions.GetMaterialFactory();
     loadParams.requiredVertexAttributes       = loadOptions.GetRequiredAttributes();
+    loadParams.pBufferPool                    = loadOptions.GetBufferPool();
+    loadParams.accelerationStructureInput     = loadOptions.GetAccelerationStructureInput();
+    loadParams.meshOptimizeOptions            = loadOptions.GetMeshOptimizeOptions();
+    loadParams.meshLodOptions                 = loadOptions.GetMeshLodOptions();
+    loadParams.vertexQuantization             = GetVertexQuantization(loadOptions);
+    loadParams.placeholderImages              = loadOptions.GetPlaceholderImages();
+    loadParams.pTextureStreamer               = loadOptions.GetTextureStreamer();
+    loadParams.progressCallback               = loadOptions.GetProgressCallback();
 
     // Use default material factory if one wasn't supplied
     if (IsNull(loadParams.pMaterialFactory)) {
@@ -2837,12 +4270,86 @@ ppx::Result GltfLoader::LoadScene(
 
     loadParams.pMeshMaterialVertexAttributeMasks = &meshDataVertexAttributes;
 
-    // Allocate resource manager
-    auto resourceManager = std::make_unique<scene::ResourceManager>();
+    scene::LoadProgress progress = {};
+    loadParams.pProgress         = &progress;
+
+    // Read the scene cache, or write it if it's missing or stale
+    std::unique_ptr<scene::SceneCache> sceneCache;
+    std::filesystem::path              sceneCachePath;
+    if (!loadOptions.GetCacheDirectory().empty()) {
+        const uint64_t    key      = CalculateSceneCacheKey(pDevice, sceneIndex, loadParams.meshOptimizeOptions, loadParams.meshLodOptions, loadParams.vertexQuantization);
+        const std::string pathHash = std::to_string(XXH64(mGltfFilePath.string().data(), mGltfFilePath.string().size(), 0));
+        sceneCachePath             = loadOptions.GetCacheDirectory() / (mGltfFilePath.stem().string() + "_" + pathHash + "_" + std::to_string(sceneIndex) + ".ppxscene");
+
+        sceneCache  = std::make_unique<scene::SceneCache>();
+        auto ppxres = sceneCache->Load(sceneCachePath, key);
+        if (ppxres == ppx::SUCCESS) {
+            PPX_LOG_INFO("Loading scene from cache: " << sceneCachePath);
+        }
+        else {
+            PPX_LOG_INFO("Scene cache " << sceneCachePath << " can't be used (" << ToString(ppxres) << "), writing it");
+            sceneCache = std::make_unique<scene::SceneCache>();
+            sceneCache->SetKey(key);
+            loadParams.writeSceneCache = true;
+
+            // Placeholders would leave images out of the cache
+            loadParams.placeholderImages = false;
+        }
+        loadParams.pSceneCache = sceneCache.get();
+    }
+    const bool readSceneCache = !IsNull(loadParams.pSceneCache) && !loadParams.writeSceneCache;
+
+    // Placeholders and cached mip chains replace whole images
+    if (loadParams.placeholderImages || !IsNull(loadParams.pSceneCache)) {
+        loadParams.pTextureStreamer = nullptr;
+    }
+
+    // Decode images ahead of time if there's more than one thread to do it,
+    // placeholder images are decoded after the scene is loaded and cached
+    // images don't need decoding.
+    GltfLoader::DecodedImages decodedImages;
+    uint32_t                  decodeThreadCount = loadOptions.GetDecodeThreadCount();
+    if (decodeThreadCount == 0) {
+        decodeThreadCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    }
+    // Packing needs every image decoded, placeholders and cached mip chains
+    // are per image.
+    const bool packImages = (loadOptions.GetMaxPackedImageSize() > 0) && !loadParams.placeholderImages && IsNull(loadParams.pSceneCache);
+    if (((decodeThreadCount > 1) || packImages) && !loadParams.placeholderImages && !readSceneCache) {
+        DecodeImagesInternal(loadParams, decodeThreadCount, decodedImages);
+        loadParams.pDecodedImages = &decodedImages;
+    }
+
+    // Allocate resource manager unless the scene shares one
+    std::shared_ptr<scene::ResourceManager> resourceManager = loadOptions.GetResourceManager();
+    if (resourceManager) {
+        // Objects that aren't keyed by content get a per file base so they
+        // don't collide with other files' objects
+        std::error_code   ec;
+        const std::string canonicalPath = std::filesystem::weakly_canonical(mGltfFilePath, ec).string();
+        const uint64_t    baseObjectId  = XXH64(canonicalPath.data(), canonicalPath.size(), 0);
+
+        loadParams.contentObjectIds       = true;
+        loadParams.baseObjectIds.texture  = baseObjectId;
+        loadParams.baseObjectIds.material = baseObjectId;
+        loadParams.baseObjectIds.mesh     = baseObjectId;
+        loadParams.baseObjectIds.meshData = baseObjectId;
+    }
+    else {
+        resourceManager = std::make_shared<scene::ResourceManager>();
+    }
 
     // Set laod params resource manager
     loadParams.pResourceManager = resourceManager.get();
 
+    // Pack small images before textures fetch them
+    if (packImages) {
+        auto ppxres = PackImagesInternal(loadParams, loadOptions.GetMaxPackedImageSize());
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
     // Allocate the node so we can set the resource manager and target scene
     scene::Scene* pTargetScene = new scene::Scene(std::move(resourceManager));
     if (IsNull(pTargetScene)) {
@@ -2861,6 +4368,24 @@ ppx::Result GltfLoader::LoadScene(
         return ppxres;
     }
 
+    if (loadParams.placeholderImages) {
+        StartPendingImageDecode(decodeThreadCount);
+    }
+
+    // Not being able to write the cache doesn't fail the load
+    if (loadParams.writeSceneCache) {
+        std::error_code ec;
+        std::filesystem::create_directories(loadOptions.GetCacheDirectory(), ec);
+
+        ppxres = sceneCache->Save(sceneCachePath);
+        if (Failed(ppxres)) {
+            PPX_LOG_WARN("Failed to write scene cache: " << sceneCachePath);
+        }
+        else {
+            PPX_LOG_INFO("Wrote scene cache: " << sceneCachePath);
+        }
+    }
+
     PPX_LOG_INFO("Scene load complete: " << GetName(pGltfScene));
     PPX_LOG_INFO("   Num samplers : " << pTargetScene->GetSamplerCount());
     PPX_LOG_INFO("   Num images   : " << pTargetScene->GetImageCount());
@@ -2896,5 +4421,98 @@ ppx::Result GltfLoader::LoadScene(
         loadOptions);
 }
 
+void GltfLoader::StartPendingImageDecode(uint32_t threadCount)
+{
+    if (mPendingImageDecodeStart >= CountU32(mPendingImages)) {
+        return;
+    }
+
+    // Entries are owned by mPendingImages and aren't removed until they're decoded
+    auto batch = std::make_shared<std::vector<PendingImage*>>();
+    for (size_t i = mPendingImageDecodeStart; i < mPendingImages.size(); ++i) {
+        batch->push_back(mPendingImages[i].get());
+    }
+    mPendingImageDecodeStart = CountU32(mPendingImages);
+
+    auto nextImage = std::make_shared<std::atomic<uint32_t>>(0);
+    auto decode    = [this, batch, nextImage]() {
+        const uint32_t imageCount = CountU32(*batch);
+        for (uint32_t i = (*nextImage)++; (i < imageCount) && !mStopPendingImageDecode; i = (*nextImage)++) {
+            PendingImage* pPendingImage = (*batch)[i];
+
+            auto bitmap = std::make_unique<ppx::Bitmap>();
+            if (DecodeImage(&mGltfData->images[pPendingImage->gltfImageIndex], bitmap.get()) == ppx::SUCCESS) {
+                pPendingImage->bitmap = std::move(bitmap);
+            }
+            pPendingImage->decoded = true;
+        }
+    };
+
+    const uint32_t count = std::min(std::max<uint32_t>(threadCount, 1), CountU32(*batch));
+    for (uint32_t i = 0; i < count; ++i) {
+        mPendingImageThreads.emplace_back(decode);
+    }
+
+    PPX_LOG_INFO("Decoding " << batch->size() << " GLTF images on " << count << " background threads");
+}
+
+ppx::Result GltfLoader::LoadPendingImages(uint32_t maxImageCount, uint32_t* pLoadedCount)
+{
+    uint32_t loadedCount = 0;
+    for (size_t i = 0; (i < mPendingImages.size()) && (loadedCount < maxImageCount);) {
+        PendingImage* pPendingImage = mPendingImages[i].get();
+        if (!pPendingImage->decoded) {
+            ++i;
+            continue;
+        }
+
+        // The image is gone if the scene was destroyed
+        scene::ImageRef image = pPendingImage->image.lock();
+        if (image && !pPendingImage->bitmap) {
+            PPX_LOG_ERROR("Failed to decode GLTF image[" << pPendingImage->gltfImageIndex << "], keeping placeholder");
+        }
+        else if (image) {
+            grfx::Device* pDevice    = image->GetImage()->GetDevice();
+            grfx::Image*  pGrfxImage = nullptr;
+
+            auto ppxres = grfx_util::CreateImageFromBitmap(
+                pDevice->GetGraphicsQueue(),
+                pPendingImage->bitmap.get(),
+                &pGrfxImage);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+
+            grfx::SampledImageView* pGrfxImageView = nullptr;
+            ppxres                                 = CreateImageView(pDevice, pGrfxImage, &pGrfxImageView);
+            if (Failed(ppxres)) {
+                pDevice->DestroyImage(pGrfxImage);
+                return ppxres;
+            }
+
+            image->SetImage(pGrfxImage, pGrfxImageView);
+            ++loadedCount;
+        }
+
+        // Decoded entries are before mPendingImageDecodeStart
+        mPendingImages.erase(mPendingImages.begin() + i);
+        --mPendingImageDecodeStart;
+    }
+
+    // All decode threads have finished
+    if (mPendingImages.empty()) {
+        for (auto& thread : mPendingImageThreads) {
+            thread.join();
+        }
+        mPendingImageThreads.clear();
+    }
+
+    if (!IsNull(pLoadedCount)) {
+        *pLoadedCount = loadedCount;
+    }
+
+    return ppx::SUCCESS;
+}
+
 } // namespace scene
 } // namespace ppx
@@ -0,0 +1,758 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_gpu_culler.h"
+#include "ppx/scene/scene_mesh.h"
+#include "ppx/scene/scene_node.h"
+#include "ppx/scene/scene_scene.h"
+#include "ppx/grfx/grfx_buffer.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_image.h"
+
+namespace ppx {
+namespace scene {
+
+// Must match GpuCull.hlsl
+enum
+{
+    CULL_FLAG_FRUSTUM   = 0x1,
+    CULL_FLAG_OCCLUSION = 0x2,
+};
+
+// Registers in GpuCull.hlsl
+enum
+{
+    CULL_PARAMS_REGISTER        = 0,
+    CULL_INSTANCES_REGISTER     = 1,
+    CULL_HIZ_REGISTER           = 2,
+    CULL_DRAWS_REGISTER         = 3,
+    CULL_VISIBLE_COUNT_REGISTER = 4,
+};
+
+// Registers in HiZ.hlsl
+enum
+{
+    HIZ_PARAMS_REGISTER = 0,
+    HIZ_SRC_REGISTER    = 1,
+    HIZ_DST_REGISTER    = 2,
+};
+
+static const uint32_t kCullGroupSize = 64;
+static const uint32_t kHiZGroupSize  = 8;
+
+// size = 176, must match GpuCull.hlsl
+struct CullParams
+{
+    float4   frustumPlanes[6];         // offset = 0
+    float4x4 prevViewProjectionMatrix; // offset = 96
+    uint32_t instanceCount;            // offset = 160
+    uint32_t flags;                    // offset = 164
+    uint32_t padding[2];               // offset = 168
+};
+
+// Must match HiZ.hlsl
+struct HiZParams
+{
+    uint32_t srcSize[2];
+    uint32_t dstSize[2];
+};
+
+// First level is half the size of the depth image, rounded up
+static void GetHiZSize(uint32_t depthWidth, uint32_t depthHeight, uint32_t* pWidth, uint32_t* pHeight, uint32_t* pLevelCount)
+{
+    *pWidth      = std::max<uint32_t>((depthWidth + 1) / 2, 1);
+    *pHeight     = std::max<uint32_t>((depthHeight + 1) / 2, 1);
+    *pLevelCount = 1;
+    for (uint32_t size = std::max(*pWidth, *pHeight); size > 1; size /= 2) {
+        *pLevelCount += 1;
+    }
+}
+
+// -------------------------------------------------------------------------------------------------
+// GpuCuller
+// -------------------------------------------------------------------------------------------------
+GpuCuller::GpuCuller()
+{
+}
+
+GpuCuller::~GpuCuller()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    for (auto& it : mDepthSources) {
+        mDevice->FreeDescriptorSet(it.second.set);
+        mDevice->DestroySampledImageView(it.second.view);
+    }
+    mDepthSources.clear();
+
+    for (auto& set : mHiZSets) {
+        mDevice->FreeDescriptorSet(set);
+    }
+    mHiZSets.clear();
+
+    for (auto& view : mHiZStorageViews) {
+        mDevice->DestroyStorageImageView(view);
+    }
+    mHiZStorageViews.clear();
+
+    for (auto& view : mHiZMipViews) {
+        mDevice->DestroySampledImageView(view);
+    }
+    mHiZMipViews.clear();
+
+    if (mHiZView) {
+        mDevice->DestroySampledImageView(mHiZView);
+        mHiZView.Reset();
+    }
+
+    if (mHiZImage) {
+        mDevice->DestroyImage(mHiZImage);
+        mHiZImage.Reset();
+    }
+
+    if (mCullSet) {
+        mDevice->FreeDescriptorSet(mCullSet);
+        mCullSet.Reset();
+    }
+
+    if (mCullPipeline) {
+        mDevice->DestroyComputePipeline(mCullPipeline);
+        mCullPipeline.Reset();
+    }
+
+    if (mHiZPipeline) {
+        mDevice->DestroyComputePipeline(mHiZPipeline);
+        mHiZPipeline.Reset();
+    }
+
+    if (mCullInterface) {
+        mDevice->DestroyPipelineInterface(mCullInterface);
+        mCullInterface.Reset();
+    }
+
+    if (mHiZInterface) {
+        mDevice->DestroyPipelineInterface(mHiZInterface);
+        mHiZInterface.Reset();
+    }
+
+    if (mCullSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mCullSetLayout);
+        mCullSetLayout.Reset();
+    }
+
+    if (mHiZSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mHiZSetLayout);
+        mHiZSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mParamsBuffer) {
+        if (!IsNull(mParamsMappedAddress)) {
+            mParamsBuffer->UnmapMemory();
+        }
+        mDevice->DestroyBuffer(mParamsBuffer);
+        mParamsBuffer.Reset();
+    }
+
+    if (mInstanceBuffer) {
+        if (!IsNull(mInstanceMappedAddress)) {
+            mInstanceBuffer->UnmapMemory();
+        }
+        mDevice->DestroyBuffer(mInstanceBuffer);
+        mInstanceBuffer.Reset();
+    }
+
+    if (mCounterReadbackBuffer) {
+        if (!IsNull(mReadbackMappedAddress)) {
+            mCounterReadbackBuffer->UnmapMemory();
+        }
+        mDevice->DestroyBuffer(mCounterReadbackBuffer);
+        mCounterReadbackBuffer.Reset();
+    }
+
+    if (mDrawArgsBuffer) {
+        mDevice->DestroyBuffer(mDrawArgsBuffer);
+        mDrawArgsBuffer.Reset();
+    }
+
+    if (mCounterBuffer) {
+        mDevice->DestroyBuffer(mCounterBuffer);
+        mCounterBuffer.Reset();
+    }
+
+    if (mCounterClearBuffer) {
+        mDevice->DestroyBuffer(mCounterClearBuffer);
+        mCounterClearBuffer.Reset();
+    }
+}
+
+ppx::Result GpuCuller::Create(grfx::Device* pDevice, const scene::GpuCullerCreateInfo& createInfo, scene::GpuCuller** ppCuller)
+{
+    if (IsNull(pDevice) || IsNull(ppCuller)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (IsNull(createInfo.pCullShader) || IsNull(createInfo.pHiZShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.maxInstanceCount == 0) || (createInfo.depthWidth == 0) || (createInfo.depthHeight == 0) || (createInfo.maxDepthImages == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    scene::GpuCuller* pCuller = new scene::GpuCuller();
+    if (IsNull(pCuller)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    auto ppxres = pCuller->InitializeResources(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pCuller;
+        return ppxres;
+    }
+
+    *ppCuller = pCuller;
+
+    return ppx::SUCCESS;
+}
+
+void GpuCuller::AppendInstances(const scene::Scene* pScene, std::vector<scene::GpuCullInstance>* pInstances)
+{
+    PPX_ASSERT_NULL_ARG(pScene);
+    PPX_ASSERT_NULL_ARG(pInstances);
+
+    const uint32_t nodeCount = pScene->GetMeshNodeCount();
+    for (uint32_t nodeIndex = 0; nodeIndex < nodeCount; ++nodeIndex) {
+        const scene::MeshNode* pNode = pScene->GetMeshNode(nodeIndex);
+        const scene::Mesh*     pMesh = pNode->GetMesh();
+        if (IsNull(pMesh)) {
+            continue;
+        }
+
+        const float4x4& modelMatrix = pNode->GetEvaluatedMatrix();
+        for (const auto& batch : pMesh->GetBatches()) {
+            const ppx::AABB bounds = batch.GetBoundingBox().GetTransformed(modelMatrix);
+
+            scene::GpuCullInstance instance = {};
+            instance.boundsMin              = bounds.GetMin();
+            instance.boundsMax              = bounds.GetMax();
+            instance.indexCount             = batch.GetIndexCount();
+            pInstances->push_back(instance);
+        }
+    }
+}
+
+ppx::Result GpuCuller::InitializeResources(grfx::Device* pDevice, const scene::GpuCullerCreateInfo& createInfo)
+{
+    mDevice           = pDevice;
+    mMaxInstanceCount = createInfo.maxInstanceCount;
+    mMaxDepthImages   = createInfo.maxDepthImages;
+
+    // Buffers
+    {
+        grfx::BufferCreateInfo bufferCreateInfo        = {};
+        bufferCreateInfo.size                          = RoundUp<uint64_t>(sizeof(CullParams), PPX_CONSTANT_BUFFER_ALIGNMENT);
+        bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+        bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        auto ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mParamsBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = mParamsBuffer->MapMemory(0, &mParamsMappedAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Read directly from host memory, instance data is small and
+        // usually doesn't change every frame.
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = mMaxInstanceCount * sizeof(scene::GpuCullInstance);
+        bufferCreateInfo.structuredElementStride            = sizeof(scene::GpuCullInstance);
+        bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mInstanceBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = mInstanceBuffer->MapMemory(0, &mInstanceMappedAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = mMaxInstanceCount * sizeof(grfx::DrawIndexedIndirectCommand);
+        bufferCreateInfo.structuredElementStride            = sizeof(grfx::DrawIndexedIndirectCommand);
+        bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+        bufferCreateInfo.usageFlags.bits.indirectBuffer     = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_INDIRECT_ARGUMENT;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mDrawArgsBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = sizeof(uint32_t);
+        bufferCreateInfo.structuredElementStride            = sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.rwStructuredBuffer = true;
+        bufferCreateInfo.usageFlags.bits.transferSrc        = true;
+        bufferCreateInfo.usageFlags.bits.transferDst        = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                       = grfx::RESOURCE_STATE_COPY_SRC;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mCounterBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        bufferCreateInfo                             = {};
+        bufferCreateInfo.size                        = sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.transferSrc = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_CPU_TO_GPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_SRC;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mCounterClearBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        const uint32_t zero = 0;
+        ppxres              = mCounterClearBuffer->CopyFromSource(sizeof(zero), &zero);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        bufferCreateInfo                             = {};
+        bufferCreateInfo.size                        = sizeof(uint32_t);
+        bufferCreateInfo.usageFlags.bits.transferDst = true;
+        bufferCreateInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_TO_CPU;
+        bufferCreateInfo.initialState                = grfx::RESOURCE_STATE_COPY_DST;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mCounterReadbackBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pReadbackAddress = nullptr;
+        ppxres                 = mCounterReadbackBuffer->MapMemory(0, &pReadbackAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mReadbackMappedAddress = static_cast<const uint32_t*>(pReadbackAddress);
+    }
+
+    // Descriptor pool: one cull set, one HiZ set per level after the first
+    // plus one per depth image for the first level.
+    {
+        uint32_t width      = 0;
+        uint32_t height     = 0;
+        uint32_t levelCount = 0;
+        GetHiZSize(createInfo.depthWidth, createInfo.depthHeight, &width, &height, &levelCount);
+
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.uniformBuffer                  = 1;
+        poolCreateInfo.structuredBuffer               = 3;
+        poolCreateInfo.sampledImage                   = levelCount + mMaxDepthImages;
+        poolCreateInfo.storageImage                   = (levelCount - 1) + mMaxDepthImages;
+
+        auto ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Set layouts
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CULL_PARAMS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CULL_INSTANCES_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CULL_HIZ_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CULL_DRAWS_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(CULL_VISIBLE_COUNT_REGISTER, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER));
+
+        auto ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mCullSetLayout);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(HIZ_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(HIZ_DST_REGISTER, grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE));
+
+        ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mHiZSetLayout);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Pipelines
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mCullSetLayout;
+
+        auto ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mCullInterface);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+        cpCreateInfo.CS                              = {createInfo.pCullShader, "csmain"};
+        cpCreateInfo.pPipelineInterface              = mCullInterface;
+
+        ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mCullPipeline);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        piCreateInfo                       = {};
+        piCreateInfo.setCount              = 1;
+        piCreateInfo.sets[0].set           = 0;
+        piCreateInfo.sets[0].pLayout       = mHiZSetLayout;
+        piCreateInfo.pushConstants.count   = sizeof(HiZParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding = HIZ_PARAMS_REGISTER;
+        piCreateInfo.pushConstants.set     = 0;
+
+        ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mHiZInterface);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        cpCreateInfo                    = {};
+        cpCreateInfo.CS                 = {createInfo.pHiZShader, "csmain"};
+        cpCreateInfo.pPipelineInterface = mHiZInterface;
+
+        ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mHiZPipeline);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    auto ppxres = InitializeHiZ(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Cull descriptors
+    {
+        ppxres = pDevice->AllocateDescriptorSet(mDescriptorPool, mCullSetLayout, &mCullSet);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        std::array<grfx::WriteDescriptor, 5> writes = {};
+
+        writes[0].binding      = CULL_PARAMS_REGISTER;
+        writes[0].type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset = 0;
+        writes[0].bufferRange  = PPX_WHOLE_SIZE;
+        writes[0].pBuffer      = mParamsBuffer;
+
+        writes[1].binding                = CULL_INSTANCES_REGISTER;
+        writes[1].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+        writes[1].bufferOffset           = 0;
+        writes[1].bufferRange            = PPX_WHOLE_SIZE;
+        writes[1].structuredElementCount = mMaxInstanceCount;
+        writes[1].pBuffer                = mInstanceBuffer;
+
+        writes[2].binding    = CULL_HIZ_REGISTER;
+        writes[2].type       = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[2].pImageView = mHiZView;
+
+        writes[3].binding                = CULL_DRAWS_REGISTER;
+        writes[3].type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+        writes[3].bufferOffset           = 0;
+        writes[3].bufferRange            = PPX_WHOLE_SIZE;
+        writes[3].structuredElementCount = mMaxInstanceCount;
+        writes[3].pBuffer                = mDrawArgsBuffer;
+
+        writes[4].binding                = CULL_VISIBLE_COUNT_REGISTER;
+        writes[4].type                   = grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER;
+        writes[4].bufferOffset           = 0;
+        writes[4].bufferRange            = PPX_WHOLE_SIZE;
+        writes[4].structuredElementCount = 1;
+        writes[4].pBuffer                = mCounterBuffer;
+
+        ppxres = mCullSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GpuCuller::InitializeHiZ(grfx::Device* pDevice, const scene::GpuCullerCreateInfo& createInfo)
+{
+    uint32_t width      = 0;
+    uint32_t height     = 0;
+    uint32_t levelCount = 0;
+    GetHiZSize(createInfo.depthWidth, createInfo.depthHeight, &width, &height, &levelCount);
+
+    grfx::ImageCreateInfo imageCreateInfo   = {};
+    imageCreateInfo.type                    = grfx::IMAGE_TYPE_2D;
+    imageCreateInfo.width                   = width;
+    imageCreateInfo.height                  = height;
+    imageCreateInfo.depth                   = 1;
+    imageCreateInfo.format                  = grfx::FORMAT_R32_FLOAT;
+    imageCreateInfo.mipLevelCount           = levelCount;
+    imageCreateInfo.usageFlags.bits.sampled = true;
+    imageCreateInfo.usageFlags.bits.storage = true;
+    imageCreateInfo.initialState            = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+    auto ppxres = pDevice->CreateImage(&imageCreateInfo, &mHiZImage);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    grfx::SampledImageViewCreateInfo sampledViewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(mHiZImage);
+    ppxres                                                 = pDevice->CreateSampledImageView(&sampledViewCreateInfo, &mHiZView);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        grfx::StorageImageViewPtr        storageView;
+        grfx::StorageImageViewCreateInfo storageViewCreateInfo = grfx::StorageImageViewCreateInfo::GuessFromImage(mHiZImage);
+        storageViewCreateInfo.mipLevel                         = level;
+        storageViewCreateInfo.mipLevelCount                    = 1;
+
+        ppxres = pDevice->CreateStorageImageView(&storageViewCreateInfo, &storageView);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mHiZStorageViews.push_back(storageView);
+
+        // The last level is never read while building the pyramid
+        if (level + 1 == levelCount) {
+            break;
+        }
+
+        grfx::SampledImageViewPtr mipView;
+        sampledViewCreateInfo               = grfx::SampledImageViewCreateInfo::GuessFromImage(mHiZImage);
+        sampledViewCreateInfo.mipLevel      = level;
+        sampledViewCreateInfo.mipLevelCount = 1;
+
+        ppxres = pDevice->CreateSampledImageView(&sampledViewCreateInfo, &mipView);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mHiZMipViews.push_back(mipView);
+    }
+
+    for (uint32_t level = 1; level < levelCount; ++level) {
+        grfx::DescriptorSetPtr set;
+        ppxres = pDevice->AllocateDescriptorSet(mDescriptorPool, mHiZSetLayout, &set);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mHiZSets.push_back(set);
+
+        std::array<grfx::WriteDescriptor, 2> writes = {};
+        writes[0].binding                           = HIZ_SRC_REGISTER;
+        writes[0].type                              = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        writes[0].pImageView                        = mHiZMipViews[level - 1];
+        writes[1].binding                           = HIZ_DST_REGISTER;
+        writes[1].type                              = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        writes[1].pImageView                        = mHiZStorageViews[level];
+
+        ppxres = set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GpuCuller::GetDepthSource(grfx::Image* pDepthImage, DepthSource** ppSource)
+{
+    auto it = mDepthSources.find(pDepthImage);
+    if (it != mDepthSources.end()) {
+        *ppSource = &it->second;
+        return ppx::SUCCESS;
+    }
+
+    if (CountU32(mDepthSources) >= mMaxDepthImages) {
+        PPX_ASSERT_MSG(false, "GpuCuller: more distinct depth images than GpuCullerCreateInfo::maxDepthImages");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    DepthSource source = {};
+
+    grfx::SampledImageViewCreateInfo viewCreateInfo = grfx::SampledImageViewCreateInfo::GuessFromImage(pDepthImage);
+    viewCreateInfo.mipLevelCount                    = 1;
+
+    auto ppxres = mDevice->CreateSampledImageView(&viewCreateInfo, &source.view);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mHiZSetLayout, &source.set);
+    if (Failed(ppxres)) {
+        mDevice->DestroySampledImageView(source.view);
+        return ppxres;
+    }
+
+    std::array<grfx::WriteDescriptor, 2> writes = {};
+    writes[0].binding                           = HIZ_SRC_REGISTER;
+    writes[0].type                              = grfx::DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    writes[0].pImageView                        = source.view;
+    writes[1].binding                           = HIZ_DST_REGISTER;
+    writes[1].type                              = grfx::DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    writes[1].pImageView                        = mHiZStorageViews[0];
+
+    ppxres = source.set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        mDevice->FreeDescriptorSet(source.set);
+        mDevice->DestroySampledImageView(source.view);
+        return ppxres;
+    }
+
+    *ppSource = &mDepthSources.emplace(pDepthImage, source).first->second;
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GpuCuller::SetInstances(uint32_t count, const scene::GpuCullInstance* pInstances)
+{
+    if (count > mMaxInstanceCount) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    if ((count > 0) && IsNull(pInstances)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (count > 0) {
+        memcpy(mInstanceMappedAddress, pInstances, count * sizeof(scene::GpuCullInstance));
+    }
+    mInstanceCount = count;
+
+    return ppx::SUCCESS;
+}
+
+void GpuCuller::Cull(grfx::CommandBuffer* pCmd, const float4x4& viewProjectionMatrix)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    const ppx::Frustum frustum(viewProjectionMatrix);
+
+    CullParams params    = {};
+    params.instanceCount = mInstanceCount;
+    for (uint32_t i = 0; i < ppx::Frustum::PLANE_COUNT; ++i) {
+        params.frustumPlanes[i] = frustum.GetPlane(i);
+    }
+    params.prevViewProjectionMatrix = mPrevViewProjectionMatrix;
+    if (mFrustumCulling) {
+        params.flags |= CULL_FLAG_FRUSTUM;
+    }
+    if (mOcclusionCulling && mHiZValid) {
+        params.flags |= CULL_FLAG_OCCLUSION;
+    }
+    memcpy(mParamsMappedAddress, &params, sizeof(params));
+
+    // The HiZ pyramid built after this frame is tested with this frame's matrix
+    mPrevViewProjectionMatrix = viewProjectionMatrix;
+
+    grfx::BufferToBufferCopyInfo copyInfo = {};
+    copyInfo.size                         = sizeof(uint32_t);
+
+    pCmd->TransitionBufferState(mCounterBuffer, grfx::RESOURCE_STATE_COPY_DST);
+    pCmd->CopyBufferToBuffer(&copyInfo, mCounterClearBuffer, mCounterBuffer);
+
+    pCmd->TransitionBufferState(mCounterBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->TransitionBufferState(mDrawArgsBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->TransitionImageState(mHiZImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    if (mInstanceCount > 0) {
+        pCmd->BindComputeDescriptorSets(mCullInterface, 1, &mCullSet);
+        pCmd->BindComputePipeline(mCullPipeline);
+        pCmd->Dispatch((mInstanceCount + kCullGroupSize - 1) / kCullGroupSize, 1, 1);
+    }
+
+    pCmd->TransitionBufferState(mDrawArgsBuffer, grfx::RESOURCE_STATE_INDIRECT_ARGUMENT);
+    pCmd->TransitionBufferState(mCounterBuffer, grfx::RESOURCE_STATE_COPY_SRC);
+    pCmd->CopyBufferToBuffer(&copyInfo, mCounterBuffer, mCounterReadbackBuffer);
+    pCmd->FlushBarriers();
+}
+
+void GpuCuller::BuildHiZ(grfx::CommandBuffer* pCmd, grfx::Image* pDepthImage, grfx::ResourceState depthState)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pDepthImage);
+
+    DepthSource* pSource = nullptr;
+    if (Failed(GetDepthSource(pDepthImage, &pSource))) {
+        return;
+    }
+
+    pCmd->FlushBarriers();
+    pCmd->TransitionImageLayout(pDepthImage, PPX_ALL_SUBRESOURCES, depthState, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+
+    pCmd->BindComputePipeline(mHiZPipeline);
+
+    uint32_t srcWidth  = pDepthImage->GetWidth();
+    uint32_t srcHeight = pDepthImage->GetHeight();
+
+    const uint32_t levelCount = mHiZImage->GetMipLevelCount();
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const uint32_t dstWidth  = std::max<uint32_t>(mHiZImage->GetWidth() >> level, 1);
+        const uint32_t dstHeight = std::max<uint32_t>(mHiZImage->GetHeight() >> level, 1);
+
+        if (level > 0) {
+            pCmd->TransitionImageState(mHiZImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, level - 1, 1);
+        }
+        pCmd->TransitionImageState(mHiZImage, grfx::RESOURCE_STATE_UNORDERED_ACCESS, level, 1);
+        pCmd->FlushBarriers();
+
+        const grfx::DescriptorSet* pSet = (level == 0) ? pSource->set.Get() : mHiZSets[level - 1].Get();
+        pCmd->BindComputeDescriptorSets(mHiZInterface, 1, &pSet);
+
+        HiZParams params  = {};
+        params.srcSize[0] = srcWidth;
+        params.srcSize[1] = srcHeight;
+        params.dstSize[0] = dstWidth;
+        params.dstSize[1] = dstHeight;
+        pCmd->PushComputeConstants(mHiZInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+        pCmd->Dispatch((dstWidth + kHiZGroupSize - 1) / kHiZGroupSize, (dstHeight + kHiZGroupSize - 1) / kHiZGroupSize, 1);
+
+        srcWidth  = dstWidth;
+        srcHeight = dstHeight;
+    }
+
+    pCmd->TransitionImageState(mHiZImage, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    pCmd->FlushBarriers();
+    pCmd->TransitionImageLayout(pDepthImage, PPX_ALL_SUBRESOURCES, grfx::RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, depthState);
+
+    mHiZValid = true;
+}
+
+uint32_t GpuCuller::GetVisibleCount() const
+{
+    return IsNull(mReadbackMappedAddress) ? 0 : *mReadbackMappedAddress;
+}
+
+} // namespace scene
+} // namespace ppx
@@ -0,0 +1,426 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_gpu_skinner.h"
+#include "ppx/scene/scene_animation.h"
+#include "ppx/scene/scene_mesh.h"
+#include "ppx/scene/scene_node.h"
+#include "ppx/grfx/grfx_device.h"
+
+namespace ppx {
+namespace scene {
+
+// Registers in SkinVertices.hlsl
+enum
+{
+    SKIN_PARAMS_REGISTER = 0,
+    SKIN_JOINTS_REGISTER = 1,
+    SKIN_SRC_REGISTER    = 2,
+    SKIN_DST_REGISTER    = 3,
+};
+
+static const uint32_t kSkinGroupSize    = 64;
+static const uint32_t kNoAttribute      = UINT32_MAX;
+static const uint32_t kSkinPositionSize = 12; // kVertexPositionFormat
+
+// Must match SkinVertices.hlsl
+struct SkinParams
+{
+    uint32_t vertexCount;
+    uint32_t positionOffset;
+    uint32_t attributeOffset;
+    uint32_t attributeStride;
+    uint32_t normalOffset;
+    uint32_t tangentOffset;
+    uint32_t skinOffset;
+    uint32_t firstJoint;
+    uint32_t outPositionOffset;
+    uint32_t outAttributeOffset;
+};
+
+static uint32_t GetFormatSize(grfx::Format format)
+{
+    return grfx::GetFormatDescription(format)->bytesPerTexel;
+}
+
+// Offsets of the normal and tangent within an interleaved attribute, in
+// the texCoord, normal, tangent, color order the loader writes them in
+static void GetAttributeOffsets(const scene::VertexAttributeFlags& attributes, uint32_t* pNormalOffset, uint32_t* pTangentOffset)
+{
+    const scene::VertexFormats formats = scene::VertexFormats::Get(scene::VERTEX_QUANTIZATION_NONE);
+
+    uint32_t offset = attributes.bits.texCoords ? GetFormatSize(formats.texCoord) : 0;
+    *pNormalOffset  = attributes.bits.normals ? offset : kNoAttribute;
+    offset += attributes.bits.normals ? GetFormatSize(formats.normal) : 0;
+    *pTangentOffset = attributes.bits.tangents ? offset : kNoAttribute;
+}
+
+// -------------------------------------------------------------------------------------------------
+// GpuSkinner
+// -------------------------------------------------------------------------------------------------
+GpuSkinner::GpuSkinner()
+{
+}
+
+GpuSkinner::~GpuSkinner()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    for (auto& it : mSourceSets) {
+        mDevice->FreeDescriptorSet(it.second);
+    }
+    mSourceSets.clear();
+
+    if (mPipeline) {
+        mDevice->DestroyComputePipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mInterface) {
+        mDevice->DestroyPipelineInterface(mInterface);
+        mInterface.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mJointBuffer) {
+        if (!IsNull(mJointMappedAddress)) {
+            mJointBuffer->UnmapMemory();
+        }
+        mDevice->DestroyBuffer(mJointBuffer);
+        mJointBuffer.Reset();
+    }
+
+    if (mOutputBuffer) {
+        mDevice->DestroyBuffer(mOutputBuffer);
+        mOutputBuffer.Reset();
+    }
+}
+
+ppx::Result GpuSkinner::Create(grfx::Device* pDevice, const scene::GpuSkinnerCreateInfo& createInfo, scene::GpuSkinner** ppSkinner)
+{
+    if (IsNull(pDevice) || IsNull(ppSkinner) || IsNull(createInfo.pSkinShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.maxVertexCount == 0) || (createInfo.maxJointCount == 0) || (createInfo.maxSourceBuffers == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    scene::GpuSkinner* pSkinner = new scene::GpuSkinner();
+    if (IsNull(pSkinner)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    auto ppxres = pSkinner->InitializeResources(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pSkinner;
+        return ppxres;
+    }
+
+    *ppSkinner = pSkinner;
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GpuSkinner::InitializeResources(grfx::Device* pDevice, const scene::GpuSkinnerCreateInfo& createInfo)
+{
+    mDevice           = pDevice;
+    mMaxJointCount    = createInfo.maxJointCount;
+    mMaxSourceBuffers = createInfo.maxSourceBuffers;
+
+    // Room for the positions and the largest attribute layout of every vertex
+    const scene::VertexFormats formats = scene::VertexFormats::Get(scene::VERTEX_QUANTIZATION_NONE);
+    const uint32_t             maxVertexSize =
+        kSkinPositionSize + GetFormatSize(formats.texCoord) + GetFormatSize(formats.normal) + GetFormatSize(formats.tangent) + GetFormatSize(formats.color);
+    mOutputSize = static_cast<uint64_t>(createInfo.maxVertexCount) * maxVertexSize;
+
+    // Buffers
+    {
+        // Written every frame and read once per skinned vertex
+        grfx::BufferCreateInfo bufferCreateInfo             = {};
+        bufferCreateInfo.size                               = mMaxJointCount * sizeof(float4x4);
+        bufferCreateInfo.structuredElementStride            = sizeof(float4x4);
+        bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        auto ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mJointBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pJointAddress = nullptr;
+        ppxres              = mJointBuffer->MapMemory(0, &pJointAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mJointMappedAddress = static_cast<float4x4*>(pJointAddress);
+
+        bufferCreateInfo                                  = {};
+        bufferCreateInfo.size                             = mOutputSize;
+        bufferCreateInfo.usageFlags.bits.rawStorageBuffer = true;
+        bufferCreateInfo.usageFlags.bits.vertexBuffer     = true;
+        bufferCreateInfo.memoryUsage                      = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                     = grfx::RESOURCE_STATE_VERTEX_BUFFER;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mOutputBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Descriptor pool: one set per source buffer
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.structuredBuffer               = mMaxSourceBuffers;
+        poolCreateInfo.rawStorageBuffer               = 2 * mMaxSourceBuffers;
+
+        auto ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Set layout
+    {
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(SKIN_JOINTS_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(SKIN_SRC_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(SKIN_DST_REGISTER, grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER));
+
+        auto ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mSetLayout;
+        piCreateInfo.pushConstants.count               = sizeof(SkinParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding             = SKIN_PARAMS_REGISTER;
+        piCreateInfo.pushConstants.set                 = 0;
+
+        auto ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mInterface);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        grfx::ComputePipelineCreateInfo cpCreateInfo = {};
+        cpCreateInfo.CS                              = {createInfo.pSkinShader, "csmain"};
+        cpCreateInfo.pPipelineInterface              = mInterface;
+
+        ppxres = pDevice->CreateComputePipeline(&cpCreateInfo, &mPipeline);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GpuSkinner::GetSourceSet(const grfx::Buffer* pSourceBuffer, grfx::DescriptorSet** ppSet)
+{
+    auto it = mSourceSets.find(pSourceBuffer);
+    if (it != mSourceSets.end()) {
+        *ppSet = it->second;
+        return ppx::SUCCESS;
+    }
+
+    if (CountU32(mSourceSets) >= mMaxSourceBuffers) {
+        PPX_ASSERT_MSG(false, "GpuSkinner: more distinct source buffers than GpuSkinnerCreateInfo::maxSourceBuffers");
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    grfx::DescriptorSetPtr set;
+    auto                   ppxres = mDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &set);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    std::array<grfx::WriteDescriptor, 3> writes = {};
+
+    writes[0].binding                = SKIN_JOINTS_REGISTER;
+    writes[0].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+    writes[0].bufferOffset           = 0;
+    writes[0].bufferRange            = PPX_WHOLE_SIZE;
+    writes[0].structuredElementCount = mMaxJointCount;
+    writes[0].pBuffer                = mJointBuffer;
+
+    // Offsets are absolute so pooled mesh data shares one set per pool buffer
+    writes[1].binding      = SKIN_SRC_REGISTER;
+    writes[1].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+    writes[1].bufferOffset = 0;
+    writes[1].bufferRange  = PPX_WHOLE_SIZE;
+    writes[1].pBuffer      = pSourceBuffer;
+
+    writes[2].binding      = SKIN_DST_REGISTER;
+    writes[2].type         = grfx::DESCRIPTOR_TYPE_RAW_STORAGE_BUFFER;
+    writes[2].bufferOffset = 0;
+    writes[2].bufferRange  = PPX_WHOLE_SIZE;
+    writes[2].pBuffer      = mOutputBuffer;
+
+    ppxres = set->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+    if (Failed(ppxres)) {
+        mDevice->FreeDescriptorSet(set);
+        return ppxres;
+    }
+
+    *ppSet = mSourceSets.emplace(pSourceBuffer, set).first->second;
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result GpuSkinner::AddInstance(const scene::MeshNode* pNode, uint32_t* pInstanceIndex)
+{
+    if (IsNull(pNode) || IsNull(pInstanceIndex) || IsNull(pNode->GetMesh()) || IsNull(pNode->GetSkin())) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    const scene::Mesh*     pMesh     = pNode->GetMesh();
+    const scene::MeshData* pMeshData = pMesh->GetMeshData();
+    if (IsNull(pMeshData) || (pMeshData->GetVertexQuantization() != scene::VERTEX_QUANTIZATION_NONE)) {
+        return ppx::ERROR_SCENE_INVALID_SOURCE_GEOMETRY_VERTEX_DATA;
+    }
+
+    const uint32_t jointCount = pNode->GetSkin()->GetJointCount();
+    if ((mJointsUsed + jointCount) > mMaxJointCount) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+
+    Instance instance   = {};
+    instance.pNode      = pNode;
+    instance.firstJoint = mJointsUsed;
+
+    uint64_t outputUsed = mOutputUsed;
+    for (const auto& batch : pMesh->GetBatches()) {
+        Batch skinnedBatch = {};
+        if (batch.IsSkinned()) {
+            const uint64_t positionSize  = static_cast<uint64_t>(batch.GetVertexCount()) * kSkinPositionSize;
+            const uint64_t attributeSize = batch.GetAttributeBufferView().size;
+            if ((outputUsed + positionSize + attributeSize) > mOutputSize) {
+                return ppx::ERROR_LIMIT_EXCEEDED;
+            }
+
+            grfx::DescriptorSet* pSet   = nullptr;
+            auto                 ppxres = GetSourceSet(batch.GetPositionBufferView().pBuffer, &pSet);
+            if (Failed(ppxres)) {
+                return ppxres;
+            }
+
+            skinnedBatch.positionOffset  = static_cast<uint32_t>(outputUsed);
+            skinnedBatch.attributeOffset = static_cast<uint32_t>(outputUsed + positionSize);
+            outputUsed += positionSize + attributeSize;
+        }
+        instance.batches.push_back(skinnedBatch);
+    }
+
+    mOutputUsed = outputUsed;
+    mJointsUsed += jointCount;
+    *pInstanceIndex = CountU32(mInstances);
+    mInstances.push_back(std::move(instance));
+
+    return ppx::SUCCESS;
+}
+
+float4x4* GpuSkinner::GetJointMatrices(uint32_t instanceIndex) const
+{
+    PPX_ASSERT_MSG(instanceIndex < CountU32(mInstances), "GpuSkinner: instance index out of range");
+    return mJointMappedAddress + mInstances[instanceIndex].firstJoint;
+}
+
+void GpuSkinner::Skin(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    pCmd->TransitionBufferState(mOutputBuffer, grfx::RESOURCE_STATE_UNORDERED_ACCESS);
+    pCmd->FlushBarriers();
+    pCmd->BindComputePipeline(mPipeline);
+
+    const grfx::DescriptorSet* pBoundSet = nullptr;
+    for (const auto& instance : mInstances) {
+        const scene::Mesh* pMesh = instance.pNode->GetMesh();
+
+        uint32_t normalOffset  = kNoAttribute;
+        uint32_t tangentOffset = kNoAttribute;
+        GetAttributeOffsets(pMesh->GetMeshData()->GetAvailableVertexAttributes(), &normalOffset, &tangentOffset);
+
+        const auto& batches = pMesh->GetBatches();
+        for (size_t i = 0; i < batches.size(); ++i) {
+            const scene::PrimitiveBatch& batch = batches[i];
+            if (!batch.IsSkinned()) {
+                continue;
+            }
+
+            const grfx::DescriptorSet* pSet = mSourceSets.at(batch.GetPositionBufferView().pBuffer).Get();
+            if (pSet != pBoundSet) {
+                pCmd->BindComputeDescriptorSets(mInterface, 1, &pSet);
+                pBoundSet = pSet;
+            }
+
+            SkinParams params         = {};
+            params.vertexCount        = batch.GetVertexCount();
+            params.positionOffset     = static_cast<uint32_t>(batch.GetPositionBufferView().offset);
+            params.attributeOffset    = static_cast<uint32_t>(batch.GetAttributeBufferView().offset);
+            params.attributeStride    = batch.GetAttributeBufferView().stride;
+            params.normalOffset       = normalOffset;
+            params.tangentOffset      = tangentOffset;
+            params.skinOffset         = static_cast<uint32_t>(batch.GetSkinBufferView().offset);
+            params.firstJoint         = instance.firstJoint;
+            params.outPositionOffset  = instance.batches[i].positionOffset;
+            params.outAttributeOffset = instance.batches[i].attributeOffset;
+            pCmd->PushComputeConstants(mInterface, sizeof(params) / sizeof(uint32_t), &params);
+
+            pCmd->Dispatch((params.vertexCount + kSkinGroupSize - 1) / kSkinGroupSize, 1, 1);
+        }
+    }
+
+    pCmd->TransitionBufferState(mOutputBuffer, grfx::RESOURCE_STATE_VERTEX_BUFFER);
+    pCmd->FlushBarriers();
+}
+
+grfx::VertexBufferView GpuSkinner::GetPositionBufferView(uint32_t instanceIndex, uint32_t batchIndex) const
+{
+    const Instance&              instance = mInstances[instanceIndex];
+    const scene::PrimitiveBatch& batch    = instance.pNode->GetMesh()->GetBatches()[batchIndex];
+    if (!batch.IsSkinned()) {
+        return batch.GetPositionBufferView();
+    }
+    return grfx::VertexBufferView(mOutputBuffer, kSkinPositionSize, instance.batches[batchIndex].positionOffset, static_cast<uint64_t>(batch.GetVertexCount()) * kSkinPositionSize);
+}
+
+grfx::VertexBufferView GpuSkinner::GetAttributeBufferView(uint32_t instanceIndex, uint32_t batchIndex) const
+{
+    const Instance&              instance = mInstances[instanceIndex];
+    const scene::PrimitiveBatch& batch    = instance.pNode->GetMesh()->GetBatches()[batchIndex];
+    if (!batch.IsSkinned() || (batch.GetAttributeBufferView().size == 0)) {
+        return batch.GetAttributeBufferView();
+    }
+    return grfx::VertexBufferView(mOutputBuffer, batch.GetAttributeBufferView().stride, instance.batches[batchIndex].attributeOffset, batch.GetAttributeBufferView().size);
+}
+
+} // namespace scene
+} // namespace ppx
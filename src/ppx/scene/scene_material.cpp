@@ -23,25 +23,75 @@ namespace scene {
 // -------------------------------------------------------------------------------------------------
 Image::Image(
     grfx::Image*            pImage,
-    grfx::SampledImageView* pImageView)
+    grfx::SampledImageView* pImageView,
+    bool                    placeholder)
     : mImage(pImage),
-      mImageView(pImageView)
+      mImageView(pImageView),
+      mPlaceholder(placeholder)
+{
+}
+
+Image::Image(
+    const scene::ImageRef& arrayImage,
+    uint32_t               arrayLayer)
+    : mArrayImage(arrayImage),
+      mArrayLayer(arrayLayer)
 {
+    PPX_ASSERT_MSG(mArrayImage && !mArrayImage->GetArrayImage(), "packed image needs a texture array");
+    PPX_ASSERT_MSG(mArrayLayer < mArrayImage->GetImage()->GetArrayLayerCount(), "array layer out of range");
 }
 
 Image::~Image()
+{
+    DestroyImage();
+}
+
+void Image::DestroyImage()
 {
     if (mImageView) {
         auto pDevice = mImageView->GetDevice();
         pDevice->DestroySampledImageView(mImageView);
+        mImageView.Reset();
     }
 
     if (mImage) {
         auto pDevice = mImage->GetDevice();
         pDevice->DestroyImage(mImage);
+        mImage.Reset();
     }
 }
 
+void Image::SetImage(
+    grfx::Image*            pImage,
+    grfx::SampledImageView* pImageView)
+{
+    PPX_ASSERT_MSG(!mArrayImage, "packed images can't be replaced");
+
+    DestroyImage();
+
+    mImage       = pImage;
+    mImageView   = pImageView;
+    mPlaceholder = false;
+}
+
+void Image::SwapImage(
+    grfx::Image*               pImage,
+    grfx::SampledImageView*    pImageView,
+    grfx::ImagePtr*            pOldImage,
+    grfx::SampledImageViewPtr* pOldImageView)
+{
+    PPX_ASSERT_MSG(!mArrayImage, "packed images can't be replaced");
+    PPX_ASSERT_NULL_ARG(pOldImage);
+    PPX_ASSERT_NULL_ARG(pOldImageView);
+
+    *pOldImage     = mImage;
+    *pOldImageView = mImageView;
+
+    mImage       = pImage;
+    mImageView   = pImageView;
+    mPlaceholder = false;
+}
+
 // -------------------------------------------------------------------------------------------------
 // Sampler
 // -------------------------------------------------------------------------------------------------
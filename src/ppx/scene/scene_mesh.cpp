@@ -14,6 +14,7 @@
 
 #include "ppx/scene/scene_mesh.h"
 #include "ppx/grfx/grfx_device.h"
+#include "ppx/camera.h"
 
 namespace ppx {
 namespace scene {
@@ -23,17 +24,23 @@ namespace scene {
 // -------------------------------------------------------------------------------------------------
 MeshData::MeshData(
     const scene::VertexAttributeFlags& availableVertexAttributes,
-    grfx::Buffer*                      pGpuBuffer)
+    grfx::Buffer*                      pGpuBuffer,
+    scene::VertexQuantization          quantization,
+    const scene::VertexDequantization& dequantization)
     : mAvailableVertexAttributes(availableVertexAttributes),
+      mVertexQuantization(quantization),
+      mVertexDequantization(dequantization),
       mGpuBuffer(pGpuBuffer)
 {
+    const scene::VertexFormats formats = scene::VertexFormats::Get(quantization);
+
     // Position
     auto positionBinding = grfx::VertexBinding(0, grfx::VERTEX_INPUT_RATE_VERTEX);
     {
         grfx::VertexAttribute attr = {};
         attr.semanticName          = "POSITION";
         attr.location              = scene::kVertexPositionLocation;
-        attr.format                = scene::kVertexPositionFormat;
+        attr.format                = formats.position;
         attr.binding               = scene::kVertexPositionBinding;
         attr.offset                = PPX_APPEND_OFFSET_ALIGNED;
         attr.inputRate             = grfx::VERTEX_INPUT_RATE_VERTEX;
@@ -54,7 +61,7 @@ MeshData::MeshData(
             grfx::VertexAttribute attr = {};
             attr.semanticName          = "TEXCOORD";
             attr.location              = scene::kVertexAttributeTexCoordLocation;
-            attr.format                = scene::kVertexAttributeTexCoordFormat;
+            attr.format                = formats.texCoord;
             attr.binding               = scene::kVertexAttributeBinding;
             attr.offset                = PPX_APPEND_OFFSET_ALIGNED;
             attr.inputRate             = grfx::VERTEX_INPUT_RATE_VERTEX;
@@ -67,7 +74,7 @@ MeshData::MeshData(
             grfx::VertexAttribute attr = {};
             attr.semanticName          = "NORMAL";
             attr.location              = scene::kVertexAttributeNormalLocation;
-            attr.format                = scene::kVertexAttributeNormalFormat;
+            attr.format                = formats.normal;
             attr.binding               = scene::kVertexAttributeBinding;
             attr.offset                = PPX_APPEND_OFFSET_ALIGNED;
             attr.inputRate             = grfx::VERTEX_INPUT_RATE_VERTEX;
@@ -80,7 +87,7 @@ MeshData::MeshData(
             grfx::VertexAttribute attr = {};
             attr.semanticName          = "TANGENT";
             attr.location              = scene::kVertexAttributeTangentLocation;
-            attr.format                = scene::kVertexAttributeTagentFormat;
+            attr.format                = formats.tangent;
             attr.binding               = scene::kVertexAttributeBinding;
             attr.offset                = PPX_APPEND_OFFSET_ALIGNED;
             attr.inputRate             = grfx::VERTEX_INPUT_RATE_VERTEX;
@@ -93,7 +100,7 @@ MeshData::MeshData(
             grfx::VertexAttribute attr = {};
             attr.semanticName          = "COLOR";
             attr.location              = scene::kVertexAttributeColorLocation;
-            attr.format                = scene::kVertexAttributeColorFormat;
+            attr.format                = formats.color;
             attr.binding               = scene::kVertexAttributeBinding;
             attr.offset                = PPX_APPEND_OFFSET_ALIGNED;
             attr.inputRate             = grfx::VERTEX_INPUT_RATE_VERTEX;
@@ -104,14 +111,37 @@ MeshData::MeshData(
     mVertexBindings.push_back(attributeBinding);
 }
 
+MeshData::MeshData(
+    const scene::VertexAttributeFlags& availableVertexAttributes,
+    grfx::BufferPool*                  pBufferPool,
+    const grfx::BufferRange&           gpuBufferRange,
+    scene::VertexQuantization          quantization,
+    const scene::VertexDequantization& dequantization)
+    : MeshData(availableVertexAttributes, gpuBufferRange.pBuffer, quantization, dequantization)
+{
+    mBufferPool     = pBufferPool;
+    mGpuBufferRange = gpuBufferRange;
+}
+
 MeshData::~MeshData()
 {
-    if (mGpuBuffer) {
+    if (!IsNull(mBufferPool)) {
+        mBufferPool->Free(mGpuBufferRange);
+    }
+    else if (mGpuBuffer) {
         auto pDevice = mGpuBuffer->GetDevice();
         pDevice->DestroyBuffer(mGpuBuffer);
     }
 }
 
+uint64_t MeshData::GetGpuBufferSize() const
+{
+    if (!IsNull(mBufferPool)) {
+        return mGpuBufferRange.size;
+    }
+    return mGpuBuffer ? mGpuBuffer->GetSize() : 0;
+}
+
 // -------------------------------------------------------------------------------------------------
 // PrimitiveBatch
 // -------------------------------------------------------------------------------------------------
@@ -122,15 +152,68 @@ PrimitiveBatch::PrimitiveBatch(
     const grfx::VertexBufferView& attributeBufferView,
     uint32_t                      indexCount,
     uint32_t                      vertexCount,
-    const ppx::AABB&              boundingBox)
+    const ppx::AABB&              boundingBox,
+    const grfx::VertexBufferView& skinBufferView)
     : mMaterial(material),
       mIndexBufferView(indexBufferView),
       mPositionBufferView(positionBufferView),
       mAttributeBufferView(attributeBufferView),
+      mSkinBufferView(skinBufferView),
       mIndexCount(indexCount),
       mVertexCount(vertexCount),
-      mBoundingBox(boundingBox)
+      mBoundingBox(boundingBox),
+      mLods(1, ppx::MeshLod{0, indexCount, 0})
+{
+}
+
+void PrimitiveBatch::SetLods(const std::vector<ppx::MeshLod>& lods)
 {
+    PPX_ASSERT_MSG(!lods.empty() && (lods[0].firstIndex == 0) && (lods[0].indexCount == mIndexCount), "LOD 0 must be the batch's indices");
+    mLods = lods;
+}
+
+uint32_t PrimitiveBatch::SelectLod(float pixelsPerUnit, float maxPixelError) const
+{
+    // Errors grow with the LOD index
+    uint32_t lod = 0;
+    while (((lod + 1) < GetLodCount()) && ((mLods[lod + 1].error * pixelsPerUnit) <= maxPixelError)) {
+        ++lod;
+    }
+    return lod;
+}
+
+grfx::AccelerationStructureTriangles PrimitiveBatch::GetAccelerationStructureTriangles() const
+{
+    grfx::AccelerationStructureTriangles triangles = {};
+    triangles.pVertexBuffer                        = mPositionBufferView.pBuffer;
+    triangles.vertexOffset                         = mPositionBufferView.offset;
+    triangles.vertexStride                         = mPositionBufferView.stride;
+    triangles.vertexCount                          = mVertexCount;
+    triangles.vertexFormat                         = grfx::FORMAT_R32G32B32_FLOAT;
+
+    if ((mIndexCount > 0) && !IsNull(mIndexBufferView.pBuffer)) {
+        triangles.pIndexBuffer = mIndexBufferView.pBuffer;
+        triangles.indexOffset  = mIndexBufferView.offset;
+        triangles.indexType    = mIndexBufferView.indexType;
+        triangles.indexCount   = mIndexCount;
+    }
+
+    return triangles;
+}
+
+float CalculateLodPixelsPerUnit(
+    const float4x4&    modelMatrix,
+    const ppx::AABB&   boundingBox,
+    const ppx::Camera& camera,
+    float              viewportHeight)
+{
+    const float  scale  = std::max(glm::length(float3(modelMatrix[0])), std::max(glm::length(float3(modelMatrix[1])), glm::length(float3(modelMatrix[2]))));
+    const float3 center = float3(modelMatrix * float4(boundingBox.GetCenter(), 1));
+    const float  radius = scale * 0.5f * glm::length(boundingBox.GetMax() - boundingBox.GetMin());
+
+    // Inside the sphere the near plane is the closest a point can be
+    const float distance = std::max(glm::distance(center, camera.GetEyePosition()) - radius, camera.GetNearClip());
+    return scale * std::abs(camera.GetProjectionMatrix()[1][1]) * 0.5f * viewportHeight / distance;
 }
 
 // -------------------------------------------------------------------------------------------------
@@ -210,5 +293,15 @@ std::vector<const scene::Material*> Mesh::GetMaterials() const
     return materials;
 }
 
+std::vector<grfx::AccelerationStructureTriangles> Mesh::GetAccelerationStructureTriangles() const
+{
+    std::vector<grfx::AccelerationStructureTriangles> geometries;
+    geometries.reserve(mBatches.size());
+    for (const auto& batch : mBatches) {
+        geometries.push_back(batch.GetAccelerationStructureTriangles());
+    }
+    return geometries;
+}
+
 } // namespace scene
 } // namespace ppx
@@ -0,0 +1,317 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_motion_vectors.h"
+#include "ppx/scene/scene_mesh.h"
+#include "ppx/scene/scene_node.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/util.h"
+
+namespace ppx {
+namespace scene {
+
+// Registers in MotionVectors.hlsl
+enum
+{
+    MOTION_VECTOR_DRAW_REGISTER      = 0,
+    MOTION_VECTOR_VIEWS_REGISTER     = 1,
+    MOTION_VECTOR_INSTANCES_REGISTER = 2,
+};
+
+// -------------------------------------------------------------------------------------------------
+// MotionVectorRenderer
+// -------------------------------------------------------------------------------------------------
+MotionVectorRenderer::MotionVectorRenderer()
+{
+}
+
+MotionVectorRenderer::~MotionVectorRenderer()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    if (mPipeline) {
+        mDevice->DestroyGraphicsPipeline(mPipeline);
+        mPipeline.Reset();
+    }
+
+    if (mInterface) {
+        mDevice->DestroyPipelineInterface(mInterface);
+        mInterface.Reset();
+    }
+
+    if (mSet) {
+        mDevice->FreeDescriptorSet(mSet);
+        mSet.Reset();
+    }
+
+    if (mSetLayout) {
+        mDevice->DestroyDescriptorSetLayout(mSetLayout);
+        mSetLayout.Reset();
+    }
+
+    if (mDescriptorPool) {
+        mDevice->DestroyDescriptorPool(mDescriptorPool);
+        mDescriptorPool.Reset();
+    }
+
+    if (mViewBuffer) {
+        if (!IsNull(mViewMappedAddress)) {
+            mViewBuffer->UnmapMemory();
+        }
+        mDevice->DestroyBuffer(mViewBuffer);
+        mViewBuffer.Reset();
+    }
+
+    if (mInstanceBuffer) {
+        if (!IsNull(mInstanceMappedAddress)) {
+            mInstanceBuffer->UnmapMemory();
+        }
+        mDevice->DestroyBuffer(mInstanceBuffer);
+        mInstanceBuffer.Reset();
+    }
+}
+
+ppx::Result MotionVectorRenderer::Create(grfx::Device* pDevice, const scene::MotionVectorRendererCreateInfo& createInfo, scene::MotionVectorRenderer** ppRenderer)
+{
+    if (IsNull(pDevice) || IsNull(ppRenderer) || IsNull(createInfo.pVertexShader) || IsNull(createInfo.pPixelShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.maxDraws == 0) || (createInfo.colorFormat == grfx::FORMAT_UNDEFINED)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    scene::MotionVectorRenderer* pRenderer = new scene::MotionVectorRenderer();
+    if (IsNull(pRenderer)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    auto ppxres = pRenderer->InitializeResources(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pRenderer;
+        return ppxres;
+    }
+
+    *ppRenderer = pRenderer;
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result MotionVectorRenderer::InitializeResources(grfx::Device* pDevice, const scene::MotionVectorRendererCreateInfo& createInfo)
+{
+    mDevice   = pDevice;
+    mMaxDraws = createInfo.maxDraws;
+
+    // Buffers, written every frame
+    {
+        grfx::BufferCreateInfo bufferCreateInfo        = {};
+        bufferCreateInfo.size                          = RoundUp<uint64_t>(sizeof(ViewMatrices), PPX_CONSTANT_BUFFER_ALIGNMENT);
+        bufferCreateInfo.usageFlags.bits.uniformBuffer = true;
+        bufferCreateInfo.memoryUsage                   = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        auto ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mViewBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pViewAddress = nullptr;
+        ppxres             = mViewBuffer->MapMemory(0, &pViewAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mViewMappedAddress = static_cast<ViewMatrices*>(pViewAddress);
+
+        bufferCreateInfo                                    = {};
+        bufferCreateInfo.size                               = mMaxDraws * sizeof(InstanceMatrices);
+        bufferCreateInfo.structuredElementStride            = sizeof(InstanceMatrices);
+        bufferCreateInfo.usageFlags.bits.roStructuredBuffer = true;
+        bufferCreateInfo.memoryUsage                        = grfx::MEMORY_USAGE_CPU_TO_GPU;
+
+        ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mInstanceBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        void* pInstanceAddress = nullptr;
+        ppxres                 = mInstanceBuffer->MapMemory(0, &pInstanceAddress);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        mInstanceMappedAddress = static_cast<InstanceMatrices*>(pInstanceAddress);
+    }
+
+    // Descriptors
+    {
+        grfx::DescriptorPoolCreateInfo poolCreateInfo = {};
+        poolCreateInfo.uniformBuffer                  = 1;
+        poolCreateInfo.structuredBuffer               = 1;
+
+        auto ppxres = pDevice->CreateDescriptorPool(&poolCreateInfo, &mDescriptorPool);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        grfx::DescriptorSetLayoutCreateInfo layoutCreateInfo = {};
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(MOTION_VECTOR_VIEWS_REGISTER, grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER));
+        layoutCreateInfo.bindings.push_back(grfx::DescriptorBinding(MOTION_VECTOR_INSTANCES_REGISTER, grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER));
+
+        ppxres = pDevice->CreateDescriptorSetLayout(&layoutCreateInfo, &mSetLayout);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        ppxres = pDevice->AllocateDescriptorSet(mDescriptorPool, mSetLayout, &mSet);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        std::array<grfx::WriteDescriptor, 2> writes = {};
+
+        writes[0].binding      = MOTION_VECTOR_VIEWS_REGISTER;
+        writes[0].type         = grfx::DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[0].bufferOffset = 0;
+        writes[0].bufferRange  = PPX_WHOLE_SIZE;
+        writes[0].pBuffer      = mViewBuffer;
+
+        writes[1].binding                = MOTION_VECTOR_INSTANCES_REGISTER;
+        writes[1].type                   = grfx::DESCRIPTOR_TYPE_RO_STRUCTURED_BUFFER;
+        writes[1].bufferOffset           = 0;
+        writes[1].bufferRange            = PPX_WHOLE_SIZE;
+        writes[1].structuredElementCount = mMaxDraws;
+        writes[1].pBuffer                = mInstanceBuffer;
+
+        ppxres = mSet->UpdateDescriptors(static_cast<uint32_t>(writes.size()), writes.data());
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Pipeline
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.setCount                          = 1;
+        piCreateInfo.sets[0].set                       = 0;
+        piCreateInfo.sets[0].pLayout                   = mSetLayout;
+        piCreateInfo.pushConstants.count               = 1;
+        piCreateInfo.pushConstants.binding             = MOTION_VECTOR_DRAW_REGISTER;
+        piCreateInfo.pushConstants.set                 = 0;
+
+        auto ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mInterface);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        // Positions only, the motion of all other attributes is the same
+        grfx::VertexAttribute positionAttribute = {};
+        positionAttribute.semanticName          = "POSITION";
+        positionAttribute.location              = 0;
+        positionAttribute.format                = scene::kVertexPositionFormat;
+        positionAttribute.binding               = 0;
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {createInfo.pVertexShader, "vsmain"};
+        gpCreateInfo.PS                                 = {createInfo.pPixelShader, "psmain"};
+        gpCreateInfo.vertexInputState.bindingCount      = 1;
+        gpCreateInfo.vertexInputState.bindings[0]       = grfx::VertexBinding(positionAttribute);
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = true;
+        gpCreateInfo.depthWriteEnable                   = true;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = 1;
+        gpCreateInfo.outputState.renderTargetFormats[0] = createInfo.colorFormat;
+        gpCreateInfo.outputState.depthStencilFormat     = createInfo.depthFormat;
+        gpCreateInfo.pPipelineInterface                 = mInterface;
+        gpCreateInfo.multiViewState.viewMask            = createInfo.viewMask;
+        gpCreateInfo.multiViewState.correlationMask     = createInfo.viewMask;
+
+        ppxres = pDevice->CreateGraphicsPipeline(&gpCreateInfo, &mPipeline);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+void MotionVectorRenderer::BeginFrame()
+{
+    ++mFrame;
+    mDrawCount = 0;
+
+    for (uint32_t viewIndex = 0; viewIndex < MAX_VIEWS; ++viewIndex) {
+        mViewMappedAddress->prevViewProjectionMatrix[viewIndex] = mViewMappedAddress->viewProjectionMatrix[viewIndex];
+    }
+}
+
+void MotionVectorRenderer::SetCamera(uint32_t viewIndex, const ppx::Camera& camera)
+{
+    PPX_ASSERT_MSG(viewIndex < MAX_VIEWS, "MotionVectorRenderer: view index out of range");
+
+    mViewMappedAddress->viewProjectionMatrix[viewIndex] = camera.GetViewProjectionMatrix();
+    // No camera motion on the first frame
+    if (!mViewsSet[viewIndex]) {
+        mViewMappedAddress->prevViewProjectionMatrix[viewIndex] = camera.GetViewProjectionMatrix();
+        mViewsSet[viewIndex]                                    = true;
+    }
+}
+
+void MotionVectorRenderer::Draw(grfx::CommandBuffer* pCmd, const scene::MeshNode* pNode)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_NULL_ARG(pNode);
+
+    const scene::Mesh* pMesh = pNode->GetMesh();
+    if (IsNull(pMesh) || IsNull(pMesh->GetMeshData())) {
+        return;
+    }
+    PPX_ASSERT_MSG(pMesh->GetMeshData()->GetVertexQuantization() == scene::VERTEX_QUANTIZATION_NONE, "MotionVectorRenderer: quantized positions aren't supported");
+    if (mDrawCount >= mMaxDraws) {
+        PPX_ASSERT_MSG(false, "MotionVectorRenderer: more draws than MotionVectorRendererCreateInfo::maxDraws");
+        return;
+    }
+
+    // Views drawn separately see the same matrices within a frame
+    const float4x4& modelMatrix = pNode->GetEvaluatedMatrix();
+    auto            it          = mNodeMatrices.find(pNode);
+    if (it == mNodeMatrices.end()) {
+        it = mNodeMatrices.emplace(pNode, NodeMatrices{modelMatrix, modelMatrix, mFrame}).first;
+    }
+    else if (it->second.frame != mFrame) {
+        it->second.previous = it->second.current;
+        it->second.current  = modelMatrix;
+        it->second.frame    = mFrame;
+    }
+
+    const uint32_t instanceIndex                          = mDrawCount++;
+    mInstanceMappedAddress[instanceIndex].modelMatrix     = it->second.current;
+    mInstanceMappedAddress[instanceIndex].prevModelMatrix = it->second.previous;
+
+    const grfx::DescriptorSet* pSet = mSet.Get();
+    pCmd->BindGraphicsPipeline(mPipeline);
+    pCmd->BindGraphicsDescriptorSets(mInterface, 1, &pSet);
+    pCmd->PushGraphicsConstants(mInterface, 1, &instanceIndex);
+
+    for (const auto& batch : pMesh->GetBatches()) {
+        pCmd->BindIndexBuffer(&batch.GetIndexBufferView());
+        pCmd->BindVertexBuffers(1, &batch.GetPositionBufferView());
+        pCmd->DrawIndexed(batch.GetIndexCount(), 1, 0, 0, 0);
+    }
+}
+
+} // namespace scene
+} // namespace ppx
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "ppx/scene/scene_node.h"
+#include "ppx/scene/scene_transform_hierarchy.h"
 
 namespace ppx {
 namespace scene {
@@ -41,6 +42,12 @@ void Node::SetVisible(bool visible, bool recursive)
 
 const float4x4& Node::GetEvaluatedMatrix() const
 {
+    if (!IsNull(mHierarchy)) {
+        // Updating can rebuild the hierarchy and move this node
+        mHierarchy->UpdateWorldMatrices();
+        return mHierarchy->GetWorldMatrix(mHierarchyIndex);
+    }
+
     if (mEvaluatedDirty) {
         float4x4 parentEvaluatedMatrix = float4x4(1);
         if (!IsNull(mParent)) {
@@ -56,11 +63,26 @@ const float4x4& Node::GetEvaluatedMatrix() const
 void Node::SetParent(scene::Node* pNewParent)
 {
     mParent = pNewParent;
+    if (!IsNull(mHierarchy)) {
+        mHierarchy->SetTopologyDirty();
+    }
     SetEvaluatedDirty();
 }
 
 void Node::SetEvaluatedDirty()
 {
+    // The hierarchy propagates to children in it on update, only the ones
+    // outside it evaluate lazily
+    if (!IsNull(mHierarchy)) {
+        mHierarchy->SetLocalDirty(mHierarchyIndex);
+        for (auto& pChild : mChildren) {
+            if (IsNull(pChild->mHierarchy)) {
+                pChild->SetEvaluatedDirty();
+            }
+        }
+        return;
+    }
+
     mEvaluatedDirty = true;
     for (auto& pChild : mChildren) {
         pChild->SetEvaluatedDirty();
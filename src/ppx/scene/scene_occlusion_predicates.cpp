@@ -0,0 +1,291 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_occlusion_predicates.h"
+#include "ppx/grfx/grfx_device.h"
+
+#include <cstddef>
+
+namespace ppx {
+namespace scene {
+
+#define PROXY_PARAMS_REGISTER 0
+
+// Box corners per proxy draw, see OcclusionProxy.hlsl
+static const uint32_t kProxyVertexCount = 36;
+
+// Must match OcclusionProxy.hlsl
+struct ProxyParams
+{
+    float4x4 viewProjectionMatrix; // offset = 0
+    float4   boundsMin;            // offset = 64
+    float4   boundsMax;            // offset = 80
+};
+
+static const uint32_t kViewProjectionConstantCount = sizeof(float4x4) / sizeof(uint32_t);
+static const uint32_t kBoundsConstantOffset        = offsetof(ProxyParams, boundsMin) / sizeof(uint32_t);
+static const uint32_t kBoundsConstantCount         = (sizeof(ProxyParams) - offsetof(ProxyParams, boundsMin)) / sizeof(uint32_t);
+
+// -------------------------------------------------------------------------------------------------
+// OcclusionPredicates
+// -------------------------------------------------------------------------------------------------
+OcclusionPredicates::OcclusionPredicates()
+{
+}
+
+OcclusionPredicates::~OcclusionPredicates()
+{
+    if (IsNull(mDevice)) {
+        return;
+    }
+
+    if (mPredicateBuffer) {
+        mDevice->DestroyBuffer(mPredicateBuffer);
+        mPredicateBuffer.Reset();
+    }
+
+    for (auto& query : mQueries) {
+        if (query) {
+            mDevice->DestroyQuery(query);
+            query.Reset();
+        }
+    }
+
+    if (mProxyPipeline) {
+        mDevice->DestroyGraphicsPipeline(mProxyPipeline);
+        mProxyPipeline.Reset();
+    }
+
+    if (mInterface) {
+        mDevice->DestroyPipelineInterface(mInterface);
+        mInterface.Reset();
+    }
+}
+
+ppx::Result OcclusionPredicates::Create(grfx::Device* pDevice, const scene::OcclusionPredicatesCreateInfo& createInfo, scene::OcclusionPredicates** ppPredicates)
+{
+    if (IsNull(pDevice) || IsNull(ppPredicates)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (IsNull(createInfo.pProxyShader)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if (createInfo.maxObjectCount == 0) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+    if (!pDevice->ConditionalRenderingSupported()) {
+        return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+    }
+
+    scene::OcclusionPredicates* pPredicates = new scene::OcclusionPredicates();
+    if (IsNull(pPredicates)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    auto ppxres = pPredicates->InitializeResources(pDevice, createInfo);
+    if (Failed(ppxres)) {
+        delete pPredicates;
+        return ppxres;
+    }
+
+    *ppPredicates = pPredicates;
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result OcclusionPredicates::InitializeResources(grfx::Device* pDevice, const scene::OcclusionPredicatesCreateInfo& createInfo)
+{
+    mDevice         = pDevice;
+    mMaxObjectCount = createInfo.maxObjectCount;
+
+    // Queries
+    for (auto& query : mQueries) {
+        grfx::QueryCreateInfo queryCreateInfo = {};
+        queryCreateInfo.type                  = grfx::QUERY_TYPE_OCCLUSION;
+        queryCreateInfo.count                 = mMaxObjectCount;
+
+        auto ppxres = pDevice->CreateQuery(&queryCreateInfo, &query);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Predicates, written by the GPU only
+    {
+        grfx::BufferCreateInfo bufferCreateInfo               = {};
+        bufferCreateInfo.size                                 = mMaxObjectCount * PPX_OCCLUSION_PREDICATE_SIZE;
+        bufferCreateInfo.usageFlags.bits.conditionalRendering = true;
+        bufferCreateInfo.usageFlags.bits.transferDst          = true;
+        bufferCreateInfo.memoryUsage                          = grfx::MEMORY_USAGE_GPU_ONLY;
+        bufferCreateInfo.initialState                         = grfx::RESOURCE_STATE_PREDICATION;
+
+        auto ppxres = pDevice->CreateBuffer(&bufferCreateInfo, &mPredicateBuffer);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    // Proxy pipeline, depth test only
+    {
+        grfx::PipelineInterfaceCreateInfo piCreateInfo = {};
+        piCreateInfo.pushConstants.count               = sizeof(ProxyParams) / sizeof(uint32_t);
+        piCreateInfo.pushConstants.binding             = PROXY_PARAMS_REGISTER;
+        piCreateInfo.pushConstants.set                 = 0;
+
+        auto ppxres = pDevice->CreatePipelineInterface(&piCreateInfo, &mInterface);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        const bool hasColor = (createInfo.colorFormat != grfx::FORMAT_UNDEFINED);
+
+        grfx::GraphicsPipelineCreateInfo2 gpCreateInfo  = {};
+        gpCreateInfo.VS                                 = {createInfo.pProxyShader, "vsmain"};
+        gpCreateInfo.topology                           = grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        gpCreateInfo.polygonMode                        = grfx::POLYGON_MODE_FILL;
+        gpCreateInfo.cullMode                           = grfx::CULL_MODE_NONE;
+        gpCreateInfo.frontFace                          = grfx::FRONT_FACE_CCW;
+        gpCreateInfo.depthReadEnable                    = true;
+        gpCreateInfo.depthWriteEnable                   = false;
+        gpCreateInfo.depthCompareOp                     = createInfo.depthCompareOp;
+        gpCreateInfo.blendModes[0]                      = grfx::BLEND_MODE_NONE;
+        gpCreateInfo.outputState.renderTargetCount      = hasColor ? 1 : 0;
+        gpCreateInfo.outputState.renderTargetFormats[0] = createInfo.colorFormat;
+        gpCreateInfo.outputState.depthStencilFormat     = createInfo.depthFormat;
+        gpCreateInfo.pPipelineInterface                 = mInterface;
+
+        // The render target stays bound for the pass, but isn't written
+        grfx::GraphicsPipelineCreateInfo fullCreateInfo = {};
+        grfx::internal::FillOutGraphicsPipelineCreateInfo(&gpCreateInfo, &fullCreateInfo);
+        if (hasColor) {
+            fullCreateInfo.colorBlendState.blendAttachments[0].colorWriteMask = grfx::ColorComponentFlags(0);
+        }
+
+        ppxres = pDevice->CreateGraphicsPipeline(&fullCreateInfo, &mProxyPipeline);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result OcclusionPredicates::SetObjects(uint32_t count, const ppx::AABB* pBounds)
+{
+    if (count > mMaxObjectCount) {
+        return ppx::ERROR_LIMIT_EXCEEDED;
+    }
+    if ((count > 0) && IsNull(pBounds)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    mObjectBounds.assign(pBounds, pBounds + count);
+
+    // Results of the previous objects don't apply
+    mFrame = 0;
+
+    return ppx::SUCCESS;
+}
+
+void OcclusionPredicates::BeginFrame(grfx::CommandBuffer* pCmd, const ppx::Camera& camera)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    mEyePosition          = camera.GetEyePosition();
+    mNearClip             = camera.GetNearClip();
+    mViewProjectionMatrix = camera.GetViewProjectionMatrix();
+    mPredicatedCount      = 0;
+
+    const uint32_t objectCount = GetObjectCount();
+    if (objectCount == 0) {
+        return;
+    }
+
+    // Every object's query was written in the previous frame, so the
+    // resolve never waits on a query that wasn't issued
+    if (mFrame > 0) {
+        pCmd->ResolveOcclusionPredicates(mQueries[(mFrame - 1) % 2], 0, objectCount, mPredicateBuffer, 0);
+    }
+
+    // Results of this frame's queries were resolved by the previous frame,
+    // which has completed
+    mQueries[mFrame % 2]->Reset(0, objectCount);
+
+    ++mFrame;
+}
+
+void OcclusionPredicates::BeginObject(grfx::CommandBuffer* pCmd, uint32_t objectIndex)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_MSG(objectIndex < GetObjectCount(), "invalid object index");
+    PPX_ASSERT_MSG(!mConditional, "BeginObject() can't be nested");
+
+    // No predicates until the queries of a frame were resolved
+    if (mFrame < 2) {
+        return;
+    }
+
+    // The near plane clips the proxy when the eye is inside of it or close
+    // to its faces, so the object would count as occluded
+    const ppx::AABB& bounds = mObjectBounds[objectIndex];
+    const float3     margin = float3(2.0f * mNearClip);
+    if (glm::all(glm::greaterThanEqual(mEyePosition, bounds.GetMin() - margin)) && glm::all(glm::lessThanEqual(mEyePosition, bounds.GetMax() + margin))) {
+        return;
+    }
+
+    pCmd->BeginConditionalRendering(mPredicateBuffer, objectIndex * PPX_OCCLUSION_PREDICATE_SIZE);
+    mConditional = true;
+    ++mPredicatedCount;
+}
+
+void OcclusionPredicates::EndObject(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+
+    if (mConditional) {
+        pCmd->EndConditionalRendering();
+        mConditional = false;
+    }
+}
+
+void OcclusionPredicates::DrawProxies(grfx::CommandBuffer* pCmd)
+{
+    PPX_ASSERT_NULL_ARG(pCmd);
+    PPX_ASSERT_MSG(!mConditional, "DrawProxies() must be recorded after EndObject()");
+    PPX_ASSERT_MSG(mFrame > 0, "DrawProxies() must be recorded after BeginFrame()");
+
+    const uint32_t objectCount = GetObjectCount();
+    if (objectCount == 0) {
+        return;
+    }
+
+    const grfx::Query* pQuery = mQueries[(mFrame - 1) % 2];
+
+    pCmd->BindGraphicsPipeline(mProxyPipeline);
+    pCmd->PushGraphicsConstants(mInterface, kViewProjectionConstantCount, &mViewProjectionMatrix, 0);
+
+    for (uint32_t objectIndex = 0; objectIndex < objectCount; ++objectIndex) {
+        const ppx::AABB& bounds = mObjectBounds[objectIndex];
+
+        const float4 params[2] = {float4(bounds.GetMin(), 0), float4(bounds.GetMax(), 0)};
+        pCmd->PushGraphicsConstants(mInterface, kBoundsConstantCount, params, kBoundsConstantOffset);
+
+        pCmd->BeginQuery(pQuery, objectIndex);
+        pCmd->Draw(kProxyVertexCount, 1, 0, 0);
+        pCmd->EndQuery(pQuery, objectIndex);
+    }
+}
+
+} // namespace scene
+} // namespace ppx
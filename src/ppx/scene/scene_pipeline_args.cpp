@@ -19,6 +19,8 @@
 #include "ppx/application.h"
 #include "ppx/graphics_util.h"
 
+#include <algorithm>
+
 namespace ppx {
 namespace scene {
 
@@ -32,6 +34,7 @@ void CopyMaterialTextureParams(
     dstTextureParams.samplerIndex      = UINT32_MAX;
     dstTextureParams.textureIndex      = UINT32_MAX;
     dstTextureParams.texCoordTransform = srcTextureView.GetTexCoordTransform();
+    dstTextureParams.arrayLayer        = 0;
 
     // Bail if we don't have a texture
     if (IsNull(srcTextureView.GetTexture())) {
@@ -43,6 +46,7 @@ void CopyMaterialTextureParams(
     if ((itSampler != samplersIndexMap.end()) && (itImage != imagesIndexMap.end())) {
         dstTextureParams.samplerIndex = itSampler->second;
         dstTextureParams.textureIndex = itImage->second;
+        dstTextureParams.arrayLayer   = itImage->first->GetArrayLayer();
     }
 }
 
@@ -319,12 +323,13 @@ ppx::Result MaterialPipelineArgs::InitializeBuffers(grfx::Device* pDevice)
     static_assert((sizeof(scene::FrameParams) == FRAME_PARAMS_STRUCT_SIZE), "Invalid size for FrameParams");
     static_assert((sizeof(scene::CameraParams) == CAMERA_PARAMS_STRUCT_SIZE), "Invalid size for CameraParams");
     static_assert((sizeof(scene::InstanceParams) == INSTANCE_PARAMS_STRUCT_SIZE), "Invalid size for InstanceParams");
+    static_assert((sizeof(scene::MaterialTextureParams) == MATERIAL_TEXTURE_PARAMS_STRUCT_SIZE), "Invalid size for MaterialTextureParams");
     static_assert((sizeof(scene::MaterialParams) == MATERIAL_PARAMS_STRUCT_SIZE), "Invalid size for MaterialParams");
 
     // ConstantBuffers
     {
         mFrameParamsPaddedSize  = RoundUp<uint32_t>(FRAME_PARAMS_STRUCT_SIZE, 256);
-        mCameraParamsPaddedSize = RoundUp<uint32_t>(CAMERA_PARAMS_STRUCT_SIZE, 256);
+        mCameraParamsPaddedSize = RoundUp<uint32_t>(MAX_VIEWS * CAMERA_PARAMS_STRUCT_SIZE, 256);
 
         mFrameParamsOffset  = 0;
         mCameraParamsOffset = mFrameParamsPaddedSize;
@@ -375,10 +380,11 @@ ppx::Result MaterialPipelineArgs::InitializeBuffers(grfx::Device* pDevice)
             return ppxres;
         }
 
-        // GPU buffer
-        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
-        createInfo.usageFlags.bits.transferSrc = false;
-        createInfo.usageFlags.bits.transferDst = true;
+        // GPU buffer, also addressable so draws can pass it in push constants
+        createInfo.memoryUsage                         = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.usageFlags.bits.transferSrc         = false;
+        createInfo.usageFlags.bits.transferDst         = true;
+        createInfo.usageFlags.bits.shaderDeviceAddress = pDevice->BufferDeviceAddressSupported();
         //
         ppxres = pDevice->CreateBuffer(&createInfo, &mGpuInstanceParamsBuffer);
         if (Failed(ppxres)) {
@@ -405,10 +411,11 @@ ppx::Result MaterialPipelineArgs::InitializeBuffers(grfx::Device* pDevice)
             return ppxres;
         }
 
-        // GPU buffer
-        createInfo.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
-        createInfo.usageFlags.bits.transferSrc = false;
-        createInfo.usageFlags.bits.transferDst = true;
+        // GPU buffer, addressable like the instance params
+        createInfo.memoryUsage                         = grfx::MEMORY_USAGE_GPU_ONLY;
+        createInfo.usageFlags.bits.transferSrc         = false;
+        createInfo.usageFlags.bits.transferDst         = true;
+        createInfo.usageFlags.bits.shaderDeviceAddress = pDevice->BufferDeviceAddressSupported();
         //
         ppxres = pDevice->CreateBuffer(&createInfo, &mGpuMateriaParamsBuffer);
         if (Failed(ppxres)) {
@@ -638,6 +645,17 @@ ppx::Result MaterialPipelineArgs::InitializeResource(grfx::Device* pDevice)
         return ppxres;
     }
 
+    // Everything is copied on the first CopyBuffers()
+    mDirtyInstances.flags.resize(MAX_DRAWABLE_INSTANCES, 0);
+    mDirtyMaterials.flags.resize(MAX_UNIQUE_MATERIALS, 0);
+    mDirtyInstances.MarkAll();
+    mDirtyMaterials.MarkAll();
+
+    // Unquantized meshes don't set the dequantization
+    for (uint32_t i = 0; i < MAX_DRAWABLE_INSTANCES; ++i) {
+        SetVertexDequantization(i, scene::VertexDequantization{});
+    }
+
     // Get instance params mapped address
     ppxres = mCpuMateriaParamsBuffer->MapMemory(0, reinterpret_cast<void**>(&mMaterialParamsMappedAddress));
     if (Failed(ppxres)) {
@@ -668,11 +686,40 @@ ppx::Result MaterialPipelineArgs::Create(grfx::Device* pDevice, scene::MaterialP
     return ppx::SUCCESS;
 }
 
-void MaterialPipelineArgs::SetCameraParams(const ppx::Camera* pCamera)
+void MaterialPipelineArgs::DirtyEntries::Mark(uint32_t index)
+{
+    if (flags[index] == 0) {
+        flags[index] = 1;
+        ++count;
+    }
+}
+
+void MaterialPipelineArgs::DirtyEntries::MarkAll()
+{
+    std::fill(flags.begin(), flags.end(), static_cast<uint8_t>(1));
+    count = CountU32(flags);
+}
+
+scene::FrameParams* MaterialPipelineArgs::GetFrameParams()
+{
+    mConstantParamsDirty = true;
+    return mFrameParamsAddress;
+}
+
+scene::CameraParams* MaterialPipelineArgs::GetCameraParams(uint32_t viewIndex)
+{
+    if (viewIndex >= MAX_VIEWS) {
+        return nullptr;
+    }
+    mConstantParamsDirty = true;
+    return mCameraParamsAddress + viewIndex;
+}
+
+void MaterialPipelineArgs::SetCameraParams(const ppx::Camera* pCamera, uint32_t viewIndex)
 {
     PPX_ASSERT_NULL_ARG(pCamera);
 
-    auto pCameraParams = this->GetCameraParams();
+    auto pCameraParams = this->GetCameraParams(viewIndex);
     PPX_ASSERT_NULL_ARG(pCameraParams);
 
     pCameraParams->viewProjectionMatrix = pCamera->GetViewProjectionMatrix();
@@ -688,17 +735,48 @@ scene::InstanceParams* MaterialPipelineArgs::GetInstanceParams(uint32_t index)
         return nullptr;
     }
 
+    mDirtyInstances.Mark(index);
+
     uint32_t offset = index * INSTANCE_PARAMS_STRUCT_SIZE;
     char*    ptr    = mInstanceParamsMappedAddress + offset;
     return reinterpret_cast<scene::InstanceParams*>(ptr);
 }
 
+void MaterialPipelineArgs::SetVertexDequantization(uint32_t index, const scene::VertexDequantization& dequantization)
+{
+    scene::InstanceParams* pInstanceParams = GetInstanceParams(index);
+    if (IsNull(pInstanceParams)) {
+        return;
+    }
+
+    pInstanceParams->positionDequantScale  = dequantization.positionScale;
+    pInstanceParams->positionDequantOffset = dequantization.positionOffset;
+}
+
+uint64_t MaterialPipelineArgs::GetInstanceParamsDeviceAddress(uint32_t index) const
+{
+    if (!mGpuInstanceParamsBuffer || !mGpuInstanceParamsBuffer->GetUsageFlags().bits.shaderDeviceAddress || (index >= MAX_DRAWABLE_INSTANCES)) {
+        return 0;
+    }
+    return mGpuInstanceParamsBuffer->GetDeviceAddress() + index * INSTANCE_PARAMS_STRUCT_SIZE;
+}
+
+uint64_t MaterialPipelineArgs::GetMaterialParamsDeviceAddress(uint32_t index) const
+{
+    if (!mGpuMateriaParamsBuffer || !mGpuMateriaParamsBuffer->GetUsageFlags().bits.shaderDeviceAddress || (index >= MAX_UNIQUE_MATERIALS)) {
+        return 0;
+    }
+    return mGpuMateriaParamsBuffer->GetDeviceAddress() + index * MATERIAL_PARAMS_STRUCT_SIZE;
+}
+
 scene::MaterialParams* MaterialPipelineArgs::GetMaterialParams(uint32_t index)
 {
     if (IsNull(mMaterialParamsMappedAddress) || (index >= MAX_UNIQUE_MATERIALS)) {
         return nullptr;
     }
 
+    mDirtyMaterials.Mark(index);
+
     uint32_t offset = index * MATERIAL_PARAMS_STRUCT_SIZE;
     char*    ptr    = mMaterialParamsMappedAddress + offset;
     return reinterpret_cast<scene::MaterialParams*>(ptr);
@@ -716,6 +794,13 @@ void MaterialPipelineArgs::SetIBLTextures(
     mDescriptorSet->UpdateSampledImage(IBL_ENVIRONMENT_MAP_REGISTER, index, pEnvironment);
 }
 
+void MaterialPipelineArgs::SetBRDFLUTTexture(grfx::SampledImageView* pBRDFLUT)
+{
+    PPX_ASSERT_NULL_ARG(pBRDFLUT);
+
+    mDescriptorSet->UpdateSampledImage(BRDF_LUT_TEXTURE_REGISTER, 0, pBRDFLUT);
+}
+
 void MaterialPipelineArgs::SetMaterialSampler(uint32_t index, const scene::Sampler* pSampler)
 {
     PPX_ASSERT_NULL_ARG(pSampler);
@@ -730,12 +815,59 @@ void MaterialPipelineArgs::SetMaterialTexture(uint32_t index, const scene::Image
     mDescriptorSet->UpdateSampledImage(MATERIAL_TEXTURES_REGISTER, index, pImage->GetImageView());
 }
 
+void MaterialPipelineArgs::CopyDirtyEntries(
+    grfx::CommandBuffer* pCmd,
+    uint32_t             entrySize,
+    grfx::Buffer*        pSrcBuffer,
+    grfx::Buffer*        pDstBuffer,
+    DirtyEntries&        dirtyEntries)
+{
+    if (dirtyEntries.count == 0) {
+        return;
+    }
+
+    // Copying a few unchanged entries is cheaper than another copy
+    const uint32_t kMaxGapEntries = 4;
+    const uint32_t entryCount     = CountU32(dirtyEntries.flags);
+
+    uint32_t index = 0;
+    while (index < entryCount) {
+        if (dirtyEntries.flags[index] == 0) {
+            ++index;
+            continue;
+        }
+
+        const uint32_t begin = index;
+        uint32_t       end   = index + 1;
+        for (uint32_t i = end; (i < entryCount) && (i <= end + kMaxGapEntries); ++i) {
+            if (dirtyEntries.flags[i] != 0) {
+                end = i + 1;
+            }
+        }
+
+        grfx::BufferToBufferCopyInfo copyInfo = {};
+        copyInfo.srcBuffer.offset             = static_cast<uint64_t>(begin) * entrySize;
+        copyInfo.dstBuffer.offset             = begin * entrySize;
+        copyInfo.size                         = static_cast<uint64_t>(end - begin) * entrySize;
+
+        pCmd->CopyBufferToBuffer(&copyInfo, pSrcBuffer, pDstBuffer);
+        mCopiedByteCount += copyInfo.size;
+
+        index = end;
+    }
+
+    std::fill(dirtyEntries.flags.begin(), dirtyEntries.flags.end(), static_cast<uint8_t>(0));
+    dirtyEntries.count = 0;
+}
+
 void MaterialPipelineArgs::CopyBuffers(grfx::CommandBuffer* pCmd)
 {
     PPX_ASSERT_NULL_ARG(pCmd);
 
+    mCopiedByteCount = 0;
+
     // Constant params buffer
-    {
+    if (mConstantParamsDirty) {
         grfx::BufferToBufferCopyInfo copyInfo = {};
         copyInfo.srcBuffer.offset             = 0;
         copyInfo.dstBuffer.offset             = 0;
@@ -745,33 +877,16 @@ void MaterialPipelineArgs::CopyBuffers(grfx::CommandBuffer* pCmd)
             &copyInfo,
             mCpuConstantParamsBuffer.Get(),
             mGpuConstantParamsBuffer.Get());
+
+        mCopiedByteCount += copyInfo.size;
+        mConstantParamsDirty = false;
     }
 
     // Instance params buffer
-    {
-        grfx::BufferToBufferCopyInfo copyInfo = {};
-        copyInfo.srcBuffer.offset             = 0;
-        copyInfo.dstBuffer.offset             = 0;
-        copyInfo.size                         = mTotalInstanceParamsPaddedSize;
-
-        pCmd->CopyBufferToBuffer(
-            &copyInfo,
-            mCpuInstanceParamsBuffer.Get(),
-            mGpuInstanceParamsBuffer.Get());
-    }
+    CopyDirtyEntries(pCmd, INSTANCE_PARAMS_STRUCT_SIZE, mCpuInstanceParamsBuffer.Get(), mGpuInstanceParamsBuffer.Get(), mDirtyInstances);
 
     // Material params buffer
-    {
-        grfx::BufferToBufferCopyInfo copyInfo = {};
-        copyInfo.srcBuffer.offset             = 0;
-        copyInfo.dstBuffer.offset             = 0;
-        copyInfo.size                         = mTotalMaterialParamsPaddedSize;
-
-        pCmd->CopyBufferToBuffer(
-            &copyInfo,
-            mCpuMateriaParamsBuffer.Get(),
-            mGpuMateriaParamsBuffer.Get());
-    }
+    CopyDirtyEntries(pCmd, MATERIAL_PARAMS_STRUCT_SIZE, mCpuMateriaParamsBuffer.Get(), mGpuMateriaParamsBuffer.Get(), mDirtyMaterials);
 }
 
 } // namespace scene
@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_render_queue.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace scene {
+
+uint64_t RenderQueue::MakeSortKey(uint32_t pipelineIndex, uint32_t materialIndex, uint32_t meshIndex, float depth)
+{
+    const uint64_t quantizedDepth = static_cast<uint64_t>(std::clamp(depth, 0.0f, 1.0f) * 65535.0f + 0.5f);
+
+    uint64_t key = 0;
+    key |= static_cast<uint64_t>(pipelineIndex & 0xFFF) << 52;
+    key |= static_cast<uint64_t>(materialIndex & 0xFFFF) << 36;
+    key |= static_cast<uint64_t>(meshIndex & 0xFFFFF) << 16;
+    key |= quantizedDepth;
+    return key;
+}
+
+void RenderQueue::Clear()
+{
+    mDraws.clear();
+    mOrder.clear();
+}
+
+void RenderQueue::Sort()
+{
+    const uint32_t drawCount = GetDrawCount();
+
+    mOrder.resize(drawCount);
+    mScratch.resize(drawCount);
+    for (uint32_t i = 0; i < drawCount; ++i) {
+        mOrder[i] = i;
+    }
+
+    // Bits that differ between any two keys, bytes without any are skipped
+    uint64_t differingBits = 0;
+    for (uint32_t i = 1; i < drawCount; ++i) {
+        differingBits |= mDraws[i].sortKey ^ mDraws[0].sortKey;
+    }
+
+    // Stable counting sort of each byte, least significant first
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        if (((differingBits >> shift) & 0xFF) == 0) {
+            continue;
+        }
+
+        uint32_t offsets[256] = {};
+        for (uint32_t i = 0; i < drawCount; ++i) {
+            ++offsets[(mDraws[i].sortKey >> shift) & 0xFF];
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t& count : offsets) {
+            const uint32_t bucketCount = count;
+            count                      = offset;
+            offset += bucketCount;
+        }
+
+        for (uint32_t index : mOrder) {
+            mScratch[offsets[(mDraws[index].sortKey >> shift) & 0xFF]++] = index;
+        }
+        mOrder.swap(mScratch);
+    }
+}
+
+} // namespace scene
+} // namespace ppx
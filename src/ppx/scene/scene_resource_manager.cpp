@@ -17,9 +17,126 @@
 #include "ppx/scene/scene_mesh.h"
 #include "ppx/grfx/grfx_device.h"
 
+#include <algorithm>
+
 namespace ppx {
 namespace scene {
 
+namespace {
+
+const char* kObjectTypeNames[] = {
+    "sampler",
+    "image",
+    "texture",
+    "material",
+    "mesh data",
+    "mesh",
+};
+
+struct EvictionCandidate
+{
+    ResourceManager::ObjectType type     = ResourceManager::OBJECT_TYPE_SAMPLER;
+    uint64_t                    objectId = 0;
+    const void*                 pObject  = nullptr;
+    uint64_t                    lastUse  = 0;
+    uint64_t                    gpuBytes = 0;
+};
+
+template <typename ObjectT>
+uint64_t GetGpuBytes(const ObjectT*)
+{
+    return 0;
+}
+
+uint64_t GetGpuBytes(const scene::Image* pObject)
+{
+    const grfx::Image* pImage = pObject->GetImage();
+    if (IsNull(pImage)) {
+        return 0;
+    }
+
+    const grfx::FormatDesc* pDesc = grfx::GetFormatDescription(pImage->GetFormat());
+    if (IsNull(pDesc)) {
+        return 0;
+    }
+
+    // Sum of the mip levels in whole blocks
+    const uint32_t blockWidth = std::max<uint32_t>(pDesc->blockWidth, 1);
+    uint32_t       width      = pImage->GetWidth();
+    uint32_t       height     = pImage->GetHeight();
+    uint32_t       depth      = pImage->GetDepth();
+    uint64_t       bytes      = 0;
+    for (uint32_t level = 0; level < pImage->GetMipLevelCount(); ++level) {
+        const uint64_t blockCountX = (width + blockWidth - 1) / blockWidth;
+        const uint64_t blockCountY = (height + blockWidth - 1) / blockWidth;
+        bytes += blockCountX * blockCountY * depth * pDesc->bytesPerTexel;
+
+        width  = std::max<uint32_t>(width / 2, 1);
+        height = std::max<uint32_t>(height / 2, 1);
+        depth  = std::max<uint32_t>(depth / 2, 1);
+    }
+    return bytes * pImage->GetArrayLayerCount();
+}
+
+uint64_t GetGpuBytes(const scene::MeshData* pObject)
+{
+    return pObject->GetGpuBufferSize();
+}
+
+template <typename ObjectRefT>
+void AppendEvictionCandidates(
+    ResourceManager::ObjectType                      type,
+    const std::unordered_map<uint64_t, ObjectRefT>&  container,
+    const std::unordered_map<const void*, uint64_t>& lastUse,
+    std::vector<EvictionCandidate>&                  candidates)
+{
+    for (const auto& [objectId, object] : container) {
+        // The resource manager holds the only reference
+        if (object.use_count() > 1) {
+            continue;
+        }
+
+        auto it = lastUse.find(object.get());
+
+        EvictionCandidate candidate = {};
+        candidate.type              = type;
+        candidate.objectId          = objectId;
+        candidate.pObject           = object.get();
+        candidate.lastUse           = (it != lastUse.end()) ? it->second : 0;
+        candidate.gpuBytes          = GetGpuBytes(object.get());
+        candidates.push_back(candidate);
+    }
+}
+
+template <typename ObjectRefT>
+void AppendResidentObjects(
+    ResourceManager::ObjectType                     type,
+    const std::unordered_map<uint64_t, ObjectRefT>& container,
+    std::vector<ResourceManager::ResidentObject>&   objects)
+{
+    for (const auto& [objectId, object] : container) {
+        ResourceManager::ResidentObject resident = {};
+        resident.type                            = type;
+        resident.objectId                        = objectId;
+        resident.name                            = object->GetName();
+        resident.gpuBytes                        = GetGpuBytes(object.get());
+        resident.referenced                      = (object.use_count() > 1);
+        objects.push_back(resident);
+    }
+}
+
+template <typename ObjectRefT>
+uint64_t SumGpuBytes(const std::unordered_map<uint64_t, ObjectRefT>& container)
+{
+    uint64_t bytes = 0;
+    for (const auto& [objectId, object] : container) {
+        bytes += GetGpuBytes(object.get());
+    }
+    return bytes;
+}
+
+} // namespace
+
 ResourceManager::ResourceManager()
 {
 }
@@ -96,6 +213,112 @@ void ResourceManager::DestroyAll()
     mMaterials.clear();
     mMeshData.clear();
     mMeshes.clear();
+    mLastUse.clear();
+}
+
+uint64_t ResourceManager::GetResidentBytes() const
+{
+    return SumGpuBytes(mImages) + SumGpuBytes(mMeshData);
+}
+
+uint32_t ResourceManager::EvictUnreferenced()
+{
+    uint64_t residentBytes = GetResidentBytes();
+    uint32_t evictedCount  = 0;
+
+    auto fitsBudget = [&]() {
+        return (mMemoryBudget != 0) && (residentBytes <= mMemoryBudget);
+    };
+
+    // Evicting an object can release the last external reference of the
+    // objects it uses, so collect candidates again until none are left
+    std::vector<EvictionCandidate> candidates;
+    while (!fitsBudget()) {
+        candidates.clear();
+        AppendEvictionCandidates(OBJECT_TYPE_SAMPLER, mSamplers, mLastUse, candidates);
+        AppendEvictionCandidates(OBJECT_TYPE_IMAGE, mImages, mLastUse, candidates);
+        AppendEvictionCandidates(OBJECT_TYPE_TEXTURE, mTextures, mLastUse, candidates);
+        AppendEvictionCandidates(OBJECT_TYPE_MATERIAL, mMaterials, mLastUse, candidates);
+        AppendEvictionCandidates(OBJECT_TYPE_MESH_DATA, mMeshData, mLastUse, candidates);
+        AppendEvictionCandidates(OBJECT_TYPE_MESH, mMeshes, mLastUse, candidates);
+        if (candidates.empty()) {
+            break;
+        }
+
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](const EvictionCandidate& a, const EvictionCandidate& b) {
+                return a.lastUse < b.lastUse;
+            });
+
+        for (const auto& candidate : candidates) {
+            if (fitsBudget()) {
+                break;
+            }
+
+            mLastUse.erase(candidate.pObject);
+            switch (candidate.type) {
+                default: break;
+                case OBJECT_TYPE_SAMPLER: mSamplers.erase(candidate.objectId); break;
+                case OBJECT_TYPE_IMAGE: mImages.erase(candidate.objectId); break;
+                case OBJECT_TYPE_TEXTURE: mTextures.erase(candidate.objectId); break;
+                case OBJECT_TYPE_MATERIAL: mMaterials.erase(candidate.objectId); break;
+                case OBJECT_TYPE_MESH_DATA: mMeshData.erase(candidate.objectId); break;
+                case OBJECT_TYPE_MESH: mMeshes.erase(candidate.objectId); break;
+            }
+
+            residentBytes -= candidate.gpuBytes;
+            ++evictedCount;
+        }
+    }
+
+    return evictedCount;
+}
+
+std::vector<ResourceManager::ResidentObject> ResourceManager::GetResidentObjects() const
+{
+    std::vector<ResidentObject> objects;
+    AppendResidentObjects(OBJECT_TYPE_SAMPLER, mSamplers, objects);
+    AppendResidentObjects(OBJECT_TYPE_IMAGE, mImages, objects);
+    AppendResidentObjects(OBJECT_TYPE_TEXTURE, mTextures, objects);
+    AppendResidentObjects(OBJECT_TYPE_MATERIAL, mMaterials, objects);
+    AppendResidentObjects(OBJECT_TYPE_MESH_DATA, mMeshData, objects);
+    AppendResidentObjects(OBJECT_TYPE_MESH, mMeshes, objects);
+
+    std::stable_sort(
+        objects.begin(),
+        objects.end(),
+        [](const ResidentObject& a, const ResidentObject& b) {
+            return a.gpuBytes > b.gpuBytes;
+        });
+
+    return objects;
+}
+
+void ResourceManager::LogResidentReport(uint32_t maxObjectCount) const
+{
+    const std::vector<ResidentObject> objects = GetResidentObjects();
+
+    uint32_t typeCounts[OBJECT_TYPE_MESH + 1] = {};
+    uint64_t typeBytes[OBJECT_TYPE_MESH + 1]  = {};
+    uint32_t unreferencedCount                = 0;
+    for (const auto& object : objects) {
+        ++typeCounts[object.type];
+        typeBytes[object.type] += object.gpuBytes;
+        unreferencedCount += object.referenced ? 0 : 1;
+    }
+
+    PPX_LOG_INFO("Resource manager: " << objects.size() << " objects (" << unreferencedCount << " unreferenced), " << GetResidentBytes() << " GPU bytes");
+    for (uint32_t type = 0; type <= OBJECT_TYPE_MESH; ++type) {
+        PPX_LOG_INFO("   " << kObjectTypeNames[type] << ": " << typeCounts[type] << " objects, " << typeBytes[type] << " bytes");
+    }
+
+    const uint32_t objectCount = std::min<uint32_t>(maxObjectCount, CountU32(objects));
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        const ResidentObject& object = objects[i];
+        PPX_LOG_INFO("   " << object.gpuBytes << " bytes, " << kObjectTypeNames[object.type] << " " << object.objectId << " '" << object.name << "'" << (object.referenced ? "" : " (unreferenced)"));
+    }
 }
 
 const std::unordered_map<uint64_t, scene::SamplerRef>& ResourceManager::GetSamplers() const
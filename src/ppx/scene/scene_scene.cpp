@@ -14,12 +14,13 @@
 
 #include "ppx/scene/scene_scene.h"
 
+#include <cmath>
 #include <set>
 
 namespace ppx {
 namespace scene {
 
-Scene::Scene(std::unique_ptr<scene::ResourceManager>&& resourceManager)
+Scene::Scene(std::shared_ptr<scene::ResourceManager> resourceManager)
     : mResourceManager(std::move(resourceManager))
 {
 }
@@ -90,6 +91,22 @@ scene::LightNode* Scene::GetLightNode(uint32_t index) const
     return pNode;
 }
 
+scene::Animation* Scene::GetAnimation(uint32_t index) const
+{
+    if (index >= GetAnimationCount()) {
+        return nullptr;
+    }
+    return mAnimations[index].get();
+}
+
+const scene::Skin* Scene::GetSkin(uint32_t index) const
+{
+    if (index >= GetSkinCount()) {
+        return nullptr;
+    }
+    return mSkins[index].get();
+}
+
 scene::Node* Scene::FindNode(const std::string& name) const
 {
     auto it = ppx::FindIf(
@@ -148,6 +165,7 @@ ppx::Result Scene::AddNode(scene::NodeRef&& node)
         return ppx::ERROR_DUPLICATE_ELEMENT;
     }
 
+    mTransformHierarchy.AddNode(node.get());
     mNodes.push_back(std::move(node));
 
     if (!IsNull(pMeshNode)) {
@@ -163,6 +181,32 @@ ppx::Result Scene::AddNode(scene::NodeRef&& node)
     return ppx::SUCCESS;
 }
 
+ppx::Result Scene::AddAnimation(std::unique_ptr<scene::Animation>&& animation)
+{
+    if (!animation) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    mAnimations.push_back(std::move(animation));
+    return ppx::SUCCESS;
+}
+
+ppx::Result Scene::AddSkin(std::unique_ptr<scene::Skin>&& skin)
+{
+    if (!skin) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    mSkins.push_back(std::move(skin));
+    return ppx::SUCCESS;
+}
+
+void Scene::ApplyAnimations(float time)
+{
+    for (auto& animation : mAnimations) {
+        const float duration = animation->GetDuration();
+        animation->Apply((duration > 0) ? std::fmod(time, duration) : 0.0f);
+    }
+}
+
 scene::ResourceIndexMap<scene::Sampler> Scene::GetSamplersArrayIndexMap() const
 {
     const auto& objects = mResourceManager->GetSamplers();
@@ -182,10 +226,23 @@ scene::ResourceIndexMap<scene::Image> Scene::GetImagesArrayIndexMap() const
 {
     const auto& objects = mResourceManager->GetImages();
 
+    // Packed images share the index of their texture array
+    scene::ResourceIndexMap<scene::Image> arrayIndices;
+
     scene::ResourceIndexMap<scene::Image> indexMap;
     //
     uint32_t index = 0;
     for (const auto& it : objects) {
+        const scene::Image* pArrayImage = it.second->GetArrayImage();
+        if (!IsNull(pArrayImage)) {
+            auto itArray = arrayIndices.find(pArrayImage);
+            if (itArray != arrayIndices.end()) {
+                indexMap[it.second.get()] = itArray->second;
+                continue;
+            }
+            arrayIndices[pArrayImage] = index;
+        }
+
         indexMap[it.second.get()] = index;
         ++index;
     }
@@ -208,5 +265,27 @@ scene::ResourceIndexMap<scene::Material> Scene::GetMaterialsArrayIndexMap() cons
     return indexMap;
 }
 
+std::vector<scene::MeshInstanceGroup> Scene::GetMeshInstanceGroups() const
+{
+    std::vector<scene::MeshInstanceGroup> groups;
+
+    std::unordered_map<const scene::Mesh*, size_t> groupIndexMap;
+    for (const scene::MeshNode* pNode : mMeshNodes) {
+        const scene::Mesh* pMesh = pNode->GetMesh();
+        if (IsNull(pMesh)) {
+            continue;
+        }
+
+        auto it = groupIndexMap.find(pMesh);
+        if (it == groupIndexMap.end()) {
+            it = groupIndexMap.emplace(pMesh, groups.size()).first;
+            groups.push_back({pMesh});
+        }
+        groups[it->second].nodes.push_back(pNode);
+    }
+
+    return groups;
+}
+
 } // namespace scene
 } // namespace ppx
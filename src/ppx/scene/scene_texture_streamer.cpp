@@ -0,0 +1,507 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_texture_streamer.h"
+#include "ppx/scene/scene_material.h"
+#include "ppx/scene/scene_mesh.h"
+#include "ppx/scene/scene_node.h"
+#include "ppx/scene/scene_scene.h"
+#include "ppx/grfx/grfx_device.h"
+#include "ppx/grfx/grfx_scope.h"
+#include "ppx/graphics_util.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <queue>
+
+namespace ppx {
+namespace scene {
+
+// Uploads go through the transfer queue if it's in another queue family,
+// like the uploads of grfx_util
+static grfx::Queue* GetUploadQueue(grfx::Queue* pQueue)
+{
+    grfx::Device* pDevice = pQueue->GetDevice();
+    if (pDevice->GetTransferQueueCount() == 0) {
+        return pQueue;
+    }
+
+    grfx::Queue* pTransferQueue = pDevice->GetTransferQueue();
+    return pTransferQueue->RequiresOwnershipTransfer(pQueue) ? pTransferQueue : pQueue;
+}
+
+// -------------------------------------------------------------------------------------------------
+// TextureStreamer
+// -------------------------------------------------------------------------------------------------
+TextureStreamer::TextureStreamer()
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    // Batches wait for their uploads when they're destroyed
+    for (auto& upload : mUploads) {
+        upload.batch.reset();
+        Retire(upload.image, upload.imageView);
+    }
+    mUploads.clear();
+
+    DestroyRetired(true);
+}
+
+ppx::Result TextureStreamer::Create(grfx::Queue* pQueue, const scene::TextureStreamerCreateInfo& createInfo, scene::TextureStreamer** ppStreamer)
+{
+    if (IsNull(pQueue) || IsNull(ppStreamer)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+    if ((createInfo.initialSize == 0) || (createInfo.maxUploadBytes == 0)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    scene::TextureStreamer* pStreamer = new scene::TextureStreamer();
+    if (IsNull(pStreamer)) {
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    pStreamer->mQueue      = pQueue;
+    pStreamer->mCreateInfo = createInfo;
+
+    *ppStreamer = pStreamer;
+
+    return ppx::SUCCESS;
+}
+
+uint64_t TextureStreamer::CalculateLevelsSize(const ppx::Mipmap& mipmap, uint32_t firstLevel)
+{
+    uint64_t size = 0;
+    for (uint32_t level = firstLevel; level < mipmap.GetLevelCount(); ++level) {
+        size += mipmap.GetMip(level)->GetFootprintSize();
+    }
+    return size;
+}
+
+ppx::Result TextureStreamer::CreateResidentImage(
+    const ppx::Mipmap&                  mipmap,
+    uint32_t                            firstLevel,
+    std::unique_ptr<grfx::UploadBatch>* pBatch,
+    grfx::Image**                       ppImage,
+    grfx::SampledImageView**            ppImageView)
+{
+    grfx::Device*  pDevice       = mQueue->GetDevice();
+    const uint32_t mipLevelCount = mipmap.GetLevelCount() - firstLevel;
+
+    // Scoped destroy
+    grfx::ScopeDestroyer SCOPED_DESTROYER(pDevice);
+
+    grfx::ImagePtr image;
+    {
+        grfx::ImageCreateInfo ci       = {};
+        ci.type                        = grfx::IMAGE_TYPE_2D;
+        ci.width                       = mipmap.GetWidth(firstLevel);
+        ci.height                      = mipmap.GetHeight(firstLevel);
+        ci.depth                       = 1;
+        ci.format                      = grfx_util::ToGrfxFormat(mipmap.GetFormat());
+        ci.sampleCount                 = grfx::SAMPLE_COUNT_1;
+        ci.mipLevelCount               = mipLevelCount;
+        ci.arrayLayerCount             = 1;
+        ci.usageFlags.bits.transferDst = true;
+        ci.usageFlags.bits.sampled     = true;
+        ci.memoryUsage                 = grfx::MEMORY_USAGE_GPU_ONLY;
+        ci.initialState                = grfx::RESOURCE_STATE_SHADER_RESOURCE;
+
+        auto ppxres = pDevice->CreateImage(&ci, &image);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(image);
+    }
+
+    // Same view as the GLTF loader's, material shaders sample arrays
+    grfx::SampledImageViewPtr imageView;
+    {
+        grfx::SampledImageViewCreateInfo ci = {};
+        ci.pImage                           = image;
+        ci.imageViewType                    = grfx::IMAGE_VIEW_TYPE_2D_ARRAY;
+        ci.format                           = image->GetFormat();
+        ci.sampleCount                      = grfx::SAMPLE_COUNT_1;
+        ci.mipLevel                         = 0;
+        ci.mipLevelCount                    = mipLevelCount;
+        ci.arrayLayer                       = 0;
+        ci.arrayLayerCount                  = 1;
+        ci.components                       = {};
+
+        auto ppxres = pDevice->CreateSampledImageView(&ci, &imageView);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+        SCOPED_DESTROYER.AddObject(imageView);
+    }
+
+    uint64_t stagingSize = 0;
+    for (uint32_t level = firstLevel; level < mipmap.GetLevelCount(); ++level) {
+        stagingSize += grfx::UploadBatch::CalculateStagingSize(pDevice->GetApi(), mipmap.GetMip(level));
+    }
+
+    auto batch = std::make_unique<grfx::UploadBatch>(GetUploadQueue(mQueue), stagingSize, mQueue);
+    for (uint32_t level = firstLevel; level < mipmap.GetLevelCount(); ++level) {
+        auto ppxres = batch->AddBitmapUpload(
+            mipmap.GetMip(level),
+            image,
+            level - firstLevel,
+            0,
+            grfx::RESOURCE_STATE_SHADER_RESOURCE,
+            grfx::RESOURCE_STATE_SHADER_RESOURCE);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+
+    auto ppxres = batch->Submit();
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // Change ownership to reference so objects don't get destroyed
+    image->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+    imageView->SetOwnership(grfx::OWNERSHIP_REFERENCE);
+
+    *pBatch      = std::move(batch);
+    *ppImage     = image;
+    *ppImageView = imageView;
+
+    return ppx::SUCCESS;
+}
+
+ppx::Result TextureStreamer::CreateImage(std::unique_ptr<ppx::Mipmap> mipmap, scene::ImageRef& outImage)
+{
+    if (!mipmap || !mipmap->IsOk()) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    // Levels no larger than initialSize, at least the smallest one
+    uint32_t coarsestLevel = 0;
+    while ((coarsestLevel + 1 < mipmap->GetLevelCount()) && (std::max(mipmap->GetWidth(coarsestLevel), mipmap->GetHeight(coarsestLevel)) > mCreateInfo.initialSize)) {
+        ++coarsestLevel;
+    }
+
+    std::unique_ptr<grfx::UploadBatch> batch;
+    grfx::Image*                       pGrfxImage     = nullptr;
+    grfx::SampledImageView*            pGrfxImageView = nullptr;
+
+    auto ppxres = CreateResidentImage(*mipmap, coarsestLevel, &batch, &pGrfxImage, &pGrfxImageView);
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    // The image is used right away
+    ppxres = batch->Wait();
+    if (Failed(ppxres)) {
+        Retire(pGrfxImage, pGrfxImageView);
+        return ppxres;
+    }
+
+    outImage = scene::MakeRef(new scene::Image(pGrfxImage, pGrfxImageView));
+    if (!outImage) {
+        Retire(pGrfxImage, pGrfxImageView);
+        return ppx::ERROR_ALLOCATION_FAILED;
+    }
+
+    // An image that was destroyed may have had the same address
+    auto it = mEntries.find(outImage.get());
+    if (it != mEntries.end()) {
+        mResidentBytes -= CalculateLevelsSize(*it->second.mipmap, it->second.residentLevel);
+        mEntries.erase(it);
+    }
+
+    mResidentBytes += CalculateLevelsSize(*mipmap, coarsestLevel);
+
+    Entry& entry        = mEntries[outImage.get()];
+    entry.image         = outImage;
+    entry.mipmap        = std::move(mipmap);
+    entry.coarsestLevel = coarsestLevel;
+    entry.residentLevel = coarsestLevel;
+    entry.wantedLevel   = coarsestLevel;
+
+    return ppx::SUCCESS;
+}
+
+void TextureStreamer::RequestLevel(const scene::Image* pImage, float mipLevel)
+{
+    auto it = mEntries.find(pImage);
+    if (it == mEntries.end()) {
+        return;
+    }
+
+    Entry&         entry = it->second;
+    const uint32_t level = static_cast<uint32_t>(std::min(std::max(mipLevel, 0.0f), static_cast<float>(entry.coarsestLevel)));
+
+    entry.requestedLevel = std::min(entry.requestedLevel, level);
+}
+
+void TextureStreamer::RequestLevels(const scene::Scene& scene, const ppx::Camera& camera, uint32_t viewportHeight)
+{
+    const bool   perspective   = (camera.GetCameraType() == ppx::CAMERA_TYPE_PERSPECTIVE);
+    const float  pixelsPerUnit = 0.5f * std::abs(camera.GetProjectionMatrix()[1][1]) * static_cast<float>(viewportHeight);
+    const float3 eyePosition   = camera.GetEyePosition();
+
+    // Level at which a texel covers about a pixel
+    auto requestTexture = [this](const scene::TextureView& textureView, float projectedSize) {
+        if (!textureView.HasTexture()) {
+            return;
+        }
+
+        auto it = mEntries.find(textureView.GetTexture()->GetImage());
+        if (it == mEntries.end()) {
+            return;
+        }
+
+        const ppx::Mipmap& mipmap      = *it->second.mipmap;
+        const float2       scale       = glm::abs(textureView.GetTexCoordScale());
+        const float        textureSize = static_cast<float>(std::max(mipmap.GetWidth(0), mipmap.GetHeight(0))) * std::max(scale.x, scale.y);
+
+        RequestLevel(textureView.GetTexture()->GetImage(), std::log2(textureSize / std::max(projectedSize, 1.0f)));
+    };
+
+    for (uint32_t nodeIndex = 0; nodeIndex < scene.GetMeshNodeCount(); ++nodeIndex) {
+        const scene::MeshNode* pNode = scene.GetMeshNode(nodeIndex);
+        const scene::Mesh*     pMesh = pNode->GetMesh();
+        if (IsNull(pMesh)) {
+            continue;
+        }
+
+        const float4x4& modelMatrix = pNode->GetEvaluatedMatrix();
+        const float     scale       = std::max({glm::length(float3(modelMatrix[0])), glm::length(float3(modelMatrix[1])), glm::length(float3(modelMatrix[2]))});
+
+        for (const auto& batch : pMesh->GetBatches()) {
+            const scene::Material* pMaterial = batch.GetMaterial();
+            if (IsNull(pMaterial) || !pMaterial->HasTextures()) {
+                continue;
+            }
+
+            // Diameter of the bounding sphere in pixels, nearest point of
+            // the sphere for perspective
+            const ppx::AABB& bounds        = batch.GetBoundingBox();
+            const float3     center        = float3(modelMatrix * float4(bounds.GetCenter(), 1));
+            const float      radius        = 0.5f * glm::length(bounds.GetSize()) * scale;
+            float            projectedSize = 2.0f * radius * pixelsPerUnit;
+            if (perspective) {
+                const float distance = glm::length(center - eyePosition) - radius;
+                projectedSize        = (distance > camera.GetNearClip()) ? (projectedSize / distance) : FLT_MAX;
+            }
+
+            const std::string ident = pMaterial->GetIdentString();
+            if (ident == PPX_MATERIAL_IDENT_STANDARD) {
+                auto pStandardMaterial = static_cast<const scene::StandardMaterial*>(pMaterial);
+                requestTexture(pStandardMaterial->GetBaseColorTextureView(), projectedSize);
+                requestTexture(pStandardMaterial->GetMetallicRoughnessTextureView(), projectedSize);
+                requestTexture(pStandardMaterial->GetNormalTextureView(), projectedSize);
+                requestTexture(pStandardMaterial->GetOcclusionTextureView(), projectedSize);
+                requestTexture(pStandardMaterial->GetEmissiveTextureView(), projectedSize);
+            }
+            else if (ident == PPX_MATERIAL_IDENT_UNLIT) {
+                auto pUnlitMaterial = static_cast<const scene::UnlitMaterial*>(pMaterial);
+                requestTexture(pUnlitMaterial->GetBaseColorTextureView(), projectedSize);
+            }
+        }
+    }
+}
+
+uint32_t TextureStreamer::GetResidentLevel(const scene::Image* pImage) const
+{
+    auto it = mEntries.find(pImage);
+    return (it != mEntries.end()) ? it->second.residentLevel : 0;
+}
+
+void TextureStreamer::Retire(const grfx::ImagePtr& image, const grfx::SampledImageViewPtr& imageView)
+{
+    RetiredImage retired = {};
+    retired.image        = image;
+    retired.imageView    = imageView;
+    retired.frame        = mFrame;
+    mRetiredImages.push_back(retired);
+}
+
+void TextureStreamer::DestroyRetired(bool all)
+{
+    grfx::Device* pDevice = mQueue->GetDevice();
+
+    auto itEnd = std::remove_if(mRetiredImages.begin(), mRetiredImages.end(), [this, all, pDevice](const RetiredImage& retired) {
+        if (!all && (mFrame < retired.frame + mCreateInfo.retireFrameCount)) {
+            return false;
+        }
+        if (retired.imageView) {
+            pDevice->DestroySampledImageView(retired.imageView);
+        }
+        if (retired.image) {
+            pDevice->DestroyImage(retired.image);
+        }
+        return true;
+    });
+    mRetiredImages.erase(itEnd, mRetiredImages.end());
+}
+
+void TextureStreamer::CompleteUploads(uint32_t* pChangedCount)
+{
+    auto itEnd = std::remove_if(mUploads.begin(), mUploads.end(), [this, pChangedCount](Upload& upload) {
+        if (!upload.batch->IsComplete()) {
+            return false;
+        }
+        upload.batch.reset();
+
+        // The entry's image may be a new one at the same address
+        auto it = mEntries.find(upload.pSceneImage);
+        if ((it != mEntries.end()) && !it->second.image.owner_before(upload.sceneImage) && !upload.sceneImage.owner_before(it->second.image)) {
+            it->second.uploading = false;
+        }
+
+        // The image was destroyed while its levels were uploading
+        std::shared_ptr<scene::Image> image = upload.sceneImage.lock();
+        if (!image) {
+            Retire(upload.image, upload.imageView);
+            return true;
+        }
+
+        Entry& entry = it->second;
+
+        grfx::ImagePtr            oldImage;
+        grfx::SampledImageViewPtr oldImageView;
+        image->SwapImage(upload.image, upload.imageView, &oldImage, &oldImageView);
+        Retire(oldImage, oldImageView);
+
+        mResidentBytes -= CalculateLevelsSize(*entry.mipmap, entry.residentLevel);
+        mResidentBytes += CalculateLevelsSize(*entry.mipmap, upload.residentLevel);
+        entry.residentLevel = upload.residentLevel;
+
+        ++(*pChangedCount);
+        return true;
+    });
+    mUploads.erase(itEnd, mUploads.end());
+}
+
+ppx::Result TextureStreamer::Update(uint32_t* pChangedCount)
+{
+    uint32_t changedCount = 0;
+    CompleteUploads(&changedCount);
+
+    ++mFrame;
+
+    // Drop the images that were destroyed, their GPU objects went with them
+    for (auto it = mEntries.begin(); it != mEntries.end();) {
+        if (it->second.image.expired() && !it->second.uploading) {
+            mResidentBytes -= CalculateLevelsSize(*it->second.mipmap, it->second.residentLevel);
+            it = mEntries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Finer levels are taken right away, coarser ones once the finer level
+    // wasn't requested for evictFrameCount frames
+    struct Target
+    {
+        const scene::Image* pSceneImage = nullptr;
+        Entry*              pEntry      = nullptr;
+        uint32_t            level       = 0;
+    };
+    std::vector<Target> targets;
+    targets.reserve(mEntries.size());
+
+    uint64_t totalBytes = 0;
+    for (auto& it : mEntries) {
+        Entry&     entry   = it.second;
+        const bool evicted = (mFrame - entry.wantedFrame) > mCreateInfo.evictFrameCount;
+        if ((entry.requestedLevel <= entry.wantedLevel) || (evicted && (entry.requestedLevel != UINT32_MAX))) {
+            entry.wantedLevel = entry.requestedLevel;
+            entry.wantedFrame = mFrame;
+        }
+        else if (evicted) {
+            entry.wantedLevel = entry.coarsestLevel;
+        }
+        entry.requestedLevel = UINT32_MAX;
+
+        targets.push_back({it.first, &entry, entry.wantedLevel});
+        totalBytes += CalculateLevelsSize(*entry.mipmap, entry.wantedLevel);
+    }
+
+    // Drop the largest finest level until the targets fit the budget
+    auto compare = [&targets](size_t a, size_t b) {
+        return targets[a].pEntry->mipmap->GetMip(targets[a].level)->GetFootprintSize() < targets[b].pEntry->mipmap->GetMip(targets[b].level)->GetFootprintSize();
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(compare)> largest(compare);
+    for (size_t i = 0; i < targets.size(); ++i) {
+        if (targets[i].level < targets[i].pEntry->coarsestLevel) {
+            largest.push(i);
+        }
+    }
+    while ((totalBytes > mCreateInfo.budgetBytes) && !largest.empty()) {
+        const size_t i = largest.top();
+        largest.pop();
+
+        totalBytes -= targets[i].pEntry->mipmap->GetMip(targets[i].level)->GetFootprintSize();
+        ++targets[i].level;
+        if (targets[i].level < targets[i].pEntry->coarsestLevel) {
+            largest.push(i);
+        }
+    }
+
+    // Images that shrink free memory, so they go first
+    std::stable_sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) {
+        return (a.level > a.pEntry->residentLevel) && (b.level <= b.pEntry->residentLevel);
+    });
+
+    uint64_t uploadBytes = 0;
+    for (const Target& target : targets) {
+        Entry& entry = *target.pEntry;
+        if ((target.level == entry.residentLevel) || entry.uploading) {
+            continue;
+        }
+
+        const uint64_t levelsSize = CalculateLevelsSize(*entry.mipmap, target.level);
+        if ((uploadBytes > 0) && (uploadBytes + levelsSize > mCreateInfo.maxUploadBytes)) {
+            break;
+        }
+
+        Upload                  upload         = {};
+        grfx::Image*            pGrfxImage     = nullptr;
+        grfx::SampledImageView* pGrfxImageView = nullptr;
+
+        auto ppxres = CreateResidentImage(*entry.mipmap, target.level, &upload.batch, &pGrfxImage, &pGrfxImageView);
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+
+        upload.pSceneImage   = target.pSceneImage;
+        upload.sceneImage    = entry.image;
+        upload.residentLevel = target.level;
+        upload.image         = pGrfxImage;
+        upload.imageView     = pGrfxImageView;
+        mUploads.push_back(std::move(upload));
+
+        entry.uploading = true;
+        uploadBytes += levelsSize;
+    }
+
+    DestroyRetired(false);
+
+    if (!IsNull(pChangedCount)) {
+        *pChangedCount = changedCount;
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace scene
+} // namespace ppx
@@ -0,0 +1,235 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/scene/scene_transform_hierarchy.h"
+#include "ppx/scene/scene_node.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+namespace ppx {
+namespace scene {
+
+namespace {
+
+constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+// Below this spawning threads costs more than the update
+constexpr uint32_t kMinParallelNodeCount = 4096;
+
+} // namespace
+
+TransformHierarchy::~TransformHierarchy()
+{
+    // Nodes can outlive the scene through their references, they go back to
+    // evaluating their matrix on their own
+    for (auto pNode : mRegisteredNodes) {
+        pNode->mHierarchy      = nullptr;
+        pNode->mHierarchyIndex = kInvalidIndex;
+        pNode->mEvaluatedDirty = true;
+    }
+}
+
+void TransformHierarchy::AddNode(scene::Node* pNode)
+{
+    PPX_ASSERT_NULL_ARG(pNode);
+    PPX_ASSERT_MSG(IsNull(pNode->mHierarchy), "node already belongs to a transform hierarchy");
+
+    pNode->mHierarchy = this;
+    mRegisteredNodes.push_back(pNode);
+    SetTopologyDirty();
+}
+
+void TransformHierarchy::SetLocalDirty(uint32_t index)
+{
+    // A pending rebuild marks every node dirty and may invalidate index
+    if (!mTopologyDirty) {
+        mDirtyFlags[index] |= DIRTY_LOCAL;
+    }
+    mDirty = true;
+}
+
+void TransformHierarchy::SetTopologyDirty()
+{
+    mTopologyDirty = true;
+    mDirty         = true;
+}
+
+void TransformHierarchy::Rebuild()
+{
+    const uint32_t nodeCount = CountU32(mRegisteredNodes);
+
+    std::unordered_map<const scene::Node*, uint32_t> indices;
+    indices.reserve(nodeCount);
+    for (auto pNode : mRegisteredNodes) {
+        indices[pNode] = kInvalidIndex;
+    }
+
+    // Nodes whose parent isn't in the hierarchy are roots too, they go last
+    // so their parent's matrix can depend on the other roots
+    std::vector<scene::Node*> roots;
+    mHasExternalParents = false;
+    for (auto pNode : mRegisteredNodes) {
+        const scene::Node* pParent = pNode->GetParent();
+        if (IsNull(pParent)) {
+            roots.push_back(pNode);
+        }
+    }
+    for (auto pNode : mRegisteredNodes) {
+        const scene::Node* pParent = pNode->GetParent();
+        if (!IsNull(pParent) && (indices.find(pParent) == indices.end())) {
+            roots.push_back(pNode);
+            mHasExternalParents = true;
+        }
+    }
+
+    mNodes.clear();
+    mParents.clear();
+    mNodes.reserve(nodeCount);
+    mParents.reserve(nodeCount);
+
+    // Depth first so every subtree is a contiguous range
+    std::vector<scene::Node*> stack;
+    for (auto pRoot : roots) {
+        stack.push_back(pRoot);
+        while (!stack.empty()) {
+            scene::Node* pNode = stack.back();
+            stack.pop_back();
+
+            const uint32_t index   = CountU32(mNodes);
+            indices[pNode]         = index;
+            pNode->mHierarchyIndex = index;
+
+            auto it = indices.find(pNode->GetParent());
+            mNodes.push_back(pNode);
+            mParents.push_back((it != indices.end()) ? it->second : kInvalidIndex);
+
+            for (uint32_t i = pNode->GetChildCount(); i > 0; --i) {
+                scene::Node* pChild = pNode->GetChild(i - 1);
+                if (indices.find(pChild) != indices.end()) {
+                    stack.push_back(pChild);
+                }
+            }
+        }
+    }
+    PPX_ASSERT_MSG(mNodes.size() == nodeCount, "transform hierarchy is missing nodes");
+
+    mLocalMatrices.assign(nodeCount, float4x4(1));
+    mWorldMatrices.assign(nodeCount, float4x4(1));
+    mDirtyFlags.assign(nodeCount, DIRTY_LOCAL);
+
+    // One past the last node of each node's subtree
+    std::vector<uint32_t> subtreeEnds(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        subtreeEnds[i] = i + 1;
+    }
+    for (uint32_t i = nodeCount; i > 0; --i) {
+        const uint32_t parent = mParents[i - 1];
+        if (parent != kInvalidIndex) {
+            subtreeEnds[parent] = std::max(subtreeEnds[parent], subtreeEnds[i - 1]);
+        }
+    }
+
+    // Skip down a single root chain so there's something to split, then
+    // each sibling subtree at that level is independent
+    uint32_t begin = 0;
+    while ((begin + 1 < nodeCount) && (subtreeEnds[begin] == nodeCount)) {
+        ++begin;
+    }
+    mSerialEnd = begin;
+
+    mSubtrees.clear();
+    while (begin < nodeCount) {
+        mSubtrees.push_back({begin, subtreeEnds[begin]});
+        begin = subtreeEnds[begin];
+    }
+
+    mTopologyDirty = false;
+}
+
+void TransformHierarchy::UpdateRange(const Range& range)
+{
+    for (uint32_t i = range.begin; i < range.end; ++i) {
+        uint8_t        flags  = mDirtyFlags[i];
+        const uint32_t parent = mParents[i];
+
+        if (flags & DIRTY_LOCAL) {
+            mLocalMatrices[i] = mNodes[i]->GetConcatenatedMatrix();
+            flags |= DIRTY_WORLD;
+        }
+        if ((parent != kInvalidIndex) && (mDirtyFlags[parent] & DIRTY_WORLD)) {
+            flags |= DIRTY_WORLD;
+        }
+
+        if (flags & DIRTY_WORLD) {
+            if (parent != kInvalidIndex) {
+                mWorldMatrices[i] = mWorldMatrices[parent] * mLocalMatrices[i];
+            }
+            else {
+                const scene::Node* pParent = mNodes[i]->GetParent();
+                mWorldMatrices[i]          = IsNull(pParent) ? mLocalMatrices[i] : pParent->GetEvaluatedMatrix() * mLocalMatrices[i];
+            }
+        }
+
+        mDirtyFlags[i] = flags;
+    }
+}
+
+void TransformHierarchy::UpdateWorldMatrices(uint32_t threadCount)
+{
+    if (!mDirty) {
+        return;
+    }
+
+    if (mTopologyDirty) {
+        Rebuild();
+    }
+    mDirty = false;
+
+    UpdateRange({0, mSerialEnd});
+
+    const uint32_t subtreeCount = CountU32(mSubtrees);
+    const uint32_t workerCount  = std::min(std::max<uint32_t>(threadCount, 1), std::max<uint32_t>(subtreeCount, 1)) - 1;
+    if ((workerCount == 0) || mHasExternalParents || (GetNodeCount() < kMinParallelNodeCount)) {
+        for (const auto& subtree : mSubtrees) {
+            UpdateRange(subtree);
+        }
+    }
+    else {
+        std::atomic<uint32_t> nextSubtree = 0;
+
+        auto update = [&]() {
+            for (uint32_t i = nextSubtree++; i < subtreeCount; i = nextSubtree++) {
+                UpdateRange(mSubtrees[i]);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (uint32_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back(update);
+        }
+        update();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Children read their parent's flags, so clear them after the pass
+    std::fill(mDirtyFlags.begin(), mDirtyFlags.end(), static_cast<uint8_t>(0));
+}
+
+} // namespace scene
+} // namespace ppx
@@ -0,0 +1,445 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "ppx/shader_compiler.h"
+#include "ppx/fs.h"
+#include "ppx/grfx/grfx_config.h"
+#include "ppx/thread_policy.h"
+
+#include "xxhash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <string_view>
+
+// clang-format off
+#if defined(PPX_LINUX)
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <spawn.h>
+#   include <sys/wait.h>
+#   include <unistd.h>
+extern char** environ;
+#elif defined(PPX_MSW)
+#   if ! defined(VC_EXTRALEAN)
+#       define VC_EXTRALEAN
+#   endif
+#   if ! defined(WIN32_LEAN_AND_MEAN)
+#   define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <Windows.h>
+#endif
+// clang-format on
+
+namespace ppx {
+
+namespace {
+
+// Bump when the arguments or the layout of the cache change
+constexpr XXH64_hash_t kShaderCacheSeed = 0x5f1c9e27a04d83b1;
+
+bool IsValidStage(const std::string& stage)
+{
+    static const char* const kStages[] = {"vs", "hs", "ds", "gs", "ps", "cs", "ms", "as"};
+    return std::find(std::begin(kStages), std::end(kStages), stage) != std::end(kStages);
+}
+
+// Hashes the contents of path and of the files it includes, each file once.
+// Includes that can't be found are left to the compiler to report.
+bool HashSourceFile(const std::filesystem::path& path, const std::vector<std::filesystem::path>& includeDirectories, std::set<std::filesystem::path>* pVisited, uint64_t* pHash)
+{
+    auto source = fs::load_file(path);
+    if (!source.has_value()) {
+        return false;
+    }
+    *pHash = XXH64(source.value().data(), source.value().size(), *pHash);
+
+    const std::string_view text(source.value().data(), source.value().size());
+    size_t                 pos = 0;
+    while ((pos = text.find("#include", pos)) != std::string_view::npos) {
+        pos += 8;
+        const size_t start = text.find_first_not_of(" \t", pos);
+        if ((start == std::string_view::npos) || ((text[start] != '"') && (text[start] != '<'))) {
+            continue;
+        }
+        const char   close = (text[start] == '"') ? '"' : '>';
+        const size_t end   = text.find_first_of(std::string{close, '\n'}, start + 1);
+        if ((end == std::string_view::npos) || (text[end] != close)) {
+            continue;
+        }
+
+        const std::filesystem::path        name(std::string(text.substr(start + 1, end - start - 1)));
+        std::vector<std::filesystem::path> candidates = {path.parent_path() / name};
+        for (const auto& directory : includeDirectories) {
+            candidates.push_back(directory / name);
+        }
+        for (const auto& candidate : candidates) {
+            std::error_code ec;
+            if (std::filesystem::is_regular_file(candidate, ec)) {
+                const std::filesystem::path includePath = candidate.lexically_normal();
+                if (pVisited->insert(includePath).second) {
+                    HashSourceFile(includePath, includeDirectories, pVisited, pHash);
+                }
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+#if defined(PPX_MSW)
+// Quotes an argument the way CommandLineToArgvW() splits it
+std::wstring QuoteArgument(const std::string& argument)
+{
+    const std::wstring wide       = std::filesystem::path(argument).wstring();
+    std::wstring       quoted     = L"\"";
+    size_t             slashCount = 0;
+    for (wchar_t c : wide) {
+        if (c == L'\\') {
+            ++slashCount;
+        }
+        else if (c == L'"') {
+            quoted.append(slashCount + 1, L'\\');
+            slashCount = 0;
+        }
+        else {
+            slashCount = 0;
+        }
+        quoted.push_back(c);
+    }
+    quoted.append(slashCount, L'\\');
+    quoted.push_back(L'"');
+    return quoted;
+}
+#endif
+
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+// AsyncShaderCompile
+// -------------------------------------------------------------------------------------------------
+bool AsyncShaderCompile::IsValid() const
+{
+    return mFuture.valid();
+}
+
+bool AsyncShaderCompile::IsReady() const
+{
+    return IsValid() && (mFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+}
+
+ShaderCompileResult AsyncShaderCompile::Wait()
+{
+    PPX_ASSERT_MSG(IsValid(), "waiting on an invalid shader compilation");
+    return mFuture.get();
+}
+
+// -------------------------------------------------------------------------------------------------
+// ShaderCompiler
+// -------------------------------------------------------------------------------------------------
+ShaderCompiler::ShaderCompiler()
+{
+}
+
+ShaderCompiler::~ShaderCompiler()
+{
+    Shutdown();
+}
+
+Result ShaderCompiler::Initialize(const ShaderCompilerCreateInfo& createInfo)
+{
+    PPX_ASSERT_MSG(!IsInitialized(), "shader compiler is already initialized");
+
+#if defined(PPX_ANDROID)
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#else
+    if (!grfx::IsDx12(createInfo.api) && !grfx::IsVk(createInfo.api)) {
+        return ppx::ERROR_UNSUPPORTED_API;
+    }
+
+    std::error_code ec;
+    const uintmax_t compilerSize = std::filesystem::file_size(createInfo.compilerPath, ec);
+    if (ec) {
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+    const auto compilerTime = std::filesystem::last_write_time(createInfo.compilerPath, ec).time_since_epoch().count();
+
+    if (!createInfo.cacheDirectory.empty()) {
+        std::filesystem::create_directories(createInfo.cacheDirectory, ec);
+        if (ec) {
+            return ppx::ERROR_PATH_DOES_NOT_EXIST;
+        }
+    }
+
+    // A different compiler can produce different bytecode from the same arguments
+    const uint64_t compilerInfo[2] = {static_cast<uint64_t>(compilerSize), static_cast<uint64_t>(compilerTime)};
+
+    mCreateInfo    = createInfo;
+    mCompilerHash  = XXH64(compilerInfo, sizeof(compilerInfo), kShaderCacheSeed);
+    mCompileCount  = 0;
+    mCacheHitCount = 0;
+    mStop          = false;
+
+    const uint32_t threadCount = std::max<uint32_t>(createInfo.threadCount, 1);
+    for (uint32_t i = 0; i < threadCount; ++i) {
+        mThreads.emplace_back([this]() { ThreadMain(); });
+    }
+    return ppx::SUCCESS;
+#endif
+}
+
+void ShaderCompiler::Shutdown()
+{
+    if (!IsInitialized()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mCondition.notify_all();
+    for (auto& thread : mThreads) {
+        thread.join();
+    }
+    mThreads.clear();
+}
+
+void ShaderCompiler::ThreadMain()
+{
+    ApplyThreadPolicy(THREAD_ROLE_LOADER);
+
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStop || !mTasks.empty(); });
+            // Pending compilations still complete on shutdown
+            if (mTasks.empty()) {
+                return;
+            }
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+        task();
+    }
+}
+
+AsyncShaderCompile ShaderCompiler::CompileAsync(const ShaderCompileInfo& compileInfo)
+{
+    PPX_ASSERT_MSG(IsInitialized(), "shader compiler is not initialized");
+
+    auto task = std::make_shared<std::packaged_task<ShaderCompileResult()>>([this, compileInfo]() { return Compile(compileInfo); });
+
+    AsyncShaderCompile handle;
+    handle.mFuture = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push_back([task]() { (*task)(); });
+    }
+    mCondition.notify_one();
+    return handle;
+}
+
+ShaderCompileResult ShaderCompiler::Compile(const ShaderCompileInfo& compileInfo)
+{
+    ShaderCompileResult result = {};
+
+    uint64_t key  = 0;
+    result.result = CalculateCacheKey(compileInfo, &key);
+    if (Failed(result.result)) {
+        return result;
+    }
+
+    const std::filesystem::path cachePath = GetCachePath(key);
+    if (!cachePath.empty()) {
+        auto bytecode = fs::load_file(cachePath);
+        if (bytecode.has_value() && !bytecode.value().empty()) {
+            result.result   = ppx::SUCCESS;
+            result.bytecode = std::move(bytecode.value());
+            result.cached   = true;
+            ++mCacheHitCount;
+            return result;
+        }
+    }
+
+    // Compiled next to the final path and renamed, so concurrent runs never read a partial file
+    std::error_code       ec;
+    std::filesystem::path tempDirectory = mCreateInfo.cacheDirectory;
+    if (tempDirectory.empty()) {
+        tempDirectory = std::filesystem::temp_directory_path(ec);
+    }
+    std::stringstream tempName;
+    tempName << std::hex << std::setw(16) << std::setfill('0') << key << "_" << std::chrono::steady_clock::now().time_since_epoch().count() << "_" << mTempFileCount++ << ".tmp";
+    const std::filesystem::path outputPath = tempDirectory / tempName.str();
+
+    result.result = RunCompiler(compileInfo, outputPath, &result.log);
+    ++mCompileCount;
+    if (Success(result.result)) {
+        auto bytecode = fs::load_file(outputPath);
+        if (bytecode.has_value() && !bytecode.value().empty()) {
+            result.bytecode = std::move(bytecode.value());
+        }
+        else {
+            result.result = ppx::ERROR_GRFX_INVALID_SHADER_BYTE_CODE;
+        }
+    }
+
+    if (Success(result.result) && !cachePath.empty()) {
+        std::filesystem::rename(outputPath, cachePath, ec);
+    }
+    std::filesystem::remove(outputPath, ec);
+
+    return result;
+}
+
+std::vector<std::string> ShaderCompiler::GetCompilerArguments(const ShaderCompileInfo& compileInfo) const
+{
+    // Matches cmake/ShaderCompile.cmake
+    std::vector<std::string> arguments;
+    if (grfx::IsDx12(mCreateInfo.api)) {
+        arguments = {"-T", compileInfo.stage + "_6_5", "-E", compileInfo.stage + "main", "-DPPX_DX12=1"};
+    }
+    else {
+        arguments = {"-spirv", "-fspv-preserve-interface"};
+        if ((compileInfo.stage == "ms") || (compileInfo.stage == "as")) {
+            arguments.push_back("-fspv-target-env=vulkan1.1spirv1.4");
+            arguments.push_back("-fspv-extension=SPV_EXT_mesh_shader");
+        }
+        else {
+            arguments.push_back("-fspv-target-env=vulkan1.1");
+        }
+        arguments.insert(arguments.end(), {"-fvk-use-dx-layout", "-DPPX_VULKAN=1", "-T", compileInfo.stage + "_6_6", "-E", compileInfo.stage + "main"});
+    }
+
+    for (const auto& define : compileInfo.defines) {
+        arguments.push_back("-D" + define.name + (define.value.empty() ? "" : "=" + define.value));
+    }
+    for (const auto& directory : mCreateInfo.includeDirectories) {
+        arguments.push_back("-I");
+        arguments.push_back(directory.string());
+    }
+    return arguments;
+}
+
+Result ShaderCompiler::CalculateCacheKey(const ShaderCompileInfo& compileInfo, uint64_t* pKey) const
+{
+    PPX_ASSERT_NULL_ARG(pKey);
+    if (!IsValidStage(compileInfo.stage)) {
+        return ppx::ERROR_INVALID_CREATE_ARGUMENT;
+    }
+
+    uint64_t                        hash = mCompilerHash;
+    std::set<std::filesystem::path> visited;
+    if (!HashSourceFile(compileInfo.sourcePath, mCreateInfo.includeDirectories, &visited, &hash)) {
+        return ppx::ERROR_PATH_DOES_NOT_EXIST;
+    }
+
+    for (const std::string& argument : GetCompilerArguments(compileInfo)) {
+        // Hashing the terminator keeps {"ab", "c"} and {"a", "bc"} apart
+        hash = XXH64(argument.c_str(), argument.size() + 1, hash);
+    }
+
+    *pKey = hash;
+    return ppx::SUCCESS;
+}
+
+std::filesystem::path ShaderCompiler::GetCachePath(uint64_t key) const
+{
+    if (mCreateInfo.cacheDirectory.empty()) {
+        return {};
+    }
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key << (grfx::IsDx12(mCreateInfo.api) ? ".dxil" : ".spv");
+    return mCreateInfo.cacheDirectory / ss.str();
+}
+
+Result ShaderCompiler::RunCompiler(const ShaderCompileInfo& compileInfo, const std::filesystem::path& outputPath, std::string* pLog) const
+{
+    std::vector<std::string> arguments = GetCompilerArguments(compileInfo);
+    arguments.insert(arguments.begin(), mCreateInfo.compilerPath.string());
+    arguments.insert(arguments.end(), {"-Fo", outputPath.string(), compileInfo.sourcePath.string()});
+
+    // The compiler's output goes to a file next to the bytecode
+    std::filesystem::path logPath = outputPath;
+    logPath += ".log";
+
+    bool succeeded = false;
+#if defined(PPX_LINUX)
+    std::vector<char*> argv;
+    for (auto& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, logPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+
+    pid_t pid   = 0;
+    int   error = posix_spawn(&pid, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (error == 0) {
+        int status = 0;
+        while ((waitpid(pid, &status, 0) < 0) && (errno == EINTR)) {
+        }
+        succeeded = WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+    }
+#elif defined(PPX_MSW)
+    std::wstring commandLine;
+    for (const auto& argument : arguments) {
+        commandLine += (commandLine.empty() ? L"" : L" ") + QuoteArgument(argument);
+    }
+
+    SECURITY_ATTRIBUTES attributes  = {sizeof(attributes), nullptr, TRUE};
+    HANDLE              logHandle   = CreateFileW(logPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, &attributes, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    STARTUPINFOW        startupInfo = {};
+    startupInfo.cb                  = sizeof(startupInfo);
+    startupInfo.dwFlags             = STARTF_USESTDHANDLES;
+    startupInfo.hStdOutput          = logHandle;
+    startupInfo.hStdError           = logHandle;
+
+    PROCESS_INFORMATION processInfo = {};
+    BOOL                created     = CreateProcessW(mCreateInfo.compilerPath.c_str(), commandLine.data(), nullptr, nullptr, TRUE, CREATE_NO_WINDOW, nullptr, nullptr, &startupInfo, &processInfo);
+    if (logHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(logHandle);
+    }
+    if (created) {
+        WaitForSingleObject(processInfo.hProcess, INFINITE);
+        DWORD exitCode = 1;
+        GetExitCodeProcess(processInfo.hProcess, &exitCode);
+        CloseHandle(processInfo.hThread);
+        CloseHandle(processInfo.hProcess);
+        succeeded = (exitCode == 0);
+    }
+#else
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#endif
+
+    auto log = fs::load_file(logPath);
+    if (log.has_value()) {
+        pLog->assign(log.value().begin(), log.value().end());
+    }
+    std::error_code ec;
+    std::filesystem::remove(logPath, ec);
+
+    return succeeded ? ppx::SUCCESS : ppx::ERROR_FAILED;
+}
+
+} // namespace ppx
@@ -0,0 +1,381 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/shader_hot_reload.h"
+#include "ppx/fs.h"
+#include "ppx/grfx/grfx_device.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace ppx {
+
+ShaderHotReload::ShaderHotReload()
+{
+}
+
+ShaderHotReload::~ShaderHotReload()
+{
+    Shutdown();
+}
+
+Result ShaderHotReload::Initialize(const ShaderHotReloadCreateInfo& createInfo)
+{
+    PPX_ASSERT_NULL_ARG(createInfo.pDevice);
+    PPX_ASSERT_MSG(!IsInitialized(), "shader hot reload is already initialized");
+
+    mDevice         = createInfo.pDevice;
+    mPollIntervalMs = std::max<uint32_t>(createInfo.pollIntervalMs, 1);
+    mReloadCount    = 0;
+    mStop           = false;
+    mPollThread     = std::thread([this]() { PollThreadMain(); });
+    return ppx::SUCCESS;
+}
+
+void ShaderHotReload::Shutdown()
+{
+    if (!IsInitialized()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStop = true;
+    }
+    mStopCondition.notify_all();
+    mPollThread.join();
+
+    for (auto& entry : mWatches) {
+        if (entry->IsRebuilding()) {
+            FinishRebuild(*entry, true);
+        }
+    }
+    mWatches.clear();
+    mModuleFiles.clear();
+    mFiles.clear();
+    mChangedFiles.clear();
+    mDevice = nullptr;
+}
+
+void ShaderHotReload::TrackShaderModule(const grfx::ShaderModule* pModule, const std::filesystem::path& filePath)
+{
+    PPX_ASSERT_NULL_ARG(pModule);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mModuleFiles[pModule] = filePath.string();
+}
+
+Result ShaderHotReload::Watch(grfx::GraphicsPipelinePtr* ppPipeline)
+{
+    PPX_ASSERT_NULL_ARG(ppPipeline);
+    if (IsNull(*ppPipeline)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    auto entry                = std::make_unique<WatchEntry>();
+    entry->ppGraphicsPipeline = ppPipeline;
+    entry->graphicsCreateInfo = (*ppPipeline)->GetCreateInfo();
+    return AddWatch(std::move(entry));
+}
+
+Result ShaderHotReload::Watch(grfx::ComputePipelinePtr* ppPipeline)
+{
+    PPX_ASSERT_NULL_ARG(ppPipeline);
+    if (IsNull(*ppPipeline)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    auto entry               = std::make_unique<WatchEntry>();
+    entry->ppComputePipeline = ppPipeline;
+    entry->computeCreateInfo = (*ppPipeline)->GetCreateInfo();
+    return AddWatch(std::move(entry));
+}
+
+void ShaderHotReload::Unwatch(const void* ppPipeline)
+{
+    auto it = std::find_if(mWatches.begin(), mWatches.end(), [ppPipeline](const std::unique_ptr<WatchEntry>& entry) {
+        return (entry->ppGraphicsPipeline == ppPipeline) || (entry->ppComputePipeline == ppPipeline);
+    });
+    if (it == mWatches.end()) {
+        return;
+    }
+
+    if ((*it)->IsRebuilding()) {
+        FinishRebuild(**it, true);
+    }
+    RemoveWatch(**it);
+    mWatches.erase(it);
+}
+
+std::vector<grfx::ShaderStageInfo*> ShaderHotReload::GetStages(WatchEntry& entry)
+{
+    if (entry.ppComputePipeline != nullptr) {
+        return {&entry.computeCreateInfo.CS};
+    }
+
+    grfx::GraphicsPipelineCreateInfo& ci = entry.graphicsCreateInfo;
+    return {&ci.VS, &ci.HS, &ci.DS, &ci.GS, &ci.AS, &ci.MS, &ci.PS};
+}
+
+Result ShaderHotReload::AddWatch(std::unique_ptr<WatchEntry> entry)
+{
+    PPX_ASSERT_MSG(IsInitialized(), "shader hot reload is not initialized");
+
+    // Watching a pipeline again replaces its files
+    Unwatch((entry->ppGraphicsPipeline != nullptr) ? static_cast<const void*>(entry->ppGraphicsPipeline) : entry->ppComputePipeline);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // The modules may be destroyed after this, only their files are kept
+    for (grfx::ShaderStageInfo* pStage : GetStages(*entry)) {
+        if (IsNull(pStage->pModule)) {
+            entry->stageFiles.emplace_back();
+            continue;
+        }
+
+        auto it = mModuleFiles.find(pStage->pModule);
+        if (it == mModuleFiles.end()) {
+            PPX_LOG_ERROR("Cannot hot reload a pipeline with a shader module that wasn't loaded with Application::CreateShader()");
+            return ppx::ERROR_ELEMENT_NOT_FOUND;
+        }
+        entry->stageFiles.emplace_back(it->second);
+        pStage->pModule = nullptr;
+    }
+
+    for (const auto& file : entry->stageFiles) {
+        if (file.empty()) {
+            continue;
+        }
+        FileState& state = mFiles[file.string()];
+        if (state.refCount++ == 0) {
+            std::error_code ec;
+            state.time = std::filesystem::last_write_time(file, ec);
+        }
+    }
+
+    mWatches.push_back(std::move(entry));
+    return ppx::SUCCESS;
+}
+
+void ShaderHotReload::RemoveWatch(WatchEntry& entry)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (const auto& file : entry.stageFiles) {
+        auto it = mFiles.find(file.string());
+        if ((it != mFiles.end()) && (--it->second.refCount == 0)) {
+            mFiles.erase(it);
+        }
+    }
+}
+
+void ShaderHotReload::Update()
+{
+    if (!IsInitialized()) {
+        return;
+    }
+
+    std::vector<std::string> changedFiles;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        changedFiles.swap(mChangedFiles);
+    }
+    for (const auto& file : changedFiles) {
+        PPX_LOG_INFO("Shader changed: " << file);
+        for (auto& entry : mWatches) {
+            if (std::find(entry->stageFiles.begin(), entry->stageFiles.end(), std::filesystem::path(file)) != entry->stageFiles.end()) {
+                entry->dirty = true;
+            }
+        }
+    }
+
+    for (auto& entry : mWatches) {
+        if (entry->IsRebuilding()) {
+            FinishRebuild(*entry, false);
+        }
+        // A file that changed during a rebuild starts another one
+        if (entry->dirty && !entry->IsRebuilding()) {
+            entry->dirty = false;
+            StartRebuild(*entry);
+        }
+    }
+}
+
+Result ShaderHotReload::StartRebuild(WatchEntry& entry)
+{
+    std::vector<grfx::ShaderStageInfo*> stages = GetStages(entry);
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const std::filesystem::path& file = entry.stageFiles[i];
+        if (file.empty()) {
+            continue;
+        }
+
+        auto bytecode = fs::load_file(file);
+        if (!bytecode.has_value() || bytecode->empty()) {
+            PPX_LOG_ERROR("Could not reload shader " << file);
+            FinishRebuild(entry, true);
+            return ppx::ERROR_PATH_DOES_NOT_EXIST;
+        }
+
+        grfx::ShaderModuleCreateInfo createInfo = {static_cast<uint32_t>(bytecode->size()), bytecode->data()};
+        grfx::ShaderModulePtr        module;
+        Result                       ppxres = mDevice->CreateShaderModule(&createInfo, &module);
+        if (Failed(ppxres)) {
+            PPX_LOG_ERROR("Could not create shader module for " << file << ": " << ToString(ppxres));
+            FinishRebuild(entry, true);
+            return ppxres;
+        }
+        entry.modules.push_back(module);
+        stages[i]->pModule = module;
+    }
+
+    Result ppxres = ppx::SUCCESS;
+    if (entry.ppGraphicsPipeline != nullptr) {
+        ppxres = mDevice->CreateGraphicsPipelineAsync(&entry.graphicsCreateInfo, &entry.graphicsPipeline);
+    }
+    else {
+        ppxres = mDevice->CreateComputePipelineAsync(&entry.computeCreateInfo, &entry.computePipeline);
+    }
+
+    // The create info was copied, the modules are kept in entry.modules
+    for (grfx::ShaderStageInfo* pStage : stages) {
+        pStage->pModule = nullptr;
+    }
+
+    if (Failed(ppxres)) {
+        PPX_LOG_ERROR("Could not start pipeline rebuild: " << ToString(ppxres));
+        FinishRebuild(entry, true);
+    }
+    return ppxres;
+}
+
+void ShaderHotReload::FinishRebuild(WatchEntry& entry, bool discard)
+{
+    Result ppxres = ppx::SUCCESS;
+    if (entry.ppGraphicsPipeline != nullptr) {
+        if (!discard && !entry.graphicsPipeline.IsReady()) {
+            return;
+        }
+        if (entry.graphicsPipeline.IsValid()) {
+            ppxres = entry.graphicsPipeline.Wait();
+        }
+    }
+    else {
+        if (!discard && !entry.computePipeline.IsReady()) {
+            return;
+        }
+        if (entry.computePipeline.IsValid()) {
+            ppxres = entry.computePipeline.Wait();
+        }
+    }
+
+    // Pipelines don't need their shader modules once they're created
+    for (auto& module : entry.modules) {
+        mDevice->DestroyShaderModule(module);
+    }
+    entry.modules.clear();
+
+    bool swapped = false;
+    if (entry.ppGraphicsPipeline != nullptr) {
+        grfx::GraphicsPipelinePtr pipeline = entry.graphicsPipeline.Get();
+        entry.graphicsPipeline.Reset();
+        if (!IsNull(pipeline) && discard) {
+            mDevice->DestroyGraphicsPipeline(pipeline);
+        }
+        else if (!IsNull(pipeline)) {
+            // Frames in flight may still use the old pipeline
+            mDevice->DeferDestroyGraphicsPipeline(*entry.ppGraphicsPipeline);
+            *entry.ppGraphicsPipeline = pipeline;
+            swapped                   = true;
+        }
+    }
+    else {
+        grfx::ComputePipelinePtr pipeline = entry.computePipeline.Get();
+        entry.computePipeline.Reset();
+        if (!IsNull(pipeline) && discard) {
+            mDevice->DestroyComputePipeline(pipeline);
+        }
+        else if (!IsNull(pipeline)) {
+            mDevice->DeferDestroyComputePipeline(*entry.ppComputePipeline);
+            *entry.ppComputePipeline = pipeline;
+            swapped                  = true;
+        }
+    }
+
+    if (swapped) {
+        std::string files;
+        for (const auto& file : entry.stageFiles) {
+            if (!file.empty()) {
+                files += (files.empty() ? "" : ", ") + file.string();
+            }
+        }
+        ++mReloadCount;
+        PPX_LOG_INFO("Reloaded pipeline of " << files);
+    }
+    else if (!discard && Failed(ppxres)) {
+        PPX_LOG_ERROR("Pipeline rebuild failed, keeping the previous pipeline: " << ToString(ppxres));
+    }
+}
+
+void ShaderHotReload::PollThreadMain()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStop) {
+        mStopCondition.wait_for(lock, std::chrono::milliseconds(mPollIntervalMs), [this]() { return mStop; });
+        if (mStop) {
+            break;
+        }
+
+        std::vector<std::string> files;
+        files.reserve(mFiles.size());
+        for (const auto& it : mFiles) {
+            files.push_back(it.first);
+        }
+
+        // Stat without holding the lock, Update() and TrackShaderModule() may be waiting on it
+        lock.unlock();
+        std::vector<std::pair<std::string, std::filesystem::file_time_type>> times;
+        for (auto& file : files) {
+            std::error_code ec;
+            auto            time = std::filesystem::last_write_time(file, ec);
+            if (!ec) {
+                times.emplace_back(std::move(file), time);
+            }
+        }
+        lock.lock();
+
+        for (const auto& [file, time] : times) {
+            auto it = mFiles.find(file);
+            if (it == mFiles.end()) {
+                continue;
+            }
+
+            FileState& state = it->second;
+            if (time == state.time) {
+                state.pending = false;
+                continue;
+            }
+            // Wait for the time to settle, the compiler may still be writing
+            if (!state.pending || (time != state.pendingTime)) {
+                state.pending     = true;
+                state.pendingTime = time;
+                continue;
+            }
+            state.time    = time;
+            state.pending = false;
+            mChangedFiles.push_back(file);
+        }
+    }
+}
+
+} // namespace ppx
@@ -0,0 +1,335 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/thread_policy.h"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+// clang-format off
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#   include <sched.h>
+#   include <sys/resource.h>
+#   include <unistd.h>
+#elif defined(PPX_MSW)
+#   if ! defined(VC_EXTRALEAN)
+#       define VC_EXTRALEAN
+#   endif
+#   if ! defined(WIN32_LEAN_AND_MEAN)
+#   define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <Windows.h>
+#endif
+// clang-format on
+
+namespace ppx {
+
+static std::mutex   sThreadPolicyMutex;
+static ThreadPolicy sThreadPolicies[THREAD_ROLE_COUNT];
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+static uint64_t GetCpuMaxFrequency(uint32_t cpu)
+{
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/cpuinfo_max_freq");
+    uint64_t      frequency = 0;
+    if (!(file >> frequency)) {
+        return 0;
+    }
+    return frequency;
+}
+#endif
+
+std::vector<uint32_t> GetCoreTypeCpus(CoreType type)
+{
+    std::vector<uint32_t> cpus;
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+    if (type == CORE_TYPE_ANY) {
+        return cpus;
+    }
+
+    const uint32_t        cpuCount = std::thread::hardware_concurrency();
+    std::vector<uint64_t> frequencies(cpuCount);
+    for (uint32_t cpu = 0; cpu < cpuCount; ++cpu) {
+        frequencies[cpu] = GetCpuMaxFrequency(cpu);
+    }
+
+    const auto [minIt, maxIt] = std::minmax_element(frequencies.begin(), frequencies.end());
+    if ((minIt == frequencies.end()) || (*minIt == 0) || (*minIt == *maxIt)) {
+        return cpus;
+    }
+
+    const uint64_t frequency = (type == CORE_TYPE_BIG) ? *maxIt : *minIt;
+    for (uint32_t cpu = 0; cpu < cpuCount; ++cpu) {
+        if (frequencies[cpu] == frequency) {
+            cpus.push_back(cpu);
+        }
+    }
+#else
+    (void)type;
+#endif
+    return cpus;
+}
+
+static bool ParseUint(const std::string& text, uint32_t* pValue)
+{
+    if (text.empty() || (text.size() > 9) || !std::all_of(text.begin(), text.end(), [](char c) { return (c >= '0') && (c <= '9'); })) {
+        return false;
+    }
+    *pValue = static_cast<uint32_t>(std::stoul(text));
+    return true;
+}
+
+Result ParseCpuSet(const std::string& spec, std::vector<uint32_t>* pCpus)
+{
+    PPX_ASSERT_NULL_ARG(pCpus);
+    if (IsNull(pCpus)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    pCpus->clear();
+    if (spec.empty() || (spec == "any")) {
+        return ppx::SUCCESS;
+    }
+    if (spec == "big") {
+        *pCpus = GetCoreTypeCpus(CORE_TYPE_BIG);
+        return ppx::SUCCESS;
+    }
+    if (spec == "little") {
+        *pCpus = GetCoreTypeCpus(CORE_TYPE_LITTLE);
+        return ppx::SUCCESS;
+    }
+
+    // Comma separated CPUs and ranges of CPUs
+    size_t begin = 0;
+    while (begin <= spec.size()) {
+        const size_t      end   = std::min(spec.find(',', begin), spec.size());
+        const std::string item  = spec.substr(begin, end - begin);
+        const size_t      dash  = item.find('-');
+        uint32_t          first = 0;
+        uint32_t          last  = 0;
+        if (dash == std::string::npos) {
+            if (!ParseUint(item, &first)) {
+                pCpus->clear();
+                return ppx::ERROR_FAILED;
+            }
+            last = first;
+        }
+        else if (!ParseUint(item.substr(0, dash), &first) || !ParseUint(item.substr(dash + 1), &last) || (last < first)) {
+            pCpus->clear();
+            return ppx::ERROR_FAILED;
+        }
+
+        for (uint32_t cpu = first; cpu <= last; ++cpu) {
+            pCpus->push_back(cpu);
+        }
+        begin = end + 1;
+    }
+
+    std::sort(pCpus->begin(), pCpus->end());
+    pCpus->erase(std::unique(pCpus->begin(), pCpus->end()), pCpus->end());
+    return ppx::SUCCESS;
+}
+
+Result ParseThreadPriority(const std::string& name, ThreadPriority* pPriority)
+{
+    PPX_ASSERT_NULL_ARG(pPriority);
+    if (IsNull(pPriority)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    if (name == "default") {
+        *pPriority = THREAD_PRIORITY_DEFAULT;
+    }
+    else if (name == "low") {
+        *pPriority = THREAD_PRIORITY_LOW;
+    }
+    else if (name == "high") {
+        *pPriority = THREAD_PRIORITY_HIGH;
+    }
+    else if (name == "urgent") {
+        *pPriority = THREAD_PRIORITY_URGENT;
+    }
+    else {
+        return ppx::ERROR_FAILED;
+    }
+    return ppx::SUCCESS;
+}
+
+// Calls fn(role, value) for each "role=value" pair of options
+template <typename Fn>
+static Result ParseRoleValues(const std::string& options, Fn fn)
+{
+    size_t begin = 0;
+    while (begin < options.size()) {
+        const size_t      end    = std::min(options.find(';', begin), options.size());
+        const std::string option = options.substr(begin, end - begin);
+        begin                    = end + 1;
+        if (option.empty()) {
+            continue;
+        }
+
+        const size_t equals = option.find('=');
+        if (equals == std::string::npos) {
+            return ppx::ERROR_FAILED;
+        }
+
+        const std::string name = option.substr(0, equals);
+        uint32_t          role = 0;
+        while ((role < THREAD_ROLE_COUNT) && (name != GetThreadRoleName(static_cast<ThreadRole>(role)))) {
+            ++role;
+        }
+        if (role == THREAD_ROLE_COUNT) {
+            return ppx::ERROR_FAILED;
+        }
+
+        Result ppxres = fn(static_cast<ThreadRole>(role), option.substr(equals + 1));
+        if (Failed(ppxres)) {
+            return ppxres;
+        }
+    }
+    return ppx::SUCCESS;
+}
+
+Result ParseThreadPolicies(const std::string& affinity, const std::string& priority, ThreadPolicy* pPolicies)
+{
+    PPX_ASSERT_NULL_ARG(pPolicies);
+    if (IsNull(pPolicies)) {
+        return ppx::ERROR_UNEXPECTED_NULL_ARGUMENT;
+    }
+
+    Result ppxres = ParseRoleValues(affinity, [pPolicies](ThreadRole role, const std::string& value) {
+        return ParseCpuSet(value, &pPolicies[role].cpus);
+    });
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    return ParseRoleValues(priority, [pPolicies](ThreadRole role, const std::string& value) {
+        return ParseThreadPriority(value, &pPolicies[role].priority);
+    });
+}
+
+const char* GetThreadRoleName(ThreadRole role)
+{
+    switch (role) {
+        case THREAD_ROLE_RENDER: return "render";
+        case THREAD_ROLE_GAME: return "game";
+        case THREAD_ROLE_LOADER: return "loader";
+        case THREAD_ROLE_JOB_WORKER: return "jobs";
+        default: break;
+    }
+    return "<unknown>";
+}
+
+const char* GetThreadPriorityName(ThreadPriority priority)
+{
+    switch (priority) {
+        case THREAD_PRIORITY_DEFAULT: return "default";
+        case THREAD_PRIORITY_LOW: return "low";
+        case THREAD_PRIORITY_HIGH: return "high";
+        case THREAD_PRIORITY_URGENT: return "urgent";
+        default: break;
+    }
+    return "<unknown>";
+}
+
+Result SetCurrentThreadAffinity(const std::vector<uint32_t>& cpus)
+{
+    if (cpus.empty()) {
+        return ppx::SUCCESS;
+    }
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return (sched_setaffinity(0, sizeof(set), &set) == 0) ? ppx::SUCCESS : ppx::ERROR_FAILED;
+#elif defined(PPX_MSW)
+    // The thread's processor group only
+    DWORD_PTR mask = 0;
+    for (uint32_t cpu : cpus) {
+        if (cpu < 8 * sizeof(DWORD_PTR)) {
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+        }
+    }
+    return ((mask != 0) && (SetThreadAffinityMask(GetCurrentThread(), mask) != 0)) ? ppx::SUCCESS : ppx::ERROR_FAILED;
+#else
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#endif
+}
+
+Result SetCurrentThreadPriority(ThreadPriority priority)
+{
+    if (priority == THREAD_PRIORITY_DEFAULT) {
+        return ppx::SUCCESS;
+    }
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+    // Nice values apply per thread on Linux. High and urgent match
+    // Android's display and urgent display priorities, raising the
+    // priority on desktop Linux needs CAP_SYS_NICE or RLIMIT_NICE.
+    int nice = 0;
+    switch (priority) {
+        case THREAD_PRIORITY_LOW: nice = 10; break;
+        case THREAD_PRIORITY_HIGH: nice = -4; break;
+        case THREAD_PRIORITY_URGENT: nice = -8; break;
+        default: break;
+    }
+    return (setpriority(PRIO_PROCESS, static_cast<id_t>(gettid()), nice) == 0) ? ppx::SUCCESS : ppx::ERROR_FAILED;
+#elif defined(PPX_MSW)
+    int value = THREAD_PRIORITY_NORMAL;
+    switch (priority) {
+        case THREAD_PRIORITY_LOW: value = THREAD_PRIORITY_BELOW_NORMAL; break;
+        case THREAD_PRIORITY_HIGH: value = THREAD_PRIORITY_ABOVE_NORMAL; break;
+        case THREAD_PRIORITY_URGENT: value = THREAD_PRIORITY_HIGHEST; break;
+        default: break;
+    }
+    return (SetThreadPriority(GetCurrentThread(), value) != 0) ? ppx::SUCCESS : ppx::ERROR_FAILED;
+#else
+    return ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE;
+#endif
+}
+
+void SetThreadPolicy(ThreadRole role, const ThreadPolicy& policy)
+{
+    PPX_ASSERT_MSG(role < THREAD_ROLE_COUNT, "invalid thread role");
+    std::lock_guard<std::mutex> lock(sThreadPolicyMutex);
+    sThreadPolicies[role] = policy;
+}
+
+ThreadPolicy GetThreadPolicy(ThreadRole role)
+{
+    PPX_ASSERT_MSG(role < THREAD_ROLE_COUNT, "invalid thread role");
+    std::lock_guard<std::mutex> lock(sThreadPolicyMutex);
+    return sThreadPolicies[role];
+}
+
+void ApplyThreadPolicy(ThreadRole role)
+{
+    const ThreadPolicy policy = GetThreadPolicy(role);
+    if (Failed(SetCurrentThreadAffinity(policy.cpus))) {
+        PPX_LOG_WARN("failed setting the affinity of a " << GetThreadRoleName(role) << " thread");
+    }
+    if (Failed(SetCurrentThreadPriority(policy.priority))) {
+        PPX_LOG_WARN("failed setting the priority of a " << GetThreadRoleName(role) << " thread");
+    }
+}
+
+} // namespace ppx
@@ -17,10 +17,41 @@
 #include "ppx/timer.h"
 #include "ppx/fs.h"
 
-#include "tiny_obj_loader.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
 
 namespace ppx {
 
+// Generated meshes get a thread per this many vertices
+static constexpr uint32_t kMinGeneratedVerticesPerTask = 16384;
+
+// Runs fn(task) for every task in [0, taskCount), on taskCount threads
+// including the calling one
+template <typename Fn>
+static void ForEachTask(uint32_t taskCount, Fn fn)
+{
+    std::atomic<uint32_t> nextTask = 0;
+
+    auto run = [&]() {
+        for (uint32_t i = nextTask++; i < taskCount; i = nextTask++) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < taskCount; ++i) {
+        workers.emplace_back(run);
+    }
+    run();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
 TriMesh::TriMesh()
 {
 }
@@ -448,6 +479,61 @@ uint32_t TriMesh::AppendBitangent(const float3& value)
     return count;
 }
 
+TriMesh::VertexSpans TriMesh::AppendVertices(uint32_t count, bool enableColors, bool enableNormals, bool enableTexCoords, bool enableTangents)
+{
+    VertexSpans spans = {};
+    spans.first       = GetCountPositions();
+    spans.count       = count;
+
+    const size_t size = static_cast<size_t>(spans.first) + count;
+    mPositions.resize(size);
+    spans.pPositions = mPositions.data() + spans.first;
+
+    if (enableColors) {
+        PPX_ASSERT_MSG(GetCountColors() == spans.first, "color count doesn't match position count");
+        mColors.resize(size);
+        spans.pColors = mColors.data() + spans.first;
+    }
+    if (enableNormals) {
+        PPX_ASSERT_MSG(GetCountNormals() == spans.first, "normal count doesn't match position count");
+        mNormals.resize(size);
+        spans.pNormals = mNormals.data() + spans.first;
+    }
+    if (enableTexCoords) {
+        PPX_ASSERT_MSG(mTexCoordDim != TRI_MESH_ATTRIBUTE_DIM_UNDEFINED, "texture coordinates need a dimension");
+        PPX_ASSERT_MSG(GetCountTexCoords() == spans.first, "texture coordinate count doesn't match position count");
+        const size_t dim = static_cast<size_t>(mTexCoordDim);
+        mTexCoords.resize(size * dim);
+        spans.pTexCoords = mTexCoords.data() + spans.first * dim;
+    }
+    if (enableTangents) {
+        PPX_ASSERT_MSG((GetCountTangents() == spans.first) && (GetCountBitangents() == spans.first), "tangent count doesn't match position count");
+        mTangents.resize(size);
+        mBitangents.resize(size);
+        spans.pTangents   = mTangents.data() + spans.first;
+        spans.pBitangents = mBitangents.data() + spans.first;
+    }
+
+    return spans;
+}
+
+uint32_t* TriMesh::AppendTriangles(uint32_t triangleCount)
+{
+    PPX_ASSERT_MSG(mIndexType == grfx::INDEX_TYPE_UINT32, "triangles can only be appended to UINT32 indices");
+    const size_t offset = mIndices.size();
+    mIndices.resize(offset + 3 * static_cast<size_t>(triangleCount) * sizeof(uint32_t));
+    return reinterpret_cast<uint32_t*>(mIndices.data() + offset);
+}
+
+void TriMesh::UpdateBoundingBox()
+{
+    mBoundingBoxMin = mBoundingBoxMax = mPositions.empty() ? float3(0) : mPositions[0];
+    for (const float3& position : mPositions) {
+        mBoundingBoxMin = glm::min(mBoundingBoxMin, position);
+        mBoundingBoxMax = glm::max(mBoundingBoxMax, position);
+    }
+}
+
 Result TriMesh::GetTriangle(uint32_t triIndex, uint32_t& v0, uint32_t& v1, uint32_t& v2) const
 {
     if (mIndexType == grfx::INDEX_TYPE_UNDEFINED) {
@@ -518,6 +604,152 @@ Result TriMesh::GetVertexData(uint32_t vtxIndex, TriMeshVertexData* pVertexData)
     return ppx::SUCCESS;
 }
 
+void TriMesh::GetIndices(std::vector<uint32_t>& indices) const
+{
+    const uint32_t indexCount = GetCountIndices();
+    indices.resize(indexCount);
+    for (uint32_t i = 0; i < indexCount; ++i) {
+        indices[i] = (mIndexType == grfx::INDEX_TYPE_UINT16) ? *GetDataIndicesU16(i) : *GetDataIndicesU32(i);
+    }
+}
+
+void TriMesh::SetIndices(const std::vector<uint32_t>& indices)
+{
+    mIndices.clear();
+    for (uint32_t index : indices) {
+        if (mIndexType == grfx::INDEX_TYPE_UINT16) {
+            AppendIndexU16(static_cast<uint16_t>(index));
+        }
+        else {
+            AppendIndexU32(index);
+        }
+    }
+}
+
+void TriMesh::RemapVertices(const std::vector<uint32_t>& remap, uint32_t newVertexCount)
+{
+    auto remapAttribute = [&remap, newVertexCount](auto& values, uint32_t elementCount) {
+        if (values.empty()) {
+            return;
+        }
+        std::remove_reference_t<decltype(values)> remapped(static_cast<size_t>(newVertexCount) * elementCount);
+        for (size_t v = 0; v < remap.size(); ++v) {
+            for (uint32_t i = 0; i < elementCount; ++i) {
+                remapped[remap[v] * elementCount + i] = values[v * elementCount + i];
+            }
+        }
+        values.swap(remapped);
+    };
+
+    const uint32_t texCoordElementCount = static_cast<uint32_t>(mTexCoordDim);
+    remapAttribute(mPositions, 1);
+    remapAttribute(mColors, 1);
+    remapAttribute(mNormals, 1);
+    remapAttribute(mTexCoords, texCoordElementCount);
+    remapAttribute(mTangents, 1);
+    remapAttribute(mBitangents, 1);
+}
+
+void TriMesh::Optimize(const MeshOptimizeOptions& options)
+{
+    if (!options.IsEnabled() || (mIndexType == grfx::INDEX_TYPE_UNDEFINED)) {
+        return;
+    }
+    PPX_ASSERT_MSG(mLods.empty(), "meshes must be optimized before their LODs are generated");
+
+    std::vector<uint32_t> indices;
+    GetIndices(indices);
+
+    std::vector<uint32_t> remap;
+    OptimizeMesh(options, indices.data(), CountU32(indices), reinterpret_cast<const float*>(mPositions.data()), sizeof(float3), GetCountPositions(), &remap);
+
+    SetIndices(indices);
+    if (!remap.empty()) {
+        RemapVertices(remap, GetCountPositions());
+    }
+}
+
+void TriMesh::GenerateLods(const MeshLodOptions& options)
+{
+    if (!options.IsEnabled() || (mIndexType == grfx::INDEX_TYPE_UNDEFINED)) {
+        return;
+    }
+
+    // LODs are always generated from the full detail indices
+    std::vector<uint32_t> indices;
+    GetIndices(indices);
+    indices.resize(GetLod(0).indexCount);
+
+    GenerateMeshLods(options, &indices, reinterpret_cast<const float*>(mPositions.data()), sizeof(float3), GetCountPositions(), &mLods);
+    SetIndices(indices);
+}
+
+MeshLod TriMesh::GetLod(uint32_t index) const
+{
+    if (mLods.empty()) {
+        PPX_ASSERT_MSG(index == 0, "LOD index out of range");
+        return MeshLod{0, GetCountIndices(), 0};
+    }
+    PPX_ASSERT_MSG(index < mLods.size(), "LOD index out of range");
+    return mLods[index];
+}
+
+uint32_t TriMesh::WeldVertices()
+{
+    const uint32_t vertexCount = GetCountPositions();
+    if (mIndexType == grfx::INDEX_TYPE_UNDEFINED) {
+        return vertexCount;
+    }
+
+    // Vertices are identical if the bytes of all of their attributes are
+    const uint32_t texCoordElementCount = static_cast<uint32_t>(mTexCoordDim);
+
+    auto appendBytes = [](std::string& key, const auto* pValue, size_t size) {
+        key.append(reinterpret_cast<const char*>(pValue), size);
+    };
+
+    std::unordered_map<std::string, uint32_t> uniqueVertices;
+    std::vector<uint32_t>                     remap(vertexCount);
+    std::string                               key;
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        key.clear();
+        appendBytes(key, &mPositions[v], sizeof(float3));
+        if (!mColors.empty()) {
+            appendBytes(key, &mColors[v], sizeof(float3));
+        }
+        if (!mNormals.empty()) {
+            appendBytes(key, &mNormals[v], sizeof(float3));
+        }
+        if (!mTexCoords.empty()) {
+            appendBytes(key, &mTexCoords[v * texCoordElementCount], texCoordElementCount * sizeof(float));
+        }
+        if (!mTangents.empty()) {
+            appendBytes(key, &mTangents[v], sizeof(float4));
+        }
+        if (!mBitangents.empty()) {
+            appendBytes(key, &mBitangents[v], sizeof(float3));
+        }
+
+        auto it  = uniqueVertices.emplace(key, CountU32(uniqueVertices)).first;
+        remap[v] = it->second;
+    }
+
+    const uint32_t newVertexCount = CountU32(uniqueVertices);
+    if (newVertexCount == vertexCount) {
+        return vertexCount;
+    }
+
+    std::vector<uint32_t> indices;
+    GetIndices(indices);
+    for (auto& index : indices) {
+        index = remap[index];
+    }
+
+    SetIndices(indices);
+    RemapVertices(remap, newVertexCount);
+    return newVertexCount;
+}
+
 void TriMesh::AppendIndexAndVertexData(
     std::vector<uint32_t>&    indexData,
     const std::vector<float>& vertexData,
@@ -566,6 +798,9 @@ void TriMesh::AppendIndexAndVertexData(
             uint32_t v2 = indexData[3 * triIndex + 2];
             mesh.AppendTriangle(v0, v1, v2);
         }
+
+        mesh.Optimize(options.mOptimize);
+        mesh.GenerateLods(options.mLods);
     }
     else {
         for (size_t i = 0; i < indexData.size(); ++i) {
@@ -593,6 +828,60 @@ void TriMesh::AppendIndexAndVertexData(
         }
     }
 }
+void TriMesh::AppendGeneratedData(
+    const std::vector<uint32_t>&                             indexData,
+    uint32_t                                                 vertexCount,
+    const std::function<void(uint32_t, TriMeshVertexData*)>& vertexFn,
+    const TriMeshOptions&                                    options,
+    TriMesh&                                                 mesh)
+{
+    // Unindexed meshes get a vertex per index, applying options the way
+    // AppendIndexAndVertexData() does
+    const bool     indexed     = options.mEnableIndices;
+    const bool     colors      = options.mEnableVertexColors || (indexed && options.mEnableObjectColor);
+    const bool     objectColor = indexed && options.mEnableObjectColor;
+    const float2   uvScale     = indexed ? options.mTexCoordScale : float2(1, 1);
+    const uint32_t count       = indexed ? vertexCount : CountU32(indexData);
+    PPX_ASSERT_MSG(!options.mEnableTexCoords || (mesh.GetTexCoordDim() == TRI_MESH_ATTRIBUTE_DIM_2), "generated meshes have 2-dimensional texture coordinates");
+
+    const VertexSpans spans     = mesh.AppendVertices(count, colors, options.mEnableNormals, options.mEnableTexCoords, options.mEnableTangents);
+    const uint32_t    maxTasks  = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    const uint32_t    taskCount = std::clamp<uint32_t>(count / kMinGeneratedVerticesPerTask, 1, maxTasks);
+
+    ForEachTask(taskCount, [&](uint32_t task) {
+        const uint32_t begin = static_cast<uint32_t>((static_cast<uint64_t>(count) * task) / taskCount);
+        const uint32_t end   = static_cast<uint32_t>((static_cast<uint64_t>(count) * (task + 1)) / taskCount);
+
+        TriMeshVertexData vertex = {};
+        for (uint32_t i = begin; i < end; ++i) {
+            vertexFn(indexed ? i : indexData[i], &vertex);
+
+            spans.pPositions[i] = vertex.position * options.mScale;
+            if (colors) {
+                spans.pColors[i] = objectColor ? options.mObjectColor : vertex.color;
+            }
+            if (options.mEnableNormals) {
+                spans.pNormals[i] = vertex.normal;
+            }
+            if (options.mEnableTexCoords) {
+                spans.pTexCoords[2 * i + 0] = vertex.texCoord.x * uvScale.x;
+                spans.pTexCoords[2 * i + 1] = vertex.texCoord.y * uvScale.y;
+            }
+            if (options.mEnableTangents) {
+                spans.pTangents[i]   = vertex.tangent;
+                spans.pBitangents[i] = vertex.bitangent;
+            }
+        }
+    });
+    mesh.UpdateBoundingBox();
+
+    if (indexed) {
+        std::memcpy(mesh.AppendTriangles(CountU32(indexData) / 3), indexData.data(), indexData.size() * sizeof(uint32_t));
+
+        mesh.Optimize(options.mOptimize);
+        mesh.GenerateLods(options.mLods);
+    }
+}
 
 TriMesh TriMesh::CreatePlane(TriMeshPlane plane, const float2& size, uint32_t usegs, uint32_t vsegs, const TriMeshOptions& options)
 {
@@ -603,68 +892,50 @@ TriMesh TriMesh::CreatePlane(TriMeshPlane plane, const float2& size, uint32_t us
     const uint32_t uverts = usegs + 1;
     const uint32_t vverts = vsegs + 1;
 
-    std::vector<float> vertexData;
-    for (uint32_t j = 0; j < vverts; ++j) {
-        for (uint32_t i = 0; i < uverts; ++i) {
-            float s = i * ds / size.x;
-            float t = j * dt / size.y;
-            float u = options.mTexCoordScale.x * s;
-            float v = options.mTexCoordScale.y * t;
-
-            // float3 position  = float3(s - hx, 0, t - hz);
-            float3 position = float3(0);
-            switch (plane) {
-                default: {
-                    PPX_ASSERT_MSG(false, "unknown plane orientation");
-                } break;
-
-                // case TRI_MESH_PLANE_POSITIVE_X: {
+    // Vertex (i, j) is at index j * uverts + i
+    auto vertexFn = [=](uint32_t index, TriMeshVertexData* pVertex) {
+        uint32_t i = index % uverts;
+        uint32_t j = index / uverts;
+        float    s = i * ds / size.x;
+        float    t = j * dt / size.y;
+        float    u = options.mTexCoordScale.x * s;
+        float    v = options.mTexCoordScale.y * t;
+
+        // float3 position  = float3(s - hx, 0, t - hz);
+        float3 position = float3(0);
+        switch (plane) {
+            default: {
+                PPX_ASSERT_MSG(false, "unknown plane orientation");
+            } break;
+
+            // case TRI_MESH_PLANE_POSITIVE_X: {
+            // } break;
+            //
+            // case TRI_MESH_PLANE_NEGATIVE_X: {
+            // } break;
+            //
+            case TRI_MESH_PLANE_POSITIVE_Y: {
+                position = float3(s * size.x - hs, 0, t * size.y - ht);
+            } break;
+
+            case TRI_MESH_PLANE_NEGATIVE_Y: {
+                position = float3((1.0f - s) * size.x - hs, 0, (1.0f - t) * size.y - ht);
+            } break;
+
+                // case TRI_MESH_PLANE_POSITIVE_Z: {
                 // } break;
                 //
-                // case TRI_MESH_PLANE_NEGATIVE_X: {
+                // case TRI_MESH_PLANE_NEGATIVE_Z: {
                 // } break;
-                //
-                case TRI_MESH_PLANE_POSITIVE_Y: {
-                    position = float3(s * size.x - hs, 0, t * size.y - ht);
-                } break;
-
-                case TRI_MESH_PLANE_NEGATIVE_Y: {
-                    position = float3((1.0f - s) * size.x - hs, 0, (1.0f - t) * size.y - ht);
-                } break;
-
-                    // case TRI_MESH_PLANE_POSITIVE_Z: {
-                    // } break;
-                    //
-                    // case TRI_MESH_PLANE_NEGATIVE_Z: {
-                    // } break;
-            }
-
-            float3 color     = float3(u, v, 0);
-            float3 normal    = float3(0, 1, 0);
-            float2 texcoord  = float2(u, v);
-            float4 tangent   = float4(0.0f, 0.0f, 0.0f, 1.0f);
-            float3 bitangent = glm::cross(normal, float3(tangent));
-
-            vertexData.push_back(position.x);
-            vertexData.push_back(position.y);
-            vertexData.push_back(position.z);
-            vertexData.push_back(color.r);
-            vertexData.push_back(color.g);
-            vertexData.push_back(color.b);
-            vertexData.push_back(normal.x);
-            vertexData.push_back(normal.y);
-            vertexData.push_back(normal.z);
-            vertexData.push_back(texcoord.x);
-            vertexData.push_back(texcoord.y);
-            vertexData.push_back(tangent.x);
-            vertexData.push_back(tangent.y);
-            vertexData.push_back(tangent.z);
-            vertexData.push_back(tangent.w);
-            vertexData.push_back(bitangent.x);
-            vertexData.push_back(bitangent.y);
-            vertexData.push_back(bitangent.z);
         }
-    }
+
+        pVertex->position  = position;
+        pVertex->color     = float3(u, v, 0);
+        pVertex->normal    = float3(0, 1, 0);
+        pVertex->texCoord  = float2(u, v);
+        pVertex->tangent   = float4(0.0f, 0.0f, 0.0f, 1.0f);
+        pVertex->bitangent = glm::cross(pVertex->normal, float3(pVertex->tangent));
+    };
 
     std::vector<uint32_t> indexData;
     for (uint32_t i = 1; i < uverts; ++i) {
@@ -722,8 +993,7 @@ TriMesh TriMesh::CreatePlane(TriMeshPlane plane, const float2& size, uint32_t us
     TriMeshAttributeDim texCoordDim = options.mEnableTexCoords ? TRI_MESH_ATTRIBUTE_DIM_2 : TRI_MESH_ATTRIBUTE_DIM_UNDEFINED;
     TriMesh             mesh        = TriMesh(indexType, texCoordDim);
 
-    uint32_t expectedVertexCount = uverts * vverts;
-    AppendIndexAndVertexData(indexData, vertexData, expectedVertexCount, options, mesh);
+    AppendGeneratedData(indexData, uverts * vverts, vertexFn, options, mesh);
 
     return mesh;
 
@@ -836,41 +1106,23 @@ TriMesh TriMesh::CreateSphere(float radius, uint32_t usegs, uint32_t vsegs, cons
     float dt = kTwoPi / static_cast<float>(usegs);
     float dp = kPi / static_cast<float>(vsegs);
 
-    std::vector<float> vertexData;
-    for (uint32_t i = 0; i < uverts; ++i) {
-        for (uint32_t j = 0; j < vverts; ++j) {
-            float  theta     = i * dt;
-            float  phi       = j * dp;
-            float  u         = options.mTexCoordScale.x * theta / kTwoPi;
-            float  v         = options.mTexCoordScale.y * phi / kPi;
-            float3 P         = SphericalToCartesian(theta, phi);
-            float3 position  = radius * P;
-            float3 color     = float3(u, v, 0);
-            float3 normal    = normalize(position);
-            float2 texcoord  = float2(u, v);
-            float4 tangent   = float4(-SphericalTangent(theta, phi), 1.0);
-            float3 bitangent = glm::cross(normal, float3(tangent));
-
-            vertexData.push_back(position.x);
-            vertexData.push_back(position.y);
-            vertexData.push_back(position.z);
-            vertexData.push_back(color.r);
-            vertexData.push_back(color.g);
-            vertexData.push_back(color.b);
-            vertexData.push_back(normal.x);
-            vertexData.push_back(normal.y);
-            vertexData.push_back(normal.z);
-            vertexData.push_back(texcoord.x);
-            vertexData.push_back(texcoord.y);
-            vertexData.push_back(tangent.x);
-            vertexData.push_back(tangent.y);
-            vertexData.push_back(tangent.z);
-            vertexData.push_back(tangent.w);
-            vertexData.push_back(bitangent.x);
-            vertexData.push_back(bitangent.y);
-            vertexData.push_back(bitangent.z);
-        }
-    }
+    // Vertex (i, j) is at index i * vverts + j
+    auto vertexFn = [=](uint32_t index, TriMeshVertexData* pVertex) {
+        uint32_t i     = index / vverts;
+        uint32_t j     = index % vverts;
+        float    theta = i * dt;
+        float    phi   = j * dp;
+        float    u     = options.mTexCoordScale.x * theta / kTwoPi;
+        float    v     = options.mTexCoordScale.y * phi / kPi;
+        float3   P     = SphericalToCartesian(theta, phi);
+
+        pVertex->position  = radius * P;
+        pVertex->color     = float3(u, v, 0);
+        pVertex->normal    = normalize(pVertex->position);
+        pVertex->texCoord  = float2(u, v);
+        pVertex->tangent   = float4(-SphericalTangent(theta, phi), 1.0);
+        pVertex->bitangent = glm::cross(pVertex->normal, float3(pVertex->tangent));
+    };
 
     std::vector<uint32_t> indexData;
     for (uint32_t i = 1; i < uverts; ++i) {
@@ -898,12 +1150,375 @@ TriMesh TriMesh::CreateSphere(float radius, uint32_t usegs, uint32_t vsegs, cons
     TriMeshAttributeDim texCoordDim = options.mEnableTexCoords ? TRI_MESH_ATTRIBUTE_DIM_2 : TRI_MESH_ATTRIBUTE_DIM_UNDEFINED;
     TriMesh             mesh        = TriMesh(indexType, texCoordDim);
 
-    uint32_t expectedVertexCount = uverts * vverts;
-    AppendIndexAndVertexData(indexData, vertexData, expectedVertexCount, options, mesh);
+    AppendGeneratedData(indexData, uverts * vverts, vertexFn, options, mesh);
 
     return mesh;
 }
 
+// -------------------------------------------------------------------------------------------------
+// OBJ parsing
+//
+// The file is split into chunks at line boundaries that are parsed in
+// parallel, twice: a first pass counts the v, vt and vn lines of every chunk
+// so the second one can resolve relative indices and write the attributes
+// straight to their place in the shared arrays.
+// -------------------------------------------------------------------------------------------------
+namespace {
+
+// Chunks smaller than this aren't worth a thread
+constexpr size_t kMinObjChunkSize = 1 << 20;
+
+// Attribute indices of a face corner, UINT32_MAX if the corner has none
+struct ObjCorner
+{
+    uint32_t position = UINT32_MAX;
+    uint32_t texCoord = UINT32_MAX;
+    uint32_t normal   = UINT32_MAX;
+
+    bool operator==(const ObjCorner& rhs) const
+    {
+        return (position == rhs.position) && (texCoord == rhs.texCoord) && (normal == rhs.normal);
+    }
+};
+
+struct ObjCounts
+{
+    uint32_t positions = 0;
+    uint32_t texCoords = 0;
+    uint32_t normals   = 0;
+};
+
+struct ObjChunk
+{
+    const char*            pBegin = nullptr;
+    const char*            pEnd   = nullptr;
+    ObjCounts              counts = {}; // Attributes in the chunk
+    ObjCounts              first  = {}; // Attributes in the chunks before
+    std::vector<ObjCorner> corners;     // Triangle corners, faces are fanned out
+    bool                   failed = false;
+};
+
+struct ObjData
+{
+    std::vector<float3>   positions;
+    std::vector<float2>   texCoords;
+    std::vector<float3>   normals;
+    std::vector<ObjChunk> chunks;
+};
+
+bool IsObjSpace(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r');
+}
+
+const char* SkipObjSpaces(const char* p, const char* pEnd)
+{
+    while ((p < pEnd) && IsObjSpace(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char* SkipObjLine(const char* p, const char* pEnd)
+{
+    const char* pNewLine = static_cast<const char*>(memchr(p, '\n', pEnd - p));
+    return IsNull(pNewLine) ? pEnd : (pNewLine + 1);
+}
+
+// Handles what OBJ exporters write: [-]digits[.digits][e[-]digits]. Anything
+// else (inf, nan, hex) goes through strtof.
+const char* ParseObjFloat(const char* p, const char* pEnd, float* pValue)
+{
+    static const double kPowers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18};
+
+    const char* pStart   = p;
+    const bool  negative = (p < pEnd) && (*p == '-');
+    if ((p < pEnd) && ((*p == '-') || (*p == '+'))) {
+        ++p;
+    }
+
+    uint64_t mantissa  = 0;
+    int      exponent  = 0;
+    int      digits    = 0;
+    bool     hasDigits = false;
+    for (; (p < pEnd) && (*p >= '0') && (*p <= '9'); ++p, hasDigits = true) {
+        if (digits < 18) {
+            mantissa = 10 * mantissa + static_cast<uint64_t>(*p - '0');
+            digits += (mantissa > 0) ? 1 : 0;
+        }
+        else {
+            ++exponent;
+        }
+    }
+    if ((p < pEnd) && (*p == '.')) {
+        for (++p; (p < pEnd) && (*p >= '0') && (*p <= '9'); ++p, hasDigits = true) {
+            if (digits < 18) {
+                mantissa = 10 * mantissa + static_cast<uint64_t>(*p - '0');
+                digits += (mantissa > 0) ? 1 : 0;
+                --exponent;
+            }
+        }
+    }
+    if (hasDigits && (p < pEnd) && ((*p == 'e') || (*p == 'E'))) {
+        const char* pExponent   = p + 1;
+        const bool  negativeExp = (pExponent < pEnd) && (*pExponent == '-');
+        if ((pExponent < pEnd) && ((*pExponent == '-') || (*pExponent == '+'))) {
+            ++pExponent;
+        }
+        int value = 0;
+        if ((pExponent < pEnd) && (*pExponent >= '0') && (*pExponent <= '9')) {
+            for (; (pExponent < pEnd) && (*pExponent >= '0') && (*pExponent <= '9'); ++pExponent) {
+                value = std::min(10 * value + (*pExponent - '0'), 1000);
+            }
+            exponent += negativeExp ? -value : value;
+            p = pExponent;
+        }
+    }
+
+    const bool simple = hasDigits && (p < pEnd) && (IsObjSpace(*p) || (*p == '\n') || (*p == '/'));
+    if (!simple && !((p == pEnd) && hasDigits)) {
+        // The file data ends with a null so strtof stops in time
+        char* pParseEnd = nullptr;
+        *pValue         = std::strtof(pStart, &pParseEnd);
+        return (pParseEnd == pStart) ? nullptr : pParseEnd;
+    }
+
+    double value = static_cast<double>(mantissa);
+    for (; exponent > 18; exponent -= 18) {
+        value *= kPowers[18];
+    }
+    for (; exponent < -18; exponent += 18) {
+        value /= kPowers[18];
+    }
+    value   = (exponent < 0) ? (value / kPowers[-exponent]) : (value * kPowers[exponent]);
+    *pValue = static_cast<float>(negative ? -value : value);
+    return p;
+}
+
+const char* ParseObjInt(const char* p, const char* pEnd, int64_t* pValue)
+{
+    const bool negative = (p < pEnd) && (*p == '-');
+    if ((p < pEnd) && ((*p == '-') || (*p == '+'))) {
+        ++p;
+    }
+    const char* pDigits = p;
+    int64_t     value   = 0;
+    for (; (p < pEnd) && (*p >= '0') && (*p <= '9'); ++p) {
+        value = std::min<int64_t>(10 * value + (*p - '0'), INT64_C(1) << 40);
+    }
+    *pValue = negative ? -value : value;
+    return (p == pDigits) ? nullptr : p;
+}
+
+// Returns the 0-based index of a 1-based or negative relative index, or
+// UINT32_MAX if it doesn't refer to one of the count attributes so far
+uint32_t ResolveObjIndex(int64_t index, uint32_t count)
+{
+    const int64_t resolved = (index > 0) ? (index - 1) : (static_cast<int64_t>(count) + index);
+    return ((index == 0) || (resolved < 0) || (resolved >= count)) ? UINT32_MAX : static_cast<uint32_t>(resolved);
+}
+
+// Returns the attribute type of a line starting at p: 'v', 't', 'n', 'f' or 0
+char GetObjLineType(const char* p, const char* pEnd, const char** ppData)
+{
+    if ((pEnd - p) < 2) {
+        return 0;
+    }
+    if (((p[0] == 'v') || (p[0] == 'f')) && IsObjSpace(p[1])) {
+        *ppData = p + 2;
+        return p[0];
+    }
+    if ((p[0] == 'v') && ((p[1] == 't') || (p[1] == 'n')) && ((pEnd - p) > 2) && IsObjSpace(p[2])) {
+        *ppData = p + 3;
+        return p[1];
+    }
+    return 0;
+}
+
+void CountObjChunk(ObjChunk* pChunk)
+{
+    for (const char* p = pChunk->pBegin; p < pChunk->pEnd; p = SkipObjLine(p, pChunk->pEnd)) {
+        const char* pData = nullptr;
+        // clang-format off
+        switch (GetObjLineType(SkipObjSpaces(p, pChunk->pEnd), pChunk->pEnd, &pData)) {
+            default  : break;
+            case 'v' : ++pChunk->counts.positions; break;
+            case 't' : ++pChunk->counts.texCoords; break;
+            case 'n' : ++pChunk->counts.normals; break;
+        }
+        // clang-format on
+    }
+}
+
+// Parses the face at p, adding its triangles to pChunk. counts are the
+// attributes before the face.
+bool ParseObjFace(const char* p, const char* pEnd, const ObjCounts& counts, ObjChunk* pChunk)
+{
+    ObjCorner first       = {};
+    ObjCorner previous    = {};
+    uint32_t  cornerCount = 0;
+    for (p = SkipObjSpaces(p, pEnd); (p < pEnd) && (*p != '\n') && (*p != '#'); p = SkipObjSpaces(p, pEnd)) {
+        ObjCorner corner = {};
+        int64_t   index  = 0;
+        if (IsNull(p = ParseObjInt(p, pEnd, &index))) {
+            return false;
+        }
+        corner.position = ResolveObjIndex(index, counts.positions);
+        if (corner.position == UINT32_MAX) {
+            return false;
+        }
+        if ((p < pEnd) && (*p == '/')) {
+            ++p;
+            if ((p < pEnd) && (*p != '/') && !IsObjSpace(*p) && (*p != '\n')) {
+                if (IsNull(p = ParseObjInt(p, pEnd, &index)) || ((corner.texCoord = ResolveObjIndex(index, counts.texCoords)) == UINT32_MAX)) {
+                    return false;
+                }
+            }
+            if ((p < pEnd) && (*p == '/')) {
+                if (IsNull(p = ParseObjInt(p + 1, pEnd, &index)) || ((corner.normal = ResolveObjIndex(index, counts.normals)) == UINT32_MAX)) {
+                    return false;
+                }
+            }
+        }
+
+        // Fan out polygons from their first corner
+        if (cornerCount == 0) {
+            first = corner;
+        }
+        else if (cornerCount >= 2) {
+            pChunk->corners.push_back(first);
+            pChunk->corners.push_back(previous);
+            pChunk->corners.push_back(corner);
+        }
+        previous = corner;
+        ++cornerCount;
+    }
+    return true;
+}
+
+void ParseObjChunk(ObjChunk* pChunk, ObjData* pData)
+{
+    ObjCounts counts = pChunk->first;
+    for (const char* p = pChunk->pBegin; p < pChunk->pEnd; p = SkipObjLine(p, pChunk->pEnd)) {
+        const char* pValues = nullptr;
+        const char  type    = GetObjLineType(SkipObjSpaces(p, pChunk->pEnd), pChunk->pEnd, &pValues);
+        if (type == 0) {
+            continue;
+        }
+        if (type == 'f') {
+            pChunk->failed = pChunk->failed || !ParseObjFace(pValues, pChunk->pEnd, counts, pChunk);
+            continue;
+        }
+
+        // Extra values like w or vertex colors are ignored
+        const uint32_t valueCount = (type == 't') ? 2 : 3;
+        float          values[3]  = {};
+        for (uint32_t i = 0; (i < valueCount) && !IsNull(pValues); ++i) {
+            pValues = SkipObjSpaces(pValues, pChunk->pEnd);
+            // Texture coordinates may leave v out
+            if ((type == 't') && (i == 1) && ((pValues == pChunk->pEnd) || (*pValues == '\n'))) {
+                break;
+            }
+            pValues = ParseObjFloat(pValues, pChunk->pEnd, &values[i]);
+        }
+        pChunk->failed = pChunk->failed || IsNull(pValues);
+
+        // clang-format off
+        switch (type) {
+            default  : break;
+            case 'v' : pData->positions[counts.positions++] = float3(values[0], values[1], values[2]); break;
+            case 't' : pData->texCoords[counts.texCoords++] = float2(values[0], values[1]); break;
+            case 'n' : pData->normals[counts.normals++]     = float3(values[0], values[1], values[2]); break;
+        }
+        // clang-format on
+    }
+}
+
+// fileData must end with a null
+bool ParseObj(const std::vector<char>& fileData, ObjData* pData)
+{
+    const char*    pBegin   = fileData.data();
+    const char*    pEnd     = pBegin + fileData.size() - 1;
+    const size_t   size     = static_cast<size_t>(pEnd - pBegin);
+    const uint32_t maxCount = std::max<uint32_t>(std::thread::hardware_concurrency(), 1);
+    const uint32_t count    = static_cast<uint32_t>(std::clamp<size_t>(size / kMinObjChunkSize, 1, maxCount));
+
+    // Chunks start after a line break
+    pData->chunks.resize(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        const char* pChunkBegin = (i == 0) ? pBegin : SkipObjLine(pBegin + (size * i) / count - 1, pEnd);
+        pData->chunks[i].pBegin = pChunkBegin;
+        pData->chunks[i].pEnd   = pEnd;
+        if (i > 0) {
+            pData->chunks[i - 1].pEnd = pChunkBegin;
+        }
+    }
+
+    ForEachTask(count, [pData](uint32_t i) { CountObjChunk(&pData->chunks[i]); });
+
+    ObjCounts total = {};
+    for (ObjChunk& chunk : pData->chunks) {
+        chunk.first = total;
+        total.positions += chunk.counts.positions;
+        total.texCoords += chunk.counts.texCoords;
+        total.normals += chunk.counts.normals;
+    }
+    pData->positions.resize(total.positions);
+    pData->texCoords.resize(total.texCoords);
+    pData->normals.resize(total.normals);
+
+    ForEachTask(count, [pData](uint32_t i) { ParseObjChunk(&pData->chunks[i], pData); });
+
+    return std::none_of(pData->chunks.begin(), pData->chunks.end(), [](const ObjChunk& chunk) { return chunk.failed; });
+}
+
+// Open addressing map of face corners to vertex indices
+class ObjVertexMap
+{
+public:
+    explicit ObjVertexMap(size_t cornerCount)
+    {
+        size_t capacity = 16;
+        while (capacity < 2 * cornerCount) {
+            capacity *= 2;
+        }
+        mSlots.assign(capacity, UINT32_MAX);
+        mCorners.reserve(cornerCount);
+    }
+
+    // Returns the vertex index of corner, adding it if it's new
+    uint32_t Insert(const ObjCorner& corner)
+    {
+        const size_t mask = mSlots.size() - 1;
+        for (size_t i = Hash(corner) & mask;; i = (i + 1) & mask) {
+            if (mSlots[i] == UINT32_MAX) {
+                mSlots[i] = CountU32(mCorners);
+                mCorners.push_back(corner);
+                return mSlots[i];
+            }
+            if (mCorners[mSlots[i]] == corner) {
+                return mSlots[i];
+            }
+        }
+    }
+
+    const std::vector<ObjCorner>& GetCorners() const { return mCorners; }
+
+private:
+    static size_t Hash(const ObjCorner& corner)
+    {
+        uint64_t h = (static_cast<uint64_t>(corner.position) * 0x9E3779B97F4A7C15ull);
+        h ^= (static_cast<uint64_t>(corner.texCoord) + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+        h ^= (static_cast<uint64_t>(corner.normal) + 0x165667B19E3779F9ull) * 0x94D049BB133111EBull;
+        return static_cast<size_t>(h ^ (h >> 29));
+    }
+
+    std::vector<uint32_t>  mSlots;
+    std::vector<ObjCorner> mCorners;
+};
+
+} // namespace
+
 Result TriMesh::CreateFromOBJ(const std::filesystem::path& path, const TriMeshOptions& options, TriMesh* pTriMesh)
 {
     if (IsNull(pTriMesh)) {
@@ -931,242 +1546,182 @@ Result TriMesh::CreateFromOBJ(const std::filesystem::path& path, const TriMeshOp
         {1.0f, 1.0f, 1.0f},
     };
 
-    tinyobj::attrib_t                attrib;
-    std::vector<tinyobj::shape_t>    shapes;
-    std::vector<tinyobj::material_t> materials;
-
-    ppx::fs::FileStream objStream;
-    if (!objStream.Open(path.string().c_str())) {
+    std::optional<std::vector<char>> fileData = ppx::fs::load_file(path);
+    if (!fileData.has_value()) {
         return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
     }
+    fileData->push_back('\0');
 
-    std::string  warn;
-    std::string  err;
-    std::istream istr(&objStream);
-    bool         loaded = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, &istr, nullptr, true);
-    if (!loaded || !err.empty()) {
+    ObjData obj;
+    if (!ParseObj(fileData.value(), &obj)) {
         return ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED;
     }
+    fileData.reset();
 
-    size_t numShapes = shapes.size();
-    if (numShapes == 0) {
+    size_t totalCorners = 0;
+    for (const ObjChunk& chunk : obj.chunks) {
+        totalCorners += chunk.corners.size();
+    }
+    const size_t totalTriangles = totalCorners / 3;
+    if (totalTriangles == 0) {
         return ppx::ERROR_GEOMETRY_FILE_NO_DATA;
     }
 
-    //// Check to see if data can be indexed
-    // bool indexable = true;
-    // for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx) {
-    //     const tinyobj::shape_t& shape     = shapes[shapeIdx];
-    //     const tinyobj::mesh_t&  shapeMesh = shape.mesh;
-    //
-    //     size_t numTriangles = shapeMesh.indices.size() / 3;
-    //     for (size_t triIdx = 0; triIdx < numTriangles; ++triIdx) {
-    //         size_t triVtxIdx0 = triIdx * 3 + 0;
-    //         size_t triVtxIdx1 = triIdx * 3 + 1;
-    //         size_t triVtxIdx2 = triIdx * 3 + 2;
-    //
-    //         // Index data
-    //         const tinyobj::index_t& dataIdx0 = shapeMesh.indices[triVtxIdx0];
-    //         const tinyobj::index_t& dataIdx1 = shapeMesh.indices[triVtxIdx1];
-    //         const tinyobj::index_t& dataIdx2 = shapeMesh.indices[triVtxIdx2];
-    //
-    //         bool sameIdx0 = (dataIdx0.vertex_index == dataIdx0.normal_index) && (dataIdx0.normal_index == dataIdx0.texcoord_index);
-    //         bool sameIdx1 = (dataIdx1.vertex_index == dataIdx1.normal_index) && (dataIdx1.normal_index == dataIdx1.texcoord_index);
-    //         bool sameIdx2 = (dataIdx2.vertex_index == dataIdx2.normal_index) && (dataIdx2.normal_index == dataIdx2.texcoord_index);
-    //         bool same     = sameIdx0 && sameIdx1 && sameIdx2;
-    //         if (!same) {
-    //            indexable = false;
-    //            break;
-    //         }
-    //     }
-    // }
-
-    // Preallocate based on the total number of triangles.
-    size_t totalTriangles = 0;
-    for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx) {
-        totalTriangles += shapes[shapeIdx].mesh.indices.size() / 3;
-    }
-    pTriMesh->PreallocateForTriangleCount(totalTriangles,
-                                          /* enableColors= */ (options.mEnableVertexColors || options.mEnableObjectColor),
-                                          options.mEnableNormals,
-                                          options.mEnableTexCoords,
-                                          options.mEnableTangents);
-
-    // Build geometry
-    for (size_t shapeIdx = 0; shapeIdx < numShapes; ++shapeIdx) {
-        const tinyobj::shape_t& shape     = shapes[shapeIdx];
-        const tinyobj::mesh_t&  shapeMesh = shape.mesh;
-
-        size_t numTriangles = shapeMesh.indices.size() / 3;
-        for (size_t triIdx = 0; triIdx < numTriangles; ++triIdx) {
-            size_t triVtxIdx0 = triIdx * 3 + 0;
-            size_t triVtxIdx1 = triIdx * 3 + 1;
-            size_t triVtxIdx2 = triIdx * 3 + 2;
-
-            // Index data
-            const tinyobj::index_t& dataIdx0 = shapeMesh.indices[triVtxIdx0];
-            const tinyobj::index_t& dataIdx1 = shapeMesh.indices[triVtxIdx1];
-            const tinyobj::index_t& dataIdx2 = shapeMesh.indices[triVtxIdx2];
-
-            // Vertex data
-            TriMeshVertexData vtx0 = {};
-            TriMeshVertexData vtx1 = {};
-            TriMeshVertexData vtx2 = {};
-
-            // Pick a face color
-            float3 faceColor = colors[triIdx % colors.size()];
-            vtx0.color       = faceColor;
-            vtx1.color       = faceColor;
-            vtx2.color       = faceColor;
-
-            // Vertex positions
-            {
-                int i0        = 3 * dataIdx0.vertex_index + 0;
-                int i1        = 3 * dataIdx0.vertex_index + 1;
-                int i2        = 3 * dataIdx0.vertex_index + 2;
-                vtx0.position = float3(attrib.vertices[i0], attrib.vertices[i1], attrib.vertices[i2]);
-
-                i0            = 3 * dataIdx1.vertex_index + 0;
-                i1            = 3 * dataIdx1.vertex_index + 1;
-                i2            = 3 * dataIdx1.vertex_index + 2;
-                vtx1.position = float3(attrib.vertices[i0], attrib.vertices[i1], attrib.vertices[i2]);
-
-                i0            = 3 * dataIdx2.vertex_index + 0;
-                i1            = 3 * dataIdx2.vertex_index + 1;
-                i2            = 3 * dataIdx2.vertex_index + 2;
-                vtx2.position = float3(attrib.vertices[i0], attrib.vertices[i1], attrib.vertices[i2]);
-            }
-
-            // Normals
-            if ((dataIdx0.normal_index != -1) && (dataIdx1.normal_index != -1) && (dataIdx2.normal_index != -1)) {
-                int i0      = 3 * dataIdx0.normal_index + 0;
-                int i1      = 3 * dataIdx0.normal_index + 1;
-                int i2      = 3 * dataIdx0.normal_index + 2;
-                vtx0.normal = float3(attrib.normals[i0], attrib.normals[i1], attrib.normals[i2]);
-
-                i0          = 3 * dataIdx1.normal_index + 0;
-                i1          = 3 * dataIdx1.normal_index + 1;
-                i2          = 3 * dataIdx1.normal_index + 2;
-                vtx1.normal = float3(attrib.normals[i0], attrib.normals[i1], attrib.normals[i2]);
-
-                i0          = 3 * dataIdx2.normal_index + 0;
-                i1          = 3 * dataIdx2.normal_index + 1;
-                i2          = 3 * dataIdx2.normal_index + 2;
-                vtx2.normal = float3(attrib.normals[i0], attrib.normals[i1], attrib.normals[i2]);
-            }
-
-            // Texture coordinates
-            if ((dataIdx0.texcoord_index != -1) && (dataIdx1.texcoord_index != -1) && (dataIdx2.texcoord_index != -1)) {
-                int i0        = 2 * dataIdx0.texcoord_index + 0;
-                int i1        = 2 * dataIdx0.texcoord_index + 1;
-                vtx0.texCoord = float2(attrib.texcoords[i0], attrib.texcoords[i1]);
-
-                i0            = 2 * dataIdx1.texcoord_index + 0;
-                i1            = 2 * dataIdx1.texcoord_index + 1;
-                vtx1.texCoord = float2(attrib.texcoords[i0], attrib.texcoords[i1]);
-
-                i0            = 2 * dataIdx2.texcoord_index + 0;
-                i1            = 2 * dataIdx2.texcoord_index + 1;
-                vtx2.texCoord = float2(attrib.texcoords[i0], attrib.texcoords[i1]);
-
-                // Scale tex coords
-                vtx0.texCoord *= options.mTexCoordScale;
-                vtx1.texCoord *= options.mTexCoordScale;
-                vtx2.texCoord *= options.mTexCoordScale;
-
-                if (options.mInvertTexCoordsV) {
-                    vtx0.texCoord.y = 1.0f - vtx0.texCoord.y;
-                    vtx1.texCoord.y = 1.0f - vtx1.texCoord.y;
-                    vtx2.texCoord.y = 1.0f - vtx2.texCoord.y;
+    // Indexed meshes get a vertex per distinct corner, unindexed ones one per corner
+    const bool            indexed = (indexType != grfx::INDEX_TYPE_UNDEFINED);
+    std::vector<uint32_t> cornerVertices(totalCorners);
+    std::vector<uint32_t> vertexTriangles; // First triangle of each vertex
+    ObjVertexMap          vertexMap(indexed ? totalCorners : 0);
+    {
+        size_t cornerIndex = 0;
+        for (const ObjChunk& chunk : obj.chunks) {
+            for (const ObjCorner& corner : chunk.corners) {
+                uint32_t vertex = static_cast<uint32_t>(cornerIndex);
+                if (indexed) {
+                    vertex = vertexMap.Insert(corner);
+                    if (vertex == vertexTriangles.size()) {
+                        vertexTriangles.push_back(static_cast<uint32_t>(cornerIndex / 3));
+                    }
                 }
+                cornerVertices[cornerIndex++] = vertex;
             }
+        }
+    }
 
-            float3 pos0 = (vtx0.position * options.mScale) + options.mTranslate;
-            float3 pos1 = (vtx1.position * options.mScale) + options.mTranslate;
-            float3 pos2 = (vtx2.position * options.mScale) + options.mTranslate;
+    std::vector<ObjCorner> cornerList;
+    if (!indexed) {
+        cornerList.reserve(totalCorners);
+        for (const ObjChunk& chunk : obj.chunks) {
+            cornerList.insert(cornerList.end(), chunk.corners.begin(), chunk.corners.end());
+        }
+    }
+    for (ObjChunk& chunk : obj.chunks) {
+        chunk.corners = std::vector<ObjCorner>();
+    }
+    const std::vector<ObjCorner>& vertices    = indexed ? vertexMap.GetCorners() : cornerList;
+    const uint32_t                vertexCount = CountU32(vertices);
+
+    // Write straight into the mesh's storage
+    pTriMesh->mPositions.resize(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        const float3 position     = (obj.positions[vertices[i].position] * options.mScale) + options.mTranslate;
+        pTriMesh->mPositions[i]   = position;
+        pTriMesh->mBoundingBoxMin = (i == 0) ? position : glm::min(pTriMesh->mBoundingBoxMin, position);
+        pTriMesh->mBoundingBoxMax = (i == 0) ? position : glm::max(pTriMesh->mBoundingBoxMax, position);
+    }
 
-            uint32_t triVtx0 = pTriMesh->AppendPosition(pos0) - 1;
-            uint32_t triVtx1 = pTriMesh->AppendPosition(pos1) - 1;
-            uint32_t triVtx2 = pTriMesh->AppendPosition(pos2) - 1;
+    if (options.mEnableVertexColors || options.mEnableObjectColor) {
+        // Face colors, shared vertices take the color of their first face
+        pTriMesh->mColors.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const uint32_t triangle = indexed ? vertexTriangles[i] : (i / 3);
+            pTriMesh->mColors[i]    = options.mEnableObjectColor ? options.mObjectColor : colors[triangle % colors.size()];
+        }
+    }
 
-            if (options.mEnableVertexColors || options.mEnableObjectColor) {
-                if (options.mEnableObjectColor) {
-                    vtx0.color = options.mObjectColor;
-                    vtx1.color = options.mObjectColor;
-                    vtx2.color = options.mObjectColor;
-                }
-                pTriMesh->AppendColor(vtx0.color);
-                pTriMesh->AppendColor(vtx1.color);
-                pTriMesh->AppendColor(vtx2.color);
-            }
+    std::vector<float3> normals(vertexCount, float3(0));
+    bool                missingNormals = false;
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        if (vertices[i].normal != UINT32_MAX) {
+            normals[i] = obj.normals[vertices[i].normal];
+        }
+        missingNormals = missingNormals || (vertices[i].normal == UINT32_MAX);
+    }
 
-            if (options.mEnableNormals) {
-                pTriMesh->AppendNormal(vtx0.normal);
-                pTriMesh->AppendNormal(vtx1.normal);
-                pTriMesh->AppendNormal(vtx2.normal);
+    if (missingNormals && (options.mEnableNormals || options.mEnableTangents)) {
+        // Smooth normals over the OBJ positions, so vertices split by
+        // texture coordinates still get the same normal
+        std::vector<uint32_t> positionIndices(totalCorners);
+        for (size_t i = 0; i < totalCorners; ++i) {
+            positionIndices[i] = vertices[cornerVertices[i]].position;
+        }
+        std::vector<float3> positionNormals(obj.positions.size());
+        GenerateMeshNormals(
+            positionIndices.data(),
+            CountU32(positionIndices),
+            &obj.positions[0].x,
+            static_cast<uint32_t>(sizeof(float3)),
+            CountU32(obj.positions),
+            &positionNormals[0].x,
+            static_cast<uint32_t>(sizeof(float3)));
+
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            if (vertices[i].normal == UINT32_MAX) {
+                normals[i] = positionNormals[vertices[i].position];
             }
+        }
+    }
 
-            if (options.mEnableTexCoords) {
-                pTriMesh->AppendTexCoord(vtx0.texCoord);
-                pTriMesh->AppendTexCoord(vtx1.texCoord);
-                pTriMesh->AppendTexCoord(vtx2.texCoord);
+    std::vector<float2> texCoords(vertexCount, float2(0));
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        if (vertices[i].texCoord != UINT32_MAX) {
+            texCoords[i] = obj.texCoords[vertices[i].texCoord] * options.mTexCoordScale;
+            if (options.mInvertTexCoordsV) {
+                texCoords[i].y = 1.0f - texCoords[i].y;
             }
+        }
+    }
 
-            if (options.mEnableTangents) {
-                float3 edge1 = vtx1.position - vtx0.position;
-                float3 edge2 = vtx2.position - vtx0.position;
-                float2 duv1  = vtx1.texCoord - vtx0.texCoord;
-                float2 duv2  = vtx2.texCoord - vtx0.texCoord;
-                float  r     = 1.0f / (duv1.x * duv2.y - duv1.y * duv2.x);
-
-                float3 tangent = float3(
-                    ((edge1.x * duv2.y) - (edge2.x * duv1.y)) * r,
-                    ((edge1.y * duv2.y) - (edge2.y * duv1.y)) * r,
-                    ((edge1.z * duv2.y) - (edge2.z * duv1.y)) * r);
-
-                float3 bitangent = float3(
-                    ((edge1.x * duv2.x) - (edge2.x * duv1.x)) * r,
-                    ((edge1.y * duv2.x) - (edge2.y * duv1.x)) * r,
-                    ((edge1.z * duv2.x) - (edge2.z * duv1.x)) * r);
-
-                tangent = glm::normalize(tangent - vtx0.normal * glm::dot(vtx0.normal, tangent));
-                float w = 1.0f;
-
-                pTriMesh->AppendTangent(float4(-tangent, w));
-                pTriMesh->AppendTangent(float4(-tangent, w));
-                pTriMesh->AppendTangent(float4(-tangent, w));
-                pTriMesh->AppendBitangent(-bitangent);
-                pTriMesh->AppendBitangent(-bitangent);
-                pTriMesh->AppendBitangent(-bitangent);
-            }
+    if (options.mEnableTangents) {
+        std::vector<float4> tangents(vertexCount);
+        GenerateMeshTangents(
+            cornerVertices.data(),
+            CountU32(cornerVertices),
+            &pTriMesh->mPositions[0].x,
+            static_cast<uint32_t>(sizeof(float3)),
+            &normals[0].x,
+            static_cast<uint32_t>(sizeof(float3)),
+            &texCoords[0].x,
+            static_cast<uint32_t>(sizeof(float2)),
+            vertexCount,
+            &tangents[0].x,
+            static_cast<uint32_t>(sizeof(float4)));
+
+        // TriMesh tangents point along -u, like CreateSphere()'s
+        pTriMesh->mTangents.resize(vertexCount);
+        pTriMesh->mBitangents.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i) {
+            const float3 tangent     = float3(tangents[i]);
+            pTriMesh->mTangents[i]   = float4(-tangent, 1.0f);
+            pTriMesh->mBitangents[i] = -tangents[i].w * glm::cross(normals[i], tangent);
+        }
+    }
 
-            if (indexType != grfx::INDEX_TYPE_UNDEFINED) {
-                if (options.mInvertWinding) {
-                    pTriMesh->AppendTriangle(triVtx0, triVtx2, triVtx1);
-                }
-                else {
-                    pTriMesh->AppendTriangle(triVtx0, triVtx1, triVtx2);
-                }
+    if (options.mEnableNormals) {
+        pTriMesh->mNormals = std::move(normals);
+    }
+
+    if (options.mEnableTexCoords) {
+        pTriMesh->mTexCoords.resize(2 * static_cast<size_t>(vertexCount));
+        memcpy(pTriMesh->mTexCoords.data(), texCoords.data(), pTriMesh->mTexCoords.size() * sizeof(float));
+    }
+
+    if (indexed) {
+        if (options.mInvertWinding) {
+            for (size_t triIdx = 0; triIdx < totalTriangles; ++triIdx) {
+                std::swap(cornerVertices[3 * triIdx + 1], cornerVertices[3 * triIdx + 2]);
             }
         }
+        pTriMesh->mIndices.resize(cornerVertices.size() * sizeof(uint32_t));
+        memcpy(pTriMesh->mIndices.data(), cornerVertices.data(), pTriMesh->mIndices.size());
     }
 
-    // if (options.mEnableTangents) {
-    //     size_t numPositions  = mesh.mPositions.size();
-    //     size_t numNormals    = mesh.mNormals.size();
-    //     size_t numTangents   = mesh.mTangents.size();
-    //     size_t numBitangents = mesh.mBitangents.size();
-    //     PPX_ASSERT_MSG(numPositions == numNormals == numTangents == numBitangents, "misaligned data for tangent calculation");
-    //
-    //     for (size_t i = 0; i < numPositions; ++i) {
-    //         const float3& T = mesh.mTangents[i];
-    //         const float3& B = mesh.mBitangents[i];
-    //     }
-    // }
+    // Corners with the same attribute indices already share a vertex, welding
+    // also merges distinct indices with equal values for the optimizations
+    // and the simplification.
+    if (indexed && (options.mOptimize.IsEnabled() || options.mLods.IsEnabled())) {
+        const uint32_t weldedVertices = pTriMesh->WeldVertices();
+        PPX_LOG_INFO("Welded OBJ vertices: " << vertexCount << " -> " << weldedVertices);
+        pTriMesh->Optimize(options.mOptimize);
+        pTriMesh->GenerateLods(options.mLods);
+        if (pTriMesh->GetLodCount() > 1) {
+            PPX_LOG_INFO("Generated " << pTriMesh->GetLodCount() << " OBJ LODs, coarsest has " << (pTriMesh->GetLod(pTriMesh->GetLodCount() - 1).indexCount / 3) << " triangles");
+        }
+    }
 
     double fnEndTime = timer.SecondsSinceStart();
     float  fnElapsed = static_cast<float>(fnEndTime - fnStartTime);
-    PPX_LOG_INFO("Created mesh from OBJ file: " << path << " (" << FloatString(fnElapsed) << " seconds, " << numShapes << " shapes, " << totalTriangles << " triangles)");
+    PPX_LOG_INFO("Created mesh from OBJ file: " << path << " (" << FloatString(fnElapsed) << " seconds, " << obj.chunks.size() << " chunks, " << totalTriangles << " triangles, " << vertexCount << " vertices)");
 
     return ppx::SUCCESS;
 }
@@ -0,0 +1,96 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/vertex_quantization.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace ppx {
+
+namespace {
+
+// Smallest magnitude that survives QuantizeSnorm16()
+constexpr float kSnorm16Epsilon = 1.0f / 32767.0f;
+
+float SignNotZero(float value)
+{
+    return (value < 0.0f) ? -1.0f : 1.0f;
+}
+
+} // namespace
+
+int16_t QuantizeSnorm16(float value)
+{
+    const float clamped = std::clamp(value, -1.0f, 1.0f);
+    return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+}
+
+uint8_t QuantizeUnorm8(float value)
+{
+    const float clamped = std::clamp(value, 0.0f, 1.0f);
+    return static_cast<uint8_t>(std::lround(clamped * 255.0f));
+}
+
+uint16_t QuantizeHalf(float value)
+{
+    return glm::packHalf1x16(value);
+}
+
+float DequantizeSnorm16(int16_t value)
+{
+    return std::max(static_cast<float>(value) / 32767.0f, -1.0f);
+}
+
+float2 EncodeOctahedral(const float3& n)
+{
+    const float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f) {
+        return float2(0);
+    }
+
+    float2 e = float2(n.x, n.y) / l1;
+    if (n.z < 0.0f) {
+        // Fold the lower hemisphere over the diagonals
+        e = float2((1.0f - std::abs(e.y)) * SignNotZero(e.x), (1.0f - std::abs(e.x)) * SignNotZero(e.y));
+    }
+    return e;
+}
+
+float3 DecodeOctahedral(const float2& e)
+{
+    float3 n = float3(e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y));
+    if (n.z < 0.0f) {
+        n.x = (1.0f - std::abs(e.y)) * SignNotZero(e.x);
+        n.y = (1.0f - std::abs(e.x)) * SignNotZero(e.y);
+    }
+    return glm::normalize(n);
+}
+
+float2 EncodeOctahedralTangent(const float4& t)
+{
+    const float2 e = EncodeOctahedral(float3(t));
+    const float  y = std::max(0.5f * e.y + 0.5f, kSnorm16Epsilon);
+    return float2(e.x, y * SignNotZero(t.w));
+}
+
+float4 DecodeOctahedralTangent(const float2& e)
+{
+    const float3 t = DecodeOctahedral(float2(e.x, 2.0f * std::abs(e.y) - 1.0f));
+    return float4(t, SignNotZero(e.y));
+}
+
+} // namespace ppx
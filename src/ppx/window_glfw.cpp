@@ -392,6 +392,7 @@ public:
     void       FillSurfaceInfo(grfx::SurfaceCreateInfo*) const final;
     void       ProcessEvent() final;
     void*      NativeHandle() final;
+    void       SetCursorCaptured(bool captured, bool rawMotion) final;
 
 private:
     GLFWwindow* mNative = nullptr;
@@ -499,6 +500,15 @@ void WindowImplGLFW::ProcessEvent()
     glfwPollEvents();
 }
 
+void WindowImplGLFW::SetCursorCaptured(bool captured, bool rawMotion)
+{
+    glfwSetInputMode(mNative, GLFW_CURSOR, captured ? GLFW_CURSOR_DISABLED : GLFW_CURSOR_NORMAL);
+    // Raw motion only applies while the cursor is disabled
+    if (glfwRawMouseMotionSupported() == GLFW_TRUE) {
+        glfwSetInputMode(mNative, GLFW_RAW_MOUSE_MOTION, (captured && rawMotion) ? GLFW_TRUE : GLFW_FALSE);
+    }
+}
+
 void* WindowImplGLFW::NativeHandle()
 {
     return mNative;
@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #if defined(PPX_BUILD_XR)
+#include <cmath>
 #include <queue>
 #include <string_view>
 #include "ppx/math_config.h"
@@ -165,6 +166,51 @@ void XrComponent::InitializeBeforeGrfxDeviceInit(const XrComponentCreateInfo& cr
         mPassthroughSupported = XR_PASSTHROUGH_OCULUS;
     }
 
+    if (createInfo.enableEyeGaze) {
+        if (IsXrExtensionSupported(xrExts, XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME)) {
+            xrInstanceExtensions.push_back(XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME);
+            mEyeGazeSupported = true;
+        }
+        else {
+            PPX_LOG_WARN("XR eye gaze is enabled but the " XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME " extension is not supported.");
+        }
+    }
+
+    if (createInfo.enableSpaceWarp) {
+        const bool isVulkan = (createInfo.api == grfx::API_VK_1_1) || (createInfo.api == grfx::API_VK_1_2);
+        if (isVulkan && (createInfo.depthFormat != grfx::FORMAT_UNDEFINED) && IsXrExtensionSupported(xrExts, XR_FB_SPACE_WARP_EXTENSION_NAME)) {
+            xrInstanceExtensions.push_back(XR_FB_SPACE_WARP_EXTENSION_NAME);
+            mSpaceWarpSupported = true;
+        }
+        else {
+            PPX_LOG_WARN("XR space warp is enabled but the " XR_FB_SPACE_WARP_EXTENSION_NAME " extension is not supported with this API or depth format.");
+        }
+    }
+
+    if (createInfo.enableFoveation) {
+        // The density maps are only exposed to Vulkan
+        const bool isVulkan = (createInfo.api == grfx::API_VK_1_1) || (createInfo.api == grfx::API_VK_1_2);
+        if (isVulkan &&
+            IsXrExtensionSupported(xrExts, XR_FB_FOVEATION_EXTENSION_NAME) &&
+            IsXrExtensionSupported(xrExts, XR_FB_FOVEATION_CONFIGURATION_EXTENSION_NAME) &&
+            IsXrExtensionSupported(xrExts, XR_FB_FOVEATION_VULKAN_EXTENSION_NAME) &&
+            IsXrExtensionSupported(xrExts, XR_FB_SWAPCHAIN_UPDATE_STATE_EXTENSION_NAME)) {
+            xrInstanceExtensions.push_back(XR_FB_FOVEATION_EXTENSION_NAME);
+            xrInstanceExtensions.push_back(XR_FB_FOVEATION_CONFIGURATION_EXTENSION_NAME);
+            xrInstanceExtensions.push_back(XR_FB_FOVEATION_VULKAN_EXTENSION_NAME);
+            xrInstanceExtensions.push_back(XR_FB_SWAPCHAIN_UPDATE_STATE_EXTENSION_NAME);
+            mFoveationSupported = true;
+            if (IsXrExtensionSupported(xrExts, XR_META_FOVEATION_EYE_TRACKED_EXTENSION_NAME)) {
+                xrInstanceExtensions.push_back(XR_META_FOVEATION_EYE_TRACKED_EXTENSION_NAME);
+                mFoveationEyeTracked = true;
+            }
+            SetFoveation(XR_FOVEATION_LEVEL_HIGH_FB, /* dynamic= */ true);
+        }
+        else {
+            PPX_LOG_WARN("XR foveation is enabled but the " XR_FB_FOVEATION_EXTENSION_NAME " extensions are not supported with this API.");
+        }
+    }
+
     // Layers (Optional)
     std::vector<const char*> xrRequestedInstanceLayers;
     if (mCreateInfo.enableDebug) {
@@ -214,6 +260,40 @@ void XrComponent::InitializeBeforeGrfxDeviceInit(const XrComponentCreateInfo& cr
     systemInfo.formFactor      = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
     CHECK_XR_CALL(xrGetSystem(mInstance, &systemInfo, &mSystemId));
 
+    // The extension can be present without an eye tracker
+    if (mEyeGazeSupported) {
+        XrSystemEyeGazeInteractionPropertiesEXT eyeGazeProperties = {XR_TYPE_SYSTEM_EYE_GAZE_INTERACTION_PROPERTIES_EXT};
+        XrSystemProperties                      systemProperties  = {XR_TYPE_SYSTEM_PROPERTIES};
+        systemProperties.next                                     = &eyeGazeProperties;
+        CHECK_XR_CALL(xrGetSystemProperties(mInstance, mSystemId, &systemProperties));
+        mEyeGazeSupported = (eyeGazeProperties.supportsEyeGazeInteraction == XR_TRUE);
+        if (!mEyeGazeSupported) {
+            PPX_LOG_WARN("XR eye gaze is enabled but the system doesn't support eye gaze interaction.");
+        }
+    }
+
+    if (mSpaceWarpSupported) {
+        XrSystemSpaceWarpPropertiesFB spaceWarpProperties = {XR_TYPE_SYSTEM_SPACE_WARP_PROPERTIES_FB};
+        XrSystemProperties            systemProperties    = {XR_TYPE_SYSTEM_PROPERTIES};
+        systemProperties.next                             = &spaceWarpProperties;
+        CHECK_XR_CALL(xrGetSystemProperties(mInstance, mSystemId, &systemProperties));
+        mSpaceWarpWidth     = spaceWarpProperties.recommendedMotionVectorImageRectWidth;
+        mSpaceWarpHeight    = spaceWarpProperties.recommendedMotionVectorImageRectHeight;
+        mSpaceWarpSupported = (mSpaceWarpWidth > 0) && (mSpaceWarpHeight > 0);
+        if (!mSpaceWarpSupported) {
+            PPX_LOG_WARN("XR space warp is enabled but the system recommends no motion vector resolution.");
+        }
+    }
+
+    // The extension can be present without an eye tracker
+    if (mFoveationEyeTracked) {
+        XrSystemFoveationEyeTrackedPropertiesMETA foveationProperties = {XR_TYPE_SYSTEM_FOVEATION_EYE_TRACKED_PROPERTIES_META};
+        XrSystemProperties                        systemProperties    = {XR_TYPE_SYSTEM_PROPERTIES};
+        systemProperties.next                                         = &foveationProperties;
+        CHECK_XR_CALL(xrGetSystemProperties(mInstance, mSystemId, &systemProperties));
+        mFoveationEyeTracked = (foveationProperties.supportsFoveationEyeTracked == XR_TRUE);
+    }
+
     // Get all supported blend modes.
     uint32_t blendCount = 0;
     CHECK_XR_CALL(xrEnumerateEnvironmentBlendModes(mInstance, mSystemId, mCreateInfo.viewConfigType, 0, &blendCount, nullptr));
@@ -350,6 +430,29 @@ XrResult XrComponent::InitializeInteractionProfiles()
     suggestedBindings.countSuggestedBindings = static_cast<uint32_t>(std::size(bindings));
     CHECK_XR_CALL_RETURN_ON_FAIL(xrSuggestInteractionProfileBindings(mInstance, &suggestedBindings));
 
+    if (mEyeGazeSupported) {
+        XrActionCreateInfo gazeActionInfo{XR_TYPE_ACTION_CREATE_INFO};
+        gazeActionInfo.actionType = XR_ACTION_TYPE_POSE_INPUT;
+        CharArrayStrCpy(gazeActionInfo.actionName, "eye_gaze");
+        CharArrayStrCpy(gazeActionInfo.localizedActionName, "Eye Gaze");
+        CHECK_XR_CALL_RETURN_ON_FAIL(xrCreateAction(mImguiInput, &gazeActionInfo, &mEyeGazeAction));
+
+        XrPath eyeGazeInteractionPath;
+        CHECK_XR_CALL_RETURN_ON_FAIL(xrStringToPath(mInstance, "/interaction_profiles/ext/eye_gaze_interaction", &eyeGazeInteractionPath));
+        XrPath gazePath;
+        CHECK_XR_CALL_RETURN_ON_FAIL(xrStringToPath(mInstance, "/user/eyes_ext/input/gaze_ext/pose", &gazePath));
+
+        XrActionSuggestedBinding gazeBinding;
+        gazeBinding.action  = mEyeGazeAction;
+        gazeBinding.binding = gazePath;
+
+        XrInteractionProfileSuggestedBinding gazeSuggestedBindings{XR_TYPE_INTERACTION_PROFILE_SUGGESTED_BINDING};
+        gazeSuggestedBindings.interactionProfile     = eyeGazeInteractionPath;
+        gazeSuggestedBindings.suggestedBindings      = &gazeBinding;
+        gazeSuggestedBindings.countSuggestedBindings = 1;
+        CHECK_XR_CALL_RETURN_ON_FAIL(xrSuggestInteractionProfileBindings(mInstance, &gazeSuggestedBindings));
+    }
+
     XrSessionActionSetsAttachInfo attachInfo{XR_TYPE_SESSION_ACTION_SETS_ATTACH_INFO};
     attachInfo.countActionSets = 1;
     attachInfo.actionSets      = &mImguiInput;
@@ -360,6 +463,13 @@ XrResult XrComponent::InitializeInteractionProfiles()
     aimSpaceInfo.poseInActionSpace = {{0, 0, 0, 1.0f}, {0, 0, 0}};
     CHECK_XR_CALL_RETURN_ON_FAIL(xrCreateActionSpace(mSession, &aimSpaceInfo, &mImguiAimSpace));
 
+    if (mEyeGazeAction != XR_NULL_HANDLE) {
+        XrActionSpaceCreateInfo gazeSpaceInfo{XR_TYPE_ACTION_SPACE_CREATE_INFO};
+        gazeSpaceInfo.action            = mEyeGazeAction;
+        gazeSpaceInfo.poseInActionSpace = kIdentityPose;
+        CHECK_XR_CALL_RETURN_ON_FAIL(xrCreateActionSpace(mSession, &gazeSpaceInfo, &mEyeGazeSpace));
+    }
+
     mInteractionProfileInitialized = true;
 
     return XR_SUCCESS;
@@ -367,6 +477,14 @@ XrResult XrComponent::InitializeInteractionProfiles()
 
 void XrComponent::Destroy()
 {
+    if (mEyeGazeSpace != XR_NULL_HANDLE) {
+        xrDestroySpace(mEyeGazeSpace);
+    }
+
+    if (mEyeGazeAction != XR_NULL_HANDLE) {
+        xrDestroyAction(mEyeGazeAction);
+    }
+
     if (mImguiAimAction != XR_NULL_HANDLE) {
         xrDestroyAction(mImguiAimAction);
     }
@@ -571,6 +689,22 @@ XrResult XrComponent::PollActions()
         CHECK_XR_CALL_RETURN_ON_FAIL(xrLocateSpace(mImguiAimSpace, mUISpace, mImguiActionTime, &aimLocation));
         mImguiAimState = aimLocation.pose;
     }
+
+    if (mEyeGazeAction != XR_NULL_HANDLE) {
+        XrActionStatePose gazeActionState = {XR_TYPE_ACTION_STATE_POSE};
+        getInfo.action                    = mEyeGazeAction;
+        CHECK_XR_CALL_RETURN_ON_FAIL(xrGetActionStatePose(mSession, &getInfo, &gazeActionState));
+
+        mEyeGazeState = std::nullopt;
+        if (gazeActionState.isActive) {
+            XrSpaceLocation gazeLocation{XR_TYPE_SPACE_LOCATION};
+            CHECK_XR_CALL_RETURN_ON_FAIL(xrLocateSpace(mEyeGazeSpace, mRefSpace, mImguiActionTime, &gazeLocation));
+            const XrSpaceLocationFlags tracked = XR_SPACE_LOCATION_ORIENTATION_VALID_BIT | XR_SPACE_LOCATION_ORIENTATION_TRACKED_BIT;
+            if ((gazeLocation.locationFlags & tracked) == tracked) {
+                mEyeGazeState = gazeLocation.pose;
+            }
+        }
+    }
     return XR_SUCCESS;
 }
 
@@ -582,6 +716,30 @@ std::optional<XrVector2f> XrComponent::GetUICursor() const
     return ProjectCursor(mImguiAimState.value(), kUIZPlane);
 }
 
+std::optional<float2> XrComponent::GetEyeGazeUV(uint32_t viewIndex) const
+{
+    if (!mEyeGazeState.has_value() || (viewIndex >= mViews.size())) {
+        return std::nullopt;
+    }
+
+    // The gaze origin is between the eyes, the parallax to each eye is
+    // ignored since what the user looks at is usually much further away.
+    const XrView&     view      = mViews[viewIndex];
+    const ppx::float3 direction = glm::rotate(FromXr(mEyeGazeState.value().orientation), ppx::float3(0, 0, -1));
+    const ppx::float3 local     = glm::rotate(glm::inverse(FromXr(view.pose.orientation)), direction);
+    if (local.z > -0.001f) {
+        return std::nullopt;
+    }
+
+    const float tanX     = local.x / -local.z;
+    const float tanY     = local.y / -local.z;
+    const float tanLeft  = std::tan(view.fov.angleLeft);
+    const float tanRight = std::tan(view.fov.angleRight);
+    const float tanUp    = std::tan(view.fov.angleUp);
+    const float tanDown  = std::tan(view.fov.angleDown);
+    return float2((tanX - tanLeft) / (tanRight - tanLeft), (tanUp - tanY) / (tanUp - tanDown));
+}
+
 void XrComponent::HandleSessionStateChangedEvent(const XrEventDataSessionStateChanged& stateChangedEvent, bool& exitRenderLoop)
 {
     const XrSessionState oldState = mSessionState;
@@ -620,21 +778,8 @@ void XrComponent::HandleSessionStateChangedEvent(const XrEventDataSessionStateCh
     }
 }
 
-void XrComponent::BeginFrame()
+bool XrComponent::LocateViews()
 {
-    XrFrameWaitInfo frameWaitInfo = {XR_TYPE_FRAME_WAIT_INFO};
-
-    CHECK_XR_CALL(xrWaitFrame(mSession, &frameWaitInfo, &mFrameState));
-    mShouldRender = mFrameState.shouldRender;
-
-    mImguiActionTime = mFrameState.predictedDisplayTime;
-
-    // Reset near and far plane values for this frame.
-    mNearPlaneForFrame = std::nullopt;
-    mFarPlaneForFrame  = std::nullopt;
-
-    // Create projection matrices and view matrices for each eye.
-
     XrViewLocateInfo viewLocateInfo = {
         XR_TYPE_VIEW_LOCATE_INFO,                  // type
         nullptr,                                   // next
@@ -648,8 +793,46 @@ void XrComponent::BeginFrame()
     uint32_t viewCount = 0;
     CHECK_XR_CALL(xrLocateViews(mSession, &viewLocateInfo, &viewState, (uint32_t)mViews.size(), &viewCount, mViews.data()));
 
-    if ((viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) == 0 ||
-        (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) == 0) {
+    return (viewState.viewStateFlags & XR_VIEW_STATE_POSITION_VALID_BIT) != 0 &&
+           (viewState.viewStateFlags & XR_VIEW_STATE_ORIENTATION_VALID_BIT) != 0;
+}
+
+void XrComponent::BeginFrame()
+{
+    XrFrameWaitInfo frameWaitInfo = {XR_TYPE_FRAME_WAIT_INFO};
+
+    uint64_t waitStart = 0;
+    Timer::Timestamp(&waitStart);
+    CHECK_XR_CALL(xrWaitFrame(mSession, &frameWaitInfo, &mFrameState));
+    Timer::Timestamp(&mWaitFrameEndTimestamp);
+    mShouldRender = mFrameState.shouldRender;
+
+    // A frame displayed more than one period after the previous one means
+    // the runtime skipped display periods
+    const double displayPeriodNanos = static_cast<double>(mFrameState.predictedDisplayPeriod);
+    mFrameTiming.waitTime           = Timer::TimestampToMillis(mWaitFrameEndTimestamp - waitStart);
+    mFrameTiming.displayPeriod      = displayPeriodNanos * PPX_TIMER_NANOS_TO_MILLIS;
+    mFrameTiming.missedFrames       = 0;
+    if ((mPreviousPredictedDisplayTime != 0) && (displayPeriodNanos > 0)) {
+        const double periods = static_cast<double>(mFrameState.predictedDisplayTime - mPreviousPredictedDisplayTime) / displayPeriodNanos;
+        if (periods > 1.5) {
+            mFrameTiming.missedFrames = static_cast<uint32_t>(std::lround(periods) - 1);
+            mFrameTiming.totalMissedFrames += mFrameTiming.missedFrames;
+        }
+    }
+    mPreviousPredictedDisplayTime = mFrameState.predictedDisplayTime;
+    mViewsLateLatched             = false;
+
+    mImguiActionTime = mFrameState.predictedDisplayTime;
+
+    // Reset near and far plane values for this frame.
+    mNearPlaneForFrame = std::nullopt;
+    mFarPlaneForFrame  = std::nullopt;
+
+    mSpaceWarpAppSpaceDelta = {{0, 0, 0, 1}, {0, 0, 0}};
+
+    // Create projection matrices and view matrices for each eye.
+    if (!LocateViews()) {
         mShouldRender = false;
     }
 
@@ -675,7 +858,34 @@ void XrComponent::BeginFrame()
     }
 }
 
-void XrComponent::EndFrame(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t layerProjStartIndex, uint32_t layerQuadStartIndex)
+void XrComponent::LateLatchViews(void* pMappedData)
+{
+    PPX_ASSERT_NULL_ARG(pMappedData);
+
+    if (!mViewsLateLatched) {
+        mViewsLateLatched = true;
+
+        // Keep the poses of BeginFrame() if tracking was lost since
+        const std::vector<XrView> views = mViews;
+        if (LocateViews()) {
+            for (size_t viewIndex = 0; viewIndex < mViews.size(); ++viewIndex) {
+                mCameras[viewIndex].UpdateView(mViews[viewIndex]);
+            }
+        }
+        else {
+            mViews = views;
+        }
+    }
+
+    XrViewMatrices* pMatrices = static_cast<XrViewMatrices*>(pMappedData);
+    for (size_t viewIndex = 0; viewIndex < mCameras.size(); ++viewIndex) {
+        pMatrices[viewIndex].view           = mCameras[viewIndex].GetViewMatrix();
+        pMatrices[viewIndex].projection     = mCameras[viewIndex].GetProjectionMatrix();
+        pMatrices[viewIndex].viewProjection = mCameras[viewIndex].GetViewProjectionMatrix();
+    }
+}
+
+void XrComponent::EndFrame(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t layerProjStartIndex, uint32_t layerQuadStartIndex, std::optional<uint32_t> spaceWarpStartIndex)
 {
     size_t viewCount = mViews.size();
     PPX_ASSERT_MSG(IsMultiView() || swapchains.size() >= viewCount, "Number of swapchains needs to be larger than or equal to the number of views!");
@@ -695,9 +905,13 @@ void XrComponent::EndFrame(const std::vector<grfx::SwapchainPtr>& swapchains, ui
     projectionLayer.SetZIndex(200);
     imGuiLayer.SetZIndex(300);
 
+    if (mPendingFoveation.has_value()) {
+        UpdateFoveation(swapchains, layerProjStartIndex);
+    }
+
     // Populate data into the layers, and add them into the queue as needed.
     ConditionallyPopulatePassthroughFbLayer(layerQueue, passthroughFbLayer);
-    ConditionallyPopulateProjectionLayer(swapchains, layerProjStartIndex, layerQueue, projectionLayer);
+    ConditionallyPopulateProjectionLayer(swapchains, layerProjStartIndex, spaceWarpStartIndex, layerQueue, projectionLayer);
     ConditionallyPopulateImGuiLayer(swapchains, layerQuadStartIndex, layerQueue, imGuiLayer);
 
     // Add any additional owned layers to the queue.
@@ -727,10 +941,64 @@ void XrComponent::EndFrame(const std::vector<grfx::SwapchainPtr>& swapchains, ui
         layers.data(),                        // layers
     };
 
+    uint64_t endFrameTimestamp = 0;
+    Timer::Timestamp(&endFrameTimestamp);
+    mFrameTiming.cpuSlack = mFrameTiming.displayPeriod - Timer::TimestampToMillis(endFrameTimestamp - mWaitFrameEndTimestamp);
+
     CHECK_XR_CALL(xrEndFrame(mSession, &frameEndInfo));
 }
 
-void XrComponent::ConditionallyPopulateProjectionLayer(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t startIndex, XrLayerBaseQueue& layerQueue, XrProjectionLayer& projectionLayer)
+void XrComponent::SetFoveation(XrFoveationLevelFB level, bool dynamic, float verticalOffset)
+{
+    if (!mFoveationSupported) {
+        return;
+    }
+
+    XrFoveationLevelProfileCreateInfoFB levelInfo = {XR_TYPE_FOVEATION_LEVEL_PROFILE_CREATE_INFO_FB};
+    levelInfo.level                               = level;
+    levelInfo.verticalOffset                      = verticalOffset;
+    levelInfo.dynamic                             = dynamic ? XR_FOVEATION_DYNAMIC_LEVEL_ENABLED_FB : XR_FOVEATION_DYNAMIC_DISABLED_FB;
+    mPendingFoveation                             = levelInfo;
+}
+
+void XrComponent::UpdateFoveation(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t startIndex)
+{
+    XrFoveationLevelProfileCreateInfoFB levelInfo = *mPendingFoveation;
+    mPendingFoveation.reset();
+
+    XrFoveationEyeTrackedProfileCreateInfoMETA eyeTrackedInfo = {XR_TYPE_FOVEATION_EYE_TRACKED_PROFILE_CREATE_INFO_META};
+    if (mFoveationEyeTracked) {
+        levelInfo.next = &eyeTrackedInfo;
+    }
+    XrFoveationProfileCreateInfoFB profileInfo = {XR_TYPE_FOVEATION_PROFILE_CREATE_INFO_FB};
+    profileInfo.next                           = &levelInfo;
+
+    PFN_xrCreateFoveationProfileFB pfnXrCreateFoveationProfileFB = nullptr;
+    CHECK_XR_CALL(xrGetInstanceProcAddr(mInstance, "xrCreateFoveationProfileFB", (PFN_xrVoidFunction*)(&pfnXrCreateFoveationProfileFB)));
+    PPX_ASSERT_MSG(pfnXrCreateFoveationProfileFB != nullptr, "Cannot get xrCreateFoveationProfileFB function pointer!");
+    PFN_xrDestroyFoveationProfileFB pfnXrDestroyFoveationProfileFB = nullptr;
+    CHECK_XR_CALL(xrGetInstanceProcAddr(mInstance, "xrDestroyFoveationProfileFB", (PFN_xrVoidFunction*)(&pfnXrDestroyFoveationProfileFB)));
+    PPX_ASSERT_MSG(pfnXrDestroyFoveationProfileFB != nullptr, "Cannot get xrDestroyFoveationProfileFB function pointer!");
+    PFN_xrUpdateSwapchainFB pfnXrUpdateSwapchainFB = nullptr;
+    CHECK_XR_CALL(xrGetInstanceProcAddr(mInstance, "xrUpdateSwapchainFB", (PFN_xrVoidFunction*)(&pfnXrUpdateSwapchainFB)));
+    PPX_ASSERT_MSG(pfnXrUpdateSwapchainFB != nullptr, "Cannot get xrUpdateSwapchainFB function pointer!");
+
+    XrFoveationProfileFB profile = XR_NULL_HANDLE;
+    CHECK_XR_CALL(pfnXrCreateFoveationProfileFB(mSession, &profileInfo, &profile));
+
+    XrSwapchainStateFoveationFB foveationState = {XR_TYPE_SWAPCHAIN_STATE_FOVEATION_FB};
+    foveationState.profile                     = profile;
+    const size_t swapchainCount                = IsMultiView() ? 1 : mViews.size();
+    for (size_t i = 0; i < swapchainCount; ++i) {
+        XrSwapchain colorSwapchain = swapchains[startIndex + i]->GetXrColorSwapchain();
+        CHECK_XR_CALL(pfnXrUpdateSwapchainFB(colorSwapchain, reinterpret_cast<const XrSwapchainStateBaseHeaderFB*>(&foveationState)));
+    }
+
+    // The swapchains keep the state, the profile is no longer needed
+    CHECK_XR_CALL(pfnXrDestroyFoveationProfileFB(profile));
+}
+
+void XrComponent::ConditionallyPopulateProjectionLayer(const std::vector<grfx::SwapchainPtr>& swapchains, uint32_t startIndex, std::optional<uint32_t> spaceWarpStartIndex, XrLayerBaseQueue& layerQueue, XrProjectionLayer& projectionLayer)
 {
     const size_t viewCount = mViews.size();
     PPX_ASSERT_MSG(IsMultiView() || swapchains.size() >= (viewCount + startIndex), "Number of swapchains needs to be larger than or equal to the number of views!");
@@ -771,6 +1039,27 @@ void XrComponent::ConditionallyPopulateProjectionLayer(const std::vector<grfx::S
         else {
             projectionLayer.AddView(view);
         }
+
+        if (mSpaceWarpSupported && spaceWarpStartIndex.has_value()) {
+            PPX_ASSERT_MSG(mNearPlaneForFrame.has_value() && mFarPlaneForFrame.has_value(), "Space warp info cannot be submitted because near and far plane values are not set.");
+            const uint32_t    spaceWarpIndex = isMultiView ? *spaceWarpStartIndex : *spaceWarpStartIndex + i;
+            const XrExtent2Di extent         = {static_cast<int>(GetSpaceWarpWidth()), static_cast<int>(GetSpaceWarpHeight())};
+
+            XrCompositionLayerSpaceWarpInfoFB spaceWarpInfo    = {XR_TYPE_COMPOSITION_LAYER_SPACE_WARP_INFO_FB};
+            spaceWarpInfo.motionVectorSubImage.swapchain       = swapchains[spaceWarpIndex]->GetXrColorSwapchain();
+            spaceWarpInfo.motionVectorSubImage.imageArrayIndex = isMultiView ? i : 0;
+            spaceWarpInfo.motionVectorSubImage.imageRect       = {{0, 0}, extent};
+            spaceWarpInfo.depthSubImage.swapchain              = swapchains[spaceWarpIndex]->GetXrDepthSwapchain();
+            spaceWarpInfo.depthSubImage.imageArrayIndex        = isMultiView ? i : 0;
+            spaceWarpInfo.depthSubImage.imageRect              = {{0, 0}, extent};
+            spaceWarpInfo.appSpaceDeltaPose                    = mSpaceWarpAppSpaceDelta;
+            spaceWarpInfo.minDepth                             = 0.0f;
+            spaceWarpInfo.maxDepth                             = 1.0f;
+            spaceWarpInfo.nearZ                                = *mNearPlaneForFrame;
+            spaceWarpInfo.farZ                                 = *mFarPlaneForFrame;
+
+            projectionLayer.AddSpaceWarpInfo(spaceWarpInfo);
+        }
     }
 
     projectionLayer.layer().type       = XR_TYPE_COMPOSITION_LAYER_PROJECTION;
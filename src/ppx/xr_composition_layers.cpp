@@ -14,6 +14,7 @@
 
 #if defined(PPX_BUILD_XR)
 #include "ppx/xr_composition_layers.h"
+#include "ppx/config.h"
 
 #include <memory>
 #include <optional>
@@ -45,6 +46,19 @@ void XrProjectionLayer::AddView(XrCompositionLayerProjectionView view, XrComposi
     layer().viewCount  = static_cast<uint32_t>(mViews.size());
 }
 
+void XrProjectionLayer::AddSpaceWarpInfo(XrCompositionLayerSpaceWarpInfoFB spaceWarpInfo)
+{
+    PPX_ASSERT_MSG(!mViews.empty(), "Space warp info needs a view to chain to");
+    mSpaceWarpInfos.emplace_back(std::make_unique<XrCompositionLayerSpaceWarpInfoFB>(spaceWarpInfo));
+
+    // After the depth info, if the view has one
+    XrBaseOutStructure* pLast = reinterpret_cast<XrBaseOutStructure*>(&mViews.back());
+    while (pLast->next != nullptr) {
+        pLast = pLast->next;
+    }
+    pLast->next = reinterpret_cast<XrBaseOutStructure*>(mSpaceWarpInfos.back().get());
+}
+
 } // namespace ppx
 
 #endif // defined(PPX_BUILD_XR)
@@ -0,0 +1,172 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "ppx/y4m_writer.h"
+
+namespace ppx {
+
+Y4mWriter::~Y4mWriter()
+{
+    Close();
+}
+
+Result Y4mWriter::Open(const std::filesystem::path& path, uint32_t width, uint32_t height, uint32_t frameRate)
+{
+    Close();
+
+    mFile.open(path, std::ios::out | std::ios::binary);
+    if (!mFile.is_open()) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+
+    Result ppxres = Open(&mFile, width, height, frameRate);
+    if (Failed(ppxres)) {
+        mFile.close();
+    }
+    return ppxres;
+}
+
+Result Y4mWriter::Open(std::ostream* pStream, uint32_t width, uint32_t height, uint32_t frameRate)
+{
+    PPX_ASSERT_NULL_ARG(pStream);
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+    if (pStream != &mFile) {
+        Close();
+    }
+
+    // Progressive, square pixels, JPEG chroma siting
+    *pStream << "YUV4MPEG2 W" << width << " H" << height << " F" << std::max<uint32_t>(frameRate, 1) << ":1 Ip A1:1 C420jpeg\n";
+    if (!*pStream) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+
+    mStream     = pStream;
+    mWidth      = width;
+    mHeight     = height;
+    mFrameCount = 0;
+    mFrame.resize(GetFrameSize(width, height));
+
+    return ppx::SUCCESS;
+}
+
+void Y4mWriter::Close()
+{
+    if (mFile.is_open()) {
+        mFile.close();
+    }
+    mStream = nullptr;
+    mFrame.clear();
+}
+
+Result Y4mWriter::WriteFrame(grfx::Format format, const void* texels, uint32_t width, uint32_t height, uint32_t rowStride)
+{
+    if (!IsOpen()) {
+        PPX_ASSERT_MSG(false, "y4m writer is not open");
+        return ppx::ERROR_FAILED;
+    }
+    if ((width != mWidth) || (height != mHeight)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    Result ppxres = ConvertToI420(format, texels, width, height, rowStride, mFrame.data());
+    if (Failed(ppxres)) {
+        return ppxres;
+    }
+
+    *mStream << "FRAME\n";
+    mStream->write(reinterpret_cast<const char*>(mFrame.data()), static_cast<std::streamsize>(mFrame.size()));
+    if (!*mStream) {
+        return ppx::ERROR_IMAGE_FILE_SAVE_FAILED;
+    }
+    ++mFrameCount;
+
+    return ppx::SUCCESS;
+}
+
+size_t Y4mWriter::GetFrameSize(uint32_t width, uint32_t height)
+{
+    const size_t chromaSize = static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2);
+    return static_cast<size_t>(width) * height + 2 * chromaSize;
+}
+
+Result Y4mWriter::ConvertToI420(grfx::Format format, const void* texels, uint32_t width, uint32_t height, uint32_t rowStride, uint8_t* pDst)
+{
+    PPX_ASSERT_NULL_ARG(texels);
+    PPX_ASSERT_NULL_ARG(pDst);
+    if ((width == 0) || (height == 0)) {
+        return ppx::ERROR_OUT_OF_RANGE;
+    }
+
+    const grfx::FormatDesc* desc = grfx::GetFormatDescription(format);
+    if ((desc->layout != grfx::FORMAT_LAYOUT_LINEAR) || (desc->dataType == grfx::FORMAT_DATA_TYPE_FLOAT) || (desc->bytesPerComponent != 1) || ((desc->componentBits & grfx::FORMAT_COMPONENT_RED_GREEN_BLUE) == 0)) {
+        return ppx::ERROR_IMAGE_INVALID_FORMAT;
+    }
+
+    const int32_t offsets[3] = {
+        (desc->componentBits & grfx::FORMAT_COMPONENT_RED) ? desc->componentOffset.red : -1,
+        (desc->componentBits & grfx::FORMAT_COMPONENT_GREEN) ? desc->componentOffset.green : -1,
+        (desc->componentBits & grfx::FORMAT_COMPONENT_BLUE) ? desc->componentOffset.blue : -1,
+    };
+    auto loadRGB = [&](uint32_t x, uint32_t y, int32_t rgb[3]) {
+        const uint8_t* pTexel = static_cast<const uint8_t*>(texels) + static_cast<size_t>(y) * rowStride + static_cast<size_t>(x) * desc->bytesPerTexel;
+        for (uint32_t c = 0; c < 3; ++c) {
+            rgb[c] = (offsets[c] >= 0) ? pTexel[offsets[c]] : 0;
+        }
+    };
+
+    const uint32_t chromaWidth  = (width + 1) / 2;
+    const uint32_t chromaHeight = (height + 1) / 2;
+    uint8_t*       pY           = pDst;
+    uint8_t*       pU           = pY + static_cast<size_t>(width) * height;
+    uint8_t*       pV           = pU + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    // Fixed point BT.601, limited range
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            int32_t rgb[3];
+            loadRGB(x, y, rgb);
+            pY[static_cast<size_t>(y) * width + x] = static_cast<uint8_t>(((66 * rgb[0] + 129 * rgb[1] + 25 * rgb[2] + 128) >> 8) + 16);
+        }
+    }
+
+    // Chroma of the average of each 2x2 block
+    for (uint32_t cy = 0; cy < chromaHeight; ++cy) {
+        for (uint32_t cx = 0; cx < chromaWidth; ++cx) {
+            int32_t  sum[3] = {0, 0, 0};
+            uint32_t count  = 0;
+            for (uint32_t y = 2 * cy; y < std::min(2 * cy + 2, height); ++y) {
+                for (uint32_t x = 2 * cx; x < std::min(2 * cx + 2, width); ++x) {
+                    int32_t rgb[3];
+                    loadRGB(x, y, rgb);
+                    sum[0] += rgb[0];
+                    sum[1] += rgb[1];
+                    sum[2] += rgb[2];
+                    ++count;
+                }
+            }
+            const int32_t r     = sum[0] / static_cast<int32_t>(count);
+            const int32_t g     = sum[1] / static_cast<int32_t>(count);
+            const int32_t b     = sum[2] / static_cast<int32_t>(count);
+            const size_t  index = static_cast<size_t>(cy) * chromaWidth + cx;
+            pU[index]           = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            pV[index]           = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+
+    return ppx::SUCCESS;
+}
+
+} // namespace ppx
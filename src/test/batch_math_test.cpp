@@ -0,0 +1,118 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/batch_math.h"
+#include "ppx/random.h"
+
+using namespace ppx;
+
+namespace {
+
+// Not a multiple of the SIMD width, so the scalar tail runs too
+const uint32_t kObjectCount = 103;
+
+void ExpectNear(const float4x4& actual, const float4x4& expected, float tolerance)
+{
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            EXPECT_NEAR(actual[c][r], expected[c][r], tolerance) << "column " << c << " row " << r;
+        }
+    }
+}
+
+} // namespace
+
+TEST(BatchMathTest, ComputeTransformMatricesMatchesTransform)
+{
+    const Transform::RotationOrder orders[] = {
+        Transform::RotationOrder::XYZ,
+        Transform::RotationOrder::XZY,
+        Transform::RotationOrder::YZX,
+        Transform::RotationOrder::YXZ,
+        Transform::RotationOrder::ZXY,
+        Transform::RotationOrder::ZYX,
+    };
+
+    Random                 random;
+    TransformArrays        transforms(kObjectCount);
+    std::vector<Transform> expected(kObjectCount);
+    for (uint32_t i = 0; i < kObjectCount; ++i) {
+        expected[i].SetTranslation(random.Float3(float3(-100.0f), float3(100.0f)));
+        expected[i].SetRotation(random.Float3(float3(-10.0f), float3(10.0f)));
+        expected[i].SetScale(random.Float3(float3(0.1f), float3(4.0f)));
+        transforms.Set(i, expected[i]);
+    }
+
+    std::vector<float4x4> matrices(kObjectCount);
+    for (Transform::RotationOrder order : orders) {
+        ComputeTransformMatrices(transforms, order, matrices.data());
+        for (uint32_t i = 0; i < kObjectCount; ++i) {
+            expected[i].SetRotationOrder(order);
+            ExpectNear(matrices[i], expected[i].GetConcatenatedMatrix(), 1e-4f);
+        }
+    }
+}
+
+TEST(BatchMathTest, TransformAABBsMatchesGetTransformed)
+{
+    Random                random;
+    AABBArrays            bounds(kObjectCount);
+    TransformArrays       transforms(kObjectCount);
+    std::vector<float4x4> matrices(kObjectCount);
+    for (uint32_t i = 0; i < kObjectCount; ++i) {
+        bounds.Set(i, AABB(random.Float3(float3(-5.0f), float3(5.0f)), random.Float3(float3(-5.0f), float3(5.0f))));
+        transforms.Set(i, random.Float3(float3(-100.0f), float3(100.0f)), random.Float3(float3(-3.0f), float3(3.0f)), random.Float3(float3(0.5f), float3(2.0f)));
+    }
+    ComputeTransformMatrices(transforms, Transform::RotationOrder::XYZ, matrices.data());
+
+    AABBArrays transformed;
+    TransformAABBs(bounds, matrices.data(), &transformed);
+    ASSERT_EQ(transformed.GetCount(), kObjectCount);
+
+    for (uint32_t i = 0; i < kObjectCount; ++i) {
+        const AABB expected = bounds.Get(i).GetTransformed(matrices[i]);
+        const AABB actual   = transformed.Get(i);
+        for (int k = 0; k < 3; ++k) {
+            EXPECT_NEAR(actual.GetMin()[k], expected.GetMin()[k], 1e-3f);
+            EXPECT_NEAR(actual.GetMax()[k], expected.GetMax()[k], 1e-3f);
+        }
+    }
+}
+
+TEST(BatchMathTest, CullAABBsMatchesFrustumOverlaps)
+{
+    const Frustum frustum(glm::perspectiveRH_ZO(glm::radians(60.0f), 1.5f, 0.1f, 100.0f) * glm::lookAtRH(float3(0, 0, 10), float3(0, 0, 0), float3(0, 1, 0)));
+
+    Random     random;
+    AABBArrays bounds(kObjectCount);
+    for (uint32_t i = 0; i < kObjectCount; ++i) {
+        const float3 center = random.Float3(float3(-60.0f), float3(60.0f));
+        bounds.Set(i, AABB(center - float3(1.0f), center + float3(1.0f)));
+    }
+
+    std::vector<uint32_t> visible(kObjectCount);
+    visible.resize(CullAABBs(frustum, bounds, visible.data()));
+
+    std::vector<uint32_t> expected;
+    for (uint32_t i = 0; i < kObjectCount; ++i) {
+        if (frustum.Overlaps(bounds.Get(i))) {
+            expected.push_back(i);
+        }
+    }
+    EXPECT_FALSE(expected.empty());
+    EXPECT_LT(expected.size(), kObjectCount);
+    EXPECT_EQ(visible, expected);
+}
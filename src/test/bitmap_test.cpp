@@ -0,0 +1,192 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/bitmap.h"
+
+#include <cmath>
+#include <filesystem>
+
+using namespace ppx;
+
+namespace {
+
+// Odd width so the SIMD kernels also run their scalar tails
+constexpr uint32_t kWidth  = 37;
+constexpr uint32_t kHeight = 5;
+
+uint8_t GetValue(uint32_t x, uint32_t y, uint32_t c)
+{
+    return static_cast<uint8_t>((x * 7 + y * 31 + c * 59) & 0xFF);
+}
+
+Bitmap CreateRgba8()
+{
+    Bitmap bitmap = Bitmap::Create(kWidth, kHeight, Bitmap::FORMAT_RGBA_UINT8);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            uint8_t* pPixel = bitmap.GetPixel8u(x, y);
+            for (uint32_t c = 0; c < 4; ++c) {
+                pPixel[c] = GetValue(x, y, c);
+            }
+        }
+    }
+    return bitmap;
+}
+
+} // namespace
+
+TEST(BitmapTest, ConvertRgbToRgba)
+{
+    Bitmap rgb = Bitmap::Create(kWidth, kHeight, Bitmap::FORMAT_RGB_UINT8);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            uint8_t* pPixel = rgb.GetPixel8u(x, y);
+            for (uint32_t c = 0; c < 3; ++c) {
+                pPixel[c] = GetValue(x, y, c);
+            }
+        }
+    }
+
+    Bitmap rgba;
+    ASSERT_EQ(rgb.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &rgba), ppx::SUCCESS);
+    ASSERT_EQ(rgba.GetFormat(), Bitmap::FORMAT_RGBA_UINT8);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            const uint8_t* pPixel = rgba.GetPixel8u(x, y);
+            EXPECT_EQ(pPixel[0], GetValue(x, y, 0));
+            EXPECT_EQ(pPixel[1], GetValue(x, y, 1));
+            EXPECT_EQ(pPixel[2], GetValue(x, y, 2));
+            EXPECT_EQ(pPixel[3], 255);
+        }
+    }
+
+    EXPECT_EQ(rgba.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &rgba), ppx::ERROR_RANGE_ALIASING_NOT_ALLOWED);
+    EXPECT_EQ(rgba.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, nullptr), ppx::ERROR_UNEXPECTED_NULL_ARGUMENT);
+}
+
+TEST(BitmapTest, ConvertRoundTrip)
+{
+    const Bitmap source = CreateRgba8();
+
+    Bitmap floats;
+    ASSERT_EQ(source.ConvertTo(Bitmap::FORMAT_RGBA_FLOAT, &floats), ppx::SUCCESS);
+    EXPECT_FLOAT_EQ(floats.GetPixel32f(1, 0)[0], GetValue(1, 0, 0) / 255.0f);
+
+    Bitmap shorts;
+    ASSERT_EQ(source.ConvertTo(Bitmap::FORMAT_RGBA_UINT16, &shorts), ppx::SUCCESS);
+    EXPECT_EQ(shorts.GetPixel16u(1, 0)[0], GetValue(1, 0, 0) * 257);
+
+    Bitmap fromFloats;
+    Bitmap fromShorts;
+    ASSERT_EQ(floats.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &fromFloats), ppx::SUCCESS);
+    ASSERT_EQ(shorts.ConvertTo(Bitmap::FORMAT_RGBA_UINT8, &fromShorts), ppx::SUCCESS);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                EXPECT_EQ(fromFloats.GetPixel8u(x, y)[c], source.GetPixel8u(x, y)[c]);
+                EXPECT_EQ(fromShorts.GetPixel8u(x, y)[c], source.GetPixel8u(x, y)[c]);
+            }
+        }
+    }
+
+    // Out of range floats clamp
+    floats.GetPixel32f(0, 0)[0] = -1.0f;
+    floats.GetPixel32f(0, 0)[1] = 2.0f;
+    ASSERT_EQ(floats.ConvertTo(Bitmap::FORMAT_R_UINT8, &fromFloats), ppx::SUCCESS);
+    EXPECT_EQ(fromFloats.GetPixel8u(0, 0)[0], 0);
+    ASSERT_EQ(floats.ConvertTo(Bitmap::FORMAT_RG_UINT16, &fromShorts), ppx::SUCCESS);
+    EXPECT_EQ(fromShorts.GetPixel16u(0, 0)[1], 65535);
+}
+
+TEST(BitmapTest, PremultiplyAlpha)
+{
+    const Bitmap source = CreateRgba8();
+
+    Bitmap bitmap = source;
+    ASSERT_EQ(bitmap.PremultiplyAlpha(), ppx::SUCCESS);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            const uint8_t* pExpected = source.GetPixel8u(x, y);
+            const uint8_t* pPixel    = bitmap.GetPixel8u(x, y);
+            for (uint32_t c = 0; c < 3; ++c) {
+                EXPECT_EQ(pPixel[c], std::lround(pExpected[c] * pExpected[3] / 255.0));
+            }
+            EXPECT_EQ(pPixel[3], pExpected[3]);
+        }
+    }
+
+    Bitmap rgb = Bitmap::Create(kWidth, kHeight, Bitmap::FORMAT_RGB_UINT8);
+    EXPECT_EQ(rgb.PremultiplyAlpha(), ppx::ERROR_IMAGE_INVALID_FORMAT);
+}
+
+TEST(BitmapTest, FillKeepsRowPadding)
+{
+    constexpr uint32_t kRowStride = kWidth * 4 + 12;
+
+    std::vector<char> storage(kRowStride * kHeight, 0x5A);
+    Bitmap            bitmap = Bitmap::Create(kWidth, kHeight, Bitmap::FORMAT_RGBA_UINT8, kRowStride, storage.data());
+    ASSERT_TRUE(bitmap.IsOk());
+    bitmap.Fill<uint8_t>(1, 2, 3, 4);
+
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        const char* pRow = storage.data() + y * kRowStride;
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            EXPECT_EQ(pRow[4 * x + 0], 1);
+            EXPECT_EQ(pRow[4 * x + 1], 2);
+            EXPECT_EQ(pRow[4 * x + 2], 3);
+            EXPECT_EQ(pRow[4 * x + 3], 4);
+        }
+        for (uint32_t i = kWidth * 4; i < kRowStride; ++i) {
+            EXPECT_EQ(pRow[i], 0x5A);
+        }
+    }
+}
+
+TEST(BitmapTest, LoadFileIntoExternalStorage)
+{
+    const Bitmap                source = CreateRgba8();
+    const std::filesystem::path path   = std::filesystem::temp_directory_path() / "bitmap_test_load_external.png";
+    ASSERT_EQ(Bitmap::SaveFilePNG(path, &source), ppx::SUCCESS);
+
+    uint32_t       width  = 0;
+    uint32_t       height = 0;
+    Bitmap::Format format = Bitmap::FORMAT_UNDEFINED;
+    ASSERT_EQ(Bitmap::GetFileProperties(path, &width, &height, &format), ppx::SUCCESS);
+    EXPECT_EQ(width, kWidth);
+    EXPECT_EQ(height, kHeight);
+    EXPECT_EQ(format, Bitmap::FORMAT_RGBA_UINT8);
+
+    // Padded rows the way a staging buffer with pitch alignment has them
+    constexpr uint32_t kRowStride = 256;
+    std::vector<char>  storage(kRowStride * kHeight, 0x5A);
+    Bitmap             bitmap;
+    ASSERT_EQ(Bitmap::LoadFile(path, kRowStride, storage.data(), &bitmap), ppx::SUCCESS);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(bitmap.GetData(), storage.data());
+    EXPECT_EQ(bitmap.GetRowStride(), kRowStride);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        const char* pRow = storage.data() + y * kRowStride;
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            for (uint32_t c = 0; c < 4; ++c) {
+                EXPECT_EQ(static_cast<uint8_t>(pRow[4 * x + c]), GetValue(x, y, c));
+            }
+        }
+        for (uint32_t i = kWidth * 4; i < kRowStride; ++i) {
+            EXPECT_EQ(pRow[i], 0x5A);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gtest/gtest.h"
+
+#include "ppx/command_capture.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace ppx {
+namespace {
+
+CaptureData MakeCaptureData()
+{
+    CaptureData data = {};
+    data.api         = grfx::API_VK_1_1;
+    data.shaders     = {{'a', 'b', 'c', 'd'}};
+
+    CaptureInterface interfaceData  = {};
+    interfaceData.pushConstantCount = 2;
+    interfaceData.sets.push_back({0, {{1, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER, 1}}});
+    data.interfaces.push_back(interfaceData);
+
+    data.pipelines.push_back({0, 0, "csmain"});
+
+    CaptureBuffer buffer = {};
+    buffer.size          = 8;
+    buffer.usageFlags    = 0x3;
+    buffer.state         = grfx::RESOURCE_STATE_GENERAL;
+    buffer.contents      = {1, 2, 3, 4, 5, 6, 7, 8};
+    data.buffers.push_back(buffer);
+
+    data.frames.push_back({CAPTURE_COMMAND_OP_BIND_COMPUTE_PIPELINE, 1, 0, CAPTURE_COMMAND_OP_DISPATCH, 3, 4, 1, 1});
+
+    return data;
+}
+
+TEST(CommandCaptureTest, RoundTripsCaptureData)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "command_capture_test_round_trip.ppxcap";
+    const CaptureData           data = MakeCaptureData();
+    ASSERT_EQ(SaveCaptureData(path, data), ppx::SUCCESS);
+
+    CaptureData loaded = {};
+    ASSERT_EQ(LoadCaptureData(path, &loaded), ppx::SUCCESS);
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(loaded.api, data.api);
+    EXPECT_EQ(loaded.shaders, data.shaders);
+    ASSERT_EQ(loaded.interfaces.size(), 1);
+    EXPECT_EQ(loaded.interfaces[0].pushConstantCount, 2);
+    ASSERT_EQ(loaded.interfaces[0].sets.size(), 1);
+    ASSERT_EQ(loaded.interfaces[0].sets[0].bindings.size(), 1);
+    EXPECT_EQ(loaded.interfaces[0].sets[0].bindings[0].binding, 1);
+    EXPECT_EQ(loaded.interfaces[0].sets[0].bindings[0].type, grfx::DESCRIPTOR_TYPE_RW_STRUCTURED_BUFFER);
+    ASSERT_EQ(loaded.pipelines.size(), 1);
+    EXPECT_EQ(loaded.pipelines[0].entryPoint, "csmain");
+    ASSERT_EQ(loaded.buffers.size(), 1);
+    EXPECT_EQ(loaded.buffers[0].size, 8);
+    EXPECT_EQ(loaded.buffers[0].contents, data.buffers[0].contents);
+    EXPECT_EQ(loaded.frames, data.frames);
+}
+
+TEST(CommandCaptureTest, RejectsTruncatedFiles)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "command_capture_test_truncated.ppxcap";
+    ASSERT_EQ(SaveCaptureData(path, MakeCaptureData()), ppx::SUCCESS);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+
+    CaptureData loaded = {};
+    EXPECT_EQ(LoadCaptureData(path, &loaded), ppx::ERROR_BAD_DATA_SOURCE);
+    std::filesystem::remove(path);
+}
+
+TEST(CommandCaptureTest, RejectsOtherFiles)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "command_capture_test_other.ppxcap";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not a capture";
+    }
+
+    CaptureData loaded = {};
+    EXPECT_EQ(LoadCaptureData(path, &loaded), ppx::ERROR_BAD_DATA_SOURCE);
+    std::filesystem::remove(path);
+}
+
+} // namespace
+} // namespace ppx
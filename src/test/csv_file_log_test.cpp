@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/csv_file_log.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace ppx;
+
+namespace {
+
+std::string ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream     file(path, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+enum class Color
+{
+    RED = 3,
+};
+
+std::ostream& operator<<(std::ostream& stream, Color)
+{
+    return stream << "red";
+}
+
+} // namespace
+
+TEST(CSVFileLogTest, FormatsLikeStreams)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "csv_file_log_test_format.csv";
+    {
+        CSVFileLog log(path);
+        log.LogField(42u);
+        log.LogField(-7);
+        log.LogField(int64_t(-9000000000));
+        log.LogField(1.5f);
+        log.LogField(0.1234567);
+        log.LogField(1e20);
+        log.LogField(true);
+        log.LogField('x');
+        log.LogField("name");
+        log.LogField(std::string("text"));
+        log.LastField(Color::RED);
+    }
+
+    std::stringstream expected;
+    expected << 42u << "," << -7 << "," << int64_t(-9000000000) << "," << 1.5f << "," << 0.1234567 << "," << 1e20 << ","
+             << true << "," << 'x' << ",name,text,red\n";
+    EXPECT_EQ(ReadFile(path), expected.str());
+    std::filesystem::remove(path);
+}
+
+TEST(CSVFileLogTest, WritesRowsInOrder)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "csv_file_log_test_order.csv";
+
+    // A small buffer so most rows go through the writer thread
+    std::stringstream expected;
+    {
+        CSVFileLog log(path, 64);
+        for (uint32_t i = 0; i < 10000; ++i) {
+            log.LogField(i);
+            log.LastField(i * 0.5);
+            expected << i << "," << (i * 0.5) << "\n";
+        }
+    }
+    EXPECT_EQ(ReadFile(path), expected.str());
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,142 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/dynamic_resolution.h"
+
+namespace ppx {
+namespace {
+
+DynamicResolutionControllerCreateInfo TestCreateInfo()
+{
+    DynamicResolutionControllerCreateInfo createInfo = {};
+    createInfo.targetFrameTimeMs                     = 10.0f;
+    createInfo.minScale                              = 0.5f;
+    createInfo.maxScale                              = 1.0f;
+    createInfo.headroom                              = 0.1f;
+    createInfo.smoothing                             = 1.0f;
+    createInfo.cooldownFrames                        = 0;
+    createInfo.alignment                             = 8;
+    return createInfo;
+}
+
+// GPU time proportional to the pixel count
+float SimulatedFrameTimeMs(float fullResolutionMs, float scale)
+{
+    return fullResolutionMs * scale * scale;
+}
+
+TEST(DynamicResolutionControllerTest, InvalidCreateInfoFails)
+{
+    DynamicResolutionController           controller;
+    DynamicResolutionControllerCreateInfo createInfo = TestCreateInfo();
+    createInfo.minScale                              = 0.0f;
+    EXPECT_EQ(controller.Initialize(createInfo), ppx::ERROR_INVALID_CREATE_ARGUMENT);
+}
+
+TEST(DynamicResolutionControllerTest, StaysAtMaxScaleUnderTarget)
+{
+    DynamicResolutionController controller;
+    ASSERT_EQ(controller.Initialize(TestCreateInfo()), ppx::SUCCESS);
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        EXPECT_FALSE(controller.Update(5.0f));
+    }
+    EXPECT_FLOAT_EQ(controller.GetScale(), 1.0f);
+}
+
+TEST(DynamicResolutionControllerTest, ConvergesBelowTarget)
+{
+    DynamicResolutionController controller;
+    ASSERT_EQ(controller.Initialize(TestCreateInfo()), ppx::SUCCESS);
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        controller.Update(SimulatedFrameTimeMs(20.0f, controller.GetScale()));
+    }
+
+    const float frameTimeMs = SimulatedFrameTimeMs(20.0f, controller.GetScale());
+    EXPECT_LE(frameTimeMs, 10.0f);
+    EXPECT_GE(frameTimeMs, 9.0f);
+    EXPECT_FALSE(controller.Update(frameTimeMs));
+}
+
+TEST(DynamicResolutionControllerTest, ClampsToMinScale)
+{
+    DynamicResolutionController controller;
+    ASSERT_EQ(controller.Initialize(TestCreateInfo()), ppx::SUCCESS);
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        controller.Update(100.0f);
+    }
+    EXPECT_FLOAT_EQ(controller.GetScale(), 0.5f);
+}
+
+TEST(DynamicResolutionControllerTest, ScalesUpGradually)
+{
+    DynamicResolutionController controller;
+    ASSERT_EQ(controller.Initialize(TestCreateInfo()), ppx::SUCCESS);
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        controller.Update(100.0f);
+    }
+    ASSERT_FLOAT_EQ(controller.GetScale(), 0.5f);
+
+    // Load drops away, one change is limited to 10%
+    EXPECT_TRUE(controller.Update(0.1f));
+    EXPECT_NEAR(controller.GetScale(), 0.55f, 1e-5f);
+}
+
+TEST(DynamicResolutionControllerTest, CooldownDelaysChanges)
+{
+    DynamicResolutionController           controller;
+    DynamicResolutionControllerCreateInfo createInfo = TestCreateInfo();
+    createInfo.cooldownFrames                        = 3;
+    ASSERT_EQ(controller.Initialize(createInfo), ppx::SUCCESS);
+
+    EXPECT_TRUE(controller.Update(15.0f));
+    const float scale = controller.GetScale();
+    for (uint32_t i = 0; i < 3; ++i) {
+        EXPECT_FALSE(controller.Update(15.0f));
+        EXPECT_FLOAT_EQ(controller.GetScale(), scale);
+    }
+    EXPECT_TRUE(controller.Update(15.0f));
+}
+
+TEST(DynamicResolutionControllerTest, RenderSizeIsAlignedAndBounded)
+{
+    DynamicResolutionController controller;
+    ASSERT_EQ(controller.Initialize(TestCreateInfo()), ppx::SUCCESS);
+
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    controller.GetRenderSize(1920, 1080, &width, &height);
+    EXPECT_EQ(width, 1920);
+    EXPECT_EQ(height, 1080);
+
+    // 1001 is rounded up to 1008, which is clamped back to the max size
+    controller.GetRenderSize(1001, 3, &width, &height);
+    EXPECT_EQ(width, 1001);
+    EXPECT_EQ(height, 3);
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        controller.Update(100.0f);
+    }
+    controller.GetRenderSize(1920, 1082, &width, &height);
+    EXPECT_EQ(width, 960);
+    EXPECT_EQ(height, 544);
+}
+
+} // namespace
+} // namespace ppx
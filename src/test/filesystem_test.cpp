@@ -26,6 +26,8 @@
 #include <stdio.h>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -77,7 +79,6 @@ protected:
     std::filesystem::path nonExistantFile;
     std::filesystem::path directory;
 
-private:
     static std::filesystem::path filenameFromFile(FILE* file)
     {
         return std::filesystem::path("/proc/self/fd/") / std::to_string(fileno(file));
@@ -190,5 +191,149 @@ TEST_F(FsTest, CloseFileDescriptorOnScopeEnd)
     EXPECT_EQ(getOpenFDCount(), fdCountBefore);
 }
 
+TEST_F(FsTest, OpenMappedReturnsContent)
+{
+    fs::File file;
+    EXPECT_TRUE(file.OpenMapped(readableFile));
+    ASSERT_TRUE(file.IsMapped());
+    EXPECT_EQ(file.GetLength(), kDefaultFileContent.size());
+    EXPECT_EQ(std::string_view(static_cast<const char*>(file.GetMappedData()), file.GetLength()), kDefaultFileContent);
+
+    std::string  buffer(kDefaultFileContent.size(), '\0');
+    const size_t readCount = file.Read(buffer.data(), buffer.size());
+    EXPECT_EQ(readCount, kDefaultFileContent.size());
+    EXPECT_EQ(buffer, kDefaultFileContent);
+}
+
+TEST_F(FsTest, OpenMappedNonExistantFileFails)
+{
+    fs::File file;
+    EXPECT_FALSE(file.OpenMapped(nonExistantFile));
+    EXPECT_FALSE(file.IsValid());
+}
+
+TEST_F(FsTest, OpenMappedEmptyFileFallsBackToStream)
+{
+    FILE* emptyFile = createFile("");
+
+    {
+        fs::File file;
+        EXPECT_TRUE(file.OpenMapped(filenameFromFile(emptyFile)));
+        EXPECT_TRUE(file.IsValid());
+        EXPECT_FALSE(file.IsMapped());
+        EXPECT_EQ(file.GetLength(), 0);
+    }
+
+    fclose(emptyFile);
+}
+
+TEST_F(FsTest, OpenMappedKeepsNoFileDescriptor)
+{
+    const size_t fdCountBefore = getOpenFDCount();
+
+    fs::File file;
+    EXPECT_TRUE(file.OpenMapped(readableFile));
+    EXPECT_EQ(getOpenFDCount(), fdCountBefore);
+}
+
+TEST_F(FsTest, LoadFileAsyncReturnsContent)
+{
+    fs::AsyncLoad load = fs::load_file_async(readableFile);
+    EXPECT_TRUE(load.IsValid());
+
+    std::optional<std::vector<char>> content = load.Wait();
+    ASSERT_TRUE(content.has_value());
+    EXPECT_EQ(std::string_view(content->data(), content->size()), kDefaultFileContent);
+    EXPECT_FALSE(load.IsValid());
+}
+
+TEST_F(FsTest, LoadFileAsyncNonExistantFileFails)
+{
+    fs::AsyncLoad loads[3] = {
+        fs::load_file_async(nonExistantFile),
+        fs::load_file_async(readableFile),
+        fs::load_file_async(nonExistantFile),
+    };
+    EXPECT_FALSE(loads[0].Wait().has_value());
+    EXPECT_TRUE(loads[1].Wait().has_value());
+    EXPECT_FALSE(loads[2].Wait().has_value());
+}
+
+// Builds an asset pack with the layout fs::AssetPack reads
+static std::string buildAssetPack(const std::vector<std::pair<std::string, std::string>>& entries, uint32_t version = fs::AssetPack::kVersion)
+{
+    auto append = [](std::string& pack, auto value) { pack.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+
+    std::string names;
+    for (const auto& entry : entries) {
+        names += entry.first;
+    }
+
+    std::string pack("PPXPACK", 8);
+    append(pack, version);
+    append(pack, static_cast<uint32_t>(entries.size()));
+
+    uint32_t nameOffset = 0;
+    uint64_t dataOffset = 16 + 24 * entries.size() + names.size();
+    for (const auto& entry : entries) {
+        append(pack, nameOffset);
+        append(pack, static_cast<uint32_t>(entry.first.size()));
+        append(pack, dataOffset);
+        append(pack, static_cast<uint64_t>(entry.second.size()));
+        nameOffset += static_cast<uint32_t>(entry.first.size());
+        dataOffset += entry.second.size();
+    }
+    pack += names;
+    for (const auto& entry : entries) {
+        pack += entry.second;
+    }
+    return pack;
+}
+
+TEST_F(FsTest, AssetPackFindsEntries)
+{
+    FILE* packFile = createFile(buildAssetPack({{"shaders/a.spv", "first"}, {"b.txt", "second entry"}, {"empty", ""}}));
+
+    fs::AssetPack pack;
+    ASSERT_TRUE(pack.Open(filenameFromFile(packFile)));
+    EXPECT_EQ(pack.GetEntryCount(), 3);
+
+    std::optional<std::vector<char>> content = pack.Load("shaders/a.spv");
+    ASSERT_TRUE(content.has_value());
+    EXPECT_EQ(std::string_view(content->data(), content->size()), "first");
+
+    size_t      size  = 0;
+    const char* pData = static_cast<const char*>(pack.Find("b.txt", &size));
+    ASSERT_NE(pData, nullptr);
+    EXPECT_EQ(std::string_view(pData, size), "second entry");
+
+    content = pack.Load("empty");
+    ASSERT_TRUE(content.has_value());
+    EXPECT_TRUE(content->empty());
+
+    EXPECT_FALSE(pack.Load("a.spv").has_value());
+    EXPECT_EQ(pack.Find("missing", &size), nullptr);
+    fclose(packFile);
+}
+
+TEST_F(FsTest, AssetPackRejectsInvalidFiles)
+{
+    fs::AssetPack pack;
+    EXPECT_FALSE(pack.Open(nonExistantFile));
+    EXPECT_FALSE(pack.Open(readableFile));
+
+    FILE* wrongVersion = createFile(buildAssetPack({{"a", "b"}}, fs::AssetPack::kVersion + 1));
+    EXPECT_FALSE(pack.Open(filenameFromFile(wrongVersion)));
+    fclose(wrongVersion);
+
+    // Data past the end of the file
+    std::string truncated = buildAssetPack({{"a", "content"}});
+    truncated.resize(truncated.size() - 1);
+    FILE* truncatedFile = createFile(truncated);
+    EXPECT_FALSE(pack.Open(filenameFromFile(truncatedFile)));
+    EXPECT_EQ(pack.GetEntryCount(), 0);
+    fclose(truncatedFile);
+}
+
 } // namespace ppx
 #endif
@@ -0,0 +1,120 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/frame_arena.h"
+
+#include <cstdint>
+#include <numeric>
+
+using namespace ppx;
+
+TEST(FrameArenaTest, AllocationsAreAligned)
+{
+    FrameArena arena(1024);
+
+    for (size_t alignment = 1; alignment <= 256; alignment *= 2) {
+        arena.Allocate(3);
+        void* pData = arena.Allocate(16, alignment);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(pData) % alignment, 0u);
+    }
+}
+
+TEST(FrameArenaTest, AllocationsDontOverlap)
+{
+    FrameArena arena(256);
+
+    char* pA = static_cast<char*>(arena.Allocate(100));
+    char* pB = static_cast<char*>(arena.Allocate(100));
+    char* pC = static_cast<char*>(arena.Allocate(100)); // Doesn't fit in the first block
+    EXPECT_TRUE((pB >= pA + 100) || (pB + 100 <= pA));
+    EXPECT_TRUE((pC >= pB + 100) || (pC + 100 <= pB));
+    EXPECT_EQ(arena.GetCapacity(), 512u);
+
+    // Larger than a block
+    EXPECT_NE(arena.Allocate(4096), nullptr);
+    EXPECT_GE(arena.GetCapacity(), 512u + 4096u);
+}
+
+TEST(FrameArenaTest, ScopeRewinds)
+{
+    FrameArena arena(256);
+    arena.Allocate(64);
+
+    const size_t usedBytes = arena.GetUsedBytes();
+    void*        pFirst    = nullptr;
+    {
+        FrameArena::Scope scope(arena);
+        pFirst = arena.Allocate(512);
+        EXPECT_GT(arena.GetUsedBytes(), usedBytes);
+    }
+    EXPECT_EQ(arena.GetUsedBytes(), usedBytes);
+
+    // Memory released by the scope is reused
+    FrameArena::Scope scope(arena);
+    EXPECT_EQ(arena.Allocate(512), pFirst);
+}
+
+TEST(FrameArenaTest, ResetMergesBlocks)
+{
+    FrameArena arena(256);
+    for (int i = 0; i < 8; ++i) {
+        arena.Allocate(200);
+    }
+    const size_t capacity = arena.GetCapacity();
+    EXPECT_GE(arena.GetPeakUsedBytes(), 8u * 200u);
+
+    arena.Reset();
+    EXPECT_EQ(arena.GetUsedBytes(), 0u);
+    EXPECT_EQ(arena.GetCapacity(), capacity);
+
+    // The same allocations fit without new blocks
+    for (int i = 0; i < 8; ++i) {
+        arena.Allocate(200);
+    }
+    EXPECT_EQ(arena.GetCapacity(), capacity);
+}
+
+TEST(FrameArenaTest, FrameVector)
+{
+    FrameArena        arena(256);
+    FrameArena::Scope scope(arena);
+
+    FrameVector<uint32_t> values(scope.GetAllocator<uint32_t>());
+    for (uint32_t i = 0; i < 1000; ++i) {
+        values.push_back(i);
+    }
+    EXPECT_EQ(values.size(), 1000u);
+    EXPECT_EQ(std::accumulate(values.begin(), values.end(), 0u), 999u * 1000u / 2u);
+    EXPECT_EQ(CountU32(values), 1000u);
+    EXPECT_EQ(DataPtr(values), values.data());
+}
+
+TEST(FrameArenaTest, ThreadArenaResetsOnNextFrame)
+{
+    FrameArena& arena = FrameArena::GetThreadArena();
+    arena.Allocate(128);
+    EXPECT_GT(arena.GetUsedBytes(), 0u);
+
+    // Not reset while a scope is open
+    {
+        FrameArena::Scope scope(FrameArena::GetThreadArena());
+        scope.GetArena().Allocate(64);
+        FrameArena::NextFrame();
+        EXPECT_GT(FrameArena::GetThreadArena().GetUsedBytes(), 128u);
+    }
+
+    EXPECT_EQ(FrameArena::GetThreadArena().GetUsedBytes(), 0u);
+}
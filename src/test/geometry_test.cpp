@@ -254,5 +254,105 @@ TEST(GeometryUint8IndexTest, AppendIndicesEdgePacksDataAsUint8)
     EXPECT_THAT(*geometry.GetIndexBuffer(), BufferEq(std::vector<uint8_t>({0, 1})));
 }
 
+// Geometry built from mesh one vertex at a time, the way Create() does
+// for formats it can't copy whole streams of
+Geometry CreatePerVertex(const GeometryCreateInfo& createInfo, const TriMesh& mesh)
+{
+    Geometry geometry;
+    EXPECT_EQ(Geometry::Create(createInfo, &geometry), ppx::SUCCESS);
+
+    std::vector<uint32_t> indices;
+    mesh.GetIndices(indices);
+    if (createInfo.indexType == grfx::INDEX_TYPE_UNDEFINED) {
+        for (uint32_t index : indices) {
+            TriMeshVertexData vertexData = {};
+            EXPECT_EQ(mesh.GetVertexData(index, &vertexData), ppx::SUCCESS);
+            geometry.AppendVertexData(vertexData);
+        }
+        return geometry;
+    }
+
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        geometry.AppendIndicesTriangle(indices[i], indices[i + 1], indices[i + 2]);
+    }
+    for (uint32_t i = 0; i < mesh.GetCountPositions(); ++i) {
+        TriMeshVertexData vertexData = {};
+        EXPECT_EQ(mesh.GetVertexData(i, &vertexData), ppx::SUCCESS);
+        geometry.AppendVertexData(vertexData);
+    }
+    return geometry;
+}
+
+void ExpectBuffersEqual(const Geometry::Buffer& actual, const Geometry::Buffer& expected)
+{
+    EXPECT_EQ(actual.GetElementSize(), expected.GetElementSize());
+    ASSERT_EQ(actual.GetSize(), expected.GetSize());
+    EXPECT_THAT(std::vector<char>(actual.GetData(), actual.GetData() + actual.GetSize()), ElementsAreArray(std::vector<char>(expected.GetData(), expected.GetData() + expected.GetSize())));
+}
+
+TEST(GeometryTriMeshTest, CreateMatchesPerVertexData)
+{
+    // No bitangents in the mesh, they must come out as zeros
+    const TriMesh mesh = TriMesh::CreateSphere(1.0f, 8, 6, TriMeshOptions().Indices().AllAttributes());
+
+    const std::vector<GeometryCreateInfo> createInfos = {
+        GeometryCreateInfo::Interleaved().AddPosition().AddNormal().AddColor().AddTexCoord().AddTangent().AddBitangent(),
+        GeometryCreateInfo::Planar().IndexTypeU16().AddPosition().AddNormal().AddTexCoord().AddBitangent(),
+        GeometryCreateInfo::PositionPlanar().IndexTypeU32().AddPosition().AddTexCoord().AddTangent(),
+    };
+    for (const GeometryCreateInfo& createInfo : createInfos) {
+        Geometry geometry;
+        ASSERT_EQ(Geometry::Create(createInfo, mesh, &geometry), ppx::SUCCESS);
+        const Geometry expected = CreatePerVertex(createInfo, mesh);
+
+        EXPECT_EQ(geometry.GetVertexCount(), expected.GetVertexCount());
+        ASSERT_EQ(geometry.GetVertexBufferCount(), expected.GetVertexBufferCount());
+        for (uint32_t i = 0; i < geometry.GetVertexBufferCount(); ++i) {
+            ExpectBuffersEqual(*geometry.GetVertexBuffer(i), *expected.GetVertexBuffer(i));
+        }
+        EXPECT_EQ(geometry.GetIndexCount(), expected.GetIndexCount());
+        ExpectBuffersEqual(*geometry.GetIndexBuffer(), *expected.GetIndexBuffer());
+    }
+}
+
+TEST(GeometryTriMeshTest, CompactIndices)
+{
+    const TriMesh mesh = TriMesh::CreateSphere(1.0f, 8, 6, TriMeshOptions().Indices());
+
+    Geometry geometry;
+    ASSERT_EQ(Geometry::Create(GeometryCreateInfo::Planar().IndexTypeU32().AddPosition(), mesh, &geometry), ppx::SUCCESS);
+    const uint32_t indexCount = geometry.GetIndexCount();
+
+    EXPECT_TRUE(geometry.CompactIndices());
+    EXPECT_EQ(geometry.GetIndexType(), grfx::INDEX_TYPE_UINT16);
+    EXPECT_EQ(geometry.GetIndexBuffer()->GetElementSize(), sizeof(uint16_t));
+    ASSERT_EQ(geometry.GetIndexCount(), indexCount);
+
+    std::vector<uint32_t> indices;
+    mesh.GetIndices(indices);
+    const uint16_t* pIndices = reinterpret_cast<const uint16_t*>(geometry.GetIndexBuffer()->GetData());
+    EXPECT_THAT(std::vector<uint32_t>(pIndices, pIndices + indexCount), ElementsAreArray(indices));
+
+    // Already UINT16
+    EXPECT_FALSE(geometry.CompactIndices());
+}
+
+TEST(GeometryTriMeshTest, ConvertToTriangleStrips)
+{
+    const TriMesh mesh = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 8, 8, TriMeshOptions().Indices().OptimizeVertexCache());
+
+    Geometry geometry;
+    ASSERT_EQ(Geometry::Create(GeometryCreateInfo::Planar().IndexTypeU16().AddPosition(), mesh, &geometry), ppx::SUCCESS);
+    const uint32_t indexCount = geometry.GetIndexCount();
+
+    EXPECT_TRUE(geometry.ConvertToTriangleStrips());
+    EXPECT_EQ(geometry.GetPrimitiveTopology(), grfx::PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP);
+    EXPECT_EQ(geometry.GetIndexType(), grfx::INDEX_TYPE_UINT16);
+    EXPECT_LT(geometry.GetIndexCount(), indexCount);
+
+    // Already strips
+    EXPECT_FALSE(geometry.ConvertToTriangleStrips());
+}
+
 } // namespace
 } // namespace ppx
@@ -0,0 +1,144 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/grfx/grfx_object_table.h"
+
+namespace ppx {
+namespace grfx {
+namespace {
+
+struct TestObject
+    : public ObjectTableEntry
+{
+    int value = 0;
+};
+
+std::vector<int> Values(const ObjectTable<TestObject>& table)
+{
+    std::vector<int> values;
+    table.ForEach([&values](TestObject* pObject) { values.push_back(pObject->value); });
+    return values;
+}
+
+TEST(ObjectTableTest, InsertAndRemove)
+{
+    ObjectTable<TestObject> table;
+    TestObject              objects[3];
+    for (int i = 0; i < 3; ++i) {
+        objects[i].value = i;
+        table.Insert(&objects[i]);
+    }
+    EXPECT_EQ(table.GetCount(), 3u);
+    EXPECT_EQ(Values(table), std::vector<int>({0, 1, 2}));
+
+    EXPECT_TRUE(table.Remove(&objects[1]));
+    EXPECT_FALSE(table.Contains(&objects[1]));
+    EXPECT_TRUE(table.Contains(&objects[2]));
+    EXPECT_EQ(table.GetCount(), 2u);
+    EXPECT_EQ(Values(table), std::vector<int>({0, 2}));
+}
+
+TEST(ObjectTableTest, RemoveTwiceFails)
+{
+    ObjectTable<TestObject> table;
+    TestObject              object;
+    table.Insert(&object);
+    EXPECT_TRUE(table.Remove(&object));
+    EXPECT_FALSE(table.Remove(&object));
+    EXPECT_TRUE(table.IsEmpty());
+}
+
+TEST(ObjectTableTest, RemoveFromOtherTableFails)
+{
+    ObjectTable<TestObject> table;
+    ObjectTable<TestObject> otherTable;
+    TestObject              object;
+    TestObject              otherObject;
+    table.Insert(&object);
+    otherTable.Insert(&otherObject);
+
+    // Both objects are in slot 0, the pointer doesn't match
+    EXPECT_FALSE(table.Remove(&otherObject));
+    EXPECT_EQ(table.GetCount(), 1u);
+}
+
+TEST(ObjectTableTest, ReusedSlotChecksGeneration)
+{
+    ObjectTable<TestObject> table;
+    TestObject              object;
+    table.Insert(&object);
+    ASSERT_TRUE(table.Remove(&object));
+
+    // Reinserting reuses the slot with a new generation, so the entry the
+    // object had before is stale
+    const TestObject stale = object;
+    table.Insert(&object);
+    const TestObject current = object;
+    EXPECT_TRUE(table.Contains(&object));
+
+    object = stale;
+    EXPECT_FALSE(table.Contains(&object));
+    EXPECT_FALSE(table.Remove(&object));
+
+    object = current;
+    EXPECT_TRUE(table.Remove(&object));
+}
+
+TEST(ObjectTableTest, ManyObjectsSpanPages)
+{
+    const uint32_t          count = 3 * ObjectTable<TestObject>::kPageSize + 7;
+    ObjectTable<TestObject> table;
+    std::vector<TestObject> objects(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        objects[i].value = static_cast<int>(i);
+        table.Insert(&objects[i]);
+    }
+    EXPECT_EQ(table.GetCount(), count);
+
+    // Remove the even objects, then reinsert them into the freed slots
+    for (uint32_t i = 0; i < count; i += 2) {
+        EXPECT_TRUE(table.Remove(&objects[i]));
+    }
+    EXPECT_EQ(table.GetCount(), count / 2);
+    for (uint32_t i = 0; i < count; i += 2) {
+        table.Insert(&objects[i]);
+    }
+    EXPECT_EQ(table.GetCount(), count);
+    for (uint32_t i = 0; i < count; ++i) {
+        EXPECT_TRUE(table.Contains(&objects[i]));
+    }
+}
+
+TEST(ObjectTableTest, ForEachAllowsRemoval)
+{
+    ObjectTable<TestObject> table;
+    TestObject              objects[4];
+    for (TestObject& object : objects) {
+        table.Insert(&object);
+    }
+
+    uint32_t visited = 0;
+    table.ForEach([&table, &visited](TestObject* pObject) {
+        EXPECT_TRUE(table.Remove(pObject));
+        ++visited;
+    });
+    EXPECT_EQ(visited, 4u);
+    EXPECT_TRUE(table.IsEmpty());
+}
+
+} // namespace
+} // namespace grfx
+} // namespace ppx
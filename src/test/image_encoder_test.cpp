@@ -0,0 +1,146 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/bitmap.h"
+#include "ppx/image_encoder.h"
+
+#include <vector>
+
+using namespace ppx;
+
+// Not a multiple of the SIMD widths, so rows end with scalar pixels
+const uint32_t kWidth  = 37;
+const uint32_t kHeight = 5;
+
+std::vector<uint8_t> CreateTexels(uint32_t rowPitch)
+{
+    std::vector<uint8_t> texels(rowPitch * kHeight);
+    for (size_t i = 0; i < texels.size(); ++i) {
+        texels[i] = static_cast<uint8_t>(i * 7 + (i >> 5));
+    }
+    return texels;
+}
+
+TEST(ImageEncoderTest, GetImageFileFormat)
+{
+    EXPECT_EQ(GetImageFileFormat("a/b.png"), IMAGE_FILE_FORMAT_PNG);
+    EXPECT_EQ(GetImageFileFormat("b.PNG"), IMAGE_FILE_FORMAT_PNG);
+    EXPECT_EQ(GetImageFileFormat("b.qoi"), IMAGE_FILE_FORMAT_QOI);
+    EXPECT_EQ(GetImageFileFormat("b.ppm"), IMAGE_FILE_FORMAT_PPM);
+    EXPECT_EQ(GetImageFileFormat("b"), IMAGE_FILE_FORMAT_PPM);
+}
+
+TEST(ImageEncoderTest, ConvertToRGB8SwizzlesBGRA)
+{
+    const uint32_t             rowPitch = kWidth * 4 + 12;
+    const std::vector<uint8_t> texels   = CreateTexels(rowPitch);
+
+    std::vector<uint8_t> rgb(kWidth * kHeight * 3);
+    ASSERT_EQ(ConvertToRGB8(grfx::FORMAT_B8G8R8A8_UNORM, texels.data(), kWidth, kHeight, rowPitch, rgb.data()), ppx::SUCCESS);
+    for (uint32_t y = 0; y < kHeight; ++y) {
+        for (uint32_t x = 0; x < kWidth; ++x) {
+            const uint8_t* pSrc = texels.data() + y * rowPitch + x * 4;
+            const uint8_t* pDst = rgb.data() + (y * kWidth + x) * 3;
+            EXPECT_EQ(pDst[0], pSrc[2]);
+            EXPECT_EQ(pDst[1], pSrc[1]);
+            EXPECT_EQ(pDst[2], pSrc[0]);
+        }
+    }
+}
+
+TEST(ImageEncoderTest, ConvertToRGB8OffsetsSignedFormats)
+{
+    const uint32_t             rowPitch = kWidth * 4;
+    const std::vector<uint8_t> texels   = CreateTexels(rowPitch);
+
+    std::vector<uint8_t> rgb(kWidth * kHeight * 3);
+    ASSERT_EQ(ConvertToRGB8(grfx::FORMAT_R8G8B8A8_SNORM, texels.data(), kWidth, kHeight, rowPitch, rgb.data()), ppx::SUCCESS);
+    for (uint32_t i = 0; i < kWidth * kHeight; ++i) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            EXPECT_EQ(rgb[i * 3 + c], static_cast<uint8_t>(texels[i * 4 + c] + 128));
+        }
+    }
+}
+
+TEST(ImageEncoderTest, ConvertToRGB8ZeroesMissingComponents)
+{
+    const uint32_t             rowPitch = kWidth * 2;
+    const std::vector<uint8_t> texels   = CreateTexels(rowPitch);
+
+    std::vector<uint8_t> rgb(kWidth * kHeight * 3);
+    ASSERT_EQ(ConvertToRGB8(grfx::FORMAT_R8G8_UNORM, texels.data(), kWidth, kHeight, rowPitch, rgb.data()), ppx::SUCCESS);
+    for (uint32_t i = 0; i < kWidth * kHeight; ++i) {
+        EXPECT_EQ(rgb[i * 3 + 0], texels[i * 2 + 0]);
+        EXPECT_EQ(rgb[i * 3 + 1], texels[i * 2 + 1]);
+        EXPECT_EQ(rgb[i * 3 + 2], 0);
+    }
+}
+
+TEST(ImageEncoderTest, ConvertToRGB8RejectsWideFormats)
+{
+    std::vector<uint8_t> texels(8);
+    std::vector<uint8_t> rgb(3);
+    EXPECT_EQ(ConvertToRGB8(grfx::FORMAT_R16G16B16A16_UNORM, texels.data(), 1, 1, 8, rgb.data()), ppx::ERROR_IMAGE_INVALID_FORMAT);
+}
+
+TEST(ImageEncoderTest, EncodePNGRoundTrip)
+{
+    for (uint32_t channelCount = 3; channelCount <= 4; ++channelCount) {
+        const uint32_t             rowPitch = kWidth * channelCount + 3;
+        const std::vector<uint8_t> pixels   = CreateTexels(rowPitch);
+
+        std::vector<uint8_t> png;
+        ASSERT_EQ(EncodePNG(pixels.data(), kWidth, kHeight, rowPitch, channelCount, &png), ppx::SUCCESS);
+
+        Bitmap bitmap;
+        ASSERT_EQ(Bitmap::LoadFromMemory(png.size(), png.data(), &bitmap), ppx::SUCCESS);
+        ASSERT_EQ(bitmap.GetWidth(), kWidth);
+        ASSERT_EQ(bitmap.GetHeight(), kHeight);
+        for (uint32_t y = 0; y < kHeight; ++y) {
+            for (uint32_t x = 0; x < kWidth; ++x) {
+                const uint8_t* pSrc = pixels.data() + y * rowPitch + x * channelCount;
+                const uint8_t* pDst = bitmap.GetPixel8u(x, y);
+                for (uint32_t c = 0; c < channelCount; ++c) {
+                    EXPECT_EQ(pDst[c], pSrc[c]);
+                }
+            }
+        }
+    }
+}
+
+TEST(ImageEncoderTest, EncodePNGCompressesFlatImages)
+{
+    std::vector<uint8_t> pixels(256 * 256 * 3, 0x40);
+    std::vector<uint8_t> png;
+    ASSERT_EQ(EncodePNG(pixels.data(), 256, 256, 256 * 3, 3, &png), ppx::SUCCESS);
+    EXPECT_LT(png.size(), pixels.size() / 50);
+}
+
+TEST(ImageEncoderTest, EncodeQOI)
+{
+    // A pixel equal to the initial one, then one small luma difference
+    const uint8_t        pixels[6] = {0, 0, 0, 1, 2, 3};
+    std::vector<uint8_t> qoi;
+    ASSERT_EQ(EncodeQOI(pixels, 2, 1, 6, 3, &qoi), ppx::SUCCESS);
+
+    const std::vector<uint8_t> expected = {
+        'q', 'o', 'i', 'f', 0, 0, 0, 2, 0, 0, 0, 1, 3, 0, // Header
+        0xC0,                                             // Run of 1
+        0xA2, 0x79,                                       // Luma, dg = 2, dr - dg = -1, db - dg = 1
+        0, 0, 0, 0, 0, 0, 0, 1,                           // End marker
+    };
+    EXPECT_EQ(qoi, expected);
+}
@@ -0,0 +1,103 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/job_system.h"
+
+#include <atomic>
+#include <vector>
+
+namespace ppx {
+namespace {
+
+TEST(JobSystemTest, RunAndWait)
+{
+    JobSystem jobSystem;
+    ASSERT_EQ(jobSystem.Initialize({4}), ppx::SUCCESS);
+    EXPECT_EQ(jobSystem.GetWorkerCount(), 4);
+
+    std::atomic<uint32_t> sum = 0;
+    JobCounter            counter;
+    for (uint32_t i = 1; i <= 100; ++i) {
+        jobSystem.Run([&sum, i]() { sum += i; }, &counter);
+    }
+    jobSystem.Wait(&counter);
+
+    EXPECT_TRUE(counter.IsDone());
+    EXPECT_EQ(sum, 5050);
+}
+
+TEST(JobSystemTest, NestedJobsWaitOnTheirChildren)
+{
+    JobSystem jobSystem;
+    ASSERT_EQ(jobSystem.Initialize({2}), ppx::SUCCESS);
+
+    std::atomic<uint32_t> count = 0;
+    JobCounter            counter;
+    for (uint32_t i = 0; i < 8; ++i) {
+        jobSystem.Run(
+            [&jobSystem, &count]() {
+                JobCounter children;
+                for (uint32_t j = 0; j < 8; ++j) {
+                    jobSystem.Run([&count]() { ++count; }, &children);
+                }
+                jobSystem.Wait(&children);
+            },
+            &counter);
+    }
+    jobSystem.Wait(&counter);
+
+    EXPECT_EQ(count, 64);
+}
+
+TEST(JobSystemTest, RunAfterWaitsForDependency)
+{
+    JobSystem jobSystem;
+    ASSERT_EQ(jobSystem.Initialize({4}), ppx::SUCCESS);
+
+    std::atomic<uint32_t> firstCount = 0;
+    std::atomic<bool>     ranEarly   = false;
+    JobCounter            first;
+    JobCounter            second;
+    for (uint32_t i = 0; i < 16; ++i) {
+        jobSystem.Run([&firstCount]() { ++firstCount; }, &first);
+    }
+    jobSystem.RunAfter(
+        &first, [&firstCount, &ranEarly]() { ranEarly = (firstCount != 16); }, &second);
+    jobSystem.Wait(&second);
+
+    EXPECT_TRUE(first.IsDone());
+    EXPECT_FALSE(ranEarly);
+}
+
+TEST(JobSystemTest, ParallelForCoversRange)
+{
+    JobSystem jobSystem;
+    ASSERT_EQ(jobSystem.Initialize({3}), ppx::SUCCESS);
+
+    std::vector<uint32_t> values(1000, 0);
+    jobSystem.ParallelFor(CountU32(values), 64, [&values](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            values[i] += i;
+        }
+    });
+
+    for (uint32_t i = 0; i < CountU32(values); ++i) {
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+} // namespace
+} // namespace ppx
@@ -730,4 +730,92 @@ TEST_F(KnobManagerWithKnobsTestFixture, KnobManager_UpdateDependentKnobs)
     EXPECT_FALSE(k1->GetValue());
 }
 
+// -------------------------------------------------------------------------------------------------
+// KnobSnapshot
+// -------------------------------------------------------------------------------------------------
+
+class KnobSnapshotTestFixture : public KnobManagerWithKnobsTestFixture
+{
+protected:
+    KnobSnapshot CreateSnapshot(const char* json)
+    {
+        CommandLineParser parser;
+        CliOptions        opts;
+        EXPECT_EQ(parser.ParseJson(opts, nlohmann::json::parse(json)), SUCCESS);
+        return km.CreateSnapshot(opts);
+    }
+
+    void DigestAll()
+    {
+        for (Knob* pKnob : std::initializer_list<Knob*>{k1.get(), k2.get(), k3.get(), k4.get(), k5.get(), k6.get(), k7.get(), k8.get(), k9.get(), k10.get()}) {
+            pKnob->DigestUpdate();
+        }
+    }
+};
+
+TEST_F(KnobSnapshotTestFixture, KnobSnapshot_ContainsOnlySpecifiedKnobs)
+{
+    KnobSnapshot snapshot = CreateSnapshot(R"({"flag_name1": false, "flag_name4": "c3 and more", "unknown": 3})");
+    EXPECT_EQ(snapshot.GetKnobCount(), 2);
+    EXPECT_TRUE(km.CreateSnapshot(CliOptions()).IsEmpty());
+}
+
+TEST_F(KnobSnapshotTestFixture, KnobSnapshot_ApplySetsValues)
+{
+    KnobSnapshot snapshot = CreateSnapshot(R"({
+        "flag_name1": false,
+        "flag_name3": 9,
+        "flag_name4": "c1",
+        "flag_name6": 2.5,
+        "flag_name9": "3x4",
+        "flag_name10": ["x", "y"]
+    })");
+
+    EXPECT_EQ(km.ApplySnapshot(snapshot), 6);
+    EXPECT_FALSE(k1->GetValue());
+    EXPECT_EQ(k3->GetValue(), 9);
+    EXPECT_EQ(k4->GetIndex(), 0);
+    EXPECT_EQ(k6->GetValue(), 2.5f);
+    EXPECT_EQ(k9->GetValue(), std::make_pair(3, 4));
+    EXPECT_EQ(k10->GetValue(), std::vector<std::string>({"x", "y"}));
+
+    // Unchanged knobs keep their values
+    EXPECT_TRUE(k2->GetValue());
+    EXPECT_EQ(k7->GetValue(), 8);
+}
+
+TEST_F(KnobSnapshotTestFixture, KnobSnapshot_OnlyChangedKnobsRaiseUpdate)
+{
+    KnobSnapshot first  = CreateSnapshot(R"({"flag_name1": false, "flag_name3": 9, "flag_name7": 8})");
+    KnobSnapshot second = CreateSnapshot(R"({"flag_name1": false, "flag_name3": 2, "flag_name7": 8})");
+    DigestAll();
+
+    // flag_name7 already has its value
+    EXPECT_EQ(km.ApplySnapshot(first), 2);
+    EXPECT_TRUE(k1->DigestUpdate());
+    EXPECT_TRUE(k3->DigestUpdate());
+    EXPECT_FALSE(k7->DigestUpdate());
+
+    EXPECT_EQ(km.ApplySnapshot(first), 0);
+    EXPECT_FALSE(k1->DigestUpdate());
+    EXPECT_FALSE(k3->DigestUpdate());
+
+    EXPECT_EQ(km.ApplySnapshot(second), 1);
+    EXPECT_FALSE(k1->DigestUpdate());
+    EXPECT_TRUE(k3->DigestUpdate());
+    EXPECT_EQ(k3->GetValue(), 2);
+}
+
+TEST_F(KnobSnapshotTestFixture, KnobSnapshot_SkipsInvalidValues)
+{
+    // Out of the slider range, not a dropdown choice
+    KnobSnapshot snapshot = CreateSnapshot(R"({"flag_name3": 11, "flag_name4": "c4", "flag_name2": false})");
+    EXPECT_EQ(snapshot.GetKnobCount(), 1);
+
+    EXPECT_EQ(km.ApplySnapshot(snapshot), 1);
+    EXPECT_FALSE(k2->GetValue());
+    EXPECT_EQ(k3->GetValue(), 5);
+    EXPECT_EQ(k4->GetIndex(), 1);
+}
+
 } // namespace ppx
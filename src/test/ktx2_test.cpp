@@ -0,0 +1,94 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/ktx2.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace ppx;
+
+namespace {
+
+// KTX2 file with levelCount levels of levelSize bytes each, all levels
+// have the same byte value as their index
+std::vector<uint8_t> CreateKtx2(uint32_t vkFormat, uint32_t width, uint32_t height, uint32_t levelCount, uint32_t levelSize, uint32_t supercompression = 0)
+{
+    const uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    const size_t  dataOffset     = 80 + 24 * levelCount;
+
+    std::vector<uint8_t> data(dataOffset + levelCount * levelSize, 0);
+    memcpy(data.data(), identifier, sizeof(identifier));
+
+    const uint32_t header[9] = {vkFormat, 1, width, height, 0, 0, 1, levelCount, supercompression};
+    memcpy(data.data() + 12, header, sizeof(header));
+
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        const uint64_t level[3] = {dataOffset + i * levelSize, levelSize, levelSize};
+        memcpy(data.data() + 80 + 24 * i, level, sizeof(level));
+        memset(data.data() + level[0], static_cast<int>(i), levelSize);
+    }
+    return data;
+}
+
+} // namespace
+
+TEST(Ktx2Test, LoadBlockCompressed)
+{
+    // BC7 8x8, 4 blocks then 1 block
+    const std::vector<uint8_t> data = CreateKtx2(145, 8, 8, 2, 64);
+    EXPECT_TRUE(Ktx2::IsKtx2Data(data.size(), data.data()));
+    EXPECT_FALSE(Ktx2::IsTranscodingRequired(data.size(), data.data()));
+    EXPECT_EQ(Ktx2::ReadFormat(data.size(), data.data()), grfx::FORMAT_BC7_UNORM);
+
+    Ktx2 ktx2;
+    ASSERT_EQ(Ktx2::LoadFromMemory(data.size(), data.data(), &ktx2), ppx::SUCCESS);
+    EXPECT_EQ(ktx2.GetFormat(), grfx::FORMAT_BC7_UNORM);
+    ASSERT_EQ(ktx2.GetLevelCount(), 2u);
+    EXPECT_EQ(ktx2.GetLevel(1).width, 4u);
+    EXPECT_EQ(ktx2.GetLevel(1).size, 64u);
+    EXPECT_EQ(ktx2.GetLevelData(1)[0], 1);
+}
+
+TEST(Ktx2Test, TranscodingRequired)
+{
+    // ETC1S with BasisLZ and UASTC with Zstd
+    for (const auto& data : {CreateKtx2(0, 8, 8, 1, 64, Ktx2::SUPERCOMPRESSION_BASIS_LZ), CreateKtx2(0, 8, 8, 1, 64, Ktx2::SUPERCOMPRESSION_ZSTD)}) {
+        EXPECT_TRUE(Ktx2::IsTranscodingRequired(data.size(), data.data()));
+        EXPECT_EQ(Ktx2::ReadFormat(data.size(), data.data()), grfx::FORMAT_UNDEFINED);
+
+        Ktx2 ktx2;
+        EXPECT_EQ(Ktx2::LoadFromMemory(data.size(), data.data(), &ktx2), ppx::ERROR_IMAGE_INVALID_FORMAT);
+    }
+}
+
+TEST(Ktx2Test, InvalidData)
+{
+    Ktx2 ktx2;
+
+    // Level too small for 8x8 BC1
+    std::vector<uint8_t> data = CreateKtx2(131, 8, 8, 1, 16);
+    EXPECT_EQ(Ktx2::LoadFromMemory(data.size(), data.data(), &ktx2), ppx::ERROR_IMAGE_FILE_LOAD_FAILED);
+
+    // Level past the end
+    data = CreateKtx2(131, 4, 4, 1, 8);
+    data.resize(data.size() - 1);
+    EXPECT_EQ(Ktx2::LoadFromMemory(data.size(), data.data(), &ktx2), ppx::ERROR_IMAGE_FILE_LOAD_FAILED);
+
+    data[0] = 0;
+    EXPECT_FALSE(Ktx2::IsKtx2Data(data.size(), data.data()));
+    EXPECT_EQ(Ktx2::LoadFromMemory(data.size(), data.data(), &ktx2), ppx::ERROR_IMAGE_FILE_LOAD_FAILED);
+}
@@ -17,7 +17,10 @@
 #include "ppx/log.h"
 #include "ppx/config.h"
 
+#include <cstdio>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace ppx {
 
@@ -169,4 +172,88 @@ TEST_F(LogTest, LogDifferentLevels)
     EXPECT_EQ(expected, mOut.str());
 }
 
+TEST_F(LogStaticTest, LogAsyncWritesOnShutdown)
+{
+    std::stringstream out;
+    Log::Initialize(LOG_MODE_CONSOLE | LOG_MODE_ASYNC, nullptr, &out);
+    PPX_LOG_INFO("Info " << 1);
+    PPX_LOG_WARN("Warn 2");
+    Log::Shutdown();
+
+    std::string expected =
+        "Logging started\n"
+        "Info 1\n"
+        "[WARNING] Warn 2\n"
+        "Logging stopped\n";
+    EXPECT_EQ(expected, out.str());
+}
+
+TEST_F(LogStaticTest, LogAsyncFatalWaitsUntilWritten)
+{
+    std::stringstream out;
+    Log::Initialize(LOG_MODE_CONSOLE | LOG_MODE_ASYNC, nullptr, &out);
+    PPX_LOG_FATAL("Fatal");
+
+    std::string expected =
+        "Logging started\n"
+        "[FATAL ERROR] Fatal\n";
+    EXPECT_EQ(expected, out.str());
+
+    Log::Shutdown();
+}
+
+TEST_F(LogStaticTest, LogAsyncKeepsOrderPerThread)
+{
+    const int         threadCount  = 4;
+    const int         messageCount = 256;
+    std::stringstream out;
+    Log::Initialize(LOG_MODE_CONSOLE | LOG_MODE_ASYNC, nullptr, &out);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < messageCount; ++i) {
+                PPX_LOG_INFO(t << " " << i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    Log::Shutdown();
+
+    std::vector<int> next(threadCount, 0);
+    std::string      line;
+    while (std::getline(out, line)) {
+        int t = 0;
+        int i = 0;
+        if (sscanf(line.c_str(), "%d %d", &t, &i) == 2) {
+            ASSERT_LT(t, threadCount);
+            EXPECT_EQ(i, next[t]);
+            next[t] = i + 1;
+        }
+    }
+    EXPECT_EQ(next, std::vector<int>(threadCount, messageCount));
+}
+
+TEST_F(LogStaticTest, LogSetAsync)
+{
+    std::stringstream out;
+    Log::Initialize(LOG_MODE_CONSOLE, nullptr, &out);
+    Log::SetAsync(true);
+    EXPECT_TRUE(Log::IsModeActive(LOG_MODE_ASYNC));
+    PPX_LOG_INFO("Async");
+    Log::SetAsync(false);
+    EXPECT_FALSE(Log::IsModeActive(LOG_MODE_ASYNC));
+    PPX_LOG_INFO("Sync");
+
+    std::string expected =
+        "Logging started\n"
+        "Async\n"
+        "Sync\n";
+    EXPECT_EQ(expected, out.str());
+
+    Log::Shutdown();
+}
+
 } // namespace ppx
@@ -0,0 +1,352 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/mesh_optimizer.h"
+#include "ppx/tri_mesh.h"
+
+#include <random>
+#include <set>
+
+using namespace ppx;
+
+namespace {
+
+// Triangles of a mesh rotated to start at their smallest index, so that
+// reordering triangles can be checked without caring about the order.
+std::multiset<std::array<uint32_t, 3>> GetTriangleSet(const std::vector<uint32_t>& indices)
+{
+    std::multiset<std::array<uint32_t, 3>> triangles;
+    for (size_t i = 0; (i + 2) < indices.size(); i += 3) {
+        std::array<uint32_t, 3> triangle = {indices[i], indices[i + 1], indices[i + 2]};
+        std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+        triangles.insert(triangle);
+    }
+    return triangles;
+}
+
+std::vector<uint32_t> GetIndices(const TriMesh& mesh)
+{
+    return std::vector<uint32_t>(mesh.GetDataIndicesU32(), mesh.GetDataIndicesU32() + mesh.GetCountIndices());
+}
+
+// Triangle list drawn by strips separated by restartIndex
+std::vector<uint32_t> ExpandTriangleStrips(const std::vector<uint32_t>& strips, uint32_t restartIndex)
+{
+    std::vector<uint32_t> indices;
+    size_t                start = 0;
+    for (size_t i = 0; i <= strips.size(); ++i) {
+        if ((i < strips.size()) && (strips[i] != restartIndex)) {
+            continue;
+        }
+        for (size_t t = start; (t + 2) < i; ++t) {
+            const bool odd = ((t - start) % 2) != 0;
+            indices.push_back(strips[odd ? t + 1 : t]);
+            indices.push_back(strips[odd ? t : t + 1]);
+            indices.push_back(strips[t + 2]);
+        }
+        start = i + 1;
+    }
+    return indices;
+}
+
+// Grid triangles in random order
+std::vector<uint32_t> CreateShuffledGrid(uint32_t segments)
+{
+    TriMesh               mesh    = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), segments, segments, TriMeshOptions().Indices());
+    std::vector<uint32_t> indices = GetIndices(mesh);
+
+    std::vector<uint32_t> order(indices.size() / 3);
+    for (uint32_t i = 0; i < CountU32(order); ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+    std::vector<uint32_t> shuffled;
+    for (uint32_t t : order) {
+        shuffled.insert(shuffled.end(), indices.begin() + 3 * t, indices.begin() + 3 * t + 3);
+    }
+    return shuffled;
+}
+
+// Closed torus with wrapped indices, so it has no borders or seams
+std::vector<uint32_t> CreateTorus(uint32_t usegs, uint32_t vsegs, std::vector<float3>* pPositions)
+{
+    pPositions->clear();
+    for (uint32_t j = 0; j < vsegs; ++j) {
+        for (uint32_t i = 0; i < usegs; ++i) {
+            const float u = 2.0f * glm::pi<float>() * static_cast<float>(i) / static_cast<float>(usegs);
+            const float v = 2.0f * glm::pi<float>() * static_cast<float>(j) / static_cast<float>(vsegs);
+            const float r = 1.0f + 0.25f * std::cos(v);
+            pPositions->push_back(float3(r * std::cos(u), 0.25f * std::sin(v), r * std::sin(u)));
+        }
+    }
+
+    std::vector<uint32_t> indices;
+    for (uint32_t j = 0; j < vsegs; ++j) {
+        for (uint32_t i = 0; i < usegs; ++i) {
+            const uint32_t v0 = j * usegs + i;
+            const uint32_t v1 = j * usegs + (i + 1) % usegs;
+            const uint32_t v2 = ((j + 1) % vsegs) * usegs + i;
+            const uint32_t v3 = ((j + 1) % vsegs) * usegs + (i + 1) % usegs;
+            indices.insert(indices.end(), {v0, v2, v1, v1, v2, v3});
+        }
+    }
+    return indices;
+}
+
+} // namespace
+
+TEST(MeshOptimizerTest, AnalyzeVertexCache)
+{
+    // Two triangles sharing an edge: 4 misses
+    const std::vector<uint32_t> indices = {0, 1, 2, 2, 1, 3};
+
+    VertexCacheStats stats = AnalyzeVertexCache(indices.data(), CountU32(indices), 4);
+    EXPECT_EQ(stats.vertexShaderInvocations, 4u);
+    EXPECT_FLOAT_EQ(stats.acmr, 2.0f);
+    EXPECT_FLOAT_EQ(stats.atvr, 1.0f);
+
+    // With a single entry only the shared vertex right after it is a hit
+    stats = AnalyzeVertexCache(indices.data(), CountU32(indices), 4, 1);
+    EXPECT_EQ(stats.vertexShaderInvocations, 5u);
+}
+
+TEST(MeshOptimizerTest, VertexCacheKeepsTrianglesAndLowersAcmr)
+{
+    const uint32_t        segments    = 32;
+    const uint32_t        vertexCount = (segments + 1) * (segments + 1);
+    std::vector<uint32_t> indices     = CreateShuffledGrid(segments);
+    const auto            triangles   = GetTriangleSet(indices);
+
+    const float before = AnalyzeVertexCache(indices.data(), CountU32(indices), vertexCount).acmr;
+    OptimizeVertexCache(indices.data(), CountU32(indices), vertexCount);
+    const float after = AnalyzeVertexCache(indices.data(), CountU32(indices), vertexCount).acmr;
+
+    EXPECT_EQ(GetTriangleSet(indices), triangles);
+    EXPECT_GT(before, 2.0f);
+    EXPECT_LT(after, 0.8f);
+}
+
+TEST(MeshOptimizerTest, OverdrawKeepsTriangles)
+{
+    TriMesh mesh = TriMesh::CreateSphere(1.0f, 32, 16, TriMeshOptions().Indices());
+
+    std::vector<uint32_t> source     = GetIndices(mesh);
+    const float           sourceAcmr = AnalyzeVertexCache(source.data(), CountU32(source), mesh.GetCountPositions()).acmr;
+
+    std::vector<uint32_t> indices = source;
+    OptimizeVertexCache(indices.data(), CountU32(indices), mesh.GetCountPositions());
+    OptimizeOverdraw(indices.data(), CountU32(indices), &mesh.GetDataPositions()->x, sizeof(float3), mesh.GetCountPositions(), 1.05f);
+
+    // Clusters give up some cache reuse but not all of it
+    EXPECT_EQ(GetTriangleSet(indices), GetTriangleSet(source));
+    EXPECT_LT(AnalyzeVertexCache(indices.data(), CountU32(indices), mesh.GetCountPositions()).acmr, sourceAcmr);
+}
+
+TEST(MeshOptimizerTest, VertexFetchRemap)
+{
+    std::vector<uint32_t> indices = {3, 1, 4, 4, 1, 0};
+    std::vector<uint32_t> remap;
+
+    // Vertex 2 isn't referenced and goes last
+    EXPECT_EQ(OptimizeVertexFetchRemap(indices.data(), CountU32(indices), 5, &remap), 4u);
+    EXPECT_EQ(indices, (std::vector<uint32_t>{0, 1, 2, 2, 1, 3}));
+    EXPECT_EQ(remap, (std::vector<uint32_t>{3, 1, 4, 0, 2}));
+
+    std::vector<uint32_t> vertices = {10, 11, 12, 13, 14};
+    RemapVertexData(vertices.data(), sizeof(uint32_t), CountU32(vertices), remap);
+    EXPECT_EQ(vertices, (std::vector<uint32_t>{13, 11, 14, 10, 12}));
+}
+
+TEST(MeshOptimizerTest, TriangleStripsKeepTrianglesAndWinding)
+{
+    TriMesh               mesh    = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 8, 8, TriMeshOptions().Indices().OptimizeVertexCache());
+    std::vector<uint32_t> indices = GetIndices(mesh);
+
+    std::vector<uint32_t> strips;
+    EXPECT_EQ(GenerateTriangleStrips(indices.data(), CountU32(indices), mesh.GetCountPositions(), UINT32_MAX, &strips), CountU32(strips));
+    EXPECT_LT(strips.size(), indices.size());
+    EXPECT_EQ(GetTriangleSet(ExpandTriangleStrips(strips, UINT32_MAX)), GetTriangleSet(indices));
+}
+
+TEST(MeshOptimizerTest, TriangleStripsOfUnconnectedTriangles)
+{
+    const std::vector<uint32_t> indices = {0, 1, 2, 3, 4, 5};
+
+    std::vector<uint32_t> strips;
+    EXPECT_EQ(GenerateTriangleStrips(indices.data(), CountU32(indices), 6, 0xFFFF, &strips), 7u);
+    EXPECT_EQ(strips, (std::vector<uint32_t>{0, 1, 2, 0xFFFF, 3, 4, 5}));
+}
+
+TEST(MeshOptimizerTest, TriMeshOptimizeKeepsCorners)
+{
+    TriMesh source = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 8, 8, TriMeshOptions().Indices().TexCoords());
+    TriMesh mesh   = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 8, 8, TriMeshOptions().Indices().TexCoords().OptimizeOverdraw().OptimizeVertexFetch());
+    ASSERT_EQ(mesh.GetCountTriangles(), source.GetCountTriangles());
+    ASSERT_EQ(mesh.GetCountPositions(), source.GetCountPositions());
+
+    // Same triangles, compared by the positions of their corners
+    auto getCorners = [](const TriMesh& m) {
+        std::multiset<std::array<float, 9>> corners;
+        for (uint32_t t = 0; t < m.GetCountTriangles(); ++t) {
+            uint32_t v[3] = {};
+            EXPECT_EQ(m.GetTriangle(t, v[0], v[1], v[2]), ppx::SUCCESS);
+            std::array<float, 9> corner = {};
+            for (uint32_t i = 0; i < 3; ++i) {
+                const float3& p   = *m.GetDataPositions(v[i]);
+                corner[3 * i + 0] = p.x;
+                corner[3 * i + 1] = p.y;
+                corner[3 * i + 2] = p.z;
+            }
+            corners.insert(corner);
+        }
+        return corners;
+    };
+    EXPECT_EQ(getCorners(mesh), getCorners(source));
+
+    // Vertex fetch order: vertices are first used in order
+    std::vector<uint32_t> indices = GetIndices(mesh);
+    uint32_t              next    = 0;
+    for (uint32_t index : indices) {
+        EXPECT_LE(index, next);
+        next = std::max(next, index + 1);
+    }
+}
+
+TEST(MeshOptimizerTest, WeldVertices)
+{
+    TriMesh mesh(grfx::INDEX_TYPE_UINT32);
+    for (uint32_t i = 0; i < 2; ++i) {
+        mesh.AppendPosition(float3(0, 0, 0));
+        mesh.AppendPosition(float3(1, 0, 0));
+        mesh.AppendPosition(float3(0, 1, 0));
+    }
+    mesh.AppendTriangle(0, 1, 2);
+    mesh.AppendTriangle(3, 5, 4);
+
+    EXPECT_EQ(mesh.WeldVertices(), 3u);
+    EXPECT_EQ(mesh.GetCountPositions(), 3u);
+    EXPECT_EQ(GetIndices(mesh), (std::vector<uint32_t>{0, 1, 2, 0, 2, 1}));
+}
+
+TEST(MeshOptimizerTest, SimplifyKeepsBorders)
+{
+    TriMesh                     mesh    = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 8, 8, TriMeshOptions().Indices());
+    const std::vector<uint32_t> indices = GetIndices(mesh);
+
+    // A flat plane simplifies without error, but only down to its border
+    std::vector<uint32_t> result;
+    const float           error = SimplifyMesh(indices.data(), CountU32(indices), &mesh.GetDataPositions()->x, sizeof(float3), mesh.GetCountPositions(), 0, 0.01f, &result);
+    EXPECT_LT(error, 1e-4f);
+    EXPECT_LE(result.size(), indices.size() / 4);
+
+    const std::set<uint32_t> remaining(result.begin(), result.end());
+    for (uint32_t v = 0; v < mesh.GetCountPositions(); ++v) {
+        const float3& p        = *mesh.GetDataPositions(v);
+        const bool    onBorder = (std::abs(p.x) > 0.49f) || (std::abs(p.z) > 0.49f);
+        if (onBorder) {
+            EXPECT_EQ(remaining.count(v), 1u);
+        }
+    }
+}
+
+TEST(MeshOptimizerTest, GenerateLods)
+{
+    std::vector<float3>   positions;
+    std::vector<uint32_t> indices     = CreateTorus(64, 32, &positions);
+    const uint32_t        indexCount  = CountU32(indices);
+    const uint32_t        vertexCount = CountU32(positions);
+
+    MeshLodOptions options = {};
+    options.lodCount       = 4;
+    options.reduction      = 0.5f;
+    options.maxError       = 0.05f;
+
+    std::vector<MeshLod> lods;
+    GenerateMeshLods(options, &indices, &positions[0].x, sizeof(float3), vertexCount, &lods);
+    ASSERT_EQ(lods.size(), 4u);
+    EXPECT_LE(indices.size(), GetMeshLodIndexCapacity(options, indexCount));
+
+    EXPECT_EQ(lods[0].firstIndex, 0u);
+    EXPECT_EQ(lods[0].indexCount, indexCount);
+    EXPECT_EQ(lods[0].error, 0.0f);
+    for (uint32_t i = 1; i < CountU32(lods); ++i) {
+        // Each LOD follows the previous one, has at most its share of the
+        // triangles and is at least as far from the full detail surface
+        EXPECT_EQ(lods[i].firstIndex, lods[i - 1].firstIndex + lods[i - 1].indexCount);
+        EXPECT_LE(lods[i].indexCount, indexCount >> i);
+        EXPECT_GT(lods[i].indexCount, 0u);
+        EXPECT_EQ(lods[i].indexCount % 3, 0u);
+        EXPECT_GE(lods[i].error, lods[i - 1].error);
+    }
+    for (uint32_t index : indices) {
+        EXPECT_LT(index, vertexCount);
+    }
+}
+
+TEST(MeshOptimizerTest, GenerateNormalsAndTangents)
+{
+    // Enough vertices to be processed on several threads
+    const TriMesh               mesh        = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(1, 1), 256, 256, TriMeshOptions().Indices().TexCoords());
+    const std::vector<uint32_t> indices     = GetIndices(mesh);
+    const uint32_t              vertexCount = mesh.GetCountPositions();
+    const uint32_t              stride3     = static_cast<uint32_t>(sizeof(float3));
+
+    std::vector<float3> normals(vertexCount);
+    GenerateMeshNormals(indices.data(), CountU32(indices), &mesh.GetDataPositions()->x, stride3, vertexCount, &normals[0].x, stride3);
+
+    // u runs along +x and v along +z, so the bitangent is +z
+    std::vector<float2> texCoords(mesh.GetDataTexCoords2(), mesh.GetDataTexCoords2() + vertexCount);
+    std::vector<float4> tangents(vertexCount);
+    GenerateMeshTangents(
+        indices.data(),
+        CountU32(indices),
+        &mesh.GetDataPositions()->x,
+        stride3,
+        &normals[0].x,
+        stride3,
+        &texCoords[0].x,
+        static_cast<uint32_t>(sizeof(float2)),
+        vertexCount,
+        &tangents[0].x,
+        static_cast<uint32_t>(sizeof(float4)));
+
+    float maxError = 0;
+    for (uint32_t v = 0; v < vertexCount; ++v) {
+        maxError = std::max(maxError, glm::length(normals[v] - float3(0, 1, 0)));
+        maxError = std::max(maxError, glm::length(tangents[v] - float4(1, 0, 0, -1)));
+    }
+    EXPECT_LT(maxError, 1e-5f);
+    EXPECT_FLOAT_EQ(glm::cross(normals[0], float3(tangents[0])).z * tangents[0].w, 1.0f);
+
+    // Mirroring u flips the tangent and the sign, not the bitangent
+    for (float2& texCoord : texCoords) {
+        texCoord.x = -texCoord.x;
+    }
+    GenerateMeshTangents(
+        indices.data(),
+        CountU32(indices),
+        &mesh.GetDataPositions()->x,
+        stride3,
+        &normals[0].x,
+        stride3,
+        &texCoords[0].x,
+        static_cast<uint32_t>(sizeof(float2)),
+        vertexCount,
+        &tangents[0].x,
+        static_cast<uint32_t>(sizeof(float4)));
+    EXPECT_LT(glm::length(tangents[vertexCount / 2] - float4(-1, 0, 0, 1)), 1e-5f);
+}
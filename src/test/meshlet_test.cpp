@@ -0,0 +1,94 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/meshlet.h"
+
+using namespace ppx;
+
+namespace {
+
+// Checks the meshlet limits and that unpacking the meshlets gives back the
+// triangles of the source mesh, in order.
+void ExpectMeshletsMatch(const TriMesh& mesh, const MeshletMesh& meshlets)
+{
+    const bool     indexed  = (mesh.GetIndexType() != grfx::INDEX_TYPE_UNDEFINED);
+    uint32_t       triIndex = 0;
+    const uint32_t count    = meshlets.GetCountMeshlets();
+    for (uint32_t m = 0; m < count; ++m) {
+        const Meshlet& meshlet = meshlets.GetMeshlets()[m];
+        EXPECT_GT(meshlet.vertexCount, 0u);
+        EXPECT_LE(meshlet.vertexCount, meshlets.GetMaxVertices());
+        EXPECT_GT(meshlet.triangleCount, 0u);
+        EXPECT_LE(meshlet.triangleCount, meshlets.GetMaxTriangles());
+        EXPECT_EQ(meshlet.triangleOffset, triIndex);
+
+        for (uint32_t t = 0; t < meshlet.triangleCount; ++t, ++triIndex) {
+            uint32_t expected[3] = {3 * triIndex + 0, 3 * triIndex + 1, 3 * triIndex + 2};
+            if (indexed) {
+                ASSERT_EQ(mesh.GetTriangle(triIndex, expected[0], expected[1], expected[2]), ppx::SUCCESS);
+            }
+
+            const uint32_t packed = meshlets.GetTriangles()[meshlet.triangleOffset + t];
+            for (uint32_t i = 0; i < 3; ++i) {
+                const uint32_t local = (packed >> (8 * i)) & 0xFF;
+                ASSERT_LT(local, meshlet.vertexCount);
+                EXPECT_EQ(meshlets.GetVertexIndices()[meshlet.vertexOffset + local], expected[i]);
+            }
+        }
+    }
+    EXPECT_EQ(triIndex, mesh.GetCountTriangles());
+}
+
+} // namespace
+
+TEST(MeshletTest, IndexedPlane)
+{
+    TriMesh mesh = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Z, float2(1, 1), 16, 16, TriMeshOptions().Indices());
+    ASSERT_EQ(mesh.GetCountTriangles(), 512u);
+
+    MeshletMesh meshlets;
+    ASSERT_EQ(MeshletMesh::Create(mesh, &meshlets), ppx::SUCCESS);
+    EXPECT_EQ(meshlets.GetMaxVertices(), 64u);
+    EXPECT_EQ(meshlets.GetMaxTriangles(), 124u);
+    EXPECT_EQ(meshlets.GetCountTriangles(), 512u);
+    ExpectMeshletsMatch(mesh, meshlets);
+
+    // Shared vertices are only referenced once per meshlet
+    EXPECT_LT(meshlets.GetCountVertexIndices(), 3 * meshlets.GetCountTriangles());
+}
+
+TEST(MeshletTest, NonIndexedCube)
+{
+    TriMesh mesh = TriMesh::CreateCube(float3(1, 1, 1));
+    ASSERT_EQ(mesh.GetIndexType(), grfx::INDEX_TYPE_UNDEFINED);
+
+    MeshletMesh meshlets;
+    ASSERT_EQ(MeshletMesh::Create(mesh, 9, 4, &meshlets), ppx::SUCCESS);
+    // 12 triangles without shared vertices: 3 per meshlet by vertex count
+    EXPECT_EQ(meshlets.GetCountMeshlets(), 4u);
+    EXPECT_EQ(meshlets.GetCountVertexIndices(), 36u);
+    ExpectMeshletsMatch(mesh, meshlets);
+}
+
+TEST(MeshletTest, TriangleLimit)
+{
+    TriMesh mesh = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Z, float2(1, 1), 4, 4, TriMeshOptions().Indices());
+
+    MeshletMesh meshlets;
+    ASSERT_EQ(MeshletMesh::Create(mesh, PPX_MESHLET_MAX_VERTICES, 8, &meshlets), ppx::SUCCESS);
+    EXPECT_EQ(meshlets.GetCountMeshlets(), 4u);
+    ExpectMeshletsMatch(mesh, meshlets);
+}
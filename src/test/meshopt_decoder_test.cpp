@@ -0,0 +1,116 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/meshopt_decoder.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace ppx;
+
+namespace {
+
+// 16 byte auxiliary code table meshoptimizer writes after the triangles
+const std::vector<uint8_t> kCodeAuxTable = {0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xA9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00};
+
+std::vector<uint8_t> IndexStream(std::vector<uint8_t> triangles)
+{
+    triangles.insert(triangles.end(), kCodeAuxTable.begin(), kCodeAuxTable.end());
+    return triangles;
+}
+
+} // namespace
+
+TEST(MeshoptDecoderTest, VertexBuffer)
+{
+    // Two vertices of 4 bytes: (10, 20, 30, 40) and (11, 18, 30, 40)
+    std::vector<uint8_t> src = {
+        0xA0,
+        // Byte 0: 2-bit deltas 0, +1
+        0x01, 0x20, 0x00, 0x00, 0x00,
+        // Byte 1: 2-bit deltas 0, escape followed by -2
+        0x01, 0x30, 0x00, 0x00, 0x00, 0x03,
+        // Bytes 2 and 3: no change
+        0x00, 0x00};
+    // Tail with the first vertex as the delta base
+    src.resize(src.size() + 28, 0);
+    src.insert(src.end(), {10, 20, 30, 40});
+
+    uint8_t dst[8] = {};
+    ASSERT_EQ(DecodeMeshoptVertexBuffer(dst, 2, 4, src.data(), src.size()), ppx::SUCCESS);
+    EXPECT_EQ(std::vector<uint8_t>(dst, dst + 8), (std::vector<uint8_t>{10, 20, 30, 40, 11, 18, 30, 40}));
+
+    // Truncated streams, bad strides and unknown versions are rejected
+    EXPECT_EQ(DecodeMeshoptVertexBuffer(dst, 2, 4, src.data(), 20), ppx::ERROR_BAD_DATA_SOURCE);
+    EXPECT_EQ(DecodeMeshoptVertexBuffer(dst, 2, 6, src.data(), src.size()), ppx::ERROR_BAD_DATA_SOURCE);
+    src[0] = 0xA1;
+    EXPECT_EQ(DecodeMeshoptVertexBuffer(dst, 2, 4, src.data(), src.size()), ppx::ERROR_BAD_DATA_SOURCE);
+}
+
+TEST(MeshoptDecoderTest, IndexBuffer)
+{
+    // Three new vertices, then the edge (2, 1) and a new vertex
+    std::vector<uint8_t> src = IndexStream({0xE1, 0xF0, 0x10});
+
+    uint16_t dst[6] = {};
+    ASSERT_EQ(DecodeMeshoptIndexBuffer(dst, 6, 2, src.data(), src.size()), ppx::SUCCESS);
+    EXPECT_EQ(std::vector<uint16_t>(dst, dst + 6), (std::vector<uint16_t>{0, 1, 2, 2, 1, 3}));
+
+    // Three free indices as zigzag deltas: +5, +2, -1
+    src = IndexStream({0xE1, 0xFF, 0xFF, 10, 4, 1});
+
+    uint32_t dst32[3] = {};
+    ASSERT_EQ(DecodeMeshoptIndexBuffer(dst32, 3, 4, src.data(), src.size()), ppx::SUCCESS);
+    EXPECT_EQ(std::vector<uint32_t>(dst32, dst32 + 3), (std::vector<uint32_t>{5, 7, 6}));
+
+    src = IndexStream({0xE1, 0xFF, 0xFF, 10, 4});
+    EXPECT_EQ(DecodeMeshoptIndexBuffer(dst32, 3, 4, src.data(), src.size()), ppx::ERROR_BAD_DATA_SOURCE);
+}
+
+TEST(MeshoptDecoderTest, IndexSequence)
+{
+    // Deltas +5, -2, +1 from the first baseline
+    const std::vector<uint8_t> src = {0xD1, 20, 6, 4, 0, 0, 0, 0};
+
+    uint32_t dst[3] = {};
+    ASSERT_EQ(DecodeMeshoptIndexSequence(dst, 3, 4, src.data(), src.size()), ppx::SUCCESS);
+    EXPECT_EQ(std::vector<uint32_t>(dst, dst + 3), (std::vector<uint32_t>{5, 3, 4}));
+    EXPECT_EQ(DecodeMeshoptIndexSequence(dst, 4, 4, src.data(), src.size()), ppx::ERROR_BAD_DATA_SOURCE);
+}
+
+TEST(MeshoptDecoderTest, Filters)
+{
+    int8_t normal[4] = {127, 0, 127, 0};
+    ASSERT_EQ(ApplyMeshoptFilter(MESHOPT_FILTER_OCTAHEDRAL, normal, 1, 4), ppx::SUCCESS);
+    EXPECT_EQ(normal[0], 127);
+    EXPECT_EQ(normal[1], 0);
+    EXPECT_EQ(normal[2], 0);
+
+    // Identity with w dropped
+    int16_t rotation[4] = {0, 0, 0, 32767};
+    ASSERT_EQ(ApplyMeshoptFilter(MESHOPT_FILTER_QUATERNION, rotation, 1, 8), ppx::SUCCESS);
+    EXPECT_EQ(rotation[3], 32767);
+    EXPECT_EQ(rotation[0], 0);
+
+    // 3 * 2^-1
+    uint32_t value = 0xFF000003;
+    ASSERT_EQ(ApplyMeshoptFilter(MESHOPT_FILTER_EXPONENTIAL, &value, 1, 4), ppx::SUCCESS);
+    float decoded = 0;
+    memcpy(&decoded, &value, sizeof(decoded));
+    EXPECT_FLOAT_EQ(decoded, 1.5f);
+
+    EXPECT_EQ(ApplyMeshoptFilter(MESHOPT_FILTER_QUATERNION, rotation, 1, 4), ppx::ERROR_BAD_DATA_SOURCE);
+}
@@ -0,0 +1,123 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/metrics_stream.h"
+
+#if defined(PPX_LINUX) || defined(PPX_ANDROID)
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+
+namespace ppx {
+namespace {
+
+// Reads exactly size bytes, false on timeout or disconnect
+bool ReadBytes(int socket, void* pData, size_t size)
+{
+    uint8_t* pBytes = static_cast<uint8_t*>(pData);
+    while (size > 0) {
+        pollfd pollFd = {socket, POLLIN, 0};
+        if (poll(&pollFd, 1, 5000) <= 0) {
+            return false;
+        }
+        ssize_t received = recv(socket, pBytes, size, 0);
+        if (received <= 0) {
+            return false;
+        }
+        pBytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool WaitForClients(const metrics::StreamServer& server, uint32_t count)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server.GetClientCount() != count) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+TEST(MetricsStreamTest, StreamsInfoAndData)
+{
+    metrics::StreamServer server;
+    ASSERT_EQ(server.Start(0), ppx::SUCCESS);
+    EXPECT_NE(server.GetPort(), 0);
+
+    metrics::Manager manager;
+    manager.SetStreamServer(&server);
+    manager.StartRun("run");
+
+    metrics::MetricMetadata metadata = {};
+    metadata.type                    = metrics::MetricType::GAUGE;
+    metadata.name                    = "frame_time";
+    metrics::MetricID id             = manager.AddMetric(metadata);
+
+    // Dropped, no client yet
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    data.gauge.seconds       = 1.0;
+    data.gauge.value         = 16.0;
+    EXPECT_TRUE(manager.RecordMetricData(id, data));
+
+    int         client  = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family  = AF_INET;
+    address.sin_port    = htons(server.GetPort());
+    inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+    ASSERT_EQ(connect(client, reinterpret_cast<sockaddr*>(&address), sizeof(address)), 0);
+    ASSERT_TRUE(WaitForClients(server, 1));
+
+    data.gauge.seconds = 2.0;
+    data.gauge.value   = 17.0;
+    EXPECT_TRUE(manager.RecordMetricData(id, data));
+
+    metrics::StreamInfoRecord info = {};
+    ASSERT_TRUE(ReadBytes(client, &info, sizeof(info)));
+    EXPECT_EQ(info.recordType, metrics::STREAM_RECORD_TYPE_INFO);
+    EXPECT_EQ(info.id, id);
+    EXPECT_EQ(info.metricType, static_cast<uint32_t>(metrics::MetricType::GAUGE));
+    std::string name(info.nameLength, '\0');
+    ASSERT_TRUE(ReadBytes(client, name.data(), name.size()));
+    EXPECT_EQ(name, "frame_time");
+
+    metrics::StreamDataRecord record = {};
+    ASSERT_TRUE(ReadBytes(client, &record, sizeof(record)));
+    EXPECT_EQ(record.recordType, metrics::STREAM_RECORD_TYPE_DATA);
+    EXPECT_EQ(record.id, id);
+    EXPECT_EQ(record.seconds, 2.0);
+    EXPECT_EQ(record.value, 17.0);
+
+    close(client);
+    EXPECT_TRUE(WaitForClients(server, 0));
+
+    manager.EndRun();
+    manager.SetStreamServer(nullptr);
+    server.Stop();
+    EXPECT_FALSE(server.IsRunning());
+}
+
+} // namespace
+} // namespace ppx
+#endif
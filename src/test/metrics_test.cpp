@@ -18,9 +18,13 @@
 
 #include "nlohmann/json.hpp"
 
+#include <cmath>
+#include <cstring>
 #include <memory>
 #include <limits>
 #include <regex>
+#include <sstream>
+#include <thread>
 
 #if !defined(NDEBUG)
 #define PERFORM_DEATH_TESTS
@@ -290,6 +294,82 @@ TEST_F(MetricsTestFixture, ReportEmptyGauge)
     EXPECT_EQ(stats["percentile_99"], 0);
 }
 
+TEST_F(MetricsTestFixture, ReportBinaryTimeSeries)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type = metrics::MetricType::GAUGE;
+    metadata.name = "gauge1";
+    auto metricId = pManager->AddMetric(metadata);
+    ASSERT_NE(metricId, metrics::kInvalidMetricID);
+
+    const double             seconds[] = {0.5, 0.516667, 0.533333, 2.0};
+    const std::vector<float> values    = {1.0f, -2.5f, 3.25f, 4.0f};
+    for (size_t i = 0; i < values.size(); ++i) {
+        metrics::MetricData data = {metrics::MetricType::GAUGE};
+        data.gauge.seconds       = seconds[i];
+        data.gauge.value         = values[i];
+        EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+    }
+
+    auto report = pManager->CreateReport("report", metrics::ReportFormat::BINARY);
+    EXPECT_EQ(report.GetFormat(), metrics::ReportFormat::BINARY);
+    std::ostringstream stream;
+    report.WriteBinary(stream);
+    const std::string binary = stream.str();
+
+    size_t offset = 0;
+    auto   read   = [&](auto* pValue) {
+        ASSERT_LE(offset + sizeof(*pValue), binary.size());
+        std::memcpy(pValue, binary.data() + offset, sizeof(*pValue));
+        offset += sizeof(*pValue);
+    };
+    ASSERT_EQ(binary.substr(0, 4), "PPXM");
+    offset           = 4;
+    uint32_t version = 0;
+    uint32_t size    = 0;
+    read(&version);
+    read(&size);
+    EXPECT_EQ(version, 1);
+
+    nlohmann::json parsed = nlohmann::json::parse(binary.substr(offset, size));
+    offset += size;
+    auto gauge = parsed["runs"][0]["gauges"][0];
+    EXPECT_FALSE(gauge.contains("time_series"));
+    EXPECT_EQ(gauge["time_series_index"], 0);
+
+    uint32_t seriesCount = 0;
+    uint64_t entryCount  = 0;
+    uint64_t encodedSize = 0;
+    read(&seriesCount);
+    read(&entryCount);
+    read(&encodedSize);
+    ASSERT_EQ(seriesCount, 1);
+    ASSERT_EQ(entryCount, values.size());
+
+    int64_t micros = 0;
+    size_t  end    = offset + encodedSize;
+    for (size_t i = 0; i < entryCount; ++i) {
+        uint64_t encoded = 0;
+        for (uint32_t shift = 0; offset < end; shift += 7) {
+            uint8_t byte = static_cast<uint8_t>(binary[offset++]);
+            encoded |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                break;
+            }
+        }
+        micros += static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1);
+        EXPECT_EQ(micros, std::llround(seconds[i] * 1000000.0));
+    }
+    EXPECT_EQ(offset, end);
+
+    for (size_t i = 0; i < entryCount; ++i) {
+        float value = 0.0f;
+        read(&value);
+        EXPECT_EQ(value, values[i]);
+    }
+    EXPECT_EQ(offset, binary.size());
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Metrics Tests
 ////////////////////////////////////////////////////////////////////////////////
@@ -522,4 +602,402 @@ TEST_F(MetricsTestFixture, MetricsGaugeIgnoresSameSeconds)
     EXPECT_EQ(gauge["time_series"][1][1], 11.0);
 }
 
+TEST_F(MetricsTestFixture, MetricsSketchGaugeIsBounded)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type          = metrics::MetricType::GAUGE;
+    metadata.name          = "gauge";
+    metadata.gaugeMode     = metrics::GaugeMode::SKETCH;
+    metadata.reservoirSize = 16;
+    auto metricId          = pManager->AddMetric(metadata);
+    ASSERT_NE(metricId, metrics::kInvalidMetricID);
+
+    // Values 1 to 10000 in a scrambled order
+    metrics::MetricData data = {metrics::MetricType::GAUGE};
+    for (uint32_t i = 0; i < 10000; ++i) {
+        data.gauge.seconds = i * 0.01;
+        data.gauge.value   = static_cast<double>((i * 7919) % 10000 + 1);
+        EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+    }
+
+    auto           result = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed = nlohmann::json::parse(result);
+    auto           gauge  = parsed["runs"][0]["gauges"][0];
+    EXPECT_EQ(gauge["mode"], "sketch");
+    EXPECT_EQ(gauge["sketch"]["entry_count"], 10000);
+    EXPECT_EQ(gauge["time_series"].size(), 16);
+    for (size_t i = 1; i < gauge["time_series"].size(); ++i) {
+        EXPECT_LT(gauge["time_series"][i - 1][0].get<double>(), gauge["time_series"][i][0].get<double>());
+    }
+
+    // Within the default 1% relative accuracy
+    auto stats = gauge["statistics"];
+    EXPECT_EQ(stats["min"], 1.0);
+    EXPECT_EQ(stats["max"], 10000.0);
+    EXPECT_NEAR(stats["median"].get<double>(), 5001.0, 5001.0 * 0.01);
+    EXPECT_NEAR(stats["percentile_01"].get<double>(), 101.0, 101.0 * 0.01);
+    EXPECT_NEAR(stats["percentile_99"].get<double>(), 9901.0, 9901.0 * 0.01);
+    EXPECT_NEAR(stats["standard_deviation"].get<double>(), 2886.75, 0.01);
+}
+
+TEST_F(MetricsTestFixture, MetricsManagerDefaultGaugeMode)
+{
+    pManager->SetDefaultGaugeMode(metrics::GaugeMode::SKETCH);
+
+    metrics::MetricMetadata metadata;
+    metadata.type = metrics::MetricType::GAUGE;
+    metadata.name = "sketch_gauge";
+    ASSERT_NE(pManager->AddMetric(metadata), metrics::kInvalidMetricID);
+
+    metadata.name      = "time_series_gauge";
+    metadata.gaugeMode = metrics::GaugeMode::TIME_SERIES;
+    ASSERT_NE(pManager->AddMetric(metadata), metrics::kInvalidMetricID);
+
+    auto           result = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed = nlohmann::json::parse(result);
+    for (const auto& gauge : parsed["runs"][0]["gauges"]) {
+        EXPECT_EQ(gauge["mode"], (gauge["metadata"]["name"] == "sketch_gauge") ? "sketch" : "time_series");
+    }
+}
+
+TEST_F(MetricsTestFixture, MetricsQueuedDataFromThreads)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type  = metrics::MetricType::GAUGE;
+    metadata.name  = "gauge";
+    auto gaugeId   = pManager->AddMetric(metadata);
+    metadata.type  = metrics::MetricType::COUNTER;
+    metadata.name  = "counter";
+    auto counterId = pManager->AddMetric(metadata);
+
+    // Each thread records every other second, in the opposite order they're drained
+    auto record = [&](uint32_t offset) {
+        for (uint32_t i = offset; i < 200; i += 2) {
+            metrics::MetricData data = {metrics::MetricType::GAUGE};
+            data.gauge.seconds       = static_cast<double>(i);
+            data.gauge.value         = static_cast<double>(i);
+            EXPECT_TRUE(pManager->QueueMetricData(gaugeId, data));
+
+            data.type              = metrics::MetricType::COUNTER;
+            data.counter.increment = 1;
+            EXPECT_TRUE(pManager->QueueMetricData(counterId, data));
+        }
+    };
+    std::thread first(record, 0);
+    std::thread second(record, 1);
+    first.join();
+    second.join();
+
+    pManager->DrainQueuedMetricData();
+
+    auto           result = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed = nlohmann::json::parse(result);
+    auto           gauge  = parsed["runs"][0]["gauges"][0];
+    ASSERT_EQ(gauge["time_series"].size(), 200);
+    EXPECT_EQ(gauge["time_series"][199][0], 199.0);
+    EXPECT_EQ(parsed["runs"][0]["counters"][0]["value"], 200);
+}
+
+TEST_F(MetricsTestFixture, MetricsQueuedDataRecordedAtEndRun)
+{
+    metrics::MetricMetadata metadata;
+    metadata.type = metrics::MetricType::COUNTER;
+    metadata.name = "counter";
+    auto metricId = pManager->AddMetric(metadata);
+
+    metrics::MetricData data = {metrics::MetricType::COUNTER};
+    data.counter.increment   = 3;
+    EXPECT_TRUE(pManager->QueueMetricData(metricId, data));
+    pManager->EndRun();
+
+    // Discarded, the run is complete
+    EXPECT_TRUE(pManager->QueueMetricData(metricId, data));
+    pManager->StartRun("second_run");
+    pManager->DrainQueuedMetricData();
+
+    auto           result = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed = nlohmann::json::parse(result);
+    for (const auto& run : parsed["runs"]) {
+        auto expectedCount = (run["name"] == "default_run") ? 1 : 0;
+        ASSERT_EQ(run["counters"].size(), expectedCount);
+        if (expectedCount > 0) {
+            EXPECT_EQ(run["counters"][0]["value"], 3);
+        }
+    }
+}
+
+TEST(MetricsTest, MetricQueueDropsWhenFull)
+{
+    metrics::MetricQueue queue(3);
+    EXPECT_EQ(queue.GetCapacity(), 4);
+
+    metrics::MetricData data = {metrics::MetricType::COUNTER};
+    for (uint32_t i = 0; i < 6; ++i) {
+        data.counter.increment = i;
+        EXPECT_EQ(queue.Push(i + 1, data), i < 4);
+    }
+    EXPECT_EQ(queue.TakeDroppedCount(), 2);
+    EXPECT_EQ(queue.TakeDroppedCount(), 0);
+
+    metrics::MetricID id = metrics::kInvalidMetricID;
+    for (uint32_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.Pop(&id, &data));
+        EXPECT_EQ(id, i + 1);
+        EXPECT_EQ(data.counter.increment, i);
+    }
+    EXPECT_FALSE(queue.Pop(&id, &data));
+}
+
+TEST_F(MetricsTestFixture, ReportBenchmarkRepetitions)
+{
+    pManager->EndRun();
+    for (uint32_t i = 0; i < 5; ++i) {
+        pManager->StartRun("repetition" + std::to_string(i));
+        pManager->AddBenchmarkRepetition();
+
+        metrics::MetricMetadata metadata;
+        metadata.type = metrics::MetricType::GAUGE;
+        metadata.name = "frame_time";
+        auto metricId = pManager->AddMetric(metadata);
+        for (uint32_t j = 0; j < 3; ++j) {
+            metrics::MetricData data = {metrics::MetricType::GAUGE};
+            data.gauge.seconds       = j + 1.0;
+            data.gauge.value         = (i == 4) ? 100.0 : (10.0 + i + j);
+            EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+        }
+        pManager->EndRun();
+    }
+
+    auto           result    = pManager->CreateReport("report").GetContentString();
+    nlohmann::json parsed    = nlohmann::json::parse(result);
+    auto           benchmark = parsed["benchmark"];
+    ASSERT_EQ(benchmark["repetitions"].size(), 5);
+    ASSERT_EQ(benchmark["gauges"].size(), 1);
+    auto gauge = benchmark["gauges"][0];
+    EXPECT_EQ(gauge["metadata"]["name"], "frame_time");
+    EXPECT_EQ(gauge["values"], nlohmann::json::array({11.0, 12.0, 13.0, 14.0, 100.0}));
+    EXPECT_EQ(gauge["outliers"], nlohmann::json::array({4}));
+    EXPECT_DOUBLE_EQ(gauge["mean"].get<double>(), 12.5);
+    EXPECT_LE(gauge["ci_lower"].get<double>(), 12.5);
+    EXPECT_GE(gauge["ci_upper"].get<double>(), 12.5);
+}
+
+TEST_F(MetricsTestFixture, ReportSweepPoints)
+{
+    pManager->EndRun();
+    for (const std::string point : {"vs=0", "vs=1"}) {
+        pManager->SetBenchmarkParameters(point, {{"vs", point.back() - '0'}});
+        for (uint32_t i = 0; i < 2; ++i) {
+            pManager->StartRun(point + " / " + std::to_string(i));
+            pManager->AddBenchmarkRepetition(point);
+
+            metrics::MetricMetadata metadata;
+            metadata.type            = metrics::MetricType::GAUGE;
+            metadata.name            = "frame_time";
+            auto                metricId = pManager->AddMetric(metadata);
+            metrics::MetricData data     = {metrics::MetricType::GAUGE};
+            data.gauge.seconds           = 1.0;
+            data.gauge.value             = (point == "vs=0") ? 10.0 : 20.0;
+            EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+            pManager->EndRun();
+        }
+    }
+
+    nlohmann::json parsed = nlohmann::json::parse(pManager->CreateReport("report").GetContentString());
+    EXPECT_FALSE(parsed.contains("benchmark"));
+    ASSERT_EQ(parsed["sweep"].size(), 2);
+    EXPECT_EQ(parsed["sweep"][0]["name"], "vs=0");
+    EXPECT_EQ(parsed["sweep"][0]["parameters"]["vs"], 0);
+    EXPECT_EQ(parsed["sweep"][0]["repetitions"].size(), 2);
+    EXPECT_EQ(parsed["sweep"][0]["gauges"][0]["mean"], 10.0);
+    EXPECT_EQ(parsed["sweep"][1]["name"], "vs=1");
+    EXPECT_EQ(parsed["sweep"][1]["gauges"][0]["mean"], 20.0);
+}
+
+TEST_F(MetricsTestFixture, ReportResultsStoreEntry)
+{
+    nlohmann::json parsed = nlohmann::json::parse(pManager->CreateReport("report").GetContentString());
+    EXPECT_FALSE(parsed.contains("device"));
+
+    metrics::DeviceFingerprint device;
+    device.gpu    = "GPU";
+    device.driver = "1.2.3";
+    device.api    = "Vulkan";
+    device.width  = 1920;
+    device.height = 1080;
+    pManager->SetDeviceFingerprint(device);
+
+    pManager->EndRun();
+    pManager->StartRun("repetition");
+    pManager->AddBenchmarkRepetition();
+    metrics::MetricMetadata metadata;
+    metadata.type                = metrics::MetricType::GAUGE;
+    metadata.name                = "frame_time";
+    auto                metricId = pManager->AddMetric(metadata);
+    metrics::MetricData data     = {metrics::MetricType::GAUGE};
+    data.gauge.seconds           = 1.0;
+    data.gauge.value             = 10.0;
+    EXPECT_TRUE(pManager->RecordMetricData(metricId, data));
+    pManager->EndRun();
+
+    auto report = pManager->CreateReport("report");
+    parsed      = nlohmann::json::parse(report.GetContentString());
+    EXPECT_EQ(parsed["device"]["gpu"], "GPU");
+    EXPECT_EQ(parsed["device"]["width"], 1920);
+    EXPECT_EQ(parsed["device"]["key"], "GPU / 1.2.3 / Vulkan / 1920x1080");
+
+    // A single line without the runs
+    const std::string line = report.GetResultsStoreEntry();
+    EXPECT_EQ(line.find('\n'), std::string::npos);
+    nlohmann::json entry = nlohmann::json::parse(line);
+    EXPECT_EQ(entry["device_key"], "GPU / 1.2.3 / Vulkan / 1920x1080");
+    EXPECT_EQ(entry["generated_at"], parsed["generated_at"]);
+    EXPECT_EQ(entry["benchmark"]["gauges"][0]["mean"], 10.0);
+    EXPECT_FALSE(entry.contains("runs"));
+}
+
+TEST(MetricsTest, ExpandSweepCombinesPointsAndCartesian)
+{
+    nlohmann::json sweep = nlohmann::json::parse(R"({
+        "points": [{"vs": 0}, {"vs": 1, "ps": "a"}],
+        "cartesian": {"sphere-count": [10, 100], "LOD": [0, 1]},
+        "warmup_frames": 30
+    })");
+
+    std::vector<metrics::SweepPoint> points;
+    ASSERT_EQ(metrics::ExpandSweep(sweep, &points), SUCCESS);
+    ASSERT_EQ(points.size(), 8);
+    EXPECT_EQ(points[0].name, "LOD=0 sphere-count=10 vs=0");
+    EXPECT_EQ(points[1].name, "LOD=0 sphere-count=100 vs=0");
+    EXPECT_EQ(points[2].name, "LOD=1 sphere-count=10 vs=0");
+    EXPECT_EQ(points[7].name, "LOD=1 ps=a sphere-count=100 vs=1");
+    EXPECT_EQ(points[7].knobs["sphere-count"], 100);
+    EXPECT_FALSE(points[0].knobs.contains("warmup_frames"));
+}
+
+TEST(MetricsTest, ExpandSweepNamesRepeatedPoints)
+{
+    std::vector<metrics::SweepPoint> points;
+    ASSERT_EQ(metrics::ExpandSweep(nlohmann::json::parse(R"({"points": [{"vs": 0}, {"vs": 0}]})"), &points), SUCCESS);
+    ASSERT_EQ(points.size(), 2);
+    EXPECT_EQ(points[0].name, "vs=0");
+    EXPECT_EQ(points[1].name, "vs=0 (2)");
+
+    ASSERT_EQ(metrics::ExpandSweep(nlohmann::json::object(), &points), SUCCESS);
+    ASSERT_EQ(points.size(), 1);
+    EXPECT_EQ(points[0].name, "default");
+
+    EXPECT_NE(metrics::ExpandSweep(nlohmann::json::parse(R"({"cartesian": {"vs": 0}})"), &points), SUCCESS);
+    EXPECT_NE(metrics::ExpandSweep(nlohmann::json::parse(R"({"points": []})"), &points), SUCCESS);
+}
+
+TEST(MetricsTest, SummarizeRepetitionsConfidenceInterval)
+{
+    metrics::BenchmarkSettings settings;
+    std::vector<double>        values;
+    for (uint32_t i = 0; i < 20; ++i) {
+        values.push_back(10.0 + (i % 5) * 0.1);
+    }
+
+    auto summary = metrics::SummarizeRepetitions(values, settings);
+    EXPECT_TRUE(summary.outliers.empty());
+    EXPECT_DOUBLE_EQ(summary.mean, 10.2);
+    EXPECT_LT(summary.ciLower, summary.mean);
+    EXPECT_GT(summary.ciUpper, summary.mean);
+    EXPECT_GT(summary.ciLower, 10.1);
+    EXPECT_LT(summary.ciUpper, 10.3);
+
+    // Deterministic
+    auto again = metrics::SummarizeRepetitions(values, settings);
+    EXPECT_EQ(again.ciLower, summary.ciLower);
+    EXPECT_EQ(again.ciUpper, summary.ciUpper);
+
+    // Too few values to reject or resample
+    auto single = metrics::SummarizeRepetitions({5.0}, settings);
+    EXPECT_EQ(single.mean, 5.0);
+    EXPECT_EQ(single.ciLower, 5.0);
+    EXPECT_EQ(single.ciUpper, 5.0);
+}
+
+TEST(MetricsTest, FrameStutterTrackerStreaks)
+{
+    metrics::FrameStutterTracker tracker(10.0, 4);
+    const double                 frameTimes[] = {5.0, 12.0, 11.0, 10.0, 20.0, 30.0, 40.0, 5.0};
+    std::vector<uint32_t>        streaks;
+    for (double frameTime : frameTimes) {
+        auto result = tracker.AddFrame(frameTime);
+        EXPECT_EQ(result.overBudget, frameTime > 10.0);
+        if (result.endedStreakLength > 0) {
+            streaks.push_back(result.endedStreakLength);
+        }
+    }
+    EXPECT_EQ(streaks, std::vector<uint32_t>({2, 3}));
+    EXPECT_EQ(tracker.GetOverBudgetCount(), 5);
+    EXPECT_EQ(tracker.GetLongestStreak(), 3);
+    EXPECT_EQ(tracker.EndStreak(), 0);
+}
+
+TEST(MetricsTest, FrameStutterTrackerWindowVariance)
+{
+    metrics::FrameStutterTracker tracker(10.0, 4);
+    const double                 frameTimes[] = {2.0, 4.0, 4.0, 6.0, 8.0, 8.0, 8.0, 8.0};
+    std::vector<double>          variances;
+    for (double frameTime : frameTimes) {
+        auto result = tracker.AddFrame(frameTime);
+        if (result.windowComplete) {
+            variances.push_back(result.windowVariance);
+        }
+    }
+    ASSERT_EQ(variances.size(), 2);
+    EXPECT_DOUBLE_EQ(variances[0], 2.0);
+    EXPECT_DOUBLE_EQ(variances[1], 0.0);
+}
+
+TEST(MetricsTest, FrameStutterTrackerHistogram)
+{
+    EXPECT_EQ(metrics::FrameStutterTracker::GetHistogramBucket(0.5), 0);
+    EXPECT_EQ(metrics::FrameStutterTracker::GetHistogramBucket(1.0), 1);
+    EXPECT_EQ(metrics::FrameStutterTracker::GetHistogramBucket(16.0), 9);
+    EXPECT_EQ(metrics::FrameStutterTracker::GetHistogramBucket(1000.0), metrics::FrameStutterTracker::kHistogramBucketCount - 1);
+    for (uint32_t i = 0; i < metrics::FrameStutterTracker::kHistogramBucketCount; ++i) {
+        const double lowerBound = metrics::FrameStutterTracker::GetHistogramLowerBound(i);
+        EXPECT_EQ(metrics::FrameStutterTracker::GetHistogramBucket(lowerBound), i);
+        EXPECT_LT(lowerBound, metrics::FrameStutterTracker::GetHistogramUpperBound(i));
+    }
+
+    metrics::FrameStutterTracker tracker;
+    tracker.AddFrame(16.5);
+    tracker.AddFrame(17.0);
+    EXPECT_EQ(tracker.GetHistogramCount(9), 2);
+    EXPECT_EQ(tracker.GetFrameCount(), 2);
+}
+
+TEST(MetricsTest, QuantileSketchSignedValues)
+{
+    metrics::QuantileSketch sketch(0.01);
+    EXPECT_EQ(sketch.GetQuantile(0.5), 0.0);
+
+    for (int i = -50; i < 50; ++i) {
+        sketch.Add(static_cast<double>(i));
+    }
+    sketch.Add(std::numeric_limits<double>::quiet_NaN());
+
+    EXPECT_EQ(sketch.GetCount(), 100);
+    EXPECT_NEAR(sketch.GetQuantile(0.0), -50.0, 0.5);
+    EXPECT_EQ(sketch.GetQuantile(0.5), 0.0);
+    EXPECT_NEAR(sketch.GetQuantile(1.0), 49.0, 0.49);
+}
+
+TEST(MetricsTest, QuantileSketchMergesLowestBuckets)
+{
+    metrics::QuantileSketch sketch(0.01, 64);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        sketch.Add(std::pow(10.0, i / 100.0));
+    }
+
+    // The high quantiles keep their accuracy
+    EXPECT_EQ(sketch.GetBucketCount(), 64);
+    EXPECT_NEAR(sketch.GetQuantile(1.0), std::pow(10.0, 9.99), std::pow(10.0, 9.99) * 0.01);
+}
+
 } // namespace ppx
@@ -0,0 +1,108 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/mipmap.h"
+
+#include <cstring>
+
+using namespace ppx;
+
+TEST(MipmapTest, BoxFilterAverages)
+{
+    Bitmap bitmap = Bitmap::Create(4, 4, Bitmap::FORMAT_R_UINT8);
+    for (uint32_t i = 0; i < 16; ++i) {
+        bitmap.GetData()[i] = static_cast<char>(i * 10);
+    }
+
+    Mipmap mipmap(bitmap, 3);
+    ASSERT_TRUE(mipmap.IsOk());
+    ASSERT_EQ(mipmap.GetLevelCount(), 3u);
+    EXPECT_EQ(mipmap.GetMip(1)->GetPixel8u(0, 0)[0], 25);
+    EXPECT_EQ(mipmap.GetMip(1)->GetPixel8u(1, 0)[0], 45);
+    EXPECT_EQ(mipmap.GetMip(1)->GetPixel8u(0, 1)[0], 105);
+    EXPECT_EQ(mipmap.GetMip(1)->GetPixel8u(1, 1)[0], 125);
+    EXPECT_EQ(mipmap.GetMip(2)->GetPixel8u(0, 0)[0], 75);
+}
+
+TEST(MipmapTest, SrgbFiltersInLinear)
+{
+    // Checker of black and white, alpha follows the color
+    Bitmap bitmap = Bitmap::Create(2, 2, Bitmap::FORMAT_RGBA_UINT8);
+    for (uint32_t y = 0; y < 2; ++y) {
+        for (uint32_t x = 0; x < 2; ++x) {
+            memset(bitmap.GetPixel8u(x, y), (x == y) ? 255 : 0, 4);
+        }
+    }
+
+    MipmapGenerateInfo generateInfo = {};
+    generateInfo.srgb               = true;
+
+    Mipmap mipmap(bitmap, 2, /* useStaticPool= */ false, generateInfo);
+    ASSERT_TRUE(mipmap.IsOk());
+    const uint8_t* pPixel = mipmap.GetMip(1)->GetPixel8u(0, 0);
+    EXPECT_EQ(pPixel[0], 188);
+    EXPECT_EQ(pPixel[1], 188);
+    EXPECT_EQ(pPixel[2], 188);
+    EXPECT_EQ(pPixel[3], 128);
+}
+
+TEST(MipmapTest, KaiserKeepsConstantOddSizes)
+{
+    Bitmap bitmap = Bitmap::Create(7, 5, Bitmap::FORMAT_RG_UINT16);
+    bitmap.Fill<uint16_t>(1000, 60000, 0, 0);
+
+    MipmapGenerateInfo generateInfo = {};
+    generateInfo.filter             = MIPMAP_FILTER_KAISER;
+
+    Mipmap mipmap(bitmap, PPX_REMAINING_MIP_LEVELS, /* useStaticPool= */ false, generateInfo);
+    ASSERT_TRUE(mipmap.IsOk());
+    ASSERT_EQ(mipmap.GetLevelCount(), 3u);
+    for (uint32_t level = 1; level < mipmap.GetLevelCount(); ++level) {
+        const Bitmap* pMip = mipmap.GetMip(level);
+        for (uint32_t y = 0; y < pMip->GetHeight(); ++y) {
+            for (uint32_t x = 0; x < pMip->GetWidth(); ++x) {
+                EXPECT_EQ(pMip->GetPixel16u(x, y)[0], 1000);
+                EXPECT_EQ(pMip->GetPixel16u(x, y)[1], 60000);
+            }
+        }
+    }
+}
+
+TEST(MipmapTest, ThreadsMatchSingleThread)
+{
+    Bitmap bitmap = Bitmap::Create(512, 512, Bitmap::FORMAT_RGBA_FLOAT);
+    float* pData  = reinterpret_cast<float*>(bitmap.GetData());
+    for (uint32_t i = 0; i < 512 * 512 * 4; ++i) {
+        pData[i] = static_cast<float>((i * 2654435761u) % 1000) / 1000.0f;
+    }
+
+    MipmapGenerateInfo generateInfo = {};
+    generateInfo.filter             = MIPMAP_FILTER_KAISER;
+    generateInfo.threadCount        = 1;
+    Mipmap single(bitmap, PPX_REMAINING_MIP_LEVELS, /* useStaticPool= */ false, generateInfo);
+
+    generateInfo.threadCount = 4;
+    Mipmap threaded(bitmap, PPX_REMAINING_MIP_LEVELS, /* useStaticPool= */ false, generateInfo);
+
+    ASSERT_TRUE(single.IsOk());
+    ASSERT_TRUE(threaded.IsOk());
+    ASSERT_EQ(single.GetLevelCount(), threaded.GetLevelCount());
+    for (uint32_t level = 1; level < single.GetLevelCount(); ++level) {
+        const Bitmap* pSingle   = single.GetMip(level);
+        const Bitmap* pThreaded = threaded.GetMip(level);
+        EXPECT_EQ(memcmp(pSingle->GetData(), pThreaded->GetData(), pSingle->GetFootprintSize()), 0);
+    }
+}
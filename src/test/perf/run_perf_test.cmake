@@ -0,0 +1,52 @@
+# Copyright 2022 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Runs a benchmark that writes a metrics report, then checks the report
+# against a set of budgets of perf_budgets.json with tools/metrics_report.py:
+#
+#   cmake -DPYTHON=... -DMETRICS_REPORT=... -DREPORT=... -DBUDGETS=...
+#         -DDEVICE_CLASS=... -DBUDGET_SET=... -P run_perf_test.cmake -- <benchmark> [args...]
+#
+# The benchmark must be told to write its report to REPORT.
+
+# Everything after -- is the benchmark command line
+set(BENCHMARK_COMMAND)
+set(IN_COMMAND FALSE)
+math(EXPR LAST_ARG "${CMAKE_ARGC} - 1")
+foreach (i RANGE ${LAST_ARG})
+    if (IN_COMMAND)
+        list(APPEND BENCHMARK_COMMAND "${CMAKE_ARGV${i}}")
+    elseif ("${CMAKE_ARGV${i}}" STREQUAL "--")
+        set(IN_COMMAND TRUE)
+    endif()
+endforeach()
+if (NOT BENCHMARK_COMMAND)
+    message(FATAL_ERROR "No benchmark command after --")
+endif()
+
+# A stale report would hide a benchmark that failed to write one
+file(REMOVE "${REPORT}")
+
+execute_process(COMMAND ${BENCHMARK_COMMAND} RESULT_VARIABLE BENCHMARK_RESULT)
+if (NOT BENCHMARK_RESULT EQUAL 0)
+    message(FATAL_ERROR "${BUDGET_SET} failed: ${BENCHMARK_RESULT}")
+endif()
+
+execute_process(
+    COMMAND "${PYTHON}" "${METRICS_REPORT}" "${REPORT}"
+        --budgets "${BUDGETS}" --device-class "${DEVICE_CLASS}" --budget-set "${BUDGET_SET}"
+    RESULT_VARIABLE CHECK_RESULT)
+if (NOT CHECK_RESULT EQUAL 0)
+    message(FATAL_ERROR "${BUDGET_SET} doesn't meet the budgets of device class ${DEVICE_CLASS}")
+endif()
@@ -0,0 +1,61 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/perf_counters.h"
+
+namespace ppx {
+namespace {
+
+TEST(PerfCountersTest, ReadFailsWhenClosed)
+{
+    PerfCounters      counters;
+    PerfCounterValues values = {};
+    EXPECT_FALSE(counters.IsOpen());
+    EXPECT_EQ(counters.Read(&values), ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE);
+    EXPECT_EQ(values.values[PERF_COUNTER_CYCLES], 0);
+}
+
+TEST(PerfCountersTest, CountsIncrease)
+{
+    PerfCounters counters;
+    if (Failed(counters.Open())) {
+        GTEST_SKIP() << "perf_event_open isn't available";
+    }
+
+    PerfCounterValues begin = {};
+    ASSERT_EQ(counters.Read(&begin), ppx::SUCCESS);
+    volatile uint64_t sum = 0;
+    for (uint64_t i = 0; i < 1000000; ++i) {
+        sum += i;
+    }
+    PerfCounterValues end = {};
+    ASSERT_EQ(counters.Read(&end), ppx::SUCCESS);
+
+    if (counters.IsAvailable(PERF_COUNTER_INSTRUCTIONS)) {
+        EXPECT_GT(end.values[PERF_COUNTER_INSTRUCTIONS], begin.values[PERF_COUNTER_INSTRUCTIONS]);
+    }
+    for (uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+        if (!counters.IsAvailable(static_cast<PerfCounter>(i))) {
+            EXPECT_EQ(end.values[i], 0);
+        }
+    }
+
+    counters.Close();
+    EXPECT_FALSE(counters.IsOpen());
+}
+
+} // namespace
+} // namespace ppx
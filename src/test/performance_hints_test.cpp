@@ -0,0 +1,63 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/performance_hints.h"
+
+#include <cmath>
+
+namespace ppx {
+namespace {
+
+TEST(PerformanceHintsTest, ClosedHintsAreUnavailable)
+{
+    PerformanceHints hints;
+    EXPECT_FALSE(hints.IsOpen());
+    EXPECT_EQ(hints.ReportActualWorkDuration(1000000), ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE);
+    EXPECT_EQ(hints.UpdateTargetWorkDuration(1000000), ppx::ERROR_REQUIRED_FEATURE_UNAVAILABLE);
+    EXPECT_EQ(hints.GetThermalStatus(), THERMAL_STATUS_UNKNOWN);
+    EXPECT_TRUE(std::isnan(hints.GetThermalHeadroom()));
+}
+
+TEST(PerformanceHintsTest, OpenReportsAvailability)
+{
+    PerformanceHints hints;
+    if (Failed(hints.Open(16666667))) {
+        EXPECT_FALSE(hints.IsOpen());
+        GTEST_SKIP() << "ADPF isn't available";
+    }
+
+    EXPECT_TRUE(hints.IsOpen());
+    if (hints.HasHintSession()) {
+        EXPECT_EQ(hints.ReportActualWorkDuration(8000000), ppx::SUCCESS);
+        EXPECT_EQ(hints.ReportActualWorkDuration(0), ppx::ERROR_OUT_OF_RANGE);
+    }
+    if (hints.HasThermalStatus()) {
+        EXPECT_NE(hints.GetThermalStatus(), THERMAL_STATUS_UNKNOWN);
+    }
+
+    hints.Close();
+    EXPECT_FALSE(hints.IsOpen());
+}
+
+TEST(PerformanceHintsTest, GetThermalStatusName)
+{
+    EXPECT_STREQ(PerformanceHints::GetThermalStatusName(THERMAL_STATUS_NONE), "none");
+    EXPECT_STREQ(PerformanceHints::GetThermalStatusName(THERMAL_STATUS_SEVERE), "severe");
+    EXPECT_STREQ(PerformanceHints::GetThermalStatusName(THERMAL_STATUS_UNKNOWN), "unknown");
+}
+
+} // namespace
+} // namespace ppx
@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/profiler.h"
+
+#include "nlohmann/json.hpp"
+
+#include <sstream>
+#include <thread>
+
+namespace ppx {
+namespace {
+
+const ProfilerEvent* FindEvent(const Profiler* pProfiler, const std::string& name)
+{
+    for (const auto& event : pProfiler->GetEvents()) {
+        if (event.GetName() == name) {
+            return &event;
+        }
+    }
+    return nullptr;
+}
+
+void ProfiledFunction()
+{
+    PPX_PROFILE_SCOPE("ProfiledFunction");
+}
+
+nlohmann::json WriteTrace()
+{
+    std::stringstream ss;
+    Profiler::WriteTrace(ss);
+    return nlohmann::json::parse(ss.str());
+}
+
+TEST(ProfilerTest, TraceRecordsSamplesMarkersAndGpuScopes)
+{
+    Profiler::ReinitializeGlobalVariables();
+
+    ProfilerEventToken token = 0;
+    ASSERT_EQ(Profiler::RegisterEvent(PROFILER_EVENT_TYPE_JOB, "trace \"job\"", PROFILER_EVENT_RECORD_ACTION_AVERAGE, &token), ppx::SUCCESS);
+
+    // Not recorded, the trace hasn't started
+    Profiler::GetProfilerForThread()->RecordSample(token, {1, 2});
+
+    Profiler::StartTrace(16);
+    EXPECT_TRUE(Profiler::IsTracing());
+    Profiler::RecordTraceFrameMarker(7);
+    {
+        ProfilerScopedEventSample sample(token);
+    }
+    Profiler::RecordTraceGpuScope("frame/shadow", 0, 1000);
+    Profiler::StopTrace();
+    EXPECT_FALSE(Profiler::IsTracing());
+
+    // Not recorded, the trace has stopped
+    Profiler::GetProfilerForThread()->RecordSample(token, {1, 2});
+    EXPECT_EQ(Profiler::GetProfilerForThread()->GetTraceEventCount(), 2);
+
+    nlohmann::json trace      = WriteTrace();
+    uint32_t       frameCount = 0;
+    uint32_t       jobCount   = 0;
+    uint32_t       gpuCount   = 0;
+    for (const auto& event : trace["traceEvents"]) {
+        if (event["ph"] == "M") {
+            continue;
+        }
+        if (event["cat"] == "frame") {
+            EXPECT_EQ(event["name"], "Frame 7");
+            frameCount += 1;
+        }
+        else if (event["cat"] == "job") {
+            EXPECT_EQ(event["name"], "trace \"job\"");
+            EXPECT_EQ(event["ph"], "X");
+            jobCount += 1;
+        }
+        else if (event["cat"] == "gpu") {
+            EXPECT_EQ(event["name"], "frame/shadow");
+            EXPECT_EQ(event["dur"], 1.0);
+            gpuCount += 1;
+        }
+    }
+    EXPECT_EQ(frameCount, 1);
+    EXPECT_EQ(jobCount, 1);
+    EXPECT_EQ(gpuCount, 1);
+
+    Profiler::ReinitializeGlobalVariables();
+}
+
+TEST(ProfilerTest, TraceDropsEventsPastCapacity)
+{
+    Profiler::StartTrace(2);
+    for (uint64_t i = 0; i < 5; ++i) {
+        Profiler::RecordTraceFrameMarker(i);
+    }
+    Profiler::StopTrace();
+
+    Profiler* pProfiler = Profiler::GetProfilerForThread();
+    EXPECT_EQ(pProfiler->GetTraceEventCount(), 2);
+    EXPECT_EQ(pProfiler->GetTraceDroppedCount(), 3);
+
+    // A new trace starts empty
+    Profiler::StartTrace(2);
+    EXPECT_EQ(pProfiler->GetTraceEventCount(), 0);
+    Profiler::StopTrace();
+}
+
+TEST(ProfilerTest, ProfileScopeRecordsOnEachThread)
+{
+    Profiler::ReinitializeGlobalVariables();
+
+    ProfiledFunction();
+    ProfiledFunction();
+    const ProfilerEvent* pEvent = FindEvent(Profiler::GetProfilerForThread(), "ProfiledFunction");
+    ASSERT_NE(pEvent, nullptr);
+    EXPECT_EQ(pEvent->GetType(), PROFILER_EVENT_TYPE_SCOPE);
+    EXPECT_EQ(pEvent->GetSampleCount(), 2);
+
+    uint64_t threadSampleCount = 0;
+    std::thread thread([&threadSampleCount]() {
+        ProfiledFunction();
+        const ProfilerEvent* pThreadEvent = FindEvent(Profiler::GetProfilerForThread(), "ProfiledFunction");
+        threadSampleCount                 = IsNull(pThreadEvent) ? 0 : pThreadEvent->GetSampleCount();
+    });
+    thread.join();
+    EXPECT_EQ(threadSampleCount, 1);
+
+    // The token kept by the scope stays valid
+    Profiler::ReinitializeGlobalVariables();
+    ProfiledFunction();
+    pEvent = FindEvent(Profiler::GetProfilerForThread(), "ProfiledFunction");
+    ASSERT_NE(pEvent, nullptr);
+    EXPECT_EQ(pEvent->GetSampleCount(), 1);
+
+    Profiler::ReinitializeGlobalVariables();
+}
+
+} // namespace
+} // namespace ppx
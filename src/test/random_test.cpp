@@ -0,0 +1,87 @@
+// Copyright 2022 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/random.h"
+
+#include <vector>
+
+using namespace ppx;
+
+// Not a multiple of the stream count, so the last values come from some of the streams only
+const size_t kValueCount = 1001;
+
+TEST(RandomTest, FillIsDeterministic)
+{
+    Random a;
+    Random b;
+
+    std::vector<uint32_t> valuesA(kValueCount);
+    std::vector<uint32_t> valuesB(kValueCount);
+    a.FillUInt32(valuesA.data(), valuesA.size());
+    b.FillUInt32(valuesB.data(), valuesB.size());
+    EXPECT_EQ(valuesA, valuesB);
+
+    // The next call continues from the generator's state
+    std::vector<uint32_t> next(kValueCount);
+    a.FillUInt32(next.data(), next.size());
+    EXPECT_NE(next, valuesA);
+}
+
+TEST(RandomTest, FillFloatRanges)
+{
+    Random random;
+
+    std::vector<float> values(kValueCount);
+    random.FillFloat(values.data(), values.size());
+    for (float value : values) {
+        EXPECT_GE(value, 0.0f);
+        EXPECT_LT(value, 1.0f);
+    }
+
+    random.FillFloat(values.data(), values.size(), -3.0f, 5.0f);
+    for (float value : values) {
+        EXPECT_GE(value, -3.0f);
+        EXPECT_LE(value, 5.0f);
+    }
+
+    std::vector<float3> vectors(kValueCount);
+    random.FillFloat3(vectors.data(), vectors.size(), float3(0, 10, -20), float3(1, 20, -10));
+    for (const float3& value : vectors) {
+        EXPECT_TRUE(glm::all(glm::greaterThanEqual(value, float3(0, 10, -20))));
+        EXPECT_TRUE(glm::all(glm::lessThanEqual(value, float3(1, 20, -10))));
+    }
+}
+
+TEST(RandomTest, FillSphere)
+{
+    Random random;
+
+    std::vector<float3> directions(kValueCount);
+    random.FillUnitVector3(directions.data(), directions.size());
+    float3 sum = float3(0);
+    for (const float3& direction : directions) {
+        EXPECT_NEAR(glm::length(direction), 1.0f, 1e-5f);
+        sum += direction;
+    }
+    // Uniform over the sphere, the mean is close to the center
+    EXPECT_LT(glm::length(sum / static_cast<float>(kValueCount)), 0.1f);
+
+    std::vector<float3> points(kValueCount);
+    random.FillPointInSphere(points.data(), points.size(), float3(5, 0, 0), 2.0f);
+    for (const float3& point : points) {
+        EXPECT_LE(glm::distance(point, float3(5, 0, 0)), 2.0f + 1e-5f);
+    }
+}
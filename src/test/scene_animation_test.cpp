@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/scene/scene_animation.h"
+#include "ppx/scene/scene_node.h"
+
+using namespace ppx;
+
+TEST(SceneAnimationTest, SampleLinear)
+{
+    scene::AnimationSampler sampler(
+        scene::ANIMATION_INTERPOLATION_LINEAR,
+        {0.0f, 1.0f, 3.0f},
+        {float4(0, 0, 0, 0), float4(2, 4, 6, 0), float4(4, 4, 4, 0)},
+        3);
+    EXPECT_EQ(sampler.GetKeyCount(), 3u);
+    EXPECT_EQ(sampler.GetVectorCount(), 1u);
+    EXPECT_FLOAT_EQ(sampler.GetEndTime(), 3.0f);
+
+    uint32_t cursor = 0;
+    float4   value  = float4(0);
+    sampler.Sample(0.5f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(1, 2, 3, 0));
+    EXPECT_EQ(cursor, 0u);
+
+    sampler.Sample(2.0f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(3, 4, 5, 0));
+    EXPECT_EQ(cursor, 1u);
+
+    // Times outside of the keys are clamped, the cursor doesn't have to be
+    // before the time
+    sampler.Sample(5.0f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(4, 4, 4, 0));
+    sampler.Sample(-1.0f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(0, 0, 0, 0));
+    cursor = 1;
+    sampler.Sample(0.5f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(1, 2, 3, 0));
+}
+
+TEST(SceneAnimationTest, SampleStep)
+{
+    scene::AnimationSampler sampler(
+        scene::ANIMATION_INTERPOLATION_STEP,
+        {0.0f, 1.0f},
+        {float4(1, 0, 0, 0), float4(2, 0, 0, 0)},
+        3);
+
+    uint32_t cursor = 0;
+    float4   value  = float4(0);
+    sampler.Sample(0.99f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(1, 0, 0, 0));
+    sampler.Sample(1.0f, &cursor, false, &value);
+    EXPECT_EQ(value, float4(2, 0, 0, 0));
+}
+
+TEST(SceneAnimationTest, SampleQuaternionShorterArc)
+{
+    // q and -q are the same rotation, blending takes the shorter arc
+    scene::AnimationSampler sampler(
+        scene::ANIMATION_INTERPOLATION_LINEAR,
+        {0.0f, 1.0f},
+        {float4(0, 0, 0, 1), float4(0, 0, 0, -1)},
+        4);
+
+    uint32_t cursor = 0;
+    float4   value  = float4(0);
+    sampler.Sample(0.5f, &cursor, true, &value);
+    EXPECT_NEAR(value.w, 1.0f, 1e-6f);
+    EXPECT_NEAR(glm::length(value), 1.0f, 1e-6f);
+}
+
+TEST(SceneAnimationTest, AddChannel)
+{
+    scene::Animation animation;
+    scene::Node      node(nullptr);
+
+    const uint32_t samplerIndex = animation.AddSampler(scene::AnimationSampler(
+        scene::ANIMATION_INTERPOLATION_LINEAR,
+        {0.0f, 2.0f},
+        {float4(0), float4(2, 0, 0, 0)},
+        3));
+    EXPECT_FLOAT_EQ(animation.GetDuration(), 2.0f);
+
+    EXPECT_EQ(animation.AddChannel({samplerIndex, nullptr, scene::ANIMATION_PATH_TRANSLATION}), ppx::ERROR_UNEXPECTED_NULL_ARGUMENT);
+    EXPECT_EQ(animation.AddChannel({samplerIndex + 1, &node, scene::ANIMATION_PATH_TRANSLATION}), ppx::ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(animation.AddChannel({samplerIndex, &node, scene::ANIMATION_PATH_WEIGHTS}), ppx::ERROR_SCENE_UNSUPPORTED_NODE_TYPE);
+    EXPECT_EQ(animation.AddChannel({samplerIndex, &node, scene::ANIMATION_PATH_TRANSLATION}), ppx::SUCCESS);
+
+    animation.Apply(1.0f);
+    EXPECT_EQ(node.GetTranslation(), float3(1, 0, 0));
+}
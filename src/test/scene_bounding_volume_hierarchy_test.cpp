@@ -0,0 +1,131 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/scene/scene_scene.h"
+
+#include <set>
+
+using namespace ppx;
+
+namespace {
+
+// Mesh with a single unit box batch and no geometry
+scene::MeshRef CreateBoxMesh()
+{
+    std::vector<scene::PrimitiveBatch> batches;
+    batches.emplace_back(nullptr, grfx::IndexBufferView{}, grfx::VertexBufferView{}, grfx::VertexBufferView{}, 0, 0, ppx::AABB(float3(-0.5f), float3(0.5f)));
+    return std::make_shared<scene::Mesh>(nullptr, std::move(batches));
+}
+
+// 10 x 10 boxes 2 units apart on the XZ plane, node (i, j) at (2i, 0, 2j)
+std::vector<scene::MeshNode*> CreateGrid(scene::Scene* pScene, const scene::MeshRef& mesh)
+{
+    std::vector<scene::MeshNode*> nodes;
+    for (uint32_t j = 0; j < 10; ++j) {
+        for (uint32_t i = 0; i < 10; ++i) {
+            auto pNode = std::make_shared<scene::MeshNode>(mesh, pScene);
+            pNode->SetTranslation(float3(2.0f * i, 0, 2.0f * j));
+            nodes.push_back(pNode.get());
+            EXPECT_EQ(pScene->AddNode(std::move(pNode)), ppx::SUCCESS);
+        }
+    }
+    return nodes;
+}
+
+} // namespace
+
+TEST(SceneBoundingVolumeHierarchyTest, Queries)
+{
+    scene::Scene                  scene(nullptr);
+    scene::MeshRef                mesh  = CreateBoxMesh();
+    std::vector<scene::MeshNode*> nodes = CreateGrid(&scene, mesh);
+
+    scene.UpdateTransforms();
+    scene.UpdateBoundingVolumeHierarchy();
+
+    const scene::BoundingVolumeHierarchy& bvh = scene.GetBoundingVolumeHierarchy();
+    ASSERT_EQ(bvh.GetItemCount(), 100u);
+    EXPECT_EQ(bvh.GetBounds().GetMin(), float3(-0.5f, -0.5f, -0.5f));
+    EXPECT_EQ(bvh.GetBounds().GetMax(), float3(18.5f, 0.5f, 18.5f));
+
+    // Box of view space x in [-1, 5], only the first three columns overlap
+    const ppx::Frustum frustum(glm::orthoRH_ZO(-1.0f, 5.0f, -1.0f, 1.0f, -100.0f, 100.0f));
+
+    std::vector<const scene::MeshNode*> visible;
+    bvh.QueryFrustum(frustum, &visible);
+    std::set<const scene::MeshNode*> expected;
+    for (const scene::MeshNode* pNode : nodes) {
+        if (frustum.Overlaps(mesh->GetBoundingBox().GetTransformed(pNode->GetEvaluatedMatrix()))) {
+            expected.insert(pNode);
+        }
+    }
+    EXPECT_EQ(expected.size(), 30u);
+    EXPECT_EQ(std::set<const scene::MeshNode*>(visible.begin(), visible.end()), expected);
+    EXPECT_EQ(visible.size(), expected.size());
+
+    // The ray along row 2 enters the box at (0, 0, 4) first
+    float distance = -1.0f;
+    EXPECT_EQ(bvh.Raycast(float3(-5, 0, 4), float3(1, 0, 0), &distance), nodes[20]);
+    EXPECT_FLOAT_EQ(distance, 4.5f);
+    EXPECT_EQ(bvh.Raycast(float3(2, 0, 2), float3(0, 0, 1), &distance), nodes[11]);
+    EXPECT_FLOAT_EQ(distance, 0.0f);
+    EXPECT_EQ(bvh.Raycast(float3(-5, 0, 4), float3(-1, 0, 0), &distance), nullptr);
+
+    EXPECT_EQ(bvh.FindNearest(float3(6.2f, 3.0f, 8.1f), &distance), nodes[43]);
+    EXPECT_FLOAT_EQ(distance, 2.5f);
+}
+
+TEST(SceneBoundingVolumeHierarchyTest, RefitAndRebuild)
+{
+    scene::Scene                  scene(nullptr);
+    scene::MeshRef                mesh  = CreateBoxMesh();
+    std::vector<scene::MeshNode*> nodes = CreateGrid(&scene, mesh);
+
+    scene.UpdateBoundingVolumeHierarchy();
+    const scene::BoundingVolumeHierarchy& bvh = scene.GetBoundingVolumeHierarchy();
+    EXPECT_TRUE(bvh.WasRebuilt());
+    const uint32_t nodeCount = bvh.GetNodeCount();
+
+    // Nothing moved
+    scene.UpdateBoundingVolumeHierarchy();
+    EXPECT_FALSE(bvh.WasRebuilt());
+
+    // Moving a node within the scene bounds refits
+    nodes[0]->SetTranslation(float3(9, 0, 9));
+    scene.UpdateTransforms();
+    scene.UpdateBoundingVolumeHierarchy();
+    EXPECT_FALSE(bvh.WasRebuilt());
+    EXPECT_EQ(bvh.GetNodeCount(), nodeCount);
+    EXPECT_EQ(bvh.Raycast(float3(9, 5, 9), float3(0, -1, 0)), nodes[0]);
+    EXPECT_EQ(bvh.Raycast(float3(0, 5, 0), float3(0, -1, 0)), nullptr);
+
+    // Moving it far away grows the bounds enough to rebuild
+    nodes[0]->SetTranslation(float3(100, 0, 0));
+    scene.UpdateTransforms();
+    scene.UpdateBoundingVolumeHierarchy();
+    EXPECT_TRUE(bvh.WasRebuilt());
+    EXPECT_EQ(bvh.FindNearest(float3(101, 0, 0)), nodes[0]);
+
+    // Adding a node rebuilds
+    auto pNode = std::make_shared<scene::MeshNode>(mesh, &scene);
+    pNode->SetTranslation(float3(0, 10, 0));
+    const scene::MeshNode* pAdded = pNode.get();
+    ASSERT_EQ(scene.AddNode(std::move(pNode)), ppx::SUCCESS);
+    scene.UpdateBoundingVolumeHierarchy();
+    EXPECT_TRUE(bvh.WasRebuilt());
+    EXPECT_EQ(bvh.GetItemCount(), 101u);
+    EXPECT_EQ(bvh.Raycast(float3(0, 20, 0), float3(0, -1, 0)), pAdded);
+}
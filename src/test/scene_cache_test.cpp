@@ -0,0 +1,96 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/scene/scene_cache.h"
+#include "ppx/mipmap.h"
+
+#include <cstring>
+
+using namespace ppx;
+
+namespace {
+
+std::filesystem::path TempCachePath()
+{
+    return std::filesystem::temp_directory_path() / "ppx_scene_cache_test.ppxscene";
+}
+
+} // namespace
+
+TEST(SceneCacheTest, RoundTrip)
+{
+    const std::vector<char> meshBytes = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    scene::SceneCache::Batch batch = {};
+    batch.indexDataSize            = 4;
+    batch.positionDataOffset       = 4;
+    batch.positionDataSize         = 4;
+    batch.indexType                = grfx::INDEX_TYPE_UINT16;
+    batch.indexCount               = 2;
+    batch.boundingBoxMin           = float3(-1, -2, -3);
+    batch.boundingBoxMax           = float3(1, 2, 3);
+
+    Bitmap bitmap;
+    ASSERT_EQ(Bitmap::Create(4, 4, Bitmap::FORMAT_RGBA_UINT8, &bitmap), ppx::SUCCESS);
+    bitmap.Fill<uint8_t>(10, 20, 30, 40);
+    Mipmap mipmap(bitmap, Mipmap::CalculateLevelCount(4, 4));
+    ASSERT_TRUE(mipmap.IsOk());
+
+    {
+        scene::SceneCache cache;
+        cache.SetKey(42);
+        cache.AddMeshData(3, 0x5, {batch}, meshBytes.data(), meshBytes.size());
+        cache.AddImage(7, mipmap);
+        ASSERT_EQ(cache.Save(TempCachePath()), ppx::SUCCESS);
+    }
+
+    scene::SceneCache cache;
+    ASSERT_EQ(cache.Load(TempCachePath(), 42), ppx::SUCCESS);
+
+    EXPECT_EQ(cache.FindMeshData(3, 0x4), nullptr);
+    const scene::SceneCache::MeshData* pMeshData = cache.FindMeshData(3, 0x5);
+    ASSERT_NE(pMeshData, nullptr);
+    ASSERT_EQ(pMeshData->batches.size(), 1u);
+    EXPECT_EQ(pMeshData->batches[0].positionDataOffset, 4u);
+    EXPECT_EQ(pMeshData->batches[0].indexType, grfx::INDEX_TYPE_UINT16);
+    EXPECT_EQ(pMeshData->batches[0].boundingBoxMax, float3(1, 2, 3));
+    ASSERT_EQ(pMeshData->dataSize, meshBytes.size());
+    EXPECT_EQ(memcmp(cache.GetData(pMeshData->dataOffset), meshBytes.data(), meshBytes.size()), 0);
+
+    const scene::SceneCache::Image* pImage = cache.FindImage(7);
+    ASSERT_NE(pImage, nullptr);
+    std::vector<Bitmap> levels;
+    ASSERT_EQ(cache.GetImageLevels(*pImage, &levels), ppx::SUCCESS);
+    ASSERT_EQ(levels.size(), mipmap.GetLevelCount());
+    EXPECT_EQ(levels[1].GetWidth(), 2u);
+    EXPECT_EQ(levels[1].GetPixel8u(1, 1)[2], 30);
+
+    std::filesystem::remove(TempCachePath());
+}
+
+TEST(SceneCacheTest, KeyMismatch)
+{
+    {
+        scene::SceneCache cache;
+        cache.SetKey(1);
+        ASSERT_EQ(cache.Save(TempCachePath()), ppx::SUCCESS);
+    }
+
+    scene::SceneCache cache;
+    EXPECT_EQ(cache.Load(TempCachePath(), 2), ppx::ERROR_SCENE_CACHE_MISMATCH);
+
+    std::filesystem::remove(TempCachePath());
+}
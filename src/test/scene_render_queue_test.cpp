@@ -0,0 +1,67 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/scene/scene_render_queue.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace ppx;
+
+TEST(SceneRenderQueueTest, SortKeyOrder)
+{
+    // Pipeline outweighs material, material outweighs mesh, mesh outweighs depth
+    EXPECT_LT(scene::RenderQueue::MakeSortKey(0, 9, 9, 1.0f), scene::RenderQueue::MakeSortKey(1, 0, 0, 0.0f));
+    EXPECT_LT(scene::RenderQueue::MakeSortKey(1, 0, 9, 1.0f), scene::RenderQueue::MakeSortKey(1, 1, 0, 0.0f));
+    EXPECT_LT(scene::RenderQueue::MakeSortKey(1, 1, 0, 1.0f), scene::RenderQueue::MakeSortKey(1, 1, 1, 0.0f));
+    EXPECT_LT(scene::RenderQueue::MakeSortKey(1, 1, 1, 0.25f), scene::RenderQueue::MakeSortKey(1, 1, 1, 0.5f));
+    EXPECT_EQ(scene::RenderQueue::MakeSortKey(0, 0, 0, -1.0f), 0u);
+}
+
+TEST(SceneRenderQueueTest, Sort)
+{
+    std::mt19937          rng(7);
+    std::vector<uint64_t> keys;
+
+    scene::RenderQueue queue;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        scene::RenderQueue::Draw draw = {};
+        draw.sortKey                  = scene::RenderQueue::MakeSortKey(rng() % 3, rng() % 50, rng() % 200, (rng() % 100) / 100.0f);
+        draw.firstInstance            = i;
+        queue.Add(draw);
+        keys.push_back(draw.sortKey);
+    }
+    queue.Sort();
+
+    std::sort(keys.begin(), keys.end());
+    ASSERT_EQ(queue.GetDrawCount(), 1000u);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(queue.GetDraw(i).sortKey, keys[i]);
+    }
+
+    // Equal keys keep the order they were added in
+    queue.Clear();
+    for (uint32_t i = 0; i < 3; ++i) {
+        scene::RenderQueue::Draw draw = {};
+        draw.sortKey                  = scene::RenderQueue::MakeSortKey(1, 2, 3, 0.5f);
+        draw.firstInstance            = i;
+        queue.Add(draw);
+    }
+    queue.Sort();
+    for (uint32_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(queue.GetDraw(i).firstInstance, i);
+    }
+}
@@ -0,0 +1,58 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/scene/scene_material.h"
+#include "ppx/scene/scene_resource_manager.h"
+
+using namespace ppx;
+
+TEST(SceneResourceManagerTest, EvictUnreferenced)
+{
+    scene::ResourceManager resourceManager;
+    for (uint64_t objectId = 0; objectId < 3; ++objectId) {
+        ASSERT_EQ(resourceManager.Cache(objectId, std::make_shared<scene::ErrorMaterial>()), ppx::SUCCESS);
+    }
+
+    scene::MaterialRef material;
+    ASSERT_TRUE(resourceManager.Find(1, material));
+
+    // Unlimited budget by default
+    EXPECT_EQ(resourceManager.EvictUnreferenced(), 0u);
+    EXPECT_EQ(resourceManager.GetMaterialCount(), 3u);
+
+    const std::vector<scene::ResourceManager::ResidentObject> objects = resourceManager.GetResidentObjects();
+    ASSERT_EQ(objects.size(), 3u);
+    for (const auto& object : objects) {
+        EXPECT_EQ(object.type, scene::ResourceManager::OBJECT_TYPE_MATERIAL);
+        EXPECT_EQ(object.gpuBytes, 0u);
+        EXPECT_EQ(object.referenced, (object.objectId == 1));
+    }
+
+    // Budget 0 evicts everything else
+    resourceManager.SetMemoryBudget(0);
+    EXPECT_EQ(resourceManager.EvictUnreferenced(), 2u);
+    EXPECT_EQ(resourceManager.GetMaterialCount(), 1u);
+
+    scene::MaterialRef found;
+    EXPECT_TRUE(resourceManager.Find(1, found));
+    EXPECT_FALSE(resourceManager.Find(0, found));
+
+    // Once released it goes too
+    material.reset();
+    found.reset();
+    EXPECT_EQ(resourceManager.EvictUnreferenced(), 1u);
+    EXPECT_EQ(resourceManager.GetMaterialCount(), 0u);
+}
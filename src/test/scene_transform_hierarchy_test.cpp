@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/scene/scene_scene.h"
+
+using namespace ppx;
+
+TEST(SceneTransformHierarchyTest, ParentBeforeChild)
+{
+    scene::Scene scene(nullptr);
+
+    auto         child  = std::make_shared<scene::Node>(&scene);
+    auto         root   = std::make_shared<scene::Node>(&scene);
+    scene::Node* pChild = child.get();
+    scene::Node* pRoot  = root.get();
+
+    // Children added before their parent still come after it
+    ASSERT_EQ(scene.AddNode(std::move(child)), ppx::SUCCESS);
+    ASSERT_EQ(scene.AddNode(std::move(root)), ppx::SUCCESS);
+    ASSERT_EQ(pRoot->AddChild(pChild), ppx::SUCCESS);
+
+    pRoot->SetTranslation(float3(1, 0, 0));
+    pChild->SetTranslation(float3(0, 2, 0));
+    EXPECT_EQ(pChild->GetEvaluatedMatrix(), glm::translate(float3(1, 2, 0)));
+
+    const scene::TransformHierarchy& hierarchy = scene.GetTransformHierarchy();
+    ASSERT_EQ(hierarchy.GetNodeCount(), 2u);
+    EXPECT_EQ(hierarchy.GetNode(0), pRoot);
+    EXPECT_EQ(hierarchy.GetNode(1), pChild);
+
+    // Moving the parent moves the child
+    pRoot->SetTranslation(float3(3, 0, 0));
+    scene.UpdateTransforms();
+    EXPECT_EQ(hierarchy.GetWorldMatrix(1), glm::translate(float3(3, 2, 0)));
+
+    ASSERT_EQ(pRoot->RemoveChild(pChild), pChild);
+    EXPECT_EQ(pChild->GetEvaluatedMatrix(), glm::translate(float3(0, 2, 0)));
+}
+
+TEST(SceneTransformHierarchyTest, ParallelUpdate)
+{
+    scene::Scene scene(nullptr);
+
+    auto         root  = std::make_shared<scene::Node>(&scene);
+    scene::Node* pRoot = root.get();
+    ASSERT_EQ(scene.AddNode(std::move(root)), ppx::SUCCESS);
+
+    // Enough nodes to update on several threads
+    std::vector<scene::Node*> children;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        auto pNode = std::make_shared<scene::Node>(&scene);
+        pNode->SetTranslation(float3(0, static_cast<float>(i), 0));
+        children.push_back(pNode.get());
+        ASSERT_EQ(pRoot->AddChild(pNode.get()), ppx::SUCCESS);
+        ASSERT_EQ(scene.AddNode(std::move(pNode)), ppx::SUCCESS);
+    }
+
+    pRoot->SetScale(float3(2, 2, 2));
+    scene.UpdateTransforms(4);
+    for (uint32_t i = 0; i < 5000; ++i) {
+        EXPECT_EQ(children[i]->GetEvaluatedMatrix(), glm::scale(float3(2, 2, 2)) * glm::translate(float3(0, static_cast<float>(i), 0)));
+    }
+}
@@ -0,0 +1,209 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gtest/gtest.h"
+
+#include "ppx/shader_compiler.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace ppx;
+
+class ShaderCompilerTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        directory = std::filesystem::temp_directory_path() / ("ppx_shader_compiler_test_" + std::string(::testing::UnitTest::GetInstance()->current_test_info()->name()));
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory / "include");
+
+        WriteFile("Shader.hlsl", "#include \"Common.hlsli\"\nfloat4 vsmain() : SV_Position { return VALUE; }\n");
+        WriteFile("Common.hlsli", "#include <Deep.hlsli>\n");
+        WriteFile("include/Deep.hlsli", "#define VALUE 0\n");
+        // Only has to exist for the cache key
+        WriteFile("dxc", "");
+
+        createInfo.api                = grfx::API_VK_1_1;
+        createInfo.compilerPath       = directory / "dxc";
+        createInfo.includeDirectories = {directory / "include"};
+
+        compileInfo.sourcePath = directory / "Shader.hlsl";
+        compileInfo.stage      = "vs";
+    }
+
+    void TearDown() override
+    {
+        compiler.Shutdown();
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+    }
+
+    void WriteFile(const std::string& name, const std::string& content)
+    {
+        std::ofstream stream(directory / name, std::ios::binary | std::ios::trunc);
+        stream << content;
+    }
+
+    uint64_t CalculateCacheKey()
+    {
+        uint64_t key = 0;
+        EXPECT_EQ(compiler.CalculateCacheKey(compileInfo, &key), ppx::SUCCESS);
+        return key;
+    }
+
+    std::filesystem::path    directory;
+    ShaderCompilerCreateInfo createInfo;
+    ShaderCompileInfo        compileInfo;
+    ShaderCompiler           compiler;
+};
+
+TEST_F(ShaderCompilerTest, InitializeFailsWithoutCompiler)
+{
+    createInfo.compilerPath = directory / "missing";
+    EXPECT_EQ(compiler.Initialize(createInfo), ppx::ERROR_PATH_DOES_NOT_EXIST);
+    EXPECT_FALSE(compiler.IsInitialized());
+}
+
+TEST_F(ShaderCompilerTest, VulkanArguments)
+{
+    ASSERT_EQ(compiler.Initialize(createInfo), ppx::SUCCESS);
+    compileInfo.defines = {{"A", ""}, {"B", "2"}};
+
+    const std::vector<std::string> expected = {
+        "-spirv",
+        "-fspv-preserve-interface",
+        "-fspv-target-env=vulkan1.1",
+        "-fvk-use-dx-layout",
+        "-DPPX_VULKAN=1",
+        "-T",
+        "vs_6_6",
+        "-E",
+        "vsmain",
+        "-DA",
+        "-DB=2",
+        "-I",
+        (directory / "include").string(),
+    };
+    EXPECT_EQ(compiler.GetCompilerArguments(compileInfo), expected);
+
+    compileInfo.stage    = "ms";
+    const auto arguments = compiler.GetCompilerArguments(compileInfo);
+    EXPECT_NE(std::find(arguments.begin(), arguments.end(), "-fspv-extension=SPV_EXT_mesh_shader"), arguments.end());
+}
+
+TEST_F(ShaderCompilerTest, DirectXArguments)
+{
+    createInfo.api = grfx::API_DX_12_0;
+    ASSERT_EQ(compiler.Initialize(createInfo), ppx::SUCCESS);
+    compileInfo.stage = "ps";
+
+    const auto arguments = compiler.GetCompilerArguments(compileInfo);
+    ASSERT_GE(arguments.size(), 5);
+    EXPECT_EQ(arguments[1], "ps_6_5");
+    EXPECT_EQ(arguments[3], "psmain");
+    EXPECT_EQ(arguments[4], "-DPPX_DX12=1");
+}
+
+TEST_F(ShaderCompilerTest, CacheKeyChangesWithDefinesAndStage)
+{
+    ASSERT_EQ(compiler.Initialize(createInfo), ppx::SUCCESS);
+    const uint64_t key = CalculateCacheKey();
+    EXPECT_EQ(CalculateCacheKey(), key);
+
+    compileInfo.defines = {{"VARIANT", "1"}};
+    const uint64_t defineKey = CalculateCacheKey();
+    EXPECT_NE(defineKey, key);
+    compileInfo.defines = {{"VARIANT", "2"}};
+    EXPECT_NE(CalculateCacheKey(), defineKey);
+
+    compileInfo.defines = {};
+    compileInfo.stage   = "ps";
+    EXPECT_NE(CalculateCacheKey(), key);
+}
+
+TEST_F(ShaderCompilerTest, CacheKeyChangesWithIncludedFiles)
+{
+    ASSERT_EQ(compiler.Initialize(createInfo), ppx::SUCCESS);
+    const uint64_t key = CalculateCacheKey();
+
+    // Found through the include directories, two includes deep
+    WriteFile("include/Deep.hlsli", "#define VALUE 1\n");
+    EXPECT_NE(CalculateCacheKey(), key);
+}
+
+TEST_F(ShaderCompilerTest, CacheKeyRejectsInvalidInput)
+{
+    ASSERT_EQ(compiler.Initialize(createInfo), ppx::SUCCESS);
+    uint64_t key = 0;
+
+    compileInfo.stage = "xs";
+    EXPECT_EQ(compiler.CalculateCacheKey(compileInfo, &key), ppx::ERROR_INVALID_CREATE_ARGUMENT);
+
+    compileInfo.stage      = "vs";
+    compileInfo.sourcePath = directory / "Missing.hlsl";
+    EXPECT_EQ(compiler.CalculateCacheKey(compileInfo, &key), ppx::ERROR_PATH_DOES_NOT_EXIST);
+}
+
+#if defined(PPX_LINUX)
+TEST_F(ShaderCompilerTest, CompiledBytecodeIsCached)
+{
+    // Stands in for DXC: copies the source to the -Fo file, fails if FAIL is defined
+    WriteFile("dxc", "#!/bin/sh\n"
+                     "prev=\"\"\n"
+                     "for a in \"$@\"; do\n"
+                     "  case \"$a\" in -DFAIL) echo \"error: FAIL\" >&2; exit 1;; esac\n"
+                     "  if [ \"$prev\" = \"-Fo\" ]; then out=\"$a\"; fi\n"
+                     "  prev=\"$a\"\n"
+                     "done\n"
+                     "cat \"$prev\" > \"$out\"\n");
+    std::filesystem::permissions(directory / "dxc", std::filesystem::perms::owner_all);
+    createInfo.cacheDirectory = directory / "cache";
+    ASSERT_EQ(compiler.Initialize(createInfo), ppx::SUCCESS);
+
+    ShaderCompileResult result = compiler.Compile(compileInfo);
+    ASSERT_EQ(result.result, ppx::SUCCESS) << result.log;
+    EXPECT_FALSE(result.cached);
+    EXPECT_FALSE(result.bytecode.empty());
+
+    AsyncShaderCompile async = compiler.CompileAsync(compileInfo);
+    ASSERT_TRUE(async.IsValid());
+    ShaderCompileResult cachedResult = async.Wait();
+    ASSERT_EQ(cachedResult.result, ppx::SUCCESS);
+    EXPECT_TRUE(cachedResult.cached);
+    EXPECT_EQ(cachedResult.bytecode, result.bytecode);
+    EXPECT_FALSE(async.IsValid());
+
+    compileInfo.defines = {{"FAIL", ""}};
+    ShaderCompileResult failedResult = compiler.Compile(compileInfo);
+    EXPECT_EQ(failedResult.result, ppx::ERROR_FAILED);
+    EXPECT_NE(failedResult.log.find("error: FAIL"), std::string::npos);
+
+    EXPECT_EQ(compiler.GetCompileCount(), 2);
+    EXPECT_EQ(compiler.GetCacheHitCount(), 1);
+
+    // Only the bytecode that compiled is left in the cache
+    size_t fileCount = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory / "cache")) {
+        EXPECT_EQ(entry.path().extension(), ".spv");
+        ++fileCount;
+    }
+    EXPECT_EQ(fileCount, 1);
+}
+#endif
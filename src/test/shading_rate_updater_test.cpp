@@ -0,0 +1,57 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/grfx/grfx_shading_rate_updater.h"
+
+namespace ppx {
+namespace grfx {
+namespace {
+
+const float kLowVariance  = 0.0001f;
+const float kHighVariance = 0.001f;
+
+TEST(ShadingRateUpdaterTest, FullRateWithoutInputs)
+{
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(0.0f, -1.0f, kLowVariance, kHighVariance), 1);
+}
+
+TEST(ShadingRateUpdaterTest, FocusFalloff)
+{
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(0.5f, -1.0f, kLowVariance, kHighVariance), 1);
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(1.0f, -1.0f, kLowVariance, kHighVariance), 2);
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(3.0f, -1.0f, kLowVariance, kHighVariance), 4);
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(100.0f, -1.0f, kLowVariance, kHighVariance), 4);
+}
+
+TEST(ShadingRateUpdaterTest, ContentVariance)
+{
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(0.0f, 0.0f, kLowVariance, kHighVariance), 4);
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(0.0f, 0.0005f, kLowVariance, kHighVariance), 2);
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(0.0f, 0.01f, kLowVariance, kHighVariance), 1);
+}
+
+TEST(ShadingRateUpdaterTest, CoarserSourceWins)
+{
+    // Detailed content in the periphery
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(3.0f, 0.01f, kLowVariance, kHighVariance), 4);
+    // Flat content at the focus
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(0.0f, 0.0f, kLowVariance, kHighVariance), 4);
+    EXPECT_EQ(ShadingRateUpdater::CalculateFragmentSize(1.0f, 0.0005f, kLowVariance, kHighVariance), 2);
+}
+
+} // namespace
+} // namespace grfx
+} // namespace ppx
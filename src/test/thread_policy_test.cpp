@@ -0,0 +1,76 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/thread_policy.h"
+
+#include <algorithm>
+
+namespace ppx {
+namespace {
+
+TEST(ThreadPolicyTest, ParseCpuSet)
+{
+    std::vector<uint32_t> cpus;
+    ASSERT_EQ(ParseCpuSet("0-3,6,2", &cpus), ppx::SUCCESS);
+    EXPECT_EQ(cpus, (std::vector<uint32_t>{0, 1, 2, 3, 6}));
+
+    ASSERT_EQ(ParseCpuSet("any", &cpus), ppx::SUCCESS);
+    EXPECT_TRUE(cpus.empty());
+
+    EXPECT_EQ(ParseCpuSet("3-1", &cpus), ppx::ERROR_FAILED);
+    EXPECT_EQ(ParseCpuSet("1,,2", &cpus), ppx::ERROR_FAILED);
+    EXPECT_EQ(ParseCpuSet("fast", &cpus), ppx::ERROR_FAILED);
+    EXPECT_TRUE(cpus.empty());
+}
+
+TEST(ThreadPolicyTest, CoreTypesAreDisjoint)
+{
+    const std::vector<uint32_t> big    = GetCoreTypeCpus(CORE_TYPE_BIG);
+    const std::vector<uint32_t> little = GetCoreTypeCpus(CORE_TYPE_LITTLE);
+    EXPECT_TRUE(GetCoreTypeCpus(CORE_TYPE_ANY).empty());
+    EXPECT_EQ(big.empty(), little.empty());
+    for (uint32_t cpu : big) {
+        EXPECT_EQ(std::find(little.begin(), little.end(), cpu), little.end());
+    }
+}
+
+TEST(ThreadPolicyTest, ParseThreadPolicies)
+{
+    ThreadPolicy policies[THREAD_ROLE_COUNT] = {};
+    policies[THREAD_ROLE_GAME].priority      = THREAD_PRIORITY_LOW;
+    ASSERT_EQ(ParseThreadPolicies("render=0-1;jobs=2,3", "render=urgent;loader=low", policies), ppx::SUCCESS);
+
+    EXPECT_EQ(policies[THREAD_ROLE_RENDER].cpus, (std::vector<uint32_t>{0, 1}));
+    EXPECT_EQ(policies[THREAD_ROLE_RENDER].priority, THREAD_PRIORITY_URGENT);
+    EXPECT_EQ(policies[THREAD_ROLE_JOB_WORKER].cpus, (std::vector<uint32_t>{2, 3}));
+    EXPECT_EQ(policies[THREAD_ROLE_LOADER].priority, THREAD_PRIORITY_LOW);
+    // Roles that aren't listed keep their policy
+    EXPECT_TRUE(policies[THREAD_ROLE_GAME].cpus.empty());
+    EXPECT_EQ(policies[THREAD_ROLE_GAME].priority, THREAD_PRIORITY_LOW);
+
+    EXPECT_EQ(ParseThreadPolicies("gpu=0", "", policies), ppx::ERROR_FAILED);
+    EXPECT_EQ(ParseThreadPolicies("", "render", policies), ppx::ERROR_FAILED);
+    EXPECT_EQ(ParseThreadPolicies("", "render=realtime", policies), ppx::ERROR_FAILED);
+}
+
+TEST(ThreadPolicyTest, DefaultPolicyChangesNothing)
+{
+    EXPECT_EQ(SetCurrentThreadAffinity({}), ppx::SUCCESS);
+    EXPECT_EQ(SetCurrentThreadPriority(THREAD_PRIORITY_DEFAULT), ppx::SUCCESS);
+}
+
+} // namespace
+} // namespace ppx
@@ -0,0 +1,156 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/tri_mesh.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace ppx;
+
+namespace {
+
+// Two quads sharing an edge, the second one with relative indices
+constexpr const char* kObj =
+    "# test\n"
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\r\n"
+    "vt 0 0\n"
+    "vt 1 0\n"
+    "vt 1 1\n"
+    "vt 0 1\n"
+    "vn 0 0 1\n"
+    "f 1/1/1 2/2/1 3/3/1 4/4/1\n"
+    "v 2 0 0\n"
+    "v 2 1 0\n"
+    "f -5/2/1 -2/1/1 -1/4/1 -4/3/1 # comment\n";
+
+std::filesystem::path WriteObj(const char* pContent)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "tri_mesh_test.obj";
+    std::ofstream               file(path, std::ios::binary);
+    file << pContent;
+    return path;
+}
+
+} // namespace
+
+TEST(TriMeshTest, CreateFromOBJSharesVertices)
+{
+    const std::filesystem::path path = WriteObj(kObj);
+
+    TriMesh mesh;
+    ASSERT_EQ(TriMesh::CreateFromOBJ(path, TriMeshOptions().Indices().Normals().TexCoords(), &mesh), ppx::SUCCESS);
+
+    // Corners 2/2/1 and 3/3/1 appear in both quads
+    EXPECT_EQ(mesh.GetCountTriangles(), 4u);
+    EXPECT_EQ(mesh.GetCountPositions(), 8u - 2u);
+    EXPECT_EQ(mesh.GetCountNormals(), mesh.GetCountPositions());
+    EXPECT_EQ(mesh.GetCountTexCoords(), mesh.GetCountPositions());
+    EXPECT_EQ(mesh.GetBoundingBoxMin(), float3(0, 0, 0));
+    EXPECT_EQ(mesh.GetBoundingBoxMax(), float3(2, 1, 0));
+
+    std::vector<uint32_t> indices;
+    mesh.GetIndices(indices);
+    ASSERT_EQ(indices.size(), 12u);
+    const float3 expected[12] = {
+        {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 0, 0}, {1, 1, 0}, {0, 1, 0},
+        {1, 0, 0}, {2, 0, 0}, {2, 1, 0}, {1, 0, 0}, {2, 1, 0}, {1, 1, 0}};
+    for (size_t i = 0; i < indices.size(); ++i) {
+        EXPECT_EQ(*mesh.GetDataPositions(indices[i]), expected[i]) << "corner " << i;
+        EXPECT_EQ(*mesh.GetDataNormalls(indices[i]), float3(0, 0, 1));
+    }
+    EXPECT_EQ(*mesh.GetDataTexCoords2(indices[6]), float2(1, 0));
+    EXPECT_EQ(*mesh.GetDataTexCoords2(indices[7]), float2(0, 0));
+
+    std::filesystem::remove(path);
+}
+
+TEST(TriMeshTest, CreateFromOBJUnindexed)
+{
+    const std::filesystem::path path = WriteObj(kObj);
+
+    TriMesh mesh;
+    ASSERT_EQ(TriMesh::CreateFromOBJ(path, TriMeshOptions().Indices(false), &mesh), ppx::SUCCESS);
+    EXPECT_EQ(mesh.GetIndexType(), grfx::INDEX_TYPE_UNDEFINED);
+    EXPECT_EQ(mesh.GetCountPositions(), 12u);
+    EXPECT_EQ(*mesh.GetDataPositions(7), float3(2, 0, 0));
+
+    std::filesystem::remove(path);
+}
+
+TEST(TriMeshTest, CreateFromOBJRejectsBadIndices)
+{
+    const std::filesystem::path path = WriteObj("v 0 0 0\nv 1 0 0\nf 1 2 3\n");
+
+    TriMesh mesh;
+    EXPECT_EQ(TriMesh::CreateFromOBJ(path, TriMeshOptions().Indices(), &mesh), ppx::ERROR_GEOMETRY_FILE_LOAD_FAILED);
+
+    std::filesystem::remove(path);
+}
+
+TEST(TriMeshTest, AppendVerticesInPlace)
+{
+    TriMesh mesh(grfx::INDEX_TYPE_UINT32, TRI_MESH_ATTRIBUTE_DIM_2);
+    mesh.AppendPosition(float3(0, 0, 0));
+    mesh.AppendTexCoord(float2(0, 0));
+
+    TriMesh::VertexSpans spans = mesh.AppendVertices(2, false, false, true, false);
+    EXPECT_EQ(spans.first, 1u);
+    EXPECT_EQ(spans.count, 2u);
+    EXPECT_EQ(spans.pColors, nullptr);
+    EXPECT_EQ(spans.pNormals, nullptr);
+    spans.pPositions[0] = float3(1, 0, 0);
+    spans.pPositions[1] = float3(1, 2, 0);
+    spans.pTexCoords[3] = 1.0f; // Vertex 2
+    mesh.UpdateBoundingBox();
+
+    uint32_t* pIndices = mesh.AppendTriangles(1);
+    pIndices[0]        = 0;
+    pIndices[1]        = 1;
+    pIndices[2]        = 2;
+
+    EXPECT_EQ(mesh.GetCountPositions(), 3u);
+    EXPECT_EQ(mesh.GetCountTexCoords(), 3u);
+    EXPECT_EQ(mesh.GetCountTriangles(), 1u);
+    EXPECT_EQ(mesh.GetBoundingBoxMin(), float3(0, 0, 0));
+    EXPECT_EQ(mesh.GetBoundingBoxMax(), float3(1, 2, 0));
+    EXPECT_EQ(*mesh.GetDataTexCoords2(2), float2(0, 1));
+
+    uint32_t v0 = 0, v1 = 0, v2 = 0;
+    ASSERT_EQ(mesh.GetTriangle(0, v0, v1, v2), ppx::SUCCESS);
+    EXPECT_EQ(v2, 2u);
+}
+
+TEST(TriMeshTest, CreateLargePlane)
+{
+    // Enough vertices to be generated on several threads
+    const uint32_t segs   = 256;
+    const uint32_t verts  = segs + 1;
+    const TriMesh  mesh   = TriMesh::CreatePlane(TRI_MESH_PLANE_POSITIVE_Y, float2(2, 2), segs, segs, TriMeshOptions().Indices().TexCoords().Normals());
+    const uint32_t vertex = 200 * verts + 100;
+
+    EXPECT_EQ(mesh.GetCountPositions(), verts * verts);
+    EXPECT_EQ(mesh.GetCountTriangles(), 2 * segs * segs);
+    EXPECT_EQ(mesh.GetBoundingBoxMin(), float3(-1, 0, -1));
+    EXPECT_EQ(mesh.GetBoundingBoxMax(), float3(1, 0, 1));
+    EXPECT_FLOAT_EQ(mesh.GetDataPositions(vertex)->x, 100.0f / 128.0f - 1.0f);
+    EXPECT_FLOAT_EQ(mesh.GetDataPositions(vertex)->z, 200.0f / 128.0f - 1.0f);
+    EXPECT_FLOAT_EQ(mesh.GetDataTexCoords2(vertex)->y, 200.0f / 256.0f);
+    EXPECT_EQ(*mesh.GetDataNormalls(vertex), float3(0, 1, 0));
+}
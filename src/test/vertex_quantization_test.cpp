@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/vertex_quantization.h"
+#include "ppx/scene/scene_mesh.h"
+
+#include <random>
+
+using namespace ppx;
+
+namespace {
+
+float3 RandomDirection(std::mt19937& rng)
+{
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    float3                                v = float3(0);
+    while (glm::length(v) < 0.01f) {
+        v = float3(dist(rng), dist(rng), dist(rng));
+    }
+    return glm::normalize(v);
+}
+
+// Round trip through the SNORM16 format
+float2 RoundTripSnorm16(const float2& e)
+{
+    return float2(DequantizeSnorm16(QuantizeSnorm16(e.x)), DequantizeSnorm16(QuantizeSnorm16(e.y)));
+}
+
+} // namespace
+
+TEST(VertexQuantizationTest, Snorm16)
+{
+    EXPECT_EQ(QuantizeSnorm16(1.0f), 32767);
+    EXPECT_EQ(QuantizeSnorm16(-1.0f), -32767);
+    EXPECT_EQ(QuantizeSnorm16(2.0f), 32767);
+    EXPECT_EQ(QuantizeSnorm16(0.0f), 0);
+    EXPECT_FLOAT_EQ(DequantizeSnorm16(-32768), -1.0f);
+    EXPECT_EQ(QuantizeUnorm8(0.5f), 128);
+}
+
+TEST(VertexQuantizationTest, OctahedralRoundTrip)
+{
+    std::mt19937 rng(1);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const float3 n = RandomDirection(rng);
+        const float3 d = DecodeOctahedral(RoundTripSnorm16(EncodeOctahedral(n)));
+        EXPECT_GT(glm::dot(n, d), 0.99999f);
+    }
+
+    // Poles and the folded edges
+    for (const float3& n : {float3(0, 0, 1), float3(0, 0, -1), float3(1, 0, 0), float3(0, -1, 0)}) {
+        EXPECT_GT(glm::dot(n, DecodeOctahedral(EncodeOctahedral(n))), 0.99999f);
+    }
+}
+
+TEST(VertexQuantizationTest, OctahedralTangentKeepsSign)
+{
+    std::mt19937 rng(2);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        const float4 t = float4(RandomDirection(rng), (i % 2) ? 1.0f : -1.0f);
+        const float4 d = DecodeOctahedralTangent(RoundTripSnorm16(EncodeOctahedralTangent(t)));
+        EXPECT_GT(glm::dot(float3(t), float3(d)), 0.9999f);
+        EXPECT_EQ(d.w, t.w);
+    }
+
+    // Encoded y is at its smallest here
+    const float4 t = float4(0, -1, 0, -1);
+    const float4 d = DecodeOctahedralTangent(RoundTripSnorm16(EncodeOctahedralTangent(t)));
+    EXPECT_EQ(d.w, -1.0f);
+}
+
+TEST(VertexQuantizationTest, CompactVertexBindings)
+{
+    const scene::VertexAttributeFlags attributes = scene::VertexAttributeFlags::All();
+    EXPECT_EQ(attributes.GetVertexBinding().GetStride(), 48u);
+    EXPECT_EQ(attributes.GetVertexBinding(scene::VERTEX_QUANTIZATION_COMPACT).GetStride(), 16u);
+
+    const scene::MeshData meshData(attributes, nullptr, scene::VERTEX_QUANTIZATION_COMPACT);
+    ASSERT_EQ(meshData.GetAvailableVertexBindings().size(), 2u);
+    EXPECT_EQ(meshData.GetAvailableVertexBindings()[0].GetStride(), 8u);
+    EXPECT_EQ(meshData.GetAvailableVertexBindings()[1].GetStride(), 16u);
+}
+
+TEST(VertexQuantizationTest, DequantizationFromBounds)
+{
+    const auto dequantization = scene::VertexDequantization::FromBounds(ppx::AABB(float3(-1, 0, 2), float3(3, 2, 2)));
+    EXPECT_EQ(dequantization.positionOffset, float3(1, 1, 2));
+    EXPECT_EQ(dequantization.positionScale, float3(2, 1, 0));
+}
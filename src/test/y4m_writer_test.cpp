@@ -0,0 +1,77 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     https://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+
+#include "ppx/y4m_writer.h"
+
+#include <sstream>
+#include <vector>
+
+namespace ppx {
+namespace {
+
+TEST(Y4mWriterTest, ConvertsBlackAndWhiteToLimitedRange)
+{
+    // 2x1 RGBA, black then white
+    const uint8_t        texels[] = {0, 0, 0, 255, 255, 255, 255, 255};
+    std::vector<uint8_t> yuv(Y4mWriter::GetFrameSize(2, 1));
+    ASSERT_EQ(yuv.size(), 4);
+    ASSERT_EQ(Y4mWriter::ConvertToI420(grfx::FORMAT_R8G8B8A8_UNORM, texels, 2, 1, 8, yuv.data()), ppx::SUCCESS);
+
+    EXPECT_EQ(yuv[0], 16);
+    EXPECT_EQ(yuv[1], 235);
+    EXPECT_EQ(yuv[2], 128);
+    EXPECT_EQ(yuv[3], 128);
+}
+
+TEST(Y4mWriterTest, SwizzlesBGRA)
+{
+    // Pure red
+    const uint8_t        texels[] = {0, 0, 255, 255};
+    std::vector<uint8_t> yuv(Y4mWriter::GetFrameSize(1, 1));
+    ASSERT_EQ(Y4mWriter::ConvertToI420(grfx::FORMAT_B8G8R8A8_UNORM, texels, 1, 1, 4, yuv.data()), ppx::SUCCESS);
+
+    EXPECT_EQ(yuv[0], 82);
+    EXPECT_EQ(yuv[1], 90);
+    EXPECT_EQ(yuv[2], 240);
+}
+
+TEST(Y4mWriterTest, WritesHeaderAndFrames)
+{
+    std::stringstream stream;
+    Y4mWriter         writer;
+    ASSERT_EQ(writer.Open(&stream, 3, 3, 30), ppx::SUCCESS);
+
+    // Row stride with padding
+    const std::vector<uint8_t> texels(16 * 3, 0);
+    EXPECT_EQ(writer.WriteFrame(grfx::FORMAT_R8G8B8A8_UNORM, texels.data(), 3, 3, 16), ppx::SUCCESS);
+    EXPECT_EQ(writer.WriteFrame(grfx::FORMAT_R8G8B8A8_UNORM, texels.data(), 3, 3, 16), ppx::SUCCESS);
+    EXPECT_EQ(writer.WriteFrame(grfx::FORMAT_R8G8B8A8_UNORM, texels.data(), 2, 3, 16), ppx::ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(writer.GetFrameCount(), 2);
+
+    const std::string header = "YUV4MPEG2 W3 H3 F30:1 Ip A1:1 C420jpeg\n";
+    const std::string frame  = "FRAME\n" + std::string(9, 16) + std::string(8, static_cast<char>(128));
+    EXPECT_EQ(stream.str(), header + frame + frame);
+}
+
+TEST(Y4mWriterTest, RejectsFloatFormats)
+{
+    const float          texels[4] = {};
+    std::vector<uint8_t> yuv(Y4mWriter::GetFrameSize(1, 1));
+    EXPECT_EQ(Y4mWriter::ConvertToI420(grfx::FORMAT_R32G32B32A32_FLOAT, texels, 1, 1, 16, yuv.data()), ppx::ERROR_IMAGE_INVALID_FORMAT);
+}
+
+} // namespace
+} // namespace ppx
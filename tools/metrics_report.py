@@ -0,0 +1,306 @@
+#!/usr/bin/env python3
+
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Load metrics reports written with `--metrics-format json` or `binary`.
+
+Binary reports hold the same JSON content as JSON reports, except that each
+gauge has a "time_series_index" into columns stored after the JSON, see
+ppx::metrics::Report::WriteBinary(). load() returns the content of either
+format with the "time_series" of each gauge restored as [[seconds, value]].
+
+Reports may have been compressed afterwards with zstd, e.g. `zstd report.bin`.
+Those require the `zstandard` module.
+
+Reports of `--benchmark-repetitions` runs have a "benchmark" object with a
+confidence interval of each gauge, `--sweep-path` runs have one per point in
+"sweep". --compare only flags gauges whose intervals don't overlap between the
+baseline and the report.
+
+Runs with `--metrics-results-store` append their benchmark summaries and
+device fingerprint to a JSON Lines results store. --store compares a report
+against the rolling baseline of the last --baseline-runs entries for the same
+device: the median of their means and confidence interval bounds.
+
+--budgets checks the median of each gauge against the limits of one set of a
+budgets file, for the device class given with --device-class, see
+src/test/perf/perf_budgets.json. Limits are maxima, or minima for gauges that
+are higher is better.
+
+Example use:
+$ tools/metrics_report.py report.bin > report.json
+$ tools/metrics_report.py --summary report.bin.zst
+$ tools/metrics_report.py --compare baseline.json report.json
+$ tools/metrics_report.py --store results.jsonl report.json
+$ tools/metrics_report.py --budgets budgets.json --device-class ci --budget-set cpu_benchmarks report.json
+"""
+
+import argparse
+import json
+import statistics
+import struct
+import sys
+
+_MAGIC = b'PPXM'
+_VERSION = 1
+_ZSTD_MAGIC = b'\x28\xb5\x2f\xfd'
+
+# ppx::metrics::MetricInterpretation
+_HIGHER_IS_BETTER = 1
+_LOWER_IS_BETTER = 2
+
+
+def _decompress(data):
+  if not data.startswith(_ZSTD_MAGIC):
+    return data
+  try:
+    import zstandard
+  except ImportError:
+    sys.exit('The zstandard module is required to read zstd compressed reports')
+  return zstandard.ZstdDecompressor().decompressobj().decompress(data)
+
+
+def _read_varints(data, count):
+  values = []
+  value = 0
+  shift = 0
+  for byte in data:
+    value |= (byte & 0x7F) << shift
+    shift += 7
+    if byte < 0x80:
+      values.append(value)
+      value = 0
+      shift = 0
+  if len(values) != count:
+    raise ValueError(f'Expected {count} timestamps, found {len(values)}')
+  return values
+
+
+def _read_binary(data):
+  version, json_size = struct.unpack_from('<II', data, 4)
+  if version != _VERSION:
+    raise ValueError(f'Unsupported binary report version {version}')
+  offset = 12
+  content = json.loads(data[offset:offset + json_size])
+  offset += json_size
+
+  (series_count,) = struct.unpack_from('<I', data, offset)
+  offset += 4
+  columns = []
+  for _ in range(series_count):
+    count, timestamps_size = struct.unpack_from('<QQ', data, offset)
+    offset += 16
+    micros = 0
+    seconds = []
+    for encoded in _read_varints(data[offset:offset + timestamps_size], count):
+      micros += (encoded >> 1) ^ -(encoded & 1)
+      seconds.append(micros / 1000000.0)
+    offset += timestamps_size
+    values = struct.unpack_from(f'<{count}f', data, offset)
+    offset += 4 * count
+    columns.append([[s, v] for s, v in zip(seconds, values)])
+
+  for run in content.get('runs', []):
+    for gauge in run.get('gauges', []):
+      index = gauge.pop('time_series_index', None)
+      if index is not None:
+        gauge['time_series'] = columns[index]
+  return content
+
+
+def load(path):
+  """Returns the JSON content of a metrics report in any format."""
+  with open(path, 'rb') as f:
+    data = _decompress(f.read())
+  if data.startswith(_MAGIC):
+    return _read_binary(data)
+  return json.loads(data)
+
+
+def _benchmarks(content):
+  """Returns the benchmark summaries of a report by sweep point name."""
+  benchmarks = {point['name']: point for point in content.get('sweep', [])}
+  if 'benchmark' in content:
+    benchmarks[''] = content['benchmark']
+  return benchmarks
+
+
+def compare(baseline, content):
+  """Prints the benchmark gauges that changed significantly, returns their count."""
+  baseline_benchmarks = _benchmarks(baseline)
+  benchmarks = _benchmarks(content)
+  if not baseline_benchmarks or not benchmarks:
+    sys.exit('Both reports must be from --benchmark-repetitions or --sweep-path runs')
+  baseline_gauges = {(point, g['metadata']['name']): g
+                     for point, benchmark in baseline_benchmarks.items()
+                     for g in benchmark['gauges']}
+  changed = 0
+  for point, benchmark in benchmarks.items():
+    changed += _compare_gauges(point, benchmark['gauges'], baseline_gauges)
+  return changed
+
+
+def _compare_gauges(point, gauges, baseline_gauges):
+  changed = 0
+  prefix = f'{point}: ' if point else ''
+  for gauge in gauges:
+    metadata = gauge['metadata']
+    base = baseline_gauges.get((point, metadata['name']))
+    if base is None:
+      continue
+    if gauge['ci_lower'] <= base['ci_upper'] and base['ci_lower'] <= gauge['ci_upper']:
+      continue
+    changed += 1
+    higher = gauge['mean'] > base['mean']
+    verdict = {_HIGHER_IS_BETTER: 'improved' if higher else 'regressed',
+               _LOWER_IS_BETTER: 'regressed' if higher else 'improved'}.get(
+                  metadata['interpretation'], 'changed')
+    print(f"{prefix}{metadata['name']}: {verdict}, {base['mean']:.4f} -> {gauge['mean']:.4f} {metadata['unit']} "
+          f"([{base['ci_lower']:.4f}, {base['ci_upper']:.4f}] -> "
+          f"[{gauge['ci_lower']:.4f}, {gauge['ci_upper']:.4f}])")
+  return changed
+
+
+def load_store(path, device_key):
+  """Returns the results store entries of a device, oldest first."""
+  entries = []
+  with open(path, 'r') as f:
+    for line in f:
+      if not line.strip():
+        continue
+      entry = json.loads(line)
+      if entry.get('device_key') == device_key:
+        entries.append(entry)
+  return entries
+
+
+def rolling_baseline(entries):
+  """Returns a report content with the median summary of each benchmark gauge."""
+  gauges = {}
+  for entry in entries:
+    for point, benchmark in _benchmarks(entry).items():
+      for gauge in benchmark['gauges']:
+        gauges.setdefault((point, gauge['metadata']['name']), []).append(gauge)
+
+  points = {}
+  for (point, _), history in gauges.items():
+    points.setdefault(point, []).append({
+        'metadata': history[-1]['metadata'],
+        'mean': statistics.median(g['mean'] for g in history),
+        'ci_lower': statistics.median(g['ci_lower'] for g in history),
+        'ci_upper': statistics.median(g['ci_upper'] for g in history),
+    })
+
+  content = {'sweep': [{'name': point, 'gauges': points[point]} for point in points if point]}
+  if '' in points:
+    content['benchmark'] = {'gauges': points['']}
+  return content
+
+
+def compare_store(store, content, baseline_runs):
+  """Compares a report to the rolling baseline of its device, returns the changed gauge count."""
+  if 'device' not in content:
+    sys.exit('The report has no device fingerprint')
+  device_key = content['device']['key']
+  # The report itself is in the store if it was run with --metrics-results-store
+  entries = [e for e in load_store(store, device_key)
+             if e.get('generated_at') != content.get('generated_at')]
+  entries = entries[-baseline_runs:]
+  if not entries:
+    print(f'No baseline for {device_key} in {store}')
+    return 0
+  print(f'Baseline of {len(entries)} runs on {device_key}')
+  return compare(rolling_baseline(entries), content)
+
+
+def check_budgets(content, budgets, device_class, budget_set):
+  """Prints the gauges over budget, returns their count."""
+  if device_class not in budgets:
+    sys.exit(f'No budgets for device class {device_class}')
+  limits = budgets[device_class].get(budget_set)
+  if limits is None:
+    sys.exit(f'No budget set {budget_set} for device class {device_class}')
+
+  over = 0
+  checked = set()
+  for run in content.get('runs', []):
+    for gauge in run.get('gauges', []):
+      metadata = gauge['metadata']
+      limit = limits.get(metadata['name'])
+      if limit is None:
+        continue
+      checked.add(metadata['name'])
+      median = gauge['statistics']['median']
+      higher_is_better = metadata['interpretation'] == _HIGHER_IS_BETTER
+      if (median < limit) if higher_is_better else (median > limit):
+        over += 1
+        print(f"{run['name']}: {metadata['name']}: median {median:.4f} {metadata['unit']} "
+              f"{'below' if higher_is_better else 'above'} budget {limit:.4f}")
+  # A renamed or filtered out gauge would otherwise always pass
+  for name in sorted(set(limits) - checked):
+    over += 1
+    print(f'{name}: not in the report')
+  return over
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+                                   formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('report', help='Path to a JSON or binary metrics report')
+  parser.add_argument('--summary', action='store_true',
+                      help='Print the statistics of each gauge instead of the whole report')
+  parser.add_argument('--compare', metavar='BASELINE',
+                      help='Print the significant changes from a baseline report, exit with 1 if any')
+  parser.add_argument('--store', metavar='RESULTS_STORE',
+                      help='Print the significant changes from the rolling baseline of the report\'s '
+                           'device in a results store, exit with 1 if any')
+  parser.add_argument('--baseline-runs', type=int, default=10,
+                      help='Number of the latest store entries in the rolling baseline (default: 10)')
+  parser.add_argument('--budgets', metavar='BUDGETS',
+                      help='Print the gauges whose median is over budget, exit with 1 if any. Requires '
+                           '--device-class and --budget-set')
+  parser.add_argument('--device-class', help='Device class of the budgets, e.g. ci')
+  parser.add_argument('--budget-set', help='Set of budgets of the device class, e.g. cpu_benchmarks')
+  args = parser.parse_args()
+  if args.budgets and not (args.device_class and args.budget_set):
+    parser.error('--budgets requires --device-class and --budget-set')
+
+  content = load(args.report)
+  if args.budgets:
+    with open(args.budgets) as f:
+      budgets = json.load(f)
+    sys.exit(1 if check_budgets(content, budgets, args.device_class, args.budget_set) > 0 else 0)
+  if args.compare:
+    sys.exit(1 if compare(load(args.compare), content) > 0 else 0)
+  if args.store:
+    sys.exit(1 if compare_store(args.store, content, args.baseline_runs) > 0 else 0)
+  if not args.summary:
+    json.dump(content, sys.stdout, indent=4)
+    print()
+    return
+
+  for run in content.get('runs', []):
+    print(run['name'])
+    for gauge in run.get('gauges', []):
+      stats = gauge['statistics']
+      print(f"  {gauge['metadata']['name']}: {len(gauge['time_series'])} entries, "
+            f"average {stats['average']:.4f}, median {stats['median']:.4f}, "
+            f"p99 {stats['percentile_99']:.4f}")
+    for counter in run.get('counters', []):
+      print(f"  {counter['metadata']['name']}: {counter['value']}")
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,112 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Packs asset files into a single archive read by ppx::fs::AssetPack.
+
+Entries are named by their path relative to the root directory, so a pack of
+the assets folder loaded with --asset-pack serves the same names as the
+folder, e.g. "basic/shaders/spv/StaticTexture.vs.spv".
+"""
+
+import argparse
+import logging
+from pathlib import Path
+import struct
+import sys
+from typing import List, Tuple
+
+MAGIC = b"PPXPACK\0"
+VERSION = 1
+HEADER_SIZE = 16
+ENTRY_SIZE = 24
+DATA_ALIGNMENT = 16
+
+
+def align(value: int, alignment: int) -> int:
+    return (value + alignment - 1) & ~(alignment - 1)
+
+
+def collect(root: Path, patterns: List[str], max_size: int) -> List[Tuple[str, Path]]:
+    files = {}
+    for pattern in patterns:
+        for path in root.glob(pattern):
+            if not path.is_file():
+                continue
+            if max_size > 0 and path.stat().st_size > max_size:
+                logging.info("Skipping %s, larger than %d bytes", path, max_size)
+                continue
+            files[path.relative_to(root).as_posix()] = path
+    return sorted(files.items())
+
+
+def write_pack(entries: List[Tuple[str, Path]], dest: Path) -> None:
+    names = b""
+    name_ranges = []
+    for name, _ in entries:
+        encoded = name.encode("utf-8")
+        name_ranges.append((len(names), len(encoded)))
+        names += encoded
+
+    contents = [path.read_bytes() for _, path in entries]
+    offset = align(HEADER_SIZE + ENTRY_SIZE * len(entries) + len(names), DATA_ALIGNMENT)
+    data_offsets = []
+    for content in contents:
+        data_offsets.append(offset)
+        offset = align(offset + len(content), DATA_ALIGNMENT)
+
+    with open(dest, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<II", VERSION, len(entries)))
+        for (name_offset, name_size), data_offset, content in zip(
+            name_ranges, data_offsets, contents
+        ):
+            f.write(
+                struct.pack("<IIQQ", name_offset, name_size, data_offset, len(content))
+            )
+        f.write(names)
+        for data_offset, content in zip(data_offsets, contents):
+            f.write(b"\0" * (data_offset - f.tell()))
+            f.write(content)
+
+
+def main():
+    logging.basicConfig(
+        format="%(asctime)s %(module)s: %(message)s", level=logging.INFO
+    )
+    parser = argparse.ArgumentParser(
+        description="Packs asset files into a single archive for the --asset-pack flag",
+    )
+    parser.add_argument("root", help="The directory entry names are relative to, e.g. assets")
+    parser.add_argument("output", help="The output filename to be saved")
+    parser.add_argument(
+        "--pattern",
+        action="append",
+        help="Glob of the files to pack relative to root, can be repeated. Defaults to all compiled shaders.",
+    )
+    parser.add_argument(
+        "--max-size",
+        type=int,
+        default=0,
+        help="Skip files larger than this many bytes, 0 packs files of any size",
+    )
+    args = parser.parse_args()
+
+    patterns = args.pattern or ["**/spv/*.spv", "**/dxil/*.dxil"]
+    entries = collect(Path(args.root), patterns, args.max_size)
+    write_pack(entries, Path(args.output))
+    logging.info("Packed %d files into %s", len(entries), args.output)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
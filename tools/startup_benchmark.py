@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     https://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Measure the cold and warm startup time of a ppx application.
+
+Launches the application --cold times without a pipeline cache, then --warm
+times with the pipeline cache the previous launch saved, and prints the mean
+and minimum of each startup_* gauge of both. Any argument after `--` is passed
+to the application as is.
+
+Cold launches only start without the pipeline cache: the OS file cache and
+driver shader caches are not cleared, drop them beforehand to measure a first
+launch after boot.
+
+Example use:
+$ tools/startup_benchmark.py build/bin/vk_startup_time
+$ tools/startup_benchmark.py --cold 5 --warm 5 build/bin/vk_scene_render -- --headless
+"""
+
+import argparse
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+import metrics_report
+
+_STARTUP_PREFIX = 'startup_'
+
+
+def _launch(app, app_args, work_dir, cache_path, index):
+  """Runs the application once, returns its startup gauges by name."""
+  metrics_path = os.path.join(work_dir, f'launch_{index}.json')
+  command = [app, '--frame-count', '1', '--enable-metrics', '--metrics-format', 'json',
+             '--metrics-filename', metrics_path, '--overwrite-metrics-file',
+             '--pipeline-cache-path', cache_path] + app_args
+  subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+
+  startup = {}
+  for run in metrics_report.load(metrics_path).get('runs', []):
+    for gauge in run.get('gauges', []):
+      name = gauge['metadata']['name']
+      if name.startswith(_STARTUP_PREFIX) and gauge['time_series']:
+        startup.setdefault(name, gauge['time_series'][0][1])
+  if not startup:
+    sys.exit(f'{app} recorded no startup metrics')
+  return startup
+
+
+def _print_summary(mode, launches):
+  print(f'{mode} ({len(launches)} launches)')
+  for name in launches[0]:
+    values = [launch[name] for launch in launches if name in launch]
+    print(f'  {name}: mean {statistics.mean(values):.2f} ms, min {min(values):.2f} ms')
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__,
+                                   formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('app', help='Path to the application binary')
+  parser.add_argument('app_args', nargs='*', help='Arguments passed to the application')
+  parser.add_argument('--cold', type=int, default=3, help='Number of launches without a pipeline cache')
+  parser.add_argument('--warm', type=int, default=3, help='Number of launches with the pipeline cache')
+  args = parser.parse_args()
+  if args.cold < 1 or args.warm < 0:
+    sys.exit('At least one cold launch is required, it creates the cache of the warm ones')
+
+  with tempfile.TemporaryDirectory() as work_dir:
+    cache_path = os.path.join(work_dir, 'pipeline_cache.bin')
+    cold = []
+    for i in range(args.cold):
+      if os.path.exists(cache_path):
+        os.remove(cache_path)
+      cold.append(_launch(args.app, args.app_args, work_dir, cache_path, len(cold)))
+    warm = [_launch(args.app, args.app_args, work_dir, cache_path, args.cold + i)
+            for i in range(args.warm)]
+
+  _print_summary('cold', cold)
+  if warm:
+    _print_summary('warm', warm)
+
+
+if __name__ == '__main__':
+  main()